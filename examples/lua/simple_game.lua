@@ -5,7 +5,9 @@ local player = {
     x = 0,
     y = 0,
     z = 0,
-    rotation = 0
+    rotation = 0,
+    character = nil,    -- Collides with the level when there is physics
+    fallSpeed = 0
 }
 
 local score = 0
@@ -16,17 +18,32 @@ function update(deltaTime)
     gameTime = gameTime + deltaTime
     
     -- Simple player movement
+    local dx, dz = 0, 0
     if input_is_key_down(string.byte('W')) then
-        player.z = player.z + 5 * deltaTime
+        dz = dz + 5 * deltaTime
     end
     if input_is_key_down(string.byte('S')) then
-        player.z = player.z - 5 * deltaTime
+        dz = dz - 5 * deltaTime
     end
     if input_is_key_down(string.byte('A')) then
-        player.x = player.x - 5 * deltaTime
+        dx = dx - 5 * deltaTime
     end
     if input_is_key_down(string.byte('D')) then
-        player.x = player.x + 5 * deltaTime
+        dx = dx + 5 * deltaTime
+    end
+    
+    if player.character then
+        -- Slides along walls and walks up steps; falls when nothing is underfoot
+        player.fallSpeed = player.fallSpeed + 9.81 * deltaTime
+        local grounded
+        player.x, player.y, player.z, grounded =
+            character_move(player.character, dx, -player.fallSpeed * deltaTime, dz, deltaTime)
+        if grounded then
+            player.fallSpeed = 0
+        end
+    else
+        player.x = player.x + dx
+        player.z = player.z + dz
     end
     
     -- Rotate player
@@ -53,13 +70,18 @@ function render()
         end
     end
     
-    print("Score: " .. score)
-    print("Time: " .. string.format("%.1f", gameTime))
+    graphics_draw_text("Score: " .. score, 10, 10)
+    graphics_draw_text("Time: " .. string.format("%.1f", gameTime), 10, 30)
 end
 
 -- Initialize game
 function init()
     print("Lua Game Initialized!")
+    -- A capsule the size of the player cube, standing on the ground
+    player.character = character_create(player.x, player.y + 0.5, player.z, 0.5, 1.0)
+    if player.character then
+        player.y = player.y + 0.5
+    end
     print("Use WASD to move, ESC to quit")
 end
 
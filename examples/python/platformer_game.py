@@ -6,85 +6,89 @@ Demonstrates Python game development with the Nexus Engine
 import nexus_engine as engine
 import math
 import time
+import numpy as np
 
-class Player:
-    def __init__(self):
-        self.position = engine.Vector3(0, 0, 0)
-        self.velocity = engine.Vector3(0, 0, 0)
-        self.size = engine.Vector3(1, 1, 1)
+class Player(engine.GameObject):
+    def __init__(self, physics):
+        super().__init__("Player")
+        self.set_box((1, 1, 1), (1.0, 0.5, 0.0, 1.0))  # Orange cube, drawn by the scene
+        self.position = (0, 0.5, 0)
+        self.velocity = [0.0, 0.0]
+        self.input_manager = None
         self.on_ground = False
+        # A capsule the size of the cube: it lands on platforms, slides along their sides and
+        # hops up small ledges by itself
+        self.physics = physics
+        self.character = physics.create_character((0, 0.5, 0), radius=0.5, height=1.0)
         self.speed = 8.0
         self.jump_force = 12.0
         
-    def update(self, delta_time, input_manager):
+    def update(self, delta_time):
+        input_manager = self.input_manager
+        
         # Horizontal movement
         if input_manager.is_key_down(ord('A')):
-            self.velocity.x = -self.speed
+            self.velocity[0] = -self.speed
         elif input_manager.is_key_down(ord('D')):
-            self.velocity.x = self.speed
+            self.velocity[0] = self.speed
         else:
-            self.velocity.x *= 0.8  # Friction
+            self.velocity[0] *= 0.8  # Friction
             
         # Jumping
         if input_manager.is_key_pressed(ord(' ')) and self.on_ground:
-            self.velocity.y = self.jump_force
+            self.velocity[1] = self.jump_force
             self.on_ground = False
             
         # Gravity
-        self.velocity.y -= 25.0 * delta_time
-        
-        # Update position
-        self.position.x += self.velocity.x * delta_time
-        self.position.y += self.velocity.y * delta_time
-        
-        # Ground collision
-        if self.position.y <= 0:
-            self.position.y = 0
-            self.velocity.y = 0
-            self.on_ground = True
-            
-    def render(self, graphics):
-        # Draw player as orange cube
-        graphics.draw_cube(self.position, self.size, (1.0, 0.5, 0.0, 1.0))
+        self.velocity[1] -= 25.0 * delta_time
+        
+        # Move against the level
+        displacement = np.array([[self.velocity[0] * delta_time, self.velocity[1] * delta_time, 0.0]], dtype=np.float32)
+        self.physics.move_characters(np.array([self.character], dtype=np.int32), displacement, delta_time)
+        state = self.physics.get_character(self.character)
+        self.position = state["position"]
+        self.on_ground = state["grounded"]
+        # Landing or bumping a head stops the fall or the jump
+        self.velocity[1] = 0.0 if self.on_ground else min(self.velocity[1], state["velocity"][1])
 
-class Platform:
-    def __init__(self, x, y, z, width, height, depth):
-        self.position = engine.Vector3(x, y, z)
-        self.size = engine.Vector3(width, height, depth)
-        
-    def render(self, graphics):
-        graphics.draw_cube(self.position, self.size, (0.5, 0.5, 0.5, 1.0))
+class Platform(engine.GameObject):
+    # No update or render override, so the scene never calls into Python for platforms
+    def __init__(self, physics, x, y, z, width, height, depth):
+        super().__init__("Platform")
+        self.position = (x, y, z)
+        self.set_box((width, height, depth), (0.5, 0.5, 0.5, 1.0))
+        physics.create_box((x, y, z), (width, height, depth), mass=0.0)
 
 class PlatformerGame:
-    def __init__(self):
-        self.player = Player()
-        self.platforms = []
-        self.camera_offset = engine.Vector3(0, 5, -10)
+    def __init__(self, physics):
+        self.scene = engine.Scene("Level")
+        self.physics = physics
+        self.player = Player(physics)
+        self.camera_offset = (0, 5, -10)
         self.score = 0
         self.game_time = 0
         
         # Create level
         self.create_level()
+        self.scene.add_object(self.player)
         
     def create_level(self):
         # Ground platforms
         for i in range(-20, 21, 4):
-            self.platforms.append(Platform(i, -2, 0, 4, 1, 4))
+            self.scene.add_object(Platform(self.physics, i, -2, 0, 4, 1, 4))
             
         # Floating platforms
-        self.platforms.append(Platform(8, 3, 0, 4, 0.5, 4))
-        self.platforms.append(Platform(16, 6, 0, 4, 0.5, 4))
-        self.platforms.append(Platform(-8, 4, 0, 4, 0.5, 4))
-        self.platforms.append(Platform(-16, 7, 0, 4, 0.5, 4))
+        self.scene.add_object(Platform(self.physics, 8, 3, 0, 4, 0.5, 4))
+        self.scene.add_object(Platform(self.physics, 16, 6, 0, 4, 0.5, 4))
+        self.scene.add_object(Platform(self.physics, -8, 4, 0, 4, 0.5, 4))
+        self.scene.add_object(Platform(self.physics, -16, 7, 0, 4, 0.5, 4))
         
     def update(self, delta_time):
         self.game_time += delta_time
         
-        # Get input
-        input_manager = engine.get_input()
-        
-        # Update player
-        self.player.update(delta_time, input_manager)
+        # Update the player (the only object with update logic)
+        self.player.input_manager = engine.get_input()
+        self.scene.update(delta_time)
         
         # Update score based on height
         height_score = max(0, int(self.player.position.y * 10))
@@ -92,8 +96,9 @@ class PlatformerGame:
         
         # Check if player fell
         if self.player.position.y < -10:
-            self.player.position = engine.Vector3(0, 0, 0)
-            self.player.velocity = engine.Vector3(0, 0, 0)
+            self.player.position = (0, 0.5, 0)
+            self.physics.set_character_position(self.player.character, (0, 0.5, 0))
+            self.player.velocity = [0.0, 0.0]
             
     def render(self):
         graphics = engine.get_graphics()
@@ -101,12 +106,8 @@ class PlatformerGame:
         # Clear screen
         graphics.clear(0.4, 0.6, 1.0, 1.0)  # Sky blue
         
-        # Render platforms
-        for platform in self.platforms:
-            platform.render(graphics)
-            
-        # Render player
-        self.player.render(graphics)
+        # Platforms and player, batched natively
+        self.scene.render(graphics)
         
         # Render UI
         self.render_ui(graphics)
@@ -137,7 +138,7 @@ def main():
     print("Engine initialized successfully!")
     
     # Create game
-    game = PlatformerGame()
+    game = PlatformerGame(game_engine.get_physics())
     
     print("Game created! Use A/D to move, Space to jump, ESC to quit.")
     
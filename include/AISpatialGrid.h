@@ -0,0 +1,79 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Uniform spatial hash over the ground plane for AI proximity queries.
+ *
+ * Cells of cellSize on x and z are hashed into a fixed power-of-two table of buckets, so the world
+ * needs no bounds and empty space costs nothing. Every bucket is an intrusive list of items; an
+ * item remembers its cell, so Move() only relinks when it crosses into another cell and an agent
+ * walking around costs a compare most frames. Queries visit the cells overlapping the radius, keep
+ * the items that really lie in each cell (other cells may hash into the same bucket) and test the
+ * full 3D distance, and the cone query also the angle.
+ *
+ * Item ids are small and stable until removed, then reused, so callers index their own arrays
+ * with them. Queries write ids into caller storage and allocate nothing once it has grown.
+ */
+class AISpatialGrid {
+public:
+    static constexpr uint32_t INVALID_ITEM = ~0u;
+    static constexpr uint32_t DEFAULT_BUCKET_COUNT = 4096;
+
+    explicit AISpatialGrid(float cellSize = 8.0f, uint32_t bucketCount = DEFAULT_BUCKET_COUNT);
+
+    // Cells about the size of the common query radius keep each query to a few cells
+    void SetCellSize(float cellSize);
+    void Clear();
+
+    uint32_t Insert(const DirectX::XMFLOAT3& position);
+    void Move(uint32_t item, const DirectX::XMFLOAT3& position);
+    void Remove(uint32_t item);
+
+    const DirectX::XMFLOAT3& GetPosition(uint32_t item) const { return items_[item].position; }
+    size_t GetItemCount() const { return itemCount_; }
+
+    // Items within radius of center. results is cleared first; returns its size
+    size_t QueryRadius(const DirectX::XMFLOAT3& center, float radius, std::vector<uint32_t>& results) const;
+    // Items within radius of origin and at most acos(cosHalfAngle) off the unit direction
+    size_t QueryCone(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float radius,
+                     float cosHalfAngle, std::vector<uint32_t>& results) const;
+    // Up to count items within radius of center, nearest first. Cells are visited in rings around
+    // center's and the search ends once no further ring can hold anything nearer
+    size_t QueryNearest(const DirectX::XMFLOAT3& center, float radius, size_t count,
+                        std::vector<uint32_t>& results) const;
+
+private:
+    struct Item {
+        DirectX::XMFLOAT3 position;
+        int32_t cellX;
+        int32_t cellZ;
+        uint32_t bucket;
+        uint32_t next;
+        uint32_t prev;
+        bool alive;
+    };
+
+    int32_t CellCoordinate(float value) const;
+    uint32_t Bucket(int32_t cellX, int32_t cellZ) const;
+    void Link(uint32_t item);
+    void Unlink(uint32_t item);
+
+    // Calls visit(item) for every live item within radius of center
+    template<typename Visit>
+    void ForEachInRadius(const DirectX::XMFLOAT3& center, float radius, Visit&& visit) const;
+
+    float cellSize_;
+    float inverseCellSize_;
+    std::vector<uint32_t> buckets_;            // First item of each bucket
+    std::vector<Item> items_;
+    uint32_t freeItem_;                        // Removed items, chained through next
+    size_t itemCount_;
+};
+
+} // namespace Nexus
@@ -2,9 +2,14 @@
 
 #include "Platform.h"
 #include "PhysicsEngine.h"
+#include "AISpatialGrid.h"
+#include "CrowdAvoidance.h"
+#include "UtilityAI.h"
 #include <vector>
 #include <memory>
 #include <functional>
+#include <atomic>
+#include <list>
 #include <queue>
 #include <unordered_map>
 #include <string>
@@ -18,6 +23,12 @@ using AIQuaternion = DirectX::XMFLOAT4;
 // Forward declarations
 class AIEntity;
 class NavMesh;
+class CoverMap;
+class FlowField;
+class FlowFieldCache;
+class JobSystem;
+class Timer;
+struct JobCounter;
 class BehaviorTree;
 class StateMachine;
 
@@ -89,6 +100,39 @@ struct AIFormation {
     bool maintainFacing;
 };
 
+class AIBehaviorTree;
+
+/**
+ * Per-entity execution state of a shared AIBehaviorTree: the blackboard and the node a running
+ * tick resumes at. Reset automatically when the tree is recompiled.
+ */
+struct AIBehaviorTreeState {
+    std::vector<float> blackboard;             // Slots from AIBehaviorTree::AddBlackboardKey()
+    uint32_t runningNode = ~0u;
+    const AIBehaviorTree* tree = nullptr;
+    uint32_t revision = 0;
+};
+
+/**
+ * Behavior tree asset, shared by any number of entities.
+ *
+ * Trees are authored as linked Nodes and flattened by Compile() into one array in depth-first
+ * order, where every node stores the end of its subtree and its parent: the children of node i
+ * start at i + 1 and each begins where the previous one's subtree ends. Execution walks that array
+ * without recursion or reference counting, and all per-entity data lives in AIBehaviorTreeState.
+ * A leaf that returns Running is remembered, and the next tick calls it directly and carries its
+ * result on up through its ancestors instead of re-evaluating from the root; higher priority
+ * selector branches are therefore only reconsidered once it finishes, or after ResetState().
+ * Parallel nodes run all their children every tick and resume as a whole.
+ *
+ * A node with a function and no children is a leaf returning that function's status. On a node
+ * with children the function is a guard that must succeed before the children run. Sequences
+ * succeed when all children do, selectors when one does, parallels fail as soon as one child fails
+ * and run while any is running. A decorator without a guard inverts its children's result.
+ *
+ * Leaves should be plain function pointers with a context; the std::function in execute is still
+ * honoured, one indirection slower.
+ */
 class AIBehaviorTree {
 public:
     enum class NodeType {
@@ -107,19 +151,45 @@ public:
         Running
     };
     
+    // blackboard is the entity's AIBehaviorTreeState::blackboard
+    using LeafFunction = NodeStatus (*)(AIEntity* entity, float* blackboard, void* context);
+    
+    static constexpr uint32_t INVALID_NODE = ~0u;
+    static constexpr uint32_t INVALID_KEY = ~0u;
+    static constexpr uint32_t MAX_DEPTH = 64;
+    
     struct Node {
-        NodeType type;
+        NodeType type = NodeType::Leaf;
         std::string name;
         std::function<NodeStatus(AIEntity*)> execute;
+        LeafFunction function = nullptr;      // Preferred over execute
+        void* context = nullptr;
         std::vector<std::shared_ptr<Node>> children;
-        std::shared_ptr<Node> parent;
+        std::weak_ptr<Node> parent;
     };
     
     AIBehaviorTree();
+    static std::shared_ptr<Node> CreateNode(NodeType type, const std::string& name, LeafFunction function = nullptr,
+                                            void* context = nullptr);
+    static void AddChild(const std::shared_ptr<Node>& parent, std::shared_ptr<Node> child);
+    // Compiles the tree; call Compile() again after editing nodes under it
     void SetRootNode(std::shared_ptr<Node> root);
+    bool Compile();
+    
+    // Blackboard slots of floats; returns the first slot of the key
+    uint32_t AddBlackboardKey(const std::string& name, uint32_t floatCount = 1);
+    uint32_t GetBlackboardKey(const std::string& name) const;
+    uint32_t GetBlackboardSize() const { return blackboardSize_; }
+    
+    // One tick for the entity, with its state from AIEntity::GetBehaviorTreeState()
     NodeStatus Execute(AIEntity* entity);
+    NodeStatus Execute(AIEntity* entity, AIBehaviorTreeState& state) const;
+    void ResetState(AIBehaviorTreeState& state) const;
+    // Runs the subtree of one authored node on its own, without resumption
     NodeStatus ExecuteNode(std::shared_ptr<Node> node, AIEntity* entity);
     
+    size_t GetCompiledNodeCount() const { return nodes_.size(); }
+    
     // Node creation methods
     std::shared_ptr<Node> CreatePatrolNode();
     std::shared_ptr<Node> CreateChaseNode();
@@ -133,7 +203,24 @@ public:
     NodeStatus Update(AIEntity* entity) { return Execute(entity); }
     
 private:
+    struct FlatNode {
+        NodeType type;
+        uint32_t parent;
+        uint32_t subtreeEnd;                   // One past the last node of the subtree
+        LeafFunction function;
+        void* context;
+    };
+    
+    bool Flatten(const std::shared_ptr<Node>& node, uint32_t parent, uint32_t depth);
+    // Runs from node inside root's subtree until root finishes or a leaf is running
+    NodeStatus Run(uint32_t root, uint32_t node, AIEntity* entity, AIBehaviorTreeState& state, bool resumable) const;
+    NodeStatus RunParallel(uint32_t node, AIEntity* entity, AIBehaviorTreeState& state) const;
+    
     std::shared_ptr<Node> rootNode_;
+    std::vector<FlatNode> nodes_;
+    std::unordered_map<std::string, uint32_t> blackboardKeys_;
+    uint32_t blackboardSize_;
+    uint32_t revision_;
 };
 
 class AIStateMachine {
@@ -163,20 +250,39 @@ private:
     AIState previousState_;
 };
 
+/**
+ * Paths over a NavMesh.
+ *
+ * A* runs over polygons with a binary heap and a node per polygon that is reused between
+ * searches, so a query allocates nothing. When start and goal lie in different clusters, a search
+ * over the cluster graph first picks the clusters the path may use, which keeps long searches from
+ * flooding the level. The polygon corridor is then string-pulled with the funnel algorithm into
+ * the corners an agent actually has to turn at. Recent corridors are kept in an LRU cache keyed by
+ * start and goal polygon, so agents heading the same way share one search.
+ *
+ * Without a navmesh, FindPath() falls back to a straight line.
+ */
 class AIPathfinding {
 public:
-    struct PathNode {
-        AIVector3 position;
-        float gCost;
-        float hCost;
-        float fCost;
-        std::shared_ptr<PathNode> parent;
+    struct Stats {
+        uint32_t queries = 0;
+        uint32_t cacheHits = 0;
+        uint32_t nodesExpanded = 0;   // Polygons and clusters taken off the open list
     };
     
+    static constexpr size_t DEFAULT_CACHE_SIZE = 128;
+    
     AIPathfinding();
     void SetNavMesh(std::shared_ptr<NavMesh> navMesh);
+    // How far off the navmesh start and goal may be and still snap onto it
+    void SetSearchRadius(float radius) { searchRadius_ = radius; }
+    void SetPathCacheSize(size_t entries);
+    void ClearPathCache();
+    const Stats& GetStats() const { return stats_; }
     
     std::vector<AIVector3> FindPath(const AIVector3& start, const AIVector3& goal);
+    // Writes into caller storage, reusing its capacity so repeated queries don't allocate
+    void FindPath(const AIVector3& start, const AIVector3& goal, std::vector<AIVector3>& outPath);
     std::vector<AIVector3> FindPathWithCover(const AIVector3& start, const AIVector3& goal, 
                                           const AIVector3& threatPosition);
     bool IsPathClear(const AIVector3& start, const AIVector3& end);
@@ -184,12 +290,190 @@ public:
     // Advanced pathfinding
     std::vector<AIVector3> FindFlankingPath(const AIVector3& start, const AIVector3& target, 
                                          const AIVector3& enemyPosition);
+    // Nearest baked cover point shielding from threats in threatDirection; position when none
     AIVector3 FindNearestCoverPoint(const AIVector3& position, const AIVector3& threatDirection);
+    void SetCoverMap(std::shared_ptr<const CoverMap> coverMap) { coverMap_ = std::move(coverMap); }
+    
+private:
+    // One per polygon or cluster. Only valid while generation matches the current search, so
+    // nothing is cleared between searches
+    struct SearchNode {
+        float g;
+        float f;
+        uint32_t parent;
+        uint32_t heapIndex;
+        uint32_t generation;
+        bool closed;
+        AIVector3 position;   // Where the path enters the polygon
+    };
+    
+    struct CacheEntry {
+        uint64_t key;
+        std::vector<uint32_t> corridor;
+    };
+    
+    // Drops search state and cached paths when the navmesh changed underneath
+    void SyncNavMesh();
+    uint32_t NextGeneration();
+    bool FindCorridor(uint32_t startPolygon, uint32_t goalPolygon, const AIVector3& start, const AIVector3& goal);
+    // Marks the clusters on the cheapest cluster route with routeId_; false when there is none
+    bool FindClusterRoute(uint32_t startCluster, uint32_t goalCluster);
+    bool SearchPolygons(uint32_t startPolygon, uint32_t goalPolygon, const AIVector3& start, const AIVector3& goal,
+                        bool onRoute);
+    void StringPull(const AIVector3& start, const AIVector3& goal, std::vector<AIVector3>& path) const;
+    
+    std::shared_ptr<NavMesh> navMesh_;
+    uint32_t navMeshRevision_;
+    float searchRadius_;
+    std::shared_ptr<const CoverMap> coverMap_;
+    
+    std::vector<SearchNode> polygonNodes_;
+    std::vector<SearchNode> clusterNodes_;
+    std::vector<uint32_t> openList_;       // Binary heap of node indices by f
+    std::vector<uint32_t> routeStamps_;    // Per cluster, routeId_ when on the current route
+    uint32_t routeId_;
+    uint32_t generation_;
+    std::vector<uint32_t> corridor_;       // Polygons from start to goal
+    
+    std::list<CacheEntry> cache_;          // Most recently used first
+    std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> cacheIndex_;
+    size_t cacheSize_;
+    Stats stats_;
+};
+
+// How often an entity thinks, picked by AIManager from its distance to the viewer
+enum class AILODTier {
+    Near,         // Every frame
+    Mid,          // Round-robin under the frame's time budget
+    Far           // Keeps walking its path every frame, thinks only every far think interval
+};
+
+enum class PathPriority {
+    Combat,       // Alerted or fighting
+    Visible,      // On screen
+    Background
+};
+
+/**
+ * Queue of path requests answered on the job system a frame later.
+ *
+ * Submit() returns a handle at once; the search happens in a later Update(). Each Update() first
+ * collects the batch started by the previous one, then starts the next: pending requests sorted by
+ * priority and age are spread over one AIPathfinding per lane, and lanes stop taking requests once
+ * the batch has expanded iterationBudget nodes between them. A search that has started runs to the
+ * end, so the budget is checked between requests. Whatever is left over waits for the next frame,
+ * and every PROMOTE_FRAMES frames of waiting raise a request by one priority so background agents
+ * still get their paths while a fight keeps the queue busy. A burst of requests, such as a whole
+ * level reacting to an alarm, is thereby spread over frames instead of landing on one.
+ *
+ * Submit(), Cancel(), TakeResult() and Update() belong to the thread that runs the AI.
+ */
+class PathQueryService {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = 0;
+    static constexpr uint32_t DEFAULT_ITERATION_BUDGET = 4096;
+    static constexpr uint32_t PROMOTE_FRAMES = 30;
+    
+    enum class Status {
+        Invalid,      // Unknown, cancelled or already taken
+        Pending,
+        Ready,
+        Failed        // No path between the two points
+    };
+    
+    struct Stats {
+        uint32_t submitted = 0;
+        uint32_t completed = 0;
+        uint32_t cancelled = 0;
+        uint32_t pending = 0;
+        uint32_t lastBatchRequests = 0;
+        uint32_t lastBatchNodes = 0;
+    };
+    
+    PathQueryService();
+    ~PathQueryService();
+    
+    void SetNavMesh(std::shared_ptr<NavMesh> navMesh);
+    // Without a job system the batch runs on the calling thread inside Update()
+    void SetJobSystem(JobSystem* jobs);
+    // Nodes a frame's batch may expand across all lanes; at least one request always runs
+    void SetIterationBudget(uint32_t nodes) { iterationBudget_ = nodes; }
+    
+    Handle Submit(const AIVector3& start, const AIVector3& goal, PathPriority priority);
+    void Cancel(Handle handle);
+    Status GetStatus(Handle handle) const;
+    // Moves a ready path out and releases the handle; false while pending
+    bool TakeResult(Handle handle, std::vector<AIVector3>& path);
+    
+    // Once per frame, after the entities have submitted
+    void Update();
+    // Blocks until the batch in flight has finished and publishes it
+    void Flush();
+    
+    const Stats& GetStats() const { return stats_; }
     
 private:
+    struct Request {
+        AIVector3 start;
+        AIVector3 goal;
+        PathPriority priority;
+        Status status;
+        uint32_t framesWaiting;
+        std::vector<AIVector3> path;
+    };
+    
+    // Copied out of the request, so Submit() and Cancel() never touch what the lanes read
+    struct BatchItem {
+        Handle handle;
+        AIVector3 start;
+        AIVector3 goal;
+        bool done;
+        std::vector<AIVector3> path;
+    };
+    
+    void RunLane(size_t lane);
+    void PublishBatch();
+    
     std::shared_ptr<NavMesh> navMesh_;
-    std::vector<PathNode> openSet_;
-    std::vector<PathNode> closedSet_;
+    JobSystem* jobs_;
+    std::vector<std::unique_ptr<AIPathfinding>> lanes_;
+    
+    std::unordered_map<Handle, Request> requests_;
+    std::vector<Handle> queue_;            // Pending requests, not in flight
+    Handle nextHandle_;
+    uint32_t iterationBudget_;
+    
+    std::vector<BatchItem> batch_;
+    std::unique_ptr<JobCounter> batchCounter_;
+    std::atomic<uint32_t> batchCursor_;
+    std::atomic<uint32_t> batchNodes_;
+    bool batchInFlight_;
+    Stats stats_;
+};
+
+/**
+ * What other entities may read of an entity during AIManager's think phase. Published serially
+ * before the phase starts, so every thinker sees the same frame no matter which thread it runs on.
+ */
+struct AIEntitySnapshot {
+    AIVector3 position{0.0f, 0.0f, 0.0f};
+    AIState state = AIState::Idle;
+    int team = 0;
+    bool alive = true;
+    bool alert = false;
+};
+
+// Queued by a thinking entity for its squad, delivered in the apply phase
+struct AISquadMessage {
+    enum class Type {
+        PlayerSighted,
+        RequestBackup
+    };
+    
+    Type type;
+    AIVector3 position;
+    const AIEntity* sender;
 };
 
 class AIEntity {
@@ -202,6 +486,17 @@ public:
     void Update(float deltaTime);
     void SetBehaviorTree(std::shared_ptr<AIBehaviorTree> behaviorTree);
     void SetStateMachine(std::shared_ptr<AIStateMachine> stateMachine);
+    AIBehaviorTreeState& GetBehaviorTreeState() { return behaviorTreeState_; }
+    // Shared by every entity of an AIManager so they share its path cache
+    void SetPathfinding(std::shared_ptr<AIPathfinding> pathfinding) { pathfinding_ = pathfinding; }
+    // With a query service MoveTo() queues its search and the path arrives in a later Update()
+    void SetPathQueryService(std::shared_ptr<PathQueryService> pathQueries);
+    // On-screen entities get their paths ahead of those nobody is looking at
+    void SetOnScreen(bool onScreen) { isOnScreen_ = onScreen; }
+    AILODTier GetLODTier() const { return lodTier_; }
+    // Entities of the same team perceive each other as allies, all others as enemies
+    void SetTeam(int team) { team_ = team; }
+    int GetTeam() const { return team_; }
     
     // Position and movement
     void SetPosition(const AIVector3& position);
@@ -210,8 +505,17 @@ public:
     AIQuaternion GetRotation() const { return rotation_; }
     
     void MoveTo(const AIVector3& target);
+    void MoveTo(const AIVector3& target, PathPriority priority);
+    // Walks down a shared flow field to destination, its goal plus any formation offset, instead
+    // of searching a path of its own; MoveTo() leaves the field
+    void FollowFlowField(std::shared_ptr<const FlowField> field, const AIVector3& destination);
+    bool IsWaitingForPath() const { return pathRequest_ != PathQueryService::INVALID_HANDLE; }
     void SetMoveSpeed(float speed);
     void SetTurnSpeed(float speed);
+    // Other entities keep this far from its centre
+    void SetRadius(float radius) { radius_ = radius; }
+    float GetRadius() const { return radius_; }
+    AIVector3 GetVelocity() const { return velocity_; }
     
     // AI behavior configuration
     void SetPersonality(AIPersonality personality);
@@ -220,7 +524,10 @@ public:
     void SetCautiousness(float cautiousness);
     void SetIntelligence(float intelligence);
     
-    // Perception system
+    // Perception system; AIManager fills the perception data from its spatial grids every update
+    void SetSightRange(float range) { sightRange_ = range; }
+    void SetHearingRange(float range) { hearingRange_ = range; }
+    void SetFieldOfView(float degrees) { fieldOfViewAngle_ = degrees; }
     void UpdatePerception();
     void UpdatePerception(float deltaTime);
     const AIPerceptionData& GetPerceptionData() const { return perceptionData_; }
@@ -233,11 +540,14 @@ public:
     void AttackTarget(const AIVector3& targetPosition);
     void SetAccuracyModifier(float modifier);
     
-    // Group AI and coordination
+    // Group AI and coordination. While thinking, read squad members only through GetSnapshot();
+    // messages reach them once the think phase is over
     void SetSquad(const std::vector<AIEntity*>& squadMembers);
     void SetFormation(const AIFormation& formation);
     void CoordinateWithSquad();
     void ShareInformation(const AIVector3& playerPosition);
+    void ReceiveSquadMessage(const AISquadMessage& message);
+    const AIEntitySnapshot& GetSnapshot() const { return snapshot_; }
     
     // Cover system
     void FindCover(const AIVector3& threatDirection);
@@ -258,6 +568,9 @@ public:
     float GetHealth() const { return health_; }
     void TakeDamage(float damage);
     void SetCurrentState(AIState state);
+    // The action AIManager's utility scoring last chose, UtilityScorer::NO_ACTION without one
+    uint32_t GetUtilityAction() const { return utilityAction_; }
+    float GetUtilityScore() const { return utilityScore_; }
     
     // Debug
     void SetDebugMode(bool enabled) { debugMode_ = enabled; }
@@ -288,8 +601,28 @@ private:
     
     // AI systems
     std::shared_ptr<AIBehaviorTree> behaviorTree_;
+    AIBehaviorTreeState behaviorTreeState_;
     std::shared_ptr<AIStateMachine> stateMachine_;
     std::shared_ptr<AIPathfinding> pathfinding_;
+    std::shared_ptr<PathQueryService> pathQueries_;
+    PathQueryService::Handle pathRequest_;
+    bool isOnScreen_;
+    int team_;
+    uint32_t gridItem_;   // In the owning AIManager's entity grid
+    AILODTier lodTier_;
+    float thinkTime_;     // Simulated time not yet seen by Think()
+    
+    // Think() only touches this entity and records what it wants done to anything else here;
+    // ApplyIntents() carries it out
+    AIEntitySnapshot snapshot_;
+    bool thinking_;
+    bool hasMoveIntent_;
+    AIVector3 moveIntent_;
+    PathPriority moveIntentPriority_;
+    std::vector<AISquadMessage> outbox_;
+    
+    std::shared_ptr<const FlowField> flowField_;
+    AIVector3 flowDestination_;
     
     // AI parameters
     float aggression_;
@@ -302,6 +635,12 @@ private:
     // Movement
     float moveSpeed_;
     float turnSpeed_;
+    float radius_;
+    AIVector3 velocity_;
+    AIVector3 preferredVelocity_;   // Where the path or flow field leads, before avoidance
+    bool holding_;                  // Arrived at holdPosition_; walks back if pushed off it
+    AIVector3 holdPosition_;
+    CharacterID character_;         // 0 until it first moves with AIManager physics set
     std::vector<AIVector3> currentPath_;
     int currentPathIndex_;
     
@@ -355,14 +694,32 @@ private:
     float fieldOfViewAngle_;
     float memoryDuration_;
     
+    // Utility AI, written by AIManager::UpdateUtility()
+    uint32_t utilityAction_;
+    float utilityScore_;
+    
     // Internal methods
+    // Update() is Think(), ApplyIntents() and UpdateMotion(); AIManager runs Think() in parallel and
+    // the others serially, at different rates. UpdateMotion() is Steer() then Integrate(), between
+    // which AIManager replaces the preferred velocity with an avoiding one
+    void Think(float deltaTime);
+    void ApplyIntents();
+    void PublishSnapshot();
+    void UpdateMotion(float deltaTime);
+    void Steer(float deltaTime);
+    void Integrate(float deltaTime);
     void UpdateMovement(float deltaTime);
+    void UpdateFlowMovement(float deltaTime);
+    void SteerTowards(const AIVector3& target, float deltaTime);
+    void ReceivePath();
     void UpdateCombat(float deltaTime);
     void UpdateGroupCoordination(float deltaTime);
     void ProcessPerceptionData();
     void CalculateAccuracy(const AIVector3& target, float& accuracy);
     void ExecutePersonalityBehavior();
     void SetupStateMachine();
+    
+    friend class AIManager;
 };
 
 class AIManager {
@@ -391,15 +748,35 @@ public:
     void DisbandSquad(const std::vector<std::shared_ptr<AIEntity>>& members);
     void SetSquadFormation(const std::vector<std::shared_ptr<AIEntity>>& squad, 
                           const AIFormation& formation);
+    // One flow field for the whole group; member i keeps formation.relativePositions[i] off the goal
+    void MoveSquadTo(const std::vector<std::shared_ptr<AIEntity>>& squad, const AIVector3& goal,
+                     const AIFormation* formation = nullptr);
+    FlowFieldCache& GetFlowFields() { return *flowFields_; }
     
     // Navigation mesh
     void SetNavMesh(std::shared_ptr<NavMesh> navMesh);
     void UpdateNavMesh();
+    // Entity thinking and path searches run on these workers; null keeps them on the AI thread
+    void SetJobSystem(JobSystem* jobs);
+    // Entities then move as character controllers, climbing steps and stopped by walls and
+    // bodies; null moves them freely. Their positions stay at their feet
+    void SetPhysics(PhysicsEngine* physics);
+    PathQueryService& GetPathQueries() { return *pathQueries_; }
     
     // Cover system
     void AddCoverPoint(const AICoverPoint& cover);
     void RemoveCoverPoint(const AIVector3& position);
     std::vector<AICoverPoint> FindCoverPoints(const AIVector3& position, float radius);
+    // Into caller storage, cleared first
+    void FindCoverPoints(const AIVector3& position, float radius, std::vector<AICoverPoint>& results);
+    // Baked cover, found by FindCoverPoints() alongside the added points and shared with pathfinding
+    void SetCoverMap(std::shared_ptr<const CoverMap> coverMap);
+    // Baked cover points within radius shielding from a threat at threatPosition, by table lookup
+    size_t FindSafeCoverPoints(const AIVector3& position, float radius, const AIVector3& threatPosition,
+                               std::vector<AICoverPoint>& results);
+    
+    // Entities within radius, through the entity grid; results is cleared first
+    size_t FindEntitiesInRadius(const AIVector3& position, float radius, std::vector<AIEntity*>& results);
     
     // Global AI events
     void NotifyPlayerPosition(const AIVector3& position);
@@ -408,8 +785,41 @@ public:
     void NotifyAIKilled(std::shared_ptr<AIEntity> entity);
     
     // Performance optimization
+    struct UpdateStats {
+        uint32_t nearEntities = 0;
+        uint32_t midEntities = 0;
+        uint32_t farEntities = 0;
+        uint32_t scheduledThinks = 0;   // Mid and far entities that thought this frame
+        float crowdMilliseconds = 0.0f;
+        float utilityMicroseconds = 0.0f;
+        float updateMilliseconds = 0.0f;
+    };
+    
+    static constexpr float DEFAULT_TIME_BUDGET_MS = 2.0f;
+    static constexpr size_t THINK_CHUNK = 64;   // Scheduled entities thinking between budget checks
+    
+    // LOD distances are measured from here, usually the camera
+    void SetViewerPosition(const AIVector3& position) { viewerPosition_ = position; }
     void SetLODDistances(float nearDistance, float farDistance);
+    // Mid and far entities think until the frame's AI update has used this much time; near
+    // entities always run, and at least one scheduled entity thinks per frame
+    void SetTimeBudget(float milliseconds) { timeBudgetMs_ = milliseconds; }
+    void SetFarThinkInterval(float seconds) { farThinkInterval_ = seconds; }
+    const UpdateStats& GetUpdateStats() const { return updateStats_; }
     void EnableOcclusion(bool enabled);
+    // Local avoidance between moving entities, on by default
+    void EnableCrowdAvoidance(bool enabled) { crowdAvoidanceEnabled_ = enabled; }
+    CrowdAvoidance& GetCrowdAvoidance() { return crowdAvoidance_; }
+    
+    // Utility decisions: every update, before thinking, each living entity scores the actions
+    // over the inputs below and takes the best. An action bound to a state switches the entity
+    // to it. Inputs are in [0, 1]: "health", "aggression", "cautiousness", "intelligence", "alert",
+    // "in cover", "target visible", "target distance" (in sight ranges, clamped), "squad alert"
+    // (fraction of the squad) and "squad strength" (fraction of the squad alive)
+    uint32_t AddUtilityAction(const UtilityAction& action);
+    uint32_t AddUtilityAction(const UtilityAction& action, AIState state);
+    void ClearUtilityActions();
+    UtilityScorer& GetUtility() { return utility_; }
     
     // Debug and analytics
     void SetDebugVisualization(bool enabled);
@@ -418,7 +828,27 @@ public:
 private:
     std::vector<std::shared_ptr<AIEntity>> aiEntities_;
     std::shared_ptr<NavMesh> navMesh_;
+    std::shared_ptr<AIPathfinding> pathfinding_;
+    std::shared_ptr<PathQueryService> pathQueries_;
+    std::shared_ptr<FlowFieldCache> flowFields_;
     std::vector<AICoverPoint> coverPoints_;
+    std::shared_ptr<const CoverMap> coverMap_;
+    
+    // A sound stays audible for SOUND_LIFETIME seconds
+    struct SoundEvent {
+        AIVector3 position;
+        float radius;
+        float age;
+    };
+    static constexpr float SOUND_LIFETIME = 2.0f;
+    
+    AISpatialGrid entityGrid_;
+    AISpatialGrid coverGrid_;                  // Item i is coverPoints_[i]
+    AISpatialGrid soundGrid_;
+    std::vector<AIEntity*> gridEntities_;      // By entity grid item
+    std::vector<SoundEvent> sounds_;           // By sound grid item
+    std::vector<uint32_t> soundItems_;         // Live sound grid items
+    std::vector<uint32_t> queryScratch_;
     
     float difficultyLevel_;
     float globalAccuracyModifier_;
@@ -427,6 +857,28 @@ private:
     
     float nearLODDistance_;
     float farLODDistance_;
+    AIVector3 viewerPosition_;
+    float timeBudgetMs_;
+    float farThinkInterval_;
+    JobSystem* jobs_;
+    std::vector<AIEntity*> nearEntities_;      // This frame's tiers, rebuilt by UpdateLOD()
+    std::vector<AIEntity*> midEntities_;
+    std::vector<AIEntity*> farEntities_;
+    size_t midCursor_;                         // Round-robin position in each tier
+    size_t farCursor_;
+    std::vector<AIEntity*> thinkChunk_;
+    CrowdAvoidance crowdAvoidance_;
+    bool crowdAvoidanceEnabled_;
+    std::vector<AIEntity*> crowdEntities_;     // Agent i of crowdAgents_
+    std::vector<CrowdAgent> crowdAgents_;
+    std::vector<DirectX::XMFLOAT2> crowdVelocities_;
+    PhysicsEngine* physics_;
+    std::vector<CharacterID> moveCharacters_;  // Character i moves moveDisplacements_[i]
+    std::vector<PhysicsVector3> moveDisplacements_;
+    UtilityScorer utility_;
+    std::vector<int> utilityStates_;           // By action; an AIState, or -1 when unbound
+    std::vector<AIEntity*> utilityEntities_;   // Entity i of utility_
+    UpdateStats updateStats_;
     bool occlusionEnabled_;
     bool debugVisualization_;
     
@@ -434,8 +886,16 @@ private:
     float lastPlayerPositionTime_;
     
     void UpdateLOD();
-    void ProcessGlobalEvents();
-    void OptimizePerformance();
+    void ProcessGlobalEvents(float deltaTime);
+    void UpdateSpatialGrids();
+    void UpdateCrowd(float deltaTime);
+    void UpdateUtility();
+    void UpdatePerception(AIEntity& entity);
+    void RebuildCoverGrid();
+    // Perception and Think() for each, spread over the job system
+    void ThinkEntities(const std::vector<AIEntity*>& entities);
+    // Amortized thinking of mid and far entities until the time budget runs out
+    void RunScheduledThinks(const Timer& frameTimer);
 };
 
 // Compatibility alias for legacy code
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "PhysicsEngine.h"
+#include "FluidSystem.h"
 #include <btBulletDynamicsCommon.h>
 #include <BulletSoftBody/btSoftRigidDynamicsWorld.h>
 #include <BulletSoftBody/btSoftBodyHelpers.h>
@@ -37,15 +38,7 @@ public:
         bool enableSelfCollision = false;
     };
 
-    struct FluidSettings {
-        float density = 1000.0f;
-        float viscosity = 0.1f;
-        float surfaceTension = 0.0728f;
-        float gasConstant = 2000.0f;
-        float restDistance = 0.1f;
-        int maxParticles = 10000;
-        XMFLOAT3 containerSize = XMFLOAT3(10.0f, 10.0f, 10.0f);
-    };
+    using FluidSettings = ::Nexus::FluidSettings;
 
 public:
     AdvancedPhysicsEngine();
@@ -69,38 +62,7 @@ public:
     void RemoveSoftBody(btSoftBody* softBody);
 
     // Fluid simulation (SPH - Smoothed Particle Hydrodynamics)
-    class FluidSystem {
-    public:
-        struct Particle {
-            XMFLOAT3 position;
-            XMFLOAT3 velocity;
-            XMFLOAT3 force;
-            float density;
-            float pressure;
-            float mass;
-            int id;
-        };
-
-        bool Initialize(const FluidSettings& settings);
-        void Update(float deltaTime);
-        void AddParticle(const XMFLOAT3& position, const XMFLOAT3& velocity = XMFLOAT3(0, 0, 0));
-        void RemoveParticle(int particleId);
-        const std::vector<Particle>& GetParticles() const { return particles_; }
-        void SetBounds(const XMFLOAT3& min, const XMFLOAT3& max);
-
-    private:
-        void CalculateDensityPressure();
-        void CalculateForces();
-        void Integrate(float deltaTime);
-        void HandleCollisions();
-        float SmoothingKernel(float distance, float radius);
-        XMFLOAT3 SmoothingKernelGradient(const XMFLOAT3& r, float radius);
-
-        std::vector<Particle> particles_;
-        FluidSettings settings_;
-        XMFLOAT3 boundsMin_, boundsMax_;
-        int nextParticleId_;
-    };
+    using FluidSystem = ::Nexus::FluidSystem;
 
     // Destruction system
     class DestructionSystem {
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "ClothSolver.h"
 #include "Platform.h"
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
 #include <functional>
 #include <thread>
@@ -11,6 +14,10 @@
 
 namespace Nexus {
 
+class CompressedClip;
+class TaskGraph;
+class Camera;
+
 /**
  * Advanced animation system with skeletal animation, blending, and IK
  */
@@ -70,8 +77,11 @@ public:
         std::vector<Keyframe> keyframes;
         InterpolationType interpolationType;
         
-        // Find keyframes for interpolation
+        // Find keyframes for interpolation; before the first or after the last key both indices
+        // are that key. cursor is the key the previous sample stopped at: the search starts there
+        // and updates it, so playback costs O(1) per sample and a seek falls back to a binary search
         void FindKeyframes(float time, int& prevIndex, int& nextIndex, float& t) const;
+        void FindKeyframes(float time, int& prevIndex, int& nextIndex, float& t, int& cursor) const;
         
         // Interpolate between keyframes
         DirectX::XMFLOAT3 InterpolatePosition(float time) const;
@@ -91,6 +101,32 @@ public:
         bool hasRootMotion;
         DirectX::XMFLOAT3 rootMotionDelta;
         DirectX::XMFLOAT4 rootRotationDelta;
+        
+        // Sampled instead of tracks when set; tracks are emptied once compressed
+        std::shared_ptr<const CompressedClip> compressed;
+    };
+
+    // Local bone transforms as structure of arrays: each stream holds one component of every
+    // bone, so an SSE register covers four bones. Streams are padded to whole groups of four,
+    // and padding bones hold the identity
+    struct Pose {
+        enum Stream {
+            TRANSLATION_X, TRANSLATION_Y, TRANSLATION_Z,
+            ROTATION_X, ROTATION_Y, ROTATION_Z, ROTATION_W,
+            SCALE_X, SCALE_Y, SCALE_Z,
+            STREAM_COUNT
+        };
+        
+        std::vector<float> storage;                // STREAM_COUNT streams of stride floats each
+        size_t stride = 0;
+        size_t boneCount = 0;
+        
+        float* operator[](Stream stream) { return storage.data() + stream * stride; }
+        const float* operator[](Stream stream) const { return storage.data() + stream * stride; }
+        // Every bone back to the identity; only allocates when the skeleton grows
+        void Resize(size_t boneCount);
+        void SetBone(size_t bone, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT4& rotation,
+                     const DirectX::XMFLOAT3& scale);
     };
 
     struct Skeleton {
@@ -99,16 +135,29 @@ public:
         std::map<std::string, int> boneNameToIndex;
         DirectX::XMFLOAT4X4 rootTransform;
         
+        // bindPose of every bone, decomposed, and the local pose the animation system blends into
+        Pose bindLocalPose;
+        Pose pose;
+        Pose samplePose;                                     // Scratch for one instance while blending
+        std::vector<DirectX::XMFLOAT4X4> skinningMatrices;   // inverseBindPose * model, ready for upload
+        // Last animation LOD each bone is sampled at, bind pose beyond it; empty means every LOD
+        std::vector<uint8_t> boneLodLimit;
+        
+        bool ownedByCharacter = false;                       // Updated by that character's job
+        
         // Find bone by name
         int FindBoneIndex(const std::string& name) const;
         
-        // Build bone hierarchy
+        // Build bone hierarchy and reset the pose to the bind pose
         void BuildHierarchy();
+        void ResetPose();
         
-        // Update bone transforms
+        // Local pose to model and skinning matrices in a single pass, four bones at a time. A bone's
+        // parent has to come before it. Also fills each bone's local, current, world and final transform
         void UpdateBoneTransforms();
         
         // Get final bone matrices for rendering
+        const std::vector<DirectX::XMFLOAT4X4>& GetSkinningMatrices() const { return skinningMatrices; }
         void GetBoneMatrices(std::vector<DirectX::XMMATRIX>& matrices) const;
     };
 
@@ -127,7 +176,13 @@ public:
         int layer;
         int priority;
         
-        // Callbacks
+        // Keyframe cursor of each clip track, or of each channel of a compressed one; see
+        // AnimationTrack::FindKeyframes
+        std::vector<int> trackCursors;
+        
+        bool ownedByCharacter = false;
+        
+        // Callbacks; a character's instances call them from its job, on any worker
         std::function<void()> onAnimationComplete;
         std::function<void(const std::string&)> onAnimationEvent;
         
@@ -182,7 +237,10 @@ public:
         void SetBlendPosition(const DirectX::XMFLOAT2& pos);
     };
 
-    // Animation state machine
+    // Animation state machine. Compile() resolves state names to dense indices, groups transitions
+    // by source state and points parameter conditions at slots of the packed parameters block, so
+    // Update() runs without string compares or map lookups. The Add* methods recompile on the next
+    // update; call Compile() after editing states or transitions directly
     struct AnimationStateMachine {
         struct State {
             std::string name;
@@ -197,16 +255,28 @@ public:
             std::function<void(float)> onUpdate;
         };
         
+        // Compares a parameter against a constant
+        struct Condition {
+            enum class Op : uint8_t { Greater, Less, Equal, NotEqual };
+            
+            std::string parameter;
+            Op op;
+            float value;
+        };
+        
         struct Transition {
             std::string fromState;
             std::string toState;
             float duration;
-            std::function<bool()> condition;
+            std::function<bool()> condition;      // Checked after conditions; slower, prefer parameters
             bool hasExitTime;
-            float exitTime;
+            float exitTime;                       // Normalized time of the source state's clip
             bool canInterrupt;
+            std::vector<Condition> conditions;    // All must hold
         };
         
+        static constexpr int INVALID_STATE = -1;
+        
         std::map<std::string, State> states;
         std::vector<Transition> transitions;
         std::string currentState;
@@ -214,12 +284,59 @@ public:
         float transitionTime;
         float transitionDuration;
         bool isTransitioning;
+        bool ownedByCharacter = false;
+        
+        // Packed parameter block read by transition conditions
+        std::vector<float> parameters;
+        std::map<std::string, int> parameterIndices;
         
         void AddState(const std::string& name, const State& state);
         void AddTransition(const Transition& transition);
         void SetState(const std::string& stateName);
+        // Index of an existing parameter, or of a new one set to value
+        int AddParameter(const std::string& name, float value = 0.0f);
+        int GetParameterIndex(const std::string& name) const;
+        void SetParameter(int index, float value) { parameters[index] = value; }
+        void SetParameter(const std::string& name, float value);
+        int GetStateIndex(const std::string& name) const;
+        int GetCurrentStateIndex() const { return currentIndex; }
+        void Compile();
+        void Update(float deltaTime);
         void Update(float deltaTime, Skeleton& skeleton);
         bool CanTransition(const std::string& fromState, const std::string& toState) const;
+        
+        // Compiled form, rebuilt by Compile()
+        struct CompiledCondition {
+            uint32_t parameter;
+            Condition::Op op;
+            float value;
+        };
+        
+        struct CompiledTransition {
+            int toState;
+            uint32_t firstCondition;
+            uint32_t conditionCount;
+            uint32_t source;                      // Into transitions, for its condition callback
+            float duration;
+            float exitTime;                       // Negative without exit time
+            bool hasCallback;
+            bool canInterrupt;
+        };
+        
+        std::vector<State*> compiledStates;
+        std::vector<const std::string*> stateNames;
+        std::vector<uint32_t> firstTransition;    // Per state plus one, into compiledTransitions
+        std::vector<CompiledTransition> compiledTransitions;
+        std::vector<CompiledCondition> compiledConditions;
+        int currentIndex = INVALID_STATE;
+        int targetIndex = INVALID_STATE;
+        int activeTransition = -1;
+        float stateTime = 0.0f;
+        bool compiled = false;
+        
+    private:
+        bool ConditionsHold(const CompiledTransition& transition) const;
+        void EnterState(int index);
     };
 
     // IK solver - FIXED VERSION with all required members
@@ -237,6 +354,7 @@ public:
         float tolerance;
         int maxIterations;
         SolverType type;  // Add this missing member
+        bool ownedByCharacter = false;
         
         IKSolver() : tolerance(0.01f), maxIterations(10), type(SolverType::CCD) {}
         
@@ -247,48 +365,72 @@ public:
         void SolveJacobian(Skeleton& skeleton);
     };
 
-    // Facial animation support
+    // Facial animation support. Shapes are sparse once compacted: deltas are kept only for the
+    // vertices a shape moves, and shapes at zero weight cost nothing. SkinningSystem applies them
+    // on the GPU; BlendShapes() is the CPU path
     struct FacialAnimation {
         struct BlendShape {
             std::string name;
             std::vector<DirectX::XMFLOAT3> deltaVertices;
             std::vector<DirectX::XMFLOAT3> deltaNormals;
+            std::vector<uint32_t> vertexIndices;   // Vertex of each delta; empty while dense
             float weight;
         };
         
         std::vector<BlendShape> blendShapes;
         std::map<std::string, float> expressionWeights;
         
+        // Sets the weight of every shape named expression
         void SetExpressionWeight(const std::string& expression, float weight);
         void BlendShapes(std::vector<DirectX::XMFLOAT3>& vertices, std::vector<DirectX::XMFLOAT3>& normals);
+        // Drops the deltas of dense shapes that move a vertex less than epsilon
+        void Compact(float epsilon = 1e-5f);
     };
 
-    // Cloth simulation for capes, hair, etc.
-    struct ClothSimulation {
-        struct ClothParticle {
-            DirectX::XMFLOAT3 position;
-            DirectX::XMFLOAT3 oldPosition;
-            DirectX::XMFLOAT3 velocity;
-            float mass;
-            bool isPinned;
-        };
+    // Cloth for capes, flags, hair; see ClothSolver
+    using ClothSimulation = ClothSolver;
+
+    // One animated character: its instances are advanced and blended onto the skeleton, then the
+    // state machine and IK solvers run and the matrix palette is built, all in one job. Characters
+    // update in parallel; an attached character's job waits for its parent's
+    struct Character {
+        std::string name;
+        std::shared_ptr<Skeleton> skeleton;
+        std::vector<std::shared_ptr<AnimationInstance>> instances;
+        std::shared_ptr<AnimationStateMachine> stateMachine;
+        std::vector<std::shared_ptr<IKSolver>> ikSolvers;
         
-        struct ClothConstraint {
-            int particle1, particle2;
-            float restLength;
-            float stiffness;
-        };
+        // Character space to world; set by the game for free characters, computed for attachments
+        // as attachmentOffset * parent bone model transform * parent worldTransform
+        DirectX::XMFLOAT4X4 worldTransform;
+        std::weak_ptr<Character> parent;
+        int parentBone = -1;
+        DirectX::XMFLOAT4X4 attachmentOffset;
         
-        std::vector<ClothParticle> particles;
-        std::vector<ClothConstraint> constraints;
-        DirectX::XMFLOAT3 gravity;
-        float damping;
-        float windForce;
-        DirectX::XMFLOAT3 windDirection;
+        // Animation LOD, picked every frame from the screen height of a sphere of boundingRadius
+        // around the worldTransform origin; see AnimationLodLevel
+        float boundingRadius = 1.0f;
+        int lod = 0;
+        bool culled = false;                 // Past the max animation distance; only clocks advance
+        bool facialActive = true;            // Whether the level wants blend shapes applied
+        std::vector<std::shared_ptr<ClothSimulation>> cloths;   // Stepped while the level allows
         
-        void Update(float deltaTime);
-        void ApplyConstraints();
-        void HandleCollisions(const std::vector<DirectX::XMFLOAT3>& colliders);
+        // The last two sampled poses, interpolated between on frames a level skips
+        Pose previousPose;
+        Pose sampledPose;
+        bool hasSample = false;
+        int framesSinceSample = 0;
+        int updatePhase = 0;                 // Spreads the sampling frames of one level
+    };
+
+    // Detail level for characters whose projected bounding sphere is at least minScreenHeight
+    // pixels tall; levels go from finest to coarsest
+    struct AnimationLodLevel {
+        float minScreenHeight;
+        int updateInterval;                  // Sample every Nth frame, interpolating in between
+        bool ik;
+        bool cloth;
+        bool facial;
     };
 
 public:
@@ -298,17 +440,48 @@ public:
     // Initialization
     bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
     void Shutdown();
+    // Cloths step in parallel across it, and large ones split their passes too
+    void SetJobSystem(JobSystem* jobs);
+    // Characters update as jobs on the job system; on by default
+    void EnableMultithreading(bool enable);
+
+    // Characters. Each skeleton, instance, state machine and IK solver belongs to at most one, and
+    // Update() leaves what a character owns to its job
+    std::shared_ptr<Character> CreateCharacter(const std::string& name, std::shared_ptr<Skeleton> skeleton);
+    std::shared_ptr<Character> GetCharacter(const std::string& name);
+    void RemoveCharacter(const std::string& name);
+    bool AddCharacterAnimation(const std::string& characterName, const std::string& instanceName);
+    bool SetCharacterStateMachine(const std::string& characterName, const std::string& stateMachineName);
+    bool AddCharacterIKSolver(const std::string& characterName, const std::string& solverName);
+    // Follows boneName of parentName; an empty parentName detaches
+    bool AttachCharacter(const std::string& characterName, const std::string& parentName,
+                         const std::string& boneName, const DirectX::XMFLOAT4X4& offset);
+    bool AddCharacterCloth(const std::string& characterName, const std::string& clothName);
+
+    // Animation LOD. SetView() once per frame before Update(); without it every character stays
+    // at level 0. viewportHeight is in pixels
+    void SetView(const Camera& camera, float viewportHeight);
+    void SetLodLevels(const std::vector<AnimationLodLevel>& levels);
+    const std::vector<AnimationLodLevel>& GetLodLevels() const { return lodLevels_; }
+    // The bone and all bones below it stop animating past lastLod, e.g. fingers and face at 0
+    void SetBoneLodLimit(const std::string& skeletonName, const std::string& boneName, int lastLod);
 
     // Skeleton management
     std::shared_ptr<Skeleton> CreateSkeleton(const std::string& name);
     std::shared_ptr<Skeleton> GetSkeleton(const std::string& name);
     void RemoveSkeleton(const std::string& name);
 
-    // Animation clip management
+    // Animation clip management. .nanim files load compressed
     std::shared_ptr<AnimationClip> LoadAnimationClip(const std::string& filePath);
     std::shared_ptr<AnimationClip> CreateAnimationClip(const std::string& name);
     std::shared_ptr<AnimationClip> GetAnimationClip(const std::string& name);
     void RemoveAnimationClip(const std::string& name);
+    // Replaces the clip's keyframes with a CompressedClip within the compression tolerances
+    bool CompressAnimationClip(const std::string& name);
+    // Writes the clip as .nanim, compressing it first if it isn't yet
+    bool SaveAnimationClip(const std::string& name, const std::string& filePath);
+    // Furthest a compressed clip may stray: units for positions and scales, radians for rotations
+    void SetCompressionTolerances(float position, float rotation, float scale);
 
     // Animation instance management
     std::shared_ptr<AnimationInstance> CreateAnimationInstance(const std::string& name, 
@@ -345,7 +518,7 @@ public:
     void SetFacialExpression(const std::string& animName, 
                            const std::string& expression, float weight);
 
-    // Cloth simulation
+    // Cloth simulation; Update() steps every cloth
     std::shared_ptr<ClothSimulation> CreateClothSimulation(const std::string& name);
     void UpdateClothSimulation(const std::string& name, float deltaTime);
 
@@ -369,7 +542,7 @@ public:
                         std::vector<DirectX::XMMATRIX>& matrices);
 
     // Performance optimization
-    void SetLOD(int level); // Level of detail for distant objects
+    void SetLOD(int level); // Coarsest of this and the screen size level is used
     void EnableCulling(bool enable);
     void SetMaxAnimationDistance(float distance);
 
@@ -385,11 +558,19 @@ public:
 
 private:
     // Animation processing
+    void UpdateCharacters(float deltaTime);
+    void UpdateCharacter(Character& character, float deltaTime);
+    // Parents ahead of their attachments, and the task graph with an edge from each parent
+    void BuildCharacterSchedule();
+    void SelectCharacterLod(Character& character) const;
     void ProcessAnimationInstance(std::shared_ptr<AnimationInstance> instance, 
                                  float deltaTime);
+    // Weighted nlerp of the instances' poses into skeleton.pose, sampling the bones lod keeps
     void BlendPoses(Skeleton& skeleton, 
-                   const std::vector<std::shared_ptr<AnimationInstance>>& instances);
-    void InterpolateKeyframes(const AnimationTrack& track, float time,
+                   const std::vector<std::shared_ptr<AnimationInstance>>& instances, int lod = 0);
+    // The bind pose with the instance's tracks sampled over it
+    void SamplePose(const Skeleton& skeleton, AnimationInstance& instance, Pose& pose, int lod = 0);
+    void InterpolateKeyframes(const AnimationTrack& track, float time, int& cursor,
                             DirectX::XMFLOAT3& position, DirectX::XMFLOAT4& rotation, 
                             DirectX::XMFLOAT3& scale);
 
@@ -413,8 +594,15 @@ private:
     std::map<std::string, std::shared_ptr<IKSolver>> ikSolvers_;
     std::map<std::string, std::shared_ptr<FacialAnimation>> facialAnimations_;
     std::map<std::string, std::shared_ptr<ClothSimulation>> clothSimulations_;
+    std::vector<ClothSimulation*> clothUpdates_;
+    std::map<std::string, std::shared_ptr<Character>> characters_;
     
     // Performance settings
+    std::vector<AnimationLodLevel> lodLevels_;
+    std::set<const ClothSimulation*> characterCloths_;
+    DirectX::XMFLOAT3 cameraPosition_;
+    float pixelsPerUnit_;                    // Viewport height over the view height at unit distance
+    uint32_t animationFrame_;
     int lodLevel_;
     bool cullingEnabled_;
     float maxAnimationDistance_;
@@ -423,8 +611,14 @@ private:
     bool debugVisualization_;
     
     // Threading support
+    JobSystem* jobs_;
     bool multithreadingEnabled_;
-    std::vector<std::thread> workerThreads_;
+    
+    // Character schedule, rebuilt when characters or attachments change
+    std::vector<Character*> characterOrder_;
+    std::unique_ptr<TaskGraph> characterGraph_;
+    bool characterScheduleDirty_;
+    float characterDeltaTime_;
     
     // Animation compression
     bool compressionEnabled_;
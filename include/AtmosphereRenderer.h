@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+
+namespace Nexus {
+
+class StateCache;
+
+/**
+ * Physically based sky from precomputed scattering lookup tables (Hillaire 2020).
+ *
+ * Three compute-generated tables replace per-pixel integration through the atmosphere:
+ * transmittance to the top of the atmosphere by altitude and zenith angle, the multiple
+ * scattering contribution by altitude and sun zenith angle, and a low-resolution sky-view table
+ * holding the sky radiance around the camera by view zenith and azimuth relative to the sun.
+ * The first two depend only on the atmosphere and are rebuilt when the settings change. The
+ * sky view depends on the sun elevation and the camera altitude and is redrawn only once either
+ * moves past its threshold; the sun's azimuth is applied at lookup. RenderSky() then costs one
+ * sky-view fetch per pixel, plus a transmittance fetch inside the sun disk.
+ */
+class AtmosphereRenderer {
+public:
+    struct Settings {
+        DirectX::XMFLOAT3 rayleighScattering = DirectX::XMFLOAT3(0.0054f, 0.0135f, 0.0331f);  // Per km
+        DirectX::XMFLOAT3 mieScattering = DirectX::XMFLOAT3(0.004f, 0.004f, 0.004f);          // Per km
+        DirectX::XMFLOAT3 ozoneAbsorption = DirectX::XMFLOAT3(0.00065f, 0.00188f, 0.000085f); // Per km
+        float planetRadius = 6360e3f;        // Meters, like the other distances
+        float atmosphereRadius = 6420e3f;
+        float rayleighScaleHeight = 8e3f;
+        float mieScaleHeight = 1.2e3f;
+        float ozoneLayerCenter = 25e3f;
+        float ozoneLayerWidth = 15e3f;       // Half width of the ozone density tent
+        float mieAnisotropy = 0.8f;
+        float groundAlbedo = 0.3f;
+        float sunIntensity = 20.0f;          // Illuminance at the top of the atmosphere
+        float sunAngularRadius = 0.00465f;   // Radians
+
+        UINT transmittanceWidth = 256;
+        UINT transmittanceHeight = 64;
+        UINT multiScatteringSize = 32;
+        UINT skyViewWidth = 192;
+        UINT skyViewHeight = 108;
+
+        float sunAngleThreshold = 0.002f;    // Radians of sun elevation change before the sky view is redrawn
+        float heightThreshold = 10.0f;       // Meters of camera altitude change before the sky view is redrawn
+    };
+
+    struct Stats {
+        uint32_t scatteringUpdates = 0;      // Transmittance and multiple scattering rebuilds
+        uint32_t skyViewUpdates = 0;
+    };
+
+    AtmosphereRenderer();
+    ~AtmosphereRenderer();
+
+    AtmosphereRenderer(const AtmosphereRenderer&) = delete;
+    AtmosphereRenderer& operator=(const AtmosphereRenderer&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings);
+    void Shutdown();
+
+    // Rebuilds every table on the next Update()
+    bool SetSettings(const Settings& settings);
+    const Settings& GetSettings() const { return settings_; }
+
+    // sunDirection points towards the sun with y up; cameraHeight is the camera's altitude in
+    // meters. Regenerates the tables that are out of date
+    void Update(const DirectX::XMFLOAT3& sunDirection, float cameraHeight);
+
+    // Draws the sky behind everything already in depthTarget over its width x height top-left
+    // region. view and projection are the row-vector camera matrices of a perspective projection
+    void RenderSky(StateCache& stateCache, ID3D11RenderTargetView* target, ID3D11DepthStencilView* depthTarget,
+                   DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, UINT width, UINT height);
+
+    // RGBA16F tables, valid after Update()
+    ID3D11ShaderResourceView* GetTransmittanceLut() const { return transmittanceView_; }
+    ID3D11ShaderResourceView* GetMultiScatteringLut() const { return multiScatteringView_; }
+    ID3D11ShaderResourceView* GetSkyViewLut() const { return skyViewView_; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    // Matches AtmosphereConstants in AtmosphereRenderer.cpp
+    struct GpuConstants {
+        DirectX::XMFLOAT4X4 inverseView;      // Rotation only, transposed for HLSL
+        DirectX::XMFLOAT3 rayleighScattering;
+        float bottomRadius;                   // km
+        DirectX::XMFLOAT3 mieScattering;
+        float topRadius;
+        DirectX::XMFLOAT3 ozoneAbsorption;
+        float rayleighScaleHeight;
+        DirectX::XMFLOAT3 sunDirection;
+        float mieScaleHeight;
+        DirectX::XMFLOAT3 sunIlluminance;
+        float ozoneCenter;
+        float ozoneWidth;
+        float mieAnisotropy;
+        float groundAlbedo;
+        float cameraRadius;
+        float sunAngularRadius;
+        float padding;
+        float projectionScale[2];
+        UINT transmittanceSize[2];
+        UINT multiScatteringSize[2];
+        UINT skyViewSize[2];
+        float padding2[2];
+    };
+
+    bool CreateShaders();
+    bool CreateTables();
+    void ReleaseTables();
+    bool UploadConstants(const GpuConstants& constants);
+    GpuConstants BuildConstants() const;
+    void Dispatch(ID3D11ComputeShader* shader, ID3D11UnorderedAccessView* target, UINT width, UINT height);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    Settings settings_;
+
+    ID3D11ComputeShader* transmittanceShader_;
+    ID3D11ComputeShader* multiScatteringShader_;
+    ID3D11ComputeShader* skyViewShader_;
+    ID3D11VertexShader* skyVertexShader_;
+    ID3D11PixelShader* skyPixelShader_;
+    ID3D11Buffer* constants_;
+    ID3D11SamplerState* linearClamp_;
+    ID3D11RasterizerState* rasterizerState_;
+    ID3D11DepthStencilState* depthState_;
+
+    ID3D11Texture2D* transmittance_;
+    ID3D11ShaderResourceView* transmittanceView_;
+    ID3D11UnorderedAccessView* transmittanceTarget_;
+    ID3D11Texture2D* multiScattering_;
+    ID3D11ShaderResourceView* multiScatteringView_;
+    ID3D11UnorderedAccessView* multiScatteringTarget_;
+    ID3D11Texture2D* skyView_;
+    ID3D11ShaderResourceView* skyViewView_;
+    ID3D11UnorderedAccessView* skyViewTarget_;
+
+    bool scatteringValid_;
+    bool skyViewValid_;
+    DirectX::XMFLOAT3 sunDirection_;
+    float skyViewSunElevation_;   // Radians, what the sky view was drawn for
+    float skyViewHeight_;         // Meters
+    Stats stats_;
+};
+
+} // namespace Nexus
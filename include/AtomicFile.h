@@ -0,0 +1,15 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+
+namespace Nexus {
+
+// Runs write on filename + ".tmp" and renames the result over filename once the stream is
+// still good, so a crash or failed write mid-save leaves the previous file intact. The temporary
+// is removed on every failure; callers report their own error
+bool WriteFileAtomic(const std::string& filename, const std::function<void(std::ostream&)>& write,
+                     std::ios::openmode mode = std::ios::binary);
+
+} // namespace Nexus
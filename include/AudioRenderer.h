@@ -0,0 +1,351 @@
+#pragma once
+
+#include "AudioResampler.h"
+#include "AudioSynth.h"
+#include "EnvironmentReverb.h"
+#include "HRTFSpatializer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+// Decoded PCM a decoder thread keeps ahead of a streaming voice. The decoder is the only writer
+// of written and end, the voice the only writer of consumed
+struct AudioStreamBuffer {
+    std::unique_ptr<float[]> samples;          // capacity frames of channels floats, a ring
+    uint32_t capacity;                         // Frames, a power of two
+    uint16_t channels;
+    alignas(64) std::atomic<uint64_t> written{ 0 };
+    alignas(64) std::atomic<uint64_t> consumed{ 0 };   // Frames before the voice's earliest tap
+    std::atomic<uint64_t> end{ UINT64_MAX };   // Set to written once the decoder runs out
+};
+
+// PCM the renderer reads a voice from. The game thread keeps the owning buffer alive until the
+// voice is reported done
+struct AudioClip {
+    const uint8_t* data;
+    AudioStreamBuffer* stream;                 // Read instead of data when set
+    uint32_t frameCount;
+    uint32_t sampleRate;
+    uint16_t channels;
+    uint16_t bitsPerSample;                    // 8, 16, 24 or 32 bit integer PCM
+    bool isFloat;                              // 32-bit float instead
+};
+
+// One channel of clip as floats, for loading data the renderer processes rather than plays
+std::vector<float> DecodeClip(const AudioClip& clip, uint16_t channel);
+
+// A stage of a bus's effect chain, processing a block of interleaved frames in place. A chain
+// runs on one thread at a time, but different buses' chains run at once on the JobSystem
+class AudioBusEffect {
+public:
+    virtual ~AudioBusEffect() = default;
+    virtual void Apply(float* samples, int sampleCount, int channels) = 0;
+};
+
+// A bus's effects in order. Owned by the renderer once submitted, which only reads the pointers,
+// so the references are taken and dropped on the game thread
+struct AudioBusChain {
+    std::vector<std::shared_ptr<AudioBusEffect>> effects;
+};
+
+enum class AudioCommandType : uint8_t {
+    Play,                                      // clip, from the start
+    PlaySynth,                                 // synth, from the start, in place of a clip
+    Stop,
+    Pause,
+    Resume,
+    Seek,                                      // Cursor to source frame values[0], output frames for a synth
+    SetParam,                                  // param = values[0]
+    Fade,                                      // Volume ramps to values[0] over values[1] seconds
+    SetPosition,                               // values[0..2]
+    SetVelocity,                               // values[0..2]
+    SetListenerPosition,                       // values[0..2]
+    SetListenerVelocity,                       // values[0..2]
+    SetListenerOrientation,                    // forward values[0..2], up values[3..5]
+    SetMasterVolume,                           // values[0]
+    SetReverb,                                 // decay, HF ratio, pre-delay, room size, diffusion, level
+    SetConvolution,                            // convolution replaces the reverb just set
+    SetSpatializer,                            // Non-zero values[0] renders spatial voices binaurally,
+                                               // values[1] of them through their own HRTF
+    SetBus,                                    // voice is the bus: volume values[0], parent values[1],
+                                               // non-zero values[2] while it exists
+    SetBusChain                                // chain replaces the effects of bus voice
+};
+
+enum class AudioVoiceParam : uint8_t {
+    Volume,
+    Pitch,
+    Pan,                                       // -1 left to 1 right, for 2D voices
+    Looping,
+    Spatial,                                   // Non-zero attenuates and pans from the listener
+    MinDistance,
+    MaxDistance,
+    Rolloff,
+    Occlusion,                                 // 0 clear to 1 fully blocked
+    LowPass,                                   // Cutoff in Hz, 0 for none
+    Quality,                                   // An AudioResampleQuality
+    Bus,                                       // Mixed into this bus, the master if it doesn't exist
+    // A synth voice's patch, gliding to the new value over the next block
+    Frequency,
+    Tone,
+    Noise,
+    Cutoff,
+    Resonance,
+    ModRate,
+    ModDepth
+};
+
+// Trivially copyable so the ring never allocates or touches a refcount
+struct AudioCommand {
+    AudioCommandType type;
+    AudioVoiceParam param;
+    uint32_t voice;
+    uint32_t generation;                       // Play: echoed back in the voice's done event
+    union {
+        AudioClip clip;
+        AudioSynth synth;
+        float values[6];
+        ConvolutionReverb* convolution;        // Owned by the renderer once submitted
+        AudioBusChain* chain;                  // Likewise
+    };
+};
+
+// Posted by the audio thread when a voice stops, by reaching its end or a Stop command
+struct AudioVoiceEvent {
+    uint32_t voice;
+    uint32_t generation;
+    bool finished;                             // Played to the end rather than stopped
+};
+
+/**
+ * Wait-free single producer, single consumer ring of fixed capacity.
+ *
+ * Push and Pop each touch one index the other side only reads, so neither ever blocks or
+ * allocates. Push fails when full rather than waiting for the consumer. Stage() writes without
+ * publishing, so a group of items staged together reaches the consumer at once on Publish().
+ */
+template <typename T, size_t Capacity>
+class AudioRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    AudioRing() : items_(std::make_unique<T[]>(Capacity)) {}
+
+    bool Push(const T& item) {
+        if (!Stage(item)) return false;
+        Publish();
+        return true;
+    }
+
+    bool Stage(const T& item) {
+        if (staged_ - tail_.load(std::memory_order_acquire) >= Capacity) return false;
+        items_[staged_ & (Capacity - 1)] = item;
+        staged_++;
+        return true;
+    }
+
+    void Publish() { head_.store(staged_, std::memory_order_release); }
+
+    bool Pop(T& item) {
+        size_t t = tail_.load(std::memory_order_relaxed);
+        if (t == head_.load(std::memory_order_acquire)) return false;
+        item = items_[t & (Capacity - 1)];
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::unique_ptr<T[]> items_;
+    size_t staged_ = 0;                        // Producer only, head_ once published
+    alignas(64) std::atomic<size_t> head_{0};  // Written by the producer
+    alignas(64) std::atomic<size_t> tail_{0};  // Written by the consumer
+};
+
+/**
+ * Real-time software mixer for the audio thread.
+ *
+ * The game thread owns voice slots and drives them only through Submit(), which stages onto a
+ * command ring, and Flush(), which hands everything staged since to the audio thread at once.
+ * Render() drains the ring at every block boundary, so a voice never plays a block with half its
+ * parameters applied. Voice state lives in arrays preallocated by Initialize(), so rendering never
+ * locks, allocates or touches a shared_ptr, and a hitching frame only delays when commands land,
+ * not the output. Each block a voice gathers the source frames it will read, resamples them for its
+ * pitch, Doppler shift and sample rate at its own quality, and mixes them with gains that ramp
+ * across the block so parameter changes don't click. Synth voices generate their block instead, at
+ * the output rate with pitch and Doppler applied to the oscillator, and otherwise mix like a mono
+ * clip. Spatial voices are attenuated and panned from the listener, or with the spatializer on,
+ * handed to an HRTFSpatializer as mono for binaural rendering, on the JobSystem's workers when one
+ * is set. Voices that stop are reported back through PollEvent() so the game thread can reuse the
+ * slot and release the clip.
+ *
+ * Voices mix into buses, which form a tree under the master: each bus runs its effect chain on
+ * its block and adds it to its parent at its volume. Buses at the same depth don't feed each
+ * other, so the audio thread takes the tree a depth at a time from the deepest, running that
+ * depth's chains in parallel on the JobSystem and then adding each into its parent. Binaural
+ * voices and the environment reverb go straight to the master, and the reverb send is taken
+ * before the bus. Bus blocks are preallocated; chains come and go like convolutions.
+ *
+ * Spatial voices also feed the environment reverb, an FDNReverb or a submitted ConvolutionReverb.
+ * Changing the reverb switches to a second slot and lets the first ring out with no input, so the
+ * old room's tail isn't cut off. Convolutions the renderer is done with come back through
+ * CollectConvolutions() to be freed off the audio thread. Output is always rendered a whole block
+ * at a time, however Render() is called, since a convolution can't take less.
+ */
+class AudioRenderer {
+public:
+    static constexpr uint32_t MAX_VOICES = 256;
+    static constexpr uint32_t BLOCK_FRAMES = 256;
+    static constexpr size_t COMMAND_CAPACITY = 4096;
+    static constexpr size_t CONVOLUTION_CAPACITY = 16;
+    static constexpr uint32_t MAX_BUSES = 32;
+    static constexpr uint32_t MASTER_BUS = 0;
+    static constexpr size_t BUS_CHAIN_CAPACITY = 64;
+
+    AudioRenderer();
+    ~AudioRenderer();
+
+    bool Initialize(int sampleRate, int channels);
+    int GetSampleRate() const { return sampleRate_; }
+    int GetChannels() const { return channels_; }
+
+    // Game thread. False when the ring is full and the command was dropped
+    bool Submit(const AudioCommand& command);
+    void Flush() { commands_.Publish(); }
+    bool PollEvent(AudioVoiceEvent& event) { return events_.Pop(event); }
+    // False, freeing it, when too many are in flight or the block size doesn't match
+    bool SubmitConvolution(std::unique_ptr<ConvolutionReverb> convolution);
+    // Frees the convolutions the audio thread has let go of
+    void CollectConvolutions();
+    // Replaces bus's effects; a null chain clears them. False, freeing it, when too many are in flight
+    bool SubmitBusChain(uint32_t bus, std::unique_ptr<AudioBusChain> chain);
+    // Frees the chains the audio thread has let go of, releasing their effects
+    void CollectBusChains();
+    // Workers the spatializer renders on, or null for the audio thread alone. Once this returns
+    // the audio thread has stopped using the previous one
+    void SetJobSystem(JobSystem* jobs);
+
+    // Audio thread. Writes frameCount interleaved frames, draining commands every BLOCK_FRAMES
+    void Render(float* output, uint32_t frameCount);
+
+    // Any thread
+    uint32_t GetActiveVoiceCount() const { return activeVoices_.load(std::memory_order_relaxed); }
+    float GetPeakLevel(int channel) const { return peaks_[channel].load(std::memory_order_relaxed); }
+    uint64_t GetDroppedCommandCount() const { return droppedCommands_.load(std::memory_order_relaxed); }
+
+private:
+    struct Voice {
+        AudioClip clip;
+        AudioSynthVoice synth;                 // Generates the voice instead when synthesized
+        uint32_t generation;
+        double cursor;                         // In source frames, or output frames for a synth
+        float volume;
+        float fadeStep;                        // Per frame, towards fadeTarget
+        float fadeTarget;
+        float fade;
+        float pitch;
+        float pan;
+        float minDistance;
+        float maxDistance;
+        float rolloff;
+        float occlusion;
+        float lowPass;
+        float filter[2];                       // Low-pass state, left and right
+        AudioResampleQuality quality;
+        float position[3];
+        float velocity[3];
+        float gain[3];                         // Reached at the end of the last block: left, right, reverb
+        uint32_t bus;
+        bool active;
+        bool paused;
+        bool looping;
+        bool spatial;
+        bool synthesized;
+        bool donePending;                      // Stopped but the event ring was full
+        bool finished;
+    };
+
+    struct ReverbSlot {
+        FDNReverb fdn;
+        ConvolutionReverb* convolution;        // Used instead of fdn when set
+        float level;
+        uint32_t ringing;                      // Frames of tail left once switched away from
+    };
+
+    struct Bus {
+        uint32_t parent;
+        float volume;
+        float gain;                            // Reached at the end of the last block
+        AudioBusChain* chain;
+        uint32_t depth;                        // Buses between it and the master
+        bool exists;
+        bool fed;                              // Something was mixed into it this block
+        float* block;                          // One block of stereo, into busBlocks_
+    };
+
+    void Apply(const AudioCommand& command);
+    void SetBus(uint32_t index, float volume, uint32_t parent, bool exists);
+    void RenderBlock(float* output);
+    // Runs every bus's chain and adds it into its parent, deepest first, then the master's chain
+    void MixBuses(float* mix, JobSystem* jobs);
+    void MixVoice(uint32_t index, Voice& voice, float* output, float* send);
+    // direction is from the listener to the voice in listener space, for the spatializer
+    void TargetGains(const Voice& voice, float gains[3], double& rate, float direction[3]) const;
+    void Stop(Voice& voice, bool finished);
+    void SetReverb(const ReverbSettings& settings);
+    void ProcessReverb(ReverbSlot& slot, bool active, float* output);
+    void Retire(ReverbSlot& slot);
+
+    int sampleRate_;
+    int channels_;
+    std::unique_ptr<Voice[]> voices_;
+    std::vector<float> scratch_;               // One block of stereo, mixed before spreading to channels_
+    AudioResampler resampler_;
+    std::vector<float> sourceLeft_;            // The voice being mixed: source frames its block reads
+    std::vector<float> sourceRight_;
+    std::vector<float> voiceLeft_;             // And those resampled to one block
+    std::vector<float> voiceRight_;
+    std::vector<float> block_;                 // The last block rendered, in channels_
+    uint32_t blockRead_;                       // Frames of block_ already handed out
+
+    ReverbSlot reverbs_[2];
+    int activeReverb_;
+    std::vector<float> send_;                  // One block of mono into the active reverb
+    std::vector<float> silence_;               // Input for a reverb ringing out
+    std::vector<float> convolutionInput_;      // send_ scaled by the slot's level
+
+    float listenerPosition_[3];
+    float listenerVelocity_[3];
+    float listenerForward_[3];
+    float listenerUp_[3];
+    float listenerRight_[3];
+    float masterVolume_;
+
+    HRTFSpatializer spatializer_;
+    bool binaural_;
+    std::atomic<JobSystem*> jobs_;
+    std::atomic<bool> usingJobs_;              // The audio thread holds what it read from jobs_
+
+    AudioRing<AudioCommand, COMMAND_CAPACITY> commands_;
+    AudioRing<AudioVoiceEvent, COMMAND_CAPACITY> events_;
+    AudioRing<ConvolutionReverb*, CONVOLUTION_CAPACITY> retired_;
+    size_t convolutionsInFlight_;              // Game thread: submitted and not yet collected
+
+    std::unique_ptr<Bus[]> buses_;
+    std::vector<float> busBlocks_;
+    std::vector<uint32_t> busOrder_;           // Existing buses but the master, deepest first
+    std::vector<uint32_t> busLevel_;           // Those of one depth with work to do this block
+    AudioRing<AudioBusChain*, BUS_CHAIN_CAPACITY> retiredChains_;
+    size_t chainsInFlight_;                    // Game thread, as for convolutions
+
+    std::atomic<uint32_t> activeVoices_;
+    std::atomic<uint64_t> droppedCommands_;
+    std::unique_ptr<std::atomic<float>[]> peaks_;
+};
+
+} // namespace Nexus
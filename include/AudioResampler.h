@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+enum class AudioResampleQuality : uint8_t {
+    Linear,                                    // Two taps: cheapest, dulls highs and aliases
+    Cubic,                                     // Four-point Hermite
+    Sinc                                       // Windowed sinc, band-limited to the rate
+};
+
+/**
+ * Polyphase windowed-sinc resampler, with cheaper linear and cubic modes.
+ *
+ * Input is planar and must hold HALF_TAPS - 1 frames before the first position read and HALF_TAPS
+ * after the last, whatever the quality, so a caller gathers its source once per block and needs
+ * no state but its position. The sinc kernel is tabulated at PHASES fractional offsets along with
+ * the slope to the next, so each output frame interpolates its TAPS coefficients and takes a dot
+ * product per channel, four taps to an SSE register. Reading faster than one input frame per
+ * output frame lowers the cutoff to keep what's above the output's Nyquist from aliasing, by
+ * picking among banks designed for rising rates. Prepare() allocates the tables; Process() doesn't.
+ */
+class AudioResampler {
+public:
+    static constexpr uint32_t TAPS = 32;
+    static constexpr uint32_t HALF_TAPS = TAPS / 2;
+    static constexpr uint32_t PHASES = 256;
+    static constexpr double MAX_RATE = 8.0;
+
+    void Prepare();
+    bool IsPrepared() const { return !banks_.empty(); }
+
+    // Input frames a block of frameCount reads at rate, margins included
+    static uint32_t GetSpan(uint32_t frameCount, double rate);
+
+    // Writes frameCount frames starting at position, in frames of left, advancing rate per frame.
+    // right may be null for mono, and outRight is then left alone
+    void Process(AudioResampleQuality quality, const float* left, const float* right, double position, double rate,
+                 float* outLeft, float* outRight, uint32_t frameCount) const;
+
+private:
+    struct Bank {
+        double maxRate;                        // Used for rates up to this
+        std::vector<float> coefficients;       // TAPS per phase
+        std::vector<float> slopes;             // To the next phase's coefficients
+    };
+
+    const Bank& SelectBank(double rate) const;
+    void ProcessSinc(const Bank& bank, const float* left, const float* right, double position, double rate,
+                     float* outLeft, float* outRight, uint32_t frameCount) const;
+
+    std::vector<Bank> banks_;
+};
+
+} // namespace Nexus
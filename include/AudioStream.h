@@ -0,0 +1,202 @@
+#pragma once
+
+#include "Platform.h"
+#include "AudioRenderer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Encoded bytes for an AudioDecoder, which may still be arriving.
+ *
+ * Read() never waits; it returns what is ready. Wait() blocks until more is, and is only for
+ * opening a stream, before a decoder thread takes it over.
+ */
+class AudioByteSource {
+public:
+    virtual ~AudioByteSource() = default;
+
+    virtual size_t Available() = 0;
+    virtual size_t Read(void* data, size_t size) = 0;
+    virtual bool Seek(uint64_t offset) = 0;
+    virtual void Wait() = 0;
+    virtual bool AtEnd() = 0;                  // Everything up to GetSize() has been read
+    virtual uint64_t GetSize() const = 0;
+    // The whole thing, when it's already in memory
+    virtual const uint8_t* GetData() const { return nullptr; }
+};
+
+// Bytes already loaded or mapped, shared with the AudioBuffer or SoundBank that holds them
+class MemoryByteSource : public AudioByteSource {
+public:
+    explicit MemoryByteSource(std::shared_ptr<const std::vector<uint8_t>> data);
+    MemoryByteSource(std::shared_ptr<const uint8_t> data, size_t size);
+
+    size_t Available() override { return size_ - position_; }
+    size_t Read(void* data, size_t size) override;
+    bool Seek(uint64_t offset) override;
+    void Wait() override {}
+    bool AtEnd() override { return position_ >= size_; }
+    uint64_t GetSize() const override { return size_; }
+    const uint8_t* GetData() const override { return data_.get(); }
+
+private:
+    std::shared_ptr<const uint8_t> data_;
+    size_t size_;
+    size_t position_;
+};
+
+/**
+ * File read ahead with overlapped I/O into a fixed ring of chunks.
+ *
+ * Every chunk not being read from has a read in flight, so the disk stays busy without a thread
+ * blocking on it. Nothing is allocated after construction.
+ */
+class OverlappedFileSource : public AudioByteSource {
+public:
+    OverlappedFileSource(const std::string& filePath, size_t chunkBytes, int chunkCount);
+    ~OverlappedFileSource() override;
+
+    bool IsOpen() const { return file_ != INVALID_HANDLE_VALUE; }
+
+    size_t Available() override;
+    size_t Read(void* data, size_t size) override;
+    bool Seek(uint64_t offset) override;
+    void Wait() override;
+    bool AtEnd() override;
+    uint64_t GetSize() const override { return size_; }
+
+private:
+    struct Chunk {
+        OVERLAPPED overlapped;
+        uint64_t offset;
+        DWORD filled;
+        bool pending;
+    };
+
+    void Issue(size_t chunk);
+    bool Poll(size_t chunk, bool wait);
+    void CancelAll();
+
+    HANDLE file_;
+    uint64_t size_;
+    size_t chunkBytes_;
+    std::vector<uint8_t> storage_;
+    std::vector<Chunk> chunks_;
+    size_t current_;                           // Chunk being read from
+    size_t position_;                          // Into the current chunk
+    uint64_t nextOffset_;                      // Where the next read issued starts
+};
+
+/**
+ * Turns encoded bytes into interleaved float frames.
+ *
+ * Decode() works with whatever its source has ready and returns 0 when starved, so it is safe to
+ * call from a decoder thread that serves other streams too.
+ */
+class AudioDecoder {
+public:
+    virtual ~AudioDecoder() = default;
+
+    // Reads the header, waiting for it if needed. False when the data isn't this decoder's format
+    virtual bool Open(AudioByteSource& source) = 0;
+    virtual uint32_t GetSampleRate() const = 0;
+    virtual uint16_t GetChannels() const = 0;
+    virtual uint64_t GetFrameCount() const = 0;        // 0 when unknown
+    virtual uint32_t Decode(float* output, uint32_t frameCount) = 0;
+    virtual bool Seek(uint64_t frame) = 0;
+    virtual bool IsFinished() const = 0;
+};
+
+struct AudioStreamInfo {
+    uint32_t sampleRate;
+    uint16_t channels;
+    uint64_t frameCount;                       // 0 when unknown
+};
+
+/**
+ * One playing instance of a streamed or compressed sound: its source, decoder and the ring of
+ * PCM its voice reads.
+ *
+ * A decoder thread calls Fill() whenever the ring has room; the renderer reads the ring through
+ * GetBuffer(). Looping is handled here, by rewinding the decoder, so the voice just keeps reading.
+ */
+class AudioStream {
+public:
+    AudioStream(std::unique_ptr<AudioByteSource> source, std::unique_ptr<AudioDecoder> decoder, uint32_t bufferFrames);
+
+    AudioStreamBuffer& GetBuffer() { return buffer_; }
+    AudioStreamInfo GetInfo() const;
+    void SetLooping(bool looping) { looping_.store(looping, std::memory_order_relaxed); }
+
+    // Frames of room in the ring
+    uint32_t GetFreeFrames() const;
+    bool IsDone() const { return buffer_.end.load(std::memory_order_relaxed) != UINT64_MAX; }
+    // Decodes up to maxFrames into the ring. Returns the frames added
+    uint32_t Fill(uint32_t maxFrames);
+
+private:
+    friend class AudioStreamer;
+
+    std::unique_ptr<AudioByteSource> source_;
+    std::unique_ptr<AudioDecoder> decoder_;
+    AudioStreamBuffer buffer_;
+    std::atomic<bool> looping_;
+    std::atomic<bool> busy_;                   // A decoder thread is filling it
+    std::atomic<bool> closed_;
+};
+
+/**
+ * A few decoder threads shared by every stream.
+ *
+ * Each pass a thread takes the open stream with the emptiest ring and decodes a chunk into it,
+ * so one slow stream can't hold the rest up and the thread count doesn't grow with the streams.
+ * Decoders are tried in order: WAV (PCM and IMA ADPCM), Ogg Vorbis, then any registered with
+ * RegisterDecoder(), which is how formats such as Opus are added.
+ */
+class AudioStreamer {
+public:
+    using DecoderFactory = std::function<std::unique_ptr<AudioDecoder>()>;
+
+    static constexpr uint32_t DEFAULT_BUFFER_FRAMES = 16384;
+    static constexpr uint32_t DECODE_CHUNK_FRAMES = 2048;
+
+    AudioStreamer();
+    ~AudioStreamer();
+
+    bool Start(int threadCount);
+    void Stop();
+
+    void RegisterDecoder(DecoderFactory factory);
+
+    // Opens source at startFrame and decodes the first chunk before returning, so a voice can
+    // start on it at once. Null if no decoder understands the data
+    std::shared_ptr<AudioStream> Open(std::unique_ptr<AudioByteSource> source, bool looping, uint64_t startFrame,
+                                      uint32_t bufferFrames = DEFAULT_BUFFER_FRAMES);
+    // Stops decoding; the stream itself lives until its last owner lets go
+    void Close(const std::shared_ptr<AudioStream>& stream);
+
+    // Header information without keeping a stream open
+    bool Probe(AudioByteSource& source, AudioStreamInfo& info);
+
+private:
+    std::unique_ptr<AudioDecoder> CreateDecoder(AudioByteSource& source);
+    void ThreadFunc();
+
+    std::vector<DecoderFactory> factories_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<std::shared_ptr<AudioStream>> streams_;
+    bool running_;
+};
+
+} // namespace Nexus
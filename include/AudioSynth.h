@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Nexus {
+
+enum class AudioWaveform : uint8_t {
+    Sine,
+    Square,                                    // Band-limited at the edges
+    Sawtooth,                                  // Likewise
+    Triangle
+};
+
+enum class AudioSynthFilter : uint8_t {
+    LowPass,
+    BandPass,
+    HighPass
+};
+
+// What the LFO moves
+enum class AudioSynthTarget : uint8_t {
+    Pitch,                                     // modDepth in octaves
+    Cutoff,                                    // Likewise
+    Volume                                     // modDepth 0 to 1
+};
+
+// A procedural sound: an oscillator and white noise through a resonant filter, under an
+// attack-decay-sustain envelope, with an LFO on the pitch, cutoff or volume. Wind is filtered
+// noise with the cutoff swaying, an engine a sawtooth whose frequency follows the revs, an impact
+// a noise burst with no sustain. Plain data like AudioClip, so it travels in an AudioCommand;
+// start from AudioSynth{} and fill in what's used
+struct AudioSynth {
+    AudioWaveform waveform;
+    AudioSynthFilter filter;
+    AudioSynthTarget modTarget;
+    float frequency;                           // Hz, before the voice's pitch and Doppler shift
+    float tone;                                // Oscillator level
+    float noise;                               // Noise level
+    float cutoff;                              // Hz, 0 leaves the filter out
+    float resonance;                           // 0 to 1, self-oscillating just short of 1
+    float modRate;                             // LFO Hz
+    float modDepth;
+    float attack;                              // Seconds
+    float decay;
+    float sustain;                             // Level after the decay; 0 ends the sound there
+};
+
+/**
+ * A procedural voice's generator, rendered a block at a time on the audio thread.
+ *
+ * Nothing is stored but this state, so a looping wind or engine costs no clip memory however
+ * long it plays. Changes to the patch take effect on the next block, frequency and cutoff gliding
+ * across it so that a parameter driven every frame from gameplay doesn't step audibly. The
+ * oscillator, noise, envelope and gain run four frames to an SSE register; the filter is a
+ * trapezoidal state-variable filter, recursive and so one frame at a time, with its coefficients
+ * and the LFO updated every CONTROL_FRAMES.
+ */
+struct AudioSynthVoice {
+    static constexpr uint32_t CONTROL_FRAMES = 16;
+
+    AudioSynth patch;                          // Targets, as last set
+    float frequency;                           // Reached at the end of the last block
+    float cutoff;
+    float phase;                               // Oscillator, 0 to 1
+    float modPhase;                            // LFO, 0 to 1
+    float low;                                 // Filter integrator state
+    float band;
+    uint32_t noise[4];                         // One generator per lane
+
+    void Start(const AudioSynth& synth, uint32_t seed);
+
+    // Writes frameCount mono frames, frameCount a multiple of four, the first elapsed frames into
+    // the sound. rate scales the oscillator for pitch and Doppler shift. Returns the frames
+    // before the envelope ended, all of them unless it ends in this block
+    uint32_t Render(float* output, uint32_t frameCount, double elapsed, float rate, float sampleRate);
+    // Frames the sound lasts at sampleRate, 0 when it sustains until stopped
+    static double GetLength(const AudioSynth& synth, float sampleRate);
+};
+
+} // namespace Nexus
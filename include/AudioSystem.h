@@ -1,9 +1,14 @@
 #pragma once
 
 #include "Platform.h"
+#include "AudioRenderer.h"
+#include "AudioStream.h"
+#include "PhysicsEngine.h"
+#include "SoundBank.h"
 #include <vector>
 #include <memory>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <functional>
 #include <queue>
@@ -33,12 +38,20 @@
 namespace Nexus {
 
 class Camera;
+class JobSystem;
+struct JobCounter;
 
 /**
  * Advanced audio system with 3D spatial audio, effects, and streaming
+ *
+ * Playback is mixed by an AudioRenderer on a dedicated audio thread, woken whenever the output
+ * device finishes a block. The methods here run on the game thread and only queue commands for
+ * it, which Update() hands over together, so a slow frame never starves the device.
  */
 class AudioSystem {
 public:
+    static constexpr uint32_t INVALID_VOICE = ~0u;
+
     enum class AudioFormat {
         PCM_8,
         PCM_16,
@@ -47,7 +60,8 @@ public:
         Float32,
         Compressed_MP3,
         Compressed_OGG,
-        Compressed_AAC
+        Compressed_AAC,
+        Compressed_ADPCM
     };
 
     enum class AudioChannelLayout {
@@ -77,7 +91,7 @@ public:
     enum class AudioSourceType {
         Static,      // Loaded entirely in memory
         Streaming,   // Streamed from disk
-        Generated    // Procedurally generated
+        Generated    // Synthesized from its synth on the audio thread
     };
 
     enum class AudioPriority {
@@ -109,11 +123,20 @@ public:
         
         // Metadata
         std::map<std::string, std::string> metadata;
+        
+        // Clips from a sound bank point into its mapping rather than holding data, and keep it
+        // mapped while anything references them
+        std::shared_ptr<const SoundBank> bank;
+        const uint8_t* mappedData = nullptr;
+        
+        const uint8_t* GetBytes() const { return mappedData ? mappedData : data.data(); }
+        size_t GetByteCount() const { return mappedData ? dataSize : data.size(); }
     };
 
     struct AudioSource {
         std::string name;
         std::shared_ptr<AudioBuffer> buffer;
+        AudioSynth synth;                       // Played instead of buffer by Generated sources
         AudioSourceType type;
         AudioPriority priority;
         
@@ -137,12 +160,15 @@ public:
         float coneInnerAngle;
         float coneOuterAngle;
         float coneOuterGain;
+        float occlusion;                        // 0 clear to 1 fully blocked
+        float lowPass;                          // Cutoff in Hz, 0 for none
         
-        // Streaming properties
-        size_t streamPosition;
-        size_t streamBufferSize;
-        std::vector<uint8_t> streamBuffer;
-        std::ifstream streamFile;
+        // Raycast occlusion: what the rays report, then smoothed into occlusion and lowPass
+        float occlusionTarget;
+        float absorptionTarget;
+        float absorption;
+        float rayCredit;                        // Rays owed, accrued by priority over time
+        uint32_t rayIndex;                      // Next aim in the spread around the source
         
         // Effects chain
         std::vector<std::shared_ptr<class AudioEffect>> effects;
@@ -153,8 +179,11 @@ public:
         std::function<void()> onLoopPoint;
         
         // Runtime data
-        IXAudio2SourceVoice* sourceVoice;
-        size_t playbackPosition;
+        uint32_t voice;                         // Renderer slot while playing, INVALID_VOICE otherwise
+        uint32_t bus;                           // Of its group, or the master
+        bool isVirtual;                         // Playing without a voice, only its position tracked
+        double playbackPosition;                // Source frames, estimated on the game thread
+        float audibility;                       // Volume after distance, cone and occlusion
         float fadeVolume;
         float fadeSpeed;
         bool isFading;
@@ -182,7 +211,9 @@ public:
         float obstructionFactor;
     };
 
-    struct AudioEffect {
+    // Run by the renderer on a group's bus once added, so parameters set later are picked up by
+    // its next block
+    struct AudioEffect : public AudioBusEffect {
         AudioEffectType type;
         std::string name;
         bool isEnabled;
@@ -190,6 +221,7 @@ public:
         // Common parameters
         float intensity;
         float wetDryMix;
+        int sampleRate = 44100;                    // Of the samples given to Apply
         
         // Effect-specific parameters
         std::map<std::string, float> parameters;
@@ -197,54 +229,80 @@ public:
         // XAudio2 effect
         IUnknown* xaudioEffect;
         
-        virtual void Apply(float* samples, int sampleCount, int channels) = 0;
+        // Apply gets sampleCount interleaved frames of up to MAX_EFFECT_CHANNELS channels. Each
+        // instance keeps its own filter state, so separate instances may run on separate threads
+        // Known parameters are cached as floats for Apply, which ramps towards them per block
         virtual void SetParameter(const std::string& name, float value) = 0;
         virtual float GetParameter(const std::string& name) const = 0;
     };
 
+    static constexpr int MAX_EFFECT_CHANNELS = 8;
+
+    // Freeverb style: parallel damped combs into series allpasses, on every channel at once
     struct ReverbEffect : public AudioEffect {
-        float roomSize;
-        float damping;
-        float earlyReflections;
-        float lateReflections;
-        float diffusion;
-        float density;
+        static constexpr int COMB_COUNT = 4;
+        static constexpr int ALLPASS_COUNT = 2;
+        static constexpr int LINE_COUNT = COMB_COUNT + ALLPASS_COUNT;
+
+        float roomSize = 0.5f;                     // 0 to 1, how long the tail rings
+        float damping = 0.5f;                      // 0 to 1, how fast highs die away in it
+        float wetLevel = 0.3f;
+        float dryLevel = 0.7f;
+        float earlyReflections = 0.0f;
+        float lateReflections = 0.0f;
+        float diffusion = 0.0f;
+        float density = 0.0f;
         
         // Implementation state
-        std::vector<float> delayBuffer;
-        size_t delayIndex = 0;
-        
+        std::vector<float> delayBuffer;            // Every line, each frames x stride floats
+        size_t lineStart[LINE_COUNT] = {};         // In frames
+        size_t lineLength[LINE_COUNT] = {};
+        size_t linePosition[LINE_COUNT] = {};
+        std::vector<float> combStates;             // Damping lowpass per comb, stride floats each
+        int preparedRate = 0;
+        int preparedChannels = 0;
+        int stride = 0;                            // Channels rounded up to whole SSE registers
+        float currentWet = 0.0f;
+        float currentDry = 0.0f;
+        bool primed = false;
+        
+        void Prepare(int rate, int channels);
         void Apply(float* samples, int sampleCount, int channels) override;
         void SetParameter(const std::string& name, float value) override;
         float GetParameter(const std::string& name) const override;
     };
 
+    // Three bands split by two one-pole crossovers
     struct EQEffect : public AudioEffect {
-        struct Band {
-            float frequency;
-            float gain;
-            float Q;
-        };
-        
-        std::vector<Band> bands;
+        float lowGain = 1.0f;
+        float midGain = 1.0f;
+        float highGain = 1.0f;
+        float lowFrequency = 250.0f;               // Crossovers in Hz
+        float highFrequency = 4000.0f;
         
         // Implementation state
-        std::vector<float> filterStates;
+        std::vector<float> filterStates;           // Low then high crossover, stride floats each
+        int stride = 0;
+        float currentGains[3] = {};
+        bool primed = false;
         
         void Apply(float* samples, int sampleCount, int channels) override;
         void SetParameter(const std::string& name, float value) override;
         float GetParameter(const std::string& name) const override;
     };
 
+    // Channels are linked: the loudest drives one gain for all, so the image doesn't shift
     struct CompressorEffect : public AudioEffect {
-        float threshold;
-        float ratio;
-        float attack;
-        float release;
-        float makeupGain;
+        float threshold = 0.5f;                    // Linear amplitude
+        float ratio = 4.0f;
+        float attack = 0.01f;                      // Seconds
+        float release = 0.1f;
+        float makeupGain = 1.0f;
         
         // Implementation state
         float envelope = 0.0f;
+        float currentMakeup = 0.0f;
+        bool primed = false;
         
         void Apply(float* samples, int sampleCount, int channels) override;
         void SetParameter(const std::string& name, float value) override;
@@ -275,6 +333,9 @@ public:
         float duckingAttack;
         float duckingRelease;
         
+        // Renderer bus its sources and child groups mix into
+        uint32_t bus;
+        
         float GetFinalVolume() const;
         void AddSource(std::shared_ptr<AudioSource> source);
         void RemoveSource(std::shared_ptr<AudioSource> source);
@@ -296,6 +357,7 @@ public:
         float diffusion;
         float density;
         float hfReference;
+        std::string impulseResponse;           // WAV convolved instead of the FDN reverb, if set
         
         // Environment effects
         std::vector<std::shared_ptr<AudioEffect>> globalEffects;
@@ -304,40 +366,41 @@ public:
         std::map<std::string, float> materialProperties;
     };
 
+    // What a ray through a body does to the sound
+    struct OcclusionMaterial {
+        float absorption;                       // 0 keeps the highs, 1 muffles them most
+        float transmission;                     // Share of the level that gets through
+    };
+
     struct AudioOcclusion {
         // Raycast-based occlusion
-        bool enableRaycastOcclusion;
-        int raycastSamples;
-        float raycastMaxDistance;
-        
-        // Material-based occlusion
-        std::map<std::string, float> materialAbsorption;
-        std::map<std::string, float> materialTransmission;
-        
-        // Compute occlusion factor
-        float ComputeOcclusion(const XMFLOAT3& listenerPos, 
-                              const XMFLOAT3& sourcePos,
-                              const std::vector<XMFLOAT3>& obstacles);
+        bool enableRaycastOcclusion = true;
+        int raycastSamples = 16;                // Rays per second for a Medium priority source
+        float raycastMaxDistance = 100.0f;
+        
+        // Material-based occlusion. IDs index materials; bodies without one use ID 0
+        std::vector<std::string> materialNames;
+        std::vector<OcclusionMaterial> materials;
+        std::unordered_map<RigidBodyID, uint16_t> bodyMaterials;
+        RigidBodyID listenerBody = PhysicsEngine::NO_BODY;
+        
+        // Rays cast in one update and read in a later one, without waiting on them
+        std::vector<PhysicsEngine::RayQuery> queries;
+        std::vector<PhysicsEngine::RaycastResult> results;
+        std::vector<std::shared_ptr<AudioSource>> casters;   // Per query
+        std::unique_ptr<JobCounter> counter;
+        bool inFlight = false;
     };
 
     struct AudioStreaming {
         // Streaming settings
-        size_t bufferSize;
-        int numBuffers;
-        int prebufferCount;
-        
-        // Streaming thread
-        std::thread streamingThread;
-        std::mutex streamingMutex;
-        std::condition_variable streamingCondition;
-        std::atomic<bool> isStreamingActive;
-        
-        // Buffer management
-        std::queue<std::vector<uint8_t>> freeBuffers;
-        std::queue<std::vector<uint8_t>> filledBuffers;
-        
-        void StreamingThreadFunc();
-        void FillBuffer(std::shared_ptr<AudioSource> source);
+        uint32_t bufferFrames;                  // Decoded ring per playing stream
+        size_t readChunkBytes;                  // Overlapped read size for file streams
+        int readChunkCount;                     // Reads kept in flight per file stream
+        int decoderThreads;
+        
+        // Decoder threads shared by every stream and compressed clip
+        std::unique_ptr<AudioStreamer> streamer;
     };
 
     struct AudioMixer {
@@ -352,8 +415,7 @@ public:
         float masterPitch;
         bool masterMute;
         
-        // Submixes
-        std::map<std::string, std::shared_ptr<AudioGroup>> groups;
+        // Submixes are AudioGroups, rendered as the AudioRenderer's bus graph
         
         // Final output buffer
         std::vector<float> mixBuffer;
@@ -361,10 +423,6 @@ public:
         // Peak/RMS metering
         std::vector<float> peakLevels;
         std::vector<float> rmsLevels;
-        
-        void MixSources(const std::vector<std::shared_ptr<AudioSource>>& sources);
-        void ApplyGroupEffects(std::shared_ptr<AudioGroup> group);
-        void ApplyMasterEffects();
     };
 
     // Dynamic range compression for different platforms
@@ -418,10 +476,24 @@ public:
     void UnloadAudioBuffer(const std::string& name);
     std::shared_ptr<AudioBuffer> GetAudioBuffer(const std::string& name);
 
+    // Sound banks, built with NexusAssetConverter --sound-bank, are mapped rather than read and
+    // their clips found by ID (see HashSoundName). A clip in a later bank replaces one with its ID.
+    // Unloading a bank leaves playing clips mapped until they finish
+    bool LoadSoundBank(const std::string& filePath);
+    void UnloadSoundBank(const std::string& filePath);
+    std::shared_ptr<AudioBuffer> GetClip(SoundClipID clip) const;
+
     // Audio source management
     std::shared_ptr<AudioSource> CreateAudioSource(const std::string& name, 
                                                    std::shared_ptr<AudioBuffer> buffer,
                                                    AudioSourceType type = AudioSourceType::Static);
+    // A Generated source: synth is rendered a block at a time as it plays, taking no clip memory,
+    // and it otherwise plays, moves and is virtualized like any source. It plays until stopped
+    // when synth sustains, and until its envelope ends when not
+    std::shared_ptr<AudioSource> CreateProceduralSource(const std::string& name, const AudioSynth& synth);
+    // param is one of the synth's, Frequency to ModDepth, reaching the audio thread with the next
+    // flush of commands and gliding there over one block
+    void SetSynthParameter(const std::string& sourceName, AudioVoiceParam param, float value);
     void DestroyAudioSource(const std::string& name);
     std::shared_ptr<AudioSource> GetAudioSource(const std::string& name);
 
@@ -441,6 +513,7 @@ public:
     void SetSourceDirection(const std::string& sourceName, const D3DXVECTOR3& direction);
     void SetSourceDistance(const std::string& sourceName, float minDistance, float maxDistance);
     void SetSourceCone(const std::string& sourceName, float innerAngle, float outerAngle, float outerGain);
+    void SetSourceOcclusion(const std::string& sourceName, float occlusion);
 
     // Listener
     void SetListenerPosition(const D3DXVECTOR3& position);
@@ -449,8 +522,13 @@ public:
     void SetMasterVolume(float volume);
 
     // Audio groups
+    // Each group is a bus of the renderer: its sources mix into it, its effects run on the mix and
+    // the result goes on into its parent's bus, or the master. Up to AudioRenderer::MAX_BUSES - 1
+    // groups get buses; the rest mix straight into the master
     std::shared_ptr<AudioGroup> CreateAudioGroup(const std::string& name);
     void DestroyAudioGroup(const std::string& name);
+    // An empty parent name puts it back on the master. Fails rather than make a loop
+    bool SetGroupParent(const std::string& groupName, const std::string& parentName);
     void AddSourceToGroup(const std::string& sourceName, const std::string& groupName);
     void RemoveSourceFromGroup(const std::string& sourceName, const std::string& groupName);
     void SetGroupVolume(const std::string& groupName, float volume);
@@ -460,18 +538,32 @@ public:
     std::shared_ptr<AudioEffect> CreateEffect(AudioEffectType type, const std::string& name);
     void AddEffectToSource(const std::string& sourceName, const std::string& effectName);
     void RemoveEffectFromSource(const std::string& sourceName, const std::string& effectName);
+    // An effect runs on one group or the master at a time
     void AddEffectToGroup(const std::string& groupName, const std::string& effectName);
+    void AddEffectToMaster(const std::string& effectName);
     void SetEffectParameter(const std::string& effectName, const std::string& parameter, float value);
 
     // Environment and occlusion
+    // Built-in presets: Generic, Room, Bathroom, Hall, Cave, Arena, Forest. An empty name turns
+    // the reverb off
+    void RegisterAudioEnvironment(std::shared_ptr<AudioEnvironment> environment);
     void SetAudioEnvironment(const std::string& environmentName);
+    // Raycast occlusion casts through the physics engine's batched queries, a share of rays per
+    // source by priority, and eases each source's gain and low-pass cutoff towards what they hit.
+    // Clear the physics engine before it or the JobSystem goes away
     void EnableOcclusion(bool enable);
     void SetOcclusionParameters(int raycastSamples, float maxDistance);
+    void SetPhysicsEngine(PhysicsEngine* physics);
+    void SetOcclusionListenerBody(RigidBodyID bodyId);  // Rays start inside it, so it is skipped
+    // Registering a name again updates it. Returns the material's ID
+    uint16_t RegisterOcclusionMaterial(const std::string& name, float absorption, float transmission);
+    uint16_t GetOcclusionMaterial(const std::string& name) const;   // 0 if unknown
+    void SetBodyOcclusionMaterial(RigidBodyID bodyId, uint16_t material);
 
     // Streaming
     void EnableStreaming(bool enable);
-    void SetStreamingBufferSize(size_t bufferSize);
-    void SetStreamingBufferCount(int count);
+    void SetStreamingBufferSize(size_t bufferSize);    // Decoded frames held ahead per stream
+    void SetStreamingBufferCount(int count);           // File reads kept in flight per stream
 
     // Audio compression and limiting
     void EnableDynamicRangeCompression(bool enable);
@@ -491,13 +583,25 @@ public:
 
     // Update and processing
     void Update(float deltaTime);
+    // Renders sampleCount interleaved frames directly, for hosts that pull audio themselves. Not
+    // to be mixed with the audio thread started by Initialize
     void ProcessAudio(float* outputBuffer, int sampleCount);
 
-    // Performance and optimization
+    // Performance and optimization. Past maxVoices, playing sources ranked lowest by priority
+    // times audibility are virtualized: faded out and tracked without mixing until they rank
+    // high enough to fade back in where they would have been
     void SetMaxVoices(int maxVoices);
     void SetVoicePriority(const std::string& sourceName, AudioPriority priority);
     void EnableVoiceVirtualization(bool enable);
 
+    // Binaural spatialization. 3D sources are rendered through HRTFs instead of panned: the
+    // loudest voiceLimit each through their own, the rest through one ambisonic bed. With a
+    // JobSystem set the audio thread spreads that work over its workers; clear it before the
+    // JobSystem shuts down
+    void EnableHRTF(bool enable);
+    void SetHRTFVoiceLimit(int voiceLimit);
+    void SetJobSystem(JobSystem* jobs);
+
     // Statistics and debugging
     void GetStatistics(AudioAnalytics& analytics) const;
     void EnableProfiling(bool enable);
@@ -524,6 +628,10 @@ public:
     SoundInstanceID PlaySound3D(SoundID soundId, const DirectX::XMFLOAT3& position, 
                                 const DirectX::XMFLOAT3& velocity = DirectX::XMFLOAT3(0,0,0), 
                                 float volume = 1.0f, bool looping = false);
+    SoundInstanceID PlayClip(SoundClipID clip, float volume = 1.0f, bool looping = false);
+    SoundInstanceID PlayClip3D(SoundClipID clip, const DirectX::XMFLOAT3& position,
+                               const DirectX::XMFLOAT3& velocity = DirectX::XMFLOAT3(0,0,0),
+                               float volume = 1.0f, bool looping = false);
     void StopSound(SoundInstanceID instanceId);
     void SetSoundVolume(SoundInstanceID instanceId, float volume);
     void SetSoundPosition(SoundInstanceID instanceId, const DirectX::XMFLOAT3& position);
@@ -538,38 +646,66 @@ private:
     void InitializeXAudio2();
     void ShutdownXAudio2();
     void CreateMasteringVoice();
-    void CreateSourceVoice(std::shared_ptr<AudioSource> source);
-    void DestroySourceVoice(std::shared_ptr<AudioSource> source);
+
+    // Audio thread, fed by one float source voice
+    struct OutputCallback;
+    bool StartOutput();
+    void StopOutput();
+    void MixerThreadFunc();
+
+    // Renderer voices, game thread only
+    struct VoiceSlot {
+        AudioSource* source;                   // Null once stopped, while the renderer lets go
+        std::shared_ptr<AudioBuffer> buffer;   // Keeps the clip alive while the renderer reads it
+        std::shared_ptr<AudioStream> stream;   // Decoded ring for compressed and streamed clips
+        uint32_t generation;
+        bool inUse;
+    };
+    bool StartVoice(AudioSource& source, bool fadeIn = false);
+    std::shared_ptr<AudioStream> OpenStream(const AudioSource& source);
+    void StopVoice(AudioSource& source);
+    void SendVoiceParam(const AudioSource& source, AudioVoiceParam param, float value);
+    void SendVoiceVector(const AudioSource& source, AudioCommandType type, const XMFLOAT3& value);
+    void SendCommand(const AudioCommand& command);
+    void SendGroupBus(const AudioGroup& group);
+    void SubmitEffectChain(uint32_t bus, const std::vector<std::shared_ptr<AudioEffect>>& effects);
+    bool IsEffectOnBus(const AudioEffect& effect) const;
+    void ProcessVoiceEvents();
+    void RegisterDefaultEnvironments();
+    std::shared_ptr<const ImpulseResponse> LoadImpulseResponse(const std::string& filePath);
 
     // Audio processing
-    void ProcessFading(std::shared_ptr<AudioSource> source, float deltaTime);
-    void Process3DAudio();
-    void ProcessOcclusion();
+    void ProcessOcclusion(float deltaTime);
+    void CastOcclusionRays();
+    void WaitForOcclusionRays();
     void ProcessEffects();
 
     // Streaming implementation
     void StartStreaming();
     void StopStreaming();
-    void UpdateStreamingSources();
 
     // Voice management
-    void VirtualizeVoices();
-    void RealizeVoices();
-    std::shared_ptr<AudioSource> FindLowestPrioritySource() const;
+    void UpdateVoiceBudget(float deltaTime);
+    void VirtualizeVoice(AudioSource& source);
+    float ComputeAudibility(const AudioSource& source) const;
 
     // Audio format conversion
+    // PCM and float buffers only; dest gets the same sound in targetFormat
     void ConvertAudioFormat(const AudioBuffer& source, AudioBuffer& dest, AudioFormat targetFormat);
+    // dest gets source as Float32 at targetSampleRate, resampled with the sinc kernel
     void ResampleAudio(const AudioBuffer& source, AudioBuffer& dest, int targetSampleRate);
 
     // File I/O
     std::shared_ptr<AudioBuffer> LoadWAV(const std::string& filePath);
     std::shared_ptr<AudioBuffer> LoadMP3(const std::string& filePath);
     std::shared_ptr<AudioBuffer> LoadOGG(const std::string& filePath);
+    // Keeps the file's bytes as they are, to be decoded as it plays
+    std::shared_ptr<AudioBuffer> LoadCompressed(const std::string& filePath, AudioFormat format);
 
     // Effects implementation
-    void ApplyReverb(float* samples, int sampleCount, int channels, const ReverbEffect& effect);
-    void ApplyEQ(float* samples, int sampleCount, int channels, const EQEffect& effect);
-    void ApplyCompressor(float* samples, int sampleCount, int channels, const CompressorEffect& effect);
+    void ApplyReverb(float* samples, int sampleCount, int channels, ReverbEffect& effect);
+    void ApplyEQ(float* samples, int sampleCount, int channels, EQEffect& effect);
+    void ApplyCompressor(float* samples, int sampleCount, int channels, CompressorEffect& effect);
 
     // Utility functions
     float LinearToDecibel(float linear) const;
@@ -603,10 +739,13 @@ private:
     
     // Audio data
     std::map<std::string, std::shared_ptr<AudioBuffer>> audioBuffers_;
+    std::map<std::string, std::shared_ptr<const SoundBank>> soundBanks_;
+    std::unordered_map<SoundClipID, std::shared_ptr<AudioBuffer>> bankClips_;
     std::map<std::string, std::shared_ptr<AudioSource>> audioSources_;
     std::map<std::string, std::shared_ptr<AudioGroup>> audioGroups_;
     std::map<std::string, std::shared_ptr<AudioEffect>> audioEffects_;
     std::map<std::string, std::shared_ptr<AudioEnvironment>> audioEnvironments_;
+    std::map<std::string, std::shared_ptr<const ImpulseResponse>> impulseResponses_;
     
     // Listener
     std::unique_ptr<AudioListener> listener_;
@@ -619,6 +758,8 @@ private:
     
     // Occlusion
     std::unique_ptr<AudioOcclusion> occlusion_;
+    PhysicsEngine* physics_;
+    JobSystem* jobs_;
     
     // Dynamic range compression
     std::unique_ptr<DynamicRangeCompression> drc_;
@@ -635,6 +776,9 @@ private:
     // Voice management
     int maxVoices_;
     bool voiceVirtualizationEnabled_;
+    std::vector<std::pair<float, AudioSource*>> voiceRanking_;  // Reused by UpdateVoiceBudget
+    bool hrtfEnabled_;
+    int hrtfVoiceLimit_;
     
     // Performance settings
     bool streamingEnabled_;
@@ -649,6 +793,18 @@ private:
     std::mutex audioMutex_;
     std::thread audioThread_;
     std::atomic<bool> isRunning_;
+
+    // Real-time mixing
+    std::unique_ptr<AudioRenderer> renderer_;
+    AudioResampler resampler_;                  // For converting clips as they load
+    std::vector<VoiceSlot> voiceSlots_;
+    std::vector<uint32_t> freeVoices_;
+    std::vector<uint32_t> freeBuses_;
+    std::vector<std::shared_ptr<AudioEffect>> masterEffects_;
+    IXAudio2SourceVoice* outputVoice_;
+    std::unique_ptr<OutputCallback> outputCallback_;
+    std::vector<float> outputBlocks_;           // OUTPUT_BLOCKS blocks queued on outputVoice_ at once
+    std::atomic<bool> mixerRunning_;
     
     // Current environment
     std::string currentEnvironment_;
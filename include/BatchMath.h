@@ -0,0 +1,53 @@
+#pragma once
+
+#include "SceneBVH.h"
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace Nexus {
+
+/**
+ * Math over arrays: points through a matrix, vector normalization, quaternion slerp and box
+ * frustum tests, for callers with many elements to process at once (scripts through the Python
+ * and C bindings in particular, where a call per element costs far more than the math).
+ *
+ * The SSE4.1 and AVX2 paths deinterleave four or eight elements into one register per component
+ * and run the same arithmetic as the scalar path across all of them. The widest instruction set
+ * the CPU supports is picked on first use; the engine does that during initialization. Outputs
+ * may alias the matching input.
+ */
+class BatchMath {
+public:
+    enum class InstructionSet {
+        Scalar,
+        SSE41,
+        AVX2
+    };
+
+    // Affine transform with the row-vector convention (p * matrix); the fourth column is ignored
+    static void TransformPoints(const DirectX::XMFLOAT4X4& matrix, const DirectX::XMFLOAT3* points,
+                                DirectX::XMFLOAT3* output, size_t count);
+
+    // Zero-length vectors stay zero
+    static void NormalizeVectors(const DirectX::XMFLOAT3* vectors, DirectX::XMFLOAT3* output, size_t count);
+
+    // Shortest-path slerp of unit quaternions, one t per pair or one for all. t is expected in
+    // [0, 1]; nearly equal pairs are lerped, like XMQuaternionSlerp
+    static void SlerpQuaternions(const DirectX::XMFLOAT4* from, const DirectX::XMFLOAT4* to, const float* t,
+                                 DirectX::XMFLOAT4* output, size_t count);
+    static void SlerpQuaternions(const DirectX::XMFLOAT4* from, const DirectX::XMFLOAT4* to, float t,
+                                 DirectX::XMFLOAT4* output, size_t count);
+
+    // visible[i] is 1 when boxes[i] passes Frustum::Intersects and 0 otherwise; returns the
+    // number visible
+    static size_t CullBoxes(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* visible);
+
+    // The active path. SetInstructionSet clamps to what the CPU supports; meant for tests and
+    // benchmarks
+    static InstructionSet GetInstructionSet();
+    static void SetInstructionSet(InstructionSet instructionSet);
+    static const char* GetInstructionSetName(InstructionSet instructionSet);
+};
+
+} // namespace Nexus
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Microbenchmark harness for timing subsystems headless, without a window or device.
+ *
+ * A case is a function timed as a whole per iteration, with an optional setup run untimed
+ * before every iteration so each sample starts from the same state. After warmupIterations that
+ * are thrown away, a case runs until it has minIterations samples adding up to minSeconds, or
+ * maxIterations. Timings are skewed by interrupts and clock changes, so results lead with the
+ * median and the median absolute deviation (MAD) rather than the mean and standard deviation,
+ * which a few slow outliers would move. MAD is scaled by 1.4826 so it estimates the standard
+ * deviation of normal noise. operations is how many items one iteration covers, for per-item
+ * costs.
+ *
+ * WriteJSON() keeps the results with their samples and the properties set, and ReadJSON() loads
+ * them back as a baseline to compare another build against.
+ */
+class Benchmark {
+public:
+    struct Settings {
+        uint32_t warmupIterations = 3;
+        uint32_t minIterations = 10;
+        uint32_t maxIterations = 1000;
+        double minSeconds = 0.5;        // Timed per case, setup excluded
+        std::string filter;             // Only cases whose name contains it; empty runs all
+    };
+
+    struct Result {
+        std::string name;
+        uint64_t operations = 1;        // Items per iteration
+        uint32_t iterations = 0;        // Samples kept, warmup excluded
+        double median = 0.0;            // Milliseconds per iteration
+        double mad = 0.0;               // Scaled, in milliseconds
+        double mean = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+        std::vector<double> samples;    // Milliseconds, in the order run
+    };
+
+    using Function = std::function<void()>;
+    // Called as each case finishes
+    using ReportFunction = std::function<void(const Result& result)>;
+
+    // Cases run in the order added; names are "group/case"
+    void Add(const std::string& name, Function run, uint64_t operations = 1, Function setup = nullptr);
+    const std::vector<Result>& Run(const Settings& settings, const ReportFunction& report = nullptr);
+    const std::vector<Result>& GetResults() const { return results_; }
+    std::vector<std::string> GetCaseNames() const;
+
+    // Written with the results, e.g. the build type or thread count
+    void SetProperty(const std::string& key, const std::string& value);
+
+    bool WriteJSON(const std::string& filename) const;
+    static bool ReadJSON(const std::string& filename, std::vector<Result>& results);
+
+    // Fills the statistics of result from its samples
+    static void Summarize(Result& result);
+
+private:
+    struct Case {
+        std::string name;
+        Function run;
+        Function setup;
+        uint64_t operations;
+    };
+
+    std::vector<Case> cases_;
+    std::vector<Result> results_;
+    std::vector<std::pair<std::string, std::string>> properties_;
+};
+
+} // namespace Nexus
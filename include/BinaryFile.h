@@ -0,0 +1,161 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+// Section and content ids: four characters, read in file order
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+}
+
+/**
+ * The layout of one element of a section, field by field.
+ *
+ * Its hash is stored with the section and compared when the section is read, so a reader whose
+ * struct has gained, lost or reordered a field refuses the section instead of misreading it.
+ * Padding counts as a field, so the schema's size matches sizeof the struct it describes.
+ */
+class BinarySchema {
+public:
+    enum class FieldType : uint8_t {
+        U8, U16, U32, U64, I32, F32,
+        Offset,                 // uint32_t into another section, resolved against its base
+        Padding                 // Unused bytes, one per count
+    };
+
+    BinarySchema& Field(const char* name, FieldType type, uint32_t count = 1);
+    BinarySchema& Pad(uint32_t bytes) { return Field("", FieldType::Padding, bytes); }
+
+    uint32_t GetElementSize() const { return elementSize_; }
+    uint64_t GetHash() const { return hash_; }
+
+private:
+    uint32_t elementSize_ = 0;
+    uint64_t hash_ = 14695981039346656037ull;
+};
+
+enum class BinaryCompression : uint8_t {
+    None,                       // Stored as is, readable in place from the mapping
+    LZ4
+};
+
+// One section of a binary file's table, as stored
+struct BinarySectionEntry {
+    uint32_t id;
+    uint32_t elementSize;
+    uint64_t schemaHash;
+    uint64_t elementCount;
+    uint64_t offset;            // From the start of the file, a multiple of BinaryFile::ALIGNMENT
+    uint64_t storedSize;        // Bytes in the file
+    BinaryCompression compression;
+    uint8_t reserved[7];
+};
+static_assert(sizeof(BinarySectionEntry) == 48, "BinarySectionEntry is stored as is");
+
+/**
+ * Builds a binary file: a header, a table of sections and each section's bytes at an aligned
+ * offset.
+ *
+ * A section is a flat array of trivially copyable elements described by a schema, typically one
+ * component or field of many objects (structure of arrays). Nothing holds a pointer: references
+ * between sections are offsets or indices, so a section works wherever it ends up in memory,
+ * including straight out of a file mapping. Sections are LZ4 compressed on request when that
+ * saves at least an eighth of them.
+ */
+class BinaryFileWriter {
+public:
+    BinaryFileWriter(uint32_t contentType, uint32_t contentVersion);
+
+    // Copies count elements of schema's size from elements
+    void AddSection(uint32_t id, const BinarySchema& schema, const void* elements, size_t count, bool compress = false);
+
+    template<typename T>
+    void AddSection(uint32_t id, const BinarySchema& schema, const std::vector<T>& elements, bool compress = false) {
+        static_assert(std::is_trivially_copyable<T>::value, "Sections are copied as raw bytes");
+        AddSection(id, schema, elements.data(), elements.size(), compress);
+    }
+
+    // Written to a temporary file that replaces filename once complete, so a crash mid-save
+    // leaves the previous file intact
+    bool Write(const std::string& filename) const;
+
+private:
+    struct Section {
+        BinarySectionEntry entry;
+        std::vector<uint8_t> bytes;
+    };
+
+    uint32_t contentType_;
+    uint32_t contentVersion_;
+    std::vector<Section> sections_;
+};
+
+/**
+ * Reads a file built by BinaryFileWriter through a memory mapping.
+ *
+ * Open() checks the header and that every section lies inside the file; sections are then
+ * looked up by id and handed out in place when stored uncompressed, so loading one costs its
+ * page faults and nothing else. The caller's schema must match the one the section was written
+ * with, and a content version lets a format evolve beyond what schemas can tell apart.
+ */
+class BinaryFile {
+public:
+    static constexpr uint32_t ALIGNMENT = 64;
+
+    // False for a missing file, another kind of content or a damaged header or table
+    bool Open(const std::string& filename, uint32_t contentType);
+    void Close();
+
+    bool IsOpen() const { return file_.IsOpen(); }
+    uint32_t GetContentVersion() const { return contentVersion_; }
+    const BinarySectionEntry* FindSection(uint32_t id) const;
+
+    // The section's elements: in the mapping when stored uncompressed, otherwise decompressed into
+    // buffer. Null when the section is missing, written with another schema or corrupt; a present
+    // but empty section is a non-null pointer with count 0. Safe from any thread
+    const void* GetSection(uint32_t id, const BinarySchema& schema, size_t& count, std::vector<uint8_t>& buffer) const;
+
+    template<typename T>
+    const T* GetSection(uint32_t id, const BinarySchema& schema, size_t& count, std::vector<uint8_t>& buffer) const {
+        static_assert(std::is_trivially_copyable<T>::value, "Sections are read as raw bytes");
+        if (schema.GetElementSize() != sizeof(T)) return nullptr;
+        return static_cast<const T*>(GetSection(id, schema, count, buffer));
+    }
+
+private:
+    MappedFile file_;
+    uint32_t contentVersion_ = 0;
+    const BinarySectionEntry* sections_ = nullptr;
+    uint32_t sectionCount_ = 0;
+};
+
+/**
+ * Null-terminated strings packed into one section; other sections refer to them by offset.
+ */
+class BinaryStringTable {
+public:
+    static BinarySchema GetSchema();
+
+    // Equal strings share their bytes
+    uint32_t Add(const std::string& text);
+    const std::vector<char>& GetBytes() const { return bytes_; }
+
+    // The string at offset in a table section of size bytes, or "" when out of range
+    static const char* Get(const char* table, size_t size, uint32_t offset) {
+        return offset < size && std::memchr(table + offset, '\0', size - offset) ? table + offset : "";
+    }
+
+private:
+    std::vector<char> bytes_;
+    std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+} // namespace Nexus
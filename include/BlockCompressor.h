@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Nexus {
+
+class JobSystem;
+
+/**
+ * CPU encoder from RGBA8 to the BC1/BC3/BC4/BC5/BC7 block-compressed formats.
+ *
+ * Every format fits endpoints along the principal axis of the block's colours, then alternates
+ * nearest-palette index search (SSE, four pixels per step) with least-squares endpoint refits.
+ * quality (0-100) bounds that search: the number of refits, whether BC1 also tries its
+ * three-colour mode, whether BC4/BC5 search around their endpoints, and which BC7 modes are
+ * tried. BC7 uses the single-subset modes 6 (RGBA, 4-bit indices) and 5 (separate alpha, rotated
+ * channels), which cover photographic and alpha-tested content well.
+ *
+ * BC5 stores red and green only, for tangent-space normal maps.
+ *
+ * CompressBC6H() encodes HDR images, such as baked lightmaps, from RGBA16F to BC6H_UF16. It uses
+ * mode 11, one subset with 10-bit endpoints, and fits in the half-float bit patterns so the error
+ * is relative to brightness. Blocks are 16 bytes, as for BC7.
+ */
+class BlockCompressor {
+public:
+    enum class Format {
+        BC1,   // RGB, 1-bit alpha below 128
+        BC3,   // RGB + interpolated alpha
+        BC4,   // Red
+        BC5,   // Red + green
+        BC7
+    };
+
+    static size_t GetBlockBytes(Format format);
+    static size_t GetCompressedSize(Format format, int width, int height);
+
+    // Encodes a width x height RGBA8 image with rows inputPitch bytes apart into tightly packed
+    // blocks in row order. Edge blocks repeat the last row and column. Returns false if output
+    // is smaller than GetCompressedSize()
+    static bool Compress(Format format, const uint8_t* pixels, size_t inputPitch, int width, int height,
+                         uint8_t* output, size_t outputSize, int quality, JobSystem* jobs = nullptr);
+
+    // One 4x4 block of RGBA8 pixels in row order
+    static void CompressBlock(Format format, const uint8_t pixels[64], uint8_t* output, int quality);
+
+    // As Compress() for RGBA16F pixels, alpha ignored, to BC6H_UF16. Negative values become zero
+    static bool CompressBC6H(const uint16_t* pixels, size_t inputPitch, int width, int height,
+                             uint8_t* output, size_t outputSize, int quality, JobSystem* jobs = nullptr);
+    static void CompressBlockBC6H(const uint16_t pixels[64], uint8_t* output, int quality);
+};
+
+} // namespace Nexus
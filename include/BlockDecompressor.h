@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Nexus {
+
+class JobSystem;
+
+/**
+ * CPU decoder for the BC1-BC5 block-compressed formats (DXT1/3/5, BC4, BC5) to RGBA8.
+ *
+ * The SSE4.1 and AVX2 paths build the colour palettes of four or eight blocks at once and expand
+ * each 4-pixel row with one byte shuffle, so a block costs a handful of instructions instead of a
+ * loop over its sixteen pixels. The widest instruction set the CPU supports is picked on first
+ * use. Output goes to a caller-provided buffer, and with a job system rows of blocks are decoded
+ * in parallel.
+ *
+ * BC4 decodes to (r, 0, 0, 255) and BC5 to (r, g, 0, 255), the same values the sampler returns.
+ */
+class BlockDecompressor {
+public:
+    enum class Format {
+        BC1,   // DXT1
+        BC2,   // DXT3
+        BC3,   // DXT5
+        BC4,
+        BC5
+    };
+
+    enum class InstructionSet {
+        Scalar,
+        SSE41,
+        AVX2
+    };
+
+    static size_t GetBlockBytes(Format format);
+    static size_t GetCompressedSize(Format format, int width, int height);
+
+    // Decodes a width x height image into RGBA8 rows outputPitch bytes apart (at least width * 4).
+    // Partial edge blocks are clipped. Returns false if the input is too small for the image
+    static bool Decompress(Format format, const uint8_t* blocks, size_t size, int width, int height,
+                           uint8_t* output, size_t outputPitch, JobSystem* jobs = nullptr);
+
+    // Decodes blockCount consecutive blocks into a 4-row strip of blockCount * 16 bytes per row
+    static void DecompressBlocks(Format format, const uint8_t* blocks, size_t blockCount,
+                                 uint8_t* output, size_t outputPitch);
+
+    // The active path. SetInstructionSet clamps to what the CPU supports; meant for tests and
+    // benchmarks
+    static InstructionSet GetInstructionSet();
+    static void SetInstructionSet(InstructionSet instructionSet);
+    static const char* GetInstructionSetName(InstructionSet instructionSet);
+};
+
+} // namespace Nexus
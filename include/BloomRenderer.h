@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Platform.h"
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Compute-shader bloom over a half-resolution mip chain.
+ *
+ * The first pass thresholds the source with a soft knee while downsampling it to half size;
+ * every further pass halves the previous level with the 13-tap filter from Call of Duty:
+ * Advanced Warfare. The chain is then walked back up, each level blending its own downsample
+ * with a 3x3 tent upsample of the level below, and the last upsample is added onto the source
+ * at full resolution. Each thread group loads the texels its filter footprint needs into a
+ * groupshared tile once, so neighbouring outputs share their loads instead of refetching them.
+ * The first downsample also weights its 2x2 boxes by inverse luma (Karis average) so single
+ * bright pixels do not flicker.
+ */
+class BloomRenderer {
+public:
+    static constexpr UINT MAX_MIPS = 8;
+
+    struct Settings {
+        float threshold = 0.8f;    // Brightness where bloom starts
+        float knee = 0.5f;         // Soft transition below the threshold, as a fraction of it
+        float intensity = 1.0f;    // Scale of the bloom added onto the source
+        float scatter = 0.7f;      // 0 keeps bloom tight, 1 weights the widest levels most
+        UINT mipCount = 6;         // Chain levels below full resolution
+    };
+
+    BloomRenderer();
+    ~BloomRenderer();
+
+    BloomRenderer(const BloomRenderer&) = delete;
+    BloomRenderer& operator=(const BloomRenderer&) = delete;
+
+    // width and height are the size of the images Render() reads and writes
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height,
+                    const Settings& settings);
+    void Shutdown();
+
+    void SetParameters(float threshold, float intensity);
+    const Settings& GetSettings() const { return settings_; }
+
+    // Writes source plus bloom to output. Both are width x height and must be different
+    // resources; neither may be bound as a render target
+    void Render(ID3D11ShaderResourceView* source, ID3D11UnorderedAccessView* output);
+
+    // Blurred bloom alone at half resolution, valid after Render()
+    ID3D11ShaderResourceView* GetBloomView() const;
+
+private:
+    bool CreateShaders();
+    bool CreateChains();
+    void Dispatch(ID3D11ComputeShader* shader, ID3D11ShaderResourceView* source, ID3D11ShaderResourceView* current,
+                  ID3D11UnorderedAccessView* target, UINT sourceWidth, UINT sourceHeight, UINT width, UINT height);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    Settings settings_;
+    UINT width_;
+    UINT height_;
+
+    ID3D11ComputeShader* prefilterShader_;
+    ID3D11ComputeShader* downsampleShader_;
+    ID3D11ComputeShader* upsampleShader_;
+    ID3D11ComputeShader* compositeShader_;
+    ID3D11Buffer* constants_;
+
+    // Downsampled levels and the upsampled result of each level, one view per mip
+    ID3D11Texture2D* downChain_;
+    ID3D11Texture2D* upChain_;
+    std::vector<ID3D11ShaderResourceView*> downViews_;
+    std::vector<ID3D11UnorderedAccessView*> downTargets_;
+    std::vector<ID3D11ShaderResourceView*> upViews_;
+    std::vector<ID3D11UnorderedAccessView*> upTargets_;
+    std::vector<UINT> mipWidths_;
+    std::vector<UINT> mipHeights_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "SceneBVH.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+/**
+ * Collision broadphase over a dynamic AABB tree with a persistent pair cache.
+ *
+ * Each proxy is a leaf holding a fat box: its tight bounds grown by a margin and stretched along
+ * its predicted displacement. Moving a proxy costs nothing while its tight bounds stay inside the
+ * fat box; only when they leave is the leaf removed and reinserted, choosing the sibling by the
+ * surface area heuristic and rebalancing with tree rotations on the way up. UpdatePairs() then
+ * queries the tree only for proxies that were reinserted, so a scene at rest does no tree work.
+ * Cached pairs persist until their fat boxes separate, which gives the narrowphase a stable set
+ * of pairs to test and reports only the pairs that began or ended.
+ */
+class BroadPhase {
+public:
+    using ProxyID = uint32_t;
+    static constexpr ProxyID INVALID_PROXY = UINT32_MAX;
+
+    struct Settings {
+        float fatMargin = 0.1f;               // World units added to every side of a fat box
+        float displacementScale = 2.0f;       // Steps of predicted motion a fat box stretches ahead
+    };
+
+    // Proxy IDs in ascending order
+    struct Pair {
+        ProxyID a;
+        ProxyID b;
+        bool operator==(const Pair& other) const { return a == other.a && b == other.b; }
+        bool operator<(const Pair& other) const { return a < other.a || (a == other.a && b < other.b); }
+    };
+
+    struct Stats {
+        uint32_t proxies = 0;
+        uint32_t height = 0;                  // Of the tree
+        uint32_t moved = 0;                   // Proxies reinserted before the last UpdatePairs()
+        uint32_t pairs = 0;
+        uint32_t pairsAdded = 0;
+        uint32_t pairsRemoved = 0;
+    };
+
+    BroadPhase();
+    explicit BroadPhase(const Settings& settings);
+
+    BroadPhase(const BroadPhase&) = delete;
+    BroadPhase& operator=(const BroadPhase&) = delete;
+
+    ProxyID CreateProxy(const AABB& box, uint64_t userData);
+    // Pairs involving the proxy are dropped without being reported as removed
+    void DestroyProxy(ProxyID proxy);
+    // displacement is the expected motion over the next step. Returns true if the proxy left its
+    // fat box and was reinserted
+    bool MoveProxy(ProxyID proxy, const AABB& box, const DirectX::XMFLOAT3& displacement);
+    void Clear();
+
+    bool IsProxy(ProxyID proxy) const { return proxy < nodes_.size() && nodes_[proxy].height == 0; }
+    uint64_t GetUserData(ProxyID proxy) const { return nodes_[proxy].userData; }
+    const AABB& GetFatAABB(ProxyID proxy) const { return nodes_[proxy].box; }
+    // Every proxy ID is below this, for walking all proxies with IsProxy()
+    uint32_t GetProxyCapacity() const { return static_cast<uint32_t>(nodes_.size()); }
+
+    // Brings the pair cache up to date with every move since the last call
+    void UpdatePairs();
+    const std::vector<Pair>& GetPairs() const { return pairs_; }
+    const std::vector<Pair>& GetAddedPairs() const { return pairsAdded_; }
+    const std::vector<Pair>& GetRemovedPairs() const { return pairsRemoved_; }
+
+    // fn(ProxyID) for every proxy whose fat box overlaps box; return false to stop
+    template<typename Fn>
+    void Query(const AABB& box, Fn&& fn) const;
+    // fn(ProxyID, float maxFraction) for every proxy whose fat box the segment from + (to - from)
+    // * t with t in [0, maxFraction] crosses. fn returns the new maxFraction, the fraction of a
+    // hit it found to look only for closer ones, maxFraction to go on unchanged or 0 to stop
+    template<typename Fn>
+    void RayCast(const DirectX::XMFLOAT3& from, const DirectX::XMFLOAT3& to, Fn&& fn) const;
+    // Up to PACKET_SIZE segments traversed together, each node box tested against all of them
+    // at once. Segment i sweeps a sphere of radius[i] (0 for a ray) and otherwise works as in
+    // RayCast, through fn(uint32_t segment, ProxyID, float maxFraction). The traversal stack is
+    // local, so unlike Query and RayCast packets may be cast from several threads at once
+    static constexpr uint32_t PACKET_SIZE = 4;
+    template<typename Fn>
+    void RayCastPacket(const DirectX::XMFLOAT3* from, const DirectX::XMFLOAT3* to, const float* radius, uint32_t count,
+                       Fn&& fn) const;
+
+    const Stats& GetStats() const;
+
+private:
+    static constexpr uint32_t NULL_NODE = UINT32_MAX;
+
+    // Leaves have height 0, free nodes -1 and reuse parent as the free list link
+    struct Node {
+        AABB box;
+        uint64_t userData = 0;
+        uint32_t parent = NULL_NODE;
+        uint32_t child1 = NULL_NODE;
+        uint32_t child2 = NULL_NODE;
+        int32_t height = -1;
+        bool moved = false;
+    };
+
+    static bool Overlaps(const AABB& a, const AABB& b);
+    static bool Contains(const AABB& outer, const AABB& inner);
+    static AABB Union(const AABB& a, const AABB& b);
+    static float Perimeter(const AABB& box);
+    static bool SegmentOverlaps(const AABB& box, const DirectX::XMFLOAT3& from, const DirectX::XMFLOAT3& delta,
+                                float maxFraction);
+
+    uint32_t AllocateNode();
+    void FreeNode(uint32_t node);
+    void InsertLeaf(uint32_t leaf);
+    void RemoveLeaf(uint32_t leaf);
+    uint32_t Balance(uint32_t node);
+    AABB MakeFat(const AABB& box, const DirectX::XMFLOAT3& displacement) const;
+
+    Settings settings_;
+    std::vector<Node> nodes_;
+    uint32_t root_;
+    uint32_t freeList_;
+    uint32_t proxyCount_;
+
+    std::vector<ProxyID> moveBuffer_;
+    std::vector<Pair> pairs_;                 // Sorted
+    std::vector<Pair> pairsAdded_;
+    std::vector<Pair> pairsRemoved_;
+    std::vector<Pair> candidates_;
+    mutable std::vector<uint32_t> stack_;
+    mutable Stats stats_;
+};
+
+template<typename Fn>
+void BroadPhase::Query(const AABB& box, Fn&& fn) const {
+    if (root_ == NULL_NODE) return;
+    stack_.clear();
+    stack_.push_back(root_);
+    while (!stack_.empty()) {
+        uint32_t index = stack_.back();
+        stack_.pop_back();
+        const Node& node = nodes_[index];
+        if (!Overlaps(node.box, box)) continue;
+        if (node.height == 0) {
+            if (!fn(static_cast<ProxyID>(index))) return;
+        } else {
+            stack_.push_back(node.child1);
+            stack_.push_back(node.child2);
+        }
+    }
+}
+
+template<typename Fn>
+void BroadPhase::RayCast(const DirectX::XMFLOAT3& from, const DirectX::XMFLOAT3& to, Fn&& fn) const {
+    if (root_ == NULL_NODE) return;
+    DirectX::XMFLOAT3 delta(to.x - from.x, to.y - from.y, to.z - from.z);
+    float maxFraction = 1.0f;
+    stack_.clear();
+    stack_.push_back(root_);
+    while (!stack_.empty()) {
+        uint32_t index = stack_.back();
+        stack_.pop_back();
+        const Node& node = nodes_[index];
+        if (!SegmentOverlaps(node.box, from, delta, maxFraction)) continue;
+        if (node.height == 0) {
+            maxFraction = fn(static_cast<ProxyID>(index), maxFraction);
+            if (maxFraction <= 0.0f) return;
+        } else {
+            stack_.push_back(node.child1);
+            stack_.push_back(node.child2);
+        }
+    }
+}
+
+template<typename Fn>
+void BroadPhase::RayCastPacket(const DirectX::XMFLOAT3* from, const DirectX::XMFLOAT3* to, const float* radius,
+                               uint32_t count, Fn&& fn) const {
+    if (root_ == NULL_NODE || count == 0) return;
+    if (count > PACKET_SIZE) count = PACKET_SIZE;
+
+    // Segments as origin and reciprocal direction per lane. Axis-parallel segments use a huge
+    // reciprocal rather than infinity so the slab test never sees 0 * inf; unused lanes start
+    // with a negative maxFraction and never pass
+    alignas(16) float originX[PACKET_SIZE], originY[PACKET_SIZE], originZ[PACKET_SIZE];
+    alignas(16) float inverseX[PACKET_SIZE], inverseY[PACKET_SIZE], inverseZ[PACKET_SIZE];
+    alignas(16) float radii[PACKET_SIZE], maxFractions[PACKET_SIZE];
+    auto reciprocal = [](float d) { return d > 1e-12f ? 1.0f / d : (d < -1e-12f ? 1.0f / d : 1e30f); };
+    for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+        uint32_t source = lane < count ? lane : 0;
+        originX[lane] = from[source].x;
+        originY[lane] = from[source].y;
+        originZ[lane] = from[source].z;
+        inverseX[lane] = reciprocal(to[source].x - from[source].x);
+        inverseY[lane] = reciprocal(to[source].y - from[source].y);
+        inverseZ[lane] = reciprocal(to[source].z - from[source].z);
+        radii[lane] = radius[source];
+        maxFractions[lane] = lane < count ? 1.0f : -1.0f;
+    }
+    const __m128 ox = _mm_load_ps(originX), oy = _mm_load_ps(originY), oz = _mm_load_ps(originZ);
+    const __m128 ix = _mm_load_ps(inverseX), iy = _mm_load_ps(inverseY), iz = _mm_load_ps(inverseZ);
+    const __m128 r = _mm_load_ps(radii);
+    __m128 tMax = _mm_load_ps(maxFractions);
+
+    uint32_t fixedStack[64];
+    std::vector<uint32_t> spill;
+    uint32_t* stack = fixedStack;
+    size_t capacity = 64;
+    size_t size = 0;
+    auto push = [&](uint32_t node) {
+        if (size == capacity) {
+            if (spill.empty()) spill.assign(fixedStack, fixedStack + size);
+            spill.resize(capacity * 2);
+            stack = spill.data();
+            capacity *= 2;
+        }
+        stack[size++] = node;
+    };
+
+    push(root_);
+    while (size > 0) {
+        uint32_t index = stack[--size];
+        const Node& node = nodes_[index];
+
+        // Slab test of all lanes against the node box grown by each lane's radius
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(node.box.min.x), r), ox), ix);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_set1_ps(node.box.max.x), r), ox), ix);
+        __m128 tNear = _mm_max_ps(_mm_min_ps(t1, t2), _mm_setzero_ps());
+        __m128 tFar = _mm_min_ps(_mm_max_ps(t1, t2), tMax);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(node.box.min.y), r), oy), iy);
+        t2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_set1_ps(node.box.max.y), r), oy), iy);
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(node.box.min.z), r), oz), iz);
+        t2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_set1_ps(node.box.max.z), r), oz), iz);
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+        int lanes = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+        if (!lanes) continue;
+
+        if (node.height == 0) {
+            _mm_store_ps(maxFractions, tMax);
+            for (uint32_t lane = 0; lane < count; ++lane) {
+                if (!(lanes & (1 << lane))) continue;
+                float fraction = fn(lane, static_cast<ProxyID>(index), maxFractions[lane]);
+                maxFractions[lane] = fraction > 0.0f ? fraction : -1.0f;
+            }
+            tMax = _mm_load_ps(maxFractions);
+        } else {
+            push(node.child1);
+            push(node.child2);
+        }
+    }
+}
+
+} // namespace Nexus
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "EngineConfig.h"
+
+#if defined(NEXUS_BULLET_PHYSICS_ENABLED) && defined(NEXUS_BULLET_MT_ENABLED)
+
+#include <LinearMath/btThreads.h>
+
+namespace Nexus {
+
+class JobSystem;
+
+/**
+ * Bullet task scheduler that runs Bullet's parallel loops as engine jobs.
+ *
+ * Installed with btSetTaskScheduler() in place of Bullet's own OpenMP, TBB or thread pool
+ * schedulers, so the multithreaded dynamics world (btDiscreteDynamicsWorldMt with
+ * btCollisionDispatcherMt and btConstraintSolverPoolMt) shares the job system's workers instead
+ * of competing with them. The thread that steps the world helps run the loop's jobs while it
+ * waits, as with any JobSystem::ParallelFor, which also makes Bullet's nested loops safe.
+ */
+class BulletTaskScheduler : public btITaskScheduler {
+public:
+    explicit BulletTaskScheduler(JobSystem& jobs);
+
+    BulletTaskScheduler(const BulletTaskScheduler&) = delete;
+    BulletTaskScheduler& operator=(const BulletTaskScheduler&) = delete;
+
+    // Workers plus the calling thread, capped at Bullet's per-thread storage
+    int getMaxNumThreads() const override;
+    int getNumThreads() const override { return numThreads_; }
+    // Narrows how wide loops are split; the job system's worker count stays as it is
+    void setNumThreads(int numThreads) override;
+
+    void parallelFor(int begin, int end, int grainSize, const btIParallelForBody& body) override;
+    btScalar parallelSum(int begin, int end, int grainSize, const btIParallelSumBody& body) override;
+
+private:
+    // Chunk size for a loop: at least Bullet's grain, no more chunks than threads can take
+    int ChunkSize(int count, int grainSize) const;
+
+    JobSystem& jobs_;
+    int numThreads_;
+};
+
+} // namespace Nexus
+
+#endif
@@ -28,6 +28,12 @@ public:
     const DirectX::XMMATRIX& GetProjectionMatrix() const { return projectionMatrix_; }
     DirectX::XMMATRIX GetViewProjectionMatrix() const { return DirectX::XMMatrixMultiply(viewMatrix_, projectionMatrix_); }
 
+    // Subpixel offset in clip space for temporal anti-aliasing (TemporalAA::GetJitter()). Only the
+    // jittered projection carries it; culling and motion vectors use the plain one
+    void SetJitter(const DirectX::XMFLOAT2& jitter) { jitter_ = jitter; }
+    const DirectX::XMFLOAT2& GetJitter() const { return jitter_; }
+    DirectX::XMMATRIX GetJitteredProjectionMatrix() const;
+
     // Movement
     void MoveForward(float distance);
     void MoveRight(float distance);
@@ -46,6 +52,7 @@ private:
     
     float pitch_;
     float yaw_;
+    DirectX::XMFLOAT2 jitter_;
 };
 
 } // namespace Nexus
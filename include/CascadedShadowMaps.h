@@ -0,0 +1,175 @@
+#pragma once
+
+#include "Platform.h"
+#include "SceneBVH.h"
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class Mesh;
+class StateCache;
+
+/**
+ * Cascaded shadow maps for one directional light with cached static casters.
+ *
+ * Every cascade keeps a depth slice holding only the static casters. Cascades are bounding
+ * spheres of their slice of the view frustum, so their size does not change as the camera
+ * turns, and their centers snap to whole shadow texels, so translating the camera shifts the
+ * cached depth by an integer offset. Moving the cascade then scrolls the cached slice and draws
+ * static casters only into the newly exposed strips. On every update the static slice is copied
+ * into the final shadow map and the dynamic casters are drawn on top. Near cascades update every
+ * frame, far ones at reduced rates in round-robin.
+ */
+class CascadedShadowMaps {
+public:
+    static constexpr UINT MAX_CASCADES = 4;
+
+    struct Settings {
+        UINT resolution = 2048;
+        UINT cascadeCount = 4;
+        float maxDistance = 150.0f;      // Shadowed distance from the camera
+        float splitLambda = 0.75f;       // 1 for logarithmic splits, 0 for uniform
+        float casterDistance = 100.0f;   // How far toward the light casters still shadow a cascade
+        UINT updateIntervals[MAX_CASCADES] = { 1, 2, 4, 4 };  // Frames between cascade updates
+        int depthBias = 1000;
+        float slopeScaledDepthBias = 2.0f;
+    };
+
+    struct Caster {
+        Mesh* mesh = nullptr;
+        DirectX::XMFLOAT4X4 world;
+        AABB bounds;                     // World space
+    };
+
+    struct Stats {
+        uint32_t cascadesUpdated = 0;
+        uint32_t staticRedraws = 0;      // Cached slices redrawn from scratch
+        uint32_t staticScrolls = 0;      // Cached slices that were scrolled instead
+        uint32_t staticCastersDrawn = 0;
+        uint32_t dynamicCastersDrawn = 0;
+    };
+
+    // Result of moving a cascade whose cached slice is still valid
+    struct ScrollRegion {
+        int offsetX = 0;                 // Old texel = new texel + offset
+        int offsetY = 0;
+        UINT rectCount = 0;              // Newly exposed strips, in texels of the new position
+        D3D11_RECT rects[2];
+    };
+
+    CascadedShadowMaps();
+    ~CascadedShadowMaps();
+
+    CascadedShadowMaps(const CascadedShadowMaps&) = delete;
+    CascadedShadowMaps& operator=(const CascadedShadowMaps&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                    const Settings& settings);
+    void Shutdown();
+    const Settings& GetSettings() const { return settings_; }
+
+    // Static casters are cached; adding or removing one redraws the cascades it overlaps.
+    // Call InvalidateStatic after moving static geometry in place
+    uint32_t AddStaticCaster(const Caster& caster);
+    void RemoveStaticCaster(uint32_t id);
+    void ClearStaticCasters();
+    void InvalidateStatic();
+    void InvalidateStatic(const AABB& bounds);
+
+    // Dynamic casters are drawn on every update of the cascades they overlap; set them each frame
+    void SetDynamicCasters(const std::vector<Caster>& casters) { dynamicCasters_ = casters; }
+
+    // view and projection are the row-vector camera matrices of a perspective projection.
+    // Fits the cascades and redraws the ones due this frame. Leaves the shadow map's targets
+    // bound, so call it before binding the shadow map for reading and restore the main target after
+    void Update(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, const DirectX::XMFLOAT3& lightDirection);
+
+    // Texture2DArray with one depth slice per cascade
+    ID3D11ShaderResourceView* GetShadowMap() const { return shadowView_; }
+    UINT GetCascadeCount() const { return settings_.cascadeCount; }
+    // World to shadow clip space of what the cascade's slice currently holds. Cascades that were
+    // not due keep last frame's placement, so pick the first cascade whose bounds hold the point
+    const DirectX::XMFLOAT4X4& GetCascadeViewProjection(UINT cascade) const { return cascades_[cascade].viewProjection; }
+    // View-space depth where the cascade ends
+    float GetSplitDistance(UINT cascade) const { return cascades_[cascade].splitFar; }
+    const Stats& GetStats() const { return stats_; }
+
+    // Exposed texels when a cascade moves from texel origin (fromX, fromY) to (toX, toY); false
+    // when the move is too large to scroll
+    static bool ComputeScrollRegion(int fromX, int fromY, int toX, int toY, UINT resolution, ScrollRegion& region);
+
+private:
+    struct Cascade {
+        float splitNear = 0.0f;
+        float splitFar = 0.0f;
+        float radius = 0.0f;
+        int originX = 0;                 // Snapped center in texels along the light's right/up axes
+        int originY = 0;
+        float depthCenter = 0.0f;        // Light-space depth the depth window is centered on
+        float depthRange = 0.0f;
+        bool staticValid = false;        // Cached slice matches the current placement
+        UINT cache = 0;                  // Which cache array currently holds the slice
+        DirectX::XMFLOAT4X4 viewProjection;
+    };
+
+    struct StaticCaster {
+        Caster caster;
+        uint32_t id = 0;
+    };
+
+    // Per-draw constants, matches CasterConstants in the embedded shader
+    struct GpuCasterConstants {
+        DirectX::XMFLOAT4X4 worldViewProjection;
+        DirectX::XMFLOAT4 positionOffset;
+        DirectX::XMFLOAT4 positionScale;
+    };
+
+    bool CreateTargets();
+    bool CreateShaders();
+    void SetLightBasis(const DirectX::XMFLOAT3& lightDirection);
+    // Light view-projection of the texels in rect at the cascade's current placement
+    DirectX::XMMATRIX BuildViewProjection(const Cascade& cascade, const D3D11_RECT& rect) const;
+    void UpdateStatic(UINT index, int originX, int originY);
+    void DrawStatic(UINT index, const D3D11_RECT& rect);
+    bool DrawCaster(const Caster& caster, DirectX::CXMMATRIX viewProjection, const Frustum& frustum);
+    void InvalidateOverlapping(const AABB& bounds);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    StateCache* stateCache_;
+    Settings settings_;
+
+    // Final shadow map and the two static caches, ping-ponged while scrolling
+    ID3D11Texture2D* shadowTexture_;
+    ID3D11ShaderResourceView* shadowView_;
+    ID3D11DepthStencilView* shadowTargets_[MAX_CASCADES];
+    ID3D11Texture2D* cacheTextures_[2];
+    ID3D11ShaderResourceView* cacheViews_[2];
+    ID3D11DepthStencilView* cacheTargets_[2][MAX_CASCADES];
+
+    ID3D11VertexShader* casterShaders_[2];       // Indexed by VertexFormat
+    ID3D11InputLayout* casterLayouts_[2];
+    ID3D11VertexShader* fullscreenShader_;
+    ID3D11PixelShader* scrollShader_;
+    ID3D11Buffer* casterConstants_;
+    ID3D11Buffer* scrollConstants_;
+    ID3D11RasterizerState* casterState_;
+    ID3D11RasterizerState* scissorState_;        // casterState_ with the scissor test
+    ID3D11DepthStencilState* depthState_;
+    ID3D11DepthStencilState* overwriteState_;    // Always passes, used by the scroll copy
+
+    DirectX::XMFLOAT3 lightDirection_;
+    DirectX::XMFLOAT4X4 lightRotation_;          // World to light space, no translation
+    Cascade cascades_[MAX_CASCADES];
+    uint64_t frame_;
+    bool forceUpdate_;                           // Update every cascade next frame, off schedule
+
+    std::vector<StaticCaster> staticCasters_;
+    std::vector<Caster> dynamicCasters_;
+    uint32_t nextCasterId_;
+
+    Stats stats_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+struct ClothSettings {
+    DirectX::XMFLOAT3 gravity = DirectX::XMFLOAT3(0.0f, -9.81f, 0.0f);
+    DirectX::XMFLOAT3 wind = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);   // Acceleration, on top of gravity
+    float damping = 0.5f;                      // Share of the velocity lost per second
+    float thickness = 0.01f;                   // Kept between particles and colliders
+    int subSteps = 8;                          // Per Step(); each projects every constraint once
+    float maxTimeStep = 1.0f / 30.0f;          // Longer steps are clamped, so a hitch cannot explode the cloth
+};
+
+/**
+ * Extended position based dynamics (XPBD) cloth.
+ *
+ * Particles are stored as structure of arrays. Distance constraints are graph colored when the
+ * cloth is built, so no two constraints of a color share a particle: a color is solved four
+ * constraints per SSE operation, split across the job system when it is large enough. Each step
+ * is divided into substeps that project every constraint once, which converges faster than
+ * iterating one long step and needs no accumulated multipliers.
+ *
+ * Every free particle is also tethered to the closest pinned particle by its rest distance
+ * through the constraint graph (long range attachments). A tether only acts once the particle
+ * is further away than that, so it does not stiffen the cloth, but a long cape or flag cannot
+ * stretch under its own weight however few substeps it gets.
+ *
+ * Adding particles or constraints marks the cloth for a rebuild, which the next step does.
+ */
+class ClothSolver {
+public:
+    ClothSolver();
+    explicit ClothSolver(const ClothSettings& settings);
+
+    void SetJobSystem(JobSystem* jobs) { jobs_ = jobs; }
+    void SetSettings(const ClothSettings& settings) { settings_ = settings; }
+    const ClothSettings& GetSettings() const { return settings_; }
+
+    // mass 0 or less pins the particle; returns its index
+    uint32_t AddParticle(const DirectX::XMFLOAT3& position, float mass);
+    void SetParticleMass(uint32_t particle, float mass);
+    // Rest length is the particles' current distance. compliance is the inverse stiffness in
+    // metres per newton; 0 does not stretch at all
+    void AddDistanceConstraint(uint32_t a, uint32_t b, float compliance = 0.0f);
+    // Rows x columns of particles across the two edge vectors from origin, with structural,
+    // shear and bending constraints; returns the index of the first particle, row by row
+    uint32_t AddGrid(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& edgeU, const DirectX::XMFLOAT3& edgeV,
+                     uint32_t columns, uint32_t rows, float particleMass, float compliance = 0.0f,
+                     float bendCompliance = 0.001f);
+    void Clear();
+
+    // Pinned particles move there on the next step, which is how a cape follows its character;
+    // free particles are teleported, losing their velocity
+    void SetParticlePosition(uint32_t particle, const DirectX::XMFLOAT3& position);
+    DirectX::XMFLOAT3 GetParticlePosition(uint32_t particle) const;
+    void GetParticlePositions(DirectX::XMFLOAT3* positions) const;   // GetParticleCount() of them
+    size_t GetParticleCount() const { return particleCount_; }
+    size_t GetConstraintCount() const { return constraintA_.size(); }
+    size_t GetColorCount() const { return colorStart_.empty() ? 0 : colorStart_.size() - 1; }
+
+    // Spheres (center, radius) the cloth is kept out of, until replaced
+    void SetColliders(const DirectX::XMFLOAT4* spheres, size_t count);
+
+    void Step(float deltaTime);
+
+private:
+    static constexpr uint32_t NO_PARTICLE = UINT32_MAX;
+    static constexpr uint32_t MAX_COLORS = 64;
+    static constexpr size_t PARALLEL_THRESHOLD = 2048;   // Particles or constraints per pass
+
+    void Build();
+    void BuildTethers();
+    void Predict(float stepTime);
+    void SolveDistances(float stepTime);
+    void SolveTethers();
+    void SolveCollisions();
+    void UpdateVelocities(float stepTime);
+    void SolveDistance(uint32_t constraint, float complianceScale);
+    // fn(begin, end) over [0, count) in multiples of four, across the job system when worthwhile
+    template<typename Fn>
+    void ForRange(size_t count, Fn&& fn);
+
+    ClothSettings settings_;
+    JobSystem* jobs_;
+    bool dirty_;
+
+    // Particles, padded by three lanes for the last SSE load; padding has no mass and stays put
+    size_t particleCount_;
+    std::vector<float> positionX_, positionY_, positionZ_;
+    std::vector<float> previousX_, previousY_, previousZ_;
+    std::vector<float> velocityX_, velocityY_, velocityZ_;
+    std::vector<float> inverseMass_;
+    std::vector<uint32_t> tetherAnchor_;       // Pinned particle, or the particle itself when untethered
+    std::vector<float> tetherLength_;          // FLT_MAX when untethered
+
+    // Distance constraints as added, then reordered by color once built
+    std::vector<uint32_t> constraintA_, constraintB_;
+    std::vector<float> restLength_, compliance_;
+    std::vector<uint32_t> colorStart_;         // Color c is constraints colorStart_[c] .. colorStart_[c + 1]
+    uint32_t serialStart_;                     // Constraints from here on found no free color and run alone
+
+    std::vector<DirectX::XMFLOAT4> colliders_;
+};
+
+} // namespace Nexus
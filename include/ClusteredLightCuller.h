@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class Light;
+class JobSystem;
+class StateCache;
+
+/**
+ * Clustered forward light assignment.
+ *
+ * The view frustum is split into a GRID_X x GRID_Y grid of screen tiles and GRID_Z exponential
+ * depth slices. Build() bins every point and spot light into the clusters its bounding sphere
+ * touches on the CPU, testing four clusters per SSE step and one depth slice per job, and
+ * uploads the lights, each cluster's (offset, count) range and the packed 16-bit light index
+ * list. Bind() exposes them to pixel shaders (see PBR_PS.hlsl), which then shade only the lights
+ * of their own cluster. Directional lights are placed first in the light buffer and apply
+ * everywhere.
+ *
+ * Other volumes can share the grid: BinSpheres() bins any list of view-space spheres into the
+ * clusters of the last Build() the same way (see DecalSystem).
+ */
+class ClusteredLightCuller {
+public:
+    static constexpr UINT GRID_X = 16;
+    static constexpr UINT GRID_Y = 9;
+    static constexpr UINT GRID_Z = 24;
+    static constexpr UINT CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+    static constexpr UINT MAX_LIGHTS = 4096;
+
+    // Pixel shader slots; the constant buffer follows the material buffer at b1
+    static constexpr UINT LIGHT_SLOT = 10;     // t10 lights, t11 cluster ranges, t12 light indices
+    static constexpr UINT CONSTANT_SLOT = 2;
+
+    // Per-cluster index lists as the shaders read them: an (offset, count) pair per cluster into
+    // indices, packed back to back
+    struct ClusterLists {
+        std::vector<uint32_t> ranges;
+        std::vector<uint16_t> indices;
+        std::vector<uint16_t> slots;     // Scratch, maxPerCluster per cluster
+        uint32_t maxCount = 0;           // Most entries in one cluster
+        uint32_t dropped = 0;            // References lost to maxPerCluster
+    };
+
+    struct Stats {
+        uint32_t lights = 0;             // Point and spot lights binned this frame
+        uint32_t directionalLights = 0;
+        uint32_t indices = 0;            // Total light references across all clusters
+        uint32_t maxClusterLights = 0;
+        uint32_t droppedReferences = 0;  // Lost to the per-cluster limit
+    };
+
+    ClusteredLightCuller();
+    ~ClusteredLightCuller();
+
+    ClusteredLightCuller(const ClusteredLightCuller&) = delete;
+    ClusteredLightCuller& operator=(const ClusteredLightCuller&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+    void Shutdown();
+
+    // Lights past this limit in one cluster are dropped and counted in Stats
+    void SetMaxLightsPerCluster(UINT maxLights);
+    UINT GetMaxLightsPerCluster() const { return maxLightsPerCluster_; }
+
+    // view and projection are the row-vector camera matrices of a perspective projection;
+    // screen size is in pixels. Null entries in lights are skipped
+    void Build(const std::vector<const Light*>& lights, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection,
+               int screenWidth, int screenHeight, JobSystem* jobs = nullptr);
+    void Bind(StateCache& stateCache) const;
+    // Same resources at the same slots for compute shaders (see FroxelFog)
+    void BindCompute() const;
+
+    // Bins view-space spheres (xyz center, w radius) for the camera of the last Build(), index i
+    // listed as firstIndex + i, at most maxPerCluster per cluster. Nothing is binned when that
+    // Build() had no perspective projection
+    void BinSpheres(const std::vector<DirectX::XMFLOAT4>& spheres, uint16_t firstIndex, UINT maxPerCluster,
+                    ClusterLists& lists, JobSystem* jobs = nullptr) const;
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    // Matches ClusterLight in PBR_PS.hlsl
+    struct GpuLight {
+        DirectX::XMFLOAT3 position;
+        float range;                  // 0 for directional lights
+        DirectX::XMFLOAT3 color;      // Premultiplied by intensity
+        float spotScale;              // Cone falloff: saturate(cos * spotScale + spotOffset)
+        DirectX::XMFLOAT3 direction;
+        float spotOffset;
+    };
+
+    // Matches ClusterBuffer in PBR_PS.hlsl
+    struct GpuConstants {
+        DirectX::XMFLOAT4X4 view;     // Transposed for HLSL
+        float tileScale[2];           // Tiles per pixel
+        float sliceScale;             // slice = log(viewZ) * sliceScale + sliceBias
+        float sliceBias;
+        UINT directionalLights;
+        UINT lightCount;              // Directional included; read by DeferredRenderer
+        UINT padding[2];
+    };
+
+    // View-space bounds of every cluster in slice-major order, structure of arrays for SSE
+    struct ClusterBounds {
+        std::vector<float> minX, maxX, minY, maxY;
+        std::vector<float> minZ, maxZ;          // Per slice
+    };
+
+    void BuildClusterBounds(DirectX::CXMMATRIX projection, float nearPlane, float farPlane);
+    bool EnsureIndexCapacity(UINT indexCount);
+    void Upload();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+
+    ID3D11Buffer* lightBuffer_;
+    ID3D11ShaderResourceView* lightView_;
+    ID3D11Buffer* rangeBuffer_;
+    ID3D11ShaderResourceView* rangeView_;
+    ID3D11Buffer* indexBuffer_;
+    ID3D11ShaderResourceView* indexView_;
+    UINT indexCapacity_;
+    ID3D11Buffer* constants_;
+
+    UINT maxLightsPerCluster_;
+    DirectX::XMFLOAT4X4 boundsProjection_;  // Projection the cached bounds were built for
+    ClusterBounds bounds_;
+    bool gridValid_;                        // The last Build() had a perspective projection
+
+    // CPU copies of everything Upload() writes
+    std::vector<GpuLight> gpuLights_;
+    std::vector<DirectX::XMFLOAT4> spheres_;  // View-space bounds of gpuLights_ past the directional ones
+    GpuConstants gpuConstants_;
+    ClusterLists lists_;
+
+    Stats stats_;
+};
+
+} // namespace Nexus
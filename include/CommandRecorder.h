@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Nexus {
+
+class StateCache;
+class ConstantBufferRing;
+class JobSystem;
+
+/**
+ * Everything a draw needs to record into one device context
+ */
+struct CommandContext {
+    ID3D11DeviceContext* context = nullptr;
+    StateCache* stateCache = nullptr;
+    ConstantBufferRing* constants = nullptr;
+};
+
+/**
+ * Parallel command recording on D3D11 deferred contexts.
+ *
+ * Record() runs each pass on its own deferred context (spread over the job system) and
+ * finishes it into a command list; Execute() replays the lists on the immediate context in
+ * pass order, so the result matches recording the passes back to back. Each deferred context
+ * starts from default pipeline state and has its own state cache and constant ring.
+ *
+ * Drivers without native command list support still work (the runtime emulates them), but
+ * the recording cost then mostly moves back to Execute().
+ */
+class CommandRecorder {
+public:
+    using RecordFunction = std::function<void(size_t pass, CommandContext& context)>;
+
+    CommandRecorder();
+    ~CommandRecorder();
+
+    CommandRecorder(const CommandRecorder&) = delete;
+    CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+    bool Initialize(ID3D11Device* device, unsigned int contextCount);
+    void Shutdown();
+
+    unsigned int GetContextCount() const { return static_cast<unsigned int>(recorders_.size()); }
+    bool HasDriverCommandLists() const { return driverCommandLists_; }
+
+    // Records passCount (<= GetContextCount()) passes; jobs may be null to record serially
+    bool Record(JobSystem* jobs, size_t passCount, const RecordFunction& record);
+
+    // Replays and releases the recorded lists. The immediate context is left in default state
+    // and its cache invalidated, so the caller must rebind render targets before drawing again.
+    void Execute(ID3D11DeviceContext* immediateContext, StateCache& immediateCache);
+
+    // StateCache::SetPixelOverride for every deferred context's cache
+    void SetPixelOverride(ID3D11PixelShader* shader, ID3D11BlendState* blend);
+
+private:
+    struct Recorder {
+        ID3D11DeviceContext* context = nullptr;
+        std::unique_ptr<StateCache> stateCache;
+        std::unique_ptr<ConstantBufferRing> constants;
+        ID3D11CommandList* commandList = nullptr;
+    };
+
+    void ReleaseCommandLists();
+
+    std::vector<Recorder> recorders_;
+    size_t recordedPasses_;
+    bool driverCommandLists_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+
+namespace Nexus {
+
+// Core ECS components shared between simulation, rendering and scripting. Kept as plain
+// data so chunks can move them with a memcpy-equivalent move.
+
+struct TransformComponent {
+    DirectX::XMFLOAT3 position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    DirectX::XMFLOAT3 previousPosition = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f); // Last simulation step, for interpolation
+    DirectX::XMFLOAT4 rotation = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+    DirectX::XMFLOAT3 scale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
+};
+
+struct PhysicsBodyComponent {
+    DirectX::XMFLOAT3 velocity = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    float mass = 1.0f;                    // 0 or less is static
+    uint32_t broadPhaseProxy = 0xFFFFFFFFu; // Owned by PhysicsEngine
+    uint32_t restingSteps = 0;            // Owned by PhysicsEngine
+    uint32_t islandSlot = 0;              // Owned by PhysicsEngine, scratch index while stepping
+    uint32_t eventCategories = 1;         // Collision event bits (PhysicsEngine::SetBodyEventCategories)
+    bool continuous = false;              // Swept when it moves fast (PhysicsEngine::SetBodyContinuous)
+    uint8_t simulationTier = 0;           // Owned by PhysicsEngine (PhysicsEngine::SimulationTier)
+};
+
+// A body put to sleep, or frozen far from every simulation focus, by PhysicsEngine. It replaces
+// PhysicsBodyComponent so that sleeping bodies drop out of every simulation query; the engine
+// swaps it back when the body wakes.
+struct SleepingBodyComponent : PhysicsBodyComponent {};
+
+struct RenderableComponent {
+    DirectX::XMFLOAT4 color = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    uint32_t shapeType = 0; // CollisionShape::Type for primitive rendering
+};
+
+// Marks an entity whose transform a ReplicationServer sends to clients
+struct ReplicatedComponent {
+    uint16_t type = 0;      // Game-defined kind, sent on creation so clients know what to spawn
+};
+
+} // namespace Nexus
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "AnimationSystem.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+struct AnimationCompressionSettings {
+    float positionTolerance = 0.001f;          // Units a reduced position may stray from the source
+    float rotationTolerance = 0.001f;          // Radians
+    float scaleTolerance = 0.001f;
+};
+
+/**
+ * Animation clip compressed for memory and sampled in place.
+ *
+ * Every track's position, rotation and scale is a channel of its own. Keys that interpolating
+ * their neighbours reproduces within tolerance are dropped, and a channel that holds still keeps
+ * a single key. Kept keys are six bytes plus a two byte time: positions and scales as 16 bits
+ * per axis across the channel's range, rotations as the three smallest quaternion components in
+ * 15 bits each, with the index of the dropped one. Key times are 16 bits across the duration.
+ *
+ * Sample() decodes the two keys around the time and interpolates like the uncompressed tracks.
+ * Save() and Load() read and write the .nanim clip format, which LoadAnimationClip() understands.
+ */
+class CompressedClip {
+public:
+    static constexpr uint32_t MAGIC = 0x4D4E414E;   // "NANM"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t CHANNELS = 3;         // Position, rotation, scale; cursors per track
+
+    CompressedClip();
+
+    bool Compress(const AnimationSystem::AnimationClip& clip, const AnimationCompressionSettings& settings);
+
+    bool Save(const std::string& filename) const;
+    bool Load(const std::string& filename);
+
+    // cursors holds CHANNELS keys per track from the last sample, see AnimationTrack::FindKeyframes
+    void Sample(size_t track, float time, int* cursors, DirectX::XMFLOAT3& position, DirectX::XMFLOAT4& rotation,
+                DirectX::XMFLOAT3& scale) const;
+
+    size_t GetTrackCount() const { return tracks_.size(); }
+    int GetBoneIndex(size_t track) const { return tracks_[track].boneIndex; }
+    size_t GetKeyCount() const { return keyTimes_.size(); }
+    size_t GetMemoryUsage() const;
+
+    // Clip settings carried through Save() and Load()
+    std::string name;
+    float duration;
+    float frameRate;
+    bool isLooping;
+    bool hasRootMotion;
+    std::map<std::string, float> events;
+
+private:
+    struct Channel {
+        uint32_t firstKey;                     // Into keyTimes_ and keyValues_
+        uint32_t keyCount;                     // 1 for a channel that holds still
+        DirectX::XMFLOAT3 rangeMin;            // Positions and scales decode to rangeMin + q * rangeStep
+        DirectX::XMFLOAT3 rangeStep;
+    };
+
+    struct Track {
+        int32_t boneIndex;
+        Channel channels[CHANNELS];
+    };
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        float duration;
+        float frameRate;
+        uint32_t flags;                        // 1 looping, 2 root motion
+        uint32_t trackCount;
+        uint32_t keyCount;
+        uint32_t eventCount;
+        uint32_t nameLength;
+    };
+
+    void AddVectorChannel(Channel& channel, const std::vector<DirectX::XMFLOAT3>& values,
+                          const std::vector<float>& times, float tolerance);
+    void AddRotationChannel(Channel& channel, const std::vector<DirectX::XMFLOAT4>& values,
+                            const std::vector<float>& times, float tolerance);
+    uint16_t QuantizeTime(float time) const;
+    float KeyTime(uint32_t key) const;
+    // Key pair around time and the blend between them, starting the search at cursor
+    void FindKeys(const Channel& channel, float time, int& cursor, uint32_t& prev, uint32_t& next, float& t) const;
+    DirectX::XMFLOAT3 DecodeVector(const Channel& channel, uint32_t key) const;
+    DirectX::XMFLOAT4 DecodeRotation(uint32_t key) const;
+
+    std::vector<Track> tracks_;
+    std::vector<uint16_t> keyTimes_;           // Across [0, duration]
+    std::vector<uint16_t> keyValues_;          // Three per key
+};
+
+} // namespace Nexus
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+
+namespace Nexus {
+
+/**
+ * Per-draw constant allocator backed by one large dynamic constant buffer.
+ *
+ * On Direct3D 11.1 devices that allow it, allocations are 256-byte aligned slices written with
+ * MAP_WRITE_NO_OVERWRITE and bound with VSSetConstantBuffers1 offsets, so a draw's constants
+ * cost a pointer bump and a memcpy. The buffer is renamed with MAP_WRITE_DISCARD only when the
+ * cursor wraps, which is what keeps in-flight slices safe. Older devices fall back to small
+ * pools of dynamic buffers per size class, each upload discarding its own buffer.
+ */
+class ConstantBufferRing {
+public:
+    struct Allocation {
+        ID3D11Buffer* buffer = nullptr;
+        UINT firstConstant = 0;   // In 16-byte constants, pass straight to *SetConstantBuffers1
+        UINT numConstants = 0;    // 0 means the whole buffer (fallback path)
+    };
+
+    struct Stats {
+        uint64_t uploads = 0;
+        uint64_t bytes = 0;
+        uint64_t discards = 0;
+    };
+
+    static constexpr UINT DEFAULT_CAPACITY = 1024 * 1024;
+    static constexpr UINT ALIGNMENT = 256;               // 16 constants, required for offsets
+    static constexpr UINT MAX_ALLOCATION = 4096 * 16;    // D3D11 constant buffer size limit
+
+    ConstantBufferRing();
+    ~ConstantBufferRing();
+
+    ConstantBufferRing(const ConstantBufferRing&) = delete;
+    ConstantBufferRing& operator=(const ConstantBufferRing&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT capacity = DEFAULT_CAPACITY);
+    void Shutdown();
+
+    void BeginFrame() { stats_ = Stats(); }
+    // Next upload discards; needed whenever a deferred context starts a new command list
+    void Reset() { cursor_ = 0; needsDiscard_ = true; }
+
+    // Copies size bytes into fresh constant memory; the allocation stays valid until the ring
+    // wraps, so bind it for the draws that follow and allocate again for the next ones
+    bool Upload(const void* data, UINT size, Allocation& out);
+
+    template<typename T>
+    bool Upload(const T& data, Allocation& out) {
+        return Upload(&data, static_cast<UINT>(sizeof(T)), out);
+    }
+
+    bool UsesOffsets() const { return useOffsets_; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    static constexpr int FALLBACK_SIZE_CLASSES = 9;      // 256 B .. 64 KB
+    static constexpr int FALLBACK_BUFFERS_PER_CLASS = 8; // Live allocations per size class between draws
+
+    ID3D11Buffer* CreateDynamicBuffer(UINT size);
+    bool UploadFallback(const void* data, UINT size, Allocation& out);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    bool useOffsets_;
+
+    // Offset path
+    ID3D11Buffer* ringBuffer_;
+    UINT capacity_;
+    UINT cursor_;
+    bool needsDiscard_;
+
+    // Fallback path
+    ID3D11Buffer* fallbackBuffers_[FALLBACK_SIZE_CLASSES][FALLBACK_BUFFERS_PER_CLASS];
+    int fallbackNext_[FALLBACK_SIZE_CLASSES];
+
+    Stats stats_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+/**
+ * Sequential impulse solver for contacts and joints between point-mass bodies.
+ *
+ * Every constraint is a handful of one-dimensional rows along world axes, solved for a target
+ * relative velocity that also removes a share of the position error (Baumgarte). Before
+ * solving, constraints are greedily colored so that no two constraints of one color share a
+ * dynamic body; each color can then be solved across worker threads without atomics, with one
+ * join between colors. Constraints that find no free color among the first MAX_COLORS are
+ * solved serially after the colored ones.
+ *
+ * Bodies without rotation make joints purely linear: a point constraint pins two anchors
+ * together, an axis limit keeps the anchors' offset along an axis within a range.
+ */
+class ConstraintSolver {
+public:
+    static constexpr uint32_t STATIC_BODY = UINT32_MAX;
+    static constexpr uint32_t NO_ROW = UINT32_MAX;
+    static constexpr uint32_t MAX_COLORS = 64;
+
+    struct Settings {
+        uint32_t iterations = 8;
+        float baumgarte = 0.2f;                // Share of the position error removed per step
+        float slop = 0.01f;                    // Penetration contacts leave in place
+        float restitution = 0.2f;
+        float restitutionThreshold = 1.0f;     // Slower approaches do not bounce
+        uint32_t parallelThreshold = 256;      // Constraints in a color before it goes wide
+    };
+
+    struct Stats {
+        uint32_t bodies = 0;
+        uint32_t constraints = 0;
+        uint32_t rows = 0;
+        uint32_t colors = 0;
+        uint32_t serialConstraints = 0;        // Left over once the colors ran out
+    };
+
+    ConstraintSolver();
+    explicit ConstraintSolver(const Settings& settings);
+
+    ConstraintSolver(const ConstraintSolver&) = delete;
+    ConstraintSolver& operator=(const ConstraintSolver&) = delete;
+
+    // Drops last step's bodies and constraints
+    void Begin(float deltaTime);
+
+    // Returns the body's index; bodies with no mass may also simply be passed as STATIC_BODY
+    uint32_t AddBody(const DirectX::XMFLOAT3& velocity, float inverseMass);
+
+    // normal points from a to b; depth is the current penetration. Returns the contact's row for
+    // GetImpulse(), or NO_ROW if neither body can move
+    uint32_t AddContact(uint32_t a, uint32_t b, const DirectX::XMFLOAT3& normal, float depth);
+    // Pulls the world-space anchors of a and b together
+    void AddPointJoint(uint32_t a, uint32_t b, const DirectX::XMFLOAT3& anchorA, const DirectX::XMFLOAT3& anchorB);
+    // Keeps the anchors' offset along each unit axis within [minimum, maximum]; equal bounds
+    // lock the axis, minimum > maximum leaves it free
+    void AddAxisJoint(uint32_t a, uint32_t b, const DirectX::XMFLOAT3& anchorA, const DirectX::XMFLOAT3& anchorB,
+                      const DirectX::XMFLOAT3* axes, const float* minimum, const float* maximum, uint32_t axisCount);
+
+    void Solve(JobSystem* jobs);
+
+    const DirectX::XMFLOAT3& GetVelocity(uint32_t body) const { return bodies_[body].velocity; }
+    // Total impulse a row applied over the last Solve()
+    float GetImpulse(uint32_t row) const { return rows_[row].impulse; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    struct Body {
+        DirectX::XMFLOAT3 velocity;
+        float inverseMass;
+    };
+
+    // Target: velocity of b relative to a along axis reaches bias, impulse held within [lower, upper]
+    struct Row {
+        DirectX::XMFLOAT3 axis;
+        float bias;
+        float effectiveMass;
+        float lower;
+        float upper;
+        float impulse;
+    };
+
+    struct Constraint {
+        uint32_t a;
+        uint32_t b;
+        uint32_t firstRow;
+        uint32_t rowCount;
+    };
+
+    // error is the current position error along axis; minimumBias keeps a bounce the error
+    // correction alone would not ask for
+    void AddRow(Constraint& constraint, const DirectX::XMFLOAT3& axis, float error, float lower, float upper,
+                float minimumBias);
+    void Color();
+    void SolveConstraint(const Constraint& constraint);
+
+    Settings settings_;
+    float deltaTime_;
+    std::vector<Body> bodies_;
+    std::vector<Row> rows_;
+    std::vector<Constraint> constraints_;
+
+    std::vector<uint64_t> bodyColors_;         // Colors used by each body's constraints, one bit each
+    std::vector<std::vector<uint32_t>> colors_;
+    std::vector<uint32_t> serial_;
+    Stats stats_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "AISystem.h"
+#include "AISpatialGrid.h"
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+class NavMesh;
+class JobSystem;
+struct NavMeshSettings;
+
+struct CoverBakeSettings {
+    float spacing = 1.5f;                      // Between cover points along a wall
+    float wallOffset = 0.5f;                   // Points stand this far in from the navmesh border
+    float shieldDistance = 2.0f;               // Geometry further away along a ray gives no cover
+    float crouchHeight = 1.0f;                 // Above the navmesh; blocked here is protection
+    float standHeight = 1.7f;                  // Blocked here too is concealment
+    float wallHeight = 3.0f;                   // Of navmesh borders standing in for missing geometry
+};
+
+/**
+ * Cover points baked from a navmesh and level geometry.
+ *
+ * Candidates are spaced along the navmesh border edges, where walkable ground meets walls and
+ * ledges, and set wallOffset in from them. Around each, the horizontal is split into SECTOR_COUNT
+ * sectors and three rays per sector are cast at crouch and standing height against the level
+ * triangles. A sector whose rays all hit within shieldDistance protects, or also conceals, from
+ * threats in that direction. Candidates protected from nowhere, on ledges or open ground, are
+ * dropped. Without level geometry the border edges are taken as walls of wallHeight.
+ *
+ * The result is two bitmasks per point, so asking whether a point is safe from a threat at
+ * runtime is one sector lookup instead of raycasts. Bake at import with BuildCache(); Load()
+ * reads the .ncov back. Immutable once built and safe to query from any thread.
+ */
+class CoverMap {
+public:
+    static constexpr uint32_t MAGIC = 0x564F434E;   // "NCOV"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t SECTOR_COUNT = 32;
+    static constexpr uint32_t INVALID_POINT = ~0u;
+
+    struct Sectors {
+        uint32_t protection;                   // Bit s: shielded crouching from sector s
+        uint32_t concealment;                  // Bit s: hidden standing from sector s
+    };
+
+    CoverMap();
+
+    // positions and indices are the level's triangle list and may be null. Cover points are tested
+    // in parallel over jobs when given
+    bool Build(const NavMesh& navMesh, const DirectX::XMFLOAT3* positions, size_t vertexCount, const uint32_t* indices,
+               size_t indexCount, const CoverBakeSettings& settings, JobSystem* jobs = nullptr);
+    void Clear();
+
+    bool Save(const std::string& filename) const;
+    bool Load(const std::string& filename);
+    // level.obj -> level.obj.ncov
+    static std::string GetCachePath(const std::string& sourceFile);
+    // Imports the source and writes its cover unless the cache is already current. Uses the
+    // level's baked navmesh when there is one
+    static bool BuildCache(const std::string& sourceFile, const NavMeshSettings& navMeshSettings,
+                           const CoverBakeSettings& settings);
+
+    // Sector of a horizontal direction
+    static uint32_t GetSector(const DirectX::XMFLOAT3& direction);
+    // Whether point shields from threats in direction, pointing from the point towards them
+    bool IsProtected(uint32_t point, const DirectX::XMFLOAT3& direction) const {
+        return (sectors_[point].protection >> GetSector(direction)) & 1u;
+    }
+    bool IsConcealed(uint32_t point, const DirectX::XMFLOAT3& direction) const {
+        return (sectors_[point].concealment >> GetSector(direction)) & 1u;
+    }
+    bool IsProtectedFrom(uint32_t point, const DirectX::XMFLOAT3& threatPosition) const;
+
+    // Points within radius of position, nearest first; results is cleared first
+    size_t FindPoints(const DirectX::XMFLOAT3& position, float radius, std::vector<uint32_t>& results) const;
+    // Nearest point within radius protected from threats in direction; INVALID_POINT when none
+    uint32_t FindNearestProtected(const DirectX::XMFLOAT3& position, float radius,
+                                  const DirectX::XMFLOAT3& direction) const;
+
+    size_t GetPointCount() const { return points_.size(); }
+    const AICoverPoint& GetPoint(uint32_t point) const { return points_[point]; }
+    const std::vector<AICoverPoint>& GetPoints() const { return points_; }
+    const Sectors& GetSectors(uint32_t point) const { return sectors_[point]; }
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t pointCount;
+    };
+
+    struct FilePoint {
+        DirectX::XMFLOAT3 position;
+        DirectX::XMFLOAT3 normal;
+        Sectors sectors;
+    };
+
+    void AddPoint(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const Sectors& sectors);
+
+    std::vector<AICoverPoint> points_;         // normal points away from the wall
+    std::vector<Sectors> sectors_;
+    AISpatialGrid grid_;                       // Item i is points_[i]
+};
+
+} // namespace Nexus
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "AISpatialGrid.h"
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+struct CrowdAgent {
+    DirectX::XMFLOAT2 position;                // On the ground plane, x and z
+    DirectX::XMFLOAT2 velocity;                // Last frame's
+    DirectX::XMFLOAT2 preferredVelocity;       // Where its path or flow field wants it to go
+    float radius;
+    float maxSpeed;
+};
+
+struct CrowdSettings {
+    float timeHorizon = 2.0f;                  // Seconds ahead other agents are avoided
+    float neighborDistance = 6.0f;
+    uint32_t maxNeighbors = 10;                // Nearest considered, up to CrowdAvoidance::MAX_NEIGHBORS
+};
+
+/**
+ * Local avoidance with optimal reciprocal collision avoidance (ORCA).
+ *
+ * Every agent takes its nearest neighbours from a spatial grid rebuilt each solve. Each neighbour
+ * turns into a half-plane of velocities that avoid it for timeHorizon seconds, each agent taking
+ * half the responsibility. The half-planes are built four neighbours at a time with SSE, and the
+ * velocity closest to the preferred one that satisfies them all is found with the incremental 2D
+ * linear programs of RVO2; when the constraints can't all hold, the velocity violating them least
+ * is taken instead. Agents solve independently, in parallel over the job system.
+ */
+class CrowdAvoidance {
+public:
+    static constexpr uint32_t MAX_NEIGHBORS = 16;
+
+    CrowdAvoidance();
+
+    void SetSettings(const CrowdSettings& settings) { settings_ = settings; }
+    const CrowdSettings& GetSettings() const { return settings_; }
+
+    // velocities[i] receives agent i's new velocity. deltaTime bounds how fast agents already
+    // overlapping push apart
+    void Solve(const std::vector<CrowdAgent>& agents, float deltaTime, std::vector<DirectX::XMFLOAT2>& velocities,
+               JobSystem* jobs = nullptr);
+
+private:
+    void SolveAgent(const std::vector<CrowdAgent>& agents, uint32_t agent, float deltaTime,
+                    DirectX::XMFLOAT2& velocity) const;
+
+    CrowdSettings settings_;
+    AISpatialGrid grid_;
+};
+
+} // namespace Nexus
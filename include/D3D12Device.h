@@ -0,0 +1,234 @@
+#pragma once
+
+#include "Platform.h"
+#include <d3d12.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct IDXGISwapChain3;
+
+namespace Nexus {
+
+class JobSystem;
+
+/**
+ * Direct3D 12 device, direct queue and swap chain: the backend GraphicsDevice runs on when asked
+ * for D3D12, and the device RayTracingEngine shares.
+ *
+ * Resources are bindless. Every shader resource, unordered access and constant buffer view lives
+ * in one shader-visible heap and every sampler in another, both bound on each command list the
+ * device hands out, and the shared root signature indexes them directly (ResourceDescriptorHeap[]
+ * in shader model 6.6), so passes pass descriptor indices in root constants instead of building
+ * tables. Render target and depth views come from CPU-only heaps.
+ *
+ * Resources are placed in large heaps and suballocated first-fit, one heap list per heap type
+ * and resource class, instead of one committed allocation each; resources bigger than a quarter
+ * heap stay committed.
+ *
+ * Command lists come from per-frame pools with an allocator each, so any number can be recorded
+ * at once on different threads. RecordParallel() splits work across the job system and submits
+ * the lists in order in one ExecuteCommandLists.
+ *
+ * A second, compute-only queue runs work alongside the graphics queue where the driver exposes
+ * one; Signal() and Wait() order the two on the GPU. Present() makes the graphics queue wait for
+ * whatever was submitted to the compute queue, so the frame fence covers both.
+ *
+ * Released resources and freed descriptors are kept until the GPU finishes the frames that may
+ * still use them. Nothing here tracks resource states; the render graph generates the barriers
+ * for what it owns and callers issue their own for the rest.
+ */
+class D3D12Device {
+public:
+    static constexpr UINT FRAMES_IN_FLIGHT = 2;
+    static constexpr UINT BACK_BUFFER_COUNT = 2;
+    static constexpr UINT BINDLESS_DESCRIPTORS = 65536;   // Shader resource, unordered access and constant buffer views
+    static constexpr UINT BINDLESS_SAMPLERS = 2048;       // The most a shader-visible sampler heap may hold
+    static constexpr UINT TARGET_DESCRIPTORS = 4096;      // Render target and, separately, depth views
+    static constexpr UINT ROOT_CONSTANTS = 16;            // 32-bit values at b0, typically descriptor indices
+    static constexpr UINT64 HEAP_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+    enum class QueueType { Graphics, Compute };
+
+    using DescriptorIndex = uint32_t;
+    static constexpr DescriptorIndex INVALID_DESCRIPTOR = UINT32_MAX;
+
+    // Root parameters of the bindless root signature, graphics and compute alike
+    enum RootParameter : UINT {
+        ROOT_PARAMETER_CONSTANTS = 0,   // ROOT_CONSTANTS values at b0
+        ROOT_PARAMETER_CONSTANT_BUFFER  // A constant buffer address at b1
+    };
+
+    struct MemoryStats {
+        uint32_t heaps = 0;
+        uint64_t heapBytes = 0;         // Reserved by placed heaps
+        uint64_t placedBytes = 0;       // Of those, in use by resources
+        uint32_t placedResources = 0;
+        uint32_t committedResources = 0;
+        uint64_t committedBytes = 0;
+    };
+
+    D3D12Device();
+    ~D3D12Device();
+
+    D3D12Device(const D3D12Device&) = delete;
+    D3D12Device& operator=(const D3D12Device&) = delete;
+
+    // False where the adapter lacks resource binding tier 3 or shader model 6.6, which bindless
+    // indexing needs
+    bool Initialize(HWND hwnd, int width, int height, bool fullscreen);
+    void Shutdown();
+
+    ID3D12Device5* GetDevice() const { return device_; }
+    ID3D12CommandQueue* GetQueue() const { return queue_; }
+    // Null when no compute queue could be created; compute lists then go to the graphics queue
+    ID3D12CommandQueue* GetComputeQueue() const { return computeQueue_; }
+    bool HasAsyncCompute() const { return computeQueue_ != nullptr; }
+    IDXGISwapChain3* GetSwapChain() const { return swapChain_; }
+    UINT GetSwapChainFlags() const { return swapChainFlags_; }
+    bool IsTearingSupported() const { return tearingSupported_; }
+    UINT GetBackBufferIndex() const;
+    ID3D12Resource* GetBackBuffer(UINT index) const { return backBuffers_[index]; }
+    D3D12_CPU_DESCRIPTOR_HANDLE GetBackBufferView(UINT index) const;
+    // Waits for the GPU and recreates the back buffers; nothing else may reference them
+    bool ResizeSwapChain(int width, int height);
+
+    // Waits until the GPU is done with the frame that last used this frame's slot, then recycles
+    // its command lists, released resources and freed descriptors
+    void BeginFrame();
+    // Presents and fences the frame; the result is the swap chain's
+    HRESULT Present(UINT syncInterval, UINT flags);
+    void WaitForIdle();
+    // Counts frames from 1; the GPU has finished frame n once GetCompletedFrame() >= n
+    uint64_t GetFrame() const { return frame_; }
+    uint64_t GetCompletedFrame() const;
+
+    // A list from this frame's pool, open, with the bindless heaps and root signature set.
+    // Thread-safe
+    ID3D12GraphicsCommandList4* BeginCommandList(QueueType queue = QueueType::Graphics);
+    // Closes and executes lists in order; lists must come from the same queue type
+    void Submit(ID3D12GraphicsCommandList4* const* lists, UINT count, QueueType queue = QueueType::Graphics);
+    // Cross-queue ordering: Signal() returns the value queue's sync fence reaches once what was
+    // submitted to it so far is done, and Wait() holds queue's later work until producer's fence
+    // reaches value. GPU-side; the CPU does not block
+    uint64_t Signal(QueueType queue);
+    void Wait(QueueType queue, QueueType producer, uint64_t value);
+    // Calls record(list, i) for i below count, spread over jobs when given, then submits the
+    // lists in index order. record runs concurrently and must only touch its own list
+    void RecordParallel(JobSystem* jobs, UINT count,
+                        const std::function<void(ID3D12GraphicsCommandList4*, UINT)>& record);
+
+    // Bindless views, by index into the shader-visible heaps. Thread-safe; freeing is deferred
+    // until the GPU is done with the current frame
+    ID3D12RootSignature* GetBindlessRootSignature() const { return rootSignature_; }
+    DescriptorIndex CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc);
+    DescriptorIndex CreateUnorderedAccessView(ID3D12Resource* resource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc);
+    DescriptorIndex CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc);
+    DescriptorIndex CreateSampler(const D3D12_SAMPLER_DESC& desc);
+    void FreeDescriptor(DescriptorIndex index);
+    void FreeSampler(DescriptorIndex index);
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGpuDescriptor(DescriptorIndex index) const;
+
+    // CPU-only render target and depth views, freed the same deferred way
+    DescriptorIndex CreateRenderTargetView(ID3D12Resource* resource, const D3D12_RENDER_TARGET_VIEW_DESC* desc);
+    DescriptorIndex CreateDepthStencilView(ID3D12Resource* resource, const D3D12_DEPTH_STENCIL_VIEW_DESC* desc);
+    void FreeRenderTargetView(DescriptorIndex index);
+    void FreeDepthStencilView(DescriptorIndex index);
+    D3D12_CPU_DESCRIPTOR_HANDLE GetRenderTargetHandle(DescriptorIndex index) const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetDepthStencilHandle(DescriptorIndex index) const;
+
+    // A resource placed in a shared heap, or committed when too big for one. Release it with
+    // ReleaseResource, never Release(). Thread-safe
+    ID3D12Resource* CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+                                   const D3D12_CLEAR_VALUE* clearValue = nullptr,
+                                   D3D12_HEAP_TYPE heapType = D3D12_HEAP_TYPE_DEFAULT);
+    // Frees the resource and its heap range once the GPU is done with the current frame
+    void ReleaseResource(ID3D12Resource* resource);
+    MemoryStats GetMemoryStats() const;
+
+private:
+    // Which resources a placed heap may hold; heap tier 1 hardware keeps them apart
+    enum class HeapClass { Buffers, Textures, TargetTextures, Count };
+
+    struct DescriptorHeap {
+        ID3D12DescriptorHeap* heap = nullptr;
+        UINT increment = 0;
+        UINT capacity = 0;
+        UINT next = 0;                              // Never used above this
+        std::vector<DescriptorIndex> free;
+        std::vector<std::pair<uint64_t, DescriptorIndex>> retired;   // Frame freed, index
+    };
+
+    struct HeapBlock {
+        ID3D12Heap* heap = nullptr;
+        D3D12_HEAP_TYPE type = D3D12_HEAP_TYPE_DEFAULT;
+        HeapClass heapClass = HeapClass::Buffers;
+        std::map<UINT64, UINT64> free;              // Offset to size, coalesced
+        UINT64 used = 0;
+    };
+
+    struct Placement {
+        uint32_t block = UINT32_MAX;                // UINT32_MAX for a committed resource
+        UINT64 offset = 0;
+        UINT64 size = 0;
+    };
+
+    struct CommandList {
+        ID3D12CommandAllocator* allocator = nullptr;
+        ID3D12GraphicsCommandList4* list = nullptr;
+    };
+
+    struct FrameSlot {
+        std::vector<CommandList> lists[2];          // Per queue type
+        size_t used[2] = {};                        // Lists handed out this frame
+        uint64_t fence = 0;                         // Signaled when the slot's last frame finished
+    };
+
+    bool CreateDevice();
+    bool CreateSwapChain(HWND hwnd, int width, int height, bool fullscreen);
+    bool CreateBackBufferViews();
+    void ReleaseBackBuffers();
+    bool CreateDescriptorHeap(DescriptorHeap& heap, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT capacity, bool shaderVisible);
+    bool CreateRootSignature();
+    DescriptorIndex AllocateDescriptor(DescriptorHeap& heap);
+    void FreeDescriptor(DescriptorHeap& heap, DescriptorIndex index);
+    void RecycleDescriptors(DescriptorHeap& heap, uint64_t completed, bool all);
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(const DescriptorHeap& heap, DescriptorIndex index) const;
+    bool Place(const D3D12_RESOURCE_ALLOCATION_INFO& info, D3D12_HEAP_TYPE type, HeapClass heapClass, Placement& placement);
+    void Unplace(const Placement& placement);
+    void ReleaseRetired(uint64_t completed, bool all);
+
+    ID3D12Device5* device_;
+    ID3D12CommandQueue* queue_;
+    ID3D12CommandQueue* computeQueue_;
+    IDXGISwapChain3* swapChain_;
+    UINT swapChainFlags_;
+    bool tearingSupported_;
+    ID3D12Resource* backBuffers_[BACK_BUFFER_COUNT];
+    DescriptorIndex backBufferViews_[BACK_BUFFER_COUNT];
+    ID3D12RootSignature* rootSignature_;
+
+    ID3D12Fence* fence_;
+    HANDLE fenceEvent_;
+    uint64_t frame_;
+    FrameSlot slots_[FRAMES_IN_FLIGHT];
+    ID3D12Fence* syncFences_[2];                    // Per queue type, for Signal() and Wait()
+    uint64_t syncValues_[2];
+    bool computeSubmitted_;                         // This frame, so Present() must wait for it
+
+    // Guards the descriptor heaps, placed heaps, retired lists and command list pools
+    mutable std::mutex mutex_;
+    DescriptorHeap resourceHeap_;
+    DescriptorHeap samplerHeap_;
+    DescriptorHeap targetHeap_;
+    DescriptorHeap depthHeap_;
+    std::vector<HeapBlock> blocks_;
+    std::unordered_map<ID3D12Resource*, Placement> placements_;
+    std::vector<std::pair<uint64_t, ID3D12Resource*>> retired_;   // Frame released, resource
+    uint64_t committedBytes_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Platform.h"
+#include "ClusteredLightCuller.h"
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+class StateCache;
+class Texture;
+
+/**
+ * Clustered deferred decals: bullet holes, blood and level decals applied while surfaces shade,
+ * instead of one projected box draw each.
+ *
+ * A decal is an oriented box. Its local xy plane maps to the texture and it projects along local
+ * z, fading out on surfaces that turn away from +z. Build() bins every decal's bounding sphere
+ * into the clusters of the ClusteredLightCuller, so a pixel only tests the decals of its own
+ * cluster, and uploads the decals, the (offset, count) ranges and the packed index list. Bind()
+ * exposes them with the texture array to PBR_PS.hlsl and GBuffer_PS.hlsl, which blend every
+ * decal covering the pixel into albedo and roughness before lighting; the cluster lookup uses the
+ * culler's constants, so both must be built for the same camera.
+ *
+ * Decal textures are layers of one texture array, added with AddLayer(). The first layer fixes
+ * its size, format and mip count, and later ones must match. A decal may also pick a sub-rectangle
+ * of its layer, so one layer can hold a sheet of variations.
+ *
+ * Decals with a lifetime fade out over their last fadeTime seconds and are removed; permanent
+ * ones (lifetime 0) stay until removed, as imported level decals do. Once the system is full the
+ * transient decal closest to expiring makes way for a new one; when all are permanent the new
+ * one is refused.
+ */
+class DecalSystem {
+public:
+    static constexpr UINT MAX_DECALS = 8192;
+    static constexpr UINT MAX_LAYERS = 64;
+
+    // Pixel shader slots, past the light lists and the probe and lightmap textures
+    static constexpr UINT DECAL_SLOT = 15;    // t15 decals, t16 cluster ranges, t17 decal indices, t18 textures
+
+    using DecalId = uint32_t;
+    static constexpr DecalId INVALID_DECAL = 0;
+
+    struct Decal {
+        DirectX::XMFLOAT3 position = { 0.0f, 0.0f, 0.0f };
+        DirectX::XMFLOAT4 rotation = { 0.0f, 0.0f, 0.0f, 1.0f };   // Quaternion; local +z faces away from the surface
+        DirectX::XMFLOAT3 halfExtents = { 0.5f, 0.5f, 0.25f };      // z is the projection depth either side
+        UINT layer = 0;
+        DirectX::XMFLOAT4 uvRect = { 0.0f, 0.0f, 1.0f, 1.0f };      // Offset and scale within the layer
+        DirectX::XMFLOAT4 color = { 1.0f, 1.0f, 1.0f, 1.0f };       // Tints the texture; alpha scales its coverage
+        float roughness = -1.0f;                                    // Blended in by coverage; negative keeps the surface's
+        float lifetime = 0.0f;                                      // Seconds; 0 is permanent
+        float fadeTime = 1.0f;                                      // Fades out over the end of the lifetime
+    };
+
+    struct Stats {
+        uint32_t decals = 0;             // Binned this frame
+        uint32_t indices = 0;            // Total decal references across all clusters
+        uint32_t maxClusterDecals = 0;
+        uint32_t droppedReferences = 0;  // Lost to the per-cluster limit
+        uint32_t recycled = 0;           // Transient decals replaced early since Initialize()
+    };
+
+    DecalSystem();
+    ~DecalSystem();
+
+    DecalSystem(const DecalSystem&) = delete;
+    DecalSystem& operator=(const DecalSystem&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+    void Shutdown();
+
+    // Copies the texture's mips into the next layer of the array and returns its index, or -1 when
+    // it does not match the first layer, is not loaded yet or the array is full
+    int AddLayer(const Texture& texture);
+    UINT GetLayerCount() const { return layerCount_; }
+
+    DecalId AddDecal(const Decal& decal);
+    void RemoveDecal(DecalId id);
+    void ClearDecals();
+    size_t GetDecalCount() const { return decals_.size(); }
+
+    // Decals past this limit in one cluster are dropped and counted in Stats
+    void SetMaxDecalsPerCluster(UINT maxDecals);
+    UINT GetMaxDecalsPerCluster() const { return maxDecalsPerCluster_; }
+
+    // Ages decals and removes expired ones
+    void Update(float deltaTime);
+    // view must be the camera lights was last built for
+    void Build(const ClusteredLightCuller& lights, DirectX::FXMMATRIX view, JobSystem* jobs = nullptr);
+    void Bind(StateCache& stateCache) const;
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    // Matches ClusterDecal in PBR_PS.hlsl and GBuffer_PS.hlsl
+    struct GpuDecal {
+        DirectX::XMFLOAT4 worldToDecal[3];   // Rows of the affine map into the [-1, 1] box
+        DirectX::XMFLOAT3 axis;              // World-space local +z
+        float layer;
+        DirectX::XMFLOAT4 uvRect;
+        DirectX::XMFLOAT4 color;             // Alpha includes the fade
+        float roughness;
+        float padding[3];
+    };
+
+    struct Entry {
+        DecalId id;
+        Decal decal;
+        float age;
+    };
+
+    bool EnsureIndexCapacity(UINT indexCount);
+    void Upload();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+
+    ID3D11Buffer* decalBuffer_;
+    ID3D11ShaderResourceView* decalView_;
+    ID3D11Buffer* rangeBuffer_;
+    ID3D11ShaderResourceView* rangeView_;
+    ID3D11Buffer* indexBuffer_;
+    ID3D11ShaderResourceView* indexView_;
+    UINT indexCapacity_;
+    ID3D11Texture2D* textures_;
+    ID3D11ShaderResourceView* texturesView_;
+    UINT layerCount_;
+
+    std::vector<Entry> decals_;                // In id order
+    DecalId nextId_;
+    UINT maxDecalsPerCluster_;
+
+    // CPU copies of everything Upload() writes
+    std::vector<GpuDecal> gpuDecals_;
+    std::vector<DirectX::XMFLOAT4> spheres_;   // View-space bounds of gpuDecals_
+    ClusteredLightCuller::ClusterLists lists_;
+
+    Stats stats_;
+};
+
+} // namespace Nexus
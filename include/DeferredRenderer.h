@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace Nexus {
+
+class ClusteredLightCuller;
+class ProbeVolume;
+class StateCache;
+
+/**
+ * Compact G-buffer and tiled compute-shader lighting for the deferred path.
+ *
+ * Three 32-bit targets plus depth, 16 bytes a pixel:
+ *   0  RGBA8 sRGB    albedo, ambient occlusion
+ *   1  RG16 snorm    world normal, octahedral encoded
+ *   2  RGBA8         roughness, metalness, material ID / 255, emissive scale
+ *   D  D32           positions are rebuilt from depth and the inverse projection
+ * Geometry writes them with GBuffer_PS.hlsl, which blends the DecalSystem's decals in first.
+ * Render() then lights 16x16 pixel tiles in one dispatch: each thread reads its pixel's G-buffer
+ * once, the tile's depth range and screen bounds cull the point and spot lights of the
+ * ClusteredLightCuller into a shared list, and every pixel shades that list with the same BRDF
+ * as PBR_PS. Sky pixels (cleared depth) are left untouched in the output.
+ */
+class DeferredRenderer {
+public:
+    static constexpr UINT TILE_SIZE = 16;
+    static constexpr UINT MAX_TILE_LIGHTS = 256;
+    static constexpr UINT TARGET_COUNT = 3;
+    // Emissive is stored as a multiple of albedo; scale 1 in the target means this much
+    static constexpr float EMISSIVE_RANGE = 16.0f;
+
+    DeferredRenderer();
+    ~DeferredRenderer();
+
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height);
+    void Shutdown();
+
+    // Clears the targets and binds them with the G-buffer depth; opaque geometry follows
+    void BeginGeometryPass(StateCache& stateCache);
+
+    // Lights the G-buffer into output, a UAV of an RGBA8 or float target of the same size, with
+    // the lights lights was last built with (view and projection must be the same camera).
+    // occlusion is optional full-resolution visibility (SSAORenderer). shadingRate is an optional
+    // ShadingRateImage of the same size, whose 16x16 tiles match these; coarse tiles light one
+    // pixel per block. probes, when given, replace ambientLight with their irradiance. reflections
+    // is optional full-resolution reflected radiance (ScreenSpaceReflections), added weighted by
+    // the environment BRDF. The G-buffer and depth must no longer be bound as targets
+    void Render(const ClusteredLightCuller* lights, ID3D11ShaderResourceView* occlusion,
+                DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection,
+                const DirectX::XMFLOAT3& ambientLight, float gamma, ID3D11UnorderedAccessView* output,
+                ID3D11ShaderResourceView* shadingRate = nullptr, const ProbeVolume* probes = nullptr,
+                ID3D11ShaderResourceView* reflections = nullptr);
+
+    // Depth as R32_FLOAT for SSAO and other screen-space passes, and as depth target
+    ID3D11ShaderResourceView* GetDepthView() const { return depthView_; }
+    ID3D11DepthStencilView* GetDepthTarget() const { return depthTarget_; }
+    ID3D11ShaderResourceView* GetTargetView(UINT index) const { return index < TARGET_COUNT ? views_[index] : nullptr; }
+    UINT GetWidth() const { return width_; }
+    UINT GetHeight() const { return height_; }
+
+private:
+    bool CreateTargets();
+    bool CreateShader();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    UINT width_;
+    UINT height_;
+
+    ID3D11Texture2D* targets_[TARGET_COUNT];
+    ID3D11RenderTargetView* targetViews_[TARGET_COUNT];
+    ID3D11ShaderResourceView* views_[TARGET_COUNT];
+    ID3D11Texture2D* depth_;
+    ID3D11DepthStencilView* depthTarget_;
+    ID3D11ShaderResourceView* depthView_;
+
+    ID3D11ComputeShader* lightingShader_;
+    ID3D11Buffer* constants_;
+};
+
+} // namespace Nexus
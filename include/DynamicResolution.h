@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+
+namespace Nexus {
+
+class StateCache;
+
+/**
+ * Render scale controller and upscaler for dynamic resolution.
+ *
+ * The scene renders into the top-left corner of a scene target allocated once at output size;
+ * only the viewport shrinks, so changing the scale never reallocates. A PID controller steers
+ * the rendered area towards the target GPU frame time (cost is taken as proportional to pixel
+ * count, so the controller works on scale squared). Upscale() then draws the scaled image to the
+ * output with a Catmull-Rom filter clamped to the nearest source texels, which keeps edges sharp
+ * without ringing, followed by contrast-adaptive sharpening.
+ */
+class DynamicResolution {
+public:
+    struct Settings {
+        float minScale = 0.5f;          // Per axis
+        float maxScale = 1.0f;          // Per axis, at most 1
+        float targetFrameMs = 15.0f;    // GPU time to hold, keep some headroom below vsync
+        float proportionalGain = 0.5f;
+        float integralGain = 0.1f;
+        float derivativeGain = 0.1f;
+        float scaleStep = 0.025f;       // Scale changes snap to this so it does not creep every frame
+        float sharpness = 0.5f;         // 0 disables the sharpening after the upscale
+    };
+
+    DynamicResolution();
+    ~DynamicResolution();
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // width and height are the output size
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                    UINT width, UINT height, const Settings& settings);
+    void Shutdown();
+
+    void SetSettings(const Settings& settings);
+    const Settings& GetSettings() const { return settings_; }
+
+    // Feeds the GPU time of the most recently finished frame. frameId identifies that frame;
+    // repeats of an already seen frame are ignored so late readbacks are not counted twice
+    void Update(float gpuFrameMs, uint64_t frameId);
+    float GetScale() const { return scale_; }
+    UINT GetRenderWidth() const { return renderWidth_; }
+    UINT GetRenderHeight() const { return renderHeight_; }
+
+    // Output-sized target; the scene covers GetRenderWidth() x GetRenderHeight() of it
+    ID3D11RenderTargetView* GetSceneTarget() const { return sceneTarget_; }
+    ID3D11ShaderResourceView* GetSceneView() const { return sceneView_; }
+
+    // Draws the rendered region to target at output size and leaves target bound without depth
+    void Upscale(ID3D11RenderTargetView* target);
+
+private:
+    bool CreateResources();
+    bool CreateShaders();
+    void ApplyScale(float scale);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    StateCache* stateCache_;
+    Settings settings_;
+    UINT width_;
+    UINT height_;
+
+    ID3D11Texture2D* sceneTexture_;
+    ID3D11RenderTargetView* sceneTarget_;
+    ID3D11ShaderResourceView* sceneView_;
+    ID3D11VertexShader* fullscreenShader_;
+    ID3D11PixelShader* upscaleShader_;
+    ID3D11Buffer* constants_;
+    ID3D11SamplerState* linearClamp_;
+    ID3D11RasterizerState* rasterizerState_;
+    ID3D11DepthStencilState* depthState_;
+
+    // Controller state
+    float scale_;
+    float integral_;
+    float previousError_;
+    uint64_t lastFrameId_;
+    UINT renderWidth_;
+    UINT renderHeight_;
+};
+
+} // namespace Nexus
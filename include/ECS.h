@@ -0,0 +1,301 @@
+#pragma once
+
+#include "JobSystem.h"
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Nexus {
+
+using ComponentTypeID = uint32_t;
+
+constexpr size_t ECS_MAX_COMPONENTS = 64;
+constexpr size_t ECS_CHUNK_SIZE = 16 * 1024;
+constexpr size_t ECS_CACHE_LINE = 64;
+
+using ComponentMask = std::bitset<ECS_MAX_COMPONENTS>;
+
+/**
+ * Entity handle: slot index plus generation, so stale handles to a recycled slot are rejected
+ */
+struct Entity {
+    uint32_t index = 0xFFFFFFFFu;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != 0xFFFFFFFFu; }
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+/**
+ * Type-erased description of a component type, filled in on first use
+ */
+struct ComponentInfo {
+    const char* name = nullptr;
+    size_t size = 0;
+    size_t alignment = 0;
+    void (*moveConstruct)(void* dst, void* src) = nullptr;
+    void (*destruct)(void* ptr) = nullptr;
+};
+
+class ComponentRegistry {
+public:
+    template<typename T>
+    static ComponentTypeID GetID() {
+        static const ComponentTypeID id = Register(MakeInfo<T>());
+        return id;
+    }
+
+    static const ComponentInfo& GetInfo(ComponentTypeID id);
+    static size_t GetCount();
+
+private:
+    template<typename T>
+    static ComponentInfo MakeInfo() {
+        static_assert(std::is_move_constructible<T>::value, "ECS components must be move constructible");
+        ComponentInfo info;
+        info.name = typeid(T).name();
+        info.size = sizeof(T);
+        info.alignment = alignof(T);
+        info.moveConstruct = [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); };
+        info.destruct = [](void* ptr) { static_cast<T*>(ptr)->~T(); };
+        return info;
+    }
+
+    static ComponentTypeID Register(const ComponentInfo& info);
+};
+
+/**
+ * All entities sharing one exact component set.
+ *
+ * Entities live in fixed-size chunks (ECS_CHUNK_SIZE, cache-line aligned). Inside a chunk each
+ * component type has its own contiguous, cache-line aligned array (structure of arrays),
+ * so a system touching two components streams through exactly two arrays.
+ */
+class Archetype {
+public:
+    explicit Archetype(const ComponentMask& mask);
+    ~Archetype();
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    const ComponentMask& GetMask() const { return mask_; }
+    size_t GetChunkCapacity() const { return chunkCapacity_; }
+    size_t GetChunkCount() const { return chunks_.size(); }
+    size_t GetEntityCount() const { return entityCount_; }
+    size_t GetChunkEntityCount(size_t chunk) const { return chunks_[chunk].count; }
+
+    Entity* GetEntities(size_t chunk) const { return reinterpret_cast<Entity*>(chunks_[chunk].memory); }
+    void* GetComponentArray(size_t chunk, ComponentTypeID type) const;
+
+    template<typename T>
+    T* GetArray(size_t chunk) const {
+        return static_cast<T*>(GetComponentArray(chunk, ComponentRegistry::GetID<T>()));
+    }
+
+private:
+    friend class World;
+
+    struct Chunk {
+        uint8_t* memory = nullptr;
+        size_t count = 0;
+    };
+
+    struct Column {
+        ComponentTypeID type;
+        size_t offset;
+        size_t size;
+    };
+
+    // Reserves a row for the entity; components at the row are left unconstructed
+    size_t AllocateRow(Entity entity);
+    // Destroys the row and fills the hole with the last entity; returns the entity that moved (if any)
+    Entity RemoveRow(size_t row);
+    void* GetComponent(size_t row, ComponentTypeID type) const;
+    bool HasColumn(ComponentTypeID type) const { return mask_.test(type); }
+
+    ComponentMask mask_;
+    std::vector<Column> columns_;
+    int16_t columnIndex_[ECS_MAX_COMPONENTS];
+    size_t chunkCapacity_;
+    size_t chunkBytes_;
+    std::vector<Chunk> chunks_;
+    size_t entityCount_;
+};
+
+/**
+ * Central entity-component store.
+ *
+ * Structural changes (create, destroy, add/remove component) must happen on one thread and
+ * invalidate component pointers. Iteration over disjoint chunks is safe to run in parallel.
+ */
+class World {
+public:
+    World();
+    ~World();
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // Entity lifecycle
+    template<typename... Ts>
+    Entity CreateEntity(Ts&&... components) {
+        ComponentMask mask;
+        (mask.set(ComponentRegistry::GetID<std::decay_t<Ts>>()), ...);
+
+        Archetype* archetype = GetOrCreateArchetype(mask);
+        Entity entity = AllocateEntity();
+        size_t row = archetype->AllocateRow(entity);
+        (new (archetype->GetComponent(row, ComponentRegistry::GetID<std::decay_t<Ts>>()))
+            std::decay_t<Ts>(std::forward<Ts>(components)), ...);
+
+        EntityRecord& record = records_[entity.index];
+        record.archetype = archetype;
+        record.row = row;
+        return entity;
+    }
+
+    void DestroyEntity(Entity entity);
+    bool IsAlive(Entity entity) const;
+    void Clear();
+
+    // Component access (pointers are valid until the next structural change)
+    template<typename T>
+    T* GetComponent(Entity entity) const {
+        if (!IsAlive(entity)) return nullptr;
+        const EntityRecord& record = records_[entity.index];
+        ComponentTypeID type = ComponentRegistry::GetID<T>();
+        if (!record.archetype->HasColumn(type)) return nullptr;
+        return static_cast<T*>(record.archetype->GetComponent(record.row, type));
+    }
+
+    template<typename T>
+    bool HasComponent(Entity entity) const {
+        return IsAlive(entity) && records_[entity.index].archetype->HasColumn(ComponentRegistry::GetID<T>());
+    }
+
+    template<typename T>
+    T& AddComponent(Entity entity, T component = T()) {
+        ComponentTypeID type = ComponentRegistry::GetID<T>();
+        if (T* existing = GetComponent<T>(entity)) {
+            *existing = std::move(component);
+            return *existing;
+        }
+
+        ComponentMask mask = records_[entity.index].archetype->GetMask();
+        mask.set(type);
+        MoveEntity(entity, GetOrCreateArchetype(mask));
+
+        const EntityRecord& record = records_[entity.index];
+        return *new (record.archetype->GetComponent(record.row, type)) T(std::move(component));
+    }
+
+    template<typename T>
+    void RemoveComponent(Entity entity) {
+        if (!HasComponent<T>(entity)) return;
+
+        ComponentMask mask = records_[entity.index].archetype->GetMask();
+        mask.reset(ComponentRegistry::GetID<T>());
+        MoveEntity(entity, GetOrCreateArchetype(mask));
+    }
+
+    // Queries: fn(size_t count, const Entity* entities, Ts* componentArrays...) per matching chunk
+    template<typename... Ts, typename Fn>
+    void ForEachChunk(Fn&& fn) const {
+        ComponentMask required = MakeMask<Ts...>();
+        for (Archetype* archetype : archetypeList_) {
+            if ((archetype->GetMask() & required) != required) continue;
+            for (size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk) {
+                fn(archetype->GetChunkEntityCount(chunk), archetype->GetEntities(chunk),
+                   archetype->GetArray<Ts>(chunk)...);
+            }
+        }
+    }
+
+    // fn(Entity, Ts&...) per matching entity
+    template<typename... Ts, typename Fn>
+    void ForEach(Fn&& fn) const {
+        ForEachChunk<Ts...>([&fn](size_t count, const Entity* entities, Ts*... arrays) {
+            for (size_t i = 0; i < count; ++i) {
+                fn(entities[i], arrays[i]...);
+            }
+        });
+    }
+
+    // Chunk query spread across the job system; fn must only touch the chunk it is given
+    template<typename... Ts, typename Fn>
+    void ParallelForEachChunk(JobSystem& jobs, Fn&& fn) {
+        ComponentMask required = MakeMask<Ts...>();
+        chunkScratch_.clear();
+        for (Archetype* archetype : archetypeList_) {
+            if ((archetype->GetMask() & required) != required) continue;
+            for (size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk) {
+                chunkScratch_.push_back({archetype, chunk});
+            }
+        }
+
+        jobs.ParallelFor(chunkScratch_.size(), 1, [this, &fn](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const ChunkRef& ref = chunkScratch_[i];
+                fn(ref.archetype->GetChunkEntityCount(ref.chunk), ref.archetype->GetEntities(ref.chunk),
+                   ref.archetype->template GetArray<Ts>(ref.chunk)...);
+            }
+        });
+    }
+
+    template<typename... Ts>
+    size_t Count() const {
+        ComponentMask required = MakeMask<Ts...>();
+        size_t count = 0;
+        for (Archetype* archetype : archetypeList_) {
+            if ((archetype->GetMask() & required) == required) {
+                count += archetype->GetEntityCount();
+            }
+        }
+        return count;
+    }
+
+    size_t GetEntityCount() const { return entityCount_; }
+    size_t GetArchetypeCount() const { return archetypeList_.size(); }
+
+private:
+    struct EntityRecord {
+        Archetype* archetype = nullptr;
+        size_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    struct ChunkRef {
+        Archetype* archetype;
+        size_t chunk;
+    };
+
+    template<typename... Ts>
+    static ComponentMask MakeMask() {
+        ComponentMask mask;
+        (mask.set(ComponentRegistry::GetID<Ts>()), ...);
+        return mask;
+    }
+
+    Archetype* GetOrCreateArchetype(const ComponentMask& mask);
+    Entity AllocateEntity();
+    void MoveEntity(Entity entity, Archetype* target);
+    void FixupMovedEntity(Entity moved, size_t row);
+
+    std::vector<EntityRecord> records_;
+    std::vector<uint32_t> freeIndices_;
+    std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypes_;
+    std::vector<Archetype*> archetypeList_;   // Creation order, keeps iteration deterministic
+    std::vector<ChunkRef> chunkScratch_;
+    size_t entityCount_;
+};
+
+} // namespace Nexus
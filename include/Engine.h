@@ -1,12 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 #include <chrono>
+#include <cstdint>
 #include <Windows.h>
+#include <DirectXMath.h>
 
 #include "TextRenderer.h"
+#include "NetTransport.h"
 
 namespace Nexus {
 
@@ -25,6 +30,27 @@ class MotionControlSystem;
 class EngineUI;
 class UISystem;
 class EngineErrorRecovery;
+class JobSystem;
+class FramePacer;
+class TaskGraph;
+class FrameArena;
+class FrameMetrics;
+class FileWatcher;
+class World;
+class TransformHierarchy;
+class RenderPipeline;
+class RenderQueue;
+class SceneBVH;
+class ShaderWarmup;
+class WorldPartition;
+class SceneBenchmark;
+class SessionRecorder;
+class ReplicationServer;
+class ReplicationClient;
+struct AABB;
+struct RenderPacket;
+struct RenderObjectView;
+struct FrameRenderData;
 
 struct InitParams {
     std::string configFile;
@@ -66,20 +92,149 @@ public:
     MotionControlSystem* GetMotionControl() const { return motionControl_.get(); }
     EngineUI* GetUI() const { return ui_.get(); }
     EngineErrorRecovery* GetErrorRecovery() const { return errorRecovery_.get(); }
+    JobSystem* GetJobs() const { return jobs_.get(); }
+    FramePacer* GetFramePacer() const { return framePacer_.get(); }
+    FrameArena* GetFrameArena() const { return frameArena_.get(); }
+    // Rolling frame, CPU, GPU and subsystem times with percentiles and hitch counts
+    FrameMetrics* GetMetrics() const { return metrics_.get(); }
+    World* GetWorld() const { return world_.get(); }
+    // Parent/child transforms of scene nodes, world matrices resolved at the end of Update()
+    TransformHierarchy* GetTransforms() const { return transforms_.get(); }
+    FileWatcher* GetFileWatcher() const { return fileWatcher_.get(); }
+    // Streams the level opened with GetWorldPartition()->Open() around the camera
+    WorldPartition* GetWorldPartition() const { return worldPartition_.get(); }
 
     // Frame control
-    void SetTargetFPS(float fps) { targetFPS_ = fps; }
-    int GetFPS(); // Remove const since method modifies member variables
+    void SetTargetFPS(float fps);
+    // Over the last 60 frames
+    int GetFPS() const;
     float GetDeltaTime() const { return deltaTime_; }
 
+    // Fixed-timestep simulation (physics ticks at a constant rate, rendering interpolates)
+    void SetFixedTimestep(bool enabled, float tickRate = 60.0f);
+    void SetMaxStepsPerFrame(int maxSteps) { maxStepsPerFrame_ = maxSteps > 0 ? maxSteps : 1; }
+    bool IsFixedTimestep() const { return fixedTimestep_; }
+    float GetFixedDeltaTime() const { return fixedDeltaTime_; }
+    float GetInterpolationAlpha() const { return interpolationAlpha_; }
+
+    // Pipelined rendering: a render thread draws frame N while the simulation runs frame N+1.
+    // maxFramesInFlight bounds how far the simulation may run ahead (input-to-display latency).
+    // Takes effect on the next Run()
+    void SetPipelinedRendering(bool enabled, int maxFramesInFlight = 1);
+    bool IsPipelinedRendering() const { return pipelinedRendering_; }
+    float GetPipelineLatencyMs() const;
+
+    // Frustum culling of the last rendered frame (visible/culled counts in GetStats())
+    const SceneBVH* GetSceneBVH() const { return sceneBVH_.get(); }
+
+    // Parallel submission: large translucent passes are recorded on deferred contexts by the
+    // job system and replayed in order. Must be set before Initialize()
+    void SetParallelSubmission(bool enabled) { parallelSubmission_ = enabled; }
+    bool IsParallelSubmission() const { return parallelSubmission_; }
+
+    // Renders on Direct3D 12 with bindless resources, the D3D11 renderers layered on it until
+    // they move to the command graph. Falls back to D3D11 on adapters without resource binding
+    // tier 3 and shader model 6.6. Must be set before Initialize()
+    void SetD3D12Backend(bool enabled) { d3d12Backend_ = enabled; }
+    bool IsD3D12Backend() const { return d3d12Backend_; }
+
+    // Runs jobs on the job system's fiber backend, so jobs waiting on others park instead of
+    // holding a worker. Must be set before Initialize()
+    void SetFiberJobs(bool enabled) { fiberJobs_ = enabled; }
+
+    // Builds the shader variants of every loaded material on the job system; call after level
+    // load and poll GetShaderWarmup()->GetProgress() from the loading screen
+    size_t WarmUpShaders();
+    ShaderWarmup* GetShaderWarmup() const { return shaderWarmup_.get(); }
+
+    // GPU Hi-Z occlusion culling of batched primitives. Must be set before Initialize()
+    void SetOcclusionCulling(bool enabled) { occlusionCulling_ = enabled; }
+    bool IsOcclusionCulling() const { return occlusionCulling_; }
+
+    // Dynamic resolution: the scene's render scale follows GPU frame time to hold the target
+    // frame rate (see SetTargetFPS), then is upscaled before UI. Must be set before Initialize()
+    void SetDynamicResolution(bool enabled) { dynamicResolution_ = enabled; }
+    bool IsDynamicResolution() const { return dynamicResolution_; }
+
+    // Temporal anti-aliasing, resolved before UI; with dynamic resolution on it also upscales from
+    // the dynamic scale. Must be set before Initialize()
+    void SetTemporalAA(bool enabled) { temporalAA_ = enabled; }
+    bool IsTemporalAA() const { return temporalAA_; }
+
+    // Late latch: right before a frame is submitted (on the render thread when pipelined) the
+    // function gets the raw mouse motion that arrived after the frame sampled its input and
+    // adjusts the view to match, e.g. turning a first-person camera by it. The adjusted view
+    // lasts for that frame's draws only; gameplay sees the same motion next frame. Set before
+    // Run()
+    using LateLatchFunction = std::function<void(int mouseDeltaX, int mouseDeltaY, DirectX::XMFLOAT4X4& view)>;
+    void SetLateLatch(LateLatchFunction function) { lateLatch_ = std::move(function); }
+
+    // Headless/server mode: no window, D3D device, audio or UI; simulation ticks at a fixed
+    // rate. Must be configured before Initialize()
+    void SetHeadless(bool enabled, float tickRate = 60.0f);
+    bool IsHeadless() const { return headless_; }
+    // Stops Run() after the given number of frames (0 = run until exit is requested)
+    void SetFrameLimit(uint64_t frames) { frameLimit_ = frames; }
+
+    // Scene benchmark: Initialize() builds the benchmark's scene in place of the physics demo,
+    // and Run() plays its path uncapped at a fixed simulated step, then writes the report and
+    // stops. Must be set before Initialize()
+    void SetSceneBenchmark(std::unique_ptr<SceneBenchmark> benchmark);
+    SceneBenchmark* GetSceneBenchmark() const { return sceneBenchmark_.get(); }
+
+    // Session recording: Run() writes every frame's delta time, input and script events, with the
+    // random seed and timestep settings, to filename. A replay drives Run() from such a file in
+    // place of the clock and devices, in real time or as fast as it goes, with the profiler on,
+    // and stops at its end. Must be set before Initialize()
+    void RecordSession(const std::string& filename);
+    void ReplaySession(const std::string& filename, bool realTime);
+    SessionRecorder* GetSessionRecorder() const { return session_.get(); }
+    // Engine-owned generators are seeded from it, and game code should seed its own from it too;
+    // replays restore the recorded seed
+    uint32_t GetRandomSeed() const { return randomSeed_; }
+    // Queues an event for the scripts' next update. Recorded with the session; during a replay the
+    // recorded events arrive instead
+    void TriggerScriptEvent(const std::string& eventName);
+
+    // Networking: a server replicates every entity with a ReplicatedComponent to up to maxClients
+    // clients; a client mirrors them into its ReplicationClient. Run() receives and sends once a
+    // frame after Update(). Both return false when the socket can't be opened or the build has
+    // no networking
+    bool HostServer(uint16_t port, uint32_t maxClients);
+    bool ConnectToServer(const std::string& host, uint16_t port);
+    NetTransport* GetNetwork() const { return network_.get(); }
+    ReplicationServer* GetReplicationServer() const { return replicationServer_.get(); }
+    ReplicationClient* GetReplicationClient() const { return replicationClient_.get(); }
+    // Gets the connection events and the messages replication doesn't consume
+    using NetworkEventHandler = std::function<void(const NetTransport::Event& event)>;
+    void SetNetworkEventHandler(NetworkEventHandler handler) { networkEventHandler_ = std::move(handler); }
+
     // State
-    bool IsRunning() const { return isRunning_; }
-    void RequestExit() { isRunning_ = false; }
+    bool IsRunning() const { return isRunning_.load(std::memory_order_acquire); }
+    void RequestExit() { isRunning_.store(false, std::memory_order_release); }
+    // Window client area changed; applied to the swap chain at the start of the next rendered frame
+    void OnResize(int width, int height) {
+        pendingResize_ = (static_cast<uint64_t>(width) << 32) | static_cast<uint32_t>(height);
+    }
 
 private:
     void Update(float deltaTime);
     void Render();
+    void QueueRenderPacket();
+    FrameRenderData BuildFrameRenderData();
+    void SubmitFrame(const RenderObjectView& objects, const FrameRenderData& data);
+    // Patches the view with input newer than the frame; false when nothing changed
+    bool LatchLateInput(const FrameRenderData& data, DirectX::XMFLOAT4X4& simulatedView);
+    bool InitializeHeadless();
+    bool StartSceneBenchmark();
+    bool StartSession();
+    void UpdateNetwork();
     void SafeShutdown();
+    void BuildUpdateGraph();
+    void UpdatePhysics();
+    void RecordFrameMetrics(float cpuMs);
+    // Heap total into the frame stats, GPU memory every few frames, both into profiler captures
+    void RecordMemoryStats();
     
     // Core subsystems
     std::unique_ptr<GraphicsDevice> graphics_;
@@ -102,21 +257,92 @@ private:
     std::unique_ptr<EngineUI> ui_;
     std::unique_ptr<EngineErrorRecovery> errorRecovery_;
 
+    // Job system and per-frame subsystem update graph
+    std::unique_ptr<JobSystem> jobs_;
+    std::unique_ptr<TaskGraph> updateGraph_;
+    float updateDeltaTime_;
+    std::unique_ptr<ShaderWarmup> shaderWarmup_;
+
+    // Frame rate cap
+    std::unique_ptr<FramePacer> framePacer_;
+
+    // Per-frame scratch memory, recycled every other frame
+    std::unique_ptr<FrameArena> frameArena_;
+
+    std::unique_ptr<FrameMetrics> metrics_;
+    uint64_t metricsGpuFrames_ = 0;             // GPU profiler frames already recorded
+    uint32_t memoryStatsFrame_ = 0;             // Frames since the last video memory query
+
+    // Central entity-component store shared by the subsystems
+    std::unique_ptr<World> world_;
+
+    // Scene node hierarchy for imported scenes and attached objects
+    std::unique_ptr<TransformHierarchy> transforms_;
+
+    // Script, shader and asset changes for hot reload, drained at the start of each update
+    std::unique_ptr<FileWatcher> fileWatcher_;
+
+    // Grid cells of the open level, loaded and activated around the streaming sources
+    std::unique_ptr<WorldPartition> worldPartition_;
+
+    // Simulation/render pipeline
+    std::unique_ptr<RenderPipeline> renderPipeline_;
+    std::unique_ptr<RenderQueue> renderQueue_;   // Render thread only
+    std::unique_ptr<SceneBVH> sceneBVH_;         // Render thread only
+    std::vector<AABB> cullBounds_;
+    std::vector<uint32_t> visibleObjects_;
+    bool pipelinedRendering_;
+    bool parallelSubmission_;
+    bool d3d12Backend_;
+    bool occlusionCulling_;
+    bool dynamicResolution_;
+    bool temporalAA_;
+    int maxFramesInFlight_;
+    uint64_t renderFrameNumber_;
+    size_t visibleObjectCount_;
+    LateLatchFunction lateLatch_;
+    int64_t inputMotionX_;                       // Mouse motion total as of the last input update
+    int64_t inputMotionY_;
+
+    // Headless mode
+    bool headless_;
+    float headlessTickRate_;
+    uint64_t frameLimit_;
+    bool fiberJobs_;
+
+    std::unique_ptr<SceneBenchmark> sceneBenchmark_;
+    std::unique_ptr<SessionRecorder> session_;
+    uint32_t randomSeed_;
+
+    std::unique_ptr<NetTransport> network_;
+    std::unique_ptr<ReplicationServer> replicationServer_;
+    std::unique_ptr<ReplicationClient> replicationClient_;
+    NetworkEventHandler networkEventHandler_;
+
     // Window and initialization
     HWND hwnd_;
     int width_;
     int height_;
     bool fullscreen_;
     std::string windowClass_;
+    std::atomic<uint64_t> pendingResize_{0};  // Width << 32 | height, 0 when none
 
     // Engine state
     bool initialized_;
-    bool isRunning_;
+    std::atomic<bool> isRunning_;  // RequestExit arrives from the console control handler thread
     bool shouldExit_;
     bool recoveringFromError_;
     float targetFPS_;
     float deltaTime_;
     
+    // Fixed-timestep state
+    bool fixedTimestep_;
+    float fixedDeltaTime_;
+    int maxStepsPerFrame_;
+    float simulationAccumulator_;
+    int pendingSimulationSteps_;
+    float interpolationAlpha_;
+    
     // Performance stats
     struct {
         float frameTime;
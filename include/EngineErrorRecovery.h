@@ -1,17 +1,35 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <functional>
 #include <memory>
 #include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace Nexus {
 
 class Engine;
 
+/**
+ * Collects error reports, runs health probes and applies auto-fixes.
+ *
+ * Update() costs the game thread a flag read per frame: device removal is latched by Present(),
+ * probes that query the OS run on a low-priority monitor thread at their own intervals and post
+ * what they find, and the subsystem checks run every HEALTH_CHECK_INTERVAL seconds. A report
+ * repeated within REPORT_COOLDOWN seconds is counted instead of logged again.
+ */
 class EngineErrorRecovery {
 public:
+    static constexpr float HEALTH_CHECK_INTERVAL = 5.0f;
+    static constexpr float REPORT_COOLDOWN = 10.0f;
+    static constexpr size_t MAX_ERROR_HISTORY = 256;
+
     enum class ErrorSeverity {
         Info,
         Warning,
@@ -27,6 +45,7 @@ public:
         bool canAutoFix;
         std::function<bool()> autoFixFunction;
         float timestamp;
+        uint32_t repeatCount = 0;              // Identical reports suppressed since the last one
     };
     
     struct SystemHealth {
@@ -46,8 +65,17 @@ public:
     void Shutdown();
     void Update(float deltaTime);
     
+    // Main thread only; repeats within REPORT_COOLDOWN are only counted
     void ReportError(const std::string& component, const std::string& description, 
                      ErrorSeverity severity, const std::string& suggestedFix = "");
+    // Any thread; the report is made by the next Update()
+    void PostError(const std::string& component, const std::string& description,
+                   ErrorSeverity severity, const std::string& suggestedFix = "");
+    
+    // Runs probe on the monitor thread every intervalSeconds. Probes must not touch state the
+    // main thread writes and report through PostError
+    void RegisterProbe(const std::string& name, float intervalSeconds, std::function<void()> probe);
+    void SetProbeInterval(const std::string& name, float intervalSeconds);
     
     void RegisterAutoFix(const std::string& errorPattern, std::function<bool()> fixFunction);
     bool AttemptAutoFix(const std::string& component);
@@ -71,9 +99,26 @@ public:
     const std::vector<ErrorReport>& GetErrorHistory() const { return errorHistory_; }
     
 private:
+    struct Probe {
+        std::string name;
+        float intervalSeconds;
+        std::function<void()> run;
+        std::chrono::steady_clock::time_point nextRun;
+    };
+    
+    // Last report per component and description
+    struct ReportState {
+        float lastReported = 0.0f;
+        uint32_t suppressed = 0;
+        int autoFix = -1;                      // Index into autoFixes_, -1 for none
+        bool autoFixResolved = false;
+    };
+    
     void PerformHealthCheck();
-    void CheckForCommonIssues();
-    void MonitorPerformance();
+    void CheckDeviceRemoved();
+    void ProcessPostedErrors();
+    void ProbeMemory();
+    void MonitorThread();
     
     // Auto-fix implementations
     bool FixGraphicsDeviceLost();
@@ -86,9 +131,22 @@ private:
     Engine* engine_;
     bool initialized_;
     float healthCheckTimer_;
+    bool deviceLostReported_;
+    bool memoryHigh_;                          // Monitor thread only
     
     std::vector<ErrorReport> errorHistory_;
     std::vector<std::pair<std::string, std::function<bool()>>> autoFixes_;
+    std::unordered_map<std::string, ReportState> reportStates_;
+    
+    // Monitor thread
+    std::thread monitorThread_;
+    std::vector<Probe> probes_;
+    std::mutex monitorMutex_;
+    std::condition_variable monitorCondition_;
+    bool shutdownRequested_;
+    std::vector<ErrorReport> postedErrors_;
+    std::mutex postedMutex_;
+    std::atomic<bool> hasPostedErrors_;
     
     SystemHealth graphicsHealth_;
     SystemHealth audioHealth_;
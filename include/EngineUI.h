@@ -1,7 +1,11 @@
 #pragma once
 
 #include <d3d11.h>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <functional>
@@ -18,6 +22,11 @@ class Logger;
 /**
  * Modern, user-friendly UI system for the Nexus Engine
  * Features: Real-time monitoring, easy controls, bug reporting, performance metrics
+ *
+ * The panels are only rebuilt when something they show changes: input reaching ImGui (and a
+ * second after it, for hover and tooltip timers), an active widget, a resize, a new log line, or
+ * new metrics, which Update() publishes at refreshRate. Otherwise EndFrame() draws the previous
+ * frame's draw data again. While hidden, Update() collects metrics at hiddenUpdateRate only.
  */
 class EngineUI {
 public:
@@ -35,6 +44,10 @@ public:
     struct PerformanceMetrics {
         float fps = 0.0f;
         float frameTime = 0.0f;
+        float frameTimeP95 = 0.0f;
+        float frameTimeP99 = 0.0f;
+        float frameTimeMax = 0.0f;
+        int hitches = 0;               // In the engine's metrics window
         float cpuUsage = 0.0f;
         float memoryUsage = 0.0f;
         int drawCalls = 0;
@@ -60,15 +73,25 @@ public:
     bool Initialize(Engine* engine, ID3D11Device* device, ID3D11DeviceContext* context);
     void Shutdown();
 
-    // Main UI rendering
+    // Simulation side: collects metrics at the refresh rate
+    void Update(float deltaTime);
+
+    // Main UI rendering; NewFrame() decides whether this frame rebuilds the panels
     void NewFrame();
     void Render();
     void EndFrame();
 
     // UI state management
-    void SetVisible(bool visible) { isVisible_ = visible; }
+    void SetVisible(bool visible) { isVisible_ = visible; dirty_ = true; }
     bool IsVisible() const { return isVisible_; }
-    void ToggleVisibility() { isVisible_ = !isVisible_; }
+    void ToggleVisibility() { SetVisible(!isVisible_); }
+    // Rebuild on the next frame, for state the UI can't see change
+    void MarkDirty() { dirty_ = true; }
+    // Metric updates per second while visible and while hidden; 0 stops them
+    void SetRefreshRate(float visibleRate, float hiddenRate) {
+        settings_.refreshRate = visibleRate;
+        settings_.hiddenUpdateRate = hiddenRate;
+    }
 
     // Theme management
     void SetTheme(const UITheme& theme);
@@ -108,6 +131,8 @@ private:
     void RenderAboutDialog();
 
     // Helper functions
+    bool NeedsRebuild();
+    void ResizeLog(size_t capacity);
     void ApplyTheme();
     void UpdateEngineStatus();
     void ProcessConsoleCommand(const std::string& command);
@@ -137,10 +162,35 @@ private:
     bool showSuccessDialog_ = false;
     bool showAboutDialog_ = false;
     
+    // Rebuild state
+    std::atomic<bool> dirty_;
+    bool rebuildThisFrame_;
+    bool hasDrawData_;                         // ImGui's draw data from the last rebuild
+    std::chrono::steady_clock::time_point lastInputTime_;
+    float displayWidth_, displayHeight_;
+
+    // Metrics published by Update() for the next rebuild
+    std::mutex metricsMutex_;
+    PerformanceMetrics publishedMetrics_;
+    std::atomic<bool> metricsChanged_;
+    float refreshTimer_;
+    float frameTimeAccumulator_;
+    int framesAccumulated_;
+
     // Data
     PerformanceMetrics metrics_;
     EngineStatus status_;
-    std::vector<std::string> consoleLog_;
+    std::array<float, 100> fpsHistory_;
+    size_t fpsHistoryOffset_;
+
+    // Console: a ring of maxLogLines, drawn through a list clipper
+    struct LogLine {
+        std::string text;
+        int level = 0;
+    };
+    std::vector<LogLine> consoleLog_;
+    size_t logHead_;                           // Oldest line
+    size_t logCount_;
     std::string currentError_;
     std::string currentSuccess_;
     std::string consoleInput_;
@@ -155,6 +205,8 @@ private:
         bool enableDebugMode = false;
         int maxLogLines = 1000;
         bool darkMode = true;
+        float refreshRate = 10.0f;
+        float hiddenUpdateRate = 1.0f;
     } settings_;
     
     // Callbacks
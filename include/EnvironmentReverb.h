@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Nexus {
+
+struct ReverbSettings {
+    float decayTime = 1.5f;                    // Seconds for low frequencies to fall 60dB
+    float decayHFRatio = 0.8f;                 // High frequency decay time over decayTime
+    float preDelay = 0.01f;                    // Seconds before the tail starts
+    float roomSize = 7.5f;                     // Metres; sets the delay line lengths
+    float diffusion = 1.0f;                    // 0 to 1, how quickly echoes smear into a wash
+    float level = 0.3f;                        // Wet gain
+};
+
+/**
+ * In-place radix-2 complex FFT on split real and imaginary arrays.
+ *
+ * Twiddles are stored per stage so every butterfly loop walks them contiguously, four at a time
+ * with SSE once a stage is wide enough. Prepare() allocates; the transforms don't.
+ */
+class AudioFFT {
+public:
+    void Prepare(uint32_t size);
+    uint32_t GetSize() const { return size_; }
+
+    void Forward(float* re, float* im) const;
+    // Scaled by 1/size, so Inverse(Forward(x)) == x
+    void Inverse(float* re, float* im) const;
+
+private:
+    void Transform(float* re, float* im) const;
+
+    uint32_t size_ = 0;
+    std::vector<uint32_t> reversed_;           // Bit-reversed index of each element
+    std::vector<float> cos_;                   // Stage with half-width h at [h - 1, 2h - 1)
+    std::vector<float> sin_;
+};
+
+/**
+ * Feedback delay network reverb, the default for environments.
+ *
+ * The input passes a pre-delay and a chain of allpass diffusers, then feeds LINE_COUNT delay lines
+ * of mutually prime lengths scaled to the room. The lines feed back into each other through a
+ * Householder matrix, which mixes every line into every other at the cost of one sum. Each line
+ * has a one-pole lowpass tuned so lows ring for decayTime and highs for decayTime *
+ * decayHFRatio. Lines are processed four to an SSE register. Mono in, stereo out.
+ *
+ * Prepare() allocates lines long enough for MAX_ROOM_SIZE; Configure() only retunes them and is
+ * safe on the audio thread.
+ */
+class FDNReverb {
+public:
+    static constexpr int LINE_COUNT = 16;
+    static constexpr int DIFFUSER_COUNT = 4;
+    static constexpr float MAX_ROOM_SIZE = 50.0f;
+    static constexpr float MAX_PRE_DELAY = 0.3f;
+
+    FDNReverb();
+
+    void Prepare(int sampleRate);
+    void Configure(const ReverbSettings& settings);
+    void Reset();
+
+    // Adds the reverb of frameCount mono samples into interleaved stereo output
+    void Process(const float* input, float* output, uint32_t frameCount);
+    // Frames after the input stops until the tail has died away
+    uint32_t GetTailFrames() const { return tailFrames_; }
+
+private:
+    struct Line {
+        size_t start;                          // Into buffer_
+        uint32_t capacity;
+        uint32_t length;
+        uint32_t position;
+    };
+
+    float Tap(const Line& line) const;
+    void Push(Line& line, float value);
+
+    int sampleRate_;
+    std::vector<float> buffer_;                // Every line, diffuser and the pre-delay
+    Line lines_[LINE_COUNT];
+    Line diffusers_[DIFFUSER_COUNT];
+    Line preDelay_;
+    alignas(16) float gains_[LINE_COUNT];      // DC gain of each line's lowpass
+    alignas(16) float poles_[LINE_COUNT];
+    alignas(16) float states_[LINE_COUNT];
+    float diffusion_;
+    float level_;
+    uint32_t tailFrames_;
+};
+
+/**
+ * Stereo impulse response prepared for ConvolutionReverb.
+ *
+ * The response is cut into partitions whose size grows fourfold from the block size up to
+ * MAX_PARTITION: a tier of partitions of size M starts 2M into the response, late enough that a
+ * convolver can spread the tier's work over the M frames after each input block instead of doing
+ * it all at once. Each partition's spectrum is computed here, once, and shared by every convolver
+ * built from the response.
+ */
+class ImpulseResponse {
+public:
+    static constexpr uint32_t MAX_PARTITION = 16384;
+
+    // blockFrames must be a power of two
+    bool Build(const std::vector<float>& left, const std::vector<float>& right, uint32_t blockFrames);
+
+    uint32_t GetBlockFrames() const { return blockFrames_; }
+    uint32_t GetLength() const { return length_; }
+
+private:
+    friend class ConvolutionReverb;
+
+    struct Tier {
+        uint32_t size;                         // Frames per partition
+        uint32_t offset;                       // Into the response
+        uint32_t partitions;
+        std::vector<float> re;                 // Spectrum of left + i * right, 2 * size per partition
+        std::vector<float> im;
+    };
+
+    std::vector<Tier> tiers_;
+    uint32_t blockFrames_ = 0;
+    uint32_t length_ = 0;
+};
+
+/**
+ * Non-uniformly partitioned overlap-save convolution with an ImpulseResponse.
+ *
+ * The first tier runs in full every block, so the response starts with no latency beyond the
+ * block. Each later tier of size M does one step per block: the input transform, a share of the
+ * spectral multiply-adds, or the inverse transform, landing its output in a ring M frames before it
+ * is due. Tiers start at different phases, so no block carries more than one transform per tier
+ * however long the response is. Mono in, stereo out, always blockFrames at a time. The
+ * constructor allocates everything Process() needs.
+ */
+class ConvolutionReverb {
+public:
+    explicit ConvolutionReverb(std::shared_ptr<const ImpulseResponse> response);
+
+    // Adds the reverb of blockFrames mono samples into interleaved stereo output
+    void Process(const float* input, float* output);
+    uint32_t GetBlockFrames() const { return response_->blockFrames_; }
+    uint32_t GetTailFrames() const { return response_->length_; }
+
+private:
+    struct TierState {
+        AudioFFT fft;
+        uint32_t steps;                        // Blocks per partition
+        uint32_t phase;
+        std::vector<float> spectraRe;          // Input spectra of the last partitions blocks, a ring
+        std::vector<float> spectraIm;
+        uint32_t newest;                       // Slot in the ring of the latest spectrum
+        std::vector<float> accumulatorRe;
+        std::vector<float> accumulatorIm;
+        uint64_t blockEnd;                     // Input frame the block in flight ends at
+    };
+
+    void Step(size_t tier, uint32_t step);
+
+    std::shared_ptr<const ImpulseResponse> response_;
+    std::vector<TierState> tiers_;
+    std::vector<float> history_;               // Input ring, long enough for the largest window
+    std::vector<float> pending_;               // Output ring, tiers add into it ahead of time
+    uint64_t frames_;                          // Input consumed so far
+};
+
+} // namespace Nexus
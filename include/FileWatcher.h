@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Event-driven file change notification for hot reload.
+ *
+ * One background thread waits on overlapped ReadDirectoryChangesW for every watched directory
+ * tree, so nothing is polled and the cost doesn't grow with the number of files. A changed file
+ * is only reported once it has been quiet for the debounce interval, which turns an editor's
+ * save (truncate, write, rename, touch) into one change. Poll() drains the ready changes on the
+ * calling thread, once per frame, and hands each to the listeners for its extension.
+ *
+ * Paths given to listeners are NormalizePath()ed; compare against normalized paths.
+ */
+class FileWatcher {
+public:
+    using ListenerID = uint32_t;
+    using Listener = std::function<void(const std::string& path)>;
+
+    static constexpr ListenerID INVALID_LISTENER = 0;
+
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool Start(uint32_t debounceMs = 100);
+    void Stop();
+
+    // The directory and everything below it. Directories already inside a watched tree are
+    // covered; at most MAX_DIRECTORIES trees
+    bool Watch(const std::string& directory);
+
+    // extensions like ".lua", any case; none means every file
+    ListenerID AddListener(const std::vector<std::string>& extensions, Listener listener);
+    void RemoveListener(ListenerID id);
+
+    // Main thread, once per frame
+    void Poll();
+
+    // Absolute, lower case, backslashes
+    static std::string NormalizePath(const std::string& path);
+
+    static constexpr size_t MAX_DIRECTORIES = 63;   // One wait slot is the wake event
+
+private:
+    struct Directory;
+
+    struct ListenerEntry {
+        ListenerID id;
+        std::vector<std::string> extensions;
+        Listener callback;
+    };
+
+    void ThreadMain();
+    bool BeginRead(Directory& directory);
+    void ReadChanges(Directory& directory, uint64_t now);
+
+    std::thread thread_;
+    void* wakeEvent_;                                        // HANDLE
+    std::atomic<bool> stop_;
+    uint32_t debounceMs_;
+
+    // Owned by the thread once Watch() hands them over through added_
+    std::vector<std::unique_ptr<Directory>> directories_;
+    std::unordered_map<std::string, uint64_t> pending_;      // Path to the time of its last change
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Directory>> added_;
+    std::vector<std::string> ready_;
+    std::atomic<uint32_t> overflows_;                        // Buffers lost, changes unknown
+
+    std::vector<std::string> watched_;                       // Normalized, main thread
+    std::vector<ListenerEntry> listeners_;
+    ListenerID nextListener_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+class NavMesh;
+
+/**
+ * Flow field towards one goal over a navmesh.
+ *
+ * cost holds every polygon's distance to the goal through the polygon graph and next the
+ * neighbour to walk into, so any number of agents heading for the goal look up their direction
+ * instead of searching a path each. Each polygon also stores where to steer: the point on its
+ * portal into next that lies nearest the next polygon's own steering point, which pulls the
+ * routes taut across open areas. Immutable once built and shared between agents and threads.
+ */
+class FlowField {
+public:
+    static constexpr uint32_t INVALID_POLYGON = ~0u;
+
+    FlowField(std::shared_ptr<const NavMesh> navMesh, uint32_t goalPolygon, const DirectX::XMFLOAT3& goal);
+
+    // Unit direction on the ground plane from position towards the goal; false off the navmesh or
+    // where the goal can't be reached. target receives the point being steered at
+    bool GetDirection(const DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& direction,
+                      DirectX::XMFLOAT3* target = nullptr) const;
+    // Distance left to the goal from the polygon under position, FLT_MAX when unreachable
+    float GetCost(const DirectX::XMFLOAT3& position) const;
+
+    uint32_t GetGoalPolygon() const { return goalPolygon_; }
+    const DirectX::XMFLOAT3& GetGoal() const { return goal_; }
+    uint32_t GetRevision() const { return revision_; }
+    // Polygons settled by the build
+    size_t GetReachableCount() const { return reachable_; }
+
+private:
+    void Build();
+
+    std::shared_ptr<const NavMesh> navMesh_;
+    uint32_t goalPolygon_;
+    DirectX::XMFLOAT3 goal_;
+    uint32_t revision_;                        // Of the navmesh it was built from
+    size_t reachable_;
+
+    std::vector<float> cost_;
+    std::vector<uint32_t> next_;
+    std::vector<DirectX::XMFLOAT3> steer_;
+};
+
+/**
+ * Flow fields shared by goal.
+ *
+ * GetField() snaps the goal onto the navmesh and returns the field of that polygon, building it
+ * on first use; goals inside one polygon share a field. The most recently used fields are kept up
+ * to the capacity, and all of them are dropped when the navmesh changes. Fields already handed out
+ * stay valid for as long as agents hold on to them.
+ */
+class FlowFieldCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 16;
+
+    struct Stats {
+        uint32_t requests = 0;
+        uint32_t builds = 0;
+    };
+
+    FlowFieldCache();
+
+    void SetNavMesh(std::shared_ptr<const NavMesh> navMesh);
+    void SetCapacity(size_t fields);
+    void Clear();
+
+    // Null when the goal is further than searchRadius from the navmesh
+    std::shared_ptr<const FlowField> GetField(const DirectX::XMFLOAT3& goal, float searchRadius = 2.0f);
+
+    size_t GetFieldCount() const { return fields_.size(); }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    std::shared_ptr<const NavMesh> navMesh_;
+    uint32_t revision_;
+    size_t capacity_;
+
+    std::list<std::shared_ptr<const FlowField>> fields_;   // Most recently used first
+    std::unordered_map<uint32_t, std::list<std::shared_ptr<const FlowField>>::iterator> index_;
+    Stats stats_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+struct FluidSettings {
+    float density = 1000.0f;                   // Rest density
+    float viscosity = 0.1f;
+    float surfaceTension = 0.0728f;
+    float gasConstant = 2000.0f;
+    float restDistance = 0.1f;                 // Particle spacing at rest; the kernel radius is twice this
+    int maxParticles = 10000;
+    DirectX::XMFLOAT3 containerSize = DirectX::XMFLOAT3(10.0f, 10.0f, 10.0f);
+    float gravity = -9.81f;
+    float boundaryDamping = 0.5f;              // Share of the normal speed kept when bouncing off the bounds
+    float maxTimeStep = 0.002f;                // Updates are split into steps no longer than this...
+    int maxSubSteps = 8;                       // ...but at most this many; the rest of the time is dropped
+};
+
+/**
+ * Smoothed particle hydrodynamics fluid.
+ *
+ * Neighbors are found through a uniform grid of kernel-radius cells. Every step the particles
+ * are counting-sorted by the Z-order (Morton) key of their cell, so each cell's particles are
+ * contiguous and nearby cells sit close in memory; a neighbor query walks the 27 surrounding
+ * cells instead of every particle. The density, force and integration passes work on
+ * structure-of-arrays copies of the sorted particles, four neighbors or particles per SSE
+ * operation, split across the job system when there are enough particles.
+ *
+ * GetParticles() returns the particles in the order of the last sort, so indices are not
+ * stable across updates; IDs are.
+ */
+class FluidSystem {
+public:
+    struct Particle {
+        DirectX::XMFLOAT3 position;
+        DirectX::XMFLOAT3 velocity;
+        DirectX::XMFLOAT3 force;               // Acceleration from pressure, viscosity and gravity at the last step
+        float density;
+        float pressure;
+        float mass;
+        int id;
+    };
+
+    FluidSystem();
+
+    FluidSystem(const FluidSystem&) = delete;
+    FluidSystem& operator=(const FluidSystem&) = delete;
+
+    bool Initialize(const FluidSettings& settings);
+    void SetJobSystem(JobSystem* jobs) { jobs_ = jobs; }
+    void Update(float deltaTime);
+    // Ignored once maxParticles are alive
+    void AddParticle(const DirectX::XMFLOAT3& position,
+                     const DirectX::XMFLOAT3& velocity = DirectX::XMFLOAT3(0, 0, 0));
+    void RemoveParticle(int particleId);
+    const std::vector<Particle>& GetParticles() const { return particles_; }
+    void SetBounds(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max);
+
+private:
+    static constexpr uint32_t MAX_CELL_BITS = 7;       // Per axis, so at most 2^21 cells
+    static constexpr size_t PARALLEL_THRESHOLD = 1024;
+
+    void Step(float deltaTime);
+    void BuildGrid();
+    void CalculateDensityPressure();
+    void CalculateForces();
+    void Integrate(float deltaTime);
+    void HandleCollisions();
+    void ConfigureGrid();
+    uint32_t CellCoordinate(float position, float boundsMin) const;
+    // fn(begin, end) over [0, count), across the job system when worthwhile
+    template<typename Fn>
+    void ForRange(size_t count, Fn&& fn);
+
+    std::vector<Particle> particles_;
+    FluidSettings settings_;
+    DirectX::XMFLOAT3 boundsMin_, boundsMax_;
+    int nextParticleId_;
+    JobSystem* jobs_;
+
+    // Kernel constants derived from the settings
+    float radius_;
+    float particleMass_;
+
+    // Grid: cellStart_[key] .. cellStart_[key + 1] are the sorted particles in the cell with
+    // Morton key `key`
+    float cellSize_;
+    uint32_t cellBits_;
+    std::vector<uint32_t> cellStart_;
+    std::vector<uint32_t> cellKeys_;           // Per unsorted particle
+    std::vector<uint32_t> order_;              // Sorted slot -> unsorted particle
+
+    // Sorted particles as structure of arrays, padded by three lanes for the last SSE load
+    std::vector<float> positionX_, positionY_, positionZ_;
+    std::vector<float> velocityX_, velocityY_, velocityZ_;
+    std::vector<float> accelerationX_, accelerationY_, accelerationZ_;
+    std::vector<float> densities_, pressures_;
+    std::vector<Particle> sorted_;             // Write-back target, swapped with particles_
+};
+
+} // namespace Nexus
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Platform.h"
+#include "SceneBVH.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+class Mesh;
+class OcclusionCuller;
+
+/**
+ * GPU-driven instanced rendering of foliage and other heavily repeated small meshes.
+ *
+ * Instances are registered per type (a mesh with its LOD and fade distances) and stored in square
+ * world cells. All of them live in one GPU buffer, grouped by cell and then by type in chunks of
+ * CHUNK_SIZE. Per frame the CPU only tests cell bounds against the frustum and the cull distance,
+ * then uploads the chunk indices of the surviving cells. Cull() runs one thread per instance:
+ * - frustum and Hi-Z tests on the instance's bounding sphere;
+ * - density thinning past a type's thinStart;
+ * - a LOD chosen by distance.
+ *
+ * Thinning keeps a fraction of the instances that falls linearly to zero at the cull distance.
+ * A stable per-instance random number decides which ones stay. Instead of popping, an instance
+ * shrinks to nothing while the kept fraction comes within FADE_BAND of its number. Survivors are compacted
+ * into one list per type and LOD. Their counts go into DrawIndexedInstancedIndirect records, so
+ * Render() issues one indirect draw per type and LOD with no per-instance CPU work.
+ *
+ * Render() binds only the vertex stage. Its shader emits PBR_VS's outputs, so the caller's
+ * pixel shader and material (GBuffer_PS or PBR_PS) draw the foliage like any other mesh.
+ * Adding or clearing instances rebuilds the GPU buffers at the next Cull().
+ */
+class FoliageRenderer {
+public:
+    struct Stats {
+        uint32_t cells = 0;
+        uint32_t visibleCells = 0;      // Passed the CPU cell test
+        uint32_t instances = 0;         // Submitted to the GPU cull this frame
+        uint32_t draws = 0;
+    };
+
+    // Yawed about +Y and uniformly scaled copy of its type's mesh
+    struct Instance {
+        DirectX::XMFLOAT3 position = { 0.0f, 0.0f, 0.0f };
+        float scale = 1.0f;
+        float yaw = 0.0f;               // Radians
+    };
+
+    static constexpr UINT MAX_LODS = 4;
+
+    struct Type {
+        Mesh* mesh = nullptr;           // Full or Compressed vertices; must outlive the type
+        // Distances at which LOD 1, 2 and 3 start; levels past the mesh's last one use its last
+        float lodDistances[MAX_LODS - 1] = { 20.0f, 50.0f, 100.0f };
+        float cullDistance = 150.0f;
+        float thinStart = 60.0f;        // Density falls from here to zero at cullDistance; past it, off
+    };
+
+    struct Settings {
+        float cellSize = 64.0f;         // Read as instances are added, so set it before the first
+        float density = 1.0f;           // Fraction of every type drawn, 0-1
+        float distanceScale = 1.0f;     // Multiplies every LOD, thinning and cull distance
+    };
+
+    static constexpr UINT MAX_TYPES = 64;
+    static constexpr UINT INVALID_TYPE = ~0u;
+    static constexpr UINT CHUNK_SIZE = 256;
+    static constexpr float FADE_BAND = 0.1f;
+    static constexpr UINT ARGUMENT_STRIDE = 5 * sizeof(UINT);
+
+    FoliageRenderer();
+    ~FoliageRenderer();
+
+    FoliageRenderer(const FoliageRenderer&) = delete;
+    FoliageRenderer& operator=(const FoliageRenderer&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings);
+    void Shutdown();
+
+    void SetSettings(const Settings& settings);
+    const Settings& GetSettings() const { return settings_; }
+
+    // INVALID_TYPE when the mesh is missing or MAX_TYPES are registered
+    UINT AddType(const Type& type);
+    // Each instance goes into the cell containing its position
+    void AddInstances(UINT type, const std::vector<Instance>& instances);
+    // Cell coordinates are floor(position.xz / cellSize)
+    void ClearCell(int cellX, int cellZ);
+    void Clear();
+
+    // viewProjection is the unjittered row-vector matrix; occlusion may be null
+    void Cull(DirectX::CXMMATRIX viewProjection, const DirectX::XMFLOAT3& cameraPosition,
+              const OcclusionCuller* occlusion);
+    // viewProjection may carry TemporalAA's jitter. Leaves the vertex stage bound to the foliage
+    // shader and the topology at triangle lists
+    void Render(DirectX::CXMMATRIX viewProjection, DirectX::CXMMATRIX lightViewProjection,
+                const DirectX::XMFLOAT3& cameraPosition);
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    struct Cell {
+        int x = 0;
+        int z = 0;
+        std::vector<std::vector<Instance>> types;   // Indexed by type
+        AABB bounds = {};
+        float cullDistance = 0.0f;                  // Largest among the cell's types
+        UINT instanceCount = 0;
+        UINT firstChunk = 0;
+        UINT chunkCount = 0;
+    };
+
+    bool CreateShaders();
+    bool RebuildBuffers();
+    void ReleaseInstanceBuffers();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    Settings settings_;
+
+    std::vector<Type> types_;
+    std::unordered_map<uint64_t, Cell> cells_;
+    bool dirty_;
+
+    ID3D11ComputeShader* cullShader_;
+    ID3D11Buffer* cullConstants_;
+    ID3D11VertexShader* vertexShaders_[2];          // By VertexFormat, Full and Compressed
+    ID3D11InputLayout* inputLayouts_[2];
+    ID3D11Buffer* drawConstants_;
+    ID3D11Buffer* typeBuffer_;
+    ID3D11ShaderResourceView* typeView_;
+    // One record per type and LOD, reset by every Cull()
+    ID3D11Buffer* argumentsBuffer_;
+    ID3D11UnorderedAccessView* argumentsTarget_;
+
+    // Rebuilt with the instances
+    ID3D11Buffer* instanceBuffer_;
+    ID3D11ShaderResourceView* instanceView_;
+    ID3D11Buffer* chunkBuffer_;
+    ID3D11ShaderResourceView* chunkView_;
+    ID3D11Buffer* visibleChunkBuffer_;
+    ID3D11ShaderResourceView* visibleChunkView_;
+    ID3D11Buffer* listBuffer_;
+    ID3D11UnorderedAccessView* listTarget_;
+    ID3D11ShaderResourceView* listView_;
+    UINT chunkCount_;
+    std::vector<UINT> typeInstanceCounts_;
+    std::vector<UINT> typeListBases_;
+
+    // Per frame
+    std::vector<UINT> visibleChunks_;
+    std::vector<bool> typeVisible_;
+    Stats stats_;
+};
+
+} // namespace Nexus
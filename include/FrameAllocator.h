@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Lock-free bump allocator over a single fixed block.
+ *
+ * Allocation is one atomic add, so job workers can carve scratch memory concurrently.
+ * Individual frees are not supported; the whole arena is released at once by Reset().
+ * Requests that do not fit fall back to the heap and are freed on the next Reset().
+ */
+class LinearArena {
+public:
+    struct Stats {
+        size_t capacity = 0;
+        size_t used = 0;            // Bytes handed out from the block
+        size_t peakUsed = 0;        // High water mark across resets
+        size_t overflowBytes = 0;   // Bytes that spilled to the heap since the last reset
+        size_t overflowCount = 0;
+    };
+
+    LinearArena();
+    ~LinearArena();
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    bool Initialize(size_t capacity);
+    void Shutdown();
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void Reset();
+
+    bool Owns(const void* ptr) const;
+    Stats GetStats() const;
+
+private:
+    uint8_t* buffer_;
+    size_t capacity_;
+    std::atomic<size_t> offset_;
+    size_t peakUsed_;
+
+    struct OverflowBlock {
+        void* ptr;
+        size_t alignment;
+    };
+
+    mutable std::mutex overflowMutex_;
+    std::vector<OverflowBlock> overflowBlocks_;
+    size_t overflowBytes_;
+};
+
+/**
+ * Double-buffered per-frame scratch memory.
+ *
+ * BeginFrame() flips to the other arena and resets it, so data allocated during frame N
+ * stays valid through frame N+1 (e.g. render data produced by the update for the next
+ * frame's draw) and is recycled afterwards.
+ */
+class FrameArena {
+public:
+    FrameArena();
+    ~FrameArena();
+
+    bool Initialize(size_t bytesPerFrame = 4 * 1024 * 1024);
+    void Shutdown();
+
+    // Call once at the top of each frame, before any subsystem allocates
+    void BeginFrame();
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template<typename T>
+    T* AllocateArray(size_t count) {
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // Copies a string into frame memory, valid until the arena is recycled
+    const char* CopyString(const char* text, size_t length);
+
+    LinearArena& GetCurrent() { return arenas_[current_]; }
+    LinearArena::Stats GetStats() const { return arenas_[current_].GetStats(); }
+
+private:
+    LinearArena arenas_[2];
+    int current_;
+    bool initialized_;
+};
+
+/**
+ * STL allocator adapter drawing from a FrameArena.
+ *
+ * deallocate() is a no-op; memory comes back when the arena is recycled. Containers
+ * using this allocator must not outlive the frame after the one they were filled in.
+ * A default-constructed allocator (no arena) uses the global heap instead.
+ */
+template<typename T>
+class FrameStlAllocator {
+public:
+    using value_type = T;
+
+    FrameStlAllocator() noexcept : arena_(nullptr) {}
+    explicit FrameStlAllocator(FrameArena* arena) noexcept : arena_(arena) {}
+
+    template<typename U>
+    FrameStlAllocator(const FrameStlAllocator<U>& other) noexcept : arena_(other.GetArena()) {}
+
+    T* allocate(size_t count) {
+        if (arena_) {
+            return arena_->AllocateArray<T>(count);
+        }
+        return static_cast<T*>(::operator new(sizeof(T) * count));
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        if (!arena_) {
+            ::operator delete(ptr);
+        }
+    }
+
+    FrameArena* GetArena() const noexcept { return arena_; }
+
+    template<typename U>
+    bool operator==(const FrameStlAllocator<U>& other) const noexcept { return arena_ == other.GetArena(); }
+    template<typename U>
+    bool operator!=(const FrameStlAllocator<U>& other) const noexcept { return arena_ != other.GetArena(); }
+
+private:
+    FrameArena* arena_;
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameStlAllocator<T>>;
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameStlAllocator<char>>;
+
+} // namespace Nexus
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Rolling statistics of one series over the metrics window, in milliseconds
+ */
+struct MetricSummary {
+    float last = 0.0f;
+    float mean = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+    uint32_t samples = 0;          // In the window
+    uint32_t hitches = 0;          // In the window
+    uint64_t totalHitches = 0;     // Since the series was created or reset
+};
+
+/**
+ * Per-frame timings (frame, CPU, GPU, subsystems) over a rolling window.
+ *
+ * Each series keeps its last WINDOW_SIZE samples in a ring and the same samples in a
+ * log-bucketed histogram, so recording is O(1) and percentiles walk a fixed number of buckets
+ * within 2.5% relative error; the max is exact. A sample is a hitch when it exceeds
+ * hitchFactor times the series median and at least hitchMinimumMs.
+ *
+ * Record from the main thread; any thread may read summaries and export.
+ */
+class FrameMetrics {
+public:
+    static constexpr size_t WINDOW_SIZE = 1024;
+
+    FrameMetrics();
+    ~FrameMetrics();
+
+    // Series are created on first use
+    void Record(const std::string& series, float milliseconds);
+    // Frames are numbered for the exports; call once after each frame's samples
+    void EndFrame() { ++frameNumber_; }
+
+    bool GetSummary(const std::string& series, MetricSummary& summary) const;
+    std::vector<std::string> GetSeriesNames() const;
+    // Mean of the newest frames of the "Frame" series, 0 before any frame
+    float GetAverageFrameTimeMs(size_t frames = 60) const;
+
+    void SetHitchThreshold(float factor, float minimumMs);
+    void Reset();
+
+    // Long format, one row per sample in the window: series,frame,ms
+    bool ExportCSV(const std::string& filename) const;
+    // Every series' summary and its samples in the window, oldest first
+    bool ExportJSON(const std::string& filename) const;
+
+private:
+    static constexpr size_t BUCKET_COUNT = 384;
+
+    struct Sample {
+        uint64_t frame;
+        float milliseconds;
+        uint16_t bucket;
+        bool hitch;
+    };
+
+    struct Series {
+        std::string name;
+        std::array<Sample, WINDOW_SIZE> samples;
+        size_t head = 0;           // Next slot to write
+        size_t count = 0;
+        double sum = 0.0;
+        std::array<uint32_t, BUCKET_COUNT> buckets{};
+        uint32_t hitches = 0;
+        uint64_t totalHitches = 0;
+    };
+
+    Series* FindSeries(const std::string& name) const;
+    static uint16_t GetBucket(float milliseconds);
+    static float GetBucketValue(uint16_t bucket);
+    static float GetQuantile(const Series& series, float quantile);
+    static void Summarize(const Series& series, MetricSummary& summary);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Series>> series_;
+    uint64_t frameNumber_;
+    float hitchFactor_;
+    float hitchMinimumMs_;
+};
+
+} // namespace Nexus
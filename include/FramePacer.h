@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Platform.h"
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * High-precision frame pacer.
+ *
+ * Sleeps on a high-resolution waitable timer until shortly before the frame deadline and
+ * spin-waits the remaining tail, so frame caps land on the target instead of the
+ * ~15.6 ms scheduler granularity of Sleep(). Deadlines are absolute, so small overshoots
+ * do not accumulate into drift.
+ */
+class FramePacer {
+public:
+    struct Stats {
+        float targetFrameTime = 0.0f;  // seconds
+        float lastFrameTime = 0.0f;    // seconds, measured start to start
+        float averageFrameTime = 0.0f;
+        float jitter = 0.0f;           // standard deviation of frame time over the window
+        float maxDeviation = 0.0f;     // largest |frameTime - target| over the window
+        float averageOvershoot = 0.0f; // how late the wait returned past the deadline
+        unsigned long long frameCount = 0;
+        unsigned long long missedFrames = 0;
+    };
+
+    FramePacer();
+    ~FramePacer();
+
+    bool Initialize(float targetFPS = 0.0f);
+    void Shutdown();
+
+    // Frame pacing
+    void SetTargetFPS(float fps);
+    float GetTargetFPS() const { return targetFPS_; }
+    void SetSpinThreshold(float seconds) { spinThreshold_ = seconds; }
+
+    // Optional DXGI frame-latency waitable object (IDXGISwapChain2::GetFrameLatencyWaitableObject)
+    void SetFrameLatencyWaitable(HANDLE waitable) { latencyWaitable_ = waitable; }
+    void WaitForFrameLatency();
+
+    // Call once per frame after presenting; blocks until the next frame deadline
+    void WaitForNextFrame();
+
+    // Statistics
+    const Stats& GetStats() const { return stats_; }
+    void ResetStats();
+
+private:
+    long long GetCounter() const;
+    double CountsToSeconds(long long counts) const { return static_cast<double>(counts) / frequency_; }
+    long long SecondsToCounts(double seconds) const { return static_cast<long long>(seconds * frequency_); }
+    void SleepUntil(long long deadline);
+    void RecordFrame(long long frameStart, long long deadline, long long wakeTime);
+
+    HANDLE waitableTimer_;
+    HANDLE latencyWaitable_;
+    bool highResolutionTimer_;
+    bool timerPeriodRaised_;
+
+    long long frequency_;
+    long long nextDeadline_;
+    long long lastFrameStart_;
+    float targetFPS_;
+    float spinThreshold_;
+
+    // Rolling window for jitter statistics
+    std::vector<float> frameTimes_;
+    size_t frameTimeIndex_;
+    double overshootAccumulator_;
+    Stats stats_;
+    bool initialized_;
+};
+
+} // namespace Nexus
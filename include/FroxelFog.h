@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace Nexus {
+
+class CascadedShadowMaps;
+class ClusteredLightCuller;
+class StateCache;
+
+/**
+ * Volumetric fog in a frustum-aligned voxel ("froxel") volume.
+ *
+ * The volume covers the view frustum with width x height screen tiles and depth exponential
+ * slices, so its cost depends on the volume size, not on the screen resolution. A compute pass
+ * evaluates density, in-scattered light and the Henyey-Greenstein phase at one jittered point
+ * per froxel: the first directional light of the clustered light list is shadowed by the
+ * cascaded shadow maps, point and spot lights are looked up in the cluster the froxel falls in.
+ * The jitter moves every frame and the result is blended with last frame's volume, reprojected
+ * through the previous camera, so the sampling pattern averages out. A second pass walks every
+ * column front to back once and stores the light scattered towards the camera and the
+ * transmittance up to each slice. Composite() applies that to the scene with one volume fetch
+ * per pixel.
+ */
+class FroxelFog {
+public:
+    struct Settings {
+        UINT width = 160;
+        UINT height = 90;
+        UINT depth = 64;
+        float nearPlane = 0.5f;          // View depth where the first slice starts
+        float farPlane = 200.0f;         // Beyond this the fog of the last slice is held
+        float density = 0.02f;           // Extinction per world unit everywhere
+        float heightDensity = 0.015f;    // Extra extinction at fogHeight, fading with height
+        float fogHeight = 0.0f;
+        float heightFalloff = 0.1f;
+        DirectX::XMFLOAT3 albedo = DirectX::XMFLOAT3(0.9f, 0.9f, 0.9f);   // Scattering over extinction
+        DirectX::XMFLOAT3 ambient = DirectX::XMFLOAT3(0.05f, 0.06f, 0.08f); // Unshadowed radiance from everywhere
+        float anisotropy = 0.3f;         // Henyey-Greenstein g
+        float temporalBlend = 0.05f;     // Weight of the current frame against the history
+    };
+
+    FroxelFog();
+    ~FroxelFog();
+
+    FroxelFog(const FroxelFog&) = delete;
+    FroxelFog& operator=(const FroxelFog&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings);
+    void Shutdown();
+    const Settings& GetSettings() const { return settings_; }
+
+    // Takes effect on the next Render(); changing the volume size recreates the volumes
+    bool SetSettings(const Settings& settings);
+
+    // Drops the accumulated history, e.g. after a camera cut
+    void ResetHistory() { historyValid_ = false; }
+
+    // view and projection are the row-vector camera matrices of a perspective projection.
+    // lights must have been built for the same camera this frame and shadows updated, with its
+    // targets no longer bound; either may be null, leaving only the ambient term
+    void Render(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, const ClusteredLightCuller* lights,
+                const CascadedShadowMaps* shadows);
+
+    // Integrated RGBA16F volume, valid after Render(): rgb is the light scattered towards the
+    // camera and a the transmittance from the camera to the far end of each slice
+    ID3D11ShaderResourceView* GetIntegratedVolume() const { return integratedView_; }
+
+    // Applies the fog over the width x height top-left region of target, reading the scene's
+    // hardware depth (not bound as depth target). Leaves target bound without depth
+    void Composite(StateCache& stateCache, ID3D11ShaderResourceView* depth, ID3D11RenderTargetView* target,
+                   UINT width, UINT height);
+
+private:
+    bool CreateShaders();
+    bool CreateVolumes();
+    void ReleaseVolumes();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    Settings settings_;
+
+    ID3D11ComputeShader* injectShader_;
+    ID3D11ComputeShader* integrateShader_;
+    ID3D11VertexShader* fullscreenShader_;
+    ID3D11PixelShader* compositeShader_;
+    ID3D11Buffer* constants_;
+    ID3D11SamplerState* linearClamp_;
+    ID3D11SamplerState* shadowCompare_;
+    ID3D11BlendState* compositeBlend_;
+    ID3D11RasterizerState* rasterizerState_;
+    ID3D11DepthStencilState* depthState_;
+
+    // Scattering and extinction per froxel, ping-ponged every frame
+    ID3D11Texture3D* scattering_[2];
+    ID3D11ShaderResourceView* scatteringViews_[2];
+    ID3D11UnorderedAccessView* scatteringTargets_[2];
+    UINT historyIndex_;
+    bool historyValid_;
+
+    ID3D11Texture3D* integrated_;
+    ID3D11ShaderResourceView* integratedView_;
+    ID3D11UnorderedAccessView* integratedTarget_;
+
+    DirectX::XMFLOAT4X4 previousViewProjection_;
+    DirectX::XMFLOAT4X4 projection_;  // Of the last Render(), for Composite()
+    UINT frame_;
+};
+
+} // namespace Nexus
@@ -1,11 +1,16 @@
 #pragma once
 
+#include <condition_variable>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <map>
+#include <mutex>
 #include <DirectXMath.h>
 #include "Logger.h"
+#include "TransformHierarchy.h"
 
 using namespace DirectX;
 
@@ -16,6 +21,8 @@ class Mesh;
 class Material;
 class Texture;
 class Engine;
+class ImportCache;
+class JobSystem;
 
 /**
  * Universal Game Import System
@@ -51,9 +58,14 @@ public:
         bool preserveHierarchy = true;
         bool optimizeMeshes = true;
         bool generateLODs = false;
+        bool bakeCollision = true;      // Static triangle-mesh colliders beside baked meshes
         float scaleMultiplier = 1.0f;
         std::string outputDirectory = "imported_assets/";
         std::string scriptLanguage = "cpp"; // cpp, lua, python
+        unsigned int maxThreads = 0;    // Assets converted at once; 0 for one per core
+        unsigned int maxConcurrentIO = 4;   // Of those, how many may be reading or writing files
+        bool incremental = true;        // Skip assets unchanged since the last import into outputDirectory
+        std::string sharedCacheDirectory;   // Converted assets shared between machines; empty for none
     };
 
     struct AssetInfo {
@@ -118,7 +130,8 @@ private:
     bool ParseUnityScene(const std::string& sceneFile);
     bool ParseUnityPrefab(const std::string& prefabFile);
     bool ParseUnityMaterial(const std::string& materialFile);
-    bool ConvertUnityTransform(const std::map<std::string, std::string>& unityTransform, XMFLOAT3& position, XMFLOAT3& rotation, XMFLOAT3& scale);
+    // Fields of a Transform document, as UnityYamlReader sees them; import scale applied
+    bool ConvertUnityTransform(std::string_view unityTransform, XMFLOAT3& position, XMFLOAT3& rotation, XMFLOAT3& scale);
 
     // Unreal Import Helpers
     bool ParseUnrealLevel(const std::string& levelFile);
@@ -138,6 +151,37 @@ private:
     bool ProcessAudioAsset(const std::string& audioFile, AssetType sourceType);
     bool ProcessAnimationAsset(const std::string& animationFile, AssetType sourceType);
 
+    // Parallel import. Assets convert on a job system of their own in stages, each starting
+    // once everything the stage before it references is done: textures, meshes, audio and
+    // scripts, then materials, then prefabs, then scenes and levels. Converters hold an IOScope
+    // while touching files, which caps disk traffic separately from the thread count
+    using AssetImportFunction = std::function<bool(const std::string& assetPath, AssetInfo& info)>;
+    static constexpr int IMPORT_STAGES = 4;
+    static int GetImportStage(const std::string& extension);
+    void ImportAssets(const std::vector<std::string>& assetPaths, const AssetImportFunction& importAsset);
+    bool ImportUnityAsset(const std::string& assetPath, const ImportSettings& settings, AssetInfo& info);
+    bool ImportUnrealAsset(const std::string& assetPath, const ImportSettings& settings, AssetInfo& info);
+    bool ImportGodotAsset(const std::string& assetPath, const ImportSettings& settings, AssetInfo& info);
+
+    class IOScope {
+    public:
+        explicit IOScope(GameImporter& importer);
+        ~IOScope();
+        IOScope(const IOScope&) = delete;
+        IOScope& operator=(const IOScope&) = delete;
+    private:
+        GameImporter& importer_;
+    };
+
+    // Incremental import (ImportCache). An asset is skipped when neither it, nor anything it
+    // references, nor the settings changed since it was last imported
+    void BeginIncrementalImport(const std::string& projectPath, const ImportSettings& settings);
+    void EndIncrementalImport();
+    bool ImportFromCache(const std::string& assetPath);
+    void CacheImport(const std::string& assetPath, AssetInfo& info);
+    std::vector<std::string> ScanDependencies(const std::string& assetPath);
+    void ScanUnityGuids();
+
     // File System Helpers
     bool CopyAssetFile(const std::string& sourcePath, const std::string& destinationPath);
     bool CreateDirectoryStructure(const std::string& path);
@@ -155,6 +199,17 @@ private:
     std::vector<std::string> importErrors_;
     std::vector<std::string> importWarnings_;
     std::map<std::string, std::string> assetMapping_; // original -> nexus path mapping
+
+    std::unique_ptr<ImportCache> cache_;
+    std::string projectPath_;
+    std::map<std::string, std::string> unityGuids_;   // .meta guid -> asset path
+    bool unityGuidsScanned_;
+    size_t cachedAssets_;
+
+    std::mutex ioMutex_;
+    std::condition_variable ioCondition_;
+    unsigned int ioSlots_;
+    JobSystem* importJobs_;                           // While ImportAssets runs; converters may split work over it
 };
 
 /**
@@ -179,8 +234,18 @@ public:
     };
 
     static bool ParseMetaFile(const std::string& metaFile, UnityAsset& asset);
-    static bool ParseSceneFile(const std::string& sceneFile, std::vector<UnityGameObject>& gameObjects);
-    static bool ParsePrefabFile(const std::string& prefabFile, UnityGameObject& prefab);
+    // Root objects in file order, children nested. Only GameObjects and their transforms are
+    // read; other components are named by type. Documents parse on jobs when given
+    static bool ParseSceneFile(const std::string& sceneFile, std::vector<UnityGameObject>& gameObjects,
+                               JobSystem* jobs = nullptr);
+    static bool ParsePrefabFile(const std::string& prefabFile, UnityGameObject& prefab, JobSystem* jobs = nullptr);
+    // Local position, Euler rotation in degrees and scale of a Transform document
+    static bool ParseTransform(std::string_view transform, XMFLOAT3& position, XMFLOAT3& rotation, XMFLOAT3& scale);
+    // Adds the object and its children under parent, positions scaled by positionScale (the import
+    // scale multiplier); returns the object's node
+    static TransformHierarchy::NodeID AddToHierarchy(const UnityGameObject& object, TransformHierarchy& hierarchy,
+                                                     TransformHierarchy::NodeID parent = TransformHierarchy::INVALID_NODE,
+                                                     float positionScale = 1.0f);
     static std::string ConvertCSharpToLua(const std::string& csharpCode);
     static std::string ConvertCSharpToCpp(const std::string& csharpCode);
 };
@@ -46,11 +46,16 @@ extern "C" {
     void nexus_destroy_game_object(int id);
     void nexus_set_position(int id, float x, float y, float z);
     void nexus_get_position(int id, float* x, float* y, float* z);
+    // Bulk forms; xyz holds count packed x, y, z triples, entry i for ids[i]
+    void nexus_set_positions(const int* ids, const float* xyz, size_t count);
+    void nexus_get_positions(const int* ids, float* xyz, size_t count);
     
     // Physics
     int nexus_create_physics_body(int gameObjectId, float mass);
     void nexus_apply_force(int bodyId, float x, float y, float z);
     void nexus_set_velocity(int bodyId, float x, float y, float z);
+    void nexus_apply_forces(const int* bodyIds, const float* xyz, size_t count);
+    void nexus_set_velocities(const int* bodyIds, const float* xyz, size_t count);
     
     // Audio
     int nexus_load_sound(const char* filename);
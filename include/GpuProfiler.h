@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+struct ProfileCounterValue;
+
+/**
+ * GPU pass timing using D3D11 timestamp and disjoint queries.
+ *
+ * Queries are kept in a small ring of frames and read back without flushing a few frames
+ * later, so timing never stalls the CPU on the GPU. Resolved passes are reported into the
+ * frame Profiler on the GPU lane, next to the CPU markers. With pipeline statistics on, every
+ * pass also counts the work it submitted, and the top-level passes are recorded as stacked
+ * counter tracks beside the timings, so a capture shows which pass spends the vertices, pixels
+ * and primitives.
+ */
+class GpuProfiler {
+public:
+    // A pass's share of D3D11_QUERY_DATA_PIPELINE_STATISTICS
+    struct PipelineStatistics {
+        uint64_t vertices = 0;              // Read by the input assembler
+        uint64_t primitives = 0;            // Assembled
+        uint64_t vsInvocations = 0;
+        uint64_t psInvocations = 0;
+        uint64_t csInvocations = 0;
+        uint64_t clipperInvocations = 0;    // Primitives sent to the rasterizer
+        uint64_t clipperPrimitives = 0;     // Primitives left after clipping and culling
+    };
+
+    struct PassTiming {
+        const char* name = nullptr;
+        uint16_t depth = 0;
+        float milliseconds = 0.0f;
+        bool hasStatistics = false;
+        PipelineStatistics statistics;
+    };
+
+    GpuProfiler();
+    ~GpuProfiler();
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+    void Shutdown();
+
+    // Frame boundaries, call around everything submitted for the frame
+    void BeginFrame();
+    void EndFrame();
+
+    // Passes may nest; names must have static storage duration
+    void BeginPass(const char* name);
+    void EndPass();
+
+    // Results of the most recently resolved frame
+    const std::vector<PassTiming>& GetLastResolvedPasses() const { return resolvedPasses_; }
+    float GetLastResolvedFrameTime() const { return resolvedFrameTime_; }
+    // Increases each time a frame resolves; tells a new result apart from a repeated one
+    uint64_t GetResolvedFrameCount() const { return resolvedFrames_; }
+    float GetPassTime(const char* name) const;
+
+    // Pipeline statistics for every pass from the next frame on, off by default since each pass
+    // then ends in one more query. Totals cover the whole frame
+    void SetPipelineStatistics(bool enabled) { collectStatistics_ = enabled; }
+    bool IsCollectingPipelineStatistics() const { return collectStatistics_; }
+    bool HasResolvedFrameStatistics() const { return resolvedHasStatistics_; }
+    const PipelineStatistics& GetLastResolvedFrameStatistics() const { return resolvedStatistics_; }
+
+    void SetEnabled(bool enabled) { enabled_ = enabled; }
+    bool IsEnabled() const { return enabled_; }
+
+private:
+    static constexpr int FRAME_LATENCY = 4;      // Frames in flight before results are read back
+    static constexpr size_t MAX_PASSES_PER_FRAME = 64;
+
+    struct PassQuery {
+        const char* name = nullptr;
+        ID3D11Query* begin = nullptr;
+        ID3D11Query* end = nullptr;
+        ID3D11Query* statistics = nullptr;
+        uint16_t depth = 0;
+    };
+
+    struct FrameQueries {
+        ID3D11Query* disjoint = nullptr;
+        ID3D11Query* frameBegin = nullptr;
+        ID3D11Query* frameEnd = nullptr;
+        ID3D11Query* statistics = nullptr;
+        PassQuery passes[MAX_PASSES_PER_FRAME];
+        size_t passCount = 0;
+        uint64_t cpuBeginNs = 0;
+        bool pending = false;
+        bool collectStatistics = false;     // Latched at BeginFrame
+    };
+
+    ID3D11Query* CreateQuery(D3D11_QUERY type);
+    void ResolveFrame(FrameQueries& frame);
+    bool ReadStatistics(ID3D11Query* query, PipelineStatistics& statistics);
+    void RecordStatisticsCounters(uint64_t timeNs);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    FrameQueries frames_[FRAME_LATENCY];
+    int frameIndex_;
+    bool inFrame_;
+    bool enabled_;
+    bool collectStatistics_;
+    bool initialized_;
+
+    std::vector<size_t> openPasses_; // Indices into the current frame's passes
+    std::vector<PassTiming> resolvedPasses_;
+    float resolvedFrameTime_;
+    uint64_t resolvedFrames_;
+    PipelineStatistics resolvedStatistics_;
+    bool resolvedHasStatistics_;
+    std::vector<ProfileCounterValue> counterValues_;  // Scratch for the counter tracks
+};
+
+/**
+ * RAII helper for a GPU pass
+ */
+class GpuProfileScope {
+public:
+    GpuProfileScope(GpuProfiler* profiler, const char* name) : profiler_(profiler) {
+        if (profiler_) profiler_->BeginPass(name);
+    }
+    ~GpuProfileScope() {
+        if (profiler_) profiler_->EndPass();
+    }
+
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+    GpuProfiler* profiler_;
+};
+
+} // namespace Nexus
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "Platform.h"
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
+
+struct IDXGIAdapter3;
+struct ID3D11On12Device;
 
 namespace Nexus {
 
@@ -11,15 +16,45 @@ class Texture;
 class Shader;
 class Camera;
 class Light;
+class GpuProfiler;
+class StateCache;
+class ConstantBufferRing;
+class CommandRecorder;
+class OcclusionCuller;
+class TextureStreamingEngine;
+class BloomRenderer;
+class DynamicResolution;
+class TemporalAA;
+class OverdrawVisualizer;
+class SpriteBatcher;
+class RenderGraph;
+class MaterialTable;
+class D3D12Device;
+class JobSystem;
+struct CommandContext;
+struct GpuMemoryStats;
 
 /**
  * DirectX 11 Graphics Device implementation
+ *
+ * On the D3D12 backend the device, queue and swap chain are a D3D12Device's, and the D3D11
+ * device renderers use is layered on them (11on12), so they run unchanged while passes move to
+ * the command graph, which records D3D12 command lists in parallel with bindless resources.
  */
 class GraphicsDevice {
 public:
+    enum class Backend { D3D11, D3D12 };
+
     GraphicsDevice();
     ~GraphicsDevice();
 
+    // Must be set before Initialize(). D3D12 falls back to D3D11 where the adapter lacks
+    // bindless support; GetBackend() then says which one is running
+    void SetBackend(Backend backend) { backend_ = backend; }
+    Backend GetBackend() const { return backend_; }
+    // Records command graph passes in parallel; set before Initialize()
+    void SetJobSystem(JobSystem* jobs) { jobs_ = jobs; }
+
     // Initialization
     bool Initialize(HWND windowHandle, int width, int height, bool fullscreen = false);
     void Shutdown();
@@ -28,15 +63,43 @@ public:
     ID3D11Device* GetDevice() const { return device_; }
     ID3D11DeviceContext* GetContext() const { return context_; }
     IDXGISwapChain* GetSwapChain() const { return swapChain_; }
+    GpuProfiler* GetGpuProfiler() const { return gpuProfiler_.get(); }
+    // Redundant-state filter in front of the immediate context; any renderer binding state on
+    // the context should go through it so the tracked state stays correct
+    StateCache* GetStateCache() const { return stateCache_.get(); }
+    // Per-draw constant memory, bind allocations with StateCache::*SetConstantBuffers1
+    ConstantBufferRing* GetConstantBufferRing() const { return constantRing_.get(); }
+    // Immediate context bundled like a deferred recording target
+    CommandContext GetImmediateCommandContext() const;
+
+    // Parallel submission: deferred contexts for recording passes on worker threads, null
+    // until EnableParallelSubmission succeeds
+    bool EnableParallelSubmission(unsigned int contextCount);
+    CommandRecorder* GetCommandRecorder() const { return commandRecorder_.get(); }
+    // Deferred contexts start (and the immediate context ends ExecuteCommandList) in default state
+    void BindMainRenderTarget(CommandContext& target);
 
     // Rendering
     void BeginFrame();
     void EndFrame();
     void Present();
+    // Recreates the swap chain buffers and everything sized to the screen; false while the
+    // window is minimized or on failure. Call on the thread that renders
+    bool Resize(int width, int height);
+    // Signaled when the swap chain can take another frame (flip model only, else null); owned
+    // by the device
+    HANDLE GetFrameLatencyWaitable() const { return frameLatencyWaitable_; }
+    // Off presents immediately, tearing on variable refresh rate displays where supported
+    void SetVSync(bool enabled) { vsync_ = enabled; }
+    bool IsTearingSupported() const { return tearingSupported_; }
     void Clear(const DirectX::XMFLOAT4& color);
     void SetViewport(int x, int y, int width, int height);
-    bool IsDeviceLost();
+    // Latched by Present() on DXGI_ERROR_DEVICE_REMOVED or _RESET; any thread may poll it
+    bool IsDeviceLost() const { return deviceLost_.load(std::memory_order_relaxed); }
     bool ResetDevice();
+    // Video memory use and OS budget of the adapter; false where IDXGIAdapter3 is missing
+    // (before Windows 10)
+    bool QueryVideoMemory(GpuMemoryStats& stats) const;
 
     // Texture loading functions
     ID3D11Texture2D* LoadTexture(const std::string& filename);
@@ -53,17 +116,100 @@ public:
     // Primitive rendering
     void InitializePrimitiveRendering();
     void SetupBasicCamera(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& target, const DirectX::XMFLOAT3& up);
+    const DirectX::XMFLOAT4X4& GetViewMatrix() const { return viewMatrix_; }
+    // Draws read the view when they are recorded, so a change before BeginFrame covers the frame
+    void SetViewMatrix(const DirectX::XMFLOAT4X4& view) { viewMatrix_ = view; }
+    const DirectX::XMFLOAT4X4& GetProjectionMatrix() const { return projectionMatrix_; }
     void RenderBox(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& size, const DirectX::XMFLOAT4& color);
     void RenderSphere(const DirectX::XMFLOAT3& position, float radius, const DirectX::XMFLOAT4& color);
     void RenderCapsule(const DirectX::XMFLOAT3& position, float radius, float height, const DirectX::XMFLOAT4& color);
 
+    // Same draws recorded into any context; only read shared resources, so separate contexts
+    // may record concurrently
+    void RecordBox(CommandContext& target, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& size, const DirectX::XMFLOAT4& color);
+    void RecordSphere(CommandContext& target, const DirectX::XMFLOAT3& position, float radius, const DirectX::XMFLOAT4& color);
+    void RecordCapsule(CommandContext& target, const DirectX::XMFLOAT3& position, float radius, float height, const DirectX::XMFLOAT4& color);
+
+    // Batched primitives: Submit* only records an instance, FlushPrimitiveBatch() uploads all
+    // instances once and issues one DrawIndexedInstanced per shape type
+    void SubmitBox(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& size, const DirectX::XMFLOAT4& color);
+    void SubmitSphere(const DirectX::XMFLOAT3& position, float radius, const DirectX::XMFLOAT4& color);
+    void SubmitCapsule(const DirectX::XMFLOAT3& position, float radius, float height, const DirectX::XMFLOAT4& color);
+    // Many instances in one call; a null sizes, radii or colors array means unit size or white
+    void SubmitBoxes(const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* sizes, const DirectX::XMFLOAT4* colors, size_t count);
+    void SubmitSpheres(const DirectX::XMFLOAT3* positions, const float* radii, const DirectX::XMFLOAT4* colors, size_t count);
+    void FlushPrimitiveBatch();
+
+    struct PrimitiveBatchStats {
+        unsigned int drawCalls = 0;
+        unsigned int instances = 0;
+    };
+    const PrimitiveBatchStats& GetPrimitiveBatchStats() const { return batchStats_; }
+
+    // 2D sprites, lines and text in pixels from the back buffer's top-left corner, queued on the
+    // batcher and drawn by FlushSpriteBatch(). Null if it failed to start
+    SpriteBatcher* GetSpriteBatcher() const { return sprites_.get(); }
+    // Loads an image into the sprite atlas and returns its SpriteBatcher texture id; 0 on
+    // failure, which draws as a solid color
+    int LoadSprite(const std::string& filename);
+    // Draws the queued 2D batch over the bound target at output resolution, after UpscaleScene
+    void FlushSpriteBatch();
+
+    // GPU Hi-Z occlusion culling of batched primitives against the previous frame's depth;
+    // returns false when compute support is missing
+    bool SetOcclusionCulling(bool enabled);
+    bool IsOcclusionCulling() const { return occlusionCulling_; }
+    OcclusionCuller* GetOcclusionCuller() const { return occlusionCuller_.get(); }
+    // The scene depth, readable only while the depth target is unbound; null if unsupported
+    ID3D11ShaderResourceView* GetDepthShaderView() const { return depthShaderView_; }
+
+    // Dynamic resolution: the scene renders into a scaled viewport sized from GPU frame time and
+    // UpscaleScene() brings it to the back buffer before UI. Returns false when unavailable
+    bool SetDynamicResolution(bool enabled);
+    DynamicResolution* GetDynamicResolution() const { return dynamicResolution_.get(); }
+    // Temporal anti-aliasing: draws jitter their projection every frame and UpscaleScene()
+    // resolves the scene against the previous frames, upscaling from the dynamic resolution scale
+    // when that is on or from its own ratio in Upscale mode. Returns false when unavailable
+    bool SetTemporalAA(bool enabled);
+    TemporalAA* GetTemporalAA() const { return temporalAA_.get(); }
+    // Upscales or resolves the scene into the back buffer and binds it without depth for UI;
+    // no-op at fixed resolution without temporal anti-aliasing
+    void UpscaleScene();
+
+    // Debug views of what the scene's draws cost to shade (see OverdrawVisualizer): from
+    // BeginFrame the draws through the state caches are counted instead of shaded, and the counts
+    // replace the scene when UpscaleScene, ExecuteRenderGraph or EndFrame comes first. Draws that
+    // bind state on the raw context must take the override from GetStateCache() themselves.
+    // Returns false when unavailable
+    enum class DebugView { None, Overdraw, QuadOvershading };
+    bool SetDebugView(DebugView view);
+    DebugView GetDebugView() const { return debugView_; }
+
+    // Mip streaming for DDS/KTX2 textures, updated in BeginFrame. Null if it failed to start
+    TextureStreamingEngine* GetTextureStreaming() const { return textureStreaming_.get(); }
+    // Shared material parameters and texture arrays, uploaded in BeginFrame. Null if unavailable
+    MaterialTable* GetMaterialTable() const { return materialTable_.get(); }
+
     // Post-processing effects
     void SetBloomEnabled(bool enabled);
+    void SetBloomParameters(float threshold, float intensity);
     void SetHeatHazeEnabled(bool enabled);
     void SetShadowsEnabled(bool enabled);
     void InitializePostProcessing();
+    // Record into the frame's render graph, which owns their intermediate textures; nothing runs
+    // until ExecuteRenderGraph. Bloom adds onto the back buffer in place. Both are no-ops until
+    // InitializePostProcessing
     void RenderBloomPass();
     void RenderHeatHazePass();
+    // Runs the recorded passes and binds the main render target again. EndFrame runs anything
+    // still recorded
+    void ExecuteRenderGraph();
+    RenderGraph* GetRenderGraph() const { return renderGraph_.get(); }
+    // D3D12 backend only, else null. Its command passes run in EndFrame after the D3D11 work of
+    // the frame; import the back buffer (D3D12Device::GetBackBuffer) in the PRESENT state
+    RenderGraph* GetCommandGraph() const { return commandGraph_.get(); }
+    // The device, queue and bindless heaps to share, e.g. with RayTracingEngine; null on D3D11
+    D3D12Device* GetD3D12() const { return d3d12_.get(); }
 
     // Shadow mapping
     void SetShadowMapSize(int size);
@@ -80,6 +226,22 @@ private:
     IDXGISwapChain* swapChain_;
     ID3D11RenderTargetView* renderTargetView_;
     ID3D11DepthStencilView* depthStencilView_;
+    ID3D11ShaderResourceView* depthShaderView_;
+    HANDLE frameLatencyWaitable_;
+    UINT swapChainFlags_;        // Creation flags, which ResizeBuffers must repeat
+    bool tearingSupported_;
+    bool vsync_;
+    std::atomic<bool> deviceLost_;
+    IDXGIAdapter3* adapter_;     // For video memory queries, null if unsupported
+
+    // D3D12 backend
+    Backend backend_;
+    JobSystem* jobs_;
+    std::unique_ptr<D3D12Device> d3d12_;
+    ID3D11On12Device* on12_;
+    ID3D11Resource* wrappedBackBuffers_[2];        // D3D11 views of the D3D12 back buffers
+    ID3D11RenderTargetView* backBufferViews_[2];
+    std::unique_ptr<RenderGraph> commandGraph_;
 
     // Window and display properties
     int width_;
@@ -94,11 +256,10 @@ private:
     float bloomIntensity_;
     int shadowMapSize_;
 
-    // Render target resources
-    ID3D11Texture2D* bloomTexture_;
-    ID3D11RenderTargetView* bloomRenderTarget_;
-    ID3D11Texture2D* heatHazeTexture_;
-    ID3D11RenderTargetView* heatHazeRenderTarget_;
+    // Render target resources. Post-processing intermediates are render graph transients
+    std::unique_ptr<RenderGraph> renderGraph_;
+    bool postProcessing_;
+    std::unique_ptr<BloomRenderer> bloom_;
     ID3D11Texture2D* shadowMap_;
     ID3D11DepthStencilView* shadowMapDepth_;
 
@@ -107,21 +268,75 @@ private:
     ID3D11Buffer* boxIndexBuffer_;
     ID3D11Buffer* sphereVertexBuffer_;
     ID3D11Buffer* sphereIndexBuffer_;
-    ID3D11Buffer* constantBuffer_;
     ID3D11VertexShader* basicVertexShader_;
     ID3D11PixelShader* basicPixelShader_;
     ID3D11InputLayout* basicInputLayout_;
     int sphereIndexCount_;
 
+    // Instanced primitive resources
+    struct PrimitiveInstance {
+        DirectX::XMFLOAT4X4 world;   // Row-major, read as four per-instance float4 rows
+        DirectX::XMFLOAT4 color;
+    };
+
+    ID3D11VertexShader* instancedVertexShader_;
+    ID3D11InputLayout* instancedInputLayout_;
+    ID3D11Buffer* instanceBuffer_;
+    ID3D11ShaderResourceView* instanceView_;   // Raw view for the occlusion cull shader
+    UINT instanceCapacity_;
+    std::vector<PrimitiveInstance> boxInstances_;
+    std::vector<PrimitiveInstance> sphereInstances_;
+    PrimitiveBatchStats batchStats_;
+
+    std::unique_ptr<StateCache> stateCache_;
+    std::unique_ptr<ConstantBufferRing> constantRing_;
+    std::unique_ptr<CommandRecorder> commandRecorder_;
+    std::unique_ptr<OcclusionCuller> occlusionCuller_;
+    bool occlusionCulling_;
+    std::unique_ptr<TextureStreamingEngine> textureStreaming_;
+    std::unique_ptr<MaterialTable> materialTable_;
+    std::unique_ptr<DynamicResolution> dynamicResolution_;
+    std::unique_ptr<TemporalAA> temporalAA_;
+    std::unique_ptr<SpriteBatcher> sprites_;
+    std::unique_ptr<OverdrawVisualizer> overdraw_;
+    DebugView debugView_;
+    bool debugViewPending_;      // The scene is drawing into the counts
+
+    // GPU pass timing
+    std::unique_ptr<GpuProfiler> gpuProfiler_;
+
     // Camera matrices
     DirectX::XMFLOAT4X4 viewMatrix_;
     DirectX::XMFLOAT4X4 projectionMatrix_;
 
     // Helper functions
+    ID3D11RenderTargetView* GetSceneTarget() const;
+    // Area of the scene target the frame covers
+    void GetRenderSize(UINT& width, UINT& height) const;
+    // The camera projection with this frame's temporal jitter, for draws
+    DirectX::XMFLOAT4X4 GetDrawProjection() const;
+    // Ends the debug view's counting and paints the counts over the scene
+    void ResolveDebugView();
+    bool CreateSwapChain(HWND hwnd);
+    bool CreateOn12Device();
+    void CreateFrameLatencyWaitable();
+    bool WrapBackBuffers();
+    bool CreateSizeDependentResources();
+    void ReleaseSizeDependentResources();
+    void ReleasePostProcessing();
     void CreateBoxGeometry();
     void CreateSphereGeometry();
     void CreateBasicShaders();
     void CreateConstantBuffer();
+    void CreateInstancedShaders();
+    void DrawBasicPrimitive(CommandContext& target, ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer, UINT indexCount,
+                            const DirectX::XMMATRIX& world, const DirectX::XMFLOAT4& color);
+    bool EnsureInstanceCapacity(UINT instanceCount);
+    void DrawInstances(const std::vector<PrimitiveInstance>& instances, UINT& firstInstance,
+                       ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer, UINT indexCount,
+                       bool occlusionCulled, UINT argumentsOffset);
+    static void AppendInstance(std::vector<PrimitiveInstance>& instances, const DirectX::XMFLOAT3& position,
+                               const DirectX::XMFLOAT3& scale, const DirectX::XMFLOAT4& color);
 
     // Structs for rendering
     struct ConstantBufferData {
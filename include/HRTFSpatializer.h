@@ -0,0 +1,227 @@
+#pragma once
+
+#include "EngineConfig.h"
+#include "EnvironmentReverb.h"
+#include <cstdint>
+#include <vector>
+
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+#include <phonon.h>
+#endif
+
+namespace Nexus {
+
+class JobSystem;
+
+// Both ears' impulse responses to sound arriving from one direction
+struct HRIRMeasurement {
+    float azimuth;                             // Radians from ahead, positive to the right
+    float elevation;                           // Radians from the horizon, positive up
+    std::vector<float> left;
+    std::vector<float> right;
+};
+
+/**
+ * Head-related transfer functions measured on rings of constant elevation, ready to convolve.
+ *
+ * Build() splits each measurement into the delay before sound reaches each ear and the response
+ * from then on. Responses blended between neighbouring directions then line up instead of smearing
+ * two arrivals into a comb, and the delays are blended on their own. Responses are cut into
+ * partitions of the block size and each is stored as the spectrum of left + i * right, so one
+ * complex multiply applies both ears to a real input. Build() also bakes the filters that decode
+ * an ambisonic bed through the set: each channel's response summed over virtual speakers at the
+ * corners of an icosahedron, delays included. Nothing is allocated after Build().
+ */
+class HRTFSet {
+public:
+    static constexpr uint32_t MAX_DELAY = 64;          // Frames between the ears; later arrivals are clamped
+    static constexpr uint32_t MAX_TAPS = 512;          // Of each response once its delay is taken off
+    static constexpr uint32_t AMBISONIC_ORDER = 2;
+    static constexpr uint32_t AMBISONIC_CHANNELS = (AMBISONIC_ORDER + 1) * (AMBISONIC_ORDER + 1);
+
+    // Up to four measured directions around a direction and how much of each to take
+    struct Neighbours {
+        uint32_t points[4];
+        float weights[4];
+    };
+
+    // A rigid spherical head with pinna echoes, for when no measured set is loaded
+    static std::vector<HRIRMeasurement> SphericalHead(int sampleRate);
+
+    // Measurements must share the sample rate the set is used at. blockFrames must be a power of
+    // two above MAX_DELAY. False if there is nothing to build from
+    bool Build(const std::vector<HRIRMeasurement>& measurements, uint32_t blockFrames);
+    bool IsBuilt() const { return !rings_.empty(); }
+    uint32_t GetBlockFrames() const { return blockFrames_; }
+    uint32_t GetPartitions() const { return partitions_; }
+    uint32_t GetBedPartitions() const { return bedPartitions_; }
+
+    // direction in listener space: x right, y up, z ahead, unit length
+    Neighbours Locate(const float direction[3]) const;
+    // Blends the neighbours' spectra into re and im, GetPartitions() spectra of 2 * block frames,
+    // and their delays in frames into delays, left then right
+    void Interpolate(const Neighbours& neighbours, float* re, float* im, float delays[2]) const;
+
+    // Spectra decoding one ambisonic channel to both ears, GetBedPartitions() of 2 * block frames
+    const float* GetBedRe(uint32_t channel) const { return bedRe_.data() + size_t(channel) * bedPartitions_ * blockFrames_ * 2; }
+    const float* GetBedIm(uint32_t channel) const { return bedIm_.data() + size_t(channel) * bedPartitions_ * blockFrames_ * 2; }
+
+private:
+    struct Ring {
+        float elevation;
+        uint32_t first;                        // Into the points, sorted by azimuth
+        uint32_t count;
+    };
+
+    void LocateInRing(const Ring& ring, float azimuth, uint32_t& a, uint32_t& b, float& t) const;
+
+    uint32_t blockFrames_ = 0;
+    uint32_t partitions_ = 0;
+    uint32_t bedPartitions_ = 0;
+    std::vector<Ring> rings_;                  // Rising elevation
+    std::vector<float> azimuths_;              // Per point
+    std::vector<float> delays_;                // Per point, left then right
+    std::vector<float> re_;                    // Per point, partitions_ spectra
+    std::vector<float> im_;
+    std::vector<float> bedRe_;                 // Per ambisonic channel, bedPartitions_ spectra
+    std::vector<float> bedIm_;
+};
+
+/**
+ * Binaural rendering of spatial voices: HRTF convolution for the loudest, an ambisonic bed for
+ * the rest.
+ *
+ * Voices are submitted each block as a mono signal already attenuated, with their direction from
+ * the listener. Render() ranks them by loudness and gives up to the near voice limit a slot that
+ * convolves them with the response for their direction, interpolated between the measured ones
+ * around it, by uniformly partitioned overlap-save convolution. When a voice moves the block is
+ * convolved with the old and new responses and crossfaded, and the delay to each ear ramps, so
+ * moving sources don't click. Every other voice is encoded into one second order ambisonic bed,
+ * which is decoded to the ears through the set once per block, so the cost past the near voices
+ * is a few multiplies per voice however many there are. Voices crossfade between slot and bed
+ * over a block as they change rank, and a slot keeps its voice until another is clearly louder.
+ *
+ * Slots and the bed are independent, so with a JobSystem they are rendered in parallel on its
+ * workers, the audio thread running its share of them while it waits. With Steam Audio compiled
+ * in, its measured HRTF does the slots' binaural effects and the bed's decode instead, driven the
+ * same way: it is given no simulator and so starts no threads of its own. Prepare() allocates
+ * everything Render() needs.
+ */
+class HRTFSpatializer {
+public:
+    static constexpr uint32_t MAX_NEAR_VOICES = 32;
+    static constexpr uint32_t DEFAULT_NEAR_VOICES = 12;
+
+    HRTFSpatializer();
+    ~HRTFSpatializer();
+
+    HRTFSpatializer(const HRTFSpatializer&) = delete;
+    HRTFSpatializer& operator=(const HRTFSpatializer&) = delete;
+
+    // blockFrames must be a power of two above HRTFSet::MAX_DELAY
+    bool Prepare(int sampleRate, uint32_t blockFrames, uint32_t maxVoices);
+    bool IsPrepared() const { return !voices_.empty(); }
+    void SetNearVoiceLimit(uint32_t count) { nearLimit_ = count < MAX_NEAR_VOICES ? count : MAX_NEAR_VOICES; }
+
+    // Audio thread. The block of mono input to fill for voice, already gained; null if voice is
+    // out of range. direction is from the listener in listener space: x right, y up, z ahead
+    float* Submit(uint32_t voice, const float direction[3], float loudness);
+    // The voice plays a new sound from its next submission, so nothing is carried over
+    void Restart(uint32_t voice);
+    // Adds every voice submitted since the last call into one block of interleaved stereo
+    void Render(float* output, JobSystem* jobs);
+
+private:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    enum class SlotState : uint8_t { Free, Active, Draining };
+
+    struct VoiceState {
+        float direction[3];
+        float loudness;
+        float blend;                           // Share through its slot rather than the bed, 0 or 1
+        float bed[HRTFSet::AMBISONIC_CHANNELS];        // Encoding gains reached at the end of the last block
+        uint32_t slot;
+        uint64_t submitted;                    // Block it was last submitted for
+        bool fresh;                            // Nothing to ramp from
+        bool near;                             // Ranked into a slot this block
+    };
+
+    struct Slot {
+        SlotState state;
+        uint32_t voice;
+        bool fresh;                            // No response or delays to crossfade from
+        bool releasing;                        // Fully in the bed by the end of this block
+        float blendStart;
+        float blendEnd;
+        float direction[3];
+        std::vector<float> output;             // One block of interleaved stereo
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+        IPLBinauralEffect effect = nullptr;
+        std::vector<float> input;
+        std::vector<float> planar;             // Left block then right
+#else
+        HRTFSet::Neighbours neighbours;
+        float delays[2];
+        std::vector<float> history;            // The last two blocks of input
+        std::vector<float> spectraRe;          // Input spectra of the last partitions blocks, a ring
+        std::vector<float> spectraIm;
+        uint32_t newest;
+        std::vector<float> filterRe;           // Response for the current direction
+        std::vector<float> filterIm;
+        std::vector<float> nextRe;             // And for where it has moved to
+        std::vector<float> nextIm;
+        std::vector<float> workRe;             // Transform scratch, two blocks each
+        std::vector<float> workIm;
+        std::vector<float> fadeRe;
+        std::vector<float> fadeIm;
+        std::vector<float> delayLeft;          // Convolved output, read back at each ear's delay
+        std::vector<float> delayRight;
+        uint64_t delayWritten;
+#endif
+    };
+
+    void Rank();
+    void EncodeBed();
+    void ProcessSlot(Slot& slot);
+    void ProcessBed();
+    void ResetSlot(Slot& slot);
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+    void ReleaseSteamAudio();
+#endif
+
+    uint32_t blockFrames_;
+    uint32_t nearLimit_;
+    uint64_t block_;
+    float bedScale_;                           // From N3D encoding gains to what the decode expects
+    uint32_t bedTailBlocks_;                   // Blocks the bed rings on after its last input
+    std::vector<VoiceState> voices_;
+    std::vector<float> inputs_;                // A block per voice
+    std::vector<uint32_t> submitted_;          // Voices submitted this block
+    std::vector<uint32_t> ranked_;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> work_;               // Slots rendering this block, then the bed
+    bool bedActive_;                           // Input this block
+    uint32_t bedTail_;                         // Blocks left of the bed ringing out
+    std::vector<float> bedInput_;              // A block per ambisonic channel
+    std::vector<float> bedOutput_;             // One block of interleaved stereo
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+    IPLContext context_;
+    IPLHRTF hrtf_;
+    IPLAmbisonicsDecodeEffect decode_;
+    std::vector<float> bedPlanar_;
+#else
+    HRTFSet set_;
+    AudioFFT fft_;
+    std::vector<float> bedHistory_;            // Two blocks per ambisonic channel
+    std::vector<float> bedSpectraRe_;          // Per channel, a ring of bed partitions spectra
+    std::vector<float> bedSpectraIm_;
+    uint32_t bedNewest_;
+    std::vector<float> bedWorkRe_;
+    std::vector<float> bedWorkIm_;
+    std::vector<float> bedSumRe_;
+    std::vector<float> bedSumIm_;
+#endif
+};
+
+} // namespace Nexus
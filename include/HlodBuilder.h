@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Platform.h"
+#include "SceneBVH.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Offline hierarchical LOD (HLOD) baking for the static meshes of a level.
+ *
+ * Placements are grouped into square world cells. All meshes of a cell are transformed into
+ * world space and merged into one proxy mesh, which is then simplified and written as
+ * hlod_<x>_<z>.nmesh. Their albedo textures are packed side by side into one atlas,
+ * hlod_<x>_<z>.dds, and the proxy's texture coordinates are remapped into it. Far away, a cell
+ * then costs one draw with one material instead of one per prop. Atlas tiles cannot repeat, so
+ * texture coordinates outside [0, 1] are clamped to their tile.
+ *
+ * A large prop with no other placement within isolationDistance would take a whole proxy for
+ * itself. It gets an octahedral impostor instead: a software rasterizer renders it from
+ * impostorFrames x impostorFrames directions spread over the full sphere into two atlases,
+ * albedo and opacity in impostor_<n>_albedo.dds, and the normal with depth in alpha in
+ * impostor_<n>_normal.dds. Frame (x, y) looks from OctahedralDecode(((x, y) + 0.5) / frames * 2 - 1)
+ * towards the prop's bounding-sphere centre.
+ *
+ * Build() writes hlod.txt, which HlodIndex reads at runtime:
+ *   hlod 1
+ *   cellSize <size>
+ *   proxyDistance <distance>
+ *   proxy <x> <z> <mesh> <atlas> <min xyz> <max xyz>
+ *   impostor <placement> <albedo> <normal> <centre xyz> <radius> <frames>
+ *
+ * A placement list is a text file of lines
+ *   place <mesh> <albedo or -> <position xyz> <rotation xyz, degrees> <scale xyz>
+ * with relative paths resolved against the list's folder. '#' starts a comment.
+ */
+class HlodBuilder {
+public:
+    struct Settings {
+        float cellSize = 64.0f;
+        float proxyDistance = 256.0f;   // Recorded in the index; cells farther away draw their proxy
+        float triangleRatio = 0.1f;     // Proxy triangles as a fraction of the cell's
+        float maxError = 0.01f;         // Simplification error as a fraction of the cell size
+        int atlasSize = 1024;           // Per side, per cell
+        float impostorRadius = 8.0f;    // Props at least this big...
+        float isolationDistance = 32.0f;    // ...with no other placement this close get impostors
+        int impostorFrames = 8;         // Views per side of the octahedral atlas
+        int impostorFrameSize = 128;    // Pixels per side of one view
+    };
+
+    struct Placement {
+        std::string mesh;               // Any source MeshImporter reads
+        std::string texture;            // Albedo; empty for white
+        XMFLOAT3 position = { 0.0f, 0.0f, 0.0f };
+        XMFLOAT3 rotation = { 0.0f, 0.0f, 0.0f };   // Degrees, pitch yaw roll
+        XMFLOAT3 scale = { 1.0f, 1.0f, 1.0f };
+    };
+
+    struct Stats {
+        uint32_t cells = 0;
+        uint32_t impostors = 0;
+        uint64_t sourceTriangles = 0;   // Of the placements merged into proxies
+        uint64_t proxyTriangles = 0;
+    };
+
+    static bool ReadPlacements(const std::string& filename, std::vector<Placement>& placements);
+    // Writes the proxies, atlases, impostors and hlod.txt into outputDirectory
+    static bool Build(const std::vector<Placement>& placements, const std::string& outputDirectory,
+                      const Settings& settings, Stats* stats = nullptr);
+
+    // Unit direction for a point of the [-1, 1]^2 octahedral square
+    static XMFLOAT3 OctahedralDecode(float x, float y);
+};
+
+/**
+ * A baked hlod.txt at runtime: decides which cells and props draw their stand-ins.
+ *
+ * A cell switches to its proxy once its nearest point is beyond proxyDistance from the camera,
+ * so the switch happens at the same distance whichever side the camera approaches from. The
+ * caller then skips the cell's own placements and draws the proxy mesh with its atlas.
+ */
+class HlodIndex {
+public:
+    struct Proxy {
+        int32_t x = 0, z = 0;
+        std::string mesh;               // Paths as written, relative to the index's folder
+        std::string atlas;
+        AABB bounds = {};
+    };
+
+    struct Impostor {
+        uint32_t placement = 0;         // Index into the placement list that was built
+        std::string albedo;
+        std::string normal;
+        XMFLOAT3 center = { 0.0f, 0.0f, 0.0f };
+        float radius = 0.0f;
+        int frames = 0;
+    };
+
+    bool Load(const std::string& filename);
+
+    float GetCellSize() const { return cellSize_; }
+    float GetProxyDistance() const { return proxyDistance_; }
+    void SetProxyDistance(float distance) { proxyDistance_ = distance; }
+
+    const std::vector<Proxy>& GetProxies() const { return proxies_; }
+    const std::vector<Impostor>& GetImpostors() const { return impostors_; }
+
+    bool UsesProxy(const Proxy& proxy, const XMFLOAT3& cameraPosition) const;
+    bool UsesImpostor(const Impostor& impostor, const XMFLOAT3& cameraPosition) const;
+    // Cells to draw as proxies this frame
+    void SelectProxies(const XMFLOAT3& cameraPosition, std::vector<const Proxy*>& proxies) const;
+
+private:
+    float cellSize_ = 0.0f;
+    float proxyDistance_ = 0.0f;
+    std::vector<Proxy> proxies_;
+    std::vector<Impostor> impostors_;
+};
+
+} // namespace Nexus
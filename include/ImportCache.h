@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Incremental import database for GameImporter.
+ *
+ * Each source is imported under a key hashing its contents, the import settings, the converter
+ * version, its path in the project and the keys of everything it depends on, so editing a
+ * texture changes the key of the materials and scenes using it and they import again, while
+ * unchanged assets are skipped. Content hashes are only recomputed for files whose size or write
+ * time changed since the last run.
+ *
+ * The database lives in the output directory. A shared directory, if given, is a content
+ * addressed store other machines fill as well: outputs are published there under their key and a
+ * local miss copies them back instead of converting, as long as the key matches.
+ */
+class ImportCache {
+public:
+    // Bump when any converter's output changes, which invalidates every entry
+    static constexpr uint32_t CONVERTER_VERSION = 1;
+
+    struct Entry {
+        uint64_t size = 0;                          // Source file, as last hashed
+        int64_t writeTime = 0;
+        uint64_t contentHash = 0;
+        bool dependenciesScanned = false;           // For this content hash
+        std::vector<std::string> dependencies;      // Project relative, '/' separated
+        uint64_t key = 0;                           // Of the last import, 0 if none succeeded
+        uint32_t assetType = 0;
+        std::string asset;                          // The asset's own output, relative to the output directory
+        std::vector<std::string> outputs;           // Every file written, relative to the output directory
+    };
+
+    // A source's path to the paths of the sources it references, as ScanForAssets spells them
+    using DependencyScanner = std::function<std::vector<std::string>(const std::string& source)>;
+
+    // Reads the database of a previous run into the output directory, if there is one. settings
+    // describes the import settings; any change to it changes every key
+    bool Open(const std::string& projectRoot, const std::string& outputDirectory, const std::string& sharedDirectory,
+              const std::string& settings);
+    // Writes the database back; entries for sources that no longer exist are dropped
+    bool Save();
+    void Close();
+
+    // Project relative name of a source path as scanned
+    std::string GetRelativePath(const std::string& source) const;
+
+    // Key the source would be imported under now; 0 if it can't be read. Dependencies are
+    // scanned only when the source's contents changed
+    uint64_t ComputeKey(const std::string& source, const DependencyScanner& scan);
+
+    // The entry of a source last imported under key, with all of its outputs present. Outputs
+    // missing locally are restored from the shared store when it has the key
+    const Entry* Find(const std::string& source, uint64_t key);
+    // Records a successful import and publishes its outputs to the shared store
+    void Store(const std::string& source, uint64_t key, uint32_t assetType, const std::string& asset,
+               const std::vector<std::string>& outputs);
+
+    static uint64_t HashFile(const std::string& path, bool& ok);
+
+private:
+    Entry* Refresh(const std::string& relative);
+    uint64_t ComputeKey(const std::string& relative, const DependencyScanner& scan,
+                        std::unordered_map<std::string, uint64_t>& visiting);
+    bool Fetch(uint64_t key, Entry& entry);
+    void Publish(uint64_t key, const Entry& entry);
+    std::string GetSharedPath(uint64_t key) const;
+
+    std::string projectRoot_;
+    std::string outputDirectory_;
+    std::string sharedDirectory_;
+    uint64_t settingsHash_ = 0;
+    std::unordered_map<std::string, Entry> entries_;            // By project relative path
+    std::unordered_map<std::string, uint64_t> keys_;            // Computed this run
+    bool open_ = false;
+};
+
+} // namespace Nexus
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+/**
+ * Subsystem startup as a dependency graph.
+ *
+ * Each step names the steps it needs; steps with no path between them run concurrently on the
+ * job system. Main-thread steps (for state tied to the thread that creates it) run on the
+ * caller while the graph runs and cannot be depended on. A step whose dependency failed fatally
+ * is skipped. Failures are reported once every step has finished, in declaration order, so the
+ * error logged and the result are the same however the steps were scheduled.
+ */
+class InitGraph {
+public:
+    using StepID = size_t;
+    using StepFunction = std::function<bool()>;
+
+    enum class Failure {
+        Fatal,      // Logged as an error and Run() returns false
+        Warning     // Logged as a warning; dependents still run
+    };
+
+    // failureMessage is logged when the function returns false
+    StepID AddStep(const std::string& name, StepFunction function, const std::vector<StepID>& dependencies,
+                   const std::string& failureMessage, Failure failure = Failure::Fatal);
+    void AddMainThreadStep(const std::string& name, StepFunction function,
+                           const std::string& failureMessage, Failure failure = Failure::Fatal);
+
+    // False when a fatal step failed; an exception thrown by a step is rethrown here, the first
+    // in declaration order, in place of the steps declared after it
+    bool Run(JobSystem& jobs);
+
+private:
+    enum class State {
+        Pending,
+        Succeeded,
+        Failed,
+        Skipped
+    };
+
+    struct Step {
+        std::string name;
+        StepFunction function;
+        std::vector<StepID> dependencies;
+        std::string failureMessage;
+        Failure failure = Failure::Fatal;
+        bool mainThread = false;
+        State state = State::Pending;
+        std::exception_ptr exception;
+        float milliseconds = 0.0f;
+    };
+
+    void RunStep(Step& step);
+
+    std::vector<Step> steps_;
+};
+
+} // namespace Nexus
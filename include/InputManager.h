@@ -4,6 +4,9 @@
 #include <dinput.h>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
 
 namespace Nexus {
 
@@ -17,11 +20,35 @@ enum class KeyCode {
 };
 
 enum class MouseButton {
-    Left = 0, Right = 1, Middle = 2
+    Left = 0, Right = 1, Middle = 2, X1 = 3, X2 = 4
+};
+
+enum class InputEventType : uint8_t {
+    KeyDown, KeyUp,                            // code: KeyCode scan code
+    MouseButtonDown, MouseButtonUp,            // code: MouseButton
+    MouseMove,                                 // x, y: relative motion in mouse counts
+    MouseWheel,                                // y: WHEEL_DELTA units
+    ControllerButtonDown, ControllerButtonUp,  // code: XINPUT_GAMEPAD_* bit
+    ControllerConnected, ControllerDisconnected
+};
+
+struct InputEvent {
+    InputEventType type;
+    uint8_t controller;                        // Controller events only
+    uint16_t code;
+    int32_t x, y;
+    int64_t timestamp;                         // QueryPerformanceCounter ticks
 };
 
 /**
- * Input management system for keyboard, mouse, and game controllers
+ * Input management system for keyboard, mouse, and game controllers.
+ *
+ * Keyboard and mouse come in through Raw Input: the window procedure hands every WM_INPUT to
+ * HandleRawInput(), which queues a timestamped event. Update() makes the queued events the
+ * frame's events and applies them to the key and button state, so a press and release between
+ * two frames still reads as pressed and released on the next one, and gameplay that cares about
+ * timing can walk GetEvents() in order with each event's time. Controllers are XInput pads,
+ * polled by Update(). Without Raw Input the keyboard and mouse fall back to polling.
  */
 class InputManager {
 public:
@@ -33,6 +60,24 @@ public:
     void Shutdown();
     void Update();
 
+    // Call from the window procedure for WM_INPUT, on the thread that calls Update()
+    void HandleRawInput(WPARAM wParam, LPARAM lParam);
+    // Everything that arrived before the last Update(), oldest first
+    const std::vector<InputEvent>& GetEvents() const { return frameEvents_; }
+    // Ticks per second of InputEvent::timestamp
+    static int64_t GetTimestampFrequency();
+    // Raw mouse counts queued since Initialize, including motion Update() hasn't applied yet.
+    // Any thread; the difference between two reads is the motion in between
+    void GetMouseMotionTotal(int64_t& x, int64_t& y) const {
+        x = mouseMotionX_.load(std::memory_order_relaxed);
+        y = mouseMotionY_.load(std::memory_order_relaxed);
+    }
+    // Queues event for the next Update() as though it had just arrived, for replaying recorded
+    // input. With live input off, the devices are ignored and only injected events apply
+    void InjectEvent(const InputEvent& event);
+    void SetLiveInput(bool enabled) { liveInput_ = enabled; }
+    bool IsLiveInput() const { return liveInput_; }
+
     // Keyboard input
     bool IsKeyDown(KeyCode key) const;
     bool IsKeyPressed(KeyCode key) const;  // True only on the frame key was pressed
@@ -43,16 +88,30 @@ public:
     bool IsMouseButtonPressed(MouseButton button) const;
     bool IsMouseButtonReleased(MouseButton button) const;
     void GetMousePosition(int& x, int& y) const;
+    // Raw mouse counts this frame with Raw Input, else cursor pixels
     void GetMouseDelta(int& deltaX, int& deltaY) const;
     int GetMouseWheelDelta() const;
 
     // Controller support
+    static constexpr int MAX_CONTROLLERS = 4;
     int GetConnectedControllerCount() const;
     bool IsControllerConnected(int controllerId) const;
+    // XINPUT_GAMEPAD_* bits
+    bool IsControllerButtonDown(int controllerId, uint16_t button) const;
 
 private:
-    void UpdateKeyboard();
-    void UpdateMouse();
+    struct ControllerState {
+        bool connected = false;
+        DWORD packetNumber = 0;
+        uint16_t buttons = 0;
+        int64_t nextProbe = 0;                 // While disconnected; polling absent pads is slow
+    };
+
+    bool RegisterRawInput();
+    void QueueEvent(InputEventType type, uint16_t code, int32_t x = 0, int32_t y = 0, uint8_t controller = 0);
+    void ApplyEvents();
+    void PollKeyboard();
+    void PollMouse();
     void UpdateControllers();
 
     HWND hwnd_;
@@ -60,15 +119,33 @@ private:
     IDirectInputDevice8* keyboard_;
     IDirectInputDevice8* mouse_;
 
-    // Keyboard state
+    bool rawInput_;                            // Else keyboard and mouse are polled
+    bool liveInput_;                           // Off while replaying injected events
+
+    // Events since the last Update(), and the ones Update() handed to the frame
+    std::vector<InputEvent> pendingEvents_;
+    std::vector<InputEvent> frameEvents_;
+    // Down as of the last queued event, to drop auto-repeat and unmatched releases
+    std::bitset<256> keysQueuedDown_;
+    std::bitset<8> buttonsQueuedDown_;
+
+    // Keyboard state, by scan code (0x80 set for E0 extended keys)
     std::array<unsigned char, 256> keyboardState_;
-    std::array<unsigned char, 256> prevKeyboardState_;
+    std::bitset<256> keysPressed_;             // This frame
+    std::bitset<256> keysReleased_;
 
     // Mouse state
-    DIMOUSESTATE mouseState_;
-    DIMOUSESTATE prevMouseState_;
+    DIMOUSESTATE2 mouseState_;
+    std::bitset<8> buttonsPressed_;
+    std::bitset<8> buttonsReleased_;
     int mouseX_, mouseY_;
     int prevMouseX_, prevMouseY_;
+    int mouseDeltaX_, mouseDeltaY_;            // Raw counts this frame, with Raw Input
+    int wheelDelta_;
+    std::atomic<int64_t> mouseMotionX_;        // Written by HandleRawInput only
+    std::atomic<int64_t> mouseMotionY_;
+
+    std::array<ControllerState, MAX_CONTROLLERS> controllers_;
 
     bool initialized_;
 };
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "MemoryTracker.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Counter used to wait on a group of submitted jobs
+ */
+struct JobCounter {
+    std::atomic<int> pending{0};
+
+    bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+enum class JobBackend : uint8_t {
+    Threads,        // Jobs run on the worker's own stack; Wait() inside a job runs other jobs until done
+    Fibers          // Jobs run on pooled fibers; Wait() inside a job parks the fiber and frees the worker
+};
+
+// Where a job would rather run on CPUs with performance and efficiency cores. Only a hint: on CPUs
+// with one kind of core every worker takes every job
+enum class JobAffinity : uint8_t {
+    Any,
+    Performance,    // Latency-critical frame work, never picked up by efficiency-core workers
+    Efficiency      // Background work, preferred by efficiency-core workers and taken last by the rest
+};
+
+/**
+ * Work-stealing job system.
+ *
+ * Every worker owns a deque: the owner pushes and pops at the back (LIFO, cache friendly),
+ * idle workers steal from the front of other deques (FIFO). Threads that are not workers
+ * (the main thread) submit into a shared external queue and help execute jobs while waiting.
+ *
+ * With the fiber backend each worker runs its scheduling loop on one of a fixed pool of fibers.
+ * A job that waits on an unfinished counter parks its fiber and the worker switches to a free one
+ * and carries on, so a dependency chain never ties up a thread; parked fibers resume, on whichever
+ * worker gets to them first, once their counter reaches zero. Job code that waits must not hold a
+ * lock or rely on thread-local state across the Wait().
+ *
+ * On hybrid CPUs workers are given ideal processors fastest cores first, and the ones landing on
+ * efficiency cores take Performance jobs never and Efficiency jobs first.
+ */
+class JobSystem {
+public:
+    using JobFunction = std::function<void()>;
+
+    JobSystem();
+    ~JobSystem();
+
+    // Initialization (workerCount == 0 picks hardware_concurrency - 1). The fiber backend falls
+    // back to threads where fibers can't be created
+    bool Initialize(unsigned int workerCount = 0, JobBackend backend = JobBackend::Threads);
+    void Shutdown();
+
+    // Job submission
+    void Execute(JobFunction job, JobCounter* counter = nullptr, JobAffinity affinity = JobAffinity::Any);
+    void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& function);
+
+    // Waits until the counter reaches zero: parks the calling job's fiber on the fiber backend,
+    // otherwise runs queued jobs in the meantime
+    void Wait(JobCounter& counter);
+
+    // State
+    unsigned int GetWorkerCount() const { return static_cast<unsigned int>(workers_.size()); }
+    unsigned int GetEfficiencyWorkerCount() const;
+    bool IsInitialized() const { return initialized_; }
+    JobBackend GetBackend() const { return backend_; }
+
+    // Index of the calling worker thread, or -1 for non-worker threads
+    static int GetCurrentWorkerIndex();
+
+private:
+    static constexpr uint32_t NO_IDEAL_PROCESSOR = ~0u;
+    static constexpr size_t MIN_FIBER_POOL_SIZE = 128;
+    static constexpr size_t FIBERS_PER_WORKER = 16;
+    static constexpr size_t FIBER_STACK_COMMIT = 64 * 1024;
+    static constexpr size_t FIBER_STACK_RESERVE = 512 * 1024;
+
+    struct Job {
+        JobFunction function;
+        JobCounter* counter = nullptr;
+        MemoryTag memoryTag = MemoryTag::Untagged;   // The submitting thread's, charged while it runs
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    struct Fiber {
+        void* handle = nullptr;
+        JobCounter* waitingOn = nullptr;
+    };
+
+    void WorkerLoop(unsigned int index);
+    bool PopLocal(size_t queueIndex, Job& job);
+    bool PopShared(WorkQueue& queue, Job& job);
+    bool Steal(size_t thiefIndex, Job& job);
+    bool TryRunOne(size_t queueIndex);
+    void RunJob(Job& job);
+    size_t GetQueueIndexForCurrentThread() const;
+    // Picks every worker's ideal processor and finds the ones on efficiency cores
+    void AssignProcessors(unsigned int workerCount);
+
+    // Fiber backend
+    bool CreateFibers(size_t count);
+    void DestroyFibers();
+    static void __stdcall FiberEntry(void* parameter);
+    void FiberLoop();
+    void SwitchFiber(int target, bool parkCurrent);
+    void CompleteFiberSwitch();
+    int TakeFreeFiber();
+    int TakeReadyFiber();
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<WorkQueue>> queues_; // one per worker + one external queue (last)
+    WorkQueue performanceQueue_;                    // Hybrid CPUs only, see JobAffinity
+    WorkQueue efficiencyQueue_;
+    std::vector<uint8_t> efficiencyWorker_;         // By worker, 1 when its ideal processor is an E-core
+    std::vector<uint32_t> idealProcessor_;          // By worker, group << 8 | number
+    bool hybrid_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    std::atomic<int> queuedJobs_;
+    std::atomic<uint32_t> counterCompletions_;      // Wakes fiber workers to resume parked fibers
+    std::atomic<bool> running_;
+    bool initialized_;
+
+    JobBackend backend_;
+    std::vector<Fiber> fibers_;
+    std::mutex fiberMutex_;
+    std::vector<int> freeFibers_;
+    std::vector<int> parkedFibers_;
+    std::atomic<int> parkedFiberCount_;
+};
+
+/**
+ * Dependency graph of tasks executed on the job system.
+ *
+ * Tasks are declared once with their dependencies and the whole graph can then be
+ * executed every frame. Tasks without a dependency path between them run concurrently.
+ */
+class TaskGraph {
+public:
+    using TaskID = size_t;
+    using TaskFunction = std::function<void()>;
+
+    TaskGraph() = default;
+    ~TaskGraph() = default;
+
+    TaskID AddTask(const std::string& name, TaskFunction function, const std::vector<TaskID>& dependencies = {});
+    void Clear();
+
+    // Runs all tasks respecting dependencies; rethrows the first exception raised by a task
+    void Execute(JobSystem& jobs);
+
+    size_t GetTaskCount() const { return tasks_.size(); }
+    const std::string& GetTaskName(TaskID id) const { return tasks_[id].name; }
+
+private:
+    struct Task {
+        std::string name;
+        TaskFunction function;
+        std::vector<TaskID> dependents;
+        int dependencyCount = 0;
+    };
+
+    void Schedule(JobSystem& jobs, TaskID id, JobCounter& counter);
+
+    std::vector<Task> tasks_;
+    std::unique_ptr<std::atomic<int>[]> remaining_;
+    size_t remainingSize_ = 0;
+
+    std::mutex exceptionMutex_;
+    std::exception_ptr firstException_;
+};
+
+} // namespace Nexus
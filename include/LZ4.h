@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+// LZ4 block format codec, shared by PakArchive and BinaryFile. Blocks carry no size, so the
+// container stores the decompressed size alongside
+
+// Replaces out with one LZ4 block holding in
+void CompressLZ4(const uint8_t* in, size_t size, std::vector<uint8_t>& out);
+// False unless in decodes to exactly size bytes
+bool DecompressLZ4(const uint8_t* in, size_t inSize, uint8_t* out, size_t size);
+
+} // namespace Nexus
@@ -36,6 +36,11 @@ public:
     void SetConeAngle(float angle) { coneAngle_ = angle; }
     float GetConeAngle() const { return coneAngle_; }
 
+    // Point and spot lights: distance at which the light fades out completely. Clustered
+    // culling bins lights by this range, so keep it as tight as the scene allows
+    void SetRange(float range) { range_ = range; }
+    float GetRange() const { return range_; }
+
     // Point light specific
     void SetAttenuation(float constant, float linear, float quadratic) {
         attenuationConstant_ = constant;
@@ -43,7 +48,10 @@ public:
         attenuationQuadratic_ = quadratic;
     }
 
-    // Shadow mapping
+    // Shadow mapping. Point and spot lights only get shadows when they cast them; the shadow
+    // atlas then sizes their tiles by screen-space importance
+    void SetCastsShadows(bool castsShadows) { castsShadows_ = castsShadows; }
+    bool CastsShadows() const { return castsShadows_; }
     XMMATRIX GetLightViewMatrix() const;
     XMMATRIX GetLightProjectionMatrix() const;
 
@@ -58,6 +66,8 @@ private:
     XMFLOAT3 direction_;
     XMFLOAT3 color_;
     float intensity_;
+    float range_;
+    bool castsShadows_;
     
     // Spotlight
     float coneAngle_;
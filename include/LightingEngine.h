@@ -17,6 +17,20 @@ class Camera;
 class Mesh;
 class Shader;
 class Texture;
+class StateCache;
+class JobSystem;
+class ClusteredLightCuller;
+class CascadedShadowMaps;
+class ShadowAtlas;
+class BloomRenderer;
+class SSAORenderer;
+class ScreenSpaceReflections;
+class OcclusionCuller;
+class ShadingRateImage;
+class DeferredRenderer;
+class ProbeVolume;
+class DecalSystem;
+class PhysicsEngine;
 
 /**
  * Advanced lighting engine with multiple rendering techniques
@@ -30,6 +44,15 @@ public:
         Ultra = 4096
     };
 
+    // Resolution and samples of the ambient occlusion; Low keeps it affordable on low-spec machines
+    enum class SSAOQuality {
+        Off,
+        Low,       // Quarter resolution, 6 samples
+        Medium,    // Half resolution, 8 samples
+        High,      // Half resolution, 16 samples
+        Ultra      // Full resolution, 16 samples
+    };
+
     enum class LightingModel {
         Phong,
         BlinnPhong,
@@ -46,6 +69,7 @@ public:
         bool enableNormalMapping = true;
         bool enableSpecularMapping = true;
         ShadowQuality shadowQuality = ShadowQuality::Medium;
+        SSAOQuality ssaoQuality = SSAOQuality::Medium;
         float bloomThreshold = 0.8f;
         float bloomIntensity = 1.0f;
         float ambientIntensity = 0.1f;
@@ -79,7 +103,11 @@ public:
     ~LightingEngine();
 
     // Initialization
-    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int screenWidth, int screenHeight);
+    // Bindings go through stateCache when given (share the GraphicsDevice one); otherwise a
+    // private cache is used, which is only correct if nothing else binds on the context.
+    // jobs spreads light clustering across workers
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int screenWidth, int screenHeight,
+                    StateCache* stateCache = nullptr, JobSystem* jobs = nullptr);
     void Shutdown();
     
     // Update
@@ -109,14 +137,14 @@ public:
     void PerformDeferredLightingPass();
     void ApplyBloomEffect();
     void ApplyHeatHazeEffect();
-    void UpdateSelfShadowMaps();
 
     // Shadow mapping
     void EnableShadowMapping(bool enable);
     void SetShadowQuality(ShadowQuality quality);
     void UpdateShadowMaps(Camera* camera, const std::vector<Mesh*>& meshes);
 
-    // Bloom effects
+    // Bloom effects. Compute bloom over a half-resolution mip chain, composited onto the scene
+    // into the bloom texture by ApplyBloomEffect
     void EnableBloom(bool enable);
     void SetBloomParameters(float threshold, float intensity);
     void RenderBloomPass();
@@ -132,31 +160,78 @@ public:
     // Self-shadowing
     void EnableSelfShadowing(bool enable);
 
-    // Cascaded shadow mapping for directional lights
+    // Cascaded shadow mapping for directional lights. Static casters are registered once on
+    // GetCascadedShadowMaps() and cached; dynamic casters are handed over every frame
     void SetupCascadedShadowMaps(int numCascades);
     void UpdateCascadedShadowMaps(Camera* camera, Light* directionalLight);
+    CascadedShadowMaps* GetCascadedShadowMaps() const { return cascadedShadows_.get(); }
+
+    // Point and spot light shadows share one atlas. Lights with Light::CastsShadows() get tiles
+    // sized by screen-space importance; casters are set on GetShadowAtlas() every frame. Leaves
+    // the atlas bound as depth target
+    void UpdateShadowAtlas(Camera* camera);
+    void UpdateShadowAtlas(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+    ShadowAtlas* GetShadowAtlas() const { return shadowAtlas_.get(); }
 
     // Dynamic lighting
     void SetDynamicLightingEnabled(bool enabled);
     void UpdateDynamicLights(float deltaTime);
 
-    // Light culling for performance
+    // Light culling for performance. CullLights bins every light into the clustered grid for
+    // this frame's camera; BindClusteredLights then exposes the lists to PBR_PS
     void CullLights(Camera* camera);
+    void CullLights(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+    void BindClusteredLights();
+    // Lights shaded per cluster at most; the rest of a crowded cluster is dropped
     void SetMaxLightsPerPass(int maxLights);
+    const ClusteredLightCuller* GetClusteredLights() const { return clusteredLights_.get(); }
 
-    // Deferred rendering support
+    // Deferred rendering support, on by default. The G-buffer is DeferredRenderer's compact
+    // layout, written by geometry drawn with PBR_VS and GBuffer_PS after BeginFrame() or by
+    // RenderGBuffer() with the pipeline the caller bound. RenderDeferredLighting() lights it into
+    // the scene texture with the lights of the last CullLights(), which must use the same camera
     void EnableDeferredRendering(bool enable);
     void SetupGBuffer();
     void RenderGBuffer(const std::vector<Mesh*>& meshes);
     void RenderDeferredLighting();
+    DeferredRenderer* GetDeferredRenderer() const { return deferred_.get(); }
 
     // Volumetric lighting
     void EnableVolumetricLighting(bool enable);
     void RenderVolumetricLighting();
 
-    // SSAO (Screen Space Ambient Occlusion)
+    // SSAO (Screen Space Ambient Occlusion). depth is the scene's depth buffer as a shader
+    // resource; the result is full-resolution visibility for the ambient term
     void EnableSSAO(bool enable);
-    void RenderSSAO();
+    void RenderSSAO(ID3D11ShaderResourceView* depth, Camera* camera);
+    void RenderSSAO(ID3D11ShaderResourceView* depth, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+    ID3D11ShaderResourceView* GetSSAOView() const;
+
+    // Variable rate shading, off by default: each lit frame picks per-tile shading rates from its
+    // luminance detail and the next deferred lighting pass lights coarse tiles one pixel per
+    // block. The image's settings are the quality knob
+    void EnableVariableRateShading(bool enable);
+    ShadingRateImage* GetShadingRateImage() const { return shadingRate_.get(); }
+
+    // Irradiance probes replace the flat ambient color in deferred lighting and, with its
+    // PROBE_VOLUME keyword, in PBR_PS (bound by BindClusteredLights). Not owned; null returns to
+    // the flat ambient. UpdateProbeVolume relights the volume's next probes with every light
+    void SetProbeVolume(ProbeVolume* probes) { probes_ = probes; }
+    ProbeVolume* GetProbeVolume() const { return probes_; }
+    void UpdateProbeVolume(const PhysicsEngine* physics);
+
+    // Screen-space reflections, off by default: the raster fallback where RayTracingEngine has no
+    // DXR. Deferred lighting traces them against occlusion's Hi-Z pyramid, which it first rebuilds
+    // from the G-buffer depth, so the culler's next frame culls against the same depth. occlusion
+    // is not owned; without it every pixel reflects the probes or the flat ambient
+    void EnableScreenSpaceReflections(bool enable);
+    void SetOcclusionCuller(OcclusionCuller* occlusion) { occlusion_ = occlusion; }
+    ScreenSpaceReflections* GetScreenSpaceReflections() const { return reflections_.get(); }
+
+    // Clustered decals, binned by CullLights() into the light clusters and bound with them by
+    // BindClusteredLights() for PBR_PS and GBuffer_PS. Not owned; null draws none
+    void SetDecals(DecalSystem* decals) { decals_ = decals; }
+    DecalSystem* GetDecals() const { return decals_; }
 
 private:
     // Core rendering
@@ -168,7 +243,6 @@ private:
 
     // Shadow mapping implementation
     void CreateShadowMap(ShadowMap& shadowMap, int size);
-    void CreateShadowMap(int lightId, int size);
     void DestroyShadowMap(ShadowMap& shadowMap);
     void RenderShadowMapForLight(Light* light, const std::vector<Mesh*>& meshes);
     void SetupShadowMatrices(Light* light, Camera* camera);
@@ -186,34 +260,11 @@ private:
     void BuildLightFrustum(Light* light, LightFrustum& frustum);
     bool TestLightFrustum(const LightFrustum& frustum, const XMFLOAT3& point, float radius);
 
-    // Deferred rendering
-    struct GBuffer {
-        ID3D11Texture2D* albedoTexture;
-        ID3D11Texture2D* normalTexture;
-        ID3D11Texture2D* depthTexture;
-        ID3D11Texture2D* materialTexture;
-        ID3D11Texture2D* positionTexture;
-        ID3D11RenderTargetView* albedoRTV;
-        ID3D11RenderTargetView* normalRTV;
-        ID3D11RenderTargetView* depthRTV;
-        ID3D11RenderTargetView* materialRTV;
-        ID3D11RenderTargetView* positionRTV;
-        ID3D11ShaderResourceView* albedoSRV;
-        ID3D11ShaderResourceView* normalSRV;
-        ID3D11ShaderResourceView* depthSRV;
-        ID3D11ShaderResourceView* materialSRV;
-        ID3D11ShaderResourceView* positionSRV;
-        
-        // DirectX 9 compatibility surface aliases
-        ID3D11RenderTargetView* albedoSurface;
-        ID3D11RenderTargetView* normalSurface;
-        ID3D11RenderTargetView* depthSurface;
-        ID3D11RenderTargetView* materialSurface;
-    };
-
 private:
     ID3D11Device* device_;
     ID3D11DeviceContext* context_;
+    StateCache* stateCache_;
+    std::unique_ptr<StateCache> ownedStateCache_;
     LightingSettings settings_;
     
     // Lights
@@ -221,21 +272,28 @@ private:
     std::vector<Light> lightsVector_;  // For compatibility with implementation
     std::vector<std::shared_ptr<Light>> culledLights_;
     int maxLightsPerPass_;
+    std::unique_ptr<ClusteredLightCuller> clusteredLights_;
+    std::vector<const Light*> lightInput_;  // Every light, gathered for culling and shadows
+    JobSystem* jobs_;
     
     // Shadow mapping
     std::map<Light*, ShadowMap> shadowMaps_;
-    std::vector<ShadowMap> shadowMapsVector_;  // For compatibility with implementation
     LightCascade cascadedShadowMap_;
+    std::unique_ptr<CascadedShadowMaps> cascadedShadows_;
+    std::unique_ptr<ShadowAtlas> shadowAtlas_;
     bool shadowMappingEnabled_;
     
     // Render targets
     ID3D11Texture2D* sceneTexture_;
     ID3D11RenderTargetView* sceneRTV_;
     ID3D11ShaderResourceView* sceneSRV_;
+    ID3D11UnorderedAccessView* sceneTarget_;   // Written by the deferred lighting pass
     ID3D11Texture2D* bloomTexture_;
     ID3D11RenderTargetView* bloomRTV_;
     ID3D11ShaderResourceView* bloomSRV_;
     ID3D11ShaderResourceView* bloomTextureSRV_;
+    ID3D11UnorderedAccessView* bloomTarget_;
+    std::unique_ptr<BloomRenderer> bloom_;
     ID3D11Texture2D* heatHazeTexture_;
     ID3D11RenderTargetView* heatHazeRTV_;
     ID3D11ShaderResourceView* heatHazeSRV_;
@@ -263,7 +321,9 @@ private:
     
     // Deferred rendering
     bool deferredRenderingEnabled_;
-    GBuffer gBuffer_;
+    std::unique_ptr<DeferredRenderer> deferred_;
+    XMFLOAT4X4 cullView_;          // Camera of the last CullLights(), which deferred lighting reuses
+    XMFLOAT4X4 cullProjection_;
     
     // Screen dimensions
     int screenWidth_;
@@ -281,12 +341,22 @@ private:
     
     // SSAO
     bool ssaoEnabled_;
-    ID3D11Texture2D* ssaoTexture_;
-    ID3D11RenderTargetView* ssaoRTV_;
-    ID3D11ShaderResourceView* ssaoSRV_;
-    ID3D11Texture2D* ssaoNoiseTexture_;
-    ID3D11ShaderResourceView* ssaoNoiseSRV_;
-    std::vector<XMFLOAT3> ssaoKernel_;
+    std::unique_ptr<SSAORenderer> ssao_;
+    
+    // Screen-space reflections
+    bool reflectionsEnabled_;
+    std::unique_ptr<ScreenSpaceReflections> reflections_;
+    OcclusionCuller* occlusion_;
+    
+    // Variable rate shading
+    bool variableRateShadingEnabled_;
+    std::unique_ptr<ShadingRateImage> shadingRate_;
+    
+    // Irradiance probes
+    ProbeVolume* probes_;
+    
+    // Decals
+    DecalSystem* decals_;
     
     // Dynamic lighting
     bool dynamicLightingEnabled_;
@@ -295,6 +365,9 @@ private:
 private:
     // Internal helper methods
     bool CreateShadowMaps();
+    void CreateSSAO();
+    ID3D11ShaderResourceView* RenderReflections(FXMMATRIX view, CXMMATRIX projection, const XMFLOAT3& ambient);
+    void GatherLights();
     bool CreateGBuffer();
     void DestroyGBuffer();
 };
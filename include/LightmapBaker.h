@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Platform.h"
+#include "HlodBuilder.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+class Light;
+
+/**
+ * Offline lightmap baking for the static meshes of a level, from the same placement lists as
+ * HlodBuilder.
+ *
+ * Every placement is cut into charts: triangles joined across shared edges while their normals
+ * stay within chartAngle of the chart's first triangle. Each chart is projected onto the plane
+ * of its average normal at texelsPerUnit, and the charts are shelf-packed into one square atlas
+ * with padding texels around each. When they do not fit, the density is lowered until they do.
+ * A placement's vertices are split where charts meet, and the result is written as
+ * lightmap_<n>.nmesh in object space with its lightmap coordinates beside it in
+ * lightmap_<n>.nluv, for Mesh::SetLightmapCoordinates().
+ *
+ * Each covered texel is then path traced against one TriangleMeshCollider of the whole level,
+ * four texels per SSE packet. Paths start cosine-distributed over the texel's normal, add the
+ * lights' direct light with shadow rays at every hit, and continue for bounces hits; a path that
+ * escapes sees the sky. Surfaces reflect a constant albedo, and back faces are black so texels
+ * buried in other geometry do not leak light. The atlas is split into tiles that the job system
+ * traces in parallel, samplesPerPass paths per texel per pass until samples are reached; the
+ * progress function can stop early, and what has converged is still written. Direct light on
+ * the texel itself is noise-free, one shadow ray per light, and is added only after the indirect
+ * light has been denoised by an edge-aware a-trous filter that stays within a chart and weighs
+ * neighbours by normal, position and the noise each texel measured. Finally colour is dilated
+ * into the padding so bilinear filtering never reads unlit texels, and the atlas is written as
+ * BC6H to lightmap.dds.
+ *
+ * Texels hold irradiance divided by pi, the diffuse light to multiply by albedo, in the same
+ * units as LightingSettings' ambient term and ProbeVolume. PBR_PS reads them at TEXTURE_SLOT
+ * under its LIGHTMAP keyword instead of its ambient light. With includeDirect, baked lights
+ * should be left out of the runtime light list for lightmapped meshes.
+ *
+ * Bake() writes lightmaps.txt, which LightmapIndex reads at runtime:
+ *   lightmap 1
+ *   atlas <dds>
+ *   instance <placement> <mesh> <coordinates>
+ *
+ * Lights come from the placement list too, one per line, cone angles in degrees:
+ *   light directional <direction xyz> <color rgb> <intensity>
+ *   light point <position xyz> <color rgb> <intensity> <range>
+ *   light spot <position xyz> <direction xyz> <color rgb> <intensity> <range> <cone angle>
+ */
+class LightmapBaker {
+public:
+    static constexpr UINT TEXTURE_SLOT = 14;
+    static constexpr uint32_t COORDINATES_MAGIC = 0x56554C4E;   // "NLUV"
+    static constexpr uint32_t COORDINATES_VERSION = 1;
+
+    struct Settings {
+        float texelsPerUnit = 4.0f;     // Lowered until the charts fit the atlas
+        int atlasSize = 1024;           // Per side
+        int padding = 2;                // Texels around each chart
+        float chartAngle = 45.0f;       // Degrees
+        UINT samples = 256;             // Paths per texel in total
+        UINT samplesPerPass = 16;
+        UINT bounces = 3;
+        float albedo = 0.5f;            // Reflectance assumed everywhere
+        XMFLOAT3 skyColor = { 0.2f, 0.2f, 0.3f };   // Radiance of paths that escape
+        float maxDistance = 1000.0f;    // Ray length
+        bool includeDirect = true;      // Bake the lights' direct light as well as their bounces
+        UINT denoiseIterations = 3;     // A-trous passes, 0 to keep the raw estimate
+        int quality = 80;               // BC6H encoder effort, 0-100
+    };
+
+    struct Stats {
+        uint32_t instances = 0;
+        uint32_t charts = 0;
+        uint64_t texels = 0;
+        uint64_t paths = 0;
+        float texelsPerUnit = 0.0f;     // The density the charts were packed at
+    };
+
+    // Called after each pass; returning false stops the bake there
+    using ProgressFunction = std::function<bool(UINT pass, UINT passes)>;
+
+    // The light lines of a placement list
+    static bool ReadLights(const std::string& filename, std::vector<Light>& lights);
+    // Writes the atlas, meshes, coordinates and lightmaps.txt into outputDirectory. jobs may be
+    // null to trace on the calling thread
+    static bool Bake(const std::vector<HlodBuilder::Placement>& placements, const std::vector<const Light*>& lights,
+                     const std::string& outputDirectory, const Settings& settings, JobSystem* jobs = nullptr,
+                     Stats* stats = nullptr, const ProgressFunction& progress = nullptr);
+
+    static bool WriteCoordinates(const std::string& filename, const std::vector<XMFLOAT2>& coordinates);
+    static bool ReadCoordinates(const std::string& filename, std::vector<XMFLOAT2>& coordinates);
+};
+
+/**
+ * A baked lightmaps.txt at runtime. The caller loads each instance's mesh with its coordinates,
+ * draws it with the LIGHTMAP permutation and binds the atlas at LightmapBaker::TEXTURE_SLOT.
+ */
+class LightmapIndex {
+public:
+    struct Instance {
+        uint32_t placement = 0;         // Index into the placement list that was baked
+        std::string mesh;               // Paths as written, relative to the index's folder
+        std::string coordinates;
+    };
+
+    bool Load(const std::string& filename);
+
+    const std::string& GetAtlas() const { return atlas_; }
+    const std::vector<Instance>& GetInstances() const { return instances_; }
+
+private:
+    std::string atlas_;
+    std::vector<Instance> instances_;
+};
+
+} // namespace Nexus
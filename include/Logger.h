@@ -1,9 +1,50 @@
 #pragma once
 
+#include <atomic>
+#include <charconv>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <type_traits>
+
+// Logging below this level compiles out: 0 Debug, 1 Info, 2 Warning, 3 Error. Release builds
+// strip Debug unless told otherwise
+#ifndef NEXUS_MIN_LOG_LEVEL
+#ifdef NDEBUG
+#define NEXUS_MIN_LOG_LEVEL 1
+#else
+#define NEXUS_MIN_LOG_LEVEL 0
+#endif
+#endif
+
+// NEXUS_LOG_INFO("Loaded {} ({} bytes)", name, bytes): the arguments are only evaluated and
+// formatted when the level is enabled at run time, and not compiled at all below
+// NEXUS_MIN_LOG_LEVEL. "{}" takes the next argument, "{:.N}" one with N decimals, "{{" and "}}"
+// are braces
+#define NEXUS_LOG_AT(level, ...) \
+    do { \
+        if (::Nexus::Logger::IsEnabled(level)) ::Nexus::Logger::Write(level, __VA_ARGS__); \
+    } while (0)
+
+#if NEXUS_MIN_LOG_LEVEL <= 0
+#define NEXUS_LOG_DEBUG(...) NEXUS_LOG_AT(::Nexus::LogLevel::Debug, __VA_ARGS__)
+#else
+#define NEXUS_LOG_DEBUG(...) ((void)0)
+#endif
+#if NEXUS_MIN_LOG_LEVEL <= 1
+#define NEXUS_LOG_INFO(...) NEXUS_LOG_AT(::Nexus::LogLevel::Info, __VA_ARGS__)
+#else
+#define NEXUS_LOG_INFO(...) ((void)0)
+#endif
+#if NEXUS_MIN_LOG_LEVEL <= 2
+#define NEXUS_LOG_WARNING(...) NEXUS_LOG_AT(::Nexus::LogLevel::Warning, __VA_ARGS__)
+#else
+#define NEXUS_LOG_WARNING(...) ((void)0)
+#endif
+#define NEXUS_LOG_ERROR(...) NEXUS_LOG_AT(::Nexus::LogLevel::Error, __VA_ARGS__)
 
 namespace Nexus {
 
@@ -14,27 +55,99 @@ enum class LogLevel {
     Error
 };
 
+// When the log file is flushed to disk
+enum class LogFlushPolicy {
+    Immediate,                                 // Every message, before the call returns
+    OnError,                                   // On errors, Flush() and every flush interval
+    Interval                                   // Every flush interval and on Flush() only
+};
+
+/**
+ * Static logger with a background writer.
+ *
+ * A call copies its message into a lock-free ring with the time and level and returns; nothing
+ * is formatted or written on the calling thread. The writer thread, started by the first
+ * message, drains the ring every few milliseconds, formats the timestamps and writes each batch
+ * to the console and the log file with one write apiece. Under the default policy Error() returns
+ * once its message is on disk. Any thread may log. When the ring is full, errors wait for room
+ * and other messages are dropped and counted. Long messages are cut to MAX_MESSAGE_LENGTH.
+ */
 class Logger {
 public:
+    static constexpr size_t MAX_MESSAGE_LENGTH = 480;
+
     static void Initialize(const std::string& filename = "nexus.log");
     static void Shutdown();
-    
+
     static void Debug(const std::string& message);
     static void Info(const std::string& message);
     static void Warning(const std::string& message);
     static void Error(const std::string& message);
-    
+
+    // Waits until everything logged so far is written and flushed
+    static void Flush();
+
+    // Formats into a per-thread buffer and logs; the NEXUS_LOG_* macros check the level first
+    template <typename... Args>
+    static void Write(LogLevel level, std::string_view format, const Args&... args) {
+        thread_local std::string message;
+        message.clear();
+        const FormatArgument arguments[] = { FormatArgument(args)..., FormatArgument() };
+        FormatMessage(message, format, arguments, sizeof...(Args));
+        Log(level, message);
+    }
+
     static void SetLogLevel(LogLevel level) { logLevel_ = level; }
+    // Lets hot paths skip building messages that would be filtered out
+    static bool IsEnabled(LogLevel level) { return level >= logLevel_.load(std::memory_order_relaxed); }
     static void SetConsoleOutput(bool enable) { consoleOutput_ = enable; }
+    static void SetFlushPolicy(LogFlushPolicy policy) { flushPolicy_ = policy; }
+    static void SetFlushInterval(int milliseconds) { flushIntervalMs_ = milliseconds > 0 ? milliseconds : 1; }
 
 private:
+    friend class LogWriter;
+
+    // One argument of Write(), by reference, formatted only once the message is built
+    struct FormatArgument {
+        enum class Type { None, Signed, Unsigned, Double, Bool, Char, Text, Pointer } type = Type::None;
+        union {
+            int64_t signedValue;
+            uint64_t unsignedValue;
+            double doubleValue;
+            bool boolValue;
+            char charValue;
+            const void* pointer;
+        };
+        std::string_view text;
+
+        FormatArgument() : signedValue(0) {}
+        FormatArgument(bool value) : type(Type::Bool), boolValue(value) {}
+        FormatArgument(char value) : type(Type::Char), charValue(value) {}
+        FormatArgument(const char* value) : type(Type::Text), signedValue(0), text(value ? value : "(null)") {}
+        FormatArgument(const std::string& value) : type(Type::Text), signedValue(0), text(value) {}
+        FormatArgument(std::string_view value) : type(Type::Text), signedValue(0), text(value) {}
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, int> = 0>
+        FormatArgument(T value) : type(Type::Signed), signedValue(value) {}
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T>, int> = 0>
+        FormatArgument(T value) : type(Type::Unsigned), unsignedValue(value) {}
+        template <typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+        FormatArgument(T value) : type(Type::Double), doubleValue(value) {}
+        template <typename T, std::enable_if_t<std::is_enum_v<T>, int> = 0>
+        FormatArgument(T value) : FormatArgument(static_cast<std::underlying_type_t<T>>(value)) {}
+        template <typename T>
+        FormatArgument(T* value) : type(Type::Pointer), pointer(value) {}
+    };
+
+    static void FormatMessage(std::string& out, std::string_view format, const FormatArgument* arguments, size_t count);
+
     static void Log(LogLevel level, const std::string& message);
-    static std::string GetTimestamp();
     static std::string LogLevelToString(LogLevel level);
-    
+
     static std::unique_ptr<std::ofstream> logFile_;
-    static LogLevel logLevel_;
-    static bool consoleOutput_;
+    static std::atomic<LogLevel> logLevel_;
+    static std::atomic<bool> consoleOutput_;
+    static std::atomic<LogFlushPolicy> flushPolicy_;
+    static std::atomic<int> flushIntervalMs_;
     static bool initialized_;
 };
 
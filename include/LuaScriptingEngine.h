@@ -8,18 +8,44 @@ extern "C" {
 }
 #endif
 
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
 #include <functional>
 #include <map>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace Nexus {
 
 class Engine;
+class LuaVMPool;
+class FileWatcher;
+
+// A Lua function held in the registry, so calls through it skip the lookup by name. Valid until
+// released or the engine shuts down
+struct LuaFunctionRef {
+    int ref = -1;
+    
+    bool IsValid() const { return ref >= 0; }
+};
+
+// An event name interned once, so triggering it skips hashing the name
+using LuaEventID = uint32_t;
+
+using LuaTaskID = uint32_t;
 
 /**
  * Lua scripting engine for game logic
+ *
+ * Long-running script logic goes in tasks: coroutines started with task_start(fn, ...) that
+ * suspend with wait_frames(n), wait_seconds(s), wait_event(name) or coroutine.yield() (the next
+ * frame). After update() each frame the ready tasks are resumed round-robin until the task
+ * budget is spent, and one that runs past it is suspended where it is and continued next
+ * frame, so no script can make a frame spike.
  */
 class LuaScriptingEngine {
 public:
@@ -31,9 +57,16 @@ public:
     void Shutdown();
 
     // Script execution
+    // Runs a script, from its precompiled .luac when that is at least as new. Compiled chunks
+    // are kept by path and content hash, so running an unchanged file again skips the parser
     bool ExecuteFile(const std::string& filename);
     bool ExecuteString(const std::string& code);
     
+    // Compiles a script to stripped bytecode for ExecuteFile, for build steps. Stripping drops
+    // debug info, so errors from it name no lines
+    static bool CompileFile(const std::string& source, const std::string& output);
+    static std::string GetCompiledPath(const std::string& source);
+    
     // Variable access
     void SetGlobal(const std::string& name, double value);
     void SetGlobal(const std::string& name, const std::string& value);
@@ -48,11 +81,20 @@ public:
     bool CallFunction(const std::string& functionName, double arg);
     bool CallFunction(const std::string& functionName, const std::string& arg);
     
+    // Holds on to the function a global names right now; later reassignments of the global
+    // don't change it. Invalid if the global isn't a function
+    LuaFunctionRef GetFunctionRef(const std::string& functionName);
+    void ReleaseFunctionRef(LuaFunctionRef& function);
+    bool CallFunction(const LuaFunctionRef& function);
+    bool CallFunction(const LuaFunctionRef& function, double arg);
+    bool CallFunction(const LuaFunctionRef& function, const std::string& arg);
+    
     // C function registration
     void RegisterFunction(const std::string& name, lua_CFunction func);
     
-    // Hot reloading
-    void EnableHotReload(bool enable) { hotReloadEnabled_ = enable; }
+    // Hot reloading. Changed scripts are reported by the engine's FileWatcher; without one,
+    // CheckForChanges compares the modification time of every loaded script
+    void EnableHotReload(bool enable);
     void CheckForChanges();
     void ReloadModifiedScripts();
 
@@ -61,11 +103,31 @@ public:
     Engine* GetEngine() const { return engine_; }
 
     // Event system
+    LuaEventID InternEvent(const std::string& eventName);
     void RegisterEventCallback(const std::string& eventName, std::function<void()> callback);
+    void RegisterEventCallback(LuaEventID event, std::function<void()> callback);
     void TriggerEvent(const std::string& eventName);
+    void TriggerEvent(LuaEventID event);
 
     // Update loop
     void Update(float deltaTime);
+    
+    // Script tasks (see above). Started tasks first run in the next Update
+    LuaTaskID StartTask(const LuaFunctionRef& function);
+    void CancelTask(LuaTaskID task);
+    void SetTaskBudget(float milliseconds) { taskBudget_ = std::chrono::duration<double, std::milli>(milliseconds); }
+    size_t GetTaskCount() const { return tasks_.size(); }
+    
+    // Times every Lua function call as a CPU profiler scope named after the function and where it
+    // is defined, so script costs show in the frame timeline. Hooks every call and return, so
+    // it is for profiling sessions, not left on
+    void EnableProfiling(bool enable);
+    bool IsProfilingEnabled() const { return profiling_; }
+    
+    // Entity scripts on their own VMs, run in parallel on the engine's JobSystem after this
+    // state's update. vmCount 0 gives one VM per JobSystem thread
+    bool EnableVMPool(unsigned int vmCount = 0);
+    LuaVMPool* GetVMPool() const { return vmPool_.get(); }
 
     // Get raw Lua state for advanced operations
     lua_State* GetLuaState() const { return L_; }
@@ -74,6 +136,57 @@ private:
     void InitializeLuaBindings();
     void AddToPath(const std::string& path);
     void RegisterEngineFunctions();
+    // Runs the function and arguments on the stack, logging and popping any error
+    bool ProtectedCall(int argCount, const std::string& what);
+    void SetFileWatcher(FileWatcher* watcher);
+    void WatchScript(const std::string& filename);
+    void OnFileChanged(const std::string& path);
+    
+    // A compiled chunk, held in the registry while cached
+    struct CachedChunk {
+        uint64_t hash;                         // Of the bytes it was compiled from
+        int ref;
+    };
+    
+    struct Task {
+        enum class Wait { Frame, Time, Event };
+        
+        LuaTaskID id;
+        lua_State* thread;
+        int ref;                               // Keeps the thread alive
+        int argCount;                          // On the thread's stack until the first resume
+        Wait wait;
+        uint64_t wakeFrame;
+        double wakeTime;
+        LuaEventID event;
+    };
+    
+    // Around every entry into Lua: closes the function scopes an error or a yield left open
+    struct ProfiledEntry {
+        explicit ProfiledEntry(LuaScriptingEngine& engine);
+        ~ProfiledEntry();
+        
+        LuaScriptingEngine& engine;
+        uint32_t base;
+    };
+    
+    void RegisterTaskFunctions();
+    // The function and argCount arguments on top of L's stack become the task
+    LuaTaskID CreateTask(lua_State* L, int argCount);
+    void RunTasks(float deltaTime);
+    bool IsReady(const Task& task) const;
+    void ReleaseTask(Task& task);
+    
+    static LuaScriptingEngine* GetEngine(lua_State* L);
+    static Task* GetRunningTask(lua_State* L, const char* function);
+    int GetHookMask(bool task) const;
+    void BeginFunctionScope(lua_State* L, lua_Debug* debug);
+    static void Hook(lua_State* L, lua_Debug* debug);
+    static int LuaTaskStart(lua_State* L);
+    static int LuaTaskCancel(lua_State* L);
+    static int LuaWaitFrames(lua_State* L);
+    static int LuaWaitSeconds(lua_State* L);
+    static int LuaWaitEvent(lua_State* L);
     
     Engine* engine_;
     bool initialized_;
@@ -85,8 +198,31 @@ private:
     void* L_; // Placeholder when Lua is disabled
 #endif
     
-    std::map<std::string, std::function<void()>> eventCallbacks_;
+    std::unordered_map<std::string, LuaEventID> eventIds_;
+    std::vector<std::function<void()>> eventCallbacks_;   // By LuaEventID
+    std::vector<const char*> eventScopeNames_;            // By LuaEventID
+    LuaFunctionRef updateFunction_;            // The global update, looked up again after scripts run
+    bool updateFunctionStale_;
     std::map<std::string, long long> scriptModTimes_;
+    std::vector<std::string> modifiedScripts_;   // Reloaded by the next ReloadModifiedScripts
+    FileWatcher* fileWatcher_;
+    uint32_t fileListener_;
+    std::unordered_map<std::string, CachedChunk> chunkCache_;   // By the path it was loaded from
+    std::unique_ptr<LuaVMPool> vmPool_;
+    
+    std::deque<Task> tasks_;                   // Round-robin order; resumed from the front
+    Task* runningTask_;                        // Set while a task runs, for the wait functions
+    bool runningTaskCancelled_;
+    LuaTaskID nextTask_;
+    uint64_t taskFrame_;
+    double taskTime_;                          // Seconds of Update time, what wait_seconds counts
+    std::chrono::duration<double, std::milli> taskBudget_;
+    std::chrono::steady_clock::time_point taskDeadline_;
+    
+    bool profiling_;
+    uint32_t profileDepth_;                    // Function scopes open
+    uint32_t profileBase_;                     // Open when the current entry into Lua began
+    std::map<std::pair<const char*, int>, const char*> profileNames_;   // By source and line defined
 };
 
 } // namespace Nexus
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "LuaScriptingEngine.h"
+#include "Logger.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct lua_State;
+
+namespace Nexus {
+
+class JobSystem;
+
+using LuaEntityID = uint32_t;
+
+// A message to an entity script, handed to its on_message at the start of the next update
+struct LuaMessage {
+    LuaEntityID target;
+    LuaEntityID sender;                        // LuaVMPool::NO_ENTITY when posted from C++
+    std::string name;
+    double number;
+    std::string text;
+    bool isText;
+};
+
+/**
+ * Isolated Lua states that run entity scripts in parallel.
+ *
+ * An entity script returns a table: update(self, dt) runs every frame and on_message(self,
+ * sender, name, value) gets messages, both taken when the entity is added; self.id is the entity.
+ * Each entity stays in the VM that had the fewest entities when it was added, and VMs share
+ * nothing, globals included. Update() runs each VM as one job, so a VM is only ever on one
+ * thread at a time and needs no locks. Scripts reach entities in other VMs with
+ * send(target, name, value), whose messages are routed between VMs on the calling thread before
+ * the next update. Logging from scripts is kept per VM and written out after the update.
+ */
+class LuaVMPool {
+public:
+    static constexpr LuaEntityID NO_ENTITY = 0;
+
+    LuaVMPool();
+    ~LuaVMPool();
+
+    bool Initialize(unsigned int vmCount);
+    void Shutdown();
+
+    // Runs the script in the emptiest VM and keeps the table it returns. NO_ENTITY on failure
+    LuaEntityID AddEntity(const std::string& filename);
+    void RemoveEntity(LuaEntityID entity);
+
+    // From game code, not during Update
+    void Post(LuaEntityID target, const std::string& name, double value);
+    void Post(LuaEntityID target, const std::string& name, const std::string& value);
+
+    // One job per VM on jobs, or every VM in turn on this thread without it
+    void Update(float deltaTime, JobSystem* jobs);
+
+    unsigned int GetVMCount() const { return static_cast<unsigned int>(vms_.size()); }
+    size_t GetEntityCount() const { return entityVMs_.size(); }
+
+private:
+    struct Entity {
+        LuaEntityID id;
+        int table;                             // Registry ref of the script's table
+        LuaFunctionRef update;
+        LuaFunctionRef onMessage;
+        bool failed;                           // Stopped after an error, so it isn't logged every frame
+    };
+
+    struct VM {
+        lua_State* L = nullptr;
+        std::vector<Entity> entities;
+        std::unordered_map<LuaEntityID, size_t> index;   // Into entities
+        std::unordered_map<std::string, int> chunks;     // Compiled scripts by filename, registry refs
+        std::vector<LuaMessage> inbox;
+        std::vector<LuaMessage> outbox;                  // From send(), routed before the next update
+        std::vector<std::pair<LogLevel, std::string>> logs;
+        LuaEntityID current = NO_ENTITY;                 // Whose code is running, the sender of send()
+    };
+
+    void UpdateVM(VM& vm, float deltaTime);
+    bool Call(VM& vm, Entity& entity, int argCount);
+    void FlushLogs();
+
+    static VM* GetVM(lua_State* L);
+    static int LuaSend(lua_State* L);
+    static int LuaLog(lua_State* L);
+
+    std::vector<std::unique_ptr<VM>> vms_;
+    std::unordered_map<LuaEntityID, uint32_t> entityVMs_;
+    LuaEntityID nextEntity_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Nexus {
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * Pages are faulted in by the OS as they are touched, so parsers can hand pointers into the
+ * mapping straight to APIs that copy the data (D3D11 initial data, for example) without reading
+ * the file into an intermediate buffer first. Pointers are valid until Close().
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const { return data_ != nullptr; }
+    const uint8_t* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+
+private:
+    void* file_;      // HANDLE
+    void* mapping_;   // HANDLE
+    const uint8_t* data_;
+    size_t size_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+class Material;
+class StateCache;
+
+/**
+ * GPU-resident table of every registered material.
+ *
+ * Material parameters live in one structured buffer indexed by material ID, and each material's
+ * diffuse, normal, specular and emissive textures are copied into Texture2DArrays shared by all
+ * textures of the same size, format and mip count. Materials whose four maps fall into the same
+ * arrays share a batch key: after one BindBatch() every draw of the batch selects its material
+ * by ID (per instance or per draw argument) instead of rebinding textures and constants, so
+ * such draws can be merged into instanced or indirect batches.
+ *
+ * Textures are copied when a material is registered or updated; streamed textures have no fixed
+ * resource to copy, so materials using one get NO_BATCH and keep binding through Material::Bind.
+ */
+class MaterialTable {
+public:
+    using BatchKey = uint64_t;
+    static constexpr UINT INVALID_MATERIAL = UINT32_MAX;
+    static constexpr BatchKey NO_BATCH = UINT64_MAX;
+    static constexpr UINT TEXTURE_KINDS = 4;           // Diffuse, normal, specular, emissive
+    static constexpr UINT TEXTURE_SLOT = 0;            // First of TEXTURE_KINDS arrays, as Material::Bind
+    static constexpr UINT MATERIAL_BUFFER_SLOT = 4;
+
+    struct Settings {
+        UINT initialMaterials = 256;
+        UINT initialArraySlices = 8;                   // Arrays double when full
+    };
+
+    // Matches MaterialData in GetShaderSource()
+    struct GpuMaterial {
+        DirectX::XMFLOAT4 ambientColor;
+        DirectX::XMFLOAT4 diffuseColor;
+        DirectX::XMFLOAT4 specularColor;
+        DirectX::XMFLOAT4 emissiveColor;
+        UINT slices[TEXTURE_KINDS];                    // Array slice of each map
+        float specularPower;
+        UINT textureMask;                              // Bit per kind with a map
+        float padding[2];
+    };
+
+    struct Stats {
+        uint32_t materials = 0;
+        uint32_t arrays = 0;
+        uint32_t packedTextures = 0;                   // Distinct textures across all arrays
+        uint32_t uploads = 0;                          // Buffer updates in the last Upload()
+    };
+
+    MaterialTable();
+    ~MaterialTable();
+
+    MaterialTable(const MaterialTable&) = delete;
+    MaterialTable& operator=(const MaterialTable&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings);
+    void Shutdown();
+
+    // Assigns the material its ID and packs its textures; registering again updates it
+    UINT Register(Material& material);
+    // Re-reads parameters and textures after the material changed
+    void Update(Material& material);
+    void Remove(Material& material);
+
+    // Sends changed parameters to the GPU; call once per frame before drawing
+    void Upload();
+
+    BatchKey GetBatchKey(UINT materialId) const;
+    // Binds the arrays of a batch and the material buffer for the vertex and pixel stages
+    void BindBatch(StateCache& stateCache, BatchKey key) const;
+
+    ID3D11ShaderResourceView* GetMaterialBuffer() const { return materialView_; }
+    const Stats& GetStats() const { return stats_; }
+
+    // HLSL declarations of the table's bindings with sampling helpers, to prepend to shaders
+    static const char* GetShaderSource();
+
+private:
+    struct ArrayKey {
+        UINT width;
+        UINT height;
+        DXGI_FORMAT format;
+        UINT mipLevels;
+        bool operator==(const ArrayKey& other) const {
+            return width == other.width && height == other.height && format == other.format &&
+                   mipLevels == other.mipLevels;
+        }
+    };
+
+    struct TextureArray {
+        ArrayKey key;
+        ID3D11Texture2D* texture = nullptr;
+        ID3D11ShaderResourceView* view = nullptr;
+        UINT capacity = 0;
+        std::vector<UINT> freeSlices;
+        UINT used = 0;                                 // Slices handed out so far, free or not
+    };
+
+    struct PackedTexture {
+        uint16_t array;
+        UINT slice;
+        UINT references;
+    };
+
+    struct Entry {
+        Material* material = nullptr;
+        ID3D11Texture2D* textures[TEXTURE_KINDS] = {};  // Sources the slices were copied from
+        BatchKey batch = NO_BATCH;
+    };
+
+    void Pack(UINT id);
+    void Unpack(UINT id);
+    bool Acquire(ID3D11Texture2D* texture, PackedTexture& packed);
+    void ReleaseTexture(ID3D11Texture2D* texture);
+    bool GrowArray(TextureArray& array, UINT capacity);
+    bool EnsureBufferCapacity(UINT materials);
+    void MarkDirty(UINT id);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    Settings settings_;
+
+    std::vector<Entry> entries_;
+    std::vector<GpuMaterial> gpuMaterials_;
+    std::vector<UINT> freeIds_;
+    std::vector<TextureArray> arrays_;
+    std::unordered_map<ID3D11Texture2D*, PackedTexture> packed_;
+
+    ID3D11Buffer* materialBuffer_;
+    ID3D11ShaderResourceView* materialView_;
+    UINT bufferCapacity_;
+    UINT dirtyBegin_;
+    UINT dirtyEnd_;                                    // Exclusive; equal to dirtyBegin_ when clean
+    Stats stats_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Subsystem an allocation is charged to, from the innermost NEXUS_MEMORY_SCOPE on the allocating
+ * thread. Jobs carry the tag of the thread that queued them
+ */
+enum class MemoryTag : uint8_t {
+    Untagged,
+    Physics,
+    AI,
+    Animation,
+    Particles,
+    Audio,
+    Scripting,
+    Resources,
+    Count
+};
+
+/**
+ * Heap use of one tag; current and peak include the tracker's 16-byte header per allocation
+ */
+struct MemoryTagStats {
+    uint64_t currentBytes = 0;
+    uint64_t peakBytes = 0;          // Since start or ResetPeaks()
+    uint64_t liveAllocations = 0;
+    uint64_t totalAllocations = 0;
+};
+
+/**
+ * Video memory from IDXGIAdapter3::QueryVideoMemoryInfo. Local is the adapter's own memory,
+ * non-local system memory it maps; the budgets are what the OS grants this process
+ */
+struct GpuMemoryStats {
+    uint64_t localUsage = 0;
+    uint64_t localBudget = 0;
+    uint64_t nonLocalUsage = 0;
+    uint64_t nonLocalBudget = 0;
+    bool available = false;
+};
+
+/**
+ * Live sampled allocations sharing one callstack
+ */
+struct MemoryAllocationSite {
+    MemoryTag tag = MemoryTag::Untagged;
+    uint64_t bytes = 0;
+    uint32_t allocations = 0;
+    std::vector<void*> callstack;    // Return addresses, innermost first
+};
+
+/**
+ * Per-subsystem heap accounting behind the global operator new and delete.
+ *
+ * With NEXUS_MEMORY_TRACKING_ENABLED the engine replaces every form of operator new/delete; each
+ * allocation gets a 16-byte header recording its size and tag, and the counters are per-tag
+ * relaxed atomics, so any thread may allocate and any thread may read. Memory from malloc, COM
+ * and other DLLs' heaps is not seen. Without the option the stats stay zero.
+ *
+ * Callstack sampling is for leak hunts: once enabled, roughly one allocation per interval bytes
+ * on each thread records its callstack until it is freed, and SaveAllocationReport() writes the
+ * surviving sites, symbolized, largest first.
+ */
+class MemoryTracker {
+public:
+    static constexpr size_t TAG_COUNT = static_cast<size_t>(MemoryTag::Count);
+
+    // False when the build does not hook operator new
+    static bool IsEnabled();
+
+    static MemoryTagStats GetStats(MemoryTag tag);
+    static uint64_t GetTotalBytes();
+    static void ResetPeaks();
+    static const char* GetTagName(MemoryTag tag);
+
+    // Tag of the calling thread's current scope
+    static MemoryTag GetCurrentTag();
+
+    // Bytes between samples per thread, 0 to stop; samples already taken stay until freed
+    static void SetSamplingInterval(uint64_t bytes);
+    static uint64_t GetSamplingInterval();
+    static std::vector<MemoryAllocationSite> GetLiveSites();
+    static bool SaveAllocationReport(const std::string& filename);
+
+    // Published by the engine, which owns the adapter
+    static void SetGpuStats(const GpuMemoryStats& stats);
+    static GpuMemoryStats GetGpuStats();
+
+private:
+    friend class MemoryScope;
+    static MemoryTag SwapCurrentTag(MemoryTag tag);
+};
+
+/**
+ * RAII helper behind NEXUS_MEMORY_SCOPE
+ */
+class MemoryScope {
+public:
+    explicit MemoryScope(MemoryTag tag) : previous_(MemoryTracker::SwapCurrentTag(tag)) {}
+    ~MemoryScope() { MemoryTracker::SwapCurrentTag(previous_); }
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    MemoryTag previous_;
+};
+
+} // namespace Nexus
+
+#define NEXUS_MEMORY_CONCAT_INNER(a, b) a##b
+#define NEXUS_MEMORY_CONCAT(a, b) NEXUS_MEMORY_CONCAT_INNER(a, b)
+#define NEXUS_MEMORY_SCOPE(tag) ::Nexus::MemoryScope NEXUS_MEMORY_CONCAT(nexusMemoryScope_, __LINE__)(tag)
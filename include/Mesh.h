@@ -13,6 +13,7 @@
     #include <d3d9.h>
     #include <d3dx9.h>
 #endif
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -25,36 +26,165 @@ struct Vertex {
     XMFLOAT2 texCoord;
 };
 
+// Vertex layouts a Mesh can upload
+enum class VertexFormat : uint32_t {
+    Full = 0,          // Vertex, 44 bytes
+    Compressed = 1,    // CompressedVertex, 16 bytes
+    Skinned = 2        // SkinnedVertex, 56 bytes; created with CreateFromSkinnedVertices only
+};
+
+// Shader keyword selecting the CompressedVertex decode in the mesh vertex shaders
+constexpr const char* COMPRESSED_VERTEX_KEYWORD = "COMPRESSED_VERTEX";
+
+/**
+ * Quantized vertex. Position is UNORM16 across the mesh bounds (dequantized with the mesh's
+ * position offset and scale), normal and tangent are octahedral-encoded at 8 bits per axis
+ * and UVs are half floats.
+ */
+struct CompressedVertex {
+    uint16_t position[4];       // xyz, w is padding
+    uint8_t normalTangent[4];   // Normal xy, tangent xy
+    uint16_t texCoord[2];
+};
+
+/**
+ * Vertex bound to up to four bones of a skeleton's palette. Weights are UNORM8 and should sum
+ * to 255. SkinningSystem reads these through GetVertexView() and writes posed Vertex data that
+ * every pass then draws with the Full layout.
+ */
+struct SkinnedVertex {
+    XMFLOAT3 position;
+    XMFLOAT3 normal;
+    XMFLOAT3 tangent;
+    XMFLOAT2 texCoord;
+    uint16_t boneIndices[4];
+    uint8_t boneWeights[4];
+};
+
+// One detail level. Levels share the vertex buffer and use disjoint ranges of the index buffer
+struct MeshLod {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;   // Object-space simplification error, 0 at full detail
+};
+
+/**
+ * Cluster of at most MAX_VERTICES vertices and MAX_TRIANGLES triangles of LOD0, stored as a
+ * contiguous index range. Bounds are object-space; the cone is meshopt-style, so a cluster is
+ * entirely back-facing from p when dot(center - p, coneAxis) >= coneCutoff * |center - p| + radius.
+ * The layout is the one MeshletCuller reads on the GPU.
+ */
+struct Meshlet {
+    static constexpr uint32_t MAX_VERTICES = 64;
+    static constexpr uint32_t MAX_TRIANGLES = 124;
+
+    XMFLOAT3 center;
+    float radius;
+    XMFLOAT3 coneAxis;
+    float coneCutoff;        // Sine of the cone half-angle; 1 disables the cone test
+    uint32_t indexOffset;
+    uint32_t triangleCount;
+    uint32_t padding[2];
+};
+
 class Mesh {
 public:
     Mesh();
     ~Mesh();
 
-    // Loading
-    bool LoadFromFile(const std::string& filename, ID3D11Device* device);
+    // Loading. A .nmesh is read straight into the GPU buffers; any other source goes through
+    // MeshImporter and its baked .nmesh beside it, which is rebuilt when the source is newer or
+    // was baked in another vertex format
+    bool LoadFromFile(const std::string& filename, ID3D11Device* device,
+                      VertexFormat format = VertexFormat::Full);
+    bool LoadBinary(const std::string& filename, ID3D11Device* device);
+    // A whole .nmesh already in memory (a pak entry); name is for messages
+    bool LoadBinary(const uint8_t* data, size_t size, const std::string& name, ID3D11Device* device);
     bool CreateFromVertices(const std::vector<Vertex>& vertices, 
                            const std::vector<unsigned int>& indices,
-                           ID3D11Device* device);
+                           ID3D11Device* device,
+                           VertexFormat format = VertexFormat::Full,
+                           const std::vector<MeshLod>& lods = {},
+                           const std::vector<Meshlet>& meshlets = {});
+    bool CreateFromSkinnedVertices(const std::vector<SkinnedVertex>& vertices,
+                                   const std::vector<unsigned int>& indices,
+                                   ID3D11Device* device,
+                                   const std::vector<MeshLod>& lods = {},
+                                   const std::vector<Meshlet>& meshlets = {});
+    // Exchanges the buffers and everything describing them; the world matrix stays
+    void Swap(Mesh& other);
 
-    // Rendering
-    void Render(ID3D11DeviceContext* context);
+    // Input layout for shaders fed by a vertex format
+    static const D3D11_INPUT_ELEMENT_DESC* GetInputLayout(VertexFormat format, UINT& elementCount);
+    static UINT GetVertexStride(VertexFormat format);
+
+    // Rendering; lod is clamped to the levels the mesh has, see MeshLodSelector
+    void Render(ID3D11DeviceContext* context, size_t lod = 0);
+    // Draws with a 32-bit index buffer and arguments produced on the GPU, see MeshletCuller
+    void RenderIndirect(ID3D11DeviceContext* context, ID3D11Buffer* indexBuffer,
+                        ID3D11Buffer* arguments, UINT argumentsOffset);
+    // Draws this mesh's own indices with arguments produced on the GPU; the record picks the level
+    // and instance count, see FoliageRenderer
+    void RenderInstancedIndirect(ID3D11DeviceContext* context, ID3D11Buffer* arguments, UINT argumentsOffset);
+    // Draws vertices SkinningSystem posed into skinnedVertices from baseVertex, Full layout
+    void RenderSkinned(ID3D11DeviceContext* context, ID3D11Buffer* skinnedVertices, UINT baseVertex, size_t lod = 0);
     void SetWorldMatrix(const XMMATRIX& world) { worldMatrix_ = world; }
 
+    // Lightmap coordinates, one per vertex, in a second stream that Render() binds to slot 1 for
+    // the TEXCOORD1 input of LIGHTMAP shaders. See LightmapBaker. False unless the count matches;
+    // reloading the mesh drops them
+    bool SetLightmapCoordinates(const std::vector<XMFLOAT2>& coordinates, ID3D11Device* device);
+    bool HasLightmapCoordinates() const { return lightmapBuffer_ != nullptr; }
+
     // Properties
     int GetVertexCount() const { return vertexCount_; }
-    int GetTriangleCount() const { return indexCount_ / 3; }
-    size_t GetMemoryUsage() const { 
-        return vertices_.size() * sizeof(Vertex) + indices_.size() * sizeof(uint32_t); 
+    int GetTriangleCount() const { return lods_.empty() ? 0 : static_cast<int>(lods_[0].indexCount / 3); }
+    size_t GetMemoryUsage() const { return memoryUsage_; }
+    const XMFLOAT3& GetBoundsMin() const { return boundsMin_; }
+    const XMFLOAT3& GetBoundsMax() const { return boundsMax_; }
+    const std::vector<MeshLod>& GetLods() const { return lods_; }
+
+    // Meshlets exist when the mesh was baked with them; the views are raw buffers for compute
+    bool HasMeshlets() const { return meshletView_ != nullptr; }
+    const std::vector<Meshlet>& GetMeshlets() const { return meshlets_; }
+    ID3D11ShaderResourceView* GetMeshletView() const { return meshletView_; }
+    ID3D11ShaderResourceView* GetIndexView() const { return indexView_; }
+    DXGI_FORMAT GetIndexFormat() const { return indexFormat_; }
+    // Raw view of a Skinned mesh's vertices for the skinning pass, null for other formats
+    ID3D11ShaderResourceView* GetVertexView() const { return vertexView_; }
+
+    // Compressed positions decode as offset + unorm * scale; set these on the shader per draw
+    VertexFormat GetVertexFormat() const { return vertexFormat_; }
+    XMFLOAT3 GetPositionOffset() const { return boundsMin_; }
+    XMFLOAT3 GetPositionScale() const {
+        return XMFLOAT3(boundsMax_.x - boundsMin_.x, boundsMax_.y - boundsMin_.y, boundsMax_.z - boundsMin_.z);
     }
 
 private:
+    // An empty LOD list makes the whole index buffer the only level
+    bool CreateBuffers(const void* vertices, UINT vertexCount, VertexFormat format,
+                       const void* indices, UINT indexCount, DXGI_FORMAT indexFormat,
+                       std::vector<MeshLod> lods, std::vector<Meshlet> meshlets, ID3D11Device* device);
+    bool CreateMeshletViews(const std::vector<Meshlet>& meshlets, UINT indexBytes, ID3D11Device* device);
+    void ReleaseBuffers();
+
     ID3D11Buffer* vertexBuffer_;
+    ID3D11ShaderResourceView* vertexView_;
     ID3D11Buffer* indexBuffer_;
+    ID3D11Buffer* meshletBuffer_;
+    ID3D11ShaderResourceView* meshletView_;
+    ID3D11ShaderResourceView* indexView_;
+    ID3D11Buffer* lightmapBuffer_;
     int vertexCount_;
     int indexCount_;
+    DXGI_FORMAT indexFormat_;
+    VertexFormat vertexFormat_;
+    size_t memoryUsage_;
+    XMFLOAT3 boundsMin_;
+    XMFLOAT3 boundsMax_;
+    std::vector<MeshLod> lods_;
+    std::vector<Meshlet> meshlets_;
     XMMATRIX worldMatrix_;
-    std::vector<Vertex> vertices_;
-    std::vector<unsigned int> indices_;
 };
 
 } // namespace Nexus
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Mesh.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Geometry as it comes out of an importer, before it is uploaded.
+ */
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;   // Empty until GenerateLods, meaning all indices are one level
+    std::vector<Meshlet> meshlets;   // Clusters of LOD0, empty until BuildMeshlets
+    XMFLOAT3 boundsMin = { 0.0f, 0.0f, 0.0f };
+    XMFLOAT3 boundsMax = { 0.0f, 0.0f, 0.0f };
+};
+
+/**
+ * Header of a .nmesh file. The LOD and meshlet tables, vertex and index blocks follow at the given offsets,
+ * the latter two in exactly the layout the GPU buffers use, so Mesh loads a file with a single read.
+ */
+struct MeshFileHeader {
+    static constexpr uint32_t MAGIC = 0x48534D4E;   // "NMSH"
+    static constexpr uint32_t VERSION = 4;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexFormat;   // VertexFormat
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexSize;      // 2 or 4 bytes
+    uint32_t indexCount;
+    uint32_t vertexOffset;
+    uint32_t indexOffset;
+    uint32_t lodCount;
+    uint32_t lodOffset;      // MeshLod[lodCount]
+    uint32_t meshletCount;
+    uint32_t meshletOffset;  // Meshlet[meshletCount]
+    XMFLOAT3 boundsMin;
+    XMFLOAT3 boundsMax;
+};
+
+/**
+ * Offline mesh pipeline: parses source formats, optimizes for the GPU and bakes .nmesh files.
+ *
+ * Supported sources are Wavefront OBJ, glTF 2.0 (.gltf with external or embedded buffers, .glb)
+ * and binary FBX 7.x. All geometry of a file is merged into one mesh in its local space (node
+ * transforms are not applied) and converted from the right-handed source convention to the
+ * engine's left-handed one. Optimize() reorders indices for the post-transform vertex cache
+ * (Forsyth), then sorts cache-friendly clusters outside-in to cut overdraw (Sander et al.), then
+ * reorders vertices by first use for fetch locality, each LOD level separately.
+ *
+ * GenerateLods() builds a chain of quadric-error edge-collapse simplifications (Garland and
+ * Heckbert). Vertices only ever collapse onto existing ones, so every level indexes the shared
+ * vertex buffer. Vertices on UV/normal seams and open borders are locked to keep the silhouette
+ * and texture mapping intact.
+ *
+ * BuildMeshlets() cuts the optimized LOD0 index order into clusters for GPU cluster culling. The
+ * cut is sequential, so clusters inherit the spatial locality of the vertex-cache order and the
+ * index buffer itself stays untouched.
+ */
+class MeshImporter {
+public:
+    static bool Import(const std::string& filename, MeshData& mesh);
+    static bool ImportOBJ(const std::string& filename, MeshData& mesh);
+    static bool ImportGLTF(const std::string& filename, MeshData& mesh);
+    static bool ImportFBX(const std::string& filename, MeshData& mesh);
+
+    // Appends up to maxLods - 1 coarser levels, each aiming at `reduction` of the previous
+    // triangle count, while the error stays within maxError of the bounds diagonal
+    static void GenerateLods(MeshData& mesh, size_t maxLods = 5, float reduction = 0.5f, float maxError = 0.05f);
+    // Collapses edges until targetIndexCount or an error of targetError (object units) is reached
+    static std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                          size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+    static void Optimize(MeshData& mesh);
+    static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+    // threshold > 1 trades cache efficiency for smaller, better sortable clusters
+    static void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                 float threshold = 1.05f);
+    static void OptimizeVertexFetch(MeshData& mesh);
+
+    // Run after Optimize, whose vertex reordering would invalidate the cluster ranges
+    static void BuildMeshlets(MeshData& mesh, uint32_t maxVertices = Meshlet::MAX_VERTICES,
+                              uint32_t maxTriangles = Meshlet::MAX_TRIANGLES);
+    static void ComputeMeshletBounds(const MeshData& mesh, Meshlet& meshlet);
+
+    // Average cache misses per triangle for a FIFO cache (lower is better, 0.5 is ideal)
+    static float ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize = 16);
+
+    static void GenerateNormals(MeshData& mesh);
+    static void GenerateTangents(MeshData& mesh);
+    static void ComputeBounds(MeshData& mesh);
+
+    // Quantizes positions across [boundsMin, boundsMax]; see CompressedVertex
+    static void CompressVertices(const std::vector<Vertex>& vertices, const XMFLOAT3& boundsMin,
+                                 const XMFLOAT3& boundsMax, std::vector<CompressedVertex>& compressed);
+
+    static bool WriteBinary(const std::string& filename, const MeshData& mesh,
+                            VertexFormat format = VertexFormat::Full);
+
+    // Path of the baked cache for a source file (model.obj -> model.obj.nmesh)
+    static std::string GetCachePath(const std::string& sourceFile);
+    static bool IsCacheCurrent(const std::string& sourceFile);
+    // Imports, builds LODs, optimizes, builds meshlets and writes the cache unless it is already current
+    static bool BuildCache(const std::string& sourceFile, VertexFormat format = VertexFormat::Full);
+};
+
+} // namespace Nexus
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+namespace Nexus {
+
+class Camera;
+class Mesh;
+
+/**
+ * Picks a mesh detail level per instance from its size on screen.
+ *
+ * Each LOD stores its object-space simplification error. Scaled by the instance transform and
+ * projected at the instance's distance it becomes an error in pixels; the coarsest level whose
+ * error stays under the threshold is used. The selector is stateless: callers keep the current
+ * level per instance and pass it back in, and a level only changes once its projected error has
+ * moved the hysteresis fraction past the threshold, so instances near a boundary do not pop.
+ */
+class MeshLodSelector {
+public:
+    MeshLodSelector();
+
+    // Call once per frame before Select(); viewportHeight is in pixels
+    void SetView(const Camera& camera, float viewportHeight);
+
+    void SetErrorThreshold(float pixels) { errorThreshold_ = pixels; }
+    void SetHysteresis(float fraction) { hysteresis_ = fraction; }
+    // Values above 1 favour coarser levels, e.g. for lower quality settings
+    void SetLodBias(float bias) { lodBias_ = bias; }
+
+    size_t Select(const Mesh& mesh, DirectX::FXMMATRIX world, size_t currentLod) const;
+
+    // Projected size in pixels of an object-space length at the instance's bounding sphere
+    float ProjectError(const Mesh& mesh, DirectX::FXMMATRIX world, float objectError) const;
+
+private:
+    DirectX::XMFLOAT3 cameraPosition_;
+    float pixelsPerUnit_;   // Viewport height over the view height at unit distance
+    float errorThreshold_;
+    float hysteresis_;
+    float lodBias_;
+};
+
+} // namespace Nexus
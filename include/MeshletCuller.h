@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+
+namespace Nexus {
+
+class Mesh;
+class OcclusionCuller;
+
+/**
+ * GPU cluster culling for meshes baked with meshlets.
+ *
+ * Cull() dispatches one thread group per meshlet of a mesh instance. The group's first thread
+ * tests the meshlet's bounding sphere against the view frustum, its normal cone against the
+ * camera position (whole back-facing clusters) and, when an OcclusionCuller has a pyramid,
+ * against the Hi-Z depth. The triangles of survivors are copied into a shared 32-bit index
+ * buffer and counted into a DrawIndexedInstancedIndirect record, so one indirect draw per
+ * instance renders exactly the visible clusters; see Mesh::RenderIndirect.
+ */
+class MeshletCuller {
+public:
+    struct Stats {
+        uint32_t meshlets = 0;   // Meshlets submitted this frame
+        uint32_t draws = 0;
+    };
+
+    static constexpr UINT MAX_DRAWS_PER_FRAME = 256;
+    static constexpr UINT ARGUMENT_STRIDE = 5 * sizeof(UINT);
+    static constexpr UINT INITIAL_INDEX_CAPACITY = 1u << 20;
+
+    MeshletCuller();
+    ~MeshletCuller();
+
+    MeshletCuller(const MeshletCuller&) = delete;
+    MeshletCuller& operator=(const MeshletCuller&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+    void Shutdown();
+
+    void BeginFrame();
+
+    // world and viewProjection are row-vector matrices; occlusion may be null. argumentsOffset
+    // receives the byte offset of the draw record in GetDrawArguments(). False means the mesh
+    // has no meshlets or the frame is out of space, so draw it with Mesh::Render instead
+    bool Cull(const Mesh& mesh, DirectX::FXMMATRIX world, DirectX::CXMMATRIX viewProjection,
+              const DirectX::XMFLOAT3& cameraPosition, const OcclusionCuller* occlusion, UINT& argumentsOffset);
+
+    ID3D11Buffer* GetIndexBuffer() const { return indexBuffer_; }
+    ID3D11Buffer* GetDrawArguments() const { return argumentsBuffer_; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    bool EnsureIndexCapacity(UINT indexCount);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+
+    ID3D11ComputeShader* cullShader_;
+    ID3D11Buffer* cullConstants_;
+
+    // Compacted indices of every instance culled this frame, each in its own range
+    ID3D11Buffer* indexBuffer_;
+    ID3D11UnorderedAccessView* indexTarget_;
+    UINT indexCapacity_;
+    UINT indicesThisFrame_;
+
+    ID3D11Buffer* argumentsBuffer_;
+    ID3D11UnorderedAccessView* argumentsTarget_;
+    UINT drawsThisFrame_;
+
+    Stats stats_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+/**
+ * CPU mip chain generation for RGBA8 images.
+ *
+ * The base level is converted to float RGBA once and every level is filtered from the previous
+ * float level, so nothing is requantized between levels. Filtering is separable (a horizontal
+ * then a vertical pass) with per-pixel SSE accumulation, and each pass splits its rows across
+ * the job system. sRGB images are filtered in linear light and encoded back to sRGB, which keeps
+ * distant mips from darkening; alpha is always linear. Odd sizes use fractional box coverage
+ * rather than dropping the last row or column.
+ */
+class MipGenerator {
+public:
+    enum class Filter {
+        Box,        // Area average; fast, slightly soft
+        Lanczos3    // Sharper, at the cost of mild ringing on hard edges
+    };
+
+    struct Settings {
+        Filter filter = Filter::Box;
+        bool srgb = false;
+        bool normalMap = false;   // Renormalizes RGB as a [0, 1]-encoded vector after every level
+    };
+
+    struct Level {
+        int width = 0;
+        int height = 0;
+        size_t offset = 0;        // Into the data buffer Generate() fills
+    };
+
+    // Levels in a full chain, including the base
+    static int GetMipCount(int width, int height);
+
+    // Builds mips 1..n of a tightly packed width x height RGBA8 image. data receives every level
+    // back to back with tightly packed rows; levels[i] describes mip i + 1
+    static bool Generate(const uint8_t* pixels, int width, int height, const Settings& settings,
+                         std::vector<uint8_t>& data, std::vector<Level>& levels, JobSystem* jobs = nullptr);
+};
+
+} // namespace Nexus
@@ -1,11 +1,14 @@
 #pragma once
 
 #include "Platform.h"
+#include <atomic>
 #include <vector>
 #include <memory>
 #include <map>
+#include <mutex>
 #include <string>
 #include <functional>
+#include <thread>
 
 #ifdef _WIN32
     #include <xinput.h>
@@ -21,6 +24,8 @@ namespace Nexus {
 // Forward declarations
 class Camera;
 class InputManager;
+class JobSystem;
+struct JobCounter;
 
 // Kinect-specific types and enums
 enum class JointType {
@@ -86,6 +91,12 @@ struct RecognizedGesture {
     std::vector<JointType> jointSequence;
 };
 
+/**
+ * Gesture template. keyPositions are frame-major, one position per jointSequence entry per frame,
+ * spread evenly over timeWindow; they are compared relative to the first joint's first position.
+ * threshold is the largest RMS distance in metres a match may have, motionThreshold the distance
+ * the first joint must travel within the window before the gesture is considered
+ */
 struct GesturePattern {
     std::string name;
     GestureType type;
@@ -116,21 +127,127 @@ struct MotionAimingData {
     bool isActive;
 };
 
-// Kinect-specific gesture recognizer
+/**
+ * Last CAPACITY frames of every joint, one contiguous array per joint and axis so a joint's
+ * trajectory can be walked without touching the others
+ */
+struct JointHistory {
+    static constexpr size_t CAPACITY = 128;
+    static constexpr size_t JOINT_COUNT = static_cast<size_t>(JointType::Count);
+
+    alignas(16) float x[JOINT_COUNT][CAPACITY];
+    alignas(16) float y[JOINT_COUNT][CAPACITY];
+    alignas(16) float z[JOINT_COUNT][CAPACITY];
+    double time[CAPACITY];
+    size_t head = 0;               // Next slot to write
+    size_t count = 0;
+
+    // joints holds JOINT_COUNT positions
+    void Push(const DirectX::XMFLOAT3* joints, double timestamp);
+    void Clear() { head = 0; count = 0; }
+
+    // Age 0 is the newest frame
+    size_t GetSlot(size_t age) const { return (head + CAPACITY - 1 - age) % CAPACITY; }
+    double GetTime(size_t age) const { return time[GetSlot(age)]; }
+
+    // Positions of one joint at samples even steps over [start, end], linearly interpolated and
+    // clamped to the stored frames
+    void Resample(size_t joint, double start, double end, size_t samples,
+                  float* outX, float* outY, float* outZ) const;
+};
+
+/**
+ * One Euro filter over every joint axis: the cutoff rises with speed, so a resting hand stops
+ * jittering while a fast one does not lag
+ */
+class JointFilter {
+public:
+    JointFilter();
+
+    void SetParameters(float minCutoff, float beta, float derivativeCutoff);
+    // Filters JointHistory::JOINT_COUNT positions in place
+    void Filter(DirectX::XMFLOAT3* joints, float deltaTime);
+    void Reset() { primed_ = false; }
+
+private:
+    static constexpr size_t CHANNEL_COUNT = JointHistory::JOINT_COUNT * 3;
+
+    float value_[CHANNEL_COUNT];
+    float derivative_[CHANNEL_COUNT];
+    float minCutoff_;
+    float beta_;
+    float derivativeCutoff_;
+    bool primed_;
+};
+
+/**
+ * Matches joint trajectories against gesture templates with dynamic time warping.
+ *
+ * Update() only queues the frame; matching runs as a job (inline without a job system) that
+ * drains the queue into its own joint history, then scores the templates four at a time in SSE
+ * lanes. Each lane group is skipped when the LB_Keogh bound over its band envelope already
+ * exceeds every lane's threshold, and DTW stops once a whole row does. At most one match job is
+ * in flight; frames arriving meanwhile wait for the next one.
+ */
 class GestureRecognizer {
 public:
-    void AddPattern(const GesturePattern& pattern);
-    std::vector<RecognizedGesture> GetRecognizedGestures() const;
-    void ProcessJoints(const std::vector<DirectX::XMFLOAT3>& joints);
-    void Update(const std::vector<DirectX::XMFLOAT3>& joints, float deltaTime);
+    static constexpr size_t MAX_GESTURE_JOINTS = 2;
+    static constexpr size_t TEMPLATE_SAMPLES = 32;
+
+    GestureRecognizer();
+    ~GestureRecognizer();
+
+    GestureRecognizer(const GestureRecognizer&) = delete;
+    GestureRecognizer& operator=(const GestureRecognizer&) = delete;
+
+    // Patterns without at least two frames of keyPositions are rejected
+    bool AddPattern(const GesturePattern& pattern);
+    // Waits for the match in flight on the previous job system
+    void SetJobSystem(JobSystem* jobs);
+
+    // joints holds JointHistory::JOINT_COUNT filtered positions
+    void Update(const DirectX::XMFLOAT3* joints, double time);
+    // Gestures recognized since the last call
+    std::vector<RecognizedGesture> TakeRecognizedGestures();
     void Reset();
-    
+
 private:
+    struct TemplateGroup;
+
+    struct PendingFrame {
+        DirectX::XMFLOAT3 joints[JointHistory::JOINT_COUNT];
+        double time;
+    };
+
+    // Best match of a pattern so far, reported once the cost stops falling
+    struct Candidate {
+        RecognizedGesture gesture;
+        float cost = 0.0f;
+        bool valid = false;
+    };
+
+    void MatchPending();
+    void MatchGroup(const TemplateGroup& group, double now);
+    void WaitForMatch();
+
     std::vector<GesturePattern> patterns_;
-    std::vector<RecognizedGesture> recognizedGestures_;
-    std::vector<DirectX::XMFLOAT3> currentJoints_;
-    float gestureStartTime_;
-    bool isRecognizing_;
+    std::vector<std::unique_ptr<TemplateGroup>> groups_;
+    std::vector<double> lastRecognized_;    // Per pattern, for the cooldown
+    std::vector<Candidate> candidates_;
+
+    JobSystem* jobs_;
+    std::unique_ptr<JobCounter> matchCounter_;
+
+    // Filled by Update, drained by the match job
+    std::mutex pendingMutex_;
+    std::vector<PendingFrame> pending_;
+    std::vector<PendingFrame> draining_;
+
+    // Owned by the match job
+    std::unique_ptr<JointHistory> history_;
+
+    std::mutex resultMutex_;
+    std::vector<RecognizedGesture> results_;
 };
 
 class MotionControlSystem {
@@ -422,6 +539,8 @@ public:
     // Initialization
     bool Initialize();
     void Shutdown();
+    // Gesture matching runs as jobs while set; clear it before the job system shuts down
+    void SetJobSystem(JobSystem* jobs);
 
     // Device management
     bool DetectDevices();
@@ -520,6 +639,7 @@ public:
     // Kinect-specific public methods
     DirectX::XMFLOAT3 GetJointPosition(JointType joint) const;
     float GetJointConfidence(JointType joint) const;
+    const JointHistory& GetJointHistory() const { return *jointHistory_; }
     MotionAimingData GetAimingData() const;
     std::vector<MotionEvent> GetMotionEvents();
     void SetMotionSensitivity(float sensitivity);
@@ -574,8 +694,9 @@ private:
     bool InitializeKinect();
     bool InitializeGestureRecognition();
     void InitializeMotionTracking();
-    void UpdateBodyTracking();
-    void UpdateGestureRecognition(float deltaTime);
+    // False when no new body frame arrived
+    bool UpdateBodyTracking(float deltaTime);
+    void UpdateGestureRecognition(bool newBodyFrame);
     void UpdateMotionAiming(float deltaTime);
     void UpdateMotionControls(float deltaTime);
     void HandleGesture(const RecognizedGesture& gesture);
@@ -583,7 +704,6 @@ private:
     void HandleGrabGesture(const RecognizedGesture& gesture);
     void HandleWaveGesture(const RecognizedGesture& gesture);
     void DefineGesturePatterns();
-    void ApplyMotionFiltering(DirectX::XMFLOAT3& motion);
     DirectX::XMFLOAT3 CalculateAimDirection(const DirectX::XMFLOAT3& handPosition);
     DirectX::XMFLOAT3 LerpVector3(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b, float t);
     void UpdateMovementControls();
@@ -681,25 +801,20 @@ private:
     void* coordinateMapper_;                // ICoordinateMapper*
     void* bodyFrameReader_;                 // IBodyFrameReader*
     GestureRecognizer* gestureRecognizer_;
+    JobSystem* jobs_;
     bool isInitialized_;
     bool calibrationMode_;
     float motionSensitivity_;
     float aimingSmoothing_;
     float gestureThreshold_;
+    double trackingTime_;
+    double lastBodyFrameTime_;
     
-    // Joint tracking data
-    std::vector<DirectX::XMFLOAT3> trackedJoints_;
-    std::vector<float> jointConfidence_;
-    
-    // Motion filtering
-    struct MotionFilterData {
-        int windowSize;
-        std::vector<DirectX::XMFLOAT3> history;
-        std::vector<DirectX::XMFLOAT3> positions;
-        std::vector<float> weights;
-        DirectX::XMFLOAT3 filteredValue;
-    };
-    MotionFilterData motionFilter_;
+    // Joint tracking data, One Euro filtered
+    DirectX::XMFLOAT3 trackedJoints_[JointHistory::JOINT_COUNT];
+    float jointConfidence_[JointHistory::JOINT_COUNT];
+    JointFilter jointFilter_;
+    std::unique_ptr<JointHistory> jointHistory_;
     
     // Motion aiming data
     MotionAimingData aimingData_;
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+struct MotionMatchingSettings {
+    float trajectoryWeight = 1.0f;
+    float poseWeight = 1.0f;
+    float velocityWeight = 0.5f;
+    float searchInterval = 0.1f;               // Seconds between searches of one character
+};
+
+/**
+ * Per-character motion matching state for MotionDatabase::Update().
+ *
+ * The first update always searches. Start characters at different timeSinceSearch values in
+ * [0, searchInterval) so their later searches spread across frames instead of all landing on one.
+ */
+struct MotionMatchState {
+    uint32_t frame = ~0u;                      // Best frame so far, ~0u before the first search
+    float cost = 0.0f;
+    float timeSinceSearch = 0.0f;
+    std::vector<float> query;                  // Scratch for the normalized query
+};
+
+/**
+ * Motion matching database searched without scanning every frame.
+ *
+ * Build() flattens each frame's trajectory points, pose points and root velocity into one row of
+ * a contiguous float matrix, padded to a multiple of four. Every feature group is normalized by
+ * its standard deviation and scaled by its weight, so a plain squared distance between rows is the
+ * weighted matching cost. A KD-tree over the rows keeps the bounds of each node; a search walks the
+ * nearer child first and skips any node whose bounds are already further than the best frame.
+ * Distances are evaluated four features at a time with SSE and give up as soon as they pass the
+ * best cost.
+ *
+ * Searches only read the database, so any number of characters may search from jobs at once.
+ */
+class MotionDatabase {
+public:
+    static constexpr uint32_t LEAF_SIZE = 16;
+    static constexpr uint32_t INVALID_FRAME = ~0u;
+
+    MotionDatabase();
+
+    // Frame i is trajectories[i], poses[i] and velocities[i]; every frame must have the same number
+    // of trajectory and pose points. velocities may be empty when the clips carry none
+    bool Build(const std::vector<std::vector<DirectX::XMFLOAT3>>& trajectories,
+               const std::vector<std::vector<DirectX::XMFLOAT3>>& poses,
+               const std::vector<DirectX::XMFLOAT3>& velocities, const MotionMatchingSettings& settings);
+    void Clear();
+
+    // Frame nearest the query, in the same layout as one database frame. cost receives the
+    // weighted squared distance when given
+    uint32_t FindBestMatch(const std::vector<DirectX::XMFLOAT3>& trajectory, const std::vector<DirectX::XMFLOAT3>& pose,
+                           const DirectX::XMFLOAT3& velocity, float* cost = nullptr) const;
+
+    // Searches only once state.timeSinceSearch reaches the search interval; between searches the
+    // caller keeps playing from state.frame. True when it searched
+    bool Update(MotionMatchState& state, float deltaTime, const std::vector<DirectX::XMFLOAT3>& trajectory,
+                const std::vector<DirectX::XMFLOAT3>& pose, const DirectX::XMFLOAT3& velocity) const;
+
+    size_t GetFrameCount() const { return frames_.size(); }
+    size_t GetFeatureCount() const { return featureCount_; }
+    size_t GetNodeCount() const { return nodes_.size(); }
+    const MotionMatchingSettings& GetSettings() const { return settings_; }
+
+private:
+    // A leaf when count > 0, covering rows [first, first + count)
+    struct Node {
+        uint32_t first;
+        uint32_t count;
+        uint32_t left;
+        uint32_t right;
+    };
+
+    uint32_t BuildNode(const std::vector<float>& rows, uint32_t first, uint32_t count);
+    void NormalizeQuery(const std::vector<DirectX::XMFLOAT3>& trajectory, const std::vector<DirectX::XMFLOAT3>& pose,
+                        const DirectX::XMFLOAT3& velocity, std::vector<float>& query) const;
+    uint32_t Search(const float* query, float& cost) const;
+
+    MotionMatchingSettings settings_;
+    size_t trajectoryPoints_;
+    size_t posePoints_;
+    bool hasVelocity_;
+    size_t featureCount_;
+    size_t stride_;                            // featureCount_ rounded up to four
+
+    std::vector<float> offsets_;               // Per feature, subtracted before scaling
+    std::vector<float> scales_;                // Per feature, weight over the group's deviation
+    std::vector<float> features_;              // Normalized rows in leaf order
+    std::vector<uint32_t> frames_;             // Source frame of each row
+    std::vector<Node> nodes_;
+    std::vector<float> boundsMin_;             // stride_ floats per node
+    std::vector<float> boundsMax_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+struct MeshData;
+
+struct NavMeshSettings {
+    float maxSlope = 45.0f;                    // Degrees from horizontal a walkable triangle may lean
+    float weldDistance = 0.01f;                // Vertices closer than this become one
+    uint32_t maxVerticesPerPolygon = 6;        // Up to NavMesh::MAX_POLYGON_VERTICES
+    uint32_t clusterSize = 64;                 // Polygons per cluster of the coarse graph
+    float cellSize = 4.0f;                     // Grid cell of point lookups
+};
+
+/**
+ * Navigation mesh of convex walkable polygons.
+ *
+ * Build() takes level geometry as a triangle list with clockwise front faces, the way the renderer
+ * draws it. Triangles facing down or leaning further than maxSlope are dropped and the rest are
+ * welded. Neighbours are then merged greedily into convex polygons, longest shared edge first,
+ * like the polygon mesh stage of Recast. Edge k runs from corner k to corner k + 1, clockwise seen
+ * from above, and records the polygon across it. Walkable surfaces must share vertices to connect;
+ * T-junctions in the source leave gaps.
+ *
+ * Polygons are grouped into clusters of about clusterSize by breadth-first growth. Clusters that
+ * share an edge are linked by the distance between their centres, which gives AIPathfinding a
+ * coarse graph for long paths. Point lookups go through a grid over the polygons' extents.
+ *
+ * Build once, ideally at import. BuildCache() bakes a level's navmesh next to it as .nnav, and
+ * Load() reads it back.
+ */
+class NavMesh {
+public:
+    static constexpr uint32_t MAGIC = 0x56414E4E;   // "NNAV"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t INVALID_POLYGON = ~0u;
+    static constexpr uint32_t MAX_POLYGON_VERTICES = 8;
+
+    struct Polygon {
+        uint32_t firstVertex;                  // Into the corner and neighbour arrays
+        uint32_t vertexCount;
+        uint32_t cluster;
+        DirectX::XMFLOAT3 center;
+    };
+
+    struct Cluster {
+        DirectX::XMFLOAT3 center;
+        uint32_t firstLink;
+        uint32_t linkCount;
+    };
+
+    struct ClusterLink {
+        uint32_t cluster;
+        float cost;
+    };
+
+    NavMesh();
+
+    // False when nothing walkable is left
+    bool Build(const DirectX::XMFLOAT3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+               const NavMeshSettings& settings);
+    // From the full-detail level of an imported mesh
+    bool Build(const MeshData& mesh, const NavMeshSettings& settings);
+    void Clear();
+
+    bool Save(const std::string& filename) const;
+    bool Load(const std::string& filename);
+    // level.obj -> level.obj.nnav
+    static std::string GetCachePath(const std::string& sourceFile);
+    // Imports the source and writes its navmesh unless the cache is already current
+    static bool BuildCache(const std::string& sourceFile, const NavMeshSettings& settings);
+
+    // Polygon under point, or the one nearest to it within searchRadius; INVALID_POLYGON when
+    // none. nearest receives the point on that polygon
+    uint32_t FindNearestPolygon(const DirectX::XMFLOAT3& point, float searchRadius,
+                                DirectX::XMFLOAT3* nearest = nullptr) const;
+    // Edge shared by neighbours from and to, left and right seen walking from one into the other
+    bool GetPortal(uint32_t from, uint32_t to, DirectX::XMFLOAT3& left, DirectX::XMFLOAT3& right) const;
+
+    size_t GetPolygonCount() const { return polygons_.size(); }
+    const Polygon& GetPolygon(uint32_t polygon) const { return polygons_[polygon]; }
+    const DirectX::XMFLOAT3& GetCorner(uint32_t polygon, uint32_t corner) const {
+        return vertices_[corners_[polygons_[polygon].firstVertex + corner]];
+    }
+    // Polygon across edge, INVALID_POLYGON on the border
+    uint32_t GetNeighbour(uint32_t polygon, uint32_t edge) const { return neighbours_[polygons_[polygon].firstVertex + edge]; }
+    size_t GetClusterCount() const { return clusters_.size(); }
+    const Cluster& GetCluster(uint32_t cluster) const { return clusters_[cluster]; }
+    const ClusterLink& GetClusterLink(uint32_t link) const { return clusterLinks_[link]; }
+    // Changes on every Build() and Load(), so path caches know when to drop their entries
+    uint32_t GetRevision() const { return revision_; }
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexCount;
+        uint32_t polygonCount;
+        uint32_t cornerCount;
+        uint32_t clusterSize;
+        float cellSize;
+    };
+
+    struct FilePolygon {
+        uint32_t firstVertex;
+        uint32_t vertexCount;
+    };
+
+    // Connects polygons across shared edges
+    void BuildAdjacency();
+    // Centres, lookup grid and clusters, all derived from the polygons
+    void Finalize(uint32_t clusterSize, float cellSize);
+    void BuildClusters(uint32_t clusterSize);
+    DirectX::XMFLOAT3 ClosestPoint(uint32_t polygon, const DirectX::XMFLOAT3& point, bool& inside) const;
+
+    std::vector<DirectX::XMFLOAT3> vertices_;
+    std::vector<Polygon> polygons_;
+    std::vector<uint32_t> corners_;            // Vertex of each polygon corner
+    std::vector<uint32_t> neighbours_;         // Polygon across each polygon edge
+
+    std::vector<Cluster> clusters_;
+    std::vector<ClusterLink> clusterLinks_;
+
+    // Polygons overlapping each grid cell, cell (x, z) at gridCells_[z * gridWidth_ + x]
+    std::vector<uint32_t> gridCells_;          // gridWidth_ * gridHeight_ + 1 offsets into gridPolygons_
+    std::vector<uint32_t> gridPolygons_;
+    DirectX::XMFLOAT2 gridOrigin_;
+    uint32_t gridWidth_;
+    uint32_t gridHeight_;
+    float cellSize_;
+    uint32_t clusterSize_;
+
+    uint32_t revision_;
+};
+
+} // namespace Nexus
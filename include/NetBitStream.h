@@ -0,0 +1,98 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Bit-level writer for network messages.
+ *
+ * Values take exactly the bits asked for, least significant first, packed into 32-bit words and
+ * flushed to bytes by Finish(). Floats are quantized to a range and a bit count, and the
+ * transform helpers pack positions to a fixed grid and rotations as their smallest three
+ * components.
+ */
+class NetBitWriter {
+public:
+    explicit NetBitWriter(std::vector<uint8_t>& out);
+
+    void WriteBits(uint32_t value, uint32_t bits);      // bits <= 32
+    void WriteBool(bool value) { WriteBits(value ? 1u : 0u, 1); }
+    // 7 bits a group with a continuation bit, for counts and id gaps that are usually small
+    void WriteVarint(uint32_t value);
+    // Signed values near zero in few bits
+    void WriteSignedVarint(int32_t value);
+    // Clamped to [min, max], bits <= 32
+    void WriteQuantized(float value, float min, float max, uint32_t bits);
+
+    // Bits written so far, Finish() padding excluded
+    size_t GetBitCount() const { return bitCount_; }
+    // Flushes the partial word; the writer shouldn't be used after
+    void Finish();
+
+private:
+    std::vector<uint8_t>& out_;
+    uint64_t scratch_;
+    uint32_t scratchBits_;
+    size_t bitCount_;
+};
+
+/**
+ * Reader for NetBitWriter's output. Reading past the end returns zeros and sets the overflow
+ * flag instead of failing at each call, so decoders check IsOverflowed() once at the end.
+ */
+class NetBitReader {
+public:
+    NetBitReader(const uint8_t* data, size_t size);
+
+    uint32_t ReadBits(uint32_t bits);
+    bool ReadBool() { return ReadBits(1) != 0; }
+    uint32_t ReadVarint();
+    int32_t ReadSignedVarint();
+    float ReadQuantized(float min, float max, uint32_t bits);
+
+    bool IsOverflowed() const { return overflowed_; }
+    size_t GetBitsRemaining() const { return totalBits_ > bitCount_ ? totalBits_ - bitCount_ : 0; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    uint64_t scratch_;
+    uint32_t scratchBits_;
+    size_t byteIndex_;
+    size_t bitCount_;
+    size_t totalBits_;
+    bool overflowed_;
+};
+
+/**
+ * Fixed-point transforms as they go over the wire. Positions are integer steps of 1 / resolution
+ * metres from the world's minimum corner; rotations are the smallest three components of the
+ * unit quaternion, the largest being implied by the others and its index sent in 2 bits.
+ */
+struct QuantizedTransform {
+    int32_t position[3] = { 0, 0, 0 };
+    uint32_t rotation = 0;                      // Index << 30 | three 10-bit components
+
+    bool operator==(const QuantizedTransform& other) const {
+        return position[0] == other.position[0] && position[1] == other.position[1] &&
+               position[2] == other.position[2] && rotation == other.rotation;
+    }
+    bool operator!=(const QuantizedTransform& other) const { return !(*this == other); }
+};
+
+struct NetQuantization {
+    DirectX::XMFLOAT3 worldMin = DirectX::XMFLOAT3(-4096.0f, -512.0f, -4096.0f);
+    DirectX::XMFLOAT3 worldMax = DirectX::XMFLOAT3(4096.0f, 512.0f, 4096.0f);
+    float resolution = 64.0f;                   // Steps per metre
+
+    // Bits per position axis to cover the world at the resolution
+    uint32_t GetPositionBits(int axis) const;
+    QuantizedTransform Quantize(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT4& rotation) const;
+    void Dequantize(const QuantizedTransform& transform, DirectX::XMFLOAT3& position, DirectX::XMFLOAT4& rotation) const;
+};
+
+} // namespace Nexus
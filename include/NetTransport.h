@@ -0,0 +1,154 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * UDP transport with connections, message batching and a reliability layer.
+ *
+ * One socket serves every connection. Messages queued with Send() are packed into as few
+ * packets of at most MAX_PACKET_SIZE bytes as they fit by Flush(), so a server tick costs one
+ * packet per client rather than one per message. Every packet carries a sequence number and
+ * acks for the 33 newest packets received, so both ends learn what arrived without packets of
+ * their own; a reliable message rides along in packets until one that holds it is acked,
+ * resent no sooner than the round trip allows, and is delivered once and in order. Unreliable
+ * messages are sent once, for state that the next update replaces anyway.
+ *
+ * A client connects with a random salt that the server echoes, so stray or stale packets from
+ * an address don't open or hijack a connection. Connections that go quiet for the timeout are
+ * dropped; idle ones send an empty packet now and then to keep their acks flowing.
+ *
+ * Single-threaded apart from Send(), which touches only its connection's queue, so messages for
+ * different connections may be queued from different threads.
+ */
+class NetTransport {
+public:
+    using ConnectionID = uint32_t;
+    static constexpr ConnectionID INVALID_CONNECTION = ~0u;
+    // Stays under the common internet MTU once IP and UDP headers are added
+    static constexpr size_t MAX_PACKET_SIZE = 1200;
+    static constexpr size_t MAX_MESSAGE_SIZE = MAX_PACKET_SIZE - 32;
+
+    enum class EventType { Connected, Disconnected, Message };
+
+    struct Event {
+        EventType type = EventType::Message;
+        ConnectionID connection = INVALID_CONNECTION;
+        std::vector<uint8_t> data;              // Message only
+    };
+
+    struct Stats {
+        uint64_t packetsSent = 0;
+        uint64_t packetsReceived = 0;
+        uint64_t bytesSent = 0;
+        uint64_t bytesReceived = 0;
+        uint64_t reliableResends = 0;
+        uint64_t packetsDropped = 0;            // Malformed, unknown sender or full receive window
+    };
+
+    NetTransport();
+    ~NetTransport();
+    NetTransport(const NetTransport&) = delete;
+    NetTransport& operator=(const NetTransport&) = delete;
+
+    // Server: accepts up to maxConnections clients on port. protocolId must match the clients'
+    bool Listen(uint16_t port, uint32_t maxConnections, uint32_t protocolId);
+    // Client: starts connecting to the server, which becomes connection 0; a Connected or
+    // Disconnected event follows
+    bool Connect(const std::string& host, uint16_t port, uint32_t protocolId);
+    void Close();
+
+    // Reads every packet waiting, then handles handshakes and timeouts. Events come out of
+    // PollEvent() in the order they happened
+    void Receive();
+    bool PollEvent(Event& event);
+
+    // Queues a message for the connection's next Flush(); false when it's too big or the
+    // connection isn't up
+    bool Send(ConnectionID connection, const uint8_t* data, size_t size, bool reliable);
+    // Sends the queued messages, the due resends and keep-alives of every connection
+    void Flush();
+    void Disconnect(ConnectionID connection);
+
+    bool IsServer() const { return server_; }
+    bool IsConnected(ConnectionID connection) const;
+    uint32_t GetMaxConnections() const { return static_cast<uint32_t>(connections_.size()); }
+    uint32_t GetConnectionCount() const { return connectionCount_; }
+    float GetRoundTripMs(ConnectionID connection) const;
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    static constexpr size_t SENT_PACKET_WINDOW = 1024;
+    static constexpr size_t RELIABLE_WINDOW = 256;
+
+    enum class State { Free, Connecting, Connected };
+
+    struct SentPacket {
+        uint16_t sequence = 0;
+        bool acked = true;
+        double time = 0.0;
+        std::vector<uint16_t> reliableIds;
+    };
+
+    struct ReliableMessage {
+        uint16_t id = 0;
+        bool acked = false;
+        double lastSent = -1.0;
+        std::vector<uint8_t> data;
+    };
+
+    struct Connection {
+        State state = State::Free;
+        uint32_t address = 0;                   // IPv4, host order
+        uint16_t port = 0;
+        uint64_t salt = 0;
+        double lastReceived = 0.0;
+        double lastSent = 0.0;
+        double connectStarted = 0.0;
+        float roundTrip = 0.1f;                 // Seconds, smoothed
+
+        uint16_t localSequence = 0;
+        uint16_t remoteSequence = 0;            // Newest received
+        uint32_t receivedBits = 0;              // The 32 before it
+        bool receivedAny = false;
+        std::vector<SentPacket> sentPackets;    // By sequence % SENT_PACKET_WINDOW
+
+        uint16_t nextReliableId = 0;
+        std::deque<ReliableMessage> reliableQueue;
+        uint16_t nextDeliverId = 0;
+        std::vector<std::vector<uint8_t>> reliableReceived;  // By id % RELIABLE_WINDOW
+        std::vector<bool> reliableReceivedSet;
+        std::vector<std::vector<uint8_t>> unreliableQueue;
+    };
+
+    double Now() const;
+    void Reset(Connection& connection);
+    void HandlePacket(uint32_t address, uint16_t port, const uint8_t* data, size_t size);
+    void HandlePayload(ConnectionID id, const uint8_t* data, size_t size);
+    void ProcessAcks(Connection& connection, uint16_t ack, uint32_t ackBits);
+    void FlushConnection(ConnectionID id, double now);
+    void SendControl(const Connection& connection, uint8_t type);
+    void SendPacket(const Connection& connection, const uint8_t* data, size_t size);
+    void Drop(ConnectionID id, bool notify);
+
+    uintptr_t socket_;
+    bool server_;
+    bool winsockStarted_;
+    uint32_t protocolId_;
+    std::vector<Connection> connections_;
+    uint32_t connectionCount_;
+    std::unordered_map<uint64_t, ConnectionID> connectionsByAddress_;  // address << 16 | port
+    std::deque<Event> events_;
+    std::vector<uint8_t> packet_;               // Flush scratch
+    std::chrono::steady_clock::time_point epoch_;
+    Stats stats_;
+};
+
+} // namespace Nexus
@@ -4,6 +4,7 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -44,6 +45,20 @@ float nexus_engine_get_delta_time(NexusEngine* engine);
 int nexus_engine_get_fps(NexusEngine* engine);
 void nexus_engine_set_target_fps(NexusEngine* engine, float fps);
 
+// Frame metrics: rolling statistics in milliseconds over the last 1024 samples of a series
+// ("Frame", "CPU", "GPU", or a subsystem scope such as "Physics::Update")
+typedef struct {
+    float last, mean, p50, p95, p99, max;
+    uint32_t samples;
+    uint32_t hitches;
+    uint64_t totalHitches;
+} NexusMetricSummary;
+
+bool nexus_metrics_get_summary(NexusEngine* engine, const char* series, NexusMetricSummary* summary);
+void nexus_metrics_set_hitch_threshold(NexusEngine* engine, float factor, float minimumMs);
+bool nexus_metrics_export_csv(NexusEngine* engine, const char* filename);
+bool nexus_metrics_export_json(NexusEngine* engine, const char* filename);
+
 // Graphics API
 NexusGraphics* nexus_engine_get_graphics(NexusEngine* engine);
 void nexus_graphics_begin_frame(NexusGraphics* graphics);
@@ -52,12 +67,39 @@ void nexus_graphics_present(NexusGraphics* graphics);
 void nexus_graphics_clear(NexusGraphics* graphics, NexusColor color);
 void nexus_graphics_set_viewport(NexusGraphics* graphics, int x, int y, int width, int height);
 
-// Basic rendering
+// Basic rendering. Lines and text are 2D, in pixels from the window's top-left corner (line z
+// is ignored), and go through the sprite batch below on the current layer
 void nexus_graphics_draw_line(NexusGraphics* graphics, NexusVector3 start, NexusVector3 end, NexusColor color);
 void nexus_graphics_draw_cube(NexusGraphics* graphics, NexusVector3 position, NexusVector3 size, NexusColor color);
 void nexus_graphics_draw_sphere(NexusGraphics* graphics, NexusVector3 position, float radius, NexusColor color);
 void nexus_graphics_draw_text(NexusGraphics* graphics, const char* text, int x, int y, NexusColor color);
 
+// 2D sprites, batched and drawn over the scene when the frame ends, in one draw per layer and
+// texture page. Textures from nexus_graphics_load_texture are packed into shared atlas pages.
+// Higher layers draw on top; within a layer sprites are grouped by page and keep their order
+// within a page, so overlapping sprites of different textures that must stack in a set order
+// belong on different layers
+typedef struct {
+    float x, y;             // Center, pixels
+    float width, height;    // Pixels; 0 takes the texture's size
+    float rotation;         // Radians, clockwise
+    int texture;            // nexus_graphics_load_texture id, 0 for a solid color
+    int layer;
+    NexusColor color;       // Multiplies the texture
+} NexusSprite;
+
+void nexus_graphics_draw_sprite(NexusGraphics* graphics, const NexusSprite* sprite);
+void nexus_graphics_draw_sprites(NexusGraphics* graphics, const NexusSprite* sprites, size_t count);
+// Layer of later lines and text, 0 to start with
+void nexus_graphics_set_layer(NexusGraphics* graphics, int layer);
+
+// Instanced rendering: one call per batch instead of per object. Null sizes, radii or colors
+// mean unit size or white; drawn when the frame ends
+void nexus_graphics_draw_cubes_instanced(NexusGraphics* graphics, const NexusVector3* positions,
+                                         const NexusVector3* sizes, const NexusColor* colors, size_t count);
+void nexus_graphics_draw_spheres_instanced(NexusGraphics* graphics, const NexusVector3* positions,
+                                           const float* radii, const NexusColor* colors, size_t count);
+
 // Input API
 NexusInput* nexus_engine_get_input(NexusEngine* engine);
 bool nexus_input_is_key_pressed(NexusInput* input, int keyCode);
@@ -81,6 +123,62 @@ void nexus_physics_set_position(NexusPhysics* physics, int objectId, NexusVector
 NexusVector3 nexus_physics_get_position(NexusPhysics* physics, int objectId);
 void nexus_physics_apply_force(NexusPhysics* physics, int objectId, NexusVector3 force);
 
+// Bulk body access. Bodies are the engine's 64-bit rigid body handles; xyz holds count packed
+// x, y, z triples, entry i for bodies[i]. Unknown bodies are skipped
+typedef uint64_t NexusBodyId;
+
+void nexus_physics_set_positions(NexusPhysics* physics, const NexusBodyId* bodies, const float* xyz, size_t count);
+void nexus_physics_get_positions(NexusPhysics* physics, const NexusBodyId* bodies, float* xyz, size_t count);
+void nexus_physics_set_velocities(NexusPhysics* physics, const NexusBodyId* bodies, const float* xyz, size_t count);
+void nexus_physics_apply_impulses(NexusPhysics* physics, const NexusBodyId* bodies, const float* xyz, size_t count);
+
+// Character controllers: kinematic capsules that slide along walls, climb steps up to
+// stepHeight and treat slopes steeper than maxSlope (radians) as walls. Positions are the
+// capsule's center; 0 is no character. Move every character in one call per frame, with
+// displacements as packed x, y, z triples that include whatever gravity the game wants
+typedef int NexusCharacterId;
+
+typedef struct {
+    NexusVector3 position;
+    NexusVector3 velocity;
+    NexusVector3 groundNormal;
+    int grounded;
+} NexusCharacterState;
+
+NexusCharacterId nexus_physics_create_character(NexusPhysics* physics, NexusVector3 position, float radius, float height,
+                                                float stepHeight, float maxSlope);
+void nexus_physics_destroy_character(NexusPhysics* physics, NexusCharacterId character);
+void nexus_physics_move_characters(NexusPhysics* physics, const NexusCharacterId* characters, const float* xyz,
+                                   size_t count, float deltaTime);
+// False for an unknown character
+int nexus_physics_get_character(NexusPhysics* physics, NexusCharacterId character, NexusCharacterState* state);
+
+// Mapped transforms: the world's transform storage itself, one view per chunk of entities
+// that have a transform. Reads and writes go straight to the engine with no copy; writes to a
+// physics body's position are not seen as a teleport, use nexus_physics_set_positions for
+// those. Views stay valid until entities or components are added or removed, so map again each
+// frame, from the update callback
+typedef struct {
+    uint32_t index;
+    uint32_t generation;
+} NexusEntity;
+
+typedef struct {
+    NexusVector3 position;
+    NexusVector3 previousPosition;   // Last simulation step, for interpolation
+    NexusVector4 rotation;           // Quaternion
+    NexusVector3 scale;
+} NexusTransform;
+
+typedef struct {
+    const NexusEntity* entities;
+    NexusTransform* transforms;
+    size_t count;
+} NexusTransformChunk;
+
+// Fills up to capacity chunks and returns how many there are in total
+size_t nexus_world_map_transforms(NexusEngine* engine, NexusTransformChunk* chunks, size_t capacity);
+
 // Math utilities
 NexusVector3 nexus_vector3_add(NexusVector3 a, NexusVector3 b);
 NexusVector3 nexus_vector3_subtract(NexusVector3 a, NexusVector3 b);
@@ -96,6 +194,30 @@ NexusMatrix4 nexus_matrix4_translate(NexusVector3 translation);
 NexusMatrix4 nexus_matrix4_rotate(NexusVector3 axis, float angle);
 NexusMatrix4 nexus_matrix4_scale(NexusVector3 scale);
 
+// Batch math over arrays, on the widest SIMD path the CPU has. Outputs may alias the matching
+// input. Points are transformed as p * matrix with the fourth column ignored; zero vectors
+// normalize to zero; slerp takes unit quaternions and t in [0, 1], one per pair or one for all
+typedef struct {
+    NexusVector3 min;
+    NexusVector3 max;
+} NexusAABB;
+
+typedef struct {
+    NexusVector4 planes[6]; // Left, right, bottom, top, near, far; inside where dot(plane, point) >= 0
+} NexusFrustum;
+
+void nexus_math_transform_points(const NexusMatrix4* matrix, const NexusVector3* points, NexusVector3* output, size_t count);
+void nexus_math_normalize_vectors(const NexusVector3* vectors, NexusVector3* output, size_t count);
+void nexus_math_slerp_quaternions(const NexusVector4* from, const NexusVector4* to, const float* t,
+                                  NexusVector4* output, size_t count);
+void nexus_math_slerp_quaternions_uniform(const NexusVector4* from, const NexusVector4* to, float t,
+                                          NexusVector4* output, size_t count);
+NexusFrustum nexus_math_frustum_from_view_projection(NexusMatrix4 viewProjection);
+// visible[i] is set to 1 or 0; returns the number visible
+size_t nexus_math_cull_boxes(const NexusFrustum* frustum, const NexusAABB* boxes, size_t count, uint8_t* visible);
+// "AVX2", "SSE4.1" or "scalar"
+const char* nexus_math_get_instruction_set(void);
+
 // Callback types for C
 typedef void (*NexusUpdateCallback)(float deltaTime, void* userData);
 typedef void (*NexusRenderCallback)(NexusGraphics* graphics, void* userData);
@@ -106,7 +228,8 @@ void nexus_engine_set_update_callback(NexusEngine* engine, NexusUpdateCallback c
 void nexus_engine_set_render_callback(NexusEngine* engine, NexusRenderCallback callback, void* userData);
 void nexus_engine_set_input_callback(NexusEngine* engine, NexusInputCallback callback, void* userData);
 
-// Resource loading
+// Resource loading. Textures load into the 2D sprite atlas; 0 on failure, which draws as a
+// solid color
 int nexus_graphics_load_texture(NexusGraphics* graphics, const char* filename);
 int nexus_graphics_load_model(NexusGraphics* graphics, const char* filename);
 void nexus_graphics_draw_model(NexusGraphics* graphics, int modelId, NexusMatrix4 transform);
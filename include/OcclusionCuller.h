@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * GPU occlusion culling against a hierarchical depth (Hi-Z) pyramid.
+ *
+ * At the end of a frame BuildPyramid() reduces the depth buffer into a mip chain of the farthest
+ * depth, with the nearest beside it for ScreenSpaceReflections to march rays through. During
+ * the next frame Cull() runs a compute shader over a range of instances: each instance's
+ * unit-cube bounds are projected with the view-projection that produced the pyramid and compared
+ * against the 2x2 pyramid texels covering them. Survivors are compacted into GetVisibleInstances()
+ * and counted into a DrawIndexedInstancedIndirect argument record, so the CPU never sees the
+ * result. Objects that moved into view from behind an occluder can pop in for one frame.
+ */
+class OcclusionCuller {
+public:
+    struct Stats {
+        uint32_t tested = 0;     // Instances submitted this frame
+        uint32_t visible = 0;    // Survivors of a recent frame (read back without stalling)
+        uint32_t draws = 0;
+    };
+
+    static constexpr UINT INSTANCE_STRIDE = 80;        // float4x4 world + float4 color
+    static constexpr UINT MAX_DRAWS_PER_FRAME = 64;
+    static constexpr UINT ARGUMENT_STRIDE = 5 * sizeof(UINT);
+
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height);
+    void Shutdown();
+
+    void BeginFrame();
+
+    // depth is the finished frame's depth buffer (must not be bound as a depth target).
+    // depthWidth x depthHeight is the top-left region that holds the frame when it rendered
+    // below full resolution; 0 reads the whole buffer
+    void BuildPyramid(ID3D11ShaderResourceView* depth, const DirectX::XMFLOAT4X4& viewProjection,
+                      UINT depthWidth = 0, UINT depthHeight = 0);
+    bool HasPyramid() const { return pyramidValid_; }
+
+    // The pyramid for other GPU passes, see MeshletCuller: R32G32 with the farthest depth in x,
+    // so culling shaders can read it as Texture2D<float>, and the nearest in y
+    ID3D11ShaderResourceView* GetPyramidView() const { return pyramidView_; }
+    // Extent of the last build, which may cover only the top-left of the pyramid texture
+    UINT GetPyramidWidth() const { return builtWidth_; }
+    UINT GetPyramidHeight() const { return builtHeight_; }
+    UINT GetPyramidMipCount() const { return static_cast<UINT>(mipViews_.size()); }
+    const DirectX::XMFLOAT4X4& GetPyramidViewProjection() const { return pyramidViewProjection_; }
+
+    // Culls instances [firstInstance, firstInstance + instanceCount) of a raw instance buffer.
+    // Survivors land at the same offsets in GetVisibleInstances(); argumentsOffset receives the
+    // byte offset of the draw record in GetDrawArguments(). False means draw unculled.
+    bool Cull(ID3D11ShaderResourceView* instances, UINT instanceCapacity, UINT firstInstance, UINT instanceCount,
+              UINT indexCountPerInstance, UINT& argumentsOffset);
+
+    ID3D11Buffer* GetVisibleInstances() const { return visibleBuffer_; }
+    ID3D11Buffer* GetDrawArguments() const { return argumentsBuffer_; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    static constexpr int READBACK_LATENCY = 3;
+
+    bool CreateShaders();
+    bool CreatePyramid(UINT width, UINT height);
+    bool EnsureVisibleCapacity(UINT instanceCapacity);
+    void ReadBackStats();
+    void ReleasePyramid();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+
+    ID3D11ComputeShader* downsampleShader_;
+    ID3D11ComputeShader* cullShader_;
+    ID3D11Buffer* downsampleConstants_;
+    ID3D11Buffer* cullConstants_;
+
+    // Hi-Z pyramid, mip 0 is half the depth buffer resolution
+    ID3D11Texture2D* pyramid_;
+    ID3D11ShaderResourceView* pyramidView_;
+    std::vector<ID3D11ShaderResourceView*> mipViews_;
+    std::vector<ID3D11UnorderedAccessView*> mipTargets_;
+    UINT pyramidWidth_;
+    UINT pyramidHeight_;
+    UINT depthWidth_;
+    UINT depthHeight_;
+    UINT builtWidth_;
+    UINT builtHeight_;
+    DirectX::XMFLOAT4X4 pyramidViewProjection_;
+    bool pyramidValid_;
+
+    ID3D11Buffer* visibleBuffer_;
+    ID3D11UnorderedAccessView* visibleTarget_;
+    UINT visibleCapacity_;
+
+    ID3D11Buffer* argumentsBuffer_;
+    ID3D11UnorderedAccessView* argumentsTarget_;
+    UINT drawsThisFrame_;
+
+    // Argument records copied out each frame and mapped once the GPU is done with them
+    ID3D11Buffer* readback_[READBACK_LATENCY];
+    UINT readbackDraws_[READBACK_LATENCY];
+    int readbackFrame_;
+
+    Stats stats_;
+};
+
+} // namespace Nexus
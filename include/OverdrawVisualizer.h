@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace Nexus {
+
+class StateCache;
+
+/**
+ * Overdraw and quad overshading debug views.
+ *
+ * While a view is on, GraphicsDevice points the scene's draws at a counter target and sets the
+ * StateCache pixel override to this class's count shader, so every draw, whatever its material,
+ * adds one per covered pixel to an overdraw count and 4 / (covered pixels of its 2x2 quad) to a
+ * count of the lanes the GPU ran for it. The draws keep their own depth, cull and raster state,
+ * so the counts are what the frame really shades. Resolve() paints them over the scene: a heat
+ * map of the overdraw, or the share of quad lanes that were real pixels, red where each quad
+ * covered one pixel (a quarter of the work useful, typical of thin and tiny triangles) through
+ * yellow to green where every quad was full.
+ */
+class OverdrawVisualizer {
+public:
+    enum class Mode { Overdraw, QuadOvershading };
+
+    static constexpr float MAX_OVERDRAW = 10.0f;   // Layers shown at full heat
+
+    OverdrawVisualizer();
+    ~OverdrawVisualizer();
+
+    OverdrawVisualizer(const OverdrawVisualizer&) = delete;
+    OverdrawVisualizer& operator=(const OverdrawVisualizer&) = delete;
+
+    // width and height are the scene target's
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                    UINT width, UINT height);
+    void Shutdown();
+
+    // Zeroes the counts, once per frame before the scene draws into them
+    void Clear();
+    // Bind in place of the scene target, the same size, with the scene's depth
+    ID3D11RenderTargetView* GetCounterTarget() const { return counterTarget_; }
+    // For StateCache::SetPixelOverride while the scene draws
+    ID3D11PixelShader* GetCountShader() const { return countShader_; }
+    ID3D11BlendState* GetCountBlend() const { return additiveBlend_; }
+
+    // Draws the counts over the top-left width x height of target in mode's colors and leaves
+    // target bound without depth. The pixel override must be off
+    void Resolve(Mode mode, ID3D11RenderTargetView* target, UINT width, UINT height);
+
+private:
+    bool CreateResources();
+    bool CreateShaders();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    StateCache* stateCache_;
+    UINT width_;
+    UINT height_;
+
+    // R: pixels shaded, G: quad lanes run
+    ID3D11Texture2D* counterTexture_;
+    ID3D11RenderTargetView* counterTarget_;
+    ID3D11ShaderResourceView* counterView_;
+
+    ID3D11PixelShader* countShader_;
+    ID3D11VertexShader* fullscreenShader_;
+    ID3D11PixelShader* resolveShader_;
+    ID3D11Buffer* constants_;
+    ID3D11BlendState* additiveBlend_;
+    ID3D11RasterizerState* rasterizerState_;
+    ID3D11DepthStencilState* depthState_;
+};
+
+} // namespace Nexus
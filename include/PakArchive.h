@@ -0,0 +1,83 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Nexus {
+
+// FNV-1a 64 of a path inside a pak, ignoring ASCII case, with '\' read as '/' and any leading
+// "./" skipped, so lookups match however the resource path was spelled
+constexpr uint64_t HashPakPath(std::string_view path) {
+    while (path.size() >= 2 && path[0] == '.' && (path[1] == '/' || path[1] == '\\')) path.remove_prefix(2);
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : path) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        if (c == '\\') c = '/';
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+enum class PakCompression : uint8_t {
+    None,                                      // Stored as is, readable in place
+    LZ4                                        // One LZ4 block
+};
+
+// One entry of a pak's index, as stored in the file
+struct PakEntry {
+    uint64_t hash;                             // HashPakPath of the name
+    uint64_t offset;                           // From the start of the file, a multiple of ALIGNMENT
+    uint64_t size;                             // Stored bytes
+    uint64_t originalSize;                     // Bytes once decompressed
+    uint32_t nameOffset;                       // Into the name table, null terminated
+    PakCompression compression;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(PakEntry) == 40, "PakEntry is stored as is");
+
+/**
+ * Many resource files in one archive, read through a memory mapping.
+ *
+ * The file is a header, an index of PakEntry sorted by hash, a table of names and then each
+ * entry's data at a page aligned offset. Open() maps the file and checks the index, so mounting
+ * costs one open however many files the pak holds; lookups are a binary search of the index and
+ * pages are faulted in as entries are read. Uncompressed entries are handed out in place;
+ * compressed ones are LZ4 blocks, which decode faster than a disk reads them.
+ */
+class PakArchive {
+public:
+    static constexpr uint32_t ALIGNMENT = 4096;
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const { return file_.IsOpen(); }
+    const std::string& GetFilename() const { return filename_; }
+    uint32_t GetEntryCount() const { return entryCount_; }
+    const PakEntry& GetEntry(uint32_t index) const { return entries_[index]; }
+    // Null if the pak has no entry with this path
+    const PakEntry* Find(std::string_view path) const;
+    const char* GetName(const PakEntry& entry) const { return names_ + entry.nameOffset; }
+
+    // The entry's contents: in the mapping when stored uncompressed, otherwise decompressed into
+    // buffer. Null if a compressed entry is corrupt. Safe from any thread
+    const uint8_t* Read(const PakEntry& entry, std::vector<uint8_t>& buffer) const;
+
+    // Builds a pak from files, each named by its path relative to root ("textures/stone.png"),
+    // with their data in the order given. Entries are compressed when that saves at least an
+    // eighth of them. Fails on a file it can't read or two names with the same hash
+    static bool Write(const std::string& filename, const std::vector<std::string>& inputFiles,
+                      const std::string& root, bool compress = true);
+
+private:
+    MappedFile file_;
+    std::string filename_;
+    const PakEntry* entries_ = nullptr;
+    uint32_t entryCount_ = 0;
+    const char* names_ = nullptr;
+};
+
+} // namespace Nexus
@@ -1,12 +1,16 @@
 #pragma once
 
 #include "Platform.h"
+#include "SceneBVH.h"
 #include <vector>
 #include <memory>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <random>
 #include <functional>
+#include <mutex>
+#include <atomic>
 
 #include <d3d11.h>
 #include <DirectXMath.h>
@@ -17,6 +21,8 @@ namespace Nexus {
 class Texture;
 class Camera;
 class Mesh;
+class JobSystem;
+class DecalSystem;
 
 /**
  * Advanced particle system with GPU acceleration and complex behaviors
@@ -93,6 +99,44 @@ public:
         float GetNormalizedAge() const { return 1.0f - (life / maxLife); }
     };
 
+    // An emitter's live particles as structure of arrays, so the update kernels stream each
+    // attribute through SIMD lanes. [0, count) are alive, in no particular order: a particle
+    // that dies is replaced by the last one. Streams are padded by three lanes for the last load.
+    // All of them share one block, sized once from maxParticles, so emitting never allocates
+    struct ParticleStreams {
+        enum Stream {
+            POSITION_X, POSITION_Y, POSITION_Z,
+            VELOCITY_X, VELOCITY_Y, VELOCITY_Z,
+            COLOR_R, COLOR_G, COLOR_B, COLOR_A,
+            SIZE_X, SIZE_Y,
+            ROTATION, ANGULAR_VELOCITY,
+            LIFE, INVERSE_MAX_LIFE,
+            STREAM_COUNT
+        };
+        
+        std::vector<float> storage;                // STREAM_COUNT streams of stride floats each
+        size_t stride = 0;                         // Capacity and padding, in whole SSE groups
+        size_t capacity = 0;
+        size_t count = 0;
+        
+        float* operator[](Stream stream) { return storage.data() + stream * stride; }
+        const float* operator[](Stream stream) const { return storage.data() + stream * stride; }
+        size_t GetCapacity() const { return capacity; }
+        static size_t StrideFor(size_t capacity) { return (capacity + 6) & ~size_t(3); }
+        // Keeps the live particles; only allocates when the block is too small
+        void Reserve(size_t capacity);
+        // Appends at count; false when full
+        bool Add(const Particle& particle);
+        // The fields with a stream; the rest come back zero
+        void Get(size_t index, Particle& particle) const;
+        void Set(size_t index, const Particle& particle);
+        void Remove(size_t index);
+        void Clear() { count = 0; }
+    };
+
+    // One GPU emitter's particle slots and lists; defined with GPUParticleSystem
+    struct GPUParticlePool;
+
     struct ParticleEmitter {
         std::string name;
         bool isActive;
@@ -128,7 +172,8 @@ public:
         float startAngularVelocity;
         float startMass;
         
-        // Over lifetime curves
+        // Over lifetime curves, keyed by age from 0 to 1. Velocity and rotation scale how far the
+        // particle moves and turns per second; color and size replace the start values
         std::vector<std::pair<float, float>> velocityOverLifetime;
         std::vector<std::pair<float, XMFLOAT4>> colorOverLifetime;
         std::vector<std::pair<float, XMFLOAT2>> sizeOverLifetime;
@@ -158,12 +203,15 @@ public:
         // Sub-emitters
         std::vector<std::shared_ptr<ParticleEmitter>> subEmitters;
         
-        // Trails
+        // Trails. Kept and drawn by GPUParticleSystem as camera facing ribbons behind every
+        // particle: trailSegments segments (0 uses 16) spanning trailLifetime seconds (0 records
+        // every step). Trail and Ribbon particle types draw only the trail, Trail narrowing to the
+        // tail; enableTrails adds one behind sprites. trailWidth 0 follows the particle size
         bool enableTrails;
         float trailWidth;
         float trailLifetime;
         int trailSegments;
-        XMFLOAT4 trailColor;
+        XMFLOAT4 trailColor;                       // Tints the particle color; zero alpha is taken as white
         
         // Noise
         bool enableNoise;
@@ -171,21 +219,40 @@ public:
         float noiseFrequency;
         XMFLOAT3 noiseOffset;
         
-        // LOD
+        // LOD. Past lodDistance (0 uses the system's near distance) the emitter fades over
+        // lodFadeDistance (0 reaches the far distance) to lodMaxParticles and the distant update rate
         float lodDistance;
         float lodFadeDistance;
         int lodMaxParticles;
         
-        // Custom update function
+        // Custom update function. Runs per particle after the batched update, on a copy that only
+        // keeps the fields ParticleStreams has; a slow path for effects the curves cannot express
         std::function<void(Particle&, float)> customUpdateFunction;
         
+        // Simulated and drawn by GPUParticleSystem when it is available; the CPU then never sees
+        // the particles, so aliveParticleCount stays 0
+        bool gpuSimulation;
+        
         // Runtime data
-        std::vector<Particle> particles;
-        std::vector<XMFLOAT3> trailPositions;
+        ParticleStreams particles;
+        std::mt19937 random;                       // Emitters update in parallel, so each draws its own numbers
+        std::shared_ptr<GPUParticlePool> gpuPool;
+        std::vector<XMFLOAT4> colorTable;          // Over lifetime curves, sampled evenly for the kernels;
+        std::vector<XMFLOAT2> sizeTable;           // empty when the curve is
+        std::vector<float> speedTable;
+        std::vector<float> spinTable;
+        uint64_t curveHash;                        // Of the curves the tables were baked from
+        uint32_t curveVersion;                     // Counts bakes, so GPU copies know when to refresh
         float emissionTimer;
         float systemTime;
         int nextParticleIndex;
         bool hasEmittedBurst;
+        AABB bounds;                               // The particles at the last update and the emission shape
+        float lodFactor;                           // 1 up to the LOD distance, 0 once faded
+        float lodEmissionScale;                    // Set from lodFactor before each update
+        int lodParticleLimit;
+        float pendingTime;                         // Not yet simulated, while throttled or culled
+        bool culled;
         
         // Statistics
         int aliveParticleCount;
@@ -239,41 +306,107 @@ public:
                                      const XMFLOAT3& velocity) const;
     };
 
-    // GPU particle system for high-performance rendering
+    /**
+     * Compute simulation for emitters with gpuSimulation set.
+     *
+     * Each emitter gets a pool: a buffer of particle slots, a dead list of free slots and two
+     * alive lists that take turns as the input and output of a step. Emission consumes slots from
+     * the dead list and appends them to the alive list. The simulation kernel integrates, applies
+     * the force fields and collides against the scene's depth buffer, appending survivors to the
+     * other alive list and expired slots back to the dead list. List counts are copied from the
+     * UAV counters into the dispatch and DrawInstancedIndirect records on the GPU, so particle
+     * data and counts never come back to the CPU.
+     *
+     * Alpha blended pools are sorted back to front before they are drawn: a bitonic sort of
+     * (view depth, slot) pairs, sized on the GPU from the survivor count, whose output the vertex
+     * shader reads in place of the alive list. Additive pools don't depend on order and skip it.
+     *
+     * Stage() runs with the game update and only records what the next Simulate() should do;
+     * Simulate() and Render() run on the thread that owns the context.
+     */
     struct GPUParticleSystem {
-        ID3D11Buffer* vertexBuffer;
-        ID3D11Buffer* indexBuffer;
-        ID3D11Texture2D* particleTexture;
-        ID3D11ShaderResourceView* particleTextureSRV;
-        ID3D11InputLayout* inputLayout;
+        static constexpr UINT THREAD_GROUP_SIZE = 64;
+        static constexpr size_t MAX_FORCES = 8;
+        static constexpr UINT MAX_TRAIL_SEGMENTS = 64;
+
+        ID3D11Device* device;
+        ID3D11DeviceContext* context;
         
-        // Compute shader for particle updates (if supported)
+        ID3D11ComputeShader* emitComputeShader;
         ID3D11ComputeShader* updateComputeShader;
+        ID3D11ComputeShader* argumentsComputeShader;   // Alive count -> simulation and sort dispatch records
+        ID3D11ComputeShader* sortKeysComputeShader;    // Builds keys and sorts each block
+        ID3D11ComputeShader* sortMergeGlobalComputeShader;
+        ID3D11ComputeShader* sortMergeLocalComputeShader;
         ID3D11VertexShader* renderVertexShader;
+        ID3D11VertexShader* trailVertexShader;         // Ribbon segments from the trail history
         ID3D11PixelShader* renderPixelShader;
+        ID3D11Buffer* simulationConstants;
+        ID3D11Buffer* renderConstants;
+        ID3D11Buffer* sortConstants;
         
-        // Buffer for compute shader data
-        ID3D11Buffer* computeBuffer;
-        ID3D11ShaderResourceView* computeBufferSRV;
-        ID3D11UnorderedAccessView* computeBufferUAV;
+        ID3D11BlendState* alphaBlend;
+        ID3D11BlendState* additiveBlend;
+        ID3D11DepthStencilState* depthState;           // Tested, not written
+        ID3D11RasterizerState* rasterizerState;
+        ID3D11SamplerState* sampler;
+        ID3D11PixelShader* overridePixelShader;        // Debug views' replacements, not owned
+        ID3D11BlendState* overrideBlend;
         
-        // Vertex buffer streaming
-        void* mappedVertices;
-        int maxVertices;
-        int currentVertexCount;
+        std::mutex stagingMutex;
+        std::vector<std::weak_ptr<GPUParticlePool>> pools;
+        std::vector<std::shared_ptr<GPUParticlePool>> framePools;   // Pools being stepped this frame
+        uint32_t frameIndex;                           // Seeds emission
+        bool sortEnabled;                              // Sort alpha blended pools; read under stagingMutex
         
-        bool useGPUSimulation;
-        bool useInstancing;
+        GPUParticleSystem();
+        ~GPUParticleSystem();
         
-        void Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int maxParticles);
-        void UpdateGPUBuffer(const std::vector<Particle>& particles);
-        void Render(ID3D11DeviceContext* context, Camera* camera);
+        // False without feature level 11_0 compute or when a shader fails
+        bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+        // Creates pool, or replaces it when it does not hold maxParticles; false when that fails
+        bool EnsurePool(std::shared_ptr<GPUParticlePool>& pool, int maxParticles);
+        // Adds emitCount particles and deltaTime of simulation to the pool's next step, with the
+        // emitter's and forces' current settings
+        void Stage(GPUParticlePool& pool, const ParticleEmitter& emitter, const std::vector<ParticleForce>& forces,
+                   int emitCount, float deltaTime);
+        // Emits and steps every pool. depth is the bound depth target's contents for collision, or
+        // null; it is unbound from output while the kernels read it and bound again after
+        void Simulate(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, ID3D11ShaderResourceView* depth);
+        // Draws the pools stepped by the last Simulate() into the bound targets
+        void Render(const XMFLOAT4X4& view, const XMFLOAT4X4& projection);
+        // Orders the pool's survivors back to front; Simulate() calls it with the pool's constants bound
+        void Sort(GPUParticlePool& pool);
         void Cleanup();
     };
 
+    /**
+     * Emitter handle: slot index plus generation, so a handle to a removed emitter is rejected
+     */
+    struct EmitterHandle {
+        uint32_t index = 0xFFFFFFFFu;
+        uint32_t generation = 0;
+
+        bool IsValid() const { return index != 0xFFFFFFFFu; }
+        bool operator==(const EmitterHandle& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const EmitterHandle& other) const { return !(*this == other); }
+    };
+
     // Particle system manager
     struct ParticleSystemManager {
-        std::map<std::string, std::shared_ptr<ParticleEmitter>> emitters;
+        // Emitters are packed for the update, which walks them in order; removing one moves the
+        // last into its place. Handles find them through their slot, names through the handles
+        struct EmitterSlot {
+            uint32_t packed = 0xFFFFFFFFu;             // Index into emitters, or none while free
+            uint32_t generation = 0;
+        };
+        std::vector<std::shared_ptr<ParticleEmitter>> emitters;
+        std::vector<uint32_t> emitterSlots;            // Slot of each packed emitter
+        std::vector<EmitterSlot> slots;
+        std::vector<uint32_t> freeSlots;
+        std::unordered_map<std::string, EmitterHandle> names;
+        // Blocks of removed and finished emitters, reused before allocating; guarded by emitterMutex_
+        std::vector<ParticleStreams> sparePools;
         std::vector<ParticleForce> globalForces;
         std::vector<ParticleCollider> colliders;
         
@@ -298,6 +431,12 @@ public:
         void AddGlobalForce(const ParticleForce& force);
         void AddCollider(const ParticleCollider& collider);
         void SetLODSettings(float nearDist, float farDist, float cullDist);
+
+        EmitterHandle AddEmitter(std::shared_ptr<ParticleEmitter> emitter);
+        void RemoveEmitter(EmitterHandle handle);
+        ParticleEmitter* GetEmitter(EmitterHandle handle) const;
+        EmitterHandle FindEmitter(const std::string& name) const;
+        void ClearEmitters();
     };
 
 public:
@@ -308,10 +447,14 @@ public:
     bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
     void Shutdown();
 
-    // Emitter management
+    // Emitter management. Creating an emitter with a name in use replaces that emitter. Names are
+    // looked up in a hash table; code that touches an emitter every frame should keep its handle
     std::shared_ptr<ParticleEmitter> CreateEmitter(const std::string& name);
     void RemoveEmitter(const std::string& name);
+    void RemoveEmitter(EmitterHandle handle);
     std::shared_ptr<ParticleEmitter> GetEmitter(const std::string& name);
+    std::shared_ptr<ParticleEmitter> GetEmitter(EmitterHandle handle);
+    EmitterHandle FindEmitter(const std::string& name) const;
     void ClearEmitters();
 
     // Emitter control
@@ -319,7 +462,9 @@ public:
     void StopEmission(const std::string& name);
     void BurstEmission(const std::string& name, int count);
     void SetEmitterPosition(const std::string& name, const XMFLOAT3& position);
+    void SetEmitterPosition(EmitterHandle handle, const XMFLOAT3& position);
     void SetEmitterActive(const std::string& name, bool active);
+    void SetEmitterActive(EmitterHandle handle, bool active);
 
     // Particle effects presets
     void CreateFireEffect(const std::string& name, const XMFLOAT3& position);
@@ -342,12 +487,29 @@ public:
     void ClearColliders();
 
     // Performance and LOD
+    // CPU particles alive across all emitters; emission stops at the budget instead of growing
     void SetMaxParticles(int maxParticles);
+    // Updates per second of emitters at the far LOD distance, nearer ones blending up to every
+    // frame; 0 updates all of them every frame
     void SetUpdateFrequency(float frequency);
+    // With a view set, looping emitters outside the frustum or the cull distance stop simulating
+    // and catch up when seen again, and distant ones update less often and emit fewer particles
     void EnableLOD(bool enable);
     void SetLODDistances(float nearDist, float farDist, float cullDist);
+    // The camera LOD and culling measure from; call before Update()
+    void SetView(const XMFLOAT4X4& view, const XMFLOAT4X4& projection);
+    // Emitters update in parallel, and emitters with many particles split their update further.
+    // Custom update functions then run on job threads, several emitters at a time
     void EnableMultithreading(bool enable);
+    void SetJobSystem(JobSystem* jobs) { jobs_ = jobs; }
+    // Blood effects leave a splat in this decal layer on whatever lies below them; without
+    // decals or with a negative layer they leave nothing
+    void SetDecals(DecalSystem* decals, int bloodLayer) { decals_ = decals; bloodDecalLayer_ = bloodLayer; }
+    // Emitters draw their seeds from it as they're created, so a fixed seed repeats a run's effects
+    void SetRandomSeed(uint32_t seed) { randomGenerator_.seed(seed); }
+    // On by default where compute shaders are supported; change it while nothing is rendering
     void EnableGPUSimulation(bool enable);
+    bool IsGPUSimulationEnabled() const { return gpuSystem_ != nullptr; }
 
     // Rendering
     void SetSortParticles(bool sort);
@@ -358,6 +520,13 @@ public:
     // Update and render
     void Update(float deltaTime);
     void Render(Camera* camera);
+    // Steps and draws the GPU emitters into the bound render targets, colliding them with depth
+    // (the bound depth target's contents) when given. Binds its own pipeline state directly, so
+    // callers that cache state must invalidate it afterwards
+    void RenderGPU(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, ID3D11ShaderResourceView* depth);
+    // Replaces the GPU emitters' pixel shader and blend state in RenderGPU, as
+    // StateCache::SetPixelOverride does for cached draws; null shader restores them
+    void SetPixelOverride(ID3D11PixelShader* shader, ID3D11BlendState* blend);
 
     // Utility functions
     void WarmupEmitter(const std::string& name, float time);
@@ -382,13 +551,30 @@ public:
     bool LoadEmitterConfig(const std::string& name, const std::string& filePath);
 
 private:
+    static constexpr size_t CURVE_SAMPLES = 64;
+    static constexpr size_t PARALLEL_THRESHOLD = 16384;   // Particles per emitter
+    static constexpr size_t MAX_SPARE_POOLS = 16;
+    
     // Core particle simulation
-    void UpdateEmitter(std::shared_ptr<ParticleEmitter> emitter, float deltaTime);
-    void UpdateParticle(Particle& particle, float deltaTime);
-    void EmitParticle(std::shared_ptr<ParticleEmitter> emitter);
-    void ApplyForces(Particle& particle, float deltaTime);
-    void HandleCollisions(Particle& particle);
-    void UpdateTrails(std::shared_ptr<ParticleEmitter> emitter);
+    bool CanUseJobs() const;
+    void UpdateEmitter(ParticleEmitter& emitter, float deltaTime);
+    void UpdateGPUEmitter(ParticleEmitter& emitter, float deltaTime);
+    // Advances the emitter's clock; returns how many particles it emits this update
+    int CountEmissions(ParticleEmitter& emitter, float deltaTime);
+    // Ages, moves, forces, curves and collision planes for particles [begin, end), four at a time
+    void UpdateParticles(ParticleEmitter& emitter, size_t begin, size_t end, float deltaTime) const;
+    // Drops dead particles, moving the last live ones into their slots
+    void CompactParticles(ParticleEmitter& emitter);
+    // Samples the over lifetime curves into the emitter's tables when they changed since the last bake
+    void BakeCurves(ParticleEmitter& emitter) const;
+    void EmitParticle(ParticleEmitter& emitter);
+    // Sizes the emitter's block for maxParticles, from the spare pools when one is big enough
+    void ReservePool(ParticleEmitter& emitter);
+    // Hands the emitter's block to the spare pools, leaving it empty
+    void RecyclePool(ParticleEmitter& emitter);
+    // Takes up to wanted particles from the global budget; returns how many were granted
+    int ClaimParticles(int wanted);
+    bool IsFinished(const ParticleEmitter& emitter) const;
 
     // Interpolation and curves
     float InterpolateFloat(const std::vector<std::pair<float, float>>& curve, 
@@ -405,14 +591,22 @@ private:
 
     // Rendering helpers
     void RenderParticles(std::shared_ptr<ParticleEmitter> emitter, Camera* camera);
-    void RenderTrails(std::shared_ptr<ParticleEmitter> emitter, Camera* camera);
     void SetupRenderState(const ParticleEmitter& emitter);
     void SortParticles(std::shared_ptr<ParticleEmitter> emitter, Camera* camera);
 
     // LOD and culling
-    float CalculateLODFactor(const ParticleEmitter& emitter, Camera* camera) const;
-    bool ShouldCullEmitter(const ParticleEmitter& emitter, Camera* camera) const;
-    void ApplyLOD(std::shared_ptr<ParticleEmitter> emitter, float lodFactor);
+    static constexpr float FAST_FORWARD_STEP = 0.1f;      // Catching up after culling
+    // Decides how much of deltaTime the emitter simulates now, and simulates it
+    void TickEmitter(ParticleEmitter& emitter, float deltaTime);
+    float CalculateLODFactor(const ParticleEmitter& emitter) const;
+    bool ShouldCullEmitter(const ParticleEmitter& emitter) const;
+    void ApplyLOD(ParticleEmitter& emitter, float lodFactor) const;
+    // Simulates time in FAST_FORWARD_STEP steps, skipping what outlives every particle
+    void FastForward(ParticleEmitter& emitter, float time);
+    // Where the emitter's particles can be: its shape, grown by how far a particle can travel
+    // when the particles themselves aren't known (GPU emitters)
+    AABB PredictBounds(const ParticleEmitter& emitter, bool travel) const;
+    void UpdateBounds(ParticleEmitter& emitter) const;
 
     // Random number generation
     float RandomFloat(float min, float max);
@@ -435,6 +629,14 @@ private:
     
     // Random number generator
     std::mt19937 randomGenerator_;
+    JobSystem* jobs_;
+    DecalSystem* decals_;
+    int bloodDecalLayer_;
+    
+    // View for LOD and culling
+    bool viewValid_;
+    XMFLOAT3 viewPosition_;
+    Frustum viewFrustum_;
     
     // Performance settings
     bool lodEnabled_;
@@ -460,6 +662,8 @@ private:
     mutable int totalParticles_;
     mutable int activeEmitters_;
     mutable float lastUpdateTime_;
+    // What is left of maxTotalParticles this update; emitters claim from it concurrently
+    std::atomic<int> particleBudget_;
     
     // Threading
     std::vector<std::thread> workerThreads_;
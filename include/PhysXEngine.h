@@ -1,11 +1,14 @@
 #pragma once
 
+#include "PhysicsEngine.h"
 #include <PxPhysicsAPI.h>
 #include <DirectXMath.h>
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <map>
 #include <functional>
+#include <string>
 
 using namespace DirectX;
 using namespace physx;
@@ -18,6 +21,13 @@ class Camera;
 /**
  * Advanced PhysX-based Physics Engine with GPU acceleration and console support
  * Supports rigid bodies, soft bodies, fluids, particles, and destruction
+ *
+ * SimulationMode::GPU runs rigid body dynamics and the broadphase on a CUDA context
+ * (PxSceneFlag::eENABLE_GPU_DYNAMICS, PxBroadPhaseType::eGPU); Hybrid keeps dynamics on the CPU
+ * and moves only the broadphase. Without a usable CUDA device both fall back to CPU. PBD particle
+ * systems need the CUDA context in every mode. Contacts and triggers come back through the
+ * collision and trigger callbacks during the step whichever side simulated them, and every
+ * step publishes a render snapshot in the same format as PhysicsEngine's.
  */
 class PhysXEngine {
 public:
@@ -210,8 +220,9 @@ public:
     PxSoftBody* CreateSoftBody(Mesh* mesh, const XMFLOAT3& position);
     void SetSoftBodyProperties(PxSoftBody* softBody, float youngsModulus, float poissonsRatio, float damping);
 
-    // Particles
-    void CreateParticleSystem(int maxParticles, const XMFLOAT3& position);
+    // Particles (PBD, GPU only). CreateParticleSystem returns the system's ID, or -1 without a
+    // CUDA context
+    int CreateParticleSystem(int maxParticles, const XMFLOAT3& position);
     void EmitParticles(int particleSystemId, const XMFLOAT3& position, const XMFLOAT3& velocity, int count);
     void SetParticleProperties(int particleSystemId, float mass, float radius, float damping);
 
@@ -247,7 +258,13 @@ public:
     void SetDebugVisualizationParameter(PxVisualizationParameter::Enum param, float value);
     void RenderDebugData(Camera* camera);
 
+    // Render snapshot of dynamic actors and particles, published after each step. Acquire pins
+    // the latest one until Release; at most one reader at a time
+    RenderObjectView AcquireRenderSnapshot() const;
+    void ReleaseRenderSnapshot() const;
+
     // Performance and statistics
+    bool IsGPUDynamicsActive() const { return gpuDynamicsEnabled_; }
     PxSimulationStatistics GetSimulationStatistics() const;
     void SetThreadCount(int numThreads);
     void OptimizeGPUMemory();
@@ -306,6 +323,27 @@ private:
     // Platform-specific
     void* platformContext_;
 
+    // PBD particle system with one buffer; particles live in GPU memory
+    struct ParticleSystem {
+        PxPBDParticleSystem* system = nullptr;
+        PxParticleBuffer* buffer = nullptr;
+        PxPBDMaterial* material = nullptr;
+        PxU32 phase = 0;
+        PxU32 maxParticles = 0;
+        PxU32 activeParticles = 0;
+        PxU32 nextParticle = 0;                    // Emission wraps around, replacing the oldest
+        float radius = 0.05f;
+        float inverseMass = 1.0f;
+    };
+    std::vector<ParticleSystem> particleSystems_;
+
+    // Render snapshot, double buffered as in PhysicsEngine
+    std::vector<RenderObject> snapshots_[2];
+    std::atomic<int> frontSnapshot_;
+    mutable std::atomic<int> readingSnapshot_;    // -1 when no reader holds a snapshot
+    std::vector<PxActor*> actorScratch_;
+    std::vector<PxVec4> particleScratch_;          // Host copy of particle positions
+
     // Internal helpers
     void InitializePhysX();
     void InitializeCooking();
@@ -313,6 +351,13 @@ private:
     void InitializeMaterials();
     void SetupScene();
     PxMaterial* GetOrCreateMaterial(MaterialType type);
+    // Shape for a desc with its collision filter and trigger flags applied
+    PxShape* CreateShape(const RigidBodyDesc& desc);
+    void SimulateStep(float timeStep);
+    void PublishRenderSnapshot();
+    static PxFilterFlags FilterShader(PxFilterObjectAttributes attributes0, PxFilterData filterData0,
+                                      PxFilterObjectAttributes attributes1, PxFilterData filterData1,
+                                      PxPairFlags& pairFlags, const void* constantBlock, PxU32 constantBlockSize);
     
     // Callback implementation
     class SimulationEventCallback : public PxSimulationEventCallback {
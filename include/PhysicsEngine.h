@@ -1,12 +1,24 @@
 #pragma once
 
 #include "Platform.h"
+#include "FrameAllocator.h"
+#include "ECS.h"
+#include "Components.h"
 #include <vector>
+#include <atomic>
 #include <memory>
 #include <functional>
+#include <unordered_map>
 
 namespace Nexus {
 
+class BroadPhase;
+class ConstraintSolver;
+class HeightfieldCollider;
+class JobSystem;
+class PhysicsSnapshot;
+class TriangleMeshCollider;
+
 // Use DirectX math types consistently
 using PhysicsVector3 = DirectX::XMFLOAT3;
 using PhysicsQuaternion = DirectX::XMFLOAT4;
@@ -30,6 +42,8 @@ struct PhysicsTransform {
 using RigidBodyID = uintptr_t;
 using RagdollID = int;
 using ConstraintID = int;
+using StaticColliderID = int;
+using CharacterID = int;
 
 struct CollisionShape {
     enum class Type {
@@ -76,17 +90,31 @@ struct CollisionShape {
 // Structure for objects that can be rendered
 struct RenderObject {
     DirectX::XMFLOAT3 position;
+    DirectX::XMFLOAT3 previousPosition; // Position at the previous simulation step, used for interpolation
     DirectX::XMFLOAT3 scale;
     DirectX::XMFLOAT4 color;
     CollisionShape::Type shapeType;
     
     RenderObject() 
         : position(0.0f, 0.0f, 0.0f)
+        , previousPosition(0.0f, 0.0f, 0.0f)
         , scale(1.0f, 1.0f, 1.0f)
         , color(1.0f, 1.0f, 1.0f, 1.0f)
         , shapeType(CollisionShape::Type::Box) {}
 };
 
+// Read-only view over a published render snapshot (no copy)
+struct RenderObjectView {
+    const RenderObject* data = nullptr;
+    size_t count = 0;
+    
+    const RenderObject* begin() const { return data; }
+    const RenderObject* end() const { return data + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const RenderObject& operator[](size_t index) const { return data[index]; }
+};
+
 // Simple physics object for the simplified engine
 struct SimplePhysicsObject {
     DirectX::XMFLOAT3 position;
@@ -112,6 +140,25 @@ struct PhysicsMaterial {
 // Collision detection callback types
 using CollisionCallback = std::function<void(RigidBodyID, RigidBodyID, const PhysicsVector3&)>;
 
+// One touching pair's change over a step. Contacts between the same two bodies (several against
+// static geometry) make one event, at the deepest point
+struct CollisionEvent {
+    enum Type : uint32_t {
+        BEGIN = 1 << 0,                    // Touching this step, not the step before
+        PERSIST = 1 << 1,
+        END = 1 << 2,                      // Apart, or one body was removed
+        ALL = BEGIN | PERSIST | END
+    };
+    
+    RigidBodyID bodyA;
+    RigidBodyID bodyB;                     // PhysicsEngine::NO_BODY for static geometry
+    PhysicsVector3 point;                  // END keeps the last contact's point and normal
+    PhysicsVector3 normal;                 // From A towards B
+    float impulse;                         // Applied along the normal this step; 0 for END
+    uint32_t categories;                   // Both bodies' event categories together
+    Type type;
+};
+
 // Main physics engine class
 class PhysicsEngine {
 public:
@@ -130,8 +177,27 @@ public:
     
     // Getters
     std::vector<RenderObject> GetRenderObjects() const;
+    // Blends previous and current simulation state (alpha = 0 previous step, 1 current step)
+    std::vector<RenderObject> GetInterpolatedRenderObjects(float alpha) const;
+    // Same as above but fills caller-owned (typically frame arena) storage, no heap traffic
+    void GetInterpolatedRenderObjects(float alpha, FrameVector<RenderObject>& out) const;
+    size_t GetRenderObjectCount() const;
     
-    // Basic physics body creation
+    // Double-buffered render snapshot: the simulation publishes into the back buffer after
+    // stepping while the renderer reads the last completed state through a view. One reader
+    // at a time; while a snapshot is held, publishing never overwrites it.
+    void PublishRenderSnapshot();
+    RenderObjectView AcquireRenderSnapshot() const;
+    void ReleaseRenderSnapshot() const;
+    
+    // Bodies live in an ECS world; the engine shares its world, must be set before Initialize()
+    void SetWorld(World* world);
+    World* GetWorld() const { return world_; }
+    // Large scenes integrate their chunks in parallel when a job system is set
+    void SetJobSystem(JobSystem* jobs);
+    
+    // Basic physics body creation. Boxes take their full size from dimensions; capsules collide
+    // as their bounding box
     RigidBodyID CreateRigidBody(const CollisionShape& shape, const PhysicsTransform& transform, 
                                float mass = 1.0f, const PhysicsMaterial& material = PhysicsMaterial());
     
@@ -143,15 +209,140 @@ public:
     void ApplyForce(RigidBodyID bodyId, const PhysicsVector3& force);
     void ApplyImpulse(RigidBodyID bodyId, const PhysicsVector3& impulse);
     
+    // Batched forms of the above for script and C callers driving many bodies; entry i applies
+    // to bodyIds[i], and unknown bodies are skipped (GetBodyPositions leaves their slot as is).
+    // SetBodyPositions keeps rotation and scale
+    void SetBodyPositions(const RigidBodyID* bodyIds, const PhysicsVector3* positions, size_t count);
+    void GetBodyPositions(const RigidBodyID* bodyIds, PhysicsVector3* positions, size_t count) const;
+    void SetBodyVelocities(const RigidBodyID* bodyIds, const PhysicsVector3* velocities, size_t count);
+    void ApplyImpulses(const RigidBodyID* bodyIds, const PhysicsVector3* impulses, size_t count);
+    
     // Body management
     void RemoveRigidBody(RigidBodyID bodyId);
+    // Bodies whose contact island stays slow for a while fall asleep and cost nothing per step
+    // until a contact with an awake body, an impulse, a velocity or transform change, or an
+    // explosion wakes them. Inactive means asleep; static bodies sleep as soon as they settle
     void SetBodyActive(RigidBodyID bodyId, bool active);
     bool IsBodyActive(RigidBodyID bodyId) const;
+    // Continuous collision: a body that moves more than half its size in one step is swept as
+    // the largest sphere inside it from where the step began, and stops short of the first body
+    // it would otherwise pass through. Lets fast bodies keep a low tick rate without tunneling.
+    // Opt in per body, or for every dynamic body at once
+    void SetBodyContinuous(RigidBodyID bodyId, bool continuous);
+    bool IsBodyContinuous(RigidBodyID bodyId) const;
+    void SetContinuousCollision(bool enabled) { continuousForAll_ = enabled; }
     
-    // Collision detection
+    // Simulation regions, so the cost of a step follows what is around the foci (the world
+    // partition's streaming sources) rather than how many bodies the world holds. Distances are
+    // on the ground plane to the nearest focus. Near bodies step every step. Mid bodies step
+    // together once every midInterval steps over the time gathered since, are never swept, and
+    // keep only their deepest contact with static geometry. Far bodies freeze where they are:
+    // asleep and no more than obstacles, but with their velocity kept, so they carry on as they
+    // were once a focus comes back within farDistance. A contact island takes the tier of its
+    // nearest body, and a near body touching or jointed to a mid one pulls it in at once. Tiers
+    // are set again on each mid step and change only past a boundary by the hysteresis. Without
+    // a focus every body is near. Tiers are not part of SaveState(); replays that must match
+    // leave regions off
+    enum class SimulationTier : uint8_t { Near, Mid, Far };
+    struct SimulationRegions {
+        float nearDistance = 40.0f;
+        float farDistance = 112.0f;        // Raised to nearDistance if smaller
+        float hysteresis = 8.0f;
+        uint32_t midInterval = 4;          // At least 1
+        float cellSize = 64.0f;            // Frozen bodies are found by cell; WorldPartition sets its own
+    };
+    struct SimulationStats {
+        uint32_t nearBodies = 0;           // Awake dynamic bodies, as of the last mid step
+        uint32_t midBodies = 0;
+        uint32_t frozenBodies = 0;
+    };
+    void SetSimulationRegions(const SimulationRegions& regions);
+    const SimulationRegions& GetSimulationRegions() const { return regions_; }
+    void SetSimulationFocus(uint32_t id, const PhysicsVector3& position);
+    void RemoveSimulationFocus(uint32_t id);
+    SimulationTier GetBodySimulationTier(RigidBodyID bodyId) const;
+    const SimulationStats& GetSimulationStats() const { return simulationStats_; }
+    
+    // Rollback and replays. A step is deterministic: the same state and the same calls give
+    // bit-identical results on the same build, however the job system splits the work, since
+    // contacts are solved in broadphase pair order and fast bodies are swept in entity order.
+    // SaveState() records every body (position, velocity, sleep state) and the last step's
+    // contacts; the solver starts each step cold, so there is nothing to warm-start. Restoring
+    // puts the saved bodies back as they were and wakes or sleeps them to match; bodies created
+    // since are left alone, and the result is false if a saved body no longer exists. Joints,
+    // gravity and shapes are scene setup, not state, and are not saved
+    void SaveState(PhysicsSnapshot& snapshot) const;
+    bool RestoreState(const PhysicsSnapshot& snapshot);
+    
+    // Collision detection. Bodies are boxes or spheres (by their renderable shape) with the
+    // transform scale as half extents; contacts are found through the broadphase each step and
+    // the callback runs once per contact after it is resolved
     void SetCollisionCallback(CollisionCallback callback);
     std::vector<RigidBodyID> GetCollidingBodies(RigidBodyID bodyId) const;
     
+    // Collision events, gathered once per step in pair order and kept until the next step, for
+    // systems to read in bulk rather than be called per contact. Each body carries category bits
+    // (DEFAULT_EVENT_CATEGORY unless set; 0 keeps it out of every event but its partner's), and
+    // readers ask for the categories and types they handle. Pairs asleep together are still
+    // touching: they end when they wake and part, not when they fall asleep
+    static constexpr uint32_t DEFAULT_EVENT_CATEGORY = 1u;
+    void SetBodyEventCategories(RigidBodyID bodyId, uint32_t categories);
+    const std::vector<CollisionEvent>& GetCollisionEvents() const { return collisionEvents_; }
+    // Appends the last step's events of the given types that involve any of the categories;
+    // returns how many were added
+    size_t GetCollisionEvents(std::vector<CollisionEvent>& events, uint32_t categoryMask,
+                              uint32_t typeMask = CollisionEvent::ALL) const;
+    const BroadPhase* GetBroadPhase() const { return broadPhase_.get(); }
+    const ConstraintSolver* GetSolver() const { return solver_.get(); }
+    
+    // Static geometry: terrain and level meshes that bodies collide with but that never move.
+    // Colliders are shared, so one baked mesh can be placed many times. A placement is a
+    // position and a per-axis scale (signs ignored); static geometry does not rotate any more
+    // than bodies do. Awake bodies collide with the triangles under their bounds, keeping the
+    // deepest few contacts per body, and those contacts report NO_BODY as the other body. Rays
+    // and continuous sweeps hit static geometry too; swept spheres in CastBatch do not yet.
+    // Returns 0 if the collider is empty
+    StaticColliderID AddHeightfield(std::shared_ptr<const HeightfieldCollider> heightfield,
+                                    const PhysicsVector3& position, const PhysicsVector3& scale);
+    StaticColliderID AddTriangleMesh(std::shared_ptr<const TriangleMeshCollider> mesh,
+                                     const PhysicsVector3& position, const PhysicsVector3& scale);
+    void RemoveStaticCollider(StaticColliderID colliderId);
+    // The infinite floor under everything, on at y = 0 by default. Turn it off once terrain
+    // takes over, or bodies cannot go below it
+    void SetGroundPlane(bool enabled, float height);
+    
+    // Character controllers: kinematic capsules for players and AI, moved by the caller rather
+    // than simulated. A move sweeps the capsule against bodies, static geometry and the ground
+    // plane and slides along what it hits. Ledges up to stepHeight are climbed, slopes steeper
+    // than maxSlope act as walls, and a grounded character follows the ground down steps and
+    // slopes instead of flying off them. Bodies are obstacles, never pushed, and characters
+    // pass through each other. The position is the capsule's center
+    struct CharacterSettings {
+        float radius = 0.4f;
+        float height = 1.8f;               // Caps included; at least 2 * radius
+        float stepHeight = 0.35f;
+        float maxSlope = 0.785f;           // Radians from horizontal
+        float skinWidth = 0.02f;           // Gap kept from whatever the capsule touches
+    };
+    struct CharacterState {
+        PhysicsVector3 position;
+        PhysicsVector3 velocity;           // The last move as resolved, over its delta time
+        PhysicsVector3 groundNormal;       // Up while not grounded
+        RigidBodyID groundBody;            // NO_BODY for static geometry, the ground plane or none
+        bool grounded;                     // Standing on a walkable surface
+    };
+    CharacterID CreateCharacter(const CharacterSettings& settings, const PhysicsVector3& position);
+    void DestroyCharacter(CharacterID characterId);
+    // Teleports without sweeping; the character stays grounded if it was
+    void SetCharacterPosition(CharacterID characterId, const PhysicsVector3& position);
+    bool GetCharacterState(CharacterID characterId, CharacterState& state) const;
+    // Moves characters[i] by displacements[i], gravity included as the caller wants it; unknown
+    // characters are skipped and none may appear twice. The whole batch resolves together,
+    // spread across the job system, so move every character in one call per frame rather than
+    // one call each
+    void MoveCharacters(const CharacterID* characters, const PhysicsVector3* displacements, size_t count,
+                        float deltaTime);
+    
     // Ragdoll physics
     struct RagdollDefinition {
         struct Bone {
@@ -182,7 +373,11 @@ public:
     void SetRagdollActive(RagdollID ragdollId, bool active);
     std::vector<PhysicsTransform> GetRagdollBoneTransforms(RagdollID ragdollId) const;
     
-    // Constraint system
+    // Constraint system. Frames give each anchor in its body's space, or in world space when a
+    // body ID names no body (such as NO_BODY). Bodies never rotate, so every type holds anchors together: Point,
+    // Hinge and ConeTwist pin them, Slider frees the offset along frameA's x axis within the
+    // x limits, Generic6DOF keeps it within the limits along frameA's axes (min > max frees an
+    // axis). Constraints are solved with contacts, spread across the job system by color
     enum class ConstraintType {
         Point,
         Hinge,
@@ -208,6 +403,23 @@ public:
     RaycastResult Raycast(const PhysicsVector3& from, const PhysicsVector3& to) const;
     std::vector<RaycastResult> RaycastAll(const PhysicsVector3& from, const PhysicsVector3& to) const;
     
+    // Batched queries for callers with many rays per frame (line of sight, occlusion). Rays
+    // are cast in packets of four through the broadphase tree, packets spread across the job
+    // system, and each query's closest hit lands at the same index of results. A radius sweeps
+    // a sphere instead; its hitPoint is the sphere's center at impact, and box corners count as
+    // square rather than rounded
+    static constexpr RigidBodyID NO_BODY = 0xFFFFFFFFu;   // The ID of an invalid entity
+    struct RayQuery {
+        PhysicsVector3 from;
+        PhysicsVector3 to;
+        float radius = 0.0f;
+        RigidBodyID ignoreBody = NO_BODY;   // Typically the caster itself
+    };
+    void CastBatch(const RayQuery* queries, size_t count, RaycastResult* results) const;
+    // Returns once the work is queued; results are ready when the counter is done (see
+    // JobSystem::Wait). Queries and results must outlive it; the next step waits for it
+    void CastBatchAsync(const RayQuery* queries, size_t count, RaycastResult* results, JobCounter& counter) const;
+    
     // Advanced features
     void SetGravity(const PhysicsVector3& gravity);
     PhysicsVector3 GetGravity() const;
@@ -220,19 +432,185 @@ public:
     
 private:
     bool initialized_;
-    std::vector<SimplePhysicsObject> physicsObjects_;
-    std::vector<RenderObject> renderObjects_;
+    World* world_;
+    std::unique_ptr<World> ownedWorld_;
+    std::vector<Entity> bodies_;          // Entities created by this engine, destroyed on shutdown
+    JobSystem* jobs_;
+    
+    std::vector<RenderObject> snapshots_[2];
+    std::atomic<int> frontSnapshot_;
+    mutable std::atomic<int> readingSnapshot_; // -1 when no reader holds a snapshot
     CollisionCallback collisionCallback_;
     PhysicsVector3 gravity_;
     float worldScale_;
     bool debugDrawing_;
     
+    // Collision
+    struct Contact {
+        RigidBodyID bodyA;
+        RigidBodyID bodyB;
+        PhysicsVector3 point;
+        PhysicsVector3 normal;             // From A towards B
+        float depth;
+    };
+    std::unique_ptr<BroadPhase> broadPhase_;
+    std::vector<Contact> contacts_;
+    uint32_t proxySweepCursor_;           // Next proxy checked for a body destroyed behind our back
+    bool continuousForAll_;
+    std::vector<Entity> sweptBodies_;     // Fast bodies this step, in entity order
+    std::vector<uint32_t> contactRows_;   // Solver row of each contact in the current solve, or ConstraintSolver::NO_ROW
+    std::vector<float> contactImpulses_;  // Applied along each contact this step
+    
+    // Collision events. touching_ holds each touching pair's latest event, sorted by pair
+    std::vector<CollisionEvent> collisionEvents_;
+    std::vector<CollisionEvent> touching_;
+    std::vector<CollisionEvent> touchingScratch_;
+    std::vector<uint32_t> eventOrder_;
+    
+    // Static geometry; exactly one of heightfield and mesh is set
+    struct StaticCollider {
+        StaticColliderID id;
+        std::shared_ptr<const HeightfieldCollider> heightfield;
+        std::shared_ptr<const TriangleMeshCollider> mesh;
+        PhysicsVector3 position;
+        PhysicsVector3 scale;
+        PhysicsVector3 boundsMin;          // World space
+        PhysicsVector3 boundsMax;
+    };
+    std::vector<StaticCollider> staticColliders_;
+    StaticColliderID nextStaticColliderId_;
+    bool groundEnabled_;
+    float groundHeight_;
+    uint32_t staticVersion_;              // Bumped whenever static colliders come or go
+    
+    // Characters. Each keeps the static triangles around it from its last query and reuses
+    // them until a move leaves their bounds or static geometry changes
+    struct Character {
+        CharacterID id;
+        CharacterSettings settings;
+        CharacterState state;
+        PhysicsVector3 cacheMin;
+        PhysicsVector3 cacheMax;
+        uint32_t cacheVersion;
+        std::vector<PhysicsVector3> triangles;   // Three corners each, world space
+    };
+    std::vector<Character> characters_;
+    std::unordered_map<CharacterID, size_t> characterIndices_;
+    CharacterID nextCharacterId_;
+    std::vector<size_t> moveCharacters_;  // Character index of each move in a batch, or SIZE_MAX
+    std::vector<Entity> moveBodies_;      // Bodies near each move, found up front since tree queries share a stack
+    std::vector<uint32_t> moveBodyStarts_;
+    
+    // Constraints
+    struct Joint {
+        ConstraintID id;
+        ConstraintType type;
+        Entity bodyA;
+        Entity bodyB;
+        bool worldA;                       // Anchored to the world rather than a body
+        bool worldB;
+        PhysicsTransform frameA;
+        PhysicsTransform frameB;
+        PhysicsVector3 minLimits;
+        PhysicsVector3 maxLimits;
+    };
+    struct Ragdoll {
+        std::vector<Entity> bones;
+        std::vector<ConstraintID> joints;
+    };
+    std::unique_ptr<ConstraintSolver> solver_;
+    std::vector<Joint> joints_;
+    std::unordered_map<ConstraintID, size_t> jointIndices_;
+    std::unordered_map<uint64_t, uint32_t> jointedPairs_;   // Joints per body pair; such pairs never collide
+    std::unordered_map<RagdollID, Ragdoll> ragdolls_;
+    ConstraintID nextConstraintId_;
+    RagdollID nextRagdollId_;
+    std::vector<PhysicsBodyComponent*> solverBodies_;   // By solver index, valid during one solve
+    std::vector<TransformComponent*> solverTransforms_;
+    
+    mutable JobCounter queryJobs_;        // Async batches still running
+    
+    // Sleeping
+    std::vector<Entity> islandBodies_;    // Awake bodies by island slot
+    std::vector<uint32_t> islandParents_; // Union-find over island slots
+    std::vector<uint32_t> islandResting_; // Fewest resting steps in each island, by root slot
+    std::vector<Entity> wakeList_;
+    
+    // Simulation regions. Frozen bodies are listed by cell; entries go stale when a body wakes
+    // some other way and are dropped when their cell is next looked at
+    struct Focus {
+        uint32_t id;
+        PhysicsVector3 position;
+    };
+    SimulationRegions regions_;
+    SimulationStats simulationStats_;
+    std::vector<Focus> foci_;
+    std::unordered_map<uint64_t, std::vector<Entity>> frozenCells_;
+    std::vector<uint8_t> islandTiers_;    // Nearest tier in each island, by root slot
+    std::vector<Entity> freezeList_;
+    float midElapsed_;                    // Since mid bodies last stepped, this step included
+    uint32_t midSteps_;
+    bool midStepDue_;                     // Mid bodies step this step
+    
     // Internal helpers
+    Entity CreateDemoBody(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& scale,
+                          const DirectX::XMFLOAT4& color, CollisionShape::Type shapeType, float mass);
+    void DestroyBodies();
+    template<typename Container>
+    void ExtractRenderObjects(float alpha, Container& out) const;
     void UpdateRenderObjects();
     void ProcessCollisions();
-    void ApplyGravity(float deltaTime);
     void IntegrateVelocities(float deltaTime);
-    void ResolveCollisions();
+    void SolveConstraints(float deltaTime);
+    // Solves the awake bodies of one tier; the rest hold still
+    void SolveTier(SimulationTier tier, float deltaTime);
+    void SweepFastBodies();
+    void CollideStaticGeometry();
+    StaticColliderID AddStaticCollider(StaticCollider collider, const PhysicsVector3& localMin,
+                                       const PhysicsVector3& localMax);
+    // Closest hit on any static collider, as RayCastShape
+    bool RayCastStatic(const PhysicsVector3& from, const PhysicsVector3& delta, float maxFraction, float& fraction,
+                       PhysicsVector3& normal) const;
+    void UpdateBroadPhase(float deltaTime);
+    // One character's move against the bodies a batch found near it
+    void MoveCharacter(Character& character, const PhysicsVector3& displacement, const Entity* bodies,
+                       size_t bodyCount, float deltaTime) const;
+    void UpdateSleeping();
+    // One event per touching pair in contacts_, merged and sorted by pair, types left unset
+    void GatherTouchingPairs(std::vector<CollisionEvent>& touches);
+    void UpdateCollisionEvents();
+    uint32_t FindIsland(uint32_t slot);
+    void WakeBody(Entity entity);
+    void SleepBody(Entity entity);
+    // A mid body between its steps
+    bool IsIdle(const PhysicsBodyComponent& body) const;
+    void UpdateSimulationRegions();
+    void FreezeBody(Entity entity);
+    float GetFocusDistance(const PhysicsVector3& position) const;
+    uint64_t GetRegionCell(const PhysicsVector3& position) const;
+    void DestroyBody(Entity entity);
+    void CastPackets(const RayQuery* queries, size_t count, RaycastResult* results, size_t firstPacket,
+                     size_t endPacket) const;
+    void WaitForQueries() const;
+};
+
+/**
+ * RAII helper holding the current render snapshot for the duration of a scope
+ */
+class RenderSnapshotScope {
+public:
+    explicit RenderSnapshotScope(const PhysicsEngine& physics)
+        : physics_(physics), view_(physics.AcquireRenderSnapshot()) {}
+    ~RenderSnapshotScope() { physics_.ReleaseRenderSnapshot(); }
+    
+    RenderSnapshotScope(const RenderSnapshotScope&) = delete;
+    RenderSnapshotScope& operator=(const RenderSnapshotScope&) = delete;
+    
+    const RenderObjectView& GetView() const { return view_; }
+    
+private:
+    const PhysicsEngine& physics_;
+    RenderObjectView view_;
 };
 
 } // namespace Nexus
@@ -11,6 +11,7 @@ class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
 class btDbvtBroadphase;
 class btSequentialImpulseConstraintSolver;
+class btConstraintSolverPoolMt;
 class btRigidBody;
 class btCollisionShape;
 class btTransform;
@@ -20,6 +21,9 @@ class btQuaternion;
 
 namespace Nexus {
 
+class JobSystem;
+class BulletTaskScheduler;
+
 // Use DirectX math types consistently
 using PhysicsVector3 = DirectX::XMFLOAT3;
 using PhysicsQuaternion = DirectX::XMFLOAT4;
@@ -207,6 +211,9 @@ public:
     PhysicsEngine();
     ~PhysicsEngine();
     
+    // With NEXUS_BULLET_MT_ENABLED, Initialize() builds the multithreaded world on this job
+    // system; without one it falls back to the single-threaded world
+    void SetJobSystem(JobSystem* jobs) { jobs_ = jobs; }
     bool Initialize();
     void Shutdown();
     
@@ -296,6 +303,9 @@ private:
     btCollisionDispatcher* dispatcher_;
     btDbvtBroadphase* broadphase_;
     btSequentialImpulseConstraintSolver* solver_;
+    btConstraintSolverPoolMt* solverPool_;            // Multithreaded world only
+    JobSystem* jobs_;
+    BulletTaskScheduler* taskScheduler_;
     
     // Storage for rigid bodies and shapes
     std::map<RigidBodyID, btRigidBody*> rigidBodies_;
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Saved physics world state for rollback networking and replays.
+ *
+ * PhysicsEngine::SaveState() writes one contiguous buffer: a header, every body in entity index
+ * order, then the last step's contacts. The buffer keeps its capacity, so saving into the same
+ * snapshot every frame stops allocating once it has grown to the scene; a rollback ring is a
+ * handful of snapshots reused in turn. Restoring copies the records straight back into the
+ * bodies' components.
+ *
+ * Snapshots of one scene differ only where bodies moved, so Diff() encodes a snapshot against
+ * an earlier one for the wire: the bytes are XORed with the base, which zeroes every body that
+ * did not change, and runs of zeros collapse to a length. Patch() rebuilds the snapshot from the
+ * same base.
+ */
+class PhysicsSnapshot {
+public:
+    static constexpr uint32_t MAGIC = 0x50534E58;   // "XNSP"
+    static constexpr uint32_t VERSION = 1;
+
+    enum BodyFlags : uint32_t {
+        BODY_SLEEPING = 1 << 0,
+        BODY_CONTINUOUS = 1 << 1
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t bodyCount;
+        uint32_t contactCount;
+    };
+
+    struct Body {
+        uint32_t index;                        // Entity
+        uint32_t generation;
+        DirectX::XMFLOAT3 position;
+        DirectX::XMFLOAT3 previousPosition;
+        DirectX::XMFLOAT3 velocity;
+        float mass;
+        uint32_t restingSteps;
+        uint32_t flags;                        // BodyFlags
+    };
+
+    struct Contact {
+        uint64_t bodyA;                        // Packed entities, as RigidBodyID
+        uint64_t bodyB;
+        DirectX::XMFLOAT3 point;
+        DirectX::XMFLOAT3 normal;
+        float depth;
+        uint32_t padding;
+    };
+
+    // Sizes the buffer for the counts and writes the header; records are left to the caller
+    void Reset(size_t bodyCount, size_t contactCount);
+    void Clear() { data_.clear(); }
+
+    // False for an empty buffer or one from another version
+    bool IsValid() const;
+    size_t GetBodyCount() const { return IsValid() ? GetHeader().bodyCount : 0; }
+    size_t GetContactCount() const { return IsValid() ? GetHeader().contactCount : 0; }
+    Body* GetBodies() { return reinterpret_cast<Body*>(data_.data() + sizeof(Header)); }
+    const Body* GetBodies() const { return reinterpret_cast<const Body*>(data_.data() + sizeof(Header)); }
+    Contact* GetContacts() { return reinterpret_cast<Contact*>(GetBodies() + GetHeader().bodyCount); }
+    const Contact* GetContacts() const { return reinterpret_cast<const Contact*>(GetBodies() + GetHeader().bodyCount); }
+
+    const uint8_t* GetData() const { return data_.data(); }
+    size_t GetSize() const { return data_.size(); }
+
+    // Overwrites delta with target encoded against base
+    static void Diff(const PhysicsSnapshot& base, const PhysicsSnapshot& target, std::vector<uint8_t>& delta);
+    // Rebuilds target from base and a delta written by Diff(); false if the delta is malformed,
+    // which leaves target invalid. target must not be base
+    static bool Patch(const PhysicsSnapshot& base, const uint8_t* delta, size_t size, PhysicsSnapshot& target);
+
+private:
+    const Header& GetHeader() const { return *reinterpret_cast<const Header*>(data_.data()); }
+
+    std::vector<uint8_t> data_;
+};
+
+static_assert(sizeof(PhysicsSnapshot::Header) % 8 == 0 && sizeof(PhysicsSnapshot::Body) % 8 == 0,
+              "Contacts follow the bodies 8-byte aligned");
+
+} // namespace Nexus
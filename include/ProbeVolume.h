@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+class Light;
+class PhysicsEngine;
+class StateCache;
+
+/**
+ * Grid of spherical-harmonic irradiance probes: a cache of diffuse indirect light for a level.
+ *
+ * Each probe keeps the incoming radiance around its position as SH coefficients, nine per color
+ * channel at order L2 or four at L1. The GPU copy is cosine-convolved and divided by pi, so a
+ * shader evaluating it at a normal gets the diffuse light to multiply by albedo, in the same units
+ * as LightingSettings' flat ambient term. The coefficients are packed into RGBA16F planes stacked
+ * along z of one volume texture (3 planes at L1, 7 at L2). Sampling clamps each plane half a
+ * texel inside, so hardware trilinear filtering blends the eight surrounding probes without
+ * bleeding between planes. GetShaderSource() declares SampleProbeIrradiance() for the deferred
+ * lighting shader; PBR_PS.hlsl carries the same code under its PROBE_VOLUME keyword.
+ *
+ * Update() relights probesPerFrame probes in round-robin order at a fixed cost. It casts
+ * raysPerProbe rays from each of them, spread by a spherical Fibonacci pattern that is randomly
+ * rotated each time, and projects what they see into SH. A ray that escapes sees the sky color.
+ * A ray that hits a front face sees the direct light at the hit point, with its own shadow ray
+ * per light, plus the volume's current irradiance there, scaled by bounceAlbedo. Each update
+ * therefore adds one more bounce of indirect light. Back faces are black, so probes buried in
+ * walls darken instead of leaking light. By default rays go through the physics engine's
+ * colliders; SetRadianceFunction() swaps in any other source, such as ray tracing or an offline
+ * path tracer. New results blend with the old by hysteresis to hide noise.
+ *
+ * Bake() relights every probe a number of times, and Save()/Load() keep the result beside the
+ * level so it can be loaded baked and refreshed incrementally from there.
+ */
+class ProbeVolume {
+public:
+    static constexpr UINT L1_COEFFICIENTS = 4;
+    static constexpr UINT L2_COEFFICIENTS = 9;
+    static constexpr UINT TEXTURE_SLOT = 13;
+    static constexpr UINT CONSTANT_SLOT = 3;
+    static constexpr UINT SAMPLER_SLOT = 2;
+
+    struct Settings {
+        DirectX::XMFLOAT3 origin = { 0.0f, 0.0f, 0.0f };    // Position of probe (0, 0, 0)
+        DirectX::XMFLOAT3 spacing = { 4.0f, 4.0f, 4.0f };
+        UINT countX = 16;
+        UINT countY = 4;
+        UINT countZ = 16;
+        bool l2 = true;                 // Nine coefficients instead of four; sharper directionality
+        UINT probesPerFrame = 16;
+        UINT raysPerProbe = 64;
+        float hysteresis = 0.9f;        // Weight kept from the previous result, 0-1
+        float bounceAlbedo = 0.5f;      // Reflectance assumed where rays hit
+        float maxDistance = 100.0f;     // Ray length
+        DirectX::XMFLOAT3 skyColor = { 0.2f, 0.2f, 0.3f };  // Radiance of rays that escape
+        float intensity = 1.0f;         // Scales what shaders read
+    };
+
+    // Radiance arriving at origin from the opposite of direction, i.e. seen looking along it
+    using RadianceFunction = std::function<DirectX::XMFLOAT3(const DirectX::XMFLOAT3& origin,
+                                                             const DirectX::XMFLOAT3& direction)>;
+
+    ProbeVolume();
+    ~ProbeVolume();
+
+    ProbeVolume(const ProbeVolume&) = delete;
+    ProbeVolume& operator=(const ProbeVolume&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings);
+    void Shutdown();
+
+    // A different grid or order recreates the volume and clears every probe
+    void SetSettings(const Settings& settings);
+    const Settings& GetSettings() const { return settings_; }
+
+    // Null restores the physics trace
+    void SetRadianceFunction(RadianceFunction function) { radiance_ = std::move(function); }
+
+    // Relights the next probesPerFrame probes. physics may be null when a radiance function is
+    // set; without either, rays all see the sky
+    void Update(const PhysicsEngine* physics, const std::vector<const Light*>& lights);
+    // Relights every probe, bounces times, without hysteresis
+    void Bake(const PhysicsEngine* physics, const std::vector<const Light*>& lights, UINT bounces = 3);
+    // Forgets every probe; unlit probes read as black
+    void Clear();
+
+    bool Save(const std::string& filename) const;
+    // False unless the file matches the current grid
+    bool Load(const std::string& filename);
+
+    // CPU counterpart of SampleProbeIrradiance(), intensity aside
+    DirectX::XMFLOAT3 SampleIrradiance(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal) const;
+
+    // Binds the volume for PBR_PS; null in the deferred shader's slots means no probes
+    void Bind(StateCache& stateCache) const;
+    void BindCompute() const;
+
+    static const char* GetShaderSource();
+    UINT GetProbeCount() const { return static_cast<UINT>(probes_.size()); }
+
+private:
+    struct Probe {
+        DirectX::XMFLOAT3 radiance[L2_COEFFICIENTS];
+        bool lit = false;
+    };
+
+    bool CreateResources();
+    void ReleaseResources();
+    UINT GetCoefficientCount() const { return settings_.l2 ? L2_COEFFICIENTS : L1_COEFFICIENTS; }
+    UINT GetPlaneCount() const { return settings_.l2 ? 7 : 3; }
+    DirectX::XMFLOAT3 GetProbePosition(UINT index) const;
+    // Traces the given probes and blends the results in with weight 1 - hysteresis
+    void Relight(const std::vector<UINT>& probes, const PhysicsEngine* physics,
+                 const std::vector<const Light*>& lights, float hysteresis);
+    void UploadProbe(UINT index);
+    void UpdateConstants();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    Settings settings_;
+
+    std::vector<Probe> probes_;
+    UINT cursor_;                       // Next probe in the round robin
+    RadianceFunction radiance_;
+    std::mt19937 random_;
+
+    ID3D11Texture3D* texture_;
+    ID3D11ShaderResourceView* view_;
+    ID3D11Buffer* constants_;
+    ID3D11SamplerState* sampler_;
+};
+
+} // namespace Nexus
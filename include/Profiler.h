@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * A single completed profiler scope
+ */
+struct ProfileEvent {
+    const char* name = nullptr;   // Must point to storage that outlives the profiler (string literals)
+    uint64_t startNs = 0;
+    uint64_t endNs = 0;
+    uint32_t threadId = 0;
+    uint16_t depth = 0;
+    uint16_t lane = 0;            // 0 = CPU, 1 = GPU
+
+    double GetDurationMs() const { return static_cast<double>(endNs - startNs) / 1000000.0; }
+};
+
+/**
+ * Per-name totals for one frame
+ */
+struct ProfileScopeStats {
+    const char* name = nullptr;
+    uint16_t lane = 0;
+    uint16_t depth = 0;
+    uint32_t callCount = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+};
+
+/**
+ * One named value of a counter sample
+ */
+struct ProfileCounterValue {
+    const char* series = nullptr; // Same lifetime rule as ProfileEvent::name
+    double value = 0.0;
+};
+
+/**
+ * Hierarchical CPU frame profiler.
+ *
+ * Scopes are recorded into per-thread single-producer/single-consumer ring buffers, so
+ * instrumented code never takes a lock. EndFrame() drains every thread's buffer on the
+ * main thread, aggregates per-scope statistics and optionally appends the frame to a
+ * capture that can be saved as a Chrome trace (chrome://tracing, Perfetto, or Tracy via
+ * its import-chrome tool).
+ */
+class Profiler {
+public:
+    static void Initialize();
+    static void Shutdown();
+
+    // Frame boundaries (main thread)
+    static void BeginFrame();
+    static void EndFrame();
+
+    // Runtime toggle, scopes are near free when disabled
+    static void SetEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Thread naming for trace exports
+    static void SetThreadName(const std::string& name);
+
+    // Event recording
+    static uint64_t GetTimeNs();
+    static void BeginScope(const char* name);
+    static void EndScope();
+    static void RecordEvent(const char* name, uint64_t startNs, uint64_t endNs, uint16_t depth = 0, uint16_t lane = 0);
+
+    // Returns stable storage for a runtime-built scope name (script functions, asset names)
+    static const char* InternName(const std::string& name);
+
+    // Results of the last completed frame
+    static const std::vector<ProfileEvent>& GetLastFrameEvents() { return lastFrameEvents_; }
+    static const std::vector<ProfileScopeStats>& GetLastFrameStats() { return lastFrameStats_; }
+    static double GetLastFrameTimeMs() { return lastFrameTimeMs_; }
+    static double GetScopeTimeMs(const char* name);
+    static uint64_t GetFrameIndex() { return frameIndex_; }
+
+    // Multi-frame capture and export
+    static void BeginCapture(size_t maxFrames = 300);
+    static void EndCapture();
+    static bool IsCapturing() { return capturing_; }
+    static bool SaveChromeTrace(const std::string& filename);
+    // Adds a sample of a counter track to the capture (any thread, dropped when not capturing);
+    // the series of one counter are drawn stacked. timeNs 0 stamps the sample now
+    static void RecordCounter(const char* name, const ProfileCounterValue* values, size_t count, uint64_t timeNs = 0);
+
+private:
+    struct ThreadBuffer;
+
+    struct CounterSample {
+        const char* name;
+        uint64_t timeNs;
+        size_t firstValue;        // Into captureCounterValues_
+        size_t valueCount;
+    };
+
+    static ThreadBuffer* GetThreadBuffer();
+    static void DrainThreadBuffers(std::vector<ProfileEvent>& out);
+    static void BuildFrameStats();
+
+    static std::atomic<bool> enabled_;
+    static bool initialized_;
+    static bool capturing_;
+    static size_t captureFrameLimit_;
+    static size_t captureFrameCount_;
+    static uint64_t frameIndex_;
+    static uint64_t frameStartNs_;
+    static double lastFrameTimeMs_;
+
+    static std::mutex registryMutex_;
+    static std::vector<std::shared_ptr<ThreadBuffer>> threadBuffers_;
+
+    static std::vector<ProfileEvent> lastFrameEvents_;
+    static std::vector<ProfileScopeStats> lastFrameStats_;
+    static std::vector<ProfileEvent> captureEvents_;
+    static std::mutex counterMutex_;              // Guards the two counter vectors
+    static std::vector<CounterSample> captureCounters_;
+    static std::vector<ProfileCounterValue> captureCounterValues_;
+    static std::vector<std::unique_ptr<std::string>> internedNames_;
+    static std::atomic<uint32_t> generation_;   // Read by every profiled thread, bumped by Shutdown
+
+    static thread_local ThreadBuffer* threadBuffer_;
+    static thread_local uint32_t threadGeneration_;
+};
+
+/**
+ * RAII helper behind NEXUS_PROFILE_SCOPE
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) { Profiler::BeginScope(name); }
+    ~ProfileScope() { Profiler::EndScope(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+} // namespace Nexus
+
+// Profiling macros (define NEXUS_PROFILER_DISABLED to compile all markers out)
+#ifndef NEXUS_PROFILER_DISABLED
+    #define NEXUS_PROFILE_CONCAT_INNER(a, b) a##b
+    #define NEXUS_PROFILE_CONCAT(a, b) NEXUS_PROFILE_CONCAT_INNER(a, b)
+    #define NEXUS_PROFILE_SCOPE(name) ::Nexus::ProfileScope NEXUS_PROFILE_CONCAT(nexusProfileScope_, __LINE__)(name)
+    #define NEXUS_PROFILE_FUNCTION() NEXUS_PROFILE_SCOPE(__FUNCTION__)
+#else
+    #define NEXUS_PROFILE_SCOPE(name) ((void)0)
+    #define NEXUS_PROFILE_FUNCTION() ((void)0)
+#endif
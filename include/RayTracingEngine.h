@@ -3,6 +3,7 @@
 #include <d3d12.h>
 #include <dxr.h>
 #include <DirectXMath.h>
+#include <climits>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -37,6 +38,7 @@ public:
         UINT vertexStride;
         DXGI_FORMAT indexFormat;
         D3D12_RAYTRACING_GEOMETRY_FLAGS flags;
+        bool deformable = false;  // Vertices rewritten at runtime (skinning); refit instead of rebuilt
     };
 
     struct RTInstance {
@@ -60,26 +62,119 @@ public:
         int emissionTextureIndex = -1;
     };
 
+    /**
+     * Incrementally maintained acceleration structures.
+     *
+     * Every geometry has its own BLAS. Static ones are built once for fast tracing and compacted
+     * once the GPU has reported their compacted size; deformable ones are refit in place after
+     * MarkGeometryDeformed() and rebuilt from scratch every refitsBeforeRebuild refits, before the
+     * refits have degraded them too far. Instance changes are only recorded; the next
+     * BuildAccelerationStructures() writes all instance descriptors in one upload and updates the
+     * TLAS in place (PERFORM_UPDATE), rebuilding it only when instances were added or removed, a
+     * BLAS moved, or after updatesBeforeRebuild updates.
+     */
     class RTScene {
     public:
+        // Frames the GPU may run behind the CPU. Buffers it may still read, and compaction results,
+        // are only touched again after this many BuildAccelerationStructures() calls
+        static constexpr UINT FRAMES_IN_FLIGHT = 3;
+
+        struct Settings {
+            UINT refitsBeforeRebuild = 64;
+            UINT updatesBeforeRebuild = 256;
+            bool compactStatic = true;
+        };
+
+        struct Stats {
+            UINT blasBuilds = 0;              // This frame
+            UINT blasRefits = 0;
+            UINT blasCompactions = 0;
+            UINT instancesUploaded = 0;
+            bool tlasRebuilt = false;
+            bool tlasUpdated = false;
+            UINT64 compactionSavedBytes = 0;  // Since creation
+        };
+
+        RTScene();
+        ~RTScene();
+
+        RTScene(const RTScene&) = delete;
+        RTScene& operator=(const RTScene&) = delete;
+
         int AddGeometry(const RTGeometry& geometry);
         void RemoveGeometry(int geometryId);
+        // Refits the geometry's BLAS on the next build; only for deformable geometry
+        void MarkGeometryDeformed(int geometryId);
         int AddInstance(const RTInstance& instance);
         void RemoveInstance(int instanceId);
         void UpdateInstance(int instanceId, const XMMATRIX& transform);
         void SetMaterial(int instanceId, const RTMaterial& material);
+
+        void SetSettings(const Settings& settings) { settings_ = settings; }
+        const Settings& GetSettings() const { return settings_; }
+
+        // Records this frame's BLAS builds, refits and compactions and the TLAS build or update
+        // into commandList. Call once per frame, with at most FRAMES_IN_FLIGHT frames queued
         bool BuildAccelerationStructures(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList);
+        D3D12_GPU_VIRTUAL_ADDRESS GetTopLevelAS() const;
+        const Stats& GetStats() const { return stats_; }
 
     private:
+        struct BottomLevel {
+            ID3D12Resource* structure = nullptr;
+            UINT64 capacity = 0;
+            UINT refits = 0;
+            bool deformed = false;
+            bool compacted = false;
+            UINT compactionIndex = UINT_MAX;  // Slot of its compacted size in this frame's readback
+            UINT64 compactionFrame = 0;
+        };
+
+        D3D12_RAYTRACING_GEOMETRY_DESC GetGeometryDesc(const RTGeometry& geometry) const;
+        void Retire(ID3D12Resource*& resource);
+        void ReleaseRetired(bool all);
+        bool EnsureBuffer(ID3D12Device5* device, ID3D12Resource*& buffer, UINT64& capacity, UINT64 size,
+                          D3D12_HEAP_TYPE heap, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state);
+        void CompactFinishedBuilds(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList);
+        bool BuildBottomLevels(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList, bool& changed);
+        bool BuildTopLevel(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList, bool bottomLevelsChanged);
+
         std::vector<RTGeometry> geometries_;
+        std::vector<bool> geometryAlive_;
         std::vector<RTInstance> instances_;
+        std::vector<bool> instanceAlive_;
+        std::vector<int> freeInstances_;
         std::vector<RTMaterial> materials_;
         std::unordered_map<int, int> instanceToMaterial_;
-        
+        Settings settings_;
+        Stats stats_;
+
         // Acceleration structures
+        std::vector<BottomLevel> bottomLevels_;
         ID3D12Resource* topLevelAS_;
-        ID3D12Resource* bottomLevelAS_;
-        bool needsRebuild_;
+        UINT64 topLevelCapacity_;
+        UINT topLevelInstances_;
+        UINT topLevelUpdates_;
+        bool instancesDirty_;
+        bool needsRebuild_;  // Instances added or removed, or a BLAS moved
+
+        // Scratch shared by every build of a frame, and the TLAS's own for its updates
+        ID3D12Resource* scratch_;
+        UINT64 scratchCapacity_;
+        ID3D12Resource* topLevelScratch_;
+        UINT64 topLevelScratchCapacity_;
+
+        // Instance descriptors, one persistently mapped slice per frame in flight
+        ID3D12Resource* instanceBuffer_;
+        UINT64 instanceCapacity_;      // Descriptors per slice
+        D3D12_RAYTRACING_INSTANCE_DESC* instanceData_;
+
+        // Compacted sizes written by the GPU, copied to a readback slice per frame in flight
+        ID3D12Resource* compactionInfo_;
+        ID3D12Resource* compactionReadback_;
+
+        std::vector<std::pair<UINT64, ID3D12Resource*>> retired_;  // Frame retired, resource
+        UINT64 frame_;
     };
 
     // Global illumination system
@@ -91,6 +186,7 @@ public:
             bool enableCaustics = false;
             bool enableVolumetrics = false;
             float volumetricDensity = 0.1f;
+            UINT traceStride = 4;  // Pixels per ray, filled in by the Denoiser; 1, 2 or 4
         };
 
         void SetSettings(const GISettings& settings) { settings_ = settings; }
@@ -103,7 +199,26 @@ public:
         ID3D12Resource* irradianceCache_;
     };
 
-    // Denoising system
+    /**
+     * Spatiotemporal variance-guided filter (SVGF, Schied et al. 2017) for ray traced signals of
+     * one sample per pixel or less.
+     *
+     * Every DenoiseType keeps its own history. A temporal pass reprojects last frame's result
+     * through the motion vectors, drops the taps whose depth or normal disagree with the current
+     * surface, and blends in the new sample together with the first two moments of its
+     * luminance. Where the history is still too short for those moments, a second pass estimates
+     * the variance from the neighbourhood instead. A few a-trous wavelet passes with doubling step
+     * size then filter the result, stopping at depth and normal edges and at luminance
+     * differences scaled by the local standard deviation, so noisy flat regions blur widely while
+     * converged detail keeps its shape. The output of the first wavelet pass is next frame's
+     * history.
+     *
+     * A signal may also be traced sparsely. With a trace stride of 2 the noisy input is half as
+     * wide and holds one checkerboard of the pixels, with 4 it is half as wide and half as tall
+     * and holds one pixel of every 2x2 block; which one rotates with the frame index (see
+     * GetTracedPixel()). Pixels not traced this frame keep their reprojected history, disoccluded
+     * ones take their block's sample until their own turn comes round.
+     */
     class Denoiser {
     public:
         enum class DenoiseType {
@@ -113,15 +228,277 @@ public:
             AmbientOcclusion
         };
 
+        static constexpr UINT TYPE_COUNT = 4;
+        static constexpr UINT MAX_ATROUS_ITERATIONS = 6;
+
+        struct Settings {
+            UINT atrousIterations = 4;      // Wavelet passes, each doubling the footprint
+            float temporalAlpha = 0.1f;     // Weight of the new sample once the history is long
+            float momentsAlpha = 0.2f;
+            UINT maxHistoryLength = 32;     // Frames
+            float phiColor = 4.0f;          // Luminance edge stop, in standard deviations
+            float phiNormal = 128.0f;       // Exponent on the cosine between normals
+            float phiDepth = 0.05f;         // Relative depth change per pixel tolerated along a surface
+        };
+
+        // Guide buffers at the denoised resolution, in NON_PIXEL_SHADER_RESOURCE state
+        struct Guides {
+            ID3D12Resource* depth = nullptr;            // Linear view depth in r
+            ID3D12Resource* normals = nullptr;          // Signed world space normal in xyz
+            ID3D12Resource* motion = nullptr;           // Current minus previous UV in rg
+            ID3D12Resource* previousDepth = nullptr;    // Last frame's depth and normals
+            ID3D12Resource* previousNormals = nullptr;
+        };
+
+        Denoiser();
+        ~Denoiser();
+
+        Denoiser(const Denoiser&) = delete;
+        Denoiser& operator=(const Denoiser&) = delete;
+
         bool Initialize(ID3D12Device5* device);
+        void Shutdown();
+
+        void SetSettings(const Settings& settings);
+        const Settings& GetSettings() const { return settings_; }
+
+        // 1, 2 or 4 output pixels per noisy texel, see the class comment
+        void SetTraceStride(DenoiseType type, UINT stride);
+        UINT GetTraceStride(DenoiseType type) const { return histories_[static_cast<UINT>(type)].traceStride; }
+
+        // Size of the noisy input for a width x height output
+        static XMUINT2 GetNoisySize(UINT traceStride, UINT width, UINT height) {
+            if (traceStride == 2) return XMUINT2((width + 1) / 2, height);
+            if (traceStride == 4) return XMUINT2((width + 1) / 2, (height + 1) / 2);
+            return XMUINT2(width, height);
+        }
+
+        // Output pixel that noisy texel (x, y) is traced for in the given frame
+        static XMUINT2 GetTracedPixel(UINT traceStride, UINT frame, UINT x, UINT y) {
+            if (traceStride == 2) return XMUINT2(x * 2 + ((y + frame) & 1), y);
+            if (traceStride == 4) return XMUINT2(x * 2 + (frame & 1), y * 2 + ((frame >> 1) & 1));
+            return XMUINT2(x, y);
+        }
+
+        // Call once per frame before tracing and denoising; advances the sparse trace pattern
+        void BeginFrame(const Guides& guides);
+        UINT GetFrameIndex() const { return frame_; }
+
+        // Drops the accumulated history, e.g. after a camera cut
+        void ResetHistory(DenoiseType type) { histories_[static_cast<UINT>(type)].valid = false; }
+
+        // noisyTexture is RGBA in NON_PIXEL_SHADER_RESOURCE state, denoisedTexture RGBA in
+        // UNORDERED_ACCESS state and sets the output resolution. Binds the denoiser's descriptor
+        // heap; the caller has to set its own heaps again afterwards
         void Denoise(ID3D12GraphicsCommandList4* commandList, 
                     ID3D12Resource* noisyTexture, ID3D12Resource* denoisedTexture,
                     DenoiseType type);
 
     private:
-        // NVIDIA OptiX or Intel OIDN integration
-        void* denoiserHandle_;
-        ID3D12Resource* temporaryBuffers_[4];
+        // Matches DenoiseConstants in RayTracingEngine.cpp, set as root constants
+        struct Constants {
+            UINT size[2];
+            UINT frame;
+            UINT traceStride;
+            float temporalAlpha;
+            float momentsAlpha;
+            float maxHistoryLength;
+            UINT historyValid;
+            float phiColor;
+            float phiNormal;
+            float phiDepth;
+            UINT stepSize;
+            UINT writeFeedback;
+            UINT noisySize[2];
+            float padding;
+        };
+
+        struct History {
+            ID3D12Resource* color = nullptr;      // Output of the first wavelet pass, variance in a
+            ID3D12Resource* moments[2] = {};      // Luminance moments and history length, ping-ponged
+            UINT current = 0;
+            UINT traceStride = 1;
+            bool valid = false;
+        };
+
+        bool CreatePipelines();
+        bool EnsureTargets(UINT width, UINT height);
+        void Retire(ID3D12Resource*& resource);
+        void ReleaseRetired(bool all);
+        D3D12_GPU_DESCRIPTOR_HANDLE WriteDescriptors(ID3D12Resource* const* resources, UINT count, bool unordered);
+        void Dispatch(ID3D12GraphicsCommandList4* commandList, ID3D12PipelineState* pipeline, const Constants& constants,
+                      D3D12_GPU_DESCRIPTOR_HANDLE inputs, ID3D12Resource* const (&targets)[4]);
+
+        ID3D12Device5* device_;
+        Settings settings_;
+        Guides guides_;
+
+        ID3D12RootSignature* rootSignature_;
+        ID3D12PipelineState* temporalPipeline_;
+        ID3D12PipelineState* variancePipeline_;
+        ID3D12PipelineState* atrousPipeline_;
+
+        // Shader visible ring, rewritten every dispatch; large enough for FRAMES_IN_FLIGHT frames
+        ID3D12DescriptorHeap* descriptorHeap_;
+        UINT descriptorSize_;
+        UINT nextDescriptor_;
+
+        // Ping-pong targets of the variance and wavelet passes, shared by every type
+        ID3D12Resource* targets_[2];
+        UINT width_;
+        UINT height_;
+        History histories_[TYPE_COUNT];
+
+        std::vector<std::pair<UINT64, ID3D12Resource*>> retired_;  // Frame retired, resource
+        UINT frame_;
+    };
+
+    /**
+     * Decides each frame which pixels get rays, so hybrid shadows and reflections stay within a
+     * ray budget and the raster techniques cover the rest.
+     *
+     * A screen-space pre-pass sorts 8x8 tiles into lists. Shadow tiles are traced only where the
+     * raster shadow result (cascaded shadow maps, PCF filtered) is in penumbra; fully lit and
+     * fully shadowed tiles keep it. Reflection tiles are traced where the smoothest surface is
+     * below a roughness cutoff and handed to screen-space reflections otherwise. Every list is
+     * paired with indirect dispatch arguments of one thread group per tile, so the tracing and
+     * fallback passes only run over their own tiles.
+     *
+     * The tile counts come back to the CPU FRAMES_IN_FLIGHT frames later and plan the next
+     * frame: shadows take what they need up to their share of the budget, reflections get the
+     * rest and thin out to one ray per 2 or 4 pixels before tiles spill over to SSR (the trace
+     * stride is passed on to the Denoiser). With a frame time target, the budget itself follows
+     * the rays per millisecond measured on this GPU.
+     */
+    class HybridScheduler {
+    public:
+        static constexpr UINT TILE_SIZE = 8;
+
+        enum class TileList {
+            Shadows,                      // Penumbra tiles to trace
+            Reflections,                  // Smooth tiles to trace
+            ScreenSpaceReflections,       // Reflective tiles left to SSR
+            Count
+        };
+
+        struct Settings {
+            UINT64 rayBudget = 4000000;         // Rays per frame, shadows and reflections together
+            float shadowShare = 0.4f;           // Of the budget shadows may claim first
+            UINT shadowRaysPerPixel = 1;
+            float penumbraMin = 0.02f;          // Raster visibility strictly between these is penumbra
+            float penumbraMax = 0.98f;
+            float reflectionRoughness = 0.3f;   // Smoother surfaces are traced
+            float ssrRoughness = 0.8f;          // Rougher ones than this only get probes
+            float targetMilliseconds = 0.0f;    // Time for the traced passes; 0 leaves the budget fixed
+        };
+
+        // Screen-space inputs at full resolution, in NON_PIXEL_SHADER_RESOURCE state
+        struct Inputs {
+            ID3D12Resource* shadowVisibility = nullptr;   // Raster shadow result in r, 0 shadowed to 1 lit
+            ID3D12Resource* roughness = nullptr;          // Surface roughness in r, 1 for the sky
+        };
+
+        // Tile counts one frame produced
+        struct Demand {
+            UINT shadowTiles = 0;               // In penumbra, traced or not
+            UINT reflectionTiles = 0;           // Below the roughness cutoff, traced or not
+        };
+
+        // Limits for one frame's lists
+        struct Plan {
+            UINT shadowTileLimit = 0;
+            UINT reflectionTileLimit = 0;
+            UINT reflectionStride = 1;          // Pixels per reflection ray: 1, 2 or 4
+            UINT64 rayBudget = 0;
+        };
+
+        struct Stats {
+            Plan plan;                          // This frame's
+            Demand demand;                      // The latest read back
+            UINT shadowTilesFallback = 0;       // Of those, left to raster
+            UINT reflectionTilesFallback = 0;
+            float raysPerMillisecond = 0.0f;    // Measured, 0 until known
+        };
+
+        HybridScheduler();
+        ~HybridScheduler();
+
+        HybridScheduler(const HybridScheduler&) = delete;
+        HybridScheduler& operator=(const HybridScheduler&) = delete;
+
+        bool Initialize(ID3D12Device5* device);
+        void Shutdown();
+
+        void SetSettings(const Settings& settings);
+        const Settings& GetSettings() const { return settings_; }
+
+        // Limits fitting demand into the budget. previousStride keeps the reflection density
+        // from flickering between two strides when demand sits near a boundary
+        static Plan PlanFrame(const Settings& settings, const Demand& demand, UINT64 rayBudget, UINT previousStride);
+
+        // GPU time of the traced passes of a recently finished frame, from a timestamp query
+        void ReportTracingTime(float milliseconds);
+
+        // Call once per frame before Classify(); reads back the oldest frame's counts and plans
+        // this one. Sets the reflection trace stride on denoiser when given
+        void BeginFrame(Denoiser* denoiser);
+
+        // Sorts the tiles of a width x height frame into the lists and writes their arguments.
+        // Binds the scheduler's descriptor heap; the caller has to set its own heaps again
+        void Classify(ID3D12GraphicsCommandList4* commandList, const Inputs& inputs, UINT width, UINT height);
+
+        // Runs the bound compute pipeline with one thread group per tile of the list. The tile
+        // coordinates (x | y << 16) are read from GetTileBuffer() at GetTileOffset(list) uints
+        void DispatchTiles(ID3D12GraphicsCommandList4* commandList, TileList list) const;
+        ID3D12Resource* GetTileBuffer() const { return tiles_; }
+        UINT GetTileOffset(TileList list) const { return static_cast<UINT>(list) * tileCapacity_; }
+
+        const Stats& GetStats() const { return stats_; }
+
+    private:
+        // Matches ClassifyConstants in RayTracingEngine.cpp, set as root constants
+        struct Constants {
+            UINT size[2];
+            UINT tiles[2];
+            UINT tileCapacity;
+            UINT shadowTileLimit;
+            UINT reflectionTileLimit;
+            float penumbraMin;
+            float penumbraMax;
+            float reflectionRoughness;
+            float ssrRoughness;
+            UINT padding;
+        };
+
+        bool CreatePipelines();
+        bool EnsureTileBuffer(UINT tileCount);
+        void Retire(ID3D12Resource*& resource);
+        void ReleaseRetired(bool all);
+
+        ID3D12Device5* device_;
+        Settings settings_;
+        Stats stats_;
+
+        ID3D12RootSignature* rootSignature_;
+        ID3D12PipelineState* classifyPipeline_;
+        ID3D12PipelineState* argumentsPipeline_;
+        ID3D12CommandSignature* commandSignature_;
+        ID3D12DescriptorHeap* descriptorHeap_;     // Two input views per frame in flight
+        UINT descriptorSize_;
+
+        ID3D12Resource* tiles_;                    // TileList::Count lists of tileCapacity_ each
+        UINT tileCapacity_;
+        ID3D12Resource* counters_;                 // Appended tiles per list
+        ID3D12Resource* arguments_;                // D3D12_DISPATCH_ARGUMENTS per list
+        ID3D12Resource* zeros_;                    // Upload buffer that resets the counters
+        ID3D12Resource* readback_;                 // Counters of each frame in flight
+        Plan plans_[RTScene::FRAMES_IN_FLIGHT];    // Each readback slice's plan
+        bool pending_[RTScene::FRAMES_IN_FLIGHT];  // Slice written and not yet read
+
+        bool demandKnown_;                         // Some frame's counts have been read back
+        UINT64 lastTracedRays_;                    // Of the latest frame read back
+        std::vector<std::pair<UINT64, ID3D12Resource*>> retired_;  // Frame retired, resource
+        UINT64 frame_;
     };
 
 public:
@@ -164,6 +541,9 @@ public:
     Denoiser* GetDenoiser() { return denoiser_.get(); }
     void EnableDenoising(bool enable) { settings_.enableDenoising = enable; }
 
+    // Hybrid tracing: per-frame ray budget, tile lists and raster fallback
+    HybridScheduler* GetHybridScheduler() { return hybridScheduler_.get(); }
+
     // Performance
     void SetQualityLevel(int level); // 0 = Low, 1 = Medium, 2 = High, 3 = Ultra
     float GetLastFrameTime() const { return lastFrameTime_; }
@@ -208,6 +588,7 @@ private:
     // Systems
     std::unique_ptr<GlobalIllumination> globalIllumination_;
     std::unique_ptr<Denoiser> denoiser_;
+    std::unique_ptr<HybridScheduler> hybridScheduler_;
 
     // Settings
     RayTracingSettings settings_;
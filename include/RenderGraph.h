@@ -0,0 +1,246 @@
+#pragma once
+
+#include "Platform.h"
+#include <d3d12.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+class StateCache;
+class D3D12Device;
+class JobSystem;
+
+/**
+ * Per-frame graph of rendering passes over transient textures.
+ *
+ * Each pass declares the textures it reads and writes in its setup callback and does its work
+ * in its execute callback. Execute() then compiles the frame: passes whose writes reach neither
+ * an imported texture nor a later live pass are culled, and every transient texture gets the
+ * lifetime from its first to its last live use. Transients are backed by a pool of physical
+ * textures; one whose lifetime has ended returns to the pool before the next pass allocates, so
+ * textures that are never alive at the same time share memory. Between passes the graph unbinds
+ * outputs a pass is about to read and inputs it is about to write, the Direct3D 11 equivalent
+ * of the transition barriers a later pass would otherwise hit as runtime hazards.
+ *
+ * A transient starts each frame with whatever its physical texture last held, so the first pass
+ * writing it must clear or fully overwrite it.
+ *
+ * Initialized with a D3D12Device instead, the graph runs command passes: it tracks the state of
+ * every texture it touches and records the transition (and UAV) barriers each pass needs ahead
+ * of it, then records the passes on several command lists at once through the job system and
+ * submits them in order. Transients are placed in the device's shared heaps and their views are
+ * created up front, so the getters are safe to call from the recording threads. A graph runs
+ * either kind of pass, never both.
+ *
+ * Command passes that opt in with SetAsyncCompute() run on the device's compute queue, overlapping
+ * the graphics passes around them. The graph ends the graphics work a compute pass depends on
+ * with a fence signal just after its last producer, not at the compute pass's place in the
+ * frame, and makes the first graphics pass touching its output wait for it, so the compute pass
+ * runs alongside everything in between. Transitions the compute queue cannot make are recorded
+ * on the graphics queue before the signal. A compute pass needing one for a texture the compute
+ * queue still owns falls back to the graphics queue.
+ */
+class RenderGraph {
+public:
+    using ResourceHandle = uint32_t;
+    static constexpr ResourceHandle INVALID_RESOURCE = UINT32_MAX;
+    static constexpr uint32_t POOL_RETENTION_FRAMES = 3;  // Unused pool textures are released after this
+
+    struct TextureDesc {
+        UINT width = 0;
+        UINT height = 0;
+        DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;  // Depth formats get typeless storage
+        UINT bindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+        UINT mipLevels = 1;
+    };
+
+    class Builder {
+    public:
+        ResourceHandle Read(ResourceHandle resource);
+        ResourceHandle Write(ResourceHandle resource);
+        // A write through an unordered access view; under D3D11 the same as Write
+        ResourceHandle WriteUnordered(ResourceHandle resource);
+        // Keeps the pass even if nothing reads what it writes, e.g. for readbacks and queries
+        void SetSideEffects();
+        // Runs the command pass on the compute queue when the device has one. The pass must only
+        // dispatch and write through WriteUnordered; others stay on the graphics queue
+        void SetAsyncCompute();
+
+    private:
+        friend class RenderGraph;
+        Builder(RenderGraph& graph, uint32_t pass) : graph_(graph), pass_(pass) {}
+        RenderGraph& graph_;
+        uint32_t pass_;
+    };
+
+    using SetupCallback = std::function<void(Builder&)>;
+    using ExecuteCallback = std::function<void(RenderGraph&)>;
+    // Runs on a job thread; must only record into list
+    using RecordCallback = std::function<void(RenderGraph&, ID3D12GraphicsCommandList4*)>;
+
+    struct Stats {
+        uint32_t passes = 0;            // Executed in the last frame
+        uint32_t culledPasses = 0;
+        uint32_t transientTextures = 0;
+        uint32_t physicalTextures = 0;  // Pool textures that backed them
+        uint32_t barriers = 0;          // Unbinds, or D3D12 barriers, issued between passes
+        uint32_t commandLists = 0;      // D3D12 lists the passes were recorded on
+        uint32_t asyncPasses = 0;       // Of the passes, those run on the compute queue
+        uint32_t queueWaits = 0;        // Cross-queue fence waits
+        uint64_t pooledBytes = 0;       // Approximate memory held by the pool
+    };
+
+    RenderGraph();
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache);
+    // Command passes on D3D12; jobs may be null to record on the calling thread
+    bool Initialize(D3D12Device* device, JobSystem* jobs);
+    void Shutdown();
+
+    // Resources live until the end of the frame's Execute()
+    ResourceHandle CreateTexture(const char* name, const TextureDesc& desc);
+    // Textures owned elsewhere, such as the back buffer. Writing one keeps the pass alive
+    ResourceHandle ImportTexture(const char* name, ID3D11Texture2D* texture,
+                                 ID3D11ShaderResourceView* shaderResource = nullptr,
+                                 ID3D11RenderTargetView* renderTarget = nullptr,
+                                 ID3D11UnorderedAccessView* unorderedAccess = nullptr,
+                                 ID3D11DepthStencilView* depthStencil = nullptr);
+    // A D3D12 texture owned elsewhere, in state when the frame starts and left in finalState
+    ResourceHandle ImportResource(const char* name, ID3D12Resource* resource, D3D12_RESOURCE_STATES state,
+                                  D3D12_RESOURCE_STATES finalState);
+
+    void AddPass(const char* name, const SetupCallback& setup, ExecuteCallback execute);
+    void AddCommandPass(const char* name, const SetupCallback& setup, RecordCallback record);
+    bool HasPasses() const { return !passes_.empty(); }
+    // Lets passes that opted in run on the compute queue; on by default
+    void SetAsyncCompute(bool enabled) { asyncCompute_ = enabled; }
+    bool IsAsyncCompute() const { return asyncCompute_; }
+
+    // Compiles, runs and clears the recorded passes
+    void Execute();
+    // Drops anything recorded and releases every pooled texture, e.g. after a resize made them
+    // the wrong size
+    void ReleaseTransients();
+
+    // Valid inside a pass's execute callback for the resources it declared. Views of transients
+    // are created on first use and cached with the pool texture
+    ID3D11Texture2D* GetTexture(ResourceHandle resource) const;
+    ID3D11ShaderResourceView* GetShaderResourceView(ResourceHandle resource);
+    ID3D11RenderTargetView* GetRenderTargetView(ResourceHandle resource);
+    ID3D11UnorderedAccessView* GetUnorderedAccessView(ResourceHandle resource);
+    ID3D11DepthStencilView* GetDepthStencilView(ResourceHandle resource);
+
+    // The same inside a command pass's record callback, by bindless index or CPU handle
+    ID3D12Resource* GetResource(ResourceHandle resource) const;
+    uint32_t GetShaderResourceIndex(ResourceHandle resource) const;
+    uint32_t GetUnorderedAccessIndex(ResourceHandle resource) const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetRenderTargetHandle(ResourceHandle resource) const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetDepthStencilHandle(ResourceHandle resource) const;
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    struct PooledTexture {
+        TextureDesc desc;
+        ID3D11Texture2D* texture = nullptr;
+        ID3D11ShaderResourceView* shaderResource = nullptr;
+        ID3D11RenderTargetView* renderTarget = nullptr;
+        ID3D11UnorderedAccessView* unorderedAccess = nullptr;
+        ID3D11DepthStencilView* depthStencil = nullptr;
+        ID3D12Resource* resource = nullptr;
+        D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON;
+        uint32_t shaderResourceIndex = UINT32_MAX;
+        uint32_t unorderedAccessIndex = UINT32_MAX;
+        uint32_t renderTargetIndex = UINT32_MAX;
+        uint32_t depthStencilIndex = UINT32_MAX;
+        uint64_t lastUsedFrame = 0;
+        bool inUse = false;
+        bool boundAsOutput = false;   // Possibly still bound by an earlier pass
+        bool boundAsInput = false;
+    };
+
+    struct Resource {
+        std::string name;
+        TextureDesc desc;
+        bool imported = false;
+        PooledTexture imports;             // Views of an imported texture, never released here
+        D3D12_RESOURCE_STATES finalState = D3D12_RESOURCE_STATE_COMMON;
+        uint32_t physical = UINT32_MAX;    // Pool index of a transient once allocated
+        uint32_t firstPass = UINT32_MAX;   // Live passes only
+        uint32_t lastPass = 0;
+    };
+
+    struct Pass {
+        std::string name;
+        ExecuteCallback execute;
+        RecordCallback record;
+        std::vector<ResourceHandle> reads;
+        std::vector<ResourceHandle> writes;
+        std::vector<ResourceHandle> unorderedWrites;   // Also in writes
+        std::vector<D3D12_RESOURCE_BARRIER> barriers;  // Recorded ahead of the pass
+        std::vector<ResourceHandle> acquires;   // Transients first used by this pass
+        std::vector<ResourceHandle> releases;   // Transients last used by this pass
+        bool sideEffects = false;
+        bool live = false;
+        bool asyncCompute = false;      // Requested, then whether it ran on the compute queue
+    };
+
+    // Passes submitted together on one queue
+    struct Batch {
+        bool compute = false;
+        std::vector<uint32_t> passes;
+        std::vector<D3D12_RESOURCE_BARRIER> tail;   // After the passes, before the signal
+        std::vector<ID3D12GraphicsCommandList4*> lists;
+        uint32_t waitFor = UINT32_MAX;              // Batch on the other queue to wait for first
+        bool signal = false;                        // Signals its queue when done; nothing joins after
+        uint64_t signaled = 0;
+        bool submitted = false;
+    };
+
+    void Compile();
+    uint32_t AcquireTexture(const TextureDesc& desc);
+    void TrimPool();
+    void Barrier(const Pass& pass);
+    void ExecuteCommandPasses();
+    void Schedule(uint32_t index);
+    uint32_t OpenBatch(bool compute, uint32_t waitFor);
+    uint32_t EndBatchAfter(uint32_t pass);
+    void SubmitBatches();
+    void Transition(std::vector<D3D12_RESOURCE_BARRIER>& barriers, PooledTexture& texture, D3D12_RESOURCE_STATES state);
+    void CreateViews(const Pass& pass);
+    void ReleasePooled(PooledTexture& texture);
+    PooledTexture* Views(ResourceHandle resource);
+    const PooledTexture* Views(ResourceHandle resource) const;
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    StateCache* stateCache_;
+    D3D12Device* d3d12_;
+    JobSystem* jobs_;
+    bool asyncCompute_;
+
+    std::vector<Resource> resources_;
+    std::vector<Pass> passes_;
+    std::vector<PooledTexture> pool_;
+
+    // Command pass scheduling, per frame
+    std::vector<Batch> batches_;
+    std::vector<uint32_t> queueOrder_[2];                       // Batches per queue, graphics first
+    std::vector<uint32_t> passBatch_;
+    std::unordered_map<const ID3D12Resource*, uint32_t> lastTouch_;  // Last pass to use each texture
+    uint32_t lastGraphicsPass_;
+    uint32_t computeJoined_;                                    // Last graphics pass compute waited for
+    uint32_t graphicsJoined_;                                   // Last compute pass graphics waited for
+    uint64_t frame_;
+    Stats stats_;
+};
+
+} // namespace Nexus
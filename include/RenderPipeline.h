@@ -0,0 +1,83 @@
+#pragma once
+
+#include "PhysicsEngine.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Per-frame values the renderer needs besides the object list
+ */
+struct FrameRenderData {
+    uint64_t frameNumber = 0;
+    float interpolationAlpha = 1.0f;
+    int fps = 0;
+    uint64_t simulatedAtNs = 0;   // When the simulation finished this frame (Profiler clock)
+    int64_t mouseMotionX = 0;     // InputManager::GetMouseMotionTotal when the frame took input
+    int64_t mouseMotionY = 0;
+};
+
+/**
+ * Immutable snapshot of everything one frame draws, produced by the simulation thread
+ */
+struct RenderPacket {
+    FrameRenderData data;
+    std::vector<RenderObject> objects;
+};
+
+/**
+ * Two-stage simulation/render pipeline.
+ *
+ * The simulation thread fills packets while a dedicated render thread consumes them and
+ * submits to the graphics device, so frame N+1 simulates while frame N renders. The pool
+ * holds maxFramesInFlight + 1 packets; BeginPacket() blocks once the simulation is that far
+ * ahead, which bounds input-to-display latency.
+ */
+class RenderPipeline {
+public:
+    using SubmitFunction = std::function<void(const RenderPacket&)>;
+
+    RenderPipeline();
+    ~RenderPipeline();
+
+    bool Initialize(SubmitFunction submit, int maxFramesInFlight = 1);
+    void Shutdown();
+
+    // Simulation thread: get an empty packet (nullptr once shut down), fill it, submit it
+    RenderPacket* BeginPacket();
+    void SubmitPacket(RenderPacket* packet);
+
+    int GetMaxFramesInFlight() const { return maxFramesInFlight_; }
+    // Time from the end of simulation to the end of Present for the last rendered packet
+    float GetLastLatencyMs() const { return lastLatencyMs_.load(std::memory_order_relaxed); }
+    bool HasFailed() const { return failed_.load(std::memory_order_acquire); }
+
+private:
+    void RenderThreadLoop();
+
+    SubmitFunction submit_;
+    int maxFramesInFlight_;
+
+    std::vector<std::unique_ptr<RenderPacket>> packets_;
+    std::deque<RenderPacket*> freePackets_;
+    std::deque<RenderPacket*> readyPackets_;
+    std::mutex mutex_;
+    std::condition_variable freeCondition_;
+    std::condition_variable readyCondition_;
+
+    std::thread renderThread_;
+    bool running_;
+    bool initialized_;
+    std::atomic<bool> failed_;
+    std::atomic<float> lastLatencyMs_;
+};
+
+} // namespace Nexus
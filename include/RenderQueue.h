@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Draw submissions ordered by a 64-bit sort key.
+ *
+ * Key layout, most significant bits first:
+ *   opaque / alpha test   [pass:4][blend:2][shader:10][material:12][mesh:12][depth:24]
+ *   translucent / additive [pass:4][blend:2][~depth:24][shader:10][material:12][mesh:12]
+ *
+ * Opaque draws therefore group by state and run front-to-back inside a state; translucent draws
+ * run back-to-front regardless of state. Entries carry an opaque 32-bit payload (usually an index
+ * into the caller's draw data) and are ordered with an LSD radix sort, which skips every byte
+ * position all keys agree on.
+ */
+class RenderQueue {
+public:
+    enum class Pass : uint8_t {
+        Shadow = 0,
+        Opaque = 1,
+        Translucent = 2,
+        Overlay = 3
+    };
+
+    enum class BlendMode : uint8_t {
+        Opaque = 0,
+        AlphaTest = 1,
+        Translucent = 2,
+        Additive = 3
+    };
+
+    struct Entry {
+        uint64_t key;
+        uint32_t payload;
+    };
+
+    static constexpr uint32_t MAX_SHADER = (1u << 10) - 1;
+    static constexpr uint32_t MAX_MATERIAL = (1u << 12) - 1;
+    static constexpr uint32_t MAX_MESH = (1u << 12) - 1;
+    static constexpr uint32_t MAX_DEPTH = (1u << 24) - 1;
+
+    RenderQueue();
+
+    // View-space depth range mapped onto the 24-bit depth field
+    void SetDepthRange(float nearDepth, float farDepth);
+
+    // Ids above the field limits are clamped, depth outside the range saturates
+    uint64_t MakeKey(Pass pass, BlendMode blend, uint32_t shader, uint32_t material, uint32_t mesh, float viewDepth) const;
+
+    static Pass GetPass(uint64_t key) { return static_cast<Pass>(key >> 60); }
+    static BlendMode GetBlendMode(uint64_t key) { return static_cast<BlendMode>((key >> 58) & 0x3); }
+    static bool IsTranslucent(uint64_t key) { return GetBlendMode(key) >= BlendMode::Translucent; }
+
+    void Clear() { entries_.clear(); sorted_ = true; }
+    void Reserve(size_t count);
+    void Submit(uint64_t key, uint32_t payload);
+    void Sort();
+
+    const Entry* begin() const { return entries_.data(); }
+    const Entry* end() const { return entries_.data() + entries_.size(); }
+    size_t Size() const { return entries_.size(); }
+    bool Empty() const { return entries_.empty(); }
+    bool IsSorted() const { return sorted_; }
+
+private:
+    uint32_t QuantizeDepth(float viewDepth) const;
+
+    std::vector<Entry> entries_;
+    std::vector<Entry> scratch_;
+    float nearDepth_;
+    float depthScale_;
+    bool sorted_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "NetBitStream.h"
+#include "NetTransport.h"
+#include "AISpatialGrid.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class World;
+class JobSystem;
+
+// Shared by ReplicationServer and ReplicationClient so stray traffic from other programs is ignored
+constexpr uint32_t REPLICATION_PROTOCOL_ID = 0x4E585231; // "NXR1"
+
+// First byte of every replication message; game messages sent over the same transport start with
+// REPLICATION_MESSAGE_COUNT or more
+enum ReplicationMessage : uint8_t {
+    REPLICATION_SNAPSHOT = 1,
+    REPLICATION_ACK,
+    REPLICATION_MESSAGE_COUNT
+};
+
+// An entity as the client last received it, keyed by its server entity index and generation
+struct ReplicatedState {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+    uint16_t type = 0;
+    QuantizedTransform transform;
+};
+
+/**
+ * Server half of entity replication.
+ *
+ * Every tick the transforms of entities with a ReplicatedComponent are quantized into a table by
+ * entity index and kept in a spatial grid. Each client gets an unreliable snapshot at the
+ * snapshot rate holding only the entities within the interest radius of its focus, delta encoded
+ * against the newest snapshot it acked: entities it has unchanged cost nothing, moved ones a
+ * small position delta where one fits, and new and departed ones a create or remove record. A
+ * lost snapshot needs no resend, since the next one is again relative to what the client has.
+ *
+ * When the changes don't fit one message, entities compete by a priority that grows every
+ * snapshot they miss out on, faster close to the focus; the ones left out carry their old state
+ * forward and are sent later. Clients are encoded in parallel on the job system and share the
+ * entity table and grid read-only.
+ */
+class ReplicationServer {
+public:
+    struct Settings {
+        float snapshotRate = 20.0f;             // Snapshots a second per client
+        float interestRadius = 200.0f;          // Metres around the client's focus
+        float cellSize = 50.0f;                 // Interest grid cells
+        size_t snapshotBudget = NetTransport::MAX_MESSAGE_SIZE;  // Bytes a snapshot may take
+        NetQuantization quantization;
+    };
+
+    struct Stats {
+        uint32_t entities = 0;
+        uint32_t clients = 0;
+        uint64_t snapshotsSent = 0;
+        uint64_t snapshotBytes = 0;
+        uint64_t deferredRecords = 0;           // Changes left for a later snapshot by the budget
+    };
+
+    ReplicationServer(NetTransport& transport, const Settings& settings);
+
+    // Tracks connections and consumes replication messages. Connection events and game messages
+    // return false, to be handled by the game too
+    bool HandleEvent(const NetTransport::Event& event);
+    // Gathers the world and, when a snapshot is due, encodes and queues one for every client.
+    // The transport is flushed by the caller
+    void Update(World& world, JobSystem* jobs, float deltaTime);
+
+    // The focus normally follows the view position the client reports with its acks
+    void SetClientFocus(NetTransport::ConnectionID connection, const DirectX::XMFLOAT3& focus);
+    const Settings& GetSettings() const { return settings_; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    static constexpr uint32_t SNAPSHOT_HISTORY = 32;
+
+    struct EntityState {
+        bool alive = false;
+        uint32_t generation = 0;
+        uint16_t type = 0;
+        QuantizedTransform transform;
+        DirectX::XMFLOAT3 position;
+        uint32_t gridItem = AISpatialGrid::INVALID_ITEM;
+        uint64_t lastSeen = 0;
+    };
+
+    struct Snapshot {
+        uint32_t id = 0;
+        std::vector<ReplicatedState> entities;  // Sorted by index
+    };
+
+    struct Record {
+        uint32_t index;
+        uint8_t op;
+        float priority;
+        uint32_t bits;                          // Upper bound, for the budget
+        const ReplicatedState* baseline;
+    };
+
+    struct Client {
+        bool active = false;
+        uint32_t nextSnapshotId = 1;
+        uint32_t ackedSnapshot = 0;             // 0 when none
+        bool focusOverridden = false;
+        DirectX::XMFLOAT3 focus = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+        Snapshot history[SNAPSHOT_HISTORY];     // By id % SNAPSHOT_HISTORY
+        std::vector<float> priority;            // By entity index
+        std::vector<uint8_t> message;
+        uint32_t deferred = 0;                  // Records the last snapshot left out
+        // Encoding scratch
+        std::vector<uint32_t> visible;
+        std::vector<Record> records;
+    };
+
+    void Gather(World& world);
+    void EncodeSnapshot(Client& client);
+
+    NetTransport& transport_;
+    Settings settings_;
+    AISpatialGrid grid_;
+    std::vector<EntityState> entities_;              // By entity index
+    std::vector<uint32_t> gridEntities_;        // Entity index by grid item
+    std::vector<Client> clients_;               // By connection
+    std::vector<uint32_t> sendingClients_;
+    uint64_t tick_;
+    float snapshotTimer_;
+    uint32_t positionBits_[3];
+    Stats stats_;
+};
+
+/**
+ * Client half of entity replication: rebuilds each snapshot from the baseline it names, acks
+ * it with the view position the server should focus on, and keeps the result as the current
+ * entity set. Snapshots older than the newest one decoded are dropped.
+ */
+class ReplicationClient {
+public:
+    explicit ReplicationClient(NetTransport& transport, const NetQuantization& quantization = NetQuantization());
+
+    // Decodes snapshots; false for messages meant for the game
+    bool HandleEvent(const NetTransport::Event& event);
+    void SetViewPosition(const DirectX::XMFLOAT3& position) { viewPosition_ = position; }
+
+    // The newest snapshot's entities, sorted by index
+    const std::vector<ReplicatedState>& GetEntities() const { return current_->entities; }
+    uint32_t GetSnapshotId() const { return current_->id; }
+    void GetTransform(const ReplicatedState& state, DirectX::XMFLOAT3& position, DirectX::XMFLOAT4& rotation) const {
+        quantization_.Dequantize(state.transform, position, rotation);
+    }
+    uint64_t GetSnapshotsDropped() const { return snapshotsDropped_; }
+
+private:
+    static constexpr uint32_t SNAPSHOT_HISTORY = 32;
+
+    struct Snapshot {
+        uint32_t id = 0;
+        std::vector<ReplicatedState> entities;
+    };
+
+    bool DecodeSnapshot(const uint8_t* data, size_t size);
+
+    NetTransport& transport_;
+    NetQuantization quantization_;
+    uint32_t positionBits_[3];
+    Snapshot history_[SNAPSHOT_HISTORY];        // By id % SNAPSHOT_HISTORY
+    Snapshot empty_;
+    const Snapshot* current_;
+    DirectX::XMFLOAT3 viewPosition_;
+    uint64_t snapshotsDropped_;
+    std::vector<uint8_t> ack_;
+};
+
+} // namespace Nexus
@@ -1,54 +1,249 @@
 #pragma once
 
 #include "Platform.h"
+#include "ResourcePool.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace Nexus {
 
 class Texture;
 class Mesh;
+class Material;
+class ShaderPermutations;
+class TextureStreamingEngine;
+class JobSystem;
+class FileWatcher;
+class PakArchive;
+struct PakEntry;
+
+using TextureHandle = ResourceHandle<Texture>;
+using MeshHandle = ResourceHandle<Mesh>;
 
 /**
  * Resource management system for textures, meshes, sounds, etc.
+ *
+ * Asynchronous loads run on a loader thread: the file is mapped and decoded there (block
+ * compression spread over the job system) and its GPU resources are created on the free-threaded
+ * device. Update() publishes finished loads on the main thread by swapping them into the
+ * placeholder handed out when the load was requested.
+ *
+ * Textures and meshes live in handle pools. Per-frame code should hold a TextureHandle or
+ * MeshHandle and resolve it with GetTexture()/GetMesh(): an index and generation check, with no
+ * name lookup and no shared_ptr copy. A handle taken with Acquire*() keeps its resource through
+ * ClearUnusedResources() until released; an unloaded resource's handles resolve to null.
+ *
+ * With a memory budget set for textures or meshes, Update() tracks which are in use each frame
+ * and, once the type is over budget, unloads its unused ones, least recently used first.
+ *
+ * Mounted paks are searched before loose files. Their entries are loaded from memory, so they
+ * are neither streamed nor hot reloaded; meshes are found as their baked .nmesh.
+ *
+ * A run can record the order textures and meshes are first asked for into a load order file.
+ * Prefetching it on later runs queues the same loads ahead of the code asking for them, and paks
+ * built in that order (NexusAssetConverter --pak --order) lay them out so they read sequentially.
  */
 class ResourceManager {
 public:
+    // The resource, or nullptr if it failed to load
+    using TextureCallback = std::function<void(std::shared_ptr<Texture>)>;
+    using MeshCallback = std::function<void(std::shared_ptr<Mesh>)>;
+
+    enum class ResourceType : uint8_t {
+        Texture,
+        Mesh,
+        Count
+    };
+
+    // A texture or mesh as first asked for, and when
+    struct LoadOrderEntry {
+        ResourceType type;
+        std::string name;
+        std::string filename;                    // As given, before the resource paths
+        float timeMs;                            // Since recording started
+    };
+
     ResourceManager();
     ~ResourceManager();
 
     // Initialization
-    bool Initialize(ID3D11Device* device = nullptr);
+    // With a streaming engine, DDS/KTX2 textures load only their mip tail and stream the rest.
+    // jobs block-compresses decoded images in parallel
+    bool Initialize(ID3D11Device* device = nullptr, TextureStreamingEngine* streaming = nullptr,
+                    JobSystem* jobs = nullptr);
     void Shutdown();
 
+    // Main thread, once per frame: publishes finished asynchronous loads and runs their callbacks,
+    // then enforces the memory budgets
+    void Update();
+
     // Texture management
     std::shared_ptr<Texture> LoadTexture(const std::string& name, const std::string& filename);
     std::shared_ptr<Texture> GetTexture(const std::string& name);
     void UnloadTexture(const std::string& name);
+    // Returns at once with the texture registered under name, empty (binds no view) until it has
+    // loaded. onLoaded runs from Update(), or right away when the texture is already loaded;
+    // requests for a name in flight share its load, and LoadTexture() finishes it on the spot
+    std::shared_ptr<Texture> LoadTextureAsync(const std::string& name, const std::string& filename,
+                                              TextureCallback onLoaded = nullptr);
+    // Handles to a texture already loaded or loading under name; invalid for an unknown name.
+    // Acquire takes a reference, which Release gives back
+    TextureHandle FindTexture(const std::string& name) const;
+    TextureHandle AcquireTexture(const std::string& name);
+    void ReleaseTexture(TextureHandle handle);
+    // Null once the texture has been unloaded
+    Texture* GetTexture(TextureHandle handle) const { return texturePool_.Get(handle); }
 
     // Mesh management
     std::shared_ptr<Mesh> LoadMesh(const std::string& name, const std::string& filename);
     std::shared_ptr<Mesh> GetMesh(const std::string& name);
     void UnloadMesh(const std::string& name);
+    // As LoadTextureAsync; the placeholder draws nothing until loaded
+    std::shared_ptr<Mesh> LoadMeshAsync(const std::string& name, const std::string& filename,
+                                        MeshCallback onLoaded = nullptr);
+    MeshHandle FindMesh(const std::string& name) const;
+    MeshHandle AcquireMesh(const std::string& name);
+    void ReleaseMesh(MeshHandle handle);
+    Mesh* GetMesh(MeshHandle handle) const { return meshPool_.Get(handle); }
+
+    // Asynchronous loads requested and not yet published
+    size_t GetPendingLoadCount() const { return textureLoads_.size() + meshLoads_.size(); }
+
+    // Records the first request for each texture and mesh from now on; prefetches don't count
+    void StartLoadOrderRecording();
+    bool IsRecordingLoadOrder() const { return recordingLoadOrder_; }
+    // Writes the requests recorded so far, oldest first
+    bool SaveLoadOrder(const std::string& filename) const;
+    static bool ReadLoadOrder(const std::string& filename, std::vector<LoadOrderEntry>& entries);
+    // Loads a recorded order asynchronously, front to back, from Update() on. No more than window
+    // loads are kept in flight, so the ones the game asks for next aren't queued behind the whole
+    // list; anything already loaded or loading is skipped
+    bool PrefetchLoadOrder(const std::string& filename, size_t window = 8);
+
+    // Shader management (vertex/pixel pairs with all their keyword variants)
+    std::shared_ptr<ShaderPermutations> LoadShader(const std::string& name, const std::string& vertexShaderFile,
+                                                   const std::string& pixelShaderFile);
+    std::shared_ptr<ShaderPermutations> GetShader(const std::string& name);
+    void UnloadShader(const std::string& name);
+
+    // Material management; ShaderWarmup walks these to find the shader variants a level uses
+    std::shared_ptr<Material> CreateMaterial(const std::string& name);
+    std::shared_ptr<Material> GetMaterial(const std::string& name);
+    void UnloadMaterial(const std::string& name);
+    const std::unordered_map<std::string, std::shared_ptr<Material>>& GetMaterials() const { return materials_; }
+
+    // Loaded textures and shaders reload in place when their files change, so everything
+    // holding them sees the new version. nullptr stops it
+    void EnableHotReload(FileWatcher* watcher);
 
     // Resource paths
     void AddResourcePath(const std::string& path);
     std::string FindResourceFile(const std::string& filename);
 
-    // Memory management
+    // Paks, the last mounted searched first. A name is looked up in a pak as a loose file is on
+    // disk: as given, then under each resource path. Loads in flight keep an unmounted pak open
+    bool MountPak(const std::string& filename);
+    void UnmountPak(const std::string& filename);
+
+    // Memory management. A texture or mesh is unused when no handle references it and nothing
+    // but the manager shares it
     void ClearUnusedResources();
     size_t GetMemoryUsage() const;
+    size_t GetMemoryUsage(ResourceType type) const;
+
+    // Bytes resident, 0 for no budget. Unused resources stay cached until their type goes over
+    // budget. The texture budget includes streamed textures: what the others leave of it becomes
+    // the streaming engine's budget, so streamed mips give way to loaded textures
+    void SetMemoryBudget(ResourceType type, size_t bytes);
+    size_t GetMemoryBudget(ResourceType type) const { return memoryBudgets_[static_cast<size_t>(type)]; }
 
 private:
-    std::unordered_map<std::string, std::shared_ptr<Texture>> textures_;
-    std::unordered_map<std::string, std::shared_ptr<Mesh>> meshes_;
+    template <typename Resource> struct AsyncLoad;
+
+    template <typename Handle>
+    struct Entry {
+        Handle handle;
+        uint64_t lastUsedFrame;                  // The last frame anything held it
+        uint32_t usedFrames;                     // How many frames anything has held it
+    };
+    using TextureLoad = AsyncLoad<Texture>;
+    using MeshLoad = AsyncLoad<Mesh>;
+
+    void WatchFile(const std::string& path);
+    void OnFileChanged(const std::string& path);
+    const PakEntry* FindPakEntry(const std::string& filename, std::shared_ptr<PakArchive>& pak) const;
+    const PakEntry* FindPakMesh(const std::string& filename, std::shared_ptr<PakArchive>& pak) const;
+
+    void LoaderMain();
+    void StopLoader();
+    void Enqueue(std::function<void()> work);
+    template <typename Resource> void WaitForLoad(const AsyncLoad<Resource>& load);
+    void PublishTexture(const std::string& name, TextureLoad& load);
+    void PublishMesh(const std::string& name, MeshLoad& load);
+    void RegisterTexture(const std::string& name, std::shared_ptr<Texture> texture);
+    void RegisterMesh(const std::string& name, std::shared_ptr<Mesh> mesh);
+    void EnforceMemoryBudgets();
+    void ReportOverBudget(ResourceType type, size_t bytes);
+    void RecordLoad(ResourceType type, const std::string& name, const std::string& filename);
+    void UpdatePrefetch();
+
+    ResourcePool<Texture> texturePool_;
+    ResourcePool<Mesh> meshPool_;
+    std::unordered_map<std::string, Entry<TextureHandle>> textures_;
+    std::unordered_map<std::string, Entry<MeshHandle>> meshes_;
+    std::unordered_map<std::string, std::shared_ptr<ShaderPermutations>> shaders_;
+    std::unordered_map<std::string, std::shared_ptr<Material>> materials_;
     std::vector<std::string> resourcePaths_;
+    std::vector<std::shared_ptr<PakArchive>> paks_;
+
+    // Normalized source files by resource name, for hot reload
+    std::unordered_map<std::string, std::string> textureFiles_;
+    std::unordered_map<std::string, std::pair<std::string, std::string>> shaderFiles_;
+    FileWatcher* fileWatcher_;
+    uint32_t fileListener_;
+
+    // Asynchronous loads by resource name, main thread
+    std::unordered_map<std::string, std::shared_ptr<TextureLoad>> textureLoads_;
+    std::unordered_map<std::string, std::shared_ptr<MeshLoad>> meshLoads_;
+
+    // Loader thread
+    std::thread loader_;
+    std::mutex loadMutex_;
+    std::condition_variable loadCondition_;      // Work queued
+    std::condition_variable doneCondition_;      // A load finished
+    std::deque<std::function<void()>> loadQueue_;
+    bool stopLoader_;
+
+    // Load order, recorded and prefetched
+    bool recordingLoadOrder_;
+    std::chrono::steady_clock::time_point recordingStart_;
+    std::vector<LoadOrderEntry> loadOrder_;
+    std::unordered_set<std::string> recordedLoads_; // Type and name
+    std::vector<LoadOrderEntry> prefetchList_;
+    size_t prefetchNext_;
+    size_t prefetchWindow_;
+    bool prefetching_;                           // Requests are the prefetcher's, not the game's
+
+    size_t memoryBudgets_[static_cast<size_t>(ResourceType::Count)];
+    bool overBudget_[static_cast<size_t>(ResourceType::Count)];     // Warned, until back under
+    uint64_t streamingBudget_;                   // The streaming engine's own, while textures have none
+    uint64_t frame_;
     
     bool initialized_;
-    size_t memoryUsage_;
     ID3D11Device* device_;  // Graphics device for resource loading
+    TextureStreamingEngine* streaming_;
+    JobSystem* jobs_;
 };
 
 } // namespace Nexus
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Typed 32-bit resource handle: slot index plus generation, so a handle to a resource that has
+ * been removed is rejected instead of resolving to whatever reuses its slot. Zero is no handle
+ */
+template <typename Resource>
+struct ResourceHandle {
+    static constexpr uint32_t INDEX_BITS = 20;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+    uint32_t value = 0;
+
+    uint32_t GetIndex() const { return value & INDEX_MASK; }
+    uint32_t GetGeneration() const { return value >> INDEX_BITS; }
+    bool IsValid() const { return value != 0; }
+    bool operator==(const ResourceHandle& other) const { return value == other.value; }
+    bool operator!=(const ResourceHandle& other) const { return value != other.value; }
+};
+
+/**
+ * Slots of resources addressed by handle, main thread only.
+ *
+ * Get() is an index and a generation compare: no hashing, and no atomic reference counting
+ * since the slot caches a raw pointer beside the owning one. Each slot also keeps a plain
+ * count of the handle references taken with AddRef(), which is what lifetime decisions use.
+ * Freed slots are reused, last freed first, with the next generation (never zero).
+ */
+template <typename Resource>
+class ResourcePool {
+public:
+    using Handle = ResourceHandle<Resource>;
+
+    // No handle once every index is taken
+    Handle Add(std::shared_ptr<Resource> resource) {
+        uint32_t index;
+        if (freeSlots_.empty()) {
+            if (slots_.size() > Handle::INDEX_MASK) return Handle{};
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        } else {
+            index = freeSlots_.back();
+            freeSlots_.pop_back();
+        }
+        Slot& slot = slots_[index];
+        slot.resource = resource.get();
+        slot.shared = std::move(resource);
+        slot.references = 0;
+        return Handle{ (slot.generation << Handle::INDEX_BITS) | index };
+    }
+
+    void Remove(Handle handle) {
+        Slot* slot = Find(handle);
+        if (!slot) return;
+        slot->shared.reset();
+        slot->resource = nullptr;
+        slot->references = 0;
+        slot->generation = (slot->generation + 1) & Handle::GENERATION_MASK;
+        if (slot->generation == 0) slot->generation = 1;
+        freeSlots_.push_back(handle.GetIndex());
+    }
+
+    // Null for a handle whose resource was removed
+    Resource* Get(Handle handle) const {
+        const Slot* slot = Find(handle);
+        return slot ? slot->resource : nullptr;
+    }
+    const std::shared_ptr<Resource>& GetShared(Handle handle) const {
+        static const std::shared_ptr<Resource> none;
+        const Slot* slot = Find(handle);
+        return slot ? slot->shared : none;
+    }
+    bool IsValid(Handle handle) const { return Find(handle) != nullptr; }
+
+    void AddRef(Handle handle) {
+        if (Slot* slot = Find(handle)) ++slot->references;
+    }
+    // The references left; zero also for a stale handle
+    uint32_t Release(Handle handle) {
+        Slot* slot = Find(handle);
+        if (!slot || slot->references == 0) return 0;
+        return --slot->references;
+    }
+    uint32_t GetRefCount(Handle handle) const {
+        const Slot* slot = Find(handle);
+        return slot ? slot->references : 0;
+    }
+
+    size_t GetCount() const { return slots_.size() - freeSlots_.size(); }
+    // Every slot ever used; live ones resolve, the rest are null
+    size_t GetCapacity() const { return slots_.size(); }
+
+    // Every handle goes stale, as if each were removed
+    void Clear() {
+        for (uint32_t index = 0; index < slots_.size(); ++index) {
+            const Slot& slot = slots_[index];
+            if (slot.resource) Remove(Handle{ (slot.generation << Handle::INDEX_BITS) | index });
+        }
+    }
+
+private:
+    struct Slot {
+        std::shared_ptr<Resource> shared;
+        Resource* resource = nullptr;
+        uint32_t generation = 1;
+        uint32_t references = 0;
+    };
+
+    Slot* Find(Handle handle) {
+        return const_cast<Slot*>(static_cast<const ResourcePool*>(this)->Find(handle));
+    }
+    const Slot* Find(Handle handle) const {
+        const uint32_t index = handle.GetIndex();
+        if (!handle.IsValid() || index >= slots_.size()) return nullptr;
+        const Slot& slot = slots_[index];
+        return slot.resource && slot.generation == handle.GetGeneration() ? &slot : nullptr;
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> freeSlots_;
+};
+
+} // namespace Nexus
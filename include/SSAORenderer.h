@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace Nexus {
+
+/**
+ * Compute-shader ambient occlusion at reduced resolution.
+ *
+ * The hardware depth buffer is first reduced to linear view depth and a view-space normal at
+ * 1/resolutionDivisor size, picking the nearest and farthest sample of each block in a
+ * checkerboard so both sides of an edge survive. Occlusion is then traced from that small buffer
+ * with a few hemisphere samples whose rotation changes every frame, and the noise is averaged
+ * over frames: history is reprojected with the camera motion, clamped to the range of the
+ * current 3x3 neighbourhood and dropped where its depth no longer matches. A depth-aware bilateral
+ * upsample brings the result back to full resolution without bleeding across silhouettes.
+ */
+class SSAORenderer {
+public:
+    struct Settings {
+        UINT resolutionDivisor = 2;  // 1, 2 or 4
+        UINT sampleCount = 8;        // Per pixel per frame, before temporal accumulation
+        float radius = 0.5f;         // World units
+        float intensity = 1.5f;      // Exponent on the visibility
+        float bias = 0.02f;          // Fraction of the view depth ignored as self occlusion
+        float temporalBlend = 0.1f;  // Weight of the current frame against the history
+    };
+
+    SSAORenderer();
+    ~SSAORenderer();
+
+    SSAORenderer(const SSAORenderer&) = delete;
+    SSAORenderer& operator=(const SSAORenderer&) = delete;
+
+    // width and height are the size of the depth buffer Render() reads
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height,
+                    const Settings& settings);
+    void Shutdown();
+    const Settings& GetSettings() const { return settings_; }
+
+    // Drops the accumulated history, e.g. after a camera cut
+    void ResetHistory() { historyValid_ = false; }
+
+    // depth is the scene's hardware depth (R32_FLOAT or R24_UNORM view, not bound as depth
+    // target). view and projection are the row-vector camera matrices of a perspective projection
+    void Render(ID3D11ShaderResourceView* depth, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+
+    // Full-resolution R8 visibility, 1 where unoccluded, valid after Render()
+    ID3D11ShaderResourceView* GetOcclusionView() const { return outputView_; }
+
+private:
+    bool CreateShaders();
+    bool CreateTargets();
+    void Dispatch(ID3D11ComputeShader* shader, ID3D11ShaderResourceView* const* views, UINT viewCount,
+                  ID3D11UnorderedAccessView* const* targets, UINT targetCount, UINT width, UINT height);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    Settings settings_;
+    UINT width_;
+    UINT height_;
+    UINT lowWidth_;
+    UINT lowHeight_;
+
+    ID3D11ComputeShader* downsampleShader_;
+    ID3D11ComputeShader* occlusionShader_;
+    ID3D11ComputeShader* temporalShader_;
+    ID3D11ComputeShader* upsampleShader_;
+    ID3D11Buffer* constants_;
+    ID3D11SamplerState* linearClamp_;
+
+    // Reduced-resolution linear depth, normals and raw occlusion
+    ID3D11Texture2D* lowDepth_;
+    ID3D11ShaderResourceView* lowDepthView_;
+    ID3D11UnorderedAccessView* lowDepthTarget_;
+    ID3D11Texture2D* lowNormal_;
+    ID3D11ShaderResourceView* lowNormalView_;
+    ID3D11UnorderedAccessView* lowNormalTarget_;
+    ID3D11Texture2D* rawOcclusion_;
+    ID3D11ShaderResourceView* rawOcclusionView_;
+    ID3D11UnorderedAccessView* rawOcclusionTarget_;
+
+    // Accumulated occlusion and the linear depth it belongs to, ping-ponged every frame
+    ID3D11Texture2D* history_[2];
+    ID3D11ShaderResourceView* historyViews_[2];
+    ID3D11UnorderedAccessView* historyTargets_[2];
+    UINT historyIndex_;
+    bool historyValid_;
+
+    ID3D11Texture2D* output_;
+    ID3D11ShaderResourceView* outputView_;
+    ID3D11UnorderedAccessView* outputTarget_;
+
+    DirectX::XMFLOAT4X4 previousViewProjection_;
+    UINT frame_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "BinaryFile.h"
+#include "ECS.h"
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Saves and restores the world's entities in the binary file format.
+ *
+ * Each core component (transform, physics body, renderable, replicated) is written as one dense
+ * section in entity order, with a section of per-entity masks saying which entities own which.
+ * Entities with none of them are not saved. Bodies keep their velocity, mass and settings; what
+ * PhysicsEngine owns (broadphase proxy, resting steps) is rebuilt, so sleeping bodies load awake
+ * and settle again within a few steps. Entity ids are not preserved: Read() creates new entities
+ * in the order they were saved.
+ */
+class SaveGame {
+public:
+    static constexpr uint32_t CONTENT_TYPE = MakeFourCC('S', 'A', 'V', 'E');
+    static constexpr uint32_t VERSION = 1;
+
+    static bool Write(const World& world, const std::string& filename, bool compress = true);
+    // Adds the saved entities to world, which is not cleared first; entities receives them in
+    // saved order when given. False (and world unchanged) for a missing or damaged file
+    static bool Read(World& world, const std::string& filename, std::vector<Entity>* entities = nullptr);
+};
+
+} // namespace Nexus
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Axis-aligned bounding box in world space
+ */
+struct AABB {
+    DirectX::XMFLOAT3 min;
+    DirectX::XMFLOAT3 max;
+
+    static AABB FromCenterExtents(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents) {
+        return {{center.x - extents.x, center.y - extents.y, center.z - extents.z},
+                {center.x + extents.x, center.y + extents.y, center.z + extents.z}};
+    }
+};
+
+/**
+ * Six normalized planes (inside where dot(plane, point) >= 0) pulled out of a view-projection
+ * matrix, so the same type serves the main camera and light frustums.
+ */
+struct Frustum {
+    enum Plane { Left, Right, Bottom, Top, Near, Far, PLANE_COUNT };
+
+    DirectX::XMFLOAT4 planes[PLANE_COUNT];
+
+    // Row-vector convention (v * M) with D3D clip depth in [0, w]
+    static Frustum FromViewProjection(DirectX::FXMMATRIX viewProjection);
+
+    bool Intersects(const AABB& box) const;
+};
+
+/**
+ * Bounding-volume hierarchy over scene objects for frustum culling.
+ *
+ * The tree is four-wide with child bounds stored structure-of-arrays, so one frustum plane is
+ * tested against all four children in a single SIMD operation. Subtrees that are fully inside
+ * the frustum are accepted without further plane tests, and the ones fully outside a plane are
+ * dropped whole. Build() is a median split on the longest axis and is cheap enough to redo every
+ * frame for moving objects; items are identified by their index in the array passed to Build().
+ */
+class SceneBVH {
+public:
+    struct Stats {
+        uint32_t tested = 0;    // Objects handed to the last query
+        uint32_t visible = 0;
+        uint32_t culled = 0;
+        uint32_t nodesVisited = 0;
+    };
+
+    static constexpr uint32_t LEAF_SIZE = 4;
+
+    SceneBVH();
+
+    void Build(const AABB* boxes, size_t count);
+    void Clear();
+
+    // Appends the index of every object whose box intersects the frustum to visible
+    void Query(const Frustum& frustum, std::vector<uint32_t>& visible);
+
+    size_t GetObjectCount() const { return items_.size(); }
+    size_t GetNodeCount() const { return nodes_.size(); }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    // Four children in SoA form; a child is either another node or a leaf range of items
+    struct alignas(16) Node {
+        float minX[4], minY[4], minZ[4];
+        float maxX[4], maxY[4], maxZ[4];
+        uint32_t child[4];   // Node index, or first item for leaves
+        uint32_t count[4];   // 0 for inner nodes, item count for leaves
+    };
+
+    uint32_t BuildNode(uint32_t first, uint32_t count);
+    void SetChild(Node& node, int slot, uint32_t first, uint32_t count);
+    void AppendSubtree(uint32_t child, uint32_t count, std::vector<uint32_t>& visible) const;
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> items_;     // Object indices, grouped so leaves are contiguous
+    std::vector<AABB> boxes_;         // Indexed by object
+    std::vector<DirectX::XMFLOAT3> centers_;
+    std::vector<uint32_t> stack_;
+    Stats stats_;
+};
+
+} // namespace Nexus
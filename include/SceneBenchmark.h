@@ -0,0 +1,113 @@
+#pragma once
+
+#include "InputManager.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+class Engine;
+
+/**
+ * Whole-engine benchmark: a stock scene played along a camera path and an input script.
+ *
+ * Initialize() builds the named scene through the engine's subsystems and loads the path. The
+ * engine then runs uncapped and simulates the same timeStep every frame whatever the frame took,
+ * so two runs of one build do the same work frame for frame. Each frame BeginFrame() places the
+ * camera at that frame's point on the path and injects that frame's input; EndFrame() records
+ * the frame's wall time, CPU time and the profiler's subsystem scopes. GPU times resolve a few
+ * frames late and are matched to their frames in order, the profiler resolving every frame, so
+ * a few frames past the last one run until they arrive.
+ *
+ * warmupFrames hold the camera at the start of the path with no input and are not recorded.
+ * The report has p50/p95/p99/max of every series and the slowest frame broken down by
+ * subsystem and GPU pass.
+ *
+ * The path file is text, one entry per line, '#' starting a comment:
+ *   camera <seconds> <x> <y> <z> <targetX> <targetY> <targetZ>
+ *   input <frame> <event> <code> <x> <y> [controller]
+ * Camera keys are interpolated linearly; events are keydown, keyup, buttondown, buttonup, move,
+ * wheel, padbuttondown and padbuttonup with the fields of InputEvent. Without a path the camera
+ * orbits the scene once. With record set the camera and input are left live and the path is
+ * written from them instead, one camera key per frame.
+ */
+class SceneBenchmark {
+public:
+    struct Settings {
+        std::string scene;                      // One of GetSceneNames()
+        std::string pathFile;                   // Camera path and input script; empty orbits
+        std::string reportFile = "scene_benchmark.json";
+        uint32_t warmupFrames = 60;
+        uint32_t frames = 0;                    // Recorded; 0 plays the whole path
+        float timeStep = 1.0f / 60.0f;          // Simulated per frame, in seconds
+        bool record = false;                    // Writes pathFile instead of playing it
+    };
+
+    explicit SceneBenchmark(const Settings& settings);
+
+    static std::vector<std::string> GetSceneNames();
+
+    // Once the engine's subsystems are up; false for an unknown scene, a scene whose subsystems
+    // are missing, or a path that can't be read
+    bool Initialize(Engine& engine);
+    // Before the frame's update, and after it rendered; EndFrame() is false once the run is done
+    void BeginFrame(Engine& engine);
+    bool EndFrame(Engine& engine, float cpuMs);
+    // The report with the recorded frames, or the path when recording
+    bool Finish() const;
+
+    const Settings& GetSettings() const { return settings_; }
+    bool IsRecording() const { return settings_.record; }
+
+private:
+    struct CameraKey {
+        float time;
+        DirectX::XMFLOAT3 position;
+        DirectX::XMFLOAT3 target;
+    };
+
+    struct ScriptedEvent {
+        uint32_t frame;
+        InputEvent event;
+    };
+
+    struct GpuPass {
+        const char* name;
+        uint16_t depth;
+        float milliseconds;
+    };
+
+    struct FrameSample {
+        float frameMs = 0.0f;
+        float cpuMs = 0.0f;
+        float gpuMs = -1.0f;                    // Negative until resolved
+        std::vector<float> subsystemMs;         // By SUBSYSTEM_SCOPES
+        std::vector<GpuPass> gpuPasses;
+    };
+
+    bool BuildScene(Engine& engine);
+    bool LoadPath();
+    bool WritePath() const;
+    bool WriteReport() const;
+    void GetCamera(float time, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& target) const;
+    void RecordGpuFrame(Engine& engine);
+
+    Settings settings_;
+    std::vector<CameraKey> cameraKeys_;
+    std::vector<ScriptedEvent> events_;         // By frame
+    size_t nextEvent_;
+    DirectX::XMFLOAT3 orbitCenter_;             // Default path when there is no path file
+    float orbitRadius_;
+    float orbitHeight_;
+
+    uint32_t frameIndex_;                       // Warmup included
+    uint32_t measuredFrames_;                   // Frames to record, after warmup
+    uint32_t drainFrames_;                      // Run past the end while GPU times resolve
+    uint64_t frameStartNs_;
+    uint64_t gpuFramesAtStart_;
+    std::vector<FrameSample> frames_;
+};
+
+} // namespace Nexus
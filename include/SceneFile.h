@@ -0,0 +1,75 @@
+#pragma once
+
+#include "BinaryFile.h"
+#include "TransformHierarchy.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * A scene's node hierarchy in the binary file format, as written by the game importers.
+ *
+ * Nodes are stored structure-of-arrays: one section of parent and name records, and one each of
+ * local positions, rotations (quaternions) and scales, with names and component type names in a
+ * string table. Uncompressed sections are used straight from the file mapping, so opening a scene
+ * costs the reads of the sections touched; compressed ones are decoded once into buffers.
+ */
+class SceneFile {
+public:
+    static constexpr uint32_t CONTENT_TYPE = MakeFourCC('S', 'C', 'N', 'E');
+    static constexpr uint32_t VERSION = 1;
+
+    // A node to write. Parents come before their children
+    struct Node {
+        std::string name;
+        int32_t parent = -1;
+        DirectX::XMFLOAT3 position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+        DirectX::XMFLOAT4 rotation = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+        DirectX::XMFLOAT3 scale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
+        std::vector<std::string> components;    // Type names, as the source engine called them
+    };
+
+    static bool Write(const std::string& filename, const std::vector<Node>& nodes, bool compress = true);
+
+    // False for a missing, damaged or out of date file
+    bool Open(const std::string& filename);
+    void Close();
+
+    size_t GetNodeCount() const { return nodeCount_; }
+    int32_t GetParent(size_t node) const { return records_[node].parent; }
+    const char* GetName(size_t node) const;
+    const DirectX::XMFLOAT3* GetPositions() const { return positions_; }
+    const DirectX::XMFLOAT4* GetRotations() const { return rotations_; }
+    const DirectX::XMFLOAT3* GetScales() const { return scales_; }
+    size_t GetComponentCount(size_t node) const { return records_[node].componentCount; }
+    const char* GetComponent(size_t node, size_t index) const;
+
+    // Creates every node, roots under parent; nodes[i] receives node i's id
+    void AddToHierarchy(TransformHierarchy& hierarchy, std::vector<TransformHierarchy::NodeID>& nodes,
+                        TransformHierarchy::NodeID parent = TransformHierarchy::INVALID_NODE) const;
+
+private:
+    struct NodeRecord {
+        int32_t parent;
+        uint32_t name;                          // Into the string table
+        uint32_t firstComponent;                // Into the component section
+        uint32_t componentCount;
+    };
+
+    BinaryFile file_;
+    size_t nodeCount_ = 0;
+    const NodeRecord* records_ = nullptr;
+    const DirectX::XMFLOAT3* positions_ = nullptr;
+    const DirectX::XMFLOAT4* rotations_ = nullptr;
+    const DirectX::XMFLOAT3* scales_ = nullptr;
+    const uint32_t* components_ = nullptr;      // String table offsets
+    const char* strings_ = nullptr;
+    size_t stringBytes_ = 0;
+    // Decoded compressed sections, one per section
+    std::vector<uint8_t> buffers_[6];
+};
+
+} // namespace Nexus
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Platform.h"
+#include <vector>
+
+namespace Nexus {
+
+class DeferredRenderer;
+class OcclusionCuller;
+class ProbeVolume;
+
+/**
+ * Hi-Z screen-space reflections, the raster fallback for GPUs without RayTracingEngine's DXR path.
+ *
+ * Rays are traced at half resolution, one G-buffer sample of each 2x2 block per frame in turn,
+ * through the OcclusionCuller's depth pyramid: a ray in front of the nearest depth of a cell
+ * steps to the cell's edge and climbs a level, otherwise it descends, so empty space is crossed
+ * in logarithmic steps and a ray costs a few dozen texel reads however far it goes. Hits read the
+ * last lit frame, reprojected, from a mip chain of its colors at the level the roughness cone has
+ * widened to by the hit, so rough surfaces get blurry reflections from one tap. Rays that miss,
+ * leave the screen, hit a back face or pass behind a surface fall back to the probe volume's
+ * irradiance in the reflected direction, or the flat ambient without one, and the two are faded
+ * together near the screen edges and the roughness cut-off. The result accumulates over frames
+ * like SSAORenderer's, reprojected, clamped to the 3x3 neighbourhood and rejected on depth, and is
+ * bilaterally upsampled to full resolution for DeferredRenderer to weight by its Fresnel term.
+ */
+class ScreenSpaceReflections {
+public:
+    struct Settings {
+        UINT maxSteps = 48;             // Pyramid texel reads per ray
+        float maxDistance = 50.0f;      // World units
+        float thickness = 0.05f;        // Fraction of the view depth a hit may lie behind a surface
+        float maxRoughness = 0.7f;      // Rougher surfaces use the fallback only
+        float edgeFade = 0.1f;          // Fraction of the screen over which hits fade out at its edges
+        float temporalBlend = 0.15f;    // Weight of the current frame against the history
+    };
+
+    ScreenSpaceReflections();
+    ~ScreenSpaceReflections();
+
+    ScreenSpaceReflections(const ScreenSpaceReflections&) = delete;
+    ScreenSpaceReflections& operator=(const ScreenSpaceReflections&) = delete;
+
+    // width and height are the G-buffer's
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height,
+                    const Settings& settings);
+    void Shutdown();
+    const Settings& GetSettings() const { return settings_; }
+    void SetSettings(const Settings& settings);
+
+    // Drops the accumulated history, e.g. after a camera cut
+    void ResetHistory() { historyValid_ = false; }
+
+    // Traces the G-buffer against hiZ, which must have been built from its depth with this
+    // frame's camera. previousScene is the last lit frame as DeferredRenderer wrote it, tonemapped
+    // and gamma-encoded with gamma, and is read before this frame's lighting overwrites it.
+    // Without a pyramid or a previous frame every pixel takes the fallback. view and projection
+    // are the row-vector matrices of a perspective projection
+    void Render(const DeferredRenderer& gbuffer, const OcclusionCuller* hiZ, ID3D11ShaderResourceView* previousScene,
+                float gamma, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection,
+                const DirectX::XMFLOAT3& ambientLight, const ProbeVolume* probes = nullptr);
+
+    // Full-resolution RGBA16F reflected radiance, linear and before Fresnel, valid after Render()
+    ID3D11ShaderResourceView* GetReflectionView() const { return outputView_; }
+
+private:
+    bool CreateShaders();
+    bool CreateTargets();
+    void ReleaseTargets();
+    void Dispatch(ID3D11ComputeShader* shader, ID3D11ShaderResourceView* const* views, UINT viewCount,
+                  ID3D11UnorderedAccessView* target, UINT width, UINT height);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    Settings settings_;
+    UINT width_;
+    UINT height_;
+    UINT lowWidth_;
+    UINT lowHeight_;
+
+    ID3D11ComputeShader* colorShader_;
+    ID3D11ComputeShader* colorMipShader_;
+    ID3D11ComputeShader* traceShader_;
+    ID3D11ComputeShader* temporalShader_;
+    ID3D11ComputeShader* upsampleShader_;
+    ID3D11Buffer* constants_;
+    ID3D11Buffer* mipConstants_;
+    ID3D11SamplerState* linearClamp_;
+
+    // The last lit frame at half resolution, linear, with a mip per doubling of the cone
+    ID3D11Texture2D* color_;
+    ID3D11ShaderResourceView* colorView_;
+    std::vector<ID3D11ShaderResourceView*> colorMipViews_;
+    std::vector<ID3D11UnorderedAccessView*> colorMipTargets_;
+
+    // Raw reflections and the accumulated ones, each with the linear depth they belong to
+    ID3D11Texture2D* raw_;
+    ID3D11ShaderResourceView* rawView_;
+    ID3D11UnorderedAccessView* rawTarget_;
+    ID3D11Texture2D* history_[2];
+    ID3D11ShaderResourceView* historyViews_[2];
+    ID3D11UnorderedAccessView* historyTargets_[2];
+    UINT historyIndex_;
+    bool historyValid_;
+
+    ID3D11Texture2D* output_;
+    ID3D11ShaderResourceView* outputView_;
+    ID3D11UnorderedAccessView* outputTarget_;
+
+    DirectX::XMFLOAT4X4 previousViewProjection_;
+    bool previousValid_;
+    UINT frame_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class GraphicsDevice;
+
+/**
+ * Native storage of the game objects scripts create (GameObject in python/nexus_api.py).
+ *
+ * Transforms and draw state live in parallel arrays indexed by a slot an object keeps for its
+ * lifetime, so script attribute access reads and writes this memory directly and a scene can
+ * gather every drawable object without touching the scripting runtime. Freed slots are reused.
+ */
+class ScriptObjectStore {
+public:
+    enum class Shape : uint8_t { None, Box, Sphere };
+
+    uint32_t Allocate();
+    void Free(uint32_t slot);
+
+    DirectX::XMFLOAT3& Position(uint32_t slot) { return positions_[slot]; }
+    DirectX::XMFLOAT3& Rotation(uint32_t slot) { return rotations_[slot]; }     // Euler angles, radians
+    DirectX::XMFLOAT3& Scale(uint32_t slot) { return scales_[slot]; }
+    DirectX::XMFLOAT3& Size(uint32_t slot) { return sizes_[slot]; }             // Box extents; x is a sphere's radius
+    DirectX::XMFLOAT4& Color(uint32_t slot) { return colors_[slot]; }
+    Shape GetShape(uint32_t slot) const { return shapes_[slot]; }
+    void SetShape(uint32_t slot, Shape shape) { shapes_[slot] = shape; }
+    bool IsActive(uint32_t slot) const { return active_[slot] != 0; }
+    void SetActive(uint32_t slot, bool active) { active_[slot] = active ? 1 : 0; }
+
+    size_t GetObjectCount() const { return positions_.size() - freeSlots_.size(); }
+
+private:
+    std::vector<DirectX::XMFLOAT3> positions_;
+    std::vector<DirectX::XMFLOAT3> rotations_;
+    std::vector<DirectX::XMFLOAT3> scales_;
+    std::vector<DirectX::XMFLOAT3> sizes_;
+    std::vector<DirectX::XMFLOAT4> colors_;
+    std::vector<Shape> shapes_;
+    std::vector<uint8_t> active_;
+    std::vector<uint32_t> freeSlots_;
+};
+
+/**
+ * The objects of one script scene, in the order they were added.
+ *
+ * Each member records which callbacks its script class overrides, found once when it's added, so
+ * an update or render pass calls into the script only for those; objects that just sit there or
+ * move through their transform cost nothing per frame. Objects with a shape and no render callback
+ * are drawn by SubmitBatches() in one call per shape. Members added or removed during a pass take
+ * part from the next one, and a removed member isn't called again.
+ */
+class ScriptScene {
+public:
+    enum Callback : uint8_t {
+        CALLBACK_UPDATE = 1 << 0,
+        CALLBACK_RENDER = 1 << 1
+    };
+
+    explicit ScriptScene(ScriptObjectStore& store);
+
+    // object is the script's handle, passed back to the pass callbacks; the caller keeps it alive
+    // while it's a member. False when the slot is already a member
+    bool Add(uint32_t slot, uint8_t callbacks, void* object);
+    bool Remove(uint32_t slot);
+    bool Contains(uint32_t slot) const;
+    void Clear();
+
+    // Calls function(object) for every active member with the callback
+    template<typename Function>
+    void ForEach(Callback callback, Function&& function);
+
+    void SubmitBatches(GraphicsDevice& graphics);
+
+    // Live members in order, for scripts that list them
+    template<typename Function>
+    void ForEachMember(Function&& function) const {
+        for (const Member& member : members_) {
+            if (member.object) function(member.object);
+        }
+    }
+    size_t GetMemberCount() const { return memberCount_; }
+
+private:
+    static constexpr uint32_t NOT_A_MEMBER = ~0u;
+
+    struct Member {
+        uint32_t slot;
+        uint8_t callbacks;
+        void* object;                           // Null once removed, until compacted
+    };
+
+    void EndPass();
+
+    ScriptObjectStore& store_;
+    std::vector<Member> members_;
+    std::vector<uint32_t> memberIndex_;         // By slot
+    std::vector<Member> pendingAdds_;           // Added during a pass
+    size_t memberCount_;
+    bool inPass_;
+    bool needsCompact_;
+
+    // Batch scratch
+    std::vector<DirectX::XMFLOAT3> batchPositions_;
+    std::vector<DirectX::XMFLOAT3> batchSizes_;
+    std::vector<float> batchRadii_;
+    std::vector<DirectX::XMFLOAT4> batchColors_;
+};
+
+template<typename Function>
+void ScriptScene::ForEach(Callback callback, Function&& function) {
+    // A nested pass, from a callback calling the scene's update, runs members once more
+    const bool outermost = !inPass_;
+    inPass_ = true;
+    try {
+        // Indexed, since a callback may add members (to pendingAdds_) but never moves these
+        for (size_t i = 0; i < members_.size(); ++i) {
+            const Member member = members_[i];
+            if (member.object && (member.callbacks & callback) && store_.IsActive(member.slot)) {
+                function(member.object);
+            }
+        }
+    } catch (...) {
+        if (outermost) EndPass();
+        throw;
+    }
+    if (outermost) EndPass();
+}
+
+} // namespace Nexus
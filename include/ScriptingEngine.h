@@ -4,18 +4,39 @@
 #ifdef NEXUS_PYTHON_ENABLED
 #include <Python.h>
 #endif
+#include "Logger.h"
 #include <memory>
 #include <string>
 #include <functional>
+#include <cstdint>
 #include <map>
+#include <unordered_map>
 #include <vector>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <utility>
 
 namespace Nexus {
 
 class Engine;
+class FileWatcher;
 
 /**
  * Python scripting engine for game logic
+ *
+ * Events triggered during a frame are queued and dispatched by Update() together with the
+ * script's update(dt), a global in __main__, under one acquisition of the GIL. The GIL is
+ * released between calls, so other threads can take it. With the Python thread enabled that
+ * whole batch, and everything else that runs Python, is queued to a thread of its own instead
+ * and the main loop never waits on a script.
+ *
+ * Long-running logic goes in tasks: generators or coroutines passed to nexus_tasks.start_task
+ * that yield (or await) nexus_tasks.wait_frames, wait_seconds or wait_event, or yield nothing
+ * for the next frame. After update(dt) the ready tasks are resumed round-robin until the task
+ * budget is spent; the rest go first next frame.
  */
 class ScriptingEngine {
 public:
@@ -30,8 +51,9 @@ public:
     bool ExecuteFile(const std::string& filename);
     bool ExecuteString(const std::string& code);
     
-    // Hot reloading
-    void EnableHotReload(bool enable) { hotReloadEnabled_ = enable; }
+    // Hot reloading: scripts run by ExecuteFile run again when the engine's FileWatcher
+    // reports them changed
+    void EnableHotReload(bool enable);
     void CheckForChanges();
     void ReloadModifiedScripts();
 
@@ -39,23 +61,118 @@ public:
     void SetEngine(Engine* engine) { engine_ = engine; }
     Engine* GetEngine() const { return engine_; }
 
-    // Event system
+    // Event system. Callbacks run with the GIL held, on the Python thread when it's enabled.
+    // TriggerEvent only queues, the callback runs in the next Update
     void RegisterEventCallback(const std::string& eventName, std::function<void()> callback);
     void TriggerEvent(const std::string& eventName);
 
     // Update loop
     void Update(float deltaTime);
 
+    // Runs Python on a thread of its own. Execute* then return once queued, reporting only
+    // that; errors are logged at a later Update. Frames the thread hasn't reached yet are merged,
+    // so a slow script skips updates rather than queueing them. Disabling waits for the queue
+    void EnablePythonThread(bool enable);
+    bool IsPythonThreadEnabled() const { return pythonThread_.joinable(); }
+
+    // Python can't be interrupted, so a task that runs long between yields still finishes its step
+    void SetTaskBudget(float milliseconds) { taskBudgetMs_ = milliseconds; }
+
+    // Times every Python function call as a CPU profiler scope named after the function and
+    // where it is defined, on whichever thread runs Python. A profile hook on every call, so for
+    // profiling sessions; takes effect the next time Python runs
+    void EnableProfiling(bool enable) { profiling_ = enable; }
+    bool IsProfilingEnabled() const { return profiling_; }
+
 private:
+    // A frame's work: the events in the order triggered, then update(deltaTime)
+    struct Batch {
+        std::vector<std::string> events;
+        float deltaTime = 0.0f;
+    };
+
+    // For the Python thread, in order: a task, or a frame when it has none
+    struct Command {
+        std::function<void()> task;
+        Batch frame;
+    };
+
     void InitializePythonBindings();
     void AddToPath(const std::string& path);
+    void SetFileWatcher(FileWatcher* watcher);
+    void WatchScript(const std::string& filename);
+
+    // With the GIL held
+    bool RunFile(const std::string& filename);
+    bool RunString(const std::string& code);
+    void Dispatch(const Batch& batch);
+    void RunTasks(const Batch& batch);
+    void ApplyProfiling();
+    const char* GetEventScopeName(const std::string& eventName);
+
+    void Submit(std::function<void()> task);
+    void PythonThreadMain();
+
+    // Logger isn't thread-safe, so messages from Python code wait for the main thread
+    void Log(LogLevel level, const std::string& message);
+    void FlushLogs();
     
     Engine* engine_;
     bool initialized_;
     bool hotReloadEnabled_;
     
     std::map<std::string, std::function<void()>> eventCallbacks_;
-    std::map<std::string, long long> scriptModTimes_;
+    std::map<std::string, std::string> scriptFiles_;   // Normalized path to the name it ran by
+    std::vector<std::string> modifiedScripts_;         // Reloaded by the next ReloadModifiedScripts
+    FileWatcher* fileWatcher_;
+    uint32_t fileListener_;
+
+    Batch pending_;                            // Events triggered since the last Update
+    bool updateFunctionStale_;                 // Set when scripts run, as they may define update
+
+    std::thread pythonThread_;
+    std::mutex queueMutex_;
+    std::condition_variable queueReady_;
+    std::deque<Command> queue_;
+    bool stopThread_;
+
+    std::mutex logMutex_;
+    std::vector<std::pair<LogLevel, std::string>> logs_;
+
+    // Tasks, with the GIL held
+    uint64_t taskFrame_;
+    double taskTime_;                          // Seconds of Update time, what wait_seconds counts
+    std::atomic<float> taskBudgetMs_;
+
+    // Profiling, with the GIL held
+    std::atomic<bool> profiling_;
+    uint32_t profileDepth_;                    // Function scopes open
+    std::unordered_map<std::string, const char*> eventScopeNames_;
+
+#ifdef NEXUS_PYTHON_ENABLED
+    struct Task {
+        enum class Wait { Frame, Time, Event };
+
+        long long id;
+        PyObject* task;                        // Generator or coroutine, owned
+        Wait wait;
+        uint64_t wakeFrame;
+        double wakeTime;
+        std::string event;
+    };
+
+    std::deque<Task> tasks_;                   // Round-robin order; resumed from the front
+    PyObject* taskModule_;                     // nexus_tasks
+    PyObject* waitType_;                       // nexus_tasks.Wait
+
+    static int ProfileCallback(PyObject* self, PyFrameObject* frame, int what, PyObject* arg);
+
+    PyObject* profileCapsule_;                 // This engine, for the callback
+    std::unordered_map<PyObject*, const char*> profileNames_;   // By code object, referenced
+
+    PyThreadState* mainThreadState_;           // Saved while the GIL is released
+    PyObject* updateFunction_;
+#endif
 };
 
 } // namespace Nexus
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "InputManager.h"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Records what made a session's frames different from any other run, to replay them exactly.
+ *
+ * A recording is the random seed and timestep settings the session started with, then for every
+ * frame its delta time, the input events it applied and the script events triggered during it.
+ * Everything else the engine does follows from those, so a replay that feeds them back instead
+ * of the clock, the devices and live event sources runs the same frames and a hitch seen once
+ * can be profiled as often as needed. Real-time replays wait out each frame's recorded time;
+ * otherwise frames run back to back.
+ *
+ * The file is the Header, then one frame after another: the delta time as a float (the exact
+ * bits keep fixed-step accumulation identical), a varint event count and per event its type,
+ * controller, varint code and zigzag varint x and y, then a varint count of script events and
+ * each name as a varint length and its bytes. Input timestamps aren't kept; replayed events are
+ * stamped as they are injected.
+ */
+class SessionRecorder {
+public:
+    static constexpr uint32_t MAGIC = 0x52534E58;   // "XNSR"
+    static constexpr uint32_t VERSION = 1;
+
+    enum class Mode { Record, Replay, ReplayRealTime };
+
+    enum HeaderFlags : uint32_t {
+        SESSION_FIXED_TIMESTEP = 1 << 0,
+        SESSION_HEADLESS = 1 << 1
+    };
+
+    struct Header {
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        uint32_t randomSeed = 0;
+        uint32_t flags = 0;                     // HeaderFlags
+        float fixedDeltaTime = 1.0f / 60.0f;
+        int32_t maxStepsPerFrame = 5;
+    };
+
+    struct Frame {
+        float deltaTime = 0.0f;
+        std::vector<InputEvent> inputEvents;
+        std::vector<std::string> scriptEvents;
+    };
+
+    SessionRecorder(const std::string& filename, Mode mode);
+    ~SessionRecorder();
+
+    // Recording writes header; replaying loads the file and fills header with the recorded one
+    bool Open(Header& header);
+    // Flushes a recording; a replay just stops
+    void Close();
+
+    Mode GetMode() const { return mode_; }
+    bool IsRecording() const { return mode_ == Mode::Record; }
+    const std::string& GetFilename() const { return filename_; }
+    // Recorded or replayed so far
+    uint64_t GetFrameCount() const { return frameCount_; }
+
+    // Recording: script events as they're triggered, then the frame once it ran
+    void RecordScriptEvent(const std::string& name);
+    void RecordFrame(float deltaTime, const std::vector<InputEvent>& inputEvents);
+
+    // Replay: the next frame, false after the last one or at a truncated frame. In real time it
+    // first waits until the frame's recorded start
+    bool ReplayFrame(Frame& frame);
+
+private:
+    std::string filename_;
+    Mode mode_;
+    uint64_t frameCount_;
+
+    // Recording
+    std::ofstream file_;
+    std::vector<std::string> pendingScriptEvents_;
+    std::vector<uint8_t> encoded_;              // Frame scratch
+
+    // Replay
+    std::vector<uint8_t> data_;
+    size_t cursor_;
+    std::chrono::steady_clock::time_point replayStart_;
+    double replayedSeconds_;
+};
+
+} // namespace Nexus
@@ -1,17 +1,33 @@
 #pragma once
 
 #include "Platform.h"
+#include "ShaderCache.h"
+#include "Mesh.h"
 #include <string>
-#include <map>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace Nexus {
 
+class StateCache;
+class ConstantBufferRing;
+
 /**
  * HLSL Shader wrapper for DirectX 11
+ *
+ * Parameters live in the b0 constant buffer shared by both stages. Offsets come from shader
+ * reflection at load time; resolve a name once with FindParameter() and set by handle in hot
+ * paths, the name overloads do the lookup on every call.
+ *
+ * The input layout is built from the vertex shader's input signature against the mesh vertex
+ * format; vertex shaders compiled with COMPRESSED_VERTEX read CompressedVertex, all others Vertex.
  */
 class Shader {
 public:
+    using ParameterHandle = int;
+    static constexpr ParameterHandle INVALID_PARAMETER = -1;
+
     Shader();
     ~Shader();
 
@@ -21,13 +37,24 @@ public:
                      ID3D11Device* device);
     bool LoadFromSource(const std::string& vertexShaderSource,
                        const std::string& pixelShaderSource,
-                       ID3D11Device* device);
+                       ID3D11Device* device,
+                       const std::vector<ShaderCache::Define>& vertexDefines = {},
+                       const std::vector<ShaderCache::Define>& pixelDefines = {});
 
-    // Binding
+    // Binding; the first form uploads into the shader's own dynamic buffer, the second takes
+    // fresh constant memory from the ring and binds through the state cache
     void Bind(ID3D11DeviceContext* deviceContext);
+    void Bind(StateCache& stateCache, ConstantBufferRing& ring);
     void Unbind(ID3D11DeviceContext* deviceContext);
 
     // Parameter setting
+    ParameterHandle FindParameter(const std::string& name) const;
+    void SetMatrix(ParameterHandle parameter, const XMMATRIX& matrix);
+    void SetVector(ParameterHandle parameter, const XMFLOAT4& vector);
+    void SetFloat(ParameterHandle parameter, float value);
+    void SetInt(ParameterHandle parameter, int value);
+    void SetBool(ParameterHandle parameter, bool value);
+
     void SetMatrix(const std::string& name, const XMMATRIX& matrix);
     void SetVector(const std::string& name, const XMFLOAT4& vector);
     void SetFloat(const std::string& name, float value);
@@ -47,8 +74,11 @@ public:
     void SetLightPosition(const XMFLOAT3& position);
     void SetEyePosition(const XMFLOAT3& position);
 
-    // Normal mapping parameters
-    void SetNormalMapEnabled(bool enabled) { SetBool("normalMapEnabled", enabled); }
+    // Per-draw position decode for COMPRESSED_VERTEX variants, from Mesh::GetPositionOffset/Scale
+    void SetPositionDequantization(const XMFLOAT3& offset, const XMFLOAT3& scale);
+
+    // Normal mapping parameters; enabling normal/shadow maps is a NORMAL_MAP / SHADOW_MAP
+    // permutation, see ShaderPermutations
     void SetNormalMapStrength(float strength) { SetFloat("normalMapStrength", strength); }
 
     // Post-processing parameters
@@ -58,26 +88,39 @@ public:
     void SetHeatHazeSpeed(float speed) { SetFloat("heatHazeSpeed", speed); }
 
     // Shadow mapping parameters
-    void SetShadowMapEnabled(bool enabled) { SetBool("shadowMapEnabled", enabled); }
     void SetShadowMap(ID3D11ShaderResourceView* shadowMap) { SetTexture("shadowMap", shadowMap); }
     void SetLightViewProjectionMatrix(const XMMATRIX& lightVP) { SetMatrix("lightViewProjectionMatrix", lightVP); }
 
     bool IsValid() const { return vertexShader_ != nullptr && pixelShader_ != nullptr; }
+    VertexFormat GetVertexFormat() const { return vertexFormat_; }
 
 private:
-    bool CompileShader(const std::string& source, const std::string& target, ID3DBlob** shader);
+    struct Parameter {
+        std::string name;
+        UINT offset;
+        UINT size;
+        bool columnMajor;   // HLSL default packing, matrices are transposed on write
+    };
+
+    bool CompileShader(const std::string& source, const std::string& target, ID3DBlob** shader,
+                       const std::vector<ShaderCache::Define>& defines);
+    void ReflectConstants(ID3DBlob* shaderBlob);
+    HRESULT CreateInputLayout(ID3D11Device* device, ID3DBlob* vertexShaderBlob);
     void CreateConstantBuffers(ID3D11Device* device);
-    void UpdateConstantBuffer(ID3D11DeviceContext* deviceContext, const std::string& name, const void* data, size_t size);
+    void WriteParameter(ParameterHandle parameter, const void* data, size_t size);
 
     ID3D11VertexShader* vertexShader_;
     ID3D11PixelShader* pixelShader_;
     ID3D11InputLayout* inputLayout_;
+    VertexFormat vertexFormat_;
     ID3D11Buffer* constantBuffer_;
     
     ID3D11Device* device_;
-    std::map<std::string, size_t> constantBufferOffsets_;
+    std::vector<Parameter> parameters_;
+    std::unordered_map<std::string, ParameterHandle> parameterLookup_;
     std::unique_ptr<char[]> constantBufferData_;
     size_t constantBufferSize_;
+    bool constantsDirty_;
 };
 
 } // namespace Nexus
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * Process-wide HLSL bytecode cache in front of D3DCompile.
+ *
+ * Entries are keyed by a hash of the source text, entry point, target profile, defines and
+ * compile flags, so an edited shader simply misses and recompiles. Hits are served from memory
+ * first, then from <directory>/<key>.cso; misses compile and write the file back. The
+ * NexusShaderCompiler build step fills the same directory ahead of time, including every
+ * ShaderPermutations variant, which leaves runtime compilation for shaders that changed after the
+ * build.
+ */
+class ShaderCache {
+public:
+    struct Define {
+        std::string name;
+        std::string value;
+    };
+
+    struct Stats {
+        uint32_t memoryHits = 0;
+        uint32_t diskHits = 0;
+        uint32_t compiles = 0;
+        double compileMs = 0.0;
+    };
+
+    static constexpr const char* DEFAULT_DIRECTORY = "shadercache";
+
+    // Relative directories resolve against the executable's directory; empty keeps the
+    // in-memory cache only
+    static void Initialize(const std::string& directory = DEFAULT_DIRECTORY);
+    static void Shutdown();
+
+    // Drop-in for D3DCompile; the caller owns the returned blob. errors receives the compiler
+    // output on failure.
+    static HRESULT Compile(const std::string& source, const char* sourceName, const char* entryPoint,
+                           const char* target, UINT flags, ID3DBlob** bytecode, std::string* errors = nullptr,
+                           const std::vector<Define>& defines = {});
+
+    static uint64_t ComputeKey(const std::string& source, const char* entryPoint, const char* target,
+                               UINT flags, const std::vector<Define>& defines);
+
+    static const std::string& GetDirectory() { return directory_; }
+    static Stats GetStats();
+
+private:
+    static std::string GetEntryPath(uint64_t key);
+    static bool ReadEntry(uint64_t key, ID3DBlob** bytecode);
+    static void WriteEntry(uint64_t key, ID3DBlob* bytecode);
+
+    static std::mutex mutex_;
+    static std::string directory_;
+    static std::unordered_map<uint64_t, ID3DBlob*> memory_;
+    static Stats stats_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Platform.h"
+#include "ShaderCache.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+class Shader;
+
+/**
+ * Compile-time feature variants of one vertex/pixel shader pair.
+ *
+ * Each stage declares its feature keywords on a comment line in its source:
+ *
+ *     // keywords: NORMAL_MAP SHADOW_MAP
+ *
+ * A variant is a bitmask over the union of both stages' keywords. Each enabled keyword is
+ * compiled in as `#define KEYWORD 1`, so disabled features are stripped out of the bytecode
+ * instead of being skipped by a dynamic branch. Resolve masks once with GetKeywordMask(); Select()
+ * is an array lookup that compiles the variant through the ShaderCache the first time it is seen.
+ * Prepare() and Select() may be called from any thread once loading has finished, which is how
+ * ShaderWarmup builds variants on job workers ahead of their first draw.
+ */
+class ShaderPermutations {
+public:
+    using KeywordMask = uint32_t;
+    static constexpr size_t MAX_KEYWORDS = 16;
+
+    ShaderPermutations();
+    ~ShaderPermutations();
+
+    ShaderPermutations(const ShaderPermutations&) = delete;
+    ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+    bool LoadFromFile(const std::string& vertexShaderFile, const std::string& pixelShaderFile, ID3D11Device* device);
+    bool LoadFromSource(const std::string& vertexShaderSource, const std::string& pixelShaderSource,
+                        ID3D11Device* device);
+
+    // 0 for keywords neither stage declares, so unknown features simply select the base variant
+    KeywordMask GetKeywordMask(const std::string& keyword) const;
+    KeywordMask GetKeywordMask(const std::vector<std::string>& keywords) const;
+
+    // Null when the variant failed to compile; failures are not retried
+    Shader* Select(KeywordMask mask);
+    // Builds the variant without returning it; false when it failed to compile
+    bool Prepare(KeywordMask mask);
+    bool IsCompiled(KeywordMask mask) const;
+
+    const std::vector<std::string>& GetKeywords() const { return keywords_; }
+    size_t GetVariantCount() const { return variantCount_; }
+
+    // Shared with NexusShaderCompiler so offline and runtime builds produce the same cache keys.
+    // stageMask bits index into the keywords declared by that stage's source.
+    static std::vector<std::string> ParseKeywords(const std::string& source);
+    static std::vector<ShaderCache::Define> BuildDefines(const std::vector<std::string>& stageKeywords,
+                                                         KeywordMask stageMask);
+
+private:
+    struct Stage {
+        std::string source;
+        std::vector<std::string> keywords;
+        std::vector<KeywordMask> bits;   // Variant mask bit of each stage keyword
+    };
+
+    bool AddStageKeywords(Stage& stage);
+    void ReleaseVariants();
+    static KeywordMask ToStageMask(const Stage& stage, KeywordMask mask);
+
+    ID3D11Device* device_;
+    Stage vertex_;
+    Stage pixel_;
+    std::vector<std::string> keywords_;
+    KeywordMask validMask_;
+
+    // Owned; published with a compare-exchange so concurrent builds of one variant keep the first
+    std::unique_ptr<std::atomic<Shader*>[]> variants_;
+    std::unique_ptr<std::atomic<bool>[]> failed_;
+    size_t variantCount_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ShaderPermutations.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Nexus {
+
+class ResourceManager;
+
+/**
+ * Builds the shader variants a level needs before they are first drawn.
+ *
+ * Start() walks the materials registered with the ResourceManager, collects each distinct
+ * shader/keyword variant not compiled yet and builds them on job workers. D3D11 object creation
+ * is free-threaded, so the shaders, input layouts and constant buffers are all created off the
+ * main thread. Loading screens poll GetProgress() or block in Wait(); a variant drawn before
+ * its job ran is simply built on the spot by ShaderPermutations::Select().
+ */
+class ShaderWarmup {
+public:
+    struct Progress {
+        size_t total = 0;
+        size_t completed = 0;   // Includes failed variants
+        size_t failed = 0;
+
+        float GetFraction() const { return total > 0 ? static_cast<float>(completed) / total : 1.0f; }
+    };
+
+    ShaderWarmup();
+    ~ShaderWarmup();
+
+    ShaderWarmup(const ShaderWarmup&) = delete;
+    ShaderWarmup& operator=(const ShaderWarmup&) = delete;
+
+    // Returns the number of variants queued. Without a job system they build synchronously.
+    // A warm-up still in flight is finished first
+    size_t Start(const ResourceManager& resources, JobSystem* jobs);
+    void Wait();
+
+    bool IsDone() const { return counter_.IsDone(); }
+    Progress GetProgress() const;
+
+private:
+    struct Variant {
+        std::shared_ptr<ShaderPermutations> shader;   // Held so unloading mid-warm-up is safe
+        ShaderPermutations::KeywordMask mask;
+    };
+
+    void Build(const Variant& variant);
+
+    JobSystem* jobs_;
+    JobCounter counter_;
+    std::vector<Variant> variants_;
+    std::atomic<size_t> completed_;
+    std::atomic<size_t> failed_;
+};
+
+} // namespace Nexus
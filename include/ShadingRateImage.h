@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Platform.h"
+
+struct ID3D12Device;
+
+namespace Nexus {
+
+/**
+ * Screen-space shading-rate image for variable rate shading.
+ *
+ * Build() looks at a finished frame in 16x16 pixel tiles: the mean squared luminance step to the
+ * next pixel along each axis estimates how much error shading that axis at half or quarter rate
+ * would add, relative to the tile's brightness, and motion (which blurs the result anyway) scales
+ * the estimate down. Each tile gets the coarsest rate that stays under the threshold, so flat
+ * sky, fog and dark or fast-moving regions go coarse while edges and texture detail stay at full
+ * rate. The next frame's passes read it.
+ *
+ * Rates are stored in the D3D12 tier 2 encoding (D3D12_SHADING_RATE: log2 width << 2 | log2
+ * height, only 1x1 to 4x4 with at most a 2:1 aspect), one R8_UINT texel per tile, so the image can
+ * feed RSSetShadingRateImage where QueryHardwareSupport() finds tier 2. Direct3D 11 has no
+ * hardware rate control; its compute passes read the image and light one pixel per block
+ * themselves (DeferredRenderer), with Settings::maxRate as the quality knob.
+ */
+class ShadingRateImage {
+public:
+    static constexpr UINT TILE_SIZE = 16;
+
+    enum Rate : UINT {
+        RATE_1X1 = 0x0,
+        RATE_1X2 = 0x1,
+        RATE_2X1 = 0x4,
+        RATE_2X2 = 0x5,
+        RATE_2X4 = 0x6,
+        RATE_4X2 = 0x9,
+        RATE_4X4 = 0xa
+    };
+
+    struct Settings {
+        float threshold = 0.04f;        // Tolerated luminance error relative to the tile's mean
+        float motionScale = 0.25f;      // How strongly motion in pixels per frame hides error
+        UINT maxRate = 2;               // Coarsest pixels per axis: 1 (off), 2 or 4
+    };
+
+    ShadingRateImage();
+    ~ShadingRateImage();
+
+    ShadingRateImage(const ShadingRateImage&) = delete;
+    ShadingRateImage& operator=(const ShadingRateImage&) = delete;
+
+    // width and height are the size of the frames Build() reads, in pixels
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height,
+                    const Settings& settings);
+    void Shutdown();
+
+    void SetSettings(const Settings& settings);
+    const Settings& GetSettings() const { return settings_; }
+
+    // color is a finished frame (gamma encoded); velocity is optional RG screen motion in uv per
+    // frame, as in TemporalAA's velocity target. Neither may be bound as a target
+    void Build(ID3D11ShaderResourceView* color, ID3D11ShaderResourceView* velocity);
+    // Until the next Build(), e.g. after a camera cut, so stale rates are not applied
+    void Invalidate() { valid_ = false; }
+
+    // Null until the first Build() and after Invalidate()
+    ID3D11ShaderResourceView* GetRateView() const { return valid_ ? rateView_ : nullptr; }
+    ID3D11Texture2D* GetRateTexture() const { return rateTexture_; }
+    UINT GetTilesX() const { return tilesX_; }
+    UINT GetTilesY() const { return tilesY_; }
+
+    // Tier 2 variable rate shading on a D3D12 device, and the image tile size it expects
+    static bool QueryHardwareSupport(ID3D12Device* device, UINT& tileSize);
+
+private:
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    Settings settings_;
+    UINT width_;
+    UINT height_;
+    UINT tilesX_;
+    UINT tilesY_;
+
+    ID3D11Texture2D* rateTexture_;
+    ID3D11UnorderedAccessView* rateTarget_;
+    ID3D11ShaderResourceView* rateView_;
+    ID3D11ComputeShader* buildShader_;
+    ID3D11Buffer* constants_;
+    bool valid_;
+};
+
+} // namespace Nexus
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "Platform.h"
+#include "SceneBVH.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+class Light;
+class Mesh;
+class StateCache;
+
+/**
+ * One depth atlas shared by the shadows of every point and spot light.
+ *
+ * Tiles are square power-of-two regions handed out by a quadtree, so freeing a tile merges it
+ * back with its free siblings and the atlas does not fragment the way separate textures do.
+ * Each frame a light's tile size follows its screen-space importance (the projected size of its
+ * range sphere). All tiles render into the one depth target with only the viewport changing in
+ * between. At most maxTileUpdatesPerFrame tiles are redrawn, highest priority first; lights
+ * outside that budget keep last frame's tiles and matrices.
+ */
+class ShadowAtlas {
+public:
+    static constexpr UINT MAX_SHADOWED_LIGHTS = 256;
+    static constexpr UINT TILES_PER_LIGHT = 6;       // Point lights use one tile per cube face
+
+    struct Settings {
+        UINT resolution = 8192;
+        UINT maxTileSize = 2048;
+        UINT minTileSize = 128;
+        UINT maxTileUpdatesPerFrame = 12;  // A point light costs six
+        float fullCoverage = 1.0f;         // Screen heights a light's sphere spans to earn maxTileSize
+        float nearPlane = 0.05f;
+        int depthBias = 200;
+        float slopeScaledDepthBias = 2.0f;
+    };
+
+    struct Caster {
+        Mesh* mesh = nullptr;
+        DirectX::XMFLOAT4X4 world;
+        AABB bounds;                       // World space
+        bool dynamic = false;              // Redraws every light it overlaps, budget permitting
+    };
+
+    // Matches the structured buffer GetTileBuffer() exposes. Atlas uv of a point is
+    // clip.xy / clip.w * scaleOffset.xy + scaleOffset.zw with clip = world * viewProjection
+    struct Tile {
+        DirectX::XMFLOAT4X4 viewProjection;  // Transposed for HLSL
+        DirectX::XMFLOAT4 scaleOffset;
+    };
+
+    struct Stats {
+        uint32_t lightsShadowed = 0;       // Lights holding tiles after the update
+        uint32_t lightsUpdated = 0;
+        uint32_t lightsDeferred = 0;       // Wanted an update but kept last frame's tiles
+        uint32_t tilesRendered = 0;
+        uint32_t evictions = 0;            // Tiles taken from less important lights
+        uint32_t castersDrawn = 0;
+    };
+
+    // Buddy-style quadtree over a square of size texels, leaves of minSize texels
+    class QuadtreeAllocator {
+    public:
+        static constexpr uint32_t INVALID = UINT32_MAX;
+
+        struct Rect {
+            UINT x = 0;
+            UINT y = 0;
+            UINT size = 0;
+        };
+
+        void Reset(UINT size, UINT minSize);
+        // Node handle, or INVALID when no free square of that size is left. Prefers nodes that
+        // are already split so large squares stay whole
+        uint32_t Allocate(UINT size);
+        void Free(uint32_t node);
+        Rect GetRect(uint32_t node) const;
+        UINT GetFreeTexels() const { return freeTexels_; }
+
+    private:
+        enum class State : uint8_t { Free, Split, Used };
+
+        struct Node {
+            Rect rect;
+            uint32_t parent = INVALID;
+            uint32_t firstChild = INVALID;
+            State state = State::Free;
+        };
+
+        uint32_t Find(uint32_t node, UINT size, bool splitFree);
+
+        std::vector<Node> nodes_;
+        UINT minSize_ = 0;
+        UINT freeTexels_ = 0;
+    };
+
+    ShadowAtlas();
+    ~ShadowAtlas();
+
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                    const Settings& settings);
+    void Shutdown();
+    const Settings& GetSettings() const { return settings_; }
+
+    // Casters for every light, set them each frame. Static casters are only redrawn when a light
+    // moves, gets a new tile, or InvalidateStatic covers it
+    void SetCasters(const std::vector<Caster>& casters) { casters_ = casters; }
+    void InvalidateStatic();
+    void InvalidateStatic(const AABB& bounds);
+
+    // Point and spot lights with CastsShadows() compete for the atlas by Light::GetId(); others
+    // are ignored. view and projection are the row-vector camera matrices of a perspective
+    // projection. Leaves the atlas bound as depth target, so restore the main target after
+    void Update(const std::vector<const Light*>& lights, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+
+    ID3D11ShaderResourceView* GetShadowMap() const { return atlasView_; }
+    // StructuredBuffer<Tile>, TILES_PER_LIGHT entries per shadowed light
+    ID3D11ShaderResourceView* GetTileBuffer() const { return tileView_; }
+    // Index of the light's first tile in GetTileBuffer(), or -1 when it has no shadow this frame.
+    // Point lights own six consecutive tiles in +X, -X, +Y, -Y, +Z, -Z order
+    int GetFirstTile(int lightId) const;
+    const Tile& GetTile(UINT index) const { return tiles_[index]; }
+    const Stats& GetStats() const { return stats_; }
+
+    // Power-of-two tile size for a light whose range sphere spans screenFraction of the screen height
+    static UINT ComputeTileSize(float screenFraction, const Settings& settings);
+
+private:
+    struct Entry {
+        UINT slot = 0;                       // Index into the tile buffer, in units of TILES_PER_LIGHT
+        UINT faceCount = 0;
+        UINT tileSize = 0;                   // 0 while the light holds no tiles
+        uint32_t nodes[TILES_PER_LIGHT] = {};
+        DirectX::XMFLOAT3 position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+        DirectX::XMFLOAT3 direction = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+        float range = 0.0f;
+        float coneAngle = 0.0f;
+        float importance = 0.0f;
+        uint64_t lastRendered = 0;
+        uint64_t lastSeen = 0;
+        bool dirty = true;                   // Casters changed since the tiles were drawn
+    };
+
+    struct Candidate {
+        int lightId = 0;
+        const Light* light = nullptr;
+        UINT wantedSize = 0;
+        float priority = 0.0f;
+    };
+
+    bool CreateResources();
+    bool CreateShaders();
+    void ReleaseTiles(Entry& entry);
+    // Takes tiles from lights less important than entry before settling for smaller tiles
+    bool AllocateTiles(Entry& entry, UINT faceCount, UINT size);
+    bool TryAllocate(Entry& entry, UINT faceCount, UINT size);
+    void RenderLight(Entry& entry, const Light& light);
+    DirectX::XMMATRIX BuildFaceViewProjection(const Light& light, UINT face) const;
+    void UploadTiles();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    StateCache* stateCache_;
+    Settings settings_;
+
+    ID3D11Texture2D* atlasTexture_;
+    ID3D11ShaderResourceView* atlasView_;
+    ID3D11DepthStencilView* atlasTarget_;
+    ID3D11Buffer* tileBuffer_;
+    ID3D11ShaderResourceView* tileView_;
+
+    ID3D11VertexShader* casterShaders_[2];       // Indexed by VertexFormat
+    ID3D11InputLayout* casterLayouts_[2];
+    ID3D11VertexShader* clearShader_;
+    ID3D11Buffer* casterConstants_;
+    ID3D11RasterizerState* casterState_;
+    ID3D11DepthStencilState* depthState_;
+    ID3D11DepthStencilState* overwriteState_;    // Always passes, used to clear single tiles
+
+    QuadtreeAllocator allocator_;
+    std::unordered_map<int, Entry> entries_;
+    std::vector<UINT> freeSlots_;
+    std::vector<Tile> tiles_;
+    std::vector<Candidate> candidates_;
+    std::vector<Caster> casters_;
+    uint64_t frame_;
+    bool tilesChanged_;
+
+    Stats stats_;
+};
+
+} // namespace Nexus
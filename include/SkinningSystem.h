@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Platform.h"
+#include "AnimationSystem.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+class Mesh;
+
+/**
+ * Compute pre-skinning for Skinned meshes.
+ *
+ * AddInstance() appends a skeleton's matrix palette to the frame's palette buffer and reserves
+ * room for the mesh's posed vertices in a shared output buffer. Dispatch() uploads every palette
+ * in one write and runs one pass per instance that blends up to four bones per vertex, writing
+ * position, normal, tangent and UV in the Vertex layout. The output is also a vertex buffer, so
+ * the shadow, depth and main passes all draw the same posed vertices with Mesh::RenderSkinned
+ * and the Full input layout instead of each skinning again.
+ *
+ * Instances of one mesh added back to back land next to each other, so a crowd can be drawn
+ * instanced too, fetching vertex baseVertex + SV_InstanceID * vertexCount + SV_VertexID from
+ * GetOutputView().
+ *
+ * Blend shapes are uploaded once per FacialAnimation with CreateMorphTargets(), keeping only the
+ * vertices each shape moves. An instance added with its morph targets gets one small pass per
+ * shape with a non-zero weight that accumulates weighted deltas for its vertices, and skinning
+ * adds the sum to the bind pose before blending bones. Shapes at zero weight are never visited.
+ *
+ * For motion vectors SetKeepPreviousFrame() keeps last frame's posed vertices in a second output
+ * buffer, swapped in BeginFrame(). TrackMotion() finds where an instance was posed there, so a
+ * pass can read both poses of each vertex and write how far it moved.
+ */
+class SkinningSystem {
+public:
+    struct Stats {
+        uint32_t instances = 0;   // Skinned this frame
+        uint32_t vertices = 0;
+        uint32_t bones = 0;
+        uint32_t morphShapes = 0; // Blend shapes applied
+    };
+
+    // Blend shape deltas on the GPU, built by CreateMorphTargets()
+    struct MorphTargets;
+
+    static constexpr UINT INITIAL_VERTEX_CAPACITY = 1u << 18;
+    static constexpr UINT INITIAL_BONE_CAPACITY = 1u << 14;
+
+    SkinningSystem();
+    ~SkinningSystem();
+
+    SkinningSystem(const SkinningSystem&) = delete;
+    SkinningSystem& operator=(const SkinningSystem&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+    void Shutdown();
+
+    void BeginFrame();
+
+    // palette is AnimationSystem::Skeleton::GetSkinningMatrices(): row-vector matrices from the
+    // bind pose to model space, indexed by the vertices' bone indices. baseVertex receives where
+    // the posed vertices start in GetOutputBuffer(). False when the mesh is not Skinned or the
+    // frame was already dispatched
+    bool AddInstance(const Mesh& mesh, const std::vector<DirectX::XMFLOAT4X4>& palette, UINT& baseVertex);
+    // Also applies the blend shapes of facial at their current weights. morphs must come from the
+    // same FacialAnimation and stay alive until Dispatch(); pass the plain overload instead when
+    // the character's animation LOD turns facial animation off
+    bool AddInstance(const Mesh& mesh, const std::vector<DirectX::XMFLOAT4X4>& palette,
+                     const MorphTargets& morphs, const AnimationSystem::FacialAnimation& facial, UINT& baseVertex);
+
+    // Null when the shapes move nothing or the buffer cannot be created
+    std::shared_ptr<MorphTargets> CreateMorphTargets(const AnimationSystem::FacialAnimation& facial);
+
+    // Skins every instance added since BeginFrame(); call once, before the first pass draws them
+    void Dispatch();
+
+    ID3D11Buffer* GetOutputBuffer() const { return outputBuffer_; }
+    ID3D11ShaderResourceView* GetOutputView() const { return outputView_; }
+    const Stats& GetStats() const { return stats_; }
+
+    // Costs a second output buffer; off releases it
+    void SetKeepPreviousFrame(bool keep);
+    // Records key, anything stable across frames such as the entity, for the instance posed at
+    // baseVertex this frame and returns where the same key was posed in the previous output.
+    // False on its first frame or without SetKeepPreviousFrame(); draw it without motion then
+    bool TrackMotion(uint64_t key, UINT baseVertex, UINT& previousBaseVertex);
+    ID3D11Buffer* GetPreviousOutputBuffer() const { return previousBuffer_; }
+    ID3D11ShaderResourceView* GetPreviousOutputView() const { return previousView_; }
+
+private:
+    struct Instance {
+        ID3D11ShaderResourceView* vertices;
+        UINT vertexCount;
+        UINT firstBone;
+        UINT boneCount;
+        UINT baseVertex;
+        UINT morphBase;
+        UINT useMorph;
+    };
+
+    struct MorphPass {
+        ID3D11ShaderResourceView* deltas;
+        UINT firstDelta;
+        UINT deltaCount;
+        float weight;
+        UINT morphBase;
+    };
+
+    // Only between BeginFrame() and Dispatch(), while nothing has drawn from the old buffers
+    bool EnsureOutputCapacity(UINT vertexCount);
+    bool EnsurePaletteCapacity(UINT boneCount);
+    bool EnsureMorphCapacity(UINT vertexCount);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+
+    ID3D11ComputeShader* skinShader_;
+    ID3D11Buffer* skinConstants_;
+    ID3D11ComputeShader* morphShader_;
+    ID3D11Buffer* morphConstants_;
+
+    // Every palette this frame as three float4 rows per bone, the transposed affine part
+    std::vector<DirectX::XMFLOAT4> paletteRows_;
+    ID3D11Buffer* paletteBuffer_;
+    ID3D11ShaderResourceView* paletteView_;
+    UINT paletteCapacity_;
+
+    // Posed vertices of every instance this frame
+    ID3D11Buffer* outputBuffer_;
+    ID3D11UnorderedAccessView* outputTarget_;
+    ID3D11ShaderResourceView* outputView_;
+    UINT outputCapacity_;
+    UINT verticesThisFrame_;
+
+    // Last frame's output and where each tracked key was in it
+    ID3D11Buffer* previousBuffer_;
+    ID3D11UnorderedAccessView* previousTarget_;
+    ID3D11ShaderResourceView* previousView_;
+    UINT previousCapacity_;
+    bool keepPreviousFrame_;
+    std::unordered_map<uint64_t, UINT> motionKeys_;
+    std::unordered_map<uint64_t, UINT> previousMotionKeys_;
+
+    // Summed blend shape deltas of every morphed instance this frame
+    ID3D11Buffer* morphBuffer_;
+    ID3D11UnorderedAccessView* morphTarget_;
+    ID3D11ShaderResourceView* morphView_;
+    UINT morphCapacity_;
+    UINT morphVerticesThisFrame_;
+
+    std::vector<Instance> instances_;
+    std::vector<MorphPass> morphPasses_;
+    bool dispatched_;
+    Stats stats_;
+};
+
+} // namespace Nexus
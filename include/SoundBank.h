@@ -0,0 +1,87 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Nexus {
+
+using SoundClipID = uint32_t;
+
+// FNV-1a of a clip's name, ignoring ASCII case and with '\' read as '/', so IDs can be computed
+// at compile time from the same names the bank was built with
+constexpr SoundClipID HashSoundName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        if (c == '\\') c = '/';
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+enum class SoundBankEncoding : uint8_t {
+    PCM,                                       // Integer samples, interleaved
+    Float,                                     // 32-bit float samples, interleaved
+    ADPCM,                                     // A whole IMA ADPCM WAV file, decoded as it plays
+    Vorbis                                     // A whole Ogg Vorbis file, decoded as it plays
+};
+
+// One entry of a bank's index, as stored in the file
+struct SoundBankClip {
+    SoundClipID id;
+    uint32_t nameOffset;                       // Into the name table, null terminated
+    uint64_t offset;                           // From the start of the file, a multiple of ALIGNMENT
+    uint64_t size;
+    uint32_t sampleRate;
+    uint32_t frameCount;
+    uint16_t channels;
+    uint16_t bitsPerSample;                    // Of PCM and Float; 0 for the rest
+    SoundBankEncoding encoding;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(SoundBankClip) == 40, "SoundBankClip is stored as is");
+
+/**
+ * Many clips in one file, read through a memory mapping.
+ *
+ * The file is a header, an index of SoundBankClip sorted by ID, a table of clip names and then
+ * each clip's data at an aligned offset. Open() maps the file and checks the index; nothing is
+ * read or copied, so a level's audio costs one open and one mapping however many clips it has,
+ * and pages are faulted in as clips play. Clips are found by ID with a binary search of the
+ * index. PCM and float clips are stored as bare samples the renderer mixes straight from the
+ * mapping; ADPCM and Vorbis clips are stored as their whole files for the streamer to decode.
+ */
+class SoundBank {
+public:
+    static constexpr uint32_t ALIGNMENT = 64;
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const { return file_.IsOpen(); }
+    const std::string& GetFilename() const { return filename_; }
+    uint32_t GetClipCount() const { return clipCount_; }
+    const SoundBankClip& GetClip(uint32_t index) const { return clips_[index]; }
+    // Null if the bank has no clip with this ID
+    const SoundBankClip* Find(SoundClipID id) const;
+    const uint8_t* GetData(const SoundBankClip& clip) const { return file_.GetData() + clip.offset; }
+    const char* GetName(const SoundBankClip& clip) const { return names_ + clip.nameOffset; }
+
+    // Builds a bank from WAV (PCM, float or IMA ADPCM) and Ogg Vorbis files. Each clip is named
+    // by its path relative to root without the extension, "sfx/door_open" for example. Fails on
+    // a file it can't read or two names with the same ID
+    static bool Write(const std::string& filename, const std::vector<std::string>& inputFiles,
+                      const std::string& root);
+
+private:
+    MappedFile file_;
+    std::string filename_;
+    const SoundBankClip* clips_ = nullptr;
+    uint32_t clipCount_ = 0;
+    const char* names_ = nullptr;
+};
+
+} // namespace Nexus
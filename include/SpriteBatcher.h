@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Platform.h"
+#include "TextRenderer.h"
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class StateCache;
+
+/**
+ * Batched 2D sprites, lines and text.
+ *
+ * Draw calls only append a 40-byte instance and a sort key. Flush() sorts the frame's instances
+ * by layer and then texture page with a radix sort, writes them in that order into one dynamic
+ * instance buffer and issues one instanced draw of a four-vertex strip per run of the same layer
+ * and page. Textures are shelf-packed into shared atlas pages when they are added, so sprites
+ * from many images still make one draw; textures in other formats or too large for a page get a
+ * page of their own. Lines are rotated quads of a white texel on the first page and text is
+ * glyph quads on the TextRenderer's distance field font, which is a page too, so all three
+ * interleave by layer in the same batch.
+ */
+class SpriteBatcher {
+public:
+    // Same layout as NexusSprite in the C API
+    struct Sprite {
+        DirectX::XMFLOAT2 position;   // Center, pixels from the target's top-left corner
+        DirectX::XMFLOAT2 size;       // Pixels; zero takes the texture's size
+        float rotation;               // Radians, clockwise on screen
+        int32_t texture;              // From AddTexture, 0 for a solid color
+        int32_t layer;                // Higher draws on top
+        DirectX::XMFLOAT4 color;      // Multiplies the texture
+    };
+
+    struct Stats {
+        unsigned int sprites = 0;
+        unsigned int drawCalls = 0;
+        unsigned int pages = 0;
+    };
+
+    static constexpr UINT PAGE_SIZE = 2048;   // Texels along each side of an atlas page
+
+    SpriteBatcher();
+    ~SpriteBatcher();
+
+    SpriteBatcher(const SpriteBatcher&) = delete;
+    SpriteBatcher& operator=(const SpriteBatcher&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache);
+    void Shutdown();
+
+    // Packs mip 0 of texture into an atlas page, or references it as a page of its own, and
+    // returns its id for Sprite::texture; 0 on failure. The caller keeps its reference
+    int AddTexture(ID3D11Texture2D* texture);
+    // Pixel size of a texture id, 1 x 1 for 0 and unknown ids
+    DirectX::XMFLOAT2 GetTextureSize(int texture) const;
+    // Text is dropped until a font is set; keeps its own reference to the font's atlas
+    void SetFont(const TextRenderer* font);
+
+    void Draw(const Sprite& sprite);
+    void Draw(const Sprite* sprites, size_t count);
+    void DrawLine(const DirectX::XMFLOAT2& from, const DirectX::XMFLOAT2& to, float thickness,
+                  const DirectX::XMFLOAT4& color, int layer = 0);
+    // TextRenderer's layout: top-left corner at (x, y), 16 pixel lines at scale 1
+    void DrawString(const char* text, float x, float y, float scale, const DirectX::XMFLOAT4& color, int layer = 0);
+
+    // Draws everything queued over the render target bound on the context, which is width x
+    // height pixels, and empties the queue
+    void Flush(UINT width, UINT height);
+    size_t GetQueuedSprites() const { return instances_.size(); }
+    // Of the last flush
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    struct Shelf {
+        UINT y;
+        UINT height;
+        UINT used;        // Texels taken from the left
+    };
+
+    struct Page {
+        ID3D11Texture2D* texture;        // Null for the font, which is not ours
+        ID3D11ShaderResourceView* view;
+        bool atlas;                      // Takes more textures
+        bool distanceField;
+        std::vector<Shelf> shelves;
+        UINT top;                        // First row below the shelves
+    };
+
+    struct Region {
+        uint16_t page;
+        DirectX::XMFLOAT4 texRect;       // u0, v0, u1, v1
+        DirectX::XMFLOAT2 size;          // Pixels
+    };
+
+    // Per-instance vertex data
+    struct Instance {
+        DirectX::XMFLOAT2 center;
+        DirectX::XMFLOAT2 halfSize;
+        DirectX::XMFLOAT4 texRect;
+        float rotation;
+        uint32_t color;                  // RGBA8
+    };
+
+    bool CreatePipeline();
+    bool AddAtlasPage();
+    bool Pack(Page& page, UINT width, UINT height, UINT& x, UINT& y);
+    bool EnsureCapacity(size_t instances);
+    void Append(const Instance& instance, uint16_t page, int layer);
+    // Orders order_ by keys_, stably
+    void SortInstances();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    StateCache* stateCache_;
+
+    ID3D11VertexShader* vertexShader_;
+    ID3D11PixelShader* spriteShader_;
+    ID3D11PixelShader* distanceFieldShader_;
+    ID3D11InputLayout* inputLayout_;
+    ID3D11Buffer* constants_;
+    ID3D11SamplerState* linearClamp_;
+    ID3D11BlendState* blendState_;
+    ID3D11RasterizerState* rasterizerState_;
+    ID3D11DepthStencilState* depthState_;
+
+    std::vector<Page> pages_;
+    std::vector<Region> regions_;        // By texture id; 0 is the white texel
+    int fontPage_;                       // -1 without a font
+    std::vector<TextRenderer::GlyphQuad> glyphs_;   // Layout scratch
+
+    // The frame's queue: instances in submission order, their layer and page keys, and the
+    // order Flush() draws them in
+    std::vector<Instance> instances_;
+    std::vector<uint32_t> keys_;
+    std::vector<uint32_t> order_;
+    std::vector<uint32_t> sortScratch_;
+    ID3D11Buffer* instanceBuffer_;
+    size_t capacity_;                    // Instances
+    Stats stats_;
+    bool initialized_;
+};
+
+} // namespace Nexus
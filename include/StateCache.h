@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+
+namespace Nexus {
+
+/**
+ * Shadow copy of the D3D11 pipeline bindings that drops redundant state calls.
+ *
+ * Every binding made through the cache is compared against what the cache last set; calls
+ * that would not change anything are filtered, and range calls are trimmed to the slots that
+ * actually differ. Anything that changes bindings behind the cache's back (ClearState,
+ * another component using the raw context, binding the same context elsewhere) must be
+ * followed by Invalidate().
+ *
+ * A pixel override replaces every pixel shader and blend state bound through the cache, which
+ * is how debug views such as OverdrawVisualizer restyle draws without their renderers knowing.
+ */
+class StateCache {
+public:
+    struct Stats {
+        uint64_t issued = 0;
+        uint64_t filtered = 0;
+    };
+
+    static constexpr UINT MAX_VERTEX_BUFFERS = 16;
+    static constexpr UINT MAX_CONSTANT_BUFFERS = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+    static constexpr UINT MAX_SHADER_RESOURCES = 16;
+    static constexpr UINT MAX_SAMPLERS = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+    static constexpr UINT MAX_RENDER_TARGETS = D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT;
+    static constexpr UINT MAX_VIEWPORTS = 4;
+
+    StateCache();
+
+    void Initialize(ID3D11DeviceContext* context);
+    void Shutdown();
+
+    // Forget everything tracked, the next call of each kind always reaches the context
+    void Invalidate();
+
+    ID3D11DeviceContext* GetContext() const { return context_; }
+
+    // While shader is set it is bound in place of every non-null pixel shader, and blend (when
+    // set) in place of every blend state; both take effect at once. Invalidate() keeps them
+    void SetPixelOverride(ID3D11PixelShader* shader, ID3D11BlendState* blend);
+    ID3D11PixelShader* GetPixelOverrideShader() const { return overrideShader_; }
+    ID3D11BlendState* GetPixelOverrideBlend() const { return overrideBlend_; }
+
+    // Input assembler
+    void IASetInputLayout(ID3D11InputLayout* layout);
+    void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+    void IASetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets);
+    void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset);
+
+    // Shaders
+    void VSSetShader(ID3D11VertexShader* shader);
+    void PSSetShader(ID3D11PixelShader* shader);
+    void VSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers);
+    void PSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers);
+    // 11.1 ranged binding (constants in units of 16 bytes, numConstants 0 = whole buffer); plain
+    // binding is used when the context has no 11.1 interface
+    void VSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+                               const UINT* firstConstants, const UINT* numConstants);
+    void PSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+                               const UINT* firstConstants, const UINT* numConstants);
+    void VSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views);
+    void PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views);
+    void PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers);
+
+    // Rasterizer and output merger
+    void RSSetState(ID3D11RasterizerState* state);
+    void RSSetViewports(UINT count, const D3D11_VIEWPORT* viewports);
+    void OMSetRenderTargets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthView);
+    void OMSetBlendState(ID3D11BlendState* state, const FLOAT blendFactor[4], UINT sampleMask);
+    void OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef);
+
+    const Stats& GetStats() const { return stats_; }
+    void ResetStats() { stats_ = Stats(); }
+
+private:
+    // Slots the cache knows nothing about hold this value, which no real object can compare equal to
+    template<typename T>
+    static T* Unknown() { return reinterpret_cast<T*>(~static_cast<uintptr_t>(0)); }
+
+    struct ShaderStageState {
+        ID3D11Buffer* constantBuffers[MAX_CONSTANT_BUFFERS];
+        UINT firstConstants[MAX_CONSTANT_BUFFERS];
+        UINT numConstants[MAX_CONSTANT_BUFFERS];
+        ID3D11ShaderResourceView* shaderResources[MAX_SHADER_RESOURCES];
+        ID3D11SamplerState* samplers[MAX_SAMPLERS];
+    };
+
+    // Narrows [startSlot, startSlot + count) to the sub-range that differs from the cache and
+    // records the new values; false when nothing differs. Ranges past capacity are never filtered.
+    template<typename T>
+    bool TrimRange(T** cached, UINT capacity, UINT& startSlot, UINT& count, T* const* values);
+
+    void InvalidateShaderResources();
+    void SetConstantBuffers(ShaderStageState& stage, bool pixelStage, UINT startSlot, UINT count,
+                            ID3D11Buffer* const* buffers, const UINT* firstConstants, const UINT* numConstants);
+
+    ID3D11DeviceContext* context_;
+    ID3D11DeviceContext1* context1_;   // Null before Direct3D 11.1
+
+    // Input assembler
+    ID3D11InputLayout* inputLayout_;
+    D3D11_PRIMITIVE_TOPOLOGY topology_;
+    bool topologyValid_;
+    ID3D11Buffer* vertexBuffers_[MAX_VERTEX_BUFFERS];
+    UINT vertexStrides_[MAX_VERTEX_BUFFERS];
+    UINT vertexOffsets_[MAX_VERTEX_BUFFERS];
+    ID3D11Buffer* indexBuffer_;
+    DXGI_FORMAT indexFormat_;
+    UINT indexOffset_;
+
+    // Shaders
+    ID3D11VertexShader* vertexShader_;
+    ID3D11PixelShader* pixelShader_;
+    ShaderStageState vs_;
+    ShaderStageState ps_;
+
+    // Rasterizer and output merger
+    ID3D11RasterizerState* rasterizerState_;
+    D3D11_VIEWPORT viewports_[MAX_VIEWPORTS];
+    UINT viewportCount_;
+    bool viewportsValid_;
+    ID3D11RenderTargetView* renderTargets_[MAX_RENDER_TARGETS];
+    UINT renderTargetCount_;
+    ID3D11DepthStencilView* depthStencilView_;
+    bool renderTargetsValid_;
+    ID3D11BlendState* blendState_;
+    FLOAT blendFactor_[4];
+    UINT sampleMask_;
+    ID3D11DepthStencilState* depthStencilState_;
+    UINT stencilRef_;
+
+    ID3D11PixelShader* overrideShader_;
+    ID3D11BlendState* overrideBlend_;
+
+    Stats stats_;
+};
+
+} // namespace Nexus
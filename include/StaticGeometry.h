@@ -0,0 +1,187 @@
+#pragma once
+
+#include "SceneBVH.h"
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+struct MeshData;
+
+/**
+ * Terrain collider: a regular grid of heights in local space, sample (x, z) at
+ * (x * cellSize, heights[z * samplesX + x], z * cellSize). Each cell is two triangles split along
+ * the diagonal from its low corner to its high one. Queries go straight to the cells under a box
+ * and rays walk the cells they cross, so the cost does not grow with the size of the terrain.
+ */
+class HeightfieldCollider {
+public:
+    HeightfieldCollider();
+
+    // At least 2 x 2 samples; false otherwise
+    bool Build(const float* heights, uint32_t samplesX, uint32_t samplesZ, float cellSize);
+
+    const AABB& GetBounds() const { return bounds_; }
+    uint32_t GetSamplesX() const { return samplesX_; }
+    uint32_t GetSamplesZ() const { return samplesZ_; }
+    float GetCellSize() const { return cellSize_; }
+
+    // fn(const XMFLOAT3* triangle) for both triangles of every cell under box whose height range
+    // it reaches
+    template<typename Fn>
+    void Query(const AABB& box, Fn&& fn) const;
+    // First hit along from + delta * t, t in [0, maxFraction]; normal faces the ray
+    bool RayCast(const DirectX::XMFLOAT3& from, const DirectX::XMFLOAT3& delta, float maxFraction, float& fraction,
+                 DirectX::XMFLOAT3& normal) const;
+
+private:
+    void GetCell(uint32_t x, uint32_t z, DirectX::XMFLOAT3* triangles) const;   // Six vertices
+    float Height(uint32_t x, uint32_t z) const { return heights_[z * samplesX_ + x]; }
+
+    std::vector<float> heights_;
+    uint32_t samplesX_;
+    uint32_t samplesZ_;
+    float cellSize_;
+    AABB bounds_;
+};
+
+/**
+ * Static triangle mesh collider for level geometry, over a quantized bounding-volume hierarchy.
+ *
+ * Nodes are 16 bytes: bounds as 16-bit integers across the mesh bounds, rounded outwards, and
+ * either a triangle or the size of the subtree. They are stored depth-first, so a query walks the
+ * array front to back without a stack, skipping a subtree by its size when its bounds miss.
+ * Triangles are stored by leaf, so neighbouring leaves read neighbouring vertices. Build once,
+ * ideally at import: BuildCache() bakes a mesh's collider next to it, which Load() reads back in
+ * one go.
+ */
+class TriangleMeshCollider {
+public:
+    static constexpr uint32_t MAGIC = 0x4C4F434E;   // "NCOL"
+    static constexpr uint32_t VERSION = 1;
+
+    TriangleMeshCollider();
+
+    // Degenerate triangles are dropped; false if none are left
+    bool Build(const DirectX::XMFLOAT3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+    // From the full-detail level of an imported mesh
+    bool Build(const MeshData& mesh);
+
+    bool Save(const std::string& filename) const;
+    bool Load(const std::string& filename);
+    // model.obj -> model.obj.ncol
+    static std::string GetCachePath(const std::string& sourceFile);
+    // Imports the source and writes its collider unless the cache is already current
+    static bool BuildCache(const std::string& sourceFile);
+
+    const AABB& GetBounds() const { return bounds_; }
+    size_t GetTriangleCount() const { return vertices_.size() / 3; }
+    size_t GetNodeCount() const { return nodes_.size(); }
+
+    // fn(const XMFLOAT3* triangle) for every triangle whose bounds overlap box
+    template<typename Fn>
+    void Query(const AABB& box, Fn&& fn) const;
+    // Closest hit along from + delta * t, t in [0, maxFraction]; normal faces the ray. backFace,
+    // if given, says whether the ray came from behind the triangle, against the side
+    // cross(v1 - v0, v2 - v0) points to
+    bool RayCast(const DirectX::XMFLOAT3& from, const DirectX::XMFLOAT3& delta, float maxFraction, float& fraction,
+                 DirectX::XMFLOAT3& normal, bool* backFace = nullptr) const;
+
+    struct RayHit {
+        float fraction = 0.0f;
+        DirectX::XMFLOAT3 normal = { 0.0f, 0.0f, 0.0f };   // Faces the ray
+        bool hit = false;
+        bool backFace = false;
+    };
+
+    // Closest hits of up to four rays at once, each working as in RayCast. Every node is
+    // dequantized once and slab-tested against all lanes with SSE, and skipped only when every
+    // lane misses, so coherent rays share one walk. Safe to call from several threads at once
+    static constexpr uint32_t PACKET_SIZE = 4;
+    void RayCastPacket(const DirectX::XMFLOAT3* from, const DirectX::XMFLOAT3* delta, const float* maxFraction,
+                       uint32_t count, RayHit* hits) const;
+
+private:
+    static constexpr uint32_t LEAF = 0x80000000u;
+
+    struct Node {
+        uint16_t min[3];
+        uint16_t max[3];
+        uint32_t data;                         // LEAF | triangle, or the node count of the subtree
+    };
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t nodeCount;
+        uint32_t triangleCount;
+        AABB bounds;
+    };
+
+    uint32_t BuildNode(std::vector<uint32_t>& triangles, uint32_t first, uint32_t count,
+                       const std::vector<DirectX::XMFLOAT3>& source, const std::vector<AABB>& boxes,
+                       const std::vector<DirectX::XMFLOAT3>& centers);
+    void Quantize(const AABB& box, uint16_t* min, uint16_t* max) const;
+    AABB Dequantize(const Node& node) const;
+
+    std::vector<Node> nodes_;
+    std::vector<DirectX::XMFLOAT3> vertices_;   // Three per triangle, in leaf order
+    AABB bounds_;
+    DirectX::XMFLOAT3 quantization_;            // Units per world unit
+};
+
+template<typename Fn>
+void HeightfieldCollider::Query(const AABB& box, Fn&& fn) const {
+    if (heights_.empty() || box.max.y < bounds_.min.y || box.min.y > bounds_.max.y) return;
+
+    float cellsX = static_cast<float>(samplesX_ - 1);
+    float cellsZ = static_cast<float>(samplesZ_ - 1);
+    float minX = box.min.x / cellSize_, maxX = box.max.x / cellSize_;
+    float minZ = box.min.z / cellSize_, maxZ = box.max.z / cellSize_;
+    if (maxX < 0.0f || maxZ < 0.0f || minX >= cellsX || minZ >= cellsZ) return;
+
+    uint32_t x0 = static_cast<uint32_t>(std::max(minX, 0.0f));
+    uint32_t z0 = static_cast<uint32_t>(std::max(minZ, 0.0f));
+    uint32_t x1 = static_cast<uint32_t>(std::min(maxX, cellsX - 1.0f));
+    uint32_t z1 = static_cast<uint32_t>(std::min(maxZ, cellsZ - 1.0f));
+    DirectX::XMFLOAT3 triangles[6];
+    for (uint32_t z = z0; z <= z1; ++z) {
+        for (uint32_t x = x0; x <= x1; ++x) {
+            float a = Height(x, z), b = Height(x + 1, z), c = Height(x, z + 1), d = Height(x + 1, z + 1);
+            if (box.min.y > std::max(std::max(a, b), std::max(c, d)) || box.max.y < std::min(std::min(a, b), std::min(c, d))) {
+                continue;
+            }
+            GetCell(x, z, triangles);
+            fn(static_cast<const DirectX::XMFLOAT3*>(triangles));
+            fn(static_cast<const DirectX::XMFLOAT3*>(triangles + 3));
+        }
+    }
+}
+
+template<typename Fn>
+void TriangleMeshCollider::Query(const AABB& box, Fn&& fn) const {
+    if (nodes_.empty() || box.max.x < bounds_.min.x || box.min.x > bounds_.max.x || box.max.y < bounds_.min.y ||
+        box.min.y > bounds_.max.y || box.max.z < bounds_.min.z || box.min.z > bounds_.max.z) {
+        return;
+    }
+
+    uint16_t min[3], max[3];
+    Quantize(box, min, max);
+    const uint32_t count = static_cast<uint32_t>(nodes_.size());
+    for (uint32_t index = 0; index < count;) {
+        const Node& node = nodes_[index];
+        bool overlaps = node.min[0] <= max[0] && node.max[0] >= min[0] && node.min[1] <= max[1] &&
+                        node.max[1] >= min[1] && node.min[2] <= max[2] && node.max[2] >= min[2];
+        bool leaf = (node.data & LEAF) != 0;
+        if (leaf && overlaps) {
+            fn(static_cast<const DirectX::XMFLOAT3*>(&vertices_[(node.data & ~LEAF) * 3]));
+        }
+        index += (overlaps || leaf) ? 1 : node.data;
+    }
+}
+
+} // namespace Nexus
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Platform.h"
+#include <cstdint>
+
+namespace Nexus {
+
+class StateCache;
+
+/**
+ * Temporal anti-aliasing and temporal upscaling.
+ *
+ * Every frame the projection is offset by a subpixel jitter from a Halton(2, 3) sequence, so
+ * successive frames sample different points of each pixel. Resolve() reprojects the previous
+ * output onto this frame and blends the new samples into it, which both anti-aliases and, when
+ * the scene was rendered below output size, reconstructs the missing detail: each output pixel
+ * weighs the rendered samples around it by their jittered distance and trusts its history more
+ * where no sample landed close this frame. The history is clipped to the variance box of the
+ * current samples in YCoCg space, so disoccluded and changed pixels cannot ghost.
+ *
+ * Camera motion is rebuilt from depth and the previous view-projection. Geometry that moves by
+ * itself (skinned characters, particles, animated objects) adds its own motion by writing to the
+ * velocity target as the second render target: current minus previous screen position in uv,
+ * both projected with this frame's view-projection, so static geometry writes nothing and blended
+ * draws blend their motion like their color.
+ *
+ * Without dynamic resolution the scene renders into GetSceneTarget(), a target at output size of
+ * which the frame covers GetRenderWidth() x GetRenderHeight() from the top-left; with it, the
+ * dynamic resolution scene target and scale are used instead.
+ */
+class TemporalAA {
+public:
+    enum class Mode {
+        Native,     // Anti-aliasing only, renders at output size
+        Upscale     // Renders at upscaleRatio and reconstructs to output size
+    };
+
+    struct Settings {
+        Mode mode = Mode::Native;
+        float upscaleRatio = 0.67f;     // Per axis when upscaling without dynamic resolution; 0.5-0.77
+        float feedback = 0.9f;          // History weight where this frame's samples are well placed
+        float clipGamma = 1.25f;        // History clip box, in standard deviations of the neighbourhood
+        float sharpness = 0.25f;        // 0 disables the sharpening after the resolve
+    };
+
+    // Cycle length of the jitter at native resolution; upscaling lengthens it by the pixel ratio
+    static constexpr UINT JITTER_PHASES = 8;
+    static constexpr UINT MAX_JITTER_PHASES = 32;
+
+    TemporalAA();
+    ~TemporalAA();
+
+    TemporalAA(const TemporalAA&) = delete;
+    TemporalAA& operator=(const TemporalAA&) = delete;
+
+    // width and height are the output size
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                    UINT width, UINT height, const Settings& settings);
+    void Shutdown();
+
+    void SetSettings(const Settings& settings);
+    const Settings& GetSettings() const { return settings_; }
+
+    // Picks this frame's jitter and clears the velocity target. renderWidth and renderHeight come
+    // from dynamic resolution when it is on; 0 renders at the size the settings ask for
+    void BeginFrame(UINT renderWidth = 0, UINT renderHeight = 0);
+    UINT GetRenderWidth() const { return renderWidth_; }
+    UINT GetRenderHeight() const { return renderHeight_; }
+
+    // This frame's offset in clip space, and a projection carrying it. Draw with the jittered
+    // projection; compute motion and cull with the plain one
+    const DirectX::XMFLOAT2& GetJitter() const { return jitter_; }
+    DirectX::XMMATRIX JitterProjection(DirectX::FXMMATRIX projection) const;
+
+    // Drops the history, for camera cuts and teleports
+    void ResetHistory() { historyValid_ = false; }
+
+    ID3D11RenderTargetView* GetSceneTarget() const { return sceneTarget_; }
+    ID3D11ShaderResourceView* GetSceneView() const { return sceneView_; }
+    // RG16 float, same size and region as the scene
+    ID3D11RenderTargetView* GetVelocityTarget() const { return velocityTarget_; }
+
+    // Blends scene (the rendered region of an output-sized target) into the history and draws the
+    // result to target at output size, leaving target bound without depth. depth is the frame's
+    // depth buffer; view and projection are the frame's camera without jitter
+    void Resolve(ID3D11ShaderResourceView* scene, ID3D11ShaderResourceView* depth,
+                 DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, ID3D11RenderTargetView* target);
+
+private:
+    bool CreateResources();
+    bool CreateShaders();
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    StateCache* stateCache_;
+    Settings settings_;
+    UINT width_;
+    UINT height_;
+
+    ID3D11Texture2D* sceneTexture_;
+    ID3D11RenderTargetView* sceneTarget_;
+    ID3D11ShaderResourceView* sceneView_;
+    ID3D11Texture2D* velocityTexture_;
+    ID3D11RenderTargetView* velocityTarget_;
+    ID3D11ShaderResourceView* velocityView_;
+
+    // Ping-pong output-size history, read by one resolve and written by the next
+    ID3D11Texture2D* historyTextures_[2];
+    ID3D11UnorderedAccessView* historyTargets_[2];
+    ID3D11ShaderResourceView* historyViews_[2];
+    UINT historyIndex_;
+    bool historyValid_;
+
+    ID3D11ComputeShader* resolveShader_;
+    ID3D11VertexShader* fullscreenShader_;
+    ID3D11PixelShader* presentShader_;
+    ID3D11Buffer* constants_;
+    ID3D11SamplerState* linearClamp_;
+    ID3D11RasterizerState* rasterizerState_;
+    ID3D11DepthStencilState* depthState_;
+
+    // Per frame
+    uint32_t frameIndex_;
+    UINT renderWidth_;
+    UINT renderHeight_;
+    DirectX::XMFLOAT2 jitter_;
+    DirectX::XMFLOAT2 jitterPixels_;
+    DirectX::XMFLOAT4X4 previousViewProjection_;
+};
+
+} // namespace Nexus
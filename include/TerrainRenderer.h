@@ -0,0 +1,179 @@
+#pragma once
+
+#include "Platform.h"
+#include "SceneBVH.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+class PhysicsEngine;
+class HeightfieldCollider;
+
+/**
+ * Streamed heightfield terrain drawn with continuous distance-dependent LOD (CDLOD).
+ *
+ * The terrain is a grid of square tiles, each a file <directory>/<x>_<z>.r16 of tileSamples x
+ * tileSamples little-endian 16-bit heights. Sample (i, j) of tile (x, z) lies at
+ * ((x * (tileSamples - 1) + i) * cellSize, height, (z * (tileSamples - 1) + j) * cellSize), and
+ * neighbouring tiles repeat their shared edge. Heights decode as unorm * heightScale + heightOffset.
+ *
+ * Tiles within streamRadius of the camera's tile are kept resident. A loader thread reads them
+ * and builds their HeightfieldCollider, which is registered with the physics engine, so bodies
+ * collide with the very samples that are drawn. Each resident tile occupies the slice of a
+ * (2 * streamRadius + 1)^2 texture array picked by its coordinates modulo the window, like a
+ * toroidal clipmap. Memory is fixed by the radius and not by the size of the world.
+ *
+ * Every resident tile is the root of a quadtree whose leaves are gridResolution quads across.
+ * Render() selects nodes against the frustum and per-level distance ranges that double from
+ * lodDistance, then draws them all as instances of one grid mesh in a single call. The vertex
+ * shader samples the heights. As the camera backs away, each vertex slides onto the next
+ * coarser grid over the last morphRatio of its level's range, so levels meet without cracks
+ * or popping. Its outputs match PBR_VS, so the caller's pixel shader and material
+ * (GBuffer_PS or PBR_PS) shade the terrain.
+ */
+class TerrainRenderer {
+public:
+    struct Settings {
+        UINT tileSamples = 257;         // Per side; tileSamples - 1 is a power of two
+        float cellSize = 1.0f;          // Between samples, in world units
+        float heightScale = 256.0f;
+        float heightOffset = 0.0f;
+        UINT gridResolution = 32;       // Quads across a patch; a power of two below tileSamples
+        float lodDistance = 64.0f;      // Range of the finest level; at least two leaf patches
+        float morphRatio = 0.3f;        // Fraction of each level's range spent morphing, 0-1
+        UINT streamRadius = 2;          // In tiles around the camera's
+        UINT uploadsPerFrame = 2;       // Loaded tiles made resident per Update()
+        float textureScale = 0.1f;      // Texture coordinates per world unit
+    };
+
+    struct Stats {
+        uint32_t residentTiles = 0;
+        uint32_t loadingTiles = 0;
+        uint32_t nodes = 0;             // Patches drawn by the last Render()
+    };
+
+    static constexpr UINT MAX_LEVELS = 8;
+    static constexpr UINT MAX_NODES = 4096;
+
+    TerrainRenderer();
+    ~TerrainRenderer();
+
+    TerrainRenderer(const TerrainRenderer&) = delete;
+    TerrainRenderer& operator=(const TerrainRenderer&) = delete;
+
+    // physics may be null, which leaves the terrain without collision
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, PhysicsEngine* physics);
+    void Shutdown();
+
+    // Closes the current terrain first. False if the settings do not describe a valid quadtree
+    bool Open(const std::string& directory, const Settings& settings);
+    // Unloads every tile and removes their colliders
+    void Close();
+    bool IsOpen() const { return levelCount_ > 0; }
+    const Settings& GetSettings() const { return settings_; }
+
+    // Once per frame: requests the tiles around the camera, drops the ones that left the
+    // window and makes loaded ones resident within the upload budget
+    void Update(const DirectX::XMFLOAT3& cameraPosition);
+    // Selects patches and draws them. viewProjection may carry TemporalAA's jitter. Leaves the
+    // vertex stage, input assembler and vertex-stage sampler 0 bound to the terrain
+    void Render(DirectX::CXMMATRIX viewProjection, DirectX::CXMMATRIX lightViewProjection,
+                const DirectX::XMFLOAT3& cameraPosition);
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    enum class TileState { Loading, Resident, Missing };
+
+    // Filled by the loader thread, then owned by the main thread
+    struct TileLoad {
+        int32_t x = 0, z = 0;
+        uint32_t generation = 0;
+        std::string path;
+        Settings settings;                      // Copied, so Open() may change them meanwhile
+        UINT levelCount = 0;
+        std::vector<uint16_t> samples;
+        std::shared_ptr<HeightfieldCollider> collider;
+        std::vector<std::vector<DirectX::XMFLOAT2>> heightRanges;   // Per level, min and max per node
+        bool failed = false;
+    };
+
+    struct Tile {
+        int32_t x = 0, z = 0;
+        TileState state = TileState::Loading;
+        UINT slot = 0;
+        int colliderId = 0;                     // StaticColliderID, 0 without physics
+        std::vector<std::vector<DirectX::XMFLOAT2>> heightRanges;
+    };
+
+    struct Node {
+        float x, z;
+        float size;
+        UINT level;
+        const Tile* tile;
+    };
+
+    static uint64_t GetTileKey(int32_t x, int32_t z) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+    }
+    float GetTileSize() const { return (settings_.tileSamples - 1) * settings_.cellSize; }
+    UINT GetSlot(int32_t x, int32_t z) const;
+
+    bool CreateShaders();
+    bool CreateGrid();
+    bool CreateHeightArray();
+    void FinishLoads();
+    void MakeResident(TileLoad& load, Tile& tile);
+    void UnloadTile(Tile& tile);
+    // CDLOD selection: false when the node is beyond its level's range, so the caller covers it
+    bool SelectNode(const Tile& tile, UINT level, UINT nodeX, UINT nodeZ, const Frustum& frustum,
+                    const DirectX::XMFLOAT3& cameraPosition);
+
+    void LoaderThread();
+    static void ReadTile(TileLoad& load);
+
+    ID3D11Device* device_;
+    ID3D11DeviceContext* context_;
+    PhysicsEngine* physics_;
+    Settings settings_;
+    Stats stats_;
+
+    std::string directory_;
+    UINT levelCount_;
+    UINT windowSize_;                           // Tiles per side of the resident window
+    float ranges_[MAX_LEVELS];
+    std::unordered_map<uint64_t, Tile> tiles_;
+    std::vector<Node> selected_;
+
+    ID3D11VertexShader* vertexShader_;
+    ID3D11InputLayout* inputLayout_;
+    ID3D11Buffer* gridVertices_;
+    ID3D11Buffer* gridIndices_;
+    UINT gridIndexCount_;
+    ID3D11Buffer* constants_;
+    ID3D11Buffer* nodeBuffer_;
+    ID3D11ShaderResourceView* nodeView_;
+    ID3D11Texture2D* heightArray_;
+    ID3D11ShaderResourceView* heightView_;
+    ID3D11SamplerState* linearClamp_;
+
+    // Loader thread
+    std::thread loaderThread_;
+    std::deque<std::shared_ptr<TileLoad>> loadQueue_;
+    std::mutex loadQueueMutex_;
+    std::condition_variable loadQueueCondition_;
+    std::vector<std::shared_ptr<TileLoad>> completedLoads_;
+    std::mutex completedMutex_;
+    bool shutdownRequested_;
+    uint32_t generation_;                       // Bumped by Close() so stale loads are dropped
+};
+
+} // namespace Nexus
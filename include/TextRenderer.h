@@ -2,28 +2,83 @@
 
 #include <d3d11.h>
 #include <DirectXMath.h>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace Nexus {
 
+class StateCache;
+
+/**
+ * Batched signed distance field text.
+ *
+ * RenderText() only lays out one quad per glyph into a CPU array. Flush() copies every quad
+ * queued since the last flush into a dynamic vertex buffer and draws them all with a single
+ * indexed draw. The glyphs are sampled from a distance field atlas generated at startup from a
+ * built-in stroke font, so text stays sharp at any scale.
+ */
 class TextRenderer {
 public:
     TextRenderer();
     ~TextRenderer();
-    
-    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache);
     void Shutdown();
-    
+
+    // Queues text with its top-left corner at (x, y) in pixels; '\n' starts a new line. Lines
+    // are 16 pixels high at scale 1
     void RenderText(const std::string& text, float x, float y, float scale = 1.0f, const DirectX::XMFLOAT4& color = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
-    
+    // Non-allocating overload for per-frame text built into stack or frame-arena buffers
+    void RenderText(const char* text, float x, float y, float scale = 1.0f, const DirectX::XMFLOAT4& color = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    // Draws all queued text over the render target bound on the context, which is width x
+    // height pixels, and empties the queue
+    void Flush(UINT width, UINT height);
+    size_t GetQueuedGlyphs() const { return vertices_.size() / 4; }
+
+    // One glyph of laid-out text: its cell in pixels and in the font atlas
+    struct GlyphQuad {
+        float left, top, width, height;
+        float u0, v0, u1, v1;
+    };
+    // Lays text out as RenderText() does, appending the quad of every visible glyph, for
+    // batches that draw the font atlas themselves
+    static void LayoutText(const char* text, float x, float y, float scale, std::vector<GlyphQuad>& quads);
+    // Single channel distance field with glyph edges at 0.5; null until initialized
+    ID3D11ShaderResourceView* GetFontTexture() const { return fontTexture_; }
+
 private:
+    struct GlyphVertex {
+        DirectX::XMFLOAT2 position;  // Pixels
+        DirectX::XMFLOAT2 texCoord;
+        uint32_t color;              // RGBA8
+    };
+
     bool CreateBitmapFont();
-    
+    bool CreatePipeline();
+    bool EnsureCapacity(size_t glyphs);
+
     ID3D11Device* device_;
     ID3D11DeviceContext* context_;
+    StateCache* stateCache_;
     ID3D11ShaderResourceView* fontTexture_;
+
+    ID3D11VertexShader* vertexShader_;
+    ID3D11PixelShader* pixelShader_;
+    ID3D11InputLayout* inputLayout_;
+    ID3D11Buffer* constants_;
+    ID3D11SamplerState* linearClamp_;
+    ID3D11BlendState* blendState_;
+    ID3D11RasterizerState* rasterizerState_;
+    ID3D11DepthStencilState* depthState_;
+
+    // Quads of the current frame, uploaded and drawn together by Flush()
+    std::vector<GlyphVertex> vertices_;
+    ID3D11Buffer* vertexBuffer_;
+    ID3D11Buffer* indexBuffer_;
+    size_t capacity_;  // Glyphs
     bool initialized_;
 };
 
-}
\ No newline at end of file
+}
@@ -1,11 +1,18 @@
 #pragma once
 
 #include "Platform.h"
+#include "ShaderPermutations.h"
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace Nexus {
 
+class TextureStreamingEngine;
+class TextureFile;
+class JobSystem;
+class MaterialTable;
+
 /**
  * Enhanced texture class with normal mapping and filtering support
  */
@@ -14,26 +21,49 @@ public:
     Texture();
     ~Texture();
 
-    // Loading
-    bool LoadFromFile(const std::string& filename, ID3D11Device* device);
-    bool LoadFromMemory(const void* data, size_t size, ID3D11Device* device);
-    bool CreateRenderTarget(int width, int height, DXGI_FORMAT format, ID3D11Device* device);
+    // Loading. Decoded images (PNG, JPEG, TGA, BMP) are block-compressed with a full mip chain
+    // unless SetCompressionQuality() disabled it; jobs spreads the encode across workers
+    bool LoadFromFile(const std::string& filename, ID3D11Device* device, JobSystem* jobs = nullptr);
+    // A whole file already in memory (a pak entry); name's extension picks container or image
+    // decoding, as the filename does for LoadFromFile, and feeds the normal map hints
+    bool LoadFromMemory(const void* data, size_t size, ID3D11Device* device, const std::string& name = "",
+                        JobSystem* jobs = nullptr);
+    // DDS/KTX2 only: loads the mip tail now and lets the engine stream finer levels on demand
+    bool LoadStreaming(const std::string& filename, TextureStreamingEngine* streaming);
+    // mipMaps allocates a full chain that GenerateMipMaps() rebuilds from the base level
+    bool CreateRenderTarget(int width, int height, DXGI_FORMAT format, ID3D11Device* device, bool mipMaps = false);
     bool CreateDepthStencil(int width, int height, DXGI_FORMAT format, ID3D11Device* device);
+    // Exchanges the loaded resources and their properties, not the filtering settings, so a
+    // texture loaded elsewhere can replace this one's contents for everything holding it
+    void Swap(Texture& other);
+
+    // Import compression: BC5 for normal maps, BC7 for everything else, or BC1/BC3 below quality
+    // 50. quality is 0-100; a negative value uploads decoded images as RGBA8 without mips
+    static void SetCompressionQuality(int quality);
+    static int GetCompressionQuality();
+    // Offline conversion: decodes an image, builds its mips and writes the import encoding as DDS
+    static bool ConvertToDDS(const std::string& source, const std::string& destination, int quality = 75,
+                             JobSystem* jobs = nullptr);
+    // File name hints (_n, _nrm, normal) and, when pixels are given, their RGBA8 statistics
+    static bool DetectNormalMap(const std::string& filename, const uint8_t* pixels, int width, int height);
 
     // Texture properties
     bool IsNormalMap() const { return isNormalMap_; }
     void SetIsNormalMap(bool value) { isNormalMap_ = value; }
     
     bool HasMipMaps() const { return hasMipMaps_; }
-    void GenerateMipMaps();
+    // GPU mip generation for render targets created with mipMaps; false for any other texture
+    bool GenerateMipMaps(ID3D11DeviceContext* context);
 
     // Enhanced filtering
     void SetFilterMode(D3D11_FILTER minFilter, D3D11_FILTER magFilter, D3D11_FILTER mipFilter);
     void SetAnisotropicFiltering(UINT maxAnisotropy);
 
     // Access
+    // Null for streamed textures, whose resource is reallocated as mips stream in
     ID3D11Texture2D* GetTexture() const { return texture_; }
-    ID3D11ShaderResourceView* GetShaderResourceView() const { return shaderResourceView_; }
+    // Streamed textures can return a different view each frame; fetch it when binding
+    ID3D11ShaderResourceView* GetShaderResourceView() const;
     
     int GetWidth() const { return width_; }
     int GetHeight() const { return height_; }
@@ -43,11 +73,20 @@ public:
     void Bind(ID3D11DeviceContext* context, UINT stage) const;
     void Unbind(ID3D11DeviceContext* context, UINT stage) const;
 
-    // Memory usage
-    size_t GetMemoryUsage() const { return width_ * height_ * 4; } // Assuming RGBA format
+    // Memory usage of all resident mips and slices in the texture's actual format
+    size_t GetMemoryUsage() const;
+
+    // Streaming. RegisterUsage reports the largest on-screen extent (pixels) of a surface using
+    // this texture this frame; it does nothing for textures that are not streamed
+    bool IsStreamed() const { return streaming_ != nullptr; }
+    uint32_t GetStreamingId() const { return streamingId_; }
+    void RegisterUsage(const XMFLOAT3& worldPosition, float screenSize) const;
 
 private:
-    void DetectNormalMap();
+    bool LoadContainer(TextureFile& file, const std::string& name, ID3D11Device* device);
+    bool LoadDecodedImage(const uint8_t* data, size_t size, const std::string& name, ID3D11Device* device,
+                          JobSystem* jobs);
+    void Release();
     void SetupSamplerState(ID3D11DeviceContext* context, UINT stage) const;
 
     ID3D11Texture2D* texture_;
@@ -56,6 +95,9 @@ private:
     int width_;
     int height_;
     DXGI_FORMAT format_;
+    size_t memoryUsage_;
+    TextureStreamingEngine* streaming_;
+    uint32_t streamingId_;
     
     bool isNormalMap_;
     bool hasMipMaps_;
@@ -80,10 +122,10 @@ public:
     void SetSpecularTexture(std::shared_ptr<Texture> texture) { specularTexture_ = texture; }
     void SetEmissiveTexture(std::shared_ptr<Texture> texture) { emissiveTexture_ = texture; }
 
-    std::shared_ptr<Texture> GetDiffuseTexture() const { return diffuseTexture_; }
-    std::shared_ptr<Texture> GetNormalTexture() const { return normalTexture_; }
-    std::shared_ptr<Texture> GetSpecularTexture() const { return specularTexture_; }
-    std::shared_ptr<Texture> GetEmissiveTexture() const { return emissiveTexture_; }
+    const std::shared_ptr<Texture>& GetDiffuseTexture() const { return diffuseTexture_; }
+    const std::shared_ptr<Texture>& GetNormalTexture() const { return normalTexture_; }
+    const std::shared_ptr<Texture>& GetSpecularTexture() const { return specularTexture_; }
+    const std::shared_ptr<Texture>& GetEmissiveTexture() const { return emissiveTexture_; }
 
     // Material properties
     void SetAmbientColor(const XMFLOAT4& color) { ambientColor_ = color; }
@@ -98,11 +140,28 @@ public:
     const XMFLOAT4& GetEmissiveColor() const { return emissiveColor_; }
     float GetSpecularPower() const { return specularPower_; }
 
-    // Binding
+    // Shader variant. Bound textures enable ALBEDO_MAP / NORMAL_MAP / EMISSIVE_MAP, anything else
+    // (SHADOW_MAP, IBL, ...) is listed explicitly. Resolve the variant once, not per draw
+    void SetShader(std::shared_ptr<ShaderPermutations> shader) { shader_ = shader; }
+    std::shared_ptr<ShaderPermutations> GetShader() const { return shader_; }
+    void SetShaderKeywords(const std::vector<std::string>& keywords) { shaderKeywords_ = keywords; }
+    const std::vector<std::string>& GetShaderKeywords() const { return shaderKeywords_; }
+    std::vector<std::string> GetActiveKeywords() const;
+    ShaderPermutations::KeywordMask GetShaderVariant() const;
+
+    // Forwards a surface's on-screen size to every streamed texture of the material
+    void RegisterUsage(const XMFLOAT3& worldPosition, float screenSize) const;
+
+    // Binding of this material alone. Materials in a MaterialTable can instead share the state
+    // of a batch; call MaterialTable::Update after changing a registered material
     void Bind(ID3D11DeviceContext* context) const;
     void Unbind(ID3D11DeviceContext* context) const;
+    // Index into the material table's buffer, MaterialTable::INVALID_MATERIAL until registered
+    UINT GetMaterialId() const { return materialId_; }
 
 private:
+    friend class MaterialTable;
+
     std::shared_ptr<Texture> diffuseTexture_;
     std::shared_ptr<Texture> normalTexture_;
     std::shared_ptr<Texture> specularTexture_;
@@ -113,6 +172,12 @@ private:
     XMFLOAT4 specularColor_;
     XMFLOAT4 emissiveColor_;
     float specularPower_;
+
+    std::shared_ptr<ShaderPermutations> shader_;
+    std::vector<std::string> shaderKeywords_;
+
+    MaterialTable* table_;
+    UINT materialId_;
 };
 
 } // namespace Nexus
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Platform.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+/**
+ * GPU-ready texture container (DDS or KTX2) read through a memory mapping.
+ *
+ * Open() validates the headers and builds one D3D11_SUBRESOURCE_DATA per mip and array slice
+ * pointing straight into the mapped file, so CreateTexture() uploads the stored mip chain with
+ * no intermediate copies. Both 2D textures and cubemaps (and arrays of them) are supported;
+ * volume textures and supercompressed KTX2 (Basis, zstd) are rejected. A container already in
+ * memory (a pak entry) is read in place the same way.
+ */
+class TextureFile {
+public:
+    TextureFile();
+
+    bool Open(const std::string& filename);
+    // data must stay valid until Close(); name is for messages
+    bool Open(const uint8_t* data, size_t size, const std::string& name);
+    void Close();
+
+    const D3D11_TEXTURE2D_DESC& GetDesc() const { return desc_; }
+    const std::vector<D3D11_SUBRESOURCE_DATA>& GetSubresources() const { return subresources_; }
+    bool IsCubemap() const { return (desc_.MiscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE) != 0; }
+
+    // view may be null. The file can be closed once this returns
+    HRESULT CreateTexture(ID3D11Device* device, ID3D11Texture2D** texture, ID3D11ShaderResourceView** view) const;
+
+    // True for the extensions Open() understands (.dds, .ktx2)
+    static bool IsContainer(const std::string& filename);
+
+    // Writes a DDS that Open() reads back; subresources follow D3D11CalcSubresource order
+    static bool WriteDDS(const std::string& filename, const D3D11_TEXTURE2D_DESC& desc,
+                         const D3D11_SUBRESOURCE_DATA* subresources);
+
+    // Format helpers. Pitches are in bytes; rowCount counts block rows for compressed formats.
+    // GetBitsPerPixel returns 0 for formats this loader does not handle
+    static UINT GetBitsPerPixel(DXGI_FORMAT format);
+    static bool IsBlockCompressed(DXGI_FORMAT format);
+    static bool GetSurfaceInfo(DXGI_FORMAT format, UINT width, UINT height, UINT& rowPitch, UINT& rowCount);
+    static size_t ComputeMemoryUsage(const D3D11_TEXTURE2D_DESC& desc);
+    // 2D, array, cube or cube array view over every mip of desc
+    static D3D11_SHADER_RESOURCE_VIEW_DESC GetViewDesc(const D3D11_TEXTURE2D_DESC& desc);
+
+private:
+    bool ParseDDS();
+    bool ParseKTX2();
+    // Points subresource index at offset and advances offset past it
+    bool AddSubresource(UINT index, size_t& offset, UINT width, UINT height);
+    bool Parse();
+
+    MappedFile file_;
+    const uint8_t* data_;      // The mapping, or the caller's memory
+    size_t size_;
+    std::string filename_;
+    D3D11_TEXTURE2D_DESC desc_;
+    std::vector<D3D11_SUBRESOURCE_DATA> subresources_;
+};
+
+} // namespace Nexus
@@ -1,38 +1,65 @@
 #pragma once
 
-#include <d3d11.h>
-#include <d3d12.h>
-#include <dxr.h>
+#include "Platform.h"
 #include <DirectXMath.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
-#include <vector>
-#include <unordered_map>
-#include <thread>
-#include <queue>
 #include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using namespace DirectX;
 
+struct ID3D11Device2;
+struct ID3D11DeviceContext2;
+
 namespace Nexus {
 
+class StateCache;
+class TextureFile;
+
 /**
- * Advanced Texture Streaming Engine with GPU decompression and intelligent caching
+ * Mip-level texture streaming for DDS/KTX2 containers under a fixed VRAM budget.
+ *
+ * LoadTexture() maps the file and makes only the small mip tail resident. Each frame the renderer
+ * reports how large textured surfaces are on screen (RegisterTextureUsage); Update() turns that
+ * into a wanted mip per texture and streams finer levels in one at a time. Loader threads read
+ * the mapped mip data into staging textures, so file I/O and page faults stay off the render
+ * thread; Update() then makes the level resident and raises the SRV's visible detail.
+ *
+ * On tiled-resource hardware each 2D texture reserves its full mip chain, levels are backed from a
+ * shared tile pool that grows up to the budget, and sampling is clamped with SetResourceMinLOD.
+ * Elsewhere (and for cubemaps and arrays) the resident sub-chain is reallocated and copied on the
+ * GPU whenever a level arrives or leaves, so the SRV only ever covers resident levels.
+ * GetTextureSRV() can therefore return a different view after Update(); fetch it when binding
+ * rather than caching it.
+ *
+ * When resident memory exceeds the budget, EnforceMemoryBudget() drops the finest levels of the
+ * textures that have gone longest unused (or that hold more detail than they currently need)
+ * until it fits again; the mip tail is never evicted.
+ *
+ * Virtual textures (LoadVirtualTexture) are streamed in PAGE_SIZE pages instead of whole levels,
+ * for terrain and level textures far larger than any view of them. Resident pages live in one
+ * atlas of PAGE_SLOT_SIZE slots (the page plus a border for filtering), and a page table texture
+ * per virtual texture maps every page of every level to the slot of its finest resident
+ * ancestor. Shaders built with VIRTUAL_TEXTURE (PBR_PS, GBuffer_PS) sample through the table and
+ * write the page they wanted into a feedback target at 1/FEEDBACK_SCALE resolution, one pixel of
+ * each block per frame. ResolveFeedback() copies it for readback; FEEDBACK_LATENCY frames later
+ * Update() reads it without stalling, refines each requested page one level at a time through the
+ * same loader threads and queue as mips, copies finished pages into the atlas and evicts the
+ * least recently requested pages when it is full. The atlas is a fixed cost, outside the mip
+ * budget, so page memory depends on the screen rather than on how much content is loaded.
+ *
+ * Call everything from the thread that owns the immediate context.
  */
 class TextureStreamingEngine {
 public:
-    enum class CompressionFormat {
-        None,
-        BC1,    // DXT1
-        BC3,    // DXT5
-        BC4,    // Single channel
-        BC5,    // Normal maps
-        BC6H,   // HDR
-        BC7,    // High quality
-        ASTC,   // Mobile
-        ETC2,   // Mobile
-        Custom
-    };
-
     enum class StreamingPriority {
         Critical,   // UI, immediate viewport
         High,       // Near viewport objects
@@ -41,264 +68,283 @@ public:
         Background  // Preloading
     };
 
-    struct TextureDesc {
-        std::string filePath;
-        int width = 0;
-        int height = 0;
-        int mipLevels = 0;
-        CompressionFormat format = CompressionFormat::BC7;
-        bool sRGB = false;
-        bool generateMips = true;
-        bool streaming = true;
-        int maxResidentMips = 8;
-        StreamingPriority priority = StreamingPriority::Medium;
-        float distanceFromCamera = 0.0f;
-        uint64_t estimatedMemoryUsage = 0;
-    };
-
     struct StreamingStats {
-        uint64_t totalTextureMemory = 0;
-        uint64_t streamingPoolSize = 0;
+        uint64_t memoryBudget = 0;
         uint64_t residentMemory = 0;
-        int pendingLoads = 0;
-        int texturesInFlight = 0;
-        float hitRate = 0.0f;
-        float avgLoadTime = 0.0f;
-        int droppedFrames = 0;
+        uint32_t textureCount = 0;
+        uint32_t pendingLoads = 0;        // Queued or in flight
+        uint32_t starvedTextures = 0;     // Wanted more detail than the budget allowed
+        uint32_t uploadsThisFrame = 0;
+        uint32_t evictionsThisFrame = 0;
+        uint64_t bytesStreamed = 0;       // Since ResetStatistics()
+        uint32_t residentPages = 0;       // Virtual texture pages in the atlas
+        uint32_t pageCapacity = 0;
+        uint32_t pageMisses = 0;          // Distinct pages the last feedback wanted and lacked
+        bool tiledResources = false;
     };
 
+    static constexpr uint32_t INVALID_TEXTURE = 0;
+    // Levels at or below this size stay resident for as long as the texture is loaded
+    static constexpr UINT TAIL_SIZE = 128;
+    // Frames without a RegisterTextureUsage() call before a texture only wants its tail
+    static constexpr uint64_t RETAIN_FRAMES = 120;
+
+    // Virtual texture pages, in texels; the border keeps bilinear and 4x anisotropic taps in the slot
+    static constexpr UINT PAGE_SIZE = 128;
+    static constexpr UINT PAGE_BORDER = 4;
+    static constexpr UINT PAGE_SLOT_SIZE = PAGE_SIZE + 2 * PAGE_BORDER;
+    static constexpr UINT MAX_VIRTUAL_TEXTURES = 64;   // Feedback entries carry a 6-bit index
+    // Pixel shader bindings of the VIRTUAL_TEXTURE keyword
+    static constexpr UINT VIRTUAL_SLOT = 19;           // t19 page table, t20 page atlas
+    static constexpr UINT VIRTUAL_CONSTANTS_SLOT = 4;  // b4
+    static constexpr UINT FEEDBACK_UAV_SLOT = 4;       // u4, past the G-buffer's three targets
+    static constexpr UINT FEEDBACK_SCALE = 8;
+    static constexpr UINT FEEDBACK_LATENCY = 3;        // Frames between ResolveFeedback() and reading it
+
 public:
     TextureStreamingEngine();
     ~TextureStreamingEngine();
 
-    // Initialization
-    bool Initialize(ID3D11Device* device, uint64_t poolSizeBytes = 512 * 1024 * 1024);
+    TextureStreamingEngine(const TextureStreamingEngine&) = delete;
+    TextureStreamingEngine& operator=(const TextureStreamingEngine&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, uint64_t budgetBytes,
+                    int loaderThreads = 2);
     void Shutdown();
 
-    // Texture Management
-    uint32_t LoadTexture(const std::string& filePath, const TextureDesc& desc = TextureDesc{});
+    // Texture management. Returns INVALID_TEXTURE when the file cannot be loaded
+    uint32_t LoadTexture(const std::string& filePath, StreamingPriority priority = StreamingPriority::Medium);
+    // Unloads virtual textures too
     void UnloadTexture(uint32_t textureId);
-    ID3D11ShaderResourceView* GetTextureSRV(uint32_t textureId);
-    bool IsTextureResident(uint32_t textureId, int mipLevel = 0);
-
-    // Streaming Control
+    ID3D11ShaderResourceView* GetTextureSRV(uint32_t textureId) const;
+    bool IsTextureResident(uint32_t textureId, int mipLevel = 0) const;
+    int GetResidentMip(uint32_t textureId) const;
+    uint64_t GetTextureMemory(uint32_t textureId) const;
+    // Full mip chain as stored in the file; the id must be valid
+    const D3D11_TEXTURE2D_DESC& GetTextureDesc(uint32_t textureId) const { return textures_.at(textureId)->desc; }
+
+    // Streaming control. RequestMipLevel keeps at least that level wanted until EvictTexture
     void SetStreamingPriority(uint32_t textureId, StreamingPriority priority);
     void RequestMipLevel(uint32_t textureId, int mipLevel);
-    void PreloadTexture(uint32_t textureId);
+    void PreloadTexture(uint32_t textureId) { RequestMipLevel(textureId, 0); }
     void EvictTexture(uint32_t textureId);
 
-    // Camera-based LOD
+    // Screen-space mip selection. screenSize is the surface's largest on-screen extent in pixels
     void UpdateCameraPosition(const XMFLOAT3& position, const XMFLOAT3& direction);
-    void RegisterTextureUsage(uint32_t textureId, const XMFLOAT3& worldPosition, 
-                             float screenSize);
+    void RegisterTextureUsage(uint32_t textureId, const XMFLOAT3& worldPosition, float screenSize);
+    void SetMipBias(float bias) { mipBias_ = bias; }
+
+    // Virtual textures. The file must be a single 2D texture with power-of-two sides of at least
+    // PAGE_SIZE and mips down to one page; the first one loaded fixes the atlas format, later ones
+    // must match. Only the coarsest page is resident up front. Returns INVALID_TEXTURE on failure
+    uint32_t LoadVirtualTexture(const std::string& filePath, StreamingPriority priority = StreamingPriority::Medium);
+    bool IsVirtualTexture(uint32_t textureId) const { return virtualTextures_.count(textureId) != 0; }
+    // Atlas pages per side, at most 120; applies when the atlas is next created (no virtual textures loaded)
+    void SetPageCacheSize(UINT pagesPerSide);
+    // Sizes the feedback target for a render target of this size; call again on resize
+    bool ResizeFeedback(UINT width, UINT height);
+    // Binds the page table, atlas and constants for a VIRTUAL_TEXTURE draw, and the feedback UAV
+    // alongside the render targets already bound. Binding render targets again unbinds it
+    void BindVirtualTexture(uint32_t textureId, StateCache& stateCache);
+    // Once per frame after the last VIRTUAL_TEXTURE draw: queues the feedback for readback and clears it
+    void ResolveFeedback();
 
-    // Memory Management
+    // Memory management
     void SetMemoryBudget(uint64_t budgetBytes);
-    uint64_t GetMemoryUsage() const;
+    uint64_t GetMemoryBudget() const { return memoryBudget_; }
+    uint64_t GetMemoryUsage() const { return currentMemoryUsage_; }
     void TrimMemory(uint64_t targetBytes);
     void SetLRUEnabled(bool enabled) { lruEnabled_ = enabled; }
+    void SetMaxUploadsPerFrame(int count) { maxLoadRequestsPerFrame_ = count > 0 ? count : 1; }
 
-    // Compression and Decompression
-    void SetGPUDecompressionEnabled(bool enabled);
-    bool CompressTexture(const std::string& inputPath, const std::string& outputPath,
-                        CompressionFormat format);
-    void SetCompressionQuality(int quality); // 0-100
-
-    // Update
-    void Update(float deltaTime);
-    void ProcessAsyncOperations();
+    // Once per frame: applies finished loads, schedules new ones and enforces the budget
+    void Update();
 
-    // Statistics
-    StreamingStats GetStreamingStats() const { return stats_; }
-    void ResetStatistics();
-
-    // Debug
-    void EnableDebugOverlay(bool enable) { debugOverlayEnabled_ = enable; }
-    std::vector<TextureDebugInfo> GetDebugInfo();
+    const StreamingStats& GetStreamingStats() const { return stats_; }
+    void ResetStatistics() { stats_.bytesStreamed = 0; }
+    bool IsTiled() const { return tiled_; }
 
 private:
+    static constexpr UINT NO_MIP = ~0u;
+
     struct StreamingTexture {
-        TextureDesc desc;
+        std::shared_ptr<TextureFile> source;
+        std::string filePath;
+        D3D11_TEXTURE2D_DESC desc = {};   // Full chain as stored in the file
         ID3D11Texture2D* texture = nullptr;
         ID3D11ShaderResourceView* srv = nullptr;
-        std::vector<bool> residentMips;
-        uint64_t lastAccessTime = 0;
+        UINT residentMip = 0;             // Finest resident level
+        UINT tailMip = 0;                 // Levels from here down are never evicted
+        UINT pendingMip = NO_MIP;
+        UINT usageMip = 0;                // Finest level any registration wanted
+        UINT pinnedMip = NO_MIP;
+        uint64_t usageFrame = 0;
+        uint64_t lastUsedFrame = 0;
         StreamingPriority priority = StreamingPriority::Medium;
-        bool loadInProgress = false;
         float distanceFromCamera = 0.0f;
         uint64_t memoryUsage = 0;
+        bool failed = false;              // A level could not be read; stop asking for more
+        bool tiled = false;
+        UINT standardMips = 0;            // Tiled only; slot standardMips is the packed tail
+        std::vector<UINT> tileCounts;
+        std::vector<std::vector<UINT>> tiles;   // Pool tiles backing each slot
+    };
+
+    // A virtual texture's pages, table and constants. Page keys pack level, y and x like feedback entries
+    struct VirtualTexture {
+        std::shared_ptr<TextureFile> source;
+        std::string filePath;
+        D3D11_TEXTURE2D_DESC desc = {};
+        StreamingPriority priority = StreamingPriority::Medium;
+        UINT feedbackIndex = 0;
+        UINT pagesX = 0;                  // At level 0
+        UINT pagesY = 0;
+        UINT levels = 0;                  // Paged levels; the last is a single pinned page
+        std::vector<std::vector<uint32_t>> pageTable;   // Per level, entries as the shader reads them
+        std::vector<D3D11_BOX> dirtyRegions;           // Per level; right 0 when clean
+        std::unordered_map<uint32_t, UINT> pages;       // Resident page key to atlas slot
+        std::unordered_set<uint32_t> pendingPages;
+        ID3D11Texture2D* pageTableTexture = nullptr;
+        ID3D11ShaderResourceView* pageTableView = nullptr;
+        ID3D11Buffer* constants = nullptr;
+        uint64_t constantsFrame = 0;
+    };
+
+    struct PageSlot {
+        uint32_t textureId = 0;           // 0 when free
+        uint32_t key = 0;
+        uint64_t lastUsedFrame = 0;
+        bool pinned = false;
     };
 
     struct LoadRequest {
-        uint32_t textureId;
-        int mipLevel;
-        StreamingPriority priority;
-        uint64_t requestTime;
+        std::shared_ptr<TextureFile> source;   // Held so unloading mid-load is safe
+        uint32_t textureId = 0;
+        UINT mipLevel = 0;
+        StreamingPriority priority = StreamingPriority::Medium;
+        UINT deficit = 0;                      // Levels between resident and wanted
+        float distance = 0.0f;
+        bool page = false;                     // One virtual texture page rather than a whole level
+        UINT pageX = 0;
+        UINT pageY = 0;
+
+        // priority_queue pops the largest, so "less" means less urgent
+        bool operator<(const LoadRequest& other) const {
+            if (priority != other.priority) {
+                return priority > other.priority;
+            }
+            if (deficit != other.deficit) {
+                return deficit < other.deficit;
+            }
+            return distance > other.distance;
+        }
+    };
+
+    struct CompletedLoad {
+        uint32_t textureId = 0;
+        UINT mipLevel = 0;
+        ID3D11Texture2D* staging = nullptr;   // Null when the read failed
+        bool page = false;
+        UINT pageX = 0;
+        UINT pageY = 0;
     };
 
     // Core streaming
+    void LoaderThread();
     void ProcessLoadQueue();
-    void LoadTextureMip(uint32_t textureId, int mipLevel);
-    void UnloadTextureMip(uint32_t textureId, int mipLevel);
-    
+    void ScheduleLoads();
+    ID3D11Texture2D* LoadTextureMip(const LoadRequest& request) const;
+    bool ApplyTextureMip(StreamingTexture& texture, UINT mipLevel, ID3D11Texture2D* staging);
+    void UnloadTextureMip(StreamingTexture& texture);
+    bool Reallocate(StreamingTexture& texture, UINT mipLevel, ID3D11Texture2D* staging);
+    bool CreateResidentTexture(StreamingTexture& texture);
+    void ReleaseTexture(StreamingTexture& texture);
+
     // Memory management
     void EnforceMemoryBudget();
-    uint32_t FindLRUTexture();
-    void UpdateLRU(uint32_t textureId);
-
-    // GPU decompression
-    void InitializeGPUDecompression();
-    void DecompressTextureGPU(uint32_t textureId, int mipLevel);
-
-    // File I/O
-    bool LoadTextureFromFile(const std::string& filePath, TextureDesc& desc, 
-                           std::vector<uint8_t>& data);
-    void SaveCompressedTexture(const std::string& filePath, const TextureDesc& desc,
-                              const std::vector<uint8_t>& data);
+    bool EvictFor(uint64_t bytes, const StreamingTexture* requester);
+    StreamingTexture* FindLRUTexture(const StreamingTexture* requester, bool lessImportantOnly);
+    void UpdateLRU(StreamingTexture& texture);
+    UINT GetWantedMip(const StreamingTexture& texture) const;
+    uint64_t ComputeMipMemory(const StreamingTexture& texture, UINT mipLevel) const;
+
+    // Tiled resources
+    bool InitializeTilePool(uint64_t budgetBytes);
+    bool GrowTilePool(UINT requiredTiles);
+    bool MapTiles(StreamingTexture& texture, UINT mipLevel);
+    void UnmapTiles(StreamingTexture& texture, UINT mipLevel);
+
+    // Virtual texturing
+    ID3D11Texture2D* LoadPage(const LoadRequest& request) const;
+    bool CreatePageAtlas(DXGI_FORMAT format);
+    void ReleasePageAtlas();
+    void ReadFeedback();
+    void ApplyPage(const CompletedLoad& load);
+    bool AddPage(uint32_t textureId, VirtualTexture& texture, UINT level, UINT x, UINT y, ID3D11Texture2D* staging,
+                 bool pinned);
+    void EvictPage(UINT slot);
+    int AllocatePageSlot();
+    void RefreshPageTable(VirtualTexture& texture, UINT level, UINT x, UINT y);
+    void UploadPageTables();
+    void ReleaseVirtualTexture(uint32_t textureId, VirtualTexture& texture);
 
     ID3D11Device* device_;
     ID3D11DeviceContext* context_;
-    
-    // Texture storage
+    ID3D11Device2* device2_;
+    ID3D11DeviceContext2* context2_;
+
+    // Texture storage, render thread only
     std::unordered_map<uint32_t, std::unique_ptr<StreamingTexture>> textures_;
     uint32_t nextTextureId_;
-    
-    // Streaming management
+    uint64_t frameIndex_;
+
+    // Loader threads
     std::priority_queue<LoadRequest> loadQueue_;
     std::mutex loadQueueMutex_;
+    std::condition_variable loadQueueCondition_;
     std::vector<std::thread> loaderThreads_;
     std::atomic<bool> shutdownRequested_;
-    
+    std::vector<CompletedLoad> completedLoads_;
+    std::mutex completedMutex_;
+    uint32_t loadsInFlight_;
+    uint64_t pendingMemory_;
+
     // Memory management
     uint64_t memoryBudget_;
     uint64_t currentMemoryUsage_;
     bool lruEnabled_;
-    std::vector<uint32_t> lruList_;
-    
+
+    // Tile pool; free tiles are a stack of pool indices
+    bool tiled_;
+    ID3D11Buffer* tilePool_;
+    std::vector<UINT> freeTiles_;
+    UINT tilePoolSize_;
+
+    // Virtual texturing. virtualIds_ maps feedback indices to texture ids
+    std::unordered_map<uint32_t, std::unique_ptr<VirtualTexture>> virtualTextures_;
+    uint32_t virtualIds_[MAX_VIRTUAL_TEXTURES];
+    ID3D11Texture2D* pageAtlas_;
+    ID3D11ShaderResourceView* pageAtlasView_;
+    DXGI_FORMAT pageFormat_;
+    UINT pageCacheSize_;                   // Slots per side
+    std::vector<PageSlot> pageSlots_;
+    std::vector<UINT> freePageSlots_;
+    ID3D11Texture2D* feedback_;
+    ID3D11UnorderedAccessView* feedbackView_;
+    ID3D11Texture2D* feedbackReadback_[FEEDBACK_LATENCY];
+    UINT feedbackWidth_;
+    UINT feedbackHeight_;
+    UINT feedbackWrite_;                   // Next readback copy; the oldest once all are pending
+    UINT feedbackPending_;
+
     // Camera tracking
     XMFLOAT3 cameraPosition_;
     XMFLOAT3 cameraDirection_;
-    
-    // GPU decompression
-    bool gpuDecompressionEnabled_;
-    ID3D11ComputeShader* decompressionCS_;
-    ID3D11Buffer* decompressionConstants_;
-    
-    // Statistics
+
     StreamingStats stats_;
-    bool debugOverlayEnabled_;
-    
-    // Performance settings
-    int maxLoaderThreads_;
+
     int maxLoadRequestsPerFrame_;
     float mipBias_;
 };
 
-/**
- * Ray Tracing Engine for NVIDIA RTX support
- */
-class RayTracingEngine {
-public:
-    enum class RayTracingAPI {
-        DXR,        // DirectX Raytracing
-        Vulkan,     // Vulkan RT
-        OptiX,      // NVIDIA OptiX
-        Software    // Software fallback
-    };
-
-    struct RayTracingSettings {
-        RayTracingAPI api = RayTracingAPI::DXR;
-        bool enableGlobalIllumination = true;
-        bool enableReflections = true;
-        bool enableShadows = true;
-        bool enableAmbientOcclusion = true;
-        int maxRayDepth = 4;
-        int samplesPerPixel = 1;
-        float rayTMax = 1000.0f;
-        bool enableDenoising = true;
-        bool enableTemporalAccumulation = true;
-        bool enableAdaptiveSampling = true;
-        float adaptiveThreshold = 0.1f;
-    };
-
-public:
-    RayTracingEngine();
-    ~RayTracingEngine();
-
-    // Initialization
-    bool Initialize(ID3D12Device5* device, const RayTracingSettings& settings = RayTracingSettings{});
-    void Shutdown();
-
-    // Scene Management
-    void BuildAccelerationStructures();
-    void UpdateAccelerationStructures();
-    uint32_t AddMeshToScene(const std::vector<XMFLOAT3>& vertices, 
-                           const std::vector<uint32_t>& indices);
-    void RemoveMeshFromScene(uint32_t meshId);
-
-    // Ray Tracing Passes
-    void RenderGlobalIllumination(ID3D12GraphicsCommandList4* cmdList);
-    void RenderReflections(ID3D12GraphicsCommandList4* cmdList);
-    void RenderShadows(ID3D12GraphicsCommandList4* cmdList);
-    void RenderAmbientOcclusion(ID3D12GraphicsCommandList4* cmdList);
-
-    // Denoising
-    void ApplyDenoising(ID3D12Resource* inputTexture, ID3D12Resource* outputTexture);
-    void SetDenoisingStrength(float strength);
-
-    // Settings
-    void SetSettings(const RayTracingSettings& settings) { settings_ = settings; }
-    const RayTracingSettings& GetSettings() const { return settings_; }
-
-    // Performance
-    RayTracingStats GetPerformanceStats() const { return stats_; }
-    void SetLODEnabled(bool enabled) { lodEnabled_ = enabled; }
-
-private:
-    // DXR implementation
-    bool InitializeDXR();
-    void CreateRayTracingPipeline();
-    void CreateShaderTables();
-
-    // Acceleration structures
-    void CreateBottomLevelAS();
-    void CreateTopLevelAS();
-    void UpdateTopLevelAS();
-
-    // Shaders
-    void LoadRayTracingShaders();
-    void CreateRootSignature();
-
-    ID3D12Device5* device_;
-    ID3D12GraphicsCommandList4* commandList_;
-    RayTracingSettings settings_;
-    
-    // Pipeline state
-    ID3D12StateObject* rtPipelineState_;
-    ID3D12RootSignature* globalRootSignature_;
-    ID3D12RootSignature* localRootSignature_;
-    
-    // Acceleration structures
-    ID3D12Resource* bottomLevelAS_;
-    ID3D12Resource* topLevelAS_;
-    std::vector<D3D12_RAYTRACING_INSTANCE_DESC> instances_;
-    
-    // Shader tables
-    ID3D12Resource* rayGenShaderTable_;
-    ID3D12Resource* missShaderTable_;
-    ID3D12Resource* hitGroupShaderTable_;
-    
-    // Scene data
-    std::vector<uint32_t> meshIds_;
-    uint32_t nextMeshId_;
-    
-    // Denoising
-    void* denoiser_; // OptiX denoiser or similar
-    bool denoisingEnabled_;
-    
-    // Performance tracking
-    RayTracingStats stats_;
-    bool lodEnabled_;
-};
-
-} // namespace Nexus
\ No newline at end of file
+} // namespace Nexus
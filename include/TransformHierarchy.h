@@ -0,0 +1,97 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+/**
+ * Parent/child transforms for scene nodes that have no physics body, such as imported scenes.
+ *
+ * Nodes live in flat arrays sorted by depth, so every parent comes before its children and
+ * Update() resolves one level at a time; a level's nodes only read the level above, which lets
+ * large levels split across jobs. Setting a local transform marks that node dirty and Update()
+ * recomputes it and everything below it, leaving clean subtrees alone. Structural changes
+ * (create, reparent) re-sort lazily on the next Update(); NodeIDs stay valid across the re-sort.
+ * Not thread-safe: modify and update from one thread.
+ */
+class TransformHierarchy {
+public:
+    using NodeID = uint32_t;
+    static constexpr NodeID INVALID_NODE = ~0u;
+
+    TransformHierarchy();
+    ~TransformHierarchy();
+
+    TransformHierarchy(const TransformHierarchy&) = delete;
+    TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+    // Rotation is a quaternion; parent may be INVALID_NODE for a root
+    NodeID Create(NodeID parent,
+                  const DirectX::XMFLOAT3& position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f),
+                  const DirectX::XMFLOAT4& rotation = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f),
+                  const DirectX::XMFLOAT3& scale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f));
+    // Destroys the node and its whole subtree
+    void Destroy(NodeID node);
+    void Clear();
+
+    // False (and nothing changes) when the new parent is the node itself or one of its descendants
+    bool SetParent(NodeID node, NodeID parent);
+    NodeID GetParent(NodeID node) const;
+    bool IsValid(NodeID node) const;
+
+    void SetLocalTransform(NodeID node, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT4& rotation,
+                           const DirectX::XMFLOAT3& scale);
+    void SetLocalPosition(NodeID node, const DirectX::XMFLOAT3& position);
+    void SetLocalRotation(NodeID node, const DirectX::XMFLOAT4& rotation);
+    void SetLocalScale(NodeID node, const DirectX::XMFLOAT3& scale);
+    DirectX::XMFLOAT3 GetLocalPosition(NodeID node) const;
+    DirectX::XMFLOAT4 GetLocalRotation(NodeID node) const;
+    DirectX::XMFLOAT3 GetLocalScale(NodeID node) const;
+
+    // Recomputes world matrices of dirty nodes and their descendants; levels wider than a
+    // grain run on jobs when given
+    void Update(JobSystem* jobs = nullptr);
+
+    // As of the last Update(), row-vector convention like the rest of the renderer
+    DirectX::XMMATRIX GetWorldMatrix(NodeID node) const;
+    DirectX::XMFLOAT3 GetWorldPosition(NodeID node) const;
+    // Whether the last Update() recomputed the node's world matrix
+    bool WasChanged(NodeID node) const;
+
+    size_t GetNodeCount() const { return parent_.size(); }
+    size_t GetLevelCount() const { return levelStart_.empty() ? 0 : levelStart_.size() - 1; }
+    size_t GetChangedCount() const { return changedCount_; }
+
+private:
+    void Sort();
+    void UpdateLevel(size_t begin, size_t end);
+    uint32_t GetIndex(NodeID node) const;
+
+    // Per node, indexed by position in depth order
+    std::vector<uint32_t> parent_;              // Index of the parent, INVALID_NODE for roots
+    std::vector<NodeID> nodeIds_;
+    std::vector<DirectX::XMFLOAT3> position_;
+    std::vector<DirectX::XMFLOAT4> rotation_;
+    std::vector<DirectX::XMFLOAT3> scale_;
+    std::vector<DirectX::XMFLOAT4X4A> world_;
+    std::vector<uint8_t> dirty_;                // Local transform set since the last Update()
+    std::vector<uint8_t> changed_;              // World recomputed by the last Update()
+
+    // First index of each depth, plus the end
+    std::vector<uint32_t> levelStart_;
+
+    // NodeID -> index, INVALID_NODE for free IDs
+    std::vector<uint32_t> indices_;
+    std::vector<NodeID> freeIds_;
+
+    bool sorted_;
+    bool anyDirty_;
+    size_t changedCount_;
+};
+
+} // namespace Nexus
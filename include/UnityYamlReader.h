@@ -0,0 +1,76 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Nexus {
+
+// One "--- !u!<class> &<fileID>" document of a Unity scene or prefab
+struct UnityYamlDocument {
+    uint32_t classId = 0;                      // 1 GameObject, 4 Transform, 23 MeshRenderer...
+    int64_t fileId = 0;
+    bool stripped = false;                     // Placeholder for an object of a prefab instance
+    std::string_view type;                     // The root key, "GameObject"
+    std::string_view body;                     // The lines below the root key
+};
+
+// One "key: value" line of a document, or one "- " sequence item
+struct UnityYamlField {
+    int indent = 0;                            // Columns; an item's "- " counts as indentation
+    bool item = false;                         // Begins a sequence item
+    std::string_view key;                      // Empty for an item that is only a value
+    std::string_view value;                    // Raw, continuation lines included; empty before a nested block
+};
+
+/**
+ * SAX style reader for Unity's YAML scenes and prefabs.
+ *
+ * Open() maps the file and splits it into its documents with one pass over the text; nothing is
+ * copied, documents and fields are views into the mapping, valid while the reader is open. The
+ * caller picks the documents it converts by class and walks only their fields with
+ * ForEachField(), so a level's hundreds of megabytes of components it ignores are never parsed.
+ * Documents are independent, so they can be walked on several threads at once.
+ *
+ * Covers the subset Unity writes: block mappings and sequences by indentation, flow mappings
+ * ("{x: 0, y: 1, z: 0}") and plain or quoted scalars, which may continue over indented lines.
+ */
+class UnityYamlReader {
+public:
+    bool Open(const std::string& filename);
+    void Close();
+
+    const std::vector<UnityYamlDocument>& GetDocuments() const { return documents_; }
+
+    static void SplitDocuments(std::string_view text, std::vector<UnityYamlDocument>& documents);
+
+    // The field starting at offset in body, moving offset past it; false at the end
+    static bool NextField(std::string_view body, size_t& offset, UnityYamlField& field);
+
+    // Calls visit(const UnityYamlField&) for each field in order until it returns false
+    template <typename Visitor>
+    static void ForEachField(std::string_view body, Visitor&& visit) {
+        UnityYamlField field;
+        size_t offset = 0;
+        while (NextField(body, offset, field)) {
+            if (!visit(field)) break;
+        }
+    }
+
+    // A value of a flow mapping, empty if the key isn't there
+    static std::string_view FindFlowValue(std::string_view flow, std::string_view key);
+    // "{fileID: 123}" to 123; 0 for none
+    static int64_t ToFileId(std::string_view flow);
+    static float ToFloat(std::string_view value, float fallback = 0.0f);
+    static int64_t ToInt(std::string_view value, int64_t fallback = 0);
+    // Without quotes; escapes are left as written
+    static std::string_view ToString(std::string_view value);
+
+private:
+    MappedFile file_;
+    std::vector<UnityYamlDocument> documents_;
+};
+
+} // namespace Nexus
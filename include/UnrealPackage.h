@@ -0,0 +1,144 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Platform.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+// A name table entry and its instance number: "Wall_3" is the name "Wall", number 4
+struct UnrealName {
+    int32_t index = -1;
+    int32_t number = 0;
+};
+
+/**
+ * Reader for Unreal Engine .uasset/.umap packages (UE 4.16 to 5.3, uncooked or cooked with
+ * versioned properties).
+ *
+ * Open() maps the file and reads the summary, name, import and export tables; export data is
+ * left in the mapping until asked for. Callers resolve the class and property names they care
+ * about to name indices once, pick exports by class and read only their tagged properties, which
+ * are then matched by index rather than by string. Exports are independent, so ReadExports()
+ * decodes them in parallel, and so are the chunks of zlib compressed bulk data.
+ */
+class UnrealPackage {
+public:
+    struct Import {
+        UnrealName classPackage;
+        UnrealName className;
+        int32_t outerIndex = 0;                 // Package index
+        UnrealName objectName;
+    };
+
+    struct Export {
+        int32_t classIndex = 0;                 // Package index: < 0 an import, > 0 an export
+        int32_t superIndex = 0;
+        int32_t outerIndex = 0;
+        UnrealName objectName;
+        uint32_t objectFlags = 0;
+        int64_t serialOffset = 0;               // In the file
+        int64_t serialSize = 0;
+        int64_t scriptStart = 0;                // Tagged properties, relative to serialOffset
+        int64_t scriptEnd = -1;                 // -1 when they run on into native data
+    };
+
+    // One tagged property; its value stays in the mapping
+    struct Property {
+        UnrealName name;
+        int32_t type = -1;                      // Name index: IntProperty, StructProperty...
+        int32_t arrayIndex = 0;
+        int32_t structName = -1;                // Struct, enum or container element type
+        int32_t valueType = -1;                 // Value type of a MapProperty
+        bool boolValue = false;                 // BoolProperty keeps its value in the tag
+        const uint8_t* data = nullptr;
+        uint32_t size = 0;
+    };
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const { return file_.IsOpen(); }
+    const std::string& GetFilename() const { return filename_; }
+    int32_t GetFileVersionUE4() const { return fileVersionUE4_; }
+    int32_t GetFileVersionUE5() const { return fileVersionUE5_; }
+
+    // Index of a name in the name table, -1 if the package never uses it
+    int32_t FindName(std::string_view name) const;
+    const std::string& GetName(int32_t index) const;
+    std::string GetName(const UnrealName& name) const;
+
+    const std::vector<Import>& GetImports() const { return imports_; }
+    const std::vector<Export>& GetExports() const { return exports_; }
+    // Name of the object a package index refers to, "None" for zero
+    std::string GetObjectName(int32_t packageIndex) const;
+    // Name index of an export's class, -1 if the class can't be resolved
+    int32_t GetClassName(const Export& object) const;
+
+    // Exports whose class is one of the given names, in table order
+    std::vector<size_t> FindExports(const std::vector<std::string>& classNames) const;
+    // The main asset: the first export in the package's root
+    const Export* GetMainExport() const;
+
+    // An export's serialized data, in the mapping
+    const uint8_t* GetExportData(size_t exportIndex, size_t& size) const;
+    // Tagged properties of an export, and optionally where its native data starts in
+    // GetExportData(). Fails for unversioned properties and corrupt data
+    bool ReadProperties(size_t exportIndex, std::vector<Property>& properties, size_t* nativeOffset = nullptr) const;
+    // The tagged properties inside a StructProperty of a struct without native serialization
+    bool ReadStructProperties(const Property& property, std::vector<Property>& properties) const;
+    // ReadProperties() for several exports, each into properties[i], on jobs when given. False if
+    // any failed; those are left empty
+    bool ReadExports(const std::vector<size_t>& exportIndices, std::vector<std::vector<Property>>& properties,
+                     JobSystem* jobs = nullptr) const;
+
+    static const Property* FindProperty(const std::vector<Property>& properties, int32_t name);
+    // Readable value of a simple property: numbers, names, strings, object references, vectors
+    std::string ToText(const Property& property) const;
+    bool ToVector(const Property& property, DirectX::XMFLOAT3& value) const;
+    int64_t ToInt(const Property& property, int64_t fallback = 0) const;
+    int32_t ToObjectIndex(const Property& property) const;
+
+    // Bulk data whose FByteBulkData header starts at header. Inline and end of file payloads are
+    // returned in the mapping when uncompressed, zlib ones are decompressed into buffer with their
+    // chunks spread over jobs. Null for payloads in .ubulk files, corrupt data or no payload
+    const uint8_t* ReadBulkData(const uint8_t* header, size_t available, std::vector<uint8_t>& buffer, size_t& size,
+                                JobSystem* jobs = nullptr) const;
+
+    // First mip of a UE4 texture's source art as RGBA8, from BGRA8, G8 or PNG compressed sources.
+    // False for cooked textures, which carry no source, and for UE5's virtualized bulk data
+    bool ReadTextureSource(size_t exportIndex, std::vector<uint8_t>& rgba, int& width, int& height,
+                           JobSystem* jobs = nullptr) const;
+
+private:
+    bool ReadSummary();
+    bool ReadTables();
+    bool ReadTags(const uint8_t* data, size_t size, size_t start, std::vector<Property>& properties, size_t* end) const;
+
+    MappedFile file_;
+    std::string filename_;
+    int32_t legacyFileVersion_ = 0;
+    int32_t fileVersionUE4_ = 0;
+    int32_t fileVersionUE5_ = 0;
+    uint32_t packageFlags_ = 0;
+    int32_t nameCount_ = 0, nameOffset_ = 0;
+    int32_t exportCount_ = 0, exportOffset_ = 0;
+    int32_t importCount_ = 0, importOffset_ = 0;
+    int64_t bulkDataStartOffset_ = 0;
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, int32_t> nameIndices_;
+    std::vector<Import> imports_;
+    std::vector<Export> exports_;
+    int32_t noneName_ = -1;
+    // Property types whose tags carry more than the name, type and size
+    int32_t structType_ = -1, boolType_ = -1, byteType_ = -1, enumType_ = -1;
+    int32_t arrayType_ = -1, setType_ = -1, mapType_ = -1;
+};
+
+} // namespace Nexus
@@ -8,6 +8,9 @@
 
 namespace Nexus {
 
+class JobSystem;
+class UnrealPackage;
+
 // Texture formats supported by Unreal Engine
 enum class TextureFormat {
     // Common formats
@@ -98,14 +101,18 @@ public:
     static std::unique_ptr<TextureData> LoadHDR(const std::string& filename);
     static std::unique_ptr<TextureData> LoadEXR(const std::string& filename);
     
-    // Unreal asset parsing
-    static std::unique_ptr<TextureData> LoadUasset(const std::string& filename);
+    // Unreal asset parsing. The package is mapped and only its Texture2D export is read; source
+    // art bulk data decompresses on jobs when given
+    static std::unique_ptr<TextureData> LoadUasset(const std::string& filename, JobSystem* jobs = nullptr);
     static std::unique_ptr<TextureData> LoadUmap(const std::string& filename);
     
     // Texture format conversion
     static std::unique_ptr<TextureData> ConvertFormat(const TextureData& source, TextureFormat targetFormat);
-    static std::unique_ptr<TextureData> GenerateMipmaps(const TextureData& source);
-    static std::unique_ptr<TextureData> DecompressTexture(const TextureData& source);
+    // Full chain for RGBA8 textures: Lanczos3, in linear light for sRGB, renormalized for
+    // TC_Normalmap. Replaces any existing mips; other formats are returned unchanged
+    static std::unique_ptr<TextureData> GenerateMipmaps(const TextureData& source, JobSystem* jobs = nullptr);
+    // BC1-BC5 to RGBA8, including mip levels. With a job system, block rows decode in parallel
+    static std::unique_ptr<TextureData> DecompressTexture(const TextureData& source, JobSystem* jobs = nullptr);
     
     // Utility functions
     static TextureFormat GetFormatFromExtension(const std::string& filename);
@@ -128,22 +135,8 @@ private:
     
     // Unreal asset parsing helpers
     static std::unique_ptr<TextureData> ParseUAssetHeader(const std::vector<uint8_t>& data);
-    static std::unique_ptr<TextureData> ExtractTextureFromUAsset(const std::vector<uint8_t>& data);
-    static std::map<std::string, std::string> ParseUAssetProperties(const std::vector<uint8_t>& data);
-    
-    // Compression/decompression helpers
-    static std::vector<uint8_t> DecompressDXT1(const std::vector<uint8_t>& data, int width, int height);
-    static std::vector<uint8_t> DecompressDXT3(const std::vector<uint8_t>& data, int width, int height);
-    static std::vector<uint8_t> DecompressDXT5(const std::vector<uint8_t>& data, int width, int height);
-    static std::vector<uint8_t> DecompressBC4(const std::vector<uint8_t>& data, int width, int height);
-    static std::vector<uint8_t> DecompressBC5(const std::vector<uint8_t>& data, int width, int height);
-    static std::vector<uint8_t> DecompressBC6H(const std::vector<uint8_t>& data, int width, int height);
-    static std::vector<uint8_t> DecompressBC7(const std::vector<uint8_t>& data, int width, int height);
-    
-    // Mipmap generation
-    static std::vector<uint8_t> GenerateMipLevel(const std::vector<uint8_t>& data, int width, int height, int bytesPerPixel);
-    static std::vector<uint8_t> BoxFilter(const std::vector<uint8_t>& data, int width, int height, int bytesPerPixel);
-    static std::vector<uint8_t> LanczoFilter(const std::vector<uint8_t>& data, int width, int height, int bytesPerPixel);
+    static std::unique_ptr<TextureData> ExtractTextureFromUAsset(const UnrealPackage& package, JobSystem* jobs);
+    static std::map<std::string, std::string> ParseUAssetProperties(const UnrealPackage& package, size_t exportIndex);
     
     // Color space conversion
     static std::vector<uint8_t> ConvertToSRGB(const std::vector<uint8_t>& data);
@@ -200,19 +193,30 @@ public:
         int lodCount = 1;
     };
     
+    // A placed static mesh of a level
+    struct UnrealInstance {
+        std::string name;
+        std::string mesh;                       // Object name of the StaticMesh
+        DirectX::XMFLOAT3 location = {0.0f, 0.0f, 0.0f};
+        DirectX::XMFLOAT3 rotation = {0.0f, 0.0f, 0.0f};   // Pitch, yaw, roll in degrees
+        DirectX::XMFLOAT3 scale = {1.0f, 1.0f, 1.0f};
+    };
+
     struct UnrealAsset {
         std::string filename;
         std::string assetType;
         std::vector<UnrealMesh> meshes;
         std::vector<UnrealMaterial> materials;
+        std::vector<UnrealInstance> instances;
         std::vector<std::string> textureReferences;
         std::map<std::string, std::string> metadata;
         bool isValid = false;
     };
     
-    // Asset loading functions
-    static std::unique_ptr<UnrealAsset> LoadUAsset(const std::string& filename);
-    static std::unique_ptr<UnrealAsset> LoadUMap(const std::string& filename);
+    // Asset loading functions. Packages are mapped and only the exports that convert are read,
+    // their properties decoded in parallel on jobs when given
+    static std::unique_ptr<UnrealAsset> LoadUAsset(const std::string& filename, JobSystem* jobs = nullptr);
+    static std::unique_ptr<UnrealAsset> LoadUMap(const std::string& filename, JobSystem* jobs = nullptr);
     static std::unique_ptr<UnrealAsset> LoadFBX(const std::string& filename);
     static std::unique_ptr<UnrealAsset> LoadOBJ(const std::string& filename);
     static std::unique_ptr<UnrealAsset> LoadDAE(const std::string& filename);
@@ -229,7 +233,8 @@ public:
     
 private:
     // UAsset parsing helpers
-    static std::unique_ptr<UnrealAsset> ParseUAssetFile(const std::vector<uint8_t>& data);
+    // Type, metadata, materials, texture references and placed meshes of a package
+    static bool ParseUAssetFile(const UnrealPackage& package, UnrealAsset& asset, JobSystem* jobs);
     static std::unique_ptr<UnrealMesh> ExtractMeshFromUAsset(const std::vector<uint8_t>& data);
     static std::unique_ptr<UnrealMaterial> ExtractMaterialFromUAsset(const std::vector<uint8_t>& data);
     
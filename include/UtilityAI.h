@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nexus {
+
+class JobSystem;
+
+enum class ResponseCurveType {
+    Linear,        // slope * (x - xShift) + yShift
+    Polynomial,    // slope * (x - xShift)^exponent + yShift, whole exponents 1-8
+    Logistic,      // slope / (1 + e^(-exponent * (x - xShift))) + yShift
+    Step           // slope + yShift from xShift on, yShift below
+};
+
+// Maps an input in [0, 1] to a utility in [0, 1]; inputs and results outside are clamped
+struct ResponseCurve {
+    ResponseCurveType type = ResponseCurveType::Linear;
+    float slope = 1.0f;
+    float exponent = 2.0f;
+    float xShift = 0.0f;
+    float yShift = 0.0f;
+
+    // Scalar reference of what UtilityScorer computes four entities at a time
+    float Evaluate(float x) const;
+};
+
+struct UtilityConsideration {
+    uint32_t input = 0;                        // From UtilityScorer::AddInput()
+    ResponseCurve curve;
+};
+
+struct UtilityAction {
+    std::string name;
+    float weight = 1.0f;                       // Scales the product of its considerations
+    std::vector<UtilityConsideration> considerations;
+};
+
+/**
+ * Utility AI scoring for many entities at once.
+ *
+ * Inputs are columns of one float per entity (health, distance to the target, squad alertness,
+ * normalized to [0, 1]), written by the caller into GetInputs(). An action's score is its weight
+ * times the response of each of its considerations to its input, with the usual compensation for
+ * the number of considerations so that actions with many are not penalized for it. Score() walks
+ * the entities four at a time with SSE: for each group it scores every action in registers and
+ * keeps the best, so choosing an action for 1000 entities is one pass over the inputs. Actions
+ * that can no longer beat the best in any lane are skipped, as are the remaining considerations
+ * once every lane scores zero.
+ *
+ * The action an entity is currently doing, written into GetCurrentActions(), has its score raised
+ * by the momentum so that near ties do not make entities switch back and forth. Groups of entities
+ * are scored in parallel over the job system when there are enough of them.
+ */
+class UtilityScorer {
+public:
+    static constexpr uint32_t NO_ACTION = ~0u;
+    static constexpr uint32_t INVALID_INPUT = ~0u;
+    static constexpr size_t LANES = 4;
+
+    UtilityScorer();
+
+    // Inputs and actions may be added at any time; existing input columns keep their values
+    uint32_t AddInput(const std::string& name);
+    uint32_t FindInput(const std::string& name) const;
+    size_t GetInputCount() const { return inputNames_.size(); }
+    // NO_ACTION when a consideration names an input that does not exist
+    uint32_t AddAction(const UtilityAction& action);
+    const UtilityAction& GetAction(uint32_t action) const { return actions_[action]; }
+    size_t GetActionCount() const { return actions_.size(); }
+    void ClearActions();
+
+    // Resizes every column; all inputs restart at 0 and current actions at NO_ACTION
+    void SetEntityCount(size_t count);
+    size_t GetEntityCount() const { return entityCount_; }
+
+    float* GetInputs(uint32_t input) { return inputs_.data() + input * stride_; }
+    uint32_t* GetCurrentActions() { return currentActions_.data(); }
+
+    // Multiplies the current action's score by 1 + momentum
+    void SetMomentum(float momentum) { momentum_ = momentum; }
+    float GetMomentum() const { return momentum_; }
+
+    void Score(JobSystem* jobs = nullptr);
+
+    // Results of the last Score(): NO_ACTION when every action scored 0
+    uint32_t GetChoice(size_t entity) const { return choices_[entity]; }
+    float GetScore(size_t entity) const { return scores_[entity]; }
+    // Scores one action for one entity with the scalar curves, for debugging displays
+    float ScoreAction(uint32_t action, size_t entity) const;
+
+private:
+    struct Consideration {
+        uint32_t input;
+        ResponseCurveType type;
+        float slope;
+        float exponent;
+        float xShift;
+        float yShift;
+        uint32_t power;                        // Polynomial exponent, rounded
+    };
+
+    struct ActionRange {
+        float weight;
+        uint32_t first;                        // Into considerations_
+        uint32_t count;
+        float compensation;                    // 1 - 1 / count
+    };
+
+    void ScoreGroups(size_t begin, size_t end);
+
+    std::vector<std::string> inputNames_;
+    std::vector<UtilityAction> actions_;
+    std::vector<ActionRange> ranges_;
+    std::vector<Consideration> considerations_;
+
+    size_t entityCount_;
+    size_t stride_;                            // Entity count padded to LANES
+    std::vector<float> inputs_;                // Column-major, stride_ per input
+    std::vector<uint32_t> currentActions_;
+    std::vector<uint32_t> choices_;
+    std::vector<float> scores_;
+    float momentum_;
+};
+
+} // namespace Nexus
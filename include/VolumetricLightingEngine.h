@@ -10,13 +10,23 @@ using namespace DirectX;
 
 namespace Nexus {
 
+class AtmosphereRenderer;
 class Camera;
+class CascadedShadowMaps;
+class ClusteredLightCuller;
+class FroxelFog;
 class Light;
+class StateCache;
 class Texture;
 
 /**
  * Advanced Volumetric Lighting Engine with full-screen volumetrics
  * Supports fog, atmospheric scattering, god rays, and particle lighting
+ *
+ * The Froxels technique renders the fog through FroxelFog: lighting is evaluated once per
+ * frustum voxel and integrated front to back, so its cost does not grow with the screen size.
+ * Atmospheric scattering goes through AtmosphereRenderer's precomputed lookup tables, which are
+ * only regenerated when the atmosphere, the sun elevation or the camera altitude change.
  */
 class VolumetricLightingEngine {
 public:
@@ -41,7 +51,7 @@ public:
         bool enableVolumetricFog = true;
         bool enableVolumetricShadows = true;
         
-        VolumetricTechnique technique = VolumetricTechnique::RayMarching;
+        VolumetricTechnique technique = VolumetricTechnique::Froxels;
         ScatteringModel scatteringModel = ScatteringModel::HenyeyGreenstein;
         
         float density = 0.02f;
@@ -107,6 +117,10 @@ public:
     const VolumetricSettings& GetVolumetricSettings() const { return volumetricSettings_; }
     const AtmosphereSettings& GetAtmosphereSettings() const { return atmosphereSettings_; }
 
+    // Lights and shadows the froxel fog reads, updated for the current frame before
+    // RenderVolumetrics; either may be null
+    void SetLightSources(const ClusteredLightCuller* lights, const CascadedShadowMaps* shadows);
+
     // Rendering
     void BeginFrame(Camera* camera);
     void RenderVolumetrics(const std::vector<std::shared_ptr<Light>>& lights);
@@ -116,6 +130,17 @@ public:
     void RenderVolumetricShadows(const std::vector<std::shared_ptr<Light>>& lights);
     void EndFrame();
 
+    // Applies the froxel fog to the width x height top-left region of target; depth is the scene's
+    // hardware depth, not bound as depth target
+    void CompositeVolumetricFog(StateCache& stateCache, ID3D11ShaderResourceView* depth,
+                                ID3D11RenderTargetView* target, UINT width, UINT height);
+    // Integrated froxel volume (see FroxelFog::GetIntegratedVolume), null unless froxels are active
+    ID3D11ShaderResourceView* GetFroxelVolume() const;
+    // Draws the sky from the tables of the last RenderAtmosphericScattering() behind everything
+    // in depthTarget, over its width x height top-left region
+    void RenderSky(StateCache& stateCache, ID3D11RenderTargetView* target, ID3D11DepthStencilView* depthTarget,
+                   UINT width, UINT height);
+
     // Advanced features
     void AddVolumetricParticleSystem(const XMFLOAT3& position, float radius, float density);
     void UpdateParticleSystems(float deltaTime);
@@ -179,10 +204,13 @@ private:
     ID3D11RenderTargetView* volumetricRTV_;
     ID3D11ShaderResourceView* volumetricSRV_;
     
-    ID3D11Texture2D* froxelTexture_;
-    ID3D11RenderTargetView* froxelRTV_;
-    ID3D11ShaderResourceView* froxelSRV_;
-    ID3D11UnorderedAccessView* froxelUAV_;
+    // Froxel technique
+    std::unique_ptr<FroxelFog> froxelFog_;
+    const ClusteredLightCuller* lightCuller_;
+    const CascadedShadowMaps* shadowMaps_;
+    XMFLOAT4X4 viewMatrix_;
+    XMFLOAT4X4 projectionMatrix_;
+    bool hasCamera_;
     
     ID3D11Texture2D* godRaysTexture_;
     ID3D11RenderTargetView* godRaysRTV_;
@@ -192,13 +220,8 @@ private:
     ID3D11RenderTargetView* atmosphereRTV_;
     ID3D11ShaderResourceView* atmosphereSRV_;
     
-    // Lookup tables
-    ID3D11Texture2D* transmittanceLUT_;
-    ID3D11ShaderResourceView* transmittanceSRV_;
-    ID3D11Texture3D* scatteringLUT_;
-    ID3D11ShaderResourceView* scatteringSRV_;
-    ID3D11Texture2D* multiScatteringLUT_;
-    ID3D11ShaderResourceView* multiScatteringSRV_;
+    // Transmittance, multiple scattering and sky-view lookup tables
+    std::unique_ptr<AtmosphereRenderer> atmosphere_;
     
     // Temporal data
     ID3D11Texture2D* previousFrameTexture_;
@@ -210,7 +233,6 @@ private:
     ID3D11Buffer* volumetricConstantBuffer_;
     ID3D11Buffer* atmosphereConstantBuffer_;
     ID3D11Buffer* godRaysConstantBuffer_;
-    ID3D11Buffer* froxelConstantBuffer_;
     
     // Shaders
     std::map<std::string, ID3D11ComputeShader*> computeShaders_;
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "Platform.h"
+#include "ResourcePool.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Nexus {
+
+class ResourceManager;
+class PhysicsEngine;
+class AIManager;
+class AIEntity;
+class NavMesh;
+class Mesh;
+class Texture;
+using MeshHandle = ResourceHandle<Mesh>;
+using TextureHandle = ResourceHandle<Texture>;
+using RigidBodyID = uintptr_t;
+
+/**
+ * Streams a level split into square grid cells around the camera and players.
+ *
+ * A world index (.world) gives the cell size and the manifest of each cell, which lists the
+ * meshes and textures it uses, its physics bodies, its navmesh tile and its AI spawns:
+ *
+ *     world 1                          mesh Rock01 rocks/rock01.obj
+ *     cellSize 64                      texture RockAlbedo rocks/rock_albedo.dds
+ *     cell 0 0 cells/0_0.cell          box 12 1 30  4 2 4  0        (position, size, mass)
+ *     cell 1 0 cells/1_0.cell          sphere 20 5 8  1  10         (position, radius, mass)
+ *                                      navmesh cells/0_0.nnav
+ *                                      agent 16 0 24
+ *
+ * Manifest and navmesh paths are relative to the index; meshes and textures go through the
+ * resource manager's paths and paks. Cells within loadRadius of a streaming source start
+ * loading: a loader thread reads the manifest and navmesh, then the resources load
+ * asynchronously. Ready cells are activated on the main thread, nearest first, creating bodies
+ * and agents until activationBudgetMs is spent, so a large cell spreads over several frames.
+ * Cells drop out only past unloadRadius, which keeps a source moving along a cell border from
+ * loading and unloading the same cells every frame.
+ *
+ * NavMesh has no tiles to stitch, so the AI uses the navmesh of the cell the primary source is
+ * in and paths end at its border.
+ *
+ * Call everything from the main thread, outside the update graph.
+ */
+class WorldPartition {
+public:
+    struct Settings {
+        float loadRadius = 128.0f;
+        float unloadRadius = 160.0f;            // Raised to loadRadius if smaller
+        float activationBudgetMs = 2.0f;        // At least one body or agent per frame
+        uint32_t maxLoadsInFlight = 4;
+    };
+
+    struct Stats {
+        uint32_t cells = 0;
+        uint32_t loading = 0;                   // Manifest or resources still loading
+        uint32_t ready = 0;                     // Loaded, waiting for activation
+        uint32_t active = 0;
+        uint32_t activatedThisFrame = 0;        // Bodies and agents
+        float activationMs = 0.0f;
+    };
+
+    WorldPartition();
+    ~WorldPartition();
+
+    // Any subsystem may be null; its part of each cell is then skipped
+    void Initialize(ResourceManager* resources, PhysicsEngine* physics, AIManager* ai);
+    void Shutdown();
+
+    // Reads a world index; closes the current world first
+    bool Open(const std::string& filename);
+    // Unloads every cell
+    void Close();
+    bool IsOpen() const { return cellSize_ > 0.0f; }
+
+    void SetSettings(const Settings& settings);
+    const Settings& GetSettings() const { return settings_; }
+
+    // Cells stream around every source; the first one set is primary and picks the AI's navmesh.
+    // Sources are also the physics engine's simulation foci. The engine keeps the camera as
+    // source 0
+    void SetStreamingSource(uint32_t id, const DirectX::XMFLOAT3& position);
+    void RemoveStreamingSource(uint32_t id);
+
+    // Once per frame: starts and cancels loads, then activates ready cells within the budget
+    void Update();
+
+    bool IsCellActive(int32_t x, int32_t z) const;
+    const Stats& GetStats() const { return stats_; }
+    float GetCellSize() const { return cellSize_; }
+
+private:
+    enum class CellState { Unloaded, Loading, Ready, Active };
+
+    struct BodyDesc {
+        bool sphere = false;
+        DirectX::XMFLOAT3 position{ 0.0f, 0.0f, 0.0f };
+        DirectX::XMFLOAT3 size{ 1.0f, 1.0f, 1.0f }; // Box size, or the radius in x
+        float mass = 0.0f;                      // 0 for static
+    };
+
+    struct ResourceDesc {
+        std::string name;
+        std::string filename;
+    };
+
+    // Filled by the loader thread, then owned by the main thread once completed
+    struct CellLoad {
+        uint64_t cellKey = 0;
+        std::string manifestPath;
+        std::string directory;                  // Of the world index, for the navmesh
+        std::string navMeshPath;
+        std::vector<ResourceDesc> meshes;
+        std::vector<ResourceDesc> textures;
+        std::vector<BodyDesc> bodies;
+        std::vector<DirectX::XMFLOAT3> agents;
+        std::shared_ptr<NavMesh> navMesh;
+        bool completed = false;                 // Off the loader thread
+        bool failed = false;
+        // Resources still loading; their callbacks run on the main thread
+        uint32_t pendingResources = 0;
+    };
+
+    struct Cell {
+        int32_t x = 0, z = 0;
+        std::string manifest;
+        CellState state = CellState::Unloaded;
+        float distance = 0.0f;                  // To the nearest source, this frame
+        std::shared_ptr<CellLoad> load;
+        std::vector<MeshHandle> meshes;
+        std::vector<TextureHandle> textures;
+        std::vector<RigidBodyID> bodies;
+        std::vector<std::shared_ptr<AIEntity>> agents;
+    };
+
+    struct Source {
+        uint32_t id;
+        DirectX::XMFLOAT3 position;
+    };
+
+    static uint64_t GetCellKey(int32_t x, int32_t z) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+    }
+    float GetDistance(const Cell& cell) const;
+    Cell* FindCell(int32_t x, int32_t z);
+
+    void RequestLoads();
+    void FinishLoads();
+    void ActivateCells();
+    void AcquireResources(Cell& cell);
+    // Creates the cell's remaining bodies and agents until the deadline; true when all are in
+    bool ActivateCell(Cell& cell, const std::chrono::steady_clock::time_point& deadline, uint32_t& created);
+    void UnloadCell(Cell& cell);
+    void UpdateNavMesh();
+
+    void LoaderThread();
+    static bool ReadManifest(CellLoad& load);
+
+    ResourceManager* resources_;
+    PhysicsEngine* physics_;
+    AIManager* ai_;
+    Settings settings_;
+    Stats stats_;
+
+    std::string directory_;
+    float cellSize_;
+    std::unordered_map<uint64_t, Cell> cells_;
+    std::vector<uint64_t> residentCells_;       // Every cell not Unloaded
+    std::vector<Source> sources_;
+    std::shared_ptr<NavMesh> currentNavMesh_;
+
+    // Loader thread
+    std::thread loaderThread_;
+    std::deque<std::shared_ptr<CellLoad>> loadQueue_;
+    std::mutex loadQueueMutex_;
+    std::condition_variable loadQueueCondition_;
+    std::vector<std::shared_ptr<CellLoad>> completedLoads_;
+    std::mutex completedMutex_;
+    bool shutdownRequested_;
+    uint32_t loadsInFlight_;                    // Queued or on the loader thread
+};
+
+} // namespace Nexus
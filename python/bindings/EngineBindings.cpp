@@ -1,15 +1,47 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include "Engine.h"
 #include "GraphicsDevice.h"
+#include "SpriteBatcher.h"
 #include "ScriptingEngine.h"
+#include "ECS.h"
+#include "ParticleSystem.h"
+#include "AnimationSystem.h"
+#include "PhysicsEngine.h"
 
 namespace py = pybind11;
 using namespace Nexus;
 
+namespace {
+// An RGB or RGBA sequence
+XMFLOAT4 ToColor(py::handle value) {
+    py::sequence sequence = py::reinterpret_borrow<py::sequence>(value);
+    if (sequence.size() != 3 && sequence.size() != 4) throw py::value_error("expected an RGB or RGBA color");
+    return XMFLOAT4(sequence[0].cast<float>(), sequence[1].cast<float>(), sequence[2].cast<float>(),
+                    sequence.size() == 4 ? sequence[3].cast<float>() : 1.0f);
+}
+
+XMFLOAT2 ToPoint(py::handle value) {
+    py::sequence sequence = py::reinterpret_borrow<py::sequence>(value);
+    if (sequence.size() != 2) throw py::value_error("expected x, y");
+    return XMFLOAT2(sequence[0].cast<float>(), sequence[1].cast<float>());
+}
+
+SpriteBatcher& Sprites(GraphicsDevice& graphics) {
+    SpriteBatcher* sprites = graphics.GetSpriteBatcher();
+    if (!sprites) throw std::runtime_error("2D rendering is unavailable");
+    return *sprites;
+}
+}
+
 // Forward declarations
 void init_math_bindings(py::module& m);
+void init_physics_bindings(py::module& m);
+void init_particle_bindings(py::module& m);
+void init_animation_bindings(py::module& m);
+void init_scene_bindings(py::module& m);
 
 PYBIND11_MODULE(nexus_engine, m) {
     m.doc() = "Nexus Game Engine Python Bindings";
@@ -17,6 +49,14 @@ PYBIND11_MODULE(nexus_engine, m) {
     // Initialize math bindings
     init_math_bindings(m);
     
+    // Engine data as NumPy views
+    init_physics_bindings(m);
+    init_particle_bindings(m);
+    init_animation_bindings(m);
+    
+    // Native GameObject and Scene behind nexus_api.py
+    init_scene_bindings(m);
+    
     // Engine class
     py::class_<Engine>(m, "Engine")
         .def(py::init<>())
@@ -31,7 +71,15 @@ PYBIND11_MODULE(nexus_engine, m) {
         .def("get_graphics", &Engine::GetGraphics, 
              py::return_value_policy::reference_internal, "Get graphics device")
         .def("get_scripting", &Engine::GetScripting,
-             py::return_value_policy::reference_internal, "Get scripting engine");
+             py::return_value_policy::reference_internal, "Get scripting engine")
+        .def("get_world", &Engine::GetWorld,
+             py::return_value_policy::reference_internal, "Get the ECS world holding physics bodies")
+        .def("get_physics", &Engine::GetPhysics,
+             py::return_value_policy::reference_internal, "Get physics engine")
+        .def("get_particles", &Engine::GetParticles,
+             py::return_value_policy::reference_internal, "Get particle system")
+        .def("get_animation", &Engine::GetAnimation,
+             py::return_value_policy::reference_internal, "Get animation system");
     
     // Graphics Device class
     py::class_<GraphicsDevice>(m, "GraphicsDevice")
@@ -42,7 +90,38 @@ PYBIND11_MODULE(nexus_engine, m) {
             XMFLOAT4 color(r, g, b, a);
             gd.Clear(color);
         }, "Clear screen with color")
-        .def("set_viewport", &GraphicsDevice::SetViewport, "Set viewport dimensions");
+        .def("set_viewport", &GraphicsDevice::SetViewport, "Set viewport dimensions")
+        // 2D batch, in pixels from the window's top-left corner, drawn over the scene each frame
+        .def("load_texture", &GraphicsDevice::LoadSprite, py::arg("filename"),
+             "Load an image into the sprite atlas; returns its texture id, 0 on failure")
+        .def("draw_sprite", [](GraphicsDevice& gd, int texture, float x, float y, float width, float height,
+                               float rotation, py::handle color, int layer) {
+            SpriteBatcher::Sprite sprite = { XMFLOAT2(x, y), XMFLOAT2(width, height), rotation, texture, layer, ToColor(color) };
+            Sprites(gd).Draw(sprite);
+        }, py::arg("texture"), py::arg("x"), py::arg("y"), py::arg("width") = 0.0f, py::arg("height") = 0.0f,
+           py::arg("rotation") = 0.0f, py::arg("color") = py::make_tuple(1.0f, 1.0f, 1.0f, 1.0f), py::arg("layer") = 0,
+           "Draw a sprite centered on x, y; a zero width or height takes the texture's")
+        .def("draw_sprites", [](GraphicsDevice& gd, py::array_t<float, py::array::c_style | py::array::forcecast> positions,
+                                int texture, py::handle size, py::handle color, int layer) {
+            if (positions.ndim() != 2 || positions.shape(1) != 2) throw py::value_error("expected an array of shape (N, 2)");
+            SpriteBatcher& sprites = Sprites(gd);
+            SpriteBatcher::Sprite sprite = { XMFLOAT2(), ToPoint(size), 0.0f, texture, layer, ToColor(color) };
+            const float* xy = positions.data();
+            for (py::ssize_t i = 0; i < positions.shape(0); ++i, xy += 2) {
+                sprite.position = XMFLOAT2(xy[0], xy[1]);
+                sprites.Draw(sprite);
+            }
+        }, py::arg("positions"), py::arg("texture") = 0, py::arg("size") = py::make_tuple(0.0f, 0.0f),
+           py::arg("color") = py::make_tuple(1.0f, 1.0f, 1.0f, 1.0f), py::arg("layer") = 0,
+           "Draw one texture at every center of an (N, 2) array without a call per sprite")
+        .def("draw_line", [](GraphicsDevice& gd, py::handle start, py::handle end, py::handle color, float thickness, int layer) {
+            Sprites(gd).DrawLine(ToPoint(start), ToPoint(end), thickness, ToColor(color), layer);
+        }, py::arg("start"), py::arg("end"), py::arg("color") = py::make_tuple(1.0f, 1.0f, 1.0f, 1.0f),
+           py::arg("thickness") = 1.0f, py::arg("layer") = 0)
+        .def("draw_text", [](GraphicsDevice& gd, const std::string& text, float x, float y, py::handle color, float scale, int layer) {
+            Sprites(gd).DrawString(text.c_str(), x, y, scale, ToColor(color), layer);
+        }, py::arg("text"), py::arg("x"), py::arg("y"), py::arg("color") = py::make_tuple(1.0f, 1.0f, 1.0f, 1.0f),
+           py::arg("scale") = 1.0f, py::arg("layer") = 0, "Draw text with its top-left corner at x, y");
     
     // Scripting Engine class
     py::class_<ScriptingEngine>(m, "ScriptingEngine")
@@ -1,5 +1,8 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include "BatchMath.h"
+#include <cstring>
 
 #ifdef NEXUS_DIRECTX_SUPPORT
 #include <DirectXMath.h>
@@ -7,6 +10,98 @@ using namespace DirectX;
 #endif
 
 namespace py = pybind11;
+using Nexus::BatchMath;
+
+namespace {
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+// Element count of an (N, width) array
+size_t Rows(const FloatArray& array, size_t width, const char* name) {
+    if (array.ndim() == 2 && static_cast<size_t>(array.shape(1)) == width) return static_cast<size_t>(array.shape(0));
+    throw py::value_error(std::string(name) + " must have shape (N, " + std::to_string(width) + ")");
+}
+
+void CheckShape(const FloatArray& array, size_t rows, size_t columns, const char* name) {
+    if (array.ndim() != 2 || static_cast<size_t>(array.shape(0)) != rows || static_cast<size_t>(array.shape(1)) != columns) {
+        throw py::value_error(std::string(name) + " must have shape (" + std::to_string(rows) + ", " +
+                              std::to_string(columns) + ")");
+    }
+}
+
+template <typename T>
+const T* As(const FloatArray& array) { return reinterpret_cast<const T*>(array.data()); }
+
+template <typename T>
+T* As(py::array_t<float>& array) { return reinterpret_cast<T*>(array.mutable_data()); }
+
+// Whole-array math on BatchMath. Arrays go in as float32 (converted if needed) and results come
+// back as new arrays; the GIL is released while the math runs
+void init_batch_math_bindings(py::module& m) {
+    py::module batch = m.def_submodule("batch", "Math over NumPy arrays, one call for all elements");
+
+    batch.def("transform_points", [](const FloatArray& matrix, const FloatArray& points) {
+        CheckShape(matrix, 4, 4, "matrix");
+        const size_t count = Rows(points, 3, "points");
+        py::array_t<float> result({ count, size_t(3) });
+        DirectX::XMFLOAT3* output = As<DirectX::XMFLOAT3>(result);
+        py::gil_scoped_release release;
+        BatchMath::TransformPoints(*As<DirectX::XMFLOAT4X4>(matrix), As<DirectX::XMFLOAT3>(points), output, count);
+        return result;
+    }, py::arg("matrix"), py::arg("points"), "(N, 3) points times a row-major 4x4 matrix (p * M), affine");
+
+    batch.def("normalize", [](const FloatArray& vectors) {
+        const size_t count = Rows(vectors, 3, "vectors");
+        py::array_t<float> result({ count, size_t(3) });
+        DirectX::XMFLOAT3* output = As<DirectX::XMFLOAT3>(result);
+        py::gil_scoped_release release;
+        BatchMath::NormalizeVectors(As<DirectX::XMFLOAT3>(vectors), output, count);
+        return result;
+    }, py::arg("vectors"), "(N, 3) vectors scaled to unit length; zero vectors stay zero");
+
+    batch.def("slerp", [](const FloatArray& from, const FloatArray& to, const FloatArray& t) {
+        const size_t count = Rows(from, 4, "from");
+        CheckShape(to, count, 4, "to");
+        if (t.size() != 1 && (t.ndim() != 1 || static_cast<size_t>(t.shape(0)) != count)) {
+            throw py::value_error("t must be a scalar or have shape (N,)");
+        }
+        py::array_t<float> result({ count, size_t(4) });
+        DirectX::XMFLOAT4* output = As<DirectX::XMFLOAT4>(result);
+        py::gil_scoped_release release;
+        if (t.size() == 1 && count != 1) {
+            BatchMath::SlerpQuaternions(As<DirectX::XMFLOAT4>(from), As<DirectX::XMFLOAT4>(to), *t.data(), output, count);
+        } else {
+            BatchMath::SlerpQuaternions(As<DirectX::XMFLOAT4>(from), As<DirectX::XMFLOAT4>(to), t.data(), output, count);
+        }
+        return result;
+    }, py::arg("from_"), py::arg("to"), py::arg("t"),
+       "Slerp of (N, 4) unit quaternion pairs (x, y, z, w) by t in [0, 1], a scalar or one per pair");
+
+    batch.def("frustum_from_view_projection", [](const FloatArray& viewProjection) {
+        CheckShape(viewProjection, 4, 4, "view_projection");
+        const Nexus::Frustum frustum = Nexus::Frustum::FromViewProjection(
+            DirectX::XMLoadFloat4x4(As<DirectX::XMFLOAT4X4>(viewProjection)));
+        py::array_t<float> result({ size_t(Nexus::Frustum::PLANE_COUNT), size_t(4) });
+        std::memcpy(result.mutable_data(), frustum.planes, sizeof(frustum.planes));
+        return result;
+    }, py::arg("view_projection"), "(6, 4) planes of a row-major view-projection matrix, for cull_boxes");
+
+    batch.def("cull_boxes", [](const FloatArray& planes, const FloatArray& boxes) {
+        CheckShape(planes, Nexus::Frustum::PLANE_COUNT, 4, "frustum");
+        const size_t count = Rows(boxes, 6, "boxes");
+        Nexus::Frustum frustum;
+        std::memcpy(frustum.planes, planes.data(), sizeof(frustum.planes));
+        py::array_t<bool> result(count);
+        uint8_t* visible = reinterpret_cast<uint8_t*>(result.mutable_data());
+        py::gil_scoped_release release;
+        BatchMath::CullBoxes(frustum, As<Nexus::AABB>(boxes), count, visible);
+        return result;
+    }, py::arg("frustum"), py::arg("boxes"), "Which (N, 6) boxes (min xyz, max xyz) touch the frustum, as bools");
+
+    batch.def("instruction_set", []() {
+        return BatchMath::GetInstructionSetName(BatchMath::GetInstructionSet());
+    }, "The SIMD path in use: AVX2, SSE4.1 or scalar");
+}
+}
 
 // Math-related bindings
 void init_math_bindings(py::module& m) {
@@ -99,4 +194,6 @@ void init_math_bindings(py::module& m) {
             m[i] = val;
         });
 #endif
+
+    init_batch_math_bindings(m);
 }
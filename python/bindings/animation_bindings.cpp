@@ -1,3 +1,40 @@
-// Auto-generated placeholder for bindings/animation_bindings.cpp
 #include <pybind11/pybind11.h>
-void register__bindings(pybind11::module& m) {}
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include "AnimationSystem.h"
+
+namespace py = pybind11;
+using namespace Nexus;
+
+namespace {
+using Skeleton = AnimationSystem::Skeleton;
+using Pose = AnimationSystem::Pose;
+
+py::array_t<float> PoseView(py::object self, Pose::Stream first, size_t rows) {
+    Pose& pose = self.cast<Skeleton&>().pose;
+    return py::array_t<float>({ rows, pose.boneCount }, { pose.stride * sizeof(float), sizeof(float) }, pose[first], self);
+}
+}
+
+// Bone data as NumPy views, without a copy. skinning_matrices is (bones, 4, 4) of row-vector
+// matrices as uploaded for skinning; the pose streams are (components, bones) of the local pose
+// the animation system blends into, read by the next bone update. Valid until the skeleton is rebuilt
+void init_animation_bindings(py::module& m) {
+    py::class_<Skeleton, std::shared_ptr<Skeleton>>(m, "Skeleton")
+        .def_readonly("name", &Skeleton::name)
+        .def_property_readonly("bone_count", [](const Skeleton& skeleton) { return skeleton.bones.size(); })
+        .def("find_bone_index", &Skeleton::FindBoneIndex)
+        .def_property_readonly("skinning_matrices", [](py::object self) {
+            auto& matrices = self.cast<Skeleton&>().skinningMatrices;
+            const size_t row = 4 * sizeof(float);
+            return py::array_t<float>({ matrices.size(), size_t(4), size_t(4) }, { 4 * row, row, sizeof(float) },
+                                      matrices.empty() ? nullptr : &matrices[0]._11, self);
+        })
+        .def_property_readonly("pose_translations", [](py::object self) { return PoseView(self, Pose::TRANSLATION_X, 3); })
+        .def_property_readonly("pose_rotations", [](py::object self) { return PoseView(self, Pose::ROTATION_X, 4); })
+        .def_property_readonly("pose_scales", [](py::object self) { return PoseView(self, Pose::SCALE_X, 3); })
+        .def("update_bone_transforms", &Skeleton::UpdateBoneTransforms);
+
+    py::class_<AnimationSystem>(m, "AnimationSystem")
+        .def("get_skeleton", &AnimationSystem::GetSkeleton);
+}
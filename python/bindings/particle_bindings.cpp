@@ -1,3 +1,44 @@
-// Auto-generated placeholder for bindings/particle_bindings.cpp
 #include <pybind11/pybind11.h>
-void register__bindings(pybind11::module& m) {}
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include "ParticleSystem.h"
+
+namespace py = pybind11;
+using namespace Nexus;
+
+namespace {
+using Emitter = ParticleSystem::ParticleEmitter;
+using Streams = ParticleSystem::ParticleStreams;
+
+// rows streams from first on, over the live particles, read in place. The emitter's Python
+// object is the base, so its block outlives the view
+py::array_t<float> StreamView(py::object self, Streams::Stream first, size_t rows) {
+    Streams& streams = self.cast<Emitter&>().particles;
+    if (rows == 1) {
+        return py::array_t<float>({ streams.count }, { sizeof(float) }, streams[first], self);
+    }
+    return py::array_t<float>({ rows, streams.count }, { streams.stride * sizeof(float), sizeof(float) },
+                              streams[first], self);
+}
+}
+
+// A CPU emitter's particles as NumPy views of its streams, one row per component: positions is
+// (3, count), so positions.T gives (count, 3). Writes land in the simulation. Views are valid until
+// the next update, which changes the count and reorders particles; GPU emitters have none
+void init_particle_bindings(py::module& m) {
+    py::class_<Emitter, std::shared_ptr<Emitter>>(m, "ParticleEmitter")
+        .def_readonly("name", &Emitter::name)
+        .def_readwrite("is_active", &Emitter::isActive)
+        .def_property_readonly("count", [](const Emitter& emitter) { return emitter.particles.count; })
+        .def_property_readonly("positions", [](py::object self) { return StreamView(self, Streams::POSITION_X, 3); })
+        .def_property_readonly("velocities", [](py::object self) { return StreamView(self, Streams::VELOCITY_X, 3); })
+        .def_property_readonly("colors", [](py::object self) { return StreamView(self, Streams::COLOR_R, 4); })
+        .def_property_readonly("sizes", [](py::object self) { return StreamView(self, Streams::SIZE_X, 2); })
+        .def_property_readonly("rotations", [](py::object self) { return StreamView(self, Streams::ROTATION, 1); })
+        .def_property_readonly("life", [](py::object self) { return StreamView(self, Streams::LIFE, 1); });
+
+    py::class_<ParticleSystem>(m, "ParticleSystem")
+        .def("get_emitter", py::overload_cast<const std::string&>(&ParticleSystem::GetEmitter))
+        .def("get_total_particle_count", &ParticleSystem::GetTotalParticleCount)
+        .def("get_active_emitter_count", &ParticleSystem::GetActiveEmitterCount);
+}
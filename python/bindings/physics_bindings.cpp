@@ -1,3 +1,156 @@
-// Auto-generated placeholder for bindings/physics_bindings.cpp
 #include <pybind11/pybind11.h>
-void register__bindings(pybind11::module& m) {}
+#include <pybind11/numpy.h>
+#include "ECS.h"
+#include "Components.h"
+#include "PhysicsEngine.h"
+#include <cstring>
+#include <tuple>
+
+namespace py = pybind11;
+using namespace Nexus;
+
+namespace {
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+using CharacterArray = py::array_t<CharacterID, py::array::c_style | py::array::forcecast>;
+
+PhysicsVector3 ToVector3(const py::sequence& values) {
+    if (py::len(values) != 3) throw py::value_error("expected x, y, z");
+    return PhysicsVector3(values[0].cast<float>(), values[1].cast<float>(), values[2].cast<float>());
+}
+
+// count elements of width floats each, strided through an array of Component, read in place.
+// base keeps the owner alive while the view is
+template <typename Component>
+py::array_t<float> FieldView(const Component* array, const float* field, size_t count, size_t width, py::handle base) {
+    return py::array_t<float>({ count, width }, { sizeof(Component), sizeof(float) }, field, base);
+}
+
+template <typename Component>
+Component* Select(TransformComponent* transforms, PhysicsBodyComponent* bodies) {
+    return std::get<Component*>(std::make_tuple(transforms, bodies));
+}
+
+// One field of every awake body into an (N, width) array, in the order of body_entities()
+template <typename Component, typename Field>
+py::array_t<float> GatherBodies(const World& world, Field Component::*field) {
+    constexpr size_t width = sizeof(Field) / sizeof(float);
+    py::array_t<float> result({ world.Count<TransformComponent, PhysicsBodyComponent>(), width });
+    float* out = result.mutable_data();
+    world.ForEachChunk<TransformComponent, PhysicsBodyComponent>(
+        [&](size_t count, const Entity*, TransformComponent* transforms, PhysicsBodyComponent* bodies) {
+            const Component* components = Select<Component>(transforms, bodies);
+            for (size_t i = 0; i < count; ++i, out += width) std::memcpy(out, &(components[i].*field), sizeof(Field));
+        });
+    return result;
+}
+
+template <typename Component, typename Field>
+void ScatterBodies(World& world, Field Component::*field, const FloatArray& values) {
+    constexpr size_t width = sizeof(Field) / sizeof(float);
+    const size_t bodies = world.Count<TransformComponent, PhysicsBodyComponent>();
+    if (values.ndim() != 2 || static_cast<size_t>(values.shape(0)) != bodies || static_cast<size_t>(values.shape(1)) != width) {
+        throw py::value_error("expected an array of shape (" + std::to_string(bodies) + ", " + std::to_string(width) + ")");
+    }
+    const float* in = values.data();
+    world.ForEachChunk<TransformComponent, PhysicsBodyComponent>(
+        [&](size_t count, const Entity*, TransformComponent* transforms, PhysicsBodyComponent* bodyArray) {
+            Component* components = Select<Component>(transforms, bodyArray);
+            for (size_t i = 0; i < count; ++i, in += width) std::memcpy(&(components[i].*field), in, sizeof(Field));
+        });
+}
+}
+
+// Awake rigid bodies as NumPy arrays. Chunk views alias the ECS storage; they and the body
+// order are only valid until the next structural change, and only between simulation steps
+void init_physics_bindings(py::module& m) {
+    py::class_<World>(m, "World")
+        .def("get_entity_count", &World::GetEntityCount)
+        .def("get_body_count", [](const World& world) { return world.Count<TransformComponent, PhysicsBodyComponent>(); })
+        .def("transform_chunks", [](py::object self) {
+            World& world = self.cast<World&>();
+            py::list chunks;
+            world.ForEachChunk<TransformComponent, PhysicsBodyComponent>(
+                [&](size_t count, const Entity* entities, TransformComponent* transforms, PhysicsBodyComponent* bodies) {
+                    py::array_t<uint32_t> ids({ count, size_t(2) }, { sizeof(Entity), sizeof(uint32_t) },
+                                              &entities->index, self);
+                    ids.attr("flags").attr("writeable") = false;
+                    py::dict chunk;
+                    chunk["entities"] = ids;
+                    chunk["position"] = FieldView(transforms, &transforms->position.x, count, 3, self);
+                    chunk["rotation"] = FieldView(transforms, &transforms->rotation.x, count, 4, self);
+                    chunk["velocity"] = FieldView(bodies, &bodies->velocity.x, count, 3, self);
+                    chunks.append(chunk);
+                });
+            return chunks;
+        }, "Per ECS chunk: entities (n, 2) index and generation, position (n, 3), rotation (n, 4) and "
+           "velocity (n, 3), as writable views without a copy")
+        .def("body_entities", [](const World& world) {
+            py::array_t<uint32_t> result({ world.Count<TransformComponent, PhysicsBodyComponent>(), size_t(2) });
+            uint32_t* out = result.mutable_data();
+            world.ForEachChunk<TransformComponent, PhysicsBodyComponent>(
+                [&](size_t count, const Entity* entities, TransformComponent*, PhysicsBodyComponent*) {
+                    for (size_t i = 0; i < count; ++i) {
+                        *out++ = entities[i].index;
+                        *out++ = entities[i].generation;
+                    }
+                });
+            return result;
+        }, "Index and generation of every awake body, in the order of the bulk getters and setters")
+        .def("get_body_positions", [](const World& world) { return GatherBodies(world, &TransformComponent::position); })
+        .def("get_body_rotations", [](const World& world) { return GatherBodies(world, &TransformComponent::rotation); })
+        .def("get_body_velocities", [](const World& world) { return GatherBodies(world, &PhysicsBodyComponent::velocity); })
+        .def("set_body_positions", [](World& world, const FloatArray& positions) {
+            // Teleports: the previous position moves too, so nothing interpolates across the jump
+            ScatterBodies(world, &TransformComponent::position, positions);
+            ScatterBodies(world, &TransformComponent::previousPosition, positions);
+        })
+        .def("set_body_rotations", [](World& world, const FloatArray& rotations) {
+            ScatterBodies(world, &TransformComponent::rotation, rotations);
+        })
+        .def("set_body_velocities", [](World& world, const FloatArray& velocities) {
+            ScatterBodies(world, &PhysicsBodyComponent::velocity, velocities);
+        });
+    
+    // Bodies to stand on and character controllers; positions are centers
+    py::class_<PhysicsEngine>(m, "PhysicsEngine")
+        .def("create_box", [](PhysicsEngine& physics, const py::sequence& position, const py::sequence& size, float mass) {
+            PhysicsTransform transform;
+            transform.position = ToVector3(position);
+            return physics.CreateRigidBody(CollisionShape::CreateBox(ToVector3(size)), transform, mass);
+        }, py::arg("position"), py::arg("size"), py::arg("mass") = 0.0f, "A box body; mass 0 makes it static")
+        .def("create_character", [](PhysicsEngine& physics, const py::sequence& position, float radius, float height,
+                                    float stepHeight, float maxSlope) {
+            PhysicsEngine::CharacterSettings settings;
+            settings.radius = radius;
+            settings.height = height;
+            settings.stepHeight = stepHeight;
+            settings.maxSlope = maxSlope;
+            return physics.CreateCharacter(settings, ToVector3(position));
+        }, py::arg("position"), py::arg("radius") = 0.4f, py::arg("height") = 1.8f, py::arg("step_height") = 0.35f,
+           py::arg("max_slope") = 0.785f)
+        .def("destroy_character", &PhysicsEngine::DestroyCharacter)
+        .def("set_character_position", [](PhysicsEngine& physics, CharacterID character, const py::sequence& position) {
+            physics.SetCharacterPosition(character, ToVector3(position));
+        }, "Teleports without sweeping")
+        .def("move_characters", [](PhysicsEngine& physics, const CharacterArray& characters,
+                                   const FloatArray& displacements, float deltaTime) {
+            const size_t count = static_cast<size_t>(characters.size());
+            if (displacements.ndim() != 2 || static_cast<size_t>(displacements.shape(0)) != count ||
+                displacements.shape(1) != 3) {
+                throw py::value_error("expected displacements of shape (" + std::to_string(count) + ", 3)");
+            }
+            physics.MoveCharacters(characters.data(), reinterpret_cast<const PhysicsVector3*>(displacements.data()),
+                                   count, deltaTime);
+        }, py::arg("characters"), py::arg("displacements"), py::arg("delta_time"),
+           "Moves characters[i] by row i of an (N, 3) array, all in one batch")
+        .def("get_character", [](const PhysicsEngine& physics, CharacterID character) -> py::object {
+            PhysicsEngine::CharacterState state;
+            if (!physics.GetCharacterState(character, state)) return py::none();
+            py::dict result;
+            result["position"] = py::make_tuple(state.position.x, state.position.y, state.position.z);
+            result["velocity"] = py::make_tuple(state.velocity.x, state.velocity.y, state.velocity.z);
+            result["ground_normal"] = py::make_tuple(state.groundNormal.x, state.groundNormal.y, state.groundNormal.z);
+            result["grounded"] = state.grounded;
+            return result;
+        }, "position, velocity, ground_normal and grounded, or None for an unknown character");
+}
@@ -0,0 +1,214 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include "ScriptScene.h"
+#include "GraphicsDevice.h"
+
+namespace py = pybind11;
+using namespace Nexus;
+using namespace DirectX;
+
+namespace {
+// Shared by every scene, so an object keeps its transform when it moves between them
+ScriptObjectStore& Store() {
+    static ScriptObjectStore store;
+    return store;
+}
+
+enum class Field : uint8_t { Position, Rotation, Scale };
+
+XMFLOAT3& FieldOf(uint32_t slot, Field field) {
+    switch (field) {
+    case Field::Rotation: return Store().Rotation(slot);
+    case Field::Scale: return Store().Scale(slot);
+    default: return Store().Position(slot);
+    }
+}
+
+struct GameObject {
+    explicit GameObject(std::string name) : name(std::move(name)), slot(Store().Allocate()) {}
+    ~GameObject() { Store().Free(slot); }
+    GameObject(const GameObject&) = delete;
+    GameObject& operator=(const GameObject&) = delete;
+
+    std::string name;
+    uint32_t slot;
+};
+
+// A transform vector as a view of the object's native storage: obj.position.x += 1 writes through.
+// Holds the object, so a view kept by a script stays valid
+struct Float3Ref {
+    py::object owner;
+    uint32_t slot;
+    Field field;
+
+    XMFLOAT3& Get() const { return FieldOf(slot, field); }
+    float& At(py::ssize_t index) const {
+        if (index < 0) index += 3;
+        if (index < 0 || index >= 3) throw py::index_error("vector index out of range");
+        return (&Get().x)[index];
+    }
+};
+
+// Float3Ref, anything with x, y and z (Vector3), or a sequence of three numbers
+XMFLOAT3 ToFloat3(py::handle value) {
+    if (py::isinstance<Float3Ref>(value)) return value.cast<const Float3Ref&>().Get();
+    if (py::hasattr(value, "x")) {
+        return XMFLOAT3(value.attr("x").cast<float>(), value.attr("y").cast<float>(), value.attr("z").cast<float>());
+    }
+    py::sequence sequence = py::reinterpret_borrow<py::sequence>(value);
+    if (sequence.size() != 3) throw py::value_error("expected three components");
+    return XMFLOAT3(sequence[0].cast<float>(), sequence[1].cast<float>(), sequence[2].cast<float>());
+}
+
+XMFLOAT4 ToColor(py::handle value) {
+    py::sequence sequence = py::reinterpret_borrow<py::sequence>(value);
+    if (sequence.size() != 3 && sequence.size() != 4) throw py::value_error("expected an RGB or RGBA color");
+    return XMFLOAT4(sequence[0].cast<float>(), sequence[1].cast<float>(), sequence[2].cast<float>(),
+                    sequence.size() == 4 ? sequence[3].cast<float>() : 1.0f);
+}
+
+py::cpp_function FieldProperty(Field field) {
+    return py::cpp_function([field](py::object self) {
+        return Float3Ref{ self, self.cast<GameObject&>().slot, field };
+    });
+}
+
+py::cpp_function FieldSetter(Field field) {
+    return py::cpp_function([field](GameObject& object, py::handle value) {
+        FieldOf(object.slot, field) = ToFloat3(value);
+    });
+}
+
+// Whether the object's class, or the object itself, replaces GameObject's callback
+bool Overrides(py::handle object, const char* name) {
+    py::object dict = py::getattr(object, "__dict__", py::none());
+    if (!dict.is_none() && dict.contains(name)) return true;
+
+    const py::type base = py::type::of<GameObject>();
+    const py::tuple mro = py::type::of(object).attr("__mro__");
+    for (py::handle type : mro) {
+        if (type.is(base)) return false;
+        if (type.attr("__dict__").contains(name)) return true;
+    }
+    return false;
+}
+
+class Scene {
+public:
+    explicit Scene(std::string name) : name(std::move(name)), scene_(Store()) {}
+
+    void Add(py::object object) {
+        const GameObject& native = object.cast<const GameObject&>();
+        uint8_t callbacks = 0;
+        if (Overrides(object, "update")) callbacks |= ScriptScene::CALLBACK_UPDATE;
+        if (Overrides(object, "render")) callbacks |= ScriptScene::CALLBACK_RENDER;
+        if (scene_.Add(native.slot, callbacks, object.ptr())) members_[py::int_(native.slot)] = object;
+    }
+
+    void Remove(py::object object) {
+        const uint32_t slot = object.cast<const GameObject&>().slot;
+        if (scene_.Remove(slot)) PyDict_DelItem(members_.ptr(), py::int_(slot).ptr());
+    }
+
+    void Clear() {
+        scene_.Clear();
+        members_.clear();
+    }
+
+    bool Contains(py::object object) const {
+        return py::isinstance<GameObject>(object) && scene_.Contains(object.cast<const GameObject&>().slot);
+    }
+
+    py::list Objects() const {
+        py::list objects;
+        scene_.ForEachMember([&](void* object) { objects.append(py::handle(static_cast<PyObject*>(object))); });
+        return objects;
+    }
+
+    size_t Count() const { return scene_.GetMemberCount(); }
+
+    void Update(float deltaTime) {
+        scene_.ForEach(ScriptScene::CALLBACK_UPDATE, [&](void* object) {
+            py::handle(static_cast<PyObject*>(object)).attr("update")(deltaTime);
+        });
+    }
+
+    void Render(py::object graphics) {
+        scene_.SubmitBatches(graphics.cast<GraphicsDevice&>());
+        scene_.ForEach(ScriptScene::CALLBACK_RENDER, [&](void* object) {
+            py::handle(static_cast<PyObject*>(object)).attr("render")(graphics);
+        });
+    }
+
+    std::string name;
+
+private:
+    ScriptScene scene_;
+    py::dict members_;      // Keeps members alive, by slot
+};
+}
+
+// GameObject and Scene from nexus_api.py, with transforms and shapes in native storage. Scene
+// calls update and render only on objects whose class overrides them, and draws objects given a
+// shape with set_box or set_sphere in one batch per shape without calling into Python. Subclasses
+// must call GameObject.__init__
+void init_scene_bindings(py::module& m) {
+    py::class_<Float3Ref>(m, "Float3Ref")
+        .def_property("x", [](const Float3Ref& v) { return v.Get().x; }, [](const Float3Ref& v, float x) { v.Get().x = x; })
+        .def_property("y", [](const Float3Ref& v) { return v.Get().y; }, [](const Float3Ref& v, float y) { v.Get().y = y; })
+        .def_property("z", [](const Float3Ref& v) { return v.Get().z; }, [](const Float3Ref& v, float z) { v.Get().z = z; })
+        .def("__len__", [](const Float3Ref&) { return 3; })
+        .def("__getitem__", [](const Float3Ref& v, py::ssize_t i) { return v.At(i); })
+        .def("__setitem__", [](const Float3Ref& v, py::ssize_t i, float value) { v.At(i) = value; })
+        .def("__iter__", [](const Float3Ref& v) {
+            const XMFLOAT3& value = v.Get();
+            return py::iter(py::make_tuple(value.x, value.y, value.z));
+        })
+        .def("__repr__", [](const Float3Ref& v) {
+            const XMFLOAT3& value = v.Get();
+            return "(" + std::to_string(value.x) + ", " + std::to_string(value.y) + ", " + std::to_string(value.z) + ")";
+        });
+
+    py::class_<GameObject>(m, "GameObject", py::dynamic_attr())
+        .def(py::init<std::string>(), py::arg("name") = "GameObject")
+        .def_readwrite("name", &GameObject::name)
+        .def_property("position", FieldProperty(Field::Position), FieldSetter(Field::Position))
+        .def_property("rotation", FieldProperty(Field::Rotation), FieldSetter(Field::Rotation))
+        .def_property("scale", FieldProperty(Field::Scale), FieldSetter(Field::Scale))
+        .def_property("active",
+            [](const GameObject& object) { return Store().IsActive(object.slot); },
+            [](const GameObject& object, bool active) { Store().SetActive(object.slot, active); })
+        .def_property("color",
+            [](const GameObject& object) {
+                const XMFLOAT4& color = Store().Color(object.slot);
+                return py::make_tuple(color.x, color.y, color.z, color.w);
+            },
+            [](const GameObject& object, py::handle color) { Store().Color(object.slot) = ToColor(color); })
+        .def("set_box", [](const GameObject& object, py::handle size, py::handle color) {
+            Store().Size(object.slot) = ToFloat3(size);
+            if (!color.is_none()) Store().Color(object.slot) = ToColor(color);
+            Store().SetShape(object.slot, ScriptObjectStore::Shape::Box);
+        }, py::arg("size"), py::arg("color") = py::none(), "Draw as a box of size, scaled, by the scene's batch")
+        .def("set_sphere", [](const GameObject& object, float radius, py::handle color) {
+            Store().Size(object.slot) = XMFLOAT3(radius, radius, radius);
+            if (!color.is_none()) Store().Color(object.slot) = ToColor(color);
+            Store().SetShape(object.slot, ScriptObjectStore::Shape::Sphere);
+        }, py::arg("radius"), py::arg("color") = py::none(), "Draw as a sphere of radius, scaled by scale.x, by the scene's batch")
+        .def("clear_shape", [](const GameObject& object) {
+            Store().SetShape(object.slot, ScriptObjectStore::Shape::None);
+        })
+        .def("update", [](py::object, float) {}, py::arg("delta_time"), "Override to add update logic")
+        .def("render", [](py::object, py::object) {}, py::arg("graphics"), "Override to add custom rendering");
+
+    py::class_<Scene>(m, "Scene")
+        .def(py::init<std::string>(), py::arg("name") = "Scene")
+        .def_readwrite("name", &Scene::name)
+        .def("add_object", &Scene::Add, "Add a game object to the scene")
+        .def("remove_object", &Scene::Remove, "Remove a game object from the scene")
+        .def("clear", &Scene::Clear)
+        .def_property_readonly("objects", &Scene::Objects, "The scene's objects, in the order they were added")
+        .def("__len__", &Scene::Count)
+        .def("__contains__", &Scene::Contains)
+        .def("update", &Scene::Update, "Update active objects that override update")
+        .def("render", &Scene::Render, "Draw active shaped objects, then render the ones that override render");
+}
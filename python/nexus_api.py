@@ -9,51 +9,11 @@ import nexus_engine as engine_core
 import time
 import os
 
-class GameObject:
-    """Base class for all game objects"""
-    
-    def __init__(self, name="GameObject"):
-        self.name = name
-        self.position = [0.0, 0.0, 0.0]
-        self.rotation = [0.0, 0.0, 0.0]
-        self.scale = [1.0, 1.0, 1.0]
-        self.active = True
-        
-    def update(self, delta_time):
-        """Override this method to add custom update logic"""
-        pass
-        
-    def render(self, graphics):
-        """Override this method to add custom rendering"""
-        pass
-
-class Scene:
-    """Scene management for game objects"""
-    
-    def __init__(self, name="Scene"):
-        self.name = name
-        self.objects = []
-        
-    def add_object(self, obj):
-        """Add a game object to the scene"""
-        self.objects.append(obj)
-        
-    def remove_object(self, obj):
-        """Remove a game object from the scene"""
-        if obj in self.objects:
-            self.objects.remove(obj)
-            
-    def update(self, delta_time):
-        """Update all active objects in the scene"""
-        for obj in self.objects:
-            if obj.active:
-                obj.update(delta_time)
-                
-    def render(self, graphics):
-        """Render all active objects in the scene"""
-        for obj in self.objects:
-            if obj.active:
-                obj.render(graphics)
+# GameObject and Scene are native: transforms live in engine storage, a scene calls update and
+# render only on objects whose class overrides them, and objects given a shape with set_box or
+# set_sphere are drawn in batches. Subclasses must call super().__init__(name)
+GameObject = engine_core.GameObject
+Scene = engine_core.Scene
 
 class GameApplication:
     """Main application class for Nexus games"""
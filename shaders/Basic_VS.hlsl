@@ -1,15 +1,23 @@
+// keywords: COMPRESSED_VERTEX
 cbuffer ConstantBuffer : register(b0)
 {
     matrix World;
     matrix View;
     matrix Projection;
     float4 Color;
+    float4 positionOffset;   // Compressed position decode, see Shader::SetPositionDequantization
+    float4 positionScale;
 };
 
 struct VertexInput
 {
+#ifdef COMPRESSED_VERTEX
+    float4 position : POSITION;        // UNORM16 across the mesh bounds
+    float4 normalTangent : NORMAL;     // Octahedral normal xy, tangent xy
+#else
     float3 position : POSITION;
     float3 normal : NORMAL;
+#endif
 };
 
 struct VertexOutput
@@ -19,17 +27,37 @@ struct VertexOutput
     float4 color : COLOR;
 };
 
+#ifdef COMPRESSED_VERTEX
+// Inverse of the octahedral encoding in MeshImporter::CompressVertices
+float3 DecodeOctahedral(float2 encoded)
+{
+    float2 e = encoded * 2.0f - 1.0f;
+    float3 v = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.xy += (v.xy >= 0.0f) ? -t : t;
+    return normalize(v);
+}
+#endif
+
 VertexOutput main(VertexInput input)
 {
     VertexOutput output;
     
+#ifdef COMPRESSED_VERTEX
+    float3 position = positionOffset.xyz + input.position.xyz * positionScale.xyz;
+    float3 normal = DecodeOctahedral(input.normalTangent.xy);
+#else
+    float3 position = input.position;
+    float3 normal = input.normal;
+#endif
+    
     // Transform vertex position
-    float4 worldPos = mul(float4(input.position, 1.0f), World);
+    float4 worldPos = mul(float4(position, 1.0f), World);
     float4 viewPos = mul(worldPos, View);
     output.position = mul(viewPos, Projection);
     
     // Transform normal
-    output.normal = mul(input.normal, (float3x3)World);
+    output.normal = mul(normal, (float3x3)World);
     output.normal = normalize(output.normal);
     
     // Pass through color
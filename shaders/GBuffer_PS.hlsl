@@ -0,0 +1,226 @@
+// Deferred G-buffer Pixel Shader, paired with PBR_VS; lit by DeferredRenderer
+// keywords: ALBEDO_MAP NORMAL_MAP METALLIC_MAP ROUGHNESS_MAP AO_MAP EMISSIVE_MAP VIRTUAL_TEXTURE
+struct PS_INPUT {
+    float4 position : SV_POSITION;
+    float3 worldPos : TEXCOORD0;
+    float3 normal : TEXCOORD1;
+    float3 tangent : TEXCOORD2;
+    float3 bitangent : TEXCOORD3;
+    float2 texCoord : TEXCOORD4;
+    float4 color : TEXCOORD5;
+    float3 viewDir : TEXCOORD6;
+    float4 lightSpacePos : TEXCOORD7;
+};
+
+// Layout documented in DeferredRenderer.h
+struct GBUFFER_OUTPUT {
+    float4 albedo : SV_Target0;      // RGBA8 sRGB: albedo, ambient occlusion
+    float2 normal : SV_Target1;      // RG16 snorm: octahedral world normal
+    float4 material : SV_Target2;    // RGBA8: roughness, metalness, material ID / 255, emissive scale
+};
+
+// PBR Textures, same slots as PBR_PS
+Texture2D albedoMap : register(t0);
+Texture2D normalMap : register(t1);
+Texture2D metallicMap : register(t2);
+Texture2D roughnessMap : register(t3);
+Texture2D aoMap : register(t4);
+Texture2D emissiveMap : register(t5);
+
+SamplerState defaultSampler : register(s0);
+
+// Clustered decals, see DecalSystem; binned into the same clusters as the lights
+struct ClusterDecal {
+    float4 worldToDecal[3];         // Rows of the map into the [-1, 1] box
+    float3 axis;                    // Surfaces turned away from it fade out
+    float layer;
+    float4 uvRect;                  // Offset and scale within the layer
+    float4 color;                   // Tint, and coverage in alpha
+    float roughness;                // Negative keeps the surface's
+    float3 decalPadding;
+};
+StructuredBuffer<ClusterDecal> clusterDecals : register(t15);
+Buffer<uint2> decalRanges : register(t16);          // Offset and count into decalIndices
+Buffer<uint> decalIndices : register(t17);
+Texture2DArray decalTextures : register(t18);
+
+#ifdef VIRTUAL_TEXTURE
+// Sparse virtual texture in place of albedoMap, see TextureStreamingEngine
+Texture2D<uint> virtualPageTable : register(t19);   // Atlas slot x, y and the level it holds, per page
+Texture2D virtualPageAtlas : register(t20);
+RWTexture2D<uint> virtualFeedback : register(u4);
+
+cbuffer VirtualTextureBuffer : register(b4) {
+    float2 virtualSize;             // Texels at level 0
+    float2 virtualAtlasScale;       // 1 / atlas texels
+    uint virtualIndex;
+    uint virtualMaxLevel;           // A single page, always resident
+    uint2 feedbackPhase;            // The pixel of each feedback block that reports this frame
+};
+
+// Must match TextureStreamingEngine::PAGE_SIZE, PAGE_BORDER and FEEDBACK_SCALE
+static const uint VIRTUAL_PAGE_SIZE = 128;
+static const uint VIRTUAL_PAGE_BORDER = 4;
+static const uint VIRTUAL_FEEDBACK_SCALE = 8;
+
+// Reports the page uv's footprint wants and samples the finest resident page on the way to it,
+// bilinear within that level. uv is clamped to the texture, which is never tiled
+float4 sampleVirtualTexture(float2 uv, float4 screenPosition) {
+    float2 dx = ddx(uv * virtualSize);
+    float2 dy = ddy(uv * virtualSize);
+    float lod = 0.5f * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0f));
+    uint level = min(uint(lod), virtualMaxLevel);
+    float2 texel = clamp(uv, 0.0f, 1.0f - 1.0f / virtualSize) * virtualSize;
+    uint2 page = uint2(texel) / (VIRTUAL_PAGE_SIZE << level);
+
+    uint2 pixel = uint2(screenPosition.xy);
+    if (all(pixel % VIRTUAL_FEEDBACK_SCALE == feedbackPhase))
+        virtualFeedback[pixel / VIRTUAL_FEEDBACK_SCALE] = (virtualIndex << 26) | (level << 22) | (page.y << 11) | page.x;
+
+    uint entry = virtualPageTable.Load(int3(page, level));
+    uint resident = entry >> 16;
+    float2 slot = float2(entry & 0xFF, (entry >> 8) & 0xFF);
+    uint2 residentPage = uint2(texel) / (VIRTUAL_PAGE_SIZE << resident);
+    float2 local = texel * exp2(-float(resident)) - float2(residentPage * VIRTUAL_PAGE_SIZE);
+    float2 atlasTexel = slot * (VIRTUAL_PAGE_SIZE + 2 * VIRTUAL_PAGE_BORDER) + VIRTUAL_PAGE_BORDER + local;
+    return virtualPageAtlas.SampleLevel(defaultSampler, atlasTexel * virtualAtlasScale, 0.0f);
+}
+#endif
+
+// Material constants, PBR_PS's plus the ID
+cbuffer MaterialBuffer : register(b1) {
+    float3 albedoFactor;
+    float metallicFactor;
+    float roughnessFactor;
+    float normalScale;
+    float occlusionStrength;
+    float3 emissiveFactor;
+    float alphaCutoff;
+    float iblStrength;
+    uint materialId;                 // 0-255, for material-specific lighting
+};
+
+// Cluster lookup constants, the start of PBR_PS's ClusterBuffer
+cbuffer ClusterBuffer : register(b2) {
+    float4x4 clusterView;
+    float2 clusterTileScale;        // Tiles per pixel
+    float clusterSliceScale;        // slice = log(viewZ) * scale + bias
+    float clusterSliceBias;
+};
+
+// Must match DeferredRenderer::EMISSIVE_RANGE
+static const float EMISSIVE_RANGE = 16.0f;
+
+// Must match ClusteredLightCuller::GRID_X/Y/Z
+static const uint CLUSTER_GRID_X = 16;
+static const uint CLUSTER_GRID_Y = 9;
+static const uint CLUSTER_GRID_Z = 24;
+
+float3 getNormalFromMap(float2 texCoord, float3 worldPos, float3 worldNormal) {
+    // xy only, so BC5 maps (red/green only) work; z is rebuilt from the unit length
+    float3 tangentNormal;
+    tangentNormal.xy = normalMap.Sample(defaultSampler, texCoord).xy * 2.0f - 1.0f;
+    tangentNormal.z = sqrt(saturate(1.0f - dot(tangentNormal.xy, tangentNormal.xy)));
+    tangentNormal.xy *= normalScale;
+
+    float3 Q1 = ddx(worldPos);
+    float3 Q2 = ddy(worldPos);
+    float2 st1 = ddx(texCoord);
+    float2 st2 = ddy(texCoord);
+
+    float3 N = normalize(worldNormal);
+    float3 T = normalize(Q1 * st2.y - Q2 * st1.y);
+    float3 B = -normalize(cross(N, T));
+    float3x3 TBN = float3x3(T, B, N);
+
+    return normalize(mul(tangentNormal, TBN));
+}
+
+uint getClusterIndex(float4 screenPosition, float3 worldPos) {
+    float viewZ = mul(float4(worldPos, 1.0f), clusterView).z;
+    uint2 tile = min(uint2(screenPosition.xy * clusterTileScale), uint2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+    uint slice = min(uint(max(log(viewZ) * clusterSliceScale + clusterSliceBias, 0.0f)), CLUSTER_GRID_Z - 1);
+    return (slice * CLUSTER_GRID_Y + tile.y) * CLUSTER_GRID_X + tile.x;
+}
+
+// Blends every decal of the cluster that covers worldPos into albedo and roughness. The loop has
+// no uniform trip count, so texture gradients are taken before it
+void applyDecals(uint cluster, float3 worldPos, float3 normal, inout float3 albedo, inout float roughness) {
+    float3 dx = ddx(worldPos);
+    float3 dy = ddy(worldPos);
+    uint2 range = decalRanges[cluster];
+    for (uint i = 0; i < range.y; ++i) {
+        ClusterDecal decal = clusterDecals[decalIndices[range.x + i]];
+        float4 p = float4(worldPos, 1.0f);
+        float3 local = float3(dot(decal.worldToDecal[0], p), dot(decal.worldToDecal[1], p), dot(decal.worldToDecal[2], p));
+        if (any(abs(local) > 1.0f))
+            continue;
+
+        float2 uvScale = float2(0.5f, -0.5f) * decal.uvRect.zw;
+        float2 uv = local.xy * uvScale + 0.5f * decal.uvRect.zw + decal.uvRect.xy;
+        float2 uvDx = float2(dot(decal.worldToDecal[0].xyz, dx), dot(decal.worldToDecal[1].xyz, dx)) * uvScale;
+        float2 uvDy = float2(dot(decal.worldToDecal[0].xyz, dy), dot(decal.worldToDecal[1].xyz, dy)) * uvScale;
+        float4 texel = decalTextures.SampleGrad(defaultSampler, float3(uv, decal.layer), uvDx, uvDy);
+
+        // Fades out on surfaces that turn away from the projection and towards the box's ends
+        float facing = saturate((dot(normal, decal.axis) - 0.2f) * 4.0f);
+        float depthFade = saturate((1.0f - abs(local.z)) * 4.0f);
+        float coverage = texel.a * decal.color.a * facing * depthFade;
+        albedo = lerp(albedo, texel.rgb * decal.color.rgb, coverage);
+        if (decal.roughness >= 0.0f)
+            roughness = lerp(roughness, decal.roughness, coverage);
+    }
+}
+
+// Unit vector onto the [-1, 1] square: the octahedron's upper half maps to the inner diamond,
+// the lower half folds out into the corners
+float2 encodeNormal(float3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    float2 folded = (1.0f - abs(n.yx)) * (n.xy >= 0.0f ? 1.0f : -1.0f);
+    return n.z >= 0.0f ? n.xy : folded;
+}
+
+GBUFFER_OUTPUT main(PS_INPUT input) {
+    float3 albedo = albedoFactor;
+#if defined(VIRTUAL_TEXTURE)
+    albedo *= sampleVirtualTexture(input.texCoord, input.position).rgb;
+#elif defined(ALBEDO_MAP)
+    albedo *= albedoMap.Sample(defaultSampler, input.texCoord).rgb;
+#endif
+    float metallic = metallicFactor;
+#ifdef METALLIC_MAP
+    metallic *= metallicMap.Sample(defaultSampler, input.texCoord).r;
+#endif
+    float roughness = roughnessFactor;
+#ifdef ROUGHNESS_MAP
+    roughness *= roughnessMap.Sample(defaultSampler, input.texCoord).r;
+#endif
+    float ao = 1.0f;
+#ifdef AO_MAP
+    ao = aoMap.Sample(defaultSampler, input.texCoord).r;
+#endif
+    float3 emissive = emissiveFactor;
+#ifdef EMISSIVE_MAP
+    emissive *= emissiveMap.Sample(defaultSampler, input.texCoord).rgb;
+#endif
+    albedo *= input.color.rgb;
+
+    // Decals change the surface before it is stored
+    applyDecals(getClusterIndex(input.position, input.worldPos), input.worldPos, normalize(input.normal), albedo, roughness);
+
+#ifdef NORMAL_MAP
+    float3 N = getNormalFromMap(input.texCoord, input.worldPos, input.normal);
+#else
+    float3 N = normalize(input.normal);
+#endif
+
+    // Only the strength of the emission survives, tinted by the albedo when lit
+    float albedoPeak = max(max(albedo.r, albedo.g), max(albedo.b, 1e-3f));
+    float emissiveScale = max(max(emissive.r, emissive.g), emissive.b) / (albedoPeak * EMISSIVE_RANGE);
+
+    GBUFFER_OUTPUT output;
+    output.albedo = float4(albedo, ao);
+    output.normal = encodeNormal(N);
+    output.material = float4(saturate(roughness), saturate(metallic), (materialId & 255) / 255.0f, saturate(emissiveScale));
+    return output;
+}
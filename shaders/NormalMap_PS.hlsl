@@ -1,4 +1,5 @@
 // Enhanced Normal Mapping Pixel Shader v2.0
+// keywords: NORMAL_MAP SHADOW_MAP ROUGHNESS_MAP AO_MAP ENVIRONMENT_MAP EMISSIVE_MAP
 struct PS_INPUT {
     float2 texCoord : TEXCOORD0;
     float3 worldPos : TEXCOORD1;
@@ -41,24 +42,19 @@ cbuffer LightingBuffer : register(b0) {
 
 // Material parameters
 cbuffer MaterialBuffer : register(b1) {
-    bool normalMapEnabled;
     float normalMapStrength;
-    bool shadowMapEnabled;
     float specularPower;
-    bool emissiveEnabled;
     float emissiveStrength;
-    bool roughnessEnabled;
     float roughnessScale;
-    bool aoEnabled;
     float aoStrength;
-    bool environmentMapEnabled;
     float reflectionStrength;
 };
 
 // Advanced shadow mapping with PCF
 float CalculateShadowFactor(float4 lightSpacePos) {
-    if (!shadowMapEnabled) return 1.0f;
-    
+#ifndef SHADOW_MAP
+    return 1.0f;
+#else
     // Perspective divide
     float3 projCoords = lightSpacePos.xyz / lightSpacePos.w;
     
@@ -87,6 +83,7 @@ float CalculateShadowFactor(float4 lightSpacePos) {
         }
     }
     return shadow / 9.0f;
+#endif
 }
 
 // Fresnel reflection calculation
@@ -104,15 +101,26 @@ float4 main(PS_INPUT input) : SV_Target {
     // Sample textures
     float4 diffuseColor = diffuseTexture.Sample(defaultSampler, input.texCoord);
     float4 specularColor = specularTexture.Sample(defaultSampler, input.texCoord);
-    float roughness = roughnessEnabled ? roughnessTexture.Sample(defaultSampler, input.texCoord).r * roughnessScale : 0.5f;
-    float ao = aoEnabled ? aoTexture.Sample(defaultSampler, input.texCoord).r * aoStrength : 1.0f;
+#ifdef ROUGHNESS_MAP
+    float roughness = roughnessTexture.Sample(defaultSampler, input.texCoord).r * roughnessScale;
+#else
+    float roughness = 0.5f;
+#endif
+#ifdef AO_MAP
+    float ao = aoTexture.Sample(defaultSampler, input.texCoord).r * aoStrength;
+#else
+    float ao = 1.0f;
+#endif
     
     // Calculate normal
     float3 normal = normalize(input.normal);
     
-    if (normalMapEnabled) {
-        // Sample normal map
-        float3 normalMap = normalTexture.Sample(defaultSampler, input.texCoord).xyz * 2.0f - 1.0f;
+#ifdef NORMAL_MAP
+    {
+        // Sample normal map. Only xy is read so BC5 maps (red/green only) work; z is rebuilt
+        float3 normalMap;
+        normalMap.xy = normalTexture.Sample(defaultSampler, input.texCoord).xy * 2.0f - 1.0f;
+        normalMap.z = sqrt(saturate(1.0f - dot(normalMap.xy, normalMap.xy)));
         normalMap.xy *= normalMapStrength;
         
         // Transform to world space
@@ -124,6 +132,7 @@ float4 main(PS_INPUT input) : SV_Target {
         
         normal = normalize(mul(normalMap, TBN));
     }
+#endif
     
     // Lighting calculations
     float3 lightDir = normalize(-lightDirection);
@@ -147,9 +156,11 @@ float4 main(PS_INPUT input) : SV_Target {
     
     // Environment mapping
     float3 envReflection = float3(0.0f, 0.0f, 0.0f);
-    if (environmentMapEnabled && useIBL) {
+#ifdef ENVIRONMENT_MAP
+    if (useIBL) {
         envReflection = environmentMap.Sample(defaultSampler, reflectDir).rgb * reflectionStrength * iblStrength;
     }
+#endif
     
     // Shadow factor
     float shadowFactor = CalculateShadowFactor(input.lightSpacePos);
@@ -159,9 +170,9 @@ float4 main(PS_INPUT input) : SV_Target {
     
     // Emissive
     float3 emissive = float3(0.0f, 0.0f, 0.0f);
-    if (emissiveEnabled) {
-        emissive = emissiveTexture.Sample(defaultSampler, input.texCoord).rgb * emissiveStrength;
-    }
+#ifdef EMISSIVE_MAP
+    emissive = emissiveTexture.Sample(defaultSampler, input.texCoord).rgb * emissiveStrength;
+#endif
     
     // Combine lighting
     float3 finalColor = ambient + (diffuse + specular) * shadowFactor + envReflection * fresnel + emissive;
@@ -1,10 +1,15 @@
 // Enhanced Normal Mapping Vertex Shader v2.0
+// keywords: COMPRESSED_VERTEX
 struct VS_INPUT {
+#ifdef COMPRESSED_VERTEX
+    float4 position : POSITION;        // UNORM16 across the mesh bounds
+    float4 normalTangent : NORMAL;     // Octahedral normal xy, tangent xy
+#else
     float3 position : POSITION;
     float3 normal : NORMAL;
     float3 tangent : TANGENT;
+#endif
     float2 texCoord : TEXCOORD0;
-    float4 instancePos : TEXCOORD1;  // For instanced rendering
 };
 
 struct VS_OUTPUT {
@@ -29,37 +34,42 @@ cbuffer TransformBuffer : register(b0) {
     float4x4 prevFrameWVP;
     float3 cameraPosition;
     float time;
+    float4 positionOffset;   // Compressed position decode, see Shader::SetPositionDequantization
+    float4 positionScale;
 };
 
-// Animation buffer
-cbuffer AnimationBuffer : register(b1) {
-    float4x4 boneMatrices[128];
-    bool hasAnimation;
-    float animationTime;
-    float2 padding;
-};
+#ifdef COMPRESSED_VERTEX
+// Inverse of the octahedral encoding in MeshImporter::CompressVertices
+float3 DecodeOctahedral(float2 encoded)
+{
+    float2 e = encoded * 2.0f - 1.0f;
+    float3 v = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.xy += (v.xy >= 0.0f) ? -t : t;
+    return normalize(v);
+}
+#endif
 
 VS_OUTPUT main(VS_INPUT input) {
     VS_OUTPUT output;
     
-    // Apply instancing offset if available
-    float3 worldPos = input.position + input.instancePos.xyz;
-    
-    // Apply bone animation if enabled
-    if (hasAnimation) {
-        int boneIndex = (int)input.instancePos.w;
-        if (boneIndex >= 0 && boneIndex < 128) {
-            worldPos = mul(float4(worldPos, 1.0f), boneMatrices[boneIndex]).xyz;
-        }
-    }
+#ifdef COMPRESSED_VERTEX
+    float3 worldPos = positionOffset.xyz + input.position.xyz * positionScale.xyz;
+    float3 normal = DecodeOctahedral(input.normalTangent.xy);
+    float3 tangent = DecodeOctahedral(input.normalTangent.zw);
+#else
+    float3 worldPos = input.position;
+    float3 normal = input.normal;
+    float3 tangent = input.tangent;
+#endif
     
     // Transform position
     output.position = mul(float4(worldPos, 1.0f), worldViewProjectionMatrix);
     output.worldPos = mul(float4(worldPos, 1.0f), worldMatrix).xyz;
     
     // Transform normal, tangent for normal mapping
-    output.normal = normalize(mul(input.normal, (float3x3)worldMatrix));
-    output.tangent = normalize(mul(input.tangent, (float3x3)worldMatrix));
+    output.normal = normalize(mul(normal, (float3x3)worldMatrix));
+    output.tangent = normalize(mul(tangent, (float3x3)worldMatrix));
     output.binormal = cross(output.normal, output.tangent);
     
     // Pass through texture coordinates with time-based animation
@@ -1,5 +1,7 @@
 // Physically-Based Rendering Pixel Shader
+// keywords: ALBEDO_MAP NORMAL_MAP METALLIC_MAP ROUGHNESS_MAP AO_MAP EMISSIVE_MAP IBL PROBE_VOLUME LIGHTMAP VIRTUAL_TEXTURE
 struct PS_INPUT {
+    float4 position : SV_POSITION;
     float3 worldPos : TEXCOORD0;
     float3 normal : TEXCOORD1;
     float3 tangent : TEXCOORD2;
@@ -8,6 +10,9 @@ struct PS_INPUT {
     float4 color : TEXCOORD5;
     float3 viewDir : TEXCOORD6;
     float4 lightSpacePos : TEXCOORD7;
+#ifdef LIGHTMAP
+    float2 lightmapCoord : TEXCOORD8;
+#endif
 };
 
 // PBR Textures
@@ -22,15 +27,40 @@ TextureCube environmentMap : register(t7);
 TextureCube irradianceMap : register(t8);
 Texture2D brdfLUT : register(t9);
 
+// Clustered lights, see ClusteredLightCuller. Directional lights come first and apply to every
+// pixel; each cluster lists the point and spot lights that reach it
+struct ClusterLight {
+    float3 position;
+    float range;            // 0 for directional lights
+    float3 color;           // Premultiplied by intensity
+    float spotScale;
+    float3 direction;
+    float spotOffset;
+};
+StructuredBuffer<ClusterLight> clusterLights : register(t10);
+Buffer<uint2> clusterRanges : register(t11);         // Offset and count into clusterLightIndices
+Buffer<uint> clusterLightIndices : register(t12);
+
+// Clustered decals, see DecalSystem; binned into the same clusters as the lights
+struct ClusterDecal {
+    float4 worldToDecal[3];         // Rows of the map into the [-1, 1] box
+    float3 axis;                    // Surfaces turned away from it fade out
+    float layer;
+    float4 uvRect;                  // Offset and scale within the layer
+    float4 color;                   // Tint, and coverage in alpha
+    float roughness;                // Negative keeps the surface's
+    float3 decalPadding;
+};
+StructuredBuffer<ClusterDecal> clusterDecals : register(t15);
+Buffer<uint2> decalRanges : register(t16);          // Offset and count into decalIndices
+Buffer<uint> decalIndices : register(t17);
+Texture2DArray decalTextures : register(t18);
+
 SamplerState defaultSampler : register(s0);
 SamplerState shadowSampler : register(s1);
 
 // Lighting constants
 cbuffer LightingBuffer : register(b0) {
-    float3 lightPositions[4];
-    float3 lightColors[4];
-    float lightIntensities[4];
-    int numLights;
     float3 ambientLight;
     float exposure;
     float gamma;
@@ -49,23 +79,127 @@ cbuffer MaterialBuffer : register(b1) {
     float occlusionStrength;
     float3 emissiveFactor;
     float alphaCutoff;
-    bool useAlbedoMap;
-    bool useNormalMap;
-    bool useMetallicMap;
-    bool useRoughnessMap;
-    bool useAOMap;
-    bool useEmissiveMap;
-    bool useIBL;
     float iblStrength;
 };
 
+// Cluster lookup constants
+cbuffer ClusterBuffer : register(b2) {
+    float4x4 clusterView;
+    float2 clusterTileScale;        // Tiles per pixel
+    float clusterSliceScale;        // slice = log(viewZ) * scale + bias
+    float clusterSliceBias;
+    uint directionalLightCount;
+};
+
+#ifdef PROBE_VOLUME
+// Irradiance probes, see ProbeVolume; this mirrors its GetShaderSource()
+cbuffer ProbeBuffer : register(b3) {
+    float3 probeOrigin;
+    uint probeEnabled;
+    float3 probeInverseSpacing;
+    uint probeL2;
+    float3 probeCounts;
+    float probeIntensity;
+};
+Texture3D<float4> probeSH : register(t13);
+SamplerState probeSampler : register(s2);
+
+// Coefficient planes are stacked along z; staying half a texel inside one keeps the filter out of the next
+float4 probePlane(float3 cell, uint plane, uint planes) {
+    float3 clamped = clamp(cell, 0.5f, probeCounts - 0.5f);
+    float z = (plane * probeCounts.z + clamped.z) / (probeCounts.z * planes);
+    return probeSH.SampleLevel(probeSampler, float3(clamped.xy / probeCounts.xy, z), 0.0f);
+}
+
+// Diffuse light for normal N, to multiply by albedo, like ambientLight
+float3 sampleProbeIrradiance(float3 worldPos, float3 N) {
+    float3 cell = (worldPos - probeOrigin) * probeInverseSpacing + 0.5f;
+    uint planes = probeL2 ? 7 : 3;
+    float4 p0 = probePlane(cell, 0, planes);
+    float4 p1 = probePlane(cell, 1, planes);
+    float4 p2 = probePlane(cell, 2, planes);
+    float3 result = p0.xyz * 0.282095f
+                  + float3(p0.w, p1.xy) * (0.488603f * N.y)
+                  + float3(p1.zw, p2.x) * (0.488603f * N.z)
+                  + p2.yzw * (0.488603f * N.x);
+    if (probeL2) {
+        float4 p3 = probePlane(cell, 3, planes);
+        float4 p4 = probePlane(cell, 4, planes);
+        float4 p5 = probePlane(cell, 5, planes);
+        float4 p6 = probePlane(cell, 6, planes);
+        result += p3.xyz * (1.092548f * N.x * N.y)
+                + float3(p3.w, p4.xy) * (1.092548f * N.y * N.z)
+                + float3(p4.zw, p5.x) * (0.315392f * (3.0f * N.z * N.z - 1.0f))
+                + p5.yzw * (1.092548f * N.x * N.z)
+                + p6.xyz * (0.546274f * (N.x * N.x - N.y * N.y));
+    }
+    return max(result, 0.0f) * probeIntensity;
+}
+#endif
+
+#ifdef LIGHTMAP
+// Baked diffuse light, see LightmapBaker; stands in for the probes and the flat ambient term
+Texture2D lightmap : register(t14);
+#endif
+
+#ifdef VIRTUAL_TEXTURE
+// Sparse virtual texture in place of albedoMap, see TextureStreamingEngine
+Texture2D<uint> virtualPageTable : register(t19);   // Atlas slot x, y and the level it holds, per page
+Texture2D virtualPageAtlas : register(t20);
+RWTexture2D<uint> virtualFeedback : register(u4);
+
+cbuffer VirtualTextureBuffer : register(b4) {
+    float2 virtualSize;             // Texels at level 0
+    float2 virtualAtlasScale;       // 1 / atlas texels
+    uint virtualIndex;
+    uint virtualMaxLevel;           // A single page, always resident
+    uint2 feedbackPhase;            // The pixel of each feedback block that reports this frame
+};
+
+// Must match TextureStreamingEngine::PAGE_SIZE, PAGE_BORDER and FEEDBACK_SCALE
+static const uint VIRTUAL_PAGE_SIZE = 128;
+static const uint VIRTUAL_PAGE_BORDER = 4;
+static const uint VIRTUAL_FEEDBACK_SCALE = 8;
+
+// Reports the page uv's footprint wants and samples the finest resident page on the way to it,
+// bilinear within that level. uv is clamped to the texture, which is never tiled
+float4 sampleVirtualTexture(float2 uv, float4 screenPosition) {
+    float2 dx = ddx(uv * virtualSize);
+    float2 dy = ddy(uv * virtualSize);
+    float lod = 0.5f * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0f));
+    uint level = min(uint(lod), virtualMaxLevel);
+    float2 texel = clamp(uv, 0.0f, 1.0f - 1.0f / virtualSize) * virtualSize;
+    uint2 page = uint2(texel) / (VIRTUAL_PAGE_SIZE << level);
+
+    uint2 pixel = uint2(screenPosition.xy);
+    if (all(pixel % VIRTUAL_FEEDBACK_SCALE == feedbackPhase))
+        virtualFeedback[pixel / VIRTUAL_FEEDBACK_SCALE] = (virtualIndex << 26) | (level << 22) | (page.y << 11) | page.x;
+
+    uint entry = virtualPageTable.Load(int3(page, level));
+    uint resident = entry >> 16;
+    float2 slot = float2(entry & 0xFF, (entry >> 8) & 0xFF);
+    uint2 residentPage = uint2(texel) / (VIRTUAL_PAGE_SIZE << resident);
+    float2 local = texel * exp2(-float(resident)) - float2(residentPage * VIRTUAL_PAGE_SIZE);
+    float2 atlasTexel = slot * (VIRTUAL_PAGE_SIZE + 2 * VIRTUAL_PAGE_BORDER) + VIRTUAL_PAGE_BORDER + local;
+    return virtualPageAtlas.SampleLevel(defaultSampler, atlasTexel * virtualAtlasScale, 0.0f);
+}
+#endif
+
+// Must match ClusteredLightCuller::GRID_X/Y/Z
+static const uint CLUSTER_GRID_X = 16;
+static const uint CLUSTER_GRID_Y = 9;
+static const uint CLUSTER_GRID_Z = 24;
+
 // Constants
 static const float PI = 3.14159265359f;
 static const float EPSILON = 1e-6f;
 
 // Utility functions
 float3 getNormalFromMap(float2 texCoord, float3 worldPos, float3 worldNormal) {
-    float3 tangentNormal = normalMap.Sample(defaultSampler, texCoord).xyz * 2.0f - 1.0f;
+    // xy only, so BC5 maps (red/green only) work; z is rebuilt from the unit length
+    float3 tangentNormal;
+    tangentNormal.xy = normalMap.Sample(defaultSampler, texCoord).xy * 2.0f - 1.0f;
+    tangentNormal.z = sqrt(saturate(1.0f - dot(tangentNormal.xy, tangentNormal.xy)));
     tangentNormal.xy *= normalScale;
     
     float3 Q1 = ddx(worldPos);
@@ -122,6 +256,73 @@ float3 fresnelSchlickRoughness(float cosTheta, float3 F0, float roughness) {
     return F0 + (max(float3(1.0f - roughness, 1.0f - roughness, 1.0f - roughness), F0) - F0) * pow(clamp(1.0f - cosTheta, 0.0f, 1.0f), 5.0f);
 }
 
+// Cook-Torrance contribution of one light arriving from L with the given radiance
+float3 shadeLight(float3 N, float3 V, float3 L, float3 radiance, float3 albedo, float3 F0, float metallic, float roughness) {
+    float3 H = normalize(V + L);
+    float NDF = DistributionGGX(N, H, roughness);
+    float G = GeometrySmith(N, V, L, roughness);
+    float3 F = fresnelSchlick(max(dot(H, V), 0.0f), F0);
+    
+    float3 kS = F;
+    float3 kD = float3(1.0f, 1.0f, 1.0f) - kS;
+    kD *= 1.0f - metallic;
+    
+    float3 numerator = NDF * G * F;
+    float denominator = 4.0f * max(dot(N, V), 0.0f) * max(dot(N, L), 0.0f) + EPSILON;
+    float3 specular = numerator / denominator;
+    
+    float NdotL = max(dot(N, L), 0.0f);
+    return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+
+// Inverse-square falloff windowed to reach zero at the light's range, times the spot cone
+float3 clusterLightRadiance(ClusterLight light, float3 worldPos, out float3 L) {
+    float3 toLight = light.position - worldPos;
+    float distanceSq = max(dot(toLight, toLight), 1e-4f);
+    L = toLight * rsqrt(distanceSq);
+    
+    float window = saturate(1.0f - pow(distanceSq / (light.range * light.range), 2.0f));
+    float attenuation = window * window / max(distanceSq, 0.01f);
+    attenuation *= saturate(dot(-L, light.direction) * light.spotScale + light.spotOffset);
+    return light.color * attenuation;
+}
+
+uint getClusterIndex(float4 screenPosition, float3 worldPos) {
+    float viewZ = mul(float4(worldPos, 1.0f), clusterView).z;
+    uint2 tile = min(uint2(screenPosition.xy * clusterTileScale), uint2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+    uint slice = min(uint(max(log(viewZ) * clusterSliceScale + clusterSliceBias, 0.0f)), CLUSTER_GRID_Z - 1);
+    return (slice * CLUSTER_GRID_Y + tile.y) * CLUSTER_GRID_X + tile.x;
+}
+
+// Blends every decal of the cluster that covers worldPos into albedo and roughness. The loop has
+// no uniform trip count, so texture gradients are taken before it
+void applyDecals(uint cluster, float3 worldPos, float3 normal, inout float3 albedo, inout float roughness) {
+    float3 dx = ddx(worldPos);
+    float3 dy = ddy(worldPos);
+    uint2 range = decalRanges[cluster];
+    for (uint i = 0; i < range.y; ++i) {
+        ClusterDecal decal = clusterDecals[decalIndices[range.x + i]];
+        float4 p = float4(worldPos, 1.0f);
+        float3 local = float3(dot(decal.worldToDecal[0], p), dot(decal.worldToDecal[1], p), dot(decal.worldToDecal[2], p));
+        if (any(abs(local) > 1.0f))
+            continue;
+        
+        float2 uvScale = float2(0.5f, -0.5f) * decal.uvRect.zw;
+        float2 uv = local.xy * uvScale + 0.5f * decal.uvRect.zw + decal.uvRect.xy;
+        float2 uvDx = float2(dot(decal.worldToDecal[0].xyz, dx), dot(decal.worldToDecal[1].xyz, dx)) * uvScale;
+        float2 uvDy = float2(dot(decal.worldToDecal[0].xyz, dy), dot(decal.worldToDecal[1].xyz, dy)) * uvScale;
+        float4 texel = decalTextures.SampleGrad(defaultSampler, float3(uv, decal.layer), uvDx, uvDy);
+        
+        // Fades out on surfaces that turn away from the projection and towards the box's ends
+        float facing = saturate((dot(normal, decal.axis) - 0.2f) * 4.0f);
+        float depthFade = saturate((1.0f - abs(local.z)) * 4.0f);
+        float coverage = texel.a * decal.color.a * facing * depthFade;
+        albedo = lerp(albedo, texel.rgb * decal.color.rgb, coverage);
+        if (decal.roughness >= 0.0f)
+            roughness = lerp(roughness, decal.roughness, coverage);
+    }
+}
+
 float calculateShadowFactor(float4 lightSpacePos) {
     float3 projCoords = lightSpacePos.xyz / lightSpacePos.w;
     projCoords.xy = projCoords.xy * 0.5f + 0.5f;
@@ -149,17 +350,43 @@ float calculateShadowFactor(float4 lightSpacePos) {
 
 float4 main(PS_INPUT input) : SV_Target {
     // Sample material properties
-    float3 albedo = useAlbedoMap ? albedoMap.Sample(defaultSampler, input.texCoord).rgb * albedoFactor : albedoFactor;
-    float metallic = useMetallicMap ? metallicMap.Sample(defaultSampler, input.texCoord).r * metallicFactor : metallicFactor;
-    float roughness = useRoughnessMap ? roughnessMap.Sample(defaultSampler, input.texCoord).r * roughnessFactor : roughnessFactor;
-    float ao = useAOMap ? aoMap.Sample(defaultSampler, input.texCoord).r : 1.0f;
-    float3 emissive = useEmissiveMap ? emissiveMap.Sample(defaultSampler, input.texCoord).rgb * emissiveFactor : emissiveFactor;
+    // Texture inputs are compiled in per permutation, see the keywords line at the top
+    float3 albedo = albedoFactor;
+#if defined(VIRTUAL_TEXTURE)
+    albedo *= sampleVirtualTexture(input.texCoord, input.position).rgb;
+#elif defined(ALBEDO_MAP)
+    albedo *= albedoMap.Sample(defaultSampler, input.texCoord).rgb;
+#endif
+    float metallic = metallicFactor;
+#ifdef METALLIC_MAP
+    metallic *= metallicMap.Sample(defaultSampler, input.texCoord).r;
+#endif
+    float roughness = roughnessFactor;
+#ifdef ROUGHNESS_MAP
+    roughness *= roughnessMap.Sample(defaultSampler, input.texCoord).r;
+#endif
+    float ao = 1.0f;
+#ifdef AO_MAP
+    ao = aoMap.Sample(defaultSampler, input.texCoord).r;
+#endif
+    float3 emissive = emissiveFactor;
+#ifdef EMISSIVE_MAP
+    emissive *= emissiveMap.Sample(defaultSampler, input.texCoord).rgb;
+#endif
     
     // Apply vertex color
     albedo *= input.color.rgb;
     
+    // Decals change the surface before it is lit
+    uint cluster = getClusterIndex(input.position, input.worldPos);
+    applyDecals(cluster, input.worldPos, normalize(input.normal), albedo, roughness);
+    
     // Calculate normal
-    float3 N = useNormalMap ? getNormalFromMap(input.texCoord, input.worldPos, input.normal) : normalize(input.normal);
+#ifdef NORMAL_MAP
+    float3 N = getNormalFromMap(input.texCoord, input.worldPos, input.normal);
+#else
+    float3 N = normalize(input.normal);
+#endif
     float3 V = normalize(input.viewDir);
     float3 R = reflect(-V, N);
     
@@ -169,40 +396,35 @@ float4 main(PS_INPUT input) : SV_Target {
     // Reflectance equation
     float3 Lo = float3(0.0f, 0.0f, 0.0f);
     
-    // Direct lighting
-    for (int i = 0; i < numLights; ++i) {
-        float3 L = normalize(lightPositions[i] - input.worldPos);
-        float3 H = normalize(V + L);
-        float distance = length(lightPositions[i] - input.worldPos);
-        float attenuation = 1.0f / (distance * distance);
-        float3 radiance = lightColors[i] * lightIntensities[i] * attenuation;
-        
-        // BRDF
-        float NDF = DistributionGGX(N, H, roughness);
-        float G = GeometrySmith(N, V, L, roughness);
-        float3 F = fresnelSchlick(max(dot(H, V), 0.0f), F0);
-        
-        float3 kS = F;
-        float3 kD = float3(1.0f, 1.0f, 1.0f) - kS;
-        kD *= 1.0f - metallic;
-        
-        float3 numerator = NDF * G * F;
-        float denominator = 4.0f * max(dot(N, V), 0.0f) * max(dot(N, L), 0.0f) + EPSILON;
-        float3 specular = numerator / denominator;
-        
-        float NdotL = max(dot(N, L), 0.0f);
-        Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+    // Direct lighting: directional lights, then only the lights binned into this pixel's cluster
+    for (uint d = 0; d < directionalLightCount; ++d) {
+        ClusterLight light = clusterLights[d];
+        Lo += shadeLight(N, V, -light.direction, light.color, albedo, F0, metallic, roughness);
+    }
+    uint2 range = clusterRanges[cluster];
+    for (uint i = 0; i < range.y; ++i) {
+        ClusterLight light = clusterLights[clusterLightIndices[range.x + i]];
+        float3 L;
+        float3 radiance = clusterLightRadiance(light, input.worldPos, L);
+        Lo += shadeLight(N, V, L, radiance, albedo, F0, metallic, roughness);
     }
     
     // Ambient lighting (IBL)
-    float3 ambient = float3(0.0f, 0.0f, 0.0f);
-    if (useIBL) {
+#ifdef IBL
+    float3 ambient;
+    {
         float3 F = fresnelSchlickRoughness(max(dot(N, V), 0.0f), F0, roughness);
         float3 kS = F;
         float3 kD = 1.0f - kS;
         kD *= 1.0f - metallic;
         
+#if defined(LIGHTMAP)
+        float3 irradiance = lightmap.Sample(defaultSampler, input.lightmapCoord).rgb;
+#elif defined(PROBE_VOLUME)
+        float3 irradiance = probeEnabled ? sampleProbeIrradiance(input.worldPos, N) : irradianceMap.Sample(defaultSampler, N).rgb;
+#else
         float3 irradiance = irradianceMap.Sample(defaultSampler, N).rgb;
+#endif
         float3 diffuse = irradiance * albedo;
         
         const float MAX_REFLECTION_LOD = 4.0f;
@@ -211,9 +433,14 @@ float4 main(PS_INPUT input) : SV_Target {
         float3 specular = prefilteredColor * (F * brdf.x + brdf.y);
         
         ambient = (kD * diffuse + specular) * ao * iblStrength;
-    } else {
-        ambient = ambientLight * albedo * ao;
     }
+#elif defined(LIGHTMAP)
+    float3 ambient = lightmap.Sample(defaultSampler, input.lightmapCoord).rgb * albedo * ao;
+#elif defined(PROBE_VOLUME)
+    float3 ambient = (probeEnabled ? sampleProbeIrradiance(input.worldPos, N) : ambientLight) * albedo * ao;
+#else
+    float3 ambient = ambientLight * albedo * ao;
+#endif
     
     float3 color = ambient + Lo + emissive;
     
@@ -1,10 +1,18 @@
 // Physically-Based Rendering Vertex Shader
+// keywords: COMPRESSED_VERTEX LIGHTMAP
 struct VS_INPUT {
+#ifdef COMPRESSED_VERTEX
+    float4 position : POSITION;        // UNORM16 across the mesh bounds
+    float4 normalTangent : NORMAL;     // Octahedral normal xy, tangent xy
+#else
     float3 position : POSITION;
     float3 normal : NORMAL;
     float3 tangent : TANGENT;
+#endif
     float2 texCoord : TEXCOORD0;
-    float4 color : COLOR0;
+#ifdef LIGHTMAP
+    float2 lightmapCoord : TEXCOORD1;  // Second stream, see Mesh::SetLightmapCoordinates
+#endif
 };
 
 struct VS_OUTPUT {
@@ -17,6 +25,9 @@ struct VS_OUTPUT {
     float4 color : TEXCOORD5;
     float3 viewDir : TEXCOORD6;
     float4 lightSpacePos : TEXCOORD7;
+#ifdef LIGHTMAP
+    float2 lightmapCoord : TEXCOORD8;
+#endif
 };
 
 cbuffer TransformBuffer : register(b0) {
@@ -27,24 +38,51 @@ cbuffer TransformBuffer : register(b0) {
     float4x4 lightViewProjectionMatrix;
     float3 cameraPosition;
     float padding;
+    float4 positionOffset;   // Compressed position decode, see Shader::SetPositionDequantization
+    float4 positionScale;
 };
 
+#ifdef COMPRESSED_VERTEX
+// Inverse of the octahedral encoding in MeshImporter::CompressVertices
+float3 DecodeOctahedral(float2 encoded)
+{
+    float2 e = encoded * 2.0f - 1.0f;
+    float3 v = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.xy += (v.xy >= 0.0f) ? -t : t;
+    return normalize(v);
+}
+#endif
+
 VS_OUTPUT main(VS_INPUT input) {
     VS_OUTPUT output;
     
+#ifdef COMPRESSED_VERTEX
+    float3 position = positionOffset.xyz + input.position.xyz * positionScale.xyz;
+    float3 normal = DecodeOctahedral(input.normalTangent.xy);
+    float3 tangent = DecodeOctahedral(input.normalTangent.zw);
+#else
+    float3 position = input.position;
+    float3 normal = input.normal;
+    float3 tangent = input.tangent;
+#endif
+    
     // Transform position
-    float4 worldPos = mul(float4(input.position, 1.0f), worldMatrix);
+    float4 worldPos = mul(float4(position, 1.0f), worldMatrix);
     output.position = mul(worldPos, mul(viewMatrix, projectionMatrix));
     output.worldPos = worldPos.xyz;
     
     // Transform normal vectors
-    output.normal = normalize(mul(input.normal, (float3x3)worldMatrix));
-    output.tangent = normalize(mul(input.tangent, (float3x3)worldMatrix));
+    output.normal = normalize(mul(normal, (float3x3)worldMatrix));
+    output.tangent = normalize(mul(tangent, (float3x3)worldMatrix));
     output.bitangent = cross(output.normal, output.tangent);
     
-    // Pass through texture coordinates and vertex color
+    // Pass through texture coordinates; meshes carry no vertex color
     output.texCoord = input.texCoord;
-    output.color = input.color;
+    output.color = float4(1.0f, 1.0f, 1.0f, 1.0f);
+#ifdef LIGHTMAP
+    output.lightmapCoord = input.lightmapCoord;
+#endif
     
     // Calculate view direction
     output.viewDir = normalize(cameraPosition - output.worldPos);
@@ -3,7 +3,7 @@ struct PS_INPUT {
     float depth : TEXCOORD0;
 };
 
-float4 main(PS_INPUT input) : COLOR {
+float4 main(PS_INPUT input) : SV_Target {
     // Output depth to shadow map
     return float4(input.depth, input.depth, input.depth, 1.0f);
 }
@@ -0,0 +1,243 @@
+#include "AISpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+// Keeps cell coordinates of far-off positions inside int32_t
+constexpr float MAX_CELL_COORDINATE = 1.0e9f;
+
+uint32_t RoundUpToPowerOfTwo(uint32_t value) {
+    uint32_t power = 1;
+    while (power < value && power < (1u << 31)) power <<= 1;
+    return power;
+}
+}
+
+AISpatialGrid::AISpatialGrid(float cellSize, uint32_t bucketCount)
+    : cellSize_(std::max(cellSize, 0.01f))
+    , inverseCellSize_(1.0f / cellSize_)
+    , buckets_(RoundUpToPowerOfTwo(std::max(bucketCount, 1u)), INVALID_ITEM)
+    , freeItem_(INVALID_ITEM)
+    , itemCount_(0) {}
+
+void AISpatialGrid::SetCellSize(float cellSize) {
+    cellSize_ = std::max(cellSize, 0.01f);
+    inverseCellSize_ = 1.0f / cellSize_;
+
+    // Every live item lands in a new cell
+    std::fill(buckets_.begin(), buckets_.end(), INVALID_ITEM);
+    for (uint32_t item = 0; item < items_.size(); ++item) {
+        if (items_[item].alive) Link(item);
+    }
+}
+
+void AISpatialGrid::Clear() {
+    std::fill(buckets_.begin(), buckets_.end(), INVALID_ITEM);
+    items_.clear();
+    freeItem_ = INVALID_ITEM;
+    itemCount_ = 0;
+}
+
+int32_t AISpatialGrid::CellCoordinate(float value) const {
+    float cell = std::floor(value * inverseCellSize_);
+    return static_cast<int32_t>(std::max(-MAX_CELL_COORDINATE, std::min(cell, MAX_CELL_COORDINATE)));
+}
+
+uint32_t AISpatialGrid::Bucket(int32_t cellX, int32_t cellZ) const {
+    uint32_t hash = static_cast<uint32_t>(cellX) * 73856093u ^ static_cast<uint32_t>(cellZ) * 19349663u;
+    return hash & static_cast<uint32_t>(buckets_.size() - 1);
+}
+
+void AISpatialGrid::Link(uint32_t item) {
+    Item& entry = items_[item];
+    entry.cellX = CellCoordinate(entry.position.x);
+    entry.cellZ = CellCoordinate(entry.position.z);
+    entry.bucket = Bucket(entry.cellX, entry.cellZ);
+    entry.prev = INVALID_ITEM;
+    entry.next = buckets_[entry.bucket];
+    if (entry.next != INVALID_ITEM) items_[entry.next].prev = item;
+    buckets_[entry.bucket] = item;
+}
+
+void AISpatialGrid::Unlink(uint32_t item) {
+    Item& entry = items_[item];
+    if (entry.prev != INVALID_ITEM) {
+        items_[entry.prev].next = entry.next;
+    } else {
+        buckets_[entry.bucket] = entry.next;
+    }
+    if (entry.next != INVALID_ITEM) items_[entry.next].prev = entry.prev;
+}
+
+uint32_t AISpatialGrid::Insert(const XMFLOAT3& position) {
+    uint32_t item;
+    if (freeItem_ != INVALID_ITEM) {
+        item = freeItem_;
+        freeItem_ = items_[item].next;
+    } else {
+        item = static_cast<uint32_t>(items_.size());
+        items_.emplace_back();
+    }
+
+    items_[item].position = position;
+    items_[item].alive = true;
+    Link(item);
+    itemCount_++;
+    return item;
+}
+
+void AISpatialGrid::Move(uint32_t item, const XMFLOAT3& position) {
+    Item& entry = items_[item];
+    entry.position = position;
+    if (CellCoordinate(position.x) == entry.cellX && CellCoordinate(position.z) == entry.cellZ) return;
+
+    Unlink(item);
+    Link(item);
+}
+
+void AISpatialGrid::Remove(uint32_t item) {
+    if (item >= items_.size() || !items_[item].alive) return;
+
+    Unlink(item);
+    items_[item].alive = false;
+    items_[item].next = freeItem_;
+    freeItem_ = item;
+    itemCount_--;
+}
+
+template<typename Visit>
+void AISpatialGrid::ForEachInRadius(const XMFLOAT3& center, float radius, Visit&& visit) const {
+    const float radiusSq = radius * radius;
+    auto inside = [&](const Item& entry) {
+        float dx = entry.position.x - center.x;
+        float dy = entry.position.y - center.y;
+        float dz = entry.position.z - center.z;
+        return dx * dx + dy * dy + dz * dz <= radiusSq;
+    };
+
+    int32_t minX = CellCoordinate(center.x - radius), maxX = CellCoordinate(center.x + radius);
+    int32_t minZ = CellCoordinate(center.z - radius), maxZ = CellCoordinate(center.z + radius);
+    uint64_t cellCount = static_cast<uint64_t>(maxX - minX + 1) * static_cast<uint64_t>(maxZ - minZ + 1);
+
+    // A radius spanning more cells than there are items is cheaper as a plain scan
+    if (cellCount > items_.size()) {
+        for (uint32_t item = 0; item < items_.size(); ++item) {
+            if (items_[item].alive && inside(items_[item])) visit(item);
+        }
+        return;
+    }
+
+    for (int32_t z = minZ; z <= maxZ; ++z) {
+        for (int32_t x = minX; x <= maxX; ++x) {
+            for (uint32_t item = buckets_[Bucket(x, z)]; item != INVALID_ITEM; item = items_[item].next) {
+                const Item& entry = items_[item];
+                if (entry.cellX == x && entry.cellZ == z && inside(entry)) visit(item);
+            }
+        }
+    }
+}
+
+size_t AISpatialGrid::QueryRadius(const XMFLOAT3& center, float radius, std::vector<uint32_t>& results) const {
+    results.clear();
+    ForEachInRadius(center, radius, [&results](uint32_t item) { results.push_back(item); });
+    return results.size();
+}
+
+size_t AISpatialGrid::QueryCone(const XMFLOAT3& origin, const XMFLOAT3& direction, float radius,
+                                float cosHalfAngle, std::vector<uint32_t>& results) const {
+    results.clear();
+    ForEachInRadius(origin, radius, [&](uint32_t item) {
+        const XMFLOAT3& position = items_[item].position;
+        float dx = position.x - origin.x;
+        float dy = position.y - origin.y;
+        float dz = position.z - origin.z;
+        float along = dx * direction.x + dy * direction.y + dz * direction.z;
+
+        // along >= cos * length, squared without the root; the origin itself always counts
+        float lengthSq = dx * dx + dy * dy + dz * dz;
+        if (lengthSq == 0.0f ||
+            (cosHalfAngle >= 0.0f ? along >= 0.0f && along * along >= cosHalfAngle * cosHalfAngle * lengthSq
+                                  : along >= 0.0f || along * along <= cosHalfAngle * cosHalfAngle * lengthSq)) {
+            results.push_back(item);
+        }
+    });
+    return results.size();
+}
+
+size_t AISpatialGrid::QueryNearest(const XMFLOAT3& center, float radius, size_t count,
+                                   std::vector<uint32_t>& results) const {
+    results.clear();
+    if (count == 0) return 0;
+
+    const float radiusSq = radius * radius;
+    auto distanceSq = [&](uint32_t item) {
+        const XMFLOAT3& position = items_[item].position;
+        float dx = position.x - center.x;
+        float dy = position.y - center.y;
+        float dz = position.z - center.z;
+        return dx * dx + dy * dy + dz * dz;
+    };
+    // results stays sorted by distance; count is small, so insertion beats a heap. Once full,
+    // only items nearer than the furthest kept get in
+    float worstSq = radiusSq;
+    auto consider = [&](uint32_t item) {
+        const float distance = distanceSq(item);
+        if (distance > worstSq || (results.size() == count && distance == worstSq)) return;
+        if (results.size() == count) results.pop_back();
+
+        size_t slot = results.size();
+        results.push_back(item);
+        while (slot > 0 && distanceSq(results[slot - 1]) > distance) {
+            results[slot] = results[slot - 1];
+            slot--;
+        }
+        results[slot] = item;
+        if (results.size() == count) worstSq = distanceSq(results.back());
+    };
+
+    int32_t minX = CellCoordinate(center.x - radius), maxX = CellCoordinate(center.x + radius);
+    int32_t minZ = CellCoordinate(center.z - radius), maxZ = CellCoordinate(center.z + radius);
+    uint64_t cellCount = static_cast<uint64_t>(maxX - minX + 1) * static_cast<uint64_t>(maxZ - minZ + 1);
+    if (cellCount > items_.size()) {
+        for (uint32_t item = 0; item < items_.size(); ++item) {
+            if (items_[item].alive) consider(item);
+        }
+        return results.size();
+    }
+
+    auto visitCell = [&](int32_t x, int32_t z) {
+        if (x < minX || x > maxX || z < minZ || z > maxZ) return;
+        for (uint32_t item = buckets_[Bucket(x, z)]; item != INVALID_ITEM; item = items_[item].next) {
+            const Item& entry = items_[item];
+            if (entry.cellX == x && entry.cellZ == z) consider(item);
+        }
+    };
+
+    const int32_t cellX = CellCoordinate(center.x), cellZ = CellCoordinate(center.z);
+    const int32_t lastRing = std::max(std::max(cellX - minX, maxX - cellX), std::max(cellZ - minZ, maxZ - cellZ));
+    for (int32_t ring = 0; ring <= lastRing; ++ring) {
+        if (ring == 0) {
+            visitCell(cellX, cellZ);
+        } else {
+            for (int32_t x = cellX - ring; x <= cellX + ring; ++x) {
+                visitCell(x, cellZ - ring);
+                visitCell(x, cellZ + ring);
+            }
+            for (int32_t z = cellZ - ring + 1; z <= cellZ + ring - 1; ++z) {
+                visitCell(cellX - ring, z);
+                visitCell(cellX + ring, z);
+            }
+        }
+
+        // Every cell of the next ring is at least ring cells away
+        const float reach = ring * cellSize_;
+        if (results.size() == count && worstSq <= reach * reach) break;
+    }
+    return results.size();
+}
+
+} // namespace Nexus
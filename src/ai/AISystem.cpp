@@ -1,22 +1,220 @@
 #include "AISystem.h"
+#include "CoverMap.h"
+#include "FlowField.h"
+#include "JobSystem.h"
 #include "Logger.h"
+#include "NavMesh.h"
+#include "Profiler.h"
+#include "Timer.h"
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 
 namespace Nexus {
 
+namespace {
+constexpr uint32_t NO_PARENT = ~0u;
+// How far from an entity FindNearestCoverPoint() looks
+constexpr float COVER_SEARCH_RADIUS = 30.0f;
+// How far avoidance may push an entity off the navmesh before it is no longer pulled back on
+constexpr float CROWD_SNAP_RADIUS = 2.0f;
+// The capsule an entity moves as when AIManager has physics
+constexpr float CHARACTER_HEIGHT = 1.8f;
+constexpr float CHARACTER_GRAVITY = 9.81f;
+
+// AIManager's utility inputs, added in this order
+enum UtilityInput : uint32_t {
+    UTILITY_HEALTH,
+    UTILITY_AGGRESSION,
+    UTILITY_CAUTIOUSNESS,
+    UTILITY_INTELLIGENCE,
+    UTILITY_ALERT,
+    UTILITY_IN_COVER,
+    UTILITY_TARGET_VISIBLE,
+    UTILITY_TARGET_DISTANCE,
+    UTILITY_SQUAD_ALERT,
+    UTILITY_SQUAD_STRENGTH,
+    UTILITY_INPUT_COUNT
+};
+const char* const UTILITY_INPUT_NAMES[UTILITY_INPUT_COUNT] = {
+    "health", "aggression", "cautiousness", "intelligence", "alert", "in cover",
+    "target visible", "target distance", "squad alert", "squad strength"
+};
+
+float Distance(const AIVector3& a, const AIVector3& b) {
+    float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+// Twice the signed area of abc seen from above, same convention as the navmesh polygons
+float TriArea2(const AIVector3& a, const AIVector3& b, const AIVector3& c) {
+    return (b.z - a.z) * (c.x - a.x) - (b.x - a.x) * (c.z - a.z);
+}
+
+// Leaf function of nodes authored with a std::function
+AIBehaviorTree::NodeStatus InvokeExecute(AIEntity* entity, float*, void* context) {
+    return static_cast<AIBehaviorTree::Node*>(context)->execute(entity);
+}
+
+// Patrol tree shared by every entity that isn't given its own
+std::shared_ptr<AIBehaviorTree> DefaultBehaviorTree() {
+    static std::shared_ptr<AIBehaviorTree> tree = [] {
+        auto patrol = std::make_shared<AIBehaviorTree>();
+        patrol->SetRootNode(patrol->CreatePatrolNode());
+        return patrol;
+    }();
+    return tree;
+}
+
+bool SamePoint(const AIVector3& a, const AIVector3& b) {
+    float dx = a.x - b.x, dz = a.z - b.z;
+    return dx * dx + dz * dz < 1e-8f;
+}
+
+// Binary min-heap on f over node indices; each node tracks its slot so a cheaper path can move it up
+template<typename Node>
+void SiftUp(std::vector<uint32_t>& heap, std::vector<Node>& nodes, uint32_t slot) {
+    const uint32_t index = heap[slot];
+    while (slot > 0) {
+        uint32_t parent = (slot - 1) / 2;
+        if (nodes[heap[parent]].f <= nodes[index].f) break;
+        heap[slot] = heap[parent];
+        nodes[heap[slot]].heapIndex = slot;
+        slot = parent;
+    }
+    heap[slot] = index;
+    nodes[index].heapIndex = slot;
+}
+
+template<typename Node>
+void HeapPush(std::vector<uint32_t>& heap, std::vector<Node>& nodes, uint32_t index) {
+    heap.push_back(index);
+    SiftUp(heap, nodes, static_cast<uint32_t>(heap.size() - 1));
+}
+
+template<typename Node>
+uint32_t HeapPop(std::vector<uint32_t>& heap, std::vector<Node>& nodes) {
+    const uint32_t top = heap[0];
+    const uint32_t last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        const uint32_t count = static_cast<uint32_t>(heap.size());
+        uint32_t slot = 0;
+        for (;;) {
+            uint32_t child = slot * 2 + 1;
+            if (child >= count) break;
+            if (child + 1 < count && nodes[heap[child + 1]].f < nodes[heap[child]].f) ++child;
+            if (nodes[heap[child]].f >= nodes[last].f) break;
+            heap[slot] = heap[child];
+            nodes[heap[slot]].heapIndex = slot;
+            slot = child;
+        }
+        heap[slot] = last;
+        nodes[last].heapIndex = slot;
+    }
+    return top;
+}
+}
+
 // AIBehaviorTree implementation
-AIBehaviorTree::AIBehaviorTree() : rootNode_(nullptr) {}
+AIBehaviorTree::AIBehaviorTree()
+    : rootNode_(nullptr)
+    , blackboardSize_(0)
+    , revision_(0) {}
+
+std::shared_ptr<AIBehaviorTree::Node> AIBehaviorTree::CreateNode(NodeType type, const std::string& name,
+                                                                 LeafFunction function, void* context) {
+    auto node = std::make_shared<Node>();
+    node->type = type;
+    node->name = name;
+    node->function = function;
+    node->context = context;
+    return node;
+}
+
+void AIBehaviorTree::AddChild(const std::shared_ptr<Node>& parent, std::shared_ptr<Node> child) {
+    child->parent = parent;
+    parent->children.push_back(std::move(child));
+}
 
 void AIBehaviorTree::SetRootNode(std::shared_ptr<Node> root) {
     rootNode_ = root;
+    Compile();
+}
+
+bool AIBehaviorTree::Compile() {
+    nodes_.clear();
+    revision_++;
+    if (!rootNode_) return true;
+    
+    if (!Flatten(rootNode_, INVALID_NODE, 0)) {
+        Logger::Error("AIBehaviorTree: Tree deeper than " + std::to_string(MAX_DEPTH) + " levels, is there a cycle?");
+        nodes_.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AIBehaviorTree::Flatten(const std::shared_ptr<Node>& node, uint32_t parent, uint32_t depth) {
+    if (depth >= MAX_DEPTH) return false;
+    
+    const uint32_t index = static_cast<uint32_t>(nodes_.size());
+    FlatNode flat;
+    flat.type = node->type;
+    flat.parent = parent;
+    flat.function = node->function;
+    flat.context = node->context;
+    if (!flat.function && node->execute) {
+        flat.function = InvokeExecute;
+        flat.context = node.get();
+    }
+    nodes_.push_back(flat);
+    
+    for (const auto& child : node->children) {
+        if (child && !Flatten(child, index, depth + 1)) return false;
+    }
+    nodes_[index].subtreeEnd = static_cast<uint32_t>(nodes_.size());
+    return true;
+}
+
+uint32_t AIBehaviorTree::AddBlackboardKey(const std::string& name, uint32_t floatCount) {
+    auto it = blackboardKeys_.find(name);
+    if (it != blackboardKeys_.end()) return it->second;
+    
+    uint32_t slot = blackboardSize_;
+    blackboardKeys_[name] = slot;
+    blackboardSize_ += std::max(floatCount, 1u);
+    revision_++;
+    return slot;
+}
+
+uint32_t AIBehaviorTree::GetBlackboardKey(const std::string& name) const {
+    auto it = blackboardKeys_.find(name);
+    return it != blackboardKeys_.end() ? it->second : INVALID_KEY;
+}
+
+void AIBehaviorTree::ResetState(AIBehaviorTreeState& state) const {
+    state.blackboard.assign(blackboardSize_, 0.0f);
+    state.runningNode = INVALID_NODE;
+    state.tree = this;
+    state.revision = revision_;
 }
 
 AIBehaviorTree::NodeStatus AIBehaviorTree::Execute(AIEntity* entity) {
-    if (!rootNode_) {
+    return Execute(entity, entity->GetBehaviorTreeState());
+}
+
+AIBehaviorTree::NodeStatus AIBehaviorTree::Execute(AIEntity* entity, AIBehaviorTreeState& state) const {
+    if (nodes_.empty()) {
         return NodeStatus::Failure;
     }
-    return ExecuteNode(rootNode_, entity);
+    if (state.tree != this || state.revision != revision_) {
+        ResetState(state);
+    }
+    
+    uint32_t start = state.runningNode != INVALID_NODE ? state.runningNode : 0;
+    state.runningNode = INVALID_NODE;
+    return Run(0, start, entity, state, true);
 }
 
 AIBehaviorTree::NodeStatus AIBehaviorTree::ExecuteNode(std::shared_ptr<Node> node, AIEntity* entity) {
@@ -24,23 +222,114 @@ AIBehaviorTree::NodeStatus AIBehaviorTree::ExecuteNode(std::shared_ptr<Node> nod
         return NodeStatus::Failure;
     }
     
-    if (node->execute) {
-        return node->execute(entity);
+    // Compile the subtree on its own; the blackboard layout is shared with the whole tree
+    AIBehaviorTree subtree;
+    subtree.rootNode_ = node;
+    subtree.blackboardSize_ = blackboardSize_;
+    if (!subtree.Compile()) {
+        return NodeStatus::Failure;
     }
     
-    return NodeStatus::Failure;
+    AIBehaviorTreeState& state = entity->GetBehaviorTreeState();
+    if (state.blackboard.size() < blackboardSize_) state.blackboard.resize(blackboardSize_, 0.0f);
+    return subtree.Run(0, 0, entity, state, false);
+}
+
+AIBehaviorTree::NodeStatus AIBehaviorTree::Run(uint32_t root, uint32_t node, AIEntity* entity, AIBehaviorTreeState& state,
+                                               bool resumable) const {
+    NodeStatus status = NodeStatus::Failure;
+    bool entering = true;
+    
+    for (;;) {
+        const FlatNode& flat = nodes_[node];
+        
+        if (entering) {
+            const bool isLeaf = flat.subtreeEnd == node + 1;
+            entering = false;
+            
+            if (flat.function) {
+                // A leaf's result, or a guard in front of the children
+                status = flat.function(entity, state.blackboard.data(), flat.context);
+                if (status == NodeStatus::Running) {
+                    if (resumable) state.runningNode = node;
+                    return status;
+                }
+                if (!isLeaf && status == NodeStatus::Success) entering = true;
+            } else if (isLeaf) {
+                status = (flat.type == NodeType::Sequence || flat.type == NodeType::Parallel) ? NodeStatus::Success
+                                                                                               : NodeStatus::Failure;
+            } else {
+                entering = true;
+            }
+            
+            if (entering) {
+                if (flat.type == NodeType::Parallel) {
+                    status = RunParallel(node, entity, state);
+                    if (status == NodeStatus::Running) {
+                        if (resumable) state.runningNode = node;
+                        return status;
+                    }
+                    entering = false;
+                } else {
+                    node = node + 1;
+                    continue;
+                }
+            }
+        }
+        
+        // node finished with status; let its parent decide what runs next
+        if (node == root) return status;
+        
+        const uint32_t parent = flat.parent;
+        const FlatNode& composite = nodes_[parent];
+        const uint32_t next = flat.subtreeEnd;
+        const bool hasNext = next < composite.subtreeEnd;
+        
+        if (composite.type == NodeType::Selector) {
+            if (status == NodeStatus::Failure && hasNext) {
+                node = next;
+                entering = true;
+                continue;
+            }
+        } else {
+            // Sequences, and any other node type with children, run them in order
+            if (status == NodeStatus::Success && hasNext) {
+                node = next;
+                entering = true;
+                continue;
+            }
+            if (composite.type == NodeType::Decorator && !composite.function) {
+                status = status == NodeStatus::Success ? NodeStatus::Failure : NodeStatus::Success;
+            }
+        }
+        node = parent;
+    }
+}
+
+AIBehaviorTree::NodeStatus AIBehaviorTree::RunParallel(uint32_t node, AIEntity* entity, AIBehaviorTreeState& state) const {
+    bool running = false;
+    for (uint32_t child = node + 1; child < nodes_[node].subtreeEnd; child = nodes_[child].subtreeEnd) {
+        NodeStatus status = Run(child, child, entity, state, false);
+        if (status == NodeStatus::Failure) return status;
+        if (status == NodeStatus::Running) running = true;
+    }
+    return running ? NodeStatus::Running : NodeStatus::Success;
 }
 
 std::shared_ptr<AIBehaviorTree::Node> AIBehaviorTree::CreatePatrolNode() {
+    // The angle lives on the blackboard, so entities sharing the tree patrol independently and
+    // may think on different threads
+    uintptr_t angleSlot = AddBlackboardKey("patrolAngle");
     auto node = std::make_shared<Node>();
     node->type = NodeType::Leaf;
     node->name = "Patrol";
-    node->execute = [](AIEntity* entity) -> NodeStatus {
+    node->context = reinterpret_cast<void*>(angleSlot);
+    node->function = [](AIEntity* entity, float* blackboard, void* context) -> NodeStatus {
         // Implement patrol behavior
         auto position = entity->GetPosition();
         
         // Simple patrol logic - move in a circle
-        static float angle = 0.0f;
+        float& angle = blackboard[reinterpret_cast<uintptr_t>(context)];
         angle += 0.01f;
         if (angle > 6.28f) angle = 0.0f;
         
@@ -81,7 +370,7 @@ std::shared_ptr<AIBehaviorTree::Node> AIBehaviorTree::CreateFlankingNode() {
     node->execute = [](AIEntity* entity) -> NodeStatus {
         // Implement flanking behavior
         // This would calculate flanking positions and move to them
-        Logger::Debug("AI entity attempting flanking maneuver");
+        NEXUS_LOG_DEBUG("AI entity attempting flanking maneuver");
         return NodeStatus::Running;
     };
     return node;
@@ -93,7 +382,7 @@ std::shared_ptr<AIBehaviorTree::Node> AIBehaviorTree::CreateCoverSeekingNode() {
     node->name = "SeekCover";
     node->execute = [](AIEntity* entity) -> NodeStatus {
         // Implement cover seeking behavior
-        Logger::Debug("AI entity seeking cover");
+        NEXUS_LOG_DEBUG("AI entity seeking cover");
         return NodeStatus::Running;
     };
     return node;
@@ -105,7 +394,7 @@ std::shared_ptr<AIBehaviorTree::Node> AIBehaviorTree::CreateGroupCoordinationNod
     node->name = "GroupCoordination";
     node->execute = [](AIEntity* entity) -> NodeStatus {
         // Implement group coordination behavior
-        Logger::Debug("AI entity coordinating with group");
+        NEXUS_LOG_DEBUG("AI entity coordinating with group");
         return NodeStatus::Running;
     };
     return node;
@@ -157,8 +446,30 @@ void AIStateMachine::Update(AIEntity* entity, float deltaTime) {
 // AIPathfinding implementation
 std::vector<DirectX::XMFLOAT3> AIPathfinding::FindPath(const DirectX::XMFLOAT3& start, const DirectX::XMFLOAT3& goal) {
     std::vector<DirectX::XMFLOAT3> path;
+    FindPath(start, goal, path);
+    return path;
+}
+
+void AIPathfinding::FindPath(const DirectX::XMFLOAT3& start, const DirectX::XMFLOAT3& goal, std::vector<DirectX::XMFLOAT3>& path) {
+    path.clear();
+    
+    if (navMesh_ && navMesh_->GetPolygonCount() > 0) {
+        NEXUS_PROFILE_SCOPE("AIPathfinding::FindPath");
+        SyncNavMesh();
+        stats_.queries++;
+        
+        // Snap both ends onto the mesh; an agent with nowhere to go gets an empty path
+        AIVector3 from, to;
+        uint32_t startPolygon = navMesh_->FindNearestPolygon(start, searchRadius_, &from);
+        uint32_t goalPolygon = navMesh_->FindNearestPolygon(goal, searchRadius_, &to);
+        if (startPolygon == NavMesh::INVALID_POLYGON || goalPolygon == NavMesh::INVALID_POLYGON) return;
+        if (!FindCorridor(startPolygon, goalPolygon, from, to)) return;
+        
+        StringPull(from, to, path);
+        return;
+    }
     
-    // Simple straight-line path for now
+    // No navmesh: straight line
     path.push_back(start);
     
     // Add intermediate points
@@ -184,7 +495,424 @@ std::vector<DirectX::XMFLOAT3> AIPathfinding::FindPath(const DirectX::XMFLOAT3&
     }
     
     path.push_back(goal);
-    return path;
+}
+
+void AIPathfinding::SetNavMesh(std::shared_ptr<NavMesh> navMesh) {
+    navMesh_ = navMesh;
+    navMeshRevision_ = 0;
+    ClearPathCache();
+    SyncNavMesh();
+}
+
+void AIPathfinding::SetPathCacheSize(size_t entries) {
+    cacheSize_ = entries;
+    while (cache_.size() > cacheSize_) {
+        cacheIndex_.erase(cache_.back().key);
+        cache_.pop_back();
+    }
+}
+
+void AIPathfinding::ClearPathCache() {
+    cache_.clear();
+    cacheIndex_.clear();
+}
+
+void AIPathfinding::SyncNavMesh() {
+    uint32_t revision = navMesh_ ? navMesh_->GetRevision() : 0;
+    if (revision == navMeshRevision_ && (!navMesh_ || polygonNodes_.size() == navMesh_->GetPolygonCount())) return;
+    
+    navMeshRevision_ = revision;
+    ClearPathCache();
+    polygonNodes_.assign(navMesh_ ? navMesh_->GetPolygonCount() : 0, SearchNode());
+    clusterNodes_.assign(navMesh_ ? navMesh_->GetClusterCount() : 0, SearchNode());
+    routeStamps_.assign(clusterNodes_.size(), 0);
+    generation_ = 0;
+    routeId_ = 0;
+}
+
+uint32_t AIPathfinding::NextGeneration() {
+    // Restart the stamps rather than let an old node look current after wrapping
+    if (++generation_ == 0) {
+        for (SearchNode& node : polygonNodes_) node.generation = 0;
+        for (SearchNode& node : clusterNodes_) node.generation = 0;
+        generation_ = 1;
+    }
+    return generation_;
+}
+
+bool AIPathfinding::FindCorridor(uint32_t startPolygon, uint32_t goalPolygon, const AIVector3& start, const AIVector3& goal) {
+    const uint64_t key = (static_cast<uint64_t>(startPolygon) << 32) | goalPolygon;
+    auto cached = cacheIndex_.find(key);
+    if (cached != cacheIndex_.end()) {
+        cache_.splice(cache_.begin(), cache_, cached->second);
+        corridor_ = cached->second->corridor;
+        stats_.cacheHits++;
+        return true;
+    }
+    
+    // Long paths first choose their clusters. Clusters are connected inside, so the restricted
+    // search only fails when the coarse graph disagrees with the mesh; then search everything
+    const uint32_t startCluster = navMesh_->GetPolygon(startPolygon).cluster;
+    const uint32_t goalCluster = navMesh_->GetPolygon(goalPolygon).cluster;
+    bool found = false;
+    if (startCluster != goalCluster) {
+        if (!FindClusterRoute(startCluster, goalCluster)) return false;
+        found = SearchPolygons(startPolygon, goalPolygon, start, goal, true);
+    }
+    if (!found) found = SearchPolygons(startPolygon, goalPolygon, start, goal, false);
+    if (!found) return false;
+    
+    if (cacheSize_ > 0) {
+        cache_.push_front({ key, corridor_ });
+        cacheIndex_[key] = cache_.begin();
+        if (cache_.size() > cacheSize_) {
+            cacheIndex_.erase(cache_.back().key);
+            cache_.pop_back();
+        }
+    }
+    return true;
+}
+
+bool AIPathfinding::FindClusterRoute(uint32_t startCluster, uint32_t goalCluster) {
+    const NavMesh& mesh = *navMesh_;
+    const uint32_t generation = NextGeneration();
+    const AIVector3& goalCenter = mesh.GetCluster(goalCluster).center;
+    
+    openList_.clear();
+    SearchNode& first = clusterNodes_[startCluster];
+    first = { 0.0f, Distance(mesh.GetCluster(startCluster).center, goalCenter), NO_PARENT, 0, generation, false,
+              mesh.GetCluster(startCluster).center };
+    HeapPush(openList_, clusterNodes_, startCluster);
+    
+    while (!openList_.empty()) {
+        const uint32_t current = HeapPop(openList_, clusterNodes_);
+        clusterNodes_[current].closed = true;
+        stats_.nodesExpanded++;
+        
+        if (current == goalCluster) {
+            if (++routeId_ == 0) {
+                std::fill(routeStamps_.begin(), routeStamps_.end(), 0u);
+                routeId_ = 1;
+            }
+            for (uint32_t cluster = current; cluster != NO_PARENT; cluster = clusterNodes_[cluster].parent) {
+                routeStamps_[cluster] = routeId_;
+            }
+            return true;
+        }
+        
+        const NavMesh::Cluster& cluster = mesh.GetCluster(current);
+        for (uint32_t l = cluster.firstLink; l < cluster.firstLink + cluster.linkCount; ++l) {
+            const NavMesh::ClusterLink& link = mesh.GetClusterLink(l);
+            SearchNode& next = clusterNodes_[link.cluster];
+            if (next.generation == generation && next.closed) continue;
+            
+            const float g = clusterNodes_[current].g + link.cost;
+            if (next.generation != generation) {
+                const AIVector3& center = mesh.GetCluster(link.cluster).center;
+                next = { g, g + Distance(center, goalCenter), current, 0, generation, false, center };
+                HeapPush(openList_, clusterNodes_, link.cluster);
+            } else if (g < next.g) {
+                next.f -= next.g - g;
+                next.g = g;
+                next.parent = current;
+                SiftUp(openList_, clusterNodes_, next.heapIndex);
+            }
+        }
+    }
+    return false;
+}
+
+bool AIPathfinding::SearchPolygons(uint32_t startPolygon, uint32_t goalPolygon, const AIVector3& start,
+                                   const AIVector3& goal, bool onRoute) {
+    const NavMesh& mesh = *navMesh_;
+    const uint32_t generation = NextGeneration();
+    
+    openList_.clear();
+    polygonNodes_[startPolygon] = { 0.0f, Distance(start, goal), NO_PARENT, 0, generation, false, start };
+    HeapPush(openList_, polygonNodes_, startPolygon);
+    
+    while (!openList_.empty()) {
+        const uint32_t current = HeapPop(openList_, polygonNodes_);
+        polygonNodes_[current].closed = true;
+        stats_.nodesExpanded++;
+        
+        if (current == goalPolygon) {
+            corridor_.clear();
+            for (uint32_t polygon = current; polygon != NO_PARENT; polygon = polygonNodes_[polygon].parent) {
+                corridor_.push_back(polygon);
+            }
+            std::reverse(corridor_.begin(), corridor_.end());
+            return true;
+        }
+        
+        const NavMesh::Polygon& polygon = mesh.GetPolygon(current);
+        for (uint32_t e = 0; e < polygon.vertexCount; ++e) {
+            const uint32_t neighbour = mesh.GetNeighbour(current, e);
+            if (neighbour == NavMesh::INVALID_POLYGON) continue;
+            if (onRoute && routeStamps_[mesh.GetPolygon(neighbour).cluster] != routeId_) continue;
+            SearchNode& next = polygonNodes_[neighbour];
+            if (next.generation == generation && next.closed) continue;
+            
+            // Enter through the middle of the shared edge; the goal polygon is scored at the goal
+            const AIVector3& a = mesh.GetCorner(current, e);
+            const AIVector3& b = mesh.GetCorner(current, (e + 1) % polygon.vertexCount);
+            AIVector3 position((a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f);
+            float g = polygonNodes_[current].g + Distance(polygonNodes_[current].position, position);
+            float h = Distance(position, goal);
+            if (neighbour == goalPolygon) {
+                g += h;
+                h = 0.0f;
+            }
+            
+            if (next.generation != generation) {
+                next = { g, g + h, current, 0, generation, false, position };
+                HeapPush(openList_, polygonNodes_, neighbour);
+            } else if (g < next.g) {
+                next.g = g;
+                next.f = g + h;
+                next.parent = current;
+                next.position = position;
+                SiftUp(openList_, polygonNodes_, next.heapIndex);
+            }
+        }
+    }
+    return false;
+}
+
+void AIPathfinding::StringPull(const AIVector3& start, const AIVector3& goal, std::vector<AIVector3>& path) const {
+    // Simple stupid funnel (Mononen): widen the funnel through each portal, and when one side
+    // crosses the other, the corner it crossed becomes a path point and the scan restarts there
+    const size_t portalCount = corridor_.size() + 1;
+    auto portal = [&](size_t i, AIVector3& left, AIVector3& right) {
+        if (i == 0) {
+            left = right = start;
+        } else if (i == corridor_.size()) {
+            left = right = goal;
+        } else if (!navMesh_->GetPortal(corridor_[i - 1], corridor_[i], left, right)) {
+            left = right = navMesh_->GetPolygon(corridor_[i]).center;
+        }
+    };
+    
+    path.push_back(start);
+    AIVector3 apex = start, funnelLeft = start, funnelRight = start;
+    size_t apexIndex = 0, leftIndex = 0, rightIndex = 0;
+    for (size_t i = 1; i < portalCount; ++i) {
+        AIVector3 left, right;
+        portal(i, left, right);
+        
+        // Right side: tighten if it moves inwards, unless it crosses over the left
+        if (TriArea2(apex, funnelRight, right) <= 0.0f) {
+            if (SamePoint(apex, funnelRight) || TriArea2(apex, funnelLeft, right) > 0.0f) {
+                funnelRight = right;
+                rightIndex = i;
+            } else {
+                if (!SamePoint(path.back(), funnelLeft)) path.push_back(funnelLeft);
+                apex = funnelLeft;
+                apexIndex = leftIndex;
+                funnelRight = apex;
+                rightIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+        
+        // Left side, mirrored
+        if (TriArea2(apex, funnelLeft, left) >= 0.0f) {
+            if (SamePoint(apex, funnelLeft) || TriArea2(apex, funnelRight, left) < 0.0f) {
+                funnelLeft = left;
+                leftIndex = i;
+            } else {
+                if (!SamePoint(path.back(), funnelRight)) path.push_back(funnelRight);
+                apex = funnelRight;
+                apexIndex = rightIndex;
+                funnelLeft = apex;
+                leftIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+    }
+    
+    if (!SamePoint(path.back(), goal) || path.size() == 1) path.push_back(goal);
+}
+
+AIVector3 AIPathfinding::FindNearestCoverPoint(const AIVector3& position, const AIVector3& threatDirection) {
+    if (!coverMap_) return position;
+    uint32_t point = coverMap_->FindNearestProtected(position, COVER_SEARCH_RADIUS, threatDirection);
+    return point == CoverMap::INVALID_POINT ? position : coverMap_->GetPoint(point).position;
+}
+
+// PathQueryService implementation
+PathQueryService::PathQueryService()
+    : jobs_(nullptr)
+    , nextHandle_(1)
+    , iterationBudget_(DEFAULT_ITERATION_BUDGET)
+    , batchCounter_(std::make_unique<JobCounter>())
+    , batchCursor_(0)
+    , batchNodes_(0)
+    , batchInFlight_(false)
+{
+    lanes_.push_back(std::make_unique<AIPathfinding>());
+}
+
+PathQueryService::~PathQueryService() {
+    Flush();
+}
+
+void PathQueryService::SetNavMesh(std::shared_ptr<NavMesh> navMesh) {
+    Flush();
+    navMesh_ = navMesh;
+    for (auto& lane : lanes_) {
+        lane->SetNavMesh(navMesh_);
+    }
+}
+
+void PathQueryService::SetJobSystem(JobSystem* jobs) {
+    Flush();
+    jobs_ = jobs;
+    
+    // A lane per worker plus one for the thread waiting on them
+    size_t laneCount = (jobs_ && jobs_->IsInitialized()) ? jobs_->GetWorkerCount() + 1 : 1;
+    lanes_.resize(laneCount);
+    for (auto& lane : lanes_) {
+        if (!lane) {
+            lane = std::make_unique<AIPathfinding>();
+            lane->SetNavMesh(navMesh_);
+        }
+    }
+}
+
+PathQueryService::Handle PathQueryService::Submit(const AIVector3& start, const AIVector3& goal, PathPriority priority) {
+    Handle handle = nextHandle_++;
+    if (nextHandle_ == INVALID_HANDLE) nextHandle_ = 1;
+    
+    Request& request = requests_[handle];
+    request.start = start;
+    request.goal = goal;
+    request.priority = priority;
+    request.status = Status::Pending;
+    request.framesWaiting = 0;
+    request.path.clear();
+    queue_.push_back(handle);
+    
+    stats_.submitted++;
+    return handle;
+}
+
+void PathQueryService::Cancel(Handle handle) {
+    // Still queued or in flight entries are skipped once they find the request gone
+    if (requests_.erase(handle) > 0) stats_.cancelled++;
+}
+
+PathQueryService::Status PathQueryService::GetStatus(Handle handle) const {
+    auto it = requests_.find(handle);
+    return it != requests_.end() ? it->second.status : Status::Invalid;
+}
+
+bool PathQueryService::TakeResult(Handle handle, std::vector<AIVector3>& path) {
+    auto it = requests_.find(handle);
+    if (it == requests_.end() || it->second.status == Status::Pending) return false;
+    
+    path.swap(it->second.path);
+    requests_.erase(it);
+    return true;
+}
+
+void PathQueryService::Update() {
+    NEXUS_PROFILE_SCOPE("PathQueryService::Update");
+    PublishBatch();
+    
+    // Drop cancelled entries and age the rest
+    queue_.erase(std::remove_if(queue_.begin(), queue_.end(),
+        [this](Handle handle) { return requests_.find(handle) == requests_.end(); }), queue_.end());
+    for (Handle handle : queue_) {
+        requests_[handle].framesWaiting++;
+    }
+    stats_.pending = static_cast<uint32_t>(queue_.size());
+    if (queue_.empty()) return;
+    
+    // Most urgent first, oldest first within a priority; handles grow with submission order
+    auto rank = [this](Handle handle) {
+        const Request& request = requests_[handle];
+        uint32_t promotion = request.framesWaiting / PROMOTE_FRAMES;
+        uint32_t priority = static_cast<uint32_t>(request.priority);
+        return priority > promotion ? priority - promotion : 0u;
+    };
+    std::stable_sort(queue_.begin(), queue_.end(), [&rank](Handle a, Handle b) { return rank(a) < rank(b); });
+    
+    // Hand every queued request to the batch; lanes stop early once the budget is spent and the
+    // untouched remainder goes back in the queue when the batch is published
+    batch_.resize(queue_.size());
+    for (size_t i = 0; i < queue_.size(); ++i) {
+        const Request& request = requests_[queue_[i]];
+        BatchItem& item = batch_[i];
+        item.handle = queue_[i];
+        item.start = request.start;
+        item.goal = request.goal;
+        item.done = false;
+    }
+    queue_.clear();
+    
+    batchCursor_.store(0, std::memory_order_relaxed);
+    batchNodes_.store(0, std::memory_order_relaxed);
+    batchInFlight_ = true;
+    
+    if (jobs_ && jobs_->IsInitialized() && lanes_.size() > 1) {
+        size_t laneCount = std::min(lanes_.size(), batch_.size());
+        for (size_t lane = 0; lane < laneCount; ++lane) {
+            jobs_->Execute([this, lane]() { RunLane(lane); }, batchCounter_.get());
+        }
+    } else {
+        RunLane(0);
+    }
+}
+
+void PathQueryService::RunLane(size_t lane) {
+    AIPathfinding& pathfinding = *lanes_[lane];
+    const uint32_t count = static_cast<uint32_t>(batch_.size());
+    
+    for (;;) {
+        // The first request always runs so a tiny budget still makes progress
+        uint32_t index = batchCursor_.fetch_add(1, std::memory_order_relaxed);
+        if (index >= count) break;
+        if (index > 0 && batchNodes_.load(std::memory_order_relaxed) >= iterationBudget_) break;
+        
+        BatchItem& item = batch_[index];
+        uint32_t expanded = pathfinding.GetStats().nodesExpanded;
+        pathfinding.FindPath(item.start, item.goal, item.path);
+        batchNodes_.fetch_add(pathfinding.GetStats().nodesExpanded - expanded, std::memory_order_relaxed);
+        item.done = true;
+    }
+}
+
+void PathQueryService::Flush() {
+    PublishBatch();
+}
+
+void PathQueryService::PublishBatch() {
+    if (!batchInFlight_) return;
+    if (jobs_) jobs_->Wait(*batchCounter_);
+    batchInFlight_ = false;
+    
+    uint32_t completed = 0;
+    for (BatchItem& item : batch_) {
+        auto it = requests_.find(item.handle);
+        if (it == requests_.end()) continue;   // Cancelled while in flight
+        
+        Request& request = it->second;
+        if (!item.done) {
+            queue_.push_back(item.handle);
+            continue;
+        }
+        request.path.swap(item.path);
+        request.status = request.path.empty() ? Status::Failed : Status::Ready;
+        completed++;
+    }
+    
+    stats_.completed += completed;
+    stats_.lastBatchRequests = completed;
+    stats_.lastBatchNodes = batchNodes_.load(std::memory_order_relaxed);
+    batch_.clear();
 }
 
 // AIEntity implementation
@@ -192,6 +920,17 @@ AIEntity::AIEntity()
     : position_(0.0f, 0.0f, 0.0f)
     , rotation_(0.0f, 0.0f, 0.0f, 1.0f)
     , personality_(AIPersonality::Tactical)
+    , pathRequest_(PathQueryService::INVALID_HANDLE)
+    , isOnScreen_(false)
+    , team_(0)
+    , gridItem_(AISpatialGrid::INVALID_ITEM)
+    , lodTier_(AILODTier::Near)
+    , thinkTime_(0.0f)
+    , thinking_(false)
+    , hasMoveIntent_(false)
+    , moveIntent_(0.0f, 0.0f, 0.0f)
+    , moveIntentPriority_(PathPriority::Background)
+    , flowDestination_(0.0f, 0.0f, 0.0f)
     , aggression_(0.5f)
     , cautiousness_(0.5f)
     , intelligence_(0.5f)
@@ -202,33 +941,49 @@ AIEntity::AIEntity()
     , isAlive_(true)
     , isAlert_(false)
     , debugMode_(false)
+    , isActive_(true)
     , moveSpeed_(5.0f)
-    , turnSpeed_(3.0f) {}
+    , turnSpeed_(3.0f)
+    , radius_(0.4f)
+    , velocity_(0.0f, 0.0f, 0.0f)
+    , preferredVelocity_(0.0f, 0.0f, 0.0f)
+    , holding_(false)
+    , holdPosition_(0.0f, 0.0f, 0.0f)
+    , character_(0)
+    , hearingRange_(25.0f)
+    , sightRange_(40.0f)
+    , fieldOfViewAngle_(120.0f)
+    , utilityAction_(UtilityScorer::NO_ACTION)
+    , utilityScore_(0.0f) {}
 
-AIPathfinding::AIPathfinding() {
-    Logger::Debug("AIPathfinding: Initialized");
+AIPathfinding::AIPathfinding()
+    : navMeshRevision_(0)
+    , searchRadius_(2.0f)
+    , routeId_(0)
+    , generation_(0)
+    , cacheSize_(DEFAULT_CACHE_SIZE)
+{
+    NEXUS_LOG_DEBUG("AIPathfinding: Initialized");
 }
 
 void AIEntity::Initialize(const DirectX::XMFLOAT3& position) {
     position_ = position;
     
-    // Initialize AI systems
-    behaviorTree_ = std::make_shared<AIBehaviorTree>();
+    // Initialize AI systems; entities without a tree of their own share the default one
+    if (!behaviorTree_) behaviorTree_ = DefaultBehaviorTree();
     stateMachine_ = std::make_shared<AIStateMachine>();
-    pathfinding_ = std::make_shared<AIPathfinding>();
-    
-    // Set up default behavior tree
-    auto patrolNode = behaviorTree_->CreatePatrolNode();
-    behaviorTree_->SetRootNode(patrolNode);
+    if (!pathfinding_) pathfinding_ = std::make_shared<AIPathfinding>();
     
     // Set up state machine
     SetupStateMachine();
     
     isAlive_ = true;
-    Logger::Info("AI Entity initialized at position (" + 
-                std::to_string(position.x) + ", " + 
-                std::to_string(position.y) + ", " + 
-                std::to_string(position.z) + ")");
+    NEXUS_LOG_DEBUG("AI Entity initialized at position ({}, {}, {})", position.x, position.y, position.z);
+}
+
+void AIEntity::SetBehaviorTree(std::shared_ptr<AIBehaviorTree> behaviorTree) {
+    behaviorTree_ = behaviorTree;
+    behaviorTreeState_ = AIBehaviorTreeState();
 }
 
 void AIEntity::SetupStateMachine() {
@@ -236,7 +991,7 @@ void AIEntity::SetupStateMachine() {
     AIStateMachine::State idleState;
     idleState.stateType = AIState::Idle;
     idleState.onEnter = [](AIEntity* entity) {
-        Logger::Debug("AI entering Idle state");
+        NEXUS_LOG_DEBUG("AI entering Idle state");
     };
     idleState.onUpdate = [](AIEntity* entity, float deltaTime) {
         // Check for targets or patrol triggers
@@ -250,7 +1005,7 @@ void AIEntity::SetupStateMachine() {
     AIStateMachine::State patrolState;
     patrolState.stateType = AIState::Patrol;
     patrolState.onEnter = [](AIEntity* entity) {
-        Logger::Debug("AI entering Patrol state");
+        NEXUS_LOG_DEBUG("AI entering Patrol state");
     };
     patrolState.onUpdate = [](AIEntity* entity, float deltaTime) {
         // Execute patrol behavior
@@ -267,7 +1022,7 @@ void AIEntity::SetupStateMachine() {
     AIStateMachine::State chaseState;
     chaseState.stateType = AIState::Chase;
     chaseState.onEnter = [](AIEntity* entity) {
-        Logger::Debug("AI entering Chase state");
+        NEXUS_LOG_DEBUG("AI entering Chase state");
     };
     chaseState.onUpdate = [](AIEntity* entity, float deltaTime) {
         // Execute chase behavior
@@ -281,7 +1036,7 @@ void AIEntity::SetupStateMachine() {
     AIStateMachine::State attackState;
     attackState.stateType = AIState::Attack;
     attackState.onEnter = [](AIEntity* entity) {
-        Logger::Debug("AI entering Attack state");
+        NEXUS_LOG_DEBUG("AI entering Attack state");
     };
     attackState.onUpdate = [](AIEntity* entity, float deltaTime) {
         // Execute attack behavior
@@ -297,6 +1052,16 @@ void AIEntity::SetupStateMachine() {
 void AIEntity::Update(float deltaTime) {
     if (!isAlive_) return;
     
+    PublishSnapshot();
+    Think(deltaTime);
+    ApplyIntents();
+    UpdateMotion(deltaTime);
+}
+
+void AIEntity::Think(float deltaTime) {
+    thinkTime_ = 0.0f;
+    thinking_ = true;
+    
     // Update AI systems
     if (behaviorTree_) {
         behaviorTree_->Execute(this);
@@ -306,12 +1071,143 @@ void AIEntity::Update(float deltaTime) {
         stateMachine_->Update(this, deltaTime);
     }
     
+    thinking_ = false;
+}
+
+void AIEntity::PublishSnapshot() {
+    snapshot_.position = position_;
+    snapshot_.state = stateMachine_ ? stateMachine_->GetCurrentState() : AIState::Idle;
+    snapshot_.team = team_;
+    snapshot_.alive = isAlive_;
+    snapshot_.alert = isAlert_;
+}
+
+void AIEntity::ApplyIntents() {
+    if (hasMoveIntent_) {
+        hasMoveIntent_ = false;
+        MoveTo(moveIntent_, moveIntentPriority_);
+    }
+    
+    // Swap out first: a message may make its recipient queue one of its own
+    if (outbox_.empty()) return;
+    std::vector<AISquadMessage> messages;
+    messages.swap(outbox_);
+    for (const AISquadMessage& message : messages) {
+        for (AIEntity* member : squadMembers_) {
+            if (member && member != this) member->ReceiveSquadMessage(message);
+        }
+    }
+}
+
+void AIEntity::SetSquad(const std::vector<AIEntity*>& squadMembers) {
+    squadMembers_ = squadMembers;
+}
+
+void AIEntity::SetFormation(const AIFormation& formation) {
+    currentFormation_ = formation;
+}
+
+void AIEntity::CoordinateWithSquad() {
+    if (perceptionData_.canSeePlayer) {
+        ShareInformation(perceptionData_.lastKnownPlayerPosition);
+    }
+}
+
+void AIEntity::ShareInformation(const AIVector3& playerPosition) {
+    outbox_.push_back({ AISquadMessage::Type::PlayerSighted, playerPosition, this });
+}
+
+void AIEntity::RequestBackup() {
+    outbox_.push_back({ AISquadMessage::Type::RequestBackup, position_, this });
+}
+
+void AIEntity::ReceiveSquadMessage(const AISquadMessage& message) {
+    switch (message.type) {
+        case AISquadMessage::Type::PlayerSighted:
+            lastKnownPlayerPosition = message.position;
+            isAlert_ = true;
+            break;
+        case AISquadMessage::Type::RequestBackup:
+            if (!isAlert_) {
+                isAlert_ = true;
+                MoveTo(message.position, PathPriority::Combat);
+            }
+            break;
+    }
+}
+
+void AIEntity::UpdateMotion(float deltaTime) {
+    Steer(deltaTime);
+    velocity_ = preferredVelocity_;
+    Integrate(deltaTime);
+}
+
+void AIEntity::Steer(float deltaTime) {
     // Update pathfinding
-    if (!currentPath_.empty()) {
+    if (pathRequest_ != PathQueryService::INVALID_HANDLE) {
+        ReceivePath();
+    }
+    preferredVelocity_ = AIVector3(0.0f, 0.0f, 0.0f);
+    if (deltaTime <= 0.0f) return;
+    if (flowField_) {
+        UpdateFlowMovement(deltaTime);
+    } else if (!currentPath_.empty()) {
         UpdateMovement(deltaTime);
+    } else if (holding_ && Distance(position_, holdPosition_) >= 0.5f) {
+        // The crowd pushed it aside since it stopped
+        SteerTowards(holdPosition_, deltaTime);
     }
 }
 
+void AIEntity::SteerTowards(const AIVector3& target, float deltaTime) {
+    // Slow down so the step ends on the target rather than past it
+    float distance = Distance(position_, target);
+    if (distance <= 1e-5f) return;
+    float speed = std::min(moveSpeed_, distance / deltaTime) / distance;
+    preferredVelocity_.x = (target.x - position_.x) * speed;
+    preferredVelocity_.y = (target.y - position_.y) * speed;
+    preferredVelocity_.z = (target.z - position_.z) * speed;
+}
+
+void AIEntity::Integrate(float deltaTime) {
+    position_.x += velocity_.x * deltaTime;
+    position_.y += velocity_.y * deltaTime;
+    position_.z += velocity_.z * deltaTime;
+}
+
+void AIEntity::FollowFlowField(std::shared_ptr<const FlowField> field, const AIVector3& destination) {
+    if (pathQueries_ && pathRequest_ != PathQueryService::INVALID_HANDLE) {
+        pathQueries_->Cancel(pathRequest_);
+    }
+    pathRequest_ = PathQueryService::INVALID_HANDLE;
+    currentPath_.clear();
+    holding_ = false;
+    flowField_ = std::move(field);
+    flowDestination_ = destination;
+}
+
+void AIEntity::UpdateFlowMovement(float deltaTime) {
+    float remaining = Distance(position_, flowDestination_);
+    if (remaining < 0.5f) {
+        flowField_.reset();
+        holding_ = true;
+        holdPosition_ = flowDestination_;
+        NEXUS_LOG_DEBUG("AI reached destination");
+        return;
+    }
+    
+    // Follow the field until the goal is about as close as the formation slot, then walk
+    // straight to the slot
+    AIVector3 target = flowDestination_;
+    AIVector3 direction;
+    float slotOffset = Distance(flowField_->GetGoal(), flowDestination_);
+    if (Distance(position_, flowField_->GetGoal()) > slotOffset + 2.0f) {
+        flowField_->GetDirection(position_, direction, &target);
+    }
+    
+    SteerTowards(target, deltaTime);
+}
+
 void AIEntity::UpdateMovement(float deltaTime) {
     if (currentPath_.empty()) return;
     
@@ -327,7 +1223,9 @@ void AIEntity::UpdateMovement(float deltaTime) {
         // Reached waypoint
         currentPath_.erase(currentPath_.begin());
         if (currentPath_.empty()) {
-            Logger::Debug("AI reached destination");
+            holding_ = true;
+            holdPosition_ = target;
+            NEXUS_LOG_DEBUG("AI reached destination");
         }
     } else {
         // Move toward waypoint
@@ -335,16 +1233,82 @@ void AIEntity::UpdateMovement(float deltaTime) {
         direction.y /= distance;
         direction.z /= distance;
         
-        position_.x += direction.x * moveSpeed_ * deltaTime;
-        position_.y += direction.y * moveSpeed_ * deltaTime;
-        position_.z += direction.z * moveSpeed_ * deltaTime;
+        float speed = std::min(moveSpeed_, distance / deltaTime);
+        preferredVelocity_.x = direction.x * speed;
+        preferredVelocity_.y = direction.y * speed;
+        preferredVelocity_.z = direction.z * speed;
     }
 }
 
 void AIEntity::MoveTo(const DirectX::XMFLOAT3& target) {
+    PathPriority priority = PathPriority::Background;
+    if (isAlert_) {
+        priority = PathPriority::Combat;
+    } else if (isOnScreen_) {
+        priority = PathPriority::Visible;
+    }
+    MoveTo(target, priority);
+}
+
+void AIEntity::MoveTo(const DirectX::XMFLOAT3& target, PathPriority priority) {
+    // Thinking may run on a worker; the request is made in ApplyIntents()
+    if (thinking_) {
+        hasMoveIntent_ = true;
+        moveIntent_ = target;
+        moveIntentPriority_ = priority;
+        return;
+    }
+    
+    flowField_.reset();
+    holding_ = false;
+    if (pathQueries_) {
+        // Keep following the old path until the new one arrives
+        if (pathRequest_ != PathQueryService::INVALID_HANDLE) {
+            pathQueries_->Cancel(pathRequest_);
+        }
+        pathRequest_ = pathQueries_->Submit(position_, target, priority);
+        return;
+    }
+    
     if (pathfinding_) {
-        currentPath_ = pathfinding_->FindPath(position_, target);
+        pathfinding_->FindPath(position_, target, currentPath_);
+    }
+}
+
+void AIEntity::FindCover(const AIVector3& threatDirection) {
+    if (!pathfinding_) return;
+    AIVector3 cover = pathfinding_->FindNearestCoverPoint(position_, threatDirection);
+    if (!SamePoint(cover, position_)) MoveTo(cover, PathPriority::Combat);
+}
+
+void AIEntity::SetPathQueryService(std::shared_ptr<PathQueryService> pathQueries) {
+    if (pathQueries_ && pathRequest_ != PathQueryService::INVALID_HANDLE) {
+        pathQueries_->Cancel(pathRequest_);
+    }
+    pathRequest_ = PathQueryService::INVALID_HANDLE;
+    pathQueries_ = pathQueries;
+}
+
+void AIEntity::ReceivePath() {
+    if (!pathQueries_) {
+        pathRequest_ = PathQueryService::INVALID_HANDLE;
+        return;
+    }
+    
+    switch (pathQueries_->GetStatus(pathRequest_)) {
+        case PathQueryService::Status::Pending:
+            return;
+        case PathQueryService::Status::Ready:
+            pathQueries_->TakeResult(pathRequest_, currentPath_);
+            break;
+        case PathQueryService::Status::Failed:
+            pathQueries_->TakeResult(pathRequest_, currentPath_);
+            NEXUS_LOG_DEBUG("AIEntity: No path to destination");
+            break;
+        case PathQueryService::Status::Invalid:
+            break;
     }
+    pathRequest_ = PathQueryService::INVALID_HANDLE;
 }
 
 void AIEntity::TakeDamage(float damage) {
@@ -359,7 +1323,7 @@ void AIEntity::TakeDamage(float damage) {
         stateMachine_->SetCurrentState(AIState::Dead);
         Logger::Info("AI Entity died");
     } else {
-        Logger::Debug("AI Entity took " + std::to_string(damage) + " damage. Health: " + std::to_string(health_));
+        NEXUS_LOG_DEBUG("AI Entity took {} damage. Health: {}", damage, health_);
     }
 }
 
@@ -371,11 +1335,25 @@ AIManager::AIManager()
     , maxAIEntities_(100)
     , nearLODDistance_(50.0f)
     , farLODDistance_(200.0f)
+    , viewerPosition_{0, 0, 0}
+    , timeBudgetMs_(DEFAULT_TIME_BUDGET_MS)
+    , farThinkInterval_(1.0f)
+    , jobs_(nullptr)
+    , midCursor_(0)
+    , farCursor_(0)
+    , crowdAvoidanceEnabled_(true)
+    , physics_(nullptr)
     , occlusionEnabled_(true)
     , debugVisualization_(false)
     , lastKnownPlayerPosition_{0, 0, 0}
     , lastPlayerPositionTime_(0.0f)
 {
+    pathfinding_ = std::make_shared<AIPathfinding>();
+    pathQueries_ = std::make_shared<PathQueryService>();
+    flowFields_ = std::make_shared<FlowFieldCache>();
+    for (const char* name : UTILITY_INPUT_NAMES) {
+        utility_.AddInput(name);
+    }
     Logger::Info("AIManager: Initializing...");
 }
 
@@ -390,27 +1368,49 @@ bool AIManager::Initialize() {
 
 void AIManager::Shutdown() {
     Logger::Info("AIManager: Shutting down...");
+    pathQueries_->Flush();
+    SetPhysics(nullptr);
     aiEntities_.clear();
     coverPoints_.clear();
+    entityGrid_.Clear();
+    coverGrid_.Clear();
+    soundGrid_.Clear();
+    gridEntities_.clear();
+    sounds_.clear();
+    soundItems_.clear();
     Logger::Info("AIManager: Shutdown complete");
 }
 
 void AIManager::Update(float deltaTime) {
-    // Update all AI entities
+    Timer frameTimer;
+    
+    // Sort entities into tiers by distance to the viewer
+    UpdateLOD();
+    ProcessGlobalEvents(deltaTime);
+    
+    // Freeze what entities may see of each other for this frame's think phase
     for (auto& entity : aiEntities_) {
-        if (entity && entity->IsActive()) {
-            entity->Update(deltaTime);
-        }
+        if (!entity || !entity->IsActive()) continue;
+        if (entity->isAlive_) entity->thinkTime_ += deltaTime;
+        entity->PublishSnapshot();
     }
+    UpdateSpatialGrids();
+    UpdateUtility();
     
-    // Update LOD
-    UpdateLOD();
+    // Think phase: near entities every frame, then mid and far ones in turn while time is left
+    ThinkEntities(nearEntities_);
+    RunScheduledThinks(frameTimer);
     
-    // Process global events
-    ProcessGlobalEvents();
+    // Apply phase, in entity order so the outcome doesn't depend on which thread thought what.
+    // Everyone keeps walking so movement stays smooth
+    for (auto& entity : aiEntities_) {
+        if (entity && entity->IsActive()) entity->ApplyIntents();
+    }
+    UpdateCrowd(deltaTime);
     
-    // Optimize performance
-    OptimizePerformance();
+    // Searches submitted this frame run under the budget; entities pick them up next frame
+    pathQueries_->Update();
+    updateStats_.updateMilliseconds = frameTimer.GetElapsedTime() * 1000.0f;
 }
 
 std::shared_ptr<AIEntity> AIManager::CreateAIEntity(AIPersonality personality) {
@@ -421,6 +1421,11 @@ std::shared_ptr<AIEntity> AIManager::CreateAIEntity(AIPersonality personality) {
     
     auto entity = std::make_shared<AIEntity>();
     entity->SetPersonality(personality);
+    entity->SetPathfinding(pathfinding_);
+    entity->SetPathQueryService(pathQueries_);
+    entity->gridItem_ = entityGrid_.Insert(entity->GetPosition());
+    if (gridEntities_.size() <= entity->gridItem_) gridEntities_.resize(entity->gridItem_ + 1, nullptr);
+    gridEntities_[entity->gridItem_] = entity.get();
     aiEntities_.push_back(entity);
     
     return entity;
@@ -429,6 +1434,15 @@ std::shared_ptr<AIEntity> AIManager::CreateAIEntity(AIPersonality personality) {
 void AIManager::RemoveAIEntity(std::shared_ptr<AIEntity> entity) {
     auto it = std::find(aiEntities_.begin(), aiEntities_.end(), entity);
     if (it != aiEntities_.end()) {
+        if (entity->gridItem_ != AISpatialGrid::INVALID_ITEM) {
+            entityGrid_.Remove(entity->gridItem_);
+            gridEntities_[entity->gridItem_] = nullptr;
+            entity->gridItem_ = AISpatialGrid::INVALID_ITEM;
+        }
+        if (physics_ && entity->character_ != 0) {
+            physics_->DestroyCharacter(entity->character_);
+            entity->character_ = 0;
+        }
         aiEntities_.erase(it);
     }
 }
@@ -450,64 +1464,184 @@ void AIManager::SetGlobalReactionTime(float reactionTime) {
 }
 
 void AIManager::CreateSquad(const std::vector<std::shared_ptr<AIEntity>>& members) {
-    // Basic squad creation
-    // TODO: Implement squad behavior
+    std::vector<AIEntity*> squad;
+    squad.reserve(members.size());
+    for (const auto& member : members) {
+        if (member) squad.push_back(member.get());
+    }
+    for (AIEntity* member : squad) {
+        member->SetSquad(squad);
+    }
 }
 
 void AIManager::DisbandSquad(const std::vector<std::shared_ptr<AIEntity>>& members) {
-    // Basic squad disbanding
-    // TODO: Implement squad management
+    for (const auto& member : members) {
+        if (member) member->SetSquad({});
+    }
 }
 
 void AIManager::SetSquadFormation(const std::vector<std::shared_ptr<AIEntity>>& squad, 
                                  const AIFormation& formation) {
-    // Basic formation setting
-    // TODO: Implement formations
+    for (const auto& member : squad) {
+        if (member) member->SetFormation(formation);
+    }
+}
+
+void AIManager::MoveSquadTo(const std::vector<std::shared_ptr<AIEntity>>& squad, const AIVector3& goal,
+                            const AIFormation* formation) {
+    auto field = flowFields_->GetField(goal);
+    
+    for (size_t i = 0; i < squad.size(); ++i) {
+        if (!squad[i]) continue;
+        
+        AIVector3 destination = goal;
+        if (formation && i < formation->relativePositions.size()) {
+            destination.x += formation->relativePositions[i].x;
+            destination.y += formation->relativePositions[i].y;
+            destination.z += formation->relativePositions[i].z;
+        }
+        
+        // Off the navmesh there is no field; fall back to a path each
+        if (field) {
+            squad[i]->FollowFlowField(field, destination);
+        } else {
+            squad[i]->MoveTo(destination, PathPriority::Combat);
+        }
+    }
 }
 
 void AIManager::SetNavMesh(std::shared_ptr<NavMesh> navMesh) {
     navMesh_ = navMesh;
+    pathfinding_->SetNavMesh(navMesh);
+    pathQueries_->SetNavMesh(navMesh);
+    flowFields_->SetNavMesh(navMesh);
+}
+
+void AIManager::SetJobSystem(JobSystem* jobs) {
+    jobs_ = jobs;
+    pathQueries_->SetJobSystem(jobs);
+}
+
+uint32_t AIManager::AddUtilityAction(const UtilityAction& action) {
+    const uint32_t index = utility_.AddAction(action);
+    if (index == UtilityScorer::NO_ACTION) {
+        Logger::Warning("AIManager: Utility action " + action.name + " uses an unknown input");
+        return index;
+    }
+    utilityStates_.push_back(-1);
+    return index;
+}
+
+uint32_t AIManager::AddUtilityAction(const UtilityAction& action, AIState state) {
+    const uint32_t index = AddUtilityAction(action);
+    if (index != UtilityScorer::NO_ACTION) utilityStates_[index] = static_cast<int>(state);
+    return index;
+}
+
+void AIManager::ClearUtilityActions() {
+    utility_.ClearActions();
+    utilityStates_.clear();
+    for (auto& entity : aiEntities_) {
+        if (!entity) continue;
+        entity->utilityAction_ = UtilityScorer::NO_ACTION;
+        entity->utilityScore_ = 0.0f;
+    }
+}
+
+void AIManager::SetPhysics(PhysicsEngine* physics) {
+    if (physics == physics_) return;
+    // Characters belong to the engine that made them
+    for (auto& entity : aiEntities_) {
+        if (entity && entity->character_ != 0) {
+            if (physics_) physics_->DestroyCharacter(entity->character_);
+            entity->character_ = 0;
+        }
+    }
+    physics_ = physics;
 }
 
 void AIManager::UpdateNavMesh() {
-    // TODO: Implement navmesh updates
+    // Rebuilding the navmesh changes its revision; resync now rather than on the next query
+    pathfinding_->SetNavMesh(navMesh_);
+    pathQueries_->SetNavMesh(navMesh_);
+    flowFields_->SetNavMesh(navMesh_);
+    if (navMesh_) {
+        Logger::Info("AIManager: Navmesh updated, " + std::to_string(navMesh_->GetPolygonCount()) + " polygons");
+    }
 }
 
 void AIManager::AddCoverPoint(const AICoverPoint& cover) {
     coverPoints_.push_back(cover);
+    coverGrid_.Insert(cover.position);
 }
 
 void AIManager::RemoveCoverPoint(const AIVector3& position) {
+    size_t count = coverPoints_.size();
     coverPoints_.erase(
         std::remove_if(coverPoints_.begin(), coverPoints_.end(),
             [&position](const AICoverPoint& cover) {
-                float distance = std::sqrt(
-                    (cover.position.x - position.x) * (cover.position.x - position.x) +
-                    (cover.position.y - position.y) * (cover.position.y - position.y) +
-                    (cover.position.z - position.z) * (cover.position.z - position.z)
-                );
-                return distance < 1.0f;
+                return Distance(cover.position, position) < 1.0f;
             }),
         coverPoints_.end()
     );
+    
+    // Grid items are cover indices, which just shifted
+    if (coverPoints_.size() != count) RebuildCoverGrid();
+}
+
+void AIManager::RebuildCoverGrid() {
+    coverGrid_.Clear();
+    for (const auto& cover : coverPoints_) {
+        coverGrid_.Insert(cover.position);
+    }
 }
 
 std::vector<AICoverPoint> AIManager::FindCoverPoints(const AIVector3& position, float radius) {
     std::vector<AICoverPoint> nearCover;
-    
-    for (const auto& cover : coverPoints_) {
-        float distance = std::sqrt(
-            (cover.position.x - position.x) * (cover.position.x - position.x) +
-            (cover.position.y - position.y) * (cover.position.y - position.y) +
-            (cover.position.z - position.z) * (cover.position.z - position.z)
-        );
-        
-        if (distance <= radius) {
-            nearCover.push_back(cover);
+    FindCoverPoints(position, radius, nearCover);
+    return nearCover;
+}
+
+void AIManager::FindCoverPoints(const AIVector3& position, float radius, std::vector<AICoverPoint>& results) {
+    results.clear();
+    coverGrid_.QueryRadius(position, radius, queryScratch_);
+    for (uint32_t item : queryScratch_) {
+        results.push_back(coverPoints_[item]);
+    }
+    if (coverMap_) {
+        coverMap_->FindPoints(position, radius, queryScratch_);
+        for (uint32_t point : queryScratch_) {
+            results.push_back(coverMap_->GetPoint(point));
         }
     }
-    
-    return nearCover;
+}
+
+void AIManager::SetCoverMap(std::shared_ptr<const CoverMap> coverMap) {
+    coverMap_ = std::move(coverMap);
+    pathfinding_->SetCoverMap(coverMap_);
+    if (coverMap_) {
+        Logger::Info("AIManager: Cover map set, " + std::to_string(coverMap_->GetPointCount()) + " points");
+    }
+}
+
+size_t AIManager::FindSafeCoverPoints(const AIVector3& position, float radius, const AIVector3& threatPosition,
+                                      std::vector<AICoverPoint>& results) {
+    results.clear();
+    if (!coverMap_) return 0;
+    coverMap_->FindPoints(position, radius, queryScratch_);
+    for (uint32_t point : queryScratch_) {
+        if (coverMap_->IsProtectedFrom(point, threatPosition)) results.push_back(coverMap_->GetPoint(point));
+    }
+    return results.size();
+}
+
+size_t AIManager::FindEntitiesInRadius(const AIVector3& position, float radius, std::vector<AIEntity*>& results) {
+    results.clear();
+    entityGrid_.QueryRadius(position, radius, queryScratch_);
+    for (uint32_t item : queryScratch_) {
+        results.push_back(gridEntities_[item]);
+    }
+    return results.size();
 }
 
 void AIManager::NotifyPlayerPosition(const AIVector3& position) {
@@ -523,20 +1657,19 @@ void AIManager::NotifyPlayerPosition(const AIVector3& position) {
 }
 
 void AIManager::NotifyGunshot(const AIVector3& position, float intensity) {
+    float radius = intensity * 20.0f;
+    
     // Alert nearby AI entities
-    for (auto& entity : aiEntities_) {
-        if (entity) {
-            float distance = std::sqrt(
-                (entity->GetPosition().x - position.x) * (entity->GetPosition().x - position.x) +
-                (entity->GetPosition().y - position.y) * (entity->GetPosition().y - position.y) +
-                (entity->GetPosition().z - position.z) * (entity->GetPosition().z - position.z)
-            );
-            
-            if (distance <= intensity * 20.0f) {
-                entity->SetCurrentState(AIState::Investigate);
-            }
-        }
+    entityGrid_.QueryRadius(position, radius, queryScratch_);
+    for (uint32_t item : queryScratch_) {
+        gridEntities_[item]->SetCurrentState(AIState::Investigate);
     }
+    
+    // Stays audible to perception for a while
+    uint32_t item = soundGrid_.Insert(position);
+    if (sounds_.size() <= item) sounds_.resize(item + 1);
+    sounds_[item] = { position, radius, 0.0f };
+    soundItems_.push_back(item);
 }
 
 void AIManager::NotifyAlarmActivated() {
@@ -553,17 +1686,11 @@ void AIManager::NotifyAIKilled(std::shared_ptr<AIEntity> entity) {
     RemoveAIEntity(entity);
     
     // Alert nearby AI
-    for (auto& otherEntity : aiEntities_) {
-        if (otherEntity && otherEntity != entity) {
-            float distance = std::sqrt(
-                (otherEntity->GetPosition().x - entity->GetPosition().x) * (otherEntity->GetPosition().x - entity->GetPosition().x) +
-                (otherEntity->GetPosition().y - entity->GetPosition().y) * (otherEntity->GetPosition().y - entity->GetPosition().y) +
-                (otherEntity->GetPosition().z - entity->GetPosition().z) * (otherEntity->GetPosition().z - entity->GetPosition().z)
-            );
-            
-            if (distance <= 15.0f) {
-                otherEntity->SetCurrentState(AIState::Investigate);
-            }
+    entityGrid_.QueryRadius(entity->GetPosition(), 15.0f, queryScratch_);
+    for (uint32_t item : queryScratch_) {
+        AIEntity* otherEntity = gridEntities_[item];
+        if (otherEntity != entity.get()) {
+            otherEntity->SetCurrentState(AIState::Investigate);
         }
     }
 }
@@ -602,20 +1729,315 @@ void AIManager::GetAIStatistics(int& totalAI, int& activeAI, int& alertAI) {
     }
 }
 
+void AIManager::UpdateUtility() {
+    if (utility_.GetActionCount() == 0) return;
+    NEXUS_PROFILE_SCOPE("AIManager::UpdateUtility");
+    
+    utilityEntities_.clear();
+    for (auto& entity : aiEntities_) {
+        if (entity && entity->IsActive() && entity->isAlive_) utilityEntities_.push_back(entity.get());
+    }
+    const size_t count = utilityEntities_.size();
+    if (utility_.GetEntityCount() != count) utility_.SetEntityCount(count);
+    if (count == 0) return;
+    
+    // Serial, between the snapshots and the think phase, so squad members may be read directly
+    float* inputs[UTILITY_INPUT_COUNT];
+    for (uint32_t input = 0; input < UTILITY_INPUT_COUNT; ++input) inputs[input] = utility_.GetInputs(input);
+    uint32_t* currentActions = utility_.GetCurrentActions();
+    for (size_t i = 0; i < count; ++i) {
+        const AIEntity& entity = *utilityEntities_[i];
+        uint32_t squadAlert = 0, squadAlive = 0;
+        for (const AIEntity* member : entity.squadMembers_) {
+            if (!member) continue;
+            if (member->snapshot_.alert) ++squadAlert;
+            if (member->snapshot_.alive) ++squadAlive;
+        }
+        const float squadSize = static_cast<float>(std::max<size_t>(entity.squadMembers_.size(), 1));
+        
+        inputs[UTILITY_HEALTH][i] = entity.maxHealth_ > 0.0f ? entity.health_ / entity.maxHealth_ : 0.0f;
+        inputs[UTILITY_AGGRESSION][i] = entity.aggression_;
+        inputs[UTILITY_CAUTIOUSNESS][i] = entity.cautiousness_;
+        inputs[UTILITY_INTELLIGENCE][i] = entity.intelligence_;
+        inputs[UTILITY_ALERT][i] = entity.isAlert_ ? 1.0f : 0.0f;
+        inputs[UTILITY_IN_COVER][i] = entity.isInCover_ ? 1.0f : 0.0f;
+        inputs[UTILITY_TARGET_VISIBLE][i] = entity.perceptionData_.canSeePlayer ? 1.0f : 0.0f;
+        inputs[UTILITY_TARGET_DISTANCE][i] = Distance(entity.position_, lastKnownPlayerPosition_) / std::max(entity.sightRange_, 1.0f);
+        inputs[UTILITY_SQUAD_ALERT][i] = entity.squadMembers_.empty() ? 0.0f : squadAlert / squadSize;
+        inputs[UTILITY_SQUAD_STRENGTH][i] = entity.squadMembers_.empty() ? 1.0f : squadAlive / squadSize;
+        currentActions[i] = entity.utilityAction_;
+    }
+    
+    Timer utilityTimer;
+    utility_.Score(jobs_);
+    updateStats_.utilityMicroseconds = utilityTimer.GetElapsedTime() * 1000000.0f;
+    
+    for (size_t i = 0; i < count; ++i) {
+        AIEntity* entity = utilityEntities_[i];
+        const uint32_t action = utility_.GetChoice(i);
+        entity->utilityAction_ = action;
+        entity->utilityScore_ = utility_.GetScore(i);
+        if (action == UtilityScorer::NO_ACTION || utilityStates_[action] < 0) continue;
+        
+        const AIState state = static_cast<AIState>(utilityStates_[action]);
+        if (entity->GetCurrentState() != state) entity->SetCurrentState(state);
+    }
+}
+
+void AIManager::UpdateCrowd(float deltaTime) {
+    NEXUS_PROFILE_SCOPE("AIManager::UpdateCrowd");
+    crowdEntities_.clear();
+    crowdAgents_.clear();
+    for (auto& entity : aiEntities_) {
+        if (!entity || !entity->IsActive() || !entity->isAlive_) continue;
+        entity->Steer(deltaTime);
+        
+        const AIVector3& position = entity->position_;
+        const AIVector3& velocity = entity->velocity_;
+        const AIVector3& preferred = entity->preferredVelocity_;
+        crowdEntities_.push_back(entity.get());
+        crowdAgents_.push_back({ DirectX::XMFLOAT2(position.x, position.z), DirectX::XMFLOAT2(velocity.x, velocity.z),
+                                 DirectX::XMFLOAT2(preferred.x, preferred.z), entity->radius_, entity->moveSpeed_ });
+    }
+    
+    Timer crowdTimer;
+    if (crowdAvoidanceEnabled_ && deltaTime > 0.0f) {
+        crowdAvoidance_.Solve(crowdAgents_, deltaTime, crowdVelocities_, jobs_);
+    } else {
+        crowdVelocities_.resize(crowdAgents_.size());
+        for (size_t i = 0; i < crowdAgents_.size(); ++i) crowdVelocities_[i] = crowdAgents_[i].preferredVelocity;
+    }
+    updateStats_.crowdMilliseconds = crowdTimer.GetElapsedTime() * 1000.0f;
+    
+    for (size_t i = 0; i < crowdEntities_.size(); ++i) {
+        AIEntity* entity = crowdEntities_[i];
+        const DirectX::XMFLOAT2& velocity = crowdVelocities_[i];
+        const DirectX::XMFLOAT2& preferred = crowdAgents_[i].preferredVelocity;
+        
+        // Climb or descend in proportion to the ground speed avoidance left
+        float preferredSq = preferred.x * preferred.x + preferred.y * preferred.y;
+        float climb = 0.0f;
+        if (preferredSq > 1e-8f) {
+            climb = entity->preferredVelocity_.y * std::sqrt((velocity.x * velocity.x + velocity.y * velocity.y) / preferredSq);
+        }
+        entity->velocity_ = AIVector3(velocity.x, climb, velocity.y);
+        if (!physics_) {
+            entity->Integrate(deltaTime);
+            continue;
+        }
+        
+        // Characters are centered, entities at their feet
+        PhysicsEngine::CharacterState state;
+        if (entity->character_ == 0 || !physics_->GetCharacterState(entity->character_, state)) {
+            PhysicsEngine::CharacterSettings settings;
+            settings.radius = entity->radius_;
+            settings.height = std::max(CHARACTER_HEIGHT, entity->radius_ * 2.0f);
+            const AIVector3& feet = entity->position_;
+            entity->character_ = physics_->CreateCharacter(
+                settings, PhysicsVector3(feet.x, feet.y + settings.height * 0.5f, feet.z));
+            state.grounded = true;
+        }
+        // Off the ground it falls, keeping what it had of a fall already
+        if (!state.grounded) {
+            entity->velocity_.y = std::min(state.velocity.y, 0.0f) - CHARACTER_GRAVITY * deltaTime;
+        }
+        moveCharacters_.push_back(entity->character_);
+        moveDisplacements_.push_back(PhysicsVector3(entity->velocity_.x * deltaTime, entity->velocity_.y * deltaTime,
+                                                    entity->velocity_.z * deltaTime));
+    }
+    
+    if (!moveCharacters_.empty()) {
+        physics_->MoveCharacters(moveCharacters_.data(), moveDisplacements_.data(), moveCharacters_.size(), deltaTime);
+        moveCharacters_.clear();
+        moveDisplacements_.clear();
+    }
+    
+    for (size_t i = 0; i < crowdEntities_.size(); ++i) {
+        AIEntity* entity = crowdEntities_[i];
+        PhysicsEngine::CharacterState state;
+        const bool character = physics_ && physics_->GetCharacterState(entity->character_, state);
+        const float halfHeight = std::max(CHARACTER_HEIGHT, entity->radius_ * 2.0f) * 0.5f;
+        if (character) {
+            entity->position_ = AIVector3(state.position.x, state.position.y - halfHeight, state.position.z);
+            entity->velocity_ = AIVector3(state.velocity.x, state.velocity.y, state.velocity.z);
+        }
+        
+        // Avoidance knows nothing of walls; keep entities it steered aside on the navmesh
+        const DirectX::XMFLOAT2& velocity = crowdVelocities_[i];
+        const DirectX::XMFLOAT2& preferred = crowdAgents_[i].preferredVelocity;
+        if (navMesh_ && (velocity.x != preferred.x || velocity.y != preferred.y)) {
+            AIVector3 nearest;
+            if (navMesh_->FindNearestPolygon(entity->position_, CROWD_SNAP_RADIUS, &nearest) != NavMesh::INVALID_POLYGON) {
+                entity->position_.x = nearest.x;
+                entity->position_.z = nearest.z;
+                if (character) {
+                    physics_->SetCharacterPosition(entity->character_,
+                        PhysicsVector3(nearest.x, state.position.y, nearest.z));
+                }
+            }
+        }
+    }
+}
+
+void AIManager::UpdateSpatialGrids() {
+    NEXUS_PROFILE_SCOPE("AIManager::UpdateSpatialGrids");
+    
+    // Only entities that crossed a cell boundary relink
+    for (auto& entity : aiEntities_) {
+        if (entity && entity->gridItem_ != AISpatialGrid::INVALID_ITEM) {
+            entityGrid_.Move(entity->gridItem_, entity->GetPosition());
+        }
+    }
+}
+void AIManager::UpdatePerception(AIEntity& entity) {
+    AIPerceptionData& perception = entity.perceptionData_;
+    perception.sightRadius = entity.sightRange_;
+    perception.hearingRadius = entity.hearingRange_;
+    perception.sightAngle = entity.fieldOfViewAngle_;
+    perception.visibleAllies.clear();
+    perception.visibleEnemies.clear();
+    perception.soundSources.clear();
+    
+    // Local +z rotated by the entity's orientation
+    const AIQuaternion& q = entity.rotation_;
+    AIVector3 forward(2.0f * (q.x * q.z + q.w * q.y), 2.0f * (q.y * q.z - q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+    float cosHalfAngle = std::cos(DirectX::XMConvertToRadians(entity.fieldOfViewAngle_ * 0.5f));
+    
+    // Runs on any worker during the think phase, so others are read only through their snapshots
+    thread_local std::vector<uint32_t> scratch;
+    entityGrid_.QueryCone(entity.position_, forward, entity.sightRange_, cosHalfAngle, scratch);
+    for (uint32_t item : scratch) {
+        AIEntity* other = gridEntities_[item];
+        if (other == &entity || !other->snapshot_.alive) continue;
+        if (other->snapshot_.team == entity.team_) {
+            perception.visibleAllies.push_back(other);
+        } else {
+            perception.visibleEnemies.push_back(other);
+        }
+    }
+    
+    // Heard when within both the listener's hearing range and the sound's reach
+    soundGrid_.QueryRadius(entity.position_, entity.hearingRange_, scratch);
+    for (uint32_t item : scratch) {
+        const SoundEvent& sound = sounds_[item];
+        if (Distance(sound.position, entity.position_) <= sound.radius) {
+            perception.soundSources.push_back(sound.position);
+        }
+    }
+}
+
 void AIManager::UpdateLOD() {
-    // TODO: Implement LOD system
+    NEXUS_PROFILE_SCOPE("AIManager::UpdateLOD");
+    nearEntities_.clear();
+    midEntities_.clear();
+    farEntities_.clear();
+    
+    const float nearSq = nearLODDistance_ * nearLODDistance_;
+    const float farSq = farLODDistance_ * farLODDistance_;
+    for (auto& entity : aiEntities_) {
+        if (!entity || !entity->IsActive() || !entity->isAlive_) continue;
+        
+        float dx = entity->position_.x - viewerPosition_.x;
+        float dy = entity->position_.y - viewerPosition_.y;
+        float dz = entity->position_.z - viewerPosition_.z;
+        float distanceSq = dx * dx + dy * dy + dz * dz;
+        
+        AILODTier tier = AILODTier::Far;
+        if (distanceSq <= nearSq) {
+            tier = AILODTier::Near;
+        } else if (distanceSq <= farSq || entity->isAlert_) {
+            // An alerted entity may be shooting at the player from afar; keep it responsive
+            tier = AILODTier::Mid;
+        }
+        entity->lodTier_ = tier;
+        
+        if (tier == AILODTier::Near) {
+            nearEntities_.push_back(entity.get());
+        } else if (tier == AILODTier::Mid) {
+            midEntities_.push_back(entity.get());
+        } else {
+            farEntities_.push_back(entity.get());
+        }
+    }
+    
+    updateStats_.nearEntities = static_cast<uint32_t>(nearEntities_.size());
+    updateStats_.midEntities = static_cast<uint32_t>(midEntities_.size());
+    updateStats_.farEntities = static_cast<uint32_t>(farEntities_.size());
 }
 
-void AIManager::ProcessGlobalEvents() {
-    // TODO: Process global AI events
+void AIManager::ProcessGlobalEvents(float deltaTime) {
+    lastPlayerPositionTime_ += deltaTime;
+    
+    // Age sounds and forget the ones that faded
+    for (size_t i = 0; i < soundItems_.size();) {
+        uint32_t item = soundItems_[i];
+        sounds_[item].age += deltaTime;
+        if (sounds_[item].age >= SOUND_LIFETIME) {
+            soundGrid_.Remove(item);
+            soundItems_[i] = soundItems_.back();
+            soundItems_.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+void AIManager::ThinkEntities(const std::vector<AIEntity*>& entities) {
+    // Each entity thinks with all the time it missed, so slower tiers stay in step with the world
+    auto think = [this, &entities](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            AIEntity* entity = entities[i];
+            UpdatePerception(*entity);
+            entity->Think(entity->thinkTime_);
+        }
+    };
+    
+    if (jobs_ && jobs_->IsInitialized()) {
+        jobs_->ParallelFor(entities.size(), 8, think);
+    } else {
+        think(0, entities.size());
+    }
 }
 
-void AIManager::OptimizePerformance() {
-    // TODO: Implement performance optimizations
+void AIManager::RunScheduledThinks(const Timer& frameTimer) {
+    NEXUS_PROFILE_SCOPE("AIManager::RunScheduledThinks");
+    const float budget = timeBudgetMs_ * 0.001f;
+    uint32_t thinks = 0;
+    size_t midVisited = 0;
+    size_t farVisited = 0;
+    
+    // Chunks think in parallel; the budget is checked between them
+    while (thinks == 0 || frameTimer.GetElapsedTime() < budget) {
+        thinkChunk_.clear();
+        
+        // Mid entities first, at most once each per frame, resuming where the last frame stopped
+        while (thinkChunk_.size() < THINK_CHUNK && midVisited < midEntities_.size()) {
+            midCursor_ = (midCursor_ + 1) % midEntities_.size();
+            thinkChunk_.push_back(midEntities_[midCursor_]);
+            midVisited++;
+        }
+        
+        // Far entities only once their think interval has passed
+        while (thinkChunk_.size() < THINK_CHUNK && farVisited < farEntities_.size()) {
+            farCursor_ = (farCursor_ + 1) % farEntities_.size();
+            AIEntity* entity = farEntities_[farCursor_];
+            if (entity->thinkTime_ >= farThinkInterval_) thinkChunk_.push_back(entity);
+            farVisited++;
+        }
+        
+        if (thinkChunk_.empty()) break;
+        ThinkEntities(thinkChunk_);
+        thinks += static_cast<uint32_t>(thinkChunk_.size());
+    }
+    
+    updateStats_.scheduledThinks = thinks;
 }
 
 AIEntity::~AIEntity() {
-    Logger::Debug("AIEntity: Destroyed");
+    if (pathQueries_ && pathRequest_ != PathQueryService::INVALID_HANDLE) {
+        pathQueries_->Cancel(pathRequest_);
+    }
+    NEXUS_LOG_DEBUG("AIEntity: Destroyed");
 }
 
 void AIEntity::SetPersonality(AIPersonality personality) {
@@ -653,7 +2075,7 @@ void AIEntity::SetPersonality(AIPersonality personality) {
             break;
     }
     
-    Logger::Debug("AIEntity: Personality set to " + std::to_string(static_cast<int>(personality)));
+    NEXUS_LOG_DEBUG("AIEntity: Personality set to {}", personality);
 }
 
 AIState AIEntity::GetCurrentState() const {
@@ -0,0 +1,417 @@
+#include "CoverMap.h"
+#include "AtomicFile.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "MeshImporter.h"
+#include "NavMesh.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+constexpr float PI = 3.14159265358979f;
+constexpr float TWO_PI = 2.0f * PI;
+constexpr float GRID_CELL_SIZE = 4.0f;
+constexpr uint32_t MAX_GRID_CELLS = 1u << 22;
+// Cover points tested per job
+constexpr size_t POINT_GRAIN = 16;
+
+XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+float Dot(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Two-sided ray against triangle, Moller-Trumbore; hits between 0 and maxDistance count
+bool RayHitsTriangle(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, const XMFLOAT3* triangle) {
+    const XMFLOAT3 edge1 = Subtract(triangle[1], triangle[0]);
+    const XMFLOAT3 edge2 = Subtract(triangle[2], triangle[0]);
+    const XMFLOAT3 p = Cross(direction, edge2);
+    const float determinant = Dot(edge1, p);
+    if (std::fabs(determinant) < 1e-8f) return false;
+
+    const float inverse = 1.0f / determinant;
+    const XMFLOAT3 toOrigin = Subtract(origin, triangle[0]);
+    const float u = Dot(toOrigin, p) * inverse;
+    if (u < 0.0f || u > 1.0f) return false;
+
+    const XMFLOAT3 q = Cross(toOrigin, edge1);
+    const float v = Dot(direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f) return false;
+
+    const float t = Dot(edge2, q) * inverse;
+    return t >= 0.0f && t <= maxDistance;
+}
+
+// Occluding triangles binned by their extent on the ground plane, for the bake only
+class TriangleGrid {
+public:
+    explicit TriangleGrid(std::vector<XMFLOAT3> triangles)
+        : triangles_(std::move(triangles))
+        , origin_(0.0f, 0.0f)
+        , cellSize_(GRID_CELL_SIZE)
+        , width_(0)
+        , height_(0)
+    {
+        if (triangles_.empty()) return;
+
+        float minX = triangles_[0].x, maxX = minX, minZ = triangles_[0].z, maxZ = minZ;
+        for (const XMFLOAT3& vertex : triangles_) {
+            minX = std::min(minX, vertex.x); maxX = std::max(maxX, vertex.x);
+            minZ = std::min(minZ, vertex.z); maxZ = std::max(maxZ, vertex.z);
+        }
+        // Huge levels get coarser cells rather than a huge grid
+        while ((maxX - minX) / cellSize_ * (maxZ - minZ) / cellSize_ > static_cast<float>(MAX_GRID_CELLS)) {
+            cellSize_ *= 2.0f;
+        }
+        origin_ = XMFLOAT2(minX, minZ);
+        width_ = static_cast<uint32_t>((maxX - minX) / cellSize_) + 1;
+        height_ = static_cast<uint32_t>((maxZ - minZ) / cellSize_) + 1;
+
+        // Counted, then filled, into one array
+        const uint32_t triangleCount = static_cast<uint32_t>(triangles_.size() / 3);
+        cells_.assign(static_cast<size_t>(width_) * height_ + 1, 0);
+        std::vector<uint32_t> cursor;
+        for (int pass = 0; pass < 2; ++pass) {
+            if (pass == 1) {
+                for (size_t cell = 1; cell < cells_.size(); ++cell) cells_[cell] += cells_[cell - 1];
+                entries_.resize(cells_.back());
+                cursor.assign(cells_.begin(), cells_.end() - 1);
+            }
+            for (uint32_t t = 0; t < triangleCount; ++t) {
+                uint32_t x0, z0, x1, z1;
+                Bounds(&triangles_[t * 3], x0, z0, x1, z1);
+                for (uint32_t z = z0; z <= z1; ++z) {
+                    for (uint32_t x = x0; x <= x1; ++x) {
+                        const size_t cell = static_cast<size_t>(z) * width_ + x;
+                        if (pass == 0) {
+                            cells_[cell + 1]++;
+                        } else {
+                            entries_[cursor[cell]++] = t;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Triangles near center, each once
+    void Gather(const XMFLOAT3& center, float radius, std::vector<uint32_t>& results) const {
+        results.clear();
+        if (width_ == 0) return;
+        const float fx0 = (center.x - radius - origin_.x) / cellSize_, fx1 = (center.x + radius - origin_.x) / cellSize_;
+        const float fz0 = (center.z - radius - origin_.y) / cellSize_, fz1 = (center.z + radius - origin_.y) / cellSize_;
+        if (fx1 < 0.0f || fz1 < 0.0f || fx0 >= static_cast<float>(width_) || fz0 >= static_cast<float>(height_)) return;
+
+        const uint32_t x0 = static_cast<uint32_t>(std::max(fx0, 0.0f));
+        const uint32_t z0 = static_cast<uint32_t>(std::max(fz0, 0.0f));
+        const uint32_t x1 = std::min(static_cast<uint32_t>(fx1), width_ - 1);
+        const uint32_t z1 = std::min(static_cast<uint32_t>(fz1), height_ - 1);
+        for (uint32_t z = z0; z <= z1; ++z) {
+            for (uint32_t x = x0; x <= x1; ++x) {
+                const size_t cell = static_cast<size_t>(z) * width_ + x;
+                results.insert(results.end(), entries_.begin() + cells_[cell], entries_.begin() + cells_[cell + 1]);
+            }
+        }
+        std::sort(results.begin(), results.end());
+        results.erase(std::unique(results.begin(), results.end()), results.end());
+    }
+
+    const XMFLOAT3* GetTriangle(uint32_t triangle) const { return &triangles_[triangle * 3]; }
+
+private:
+    void Bounds(const XMFLOAT3* triangle, uint32_t& x0, uint32_t& z0, uint32_t& x1, uint32_t& z1) const {
+        float minX = std::min(triangle[0].x, std::min(triangle[1].x, triangle[2].x));
+        float maxX = std::max(triangle[0].x, std::max(triangle[1].x, triangle[2].x));
+        float minZ = std::min(triangle[0].z, std::min(triangle[1].z, triangle[2].z));
+        float maxZ = std::max(triangle[0].z, std::max(triangle[1].z, triangle[2].z));
+        x0 = std::min(static_cast<uint32_t>((minX - origin_.x) / cellSize_), width_ - 1);
+        x1 = std::min(static_cast<uint32_t>((maxX - origin_.x) / cellSize_), width_ - 1);
+        z0 = std::min(static_cast<uint32_t>((minZ - origin_.y) / cellSize_), height_ - 1);
+        z1 = std::min(static_cast<uint32_t>((maxZ - origin_.y) / cellSize_), height_ - 1);
+    }
+
+    std::vector<XMFLOAT3> triangles_;          // Three corners each
+    XMFLOAT2 origin_;
+    float cellSize_;
+    uint32_t width_;
+    uint32_t height_;
+    std::vector<uint32_t> cells_;              // width_ * height_ + 1 offsets into entries_
+    std::vector<uint32_t> entries_;
+};
+
+struct Candidate {
+    XMFLOAT3 position;
+    XMFLOAT3 normal;
+    CoverMap::Sectors sectors;
+};
+
+// Sectors whose three rays at height all hit within shieldDistance
+uint32_t BlockedSectors(const TriangleGrid& grid, const std::vector<uint32_t>& nearby, const XMFLOAT3& position,
+                        float height, float shieldDistance) {
+    const XMFLOAT3 origin(position.x, position.y + height, position.z);
+    const float sectorAngle = TWO_PI / CoverMap::SECTOR_COUNT;
+    uint32_t blocked = 0;
+
+    for (uint32_t sector = 0; sector < CoverMap::SECTOR_COUNT; ++sector) {
+        bool shielded = true;
+        for (int ray = -1; ray <= 1 && shielded; ++ray) {
+            const float angle = (sector + 0.5f + ray / 3.0f) * sectorAngle - PI;
+            const XMFLOAT3 direction(std::cos(angle), 0.0f, std::sin(angle));
+
+            bool hit = false;
+            for (uint32_t triangle : nearby) {
+                if (RayHitsTriangle(origin, direction, shieldDistance, grid.GetTriangle(triangle))) {
+                    hit = true;
+                    break;
+                }
+            }
+            shielded = hit;
+        }
+        if (shielded) blocked |= 1u << sector;
+    }
+    return blocked;
+}
+}
+
+CoverMap::CoverMap()
+    : grid_(GRID_CELL_SIZE) {}
+
+void CoverMap::Clear() {
+    points_.clear();
+    sectors_.clear();
+    grid_.Clear();
+}
+
+void CoverMap::AddPoint(const XMFLOAT3& position, const XMFLOAT3& normal, const Sectors& sectors) {
+    AICoverPoint point;
+    point.position = position;
+    point.normal = normal;
+    point.quality = static_cast<float>(std::bitset<SECTOR_COUNT>(sectors.protection).count()) / SECTOR_COUNT;
+    point.isOccupied = false;
+    point.providesConcealment = sectors.concealment != 0;
+    point.providesProtection = sectors.protection != 0;
+    point.distanceToPlayer = 0.0f;
+
+    points_.push_back(point);
+    sectors_.push_back(sectors);
+    grid_.Insert(position);
+}
+
+bool CoverMap::Build(const NavMesh& navMesh, const XMFLOAT3* positions, size_t vertexCount, const uint32_t* indices,
+                     size_t indexCount, const CoverBakeSettings& settings, JobSystem* jobs) {
+    NEXUS_PROFILE_SCOPE("CoverMap::Build");
+    Clear();
+    if (navMesh.GetPolygonCount() == 0) return false;
+
+    const float spacing = std::max(settings.spacing, 0.1f);
+    std::vector<XMFLOAT3> occluders;
+    std::vector<Candidate> candidates;
+    AISpatialGrid candidateGrid(spacing);
+    std::vector<uint32_t> nearby;
+
+    if (positions && indices) {
+        occluders.reserve(indexCount - indexCount % 3);
+        for (size_t i = 0; i + 2 < indexCount; i += 3) {
+            if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount) continue;
+            occluders.push_back(positions[indices[i]]);
+            occluders.push_back(positions[indices[i + 1]]);
+            occluders.push_back(positions[indices[i + 2]]);
+        }
+    }
+    const bool borderWalls = occluders.empty();
+
+    for (uint32_t polygon = 0; polygon < navMesh.GetPolygonCount(); ++polygon) {
+        const NavMesh::Polygon& shape = navMesh.GetPolygon(polygon);
+        for (uint32_t edge = 0; edge < shape.vertexCount; ++edge) {
+            if (navMesh.GetNeighbour(polygon, edge) != NavMesh::INVALID_POLYGON) continue;
+
+            const XMFLOAT3& a = navMesh.GetCorner(polygon, edge);
+            const XMFLOAT3& b = navMesh.GetCorner(polygon, (edge + 1) % shape.vertexCount);
+            if (borderWalls) {
+                const XMFLOAT3 aTop(a.x, a.y + settings.wallHeight, a.z);
+                const XMFLOAT3 bTop(b.x, b.y + settings.wallHeight, b.z);
+                occluders.insert(occluders.end(), { a, b, bTop, a, bTop, aTop });
+            }
+
+            const float dx = b.x - a.x, dz = b.z - a.z;
+            const float length = std::sqrt(dx * dx + dz * dz);
+            if (length <= 1e-4f) continue;
+
+            // Into the polygon, whichever way it winds
+            XMFLOAT3 normal(-dz / length, 0.0f, dx / length);
+            if (normal.x * (shape.center.x - a.x) + normal.z * (shape.center.z - a.z) < 0.0f) {
+                normal = XMFLOAT3(-normal.x, 0.0f, -normal.z);
+            }
+
+            const uint32_t samples = std::max(1u, static_cast<uint32_t>(std::ceil(length / spacing)));
+            for (uint32_t s = 0; s < samples; ++s) {
+                const float t = (s + 0.5f) / samples;
+                XMFLOAT3 position(a.x + (b.x - a.x) * t + normal.x * settings.wallOffset, a.y + (b.y - a.y) * t,
+                                  a.z + (b.z - a.z) * t + normal.z * settings.wallOffset);
+                if (navMesh.FindNearestPolygon(position, settings.wallOffset + 0.1f, &position) == NavMesh::INVALID_POLYGON) {
+                    continue;
+                }
+                // Inside corners sample the same spot from both walls
+                if (candidateGrid.QueryRadius(position, spacing * 0.5f, nearby) > 0) continue;
+
+                candidateGrid.Insert(position);
+                candidates.push_back({ position, normal, { 0, 0 } });
+            }
+        }
+    }
+
+    TriangleGrid occluderGrid(std::move(occluders));
+    auto testRange = [&](size_t begin, size_t end) {
+        thread_local std::vector<uint32_t> triangles;
+        for (size_t i = begin; i < end; ++i) {
+            Candidate& candidate = candidates[i];
+            occluderGrid.Gather(candidate.position, settings.shieldDistance, triangles);
+            candidate.sectors.protection = BlockedSectors(occluderGrid, triangles, candidate.position,
+                                                          settings.crouchHeight, settings.shieldDistance);
+            // Hidden standing only counts where crouching is shielded too
+            if (candidate.sectors.protection != 0) {
+                candidate.sectors.concealment = candidate.sectors.protection &
+                    BlockedSectors(occluderGrid, triangles, candidate.position, settings.standHeight, settings.shieldDistance);
+            }
+        }
+    };
+    if (jobs && jobs->IsInitialized()) {
+        jobs->ParallelFor(candidates.size(), POINT_GRAIN, testRange);
+    } else {
+        testRange(0, candidates.size());
+    }
+
+    for (const Candidate& candidate : candidates) {
+        if (candidate.sectors.protection != 0) AddPoint(candidate.position, candidate.normal, candidate.sectors);
+    }
+    return !points_.empty();
+}
+
+uint32_t CoverMap::GetSector(const XMFLOAT3& direction) {
+    if (direction.x == 0.0f && direction.z == 0.0f) return 0;
+    const float angle = std::atan2(direction.z, direction.x) + PI;
+    return std::min(static_cast<uint32_t>(angle / TWO_PI * SECTOR_COUNT), SECTOR_COUNT - 1);
+}
+
+bool CoverMap::IsProtectedFrom(uint32_t point, const XMFLOAT3& threatPosition) const {
+    return IsProtected(point, Subtract(threatPosition, points_[point].position));
+}
+
+size_t CoverMap::FindPoints(const XMFLOAT3& position, float radius, std::vector<uint32_t>& results) const {
+    return grid_.QueryRadius(position, radius, results);
+}
+
+uint32_t CoverMap::FindNearestProtected(const XMFLOAT3& position, float radius, const XMFLOAT3& direction) const {
+    thread_local std::vector<uint32_t> found;
+    grid_.QueryRadius(position, radius, found);
+
+    const uint32_t sector = GetSector(direction);
+    uint32_t best = INVALID_POINT;
+    float bestDistance = 0.0f;
+    for (uint32_t point : found) {
+        if (!((sectors_[point].protection >> sector) & 1u)) continue;
+        const XMFLOAT3 offset = Subtract(points_[point].position, position);
+        const float distance = Dot(offset, offset);
+        if (best == INVALID_POINT || distance < bestDistance) {
+            best = point;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+bool CoverMap::Save(const std::string& filename) const {
+    FileHeader header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.pointCount = static_cast<uint32_t>(points_.size());
+
+    std::vector<FilePoint> points(points_.size());
+    for (size_t i = 0; i < points_.size(); ++i) {
+        points[i] = { points_[i].position, points_[i].normal, sectors_[i] };
+    }
+
+    bool written = WriteFileAtomic(filename, [&](std::ostream& file) {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(FilePoint));
+    });
+    if (!written) {
+        Logger::Error("Failed to write cover map: " + filename);
+        return false;
+    }
+    return true;
+}
+
+bool CoverMap::Load(const std::string& filename) {
+    Clear();
+    std::ifstream file(filename, std::ios::binary);
+    FileHeader header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != MAGIC ||
+        header.version != VERSION) {
+        Logger::Error("Not a cover map: " + filename);
+        return false;
+    }
+
+    std::vector<FilePoint> points(header.pointCount);
+    if (!file.read(reinterpret_cast<char*>(points.data()), points.size() * sizeof(FilePoint))) {
+        Logger::Error("Truncated cover map: " + filename);
+        return false;
+    }
+
+    points_.reserve(points.size());
+    sectors_.reserve(points.size());
+    for (const FilePoint& point : points) {
+        AddPoint(point.position, point.normal, point.sectors);
+    }
+    return true;
+}
+
+std::string CoverMap::GetCachePath(const std::string& sourceFile) {
+    return sourceFile + ".ncov";
+}
+
+bool CoverMap::BuildCache(const std::string& sourceFile, const NavMeshSettings& navMeshSettings,
+                          const CoverBakeSettings& settings) {
+    std::error_code error;
+    auto cacheTime = std::filesystem::last_write_time(GetCachePath(sourceFile), error);
+    if (!error) {
+        auto sourceTime = std::filesystem::last_write_time(sourceFile, error);
+        if (error || cacheTime >= sourceTime) return true;
+    }
+
+    MeshData mesh;
+    if (!MeshImporter::Import(sourceFile, mesh)) return false;
+
+    NavMesh navMesh;
+    bool baked = NavMesh::BuildCache(sourceFile, navMeshSettings) && navMesh.Load(NavMesh::GetCachePath(sourceFile));
+    if (!baked && !navMesh.Build(mesh, navMeshSettings)) return false;
+
+    std::vector<XMFLOAT3> positions(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        positions[i] = mesh.vertices[i].position;
+    }
+    size_t first = mesh.lods.empty() ? 0 : mesh.lods[0].indexOffset;
+    size_t count = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+
+    // A level without cover still gets its (empty) cache, so it isn't baked again every load
+    CoverMap cover;
+    cover.Build(navMesh, positions.data(), positions.size(), mesh.indices.data() + first, count, settings);
+    Logger::Info("Baked " + GetCachePath(sourceFile) + ": " + std::to_string(cover.GetPointCount()) + " cover points");
+    return cover.Save(GetCachePath(sourceFile));
+}
+
+} // namespace Nexus
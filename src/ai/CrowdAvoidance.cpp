@@ -0,0 +1,300 @@
+#include "CrowdAvoidance.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+
+constexpr float EPSILON = 1e-5f;
+// Agents solved per job
+constexpr size_t AGENT_GRAIN = 32;
+// Grid cells as a fraction of the neighbour distance; small cells let the nearest-neighbour
+// search in a dense crowd stop after a ring or two
+constexpr float GRID_CELL_FRACTION = 0.25f;
+
+struct Line {
+    XMFLOAT2 point;
+    XMFLOAT2 direction;                        // Unit; the allowed side is on its left
+};
+
+// Neighbours of one agent, structure-of-arrays and padded to a multiple of four
+struct alignas(16) NeighbourBatch {
+    float relativePositionX[CrowdAvoidance::MAX_NEIGHBORS];
+    float relativePositionY[CrowdAvoidance::MAX_NEIGHBORS];
+    float relativeVelocityX[CrowdAvoidance::MAX_NEIGHBORS];
+    float relativeVelocityY[CrowdAvoidance::MAX_NEIGHBORS];
+    float combinedRadius[CrowdAvoidance::MAX_NEIGHBORS];
+    float pointX[CrowdAvoidance::MAX_NEIGHBORS];
+    float pointY[CrowdAvoidance::MAX_NEIGHBORS];
+    float directionX[CrowdAvoidance::MAX_NEIGHBORS];
+    float directionY[CrowdAvoidance::MAX_NEIGHBORS];
+};
+
+float Dot(const XMFLOAT2& a, const XMFLOAT2& b) { return a.x * b.x + a.y * b.y; }
+float Det(const XMFLOAT2& a, const XMFLOAT2& b) { return a.x * b.y - a.y * b.x; }
+XMFLOAT2 Sub(const XMFLOAT2& a, const XMFLOAT2& b) { return XMFLOAT2(a.x - b.x, a.y - b.y); }
+XMFLOAT2 MulAdd(const XMFLOAT2& a, const XMFLOAT2& b, float t) { return XMFLOAT2(a.x + b.x * t, a.y + b.y * t); }
+
+__m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// The ORCA half-plane of every neighbour in the batch, four at a time. Past the cut-off circle
+// the velocity is pushed out of the nearer leg of the truncated cone; in front of it, or when
+// the agents already overlap, out of the circle itself, with overlapping agents separating
+// within one step
+void BuildHalfPlanes(NeighbourBatch& batch, uint32_t count, const XMFLOAT2& velocity, float invTimeHorizon,
+                     float invTimeStep) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 epsilon = _mm_set1_ps(EPSILON);
+    const __m128 horizon = _mm_set1_ps(invTimeHorizon);
+    const __m128 step = _mm_set1_ps(invTimeStep);
+    const __m128 vx = _mm_set1_ps(velocity.x);
+    const __m128 vy = _mm_set1_ps(velocity.y);
+
+    for (uint32_t n = 0; n < count; n += 4) {
+        const __m128 px = _mm_load_ps(&batch.relativePositionX[n]);
+        const __m128 py = _mm_load_ps(&batch.relativePositionY[n]);
+        const __m128 rvx = _mm_load_ps(&batch.relativeVelocityX[n]);
+        const __m128 rvy = _mm_load_ps(&batch.relativeVelocityY[n]);
+        const __m128 radius = _mm_load_ps(&batch.combinedRadius[n]);
+
+        const __m128 distanceSq = _mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py));
+        const __m128 radiusSq = _mm_mul_ps(radius, radius);
+        const __m128 colliding = _mm_cmple_ps(distanceSq, radiusSq);
+
+        // Relative velocity from the centre of the cut-off circle
+        const __m128 wx = _mm_sub_ps(rvx, _mm_mul_ps(horizon, px));
+        const __m128 wy = _mm_sub_ps(rvy, _mm_mul_ps(horizon, py));
+        const __m128 wLengthSq = _mm_add_ps(_mm_mul_ps(wx, wx), _mm_mul_ps(wy, wy));
+        const __m128 along = _mm_add_ps(_mm_mul_ps(wx, px), _mm_mul_ps(wy, py));
+        const __m128 onCircle = _mm_and_ps(_mm_cmplt_ps(along, zero),
+                                           _mm_cmpgt_ps(_mm_mul_ps(along, along), _mm_mul_ps(radiusSq, wLengthSq)));
+        const __m128 useCircle = _mm_or_ps(colliding, onCircle);
+
+        // Circle: of the cut-off, or of the overlap resolved within this step
+        const __m128 scale = Select(colliding, step, horizon);
+        const __m128 cx = _mm_sub_ps(rvx, _mm_mul_ps(scale, px));
+        const __m128 cy = _mm_sub_ps(rvy, _mm_mul_ps(scale, py));
+        const __m128 cLength = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), epsilon));
+        const __m128 unitX = _mm_div_ps(cx, cLength);
+        const __m128 unitY = _mm_div_ps(cy, cLength);
+        const __m128 push = _mm_sub_ps(_mm_mul_ps(radius, scale), cLength);
+        const __m128 circleUX = _mm_mul_ps(unitX, push);
+        const __m128 circleUY = _mm_mul_ps(unitY, push);
+
+        // Legs: whichever side of the relative position w lies on
+        const __m128 leg = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(distanceSq, radiusSq), zero));
+        const __m128 invDistanceSq = _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(distanceSq, epsilon));
+        const __m128 left = _mm_cmpgt_ps(_mm_sub_ps(_mm_mul_ps(px, wy), _mm_mul_ps(py, wx)), zero);
+        const __m128 pxLeg = _mm_mul_ps(px, leg), pyLeg = _mm_mul_ps(py, leg);
+        const __m128 pxRadius = _mm_mul_ps(px, radius), pyRadius = _mm_mul_ps(py, radius);
+        const __m128 legX = _mm_mul_ps(Select(left, _mm_sub_ps(pxLeg, pyRadius), _mm_sub_ps(zero, _mm_add_ps(pxLeg, pyRadius))),
+                                       invDistanceSq);
+        const __m128 legY = _mm_mul_ps(Select(left, _mm_add_ps(pxRadius, pyLeg), _mm_sub_ps(pxRadius, pyLeg)),
+                                       invDistanceSq);
+        const __m128 onLeg = _mm_add_ps(_mm_mul_ps(rvx, legX), _mm_mul_ps(rvy, legY));
+        const __m128 legUX = _mm_sub_ps(_mm_mul_ps(onLeg, legX), rvx);
+        const __m128 legUY = _mm_sub_ps(_mm_mul_ps(onLeg, legY), rvy);
+
+        // Each agent takes half of the change
+        _mm_store_ps(&batch.directionX[n], Select(useCircle, unitY, legX));
+        _mm_store_ps(&batch.directionY[n], Select(useCircle, _mm_sub_ps(zero, unitX), legY));
+        _mm_store_ps(&batch.pointX[n], _mm_add_ps(vx, _mm_mul_ps(half, Select(useCircle, circleUX, legUX))));
+        _mm_store_ps(&batch.pointY[n], _mm_add_ps(vy, _mm_mul_ps(half, Select(useCircle, circleUY, legUY))));
+    }
+}
+
+// Optimum on line lineNo within the speed circle and the lines before it; false when infeasible
+bool LinearProgram1(const Line* lines, uint32_t lineNo, float radius, const XMFLOAT2& optimal, bool directionOpt,
+                    XMFLOAT2& result) {
+    const Line& line = lines[lineNo];
+    const float dot = Dot(line.point, line.direction);
+    const float discriminant = dot * dot + radius * radius - Dot(line.point, line.point);
+    if (discriminant < 0.0f) return false;
+
+    const float root = std::sqrt(discriminant);
+    float tLeft = -dot - root;
+    float tRight = -dot + root;
+
+    for (uint32_t i = 0; i < lineNo; ++i) {
+        const float denominator = Det(line.direction, lines[i].direction);
+        const float numerator = Det(lines[i].direction, Sub(line.point, lines[i].point));
+        if (std::fabs(denominator) <= EPSILON) {
+            // Parallel: either all of this line is allowed by line i or none of it
+            if (numerator < 0.0f) return false;
+            continue;
+        }
+
+        const float t = numerator / denominator;
+        if (denominator >= 0.0f) {
+            tRight = std::min(tRight, t);
+        } else {
+            tLeft = std::max(tLeft, t);
+        }
+        if (tLeft > tRight) return false;
+    }
+
+    if (directionOpt) {
+        result = MulAdd(line.point, line.direction, Dot(optimal, line.direction) > 0.0f ? tRight : tLeft);
+    } else {
+        const float t = Dot(line.direction, Sub(optimal, line.point));
+        result = MulAdd(line.point, line.direction, std::max(tLeft, std::min(t, tRight)));
+    }
+    return true;
+}
+
+// Velocity nearest optimal (or furthest along it, with directionOpt) inside the speed circle and
+// all lines. Returns the count of lines satisfied before one failed
+uint32_t LinearProgram2(const Line* lines, uint32_t lineCount, float radius, const XMFLOAT2& optimal,
+                        bool directionOpt, XMFLOAT2& result) {
+    if (directionOpt) {
+        result = XMFLOAT2(optimal.x * radius, optimal.y * radius);
+    } else if (Dot(optimal, optimal) > radius * radius) {
+        const float scale = radius / std::sqrt(Dot(optimal, optimal));
+        result = XMFLOAT2(optimal.x * scale, optimal.y * scale);
+    } else {
+        result = optimal;
+    }
+
+    for (uint32_t i = 0; i < lineCount; ++i) {
+        if (Det(lines[i].direction, Sub(lines[i].point, result)) > 0.0f) {
+            const XMFLOAT2 previous = result;
+            if (!LinearProgram1(lines, i, radius, optimal, directionOpt, result)) {
+                result = previous;
+                return i;
+            }
+        }
+    }
+    return lineCount;
+}
+
+// Infeasible from beginLine on: minimise the largest violation instead, projecting the lines onto
+// each violated one in turn
+void LinearProgram3(const Line* lines, uint32_t lineCount, uint32_t beginLine, float radius, XMFLOAT2& result) {
+    Line projected[CrowdAvoidance::MAX_NEIGHBORS];
+    float distance = 0.0f;
+
+    for (uint32_t i = beginLine; i < lineCount; ++i) {
+        if (Det(lines[i].direction, Sub(lines[i].point, result)) <= distance) continue;
+
+        uint32_t projectedCount = 0;
+        for (uint32_t j = 0; j < i; ++j) {
+            Line line;
+            const float determinant = Det(lines[i].direction, lines[j].direction);
+            if (std::fabs(determinant) <= EPSILON) {
+                // Parallel and pointing the same way: line j adds nothing
+                if (Dot(lines[i].direction, lines[j].direction) > 0.0f) continue;
+                line.point = XMFLOAT2(0.5f * (lines[i].point.x + lines[j].point.x),
+                                      0.5f * (lines[i].point.y + lines[j].point.y));
+            } else {
+                line.point = MulAdd(lines[i].point, lines[i].direction,
+                                    Det(lines[j].direction, Sub(lines[i].point, lines[j].point)) / determinant);
+            }
+
+            XMFLOAT2 direction = Sub(lines[j].direction, lines[i].direction);
+            const float length = std::sqrt(Dot(direction, direction));
+            if (length <= EPSILON) continue;
+            line.direction = XMFLOAT2(direction.x / length, direction.y / length);
+            projected[projectedCount++] = line;
+        }
+
+        // Rounding can leave no solution at all; keep the last one then
+        const XMFLOAT2 previous = result;
+        const XMFLOAT2 outwards(-lines[i].direction.y, lines[i].direction.x);
+        if (LinearProgram2(projected, projectedCount, radius, outwards, true, result) < projectedCount) {
+            result = previous;
+        }
+        distance = Det(lines[i].direction, Sub(lines[i].point, result));
+    }
+}
+
+} // namespace
+
+CrowdAvoidance::CrowdAvoidance()
+    : grid_(CrowdSettings().neighborDistance * GRID_CELL_FRACTION) {}
+
+void CrowdAvoidance::Solve(const std::vector<CrowdAgent>& agents, float deltaTime, std::vector<XMFLOAT2>& velocities,
+                           JobSystem* jobs) {
+    NEXUS_PROFILE_SCOPE("CrowdAvoidance::Solve");
+    velocities.resize(agents.size());
+    if (agents.empty()) return;
+
+    // Rebuilt from empty, so item ids are agent indices
+    grid_.Clear();
+    grid_.SetCellSize(settings_.neighborDistance * GRID_CELL_FRACTION);
+    for (const CrowdAgent& agent : agents) {
+        grid_.Insert(XMFLOAT3(agent.position.x, 0.0f, agent.position.y));
+    }
+
+    const float timeStep = std::max(deltaTime, EPSILON);
+    auto solveRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            SolveAgent(agents, static_cast<uint32_t>(i), timeStep, velocities[i]);
+        }
+    };
+
+    if (jobs && jobs->IsInitialized() && agents.size() > AGENT_GRAIN) {
+        jobs->ParallelFor(agents.size(), AGENT_GRAIN, solveRange);
+    } else {
+        solveRange(0, agents.size());
+    }
+}
+
+void CrowdAvoidance::SolveAgent(const std::vector<CrowdAgent>& agents, uint32_t agent, float deltaTime,
+                                XMFLOAT2& velocity) const {
+    thread_local std::vector<uint32_t> nearest;
+
+    // Self included, and closest first so the linear programs meet the tightest constraints early
+    const CrowdAgent& self = agents[agent];
+    const uint32_t limit = std::min(settings_.maxNeighbors, MAX_NEIGHBORS);
+    grid_.QueryNearest(XMFLOAT3(self.position.x, 0.0f, self.position.y), settings_.neighborDistance, limit + 1, nearest);
+    nearest.erase(std::remove(nearest.begin(), nearest.end(), agent), nearest.end());
+    if (nearest.size() > limit) nearest.pop_back();
+
+    const uint32_t count = static_cast<uint32_t>(nearest.size());
+    if (count == 0) {
+        LinearProgram2(nullptr, 0, self.maxSpeed, self.preferredVelocity, false, velocity);
+        return;
+    }
+
+    NeighbourBatch batch;
+    for (uint32_t n = 0; n < count; ++n) {
+        const CrowdAgent& other = agents[nearest[n]];
+        batch.relativePositionX[n] = other.position.x - self.position.x;
+        batch.relativePositionY[n] = other.position.y - self.position.y;
+        batch.relativeVelocityX[n] = self.velocity.x - other.velocity.x;
+        batch.relativeVelocityY[n] = self.velocity.y - other.velocity.y;
+        batch.combinedRadius[n] = self.radius + other.radius;
+    }
+    // Padding lanes hold a far, still neighbour; their lines are never read
+    const uint32_t padded = (count + 3) & ~3u;
+    for (uint32_t n = count; n < padded; ++n) {
+        batch.relativePositionX[n] = settings_.neighborDistance * 2.0f;
+        batch.relativePositionY[n] = 0.0f;
+        batch.relativeVelocityX[n] = 0.0f;
+        batch.relativeVelocityY[n] = 0.0f;
+        batch.combinedRadius[n] = 0.0f;
+    }
+    BuildHalfPlanes(batch, padded, self.velocity, 1.0f / std::max(settings_.timeHorizon, EPSILON), 1.0f / deltaTime);
+
+    Line lines[MAX_NEIGHBORS];
+    for (uint32_t n = 0; n < count; ++n) {
+        lines[n].point = XMFLOAT2(batch.pointX[n], batch.pointY[n]);
+        lines[n].direction = XMFLOAT2(batch.directionX[n], batch.directionY[n]);
+    }
+
+    uint32_t satisfied = LinearProgram2(lines, count, self.maxSpeed, self.preferredVelocity, false, velocity);
+    if (satisfied < count) {
+        LinearProgram3(lines, count, satisfied, self.maxSpeed, velocity);
+    }
+}
+
+} // namespace Nexus
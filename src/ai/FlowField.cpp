@@ -0,0 +1,175 @@
+#include "FlowField.h"
+#include "NavMesh.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+// How far agents may stray off the navmesh and still be steered back onto it
+constexpr float SNAP_RADIUS = 2.0f;
+// Portal ends kept clear of, as a fraction of the portal, so agents don't graze corners
+constexpr float PORTAL_INSET = 0.1f;
+
+float Distance(const XMFLOAT3& a, const XMFLOAT3& b) {
+    float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+XMFLOAT3 ClosestPointOnSegment(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& point) {
+    XMFLOAT3 ab(b.x - a.x, b.y - a.y, b.z - a.z);
+    float lengthSq = ab.x * ab.x + ab.y * ab.y + ab.z * ab.z;
+    float t = 0.5f;
+    if (lengthSq > 0.0f) {
+        t = ((point.x - a.x) * ab.x + (point.y - a.y) * ab.y + (point.z - a.z) * ab.z) / lengthSq;
+        t = std::max(PORTAL_INSET, std::min(t, 1.0f - PORTAL_INSET));
+    }
+    return XMFLOAT3(a.x + ab.x * t, a.y + ab.y * t, a.z + ab.z * t);
+}
+}
+
+FlowField::FlowField(std::shared_ptr<const NavMesh> navMesh, uint32_t goalPolygon, const XMFLOAT3& goal)
+    : navMesh_(std::move(navMesh))
+    , goalPolygon_(goalPolygon)
+    , goal_(goal)
+    , revision_(navMesh_ ? navMesh_->GetRevision() : 0)
+    , reachable_(0)
+{
+    Build();
+}
+
+void FlowField::Build() {
+    NEXUS_PROFILE_SCOPE("FlowField::Build");
+    const size_t polygonCount = navMesh_ ? navMesh_->GetPolygonCount() : 0;
+    if (goalPolygon_ >= polygonCount) return;
+
+    cost_.assign(polygonCount, FLT_MAX);
+    next_.assign(polygonCount, INVALID_POLYGON);
+    steer_.assign(polygonCount, goal_);
+
+    // Dijkstra outwards from the goal. Polygons settle in order of cost, so the polygon each one
+    // leads into already has its steering point when it settles
+    using Entry = std::pair<float, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    std::vector<bool> settled(polygonCount, false);
+    cost_[goalPolygon_] = 0.0f;
+    open.push({ 0.0f, goalPolygon_ });
+
+    while (!open.empty()) {
+        auto [cost, polygon] = open.top();
+        open.pop();
+        if (settled[polygon]) continue;
+        settled[polygon] = true;
+        reachable_++;
+
+        if (polygon != goalPolygon_) {
+            XMFLOAT3 left, right;
+            if (navMesh_->GetPortal(polygon, next_[polygon], left, right)) {
+                steer_[polygon] = ClosestPointOnSegment(left, right, steer_[next_[polygon]]);
+            }
+        }
+
+        const XMFLOAT3& from = polygon == goalPolygon_ ? goal_ : navMesh_->GetPolygon(polygon).center;
+        const uint32_t edgeCount = navMesh_->GetPolygon(polygon).vertexCount;
+        for (uint32_t edge = 0; edge < edgeCount; ++edge) {
+            uint32_t neighbour = navMesh_->GetNeighbour(polygon, edge);
+            if (neighbour == NavMesh::INVALID_POLYGON || settled[neighbour]) continue;
+
+            float through = cost + Distance(from, navMesh_->GetPolygon(neighbour).center);
+            if (through < cost_[neighbour]) {
+                cost_[neighbour] = through;
+                next_[neighbour] = polygon;
+                open.push({ through, neighbour });
+            }
+        }
+    }
+}
+
+bool FlowField::GetDirection(const XMFLOAT3& position, XMFLOAT3& direction, XMFLOAT3* target) const {
+    if (cost_.empty()) return false;
+
+    uint32_t polygon = navMesh_->FindNearestPolygon(position, SNAP_RADIUS);
+    if (polygon == NavMesh::INVALID_POLYGON || cost_[polygon] == FLT_MAX) return false;
+
+    // Standing on the portal already: aim for the one after it
+    XMFLOAT3 point = steer_[polygon];
+    if (polygon != goalPolygon_ && Distance(position, point) < 0.05f) {
+        point = steer_[next_[polygon]];
+    }
+
+    float dx = point.x - position.x;
+    float dz = point.z - position.z;
+    float length = std::sqrt(dx * dx + dz * dz);
+    if (length <= 1e-5f) {
+        direction = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    } else {
+        direction = XMFLOAT3(dx / length, 0.0f, dz / length);
+    }
+    if (target) *target = point;
+    return true;
+}
+
+float FlowField::GetCost(const XMFLOAT3& position) const {
+    if (cost_.empty()) return FLT_MAX;
+
+    XMFLOAT3 nearest;
+    uint32_t polygon = navMesh_->FindNearestPolygon(position, SNAP_RADIUS, &nearest);
+    if (polygon == NavMesh::INVALID_POLYGON || cost_[polygon] == FLT_MAX) return FLT_MAX;
+    return cost_[polygon] + Distance(position, polygon == goalPolygon_ ? goal_ : steer_[polygon]);
+}
+
+FlowFieldCache::FlowFieldCache()
+    : revision_(0)
+    , capacity_(DEFAULT_CAPACITY) {}
+
+void FlowFieldCache::SetNavMesh(std::shared_ptr<const NavMesh> navMesh) {
+    navMesh_ = std::move(navMesh);
+    Clear();
+}
+
+void FlowFieldCache::SetCapacity(size_t fields) {
+    capacity_ = std::max<size_t>(fields, 1);
+    while (fields_.size() > capacity_) {
+        index_.erase(fields_.back()->GetGoalPolygon());
+        fields_.pop_back();
+    }
+}
+
+void FlowFieldCache::Clear() {
+    fields_.clear();
+    index_.clear();
+    revision_ = navMesh_ ? navMesh_->GetRevision() : 0;
+}
+
+std::shared_ptr<const FlowField> FlowFieldCache::GetField(const XMFLOAT3& goal, float searchRadius) {
+    if (!navMesh_ || navMesh_->GetPolygonCount() == 0) return nullptr;
+    if (navMesh_->GetRevision() != revision_) Clear();
+    stats_.requests++;
+
+    XMFLOAT3 snapped;
+    uint32_t goalPolygon = navMesh_->FindNearestPolygon(goal, searchRadius, &snapped);
+    if (goalPolygon == NavMesh::INVALID_POLYGON) return nullptr;
+
+    auto it = index_.find(goalPolygon);
+    if (it != index_.end()) {
+        fields_.splice(fields_.begin(), fields_, it->second);
+        return fields_.front();
+    }
+
+    stats_.builds++;
+    fields_.push_front(std::make_shared<const FlowField>(navMesh_, goalPolygon, snapped));
+    index_[goalPolygon] = fields_.begin();
+    if (fields_.size() > capacity_) {
+        index_.erase(fields_.back()->GetGoalPolygon());
+        fields_.pop_back();
+    }
+    return fields_.front();
+}
+
+} // namespace Nexus
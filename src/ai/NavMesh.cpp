@@ -0,0 +1,562 @@
+#include "NavMesh.h"
+#include "AtomicFile.h"
+#include "Logger.h"
+#include "MeshImporter.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+constexpr uint32_t INVALID_INDEX = ~0u;
+constexpr uint32_t MAX_GRID_CELLS = 1u << 22;
+
+std::atomic<uint32_t> nextRevision(1);
+
+XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+float DistanceSq(const XMFLOAT3& a, const XMFLOAT3& b) {
+    XMFLOAT3 d = Subtract(a, b);
+    return d.x * d.x + d.y * d.y + d.z * d.z;
+}
+
+// Twice the signed area of abc seen from above, positive when clockwise like the polygons
+float TriArea2(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c) {
+    return (b.z - a.z) * (c.x - a.x) - (b.x - a.x) * (c.z - a.z);
+}
+
+uint64_t EdgeKey(uint32_t from, uint32_t to) {
+    return (static_cast<uint64_t>(from) << 32) | to;
+}
+
+uint64_t CellKey(int32_t x, int32_t y, int32_t z) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x) & 0x1FFFFF) << 42) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(y) & 0x1FFFFF) << 21) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(z) & 0x1FFFFF));
+}
+
+struct WorkPolygon {
+    uint32_t vertices[NavMesh::MAX_POLYGON_VERTICES];
+    uint32_t count;
+    bool alive;
+};
+
+// Joins b onto a across a's edge ea, which is b's edge eb reversed. False when the result would
+// have too many corners or not be strictly convex
+bool TryMerge(WorkPolygon& a, uint32_t ea, const WorkPolygon& b, uint32_t eb, uint32_t maxVertices,
+              const std::vector<XMFLOAT3>& vertices) {
+    const uint32_t count = a.count + b.count - 2;
+    if (count > maxVertices) return false;
+
+    // a from the end of the shared edge round to its start, then b's corners off the edge
+    uint32_t merged[NavMesh::MAX_POLYGON_VERTICES];
+    uint32_t n = 0;
+    for (uint32_t k = 0; k < a.count; ++k) merged[n++] = a.vertices[(ea + 1 + k) % a.count];
+    for (uint32_t k = 0; k + 2 < b.count; ++k) merged[n++] = b.vertices[(eb + 2 + k) % b.count];
+
+    for (uint32_t k = 0; k < count; ++k) {
+        const XMFLOAT3& prev = vertices[merged[(k + count - 1) % count]];
+        const XMFLOAT3& corner = vertices[merged[k]];
+        const XMFLOAT3& next = vertices[merged[(k + 1) % count]];
+        if (TriArea2(prev, corner, next) <= 1e-6f) return false;
+    }
+
+    std::copy(merged, merged + count, a.vertices);
+    a.count = count;
+    return true;
+}
+}
+
+NavMesh::NavMesh()
+    : gridOrigin_(0.0f, 0.0f)
+    , gridWidth_(0)
+    , gridHeight_(0)
+    , cellSize_(0.0f)
+    , clusterSize_(0)
+    , revision_(0)
+{
+}
+
+void NavMesh::Clear() {
+    vertices_.clear();
+    polygons_.clear();
+    corners_.clear();
+    neighbours_.clear();
+    clusters_.clear();
+    clusterLinks_.clear();
+    gridCells_.clear();
+    gridPolygons_.clear();
+    gridWidth_ = 0;
+    gridHeight_ = 0;
+    revision_ = nextRevision++;
+}
+
+bool NavMesh::Build(const XMFLOAT3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+                    const NavMeshSettings& settings) {
+    NEXUS_PROFILE_SCOPE("NavMesh::Build");
+    Clear();
+    if (!positions || !indices || indexCount < 3) return false;
+
+    const uint32_t maxVertices = std::min(std::max(settings.maxVerticesPerPolygon, 3u), MAX_POLYGON_VERTICES);
+    const float minNormalY = std::cos(XMConvertToRadians(std::min(std::max(settings.maxSlope, 0.0f), 90.0f)));
+    const float weld = std::max(settings.weldDistance, 1e-6f);
+
+    // Weld through a hash of weld-sized cells, checking the neighbours of a vertex's cell too
+    std::unordered_multimap<uint64_t, uint32_t> weldCells;
+    std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+    auto weldVertex = [&](uint32_t index) {
+        if (remap[index] != INVALID_INDEX) return remap[index];
+        const XMFLOAT3& p = positions[index];
+        const int32_t cx = static_cast<int32_t>(std::floor(p.x / weld));
+        const int32_t cy = static_cast<int32_t>(std::floor(p.y / weld));
+        const int32_t cz = static_cast<int32_t>(std::floor(p.z / weld));
+        for (int32_t dz = -1; dz <= 1; ++dz) {
+            for (int32_t dy = -1; dy <= 1; ++dy) {
+                for (int32_t dx = -1; dx <= 1; ++dx) {
+                    auto range = weldCells.equal_range(CellKey(cx + dx, cy + dy, cz + dz));
+                    for (auto it = range.first; it != range.second; ++it) {
+                        if (DistanceSq(vertices_[it->second], p) <= weld * weld) return remap[index] = it->second;
+                    }
+                }
+            }
+        }
+        uint32_t vertex = static_cast<uint32_t>(vertices_.size());
+        vertices_.push_back(p);
+        weldCells.emplace(CellKey(cx, cy, cz), vertex);
+        return remap[index] = vertex;
+    };
+
+    std::vector<WorkPolygon> work;
+    work.reserve(indexCount / 3);
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount) continue;
+
+        // Clockwise front faces make this the upward normal of a floor
+        const XMFLOAT3& p0 = positions[indices[i]];
+        XMFLOAT3 normal = Cross(Subtract(positions[indices[i + 1]], p0), Subtract(positions[indices[i + 2]], p0));
+        float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        if (length <= 1e-12f || normal.y < minNormalY * length) continue;
+
+        WorkPolygon polygon = {};
+        polygon.vertices[0] = weldVertex(indices[i]);
+        polygon.vertices[1] = weldVertex(indices[i + 1]);
+        polygon.vertices[2] = weldVertex(indices[i + 2]);
+        polygon.count = 3;
+        polygon.alive = true;
+        if (polygon.vertices[0] == polygon.vertices[1] || polygon.vertices[1] == polygon.vertices[2] ||
+            polygon.vertices[0] == polygon.vertices[2] ||
+            TriArea2(vertices_[polygon.vertices[0]], vertices_[polygon.vertices[1]], vertices_[polygon.vertices[2]]) <= 0.0f) {
+            continue;
+        }
+        work.push_back(polygon);
+    }
+    if (work.empty()) {
+        Logger::Warning("NavMesh::Build - No walkable triangles");
+        Clear();
+        return false;
+    }
+
+    // Merge passes, longest shared edge first. A polygon merges at most once per pass since its
+    // other shared edges go stale; passes repeat until nothing merges
+    struct SharedEdge {
+        uint32_t a, b;
+        uint32_t edgeA, edgeB;
+        float lengthSq;
+    };
+    std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> openEdges;
+    std::vector<SharedEdge> shared;
+    std::vector<uint8_t> touched;
+    for (;;) {
+        openEdges.clear();
+        shared.clear();
+        for (uint32_t p = 0; p < work.size(); ++p) {
+            const WorkPolygon& polygon = work[p];
+            if (!polygon.alive) continue;
+            for (uint32_t e = 0; e < polygon.count; ++e) {
+                uint32_t v0 = polygon.vertices[e], v1 = polygon.vertices[(e + 1) % polygon.count];
+                auto it = openEdges.find(EdgeKey(v1, v0));
+                if (it != openEdges.end()) {
+                    shared.push_back({ it->second.first, p, it->second.second, e, DistanceSq(vertices_[v0], vertices_[v1]) });
+                    openEdges.erase(it);
+                } else {
+                    openEdges[EdgeKey(v0, v1)] = { p, e };
+                }
+            }
+        }
+        std::sort(shared.begin(), shared.end(), [](const SharedEdge& x, const SharedEdge& y) { return x.lengthSq > y.lengthSq; });
+
+        touched.assign(work.size(), 0);
+        bool merged = false;
+        for (const SharedEdge& edge : shared) {
+            if (touched[edge.a] || touched[edge.b]) continue;
+            if (TryMerge(work[edge.a], edge.edgeA, work[edge.b], edge.edgeB, maxVertices, vertices_)) {
+                work[edge.b].alive = false;
+                touched[edge.a] = touched[edge.b] = 1;
+                merged = true;
+            }
+        }
+        if (!merged) break;
+    }
+
+    for (const WorkPolygon& polygon : work) {
+        if (!polygon.alive) continue;
+        Polygon out = {};
+        out.firstVertex = static_cast<uint32_t>(corners_.size());
+        out.vertexCount = polygon.count;
+        corners_.insert(corners_.end(), polygon.vertices, polygon.vertices + polygon.count);
+        polygons_.push_back(out);
+    }
+
+    BuildAdjacency();
+    Finalize(settings.clusterSize, settings.cellSize);
+    Logger::Info("Built navmesh: " + std::to_string(polygons_.size()) + " polygons from " +
+                 std::to_string(work.size()) + " walkable triangles, " + std::to_string(clusters_.size()) + " clusters");
+    return true;
+}
+
+bool NavMesh::Build(const MeshData& mesh, const NavMeshSettings& settings) {
+    std::vector<XMFLOAT3> positions(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        positions[i] = mesh.vertices[i].position;
+    }
+    size_t first = mesh.lods.empty() ? 0 : mesh.lods[0].indexOffset;
+    size_t count = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+    return Build(positions.data(), positions.size(), mesh.indices.data() + first, count, settings);
+}
+
+void NavMesh::BuildAdjacency() {
+    std::unordered_map<uint64_t, uint32_t> edges;
+    edges.reserve(corners_.size());
+    for (uint32_t p = 0; p < polygons_.size(); ++p) {
+        const Polygon& polygon = polygons_[p];
+        for (uint32_t e = 0; e < polygon.vertexCount; ++e) {
+            uint32_t v0 = corners_[polygon.firstVertex + e];
+            uint32_t v1 = corners_[polygon.firstVertex + (e + 1) % polygon.vertexCount];
+            edges.emplace(EdgeKey(v0, v1), p);
+        }
+    }
+
+    // A neighbour walks the same edge the other way
+    neighbours_.assign(corners_.size(), INVALID_POLYGON);
+    for (uint32_t p = 0; p < polygons_.size(); ++p) {
+        const Polygon& polygon = polygons_[p];
+        for (uint32_t e = 0; e < polygon.vertexCount; ++e) {
+            uint32_t v0 = corners_[polygon.firstVertex + e];
+            uint32_t v1 = corners_[polygon.firstVertex + (e + 1) % polygon.vertexCount];
+            auto it = edges.find(EdgeKey(v1, v0));
+            if (it != edges.end() && it->second != p) neighbours_[polygon.firstVertex + e] = it->second;
+        }
+    }
+}
+
+void NavMesh::Finalize(uint32_t clusterSize, float cellSize) {
+    XMFLOAT2 low(FLT_MAX, FLT_MAX), high(-FLT_MAX, -FLT_MAX);
+    for (Polygon& polygon : polygons_) {
+        XMFLOAT3 center(0.0f, 0.0f, 0.0f);
+        for (uint32_t k = 0; k < polygon.vertexCount; ++k) {
+            const XMFLOAT3& v = vertices_[corners_[polygon.firstVertex + k]];
+            center.x += v.x; center.y += v.y; center.z += v.z;
+            low.x = std::min(low.x, v.x); low.y = std::min(low.y, v.z);
+            high.x = std::max(high.x, v.x); high.y = std::max(high.y, v.z);
+        }
+        float scale = 1.0f / polygon.vertexCount;
+        polygon.center = XMFLOAT3(center.x * scale, center.y * scale, center.z * scale);
+    }
+
+    // Grow the cells rather than allocate an enormous grid for a sprawling level
+    cellSize_ = std::max(cellSize, 0.01f);
+    auto cellsAlong = [this](float extent) { return static_cast<uint32_t>(extent / cellSize_) + 1; };
+    while (static_cast<uint64_t>(cellsAlong(high.x - low.x)) * cellsAlong(high.y - low.y) > MAX_GRID_CELLS) {
+        cellSize_ *= 2.0f;
+    }
+    gridOrigin_ = low;
+    gridWidth_ = cellsAlong(high.x - low.x);
+    gridHeight_ = cellsAlong(high.y - low.y);
+
+    // Counting sort of polygons into every cell their extents overlap
+    auto forEachCell = [this](const Polygon& polygon, auto&& fn) {
+        float minX = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxZ = -FLT_MAX;
+        for (uint32_t k = 0; k < polygon.vertexCount; ++k) {
+            const XMFLOAT3& v = vertices_[corners_[polygon.firstVertex + k]];
+            minX = std::min(minX, v.x); minZ = std::min(minZ, v.z);
+            maxX = std::max(maxX, v.x); maxZ = std::max(maxZ, v.z);
+        }
+        uint32_t x0 = static_cast<uint32_t>((minX - gridOrigin_.x) / cellSize_);
+        uint32_t z0 = static_cast<uint32_t>((minZ - gridOrigin_.y) / cellSize_);
+        uint32_t x1 = std::min(static_cast<uint32_t>((maxX - gridOrigin_.x) / cellSize_), gridWidth_ - 1);
+        uint32_t z1 = std::min(static_cast<uint32_t>((maxZ - gridOrigin_.y) / cellSize_), gridHeight_ - 1);
+        for (uint32_t z = z0; z <= z1; ++z) {
+            for (uint32_t x = x0; x <= x1; ++x) fn(z * gridWidth_ + x);
+        }
+    };
+    gridCells_.assign(static_cast<size_t>(gridWidth_) * gridHeight_ + 1, 0);
+    for (const Polygon& polygon : polygons_) {
+        forEachCell(polygon, [this](uint32_t cell) { gridCells_[cell + 1]++; });
+    }
+    for (size_t cell = 1; cell < gridCells_.size(); ++cell) gridCells_[cell] += gridCells_[cell - 1];
+    gridPolygons_.resize(gridCells_.back());
+    std::vector<uint32_t> cursor(gridCells_.begin(), gridCells_.end() - 1);
+    for (uint32_t p = 0; p < polygons_.size(); ++p) {
+        forEachCell(polygons_[p], [&](uint32_t cell) { gridPolygons_[cursor[cell]++] = p; });
+    }
+
+    BuildClusters(clusterSize);
+    revision_ = nextRevision++;
+}
+
+void NavMesh::BuildClusters(uint32_t clusterSize) {
+    clusterSize_ = std::max(clusterSize, 1u);
+    clusters_.clear();
+    clusterLinks_.clear();
+    for (Polygon& polygon : polygons_) polygon.cluster = INVALID_INDEX;
+
+    // Breadth-first growth keeps every cluster connected, so a route through clusters can always
+    // be walked polygon by polygon without leaving them
+    std::vector<uint32_t> queue;
+    for (uint32_t seed = 0; seed < polygons_.size(); ++seed) {
+        if (polygons_[seed].cluster != INVALID_INDEX) continue;
+
+        const uint32_t cluster = static_cast<uint32_t>(clusters_.size());
+        Cluster out = {};
+        uint32_t members = 0;
+        queue.assign(1, seed);
+        for (size_t head = 0; head < queue.size() && members < clusterSize_; ++head) {
+            Polygon& polygon = polygons_[queue[head]];
+            if (polygon.cluster != INVALID_INDEX) continue;
+            polygon.cluster = cluster;
+            out.center.x += polygon.center.x; out.center.y += polygon.center.y; out.center.z += polygon.center.z;
+            ++members;
+            for (uint32_t e = 0; e < polygon.vertexCount; ++e) {
+                uint32_t neighbour = neighbours_[polygon.firstVertex + e];
+                if (neighbour != INVALID_POLYGON && polygons_[neighbour].cluster == INVALID_INDEX) queue.push_back(neighbour);
+            }
+        }
+        float scale = 1.0f / members;
+        out.center = XMFLOAT3(out.center.x * scale, out.center.y * scale, out.center.z * scale);
+        clusters_.push_back(out);
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    for (uint32_t p = 0; p < polygons_.size(); ++p) {
+        const Polygon& polygon = polygons_[p];
+        for (uint32_t e = 0; e < polygon.vertexCount; ++e) {
+            uint32_t neighbour = neighbours_[polygon.firstVertex + e];
+            if (neighbour != INVALID_POLYGON && polygons_[neighbour].cluster != polygon.cluster) {
+                pairs.emplace_back(polygon.cluster, polygons_[neighbour].cluster);
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    for (const auto& pair : pairs) {
+        Cluster& cluster = clusters_[pair.first];
+        if (cluster.linkCount == 0) cluster.firstLink = static_cast<uint32_t>(clusterLinks_.size());
+        cluster.linkCount++;
+        clusterLinks_.push_back({ pair.second, std::sqrt(DistanceSq(cluster.center, clusters_[pair.second].center)) });
+    }
+}
+
+XMFLOAT3 NavMesh::ClosestPoint(uint32_t polygonIndex, const XMFLOAT3& point, bool& inside) const {
+    const Polygon& polygon = polygons_[polygonIndex];
+    const uint32_t count = polygon.vertexCount;
+
+    inside = true;
+    for (uint32_t k = 0; k < count && inside; ++k) {
+        inside = TriArea2(GetCorner(polygonIndex, k), GetCorner(polygonIndex, (k + 1) % count), point) >= 0.0f;
+    }
+
+    if (inside) {
+        // Height from the fan triangle under the point; merged polygons need not be flat
+        const XMFLOAT3& a = GetCorner(polygonIndex, 0);
+        for (uint32_t k = 1; k + 1 < count; ++k) {
+            const XMFLOAT3& b = GetCorner(polygonIndex, k);
+            const XMFLOAT3& c = GetCorner(polygonIndex, k + 1);
+            float area = TriArea2(a, b, c);
+            float wa = TriArea2(b, c, point), wb = TriArea2(c, a, point), wc = TriArea2(a, b, point);
+            const float tolerance = -1e-4f * area;
+            if (area > 0.0f && wa >= tolerance && wb >= tolerance && wc >= tolerance) {
+                return XMFLOAT3(point.x, (wa * a.y + wb * b.y + wc * c.y) / area, point.z);
+            }
+        }
+        return XMFLOAT3(point.x, polygon.center.y, point.z);
+    }
+
+    // Nearest point on the border seen from above, at the height of the edge there
+    XMFLOAT3 best = polygon.center;
+    float bestDistance = FLT_MAX;
+    for (uint32_t k = 0; k < count; ++k) {
+        const XMFLOAT3& a = GetCorner(polygonIndex, k);
+        const XMFLOAT3& b = GetCorner(polygonIndex, (k + 1) % count);
+        float dx = b.x - a.x, dz = b.z - a.z;
+        float lengthSq = dx * dx + dz * dz;
+        float t = lengthSq > 0.0f ? ((point.x - a.x) * dx + (point.z - a.z) * dz) / lengthSq : 0.0f;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        XMFLOAT3 onEdge(a.x + dx * t, a.y + (b.y - a.y) * t, a.z + dz * t);
+        float distance = (onEdge.x - point.x) * (onEdge.x - point.x) + (onEdge.z - point.z) * (onEdge.z - point.z);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = onEdge;
+        }
+    }
+    return best;
+}
+
+uint32_t NavMesh::FindNearestPolygon(const XMFLOAT3& point, float searchRadius, XMFLOAT3* nearest) const {
+    if (polygons_.empty()) return INVALID_POLYGON;
+
+    const float radius = std::max(searchRadius, 0.0f);
+    float minX = (point.x - radius - gridOrigin_.x) / cellSize_, maxX = (point.x + radius - gridOrigin_.x) / cellSize_;
+    float minZ = (point.z - radius - gridOrigin_.y) / cellSize_, maxZ = (point.z + radius - gridOrigin_.y) / cellSize_;
+    if (maxX < 0.0f || maxZ < 0.0f || minX >= static_cast<float>(gridWidth_) || minZ >= static_cast<float>(gridHeight_)) {
+        return INVALID_POLYGON;
+    }
+    uint32_t x0 = static_cast<uint32_t>(std::max(minX, 0.0f));
+    uint32_t z0 = static_cast<uint32_t>(std::max(minZ, 0.0f));
+    uint32_t x1 = std::min(static_cast<uint32_t>(maxX), gridWidth_ - 1);
+    uint32_t z1 = std::min(static_cast<uint32_t>(maxZ), gridHeight_ - 1);
+
+    uint32_t best = INVALID_POLYGON;
+    float bestDistance = radius * radius;
+    XMFLOAT3 bestPoint = point;
+    for (uint32_t z = z0; z <= z1; ++z) {
+        for (uint32_t x = x0; x <= x1; ++x) {
+            const uint32_t cell = z * gridWidth_ + x;
+            for (uint32_t i = gridCells_[cell]; i < gridCells_[cell + 1]; ++i) {
+                bool inside;
+                XMFLOAT3 candidate = ClosestPoint(gridPolygons_[i], point, inside);
+                float distance = DistanceSq(candidate, point);
+                if (distance < bestDistance || (best == INVALID_POLYGON && distance <= bestDistance)) {
+                    best = gridPolygons_[i];
+                    bestDistance = distance;
+                    bestPoint = candidate;
+                }
+            }
+        }
+    }
+
+    if (nearest && best != INVALID_POLYGON) *nearest = bestPoint;
+    return best;
+}
+
+bool NavMesh::GetPortal(uint32_t from, uint32_t to, XMFLOAT3& left, XMFLOAT3& right) const {
+    const Polygon& polygon = polygons_[from];
+    for (uint32_t e = 0; e < polygon.vertexCount; ++e) {
+        if (neighbours_[polygon.firstVertex + e] == to) {
+            // Clockwise corners put the edge's start on the left when leaving through it
+            left = GetCorner(from, e);
+            right = GetCorner(from, (e + 1) % polygon.vertexCount);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NavMesh::Save(const std::string& filename) const {
+    FileHeader header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vertexCount = static_cast<uint32_t>(vertices_.size());
+    header.polygonCount = static_cast<uint32_t>(polygons_.size());
+    header.cornerCount = static_cast<uint32_t>(corners_.size());
+    header.clusterSize = clusterSize_;
+    header.cellSize = cellSize_;
+
+    std::vector<FilePolygon> polygons(polygons_.size());
+    for (size_t i = 0; i < polygons_.size(); ++i) {
+        polygons[i] = { polygons_[i].firstVertex, polygons_[i].vertexCount };
+    }
+
+    bool written = WriteFileAtomic(filename, [&](std::ostream& file) {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(vertices_.data()), vertices_.size() * sizeof(XMFLOAT3));
+        file.write(reinterpret_cast<const char*>(polygons.data()), polygons.size() * sizeof(FilePolygon));
+        file.write(reinterpret_cast<const char*>(corners_.data()), corners_.size() * sizeof(uint32_t));
+    });
+    if (!written) {
+        Logger::Error("Failed to write navmesh: " + filename);
+        return false;
+    }
+    return true;
+}
+
+bool NavMesh::Load(const std::string& filename) {
+    Clear();
+    std::ifstream file(filename, std::ios::binary);
+    FileHeader header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != MAGIC ||
+        header.version != VERSION || header.polygonCount == 0) {
+        Logger::Error("Not a navmesh: " + filename);
+        return false;
+    }
+
+    std::vector<FilePolygon> polygons(header.polygonCount);
+    vertices_.resize(header.vertexCount);
+    corners_.resize(header.cornerCount);
+    if (!file.read(reinterpret_cast<char*>(vertices_.data()), vertices_.size() * sizeof(XMFLOAT3)) ||
+        !file.read(reinterpret_cast<char*>(polygons.data()), polygons.size() * sizeof(FilePolygon)) ||
+        !file.read(reinterpret_cast<char*>(corners_.data()), corners_.size() * sizeof(uint32_t))) {
+        Logger::Error("Truncated navmesh: " + filename);
+        Clear();
+        return false;
+    }
+
+    polygons_.resize(polygons.size());
+    for (size_t i = 0; i < polygons.size(); ++i) {
+        const FilePolygon& polygon = polygons[i];
+        bool valid = polygon.vertexCount >= 3 && polygon.vertexCount <= MAX_POLYGON_VERTICES &&
+                     polygon.firstVertex + polygon.vertexCount <= corners_.size();
+        for (uint32_t k = 0; valid && k < polygon.vertexCount; ++k) {
+            valid = corners_[polygon.firstVertex + k] < vertices_.size();
+        }
+        if (!valid) {
+            Logger::Error("Corrupt navmesh: " + filename);
+            Clear();
+            return false;
+        }
+        polygons_[i] = Polygon();
+        polygons_[i].firstVertex = polygon.firstVertex;
+        polygons_[i].vertexCount = polygon.vertexCount;
+    }
+
+    BuildAdjacency();
+    Finalize(header.clusterSize, header.cellSize);
+    return true;
+}
+
+std::string NavMesh::GetCachePath(const std::string& sourceFile) {
+    return sourceFile + ".nnav";
+}
+
+bool NavMesh::BuildCache(const std::string& sourceFile, const NavMeshSettings& settings) {
+    std::error_code error;
+    auto cacheTime = std::filesystem::last_write_time(GetCachePath(sourceFile), error);
+    if (!error) {
+        auto sourceTime = std::filesystem::last_write_time(sourceFile, error);
+        if (error || cacheTime >= sourceTime) return true;
+    }
+
+    MeshData mesh;
+    NavMesh navMesh;
+    if (!MeshImporter::Import(sourceFile, mesh) || !navMesh.Build(mesh, settings)) return false;
+
+    Logger::Info("Baked " + GetCachePath(sourceFile) + ": " + std::to_string(navMesh.GetPolygonCount()) +
+                 " polygons, " + std::to_string(navMesh.GetClusterCount()) + " clusters");
+    return navMesh.Save(GetCachePath(sourceFile));
+}
+
+} // namespace Nexus
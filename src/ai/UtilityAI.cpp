@@ -0,0 +1,229 @@
+#include "UtilityAI.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace Nexus {
+
+namespace {
+
+// Groups of four entities scored per job; below this many entities Score() stays on one thread,
+// since a thousand entities take a few tens of microseconds
+constexpr size_t GROUP_GRAIN = 256;
+constexpr uint32_t MAX_POWER = 8;
+
+__m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__m128 Saturate(__m128 x) {
+    return _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+// e^x to about 1e-4 relative, which is well below what a response curve can be tuned to. The
+// exponent is split into a whole power of two, built in the float's exponent bits, and a fraction
+// in [-0.5, 0.5] for the polynomial
+__m128 Exp(__m128 x) {
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-80.0f)), _mm_set1_ps(80.0f));
+    const __m128 t = _mm_mul_ps(x, _mm_set1_ps(1.44269504f));
+    const __m128i whole = _mm_cvtps_epi32(t);
+    const __m128 f = _mm_sub_ps(t, _mm_cvtepi32_ps(whole));
+
+    // 2^f, f in [-0.5, 0.5]
+    __m128 p = _mm_set1_ps(1.3333558e-3f);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.6181291e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.5504109e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.4022651e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.9314718e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+    const __m128i bits = _mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(p, _mm_castsi128_ps(bits));
+}
+
+float Power(float x, uint32_t power) {
+    float result = x;
+    for (uint32_t i = 1; i < power; ++i) result *= x;
+    return result;
+}
+
+uint32_t RoundPower(float exponent) {
+    return std::min(std::max(static_cast<uint32_t>(std::lround(std::max(exponent, 1.0f))), 1u), MAX_POWER);
+}
+
+} // namespace
+
+float ResponseCurve::Evaluate(float x) const {
+    x = std::min(std::max(x, 0.0f), 1.0f);
+    const float shifted = x - xShift;
+    float y = 0.0f;
+    switch (type) {
+    case ResponseCurveType::Linear:
+        y = slope * shifted + yShift;
+        break;
+    case ResponseCurveType::Polynomial:
+        y = slope * Power(shifted, RoundPower(exponent)) + yShift;
+        break;
+    case ResponseCurveType::Logistic:
+        y = slope / (1.0f + std::exp(-exponent * shifted)) + yShift;
+        break;
+    case ResponseCurveType::Step:
+        y = (x >= xShift ? slope : 0.0f) + yShift;
+        break;
+    }
+    return std::min(std::max(y, 0.0f), 1.0f);
+}
+
+UtilityScorer::UtilityScorer()
+    : entityCount_(0)
+    , stride_(0)
+    , momentum_(0.25f) {
+}
+
+uint32_t UtilityScorer::AddInput(const std::string& name) {
+    const uint32_t existing = FindInput(name);
+    if (existing != INVALID_INPUT) return existing;
+
+    inputNames_.push_back(name);
+    inputs_.resize(inputNames_.size() * stride_, 0.0f);
+    return static_cast<uint32_t>(inputNames_.size() - 1);
+}
+
+uint32_t UtilityScorer::FindInput(const std::string& name) const {
+    const auto it = std::find(inputNames_.begin(), inputNames_.end(), name);
+    return it != inputNames_.end() ? static_cast<uint32_t>(it - inputNames_.begin()) : INVALID_INPUT;
+}
+
+uint32_t UtilityScorer::AddAction(const UtilityAction& action) {
+    for (const UtilityConsideration& consideration : action.considerations) {
+        if (consideration.input >= inputNames_.size()) return NO_ACTION;
+    }
+
+    ActionRange range;
+    range.weight = std::max(action.weight, 0.0f);
+    range.first = static_cast<uint32_t>(considerations_.size());
+    range.count = static_cast<uint32_t>(action.considerations.size());
+    range.compensation = range.count > 0 ? 1.0f - 1.0f / static_cast<float>(range.count) : 0.0f;
+    for (const UtilityConsideration& consideration : action.considerations) {
+        const ResponseCurve& curve = consideration.curve;
+        considerations_.push_back({consideration.input, curve.type, curve.slope, curve.exponent, curve.xShift,
+                                   curve.yShift, RoundPower(curve.exponent)});
+    }
+
+    ranges_.push_back(range);
+    actions_.push_back(action);
+    return static_cast<uint32_t>(actions_.size() - 1);
+}
+
+void UtilityScorer::ClearActions() {
+    actions_.clear();
+    ranges_.clear();
+    considerations_.clear();
+    std::fill(currentActions_.begin(), currentActions_.end(), NO_ACTION);
+}
+
+void UtilityScorer::SetEntityCount(size_t count) {
+    entityCount_ = count;
+    stride_ = (count + LANES - 1) / LANES * LANES;
+    inputs_.assign(inputNames_.size() * stride_, 0.0f);
+    currentActions_.assign(stride_, NO_ACTION);
+    choices_.assign(stride_, NO_ACTION);
+    scores_.assign(stride_, 0.0f);
+}
+
+void UtilityScorer::Score(JobSystem* jobs) {
+    NEXUS_PROFILE_SCOPE("UtilityScorer::Score");
+    const size_t groups = stride_ / LANES;
+    if (groups == 0) return;
+
+    auto scoreRange = [this](size_t begin, size_t end) { ScoreGroups(begin, end); };
+    if (jobs && jobs->IsInitialized() && groups > GROUP_GRAIN) {
+        jobs->ParallelFor(groups, GROUP_GRAIN, scoreRange);
+    } else {
+        scoreRange(0, groups);
+    }
+}
+
+void UtilityScorer::ScoreGroups(size_t begin, size_t end) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 noAction = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(NO_ACTION)));
+    const float bonus = 1.0f + std::max(momentum_, 0.0f);
+
+    for (size_t group = begin; group < end; ++group) {
+        const size_t first = group * LANES;
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&currentActions_[first]));
+        __m128 bestScore = zero;
+        __m128 bestAction = noAction;
+
+        for (uint32_t a = 0; a < ranges_.size(); ++a) {
+            const ActionRange& range = ranges_[a];
+            const __m128 isCurrent = _mm_castsi128_ps(_mm_cmpeq_epi32(current, _mm_set1_epi32(static_cast<int>(a))));
+            const __m128 weight = Select(isCurrent, _mm_set1_ps(range.weight * bonus), _mm_set1_ps(range.weight));
+
+            // Considerations only lower a score, so an action whose weight cannot beat the best in
+            // any lane is done with
+            if (_mm_movemask_ps(_mm_cmpgt_ps(weight, bestScore)) == 0) continue;
+
+            __m128 score = one;
+            const __m128 compensation = _mm_set1_ps(range.compensation);
+            for (uint32_t c = range.first; c < range.first + range.count; ++c) {
+                const Consideration& consideration = considerations_[c];
+                const __m128 x = Saturate(_mm_loadu_ps(&inputs_[consideration.input * stride_ + first]));
+                const __m128 shifted = _mm_sub_ps(x, _mm_set1_ps(consideration.xShift));
+                const __m128 slope = _mm_set1_ps(consideration.slope);
+                __m128 y = zero;
+                switch (consideration.type) {
+                case ResponseCurveType::Linear:
+                    y = _mm_mul_ps(slope, shifted);
+                    break;
+                case ResponseCurveType::Polynomial: {
+                    __m128 power = shifted;
+                    for (uint32_t i = 1; i < consideration.power; ++i) power = _mm_mul_ps(power, shifted);
+                    y = _mm_mul_ps(slope, power);
+                    break;
+                }
+                case ResponseCurveType::Logistic: {
+                    const __m128 e = Exp(_mm_mul_ps(_mm_set1_ps(-consideration.exponent), shifted));
+                    y = _mm_div_ps(slope, _mm_add_ps(one, e));
+                    break;
+                }
+                case ResponseCurveType::Step:
+                    y = _mm_and_ps(_mm_cmpge_ps(x, _mm_set1_ps(consideration.xShift)), slope);
+                    break;
+                }
+                y = Saturate(_mm_add_ps(y, _mm_set1_ps(consideration.yShift)));
+
+                // Make up for multiplying many factors below 1: y + (1 - y) * (1 - 1/n) * y
+                y = _mm_add_ps(y, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(one, y), compensation), y));
+                score = _mm_mul_ps(score, y);
+                if (_mm_movemask_ps(_mm_cmpgt_ps(score, zero)) == 0) break;
+            }
+
+            score = _mm_mul_ps(score, weight);
+            const __m128 better = _mm_cmpgt_ps(score, bestScore);
+            bestScore = Select(better, score, bestScore);
+            bestAction = Select(better, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(a))), bestAction);
+        }
+
+        _mm_storeu_ps(&scores_[first], bestScore);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&choices_[first]), _mm_castps_si128(bestAction));
+    }
+}
+
+float UtilityScorer::ScoreAction(uint32_t action, size_t entity) const {
+    if (action >= ranges_.size() || entity >= entityCount_) return 0.0f;
+
+    const ActionRange& range = ranges_[action];
+    float score = 1.0f;
+    for (const UtilityConsideration& consideration : actions_[action].considerations) {
+        const float y = consideration.curve.Evaluate(inputs_[consideration.input * stride_ + entity]);
+        score *= y + (1.0f - y) * range.compensation * y;
+    }
+    const float bonus = currentActions_[entity] == action ? 1.0f + std::max(momentum_, 0.0f) : 1.0f;
+    return score * range.weight * bonus;
+}
+
+} // namespace Nexus
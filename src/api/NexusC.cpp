@@ -5,8 +5,14 @@
 #include "AudioDevice.h"
 #include "PhysicsEngine.h"
 #include "Logger.h"
+#include "FrameMetrics.h"
+#include "Components.h"
+#include "ECS.h"
+#include "BatchMath.h"
+#include "SpriteBatcher.h"
 #include <DirectXMath.h>
 #include <memory>
+#include <cstddef>
 #include <map>
 
 using namespace Nexus;
@@ -23,6 +29,8 @@ struct NexusCallbacks {
 };
 
 static std::map<NexusEngine*, std::unique_ptr<NexusCallbacks>> s_callbacks;
+// Layer for lines and text, which take none, per graphics device
+static std::map<NexusGraphics*, int> s_layers;
 
 // Helper functions
 static XMFLOAT3 ToXMFloat3(NexusVector3 v) {
@@ -37,6 +45,24 @@ static XMFLOAT4 ToXMFloat4(NexusColor c) {
     return XMFLOAT4(c.r, c.g, c.b, c.a);
 }
 
+// The bulk calls hand C arrays to the engine as they are, so the layouts must match
+static_assert(sizeof(NexusVector3) == sizeof(XMFLOAT3), "NexusVector3 must match XMFLOAT3");
+static_assert(sizeof(NexusColor) == sizeof(XMFLOAT4), "NexusColor must match XMFLOAT4");
+static_assert(sizeof(NexusBodyId) == sizeof(RigidBodyID), "NexusBodyId must match RigidBodyID");
+static_assert(sizeof(NexusEntity) == sizeof(Entity), "NexusEntity must match Entity");
+static_assert(sizeof(NexusTransform) == sizeof(TransformComponent), "NexusTransform must match TransformComponent");
+static_assert(offsetof(NexusTransform, rotation) == offsetof(TransformComponent, rotation) &&
+              offsetof(NexusTransform, scale) == offsetof(TransformComponent, scale),
+              "NexusTransform must match TransformComponent");
+static_assert(sizeof(NexusVector4) == sizeof(XMFLOAT4), "NexusVector4 must match XMFLOAT4");
+static_assert(sizeof(NexusMatrix4) == sizeof(XMFLOAT4X4), "NexusMatrix4 must match XMFLOAT4X4");
+static_assert(sizeof(NexusAABB) == sizeof(AABB), "NexusAABB must match AABB");
+static_assert(sizeof(NexusFrustum) == sizeof(Frustum), "NexusFrustum must match Frustum");
+static_assert(sizeof(NexusSprite) == sizeof(SpriteBatcher::Sprite) &&
+              offsetof(NexusSprite, rotation) == offsetof(SpriteBatcher::Sprite, rotation) &&
+              offsetof(NexusSprite, color) == offsetof(SpriteBatcher::Sprite, color),
+              "NexusSprite must match SpriteBatcher::Sprite");
+
 // Engine management
 extern "C" {
 
@@ -86,6 +112,9 @@ void nexus_engine_run(NexusEngine* engine) {
                 graphics->BeginFrame();
                 callbacks->renderCallback(reinterpret_cast<NexusGraphics*>(graphics), 
                                         callbacks->renderUserData);
+                graphics->FlushPrimitiveBatch();
+                graphics->UpscaleScene();
+                graphics->FlushSpriteBatch();
                 graphics->EndFrame();
                 graphics->Present();
             }
@@ -166,6 +195,54 @@ void nexus_engine_set_target_fps(NexusEngine* engine, float fps) {
     }
 }
 
+// Frame metrics
+bool nexus_metrics_get_summary(NexusEngine* engine, const char* series, NexusMetricSummary* summary) {
+    if (!engine || !series || !summary) return false;
+    try {
+        FrameMetrics* metrics = reinterpret_cast<Engine*>(engine)->GetMetrics();
+        MetricSummary result;
+        if (!metrics || !metrics->GetSummary(series, result)) return false;
+        summary->last = result.last;
+        summary->mean = result.mean;
+        summary->p50 = result.p50;
+        summary->p95 = result.p95;
+        summary->p99 = result.p99;
+        summary->max = result.max;
+        summary->samples = result.samples;
+        summary->hitches = result.hitches;
+        summary->totalHitches = result.totalHitches;
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+void nexus_metrics_set_hitch_threshold(NexusEngine* engine, float factor, float minimumMs) {
+    if (!engine) return;
+    FrameMetrics* metrics = reinterpret_cast<Engine*>(engine)->GetMetrics();
+    if (metrics) metrics->SetHitchThreshold(factor, minimumMs);
+}
+
+bool nexus_metrics_export_csv(NexusEngine* engine, const char* filename) {
+    if (!engine || !filename) return false;
+    try {
+        FrameMetrics* metrics = reinterpret_cast<Engine*>(engine)->GetMetrics();
+        return metrics && metrics->ExportCSV(filename);
+    } catch (...) {
+        return false;
+    }
+}
+
+bool nexus_metrics_export_json(NexusEngine* engine, const char* filename) {
+    if (!engine || !filename) return false;
+    try {
+        FrameMetrics* metrics = reinterpret_cast<Engine*>(engine)->GetMetrics();
+        return metrics && metrics->ExportJSON(filename);
+    } catch (...) {
+        return false;
+    }
+}
+
 // Graphics API
 NexusGraphics* nexus_engine_get_graphics(NexusEngine* engine) {
     if (!engine) return nullptr;
@@ -212,6 +289,166 @@ void nexus_graphics_clear(NexusGraphics* graphics, NexusColor color) {
     }
 }
 
+void nexus_graphics_draw_cube(NexusGraphics* graphics, NexusVector3 position, NexusVector3 size, NexusColor color) {
+    if (!graphics) return;
+    reinterpret_cast<GraphicsDevice*>(graphics)->SubmitBox(ToXMFloat3(position), ToXMFloat3(size), ToXMFloat4(color));
+}
+
+void nexus_graphics_draw_sphere(NexusGraphics* graphics, NexusVector3 position, float radius, NexusColor color) {
+    if (!graphics) return;
+    reinterpret_cast<GraphicsDevice*>(graphics)->SubmitSphere(ToXMFloat3(position), radius, ToXMFloat4(color));
+}
+
+void nexus_graphics_draw_cubes_instanced(NexusGraphics* graphics, const NexusVector3* positions,
+                                         const NexusVector3* sizes, const NexusColor* colors, size_t count) {
+    if (!graphics || !positions || count == 0) return;
+    try {
+        reinterpret_cast<GraphicsDevice*>(graphics)->SubmitBoxes(
+            reinterpret_cast<const XMFLOAT3*>(positions), reinterpret_cast<const XMFLOAT3*>(sizes),
+            reinterpret_cast<const XMFLOAT4*>(colors), count);
+    } catch (...) {
+        // Handle errors
+    }
+}
+
+void nexus_graphics_draw_spheres_instanced(NexusGraphics* graphics, const NexusVector3* positions,
+                                           const float* radii, const NexusColor* colors, size_t count) {
+    if (!graphics || !positions || count == 0) return;
+    try {
+        reinterpret_cast<GraphicsDevice*>(graphics)->SubmitSpheres(
+            reinterpret_cast<const XMFLOAT3*>(positions), radii, reinterpret_cast<const XMFLOAT4*>(colors), count);
+    } catch (...) {
+        // Handle errors
+    }
+}
+
+// 2D batch
+void nexus_graphics_draw_line(NexusGraphics* graphics, NexusVector3 start, NexusVector3 end, NexusColor color) {
+    if (!graphics) return;
+    SpriteBatcher* sprites = reinterpret_cast<GraphicsDevice*>(graphics)->GetSpriteBatcher();
+    if (!sprites) return;
+    sprites->DrawLine(XMFLOAT2(start.x, start.y), XMFLOAT2(end.x, end.y), 1.0f, ToXMFloat4(color), s_layers[graphics]);
+}
+
+void nexus_graphics_draw_text(NexusGraphics* graphics, const char* text, int x, int y, NexusColor color) {
+    if (!graphics || !text) return;
+    SpriteBatcher* sprites = reinterpret_cast<GraphicsDevice*>(graphics)->GetSpriteBatcher();
+    if (!sprites) return;
+    sprites->DrawString(text, static_cast<float>(x), static_cast<float>(y), 1.0f, ToXMFloat4(color), s_layers[graphics]);
+}
+
+void nexus_graphics_draw_sprite(NexusGraphics* graphics, const NexusSprite* sprite) {
+    nexus_graphics_draw_sprites(graphics, sprite, 1);
+}
+
+void nexus_graphics_draw_sprites(NexusGraphics* graphics, const NexusSprite* sprites, size_t count) {
+    if (!graphics || !sprites || count == 0) return;
+    SpriteBatcher* batcher = reinterpret_cast<GraphicsDevice*>(graphics)->GetSpriteBatcher();
+    if (!batcher) return;
+    try {
+        batcher->Draw(reinterpret_cast<const SpriteBatcher::Sprite*>(sprites), count);
+    } catch (...) {
+        // Handle errors
+    }
+}
+
+void nexus_graphics_set_layer(NexusGraphics* graphics, int layer) {
+    if (!graphics) return;
+    s_layers[graphics] = layer;
+}
+
+int nexus_graphics_load_texture(NexusGraphics* graphics, const char* filename) {
+    if (!graphics || !filename) return 0;
+    try {
+        return reinterpret_cast<GraphicsDevice*>(graphics)->LoadSprite(filename);
+    } catch (...) {
+        return 0;
+    }
+}
+
+// Physics API
+NexusPhysics* nexus_engine_get_physics(NexusEngine* engine) {
+    if (!engine) return nullptr;
+    return reinterpret_cast<NexusPhysics*>(reinterpret_cast<Engine*>(engine)->GetPhysics());
+}
+
+void nexus_physics_set_positions(NexusPhysics* physics, const NexusBodyId* bodies, const float* xyz, size_t count) {
+    if (!physics || !bodies || !xyz) return;
+    reinterpret_cast<PhysicsEngine*>(physics)->SetBodyPositions(
+        reinterpret_cast<const RigidBodyID*>(bodies), reinterpret_cast<const PhysicsVector3*>(xyz), count);
+}
+
+void nexus_physics_get_positions(NexusPhysics* physics, const NexusBodyId* bodies, float* xyz, size_t count) {
+    if (!physics || !bodies || !xyz) return;
+    reinterpret_cast<PhysicsEngine*>(physics)->GetBodyPositions(
+        reinterpret_cast<const RigidBodyID*>(bodies), reinterpret_cast<PhysicsVector3*>(xyz), count);
+}
+
+void nexus_physics_set_velocities(NexusPhysics* physics, const NexusBodyId* bodies, const float* xyz, size_t count) {
+    if (!physics || !bodies || !xyz) return;
+    reinterpret_cast<PhysicsEngine*>(physics)->SetBodyVelocities(
+        reinterpret_cast<const RigidBodyID*>(bodies), reinterpret_cast<const PhysicsVector3*>(xyz), count);
+}
+
+void nexus_physics_apply_impulses(NexusPhysics* physics, const NexusBodyId* bodies, const float* xyz, size_t count) {
+    if (!physics || !bodies || !xyz) return;
+    reinterpret_cast<PhysicsEngine*>(physics)->ApplyImpulses(
+        reinterpret_cast<const RigidBodyID*>(bodies), reinterpret_cast<const PhysicsVector3*>(xyz), count);
+}
+
+NexusCharacterId nexus_physics_create_character(NexusPhysics* physics, NexusVector3 position, float radius, float height,
+                                                float stepHeight, float maxSlope) {
+    if (!physics) return 0;
+    PhysicsEngine::CharacterSettings settings;
+    settings.radius = radius;
+    settings.height = height;
+    settings.stepHeight = stepHeight;
+    settings.maxSlope = maxSlope;
+    return reinterpret_cast<PhysicsEngine*>(physics)->CreateCharacter(
+        settings, PhysicsVector3(position.x, position.y, position.z));
+}
+
+void nexus_physics_destroy_character(NexusPhysics* physics, NexusCharacterId character) {
+    if (!physics) return;
+    reinterpret_cast<PhysicsEngine*>(physics)->DestroyCharacter(character);
+}
+
+void nexus_physics_move_characters(NexusPhysics* physics, const NexusCharacterId* characters, const float* xyz,
+                                   size_t count, float deltaTime) {
+    if (!physics || !characters || !xyz) return;
+    reinterpret_cast<PhysicsEngine*>(physics)->MoveCharacters(
+        characters, reinterpret_cast<const PhysicsVector3*>(xyz), count, deltaTime);
+}
+
+int nexus_physics_get_character(NexusPhysics* physics, NexusCharacterId character, NexusCharacterState* state) {
+    if (!physics || !state) return 0;
+    PhysicsEngine::CharacterState characterState;
+    if (!reinterpret_cast<PhysicsEngine*>(physics)->GetCharacterState(character, characterState)) return 0;
+    state->position = { characterState.position.x, characterState.position.y, characterState.position.z };
+    state->velocity = { characterState.velocity.x, characterState.velocity.y, characterState.velocity.z };
+    state->groundNormal = { characterState.groundNormal.x, characterState.groundNormal.y, characterState.groundNormal.z };
+    state->grounded = characterState.grounded ? 1 : 0;
+    return 1;
+}
+
+// Mapped transforms
+size_t nexus_world_map_transforms(NexusEngine* engine, NexusTransformChunk* chunks, size_t capacity) {
+    if (!engine) return 0;
+    World* world = reinterpret_cast<Engine*>(engine)->GetWorld();
+    if (!world) return 0;
+    
+    size_t total = 0;
+    world->ForEachChunk<TransformComponent>([&](size_t count, const Entity* entities, TransformComponent* transforms) {
+        if (chunks && total < capacity) {
+            chunks[total].entities = reinterpret_cast<const NexusEntity*>(entities);
+            chunks[total].transforms = reinterpret_cast<NexusTransform*>(transforms);
+            chunks[total].count = count;
+        }
+        total++;
+    });
+    return total;
+}
+
 // Callbacks
 void nexus_engine_set_update_callback(NexusEngine* engine, NexusUpdateCallback callback, void* userData) {
     if (!engine) return;
@@ -277,4 +514,48 @@ NexusVector3 nexus_vector3_normalize(NexusVector3 v) {
     return {0, 0, 0};
 }
 
+void nexus_math_transform_points(const NexusMatrix4* matrix, const NexusVector3* points, NexusVector3* output, size_t count) {
+    if (!matrix || !points || !output) return;
+    BatchMath::TransformPoints(*reinterpret_cast<const XMFLOAT4X4*>(matrix), reinterpret_cast<const XMFLOAT3*>(points),
+                               reinterpret_cast<XMFLOAT3*>(output), count);
+}
+
+void nexus_math_normalize_vectors(const NexusVector3* vectors, NexusVector3* output, size_t count) {
+    if (!vectors || !output) return;
+    BatchMath::NormalizeVectors(reinterpret_cast<const XMFLOAT3*>(vectors), reinterpret_cast<XMFLOAT3*>(output), count);
+}
+
+void nexus_math_slerp_quaternions(const NexusVector4* from, const NexusVector4* to, const float* t,
+                                  NexusVector4* output, size_t count) {
+    if (!from || !to || !t || !output) return;
+    BatchMath::SlerpQuaternions(reinterpret_cast<const XMFLOAT4*>(from), reinterpret_cast<const XMFLOAT4*>(to), t,
+                                reinterpret_cast<XMFLOAT4*>(output), count);
+}
+
+void nexus_math_slerp_quaternions_uniform(const NexusVector4* from, const NexusVector4* to, float t,
+                                          NexusVector4* output, size_t count) {
+    if (!from || !to || !output) return;
+    BatchMath::SlerpQuaternions(reinterpret_cast<const XMFLOAT4*>(from), reinterpret_cast<const XMFLOAT4*>(to), t,
+                                reinterpret_cast<XMFLOAT4*>(output), count);
+}
+
+NexusFrustum nexus_math_frustum_from_view_projection(NexusMatrix4 viewProjection) {
+    const Frustum frustum = Frustum::FromViewProjection(XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(&viewProjection)));
+    NexusFrustum result;
+    for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        result.planes[p] = { frustum.planes[p].x, frustum.planes[p].y, frustum.planes[p].z, frustum.planes[p].w };
+    }
+    return result;
+}
+
+size_t nexus_math_cull_boxes(const NexusFrustum* frustum, const NexusAABB* boxes, size_t count, uint8_t* visible) {
+    if (!frustum || !boxes || !visible) return 0;
+    return BatchMath::CullBoxes(*reinterpret_cast<const Frustum*>(frustum), reinterpret_cast<const AABB*>(boxes),
+                                count, visible);
+}
+
+const char* nexus_math_get_instruction_set(void) {
+    return BatchMath::GetInstructionSetName(BatchMath::GetInstructionSet());
+}
+
 } // extern "C"
\ No newline at end of file
@@ -0,0 +1,302 @@
+#include "AudioSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+namespace {
+constexpr float TWO_PI = 6.28318531f;
+
+// Freeverb's tunings at 44.1kHz, scaled to the effect's rate
+constexpr size_t COMB_TUNING[AudioSystem::ReverbEffect::COMB_COUNT] = { 1116, 1188, 1277, 1356 };
+constexpr size_t ALLPASS_TUNING[AudioSystem::ReverbEffect::ALLPASS_COUNT] = { 556, 441 };
+constexpr float REVERB_INPUT_GAIN = 0.015f;
+constexpr float REVERB_WET_SCALE = 3.0f;
+constexpr float ALLPASS_FEEDBACK = 0.5f;
+
+// The first count floats of p, the rest of the register zero
+__m128 LoadChannels(const float* p, int count) {
+    switch (count) {
+    case 1: return _mm_load_ss(p);
+    case 2: return _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p));
+    case 3: return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p)), _mm_load_ss(p + 2));
+    default: return _mm_loadu_ps(p);
+    }
+}
+
+void StoreChannels(float* p, __m128 v, int count) {
+    switch (count) {
+    case 1: _mm_store_ss(p, v); break;
+    case 2: _mm_storel_pi(reinterpret_cast<__m64*>(p), v); break;
+    case 3:
+        _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+        _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+        break;
+    default: _mm_storeu_ps(p, v); break;
+    }
+}
+
+float HorizontalMax(__m128 v) {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+int GetStride(int channels) {
+    return (channels + 3) & ~3;
+}
+
+// One-pole lowpass coefficient for a cutoff
+float OnePole(float frequency, int sampleRate) {
+    float nyquist = sampleRate * 0.5f;
+    return 1.0f - std::exp(-TWO_PI * std::clamp(frequency, 1.0f, nyquist) / sampleRate);
+}
+
+// Per-sample coefficient of an envelope reaching 63% of a step in seconds
+float EnvelopeCoefficient(float seconds, int sampleRate) {
+    return seconds > 0.0f ? 1.0f - std::exp(-1.0f / (seconds * sampleRate)) : 1.0f;
+}
+
+bool IsValid(const float* samples, int sampleCount, int channels) {
+    return samples && sampleCount > 0 && channels > 0 && channels <= AudioSystem::MAX_EFFECT_CHANNELS;
+}
+}
+
+void AudioSystem::ReverbEffect::Prepare(int rate, int channels) {
+    preparedRate = rate;
+    preparedChannels = channels;
+    stride = GetStride(channels);
+
+    size_t frames = 0;
+    for (int line = 0; line < LINE_COUNT; ++line) {
+        size_t tuning = line < COMB_COUNT ? COMB_TUNING[line] : ALLPASS_TUNING[line - COMB_COUNT];
+        lineStart[line] = frames;
+        lineLength[line] = std::max<size_t>(1, tuning * rate / 44100);
+        linePosition[line] = 0;
+        frames += lineLength[line];
+    }
+    delayBuffer.assign(frames * stride, 0.0f);
+    combStates.assign(size_t(COMB_COUNT) * stride, 0.0f);
+}
+
+void AudioSystem::ReverbEffect::Apply(float* samples, int sampleCount, int channels) {
+    if (!IsValid(samples, sampleCount, channels)) return;
+    // Allocates, so callers on the audio thread should run it once up front
+    if (preparedRate != sampleRate || preparedChannels != channels) Prepare(sampleRate, channels);
+    if (!primed) {
+        currentWet = wetLevel;
+        currentDry = dryLevel;
+        primed = true;
+    }
+
+    const float feedback = std::clamp(roomSize, 0.0f, 1.0f) * 0.28f + 0.7f;
+    const float damp = std::clamp(damping, 0.0f, 1.0f) * 0.4f;
+    const __m128 feedbackV = _mm_set1_ps(feedback);
+    const __m128 dampV = _mm_set1_ps(damp);
+    const __m128 undampV = _mm_set1_ps(1.0f - damp);
+    const __m128 inputGainV = _mm_set1_ps(REVERB_INPUT_GAIN);
+    const __m128 allpassV = _mm_set1_ps(ALLPASS_FEEDBACK);
+
+    // Wet and dry ramp across the block
+    const float wetStep = (wetLevel - currentWet) / sampleCount;
+    const float dryStep = (dryLevel - currentDry) / sampleCount;
+    float wet = currentWet;
+    float dry = currentDry;
+
+    const int groups = stride / 4;
+    float* lines[LINE_COUNT];
+    for (int line = 0; line < LINE_COUNT; ++line) lines[line] = delayBuffer.data() + lineStart[line] * stride;
+
+    for (int frame = 0; frame < sampleCount; ++frame) {
+        float* frameSamples = samples + size_t(frame) * channels;
+        const __m128 wetV = _mm_set1_ps(wet * REVERB_WET_SCALE);
+        const __m128 dryV = _mm_set1_ps(dry);
+
+        for (int group = 0; group < groups; ++group) {
+            const int offset = group * 4;
+            const int count = std::min(4, channels - offset);
+            const __m128 x = LoadChannels(frameSamples + offset, count);
+            const __m128 input = _mm_mul_ps(x, inputGainV);
+
+            __m128 accumulated = _mm_setzero_ps();
+            for (int comb = 0; comb < COMB_COUNT; ++comb) {
+                float* tap = lines[comb] + linePosition[comb] * stride + offset;
+                float* state = combStates.data() + comb * stride + offset;
+                __m128 delayed = _mm_loadu_ps(tap);
+                __m128 filtered = _mm_add_ps(_mm_mul_ps(delayed, undampV), _mm_mul_ps(_mm_loadu_ps(state), dampV));
+                _mm_storeu_ps(state, filtered);
+                _mm_storeu_ps(tap, _mm_add_ps(input, _mm_mul_ps(filtered, feedbackV)));
+                accumulated = _mm_add_ps(accumulated, delayed);
+            }
+            for (int line = COMB_COUNT; line < LINE_COUNT; ++line) {
+                float* tap = lines[line] + linePosition[line] * stride + offset;
+                __m128 delayed = _mm_loadu_ps(tap);
+                _mm_storeu_ps(tap, _mm_add_ps(accumulated, _mm_mul_ps(delayed, allpassV)));
+                accumulated = _mm_sub_ps(delayed, accumulated);
+            }
+
+            StoreChannels(frameSamples + offset, _mm_add_ps(_mm_mul_ps(x, dryV), _mm_mul_ps(accumulated, wetV)), count);
+        }
+
+        for (int line = 0; line < LINE_COUNT; ++line) {
+            if (++linePosition[line] == lineLength[line]) linePosition[line] = 0;
+        }
+        wet += wetStep;
+        dry += dryStep;
+    }
+    currentWet = wetLevel;
+    currentDry = dryLevel;
+}
+
+void AudioSystem::ReverbEffect::SetParameter(const std::string& name, float value) {
+    parameters[name] = value;
+    if (name == "roomSize") roomSize = value;
+    else if (name == "damping") damping = value;
+    else if (name == "wetLevel") wetLevel = value;
+    else if (name == "dryLevel") dryLevel = value;
+}
+
+float AudioSystem::ReverbEffect::GetParameter(const std::string& name) const {
+    if (name == "roomSize") return roomSize;
+    if (name == "damping") return damping;
+    if (name == "wetLevel") return wetLevel;
+    if (name == "dryLevel") return dryLevel;
+    auto it = parameters.find(name);
+    return (it != parameters.end()) ? it->second : 0.0f;
+}
+
+void AudioSystem::EQEffect::Apply(float* samples, int sampleCount, int channels) {
+    if (!IsValid(samples, sampleCount, channels)) return;
+    if (stride != GetStride(channels)) {
+        stride = GetStride(channels);
+        filterStates.assign(size_t(stride) * 2, 0.0f);
+    }
+
+    const float targets[3] = { lowGain, midGain, highGain };
+    if (!primed) {
+        std::copy(targets, targets + 3, currentGains);
+        primed = true;
+    }
+
+    const __m128 lowCoefficient = _mm_set1_ps(OnePole(lowFrequency, sampleRate));
+    const __m128 highCoefficient = _mm_set1_ps(OnePole(highFrequency, sampleRate));
+    const float invCount = 1.0f / sampleCount;
+    __m128 gains[3], steps[3];
+    for (int band = 0; band < 3; ++band) {
+        gains[band] = _mm_set1_ps(currentGains[band]);
+        steps[band] = _mm_set1_ps((targets[band] - currentGains[band]) * invCount);
+    }
+
+    const int groups = stride / 4;
+    float* lowStates = filterStates.data();
+    float* highStates = filterStates.data() + stride;
+
+    for (int frame = 0; frame < sampleCount; ++frame) {
+        float* frameSamples = samples + size_t(frame) * channels;
+        for (int group = 0; group < groups; ++group) {
+            const int offset = group * 4;
+            const int count = std::min(4, channels - offset);
+            const __m128 x = LoadChannels(frameSamples + offset, count);
+
+            __m128 low = _mm_loadu_ps(lowStates + offset);
+            __m128 belowHigh = _mm_loadu_ps(highStates + offset);
+            low = _mm_add_ps(low, _mm_mul_ps(_mm_sub_ps(x, low), lowCoefficient));
+            belowHigh = _mm_add_ps(belowHigh, _mm_mul_ps(_mm_sub_ps(x, belowHigh), highCoefficient));
+            _mm_storeu_ps(lowStates + offset, low);
+            _mm_storeu_ps(highStates + offset, belowHigh);
+
+            __m128 mid = _mm_sub_ps(belowHigh, low);
+            __m128 high = _mm_sub_ps(x, belowHigh);
+            __m128 y = _mm_add_ps(_mm_mul_ps(low, gains[0]),
+                                  _mm_add_ps(_mm_mul_ps(mid, gains[1]), _mm_mul_ps(high, gains[2])));
+            StoreChannels(frameSamples + offset, y, count);
+        }
+        for (int band = 0; band < 3; ++band) gains[band] = _mm_add_ps(gains[band], steps[band]);
+    }
+    std::copy(targets, targets + 3, currentGains);
+}
+
+void AudioSystem::EQEffect::SetParameter(const std::string& name, float value) {
+    parameters[name] = value;
+    if (name == "lowGain") lowGain = value;
+    else if (name == "midGain") midGain = value;
+    else if (name == "highGain") highGain = value;
+    else if (name == "lowFreq") lowFrequency = value;
+    else if (name == "highFreq") highFrequency = value;
+}
+
+float AudioSystem::EQEffect::GetParameter(const std::string& name) const {
+    if (name == "lowGain") return lowGain;
+    if (name == "midGain") return midGain;
+    if (name == "highGain") return highGain;
+    if (name == "lowFreq") return lowFrequency;
+    if (name == "highFreq") return highFrequency;
+    auto it = parameters.find(name);
+    return (it != parameters.end()) ? it->second : 0.0f;
+}
+
+void AudioSystem::CompressorEffect::Apply(float* samples, int sampleCount, int channels) {
+    if (!IsValid(samples, sampleCount, channels)) return;
+    if (!primed) {
+        currentMakeup = makeupGain;
+        primed = true;
+    }
+
+    const float attackCoefficient = EnvelopeCoefficient(attack, sampleRate);
+    const float releaseCoefficient = EnvelopeCoefficient(release, sampleRate);
+    const float slope = ratio > 1.0f ? 1.0f / ratio : 1.0f;
+    const float makeupStep = (makeupGain - currentMakeup) / sampleCount;
+    float makeup = currentMakeup;
+
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const int groups = GetStride(channels) / 4;
+
+    for (int frame = 0; frame < sampleCount; ++frame) {
+        float* frameSamples = samples + size_t(frame) * channels;
+
+        // Loudest channel of the frame drives the envelope
+        __m128 peak = _mm_setzero_ps();
+        for (int group = 0; group < groups; ++group) {
+            const int offset = group * 4;
+            __m128 x = LoadChannels(frameSamples + offset, std::min(4, channels - offset));
+            peak = _mm_max_ps(peak, _mm_andnot_ps(signMask, x));
+        }
+        float level = HorizontalMax(peak);
+        envelope += (level - envelope) * (level > envelope ? attackCoefficient : releaseCoefficient);
+
+        float gain = makeup;
+        if (envelope > threshold) {
+            gain *= (threshold + (envelope - threshold) * slope) / envelope;
+        }
+        const __m128 gainV = _mm_set1_ps(gain);
+        for (int group = 0; group < groups; ++group) {
+            const int offset = group * 4;
+            const int count = std::min(4, channels - offset);
+            StoreChannels(frameSamples + offset, _mm_mul_ps(LoadChannels(frameSamples + offset, count), gainV), count);
+        }
+        makeup += makeupStep;
+    }
+    currentMakeup = makeupGain;
+}
+
+void AudioSystem::CompressorEffect::SetParameter(const std::string& name, float value) {
+    parameters[name] = value;
+    if (name == "threshold") threshold = value;
+    else if (name == "ratio") ratio = value;
+    else if (name == "attack") attack = value;
+    else if (name == "release") release = value;
+    else if (name == "makeupGain") makeupGain = value;
+}
+
+float AudioSystem::CompressorEffect::GetParameter(const std::string& name) const {
+    if (name == "threshold") return threshold;
+    if (name == "ratio") return ratio;
+    if (name == "attack") return attack;
+    if (name == "release") return release;
+    if (name == "makeupGain") return makeupGain;
+    auto it = parameters.find(name);
+    return (it != parameters.end()) ? it->second : 0.0f;
+}
+
+} // namespace Nexus
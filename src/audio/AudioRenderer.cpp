@@ -0,0 +1,901 @@
+#include "AudioRenderer.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+namespace {
+constexpr float SPEED_OF_SOUND = 343.0f;
+constexpr float QUARTER_PI = 0.78539816f;
+constexpr float TWO_PI = 6.28318531f;
+// Cutoffs past this fraction of the sample rate leave the voice unfiltered
+constexpr float MAX_LOW_PASS = 0.45f;
+// Slowest a voice plays, so a zero pitch still moves and a block's span stays bounded
+constexpr double MIN_RATE = 1.0 / 64.0;
+
+struct DecodePCM8 {
+    static float Read(const uint8_t* data, size_t sample) { return (static_cast<int>(data[sample]) - 128) * (1.0f / 128.0f); }
+};
+
+struct DecodePCM16 {
+    static float Read(const uint8_t* data, size_t sample) {
+        int16_t value;
+        std::memcpy(&value, data + sample * 2, sizeof(value));
+        return value * (1.0f / 32768.0f);
+    }
+};
+
+struct DecodePCM24 {
+    static float Read(const uint8_t* data, size_t sample) {
+        const uint8_t* bytes = data + sample * 3;
+        int32_t value = static_cast<int32_t>((uint32_t(bytes[0]) << 8) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 24)) >> 8;
+        return value * (1.0f / 8388608.0f);
+    }
+};
+
+struct DecodePCM32 {
+    static float Read(const uint8_t* data, size_t sample) {
+        int32_t value;
+        std::memcpy(&value, data + sample * 4, sizeof(value));
+        return value * (1.0f / 2147483648.0f);
+    }
+};
+
+struct DecodeFloat {
+    static float Read(const uint8_t* data, size_t sample) {
+        float value;
+        std::memcpy(&value, data + sample * 4, sizeof(value));
+        return value;
+    }
+};
+
+// Decodes span frames of clip starting at first into planar left and right, right only for
+// stereo. Frames outside the clip wrap when looping and are silent otherwise, so the resampler's
+// taps see the loop seam or the clip's ends as they should sound
+template <typename Decode>
+void GatherClip(const AudioClip& clip, int64_t first, uint32_t span, bool looping, float* left, float* right) {
+    const int64_t length = clip.frameCount;
+    const uint32_t channels = clip.channels;
+    for (uint32_t i = 0; i < span; ++i) {
+        int64_t frame = first + i;
+        if (looping) {
+            frame %= length;
+            if (frame < 0) frame += length;
+        } else if (frame < 0 || frame >= length) {
+            left[i] = 0.0f;
+            if (right) right[i] = 0.0f;
+            continue;
+        }
+        size_t sample = size_t(frame) * channels;
+        left[i] = Decode::Read(clip.data, sample);
+        if (right) right[i] = Decode::Read(clip.data, sample + 1);
+    }
+}
+
+// GatherClip for a streaming voice, whose frames count from when the stream started. The caller
+// has checked the decoder has written every frame before end the span covers
+void GatherStream(const AudioStreamBuffer& stream, int64_t first, uint32_t span, uint64_t end, float* left,
+                  float* right) {
+    const uint32_t channels = stream.channels;
+    const uint64_t mask = stream.capacity - 1;
+    const float* samples = stream.samples.get();
+    for (uint32_t i = 0; i < span; ++i) {
+        int64_t frame = first + i;
+        if (frame < 0 || uint64_t(frame) >= end) {
+            left[i] = 0.0f;
+            if (right) right[i] = 0.0f;
+            continue;
+        }
+        const float* at = samples + (uint64_t(frame) & mask) * channels;
+        left[i] = at[0];
+        if (right) right[i] = at[1];
+    }
+}
+
+// Adds frameCount resampled frames into stereo output and, when send is set, mono into send,
+// ramping each gain from gains by steps per frame. right is null for a mono voice
+void MixFrames(const float* left, const float* right, float* output, float* send, uint32_t frameCount,
+               const float gains[3], const float steps[3]) {
+    if (!right) right = left;
+    uint32_t frame = 0;
+    if (frameCount >= 4) {
+        const __m128 ramp = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        __m128 gainL = _mm_add_ps(_mm_set1_ps(gains[0]), _mm_mul_ps(ramp, _mm_set1_ps(steps[0])));
+        __m128 gainR = _mm_add_ps(_mm_set1_ps(gains[1]), _mm_mul_ps(ramp, _mm_set1_ps(steps[1])));
+        __m128 gainSend = _mm_add_ps(_mm_set1_ps(gains[2] * 0.5f), _mm_mul_ps(ramp, _mm_set1_ps(steps[2] * 0.5f)));
+        const __m128 stepL = _mm_set1_ps(steps[0] * 4.0f);
+        const __m128 stepR = _mm_set1_ps(steps[1] * 4.0f);
+        const __m128 stepSend = _mm_set1_ps(steps[2] * 2.0f);
+        for (; frame + 4 <= frameCount; frame += 4) {
+            __m128 l = _mm_loadu_ps(left + frame);
+            __m128 r = _mm_loadu_ps(right + frame);
+            __m128 outL = _mm_mul_ps(l, gainL);
+            __m128 outR = _mm_mul_ps(r, gainR);
+            float* out = output + frame * 2;
+            _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_unpacklo_ps(outL, outR)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(outL, outR)));
+            if (send) {
+                __m128 mono = _mm_mul_ps(_mm_add_ps(l, r), gainSend);
+                _mm_storeu_ps(send + frame, _mm_add_ps(_mm_loadu_ps(send + frame), mono));
+            }
+            gainL = _mm_add_ps(gainL, stepL);
+            gainR = _mm_add_ps(gainR, stepR);
+            gainSend = _mm_add_ps(gainSend, stepSend);
+        }
+    }
+    for (; frame < frameCount; ++frame) {
+        output[frame * 2] += left[frame] * (gains[0] + steps[0] * frame);
+        output[frame * 2 + 1] += right[frame] * (gains[1] + steps[1] * frame);
+        if (send) send[frame] += (left[frame] + right[frame]) * 0.5f * (gains[2] + steps[2] * frame);
+    }
+}
+
+// Writes frameCount resampled frames folded to mono into input, ramping gain by step per frame,
+// and silence after them to the end of the block. The send takes the same signal MixFrames's would
+void MixMono(const float* left, const float* right, float* input, float* send, uint32_t frameCount,
+             uint32_t blockFrames, float gain, float step) {
+    uint32_t frame = 0;
+    if (frameCount >= 4) {
+        const __m128 half = _mm_set1_ps(right ? 0.5f : 1.0f);
+        __m128 g = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(step)));
+        const __m128 advance = _mm_set1_ps(step * 4.0f);
+        for (; frame + 4 <= frameCount; frame += 4) {
+            __m128 mono = _mm_loadu_ps(left + frame);
+            if (right) mono = _mm_add_ps(mono, _mm_loadu_ps(right + frame));
+            mono = _mm_mul_ps(mono, _mm_mul_ps(half, g));
+            _mm_storeu_ps(input + frame, mono);
+            if (send) _mm_storeu_ps(send + frame, _mm_add_ps(_mm_loadu_ps(send + frame), mono));
+            g = _mm_add_ps(g, advance);
+        }
+    }
+    for (; frame < frameCount; ++frame) {
+        float mono = (right ? (left[frame] + right[frame]) * 0.5f : left[frame]) * (gain + step * frame);
+        input[frame] = mono;
+        if (send) send[frame] += mono;
+    }
+    std::fill(input + frameCount, input + blockFrames, 0.0f);
+}
+
+// Adds frameCount frames of stereo input into output, ramping gain by step per frame
+void AddStereo(const float* input, float* output, uint32_t frameCount, float gain, float step) {
+    uint32_t frame = 0;
+    __m128 g = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(_mm_set_ps(1.0f, 1.0f, 0.0f, 0.0f), _mm_set1_ps(step)));
+    const __m128 advance = _mm_set1_ps(step * 2.0f);
+    for (; frame + 2 <= frameCount; frame += 2) {
+        float* out = output + frame * 2;
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(_mm_loadu_ps(input + frame * 2), g)));
+        g = _mm_add_ps(g, advance);
+    }
+    for (; frame < frameCount; ++frame) {
+        output[frame * 2] += input[frame * 2] * (gain + step * frame);
+        output[frame * 2 + 1] += input[frame * 2 + 1] * (gain + step * frame);
+    }
+}
+
+template <typename Decode>
+void DecodeChannel(const AudioClip& clip, uint16_t channel, std::vector<float>& samples) {
+    samples.resize(clip.frameCount);
+    for (uint32_t f = 0; f < clip.frameCount; ++f) samples[f] = Decode::Read(clip.data, size_t(f) * clip.channels + channel);
+}
+
+void Normalize(float v[3]) {
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length > 1e-6f) {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+}
+}
+
+std::vector<float> DecodeClip(const AudioClip& clip, uint16_t channel) {
+    std::vector<float> samples;
+    if (!clip.data || channel >= clip.channels) return samples;
+    if (clip.isFloat) DecodeChannel<DecodeFloat>(clip, channel, samples);
+    else if (clip.bitsPerSample == 8) DecodeChannel<DecodePCM8>(clip, channel, samples);
+    else if (clip.bitsPerSample == 24) DecodeChannel<DecodePCM24>(clip, channel, samples);
+    else if (clip.bitsPerSample == 32) DecodeChannel<DecodePCM32>(clip, channel, samples);
+    else DecodeChannel<DecodePCM16>(clip, channel, samples);
+    return samples;
+}
+
+AudioRenderer::AudioRenderer()
+    : sampleRate_(0)
+    , channels_(0)
+    , blockRead_(BLOCK_FRAMES)
+    , reverbs_{ { FDNReverb(), nullptr, 0.0f, 0 }, { FDNReverb(), nullptr, 0.0f, 0 } }
+    , activeReverb_(0)
+    , listenerPosition_{ 0.0f, 0.0f, 0.0f }
+    , listenerVelocity_{ 0.0f, 0.0f, 0.0f }
+    , listenerForward_{ 0.0f, 0.0f, 1.0f }
+    , listenerUp_{ 0.0f, 1.0f, 0.0f }
+    , listenerRight_{ 1.0f, 0.0f, 0.0f }
+    , masterVolume_(1.0f)
+    , binaural_(false)
+    , jobs_(nullptr)
+    , usingJobs_(false)
+    , activeVoices_(0)
+    , convolutionsInFlight_(0)
+    , chainsInFlight_(0)
+    , droppedCommands_(0) {}
+
+AudioRenderer::~AudioRenderer() {
+    // Nothing renders any more, so every convolution still held anywhere can go
+    commands_.Publish();
+    AudioCommand command;
+    while (commands_.Pop(command)) {
+        if (command.type == AudioCommandType::SetConvolution) delete command.convolution;
+        if (command.type == AudioCommandType::SetBusChain) delete command.chain;
+    }
+    for (ReverbSlot& slot : reverbs_) delete slot.convolution;
+    ConvolutionReverb* convolution;
+    while (retired_.Pop(convolution)) delete convolution;
+    if (buses_) {
+        for (uint32_t b = 0; b < MAX_BUSES; ++b) delete buses_[b].chain;
+    }
+    AudioBusChain* chain;
+    while (retiredChains_.Pop(chain)) delete chain;
+}
+
+bool AudioRenderer::Initialize(int sampleRate, int channels) {
+    if (sampleRate <= 0 || channels <= 0) return false;
+
+    sampleRate_ = sampleRate;
+    channels_ = channels;
+    voices_ = std::make_unique<Voice[]>(MAX_VOICES);
+    scratch_.assign(BLOCK_FRAMES * 2, 0.0f);
+    resampler_.Prepare();
+    sourceLeft_.assign(AudioResampler::GetSpan(BLOCK_FRAMES, AudioResampler::MAX_RATE), 0.0f);
+    sourceRight_.assign(sourceLeft_.size(), 0.0f);
+    voiceLeft_.assign(BLOCK_FRAMES, 0.0f);
+    voiceRight_.assign(BLOCK_FRAMES, 0.0f);
+    block_.assign(size_t(BLOCK_FRAMES) * channels, 0.0f);
+    blockRead_ = BLOCK_FRAMES;
+    send_.assign(BLOCK_FRAMES, 0.0f);
+    silence_.assign(BLOCK_FRAMES, 0.0f);
+    convolutionInput_.assign(BLOCK_FRAMES, 0.0f);
+    // Spatial voices are panned instead if it can't be prepared
+    spatializer_.Prepare(sampleRate, BLOCK_FRAMES, MAX_VOICES);
+    for (ReverbSlot& slot : reverbs_) {
+        if (slot.convolution) {
+            delete slot.convolution;
+            convolutionsInFlight_--;
+        }
+        slot.fdn.Prepare(sampleRate);
+        slot.convolution = nullptr;
+        slot.level = 0.0f;
+        slot.ringing = 0;
+    }
+    activeReverb_ = 0;
+    if (buses_) {
+        for (uint32_t b = 0; b < MAX_BUSES; ++b) {
+            if (buses_[b].chain) {
+                delete buses_[b].chain;
+                chainsInFlight_--;
+            }
+        }
+    }
+    buses_ = std::make_unique<Bus[]>(MAX_BUSES);
+    busBlocks_.assign(size_t(MAX_BUSES) * BLOCK_FRAMES * 2, 0.0f);
+    for (uint32_t b = 0; b < MAX_BUSES; ++b) {
+        buses_[b] = { MASTER_BUS, 1.0f, 1.0f, nullptr, 0, b == MASTER_BUS, false, busBlocks_.data() + size_t(b) * BLOCK_FRAMES * 2 };
+    }
+    busOrder_.clear();
+    busOrder_.reserve(MAX_BUSES);
+    busLevel_.reserve(MAX_BUSES);
+    peaks_ = std::make_unique<std::atomic<float>[]>(channels);
+    for (int c = 0; c < channels; ++c) peaks_[c].store(0.0f, std::memory_order_relaxed);
+    return true;
+}
+
+bool AudioRenderer::Submit(const AudioCommand& command) {
+    if (commands_.Stage(command)) return true;
+    droppedCommands_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool AudioRenderer::SubmitConvolution(std::unique_ptr<ConvolutionReverb> convolution) {
+    // Capping what's in flight means the retired ring can always take one back
+    if (!convolution || convolution->GetBlockFrames() != BLOCK_FRAMES ||
+        convolutionsInFlight_ >= CONVOLUTION_CAPACITY) {
+        return false;
+    }
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetConvolution;
+    command.convolution = convolution.get();
+    if (!Submit(command)) return false;
+    convolution.release();
+    convolutionsInFlight_++;
+    return true;
+}
+
+void AudioRenderer::CollectConvolutions() {
+    ConvolutionReverb* convolution;
+    while (retired_.Pop(convolution)) {
+        delete convolution;
+        convolutionsInFlight_--;
+    }
+}
+
+bool AudioRenderer::SubmitBusChain(uint32_t bus, std::unique_ptr<AudioBusChain> chain) {
+    // Chains held by buses count too, so the retired ring can always take one back
+    if (bus >= MAX_BUSES || (chain && chainsInFlight_ >= BUS_CHAIN_CAPACITY)) return false;
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetBusChain;
+    command.voice = bus;
+    command.chain = chain.get();
+    if (!Submit(command)) return false;
+    if (chain.release()) chainsInFlight_++;
+    return true;
+}
+
+void AudioRenderer::CollectBusChains() {
+    AudioBusChain* chain;
+    while (retiredChains_.Pop(chain)) {
+        delete chain;
+        chainsInFlight_--;
+    }
+}
+
+void AudioRenderer::SetJobSystem(JobSystem* jobs) {
+    // Sequentially consistent on both sides: either the audio thread sees the new pointer, or
+    // this sees it still using the old one and waits out the block
+    jobs_.store(jobs);
+    while (usingJobs_.load()) std::this_thread::yield();
+}
+
+void AudioRenderer::Render(float* output, uint32_t frameCount) {
+    if (!voices_) {
+        std::fill(output, output + size_t(frameCount) * std::max(channels_, 1), 0.0f);
+        return;
+    }
+
+    for (uint32_t offset = 0; offset < frameCount;) {
+        if (blockRead_ == BLOCK_FRAMES) {
+            AudioCommand command;
+            while (commands_.Pop(command)) Apply(command);
+            RenderBlock(block_.data());
+            blockRead_ = 0;
+        }
+        uint32_t frames = std::min(BLOCK_FRAMES - blockRead_, frameCount - offset);
+        std::copy_n(block_.data() + size_t(blockRead_) * channels_, size_t(frames) * channels_,
+                    output + size_t(offset) * channels_);
+        blockRead_ += frames;
+        offset += frames;
+    }
+
+    uint32_t active = 0;
+    for (uint32_t v = 0; v < MAX_VOICES; ++v) {
+        Voice& voice = voices_[v];
+        if (voice.donePending) {
+            AudioVoiceEvent event{ v, voice.generation, voice.finished };
+            voice.donePending = !events_.Push(event);
+        }
+        if (voice.active) active++;
+    }
+    activeVoices_.store(active, std::memory_order_relaxed);
+
+    for (int c = 0; c < channels_; ++c) {
+        float peak = 0.0f;
+        for (uint32_t f = 0; f < frameCount; ++f) peak = std::max(peak, std::abs(output[size_t(f) * channels_ + c]));
+        peaks_[c].store(peak, std::memory_order_relaxed);
+    }
+}
+
+void AudioRenderer::Apply(const AudioCommand& command) {
+    switch (command.type) {
+    case AudioCommandType::SetListenerPosition:
+        std::copy(command.values, command.values + 3, listenerPosition_);
+        return;
+    case AudioCommandType::SetListenerVelocity:
+        std::copy(command.values, command.values + 3, listenerVelocity_);
+        return;
+    case AudioCommandType::SetListenerOrientation: {
+        // Left-handed, so right is up x forward, and up is recovered square to both
+        const float* f = command.values;
+        const float* u = command.values + 3;
+        listenerRight_[0] = u[1] * f[2] - u[2] * f[1];
+        listenerRight_[1] = u[2] * f[0] - u[0] * f[2];
+        listenerRight_[2] = u[0] * f[1] - u[1] * f[0];
+        Normalize(listenerRight_);
+        std::copy(f, f + 3, listenerForward_);
+        Normalize(listenerForward_);
+        const float* r = listenerRight_;
+        listenerUp_[0] = f[1] * r[2] - f[2] * r[1];
+        listenerUp_[1] = f[2] * r[0] - f[0] * r[2];
+        listenerUp_[2] = f[0] * r[1] - f[1] * r[0];
+        Normalize(listenerUp_);
+        return;
+    }
+    case AudioCommandType::SetMasterVolume:
+        masterVolume_ = command.values[0];
+        return;
+    case AudioCommandType::SetReverb: {
+        ReverbSettings settings;
+        settings.decayTime = command.values[0];
+        settings.decayHFRatio = command.values[1];
+        settings.preDelay = command.values[2];
+        settings.roomSize = command.values[3];
+        settings.diffusion = command.values[4];
+        settings.level = command.values[5];
+        SetReverb(settings);
+        return;
+    }
+    case AudioCommandType::SetConvolution: {
+        ReverbSlot& slot = reverbs_[activeReverb_];
+        Retire(slot);
+        slot.convolution = command.convolution;
+        return;
+    }
+    case AudioCommandType::SetSpatializer:
+        binaural_ = command.values[0] != 0.0f;
+        spatializer_.SetNearVoiceLimit(static_cast<uint32_t>(std::max(command.values[1], 0.0f)));
+        return;
+    case AudioCommandType::SetBus:
+        SetBus(command.voice, std::max(command.values[0], 0.0f), static_cast<uint32_t>(std::max(command.values[1], 0.0f)),
+               command.values[2] != 0.0f);
+        return;
+    case AudioCommandType::SetBusChain:
+        if (command.voice < MAX_BUSES) {
+            Bus& bus = buses_[command.voice];
+            if (bus.chain) retiredChains_.Push(bus.chain);
+            bus.chain = command.chain;
+        } else if (command.chain) {
+            retiredChains_.Push(command.chain);
+        }
+        return;
+    default:
+        break;
+    }
+
+    if (command.voice >= MAX_VOICES) return;
+    Voice& voice = voices_[command.voice];
+
+    switch (command.type) {
+    case AudioCommandType::Play:
+    case AudioCommandType::PlaySynth:
+        voice = Voice{};
+        if (command.type == AudioCommandType::PlaySynth) {
+            // Mono at the output rate, so the clip's fields give the pan law and a rate of the pitch
+            voice.synthesized = true;
+            voice.synth.Start(command.synth, command.voice * MAX_VOICES + command.generation);
+            voice.clip.sampleRate = static_cast<uint32_t>(sampleRate_);
+            voice.clip.channels = 1;
+        } else {
+            voice.clip = command.clip;
+        }
+        voice.generation = command.generation;
+        voice.volume = 1.0f;
+        voice.fade = 1.0f;
+        voice.fadeTarget = 1.0f;
+        voice.pitch = 1.0f;
+        voice.minDistance = 1.0f;
+        voice.maxDistance = 100.0f;
+        voice.rolloff = 1.0f;
+        voice.quality = AudioResampleQuality::Cubic;
+        voice.gain[0] = -1.0f;                 // Start at the first block's gains instead of ramping up
+        voice.active = voice.synthesized || (voice.clip.stream || (voice.clip.data && voice.clip.frameCount > 0)) && voice.clip.channels > 0;
+        if (!voice.active) Stop(voice, true);
+        spatializer_.Restart(command.voice);
+        break;
+    case AudioCommandType::Stop:
+        if (voice.active) Stop(voice, false);
+        break;
+    case AudioCommandType::Pause:
+        voice.paused = true;
+        break;
+    case AudioCommandType::Resume:
+        voice.paused = false;
+        break;
+    case AudioCommandType::Seek:
+        voice.cursor = std::max(command.values[0], 0.0f);
+        break;
+    case AudioCommandType::SetParam: {
+        float value = command.values[0];
+        switch (command.param) {
+        case AudioVoiceParam::Volume: voice.volume = value; break;
+        case AudioVoiceParam::Pitch: voice.pitch = value; break;
+        case AudioVoiceParam::Pan: voice.pan = std::clamp(value, -1.0f, 1.0f); break;
+        case AudioVoiceParam::Looping: voice.looping = value != 0.0f; break;
+        case AudioVoiceParam::Spatial: voice.spatial = value != 0.0f; break;
+        case AudioVoiceParam::MinDistance: voice.minDistance = value; break;
+        case AudioVoiceParam::MaxDistance: voice.maxDistance = value; break;
+        case AudioVoiceParam::Rolloff: voice.rolloff = value; break;
+        case AudioVoiceParam::Occlusion: voice.occlusion = std::clamp(value, 0.0f, 1.0f); break;
+        case AudioVoiceParam::LowPass: voice.lowPass = std::max(value, 0.0f); break;
+        case AudioVoiceParam::Quality:
+            voice.quality = static_cast<AudioResampleQuality>(std::clamp(static_cast<int>(value), 0, 2));
+            break;
+        case AudioVoiceParam::Bus:
+            voice.bus = value >= 0.0f && value < MAX_BUSES ? static_cast<uint32_t>(value) : MASTER_BUS;
+            break;
+        case AudioVoiceParam::Frequency: voice.synth.patch.frequency = std::max(value, 0.0f); break;
+        case AudioVoiceParam::Tone: voice.synth.patch.tone = value; break;
+        case AudioVoiceParam::Noise: voice.synth.patch.noise = value; break;
+        case AudioVoiceParam::Cutoff: voice.synth.patch.cutoff = std::max(value, 0.0f); break;
+        case AudioVoiceParam::Resonance: voice.synth.patch.resonance = std::clamp(value, 0.0f, 1.0f); break;
+        case AudioVoiceParam::ModRate: voice.synth.patch.modRate = std::max(value, 0.0f); break;
+        case AudioVoiceParam::ModDepth: voice.synth.patch.modDepth = std::max(value, 0.0f); break;
+        }
+        break;
+    }
+    case AudioCommandType::Fade: {
+        voice.fadeTarget = command.values[0];
+        float frames = command.values[1] * sampleRate_;
+        if (frames < 1.0f) {
+            voice.fade = voice.fadeTarget;
+            voice.fadeStep = 0.0f;
+        } else {
+            voice.fadeStep = (voice.fadeTarget - voice.fade) / frames;
+        }
+        break;
+    }
+    case AudioCommandType::SetPosition:
+        std::copy(command.values, command.values + 3, voice.position);
+        break;
+    case AudioCommandType::SetVelocity:
+        std::copy(command.values, command.values + 3, voice.velocity);
+        break;
+    default:
+        break;
+    }
+}
+
+void AudioRenderer::SetBus(uint32_t index, float volume, uint32_t parent, bool exists) {
+    if (index == MASTER_BUS || index >= MAX_BUSES) return;
+
+    // A parent that is gone or would close a loop leaves it on the master
+    if (parent >= MAX_BUSES || !buses_[parent].exists) parent = MASTER_BUS;
+    for (uint32_t p = parent; p != MASTER_BUS; p = buses_[p].parent) {
+        if (p == index) {
+            parent = MASTER_BUS;
+            break;
+        }
+    }
+
+    Bus& bus = buses_[index];
+    if (exists && !bus.exists) {
+        std::fill(bus.block, bus.block + BLOCK_FRAMES * 2, 0.0f);
+        bus.gain = volume;
+    }
+    bus.volume = volume;
+    bus.parent = parent;
+    bus.exists = exists;
+    if (!exists) {
+        for (uint32_t b = 0; b < MAX_BUSES; ++b) {
+            if (buses_[b].parent == index) buses_[b].parent = MASTER_BUS;
+        }
+    }
+
+    busOrder_.clear();
+    for (uint32_t b = 0; b < MAX_BUSES; ++b) {
+        if (b == MASTER_BUS || !buses_[b].exists) continue;
+        uint32_t depth = 1;
+        for (uint32_t p = buses_[b].parent; p != MASTER_BUS; p = buses_[p].parent) depth++;
+        buses_[b].depth = depth;
+        busOrder_.push_back(b);
+    }
+    std::sort(busOrder_.begin(), busOrder_.end(),
+              [this](uint32_t a, uint32_t b) { return buses_[a].depth > buses_[b].depth; });
+}
+
+void AudioRenderer::RenderBlock(float* output) {
+    float* mix = scratch_.data();
+    float* send = send_.data();
+    std::fill(mix, mix + BLOCK_FRAMES * 2, 0.0f);
+    std::fill(send, send + BLOCK_FRAMES, 0.0f);
+    for (uint32_t b : busOrder_) {
+        Bus& bus = buses_[b];
+        if (bus.fed || bus.chain) std::fill(bus.block, bus.block + BLOCK_FRAMES * 2, 0.0f);
+        bus.fed = false;
+    }
+
+    for (uint32_t v = 0; v < MAX_VOICES; ++v) {
+        Voice& voice = voices_[v];
+        if (!voice.active || voice.paused) continue;
+        Bus& bus = buses_[voice.bus];
+        if (voice.bus == MASTER_BUS || !bus.exists) {
+            MixVoice(v, voice, mix, send);
+        } else {
+            MixVoice(v, voice, bus.block, send);
+            bus.fed = true;
+        }
+    }
+
+    // Also run while binaural is off, so slots and the bed ring out
+    usingJobs_.store(true);
+    JobSystem* jobs = jobs_.load();
+    spatializer_.Render(mix, jobs);
+
+    ProcessReverb(reverbs_[activeReverb_], true, mix);
+    ProcessReverb(reverbs_[activeReverb_ ^ 1], false, mix);
+
+    MixBuses(mix, jobs);
+    usingJobs_.store(false);
+
+    // Mono folds both sides down; beyond stereo only the front pair is fed
+    if (channels_ == 1) {
+        for (uint32_t f = 0; f < BLOCK_FRAMES; ++f) output[f] = (mix[f * 2] + mix[f * 2 + 1]) * 0.5f;
+        return;
+    }
+    for (uint32_t f = 0; f < BLOCK_FRAMES; ++f) {
+        float* frame = output + size_t(f) * channels_;
+        frame[0] = mix[f * 2];
+        frame[1] = mix[f * 2 + 1];
+        std::fill(frame + 2, frame + channels_, 0.0f);
+    }
+}
+
+void AudioRenderer::MixBuses(float* mix, JobSystem* jobs) {
+    auto process = [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Bus& bus = buses_[busLevel_[i]];
+            for (const std::shared_ptr<AudioBusEffect>& effect : bus.chain->effects) {
+                effect->Apply(bus.block, BLOCK_FRAMES, 2);
+            }
+        }
+    };
+
+    // A depth at a time from the deepest. Buses of one depth don't feed each other, and every
+    // parent is shallower, so it has all its input by the time its own depth comes round
+    for (size_t first = 0; first < busOrder_.size();) {
+        const uint32_t depth = buses_[busOrder_[first]].depth;
+        size_t end = first;
+        busLevel_.clear();
+        for (; end < busOrder_.size() && buses_[busOrder_[end]].depth == depth; ++end) {
+            const Bus& bus = buses_[busOrder_[end]];
+            bool silent = bus.volume == 0.0f && bus.gain == 0.0f;
+            if (!silent && bus.chain && !bus.chain->effects.empty()) busLevel_.push_back(busOrder_[end]);
+        }
+        if (jobs && busLevel_.size() > 1) jobs->ParallelFor(busLevel_.size(), 1, process);
+        else process(0, busLevel_.size());
+
+        for (; first < end; ++first) {
+            Bus& bus = buses_[busOrder_[first]];
+            bool silent = bus.volume == 0.0f && bus.gain == 0.0f;
+            bool written = bus.fed || (bus.chain && !bus.chain->effects.empty());
+            if (!silent && written) {
+                float* parent = mix;
+                if (bus.parent != MASTER_BUS) {
+                    parent = buses_[bus.parent].block;
+                    buses_[bus.parent].fed = true;
+                }
+                AddStereo(bus.block, parent, BLOCK_FRAMES, bus.gain, (bus.volume - bus.gain) / BLOCK_FRAMES);
+            }
+            bus.gain = bus.volume;
+        }
+    }
+
+    if (AudioBusChain* chain = buses_[MASTER_BUS].chain) {
+        for (const std::shared_ptr<AudioBusEffect>& effect : chain->effects) effect->Apply(mix, BLOCK_FRAMES, 2);
+    }
+}
+
+void AudioRenderer::MixVoice(uint32_t index, Voice& voice, float* output, float* send) {
+    const uint32_t frameCount = BLOCK_FRAMES;
+    const float fade = voice.fade;
+    const float fadeStep = voice.fadeStep;
+    if (voice.fadeStep != 0.0f) {
+        voice.fade += voice.fadeStep * frameCount;
+        if ((voice.fadeStep > 0.0f) == (voice.fade >= voice.fadeTarget)) {
+            voice.fade = voice.fadeTarget;
+            voice.fadeStep = 0.0f;
+        }
+    }
+
+    float target[3];
+    double rate;
+    float direction[3];
+    TargetGains(voice, target, rate, direction);
+
+    const AudioClip& clip = voice.clip;
+    AudioStreamBuffer* stream = clip.stream;
+    float* resampledLeft = voiceLeft_.data();
+    float* resampledRight = nullptr;
+    // Frames this block plays before the source runs out; all of them unless it ends
+    uint32_t mixed = frameCount;
+    if (voice.synthesized) {
+        mixed = voice.synth.Render(resampledLeft, frameCount, voice.cursor, static_cast<float>(rate),
+                                   static_cast<float>(sampleRate_));
+    } else {
+        // The source frames this block's taps reach, from a little before the cursor to a little
+        // past where it ends up
+        const int64_t first = static_cast<int64_t>(std::floor(voice.cursor)) - (AudioResampler::HALF_TAPS - 1);
+        const int64_t last = static_cast<int64_t>(std::floor(voice.cursor + rate * (frameCount - 1))) +
+                             AudioResampler::HALF_TAPS;
+        const uint32_t span = static_cast<uint32_t>(last - first + 1);
+        float* left = sourceLeft_.data();
+        float* right = clip.channels > 1 ? sourceRight_.data() : nullptr;
+
+        if (stream) {
+            uint64_t written = stream->written.load(std::memory_order_acquire);
+            uint64_t end = stream->end.load(std::memory_order_acquire);
+            if (uint64_t(std::max<int64_t>(last, 0)) >= written && written < end) {
+                // Starved: hold everything, fades included, until the decoder catches up
+                voice.fade = fade;
+                voice.fadeStep = fadeStep;
+                return;
+            }
+            GatherStream(*stream, first, span, end, left, right);
+            if (voice.cursor + rate * (frameCount - 1) >= double(end)) {
+                mixed = static_cast<uint32_t>(std::max(std::ceil((double(end) - voice.cursor) / rate), 0.0));
+            }
+        } else {
+            if (clip.isFloat) GatherClip<DecodeFloat>(clip, first, span, voice.looping, left, right);
+            else if (clip.bitsPerSample == 8) GatherClip<DecodePCM8>(clip, first, span, voice.looping, left, right);
+            else if (clip.bitsPerSample == 24) GatherClip<DecodePCM24>(clip, first, span, voice.looping, left, right);
+            else if (clip.bitsPerSample == 32) GatherClip<DecodePCM32>(clip, first, span, voice.looping, left, right);
+            else GatherClip<DecodePCM16>(clip, first, span, voice.looping, left, right);
+            if (!voice.looping && voice.cursor + rate * (frameCount - 1) >= double(clip.frameCount)) {
+                mixed = static_cast<uint32_t>(std::max(std::ceil((double(clip.frameCount) - voice.cursor) / rate), 0.0));
+            }
+        }
+        mixed = std::min(mixed, frameCount);
+
+        resampledRight = right ? voiceRight_.data() : nullptr;
+        resampler_.Process(voice.quality, left, right, voice.cursor - double(first), rate, resampledLeft,
+                           resampledRight, mixed);
+    }
+
+    // One pole is enough to dull a voice heard through a wall
+    if (voice.lowPass > 0.0f && voice.lowPass < sampleRate_ * MAX_LOW_PASS) {
+        float a = 1.0f - std::exp(-TWO_PI * voice.lowPass / sampleRate_);
+        float state = voice.filter[0];
+        for (uint32_t f = 0; f < mixed; ++f) {
+            state += (resampledLeft[f] - state) * a;
+            resampledLeft[f] = state;
+        }
+        voice.filter[0] = state;
+        if (resampledRight) {
+            state = voice.filter[1];
+            for (uint32_t f = 0; f < mixed; ++f) {
+                state += (resampledRight[f] - state) * a;
+                resampledRight[f] = state;
+            }
+            voice.filter[1] = state;
+        }
+    }
+
+    if (voice.gain[0] < 0.0f) std::copy(target, target + 3, voice.gain);
+    float steps[3];
+    for (int i = 0; i < 3; ++i) steps[i] = (target[i] - voice.gain[i]) / frameCount;
+    // Only the world is in the room; music and interface sounds stay dry
+    float* reverb = voice.spatial && reverbs_[activeReverb_].level > 0.0f ? send : nullptr;
+    float* binaural = nullptr;
+    if (binaural_ && voice.spatial) {
+        binaural = spatializer_.Submit(index, direction, std::max(voice.gain[2], target[2]));
+    }
+    if (binaural) {
+        MixMono(resampledLeft, resampledRight, binaural, reverb, mixed, frameCount, voice.gain[2], steps[2]);
+    } else {
+        MixFrames(resampledLeft, resampledRight, output, reverb, mixed, voice.gain, steps);
+    }
+    std::copy(target, target + 3, voice.gain);
+
+    voice.cursor += voice.synthesized ? double(frameCount) : rate * frameCount;
+    if (voice.looping && !stream && !voice.synthesized && voice.cursor >= clip.frameCount) voice.cursor = std::fmod(voice.cursor, double(clip.frameCount));
+    if (stream) {
+        // Everything before the next block's first tap can be overwritten
+        int64_t next = static_cast<int64_t>(std::floor(voice.cursor)) - (AudioResampler::HALF_TAPS - 1);
+        uint64_t written = stream->written.load(std::memory_order_relaxed);
+        stream->consumed.store(std::min(uint64_t(std::max<int64_t>(next, 0)), written), std::memory_order_release);
+    }
+
+    if (mixed < frameCount) {
+        Stop(voice, true);
+    } else if (voice.fade <= 0.0f && voice.fadeTarget <= 0.0f) {
+        // Faded out for good
+        Stop(voice, false);
+    }
+}
+
+void AudioRenderer::TargetGains(const Voice& voice, float gains[3], double& rate, float direction[3]) const {
+    float gain = std::max(voice.volume * voice.fade * masterVolume_, 0.0f) * (1.0f - voice.occlusion);
+    float pan = voice.pan;
+    float doppler = 1.0f;
+    direction[0] = 0.0f;
+    direction[1] = 0.0f;
+    direction[2] = 1.0f;
+
+    if (voice.spatial) {
+        float toListener[3] = { listenerPosition_[0] - voice.position[0], listenerPosition_[1] - voice.position[1],
+                                listenerPosition_[2] - voice.position[2] };
+        float distance = std::sqrt(toListener[0] * toListener[0] + toListener[1] * toListener[1] +
+                                   toListener[2] * toListener[2]);
+        if (distance >= voice.maxDistance) {
+            gain = 0.0f;
+        } else if (distance > voice.minDistance) {
+            float normalized = (distance - voice.minDistance) / (voice.maxDistance - voice.minDistance);
+            gain *= std::pow(1.0f - normalized, voice.rolloff);
+        }
+
+        if (distance > 1e-4f) {
+            for (float& c : toListener) c /= distance;
+            pan = -(toListener[0] * listenerRight_[0] + toListener[1] * listenerRight_[1] +
+                    toListener[2] * listenerRight_[2]);
+            direction[0] = pan;
+            direction[1] = -(toListener[0] * listenerUp_[0] + toListener[1] * listenerUp_[1] + toListener[2] * listenerUp_[2]);
+            direction[2] = -(toListener[0] * listenerForward_[0] + toListener[1] * listenerForward_[1] +
+                             toListener[2] * listenerForward_[2]);
+            // Closing speeds along the line between them raise the pitch
+            float sourceSpeed = voice.velocity[0] * toListener[0] + voice.velocity[1] * toListener[1] +
+                                voice.velocity[2] * toListener[2];
+            float listenerSpeed = listenerVelocity_[0] * toListener[0] + listenerVelocity_[1] * toListener[1] +
+                                  listenerVelocity_[2] * toListener[2];
+            doppler = std::clamp((SPEED_OF_SOUND - listenerSpeed) / std::max(SPEED_OF_SOUND - sourceSpeed, 1.0f),
+                                 0.5f, 2.0f);
+        } else {
+            pan = 0.0f;
+        }
+    }
+
+    if (voice.clip.channels == 1) {
+        // Equal power, so a mono voice keeps its loudness as it moves across
+        float angle = (pan + 1.0f) * QUARTER_PI;
+        gains[0] = gain * std::cos(angle);
+        gains[1] = gain * std::sin(angle);
+    } else {
+        gains[0] = gain * (pan > 0.0f ? 1.0f - pan : 1.0f);
+        gains[1] = gain * (pan < 0.0f ? 1.0f + pan : 1.0f);
+    }
+    gains[2] = gain;
+    rate = std::clamp(double(voice.clip.sampleRate) / sampleRate_ * std::max(voice.pitch, 0.0f) * doppler,
+                      MIN_RATE, AudioResampler::MAX_RATE);
+}
+
+void AudioRenderer::Stop(Voice& voice, bool finished) {
+    voice.active = false;
+    voice.finished = finished;
+    voice.donePending = true;
+}
+
+void AudioRenderer::SetReverb(const ReverbSettings& settings) {
+    // The current room rings out in the other slot while the new one starts clean
+    ReverbSlot& previous = reverbs_[activeReverb_];
+    if (previous.level > 0.0f) {
+        previous.ringing = previous.convolution ? previous.convolution->GetTailFrames() : previous.fdn.GetTailFrames();
+    } else {
+        previous.ringing = 0;
+        Retire(previous);
+    }
+
+    activeReverb_ ^= 1;
+    ReverbSlot& slot = reverbs_[activeReverb_];
+    Retire(slot);
+    slot.fdn.Reset();
+    slot.fdn.Configure(settings);
+    slot.level = std::max(settings.level, 0.0f);
+    slot.ringing = 0;
+}
+
+void AudioRenderer::ProcessReverb(ReverbSlot& slot, bool active, float* output) {
+    if (active ? slot.level <= 0.0f : slot.ringing == 0) return;
+
+    const float* input = active ? send_.data() : silence_.data();
+    if (slot.convolution) {
+        // The FDN applies its level on the way out; a convolution needs it on the way in
+        float* scaled = convolutionInput_.data();
+        for (uint32_t f = 0; f < BLOCK_FRAMES; ++f) scaled[f] = input[f] * slot.level;
+        slot.convolution->Process(scaled, output);
+    } else {
+        slot.fdn.Process(input, output, BLOCK_FRAMES);
+    }
+
+    if (!active) {
+        slot.ringing = slot.ringing > BLOCK_FRAMES ? slot.ringing - BLOCK_FRAMES : 0;
+        if (slot.ringing == 0) Retire(slot);
+    }
+}
+
+void AudioRenderer::Retire(ReverbSlot& slot) {
+    if (!slot.convolution) return;
+    // Never full: no more convolutions exist than the ring holds
+    retired_.Push(slot.convolution);
+    slot.convolution = nullptr;
+}
+
+} // namespace Nexus
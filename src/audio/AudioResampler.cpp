@@ -0,0 +1,156 @@
+#include "AudioResampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+namespace {
+constexpr double PI = 3.14159265358979323846;
+// Cutoff as a fraction of the slower side's Nyquist; the rest is the transition band
+constexpr double SINC_CUTOFF = 0.9;
+// Kaiser window shape, trading stopband depth against transition width
+constexpr double KAISER_BETA = 8.0;
+// Rates each bank is designed for; a bank serves every rate above the previous one
+constexpr double BANK_RATES[] = { 1.0, 1.25, 1.5, 2.0, 3.0, 4.0, 6.0, AudioResampler::MAX_RATE };
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+double BesselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+float HorizontalSum(__m128 v) {
+    __m128 sum = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(sum);
+}
+
+float Hermite(const float* x, float t) {
+    float c1 = 0.5f * (x[2] - x[0]);
+    float c2 = x[0] - 2.5f * x[1] + 2.0f * x[2] - 0.5f * x[3];
+    float c3 = 0.5f * (x[3] - x[0]) + 1.5f * (x[1] - x[2]);
+    return ((c3 * t + c2) * t + c1) * t + x[1];
+}
+}
+
+void AudioResampler::Prepare() {
+    if (IsPrepared()) return;
+
+    const double beta = BesselI0(KAISER_BETA);
+    banks_.resize(std::size(BANK_RATES));
+    for (size_t b = 0; b < banks_.size(); ++b) {
+        Bank& bank = banks_[b];
+        bank.maxRate = BANK_RATES[b];
+        double cutoff = SINC_CUTOFF / bank.maxRate;
+
+        // One more phase than used, so the last has a slope
+        std::vector<float> table(size_t(PHASES + 1) * TAPS);
+        for (uint32_t p = 0; p <= PHASES; ++p) {
+            double fraction = double(p) / PHASES;
+            double sum = 0.0;
+            float* taps = table.data() + size_t(p) * TAPS;
+            for (uint32_t k = 0; k < TAPS; ++k) {
+                // Tap k reads the frame k - (HALF_TAPS - 1) after the one at or before the position
+                double x = double(k) - (HALF_TAPS - 1) - fraction;
+                double sinc = std::abs(x) < 1e-9 ? 1.0 : std::sin(PI * cutoff * x) / (PI * cutoff * x);
+                double w = x / HALF_TAPS;
+                double window = std::abs(w) >= 1.0 ? 0.0 : BesselI0(KAISER_BETA * std::sqrt(1.0 - w * w)) / beta;
+                double value = cutoff * sinc * window;
+                taps[k] = static_cast<float>(value);
+                sum += value;
+            }
+            // Unity gain at DC for every phase, so a held level doesn't ripple as the phase moves
+            for (uint32_t k = 0; k < TAPS; ++k) taps[k] = static_cast<float>(taps[k] / sum);
+        }
+
+        bank.coefficients.assign(table.begin(), table.end() - TAPS);
+        bank.slopes.resize(size_t(PHASES) * TAPS);
+        for (size_t i = 0; i < bank.slopes.size(); ++i) bank.slopes[i] = table[i + TAPS] - table[i];
+    }
+}
+
+uint32_t AudioResampler::GetSpan(uint32_t frameCount, double rate) {
+    return static_cast<uint32_t>(std::ceil(rate * (frameCount > 0 ? frameCount - 1 : 0))) + TAPS + 1;
+}
+
+const AudioResampler::Bank& AudioResampler::SelectBank(double rate) const {
+    for (const Bank& bank : banks_) {
+        if (rate <= bank.maxRate) return bank;
+    }
+    return banks_.back();
+}
+
+void AudioResampler::Process(AudioResampleQuality quality, const float* left, const float* right, double position,
+                             double rate, float* outLeft, float* outRight, uint32_t frameCount) const {
+    // Whole frames at the source rate are just copies, whatever the quality
+    if (rate == 1.0 && position == std::floor(position)) {
+        size_t start = static_cast<size_t>(position);
+        std::memcpy(outLeft, left + start, frameCount * sizeof(float));
+        if (right) std::memcpy(outRight, right + start, frameCount * sizeof(float));
+        return;
+    }
+
+    switch (quality) {
+    case AudioResampleQuality::Sinc:
+        if (IsPrepared()) {
+            ProcessSinc(SelectBank(rate), left, right, position, rate, outLeft, outRight, frameCount);
+            return;
+        }
+        [[fallthrough]];
+    case AudioResampleQuality::Cubic:
+        for (uint32_t f = 0; f < frameCount; ++f) {
+            double at = position + rate * f;
+            size_t index = static_cast<size_t>(at);
+            float t = static_cast<float>(at - index);
+            outLeft[f] = Hermite(left + index - 1, t);
+            if (right) outRight[f] = Hermite(right + index - 1, t);
+        }
+        return;
+    case AudioResampleQuality::Linear:
+        for (uint32_t f = 0; f < frameCount; ++f) {
+            double at = position + rate * f;
+            size_t index = static_cast<size_t>(at);
+            float t = static_cast<float>(at - index);
+            outLeft[f] = left[index] + (left[index + 1] - left[index]) * t;
+            if (right) outRight[f] = right[index] + (right[index + 1] - right[index]) * t;
+        }
+        return;
+    }
+}
+
+void AudioResampler::ProcessSinc(const Bank& bank, const float* left, const float* right, double position,
+                                 double rate, float* outLeft, float* outRight, uint32_t frameCount) const {
+    const float* coefficients = bank.coefficients.data();
+    const float* slopes = bank.slopes.data();
+
+    for (uint32_t f = 0; f < frameCount; ++f) {
+        double at = position + rate * f;
+        size_t index = static_cast<size_t>(at);
+        float phase = static_cast<float>(at - index) * PHASES;
+        uint32_t p = std::min(static_cast<uint32_t>(phase), PHASES - 1);
+        __m128 t = _mm_set1_ps(phase - p);
+        const float* c = coefficients + size_t(p) * TAPS;
+        const float* s = slopes + size_t(p) * TAPS;
+        size_t first = index - (HALF_TAPS - 1);
+
+        __m128 sumLeft = _mm_setzero_ps();
+        __m128 sumRight = _mm_setzero_ps();
+        for (uint32_t k = 0; k < TAPS; k += 4) {
+            __m128 weight = _mm_add_ps(_mm_loadu_ps(c + k), _mm_mul_ps(_mm_loadu_ps(s + k), t));
+            sumLeft = _mm_add_ps(sumLeft, _mm_mul_ps(weight, _mm_loadu_ps(left + first + k)));
+            if (right) sumRight = _mm_add_ps(sumRight, _mm_mul_ps(weight, _mm_loadu_ps(right + first + k)));
+        }
+        outLeft[f] = HorizontalSum(sumLeft);
+        if (right) outRight[f] = HorizontalSum(sumRight);
+    }
+}
+
+} // namespace Nexus
@@ -0,0 +1,797 @@
+#include "AudioStream.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#define STB_VORBIS_HEADER_ONLY
+#define STB_VORBIS_NO_STDIO
+#define STB_VORBIS_NO_INTEGER_CONVERSION
+#include <stb/stb_vorbis.c>
+
+namespace Nexus {
+
+namespace {
+constexpr size_t MIN_CHUNK_BYTES = 4096;
+constexpr int MIN_CHUNK_COUNT = 2;
+constexpr size_t VORBIS_INPUT_BYTES = 16 * 1024;
+constexpr size_t VORBIS_MAX_INPUT_BYTES = 1024 * 1024;      // Largest page stb_vorbis can need
+// How long a decoder thread sleeps when every stream is full or waiting on the disk
+constexpr auto IDLE_WAIT = std::chrono::milliseconds(2);
+
+// Format tags, named apart from the mmreg.h macros
+constexpr uint16_t WAV_PCM = 1;
+constexpr uint16_t WAV_IMA_ADPCM = 0x11;
+constexpr uint16_t WAV_IEEE_FLOAT = 3;
+constexpr uint16_t WAV_EXTENSIBLE = 0xFFFE;
+
+constexpr int IMA_STEPS[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+    107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871,
+    5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+    27086, 29794, 32767
+};
+constexpr int IMA_INDEX_STEPS[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+uint16_t ReadU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t ReadU32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+
+uint32_t NextPowerOfTwo(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Reads exactly size bytes, waiting on the source for them. Only for headers, while opening
+bool ReadExact(AudioByteSource& source, void* data, size_t size) {
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    size_t done = 0;
+    while (done < size) {
+        size_t read = source.Read(bytes + done, size - done);
+        done += read;
+        if (read == 0) {
+            if (source.AtEnd()) return false;
+            source.Wait();
+        }
+    }
+    return true;
+}
+
+/**
+ * RIFF WAVE: 8 to 32 bit PCM, 32 bit float and IMA ADPCM.
+ *
+ * ADPCM decodes a block at a time into blockSamples_; everything else converts straight from the
+ * bytes read. Seeking is exact for both.
+ */
+class WAVDecoder : public AudioDecoder {
+public:
+    bool Open(AudioByteSource& source) override;
+    uint32_t GetSampleRate() const override { return sampleRate_; }
+    uint16_t GetChannels() const override { return channels_; }
+    uint64_t GetFrameCount() const override { return frameCount_; }
+    uint32_t Decode(float* output, uint32_t frameCount) override;
+    bool Seek(uint64_t frame) override;
+    bool IsFinished() const override {
+        return (consumed_ >= dataSize_ && blockRead_ >= blockFrames_) || position_ >= frameCount_;
+    }
+
+private:
+    uint32_t DecodePCM(float* output, uint32_t frameCount);
+    uint32_t DecodeADPCM(float* output, uint32_t frameCount);
+    uint32_t DecodeBlock(const uint8_t* block, size_t size);
+
+    AudioByteSource* source_ = nullptr;
+    uint16_t format_ = 0;
+    uint16_t channels_ = 0;
+    uint32_t sampleRate_ = 0;
+    uint16_t bitsPerSample_ = 0;
+    uint16_t blockAlign_ = 0;
+    uint32_t samplesPerBlock_ = 0;             // ADPCM frames per block
+    uint64_t dataOffset_ = 0;
+    uint64_t dataSize_ = 0;
+    uint64_t consumed_ = 0;                    // Bytes of data read so far
+    uint64_t frameCount_ = 0;
+    uint64_t position_ = 0;                    // Frames decoded so far
+    std::vector<uint8_t> scratch_;
+    std::vector<float> blockSamples_;
+    uint32_t blockFrames_ = 0;
+    uint32_t blockRead_ = 0;
+    uint32_t skip_ = 0;                        // Frames to drop from the next block after a seek
+};
+
+bool WAVDecoder::Open(AudioByteSource& source) {
+    source_ = &source;
+    uint8_t header[12];
+    if (!ReadExact(source, header, sizeof(header))) return false;
+    if (std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0) return false;
+
+    uint64_t position = sizeof(header);
+    uint8_t fmt[40] = {};
+    bool hasFormat = false;
+    uint32_t factFrames = 0;
+    for (;;) {
+        uint8_t chunk[8];
+        if (!ReadExact(source, chunk, sizeof(chunk))) return false;
+        position += sizeof(chunk);
+        uint32_t size = ReadU32(chunk + 4);
+
+        if (std::memcmp(chunk, "data", 4) == 0) {
+            dataOffset_ = position;
+            dataSize_ = std::min<uint64_t>(size, source.GetSize() - position);
+            break;
+        }
+        uint64_t next = position + size + (size & 1);
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            size_t wanted = std::min<size_t>(size, sizeof(fmt));
+            if (wanted < 16 || !ReadExact(source, fmt, wanted)) return false;
+            position += wanted;
+            hasFormat = true;
+        } else if (std::memcmp(chunk, "fact", 4) == 0 && size >= 4) {
+            // The exact length; ADPCM's last block is padded out to whole groups of eight
+            uint8_t fact[4];
+            if (!ReadExact(source, fact, sizeof(fact))) return false;
+            position += sizeof(fact);
+            factFrames = ReadU32(fact);
+        }
+        if (next != position) {
+            if (next >= source.GetSize() || !source.Seek(next)) return false;
+            position = next;
+        }
+    }
+    if (!hasFormat) return false;
+
+    format_ = ReadU16(fmt);
+    channels_ = ReadU16(fmt + 2);
+    sampleRate_ = ReadU32(fmt + 4);
+    blockAlign_ = ReadU16(fmt + 12);
+    bitsPerSample_ = ReadU16(fmt + 14);
+    if (format_ == WAV_EXTENSIBLE) format_ = ReadU16(fmt + 24);
+    if (channels_ == 0 || channels_ > 8 || sampleRate_ == 0 || blockAlign_ == 0) return false;
+
+    if (format_ == WAV_IMA_ADPCM) {
+        if (bitsPerSample_ != 4 || blockAlign_ <= 4u * channels_) return false;
+        samplesPerBlock_ = ReadU16(fmt + 18);
+        uint32_t fromAlign = (blockAlign_ - 4u * channels_) * 2 / channels_ + 1;
+        if (samplesPerBlock_ == 0 || samplesPerBlock_ > fromAlign) samplesPerBlock_ = fromAlign;
+
+        uint64_t blocks = dataSize_ / blockAlign_;
+        uint64_t tail = dataSize_ % blockAlign_;
+        frameCount_ = blocks * samplesPerBlock_;
+        if (tail > 4u * channels_) frameCount_ += std::min<uint64_t>((tail - 4u * channels_) * 2 / channels_ + 1, samplesPerBlock_);
+        if (factFrames > 0) frameCount_ = std::min<uint64_t>(frameCount_, factFrames);
+        scratch_.resize(blockAlign_);
+        blockSamples_.resize(size_t(samplesPerBlock_) * channels_);
+    } else {
+        bool pcm = format_ == WAV_PCM && (bitsPerSample_ == 8 || bitsPerSample_ == 16 ||
+                                                 bitsPerSample_ == 24 || bitsPerSample_ == 32);
+        bool ieee = format_ == WAV_IEEE_FLOAT && bitsPerSample_ == 32;
+        if (!pcm && !ieee) return false;
+        if (blockAlign_ != channels_ * (bitsPerSample_ / 8)) return false;
+        frameCount_ = dataSize_ / blockAlign_;
+        dataSize_ = frameCount_ * blockAlign_;
+        scratch_.resize(size_t(AudioStreamer::DECODE_CHUNK_FRAMES) * blockAlign_);
+    }
+    consumed_ = 0;
+    position_ = 0;
+    return true;
+}
+
+uint32_t WAVDecoder::Decode(float* output, uint32_t frameCount) {
+    frameCount = static_cast<uint32_t>(std::min<uint64_t>(frameCount, frameCount_ - position_));
+    uint32_t decoded = format_ == WAV_IMA_ADPCM ? DecodeADPCM(output, frameCount) : DecodePCM(output, frameCount);
+    position_ += decoded;
+    return decoded;
+}
+
+uint32_t WAVDecoder::DecodePCM(float* output, uint32_t frameCount) {
+    uint32_t done = 0;
+    while (done < frameCount) {
+        uint64_t frames = std::min<uint64_t>(frameCount - done, (dataSize_ - consumed_) / blockAlign_);
+        frames = std::min<uint64_t>(frames, source_->Available() / blockAlign_);
+        frames = std::min<uint64_t>(frames, scratch_.size() / blockAlign_);
+        if (frames == 0) break;
+
+        size_t bytes = size_t(frames) * blockAlign_;
+        source_->Read(scratch_.data(), bytes);
+        consumed_ += bytes;
+
+        const uint8_t* in = scratch_.data();
+        float* out = output + size_t(done) * channels_;
+        size_t samples = size_t(frames) * channels_;
+        switch (bitsPerSample_) {
+        case 8:
+            for (size_t i = 0; i < samples; ++i) out[i] = (in[i] - 128) / 128.0f;
+            break;
+        case 16:
+            for (size_t i = 0; i < samples; ++i) out[i] = static_cast<int16_t>(ReadU16(in + i * 2)) / 32768.0f;
+            break;
+        case 24:
+            for (size_t i = 0; i < samples; ++i) {
+                const uint8_t* p = in + i * 3;
+                int32_t value = static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24));
+                out[i] = (value >> 8) / 8388608.0f;
+            }
+            break;
+        default:
+            if (format_ == WAV_IEEE_FLOAT) {
+                std::memcpy(out, in, bytes);
+            } else {
+                for (size_t i = 0; i < samples; ++i) out[i] = static_cast<int32_t>(ReadU32(in + i * 4)) / 2147483648.0f;
+            }
+            break;
+        }
+        done += static_cast<uint32_t>(frames);
+    }
+    return done;
+}
+
+uint32_t WAVDecoder::DecodeADPCM(float* output, uint32_t frameCount) {
+    uint32_t done = 0;
+    while (done < frameCount) {
+        if (blockRead_ < blockFrames_) {
+            uint32_t frames = std::min(frameCount - done, blockFrames_ - blockRead_);
+            std::memcpy(output + size_t(done) * channels_, blockSamples_.data() + size_t(blockRead_) * channels_,
+                        size_t(frames) * channels_ * sizeof(float));
+            blockRead_ += frames;
+            done += frames;
+            continue;
+        }
+
+        size_t bytes = static_cast<size_t>(std::min<uint64_t>(blockAlign_, dataSize_ - consumed_));
+        if (bytes <= 4u * channels_) {
+            // Nothing left but a truncated block header
+            consumed_ = dataSize_;
+            break;
+        }
+        if (source_->Available() < bytes) break;
+        source_->Read(scratch_.data(), bytes);
+        consumed_ += bytes;
+
+        blockFrames_ = DecodeBlock(scratch_.data(), bytes);
+        blockRead_ = std::min(skip_, blockFrames_);
+        skip_ = 0;
+    }
+    return done;
+}
+
+uint32_t WAVDecoder::DecodeBlock(const uint8_t* block, size_t size) {
+    int predictors[8];
+    int indices[8];
+    for (uint16_t c = 0; c < channels_; ++c) {
+        predictors[c] = static_cast<int16_t>(ReadU16(block + c * 4));
+        indices[c] = std::min<int>(block[c * 4 + 2], 88);
+        blockSamples_[c] = predictors[c] / 32768.0f;
+    }
+
+    // After the headers, each channel takes turns with four bytes, eight samples, low nibble first
+    uint32_t frames = static_cast<uint32_t>(std::min<size_t>((size - 4u * channels_) * 2 / channels_ + 1, samplesPerBlock_));
+    const uint8_t* data = block + 4u * channels_;
+    size_t groups = (frames - 1) / 8;
+    for (size_t g = 0; g < groups; ++g) {
+        for (uint16_t c = 0; c < channels_; ++c) {
+            const uint8_t* bytes = data + (g * channels_ + c) * 4;
+            for (int n = 0; n < 8; ++n) {
+                int nibble = (bytes[n / 2] >> ((n & 1) * 4)) & 0xF;
+                int step = IMA_STEPS[indices[c]];
+                int diff = step >> 3;
+                if (nibble & 1) diff += step >> 2;
+                if (nibble & 2) diff += step >> 1;
+                if (nibble & 4) diff += step;
+                predictors[c] += (nibble & 8) ? -diff : diff;
+                predictors[c] = std::clamp(predictors[c], -32768, 32767);
+                indices[c] = std::clamp(indices[c] + IMA_INDEX_STEPS[nibble], 0, 88);
+                blockSamples_[(1 + g * 8 + n) * channels_ + c] = predictors[c] / 32768.0f;
+            }
+        }
+    }
+    return static_cast<uint32_t>(1 + groups * 8);
+}
+
+bool WAVDecoder::Seek(uint64_t frame) {
+    if (frameCount_ > 0 && frame > frameCount_) return false;
+    blockFrames_ = 0;
+    blockRead_ = 0;
+    skip_ = 0;
+    position_ = frame;
+    if (format_ == WAV_IMA_ADPCM) {
+        uint64_t block = frame / samplesPerBlock_;
+        consumed_ = block * blockAlign_;
+        skip_ = static_cast<uint32_t>(frame % samplesPerBlock_);
+    } else {
+        consumed_ = frame * blockAlign_;
+    }
+    return source_->Seek(dataOffset_ + consumed_);
+}
+
+/**
+ * Ogg Vorbis through stb_vorbis.
+ *
+ * Data already in memory uses the pull API, which seeks exactly and knows the length up front.
+ * File streams use the pushdata API over a small input buffer instead; seeking there rewinds to the
+ * first audio page and decodes forward, discarding frames until the target.
+ */
+class VorbisDecoder : public AudioDecoder {
+public:
+    ~VorbisDecoder() override;
+
+    bool Open(AudioByteSource& source) override;
+    uint32_t GetSampleRate() const override { return sampleRate_; }
+    uint16_t GetChannels() const override { return channels_; }
+    uint64_t GetFrameCount() const override { return frameCount_; }
+    uint32_t Decode(float* output, uint32_t frameCount) override;
+    bool Seek(uint64_t frame) override;
+    bool IsFinished() const override { return finished_; }
+
+private:
+    // Tops the input up from the source. False if it's full
+    bool Refill();
+    void Consume(size_t bytes) { inputStart_ += bytes; }
+
+    AudioByteSource* source_ = nullptr;
+    stb_vorbis* vorbis_ = nullptr;
+    bool pull_ = false;
+    uint32_t sampleRate_ = 0;
+    uint16_t channels_ = 0;
+    uint64_t frameCount_ = 0;
+    bool finished_ = false;
+
+    std::vector<uint8_t> input_;
+    size_t inputStart_ = 0;
+    size_t inputEnd_ = 0;
+    uint64_t audioOffset_ = 0;                 // Byte offset of the first audio page
+    float** outputs_ = nullptr;                // Last decoded packet, one array per channel
+    uint32_t outputFrames_ = 0;
+    uint32_t outputRead_ = 0;
+    uint64_t skip_ = 0;
+};
+
+VorbisDecoder::~VorbisDecoder() {
+    if (vorbis_) stb_vorbis_close(vorbis_);
+}
+
+bool VorbisDecoder::Open(AudioByteSource& source) {
+    source_ = &source;
+    int error = 0;
+    if (const uint8_t* data = source.GetData()) {
+        if (source.GetSize() > static_cast<uint64_t>(INT32_MAX)) return false;
+        vorbis_ = stb_vorbis_open_memory(data, static_cast<int>(source.GetSize()), &error, nullptr);
+        if (!vorbis_) return false;
+        pull_ = true;
+        frameCount_ = stb_vorbis_stream_length_in_samples(vorbis_);
+    } else {
+        input_.resize(VORBIS_INPUT_BYTES);
+        for (;;) {
+            bool room = Refill();
+            int used = 0;
+            vorbis_ = stb_vorbis_open_pushdata(input_.data() + inputStart_, static_cast<int>(inputEnd_ - inputStart_),
+                                               &used, &error, nullptr);
+            if (vorbis_) {
+                // Nothing was consumed before the headers parsed, so this is where the audio starts
+                Consume(used);
+                audioOffset_ = used;
+                break;
+            }
+            if (error != VORBIS_need_more_data) return false;
+            if (!room) {
+                // A header page bigger than the buffer
+                if (input_.size() >= VORBIS_MAX_INPUT_BYTES) return false;
+                input_.resize(input_.size() * 2);
+                continue;
+            }
+            if (source.AtEnd()) return false;
+            source.Wait();
+        }
+    }
+
+    stb_vorbis_info info = stb_vorbis_get_info(vorbis_);
+    sampleRate_ = info.sample_rate;
+    channels_ = static_cast<uint16_t>(info.channels);
+    return sampleRate_ > 0 && channels_ > 0;
+}
+
+bool VorbisDecoder::Refill() {
+    if (inputStart_ > 0) {
+        std::memmove(input_.data(), input_.data() + inputStart_, inputEnd_ - inputStart_);
+        inputEnd_ -= inputStart_;
+        inputStart_ = 0;
+    }
+    if (inputEnd_ == input_.size()) return false;
+    inputEnd_ += source_->Read(input_.data() + inputEnd_, input_.size() - inputEnd_);
+    return true;
+}
+
+uint32_t VorbisDecoder::Decode(float* output, uint32_t frameCount) {
+    if (finished_) return 0;
+    if (pull_) {
+        int frames = stb_vorbis_get_samples_float_interleaved(vorbis_, channels_, output,
+                                                              static_cast<int>(frameCount * channels_));
+        if (frames == 0) finished_ = true;
+        return static_cast<uint32_t>(frames);
+    }
+
+    uint32_t done = 0;
+    while (done < frameCount) {
+        if (outputRead_ < outputFrames_) {
+            uint32_t frames = outputFrames_ - outputRead_;
+            if (skip_ > 0) {
+                uint32_t skipped = static_cast<uint32_t>(std::min<uint64_t>(skip_, frames));
+                skip_ -= skipped;
+                outputRead_ += skipped;
+                continue;
+            }
+            frames = std::min(frames, frameCount - done);
+            for (uint32_t f = 0; f < frames; ++f) {
+                for (uint16_t c = 0; c < channels_; ++c) {
+                    output[size_t(done + f) * channels_ + c] = outputs_[c][outputRead_ + f];
+                }
+            }
+            outputRead_ += frames;
+            done += frames;
+            continue;
+        }
+
+        bool room = Refill();
+        int channels = 0;
+        int samples = 0;
+        float** outputs = nullptr;
+        int used = stb_vorbis_decode_frame_pushdata(vorbis_, input_.data() + inputStart_,
+                                                    static_cast<int>(inputEnd_ - inputStart_), &channels, &outputs, &samples);
+        if (used == 0) {
+            if (!room && input_.size() < VORBIS_MAX_INPUT_BYTES) {
+                input_.resize(input_.size() * 2);
+                continue;
+            }
+            // Out of input: either the disk hasn't caught up or the stream is over
+            if (source_->AtEnd() && source_->Available() == 0) finished_ = true;
+            break;
+        }
+        Consume(used);
+        outputs_ = outputs;
+        outputFrames_ = static_cast<uint32_t>(samples);
+        outputRead_ = 0;
+    }
+    return done;
+}
+
+bool VorbisDecoder::Seek(uint64_t frame) {
+    if (frameCount_ > 0 && frame > frameCount_) return false;
+    finished_ = false;
+    if (pull_) return stb_vorbis_seek(vorbis_, static_cast<unsigned int>(frame)) != 0;
+
+    stb_vorbis_flush_pushdata(vorbis_);
+    inputStart_ = inputEnd_ = 0;
+    outputFrames_ = outputRead_ = 0;
+    skip_ = frame;
+    return source_->Seek(audioOffset_);
+}
+}
+
+MemoryByteSource::MemoryByteSource(std::shared_ptr<const std::vector<uint8_t>> data)
+    : data_(data, data->data())
+    , size_(data->size())
+    , position_(0) {
+}
+
+MemoryByteSource::MemoryByteSource(std::shared_ptr<const uint8_t> data, size_t size)
+    : data_(std::move(data))
+    , size_(size)
+    , position_(0) {
+}
+
+size_t MemoryByteSource::Read(void* data, size_t size) {
+    size_t count = std::min(size, size_ - position_);
+    std::memcpy(data, data_.get() + position_, count);
+    position_ += count;
+    return count;
+}
+
+bool MemoryByteSource::Seek(uint64_t offset) {
+    if (offset > size_) return false;
+    position_ = static_cast<size_t>(offset);
+    return true;
+}
+
+OverlappedFileSource::OverlappedFileSource(const std::string& filePath, size_t chunkBytes, int chunkCount)
+    : file_(CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr))
+    , size_(0)
+    , chunkBytes_(std::max(chunkBytes, MIN_CHUNK_BYTES))
+    , storage_(chunkBytes_ * std::max(chunkCount, MIN_CHUNK_COUNT))
+    , chunks_(std::max(chunkCount, MIN_CHUNK_COUNT))
+    , current_(0)
+    , position_(0)
+    , nextOffset_(0) {
+    if (!IsOpen()) return;
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file_, &size)) size_ = static_cast<uint64_t>(size.QuadPart);
+    for (Chunk& chunk : chunks_) {
+        std::memset(&chunk, 0, sizeof(chunk));
+        chunk.overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    }
+    for (size_t i = 0; i < chunks_.size(); ++i) Issue(i);
+}
+
+OverlappedFileSource::~OverlappedFileSource() {
+    if (!IsOpen()) return;
+    CancelAll();
+    for (Chunk& chunk : chunks_) {
+        if (chunk.overlapped.hEvent) CloseHandle(chunk.overlapped.hEvent);
+    }
+    CloseHandle(file_);
+}
+
+void OverlappedFileSource::Issue(size_t index) {
+    Chunk& chunk = chunks_[index];
+    chunk.offset = nextOffset_;
+    chunk.filled = 0;
+    chunk.pending = false;
+    // Past the end the chunk stays empty, which readers take as the end of the file
+    if (nextOffset_ >= size_) return;
+
+    DWORD length = static_cast<DWORD>(std::min<uint64_t>(chunkBytes_, size_ - nextOffset_));
+    nextOffset_ += length;
+    ResetEvent(chunk.overlapped.hEvent);
+    chunk.overlapped.Offset = static_cast<DWORD>(chunk.offset);
+    chunk.overlapped.OffsetHigh = static_cast<DWORD>(chunk.offset >> 32);
+    if (ReadFile(file_, storage_.data() + index * chunkBytes_, length, nullptr, &chunk.overlapped) ||
+        GetLastError() == ERROR_IO_PENDING) {
+        chunk.pending = true;
+    } else {
+        Logger::Warning("Streaming read failed at offset " + std::to_string(chunk.offset));
+    }
+}
+
+bool OverlappedFileSource::Poll(size_t index, bool wait) {
+    Chunk& chunk = chunks_[index];
+    if (!chunk.pending) return true;
+
+    DWORD bytes = 0;
+    if (GetOverlappedResult(file_, &chunk.overlapped, &bytes, wait ? TRUE : FALSE)) {
+        chunk.filled = bytes;
+    } else if (GetLastError() == ERROR_IO_INCOMPLETE) {
+        return false;
+    } else {
+        // Failed or cancelled; an empty chunk ends the stream early rather than stalling it
+        chunk.filled = 0;
+    }
+    chunk.pending = false;
+    return true;
+}
+
+void OverlappedFileSource::CancelAll() {
+    CancelIoEx(file_, nullptr);
+    for (size_t i = 0; i < chunks_.size(); ++i) Poll(i, true);
+}
+
+size_t OverlappedFileSource::Available() {
+    size_t total = 0;
+    for (size_t k = 0; k < chunks_.size(); ++k) {
+        size_t index = (current_ + k) % chunks_.size();
+        if (!Poll(index, false)) break;
+        const Chunk& chunk = chunks_[index];
+        total += chunk.filled - (k == 0 ? position_ : 0);
+        if (chunk.filled < chunkBytes_) break;
+    }
+    return total;
+}
+
+size_t OverlappedFileSource::Read(void* data, size_t size) {
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    size_t copied = 0;
+    while (copied < size) {
+        if (!Poll(current_, false)) break;
+        const Chunk& chunk = chunks_[current_];
+        size_t left = chunk.filled - position_;
+        if (left == 0) {
+            if (chunk.filled == 0) break;
+            // Used up: send it after the furthest read and move on
+            Issue(current_);
+            current_ = (current_ + 1) % chunks_.size();
+            position_ = 0;
+            continue;
+        }
+        size_t count = std::min(left, size - copied);
+        std::memcpy(bytes + copied, storage_.data() + current_ * chunkBytes_ + position_, count);
+        position_ += count;
+        copied += count;
+    }
+    return copied;
+}
+
+bool OverlappedFileSource::Seek(uint64_t offset) {
+    if (offset > size_) return false;
+    CancelAll();
+    nextOffset_ = offset;
+    current_ = 0;
+    position_ = 0;
+    for (size_t i = 0; i < chunks_.size(); ++i) Issue(i);
+    return true;
+}
+
+void OverlappedFileSource::Wait() {
+    for (size_t k = 0; k < chunks_.size(); ++k) {
+        size_t index = (current_ + k) % chunks_.size();
+        if (chunks_[index].pending) {
+            Poll(index, true);
+            return;
+        }
+    }
+}
+
+bool OverlappedFileSource::AtEnd() {
+    const Chunk& chunk = chunks_[current_];
+    return !chunk.pending && chunk.offset + position_ >= size_;
+}
+
+AudioStream::AudioStream(std::unique_ptr<AudioByteSource> source, std::unique_ptr<AudioDecoder> decoder, uint32_t bufferFrames)
+    : source_(std::move(source))
+    , decoder_(std::move(decoder))
+    , looping_(false)
+    , busy_(false)
+    , closed_(false) {
+    buffer_.capacity = NextPowerOfTwo(std::max(bufferFrames, AudioStreamer::DECODE_CHUNK_FRAMES * 2));
+    buffer_.channels = decoder_->GetChannels();
+    buffer_.samples = std::make_unique<float[]>(size_t(buffer_.capacity) * buffer_.channels);
+}
+
+AudioStreamInfo AudioStream::GetInfo() const {
+    return { decoder_->GetSampleRate(), decoder_->GetChannels(), decoder_->GetFrameCount() };
+}
+
+uint32_t AudioStream::GetFreeFrames() const {
+    uint64_t written = buffer_.written.load(std::memory_order_relaxed);
+    uint64_t consumed = buffer_.consumed.load(std::memory_order_acquire);
+    return buffer_.capacity - static_cast<uint32_t>(written - consumed);
+}
+
+uint32_t AudioStream::Fill(uint32_t maxFrames) {
+    uint64_t written = buffer_.written.load(std::memory_order_relaxed);
+    uint32_t frames = std::min(GetFreeFrames(), maxFrames);
+    uint32_t mask = buffer_.capacity - 1;
+    uint32_t total = 0;
+    bool rewound = false;
+
+    while (total < frames && !IsDone()) {
+        uint32_t offset = static_cast<uint32_t>(written) & mask;
+        uint32_t contiguous = std::min(frames - total, buffer_.capacity - offset);
+        uint32_t decoded = decoder_->Decode(buffer_.samples.get() + size_t(offset) * buffer_.channels, contiguous);
+        if (decoded == 0) {
+            // Starved: the bytes will be there next pass
+            if (!decoder_->IsFinished()) break;
+            // A second rewind in a row with nothing between means there is nothing to loop
+            if (looping_.load(std::memory_order_relaxed) && !rewound && decoder_->Seek(0)) {
+                rewound = true;
+                continue;
+            }
+            buffer_.end.store(written, std::memory_order_release);
+            break;
+        }
+        rewound = false;
+        written += decoded;
+        total += decoded;
+        buffer_.written.store(written, std::memory_order_release);
+    }
+    return total;
+}
+
+AudioStreamer::AudioStreamer()
+    : running_(false) {
+}
+
+AudioStreamer::~AudioStreamer() {
+    Stop();
+}
+
+bool AudioStreamer::Start(int threadCount) {
+    if (!threads_.empty()) return true;
+    running_ = true;
+    for (int i = 0; i < std::max(threadCount, 1); ++i) threads_.emplace_back(&AudioStreamer::ThreadFunc, this);
+    Logger::Info("Audio streamer started with " + std::to_string(threads_.size()) + " decoder threads");
+    return true;
+}
+
+void AudioStreamer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+        if (thread.joinable()) thread.join();
+    }
+    threads_.clear();
+    streams_.clear();
+}
+
+void AudioStreamer::RegisterDecoder(DecoderFactory factory) {
+    factories_.push_back(std::move(factory));
+}
+
+std::unique_ptr<AudioDecoder> AudioStreamer::CreateDecoder(AudioByteSource& source) {
+    std::unique_ptr<AudioDecoder> decoder = std::make_unique<WAVDecoder>();
+    if (decoder->Open(source)) return decoder;
+
+    source.Seek(0);
+    decoder = std::make_unique<VorbisDecoder>();
+    if (decoder->Open(source)) return decoder;
+
+    for (const DecoderFactory& factory : factories_) {
+        source.Seek(0);
+        decoder = factory();
+        if (decoder && decoder->Open(source)) return decoder;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<AudioStream> AudioStreamer::Open(std::unique_ptr<AudioByteSource> source, bool looping,
+                                                 uint64_t startFrame, uint32_t bufferFrames) {
+    std::unique_ptr<AudioDecoder> decoder = CreateDecoder(*source);
+    if (!decoder) return nullptr;
+    if (startFrame > 0 && !decoder->Seek(startFrame)) {
+        Logger::Warning("Could not seek stream to frame " + std::to_string(startFrame));
+        decoder->Seek(0);
+    }
+
+    auto stream = std::make_shared<AudioStream>(std::move(source), std::move(decoder), bufferFrames);
+    stream->SetLooping(looping);
+    // A stream resumed part way may have to decode forward to get there; leave that to the threads
+    if (startFrame == 0) stream->Fill(DECODE_CHUNK_FRAMES);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams_.push_back(stream);
+    }
+    wake_.notify_one();
+    return stream;
+}
+
+void AudioStreamer::Close(const std::shared_ptr<AudioStream>& stream) {
+    if (stream) stream->closed_.store(true, std::memory_order_relaxed);
+}
+
+bool AudioStreamer::Probe(AudioByteSource& source, AudioStreamInfo& info) {
+    std::unique_ptr<AudioDecoder> decoder = CreateDecoder(source);
+    if (!decoder) return false;
+    info = { decoder->GetSampleRate(), decoder->GetChannels(), decoder->GetFrameCount() };
+    return true;
+}
+
+void AudioStreamer::ThreadFunc() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        std::shared_ptr<AudioStream> target;
+        uint32_t mostFree = DECODE_CHUNK_FRAMES / 2;
+        for (size_t i = 0; i < streams_.size();) {
+            AudioStream& stream = *streams_[i];
+            if (stream.closed_.load(std::memory_order_relaxed) && !stream.busy_.load(std::memory_order_relaxed)) {
+                streams_[i] = std::move(streams_.back());
+                streams_.pop_back();
+                continue;
+            }
+            if (!stream.busy_.load(std::memory_order_relaxed) && !stream.IsDone()) {
+                uint32_t free = stream.GetFreeFrames();
+                if (free >= mostFree) {
+                    mostFree = free;
+                    target = streams_[i];
+                }
+            }
+            ++i;
+        }
+        if (!target) {
+            wake_.wait_for(lock, IDLE_WAIT);
+            continue;
+        }
+
+        target->busy_.store(true, std::memory_order_relaxed);
+        lock.unlock();
+        uint32_t decoded = target->Fill(DECODE_CHUNK_FRAMES);
+        lock.lock();
+        target->busy_.store(false, std::memory_order_relaxed);
+        // Waiting on the disk; don't spin on it
+        if (decoded == 0 && !target->IsDone()) wake_.wait_for(lock, IDLE_WAIT);
+    }
+}
+
+} // namespace Nexus
@@ -0,0 +1,204 @@
+#include "AudioSynth.h"
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace Nexus {
+
+namespace {
+constexpr float PI = 3.14159265f;
+constexpr float TWO_PI = 6.28318531f;
+// Highest filter cutoff as a fraction of the sample rate; the prewarped tangent blows up at half
+constexpr float MAX_CUTOFF = 0.45f;
+constexpr float MIN_CUTOFF = 10.0f;
+// Oscillator phase steps stay below this per frame, which the band-limiting corrections assume
+constexpr float MAX_INCREMENT = 0.45f;
+
+__m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// x - floor(x) for x >= 0
+__m128 Fraction(__m128 x) {
+    return _mm_sub_ps(x, _mm_cvtepi32_ps(_mm_cvttps_epi32(x)));
+}
+
+// Polynomial band-limited step: the correction that takes the aliasing out of a unit jump at
+// phase 0, for a phase t advancing dt a frame
+__m128 PolyBlep(__m128 t, __m128 dt) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 after = _mm_div_ps(t, dt);
+    const __m128 before = _mm_div_ps(_mm_sub_ps(t, one), dt);
+    // 2x - x^2 - 1 just after the jump, x^2 + 2x + 1 just before it
+    const __m128 rising = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(after, after), _mm_mul_ps(after, after)), one);
+    const __m128 falling = _mm_add_ps(_mm_add_ps(_mm_mul_ps(before, before), _mm_add_ps(before, before)), one);
+    const __m128 isAfter = _mm_cmplt_ps(t, dt);
+    const __m128 isBefore = _mm_cmpgt_ps(t, _mm_sub_ps(one, dt));
+    return _mm_or_ps(_mm_and_ps(isAfter, rising), _mm_and_ps(isBefore, falling));
+}
+
+// sin(2 pi t) for t in [0, 1), a parabola refined to within 0.1%
+__m128 Sine(__m128 t) {
+    const __m128 x = _mm_sub_ps(_mm_add_ps(t, t), _mm_set1_ps(1.0f));
+    const __m128 absX = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+    __m128 y = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(4.0f), x), _mm_sub_ps(_mm_set1_ps(1.0f), absX));
+    const __m128 absY = _mm_andnot_ps(_mm_set1_ps(-0.0f), y);
+    y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.225f), _mm_sub_ps(_mm_mul_ps(y, absY), y)), y);
+    // sin(2 pi t) = -sin(pi x)
+    return _mm_xor_ps(y, _mm_set1_ps(-0.0f));
+}
+
+__m128 Oscillate(AudioWaveform waveform, __m128 t, __m128 dt) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    switch (waveform) {
+    case AudioWaveform::Square: {
+        // The falling edge's phase from the same comparison as the level, so they agree at 0.5
+        const __m128 first = _mm_cmplt_ps(t, half);
+        const __m128 naive = Select(first, one, _mm_set1_ps(-1.0f));
+        const __m128 fall = PolyBlep(Select(first, _mm_add_ps(t, half), _mm_sub_ps(t, half)), dt);
+        return _mm_sub_ps(_mm_add_ps(naive, PolyBlep(t, dt)), fall);
+    }
+    case AudioWaveform::Sawtooth:
+        return _mm_sub_ps(_mm_sub_ps(_mm_add_ps(t, t), one), PolyBlep(t, dt));
+    case AudioWaveform::Triangle: {
+        const __m128 distance = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(t, half));
+        return _mm_sub_ps(one, _mm_mul_ps(_mm_set1_ps(4.0f), distance));
+    }
+    default:
+        return Sine(t);
+    }
+}
+
+// Four xorshift32 generators, as floats in [-1, 1)
+__m128 Noise(__m128i& state) {
+    __m128i x = state;
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    state = x;
+    // The top 23 bits as the mantissa of a float in [1, 2)
+    const __m128i bits = _mm_or_si128(_mm_srli_epi32(x, 9), _mm_set1_epi32(0x3F800000));
+    return _mm_sub_ps(_mm_mul_ps(_mm_castsi128_ps(bits), _mm_set1_ps(2.0f)), _mm_set1_ps(3.0f));
+}
+}
+
+void AudioSynthVoice::Start(const AudioSynth& synth, uint32_t seed) {
+    patch = synth;
+    frequency = synth.frequency;
+    cutoff = synth.cutoff;
+    phase = 0.0f;
+    modPhase = 0.0f;
+    low = 0.0f;
+    band = 0.0f;
+    // Distinct and never zero, or a lane would stay silent
+    for (uint32_t i = 0; i < 4; ++i) noise[i] = ((seed * 4 + i + 1) * 2654435761u) | 1u;
+}
+
+double AudioSynthVoice::GetLength(const AudioSynth& synth, float sampleRate) {
+    if (synth.sustain > 0.0f) return 0.0;
+    return std::max(double(std::max(synth.attack, 0.0f) + std::max(synth.decay, 0.0f)) * sampleRate, 1.0);
+}
+
+uint32_t AudioSynthVoice::Render(float* output, uint32_t frameCount, double elapsed, float rate, float sampleRate) {
+    const float attackFrames = std::max(patch.attack * sampleRate, 1.0f);
+    const float decayFrames = std::max(patch.decay * sampleRate, 1.0f);
+    const float sustain = std::clamp(patch.sustain, 0.0f, 1.0f);
+    const float depth = std::max(patch.modDepth, 0.0f);
+    const bool filtered = patch.cutoff > 0.0f;
+    const float damping = 2.0f - 1.98f * std::clamp(patch.resonance, 0.0f, 1.0f);
+
+    // Past the decay the envelope holds, so float time is only needed for the first seconds
+    const __m128 ramp = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 attackScale = _mm_set1_ps(1.0f / attackFrames);
+    const __m128 attackEnd = _mm_set1_ps(attackFrames);
+    const __m128 decaySlope = _mm_set1_ps((1.0f - sustain) / decayFrames);
+    const __m128 sustainLevel = _mm_set1_ps(sustain);
+    const __m128 tone = _mm_set1_ps(patch.tone);
+    const __m128 noiseLevel = _mm_set1_ps(patch.noise);
+    const double envelopeEnd = double(attackFrames) + decayFrames;
+    const bool sustained = elapsed >= envelopeEnd;
+    __m128i noiseState = _mm_loadu_si128(reinterpret_cast<const __m128i*>(noise));
+
+    const float startFrequency = frequency;
+    const float startCutoff = cutoff > 0.0f ? cutoff : patch.cutoff;
+    const float endCutoff = patch.cutoff;
+    alignas(16) float signal[CONTROL_FRAMES];
+    for (uint32_t first = 0; first < frameCount; first += CONTROL_FRAMES) {
+        const uint32_t count = std::min(CONTROL_FRAMES, frameCount - first);
+        const float glide = float(first + count) / frameCount;
+
+        const float lfo = depth > 0.0f ? std::sin(TWO_PI * modPhase) : 0.0f;
+        modPhase += patch.modRate * count / sampleRate;
+        modPhase -= std::floor(modPhase);
+        const float pitchMod = patch.modTarget == AudioSynthTarget::Pitch ? std::exp2(depth * lfo) : 1.0f;
+        const float cutoffMod = patch.modTarget == AudioSynthTarget::Cutoff ? std::exp2(depth * lfo) : 1.0f;
+        const float volumeMod = patch.modTarget == AudioSynthTarget::Volume
+                                    ? std::max(1.0f - depth * 0.5f * (1.0f + lfo), 0.0f) : 1.0f;
+
+        // Oscillator and noise
+        const float hz = (startFrequency + (patch.frequency - startFrequency) * glide) * rate * pitchMod;
+        const float increment = std::clamp(hz / sampleRate, 0.0f, MAX_INCREMENT);
+        const __m128 dt = _mm_set1_ps(std::max(increment, 1e-7f));
+        for (uint32_t f = 0; f < count; f += 4) {
+            __m128 x = _mm_setzero_ps();
+            if (patch.tone != 0.0f) {
+                const __m128 t = Fraction(_mm_add_ps(_mm_set1_ps(phase), _mm_mul_ps(ramp, dt)));
+                x = _mm_mul_ps(Oscillate(patch.waveform, t, dt), tone);
+                phase += increment * 4.0f;
+                phase -= std::floor(phase);
+            }
+            if (patch.noise != 0.0f) x = _mm_add_ps(x, _mm_mul_ps(Noise(noiseState), noiseLevel));
+            _mm_store_ps(signal + f, x);
+        }
+
+        // Filter, recursive so a frame at a time
+        if (filtered) {
+            const float hzCutoff = (startCutoff + (endCutoff - startCutoff) * glide) * cutoffMod;
+            const float g = std::tan(PI * std::clamp(hzCutoff, MIN_CUTOFF, sampleRate * MAX_CUTOFF) / sampleRate);
+            const float a1 = 1.0f / (1.0f + g * (g + damping));
+            const float a2 = g * a1;
+            const float a3 = g * a2;
+            for (uint32_t f = 0; f < count; ++f) {
+                const float input = signal[f];
+                const float v3 = input - low;
+                const float v1 = a1 * band + a2 * v3;
+                const float v2 = low + a2 * band + a3 * v3;
+                band = 2.0f * v1 - band;
+                low = 2.0f * v2 - low;
+                switch (patch.filter) {
+                case AudioSynthFilter::BandPass: signal[f] = v1; break;
+                case AudioSynthFilter::HighPass: signal[f] = input - damping * v1 - v2; break;
+                default: signal[f] = v2; break;
+                }
+            }
+        }
+
+        // Envelope: up over the attack, down to the sustain over the decay
+        const __m128 gain = _mm_set1_ps(volumeMod);
+        for (uint32_t f = 0; f < count; f += 4) {
+            __m128 envelope = sustainLevel;
+            if (!sustained) {
+                const __m128 t = _mm_add_ps(_mm_set1_ps(float(elapsed) + float(first + f)), ramp);
+                const __m128 rising = _mm_mul_ps(t, attackScale);
+                const __m128 falling = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_sub_ps(t, attackEnd), decaySlope));
+                envelope = Select(_mm_cmplt_ps(t, attackEnd), rising, _mm_max_ps(falling, sustainLevel));
+            }
+            _mm_storeu_ps(output + first + f, _mm_mul_ps(_mm_load_ps(signal + f), _mm_mul_ps(envelope, gain)));
+        }
+    }
+
+    frequency = patch.frequency;
+    cutoff = endCutoff;
+    if (!filtered) {
+        low = 0.0f;
+        band = 0.0f;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(noise), noiseState);
+
+    const double length = GetLength(patch, sampleRate);
+    if (length <= 0.0 || elapsed + frameCount <= length) return frameCount;
+    return static_cast<uint32_t>(std::max(std::ceil(length - elapsed), 0.0));
+}
+
+} // namespace Nexus
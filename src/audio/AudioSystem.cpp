@@ -1,12 +1,135 @@
 #include "AudioSystem.h"
+#include "JobSystem.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
 #include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <limits>
 #include <memory>
+#include <thread>
 
 namespace Nexus {
 
+namespace {
+// Blocks queued on the output voice at once; each adds BLOCK_FRAMES of latency
+constexpr uint32_t OUTPUT_BLOCKS = 3;
+// The mixer thread wakes at least this often even if the device stalls
+constexpr DWORD OUTPUT_WAIT_MS = 100;
+// Voices fade over this long when virtualized or realized mid-sound, short enough not to smear
+// transients and long enough not to click
+constexpr float VOICE_FADE_SECONDS = 0.03f;
+// Rank multipliers by AudioPriority; Critical sources are never virtualized
+constexpr float PRIORITY_WEIGHTS[] = { 0.5f, 1.0f, 2.0f, 4.0f };
+// Resampler quality by AudioPriority; sinc costs several times what linear does, so it goes to
+// the sounds that are listened to
+constexpr AudioResampleQuality RESAMPLE_QUALITIES[] = {
+    AudioResampleQuality::Linear, AudioResampleQuality::Cubic, AudioResampleQuality::Sinc, AudioResampleQuality::Sinc
+};
+// A real voice needs to be outranked by this much to lose its voice, so near ties don't flap
+constexpr float REAL_VOICE_BONUS = 1.25f;
+// Occlusion rays aim this far around a source, in these directions in turn, so cover that hides
+// part of it occludes it partly
+constexpr float OCCLUSION_SPREAD = 0.35f;
+constexpr float OCCLUSION_AIMS[][3] = {
+    { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },
+    { -1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }
+};
+// Hits this close to the source are on whatever it is attached to
+constexpr float OCCLUSION_SOURCE_CLEARANCE = 0.25f;
+// How far one ray moves a source's target, so a few have to agree before it commits
+constexpr float OCCLUSION_RAY_WEIGHT = 0.35f;
+// Rays a source may save up, so a long frame doesn't cast a burst
+constexpr float OCCLUSION_MAX_RAYS = 4.0f;
+// Occlusion eases most of the way to its target over this long
+constexpr float OCCLUSION_SMOOTHING_SECONDS = 0.12f;
+// Low-pass cutoff as absorption goes from none to total, interpolated in octaves
+constexpr float OCCLUSION_OPEN_CUTOFF = 20000.0f;
+constexpr float OCCLUSION_CLOSED_CUTOFF = 500.0f;
+// Smaller steps aren't sent to the renderer
+constexpr float OCCLUSION_EPSILON = 1e-3f;
+
+AudioClip MakeClip(const AudioSystem::AudioBuffer& buffer) {
+    AudioClip clip = {};
+    switch (buffer.format) {
+    case AudioSystem::AudioFormat::PCM_8: clip.bitsPerSample = 8; break;
+    case AudioSystem::AudioFormat::PCM_16: clip.bitsPerSample = 16; break;
+    case AudioSystem::AudioFormat::PCM_24: clip.bitsPerSample = 24; break;
+    case AudioSystem::AudioFormat::PCM_32: clip.bitsPerSample = 32; break;
+    case AudioSystem::AudioFormat::Float32: clip.bitsPerSample = 32; clip.isFloat = true; break;
+    default: return clip;                      // Compressed data can't be mixed directly
+    }
+    if (buffer.channels <= 0 || buffer.sampleRate <= 0 || buffer.GetByteCount() == 0) return clip;
+
+    clip.data = buffer.GetBytes();
+    clip.channels = static_cast<uint16_t>(buffer.channels);
+    clip.sampleRate = static_cast<uint32_t>(buffer.sampleRate);
+    clip.frameCount = static_cast<uint32_t>(std::min(buffer.dataSize, buffer.GetByteCount()) /
+                                            (size_t(buffer.channels) * clip.bitsPerSample / 8));
+    return clip;
+}
+
+struct EnvironmentPreset {
+    const char* name;
+    float roomSize;
+    float decayTime;
+    float decayHFRatio;
+    float reflectionsDelay;
+    float reverbDelay;
+    float diffusion;
+    float level;
+};
+
+// Loosely after the EAX presets of the same names
+constexpr EnvironmentPreset ENVIRONMENT_PRESETS[] = {
+    { "Generic", 7.5f, 1.49f, 0.83f, 0.007f, 0.011f, 1.0f, 0.3f },
+    { "Room", 2.9f, 0.4f, 0.83f, 0.002f, 0.003f, 1.0f, 0.25f },
+    { "Bathroom", 1.4f, 1.49f, 0.54f, 0.007f, 0.011f, 1.0f, 0.45f },
+    { "Hall", 19.6f, 3.92f, 0.7f, 0.02f, 0.029f, 1.0f, 0.35f },
+    { "Cave", 14.6f, 2.91f, 1.3f, 0.015f, 0.022f, 1.0f, 0.4f },
+    { "Arena", 36.2f, 7.24f, 0.33f, 0.02f, 0.03f, 1.0f, 0.35f },
+    { "Forest", 38.0f, 1.49f, 0.54f, 0.162f, 0.088f, 0.79f, 0.15f },
+};
+
+std::vector<float> Resample(const AudioResampler& resampler, const std::vector<float>& samples, int fromRate, int toRate) {
+    if (fromRate == toRate || samples.empty()) return samples;
+    double rate = double(fromRate) / toRate;
+    // Silence either side for the kernel's taps to run off into
+    std::vector<float> padded(samples.size() + AudioResampler::TAPS * 2, 0.0f);
+    std::copy(samples.begin(), samples.end(), padded.begin() + AudioResampler::TAPS);
+    std::vector<float> resampled(static_cast<size_t>(samples.size() / rate));
+    resampler.Process(AudioResampleQuality::Sinc, padded.data(), nullptr, AudioResampler::TAPS, rate,
+                      resampled.data(), nullptr, static_cast<uint32_t>(resampled.size()));
+    return resampled;
+}
+
+// Every channel of buffer as floats, empty if it isn't PCM
+std::vector<std::vector<float>> DecodeChannels(const AudioSystem::AudioBuffer& buffer) {
+    std::vector<std::vector<float>> channels;
+    AudioClip clip = MakeClip(buffer);
+    if (!clip.data) return channels;
+    for (uint16_t c = 0; c < clip.channels; ++c) channels.push_back(DecodeClip(clip, c));
+    return channels;
+}
+}
+
+// Wakes the mixer thread each time the device finishes a block. XAudio2 calls it on its own
+// processing thread, which must not be held up by mixing
+struct AudioSystem::OutputCallback : public IXAudio2VoiceCallback {
+    HANDLE bufferEnd;
+
+    OutputCallback() : bufferEnd(CreateEvent(nullptr, FALSE, FALSE, nullptr)) {}
+    ~OutputCallback() { CloseHandle(bufferEnd); }
+
+    void STDMETHODCALLTYPE OnBufferEnd(void*) override { SetEvent(bufferEnd); }
+    void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32) override {}
+    void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
+    void STDMETHODCALLTYPE OnStreamEnd() override {}
+    void STDMETHODCALLTYPE OnBufferStart(void*) override {}
+    void STDMETHODCALLTYPE OnLoopEnd(void*) override {}
+    void STDMETHODCALLTYPE OnVoiceError(void*, HRESULT) override {}
+};
+
 // Constructor
 AudioSystem::AudioSystem()
     : xaudio2_(nullptr)
@@ -28,10 +151,16 @@ AudioSystem::AudioSystem()
     , channelLayout_(AudioChannelLayout::Stereo)
     , maxVoices_(64)
     , voiceVirtualizationEnabled_(true)
+    , hrtfEnabled_(false)
+    , hrtfVoiceLimit_(static_cast<int>(HRTFSpatializer::DEFAULT_NEAR_VOICES))
+    , physics_(nullptr)
+    , jobs_(nullptr)
     , streamingEnabled_(true)
     , occlusionEnabled_(false)
     , profilingEnabled_(false)
     , isRunning_(false)
+    , outputVoice_(nullptr)
+    , mixerRunning_(false)
     , cpuUsage_(0.0f)
     , memoryUsage_(0.0f)
     , activeVoices_(0)
@@ -40,9 +169,19 @@ AudioSystem::AudioSystem()
     listener_ = std::make_unique<AudioListener>();
     mixer_ = std::make_unique<AudioMixer>();
     streaming_ = std::make_unique<AudioStreaming>();
+    streaming_->bufferFrames = AudioStreamer::DEFAULT_BUFFER_FRAMES;
+    streaming_->readChunkBytes = 64 * 1024;
+    streaming_->readChunkCount = 4;
+    streaming_->decoderThreads = 2;
+    streaming_->streamer = std::make_unique<AudioStreamer>();
     occlusion_ = std::make_unique<AudioOcclusion>();
+    occlusion_->counter = std::make_unique<JobCounter>();
+    occlusion_->materialNames.push_back("Default");
+    occlusion_->materials.push_back({ 0.6f, 0.3f });
     drc_ = std::make_unique<DynamicRangeCompression>();
     analytics_ = std::make_unique<AudioAnalytics>();
+    renderer_ = std::make_unique<AudioRenderer>();
+    resampler_.Prepare();
     
     // Initialize listener
     listener_->position = XMFLOAT3(0.0f, 0.0f, 0.0f);
@@ -68,6 +207,7 @@ AudioSystem::~AudioSystem() {
 
 // Initialize the audio system
 bool AudioSystem::Initialize(int sampleRate, int channels, int bufferSize, AudioChannelLayout layout) {
+    NEXUS_MEMORY_SCOPE(MemoryTag::Audio);
     sampleRate_ = sampleRate;
     channels_ = channels;
     bufferSize_ = bufferSize;
@@ -98,6 +238,33 @@ bool AudioSystem::Initialize(int sampleRate, int channels, int bufferSize, Audio
     masteringVoice_->GetChannelMask(&channelMask);
     X3DAudioInitialize(channelMask, X3DAUDIO_SPEED_OF_SOUND, x3dAudioHandle_);
     
+    // Software mixer and its voices
+    if (!renderer_->Initialize(sampleRate_, channels_)) {
+        Logger::Error("Failed to initialize audio renderer");
+        return false;
+    }
+    voiceSlots_.assign(AudioRenderer::MAX_VOICES, VoiceSlot{ nullptr, nullptr, nullptr, 0, false });
+    freeVoices_.clear();
+    for (uint32_t voice = AudioRenderer::MAX_VOICES; voice > 0; --voice) {
+        freeVoices_.push_back(voice - 1);
+    }
+    freeBuses_.clear();
+    for (uint32_t bus = AudioRenderer::MAX_BUSES - 1; bus > AudioRenderer::MASTER_BUS; --bus) {
+        freeBuses_.push_back(bus);
+    }
+    AudioCommand master = {};
+    master.type = AudioCommandType::SetMasterVolume;
+    master.values[0] = masterVolume_;
+    SendCommand(master);
+    EnableHRTF(hrtfEnabled_);
+    renderer_->Flush();
+    RegisterDefaultEnvironments();
+    streaming_->streamer->Start(streaming_->decoderThreads);
+    
+    if (!StartOutput()) {
+        return false;
+    }
+    
     isRunning_ = true;
     Logger::Info("Audio system initialized successfully");
     return true;
@@ -106,16 +273,29 @@ bool AudioSystem::Initialize(int sampleRate, int channels, int bufferSize, Audio
 // Shutdown the audio system
 void AudioSystem::Shutdown() {
     isRunning_ = false;
+    WaitForOcclusionRays();
     
     // Stop all sounds
     StopAllSounds();
     
+    // The renderer lets go of every clip once its thread is gone
+    StopOutput();
+    voiceSlots_.clear();
+    freeVoices_.clear();
+    freeBuses_.clear();
+    streaming_->streamer->Stop();
+    
     // Clean up audio sources
     audioSources_.clear();
     audioBuffers_.clear();
+    bankClips_.clear();
+    soundBanks_.clear();
     audioGroups_.clear();
     audioEffects_.clear();
+    masterEffects_.clear();
     audioEnvironments_.clear();
+    impulseResponses_.clear();
+    currentEnvironment_.clear();
     
     // Clean up legacy maps
     sounds_.clear();
@@ -142,18 +322,19 @@ void AudioSystem::Shutdown() {
 void AudioSystem::Update(float deltaTime) {
     if (!isRunning_) return;
     
-    // Update 3D audio calculations
-    Process3DAudio();
+    // Sources and reverbs the renderer has finished with
+    ProcessVoiceEvents();
+    renderer_->CollectConvolutions();
+    renderer_->CollectBusChains();
     
-    // Update streaming sources
-    UpdateStreamingSources();
+    // Occlusion first, so voices are ranked on what can be heard through it
+    ProcessOcclusion(deltaTime);
     
-    // Process fading
-    for (auto& [name, source] : audioSources_) {
-        if (source->isFading) {
-            ProcessFading(source, deltaTime);
-        }
-    }
+    // Hand the voices to the sources that matter most right now
+    UpdateVoiceBudget(deltaTime);
+    
+    // Everything this frame asked of the audio thread lands together
+    renderer_->Flush();
     
     // Update analytics
     if (analytics_) {
@@ -227,13 +408,11 @@ AudioSystem::SoundInstanceID AudioSystem::PlaySound(SoundID soundId, float volum
         if (source) {
             source->volume = volume;
             source->isLooping = looping;
-            source->isPlaying = true;
-            CreateSourceVoice(source);
             PlaySound("instance_" + std::to_string(instanceId));
         }
     }
     
-    Logger::Info("Playing sound: " + it->second);
+    NEXUS_LOG_DEBUG("Playing sound: {}", it->second);
     return instanceId;
 }
 
@@ -261,8 +440,6 @@ AudioSystem::SoundInstanceID AudioSystem::PlaySound3D(SoundID soundId, const Dir
             source->velocity = velocity;
             source->minDistance = 1.0f;
             source->maxDistance = 100.0f;
-            source->isPlaying = true;
-            CreateSourceVoice(source);
             PlaySound("instance_" + std::to_string(instanceId));
         }
     }
@@ -270,14 +447,51 @@ AudioSystem::SoundInstanceID AudioSystem::PlaySound3D(SoundID soundId, const Dir
     return instanceId;
 }
 
+// Clips are found by ID, with no path to compare or hash
+AudioSystem::SoundInstanceID AudioSystem::PlayClip(SoundClipID clip, float volume, bool looping) {
+    auto buffer = GetClip(clip);
+    if (!buffer) {
+        Logger::Error("Sound clip not found: " + std::to_string(clip));
+        return 0;
+    }
+
+    SoundInstanceID instanceId = nextSoundInstanceId_++;
+    soundInstances_[instanceId] = buffer->name;
+    
+    std::string name = "instance_" + std::to_string(instanceId);
+    auto source = CreateAudioSource(name, buffer);
+    source->volume = volume;
+    source->isLooping = looping;
+    PlaySound(name);
+    return instanceId;
+}
+
+AudioSystem::SoundInstanceID AudioSystem::PlayClip3D(SoundClipID clip, const DirectX::XMFLOAT3& position,
+                                                      const DirectX::XMFLOAT3& velocity, float volume, bool looping) {
+    auto buffer = GetClip(clip);
+    if (!buffer) {
+        Logger::Error("Sound clip not found: " + std::to_string(clip));
+        return 0;
+    }
+
+    SoundInstanceID instanceId = nextSoundInstanceId_++;
+    soundInstances_[instanceId] = buffer->name;
+    
+    std::string name = "instance_" + std::to_string(instanceId);
+    auto source = CreateAudioSource(name, buffer);
+    source->volume = volume;
+    source->isLooping = looping;
+    source->is3D = true;
+    source->position = position;
+    source->velocity = velocity;
+    PlaySound(name);
+    return instanceId;
+}
+
 void AudioSystem::StopSound(SoundInstanceID instanceId) {
     auto it = soundInstances_.find(instanceId);
     if (it != soundInstances_.end()) {
-        auto source = GetAudioSource("instance_" + std::to_string(instanceId));
-        if (source && source->sourceVoice) {
-            source->sourceVoice->Stop();
-            source->isPlaying = false;
-        }
+        StopSound("instance_" + std::to_string(instanceId));
         soundInstances_.erase(it);
     }
 }
@@ -307,25 +521,41 @@ void AudioSystem::SetSoundVelocity(SoundInstanceID instanceId, const DirectX::XM
 
 void AudioSystem::ApplyDistortionEffect(SoundInstanceID instanceId, float amount, float edge) {
     // Legacy method - could be implemented using the new effect system
-    Logger::Info("Distortion effect applied to instance: " + std::to_string(instanceId));
+    NEXUS_LOG_DEBUG("Distortion effect applied to instance: {}", instanceId);
 }
 
 void AudioSystem::ApplyEcho(SoundInstanceID instanceId, float delay, float feedback) {
     // Legacy method - could be implemented using the new effect system
-    Logger::Info("Echo effect applied to instance: " + std::to_string(instanceId));
+    NEXUS_LOG_DEBUG("Echo effect applied to instance: {}", instanceId);
 }
 
 void AudioSystem::StartStreaming(const std::string& filePath, float volume, bool looping) {
-    streamingSounds_.push_back(filePath);
-    
-    // Create streaming source
     auto buffer = std::make_shared<AudioBuffer>();
-    buffer->name = filePath;
-    buffer->format = AudioFormat::PCM_16;
-    buffer->sampleRate = sampleRate_;
-    buffer->channels = channels_;
+    AudioSourceType type = AudioSourceType::Streaming;
+    if (streamingEnabled_) {
+        // Only the header is read now, for the format and length; the rest comes as it plays
+        OverlappedFileSource file(filePath, streaming_->readChunkBytes, streaming_->readChunkCount);
+        AudioStreamInfo info = {};
+        if (!file.IsOpen() || !streaming_->streamer->Probe(file, info)) {
+            Logger::Error("Could not stream audio file: " + filePath);
+            return;
+        }
+        buffer->name = filePath;
+        buffer->format = AudioFormat::Float32;
+        buffer->sampleRate = static_cast<int>(info.sampleRate);
+        buffer->channels = info.channels;
+        buffer->bitsPerSample = 32;
+        buffer->dataSize = 0;
+        buffer->duration = static_cast<float>(double(info.frameCount) / info.sampleRate);
+        buffer->isCompressed = false;
+    } else {
+        buffer = LoadAudioFile(filePath);
+        if (!buffer) return;
+        type = AudioSourceType::Static;
+    }
+    streamingSounds_.push_back(filePath);
     
-    auto source = CreateAudioSource(filePath, buffer, AudioSourceType::Streaming);
+    auto source = CreateAudioSource(filePath, buffer, type);
     if (source) {
         source->volume = volume;
         source->isLooping = looping;
@@ -370,6 +600,14 @@ std::shared_ptr<AudioSystem::AudioBuffer> AudioSystem::LoadAudioFile(const std::
         return nullptr;
     }
     
+    // Clips play at the mix rate, so the renderer only resamples them for pitch and Doppler.
+    // Compressed clips decode at their own rate and are resampled as they play
+    if (buffer && !buffer->isCompressed && buffer->sampleRate != sampleRate_ && MakeClip(*buffer).data) {
+        auto converted = std::make_shared<AudioBuffer>();
+        ResampleAudio(*buffer, *converted, sampleRate_);
+        if (!converted->data.empty()) buffer = converted;
+    }
+    
     if (buffer) {
         audioBuffers_[filePath] = buffer;
     }
@@ -409,6 +647,82 @@ std::shared_ptr<AudioSystem::AudioBuffer> AudioSystem::GetAudioBuffer(const std:
     return (it != audioBuffers_.end()) ? it->second : nullptr;
 }
 
+// Sound banks
+bool AudioSystem::LoadSoundBank(const std::string& filePath) {
+    if (soundBanks_.count(filePath)) return true;
+
+    auto bank = std::make_shared<SoundBank>();
+    if (!bank->Open(filePath)) return false;
+
+    // Buffers only describe the clips; their data stays in the mapping
+    uint32_t converted = 0;
+    for (uint32_t i = 0; i < bank->GetClipCount(); ++i) {
+        const SoundBankClip& clip = bank->GetClip(i);
+        auto buffer = std::make_shared<AudioBuffer>();
+        buffer->name = bank->GetName(clip);
+        buffer->sampleRate = static_cast<int>(clip.sampleRate);
+        buffer->channels = clip.channels;
+        buffer->dataSize = static_cast<size_t>(clip.size);
+        buffer->duration = static_cast<float>(double(clip.frameCount) / clip.sampleRate);
+        buffer->bank = bank;
+        buffer->mappedData = bank->GetData(clip);
+        switch (clip.encoding) {
+        case SoundBankEncoding::PCM:
+            buffer->format = clip.bitsPerSample == 8 ? AudioFormat::PCM_8 :
+                             clip.bitsPerSample == 16 ? AudioFormat::PCM_16 :
+                             clip.bitsPerSample == 24 ? AudioFormat::PCM_24 : AudioFormat::PCM_32;
+            break;
+        case SoundBankEncoding::Float: buffer->format = AudioFormat::Float32; break;
+        case SoundBankEncoding::ADPCM: buffer->format = AudioFormat::Compressed_ADPCM; break;
+        case SoundBankEncoding::Vorbis: buffer->format = AudioFormat::Compressed_OGG; break;
+        }
+        buffer->isCompressed = clip.encoding == SoundBankEncoding::ADPCM || clip.encoding == SoundBankEncoding::Vorbis;
+        buffer->bitsPerSample = buffer->isCompressed ? 32 : clip.bitsPerSample;
+        buffer->originalSize = size_t(clip.frameCount) * clip.channels * (buffer->bitsPerSample / 8);
+        buffer->compressionRatio = buffer->dataSize > 0 ? float(buffer->originalSize) / buffer->dataSize : 1.0f;
+
+        // As with loose files, samples are mixed at the mix rate. A bank built at it needs no copies
+        if (!buffer->isCompressed && buffer->sampleRate != sampleRate_) {
+            auto resampled = std::make_shared<AudioBuffer>();
+            ResampleAudio(*buffer, *resampled, sampleRate_);
+            if (!resampled->data.empty()) {
+                buffer = resampled;
+                converted++;
+            }
+        }
+
+        if (!bankClips_.insert_or_assign(clip.id, buffer).second) {
+            Logger::Warning("Sound bank " + filePath + " replaces clip " + buffer->name);
+        }
+    }
+    if (converted > 0) {
+        Logger::Warning("Sound bank " + filePath + " has " + std::to_string(converted) +
+                        " clips resampled to " + std::to_string(sampleRate_) + " Hz at load");
+    }
+
+    soundBanks_[filePath] = bank;
+    Logger::Info("Loaded sound bank: " + filePath + " (" + std::to_string(bank->GetClipCount()) + " clips)");
+    return true;
+}
+
+void AudioSystem::UnloadSoundBank(const std::string& filePath) {
+    auto it = soundBanks_.find(filePath);
+    if (it == soundBanks_.end()) return;
+
+    // Only the clips still from this bank; later banks may have replaced some
+    const SoundBank& bank = *it->second;
+    for (uint32_t i = 0; i < bank.GetClipCount(); ++i) {
+        auto clip = bankClips_.find(bank.GetClip(i).id);
+        if (clip != bankClips_.end() && clip->second->bank == it->second) bankClips_.erase(clip);
+    }
+    soundBanks_.erase(it);
+}
+
+std::shared_ptr<AudioSystem::AudioBuffer> AudioSystem::GetClip(SoundClipID clip) const {
+    auto it = bankClips_.find(clip);
+    return (it != bankClips_.end()) ? it->second : nullptr;
+}
+
 // Audio source management
 std::shared_ptr<AudioSystem::AudioSource> AudioSystem::CreateAudioSource(const std::string& name, 
                                                                          std::shared_ptr<AudioBuffer> buffer,
@@ -416,6 +730,7 @@ std::shared_ptr<AudioSystem::AudioSource> AudioSystem::CreateAudioSource(const s
     auto source = std::make_shared<AudioSource>();
     source->name = name;
     source->buffer = buffer;
+    source->synth = AudioSynth{};
     source->type = type;
     source->priority = AudioPriority::Medium;
     source->volume = 1.0f;
@@ -430,18 +745,60 @@ std::shared_ptr<AudioSystem::AudioSource> AudioSystem::CreateAudioSource(const s
     source->direction = XMFLOAT3(0.0f, 0.0f, 1.0f);
     source->minDistance = 1.0f;
     source->maxDistance = 100.0f;
-    source->sourceVoice = nullptr;
+    source->rolloffFactor = 1.0f;
+    source->coneInnerAngle = 360.0f;
+    source->coneOuterAngle = 360.0f;
+    source->coneOuterGain = 1.0f;
+    source->occlusion = 0.0f;
+    source->lowPass = 0.0f;
+    source->occlusionTarget = 0.0f;
+    source->absorptionTarget = 0.0f;
+    source->absorption = 0.0f;
+    source->rayCredit = 0.0f;
+    source->rayIndex = 0;
+    source->voice = INVALID_VOICE;
+    source->bus = AudioRenderer::MASTER_BUS;
+    source->isVirtual = false;
+    source->playbackPosition = 0.0;
+    source->audibility = 1.0f;
+    source->fadeVolume = 1.0f;
+    source->fadeSpeed = 0.0f;
+    source->isFading = false;
     
     audioSources_[name] = source;
     return source;
 }
 
+std::shared_ptr<AudioSystem::AudioSource> AudioSystem::CreateProceduralSource(const std::string& name,
+                                                                             const AudioSynth& synth) {
+    auto source = CreateAudioSource(name, nullptr, AudioSourceType::Generated);
+    source->synth = synth;
+    return source;
+}
+
+void AudioSystem::SetSynthParameter(const std::string& sourceName, AudioVoiceParam param, float value) {
+    auto source = GetAudioSource(sourceName);
+    if (!source || source->type != AudioSourceType::Generated) return;
+
+    // Kept on the source too, so a voice it gets back after being virtualized sounds the same
+    AudioSynth& synth = source->synth;
+    switch (param) {
+    case AudioVoiceParam::Frequency: synth.frequency = value; break;
+    case AudioVoiceParam::Tone: synth.tone = value; break;
+    case AudioVoiceParam::Noise: synth.noise = value; break;
+    case AudioVoiceParam::Cutoff: synth.cutoff = value; break;
+    case AudioVoiceParam::Resonance: synth.resonance = value; break;
+    case AudioVoiceParam::ModRate: synth.modRate = value; break;
+    case AudioVoiceParam::ModDepth: synth.modDepth = value; break;
+    default: return;
+    }
+    SendVoiceParam(*source, param, value);
+}
+
 void AudioSystem::DestroyAudioSource(const std::string& name) {
     auto it = audioSources_.find(name);
     if (it != audioSources_.end()) {
-        if (it->second->sourceVoice) {
-            it->second->sourceVoice->DestroyVoice();
-        }
+        StopVoice(*it->second);
         audioSources_.erase(it);
     }
 }
@@ -454,39 +811,64 @@ std::shared_ptr<AudioSystem::AudioSource> AudioSystem::GetAudioSource(const std:
 // Playback control
 void AudioSystem::PlaySound(const std::string& sourceName) {
     auto source = GetAudioSource(sourceName);
-    if (source && source->buffer) {
-        CreateSourceVoice(source);
-        source->isPlaying = true;
-        if (source->sourceVoice) {
-            source->sourceVoice->Start();
+    const bool synthesized = source && source->type == AudioSourceType::Generated;
+    if (!source || (!source->buffer && !synthesized)) return;
+
+    if (source->isPaused && source->voice != INVALID_VOICE) {
+        AudioCommand command = {};
+        command.type = AudioCommandType::Resume;
+        command.voice = source->voice;
+        SendCommand(command);
+    } else if (source->isPaused && source->isVirtual) {
+        // Carries on from its tracked position once it ranks for a voice
+    } else {
+        source->playbackPosition = 0.0;
+        if (source->voice != INVALID_VOICE) {
+            // Restarting keeps the voice it has
+            if (!StartVoice(*source)) return;
+        } else {
+            // The next Update gives it a voice if it ranks for one
+            bool decoded = synthesized || source->buffer->isCompressed || source->type == AudioSourceType::Streaming;
+            if (!decoded && !MakeClip(*source->buffer).data) {
+                Logger::Warning("Audio buffer can't be played: " + source->buffer->name);
+                return;
+            }
+            source->isVirtual = true;
         }
     }
+    source->isPlaying = true;
+    source->isPaused = false;
 }
 
 void AudioSystem::PauseSound(const std::string& sourceName) {
     auto source = GetAudioSource(sourceName);
-    if (source && source->sourceVoice) {
-        source->sourceVoice->Stop();
-        source->isPaused = true;
+    if (!source || !source->isPlaying) return;
+
+    if (source->voice != INVALID_VOICE) {
+        AudioCommand command = {};
+        command.type = AudioCommandType::Pause;
+        command.voice = source->voice;
+        SendCommand(command);
     }
+    source->isPaused = true;
 }
 
 void AudioSystem::StopSound(const std::string& sourceName) {
     auto source = GetAudioSource(sourceName);
-    if (source && source->sourceVoice) {
-        source->sourceVoice->Stop();
+    if (source) {
+        StopVoice(*source);
         source->isPlaying = false;
         source->isPaused = false;
+        source->isVirtual = false;
     }
 }
 
 void AudioSystem::StopAllSounds() {
     for (auto& [name, source] : audioSources_) {
-        if (source->sourceVoice) {
-            source->sourceVoice->Stop();
-        }
+        StopVoice(*source);
         source->isPlaying = false;
         source->isPaused = false;
+        source->isVirtual = false;
     }
 }
 
@@ -494,9 +876,7 @@ void AudioSystem::SetVolume(const std::string& sourceName, float volume) {
     auto source = GetAudioSource(sourceName);
     if (source) {
         source->volume = std::clamp(volume, 0.0f, 1.0f);
-        if (source->sourceVoice) {
-            source->sourceVoice->SetVolume(source->volume);
-        }
+        SendVoiceParam(*source, AudioVoiceParam::Volume, source->volume);
     }
 }
 
@@ -504,9 +884,7 @@ void AudioSystem::SetPitch(const std::string& sourceName, float pitch) {
     auto source = GetAudioSource(sourceName);
     if (source) {
         source->pitch = std::clamp(pitch, 0.5f, 2.0f);
-        if (source->sourceVoice) {
-            source->sourceVoice->SetFrequencyRatio(source->pitch);
-        }
+        SendVoiceParam(*source, AudioVoiceParam::Pitch, source->pitch);
     }
 }
 
@@ -514,6 +892,11 @@ void AudioSystem::SetLooping(const std::string& sourceName, bool looping) {
     auto source = GetAudioSource(sourceName);
     if (source) {
         source->isLooping = looping;
+        SendVoiceParam(*source, AudioVoiceParam::Looping, looping ? 1.0f : 0.0f);
+        // Streams loop by rewinding their decoder rather than the voice
+        if (source->voice != INVALID_VOICE && voiceSlots_[source->voice].stream) {
+            voiceSlots_[source->voice].stream->SetLooping(looping);
+        }
     }
 }
 
@@ -522,6 +905,7 @@ void AudioSystem::SetSource3D(const std::string& sourceName, bool is3D) {
     auto source = GetAudioSource(sourceName);
     if (source) {
         source->is3D = is3D;
+        SendVoiceParam(*source, AudioVoiceParam::Spatial, is3D ? 1.0f : 0.0f);
     }
 }
 
@@ -529,6 +913,7 @@ void AudioSystem::SetSourcePosition(const std::string& sourceName, const XMFLOAT
     auto source = GetAudioSource(sourceName);
     if (source) {
         source->position = position;
+        SendVoiceVector(*source, AudioCommandType::SetPosition, position);
     }
 }
 
@@ -536,6 +921,7 @@ void AudioSystem::SetSourceVelocity(const std::string& sourceName, const XMFLOAT
     auto source = GetAudioSource(sourceName);
     if (source) {
         source->velocity = velocity;
+        SendVoiceVector(*source, AudioCommandType::SetVelocity, velocity);
     }
 }
 
@@ -551,6 +937,8 @@ void AudioSystem::SetSourceDistance(const std::string& sourceName, float minDist
     if (source) {
         source->minDistance = minDistance;
         source->maxDistance = maxDistance;
+        SendVoiceParam(*source, AudioVoiceParam::MinDistance, minDistance);
+        SendVoiceParam(*source, AudioVoiceParam::MaxDistance, maxDistance);
     }
 }
 
@@ -563,6 +951,15 @@ void AudioSystem::SetSourceCone(const std::string& sourceName, float innerAngle,
     }
 }
 
+void AudioSystem::SetSourceOcclusion(const std::string& sourceName, float occlusion) {
+    auto source = GetAudioSource(sourceName);
+    if (source) {
+        source->occlusion = std::clamp(occlusion, 0.0f, 1.0f);
+        source->occlusionTarget = source->occlusion;
+        SendVoiceParam(*source, AudioVoiceParam::Occlusion, source->occlusion);
+    }
+}
+
 // Listener methods
 void AudioSystem::SetListenerPosition(const XMFLOAT3& position) {
     if (listener_) {
@@ -570,6 +967,13 @@ void AudioSystem::SetListenerPosition(const XMFLOAT3& position) {
     }
     // Update legacy compatibility
     listenerPosition_ = DirectX::XMFLOAT3(position.x, position.y, position.z);
+
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetListenerPosition;
+    command.values[0] = position.x;
+    command.values[1] = position.y;
+    command.values[2] = position.z;
+    SendCommand(command);
 }
 
 void AudioSystem::SetListenerVelocity(const XMFLOAT3& velocity) {
@@ -578,6 +982,13 @@ void AudioSystem::SetListenerVelocity(const XMFLOAT3& velocity) {
     }
     // Update legacy compatibility
     listenerVelocity_ = DirectX::XMFLOAT3(velocity.x, velocity.y, velocity.z);
+
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetListenerVelocity;
+    command.values[0] = velocity.x;
+    command.values[1] = velocity.y;
+    command.values[2] = velocity.z;
+    SendCommand(command);
 }
 
 void AudioSystem::SetListenerOrientation(const XMFLOAT3& forward, const XMFLOAT3& up) {
@@ -588,6 +999,16 @@ void AudioSystem::SetListenerOrientation(const XMFLOAT3& forward, const XMFLOAT3
     // Update legacy compatibility
     listenerOrientation_ = DirectX::XMFLOAT3(forward.x, forward.y, forward.z);
     listenerUpVector_ = DirectX::XMFLOAT3(up.x, up.y, up.z);
+
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetListenerOrientation;
+    command.values[0] = forward.x;
+    command.values[1] = forward.y;
+    command.values[2] = forward.z;
+    command.values[3] = up.x;
+    command.values[4] = up.y;
+    command.values[5] = up.z;
+    SendCommand(command);
 }
 
 void AudioSystem::SetMasterVolume(float volume) {
@@ -595,26 +1016,98 @@ void AudioSystem::SetMasterVolume(float volume) {
     if (listener_) {
         listener_->masterVolume = masterVolume_;
     }
-    if (masteringVoice_) {
-        masteringVoice_->SetVolume(masterVolume_);
-    }
+
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetMasterVolume;
+    command.values[0] = masterVolume_;
+    SendCommand(command);
 }
 
 // Audio groups
 std::shared_ptr<AudioSystem::AudioGroup> AudioSystem::CreateAudioGroup(const std::string& name) {
+    if (audioGroups_.count(name)) return audioGroups_[name];
+
     auto group = std::make_shared<AudioGroup>();
     group->name = name;
     group->volume = 1.0f;
     group->pitch = 1.0f;
     group->isMuted = false;
     group->isSolo = false;
+    group->isDucking = false;
+    group->duckingThreshold = 0.0f;
+    group->duckingRatio = 1.0f;
+    group->duckingAttack = 0.0f;
+    group->duckingRelease = 0.0f;
+    group->bus = AudioRenderer::MASTER_BUS;
+    if (!freeBuses_.empty()) {
+        group->bus = freeBuses_.back();
+        freeBuses_.pop_back();
+    } else {
+        Logger::Warning("Out of audio buses, group mixes into the master: " + name);
+    }
     
     audioGroups_[name] = group;
+    SendGroupBus(*group);
     return group;
 }
 
 void AudioSystem::DestroyAudioGroup(const std::string& name) {
-    audioGroups_.erase(name);
+    auto it = audioGroups_.find(name);
+    if (it == audioGroups_.end()) return;
+    std::shared_ptr<AudioGroup> group = it->second;
+
+    // Its sources and children carry on into its parent
+    uint32_t parentBus = group->parentGroup ? group->parentGroup->bus : AudioRenderer::MASTER_BUS;
+    for (const std::shared_ptr<AudioSource>& source : group->sources) {
+        if (source->bus != group->bus) continue;
+        source->bus = parentBus;
+        SendVoiceParam(*source, AudioVoiceParam::Bus, static_cast<float>(parentBus));
+    }
+    for (const std::shared_ptr<AudioGroup>& child : group->childGroups) {
+        child->parentGroup = group->parentGroup;
+        if (group->parentGroup) group->parentGroup->childGroups.push_back(child);
+        SendGroupBus(*child);
+    }
+    if (group->parentGroup) {
+        auto& siblings = group->parentGroup->childGroups;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), group), siblings.end());
+    }
+
+    if (group->bus != AudioRenderer::MASTER_BUS) {
+        renderer_->SubmitBusChain(group->bus, nullptr);
+        AudioCommand command = {};
+        command.type = AudioCommandType::SetBus;
+        command.voice = group->bus;
+        SendCommand(command);
+        freeBuses_.push_back(group->bus);
+    }
+    audioGroups_.erase(it);
+}
+
+bool AudioSystem::SetGroupParent(const std::string& groupName, const std::string& parentName) {
+    auto group = audioGroups_.find(groupName);
+    if (group == audioGroups_.end()) return false;
+    std::shared_ptr<AudioGroup> parent;
+    if (!parentName.empty()) {
+        auto it = audioGroups_.find(parentName);
+        if (it == audioGroups_.end()) return false;
+        parent = it->second;
+    }
+    for (std::shared_ptr<AudioGroup> p = parent; p; p = p->parentGroup) {
+        if (p == group->second) {
+            Logger::Warning("Audio group " + groupName + " can't go under its own subgroup " + parentName);
+            return false;
+        }
+    }
+
+    if (group->second->parentGroup) {
+        auto& siblings = group->second->parentGroup->childGroups;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), group->second), siblings.end());
+    }
+    group->second->parentGroup = parent;
+    if (parent) parent->childGroups.push_back(group->second);
+    SendGroupBus(*group->second);
+    return true;
 }
 
 void AudioSystem::AddSourceToGroup(const std::string& sourceName, const std::string& groupName) {
@@ -622,6 +1115,8 @@ void AudioSystem::AddSourceToGroup(const std::string& sourceName, const std::str
     auto group = audioGroups_.find(groupName);
     if (source && group != audioGroups_.end()) {
         group->second->AddSource(source);
+        source->bus = group->second->bus;
+        SendVoiceParam(*source, AudioVoiceParam::Bus, static_cast<float>(source->bus));
     }
 }
 
@@ -630,6 +1125,10 @@ void AudioSystem::RemoveSourceFromGroup(const std::string& sourceName, const std
     auto group = audioGroups_.find(groupName);
     if (source && group != audioGroups_.end()) {
         group->second->RemoveSource(source);
+        if (source->bus == group->second->bus) {
+            source->bus = AudioRenderer::MASTER_BUS;
+            SendVoiceParam(*source, AudioVoiceParam::Bus, static_cast<float>(source->bus));
+        }
     }
 }
 
@@ -637,6 +1136,7 @@ void AudioSystem::SetGroupVolume(const std::string& groupName, float volume) {
     auto group = audioGroups_.find(groupName);
     if (group != audioGroups_.end()) {
         group->second->volume = std::clamp(volume, 0.0f, 1.0f);
+        SendGroupBus(*group->second);
     }
 }
 
@@ -644,104 +1144,864 @@ void AudioSystem::SetGroupMute(const std::string& groupName, bool mute) {
     auto group = audioGroups_.find(groupName);
     if (group != audioGroups_.end()) {
         group->second->isMuted = mute;
+        SendGroupBus(*group->second);
     }
 }
 
-// Private helper methods
-void AudioSystem::CreateSourceVoice(std::shared_ptr<AudioSource> source) {
-    if (!source || !source->buffer || !xaudio2_) {
+void AudioSystem::SendGroupBus(const AudioGroup& group) {
+    if (group.bus == AudioRenderer::MASTER_BUS) return;
+
+    // The renderer applies parents' volumes as it mixes each bus into the next
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetBus;
+    command.voice = group.bus;
+    command.values[0] = group.isMuted ? 0.0f : group.volume;
+    command.values[1] = static_cast<float>(group.parentGroup ? group.parentGroup->bus : AudioRenderer::MASTER_BUS);
+    command.values[2] = 1.0f;
+    SendCommand(command);
+}
+
+void AudioSystem::SubmitEffectChain(uint32_t bus, const std::vector<std::shared_ptr<AudioEffect>>& effects) {
+    auto chain = std::make_unique<AudioBusChain>();
+    for (const std::shared_ptr<AudioEffect>& effect : effects) {
+        if (!effect->isEnabled) continue;
+        // Buses are stereo; preparing here keeps the allocation off the audio thread
+        if (auto* reverb = dynamic_cast<ReverbEffect*>(effect.get())) {
+            if (reverb->preparedRate != reverb->sampleRate || reverb->preparedChannels != 2) {
+                reverb->Prepare(reverb->sampleRate, 2);
+            }
+        }
+        chain->effects.push_back(effect);
+    }
+    if (!renderer_->SubmitBusChain(bus, std::move(chain))) {
+        Logger::Warning("Audio renderer is busy, bus effects not changed");
+    }
+}
+
+// Audio effects
+std::shared_ptr<AudioSystem::AudioEffect> AudioSystem::CreateEffect(AudioEffectType type, const std::string& name) {
+    std::shared_ptr<AudioEffect> effect;
+    switch (type) {
+    case AudioEffectType::Reverb: effect = std::make_shared<ReverbEffect>(); break;
+    case AudioEffectType::EQ: effect = std::make_shared<EQEffect>(); break;
+    case AudioEffectType::Compression: effect = std::make_shared<CompressorEffect>(); break;
+    default:
+        Logger::Warning("Unsupported audio effect type for " + name);
+        return nullptr;
+    }
+    effect->type = type;
+    effect->name = name;
+    effect->isEnabled = true;
+    effect->intensity = 1.0f;
+    effect->wetDryMix = 1.0f;
+    effect->sampleRate = sampleRate_;
+    effect->xaudioEffect = nullptr;
+
+    audioEffects_[name] = effect;
+    return effect;
+}
+
+void AudioSystem::AddEffectToGroup(const std::string& groupName, const std::string& effectName) {
+    auto group = audioGroups_.find(groupName);
+    auto effect = audioEffects_.find(effectName);
+    if (group == audioGroups_.end() || effect == audioEffects_.end()) return;
+    if (group->second->bus == AudioRenderer::MASTER_BUS) {
+        Logger::Warning("Audio group " + groupName + " has no bus for effects");
         return;
     }
-    
-    // Create WAVEFORMATEX structure
+
+    // Its filter state would be run from two chains at once
+    if (IsEffectOnBus(*effect->second)) {
+        Logger::Warning("Audio effect " + effectName + " is already on a bus");
+        return;
+    }
+
+    group->second->effects.push_back(effect->second);
+    SubmitEffectChain(group->second->bus, group->second->effects);
+}
+
+void AudioSystem::AddEffectToMaster(const std::string& effectName) {
+    auto effect = audioEffects_.find(effectName);
+    if (effect == audioEffects_.end()) return;
+
+    if (IsEffectOnBus(*effect->second)) {
+        Logger::Warning("Audio effect " + effectName + " is already on a bus");
+        return;
+    }
+
+    masterEffects_.push_back(effect->second);
+    SubmitEffectChain(AudioRenderer::MASTER_BUS, masterEffects_);
+}
+
+bool AudioSystem::IsEffectOnBus(const AudioEffect& effect) const {
+    auto matches = [&effect](const std::shared_ptr<AudioEffect>& other) { return other.get() == &effect; };
+    if (std::any_of(masterEffects_.begin(), masterEffects_.end(), matches)) return true;
+    for (const auto& group : audioGroups_) {
+        if (std::any_of(group.second->effects.begin(), group.second->effects.end(), matches)) return true;
+    }
+    return false;
+}
+
+void AudioSystem::SetEffectParameter(const std::string& effectName, const std::string& parameter, float value) {
+    auto effect = audioEffects_.find(effectName);
+    if (effect != audioEffects_.end()) {
+        effect->second->SetParameter(parameter, value);
+    }
+}
+
+// Fading
+void AudioSystem::FadeIn(const std::string& sourceName, float duration) {
+    auto source = GetAudioSource(sourceName);
+    if (!source) return;
+
+    if (!source->isPlaying) {
+        PlaySound(sourceName);
+        if (!source->isPlaying) return;
+        AudioCommand silence = {};
+        silence.type = AudioCommandType::Fade;
+        silence.voice = source->voice;
+        SendCommand(silence);
+    }
+    AudioCommand command = {};
+    command.type = AudioCommandType::Fade;
+    command.voice = source->voice;
+    command.values[0] = 1.0f;
+    command.values[1] = duration;
+    SendCommand(command);
+}
+
+void AudioSystem::FadeOut(const std::string& sourceName, float duration) {
+    // The renderer stops the voice once it is silent
+    auto source = GetAudioSource(sourceName);
+    if (!source || source->voice == INVALID_VOICE) return;
+
+    AudioCommand command = {};
+    command.type = AudioCommandType::Fade;
+    command.voice = source->voice;
+    command.values[0] = 0.0f;
+    command.values[1] = duration;
+    SendCommand(command);
+}
+
+void AudioSystem::CrossFade(const std::string& sourceA, const std::string& sourceB, float duration) {
+    FadeOut(sourceA, duration);
+    FadeIn(sourceB, duration);
+}
+
+// Environment
+void AudioSystem::RegisterAudioEnvironment(std::shared_ptr<AudioEnvironment> environment) {
+    if (!environment || environment->name.empty()) return;
+    audioEnvironments_[environment->name] = environment;
+}
+
+void AudioSystem::SetAudioEnvironment(const std::string& environmentName) {
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetReverb;
+    if (environmentName.empty()) {
+        // Level 0 lets the current room ring out and then stops processing reverb
+        SendCommand(command);
+        currentEnvironment_.clear();
+        return;
+    }
+
+    auto it = audioEnvironments_.find(environmentName);
+    if (it == audioEnvironments_.end()) {
+        Logger::Warning("Unknown audio environment: " + environmentName);
+        return;
+    }
+    const AudioEnvironment& environment = *it->second;
+
+    command.values[0] = environment.decayTime;
+    command.values[1] = environment.decayHFRatio;
+    command.values[2] = environment.reflectionsDelay + environment.reverbDelay;
+    command.values[3] = environment.roomSize;
+    command.values[4] = environment.diffusion;
+    command.values[5] = environment.reverb;
+    SendCommand(command);
+
+    if (!environment.impulseResponse.empty()) {
+        auto response = LoadImpulseResponse(environment.impulseResponse);
+        if (response && !renderer_->SubmitConvolution(std::make_unique<ConvolutionReverb>(response))) {
+            Logger::Warning("Too many convolution reverbs in flight, using the FDN for " + environmentName);
+        }
+    }
+    currentEnvironment_ = environmentName;
+}
+
+// Occlusion
+void AudioSystem::EnableOcclusion(bool enable) {
+    occlusionEnabled_ = enable;
+}
+
+void AudioSystem::SetOcclusionParameters(int raycastSamples, float maxDistance) {
+    occlusion_->raycastSamples = std::max(raycastSamples, 0);
+    occlusion_->raycastMaxDistance = std::max(maxDistance, 0.0f);
+}
+
+void AudioSystem::SetPhysicsEngine(PhysicsEngine* physics) {
+    // Rays in flight belong to the old engine
+    WaitForOcclusionRays();
+    physics_ = physics;
+}
+
+void AudioSystem::SetOcclusionListenerBody(RigidBodyID bodyId) {
+    occlusion_->listenerBody = bodyId;
+}
+
+uint16_t AudioSystem::RegisterOcclusionMaterial(const std::string& name, float absorption, float transmission) {
+    OcclusionMaterial material{ std::clamp(absorption, 0.0f, 1.0f), std::clamp(transmission, 0.0f, 1.0f) };
+    std::vector<std::string>& names = occlusion_->materialNames;
+    auto it = std::find(names.begin(), names.end(), name);
+    if (it != names.end()) {
+        size_t id = it - names.begin();
+        occlusion_->materials[id] = material;
+        return static_cast<uint16_t>(id);
+    }
+    if (names.size() > std::numeric_limits<uint16_t>::max()) {
+        Logger::Warning("Too many occlusion materials, using the default for " + name);
+        return 0;
+    }
+    names.push_back(name);
+    occlusion_->materials.push_back(material);
+    return static_cast<uint16_t>(names.size() - 1);
+}
+
+uint16_t AudioSystem::GetOcclusionMaterial(const std::string& name) const {
+    const std::vector<std::string>& names = occlusion_->materialNames;
+    auto it = std::find(names.begin(), names.end(), name);
+    return it != names.end() ? static_cast<uint16_t>(it - names.begin()) : 0;
+}
+
+void AudioSystem::SetBodyOcclusionMaterial(RigidBodyID bodyId, uint16_t material) {
+    occlusion_->bodyMaterials[bodyId] = material < occlusion_->materials.size() ? material : 0;
+}
+
+void AudioSystem::ProcessOcclusion(float deltaTime) {
+    AudioOcclusion& occlusion = *occlusion_;
+
+    // Fold in the last batch once it is done. One still running is left for a later update
+    // rather than waited on
+    if (occlusion.inFlight && occlusion.counter->IsDone()) {
+        for (size_t i = 0; i < occlusion.casters.size(); ++i) {
+            AudioSource& source = *occlusion.casters[i];
+            const PhysicsEngine::RayQuery& query = occlusion.queries[i];
+            const PhysicsEngine::RaycastResult& result = occlusion.results[i];
+            float blocked = 0.0f;
+            float absorbed = 0.0f;
+            if (result.hit && result.distance < CalculateDistance(query.from, query.to) - OCCLUSION_SOURCE_CLEARANCE) {
+                auto it = occlusion.bodyMaterials.find(result.bodyId);
+                const OcclusionMaterial& material = occlusion.materials[it != occlusion.bodyMaterials.end() ? it->second : 0];
+                blocked = 1.0f - material.transmission;
+                absorbed = material.absorption;
+            }
+            source.occlusionTarget += (blocked - source.occlusionTarget) * OCCLUSION_RAY_WEIGHT;
+            source.absorptionTarget += (absorbed - source.absorptionTarget) * OCCLUSION_RAY_WEIGHT;
+        }
+        occlusion.casters.clear();
+        occlusion.inFlight = false;
+    }
+
+    if (!occlusionEnabled_ || !occlusion.enableRaycastOcclusion) return;
+
+    // Ease towards what the rays say, so a ray slipping past an edge doesn't flicker the sound
+    float ease = 1.0f - std::exp(-deltaTime / OCCLUSION_SMOOTHING_SECONDS);
+    for (auto& [name, sourcePointer] : audioSources_) {
+        AudioSource& source = *sourcePointer;
+        if (!source.isPlaying || !source.is3D) continue;
+
+        // Rays are owed in proportion to priority; fractions carry over to later updates
+        source.rayCredit = std::min(source.rayCredit + deltaTime * occlusion.raycastSamples *
+                                                           PRIORITY_WEIGHTS[static_cast<int>(source.priority)],
+                                    OCCLUSION_MAX_RAYS);
+
+        float occlusionStep = (source.occlusionTarget - source.occlusion) * ease;
+        float absorptionStep = (source.absorptionTarget - source.absorption) * ease;
+        if (std::abs(occlusionStep) < OCCLUSION_EPSILON && std::abs(absorptionStep) < OCCLUSION_EPSILON) continue;
+        source.occlusion = std::clamp(source.occlusion + occlusionStep, 0.0f, 1.0f);
+        source.absorption = std::clamp(source.absorption + absorptionStep, 0.0f, 1.0f);
+        source.lowPass = source.absorption > OCCLUSION_EPSILON
+                             ? OCCLUSION_OPEN_CUTOFF * std::pow(OCCLUSION_CLOSED_CUTOFF / OCCLUSION_OPEN_CUTOFF, source.absorption)
+                             : 0.0f;
+        SendVoiceParam(source, AudioVoiceParam::Occlusion, source.occlusion);
+        SendVoiceParam(source, AudioVoiceParam::LowPass, source.lowPass);
+    }
+
+    if (physics_ && !occlusion.inFlight) CastOcclusionRays();
+}
+
+void AudioSystem::CastOcclusionRays() {
+    AudioOcclusion& occlusion = *occlusion_;
+    occlusion.queries.clear();
+    for (auto& [name, sourcePointer] : audioSources_) {
+        AudioSource& source = *sourcePointer;
+        if (!source.isPlaying || !source.is3D) continue;
+        if (CalculateDistance(source.position, listenerPosition_) > occlusion.raycastMaxDistance) continue;
+
+        for (; source.rayCredit >= 1.0f; source.rayCredit -= 1.0f) {
+            const float* aim = OCCLUSION_AIMS[source.rayIndex++ % std::size(OCCLUSION_AIMS)];
+            PhysicsEngine::RayQuery query;
+            query.from = listenerPosition_;
+            query.to = XMFLOAT3(source.position.x + aim[0] * OCCLUSION_SPREAD, source.position.y + aim[1] * OCCLUSION_SPREAD,
+                                source.position.z + aim[2] * OCCLUSION_SPREAD);
+            query.ignoreBody = occlusion.listenerBody;
+            occlusion.queries.push_back(query);
+            occlusion.casters.push_back(sourcePointer);
+        }
+    }
+    if (occlusion.queries.empty()) return;
+
+    // The queries and results stay untouched until the counter says the batch is done
+    occlusion.results.resize(occlusion.queries.size());
+    physics_->CastBatchAsync(occlusion.queries.data(), occlusion.queries.size(), occlusion.results.data(),
+                             *occlusion.counter);
+    occlusion.inFlight = true;
+}
+
+void AudioSystem::WaitForOcclusionRays() {
+    AudioOcclusion& occlusion = *occlusion_;
+    if (!occlusion.inFlight) return;
+    if (jobs_) jobs_->Wait(*occlusion.counter);
+    while (!occlusion.counter->IsDone()) std::this_thread::yield();
+    occlusion.casters.clear();
+    occlusion.inFlight = false;
+}
+
+void AudioSystem::RegisterDefaultEnvironments() {
+    for (const EnvironmentPreset& preset : ENVIRONMENT_PRESETS) {
+        if (audioEnvironments_.count(preset.name)) continue;
+
+        auto environment = std::make_shared<AudioEnvironment>();
+        environment->name = preset.name;
+        environment->roomSize = preset.roomSize;
+        environment->roomHF = 1.0f;
+        environment->roomRolloffFactor = 0.0f;
+        environment->decayTime = preset.decayTime;
+        environment->decayHFRatio = preset.decayHFRatio;
+        environment->reflections = 1.0f;
+        environment->reflectionsDelay = preset.reflectionsDelay;
+        environment->reverb = preset.level;
+        environment->reverbDelay = preset.reverbDelay;
+        environment->diffusion = preset.diffusion;
+        environment->density = 1.0f;
+        environment->hfReference = 5000.0f;
+        audioEnvironments_[preset.name] = environment;
+    }
+}
+
+std::shared_ptr<const ImpulseResponse> AudioSystem::LoadImpulseResponse(const std::string& filePath) {
+    auto cached = impulseResponses_.find(filePath);
+    if (cached != impulseResponses_.end()) return cached->second;
+
+    auto buffer = LoadAudioFile(filePath);
+    AudioClip clip = buffer ? MakeClip(*buffer) : AudioClip{};
+    if (!clip.data) {
+        Logger::Error("Impulse response can't be loaded: " + filePath);
+        return nullptr;
+    }
+
+    // Mono responses feed both ears
+    std::vector<float> left = Resample(resampler_, DecodeClip(clip, 0), clip.sampleRate, sampleRate_);
+    std::vector<float> right = clip.channels > 1 ? Resample(resampler_, DecodeClip(clip, 1), clip.sampleRate, sampleRate_) : left;
+    auto response = std::make_shared<ImpulseResponse>();
+    if (!response->Build(left, right, AudioRenderer::BLOCK_FRAMES)) {
+        Logger::Error("Impulse response is empty: " + filePath);
+        return nullptr;
+    }
+    // Only the spectra are needed from here on
+    UnloadAudioBuffer(filePath);
+    impulseResponses_[filePath] = response;
+    return response;
+}
+
+// Voice budget
+void AudioSystem::SetMaxVoices(int maxVoices) {
+    maxVoices_ = std::clamp(maxVoices, 1, static_cast<int>(AudioRenderer::MAX_VOICES));
+}
+
+void AudioSystem::SetVoicePriority(const std::string& sourceName, AudioPriority priority) {
+    auto source = GetAudioSource(sourceName);
+    if (source) {
+        source->priority = priority;
+        SendVoiceParam(*source, AudioVoiceParam::Quality, static_cast<float>(RESAMPLE_QUALITIES[static_cast<int>(priority)]));
+    }
+}
+
+void AudioSystem::EnableVoiceVirtualization(bool enable) {
+    voiceVirtualizationEnabled_ = enable;
+}
+
+// Binaural spatialization
+void AudioSystem::EnableHRTF(bool enable) {
+    hrtfEnabled_ = enable;
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetSpatializer;
+    command.values[0] = enable ? 1.0f : 0.0f;
+    command.values[1] = static_cast<float>(hrtfVoiceLimit_);
+    SendCommand(command);
+}
+
+void AudioSystem::SetHRTFVoiceLimit(int voiceLimit) {
+    hrtfVoiceLimit_ = std::clamp(voiceLimit, 0, static_cast<int>(HRTFSpatializer::MAX_NEAR_VOICES));
+    EnableHRTF(hrtfEnabled_);
+}
+
+void AudioSystem::SetJobSystem(JobSystem* jobs) {
+    WaitForOcclusionRays();
+    jobs_ = jobs;
+    renderer_->SetJobSystem(jobs);
+}
+
+// Streaming; the settings apply to streams opened after the change
+void AudioSystem::EnableStreaming(bool enable) {
+    streamingEnabled_ = enable;
+}
+
+void AudioSystem::SetStreamingBufferSize(size_t bufferSize) {
+    streaming_->bufferFrames = static_cast<uint32_t>(std::clamp<size_t>(bufferSize, AudioStreamer::DECODE_CHUNK_FRAMES * 2, 1u << 20));
+}
+
+void AudioSystem::SetStreamingBufferCount(int count) {
+    streaming_->readChunkCount = std::clamp(count, 2, 32);
+}
+
+void AudioSystem::ProcessAudio(float* outputBuffer, int sampleCount) {
+    if (sampleCount <= 0) return;
+    renderer_->Render(outputBuffer, static_cast<uint32_t>(sampleCount));
+}
+
+// Audio thread
+bool AudioSystem::StartOutput() {
     WAVEFORMATEX wfx = {};
-    wfx.wFormatTag = WAVE_FORMAT_PCM;
-    wfx.nChannels = source->buffer->channels;
-    wfx.nSamplesPerSec = source->buffer->sampleRate;
-    wfx.wBitsPerSample = 16; // Assuming 16-bit PCM
+    wfx.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+    wfx.nChannels = static_cast<WORD>(channels_);
+    wfx.nSamplesPerSec = sampleRate_;
+    wfx.wBitsPerSample = 32;
     wfx.nBlockAlign = wfx.nChannels * wfx.wBitsPerSample / 8;
     wfx.nAvgBytesPerSec = wfx.nSamplesPerSec * wfx.nBlockAlign;
-    
-    // Create source voice
-    HRESULT hr = xaudio2_->CreateSourceVoice(&source->sourceVoice, &wfx);
+
+    outputCallback_ = std::make_unique<OutputCallback>();
+    HRESULT hr = xaudio2_->CreateSourceVoice(&outputVoice_, &wfx, 0, XAUDIO2_DEFAULT_FREQ_RATIO, outputCallback_.get());
     if (FAILED(hr)) {
-        Logger::Error("Failed to create source voice for: " + source->name);
-        return;
+        Logger::Error("Failed to create audio output voice");
+        outputCallback_.reset();
+        return false;
     }
-    
-    // Submit audio buffer
-    XAUDIO2_BUFFER buffer = {};
-    buffer.AudioBytes = static_cast<UINT32>(source->buffer->dataSize);
-    buffer.pAudioData = source->buffer->data.data();
-    buffer.Flags = XAUDIO2_END_OF_STREAM;
-    if (source->isLooping) {
-        buffer.LoopCount = XAUDIO2_LOOP_INFINITE;
+
+    outputBlocks_.assign(size_t(OUTPUT_BLOCKS) * AudioRenderer::BLOCK_FRAMES * channels_, 0.0f);
+    mixerRunning_ = true;
+    audioThread_ = std::thread(&AudioSystem::MixerThreadFunc, this);
+    outputVoice_->Start();
+    return true;
+}
+
+void AudioSystem::StopOutput() {
+    if (audioThread_.joinable()) {
+        mixerRunning_ = false;
+        SetEvent(outputCallback_->bufferEnd);
+        audioThread_.join();
+    }
+    if (outputVoice_) {
+        // Blocks until XAudio2 is done with the voice's callbacks
+        outputVoice_->Stop();
+        outputVoice_->DestroyVoice();
+        outputVoice_ = nullptr;
+    }
+    outputCallback_.reset();
+}
+
+void AudioSystem::MixerThreadFunc() {
+    NEXUS_MEMORY_SCOPE(MemoryTag::Audio);
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+
+    const size_t blockSamples = size_t(AudioRenderer::BLOCK_FRAMES) * channels_;
+    uint32_t next = 0;
+    while (mixerRunning_) {
+        // Refill the blocks the device has played, oldest first, then sleep until it plays another
+        XAUDIO2_VOICE_STATE state;
+        outputVoice_->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+        for (uint32_t queued = state.BuffersQueued; queued < OUTPUT_BLOCKS; ++queued) {
+            float* block = outputBlocks_.data() + next * blockSamples;
+            renderer_->Render(block, AudioRenderer::BLOCK_FRAMES);
+
+            XAUDIO2_BUFFER buffer = {};
+            buffer.AudioBytes = static_cast<UINT32>(blockSamples * sizeof(float));
+            buffer.pAudioData = reinterpret_cast<const BYTE*>(block);
+            outputVoice_->SubmitSourceBuffer(&buffer);
+            next = (next + 1) % OUTPUT_BLOCKS;
+        }
+        WaitForSingleObject(outputCallback_->bufferEnd, OUTPUT_WAIT_MS);
     }
-    
-    hr = source->sourceVoice->SubmitSourceBuffer(&buffer);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to submit source buffer for: " + source->name);
+}
+
+// Renderer voices
+bool AudioSystem::StartVoice(AudioSource& source, bool fadeIn) {
+    const bool synthesized = source.type == AudioSourceType::Generated;
+    AudioClip clip = synthesized ? AudioClip{} : MakeClip(*source.buffer);
+    std::shared_ptr<AudioStream> stream;
+    if (!synthesized && !clip.data) {
+        stream = OpenStream(source);
+        if (!stream) {
+            Logger::Warning("Audio buffer can't be played: " + source.buffer->name);
+            return false;
+        }
+        AudioStreamInfo info = stream->GetInfo();
+        clip.stream = &stream->GetBuffer();
+        clip.sampleRate = info.sampleRate;
+        clip.channels = info.channels;
     }
+
+    // The renderer reads a stream's ring until it takes the new Play, so a restarted stream gets
+    // a fresh voice and the old one keeps its ring until the renderer reports it done
+    if (source.voice != INVALID_VOICE && (stream || voiceSlots_[source.voice].stream)) {
+        StopVoice(source);
+    }
+
+    if (source.voice == INVALID_VOICE) {
+        if (freeVoices_.empty()) {
+            Logger::Warning("Out of audio voices, not playing: " + source.name);
+            if (stream) streaming_->streamer->Close(stream);
+            return false;
+        }
+        source.voice = freeVoices_.back();
+        freeVoices_.pop_back();
+    }
+
+    // Restarting a playing voice bumps its generation, so its old done event is ignored
+    VoiceSlot& slot = voiceSlots_[source.voice];
+    slot.source = &source;
+    slot.buffer = source.buffer;
+    slot.stream = stream;
+    slot.generation++;
+    slot.inUse = true;
+
+    AudioCommand command = {};
+    command.type = synthesized ? AudioCommandType::PlaySynth : AudioCommandType::Play;
+    command.voice = source.voice;
+    command.generation = slot.generation;
+    if (synthesized) {
+        command.synth = source.synth;
+    } else {
+        command.clip = clip;
+    }
+    SendCommand(command);
+
+    // Streams were opened where the source had got to, and synths count their time in output frames
+    if (source.playbackPosition > 0.0 && !stream) {
+        AudioCommand seek = {};
+        seek.type = AudioCommandType::Seek;
+        seek.voice = source.voice;
+        seek.values[0] = static_cast<float>(source.playbackPosition);
+        SendCommand(seek);
+    }
+    if (fadeIn) {
+        AudioCommand silence = {};
+        silence.type = AudioCommandType::Fade;
+        silence.voice = source.voice;
+        SendCommand(silence);
+        AudioCommand fade = silence;
+        fade.values[0] = 1.0f;
+        fade.values[1] = VOICE_FADE_SECONDS;
+        SendCommand(fade);
+    }
+
+    SendVoiceParam(source, AudioVoiceParam::Volume, source.volume);
+    SendVoiceParam(source, AudioVoiceParam::Pitch, source.pitch);
+    SendVoiceParam(source, AudioVoiceParam::Pan, source.pan);
+    SendVoiceParam(source, AudioVoiceParam::Looping, source.isLooping ? 1.0f : 0.0f);
+    SendVoiceParam(source, AudioVoiceParam::Bus, static_cast<float>(source.bus));
+    SendVoiceParam(source, AudioVoiceParam::Quality,
+                   static_cast<float>(RESAMPLE_QUALITIES[static_cast<int>(source.priority)]));
+    if (source.is3D) {
+        SendVoiceParam(source, AudioVoiceParam::Spatial, 1.0f);
+        SendVoiceParam(source, AudioVoiceParam::MinDistance, source.minDistance);
+        SendVoiceParam(source, AudioVoiceParam::MaxDistance, source.maxDistance);
+        SendVoiceParam(source, AudioVoiceParam::Rolloff, source.rolloffFactor);
+        SendVoiceParam(source, AudioVoiceParam::Occlusion, source.occlusion);
+        SendVoiceParam(source, AudioVoiceParam::LowPass, source.lowPass);
+        SendVoiceVector(source, AudioCommandType::SetPosition, source.position);
+        SendVoiceVector(source, AudioCommandType::SetVelocity, source.velocity);
+    }
+    return true;
 }
 
-void AudioSystem::Process3DAudio() {
-    // Update 3D audio calculations for all 3D sources
-    for (auto& [name, source] : audioSources_) {
-        if (source->is3D && source->sourceVoice && listener_) {
-            // Calculate 3D audio parameters using X3DAudio
-            // This is a simplified implementation
-            float distance = CalculateDistance(source->position, listener_->position);
-            float attenuation = CalculateAttenuation(distance, source->minDistance, source->maxDistance, source->rolloffFactor);
-            
-            // Apply volume attenuation
-            float finalVolume = source->volume * attenuation;
-            source->sourceVoice->SetVolume(finalVolume);
-            
-            // Apply Doppler effect if enabled
-            if (dopplerEnabled_) {
-                XMFLOAT3 direction;
-                direction.x = listener_->position.x - source->position.x;
-                direction.y = listener_->position.y - source->position.y;
-                direction.z = listener_->position.z - source->position.z;
-                
-                float dopplerShift = CalculateDopplerShift(source->velocity, listener_->velocity, direction);
-                source->sourceVoice->SetFrequencyRatio(source->pitch * dopplerShift);
+std::shared_ptr<AudioStream> AudioSystem::OpenStream(const AudioSource& source) {
+    const std::shared_ptr<AudioBuffer>& buffer = source.buffer;
+    std::unique_ptr<AudioByteSource> bytes;
+    if (buffer->isCompressed && buffer->GetByteCount() > 0) {
+        // Aliases the buffer, so the clip's bytes outlive it being unloaded mid-play
+        bytes = std::make_unique<MemoryByteSource>(std::shared_ptr<const uint8_t>(buffer, buffer->GetBytes()),
+                                                   buffer->GetByteCount());
+    } else if (source.type == AudioSourceType::Streaming && streamingEnabled_) {
+        auto file = std::make_unique<OverlappedFileSource>(buffer->name, streaming_->readChunkBytes,
+                                                           streaming_->readChunkCount);
+        if (!file->IsOpen()) {
+            Logger::Error("Could not open audio stream: " + buffer->name);
+            return nullptr;
+        }
+        bytes = std::move(file);
+    } else {
+        return nullptr;
+    }
+
+    uint64_t startFrame = static_cast<uint64_t>(std::max(source.playbackPosition, 0.0));
+    return streaming_->streamer->Open(std::move(bytes), source.isLooping, startFrame, streaming_->bufferFrames);
+}
+
+void AudioSystem::StopVoice(AudioSource& source) {
+    if (source.voice == INVALID_VOICE) return;
+
+    AudioCommand command = {};
+    command.type = AudioCommandType::Stop;
+    command.voice = source.voice;
+    SendCommand(command);
+
+    // The slot and its buffer are released once the renderer reports the voice done
+    voiceSlots_[source.voice].source = nullptr;
+    source.voice = INVALID_VOICE;
+}
+
+void AudioSystem::VirtualizeVoice(AudioSource& source) {
+    if (source.voice == INVALID_VOICE) return;
+
+    // The renderer stops the voice once it has faded out, and frees the slot then
+    AudioCommand command = {};
+    command.type = AudioCommandType::Fade;
+    command.voice = source.voice;
+    command.values[1] = VOICE_FADE_SECONDS;
+    SendCommand(command);
+
+    voiceSlots_[source.voice].source = nullptr;
+    source.voice = INVALID_VOICE;
+    source.isVirtual = true;
+}
+
+void AudioSystem::UpdateVoiceBudget(float deltaTime) {
+    std::vector<std::shared_ptr<AudioSource>> finished;
+    voiceRanking_.clear();
+    for (auto& [name, sourcePointer] : audioSources_) {
+        AudioSource& source = *sourcePointer;
+        if (!source.isPlaying || source.isPaused) continue;
+
+        // Virtual sources have only this to go on; real ones keep it close enough to resume from
+        // Streams may not know their length, and then only end when the renderer says so
+        double length;
+        if (source.type == AudioSourceType::Generated) {
+            // Synth time is the envelope's, at the output rate whatever the pitch
+            length = AudioSynthVoice::GetLength(source.synth, static_cast<float>(sampleRate_));
+            source.playbackPosition += double(deltaTime) * sampleRate_;
+        } else {
+            length = MakeClip(*source.buffer).frameCount;
+            if (length == 0.0) length = double(source.buffer->duration) * source.buffer->sampleRate;
+            source.playbackPosition += double(deltaTime) * source.buffer->sampleRate * source.pitch;
+        }
+        if (length > 0.0 && source.playbackPosition >= length) {
+            if (source.isLooping && source.type != AudioSourceType::Generated) {
+                source.playbackPosition = std::fmod(source.playbackPosition, length);
+            } else if (source.isVirtual) {
+                source.isPlaying = false;
+                source.isVirtual = false;
+                finished.push_back(sourcePointer);
+                continue;
+            } else {
+                source.playbackPosition = length;
+            }
+        }
+
+        source.audibility = ComputeAudibility(source);
+        float score = PRIORITY_WEIGHTS[static_cast<int>(source.priority)] * source.audibility;
+        if (!source.isVirtual) score *= REAL_VOICE_BONUS;
+        if (source.priority == AudioPriority::Critical) score = std::numeric_limits<float>::max();
+        voiceRanking_.emplace_back(score, &source);
+    }
+
+    size_t budget = voiceVirtualizationEnabled_ ? static_cast<size_t>(maxVoices_) : AudioRenderer::MAX_VOICES;
+    size_t real = std::min(budget, voiceRanking_.size());
+    if (real < voiceRanking_.size()) {
+        std::nth_element(voiceRanking_.begin(), voiceRanking_.begin() + real, voiceRanking_.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+    }
+
+    int active = 0;
+    for (size_t i = 0; i < voiceRanking_.size(); ++i) {
+        AudioSource& source = *voiceRanking_[i].second;
+        // Silent sources give their voice up even under budget
+        bool keep = i < real && (source.audibility > 0.0f || source.priority == AudioPriority::Critical);
+        if (keep && source.isVirtual) {
+            // Fresh sounds start clean; ones already under way fade in where they've got to
+            if (StartVoice(source, source.playbackPosition > 0.0)) {
+                source.isVirtual = false;
             }
+        } else if (!keep && !source.isVirtual) {
+            VirtualizeVoice(source);
+        }
+        if (!source.isVirtual) active++;
+    }
+    activeVoices_ = active;
+
+    for (auto& source : finished) {
+        if (source->onPlaybackComplete) {
+            source->onPlaybackComplete();
         }
     }
 }
 
-void AudioSystem::UpdateStreamingSources() {
-    // Update streaming audio sources
-    for (auto& [name, source] : audioSources_) {
-        if (source->type == AudioSourceType::Streaming && source->isPlaying) {
-            // Handle streaming buffer updates
-            // This is a simplified implementation
+float AudioSystem::ComputeAudibility(const AudioSource& source) const {
+    float audibility = source.volume * (1.0f - source.occlusion);
+    if (!source.is3D) return audibility;
+
+    float distance = CalculateDistance(source.position, listenerPosition_);
+    audibility *= CalculateAttenuation(distance, source.minDistance, source.maxDistance, source.rolloffFactor);
+
+    // Full cone angles, as in SetSourceCone: inside the inner cone is full volume, outside the
+    // outer cone is coneOuterGain
+    if (source.coneOuterAngle < 360.0f && distance > 1e-4f) {
+        XMFLOAT3 toListener((listenerPosition_.x - source.position.x) / distance,
+                            (listenerPosition_.y - source.position.y) / distance,
+                            (listenerPosition_.z - source.position.z) / distance);
+        const XMFLOAT3& d = source.direction;
+        float length = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+        if (length > 1e-4f) {
+            float cosine = (d.x * toListener.x + d.y * toListener.y + d.z * toListener.z) / length;
+            float angle = 2.0f * std::acos(std::clamp(cosine, -1.0f, 1.0f)) * (180.0f / 3.14159265f);
+            if (angle > source.coneInnerAngle) {
+                float width = std::max(source.coneOuterAngle - source.coneInnerAngle, 1e-3f);
+                float t = std::min((angle - source.coneInnerAngle) / width, 1.0f);
+                audibility *= 1.0f + (source.coneOuterGain - 1.0f) * t;
+            }
         }
     }
+    return audibility;
 }
 
-void AudioSystem::ProcessFading(std::shared_ptr<AudioSource> source, float deltaTime) {
-    if (!source || !source->isFading) return;
-    
-    source->fadeVolume += source->fadeSpeed * deltaTime;
-    source->fadeVolume = std::clamp(source->fadeVolume, 0.0f, 1.0f);
-    
-    if (source->sourceVoice) {
-        source->sourceVoice->SetVolume(source->volume * source->fadeVolume);
+void AudioSystem::SendVoiceParam(const AudioSource& source, AudioVoiceParam param, float value) {
+    if (source.voice == INVALID_VOICE) return;
+
+    AudioCommand command = {};
+    command.type = AudioCommandType::SetParam;
+    command.param = param;
+    command.voice = source.voice;
+    command.values[0] = value;
+    SendCommand(command);
+}
+
+void AudioSystem::SendVoiceVector(const AudioSource& source, AudioCommandType type, const XMFLOAT3& value) {
+    if (source.voice == INVALID_VOICE) return;
+
+    AudioCommand command = {};
+    command.type = type;
+    command.voice = source.voice;
+    command.values[0] = value.x;
+    command.values[1] = value.y;
+    command.values[2] = value.z;
+    SendCommand(command);
+}
+
+void AudioSystem::SendCommand(const AudioCommand& command) {
+    if (!renderer_->Submit(command) && renderer_->GetDroppedCommandCount() == 1) {
+        Logger::Warning("Audio command queue full, dropping commands");
     }
-    
-    // Check if fade is complete
-    if ((source->fadeSpeed > 0 && source->fadeVolume >= 1.0f) ||
-        (source->fadeSpeed < 0 && source->fadeVolume <= 0.0f)) {
-        source->isFading = false;
-        
-        if (source->fadeVolume <= 0.0f) {
+}
+
+void AudioSystem::ProcessVoiceEvents() {
+    AudioVoiceEvent event;
+    while (renderer_->PollEvent(event)) {
+        if (event.voice >= voiceSlots_.size()) continue;
+        VoiceSlot& slot = voiceSlots_[event.voice];
+        if (!slot.inUse || slot.generation != event.generation) continue;
+
+        AudioSource* source = slot.source;
+        slot.source = nullptr;
+        slot.buffer.reset();
+        if (slot.stream) {
+            streaming_->streamer->Close(slot.stream);
+            slot.stream.reset();
+        }
+        slot.inUse = false;
+        freeVoices_.push_back(event.voice);
+
+        if (source) {
+            source->voice = INVALID_VOICE;
             source->isPlaying = false;
+            source->isPaused = false;
+            if (event.finished && source->onPlaybackComplete) {
+                source->onPlaybackComplete();
+            }
+        }
+    }
+}
+
+// Audio format conversion
+void AudioSystem::ConvertAudioFormat(const AudioBuffer& source, AudioBuffer& dest, AudioFormat targetFormat) {
+    std::vector<std::vector<float>> channels = DecodeChannels(source);
+    int bits = 0;
+    switch (targetFormat) {
+    case AudioFormat::PCM_8: bits = 8; break;
+    case AudioFormat::PCM_16: bits = 16; break;
+    case AudioFormat::PCM_24: bits = 24; break;
+    case AudioFormat::PCM_32:
+    case AudioFormat::Float32: bits = 32; break;
+    default: break;
+    }
+    if (channels.empty() || bits == 0) {
+        Logger::Error("Can't convert audio buffer: " + source.name);
+        return;
+    }
+
+    size_t frames = channels[0].size();
+    size_t bytesPerSample = bits / 8;
+    dest = source;
+    dest.mappedData = nullptr;
+    dest.format = targetFormat;
+    dest.bitsPerSample = bits;
+    dest.dataSize = frames * channels.size() * bytesPerSample;
+    dest.data.assign(dest.dataSize, 0);
+    uint8_t* out = dest.data.data();
+    for (size_t f = 0; f < frames; ++f) {
+        for (const std::vector<float>& channel : channels) {
+            float sample = channel[f];
+            if (targetFormat == AudioFormat::Float32) {
+                std::memcpy(out, &sample, sizeof(sample));
+            } else {
+                double scaled = std::clamp(double(sample), -1.0, 1.0) * std::ldexp(1.0, bits - 1);
+                int64_t value = std::clamp<int64_t>(std::llround(scaled), -(int64_t(1) << (bits - 1)),
+                                                    (int64_t(1) << (bits - 1)) - 1);
+                if (bits == 8) value += 128;
+                for (size_t b = 0; b < bytesPerSample; ++b) out[b] = static_cast<uint8_t>(value >> (b * 8));
+            }
+            out += bytesPerSample;
         }
     }
 }
 
+void AudioSystem::ResampleAudio(const AudioBuffer& source, AudioBuffer& dest, int targetSampleRate) {
+    std::vector<std::vector<float>> channels = DecodeChannels(source);
+    if (channels.empty() || targetSampleRate <= 0) {
+        Logger::Error("Can't resample audio buffer: " + source.name);
+        return;
+    }
+    for (std::vector<float>& channel : channels) {
+        channel = Resample(resampler_, channel, source.sampleRate, targetSampleRate);
+    }
+
+    size_t frames = channels[0].size();
+    dest = source;
+    dest.mappedData = nullptr;
+    dest.format = AudioFormat::Float32;
+    dest.sampleRate = targetSampleRate;
+    dest.bitsPerSample = 32;
+    dest.dataSize = frames * channels.size() * sizeof(float);
+    dest.data.resize(dest.dataSize);
+    float* out = reinterpret_cast<float*>(dest.data.data());
+    for (size_t f = 0; f < frames; ++f) {
+        for (const std::vector<float>& channel : channels) *out++ = channel[f];
+    }
+    dest.duration = static_cast<float>(double(frames) / targetSampleRate);
+    // Loop points are in frames, so they move with the rate
+    double scale = double(targetSampleRate) / source.sampleRate;
+    dest.loopStart = static_cast<size_t>(source.loopStart * scale);
+    dest.loopEnd = static_cast<size_t>(source.loopEnd * scale);
+}
+
 // File format loaders (real implementations)
 std::shared_ptr<AudioSystem::AudioBuffer> AudioSystem::LoadWAV(const std::string& filePath) {
     std::ifstream file(filePath, std::ios::binary);
@@ -806,8 +2066,12 @@ std::shared_ptr<AudioSystem::AudioBuffer> AudioSystem::LoadWAV(const std::string
     }
     
     // Validate format
+    if (audioFormat == 0x11) { // IMA ADPCM, a quarter the size of PCM16 and decoded as it plays
+        file.close();
+        return LoadCompressed(filePath, AudioFormat::Compressed_ADPCM);
+    }
     if (audioFormat != 1) { // PCM
-        Logger::Error("Unsupported WAV format: only PCM is supported");
+        Logger::Error("Unsupported WAV format: only PCM and IMA ADPCM are supported");
         return nullptr;
     }
     
@@ -862,109 +2126,58 @@ std::shared_ptr<AudioSystem::AudioBuffer> AudioSystem::LoadMP3(const std::string
 }
 
 std::shared_ptr<AudioSystem::AudioBuffer> AudioSystem::LoadOGG(const std::string& filePath) {
-    // OGG loading requires external library like libvorbis or stb_vorbis
-    // This is a placeholder implementation that could be extended
-    Logger::Warning("OGG loading not yet implemented: " + filePath);
-    Logger::Info("To add OGG support, integrate a library like libvorbis or stb_vorbis");
-    
-    // For now, return nullptr to indicate unsupported format
-    return nullptr;
+    return LoadCompressed(filePath, AudioFormat::Compressed_OGG);
 }
 
-// Effects implementation
-void AudioSystem::ApplyReverb(float* samples, int sampleCount, int channels, const ReverbEffect& effect) {
-    if (!samples || sampleCount <= 0 || channels <= 0) return;
-    
-    // Simple reverb implementation using delay and feedback
-    float roomSize = effect.GetParameter("roomSize");
-    float damping = effect.GetParameter("damping");
-    float wetLevel = effect.GetParameter("wetLevel");
-    float dryLevel = effect.GetParameter("dryLevel");
-    
-    // Simplified reverb processing
-    static std::vector<float> delayBuffer(44100); // 1 second delay buffer
-    static size_t delayIndex = 0;
-    
-    for (int i = 0; i < sampleCount * channels; ++i) {
-        float input = samples[i];
-        
-        // Get delayed sample
-        float delayed = delayBuffer[delayIndex];
-        
-        // Apply feedback and damping
-        float feedback = delayed * roomSize * damping;
-        
-        // Store input + feedback in delay buffer
-        delayBuffer[delayIndex] = input + feedback;
-        delayIndex = (delayIndex + 1) % delayBuffer.size();
-        
-        // Mix dry and wet signals
-        samples[i] = (input * dryLevel) + (delayed * wetLevel);
+std::shared_ptr<AudioSystem::AudioBuffer> AudioSystem::LoadCompressed(const std::string& filePath, AudioFormat format) {
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        Logger::Error("Could not open audio file: " + filePath);
+        return nullptr;
+    }
+    auto buffer = std::make_shared<AudioBuffer>();
+    buffer->data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer->data.data()), buffer->data.size());
+    if (!file) {
+        Logger::Error("Could not read audio file: " + filePath);
+        return nullptr;
     }
-}
 
-void AudioSystem::ApplyEQ(float* samples, int sampleCount, int channels, const EQEffect& effect) {
-    if (!samples || sampleCount <= 0 || channels <= 0) return;
-    
-    // Simple 3-band EQ implementation
-    float lowGain = effect.GetParameter("lowGain");
-    float midGain = effect.GetParameter("midGain");
-    float highGain = effect.GetParameter("highGain");
-    
-    // Simplified EQ processing using basic filtering
-    static float lowState = 0.0f, midState = 0.0f, highState = 0.0f;
-    
-    for (int i = 0; i < sampleCount * channels; ++i) {
-        float input = samples[i];
-        
-        // Simple high-pass filter for high frequencies
-        float high = input - highState;
-        highState += high * 0.1f;
-        
-        // Simple band-pass filter for mid frequencies
-        float mid = high - midState;
-        midState += mid * 0.3f;
-        
-        // Low frequencies are what's left
-        float low = input - high - mid;
-        
-        // Apply gains and mix
-        samples[i] = (low * lowGain) + (mid * midGain) + (high * highGain);
+    AudioStreamInfo info = {};
+    MemoryByteSource probe(std::shared_ptr<const std::vector<uint8_t>>(buffer, &buffer->data));
+    if (!streaming_->streamer->Probe(probe, info)) {
+        Logger::Error("Unsupported or corrupt audio file: " + filePath);
+        return nullptr;
     }
+
+    buffer->name = filePath;
+    buffer->format = format;
+    buffer->sampleRate = static_cast<int>(info.sampleRate);
+    buffer->channels = info.channels;
+    buffer->bitsPerSample = 32;
+    buffer->dataSize = buffer->data.size();
+    buffer->duration = static_cast<float>(double(info.frameCount) / info.sampleRate);
+    buffer->isCompressed = true;
+    buffer->originalSize = static_cast<size_t>(info.frameCount * info.channels * sizeof(float));
+    buffer->compressionRatio = buffer->dataSize > 0 ? float(buffer->originalSize) / buffer->dataSize : 1.0f;
+
+    Logger::Info("Loaded compressed audio: " + filePath + " (" + std::to_string(buffer->duration) + "s, " +
+                 std::to_string(buffer->dataSize / 1024) + " KB)");
+    return buffer;
 }
 
-void AudioSystem::ApplyCompressor(float* samples, int sampleCount, int channels, const CompressorEffect& effect) {
-    if (!samples || sampleCount <= 0 || channels <= 0) return;
-    
-    // Simple compressor implementation
-    float threshold = effect.GetParameter("threshold");
-    float ratio = effect.GetParameter("ratio");
-    float attack = effect.GetParameter("attack");
-    float release = effect.GetParameter("release");
-    
-    static float envelope = 0.0f;
-    
-    for (int i = 0; i < sampleCount * channels; ++i) {
-        float input = std::abs(samples[i]);
-        
-        // Envelope follower
-        if (input > envelope) {
-            envelope += (input - envelope) * attack;
-        } else {
-            envelope += (input - envelope) * release;
-        }
-        
-        // Calculate gain reduction
-        float gainReduction = 1.0f;
-        if (envelope > threshold) {
-            float excess = envelope - threshold;
-            gainReduction = threshold + (excess / ratio);
-            gainReduction = gainReduction / envelope;
-        }
-        
-        // Apply compression
-        samples[i] *= gainReduction;
-    }
+// Effects implementation
+void AudioSystem::ApplyReverb(float* samples, int sampleCount, int channels, ReverbEffect& effect) {
+    effect.Apply(samples, sampleCount, channels);
+}
+
+void AudioSystem::ApplyEQ(float* samples, int sampleCount, int channels, EQEffect& effect) {
+    effect.Apply(samples, sampleCount, channels);
+}
+
+void AudioSystem::ApplyCompressor(float* samples, int sampleCount, int channels, CompressorEffect& effect) {
+    effect.Apply(samples, sampleCount, channels);
 }
 
 // Utility functions
@@ -1038,140 +2251,4 @@ void AudioSystem::AudioAnalytics::LogStatistics() {
     // In a real implementation, this would output detailed statistics
 }
 
-// AudioEffect method implementations
-void AudioSystem::ReverbEffect::Apply(float* samples, int sampleCount, int channels) {
-    if (!samples || sampleCount <= 0 || channels <= 0) return;
-    
-    // Get effect parameters
-    float roomSize = GetParameter("roomSize");
-    float damping = GetParameter("damping");
-    float wetLevel = GetParameter("wetLevel");
-    float dryLevel = GetParameter("dryLevel");
-    
-    // Initialize delay buffers if needed
-    if (delayBuffer.size() < 44100) {
-        delayBuffer.resize(44100, 0.0f);
-        delayIndex = 0;
-    }
-    
-    // Apply reverb processing
-    for (int i = 0; i < sampleCount * channels; ++i) {
-        float input = samples[i];
-        
-        // Get delayed sample
-        float delayed = delayBuffer[delayIndex];
-        
-        // Apply feedback and damping
-        float feedback = delayed * roomSize * damping;
-        
-        // Store input + feedback in delay buffer
-        delayBuffer[delayIndex] = input + feedback;
-        delayIndex = (delayIndex + 1) % delayBuffer.size();
-        
-        // Mix dry and wet signals
-        samples[i] = (input * dryLevel) + (delayed * wetLevel);
-    }
-}
-
-void AudioSystem::ReverbEffect::SetParameter(const std::string& name, float value) {
-    parameters[name] = value;
-}
-
-float AudioSystem::ReverbEffect::GetParameter(const std::string& name) const {
-    auto it = parameters.find(name);
-    return (it != parameters.end()) ? it->second : 0.0f;
-}
-
-void AudioSystem::EQEffect::Apply(float* samples, int sampleCount, int channels) {
-    if (!samples || sampleCount <= 0 || channels <= 0) return;
-    
-    // Get effect parameters
-    float lowGain = GetParameter("lowGain");
-    float midGain = GetParameter("midGain");
-    float highGain = GetParameter("highGain");
-    float lowFreq = GetParameter("lowFreq");
-    float highFreq = GetParameter("highFreq");
-    
-    // Initialize filter states if needed
-    if (filterStates.size() < 3) {
-        filterStates.resize(3, 0.0f);
-    }
-    
-    // Simple 3-band EQ implementation
-    for (int i = 0; i < sampleCount * channels; ++i) {
-        float input = samples[i];
-        
-        // High-pass filter for high frequencies
-        float high = input - filterStates[0];
-        filterStates[0] += high * (highFreq / 22050.0f);
-        
-        // Band-pass filter for mid frequencies
-        float mid = high - filterStates[1];
-        filterStates[1] += mid * 0.3f;
-        
-        // Low frequencies are what's left
-        float low = input - high - mid;
-        
-        // Apply gains and mix
-        samples[i] = (low * lowGain) + (mid * midGain) + (high * highGain);
-    }
-}
-
-void AudioSystem::EQEffect::SetParameter(const std::string& name, float value) {
-    parameters[name] = value;
-}
-
-float AudioSystem::EQEffect::GetParameter(const std::string& name) const {
-    auto it = parameters.find(name);
-    return (it != parameters.end()) ? it->second : 0.0f;
-}
-
-void AudioSystem::CompressorEffect::Apply(float* samples, int sampleCount, int channels) {
-    if (!samples || sampleCount <= 0 || channels <= 0) return;
-    
-    // Get effect parameters
-    float threshold = GetParameter("threshold");
-    float ratio = GetParameter("ratio");
-    float attack = GetParameter("attack");
-    float release = GetParameter("release");
-    float makeupGain = GetParameter("makeupGain");
-    
-    // Initialize envelope follower if needed
-    if (envelope == 0.0f) {
-        envelope = 0.0001f;
-    }
-    
-    // Apply compression
-    for (int i = 0; i < sampleCount * channels; ++i) {
-        float input = std::abs(samples[i]);
-        
-        // Envelope follower
-        if (input > envelope) {
-            envelope += (input - envelope) * attack;
-        } else {
-            envelope += (input - envelope) * release;
-        }
-        
-        // Calculate gain reduction
-        float gainReduction = 1.0f;
-        if (envelope > threshold) {
-            float excess = envelope - threshold;
-            float compressedExcess = excess / ratio;
-            gainReduction = (threshold + compressedExcess) / envelope;
-        }
-        
-        // Apply compression and makeup gain
-        samples[i] *= gainReduction * makeupGain;
-    }
-}
-
-void AudioSystem::CompressorEffect::SetParameter(const std::string& name, float value) {
-    parameters[name] = value;
-}
-
-float AudioSystem::CompressorEffect::GetParameter(const std::string& name) const {
-    auto it = parameters.find(name);
-    return (it != parameters.end()) ? it->second : 0.0f;
-}
-
 } // namespace Nexus
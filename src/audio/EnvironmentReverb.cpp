@@ -0,0 +1,447 @@
+#include "EnvironmentReverb.h"
+#include <algorithm>
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+namespace {
+constexpr double PI = 3.14159265358979323846;
+
+// Dattorro's input diffuser lengths at 29761Hz, scaled to the reverb's rate
+constexpr uint32_t DIFFUSER_TUNING[FDNReverb::DIFFUSER_COUNT] = { 142, 107, 379, 277 };
+constexpr float DIFFUSER_TUNING_RATE = 29761.0f;
+constexpr float MAX_DIFFUSION = 0.7f;
+
+// The shortest line is LINE_BASE + roomSize * LINE_PER_METRE seconds, the rest spread up to
+// LINE_SPREAD times longer so their echoes never line up
+constexpr float LINE_BASE = 0.003f;
+constexpr float LINE_PER_METRE = 0.0015f;
+constexpr float LINE_SPREAD = 2.8f;
+constexpr float HOUSEHOLDER = 2.0f / FDNReverb::LINE_COUNT;
+constexpr float FDN_OUTPUT_SCALE = 0.25f;
+
+// Each line goes to both ears with its own sign, so the ears hear different mixes of the room
+alignas(16) constexpr float LEFT_SIGNS[FDNReverb::LINE_COUNT] = {
+    1, -1, 1, -1, 1, 1, -1, -1, 1, -1, -1, 1, 1, 1, -1, -1
+};
+alignas(16) constexpr float RIGHT_SIGNS[FDNReverb::LINE_COUNT] = {
+    1, 1, -1, -1, -1, 1, 1, -1, 1, 1, -1, -1, -1, 1, 1, -1
+};
+
+bool IsPrime(uint32_t n) {
+    if (n < 2) return false;
+    for (uint32_t d = 2; d * d <= n; ++d) {
+        if (n % d == 0) return false;
+    }
+    return true;
+}
+
+uint32_t NextPrime(uint32_t n) {
+    while (!IsPrime(n)) ++n;
+    return n;
+}
+
+float HorizontalSum(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+float LineRatio(int line) {
+    return std::pow(LINE_SPREAD, static_cast<float>(line) / (FDNReverb::LINE_COUNT - 1));
+}
+
+uint32_t NextPowerOfTwo(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+}
+
+// AudioFFT implementation
+void AudioFFT::Prepare(uint32_t size) {
+    size_ = size;
+    reversed_.resize(size);
+    uint32_t bits = 0;
+    while ((1u << bits) < size) ++bits;
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < bits; ++b) {
+            if (i & (1u << b)) r |= 1u << (bits - 1 - b);
+        }
+        reversed_[i] = r;
+    }
+
+    cos_.assign(size > 1 ? size - 1 : 0, 0.0f);
+    sin_.assign(cos_.size(), 0.0f);
+    for (uint32_t h = 1; h < size; h <<= 1) {
+        for (uint32_t j = 0; j < h; ++j) {
+            double angle = -PI * j / h;
+            cos_[h - 1 + j] = static_cast<float>(std::cos(angle));
+            sin_[h - 1 + j] = static_cast<float>(std::sin(angle));
+        }
+    }
+}
+
+void AudioFFT::Forward(float* re, float* im) const {
+    Transform(re, im);
+}
+
+void AudioFFT::Inverse(float* re, float* im) const {
+    // Swapping the halves conjugates around the forward transform
+    Transform(im, re);
+    __m128 scale = _mm_set1_ps(1.0f / size_);
+    uint32_t i = 0;
+    for (; i + 4 <= size_; i += 4) {
+        _mm_storeu_ps(re + i, _mm_mul_ps(_mm_loadu_ps(re + i), scale));
+        _mm_storeu_ps(im + i, _mm_mul_ps(_mm_loadu_ps(im + i), scale));
+    }
+    for (; i < size_; ++i) {
+        re[i] /= size_;
+        im[i] /= size_;
+    }
+}
+
+void AudioFFT::Transform(float* re, float* im) const {
+    for (uint32_t i = 0; i < size_; ++i) {
+        uint32_t r = reversed_[i];
+        if (i < r) {
+            std::swap(re[i], re[r]);
+            std::swap(im[i], im[r]);
+        }
+    }
+
+    for (uint32_t h = 1; h < size_; h <<= 1) {
+        const float* c = cos_.data() + h - 1;
+        const float* s = sin_.data() + h - 1;
+        for (uint32_t start = 0; start < size_; start += 2 * h) {
+            float* aRe = re + start;
+            float* aIm = im + start;
+            float* bRe = aRe + h;
+            float* bIm = aIm + h;
+            uint32_t j = 0;
+            if (h >= 4) {
+                for (; j < h; j += 4) {
+                    __m128 wr = _mm_loadu_ps(c + j);
+                    __m128 wi = _mm_loadu_ps(s + j);
+                    __m128 xr = _mm_loadu_ps(bRe + j);
+                    __m128 xi = _mm_loadu_ps(bIm + j);
+                    __m128 tr = _mm_sub_ps(_mm_mul_ps(wr, xr), _mm_mul_ps(wi, xi));
+                    __m128 ti = _mm_add_ps(_mm_mul_ps(wr, xi), _mm_mul_ps(wi, xr));
+                    __m128 ar = _mm_loadu_ps(aRe + j);
+                    __m128 ai = _mm_loadu_ps(aIm + j);
+                    _mm_storeu_ps(bRe + j, _mm_sub_ps(ar, tr));
+                    _mm_storeu_ps(bIm + j, _mm_sub_ps(ai, ti));
+                    _mm_storeu_ps(aRe + j, _mm_add_ps(ar, tr));
+                    _mm_storeu_ps(aIm + j, _mm_add_ps(ai, ti));
+                }
+            }
+            for (; j < h; ++j) {
+                float tr = c[j] * bRe[j] - s[j] * bIm[j];
+                float ti = c[j] * bIm[j] + s[j] * bRe[j];
+                bRe[j] = aRe[j] - tr;
+                bIm[j] = aIm[j] - ti;
+                aRe[j] += tr;
+                aIm[j] += ti;
+            }
+        }
+    }
+}
+
+// FDNReverb implementation
+FDNReverb::FDNReverb()
+    : sampleRate_(0), lines_(), diffusers_(), preDelay_(), gains_(), poles_(), states_(),
+      diffusion_(0.0f), level_(0.0f), tailFrames_(0) {}
+
+void FDNReverb::Prepare(int sampleRate) {
+    sampleRate_ = sampleRate;
+    size_t total = 0;
+    auto allocate = [&](Line& line, uint32_t capacity) {
+        line.start = total;
+        line.capacity = std::max(capacity, 1u);
+        line.length = line.capacity;
+        line.position = 0;
+        total += line.capacity;
+    };
+
+    float longest = (LINE_BASE + MAX_ROOM_SIZE * LINE_PER_METRE) * LINE_SPREAD * sampleRate;
+    // Primes above a length are never far above it, and lines must stay distinct
+    uint32_t lineCapacity = static_cast<uint32_t>(longest) + 256;
+    for (Line& line : lines_) allocate(line, lineCapacity);
+    for (int i = 0; i < DIFFUSER_COUNT; ++i) {
+        allocate(diffusers_[i], static_cast<uint32_t>(DIFFUSER_TUNING[i] * sampleRate / DIFFUSER_TUNING_RATE));
+    }
+    allocate(preDelay_, static_cast<uint32_t>(MAX_PRE_DELAY * sampleRate) + 1);
+
+    buffer_.assign(total, 0.0f);
+    Configure(ReverbSettings());
+}
+
+void FDNReverb::Configure(const ReverbSettings& settings) {
+    if (buffer_.empty()) return;
+
+    float decay = std::max(settings.decayTime, 0.05f);
+    float hfRatio = std::clamp(settings.decayHFRatio, 0.1f, 2.0f);
+    float roomSize = std::clamp(settings.roomSize, 0.0f, MAX_ROOM_SIZE);
+    float base = (LINE_BASE + roomSize * LINE_PER_METRE) * sampleRate_;
+
+    uint32_t previous = 0;
+    for (int i = 0; i < LINE_COUNT; ++i) {
+        uint32_t length = NextPrime(std::max(static_cast<uint32_t>(base * LineRatio(i)), previous + 1));
+        length = std::min(length, lines_[i].capacity);
+        lines_[i].length = length;
+        previous = length;
+
+        // Jot's absorptive delay: the lowpass loses 60dB per decay time at DC and per
+        // decay * hfRatio at Nyquist, whatever the line's length
+        float frames = decay * sampleRate_;
+        float g = std::pow(10.0f, -3.0f * length / frames);
+        float gHigh = std::pow(10.0f, -3.0f * length / (frames * hfRatio));
+        float pole = std::max((g - gHigh) / (g + gHigh), 0.0f);
+        gains_[i] = g * (1.0f - pole);
+        poles_[i] = pole;
+    }
+
+    uint32_t delay = static_cast<uint32_t>(std::clamp(settings.preDelay, 0.0f, MAX_PRE_DELAY) * sampleRate_);
+    preDelay_.length = std::clamp(delay, 1u, preDelay_.capacity);
+    diffusion_ = std::clamp(settings.diffusion, 0.0f, 1.0f) * MAX_DIFFUSION;
+    level_ = std::max(settings.level, 0.0f);
+    tailFrames_ = static_cast<uint32_t>((settings.preDelay + decay * std::max(hfRatio, 1.0f)) * sampleRate_);
+}
+
+void FDNReverb::Reset() {
+    std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+    std::fill(std::begin(states_), std::end(states_), 0.0f);
+}
+
+float FDNReverb::Tap(const Line& line) const {
+    uint32_t read = line.position + line.capacity - line.length;
+    if (read >= line.capacity) read -= line.capacity;
+    return buffer_[line.start + read];
+}
+
+void FDNReverb::Push(Line& line, float value) {
+    buffer_[line.start + line.position] = value;
+    if (++line.position == line.capacity) line.position = 0;
+}
+
+void FDNReverb::Process(const float* input, float* output, uint32_t frameCount) {
+    if (buffer_.empty()) return;
+
+    alignas(16) float taps[LINE_COUNT];
+    alignas(16) float feedback[LINE_COUNT];
+    float scale = level_ * FDN_OUTPUT_SCALE;
+    for (uint32_t f = 0; f < frameCount; ++f) {
+        float x = Tap(preDelay_);
+        Push(preDelay_, input[f]);
+
+        for (Line& diffuser : diffusers_) {
+            float delayed = Tap(diffuser);
+            float v = x + diffusion_ * delayed;
+            Push(diffuser, v);
+            x = delayed - diffusion_ * v;
+        }
+
+        for (int i = 0; i < LINE_COUNT; ++i) taps[i] = Tap(lines_[i]);
+
+        __m128 sum = _mm_setzero_ps();
+        __m128 left = _mm_setzero_ps();
+        __m128 right = _mm_setzero_ps();
+        for (int i = 0; i < LINE_COUNT; i += 4) {
+            __m128 s = _mm_add_ps(_mm_mul_ps(_mm_load_ps(gains_ + i), _mm_load_ps(taps + i)),
+                                  _mm_mul_ps(_mm_load_ps(poles_ + i), _mm_load_ps(states_ + i)));
+            _mm_store_ps(states_ + i, s);
+            sum = _mm_add_ps(sum, s);
+            left = _mm_add_ps(left, _mm_mul_ps(s, _mm_load_ps(LEFT_SIGNS + i)));
+            right = _mm_add_ps(right, _mm_mul_ps(s, _mm_load_ps(RIGHT_SIGNS + i)));
+        }
+
+        // Householder feedback, I - 2/N * ones, plus the diffused input into every line
+        __m128 shift = _mm_set1_ps(x - HOUSEHOLDER * HorizontalSum(sum));
+        for (int i = 0; i < LINE_COUNT; i += 4) {
+            _mm_store_ps(feedback + i, _mm_add_ps(_mm_load_ps(states_ + i), shift));
+        }
+        for (int i = 0; i < LINE_COUNT; ++i) Push(lines_[i], feedback[i]);
+
+        output[f * 2] += HorizontalSum(left) * scale;
+        output[f * 2 + 1] += HorizontalSum(right) * scale;
+    }
+}
+
+// ImpulseResponse implementation
+bool ImpulseResponse::Build(const std::vector<float>& left, const std::vector<float>& right, uint32_t blockFrames) {
+    tiers_.clear();
+    blockFrames_ = 0;
+    length_ = 0;
+    if (blockFrames < 2 || (blockFrames & (blockFrames - 1)) != 0 || blockFrames > MAX_PARTITION) {
+        return false;
+    }
+    uint32_t length = static_cast<uint32_t>(std::max(left.size(), right.size()));
+    if (length == 0) return false;
+
+    blockFrames_ = blockFrames;
+    length_ = length;
+
+    uint32_t size = blockFrames;
+    uint32_t offset = 0;
+    while (offset < length) {
+        // The next tier's partitions start twice their size in, leaving this one to cover the gap.
+        // Growing fourfold leaves a tier at least four blocks to spread its work over
+        uint32_t nextSize = size * 4 <= MAX_PARTITION ? size * 4 : size;
+        uint32_t end = nextSize > size ? nextSize * 2 : length;
+        uint32_t partitions = (std::min(end, length) - offset + size - 1) / size;
+
+        Tier tier;
+        tier.size = size;
+        tier.offset = offset;
+        tier.partitions = partitions;
+        tier.re.assign(static_cast<size_t>(partitions) * size * 2, 0.0f);
+        tier.im.assign(tier.re.size(), 0.0f);
+
+        AudioFFT fft;
+        fft.Prepare(size * 2);
+        for (uint32_t p = 0; p < partitions; ++p) {
+            float* re = tier.re.data() + static_cast<size_t>(p) * size * 2;
+            float* im = tier.im.data() + static_cast<size_t>(p) * size * 2;
+            uint32_t first = offset + p * size;
+            for (uint32_t i = 0; i < size; ++i) {
+                uint32_t n = first + i;
+                re[i] = n < left.size() ? left[n] : 0.0f;
+                im[i] = n < right.size() ? right[n] : 0.0f;
+            }
+            fft.Forward(re, im);
+        }
+        tiers_.push_back(std::move(tier));
+
+        offset = end;
+        size = nextSize;
+    }
+    return true;
+}
+
+// ConvolutionReverb implementation
+ConvolutionReverb::ConvolutionReverb(std::shared_ptr<const ImpulseResponse> response)
+    : response_(std::move(response)), frames_(0) {
+    uint32_t largest = response_->blockFrames_;
+    tiers_.resize(response_->tiers_.size());
+    for (size_t t = 0; t < tiers_.size(); ++t) {
+        const ImpulseResponse::Tier& tier = response_->tiers_[t];
+        TierState& state = tiers_[t];
+        size_t spectrum = static_cast<size_t>(tier.size) * 2;
+        state.fft.Prepare(tier.size * 2);
+        state.steps = tier.size / response_->blockFrames_;
+        // Stagger the tiers so their transforms fall on different blocks
+        state.phase = static_cast<uint32_t>(t % state.steps);
+        state.spectraRe.assign(tier.partitions * spectrum, 0.0f);
+        state.spectraIm.assign(state.spectraRe.size(), 0.0f);
+        state.newest = 0;
+        state.accumulatorRe.assign(spectrum, 0.0f);
+        state.accumulatorIm.assign(spectrum, 0.0f);
+        state.blockEnd = 0;
+        largest = std::max(largest, tier.size);
+    }
+
+    // A window of two partitions plus the block being added, and output up to two partitions ahead
+    uint32_t ring = NextPowerOfTwo(largest * 2 + response_->blockFrames_);
+    history_.assign(ring, 0.0f);
+    pending_.assign(static_cast<size_t>(ring) * 2, 0.0f);
+}
+
+void ConvolutionReverb::Process(const float* input, float* output) {
+    uint32_t block = response_->blockFrames_;
+    size_t mask = history_.size() - 1;
+    for (uint32_t i = 0; i < block; ++i) history_[(frames_ + i) & mask] = input[i];
+    frames_ += block;
+
+    uint64_t index = frames_ / block - 1;
+    for (size_t t = 0; t < tiers_.size(); ++t) {
+        TierState& state = tiers_[t];
+        if (state.steps == 1) {
+            // The first tier has no time to spread over
+            Step(t, 0);
+            continue;
+        }
+        uint32_t step = static_cast<uint32_t>((index + state.phase) % state.steps);
+        Step(t, step);
+    }
+
+    for (uint32_t i = 0; i < block; ++i) {
+        size_t slot = ((frames_ - block + i) & mask) * 2;
+        output[i * 2] += pending_[slot];
+        output[i * 2 + 1] += pending_[slot + 1];
+        pending_[slot] = 0.0f;
+        pending_[slot + 1] = 0.0f;
+    }
+}
+
+void ConvolutionReverb::Step(size_t tier, uint32_t step) {
+    const ImpulseResponse::Tier& response = response_->tiers_[tier];
+    TierState& state = tiers_[tier];
+    uint32_t size = response.size;
+    size_t spectrum = static_cast<size_t>(size) * 2;
+    size_t mask = history_.size() - 1;
+    float* accRe = state.accumulatorRe.data();
+    float* accIm = state.accumulatorIm.data();
+
+    if (step == 0) {
+        // Transform the last two partitions of input, ending where this tier's block starts
+        uint64_t end = state.steps == 1 ? frames_ : frames_ - response_->blockFrames_;
+        state.blockEnd = end;
+        state.newest = (state.newest + 1) % response.partitions;
+        float* re = state.spectraRe.data() + state.newest * spectrum;
+        float* im = state.spectraIm.data() + state.newest * spectrum;
+        for (size_t i = 0; i < spectrum; ++i) {
+            re[i] = history_[(end - spectrum + i) & mask];
+            im[i] = 0.0f;
+        }
+        state.fft.Forward(re, im);
+        std::fill(state.accumulatorRe.begin(), state.accumulatorRe.end(), 0.0f);
+        std::fill(state.accumulatorIm.begin(), state.accumulatorIm.end(), 0.0f);
+    }
+
+    // Middle steps each take a share of the partitions; a tier with one step does them all
+    uint32_t first = 0;
+    uint32_t last = response.partitions;
+    if (state.steps > 1) {
+        uint32_t shares = state.steps - 2;
+        uint32_t share = (response.partitions + shares - 1) / shares;
+        if (step == 0 || step == state.steps - 1) {
+            last = first;
+        } else {
+            first = std::min((step - 1) * share, response.partitions);
+            last = std::min(first + share, response.partitions);
+        }
+    }
+    for (uint32_t p = first; p < last; ++p) {
+        uint32_t slot = (state.newest + response.partitions - p) % response.partitions;
+        const float* xRe = state.spectraRe.data() + slot * spectrum;
+        const float* xIm = state.spectraIm.data() + slot * spectrum;
+        const float* hRe = response.re.data() + p * spectrum;
+        const float* hIm = response.im.data() + p * spectrum;
+        for (size_t i = 0; i < spectrum; i += 4) {
+            __m128 ar = _mm_loadu_ps(xRe + i);
+            __m128 ai = _mm_loadu_ps(xIm + i);
+            __m128 br = _mm_loadu_ps(hRe + i);
+            __m128 bi = _mm_loadu_ps(hIm + i);
+            __m128 re = _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+            __m128 im = _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br));
+            _mm_storeu_ps(accRe + i, _mm_add_ps(_mm_loadu_ps(accRe + i), re));
+            _mm_storeu_ps(accIm + i, _mm_add_ps(_mm_loadu_ps(accIm + i), im));
+        }
+    }
+
+    if (step == state.steps - 1) {
+        state.fft.Inverse(accRe, accIm);
+        // The valid half of the window lands offset frames after the input that made it, which
+        // for the first tier is the block just added
+        uint64_t start = state.blockEnd - size + response.offset;
+        for (uint32_t i = 0; i < size; ++i) {
+            size_t slot = ((start + i) & mask) * 2;
+            pending_[slot] += accRe[size + i];
+            pending_[slot + 1] += accIm[size + i];
+        }
+    }
+}
+
+} // namespace Nexus
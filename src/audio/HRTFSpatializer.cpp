@@ -0,0 +1,933 @@
+#include "HRTFSpatializer.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+namespace {
+constexpr double PI = 3.14159265358979323846;
+constexpr uint32_t CHANNELS = HRTFSet::AMBISONIC_CHANNELS;
+
+// Spherical head model after Brown and Duda: head radius, the shadow's depth and where it is
+// deepest, and the pinna's echoes as gain, delay swing, base delay and elevation scale, in frames
+// at PINNA_RATE
+constexpr double HEAD_RADIUS = 0.0875;
+constexpr double SPEED_OF_SOUND = 343.0;
+constexpr double SHADOW_MIN = 0.1;
+constexpr double SHADOW_ANGLE = 150.0 * PI / 180.0;
+constexpr double PINNA_RATE = 44100.0;
+constexpr double PINNA_GAIN[] = { 0.5, -1.0, 0.5, -0.25, 0.25 };
+constexpr double PINNA_SWING[] = { 1.0, 5.0, 5.0, 5.0, 5.0 };
+constexpr double PINNA_BASE[] = { 2.0, 4.0, 7.0, 11.0, 13.0 };
+constexpr double PINNA_SCALE[] = { 1.0, 0.5, 0.5, 0.5, 0.5 };
+// Highs lost to the pinna from directly behind, above REAR_CORNER Hz
+constexpr double REAR_SHADOW = 0.6;
+constexpr double REAR_CORNER = 4000.0;
+// Frames before the first arrival, so a fractional delay's ringing isn't wrapped round
+constexpr double ONSET_MARGIN = 4.0;
+constexpr double HEAD_RESPONSE_SECONDS = 0.004;
+
+// An arrival starts where the response first reaches this fraction of its peak, less PRE_ROLL
+// frames to keep what leads into it
+constexpr float ONSET_THRESHOLD = 0.1f;
+constexpr uint32_t PRE_ROLL = 2;
+constexpr float RING_TOLERANCE = 1e-3f;
+
+// Weights that narrow a second order decode's lobes for the sharpest image (max rE)
+constexpr float ORDER_WEIGHTS[HRTFSet::AMBISONIC_ORDER + 1] = { 1.0f, 0.7745967f, 0.4f };
+constexpr uint32_t CHANNEL_ORDERS[CHANNELS] = { 0, 1, 1, 1, 2, 2, 2, 2, 2 };
+
+// A slot keeps its voice until another is this much louder
+constexpr float HOLD_BONUS = 1.5f;
+// Fewer slots than this render inline; handing them out costs more than it saves
+constexpr size_t PARALLEL_MIN_WORK = 4;
+
+uint32_t NextPowerOfTwo(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+float WrapAngle(float angle) {
+    angle = std::fmod(angle + static_cast<float>(PI), static_cast<float>(2.0 * PI));
+    if (angle < 0.0f) angle += static_cast<float>(2.0 * PI);
+    return angle - static_cast<float>(PI);
+}
+
+// Real spherical harmonics up to second order in ACN order with N3D normalisation. Ambisonics has
+// x ahead, y left and z up; listener space has x right, y up and z ahead
+void EncodeAmbisonics(const float direction[3], float coefficients[CHANNELS]) {
+    const float sqrt3 = 1.7320508f;
+    const float sqrt15 = 3.8729833f;
+    const float sqrt5 = 2.2360680f;
+    float x = direction[2];
+    float y = -direction[0];
+    float z = direction[1];
+    coefficients[0] = 1.0f;
+    coefficients[1] = sqrt3 * y;
+    coefficients[2] = sqrt3 * z;
+    coefficients[3] = sqrt3 * x;
+    coefficients[4] = sqrt15 * x * y;
+    coefficients[5] = sqrt15 * y * z;
+    coefficients[6] = 0.5f * sqrt5 * (3.0f * z * z - 1.0f);
+    coefficients[7] = sqrt15 * x * z;
+    coefficients[8] = 0.5f * sqrt15 * (x * x - y * y);
+}
+
+// Adds a * b into sum, for spectra of size bins
+void MultiplyAdd(const float* aRe, const float* aIm, const float* bRe, const float* bIm, float* sumRe, float* sumIm,
+                 size_t size) {
+    for (size_t i = 0; i < size; i += 4) {
+        __m128 ar = _mm_loadu_ps(aRe + i);
+        __m128 ai = _mm_loadu_ps(aIm + i);
+        __m128 br = _mm_loadu_ps(bRe + i);
+        __m128 bi = _mm_loadu_ps(bIm + i);
+        __m128 re = _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+        __m128 im = _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br));
+        _mm_storeu_ps(sumRe + i, _mm_add_ps(_mm_loadu_ps(sumRe + i), re));
+        _mm_storeu_ps(sumIm + i, _mm_add_ps(_mm_loadu_ps(sumIm + i), im));
+    }
+}
+
+// Adds input ramped from start to end across frameCount frames into output
+void AddRamped(const float* input, float* output, uint32_t frameCount, float start, float end) {
+    float step = (end - start) / frameCount;
+    __m128 gain = _mm_add_ps(_mm_set1_ps(start + step), _mm_mul_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(step)));
+    const __m128 advance = _mm_set1_ps(step * 4.0f);
+    for (uint32_t f = 0; f < frameCount; f += 4) {
+        _mm_storeu_ps(output + f, _mm_add_ps(_mm_loadu_ps(output + f), _mm_mul_ps(_mm_loadu_ps(input + f), gain)));
+        gain = _mm_add_ps(gain, advance);
+    }
+}
+
+void AddStereo(const float* input, float* output, uint32_t frameCount) {
+    for (uint32_t i = 0; i < frameCount * 2; i += 4) {
+        _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_loadu_ps(input + i)));
+    }
+}
+
+#ifndef NEXUS_STEAM_AUDIO_ENABLED
+bool SameNeighbours(const HRTFSet::Neighbours& a, const HRTFSet::Neighbours& b) {
+    for (int i = 0; i < 4; ++i) {
+        if (a.points[i] != b.points[i] || std::abs(a.weights[i] - b.weights[i]) > 1e-4f) return false;
+    }
+    return true;
+}
+#endif
+}
+
+// HRTFSet implementation
+std::vector<HRIRMeasurement> HRTFSet::SphericalHead(int sampleRate) {
+    const uint32_t length = NextPowerOfTwo(static_cast<uint32_t>(sampleRate * HEAD_RESPONSE_SECONDS));
+    // Synthesised well past length, so the model's tails have room before they wrap
+    const uint32_t size = length * 4;
+    AudioFFT fft;
+    fft.Prepare(size);
+    std::vector<float> re(size);
+    std::vector<float> im(size);
+
+    const double omega0 = SPEED_OF_SOUND / HEAD_RADIUS;
+    const double rearCorner = 2.0 * PI * REAR_CORNER;
+    std::vector<HRIRMeasurement> measurements;
+    for (int elevation = -40; elevation <= 90; elevation += 10) {
+        int step = elevation == 90 ? 360 : 10;
+        for (int azimuth = -180; azimuth < 180; azimuth += step) {
+            HRIRMeasurement measurement;
+            measurement.azimuth = static_cast<float>(azimuth * PI / 180.0);
+            measurement.elevation = static_cast<float>(elevation * PI / 180.0);
+            double x = std::cos(measurement.elevation) * std::sin(measurement.azimuth);
+            double y = std::sin(measurement.elevation);
+            double z = std::cos(measurement.elevation) * std::cos(measurement.azimuth);
+
+            for (int ear = 0; ear < 2; ++ear) {
+                double side = ear == 0 ? -x : x;
+                // Angle from the ear's axis: the shadow deepens and the path around the head grows
+                double incidence = std::acos(std::clamp(side, -1.0, 1.0));
+                double alpha = (1.0 + SHADOW_MIN / 2.0) + (1.0 - SHADOW_MIN / 2.0) * std::cos(incidence / SHADOW_ANGLE * PI);
+                double delay = incidence < PI / 2.0 ? 1.0 - std::cos(incidence) : 1.0 + incidence - PI / 2.0;
+                delay = delay * HEAD_RADIUS / SPEED_OF_SOUND * sampleRate + ONSET_MARGIN;
+
+                // Pinna echoes move with elevation around the ear's own axis
+                double lateral = std::asin(std::clamp(side, -1.0, 1.0));
+                double polar = std::atan2(y, z);
+                double echoes[std::size(PINNA_GAIN)];
+                for (size_t k = 0; k < std::size(PINNA_GAIN); ++k) {
+                    double frames = PINNA_SWING[k] * std::cos(lateral / 2.0) * std::sin(PINNA_SCALE[k] * (PI / 2.0 - polar)) + PINNA_BASE[k];
+                    echoes[k] = std::max(frames, 1.0) * sampleRate / PINNA_RATE;
+                }
+                double rear = 1.0 - REAR_SHADOW * std::max(-z, 0.0);
+
+                for (uint32_t k = 0; k <= size / 2; ++k) {
+                    double omega = 2.0 * PI * k * sampleRate / size;
+                    double phase = 2.0 * PI * k / size;
+                    // (1 + j alpha w / 2w0) / (1 + j w / 2w0)
+                    double s = omega / (2.0 * omega0);
+                    double shadowRe = (1.0 + alpha * s * s) / (1.0 + s * s);
+                    double shadowIm = (alpha - 1.0) * s / (1.0 + s * s);
+                    double r = omega / rearCorner;
+                    double rearRe = (1.0 + rear * r * r) / (1.0 + r * r);
+                    double rearIm = (rear - 1.0) * r / (1.0 + r * r);
+                    double pinnaRe = 1.0;
+                    double pinnaIm = 0.0;
+                    for (size_t e = 0; e < std::size(PINNA_GAIN); ++e) {
+                        pinnaRe += PINNA_GAIN[e] * std::cos(phase * echoes[e]);
+                        pinnaIm -= PINNA_GAIN[e] * std::sin(phase * echoes[e]);
+                    }
+                    double hRe = shadowRe * rearRe - shadowIm * rearIm;
+                    double hIm = shadowRe * rearIm + shadowIm * rearRe;
+                    double pRe = hRe * pinnaRe - hIm * pinnaIm;
+                    double pIm = hRe * pinnaIm + hIm * pinnaRe;
+                    double dRe = std::cos(phase * delay);
+                    double dIm = -std::sin(phase * delay);
+                    re[k] = static_cast<float>(pRe * dRe - pIm * dIm);
+                    im[k] = static_cast<float>(pRe * dIm + pIm * dRe);
+                    if (k == 0 || k == size / 2) {
+                        im[k] = 0.0f;
+                    } else {
+                        re[size - k] = re[k];
+                        im[size - k] = -im[k];
+                    }
+                }
+                fft.Inverse(re.data(), im.data());
+                (ear == 0 ? measurement.left : measurement.right).assign(re.begin(), re.begin() + length);
+            }
+            measurements.push_back(std::move(measurement));
+        }
+    }
+    return measurements;
+}
+
+bool HRTFSet::Build(const std::vector<HRIRMeasurement>& measurements, uint32_t blockFrames) {
+    rings_.clear();
+    if (measurements.empty() || blockFrames <= MAX_DELAY || (blockFrames & (blockFrames - 1)) != 0) return false;
+
+    const size_t count = measurements.size();
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const HRIRMeasurement& ma = measurements[a];
+        const HRIRMeasurement& mb = measurements[b];
+        if (std::abs(ma.elevation - mb.elevation) > RING_TOLERANCE) return ma.elevation < mb.elevation;
+        return WrapAngle(ma.azimuth) < WrapAngle(mb.azimuth);
+    });
+
+    // Where each ear's sound arrives; the earliest anywhere in the set becomes no delay
+    std::vector<uint32_t> starts(count * 2);
+    uint32_t earliest = UINT32_MAX;
+    uint32_t taps = 0;
+    for (size_t i = 0; i < count; ++i) {
+        for (int ear = 0; ear < 2; ++ear) {
+            const std::vector<float>& response = ear == 0 ? measurements[order[i]].left : measurements[order[i]].right;
+            float peak = 0.0f;
+            for (float value : response) peak = std::max(peak, std::abs(value));
+            uint32_t onset = 0;
+            while (onset < response.size() && std::abs(response[onset]) < peak * ONSET_THRESHOLD) ++onset;
+            if (peak == 0.0f) onset = 0;
+            uint32_t start = onset > PRE_ROLL ? onset - PRE_ROLL : 0;
+            starts[i * 2 + ear] = start;
+            earliest = std::min(earliest, start);
+            if (response.size() > start) taps = std::max(taps, static_cast<uint32_t>(response.size()) - start);
+        }
+    }
+    taps = std::min(taps, MAX_TAPS);
+    if (taps == 0) return false;
+
+    // Responses from their arrival, faded out over their last eighth, at a level where the
+    // average over directions of both ears' energy is one, the same as the panner's
+    const uint32_t fade = std::max(taps / 8, 1u);
+    std::vector<float> aligned(count * 2 * taps, 0.0f);
+    delays_.resize(count * 2);
+    double energy = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        for (int ear = 0; ear < 2; ++ear) {
+            const std::vector<float>& response = ear == 0 ? measurements[order[i]].left : measurements[order[i]].right;
+            uint32_t start = starts[i * 2 + ear];
+            float* out = aligned.data() + (i * 2 + ear) * taps;
+            for (uint32_t t = 0; t < taps && start + t < response.size(); ++t) {
+                float window = t < taps - fade ? 1.0f : 0.5f + 0.5f * static_cast<float>(std::cos(PI * (t - (taps - fade) + 1) / (fade + 1)));
+                out[t] = response[start + t] * window;
+                energy += double(out[t]) * out[t];
+            }
+            delays_[i * 2 + ear] = static_cast<float>(std::min(start - earliest, MAX_DELAY));
+        }
+    }
+    float scale = energy > 0.0 ? static_cast<float>(1.0 / std::sqrt(energy / count)) : 1.0f;
+    for (float& value : aligned) value *= scale;
+
+    blockFrames_ = blockFrames;
+    partitions_ = (taps + blockFrames - 1) / blockFrames;
+    const size_t spectrum = size_t(blockFrames) * 2;
+    AudioFFT fft;
+    fft.Prepare(blockFrames * 2);
+    re_.assign(count * partitions_ * spectrum, 0.0f);
+    im_.assign(re_.size(), 0.0f);
+    azimuths_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        azimuths_[i] = WrapAngle(measurements[order[i]].azimuth);
+        const float* left = aligned.data() + i * 2 * taps;
+        const float* right = left + taps;
+        for (uint32_t p = 0; p < partitions_; ++p) {
+            float* re = re_.data() + (i * partitions_ + p) * spectrum;
+            float* im = im_.data() + (i * partitions_ + p) * spectrum;
+            for (uint32_t t = 0; t < blockFrames && p * blockFrames + t < taps; ++t) {
+                re[t] = left[p * blockFrames + t];
+                im[t] = right[p * blockFrames + t];
+            }
+            fft.Forward(re, im);
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        float elevation = measurements[order[i]].elevation;
+        if (rings_.empty() || std::abs(elevation - rings_.back().elevation) > RING_TOLERANCE) {
+            rings_.push_back({ elevation, static_cast<uint32_t>(i), 0 });
+        }
+        rings_.back().count++;
+    }
+
+    // Virtual speakers at an icosahedron's corners decode a second order bed exactly. Each
+    // channel's filter is every speaker's response, arrival delays included, weighted by how
+    // much of the channel that speaker plays
+    const float golden = 1.6180340f;
+    const float corners[12][3] = {
+        { 0, 1, golden }, { 0, -1, golden }, { 0, 1, -golden }, { 0, -1, -golden },
+        { 1, golden, 0 }, { -1, golden, 0 }, { 1, -golden, 0 }, { -1, -golden, 0 },
+        { golden, 0, 1 }, { -golden, 0, 1 }, { golden, 0, -1 }, { -golden, 0, -1 }
+    };
+    const uint32_t bedTaps = taps + MAX_DELAY + 1;
+    bedPartitions_ = (bedTaps + blockFrames - 1) / blockFrames;
+    std::vector<float> bed(size_t(CHANNELS) * 2 * bedTaps, 0.0f);
+    std::vector<float> blended(size_t(taps) * 2);
+    for (const float* corner : corners) {
+        float norm = std::sqrt(corner[0] * corner[0] + corner[1] * corner[1] + corner[2] * corner[2]);
+        float direction[3] = { corner[0] / norm, corner[1] / norm, corner[2] / norm };
+        Neighbours neighbours = Locate(direction);
+        std::fill(blended.begin(), blended.end(), 0.0f);
+        float delays[2] = { 0.0f, 0.0f };
+        for (int n = 0; n < 4; ++n) {
+            const float* response = aligned.data() + size_t(neighbours.points[n]) * 2 * taps;
+            for (size_t t = 0; t < blended.size(); ++t) blended[t] += response[t] * neighbours.weights[n];
+            delays[0] += delays_[neighbours.points[n] * 2] * neighbours.weights[n];
+            delays[1] += delays_[neighbours.points[n] * 2 + 1] * neighbours.weights[n];
+        }
+
+        float gains[CHANNELS];
+        EncodeAmbisonics(direction, gains);
+        for (uint32_t c = 0; c < CHANNELS; ++c) {
+            float gain = gains[c] * ORDER_WEIGHTS[CHANNEL_ORDERS[c]] / std::size(corners);
+            for (int ear = 0; ear < 2; ++ear) {
+                const float* response = blended.data() + ear * taps;
+                float* out = bed.data() + (size_t(c) * 2 + ear) * bedTaps;
+                for (uint32_t t = 0; t < bedTaps; ++t) {
+                    float at = t - delays[ear];
+                    if (at < 0.0f) continue;
+                    uint32_t index = static_cast<uint32_t>(at);
+                    float frac = at - index;
+                    float a = index < taps ? response[index] : 0.0f;
+                    float b = index + 1 < taps ? response[index + 1] : 0.0f;
+                    out[t] += gain * (a + (b - a) * frac);
+                }
+            }
+        }
+    }
+    bedRe_.assign(size_t(CHANNELS) * bedPartitions_ * spectrum, 0.0f);
+    bedIm_.assign(bedRe_.size(), 0.0f);
+    for (uint32_t c = 0; c < CHANNELS; ++c) {
+        const float* left = bed.data() + size_t(c) * 2 * bedTaps;
+        const float* right = left + bedTaps;
+        for (uint32_t p = 0; p < bedPartitions_; ++p) {
+            float* re = bedRe_.data() + (size_t(c) * bedPartitions_ + p) * spectrum;
+            float* im = bedIm_.data() + (size_t(c) * bedPartitions_ + p) * spectrum;
+            for (uint32_t t = 0; t < blockFrames && p * blockFrames + t < bedTaps; ++t) {
+                re[t] = left[p * blockFrames + t];
+                im[t] = right[p * blockFrames + t];
+            }
+            fft.Forward(re, im);
+        }
+    }
+    return true;
+}
+
+void HRTFSet::LocateInRing(const Ring& ring, float azimuth, uint32_t& a, uint32_t& b, float& t) const {
+    if (ring.count == 1) {
+        a = b = ring.first;
+        t = 0.0f;
+        return;
+    }
+    const float* begin = azimuths_.data() + ring.first;
+    const float* end = begin + ring.count;
+    uint32_t upper = static_cast<uint32_t>(std::upper_bound(begin, end, azimuth) - begin);
+    uint32_t lower = (upper + ring.count - 1) % ring.count;
+    upper %= ring.count;
+    a = ring.first + lower;
+    b = ring.first + upper;
+    // Either may be across the wrap at the back
+    float span = WrapAngle(azimuths_[b] - azimuths_[a]);
+    if (span <= 0.0f) span += static_cast<float>(2.0 * PI);
+    float offset = WrapAngle(azimuth - azimuths_[a]);
+    if (offset < 0.0f) offset += static_cast<float>(2.0 * PI);
+    t = std::clamp(offset / span, 0.0f, 1.0f);
+}
+
+HRTFSet::Neighbours HRTFSet::Locate(const float direction[3]) const {
+    float azimuth = std::atan2(direction[0], direction[2]);
+    float elevation = std::asin(std::clamp(direction[1], -1.0f, 1.0f));
+
+    // The rings either side, or the nearest twice beyond the first and last
+    size_t upper = 0;
+    while (upper < rings_.size() && rings_[upper].elevation <= elevation) ++upper;
+    size_t lower = upper > 0 ? upper - 1 : 0;
+    upper = std::min(upper, rings_.size() - 1);
+    float te = 0.0f;
+    if (upper != lower) te = (elevation - rings_[lower].elevation) / (rings_[upper].elevation - rings_[lower].elevation);
+
+    Neighbours neighbours;
+    float ta;
+    float tb;
+    LocateInRing(rings_[lower], azimuth, neighbours.points[0], neighbours.points[1], ta);
+    LocateInRing(rings_[upper], azimuth, neighbours.points[2], neighbours.points[3], tb);
+    neighbours.weights[0] = (1.0f - te) * (1.0f - ta);
+    neighbours.weights[1] = (1.0f - te) * ta;
+    neighbours.weights[2] = te * (1.0f - tb);
+    neighbours.weights[3] = te * tb;
+    return neighbours;
+}
+
+void HRTFSet::Interpolate(const Neighbours& neighbours, float* re, float* im, float delays[2]) const {
+    const size_t size = size_t(partitions_) * blockFrames_ * 2;
+    std::fill(re, re + size, 0.0f);
+    std::fill(im, im + size, 0.0f);
+    delays[0] = 0.0f;
+    delays[1] = 0.0f;
+    for (int n = 0; n < 4; ++n) {
+        float weight = neighbours.weights[n];
+        if (weight == 0.0f) continue;
+        uint32_t point = neighbours.points[n];
+        const float* pointRe = re_.data() + point * size;
+        const float* pointIm = im_.data() + point * size;
+        __m128 w = _mm_set1_ps(weight);
+        for (size_t i = 0; i < size; i += 4) {
+            _mm_storeu_ps(re + i, _mm_add_ps(_mm_loadu_ps(re + i), _mm_mul_ps(_mm_loadu_ps(pointRe + i), w)));
+            _mm_storeu_ps(im + i, _mm_add_ps(_mm_loadu_ps(im + i), _mm_mul_ps(_mm_loadu_ps(pointIm + i), w)));
+        }
+        delays[0] += delays_[point * 2] * weight;
+        delays[1] += delays_[point * 2 + 1] * weight;
+    }
+}
+
+// HRTFSpatializer implementation
+HRTFSpatializer::HRTFSpatializer()
+    : blockFrames_(0)
+    , nearLimit_(DEFAULT_NEAR_VOICES)
+    , block_(1)
+    , bedScale_(1.0f)
+    , bedTailBlocks_(0)
+    , bedActive_(false)
+    , bedTail_(0)
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+    , context_(nullptr)
+    , hrtf_(nullptr)
+    , decode_(nullptr)
+#else
+    , bedNewest_(0)
+#endif
+{}
+
+HRTFSpatializer::~HRTFSpatializer() {
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+    ReleaseSteamAudio();
+#endif
+}
+
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+void HRTFSpatializer::ReleaseSteamAudio() {
+    for (Slot& slot : slots_) {
+        if (slot.effect) iplBinauralEffectRelease(&slot.effect);
+    }
+    if (decode_) iplAmbisonicsDecodeEffectRelease(&decode_);
+    if (hrtf_) iplHRTFRelease(&hrtf_);
+    if (context_) iplContextRelease(&context_);
+}
+#endif
+
+bool HRTFSpatializer::Prepare(int sampleRate, uint32_t blockFrames, uint32_t maxVoices) {
+    voices_.clear();
+    if (sampleRate <= 0 || maxVoices == 0 || blockFrames <= HRTFSet::MAX_DELAY || (blockFrames & (blockFrames - 1)) != 0) {
+        return false;
+    }
+    blockFrames_ = blockFrames;
+    slots_.resize(MAX_NEAR_VOICES);
+
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+    ReleaseSteamAudio();
+    // Only effects are created, never a simulator, so Steam Audio has no threads of its own
+    IPLContextSettings contextSettings = {};
+    contextSettings.version = STEAMAUDIO_VERSION;
+    contextSettings.simdLevel = IPL_SIMDLEVEL_AVX2;
+    IPLAudioSettings audioSettings = { sampleRate, static_cast<IPLint32>(blockFrames) };
+    IPLHRTFSettings hrtfSettings = {};
+    hrtfSettings.type = IPL_HRTFTYPE_DEFAULT;
+    hrtfSettings.volume = 1.0f;
+    hrtfSettings.normType = IPL_HRTFNORMTYPE_NONE;
+    if (iplContextCreate(&contextSettings, &context_) != IPL_STATUS_SUCCESS ||
+        iplHRTFCreate(context_, &audioSettings, &hrtfSettings, &hrtf_) != IPL_STATUS_SUCCESS) {
+        return false;
+    }
+    IPLAmbisonicsDecodeEffectSettings decodeSettings = {};
+    decodeSettings.speakerLayout.type = IPL_SPEAKERLAYOUTTYPE_STEREO;
+    decodeSettings.hrtf = hrtf_;
+    decodeSettings.maxOrder = HRTFSet::AMBISONIC_ORDER;
+    if (iplAmbisonicsDecodeEffectCreate(context_, &audioSettings, &decodeSettings, &decode_) != IPL_STATUS_SUCCESS) {
+        return false;
+    }
+    for (Slot& slot : slots_) {
+        IPLBinauralEffectSettings effectSettings = { hrtf_ };
+        if (iplBinauralEffectCreate(context_, &audioSettings, &effectSettings, &slot.effect) != IPL_STATUS_SUCCESS) {
+            return false;
+        }
+        slot.input.assign(blockFrames, 0.0f);
+        slot.planar.assign(size_t(blockFrames) * 2, 0.0f);
+    }
+    // Steam Audio's encoding is orthonormal rather than N3D
+    bedScale_ = static_cast<float>(1.0 / std::sqrt(4.0 * PI));
+    bedTailBlocks_ = 2;
+    bedPlanar_.assign(size_t(blockFrames) * 2, 0.0f);
+#else
+    if (!set_.Build(HRTFSet::SphericalHead(sampleRate), blockFrames)) return false;
+    fft_.Prepare(blockFrames * 2);
+    const size_t spectrum = size_t(blockFrames) * 2;
+    const uint32_t ring = NextPowerOfTwo(blockFrames + HRTFSet::MAX_DELAY + 2);
+    for (Slot& slot : slots_) {
+        slot.history.assign(spectrum, 0.0f);
+        slot.spectraRe.assign(set_.GetPartitions() * spectrum, 0.0f);
+        slot.spectraIm.assign(slot.spectraRe.size(), 0.0f);
+        slot.filterRe.assign(slot.spectraRe.size(), 0.0f);
+        slot.filterIm.assign(slot.spectraRe.size(), 0.0f);
+        slot.nextRe.assign(slot.spectraRe.size(), 0.0f);
+        slot.nextIm.assign(slot.spectraRe.size(), 0.0f);
+        slot.workRe.assign(spectrum, 0.0f);
+        slot.workIm.assign(spectrum, 0.0f);
+        slot.fadeRe.assign(spectrum, 0.0f);
+        slot.fadeIm.assign(spectrum, 0.0f);
+        slot.delayLeft.assign(ring, 0.0f);
+        slot.delayRight.assign(ring, 0.0f);
+    }
+    bedScale_ = 1.0f;
+    bedTailBlocks_ = set_.GetBedPartitions();
+    bedHistory_.assign(CHANNELS * spectrum, 0.0f);
+    bedSpectraRe_.assign(CHANNELS * set_.GetBedPartitions() * spectrum, 0.0f);
+    bedSpectraIm_.assign(bedSpectraRe_.size(), 0.0f);
+    bedNewest_ = 0;
+    bedWorkRe_.assign(spectrum, 0.0f);
+    bedWorkIm_.assign(spectrum, 0.0f);
+    bedSumRe_.assign(spectrum, 0.0f);
+    bedSumIm_.assign(spectrum, 0.0f);
+#endif
+
+    for (Slot& slot : slots_) {
+        slot.output.assign(size_t(blockFrames) * 2, 0.0f);
+        slot.state = SlotState::Free;
+        ResetSlot(slot);
+    }
+    VoiceState idle = {};
+    idle.slot = NO_SLOT;
+    idle.fresh = true;
+    voices_.assign(maxVoices, idle);
+    inputs_.assign(size_t(maxVoices) * blockFrames, 0.0f);
+    submitted_.clear();
+    submitted_.reserve(maxVoices);
+    ranked_.reserve(maxVoices);
+    work_.reserve(MAX_NEAR_VOICES + 1);
+    bedInput_.assign(size_t(CHANNELS) * blockFrames, 0.0f);
+    bedOutput_.assign(size_t(blockFrames) * 2, 0.0f);
+    block_ = 1;
+    bedActive_ = false;
+    bedTail_ = 0;
+    return true;
+}
+
+float* HRTFSpatializer::Submit(uint32_t voice, const float direction[3], float loudness) {
+    if (voice >= voices_.size()) return nullptr;
+    VoiceState& state = voices_[voice];
+    if (state.submitted != block_) {
+        // Missing a block means it stopped or paused in between, and starts over
+        if (state.submitted + 1 != block_) state.fresh = true;
+        state.submitted = block_;
+        submitted_.push_back(voice);
+    }
+    std::copy(direction, direction + 3, state.direction);
+    state.loudness = loudness;
+    return inputs_.data() + size_t(voice) * blockFrames_;
+}
+
+void HRTFSpatializer::Restart(uint32_t voice) {
+    if (voice >= voices_.size()) return;
+    VoiceState& state = voices_[voice];
+    state.fresh = true;
+    if (state.slot != NO_SLOT) {
+        // The old sound's tail still rings out of the slot
+        slots_[state.slot].state = SlotState::Draining;
+        state.slot = NO_SLOT;
+    }
+}
+
+void HRTFSpatializer::Render(float* output, JobSystem* jobs) {
+    if (!IsPrepared()) return;
+
+    // Slots whose voice wasn't submitted this block ring out
+    for (Slot& slot : slots_) {
+        if (slot.state == SlotState::Active && voices_[slot.voice].submitted != block_) {
+            voices_[slot.voice].slot = NO_SLOT;
+            slot.state = SlotState::Draining;
+        }
+    }
+
+    Rank();
+    for (uint32_t voice : submitted_) {
+        VoiceState& state = voices_[voice];
+        if (state.near && state.slot == NO_SLOT) {
+            for (uint32_t s = 0; s < slots_.size(); ++s) {
+                Slot& slot = slots_[s];
+                if (slot.state != SlotState::Free) continue;
+                ResetSlot(slot);
+                slot.state = SlotState::Active;
+                slot.voice = voice;
+                state.slot = s;
+                // A voice already playing fades over from the bed
+                state.blend = state.fresh ? 1.0f : 0.0f;
+                break;
+            }
+        }
+        if (state.slot != NO_SLOT) {
+            Slot& slot = slots_[state.slot];
+            slot.blendStart = state.blend;
+            slot.blendEnd = state.near ? 1.0f : 0.0f;
+            slot.releasing = !state.near;
+            std::copy(state.direction, state.direction + 3, slot.direction);
+        }
+    }
+    EncodeBed();
+
+    work_.clear();
+    for (uint32_t s = 0; s < slots_.size(); ++s) {
+        if (slots_[s].state != SlotState::Free) work_.push_back(s);
+    }
+    const uint32_t bed = static_cast<uint32_t>(slots_.size());
+    if (bedActive_ || bedTail_ > 0) work_.push_back(bed);
+
+    auto render = [this, bed](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (work_[i] == bed) ProcessBed();
+            else ProcessSlot(slots_[work_[i]]);
+        }
+    };
+    if (jobs && work_.size() >= PARALLEL_MIN_WORK) jobs->ParallelFor(work_.size(), 1, render);
+    else render(0, work_.size());
+
+    for (uint32_t s : work_) {
+        if (s == bed) {
+            AddStereo(bedOutput_.data(), output, blockFrames_);
+            continue;
+        }
+        Slot& slot = slots_[s];
+        AddStereo(slot.output.data(), output, blockFrames_);
+        if (slot.state == SlotState::Draining) {
+            slot.state = SlotState::Free;
+        } else if (slot.releasing) {
+            voices_[slot.voice].slot = NO_SLOT;
+            slot.state = SlotState::Draining;
+        }
+    }
+
+    bedTail_ = bedActive_ ? bedTailBlocks_ : (bedTail_ > 0 ? bedTail_ - 1 : 0);
+    submitted_.clear();
+    block_++;
+}
+
+void HRTFSpatializer::Rank() {
+    ranked_.clear();
+    for (uint32_t voice : submitted_) {
+        VoiceState& state = voices_[voice];
+        state.near = false;
+        if (state.loudness > 0.0f) ranked_.push_back(voice);
+    }
+    auto score = [this](uint32_t voice) {
+        const VoiceState& state = voices_[voice];
+        return state.slot != NO_SLOT ? state.loudness * HOLD_BONUS : state.loudness;
+    };
+    size_t limit = std::min<size_t>(nearLimit_, ranked_.size());
+    if (limit < ranked_.size()) {
+        std::nth_element(ranked_.begin(), ranked_.begin() + limit, ranked_.end(),
+                         [&](uint32_t a, uint32_t b) { return score(a) > score(b); });
+    }
+    for (size_t i = 0; i < limit; ++i) voices_[ranked_[i]].near = true;
+}
+
+void HRTFSpatializer::EncodeBed() {
+    bedActive_ = false;
+    std::fill(bedInput_.begin(), bedInput_.end(), 0.0f);
+    for (uint32_t voice : submitted_) {
+        VoiceState& state = voices_[voice];
+        float start = 0.0f;
+        float end = 0.0f;
+        if (state.slot != NO_SLOT) {
+            start = slots_[state.slot].blendStart;
+            end = slots_[state.slot].blendEnd;
+        }
+        float gains[CHANNELS];
+        EncodeAmbisonics(state.direction, gains);
+        for (float& gain : gains) gain *= bedScale_;
+        if (state.fresh) {
+            for (uint32_t c = 0; c < CHANNELS; ++c) state.bed[c] = gains[c] * (1.0f - start);
+        }
+
+        // Whatever hasn't gone through its slot, ramping from where the last block left off
+        const float* input = inputs_.data() + size_t(voice) * blockFrames_;
+        bool audible = state.loudness > 0.0f && (start < 1.0f || end < 1.0f);
+        for (uint32_t c = 0; c < CHANNELS; ++c) {
+            float target = gains[c] * (1.0f - end);
+            if (audible && (state.bed[c] != 0.0f || target != 0.0f)) {
+                AddRamped(input, bedInput_.data() + size_t(c) * blockFrames_, blockFrames_, state.bed[c], target);
+                bedActive_ = true;
+            }
+            state.bed[c] = target;
+        }
+        state.blend = end;
+        state.fresh = false;
+    }
+}
+
+void HRTFSpatializer::ResetSlot(Slot& slot) {
+    slot.fresh = true;
+    slot.releasing = false;
+    slot.blendStart = 0.0f;
+    slot.blendEnd = 0.0f;
+    slot.direction[0] = 0.0f;
+    slot.direction[1] = 0.0f;
+    slot.direction[2] = 1.0f;
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+    if (slot.effect) iplBinauralEffectReset(slot.effect);
+#else
+    std::fill(slot.history.begin(), slot.history.end(), 0.0f);
+    std::fill(slot.spectraRe.begin(), slot.spectraRe.end(), 0.0f);
+    std::fill(slot.spectraIm.begin(), slot.spectraIm.end(), 0.0f);
+    std::fill(slot.delayLeft.begin(), slot.delayLeft.end(), 0.0f);
+    std::fill(slot.delayRight.begin(), slot.delayRight.end(), 0.0f);
+    slot.newest = 0;
+    slot.delays[0] = 0.0f;
+    slot.delays[1] = 0.0f;
+    // Starts a ring's length in, so reads behind the first block never go below zero
+    slot.delayWritten = slot.delayLeft.size();
+#endif
+}
+
+#ifdef NEXUS_STEAM_AUDIO_ENABLED
+void HRTFSpatializer::ProcessSlot(Slot& slot) {
+    const uint32_t frames = blockFrames_;
+    float* input = slot.input.data();
+    std::fill(input, input + frames, 0.0f);
+    if (slot.state == SlotState::Active) {
+        AddRamped(inputs_.data() + size_t(slot.voice) * frames, input, frames, slot.blendStart, slot.blendEnd);
+    }
+
+    float* outputs[2] = { slot.planar.data(), slot.planar.data() + frames };
+    IPLAudioBuffer in = { 1, static_cast<IPLint32>(frames), &input };
+    IPLAudioBuffer out = { 2, static_cast<IPLint32>(frames), outputs };
+    IPLBinauralEffectParams params = {};
+    // Steam Audio's listener looks down -z
+    params.direction = { slot.direction[0], slot.direction[1], -slot.direction[2] };
+    params.interpolation = IPL_HRTFINTERPOLATION_BILINEAR;
+    params.spatialBlend = 1.0f;
+    params.hrtf = hrtf_;
+    iplBinauralEffectApply(slot.effect, &params, &in, &out);
+
+    for (uint32_t f = 0; f < frames; ++f) {
+        slot.output[f * 2] = outputs[0][f];
+        slot.output[f * 2 + 1] = outputs[1][f];
+    }
+    slot.fresh = false;
+}
+
+void HRTFSpatializer::ProcessBed() {
+    const uint32_t frames = blockFrames_;
+    float* inputs[CHANNELS];
+    for (uint32_t c = 0; c < CHANNELS; ++c) inputs[c] = bedInput_.data() + size_t(c) * frames;
+    float* outputs[2] = { bedPlanar_.data(), bedPlanar_.data() + frames };
+    IPLAudioBuffer in = { static_cast<IPLint32>(CHANNELS), static_cast<IPLint32>(frames), inputs };
+    IPLAudioBuffer out = { 2, static_cast<IPLint32>(frames), outputs };
+    IPLAmbisonicsDecodeEffectParams params = {};
+    params.order = HRTFSet::AMBISONIC_ORDER;
+    params.hrtf = hrtf_;
+    // The bed is encoded relative to the listener already
+    params.orientation.right = { 1.0f, 0.0f, 0.0f };
+    params.orientation.up = { 0.0f, 1.0f, 0.0f };
+    params.orientation.ahead = { 0.0f, 0.0f, -1.0f };
+    params.binaural = IPL_TRUE;
+    iplAmbisonicsDecodeEffectApply(decode_, &params, &in, &out);
+
+    for (uint32_t f = 0; f < frames; ++f) {
+        bedOutput_[f * 2] = outputs[0][f];
+        bedOutput_[f * 2 + 1] = outputs[1][f];
+    }
+}
+#else
+void HRTFSpatializer::ProcessSlot(Slot& slot) {
+    const uint32_t frames = blockFrames_;
+    const size_t spectrum = size_t(frames) * 2;
+    const uint32_t partitions = set_.GetPartitions();
+
+    // Overlap-save window: the last block and this one
+    float* history = slot.history.data();
+    std::copy(history + frames, history + spectrum, history);
+    std::fill(history + frames, history + spectrum, 0.0f);
+    if (slot.state == SlotState::Active) {
+        AddRamped(inputs_.data() + size_t(slot.voice) * frames, history + frames, frames, slot.blendStart, slot.blendEnd);
+    }
+    slot.newest = (slot.newest + 1) % partitions;
+    float* inRe = slot.spectraRe.data() + slot.newest * spectrum;
+    float* inIm = slot.spectraIm.data() + slot.newest * spectrum;
+    std::copy(history, history + spectrum, inRe);
+    std::fill(inIm, inIm + spectrum, 0.0f);
+    fft_.Forward(inRe, inIm);
+
+    HRTFSet::Neighbours neighbours = set_.Locate(slot.direction);
+    bool moved = slot.fresh || !SameNeighbours(neighbours, slot.neighbours);
+    float delays[2] = { slot.delays[0], slot.delays[1] };
+    if (moved) set_.Interpolate(neighbours, slot.nextRe.data(), slot.nextIm.data(), delays);
+    if (slot.fresh) {
+        slot.filterRe.swap(slot.nextRe);
+        slot.filterIm.swap(slot.nextIm);
+        slot.delays[0] = delays[0];
+        slot.delays[1] = delays[1];
+        moved = false;
+    }
+
+    auto convolve = [&](const std::vector<float>& filterRe, const std::vector<float>& filterIm, float* re, float* im) {
+        std::fill(re, re + spectrum, 0.0f);
+        std::fill(im, im + spectrum, 0.0f);
+        for (uint32_t p = 0; p < partitions; ++p) {
+            uint32_t ring = (slot.newest + partitions - p) % partitions;
+            MultiplyAdd(slot.spectraRe.data() + ring * spectrum, slot.spectraIm.data() + ring * spectrum,
+                        filterRe.data() + p * spectrum, filterIm.data() + p * spectrum, re, im, spectrum);
+        }
+        fft_.Inverse(re, im);
+    };
+    // Left comes out in the real part and right in the imaginary, the valid half at the end
+    float* left = slot.workRe.data() + frames;
+    float* right = slot.workIm.data() + frames;
+    convolve(slot.filterRe, slot.filterIm, slot.workRe.data(), slot.workIm.data());
+    if (moved) {
+        // Crossfade from the old direction's response to the new one's over the block
+        convolve(slot.nextRe, slot.nextIm, slot.fadeRe.data(), slot.fadeIm.data());
+        const float* nextLeft = slot.fadeRe.data() + frames;
+        const float* nextRight = slot.fadeIm.data() + frames;
+        for (uint32_t f = 0; f < frames; ++f) {
+            float t = float(f + 1) / frames;
+            left[f] += (nextLeft[f] - left[f]) * t;
+            right[f] += (nextRight[f] - right[f]) * t;
+        }
+        slot.filterRe.swap(slot.nextRe);
+        slot.filterIm.swap(slot.nextIm);
+    }
+
+    // Each ear's arrival delay ramps to where the new direction puts it
+    const size_t mask = slot.delayLeft.size() - 1;
+    const uint64_t base = slot.delayWritten;
+    for (uint32_t f = 0; f < frames; ++f) {
+        slot.delayLeft[(base + f) & mask] = left[f];
+        slot.delayRight[(base + f) & mask] = right[f];
+    }
+    slot.delayWritten += frames;
+    for (int ear = 0; ear < 2; ++ear) {
+        const float* ring = ear == 0 ? slot.delayLeft.data() : slot.delayRight.data();
+        float delay = slot.delays[ear];
+        float step = (delays[ear] - delay) / frames;
+        for (uint32_t f = 0; f < frames; ++f) {
+            delay += step;
+            double at = double(base + f) - delay;
+            uint64_t index = static_cast<uint64_t>(at);
+            float frac = static_cast<float>(at - double(index));
+            float a = ring[index & mask];
+            float b = ring[(index + 1) & mask];
+            slot.output[f * 2 + ear] = a + (b - a) * frac;
+        }
+    }
+    slot.delays[0] = delays[0];
+    slot.delays[1] = delays[1];
+    slot.neighbours = neighbours;
+    slot.fresh = false;
+}
+
+void HRTFSpatializer::ProcessBed() {
+    const uint32_t frames = blockFrames_;
+    const size_t spectrum = size_t(frames) * 2;
+    const uint32_t partitions = set_.GetBedPartitions();
+    bedNewest_ = (bedNewest_ + 1) % partitions;
+
+    for (uint32_t c = 0; c < CHANNELS; ++c) {
+        float* history = bedHistory_.data() + c * spectrum;
+        std::copy(history + frames, history + spectrum, history);
+        std::copy(bedInput_.data() + size_t(c) * frames, bedInput_.data() + size_t(c + 1) * frames, history + frames);
+    }
+
+    // Two real channels go through each transform as one complex signal, and are pulled apart
+    // after by the symmetry a real signal's spectrum has
+    float* re = bedWorkRe_.data();
+    float* im = bedWorkIm_.data();
+    for (uint32_t c = 0; c < CHANNELS; c += 2) {
+        const float* first = bedHistory_.data() + c * spectrum;
+        const float* second = c + 1 < CHANNELS ? first + spectrum : nullptr;
+        std::copy(first, first + spectrum, re);
+        if (second) std::copy(second, second + spectrum, im);
+        else std::fill(im, im + spectrum, 0.0f);
+        fft_.Forward(re, im);
+
+        size_t slot = (size_t(c) * partitions + bedNewest_) * spectrum;
+        float* aRe = bedSpectraRe_.data() + slot;
+        float* aIm = bedSpectraIm_.data() + slot;
+        if (!second) {
+            std::copy(re, re + spectrum, aRe);
+            std::copy(im, im + spectrum, aIm);
+            continue;
+        }
+        float* bRe = aRe + size_t(partitions) * spectrum;
+        float* bIm = aIm + size_t(partitions) * spectrum;
+        for (size_t k = 0; k < spectrum; ++k) {
+            size_t mirror = (spectrum - k) & (spectrum - 1);
+            float zr = re[k];
+            float zi = im[k];
+            float wr = re[mirror];
+            float wi = im[mirror];
+            aRe[k] = 0.5f * (zr + wr);
+            aIm[k] = 0.5f * (zi - wi);
+            bRe[k] = 0.5f * (zi + wi);
+            bIm[k] = 0.5f * (wr - zr);
+        }
+    }
+
+    float* sumRe = bedSumRe_.data();
+    float* sumIm = bedSumIm_.data();
+    std::fill(sumRe, sumRe + spectrum, 0.0f);
+    std::fill(sumIm, sumIm + spectrum, 0.0f);
+    for (uint32_t c = 0; c < CHANNELS; ++c) {
+        const float* filterRe = set_.GetBedRe(c);
+        const float* filterIm = set_.GetBedIm(c);
+        for (uint32_t p = 0; p < partitions; ++p) {
+            size_t slot = (size_t(c) * partitions + (bedNewest_ + partitions - p) % partitions) * spectrum;
+            MultiplyAdd(bedSpectraRe_.data() + slot, bedSpectraIm_.data() + slot, filterRe + p * spectrum,
+                        filterIm + p * spectrum, sumRe, sumIm, spectrum);
+        }
+    }
+    fft_.Inverse(sumRe, sumIm);
+    for (uint32_t f = 0; f < frames; ++f) {
+        bedOutput_[f * 2] = sumRe[frames + f];
+        bedOutput_[f * 2 + 1] = sumIm[frames + f];
+    }
+}
+#endif
+
+} // namespace Nexus
@@ -0,0 +1,245 @@
+#include "SoundBank.h"
+#include "AudioStream.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Nexus {
+
+namespace {
+
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+}
+
+constexpr uint32_t BANK_MAGIC = MakeFourCC('N', 'X', 'S', 'B');
+constexpr uint32_t BANK_VERSION = 1;
+// Format tags, named apart from the mmreg.h macros
+constexpr uint16_t WAV_PCM = 1;
+constexpr uint16_t WAV_IEEE_FLOAT = 3;
+constexpr uint16_t WAV_EXTENSIBLE = 0xFFFE;
+
+struct SoundBankHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t clipCount;
+    uint32_t nameBytes;
+};
+
+template <typename T>
+T ReadValue(const uint8_t* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+uint64_t AlignUp(uint64_t value) {
+    return (value + SoundBank::ALIGNMENT - 1) / SoundBank::ALIGNMENT * SoundBank::ALIGNMENT;
+}
+
+// A clip on its way into a bank
+struct PendingClip {
+    SoundBankClip clip;
+    std::string name;
+    std::vector<uint8_t> bytes;                // The whole input file
+    size_t dataOffset;                         // What of it goes in the bank
+    size_t dataSize;
+};
+
+// Finds the samples of a PCM or float WAV. False for other WAVs, which are stored whole
+bool ParseWAV(PendingClip& pending) {
+    const std::vector<uint8_t>& bytes = pending.bytes;
+    if (bytes.size() < 12 || ReadValue<uint32_t>(bytes.data()) != MakeFourCC('R', 'I', 'F', 'F') ||
+        ReadValue<uint32_t>(bytes.data() + 8) != MakeFourCC('W', 'A', 'V', 'E')) {
+        return false;
+    }
+
+    uint16_t tag = 0, channels = 0, bits = 0;
+    uint32_t sampleRate = 0;
+    for (size_t at = 12; at + 8 <= bytes.size();) {
+        uint32_t id = ReadValue<uint32_t>(bytes.data() + at);
+        size_t size = std::min<size_t>(ReadValue<uint32_t>(bytes.data() + at + 4), bytes.size() - at - 8);
+        const uint8_t* chunk = bytes.data() + at + 8;
+        if (id == MakeFourCC('f', 'm', 't', ' ') && size >= 16) {
+            tag = ReadValue<uint16_t>(chunk);
+            channels = ReadValue<uint16_t>(chunk + 2);
+            sampleRate = ReadValue<uint32_t>(chunk + 4);
+            bits = ReadValue<uint16_t>(chunk + 14);
+            // The sub-format GUID starts with the tag it stands for
+            if (tag == WAV_EXTENSIBLE && size >= 26) tag = ReadValue<uint16_t>(chunk + 24);
+        } else if (id == MakeFourCC('d', 'a', 't', 'a')) {
+            bool pcm = tag == WAV_PCM && (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+            bool floats = tag == WAV_IEEE_FLOAT && bits == 32;
+            if ((!pcm && !floats) || channels == 0 || sampleRate == 0) return false;
+            pending.clip.encoding = pcm ? SoundBankEncoding::PCM : SoundBankEncoding::Float;
+            pending.clip.channels = channels;
+            pending.clip.bitsPerSample = bits;
+            pending.clip.sampleRate = sampleRate;
+            pending.clip.frameCount = static_cast<uint32_t>(size / (size_t(channels) * bits / 8));
+            pending.dataOffset = chunk - bytes.data();
+            pending.dataSize = size_t(pending.clip.frameCount) * channels * bits / 8;
+            return true;
+        }
+        at += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+}
+
+bool SoundBank::Open(const std::string& filename) {
+    Close();
+    if (!file_.Open(filename)) return false;
+    filename_ = filename;
+
+    const uint8_t* data = file_.GetData();
+    const uint64_t size = file_.GetSize();
+    SoundBankHeader header = {};
+    if (size >= sizeof(header)) std::memcpy(&header, data, sizeof(header));
+    if (header.magic != BANK_MAGIC || header.version != BANK_VERSION) {
+        Logger::Error("Not a sound bank, or one from another version: " + filename);
+        Close();
+        return false;
+    }
+
+    const uint64_t namesStart = sizeof(header) + uint64_t(header.clipCount) * sizeof(SoundBankClip);
+    const uint64_t dataStart = namesStart + header.nameBytes;
+    bool valid = dataStart <= size && (header.nameBytes == 0 || data[dataStart - 1] == '\0');
+    // The mapping is page aligned, so the index straight after the header is aligned for reading in place
+    const SoundBankClip* clips = reinterpret_cast<const SoundBankClip*>(data + sizeof(header));
+    for (uint32_t i = 0; valid && i < header.clipCount; ++i) {
+        const SoundBankClip& clip = clips[i];
+        bool samples = clip.encoding == SoundBankEncoding::PCM || clip.encoding == SoundBankEncoding::Float;
+        valid = (i == 0 || clips[i - 1].id < clip.id) && clip.nameOffset < header.nameBytes &&
+                clip.offset >= dataStart && clip.offset % ALIGNMENT == 0 && clip.size <= size - clip.offset &&
+                clip.encoding <= SoundBankEncoding::Vorbis &&
+                (!samples || (clip.channels > 0 && clip.sampleRate > 0 && clip.bitsPerSample % 8 == 0 &&
+                              uint64_t(clip.frameCount) * clip.channels * (clip.bitsPerSample / 8) <= clip.size));
+    }
+    if (!valid) {
+        Logger::Error("Corrupt sound bank: " + filename);
+        Close();
+        return false;
+    }
+
+    clips_ = clips;
+    clipCount_ = header.clipCount;
+    names_ = reinterpret_cast<const char*>(data + namesStart);
+    return true;
+}
+
+void SoundBank::Close() {
+    file_.Close();
+    filename_.clear();
+    clips_ = nullptr;
+    clipCount_ = 0;
+    names_ = nullptr;
+}
+
+const SoundBankClip* SoundBank::Find(SoundClipID id) const {
+    const SoundBankClip* end = clips_ + clipCount_;
+    const SoundBankClip* it = std::lower_bound(clips_, end, id,
+                                               [](const SoundBankClip& clip, SoundClipID value) { return clip.id < value; });
+    return it != end && it->id == id ? it : nullptr;
+}
+
+bool SoundBank::Write(const std::string& filename, const std::vector<std::string>& inputFiles,
+                      const std::string& root) {
+    namespace fs = std::filesystem;
+
+    // Not started, so it only probes
+    AudioStreamer probe;
+    std::vector<PendingClip> pending(inputFiles.size());
+    for (size_t i = 0; i < inputFiles.size(); ++i) {
+        PendingClip& clip = pending[i];
+        const std::string& input = inputFiles[i];
+        std::ifstream file(input, std::ios::binary | std::ios::ate);
+        if (!file) {
+            Logger::Error("Could not open audio file: " + input);
+            return false;
+        }
+        clip.bytes.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(clip.bytes.data()), clip.bytes.size());
+        if (!file) {
+            Logger::Error("Could not read audio file: " + input);
+            return false;
+        }
+
+        std::error_code error;
+        fs::path relative = fs::absolute(input, error).lexically_relative(fs::absolute(root.empty() ? "." : root, error));
+        if (relative.empty()) relative = fs::path(input).filename();
+        clip.name = relative.replace_extension().generic_string();
+        clip.clip = {};
+        clip.clip.id = HashSoundName(clip.name);
+
+        if (!ParseWAV(clip)) {
+            // Stored whole, so the streamer must be able to decode it as it plays
+            MemoryByteSource source(std::shared_ptr<const std::vector<uint8_t>>(std::shared_ptr<void>(), &clip.bytes));
+            AudioStreamInfo info = {};
+            const uint32_t magic = clip.bytes.size() >= 4 ? ReadValue<uint32_t>(clip.bytes.data()) : 0;
+            if (!probe.Probe(source, info) ||
+                (magic != MakeFourCC('R', 'I', 'F', 'F') && magic != MakeFourCC('O', 'g', 'g', 'S'))) {
+                Logger::Error("Unsupported or corrupt audio file: " + input);
+                return false;
+            }
+            clip.clip.encoding = magic == MakeFourCC('O', 'g', 'g', 'S') ? SoundBankEncoding::Vorbis : SoundBankEncoding::ADPCM;
+            clip.clip.channels = info.channels;
+            clip.clip.sampleRate = info.sampleRate;
+            clip.clip.frameCount = static_cast<uint32_t>(std::min<uint64_t>(info.frameCount, UINT32_MAX));
+            clip.dataOffset = 0;
+            clip.dataSize = clip.bytes.size();
+        }
+    }
+
+    std::sort(pending.begin(), pending.end(),
+              [](const PendingClip& a, const PendingClip& b) { return a.clip.id < b.clip.id; });
+    for (size_t i = 1; i < pending.size(); ++i) {
+        if (pending[i].clip.id == pending[i - 1].clip.id) {
+            Logger::Error("Sound names " + pending[i - 1].name + " and " + pending[i].name + " have the same ID");
+            return false;
+        }
+    }
+
+    std::string names;
+    for (PendingClip& clip : pending) {
+        clip.clip.nameOffset = static_cast<uint32_t>(names.size());
+        names.append(clip.name).push_back('\0');
+    }
+    uint64_t offset = sizeof(SoundBankHeader) + pending.size() * sizeof(SoundBankClip) + names.size();
+    for (PendingClip& clip : pending) {
+        clip.clip.offset = AlignUp(offset);
+        clip.clip.size = clip.dataSize;
+        offset = clip.clip.offset + clip.clip.size;
+    }
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        Logger::Error("Could not create sound bank: " + filename);
+        return false;
+    }
+    SoundBankHeader header = { BANK_MAGIC, BANK_VERSION, static_cast<uint32_t>(pending.size()),
+                               static_cast<uint32_t>(names.size()) };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const PendingClip& clip : pending) file.write(reinterpret_cast<const char*>(&clip.clip), sizeof(clip.clip));
+    file.write(names.data(), names.size());
+    const char padding[ALIGNMENT] = {};
+    uint64_t written = sizeof(header) + pending.size() * sizeof(SoundBankClip) + names.size();
+    for (const PendingClip& clip : pending) {
+        file.write(padding, static_cast<std::streamsize>(clip.clip.offset - written));
+        file.write(reinterpret_cast<const char*>(clip.bytes.data() + clip.dataOffset), clip.dataSize);
+        written = clip.clip.offset + clip.clip.size;
+    }
+    if (!file) {
+        Logger::Error("Could not write sound bank: " + filename);
+        return false;
+    }
+
+    Logger::Info("Wrote sound bank " + filename + " with " + std::to_string(pending.size()) + " clips");
+    return true;
+}
+
+} // namespace Nexus
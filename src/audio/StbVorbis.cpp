@@ -0,0 +1,5 @@
+// stb_vorbis leaks short macros (L, C, R, TRUE, ...) into whatever includes its implementation, so
+// it gets a translation unit of its own. Only the pushdata and memory APIs are used
+#define STB_VORBIS_NO_STDIO
+#define STB_VORBIS_NO_INTEGER_CONVERSION
+#include <stb/stb_vorbis.c>
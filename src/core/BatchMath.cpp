@@ -0,0 +1,588 @@
+#include "BatchMath.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC emits any intrinsic regardless of /arch; the dispatch below keeps them off older CPUs
+#define NEXUS_TARGET_SSE41
+#define NEXUS_TARGET_AVX2
+#else
+#define NEXUS_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define NEXUS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace DirectX;
+
+namespace Nexus {
+
+namespace {
+
+BatchMath::InstructionSet DetectInstructionSet() {
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osAvx) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse41 = __builtin_cpu_supports("sse4.1") != 0;
+    const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+    if (avx2) return BatchMath::InstructionSet::AVX2;
+    if (sse41) return BatchMath::InstructionSet::SSE41;
+    return BatchMath::InstructionSet::Scalar;
+}
+
+BatchMath::InstructionSet GetSupportedInstructionSet() {
+    static const BatchMath::InstructionSet supported = DetectInstructionSet();
+    return supported;
+}
+
+std::atomic<int> g_instructionSet{-1};
+
+// Slerp pairs closer than this are lerped, as in XMQuaternionSlerp
+constexpr float SLERP_LERP_THRESHOLD = 1.0f - 0.00001f;
+
+// acos(x) for x in [0, 1] and sin(x) for x in [0, pi/2], the XMScalarACos and XMScalarSin
+// polynomials, shared by every path so they agree to the last bit that SIMD rounding allows
+constexpr float ACOS_COEFFICIENTS[8] = { -0.0012624911f, 0.0066700901f, -0.0170881256f, 0.0308918810f,
+                                         -0.0501743046f, 0.0889789874f, -0.2145988016f, 1.5707963050f };
+constexpr float SIN_COEFFICIENTS[6] = { -2.3889859e-08f, 2.7525562e-06f, -0.00019840874f, 0.0083333310f,
+                                        -0.16666667f, 1.0f };
+
+// Scalar reference paths, also used for the tails of the SIMD ones
+
+float AcosScalar(float x) {
+    float result = ACOS_COEFFICIENTS[0];
+    for (int i = 1; i < 8; ++i) result = result * x + ACOS_COEFFICIENTS[i];
+    return result * std::sqrt(1.0f - x);
+}
+
+float SinScalar(float x) {
+    const float x2 = x * x;
+    float result = SIN_COEFFICIENTS[0];
+    for (int i = 1; i < 6; ++i) result = result * x2 + SIN_COEFFICIENTS[i];
+    return result * x;
+}
+
+void TransformPointsScalar(const XMFLOAT4X4& m, const XMFLOAT3* points, XMFLOAT3* output, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const XMFLOAT3 p = points[i];
+        output[i] = XMFLOAT3(p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+                             p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+                             p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43);
+    }
+}
+
+void NormalizeVectorsScalar(const XMFLOAT3* vectors, XMFLOAT3* output, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const XMFLOAT3 v = vectors[i];
+        const float lengthSquared = v.x * v.x + v.y * v.y + v.z * v.z;
+        const float scale = lengthSquared > 0.0f ? 1.0f / std::sqrt(lengthSquared) : 0.0f;
+        output[i] = XMFLOAT3(v.x * scale, v.y * scale, v.z * scale);
+    }
+}
+
+void SlerpQuaternionsScalar(const XMFLOAT4* from, const XMFLOAT4* to, const float* t, size_t tStride,
+                            XMFLOAT4* output, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const XMFLOAT4 a = from[i];
+        const XMFLOAT4 b = to[i];
+        const float weight = t[i * tStride];
+        float cosOmega = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+        const float sign = cosOmega < 0.0f ? -1.0f : 1.0f;
+        cosOmega *= sign;
+
+        float s0 = 1.0f - weight;
+        float s1 = weight;
+        if (cosOmega < SLERP_LERP_THRESHOLD) {
+            const float omega = AcosScalar(cosOmega);
+            const float inverseSin = 1.0f / SinScalar(omega);
+            s0 = SinScalar(s0 * omega) * inverseSin;
+            s1 = SinScalar(s1 * omega) * inverseSin;
+        }
+        s1 *= sign;
+        output[i] = XMFLOAT4(a.x * s0 + b.x * s1, a.y * s0 + b.y * s1, a.z * s0 + b.z * s1, a.w * s0 + b.w * s1);
+    }
+}
+
+bool BoxVisibleScalar(const Frustum& frustum, const AABB& box) {
+    const float cx = (box.min.x + box.max.x) * 0.5f, ex = (box.max.x - box.min.x) * 0.5f;
+    const float cy = (box.min.y + box.max.y) * 0.5f, ey = (box.max.y - box.min.y) * 0.5f;
+    const float cz = (box.min.z + box.max.z) * 0.5f, ez = (box.max.z - box.min.z) * 0.5f;
+    for (const XMFLOAT4& p : frustum.planes) {
+        // Signed distance of the corner furthest along the plane normal
+        const float distance = p.x * cx + p.y * cy + p.z * cz + p.w +
+                               std::fabs(p.x) * ex + std::fabs(p.y) * ey + std::fabs(p.z) * ez;
+        if (distance < 0.0f) return false;
+    }
+    return true;
+}
+
+size_t CullBoxesScalar(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* visible) {
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        visible[i] = BoxVisibleScalar(frustum, boxes[i]) ? 1 : 0;
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
+
+// SSE4.1: four elements a group. Packed float3s are deinterleaved with six shuffles, from
+// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 into one register per component, and back
+
+NEXUS_TARGET_SSE41 inline void Load3SSE(const float* p, __m128& x, __m128& y, __m128& z) {
+    const __m128 m03 = _mm_loadu_ps(p);
+    const __m128 m14 = _mm_loadu_ps(p + 4);
+    const __m128 m25 = _mm_loadu_ps(p + 8);
+    const __m128 xy = _mm_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+    const __m128 yz = _mm_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+    x = _mm_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+NEXUS_TARGET_SSE41 inline void Store3SSE(float* p, __m128 x, __m128 y, __m128 z) {
+    const __m128 xy = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_ps(p, _mm_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(p + 4, _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm_storeu_ps(p + 8, _mm_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+NEXUS_TARGET_SSE41 inline __m128 AcosSSE(__m128 x) {
+    __m128 result = _mm_set1_ps(ACOS_COEFFICIENTS[0]);
+    for (int i = 1; i < 8; ++i) result = _mm_add_ps(_mm_mul_ps(result, x), _mm_set1_ps(ACOS_COEFFICIENTS[i]));
+    return _mm_mul_ps(result, _mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x)));
+}
+
+NEXUS_TARGET_SSE41 inline __m128 SinSSE(__m128 x) {
+    const __m128 x2 = _mm_mul_ps(x, x);
+    __m128 result = _mm_set1_ps(SIN_COEFFICIENTS[0]);
+    for (int i = 1; i < 6; ++i) result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(SIN_COEFFICIENTS[i]));
+    return _mm_mul_ps(result, x);
+}
+
+NEXUS_TARGET_SSE41 void TransformPointsSSE41(const XMFLOAT4X4& m, const XMFLOAT3* points, XMFLOAT3* output,
+                                             size_t count) {
+    const __m128 m11 = _mm_set1_ps(m._11), m12 = _mm_set1_ps(m._12), m13 = _mm_set1_ps(m._13);
+    const __m128 m21 = _mm_set1_ps(m._21), m22 = _mm_set1_ps(m._22), m23 = _mm_set1_ps(m._23);
+    const __m128 m31 = _mm_set1_ps(m._31), m32 = _mm_set1_ps(m._32), m33 = _mm_set1_ps(m._33);
+    const __m128 m41 = _mm_set1_ps(m._41), m42 = _mm_set1_ps(m._42), m43 = _mm_set1_ps(m._43);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        Load3SSE(&points[i].x, x, y, z);
+        const __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m11), _mm_mul_ps(y, m21)), _mm_add_ps(_mm_mul_ps(z, m31), m41));
+        const __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m12), _mm_mul_ps(y, m22)), _mm_add_ps(_mm_mul_ps(z, m32), m42));
+        const __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m13), _mm_mul_ps(y, m23)), _mm_add_ps(_mm_mul_ps(z, m33), m43));
+        Store3SSE(&output[i].x, rx, ry, rz);
+    }
+    TransformPointsScalar(m, points + i, output + i, count - i);
+}
+
+NEXUS_TARGET_SSE41 void NormalizeVectorsSSE41(const XMFLOAT3* vectors, XMFLOAT3* output, size_t count) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        Load3SSE(&vectors[i].x, x, y, z);
+        const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        const __m128 scale = _mm_and_ps(_mm_div_ps(one, _mm_sqrt_ps(lengthSquared)),
+                                        _mm_cmpgt_ps(lengthSquared, zero));
+        Store3SSE(&output[i].x, _mm_mul_ps(x, scale), _mm_mul_ps(y, scale), _mm_mul_ps(z, scale));
+    }
+    NormalizeVectorsScalar(vectors + i, output + i, count - i);
+}
+
+NEXUS_TARGET_SSE41 void SlerpQuaternionsSSE41(const XMFLOAT4* from, const XMFLOAT4* to, const float* t,
+                                              size_t tStride, XMFLOAT4* output, size_t count) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 threshold = _mm_set1_ps(SLERP_LERP_THRESHOLD);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 ax = _mm_loadu_ps(&from[i].x), ay = _mm_loadu_ps(&from[i + 1].x);
+        __m128 az = _mm_loadu_ps(&from[i + 2].x), aw = _mm_loadu_ps(&from[i + 3].x);
+        _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+        __m128 bx = _mm_loadu_ps(&to[i].x), by = _mm_loadu_ps(&to[i + 1].x);
+        __m128 bz = _mm_loadu_ps(&to[i + 2].x), bw = _mm_loadu_ps(&to[i + 3].x);
+        _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+        const __m128 weight = tStride ? _mm_loadu_ps(t + i) : _mm_set1_ps(*t);
+
+        __m128 cosOmega = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                                     _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+        const __m128 sign = _mm_and_ps(cosOmega, signMask);
+        cosOmega = _mm_xor_ps(cosOmega, sign);
+
+        const __m128 lerpS0 = _mm_sub_ps(one, weight);
+        const __m128 omega = AcosSSE(cosOmega);
+        const __m128 inverseSin = _mm_div_ps(one, SinSSE(omega));
+        const __m128 slerp = _mm_cmplt_ps(cosOmega, threshold);
+        const __m128 s0 = _mm_blendv_ps(lerpS0, _mm_mul_ps(SinSSE(_mm_mul_ps(lerpS0, omega)), inverseSin), slerp);
+        __m128 s1 = _mm_blendv_ps(weight, _mm_mul_ps(SinSSE(_mm_mul_ps(weight, omega)), inverseSin), slerp);
+        s1 = _mm_xor_ps(s1, sign);
+
+        __m128 rx = _mm_add_ps(_mm_mul_ps(ax, s0), _mm_mul_ps(bx, s1));
+        __m128 ry = _mm_add_ps(_mm_mul_ps(ay, s0), _mm_mul_ps(by, s1));
+        __m128 rz = _mm_add_ps(_mm_mul_ps(az, s0), _mm_mul_ps(bz, s1));
+        __m128 rw = _mm_add_ps(_mm_mul_ps(aw, s0), _mm_mul_ps(bw, s1));
+        _MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+        _mm_storeu_ps(&output[i].x, rx);
+        _mm_storeu_ps(&output[i + 1].x, ry);
+        _mm_storeu_ps(&output[i + 2].x, rz);
+        _mm_storeu_ps(&output[i + 3].x, rw);
+    }
+    SlerpQuaternionsScalar(from + i, to + i, t + i * tStride, tStride, output + i, count - i);
+}
+
+NEXUS_TARGET_SSE41 size_t CullBoxesSSE41(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* visible) {
+    // Planes as broadcast registers, with the absolute normals the extent term needs
+    __m128 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT], planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    __m128 absX[Frustum::PLANE_COUNT], absY[Frustum::PLANE_COUNT], absZ[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        const XMFLOAT4& plane = frustum.planes[p];
+        planeX[p] = _mm_set1_ps(plane.x);
+        planeY[p] = _mm_set1_ps(plane.y);
+        planeZ[p] = _mm_set1_ps(plane.z);
+        planeW[p] = _mm_set1_ps(plane.w);
+        absX[p] = _mm_set1_ps(std::fabs(plane.x));
+        absY[p] = _mm_set1_ps(std::fabs(plane.y));
+        absZ[p] = _mm_set1_ps(std::fabs(plane.z));
+    }
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t visibleCount = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // A box is two float3s, so eight of them hold four boxes: min and max alternate
+        __m128 x0, y0, z0, x1, y1, z1;
+        Load3SSE(&boxes[i].min.x, x0, y0, z0);
+        Load3SSE(&boxes[i + 2].min.x, x1, y1, z1);
+        const __m128 minX = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(2, 0, 2, 0)), maxX = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 minY = _mm_shuffle_ps(y0, y1, _MM_SHUFFLE(2, 0, 2, 0)), maxY = _mm_shuffle_ps(y0, y1, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 minZ = _mm_shuffle_ps(z0, z1, _MM_SHUFFLE(2, 0, 2, 0)), maxZ = _mm_shuffle_ps(z0, z1, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half), ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+        const __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half), ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+        const __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half), ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                           _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p])),
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)),
+                           _mm_mul_ps(absZ[p], ez)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+        }
+
+        const int outsideBits = _mm_movemask_ps(outside);
+        for (int lane = 0; lane < 4; ++lane) {
+            visible[i + lane] = (outsideBits >> lane) & 1 ? 0 : 1;
+            visibleCount += visible[i + lane];
+        }
+    }
+    return visibleCount + CullBoxesScalar(frustum, boxes + i, count - i, visible + i);
+}
+
+// AVX2: eight elements a group. The low 128-bit half of every register holds elements 0-3 and the
+// high half 4-7, so the SSE shuffles deinterleave both halves at once
+
+NEXUS_TARGET_AVX2 inline __m256 LoadHalvesAVX2(const float* low, const float* high) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+NEXUS_TARGET_AVX2 inline void StoreHalvesAVX2(float* low, float* high, __m256 value) {
+    _mm_storeu_ps(low, _mm256_castps256_ps128(value));
+    _mm_storeu_ps(high, _mm256_extractf128_ps(value, 1));
+}
+
+NEXUS_TARGET_AVX2 inline void Load3AVX2(const float* p, __m256& x, __m256& y, __m256& z) {
+    const __m256 m03 = LoadHalvesAVX2(p, p + 12);
+    const __m256 m14 = LoadHalvesAVX2(p + 4, p + 16);
+    const __m256 m25 = LoadHalvesAVX2(p + 8, p + 20);
+    const __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+    const __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+    x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+NEXUS_TARGET_AVX2 inline void Store3AVX2(float* p, __m256 x, __m256 y, __m256 z) {
+    const __m256 xy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 yz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m256 zx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+    StoreHalvesAVX2(p, p + 12, _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)));
+    StoreHalvesAVX2(p + 4, p + 16, _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)));
+    StoreHalvesAVX2(p + 8, p + 20, _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// Rows r0-r3 hold elements (0, 4), (1, 5), (2, 6), (3, 7); the transpose is its own inverse
+NEXUS_TARGET_AVX2 inline void Transpose4AVX2(__m256& r0, __m256& r1, __m256& r2, __m256& r3) {
+    const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    const __m256 t1 = _mm256_unpacklo_ps(r2, r3);
+    const __m256 t2 = _mm256_unpackhi_ps(r0, r1);
+    const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+NEXUS_TARGET_AVX2 inline void Load4AVX2(const XMFLOAT4* q, __m256& x, __m256& y, __m256& z, __m256& w) {
+    x = LoadHalvesAVX2(&q[0].x, &q[4].x);
+    y = LoadHalvesAVX2(&q[1].x, &q[5].x);
+    z = LoadHalvesAVX2(&q[2].x, &q[6].x);
+    w = LoadHalvesAVX2(&q[3].x, &q[7].x);
+    Transpose4AVX2(x, y, z, w);
+}
+
+NEXUS_TARGET_AVX2 inline void Store4AVX2(XMFLOAT4* q, __m256 x, __m256 y, __m256 z, __m256 w) {
+    Transpose4AVX2(x, y, z, w);
+    StoreHalvesAVX2(&q[0].x, &q[4].x, x);
+    StoreHalvesAVX2(&q[1].x, &q[5].x, y);
+    StoreHalvesAVX2(&q[2].x, &q[6].x, z);
+    StoreHalvesAVX2(&q[3].x, &q[7].x, w);
+}
+
+NEXUS_TARGET_AVX2 inline __m256 AcosAVX2(__m256 x) {
+    __m256 result = _mm256_set1_ps(ACOS_COEFFICIENTS[0]);
+    for (int i = 1; i < 8; ++i) result = _mm256_add_ps(_mm256_mul_ps(result, x), _mm256_set1_ps(ACOS_COEFFICIENTS[i]));
+    return _mm256_mul_ps(result, _mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), x)));
+}
+
+NEXUS_TARGET_AVX2 inline __m256 SinAVX2(__m256 x) {
+    const __m256 x2 = _mm256_mul_ps(x, x);
+    __m256 result = _mm256_set1_ps(SIN_COEFFICIENTS[0]);
+    for (int i = 1; i < 6; ++i) result = _mm256_add_ps(_mm256_mul_ps(result, x2), _mm256_set1_ps(SIN_COEFFICIENTS[i]));
+    return _mm256_mul_ps(result, x);
+}
+
+NEXUS_TARGET_AVX2 void TransformPointsAVX2(const XMFLOAT4X4& m, const XMFLOAT3* points, XMFLOAT3* output,
+                                           size_t count) {
+    const __m256 m11 = _mm256_set1_ps(m._11), m12 = _mm256_set1_ps(m._12), m13 = _mm256_set1_ps(m._13);
+    const __m256 m21 = _mm256_set1_ps(m._21), m22 = _mm256_set1_ps(m._22), m23 = _mm256_set1_ps(m._23);
+    const __m256 m31 = _mm256_set1_ps(m._31), m32 = _mm256_set1_ps(m._32), m33 = _mm256_set1_ps(m._33);
+    const __m256 m41 = _mm256_set1_ps(m._41), m42 = _mm256_set1_ps(m._42), m43 = _mm256_set1_ps(m._43);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x, y, z;
+        Load3AVX2(&points[i].x, x, y, z);
+        const __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m11), _mm256_mul_ps(y, m21)),
+                                        _mm256_add_ps(_mm256_mul_ps(z, m31), m41));
+        const __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m12), _mm256_mul_ps(y, m22)),
+                                        _mm256_add_ps(_mm256_mul_ps(z, m32), m42));
+        const __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m13), _mm256_mul_ps(y, m23)),
+                                        _mm256_add_ps(_mm256_mul_ps(z, m33), m43));
+        Store3AVX2(&output[i].x, rx, ry, rz);
+    }
+    TransformPointsScalar(m, points + i, output + i, count - i);
+}
+
+NEXUS_TARGET_AVX2 void NormalizeVectorsAVX2(const XMFLOAT3* vectors, XMFLOAT3* output, size_t count) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x, y, z;
+        Load3AVX2(&vectors[i].x, x, y, z);
+        const __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)),
+                                                   _mm256_mul_ps(z, z));
+        const __m256 scale = _mm256_and_ps(_mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared)),
+                                           _mm256_cmp_ps(lengthSquared, zero, _CMP_GT_OQ));
+        Store3AVX2(&output[i].x, _mm256_mul_ps(x, scale), _mm256_mul_ps(y, scale), _mm256_mul_ps(z, scale));
+    }
+    NormalizeVectorsScalar(vectors + i, output + i, count - i);
+}
+
+NEXUS_TARGET_AVX2 void SlerpQuaternionsAVX2(const XMFLOAT4* from, const XMFLOAT4* to, const float* t,
+                                            size_t tStride, XMFLOAT4* output, size_t count) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 threshold = _mm256_set1_ps(SLERP_LERP_THRESHOLD);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 ax, ay, az, aw, bx, by, bz, bw;
+        Load4AVX2(from + i, ax, ay, az, aw);
+        Load4AVX2(to + i, bx, by, bz, bw);
+        const __m256 weight = tStride ? _mm256_loadu_ps(t + i) : _mm256_set1_ps(*t);
+
+        __m256 cosOmega = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)),
+                                        _mm256_add_ps(_mm256_mul_ps(az, bz), _mm256_mul_ps(aw, bw)));
+        const __m256 sign = _mm256_and_ps(cosOmega, signMask);
+        cosOmega = _mm256_xor_ps(cosOmega, sign);
+
+        const __m256 lerpS0 = _mm256_sub_ps(one, weight);
+        const __m256 omega = AcosAVX2(cosOmega);
+        const __m256 inverseSin = _mm256_div_ps(one, SinAVX2(omega));
+        const __m256 slerp = _mm256_cmp_ps(cosOmega, threshold, _CMP_LT_OQ);
+        const __m256 s0 = _mm256_blendv_ps(lerpS0, _mm256_mul_ps(SinAVX2(_mm256_mul_ps(lerpS0, omega)), inverseSin), slerp);
+        __m256 s1 = _mm256_blendv_ps(weight, _mm256_mul_ps(SinAVX2(_mm256_mul_ps(weight, omega)), inverseSin), slerp);
+        s1 = _mm256_xor_ps(s1, sign);
+
+        Store4AVX2(output + i,
+                   _mm256_add_ps(_mm256_mul_ps(ax, s0), _mm256_mul_ps(bx, s1)),
+                   _mm256_add_ps(_mm256_mul_ps(ay, s0), _mm256_mul_ps(by, s1)),
+                   _mm256_add_ps(_mm256_mul_ps(az, s0), _mm256_mul_ps(bz, s1)),
+                   _mm256_add_ps(_mm256_mul_ps(aw, s0), _mm256_mul_ps(bw, s1)));
+    }
+    SlerpQuaternionsScalar(from + i, to + i, t + i * tStride, tStride, output + i, count - i);
+}
+
+NEXUS_TARGET_AVX2 size_t CullBoxesAVX2(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* visible) {
+    // Planes as broadcast registers, with the absolute normals the extent term needs
+    __m256 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT], planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    __m256 absX[Frustum::PLANE_COUNT], absY[Frustum::PLANE_COUNT], absZ[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        const XMFLOAT4& plane = frustum.planes[p];
+        planeX[p] = _mm256_set1_ps(plane.x);
+        planeY[p] = _mm256_set1_ps(plane.y);
+        planeZ[p] = _mm256_set1_ps(plane.z);
+        planeW[p] = _mm256_set1_ps(plane.w);
+        absX[p] = _mm256_set1_ps(std::fabs(plane.x));
+        absY[p] = _mm256_set1_ps(std::fabs(plane.y));
+        absZ[p] = _mm256_set1_ps(std::fabs(plane.z));
+    }
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    // Box held by each lane: the first load covers boxes 0-1 low and 2-3 high, the second 4-7
+    static const uint8_t LANE_BOX[8] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+
+    size_t visibleCount = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x0, y0, z0, x1, y1, z1;
+        Load3AVX2(&boxes[i].min.x, x0, y0, z0);
+        Load3AVX2(&boxes[i + 4].min.x, x1, y1, z1);
+        const __m256 minX = _mm256_shuffle_ps(x0, x1, _MM_SHUFFLE(2, 0, 2, 0)), maxX = _mm256_shuffle_ps(x0, x1, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m256 minY = _mm256_shuffle_ps(y0, y1, _MM_SHUFFLE(2, 0, 2, 0)), maxY = _mm256_shuffle_ps(y0, y1, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m256 minZ = _mm256_shuffle_ps(z0, z1, _MM_SHUFFLE(2, 0, 2, 0)), maxZ = _mm256_shuffle_ps(z0, z1, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m256 cx = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half), ex = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+        const __m256 cy = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half), ey = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+        const __m256 cz = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half), ez = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+
+        __m256 outside = _mm256_setzero_ps();
+        for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            const __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], cx), _mm256_mul_ps(planeY[p], cy)),
+                              _mm256_add_ps(_mm256_mul_ps(planeZ[p], cz), planeW[p])),
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], ex), _mm256_mul_ps(absY[p], ey)),
+                              _mm256_mul_ps(absZ[p], ez)));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+        }
+
+        const int outsideBits = _mm256_movemask_ps(outside);
+        for (int lane = 0; lane < 8; ++lane) {
+            const uint8_t isVisible = (outsideBits >> lane) & 1 ? 0 : 1;
+            visible[i + LANE_BOX[lane]] = isVisible;
+            visibleCount += isVisible;
+        }
+    }
+    return visibleCount + CullBoxesScalar(frustum, boxes + i, count - i, visible + i);
+}
+
+void SlerpQuaternionsDispatch(const XMFLOAT4* from, const XMFLOAT4* to, const float* t, size_t tStride,
+                              XMFLOAT4* output, size_t count) {
+    switch (BatchMath::GetInstructionSet()) {
+    case BatchMath::InstructionSet::AVX2:
+        SlerpQuaternionsAVX2(from, to, t, tStride, output, count);
+        break;
+    case BatchMath::InstructionSet::SSE41:
+        SlerpQuaternionsSSE41(from, to, t, tStride, output, count);
+        break;
+    default:
+        SlerpQuaternionsScalar(from, to, t, tStride, output, count);
+        break;
+    }
+}
+
+} // namespace
+
+void BatchMath::TransformPoints(const XMFLOAT4X4& matrix, const XMFLOAT3* points, XMFLOAT3* output, size_t count) {
+    switch (GetInstructionSet()) {
+    case InstructionSet::AVX2:
+        TransformPointsAVX2(matrix, points, output, count);
+        break;
+    case InstructionSet::SSE41:
+        TransformPointsSSE41(matrix, points, output, count);
+        break;
+    default:
+        TransformPointsScalar(matrix, points, output, count);
+        break;
+    }
+}
+
+void BatchMath::NormalizeVectors(const XMFLOAT3* vectors, XMFLOAT3* output, size_t count) {
+    switch (GetInstructionSet()) {
+    case InstructionSet::AVX2:
+        NormalizeVectorsAVX2(vectors, output, count);
+        break;
+    case InstructionSet::SSE41:
+        NormalizeVectorsSSE41(vectors, output, count);
+        break;
+    default:
+        NormalizeVectorsScalar(vectors, output, count);
+        break;
+    }
+}
+
+void BatchMath::SlerpQuaternions(const XMFLOAT4* from, const XMFLOAT4* to, const float* t, XMFLOAT4* output,
+                                 size_t count) {
+    SlerpQuaternionsDispatch(from, to, t, 1, output, count);
+}
+
+void BatchMath::SlerpQuaternions(const XMFLOAT4* from, const XMFLOAT4* to, float t, XMFLOAT4* output,
+                                 size_t count) {
+    SlerpQuaternionsDispatch(from, to, &t, 0, output, count);
+}
+
+size_t BatchMath::CullBoxes(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* visible) {
+    switch (GetInstructionSet()) {
+    case InstructionSet::AVX2: return CullBoxesAVX2(frustum, boxes, count, visible);
+    case InstructionSet::SSE41: return CullBoxesSSE41(frustum, boxes, count, visible);
+    default: return CullBoxesScalar(frustum, boxes, count, visible);
+    }
+}
+
+BatchMath::InstructionSet BatchMath::GetInstructionSet() {
+    int current = g_instructionSet.load(std::memory_order_relaxed);
+    if (current < 0) {
+        current = static_cast<int>(GetSupportedInstructionSet());
+        g_instructionSet.store(current, std::memory_order_relaxed);
+    }
+    return static_cast<InstructionSet>(current);
+}
+
+void BatchMath::SetInstructionSet(InstructionSet instructionSet) {
+    const int supported = static_cast<int>(GetSupportedInstructionSet());
+    g_instructionSet.store(std::min(static_cast<int>(instructionSet), supported), std::memory_order_relaxed);
+}
+
+const char* BatchMath::GetInstructionSetName(InstructionSet instructionSet) {
+    switch (instructionSet) {
+    case InstructionSet::AVX2: return "AVX2";
+    case InstructionSet::SSE41: return "SSE4.1";
+    default: return "scalar";
+    }
+}
+
+} // namespace Nexus
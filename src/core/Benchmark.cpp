@@ -0,0 +1,191 @@
+#include "Benchmark.h"
+#include "Logger.h"
+#include <rapidjson/document.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace Nexus {
+
+namespace {
+
+// Makes the MAD of normally distributed samples estimate their standard deviation
+constexpr double MAD_SCALE = 1.4826;
+
+// Names and properties come from code, but quotes would break the file
+void WriteJsonString(std::ofstream& file, const std::string& text) {
+    file << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') file << '\\';
+        file << c;
+    }
+    file << '"';
+}
+
+// Of a sorted range
+double Median(const std::vector<double>& sorted) {
+    if (sorted.empty()) return 0.0;
+    const size_t middle = sorted.size() / 2;
+    return sorted.size() % 2 ? sorted[middle] : 0.5 * (sorted[middle - 1] + sorted[middle]);
+}
+
+double GetMilliseconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+void Benchmark::Add(const std::string& name, Function run, uint64_t operations, Function setup) {
+    cases_.push_back({ name, std::move(run), std::move(setup), std::max<uint64_t>(operations, 1) });
+}
+
+std::vector<std::string> Benchmark::GetCaseNames() const {
+    std::vector<std::string> names;
+    for (const Case& benchmarkCase : cases_) {
+        names.push_back(benchmarkCase.name);
+    }
+    return names;
+}
+
+void Benchmark::SetProperty(const std::string& key, const std::string& value) {
+    for (auto& property : properties_) {
+        if (property.first == key) {
+            property.second = value;
+            return;
+        }
+    }
+    properties_.emplace_back(key, value);
+}
+
+const std::vector<Benchmark::Result>& Benchmark::Run(const Settings& settings, const ReportFunction& report) {
+    const uint32_t minIterations = std::max(settings.minIterations, 1u);
+    const uint32_t maxIterations = std::max(settings.maxIterations, minIterations);
+
+    results_.clear();
+    for (const Case& benchmarkCase : cases_) {
+        if (!settings.filter.empty() && benchmarkCase.name.find(settings.filter) == std::string::npos) continue;
+
+        // Caches, allocations and lazily built state settle before anything is kept
+        for (uint32_t i = 0; i < settings.warmupIterations; ++i) {
+            if (benchmarkCase.setup) benchmarkCase.setup();
+            benchmarkCase.run();
+        }
+
+        Result result;
+        result.name = benchmarkCase.name;
+        result.operations = benchmarkCase.operations;
+        double elapsed = 0.0;
+        while (result.samples.size() < maxIterations &&
+               (result.samples.size() < minIterations || elapsed < settings.minSeconds * 1000.0)) {
+            if (benchmarkCase.setup) benchmarkCase.setup();
+            const auto start = std::chrono::steady_clock::now();
+            benchmarkCase.run();
+            const double milliseconds = GetMilliseconds(start, std::chrono::steady_clock::now());
+            result.samples.push_back(milliseconds);
+            elapsed += milliseconds;
+        }
+
+        Summarize(result);
+        results_.push_back(std::move(result));
+        if (report) report(results_.back());
+    }
+    return results_;
+}
+
+void Benchmark::Summarize(Result& result) {
+    result.iterations = static_cast<uint32_t>(result.samples.size());
+    if (result.samples.empty()) {
+        result.median = result.mad = result.mean = result.min = result.max = 0.0;
+        return;
+    }
+
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    result.median = Median(sorted);
+    result.min = sorted.front();
+    result.max = sorted.back();
+
+    double sum = 0.0;
+    for (double& sample : sorted) {
+        sum += sample;
+        sample = std::abs(sample - result.median);
+    }
+    result.mean = sum / sorted.size();
+    std::sort(sorted.begin(), sorted.end());
+    result.mad = Median(sorted) * MAD_SCALE;
+}
+
+bool Benchmark::WriteJSON(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+        Logger::Error("Failed to write benchmark results: " + filename);
+        return false;
+    }
+
+    file << std::setprecision(9) << "{\"properties\":{";
+    for (size_t p = 0; p < properties_.size(); ++p) {
+        if (p > 0) file << ',';
+        WriteJsonString(file, properties_[p].first);
+        file << ':';
+        WriteJsonString(file, properties_[p].second);
+    }
+    file << "},\"results\":[";
+    for (size_t r = 0; r < results_.size(); ++r) {
+        const Result& result = results_[r];
+        file << (r > 0 ? ",\n" : "\n") << "{\"name\":";
+        WriteJsonString(file, result.name);
+        file << ",\"operations\":" << result.operations << ",\"iterations\":" << result.iterations
+             << ",\"median\":" << result.median << ",\"mad\":" << result.mad << ",\"mean\":" << result.mean
+             << ",\"min\":" << result.min << ",\"max\":" << result.max << ",\"samples\":[";
+        for (size_t i = 0; i < result.samples.size(); ++i) {
+            if (i > 0) file << ',';
+            file << result.samples[i];
+        }
+        file << "]}";
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+bool Benchmark::ReadJSON(const std::string& filename, std::vector<Result>& results) {
+    std::ifstream file(filename);
+    if (!file) {
+        Logger::Error("Cannot open benchmark results: " + filename);
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    const std::string text = stream.str();
+
+    rapidjson::Document document;
+    document.Parse(text.c_str());
+    if (document.HasParseError() || !document.IsObject() || !document.HasMember("results") ||
+        !document["results"].IsArray()) {
+        Logger::Error("Not a benchmark results file: " + filename);
+        return false;
+    }
+
+    results.clear();
+    for (const rapidjson::Value& entry : document["results"].GetArray()) {
+        if (!entry.IsObject() || !entry.HasMember("name") || !entry["name"].IsString()) continue;
+        Result result;
+        result.name = entry["name"].GetString();
+        if (entry.HasMember("operations") && entry["operations"].IsUint64()) {
+            result.operations = entry["operations"].GetUint64();
+        }
+        if (entry.HasMember("samples") && entry["samples"].IsArray()) {
+            for (const rapidjson::Value& sample : entry["samples"].GetArray()) {
+                if (sample.IsNumber()) result.samples.push_back(sample.GetDouble());
+            }
+        }
+        // Recomputed rather than trusted, so files cut down to their samples still compare
+        Summarize(result);
+        results.push_back(std::move(result));
+    }
+    return true;
+}
+
+} // namespace Nexus
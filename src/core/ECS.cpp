@@ -0,0 +1,250 @@
+#include "ECS.h"
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
+namespace Nexus {
+
+namespace {
+ComponentInfo g_componentInfos[ECS_MAX_COMPONENTS];
+std::atomic<size_t> g_componentCount{0};
+std::mutex g_registryMutex;
+
+size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+// ComponentRegistry implementation
+ComponentTypeID ComponentRegistry::Register(const ComponentInfo& info) {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+
+    size_t id = g_componentCount.load(std::memory_order_relaxed);
+    if (id >= ECS_MAX_COMPONENTS) {
+        Logger::Error("ECS: component limit (" + std::to_string(ECS_MAX_COMPONENTS) + ") exceeded registering " + info.name);
+        throw std::runtime_error("ECS component limit exceeded");
+    }
+
+    g_componentInfos[id] = info;
+    g_componentCount.store(id + 1, std::memory_order_release);
+    return static_cast<ComponentTypeID>(id);
+}
+
+const ComponentInfo& ComponentRegistry::GetInfo(ComponentTypeID id) {
+    return g_componentInfos[id];
+}
+
+size_t ComponentRegistry::GetCount() {
+    return g_componentCount.load(std::memory_order_acquire);
+}
+
+// Archetype implementation
+Archetype::Archetype(const ComponentMask& mask)
+    : mask_(mask)
+    , chunkCapacity_(0)
+    , chunkBytes_(ECS_CHUNK_SIZE)
+    , entityCount_(0)
+{
+    std::fill(std::begin(columnIndex_), std::end(columnIndex_), static_cast<int16_t>(-1));
+
+    size_t bytesPerEntity = sizeof(Entity);
+    for (ComponentTypeID type = 0; type < ECS_MAX_COMPONENTS; ++type) {
+        if (!mask_.test(type)) continue;
+        const ComponentInfo& info = ComponentRegistry::GetInfo(type);
+        columnIndex_[type] = static_cast<int16_t>(columns_.size());
+        columns_.push_back({type, 0, info.size});
+        bytesPerEntity += info.size;
+    }
+
+    // Lay out [entities][component 0][component 1]..., each array starting on a cache line
+    auto layout = [this](size_t capacity) {
+        size_t offset = AlignUp(sizeof(Entity) * capacity, ECS_CACHE_LINE);
+        for (Column& column : columns_) {
+            column.offset = offset;
+            offset = AlignUp(offset + column.size * capacity, ECS_CACHE_LINE);
+        }
+        return offset;
+    };
+
+    size_t capacity = std::max<size_t>(ECS_CHUNK_SIZE / bytesPerEntity, 1);
+    while (capacity > 1 && layout(capacity) > ECS_CHUNK_SIZE) {
+        --capacity;
+    }
+
+    chunkCapacity_ = capacity;
+    chunkBytes_ = std::max(layout(capacity), ECS_CHUNK_SIZE); // Oversized components get a bigger chunk
+}
+
+Archetype::~Archetype() {
+    while (entityCount_ > 0) {
+        RemoveRow(entityCount_ - 1);
+    }
+    for (Chunk& chunk : chunks_) {
+        ::operator delete(chunk.memory, std::align_val_t(ECS_CACHE_LINE));
+    }
+    chunks_.clear();
+}
+
+void* Archetype::GetComponentArray(size_t chunk, ComponentTypeID type) const {
+    int16_t column = columnIndex_[type];
+    if (column < 0) return nullptr;
+    return chunks_[chunk].memory + columns_[column].offset;
+}
+
+void* Archetype::GetComponent(size_t row, ComponentTypeID type) const {
+    const Column& column = columns_[columnIndex_[type]];
+    const Chunk& chunk = chunks_[row / chunkCapacity_];
+    return chunk.memory + column.offset + column.size * (row % chunkCapacity_);
+}
+
+size_t Archetype::AllocateRow(Entity entity) {
+    if (chunks_.empty() || chunks_.back().count == chunkCapacity_) {
+        Chunk chunk;
+        chunk.memory = static_cast<uint8_t*>(::operator new(chunkBytes_, std::align_val_t(ECS_CACHE_LINE)));
+        chunks_.push_back(chunk);
+    }
+
+    Chunk& chunk = chunks_.back();
+    reinterpret_cast<Entity*>(chunk.memory)[chunk.count] = entity;
+    chunk.count++;
+    return entityCount_++;
+}
+
+Entity Archetype::RemoveRow(size_t row) {
+    size_t last = entityCount_ - 1;
+    Entity moved;
+
+    for (const Column& column : columns_) {
+        const ComponentInfo& info = ComponentRegistry::GetInfo(column.type);
+        void* hole = GetComponent(row, column.type);
+        info.destruct(hole);
+        if (row != last) {
+            void* tail = GetComponent(last, column.type);
+            info.moveConstruct(hole, tail);
+            info.destruct(tail);
+        }
+    }
+
+    if (row != last) {
+        Entity* rowEntities = GetEntities(row / chunkCapacity_);
+        Entity* lastEntities = GetEntities(last / chunkCapacity_);
+        moved = lastEntities[last % chunkCapacity_];
+        rowEntities[row % chunkCapacity_] = moved;
+    }
+
+    entityCount_--;
+    Chunk& tailChunk = chunks_.back();
+    tailChunk.count--;
+    if (tailChunk.count == 0) {
+        ::operator delete(tailChunk.memory, std::align_val_t(ECS_CACHE_LINE));
+        chunks_.pop_back();
+    }
+
+    return moved;
+}
+
+// World implementation
+World::World()
+    : entityCount_(0)
+{
+}
+
+World::~World() {
+    Clear();
+}
+
+Archetype* World::GetOrCreateArchetype(const ComponentMask& mask) {
+    auto it = archetypes_.find(mask);
+    if (it != archetypes_.end()) {
+        return it->second.get();
+    }
+
+    auto archetype = std::make_unique<Archetype>(mask);
+    Archetype* raw = archetype.get();
+    archetypes_.emplace(mask, std::move(archetype));
+    archetypeList_.push_back(raw);
+    return raw;
+}
+
+Entity World::AllocateEntity() {
+    Entity entity;
+    if (!freeIndices_.empty()) {
+        entity.index = freeIndices_.back();
+        freeIndices_.pop_back();
+    } else {
+        entity.index = static_cast<uint32_t>(records_.size());
+        records_.emplace_back();
+    }
+
+    entity.generation = records_[entity.index].generation;
+    entityCount_++;
+    return entity;
+}
+
+bool World::IsAlive(Entity entity) const {
+    return entity.index < records_.size() &&
+           records_[entity.index].archetype != nullptr &&
+           records_[entity.index].generation == entity.generation;
+}
+
+void World::FixupMovedEntity(Entity moved, size_t row) {
+    if (moved.IsValid()) {
+        records_[moved.index].row = row;
+    }
+}
+
+void World::DestroyEntity(Entity entity) {
+    if (!IsAlive(entity)) return;
+
+    EntityRecord& record = records_[entity.index];
+    size_t row = record.row;
+    FixupMovedEntity(record.archetype->RemoveRow(row), row);
+
+    record.archetype = nullptr;
+    record.row = 0;
+    record.generation++;
+    freeIndices_.push_back(entity.index);
+    entityCount_--;
+}
+
+void World::MoveEntity(Entity entity, Archetype* target) {
+    EntityRecord& record = records_[entity.index];
+    Archetype* source = record.archetype;
+    if (source == target) return;
+
+    size_t sourceRow = record.row;
+    size_t targetRow = target->AllocateRow(entity);
+
+    // Components present in both archetypes move across; the rest are destroyed by RemoveRow
+    for (const Archetype::Column& column : source->columns_) {
+        if (!target->HasColumn(column.type)) continue;
+        ComponentRegistry::GetInfo(column.type).moveConstruct(target->GetComponent(targetRow, column.type),
+                                                              source->GetComponent(sourceRow, column.type));
+    }
+    FixupMovedEntity(source->RemoveRow(sourceRow), sourceRow);
+
+    record.archetype = target;
+    record.row = targetRow;
+}
+
+void World::Clear() {
+    archetypeList_.clear();
+    archetypes_.clear();
+    chunkScratch_.clear();
+
+    // Bump generations so handles from before the clear stay dead
+    for (EntityRecord& record : records_) {
+        record.archetype = nullptr;
+        record.row = 0;
+        record.generation++;
+    }
+    freeIndices_.clear();
+    for (uint32_t i = static_cast<uint32_t>(records_.size()); i > 0; --i) {
+        freeIndices_.push_back(i - 1);
+    }
+    entityCount_ = 0;
+}
+
+} // namespace Nexus
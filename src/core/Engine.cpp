@@ -1,5 +1,8 @@
 #include "Engine.h"
+#include "EngineConfig.h"
 #include "GraphicsDevice.h"
+#include "DynamicResolution.h"
+#include "GpuProfiler.h"
 #include "AudioDevice.h"
 #include "AudioSystem.h"
 #include "InputManager.h"
@@ -15,31 +18,104 @@
 #include "MotionControlSystem.h"
 #include "EngineUI.h"
 #include "EngineErrorRecovery.h"
+#include "JobSystem.h"
+#include "InitGraph.h"
+#include "FramePacer.h"
+#include "Profiler.h"
+#include "FrameAllocator.h"
+#include "ECS.h"
+#include "RenderPipeline.h"
+#include "RenderQueue.h"
+#include "SceneBVH.h"
+#include "CommandRecorder.h"
+#include "ShaderCache.h"
+#include "ShaderWarmup.h"
+#include "StateCache.h"
+#include "FileWatcher.h"
+#include "FrameMetrics.h"
+#include "MemoryTracker.h"
+#include "WorldPartition.h"
+#include "TransformHierarchy.h"
+#include "SceneBenchmark.h"
+#include "SessionRecorder.h"
+#include "Replication.h"
+#include "SpriteBatcher.h"
+#include "BatchMath.h"
 #include <windowsx.h>
+#include <algorithm>
 #include <chrono>
 #include <stdexcept>
 #include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <random>
 
 namespace Nexus {
 
 // Static instance for window procedure
 static Engine* g_engineInstance = nullptr;
 
+// Below this many translucent draws, deferred recording costs more than it saves
+static constexpr size_t PARALLEL_SUBMISSION_THRESHOLD = 512;
+
+// The resources a run loads, in order, for the next one to prefetch and the pak builder to follow
+static constexpr const char* LOAD_ORDER_FILE = "load_order.txt";
+
+// Games add their own sources, players for instance, under other ids
+static constexpr uint32_t CAMERA_STREAMING_SOURCE = 0;
+
+// Video memory is a kernel query; usage moves slowly enough for a couple of reads a second
+static constexpr uint32_t VIDEO_MEMORY_QUERY_FRAMES = 30;
+
+// Dynamic resolution holds GPU time a little under the frame interval so spikes still make it
+static void MatchDynamicResolutionTarget(GraphicsDevice* graphics, float fps) {
+    DynamicResolution* dynamicResolution = graphics ? graphics->GetDynamicResolution() : nullptr;
+    if (!dynamicResolution || fps <= 0.0f) return;
+    DynamicResolution::Settings settings = dynamicResolution->GetSettings();
+    settings.targetFrameMs = 900.0f / fps;
+    dynamicResolution->SetSettings(settings);
+}
+
 Engine::Engine()
     : initialized_(false)
     , isRunning_(false)
     , shouldExit_(false)
     , recoveringFromError_(false)
+    , targetFPS_(0.0f)
     , deltaTime_(0.0f)
     , hwnd_(nullptr)
     , windowClass_("NexusEngineWindow")
     , frameCount_(0)
     , timeAccumulator_(0.0f)
+    , updateDeltaTime_(0.0f)
+    , fixedTimestep_(false)
+    , fixedDeltaTime_(1.0f / 60.0f)
+    , maxStepsPerFrame_(5)
+    , simulationAccumulator_(0.0f)
+    , pendingSimulationSteps_(0)
+    , interpolationAlpha_(1.0f)
+    , pipelinedRendering_(false)
+    , parallelSubmission_(false)
+    , d3d12Backend_(false)
+    , occlusionCulling_(false)
+    , dynamicResolution_(false)
+    , temporalAA_(false)
+    , maxFramesInFlight_(1)
+    , renderFrameNumber_(0)
+    , visibleObjectCount_(0)
+    , inputMotionX_(0)
+    , inputMotionY_(0)
+    , headless_(false)
+    , headlessTickRate_(60.0f)
+    , frameLimit_(0)
+    , fiberJobs_(false)
+    , randomSeed_(0)
 {
     g_engineInstance = this;
     
     // Initialize performance stats
     perfStats_ = {};
+    metrics_ = std::make_unique<FrameMetrics>();
 }
 
 Engine::~Engine() {
@@ -62,13 +138,18 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             return 0;
             
         case WM_SIZE:
-            if (g_engineInstance && g_engineInstance->GetGraphics()) {
-                UINT width = LOWORD(lParam);
-                UINT height = HIWORD(lParam);
-                // Handle resize
+            if (g_engineInstance && wParam != SIZE_MINIMIZED) {
+                g_engineInstance->OnResize(LOWORD(lParam), HIWORD(lParam));
             }
             return 0;
             
+        case WM_INPUT:
+            if (g_engineInstance && g_engineInstance->GetInput()) {
+                g_engineInstance->GetInput()->HandleRawInput(wParam, lParam);
+            }
+            // DefWindowProc frees the input's buffer
+            break;
+            
         case WM_KEYDOWN:
             if (wParam == VK_ESCAPE) {
                 if (g_engineInstance) {
@@ -81,6 +162,21 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     return DefWindowProc(hwnd, uMsg, wParam, lParam);
 }
 
+// Console control handler so headless servers shut down cleanly on Ctrl+C / service stop
+static BOOL WINAPI ConsoleCtrlHandler(DWORD ctrlType) {
+    switch (ctrlType) {
+        case CTRL_C_EVENT:
+        case CTRL_BREAK_EVENT:
+        case CTRL_CLOSE_EVENT:
+        case CTRL_SHUTDOWN_EVENT:
+            if (g_engineInstance) {
+                g_engineInstance->RequestExit();
+            }
+            return TRUE;
+    }
+    return FALSE;
+}
+
 bool Engine::Initialize(const std::string& configFile) {
     if (initialized_) return true;
     
@@ -93,6 +189,54 @@ bool Engine::Initialize(const std::string& configFile) {
             return false;
         }
 
+        Profiler::Initialize();
+
+        // Detects the CPU's SIMD support once, before scripts and jobs call in
+        Logger::Info(std::string("Batch math: ") + BatchMath::GetInstructionSetName(BatchMath::GetInstructionSet()));
+
+        // Bytecode precompiled by the NexusShaders build step, refilled on a miss
+        ShaderCache::Initialize();
+
+        // Start worker threads before any subsystem so they can schedule work
+        jobs_ = std::make_unique<JobSystem>();
+        if (!jobs_->Initialize(0, fiberJobs_ ? JobBackend::Fibers : JobBackend::Threads)) {
+            Logger::Error("Failed to initialize job system");
+            return false;
+        }
+
+        framePacer_ = std::make_unique<FramePacer>();
+        framePacer_->Initialize(targetFPS_);
+
+        frameArena_ = std::make_unique<FrameArena>();
+        if (!frameArena_->Initialize()) {
+            Logger::Error("Failed to initialize frame arena");
+            return false;
+        }
+
+        // Hot reload only loses its notifications without it
+        fileWatcher_ = std::make_unique<FileWatcher>();
+        if (!fileWatcher_->Start()) {
+            fileWatcher_.reset();
+        }
+
+        world_ = std::make_unique<World>();
+        transforms_ = std::make_unique<TransformHierarchy>();
+
+        if (headless_) {
+            if (!InitializeHeadless()) {
+                return false;
+            }
+
+            BuildUpdateGraph();
+            if (!StartSession() || !StartSceneBenchmark()) {
+                return false;
+            }
+
+            Logger::Info("Engine initialized successfully (headless)");
+            initialized_ = true;
+            return true;
+        }
+
         // Create window
         WNDCLASSEXA wc = {};
         wc.cbSize = sizeof(WNDCLASSEXA);
@@ -130,10 +274,31 @@ bool Engine::Initialize(const std::string& configFile) {
         UpdateWindow(hwnd_);
 
         // Initialize graphics first
+        graphics_->SetBackend(d3d12Backend_ ? GraphicsDevice::Backend::D3D12 : GraphicsDevice::Backend::D3D11);
+        graphics_->SetJobSystem(jobs_.get());
         if (!graphics_->Initialize(hwnd_, width_, height_, fullscreen_)) {
             Logger::Error("Failed to initialize graphics device");
             return false;
         }
+        d3d12Backend_ = graphics_->GetBackend() == GraphicsDevice::Backend::D3D12;
+        framePacer_->SetFrameLatencyWaitable(graphics_->GetFrameLatencyWaitable());
+        if (parallelSubmission_) {
+            // One deferred context per thread that can record at once
+            unsigned int contexts = std::min(std::max(jobs_->GetWorkerCount() + 1, 2u), 8u);
+            if (!graphics_->EnableParallelSubmission(contexts)) {
+                parallelSubmission_ = false;
+            }
+        }
+        if (occlusionCulling_) {
+            occlusionCulling_ = graphics_->SetOcclusionCulling(true);
+        }
+        if (dynamicResolution_) {
+            dynamicResolution_ = graphics_->SetDynamicResolution(true);
+            MatchDynamicResolutionTarget(graphics_.get(), targetFPS_);
+        }
+        if (temporalAA_) {
+            temporalAA_ = graphics_->SetTemporalAA(true);
+        }
 
         // Initialize input
         if (!input_->Initialize(hwnd_)) {
@@ -141,74 +306,104 @@ bool Engine::Initialize(const std::string& configFile) {
             return false;
         }
 
-        // Initialize resource manager with graphics device
-        if (!resources_->Initialize(graphics_->GetDevice())) {
-            Logger::Error("Failed to initialize resource manager");
-            return false;
-        }
+        // The rest only needs the device and the job system, so independent subsystems start
+        // concurrently. Steps that may touch the immediate context are chained one after another
+        InitGraph init;
 
-        // Initialize audio
-        if (!audio_->Initialize()) {
-            Logger::Error("Failed to initialize audio device");
-            return false;
-        }
+        InitGraph::StepID resourcesStep = init.AddStep("Resources", [this]() {
+            if (!resources_->Initialize(graphics_->GetDevice(), graphics_->GetTextureStreaming(), jobs_.get())) {
+                return false;
+            }
+            resources_->EnableHotReload(fileWatcher_.get());
+            // What the last run loaded comes in ahead of the code asking for it; this run's order
+            // replaces it on shutdown
+            resources_->PrefetchLoadOrder(LOAD_ORDER_FILE);
+            resources_->StartLoadOrderRecording();
+            return true;
+        }, {}, "Failed to initialize resource manager");
+
+        InitGraph::StepID audioStep = init.AddStep("AudioDevice", [this]() {
+            return audio_->Initialize();
+        }, {}, "Failed to initialize audio device");
 
         // Fix: Use correct AudioSystem::Initialize signature (takes int parameters, not AudioDevice*)
-        if (!audioSystem_->Initialize(44100, 2, 16, AudioSystem::AudioChannelLayout::Stereo)) {
-            Logger::Error("Failed to initialize audio system");
-            return false;
-        }
+        init.AddStep("AudioSystem", [this]() {
+            return audioSystem_->Initialize(44100, 2, 16, AudioSystem::AudioChannelLayout::Stereo);
+        }, {audioStep}, "Failed to initialize audio system");
 
 #ifdef NEXUS_PYTHON_ENABLED
-        // Initialize scripting
-        if (!scripting_->Initialize()) {
-            Logger::Warning("Python scripting not available");
-        }
+        // The interpreter's thread state belongs to the thread that starts it
+        init.AddMainThreadStep("Scripting", [this]() {
+            return scripting_->Initialize(this);
+        }, "Python scripting not available", InitGraph::Failure::Warning);
 #endif
 
-        // Initialize physics
-        if (!physics_->Initialize()) {
-            Logger::Error("Failed to initialize physics engine");
-            return false;
-        }
+        init.AddStep("Physics", [this]() {
+            physics_->SetWorld(world_.get());
+            physics_->SetJobSystem(jobs_.get());
+            return physics_->Initialize();
+        }, {}, "Failed to initialize physics engine");
 
-        // Initialize AI system
-        if (!ai_->Initialize()) {
-            Logger::Error("Failed to initialize AI system");
-            return false;
-        }
+        init.AddStep("AI", [this]() {
+            return ai_->Initialize();
+        }, {}, "Failed to initialize AI system");
 
-        // Initialize lighting engine
-        if (!lighting_->Initialize(graphics_->GetDevice(), graphics_->GetContext(), width_, height_)) {
-            Logger::Error("Failed to initialize lighting engine");
-            return false;
-        }
+        InitGraph::StepID lightingStep = init.AddStep("Lighting", [this]() {
+            return lighting_->Initialize(graphics_->GetDevice(), graphics_->GetContext(), width_, height_,
+                                         graphics_->GetStateCache(), jobs_.get());
+        }, {resourcesStep}, "Failed to initialize lighting engine");
 
         // Fix: AnimationSystem::Initialize takes device and context parameters
-        if (!animation_->Initialize(graphics_->GetDevice(), graphics_->GetContext())) {
-            Logger::Error("Failed to initialize animation system");
-            return false;
-        }
+        InitGraph::StepID animationStep = init.AddStep("Animation", [this]() {
+            animation_->SetJobSystem(jobs_.get());
+            return animation_->Initialize(graphics_->GetDevice(), graphics_->GetContext());
+        }, {lightingStep}, "Failed to initialize animation system");
 
-        // Initialize particle system
-        if (!particles_->Initialize(graphics_->GetDevice(), graphics_->GetContext())) {
-            Logger::Error("Failed to initialize particle system");
-            return false;
-        }
+        InitGraph::StepID particlesStep = init.AddStep("Particles", [this]() {
+            particles_->SetJobSystem(jobs_.get());
+            return particles_->Initialize(graphics_->GetDevice(), graphics_->GetContext());
+        }, {animationStep}, "Failed to initialize particle system");
 
         // Fix: MotionControlSystem::Initialize takes no parameters
-        if (!motionControl_->Initialize()) {
-            Logger::Warning("Motion control initialization failed - continuing without motion control");
+        init.AddStep("MotionControl", [this]() {
+            motionControl_->SetJobSystem(jobs_.get());
+            return motionControl_->Initialize();
+        }, {}, "Motion control initialization failed - continuing without motion control",
+        InitGraph::Failure::Warning);
+
+        init.AddStep("TextRenderer", [this]() {
+            textRenderer_ = std::make_unique<TextRenderer>();
+            if (!textRenderer_->Initialize(graphics_->GetDevice(), graphics_->GetContext(), graphics_->GetStateCache())) {
+                return false;
+            }
+            // 2D text from scripts and the C API draws with the same font
+            if (SpriteBatcher* sprites = graphics_->GetSpriteBatcher()) {
+                sprites->SetFont(textRenderer_.get());
+            }
+            return true;
+        }, {particlesStep}, "Failed to initialize text renderer", InitGraph::Failure::Warning);
+
+        if (!init.Run(*jobs_)) {
+            return false;
         }
+        audioSystem_->SetJobSystem(jobs_.get());
+        audioSystem_->SetPhysicsEngine(physics_.get());
+
+        renderQueue_ = std::make_unique<RenderQueue>();
+        sceneBVH_ = std::make_unique<SceneBVH>();
 
-        // Create TextRenderer
-        textRenderer_ = std::make_unique<TextRenderer>();
-        if (!textRenderer_->Initialize(graphics_->GetDevice(), graphics_->GetContext())) {
-            Logger::Warning("Failed to initialize text renderer");
+        worldPartition_ = std::make_unique<WorldPartition>();
+        worldPartition_->Initialize(resources_.get(), physics_.get(), ai_.get());
+
+        // Create physics demo, unless a benchmark scene takes its place
+        if (!sceneBenchmark_) {
+            physics_->CreatePhysicsDemo();
         }
 
-        // Create physics demo
-        physics_->CreatePhysicsDemo();
+        BuildUpdateGraph();
+        if (!StartSession() || !StartSceneBenchmark()) {
+            return false;
+        }
 
         Logger::Info("Engine initialized successfully");
         initialized_ = true;
@@ -220,185 +415,919 @@ bool Engine::Initialize(const std::string& configFile) {
     }
 }
 
+bool Engine::InitializeHeadless() {
+    Logger::Info("Initializing headless simulation at " + std::to_string(headlessTickRate_) + " Hz...");
+
+    // Only the simulation subsystems; graphics, window, input, audio, lighting, particles,
+    // text and UI are left unset and every call site already skips them when null
+    if (!physics_) physics_ = std::make_unique<PhysicsEngine>();
+    if (!ai_) ai_ = std::make_unique<AIManager>();
+    if (!animation_) animation_ = std::make_unique<AnimationSystem>();
+
+    InitGraph init;
+    init.AddStep("Physics", [this]() {
+        physics_->SetWorld(world_.get());
+        physics_->SetJobSystem(jobs_.get());
+        return physics_->Initialize();
+    }, {}, "Failed to initialize physics engine");
+
+    init.AddStep("AI", [this]() {
+        return ai_->Initialize();
+    }, {}, "Failed to initialize AI system");
+
+    // No device: animation runs CPU-side only
+    init.AddStep("Animation", [this]() {
+        animation_->SetJobSystem(jobs_.get());
+        return animation_->Initialize(nullptr, nullptr);
+    }, {}, "Failed to initialize animation system");
+
+#ifdef NEXUS_PYTHON_ENABLED
+    if (!scripting_) scripting_ = std::make_unique<ScriptingEngine>();
+    init.AddMainThreadStep("Scripting", [this]() {
+        return scripting_->Initialize(this);
+    }, "Python scripting not available", InitGraph::Failure::Warning);
+#endif
+
+    if (!init.Run(*jobs_)) {
+        return false;
+    }
+
+    // Servers stream the cells around their players, who are the sources
+    worldPartition_ = std::make_unique<WorldPartition>();
+    worldPartition_->Initialize(nullptr, physics_.get(), ai_.get());
+
+    SetFixedTimestep(true, headlessTickRate_);
+    SetTargetFPS(headlessTickRate_);
+
+    SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+    return true;
+}
+
+bool Engine::StartSceneBenchmark() {
+    if (!sceneBenchmark_) return true;
+    if (!sceneBenchmark_->Initialize(*this)) {
+        return false;
+    }
+
+    // The profiler's scopes are the subsystem breakdown; every frame simulates timeStep instead
+    // of the time it took, so the fixed-step accumulator would only add steps at random
+    Profiler::SetEnabled(true);
+    SetFixedTimestep(false);
+    if (sceneBenchmark_->IsRecording()) {
+        return true;
+    }
+    SetTargetFPS(0.0f);
+    if (graphics_) {
+        graphics_->SetVSync(false);
+    }
+    if (input_) {
+        input_->SetLiveInput(false);
+    }
+    return true;
+}
+
+bool Engine::StartSession() {
+    randomSeed_ = std::random_device{}();
+    if (session_) {
+        SessionRecorder::Header header;
+        if (session_->IsRecording()) {
+            header.randomSeed = randomSeed_;
+            header.flags = (fixedTimestep_ ? SessionRecorder::SESSION_FIXED_TIMESTEP : 0) |
+                           (headless_ ? SessionRecorder::SESSION_HEADLESS : 0);
+            header.fixedDeltaTime = fixedDeltaTime_;
+            header.maxStepsPerFrame = maxStepsPerFrame_;
+            if (!session_->Open(header)) {
+                return false;
+            }
+        } else {
+            if (!session_->Open(header)) {
+                return false;
+            }
+            if (((header.flags & SessionRecorder::SESSION_HEADLESS) != 0) != headless_) {
+                Logger::Warning(std::string("Session was recorded ") +
+                                (headless_ ? "with a window" : "headless") + ", the replay may diverge");
+            }
+            randomSeed_ = header.randomSeed;
+            SetFixedTimestep((header.flags & SessionRecorder::SESSION_FIXED_TIMESTEP) != 0);
+            fixedDeltaTime_ = header.fixedDeltaTime;
+            SetMaxStepsPerFrame(header.maxStepsPerFrame);
+
+            // Frames take their recorded time; pacing is the recorder's, and only in real time
+            Profiler::SetEnabled(true);
+            SetTargetFPS(0.0f);
+            if (graphics_) {
+                graphics_->SetVSync(false);
+            }
+            if (input_) {
+                input_->SetLiveInput(false);
+            }
+        }
+    }
+
+    if (particles_) {
+        particles_->SetRandomSeed(randomSeed_);
+    }
+    return true;
+}
+
+void Engine::RecordSession(const std::string& filename) {
+    if (initialized_) {
+        Logger::Warning("Engine::RecordSession must be called before Initialize");
+        return;
+    }
+    session_ = std::make_unique<SessionRecorder>(filename, SessionRecorder::Mode::Record);
+}
+
+void Engine::ReplaySession(const std::string& filename, bool realTime) {
+    if (initialized_) {
+        Logger::Warning("Engine::ReplaySession must be called before Initialize");
+        return;
+    }
+    session_ = std::make_unique<SessionRecorder>(filename, realTime ? SessionRecorder::Mode::ReplayRealTime
+                                                                    : SessionRecorder::Mode::Replay);
+}
+
+void Engine::TriggerScriptEvent(const std::string& eventName) {
+    if (session_) {
+        if (!session_->IsRecording()) return;
+        session_->RecordScriptEvent(eventName);
+    }
+#ifdef NEXUS_PYTHON_ENABLED
+    if (scripting_) {
+        scripting_->TriggerEvent(eventName);
+    }
+#endif
+}
+
+bool Engine::HostServer(uint16_t port, uint32_t maxClients) {
+#ifdef NEXUS_NETWORKING_ENABLED
+    replicationClient_.reset();
+    network_ = std::make_unique<NetTransport>();
+    if (!network_->Listen(port, maxClients, REPLICATION_PROTOCOL_ID)) {
+        network_.reset();
+        return false;
+    }
+    replicationServer_ = std::make_unique<ReplicationServer>(*network_, ReplicationServer::Settings());
+    return true;
+#else
+    (void)port;
+    (void)maxClients;
+    Logger::Error("Engine::HostServer: built without networking");
+    return false;
+#endif
+}
+
+bool Engine::ConnectToServer(const std::string& host, uint16_t port) {
+#ifdef NEXUS_NETWORKING_ENABLED
+    replicationServer_.reset();
+    network_ = std::make_unique<NetTransport>();
+    if (!network_->Connect(host, port, REPLICATION_PROTOCOL_ID)) {
+        network_.reset();
+        return false;
+    }
+    replicationClient_ = std::make_unique<ReplicationClient>(*network_);
+    return true;
+#else
+    (void)host;
+    (void)port;
+    Logger::Error("Engine::ConnectToServer: built without networking");
+    return false;
+#endif
+}
+
+void Engine::UpdateNetwork() {
+#ifdef NEXUS_NETWORKING_ENABLED
+    NEXUS_PROFILE_SCOPE("Engine::UpdateNetwork");
+    network_->Receive();
+    NetTransport::Event event;
+    while (network_->PollEvent(event)) {
+        bool consumed = replicationServer_ ? replicationServer_->HandleEvent(event)
+                                           : replicationClient_ && replicationClient_->HandleEvent(event);
+        if (!consumed && networkEventHandler_) {
+            networkEventHandler_(event);
+        }
+    }
+    if (replicationServer_ && world_) {
+        replicationServer_->Update(*world_, jobs_.get(), deltaTime_);
+    }
+    network_->Flush();
+#endif
+}
+
+void Engine::SetSceneBenchmark(std::unique_ptr<SceneBenchmark> benchmark) {
+    if (initialized_) {
+        Logger::Warning("Engine::SetSceneBenchmark must be called before Initialize");
+        return;
+    }
+    sceneBenchmark_ = std::move(benchmark);
+}
+
+void Engine::SetHeadless(bool enabled, float tickRate) {
+    if (initialized_) {
+        Logger::Warning("Engine::SetHeadless must be called before Initialize");
+        return;
+    }
+
+    headless_ = enabled;
+    if (tickRate > 0.0f) {
+        headlessTickRate_ = tickRate;
+    }
+}
+
 void Engine::Run() {
     Logger::Info("Starting main engine loop...");
     
     isRunning_ = true;
-    Timer timer;
+    Timer frameTimer;
+    uint64_t framesRun = 0;
+    const bool replaying = session_ && !session_->IsRecording();
+    SessionRecorder::Frame replayFrame;
+    static const std::vector<InputEvent> noInputEvents;
+    
+    if (pipelinedRendering_ && graphics_ && !headless_) {
+        renderPipeline_ = std::make_unique<RenderPipeline>();
+        if (!renderPipeline_->Initialize([this](const RenderPacket& packet) {
+                // The render thread owns the immediate context (and the swap chain wait) from here on
+                if (framePacer_) {
+                    framePacer_->WaitForFrameLatency();
+                }
+                RenderObjectView objects;
+                objects.data = packet.objects.data();
+                objects.count = packet.objects.size();
+                SubmitFrame(objects, packet.data);
+            }, maxFramesInFlight_)) {
+            Logger::Warning("Failed to start render pipeline, rendering on the main thread");
+            renderPipeline_.reset();
+        }
+    }
     
     try {
         while (isRunning_) {
-            timer.Reset();
+            Profiler::BeginFrame();
+            if (frameArena_) {
+                frameArena_->BeginFrame();
+            }
             
-            MSG msg = {};
-            while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-                TranslateMessage(&msg);
-                DispatchMessage(&msg);
-                
-                if (msg.message == WM_QUIT) {
+            // Block until the swap chain can take another frame (no-op without a latency waitable)
+            if (framePacer_ && !renderPipeline_) {
+                framePacer_->WaitForFrameLatency();
+            }
+            
+            // Wall-clock time since the previous frame started
+            deltaTime_ = frameTimer.GetElapsedTime();
+            frameTimer.Reset();
+            if (replaying) {
+                if (!session_->ReplayFrame(replayFrame)) {
+                    Logger::Info("Session replay ended after " + std::to_string(session_->GetFrameCount()) + " frames");
                     isRunning_ = false;
                     break;
                 }
+                deltaTime_ = replayFrame.deltaTime;
+                if (input_) {
+                    for (const InputEvent& event : replayFrame.inputEvents) {
+                        input_->InjectEvent(event);
+                    }
+                }
+#ifdef NEXUS_PYTHON_ENABLED
+                if (scripting_) {
+                    for (const std::string& eventName : replayFrame.scriptEvents) {
+                        scripting_->TriggerEvent(eventName);
+                    }
+                }
+#endif
+            }
+            if (sceneBenchmark_) {
+                // Same step every frame, so benchmark runs simulate identically however fast they go
+                deltaTime_ = sceneBenchmark_->GetSettings().timeStep;
+                sceneBenchmark_->BeginFrame(*this);
+            }
+            
+            if (!headless_) {
+                MSG msg = {};
+                while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+                    TranslateMessage(&msg);
+                    DispatchMessage(&msg);
+                    
+                    if (msg.message == WM_QUIT) {
+                        isRunning_ = false;
+                        break;
+                    }
+                }
             }
 
-            // Check for ESC key to exit
-            if (GetAsyncKeyState(VK_ESCAPE) & 0x8000) {
-                isRunning_ = false;
-                break;
+            // Work out how many fixed simulation steps this frame owes
+            if (fixedTimestep_) {
+                simulationAccumulator_ += deltaTime_;
+                pendingSimulationSteps_ = static_cast<int>(simulationAccumulator_ / fixedDeltaTime_);
+                if (pendingSimulationSteps_ > maxStepsPerFrame_) {
+                    // Drop the backlog instead of spiralling after a long hitch
+                    pendingSimulationSteps_ = maxStepsPerFrame_;
+                    simulationAccumulator_ = fixedDeltaTime_ * maxStepsPerFrame_;
+                }
+                simulationAccumulator_ -= pendingSimulationSteps_ * fixedDeltaTime_;
+                interpolationAlpha_ = simulationAccumulator_ / fixedDeltaTime_;
+            } else {
+                pendingSimulationSteps_ = 1;
+                interpolationAlpha_ = 1.0f;
             }
 
             // Update
-            deltaTime_ = timer.GetElapsedTime();
+            uint64_t cpuStartNs = Profiler::GetTimeNs();
             try {
+                NEXUS_PROFILE_SCOPE("Engine::Update");
                 Update(deltaTime_);
+                if (network_) {
+                    UpdateNetwork();
+                }
             } catch (const std::exception& e) {
                 Logger::Error("Exception during update: " + std::string(e.what()));
                 isRunning_ = false;
                 break;
             }
 
-            // Render frame
+            // Render frame (headless runs have no graphics device and skip straight to pacing)
             try {
-                Render();
+                NEXUS_PROFILE_SCOPE("Engine::Render");
+                if (renderPipeline_) {
+                    QueueRenderPacket();
+                } else {
+                    Render();
+                }
             } catch (const std::exception& e) {
                 Logger::Error("Exception during render: " + std::string(e.what()));
                 isRunning_ = false;
                 break;
             }
 
+            float cpuMs = static_cast<float>(Profiler::GetTimeNs() - cpuStartNs) / 1000000.0f;
+
             // Cap frame rate
-            float frameTime = timer.GetElapsedTime();
-            if (targetFPS_ > 0) {
-                float targetFrameTime = 1.0f / targetFPS_;
-                if (frameTime < targetFrameTime) {
-                    Sleep(static_cast<DWORD>((targetFrameTime - frameTime) * 1000.0f));
-                }
+            if (framePacer_) {
+                NEXUS_PROFILE_SCOPE("Engine::WaitForNextFrame");
+                framePacer_->WaitForNextFrame();
+            }
+
+            Profiler::EndFrame();
+            perfStats_.frameTime = static_cast<float>(Profiler::GetLastFrameTimeMs());
+            perfStats_.updateTime = static_cast<float>(Profiler::GetScopeTimeMs("Engine::Update"));
+            perfStats_.renderTime = static_cast<float>(Profiler::GetScopeTimeMs("Engine::Render"));
+            RecordFrameMetrics(cpuMs);
+            RecordMemoryStats();
+
+            if (session_ && session_->IsRecording()) {
+                session_->RecordFrame(deltaTime_, input_ ? input_->GetEvents() : noInputEvents);
+            }
+
+            if (sceneBenchmark_ && !sceneBenchmark_->EndFrame(*this, cpuMs)) {
+                isRunning_ = false;
+            }
+
+            if (frameLimit_ > 0 && ++framesRun >= frameLimit_) {
+                Logger::Info("Frame limit of " + std::to_string(frameLimit_) + " reached");
+                isRunning_ = false;
             }
         }
     } catch (const std::exception& e) {
         Logger::Error("Exception in main loop: " + std::string(e.what()));
     }
     
+    // Let the render thread finish its packet before the device can be torn down
+    if (renderPipeline_) {
+        renderPipeline_->Shutdown();
+        renderPipeline_.reset();
+    }
+    
+    // Whatever ended the run, what was measured or recorded is kept
+    if (sceneBenchmark_) {
+        sceneBenchmark_->Finish();
+    }
+    if (session_) {
+        session_->Close();
+    }
+    
     Logger::Info("Main loop ended");
 }
 
+void Engine::BuildUpdateGraph() {
+    updateGraph_ = std::make_unique<TaskGraph>();
+
+    // Physics drives the world state that AI and animation read, everything else only
+    // depends on this frame's input which is polled before the graph runs
+    TaskGraph::TaskID physicsTask = updateGraph_->AddTask("Physics", [this]() {
+        NEXUS_PROFILE_SCOPE("Physics::Update");
+        UpdatePhysics();
+    });
+
+    updateGraph_->AddTask("AI", [this]() {
+        NEXUS_PROFILE_SCOPE("AI::Update");
+        NEXUS_MEMORY_SCOPE(MemoryTag::AI);
+        if (ai_) ai_->Update(updateDeltaTime_);
+    }, {physicsTask});
+
+    updateGraph_->AddTask("Animation", [this]() {
+        NEXUS_PROFILE_SCOPE("Animation::Update");
+        NEXUS_MEMORY_SCOPE(MemoryTag::Animation);
+        if (animation_) animation_->Update(updateDeltaTime_);
+    }, {physicsTask});
+
+    updateGraph_->AddTask("Audio", [this]() {
+        NEXUS_PROFILE_SCOPE("Audio::Update");
+        NEXUS_MEMORY_SCOPE(MemoryTag::Audio);
+        if (audioSystem_) audioSystem_->Update(updateDeltaTime_);
+    });
+
+    updateGraph_->AddTask("Particles", [this]() {
+        NEXUS_PROFILE_SCOPE("Particles::Update");
+        NEXUS_MEMORY_SCOPE(MemoryTag::Particles);
+        if (particles_) particles_->Update(updateDeltaTime_);
+    });
+
+    updateGraph_->AddTask("MotionControl", [this]() {
+        NEXUS_PROFILE_SCOPE("MotionControl::Update");
+        if (motionControl_) motionControl_->Update(updateDeltaTime_);
+    });
+
+    Logger::Info("Subsystem update graph built with " + std::to_string(updateGraph_->GetTaskCount()) + " tasks");
+}
+
+void Engine::SetTargetFPS(float fps) {
+    targetFPS_ = fps;
+    if (framePacer_) {
+        framePacer_->SetTargetFPS(fps);
+    }
+    MatchDynamicResolutionTarget(graphics_.get(), fps);
+}
+
+void Engine::SetFixedTimestep(bool enabled, float tickRate) {
+    fixedTimestep_ = enabled;
+    if (tickRate > 0.0f) {
+        fixedDeltaTime_ = 1.0f / tickRate;
+    }
+    simulationAccumulator_ = 0.0f;
+    interpolationAlpha_ = 1.0f;
+
+    Logger::Info(std::string("Fixed timestep ") + (enabled ? "enabled at " + std::to_string(tickRate) + " Hz" : "disabled"));
+}
+
+void Engine::UpdatePhysics() {
+    if (!physics_) return;
+    NEXUS_MEMORY_SCOPE(MemoryTag::Physics);
+
+    if (fixedTimestep_) {
+        for (int step = 0; step < pendingSimulationSteps_; ++step) {
+            physics_->Update(fixedDeltaTime_);
+        }
+    } else {
+        physics_->Update(updateDeltaTime_);
+    }
+
+    // Hand the completed state to the renderer once per frame, not per sub-step
+    physics_->PublishRenderSnapshot();
+}
+
 void Engine::Update(float deltaTime) {
+    updateDeltaTime_ = deltaTime;
+
+    // Files saved since the last frame reload before anything uses them
+    if (fileWatcher_) {
+        fileWatcher_->Poll();
+    }
+    // Likewise resources whose asynchronous loads have finished
+    if (resources_) {
+        NEXUS_MEMORY_SCOPE(MemoryTag::Resources);
+        resources_->Update();
+    }
+
     // Update input first
     if (input_) {
+        NEXUS_PROFILE_SCOPE("Input::Update");
         input_->Update();
+        input_->GetMouseMotionTotal(inputMotionX_, inputMotionY_);
     }
     
-    // Update physics
-    if (physics_) {
-        physics_->Update(deltaTime);
+    // Particle and AI LOD measure from the last rendered view
+    if (particles_ && graphics_) {
+        particles_->SetView(graphics_->GetViewMatrix(), graphics_->GetProjectionMatrix());
     }
-    
-    // Update AI
-    if (ai_) {
-        ai_->Update(deltaTime);
+    if (ai_ && graphics_) {
+        DirectX::XMFLOAT3 viewPosition;
+        DirectX::XMStoreFloat3(&viewPosition,
+            DirectX::XMMatrixInverse(nullptr, DirectX::XMLoadFloat4x4(&graphics_->GetViewMatrix())).r[3]);
+        ai_->SetViewerPosition(viewPosition);
+        if (worldPartition_) worldPartition_->SetStreamingSource(CAMERA_STREAMING_SOURCE, viewPosition);
     }
-    
-    // Update audio
-    if (audioSystem_) {
-        audioSystem_->Update(deltaTime);
-    }
-    
-    // Update animation
-    if (animation_) {
-        animation_->Update(deltaTime);
-    }
-    
-    // Update particles
-    if (particles_) {
-        particles_->Update(deltaTime);
+    // Cells come in before the update graph, which simulates their bodies and agents
+    if (worldPartition_) {
+        worldPartition_->Update();
     }
     
-    // Update motion control
-    if (motionControl_) {
-        motionControl_->Update(deltaTime);
+    // Independent subsystems run concurrently on the job system
+    if (jobs_ && updateGraph_) {
+        updateGraph_->Execute(*jobs_);
+    } else {
+        UpdatePhysics();
+        if (ai_) {
+            NEXUS_MEMORY_SCOPE(MemoryTag::AI);
+            ai_->Update(deltaTime);
+        }
+        if (audioSystem_) {
+            NEXUS_MEMORY_SCOPE(MemoryTag::Audio);
+            audioSystem_->Update(deltaTime);
+        }
+        if (animation_) {
+            NEXUS_MEMORY_SCOPE(MemoryTag::Animation);
+            animation_->Update(deltaTime);
+        }
+        if (particles_) {
+            NEXUS_MEMORY_SCOPE(MemoryTag::Particles);
+            particles_->Update(deltaTime);
+        }
+        if (motionControl_) motionControl_->Update(deltaTime);
     }
     
 #ifdef NEXUS_PYTHON_ENABLED
-    // Update scripting
+    // Update scripting (stays on the main thread, scripts may touch any subsystem)
     if (scripting_) {
+        NEXUS_PROFILE_SCOPE("Scripting::Update");
+        NEXUS_MEMORY_SCOPE(MemoryTag::Scripting);
         scripting_->Update(deltaTime);
     }
 #endif
     
+    // After scripts, so nodes they moved this frame render where they were put
+    if (transforms_) {
+        transforms_->Update(jobs_.get());
+    }
+    
     // Update UI
     if (ui_) {
+        NEXUS_PROFILE_SCOPE("UI::Update");
         ui_->Update(deltaTime);
     }
     
     // Update error recovery
     if (errorRecovery_) {
+        NEXUS_PROFILE_SCOPE("ErrorRecovery::Update");
         errorRecovery_->Update(deltaTime);
     }
 }
 
+void Engine::SetPipelinedRendering(bool enabled, int maxFramesInFlight) {
+    if (isRunning_) {
+        Logger::Warning("Pipelined rendering setting applies from the next Run()");
+    }
+    pipelinedRendering_ = enabled;
+    maxFramesInFlight_ = maxFramesInFlight > 0 ? maxFramesInFlight : 1;
+}
+
+float Engine::GetPipelineLatencyMs() const {
+    return renderPipeline_ ? renderPipeline_->GetLastLatencyMs() : 0.0f;
+}
+
+size_t Engine::WarmUpShaders() {
+    if (!resources_) return 0;
+    if (!shaderWarmup_) {
+        shaderWarmup_ = std::make_unique<ShaderWarmup>();
+    }
+    return shaderWarmup_->Start(*resources_, jobs_.get());
+}
+
+FrameRenderData Engine::BuildFrameRenderData() {
+    FrameRenderData data;
+    data.frameNumber = renderFrameNumber_++;
+    data.interpolationAlpha = fixedTimestep_ ? interpolationAlpha_ : 1.0f;
+    data.fps = GetFPS();
+    data.simulatedAtNs = Profiler::GetTimeNs();
+    data.mouseMotionX = inputMotionX_;
+    data.mouseMotionY = inputMotionY_;
+    return data;
+}
+
 void Engine::Render() {
     if (!graphics_) return;
     
+    FrameRenderData data = BuildFrameRenderData();
+    if (physics_) {
+        // Serial path draws straight from the physics snapshot, no copy
+        RenderSnapshotScope snapshot(*physics_);
+        SubmitFrame(snapshot.GetView(), data);
+    } else {
+        SubmitFrame(RenderObjectView(), data);
+    }
+}
+
+void Engine::QueueRenderPacket() {
+    if (renderPipeline_->HasFailed()) {
+        isRunning_ = false;
+        return;
+    }
+    
+    // Blocks while the render thread is maxFramesInFlight frames behind
+    RenderPacket* packet = nullptr;
+    {
+        NEXUS_PROFILE_SCOPE("Render::WaitForPacket");
+        packet = renderPipeline_->BeginPacket();
+    }
+    if (!packet) return;
+    
+    packet->objects.clear();
+    if (physics_) {
+        RenderSnapshotScope snapshot(*physics_);
+        const RenderObjectView& view = snapshot.GetView();
+        packet->objects.assign(view.begin(), view.end());
+    }
+    packet->data = BuildFrameRenderData();
+    renderPipeline_->SubmitPacket(packet);
+}
+
+void Engine::SubmitFrame(const RenderObjectView& renderObjects, const FrameRenderData& data) {
+    // Resizes reach the swap chain on the thread that owns the immediate context
+    uint64_t pendingSize = pendingResize_.exchange(0);
+    if (pendingSize != 0) {
+        int width = static_cast<int>(pendingSize >> 32);
+        int height = static_cast<int>(pendingSize & 0xffffffffu);
+        if (graphics_->Resize(width, height)) {
+            width_ = width;
+            height_ = height;
+        }
+    }
+    
+    // Latched as late as possible; everything after this draws from the patched view
+    DirectX::XMFLOAT4X4 simulatedView;
+    bool latched = LatchLateInput(data, simulatedView);
+    DirectX::XMFLOAT4X4 latchedView = graphics_->GetViewMatrix();
+    
     graphics_->BeginFrame();
     
+    // Per-cluster light lists for this frame's camera, bound for every forward-shaded draw
+    if (lighting_) {
+        NEXUS_PROFILE_SCOPE("Render::ClusterLights");
+        lighting_->CullLights(DirectX::XMLoadFloat4x4(&graphics_->GetViewMatrix()),
+                              DirectX::XMLoadFloat4x4(&graphics_->GetProjectionMatrix()));
+        lighting_->BindClusteredLights();
+    }
+    
     // Render physics objects
-    if (physics_) {
-        const auto& renderObjects = physics_->GetRenderObjects();
-        if (!renderObjects.empty()) {
+    {
+        NEXUS_PROFILE_SCOPE("Render::PhysicsObjects");
+        GpuProfileScope gpuScope(graphics_->GetGpuProfiler(), "Primitives");
+        const float alpha = data.interpolationAlpha;
+        visibleObjectCount_ = 0;
+        if (!renderObjects.empty() && renderQueue_ && sceneBVH_) {
             static bool firstRender = true;
             if (firstRender) {
                 Logger::Info("Rendering " + std::to_string(renderObjects.size()) + " physics objects");
                 firstRender = false;
             }
-            for (const auto& obj : renderObjects) {
+            
+            // Blend between the last two simulation steps while reading the snapshot in place
+            auto interpolate = [alpha](const RenderObject& obj) {
+                return DirectX::XMFLOAT3(obj.previousPosition.x + (obj.position.x - obj.previousPosition.x) * alpha,
+                                         obj.previousPosition.y + (obj.position.y - obj.previousPosition.y) * alpha,
+                                         obj.previousPosition.z + (obj.position.z - obj.previousPosition.z) * alpha);
+            };
+            
+            // Cull against the camera frustum; the hierarchy is rebuilt because every object can move
+            {
+                NEXUS_PROFILE_SCOPE("Render::Cull");
+                cullBounds_.resize(renderObjects.size());
+                for (size_t i = 0; i < renderObjects.size(); ++i) {
+                    const RenderObject& obj = renderObjects[i];
+                    DirectX::XMFLOAT3 extents = obj.scale;
+                    if (obj.shapeType == CollisionShape::Type::Sphere) {
+                        extents = DirectX::XMFLOAT3(obj.scale.x, obj.scale.x, obj.scale.x);
+                    } else if (obj.shapeType == CollisionShape::Type::Capsule) {
+                        extents = DirectX::XMFLOAT3(obj.scale.x, obj.scale.x + obj.scale.y * 0.5f, obj.scale.x);
+                    }
+                    cullBounds_[i] = AABB::FromCenterExtents(interpolate(obj), extents);
+                }
+                sceneBVH_->Build(cullBounds_.data(), cullBounds_.size());
+                
+                DirectX::XMMATRIX viewProjection = DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&graphics_->GetViewMatrix()),
+                                                                             DirectX::XMLoadFloat4x4(&graphics_->GetProjectionMatrix()));
+                visibleObjects_.clear();
+                sceneBVH_->Query(Frustum::FromViewProjection(viewProjection), visibleObjects_);
+                visibleObjectCount_ = visibleObjects_.size();
+            }
+            
+            // Key every visible object by shape and view depth; see-through colors sort back-to-front
+            const DirectX::XMFLOAT4X4& view = graphics_->GetViewMatrix();
+            renderQueue_->Clear();
+            renderQueue_->Reserve(visibleObjects_.size());
+            for (uint32_t i : visibleObjects_) {
+                const RenderObject& obj = renderObjects[i];
+                DirectX::XMFLOAT3 position = interpolate(obj);
+                float viewDepth = position.x * view._13 + position.y * view._23 + position.z * view._33 + view._43;
+                RenderQueue::BlendMode blend = obj.color.w < 1.0f ? RenderQueue::BlendMode::Translucent : RenderQueue::BlendMode::Opaque;
+                renderQueue_->Submit(renderQueue_->MakeKey(RenderQueue::Pass::Opaque, blend, 0, 0,
+                                                           static_cast<uint32_t>(obj.shapeType), viewDepth),
+                                     i);
+            }
+            renderQueue_->Sort();
+            
+            // Opaque objects go through the instanced batch in sorted (front-to-back) order;
+            // translucent ones must keep their exact order, so they are drawn one by one after it
+            const RenderQueue::Entry* entry = renderQueue_->begin();
+            const RenderQueue::Entry* translucentEnd = renderQueue_->end();
+            for (; entry != translucentEnd && !RenderQueue::IsTranslucent(entry->key); ++entry) {
+                const RenderObject& obj = renderObjects[entry->payload];
+                DirectX::XMFLOAT3 position = interpolate(obj);
                 switch (obj.shapeType) {
                     case CollisionShape::Type::Box:
-                        graphics_->RenderBox(obj.position, obj.scale, obj.color);
+                        graphics_->SubmitBox(position, obj.scale, obj.color);
                         break;
                     case CollisionShape::Type::Sphere:
-                        graphics_->RenderSphere(obj.position, obj.scale.x, obj.color);
+                        graphics_->SubmitSphere(position, obj.scale.x, obj.color);
                         break;
                     case CollisionShape::Type::Capsule:
-                        graphics_->RenderCapsule(obj.position, obj.scale.x, obj.scale.y, obj.color);
+                        graphics_->SubmitCapsule(position, obj.scale.x, obj.scale.y, obj.color);
                         break;
                 }
             }
+            graphics_->FlushPrimitiveBatch();
+            
+            auto recordTranslucent = [&](CommandContext& context, const RenderQueue::Entry* begin, const RenderQueue::Entry* end) {
+                for (const RenderQueue::Entry* it = begin; it != end; ++it) {
+                    const RenderObject& obj = renderObjects[it->payload];
+                    DirectX::XMFLOAT3 position = interpolate(obj);
+                    switch (obj.shapeType) {
+                        case CollisionShape::Type::Box:
+                            graphics_->RecordBox(context, position, obj.scale, obj.color);
+                            break;
+                        case CollisionShape::Type::Sphere:
+                            graphics_->RecordSphere(context, position, obj.scale.x, obj.color);
+                            break;
+                        case CollisionShape::Type::Capsule:
+                            graphics_->RecordCapsule(context, position, obj.scale.x, obj.scale.y, obj.color);
+                            break;
+                    }
+                }
+            };
+            
+            const RenderQueue::Entry* translucentBegin = entry;
+            size_t translucentCount = static_cast<size_t>(translucentEnd - translucentBegin);
+            CommandRecorder* recorder = graphics_->GetCommandRecorder();
+            if (recorder && translucentCount >= PARALLEL_SUBMISSION_THRESHOLD) {
+                // Contiguous chunks on deferred contexts, replayed in order so blending matches
+                NEXUS_PROFILE_SCOPE("Render::ParallelTranslucent");
+                size_t passes = std::min<size_t>(recorder->GetContextCount(), translucentCount / (PARALLEL_SUBMISSION_THRESHOLD / 2));
+                size_t chunk = (translucentCount + passes - 1) / passes;
+                recorder->Record(jobs_.get(), passes, [&](size_t pass, CommandContext& context) {
+                    const RenderQueue::Entry* begin = translucentBegin + std::min(pass * chunk, translucentCount);
+                    const RenderQueue::Entry* end = translucentBegin + std::min((pass + 1) * chunk, translucentCount);
+                    graphics_->BindMainRenderTarget(context);
+                    recordTranslucent(context, begin, end);
+                });
+                recorder->Execute(graphics_->GetContext(), *graphics_->GetStateCache());
+                
+                CommandContext immediate = graphics_->GetImmediateCommandContext();
+                graphics_->BindMainRenderTarget(immediate);
+            } else if (translucentCount > 0) {
+                CommandContext immediate = graphics_->GetImmediateCommandContext();
+                recordTranslucent(immediate, translucentBegin, translucentEnd);
+            }
         }
+    }
+    
+    // GPU particles collide with the depth the scene just wrote, then blend over it
+    if (particles_ && particles_->IsGPUSimulationEnabled()) {
+        NEXUS_PROFILE_SCOPE("Render::Particles");
+        GpuProfileScope gpuScope(graphics_->GetGpuProfiler(), "Particles");
+        // Particles bind their own state, so debug views reach them separately
+        StateCache* state = graphics_->GetStateCache();
+        particles_->SetPixelOverride(state->GetPixelOverrideShader(), state->GetPixelOverrideBlend());
+        particles_->RenderGPU(graphics_->GetViewMatrix(), graphics_->GetProjectionMatrix(), graphics_->GetDepthShaderView());
+        graphics_->GetStateCache()->Invalidate();
+        CommandContext immediate = graphics_->GetImmediateCommandContext();
+        graphics_->BindMainRenderTarget(immediate);
+    }
+    
+    // Text and UI draw at output resolution on top of the upscaled scene
+    graphics_->UpscaleScene();
+    
+    // 2D sprites, lines and text queued by game code, under the status text and UI
+    graphics_->FlushSpriteBatch();
+    
+    // Render UI text (basic status information)
+    if (textRenderer_) {
+        using namespace DirectX;
+        char line[64];
+        textRenderer_->RenderText("Nexus Engine v1.0", 10.0f, 10.0f, 1.0f, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+        std::snprintf(line, sizeof(line), "FPS: %d", data.fps);
+        textRenderer_->RenderText(line, 10.0f, 30.0f, 1.0f, XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f));
+        std::snprintf(line, sizeof(line), "Objects: %zu (%zu visible)", renderObjects.size(), visibleObjectCount_);
+        textRenderer_->RenderText(line, 10.0f, 50.0f, 1.0f, XMFLOAT4(0.8f, 0.8f, 0.8f, 1.0f));
         
-        // Render UI text (basic status information)
-        if (textRenderer_) {
-            using namespace DirectX;
-            textRenderer_->RenderText("Nexus Engine v1.0", 10.0f, 10.0f, 1.0f, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
-            textRenderer_->RenderText("FPS: " + std::to_string(GetFPS()), 10.0f, 30.0f, 1.0f, XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f));
-            textRenderer_->RenderText("Objects: " + std::to_string(physics_ ? physics_->GetRenderObjects().size() : 0), 10.0f, 50.0f, 1.0f, XMFLOAT4(0.8f, 0.8f, 0.8f, 1.0f));
-        }
+        // Everything queued this frame in one draw, under the UI
+        textRenderer_->Flush(static_cast<UINT>(width_), static_cast<UINT>(height_));
     }
     
-    // Render UI
+    // Render UI (built on the render thread when pipelined; panels read live engine state)
     if (ui_) {
+        NEXUS_PROFILE_SCOPE("Render::UI");
+        GpuProfileScope gpuScope(graphics_->GetGpuProfiler(), "UI");
+        ui_->NewFrame();
         ui_->Render();
+        ui_->EndFrame();
     }
     
     graphics_->EndFrame();
+    // Put the simulation's view back unless the simulation has set a newer one meanwhile
+    if (latched && std::memcmp(&graphics_->GetViewMatrix(), &latchedView, sizeof(latchedView)) == 0) {
+        graphics_->SetViewMatrix(simulatedView);
+    }
+    
+    NEXUS_PROFILE_SCOPE("Render::Present");
     graphics_->Present();
 }
 
-int Engine::GetFPS() {
-    static auto lastUpdate = std::chrono::high_resolution_clock::now();
-    static int frameCount = 0;
-    static int currentFPS = 0;
+bool Engine::LatchLateInput(const FrameRenderData& data, DirectX::XMFLOAT4X4& simulatedView) {
+    if (!lateLatch_ || !input_) return false;
+    NEXUS_PROFILE_SCOPE("Render::LateLatch");
     
-    frameCount++;
-    auto now = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration<float>(now - lastUpdate).count();
+    // Serially this is the window thread, so fetch the raw input that queued up during the frame
+    if (!renderPipeline_ && !headless_) {
+        MSG msg = {};
+        while (PeekMessage(&msg, nullptr, WM_INPUT, WM_INPUT, PM_REMOVE)) {
+            DispatchMessage(&msg);
+        }
+    }
+    
+    int64_t motionX = 0, motionY = 0;
+    input_->GetMouseMotionTotal(motionX, motionY);
+    int deltaX = static_cast<int>(motionX - data.mouseMotionX);
+    int deltaY = static_cast<int>(motionY - data.mouseMotionY);
+    if (deltaX == 0 && deltaY == 0) return false;
+    
+    simulatedView = graphics_->GetViewMatrix();
+    DirectX::XMFLOAT4X4 view = simulatedView;
+    lateLatch_(deltaX, deltaY, view);
+    graphics_->SetViewMatrix(view);
+    return true;
+}
+
+int Engine::GetFPS() const {
+    float frameMs = metrics_ ? metrics_->GetAverageFrameTimeMs() : 0.0f;
+    return frameMs > 0.0f ? static_cast<int>(1000.0f / frameMs + 0.5f) : 0;
+}
+
+void Engine::RecordFrameMetrics(float cpuMs) {
+    if (!metrics_) return;
     
-    if (elapsed >= 1.0f) {
-        currentFPS = frameCount;
-        frameCount = 0;
-        lastUpdate = now;
+    metrics_->Record("Frame", deltaTime_ * 1000.0f);
+    metrics_->Record("CPU", cpuMs);
+    
+    // GPU times resolve a few frames late; record each resolved frame once
+    GpuProfiler* gpuProfiler = graphics_ ? graphics_->GetGpuProfiler() : nullptr;
+    if (gpuProfiler && gpuProfiler->GetResolvedFrameCount() != metricsGpuFrames_) {
+        metricsGpuFrames_ = gpuProfiler->GetResolvedFrameCount();
+        metrics_->Record("GPU", gpuProfiler->GetLastResolvedFrameTime());
     }
     
-    return currentFPS;
+    // Subsystem breakdown comes from the profiler's scopes, so only while it is enabled
+    if (Profiler::IsEnabled()) {
+        static const char* const subsystemScopes[] = {
+            "Physics::Update", "AI::Update", "Animation::Update", "Audio::Update", "Particles::Update",
+            "Scripting::Update", "UI::Update", "Engine::Render"
+        };
+        for (const char* scope : subsystemScopes) {
+            double scopeMs = Profiler::GetScopeTimeMs(scope);
+            if (scopeMs > 0.0) {
+                metrics_->Record(scope, static_cast<float>(scopeMs));
+            }
+        }
+    }
+    metrics_->EndFrame();
+}
+
+void Engine::RecordMemoryStats() {
+    uint64_t heapBytes = MemoryTracker::GetTotalBytes();
+    perfStats_.memoryUsage = static_cast<int>(heapBytes / (1024 * 1024));
+
+    if (graphics_ && memoryStatsFrame_++ % VIDEO_MEMORY_QUERY_FRAMES == 0) {
+        GpuMemoryStats gpu;
+        graphics_->QueryVideoMemory(gpu);
+        MemoryTracker::SetGpuStats(gpu);
+    }
+
+    if (!Profiler::IsCapturing()) return;
+    constexpr double MB = 1024.0 * 1024.0;
+    ProfileCounterValue heap[MemoryTracker::TAG_COUNT];
+    for (size_t i = 0; i < MemoryTracker::TAG_COUNT; ++i) {
+        MemoryTag tag = static_cast<MemoryTag>(i);
+        heap[i].series = MemoryTracker::GetTagName(tag);
+        heap[i].value = MemoryTracker::GetStats(tag).currentBytes / MB;
+    }
+    Profiler::RecordCounter("Heap MB", heap, MemoryTracker::TAG_COUNT);
+
+    GpuMemoryStats gpu = MemoryTracker::GetGpuStats();
+    if (gpu.available) {
+        ProfileCounterValue video[] = {
+            { "Local", gpu.localUsage / MB },
+            { "Non-local", gpu.nonLocalUsage / MB }
+        };
+        Profiler::RecordCounter("Video memory MB", video, 2);
+    }
 }
 
 void Engine::Shutdown() {
@@ -406,6 +1335,52 @@ void Engine::Shutdown() {
     
     isRunning_ = false;
     
+    if (headless_) {
+        SetConsoleCtrlHandler(ConsoleCtrlHandler, FALSE);
+    }
+    
+    if (renderPipeline_) {
+        renderPipeline_->Shutdown();
+        renderPipeline_.reset();
+    }
+    
+    if (framePacer_) {
+        framePacer_->Shutdown();
+        framePacer_.reset();
+    }
+    
+    // Streamed cells give their bodies, agents and resources back while all three are up
+    worldPartition_.reset();
+    if (resources_ && resources_->IsRecordingLoadOrder()) {
+        resources_->SaveLoadOrder(LOAD_ORDER_FILE);
+    }
+
+    // Say goodbye to peers; the server encodes snapshots on the job system
+    replicationServer_.reset();
+    replicationClient_.reset();
+    network_.reset();
+
+    // Stop worker threads before the subsystems they update go away
+    updateGraph_.reset();
+    shaderWarmup_.reset();
+    if (jobs_) {
+        // The audio thread keeps rendering, so it has to let go of the workers first
+        if (audioSystem_) {
+            audioSystem_->SetPhysicsEngine(nullptr);
+            audioSystem_->SetJobSystem(nullptr);
+        }
+        // So does the resource loader, which compresses textures on them
+        if (resources_) {
+            resources_->Shutdown();
+        }
+        // And gesture matching, which may still have a job queued
+        if (motionControl_) {
+            motionControl_->SetJobSystem(nullptr);
+        }
+        jobs_->Shutdown();
+        jobs_.reset();
+    }
+    
     // Shutdown subsystems in reverse order
     textRenderer_.reset();
     motionControl_.reset();
@@ -423,8 +1398,14 @@ void Engine::Shutdown() {
     input_.reset();
     audioSystem_.reset();
     audio_.reset();
+    renderQueue_.reset();
+    sceneBVH_.reset();
     graphics_.reset();
     
+    // Subsystems release their entities on shutdown, so the world goes last
+    transforms_.reset();
+    world_.reset();
+    
     // Cleanup window
     if (hwnd_) {
         DestroyWindow(hwnd_);
@@ -433,6 +1414,16 @@ void Engine::Shutdown() {
     
     UnregisterClassA("NexusEngine", GetModuleHandle(nullptr));
     Platform::Shutdown();
+    ShaderCache::Shutdown();
+    Profiler::Shutdown();
+    
+    if (frameArena_) {
+        frameArena_->Shutdown();
+        frameArena_.reset();
+    }
+    
+    // After everything that listens to it
+    fileWatcher_.reset();
     
     Logger::Info("Engine shutdown complete");
 }
@@ -12,10 +12,31 @@
 
 namespace Nexus {
 
+namespace {
+
+// Memory load, in percent, that raises the warning, and below which it clears again
+constexpr DWORD MEMORY_HIGH_PERCENT = 90;
+constexpr DWORD MEMORY_NORMAL_PERCENT = 85;
+constexpr float MEMORY_PROBE_INTERVAL = 2.0f;
+
+float GetTimeSeconds() {
+    return std::chrono::duration<float>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::chrono::steady_clock::duration ToDuration(float seconds) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(seconds));
+}
+
+} // namespace
+
 EngineErrorRecovery::EngineErrorRecovery()
     : engine_(nullptr)
     , initialized_(false)
     , healthCheckTimer_(0.0f)
+    , deviceLostReported_(false)
+    , memoryHigh_(false)
+    , shutdownRequested_(false)
+    , hasPostedErrors_(false)
 {
 }
 
@@ -38,6 +59,11 @@ bool EngineErrorRecovery::Initialize(Engine* engine) {
     RegisterAutoFix("shader_compilation_error", [this]() { return FixShaderCompilationError(); });
     RegisterAutoFix("texture_loading_error", [this]() { return FixTextureLoadingError(); });
     
+    RegisterProbe("memory", MEMORY_PROBE_INTERVAL, [this]() { ProbeMemory(); });
+    
+    shutdownRequested_ = false;
+    monitorThread_ = std::thread(&EngineErrorRecovery::MonitorThread, this);
+    
     initialized_ = true;
     Logger::Info("Engine Error Recovery System initialized");
     
@@ -49,8 +75,25 @@ void EngineErrorRecovery::Shutdown() {
     
     Logger::Info("Shutting down Engine Error Recovery System...");
     
+    {
+        std::lock_guard<std::mutex> lock(monitorMutex_);
+        shutdownRequested_ = true;
+    }
+    monitorCondition_.notify_all();
+    if (monitorThread_.joinable()) {
+        monitorThread_.join();
+    }
+    probes_.clear();
+    {
+        std::lock_guard<std::mutex> lock(postedMutex_);
+        postedErrors_.clear();
+    }
+    hasPostedErrors_ = false;
+    
     errorHistory_.clear();
     autoFixes_.clear();
+    reportStates_.clear();
+    deviceLostReported_ = false;
     
     initialized_ = false;
     Logger::Info("Engine Error Recovery System shutdown complete");
@@ -59,53 +102,79 @@ void EngineErrorRecovery::Shutdown() {
 void EngineErrorRecovery::Update(float deltaTime) {
     if (!initialized_) return;
     
-    healthCheckTimer_ += deltaTime;
+    CheckDeviceRemoved();
     
-    // Perform health check every 5 seconds
-    if (healthCheckTimer_ >= 5.0f) {
+    if (hasPostedErrors_.load(std::memory_order_acquire)) {
+        ProcessPostedErrors();
+    }
+    
+    healthCheckTimer_ += deltaTime;
+    if (healthCheckTimer_ >= HEALTH_CHECK_INTERVAL) {
         PerformHealthCheck();
         healthCheckTimer_ = 0.0f;
     }
-    
-    // Check for common issues every frame
-    CheckForCommonIssues();
-    MonitorPerformance();
 }
 
 void EngineErrorRecovery::ReportError(const std::string& component, const std::string& description, 
                                      ErrorSeverity severity, const std::string& suggestedFix) {
+    float now = GetTimeSeconds();
+    ReportState& state = reportStates_[component + '\n' + description];
+    
+    // Critical errors always go through so their auto-fix gets a chance
+    if (severity != ErrorSeverity::Critical && state.lastReported > 0.0f &&
+        now - state.lastReported < REPORT_COOLDOWN) {
+        ++state.suppressed;
+        return;
+    }
+    
+    // Match the auto-fix patterns once per distinct report
+    if (!state.autoFixResolved) {
+        state.autoFix = -1;
+        for (size_t i = 0; i < autoFixes_.size(); ++i) {
+            if (description.find(autoFixes_[i].first) != std::string::npos) {
+                state.autoFix = static_cast<int>(i);
+                break;
+            }
+        }
+        state.autoFixResolved = true;
+    }
+    
     ErrorReport report;
     report.component = component;
     report.description = description;
     report.severity = severity;
     report.suggestedFix = suggestedFix;
-    report.canAutoFix = false;
-    report.timestamp = std::chrono::duration<float>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-    
-    // Check if we have an auto-fix for this error
-    for (const auto& fix : autoFixes_) {
-        if (description.find(fix.first) != std::string::npos) {
-            report.canAutoFix = true;
-            report.autoFixFunction = fix.second;
-            break;
-        }
+    report.canAutoFix = state.autoFix >= 0;
+    if (report.canAutoFix) {
+        report.autoFixFunction = autoFixes_[state.autoFix].second;
     }
+    report.timestamp = now;
+    report.repeatCount = state.suppressed;
+    state.lastReported = now;
+    state.suppressed = 0;
     
+    if (errorHistory_.size() >= MAX_ERROR_HISTORY) {
+        errorHistory_.erase(errorHistory_.begin(), errorHistory_.begin() + MAX_ERROR_HISTORY / 4);
+    }
     errorHistory_.push_back(report);
     
     // Log the error
+    std::string message = "[" + component + "] " + description;
+    if (report.repeatCount > 0) {
+        message += " (repeated " + std::to_string(report.repeatCount) + " times)";
+    }
     switch (severity) {
         case ErrorSeverity::Info:
-            Logger::Info("[" + component + "] " + description);
+            Logger::Info(message);
             break;
         case ErrorSeverity::Warning:
-            Logger::Warning("[" + component + "] " + description);
+            Logger::Warning(message);
             break;
         case ErrorSeverity::Error:
-            Logger::Error("[" + component + "] " + description);
+            Logger::Error(message);
             break;
         case ErrorSeverity::Critical:
-            Logger::Error("[CRITICAL][" + component + "] " + description);
+            Logger::Error("[CRITICAL]" + message);
             break;
     }
     
@@ -128,429 +197,53 @@ void EngineErrorRecovery::ReportError(const std::string& component, const std::s
     }
 }
 
-void EngineErrorRecovery::RegisterAutoFix(const std::string& errorPattern, std::function<bool()> fixFunction) {
-    autoFixes_.emplace_back(errorPattern, fixFunction);
-}
-
-bool EngineErrorRecovery::AttemptAutoFix(const std::string& component) {
-    bool anyFixed = false;
-    
-    for (auto& error : errorHistory_) {
-        if (error.component == component && error.canAutoFix && error.autoFixFunction) {
-            Logger::Info("Attempting auto-fix for: " + error.description);
-            if (error.autoFixFunction()) {
-                Logger::Info("Auto-fix successful!");
-                anyFixed = true;
-            } else {
-                Logger::Warning("Auto-fix failed for: " + error.description);
-            }
-        }
-    }
-    
-    return anyFixed;
-}
-
-bool EngineErrorRecovery::AttemptAutoFixAll() {
-    bool anyFixed = false;
-    
-    for (auto& error : errorHistory_) {
-        if (error.canAutoFix && error.autoFixFunction) {
-            Logger::Info("Attempting auto-fix for: " + error.description);
-            if (error.autoFixFunction()) {
-                Logger::Info("Auto-fix successful!");
-                anyFixed = true;
-            } else {
-                Logger::Warning("Auto-fix failed for: " + error.description);
-            }
-        }
-    }
-    
-    if (anyFixed && recoveryCallback_) {
-        recoveryCallback_("Auto-fix completed");
-    }
-    
-    return anyFixed;
-}
-
-EngineErrorRecovery::SystemHealth EngineErrorRecovery::CheckGraphicsHealth() {
-    SystemHealth health;
-    
-    if (!engine_ || !engine_->GetGraphics()) {
-        health.isHealthy = false;
-        health.healthScore = 0.0f;
-        health.issues.push_back("Graphics system not initialized");
-        health.fixes.push_back("Restart graphics system");
-        return health;
-    }
-    
-    // Check if device is lost
-    if (engine_->GetGraphics()->IsDeviceLost()) {
-        health.isHealthy = false;
-        health.healthScore = 20.0f;
-        health.issues.push_back("Graphics device lost");
-        health.fixes.push_back("Reset graphics device");
-    }
-    
-    graphicsHealth_ = health;
-    return health;
-}
-
-EngineErrorRecovery::SystemHealth EngineErrorRecovery::CheckAudioHealth() {
-    SystemHealth health;
-    
-    if (!engine_ || !engine_->GetAudioSystem()) {
-        health.isHealthy = false;
-        health.healthScore = 0.0f;
-        health.issues.push_back("Audio system not initialized");
-        health.fixes.push_back("Restart audio system");
-        return health;
-    }
-    
-    audioHealth_ = health;
-    return health;
-}
-
-EngineErrorRecovery::SystemHealth EngineErrorRecovery::CheckInputHealth() {
-    SystemHealth health;
-    
-    if (!engine_ || !engine_->GetInput()) {
-        health.isHealthy = false;
-        health.healthScore = 0.0f;
-        health.issues.push_back("Input system not initialized");
-        health.fixes.push_back("Restart input system");
-        return health;
-    }
-    
-    inputHealth_ = health;
-    return health;
-}
-
-EngineErrorRecovery::SystemHealth EngineErrorRecovery::CheckPhysicsHealth() {
-    SystemHealth health;
-    
-    if (!engine_ || !engine_->GetPhysics()) {
-        health.isHealthy = false;
-        health.healthScore = 0.0f;
-        health.issues.push_back("Physics system not initialized");
-        health.fixes.push_back("Restart physics system");
-        return health;
-    }
-    
-    physicsHealth_ = health;
-    return health;
-}
-
-EngineErrorRecovery::SystemHealth EngineErrorRecovery::CheckOverallHealth() {
-    SystemHealth graphics = CheckGraphicsHealth();
-    SystemHealth audio = CheckAudioHealth();
-    SystemHealth input = CheckInputHealth();
-    SystemHealth physics = CheckPhysicsHealth();
-    
-    overallHealth_.healthScore = (graphics.healthScore + audio.healthScore + 
-                                 input.healthScore + physics.healthScore) / 4.0f;
-    
-    overallHealth_.isHealthy = (overallHealth_.healthScore >= 80.0f);
-    
-    overallHealth_.issues.clear();
-    overallHealth_.fixes.clear();
-    
-    // Combine all issues
-    for (const auto& issue : graphics.issues) overallHealth_.issues.push_back("Graphics: " + issue);
-    for (const auto& issue : audio.issues) overallHealth_.issues.push_back("Audio: " + issue);
-    for (const auto& issue : input.issues) overallHealth_.issues.push_back("Input: " + issue);
-    for (const auto& issue : physics.issues) overallHealth_.issues.push_back("Physics: " + issue);
-    
-    // Combine all fixes
-    for (const auto& fix : graphics.fixes) overallHealth_.fixes.push_back("Graphics: " + fix);
-    for (const auto& fix : audio.fixes) overallHealth_.fixes.push_back("Audio: " + fix);
-    for (const auto& fix : input.fixes) overallHealth_.fixes.push_back("Input: " + fix);
-    for (const auto& fix : physics.fixes) overallHealth_.fixes.push_back("Physics: " + fix);
-    
-    return overallHealth_;
-}
-
-bool EngineErrorRecovery::RestartGraphicsSystem() {
-    if (!engine_) return false;
-    
-    Logger::Info("Attempting to restart graphics system...");
-    
-    try {
-        auto graphics = engine_->GetGraphics();
-        if (graphics) {
-            // Try to reset the device first
-            if (graphics->ResetDevice()) {
-                Logger::Info("Graphics device reset successful");
-                return true;
-            }
-        }
-        
-        // If reset failed, try full restart
-        // This would require engine support for restarting subsystems
-        Logger::Warning("Graphics device reset failed, full restart needed");
-        return false;
-        
-    } catch (const std::exception& e) {
-        Logger::Error("Failed to restart graphics system: " + std::string(e.what()));
-        return false;
-    }
-}
-
-bool EngineErrorRecovery::RestartAudioSystem() {
-    if (!engine_) return false;
-    
-    Logger::Info("Attempting to restart audio system...");
-    
-    try {
-        // This would require engine support for restarting subsystems
-        Logger::Info("Audio system restart successful");
-        return true;
-        
-    } catch (const std::exception& e) {
-        Logger::Error("Failed to restart audio system: " + std::string(e.what()));
-        return false;
-    }
-}
-
-bool EngineErrorRecovery::RestartInputSystem() {
-    if (!engine_) return false;
-    
-    Logger::Info("Attempting to restart input system...");
-    
-    try {
-        // This would require engine support for restarting subsystems
-        Logger::Info("Input system restart successful");
-        return true;
-        
-    } catch (const std::exception& e) {
-        Logger::Error("Failed to restart input system: " + std::string(e.what()));
-        return false;
-    }
-}
-
-bool EngineErrorRecovery::ResetToDefaults() {
-    Logger::Info("Resetting engine to default settings...");
-    
-    try {
-        // Reset all systems to default state
-        // This would involve clearing configurations and reinitializing
-        
-        Logger::Info("Engine reset to defaults successful");
-        return true;
-        
-    } catch (const std::exception& e) {
-        Logger::Error("Failed to reset engine: " + std::string(e.what()));
-        return false;
-    }
-}
-
-bool EngineErrorRecovery::RecoverFromCrash() {
-    Logger::Info("Attempting crash recovery...");
-    
-    try {
-        // Attempt to recover from a crash
-        // This might involve restarting all systems
-        
-        bool success = true;
-        success &= RestartGraphicsSystem();
-        success &= RestartAudioSystem();
-        success &= RestartInputSystem();
-        
-        if (success) {
-            Logger::Info("Crash recovery successful");
-        } else {
-            Logger::Error("Crash recovery failed");
-        }
-        
-        return success;
-        
-    } catch (const std::exception& e) {
-        Logger::Error("Crash recovery failed: " + std::string(e.what()));
-        return false;
-    }
-}
-
-void EngineErrorRecovery::PerformHealthCheck() {
-    if (!initialized_) return;
-    
-    CheckOverallHealth();
-    
-    // Report any new issues
-    if (!overallHealth_.isHealthy) {
-        for (const auto& issue : overallHealth_.issues) {
-            ReportError("HealthCheck", issue, ErrorSeverity::Warning);
-        }
-    }
-}
-
-void EngineErrorRecovery::CheckForCommonIssues() {
-    if (!engine_) return;
-    
-    // Check for graphics device lost
-    auto graphics = engine_->GetGraphics();
-    if (graphics && graphics->IsDeviceLost()) {
-        ReportError("Graphics", "Device lost detected", ErrorSeverity::Error, "Reset graphics device");
-    }
-    
-    // Check for low memory
-    MEMORYSTATUSEX memStatus;
-    memStatus.dwLength = sizeof(memStatus);
-    if (GlobalMemoryStatusEx(&memStatus)) {
-        DWORD memoryUsagePercent = memStatus.dwMemoryLoad;
-        if (memoryUsagePercent > 90) {
-            ReportError("Memory", "High memory usage: " + std::to_string(memoryUsagePercent) + "%", 
-                       ErrorSeverity::Warning, "Consider reducing memory usage");
-        }
-    }
-}
-
-void EngineErrorRecovery::MonitorPerformance() {
-    // TODO: Monitor FPS, frame time, etc.
-    // Report performance issues if detected
-}
-
-// Auto-fix implementations
-bool EngineErrorRecovery::FixGraphicsDeviceLost() {
-    return RestartGraphicsSystem();
-}
-
-bool EngineErrorRecovery::FixAudioDeviceDisconnected() {
-    return RestartAudioSystem();
-}
-
-bool EngineErrorRecovery::FixInputDeviceError() {
-    return Rest// filepath: g:\code\gameengine\src\core\EngineErrorRecovery.cpp
-#include "EngineErrorRecovery.h"
-#include "Engine.h"
-#include "Logger.h"
-#include "GraphicsDevice.h"
-#include "AudioSystem.h"
-#include "InputManager.h"
-#include "PhysicsEngine.h"
-
-#include <Windows.h>
-#include <algorithm>
-#include <chrono>
-
-namespace Nexus {
-
-EngineErrorRecovery::EngineErrorRecovery()
-    : engine_(nullptr)
-    , initialized_(false)
-    , healthCheckTimer_(0.0f)
-{
-}
-
-EngineErrorRecovery::~EngineErrorRecovery() {
-    Shutdown();
-}
-
-bool EngineErrorRecovery::Initialize(Engine* engine) {
-    if (initialized_) return true;
-    
-    engine_ = engine;
-    
-    Logger::Info("Initializing Engine Error Recovery System...");
-    
-    // Register common auto-fixes
-    RegisterAutoFix("graphics_device_lost", [this]() { return FixGraphicsDeviceLost(); });
-    RegisterAutoFix("audio_device_disconnected", [this]() { return FixAudioDeviceDisconnected(); });
-    RegisterAutoFix("input_device_error", [this]() { return FixInputDeviceError(); });
-    RegisterAutoFix("memory_leak", [this]() { return FixMemoryLeak(); });
-    RegisterAutoFix("shader_compilation_error", [this]() { return FixShaderCompilationError(); });
-    RegisterAutoFix("texture_loading_error", [this]() { return FixTextureLoadingError(); });
-    
-    initialized_ = true;
-    Logger::Info("Engine Error Recovery System initialized");
-    
-    return true;
-}
-
-void EngineErrorRecovery::Shutdown() {
-    if (!initialized_) return;
-    
-    Logger::Info("Shutting down Engine Error Recovery System...");
-    
-    errorHistory_.clear();
-    autoFixes_.clear();
-    
-    initialized_ = false;
-    Logger::Info("Engine Error Recovery System shutdown complete");
-}
-
-void EngineErrorRecovery::Update(float deltaTime) {
-    if (!initialized_) return;
-    
-    healthCheckTimer_ += deltaTime;
-    
-    // Perform health check every 5 seconds
-    if (healthCheckTimer_ >= 5.0f) {
-        PerformHealthCheck();
-        healthCheckTimer_ = 0.0f;
-    }
-    
-    // Check for common issues every frame
-    CheckForCommonIssues();
-    MonitorPerformance();
-}
-
-void EngineErrorRecovery::ReportError(const std::string& component, const std::string& description, 
-                                     ErrorSeverity severity, const std::string& suggestedFix) {
+void EngineErrorRecovery::PostError(const std::string& component, const std::string& description,
+                                    ErrorSeverity severity, const std::string& suggestedFix) {
     ErrorReport report;
     report.component = component;
     report.description = description;
     report.severity = severity;
     report.suggestedFix = suggestedFix;
     report.canAutoFix = false;
-    report.timestamp = std::chrono::duration<float>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-    
-    // Check if we have an auto-fix for this error
-    for (const auto& fix : autoFixes_) {
-        if (description.find(fix.first) != std::string::npos) {
-            report.canAutoFix = true;
-            report.autoFixFunction = fix.second;
-            break;
-        }
-    }
-    
-    errorHistory_.push_back(report);
+    report.timestamp = GetTimeSeconds();
     
-    // Log the error
-    switch (severity) {
-        case ErrorSeverity::Info:
-            Logger::Info("[" + component + "] " + description);
-            break;
-        case ErrorSeverity::Warning:
-            Logger::Warning("[" + component + "] " + description);
-            break;
-        case ErrorSeverity::Error:
-            Logger::Error("[" + component + "] " + description);
-            break;
-        case ErrorSeverity::Critical:
-            Logger::Error("[CRITICAL][" + component + "] " + description);
-            break;
-    }
-    
-    // Trigger callback
-    if (errorCallback_) {
-        errorCallback_(report);
+    std::lock_guard<std::mutex> lock(postedMutex_);
+    postedErrors_.push_back(std::move(report));
+    hasPostedErrors_.store(true, std::memory_order_release);
+}
+
+void EngineErrorRecovery::RegisterProbe(const std::string& name, float intervalSeconds, std::function<void()> probe) {
+    {
+        std::lock_guard<std::mutex> lock(monitorMutex_);
+        Probe entry;
+        entry.name = name;
+        entry.intervalSeconds = std::max(intervalSeconds, 0.01f);
+        entry.run = std::move(probe);
+        entry.nextRun = std::chrono::steady_clock::now();
+        probes_.push_back(std::move(entry));
     }
-    
-    // Attempt auto-fix for critical errors
-    if (severity == ErrorSeverity::Critical && report.canAutoFix) {
-        Logger::Info("Attempting auto-fix for critical error...");
-        if (report.autoFixFunction()) {
-            Logger::Info("Auto-fix successful!");
-            if (recoveryCallback_) {
-                recoveryCallback_("Auto-fixed: " + description);
+    monitorCondition_.notify_all();
+}
+
+void EngineErrorRecovery::SetProbeInterval(const std::string& name, float intervalSeconds) {
+    {
+        std::lock_guard<std::mutex> lock(monitorMutex_);
+        for (auto& probe : probes_) {
+            if (probe.name == name) {
+                probe.intervalSeconds = std::max(intervalSeconds, 0.01f);
+                probe.nextRun = std::min(probe.nextRun, std::chrono::steady_clock::now() + ToDuration(probe.intervalSeconds));
             }
-        } else {
-            Logger::Error("Auto-fix failed!");
         }
     }
+    monitorCondition_.notify_all();
 }
 
 void EngineErrorRecovery::RegisterAutoFix(const std::string& errorPattern, std::function<bool()> fixFunction) {
     autoFixes_.emplace_back(errorPattern, fixFunction);
+    // Reports seen so far may match the new pattern
+    for (auto& entry : reportStates_) {
+        entry.second.autoFixResolved = false;
+    }
 }
 
 bool EngineErrorRecovery::AttemptAutoFix(const std::string& component) {
@@ -803,36 +496,96 @@ void EngineErrorRecovery::PerformHealthCheck() {
     }
 }
 
-void EngineErrorRecovery::CheckForCommonIssues() {
-    if (!engine_) return;
-    
-    // Check for graphics device lost
-    auto graphics = engine_->GetGraphics();
-    if (graphics && graphics->IsDeviceLost()) {
+void EngineErrorRecovery::CheckDeviceRemoved() {
+    // Present() latches device removal, so this is a flag read; report once per loss
+    GraphicsDevice* graphics = engine_ ? engine_->GetGraphics() : nullptr;
+    bool deviceLost = graphics && graphics->IsDeviceLost();
+    if (deviceLost && !deviceLostReported_) {
         ReportError("Graphics", "Device lost detected", ErrorSeverity::Error, "Reset graphics device");
     }
-    
-    // Check for low memory
+    deviceLostReported_ = deviceLost;
+}
+
+void EngineErrorRecovery::ProcessPostedErrors() {
+    std::vector<ErrorReport> posted;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex_);
+        posted.swap(postedErrors_);
+        hasPostedErrors_.store(false, std::memory_order_relaxed);
+    }
+    for (const auto& report : posted) {
+        ReportError(report.component, report.description, report.severity, report.suggestedFix);
+    }
+}
+
+void EngineErrorRecovery::ProbeMemory() {
     MEMORYSTATUSEX memStatus;
     memStatus.dwLength = sizeof(memStatus);
-    if (GlobalMemoryStatusEx(&memStatus)) {
-        DWORD memoryUsagePercent = memStatus.dwMemoryLoad;
-        if (memoryUsagePercent > 90) {
-            ReportError("Memory", "High memory usage: " + std::to_string(memoryUsagePercent) + "%", 
-                       ErrorSeverity::Warning, "Consider reducing memory usage");
+    if (!GlobalMemoryStatusEx(&memStatus)) return;
+    
+    // Report on crossing the threshold, not on every sample above it
+    DWORD memoryUsagePercent = memStatus.dwMemoryLoad;
+    if (!memoryHigh_ && memoryUsagePercent > MEMORY_HIGH_PERCENT) {
+        memoryHigh_ = true;
+        PostError("Memory", "High memory usage: " + std::to_string(memoryUsagePercent) + "%",
+                  ErrorSeverity::Warning, "Consider reducing memory usage");
+    } else if (memoryHigh_ && memoryUsagePercent < MEMORY_NORMAL_PERCENT) {
+        memoryHigh_ = false;
+    }
+}
+
+void EngineErrorRecovery::MonitorThread() {
+    // Probes are never urgent; keep them off the cores the frame needs
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+    
+    std::unique_lock<std::mutex> lock(monitorMutex_);
+    while (!shutdownRequested_) {
+        auto now = std::chrono::steady_clock::now();
+        auto wakeTime = now + std::chrono::seconds(1);
+        for (size_t i = 0; i < probes_.size() && !shutdownRequested_; ++i) {
+            if (probes_[i].nextRun <= now) {
+                probes_[i].nextRun = now + ToDuration(probes_[i].intervalSeconds);
+                // Run unlocked so a slow probe doesn't hold up registration or shutdown
+                std::function<void()> run = probes_[i].run;
+                lock.unlock();
+                run();
+                lock.lock();
+                now = std::chrono::steady_clock::now();
+            }
+            if (i < probes_.size()) {
+                wakeTime = std::min(wakeTime, probes_[i].nextRun);
+            }
         }
+        monitorCondition_.wait_until(lock, wakeTime);
     }
 }
 
-void EngineErrorRecovery::MonitorPerformance() {
-    // TODO: Monitor FPS, frame time, etc.
-    // Report performance issues if detected
-}
-
 // Auto-fix implementations
 bool EngineErrorRecovery::FixGraphicsDeviceLost() {
     return RestartGraphicsSystem();
 }
 
 bool EngineErrorRecovery::FixAudioDeviceDisconnected() {
-    return RestartAudioSystem();
\ No newline at end of file
+    return RestartAudioSystem();
+}
+
+bool EngineErrorRecovery::FixInputDeviceError() {
+    return RestartInputSystem();
+}
+
+bool EngineErrorRecovery::FixMemoryLeak() {
+    Logger::Warning("Memory leak suspected, no automatic fix available");
+    return false;
+}
+
+bool EngineErrorRecovery::FixShaderCompilationError() {
+    Logger::Warning("Shader compilation failed, keeping the previous shaders");
+    return false;
+}
+
+bool EngineErrorRecovery::FixTextureLoadingError() {
+    Logger::Warning("Texture failed to load, using the fallback texture");
+    return false;
+}
+
+} // namespace Nexus
@@ -0,0 +1,155 @@
+#include "FrameAllocator.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+// LinearArena implementation
+LinearArena::LinearArena()
+    : buffer_(nullptr)
+    , capacity_(0)
+    , offset_(0)
+    , peakUsed_(0)
+    , overflowBytes_(0)
+{
+}
+
+LinearArena::~LinearArena() {
+    Shutdown();
+}
+
+bool LinearArena::Initialize(size_t capacity) {
+    if (buffer_) return true;
+
+    buffer_ = static_cast<uint8_t*>(::operator new(capacity, std::nothrow));
+    if (!buffer_) {
+        Logger::Error("Failed to allocate " + std::to_string(capacity) + " byte frame arena");
+        return false;
+    }
+
+    capacity_ = capacity;
+    offset_.store(0, std::memory_order_relaxed);
+    peakUsed_ = 0;
+    return true;
+}
+
+void LinearArena::Shutdown() {
+    Reset();
+    if (buffer_) {
+        ::operator delete(buffer_);
+        buffer_ = nullptr;
+    }
+    capacity_ = 0;
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment) {
+    if (size == 0) size = 1;
+    alignment = std::max<size_t>(alignment, 1);
+
+    if (buffer_) {
+        // Reserve size + alignment slack so the aligned block always fits inside the reservation
+        size_t reserved = size + alignment - 1;
+        size_t start = offset_.fetch_add(reserved, std::memory_order_relaxed);
+        if (start + reserved <= capacity_) {
+            uintptr_t base = reinterpret_cast<uintptr_t>(buffer_ + start);
+            return reinterpret_cast<void*>(AlignUp(base, alignment));
+        }
+    }
+
+    // Arena exhausted: spill to the heap and keep going, the overflow shows up in the stats
+    alignment = std::max(alignment, alignof(std::max_align_t));
+    void* block = ::operator new(size, std::align_val_t(alignment));
+    std::lock_guard<std::mutex> lock(overflowMutex_);
+    if (overflowBlocks_.empty()) {
+        Logger::Warning("Frame arena exhausted (" + std::to_string(capacity_) + " bytes), falling back to heap");
+    }
+    overflowBlocks_.push_back({block, alignment});
+    overflowBytes_ += size;
+    return block;
+}
+
+void LinearArena::Reset() {
+    size_t used = std::min(offset_.load(std::memory_order_relaxed), capacity_);
+    peakUsed_ = std::max(peakUsed_, used);
+    offset_.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(overflowMutex_);
+    for (const OverflowBlock& block : overflowBlocks_) {
+        ::operator delete(block.ptr, std::align_val_t(block.alignment));
+    }
+    overflowBlocks_.clear();
+    overflowBytes_ = 0;
+}
+
+bool LinearArena::Owns(const void* ptr) const {
+    const uint8_t* bytes = static_cast<const uint8_t*>(ptr);
+    return buffer_ && bytes >= buffer_ && bytes < buffer_ + capacity_;
+}
+
+LinearArena::Stats LinearArena::GetStats() const {
+    Stats stats;
+    stats.capacity = capacity_;
+    stats.used = std::min(offset_.load(std::memory_order_relaxed), capacity_);
+    stats.peakUsed = std::max(peakUsed_, stats.used);
+    std::lock_guard<std::mutex> lock(overflowMutex_);
+    stats.overflowBytes = overflowBytes_;
+    stats.overflowCount = overflowBlocks_.size();
+    return stats;
+}
+
+// FrameArena implementation
+FrameArena::FrameArena()
+    : current_(0)
+    , initialized_(false)
+{
+}
+
+FrameArena::~FrameArena() {
+    Shutdown();
+}
+
+bool FrameArena::Initialize(size_t bytesPerFrame) {
+    if (initialized_) return true;
+
+    if (!arenas_[0].Initialize(bytesPerFrame) || !arenas_[1].Initialize(bytesPerFrame)) {
+        Shutdown();
+        return false;
+    }
+
+    current_ = 0;
+    initialized_ = true;
+    Logger::Info("Frame arena initialized (2 x " + std::to_string(bytesPerFrame / 1024) + " KB)");
+    return true;
+}
+
+void FrameArena::Shutdown() {
+    arenas_[0].Shutdown();
+    arenas_[1].Shutdown();
+    initialized_ = false;
+}
+
+void FrameArena::BeginFrame() {
+    current_ ^= 1;
+    arenas_[current_].Reset();
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+    return arenas_[current_].Allocate(size, alignment);
+}
+
+const char* FrameArena::CopyString(const char* text, size_t length) {
+    char* copy = AllocateArray<char>(length + 1);
+    std::memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+} // namespace Nexus
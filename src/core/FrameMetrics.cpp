@@ -0,0 +1,216 @@
+#include "FrameMetrics.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace Nexus {
+
+namespace {
+
+// Bucket i covers [MIN_VALUE * GROWTH^i, MIN_VALUE * GROWTH^(i+1)): 1 us to about 100 s
+constexpr float MIN_VALUE_MS = 0.001f;
+constexpr float GROWTH = 1.05f;
+
+// Writes a series name into JSON; names come from code, but quotes would break the file
+void WriteJsonString(std::ofstream& file, const std::string& text) {
+    file << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') file << '\\';
+        file << c;
+    }
+    file << '"';
+}
+
+} // namespace
+
+FrameMetrics::FrameMetrics()
+    : frameNumber_(0)
+    , hitchFactor_(2.0f)
+    , hitchMinimumMs_(8.0f)
+{
+}
+
+FrameMetrics::~FrameMetrics() = default;
+
+void FrameMetrics::Record(const std::string& name, float milliseconds) {
+    milliseconds = std::max(milliseconds, 0.0f);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Series* series = FindSeries(name);
+    if (!series) {
+        series_.push_back(std::make_unique<Series>());
+        series = series_.back().get();
+        series->name = name;
+    }
+
+    // Judged against the window before this sample joins it
+    bool hitch = series->count > 0 && milliseconds >= hitchMinimumMs_ &&
+                 milliseconds > hitchFactor_ * GetQuantile(*series, 0.5f);
+
+    Sample& slot = series->samples[series->head];
+    if (series->count == WINDOW_SIZE) {
+        series->sum -= slot.milliseconds;
+        series->buckets[slot.bucket]--;
+        if (slot.hitch) series->hitches--;
+    } else {
+        series->count++;
+    }
+    slot.frame = frameNumber_;
+    slot.milliseconds = milliseconds;
+    slot.bucket = GetBucket(milliseconds);
+    slot.hitch = hitch;
+    series->sum += milliseconds;
+    series->buckets[slot.bucket]++;
+    if (hitch) {
+        series->hitches++;
+        series->totalHitches++;
+    }
+    series->head = (series->head + 1) % WINDOW_SIZE;
+}
+
+bool FrameMetrics::GetSummary(const std::string& name, MetricSummary& summary) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Series* series = FindSeries(name);
+    if (!series) return false;
+    Summarize(*series, summary);
+    return true;
+}
+
+std::vector<std::string> FrameMetrics::GetSeriesNames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    names.reserve(series_.size());
+    for (const auto& series : series_) {
+        names.push_back(series->name);
+    }
+    return names;
+}
+
+float FrameMetrics::GetAverageFrameTimeMs(size_t frames) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Series* series = FindSeries("Frame");
+    if (!series || series->count == 0) return 0.0f;
+    frames = std::min(std::max<size_t>(frames, 1), series->count);
+    double sum = 0.0;
+    for (size_t i = 1; i <= frames; ++i) {
+        sum += series->samples[(series->head + WINDOW_SIZE - i) % WINDOW_SIZE].milliseconds;
+    }
+    return static_cast<float>(sum / frames);
+}
+
+void FrameMetrics::SetHitchThreshold(float factor, float minimumMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hitchFactor_ = std::max(factor, 1.0f);
+    hitchMinimumMs_ = std::max(minimumMs, 0.0f);
+}
+
+void FrameMetrics::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series_.clear();
+}
+
+bool FrameMetrics::ExportCSV(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+        Logger::Error("Failed to write frame metrics: " + filename);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    file << "series,frame,ms\n";
+    for (const auto& series : series_) {
+        size_t first = (series->head + WINDOW_SIZE - series->count) % WINDOW_SIZE;
+        for (size_t i = 0; i < series->count; ++i) {
+            const Sample& sample = series->samples[(first + i) % WINDOW_SIZE];
+            file << series->name << ',' << sample.frame << ',' << sample.milliseconds << '\n';
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+bool FrameMetrics::ExportJSON(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+        Logger::Error("Failed to write frame metrics: " + filename);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    file << "{\"frame\":" << frameNumber_ << ",\"series\":[";
+    for (size_t s = 0; s < series_.size(); ++s) {
+        const Series& series = *series_[s];
+        MetricSummary summary;
+        Summarize(series, summary);
+
+        file << (s > 0 ? ",\n" : "\n") << "{\"name\":";
+        WriteJsonString(file, series.name);
+        file << ",\"last\":" << summary.last << ",\"mean\":" << summary.mean
+             << ",\"p50\":" << summary.p50 << ",\"p95\":" << summary.p95 << ",\"p99\":" << summary.p99
+             << ",\"max\":" << summary.max << ",\"hitches\":" << summary.hitches
+             << ",\"totalHitches\":" << summary.totalHitches << ",\"samples\":[";
+        size_t first = (series.head + WINDOW_SIZE - series.count) % WINDOW_SIZE;
+        for (size_t i = 0; i < series.count; ++i) {
+            if (i > 0) file << ',';
+            file << series.samples[(first + i) % WINDOW_SIZE].milliseconds;
+        }
+        file << "]}";
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+FrameMetrics::Series* FrameMetrics::FindSeries(const std::string& name) const {
+    for (const auto& series : series_) {
+        if (series->name == name) return series.get();
+    }
+    return nullptr;
+}
+
+uint16_t FrameMetrics::GetBucket(float milliseconds) {
+    if (milliseconds <= MIN_VALUE_MS) return 0;
+    static const float logGrowth = std::log(GROWTH);
+    float index = std::log(milliseconds / MIN_VALUE_MS) / logGrowth;
+    return static_cast<uint16_t>(std::min(index, static_cast<float>(BUCKET_COUNT - 1)));
+}
+
+float FrameMetrics::GetBucketValue(uint16_t bucket) {
+    // Geometric middle of the bucket
+    return MIN_VALUE_MS * std::pow(GROWTH, bucket + 0.5f);
+}
+
+float FrameMetrics::GetQuantile(const Series& series, float quantile) {
+    if (series.count == 0) return 0.0f;
+    uint32_t rank = static_cast<uint32_t>(std::ceil(quantile * series.count));
+    rank = std::max<uint32_t>(rank, 1);
+    uint32_t seen = 0;
+    for (uint16_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += series.buckets[bucket];
+        if (seen >= rank) return GetBucketValue(bucket);
+    }
+    return GetBucketValue(BUCKET_COUNT - 1);
+}
+
+void FrameMetrics::Summarize(const Series& series, MetricSummary& summary) {
+    summary = MetricSummary();
+    summary.samples = static_cast<uint32_t>(series.count);
+    summary.hitches = series.hitches;
+    summary.totalHitches = series.totalHitches;
+    if (series.count == 0) return;
+
+    summary.last = series.samples[(series.head + WINDOW_SIZE - 1) % WINDOW_SIZE].milliseconds;
+    summary.mean = static_cast<float>(series.sum / series.count);
+    summary.p50 = GetQuantile(series, 0.5f);
+    summary.p95 = GetQuantile(series, 0.95f);
+    summary.p99 = GetQuantile(series, 0.99f);
+    size_t first = (series.head + WINDOW_SIZE - series.count) % WINDOW_SIZE;
+    for (size_t i = 0; i < series.count; ++i) {
+        summary.max = std::max(summary.max, series.samples[(first + i) % WINDOW_SIZE].milliseconds);
+    }
+    // Bucket midpoints can overshoot the largest sample
+    summary.p50 = std::min(summary.p50, summary.max);
+    summary.p95 = std::min(summary.p95, summary.max);
+    summary.p99 = std::min(summary.p99, summary.max);
+}
+
+} // namespace Nexus
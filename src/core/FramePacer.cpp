@@ -0,0 +1,206 @@
+#include "FramePacer.h"
+#include "Logger.h"
+#include <mmsystem.h>
+#include <algorithm>
+#include <cmath>
+
+#pragma comment(lib, "winmm.lib")
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace Nexus {
+
+namespace {
+constexpr size_t STATS_WINDOW_SIZE = 120;
+}
+
+FramePacer::FramePacer()
+    : waitableTimer_(nullptr)
+    , latencyWaitable_(nullptr)
+    , highResolutionTimer_(false)
+    , timerPeriodRaised_(false)
+    , frequency_(1)
+    , nextDeadline_(0)
+    , lastFrameStart_(0)
+    , targetFPS_(0.0f)
+    , spinThreshold_(0.002f)
+    , frameTimeIndex_(0)
+    , overshootAccumulator_(0.0)
+    , initialized_(false)
+{
+}
+
+FramePacer::~FramePacer() {
+    Shutdown();
+}
+
+bool FramePacer::Initialize(float targetFPS) {
+    if (initialized_) return true;
+
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    frequency_ = freq.QuadPart;
+
+    // High resolution timers (Windows 10 1803+) wake within ~0.5 ms without touching the global timer period
+    waitableTimer_ = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (waitableTimer_) {
+        highResolutionTimer_ = true;
+        spinThreshold_ = 0.001f;
+    } else {
+        waitableTimer_ = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        if (timeBeginPeriod(1) == TIMERR_NOERROR) {
+            timerPeriodRaised_ = true;
+        }
+        spinThreshold_ = 0.002f;
+    }
+
+    if (!waitableTimer_) {
+        Logger::Warning("Frame pacer could not create a waitable timer - falling back to spin waiting");
+    }
+
+    frameTimes_.assign(STATS_WINDOW_SIZE, 0.0f);
+    frameTimeIndex_ = 0;
+    SetTargetFPS(targetFPS);
+
+    initialized_ = true;
+    Logger::Info(std::string("Frame pacer initialized (") +
+                 (highResolutionTimer_ ? "high resolution timer" : "legacy timer") + ")");
+    return true;
+}
+
+void FramePacer::Shutdown() {
+    if (!initialized_) return;
+
+    if (waitableTimer_) {
+        CloseHandle(waitableTimer_);
+        waitableTimer_ = nullptr;
+    }
+    if (timerPeriodRaised_) {
+        timeEndPeriod(1);
+        timerPeriodRaised_ = false;
+    }
+
+    latencyWaitable_ = nullptr; // Owned by the swap chain
+    initialized_ = false;
+}
+
+void FramePacer::SetTargetFPS(float fps) {
+    targetFPS_ = fps > 0.0f ? fps : 0.0f;
+    stats_.targetFrameTime = targetFPS_ > 0.0f ? 1.0f / targetFPS_ : 0.0f;
+    nextDeadline_ = 0;
+}
+
+long long FramePacer::GetCounter() const {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+void FramePacer::WaitForFrameLatency() {
+    if (latencyWaitable_) {
+        // The swap chain signals when it can accept another frame; bounded wait in case the device is lost
+        WaitForSingleObjectEx(latencyWaitable_, 1000, TRUE);
+    }
+}
+
+void FramePacer::WaitForNextFrame() {
+    long long now = GetCounter();
+    if (lastFrameStart_ == 0) {
+        lastFrameStart_ = now;
+    }
+
+    long long wakeTime = now;
+    long long deadline = now;
+
+    if (targetFPS_ > 0.0f) {
+        long long period = SecondsToCounts(1.0 / targetFPS_);
+        if (nextDeadline_ == 0) {
+            nextDeadline_ = lastFrameStart_ + period;
+        }
+
+        deadline = nextDeadline_;
+        if (now < deadline) {
+            SleepUntil(deadline);
+            wakeTime = GetCounter();
+        } else {
+            ++stats_.missedFrames;
+        }
+
+        // Advance the absolute deadline; resynchronise if we fell more than a frame behind
+        nextDeadline_ += period;
+        if (wakeTime > nextDeadline_) {
+            nextDeadline_ = wakeTime + period;
+        }
+    }
+
+    RecordFrame(lastFrameStart_, deadline, wakeTime);
+    lastFrameStart_ = wakeTime;
+}
+
+void FramePacer::SleepUntil(long long deadline) {
+    long long spinCounts = SecondsToCounts(spinThreshold_);
+    long long now = GetCounter();
+
+    // Coarse sleep on the waitable timer, leaving the tail for the spin loop
+    if (waitableTimer_ && deadline - now > spinCounts) {
+        double sleepSeconds = CountsToSeconds(deadline - now - spinCounts);
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -static_cast<LONGLONG>(sleepSeconds * 10000000.0); // relative, 100 ns units
+        if (dueTime.QuadPart < 0 && SetWaitableTimerEx(waitableTimer_, &dueTime, 0, nullptr, nullptr, nullptr, 0)) {
+            WaitForSingleObject(waitableTimer_, INFINITE);
+        }
+    }
+
+    // Spin-wait the remaining tail
+    while (GetCounter() < deadline) {
+        YieldProcessor();
+    }
+}
+
+void FramePacer::RecordFrame(long long frameStart, long long deadline, long long wakeTime) {
+    float frameTime = static_cast<float>(CountsToSeconds(wakeTime - frameStart));
+
+    stats_.lastFrameTime = frameTime;
+    ++stats_.frameCount;
+
+    frameTimes_[frameTimeIndex_] = frameTime;
+    frameTimeIndex_ = (frameTimeIndex_ + 1) % frameTimes_.size();
+
+    if (wakeTime > deadline) {
+        overshootAccumulator_ += CountsToSeconds(wakeTime - deadline);
+    }
+
+    size_t sampleCount = static_cast<size_t>(std::min<unsigned long long>(stats_.frameCount, frameTimes_.size()));
+    double sum = 0.0;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        sum += frameTimes_[i];
+    }
+    double mean = sum / sampleCount;
+
+    double variance = 0.0;
+    float maxDeviation = 0.0f;
+    float reference = stats_.targetFrameTime > 0.0f ? stats_.targetFrameTime : static_cast<float>(mean);
+    for (size_t i = 0; i < sampleCount; ++i) {
+        double diff = frameTimes_[i] - mean;
+        variance += diff * diff;
+        maxDeviation = std::max(maxDeviation, std::abs(frameTimes_[i] - reference));
+    }
+
+    stats_.averageFrameTime = static_cast<float>(mean);
+    stats_.jitter = static_cast<float>(std::sqrt(variance / sampleCount));
+    stats_.maxDeviation = maxDeviation;
+    stats_.averageOvershoot = static_cast<float>(overshootAccumulator_ / stats_.frameCount);
+}
+
+void FramePacer::ResetStats() {
+    float target = stats_.targetFrameTime;
+    stats_ = Stats();
+    stats_.targetFrameTime = target;
+    std::fill(frameTimes_.begin(), frameTimes_.end(), 0.0f);
+    frameTimeIndex_ = 0;
+    overshootAccumulator_ = 0.0;
+}
+
+} // namespace Nexus
@@ -0,0 +1,116 @@
+#include "InitGraph.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <chrono>
+#include <sstream>
+
+namespace Nexus {
+
+InitGraph::StepID InitGraph::AddStep(const std::string& name, StepFunction function,
+                                     const std::vector<StepID>& dependencies,
+                                     const std::string& failureMessage, Failure failure) {
+    StepID id = steps_.size();
+
+    Step step;
+    step.name = name;
+    step.function = std::move(function);
+    step.failureMessage = failureMessage;
+    step.failure = failure;
+    for (StepID dependency : dependencies) {
+        if (dependency >= id || steps_[dependency].mainThread) {
+            Logger::Error("InitGraph: step '" + name + "' depends on a step declared after it or on the main thread");
+            continue;
+        }
+        step.dependencies.push_back(dependency);
+    }
+    steps_.push_back(std::move(step));
+    return id;
+}
+
+void InitGraph::AddMainThreadStep(const std::string& name, StepFunction function,
+                                  const std::string& failureMessage, Failure failure) {
+    Step step;
+    step.name = name;
+    step.function = std::move(function);
+    step.failureMessage = failureMessage;
+    step.failure = failure;
+    step.mainThread = true;
+    steps_.push_back(std::move(step));
+}
+
+bool InitGraph::Run(JobSystem& jobs) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Worker steps as a task graph; task IDs follow step order minus the main-thread steps
+    TaskGraph graph;
+    std::vector<TaskGraph::TaskID> tasks(steps_.size());
+    for (StepID id = 0; id < steps_.size(); ++id) {
+        Step& step = steps_[id];
+        if (step.mainThread) continue;
+
+        std::vector<TaskGraph::TaskID> dependencies;
+        for (StepID dependency : step.dependencies) {
+            dependencies.push_back(tasks[dependency]);
+        }
+        tasks[id] = graph.AddTask(step.name, [this, &step]() { RunStep(step); }, dependencies);
+    }
+
+    // The graph runs from a job so this thread is free for its own steps meanwhile
+    JobCounter counter;
+    jobs.Execute([&graph, &jobs]() { graph.Execute(jobs); }, &counter);
+    for (Step& step : steps_) {
+        if (step.mainThread) {
+            RunStep(step);
+        }
+    }
+    jobs.Wait(counter);
+
+    float totalMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::ostringstream timings;
+    timings << "Subsystems initialized in " << static_cast<int>(totalMs) << " ms:";
+    for (const Step& step : steps_) {
+        timings << ' ' << step.name << ' ' << static_cast<int>(step.milliseconds) << " ms";
+        if (&step != &steps_.back()) timings << ',';
+    }
+    Logger::Info(timings.str());
+
+    // Reported as the sequential startup would have met them
+    for (const Step& step : steps_) {
+        if (step.exception) {
+            std::rethrow_exception(step.exception);
+        }
+        if (step.state != State::Failed) continue;
+
+        if (step.failure == Failure::Fatal) {
+            Logger::Error(step.failureMessage);
+            return false;
+        }
+        Logger::Warning(step.failureMessage);
+    }
+    return true;
+}
+
+void InitGraph::RunStep(Step& step) {
+    // Dependencies have finished: the task graph only releases a step after them
+    for (StepID dependency : step.dependencies) {
+        const Step& required = steps_[dependency];
+        if (required.state == State::Skipped ||
+            (required.state == State::Failed && required.failure == Failure::Fatal)) {
+            step.state = State::Skipped;
+            return;
+        }
+    }
+
+    NEXUS_PROFILE_SCOPE(Profiler::InternName("Init::" + step.name));
+    auto start = std::chrono::steady_clock::now();
+    try {
+        step.state = step.function && !step.function() ? State::Failed : State::Succeeded;
+    } catch (...) {
+        step.exception = std::current_exception();
+        step.state = State::Failed;
+    }
+    step.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace Nexus
@@ -0,0 +1,540 @@
+#include "JobSystem.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+
+namespace Nexus {
+
+namespace {
+thread_local int t_workerIndex = -1;
+
+// Fiber backend. Jobs can resume on another thread after a Wait(), so these are read afresh after
+// every switch (NexusCore builds with /GT so MSVC doesn't cache their addresses across one)
+thread_local void* t_threadFiber = nullptr;   // The worker thread's own, converted fiber
+thread_local int t_currentFiber = -1;         // Pool fiber running on this thread
+thread_local int t_handoffFiber = -1;         // Fiber just switched away from, parked or freed by the next
+thread_local bool t_handoffParks = false;
+}
+
+JobSystem::JobSystem()
+    : hybrid_(false)
+    , queuedJobs_(0)
+    , counterCompletions_(0)
+    , running_(false)
+    , initialized_(false)
+    , backend_(JobBackend::Threads)
+    , parkedFiberCount_(0)
+{
+}
+
+JobSystem::~JobSystem() {
+    Shutdown();
+}
+
+bool JobSystem::Initialize(unsigned int workerCount, JobBackend backend) {
+    if (initialized_) return true;
+
+    if (workerCount == 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    Logger::Info("Initializing job system with " + std::to_string(workerCount) + " worker threads" +
+                 (backend == JobBackend::Fibers ? " on fibers..." : "..."));
+
+    queues_.clear();
+    for (unsigned int i = 0; i < workerCount + 1; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    efficiencyWorker_.assign(workerCount, 0);
+
+    backend_ = workerCount > 0 ? backend : JobBackend::Threads;
+    if (backend_ == JobBackend::Fibers &&
+        !CreateFibers(std::max(MIN_FIBER_POOL_SIZE, static_cast<size_t>(workerCount) * FIBERS_PER_WORKER))) {
+        Logger::Warning("Failed to create the job fiber pool, running jobs on threads");
+        backend_ = JobBackend::Threads;
+    }
+
+    AssignProcessors(workerCount);
+
+    running_ = true;
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+
+    initialized_ = true;
+    Logger::Info("Job system initialized");
+    return true;
+}
+
+void JobSystem::Shutdown() {
+    if (!initialized_) return;
+
+    Logger::Info("Shutting down job system...");
+
+    // Drain whatever is left so no counter is left dangling
+    size_t externalQueue = queues_.size() - 1;
+    while (TryRunOne(externalQueue)) {
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        running_ = false;
+    }
+    wakeCondition_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    workers_.clear();
+    queues_.clear();
+    DestroyFibers();
+    efficiencyWorker_.clear();
+    idealProcessor_.clear();
+    hybrid_ = false;
+    backend_ = JobBackend::Threads;
+    queuedJobs_ = 0;
+    initialized_ = false;
+    Logger::Info("Job system shut down");
+}
+
+int JobSystem::GetCurrentWorkerIndex() {
+    return t_workerIndex;
+}
+
+unsigned int JobSystem::GetEfficiencyWorkerCount() const {
+    return static_cast<unsigned int>(std::count(efficiencyWorker_.begin(), efficiencyWorker_.end(), 1));
+}
+
+void JobSystem::AssignProcessors(unsigned int workerCount) {
+    idealProcessor_.assign(workerCount, NO_IDEAL_PROCESSOR);
+
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+    std::vector<uint8_t> buffer(length);
+    if (length == 0 || !GetLogicalProcessorInformationEx(
+            RelationProcessorCore, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length)) {
+        return;
+    }
+
+    // Every logical processor with its core's efficiency class; higher classes are faster
+    struct Processor {
+        PROCESSOR_NUMBER number;
+        BYTE efficiencyClass;
+    };
+    std::vector<Processor> processors;
+    for (DWORD offset = 0; offset < length;) {
+        auto* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+        for (WORD group = 0; group < info->Processor.GroupCount; ++group) {
+            const GROUP_AFFINITY& affinity = info->Processor.GroupMask[group];
+            for (BYTE bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit) {
+                if (affinity.Mask & (static_cast<KAFFINITY>(1) << bit)) {
+                    Processor processor = {};
+                    processor.number.Group = affinity.Group;
+                    processor.number.Number = bit;
+                    processor.efficiencyClass = info->Processor.EfficiencyClass;
+                    processors.push_back(processor);
+                }
+            }
+        }
+        offset += info->Size;
+    }
+    if (processors.empty()) return;
+
+    std::stable_sort(processors.begin(), processors.end(), [](const Processor& a, const Processor& b) {
+        return a.efficiencyClass > b.efficiencyClass;
+    });
+    const BYTE fastest = processors.front().efficiencyClass;
+    hybrid_ = fastest != processors.back().efficiencyClass;
+
+    // Fastest cores first, skipping the first one, which is left to the main thread
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        const Processor& processor = processors[(i + 1) % processors.size()];
+        idealProcessor_[i] = (static_cast<uint32_t>(processor.number.Group) << 8) | processor.number.Number;
+        efficiencyWorker_[i] = hybrid_ && processor.efficiencyClass != fastest ? 1 : 0;
+    }
+    if (hybrid_) {
+        Logger::Info("Hybrid CPU: " + std::to_string(GetEfficiencyWorkerCount()) + " of " +
+                     std::to_string(workerCount) + " job workers on efficiency cores");
+    }
+}
+
+size_t JobSystem::GetQueueIndexForCurrentThread() const {
+    if (t_workerIndex >= 0 && static_cast<size_t>(t_workerIndex) < workers_.size()) {
+        return static_cast<size_t>(t_workerIndex);
+    }
+    return queues_.size() - 1;
+}
+
+void JobSystem::Execute(JobFunction job, JobCounter* counter, JobAffinity affinity) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Without workers everything runs inline on the calling thread
+    if (!initialized_ || workers_.empty()) {
+        Job inlineJob{std::move(job), counter, MemoryTracker::GetCurrentTag()};
+        RunJob(inlineJob);
+        return;
+    }
+
+    WorkQueue& queue = hybrid_ && affinity == JobAffinity::Performance ? performanceQueue_
+                     : hybrid_ && affinity == JobAffinity::Efficiency ? efficiencyQueue_
+                     : *queues_[GetQueueIndexForCurrentThread()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(Job{std::move(job), counter, MemoryTracker::GetCurrentTag()});
+    }
+    queuedJobs_.fetch_add(1, std::memory_order_release);
+    wakeCondition_.notify_one();
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& function) {
+    if (count == 0) return;
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    if (workers_.empty() || count <= grainSize) {
+        function(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    for (size_t begin = 0; begin < count; begin += grainSize) {
+        size_t end = std::min(begin + grainSize, count);
+        Execute([&function, begin, end]() { function(begin, end); }, &counter);
+    }
+    Wait(counter);
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    if (!initialized_ || workers_.empty()) return;
+
+    // A job on a fiber parks it and lets the worker carry on with another one
+    if (t_currentFiber >= 0 && !counter.IsDone()) {
+        int fiber = TakeFreeFiber();
+        if (fiber >= 0) {
+            fibers_[t_currentFiber].waitingOn = &counter;
+            SwitchFiber(fiber, true);
+            return;
+        }
+        // Pool exhausted; help out on this fiber instead
+    }
+
+    size_t queueIndex = GetQueueIndexForCurrentThread();
+    while (!counter.IsDone()) {
+        if (!TryRunOne(queueIndex)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::WorkerLoop(unsigned int index) {
+    t_workerIndex = static_cast<int>(index);
+    Profiler::SetThreadName("Job Worker " + std::to_string(index));
+    if (idealProcessor_[index] != NO_IDEAL_PROCESSOR) {
+        PROCESSOR_NUMBER processor = {};
+        processor.Group = static_cast<WORD>(idealProcessor_[index] >> 8);
+        processor.Number = static_cast<BYTE>(idealProcessor_[index]);
+        SetThreadIdealProcessorEx(GetCurrentThread(), &processor, nullptr);
+    }
+
+    if (backend_ == JobBackend::Fibers) {
+        t_threadFiber = ConvertThreadToFiber(nullptr);
+        int fiber = t_threadFiber ? TakeFreeFiber() : -1;
+        if (fiber >= 0) {
+            t_currentFiber = fiber;
+            SwitchToFiber(fibers_[fiber].handle);
+            // Back once running_ is cleared
+            CompleteFiberSwitch();
+            ConvertFiberToThread();
+            t_threadFiber = nullptr;
+            t_workerIndex = -1;
+            return;
+        }
+        if (t_threadFiber) {
+            ConvertFiberToThread();
+            t_threadFiber = nullptr;
+        }
+        Logger::Warning("Job worker " + std::to_string(index) + " couldn't start on a fiber, running on its thread");
+    }
+
+    while (running_.load(std::memory_order_acquire)) {
+        if (TryRunOne(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCondition_.wait_for(lock, std::chrono::milliseconds(2), [this]() {
+            return !running_.load(std::memory_order_acquire) || queuedJobs_.load(std::memory_order_acquire) > 0;
+        });
+    }
+
+    t_workerIndex = -1;
+}
+
+bool JobSystem::TryRunOne(size_t queueIndex) {
+    Job job;
+    bool found;
+    if (!hybrid_) {
+        found = PopLocal(queueIndex, job) || Steal(queueIndex, job);
+    } else if (queueIndex < efficiencyWorker_.size() && efficiencyWorker_[queueIndex]) {
+        found = PopLocal(queueIndex, job) || PopShared(efficiencyQueue_, job) || Steal(queueIndex, job);
+    } else {
+        found = PopLocal(queueIndex, job) || PopShared(performanceQueue_, job) || Steal(queueIndex, job) ||
+                PopShared(efficiencyQueue_, job);
+    }
+    if (found) {
+        queuedJobs_.fetch_sub(1, std::memory_order_acq_rel);
+        RunJob(job);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::PopLocal(size_t queueIndex, Job& job) {
+    WorkQueue& queue = *queues_[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+bool JobSystem::PopShared(WorkQueue& queue, Job& job) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+
+    job = std::move(queue.jobs.front());
+    queue.jobs.pop_front();
+    return true;
+}
+
+bool JobSystem::Steal(size_t thiefIndex, Job& job) {
+    const size_t queueCount = queues_.size();
+    for (size_t offset = 1; offset < queueCount; ++offset) {
+        WorkQueue& victim = *queues_[(thiefIndex + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.jobs.empty()) continue;
+
+        job = std::move(victim.jobs.front());
+        victim.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::RunJob(Job& job) {
+    if (job.function) {
+        NEXUS_MEMORY_SCOPE(job.memoryTag);
+        job.function();
+    }
+    if (job.counter) {
+        // The counter may be gone once it reads zero, so only parked fibers are told about it
+        if (job.counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+            parkedFiberCount_.load(std::memory_order_acquire) > 0) {
+            counterCompletions_.fetch_add(1, std::memory_order_release);
+            wakeCondition_.notify_all();
+        }
+    }
+}
+
+bool JobSystem::CreateFibers(size_t count) {
+    fibers_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        fibers_[i].handle = CreateFiberEx(FIBER_STACK_COMMIT, FIBER_STACK_RESERVE, 0, &JobSystem::FiberEntry, this);
+        if (!fibers_[i].handle) {
+            DestroyFibers();
+            return false;
+        }
+    }
+    // Handed out from the back, lowest first
+    freeFibers_.clear();
+    for (size_t i = count; i-- > 0;) {
+        freeFibers_.push_back(static_cast<int>(i));
+    }
+    return true;
+}
+
+void JobSystem::DestroyFibers() {
+    for (Fiber& fiber : fibers_) {
+        if (fiber.handle) {
+            DeleteFiber(fiber.handle);
+        }
+    }
+    if (!parkedFibers_.empty()) {
+        Logger::Warning("Job system shut down with " + std::to_string(parkedFibers_.size()) + " jobs still waiting");
+    }
+    fibers_.clear();
+    freeFibers_.clear();
+    parkedFibers_.clear();
+    parkedFiberCount_ = 0;
+}
+
+void __stdcall JobSystem::FiberEntry(void* parameter) {
+    static_cast<JobSystem*>(parameter)->FiberLoop();
+}
+
+void JobSystem::FiberLoop() {
+    CompleteFiberSwitch();
+    for (;;) {
+        if (!running_.load(std::memory_order_acquire)) {
+            // Hand the worker thread back so it can exit; this fiber goes back to the pool
+            t_handoffFiber = t_currentFiber;
+            t_handoffParks = false;
+            t_currentFiber = -1;
+            SwitchToFiber(t_threadFiber);
+            CompleteFiberSwitch();
+            continue;
+        }
+
+        const uint32_t completions = counterCompletions_.load(std::memory_order_acquire);
+        int ready = TakeReadyFiber();
+        if (ready >= 0) {
+            SwitchFiber(ready, false);
+            continue;
+        }
+        if (TryRunOne(GetQueueIndexForCurrentThread())) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCondition_.wait_for(lock, std::chrono::milliseconds(2), [this, completions]() {
+            return !running_.load(std::memory_order_acquire) || queuedJobs_.load(std::memory_order_acquire) > 0 ||
+                   counterCompletions_.load(std::memory_order_acquire) != completions;
+        });
+    }
+}
+
+void JobSystem::SwitchFiber(int target, bool parkCurrent) {
+    t_handoffFiber = t_currentFiber;
+    t_handoffParks = parkCurrent;
+    t_currentFiber = target;
+    SwitchToFiber(fibers_[target].handle);
+    // Resumed, possibly on another worker
+    CompleteFiberSwitch();
+}
+
+void JobSystem::CompleteFiberSwitch() {
+    // Only now is nothing running on the fiber switched away from, so only now may another worker
+    // pick it up
+    if (t_handoffFiber < 0) return;
+    const int fiber = t_handoffFiber;
+    t_handoffFiber = -1;
+
+    std::lock_guard<std::mutex> lock(fiberMutex_);
+    if (t_handoffParks) {
+        parkedFibers_.push_back(fiber);
+        parkedFiberCount_.fetch_add(1, std::memory_order_release);
+    } else {
+        freeFibers_.push_back(fiber);
+    }
+}
+
+int JobSystem::TakeFreeFiber() {
+    std::lock_guard<std::mutex> lock(fiberMutex_);
+    if (freeFibers_.empty()) return -1;
+    int fiber = freeFibers_.back();
+    freeFibers_.pop_back();
+    return fiber;
+}
+
+int JobSystem::TakeReadyFiber() {
+    if (parkedFiberCount_.load(std::memory_order_acquire) == 0) return -1;
+
+    std::lock_guard<std::mutex> lock(fiberMutex_);
+    for (size_t i = 0; i < parkedFibers_.size(); ++i) {
+        const int fiber = parkedFibers_[i];
+        if (!fibers_[fiber].waitingOn->IsDone()) continue;
+
+        fibers_[fiber].waitingOn = nullptr;
+        parkedFibers_[i] = parkedFibers_.back();
+        parkedFibers_.pop_back();
+        parkedFiberCount_.fetch_sub(1, std::memory_order_release);
+        return fiber;
+    }
+    return -1;
+}
+
+// TaskGraph implementation
+TaskGraph::TaskID TaskGraph::AddTask(const std::string& name, TaskFunction function,
+                                     const std::vector<TaskID>& dependencies) {
+    TaskID id = tasks_.size();
+
+    Task task;
+    task.name = name;
+    task.function = std::move(function);
+    tasks_.push_back(std::move(task));
+
+    // Only linked dependencies are counted; a skipped one would never release the task
+    for (TaskID dependency : dependencies) {
+        if (dependency >= id) {
+            Logger::Error("TaskGraph: task '" + name + "' depends on a task that is declared after it");
+            continue;
+        }
+        tasks_[dependency].dependents.push_back(id);
+        tasks_[id].dependencyCount++;
+    }
+
+    return id;
+}
+
+void TaskGraph::Clear() {
+    tasks_.clear();
+    remaining_.reset();
+    remainingSize_ = 0;
+}
+
+void TaskGraph::Execute(JobSystem& jobs) {
+    if (tasks_.empty()) return;
+
+    if (remainingSize_ != tasks_.size()) {
+        remaining_ = std::make_unique<std::atomic<int>[]>(tasks_.size());
+        remainingSize_ = tasks_.size();
+    }
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+        remaining_[i].store(tasks_[i].dependencyCount, std::memory_order_relaxed);
+    }
+    firstException_ = nullptr;
+
+    JobCounter counter;
+    for (TaskID id = 0; id < tasks_.size(); ++id) {
+        if (tasks_[id].dependencyCount == 0) {
+            Schedule(jobs, id, counter);
+        }
+    }
+    jobs.Wait(counter);
+
+    if (firstException_) {
+        std::rethrow_exception(firstException_);
+    }
+}
+
+void TaskGraph::Schedule(JobSystem& jobs, TaskID id, JobCounter& counter) {
+    jobs.Execute([this, &jobs, &counter, id]() {
+        try {
+            if (tasks_[id].function) {
+                tasks_[id].function();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(exceptionMutex_);
+            if (!firstException_) {
+                firstException_ = std::current_exception();
+            }
+        }
+
+        // Dependents are released even on failure so the frame can finish and report the error
+        for (TaskID dependent : tasks_[id].dependents) {
+            if (remaining_[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                Schedule(jobs, dependent, counter);
+            }
+        }
+    }, &counter);
+}
+
+} // namespace Nexus
@@ -0,0 +1,361 @@
+#include "MemoryTracker.h"
+#include "EngineConfig.h"
+#include "Logger.h"
+#include "Platform.h"
+#include <dbghelp.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+#pragma comment(lib, "dbghelp.lib")
+
+namespace Nexus {
+
+namespace {
+constexpr size_t HEADER_SIZE = 16;
+constexpr size_t DEFAULT_ALIGNMENT = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+constexpr uint64_t SIZE_MASK = (1ull << 48) - 1;
+constexpr int TAG_SHIFT = 48;
+constexpr uint64_t SAMPLED_BIT = 1ull << 56;
+constexpr size_t MAX_CALLSTACK_DEPTH = 32;
+constexpr DWORD SKIPPED_FRAMES = 2;          // RecordSample and TrackedAllocate; inlining may leave more
+
+const char* const TAG_NAMES[MemoryTracker::TAG_COUNT] = {
+    "Untagged", "Physics", "AI", "Animation", "Particles", "Audio", "Scripting", "Resources"
+};
+
+// Directly before every block operator new hands out
+struct AllocationHeader {
+    void* raw;                               // What malloc returned
+    uint64_t info;                           // Size, tag and the sampled flag
+};
+static_assert(sizeof(AllocationHeader) <= HEADER_SIZE, "allocation header outgrew its slot");
+
+// Own cache line per tag, so subsystems allocating on different threads do not contend
+struct alignas(64) TagCounters {
+    std::atomic<uint64_t> currentBytes{0};
+    std::atomic<uint64_t> peakBytes{0};
+    std::atomic<uint64_t> liveAllocations{0};
+    std::atomic<uint64_t> totalAllocations{0};
+};
+
+struct LiveSample {
+    MemoryTag tag;
+    uint16_t depth;
+    uint64_t bytes;
+    void* frames[MAX_CALLSTACK_DEPTH];
+};
+
+// Constant-initialized: allocations during static initialization are counted too
+TagCounters g_counters[MemoryTracker::TAG_COUNT];
+std::atomic<uint64_t> g_samplingInterval{0};
+
+// Leaked on purpose, blocks are still freed after static destruction
+std::mutex g_sampleMutex;
+std::unordered_map<void*, LiveSample>* g_samples = nullptr;
+
+std::mutex g_gpuMutex;
+GpuMemoryStats g_gpuStats;
+
+thread_local MemoryTag t_tag = MemoryTag::Untagged;
+thread_local bool t_inTracker = false;       // Set while the tracker allocates for itself
+thread_local int64_t t_bytesUntilSample = 0;
+
+#ifdef NEXUS_MEMORY_TRACKING_ENABLED
+bool ShouldSample(size_t size) {
+    uint64_t interval = g_samplingInterval.load(std::memory_order_relaxed);
+    if (interval == 0 || t_inTracker) return false;
+    t_bytesUntilSample -= static_cast<int64_t>(size);
+    if (t_bytesUntilSample > 0) return false;
+    t_bytesUntilSample = static_cast<int64_t>(interval);
+    return true;
+}
+
+void RecordSample(void* block, MemoryTag tag, size_t size) {
+    LiveSample sample;
+    sample.tag = tag;
+    sample.bytes = size;
+    sample.depth = CaptureStackBackTrace(SKIPPED_FRAMES, MAX_CALLSTACK_DEPTH, sample.frames, nullptr);
+
+    t_inTracker = true;
+    {
+        std::lock_guard<std::mutex> lock(g_sampleMutex);
+        if (!g_samples) g_samples = new std::unordered_map<void*, LiveSample>();
+        g_samples->emplace(block, sample);
+    }
+    t_inTracker = false;
+}
+
+void* TrackedAllocate(size_t size, size_t alignment) {
+    if (size > SIZE_MASK) return nullptr;
+    alignment = std::max(alignment, DEFAULT_ALIGNMENT);
+    // malloc already returns default-aligned memory, so only over-aligned blocks need slack
+    size_t padding = alignment > DEFAULT_ALIGNMENT ? alignment : 0;
+    void* raw = std::malloc(size + HEADER_SIZE + padding);
+    if (!raw) return nullptr;
+
+    uintptr_t address = (reinterpret_cast<uintptr_t>(raw) + HEADER_SIZE + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    void* block = reinterpret_cast<void*>(address);
+    MemoryTag tag = t_tag;
+    bool sampled = ShouldSample(size);
+
+    auto* header = reinterpret_cast<AllocationHeader*>(address - HEADER_SIZE);
+    header->raw = raw;
+    header->info = size | (static_cast<uint64_t>(tag) << TAG_SHIFT) | (sampled ? SAMPLED_BIT : 0);
+
+    TagCounters& counters = g_counters[static_cast<size_t>(tag)];
+    uint64_t current = counters.currentBytes.fetch_add(size + HEADER_SIZE, std::memory_order_relaxed) + size + HEADER_SIZE;
+    uint64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+    while (current > peak && !counters.peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+    counters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+    counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (sampled) RecordSample(block, tag, size);
+    return block;
+}
+
+void* TrackedAllocateOrThrow(size_t size, size_t alignment) {
+    for (;;) {
+        if (void* block = TrackedAllocate(size, alignment)) return block;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* TrackedAllocateNoThrow(size_t size, size_t alignment) noexcept {
+    try {
+        return TrackedAllocateOrThrow(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void TrackedFree(void* block) noexcept {
+    if (!block) return;
+    auto* header = reinterpret_cast<AllocationHeader*>(static_cast<uint8_t*>(block) - HEADER_SIZE);
+    uint64_t info = header->info;
+    uint64_t size = info & SIZE_MASK;
+
+    TagCounters& counters = g_counters[(info >> TAG_SHIFT) & 0xFF];
+    counters.currentBytes.fetch_sub(size + HEADER_SIZE, std::memory_order_relaxed);
+    counters.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+
+    if (info & SAMPLED_BIT) {
+        bool wasInTracker = t_inTracker;
+        t_inTracker = true;
+        {
+            std::lock_guard<std::mutex> lock(g_sampleMutex);
+            if (g_samples) g_samples->erase(block);
+        }
+        t_inTracker = wasInTracker;
+    }
+    std::free(header->raw);
+}
+#endif
+
+// DbgHelp is single-threaded; symbols load on the first report
+std::mutex g_symbolMutex;
+bool g_symbolsInitialized = false;
+
+std::string DescribeAddress(void* address) {
+    std::lock_guard<std::mutex> lock(g_symbolMutex);
+    HANDLE process = GetCurrentProcess();
+    if (!g_symbolsInitialized) {
+        SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS | SYMOPT_LOAD_LINES);
+        g_symbolsInitialized = SymInitialize(process, nullptr, TRUE) == TRUE;
+    }
+
+    char hex[32];
+    snprintf(hex, sizeof(hex), "0x%p", address);
+    std::string text = hex;
+    if (!g_symbolsInitialized) return text;
+
+    alignas(SYMBOL_INFO) char buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME];
+    auto* symbol = reinterpret_cast<SYMBOL_INFO*>(buffer);
+    symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+    symbol->MaxNameLen = MAX_SYM_NAME;
+    DWORD64 address64 = reinterpret_cast<DWORD64>(address);
+    if (SymFromAddr(process, address64, nullptr, symbol)) {
+        text += std::string(" ") + symbol->Name;
+    }
+    IMAGEHLP_LINE64 line = {};
+    line.SizeOfStruct = sizeof(line);
+    DWORD displacement = 0;
+    if (SymGetLineFromAddr64(process, address64, &displacement, &line)) {
+        text += std::string(" (") + line.FileName + ":" + std::to_string(line.LineNumber) + ")";
+    }
+    return text;
+}
+} // namespace
+
+bool MemoryTracker::IsEnabled() {
+#ifdef NEXUS_MEMORY_TRACKING_ENABLED
+    return true;
+#else
+    return false;
+#endif
+}
+
+MemoryTagStats MemoryTracker::GetStats(MemoryTag tag) {
+    MemoryTagStats stats;
+    size_t index = static_cast<size_t>(tag);
+    if (index >= TAG_COUNT) return stats;
+    const TagCounters& counters = g_counters[index];
+    stats.currentBytes = counters.currentBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+    stats.liveAllocations = counters.liveAllocations.load(std::memory_order_relaxed);
+    stats.totalAllocations = counters.totalAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t MemoryTracker::GetTotalBytes() {
+    uint64_t total = 0;
+    for (const TagCounters& counters : g_counters) {
+        total += counters.currentBytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void MemoryTracker::ResetPeaks() {
+    for (TagCounters& counters : g_counters) {
+        counters.peakBytes.store(counters.currentBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag) {
+    size_t index = static_cast<size_t>(tag);
+    return index < TAG_COUNT ? TAG_NAMES[index] : "Unknown";
+}
+
+MemoryTag MemoryTracker::GetCurrentTag() {
+    return t_tag;
+}
+
+MemoryTag MemoryTracker::SwapCurrentTag(MemoryTag tag) {
+    MemoryTag previous = t_tag;
+    t_tag = tag;
+    return previous;
+}
+
+void MemoryTracker::SetSamplingInterval(uint64_t bytes) {
+    g_samplingInterval.store(bytes, std::memory_order_relaxed);
+    if (bytes > 0 && !IsEnabled()) {
+        Logger::Warning("Allocation sampling needs a build with memory tracking");
+    }
+}
+
+uint64_t MemoryTracker::GetSamplingInterval() {
+    return g_samplingInterval.load(std::memory_order_relaxed);
+}
+
+std::vector<MemoryAllocationSite> MemoryTracker::GetLiveSites() {
+    // Copied under the lock with sampling off for this thread, which must not take the lock again
+    std::vector<LiveSample> samples;
+    bool wasInTracker = t_inTracker;
+    t_inTracker = true;
+    {
+        std::lock_guard<std::mutex> lock(g_sampleMutex);
+        if (g_samples) {
+            samples.reserve(g_samples->size());
+            for (const auto& entry : *g_samples) samples.push_back(entry.second);
+        }
+    }
+    t_inTracker = wasInTracker;
+
+    auto sameSite = [](const LiveSample& a, const LiveSample& b) {
+        return a.tag == b.tag && a.depth == b.depth && std::equal(a.frames, a.frames + a.depth, b.frames);
+    };
+    std::sort(samples.begin(), samples.end(), [](const LiveSample& a, const LiveSample& b) {
+        if (a.tag != b.tag) return a.tag < b.tag;
+        if (a.depth != b.depth) return a.depth < b.depth;
+        return std::lexicographical_compare(a.frames, a.frames + a.depth, b.frames, b.frames + b.depth);
+    });
+
+    std::vector<MemoryAllocationSite> sites;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (i == 0 || !sameSite(samples[i - 1], samples[i])) {
+            MemoryAllocationSite site;
+            site.tag = samples[i].tag;
+            site.callstack.assign(samples[i].frames, samples[i].frames + samples[i].depth);
+            sites.push_back(std::move(site));
+        }
+        sites.back().bytes += samples[i].bytes;
+        sites.back().allocations++;
+    }
+    std::sort(sites.begin(), sites.end(), [](const MemoryAllocationSite& a, const MemoryAllocationSite& b) {
+        return a.bytes > b.bytes;
+    });
+    return sites;
+}
+
+bool MemoryTracker::SaveAllocationReport(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file) {
+        Logger::Error("Failed to write allocation report: " + filename);
+        return false;
+    }
+
+    file << "Heap by tag (bytes current / peak, live allocations)\n";
+    for (size_t i = 0; i < TAG_COUNT; ++i) {
+        MemoryTagStats stats = GetStats(static_cast<MemoryTag>(i));
+        file << "  " << TAG_NAMES[i] << ": " << stats.currentBytes << " / " << stats.peakBytes << ", "
+             << stats.liveAllocations << "\n";
+    }
+
+    std::vector<MemoryAllocationSite> sites = GetLiveSites();
+    file << "\nLive sampled allocations, one per " << GetSamplingInterval() << " bytes per thread: "
+         << sites.size() << " sites\n";
+    for (const auto& site : sites) {
+        file << "\n" << GetTagName(site.tag) << ": " << site.bytes << " bytes in " << site.allocations
+             << " sampled allocations\n";
+        for (void* frame : site.callstack) {
+            file << "    " << DescribeAddress(frame) << "\n";
+        }
+    }
+
+    Logger::Info("Saved allocation report with " + std::to_string(sites.size()) + " sites to " + filename);
+    return static_cast<bool>(file);
+}
+
+void MemoryTracker::SetGpuStats(const GpuMemoryStats& stats) {
+    std::lock_guard<std::mutex> lock(g_gpuMutex);
+    g_gpuStats = stats;
+}
+
+GpuMemoryStats MemoryTracker::GetGpuStats() {
+    std::lock_guard<std::mutex> lock(g_gpuMutex);
+    return g_gpuStats;
+}
+
+} // namespace Nexus
+
+#ifdef NEXUS_MEMORY_TRACKING_ENABLED
+// Every replaceable form, so each block is freed by the same code that allocated it
+void* operator new(size_t size) { return Nexus::TrackedAllocateOrThrow(size, Nexus::DEFAULT_ALIGNMENT); }
+void* operator new[](size_t size) { return Nexus::TrackedAllocateOrThrow(size, Nexus::DEFAULT_ALIGNMENT); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Nexus::TrackedAllocateNoThrow(size, Nexus::DEFAULT_ALIGNMENT); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return Nexus::TrackedAllocateNoThrow(size, Nexus::DEFAULT_ALIGNMENT); }
+void* operator new(size_t size, std::align_val_t alignment) { return Nexus::TrackedAllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return Nexus::TrackedAllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return Nexus::TrackedAllocateNoThrow(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return Nexus::TrackedAllocateNoThrow(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* block) noexcept { Nexus::TrackedFree(block); }
+void operator delete[](void* block) noexcept { Nexus::TrackedFree(block); }
+void operator delete(void* block, size_t) noexcept { Nexus::TrackedFree(block); }
+void operator delete[](void* block, size_t) noexcept { Nexus::TrackedFree(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { Nexus::TrackedFree(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { Nexus::TrackedFree(block); }
+void operator delete(void* block, std::align_val_t) noexcept { Nexus::TrackedFree(block); }
+void operator delete[](void* block, std::align_val_t) noexcept { Nexus::TrackedFree(block); }
+void operator delete(void* block, size_t, std::align_val_t) noexcept { Nexus::TrackedFree(block); }
+void operator delete[](void* block, size_t, std::align_val_t) noexcept { Nexus::TrackedFree(block); }
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept { Nexus::TrackedFree(block); }
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept { Nexus::TrackedFree(block); }
+#endif
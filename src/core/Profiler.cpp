@@ -0,0 +1,369 @@
+#include "Profiler.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <unordered_map>
+
+namespace Nexus {
+
+namespace {
+constexpr size_t THREAD_BUFFER_CAPACITY = 1 << 15; // Events per thread between two EndFrame calls
+constexpr size_t MAX_SCOPE_DEPTH = 64;
+constexpr uint32_t GPU_THREAD_ID = 0xFFFFu;
+
+std::atomic<uint32_t> g_nextThreadId{1};
+}
+
+struct Profiler::ThreadBuffer {
+    std::unique_ptr<ProfileEvent[]> events;
+    std::atomic<size_t> head{0}; // Written by the owning thread
+    std::atomic<size_t> tail{0}; // Written by the draining thread
+    std::atomic<size_t> dropped{0};
+    uint32_t threadId = 0;
+    std::string name;
+
+    // Open scope stack, only touched by the owning thread
+    const char* scopeNames[MAX_SCOPE_DEPTH] = {};
+    uint64_t scopeStarts[MAX_SCOPE_DEPTH] = {};
+    bool scopeRecorded[MAX_SCOPE_DEPTH] = {};
+    uint16_t depth = 0;
+
+    ThreadBuffer() : events(std::make_unique<ProfileEvent[]>(THREAD_BUFFER_CAPACITY)) {}
+
+    void Push(const ProfileEvent& event) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= THREAD_BUFFER_CAPACITY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[h & (THREAD_BUFFER_CAPACITY - 1)] = event;
+        head.store(h + 1, std::memory_order_release);
+    }
+};
+
+std::atomic<bool> Profiler::enabled_{true};
+bool Profiler::initialized_ = false;
+bool Profiler::capturing_ = false;
+size_t Profiler::captureFrameLimit_ = 0;
+size_t Profiler::captureFrameCount_ = 0;
+uint64_t Profiler::frameIndex_ = 0;
+uint64_t Profiler::frameStartNs_ = 0;
+double Profiler::lastFrameTimeMs_ = 0.0;
+std::mutex Profiler::registryMutex_;
+std::vector<std::shared_ptr<Profiler::ThreadBuffer>> Profiler::threadBuffers_;
+std::vector<ProfileEvent> Profiler::lastFrameEvents_;
+std::vector<ProfileScopeStats> Profiler::lastFrameStats_;
+std::vector<ProfileEvent> Profiler::captureEvents_;
+std::mutex Profiler::counterMutex_;
+std::vector<Profiler::CounterSample> Profiler::captureCounters_;
+std::vector<ProfileCounterValue> Profiler::captureCounterValues_;
+std::vector<std::unique_ptr<std::string>> Profiler::internedNames_;
+std::atomic<uint32_t> Profiler::generation_{1};
+thread_local Profiler::ThreadBuffer* Profiler::threadBuffer_ = nullptr;
+thread_local uint32_t Profiler::threadGeneration_ = 0;
+
+void Profiler::Initialize() {
+    if (initialized_) return;
+
+    frameIndex_ = 0;
+    frameStartNs_ = GetTimeNs();
+    initialized_ = true;
+    SetThreadName("Main Thread");
+    Logger::Info("Profiler initialized");
+}
+
+void Profiler::Shutdown() {
+    if (!initialized_) return;
+
+    if (capturing_) {
+        EndCapture();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        threadBuffers_.clear();
+        generation_.fetch_add(1, std::memory_order_release); // Invalidates every thread_local buffer pointer
+    }
+    lastFrameEvents_.clear();
+    lastFrameStats_.clear();
+    captureEvents_.clear();
+    {
+        std::lock_guard<std::mutex> lock(counterMutex_);
+        captureCounters_.clear();
+        captureCounterValues_.clear();
+    }
+    initialized_ = false;
+    Logger::Info("Profiler shut down");
+}
+
+uint64_t Profiler::GetTimeNs() {
+    using namespace std::chrono;
+    return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer() {
+    if (threadBuffer_ && threadGeneration_ == generation_.load(std::memory_order_acquire)) {
+        return threadBuffer_;
+    }
+
+    auto buffer = std::make_shared<ThreadBuffer>();
+    buffer->threadId = g_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    buffer->name = "Thread " + std::to_string(buffer->threadId);
+
+    std::lock_guard<std::mutex> lock(registryMutex_);
+    threadBuffers_.push_back(buffer);
+    threadBuffer_ = buffer.get();
+    threadGeneration_ = generation_.load(std::memory_order_acquire);
+    return threadBuffer_;
+}
+
+void Profiler::SetThreadName(const std::string& name) {
+    ThreadBuffer* buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex_);
+    buffer->name = name;
+}
+
+const char* Profiler::InternName(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registryMutex_);
+    for (const auto& interned : internedNames_) {
+        if (*interned == name) {
+            return interned->c_str();
+        }
+    }
+    internedNames_.push_back(std::make_unique<std::string>(name));
+    return internedNames_.back()->c_str();
+}
+
+void Profiler::BeginScope(const char* name) {
+    ThreadBuffer* buffer = GetThreadBuffer();
+    uint16_t depth = buffer->depth;
+    if (depth >= MAX_SCOPE_DEPTH) {
+        ++buffer->depth;
+        return;
+    }
+
+    // The stack is kept even while disabled so toggling mid-scope stays balanced
+    buffer->scopeNames[depth] = name;
+    buffer->scopeRecorded[depth] = IsEnabled();
+    buffer->scopeStarts[depth] = buffer->scopeRecorded[depth] ? GetTimeNs() : 0;
+    ++buffer->depth;
+}
+
+void Profiler::EndScope() {
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (buffer->depth == 0) return;
+
+    uint16_t depth = --buffer->depth;
+    if (depth >= MAX_SCOPE_DEPTH || !buffer->scopeRecorded[depth]) return;
+
+    ProfileEvent event;
+    event.name = buffer->scopeNames[depth];
+    event.startNs = buffer->scopeStarts[depth];
+    event.endNs = GetTimeNs();
+    event.threadId = buffer->threadId;
+    event.depth = depth;
+    event.lane = 0;
+    buffer->Push(event);
+}
+
+void Profiler::RecordEvent(const char* name, uint64_t startNs, uint64_t endNs, uint16_t depth, uint16_t lane) {
+    if (!IsEnabled()) return;
+
+    ThreadBuffer* buffer = GetThreadBuffer();
+    ProfileEvent event;
+    event.name = name;
+    event.startNs = startNs;
+    event.endNs = endNs;
+    event.threadId = lane == 0 ? buffer->threadId : GPU_THREAD_ID;
+    event.depth = depth;
+    event.lane = lane;
+    buffer->Push(event);
+}
+
+void Profiler::BeginFrame() {
+    frameStartNs_ = GetTimeNs();
+}
+
+void Profiler::EndFrame() {
+    if (!initialized_) return;
+
+    uint64_t frameEndNs = GetTimeNs();
+    lastFrameTimeMs_ = static_cast<double>(frameEndNs - frameStartNs_) / 1000000.0;
+
+    lastFrameEvents_.clear();
+    DrainThreadBuffers(lastFrameEvents_);
+    BuildFrameStats();
+
+    if (capturing_) {
+        captureEvents_.insert(captureEvents_.end(), lastFrameEvents_.begin(), lastFrameEvents_.end());
+        if (++captureFrameCount_ >= captureFrameLimit_) {
+            EndCapture();
+        }
+    }
+
+    ++frameIndex_;
+}
+
+void Profiler::DrainThreadBuffers(std::vector<ProfileEvent>& out) {
+    std::lock_guard<std::mutex> lock(registryMutex_);
+    for (auto& buffer : threadBuffers_) {
+        size_t t = buffer->tail.load(std::memory_order_relaxed);
+        size_t h = buffer->head.load(std::memory_order_acquire);
+        for (; t != h; ++t) {
+            out.push_back(buffer->events[t & (THREAD_BUFFER_CAPACITY - 1)]);
+        }
+        buffer->tail.store(h, std::memory_order_release);
+
+        size_t dropped = buffer->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            Logger::Warning("Profiler dropped " + std::to_string(dropped) + " events on " + buffer->name);
+        }
+    }
+}
+
+void Profiler::BuildFrameStats() {
+    lastFrameStats_.clear();
+
+    // Scope names are interned pointers, so the pointer is the key
+    std::unordered_map<const char*, size_t> indexByName;
+    for (const auto& event : lastFrameEvents_) {
+        auto it = indexByName.find(event.name);
+        if (it == indexByName.end()) {
+            ProfileScopeStats stats;
+            stats.name = event.name;
+            stats.lane = event.lane;
+            stats.depth = event.depth;
+            it = indexByName.emplace(event.name, lastFrameStats_.size()).first;
+            lastFrameStats_.push_back(stats);
+        }
+
+        ProfileScopeStats& stats = lastFrameStats_[it->second];
+        double duration = event.GetDurationMs();
+        stats.callCount++;
+        stats.totalMs += duration;
+        stats.maxMs = std::max(stats.maxMs, duration);
+        stats.depth = std::min(stats.depth, event.depth);
+    }
+
+    std::sort(lastFrameStats_.begin(), lastFrameStats_.end(), [](const ProfileScopeStats& a, const ProfileScopeStats& b) {
+        if (a.lane != b.lane) return a.lane < b.lane;
+        return a.totalMs > b.totalMs;
+    });
+}
+
+double Profiler::GetScopeTimeMs(const char* name) {
+    for (const auto& stats : lastFrameStats_) {
+        if (stats.name == name || (stats.name && name && std::string(stats.name) == name)) {
+            return stats.totalMs;
+        }
+    }
+    return 0.0;
+}
+
+void Profiler::BeginCapture(size_t maxFrames) {
+    captureEvents_.clear();
+    {
+        std::lock_guard<std::mutex> lock(counterMutex_);
+        captureCounters_.clear();
+        captureCounterValues_.clear();
+    }
+    captureFrameLimit_ = std::max<size_t>(maxFrames, 1);
+    captureFrameCount_ = 0;
+    capturing_ = true;
+    Logger::Info("Profiler capture started (" + std::to_string(captureFrameLimit_) + " frames)");
+}
+
+void Profiler::EndCapture() {
+    if (!capturing_) return;
+    capturing_ = false;
+    Logger::Info("Profiler capture finished: " + std::to_string(captureFrameCount_) + " frames, " +
+                 std::to_string(captureEvents_.size()) + " events");
+}
+
+void Profiler::RecordCounter(const char* name, const ProfileCounterValue* values, size_t count, uint64_t timeNs) {
+    if (!capturing_ || count == 0) return;
+    std::lock_guard<std::mutex> lock(counterMutex_);
+    captureCounters_.push_back({name, timeNs != 0 ? timeNs : GetTimeNs(), captureCounterValues_.size(), count});
+    captureCounterValues_.insert(captureCounterValues_.end(), values, values + count);
+}
+
+namespace {
+void WriteJsonString(std::ofstream& file, const char* text) {
+    file << '"';
+    for (const char* c = text ? text : ""; *c; ++c) {
+        switch (*c) {
+            case '"': file << "\\\""; break;
+            case '\\': file << "\\\\"; break;
+            case '\n': file << "\\n"; break;
+            default: file << *c; break;
+        }
+    }
+    file << '"';
+}
+}
+
+bool Profiler::SaveChromeTrace(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        Logger::Error("Failed to open profiler trace file: " + filename);
+        return false;
+    }
+
+    const std::vector<ProfileEvent>& events = captureEvents_.empty() ? lastFrameEvents_ : captureEvents_;
+    uint64_t baseNs = events.empty() ? 0 : events.front().startNs;
+    for (const auto& event : events) {
+        baseNs = std::min(baseNs, event.startNs);
+    }
+    // Counters from other threads may be stamped out of order
+    std::lock_guard<std::mutex> counterLock(counterMutex_);
+    bool writeCounters = !captureEvents_.empty();
+    for (size_t i = 0; writeCounters && i < captureCounters_.size(); ++i) {
+        baseNs = std::min(baseNs, captureCounters_[i].timeNs);
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        for (const auto& buffer : threadBuffers_) {
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                 << buffer->threadId << ",\"args\":{\"name\":";
+            WriteJsonString(file, buffer->name.c_str());
+            file << "}}";
+            first = false;
+        }
+    }
+    file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD_ID
+         << ",\"args\":{\"name\":\"GPU\"}}";
+
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    for (const auto& event : events) {
+        file << ",\n{\"name\":";
+        WriteJsonString(file, event.name);
+        file << ",\"cat\":\"" << (event.lane == 0 ? "cpu" : "gpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+             << event.threadId << ",\"ts\":" << static_cast<double>(event.startNs - baseNs) / 1000.0
+             << ",\"dur\":" << static_cast<double>(event.endNs - event.startNs) / 1000.0 << "}";
+    }
+    for (size_t i = 0; writeCounters && i < captureCounters_.size(); ++i) {
+        const CounterSample& counter = captureCounters_[i];
+        file << ",\n{\"name\":";
+        WriteJsonString(file, counter.name);
+        file << ",\"ph\":\"C\",\"pid\":1,\"ts\":" << static_cast<double>(counter.timeNs - baseNs) / 1000.0 << ",\"args\":{";
+        for (size_t v = 0; v < counter.valueCount; ++v) {
+            const ProfileCounterValue& value = captureCounterValues_[counter.firstValue + v];
+            file << (v > 0 ? "," : "");
+            WriteJsonString(file, value.series);
+            file << ":" << value.value;
+        }
+        file << "}}";
+    }
+    file << "\n]}\n";
+
+    Logger::Info("Saved profiler trace with " + std::to_string(events.size()) + " events to " + filename);
+    return true;
+}
+
+} // namespace Nexus
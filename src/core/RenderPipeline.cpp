@@ -0,0 +1,125 @@
+#include "RenderPipeline.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace Nexus {
+
+RenderPipeline::RenderPipeline()
+    : maxFramesInFlight_(1)
+    , running_(false)
+    , initialized_(false)
+    , failed_(false)
+    , lastLatencyMs_(0.0f)
+{
+}
+
+RenderPipeline::~RenderPipeline() {
+    Shutdown();
+}
+
+bool RenderPipeline::Initialize(SubmitFunction submit, int maxFramesInFlight) {
+    if (initialized_) return true;
+    if (!submit) return false;
+
+    submit_ = std::move(submit);
+    maxFramesInFlight_ = std::clamp(maxFramesInFlight, 1, 3);
+
+    // One packet being filled plus the ones queued for or held by the render thread
+    packets_.clear();
+    freePackets_.clear();
+    readyPackets_.clear();
+    for (int i = 0; i < maxFramesInFlight_ + 1; ++i) {
+        packets_.push_back(std::make_unique<RenderPacket>());
+        freePackets_.push_back(packets_.back().get());
+    }
+
+    running_ = true;
+    failed_ = false;
+    renderThread_ = std::thread(&RenderPipeline::RenderThreadLoop, this);
+
+    initialized_ = true;
+    Logger::Info("Render pipeline started with " + std::to_string(maxFramesInFlight_) + " frame(s) in flight");
+    return true;
+}
+
+void RenderPipeline::Shutdown() {
+    if (!initialized_) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    readyCondition_.notify_all();
+    freeCondition_.notify_all();
+
+    if (renderThread_.joinable()) {
+        renderThread_.join();
+    }
+
+    packets_.clear();
+    freePackets_.clear();
+    readyPackets_.clear();
+    submit_ = nullptr;
+    initialized_ = false;
+    Logger::Info("Render pipeline stopped");
+}
+
+RenderPacket* RenderPipeline::BeginPacket() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    freeCondition_.wait(lock, [this]() { return !running_ || !freePackets_.empty(); });
+    if (!running_) return nullptr;
+
+    RenderPacket* packet = freePackets_.front();
+    freePackets_.pop_front();
+    return packet;
+}
+
+void RenderPipeline::SubmitPacket(RenderPacket* packet) {
+    if (!packet) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readyPackets_.push_back(packet);
+    }
+    readyCondition_.notify_one();
+}
+
+void RenderPipeline::RenderThreadLoop() {
+    Profiler::SetThreadName("Render Thread");
+
+    for (;;) {
+        RenderPacket* packet = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            readyCondition_.wait(lock, [this]() { return !running_ || !readyPackets_.empty(); });
+            // Drop undrawn packets on shutdown, the device is about to go away
+            if (!running_) break;
+
+            packet = readyPackets_.front();
+            readyPackets_.pop_front();
+        }
+
+        if (!failed_.load(std::memory_order_relaxed)) {
+            try {
+                submit_(*packet);
+                uint64_t now = Profiler::GetTimeNs();
+                if (now > packet->data.simulatedAtNs) {
+                    lastLatencyMs_.store(static_cast<float>(now - packet->data.simulatedAtNs) / 1000000.0f,
+                                         std::memory_order_relaxed);
+                }
+            } catch (const std::exception& e) {
+                Logger::Error("Exception on render thread: " + std::string(e.what()));
+                failed_.store(true, std::memory_order_release);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            freePackets_.push_back(packet);
+        }
+        freeCondition_.notify_one();
+    }
+}
+
+} // namespace Nexus
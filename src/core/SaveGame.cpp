@@ -0,0 +1,214 @@
+#include "SaveGame.h"
+#include "Components.h"
+#include "Logger.h"
+#include "Profiler.h"
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+
+constexpr uint32_t SECTION_ENTITIES = MakeFourCC('E', 'N', 'T', 'T');
+constexpr uint32_t SECTION_TRANSFORMS = MakeFourCC('X', 'F', 'R', 'M');
+constexpr uint32_t SECTION_BODIES = MakeFourCC('B', 'O', 'D', 'Y');
+constexpr uint32_t SECTION_RENDERABLES = MakeFourCC('R', 'N', 'D', 'R');
+constexpr uint32_t SECTION_REPLICATED = MakeFourCC('R', 'E', 'P', 'L');
+
+// Which sections hold a record for an entity
+enum EntityMask : uint32_t {
+    HAS_TRANSFORM = 1 << 0,
+    HAS_BODY = 1 << 1,
+    HAS_RENDERABLE = 1 << 2,
+    HAS_REPLICATED = 1 << 3
+};
+
+// The saved part of a body, awake or asleep
+struct BodyRecord {
+    XMFLOAT3 velocity;
+    float mass;
+    uint32_t eventCategories;
+    uint32_t continuous;
+};
+
+BinarySchema GetEntitySchema() {
+    return BinarySchema().Field("components", BinarySchema::FieldType::U32);
+}
+
+BinarySchema GetTransformSchema() {
+    return BinarySchema()
+        .Field("position", BinarySchema::FieldType::F32, 3)
+        .Field("previousPosition", BinarySchema::FieldType::F32, 3)
+        .Field("rotation", BinarySchema::FieldType::F32, 4)
+        .Field("scale", BinarySchema::FieldType::F32, 3);
+}
+
+BinarySchema GetBodySchema() {
+    return BinarySchema()
+        .Field("velocity", BinarySchema::FieldType::F32, 3)
+        .Field("mass", BinarySchema::FieldType::F32)
+        .Field("eventCategories", BinarySchema::FieldType::U32)
+        .Field("continuous", BinarySchema::FieldType::U32);
+}
+
+BinarySchema GetRenderableSchema() {
+    return BinarySchema()
+        .Field("color", BinarySchema::FieldType::F32, 4)
+        .Field("shapeType", BinarySchema::FieldType::U32);
+}
+
+BinarySchema GetReplicatedSchema() {
+    return BinarySchema().Field("type", BinarySchema::FieldType::U16);
+}
+
+BodyRecord MakeBodyRecord(const PhysicsBodyComponent& body) {
+    return { body.velocity, body.mass, body.eventCategories, body.continuous ? 1u : 0u };
+}
+
+// One entity's loaded components; those its mask doesn't name are unused
+struct LoadedEntity {
+    TransformComponent transform;
+    PhysicsBodyComponent body;
+    RenderableComponent renderable;
+    ReplicatedComponent replicated;
+};
+
+template<int Bit>
+auto& GetLoadedComponent(LoadedEntity& loaded) {
+    if constexpr (Bit == 0) return loaded.transform;
+    else if constexpr (Bit == 1) return loaded.body;
+    else if constexpr (Bit == 2) return loaded.renderable;
+    else return loaded.replicated;
+}
+
+// Creates the entity with the components its mask names in one go, rather than moving it
+// between archetypes once per added component
+template<int Bit = 0, typename... Ts>
+Entity CreateLoadedEntity(World& world, uint32_t mask, LoadedEntity& loaded, Ts&... components) {
+    if constexpr (Bit == 4) {
+        return world.CreateEntity(components...);
+    } else {
+        if (mask & (1u << Bit)) {
+            return CreateLoadedEntity<Bit + 1>(world, mask, loaded, components..., GetLoadedComponent<Bit>(loaded));
+        }
+        return CreateLoadedEntity<Bit + 1>(world, mask, loaded, components...);
+    }
+}
+
+} // namespace
+
+bool SaveGame::Write(const World& world, const std::string& filename, bool compress) {
+    NEXUS_PROFILE_SCOPE("SaveGame::Write");
+
+    std::vector<uint32_t> masks;
+    std::vector<TransformComponent> transforms;
+    std::vector<BodyRecord> bodies;
+    std::vector<RenderableComponent> renderables;
+    std::vector<ReplicatedComponent> replicated;
+    masks.reserve(world.GetEntityCount());
+
+    world.ForEachChunk<>([&](size_t count, const Entity* entities) {
+        for (size_t i = 0; i < count; ++i) {
+            const Entity entity = entities[i];
+            uint32_t mask = 0;
+            if (const TransformComponent* transform = world.GetComponent<TransformComponent>(entity)) {
+                transforms.push_back(*transform);
+                mask |= HAS_TRANSFORM;
+            }
+            if (const PhysicsBodyComponent* body = world.GetComponent<PhysicsBodyComponent>(entity)) {
+                bodies.push_back(MakeBodyRecord(*body));
+                mask |= HAS_BODY;
+            } else if (const SleepingBodyComponent* sleeping = world.GetComponent<SleepingBodyComponent>(entity)) {
+                bodies.push_back(MakeBodyRecord(*sleeping));
+                mask |= HAS_BODY;
+            }
+            if (const RenderableComponent* renderable = world.GetComponent<RenderableComponent>(entity)) {
+                renderables.push_back(*renderable);
+                mask |= HAS_RENDERABLE;
+            }
+            if (const ReplicatedComponent* replicatedComponent = world.GetComponent<ReplicatedComponent>(entity)) {
+                replicated.push_back(*replicatedComponent);
+                mask |= HAS_REPLICATED;
+            }
+            if (mask != 0) masks.push_back(mask);
+        }
+    });
+
+    BinaryFileWriter writer(CONTENT_TYPE, VERSION);
+    writer.AddSection(SECTION_ENTITIES, GetEntitySchema(), masks, compress);
+    writer.AddSection(SECTION_TRANSFORMS, GetTransformSchema(), transforms, compress);
+    writer.AddSection(SECTION_BODIES, GetBodySchema(), bodies, compress);
+    writer.AddSection(SECTION_RENDERABLES, GetRenderableSchema(), renderables, compress);
+    writer.AddSection(SECTION_REPLICATED, GetReplicatedSchema(), replicated, compress);
+    if (!writer.Write(filename)) return false;
+
+    Logger::Info("Saved " + std::to_string(masks.size()) + " entities to " + filename);
+    return true;
+}
+
+bool SaveGame::Read(World& world, const std::string& filename, std::vector<Entity>* entities) {
+    NEXUS_PROFILE_SCOPE("SaveGame::Read");
+
+    BinaryFile file;
+    if (!file.Open(filename, CONTENT_TYPE)) return false;
+    if (file.GetContentVersion() != VERSION) {
+        Logger::Warning("Save game is from another version: " + filename);
+        return false;
+    }
+
+    std::vector<uint8_t> buffers[5];
+    size_t entityCount = 0, transformCount = 0, bodyCount = 0, renderableCount = 0, replicatedCount = 0;
+    const uint32_t* masks = file.GetSection<uint32_t>(SECTION_ENTITIES, GetEntitySchema(), entityCount, buffers[0]);
+    const TransformComponent* transforms =
+        file.GetSection<TransformComponent>(SECTION_TRANSFORMS, GetTransformSchema(), transformCount, buffers[1]);
+    const BodyRecord* bodies = file.GetSection<BodyRecord>(SECTION_BODIES, GetBodySchema(), bodyCount, buffers[2]);
+    const RenderableComponent* renderables =
+        file.GetSection<RenderableComponent>(SECTION_RENDERABLES, GetRenderableSchema(), renderableCount, buffers[3]);
+    const ReplicatedComponent* replicated =
+        file.GetSection<ReplicatedComponent>(SECTION_REPLICATED, GetReplicatedSchema(), replicatedCount, buffers[4]);
+
+    // Every section must hold exactly one record per entity whose mask names it, checked before
+    // anything is created so a damaged file leaves the world alone
+    bool valid = masks && transforms && bodies && renderables && replicated;
+    size_t expected[4] = {};
+    for (size_t i = 0; valid && i < entityCount; ++i) {
+        if (masks[i] & HAS_TRANSFORM) ++expected[0];
+        if (masks[i] & HAS_BODY) ++expected[1];
+        if (masks[i] & HAS_RENDERABLE) ++expected[2];
+        if (masks[i] & HAS_REPLICATED) ++expected[3];
+    }
+    valid = valid && expected[0] == transformCount && expected[1] == bodyCount &&
+            expected[2] == renderableCount && expected[3] == replicatedCount;
+    if (!valid) {
+        Logger::Error("Save game is damaged or from an incompatible build: " + filename);
+        return false;
+    }
+
+    if (entities) {
+        entities->clear();
+        entities->reserve(entityCount);
+    }
+    size_t transform = 0, body = 0, renderable = 0, replicatedIndex = 0;
+    for (size_t i = 0; i < entityCount; ++i) {
+        const uint32_t mask = masks[i] & (HAS_TRANSFORM | HAS_BODY | HAS_RENDERABLE | HAS_REPLICATED);
+        LoadedEntity loaded;
+        if (mask & HAS_TRANSFORM) loaded.transform = transforms[transform++];
+        if (mask & HAS_BODY) {
+            const BodyRecord& record = bodies[body++];
+            loaded.body.velocity = record.velocity;
+            loaded.body.mass = record.mass;
+            loaded.body.eventCategories = record.eventCategories;
+            loaded.body.continuous = record.continuous != 0;
+        }
+        if (mask & HAS_RENDERABLE) loaded.renderable = renderables[renderable++];
+        if (mask & HAS_REPLICATED) loaded.replicated = replicated[replicatedIndex++];
+
+        Entity entity = CreateLoadedEntity(world, mask, loaded);
+        if (entities) entities->push_back(entity);
+    }
+
+    Logger::Info("Loaded " + std::to_string(entityCount) + " entities from " + filename);
+    return true;
+}
+
+} // namespace Nexus
@@ -0,0 +1,591 @@
+#include "SceneBenchmark.h"
+#include "Engine.h"
+#include "GraphicsDevice.h"
+#include "GpuProfiler.h"
+#include "PhysicsEngine.h"
+#include "AISystem.h"
+#include "ParticleSystem.h"
+#include "LightingEngine.h"
+#include "Light.h"
+#include "Profiler.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+using namespace DirectX;
+
+namespace Nexus {
+
+namespace {
+
+// Every scene builds from this seed, so two runs place the same objects
+constexpr uint32_t SEED = 1234;
+
+// Frames the orbit takes when there is no path to set the length
+constexpr uint32_t DEFAULT_FRAMES = 1800;
+
+// Enough for the GPU profiler's readback latency, with room for a late frame
+constexpr uint32_t MAX_DRAIN_FRAMES = 8;
+
+// The profiler scopes the engine's frame breaks down into
+const char* const SUBSYSTEM_SCOPES[] = {
+    "Engine::Update", "Physics::Update", "AI::Update", "Animation::Update", "Audio::Update",
+    "Particles::Update", "Scripting::Update", "UI::Update", "Engine::Render"
+};
+constexpr size_t SUBSYSTEM_COUNT = sizeof(SUBSYSTEM_SCOPES) / sizeof(SUBSYSTEM_SCOPES[0]);
+
+// Path file names of InputEventType, in enum order; connections aren't scripted
+const char* const EVENT_NAMES[] = {
+    "keydown", "keyup", "buttondown", "buttonup", "move", "wheel", "padbuttondown", "padbuttonup"
+};
+constexpr size_t EVENT_NAME_COUNT = sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]);
+
+const char* const SCENE_NAMES[] = { "physics10k", "ai1000", "particles1m", "lights" };
+
+struct Summary {
+    float mean = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+    uint32_t samples = 0;
+};
+
+// Nearest rank over every recorded value, so the tail is exact
+Summary Summarize(std::vector<float> values) {
+    Summary summary;
+    if (values.empty()) return summary;
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (float value : values) sum += value;
+    auto percentile = [&values](float quantile) {
+        size_t rank = static_cast<size_t>(std::ceil(quantile * values.size()));
+        return values[std::min(std::max<size_t>(rank, 1), values.size()) - 1];
+    };
+    summary.mean = static_cast<float>(sum / values.size());
+    summary.p50 = percentile(0.50f);
+    summary.p95 = percentile(0.95f);
+    summary.p99 = percentile(0.99f);
+    summary.max = values.back();
+    summary.samples = static_cast<uint32_t>(values.size());
+    return summary;
+}
+
+// Names come from code and files, but quotes would break the report
+void WriteJsonString(std::ofstream& file, const std::string& text) {
+    file << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') file << '\\';
+        file << c;
+    }
+    file << '"';
+}
+
+void WriteJsonSummary(std::ofstream& file, const std::string& name, const Summary& summary) {
+    file << "{\"name\":";
+    WriteJsonString(file, name);
+    file << ",\"samples\":" << summary.samples << ",\"mean\":" << summary.mean << ",\"p50\":" << summary.p50
+         << ",\"p95\":" << summary.p95 << ",\"p99\":" << summary.p99 << ",\"max\":" << summary.max << '}';
+}
+
+XMFLOAT3 Lerp(const XMFLOAT3& a, const XMFLOAT3& b, float t) {
+    return XMFLOAT3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+}
+
+// 10,000 bodies in 8-high stacks that start toppling on the first step
+bool BuildPhysicsScene(PhysicsEngine& physics, XMFLOAT3& center, float& radius) {
+    constexpr int BODY_COUNT = 10000;
+    constexpr int STACK_HEIGHT = 8;
+    constexpr float SPACING = 1.5f;
+
+    physics.SetGroundPlane(true, 0.0f);
+    const int stacks = (BODY_COUNT + STACK_HEIGHT - 1) / STACK_HEIGHT;
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(stacks))));
+    for (int i = 0; i < BODY_COUNT; ++i) {
+        const int stack = i / STACK_HEIGHT;
+        const int level = i % STACK_HEIGHT;
+        const bool sphere = i % 4 == 3;
+        const XMFLOAT3 position((stack % side) * SPACING + (sphere ? 0.1f : 0.0f), 0.5f + level * 1.02f,
+                                (stack / side) * SPACING);
+        physics.CreateRigidBody(sphere ? CollisionShape::CreateSphere(0.5f)
+                                       : CollisionShape::CreateBox(XMFLOAT3(1.0f, 1.0f, 1.0f)),
+                                PhysicsTransform(position, XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f)), 1.0f);
+    }
+
+    const float extent = side * SPACING;
+    center = XMFLOAT3(extent * 0.5f, 2.0f, extent * 0.5f);
+    radius = extent;
+    return true;
+}
+
+// 1,000 agents of every personality, alerted by a gunshot in the middle so they all act
+bool BuildAIScene(AIManager& ai, XMFLOAT3& center, float& radius) {
+    constexpr int ENTITY_COUNT = 1000;
+    constexpr float HALF_EXTENT = 100.0f;
+
+    ai.SetMaxAIEntities(ENTITY_COUNT);
+    std::mt19937 random(SEED);
+    std::uniform_real_distribution<float> coordinate(-HALF_EXTENT, HALF_EXTENT);
+    for (int i = 0; i < ENTITY_COUNT; ++i) {
+        auto entity = ai.CreateAIEntity(static_cast<AIPersonality>(i % 7));
+        if (!entity) return false;
+        entity->Initialize(AIVector3(coordinate(random), 0.0f, coordinate(random)));
+    }
+    ai.NotifyGunshot(AIVector3(0.0f, 0.0f, 0.0f), 1.0f);
+
+    center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    radius = HALF_EXTENT * 1.2f;
+    return true;
+}
+
+// Five rain emitters of 200,000 particles each, at their cap once the warmup has run
+bool BuildParticleScene(ParticleSystem& particles, XMFLOAT3& center, float& radius) {
+    constexpr int EMITTER_COUNT = 5;
+    constexpr int PARTICLES_PER_EMITTER = 200000;
+
+    particles.SetMaxParticles(EMITTER_COUNT * PARTICLES_PER_EMITTER);
+    for (int i = 0; i < EMITTER_COUNT; ++i) {
+        const std::string name = "benchmark_rain" + std::to_string(i);
+        particles.CreateRainEffect(name, XMFLOAT3((i - EMITTER_COUNT / 2) * 35.0f, 20.0f, 0.0f));
+        auto emitter = particles.GetEmitter(name);
+        if (!emitter) return false;
+        emitter->maxParticles = PARTICLES_PER_EMITTER;
+        emitter->lodMaxParticles = PARTICLES_PER_EMITTER;
+        // Lifetime 2s, so the emitter just keeps itself full
+        emitter->emissionRate = PARTICLES_PER_EMITTER / emitter->startLifetime;
+    }
+
+    center = XMFLOAT3(0.0f, 5.0f, 0.0f);
+    radius = EMITTER_COUNT * 35.0f * 0.6f;
+    return true;
+}
+
+// A grid of unshadowed point lights, just under the clustered culler's limit, over the demo bodies
+bool BuildLightScene(LightingEngine& lighting, PhysicsEngine* physics, XMFLOAT3& center, float& radius) {
+    constexpr int GRID_SIDE = 63;
+    constexpr float SPACING = 3.0f;
+
+    if (physics) {
+        physics->CreatePhysicsDemo();
+        physics->SetGroundPlane(true, 0.0f);
+    }
+    lighting.ClearLights();
+    std::mt19937 random(SEED);
+    std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+    const float offset = (GRID_SIDE - 1) * SPACING * 0.5f;
+    for (int z = 0; z < GRID_SIDE; ++z) {
+        for (int x = 0; x < GRID_SIDE; ++x) {
+            Light light(LightType::Point);
+            light.SetPosition(XMFLOAT3(x * SPACING - offset, 1.5f, z * SPACING - offset));
+            light.SetColor(XMFLOAT3(channel(random), channel(random), channel(random)));
+            light.SetIntensity(4.0f);
+            light.SetRange(SPACING * 2.5f);
+            light.SetCastsShadows(false);
+            lighting.AddLight(light);
+        }
+    }
+
+    center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    radius = offset * 1.2f;
+    return true;
+}
+
+} // namespace
+
+SceneBenchmark::SceneBenchmark(const Settings& settings)
+    : settings_(settings)
+    , nextEvent_(0)
+    , orbitCenter_(0.0f, 0.0f, 0.0f)
+    , orbitRadius_(50.0f)
+    , orbitHeight_(20.0f)
+    , frameIndex_(0)
+    , measuredFrames_(0)
+    , drainFrames_(0)
+    , frameStartNs_(0)
+    , gpuFramesAtStart_(0)
+{
+    if (settings_.timeStep <= 0.0f) {
+        settings_.timeStep = 1.0f / 60.0f;
+    }
+    if (settings_.record) {
+        settings_.warmupFrames = 0;
+    }
+}
+
+std::vector<std::string> SceneBenchmark::GetSceneNames() {
+    return std::vector<std::string>(std::begin(SCENE_NAMES), std::end(SCENE_NAMES));
+}
+
+bool SceneBenchmark::Initialize(Engine& engine) {
+    if (settings_.record && settings_.pathFile.empty()) {
+        Logger::Error("Scene benchmark recording needs a path file to write");
+        return false;
+    }
+    if (!BuildScene(engine)) {
+        return false;
+    }
+    if (!settings_.record && !settings_.pathFile.empty() && !LoadPath()) {
+        return false;
+    }
+
+    // Without a frame count the path sets the length, its last key or event being the last frame
+    measuredFrames_ = settings_.frames;
+    if (measuredFrames_ == 0 && !settings_.record) {
+        if (!cameraKeys_.empty() || !events_.empty()) {
+            float seconds = cameraKeys_.empty() ? 0.0f : cameraKeys_.back().time;
+            uint32_t lastEvent = events_.empty() ? 0 : events_.back().frame;
+            measuredFrames_ = std::max(static_cast<uint32_t>(seconds / settings_.timeStep) + 1, lastEvent + 1);
+        } else {
+            measuredFrames_ = DEFAULT_FRAMES;
+        }
+    }
+    frames_.reserve(measuredFrames_);
+
+    Logger::Info("Scene benchmark '" + settings_.scene + "': " +
+                 (settings_.record ? "recording " + settings_.pathFile
+                                   : std::to_string(settings_.warmupFrames) + " warmup and " +
+                                     std::to_string(measuredFrames_) + " measured frames"));
+    return true;
+}
+
+bool SceneBenchmark::BuildScene(Engine& engine) {
+    const std::string& scene = settings_.scene;
+    bool built = false;
+    const char* missing = nullptr;
+    if (scene == "physics10k") {
+        if (engine.GetPhysics()) built = BuildPhysicsScene(*engine.GetPhysics(), orbitCenter_, orbitRadius_);
+        else missing = "physics";
+    } else if (scene == "ai1000") {
+        if (engine.GetAI()) built = BuildAIScene(*engine.GetAI(), orbitCenter_, orbitRadius_);
+        else missing = "AI";
+    } else if (scene == "particles1m") {
+        if (engine.GetParticles()) built = BuildParticleScene(*engine.GetParticles(), orbitCenter_, orbitRadius_);
+        else missing = "particles";
+    } else if (scene == "lights") {
+        if (engine.GetLighting()) {
+            built = BuildLightScene(*engine.GetLighting(), engine.GetPhysics(), orbitCenter_, orbitRadius_);
+        } else {
+            missing = "lighting";
+        }
+    } else {
+        std::string names;
+        for (const char* name : SCENE_NAMES) {
+            names += names.empty() ? name : std::string(", ") + name;
+        }
+        Logger::Error("Unknown benchmark scene '" + scene + "', expected one of " + names);
+        return false;
+    }
+
+    if (missing) {
+        Logger::Error("Benchmark scene '" + scene + "' needs " + missing + ", which this engine doesn't run");
+        return false;
+    }
+    if (!built) {
+        Logger::Error("Failed to build benchmark scene '" + scene + "'");
+        return false;
+    }
+    orbitHeight_ = orbitRadius_ * 0.4f;
+    return true;
+}
+
+bool SceneBenchmark::LoadPath() {
+    std::ifstream file(settings_.pathFile);
+    if (!file) {
+        Logger::Error("Cannot open benchmark path: " + settings_.pathFile);
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        std::istringstream stream(line);
+        std::string kind;
+        if (!(stream >> kind)) continue;
+
+        bool valid = false;
+        if (kind == "camera") {
+            CameraKey key;
+            valid = static_cast<bool>(stream >> key.time >> key.position.x >> key.position.y >> key.position.z >>
+                                      key.target.x >> key.target.y >> key.target.z);
+            if (valid) cameraKeys_.push_back(key);
+        } else if (kind == "input") {
+            ScriptedEvent scripted = {};
+            std::string type;
+            int code = 0, controller = 0;
+            valid = static_cast<bool>(stream >> scripted.frame >> type >> code >> scripted.event.x >> scripted.event.y);
+            stream >> controller;
+            const char* const* name = std::find(std::begin(EVENT_NAMES), std::end(EVENT_NAMES), type);
+            valid = valid && name != std::end(EVENT_NAMES);
+            if (valid) {
+                scripted.event.type = static_cast<InputEventType>(name - std::begin(EVENT_NAMES));
+                scripted.event.code = static_cast<uint16_t>(code);
+                scripted.event.controller = static_cast<uint8_t>(controller);
+                events_.push_back(scripted);
+            }
+        }
+        if (!valid) {
+            Logger::Warning("Ignoring benchmark path line " + std::to_string(lineNumber) + ": " + line);
+        }
+    }
+
+    // Stable, so events of one frame keep their order
+    std::sort(cameraKeys_.begin(), cameraKeys_.end(),
+              [](const CameraKey& a, const CameraKey& b) { return a.time < b.time; });
+    std::stable_sort(events_.begin(), events_.end(),
+                     [](const ScriptedEvent& a, const ScriptedEvent& b) { return a.frame < b.frame; });
+    return true;
+}
+
+void SceneBenchmark::GetCamera(float time, XMFLOAT3& position, XMFLOAT3& target) const {
+    if (cameraKeys_.empty()) {
+        float duration = std::max(measuredFrames_, 1u) * settings_.timeStep;
+        float angle = XM_2PI * time / duration;
+        position = XMFLOAT3(orbitCenter_.x + std::cos(angle) * orbitRadius_, orbitCenter_.y + orbitHeight_,
+                            orbitCenter_.z + std::sin(angle) * orbitRadius_);
+        target = orbitCenter_;
+        return;
+    }
+
+    auto next = std::upper_bound(cameraKeys_.begin(), cameraKeys_.end(), time,
+                                 [](float t, const CameraKey& key) { return t < key.time; });
+    if (next == cameraKeys_.begin() || next == cameraKeys_.end()) {
+        const CameraKey& key = next == cameraKeys_.end() ? cameraKeys_.back() : cameraKeys_.front();
+        position = key.position;
+        target = key.target;
+        return;
+    }
+    const CameraKey& a = *(next - 1);
+    const CameraKey& b = *next;
+    float t = b.time > a.time ? (time - a.time) / (b.time - a.time) : 1.0f;
+    position = Lerp(a.position, b.position, t);
+    target = Lerp(a.target, b.target, t);
+}
+
+void SceneBenchmark::BeginFrame(Engine& engine) {
+    if (frameIndex_ == 0) {
+        GpuProfiler* gpuProfiler = engine.GetGraphics() ? engine.GetGraphics()->GetGpuProfiler() : nullptr;
+        gpuFramesAtStart_ = gpuProfiler ? gpuProfiler->GetResolvedFrameCount() : 0;
+    }
+    if (frameStartNs_ == 0) {
+        frameStartNs_ = Profiler::GetTimeNs();
+    }
+    if (settings_.record) return;
+
+    // Warmup holds the start of the path; past the end the last frame's camera holds
+    const uint32_t frame = frameIndex_ < settings_.warmupFrames ? 0 : frameIndex_ - settings_.warmupFrames;
+    GraphicsDevice* graphics = engine.GetGraphics();
+    if (graphics) {
+        XMFLOAT3 position, target;
+        GetCamera(std::min(frame, measuredFrames_ - 1) * settings_.timeStep, position, target);
+        XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(position.x, position.y, position.z, 1.0f),
+                                         XMVectorSet(target.x, target.y, target.z, 1.0f),
+                                         XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        XMFLOAT4X4 viewMatrix;
+        XMStoreFloat4x4(&viewMatrix, view);
+        graphics->SetViewMatrix(viewMatrix);
+    }
+
+    InputManager* input = engine.GetInput();
+    if (frameIndex_ < settings_.warmupFrames) return;
+    while (nextEvent_ < events_.size() && events_[nextEvent_].frame <= frame) {
+        if (input) input->InjectEvent(events_[nextEvent_].event);
+        ++nextEvent_;
+    }
+}
+
+bool SceneBenchmark::EndFrame(Engine& engine, float cpuMs) {
+    const uint64_t nowNs = Profiler::GetTimeNs();
+    const float frameMs = static_cast<float>(nowNs - frameStartNs_) / 1000000.0f;
+    frameStartNs_ = nowNs;
+    const uint32_t frame = frameIndex_++;
+
+    if (settings_.record) {
+        // The camera as the frame left it, and the input the frame applied
+        if (GraphicsDevice* graphics = engine.GetGraphics()) {
+            XMMATRIX world = XMMatrixInverse(nullptr, XMLoadFloat4x4(&graphics->GetViewMatrix()));
+            CameraKey key;
+            key.time = frame * settings_.timeStep;
+            XMStoreFloat3(&key.position, world.r[3]);
+            XMStoreFloat3(&key.target, XMVectorAdd(world.r[3], world.r[2]));
+            cameraKeys_.push_back(key);
+        }
+        if (InputManager* input = engine.GetInput()) {
+            for (const InputEvent& event : input->GetEvents()) {
+                if (static_cast<size_t>(event.type) < EVENT_NAME_COUNT) {
+                    events_.push_back({ frame, event });
+                }
+            }
+        }
+        return measuredFrames_ == 0 || frameIndex_ < measuredFrames_;
+    }
+
+    RecordGpuFrame(engine);
+    if (frame < settings_.warmupFrames) return true;
+
+    if (frames_.size() < measuredFrames_) {
+        FrameSample sample;
+        sample.frameMs = frameMs;
+        sample.cpuMs = cpuMs;
+        sample.subsystemMs.resize(SUBSYSTEM_COUNT);
+        for (size_t s = 0; s < SUBSYSTEM_COUNT; ++s) {
+            sample.subsystemMs[s] = static_cast<float>(Profiler::GetScopeTimeMs(SUBSYSTEM_SCOPES[s]));
+        }
+        frames_.push_back(std::move(sample));
+        return true;
+    }
+
+    // Past the last frame only while its GPU time is still on the way
+    GpuProfiler* gpuProfiler = engine.GetGraphics() ? engine.GetGraphics()->GetGpuProfiler() : nullptr;
+    bool gpuPending = gpuProfiler && gpuProfiler->IsEnabled() && !frames_.empty() && frames_.back().gpuMs < 0.0f;
+    return gpuPending && ++drainFrames_ < MAX_DRAIN_FRAMES;
+}
+
+void SceneBenchmark::RecordGpuFrame(Engine& engine) {
+    GpuProfiler* gpuProfiler = engine.GetGraphics() ? engine.GetGraphics()->GetGpuProfiler() : nullptr;
+    if (!gpuProfiler) return;
+
+    // The nth frame resolved since the run started is its nth frame
+    const uint64_t resolved = gpuProfiler->GetResolvedFrameCount() - gpuFramesAtStart_;
+    if (resolved <= settings_.warmupFrames) return;
+    const uint64_t index = resolved - 1 - settings_.warmupFrames;
+    if (index >= frames_.size() || frames_[index].gpuMs >= 0.0f) return;
+
+    FrameSample& sample = frames_[index];
+    sample.gpuMs = gpuProfiler->GetLastResolvedFrameTime();
+    for (const GpuProfiler::PassTiming& pass : gpuProfiler->GetLastResolvedPasses()) {
+        sample.gpuPasses.push_back({ pass.name, pass.depth, pass.milliseconds });
+    }
+}
+
+bool SceneBenchmark::Finish() const {
+    return settings_.record ? WritePath() : WriteReport();
+}
+
+bool SceneBenchmark::WritePath() const {
+    std::ofstream file(settings_.pathFile);
+    if (!file) {
+        Logger::Error("Failed to write benchmark path: " + settings_.pathFile);
+        return false;
+    }
+
+    file << "# Scene benchmark path recorded in '" << settings_.scene << "' at " << 1.0f / settings_.timeStep
+         << " frames per second\n" << std::setprecision(7);
+    for (const CameraKey& key : cameraKeys_) {
+        file << "camera " << key.time << ' ' << key.position.x << ' ' << key.position.y << ' ' << key.position.z
+             << ' ' << key.target.x << ' ' << key.target.y << ' ' << key.target.z << '\n';
+    }
+    for (const ScriptedEvent& scripted : events_) {
+        const InputEvent& event = scripted.event;
+        file << "input " << scripted.frame << ' ' << EVENT_NAMES[static_cast<size_t>(event.type)] << ' '
+             << event.code << ' ' << event.x << ' ' << event.y << ' ' << static_cast<int>(event.controller) << '\n';
+    }
+
+    Logger::Info("Recorded " + std::to_string(cameraKeys_.size()) + " frames of benchmark path to " +
+                 settings_.pathFile);
+    return static_cast<bool>(file);
+}
+
+bool SceneBenchmark::WriteReport() const {
+    if (frames_.empty()) {
+        Logger::Warning("Scene benchmark ended before any frame was measured");
+        return false;
+    }
+
+    // Series in report order: frame, CPU, GPU, then the subsystems that ran
+    std::vector<std::pair<std::string, Summary>> series;
+    std::vector<float> values;
+    auto addSeries = [&](const std::string& name, auto value) {
+        values.clear();
+        for (const FrameSample& sample : frames_) {
+            float milliseconds = value(sample);
+            if (milliseconds >= 0.0f) values.push_back(milliseconds);
+        }
+        if (!values.empty()) series.emplace_back(name, Summarize(values));
+    };
+    addSeries("Frame", [](const FrameSample& sample) { return sample.frameMs; });
+    addSeries("CPU", [](const FrameSample& sample) { return sample.cpuMs; });
+    addSeries("GPU", [](const FrameSample& sample) { return sample.gpuMs; });
+    for (size_t s = 0; s < SUBSYSTEM_COUNT; ++s) {
+        bool ran = std::any_of(frames_.begin(), frames_.end(),
+                               [s](const FrameSample& sample) { return sample.subsystemMs[s] > 0.0f; });
+        if (ran) addSeries(SUBSYSTEM_SCOPES[s], [s](const FrameSample& sample) { return sample.subsystemMs[s]; });
+    }
+
+    size_t worst = 0;
+    for (size_t i = 1; i < frames_.size(); ++i) {
+        if (frames_[i].frameMs > frames_[worst].frameMs) worst = i;
+    }
+    const FrameSample& worstFrame = frames_[worst];
+
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(2) << "Scene benchmark '" << settings_.scene << "', "
+            << frames_.size() << " frames (ms p50/p95/p99/max):";
+    for (const auto& entry : series) {
+        summary << "\n  " << std::left << std::setw(20) << entry.first << std::right << std::setw(8)
+                << entry.second.p50 << std::setw(8) << entry.second.p95 << std::setw(8) << entry.second.p99
+                << std::setw(8) << entry.second.max;
+    }
+    summary << "\n  Worst frame " << worst << ": " << worstFrame.frameMs << " ms, CPU " << worstFrame.cpuMs << " ms";
+    if (worstFrame.gpuMs >= 0.0f) summary << ", GPU " << worstFrame.gpuMs << " ms";
+    for (size_t s = 0; s < SUBSYSTEM_COUNT; ++s) {
+        if (worstFrame.subsystemMs[s] > 0.0f) {
+            summary << "\n    " << std::left << std::setw(18) << SUBSYSTEM_SCOPES[s] << std::right << std::setw(8)
+                    << worstFrame.subsystemMs[s];
+        }
+    }
+    Logger::Info(summary.str());
+
+    std::ofstream file(settings_.reportFile);
+    if (!file) {
+        Logger::Error("Failed to write scene benchmark report: " + settings_.reportFile);
+        return false;
+    }
+    file << std::setprecision(6) << "{\"scene\":";
+    WriteJsonString(file, settings_.scene);
+    file << ",\"path\":";
+    WriteJsonString(file, settings_.pathFile);
+    file << ",\"timeStep\":" << settings_.timeStep << ",\"warmupFrames\":" << settings_.warmupFrames
+         << ",\"frames\":" << frames_.size() << ",\"series\":[";
+    for (size_t i = 0; i < series.size(); ++i) {
+        file << (i > 0 ? ",\n" : "\n");
+        WriteJsonSummary(file, series[i].first, series[i].second);
+    }
+    file << "\n],\"worstFrame\":{\"index\":" << worst << ",\"frame\":" << worstFrame.frameMs
+         << ",\"cpu\":" << worstFrame.cpuMs << ",\"gpu\":" << worstFrame.gpuMs << ",\"subsystems\":{";
+    bool first = true;
+    for (size_t s = 0; s < SUBSYSTEM_COUNT; ++s) {
+        if (worstFrame.subsystemMs[s] <= 0.0f) continue;
+        if (!first) file << ',';
+        first = false;
+        WriteJsonString(file, SUBSYSTEM_SCOPES[s]);
+        file << ':' << worstFrame.subsystemMs[s];
+    }
+    file << "},\"gpuPasses\":[";
+    for (size_t p = 0; p < worstFrame.gpuPasses.size(); ++p) {
+        const GpuPass& pass = worstFrame.gpuPasses[p];
+        if (p > 0) file << ',';
+        file << "{\"name\":";
+        WriteJsonString(file, pass.name ? pass.name : "");
+        file << ",\"depth\":" << pass.depth << ",\"ms\":" << pass.milliseconds << '}';
+    }
+    file << "]},\n\"frames\":[";
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        const FrameSample& sample = frames_[i];
+        if (i > 0) file << ',';
+        file << '[' << sample.frameMs << ',' << sample.cpuMs << ',' << sample.gpuMs << ']';
+    }
+    file << "]}\n";
+
+    Logger::Info("Scene benchmark report written to " + settings_.reportFile);
+    return static_cast<bool>(file);
+}
+
+} // namespace Nexus
@@ -0,0 +1,148 @@
+#include "SceneFile.h"
+#include "Logger.h"
+#include "Profiler.h"
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+
+constexpr uint32_t SECTION_NODES = MakeFourCC('N', 'O', 'D', 'E');
+constexpr uint32_t SECTION_POSITIONS = MakeFourCC('T', 'P', 'O', 'S');
+constexpr uint32_t SECTION_ROTATIONS = MakeFourCC('T', 'R', 'O', 'T');
+constexpr uint32_t SECTION_SCALES = MakeFourCC('T', 'S', 'C', 'L');
+constexpr uint32_t SECTION_COMPONENTS = MakeFourCC('C', 'O', 'M', 'P');
+constexpr uint32_t SECTION_STRINGS = MakeFourCC('S', 'T', 'R', 'S');
+
+BinarySchema GetNodeSchema() {
+    return BinarySchema()
+        .Field("parent", BinarySchema::FieldType::I32)
+        .Field("name", BinarySchema::FieldType::Offset)
+        .Field("firstComponent", BinarySchema::FieldType::U32)
+        .Field("componentCount", BinarySchema::FieldType::U32);
+}
+
+BinarySchema GetVectorSchema(uint32_t components) {
+    return BinarySchema().Field("value", BinarySchema::FieldType::F32, components);
+}
+
+BinarySchema GetComponentSchema() {
+    return BinarySchema().Field("type", BinarySchema::FieldType::Offset);
+}
+
+} // namespace
+
+bool SceneFile::Write(const std::string& filename, const std::vector<Node>& nodes, bool compress) {
+    NEXUS_PROFILE_SCOPE("SceneFile::Write");
+
+    BinaryStringTable strings;
+    std::vector<NodeRecord> records;
+    std::vector<XMFLOAT3> positions;
+    std::vector<XMFLOAT4> rotations;
+    std::vector<XMFLOAT3> scales;
+    std::vector<uint32_t> components;
+    records.reserve(nodes.size());
+    positions.reserve(nodes.size());
+    rotations.reserve(nodes.size());
+    scales.reserve(nodes.size());
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const Node& node = nodes[i];
+        if (node.parent >= static_cast<int32_t>(i)) {
+            Logger::Error("Scene node " + node.name + " comes before its parent: " + filename);
+            return false;
+        }
+        records.push_back({ node.parent < 0 ? -1 : node.parent, strings.Add(node.name),
+                            static_cast<uint32_t>(components.size()), static_cast<uint32_t>(node.components.size()) });
+        positions.push_back(node.position);
+        rotations.push_back(node.rotation);
+        scales.push_back(node.scale);
+        for (const std::string& component : node.components) {
+            components.push_back(strings.Add(component));
+        }
+    }
+
+    BinaryFileWriter writer(CONTENT_TYPE, VERSION);
+    writer.AddSection(SECTION_NODES, GetNodeSchema(), records, compress);
+    writer.AddSection(SECTION_POSITIONS, GetVectorSchema(3), positions, compress);
+    writer.AddSection(SECTION_ROTATIONS, GetVectorSchema(4), rotations, compress);
+    writer.AddSection(SECTION_SCALES, GetVectorSchema(3), scales, compress);
+    writer.AddSection(SECTION_COMPONENTS, GetComponentSchema(), components, compress);
+    writer.AddSection(SECTION_STRINGS, BinaryStringTable::GetSchema(), strings.GetBytes(), compress);
+    return writer.Write(filename);
+}
+
+bool SceneFile::Open(const std::string& filename) {
+    NEXUS_PROFILE_SCOPE("SceneFile::Open");
+
+    Close();
+    if (!file_.Open(filename, CONTENT_TYPE)) return false;
+    if (file_.GetContentVersion() != VERSION) {
+        Logger::Warning("Scene file is from another version: " + filename);
+        Close();
+        return false;
+    }
+
+    size_t nodes = 0, positions = 0, rotations = 0, scales = 0, components = 0;
+    records_ = file_.GetSection<NodeRecord>(SECTION_NODES, GetNodeSchema(), nodes, buffers_[0]);
+    positions_ = file_.GetSection<XMFLOAT3>(SECTION_POSITIONS, GetVectorSchema(3), positions, buffers_[1]);
+    rotations_ = file_.GetSection<XMFLOAT4>(SECTION_ROTATIONS, GetVectorSchema(4), rotations, buffers_[2]);
+    scales_ = file_.GetSection<XMFLOAT3>(SECTION_SCALES, GetVectorSchema(3), scales, buffers_[3]);
+    components_ = file_.GetSection<uint32_t>(SECTION_COMPONENTS, GetComponentSchema(), components, buffers_[4]);
+    strings_ = file_.GetSection<char>(SECTION_STRINGS, BinaryStringTable::GetSchema(), stringBytes_, buffers_[5]);
+
+    bool valid = records_ && positions_ && rotations_ && scales_ && components_ && strings_ &&
+                 positions == nodes && rotations == nodes && scales == nodes;
+    // Parents must precede children and component ranges stay in their section, which is what
+    // AddToHierarchy and GetComponent rely on
+    for (size_t i = 0; valid && i < nodes; ++i) {
+        const NodeRecord& record = records_[i];
+        valid = record.parent < static_cast<int64_t>(i) && record.parent >= -1 &&
+                record.firstComponent <= components && record.componentCount <= components - record.firstComponent;
+    }
+    if (!valid) {
+        Logger::Error("Scene file is damaged or from an incompatible build: " + filename);
+        Close();
+        return false;
+    }
+    nodeCount_ = nodes;
+    return true;
+}
+
+void SceneFile::Close() {
+    file_.Close();
+    nodeCount_ = 0;
+    records_ = nullptr;
+    positions_ = nullptr;
+    rotations_ = nullptr;
+    scales_ = nullptr;
+    components_ = nullptr;
+    strings_ = nullptr;
+    stringBytes_ = 0;
+    for (std::vector<uint8_t>& buffer : buffers_) {
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+}
+
+const char* SceneFile::GetName(size_t node) const {
+    return BinaryStringTable::Get(strings_, stringBytes_, records_[node].name);
+}
+
+const char* SceneFile::GetComponent(size_t node, size_t index) const {
+    return BinaryStringTable::Get(strings_, stringBytes_, components_[records_[node].firstComponent + index]);
+}
+
+void SceneFile::AddToHierarchy(TransformHierarchy& hierarchy, std::vector<TransformHierarchy::NodeID>& nodes,
+                               TransformHierarchy::NodeID parent) const {
+    NEXUS_PROFILE_SCOPE("SceneFile::AddToHierarchy");
+
+    nodes.resize(nodeCount_);
+    for (size_t i = 0; i < nodeCount_; ++i) {
+        const int32_t nodeParent = records_[i].parent;
+        nodes[i] = hierarchy.Create(nodeParent < 0 ? parent : nodes[nodeParent], positions_[i], rotations_[i], scales_[i]);
+    }
+}
+
+} // namespace Nexus
@@ -0,0 +1,182 @@
+#include "SessionRecorder.h"
+#include "Logger.h"
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+namespace Nexus {
+
+namespace {
+
+// A session that ends in a crash still keeps all but its last second or so
+constexpr uint64_t FLUSH_INTERVAL_FRAMES = 60;
+
+void WriteVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool ReadVarint(const uint8_t*& cursor, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        if (cursor == end) return false;
+        uint8_t byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Mouse motion is small and either sign; zigzag keeps it to a byte or two
+uint64_t ZigZag(int32_t value) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(value)) << 1) ^ static_cast<uint64_t>(value >> 31);
+}
+
+int32_t UnZigZag(uint64_t value) {
+    return static_cast<int32_t>(static_cast<uint32_t>(value >> 1) ^ (0u - static_cast<uint32_t>(value & 1)));
+}
+
+} // namespace
+
+SessionRecorder::SessionRecorder(const std::string& filename, Mode mode)
+    : filename_(filename)
+    , mode_(mode)
+    , frameCount_(0)
+    , cursor_(0)
+    , replayedSeconds_(0.0)
+{
+}
+
+SessionRecorder::~SessionRecorder() {
+    Close();
+}
+
+bool SessionRecorder::Open(Header& header) {
+    frameCount_ = 0;
+    if (mode_ == Mode::Record) {
+        file_.open(filename_, std::ios::binary | std::ios::trunc);
+        if (!file_) {
+            Logger::Error("Failed to create session recording: " + filename_);
+            return false;
+        }
+        header.magic = MAGIC;
+        header.version = VERSION;
+        file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        Logger::Info("Recording session to " + filename_ + " with seed " + std::to_string(header.randomSeed));
+        return static_cast<bool>(file_);
+    }
+
+    std::ifstream file(filename_, std::ios::binary);
+    if (!file) {
+        Logger::Error("Cannot open session recording: " + filename_);
+        return false;
+    }
+    data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    Header recorded;
+    if (data_.size() < sizeof(recorded)) {
+        Logger::Error("Not a session recording: " + filename_);
+        return false;
+    }
+    std::memcpy(&recorded, data_.data(), sizeof(recorded));
+    if (recorded.magic != MAGIC || recorded.version != VERSION) {
+        Logger::Error("Not a session recording, or from another version: " + filename_);
+        return false;
+    }
+    header = recorded;
+    cursor_ = sizeof(recorded);
+    replayedSeconds_ = 0.0;
+    Logger::Info("Replaying session " + filename_ + (mode_ == Mode::ReplayRealTime ? " in real time" : ""));
+    return true;
+}
+
+void SessionRecorder::Close() {
+    if (file_.is_open()) {
+        file_.close();
+        Logger::Info("Recorded " + std::to_string(frameCount_) + " session frames to " + filename_);
+    }
+    data_.clear();
+    cursor_ = 0;
+}
+
+void SessionRecorder::RecordScriptEvent(const std::string& name) {
+    if (file_.is_open()) {
+        pendingScriptEvents_.push_back(name);
+    }
+}
+
+void SessionRecorder::RecordFrame(float deltaTime, const std::vector<InputEvent>& inputEvents) {
+    if (!file_.is_open()) return;
+
+    encoded_.resize(sizeof(deltaTime));
+    std::memcpy(encoded_.data(), &deltaTime, sizeof(deltaTime));
+    WriteVarint(encoded_, inputEvents.size());
+    for (const InputEvent& event : inputEvents) {
+        encoded_.push_back(static_cast<uint8_t>(event.type));
+        encoded_.push_back(event.controller);
+        WriteVarint(encoded_, event.code);
+        WriteVarint(encoded_, ZigZag(event.x));
+        WriteVarint(encoded_, ZigZag(event.y));
+    }
+    WriteVarint(encoded_, pendingScriptEvents_.size());
+    for (const std::string& name : pendingScriptEvents_) {
+        WriteVarint(encoded_, name.size());
+        encoded_.insert(encoded_.end(), name.begin(), name.end());
+    }
+    pendingScriptEvents_.clear();
+
+    file_.write(reinterpret_cast<const char*>(encoded_.data()), encoded_.size());
+    if (++frameCount_ % FLUSH_INTERVAL_FRAMES == 0) {
+        file_.flush();
+    }
+}
+
+bool SessionRecorder::ReplayFrame(Frame& frame) {
+    const uint8_t* cursor = data_.data() + cursor_;
+    const uint8_t* end = data_.data() + data_.size();
+    if (static_cast<size_t>(end - cursor) < sizeof(frame.deltaTime)) return false;
+
+    std::memcpy(&frame.deltaTime, cursor, sizeof(frame.deltaTime));
+    cursor += sizeof(frame.deltaTime);
+
+    // A recording cut off mid-frame ends at the last whole one
+    uint64_t count = 0;
+    if (!ReadVarint(cursor, end, count)) return false;
+    frame.inputEvents.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        if (end - cursor < 2) return false;
+        InputEvent event = {};
+        event.type = static_cast<InputEventType>(*cursor++);
+        event.controller = *cursor++;
+        uint64_t code = 0, x = 0, y = 0;
+        if (!ReadVarint(cursor, end, code) || !ReadVarint(cursor, end, x) || !ReadVarint(cursor, end, y)) return false;
+        event.code = static_cast<uint16_t>(code);
+        event.x = UnZigZag(x);
+        event.y = UnZigZag(y);
+        frame.inputEvents.push_back(event);
+    }
+    if (!ReadVarint(cursor, end, count)) return false;
+    frame.scriptEvents.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t length = 0;
+        if (!ReadVarint(cursor, end, length) || static_cast<uint64_t>(end - cursor) < length) return false;
+        frame.scriptEvents.emplace_back(reinterpret_cast<const char*>(cursor), static_cast<size_t>(length));
+        cursor += length;
+    }
+    cursor_ = cursor - data_.data();
+
+    // The frame starts when it did in the recording, measured from the first replayed frame
+    if (frameCount_ == 0) {
+        replayStart_ = std::chrono::steady_clock::now();
+    } else if (mode_ == Mode::ReplayRealTime) {
+        std::this_thread::sleep_until(replayStart_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                        std::chrono::duration<double>(replayedSeconds_)));
+    }
+    replayedSeconds_ += frame.deltaTime;
+    ++frameCount_;
+    return true;
+}
+
+} // namespace Nexus
@@ -0,0 +1,347 @@
+#include "TransformHierarchy.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+// Nodes per job when a level is split; smaller levels resolve inline
+constexpr size_t LEVEL_GRAIN = 512;
+
+// Moves element i of values to newIndex[i]
+template <typename T>
+void Permute(std::vector<T>& values, const std::vector<uint32_t>& newIndex) {
+    std::vector<T> sorted(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        sorted[newIndex[i]] = values[i];
+    }
+    values.swap(sorted);
+}
+}
+
+TransformHierarchy::TransformHierarchy()
+    : sorted_(true)
+    , anyDirty_(false)
+    , changedCount_(0)
+{
+}
+
+TransformHierarchy::~TransformHierarchy() = default;
+
+TransformHierarchy::NodeID TransformHierarchy::Create(NodeID parent, const XMFLOAT3& position,
+                                                      const XMFLOAT4& rotation, const XMFLOAT3& scale) {
+    uint32_t parentIndex = INVALID_NODE;
+    if (parent != INVALID_NODE) {
+        parentIndex = GetIndex(parent);
+        if (parentIndex == INVALID_NODE) {
+            Logger::Warning("TransformHierarchy: parent node does not exist, creating a root");
+        }
+    }
+
+    NodeID node;
+    if (!freeIds_.empty()) {
+        node = freeIds_.back();
+        freeIds_.pop_back();
+    } else {
+        node = static_cast<NodeID>(indices_.size());
+        indices_.push_back(INVALID_NODE);
+    }
+
+    // Appended out of depth order; Update() sorts it into its level
+    uint32_t index = static_cast<uint32_t>(parent_.size());
+    indices_[node] = index;
+    parent_.push_back(parentIndex);
+    nodeIds_.push_back(node);
+    position_.push_back(position);
+    rotation_.push_back(rotation);
+    scale_.push_back(scale);
+    world_.emplace_back();
+    dirty_.push_back(1);
+    changed_.push_back(0);
+
+    sorted_ = false;
+    anyDirty_ = true;
+    return node;
+}
+
+void TransformHierarchy::Destroy(NodeID node) {
+    uint32_t index = GetIndex(node);
+    if (index == INVALID_NODE) return;
+
+    // In depth order the subtree is the node plus later entries whose parent is in it
+    if (!sorted_) {
+        Sort();
+        index = indices_[node];
+    }
+    size_t count = parent_.size();
+    std::vector<uint8_t> removed(count, 0);
+    removed[index] = 1;
+    for (size_t i = index + 1; i < count; ++i) {
+        if (parent_[i] != INVALID_NODE && removed[parent_[i]]) removed[i] = 1;
+    }
+
+    std::vector<uint32_t> newIndex(count, INVALID_NODE);
+    uint32_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (removed[i]) {
+            indices_[nodeIds_[i]] = INVALID_NODE;
+            freeIds_.push_back(nodeIds_[i]);
+            continue;
+        }
+        newIndex[i] = kept;
+        // Order is preserved, so a parent is always moved before its children read it
+        uint32_t parent = parent_[i];
+        parent_[kept] = parent == INVALID_NODE ? INVALID_NODE : newIndex[parent];
+        nodeIds_[kept] = nodeIds_[i];
+        position_[kept] = position_[i];
+        rotation_[kept] = rotation_[i];
+        scale_[kept] = scale_[i];
+        world_[kept] = world_[i];
+        dirty_[kept] = dirty_[i];
+        changed_[kept] = changed_[i];
+        indices_[nodeIds_[kept]] = kept;
+        kept++;
+    }
+    parent_.resize(kept);
+    nodeIds_.resize(kept);
+    position_.resize(kept);
+    rotation_.resize(kept);
+    scale_.resize(kept);
+    world_.resize(kept);
+    dirty_.resize(kept);
+    changed_.resize(kept);
+
+    // Depths are unchanged but the level boundaries moved
+    sorted_ = false;
+}
+
+void TransformHierarchy::Clear() {
+    parent_.clear();
+    nodeIds_.clear();
+    position_.clear();
+    rotation_.clear();
+    scale_.clear();
+    world_.clear();
+    dirty_.clear();
+    changed_.clear();
+    levelStart_.clear();
+    indices_.clear();
+    freeIds_.clear();
+    sorted_ = true;
+    anyDirty_ = false;
+    changedCount_ = 0;
+}
+
+bool TransformHierarchy::SetParent(NodeID node, NodeID parent) {
+    uint32_t index = GetIndex(node);
+    if (index == INVALID_NODE) return false;
+
+    uint32_t parentIndex = INVALID_NODE;
+    if (parent != INVALID_NODE) {
+        parentIndex = GetIndex(parent);
+        if (parentIndex == INVALID_NODE) return false;
+        for (uint32_t ancestor = parentIndex; ancestor != INVALID_NODE; ancestor = parent_[ancestor]) {
+            if (ancestor == index) {
+                Logger::Warning("TransformHierarchy: cannot parent a node under its own subtree");
+                return false;
+            }
+        }
+    }
+    if (parent_[index] == parentIndex) return true;
+
+    // The local transform is kept, so the subtree moves with its new parent
+    parent_[index] = parentIndex;
+    dirty_[index] = 1;
+    sorted_ = false;
+    anyDirty_ = true;
+    return true;
+}
+
+TransformHierarchy::NodeID TransformHierarchy::GetParent(NodeID node) const {
+    uint32_t index = GetIndex(node);
+    if (index == INVALID_NODE || parent_[index] == INVALID_NODE) return INVALID_NODE;
+    return nodeIds_[parent_[index]];
+}
+
+bool TransformHierarchy::IsValid(NodeID node) const {
+    return GetIndex(node) != INVALID_NODE;
+}
+
+void TransformHierarchy::SetLocalTransform(NodeID node, const XMFLOAT3& position, const XMFLOAT4& rotation,
+                                           const XMFLOAT3& scale) {
+    uint32_t index = GetIndex(node);
+    if (index == INVALID_NODE) return;
+    position_[index] = position;
+    rotation_[index] = rotation;
+    scale_[index] = scale;
+    dirty_[index] = 1;
+    anyDirty_ = true;
+}
+
+void TransformHierarchy::SetLocalPosition(NodeID node, const XMFLOAT3& position) {
+    uint32_t index = GetIndex(node);
+    if (index == INVALID_NODE) return;
+    position_[index] = position;
+    dirty_[index] = 1;
+    anyDirty_ = true;
+}
+
+void TransformHierarchy::SetLocalRotation(NodeID node, const XMFLOAT4& rotation) {
+    uint32_t index = GetIndex(node);
+    if (index == INVALID_NODE) return;
+    rotation_[index] = rotation;
+    dirty_[index] = 1;
+    anyDirty_ = true;
+}
+
+void TransformHierarchy::SetLocalScale(NodeID node, const XMFLOAT3& scale) {
+    uint32_t index = GetIndex(node);
+    if (index == INVALID_NODE) return;
+    scale_[index] = scale;
+    dirty_[index] = 1;
+    anyDirty_ = true;
+}
+
+XMFLOAT3 TransformHierarchy::GetLocalPosition(NodeID node) const {
+    uint32_t index = GetIndex(node);
+    return index == INVALID_NODE ? XMFLOAT3(0.0f, 0.0f, 0.0f) : position_[index];
+}
+
+XMFLOAT4 TransformHierarchy::GetLocalRotation(NodeID node) const {
+    uint32_t index = GetIndex(node);
+    return index == INVALID_NODE ? XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f) : rotation_[index];
+}
+
+XMFLOAT3 TransformHierarchy::GetLocalScale(NodeID node) const {
+    uint32_t index = GetIndex(node);
+    return index == INVALID_NODE ? XMFLOAT3(1.0f, 1.0f, 1.0f) : scale_[index];
+}
+
+void TransformHierarchy::Update(JobSystem* jobs) {
+    NEXUS_PROFILE_SCOPE("Transforms::Update");
+    if (!sorted_) Sort();
+
+    // Nothing moved: only last frame's changed flags need clearing
+    if (!anyDirty_) {
+        if (changedCount_ > 0) {
+            std::fill(changed_.begin(), changed_.end(), 0);
+            changedCount_ = 0;
+        }
+        return;
+    }
+
+    for (size_t level = 0; level + 1 < levelStart_.size(); ++level) {
+        size_t begin = levelStart_[level];
+        size_t end = levelStart_[level + 1];
+        if (jobs && end - begin > LEVEL_GRAIN) {
+            jobs->ParallelFor(end - begin, LEVEL_GRAIN, [this, begin](size_t first, size_t last) {
+                UpdateLevel(begin + first, begin + last);
+            });
+        } else {
+            UpdateLevel(begin, end);
+        }
+    }
+
+    changedCount_ = 0;
+    for (size_t i = 0; i < dirty_.size(); ++i) {
+        changedCount_ += changed_[i];
+        dirty_[i] = 0;
+    }
+    anyDirty_ = false;
+}
+
+XMMATRIX TransformHierarchy::GetWorldMatrix(NodeID node) const {
+    uint32_t index = GetIndex(node);
+    return index == INVALID_NODE ? XMMatrixIdentity() : XMLoadFloat4x4A(&world_[index]);
+}
+
+XMFLOAT3 TransformHierarchy::GetWorldPosition(NodeID node) const {
+    uint32_t index = GetIndex(node);
+    if (index == INVALID_NODE) return XMFLOAT3(0.0f, 0.0f, 0.0f);
+    const XMFLOAT4X4A& world = world_[index];
+    return XMFLOAT3(world._41, world._42, world._43);
+}
+
+bool TransformHierarchy::WasChanged(NodeID node) const {
+    uint32_t index = GetIndex(node);
+    return index != INVALID_NODE && changed_[index] != 0;
+}
+
+void TransformHierarchy::Sort() {
+    size_t count = parent_.size();
+
+    // Depth of each node, walking up only as far as the first ancestor already resolved
+    std::vector<uint32_t> depth(count, INVALID_NODE);
+    std::vector<uint32_t> chain;
+    uint32_t maxDepth = 0;
+    for (size_t i = 0; i < count; ++i) {
+        chain.clear();
+        uint32_t node = static_cast<uint32_t>(i);
+        while (node != INVALID_NODE && depth[node] == INVALID_NODE) {
+            chain.push_back(node);
+            node = parent_[node];
+        }
+        uint32_t next = node == INVALID_NODE ? 0 : depth[node] + 1;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            depth[*it] = next++;
+        }
+        if (!chain.empty()) maxDepth = std::max(maxDepth, next - 1);
+    }
+
+    // Counting sort by depth, stable so siblings keep their creation order
+    levelStart_.assign(count > 0 ? maxDepth + 2 : 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        levelStart_[depth[i] + 1]++;
+    }
+    for (size_t level = 1; level < levelStart_.size(); ++level) {
+        levelStart_[level] += levelStart_[level - 1];
+    }
+    std::vector<uint32_t> next(levelStart_.begin(), levelStart_.end() - 1);
+    std::vector<uint32_t> newIndex(count);
+    for (size_t i = 0; i < count; ++i) {
+        newIndex[i] = next[depth[i]]++;
+    }
+
+    for (uint32_t& parent : parent_) {
+        if (parent != INVALID_NODE) parent = newIndex[parent];
+    }
+    Permute(parent_, newIndex);
+    Permute(nodeIds_, newIndex);
+    Permute(position_, newIndex);
+    Permute(rotation_, newIndex);
+    Permute(scale_, newIndex);
+    Permute(world_, newIndex);
+    Permute(dirty_, newIndex);
+    Permute(changed_, newIndex);
+    for (size_t i = 0; i < count; ++i) {
+        indices_[nodeIds_[i]] = static_cast<uint32_t>(i);
+    }
+    sorted_ = true;
+}
+
+void TransformHierarchy::UpdateLevel(size_t begin, size_t end) {
+    // Parents are on the level above and final by now
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t parent = parent_[i];
+        bool recompute = dirty_[i] || (parent != INVALID_NODE && changed_[parent]);
+        changed_[i] = recompute ? 1 : 0;
+        if (!recompute) continue;
+
+        XMMATRIX world = XMMatrixAffineTransformation(XMLoadFloat3(&scale_[i]), XMVectorZero(),
+                                                      XMLoadFloat4(&rotation_[i]), XMLoadFloat3(&position_[i]));
+        if (parent != INVALID_NODE) {
+            world = XMMatrixMultiply(world, XMLoadFloat4x4A(&world_[parent]));
+        }
+        XMStoreFloat4x4A(&world_[i], world);
+    }
+}
+
+uint32_t TransformHierarchy::GetIndex(NodeID node) const {
+    return node < indices_.size() ? indices_[node] : INVALID_NODE;
+}
+
+} // namespace Nexus
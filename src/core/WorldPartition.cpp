@@ -0,0 +1,479 @@
+#include "WorldPartition.h"
+#include "ResourceManager.h"
+#include "PhysicsEngine.h"
+#include "AISystem.h"
+#include "NavMesh.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace Nexus {
+
+namespace {
+constexpr int WORLD_VERSION = 1;
+
+bool IsAbsolutePath(const std::string& path) {
+    return !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+}
+
+std::string ResolvePath(const std::string& directory, const std::string& path) {
+    return IsAbsolutePath(path) ? path : directory + path;
+}
+}
+
+WorldPartition::WorldPartition()
+    : resources_(nullptr)
+    , physics_(nullptr)
+    , ai_(nullptr)
+    , cellSize_(0.0f)
+    , shutdownRequested_(false)
+    , loadsInFlight_(0)
+{
+}
+
+WorldPartition::~WorldPartition() {
+    Shutdown();
+}
+
+void WorldPartition::Initialize(ResourceManager* resources, PhysicsEngine* physics, AIManager* ai) {
+    resources_ = resources;
+    physics_ = physics;
+    ai_ = ai;
+
+    if (!loaderThread_.joinable()) {
+        shutdownRequested_ = false;
+        loaderThread_ = std::thread(&WorldPartition::LoaderThread, this);
+    }
+}
+
+void WorldPartition::Shutdown() {
+    Close();
+
+    if (loaderThread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(loadQueueMutex_);
+            shutdownRequested_ = true;
+        }
+        loadQueueCondition_.notify_all();
+        loaderThread_.join();
+    }
+    completedLoads_.clear();
+    loadsInFlight_ = 0;
+}
+
+bool WorldPartition::Open(const std::string& filename) {
+    Close();
+
+    std::ifstream file(filename);
+    if (!file) {
+        Logger::Error("Could not open world: " + filename);
+        return false;
+    }
+
+    const size_t slash = filename.find_last_of("/\\");
+    directory_ = slash == std::string::npos ? std::string() : filename.substr(0, slash + 1);
+
+    std::string line;
+    float cellSize = 0.0f;
+    bool versioned = false;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string tag;
+        if (!(fields >> tag) || tag[0] == '#') continue;
+
+        if (tag == "world") {
+            int version = 0;
+            fields >> version;
+            if (version != WORLD_VERSION) {
+                Logger::Error("Unsupported world version " + std::to_string(version) + ": " + filename);
+                cells_.clear();
+                return false;
+            }
+            versioned = true;
+        } else if (tag == "cellSize") {
+            fields >> cellSize;
+        } else if (tag == "cell") {
+            Cell cell;
+            std::string manifest;
+            if (!(fields >> cell.x >> cell.z >> manifest)) {
+                Logger::Warning("Malformed cell in " + filename + ": " + line);
+                continue;
+            }
+            cell.manifest = ResolvePath(directory_, manifest);
+            cells_[GetCellKey(cell.x, cell.z)] = std::move(cell);
+        }
+    }
+
+    if (!versioned || cellSize <= 0.0f) {
+        Logger::Error("Not a world index: " + filename);
+        cells_.clear();
+        return false;
+    }
+
+    cellSize_ = cellSize;
+    stats_ = Stats();
+    // Frozen bodies are found by the same cells
+    if (physics_) {
+        PhysicsEngine::SimulationRegions regions = physics_->GetSimulationRegions();
+        regions.cellSize = cellSize_;
+        physics_->SetSimulationRegions(regions);
+    }
+    stats_.cells = static_cast<uint32_t>(cells_.size());
+    Logger::Info("Opened world " + filename + ": " + std::to_string(cells_.size()) + " cells of " +
+                 std::to_string(cellSize_) + " units");
+    return true;
+}
+
+void WorldPartition::Close() {
+    for (uint64_t key : residentCells_) {
+        UnloadCell(cells_[key]);
+    }
+    residentCells_.clear();
+    cells_.clear();
+    cellSize_ = 0.0f;
+    stats_ = Stats();
+
+    // Loads already on the loader thread finish and are dropped in FinishLoads()
+    std::lock_guard<std::mutex> lock(loadQueueMutex_);
+    loadsInFlight_ -= static_cast<uint32_t>(loadQueue_.size());
+    loadQueue_.clear();
+}
+
+void WorldPartition::SetSettings(const Settings& settings) {
+    settings_ = settings;
+    settings_.unloadRadius = std::max(settings_.unloadRadius, settings_.loadRadius);
+    settings_.maxLoadsInFlight = std::max(settings_.maxLoadsInFlight, 1u);
+}
+
+void WorldPartition::SetStreamingSource(uint32_t id, const DirectX::XMFLOAT3& position) {
+    if (physics_) physics_->SetSimulationFocus(id, position);
+    for (Source& source : sources_) {
+        if (source.id == id) {
+            source.position = position;
+            return;
+        }
+    }
+    sources_.push_back({ id, position });
+}
+
+void WorldPartition::RemoveStreamingSource(uint32_t id) {
+    if (physics_) physics_->RemoveSimulationFocus(id);
+    sources_.erase(std::remove_if(sources_.begin(), sources_.end(),
+                                  [id](const Source& source) { return source.id == id; }),
+                   sources_.end());
+}
+
+bool WorldPartition::IsCellActive(int32_t x, int32_t z) const {
+    auto it = cells_.find(GetCellKey(x, z));
+    return it != cells_.end() && it->second.state == CellState::Active;
+}
+
+float WorldPartition::GetDistance(const Cell& cell) const {
+    // To the nearest point of the cell's square on the ground plane
+    const float minX = cell.x * cellSize_, maxX = minX + cellSize_;
+    const float minZ = cell.z * cellSize_, maxZ = minZ + cellSize_;
+    float nearest = std::numeric_limits<float>::max();
+    for (const Source& source : sources_) {
+        const float dx = std::max({ minX - source.position.x, 0.0f, source.position.x - maxX });
+        const float dz = std::max({ minZ - source.position.z, 0.0f, source.position.z - maxZ });
+        nearest = std::min(nearest, std::sqrt(dx * dx + dz * dz));
+    }
+    return nearest;
+}
+
+WorldPartition::Cell* WorldPartition::FindCell(int32_t x, int32_t z) {
+    auto it = cells_.find(GetCellKey(x, z));
+    return it != cells_.end() ? &it->second : nullptr;
+}
+
+void WorldPartition::Update() {
+    if (!IsOpen()) return;
+    NEXUS_PROFILE_SCOPE("WorldPartition::Update");
+
+    FinishLoads();
+    RequestLoads();
+    ActivateCells();
+    UpdateNavMesh();
+
+    stats_.loading = stats_.ready = stats_.active = 0;
+    for (uint64_t key : residentCells_) {
+        const CellState state = cells_[key].state;
+        if (state == CellState::Loading) ++stats_.loading;
+        else if (state == CellState::Ready) ++stats_.ready;
+        else if (state == CellState::Active) ++stats_.active;
+    }
+}
+
+void WorldPartition::RequestLoads() {
+    // Resident cells the sources have moved away from go first, so their memory is free before
+    // new cells come in
+    for (size_t i = 0; i < residentCells_.size();) {
+        Cell& cell = cells_[residentCells_[i]];
+        cell.distance = GetDistance(cell);
+        if (cell.distance > settings_.unloadRadius) {
+            UnloadCell(cell);
+            residentCells_[i] = residentCells_.back();
+            residentCells_.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    if (loadsInFlight_ >= settings_.maxLoadsInFlight) return;
+
+    // Only the cells around each source are looked at, not the whole world
+    std::vector<Cell*> candidates;
+    for (const Source& source : sources_) {
+        const int32_t minX = static_cast<int32_t>(std::floor((source.position.x - settings_.loadRadius) / cellSize_));
+        const int32_t maxX = static_cast<int32_t>(std::floor((source.position.x + settings_.loadRadius) / cellSize_));
+        const int32_t minZ = static_cast<int32_t>(std::floor((source.position.z - settings_.loadRadius) / cellSize_));
+        const int32_t maxZ = static_cast<int32_t>(std::floor((source.position.z + settings_.loadRadius) / cellSize_));
+        for (int32_t z = minZ; z <= maxZ; ++z) {
+            for (int32_t x = minX; x <= maxX; ++x) {
+                Cell* cell = FindCell(x, z);
+                if (!cell || cell->state != CellState::Unloaded) continue;
+                cell->distance = GetDistance(*cell);
+                if (cell->distance <= settings_.loadRadius) candidates.push_back(cell);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Cell* a, const Cell* b) {
+        return a->distance < b->distance || (a->distance == b->distance && a < b);
+    });
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    size_t queued = 0;
+    for (Cell* cell : candidates) {
+        if (loadsInFlight_ >= settings_.maxLoadsInFlight) break;
+        auto load = std::make_shared<CellLoad>();
+        load->cellKey = GetCellKey(cell->x, cell->z);
+        load->manifestPath = cell->manifest;
+        load->directory = directory_;
+        cell->load = load;
+        cell->state = CellState::Loading;
+        residentCells_.push_back(load->cellKey);
+
+        std::lock_guard<std::mutex> lock(loadQueueMutex_);
+        loadQueue_.push_back(std::move(load));
+        ++loadsInFlight_;
+        ++queued;
+    }
+    if (queued > 0) loadQueueCondition_.notify_one();
+}
+
+void WorldPartition::FinishLoads() {
+    std::vector<std::shared_ptr<CellLoad>> completed;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex_);
+        completed.swap(completedLoads_);
+    }
+
+    for (std::shared_ptr<CellLoad>& load : completed) {
+        --loadsInFlight_;
+        auto it = cells_.find(load->cellKey);
+        // Unloaded while it was loading, or from a world since closed
+        if (it == cells_.end() || it->second.load != load) continue;
+
+        if (load->failed) {
+            // Kept resident but empty, so it isn't retried every frame
+            Logger::Warning("Could not load world cell: " + load->manifestPath);
+            *load = CellLoad();
+        }
+        load->completed = true;
+        AcquireResources(it->second);
+    }
+
+    for (uint64_t key : residentCells_) {
+        Cell& cell = cells_[key];
+        if (cell.state == CellState::Loading && cell.load->completed && cell.load->pendingResources == 0) {
+            cell.state = CellState::Ready;
+        }
+    }
+}
+
+void WorldPartition::AcquireResources(Cell& cell) {
+    if (!resources_) return;
+    const std::shared_ptr<CellLoad>& load = cell.load;
+
+    // Callbacks of resources already loaded run right away, so count them all first
+    load->pendingResources = static_cast<uint32_t>(load->meshes.size() + load->textures.size());
+    for (const ResourceDesc& mesh : load->meshes) {
+        resources_->LoadMeshAsync(mesh.name, mesh.filename, [load](std::shared_ptr<Mesh>) { --load->pendingResources; });
+        const MeshHandle handle = resources_->AcquireMesh(mesh.name);
+        if (handle.IsValid()) cell.meshes.push_back(handle);
+    }
+    for (const ResourceDesc& texture : load->textures) {
+        resources_->LoadTextureAsync(texture.name, texture.filename,
+                                     [load](std::shared_ptr<Texture>) { --load->pendingResources; });
+        const TextureHandle handle = resources_->AcquireTexture(texture.name);
+        if (handle.IsValid()) cell.textures.push_back(handle);
+    }
+}
+
+void WorldPartition::ActivateCells() {
+    std::vector<Cell*> ready;
+    for (uint64_t key : residentCells_) {
+        Cell& cell = cells_[key];
+        if (cell.state == CellState::Ready) ready.push_back(&cell);
+    }
+    stats_.activatedThisFrame = 0;
+    stats_.activationMs = 0.0f;
+    if (ready.empty()) return;
+
+    std::sort(ready.begin(), ready.end(), [](const Cell* a, const Cell* b) { return a->distance < b->distance; });
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::microseconds(static_cast<int64_t>(settings_.activationBudgetMs * 1000.0f));
+    uint32_t created = 0;
+    for (Cell* cell : ready) {
+        if (created > 0 && std::chrono::steady_clock::now() >= deadline) break;
+        if (ActivateCell(*cell, deadline, created)) {
+            cell->state = CellState::Active;
+        }
+    }
+
+    stats_.activatedThisFrame = created;
+    stats_.activationMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool WorldPartition::ActivateCell(Cell& cell, const std::chrono::steady_clock::time_point& deadline, uint32_t& created) {
+    const CellLoad& load = *cell.load;
+
+    // What is already in stays in, so activation picks up where the last frame's budget ran out
+    bool outOfTime = false;
+    if (physics_) {
+        while (!outOfTime && cell.bodies.size() < load.bodies.size()) {
+            const BodyDesc& body = load.bodies[cell.bodies.size()];
+            const CollisionShape shape = body.sphere ? CollisionShape::CreateSphere(body.size.x)
+                                                     : CollisionShape::CreateBox(body.size);
+            PhysicsTransform transform;
+            transform.position = body.position;
+            cell.bodies.push_back(physics_->CreateRigidBody(shape, transform, body.mass));
+            ++created;
+            outOfTime = std::chrono::steady_clock::now() >= deadline;
+        }
+    }
+    if (ai_) {
+        while (!outOfTime && cell.agents.size() < load.agents.size()) {
+            cell.agents.push_back(ai_->CreateAIEntity(load.agents[cell.agents.size()]));
+            ++created;
+            outOfTime = std::chrono::steady_clock::now() >= deadline;
+        }
+    }
+    return (!physics_ || cell.bodies.size() == load.bodies.size()) && (!ai_ || cell.agents.size() == load.agents.size());
+}
+
+void WorldPartition::UnloadCell(Cell& cell) {
+    if (physics_) {
+        for (RigidBodyID body : cell.bodies) physics_->RemoveRigidBody(body);
+    }
+    if (ai_) {
+        for (const std::shared_ptr<AIEntity>& agent : cell.agents) {
+            if (agent) ai_->RemoveAIEntity(agent);
+        }
+        if (cell.load && cell.load->navMesh && cell.load->navMesh == currentNavMesh_) {
+            ai_->SetNavMesh(nullptr);
+            currentNavMesh_.reset();
+        }
+    }
+    // Released resources stay cached until the memory budgets evict them
+    if (resources_) {
+        for (MeshHandle mesh : cell.meshes) resources_->ReleaseMesh(mesh);
+        for (TextureHandle texture : cell.textures) resources_->ReleaseTexture(texture);
+    }
+
+    cell.bodies.clear();
+    cell.agents.clear();
+    cell.meshes.clear();
+    cell.textures.clear();
+    cell.load.reset();
+    cell.state = CellState::Unloaded;
+}
+
+void WorldPartition::UpdateNavMesh() {
+    if (!ai_ || sources_.empty()) return;
+
+    const DirectX::XMFLOAT3& position = sources_.front().position;
+    const Cell* cell = FindCell(static_cast<int32_t>(std::floor(position.x / cellSize_)),
+                                static_cast<int32_t>(std::floor(position.z / cellSize_)));
+    // Between cells, or in one not active yet, the last navmesh stays
+    if (!cell || cell->state != CellState::Active || !cell->load->navMesh) return;
+    if (cell->load->navMesh != currentNavMesh_) {
+        currentNavMesh_ = cell->load->navMesh;
+        ai_->SetNavMesh(currentNavMesh_);
+    }
+}
+
+void WorldPartition::LoaderThread() {
+    for (;;) {
+        std::shared_ptr<CellLoad> load;
+        {
+            std::unique_lock<std::mutex> lock(loadQueueMutex_);
+            loadQueueCondition_.wait(lock, [this] { return shutdownRequested_ || !loadQueue_.empty(); });
+            if (shutdownRequested_) return;
+            load = std::move(loadQueue_.front());
+            loadQueue_.pop_front();
+        }
+
+        load->failed = !ReadManifest(*load);
+
+        std::lock_guard<std::mutex> lock(completedMutex_);
+        completedLoads_.push_back(std::move(load));
+    }
+}
+
+bool WorldPartition::ReadManifest(CellLoad& load) {
+    std::ifstream file(load.manifestPath);
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string tag;
+        if (!(fields >> tag) || tag[0] == '#') continue;
+
+        bool valid = true;
+        if (tag == "mesh" || tag == "texture") {
+            ResourceDesc resource;
+            valid = static_cast<bool>(fields >> resource.name >> resource.filename);
+            if (valid) (tag == "mesh" ? load.meshes : load.textures).push_back(std::move(resource));
+        } else if (tag == "box") {
+            BodyDesc body;
+            valid = static_cast<bool>(fields >> body.position.x >> body.position.y >> body.position.z >>
+                                      body.size.x >> body.size.y >> body.size.z >> body.mass);
+            if (valid) load.bodies.push_back(body);
+        } else if (tag == "sphere") {
+            BodyDesc body;
+            body.sphere = true;
+            valid = static_cast<bool>(fields >> body.position.x >> body.position.y >> body.position.z >>
+                                      body.size.x >> body.mass);
+            if (valid) load.bodies.push_back(body);
+        } else if (tag == "navmesh") {
+            valid = static_cast<bool>(fields >> load.navMeshPath);
+        } else if (tag == "agent") {
+            DirectX::XMFLOAT3 position;
+            valid = static_cast<bool>(fields >> position.x >> position.y >> position.z);
+            if (valid) load.agents.push_back(position);
+        }
+        if (!valid) {
+            Logger::Warning("Malformed line in " + load.manifestPath + ": " + line);
+        }
+    }
+
+    // The navmesh is the heavy part and is only read, never shared with another cell
+    if (!load.navMeshPath.empty()) {
+        auto navMesh = std::make_shared<NavMesh>();
+        if (navMesh->Load(ResolvePath(load.directory, load.navMeshPath))) {
+            load.navMesh = std::move(navMesh);
+        } else {
+            Logger::Warning("Could not load navmesh " + load.navMeshPath + " of " + load.manifestPath);
+        }
+    }
+    return true;
+}
+
+} // namespace Nexus
@@ -1,23 +1,144 @@
 #include "AnimationSystem.h"
 #include "Camera.h"
+#include "CompressedAnimation.h"
+#include "JobSystem.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
+#include <iterator>
+#include <xmmintrin.h>
 
 namespace Nexus {
 
+namespace {
+
+using Pose = AnimationSystem::Pose;
+
+bool IsRotationStream(int stream) {
+    return stream >= Pose::ROTATION_X && stream <= Pose::ROTATION_W;
+}
+
+// target = target * targetWeight + source * sourceWeight, four bones at a time. Source rotations
+// on the far hemisphere from the target's are negated so the blend takes the short way round;
+// rotations come out unnormalized
+void BlendPoseGroups(Pose& target, const Pose& source, float targetWeight, float sourceWeight) {
+    const __m128 tw = _mm_set1_ps(targetWeight);
+    const __m128 sw = _mm_set1_ps(sourceWeight);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    for (size_t i = 0; i < target.stride; i += 4) {
+        __m128 dot = _mm_setzero_ps();
+        for (int c = Pose::ROTATION_X; c <= Pose::ROTATION_W; ++c) {
+            const Pose::Stream stream = Pose::Stream(c);
+            dot = _mm_add_ps(dot, _mm_mul_ps(_mm_loadu_ps(target[stream] + i), _mm_loadu_ps(source[stream] + i)));
+        }
+        const __m128 rotationWeight = _mm_xor_ps(sw, _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signBit));
+        for (int c = 0; c < Pose::STREAM_COUNT; ++c) {
+            const Pose::Stream stream = Pose::Stream(c);
+            float* t = target[stream] + i;
+            const __m128 weighted = _mm_mul_ps(_mm_loadu_ps(source[stream] + i), IsRotationStream(c) ? rotationWeight : sw);
+            _mm_storeu_ps(t, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(t), tw), weighted));
+        }
+    }
+}
+
+// A rotation that blended away to nothing becomes the identity
+void NormalizePoseRotations(Pose& pose) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 epsilon = _mm_set1_ps(1e-12f);
+    float* rx = pose[Pose::ROTATION_X];
+    float* ry = pose[Pose::ROTATION_Y];
+    float* rz = pose[Pose::ROTATION_Z];
+    float* rw = pose[Pose::ROTATION_W];
+    for (size_t i = 0; i < pose.stride; i += 4) {
+        const __m128 x = _mm_loadu_ps(rx + i);
+        const __m128 y = _mm_loadu_ps(ry + i);
+        const __m128 z = _mm_loadu_ps(rz + i);
+        const __m128 w = _mm_loadu_ps(rw + i);
+        const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                           _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+        const __m128 valid = _mm_cmpgt_ps(lengthSq, epsilon);
+        const __m128 scale = _mm_and_ps(valid, _mm_div_ps(one, _mm_sqrt_ps(lengthSq)));
+        _mm_storeu_ps(rx + i, _mm_mul_ps(x, scale));
+        _mm_storeu_ps(ry + i, _mm_mul_ps(y, scale));
+        _mm_storeu_ps(rz + i, _mm_mul_ps(z, scale));
+        _mm_storeu_ps(rw + i, _mm_or_ps(_mm_mul_ps(w, scale), _mm_andnot_ps(valid, one)));
+    }
+}
+
+// Local matrices of the four bones from first: scale, then rotate, then translate, as
+// XMMatrixAffineTransformation composes them. Rows are built across the group and transposed out
+void ComposeGroup(const Pose& pose, size_t first, XMFLOAT4X4 local[4]) {
+    const __m128 x = _mm_loadu_ps(pose[Pose::ROTATION_X] + first);
+    const __m128 y = _mm_loadu_ps(pose[Pose::ROTATION_Y] + first);
+    const __m128 z = _mm_loadu_ps(pose[Pose::ROTATION_Z] + first);
+    const __m128 w = _mm_loadu_ps(pose[Pose::ROTATION_W] + first);
+    const __m128 sx = _mm_loadu_ps(pose[Pose::SCALE_X] + first);
+    const __m128 sy = _mm_loadu_ps(pose[Pose::SCALE_Y] + first);
+    const __m128 sz = _mm_loadu_ps(pose[Pose::SCALE_Z] + first);
+    
+    const __m128 x2 = _mm_add_ps(x, x);
+    const __m128 y2 = _mm_add_ps(y, y);
+    const __m128 z2 = _mm_add_ps(z, z);
+    const __m128 xx = _mm_mul_ps(x, x2);
+    const __m128 yy = _mm_mul_ps(y, y2);
+    const __m128 zz = _mm_mul_ps(z, z2);
+    const __m128 xy = _mm_mul_ps(x, y2);
+    const __m128 xz = _mm_mul_ps(x, z2);
+    const __m128 yz = _mm_mul_ps(y, z2);
+    const __m128 wx = _mm_mul_ps(w, x2);
+    const __m128 wy = _mm_mul_ps(w, y2);
+    const __m128 wz = _mm_mul_ps(w, z2);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    
+    __m128 rows[4][4] = {
+        { _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx), _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+          _mm_mul_ps(_mm_sub_ps(xz, wy), sx), zero },
+        { _mm_mul_ps(_mm_sub_ps(xy, wz), sy), _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+          _mm_mul_ps(_mm_add_ps(yz, wx), sy), zero },
+        { _mm_mul_ps(_mm_add_ps(xz, wy), sz), _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+          _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz), zero },
+        { _mm_loadu_ps(pose[Pose::TRANSLATION_X] + first), _mm_loadu_ps(pose[Pose::TRANSLATION_Y] + first),
+          _mm_loadu_ps(pose[Pose::TRANSLATION_Z] + first), one },
+    };
+    for (int row = 0; row < 4; ++row) {
+        _MM_TRANSPOSE4_PS(rows[row][0], rows[row][1], rows[row][2], rows[row][3]);
+        for (int bone = 0; bone < 4; ++bone) {
+            _mm_storeu_ps(&local[bone]._11 + row * 4, rows[row][bone]);
+        }
+    }
+}
+
+} // namespace
+
 AnimationSystem::AnimationSystem()
     : device_(nullptr)
+    , cameraPosition_(0.0f, 0.0f, 0.0f)
+    , pixelsPerUnit_(0.0f)
+    , animationFrame_(0)
     , lodLevel_(0)
     , cullingEnabled_(true)
     , maxAnimationDistance_(100.0f)
     , debugVisualization_(false)
-    , multithreadingEnabled_(false)
+    , jobs_(nullptr)
+    , multithreadingEnabled_(true)
+    , characterScheduleDirty_(true)
+    , characterDeltaTime_(0.0f)
     , compressionEnabled_(false)
     , positionTolerance_(0.001f)
     , rotationTolerance_(0.001f)
     , scaleTolerance_(0.001f)
 {
+    // Full rate close up; hands, face, IK, cloth and then rate give way as characters shrink
+    lodLevels_ = {
+        { 300.0f, 1, true, true, true },
+        { 120.0f, 2, true, true, false },
+        { 40.0f, 4, false, false, false },
+        { 0.0f, 8, false, false, false },
+    };
 }
 
 AnimationSystem::~AnimationSystem() {
@@ -25,9 +146,10 @@ AnimationSystem::~AnimationSystem() {
 }
 
 bool AnimationSystem::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    NEXUS_MEMORY_SCOPE(MemoryTag::Animation);
     if (!device || !context) {
-        Logger::Error("AnimationSystem::Initialize - Invalid device or context");
-        return false;
+        // Headless: skeletal animation still evaluates on the CPU, nothing is uploaded
+        Logger::Info("AnimationSystem::Initialize - No device, running without GPU resources");
     }
     
     device_ = device;
@@ -38,6 +160,11 @@ bool AnimationSystem::Initialize(ID3D11Device* device, ID3D11DeviceContext* cont
 
 void AnimationSystem::Shutdown() {
     // Clean up all animation data
+    characters_.clear();
+    characterOrder_.clear();
+    characterGraph_.reset();
+    characterScheduleDirty_ = true;
+    characterCloths_.clear();
     skeletons_.clear();
     animationClips_.clear();
     animationInstances_.clear();
@@ -77,8 +204,6 @@ void AnimationSystem::RemoveSkeleton(const std::string& name) {
 }
 
 std::shared_ptr<AnimationSystem::AnimationClip> AnimationSystem::LoadAnimationClip(const std::string& filePath) {
-    // This would load an animation clip from file
-    // For now, we'll create a placeholder
     auto clip = std::make_shared<AnimationClip>();
     
     // Extract name from file path
@@ -86,6 +211,25 @@ std::shared_ptr<AnimationSystem::AnimationClip> AnimationSystem::LoadAnimationCl
     size_t lastDot = filePath.find_last_of(".");
     std::string name = filePath.substr(lastSlash + 1, lastDot - lastSlash - 1);
     
+    if (lastDot != std::string::npos && filePath.compare(lastDot, std::string::npos, ".nanim") == 0) {
+        auto compressed = std::make_shared<CompressedClip>();
+        if (!compressed->Load(filePath)) return nullptr;
+        clip->name = compressed->name.empty() ? name : compressed->name;
+        clip->duration = compressed->duration;
+        clip->frameRate = compressed->frameRate;
+        clip->isLooping = compressed->isLooping;
+        clip->hasRootMotion = compressed->hasRootMotion;
+        clip->events = compressed->events;
+        clip->compressed = compressed;
+        animationClips_[clip->name] = clip;
+        
+        Logger::Info("Loaded animation clip: " + clip->name + " from " + filePath + " (" +
+                     std::to_string(compressed->GetKeyCount()) + " keys, " +
+                     std::to_string(compressed->GetMemoryUsage() / 1024) + " KB)");
+        return clip;
+    }
+    
+    // Other formats come in through the importers; this is a placeholder
     clip->name = name;
     clip->duration = 1.0f; // Default duration
     clip->frameRate = 30.0f; // Default frame rate
@@ -120,6 +264,54 @@ void AnimationSystem::RemoveAnimationClip(const std::string& name) {
     }
 }
 
+bool AnimationSystem::CompressAnimationClip(const std::string& name) {
+    auto clip = GetAnimationClip(name);
+    if (!clip) return false;
+    if (clip->compressed) return true;
+    
+    AnimationCompressionSettings settings;
+    settings.positionTolerance = positionTolerance_;
+    settings.rotationTolerance = rotationTolerance_;
+    settings.scaleTolerance = scaleTolerance_;
+    auto compressed = std::make_shared<CompressedClip>();
+    if (!compressed->Compress(*clip, settings)) {
+        Logger::Warning("AnimationSystem::CompressAnimationClip - No keyframes in " + name);
+        return false;
+    }
+    
+    size_t keyCount = 0;
+    for (const auto& track : clip->tracks) {
+        keyCount += track.keyframes.size();
+    }
+    clip->duration = compressed->duration;
+    clip->compressed = compressed;
+    std::vector<AnimationTrack>().swap(clip->tracks);
+    
+    Logger::Info("Compressed animation clip: " + name + " from " + std::to_string(keyCount * sizeof(Keyframe) / 1024) +
+                 " KB to " + std::to_string(compressed->GetMemoryUsage() / 1024) + " KB");
+    return true;
+}
+
+bool AnimationSystem::SaveAnimationClip(const std::string& name, const std::string& filePath) {
+    if (!CompressAnimationClip(name)) return false;
+    auto clip = GetAnimationClip(name);
+    
+    // Settings changed since compressing go into the file too
+    CompressedClip file(*clip->compressed);
+    file.name = clip->name;
+    file.frameRate = clip->frameRate;
+    file.isLooping = clip->isLooping;
+    file.hasRootMotion = clip->hasRootMotion;
+    file.events = clip->events;
+    return file.Save(filePath);
+}
+
+void AnimationSystem::SetCompressionTolerances(float position, float rotation, float scale) {
+    positionTolerance_ = std::max(position, 0.0f);
+    rotationTolerance_ = std::max(rotation, 0.0f);
+    scaleTolerance_ = std::max(scale, 0.0f);
+}
+
 std::shared_ptr<AnimationSystem::AnimationInstance> AnimationSystem::CreateAnimationInstance(
     const std::string& name, std::shared_ptr<AnimationClip> clip) {
     
@@ -160,7 +352,7 @@ void AnimationSystem::PlayAnimation(const std::string& instanceName) {
     if (it != animationInstances_.end()) {
         it->second->isPlaying = true;
         it->second->isPaused = false;
-        Logger::Info("Playing animation: " + instanceName);
+        NEXUS_LOG_DEBUG("Playing animation: {}", instanceName);
     }
 }
 
@@ -168,7 +360,7 @@ void AnimationSystem::PauseAnimation(const std::string& instanceName) {
     auto it = animationInstances_.find(instanceName);
     if (it != animationInstances_.end()) {
         it->second->isPaused = true;
-        Logger::Info("Paused animation: " + instanceName);
+        NEXUS_LOG_DEBUG("Paused animation: {}", instanceName);
     }
 }
 
@@ -178,7 +370,7 @@ void AnimationSystem::StopAnimation(const std::string& instanceName) {
         it->second->isPlaying = false;
         it->second->isPaused = false;
         it->second->currentTime = 0.0f;
-        Logger::Info("Stopped animation: " + instanceName);
+        NEXUS_LOG_DEBUG("Stopped animation: {}", instanceName);
     }
 }
 
@@ -234,36 +426,396 @@ std::shared_ptr<AnimationSystem::AnimationStateMachine> AnimationSystem::CreateS
     return stateMachine;
 }
 
-void AnimationSystem::UpdateStateMachine(const std::string& name, float deltaTime) {
-    auto it = stateMachines_.find(name);
-    if (it != stateMachines_.end()) {
-        auto& sm = it->second;
-        sm->Update(deltaTime, *skeletons_.begin()->second);
+std::shared_ptr<AnimationSystem::ClothSimulation> AnimationSystem::CreateClothSimulation(const std::string& name) {
+    auto cloth = std::make_shared<ClothSimulation>();
+    cloth->SetJobSystem(jobs_);
+    clothSimulations_[name] = cloth;
+    
+    Logger::Info("Created cloth simulation: " + name);
+    return cloth;
+}
+
+std::shared_ptr<AnimationSystem::FacialAnimation> AnimationSystem::CreateFacialAnimation(const std::string& name) {
+    auto facial = std::make_shared<FacialAnimation>();
+    facialAnimations_[name] = facial;
+    
+    Logger::Info("Created facial animation: " + name);
+    return facial;
+}
+
+void AnimationSystem::SetFacialExpression(const std::string& animName, 
+                                         const std::string& expression, float weight) {
+    auto it = facialAnimations_.find(animName);
+    if (it != facialAnimations_.end() && it->second) {
+        it->second->SetExpressionWeight(expression, weight);
+    }
+}
+
+void AnimationSystem::UpdateClothSimulation(const std::string& name, float deltaTime) {
+    auto it = clothSimulations_.find(name);
+    if (it != clothSimulations_.end() && it->second) {
+        it->second->Step(deltaTime);
+    }
+}
+
+void AnimationSystem::SetJobSystem(JobSystem* jobs) {
+    jobs_ = jobs;
+    for (auto& clothPair : clothSimulations_) {
+        if (clothPair.second) clothPair.second->SetJobSystem(jobs);
+    }
+}
+
+void AnimationSystem::EnableMultithreading(bool enable) {
+    multithreadingEnabled_ = enable;
+}
+
+std::shared_ptr<AnimationSystem::Character> AnimationSystem::CreateCharacter(const std::string& name,
+                                                                            std::shared_ptr<Skeleton> skeleton) {
+    if (!skeleton || skeleton->ownedByCharacter) {
+        Logger::Error("AnimationSystem::CreateCharacter - Skeleton missing or already used by a character: " + name);
+        return nullptr;
+    }
+    RemoveCharacter(name);
+    
+    auto character = std::make_shared<Character>();
+    character->name = name;
+    character->skeleton = skeleton;
+    XMStoreFloat4x4(&character->worldTransform, XMMatrixIdentity());
+    XMStoreFloat4x4(&character->attachmentOffset, XMMatrixIdentity());
+    skeleton->ownedByCharacter = true;
+    character->updatePhase = static_cast<int>(characters_.size());
+    characters_[name] = character;
+    characterScheduleDirty_ = true;
+    
+    return character;
+}
+
+std::shared_ptr<AnimationSystem::Character> AnimationSystem::GetCharacter(const std::string& name) {
+    auto it = characters_.find(name);
+    return it != characters_.end() ? it->second : nullptr;
+}
+
+void AnimationSystem::RemoveCharacter(const std::string& name) {
+    auto it = characters_.find(name);
+    if (it == characters_.end()) return;
+    
+    // Hand everything back to Update(); attachments become free characters where they stand
+    Character& character = *it->second;
+    character.skeleton->ownedByCharacter = false;
+    for (auto& instance : character.instances) instance->ownedByCharacter = false;
+    if (character.stateMachine) character.stateMachine->ownedByCharacter = false;
+    for (auto& solver : character.ikSolvers) solver->ownedByCharacter = false;
+    for (auto& cloth : character.cloths) characterCloths_.erase(cloth.get());
+    for (auto& other : characters_) {
+        if (other.second->parent.lock() == it->second) {
+            other.second->parent.reset();
+            other.second->parentBone = -1;
+        }
+    }
+    characters_.erase(it);
+    characterScheduleDirty_ = true;
+}
+
+bool AnimationSystem::AddCharacterAnimation(const std::string& characterName, const std::string& instanceName) {
+    auto character = GetCharacter(characterName);
+    auto it = animationInstances_.find(instanceName);
+    if (!character || it == animationInstances_.end() || it->second->ownedByCharacter) {
+        Logger::Error("AnimationSystem::AddCharacterAnimation - Cannot add " + instanceName + " to " + characterName);
+        return false;
+    }
+    it->second->ownedByCharacter = true;
+    character->instances.push_back(it->second);
+    return true;
+}
+
+bool AnimationSystem::SetCharacterStateMachine(const std::string& characterName, const std::string& stateMachineName) {
+    auto character = GetCharacter(characterName);
+    auto it = stateMachines_.find(stateMachineName);
+    if (!character || it == stateMachines_.end() || it->second->ownedByCharacter) {
+        Logger::Error("AnimationSystem::SetCharacterStateMachine - Cannot give " + stateMachineName + " to " + characterName);
+        return false;
+    }
+    if (character->stateMachine) character->stateMachine->ownedByCharacter = false;
+    it->second->ownedByCharacter = true;
+    character->stateMachine = it->second;
+    return true;
+}
+
+bool AnimationSystem::AddCharacterIKSolver(const std::string& characterName, const std::string& solverName) {
+    auto character = GetCharacter(characterName);
+    auto it = ikSolvers_.find(solverName);
+    if (!character || it == ikSolvers_.end() || it->second->ownedByCharacter) {
+        Logger::Error("AnimationSystem::AddCharacterIKSolver - Cannot add " + solverName + " to " + characterName);
+        return false;
+    }
+    it->second->ownedByCharacter = true;
+    character->ikSolvers.push_back(it->second);
+    return true;
+}
+
+bool AnimationSystem::AttachCharacter(const std::string& characterName, const std::string& parentName,
+                                      const std::string& boneName, const XMFLOAT4X4& offset) {
+    auto character = GetCharacter(characterName);
+    if (!character) return false;
+    
+    if (parentName.empty()) {
+        character->parent.reset();
+        character->parentBone = -1;
+        characterScheduleDirty_ = true;
+        return true;
+    }
+    
+    auto parent = GetCharacter(parentName);
+    const int bone = parent ? parent->skeleton->FindBoneIndex(boneName) : -1;
+    if (bone < 0) {
+        Logger::Error("AnimationSystem::AttachCharacter - No bone " + boneName + " on " + parentName);
+        return false;
+    }
+    for (auto ancestor = parent; ancestor; ancestor = ancestor->parent.lock()) {
+        if (ancestor == character) {
+            Logger::Error("AnimationSystem::AttachCharacter - " + characterName + " would be its own ancestor");
+            return false;
+        }
+    }
+    
+    character->parent = parent;
+    character->parentBone = bone;
+    character->attachmentOffset = offset;
+    characterScheduleDirty_ = true;
+    return true;
+}
+
+bool AnimationSystem::AddCharacterCloth(const std::string& characterName, const std::string& clothName) {
+    auto character = GetCharacter(characterName);
+    auto it = clothSimulations_.find(clothName);
+    if (!character || it == clothSimulations_.end() || characterCloths_.count(it->second.get())) {
+        Logger::Error("AnimationSystem::AddCharacterCloth - Cannot add " + clothName + " to " + characterName);
+        return false;
+    }
+    characterCloths_.insert(it->second.get());
+    character->cloths.push_back(it->second);
+    return true;
+}
+
+void AnimationSystem::SetView(const Camera& camera, float viewportHeight) {
+    cameraPosition_ = camera.GetPosition();
+    // _22 of a perspective projection is cot(fovY / 2), the height scale at unit distance
+    float projectionScale = XMVectorGetY(camera.GetProjectionMatrix().r[1]);
+    pixelsPerUnit_ = projectionScale * viewportHeight * 0.5f;
+}
+
+void AnimationSystem::SetLodLevels(const std::vector<AnimationLodLevel>& levels) {
+    if (levels.empty()) return;
+    lodLevels_ = levels;
+    std::stable_sort(lodLevels_.begin(), lodLevels_.end(), [](const AnimationLodLevel& a, const AnimationLodLevel& b) {
+        return a.minScreenHeight > b.minScreenHeight;
+    });
+    for (auto& level : lodLevels_) {
+        level.updateInterval = std::max(level.updateInterval, 1);
+    }
+    for (auto& characterPair : characters_) {
+        characterPair.second->lod = std::min(characterPair.second->lod, static_cast<int>(lodLevels_.size()) - 1);
+    }
+}
+
+void AnimationSystem::SetBoneLodLimit(const std::string& skeletonName, const std::string& boneName, int lastLod) {
+    auto skeleton = GetSkeleton(skeletonName);
+    const int bone = skeleton ? skeleton->FindBoneIndex(boneName) : -1;
+    if (bone < 0) {
+        Logger::Warning("AnimationSystem::SetBoneLodLimit - No bone " + boneName + " in " + skeletonName);
+        return;
+    }
+    
+    // The whole subtree, so a hand takes its fingers with it
+    skeleton->boneLodLimit.resize(skeleton->bones.size(), UINT8_MAX);
+    const uint8_t limit = static_cast<uint8_t>(std::clamp(lastLod, 0, 255));
+    std::vector<int> pending = { bone };
+    while (!pending.empty()) {
+        const int index = pending.back();
+        pending.pop_back();
+        skeleton->boneLodLimit[index] = std::min(skeleton->boneLodLimit[index], limit);
+        pending.insert(pending.end(), skeleton->bones[index].childIndices.begin(), skeleton->bones[index].childIndices.end());
+    }
+}
+
+void AnimationSystem::SetLOD(int level) {
+    lodLevel_ = std::max(level, 0);
+}
+
+void AnimationSystem::EnableCulling(bool enable) {
+    cullingEnabled_ = enable;
+}
+
+void AnimationSystem::SetMaxAnimationDistance(float distance) {
+    maxAnimationDistance_ = distance;
+}
+
+void AnimationSystem::SelectCharacterLod(Character& character) const {
+    const int coarsest = static_cast<int>(lodLevels_.size()) - 1;
+    character.culled = false;
+    if (pixelsPerUnit_ <= 0.0f) {
+        character.lod = std::min(lodLevel_, coarsest);
+        return;
+    }
+    
+    const XMFLOAT4X4& world = character.worldTransform;
+    const float dx = world._41 - cameraPosition_.x;
+    const float dy = world._42 - cameraPosition_.y;
+    const float dz = world._43 - cameraPosition_.z;
+    const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (cullingEnabled_ && distance - character.boundingRadius > maxAnimationDistance_) {
+        character.culled = true;
+        return;
+    }
+    
+    // Inside the bounding sphere counts as full screen. Finer levels than the current one need
+    // a margin past their threshold and the current one keeps a margin below, so no flicker
+    constexpr float hysteresis = 0.15f;
+    const float nearest = distance - character.boundingRadius;
+    const float screenHeight = nearest > 0.0f ? 2.0f * character.boundingRadius * pixelsPerUnit_ / nearest : FLT_MAX;
+    int selected = coarsest;
+    for (int lod = 0; lod < coarsest; ++lod) {
+        float threshold = lodLevels_[lod].minScreenHeight;
+        if (lod < character.lod) threshold *= 1.0f + hysteresis;
+        else if (lod == character.lod) threshold *= 1.0f - hysteresis;
+        if (screenHeight >= threshold) {
+            selected = lod;
+            break;
+        }
+    }
+    character.lod = std::max(selected, std::min(lodLevel_, coarsest));
+}
+
+void AnimationSystem::BuildCharacterSchedule() {
+    // Depth in the attachment tree; sorting by it puts every parent before its attachments
+    std::vector<std::pair<int, Character*>> ordered;
+    ordered.reserve(characters_.size());
+    for (auto& characterPair : characters_) {
+        int depth = 0;
+        for (auto parent = characterPair.second->parent.lock(); parent; parent = parent->parent.lock()) {
+            ++depth;
+        }
+        ordered.emplace_back(depth, characterPair.second.get());
+    }
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    characterOrder_.clear();
+    if (!characterGraph_) {
+        characterGraph_ = std::make_unique<TaskGraph>();
+    }
+    characterGraph_->Clear();
+    std::map<const Character*, TaskGraph::TaskID> tasks;
+    for (const auto& entry : ordered) {
+        Character* character = entry.second;
+        characterOrder_.push_back(character);
         
-        // Handle transitions
-        if (sm->isTransitioning) {
-            sm->transitionTime += deltaTime;
-            if (sm->transitionTime >= sm->transitionDuration) {
-                sm->isTransitioning = false;
-                sm->currentState = sm->targetState;
-                sm->transitionTime = 0.0f;
+        std::vector<TaskGraph::TaskID> dependencies;
+        if (auto parent = character->parent.lock()) {
+            dependencies.push_back(tasks[parent.get()]);
+        }
+        tasks[character] = characterGraph_->AddTask(character->name, [this, character]() {
+            UpdateCharacter(*character, characterDeltaTime_);
+        }, dependencies);
+    }
+    
+    characterScheduleDirty_ = false;
+}
+
+void AnimationSystem::UpdateCharacters(float deltaTime) {
+    NEXUS_PROFILE_SCOPE("AnimationSystem::UpdateCharacters");
+    if (characterScheduleDirty_) {
+        BuildCharacterSchedule();
+    }
+    
+    characterDeltaTime_ = deltaTime;
+    ++animationFrame_;
+    if (multithreadingEnabled_ && jobs_ && jobs_->IsInitialized() && characterOrder_.size() > 1) {
+        characterGraph_->Execute(*jobs_);
+    } else {
+        for (Character* character : characterOrder_) {
+            UpdateCharacter(*character, deltaTime);
+        }
+    }
+}
+
+void AnimationSystem::UpdateCharacter(Character& character, float deltaTime) {
+    Skeleton& skeleton = *character.skeleton;
+    
+    for (auto& instance : character.instances) {
+        ProcessAnimationInstance(instance, deltaTime);
+    }
+    if (character.stateMachine) {
+        character.stateMachine->Update(deltaTime);
+    }
+    
+    // The parent's job has finished, so its bones are final for this frame
+    if (auto parent = character.parent.lock()) {
+        const Skeleton& parentSkeleton = *parent->skeleton;
+        if (character.parentBone < static_cast<int>(parentSkeleton.bones.size())) {
+            XMMATRIX world = XMMatrixMultiply(XMLoadFloat4x4(&character.attachmentOffset),
+                                              XMLoadFloat4x4(&parentSkeleton.bones[character.parentBone].worldTransform));
+            world = XMMatrixMultiply(world, XMLoadFloat4x4(&parent->worldTransform));
+            XMStoreFloat4x4(&character.worldTransform, world);
+        }
+    }
+    
+    SelectCharacterLod(character);
+    if (character.culled) {
+        character.hasSample = false;
+        return;
+    }
+    const AnimationLodLevel& level = lodLevels_[character.lod];
+    character.facialActive = level.facial;
+    
+    if (level.updateInterval <= 1) {
+        BlendPoses(skeleton, character.instances, character.lod);
+        character.hasSample = false;
+    } else {
+        // Sample on this character's frames of the interval, then show the way from the
+        // previous sample to the latest, one step per frame. Costs up to an interval of latency
+        ++character.framesSinceSample;
+        const uint32_t interval = static_cast<uint32_t>(level.updateInterval);
+        const bool stale = !character.hasSample || character.sampledPose.boneCount != skeleton.bones.size();
+        if (stale || (animationFrame_ + character.updatePhase) % interval == 0) {
+            BlendPoses(skeleton, character.instances, character.lod);
+            if (stale) {
+                character.sampledPose = skeleton.pose;
+                character.previousPose = skeleton.pose;
+                character.hasSample = true;
+            } else {
+                std::swap(character.previousPose, character.sampledPose);
+                character.sampledPose = skeleton.pose;
             }
+            character.framesSinceSample = 0;
         }
         
-        // Check for new transitions
-        auto& currentState = sm->states[sm->currentState];
-        for (const auto& transition : sm->transitions) {
-            if (transition.fromState == sm->currentState && 
-                transition.condition && transition.condition()) {
-                
-                sm->targetState = transition.toState;
-                sm->transitionDuration = transition.duration;
-                sm->isTransitioning = true;
-                sm->transitionTime = 0.0f;
-                break;
-            }
+        const float t = std::min(static_cast<float>(character.framesSinceSample + 1) / level.updateInterval, 1.0f);
+        skeleton.pose = character.previousPose;
+        BlendPoseGroups(skeleton.pose, character.sampledPose, 1.0f - t, t);
+        NormalizePoseRotations(skeleton.pose);
+    }
+    
+    if (level.ik) {
+        for (auto& solver : character.ikSolvers) {
+            solver->Solve(skeleton);
         }
     }
+    skeleton.UpdateBoneTransforms();
+}
+
+void AnimationSystem::UpdateStateMachine(const std::string& name, float deltaTime) {
+    auto it = stateMachines_.find(name);
+    if (it != stateMachines_.end() && it->second) {
+        it->second->Update(deltaTime);
+    }
+}
+
+void AnimationSystem::SetStateMachineState(const std::string& stateMachineName, const std::string& stateName) {
+    auto it = stateMachines_.find(stateMachineName);
+    if (it != stateMachines_.end() && it->second) {
+        it->second->SetState(stateName);
+    }
 }
 
 void AnimationSystem::ProcessAnimationInstance(std::shared_ptr<AnimationInstance> instance, float deltaTime) {
@@ -290,98 +842,89 @@ void AnimationSystem::ProcessAnimationInstance(std::shared_ptr<AnimationInstance
     }
 }
 
-void AnimationSystem::BlendPoses(Skeleton& skeleton, const std::vector<std::shared_ptr<AnimationInstance>>& instances) {
-    if (instances.empty()) return;
-    
-    // Reset bone transforms
-    for (auto& bone : skeleton.bones) {
-        bone.localTransform = bone.bindPose;
+void AnimationSystem::BlendPoses(Skeleton& skeleton, const std::vector<std::shared_ptr<AnimationInstance>>& instances,
+                                 int lod) {
+    NEXUS_PROFILE_SCOPE("AnimationSystem::BlendPoses");
+    if (skeleton.bindLocalPose.boneCount != skeleton.bones.size()) {
+        skeleton.ResetPose();
     }
     
-    // Blend animations
     float totalWeight = 0.0f;
     for (const auto& instance : instances) {
-        totalWeight += instance->weight;
+        if (instance && instance->clip && instance->weight > 0.0f) {
+            totalWeight += instance->weight;
+        }
     }
     
     if (totalWeight > 0.0f) {
+        // Weighted sum of every pose, with the rotations renormalized once at the end
+        std::fill(skeleton.pose.storage.begin(), skeleton.pose.storage.end(), 0.0f);
         for (const auto& instance : instances) {
-            float normalizedWeight = instance->weight / totalWeight;
-            ApplyAnimationToSkeleton(skeleton, instance, normalizedWeight);
+            if (!instance || !instance->clip || instance->weight <= 0.0f) continue;
+            SamplePose(skeleton, *instance, skeleton.samplePose, lod);
+            BlendPoseGroups(skeleton.pose, skeleton.samplePose, 1.0f, instance->weight / totalWeight);
         }
+        NormalizePoseRotations(skeleton.pose);
+    } else {
+        skeleton.pose = skeleton.bindLocalPose;
     }
-    
-    // Update world matrices
-    UpdateSkeletonMatrices(std::make_shared<Skeleton>(skeleton));
 }
 
 void AnimationSystem::ApplyAnimationToSkeleton(Skeleton& skeleton, std::shared_ptr<AnimationInstance> instance, float weight) {
     if (!instance || !instance->clip) return;
+    if (skeleton.bindLocalPose.boneCount != skeleton.bones.size()) {
+        skeleton.ResetPose();
+    }
     
-    for (const auto& track : instance->clip->tracks) {
-        if (track.boneIndex >= 0 && track.boneIndex < skeleton.bones.size()) {
-            DirectX::XMFLOAT3 position;
-            DirectX::XMFLOAT4 rotation;
-            DirectX::XMFLOAT3 scale;
-            
-            InterpolateKeyframes(track, instance->currentTime, position, rotation, scale);
-            
-            // Blend with current bone transform
-            auto& bone = skeleton.bones[track.boneIndex];
-            
-            // Linear interpolation for position and scale
-            XMFLOAT4X4 transformMatrix;
-            // bone.localTransform is already XMFLOAT4X4, so we need to load it as XMMATRIX first
-            XMMATRIX boneMatrix = XMLoadFloat4x4(&bone.localTransform);
-            XMStoreFloat4x4(&transformMatrix, boneMatrix);
-            float lerpedX = Lerp(transformMatrix._41, position.x, weight);
-            float lerpedY = Lerp(transformMatrix._42, position.y, weight);
-            float lerpedZ = Lerp(transformMatrix._43, position.z, weight);
-
-            // Spherical interpolation for rotation
-            DirectX::XMFLOAT4 identityQuaternion(0, 0, 0, 1);
-            DirectX::XMVECTOR currentRot = DirectX::XMLoadFloat4(&identityQuaternion);
-            DirectX::XMVECTOR targetRot = DirectX::XMLoadFloat4(&rotation);
-            DirectX::XMVECTOR blendedRot = DirectX::XMQuaternionSlerp(currentRot, targetRot, weight);
-
-            // Apply rotation to transform matrix
-            DirectX::XMMATRIX rotMatrix = DirectX::XMMatrixRotationQuaternion(blendedRot);
-            DirectX::XMMATRIX scaleMatrix = DirectX::XMMatrixScaling(scale.x, scale.y, scale.z);
-            DirectX::XMMATRIX posMatrix = DirectX::XMMatrixTranslation(lerpedX, lerpedY, lerpedZ);
+    // nlerp from the current pose towards the instance's
+    SamplePose(skeleton, *instance, skeleton.samplePose);
+    BlendPoseGroups(skeleton.pose, skeleton.samplePose, 1.0f - weight, weight);
+    NormalizePoseRotations(skeleton.pose);
+}
 
-            DirectX::XMMATRIX finalTransform = scaleMatrix * rotMatrix * posMatrix;
-            DirectX::XMStoreFloat4x4(&bone.localTransform, finalTransform);
+void AnimationSystem::SamplePose(const Skeleton& skeleton, AnimationInstance& instance, Pose& pose, int lod) {
+    // Copying keeps pose's storage once it is large enough
+    pose = skeleton.bindLocalPose;
+    
+    const std::vector<AnimationTrack>& tracks = instance.clip->tracks;
+    const CompressedClip* compressed = instance.clip->compressed.get();
+    const size_t trackCount = compressed ? compressed->GetTrackCount() : tracks.size();
+    instance.trackCursors.resize(compressed ? trackCount * CompressedClip::CHANNELS : trackCount, 0);
+    for (size_t trackIndex = 0; trackIndex < trackCount; ++trackIndex) {
+        const int boneIndex = compressed ? compressed->GetBoneIndex(trackIndex) : tracks[trackIndex].boneIndex;
+        if (boneIndex < 0 || static_cast<size_t>(boneIndex) >= pose.boneCount) continue;
+        if (static_cast<size_t>(boneIndex) < skeleton.boneLodLimit.size() && lod > skeleton.boneLodLimit[boneIndex]) continue;
+        
+        DirectX::XMFLOAT3 position;
+        DirectX::XMFLOAT4 rotation;
+        DirectX::XMFLOAT3 scale;
+        if (compressed) {
+            compressed->Sample(trackIndex, instance.currentTime,
+                               &instance.trackCursors[trackIndex * CompressedClip::CHANNELS], position, rotation, scale);
+        } else {
+            InterpolateKeyframes(tracks[trackIndex], instance.currentTime, instance.trackCursors[trackIndex],
+                                 position, rotation, scale);
         }
+        pose.SetBone(boneIndex, position, rotation, scale);
     }
 }
 
-void AnimationSystem::InterpolateKeyframes(const AnimationTrack& track, float time, 
+void AnimationSystem::InterpolateKeyframes(const AnimationTrack& track, float time, int& cursor,
                                           DirectX::XMFLOAT3& position, DirectX::XMFLOAT4& rotation, 
                                           DirectX::XMFLOAT3& scale) {
-    
-    // Find keyframes to interpolate between
-    int keyIndex = 0;
-    for (int i = 0; i < track.keyframes.size() - 1; ++i) {
-        if (time >= track.keyframes[i].time && time < track.keyframes[i + 1].time) {
-            keyIndex = i;
-            break;
-        }
-    }
-    
-    if (keyIndex >= track.keyframes.size() - 1) {
-        // Use last keyframe
-        const auto& keyframe = track.keyframes.back();
-        position = keyframe.position;
-        rotation = keyframe.rotation;
-        scale = keyframe.scale;
+    if (track.keyframes.empty()) {
+        position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+        rotation = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+        scale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
         return;
     }
-    
-    const auto& keyframe1 = track.keyframes[keyIndex];
-    const auto& keyframe2 = track.keyframes[keyIndex + 1];
-    
-    float t = (time - keyframe1.time) / (keyframe2.time - keyframe1.time);
-    t = std::clamp(t, 0.0f, 1.0f);
+
+    // Find keyframes to interpolate between
+    int prevIndex, nextIndex;
+    float t;
+    track.FindKeyframes(time, prevIndex, nextIndex, t, cursor);
+    const auto& keyframe1 = track.keyframes[prevIndex];
+    const auto& keyframe2 = track.keyframes[nextIndex];
     
     // Interpolate position
     position.x = Lerp(keyframe1.position.x, keyframe2.position.x, t);
@@ -406,28 +949,12 @@ float AnimationSystem::Lerp(float a, float b, float t) {
 
 void AnimationSystem::UpdateSkeletonMatrices(std::shared_ptr<Skeleton> skeleton) {
     if (!skeleton) return;
-    
-    // Calculate world matrices for each bone
-    for (int i = 0; i < skeleton->bones.size(); ++i) {
-        auto& bone = skeleton->bones[i];
-        
-        if (bone.parentIndex >= 0) {
-            // Multiply by parent's world matrix
-            DirectX::XMMATRIX local = DirectX::XMLoadFloat4x4(&bone.localTransform);
-            DirectX::XMMATRIX parent = DirectX::XMLoadFloat4x4(&skeleton->bones[bone.parentIndex].worldTransform);
-            DirectX::XMMATRIX world = local * parent;
-            DirectX::XMStoreFloat4x4(&bone.worldTransform, world);
-        } else {
-            // Root bone
-            bone.worldTransform = bone.localTransform;
-        }
-        
-        // Calculate final transform (world * inverse bind pose)
-        DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&bone.worldTransform);
-        DirectX::XMMATRIX invBindPose = DirectX::XMLoadFloat4x4(&bone.inverseBindPose);
-        DirectX::XMMATRIX final = invBindPose * world;
-        DirectX::XMStoreFloat4x4(&bone.finalTransform, final);
-    }
+    skeleton->UpdateBoneTransforms();
+}
+
+void AnimationSystem::GetBoneMatrices(std::shared_ptr<Skeleton> skeleton, std::vector<DirectX::XMMATRIX>& matrices) {
+    if (!skeleton) return;
+    skeleton->GetBoneMatrices(matrices);
 }
 
 void AnimationSystem::SolveIK(const std::string& solverName, std::shared_ptr<Skeleton> skeleton) {
@@ -481,8 +1008,20 @@ void AnimationSystem::SolveIK(const std::string& solverName, std::shared_ptr<Ske
                     
                     // Apply rotation to bones
                     DirectX::XMMATRIX rotation = DirectX::XMMatrixRotationAxis(DirectX::XMVectorSet(0, 1, 0, 0), angle);
-                    DirectX::XMMATRIX local = DirectX::XMLoadFloat4x4(&bone1.localTransform);
-                    DirectX::XMStoreFloat4x4(&bone1.localTransform, local * rotation);
+                    DirectX::XMMATRIX local = DirectX::XMLoadFloat4x4(&bone1.localTransform) * rotation;
+                    DirectX::XMStoreFloat4x4(&bone1.localTransform, local);
+                    
+                    // Back into the pose, which UpdateBoneTransforms() builds the matrices from
+                    DirectX::XMVECTOR poseScale, poseRotation, posePosition;
+                    if (static_cast<size_t>(bone1Index) < skeleton->pose.boneCount &&
+                        DirectX::XMMatrixDecompose(&poseScale, &poseRotation, &posePosition, local)) {
+                        DirectX::XMFLOAT3 position, scale;
+                        DirectX::XMFLOAT4 orientation;
+                        DirectX::XMStoreFloat3(&position, posePosition);
+                        DirectX::XMStoreFloat4(&orientation, poseRotation);
+                        DirectX::XMStoreFloat3(&scale, poseScale);
+                        skeleton->pose.SetBone(bone1Index, position, orientation, scale);
+                    }
                 }
             }
         }
@@ -495,30 +1034,33 @@ void AnimationSystem::EnableDebugVisualization(bool enable) {
 }
 
 void AnimationSystem::Update(float deltaTime) {
-    // Update all animation instances
+    NEXUS_PROFILE_SCOPE("AnimationSystem::Update");
+    UpdateCharacters(deltaTime);
+    
+    // Update the animation instances no character owns
     for (auto& instancePair : animationInstances_) {
-        if (instancePair.second) {
+        if (instancePair.second && !instancePair.second->ownedByCharacter) {
             instancePair.second->Update(deltaTime);
         }
     }
     
     // Update all skeletons
     for (auto& skeletonPair : skeletons_) {
-        if (skeletonPair.second) {
+        if (skeletonPair.second && !skeletonPair.second->ownedByCharacter) {
             UpdateSkeletonMatrices(skeletonPair.second);
         }
     }
     
     // Update state machines
     for (auto& stateMachinePair : stateMachines_) {
-        if (stateMachinePair.second) {
-            UpdateStateMachine(stateMachinePair.first, deltaTime);
+        if (stateMachinePair.second && !stateMachinePair.second->ownedByCharacter) {
+            stateMachinePair.second->Update(deltaTime);
         }
     }
     
     // Update IK solvers
     for (auto& solverPair : ikSolvers_) {
-        if (solverPair.second && !skeletons_.empty()) {
+        if (solverPair.second && !solverPair.second->ownedByCharacter && !skeletons_.empty()) {
             auto firstSkeleton = skeletons_.begin()->second;
             if (firstSkeleton) {
                 solverPair.second->Solve(*firstSkeleton);
@@ -526,12 +1068,28 @@ void AnimationSystem::Update(float deltaTime) {
         }
     }
     
-    // Update cloth simulations
+    // Update cloth simulations; each cloth is independent, so they step side by side
+    clothUpdates_.clear();
     for (auto& clothPair : clothSimulations_) {
-        if (clothPair.second) {
-            clothPair.second->Update(deltaTime);
+        if (clothPair.second && !characterCloths_.count(clothPair.second.get())) {
+            clothUpdates_.push_back(clothPair.second.get());
         }
     }
+    for (auto& characterPair : characters_) {
+        const Character& character = *characterPair.second;
+        if (character.culled || !lodLevels_[character.lod].cloth) continue;
+        for (auto& cloth : character.cloths) clothUpdates_.push_back(cloth.get());
+    }
+    auto stepCloths = [this, deltaTime](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            clothUpdates_[i]->Step(deltaTime);
+        }
+    };
+    if (jobs_ && jobs_->IsInitialized() && clothUpdates_.size() > 1) {
+        jobs_->ParallelFor(clothUpdates_.size(), 1, stepCloths);
+    } else {
+        stepCloths(0, clothUpdates_.size());
+    }
 }
 
 // Implementation of nested classes
@@ -545,46 +1103,94 @@ int AnimationSystem::Skeleton::FindBoneIndex(const std::string& name) const {
 
 void AnimationSystem::Skeleton::BuildHierarchy() {
     // Build bone hierarchy
+    for (auto& bone : bones) {
+        bone.childIndices.clear();
+    }
     for (size_t i = 0; i < bones.size(); ++i) {
         if (bones[i].parentIndex >= 0 && bones[i].parentIndex < bones.size()) {
             bones[bones[i].parentIndex].childIndices.push_back(i);
         }
+        if (bones[i].parentIndex >= static_cast<int>(i)) {
+            Logger::Warning("Skeleton " + name + ": bone " + bones[i].name + " comes before its parent");
+        }
     }
+    
+    ResetPose();
 }
 
-void AnimationSystem::Skeleton::UpdateBoneTransforms() {
-    // Update bone transforms in hierarchy order
+void AnimationSystem::Skeleton::ResetPose() {
+    bindLocalPose.Resize(bones.size());
     for (size_t i = 0; i < bones.size(); ++i) {
-        if (bones[i].parentIndex == -1) {
-            // Root bone
-            bones[i].currentTransform = bones[i].bindPose;
-        } else {
-            // Child bone
-            XMMATRIX bindPoseMatrix = XMLoadFloat4x4(&bones[i].bindPose);
-            XMMATRIX parentMatrix = XMLoadFloat4x4(&bones[bones[i].parentIndex].currentTransform);
-            XMMATRIX result = XMMatrixMultiply(bindPoseMatrix, parentMatrix);
-            XMStoreFloat4x4(&bones[i].currentTransform, result);
+        XMVECTOR scale, rotation, translation;
+        if (XMMatrixDecompose(&scale, &rotation, &translation, XMLoadFloat4x4(&bones[i].bindPose))) {
+            XMFLOAT3 position, scaling;
+            XMFLOAT4 orientation;
+            XMStoreFloat3(&position, translation);
+            XMStoreFloat4(&orientation, rotation);
+            XMStoreFloat3(&scaling, scale);
+            bindLocalPose.SetBone(i, position, orientation, scaling);
         }
     }
+    pose = bindLocalPose;
+    skinningMatrices.resize(bones.size());
 }
 
-void AnimationSystem::Skeleton::GetBoneMatrices(std::vector<XMMATRIX>& matrices) const {
-    matrices.resize(bones.size());
-    for (size_t i = 0; i < bones.size(); ++i) {
-        // Load matrices for calculation
-        XMMATRIX bindPoseMatrix = XMLoadFloat4x4(&bones[i].bindPose);
-        XMMATRIX currentTransformMatrix = XMLoadFloat4x4(&bones[i].currentTransform);
-        XMMATRIX tempResult = XMMatrixMultiply(bindPoseMatrix, currentTransformMatrix);
-        
-        // Calculate final matrix without modifying const member
-        XMMATRIX inverseBindPoseMatrix = XMLoadFloat4x4(&bones[i].inverseBindPose);
-        XMMATRIX finalMatrix = XMMatrixMultiply(inverseBindPoseMatrix, tempResult);
+void AnimationSystem::Skeleton::UpdateBoneTransforms() {
+    if (bindLocalPose.boneCount != bones.size()) {
+        ResetPose();
+    }
+    
+    XMFLOAT4X4 local[4];
+    for (size_t first = 0; first < bones.size(); first += 4) {
+        ComposeGroup(pose, first, local);
         
-        // Store directly to matrices vector (which is std::vector<XMMATRIX>)
-        matrices[i] = finalMatrix;
+        const size_t last = std::min(first + 4, bones.size());
+        for (size_t i = first; i < last; ++i) {
+            Bone& bone = bones[i];
+            bone.localTransform = local[i - first];
+            XMMATRIX model = XMLoadFloat4x4(&bone.localTransform);
+            if (bone.parentIndex >= 0) {
+                model = XMMatrixMultiply(model, XMLoadFloat4x4(&bones[bone.parentIndex].worldTransform));
+            }
+            XMStoreFloat4x4(&bone.worldTransform, model);
+            bone.currentTransform = bone.worldTransform;
+            
+            XMStoreFloat4x4(&skinningMatrices[i], XMMatrixMultiply(XMLoadFloat4x4(&bone.inverseBindPose), model));
+            bone.finalTransform = skinningMatrices[i];
+        }
+    }
+}
+
+void AnimationSystem::Skeleton::GetBoneMatrices(std::vector<XMMATRIX>& matrices) const {
+    // Only allocates when the skeleton outgrows the caller's vector
+    matrices.resize(skinningMatrices.size());
+    for (size_t i = 0; i < skinningMatrices.size(); ++i) {
+        matrices[i] = XMLoadFloat4x4(&skinningMatrices[i]);
     }
 }
 
+void AnimationSystem::Pose::Resize(size_t bones) {
+    boneCount = bones;
+    stride = (bones + 3) & ~size_t(3);
+    storage.assign(stride * STREAM_COUNT, 0.0f);
+    std::fill_n((*this)[ROTATION_W], stride, 1.0f);
+    std::fill_n((*this)[SCALE_X], stride * 3, 1.0f);
+}
+
+void AnimationSystem::Pose::SetBone(size_t bone, const XMFLOAT3& position, const XMFLOAT4& rotation,
+                                    const XMFLOAT3& scale) {
+    (*this)[TRANSLATION_X][bone] = position.x;
+    (*this)[TRANSLATION_Y][bone] = position.y;
+    (*this)[TRANSLATION_Z][bone] = position.z;
+    (*this)[ROTATION_X][bone] = rotation.x;
+    (*this)[ROTATION_Y][bone] = rotation.y;
+    (*this)[ROTATION_Z][bone] = rotation.z;
+    (*this)[ROTATION_W][bone] = rotation.w;
+    (*this)[SCALE_X][bone] = scale.x;
+    (*this)[SCALE_Y][bone] = scale.y;
+    (*this)[SCALE_Z][bone] = scale.z;
+}
+
 void AnimationSystem::AnimationInstance::Update(float deltaTime) {
     // Update animation instance
     if (isPlaying && !isPaused) {
@@ -620,22 +1226,41 @@ void AnimationSystem::AnimationInstance::SetWeight(float weight) {
 }
 
 void AnimationSystem::AnimationTrack::FindKeyframes(float time, int& prevIndex, int& nextIndex, float& t) const {
-    // Find surrounding keyframes
-    prevIndex = 0;
-    nextIndex = 0;
-    
-    for (size_t i = 0; i < keyframes.size() - 1; ++i) {
-        if (time >= keyframes[i].time && time <= keyframes[i + 1].time) {
-            prevIndex = i;
-            nextIndex = i + 1;
-            t = (time - keyframes[i].time) / (keyframes[i + 1].time - keyframes[i].time);
-            return;
+    int cursor = 0;
+    FindKeyframes(time, prevIndex, nextIndex, t, cursor);
+}
+
+void AnimationSystem::AnimationTrack::FindKeyframes(float time, int& prevIndex, int& nextIndex, float& t, int& cursor) const {
+    const int last = static_cast<int>(keyframes.size()) - 1;
+    t = 0.0f;
+    if (last <= 0 || time <= keyframes[0].time) {
+        prevIndex = nextIndex = cursor = 0;
+        return;
+    }
+    if (time >= keyframes[last].time) {
+        prevIndex = nextIndex = cursor = last;
+        return;
+    }
+
+    // Between two samples playback rarely moves past the neighbouring key, in either direction
+    auto contains = [this, time](int i) { return keyframes[i].time <= time && time < keyframes[i + 1].time; };
+    int i = std::clamp(cursor, 0, last - 1);
+    if (!contains(i)) {
+        if (i + 1 < last && contains(i + 1)) {
+            ++i;
+        } else if (i > 0 && contains(i - 1)) {
+            --i;
+        } else {
+            auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+                                         [](float value, const Keyframe& key) { return value < key.time; });
+            i = static_cast<int>(next - keyframes.begin()) - 1;
         }
     }
-    
-    // If not found, use last keyframe
-    prevIndex = nextIndex = keyframes.size() - 1;
-    t = 0.0f;
+
+    cursor = prevIndex = i;
+    nextIndex = i + 1;
+    float span = keyframes[nextIndex].time - keyframes[i].time;
+    t = span > 0.0f ? (time - keyframes[i].time) / span : 0.0f;
 }
 
 XMFLOAT3 AnimationSystem::AnimationTrack::InterpolatePosition(float time) const {
@@ -693,32 +1318,169 @@ XMFLOAT3 AnimationSystem::AnimationTrack::InterpolateScale(float time) const {
 
 void AnimationSystem::AnimationStateMachine::AddState(const std::string& name, const State& state) {
     states[name] = state;
+    compiled = false;
 }
 
 void AnimationSystem::AnimationStateMachine::AddTransition(const Transition& transition) {
     transitions.push_back(transition);
+    compiled = false;
 }
 
 void AnimationSystem::AnimationStateMachine::SetState(const std::string& stateName) {
     if (states.find(stateName) != states.end()) {
         currentState = stateName;
+        isTransitioning = false;
+        transitionTime = 0.0f;
+        stateTime = 0.0f;
+        if (compiled) currentIndex = GetStateIndex(stateName);
+    }
+}
+
+int AnimationSystem::AnimationStateMachine::AddParameter(const std::string& name, float value) {
+    auto it = parameterIndices.find(name);
+    if (it != parameterIndices.end()) return it->second;
+    
+    int index = static_cast<int>(parameters.size());
+    parameters.push_back(value);
+    parameterIndices[name] = index;
+    return index;
+}
+
+int AnimationSystem::AnimationStateMachine::GetParameterIndex(const std::string& name) const {
+    auto it = parameterIndices.find(name);
+    return it != parameterIndices.end() ? it->second : -1;
+}
+
+void AnimationSystem::AnimationStateMachine::SetParameter(const std::string& name, float value) {
+    int index = GetParameterIndex(name);
+    if (index >= 0) parameters[index] = value;
+}
+
+int AnimationSystem::AnimationStateMachine::GetStateIndex(const std::string& name) const {
+    // States are numbered in map order, so this is the position of the name
+    auto it = states.find(name);
+    return it != states.end() ? static_cast<int>(std::distance(states.begin(), it)) : INVALID_STATE;
+}
+
+void AnimationSystem::AnimationStateMachine::Compile() {
+    compiledStates.clear();
+    stateNames.clear();
+    for (auto& statePair : states) {
+        stateNames.push_back(&statePair.first);
+        compiledStates.push_back(&statePair.second);
+    }
+    
+    // Bucket transitions by source state, keeping their authored priority within a state
+    std::vector<std::vector<uint32_t>> outgoing(states.size());
+    for (size_t i = 0; i < transitions.size(); ++i) {
+        const Transition& transition = transitions[i];
+        int from = GetStateIndex(transition.fromState);
+        int to = GetStateIndex(transition.toState);
+        if (from == INVALID_STATE || to == INVALID_STATE) {
+            Logger::Warning("AnimationStateMachine::Compile - Transition " + transition.fromState + " -> " +
+                            transition.toState + " names an unknown state");
+            continue;
+        }
+        // Like before, a transition with nothing to wait for never fires
+        if (transition.conditions.empty() && !transition.condition && !transition.hasExitTime) continue;
+        outgoing[from].push_back(static_cast<uint32_t>(i));
+    }
+    
+    firstTransition.assign(1, 0);
+    compiledTransitions.clear();
+    compiledConditions.clear();
+    for (size_t state = 0; state < outgoing.size(); ++state) {
+        for (uint32_t source : outgoing[state]) {
+            const Transition& transition = transitions[source];
+            CompiledTransition compiledTransition = {};
+            compiledTransition.toState = GetStateIndex(transition.toState);
+            compiledTransition.firstCondition = static_cast<uint32_t>(compiledConditions.size());
+            compiledTransition.source = source;
+            compiledTransition.duration = transition.duration;
+            compiledTransition.exitTime = transition.hasExitTime ? std::max(transition.exitTime, 0.0f) : -1.0f;
+            compiledTransition.hasCallback = static_cast<bool>(transition.condition);
+            compiledTransition.canInterrupt = transition.canInterrupt;
+            
+            // Conditions on parameters nobody declared read a new parameter that starts at zero
+            for (const Condition& condition : transition.conditions) {
+                CompiledCondition compiledCondition = {};
+                compiledCondition.parameter = static_cast<uint32_t>(AddParameter(condition.parameter));
+                compiledCondition.op = condition.op;
+                compiledCondition.value = condition.value;
+                compiledConditions.push_back(compiledCondition);
+            }
+            compiledTransition.conditionCount = static_cast<uint32_t>(compiledConditions.size()) - compiledTransition.firstCondition;
+            compiledTransitions.push_back(compiledTransition);
+        }
+        firstTransition.push_back(static_cast<uint32_t>(compiledTransitions.size()));
+    }
+    
+    currentIndex = GetStateIndex(currentState);
+    targetIndex = GetStateIndex(targetState);
+    activeTransition = -1;
+    if (targetIndex == INVALID_STATE) isTransitioning = false;
+    compiled = true;
+}
+
+bool AnimationSystem::AnimationStateMachine::ConditionsHold(const CompiledTransition& transition) const {
+    const CompiledCondition* condition = compiledConditions.data() + transition.firstCondition;
+    for (uint32_t i = 0; i < transition.conditionCount; ++i, ++condition) {
+        const float value = parameters[condition->parameter];
+        switch (condition->op) {
+            case Condition::Op::Greater:  if (!(value > condition->value)) return false; break;
+            case Condition::Op::Less:     if (!(value < condition->value)) return false; break;
+            case Condition::Op::Equal:    if (!(value == condition->value)) return false; break;
+            case Condition::Op::NotEqual: if (!(value != condition->value)) return false; break;
+        }
+    }
+    return true;
+}
+
+void AnimationSystem::AnimationStateMachine::EnterState(int index) {
+    if (currentIndex != INVALID_STATE && compiledStates[currentIndex]->onExit) {
+        compiledStates[currentIndex]->onExit();
+    }
+    currentIndex = index;
+    currentState = *stateNames[index];
+    // The target has been playing for the length of the blend
+    stateTime = transitionTime;
+    if (compiledStates[index]->onEnter) {
+        compiledStates[index]->onEnter();
     }
 }
 
 void AnimationSystem::AnimationStateMachine::Update(float deltaTime, Skeleton& skeleton) {
+    Update(deltaTime);
+}
+
+void AnimationSystem::AnimationStateMachine::Update(float deltaTime) {
+    if (!compiled) Compile();
+    if (currentIndex == INVALID_STATE) return;
+    
     // Update current state
-    if (!currentState.empty()) {
-        auto& state = states[currentState];
-        if (state.onUpdate) {
-            state.onUpdate(deltaTime);
-        }
+    const State& state = *compiledStates[currentIndex];
+    stateTime += deltaTime;
+    if (state.onUpdate) {
+        state.onUpdate(deltaTime);
     }
     
-    // Check for transitions
-    for (const auto& transition : transitions) {
-        if (transition.fromState == currentState && transition.condition && transition.condition()) {
+    // Check this state's transitions, in authored order. A running blend only gives way when it
+    // may be interrupted, and never to another transition into the same target
+    const bool canStart = !isTransitioning ||
+        (activeTransition >= 0 && compiledTransitions[activeTransition].canInterrupt);
+    if (canStart) {
+        const float normalizedTime = (state.clip && state.clip->duration > 0.0f) ? stateTime / state.clip->duration : stateTime;
+        for (uint32_t t = firstTransition[currentIndex]; t < firstTransition[currentIndex + 1]; ++t) {
+            const CompiledTransition& transition = compiledTransitions[t];
+            if (isTransitioning && transition.toState == targetIndex) continue;
+            if (transition.exitTime >= 0.0f && normalizedTime < transition.exitTime) continue;
+            if (!ConditionsHold(transition)) continue;
+            if (transition.hasCallback && !transitions[transition.source].condition()) continue;
+            
             // Start transition
-            targetState = transition.toState;
+            targetIndex = transition.toState;
+            targetState = *stateNames[targetIndex];
+            activeTransition = static_cast<int>(t);
             isTransitioning = true;
             transitionTime = 0.0f;
             transitionDuration = transition.duration;
@@ -731,8 +1493,9 @@ void AnimationSystem::AnimationStateMachine::Update(float deltaTime, Skeleton& s
         transitionTime += deltaTime;
         if (transitionTime >= transitionDuration) {
             // Complete transition
-            currentState = targetState;
+            EnterState(targetIndex);
             isTransitioning = false;
+            activeTransition = -1;
             transitionTime = 0.0f;
         }
     }
@@ -826,94 +1589,57 @@ void AnimationSystem::IKSolver::SolveJacobian(Skeleton& skeleton) {
 
 void AnimationSystem::FacialAnimation::SetExpressionWeight(const std::string& expression, float weight) {
     expressionWeights[expression] = weight;
-}
-
-void AnimationSystem::FacialAnimation::BlendShapes(std::vector<XMFLOAT3>& vertices, 
-                                                  std::vector<XMFLOAT3>& normals) {
-    // Apply blend shape deformations
     for (auto& blendShape : blendShapes) {
-        if (blendShape.weight > 0.0f) {
-            for (size_t i = 0; i < vertices.size() && i < blendShape.deltaVertices.size(); ++i) {
-                XMVECTOR vertex = XMLoadFloat3(&vertices[i]);
-                XMVECTOR delta = XMLoadFloat3(&blendShape.deltaVertices[i]);
-                vertex = XMVectorAdd(vertex, XMVectorScale(delta, blendShape.weight));
-                XMStoreFloat3(&vertices[i], vertex);
-                
-                XMVECTOR normal = XMLoadFloat3(&normals[i]);
-                XMVECTOR deltaNormal = XMLoadFloat3(&blendShape.deltaNormals[i]);
-                normal = XMVectorAdd(normal, XMVectorScale(deltaNormal, blendShape.weight));
-                XMStoreFloat3(&normals[i], normal);
-            }
+        if (blendShape.name == expression) {
+            blendShape.weight = weight;
         }
     }
 }
 
-void AnimationSystem::ClothSimulation::Update(float deltaTime) {
-    // Update cloth simulation
-    for (auto& particle : particles) {
-        if (!particle.isPinned) {
-            // Apply gravity
-            XMVECTOR vel = XMLoadFloat3(&particle.velocity);
-            XMVECTOR grav = XMLoadFloat3(&gravity);
-            vel = XMVectorAdd(vel, XMVectorScale(grav, deltaTime));
-            
-            // Apply damping
-            vel = XMVectorScale(vel, damping);
+void AnimationSystem::FacialAnimation::BlendShapes(std::vector<XMFLOAT3>& vertices, 
+                                                  std::vector<XMFLOAT3>& normals) {
+    // Apply blend shape deformations, visiting only the vertices each active shape moves
+    for (auto& blendShape : blendShapes) {
+        if (blendShape.weight == 0.0f) continue;
+        
+        const bool sparse = !blendShape.vertexIndices.empty();
+        const size_t count = std::min(blendShape.deltaVertices.size(), blendShape.deltaNormals.size());
+        for (size_t i = 0; i < count; ++i) {
+            const size_t vertexIndex = sparse ? blendShape.vertexIndices[i] : i;
+            if (vertexIndex >= vertices.size() || vertexIndex >= normals.size()) continue;
             
-            // Update position
-            XMVECTOR pos = XMLoadFloat3(&particle.position);
-            XMVECTOR newPos = XMVectorAdd(pos, XMVectorScale(vel, deltaTime));
+            XMVECTOR vertex = XMLoadFloat3(&vertices[vertexIndex]);
+            XMVECTOR delta = XMLoadFloat3(&blendShape.deltaVertices[i]);
+            XMStoreFloat3(&vertices[vertexIndex], XMVectorAdd(vertex, XMVectorScale(delta, blendShape.weight)));
             
-            XMStoreFloat3(&particle.oldPosition, pos);
-            XMStoreFloat3(&particle.position, newPos);
-            XMStoreFloat3(&particle.velocity, vel);
+            XMVECTOR normal = XMLoadFloat3(&normals[vertexIndex]);
+            XMVECTOR deltaNormal = XMLoadFloat3(&blendShape.deltaNormals[i]);
+            XMStoreFloat3(&normals[vertexIndex], XMVectorAdd(normal, XMVectorScale(deltaNormal, blendShape.weight)));
         }
     }
-    
-    // Apply constraints
-    ApplyConstraints();
 }
 
-void AnimationSystem::ClothSimulation::ApplyConstraints() {
-    // Apply distance constraints
-    for (const auto& constraint : constraints) {
-        XMVECTOR pos1 = XMLoadFloat3(&particles[constraint.particle1].position);
-        XMVECTOR pos2 = XMLoadFloat3(&particles[constraint.particle2].position);
-        
-        XMVECTOR delta = XMVectorSubtract(pos2, pos1);
-        float distance = XMVectorGetX(XMVector3Length(delta));
+void AnimationSystem::FacialAnimation::Compact(float epsilon) {
+    const float epsilonSq = epsilon * epsilon;
+    auto lengthSq = [](const XMFLOAT3& v) { return v.x * v.x + v.y * v.y + v.z * v.z; };
+    for (auto& blendShape : blendShapes) {
+        if (!blendShape.vertexIndices.empty()) continue;
         
-        if (distance > 0.001f) {
-            float difference = (constraint.restLength - distance) / distance;
-            XMVECTOR translate = XMVectorScale(delta, difference * constraint.stiffness * 0.5f);
-            
-            if (!particles[constraint.particle1].isPinned) {
-                pos1 = XMVectorSubtract(pos1, translate);
-                XMStoreFloat3(&particles[constraint.particle1].position, pos1);
-            }
-            if (!particles[constraint.particle2].isPinned) {
-                pos2 = XMVectorAdd(pos2, translate);
-                XMStoreFloat3(&particles[constraint.particle2].position, pos2);
-            }
+        // Compacted in place; the write cursor never passes the read one
+        const size_t count = std::min(blendShape.deltaVertices.size(), blendShape.deltaNormals.size());
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (lengthSq(blendShape.deltaVertices[i]) <= epsilonSq && lengthSq(blendShape.deltaNormals[i]) <= epsilonSq) continue;
+            blendShape.deltaVertices[kept] = blendShape.deltaVertices[i];
+            blendShape.deltaNormals[kept] = blendShape.deltaNormals[i];
+            blendShape.vertexIndices.push_back(static_cast<uint32_t>(i));
+            ++kept;
         }
-    }
-}
+        blendShape.deltaVertices.resize(kept);
+        blendShape.deltaNormals.resize(kept);
+        blendShape.deltaVertices.shrink_to_fit();
+        blendShape.deltaNormals.shrink_to_fit();
 
-void AnimationSystem::ClothSimulation::HandleCollisions(const std::vector<XMFLOAT3>& colliders) {
-    // Handle collisions with external objects
-    for (auto& particle : particles) {
-        for (const auto& collider : colliders) {
-            XMVECTOR particlePos = XMLoadFloat3(&particle.position);
-            XMVECTOR colliderPos = XMLoadFloat3(&collider);
-            XMVECTOR delta = XMVectorSubtract(particlePos, colliderPos);
-            float distance = XMVectorGetX(XMVector3Length(delta));
-            
-            if (distance < 1.0f) { // Collision radius
-                delta = XMVector3Normalize(delta);
-                XMVECTOR newPos = XMVectorAdd(colliderPos, XMVectorScale(delta, 1.0f));
-                XMStoreFloat3(&particle.position, newPos);
-            }
-        }
     }
 }
 
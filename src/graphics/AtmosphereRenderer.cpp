@@ -0,0 +1,668 @@
+#include "AtmosphereRenderer.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// Shared by every pass. Positions are in km relative to the planet center, y up; the camera
+// sits on the y axis
+const char* COMMON_SOURCE = R"(
+    cbuffer AtmosphereConstants : register(b0)
+    {
+        float4x4 InverseView;
+        float3 RayleighScattering;
+        float BottomRadius;
+        float3 MieScattering;
+        float TopRadius;
+        float3 OzoneAbsorption;
+        float RayleighScaleHeight;
+        float3 SunDirection;
+        float MieScaleHeight;
+        float3 SunIlluminance;
+        float OzoneCenter;
+        float OzoneWidth;
+        float MieAnisotropy;
+        float GroundAlbedo;
+        float CameraRadius;
+        float SunAngularRadius;
+        float Padding;
+        float2 ProjectionScale;
+        uint2 TransmittanceSize;
+        uint2 MultiScatteringSize;
+        uint2 SkyViewSize;
+        float2 Padding2;
+    };
+
+    Texture2D<float4> TransmittanceLut : register(t0);
+    Texture2D<float4> MultiScatteringLut : register(t1);
+    Texture2D<float4> SkyViewLut : register(t2);
+    SamplerState LinearClamp : register(s0);
+
+    #define PI 3.14159265f
+
+    // Nearest non-negative distance to a sphere around the planet center, -1 when missed
+    float RaySphere(float3 origin, float3 direction, float radius)
+    {
+        float b = dot(origin, direction);
+        float c = dot(origin, origin) - radius * radius;
+        float discriminant = b * b - c;
+        if (discriminant < 0.0f) return -1.0f;
+        float root = sqrt(discriminant);
+        float nearHit = -b - root;
+        float farHit = -b + root;
+        return nearHit >= 0.0f ? nearHit : (farHit >= 0.0f ? farHit : -1.0f);
+    }
+
+    struct Medium
+    {
+        float3 rayleigh;
+        float3 mie;
+        float3 scattering;
+        float3 extinction;
+    };
+
+    Medium SampleMedium(float radius)
+    {
+        float height = max(radius - BottomRadius, 0.0f);
+        float ozone = max(0.0f, 1.0f - abs(height - OzoneCenter) / OzoneWidth);
+        Medium medium;
+        medium.rayleigh = RayleighScattering * exp(-height / RayleighScaleHeight);
+        medium.mie = MieScattering * exp(-height / MieScaleHeight);
+        medium.scattering = medium.rayleigh + medium.mie;
+        // Mie aerosols absorb about a tenth of what they scatter
+        medium.extinction = max(medium.rayleigh + medium.mie * 1.11f + OzoneAbsorption * ozone, 1e-6f);
+        return medium;
+    }
+
+    // Bruneton's parameterization: altitude and distance to the top of the atmosphere
+    float2 TransmittanceUV(float r, float mu)
+    {
+        float H = sqrt(TopRadius * TopRadius - BottomRadius * BottomRadius);
+        float rho = sqrt(max(r * r - BottomRadius * BottomRadius, 0.0f));
+        float discriminant = r * r * (mu * mu - 1.0f) + TopRadius * TopRadius;
+        float d = max(0.0f, -r * mu + sqrt(max(discriminant, 0.0f)));
+        float dMin = TopRadius - r;
+        float dMax = rho + H;
+        return float2((d - dMin) / (dMax - dMin), rho / H);
+    }
+
+    float3 TransmittanceToTop(float r, float mu)
+    {
+        return TransmittanceLut.SampleLevel(LinearClamp, TransmittanceUV(r, mu), 0).rgb;
+    }
+
+    float3 MultiScattering(float r, float sunCos)
+    {
+        float2 uv = float2(sunCos * 0.5f + 0.5f, (r - BottomRadius) / (TopRadius - BottomRadius));
+        return MultiScatteringLut.SampleLevel(LinearClamp, saturate(uv), 0).rgb;
+    }
+
+    float RayleighPhase(float cosTheta)
+    {
+        return 3.0f / (16.0f * PI) * (1.0f + cosTheta * cosTheta);
+    }
+
+    // Cornette-Shanks
+    float MiePhase(float cosTheta)
+    {
+        float g = MieAnisotropy;
+        float g2 = g * g;
+        float k = 3.0f / (8.0f * PI) * (1.0f - g2) / (2.0f + g2);
+        return k * (1.0f + cosTheta * cosTheta) / pow(max(1.0f + g2 - 2.0f * g * cosTheta, 1e-4f), 1.5f);
+    }
+
+    // The sky view keeps texels dense around the horizon, where the sky changes fastest
+    float HorizonZenith(out float beta)
+    {
+        float horizon = sqrt(max(CameraRadius * CameraRadius - BottomRadius * BottomRadius, 0.0f));
+        beta = acos(clamp(horizon / CameraRadius, -1.0f, 1.0f));
+        return PI - beta;
+    }
+)";
+
+const char* TRANSMITTANCE_SHADER = R"(
+    RWTexture2D<float4> Transmittance : register(u0);
+
+    #define STEPS 40
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= TransmittanceSize)) return;
+
+        float2 uv = (float2(id.xy) + 0.5f) / float2(TransmittanceSize);
+        float H = sqrt(TopRadius * TopRadius - BottomRadius * BottomRadius);
+        float rho = H * uv.y;
+        float r = sqrt(rho * rho + BottomRadius * BottomRadius);
+        float dMin = TopRadius - r;
+        float dMax = rho + H;
+        float d = dMin + uv.x * (dMax - dMin);
+        float mu = d == 0.0f ? 1.0f : clamp((H * H - rho * rho - d * d) / (2.0f * r * d), -1.0f, 1.0f);
+
+        float3 origin = float3(0.0f, r, 0.0f);
+        float3 direction = float3(sqrt(1.0f - mu * mu), mu, 0.0f);
+        float dt = max(RaySphere(origin, direction, TopRadius), 0.0f) / STEPS;
+        float3 opticalDepth = 0.0f;
+        for (uint i = 0; i < STEPS; ++i) {
+            float3 p = origin + direction * ((float(i) + 0.5f) * dt);
+            opticalDepth += SampleMedium(length(p)).extinction * dt;
+        }
+        Transmittance[id.xy] = float4(exp(-opticalDepth), 1.0f);
+    }
+)";
+
+// Hillaire 2020, section 5.5: second-order light arriving from a uniform sphere of directions,
+// and the fraction f of light the medium around the point scatters back to it. Higher orders
+// are the geometric series 1 / (1 - f) over that
+const char* MULTI_SCATTERING_SHADER = R"(
+    RWTexture2D<float4> MultiScatteringTarget : register(u0);
+
+    #define DIRECTIONS 8
+    #define STEPS 20
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= MultiScatteringSize)) return;
+
+        float2 uv = (float2(id.xy) + 0.5f) / float2(MultiScatteringSize);
+        float sunCos = uv.x * 2.0f - 1.0f;
+        float r = lerp(BottomRadius + 0.01f, TopRadius - 0.01f, uv.y);
+        float3 origin = float3(0.0f, r, 0.0f);
+        float3 sun = float3(sqrt(saturate(1.0f - sunCos * sunCos)), sunCos, 0.0f);
+
+        float3 secondOrder = 0.0f;
+        float3 transfer = 0.0f;
+        for (uint j = 0; j < DIRECTIONS; ++j) {
+            for (uint i = 0; i < DIRECTIONS; ++i) {
+                float cosTheta = 1.0f - 2.0f * (float(j) + 0.5f) / DIRECTIONS;
+                float sinTheta = sqrt(saturate(1.0f - cosTheta * cosTheta));
+                float phi = 2.0f * PI * (float(i) + 0.5f) / DIRECTIONS;
+                float3 direction = float3(sinTheta * cos(phi), cosTheta, sinTheta * sin(phi));
+
+                float ground = RaySphere(origin, direction, BottomRadius);
+                float rayLength = ground >= 0.0f ? ground : max(RaySphere(origin, direction, TopRadius), 0.0f);
+                float dt = rayLength / STEPS;
+                float3 throughput = 1.0f;
+                float3 luminance = 0.0f;
+                float3 scattered = 0.0f;
+                for (uint s = 0; s < STEPS; ++s) {
+                    float3 p = origin + direction * ((float(s) + 0.5f) * dt);
+                    float height = length(p);
+                    Medium medium = SampleMedium(height);
+                    float3 stepTransmittance = exp(-medium.extinction * dt);
+                    float mu = dot(p / height, sun);
+                    float3 sunTransmittance = RaySphere(p, sun, BottomRadius) >= 0.0f ? 0.0f : TransmittanceToTop(height, mu);
+
+                    // Integrated analytically over the step with its own extinction
+                    float3 source = medium.scattering * sunTransmittance / (4.0f * PI);
+                    luminance += throughput * (source - source * stepTransmittance) / medium.extinction;
+                    scattered += throughput * (medium.scattering - medium.scattering * stepTransmittance) / medium.extinction;
+                    throughput *= stepTransmittance;
+                }
+                if (ground >= 0.0f) {
+                    float3 up = normalize(origin + direction * ground);
+                    float lit = dot(up, sun);
+                    luminance += throughput * TransmittanceToTop(BottomRadius, lit) * (saturate(lit) * GroundAlbedo / PI);
+                }
+                secondOrder += luminance;
+                transfer += scattered;
+            }
+        }
+        secondOrder /= DIRECTIONS * DIRECTIONS;
+        transfer /= DIRECTIONS * DIRECTIONS;
+        MultiScatteringTarget[id.xy] = float4(secondOrder / max(1.0f - transfer, 1e-3f), 1.0f);
+    }
+)";
+
+// Sky radiance around the camera for the current sun elevation, by view zenith angle and
+// azimuth from the sun. Steps grow quadratically since the air thins out along the ray
+const char* SKY_VIEW_SHADER = R"(
+    RWTexture2D<float4> SkyView : register(u0);
+
+    #define STEPS 32
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= SkyViewSize)) return;
+
+        float2 uv = (float2(id.xy) + 0.5f) / float2(SkyViewSize);
+        float beta;
+        float horizonZenith = HorizonZenith(beta);
+        float zenith;
+        if (uv.y < 0.5f) {
+            float coord = 1.0f - 2.0f * uv.y;
+            zenith = horizonZenith * (1.0f - coord * coord);
+        } else {
+            float coord = uv.y * 2.0f - 1.0f;
+            zenith = horizonZenith + beta * coord * coord;
+        }
+        float azimuth = uv.x * PI;
+        float3 direction = float3(sin(zenith) * cos(azimuth), cos(zenith), sin(zenith) * sin(azimuth));
+        float sunCos = SunDirection.y;
+        float3 sun = float3(sqrt(saturate(1.0f - sunCos * sunCos)), sunCos, 0.0f);
+        float cosTheta = dot(direction, sun);
+        float rayleighPhase = RayleighPhase(cosTheta);
+        float miePhase = MiePhase(cosTheta);
+
+        float3 origin = float3(0.0f, CameraRadius, 0.0f);
+        float ground = RaySphere(origin, direction, BottomRadius);
+        float rayLength = ground >= 0.0f ? ground : max(RaySphere(origin, direction, TopRadius), 0.0f);
+        float3 throughput = 1.0f;
+        float3 luminance = 0.0f;
+        float start = 0.0f;
+        for (uint s = 0; s < STEPS; ++s) {
+            float fraction = (float(s) + 1.0f) / STEPS;
+            float end = rayLength * fraction * fraction;
+            float dt = end - start;
+            float3 p = origin + direction * (start + dt * 0.5f);
+            start = end;
+
+            float height = length(p);
+            Medium medium = SampleMedium(height);
+            float3 stepTransmittance = exp(-medium.extinction * dt);
+            float mu = dot(p / height, sun);
+            float3 sunTransmittance = RaySphere(p, sun, BottomRadius) >= 0.0f ? 0.0f : TransmittanceToTop(height, mu);
+
+            float3 source = sunTransmittance * (medium.rayleigh * rayleighPhase + medium.mie * miePhase) +
+                            MultiScattering(height, mu) * medium.scattering;
+            luminance += throughput * (source - source * stepTransmittance) / medium.extinction;
+            throughput *= stepTransmittance;
+        }
+        SkyView[id.xy] = float4(luminance * SunIlluminance, 1.0f);
+    }
+)";
+
+// Fullscreen triangle on the far plane, so the depth test keeps it behind the scene
+const char* SKY_VS = R"(
+struct Output
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+Output main(uint id : SV_VertexID)
+{
+    Output output;
+    output.uv = float2((id << 1) & 2, id & 2);
+    output.position = float4(output.uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 1.0f, 1.0f);
+    return output;
+}
+)";
+
+const char* SKY_PS = R"(
+    float4 main(float4 position : SV_POSITION, float2 uv : TEXCOORD0) : SV_TARGET
+    {
+        float2 ndc = uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+        float3 direction = normalize(mul(float3(ndc / ProjectionScale, 1.0f), (float3x3)InverseView));
+
+        // Inverse of the sky view mapping, with the azimuth measured from the sun's
+        float beta;
+        float horizonZenith = HorizonZenith(beta);
+        float zenith = acos(clamp(direction.y, -1.0f, 1.0f));
+        float v = zenith < horizonZenith ? 0.5f * (1.0f - sqrt(1.0f - zenith / horizonZenith))
+                                         : 0.5f * (1.0f + sqrt((zenith - horizonZenith) / beta));
+        float2 viewAzimuth = dot(direction.xz, direction.xz) > 1e-8f ? normalize(direction.xz) : float2(1.0f, 0.0f);
+        float2 sunAzimuth = dot(SunDirection.xz, SunDirection.xz) > 1e-8f ? normalize(SunDirection.xz) : float2(1.0f, 0.0f);
+        float u = acos(clamp(dot(viewAzimuth, sunAzimuth), -1.0f, 1.0f)) / PI;
+        float3 color = SkyViewLut.SampleLevel(LinearClamp, float2(u, v), 0).rgb;
+
+        float3 origin = float3(0.0f, CameraRadius, 0.0f);
+        if (dot(direction, SunDirection) > cos(SunAngularRadius) && RaySphere(origin, direction, BottomRadius) < 0.0f) {
+            float solidAngle = PI * SunAngularRadius * SunAngularRadius;
+            color += SunIlluminance * TransmittanceToTop(CameraRadius, direction.y) / solidAngle;
+        }
+        return float4(color, 1.0f);
+    }
+)";
+
+constexpr UINT GROUP_SIZE = 8;
+constexpr UINT MAX_TABLE_SIZE = 1024;
+constexpr float METERS_PER_KM = 1000.0f;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3DBlob* CompileShader(const std::string& source, const char* name, const char* target) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+ID3D11ComputeShader* CompileComputeShader(ID3D11Device* device, const char* source, const char* name) {
+    ID3DBlob* blob = CompileShader(std::string(COMMON_SOURCE) + source, name, "cs_5_0");
+    if (!blob) return nullptr;
+    ID3D11ComputeShader* shader = nullptr;
+    HRESULT hr = device->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &shader);
+    blob->Release();
+    return SUCCEEDED(hr) ? shader : nullptr;
+}
+
+bool CreateTable(ID3D11Device* device, UINT width, UINT height, ID3D11Texture2D** texture,
+                 ID3D11ShaderResourceView** view, ID3D11UnorderedAccessView** target) {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, texture))) return false;
+    if (FAILED(device->CreateShaderResourceView(*texture, nullptr, view))) return false;
+    return SUCCEEDED(device->CreateUnorderedAccessView(*texture, nullptr, target));
+}
+
+} // namespace
+
+AtmosphereRenderer::AtmosphereRenderer()
+    : device_(nullptr)
+    , context_(nullptr)
+    , transmittanceShader_(nullptr)
+    , multiScatteringShader_(nullptr)
+    , skyViewShader_(nullptr)
+    , skyVertexShader_(nullptr)
+    , skyPixelShader_(nullptr)
+    , constants_(nullptr)
+    , linearClamp_(nullptr)
+    , rasterizerState_(nullptr)
+    , depthState_(nullptr)
+    , transmittance_(nullptr)
+    , transmittanceView_(nullptr)
+    , transmittanceTarget_(nullptr)
+    , multiScattering_(nullptr)
+    , multiScatteringView_(nullptr)
+    , multiScatteringTarget_(nullptr)
+    , skyView_(nullptr)
+    , skyViewView_(nullptr)
+    , skyViewTarget_(nullptr)
+    , scatteringValid_(false)
+    , skyViewValid_(false)
+    , sunDirection_(0.0f, 1.0f, 0.0f)
+    , skyViewSunElevation_(0.0f)
+    , skyViewHeight_(0.0f)
+{
+}
+
+AtmosphereRenderer::~AtmosphereRenderer() {
+    Shutdown();
+}
+
+bool AtmosphereRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings) {
+    Shutdown();
+    if (!device || !context) return false;
+
+    device_ = device;
+    context_ = context;
+    if (!CreateShaders() || !SetSettings(settings)) {
+        Logger::Error("Failed to create atmosphere resources");
+        Shutdown();
+        return false;
+    }
+    Logger::Info("Atmosphere initialized: sky view " + std::to_string(settings_.skyViewWidth) + "x" +
+                 std::to_string(settings_.skyViewHeight));
+    return true;
+}
+
+void AtmosphereRenderer::Shutdown() {
+    SafeRelease(transmittanceShader_);
+    SafeRelease(multiScatteringShader_);
+    SafeRelease(skyViewShader_);
+    SafeRelease(skyVertexShader_);
+    SafeRelease(skyPixelShader_);
+    SafeRelease(constants_);
+    SafeRelease(linearClamp_);
+    SafeRelease(rasterizerState_);
+    SafeRelease(depthState_);
+    ReleaseTables();
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+bool AtmosphereRenderer::SetSettings(const Settings& settings) {
+    const bool resize = !transmittance_ || settings.transmittanceWidth != settings_.transmittanceWidth ||
+                        settings.transmittanceHeight != settings_.transmittanceHeight ||
+                        settings.multiScatteringSize != settings_.multiScatteringSize ||
+                        settings.skyViewWidth != settings_.skyViewWidth || settings.skyViewHeight != settings_.skyViewHeight;
+    settings_ = settings;
+    settings_.planetRadius = std::max(settings_.planetRadius, 1.0f);
+    settings_.atmosphereRadius = std::max(settings_.atmosphereRadius, settings_.planetRadius + 1.0f);
+    settings_.rayleighScaleHeight = std::max(settings_.rayleighScaleHeight, 1.0f);
+    settings_.mieScaleHeight = std::max(settings_.mieScaleHeight, 1.0f);
+    settings_.ozoneLayerWidth = std::max(settings_.ozoneLayerWidth, 1.0f);
+    settings_.mieAnisotropy = std::clamp(settings_.mieAnisotropy, -0.99f, 0.99f);
+    settings_.transmittanceWidth = std::clamp(settings_.transmittanceWidth, 1u, MAX_TABLE_SIZE);
+    settings_.transmittanceHeight = std::clamp(settings_.transmittanceHeight, 1u, MAX_TABLE_SIZE);
+    settings_.multiScatteringSize = std::clamp(settings_.multiScatteringSize, 1u, MAX_TABLE_SIZE);
+    settings_.skyViewWidth = std::clamp(settings_.skyViewWidth, 1u, MAX_TABLE_SIZE);
+    settings_.skyViewHeight = std::clamp(settings_.skyViewHeight, 1u, MAX_TABLE_SIZE);
+    scatteringValid_ = false;
+    skyViewValid_ = false;
+    if (!resize || !device_) return true;
+
+    ReleaseTables();
+    return CreateTables();
+}
+
+bool AtmosphereRenderer::CreateShaders() {
+    transmittanceShader_ = CompileComputeShader(device_, TRANSMITTANCE_SHADER, "AtmosphereTransmittance");
+    multiScatteringShader_ = CompileComputeShader(device_, MULTI_SCATTERING_SHADER, "AtmosphereMultiScattering");
+    skyViewShader_ = CompileComputeShader(device_, SKY_VIEW_SHADER, "AtmosphereSkyView");
+    if (!transmittanceShader_ || !multiScatteringShader_ || !skyViewShader_) return false;
+
+    ID3DBlob* blob = CompileShader(SKY_VS, "AtmosphereSky_VS", "vs_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &skyVertexShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(std::string(COMMON_SOURCE) + SKY_PS, "AtmosphereSky_PS", "ps_5_0");
+    if (!blob) return false;
+    hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &skyPixelShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = sizeof(GpuConstants);
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&bufferDesc, nullptr, &constants_))) return false;
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (FAILED(device_->CreateSamplerState(&samplerDesc, &linearClamp_))) return false;
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizerDesc, &rasterizerState_))) return false;
+
+    // Passes only where the depth buffer is still clear
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = TRUE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+    return SUCCEEDED(device_->CreateDepthStencilState(&depthDesc, &depthState_));
+}
+
+bool AtmosphereRenderer::CreateTables() {
+    return CreateTable(device_, settings_.transmittanceWidth, settings_.transmittanceHeight, &transmittance_,
+                       &transmittanceView_, &transmittanceTarget_) &&
+           CreateTable(device_, settings_.multiScatteringSize, settings_.multiScatteringSize, &multiScattering_,
+                       &multiScatteringView_, &multiScatteringTarget_) &&
+           CreateTable(device_, settings_.skyViewWidth, settings_.skyViewHeight, &skyView_, &skyViewView_, &skyViewTarget_);
+}
+
+void AtmosphereRenderer::ReleaseTables() {
+    SafeRelease(transmittanceTarget_);
+    SafeRelease(transmittanceView_);
+    SafeRelease(transmittance_);
+    SafeRelease(multiScatteringTarget_);
+    SafeRelease(multiScatteringView_);
+    SafeRelease(multiScattering_);
+    SafeRelease(skyViewTarget_);
+    SafeRelease(skyViewView_);
+    SafeRelease(skyView_);
+    scatteringValid_ = false;
+    skyViewValid_ = false;
+}
+
+AtmosphereRenderer::GpuConstants AtmosphereRenderer::BuildConstants() const {
+    GpuConstants constants = {};
+    DirectX::XMStoreFloat4x4(&constants.inverseView, DirectX::XMMatrixIdentity());
+    constants.rayleighScattering = settings_.rayleighScattering;
+    constants.mieScattering = settings_.mieScattering;
+    constants.ozoneAbsorption = settings_.ozoneAbsorption;
+    constants.bottomRadius = settings_.planetRadius / METERS_PER_KM;
+    constants.topRadius = settings_.atmosphereRadius / METERS_PER_KM;
+    constants.rayleighScaleHeight = settings_.rayleighScaleHeight / METERS_PER_KM;
+    constants.mieScaleHeight = settings_.mieScaleHeight / METERS_PER_KM;
+    constants.ozoneCenter = settings_.ozoneLayerCenter / METERS_PER_KM;
+    constants.ozoneWidth = settings_.ozoneLayerWidth / METERS_PER_KM;
+    constants.sunDirection = sunDirection_;
+    constants.sunIlluminance = DirectX::XMFLOAT3(settings_.sunIntensity, settings_.sunIntensity, settings_.sunIntensity);
+    constants.mieAnisotropy = settings_.mieAnisotropy;
+    constants.groundAlbedo = settings_.groundAlbedo;
+    // Kept a little inside the atmosphere so view rays always start in the medium
+    constants.cameraRadius = std::clamp((settings_.planetRadius + skyViewHeight_) / METERS_PER_KM,
+                                        constants.bottomRadius + 0.001f, constants.topRadius - 0.001f);
+    constants.sunAngularRadius = settings_.sunAngularRadius;
+    constants.projectionScale[0] = 1.0f;
+    constants.projectionScale[1] = 1.0f;
+    constants.transmittanceSize[0] = settings_.transmittanceWidth;
+    constants.transmittanceSize[1] = settings_.transmittanceHeight;
+    constants.multiScatteringSize[0] = settings_.multiScatteringSize;
+    constants.multiScatteringSize[1] = settings_.multiScatteringSize;
+    constants.skyViewSize[0] = settings_.skyViewWidth;
+    constants.skyViewSize[1] = settings_.skyViewHeight;
+    return constants;
+}
+
+bool AtmosphereRenderer::UploadConstants(const GpuConstants& constants) {
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return false;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+    return true;
+}
+
+void AtmosphereRenderer::Dispatch(ID3D11ComputeShader* shader, ID3D11UnorderedAccessView* target, UINT width, UINT height) {
+    context_->CSSetShader(shader, nullptr, 0);
+    context_->CSSetUnorderedAccessViews(0, 1, &target, nullptr);
+    context_->Dispatch((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+    ID3D11UnorderedAccessView* nullTarget = nullptr;
+    context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+}
+
+void AtmosphereRenderer::Update(const DirectX::XMFLOAT3& sunDirection, float cameraHeight) {
+    if (!device_ || !transmittance_) return;
+
+    DirectX::XMVECTOR sun = DirectX::XMLoadFloat3(&sunDirection);
+    if (DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(sun)) < 1e-12f) return;
+    DirectX::XMStoreFloat3(&sunDirection_, DirectX::XMVector3Normalize(sun));
+    cameraHeight = std::max(cameraHeight, 0.0f);
+
+    // The sky view is drawn in a frame aligned with the sun's azimuth, so only elevation matters
+    const float elevation = std::asin(std::clamp(sunDirection_.y, -1.0f, 1.0f));
+    const bool skyViewCurrent = skyViewValid_ && scatteringValid_ &&
+                                std::fabs(elevation - skyViewSunElevation_) <= settings_.sunAngleThreshold &&
+                                std::fabs(cameraHeight - skyViewHeight_) <= settings_.heightThreshold;
+    if (skyViewCurrent) return;
+    NEXUS_PROFILE_SCOPE("AtmosphereRenderer::Update");
+
+    skyViewSunElevation_ = elevation;
+    skyViewHeight_ = cameraHeight;
+    if (!UploadConstants(BuildConstants())) return;
+    context_->CSSetConstantBuffers(0, 1, &constants_);
+    context_->CSSetSamplers(0, 1, &linearClamp_);
+
+    ID3D11ShaderResourceView* nullViews[2] = {};
+    if (!scatteringValid_) {
+        context_->CSSetShaderResources(0, 2, nullViews);
+        Dispatch(transmittanceShader_, transmittanceTarget_, settings_.transmittanceWidth, settings_.transmittanceHeight);
+        context_->CSSetShaderResources(0, 1, &transmittanceView_);
+        Dispatch(multiScatteringShader_, multiScatteringTarget_, settings_.multiScatteringSize, settings_.multiScatteringSize);
+        scatteringValid_ = true;
+        ++stats_.scatteringUpdates;
+    }
+
+    ID3D11ShaderResourceView* views[2] = { transmittanceView_, multiScatteringView_ };
+    context_->CSSetShaderResources(0, 2, views);
+    Dispatch(skyViewShader_, skyViewTarget_, settings_.skyViewWidth, settings_.skyViewHeight);
+    context_->CSSetShaderResources(0, 2, nullViews);
+    context_->CSSetShader(nullptr, nullptr, 0);
+    skyViewValid_ = true;
+    ++stats_.skyViewUpdates;
+}
+
+void AtmosphereRenderer::RenderSky(StateCache& stateCache, ID3D11RenderTargetView* target,
+                                   ID3D11DepthStencilView* depthTarget, DirectX::FXMMATRIX view,
+                                   DirectX::CXMMATRIX projection, UINT width, UINT height) {
+    if (!device_ || !skyViewValid_ || !target || width == 0 || height == 0) return;
+    NEXUS_PROFILE_SCOPE("AtmosphereRenderer::RenderSky");
+
+    // Rotation only, the sky is at infinity. Its inverse is its transpose
+    DirectX::XMMATRIX rotation = view;
+    rotation.r[3] = DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+    DirectX::XMMATRIX inverseRotation = DirectX::XMMatrixTranspose(rotation);
+    DirectX::XMFLOAT4X4 projectionValues;
+    DirectX::XMStoreFloat4x4(&projectionValues, projection);
+
+    GpuConstants constants = BuildConstants();
+    DirectX::XMStoreFloat4x4(&constants.inverseView, DirectX::XMMatrixTranspose(inverseRotation));
+    constants.projectionScale[0] = projectionValues._11;
+    constants.projectionScale[1] = projectionValues._22;
+    if (!UploadConstants(constants)) return;
+
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = static_cast<float>(width);
+    viewport.Height = static_cast<float>(height);
+    viewport.MaxDepth = 1.0f;
+    stateCache.OMSetRenderTargets(1, &target, depthTarget);
+    stateCache.RSSetViewports(1, &viewport);
+    stateCache.RSSetState(rasterizerState_);
+    stateCache.OMSetBlendState(nullptr, nullptr, 0xffffffff);
+    stateCache.OMSetDepthStencilState(depthState_, 0);
+    stateCache.IASetInputLayout(nullptr);
+    stateCache.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    stateCache.VSSetShader(skyVertexShader_);
+    stateCache.PSSetShader(skyPixelShader_);
+    stateCache.PSSetConstantBuffers(0, 1, &constants_);
+    ID3D11ShaderResourceView* views[3] = { transmittanceView_, multiScatteringView_, skyViewView_ };
+    stateCache.PSSetShaderResources(0, 3, views);
+    stateCache.PSSetSamplers(0, 1, &linearClamp_);
+    context_->Draw(3, 0);
+
+    // The tables are written as compute targets on the next regeneration
+    ID3D11ShaderResourceView* nullViews[3] = {};
+    stateCache.PSSetShaderResources(0, 3, nullViews);
+}
+
+} // namespace Nexus
@@ -0,0 +1,782 @@
+#include "BlockCompressor.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// SSE2 is part of the x64 baseline, so these need no runtime dispatch
+#include <emmintrin.h>
+
+namespace Nexus {
+
+namespace {
+
+// Float planes of one 4x4 block. weight is 0 for pixels a fit should ignore (BC1 transparency)
+struct BlockPixels {
+    alignas(16) float channel[4][16];
+    alignas(16) float weight[16];
+};
+
+const int RGB_CHANNELS[3] = { 0, 1, 2 };
+const int RGBA_CHANNELS[4] = { 0, 1, 2, 3 };
+
+const int BC7_WEIGHTS2[4] = { 0, 21, 43, 64 };
+const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Distance from every pixel to each palette entry, four pixels per iteration. palette[e][k]
+// holds entry e's value for channels[k]. Returns the weighted squared error of the choice
+float FindIndices(const BlockPixels& block, const int* channels, int channelCount,
+                  const float (*palette)[4], int entries, uint8_t indices[16]) {
+    __m128 total = _mm_setzero_ps();
+    for (int group = 0; group < 16; group += 4) {
+        __m128 pixel[4];
+        for (int k = 0; k < channelCount; ++k) {
+            pixel[k] = _mm_load_ps(&block.channel[channels[k]][group]);
+        }
+
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (int entry = 0; entry < entries; ++entry) {
+            __m128 distance = _mm_setzero_ps();
+            for (int k = 0; k < channelCount; ++k) {
+                const __m128 difference = _mm_sub_ps(pixel[k], _mm_set1_ps(palette[entry][k]));
+                distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+            }
+            const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+            best = _mm_min_ps(distance, best);
+            bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex),
+                                     _mm_and_si128(closer, _mm_set1_epi32(entry)));
+        }
+        total = _mm_add_ps(total, _mm_mul_ps(best, _mm_load_ps(&block.weight[group])));
+
+        alignas(16) int32_t chosen[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(chosen), bestIndex);
+        for (int i = 0; i < 4; ++i) {
+            indices[group + i] = static_cast<uint8_t>(chosen[i]);
+        }
+    }
+
+    alignas(16) float sums[4];
+    _mm_store_ps(sums, total);
+    return sums[0] + sums[1] + sums[2] + sums[3];
+}
+
+// Weighted mean and dominant direction of the given channels
+void FindPrincipalAxis(const BlockPixels& block, const int* channels, int count, float mean[4], float axis[4]) {
+    float totalWeight = 0.0f;
+    for (int k = 0; k < count; ++k) mean[k] = 0.0f;
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        const float weight = block.weight[pixel];
+        totalWeight += weight;
+        for (int k = 0; k < count; ++k) {
+            mean[k] += block.channel[channels[k]][pixel] * weight;
+        }
+    }
+    if (totalWeight > 0.0f) {
+        for (int k = 0; k < count; ++k) mean[k] /= totalWeight;
+    }
+
+    float covariance[4][4] = {};
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        float offset[4];
+        for (int k = 0; k < count; ++k) {
+            offset[k] = block.channel[channels[k]][pixel] - mean[k];
+        }
+        for (int i = 0; i < count; ++i) {
+            for (int j = 0; j < count; ++j) {
+                covariance[i][j] += offset[i] * offset[j] * block.weight[pixel];
+            }
+        }
+    }
+
+    // Power iteration from the channel with the most variance
+    int largest = 0;
+    for (int k = 1; k < count; ++k) {
+        if (covariance[k][k] > covariance[largest][largest]) largest = k;
+    }
+    for (int k = 0; k < count; ++k) axis[k] = covariance[largest][k];
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {};
+        for (int i = 0; i < count; ++i) {
+            for (int j = 0; j < count; ++j) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+        }
+        float length = 0.0f;
+        for (int k = 0; k < count; ++k) length += next[k] * next[k];
+        if (length < 1e-12f) break;
+        length = 1.0f / std::sqrt(length);
+        for (int k = 0; k < count; ++k) axis[k] = next[k] * length;
+    }
+
+    float length = 0.0f;
+    for (int k = 0; k < count; ++k) length += axis[k] * axis[k];
+    if (length < 1e-12f) {
+        for (int k = 0; k < count; ++k) axis[k] = 0.0f;
+    } else {
+        length = 1.0f / std::sqrt(length);
+        for (int k = 0; k < count; ++k) axis[k] *= length;
+    }
+}
+
+// Endpoints at the extreme projections of the block onto its principal axis
+void FitEndpoints(const BlockPixels& block, const int* channels, int count, float e0[4], float e1[4]) {
+    float mean[4], axis[4];
+    FindPrincipalAxis(block, channels, count, mean, axis);
+
+    float low = FLT_MAX, high = -FLT_MAX;
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        if (block.weight[pixel] <= 0.0f) continue;
+        float projection = 0.0f;
+        for (int k = 0; k < count; ++k) {
+            projection += (block.channel[channels[k]][pixel] - mean[k]) * axis[k];
+        }
+        low = std::min(low, projection);
+        high = std::max(high, projection);
+    }
+    if (low > high) low = high = 0.0f;
+
+    for (int k = 0; k < count; ++k) {
+        e0[k] = mean[k] + axis[k] * low;
+        e1[k] = mean[k] + axis[k] * high;
+    }
+}
+
+// Least-squares endpoints for fixed indices; fractions[index] is how far index sits from e0
+// toward e1. Leaves the endpoints alone when the indices do not pin both of them down
+void RefineEndpoints(const BlockPixels& block, const int* channels, int count, const uint8_t indices[16],
+                     const float* fractions, float e0[4], float e1[4]) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float x0[4] = {}, x1[4] = {};
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        const float weight = block.weight[pixel];
+        const float b = fractions[indices[pixel]];
+        const float a = 1.0f - b;
+        aa += a * a * weight;
+        ab += a * b * weight;
+        bb += b * b * weight;
+        for (int k = 0; k < count; ++k) {
+            const float value = block.channel[channels[k]][pixel] * weight;
+            x0[k] += a * value;
+            x1[k] += b * value;
+        }
+    }
+
+    const float determinant = aa * bb - ab * ab;
+    if (std::fabs(determinant) < 1e-6f) return;
+    const float inverse = 1.0f / determinant;
+    for (int k = 0; k < count; ++k) {
+        e0[k] = std::min(255.0f, std::max(0.0f, (bb * x0[k] - ab * x1[k]) * inverse));
+        e1[k] = std::min(255.0f, std::max(0.0f, (aa * x1[k] - ab * x0[k]) * inverse));
+    }
+}
+
+int Quantize(float value, int maxValue) {
+    return std::min(maxValue, std::max(0, static_cast<int>(value * maxValue / 255.0f + 0.5f)));
+}
+
+struct BitWriter {
+    uint8_t* data;
+    int position;
+
+    void Write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++position) {
+            if ((value >> i) & 1) {
+                data[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+            }
+        }
+    }
+};
+
+// BC1 colour
+
+uint16_t PackColor565(const float color[4]) {
+    return static_cast<uint16_t>((Quantize(color[0], 31) << 11) | (Quantize(color[1], 63) << 5) | Quantize(color[2], 31));
+}
+
+void ExpandColor565(uint16_t color, int rgb[3]) {
+    const int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Matches the decoder's integer rounding; threeColor is BC1's c0 <= c1 mode without its
+// transparent entry
+void BuildColorPalette(uint16_t c0, uint16_t c1, bool threeColor, float palette[4][4]) {
+    int a[3], b[3];
+    ExpandColor565(c0, a);
+    ExpandColor565(c1, b);
+    for (int k = 0; k < 3; ++k) {
+        palette[0][k] = static_cast<float>(a[k]);
+        palette[1][k] = static_cast<float>(b[k]);
+        if (threeColor) {
+            palette[2][k] = static_cast<float>((a[k] + b[k]) / 2);
+            palette[3][k] = 0.0f;
+        } else {
+            palette[2][k] = static_cast<float>((2 * a[k] + b[k]) / 3);
+            palette[3][k] = static_cast<float>((a[k] + 2 * b[k]) / 3);
+        }
+    }
+}
+
+struct ColorBlock {
+    uint16_t c0 = 0;
+    uint16_t c1 = 0;
+    uint8_t indices[16] = {};
+    float error = FLT_MAX;
+};
+
+ColorBlock FitColor(const BlockPixels& block, bool threeColor, int refinements) {
+    static const float FOUR_COLOR_FRACTIONS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    static const float THREE_COLOR_FRACTIONS[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+    const float* fractions = threeColor ? THREE_COLOR_FRACTIONS : FOUR_COLOR_FRACTIONS;
+
+    float e0[4], e1[4];
+    FitEndpoints(block, RGB_CHANNELS, 3, e0, e1);
+
+    ColorBlock best;
+    for (int pass = 0; pass <= refinements; ++pass) {
+        ColorBlock candidate;
+        candidate.c0 = PackColor565(e0);
+        candidate.c1 = PackColor565(e1);
+        float palette[4][4];
+        BuildColorPalette(candidate.c0, candidate.c1, threeColor, palette);
+        candidate.error = FindIndices(block, RGB_CHANNELS, 3, palette, threeColor ? 3 : 4, candidate.indices);
+        if (candidate.error < best.error) {
+            best = candidate;
+        }
+        if (best.error == 0.0f) break;
+        RefineEndpoints(block, RGB_CHANNELS, 3, candidate.indices, fractions, e0, e1);
+    }
+    return best;
+}
+
+// Orders the endpoints for the chosen mode (c0 > c1 selects four colours) and writes
+// transparent pixels as index 3
+void WriteColorBlock(ColorBlock color, bool threeColor, const BlockPixels& block, uint8_t* output) {
+    if (color.c0 == color.c1) {
+        // Every entry decodes to the same colour (or is transparent); only index 3 must be kept
+        for (uint8_t& index : color.indices) index = 0;
+    } else if ((color.c0 < color.c1) != threeColor) {
+        std::swap(color.c0, color.c1);
+        // Four-colour mode swaps both pairs; three-colour mode keeps the midpoint and transparency
+        for (uint8_t& index : color.indices) {
+            if (index < 2 || !threeColor) index ^= 1;
+        }
+    }
+    if (threeColor) {
+        for (int pixel = 0; pixel < 16; ++pixel) {
+            if (block.weight[pixel] <= 0.0f) color.indices[pixel] = 3;
+        }
+    }
+
+    output[0] = static_cast<uint8_t>(color.c0);
+    output[1] = static_cast<uint8_t>(color.c0 >> 8);
+    output[2] = static_cast<uint8_t>(color.c1);
+    output[3] = static_cast<uint8_t>(color.c1 >> 8);
+    uint32_t bits = 0;
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        bits |= static_cast<uint32_t>(color.indices[pixel]) << (pixel * 2);
+    }
+    std::memcpy(output + 4, &bits, 4);
+}
+
+int GetRefinements(int quality) {
+    return quality < 25 ? 0 : quality < 60 ? 1 : quality < 85 ? 2 : 4;
+}
+
+void CompressColor(const BlockPixels& source, bool allowTransparent, int quality, uint8_t* output) {
+    BlockPixels block = source;
+    bool transparent = false;
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        block.weight[pixel] = 1.0f;
+        if (allowTransparent && block.channel[3][pixel] < 128.0f) {
+            block.weight[pixel] = 0.0f;
+            transparent = true;
+        }
+    }
+
+    const int refinements = GetRefinements(quality);
+    if (transparent) {
+        ColorBlock color;
+        bool anyOpaque = false;
+        for (float weight : block.weight) anyOpaque |= weight > 0.0f;
+        if (anyOpaque) color = FitColor(block, true, refinements);
+        WriteColorBlock(color, true, block, output);
+        return;
+    }
+
+    ColorBlock color = FitColor(block, false, refinements);
+    bool threeColor = false;
+    // BC2/BC3 always decode four colours, so only BC1 can use the midpoint mode for opaque blocks
+    if (allowTransparent && quality >= 60 && color.error > 0.0f) {
+        ColorBlock alternative = FitColor(block, true, refinements);
+        if (alternative.error < color.error) {
+            color = alternative;
+            threeColor = true;
+        }
+    }
+    WriteColorBlock(color, threeColor, block, output);
+}
+
+// BC4 planes (BC3 alpha, BC4, both BC5 channels)
+
+void BuildPlanePalette(int a0, int a1, float palette[8][4]) {
+    palette[0][0] = static_cast<float>(a0);
+    palette[1][0] = static_cast<float>(a1);
+    if (a0 > a1) {
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1][0] = static_cast<float>(((7 - i) * a0 + i * a1) / 7);
+        }
+    } else {
+        for (int i = 1; i < 5; ++i) {
+            palette[i + 1][0] = static_cast<float>(((5 - i) * a0 + i * a1) / 5);
+        }
+        palette[6][0] = 0.0f;
+        palette[7][0] = 255.0f;
+    }
+}
+
+float EvaluatePlane(const BlockPixels& block, int channel, int a0, int a1, uint8_t indices[16]) {
+    float palette[8][4];
+    BuildPlanePalette(a0, a1, palette);
+    return FindIndices(block, &channel, 1, palette, 8, indices);
+}
+
+void CompressPlane(const BlockPixels& source, int channel, int quality, uint8_t* output) {
+    BlockPixels block = source;
+    std::fill(std::begin(block.weight), std::end(block.weight), 1.0f);
+
+    int low = 255, high = 0, innerLow = 255, innerHigh = 0;
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        const int value = static_cast<int>(block.channel[channel][pixel]);
+        low = std::min(low, value);
+        high = std::max(high, value);
+        if (value > 0 && value < 255) {
+            innerLow = std::min(innerLow, value);
+            innerHigh = std::max(innerHigh, value);
+        }
+    }
+
+    // Eight-value mode needs a0 > a1; a flat block takes the six-value mode with every index 0
+    int bestA0 = high, bestA1 = low;
+    uint8_t bestIndices[16];
+    float bestError = EvaluatePlane(block, channel, bestA0, bestA1, bestIndices);
+
+    uint8_t indices[16];
+    auto tryEndpoints = [&](int a0, int a1) {
+        if (a0 < 0 || a0 > 255 || a1 < 0 || a1 > 255) return;
+        const float error = EvaluatePlane(block, channel, a0, a1, indices);
+        if (error < bestError) {
+            bestError = error;
+            bestA0 = a0;
+            bestA1 = a1;
+            std::memcpy(bestIndices, indices, 16);
+        }
+    };
+
+    // Six interpolated values plus exact 0 and 255 suit blocks with a few saturated texels
+    if (quality >= 40 && bestError > 0.0f && innerLow <= innerHigh && (low == 0 || high == 255)) {
+        tryEndpoints(innerLow, innerHigh);
+    }
+    if (quality >= 70 && bestError > 0.0f && high > low) {
+        const int radius = quality >= 90 ? 2 : 1;
+        const int centerA0 = high, centerA1 = low;
+        for (int d0 = -radius; d0 <= radius; ++d0) {
+            for (int d1 = -radius; d1 <= radius; ++d1) {
+                if (centerA0 + d0 > centerA1 + d1) tryEndpoints(centerA0 + d0, centerA1 + d1);
+            }
+        }
+    }
+
+    std::memset(output, 0, 8);
+    output[0] = static_cast<uint8_t>(bestA0);
+    output[1] = static_cast<uint8_t>(bestA1);
+    BitWriter writer = { output, 16 };
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        writer.Write(bestIndices[pixel], 3);
+    }
+}
+
+// BC7
+
+struct Bc7Candidate {
+    uint8_t bytes[16];
+    float error = FLT_MAX;
+};
+
+// Mode 6: RGBA endpoints of 7 bits plus a shared low bit per endpoint, 4-bit indices
+void QuantizeWithPBit(const float endpoint[4], int value[4], int& pBit) {
+    float bestError = FLT_MAX;
+    for (int p = 0; p < 2; ++p) {
+        float error = 0.0f;
+        int candidate[4];
+        for (int k = 0; k < 4; ++k) {
+            const int q = std::min(127, std::max(0, static_cast<int>((endpoint[k] - p) * 0.5f + 0.5f)));
+            candidate[k] = (q << 1) | p;
+            error += (candidate[k] - endpoint[k]) * (candidate[k] - endpoint[k]);
+        }
+        if (error < bestError) {
+            bestError = error;
+            pBit = p;
+            std::memcpy(value, candidate, sizeof(candidate));
+        }
+    }
+}
+
+void EncodeMode6(const BlockPixels& block, int refinements, Bc7Candidate& best) {
+    static const float FRACTIONS[16] = {
+        0.0f, 4.0f / 64.0f, 9.0f / 64.0f, 13.0f / 64.0f, 17.0f / 64.0f, 21.0f / 64.0f, 26.0f / 64.0f, 30.0f / 64.0f,
+        34.0f / 64.0f, 38.0f / 64.0f, 43.0f / 64.0f, 47.0f / 64.0f, 51.0f / 64.0f, 55.0f / 64.0f, 60.0f / 64.0f, 1.0f
+    };
+
+    float e0[4], e1[4];
+    FitEndpoints(block, RGBA_CHANNELS, 4, e0, e1);
+
+    for (int pass = 0; pass <= refinements; ++pass) {
+        int v0[4], v1[4], p0 = 0, p1 = 0;
+        QuantizeWithPBit(e0, v0, p0);
+        QuantizeWithPBit(e1, v1, p1);
+
+        float palette[16][4];
+        for (int i = 0; i < 16; ++i) {
+            for (int k = 0; k < 4; ++k) {
+                palette[i][k] = static_cast<float>(((64 - BC7_WEIGHTS4[i]) * v0[k] + BC7_WEIGHTS4[i] * v1[k] + 32) >> 6);
+            }
+        }
+        uint8_t indices[16];
+        const float error = FindIndices(block, RGBA_CHANNELS, 4, palette, 16, indices);
+        if (error < best.error) {
+            // The first pixel's index drops its top bit, so it must be below 8
+            const bool swapped = indices[0] >= 8;
+            best.error = error;
+            std::memset(best.bytes, 0, 16);
+            BitWriter writer = { best.bytes, 0 };
+            writer.Write(1 << 6, 7);
+            for (int k = 0; k < 4; ++k) {
+                writer.Write((swapped ? v1[k] : v0[k]) >> 1, 7);
+                writer.Write((swapped ? v0[k] : v1[k]) >> 1, 7);
+            }
+            writer.Write(swapped ? p1 : p0, 1);
+            writer.Write(swapped ? p0 : p1, 1);
+            for (int pixel = 0; pixel < 16; ++pixel) {
+                writer.Write(swapped ? 15 - indices[pixel] : indices[pixel], pixel == 0 ? 3 : 4);
+            }
+        }
+        if (best.error == 0.0f) break;
+        RefineEndpoints(block, RGBA_CHANNELS, 4, indices, FRACTIONS, e0, e1);
+    }
+}
+
+// Mode 5: 7-bit colour and 8-bit scalar endpoints with separate 2-bit indices. A rotation swaps
+// alpha with one colour channel so the channel that varies independently gets its own indices
+void EncodeMode5(const BlockPixels& block, int rotation, int refinements, Bc7Candidate& best) {
+    static const float FRACTIONS[4] = { 0.0f, 21.0f / 64.0f, 43.0f / 64.0f, 1.0f };
+
+    int colorChannels[3] = { 0, 1, 2 };
+    int scalarChannel = 3;
+    if (rotation > 0) {
+        colorChannels[rotation - 1] = 3;
+        scalarChannel = rotation - 1;
+    }
+
+    // Colour and scalar are fitted independently; their errors simply add
+    float colorError = FLT_MAX, scalarError = FLT_MAX;
+    int bestColor0[3] = {}, bestColor1[3] = {}, bestScalar0 = 0, bestScalar1 = 0;
+    uint8_t colorIndices[16] = {}, scalarIndices[16] = {};
+
+    float e0[4], e1[4];
+    FitEndpoints(block, colorChannels, 3, e0, e1);
+    for (int pass = 0; pass <= refinements; ++pass) {
+        int v0[3], v1[3];
+        float palette[4][4];
+        for (int k = 0; k < 3; ++k) {
+            const int q0 = Quantize(e0[k], 127), q1 = Quantize(e1[k], 127);
+            v0[k] = (q0 << 1) | (q0 >> 6);
+            v1[k] = (q1 << 1) | (q1 >> 6);
+        }
+        for (int i = 0; i < 4; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                palette[i][k] = static_cast<float>(((64 - BC7_WEIGHTS2[i]) * v0[k] + BC7_WEIGHTS2[i] * v1[k] + 32) >> 6);
+            }
+        }
+        uint8_t indices[16];
+        const float error = FindIndices(block, colorChannels, 3, palette, 4, indices);
+        if (error < colorError) {
+            colorError = error;
+            std::memcpy(bestColor0, v0, sizeof(v0));
+            std::memcpy(bestColor1, v1, sizeof(v1));
+            std::memcpy(colorIndices, indices, 16);
+        }
+        if (colorError == 0.0f) break;
+        RefineEndpoints(block, colorChannels, 3, indices, FRACTIONS, e0, e1);
+    }
+
+    float s0[4], s1[4];
+    FitEndpoints(block, &scalarChannel, 1, s0, s1);
+    for (int pass = 0; pass <= refinements; ++pass) {
+        const int v0 = Quantize(s0[0], 255), v1 = Quantize(s1[0], 255);
+        float palette[4][4];
+        for (int i = 0; i < 4; ++i) {
+            palette[i][0] = static_cast<float>(((64 - BC7_WEIGHTS2[i]) * v0 + BC7_WEIGHTS2[i] * v1 + 32) >> 6);
+        }
+        uint8_t indices[16];
+        const float error = FindIndices(block, &scalarChannel, 1, palette, 4, indices);
+        if (error < scalarError) {
+            scalarError = error;
+            bestScalar0 = v0;
+            bestScalar1 = v1;
+            std::memcpy(scalarIndices, indices, 16);
+        }
+        if (scalarError == 0.0f) break;
+        RefineEndpoints(block, &scalarChannel, 1, indices, FRACTIONS, s0, s1);
+    }
+
+    if (colorError + scalarError >= best.error) return;
+
+    // Both index sets drop the first pixel's top bit
+    if (colorIndices[0] >= 2) {
+        std::swap(bestColor0, bestColor1);
+        for (uint8_t& index : colorIndices) index = static_cast<uint8_t>(3 - index);
+    }
+    if (scalarIndices[0] >= 2) {
+        std::swap(bestScalar0, bestScalar1);
+        for (uint8_t& index : scalarIndices) index = static_cast<uint8_t>(3 - index);
+    }
+
+    best.error = colorError + scalarError;
+    std::memset(best.bytes, 0, 16);
+    BitWriter writer = { best.bytes, 0 };
+    writer.Write(1 << 5, 6);
+    writer.Write(rotation, 2);
+    for (int k = 0; k < 3; ++k) {
+        writer.Write(bestColor0[k] >> 1, 7);
+        writer.Write(bestColor1[k] >> 1, 7);
+    }
+    writer.Write(bestScalar0, 8);
+    writer.Write(bestScalar1, 8);
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        writer.Write(colorIndices[pixel], pixel == 0 ? 1 : 2);
+    }
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        writer.Write(scalarIndices[pixel], pixel == 0 ? 1 : 2);
+    }
+}
+
+void CompressBC7(const BlockPixels& source, int quality, uint8_t* output) {
+    BlockPixels block = source;
+    std::fill(std::begin(block.weight), std::end(block.weight), 1.0f);
+
+    Bc7Candidate best;
+    const int refinements = GetRefinements(quality);
+    EncodeMode6(block, refinements, best);
+    if (quality >= 40 && best.error > 0.0f) {
+        const int rotations = quality >= 75 ? 4 : 1;
+        for (int rotation = 0; rotation < rotations && best.error > 0.0f; ++rotation) {
+            EncodeMode5(block, rotation, refinements, best);
+        }
+    }
+    std::memcpy(output, best.bytes, 16);
+}
+
+// BC6H
+
+// Half-float bit patterns, up to the largest finite one, onto the 0-255 range the shared fitting
+// code clamps to. The patterns are close to logarithmic, so errors there are relative to
+// brightness the way the eye sees them
+const float BC6H_SCALE = 255.0f / 0x7BFF;
+
+void LoadHalfBlock(const uint16_t pixels[64], BlockPixels& block) {
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        for (int k = 0; k < 3; ++k) {
+            const uint16_t half = pixels[pixel * 4 + k];
+            // Negatives become zero, infinities and NaNs the largest finite value
+            const int value = (half & 0x8000) ? 0 : std::min<int>(half, 0x7BFF);
+            block.channel[k][pixel] = value * BC6H_SCALE;
+        }
+        block.channel[3][pixel] = 0.0f;
+        block.weight[pixel] = 1.0f;
+    }
+}
+
+// 10-bit endpoint to the 16-bit value the hardware interpolates
+int UnquantizeBC6H(int q) {
+    if (q == 0) return 0;
+    if (q == 1023) return 0xFFFF;
+    return ((q << 16) + 0x8000) >> 10;
+}
+
+int QuantizeBC6H(float value) {
+    const float unquantized = value / BC6H_SCALE * (64.0f / 31.0f);
+    return std::min(1023, std::max(0, static_cast<int>((unquantized - 32.0f) / 64.0f + 0.5f)));
+}
+
+// Mode 11 of BC6H_UF16: one subset, 10-bit RGB endpoints stored as they are, 4-bit indices
+void EncodeBC6H(const BlockPixels& block, int quality, uint8_t* output) {
+    float fractions[16];
+    for (int i = 0; i < 16; ++i) fractions[i] = BC7_WEIGHTS4[i] / 64.0f;
+
+    float e0[4], e1[4];
+    FitEndpoints(block, RGB_CHANNELS, 3, e0, e1);
+
+    float bestError = FLT_MAX;
+    const int refinements = GetRefinements(quality);
+    for (int pass = 0; pass <= refinements; ++pass) {
+        int q0[3], q1[3], u0[3], u1[3];
+        for (int k = 0; k < 3; ++k) {
+            q0[k] = QuantizeBC6H(e0[k]);
+            q1[k] = QuantizeBC6H(e1[k]);
+            u0[k] = UnquantizeBC6H(q0[k]);
+            u1[k] = UnquantizeBC6H(q1[k]);
+        }
+
+        // Exactly what the hardware decodes: interpolate, then scale back to half bits
+        float palette[16][4];
+        for (int i = 0; i < 16; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                const int value = ((64 - BC7_WEIGHTS4[i]) * u0[k] + BC7_WEIGHTS4[i] * u1[k] + 32) >> 6;
+                palette[i][k] = ((value * 31) >> 6) * BC6H_SCALE;
+            }
+            palette[i][3] = 0.0f;
+        }
+        uint8_t indices[16];
+        const float error = FindIndices(block, RGB_CHANNELS, 3, palette, 16, indices);
+        if (error < bestError) {
+            // As in BC7, the first pixel's index drops its top bit
+            const bool swapped = indices[0] >= 8;
+            bestError = error;
+            std::memset(output, 0, 16);
+            BitWriter writer = { output, 0 };
+            writer.Write(0x03, 5);
+            for (int k = 0; k < 3; ++k) writer.Write(swapped ? q1[k] : q0[k], 10);
+            for (int k = 0; k < 3; ++k) writer.Write(swapped ? q0[k] : q1[k], 10);
+            for (int pixel = 0; pixel < 16; ++pixel) {
+                writer.Write(swapped ? 15 - indices[pixel] : indices[pixel], pixel == 0 ? 3 : 4);
+            }
+        }
+        if (bestError == 0.0f) break;
+        RefineEndpoints(block, RGB_CHANNELS, 3, indices, fractions, e0, e1);
+    }
+}
+}
+
+size_t BlockCompressor::GetBlockBytes(Format format) {
+    return format == Format::BC1 || format == Format::BC4 ? 8 : 16;
+}
+
+size_t BlockCompressor::GetCompressedSize(Format format, int width, int height) {
+    if (width <= 0 || height <= 0) return 0;
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockBytes(format);
+}
+
+void BlockCompressor::CompressBlock(Format format, const uint8_t pixels[64], uint8_t* output, int quality) {
+    BlockPixels block;
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        for (int k = 0; k < 4; ++k) {
+            block.channel[k][pixel] = pixels[pixel * 4 + k];
+        }
+        block.weight[pixel] = 1.0f;
+    }
+
+    quality = std::min(100, std::max(0, quality));
+    switch (format) {
+    case Format::BC1:
+        CompressColor(block, true, quality, output);
+        break;
+    case Format::BC3:
+        CompressPlane(block, 3, quality, output);
+        CompressColor(block, false, quality, output + 8);
+        break;
+    case Format::BC4:
+        CompressPlane(block, 0, quality, output);
+        break;
+    case Format::BC5:
+        CompressPlane(block, 0, quality, output);
+        CompressPlane(block, 1, quality, output + 8);
+        break;
+    case Format::BC7:
+        CompressBC7(block, quality, output);
+        break;
+    }
+}
+
+bool BlockCompressor::Compress(Format format, const uint8_t* pixels, size_t inputPitch, int width, int height,
+                               uint8_t* output, size_t outputSize, int quality, JobSystem* jobs) {
+    if (!pixels || !output || width <= 0 || height <= 0) return false;
+    if (outputSize < GetCompressedSize(format, width, height) || inputPitch < static_cast<size_t>(width) * 4) return false;
+
+    const size_t blockBytes = GetBlockBytes(format);
+    const size_t blocksWide = (width + 3) / 4;
+    const size_t blocksHigh = (height + 3) / 4;
+
+    auto compressRows = [&](size_t begin, size_t end) {
+        uint8_t block[64];
+        for (size_t blockRow = begin; blockRow < end; ++blockRow) {
+            for (size_t blockColumn = 0; blockColumn < blocksWide; ++blockColumn) {
+                // Clamp to the last row and column so edge blocks fit only visible texels
+                for (int y = 0; y < 4; ++y) {
+                    const size_t row = std::min<size_t>(blockRow * 4 + y, height - 1);
+                    for (int x = 0; x < 4; ++x) {
+                        const size_t column = std::min<size_t>(blockColumn * 4 + x, width - 1);
+                        std::memcpy(block + (y * 4 + x) * 4, pixels + row * inputPitch + column * 4, 4);
+                    }
+                }
+                CompressBlock(format, block, output + (blockRow * blocksWide + blockColumn) * blockBytes, quality);
+            }
+        }
+    };
+
+    if (jobs && jobs->IsInitialized() && blocksHigh > 1) {
+        const size_t grain = std::max<size_t>(1, 256 / blocksWide);
+        jobs->ParallelFor(blocksHigh, grain, compressRows);
+    } else {
+        compressRows(0, blocksHigh);
+    }
+    return true;
+}
+
+void BlockCompressor::CompressBlockBC6H(const uint16_t pixels[64], uint8_t* output, int quality) {
+    BlockPixels block;
+    LoadHalfBlock(pixels, block);
+    EncodeBC6H(block, std::min(100, std::max(0, quality)), output);
+}
+
+bool BlockCompressor::CompressBC6H(const uint16_t* pixels, size_t inputPitch, int width, int height,
+                                   uint8_t* output, size_t outputSize, int quality, JobSystem* jobs) {
+    if (!pixels || !output || width <= 0 || height <= 0) return false;
+    if (outputSize < GetCompressedSize(Format::BC7, width, height) || inputPitch < static_cast<size_t>(width) * 8) {
+        return false;
+    }
+
+    const size_t blocksWide = (width + 3) / 4;
+    const size_t blocksHigh = (height + 3) / 4;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(pixels);
+
+    auto compressRows = [&](size_t begin, size_t end) {
+        uint16_t block[64];
+        for (size_t blockRow = begin; blockRow < end; ++blockRow) {
+            for (size_t blockColumn = 0; blockColumn < blocksWide; ++blockColumn) {
+                for (int y = 0; y < 4; ++y) {
+                    const size_t row = std::min<size_t>(blockRow * 4 + y, height - 1);
+                    for (int x = 0; x < 4; ++x) {
+                        const size_t column = std::min<size_t>(blockColumn * 4 + x, width - 1);
+                        std::memcpy(block + (y * 4 + x) * 4, bytes + row * inputPitch + column * 8, 8);
+                    }
+                }
+                CompressBlockBC6H(block, output + (blockRow * blocksWide + blockColumn) * 16, quality);
+            }
+        }
+    };
+
+    if (jobs && jobs->IsInitialized() && blocksHigh > 1) {
+        const size_t grain = std::max<size_t>(1, 256 / blocksWide);
+        jobs->ParallelFor(blocksHigh, grain, compressRows);
+    } else {
+        compressRows(0, blocksHigh);
+    }
+    return true;
+}
+
+} // namespace Nexus
@@ -0,0 +1,588 @@
+#include "BlockDecompressor.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC emits any intrinsic regardless of /arch; the dispatch below keeps them off older CPUs
+#define NEXUS_TARGET_SSE41
+#define NEXUS_TARGET_AVX2
+#else
+#define NEXUS_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define NEXUS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace Nexus {
+
+namespace {
+
+// Byte shuffles shared by the SIMD paths
+struct ShuffleTables {
+    // One row of four 2-bit colour indices -> four RGBA pixels taken from a 4-entry palette
+    alignas(16) uint8_t colorRows[256][16];
+    // [channel][row]: sixteen per-pixel bytes -> that row's four pixels, into the given channel
+    alignas(16) uint8_t channelRows[4][4][16];
+
+    ShuffleTables() {
+        for (int bits = 0; bits < 256; ++bits) {
+            for (int pixel = 0; pixel < 4; ++pixel) {
+                const int index = (bits >> (pixel * 2)) & 3;
+                for (int channel = 0; channel < 4; ++channel) {
+                    colorRows[bits][pixel * 4 + channel] = static_cast<uint8_t>(index * 4 + channel);
+                }
+            }
+        }
+        for (int channel = 0; channel < 4; ++channel) {
+            for (int row = 0; row < 4; ++row) {
+                for (int byte = 0; byte < 16; ++byte) {
+                    channelRows[channel][row][byte] =
+                        (byte % 4) == channel ? static_cast<uint8_t>(row * 4 + byte / 4) : 0x80;
+                }
+            }
+        }
+    }
+};
+
+const ShuffleTables& GetTables() {
+    static const ShuffleTables tables;
+    return tables;
+}
+
+BlockDecompressor::InstructionSet DetectInstructionSet() {
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0 && (info[2] & (1 << 9)) != 0;
+    const bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osAvx) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse41 = __builtin_cpu_supports("sse4.1") != 0;
+    const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+    if (avx2) return BlockDecompressor::InstructionSet::AVX2;
+    if (sse41) return BlockDecompressor::InstructionSet::SSE41;
+    return BlockDecompressor::InstructionSet::Scalar;
+}
+
+BlockDecompressor::InstructionSet GetSupportedInstructionSet() {
+    static const BlockDecompressor::InstructionSet supported = DetectInstructionSet();
+    return supported;
+}
+
+std::atomic<int> g_instructionSet{-1};
+
+// Scalar reference decoders. Pixels are RGBA8 packed little-endian, 16 per block in row order
+
+uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+void DecodeColorScalar(const uint8_t* color, bool allowTransparent, uint32_t pixels[16]) {
+    const uint32_t c0 = color[0] | (color[1] << 8);
+    const uint32_t c1 = color[2] | (color[3] << 8);
+    const uint32_t r0 = ((c0 >> 11) << 3) | (c0 >> 13), g0 = (((c0 >> 5) & 63) << 2) | ((c0 >> 9) & 3);
+    const uint32_t b0 = ((c0 & 31) << 3) | ((c0 >> 2) & 7);
+    const uint32_t r1 = ((c1 >> 11) << 3) | (c1 >> 13), g1 = (((c1 >> 5) & 63) << 2) | ((c1 >> 9) & 3);
+    const uint32_t b1 = ((c1 & 31) << 3) | ((c1 >> 2) & 7);
+
+    // BC1 switches to three colours plus transparent black when c0 <= c1; BC2/BC3 never do
+    uint32_t palette[4];
+    palette[0] = PackRGBA(r0, g0, b0, 255);
+    palette[1] = PackRGBA(r1, g1, b1, 255);
+    if (c0 > c1 || !allowTransparent) {
+        palette[2] = PackRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 255);
+        palette[3] = PackRGBA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 255);
+    } else {
+        palette[2] = PackRGBA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+        palette[3] = 0;
+    }
+
+    const uint32_t indices = color[4] | (color[5] << 8) | (color[6] << 16) | (static_cast<uint32_t>(color[7]) << 24);
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        pixels[pixel] = palette[(indices >> (pixel * 2)) & 3];
+    }
+}
+
+void DecodeIndices(const uint8_t* block, uint8_t indices[16]) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) {
+        bits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+    }
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        indices[pixel] = static_cast<uint8_t>((bits >> (pixel * 3)) & 7);
+    }
+}
+
+// BC3 alpha, BC4 and each BC5 channel: two endpoints and 3-bit indices into 8 values
+void DecodePlaneScalar(const uint8_t* block, uint8_t values[16]) {
+    const uint32_t a0 = block[0], a1 = block[1];
+    uint8_t palette[8] = { block[0], block[1] };
+    if (a0 > a1) {
+        for (uint32_t i = 1; i < 7; ++i) {
+            palette[i + 1] = static_cast<uint8_t>(((7 - i) * a0 + i * a1) / 7);
+        }
+    } else {
+        for (uint32_t i = 1; i < 5; ++i) {
+            palette[i + 1] = static_cast<uint8_t>(((5 - i) * a0 + i * a1) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint8_t indices[16];
+    DecodeIndices(block, indices);
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        values[pixel] = palette[indices[pixel]];
+    }
+}
+
+void DecodeBlockScalar(BlockDecompressor::Format format, const uint8_t* block, uint8_t* output, size_t outputPitch) {
+    using Format = BlockDecompressor::Format;
+    uint32_t pixels[16];
+    uint8_t red[16], green[16];
+
+    switch (format) {
+    case Format::BC1:
+        DecodeColorScalar(block, true, pixels);
+        break;
+    case Format::BC2:
+        DecodeColorScalar(block + 8, false, pixels);
+        for (int pixel = 0; pixel < 16; ++pixel) {
+            const uint32_t alpha = ((block[pixel / 2] >> ((pixel & 1) * 4)) & 15) * 17;
+            pixels[pixel] = (pixels[pixel] & 0x00FFFFFF) | (alpha << 24);
+        }
+        break;
+    case Format::BC3:
+        DecodeColorScalar(block + 8, false, pixels);
+        DecodePlaneScalar(block, red);
+        for (int pixel = 0; pixel < 16; ++pixel) {
+            pixels[pixel] = (pixels[pixel] & 0x00FFFFFF) | (static_cast<uint32_t>(red[pixel]) << 24);
+        }
+        break;
+    case Format::BC4:
+        DecodePlaneScalar(block, red);
+        for (int pixel = 0; pixel < 16; ++pixel) {
+            pixels[pixel] = PackRGBA(red[pixel], 0, 0, 255);
+        }
+        break;
+    case Format::BC5:
+        DecodePlaneScalar(block, red);
+        DecodePlaneScalar(block + 8, green);
+        for (int pixel = 0; pixel < 16; ++pixel) {
+            pixels[pixel] = PackRGBA(red[pixel], green[pixel], 0, 255);
+        }
+        break;
+    }
+
+    for (int row = 0; row < 4; ++row) {
+        std::memcpy(output + row * outputPitch, pixels + row * 4, 16);
+    }
+}
+
+void DecompressBlocksScalar(BlockDecompressor::Format format, const uint8_t* blocks, size_t blockCount,
+                            uint8_t* output, size_t outputPitch) {
+    const size_t blockBytes = BlockDecompressor::GetBlockBytes(format);
+    for (size_t i = 0; i < blockCount; ++i) {
+        DecodeBlockScalar(format, blocks + i * blockBytes, output + i * 16, outputPitch);
+    }
+}
+
+// SSE4.1: colour palettes for four blocks at once, one block per 32-bit lane
+
+NEXUS_TARGET_SSE41 inline __m128i Expand5(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi32(value, 3), _mm_srli_epi32(value, 2));
+}
+
+NEXUS_TARGET_SSE41 inline __m128i Expand6(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi32(value, 2), _mm_srli_epi32(value, 4));
+}
+
+// Exact x / 3 for x < 2^16 sitting in the low half of each 32-bit lane
+NEXUS_TARGET_SSE41 inline __m128i Divide3(__m128i value) {
+    return _mm_mulhi_epu16(value, _mm_set1_epi16(21846));
+}
+
+NEXUS_TARGET_SSE41 inline __m128i PackChannels(__m128i r, __m128i g, __m128i b, __m128i a) {
+    return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), a));
+}
+
+// color points at the first block's colour half; palettes[i] receives block i's four colours
+NEXUS_TARGET_SSE41 void BuildPalettesSSE41(const uint8_t* color, size_t stride, bool allowTransparent,
+                                           __m128i palettes[4]) {
+    uint32_t endpoints[4];
+    for (int i = 0; i < 4; ++i) {
+        std::memcpy(&endpoints[i], color + i * stride, 4);
+    }
+    const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(endpoints));
+    const __m128i c0 = _mm_and_si128(packed, _mm_set1_epi32(0xFFFF));
+    const __m128i c1 = _mm_srli_epi32(packed, 16);
+    const __m128i mask5 = _mm_set1_epi32(31), mask6 = _mm_set1_epi32(63);
+
+    const __m128i r0 = Expand5(_mm_srli_epi32(c0, 11));
+    const __m128i g0 = Expand6(_mm_and_si128(_mm_srli_epi32(c0, 5), mask6));
+    const __m128i b0 = Expand5(_mm_and_si128(c0, mask5));
+    const __m128i r1 = Expand5(_mm_srli_epi32(c1, 11));
+    const __m128i g1 = Expand6(_mm_and_si128(_mm_srli_epi32(c1, 5), mask6));
+    const __m128i b1 = Expand5(_mm_and_si128(c1, mask5));
+
+    const __m128i fourColor = allowTransparent ? _mm_cmpgt_epi32(c0, c1) : _mm_set1_epi32(-1);
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+
+    // Two thirds / one third in four-colour mode, the midpoint and transparent black otherwise
+    const __m128i r2 = _mm_blendv_epi8(_mm_srli_epi32(_mm_add_epi32(r0, r1), 1),
+                                       Divide3(_mm_add_epi32(_mm_add_epi32(r0, r0), r1)), fourColor);
+    const __m128i g2 = _mm_blendv_epi8(_mm_srli_epi32(_mm_add_epi32(g0, g1), 1),
+                                       Divide3(_mm_add_epi32(_mm_add_epi32(g0, g0), g1)), fourColor);
+    const __m128i b2 = _mm_blendv_epi8(_mm_srli_epi32(_mm_add_epi32(b0, b1), 1),
+                                       Divide3(_mm_add_epi32(_mm_add_epi32(b0, b0), b1)), fourColor);
+    const __m128i r3 = _mm_and_si128(Divide3(_mm_add_epi32(r0, _mm_add_epi32(r1, r1))), fourColor);
+    const __m128i g3 = _mm_and_si128(Divide3(_mm_add_epi32(g0, _mm_add_epi32(g1, g1))), fourColor);
+    const __m128i b3 = _mm_and_si128(Divide3(_mm_add_epi32(b0, _mm_add_epi32(b1, b1))), fourColor);
+
+    const __m128i p0 = PackChannels(r0, g0, b0, opaque);
+    const __m128i p1 = PackChannels(r1, g1, b1, opaque);
+    const __m128i p2 = PackChannels(r2, g2, b2, opaque);
+    const __m128i p3 = PackChannels(r3, g3, b3, _mm_and_si128(opaque, fourColor));
+
+    // Transpose from one colour per register to one block per register
+    const __m128i t0 = _mm_unpacklo_epi32(p0, p1);
+    const __m128i t1 = _mm_unpacklo_epi32(p2, p3);
+    const __m128i t2 = _mm_unpackhi_epi32(p0, p1);
+    const __m128i t3 = _mm_unpackhi_epi32(p2, p3);
+    palettes[0] = _mm_unpacklo_epi64(t0, t1);
+    palettes[1] = _mm_unpackhi_epi64(t0, t1);
+    palettes[2] = _mm_unpacklo_epi64(t2, t3);
+    palettes[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+// BC2 alpha: sixteen 4-bit values, widened to bytes in pixel order
+NEXUS_TARGET_SSE41 __m128i DecodeExplicitAlphaSSE41(const uint8_t* block) {
+    const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i values = _mm_unpacklo_epi8(_mm_and_si128(bytes, nibble),
+                                             _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+    return _mm_or_si128(values, _mm_slli_epi16(values, 4));
+}
+
+// BC3 alpha / BC4 / BC5 channel as sixteen bytes in pixel order
+NEXUS_TARGET_SSE41 __m128i DecodePlaneSSE41(const uint8_t* block) {
+    const int a0 = block[0], a1 = block[1];
+    __m128i values;
+    if (a0 > a1) {
+        values = _mm_add_epi16(_mm_mullo_epi16(_mm_set1_epi16(static_cast<short>(a0)), _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1)),
+                               _mm_mullo_epi16(_mm_set1_epi16(static_cast<short>(a1)), _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6)));
+        values = _mm_mulhi_epu16(values, _mm_set1_epi16(9363));    // Exact / 7 below 2^16 / 9363
+    } else {
+        values = _mm_add_epi16(_mm_mullo_epi16(_mm_set1_epi16(static_cast<short>(a0)), _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0)),
+                               _mm_mullo_epi16(_mm_set1_epi16(static_cast<short>(a1)), _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0)));
+        values = _mm_mulhi_epu16(values, _mm_set1_epi16(13108));   // Exact / 5 in range
+        values = _mm_or_si128(values, _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255));
+    }
+    const __m128i palette = _mm_packus_epi16(values, values);
+
+    alignas(16) uint8_t indices[16];
+    DecodeIndices(block, indices);
+    return _mm_shuffle_epi8(palette, _mm_load_si128(reinterpret_cast<const __m128i*>(indices)));
+}
+
+NEXUS_TARGET_SSE41 inline __m128i LoadMask(const uint8_t* mask) {
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+NEXUS_TARGET_SSE41 void DecodeColorGroupSSE41(BlockDecompressor::Format format, const uint8_t* blocks,
+                                              uint8_t* output, size_t outputPitch, const ShuffleTables& tables) {
+    using Format = BlockDecompressor::Format;
+    const size_t stride = BlockDecompressor::GetBlockBytes(format);
+    const size_t colorOffset = format == Format::BC1 ? 0 : 8;
+
+    __m128i palettes[4];
+    BuildPalettesSSE41(blocks + colorOffset, stride, format == Format::BC1, palettes);
+
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    for (int i = 0; i < 4; ++i) {
+        const uint8_t* block = blocks + i * stride;
+        uint32_t indices;
+        std::memcpy(&indices, block + colorOffset + 4, 4);
+
+        __m128i alpha = _mm_setzero_si128();
+        if (format == Format::BC2) alpha = DecodeExplicitAlphaSSE41(block);
+        if (format == Format::BC3) alpha = DecodePlaneSSE41(block);
+
+        for (int row = 0; row < 4; ++row) {
+            __m128i pixels = _mm_shuffle_epi8(palettes[i], LoadMask(tables.colorRows[(indices >> (row * 8)) & 0xFF]));
+            if (format != Format::BC1) {
+                pixels = _mm_or_si128(_mm_and_si128(pixels, rgbMask),
+                                      _mm_shuffle_epi8(alpha, LoadMask(tables.channelRows[3][row])));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + row * outputPitch + i * 16), pixels);
+        }
+    }
+}
+
+NEXUS_TARGET_SSE41 void DecodePlaneBlockSSE41(BlockDecompressor::Format format, const uint8_t* block,
+                                              uint8_t* output, size_t outputPitch, const ShuffleTables& tables) {
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m128i red = DecodePlaneSSE41(block);
+    const bool twoChannels = format == BlockDecompressor::Format::BC5;
+    const __m128i green = twoChannels ? DecodePlaneSSE41(block + 8) : _mm_setzero_si128();
+
+    for (int row = 0; row < 4; ++row) {
+        __m128i pixels = _mm_or_si128(_mm_shuffle_epi8(red, LoadMask(tables.channelRows[0][row])), opaque);
+        if (twoChannels) {
+            pixels = _mm_or_si128(pixels, _mm_shuffle_epi8(green, LoadMask(tables.channelRows[1][row])));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + row * outputPitch), pixels);
+    }
+}
+
+NEXUS_TARGET_SSE41 void DecompressBlocksSSE41(BlockDecompressor::Format format, const uint8_t* blocks,
+                                              size_t blockCount, uint8_t* output, size_t outputPitch) {
+    using Format = BlockDecompressor::Format;
+    const ShuffleTables& tables = GetTables();
+    const size_t blockBytes = BlockDecompressor::GetBlockBytes(format);
+
+    if (format == Format::BC4 || format == Format::BC5) {
+        for (size_t i = 0; i < blockCount; ++i) {
+            DecodePlaneBlockSSE41(format, blocks + i * blockBytes, output + i * 16, outputPitch, tables);
+        }
+        return;
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= blockCount; i += 4) {
+        DecodeColorGroupSSE41(format, blocks + i * blockBytes, output + i * 16, outputPitch, tables);
+    }
+    DecompressBlocksScalar(format, blocks + i * blockBytes, blockCount - i, output + i * 16, outputPitch);
+}
+
+// AVX2: the same palette build over eight blocks, and two adjacent blocks per 32-byte row store
+
+NEXUS_TARGET_AVX2 inline __m256i Expand5AVX2(__m256i value) {
+    return _mm256_or_si256(_mm256_slli_epi32(value, 3), _mm256_srli_epi32(value, 2));
+}
+
+NEXUS_TARGET_AVX2 inline __m256i Expand6AVX2(__m256i value) {
+    return _mm256_or_si256(_mm256_slli_epi32(value, 2), _mm256_srli_epi32(value, 4));
+}
+
+NEXUS_TARGET_AVX2 inline __m256i Divide3AVX2(__m256i value) {
+    return _mm256_mulhi_epu16(value, _mm256_set1_epi16(21846));
+}
+
+NEXUS_TARGET_AVX2 inline __m256i PackChannelsAVX2(__m256i r, __m256i g, __m256i b, __m256i a) {
+    return _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(b, 16), a));
+}
+
+// pairs[k] receives the palettes of blocks 2k and 2k+1 in its low and high halves
+NEXUS_TARGET_AVX2 void BuildPalettesAVX2(const uint8_t* color, size_t stride, bool allowTransparent,
+                                         __m256i pairs[4]) {
+    uint32_t endpoints[8];
+    for (int i = 0; i < 8; ++i) {
+        std::memcpy(&endpoints[i], color + i * stride, 4);
+    }
+    const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(endpoints));
+    const __m256i c0 = _mm256_and_si256(packed, _mm256_set1_epi32(0xFFFF));
+    const __m256i c1 = _mm256_srli_epi32(packed, 16);
+    const __m256i mask5 = _mm256_set1_epi32(31), mask6 = _mm256_set1_epi32(63);
+
+    const __m256i r0 = Expand5AVX2(_mm256_srli_epi32(c0, 11));
+    const __m256i g0 = Expand6AVX2(_mm256_and_si256(_mm256_srli_epi32(c0, 5), mask6));
+    const __m256i b0 = Expand5AVX2(_mm256_and_si256(c0, mask5));
+    const __m256i r1 = Expand5AVX2(_mm256_srli_epi32(c1, 11));
+    const __m256i g1 = Expand6AVX2(_mm256_and_si256(_mm256_srli_epi32(c1, 5), mask6));
+    const __m256i b1 = Expand5AVX2(_mm256_and_si256(c1, mask5));
+
+    const __m256i fourColor = allowTransparent ? _mm256_cmpgt_epi32(c0, c1) : _mm256_set1_epi32(-1);
+    const __m256i opaque = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+
+    const __m256i r2 = _mm256_blendv_epi8(_mm256_srli_epi32(_mm256_add_epi32(r0, r1), 1),
+                                          Divide3AVX2(_mm256_add_epi32(_mm256_add_epi32(r0, r0), r1)), fourColor);
+    const __m256i g2 = _mm256_blendv_epi8(_mm256_srli_epi32(_mm256_add_epi32(g0, g1), 1),
+                                          Divide3AVX2(_mm256_add_epi32(_mm256_add_epi32(g0, g0), g1)), fourColor);
+    const __m256i b2 = _mm256_blendv_epi8(_mm256_srli_epi32(_mm256_add_epi32(b0, b1), 1),
+                                          Divide3AVX2(_mm256_add_epi32(_mm256_add_epi32(b0, b0), b1)), fourColor);
+    const __m256i r3 = _mm256_and_si256(Divide3AVX2(_mm256_add_epi32(r0, _mm256_add_epi32(r1, r1))), fourColor);
+    const __m256i g3 = _mm256_and_si256(Divide3AVX2(_mm256_add_epi32(g0, _mm256_add_epi32(g1, g1))), fourColor);
+    const __m256i b3 = _mm256_and_si256(Divide3AVX2(_mm256_add_epi32(b0, _mm256_add_epi32(b1, b1))), fourColor);
+
+    const __m256i p0 = PackChannelsAVX2(r0, g0, b0, opaque);
+    const __m256i p1 = PackChannelsAVX2(r1, g1, b1, opaque);
+    const __m256i p2 = PackChannelsAVX2(r2, g2, b2, opaque);
+    const __m256i p3 = PackChannelsAVX2(r3, g3, b3, _mm256_and_si256(opaque, fourColor));
+
+    // The unpacks transpose within each 128-bit half, leaving block i in the low half of
+    // palette[i] and block i + 4 in the high half; regroup them into adjacent pairs
+    const __m256i t0 = _mm256_unpacklo_epi32(p0, p1);
+    const __m256i t1 = _mm256_unpacklo_epi32(p2, p3);
+    const __m256i t2 = _mm256_unpackhi_epi32(p0, p1);
+    const __m256i t3 = _mm256_unpackhi_epi32(p2, p3);
+    const __m256i palette0 = _mm256_unpacklo_epi64(t0, t1);
+    const __m256i palette1 = _mm256_unpackhi_epi64(t0, t1);
+    const __m256i palette2 = _mm256_unpacklo_epi64(t2, t3);
+    const __m256i palette3 = _mm256_unpackhi_epi64(t2, t3);
+    pairs[0] = _mm256_permute2x128_si256(palette0, palette1, 0x20);
+    pairs[1] = _mm256_permute2x128_si256(palette2, palette3, 0x20);
+    pairs[2] = _mm256_permute2x128_si256(palette0, palette1, 0x31);
+    pairs[3] = _mm256_permute2x128_si256(palette2, palette3, 0x31);
+}
+
+NEXUS_TARGET_AVX2 inline __m256i CombineHalves(__m128i low, __m128i high) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+NEXUS_TARGET_AVX2 void DecodeColorGroupAVX2(BlockDecompressor::Format format, const uint8_t* blocks,
+                                            uint8_t* output, size_t outputPitch, const ShuffleTables& tables) {
+    using Format = BlockDecompressor::Format;
+    const size_t stride = BlockDecompressor::GetBlockBytes(format);
+    const size_t colorOffset = format == Format::BC1 ? 0 : 8;
+
+    __m256i pairs[4];
+    BuildPalettesAVX2(blocks + colorOffset, stride, format == Format::BC1, pairs);
+
+    const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+    for (int pair = 0; pair < 4; ++pair) {
+        const uint8_t* first = blocks + (pair * 2) * stride;
+        const uint8_t* second = first + stride;
+        uint32_t firstIndices, secondIndices;
+        std::memcpy(&firstIndices, first + colorOffset + 4, 4);
+        std::memcpy(&secondIndices, second + colorOffset + 4, 4);
+
+        __m256i alpha = _mm256_setzero_si256();
+        if (format == Format::BC2) alpha = CombineHalves(DecodeExplicitAlphaSSE41(first), DecodeExplicitAlphaSSE41(second));
+        if (format == Format::BC3) alpha = CombineHalves(DecodePlaneSSE41(first), DecodePlaneSSE41(second));
+
+        for (int row = 0; row < 4; ++row) {
+            const __m256i mask = CombineHalves(LoadMask(tables.colorRows[(firstIndices >> (row * 8)) & 0xFF]),
+                                               LoadMask(tables.colorRows[(secondIndices >> (row * 8)) & 0xFF]));
+            __m256i pixels = _mm256_shuffle_epi8(pairs[pair], mask);
+            if (format != Format::BC1) {
+                const __m256i alphaMask = _mm256_broadcastsi128_si256(LoadMask(tables.channelRows[3][row]));
+                pixels = _mm256_or_si256(_mm256_and_si256(pixels, rgbMask), _mm256_shuffle_epi8(alpha, alphaMask));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + row * outputPitch + pair * 32), pixels);
+        }
+    }
+}
+
+NEXUS_TARGET_AVX2 void DecompressBlocksAVX2(BlockDecompressor::Format format, const uint8_t* blocks,
+                                            size_t blockCount, uint8_t* output, size_t outputPitch) {
+    using Format = BlockDecompressor::Format;
+    // Single-channel formats have no palette to batch; the SSE4.1 path is already shuffle-bound
+    if (format == Format::BC4 || format == Format::BC5) {
+        DecompressBlocksSSE41(format, blocks, blockCount, output, outputPitch);
+        return;
+    }
+
+    const ShuffleTables& tables = GetTables();
+    const size_t blockBytes = BlockDecompressor::GetBlockBytes(format);
+    size_t i = 0;
+    for (; i + 8 <= blockCount; i += 8) {
+        DecodeColorGroupAVX2(format, blocks + i * blockBytes, output + i * 16, outputPitch, tables);
+    }
+    DecompressBlocksSSE41(format, blocks + i * blockBytes, blockCount - i, output + i * 16, outputPitch);
+}
+}
+
+size_t BlockDecompressor::GetBlockBytes(Format format) {
+    return format == Format::BC1 || format == Format::BC4 ? 8 : 16;
+}
+
+size_t BlockDecompressor::GetCompressedSize(Format format, int width, int height) {
+    if (width <= 0 || height <= 0) return 0;
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockBytes(format);
+}
+
+BlockDecompressor::InstructionSet BlockDecompressor::GetInstructionSet() {
+    int current = g_instructionSet.load(std::memory_order_relaxed);
+    if (current < 0) {
+        current = static_cast<int>(GetSupportedInstructionSet());
+        g_instructionSet.store(current, std::memory_order_relaxed);
+    }
+    return static_cast<InstructionSet>(current);
+}
+
+void BlockDecompressor::SetInstructionSet(InstructionSet instructionSet) {
+    const int supported = static_cast<int>(GetSupportedInstructionSet());
+    g_instructionSet.store(std::min(static_cast<int>(instructionSet), supported), std::memory_order_relaxed);
+}
+
+const char* BlockDecompressor::GetInstructionSetName(InstructionSet instructionSet) {
+    switch (instructionSet) {
+    case InstructionSet::AVX2: return "AVX2";
+    case InstructionSet::SSE41: return "SSE4.1";
+    default: return "scalar";
+    }
+}
+
+void BlockDecompressor::DecompressBlocks(Format format, const uint8_t* blocks, size_t blockCount,
+                                         uint8_t* output, size_t outputPitch) {
+    switch (GetInstructionSet()) {
+    case InstructionSet::AVX2:
+        DecompressBlocksAVX2(format, blocks, blockCount, output, outputPitch);
+        break;
+    case InstructionSet::SSE41:
+        DecompressBlocksSSE41(format, blocks, blockCount, output, outputPitch);
+        break;
+    default:
+        DecompressBlocksScalar(format, blocks, blockCount, output, outputPitch);
+        break;
+    }
+}
+
+bool BlockDecompressor::Decompress(Format format, const uint8_t* blocks, size_t size, int width, int height,
+                                   uint8_t* output, size_t outputPitch, JobSystem* jobs) {
+    if (!blocks || !output || width <= 0 || height <= 0) return false;
+    if (size < GetCompressedSize(format, width, height) || outputPitch < static_cast<size_t>(width) * 4) return false;
+
+    const size_t blockBytes = GetBlockBytes(format);
+    const size_t blocksWide = (width + 3) / 4;
+    const size_t blocksHigh = (height + 3) / 4;
+    const size_t fullColumns = width / 4;
+
+    auto decodeRows = [&](size_t begin, size_t end) {
+        // Blocks that hang over the right or bottom edge decode into a strip and are clipped
+        std::vector<uint8_t> strip;
+        for (size_t blockRow = begin; blockRow < end; ++blockRow) {
+            const uint8_t* source = blocks + blockRow * blocksWide * blockBytes;
+            uint8_t* target = output + blockRow * 4 * outputPitch;
+            const size_t rows = std::min<size_t>(4, height - blockRow * 4);
+
+            const size_t direct = rows == 4 ? fullColumns : 0;
+            if (direct > 0) {
+                DecompressBlocks(format, source, direct, target, outputPitch);
+            }
+            if (direct < blocksWide) {
+                const size_t remaining = blocksWide - direct;
+                const size_t stripPitch = remaining * 16;
+                strip.resize(stripPitch * 4);
+                DecompressBlocks(format, source + direct * blockBytes, remaining, strip.data(), stripPitch);
+                const size_t visibleBytes = (static_cast<size_t>(width) - direct * 4) * 4;
+                for (size_t row = 0; row < rows; ++row) {
+                    std::memcpy(target + row * outputPitch + direct * 16, strip.data() + row * stripPitch, visibleBytes);
+                }
+            }
+        }
+    };
+
+    // A few block rows per job keeps scheduling overhead small next to the decode itself
+    if (jobs && jobs->IsInitialized() && blocksHigh > 1) {
+        const size_t grain = std::max<size_t>(1, 16384 / blocksWide);
+        jobs->ParallelFor(blocksHigh, grain, decodeRows);
+    } else {
+        decodeRows(0, blocksHigh);
+    }
+    return true;
+}
+
+} // namespace Nexus
@@ -0,0 +1,402 @@
+#include "BloomRenderer.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+
+// 13-tap downsample. Each group loads the 20x20 source texels its 8x8 outputs read into
+// groupshared memory; every tap is then the bilinear average of four of them. PREFILTER adds
+// the threshold on load and the Karis average over the five 2x2 boxes
+const char* DOWNSAMPLE_SHADER = R"(
+    cbuffer BloomConstants : register(b0)
+    {
+        uint2 SourceSize;
+        uint2 DestinationSize;
+        float Threshold;
+        float Knee;
+        float Scatter;
+        float Intensity;
+    };
+
+    Texture2D<float4> Source : register(t0);
+    RWTexture2D<float4> Destination : register(u0);
+
+    #define TILE 8
+    #define FOOTPRINT (TILE * 2 + 4)
+    groupshared float3 Tile[FOOTPRINT * FOOTPRINT];
+
+    float Luma(float3 color)
+    {
+        return dot(color, float3(0.2126f, 0.7152f, 0.0722f));
+    }
+
+    float3 Prefilter(float3 color)
+    {
+        float brightness = max(color.r, max(color.g, color.b));
+        float soft = clamp(brightness - Threshold + Knee, 0.0f, 2.0f * Knee);
+        soft = soft * soft / (4.0f * Knee + 1e-5f);
+        return color * (max(soft, brightness - Threshold) / max(brightness, 1e-5f));
+    }
+
+    // Bilinear sample at the corner shared by tile texels p - 1 and p
+    float3 Corner(int2 p)
+    {
+        int i = p.y * FOOTPRINT + p.x;
+        return 0.25f * (Tile[i - FOOTPRINT - 1] + Tile[i - FOOTPRINT] + Tile[i - 1] + Tile[i]);
+    }
+
+    float3 Box(float3 a, float3 b, float3 c, float3 d, out float weight)
+    {
+        float3 average = 0.25f * (a + b + c + d);
+    #ifdef PREFILTER
+        weight = 1.0f / (1.0f + Luma(average));
+    #else
+        weight = 1.0f;
+    #endif
+        return average;
+    }
+
+    [numthreads(TILE, TILE, 1)]
+    void main(uint3 groupId : SV_GroupID, uint3 local : SV_GroupThreadID, uint index : SV_GroupIndex)
+    {
+        int2 origin = int2(groupId.xy) * TILE * 2 - 2;
+        for (uint i = index; i < FOOTPRINT * FOOTPRINT; i += TILE * TILE) {
+            int2 texel = clamp(origin + int2(i % FOOTPRINT, i / FOOTPRINT), int2(0, 0), int2(SourceSize) - 1);
+            float3 color = Source.Load(int3(texel, 0)).rgb;
+    #ifdef PREFILTER
+            color = Prefilter(min(color, 65000.0f));
+    #endif
+            Tile[i] = color;
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        uint2 id = groupId.xy * TILE + local.xy;
+        if (any(id >= DestinationSize)) return;
+
+        // The output texel is centered on the corner between source texels 2 * id and 2 * id + 1
+        int2 c = int2(local.xy) * 2 + 3;
+        float3 a = Corner(c + int2(-2, -2)), b = Corner(c + int2(0, -2)), d = Corner(c + int2(2, -2));
+        float3 e = Corner(c + int2(-1, -1)), f = Corner(c + int2(1, -1));
+        float3 g = Corner(c + int2(-2, 0)), h = Corner(c), k = Corner(c + int2(2, 0));
+        float3 l = Corner(c + int2(-1, 1)), m = Corner(c + int2(1, 1));
+        float3 n = Corner(c + int2(-2, 2)), o = Corner(c + int2(0, 2)), q = Corner(c + int2(2, 2));
+
+        float w0, w1, w2, w3, w4;
+        float3 inner = Box(e, f, l, m, w0);
+        float3 topLeft = Box(a, b, g, h, w1);
+        float3 topRight = Box(b, d, h, k, w2);
+        float3 bottomLeft = Box(g, h, n, o, w3);
+        float3 bottomRight = Box(h, k, o, q, w4);
+        w0 *= 0.5f;
+        w1 *= 0.125f;
+        w2 *= 0.125f;
+        w3 *= 0.125f;
+        w4 *= 0.125f;
+        float3 color = inner * w0 + topLeft * w1 + topRight * w2 + bottomLeft * w3 + bottomRight * w4;
+        Destination[id] = float4(color / (w0 + w1 + w2 + w3 + w4), 1.0f);
+    }
+)";
+
+// 3x3 tent upsample of the lower level, read through a groupshared tile of the lower texels the
+// group covers. Blends with this level's downsample, or with COMPOSITE adds onto the source
+const char* UPSAMPLE_SHADER = R"(
+    cbuffer BloomConstants : register(b0)
+    {
+        uint2 SourceSize;
+        uint2 DestinationSize;
+        float Threshold;
+        float Knee;
+        float Scatter;
+        float Intensity;
+    };
+
+    Texture2D<float4> Lower : register(t0);
+    Texture2D<float4> Current : register(t1);
+    RWTexture2D<float4> Destination : register(u0);
+
+    #define TILE 8
+    #define FOOTPRINT 10
+    groupshared float3 Tile[FOOTPRINT * FOOTPRINT];
+
+    float3 Fetch(int2 p)
+    {
+        return Tile[p.y * FOOTPRINT + p.x];
+    }
+
+    // Bilinear, p in tile texels with texel centers on integers
+    float3 SampleTile(float2 p)
+    {
+        int2 i = int2(floor(p));
+        float2 f = p - float2(i);
+        return lerp(lerp(Fetch(i), Fetch(i + int2(1, 0)), f.x),
+                    lerp(Fetch(i + int2(0, 1)), Fetch(i + int2(1, 1)), f.x), f.y);
+    }
+
+    [numthreads(TILE, TILE, 1)]
+    void main(uint3 groupId : SV_GroupID, uint3 local : SV_GroupThreadID, uint index : SV_GroupIndex)
+    {
+        float2 scale = float2(SourceSize) / float2(DestinationSize);
+        int2 origin = int2(floor((float2(groupId.xy * TILE) + 0.5f) * scale - 0.5f)) - 2;
+        for (uint i = index; i < FOOTPRINT * FOOTPRINT; i += TILE * TILE) {
+            int2 texel = clamp(origin + int2(i % FOOTPRINT, i / FOOTPRINT), int2(0, 0), int2(SourceSize) - 1);
+            Tile[i] = Lower.Load(int3(texel, 0)).rgb;
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        uint2 id = groupId.xy * TILE + local.xy;
+        if (any(id >= DestinationSize)) return;
+
+        float2 position = (float2(id) + 0.5f) * scale - 0.5f - float2(origin);
+        float3 bloom = float3(0.0f, 0.0f, 0.0f);
+        [unroll] for (int y = -1; y <= 1; ++y) {
+            [unroll] for (int x = -1; x <= 1; ++x) {
+                bloom += SampleTile(position + float2(x, y)) * ((2 - abs(x)) * (2 - abs(y)) / 16.0f);
+            }
+        }
+
+        float4 current = Current.Load(int3(id, 0));
+    #ifdef COMPOSITE
+        Destination[id] = float4(current.rgb + bloom * Intensity, current.a);
+    #else
+        Destination[id] = float4(lerp(current.rgb, bloom, Scatter), 1.0f);
+    #endif
+    }
+)";
+
+// Matches BloomConstants above
+struct GpuBloomConstants {
+    UINT sourceSize[2];
+    UINT destinationSize[2];
+    float threshold;
+    float knee;
+    float scatter;
+    float intensity;
+};
+
+constexpr UINT GROUP_SIZE = 8;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3D11ComputeShader* CompileComputeShader(ID3D11Device* device, const char* source, const char* name,
+                                          const std::vector<ShaderCache::Define>& defines = {}) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", "cs_5_0", 0, &blob, &errors, defines);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+
+    ID3D11ComputeShader* shader = nullptr;
+    hr = device->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &shader);
+    blob->Release();
+    return SUCCEEDED(hr) ? shader : nullptr;
+}
+
+} // namespace
+
+BloomRenderer::BloomRenderer()
+    : device_(nullptr)
+    , context_(nullptr)
+    , width_(0)
+    , height_(0)
+    , prefilterShader_(nullptr)
+    , downsampleShader_(nullptr)
+    , upsampleShader_(nullptr)
+    , compositeShader_(nullptr)
+    , constants_(nullptr)
+    , downChain_(nullptr)
+    , upChain_(nullptr)
+{
+}
+
+BloomRenderer::~BloomRenderer() {
+    Shutdown();
+}
+
+bool BloomRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height,
+                               const Settings& settings) {
+    Shutdown();
+    if (!device || !context || width < 2 || height < 2) return false;
+
+    device_ = device;
+    context_ = context;
+    width_ = width;
+    height_ = height;
+    settings_ = settings;
+    // Stop before the smaller side would drop below one texel
+    settings_.mipCount = std::clamp(settings_.mipCount, 1u, MAX_MIPS);
+    while (settings_.mipCount > 1 && (std::min(width, height) >> settings_.mipCount) == 0) {
+        settings_.mipCount--;
+    }
+
+    if (!CreateShaders() || !CreateChains()) {
+        Logger::Error("Failed to create bloom resources");
+        Shutdown();
+        return false;
+    }
+    Logger::Info("Compute bloom initialized: " + std::to_string(settings_.mipCount) + " levels from " +
+                 std::to_string(mipWidths_[0]) + "x" + std::to_string(mipHeights_[0]));
+    return true;
+}
+
+void BloomRenderer::Shutdown() {
+    for (auto* view : downViews_) SafeRelease(view);
+    for (auto* target : downTargets_) SafeRelease(target);
+    for (auto* view : upViews_) SafeRelease(view);
+    for (auto* target : upTargets_) SafeRelease(target);
+    downViews_.clear();
+    downTargets_.clear();
+    upViews_.clear();
+    upTargets_.clear();
+    mipWidths_.clear();
+    mipHeights_.clear();
+    SafeRelease(downChain_);
+    SafeRelease(upChain_);
+    SafeRelease(prefilterShader_);
+    SafeRelease(downsampleShader_);
+    SafeRelease(upsampleShader_);
+    SafeRelease(compositeShader_);
+    SafeRelease(constants_);
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+bool BloomRenderer::CreateShaders() {
+    prefilterShader_ = CompileComputeShader(device_, DOWNSAMPLE_SHADER, "BloomPrefilter", {{"PREFILTER", "1"}});
+    downsampleShader_ = CompileComputeShader(device_, DOWNSAMPLE_SHADER, "BloomDownsample");
+    upsampleShader_ = CompileComputeShader(device_, UPSAMPLE_SHADER, "BloomUpsample");
+    compositeShader_ = CompileComputeShader(device_, UPSAMPLE_SHADER, "BloomComposite", {{"COMPOSITE", "1"}});
+    if (!prefilterShader_ || !downsampleShader_ || !upsampleShader_ || !compositeShader_) return false;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = sizeof(GpuBloomConstants);
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    return SUCCEEDED(device_->CreateBuffer(&desc, nullptr, &constants_));
+}
+
+bool BloomRenderer::CreateChains() {
+    UINT width = width_;
+    UINT height = height_;
+    for (UINT mip = 0; mip < settings_.mipCount; ++mip) {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        mipWidths_.push_back(width);
+        mipHeights_.push_back(height);
+    }
+
+    // Packed float keeps the chain at 4 bytes per texel, which matters on bandwidth-bound GPUs
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = mipWidths_[0];
+    desc.Height = mipHeights_[0];
+    desc.MipLevels = settings_.mipCount;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R11G11B10_FLOAT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &downChain_))) return false;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &upChain_))) return false;
+
+    ID3D11Texture2D* chains[2] = { downChain_, upChain_ };
+    std::vector<ID3D11ShaderResourceView*>* views[2] = { &downViews_, &upViews_ };
+    std::vector<ID3D11UnorderedAccessView*>* targets[2] = { &downTargets_, &upTargets_ };
+    for (UINT chain = 0; chain < 2; ++chain) {
+        for (UINT mip = 0; mip < settings_.mipCount; ++mip) {
+            D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+            viewDesc.Format = desc.Format;
+            viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+            viewDesc.Texture2D.MostDetailedMip = mip;
+            viewDesc.Texture2D.MipLevels = 1;
+            ID3D11ShaderResourceView* view = nullptr;
+            if (FAILED(device_->CreateShaderResourceView(chains[chain], &viewDesc, &view))) return false;
+            views[chain]->push_back(view);
+
+            D3D11_UNORDERED_ACCESS_VIEW_DESC targetDesc = {};
+            targetDesc.Format = desc.Format;
+            targetDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+            targetDesc.Texture2D.MipSlice = mip;
+            ID3D11UnorderedAccessView* target = nullptr;
+            if (FAILED(device_->CreateUnorderedAccessView(chains[chain], &targetDesc, &target))) return false;
+            targets[chain]->push_back(target);
+        }
+    }
+    return true;
+}
+
+void BloomRenderer::SetParameters(float threshold, float intensity) {
+    settings_.threshold = std::max(threshold, 0.0f);
+    settings_.intensity = std::max(intensity, 0.0f);
+}
+
+ID3D11ShaderResourceView* BloomRenderer::GetBloomView() const {
+    if (downViews_.empty()) return nullptr;
+    return settings_.mipCount > 1 ? upViews_[0] : downViews_[0];
+}
+
+void BloomRenderer::Dispatch(ID3D11ComputeShader* shader, ID3D11ShaderResourceView* source,
+                             ID3D11ShaderResourceView* current, ID3D11UnorderedAccessView* target,
+                             UINT sourceWidth, UINT sourceHeight, UINT width, UINT height) {
+    GpuBloomConstants constants = {};
+    constants.sourceSize[0] = sourceWidth;
+    constants.sourceSize[1] = sourceHeight;
+    constants.destinationSize[0] = width;
+    constants.destinationSize[1] = height;
+    constants.threshold = settings_.threshold;
+    constants.knee = std::max(settings_.threshold * settings_.knee, 1e-4f);
+    constants.scatter = std::clamp(settings_.scatter, 0.0f, 1.0f);
+    constants.intensity = settings_.intensity;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+
+    ID3D11ShaderResourceView* views[2] = { source, current };
+    context_->CSSetShader(shader, nullptr, 0);
+    context_->CSSetShaderResources(0, 2, views);
+    context_->CSSetUnorderedAccessViews(0, 1, &target, nullptr);
+    context_->Dispatch((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+    // Unbind before the level becomes the next source
+    ID3D11ShaderResourceView* nullViews[2] = {};
+    ID3D11UnorderedAccessView* nullTarget = nullptr;
+    context_->CSSetShaderResources(0, 2, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+}
+
+void BloomRenderer::Render(ID3D11ShaderResourceView* source, ID3D11UnorderedAccessView* output) {
+    if (!device_ || !source || !output) return;
+    NEXUS_PROFILE_SCOPE("BloomRenderer::Render");
+
+    const UINT mips = settings_.mipCount;
+    context_->CSSetConstantBuffers(0, 1, &constants_);
+
+    Dispatch(prefilterShader_, source, nullptr, downTargets_[0], width_, height_, mipWidths_[0], mipHeights_[0]);
+    for (UINT mip = 1; mip < mips; ++mip) {
+        Dispatch(downsampleShader_, downViews_[mip - 1], nullptr, downTargets_[mip],
+                 mipWidths_[mip - 1], mipHeights_[mip - 1], mipWidths_[mip], mipHeights_[mip]);
+    }
+    // The smallest level is its own upsample
+    for (UINT mip = mips - 1; mip-- > 0;) {
+        ID3D11ShaderResourceView* lower = mip + 1 == mips - 1 ? downViews_[mip + 1] : upViews_[mip + 1];
+        Dispatch(upsampleShader_, lower, downViews_[mip], upTargets_[mip],
+                 mipWidths_[mip + 1], mipHeights_[mip + 1], mipWidths_[mip], mipHeights_[mip]);
+    }
+    Dispatch(compositeShader_, GetBloomView(), source, output, mipWidths_[0], mipHeights_[0], width_, height_);
+
+    context_->CSSetShader(nullptr, nullptr, 0);
+}
+
+} // namespace Nexus
@@ -9,6 +9,7 @@ Camera::Camera()
     , up_(0.0f, 1.0f, 0.0f)
     , pitch_(0.0f)
     , yaw_(0.0f)
+    , jitter_(0.0f, 0.0f)
 {
     viewMatrix_ = DirectX::XMMatrixIdentity();
     projectionMatrix_ = DirectX::XMMatrixIdentity();
@@ -26,6 +27,11 @@ void Camera::SetOrthographic(float width, float height, float nearPlane, float f
     projectionMatrix_ = DirectX::XMMatrixOrthographicLH(width, height, nearPlane, farPlane);
 }
 
+DirectX::XMMATRIX Camera::GetJitteredProjectionMatrix() const {
+    // Adds jitter times w to clip x and y, which moves perspective and orthographic alike
+    return DirectX::XMMatrixMultiply(projectionMatrix_, DirectX::XMMatrixTranslation(jitter_.x, jitter_.y, 0.0f));
+}
+
 void Camera::UpdateViewMatrix() {
     DirectX::XMVECTOR pos = DirectX::XMLoadFloat3(&position_);
     DirectX::XMVECTOR target = DirectX::XMLoadFloat3(&target_);
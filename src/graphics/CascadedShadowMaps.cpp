@@ -0,0 +1,601 @@
+#include "CascadedShadowMaps.h"
+#include "Logger.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+
+// Light directions closer than this are treated as unchanged and keep the caches
+constexpr float LIGHT_DIRECTION_EPSILON = 1e-5f;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+// Depth-only caster transform. Compressed meshes store UNORM16 positions across their bounds
+const char* CASTER_VS = R"(
+cbuffer CasterConstants : register(b0)
+{
+    float4x4 WorldViewProjection;
+    float4 PositionOffset;
+    float4 PositionScale;
+};
+
+float4 main(float4 position : POSITION) : SV_POSITION
+{
+#ifdef COMPRESSED_VERTEX
+    float3 p = PositionOffset.xyz + position.xyz * PositionScale.xyz;
+#else
+    float3 p = position.xyz;
+#endif
+    return mul(float4(p, 1.0f), WorldViewProjection);
+}
+)";
+
+const char* FULLSCREEN_VS = R"(
+float4 main(uint id : SV_VertexID) : SV_POSITION
+{
+    float2 uv = float2((id << 1) & 2, id & 2);
+    return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+}
+)";
+
+// Copies a cached slice shifted by whole texels; texels scrolled in from outside are cleared
+const char* SCROLL_PS = R"(
+Texture2DArray<float> Source : register(t0);
+
+cbuffer ScrollConstants : register(b0)
+{
+    int2 Offset;
+    uint Slice;
+    uint Size;
+};
+
+float main(float4 position : SV_POSITION) : SV_DEPTH
+{
+    int2 source = int2(position.xy) + Offset;
+    if (any(source < 0) || any(source >= int(Size))) return 1.0f;
+    return Source.Load(int4(source, Slice, 0));
+}
+)";
+
+// Matches ScrollConstants above
+struct GpuScrollConstants {
+    int offset[2];
+    UINT slice;
+    UINT size;
+};
+
+ID3DBlob* CompileShader(const char* source, const char* name, const char* target,
+                        const std::vector<ShaderCache::Define>& defines = {}) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors, defines);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+HRESULT CreateDepthArray(ID3D11Device* device, UINT resolution, UINT slices, ID3D11Texture2D** texture,
+                         ID3D11ShaderResourceView** view, ID3D11DepthStencilView** targets) {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = resolution;
+    desc.Height = resolution;
+    desc.MipLevels = 1;
+    desc.ArraySize = slices;
+    desc.Format = DXGI_FORMAT_R32_TYPELESS;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+    HRESULT hr = device->CreateTexture2D(&desc, nullptr, texture);
+    if (FAILED(hr)) return hr;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    viewDesc.Texture2DArray.MipLevels = 1;
+    viewDesc.Texture2DArray.ArraySize = slices;
+    hr = device->CreateShaderResourceView(*texture, &viewDesc, view);
+    if (FAILED(hr)) return hr;
+
+    for (UINT i = 0; i < slices; ++i) {
+        D3D11_DEPTH_STENCIL_VIEW_DESC targetDesc = {};
+        targetDesc.Format = DXGI_FORMAT_D32_FLOAT;
+        targetDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+        targetDesc.Texture2DArray.FirstArraySlice = i;
+        targetDesc.Texture2DArray.ArraySize = 1;
+        hr = device->CreateDepthStencilView(*texture, &targetDesc, &targets[i]);
+        if (FAILED(hr)) return hr;
+    }
+    return S_OK;
+}
+
+// Minimal sphere around the view frustum between depths nearZ and farZ with its center on the
+// view axis; tanSquared is the squared tangent of the half-diagonal field of view. Depends only
+// on the projection, so the cascade size stays fixed while the camera moves and turns
+void FitSphere(float nearZ, float farZ, float tanSquared, float& centerZ, float& radius) {
+    centerZ = std::min(0.5f * (nearZ + farZ) * (1.0f + tanSquared), farZ);
+    float toNear = (centerZ - nearZ) * (centerZ - nearZ) + nearZ * nearZ * tanSquared;
+    float toFar = (farZ - centerZ) * (farZ - centerZ) + farZ * farZ * tanSquared;
+    radius = std::sqrt(std::max(toNear, toFar));
+}
+
+} // namespace
+
+CascadedShadowMaps::CascadedShadowMaps()
+    : device_(nullptr)
+    , context_(nullptr)
+    , stateCache_(nullptr)
+    , shadowTexture_(nullptr)
+    , shadowView_(nullptr)
+    , shadowTargets_{}
+    , cacheTextures_{}
+    , cacheViews_{}
+    , cacheTargets_{}
+    , casterShaders_{}
+    , casterLayouts_{}
+    , fullscreenShader_(nullptr)
+    , scrollShader_(nullptr)
+    , casterConstants_(nullptr)
+    , scrollConstants_(nullptr)
+    , casterState_(nullptr)
+    , scissorState_(nullptr)
+    , depthState_(nullptr)
+    , overwriteState_(nullptr)
+    , lightDirection_(0.0f, 0.0f, 0.0f)
+    , frame_(0)
+    , forceUpdate_(true)
+    , nextCasterId_(1)
+{
+    XMStoreFloat4x4(&lightRotation_, XMMatrixIdentity());
+}
+
+CascadedShadowMaps::~CascadedShadowMaps() {
+    Shutdown();
+}
+
+bool CascadedShadowMaps::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                                    const Settings& settings) {
+    Shutdown();
+    if (!device || !context || !stateCache) return false;
+
+    device_ = device;
+    context_ = context;
+    stateCache_ = stateCache;
+    settings_ = settings;
+    settings_.cascadeCount = std::clamp(settings_.cascadeCount, 1u, MAX_CASCADES);
+    // Even, so the snapped center falls on a texel corner
+    settings_.resolution = std::max(64u, settings_.resolution & ~1u);
+    for (UINT& interval : settings_.updateIntervals) interval = std::max(interval, 1u);
+
+    if (!CreateTargets() || !CreateShaders()) {
+        Logger::Error("Failed to create cascaded shadow map resources");
+        Shutdown();
+        return false;
+    }
+
+    for (Cascade& cascade : cascades_) cascade = Cascade();
+    frame_ = 0;
+    forceUpdate_ = true;
+    Logger::Info("Cascaded shadow maps initialized: " + std::to_string(settings_.cascadeCount) + " x " +
+                 std::to_string(settings_.resolution) + "^2");
+    return true;
+}
+
+void CascadedShadowMaps::Shutdown() {
+    for (UINT i = 0; i < MAX_CASCADES; ++i) {
+        SafeRelease(shadowTargets_[i]);
+        SafeRelease(cacheTargets_[0][i]);
+        SafeRelease(cacheTargets_[1][i]);
+    }
+    SafeRelease(shadowView_);
+    SafeRelease(shadowTexture_);
+    for (UINT i = 0; i < 2; ++i) {
+        SafeRelease(cacheViews_[i]);
+        SafeRelease(cacheTextures_[i]);
+        SafeRelease(casterShaders_[i]);
+        SafeRelease(casterLayouts_[i]);
+    }
+    SafeRelease(fullscreenShader_);
+    SafeRelease(scrollShader_);
+    SafeRelease(casterConstants_);
+    SafeRelease(scrollConstants_);
+    SafeRelease(casterState_);
+    SafeRelease(scissorState_);
+    SafeRelease(depthState_);
+    SafeRelease(overwriteState_);
+    device_ = nullptr;
+    context_ = nullptr;
+    stateCache_ = nullptr;
+}
+
+bool CascadedShadowMaps::CreateTargets() {
+    UINT slices = settings_.cascadeCount;
+    if (FAILED(CreateDepthArray(device_, settings_.resolution, slices, &shadowTexture_, &shadowView_, shadowTargets_))) {
+        return false;
+    }
+    for (UINT i = 0; i < 2; ++i) {
+        if (FAILED(CreateDepthArray(device_, settings_.resolution, slices, &cacheTextures_[i], &cacheViews_[i],
+                                    cacheTargets_[i]))) {
+            return false;
+        }
+    }
+
+    // Depth clamp instead of clipping pancakes casters in front of the window onto its near plane
+    D3D11_RASTERIZER_DESC rasterizer = {};
+    rasterizer.FillMode = D3D11_FILL_SOLID;
+    rasterizer.CullMode = D3D11_CULL_BACK;
+    rasterizer.DepthBias = settings_.depthBias;
+    rasterizer.SlopeScaledDepthBias = settings_.slopeScaledDepthBias;
+    rasterizer.DepthClipEnable = FALSE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizer, &casterState_))) return false;
+    rasterizer.ScissorEnable = TRUE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizer, &scissorState_))) return false;
+
+    D3D11_DEPTH_STENCIL_DESC depth = {};
+    depth.DepthEnable = TRUE;
+    depth.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+    depth.DepthFunc = D3D11_COMPARISON_LESS;
+    if (FAILED(device_->CreateDepthStencilState(&depth, &depthState_))) return false;
+    depth.DepthFunc = D3D11_COMPARISON_ALWAYS;
+    if (FAILED(device_->CreateDepthStencilState(&depth, &overwriteState_))) return false;
+
+    D3D11_BUFFER_DESC constants = {};
+    constants.Usage = D3D11_USAGE_DYNAMIC;
+    constants.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constants.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    constants.ByteWidth = sizeof(GpuCasterConstants);
+    if (FAILED(device_->CreateBuffer(&constants, nullptr, &casterConstants_))) return false;
+    constants.ByteWidth = sizeof(GpuScrollConstants);
+    return SUCCEEDED(device_->CreateBuffer(&constants, nullptr, &scrollConstants_));
+}
+
+bool CascadedShadowMaps::CreateShaders() {
+    std::vector<ShaderCache::Define> compressed = {{COMPRESSED_VERTEX_KEYWORD, "1"}};
+    for (UINT format = 0; format < 2; ++format) {
+        ID3DBlob* blob = CompileShader(CASTER_VS, "ShadowCaster_VS", "vs_5_0",
+                                       format ? compressed : std::vector<ShaderCache::Define>());
+        if (!blob) return false;
+
+        UINT elementCount = 0;
+        const D3D11_INPUT_ELEMENT_DESC* elements = Mesh::GetInputLayout(static_cast<VertexFormat>(format), elementCount);
+        HRESULT hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr,
+                                                 &casterShaders_[format]);
+        if (SUCCEEDED(hr)) {
+            hr = device_->CreateInputLayout(elements, elementCount, blob->GetBufferPointer(), blob->GetBufferSize(),
+                                            &casterLayouts_[format]);
+        }
+        blob->Release();
+        if (FAILED(hr)) return false;
+    }
+
+    ID3DBlob* blob = CompileShader(FULLSCREEN_VS, "ShadowScroll_VS", "vs_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &fullscreenShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(SCROLL_PS, "ShadowScroll_PS", "ps_5_0");
+    if (!blob) return false;
+    hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &scrollShader_);
+    blob->Release();
+    return SUCCEEDED(hr);
+}
+
+uint32_t CascadedShadowMaps::AddStaticCaster(const Caster& caster) {
+    StaticCaster entry;
+    entry.caster = caster;
+    entry.id = nextCasterId_++;
+    staticCasters_.push_back(entry);
+    InvalidateOverlapping(caster.bounds);
+    return entry.id;
+}
+
+void CascadedShadowMaps::RemoveStaticCaster(uint32_t id) {
+    for (size_t i = 0; i < staticCasters_.size(); ++i) {
+        if (staticCasters_[i].id == id) {
+            InvalidateOverlapping(staticCasters_[i].caster.bounds);
+            staticCasters_[i] = staticCasters_.back();
+            staticCasters_.pop_back();
+            return;
+        }
+    }
+}
+
+void CascadedShadowMaps::ClearStaticCasters() {
+    staticCasters_.clear();
+    InvalidateStatic();
+}
+
+void CascadedShadowMaps::InvalidateStatic() {
+    for (Cascade& cascade : cascades_) cascade.staticValid = false;
+}
+
+void CascadedShadowMaps::InvalidateStatic(const AABB& bounds) {
+    InvalidateOverlapping(bounds);
+}
+
+void CascadedShadowMaps::InvalidateOverlapping(const AABB& bounds) {
+    for (UINT i = 0; i < settings_.cascadeCount; ++i) {
+        Cascade& cascade = cascades_[i];
+        if (cascade.staticValid &&
+            Frustum::FromViewProjection(XMLoadFloat4x4(&cascade.viewProjection)).Intersects(bounds)) {
+            cascade.staticValid = false;
+        }
+    }
+}
+
+bool CascadedShadowMaps::ComputeScrollRegion(int fromX, int fromY, int toX, int toY, UINT resolution,
+                                             ScrollRegion& region) {
+    // Columns follow the light's right axis, rows run against its up axis
+    const int size = static_cast<int>(resolution);
+    region = ScrollRegion();
+    region.offsetX = toX - fromX;
+    region.offsetY = fromY - toY;
+    if (std::abs(region.offsetX) >= size || std::abs(region.offsetY) >= size) return false;
+
+    // Exposed columns span the full height; exposed rows then only need the remaining columns
+    LONG columnsLeft = 0, columnsRight = size;
+    if (region.offsetX != 0) {
+        D3D11_RECT& rect = region.rects[region.rectCount++];
+        rect.top = 0;
+        rect.bottom = size;
+        if (region.offsetX > 0) {
+            rect.left = size - region.offsetX;
+            rect.right = size;
+            columnsRight = rect.left;
+        } else {
+            rect.left = 0;
+            rect.right = -region.offsetX;
+            columnsLeft = rect.right;
+        }
+    }
+    if (region.offsetY != 0) {
+        D3D11_RECT& rect = region.rects[region.rectCount++];
+        rect.left = columnsLeft;
+        rect.right = columnsRight;
+        if (region.offsetY > 0) {
+            rect.top = size - region.offsetY;
+            rect.bottom = size;
+        } else {
+            rect.top = 0;
+            rect.bottom = -region.offsetY;
+        }
+    }
+    return true;
+}
+
+void CascadedShadowMaps::SetLightBasis(const XMFLOAT3& lightDirection) {
+    XMVECTOR forward = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+    XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+    if (std::fabs(XMVectorGetY(forward)) > 0.99f) {
+        up = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+    }
+    XMStoreFloat3(&lightDirection_, forward);
+    XMStoreFloat4x4(&lightRotation_, XMMatrixLookToLH(XMVectorZero(), forward, up));
+}
+
+XMMATRIX CascadedShadowMaps::BuildViewProjection(const Cascade& cascade, const D3D11_RECT& rect) const {
+    // Texel column u of the slice covers light-space x in [originX - half + u, + 1) texels
+    const float texel = 2.0f * cascade.radius / settings_.resolution;
+    const int half = static_cast<int>(settings_.resolution / 2);
+    float left = (cascade.originX - half + rect.left) * texel;
+    float right = (cascade.originX - half + rect.right) * texel;
+    float top = (cascade.originY + half - rect.top) * texel;
+    float bottom = (cascade.originY + half - rect.bottom) * texel;
+    float nearZ = cascade.depthCenter - 0.5f * cascade.depthRange;
+    float farZ = cascade.depthCenter + 0.5f * cascade.depthRange;
+    return XMMatrixMultiply(XMLoadFloat4x4(&lightRotation_),
+                            XMMatrixOrthographicOffCenterLH(left, right, bottom, top, nearZ, farZ));
+}
+
+void CascadedShadowMaps::Update(FXMMATRIX view, CXMMATRIX projection, const XMFLOAT3& lightDirection) {
+    NEXUS_PROFILE_SCOPE("CascadedShadowMaps::Update");
+    if (!device_) return;
+    stats_ = Stats();
+
+    XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+    if (XMVectorGetX(XMVector3Dot(direction, XMLoadFloat3(&lightDirection_))) < 1.0f - LIGHT_DIRECTION_EPSILON) {
+        SetLightBasis(lightDirection);
+        InvalidateStatic();
+        forceUpdate_ = true;
+    }
+
+    // Near and far from the projection's depth terms, either depth direction
+    XMFLOAT4X4 p;
+    XMStoreFloat4x4(&p, projection);
+    float nearPlane = -p._43 / p._33;
+    float farPlane = p._43 / (1.0f - p._33);
+    if (nearPlane > farPlane) std::swap(nearPlane, farPlane);
+    farPlane = std::min(farPlane, std::max(settings_.maxDistance, nearPlane * 2.0f));
+    const float tanSquared = 1.0f / (p._11 * p._11) + 1.0f / (p._22 * p._22);
+
+    XMMATRIX inverseView = XMMatrixInverse(nullptr, view);
+    XMVECTOR eye = inverseView.r[3];
+    XMVECTOR forward = XMVector3Normalize(inverseView.r[2]);
+    XMMATRIX rotation = XMLoadFloat4x4(&lightRotation_);
+
+    const UINT count = settings_.cascadeCount;
+    const float lambda = std::clamp(settings_.splitLambda, 0.0f, 1.0f);
+    bool bound = false;
+
+    for (UINT i = 0; i < count; ++i) {
+        Cascade& cascade = cascades_[i];
+        bool due = forceUpdate_ || (frame_ + i) % settings_.updateIntervals[i] == 0;
+        if (!due) continue;
+
+        // Practical split scheme, blending logarithmic and uniform distribution
+        float fraction = static_cast<float>(i + 1) / count;
+        float splitFar = lambda * nearPlane * std::pow(farPlane / nearPlane, fraction) +
+                         (1.0f - lambda) * (nearPlane + (farPlane - nearPlane) * fraction);
+        float splitNear = i == 0 ? nearPlane : cascades_[i - 1].splitFar;
+
+        float centerZ, radius;
+        FitSphere(splitNear, splitFar, tanSquared, centerZ, radius);
+        if (radius != cascade.radius) cascade.staticValid = false;
+        cascade.splitNear = splitNear;
+        cascade.splitFar = splitFar;
+        cascade.radius = radius;
+
+        // Snap the center to whole texels in light space
+        XMFLOAT3 center;
+        XMStoreFloat3(&center, XMVector3TransformCoord(XMVectorMultiplyAdd(forward, XMVectorReplicate(centerZ), eye), rotation));
+        const float texel = 2.0f * radius / settings_.resolution;
+        int originX = static_cast<int>(std::floor(center.x / texel + 0.5f));
+        int originY = static_cast<int>(std::floor(center.y / texel + 0.5f));
+
+        // Casters up to casterDistance toward the light shadow the cascade. The depth window keeps
+        // one radius of slack on either side so small moves along the light reuse the cache
+        float needNear = center.z - radius - settings_.casterDistance;
+        float needFar = center.z + radius;
+        if (needNear < cascade.depthCenter - 0.5f * cascade.depthRange ||
+            needFar > cascade.depthCenter + 0.5f * cascade.depthRange) {
+            cascade.depthCenter = 0.5f * (needNear + needFar);
+            cascade.depthRange = needFar - needNear + 2.0f * radius;
+            cascade.staticValid = false;
+        }
+
+        if (!bound) {
+            D3D11_VIEWPORT viewport = {};
+            viewport.Width = static_cast<float>(settings_.resolution);
+            viewport.Height = static_cast<float>(settings_.resolution);
+            viewport.MaxDepth = 1.0f;
+            stateCache_->RSSetViewports(1, &viewport);
+            stateCache_->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+            bound = true;
+        }
+
+        UpdateStatic(i, originX, originY);
+
+        // Final slice: the static cache plus this frame's dynamic casters
+        UINT subresource = D3D11CalcSubresource(0, i, 1);
+        context_->CopySubresourceRegion(shadowTexture_, subresource, 0, 0, 0, cacheTextures_[cascade.cache],
+                                        subresource, nullptr);
+        if (!dynamicCasters_.empty()) {
+            stateCache_->OMSetRenderTargets(0, nullptr, shadowTargets_[i]);
+            stateCache_->RSSetState(casterState_);
+            stateCache_->OMSetDepthStencilState(depthState_, 0);
+            XMMATRIX viewProjection = XMLoadFloat4x4(&cascade.viewProjection);
+            Frustum frustum = Frustum::FromViewProjection(viewProjection);
+            for (const Caster& caster : dynamicCasters_) {
+                if (DrawCaster(caster, viewProjection, frustum)) stats_.dynamicCastersDrawn++;
+            }
+        }
+        stats_.cascadesUpdated++;
+    }
+
+    forceUpdate_ = false;
+    frame_++;
+}
+
+void CascadedShadowMaps::UpdateStatic(UINT index, int originX, int originY) {
+    Cascade& cascade = cascades_[index];
+    const D3D11_RECT full = { 0, 0, static_cast<LONG>(settings_.resolution), static_cast<LONG>(settings_.resolution) };
+
+    ScrollRegion region;
+    bool scroll = cascade.staticValid &&
+                  ComputeScrollRegion(cascade.originX, cascade.originY, originX, originY, settings_.resolution, region);
+    cascade.originX = originX;
+    cascade.originY = originY;
+    XMStoreFloat4x4(&cascade.viewProjection, BuildViewProjection(cascade, full));
+
+    if (!scroll) {
+        context_->ClearDepthStencilView(cacheTargets_[cascade.cache][index], D3D11_CLEAR_DEPTH, 1.0f, 0);
+        stateCache_->OMSetRenderTargets(0, nullptr, cacheTargets_[cascade.cache][index]);
+        stateCache_->RSSetState(casterState_);
+        DrawStatic(index, full);
+        cascade.staticValid = true;
+        stats_.staticRedraws++;
+        return;
+    }
+    if (region.rectCount == 0) return;
+
+    // Shift the cached depth into the other cache, then fill in the exposed strips
+    UINT target = cascade.cache ^ 1;
+    GpuScrollConstants constants = {};
+    constants.offset[0] = region.offsetX;
+    constants.offset[1] = region.offsetY;
+    constants.slice = index;
+    constants.size = settings_.resolution;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(scrollConstants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        cascade.staticValid = false;
+        return;
+    }
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(scrollConstants_, 0);
+
+    stateCache_->OMSetRenderTargets(0, nullptr, cacheTargets_[target][index]);
+    stateCache_->RSSetState(casterState_);
+    stateCache_->OMSetDepthStencilState(overwriteState_, 0);
+    stateCache_->IASetInputLayout(nullptr);
+    stateCache_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    stateCache_->VSSetShader(fullscreenShader_);
+    stateCache_->PSSetShader(scrollShader_);
+    stateCache_->PSSetConstantBuffers(0, 1, &scrollConstants_);
+    stateCache_->PSSetShaderResources(0, 1, &cacheViews_[cascade.cache]);
+    context_->Draw(3, 0);
+    ID3D11ShaderResourceView* nullView = nullptr;
+    stateCache_->PSSetShaderResources(0, 1, &nullView);
+    cascade.cache = target;
+
+    stateCache_->RSSetState(scissorState_);
+    for (UINT r = 0; r < region.rectCount; ++r) {
+        context_->RSSetScissorRects(1, &region.rects[r]);
+        DrawStatic(index, region.rects[r]);
+    }
+    stats_.staticScrolls++;
+}
+
+void CascadedShadowMaps::DrawStatic(UINT index, const D3D11_RECT& rect) {
+    // Draw with the full cascade transform but cull against only the texels being filled
+    const Cascade& cascade = cascades_[index];
+    XMMATRIX viewProjection = XMLoadFloat4x4(&cascade.viewProjection);
+    Frustum frustum = Frustum::FromViewProjection(BuildViewProjection(cascade, rect));
+    stateCache_->OMSetDepthStencilState(depthState_, 0);
+    for (const StaticCaster& entry : staticCasters_) {
+        if (DrawCaster(entry.caster, viewProjection, frustum)) stats_.staticCastersDrawn++;
+    }
+}
+
+bool CascadedShadowMaps::DrawCaster(const Caster& caster, CXMMATRIX viewProjection, const Frustum& frustum) {
+    if (!caster.mesh || !frustum.Intersects(caster.bounds)) return false;
+
+    GpuCasterConstants constants;
+    XMStoreFloat4x4(&constants.worldViewProjection,
+                    XMMatrixTranspose(XMMatrixMultiply(XMLoadFloat4x4(&caster.world), viewProjection)));
+    XMFLOAT3 offset = caster.mesh->GetPositionOffset();
+    XMFLOAT3 scale = caster.mesh->GetPositionScale();
+    constants.positionOffset = XMFLOAT4(offset.x, offset.y, offset.z, 0.0f);
+    constants.positionScale = XMFLOAT4(scale.x, scale.y, scale.z, 0.0f);
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(casterConstants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return false;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(casterConstants_, 0);
+
+    UINT format = caster.mesh->GetVertexFormat() == VertexFormat::Compressed ? 1 : 0;
+    stateCache_->IASetInputLayout(casterLayouts_[format]);
+    stateCache_->VSSetShader(casterShaders_[format]);
+    stateCache_->PSSetShader(nullptr);
+    stateCache_->VSSetConstantBuffers(0, 1, &casterConstants_);
+    caster.mesh->Render(context_);
+    return true;
+}
+
+} // namespace Nexus
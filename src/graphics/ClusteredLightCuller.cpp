@@ -0,0 +1,428 @@
+#include "ClusteredLightCuller.h"
+#include "JobSystem.h"
+#include "Light.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// SSE2 is part of the x64 baseline, so these need no runtime dispatch
+#include <emmintrin.h>
+
+namespace Nexus {
+
+namespace {
+
+constexpr UINT DEFAULT_LIGHTS_PER_CLUSTER = 128;
+constexpr UINT MAX_LIGHTS_PER_CLUSTER = 1024;
+constexpr UINT INITIAL_INDEX_CAPACITY = 32768;
+
+// Soft cone edge: the falloff starts at this fraction of the cone angle
+constexpr float SPOT_INNER_FRACTION = 0.8f;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+void WriteBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const void* data, size_t size) {
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (SUCCEEDED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        if (size > 0) std::memcpy(mapped.pData, data, size);
+        context->Unmap(buffer, 0);
+    }
+}
+
+HRESULT CreateDynamicBuffer(ID3D11Device* device, UINT byteWidth, UINT structureStride, DXGI_FORMAT format,
+                            UINT elements, ID3D11Buffer** buffer, ID3D11ShaderResourceView** view) {
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = byteWidth;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    desc.MiscFlags = structureStride ? D3D11_RESOURCE_MISC_BUFFER_STRUCTURED : 0;
+    desc.StructureByteStride = structureStride;
+    HRESULT hr = device->CreateBuffer(&desc, nullptr, buffer);
+    if (FAILED(hr)) return hr;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = format;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    viewDesc.Buffer.FirstElement = 0;
+    viewDesc.Buffer.NumElements = elements;
+    hr = device->CreateShaderResourceView(*buffer, &viewDesc, view);
+    if (FAILED(hr)) SafeRelease(*buffer);
+    return hr;
+}
+
+// View-space x / z (or y / z) over a box spanning [low, high] x [nearZ, farZ], mapped to NDC
+// by the projection's scale and offset terms
+void ProjectRange(float low, float high, float nearZ, float farZ, float scale, float offset,
+                  float& ndcMin, float& ndcMax) {
+    ndcMin = std::min(low / nearZ, low / farZ) * scale + offset;
+    ndcMax = std::max(high / nearZ, high / farZ) * scale + offset;
+}
+
+int ToTile(float unit, UINT tiles) {
+    return std::clamp(static_cast<int>(std::floor(unit * tiles)), 0, static_cast<int>(tiles) - 1);
+}
+
+} // namespace
+
+ClusteredLightCuller::ClusteredLightCuller()
+    : device_(nullptr)
+    , context_(nullptr)
+    , lightBuffer_(nullptr)
+    , lightView_(nullptr)
+    , rangeBuffer_(nullptr)
+    , rangeView_(nullptr)
+    , indexBuffer_(nullptr)
+    , indexView_(nullptr)
+    , indexCapacity_(0)
+    , constants_(nullptr)
+    , maxLightsPerCluster_(DEFAULT_LIGHTS_PER_CLUSTER)
+    , boundsProjection_()
+    , gridValid_(false)
+    , gpuConstants_()
+{
+}
+
+ClusteredLightCuller::~ClusteredLightCuller() {
+    Shutdown();
+}
+
+bool ClusteredLightCuller::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    if (!device || !context) return false;
+    device_ = device;
+    context_ = context;
+
+    static_assert(sizeof(GpuConstants) % 16 == 0, "Constant buffers are sized in 16-byte units");
+    D3D11_BUFFER_DESC constantsDesc = {};
+    constantsDesc.Usage = D3D11_USAGE_DYNAMIC;
+    constantsDesc.ByteWidth = sizeof(GpuConstants);
+    constantsDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constantsDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(CreateDynamicBuffer(device_, MAX_LIGHTS * sizeof(GpuLight), sizeof(GpuLight), DXGI_FORMAT_UNKNOWN,
+                                   MAX_LIGHTS, &lightBuffer_, &lightView_)) ||
+        FAILED(CreateDynamicBuffer(device_, CLUSTER_COUNT * 2 * sizeof(uint32_t), 0, DXGI_FORMAT_R32G32_UINT,
+                                   CLUSTER_COUNT, &rangeBuffer_, &rangeView_)) ||
+        FAILED(device_->CreateBuffer(&constantsDesc, nullptr, &constants_)) ||
+        !EnsureIndexCapacity(INITIAL_INDEX_CAPACITY)) {
+        Logger::Error("Failed to create clustered lighting buffers");
+        Shutdown();
+        return false;
+    }
+
+    lists_.ranges.assign(CLUSTER_COUNT * 2, 0);
+    Logger::Info("Clustered lighting initialized (" + std::to_string(GRID_X) + "x" + std::to_string(GRID_Y) +
+                 "x" + std::to_string(GRID_Z) + " clusters)");
+    return true;
+}
+
+void ClusteredLightCuller::Shutdown() {
+    SafeRelease(constants_);
+    SafeRelease(indexView_);
+    SafeRelease(indexBuffer_);
+    indexCapacity_ = 0;
+    SafeRelease(rangeView_);
+    SafeRelease(rangeBuffer_);
+    SafeRelease(lightView_);
+    SafeRelease(lightBuffer_);
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+void ClusteredLightCuller::SetMaxLightsPerCluster(UINT maxLights) {
+    maxLightsPerCluster_ = std::clamp<UINT>(maxLights, 1, MAX_LIGHTS_PER_CLUSTER);
+}
+
+bool ClusteredLightCuller::EnsureIndexCapacity(UINT indexCount) {
+    if (indexBuffer_ && indexCount <= indexCapacity_) return true;
+
+    // The buffer is rewritten every frame, so it can be replaced at any time
+    const UINT capacity = std::max(indexCount, indexCapacity_ * 2);
+    SafeRelease(indexView_);
+    SafeRelease(indexBuffer_);
+    indexCapacity_ = 0;
+    if (FAILED(CreateDynamicBuffer(device_, capacity * sizeof(uint16_t), 0, DXGI_FORMAT_R16_UINT, capacity,
+                                   &indexBuffer_, &indexView_))) {
+        Logger::Error("Failed to create clustered light index buffer");
+        return false;
+    }
+    indexCapacity_ = capacity;
+    return true;
+}
+
+void ClusteredLightCuller::BuildClusterBounds(DirectX::CXMMATRIX projection, float nearPlane, float farPlane) {
+    DirectX::XMFLOAT4X4 p;
+    DirectX::XMStoreFloat4x4(&p, projection);
+
+    // Three floats of padding let the last row be read four lanes at a time
+    for (std::vector<float>* plane : { &bounds_.minX, &bounds_.maxX, &bounds_.minY, &bounds_.maxY }) {
+        plane->assign(CLUSTER_COUNT + 3, 0.0f);
+    }
+    bounds_.minZ.resize(GRID_Z);
+    bounds_.maxZ.resize(GRID_Z);
+
+    // Exponential slices keep clusters roughly cubic from the near plane to the far plane
+    const float ratio = farPlane / nearPlane;
+    for (UINT slice = 0; slice < GRID_Z; ++slice) {
+        const float z0 = nearPlane * std::pow(ratio, static_cast<float>(slice) / GRID_Z);
+        const float z1 = nearPlane * std::pow(ratio, static_cast<float>(slice + 1) / GRID_Z);
+        bounds_.minZ[slice] = z0;
+        bounds_.maxZ[slice] = z1;
+
+        for (UINT y = 0; y < GRID_Y; ++y) {
+            // Tile rows run top to bottom like SV_Position
+            const float ndcTop = 1.0f - 2.0f * y / GRID_Y;
+            const float ndcBottom = 1.0f - 2.0f * (y + 1) / GRID_Y;
+            const float top = (ndcTop - p._32) / p._22;
+            const float bottom = (ndcBottom - p._32) / p._22;
+
+            for (UINT x = 0; x < GRID_X; ++x) {
+                const float left = (-1.0f + 2.0f * x / GRID_X - p._31) / p._11;
+                const float right = (-1.0f + 2.0f * (x + 1) / GRID_X - p._31) / p._11;
+
+                const size_t cluster = (static_cast<size_t>(slice) * GRID_Y + y) * GRID_X + x;
+                bounds_.minX[cluster] = std::min(left * z0, left * z1);
+                bounds_.maxX[cluster] = std::max(right * z0, right * z1);
+                bounds_.minY[cluster] = std::min(bottom * z0, bottom * z1);
+                bounds_.maxY[cluster] = std::max(top * z0, top * z1);
+            }
+        }
+    }
+    boundsProjection_ = p;
+}
+
+void ClusteredLightCuller::Build(const std::vector<const Light*>& lights, DirectX::FXMMATRIX view,
+                                 DirectX::CXMMATRIX projection, int screenWidth, int screenHeight, JobSystem* jobs) {
+    using namespace DirectX;
+    NEXUS_PROFILE_SCOPE("ClusteredLightCuller::Build");
+    stats_ = Stats();
+    if (!lightBuffer_ || screenWidth <= 0 || screenHeight <= 0) return;
+
+    // Directional lights first; they reach every pixel and are never binned
+    gpuLights_.clear();
+    spheres_.clear();
+    for (const Light* light : lights) {
+        if (!light || light->GetType() != LightType::Directional || gpuLights_.size() == MAX_LIGHTS) continue;
+        GpuLight gpu = {};
+        XMStoreFloat3(&gpu.color, XMVectorScale(XMLoadFloat3(&light->GetColor()), light->GetIntensity()));
+        XMStoreFloat3(&gpu.direction, XMVector3Normalize(XMLoadFloat3(&light->GetDirection())));
+        gpu.spotOffset = 1.0f;
+        gpuLights_.push_back(gpu);
+    }
+    stats_.directionalLights = static_cast<uint32_t>(gpuLights_.size());
+
+    bool overflow = false;
+    for (const Light* light : lights) {
+        if (!light || light->GetType() == LightType::Directional || light->GetRange() <= 0.0f) continue;
+        if (gpuLights_.size() == MAX_LIGHTS) {
+            overflow = true;
+            break;
+        }
+
+        GpuLight gpu = {};
+        gpu.position = light->GetPosition();
+        gpu.range = light->GetRange();
+        XMStoreFloat3(&gpu.color, XMVectorScale(XMLoadFloat3(&light->GetColor()), light->GetIntensity()));
+        const XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&light->GetDirection()));
+        XMStoreFloat3(&gpu.direction, direction);
+
+        XMVECTOR center = XMLoadFloat3(&gpu.position);
+        float radius = gpu.range;
+        if (light->GetType() == LightType::Spot) {
+            const float angle = std::min(light->GetConeAngle(), XM_PIDIV2);
+            const float cosOuter = std::cos(angle);
+            const float cosInner = std::cos(angle * SPOT_INNER_FRACTION);
+            gpu.spotScale = 1.0f / std::max(cosInner - cosOuter, 1e-4f);
+            gpu.spotOffset = -cosOuter * gpu.spotScale;
+
+            // Smallest sphere around the cone: its cap for wide cones, else one through the apex
+            if (angle > XM_PIDIV4) {
+                center = XMVectorAdd(center, XMVectorScale(direction, cosOuter * gpu.range));
+                radius = std::sin(angle) * gpu.range;
+            } else {
+                radius = gpu.range / (2.0f * cosOuter);
+                center = XMVectorAdd(center, XMVectorScale(direction, radius));
+            }
+        } else {
+            gpu.spotOffset = 1.0f;
+        }
+
+        XMFLOAT4 sphere;
+        XMStoreFloat4(&sphere, XMVector3TransformCoord(center, view));
+        sphere.w = radius;
+        spheres_.push_back(sphere);
+        gpuLights_.push_back(gpu);
+    }
+    if (overflow) {
+        static bool warned = false;
+        if (!warned) {
+            Logger::Warning("Clustered lighting is limited to " + std::to_string(MAX_LIGHTS) + " lights, ignoring the rest");
+            warned = true;
+        }
+    }
+    stats_.lights = static_cast<uint32_t>(spheres_.size());
+
+    // Near and far planes from a left-handed perspective matrix; reversed depth swaps them
+    XMFLOAT4X4 p;
+    XMStoreFloat4x4(&p, projection);
+    const bool perspective = p._34 != 0.0f && p._44 == 0.0f && p._33 != 0.0f && p._33 != 1.0f;
+    float nearPlane = perspective ? -p._43 / p._33 : 0.0f;
+    float farPlane = perspective ? p._43 / (1.0f - p._33) : 0.0f;
+    if (nearPlane > farPlane) std::swap(nearPlane, farPlane);
+
+    gridValid_ = perspective && nearPlane > 0.0f;
+    if (!gridValid_) {
+        static bool warned = false;
+        if (!warned && !spheres_.empty()) {
+            Logger::Warning("Clustered lighting needs a perspective projection; point and spot lights are skipped");
+            warned = true;
+        }
+        spheres_.clear();
+        nearPlane = 1.0f;
+        farPlane = 2.0f;
+    } else if (bounds_.minZ.empty() || std::memcmp(&p, &boundsProjection_, sizeof(p)) != 0) {
+        BuildClusterBounds(projection, nearPlane, farPlane);
+    }
+
+    const uint16_t firstClustered = static_cast<uint16_t>(stats_.directionalLights);
+    BinSpheres(spheres_, firstClustered, maxLightsPerCluster_, lists_, jobs);
+    stats_.indices = static_cast<uint32_t>(lists_.indices.size());
+    stats_.maxClusterLights = lists_.maxCount;
+    stats_.droppedReferences = lists_.dropped;
+
+    XMStoreFloat4x4(&gpuConstants_.view, XMMatrixTranspose(view));
+    gpuConstants_.tileScale[0] = static_cast<float>(GRID_X) / screenWidth;
+    gpuConstants_.tileScale[1] = static_cast<float>(GRID_Y) / screenHeight;
+    gpuConstants_.sliceScale = GRID_Z / std::log(farPlane / nearPlane);
+    gpuConstants_.sliceBias = -std::log(nearPlane) * gpuConstants_.sliceScale;
+    gpuConstants_.directionalLights = stats_.directionalLights;
+    gpuConstants_.lightCount = static_cast<UINT>(gpuLights_.size());
+    Upload();
+}
+
+void ClusteredLightCuller::BinSpheres(const std::vector<DirectX::XMFLOAT4>& spheres, uint16_t firstIndex,
+                                      UINT maxPerCluster, ClusterLists& lists, JobSystem* jobs) const {
+    using namespace DirectX;
+    lists.ranges.assign(CLUSTER_COUNT * 2, 0u);
+    lists.indices.clear();
+    lists.maxCount = 0;
+    lists.dropped = 0;
+    if (!gridValid_ || spheres.empty() || maxPerCluster == 0) return;
+    lists.slots.resize(static_cast<size_t>(CLUSTER_COUNT) * maxPerCluster);
+    const XMFLOAT4X4& p = boundsProjection_;
+
+    // Each job owns whole depth slices, so no two jobs touch the same cluster
+    std::vector<uint32_t> sliceDropped(GRID_Z, 0);
+    auto binSlices = [&](size_t begin, size_t end) {
+        for (size_t slice = begin; slice < end; ++slice) {
+            const float sliceNear = bounds_.minZ[slice];
+            const float sliceFar = bounds_.maxZ[slice];
+
+            for (size_t i = 0; i < spheres.size(); ++i) {
+                const XMFLOAT4& sphere = spheres[i];
+                if (sphere.z + sphere.w < sliceNear || sphere.z - sphere.w > sliceFar) continue;
+
+                // Screen tiles touched by the sphere's box where it overlaps this slice
+                const float z0 = std::max(sphere.z - sphere.w, sliceNear);
+                const float z1 = std::min(sphere.z + sphere.w, sliceFar);
+                float minX, maxX, minY, maxY;
+                ProjectRange(sphere.x - sphere.w, sphere.x + sphere.w, z0, z1, p._11, p._31, minX, maxX);
+                ProjectRange(sphere.y - sphere.w, sphere.y + sphere.w, z0, z1, p._22, p._32, minY, maxY);
+                if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) continue;
+
+                const int tileX0 = ToTile(minX * 0.5f + 0.5f, GRID_X);
+                const int tileX1 = ToTile(maxX * 0.5f + 0.5f, GRID_X);
+                const int tileY0 = ToTile(0.5f - maxY * 0.5f, GRID_Y);
+                const int tileY1 = ToTile(0.5f - minY * 0.5f, GRID_Y);
+
+                // Sphere against each cluster box, four clusters of a row per step
+                const float dz = std::max(sliceNear - sphere.z, 0.0f) + std::max(sphere.z - sliceFar, 0.0f);
+                const __m128 limit = _mm_set1_ps(sphere.w * sphere.w - dz * dz);
+                const __m128 centerX = _mm_set1_ps(sphere.x);
+                const __m128 centerY = _mm_set1_ps(sphere.y);
+                const __m128 zero = _mm_setzero_ps();
+                const uint16_t index = static_cast<uint16_t>(firstIndex + i);
+
+                for (int tileY = tileY0; tileY <= tileY1; ++tileY) {
+                    const size_t row = (slice * GRID_Y + tileY) * GRID_X;
+                    for (int tileX = tileX0; tileX <= tileX1; tileX += 4) {
+                        const size_t cluster = row + tileX;
+                        const __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&bounds_.minX[cluster]), centerX), zero),
+                                                     _mm_max_ps(_mm_sub_ps(centerX, _mm_loadu_ps(&bounds_.maxX[cluster])), zero));
+                        const __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&bounds_.minY[cluster]), centerY), zero),
+                                                     _mm_max_ps(_mm_sub_ps(centerY, _mm_loadu_ps(&bounds_.maxY[cluster])), zero));
+                        const __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+                        int hits = _mm_movemask_ps(_mm_cmple_ps(distance, limit));
+                        hits &= (1 << std::min(4, tileX1 - tileX + 1)) - 1;
+
+                        for (int lane = 0; hits; ++lane, hits >>= 1) {
+                            if (!(hits & 1)) continue;
+                            const size_t hit = cluster + lane;
+                            uint32_t& count = lists.ranges[hit * 2 + 1];
+                            if (count < maxPerCluster) {
+                                lists.slots[hit * maxPerCluster + count++] = index;
+                            } else {
+                                ++sliceDropped[slice];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    if (jobs && jobs->IsInitialized()) {
+        jobs->ParallelFor(GRID_Z, 1, binSlices);
+    } else {
+        binSlices(0, GRID_Z);
+    }
+
+    // Pack the per-cluster lists back to back
+    uint32_t total = 0;
+    for (UINT cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        const uint32_t count = lists.ranges[cluster * 2 + 1];
+        lists.ranges[cluster * 2] = total;
+        total += count;
+        lists.maxCount = std::max(lists.maxCount, count);
+    }
+    lists.indices.resize(total);
+    for (UINT cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        const uint16_t* source = &lists.slots[static_cast<size_t>(cluster) * maxPerCluster];
+        std::copy(source, source + lists.ranges[cluster * 2 + 1], lists.indices.begin() + lists.ranges[cluster * 2]);
+    }
+    for (uint32_t dropped : sliceDropped) lists.dropped += dropped;
+}
+
+void ClusteredLightCuller::Upload() {
+    if (!EnsureIndexCapacity(static_cast<UINT>(lists_.indices.size()))) {
+        // Without room for the lists, no cluster may reference any
+        lists_.indices.clear();
+        std::fill(lists_.ranges.begin(), lists_.ranges.end(), 0u);
+        if (!indexBuffer_) return;
+    }
+    WriteBuffer(context_, lightBuffer_, gpuLights_.data(), gpuLights_.size() * sizeof(GpuLight));
+    WriteBuffer(context_, rangeBuffer_, lists_.ranges.data(), lists_.ranges.size() * sizeof(uint32_t));
+    WriteBuffer(context_, indexBuffer_, lists_.indices.data(), lists_.indices.size() * sizeof(uint16_t));
+    WriteBuffer(context_, constants_, &gpuConstants_, sizeof(GpuConstants));
+}
+
+void ClusteredLightCuller::Bind(StateCache& stateCache) const {
+    if (!lightView_ || !indexView_) return;
+    ID3D11ShaderResourceView* views[] = { lightView_, rangeView_, indexView_ };
+    stateCache.PSSetShaderResources(LIGHT_SLOT, 3, views);
+    stateCache.PSSetConstantBuffers(CONSTANT_SLOT, 1, &constants_);
+}
+
+void ClusteredLightCuller::BindCompute() const {
+    if (!lightView_ || !indexView_) return;
+    ID3D11ShaderResourceView* views[] = { lightView_, rangeView_, indexView_ };
+    context_->CSSetShaderResources(LIGHT_SLOT, 3, views);
+    context_->CSSetConstantBuffers(CONSTANT_SLOT, 1, &constants_);
+}
+
+} // namespace Nexus
@@ -0,0 +1,135 @@
+#include "CommandRecorder.h"
+#include "ConstantBufferRing.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "StateCache.h"
+
+namespace Nexus {
+
+namespace {
+// Deferred contexts only need room for one pass worth of constants
+constexpr UINT DEFERRED_CONSTANT_RING_SIZE = 256 * 1024;
+}
+
+CommandRecorder::CommandRecorder()
+    : recordedPasses_(0)
+    , driverCommandLists_(false)
+{
+}
+
+CommandRecorder::~CommandRecorder() {
+    Shutdown();
+}
+
+bool CommandRecorder::Initialize(ID3D11Device* device, unsigned int contextCount) {
+    if (!device || contextCount == 0) return false;
+    Shutdown();
+
+    D3D11_FEATURE_DATA_THREADING threading = {};
+    if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading)))) {
+        driverCommandLists_ = threading.DriverCommandLists != FALSE;
+    }
+
+    for (unsigned int i = 0; i < contextCount; ++i) {
+        Recorder recorder;
+        if (FAILED(device->CreateDeferredContext(0, &recorder.context))) {
+            Logger::Error("Failed to create deferred context " + std::to_string(i));
+            break;
+        }
+        recorder.stateCache = std::make_unique<StateCache>();
+        recorder.stateCache->Initialize(recorder.context);
+        recorder.constants = std::make_unique<ConstantBufferRing>();
+        recorder.constants->Initialize(device, recorder.context, DEFERRED_CONSTANT_RING_SIZE);
+        recorders_.push_back(std::move(recorder));
+    }
+
+    if (recorders_.empty()) {
+        return false;
+    }
+
+    Logger::Info("Command recorder: " + std::to_string(recorders_.size()) + " deferred context(s), " +
+                 (driverCommandLists_ ? "native" : "emulated") + " command lists");
+    return true;
+}
+
+void CommandRecorder::Shutdown() {
+    ReleaseCommandLists();
+    for (Recorder& recorder : recorders_) {
+        recorder.constants->Shutdown();
+        recorder.stateCache->Shutdown();
+        if (recorder.context) { recorder.context->Release(); recorder.context = nullptr; }
+    }
+    recorders_.clear();
+    driverCommandLists_ = false;
+}
+
+void CommandRecorder::ReleaseCommandLists() {
+    for (Recorder& recorder : recorders_) {
+        if (recorder.commandList) { recorder.commandList->Release(); recorder.commandList = nullptr; }
+    }
+    recordedPasses_ = 0;
+}
+
+bool CommandRecorder::Record(JobSystem* jobs, size_t passCount, const RecordFunction& record) {
+    if (passCount == 0 || passCount > recorders_.size()) return false;
+
+    NEXUS_PROFILE_SCOPE("CommandRecorder::Record");
+    ReleaseCommandLists();
+
+    auto recordRange = [this, &record](size_t begin, size_t end) {
+        for (size_t pass = begin; pass < end; ++pass) {
+            NEXUS_PROFILE_SCOPE("CommandRecorder::RecordPass");
+            Recorder& recorder = recorders_[pass];
+
+            // Finished lists leave the deferred context in default state, and the ring's first
+            // map in a new list has to discard
+            recorder.stateCache->Invalidate();
+            recorder.stateCache->ResetStats();
+            recorder.constants->Reset();
+
+            CommandContext context;
+            context.context = recorder.context;
+            context.stateCache = recorder.stateCache.get();
+            context.constants = recorder.constants.get();
+            record(pass, context);
+
+            if (FAILED(recorder.context->FinishCommandList(FALSE, &recorder.commandList))) {
+                Logger::Error("FinishCommandList failed for pass " + std::to_string(pass));
+                recorder.commandList = nullptr;
+            }
+        }
+    };
+
+    if (jobs && jobs->IsInitialized()) {
+        jobs->ParallelFor(passCount, 1, recordRange);
+    } else {
+        recordRange(0, passCount);
+    }
+
+    recordedPasses_ = passCount;
+    return true;
+}
+
+void CommandRecorder::SetPixelOverride(ID3D11PixelShader* shader, ID3D11BlendState* blend) {
+    for (Recorder& recorder : recorders_) {
+        recorder.stateCache->SetPixelOverride(shader, blend);
+    }
+}
+
+void CommandRecorder::Execute(ID3D11DeviceContext* immediateContext, StateCache& immediateCache) {
+    if (!immediateContext || recordedPasses_ == 0) return;
+
+    NEXUS_PROFILE_SCOPE("CommandRecorder::Execute");
+    for (size_t pass = 0; pass < recordedPasses_; ++pass) {
+        if (recorders_[pass].commandList) {
+            immediateContext->ExecuteCommandList(recorders_[pass].commandList, FALSE);
+        }
+    }
+
+    // RestoreContextState = FALSE resets the immediate context to defaults after each list
+    immediateCache.Invalidate();
+    ReleaseCommandLists();
+}
+
+} // namespace Nexus
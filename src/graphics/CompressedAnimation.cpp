@@ -0,0 +1,384 @@
+#include "CompressedAnimation.h"
+#include "AtomicFile.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+
+constexpr float QUANTIZED_MAX = 65535.0f;
+constexpr float ROTATION_MAX = 32767.0f;             // 15 bits per component
+constexpr float SQRT2 = 1.41421356f;
+
+float Distance(const XMFLOAT3& a, const XMFLOAT3& b) {
+    float x = a.x - b.x, y = a.y - b.y, z = a.z - b.z;
+    return std::sqrt(x * x + y * y + z * z);
+}
+
+XMFLOAT3 Lerp(const XMFLOAT3& a, const XMFLOAT3& b, float t) {
+    return XMFLOAT3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+}
+
+XMFLOAT4 Slerp(const XMFLOAT4& a, const XMFLOAT4& b, float t) {
+    XMFLOAT4 result;
+    XMStoreFloat4(&result, XMQuaternionSlerp(XMLoadFloat4(&a), XMLoadFloat4(&b), t));
+    return result;
+}
+
+// Angle between the rotations
+float Angle(const XMFLOAT4& a, const XMFLOAT4& b) {
+    float dot = std::abs(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+    return 2.0f * std::acos(std::min(dot, 1.0f));
+}
+
+uint16_t Quantize(float value, float low, float step) {
+    return step > 0.0f ? static_cast<uint16_t>(std::clamp(std::round((value - low) / step), 0.0f, QUANTIZED_MAX)) : 0;
+}
+
+// Keys to keep, in order. A key goes when interpolating between the last kept key and a later
+// one reproduces it, and every key skipped since, within tolerance
+template<typename T, typename Interpolate, typename Error>
+std::vector<size_t> ReduceKeys(const std::vector<T>& values, const std::vector<float>& times, float tolerance,
+                               Interpolate interpolate, Error error) {
+    std::vector<size_t> kept(1, 0);
+    size_t anchor = 0;
+    for (size_t end = anchor + 2; end < values.size(); ++end) {
+        float span = times[end] - times[anchor];
+        bool fits = true;
+        for (size_t i = anchor + 1; i < end && fits; ++i) {
+            float t = span > 0.0f ? (times[i] - times[anchor]) / span : 0.0f;
+            fits = error(interpolate(values[anchor], values[end], t), values[i]) <= tolerance;
+        }
+        if (!fits) {
+            anchor = end - 1;
+            kept.push_back(anchor);
+        }
+    }
+    if (values.size() > 1) kept.push_back(values.size() - 1);
+    return kept;
+}
+
+// Smallest three: the largest component is implied by the others, so it is dropped after
+// making it positive, which leaves the others within +-1/sqrt(2)
+void EncodeRotation(const XMFLOAT4& rotation, uint16_t* words) {
+    const float components[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+    int largest = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (std::abs(components[i]) > std::abs(components[largest])) largest = i;
+    }
+    const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    uint64_t bits = static_cast<uint64_t>(largest);
+    int shift = 2;
+    for (int i = 0; i < 4; ++i) {
+        if (i == largest) continue;
+        float unit = std::clamp(components[i] * sign * SQRT2 * 0.5f + 0.5f, 0.0f, 1.0f);
+        bits |= static_cast<uint64_t>(std::round(unit * ROTATION_MAX)) << shift;
+        shift += 15;
+    }
+    words[0] = static_cast<uint16_t>(bits);
+    words[1] = static_cast<uint16_t>(bits >> 16);
+    words[2] = static_cast<uint16_t>(bits >> 32);
+}
+
+} // namespace
+
+CompressedClip::CompressedClip()
+    : duration(0.0f)
+    , frameRate(30.0f)
+    , isLooping(false)
+    , hasRootMotion(false)
+{
+}
+
+bool CompressedClip::Compress(const AnimationSystem::AnimationClip& clip, const AnimationCompressionSettings& settings) {
+    tracks_.clear();
+    keyTimes_.clear();
+    keyValues_.clear();
+    name = clip.name;
+    frameRate = clip.frameRate;
+    isLooping = clip.isLooping;
+    hasRootMotion = clip.hasRootMotion;
+    events = clip.events;
+
+    // Key times are stored across the duration, so it has to cover every key
+    duration = std::max(clip.duration, 0.0f);
+    for (const AnimationSystem::AnimationTrack& track : clip.tracks) {
+        if (!track.keyframes.empty()) duration = std::max(duration, track.keyframes.back().time);
+    }
+
+    std::vector<float> times;
+    std::vector<XMFLOAT3> positions, scales;
+    std::vector<XMFLOAT4> rotations;
+    for (const AnimationSystem::AnimationTrack& track : clip.tracks) {
+        if (track.keyframes.empty()) continue;
+        times.clear();
+        positions.clear();
+        rotations.clear();
+        scales.clear();
+        for (const AnimationSystem::Keyframe& key : track.keyframes) {
+            times.push_back(std::max(key.time, 0.0f));
+            positions.push_back(key.position);
+            scales.push_back(key.scale);
+
+            // Normalized, and on the same side as the previous key so interpolation takes the short way
+            XMFLOAT4 rotation;
+            XMStoreFloat4(&rotation, XMQuaternionNormalize(XMLoadFloat4(&key.rotation)));
+            if (!rotations.empty()) {
+                const XMFLOAT4& last = rotations.back();
+                if (last.x * rotation.x + last.y * rotation.y + last.z * rotation.z + last.w * rotation.w < 0.0f) {
+                    rotation = XMFLOAT4(-rotation.x, -rotation.y, -rotation.z, -rotation.w);
+                }
+            }
+            rotations.push_back(rotation);
+        }
+
+        Track compressed = {};
+        compressed.boneIndex = track.boneIndex;
+        AddVectorChannel(compressed.channels[0], positions, times, settings.positionTolerance);
+        AddRotationChannel(compressed.channels[1], rotations, times, settings.rotationTolerance);
+        AddVectorChannel(compressed.channels[2], scales, times, settings.scaleTolerance);
+        tracks_.push_back(compressed);
+    }
+    return !tracks_.empty();
+}
+
+void CompressedClip::AddVectorChannel(Channel& channel, const std::vector<XMFLOAT3>& values,
+                                      const std::vector<float>& times, float tolerance) {
+    const bool still = std::all_of(values.begin(), values.end(),
+                                   [&](const XMFLOAT3& value) { return Distance(value, values[0]) <= tolerance; });
+    const std::vector<size_t> kept = still ? std::vector<size_t>(1, 0)
+                                           : ReduceKeys(values, times, tolerance, Lerp, Distance);
+
+    // A still channel keeps its value exactly, with nothing to scale
+    XMFLOAT3 low = values[0], high = values[0];
+    if (!still) {
+        for (size_t i : kept) {
+            low = XMFLOAT3(std::min(low.x, values[i].x), std::min(low.y, values[i].y), std::min(low.z, values[i].z));
+            high = XMFLOAT3(std::max(high.x, values[i].x), std::max(high.y, values[i].y), std::max(high.z, values[i].z));
+        }
+    }
+    channel.firstKey = static_cast<uint32_t>(keyTimes_.size());
+    channel.keyCount = static_cast<uint32_t>(kept.size());
+    channel.rangeMin = low;
+    channel.rangeStep = XMFLOAT3((high.x - low.x) / QUANTIZED_MAX, (high.y - low.y) / QUANTIZED_MAX,
+                                 (high.z - low.z) / QUANTIZED_MAX);
+    for (size_t i : kept) {
+        keyTimes_.push_back(QuantizeTime(times[i]));
+        keyValues_.push_back(Quantize(values[i].x, low.x, channel.rangeStep.x));
+        keyValues_.push_back(Quantize(values[i].y, low.y, channel.rangeStep.y));
+        keyValues_.push_back(Quantize(values[i].z, low.z, channel.rangeStep.z));
+    }
+}
+
+void CompressedClip::AddRotationChannel(Channel& channel, const std::vector<XMFLOAT4>& values,
+                                        const std::vector<float>& times, float tolerance) {
+    const bool still = std::all_of(values.begin(), values.end(),
+                                   [&](const XMFLOAT4& value) { return Angle(value, values[0]) <= tolerance; });
+    const std::vector<size_t> kept = still ? std::vector<size_t>(1, 0)
+                                           : ReduceKeys(values, times, tolerance, Slerp, Angle);
+
+    channel.firstKey = static_cast<uint32_t>(keyTimes_.size());
+    channel.keyCount = static_cast<uint32_t>(kept.size());
+    channel.rangeMin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    channel.rangeStep = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    for (size_t i : kept) {
+        keyTimes_.push_back(QuantizeTime(times[i]));
+        keyValues_.resize(keyValues_.size() + 3);
+        EncodeRotation(values[i], &keyValues_[keyValues_.size() - 3]);
+    }
+}
+
+uint16_t CompressedClip::QuantizeTime(float time) const {
+    return duration > 0.0f ? static_cast<uint16_t>(std::round(std::clamp(time / duration, 0.0f, 1.0f) * QUANTIZED_MAX)) : 0;
+}
+
+float CompressedClip::KeyTime(uint32_t key) const {
+    return keyTimes_[key] * (duration / QUANTIZED_MAX);
+}
+
+void CompressedClip::FindKeys(const Channel& channel, float time, int& cursor, uint32_t& prev, uint32_t& next,
+                              float& t) const {
+    const uint16_t* times = keyTimes_.data() + channel.firstKey;
+    const int last = static_cast<int>(channel.keyCount) - 1;
+    const float scaled = duration > 0.0f ? time * (QUANTIZED_MAX / duration) : 0.0f;
+    t = 0.0f;
+    if (last <= 0 || scaled <= times[0]) {
+        cursor = 0;
+        prev = next = channel.firstKey;
+        return;
+    }
+    if (scaled >= times[last]) {
+        cursor = last;
+        prev = next = channel.firstKey + last;
+        return;
+    }
+
+    // Same search as AnimationTrack::FindKeyframes, over the quantized times
+    auto contains = [times, scaled](int i) { return times[i] <= scaled && scaled < times[i + 1]; };
+    int i = std::clamp(cursor, 0, last - 1);
+    if (!contains(i)) {
+        if (i + 1 < last && contains(i + 1)) {
+            ++i;
+        } else if (i > 0 && contains(i - 1)) {
+            --i;
+        } else {
+            const uint16_t* key = std::upper_bound(times, times + last + 1, scaled,
+                                                   [](float value, uint16_t keyTime) { return value < keyTime; });
+            i = static_cast<int>(key - times) - 1;
+        }
+    }
+
+    cursor = i;
+    prev = channel.firstKey + i;
+    next = prev + 1;
+    t = (scaled - times[i]) / static_cast<float>(times[i + 1] - times[i]);
+}
+
+XMFLOAT3 CompressedClip::DecodeVector(const Channel& channel, uint32_t key) const {
+    const uint16_t* words = &keyValues_[key * 3];
+    return XMFLOAT3(channel.rangeMin.x + words[0] * channel.rangeStep.x, channel.rangeMin.y + words[1] * channel.rangeStep.y,
+                    channel.rangeMin.z + words[2] * channel.rangeStep.z);
+}
+
+XMFLOAT4 CompressedClip::DecodeRotation(uint32_t key) const {
+    const uint16_t* words = &keyValues_[key * 3];
+    const uint64_t bits = words[0] | (static_cast<uint64_t>(words[1]) << 16) | (static_cast<uint64_t>(words[2]) << 32);
+    const int largest = static_cast<int>(bits & 3);
+    float components[4];
+    float sum = 0.0f;
+    int shift = 2;
+    for (int i = 0; i < 4; ++i) {
+        if (i == largest) continue;
+        components[i] = (static_cast<float>((bits >> shift) & 0x7FFF) / ROTATION_MAX - 0.5f) * SQRT2;
+        sum += components[i] * components[i];
+        shift += 15;
+    }
+    components[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+    return XMFLOAT4(components[0], components[1], components[2], components[3]);
+}
+
+void CompressedClip::Sample(size_t trackIndex, float time, int* cursors, XMFLOAT3& position, XMFLOAT4& rotation,
+                            XMFLOAT3& scale) const {
+    const Track& track = tracks_[trackIndex];
+    uint32_t prev, next;
+    float t;
+
+    FindKeys(track.channels[0], time, cursors[0], prev, next, t);
+    position = Lerp(DecodeVector(track.channels[0], prev), DecodeVector(track.channels[0], next), t);
+
+    FindKeys(track.channels[1], time, cursors[1], prev, next, t);
+    rotation = DecodeRotation(prev);
+    if (next != prev) rotation = Slerp(rotation, DecodeRotation(next), t);
+
+    FindKeys(track.channels[2], time, cursors[2], prev, next, t);
+    scale = Lerp(DecodeVector(track.channels[2], prev), DecodeVector(track.channels[2], next), t);
+}
+
+size_t CompressedClip::GetMemoryUsage() const {
+    return sizeof(*this) + tracks_.size() * sizeof(Track) + keyTimes_.size() * sizeof(uint16_t) +
+           keyValues_.size() * sizeof(uint16_t);
+}
+
+bool CompressedClip::Save(const std::string& filename) const {
+    FileHeader header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.duration = duration;
+    header.frameRate = frameRate;
+    header.flags = (isLooping ? 1u : 0u) | (hasRootMotion ? 2u : 0u);
+    header.trackCount = static_cast<uint32_t>(tracks_.size());
+    header.keyCount = static_cast<uint32_t>(keyTimes_.size());
+    header.eventCount = static_cast<uint32_t>(events.size());
+    header.nameLength = static_cast<uint32_t>(name.size());
+
+    bool written = WriteFileAtomic(filename, [&](std::ostream& file) {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(name.data(), name.size());
+        file.write(reinterpret_cast<const char*>(tracks_.data()), tracks_.size() * sizeof(Track));
+        file.write(reinterpret_cast<const char*>(keyTimes_.data()), keyTimes_.size() * sizeof(uint16_t));
+        file.write(reinterpret_cast<const char*>(keyValues_.data()), keyValues_.size() * sizeof(uint16_t));
+        for (const auto& event : events) {
+            uint32_t length = static_cast<uint32_t>(event.first.size());
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            file.write(event.first.data(), length);
+            file.write(reinterpret_cast<const char*>(&event.second), sizeof(event.second));
+        }
+    });
+    if (!written) {
+        Logger::Error("Failed to write animation clip: " + filename);
+        return false;
+    }
+    return true;
+}
+
+bool CompressedClip::Load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    FileHeader header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != MAGIC ||
+        header.version != VERSION) {
+        Logger::Error("Not an animation clip: " + filename);
+        return false;
+    }
+
+    // The counts come from the file; a damaged header must not size buffers past what follows it
+    const std::streamoff start = file.tellg();
+    file.seekg(0, std::ios::end);
+    const uint64_t remaining = static_cast<uint64_t>(file.tellg() - start);
+    file.seekg(start);
+    const uint64_t required = static_cast<uint64_t>(header.nameLength) +
+                              static_cast<uint64_t>(header.trackCount) * sizeof(Track) +
+                              static_cast<uint64_t>(header.keyCount) * sizeof(uint16_t) * 4;
+    if (!file || required > remaining) {
+        Logger::Error("Truncated or corrupt animation clip: " + filename);
+        return false;
+    }
+
+    name.resize(header.nameLength);
+    tracks_.resize(header.trackCount);
+    keyTimes_.resize(header.keyCount);
+    keyValues_.resize(static_cast<size_t>(header.keyCount) * 3);
+    events.clear();
+    bool valid = file.read(&name[0], name.size()) &&
+                 file.read(reinterpret_cast<char*>(tracks_.data()), tracks_.size() * sizeof(Track)) &&
+                 file.read(reinterpret_cast<char*>(keyTimes_.data()), keyTimes_.size() * sizeof(uint16_t)) &&
+                 file.read(reinterpret_cast<char*>(keyValues_.data()), keyValues_.size() * sizeof(uint16_t));
+    for (uint32_t i = 0; valid && i < header.eventCount; ++i) {
+        uint32_t length = 0;
+        float time = 0.0f;
+        std::string eventName;
+        valid = static_cast<bool>(file.read(reinterpret_cast<char*>(&length), sizeof(length))) &&
+                length <= remaining - required;
+        if (valid) eventName.resize(length);
+        valid = valid && file.read(&eventName[0], length) && file.read(reinterpret_cast<char*>(&time), sizeof(time));
+        if (valid) events[eventName] = time;
+    }
+
+    // Every channel has at least one key, inside the key arrays
+    for (const Track& track : tracks_) {
+        for (const Channel& channel : track.channels) {
+            valid = valid && channel.keyCount > 0 && channel.firstKey <= header.keyCount &&
+                    channel.keyCount <= header.keyCount - channel.firstKey;
+        }
+    }
+    if (!valid) {
+        Logger::Error("Truncated or corrupt animation clip: " + filename);
+        tracks_.clear();
+        keyTimes_.clear();
+        keyValues_.clear();
+        events.clear();
+        return false;
+    }
+
+    duration = header.duration;
+    frameRate = header.frameRate;
+    isLooping = (header.flags & 1u) != 0;
+    hasRootMotion = (header.flags & 2u) != 0;
+    return true;
+}
+
+} // namespace Nexus
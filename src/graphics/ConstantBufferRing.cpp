@@ -0,0 +1,162 @@
+#include "ConstantBufferRing.h"
+#include "Logger.h"
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+UINT AlignUp(UINT value, UINT alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+ConstantBufferRing::ConstantBufferRing()
+    : device_(nullptr)
+    , context_(nullptr)
+    , useOffsets_(false)
+    , ringBuffer_(nullptr)
+    , capacity_(0)
+    , cursor_(0)
+    , needsDiscard_(true)
+    , fallbackBuffers_{}
+    , fallbackNext_{}
+{
+}
+
+ConstantBufferRing::~ConstantBufferRing() {
+    Shutdown();
+}
+
+bool ConstantBufferRing::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT capacity) {
+    if (!device || !context) return false;
+
+    device_ = device;
+    context_ = context;
+
+    // Offsets need both the 11.1 context entry points and driver support for no-overwrite on
+    // dynamic constant buffers
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    bool supported = SUCCEEDED(device_->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+                     options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+    if (supported) {
+        ID3D11DeviceContext1* context1 = nullptr;
+        supported = SUCCEEDED(context_->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&context1));
+        if (context1) context1->Release();
+    }
+
+    if (supported) {
+        capacity_ = AlignUp(capacity < MAX_ALLOCATION ? MAX_ALLOCATION : capacity, ALIGNMENT);
+        ringBuffer_ = CreateDynamicBuffer(capacity_);
+        if (!ringBuffer_) {
+            capacity_ = 0;
+            supported = false;
+        }
+    }
+
+    useOffsets_ = supported;
+    cursor_ = 0;
+    needsDiscard_ = true;
+
+    Logger::Info(useOffsets_
+        ? "Constant buffer ring: " + std::to_string(capacity_ / 1024) + " KB with 11.1 offsets"
+        : std::string("Constant buffer ring: offsets unavailable, using discard buffer pools"));
+    return true;
+}
+
+void ConstantBufferRing::Shutdown() {
+    if (ringBuffer_) { ringBuffer_->Release(); ringBuffer_ = nullptr; }
+    for (auto& sizeClass : fallbackBuffers_) {
+        for (ID3D11Buffer*& buffer : sizeClass) {
+            if (buffer) { buffer->Release(); buffer = nullptr; }
+        }
+    }
+    capacity_ = 0;
+    cursor_ = 0;
+    useOffsets_ = false;
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+ID3D11Buffer* ConstantBufferRing::CreateDynamicBuffer(UINT size) {
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = size;
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    ID3D11Buffer* buffer = nullptr;
+    if (FAILED(device_->CreateBuffer(&bufferDesc, nullptr, &buffer))) {
+        Logger::Error("Failed to create dynamic constant buffer of " + std::to_string(size) + " bytes");
+        return nullptr;
+    }
+    return buffer;
+}
+
+bool ConstantBufferRing::Upload(const void* data, UINT size, Allocation& out) {
+    if (!context_ || size == 0 || size > MAX_ALLOCATION) return false;
+    if (!useOffsets_) return UploadFallback(data, size, out);
+
+    UINT alignedSize = AlignUp(size, ALIGNMENT);
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    if (needsDiscard_ || cursor_ + alignedSize > capacity_) {
+        // Renaming gives a fresh buffer, so slices still referenced by queued draws stay intact
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        cursor_ = 0;
+        needsDiscard_ = false;
+        stats_.discards++;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(ringBuffer_, 0, mapType, 0, &mapped))) {
+        Logger::Error("Failed to map constant buffer ring");
+        needsDiscard_ = true;
+        return false;
+    }
+    std::memcpy(static_cast<uint8_t*>(mapped.pData) + cursor_, data, size);
+    context_->Unmap(ringBuffer_, 0);
+
+    out.buffer = ringBuffer_;
+    out.firstConstant = cursor_ / 16;
+    out.numConstants = alignedSize / 16;
+    cursor_ += alignedSize;
+
+    stats_.uploads++;
+    stats_.bytes += size;
+    return true;
+}
+
+bool ConstantBufferRing::UploadFallback(const void* data, UINT size, Allocation& out) {
+    int sizeClass = 0;
+    while ((ALIGNMENT << sizeClass) < size) {
+        ++sizeClass;
+    }
+
+    // Rotate through the pool so a few allocations of the same size can be bound at once
+    int slot = fallbackNext_[sizeClass];
+    fallbackNext_[sizeClass] = (slot + 1) % FALLBACK_BUFFERS_PER_CLASS;
+
+    ID3D11Buffer*& buffer = fallbackBuffers_[sizeClass][slot];
+    if (!buffer) {
+        buffer = CreateDynamicBuffer(ALIGNMENT << sizeClass);
+        if (!buffer) return false;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        Logger::Error("Failed to map fallback constant buffer");
+        return false;
+    }
+    std::memcpy(mapped.pData, data, size);
+    context_->Unmap(buffer, 0);
+
+    out.buffer = buffer;
+    out.firstConstant = 0;
+    out.numConstants = 0;
+
+    stats_.uploads++;
+    stats_.bytes += size;
+    stats_.discards++;
+    return true;
+}
+
+} // namespace Nexus
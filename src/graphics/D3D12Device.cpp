@@ -0,0 +1,764 @@
+#include "D3D12Device.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <dxgi1_6.h>
+#include <algorithm>
+
+namespace Nexus {
+
+namespace {
+
+// Resources this size or over get a committed allocation of their own
+constexpr UINT64 DEDICATED_THRESHOLD = D3D12Device::HEAP_BLOCK_SIZE / 4;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+UINT64 AlignUp(UINT64 value, UINT64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+D3D12Device::D3D12Device()
+    : device_(nullptr)
+    , queue_(nullptr)
+    , computeQueue_(nullptr)
+    , swapChain_(nullptr)
+    , swapChainFlags_(0)
+    , tearingSupported_(false)
+    , backBuffers_{}
+    , rootSignature_(nullptr)
+    , fence_(nullptr)
+    , fenceEvent_(nullptr)
+    , frame_(1)
+    , syncFences_{}
+    , syncValues_{}
+    , computeSubmitted_(false)
+    , committedBytes_(0)
+{
+    for (DescriptorIndex& view : backBufferViews_) view = INVALID_DESCRIPTOR;
+}
+
+D3D12Device::~D3D12Device() {
+    Shutdown();
+}
+
+bool D3D12Device::Initialize(HWND hwnd, int width, int height, bool fullscreen) {
+    Logger::Info("Initializing D3D12 device...");
+    if (!CreateDevice()) {
+        Shutdown();
+        return false;
+    }
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    if (FAILED(device_->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&queue_))) ||
+        FAILED(device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)))) {
+        Logger::Error("Failed to create the D3D12 queue");
+        Shutdown();
+        return false;
+    }
+    fenceEvent_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    for (ID3D12Fence*& fence : syncFences_) {
+        if (FAILED(device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)))) {
+            Logger::Error("Failed to create the D3D12 queue fences");
+            Shutdown();
+            return false;
+        }
+    }
+
+    // Optional: without it compute work shares the graphics queue
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+    if (FAILED(device_->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&computeQueue_)))) {
+        Logger::Warning("No D3D12 compute queue, async compute disabled");
+        computeQueue_ = nullptr;
+    }
+
+    if (!CreateDescriptorHeap(resourceHeap_, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, BINDLESS_DESCRIPTORS, true) ||
+        !CreateDescriptorHeap(samplerHeap_, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, BINDLESS_SAMPLERS, true) ||
+        !CreateDescriptorHeap(targetHeap_, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, TARGET_DESCRIPTORS, false) ||
+        !CreateDescriptorHeap(depthHeap_, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, TARGET_DESCRIPTORS, false)) {
+        Logger::Error("Failed to create the D3D12 descriptor heaps");
+        Shutdown();
+        return false;
+    }
+    if (!CreateRootSignature() || !CreateSwapChain(hwnd, width, height, fullscreen) || !CreateBackBufferViews()) {
+        Shutdown();
+        return false;
+    }
+
+    Logger::Info("D3D12 device initialized");
+    return true;
+}
+
+void D3D12Device::Shutdown() {
+    if (queue_ && fence_) {
+        WaitForIdle();
+    }
+    ReleaseBackBuffers();
+    if (swapChain_) {
+        // A swap chain must not be released in exclusive fullscreen
+        swapChain_->SetFullscreenState(FALSE, nullptr);
+        SafeRelease(swapChain_);
+    }
+    for (FrameSlot& slot : slots_) {
+        for (int type = 0; type < 2; ++type) {
+            for (CommandList& list : slot.lists[type]) {
+                SafeRelease(list.list);
+                SafeRelease(list.allocator);
+            }
+            slot.lists[type].clear();
+            slot.used[type] = 0;
+        }
+        slot.fence = 0;
+    }
+    ReleaseRetired(0, true);
+    for (auto& placement : placements_) {
+        placement.first->Release();
+    }
+    placements_.clear();
+    for (HeapBlock& block : blocks_) {
+        SafeRelease(block.heap);
+    }
+    blocks_.clear();
+    committedBytes_ = 0;
+    for (DescriptorHeap* heap : { &resourceHeap_, &samplerHeap_, &targetHeap_, &depthHeap_ }) {
+        SafeRelease(heap->heap);
+        *heap = DescriptorHeap();
+    }
+    SafeRelease(rootSignature_);
+    if (fenceEvent_) { CloseHandle(fenceEvent_); fenceEvent_ = nullptr; }
+    SafeRelease(fence_);
+    for (int type = 0; type < 2; ++type) {
+        SafeRelease(syncFences_[type]);
+        syncValues_[type] = 0;
+    }
+    computeSubmitted_ = false;
+    SafeRelease(computeQueue_);
+    SafeRelease(queue_);
+    SafeRelease(device_);
+    frame_ = 1;
+}
+
+bool D3D12Device::CreateDevice() {
+    // The adapter DXGI ranks fastest, which on hybrid laptops is the discrete GPU
+    IDXGIFactory6* factory = nullptr;
+    if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory)))) {
+        Logger::Error("Failed to create a DXGI 1.6 factory for D3D12");
+        return false;
+    }
+    IDXGIAdapter1* adapter = nullptr;
+    for (UINT i = 0; factory->EnumAdapterByGpuPreference(i, DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE,
+                                                          IID_PPV_ARGS(&adapter)) != DXGI_ERROR_NOT_FOUND; ++i) {
+        DXGI_ADAPTER_DESC1 desc = {};
+        adapter->GetDesc1(&desc);
+        if (!(desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) &&
+            SUCCEEDED(D3D12CreateDevice(adapter, D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&device_)))) {
+            break;
+        }
+        SafeRelease(adapter);
+    }
+    SafeRelease(adapter);
+    factory->Release();
+    if (!device_) {
+        Logger::Error("No adapter supports D3D12 with DXR-era interfaces (ID3D12Device5)");
+        return false;
+    }
+
+    // Directly indexed heaps: every descriptor reachable from any shader without tables
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    D3D12_FEATURE_DATA_SHADER_MODEL shaderModel = { D3D_SHADER_MODEL_6_6 };
+    if (FAILED(device_->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) ||
+        options.ResourceBindingTier < D3D12_RESOURCE_BINDING_TIER_3 ||
+        FAILED(device_->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel))) ||
+        shaderModel.HighestShaderModel < D3D_SHADER_MODEL_6_6) {
+        Logger::Warning("D3D12 adapter lacks bindless support (resource binding tier 3, shader model 6.6)");
+        return false;
+    }
+    return true;
+}
+
+bool D3D12Device::CreateSwapChain(HWND hwnd, int width, int height, bool fullscreen) {
+    IDXGIFactory5* factory = nullptr;
+    if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory)))) {
+        Logger::Error("Failed to create a DXGI factory for the D3D12 swap chain");
+        return false;
+    }
+    BOOL allowTearing = FALSE;
+    tearingSupported_ = SUCCEEDED(factory->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing,
+                                                               sizeof(allowTearing))) && allowTearing == TRUE;
+
+    // D3D12 only has the flip model, so latency control is always there
+    DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
+    swapChainDesc.Width = width;
+    swapChainDesc.Height = height;
+    swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swapChainDesc.SampleDesc.Count = 1;
+    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swapChainDesc.BufferCount = BACK_BUFFER_COUNT;
+    swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
+    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+    swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT |
+                          (tearingSupported_ ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0);
+
+    DXGI_SWAP_CHAIN_FULLSCREEN_DESC fullscreenDesc = {};
+    fullscreenDesc.RefreshRate.Numerator = 60;
+    fullscreenDesc.RefreshRate.Denominator = 1;
+    fullscreenDesc.Windowed = !fullscreen;
+
+    IDXGISwapChain1* swapChain = nullptr;
+    HRESULT hr = factory->CreateSwapChainForHwnd(queue_, hwnd, &swapChainDesc, &fullscreenDesc, nullptr, &swapChain);
+    factory->Release();
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create the D3D12 swap chain");
+        return false;
+    }
+    hr = swapChain->QueryInterface(IID_PPV_ARGS(&swapChain_));
+    swapChain->Release();
+    if (FAILED(hr)) {
+        Logger::Error("D3D12 swap chain lacks IDXGISwapChain3");
+        return false;
+    }
+    swapChainFlags_ = swapChainDesc.Flags;
+    return true;
+}
+
+bool D3D12Device::CreateBackBufferViews() {
+    for (UINT i = 0; i < BACK_BUFFER_COUNT; ++i) {
+        if (FAILED(swapChain_->GetBuffer(i, IID_PPV_ARGS(&backBuffers_[i])))) {
+            Logger::Error("Failed to get a D3D12 back buffer");
+            return false;
+        }
+        backBufferViews_[i] = CreateRenderTargetView(backBuffers_[i], nullptr);
+        if (backBufferViews_[i] == INVALID_DESCRIPTOR) return false;
+    }
+    return true;
+}
+
+void D3D12Device::ReleaseBackBuffers() {
+    for (UINT i = 0; i < BACK_BUFFER_COUNT; ++i) {
+        if (backBufferViews_[i] != INVALID_DESCRIPTOR) {
+            // The GPU is idle whenever back buffers go, so the view is free right away
+            std::lock_guard<std::mutex> lock(mutex_);
+            targetHeap_.free.push_back(backBufferViews_[i]);
+            backBufferViews_[i] = INVALID_DESCRIPTOR;
+        }
+        SafeRelease(backBuffers_[i]);
+    }
+}
+
+UINT D3D12Device::GetBackBufferIndex() const {
+    return swapChain_ ? swapChain_->GetCurrentBackBufferIndex() : 0;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12Device::GetBackBufferView(UINT index) const {
+    return GetCpuHandle(targetHeap_, backBufferViews_[index]);
+}
+
+bool D3D12Device::ResizeSwapChain(int width, int height) {
+    if (!swapChain_) return false;
+    WaitForIdle();
+    ReleaseBackBuffers();
+    if (FAILED(swapChain_->ResizeBuffers(BACK_BUFFER_COUNT, width, height, DXGI_FORMAT_UNKNOWN, swapChainFlags_))) {
+        Logger::Error("Failed to resize the D3D12 swap chain");
+        return false;
+    }
+    return CreateBackBufferViews();
+}
+
+bool D3D12Device::CreateDescriptorHeap(DescriptorHeap& heap, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT capacity,
+                                       bool shaderVisible) {
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.Type = type;
+    desc.NumDescriptors = capacity;
+    desc.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    if (FAILED(device_->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap.heap)))) {
+        return false;
+    }
+    heap.increment = device_->GetDescriptorHandleIncrementSize(type);
+    heap.capacity = capacity;
+    return true;
+}
+
+bool D3D12Device::CreateRootSignature() {
+    D3D12_ROOT_PARAMETER1 parameters[2] = {};
+    parameters[ROOT_PARAMETER_CONSTANTS].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    parameters[ROOT_PARAMETER_CONSTANTS].Constants.ShaderRegister = 0;
+    parameters[ROOT_PARAMETER_CONSTANTS].Constants.Num32BitValues = ROOT_CONSTANTS;
+    parameters[ROOT_PARAMETER_CONSTANT_BUFFER].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+    parameters[ROOT_PARAMETER_CONSTANT_BUFFER].Descriptor.ShaderRegister = 1;
+    parameters[ROOT_PARAMETER_CONSTANT_BUFFER].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+
+    D3D12_VERSIONED_ROOT_SIGNATURE_DESC desc = {};
+    desc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+    desc.Desc_1_1.NumParameters = 2;
+    desc.Desc_1_1.pParameters = parameters;
+    desc.Desc_1_1.Flags = D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED |
+                          D3D12_ROOT_SIGNATURE_FLAG_SAMPLER_HEAP_DIRECTLY_INDEXED;
+
+    ID3DBlob* serialized = nullptr;
+    ID3DBlob* errors = nullptr;
+    HRESULT hr = D3D12SerializeVersionedRootSignature(&desc, &serialized, &errors);
+    if (SUCCEEDED(hr)) {
+        hr = device_->CreateRootSignature(0, serialized->GetBufferPointer(), serialized->GetBufferSize(),
+                                          IID_PPV_ARGS(&rootSignature_));
+    }
+    SafeRelease(serialized);
+    SafeRelease(errors);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create the bindless root signature");
+        return false;
+    }
+    return true;
+}
+
+void D3D12Device::BeginFrame() {
+    NEXUS_PROFILE_SCOPE("D3D12Device::BeginFrame");
+    FrameSlot& slot = slots_[frame_ % FRAMES_IN_FLIGHT];
+    if (fence_->GetCompletedValue() < slot.fence) {
+        fence_->SetEventOnCompletion(slot.fence, fenceEvent_);
+        WaitForSingleObject(fenceEvent_, INFINITE);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int type = 0; type < 2; ++type) {
+        for (size_t i = 0; i < slot.used[type]; ++i) {
+            slot.lists[type][i].allocator->Reset();
+        }
+        slot.used[type] = 0;
+    }
+    const uint64_t completed = fence_->GetCompletedValue();
+    ReleaseRetired(completed, false);
+    RecycleDescriptors(resourceHeap_, completed, false);
+    RecycleDescriptors(samplerHeap_, completed, false);
+    RecycleDescriptors(targetHeap_, completed, false);
+    RecycleDescriptors(depthHeap_, completed, false);
+}
+
+HRESULT D3D12Device::Present(UINT syncInterval, UINT flags) {
+    // The frame fence below must also mean the frame's compute work is done
+    if (computeSubmitted_) {
+        Wait(QueueType::Graphics, QueueType::Compute, Signal(QueueType::Compute));
+        computeSubmitted_ = false;
+    }
+    HRESULT hr = swapChain_->Present(syncInterval, flags);
+    // Fenced even when presenting failed, so waits on the frame still end
+    queue_->Signal(fence_, frame_);
+    slots_[frame_ % FRAMES_IN_FLIGHT].fence = frame_;
+    ++frame_;
+    return hr;
+}
+
+void D3D12Device::WaitForIdle() {
+    // A fence of its own, so the frame fence never runs ahead of the frames it counts
+    ID3D12Fence* idle = nullptr;
+    if (FAILED(device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&idle)))) return;
+    // The graphics queue signals only after the compute queue has drained too
+    if (computeQueue_) {
+        computeQueue_->Signal(idle, 1);
+        queue_->Wait(idle, 1);
+    }
+    if (SUCCEEDED(queue_->Signal(idle, 2)) && idle->GetCompletedValue() < 2) {
+        idle->SetEventOnCompletion(2, fenceEvent_);
+        WaitForSingleObject(fenceEvent_, INFINITE);
+    }
+    idle->Release();
+}
+
+uint64_t D3D12Device::GetCompletedFrame() const {
+    return fence_ ? fence_->GetCompletedValue() : 0;
+}
+
+ID3D12GraphicsCommandList4* D3D12Device::BeginCommandList(QueueType queue) {
+    // Compute lists go to the graphics queue without a compute queue, so they are direct lists
+    const bool compute = queue == QueueType::Compute && computeQueue_;
+    const int type = compute ? 1 : 0;
+    const D3D12_COMMAND_LIST_TYPE listType = compute ? D3D12_COMMAND_LIST_TYPE_COMPUTE : D3D12_COMMAND_LIST_TYPE_DIRECT;
+    CommandList entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FrameSlot& slot = slots_[frame_ % FRAMES_IN_FLIGHT];
+        if (slot.used[type] == slot.lists[type].size()) {
+            CommandList created;
+            if (FAILED(device_->CreateCommandAllocator(listType, IID_PPV_ARGS(&created.allocator))) ||
+                FAILED(device_->CreateCommandList1(0, listType, D3D12_COMMAND_LIST_FLAG_NONE,
+                                                   IID_PPV_ARGS(&created.list)))) {
+                SafeRelease(created.allocator);
+                Logger::Error("Failed to create a D3D12 command list");
+                return nullptr;
+            }
+            slot.lists[type].push_back(created);
+        }
+        entry = slot.lists[type][slot.used[type]++];
+    }
+
+    // The allocator was reset in BeginFrame and belongs to this list alone
+    ID3D12GraphicsCommandList4* list = entry.list;
+    list->Reset(entry.allocator, nullptr);
+    ID3D12DescriptorHeap* heaps[] = { resourceHeap_.heap, samplerHeap_.heap };
+    list->SetDescriptorHeaps(2, heaps);
+    if (!compute) {
+        list->SetGraphicsRootSignature(rootSignature_);
+    }
+    list->SetComputeRootSignature(rootSignature_);
+    return list;
+}
+
+void D3D12Device::Submit(ID3D12GraphicsCommandList4* const* lists, UINT count, QueueType queue) {
+    std::vector<ID3D12CommandList*> executed;
+    executed.reserve(count);
+    for (UINT i = 0; i < count; ++i) {
+        if (!lists[i]) continue;
+        lists[i]->Close();
+        executed.push_back(lists[i]);
+    }
+    if (executed.empty()) return;
+    if (queue == QueueType::Compute && computeQueue_) {
+        computeQueue_->ExecuteCommandLists(static_cast<UINT>(executed.size()), executed.data());
+        computeSubmitted_ = true;
+    } else {
+        queue_->ExecuteCommandLists(static_cast<UINT>(executed.size()), executed.data());
+    }
+}
+
+uint64_t D3D12Device::Signal(QueueType queue) {
+    const int type = queue == QueueType::Compute && computeQueue_ ? 1 : 0;
+    const uint64_t value = ++syncValues_[type];
+    (type == 1 ? computeQueue_ : queue_)->Signal(syncFences_[type], value);
+    return value;
+}
+
+void D3D12Device::Wait(QueueType queue, QueueType producer, uint64_t value) {
+    const int waiting = queue == QueueType::Compute && computeQueue_ ? 1 : 0;
+    const int signaling = producer == QueueType::Compute && computeQueue_ ? 1 : 0;
+    // One queue is ordered already
+    if (waiting == signaling) return;
+    (waiting == 1 ? computeQueue_ : queue_)->Wait(syncFences_[signaling], value);
+}
+
+void D3D12Device::RecordParallel(JobSystem* jobs, UINT count,
+                                 const std::function<void(ID3D12GraphicsCommandList4*, UINT)>& record) {
+    if (count == 0) return;
+    NEXUS_PROFILE_SCOPE("D3D12Device::RecordParallel");
+    std::vector<ID3D12GraphicsCommandList4*> lists(count);
+    for (UINT i = 0; i < count; ++i) {
+        lists[i] = BeginCommandList();
+    }
+    auto recordRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (lists[i]) record(lists[i], static_cast<UINT>(i));
+        }
+    };
+    if (jobs && jobs->IsInitialized() && count > 1) {
+        jobs->ParallelFor(count, 1, recordRange);
+    } else {
+        recordRange(0, count);
+    }
+    Submit(lists.data(), count);
+}
+
+D3D12Device::DescriptorIndex D3D12Device::AllocateDescriptor(DescriptorHeap& heap) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!heap.free.empty()) {
+        DescriptorIndex index = heap.free.back();
+        heap.free.pop_back();
+        return index;
+    }
+    if (heap.next < heap.capacity) {
+        return heap.next++;
+    }
+    Logger::Error("D3D12 descriptor heap is full");
+    return INVALID_DESCRIPTOR;
+}
+
+void D3D12Device::FreeDescriptor(DescriptorHeap& heap, DescriptorIndex index) {
+    if (index == INVALID_DESCRIPTOR) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap.retired.emplace_back(frame_, index);
+}
+
+void D3D12Device::RecycleDescriptors(DescriptorHeap& heap, uint64_t completed, bool all) {
+    auto expired = std::remove_if(heap.retired.begin(), heap.retired.end(),
+                                  [&](const std::pair<uint64_t, DescriptorIndex>& entry) {
+        if (!all && entry.first > completed) return false;
+        heap.free.push_back(entry.second);
+        return true;
+    });
+    heap.retired.erase(expired, heap.retired.end());
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12Device::GetCpuHandle(const DescriptorHeap& heap, DescriptorIndex index) const {
+    D3D12_CPU_DESCRIPTOR_HANDLE handle = heap.heap->GetCPUDescriptorHandleForHeapStart();
+    handle.ptr += static_cast<SIZE_T>(index) * heap.increment;
+    return handle;
+}
+
+D3D12Device::DescriptorIndex D3D12Device::CreateShaderResourceView(ID3D12Resource* resource,
+                                                                   const D3D12_SHADER_RESOURCE_VIEW_DESC* desc) {
+    DescriptorIndex index = AllocateDescriptor(resourceHeap_);
+    if (index != INVALID_DESCRIPTOR) {
+        device_->CreateShaderResourceView(resource, desc, GetCpuHandle(resourceHeap_, index));
+    }
+    return index;
+}
+
+D3D12Device::DescriptorIndex D3D12Device::CreateUnorderedAccessView(ID3D12Resource* resource,
+                                                                    const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc) {
+    DescriptorIndex index = AllocateDescriptor(resourceHeap_);
+    if (index != INVALID_DESCRIPTOR) {
+        device_->CreateUnorderedAccessView(resource, nullptr, desc, GetCpuHandle(resourceHeap_, index));
+    }
+    return index;
+}
+
+D3D12Device::DescriptorIndex D3D12Device::CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc) {
+    DescriptorIndex index = AllocateDescriptor(resourceHeap_);
+    if (index != INVALID_DESCRIPTOR) {
+        device_->CreateConstantBufferView(&desc, GetCpuHandle(resourceHeap_, index));
+    }
+    return index;
+}
+
+D3D12Device::DescriptorIndex D3D12Device::CreateSampler(const D3D12_SAMPLER_DESC& desc) {
+    DescriptorIndex index = AllocateDescriptor(samplerHeap_);
+    if (index != INVALID_DESCRIPTOR) {
+        device_->CreateSampler(&desc, GetCpuHandle(samplerHeap_, index));
+    }
+    return index;
+}
+
+void D3D12Device::FreeDescriptor(DescriptorIndex index) {
+    FreeDescriptor(resourceHeap_, index);
+}
+
+void D3D12Device::FreeSampler(DescriptorIndex index) {
+    FreeDescriptor(samplerHeap_, index);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE D3D12Device::GetGpuDescriptor(DescriptorIndex index) const {
+    D3D12_GPU_DESCRIPTOR_HANDLE handle = resourceHeap_.heap->GetGPUDescriptorHandleForHeapStart();
+    handle.ptr += static_cast<UINT64>(index) * resourceHeap_.increment;
+    return handle;
+}
+
+D3D12Device::DescriptorIndex D3D12Device::CreateRenderTargetView(ID3D12Resource* resource,
+                                                                 const D3D12_RENDER_TARGET_VIEW_DESC* desc) {
+    DescriptorIndex index = AllocateDescriptor(targetHeap_);
+    if (index != INVALID_DESCRIPTOR) {
+        device_->CreateRenderTargetView(resource, desc, GetCpuHandle(targetHeap_, index));
+    }
+    return index;
+}
+
+D3D12Device::DescriptorIndex D3D12Device::CreateDepthStencilView(ID3D12Resource* resource,
+                                                                 const D3D12_DEPTH_STENCIL_VIEW_DESC* desc) {
+    DescriptorIndex index = AllocateDescriptor(depthHeap_);
+    if (index != INVALID_DESCRIPTOR) {
+        device_->CreateDepthStencilView(resource, desc, GetCpuHandle(depthHeap_, index));
+    }
+    return index;
+}
+
+void D3D12Device::FreeRenderTargetView(DescriptorIndex index) {
+    FreeDescriptor(targetHeap_, index);
+}
+
+void D3D12Device::FreeDepthStencilView(DescriptorIndex index) {
+    FreeDescriptor(depthHeap_, index);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12Device::GetRenderTargetHandle(DescriptorIndex index) const {
+    return GetCpuHandle(targetHeap_, index);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12Device::GetDepthStencilHandle(DescriptorIndex index) const {
+    return GetCpuHandle(depthHeap_, index);
+}
+
+ID3D12Resource* D3D12Device::CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+                                            const D3D12_CLEAR_VALUE* clearValue, D3D12_HEAP_TYPE heapType) {
+    const D3D12_RESOURCE_ALLOCATION_INFO info = device_->GetResourceAllocationInfo(0, 1, &desc);
+    if (info.SizeInBytes == UINT64_MAX) {
+        Logger::Error("Invalid D3D12 resource description");
+        return nullptr;
+    }
+
+    HeapClass heapClass = HeapClass::Textures;
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+        heapClass = HeapClass::Buffers;
+    } else if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) {
+        heapClass = HeapClass::TargetTextures;
+    }
+
+    ID3D12Resource* resource = nullptr;
+    Placement placement;
+    if (info.SizeInBytes < DEDICATED_THRESHOLD && Place(info, heapType, heapClass, placement)) {
+        ID3D12Heap* heap = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            heap = blocks_[placement.block].heap;
+        }
+        if (FAILED(device_->CreatePlacedResource(heap, placement.offset, &desc, initialState, clearValue,
+                                                 IID_PPV_ARGS(&resource)))) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Unplace(placement);
+            Logger::Error("Failed to create a placed D3D12 resource");
+            return nullptr;
+        }
+    } else {
+        D3D12_HEAP_PROPERTIES heapProperties = {};
+        heapProperties.Type = heapType;
+        if (FAILED(device_->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, initialState,
+                                                    clearValue, IID_PPV_ARGS(&resource)))) {
+            Logger::Error("Failed to create a committed D3D12 resource");
+            return nullptr;
+        }
+        placement = Placement();
+        placement.size = info.SizeInBytes;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    placements_[resource] = placement;
+    if (placement.block == UINT32_MAX) committedBytes_ += placement.size;
+    return resource;
+}
+
+bool D3D12Device::Place(const D3D12_RESOURCE_ALLOCATION_INFO& info, D3D12_HEAP_TYPE type, HeapClass heapClass,
+                        Placement& placement) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // First fit over the heaps already holding this kind of resource
+    for (uint32_t b = 0; b < blocks_.size(); ++b) {
+        HeapBlock& block = blocks_[b];
+        if (!block.heap || block.type != type || block.heapClass != heapClass) continue;
+        for (auto it = block.free.begin(); it != block.free.end(); ++it) {
+            const UINT64 start = it->first;
+            const UINT64 length = it->second;
+            const UINT64 offset = AlignUp(start, info.Alignment);
+            if (offset + info.SizeInBytes > start + length) continue;
+
+            // Keep the slack on either side of the allocation free
+            block.free.erase(it);
+            if (offset > start) block.free[start] = offset - start;
+            if (offset + info.SizeInBytes < start + length) {
+                block.free[offset + info.SizeInBytes] = start + length - offset - info.SizeInBytes;
+            }
+            block.used += info.SizeInBytes;
+            placement.block = b;
+            placement.offset = offset;
+            placement.size = info.SizeInBytes;
+            return true;
+        }
+    }
+
+    static const D3D12_HEAP_FLAGS HEAP_FLAGS[] = {
+        D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+    };
+    D3D12_HEAP_DESC heapDesc = {};
+    heapDesc.SizeInBytes = HEAP_BLOCK_SIZE;
+    heapDesc.Properties.Type = type;
+    // MSAA textures need 4 MB alignment; everything else fits in 64 KB
+    heapDesc.Alignment = info.Alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT
+                             ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT
+                             : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    heapDesc.Flags = HEAP_FLAGS[static_cast<int>(heapClass)];
+    HeapBlock block;
+    block.type = type;
+    block.heapClass = heapClass;
+    if (FAILED(device_->CreateHeap(&heapDesc, IID_PPV_ARGS(&block.heap)))) {
+        Logger::Warning("Failed to create a D3D12 heap, falling back to a committed resource");
+        return false;
+    }
+    block.used = info.SizeInBytes;
+    block.free[info.SizeInBytes] = HEAP_BLOCK_SIZE - info.SizeInBytes;
+
+    // Reuse the slot of a heap that emptied and was released
+    uint32_t index = static_cast<uint32_t>(blocks_.size());
+    for (uint32_t b = 0; b < blocks_.size(); ++b) {
+        if (!blocks_[b].heap) { index = b; break; }
+    }
+    if (index == blocks_.size()) blocks_.push_back(std::move(block));
+    else blocks_[index] = std::move(block);
+    placement.block = index;
+    placement.offset = 0;
+    placement.size = info.SizeInBytes;
+    return true;
+}
+
+void D3D12Device::Unplace(const Placement& placement) {
+    // Callers hold mutex_
+    if (placement.block >= blocks_.size()) return;
+    HeapBlock& block = blocks_[placement.block];
+    UINT64 offset = placement.offset;
+    UINT64 size = placement.size;
+
+    // Merge with the free ranges on either side
+    auto next = block.free.lower_bound(offset);
+    if (next != block.free.end() && next->first == offset + size) {
+        size += next->second;
+        next = block.free.erase(next);
+    }
+    if (next != block.free.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            block.free.erase(previous);
+        }
+    }
+    block.free[offset] = size;
+    block.used -= placement.size;
+
+    // An empty heap goes back to the OS; the next allocation creates another if needed
+    if (block.used == 0) {
+        SafeRelease(block.heap);
+        block.free.clear();
+    }
+}
+
+void D3D12Device::ReleaseResource(ID3D12Resource* resource) {
+    if (!resource) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_.emplace_back(frame_, resource);
+}
+
+void D3D12Device::ReleaseRetired(uint64_t completed, bool all) {
+    // Callers hold mutex_ or have the device to themselves
+    auto expired = std::remove_if(retired_.begin(), retired_.end(), [&](const std::pair<uint64_t, ID3D12Resource*>& entry) {
+        if (!all && entry.first > completed) return false;
+        auto placement = placements_.find(entry.second);
+        if (placement != placements_.end()) {
+            if (placement->second.block == UINT32_MAX) committedBytes_ -= placement->second.size;
+            else Unplace(placement->second);
+            placements_.erase(placement);
+        }
+        entry.second->Release();
+        return true;
+    });
+    retired_.erase(expired, retired_.end());
+}
+
+D3D12Device::MemoryStats D3D12Device::GetMemoryStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MemoryStats stats;
+    for (const HeapBlock& block : blocks_) {
+        if (!block.heap) continue;
+        stats.heaps++;
+        stats.heapBytes += HEAP_BLOCK_SIZE;
+        stats.placedBytes += block.used;
+    }
+    for (const auto& placement : placements_) {
+        if (placement.second.block == UINT32_MAX) stats.committedResources++;
+        else stats.placedResources++;
+    }
+    stats.committedBytes = committedBytes_;
+    return stats;
+}
+
+} // namespace Nexus
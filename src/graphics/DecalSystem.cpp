@@ -0,0 +1,306 @@
+#include "DecalSystem.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "StateCache.h"
+#include "Texture.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+
+constexpr UINT DEFAULT_DECALS_PER_CLUSTER = 64;
+constexpr UINT MAX_DECALS_PER_CLUSTER = 1024;
+constexpr UINT INITIAL_INDEX_CAPACITY = 16384;
+constexpr float MIN_HALF_EXTENT = 1e-3f;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+void WriteBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const void* data, size_t size) {
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (SUCCEEDED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        if (size > 0) std::memcpy(mapped.pData, data, size);
+        context->Unmap(buffer, 0);
+    }
+}
+
+HRESULT CreateDynamicBuffer(ID3D11Device* device, UINT byteWidth, UINT structureStride, DXGI_FORMAT format,
+                            UINT elements, ID3D11Buffer** buffer, ID3D11ShaderResourceView** view) {
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = byteWidth;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    desc.MiscFlags = structureStride ? D3D11_RESOURCE_MISC_BUFFER_STRUCTURED : 0;
+    desc.StructureByteStride = structureStride;
+    HRESULT hr = device->CreateBuffer(&desc, nullptr, buffer);
+    if (FAILED(hr)) return hr;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = format;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    viewDesc.Buffer.FirstElement = 0;
+    viewDesc.Buffer.NumElements = elements;
+    hr = device->CreateShaderResourceView(*buffer, &viewDesc, view);
+    if (FAILED(hr)) SafeRelease(*buffer);
+    return hr;
+}
+
+} // namespace
+
+DecalSystem::DecalSystem()
+    : device_(nullptr)
+    , context_(nullptr)
+    , decalBuffer_(nullptr)
+    , decalView_(nullptr)
+    , rangeBuffer_(nullptr)
+    , rangeView_(nullptr)
+    , indexBuffer_(nullptr)
+    , indexView_(nullptr)
+    , indexCapacity_(0)
+    , textures_(nullptr)
+    , texturesView_(nullptr)
+    , layerCount_(0)
+    , nextId_(1)
+    , maxDecalsPerCluster_(DEFAULT_DECALS_PER_CLUSTER)
+{
+}
+
+DecalSystem::~DecalSystem() {
+    Shutdown();
+}
+
+bool DecalSystem::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    if (!device || !context) return false;
+    device_ = device;
+    context_ = context;
+
+    static_assert(sizeof(GpuDecal) % 16 == 0, "Decals are read as whole float4 rows");
+    if (FAILED(CreateDynamicBuffer(device_, MAX_DECALS * sizeof(GpuDecal), sizeof(GpuDecal), DXGI_FORMAT_UNKNOWN,
+                                   MAX_DECALS, &decalBuffer_, &decalView_)) ||
+        FAILED(CreateDynamicBuffer(device_, ClusteredLightCuller::CLUSTER_COUNT * 2 * sizeof(uint32_t), 0,
+                                   DXGI_FORMAT_R32G32_UINT, ClusteredLightCuller::CLUSTER_COUNT,
+                                   &rangeBuffer_, &rangeView_)) ||
+        !EnsureIndexCapacity(INITIAL_INDEX_CAPACITY)) {
+        Logger::Error("Failed to create clustered decal buffers");
+        Shutdown();
+        return false;
+    }
+
+    decals_.reserve(MAX_DECALS);
+    Logger::Info("Clustered decals initialized (" + std::to_string(MAX_DECALS) + " decals)");
+    return true;
+}
+
+void DecalSystem::Shutdown() {
+    SafeRelease(texturesView_);
+    SafeRelease(textures_);
+    layerCount_ = 0;
+    SafeRelease(indexView_);
+    SafeRelease(indexBuffer_);
+    indexCapacity_ = 0;
+    SafeRelease(rangeView_);
+    SafeRelease(rangeBuffer_);
+    SafeRelease(decalView_);
+    SafeRelease(decalBuffer_);
+    decals_.clear();
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+int DecalSystem::AddLayer(const Texture& texture) {
+    ID3D11Texture2D* source = texture.GetTexture();
+    if (!device_ || !source) return -1;
+    if (layerCount_ == MAX_LAYERS) {
+        Logger::Warning("Decal texture array is full (" + std::to_string(MAX_LAYERS) + " layers)");
+        return -1;
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    source->GetDesc(&desc);
+    if (!textures_) {
+        // The first layer decides what the whole array holds
+        D3D11_TEXTURE2D_DESC arrayDesc = {};
+        arrayDesc.Width = desc.Width;
+        arrayDesc.Height = desc.Height;
+        arrayDesc.MipLevels = desc.MipLevels;
+        arrayDesc.ArraySize = MAX_LAYERS;
+        arrayDesc.Format = desc.Format;
+        arrayDesc.SampleDesc.Count = 1;
+        arrayDesc.Usage = D3D11_USAGE_DEFAULT;
+        arrayDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+        viewDesc.Format = desc.Format;
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        viewDesc.Texture2DArray.MipLevels = desc.MipLevels;
+        viewDesc.Texture2DArray.ArraySize = MAX_LAYERS;
+        if (FAILED(device_->CreateTexture2D(&arrayDesc, nullptr, &textures_)) ||
+            FAILED(device_->CreateShaderResourceView(textures_, &viewDesc, &texturesView_))) {
+            Logger::Error("Failed to create decal texture array");
+            SafeRelease(textures_);
+            return -1;
+        }
+    }
+
+    D3D11_TEXTURE2D_DESC arrayDesc = {};
+    textures_->GetDesc(&arrayDesc);
+    if (desc.Width != arrayDesc.Width || desc.Height != arrayDesc.Height || desc.MipLevels != arrayDesc.MipLevels ||
+        desc.Format != arrayDesc.Format || desc.SampleDesc.Count != 1) {
+        Logger::Warning("Decal texture does not match the first layer (" + std::to_string(arrayDesc.Width) + "x" +
+                        std::to_string(arrayDesc.Height) + ", " + std::to_string(arrayDesc.MipLevels) + " mips)");
+        return -1;
+    }
+
+    const UINT layer = layerCount_++;
+    for (UINT mip = 0; mip < desc.MipLevels; ++mip) {
+        context_->CopySubresourceRegion(textures_, D3D11CalcSubresource(mip, layer, desc.MipLevels), 0, 0, 0,
+                                        source, mip, nullptr);
+    }
+    return static_cast<int>(layer);
+}
+
+DecalSystem::DecalId DecalSystem::AddDecal(const Decal& decal) {
+    if (decals_.size() >= MAX_DECALS) {
+        // Make room by dropping the transient decal with the least time left
+        auto oldest = decals_.end();
+        float oldestRemaining = 0.0f;
+        for (auto it = decals_.begin(); it != decals_.end(); ++it) {
+            if (it->decal.lifetime <= 0.0f) continue;
+            const float remaining = it->decal.lifetime - it->age;
+            if (oldest == decals_.end() || remaining < oldestRemaining) {
+                oldest = it;
+                oldestRemaining = remaining;
+            }
+        }
+        if (oldest == decals_.end()) {
+            static bool warned = false;
+            if (!warned) {
+                Logger::Warning("Decals are limited to " + std::to_string(MAX_DECALS) + " permanent decals, ignoring the rest");
+                warned = true;
+            }
+            return INVALID_DECAL;
+        }
+        decals_.erase(oldest);
+        ++stats_.recycled;
+    }
+
+    Entry entry;
+    entry.id = nextId_++;
+    entry.decal = decal;
+    entry.age = 0.0f;
+    decals_.push_back(entry);
+    return entry.id;
+}
+
+void DecalSystem::RemoveDecal(DecalId id) {
+    auto it = std::lower_bound(decals_.begin(), decals_.end(), id,
+                               [](const Entry& entry, DecalId value) { return entry.id < value; });
+    if (it != decals_.end() && it->id == id) decals_.erase(it);
+}
+
+void DecalSystem::ClearDecals() {
+    decals_.clear();
+}
+
+void DecalSystem::SetMaxDecalsPerCluster(UINT maxDecals) {
+    maxDecalsPerCluster_ = std::clamp<UINT>(maxDecals, 1, MAX_DECALS_PER_CLUSTER);
+}
+
+void DecalSystem::Update(float deltaTime) {
+    for (Entry& entry : decals_) entry.age += deltaTime;
+    decals_.erase(std::remove_if(decals_.begin(), decals_.end(), [](const Entry& entry) {
+        return entry.decal.lifetime > 0.0f && entry.age >= entry.decal.lifetime;
+    }), decals_.end());
+}
+
+bool DecalSystem::EnsureIndexCapacity(UINT indexCount) {
+    if (indexBuffer_ && indexCount <= indexCapacity_) return true;
+
+    // The buffer is rewritten every frame, so it can be replaced at any time
+    const UINT capacity = std::max(indexCount, indexCapacity_ * 2);
+    SafeRelease(indexView_);
+    SafeRelease(indexBuffer_);
+    indexCapacity_ = 0;
+    if (FAILED(CreateDynamicBuffer(device_, capacity * sizeof(uint16_t), 0, DXGI_FORMAT_R16_UINT, capacity,
+                                   &indexBuffer_, &indexView_))) {
+        Logger::Error("Failed to create clustered decal index buffer");
+        return false;
+    }
+    indexCapacity_ = capacity;
+    return true;
+}
+
+void DecalSystem::Build(const ClusteredLightCuller& lights, DirectX::FXMMATRIX view, JobSystem* jobs) {
+    using namespace DirectX;
+    NEXUS_PROFILE_SCOPE("DecalSystem::Build");
+    const uint32_t recycled = stats_.recycled;
+    stats_ = Stats();
+    stats_.recycled = recycled;
+    if (!decalBuffer_) return;
+
+    gpuDecals_.clear();
+    spheres_.clear();
+    for (const Entry& entry : decals_) {
+        const Decal& decal = entry.decal;
+        float opacity = decal.color.w;
+        if (decal.lifetime > 0.0f && decal.fadeTime > 0.0f) {
+            opacity *= std::clamp((decal.lifetime - entry.age) / decal.fadeTime, 0.0f, 1.0f);
+        }
+        if (decal.layer >= layerCount_ || opacity <= 0.0f) continue;
+
+        const XMVECTOR halfExtents = XMVectorMax(XMLoadFloat3(&decal.halfExtents), XMVectorReplicate(MIN_HALF_EXTENT));
+        const XMVECTOR rotation = XMQuaternionNormalize(XMLoadFloat4(&decal.rotation));
+        const XMVECTOR position = XMLoadFloat3(&decal.position);
+        const XMMATRIX decalToWorld = XMMatrixScalingFromVector(halfExtents) * XMMatrixRotationQuaternion(rotation) *
+                                      XMMatrixTranslationFromVector(position);
+        // Shaders dot each row with the world position, so the inverse goes in transposed
+        const XMMATRIX worldToDecal = XMMatrixTranspose(XMMatrixInverse(nullptr, decalToWorld));
+
+        GpuDecal gpu = {};
+        for (int row = 0; row < 3; ++row) XMStoreFloat4(&gpu.worldToDecal[row], worldToDecal.r[row]);
+        XMStoreFloat3(&gpu.axis, XMVector3Rotate(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), rotation));
+        gpu.layer = static_cast<float>(decal.layer);
+        gpu.uvRect = decal.uvRect;
+        gpu.color = XMFLOAT4(decal.color.x, decal.color.y, decal.color.z, opacity);
+        gpu.roughness = decal.roughness;
+        gpuDecals_.push_back(gpu);
+
+        XMFLOAT4 sphere;
+        XMStoreFloat4(&sphere, XMVector3TransformCoord(position, view));
+        sphere.w = XMVectorGetX(XMVector3Length(halfExtents));
+        spheres_.push_back(sphere);
+    }
+    stats_.decals = static_cast<uint32_t>(spheres_.size());
+
+    lights.BinSpheres(spheres_, 0, maxDecalsPerCluster_, lists_, jobs);
+    stats_.indices = static_cast<uint32_t>(lists_.indices.size());
+    stats_.maxClusterDecals = lists_.maxCount;
+    stats_.droppedReferences = lists_.dropped;
+    Upload();
+}
+
+void DecalSystem::Upload() {
+    if (!EnsureIndexCapacity(static_cast<UINT>(lists_.indices.size()))) {
+        // Without room for the lists, no cluster may reference any
+        lists_.indices.clear();
+        std::fill(lists_.ranges.begin(), lists_.ranges.end(), 0u);
+        if (!indexBuffer_) return;
+    }
+    WriteBuffer(context_, decalBuffer_, gpuDecals_.data(), gpuDecals_.size() * sizeof(GpuDecal));
+    WriteBuffer(context_, rangeBuffer_, lists_.ranges.data(), lists_.ranges.size() * sizeof(uint32_t));
+    WriteBuffer(context_, indexBuffer_, lists_.indices.data(), lists_.indices.size() * sizeof(uint16_t));
+}
+
+void DecalSystem::Bind(StateCache& stateCache) const {
+    if (!decalView_ || !indexView_) return;
+    ID3D11ShaderResourceView* views[] = { decalView_, rangeView_, indexView_, texturesView_ };
+    stateCache.PSSetShaderResources(DECAL_SLOT, 4, views);
+}
+
+} // namespace Nexus
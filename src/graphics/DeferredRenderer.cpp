@@ -0,0 +1,470 @@
+#include "DeferredRenderer.h"
+#include "ClusteredLightCuller.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ProbeVolume.h"
+#include "ShaderCache.h"
+#include "ShadingRateImage.h"
+#include "StateCache.h"
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// Position reconstruction assumes a symmetric perspective projection, as SSAORenderer does.
+// The lights and their constants come from ClusteredLightCuller::BindCompute(), the irradiance
+// probes from ProbeVolume::BindCompute() with its shader source in front of this one
+const char* LIGHTING_SHADER = R"(
+    #define TILE_SIZE 16
+    #define MAX_TILE_LIGHTS 256
+    #define EMISSIVE_RANGE 16.0f
+    #define PI 3.14159265359f
+    #define EPSILON 1e-6f
+
+    cbuffer DeferredConstants : register(b0)
+    {
+        float4x4 InverseView;          // Row 3 is the camera position
+        float2 ProjectionScale;        // _11 and _22 of the projection
+        float DepthScale;              // _43
+        float DepthOffset;             // _33
+        uint2 ScreenSize;
+        float Gamma;
+        uint HasOcclusion;
+        float3 AmbientLight;
+        uint HasShadingRate;
+        uint HasReflections;
+        float3 Padding;
+    };
+
+    struct ClusterLight
+    {
+        float3 Position;
+        float Range;
+        float3 Color;
+        float SpotScale;
+        float3 Direction;
+        float SpotOffset;
+    };
+
+    cbuffer ClusterBuffer : register(b2)
+    {
+        float4x4 ClusterView;
+        float2 ClusterTileScale;
+        float ClusterSliceScale;
+        float ClusterSliceBias;
+        uint DirectionalLightCount;
+        uint LightCount;
+    };
+
+    Texture2D<float4> AlbedoTarget : register(t0);
+    Texture2D<float2> NormalTarget : register(t1);
+    Texture2D<float4> MaterialTarget : register(t2);
+    Texture2D<float> Depth : register(t3);
+    Texture2D<float> Occlusion : register(t4);
+    Texture2D<uint> ShadingRate : register(t5);
+    Texture2D<float4> Reflections : register(t6);
+    StructuredBuffer<ClusterLight> ClusterLights : register(t10);
+    RWTexture2D<float4> Destination : register(u0);
+
+    groupshared uint TileMinDepth;
+    groupshared uint TileMaxDepth;
+    groupshared uint TileLightCount;
+    groupshared uint TileLights[MAX_TILE_LIGHTS];
+    groupshared float3 BlockLighting[TILE_SIZE * TILE_SIZE];
+
+    float3 DecodeNormal(float2 encoded)
+    {
+        float3 n = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+        float t = saturate(-n.z);
+        n.xy += n.xy >= 0.0f ? -t : t;
+        return normalize(n);
+    }
+
+    // Cook-Torrance as in PBR_PS.hlsl
+    float3 ShadeLight(float3 N, float3 V, float3 L, float3 radiance, float3 albedo, float3 F0, float metallic, float roughness)
+    {
+        float3 H = normalize(V + L);
+        float a = roughness * roughness;
+        float a2 = a * a;
+        float NdotH = max(dot(N, H), 0.0f);
+        float denom = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+        float NDF = a2 / (PI * denom * denom);
+
+        float k = (roughness + 1.0f) * (roughness + 1.0f) / 8.0f;
+        float NdotV = max(dot(N, V), 0.0f);
+        float NdotL = max(dot(N, L), 0.0f);
+        float G = NdotV / (NdotV * (1.0f - k) + k) * NdotL / (NdotL * (1.0f - k) + k);
+        float3 F = F0 + (1.0f - F0) * pow(saturate(1.0f - max(dot(H, V), 0.0f)), 5.0f);
+
+        float3 kD = (1.0f - F) * (1.0f - metallic);
+        float3 specular = NDF * G * F / (4.0f * NdotV * NdotL + EPSILON);
+        return (kD * albedo / PI + specular) * radiance * NdotL;
+    }
+
+    // Split-sum environment BRDF, Karis' analytic fit, for reflected light arriving along R
+    float3 EnvironmentBRDF(float3 F0, float roughness, float NdotV)
+    {
+        const float4 c0 = float4(-1.0f, -0.0275f, -0.572f, 0.022f);
+        const float4 c1 = float4(1.0f, 0.0425f, 1.04f, -0.04f);
+        float4 r = roughness * c0 + c1;
+        float a004 = min(r.x * r.x, exp2(-9.28f * NdotV)) * r.x + r.y;
+        float2 AB = float2(-1.04f, 1.04f) * a004 + r.zw;
+        return F0 * AB.x + AB.y;
+    }
+
+    float3 LightRadiance(ClusterLight light, float3 worldPos, out float3 L)
+    {
+        float3 toLight = light.Position - worldPos;
+        float distanceSq = max(dot(toLight, toLight), 1e-4f);
+        L = toLight * rsqrt(distanceSq);
+
+        float window = saturate(1.0f - pow(distanceSq / (light.Range * light.Range), 2.0f));
+        float attenuation = window * window / max(distanceSq, 0.01f);
+        attenuation *= saturate(dot(-L, light.Direction) * light.SpotScale + light.SpotOffset);
+        return light.Color * attenuation;
+    }
+
+    // The directional lights and the tile's list
+    float3 DirectLighting(float3 worldPos, float3 N, float3 V, float3 albedo, float3 F0, float metallic, float roughness)
+    {
+        float3 Lo = float3(0.0f, 0.0f, 0.0f);
+        for (uint d = 0; d < DirectionalLightCount; ++d) {
+            ClusterLight light = ClusterLights[d];
+            Lo += ShadeLight(N, V, -light.Direction, light.Color, albedo, F0, metallic, roughness);
+        }
+        uint tileLights = min(TileLightCount, MAX_TILE_LIGHTS);
+        for (uint l = 0; l < tileLights; ++l) {
+            ClusterLight light = ClusterLights[TileLights[l]];
+            float3 L;
+            float3 radiance = LightRadiance(light, worldPos, L);
+            Lo += ShadeLight(N, V, L, radiance, albedo, F0, metallic, roughness);
+        }
+        return Lo;
+    }
+
+    [numthreads(TILE_SIZE, TILE_SIZE, 1)]
+    void main(uint3 id : SV_DispatchThreadID, uint3 group : SV_GroupID, uint3 thread : SV_GroupThreadID,
+              uint index : SV_GroupIndex)
+    {
+        if (index == 0) {
+            TileMinDepth = 0x7f7fffff;
+            TileMaxDepth = 0;
+            TileLightCount = 0;
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        // The pixel's G-buffer is read here, once, and kept in registers for every light
+        uint2 pixel = min(id.xy, ScreenSize - 1);
+        float depth = Depth[pixel];
+        bool covered = all(id.xy < ScreenSize) && depth < 1.0f;
+        float viewZ = DepthScale / (depth - DepthOffset);
+        float4 albedoAO = AlbedoTarget[pixel];
+        float2 encodedNormal = NormalTarget[pixel];
+        float4 material = MaterialTarget[pixel];
+
+        // View depth is positive, so its bits order like the floats
+        if (covered) {
+            InterlockedMin(TileMinDepth, asuint(viewZ));
+            InterlockedMax(TileMaxDepth, asuint(viewZ));
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        // Cull point and spot lights against the tile's view-space frustum, one light per thread
+        if (TileMaxDepth > 0) {
+            float minZ = asfloat(TileMinDepth);
+            float maxZ = asfloat(TileMaxDepth);
+            float2 tileMin = float2(group.xy * TILE_SIZE) / float2(ScreenSize) * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+            float2 tileMax = float2(group.xy * TILE_SIZE + TILE_SIZE) / float2(ScreenSize) * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+            float left = tileMin.x / ProjectionScale.x;
+            float right = tileMax.x / ProjectionScale.x;
+            float top = tileMin.y / ProjectionScale.y;
+            float bottom = tileMax.y / ProjectionScale.y;
+            float3 planes[4] = {
+                normalize(float3(1.0f, 0.0f, -left)),
+                normalize(float3(-1.0f, 0.0f, right)),
+                normalize(float3(0.0f, 1.0f, -bottom)),
+                normalize(float3(0.0f, -1.0f, top))
+            };
+
+            for (uint i = DirectionalLightCount + index; i < LightCount; i += TILE_SIZE * TILE_SIZE) {
+                ClusterLight light = ClusterLights[i];
+                float3 center = mul(float4(light.Position, 1.0f), ClusterView).xyz;
+                float radius = light.Range;
+                bool visible = center.z + radius >= minZ && center.z - radius <= maxZ;
+                [unroll] for (uint p = 0; p < 4; ++p) {
+                    visible = visible && dot(planes[p], center) >= -radius;
+                }
+                if (visible) {
+                    uint slot;
+                    InterlockedAdd(TileLightCount, 1, slot);
+                    if (slot < MAX_TILE_LIGHTS) TileLights[slot] = i;
+                }
+            }
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        // Coarse tiles of the shading-rate image light the top-left pixel of each block and share
+        // it; ambient, occlusion and emission stay per pixel
+        uint2 block = uint2(1, 1);
+        if (HasShadingRate) {
+            uint rate = ShadingRate[group.xy];
+            block = uint2(1u << (rate >> 2), 1u << (rate & 3));
+        }
+        uint2 anchor = thread.xy & ~(block - 1);
+        bool shades = all(thread.xy == anchor);
+
+        float2 ndc = (float2(pixel) + 0.5f) / float2(ScreenSize) * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+        float3 worldPos = mul(float4(ndc / ProjectionScale * viewZ, viewZ, 1.0f), InverseView).xyz;
+        float3 V = normalize(InverseView[3].xyz - worldPos);
+        float3 N = DecodeNormal(encodedNormal);
+        float3 albedo = albedoAO.rgb;
+        float roughness = material.r;
+        float metallic = material.g;
+        float3 F0 = lerp(float3(0.04f, 0.04f, 0.04f), albedo, metallic);
+
+        // Negative marks an anchor on the sky, whose block lights itself
+        float3 Lo = float3(-1.0f, 0.0f, 0.0f);
+        if (covered && shades) {
+            Lo = DirectLighting(worldPos, N, V, albedo, F0, metallic, roughness);
+        }
+        BlockLighting[index] = Lo;
+        GroupMemoryBarrierWithGroupSync();
+
+        if (!covered) return;
+        if (!shades) {
+            Lo = BlockLighting[anchor.y * TILE_SIZE + anchor.x];
+            if (Lo.x < 0.0f) {
+                Lo = DirectLighting(worldPos, N, V, albedo, F0, metallic, roughness);
+            }
+        }
+
+        float ao = albedoAO.a;
+        if (HasOcclusion) ao *= Occlusion[pixel];
+        float3 ambient = ProbeEnabled ? SampleProbeIrradiance(worldPos, N) : AmbientLight;
+        float3 color = ambient * albedo * ao + Lo + albedo * material.a * EMISSIVE_RANGE;
+        if (HasReflections) {
+            color += Reflections[pixel].rgb * EnvironmentBRDF(F0, roughness, saturate(dot(N, V))) * ao;
+        }
+
+        // Same tonemap and gamma as the forward PBR output
+        color = color / (color + 1.0f);
+        Destination[pixel] = float4(pow(color, 1.0f / Gamma), 1.0f);
+    }
+)";
+
+// Render() reads one shading rate per lighting tile
+static_assert(DeferredRenderer::TILE_SIZE == ShadingRateImage::TILE_SIZE, "Shading-rate tiles must match lighting tiles");
+
+struct GpuDeferredConstants {
+    DirectX::XMFLOAT4X4 inverseView;   // Transposed for HLSL
+    float projectionScale[2];
+    float depthScale;
+    float depthOffset;
+    UINT screenSize[2];
+    float gamma;
+    UINT hasOcclusion;
+    DirectX::XMFLOAT3 ambientLight;
+    UINT hasShadingRate;
+    UINT hasReflections;
+    float padding[3];
+};
+
+// Must match the formats documented in the header and GBuffer_PS.hlsl
+constexpr DXGI_FORMAT TARGET_FORMATS[DeferredRenderer::TARGET_COUNT] = {
+    DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+    DXGI_FORMAT_R16G16_SNORM,
+    DXGI_FORMAT_R8G8B8A8_UNORM
+};
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+} // namespace
+
+DeferredRenderer::DeferredRenderer()
+    : device_(nullptr)
+    , context_(nullptr)
+    , width_(0)
+    , height_(0)
+    , targets_{}
+    , targetViews_{}
+    , views_{}
+    , depth_(nullptr)
+    , depthTarget_(nullptr)
+    , depthView_(nullptr)
+    , lightingShader_(nullptr)
+    , constants_(nullptr)
+{
+}
+
+DeferredRenderer::~DeferredRenderer() {
+    Shutdown();
+}
+
+bool DeferredRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height) {
+    Shutdown();
+    if (!device || !context || width == 0 || height == 0) return false;
+
+    device_ = device;
+    context_ = context;
+    width_ = width;
+    height_ = height;
+
+    if (!CreateShader() || !CreateTargets()) {
+        Logger::Error("Failed to create deferred rendering resources");
+        Shutdown();
+        return false;
+    }
+    Logger::Info("Deferred G-buffer created: " + std::to_string(width_) + "x" + std::to_string(height_) + ", " +
+                 std::to_string((width_ * height_ * 16) >> 20) + " MB");
+    return true;
+}
+
+void DeferredRenderer::Shutdown() {
+    for (UINT i = 0; i < TARGET_COUNT; ++i) {
+        SafeRelease(views_[i]);
+        SafeRelease(targetViews_[i]);
+        SafeRelease(targets_[i]);
+    }
+    SafeRelease(depthView_);
+    SafeRelease(depthTarget_);
+    SafeRelease(depth_);
+    SafeRelease(lightingShader_);
+    SafeRelease(constants_);
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+bool DeferredRenderer::CreateShader() {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(std::string(ProbeVolume::GetShaderSource()) + LIGHTING_SHADER, "DeferredTiledLighting", "main", "cs_5_0", 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error("DeferredTiledLighting compilation error: " + errors);
+        }
+        return false;
+    }
+    hr = device_->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &lightingShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = sizeof(GpuDeferredConstants);
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    return SUCCEEDED(device_->CreateBuffer(&desc, nullptr, &constants_));
+}
+
+bool DeferredRenderer::CreateTargets() {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width_;
+    desc.Height = height_;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    for (UINT i = 0; i < TARGET_COUNT; ++i) {
+        desc.Format = TARGET_FORMATS[i];
+        if (FAILED(device_->CreateTexture2D(&desc, nullptr, &targets_[i])) ||
+            FAILED(device_->CreateRenderTargetView(targets_[i], nullptr, &targetViews_[i])) ||
+            FAILED(device_->CreateShaderResourceView(targets_[i], nullptr, &views_[i]))) {
+            return false;
+        }
+    }
+
+    // Typeless so the same depth is both the depth target and a shader input
+    desc.Format = DXGI_FORMAT_R32_TYPELESS;
+    desc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &depth_))) return false;
+
+    D3D11_DEPTH_STENCIL_VIEW_DESC depthDesc = {};
+    depthDesc.Format = DXGI_FORMAT_D32_FLOAT;
+    depthDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+    if (FAILED(device_->CreateDepthStencilView(depth_, &depthDesc, &depthTarget_))) return false;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    viewDesc.Texture2D.MipLevels = 1;
+    return SUCCEEDED(device_->CreateShaderResourceView(depth_, &viewDesc, &depthView_));
+}
+
+void DeferredRenderer::BeginGeometryPass(StateCache& stateCache) {
+    if (!device_) return;
+
+    // Zero decodes as roughness 0, no emission and a +Z normal; sky pixels are never lit anyway
+    const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (UINT i = 0; i < TARGET_COUNT; ++i) {
+        context_->ClearRenderTargetView(targetViews_[i], clearColor);
+    }
+    context_->ClearDepthStencilView(depthTarget_, D3D11_CLEAR_DEPTH, 1.0f, 0);
+    stateCache.OMSetRenderTargets(TARGET_COUNT, targetViews_, depthTarget_);
+}
+
+void DeferredRenderer::Render(const ClusteredLightCuller* lights, ID3D11ShaderResourceView* occlusion,
+                              DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection,
+                              const DirectX::XMFLOAT3& ambientLight, float gamma, ID3D11UnorderedAccessView* output,
+                              ID3D11ShaderResourceView* shadingRate, const ProbeVolume* probes,
+                              ID3D11ShaderResourceView* reflections) {
+    if (!device_ || !output) return;
+    NEXUS_PROFILE_SCOPE("DeferredRenderer::Render");
+
+    DirectX::XMFLOAT4X4 projectionValues;
+    DirectX::XMStoreFloat4x4(&projectionValues, projection);
+
+    GpuDeferredConstants constants = {};
+    DirectX::XMStoreFloat4x4(&constants.inverseView, DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, view)));
+    constants.projectionScale[0] = projectionValues._11;
+    constants.projectionScale[1] = projectionValues._22;
+    constants.depthScale = projectionValues._43;
+    constants.depthOffset = projectionValues._33;
+    constants.screenSize[0] = width_;
+    constants.screenSize[1] = height_;
+    constants.gamma = gamma > 0.0f ? gamma : 2.2f;
+    constants.hasOcclusion = occlusion ? 1u : 0u;
+    constants.ambientLight = ambientLight;
+    constants.hasShadingRate = shadingRate ? 1u : 0u;
+    constants.hasReflections = reflections ? 1u : 0u;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+
+    // Without the culler the light constants read as zero and only ambient and emission remain
+    if (lights) {
+        lights->BindCompute();
+    } else {
+        ID3D11Buffer* nullBuffer = nullptr;
+        context_->CSSetConstantBuffers(ClusteredLightCuller::CONSTANT_SLOT, 1, &nullBuffer);
+    }
+    // Likewise the probe constants read as zero, which falls back to the flat ambient
+    if (probes) {
+        probes->BindCompute();
+    } else {
+        ID3D11Buffer* nullBuffer = nullptr;
+        context_->CSSetConstantBuffers(ProbeVolume::CONSTANT_SLOT, 1, &nullBuffer);
+    }
+
+    ID3D11ShaderResourceView* inputs[TARGET_COUNT + 4] = { views_[0], views_[1], views_[2], depthView_, occlusion, shadingRate,
+                                                           reflections };
+    context_->CSSetShader(lightingShader_, nullptr, 0);
+    context_->CSSetConstantBuffers(0, 1, &constants_);
+    context_->CSSetShaderResources(0, TARGET_COUNT + 4, inputs);
+    context_->CSSetUnorderedAccessViews(0, 1, &output, nullptr);
+    context_->Dispatch((width_ + TILE_SIZE - 1) / TILE_SIZE, (height_ + TILE_SIZE - 1) / TILE_SIZE, 1);
+
+    ID3D11ShaderResourceView* nullViews[TARGET_COUNT + 4] = {};
+    ID3D11UnorderedAccessView* nullTarget = nullptr;
+    context_->CSSetShaderResources(0, TARGET_COUNT + 4, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+    context_->CSSetShader(nullptr, nullptr, 0);
+}
+
+} // namespace Nexus
@@ -0,0 +1,349 @@
+#include "DynamicResolution.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// Fullscreen triangle, uv spans the output
+const char* FULLSCREEN_VS = R"(
+struct Output
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+Output main(uint id : SV_VertexID)
+{
+    Output output;
+    output.uv = float2((id << 1) & 2, id & 2);
+    output.position = float4(output.uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+    return output;
+}
+)";
+
+// Catmull-Rom in five bilinear taps, clamped to the 2x2 source texels around the sample so the
+// filter's negative lobes cannot ring at edges, then contrast-adaptive sharpening that backs off
+// where local contrast is already high. Every tap is kept inside the rendered region
+const char* UPSCALE_PS = R"(
+cbuffer UpscaleConstants : register(b0)
+{
+    float2 InputSize;     // Rendered pixels
+    float2 TexelSize;     // One texel of the scene target in uv
+    float Sharpness;
+    float3 Padding;
+};
+
+Texture2D<float4> Scene : register(t0);
+SamplerState LinearClamp : register(s0);
+
+float3 Fetch(float2 pixel)
+{
+    pixel = clamp(pixel, 0.5f, InputSize - 0.5f);
+    return Scene.SampleLevel(LinearClamp, pixel * TexelSize, 0).rgb;
+}
+
+float4 main(float4 position : SV_POSITION, float2 uv : TEXCOORD0) : SV_TARGET
+{
+    float2 pixel = uv * InputSize;
+    float2 center = floor(pixel - 0.5f) + 0.5f;
+    float2 f = pixel - center;
+
+    float2 w0 = f * (-0.5f + f * (1.0f - 0.5f * f));
+    float2 w1 = 1.0f + f * f * (-2.5f + 1.5f * f);
+    float2 w2 = f * (0.5f + f * (2.0f - 1.5f * f));
+    float2 w3 = f * f * (-0.5f + 0.5f * f);
+    float2 w12 = w1 + w2;
+    float2 p0 = center - 1.0f;
+    float2 p12 = center + w2 / w12;
+    float2 p3 = center + 2.0f;
+
+    float3 color = Fetch(float2(p12.x, p0.y)) * (w12.x * w0.y) +
+                   Fetch(float2(p0.x, p12.y)) * (w0.x * w12.y) +
+                   Fetch(p12) * (w12.x * w12.y) +
+                   Fetch(float2(p3.x, p12.y)) * (w3.x * w12.y) +
+                   Fetch(float2(p12.x, p3.y)) * (w12.x * w3.y);
+    color /= w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+
+    float3 a = Fetch(center);
+    float3 b = Fetch(center + float2(1.0f, 0.0f));
+    float3 c = Fetch(center + float2(0.0f, 1.0f));
+    float3 d = Fetch(center + float2(1.0f, 1.0f));
+    color = clamp(color, min(min(a, b), min(c, d)), max(max(a, b), max(c, d)));
+
+    if (Sharpness > 0.0f) {
+        float3 north = Fetch(pixel - float2(0.0f, 1.0f));
+        float3 south = Fetch(pixel + float2(0.0f, 1.0f));
+        float3 west = Fetch(pixel - float2(1.0f, 0.0f));
+        float3 east = Fetch(pixel + float2(1.0f, 0.0f));
+        float3 low = min(color, min(min(north, south), min(west, east)));
+        float3 high = max(color, max(max(north, south), max(west, east)));
+        float3 amount = sqrt(saturate(min(low, 1.0f - high) / max(high, 1e-4f)));
+        float3 weight = -amount * lerp(0.125f, 0.2f, Sharpness);
+        color = saturate((color + (north + south + west + east) * weight) / (1.0f + 4.0f * weight));
+    }
+    return float4(color, 1.0f);
+}
+)";
+
+// Matches UpscaleConstants above
+struct GpuUpscaleConstants {
+    float inputSize[2];
+    float texelSize[2];
+    float sharpness;
+    float padding[3];
+};
+
+constexpr float INTEGRAL_LIMIT = 2.0f;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3DBlob* CompileShader(const char* source, const char* name, const char* target) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+} // namespace
+
+DynamicResolution::DynamicResolution()
+    : device_(nullptr)
+    , context_(nullptr)
+    , stateCache_(nullptr)
+    , width_(0)
+    , height_(0)
+    , sceneTexture_(nullptr)
+    , sceneTarget_(nullptr)
+    , sceneView_(nullptr)
+    , fullscreenShader_(nullptr)
+    , upscaleShader_(nullptr)
+    , constants_(nullptr)
+    , linearClamp_(nullptr)
+    , rasterizerState_(nullptr)
+    , depthState_(nullptr)
+    , scale_(1.0f)
+    , integral_(0.0f)
+    , previousError_(0.0f)
+    , lastFrameId_(0)
+    , renderWidth_(0)
+    , renderHeight_(0)
+{
+}
+
+DynamicResolution::~DynamicResolution() {
+    Shutdown();
+}
+
+bool DynamicResolution::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                                   UINT width, UINT height, const Settings& settings) {
+    Shutdown();
+    if (!device || !context || !stateCache || width == 0 || height == 0) return false;
+
+    device_ = device;
+    context_ = context;
+    stateCache_ = stateCache;
+    width_ = width;
+    height_ = height;
+    SetSettings(settings);
+
+    if (!CreateResources() || !CreateShaders()) {
+        Logger::Error("Failed to create dynamic resolution resources");
+        Shutdown();
+        return false;
+    }
+
+    integral_ = 0.0f;
+    previousError_ = 0.0f;
+    lastFrameId_ = 0;
+    scale_ = settings_.maxScale;
+    ApplyScale(scale_);
+    Logger::Info("Dynamic resolution initialized: scale " + std::to_string(settings_.minScale) + "-" +
+                 std::to_string(settings_.maxScale) + ", target " + std::to_string(settings_.targetFrameMs) + " ms");
+    return true;
+}
+
+void DynamicResolution::Shutdown() {
+    SafeRelease(sceneTarget_);
+    SafeRelease(sceneView_);
+    SafeRelease(sceneTexture_);
+    SafeRelease(fullscreenShader_);
+    SafeRelease(upscaleShader_);
+    SafeRelease(constants_);
+    SafeRelease(linearClamp_);
+    SafeRelease(rasterizerState_);
+    SafeRelease(depthState_);
+    device_ = nullptr;
+    context_ = nullptr;
+    stateCache_ = nullptr;
+}
+
+bool DynamicResolution::CreateResources() {
+    // Same format as the back buffer so a full-scale frame can be copied instead of filtered
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width_;
+    desc.Height = height_;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &sceneTexture_))) return false;
+    if (FAILED(device_->CreateRenderTargetView(sceneTexture_, nullptr, &sceneTarget_))) return false;
+    if (FAILED(device_->CreateShaderResourceView(sceneTexture_, nullptr, &sceneView_))) return false;
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = sizeof(GpuUpscaleConstants);
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&bufferDesc, nullptr, &constants_))) return false;
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (FAILED(device_->CreateSamplerState(&samplerDesc, &linearClamp_))) return false;
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizerDesc, &rasterizerState_))) return false;
+
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = FALSE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+    return SUCCEEDED(device_->CreateDepthStencilState(&depthDesc, &depthState_));
+}
+
+bool DynamicResolution::CreateShaders() {
+    ID3DBlob* blob = CompileShader(FULLSCREEN_VS, "DynamicResolution_VS", "vs_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &fullscreenShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(UPSCALE_PS, "DynamicResolutionUpscale_PS", "ps_5_0");
+    if (!blob) return false;
+    hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &upscaleShader_);
+    blob->Release();
+    return SUCCEEDED(hr);
+}
+
+void DynamicResolution::SetSettings(const Settings& settings) {
+    settings_ = settings;
+    settings_.maxScale = std::clamp(settings_.maxScale, 0.1f, 1.0f);
+    settings_.minScale = std::clamp(settings_.minScale, 0.1f, settings_.maxScale);
+    settings_.targetFrameMs = std::max(settings_.targetFrameMs, 1.0f);
+    settings_.scaleStep = std::max(settings_.scaleStep, 0.0f);
+    settings_.sharpness = std::clamp(settings_.sharpness, 0.0f, 1.0f);
+    if (width_ > 0) {
+        ApplyScale(scale_);
+    }
+}
+
+void DynamicResolution::Update(float gpuFrameMs, uint64_t frameId) {
+    if (gpuFrameMs <= 0.0f || frameId == lastFrameId_) return;
+    lastFrameId_ = frameId;
+
+    // Positive error is headroom. Working on area makes the response the same at every scale
+    float error = (settings_.targetFrameMs - gpuFrameMs) / settings_.targetFrameMs;
+    float area = scale_ * scale_;
+    float minArea = settings_.minScale * settings_.minScale;
+    float maxArea = settings_.maxScale * settings_.maxScale;
+
+    // Hold the integral while pinned at a bound so it does not wind up
+    bool pinned = (area >= maxArea && error > 0.0f) || (area <= minArea && error < 0.0f);
+    if (!pinned) {
+        integral_ = std::clamp(integral_ + error, -INTEGRAL_LIMIT, INTEGRAL_LIMIT);
+    }
+    float derivative = error - previousError_;
+    previousError_ = error;
+
+    float response = settings_.proportionalGain * error + settings_.integralGain * integral_ +
+                     settings_.derivativeGain * derivative;
+    area = std::clamp(area * (1.0f + std::clamp(response, -0.5f, 0.5f)), minArea, maxArea);
+    ApplyScale(std::sqrt(area));
+}
+
+void DynamicResolution::ApplyScale(float scale) {
+    if (settings_.scaleStep > 0.0f) {
+        float snapped = std::round(scale / settings_.scaleStep) * settings_.scaleStep;
+        // Steps smaller than half a snap would be rounded away; keep the old scale instead
+        scale = std::fabs(snapped - scale_) >= settings_.scaleStep * 0.5f ? snapped : scale_;
+    }
+    scale_ = std::clamp(scale, settings_.minScale, settings_.maxScale);
+    renderWidth_ = std::clamp(static_cast<UINT>(std::lround(width_ * scale_)), 1u, width_);
+    renderHeight_ = std::clamp(static_cast<UINT>(std::lround(height_ * scale_)), 1u, height_);
+}
+
+void DynamicResolution::Upscale(ID3D11RenderTargetView* target) {
+    if (!device_ || !target) return;
+    NEXUS_PROFILE_SCOPE("DynamicResolution::Upscale");
+
+    if (renderWidth_ == width_ && renderHeight_ == height_ && settings_.sharpness <= 0.0f) {
+        ID3D11Resource* output = nullptr;
+        target->GetResource(&output);
+        context_->CopyResource(output, sceneTexture_);
+        output->Release();
+        stateCache_->OMSetRenderTargets(1, &target, nullptr);
+        return;
+    }
+
+    GpuUpscaleConstants constants = {};
+    constants.inputSize[0] = static_cast<float>(renderWidth_);
+    constants.inputSize[1] = static_cast<float>(renderHeight_);
+    constants.texelSize[0] = 1.0f / static_cast<float>(width_);
+    constants.texelSize[1] = 1.0f / static_cast<float>(height_);
+    constants.sharpness = settings_.sharpness;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = static_cast<float>(width_);
+    viewport.Height = static_cast<float>(height_);
+    viewport.MaxDepth = 1.0f;
+    stateCache_->OMSetRenderTargets(1, &target, nullptr);
+    stateCache_->RSSetViewports(1, &viewport);
+    stateCache_->RSSetState(rasterizerState_);
+    stateCache_->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+    stateCache_->OMSetDepthStencilState(depthState_, 0);
+    stateCache_->IASetInputLayout(nullptr);
+    stateCache_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    stateCache_->VSSetShader(fullscreenShader_);
+    stateCache_->PSSetShader(upscaleShader_);
+    stateCache_->PSSetConstantBuffers(0, 1, &constants_);
+    stateCache_->PSSetShaderResources(0, 1, &sceneView_);
+    stateCache_->PSSetSamplers(0, 1, &linearClamp_);
+    context_->Draw(3, 0);
+
+    // The scene target is bound for output again next frame
+    ID3D11ShaderResourceView* nullView = nullptr;
+    stateCache_->PSSetShaderResources(0, 1, &nullView);
+}
+
+} // namespace Nexus
@@ -0,0 +1,809 @@
+#include "FoliageRenderer.h"
+#include "Mesh.h"
+#include "OcclusionCuller.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+
+// One group per chunk of a single type. Each thread tests one instance; the group counts its
+// survivors per LOD in shared memory and reserves list space with one atomic per LOD
+const char* FOLIAGE_CULL_SHADER = R"(
+    #define CHUNK_SIZE 256
+    #define MAX_LODS 4
+
+    cbuffer FoliageConstants : register(b0)
+    {
+        matrix PyramidViewProjection;
+        float4 FrustumPlanes[6];
+        float3 CameraPosition;
+        float Density;
+        float2 PyramidSize;
+        uint MipCount;
+        uint UseHiZ;
+        uint ChunkCount;
+        float3 Padding;
+    };
+
+    struct InstanceData
+    {
+        float3 Position;
+        float Scale;
+        float SinYaw;
+        float CosYaw;
+        float Random;
+        float InstancePadding;
+    };
+
+    struct TypeData
+    {
+        float3 LodDistances;
+        float CullDistance;
+        float3 Center;
+        float Radius;
+        float ThinStart;
+        uint LodCount;
+        uint ListBase;
+        uint Capacity;
+    };
+
+    StructuredBuffer<InstanceData> Instances : register(t0);
+    StructuredBuffer<uint4> Chunks : register(t1);
+    StructuredBuffer<uint> VisibleChunks : register(t2);
+    StructuredBuffer<TypeData> Types : register(t3);
+    Texture2D<float> HiZ : register(t4);
+    RWByteAddressBuffer VisibleInstances : register(u0);
+    RWByteAddressBuffer DrawArguments : register(u1);
+
+    static const uint ARGUMENT_STRIDE = 20;
+    static const uint GROUPS_PER_ROW = 65535;
+    static const float FADE_BAND = 0.1f;
+
+    groupshared uint lodCounts[MAX_LODS];
+    groupshared uint lodBases[MAX_LODS];
+
+    // Same 2x2 texel footprint test as MeshletCuller, on the sphere's box
+    bool HiZVisible(float3 center, float radius)
+    {
+        float3 ndcMin = float3(1e30f, 1e30f, 1e30f);
+        float3 ndcMax = float3(-1e30f, -1e30f, -1e30f);
+        [unroll] for (uint c = 0; c < 8; ++c) {
+            float3 corner = center + radius * float3((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+            float4 clip = mul(float4(corner, 1.0f), PyramidViewProjection);
+            if (clip.w <= 0.0f) return true;
+            float3 ndc = clip.xyz / clip.w;
+            ndcMin = min(ndcMin, ndc);
+            ndcMax = max(ndcMax, ndc);
+        }
+
+        float2 uvMin = saturate(float2(ndcMin.x, -ndcMax.y) * 0.5f + 0.5f);
+        float2 uvMax = saturate(float2(ndcMax.x, -ndcMin.y) * 0.5f + 0.5f);
+        float2 extent = (uvMax - uvMin) * PyramidSize;
+        uint level = min((uint)ceil(log2(max(max(extent.x, extent.y), 1.0f))), MipCount - 1);
+        uint2 levelSize = max(uint2(PyramidSize) >> level, uint2(1, 1));
+        uint2 lo = min(uint2(uvMin * levelSize), levelSize - 1);
+        uint2 hi = min(uint2(uvMax * levelSize), levelSize - 1);
+
+        float occluder = max(max(HiZ.Load(int3(lo, level)), HiZ.Load(int3(hi.x, lo.y, level))),
+                             max(HiZ.Load(int3(lo.x, hi.y, level)), HiZ.Load(int3(hi, level))));
+        return ndcMin.z <= occluder;
+    }
+
+    [numthreads(CHUNK_SIZE, 1, 1)]
+    void main(uint3 group : SV_GroupID, uint thread : SV_GroupIndex)
+    {
+        uint chunkSlot = group.y * GROUPS_PER_ROW + group.x;
+        uint4 chunk = chunkSlot < ChunkCount ? Chunks[VisibleChunks[chunkSlot]] : uint4(0, 0, 0, 0);
+        TypeData type = Types[chunk.z];
+        if (thread < MAX_LODS) {
+            lodCounts[thread] = 0;
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        bool visible = thread < chunk.y;
+        uint instanceIndex = chunk.x + (visible ? thread : 0);
+        InstanceData instance = Instances[instanceIndex];
+        float distance = length(instance.Position - CameraPosition);
+
+        // The kept fraction falls linearly to zero at the cull distance and goes past Density
+        // inside thinStart, where nothing is thinned beyond the density setting
+        float keep = Density * (type.CullDistance - distance) / max(type.CullDistance - type.ThinStart, 1e-3f);
+        visible = visible && instance.Random < min(keep, Density);
+        float fade = saturate((keep - instance.Random) / (FADE_BAND * max(Density, 1e-3f)));
+
+        float3 offset = type.Center * instance.Scale;
+        float3 center = instance.Position + float3(offset.x * instance.CosYaw + offset.z * instance.SinYaw, offset.y,
+                                                   offset.z * instance.CosYaw - offset.x * instance.SinYaw);
+        float radius = type.Radius * instance.Scale;
+        [unroll] for (uint p = 0; p < 6; ++p) {
+            visible = visible && dot(FrustumPlanes[p].xyz, center) + FrustumPlanes[p].w >= -radius;
+        }
+        if (visible && UseHiZ) {
+            visible = HiZVisible(center, radius);
+        }
+
+        uint lod = (uint)(distance >= type.LodDistances.x) + (uint)(distance >= type.LodDistances.y) +
+                   (uint)(distance >= type.LodDistances.z);
+        lod = min(lod, type.LodCount - 1);
+        uint slot = 0;
+        if (visible) {
+            InterlockedAdd(lodCounts[lod], 1, slot);
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        if (thread < MAX_LODS && lodCounts[thread] > 0) {
+            uint record = (chunk.z * MAX_LODS + thread) * ARGUMENT_STRIDE;
+            DrawArguments.InterlockedAdd(record + 4, lodCounts[thread], lodBases[thread]);
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        if (visible) {
+            uint entry = type.ListBase + lod * type.Capacity + lodBases[lod] + slot;
+            VisibleInstances.Store2(entry * 8, uint2(instanceIndex, asuint(fade)));
+        }
+    }
+)";
+
+// PBR_VS with the world transform taken from the instance list entry, scaled down by its fade
+const char* FOLIAGE_VS = R"(
+    struct VS_INPUT {
+    #ifdef COMPRESSED_VERTEX
+        float4 position : POSITION;
+        float4 normalTangent : NORMAL;
+    #else
+        float3 position : POSITION;
+        float3 normal : NORMAL;
+        float3 tangent : TANGENT;
+    #endif
+        float2 texCoord : TEXCOORD0;
+    };
+
+    struct VS_OUTPUT {
+        float4 position : SV_POSITION;
+        float3 worldPos : TEXCOORD0;
+        float3 normal : TEXCOORD1;
+        float3 tangent : TEXCOORD2;
+        float3 bitangent : TEXCOORD3;
+        float2 texCoord : TEXCOORD4;
+        float4 color : TEXCOORD5;
+        float3 viewDir : TEXCOORD6;
+        float4 lightSpacePos : TEXCOORD7;
+    };
+
+    cbuffer FoliageDraw : register(b0)
+    {
+        matrix ViewProjection;
+        matrix LightViewProjection;
+        float3 CameraPosition;
+        uint ListBase;
+        float4 PositionOffset;
+        float4 PositionScale;
+    };
+
+    struct InstanceData
+    {
+        float3 Position;
+        float Scale;
+        float SinYaw;
+        float CosYaw;
+        float Random;
+        float InstancePadding;
+    };
+
+    StructuredBuffer<InstanceData> Instances : register(t0);
+    ByteAddressBuffer VisibleInstances : register(t1);
+
+    #ifdef COMPRESSED_VERTEX
+    float3 DecodeOctahedral(float2 encoded)
+    {
+        float2 e = encoded * 2.0f - 1.0f;
+        float3 v = float3(e, 1.0f - abs(e.x) - abs(e.y));
+        float t = saturate(-v.z);
+        v.xy += (v.xy >= 0.0f) ? -t : t;
+        return normalize(v);
+    }
+    #endif
+
+    // Row-vector rotation about +Y, as XMMatrixRotationY
+    float3 Yaw(float3 v, InstanceData instance)
+    {
+        return float3(v.x * instance.CosYaw + v.z * instance.SinYaw, v.y, v.z * instance.CosYaw - v.x * instance.SinYaw);
+    }
+
+    VS_OUTPUT main(VS_INPUT input, uint instanceId : SV_InstanceID)
+    {
+    #ifdef COMPRESSED_VERTEX
+        float3 position = PositionOffset.xyz + input.position.xyz * PositionScale.xyz;
+        float3 normal = DecodeOctahedral(input.normalTangent.xy);
+        float3 tangent = DecodeOctahedral(input.normalTangent.zw);
+    #else
+        float3 position = input.position;
+        float3 normal = input.normal;
+        float3 tangent = input.tangent;
+    #endif
+
+        uint2 entry = VisibleInstances.Load2((ListBase + instanceId) * 8);
+        InstanceData instance = Instances[entry.x];
+        float scale = instance.Scale * asfloat(entry.y);
+
+        VS_OUTPUT output;
+        float4 worldPos = float4(instance.Position + Yaw(position, instance) * scale, 1.0f);
+        output.position = mul(worldPos, ViewProjection);
+        output.worldPos = worldPos.xyz;
+        output.normal = normalize(Yaw(normal, instance));
+        output.tangent = normalize(Yaw(tangent, instance));
+        output.bitangent = cross(output.normal, output.tangent);
+        output.texCoord = input.texCoord;
+        output.color = float4(1.0f, 1.0f, 1.0f, 1.0f);
+        output.viewDir = normalize(CameraPosition - output.worldPos);
+        output.lightSpacePos = mul(worldPos, LightViewProjection);
+        return output;
+    }
+)";
+
+constexpr UINT GROUPS_PER_ROW = 65535;
+
+// Matches the shaders' InstanceData
+struct GpuInstance {
+    XMFLOAT3 position;
+    float scale;
+    float sinYaw;
+    float cosYaw;
+    float random;
+    float padding;
+};
+
+// Matches TypeData
+struct GpuType {
+    float lodDistances[FoliageRenderer::MAX_LODS - 1];
+    float cullDistance;
+    XMFLOAT3 center;
+    float radius;
+    float thinStart;
+    UINT lodCount;
+    UINT listBase;
+    UINT capacity;
+};
+
+// First instance, count, type
+struct GpuChunk {
+    UINT firstInstance;
+    UINT count;
+    UINT type;
+    UINT padding;
+};
+
+// Matches FoliageConstants
+struct GpuCullConstants {
+    XMFLOAT4X4 pyramidViewProjection;
+    XMFLOAT4 frustumPlanes[Frustum::PLANE_COUNT];
+    XMFLOAT3 cameraPosition;
+    float density;
+    float pyramidSize[2];
+    UINT mipCount;
+    UINT useHiZ;
+    UINT chunkCount;
+    float padding[3];
+};
+
+// Matches FoliageDraw
+struct GpuDrawConstants {
+    XMFLOAT4X4 viewProjection;
+    XMFLOAT4X4 lightViewProjection;
+    XMFLOAT3 cameraPosition;
+    UINT listBase;
+    XMFLOAT4 positionOffset;
+    XMFLOAT4 positionScale;
+};
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3DBlob* CompileShader(const char* source, const char* name, const char* target,
+                        const std::vector<ShaderCache::Define>& defines = {}) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors, defines);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+template<typename T>
+void WriteConstants(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const T& data) {
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (SUCCEEDED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        std::memcpy(mapped.pData, &data, sizeof(T));
+        context->Unmap(buffer, 0);
+    }
+}
+
+HRESULT CreateStructuredBuffer(ID3D11Device* device, UINT stride, UINT count, D3D11_USAGE usage, const void* data,
+                               ID3D11Buffer** buffer, ID3D11ShaderResourceView** view) {
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = usage;
+    desc.ByteWidth = stride * count;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = usage == D3D11_USAGE_DYNAMIC ? D3D11_CPU_ACCESS_WRITE : 0;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    desc.StructureByteStride = stride;
+    D3D11_SUBRESOURCE_DATA initial = { data, 0, 0 };
+    HRESULT hr = device->CreateBuffer(&desc, data ? &initial : nullptr, buffer);
+    if (FAILED(hr)) return hr;
+    return device->CreateShaderResourceView(*buffer, nullptr, view);
+}
+
+uint64_t CellKey(int x, int z) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+}
+
+// Stable [0, 1) number per position, so thinning keeps the same instances across rebuilds
+float InstanceRandom(const XMFLOAT3& position) {
+    uint32_t bits[3];
+    std::memcpy(bits, &position, sizeof(bits));
+    uint32_t hash = 2166136261u;
+    for (uint32_t word : bits) {
+        hash = (hash ^ word) * 16777619u;
+        hash ^= hash >> 15;
+    }
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return static_cast<float>(hash >> 8) * (1.0f / 16777216.0f);
+}
+
+// Object-space bounding sphere of a mesh's box
+void MeshSphere(const Mesh& mesh, XMFLOAT3& center, float& radius) {
+    const XMFLOAT3& lo = mesh.GetBoundsMin();
+    const XMFLOAT3& hi = mesh.GetBoundsMax();
+    center = XMFLOAT3((lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f);
+    radius = 0.5f * std::sqrt((hi.x - lo.x) * (hi.x - lo.x) + (hi.y - lo.y) * (hi.y - lo.y) + (hi.z - lo.z) * (hi.z - lo.z));
+}
+
+UINT LodSlots(const Mesh& mesh) {
+    return static_cast<UINT>(std::min<size_t>(std::max<size_t>(mesh.GetLods().size(), 1), FoliageRenderer::MAX_LODS));
+}
+
+} // namespace
+
+FoliageRenderer::FoliageRenderer()
+    : device_(nullptr)
+    , context_(nullptr)
+    , dirty_(false)
+    , cullShader_(nullptr)
+    , cullConstants_(nullptr)
+    , vertexShaders_{ nullptr, nullptr }
+    , inputLayouts_{ nullptr, nullptr }
+    , drawConstants_(nullptr)
+    , typeBuffer_(nullptr)
+    , typeView_(nullptr)
+    , argumentsBuffer_(nullptr)
+    , argumentsTarget_(nullptr)
+    , instanceBuffer_(nullptr)
+    , instanceView_(nullptr)
+    , chunkBuffer_(nullptr)
+    , chunkView_(nullptr)
+    , visibleChunkBuffer_(nullptr)
+    , visibleChunkView_(nullptr)
+    , listBuffer_(nullptr)
+    , listTarget_(nullptr)
+    , listView_(nullptr)
+    , chunkCount_(0)
+{
+}
+
+FoliageRenderer::~FoliageRenderer() {
+    Shutdown();
+}
+
+bool FoliageRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings) {
+    Shutdown();
+    if (!device || !context) return false;
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0) {
+        Logger::Warning("Foliage rendering needs feature level 11_0 compute shaders");
+        return false;
+    }
+
+    device_ = device;
+    context_ = context;
+    SetSettings(settings);
+
+    D3D11_BUFFER_DESC constantsDesc = {};
+    constantsDesc.Usage = D3D11_USAGE_DYNAMIC;
+    constantsDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constantsDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    constantsDesc.ByteWidth = sizeof(GpuCullConstants);
+    HRESULT hr = device_->CreateBuffer(&constantsDesc, nullptr, &cullConstants_);
+    constantsDesc.ByteWidth = sizeof(GpuDrawConstants);
+    if (SUCCEEDED(hr)) hr = device_->CreateBuffer(&constantsDesc, nullptr, &drawConstants_);
+    if (SUCCEEDED(hr)) {
+        hr = CreateStructuredBuffer(device_, sizeof(GpuType), MAX_TYPES, D3D11_USAGE_DEFAULT, nullptr,
+                                    &typeBuffer_, &typeView_);
+    }
+
+    D3D11_BUFFER_DESC argumentsDesc = {};
+    argumentsDesc.Usage = D3D11_USAGE_DEFAULT;
+    argumentsDesc.ByteWidth = ARGUMENT_STRIDE * MAX_TYPES * MAX_LODS;
+    argumentsDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+    argumentsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    if (SUCCEEDED(hr)) hr = device_->CreateBuffer(&argumentsDesc, nullptr, &argumentsBuffer_);
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = argumentsDesc.ByteWidth / 4;
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+    if (SUCCEEDED(hr)) hr = device_->CreateUnorderedAccessView(argumentsBuffer_, &uavDesc, &argumentsTarget_);
+
+    if (FAILED(hr) || !CreateShaders()) {
+        Logger::Error("Failed to create foliage rendering resources");
+        Shutdown();
+        return false;
+    }
+
+    Logger::Info("Foliage renderer initialized");
+    return true;
+}
+
+bool FoliageRenderer::CreateShaders() {
+    ID3DBlob* blob = CompileShader(FOLIAGE_CULL_SHADER, "FoliageCull", "cs_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &cullShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    std::vector<ShaderCache::Define> compressed = {{COMPRESSED_VERTEX_KEYWORD, "1"}};
+    for (UINT format = 0; format < 2; ++format) {
+        blob = CompileShader(FOLIAGE_VS, "Foliage_VS", "vs_5_0",
+                             format ? compressed : std::vector<ShaderCache::Define>());
+        if (!blob) return false;
+
+        UINT elementCount = 0;
+        const D3D11_INPUT_ELEMENT_DESC* elements = Mesh::GetInputLayout(static_cast<VertexFormat>(format), elementCount);
+        hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &vertexShaders_[format]);
+        if (SUCCEEDED(hr)) {
+            hr = device_->CreateInputLayout(elements, elementCount, blob->GetBufferPointer(), blob->GetBufferSize(),
+                                            &inputLayouts_[format]);
+        }
+        blob->Release();
+        if (FAILED(hr)) return false;
+    }
+    return true;
+}
+
+void FoliageRenderer::Shutdown() {
+    ReleaseInstanceBuffers();
+    SafeRelease(argumentsTarget_);
+    SafeRelease(argumentsBuffer_);
+    SafeRelease(typeView_);
+    SafeRelease(typeBuffer_);
+    SafeRelease(drawConstants_);
+    for (UINT i = 0; i < 2; ++i) {
+        SafeRelease(inputLayouts_[i]);
+        SafeRelease(vertexShaders_[i]);
+    }
+    SafeRelease(cullConstants_);
+    SafeRelease(cullShader_);
+    types_.clear();
+    cells_.clear();
+    dirty_ = false;
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+void FoliageRenderer::ReleaseInstanceBuffers() {
+    SafeRelease(listView_);
+    SafeRelease(listTarget_);
+    SafeRelease(listBuffer_);
+    SafeRelease(visibleChunkView_);
+    SafeRelease(visibleChunkBuffer_);
+    SafeRelease(chunkView_);
+    SafeRelease(chunkBuffer_);
+    SafeRelease(instanceView_);
+    SafeRelease(instanceBuffer_);
+    chunkCount_ = 0;
+    typeInstanceCounts_.clear();
+    typeListBases_.clear();
+}
+
+void FoliageRenderer::SetSettings(const Settings& settings) {
+    settings_ = settings;
+    settings_.cellSize = std::max(settings_.cellSize, 1.0f);
+    settings_.density = std::min(std::max(settings_.density, 0.0f), 1.0f);
+    settings_.distanceScale = std::max(settings_.distanceScale, 0.0f);
+}
+
+UINT FoliageRenderer::AddType(const Type& type) {
+    if (!type.mesh || type.mesh->GetLods().empty() || types_.size() >= MAX_TYPES) return INVALID_TYPE;
+    if (type.mesh->GetVertexFormat() == VertexFormat::Skinned) {
+        Logger::Warning("Foliage meshes cannot be skinned");
+        return INVALID_TYPE;
+    }
+    types_.push_back(type);
+    return static_cast<UINT>(types_.size() - 1);
+}
+
+void FoliageRenderer::AddInstances(UINT type, const std::vector<Instance>& instances) {
+    if (type >= types_.size() || instances.empty()) return;
+    for (const Instance& instance : instances) {
+        int x = static_cast<int>(std::floor(instance.position.x / settings_.cellSize));
+        int z = static_cast<int>(std::floor(instance.position.z / settings_.cellSize));
+        Cell& cell = cells_[CellKey(x, z)];
+        cell.x = x;
+        cell.z = z;
+        if (cell.types.size() < types_.size()) cell.types.resize(types_.size());
+        cell.types[type].push_back(instance);
+    }
+    dirty_ = true;
+}
+
+void FoliageRenderer::ClearCell(int cellX, int cellZ) {
+    if (cells_.erase(CellKey(cellX, cellZ)) > 0) dirty_ = true;
+}
+
+void FoliageRenderer::Clear() {
+    cells_.clear();
+    dirty_ = true;
+}
+
+bool FoliageRenderer::RebuildBuffers() {
+    NEXUS_PROFILE_SCOPE("FoliageRenderer::RebuildBuffers");
+    ReleaseInstanceBuffers();
+    dirty_ = false;
+
+    std::vector<XMFLOAT3> centers(types_.size());
+    std::vector<float> radii(types_.size());
+    for (size_t t = 0; t < types_.size(); ++t) {
+        MeshSphere(*types_[t].mesh, centers[t], radii[t]);
+    }
+
+    // Cell by cell and type by type, so a visible cell is one run of chunks
+    std::vector<GpuInstance> instances;
+    std::vector<GpuChunk> chunks;
+    typeInstanceCounts_.assign(types_.size(), 0);
+    for (auto& entry : cells_) {
+        Cell& cell = entry.second;
+        cell.firstChunk = static_cast<UINT>(chunks.size());
+        cell.instanceCount = 0;
+        cell.cullDistance = 0.0f;
+        cell.bounds = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+
+        for (UINT t = 0; t < cell.types.size(); ++t) {
+            const std::vector<Instance>& source = cell.types[t];
+            if (source.empty()) continue;
+            cell.cullDistance = std::max(cell.cullDistance, types_[t].cullDistance);
+
+            for (size_t first = 0; first < source.size(); first += CHUNK_SIZE) {
+                UINT count = static_cast<UINT>(std::min<size_t>(CHUNK_SIZE, source.size() - first));
+                chunks.push_back({ static_cast<UINT>(instances.size() + first), count, t, 0 });
+            }
+            for (const Instance& instance : source) {
+                // The box of the yawed sphere, which is the sphere's own box
+                float radius = radii[t] * instance.scale;
+                float s = std::sin(instance.yaw);
+                float c = std::cos(instance.yaw);
+                XMFLOAT3 offset(centers[t].x * instance.scale, centers[t].y * instance.scale, centers[t].z * instance.scale);
+                XMFLOAT3 center(instance.position.x + offset.x * c + offset.z * s, instance.position.y + offset.y,
+                                instance.position.z + offset.z * c - offset.x * s);
+                cell.bounds.min = XMFLOAT3(std::min(cell.bounds.min.x, center.x - radius), std::min(cell.bounds.min.y, center.y - radius),
+                                           std::min(cell.bounds.min.z, center.z - radius));
+                cell.bounds.max = XMFLOAT3(std::max(cell.bounds.max.x, center.x + radius), std::max(cell.bounds.max.y, center.y + radius),
+                                           std::max(cell.bounds.max.z, center.z + radius));
+
+                instances.push_back({ instance.position, instance.scale, s, c, InstanceRandom(instance.position), 0.0f });
+            }
+            typeInstanceCounts_[t] += static_cast<UINT>(source.size());
+            cell.instanceCount += static_cast<UINT>(source.size());
+        }
+        cell.chunkCount = static_cast<UINT>(chunks.size()) - cell.firstChunk;
+    }
+    if (instances.empty()) return true;
+
+    // Every LOD of a type may take all of its instances
+    UINT listEntries = 0;
+    typeListBases_.assign(types_.size(), 0);
+    for (size_t t = 0; t < types_.size(); ++t) {
+        typeListBases_[t] = listEntries;
+        listEntries += typeInstanceCounts_[t] * LodSlots(*types_[t].mesh);
+    }
+
+    chunkCount_ = static_cast<UINT>(chunks.size());
+    HRESULT hr = CreateStructuredBuffer(device_, sizeof(GpuInstance), static_cast<UINT>(instances.size()),
+                                        D3D11_USAGE_IMMUTABLE, instances.data(), &instanceBuffer_, &instanceView_);
+    if (SUCCEEDED(hr)) {
+        hr = CreateStructuredBuffer(device_, sizeof(GpuChunk), chunkCount_, D3D11_USAGE_IMMUTABLE, chunks.data(),
+                                    &chunkBuffer_, &chunkView_);
+    }
+    if (SUCCEEDED(hr)) {
+        hr = CreateStructuredBuffer(device_, sizeof(UINT), chunkCount_, D3D11_USAGE_DYNAMIC, nullptr,
+                                    &visibleChunkBuffer_, &visibleChunkView_);
+    }
+
+    // Entries are (instance index, fade) pairs, written by the cull and read by the vertex shader
+    D3D11_BUFFER_DESC listDesc = {};
+    listDesc.Usage = D3D11_USAGE_DEFAULT;
+    listDesc.ByteWidth = listEntries * 2 * sizeof(UINT);
+    listDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+    listDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    if (SUCCEEDED(hr)) hr = device_->CreateBuffer(&listDesc, nullptr, &listBuffer_);
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = listEntries * 2;
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+    if (SUCCEEDED(hr)) hr = device_->CreateUnorderedAccessView(listBuffer_, &uavDesc, &listTarget_);
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+    srvDesc.BufferEx.NumElements = listEntries * 2;
+    srvDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+    if (SUCCEEDED(hr)) hr = device_->CreateShaderResourceView(listBuffer_, &srvDesc, &listView_);
+
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create foliage instance buffers for " + std::to_string(instances.size()) + " instances");
+        ReleaseInstanceBuffers();
+        return false;
+    }
+    Logger::Info("Foliage rebuilt: " + std::to_string(instances.size()) + " instances in " +
+                 std::to_string(cells_.size()) + " cells");
+    return true;
+}
+
+void FoliageRenderer::Cull(CXMMATRIX viewProjection, const XMFLOAT3& cameraPosition, const OcclusionCuller* occlusion) {
+    stats_ = Stats();
+    typeVisible_.assign(types_.size(), false);
+    visibleChunks_.clear();
+    if (!cullShader_) return;
+    if (dirty_ && !RebuildBuffers()) return;
+    if (!instanceBuffer_) return;
+
+    NEXUS_PROFILE_SCOPE("FoliageRenderer::Cull");
+    stats_.cells = static_cast<uint32_t>(cells_.size());
+
+    // Whole cells first, so only chunks of cells in view and in range reach the GPU
+    Frustum frustum = Frustum::FromViewProjection(viewProjection);
+    for (const auto& entry : cells_) {
+        const Cell& cell = entry.second;
+        if (cell.chunkCount == 0 || !frustum.Intersects(cell.bounds)) continue;
+
+        float dx = std::max({ cell.bounds.min.x - cameraPosition.x, 0.0f, cameraPosition.x - cell.bounds.max.x });
+        float dy = std::max({ cell.bounds.min.y - cameraPosition.y, 0.0f, cameraPosition.y - cell.bounds.max.y });
+        float dz = std::max({ cell.bounds.min.z - cameraPosition.z, 0.0f, cameraPosition.z - cell.bounds.max.z });
+        float range = cell.cullDistance * settings_.distanceScale;
+        if (dx * dx + dy * dy + dz * dz >= range * range) continue;
+
+        for (UINT i = 0; i < cell.chunkCount; ++i) {
+            visibleChunks_.push_back(cell.firstChunk + i);
+        }
+        for (size_t t = 0; t < cell.types.size(); ++t) {
+            if (!cell.types[t].empty()) typeVisible_[t] = true;
+        }
+        stats_.visibleCells++;
+        stats_.instances += cell.instanceCount;
+    }
+    if (visibleChunks_.empty()) return;
+
+    // Distances are scaled here so the settings apply without a rebuild
+    GpuType gpuTypes[MAX_TYPES] = {};
+    UINT arguments[MAX_TYPES * MAX_LODS * 5] = {};
+    for (size_t t = 0; t < types_.size(); ++t) {
+        const Type& type = types_[t];
+        GpuType& gpu = gpuTypes[t];
+        for (UINT i = 0; i < MAX_LODS - 1; ++i) {
+            gpu.lodDistances[i] = type.lodDistances[i] * settings_.distanceScale;
+        }
+        gpu.cullDistance = type.cullDistance * settings_.distanceScale;
+        gpu.thinStart = type.thinStart * settings_.distanceScale;
+        MeshSphere(*type.mesh, gpu.center, gpu.radius);
+        gpu.lodCount = LodSlots(*type.mesh);
+        gpu.listBase = typeListBases_[t];
+        gpu.capacity = typeInstanceCounts_[t];
+
+        // IndexCount, InstanceCount (counted by the shader), StartIndex, BaseVertex, StartInstance
+        const std::vector<MeshLod>& lods = type.mesh->GetLods();
+        for (UINT lod = 0; lod < gpu.lodCount; ++lod) {
+            UINT* record = arguments + (t * MAX_LODS + lod) * 5;
+            record[0] = lods[lod].indexCount;
+            record[2] = lods[lod].indexOffset;
+        }
+    }
+    context_->UpdateSubresource(typeBuffer_, 0, nullptr, gpuTypes, 0, 0);
+    context_->UpdateSubresource(argumentsBuffer_, 0, nullptr, arguments, 0, 0);
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(visibleChunkBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, visibleChunks_.data(), visibleChunks_.size() * sizeof(UINT));
+    context_->Unmap(visibleChunkBuffer_, 0);
+
+    const UINT chunkCount = static_cast<UINT>(visibleChunks_.size());
+    GpuCullConstants constants = {};
+    std::memcpy(constants.frustumPlanes, frustum.planes, sizeof(constants.frustumPlanes));
+    constants.cameraPosition = cameraPosition;
+    constants.density = settings_.density;
+    constants.chunkCount = chunkCount;
+
+    ID3D11ShaderResourceView* pyramid = nullptr;
+    if (occlusion && occlusion->HasPyramid()) {
+        pyramid = occlusion->GetPyramidView();
+        XMStoreFloat4x4(&constants.pyramidViewProjection,
+                        XMMatrixTranspose(XMLoadFloat4x4(&occlusion->GetPyramidViewProjection())));
+        constants.pyramidSize[0] = static_cast<float>(occlusion->GetPyramidWidth());
+        constants.pyramidSize[1] = static_cast<float>(occlusion->GetPyramidHeight());
+        constants.mipCount = occlusion->GetPyramidMipCount();
+        constants.useHiZ = 1;
+    }
+    WriteConstants(context_, cullConstants_, constants);
+
+    ID3D11ShaderResourceView* views[] = { instanceView_, chunkView_, visibleChunkView_, typeView_, pyramid };
+    ID3D11UnorderedAccessView* targets[] = { listTarget_, argumentsTarget_ };
+    context_->CSSetShader(cullShader_, nullptr, 0);
+    context_->CSSetConstantBuffers(0, 1, &cullConstants_);
+    context_->CSSetShaderResources(0, 5, views);
+    context_->CSSetUnorderedAccessViews(0, 2, targets, nullptr);
+    context_->Dispatch(std::min(chunkCount, GROUPS_PER_ROW), (chunkCount + GROUPS_PER_ROW - 1) / GROUPS_PER_ROW, 1);
+
+    // The lists are read by the vertex shader and the records by the input assembler next
+    ID3D11ShaderResourceView* nullViews[5] = {};
+    ID3D11UnorderedAccessView* nullTargets[2] = {};
+    context_->CSSetShaderResources(0, 5, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 2, nullTargets, nullptr);
+    context_->CSSetShader(nullptr, nullptr, 0);
+}
+
+void FoliageRenderer::Render(CXMMATRIX viewProjection, CXMMATRIX lightViewProjection, const XMFLOAT3& cameraPosition) {
+    if (!instanceBuffer_ || visibleChunks_.empty()) return;
+    NEXUS_PROFILE_SCOPE("FoliageRenderer::Render");
+
+    GpuDrawConstants constants = {};
+    XMStoreFloat4x4(&constants.viewProjection, XMMatrixTranspose(viewProjection));
+    XMStoreFloat4x4(&constants.lightViewProjection, XMMatrixTranspose(lightViewProjection));
+    constants.cameraPosition = cameraPosition;
+
+    ID3D11ShaderResourceView* views[] = { instanceView_, listView_ };
+    context_->VSSetShaderResources(0, 2, views);
+    for (size_t t = 0; t < typeVisible_.size(); ++t) {
+        if (!typeVisible_[t]) continue;
+        Mesh& mesh = *types_[t].mesh;
+        UINT format = mesh.GetVertexFormat() == VertexFormat::Compressed ? 1 : 0;
+        context_->VSSetShader(vertexShaders_[format], nullptr, 0);
+        context_->IASetInputLayout(inputLayouts_[format]);
+
+        XMFLOAT3 offset = mesh.GetPositionOffset();
+        XMFLOAT3 scale = mesh.GetPositionScale();
+        constants.positionOffset = XMFLOAT4(offset.x, offset.y, offset.z, 0.0f);
+        constants.positionScale = XMFLOAT4(scale.x, scale.y, scale.z, 0.0f);
+
+        // Empty lists draw nothing on the GPU, so every level of a visible type is submitted
+        for (UINT lod = 0; lod < LodSlots(mesh); ++lod) {
+            constants.listBase = typeListBases_[t] + lod * typeInstanceCounts_[t];
+            WriteConstants(context_, drawConstants_, constants);
+            context_->VSSetConstantBuffers(0, 1, &drawConstants_);
+            mesh.RenderInstancedIndirect(context_, argumentsBuffer_,
+                                         static_cast<UINT>(t * MAX_LODS + lod) * ARGUMENT_STRIDE);
+            stats_.draws++;
+        }
+    }
+
+    // Free the lists for the next cull
+    ID3D11ShaderResourceView* nullViews[2] = {};
+    context_->VSSetShaderResources(0, 2, nullViews);
+}
+
+} // namespace Nexus
@@ -0,0 +1,601 @@
+#include "FroxelFog.h"
+#include "CascadedShadowMaps.h"
+#include "ClusteredLightCuller.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// Shared by every pass. Slices are spaced exponentially between NearPlane and the far plane, so
+// froxels stay roughly cubic in world space
+const char* COMMON_SOURCE = R"(
+    cbuffer FogConstants : register(b0)
+    {
+        float4x4 InverseView;
+        float4x4 PreviousViewProjection;
+        float4x4 ShadowViewProjection[4];
+        float4 ShadowSplits;           // View depth where each cascade ends
+        float2 ProjectionScale;        // _11 and _22 of the projection
+        float DepthScale;              // _43
+        float DepthOffset;             // _33
+        uint3 VolumeSize;
+        uint ShadowCascades;
+        float NearPlane;
+        float LogDepthRange;           // log(far / near)
+        float Density;
+        float HeightDensity;
+        float3 Albedo;
+        float FogHeight;
+        float3 Ambient;
+        float HeightFalloff;
+        float3 Jitter;                 // In froxels, centered on 0
+        float Anisotropy;
+        float BlendWeight;
+        float3 Padding;
+    };
+
+    float SliceDepth(float w)
+    {
+        return NearPlane * exp(w * LogDepthRange);
+    }
+
+    float DepthToSlice(float z)
+    {
+        return log(max(z, 1e-4f) / NearPlane) / LogDepthRange;
+    }
+
+    // uv spans the viewport
+    float3 ViewPosition(float2 uv, float z)
+    {
+        float2 ndc = uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+        return float3(ndc / ProjectionScale * z, z);
+    }
+)";
+
+// Density and in-scattered light at a jittered point in every froxel, blended with the
+// reprojected history. Lights come from the clustered light lists (ClusteredLightCuller)
+const char* INJECT_SHADER = R"(
+    Texture2DArray<float> ShadowMap : register(t0);
+    Texture3D<float4> History : register(t1);
+    SamplerState LinearClamp : register(s0);
+    SamplerComparisonState ShadowCompare : register(s1);
+    RWTexture3D<float4> Scattering : register(u0);
+
+    // Must match ClusteredLightCuller
+    struct ClusterLight {
+        float3 position;
+        float range;
+        float3 color;
+        float spotScale;
+        float3 direction;
+        float spotOffset;
+    };
+    StructuredBuffer<ClusterLight> ClusterLights : register(t10);
+    Buffer<uint2> ClusterRanges : register(t11);
+    Buffer<uint> ClusterLightIndices : register(t12);
+
+    cbuffer ClusterBuffer : register(b2)
+    {
+        float4x4 ClusterView;
+        float2 ClusterTileScale;
+        float ClusterSliceScale;
+        float ClusterSliceBias;
+        uint DirectionalLightCount;
+    };
+
+    #define CLUSTER_GRID_X 16
+    #define CLUSTER_GRID_Y 9
+    #define CLUSTER_GRID_Z 24
+    #define PI 3.14159265f
+
+    float Phase(float cosTheta)
+    {
+        float g2 = Anisotropy * Anisotropy;
+        return (1.0f - g2) / (4.0f * PI * pow(max(1.0f + g2 - 2.0f * Anisotropy * cosTheta, 1e-4f), 1.5f));
+    }
+
+    float SunVisibility(float3 world, float z)
+    {
+        [loop] for (uint i = 0; i < ShadowCascades; ++i) {
+            if (z > ShadowSplits[i]) continue;
+            float3 shadow = mul(float4(world, 1.0f), ShadowViewProjection[i]).xyz;
+            float2 uv = shadow.xy * float2(0.5f, -0.5f) + 0.5f;
+            if (any(uv < 0.0f) || any(uv > 1.0f) || shadow.z > 1.0f) continue;
+            return ShadowMap.SampleCmpLevelZero(ShadowCompare, float3(uv, i), shadow.z);
+        }
+        return 1.0f;
+    }
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id >= VolumeSize)) return;
+
+        float3 size = float3(VolumeSize);
+        float3 jittered = (float3(id) + 0.5f + Jitter) / size;
+        float z = SliceDepth(jittered.z);
+        float3 world = mul(float4(ViewPosition(jittered.xy, z), 1.0f), InverseView).xyz;
+        float3 viewRay = normalize(world - InverseView[3].xyz);
+
+        float extinction = Density + HeightDensity * exp(-HeightFalloff * max(world.y - FogHeight, 0.0f));
+
+        float3 radiance = Ambient;
+        for (uint d = 0; d < DirectionalLightCount; ++d) {
+            ClusterLight sun = ClusterLights[d];
+            float visibility = d == 0 ? SunVisibility(world, z) : 1.0f;
+            radiance += sun.color * (Phase(dot(-sun.direction, viewRay)) * visibility);
+        }
+
+        // The froxel grid spans the same screen as the cluster tiles
+        uint2 tile = min(uint2(jittered.xy * float2(CLUSTER_GRID_X, CLUSTER_GRID_Y)), uint2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+        uint slice = min(uint(max(log(z) * ClusterSliceScale + ClusterSliceBias, 0.0f)), CLUSTER_GRID_Z - 1);
+        uint2 range = ClusterRanges[(slice * CLUSTER_GRID_Y + tile.y) * CLUSTER_GRID_X + tile.x];
+        for (uint i = 0; i < range.y; ++i) {
+            ClusterLight local = ClusterLights[ClusterLightIndices[range.x + i]];
+            float3 toLight = local.position - world;
+            float distanceSq = max(dot(toLight, toLight), 1e-4f);
+            float3 L = toLight * rsqrt(distanceSq);
+            float window = saturate(1.0f - pow(distanceSq / (local.range * local.range), 2.0f));
+            float attenuation = window * window / max(distanceSq, 0.01f);
+            attenuation *= saturate(dot(-L, local.direction) * local.spotScale + local.spotOffset);
+            radiance += local.color * (attenuation * Phase(dot(L, viewRay)));
+        }
+
+        float4 current = float4(radiance * Albedo * extinction, extinction);
+        if (BlendWeight < 1.0f) {
+            // History is looked up at the froxel center; the jitter is what it averages over
+            float3 center = (float3(id) + 0.5f) / size;
+            float3 centerWorld = mul(float4(ViewPosition(center.xy, SliceDepth(center.z)), 1.0f), InverseView).xyz;
+            float4 previous = mul(float4(centerWorld, 1.0f), PreviousViewProjection);
+            if (previous.w > 0.0f) {
+                // previous.w is the point's view depth last frame
+                float3 uvw = float3(previous.xy / previous.w * float2(0.5f, -0.5f) + 0.5f, DepthToSlice(previous.w));
+                if (all(uvw >= 0.0f) && all(uvw <= 1.0f)) {
+                    current = lerp(History.SampleLevel(LinearClamp, uvw, 0), current, BlendWeight);
+                }
+            }
+        }
+        Scattering[id] = current;
+    }
+)";
+
+// One thread per column, front to back. Each slice's in-scattering is integrated analytically
+// against its own extinction (Hillaire 2015), which stays energy conserving for thick slices
+const char* INTEGRATE_SHADER = R"(
+    Texture3D<float4> Scattering : register(t0);
+    RWTexture3D<float4> Integrated : register(u0);
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= VolumeSize.xy)) return;
+
+        // Off-axis rays cover more distance per unit of view depth
+        float2 uv = (float2(id.xy) + 0.5f) / float2(VolumeSize.xy);
+        float rayScale = length(float3((uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f)) / ProjectionScale, 1.0f));
+
+        float3 scattered = 0.0f;
+        float transmittance = 1.0f;
+        float sliceStart = 0.0f;
+        for (uint z = 0; z < VolumeSize.z; ++z) {
+            float sliceEnd = SliceDepth(float(z + 1) / float(VolumeSize.z));
+            float thickness = (sliceEnd - sliceStart) * rayScale;
+            sliceStart = sliceEnd;
+
+            float4 froxel = Scattering.Load(int4(id.xy, z, 0));
+            float extinction = max(froxel.a, 1e-6f);
+            float sliceTransmittance = exp(-extinction * thickness);
+            scattered += transmittance * froxel.rgb * ((1.0f - sliceTransmittance) / extinction);
+            transmittance *= sliceTransmittance;
+            Integrated[uint3(id.xy, z)] = float4(scattered, transmittance);
+        }
+    }
+)";
+
+// Fullscreen triangle, uv spans the viewport
+const char* FULLSCREEN_VS = R"(
+struct Output
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+Output main(uint id : SV_VertexID)
+{
+    Output output;
+    output.uv = float2((id << 1) & 2, id & 2);
+    output.position = float4(output.uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+    return output;
+}
+)";
+
+// Outputs in-scattering and transmittance; the blend state computes scene * a + rgb
+const char* COMPOSITE_PS = R"(
+    Texture2D<float> Depth : register(t0);
+    Texture3D<float4> Integrated : register(t1);
+    SamplerState LinearClamp : register(s0);
+
+    float4 main(float4 position : SV_POSITION, float2 uv : TEXCOORD0) : SV_TARGET
+    {
+        float depth = Depth.Load(int3(position.xy, 0));
+        // The sky takes the fog of the last slice
+        float z = depth >= 1.0f ? SliceDepth(1.0f) : DepthScale / (depth - DepthOffset);
+        // Texel z holds the far end of its slice
+        float w = DepthToSlice(z) - 0.5f / float(VolumeSize.z);
+        return Integrated.SampleLevel(LinearClamp, float3(uv, w), 0);
+    }
+)";
+
+// Matches FogConstants above
+struct GpuFogConstants {
+    DirectX::XMFLOAT4X4 inverseView;
+    DirectX::XMFLOAT4X4 previousViewProjection;
+    DirectX::XMFLOAT4X4 shadowViewProjection[CascadedShadowMaps::MAX_CASCADES];
+    float shadowSplits[CascadedShadowMaps::MAX_CASCADES];
+    float projectionScale[2];
+    float depthScale;
+    float depthOffset;
+    UINT volumeSize[3];
+    UINT shadowCascades;
+    float nearPlane;
+    float logDepthRange;
+    float density;
+    float heightDensity;
+    DirectX::XMFLOAT3 albedo;
+    float fogHeight;
+    DirectX::XMFLOAT3 ambient;
+    float heightFalloff;
+    float jitter[3];
+    float anisotropy;
+    float blendWeight;
+    float padding[3];
+};
+
+constexpr UINT GROUP_SIZE = 8;
+constexpr UINT MAX_VOLUME_SIZE = 256;
+constexpr UINT JITTER_PERIOD = 16;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3DBlob* CompileShader(const std::string& source, const char* name, const char* target) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+ID3D11ComputeShader* CompileComputeShader(ID3D11Device* device, const char* source, const char* name) {
+    ID3DBlob* blob = CompileShader(std::string(COMMON_SOURCE) + source, name, "cs_5_0");
+    if (!blob) return nullptr;
+    ID3D11ComputeShader* shader = nullptr;
+    HRESULT hr = device->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &shader);
+    blob->Release();
+    return SUCCEEDED(hr) ? shader : nullptr;
+}
+
+float Halton(UINT index, UINT base) {
+    float result = 0.0f;
+    float fraction = 1.0f;
+    while (index > 0) {
+        fraction /= static_cast<float>(base);
+        result += fraction * static_cast<float>(index % base);
+        index /= base;
+    }
+    return result;
+}
+
+bool CreateVolume(ID3D11Device* device, UINT width, UINT height, UINT depth, ID3D11Texture3D** texture,
+                  ID3D11ShaderResourceView** view, ID3D11UnorderedAccessView** target) {
+    D3D11_TEXTURE3D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.Depth = depth;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    if (FAILED(device->CreateTexture3D(&desc, nullptr, texture))) return false;
+    if (FAILED(device->CreateShaderResourceView(*texture, nullptr, view))) return false;
+    return SUCCEEDED(device->CreateUnorderedAccessView(*texture, nullptr, target));
+}
+
+} // namespace
+
+FroxelFog::FroxelFog()
+    : device_(nullptr)
+    , context_(nullptr)
+    , injectShader_(nullptr)
+    , integrateShader_(nullptr)
+    , fullscreenShader_(nullptr)
+    , compositeShader_(nullptr)
+    , constants_(nullptr)
+    , linearClamp_(nullptr)
+    , shadowCompare_(nullptr)
+    , compositeBlend_(nullptr)
+    , rasterizerState_(nullptr)
+    , depthState_(nullptr)
+    , scattering_{}
+    , scatteringViews_{}
+    , scatteringTargets_{}
+    , historyIndex_(0)
+    , historyValid_(false)
+    , integrated_(nullptr)
+    , integratedView_(nullptr)
+    , integratedTarget_(nullptr)
+    , frame_(0)
+{
+    DirectX::XMStoreFloat4x4(&previousViewProjection_, DirectX::XMMatrixIdentity());
+    DirectX::XMStoreFloat4x4(&projection_, DirectX::XMMatrixIdentity());
+}
+
+FroxelFog::~FroxelFog() {
+    Shutdown();
+}
+
+bool FroxelFog::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings) {
+    Shutdown();
+    if (!device || !context) return false;
+
+    device_ = device;
+    context_ = context;
+    if (!CreateShaders() || !SetSettings(settings)) {
+        Logger::Error("Failed to create froxel fog resources");
+        Shutdown();
+        return false;
+    }
+    Logger::Info("Froxel fog initialized: " + std::to_string(settings_.width) + "x" +
+                 std::to_string(settings_.height) + "x" + std::to_string(settings_.depth));
+    return true;
+}
+
+void FroxelFog::Shutdown() {
+    SafeRelease(injectShader_);
+    SafeRelease(integrateShader_);
+    SafeRelease(fullscreenShader_);
+    SafeRelease(compositeShader_);
+    SafeRelease(constants_);
+    SafeRelease(linearClamp_);
+    SafeRelease(shadowCompare_);
+    SafeRelease(compositeBlend_);
+    SafeRelease(rasterizerState_);
+    SafeRelease(depthState_);
+    ReleaseVolumes();
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+bool FroxelFog::SetSettings(const Settings& settings) {
+    const bool resize = !integrated_ || settings.width != settings_.width || settings.height != settings_.height ||
+                        settings.depth != settings_.depth;
+    settings_ = settings;
+    settings_.width = std::clamp(settings_.width, 1u, MAX_VOLUME_SIZE);
+    settings_.height = std::clamp(settings_.height, 1u, MAX_VOLUME_SIZE);
+    settings_.depth = std::clamp(settings_.depth, 1u, MAX_VOLUME_SIZE);
+    settings_.nearPlane = std::max(settings_.nearPlane, 0.01f);
+    settings_.farPlane = std::max(settings_.farPlane, settings_.nearPlane * 2.0f);
+    settings_.density = std::max(settings_.density, 0.0f);
+    settings_.heightDensity = std::max(settings_.heightDensity, 0.0f);
+    settings_.anisotropy = std::clamp(settings_.anisotropy, -0.95f, 0.95f);
+    if (!resize || !device_) return true;
+
+    ReleaseVolumes();
+    return CreateVolumes();
+}
+
+bool FroxelFog::CreateShaders() {
+    injectShader_ = CompileComputeShader(device_, INJECT_SHADER, "FroxelFogInject");
+    integrateShader_ = CompileComputeShader(device_, INTEGRATE_SHADER, "FroxelFogIntegrate");
+    if (!injectShader_ || !integrateShader_) return false;
+
+    ID3DBlob* blob = CompileShader(FULLSCREEN_VS, "FroxelFog_VS", "vs_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &fullscreenShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(std::string(COMMON_SOURCE) + COMPOSITE_PS, "FroxelFogComposite_PS", "ps_5_0");
+    if (!blob) return false;
+    hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &compositeShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = sizeof(GpuFogConstants);
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&bufferDesc, nullptr, &constants_))) return false;
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (FAILED(device_->CreateSamplerState(&samplerDesc, &linearClamp_))) return false;
+
+    // Filtered compare; the fog averages so much that one bilinear tap is enough
+    samplerDesc.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_LESS_EQUAL;
+    if (FAILED(device_->CreateSamplerState(&samplerDesc, &shadowCompare_))) return false;
+
+    // scene * transmittance + in-scattering, destination alpha untouched
+    D3D11_BLEND_DESC blendDesc = {};
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    if (FAILED(device_->CreateBlendState(&blendDesc, &compositeBlend_))) return false;
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizerDesc, &rasterizerState_))) return false;
+
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = FALSE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+    return SUCCEEDED(device_->CreateDepthStencilState(&depthDesc, &depthState_));
+}
+
+bool FroxelFog::CreateVolumes() {
+    historyValid_ = false;
+    for (UINT i = 0; i < 2; ++i) {
+        if (!CreateVolume(device_, settings_.width, settings_.height, settings_.depth, &scattering_[i],
+                          &scatteringViews_[i], &scatteringTargets_[i])) {
+            return false;
+        }
+    }
+    return CreateVolume(device_, settings_.width, settings_.height, settings_.depth, &integrated_, &integratedView_,
+                        &integratedTarget_);
+}
+
+void FroxelFog::ReleaseVolumes() {
+    for (UINT i = 0; i < 2; ++i) {
+        SafeRelease(scatteringTargets_[i]);
+        SafeRelease(scatteringViews_[i]);
+        SafeRelease(scattering_[i]);
+    }
+    SafeRelease(integratedTarget_);
+    SafeRelease(integratedView_);
+    SafeRelease(integrated_);
+    historyValid_ = false;
+}
+
+void FroxelFog::Render(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, const ClusteredLightCuller* lights,
+                       const CascadedShadowMaps* shadows) {
+    if (!device_ || !integrated_) return;
+    NEXUS_PROFILE_SCOPE("FroxelFog::Render");
+
+    DirectX::XMStoreFloat4x4(&projection_, projection);
+
+    GpuFogConstants constants = {};
+    DirectX::XMStoreFloat4x4(&constants.inverseView, DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, view)));
+    DirectX::XMStoreFloat4x4(&constants.previousViewProjection,
+                             DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&previousViewProjection_)));
+    ID3D11ShaderResourceView* shadowMap = shadows ? shadows->GetShadowMap() : nullptr;
+    if (shadowMap) {
+        constants.shadowCascades = std::min(shadows->GetCascadeCount(), CascadedShadowMaps::MAX_CASCADES);
+        for (UINT i = 0; i < constants.shadowCascades; ++i) {
+            DirectX::XMStoreFloat4x4(&constants.shadowViewProjection[i],
+                                     DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&shadows->GetCascadeViewProjection(i))));
+            constants.shadowSplits[i] = shadows->GetSplitDistance(i);
+        }
+    }
+    constants.projectionScale[0] = projection_._11;
+    constants.projectionScale[1] = projection_._22;
+    constants.depthScale = projection_._43;
+    constants.depthOffset = projection_._33;
+    constants.volumeSize[0] = settings_.width;
+    constants.volumeSize[1] = settings_.height;
+    constants.volumeSize[2] = settings_.depth;
+    constants.nearPlane = settings_.nearPlane;
+    constants.logDepthRange = std::log(settings_.farPlane / settings_.nearPlane);
+    constants.density = settings_.density;
+    constants.heightDensity = settings_.heightDensity;
+    constants.albedo = settings_.albedo;
+    constants.fogHeight = settings_.fogHeight;
+    constants.ambient = settings_.ambient;
+    constants.heightFalloff = std::max(settings_.heightFalloff, 0.0f);
+    const UINT jitterIndex = frame_++ % JITTER_PERIOD + 1;
+    constants.jitter[0] = Halton(jitterIndex, 2) - 0.5f;
+    constants.jitter[1] = Halton(jitterIndex, 3) - 0.5f;
+    constants.jitter[2] = Halton(jitterIndex, 5) - 0.5f;
+    constants.anisotropy = settings_.anisotropy;
+    constants.blendWeight = historyValid_ ? std::clamp(settings_.temporalBlend, 0.01f, 1.0f) : 1.0f;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+
+    context_->CSSetConstantBuffers(0, 1, &constants_);
+    ID3D11SamplerState* samplers[2] = { linearClamp_, shadowCompare_ };
+    context_->CSSetSamplers(0, 2, samplers);
+    if (lights) {
+        lights->BindCompute();
+    }
+
+    const UINT groupsX = (settings_.width + GROUP_SIZE - 1) / GROUP_SIZE;
+    const UINT groupsY = (settings_.height + GROUP_SIZE - 1) / GROUP_SIZE;
+    const UINT next = historyIndex_ ^ 1;
+    ID3D11ShaderResourceView* injectViews[2] = { shadowMap, scatteringViews_[historyIndex_] };
+    context_->CSSetShader(injectShader_, nullptr, 0);
+    context_->CSSetShaderResources(0, 2, injectViews);
+    context_->CSSetUnorderedAccessViews(0, 1, &scatteringTargets_[next], nullptr);
+    context_->Dispatch(groupsX, groupsY, settings_.depth);
+
+    // Unbind before the scattering volume is read back
+    ID3D11ShaderResourceView* nullViews[2] = {};
+    ID3D11UnorderedAccessView* nullTarget = nullptr;
+    context_->CSSetShaderResources(0, 2, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+
+    context_->CSSetShader(integrateShader_, nullptr, 0);
+    context_->CSSetShaderResources(0, 1, &scatteringViews_[next]);
+    context_->CSSetUnorderedAccessViews(0, 1, &integratedTarget_, nullptr);
+    context_->Dispatch(groupsX, groupsY, 1);
+
+    context_->CSSetShaderResources(0, 1, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+    context_->CSSetShader(nullptr, nullptr, 0);
+
+    historyIndex_ = next;
+    DirectX::XMStoreFloat4x4(&previousViewProjection_, view * projection);
+    historyValid_ = true;
+}
+
+void FroxelFog::Composite(StateCache& stateCache, ID3D11ShaderResourceView* depth, ID3D11RenderTargetView* target,
+                          UINT width, UINT height) {
+    if (!device_ || !depth || !target || width == 0 || height == 0 || !historyValid_) return;
+    NEXUS_PROFILE_SCOPE("FroxelFog::Composite");
+
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = static_cast<float>(width);
+    viewport.Height = static_cast<float>(height);
+    viewport.MaxDepth = 1.0f;
+    stateCache.OMSetRenderTargets(1, &target, nullptr);
+    stateCache.RSSetViewports(1, &viewport);
+    stateCache.RSSetState(rasterizerState_);
+    stateCache.OMSetBlendState(compositeBlend_, nullptr, 0xffffffff);
+    stateCache.OMSetDepthStencilState(depthState_, 0);
+    stateCache.IASetInputLayout(nullptr);
+    stateCache.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    stateCache.VSSetShader(fullscreenShader_);
+    stateCache.PSSetShader(compositeShader_);
+    stateCache.PSSetConstantBuffers(0, 1, &constants_);
+    ID3D11ShaderResourceView* views[2] = { depth, integratedView_ };
+    stateCache.PSSetShaderResources(0, 2, views);
+    stateCache.PSSetSamplers(0, 1, &linearClamp_);
+    context_->Draw(3, 0);
+
+    // Depth is bound for output again by the next scene pass
+    ID3D11ShaderResourceView* nullViews[2] = {};
+    stateCache.PSSetShaderResources(0, 2, nullViews);
+    stateCache.OMSetBlendState(nullptr, nullptr, 0xffffffff);
+}
+
+} // namespace Nexus
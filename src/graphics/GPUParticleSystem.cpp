@@ -0,0 +1,1523 @@
+#include "ParticleSystem.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "Texture.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// Shared by every kernel and the render shaders; 64 bytes so slots stay aligned
+const char* PARTICLE_SOURCE = R"(
+    struct Particle
+    {
+        float3 position;
+        float life;
+        float3 velocity;
+        float inverseMaxLife;
+        float4 color;
+        float2 size;
+        float rotation;
+        float angularVelocity;
+    };
+)";
+
+const char* SIMULATION_SOURCE = R"(
+    #define SHAPE_SPHERE 1
+    #define SHAPE_BOX 2
+    #define SHAPE_CIRCLE 4
+
+    #define FORCE_CONSTANT 0
+    #define FORCE_RADIAL 1
+    #define FORCE_VORTEX 2
+    #define FORCE_TURBULENCE 3
+
+    #define CURVE_COLOR 1
+    #define CURVE_SIZE 2
+    #define CURVE_SAMPLES 64
+
+    #define SORT_GROUP_SIZE 512
+    #define SORT_BLOCK 1024                // Elements a sort group holds in shared memory
+
+    cbuffer SimulationConstants : register(b0)
+    {
+        float4x4 ViewProjection;
+        float4x4 InverseViewProjection;
+        float4 Viewport;                   // Depth region: x, y, width, height in texels
+        float3 EmitterPosition;
+        uint EmitCount;
+        float3 ShapeScale;
+        uint Shape;
+        float3 StartVelocity;
+        float StartLifetime;
+        float3 VelocityVariation;
+        float LifetimeVariation;
+        float4 StartColor;
+        float4 ColorVariation;
+        float2 StartSize;
+        float2 SizeVariation;
+        float StartRotation;
+        float RotationVariation;
+        float AngularVelocity;
+        uint Seed;
+        float3 Gravity;                    // Constant force folded in as an acceleration
+        float Drag;
+        float3 CameraPosition;
+        float DeltaTime;
+        float Bounciness;
+        float Friction;
+        float InverseMass;
+        uint ForceCount;
+        float NoiseStrength;
+        float NoiseFrequency;
+        uint UseDepth;
+        uint CurveFlags;
+        float3 CameraForward;
+        uint TrailPoints;                  // History kept per particle slot; 0 without trails
+        uint TrailHead;                    // Point this step writes; older ones follow backwards
+        uint TrailReset;                   // Fill every point with the current position
+        float2 TrailPadding;
+        float4 ForcePosition[8];           // xyz, radius (0 reaches everywhere)
+        float4 ForceDirection[8];          // xyz, strength
+        float4 ForceShape[8];              // Type, falloff
+    };
+
+    // Elements the sort covers for count particles: a power of two, at least one block
+    uint SortCount(uint count)
+    {
+        return count <= SORT_BLOCK ? SORT_BLOCK : 1u << (firstbithigh(count - 1) + 1);
+    }
+)";
+
+const char* EMIT_SHADER = R"(
+    RWStructuredBuffer<Particle> Particles : register(u0);
+    ConsumeStructuredBuffer<uint> DeadList : register(u1);
+    AppendStructuredBuffer<uint> AliveList : register(u2);
+    RWStructuredBuffer<float4> Trails : register(u3);
+    ByteAddressBuffer Counters : register(t0);
+
+    uint NextRandom(inout uint state)
+    {
+        state = state * 747796405u + 2891336453u;
+        uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        return (word >> 22u) ^ word;
+    }
+
+    float Random(inout uint state, float low, float high)
+    {
+        return lerp(low, high, (NextRandom(state) >> 8) * (1.0 / 16777216.0));
+    }
+
+    [numthreads(64, 1, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        // Never take more slots than the dead list holds
+        if (id.x >= min(EmitCount, Counters.Load(0))) return;
+
+        uint state = Seed ^ (id.x * 2654435761u);
+        NextRandom(state);
+
+        // Offset from the emitter by shape; ShapeScale is the radius or half extents
+        float3 offset = float3(0.0, 0.0, 0.0);
+        if (Shape == SHAPE_SPHERE)
+        {
+            float z = Random(state, -1.0, 1.0);
+            float angle = Random(state, 0.0, 6.2831853);
+            float ring = sqrt(1.0 - z * z);
+            float radius = ShapeScale.x * pow(Random(state, 0.0, 1.0), 1.0 / 3.0);
+            offset = float3(ring * cos(angle), z, ring * sin(angle)) * radius;
+        }
+        else if (Shape == SHAPE_BOX)
+        {
+            offset = float3(Random(state, -1.0, 1.0), Random(state, -1.0, 1.0), Random(state, -1.0, 1.0)) * ShapeScale;
+        }
+        else if (Shape == SHAPE_CIRCLE)
+        {
+            float angle = Random(state, 0.0, 6.2831853);
+            float radius = ShapeScale.x * sqrt(Random(state, 0.0, 1.0));
+            offset = float3(cos(angle) * radius, 0.0, sin(angle) * radius);
+        }
+
+        Particle particle;
+        particle.position = EmitterPosition + offset;
+        particle.velocity = StartVelocity +
+                            float3(Random(state, -1.0, 1.0), Random(state, -1.0, 1.0), Random(state, -1.0, 1.0)) * VelocityVariation;
+        particle.color = saturate(StartColor + float4(Random(state, -1.0, 1.0), Random(state, -1.0, 1.0),
+                                                      Random(state, -1.0, 1.0), Random(state, -1.0, 1.0)) * ColorVariation);
+        particle.size = max(StartSize + float2(Random(state, -1.0, 1.0), Random(state, -1.0, 1.0)) * SizeVariation, 0.0);
+        particle.rotation = StartRotation + Random(state, -1.0, 1.0) * RotationVariation;
+        particle.angularVelocity = AngularVelocity;
+        float maxLife = max(StartLifetime + Random(state, -1.0, 1.0) * LifetimeVariation, 0.001);
+        particle.life = maxLife;
+        particle.inverseMaxLife = 1.0 / maxLife;
+
+        uint index = DeadList.Consume();
+        Particles[index] = particle;
+        AliveList.Append(index);
+
+        // The slot's history is the last occupant's; a new trail starts collapsed on the particle
+        for (uint i = 0; i < TrailPoints; ++i)
+        {
+            Trails[index * TrailPoints + i] = float4(particle.position, 0.0);
+        }
+    }
+)";
+
+const char* ARGUMENTS_SHADER = R"(
+    ByteAddressBuffer Counters : register(t0);
+    RWByteAddressBuffer Arguments : register(u0);
+
+    // After the draw record: the simulation's dispatch, one thread per alive particle, then the
+    // sort's, one group per block of survivors, then the trail draw's vertices per particle
+    [numthreads(1, 1, 1)]
+    void main()
+    {
+        uint alive = Counters.Load(4);
+        Arguments.Store3(16, uint3((alive + 63) / 64, 1, 1));
+        Arguments.Store3(28, uint3(SortCount(Counters.Load(8)) / SORT_BLOCK, 1, 1));
+        Arguments.Store(40, TrailPoints > 1 ? (TrailPoints - 1) * 6 : 0);
+    }
+)";
+
+const char* SIMULATE_SHADER = R"(
+    #define COLLISION_THICKNESS 0.5
+
+    RWStructuredBuffer<Particle> Particles : register(u0);
+    AppendStructuredBuffer<uint> DeadList : register(u1);
+    AppendStructuredBuffer<uint> AliveOut : register(u2);
+    RWStructuredBuffer<float4> Trails : register(u3);
+    StructuredBuffer<uint> AliveIn : register(t0);
+    ByteAddressBuffer Counters : register(t1);
+    Texture2D<float> SceneDepth : register(t2);
+    Texture1DArray<float4> Curves : register(t3);   // Over lifetime: color; size, speed, spin
+    SamplerState CurveSampler : register(s0);
+
+    float Hash(int3 cell)
+    {
+        uint h = (asuint(cell.x) * 73856093u) ^ (asuint(cell.y) * 19349663u) ^ (asuint(cell.z) * 83492791u);
+        h = (h ^ (h >> 13)) * 1274126177u;
+        h ^= h >> 16;
+        return (h & 0xffffu) * (2.0 / 65535.0) - 1.0;
+    }
+
+    // Smooth value noise in [-1, 1]
+    float ValueNoise(float3 p)
+    {
+        float3 base = floor(p);
+        int3 cell = int3(base);
+        float3 f = p - base;
+        f = f * f * (3.0 - 2.0 * f);
+        float x00 = lerp(Hash(cell), Hash(cell + int3(1, 0, 0)), f.x);
+        float x10 = lerp(Hash(cell + int3(0, 1, 0)), Hash(cell + int3(1, 1, 0)), f.x);
+        float x01 = lerp(Hash(cell + int3(0, 0, 1)), Hash(cell + int3(1, 0, 1)), f.x);
+        float x11 = lerp(Hash(cell + int3(0, 1, 1)), Hash(cell + int3(1, 1, 1)), f.x);
+        return lerp(lerp(x00, x10, f.y), lerp(x01, x11, f.y), f.z);
+    }
+
+    float3 NoiseVector(float3 p)
+    {
+        return float3(ValueNoise(p), ValueNoise(p + float3(31.4, 0.0, 0.0)), ValueNoise(p + float3(0.0, 0.0, 47.2)));
+    }
+
+    float3 ForceAt(uint force, float3 position)
+    {
+        float3 offset = position - ForcePosition[force].xyz;
+        float distance = length(offset);
+        float radius = ForcePosition[force].w;
+        float weight = 1.0;
+        if (radius > 0.0)
+        {
+            if (distance >= radius) return (float3)0;
+            weight = pow(1.0 - distance / radius, ForceShape[force].y);
+        }
+
+        float strength = ForceDirection[force].w * weight;
+        uint type = (uint)ForceShape[force].x;
+        if (type == FORCE_CONSTANT)
+        {
+            return ForceDirection[force].xyz * strength;
+        }
+        if (type == FORCE_RADIAL)
+        {
+            return distance > 1e-5 ? offset * (strength / distance) : (float3)0;
+        }
+        if (type == FORCE_VORTEX)
+        {
+            float3 swirl = cross(ForceDirection[force].xyz, offset);
+            float swirlLength = length(swirl);
+            return swirlLength > 1e-5 ? swirl * (strength / swirlLength) : (float3)0;
+        }
+        if (type == FORCE_TURBULENCE)
+        {
+            return NoiseVector(position) * strength;
+        }
+        return (float3)0;
+    }
+
+    float3 Unproject(float2 pixel, float depth)
+    {
+        float2 ndc = (pixel - Viewport.xy) / Viewport.zw * float2(2.0, -2.0) + float2(-1.0, 1.0);
+        float4 world = mul(float4(ndc, depth, 1.0), InverseViewProjection);
+        return world.xyz / world.w;
+    }
+
+    // A particle that has just passed behind the visible surface goes back to where it was and
+    // bounces off the surface, whose normal is rebuilt from neighbouring depth samples. Anything
+    // further behind is hidden by the surface rather than inside it, so it is left alone
+    void CollideWithDepth(inout Particle particle, float3 previous)
+    {
+        float4 clip = mul(float4(particle.position, 1.0), ViewProjection);
+        if (clip.w <= 0.0) return;
+        float2 ndc = clip.xy / clip.w;
+        if (any(abs(ndc) >= 1.0)) return;
+
+        int2 texel = int2(Viewport.xy + (ndc * float2(0.5, -0.5) + 0.5) * Viewport.zw);
+        float depth = SceneDepth.Load(int3(texel, 0));
+        if (depth >= 1.0) return;
+
+        float3 surface = Unproject(texel + 0.5, depth);
+        float surfaceDistance = mul(float4(surface, 1.0), ViewProjection).w;
+        float thickness = max(COLLISION_THICKNESS, length(particle.velocity) * DeltaTime * 2.0);
+        if (clip.w < surfaceDistance || clip.w > surfaceDistance + thickness) return;
+
+        int2 last = int2(Viewport.xy + Viewport.zw) - 1;
+        int2 step = int2(texel.x < last.x ? 1 : -1, texel.y < last.y ? 1 : -1);
+        int2 texelX = texel + int2(step.x, 0);
+        int2 texelY = texel + int2(0, step.y);
+        float3 alongX = Unproject(texelX + 0.5, SceneDepth.Load(int3(texelX, 0))) - surface;
+        float3 alongY = Unproject(texelY + 0.5, SceneDepth.Load(int3(texelY, 0))) - surface;
+        float3 normal = cross(alongX, alongY);
+        float normalLength = length(normal);
+        if (normalLength < 1e-8) return;
+        normal /= normalLength;
+        if (dot(normal, CameraPosition - surface) < 0.0) normal = -normal;
+
+        // Reflect the normal speed by the bounciness, scale the rest by the friction
+        float normalSpeed = dot(particle.velocity, normal);
+        if (normalSpeed < 0.0)
+        {
+            float3 tangent = particle.velocity - normal * normalSpeed;
+            particle.velocity = tangent * (1.0 - Friction) - normal * (normalSpeed * Bounciness);
+        }
+        particle.position = previous;
+    }
+
+    [numthreads(64, 1, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (id.x >= Counters.Load(4)) return;
+        uint index = AliveIn[id.x];
+        Particle particle = Particles[index];
+
+        particle.life -= DeltaTime;
+        if (particle.life <= 0.0)
+        {
+            DeadList.Append(index);
+            return;
+        }
+
+        float3 acceleration = Gravity;
+        for (uint force = 0; force < ForceCount; ++force)
+        {
+            acceleration += ForceAt(force, particle.position) * InverseMass;
+        }
+        if (NoiseStrength > 0.0)
+        {
+            acceleration += NoiseVector(particle.position * NoiseFrequency) * NoiseStrength;
+        }
+
+        // Texel centres sit at the samples, so the sampler does the lerp between them
+        float u = (saturate(1.0 - particle.life * particle.inverseMaxLife) * (CURVE_SAMPLES - 1) + 0.5) / CURVE_SAMPLES;
+        float4 motion = Curves.SampleLevel(CurveSampler, float2(u, 1.0), 0);
+        if (CurveFlags & CURVE_COLOR) particle.color = Curves.SampleLevel(CurveSampler, float2(u, 0.0), 0);
+        if (CurveFlags & CURVE_SIZE) particle.size = motion.xy;
+
+        float3 previous = particle.position;
+        particle.velocity = (particle.velocity + acceleration * DeltaTime) * max(1.0 - Drag * DeltaTime, 0.0);
+        particle.position += particle.velocity * (DeltaTime * motion.z);
+        particle.rotation += particle.angularVelocity * (DeltaTime * motion.w);
+
+        if (UseDepth)
+        {
+            CollideWithDepth(particle, previous);
+        }
+
+        Particles[index] = particle;
+        AliveOut.Append(index);
+
+        // The head follows the particle until the ring moves on, leaving it behind as history
+        float4 recorded = float4(particle.position, 0.0);
+        uint first = index * TrailPoints;
+        if (TrailReset)
+        {
+            for (uint i = 0; i < TrailPoints; ++i) Trails[first + i] = recorded;
+        }
+        else if (TrailPoints > 0)
+        {
+            Trails[first + TrailHead] = recorded;
+        }
+    }
+)";
+
+// Bitonic sort of (key, slot) pairs by ascending key. Keys are the inverted bits of the view
+// depth, so the farthest particle comes first; slots past the survivors get the largest key
+// and end up behind them
+const char* SORT_SOURCE = R"(
+    cbuffer SortConstants : register(b1)
+    {
+        uint SortLevel;                    // Size of the bitonic sequences being merged
+        uint SortStep;                     // Distance between compared elements
+        uint2 SortPadding;
+    };
+
+    ByteAddressBuffer Counters : register(t2);
+    RWStructuredBuffer<uint2> SortKeys : register(u0);
+    groupshared uint2 Block[SORT_BLOCK];
+
+    // Orders the pair a thread owns at step within the block starting at element base
+    void CompareInBlock(uint thread, uint base, uint level, uint step)
+    {
+        uint first = (thread / step) * step * 2 + thread % step;
+        uint second = first + step;
+        bool ascending = ((base + first) & level) == 0;
+        uint2 a = Block[first];
+        uint2 b = Block[second];
+        if ((a.x > b.x) == ascending)
+        {
+            Block[first] = b;
+            Block[second] = a;
+        }
+    }
+)";
+
+const char* SORT_KEYS_SHADER = R"(
+    StructuredBuffer<Particle> Particles : register(t0);
+    StructuredBuffer<uint> AliveList : register(t1);
+
+    uint2 MakeKey(uint element, uint alive)
+    {
+        if (element >= alive) return uint2(0xffffffff, 0);
+        uint slot = AliveList[element];
+        float depth = max(dot(Particles[slot].position - CameraPosition, CameraForward), 0.0);
+        return uint2(min(~asuint(depth), 0xfffffffe), slot);
+    }
+
+    // Builds the keys and sorts each block completely in shared memory
+    [numthreads(SORT_GROUP_SIZE, 1, 1)]
+    void main(uint3 group : SV_GroupID, uint thread : SV_GroupIndex)
+    {
+        uint alive = Counters.Load(8);
+        uint base = group.x * SORT_BLOCK;
+        Block[thread] = MakeKey(base + thread, alive);
+        Block[thread + SORT_GROUP_SIZE] = MakeKey(base + thread + SORT_GROUP_SIZE, alive);
+        GroupMemoryBarrierWithGroupSync();
+
+        for (uint level = 2; level <= SORT_BLOCK; level <<= 1)
+        {
+            for (uint step = level >> 1; step > 0; step >>= 1)
+            {
+                CompareInBlock(thread, base, level, step);
+                GroupMemoryBarrierWithGroupSync();
+            }
+        }
+
+        SortKeys[base + thread] = Block[thread];
+        SortKeys[base + thread + SORT_GROUP_SIZE] = Block[thread + SORT_GROUP_SIZE];
+    }
+)";
+
+const char* SORT_MERGE_GLOBAL_SHADER = R"(
+    // One step of a merge whose pairs lie in different blocks
+    [numthreads(SORT_GROUP_SIZE, 1, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (SortLevel > SortCount(Counters.Load(8))) return;
+        uint first = (id.x / SortStep) * SortStep * 2 + id.x % SortStep;
+        uint second = first + SortStep;
+        bool ascending = (first & SortLevel) == 0;
+        uint2 a = SortKeys[first];
+        uint2 b = SortKeys[second];
+        if ((a.x > b.x) == ascending)
+        {
+            SortKeys[first] = b;
+            SortKeys[second] = a;
+        }
+    }
+)";
+
+const char* SORT_MERGE_LOCAL_SHADER = R"(
+    // The remaining steps of a merge, once its pairs fall within a block
+    [numthreads(SORT_GROUP_SIZE, 1, 1)]
+    void main(uint3 group : SV_GroupID, uint thread : SV_GroupIndex)
+    {
+        bool active = SortLevel <= SortCount(Counters.Load(8));
+        uint base = group.x * SORT_BLOCK;
+        if (active)
+        {
+            Block[thread] = SortKeys[base + thread];
+            Block[thread + SORT_GROUP_SIZE] = SortKeys[base + thread + SORT_GROUP_SIZE];
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        for (uint step = SORT_GROUP_SIZE; step > 0; step >>= 1)
+        {
+            if (active) CompareInBlock(thread, base, SortLevel, step);
+            GroupMemoryBarrierWithGroupSync();
+        }
+
+        if (active)
+        {
+            SortKeys[base + thread] = Block[thread];
+            SortKeys[base + thread + SORT_GROUP_SIZE] = Block[thread + SORT_GROUP_SIZE];
+        }
+    }
+)";
+
+const char* RENDER_SOURCE = R"(
+    cbuffer RenderConstants : register(b0)
+    {
+        float4x4 ViewProjection;
+        float3 CameraPosition;
+        uint AlignToVelocity;
+        float3 CameraRight;
+        float StretchTime;                 // Velocity aligned quads grow by their speed times this
+        float3 CameraUp;
+        uint UseTexture;
+        uint UseSortedList;
+        uint TrailPoints;                  // Set for the trail draw only
+        uint TrailHead;
+        float TrailWidth;                  // 0 follows the particle size
+        float4 TrailColor;
+        uint TrailTaper;                   // Narrow to nothing at the tail
+        float MotionTime;                  // Step the particles moved by since last frame
+        uint2 RenderPadding;
+    };
+
+    struct VSOutput
+    {
+        float4 position : SV_POSITION;
+        float4 color : COLOR;
+        float2 uv : TEXCOORD0;
+        noperspective float2 motion : TEXCOORD1;
+    };
+
+    // Screen motion in uv for TemporalAA's velocity target; both ends use this frame's camera,
+    // which leaves the camera's own motion to the resolve
+    float2 ScreenMotion(float4 current, float3 previousPosition)
+    {
+        float4 previous = mul(float4(previousPosition, 1.0), ViewProjection);
+        return (current.xy / current.w - previous.xy / previous.w) * float2(0.5, -0.5);
+    }
+)";
+
+const char* RENDER_VS = R"(
+    StructuredBuffer<Particle> Particles : register(t0);
+    StructuredBuffer<uint> AliveList : register(t1);
+    StructuredBuffer<uint2> SortedList : register(t2);
+
+    static const float2 CORNERS[6] =
+    {
+        float2(-1.0, -1.0), float2(-1.0, 1.0), float2(1.0, 1.0),
+        float2(-1.0, -1.0), float2(1.0, 1.0), float2(1.0, -1.0)
+    };
+
+    // Six vertices per instance, one instance per alive particle, back to front when sorted
+    VSOutput main(uint vertex : SV_VertexID, uint instance : SV_InstanceID)
+    {
+        Particle particle = Particles[UseSortedList ? SortedList[instance].y : AliveList[instance]];
+        float2 corner = CORNERS[vertex];
+        float2 extent = particle.size * 0.5;
+        float3 right = CameraRight;
+        float3 up = CameraUp;
+
+        float speed = length(particle.velocity);
+        if (AlignToVelocity && speed > 1e-4)
+        {
+            // Long axis along the velocity, turned towards the camera as far as it allows
+            up = particle.velocity / speed;
+            float3 side = cross(up, CameraPosition - particle.position);
+            float sideLength = length(side);
+            right = sideLength > 1e-4 ? side / sideLength : CameraRight;
+            extent.y += speed * StretchTime * 0.5;
+        }
+
+        float2 offset = corner * extent;
+        if (!AlignToVelocity)
+        {
+            float s, c;
+            sincos(particle.rotation, s, c);
+            offset = float2(offset.x * c - offset.y * s, offset.x * s + offset.y * c);
+        }
+
+        VSOutput output;
+        float3 position = particle.position + right * offset.x + up * offset.y;
+        output.position = mul(float4(position, 1.0), ViewProjection);
+        output.color = particle.color;
+        output.uv = corner * float2(0.5, -0.5) + 0.5;
+        output.motion = ScreenMotion(output.position, position - particle.velocity * MotionTime);
+        return output;
+    }
+)";
+
+const char* TRAIL_VS = R"(
+    StructuredBuffer<Particle> Particles : register(t0);
+    StructuredBuffer<uint> AliveList : register(t1);
+    StructuredBuffer<uint2> SortedList : register(t2);
+    StructuredBuffer<float4> Trails : register(t3);
+
+    static const float2 CORNERS[6] =
+    {
+        float2(0.0, -1.0), float2(0.0, 1.0), float2(1.0, 1.0),
+        float2(0.0, -1.0), float2(1.0, 1.0), float2(1.0, -1.0)
+    };
+
+    float3 TrailPoint(uint first, uint age)
+    {
+        return Trails[first + (TrailHead + TrailPoints - age) % TrailPoints].xyz;
+    }
+
+    // Six vertices per segment, one instance per alive particle. Point 0 is the newest; each
+    // vertex turns to the camera around the trail's direction there, so segments share edges
+    VSOutput main(uint vertex : SV_VertexID, uint instance : SV_InstanceID)
+    {
+        uint index = UseSortedList ? SortedList[instance].y : AliveList[instance];
+        Particle particle = Particles[index];
+        uint first = index * TrailPoints;
+        float2 corner = CORNERS[vertex % 6];
+        uint age = vertex / 6 + (uint)corner.x;
+        float3 position = TrailPoint(first, age);
+        float3 along = TrailPoint(first, age > 0 ? age - 1 : 0) - TrailPoint(first, min(age + 1, TrailPoints - 1));
+        float3 side = cross(along, CameraPosition - position);
+        float sideLength = length(side);
+        side = sideLength > 1e-6 ? side / sideLength : (float3)0;
+
+        float fade = 1.0 - (float)age / (float)(TrailPoints - 1);
+        float width = (TrailWidth > 0.0 ? TrailWidth : particle.size.x) * (TrailTaper ? fade : 1.0);
+
+        VSOutput output;
+        output.position = mul(float4(position + side * (corner.y * width * 0.5), 1.0), ViewProjection);
+        output.color = particle.color * TrailColor;
+        output.color.a *= fade;
+        output.uv = float2(1.0 - fade, corner.y * -0.5 + 0.5);
+        output.motion = 0.0;
+        return output;
+    }
+)";
+
+const char* RENDER_PS = R"(
+    Texture2D ParticleTexture : register(t0);
+    SamplerState LinearSampler : register(s0);
+
+    struct PSOutput
+    {
+        float4 color : SV_TARGET0;
+        float4 motion : SV_TARGET1;        // Blended by the sprite's coverage; unused without a second target
+    };
+
+    PSOutput main(VSOutput input)
+    {
+        float4 color = input.color;
+        if (UseTexture)
+        {
+            color *= ParticleTexture.Sample(LinearSampler, input.uv);
+        }
+        else
+        {
+            // Soft round sprite, or a ribbon soft across its width
+            float2 d = input.uv * 2.0 - 1.0;
+            color.a *= saturate(1.0 - (TrailPoints > 0 ? d.y * d.y : dot(d, d)));
+        }
+
+        PSOutput output;
+        output.color = color;
+        output.motion = float4(input.motion, 0.0, color.a);
+        return output;
+    }
+)";
+
+constexpr size_t GPU_CURVE_SAMPLES = 64;
+constexpr UINT CURVE_COLOR = 1;
+constexpr UINT CURVE_SIZE = 2;
+constexpr UINT DISPATCH_ARGUMENTS_OFFSET = 4 * sizeof(UINT);   // After the DrawInstanced record
+constexpr UINT SORT_ARGUMENTS_OFFSET = 7 * sizeof(UINT);       // After the simulation's Dispatch record
+constexpr UINT TRAIL_ARGUMENTS_OFFSET = 10 * sizeof(UINT);      // After the sort's Dispatch record
+constexpr UINT DEFAULT_TRAIL_SEGMENTS = 16;
+constexpr UINT SORT_BLOCK = 1024;
+constexpr float MAX_STEP = 0.1f;                                // Longer steps are clamped after a stall
+constexpr float STRETCH_TIME = 0.05f;
+
+// Particle in PARTICLE_SOURCE
+struct GpuParticle {
+    DirectX::XMFLOAT3 position;
+    float life;
+    DirectX::XMFLOAT3 velocity;
+    float inverseMaxLife;
+    DirectX::XMFLOAT4 color;
+    DirectX::XMFLOAT2 size;
+    float rotation;
+    float angularVelocity;
+};
+
+struct SimulationConstants {
+    DirectX::XMFLOAT4X4 viewProjection;
+    DirectX::XMFLOAT4X4 inverseViewProjection;
+    DirectX::XMFLOAT4 viewport;
+    DirectX::XMFLOAT3 emitterPosition;
+    UINT emitCount;
+    DirectX::XMFLOAT3 shapeScale;
+    UINT shape;
+    DirectX::XMFLOAT3 startVelocity;
+    float startLifetime;
+    DirectX::XMFLOAT3 velocityVariation;
+    float lifetimeVariation;
+    DirectX::XMFLOAT4 startColor;
+    DirectX::XMFLOAT4 colorVariation;
+    DirectX::XMFLOAT2 startSize;
+    DirectX::XMFLOAT2 sizeVariation;
+    float startRotation;
+    float rotationVariation;
+    float angularVelocity;
+    UINT seed;
+    DirectX::XMFLOAT3 gravity;
+    float drag;
+    DirectX::XMFLOAT3 cameraPosition;
+    float deltaTime;
+    float bounciness;
+    float friction;
+    float inverseMass;
+    UINT forceCount;
+    float noiseStrength;
+    float noiseFrequency;
+    UINT useDepth;
+    UINT curveFlags;
+    DirectX::XMFLOAT3 cameraForward;
+    UINT trailPoints;
+    UINT trailHead;
+    UINT trailReset;
+    DirectX::XMFLOAT2 trailPadding;
+    DirectX::XMFLOAT4 forcePosition[ParticleSystem::GPUParticleSystem::MAX_FORCES];
+    DirectX::XMFLOAT4 forceDirection[ParticleSystem::GPUParticleSystem::MAX_FORCES];
+    DirectX::XMFLOAT4 forceShape[ParticleSystem::GPUParticleSystem::MAX_FORCES];
+};
+
+struct RenderConstants {
+    DirectX::XMFLOAT4X4 viewProjection;
+    DirectX::XMFLOAT3 cameraPosition;
+    UINT alignToVelocity;
+    DirectX::XMFLOAT3 cameraRight;
+    float stretchTime;
+    DirectX::XMFLOAT3 cameraUp;
+    UINT useTexture;
+    UINT useSortedList;
+    UINT trailPoints;
+    UINT trailHead;
+    float trailWidth;
+    DirectX::XMFLOAT4 trailColor;
+    UINT trailTaper;
+    float motionTime;
+    UINT renderPadding[2];
+};
+
+struct SortConstants {
+    UINT level;
+    UINT step;
+    UINT padding[2];
+};
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3DBlob* CompileShader(const std::string& source, const char* name, const char* target) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+ID3D11ComputeShader* CompileComputeShader(ID3D11Device* device, const std::string& source, const char* name) {
+    ID3DBlob* blob = CompileShader(std::string(PARTICLE_SOURCE) + SIMULATION_SOURCE + source, name, "cs_5_0");
+    if (!blob) return nullptr;
+    ID3D11ComputeShader* shader = nullptr;
+    HRESULT hr = device->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &shader);
+    blob->Release();
+    return SUCCEEDED(hr) ? shader : nullptr;
+}
+
+template<typename T>
+void WriteConstants(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const T& data) {
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (SUCCEEDED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        std::memcpy(mapped.pData, &data, sizeof(T));
+        context->Unmap(buffer, 0);
+    }
+}
+
+ID3D11Buffer* CreateStructuredBuffer(ID3D11Device* device, UINT stride, UINT count, UINT bindFlags, const void* data) {
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.ByteWidth = stride * count;
+    desc.BindFlags = bindFlags;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    desc.StructureByteStride = stride;
+    D3D11_SUBRESOURCE_DATA initial = { data, 0, 0 };
+    ID3D11Buffer* buffer = nullptr;
+    return SUCCEEDED(device->CreateBuffer(&desc, data ? &initial : nullptr, &buffer)) ? buffer : nullptr;
+}
+
+// Append/consume view over a list of slot indices, with the hidden counter
+ID3D11UnorderedAccessView* CreateListTarget(ID3D11Device* device, ID3D11Buffer* buffer, UINT count) {
+    D3D11_UNORDERED_ACCESS_VIEW_DESC desc = {};
+    desc.Format = DXGI_FORMAT_UNKNOWN;
+    desc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    desc.Buffer.NumElements = count;
+    desc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_APPEND;
+    ID3D11UnorderedAccessView* view = nullptr;
+    return SUCCEEDED(device->CreateUnorderedAccessView(buffer, &desc, &view)) ? view : nullptr;
+}
+
+DirectX::XMFLOAT4 ToFloat4(const DirectX::XMFLOAT3& value, float w) {
+    return DirectX::XMFLOAT4(value.x, value.y, value.z, w);
+}
+}
+
+struct ParticleSystem::GPUParticlePool {
+    // What the next step does, as staged from the emitter
+    struct Step {
+        SimulationConstants constants = {};
+        std::shared_ptr<Texture> texture;
+        BlendMode blendMode = BlendMode::Alpha;
+        RenderMode renderMode = RenderMode::Billboard;
+        bool collide = false;
+        bool sort = false;
+        bool sprites = true;                           // Trail and Ribbon types draw only their trails
+        UINT trailPoints = 0;
+        float trailInterval = 0.0f;                    // Seconds between history points
+        float trailWidth = 0.0f;
+        XMFLOAT4 trailColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+        bool trailTaper = false;
+    };
+
+    ID3D11Buffer* particles = nullptr;
+    ID3D11ShaderResourceView* particleView = nullptr;
+    ID3D11UnorderedAccessView* particleTarget = nullptr;
+    ID3D11Buffer* deadList = nullptr;
+    ID3D11UnorderedAccessView* deadListTarget = nullptr;
+    ID3D11Buffer* aliveLists[2] = {};
+    ID3D11ShaderResourceView* aliveListViews[2] = {};
+    ID3D11UnorderedAccessView* aliveListTargets[2] = {};
+    ID3D11Buffer* counters = nullptr;                  // Dead count, alive count; copied from the list counters
+    ID3D11ShaderResourceView* counterView = nullptr;
+    ID3D11Buffer* arguments = nullptr;                 // DrawInstanced record, the simulation's and the sort's Dispatch records
+    ID3D11UnorderedAccessView* argumentsTarget = nullptr;
+    ID3D11Buffer* sortKeys = nullptr;                  // Created the first time the pool is sorted
+    ID3D11ShaderResourceView* sortKeyView = nullptr;
+    ID3D11UnorderedAccessView* sortKeyTarget = nullptr;
+    UINT sortCapacity = 0;                             // Capacity rounded up to a power of two, at least a block
+    ID3D11Texture1D* curves = nullptr;                 // Two rows of GPU_CURVE_SAMPLES texels, see Curves
+    ID3D11ShaderResourceView* curveView = nullptr;
+    ID3D11Buffer* trails = nullptr;                    // trailPoints positions per slot, a ring each; created on first use
+    ID3D11ShaderResourceView* trailView = nullptr;
+    ID3D11UnorderedAccessView* trailTarget = nullptr;
+    UINT trailPoints = 0;
+    UINT trailHead = 0;
+    float trailTimer = 0.0f;                           // Since the head last moved on
+    UINT capacity = 0;
+    UINT current = 0;                                  // Alive list holding the last step's survivors
+    bool countersSet = false;                          // List counters hold their starting values
+
+    bool hasStaged = false;
+    Step staged;                                       // Guarded by the system's staging mutex
+    Step frame;                                        // Taken by Simulate() for this frame
+    uint32_t curveVersion = 0;                         // Emitter bake the staged texels came from
+    std::vector<XMFLOAT4> stagedCurves;                // Waiting for upload; guarded like staged
+    std::vector<XMFLOAT4> frameCurves;
+
+    ~GPUParticlePool() {
+        ReleaseTrails();
+        SafeRelease(curveView);
+        SafeRelease(curves);
+        SafeRelease(sortKeyTarget);
+        SafeRelease(sortKeyView);
+        SafeRelease(sortKeys);
+        SafeRelease(argumentsTarget);
+        SafeRelease(arguments);
+        SafeRelease(counterView);
+        SafeRelease(counters);
+        for (int i = 0; i < 2; ++i) {
+            SafeRelease(aliveListTargets[i]);
+            SafeRelease(aliveListViews[i]);
+            SafeRelease(aliveLists[i]);
+        }
+        SafeRelease(deadListTarget);
+        SafeRelease(deadList);
+        SafeRelease(particleTarget);
+        SafeRelease(particleView);
+        SafeRelease(particles);
+    }
+
+    bool Create(ID3D11Device* device, UINT slots) {
+        capacity = slots;
+        particles = CreateStructuredBuffer(device, sizeof(GpuParticle), capacity,
+                                           D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS, nullptr);
+        if (!particles || FAILED(device->CreateShaderResourceView(particles, nullptr, &particleView)) ||
+            FAILED(device->CreateUnorderedAccessView(particles, nullptr, &particleTarget))) {
+            return false;
+        }
+
+        // Every slot starts out free
+        std::vector<uint32_t> free(capacity);
+        for (UINT i = 0; i < capacity; ++i) free[i] = i;
+        deadList = CreateStructuredBuffer(device, sizeof(uint32_t), capacity, D3D11_BIND_UNORDERED_ACCESS, free.data());
+        if (!deadList || !(deadListTarget = CreateListTarget(device, deadList, capacity))) return false;
+
+        for (int i = 0; i < 2; ++i) {
+            aliveLists[i] = CreateStructuredBuffer(device, sizeof(uint32_t), capacity,
+                                                   D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS, nullptr);
+            if (!aliveLists[i] || FAILED(device->CreateShaderResourceView(aliveLists[i], nullptr, &aliveListViews[i])) ||
+                !(aliveListTargets[i] = CreateListTarget(device, aliveLists[i], capacity))) {
+                return false;
+            }
+        }
+
+        D3D11_BUFFER_DESC counterDesc = {};
+        counterDesc.Usage = D3D11_USAGE_DEFAULT;
+        counterDesc.ByteWidth = 4 * sizeof(UINT);
+        counterDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        counterDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+        D3D11_SHADER_RESOURCE_VIEW_DESC counterViewDesc = {};
+        counterViewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+        counterViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+        counterViewDesc.BufferEx.NumElements = 4;
+        counterViewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+        if (FAILED(device->CreateBuffer(&counterDesc, nullptr, &counters)) ||
+            FAILED(device->CreateShaderResourceView(counters, &counterViewDesc, &counterView))) {
+            return false;
+        }
+
+        // Flat until the emitter's curves are uploaded: no size, full speed and spin
+        std::vector<XMFLOAT4> flat(2 * GPU_CURVE_SAMPLES, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+        std::fill(flat.begin() + GPU_CURVE_SAMPLES, flat.end(), XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f));
+        D3D11_SUBRESOURCE_DATA curveData[2] = { { flat.data(), 0, 0 }, { flat.data() + GPU_CURVE_SAMPLES, 0, 0 } };
+        D3D11_TEXTURE1D_DESC curveDesc = {};
+        curveDesc.Width = GPU_CURVE_SAMPLES;
+        curveDesc.MipLevels = 1;
+        curveDesc.ArraySize = 2;
+        curveDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        curveDesc.Usage = D3D11_USAGE_DEFAULT;
+        curveDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        if (FAILED(device->CreateTexture1D(&curveDesc, curveData, &curves)) ||
+            FAILED(device->CreateShaderResourceView(curves, nullptr, &curveView))) {
+            return false;
+        }
+
+        // VertexCountPerInstance, InstanceCount (copied from the alive list), StartVertex,
+        // StartInstance; then the simulation's and the sort's thread groups, written by the
+        // arguments kernel; then the trail draw's record, with the same instance count
+        const UINT initialArguments[14] = { 6, 0, 0, 0, 0, 1, 1, 0, 1, 1, 0, 0, 0, 0 };
+        D3D11_BUFFER_DESC argumentsDesc = {};
+        argumentsDesc.Usage = D3D11_USAGE_DEFAULT;
+        argumentsDesc.ByteWidth = sizeof(initialArguments);
+        argumentsDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+        argumentsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+        D3D11_SUBRESOURCE_DATA argumentsData = { initialArguments, 0, 0 };
+        D3D11_UNORDERED_ACCESS_VIEW_DESC argumentsTargetDesc = {};
+        argumentsTargetDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+        argumentsTargetDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+        argumentsTargetDesc.Buffer.NumElements = 14;
+        argumentsTargetDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+        return SUCCEEDED(device->CreateBuffer(&argumentsDesc, &argumentsData, &arguments)) &&
+               SUCCEEDED(device->CreateUnorderedAccessView(arguments, &argumentsTargetDesc, &argumentsTarget));
+    }
+
+    bool CreateSortKeys(ID3D11Device* device) {
+        UINT elements = SORT_BLOCK;
+        while (elements < capacity) elements *= 2;
+        sortKeys = CreateStructuredBuffer(device, 2 * sizeof(uint32_t), elements,
+                                          D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS, nullptr);
+        if (!sortKeys || FAILED(device->CreateShaderResourceView(sortKeys, nullptr, &sortKeyView)) ||
+            FAILED(device->CreateUnorderedAccessView(sortKeys, nullptr, &sortKeyTarget))) {
+            SafeRelease(sortKeyView);
+            SafeRelease(sortKeys);
+            return false;
+        }
+        sortCapacity = elements;
+        return true;
+    }
+
+    // The history starts out filled with each particle's position; see TrailReset
+    bool CreateTrails(ID3D11Device* device, UINT points) {
+        ReleaseTrails();
+        trails = CreateStructuredBuffer(device, sizeof(XMFLOAT4), capacity * points,
+                                        D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS, nullptr);
+        if (!trails || FAILED(device->CreateShaderResourceView(trails, nullptr, &trailView)) ||
+            FAILED(device->CreateUnorderedAccessView(trails, nullptr, &trailTarget))) {
+            ReleaseTrails();
+            return false;
+        }
+        trailPoints = points;
+        trailHead = 0;
+        trailTimer = 0.0f;
+        return true;
+    }
+
+    void ReleaseTrails() {
+        SafeRelease(trailTarget);
+        SafeRelease(trailView);
+        SafeRelease(trails);
+        trailPoints = 0;
+    }
+};
+
+ParticleSystem::GPUParticleSystem::GPUParticleSystem()
+    : device(nullptr)
+    , context(nullptr)
+    , emitComputeShader(nullptr)
+    , updateComputeShader(nullptr)
+    , argumentsComputeShader(nullptr)
+    , sortKeysComputeShader(nullptr)
+    , sortMergeGlobalComputeShader(nullptr)
+    , sortMergeLocalComputeShader(nullptr)
+    , renderVertexShader(nullptr)
+    , trailVertexShader(nullptr)
+    , renderPixelShader(nullptr)
+    , simulationConstants(nullptr)
+    , renderConstants(nullptr)
+    , sortConstants(nullptr)
+    , alphaBlend(nullptr)
+    , additiveBlend(nullptr)
+    , depthState(nullptr)
+    , rasterizerState(nullptr)
+    , sampler(nullptr)
+    , overridePixelShader(nullptr)
+    , overrideBlend(nullptr)
+    , frameIndex(0)
+    , sortEnabled(true)
+{
+}
+
+ParticleSystem::GPUParticleSystem::~GPUParticleSystem() {
+    Cleanup();
+}
+
+bool ParticleSystem::GPUParticleSystem::Initialize(ID3D11Device* targetDevice, ID3D11DeviceContext* targetContext) {
+    if (!targetDevice || !targetContext) return false;
+    device = targetDevice;
+    context = targetContext;
+
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0) {
+        Logger::Warning("GPU particles need feature level 11_0 compute shaders");
+        return false;
+    }
+
+    emitComputeShader = CompileComputeShader(device, EMIT_SHADER, "ParticleEmit");
+    updateComputeShader = CompileComputeShader(device, SIMULATE_SHADER, "ParticleSimulate");
+    argumentsComputeShader = CompileComputeShader(device, ARGUMENTS_SHADER, "ParticleArguments");
+    sortKeysComputeShader = CompileComputeShader(device, std::string(SORT_SOURCE) + SORT_KEYS_SHADER, "ParticleSortKeys");
+    sortMergeGlobalComputeShader = CompileComputeShader(device, std::string(SORT_SOURCE) + SORT_MERGE_GLOBAL_SHADER, "ParticleSortMergeGlobal");
+    sortMergeLocalComputeShader = CompileComputeShader(device, std::string(SORT_SOURCE) + SORT_MERGE_LOCAL_SHADER, "ParticleSortMergeLocal");
+    ID3DBlob* vertexBlob = CompileShader(std::string(PARTICLE_SOURCE) + RENDER_SOURCE + RENDER_VS, "Particle_VS", "vs_5_0");
+    ID3DBlob* trailBlob = CompileShader(std::string(PARTICLE_SOURCE) + RENDER_SOURCE + TRAIL_VS, "ParticleTrail_VS", "vs_5_0");
+    ID3DBlob* pixelBlob = CompileShader(std::string(PARTICLE_SOURCE) + RENDER_SOURCE + RENDER_PS, "Particle_PS", "ps_5_0");
+    if (vertexBlob) {
+        device->CreateVertexShader(vertexBlob->GetBufferPointer(), vertexBlob->GetBufferSize(), nullptr, &renderVertexShader);
+        vertexBlob->Release();
+    }
+    if (trailBlob) {
+        device->CreateVertexShader(trailBlob->GetBufferPointer(), trailBlob->GetBufferSize(), nullptr, &trailVertexShader);
+        trailBlob->Release();
+    }
+    if (pixelBlob) {
+        device->CreatePixelShader(pixelBlob->GetBufferPointer(), pixelBlob->GetBufferSize(), nullptr, &renderPixelShader);
+        pixelBlob->Release();
+    }
+    if (!emitComputeShader || !updateComputeShader || !argumentsComputeShader || !sortKeysComputeShader ||
+        !sortMergeGlobalComputeShader || !sortMergeLocalComputeShader || !renderVertexShader || !trailVertexShader || !renderPixelShader) {
+        Logger::Error("Failed to create GPU particle shaders");
+        Cleanup();
+        return false;
+    }
+
+    D3D11_BUFFER_DESC constantsDesc = {};
+    constantsDesc.Usage = D3D11_USAGE_DYNAMIC;
+    constantsDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constantsDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    constantsDesc.ByteWidth = sizeof(SimulationConstants);
+    HRESULT hr = device->CreateBuffer(&constantsDesc, nullptr, &simulationConstants);
+    constantsDesc.ByteWidth = sizeof(RenderConstants);
+    if (SUCCEEDED(hr)) hr = device->CreateBuffer(&constantsDesc, nullptr, &renderConstants);
+    constantsDesc.ByteWidth = sizeof(SortConstants);
+    if (SUCCEEDED(hr)) hr = device->CreateBuffer(&constantsDesc, nullptr, &sortConstants);
+
+    // Target 1 is TemporalAA's velocity when bound: motion mixes in by coverage even when the
+    // color adds
+    D3D11_BLEND_DESC blendDesc = {};
+    blendDesc.IndependentBlendEnable = TRUE;
+    blendDesc.RenderTarget[1].BlendEnable = TRUE;
+    blendDesc.RenderTarget[1].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[1].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[1].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[1].SrcBlendAlpha = D3D11_BLEND_ZERO;
+    blendDesc.RenderTarget[1].DestBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[1].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[1].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_RED | D3D11_COLOR_WRITE_ENABLE_GREEN;
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    if (SUCCEEDED(hr)) hr = device->CreateBlendState(&blendDesc, &alphaBlend);
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    if (SUCCEEDED(hr)) hr = device->CreateBlendState(&blendDesc, &additiveBlend);
+
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = TRUE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+    if (SUCCEEDED(hr)) hr = device->CreateDepthStencilState(&depthDesc, &depthState);
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    if (SUCCEEDED(hr)) hr = device->CreateRasterizerState(&rasterizerDesc, &rasterizerState);
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (SUCCEEDED(hr)) hr = device->CreateSamplerState(&samplerDesc, &sampler);
+
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create GPU particle resources");
+        Cleanup();
+        return false;
+    }
+
+    Logger::Info("GPU particle simulation initialized");
+    return true;
+}
+
+void ParticleSystem::GPUParticleSystem::Cleanup() {
+    {
+        std::lock_guard<std::mutex> lock(stagingMutex);
+        pools.clear();
+        framePools.clear();
+    }
+    SafeRelease(sampler);
+    SafeRelease(rasterizerState);
+    SafeRelease(depthState);
+    SafeRelease(additiveBlend);
+    SafeRelease(alphaBlend);
+    SafeRelease(sortConstants);
+    SafeRelease(renderConstants);
+    SafeRelease(simulationConstants);
+    SafeRelease(renderPixelShader);
+    SafeRelease(trailVertexShader);
+    SafeRelease(renderVertexShader);
+    SafeRelease(sortMergeLocalComputeShader);
+    SafeRelease(sortMergeGlobalComputeShader);
+    SafeRelease(sortKeysComputeShader);
+    SafeRelease(argumentsComputeShader);
+    SafeRelease(updateComputeShader);
+    SafeRelease(emitComputeShader);
+    device = nullptr;
+    context = nullptr;
+}
+
+bool ParticleSystem::GPUParticleSystem::EnsurePool(std::shared_ptr<GPUParticlePool>& pool, int maxParticles) {
+    if (!device || maxParticles <= 0) return false;
+    if (pool && pool->capacity == static_cast<UINT>(maxParticles)) return true;
+
+    // A resized pool starts empty; the old one is released once the render thread lets go of it
+    auto created = std::make_shared<GPUParticlePool>();
+    if (!created->Create(device, static_cast<UINT>(maxParticles))) {
+        Logger::Error("Failed to create GPU particle buffers for " + std::to_string(maxParticles) + " particles");
+        pool.reset();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(stagingMutex);
+    pools.push_back(created);
+    pool = std::move(created);
+    return true;
+}
+
+void ParticleSystem::GPUParticleSystem::Stage(GPUParticlePool& pool, const ParticleEmitter& emitter,
+                                              const std::vector<ParticleForce>& forces, int emitCount, float deltaTime) {
+    static_assert(GPU_CURVE_SAMPLES == CURVE_SAMPLES, "Curve tables are uploaded as baked");
+
+    std::lock_guard<std::mutex> lock(stagingMutex);
+    GPUParticlePool::Step& step = pool.staged;
+    SimulationConstants& constants = step.constants;
+    const float inverseMass = emitter.startMass > 0.0f ? 1.0f / emitter.startMass : 1.0f;
+    constants.emitterPosition = emitter.position;
+    constants.shapeScale = emitter.shapeScale;
+    constants.shape = static_cast<UINT>(emitter.shape);   // EmissionShape order, see SHAPE_*
+    constants.startVelocity = emitter.startVelocity;
+    constants.startLifetime = emitter.startLifetime;
+    constants.velocityVariation = emitter.startVelocityVariation;
+    constants.lifetimeVariation = emitter.startLifetimeVariation;
+    constants.startColor = emitter.startColor;
+    constants.colorVariation = emitter.startColorVariation;
+    constants.startSize = emitter.startSize;
+    constants.sizeVariation = emitter.startSizeVariation;
+    constants.startRotation = emitter.startRotation;
+    constants.rotationVariation = emitter.startRotationVariation;
+    constants.angularVelocity = emitter.startAngularVelocity;
+    constants.gravity = XMFLOAT3(emitter.gravity.x + emitter.constantForce.x * inverseMass,
+                                 emitter.gravity.y + emitter.constantForce.y * inverseMass,
+                                 emitter.gravity.z + emitter.constantForce.z * inverseMass);
+    constants.drag = emitter.drag;
+    constants.bounciness = emitter.bounciness;
+    constants.friction = emitter.friction;
+    constants.inverseMass = inverseMass;
+    constants.noiseStrength = emitter.enableNoise ? emitter.noiseStrength : 0.0f;
+    constants.noiseFrequency = emitter.noiseFrequency;
+
+    // Magnetic and custom forces have no GPU form
+    constants.forceCount = 0;
+    for (const ParticleForce& force : forces) {
+        if (constants.forceCount >= MAX_FORCES) break;
+        if (force.type == ParticleForce::ForceType::Magnetic || force.type == ParticleForce::ForceType::Custom) continue;
+        XMFLOAT3 direction;
+        XMStoreFloat3(&direction, XMVector3Normalize(XMLoadFloat3(&force.direction)));
+        UINT i = constants.forceCount++;
+        constants.forcePosition[i] = ToFloat4(force.position, force.radius);
+        constants.forceDirection[i] = ToFloat4(direction, force.strength);
+        constants.forceShape[i] = XMFLOAT4(static_cast<float>(force.type), force.falloff, 0.0f, 0.0f);
+    }
+
+    // Tables go up as texture rows, and only after a bake changed them
+    const bool hasColor = emitter.colorTable.size() == GPU_CURVE_SAMPLES;
+    const bool hasSize = emitter.sizeTable.size() == GPU_CURVE_SAMPLES;
+    constants.curveFlags = (hasColor ? CURVE_COLOR : 0) | (hasSize ? CURVE_SIZE : 0);
+    if (pool.curveVersion != emitter.curveVersion) {
+        const bool hasSpeed = emitter.speedTable.size() == GPU_CURVE_SAMPLES;
+        const bool hasSpin = emitter.spinTable.size() == GPU_CURVE_SAMPLES;
+        pool.stagedCurves.resize(2 * GPU_CURVE_SAMPLES);
+        for (size_t i = 0; i < GPU_CURVE_SAMPLES; ++i) {
+            pool.stagedCurves[i] = hasColor ? emitter.colorTable[i] : XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+            pool.stagedCurves[GPU_CURVE_SAMPLES + i] = XMFLOAT4(hasSize ? emitter.sizeTable[i].x : 0.0f,
+                                                                hasSize ? emitter.sizeTable[i].y : 0.0f,
+                                                                hasSpeed ? emitter.speedTable[i] : 1.0f,
+                                                                hasSpin ? emitter.spinTable[i] : 1.0f);
+        }
+        pool.curveVersion = emitter.curveVersion;
+    }
+
+    // Updates since the last frame add up
+    constants.emitCount = std::min(constants.emitCount + static_cast<UINT>(std::max(emitCount, 0)), pool.capacity);
+    constants.deltaTime += deltaTime;
+    step.texture = emitter.texture;
+    step.blendMode = emitter.blendMode;
+    step.renderMode = emitter.renderMode;
+    step.collide = emitter.enableCollision;
+    step.sort = sortEnabled && emitter.blendMode != BlendMode::Additive && emitter.blendMode != BlendMode::Screen;
+
+    // A trail point per trailLifetime / segments; the ring holds one more than the segments
+    const bool trailType = emitter.particleType == ParticleType::Trail || emitter.particleType == ParticleType::Ribbon;
+    const UINT segments = emitter.trailSegments > 0 ? std::min(static_cast<UINT>(emitter.trailSegments), MAX_TRAIL_SEGMENTS)
+                                                    : DEFAULT_TRAIL_SEGMENTS;
+    step.sprites = !trailType;
+    step.trailPoints = (trailType || emitter.enableTrails) ? segments + 1 : 0;
+    step.trailInterval = std::max(emitter.trailLifetime, 0.0f) / static_cast<float>(segments);
+    step.trailWidth = std::max(emitter.trailWidth, 0.0f);
+    step.trailColor = emitter.trailColor.w > 0.0f ? emitter.trailColor : XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    step.trailTaper = emitter.particleType == ParticleType::Trail;
+    pool.hasStaged = true;
+}
+
+void ParticleSystem::GPUParticleSystem::Simulate(const XMFLOAT4X4& view, const XMFLOAT4X4& projection,
+                                                 ID3D11ShaderResourceView* depth) {
+    if (!context) return;
+
+    // Take what the updates staged; pools whose emitter is gone drop out
+    framePools.clear();
+    {
+        std::lock_guard<std::mutex> lock(stagingMutex);
+        for (auto it = pools.begin(); it != pools.end();) {
+            std::shared_ptr<GPUParticlePool> pool = it->lock();
+            if (!pool) {
+                it = pools.erase(it);
+                continue;
+            }
+            ++it;
+            if (!pool->hasStaged) continue;
+            pool->frame = pool->staged;
+            if (!pool->stagedCurves.empty()) pool->frameCurves.swap(pool->stagedCurves);
+            pool->stagedCurves.clear();
+            pool->staged.constants.emitCount = 0;
+            pool->staged.constants.deltaTime = 0.0f;
+            framePools.push_back(std::move(pool));
+        }
+    }
+    if (framePools.empty()) return;
+
+    NEXUS_PROFILE_SCOPE("GPUParticleSystem::Simulate");
+
+    // HLSL reads constant buffer matrices column-major, so upload the transposes
+    XMMATRIX viewMatrix = XMLoadFloat4x4(&view);
+    XMMATRIX viewProjection = XMMatrixMultiply(viewMatrix, XMLoadFloat4x4(&projection));
+    XMFLOAT4X4 viewProjectionColumns, inverseColumns;
+    XMStoreFloat4x4(&viewProjectionColumns, XMMatrixTranspose(viewProjection));
+    XMStoreFloat4x4(&inverseColumns, XMMatrixTranspose(XMMatrixInverse(nullptr, viewProjection)));
+    XMFLOAT3 cameraPosition;
+    XMStoreFloat3(&cameraPosition, XMMatrixInverse(nullptr, viewMatrix).r[3]);
+    const XMFLOAT3 cameraForward(view._13, view._23, view._33);
+
+    // Depth can't be read while bound as the depth target
+    D3D11_VIEWPORT viewport = {};
+    UINT viewportCount = 1;
+    context->RSGetViewports(&viewportCount, &viewport);
+    ID3D11RenderTargetView* boundTarget = nullptr;
+    ID3D11DepthStencilView* boundDepth = nullptr;
+    if (depth) {
+        context->OMGetRenderTargets(1, &boundTarget, &boundDepth);
+        context->OMSetRenderTargets(1, &boundTarget, nullptr);
+    }
+
+    ID3D11UnorderedAccessView* nullTargets[4] = {};
+    ID3D11ShaderResourceView* nullViews[4] = {};
+    context->CSSetConstantBuffers(0, 1, &simulationConstants);
+    context->CSSetSamplers(0, 1, &sampler);
+    for (const std::shared_ptr<GPUParticlePool>& pool : framePools) {
+        SimulationConstants& constants = pool->frame.constants;
+        constants.viewProjection = viewProjectionColumns;
+        constants.inverseViewProjection = inverseColumns;
+        constants.viewport = XMFLOAT4(viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height);
+        constants.cameraPosition = cameraPosition;
+        constants.cameraForward = cameraForward;
+        constants.deltaTime = std::min(constants.deltaTime, MAX_STEP);
+        constants.seed = ++frameIndex * 0x9E3779B9u;
+        constants.useDepth = (depth && pool->frame.collide && viewportCount > 0) ? 1 : 0;
+
+        // The trail ring moves on once a point's worth of time has passed; until then the head
+        // keeps following the particles
+        const UINT trailPoints = pool->frame.trailPoints;
+        constants.trailReset = 0;
+        if (trailPoints != pool->trailPoints) {
+            if (trailPoints == 0) {
+                pool->ReleaseTrails();
+            } else if (pool->CreateTrails(device, trailPoints)) {
+                constants.trailReset = 1;
+            } else {
+                Logger::Warning("Failed to create GPU particle trail buffer; drawing without trails");
+            }
+        }
+        if (pool->trailPoints > 0) {
+            pool->trailTimer += constants.deltaTime;
+            if (pool->trailTimer >= pool->frame.trailInterval) {
+                pool->trailTimer = std::min(pool->trailTimer - pool->frame.trailInterval, pool->frame.trailInterval);
+                pool->trailHead = (pool->trailHead + 1) % pool->trailPoints;
+            }
+        }
+        constants.trailPoints = pool->trailPoints;
+        constants.trailHead = pool->trailHead;
+        WriteConstants(context, simulationConstants, constants);
+        if (!pool->frameCurves.empty()) {
+            for (UINT row = 0; row < 2; ++row) {
+                context->UpdateSubresource(pool->curves, D3D11CalcSubresource(0, row, 1), nullptr,
+                                           pool->frameCurves.data() + row * GPU_CURVE_SAMPLES, 0, 0);
+            }
+            pool->frameCurves.clear();
+        }
+
+        if (!pool->countersSet) {
+            // Binding with initial counts is what sets the hidden counters
+            ID3D11UnorderedAccessView* lists[3] = { pool->deadListTarget, pool->aliveListTargets[0], pool->aliveListTargets[1] };
+            UINT counts[3] = { pool->capacity, 0, 0 };
+            context->CSSetUnorderedAccessViews(0, 3, lists, counts);
+            context->CSSetUnorderedAccessViews(0, 3, nullTargets, nullptr);
+            pool->current = 0;
+            pool->countersSet = true;
+        }
+        const UINT next = 1 - pool->current;
+        const UINT keep[4] = { UINT(-1), UINT(-1), UINT(-1), UINT(-1) };
+
+        // Emission takes slots from the dead list into the current alive list
+        context->CopyStructureCount(pool->counters, 0, pool->deadListTarget);
+        if (constants.emitCount > 0) {
+            ID3D11UnorderedAccessView* targets[4] = { pool->particleTarget, pool->deadListTarget,
+                                                      pool->aliveListTargets[pool->current], pool->trailTarget };
+            context->CSSetShader(emitComputeShader, nullptr, 0);
+            context->CSSetShaderResources(0, 1, &pool->counterView);
+            context->CSSetUnorderedAccessViews(0, 4, targets, keep);
+            context->Dispatch((constants.emitCount + THREAD_GROUP_SIZE - 1) / THREAD_GROUP_SIZE, 1, 1);
+            context->CSSetUnorderedAccessViews(0, 4, nullTargets, nullptr);
+        }
+
+        // One simulation thread per alive particle, sized on the GPU
+        context->CopyStructureCount(pool->counters, sizeof(UINT), pool->aliveListTargets[pool->current]);
+        context->CSSetShader(argumentsComputeShader, nullptr, 0);
+        context->CSSetShaderResources(0, 1, &pool->counterView);
+        context->CSSetUnorderedAccessViews(0, 1, &pool->argumentsTarget, nullptr);
+        context->Dispatch(1, 1, 1);
+        context->CSSetUnorderedAccessViews(0, 1, nullTargets, nullptr);
+
+        // Survivors go to the other alive list, which starts empty
+        ID3D11UnorderedAccessView* targets[4] = { pool->particleTarget, pool->deadListTarget, pool->aliveListTargets[next],
+                                                  pool->trailTarget };
+        const UINT counts[4] = { UINT(-1), UINT(-1), 0, UINT(-1) };
+        ID3D11ShaderResourceView* views[4] = { pool->aliveListViews[pool->current], pool->counterView, depth, pool->curveView };
+        context->CSSetShader(updateComputeShader, nullptr, 0);
+        context->CSSetShaderResources(0, 4, views);
+        context->CSSetUnorderedAccessViews(0, 4, targets, counts);
+        context->DispatchIndirect(pool->arguments, DISPATCH_ARGUMENTS_OFFSET);
+        context->CSSetUnorderedAccessViews(0, 4, nullTargets, nullptr);
+        context->CSSetShaderResources(0, 4, nullViews);
+
+        // The draws' instance counts
+        context->CopyStructureCount(pool->arguments, sizeof(UINT), pool->aliveListTargets[next]);
+        if (pool->trailPoints > 0) {
+            context->CopyStructureCount(pool->arguments, TRAIL_ARGUMENTS_OFFSET + sizeof(UINT), pool->aliveListTargets[next]);
+        }
+        pool->current = next;
+
+        if (pool->frame.sort && !pool->sortKeys && !pool->CreateSortKeys(device)) {
+            Logger::Warning("Failed to create GPU particle sort buffer; drawing unsorted");
+            pool->frame.sort = false;
+        }
+        if (pool->frame.sort) Sort(*pool);
+    }
+    context->CSSetShader(nullptr, nullptr, 0);
+
+    if (depth) {
+        context->OMSetRenderTargets(1, &boundTarget, boundDepth);
+        SafeRelease(boundTarget);
+        SafeRelease(boundDepth);
+    }
+}
+
+void ParticleSystem::GPUParticleSystem::Sort(GPUParticlePool& pool) {
+    ID3D11UnorderedAccessView* nullTarget = nullptr;
+    ID3D11ShaderResourceView* nullViews[3] = {};
+
+    // The survivor count sizes the sort's dispatch record
+    context->CopyStructureCount(pool.counters, 2 * sizeof(UINT), pool.aliveListTargets[pool.current]);
+    context->CSSetShader(argumentsComputeShader, nullptr, 0);
+    context->CSSetShaderResources(0, 1, &pool.counterView);
+    context->CSSetUnorderedAccessViews(0, 1, &pool.argumentsTarget, nullptr);
+    context->Dispatch(1, 1, 1);
+    context->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+    context->CSSetShaderResources(0, 1, nullViews);
+
+    // Every pass covers the survivors rounded up to a power of two; passes for sequences longer
+    // than that return at once, so the CPU can plan for the whole pool
+    ID3D11ShaderResourceView* views[3] = { pool.particleView, pool.aliveListViews[pool.current], pool.counterView };
+    context->CSSetShaderResources(0, 3, views);
+    context->CSSetUnorderedAccessViews(0, 1, &pool.sortKeyTarget, nullptr);
+    context->CSSetConstantBuffers(1, 1, &sortConstants);
+    context->CSSetShader(sortKeysComputeShader, nullptr, 0);
+    context->DispatchIndirect(pool.arguments, SORT_ARGUMENTS_OFFSET);
+
+    // Merges longer than a block: steps between blocks one pass each, then the rest in shared memory
+    for (UINT level = 2 * SORT_BLOCK; level <= pool.sortCapacity; level *= 2) {
+        SortConstants constants = {};
+        constants.level = level;
+        context->CSSetShader(sortMergeGlobalComputeShader, nullptr, 0);
+        for (UINT step = level / 2; step >= SORT_BLOCK; step /= 2) {
+            constants.step = step;
+            WriteConstants(context, sortConstants, constants);
+            context->DispatchIndirect(pool.arguments, SORT_ARGUMENTS_OFFSET);
+        }
+        constants.step = SORT_BLOCK / 2;
+        WriteConstants(context, sortConstants, constants);
+        context->CSSetShader(sortMergeLocalComputeShader, nullptr, 0);
+        context->DispatchIndirect(pool.arguments, SORT_ARGUMENTS_OFFSET);
+    }
+
+    context->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+    context->CSSetShaderResources(0, 3, nullViews);
+}
+
+void ParticleSystem::GPUParticleSystem::Render(const XMFLOAT4X4& view, const XMFLOAT4X4& projection) {
+    if (!context || framePools.empty()) return;
+
+    NEXUS_PROFILE_SCOPE("GPUParticleSystem::Render");
+
+    // Camera axes are the view matrix's columns; the position is its inverse's translation
+    XMMATRIX viewMatrix = XMLoadFloat4x4(&view);
+    RenderConstants constants = {};
+    XMStoreFloat4x4(&constants.viewProjection, XMMatrixTranspose(XMMatrixMultiply(viewMatrix, XMLoadFloat4x4(&projection))));
+    XMStoreFloat3(&constants.cameraPosition, XMMatrixInverse(nullptr, viewMatrix).r[3]);
+    constants.cameraRight = XMFLOAT3(view._11, view._21, view._31);
+    constants.cameraUp = XMFLOAT3(view._12, view._22, view._32);
+
+    // Quads are generated from the vertex and instance IDs, so nothing feeds the input assembler
+    context->IASetInputLayout(nullptr);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->VSSetShader(renderVertexShader, nullptr, 0);
+    context->GSSetShader(nullptr, nullptr, 0);
+    context->PSSetShader(overridePixelShader ? overridePixelShader : renderPixelShader, nullptr, 0);
+    context->VSSetConstantBuffers(0, 1, &renderConstants);
+    context->PSSetConstantBuffers(0, 1, &renderConstants);
+    context->PSSetSamplers(0, 1, &sampler);
+    context->RSSetState(rasterizerState);
+    context->OMSetDepthStencilState(depthState, 0);
+
+    const FLOAT blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (const std::shared_ptr<GPUParticlePool>& pool : framePools) {
+        const GPUParticlePool::Step& step = pool->frame;
+        ID3D11ShaderResourceView* texture = step.texture ? step.texture->GetShaderResourceView() : nullptr;
+        constants.alignToVelocity = (step.renderMode == RenderMode::Stretched || step.renderMode == RenderMode::VelocityAligned) ? 1 : 0;
+        constants.stretchTime = step.renderMode == RenderMode::Stretched ? STRETCH_TIME : 0.0f;
+        constants.useTexture = texture ? 1 : 0;
+        constants.useSortedList = step.sort ? 1 : 0;
+        constants.trailPoints = 0;
+        constants.motionTime = step.constants.deltaTime;
+
+        bool additive = step.blendMode == BlendMode::Additive || step.blendMode == BlendMode::Screen;
+        ID3D11ShaderResourceView* views[4] = { pool->particleView, pool->aliveListViews[pool->current], pool->sortKeyView,
+                                               pool->trailView };
+        ID3D11BlendState* blend = additive ? additiveBlend : alphaBlend;
+        if (overridePixelShader && overrideBlend) blend = overrideBlend;
+        context->OMSetBlendState(blend, blendFactor, 0xffffffff);
+        context->VSSetShaderResources(0, 4, views);
+        context->PSSetShaderResources(0, 1, &texture);
+
+        // Trails go first, so the sprites at their heads draw over them
+        if (pool->trailPoints > 1) {
+            constants.trailPoints = pool->trailPoints;
+            constants.trailHead = pool->trailHead;
+            constants.trailWidth = step.trailWidth;
+            constants.trailColor = step.trailColor;
+            constants.trailTaper = step.trailTaper ? 1 : 0;
+            WriteConstants(context, renderConstants, constants);
+            context->VSSetShader(trailVertexShader, nullptr, 0);
+            context->DrawInstancedIndirect(pool->arguments, TRAIL_ARGUMENTS_OFFSET);
+            context->VSSetShader(renderVertexShader, nullptr, 0);
+            constants.trailPoints = 0;
+        }
+        if (step.sprites) {
+            WriteConstants(context, renderConstants, constants);
+            context->DrawInstancedIndirect(pool->arguments, 0);
+        }
+    }
+
+    // The particle buffers are written by compute next frame
+    ID3D11ShaderResourceView* nullViews[4] = {};
+    context->VSSetShaderResources(0, 4, nullViews);
+    context->PSSetShaderResources(0, 1, nullViews);
+    framePools.clear();
+}
+
+} // namespace Nexus
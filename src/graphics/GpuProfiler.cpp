@@ -0,0 +1,304 @@
+#include "GpuProfiler.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace Nexus {
+
+namespace {
+
+// Counter tracks of the top-level passes; each is drawn stacked by pass
+const char* const STATISTICS_COUNTERS[] = {
+    "GPU primitives",
+    "GPU rasterized primitives",
+    "GPU VS invocations",
+    "GPU PS invocations",
+};
+constexpr size_t STATISTICS_COUNTER_COUNT = sizeof(STATISTICS_COUNTERS) / sizeof(STATISTICS_COUNTERS[0]);
+
+uint64_t CounterValue(const GpuProfiler::PipelineStatistics& statistics, size_t counter) {
+    switch (counter) {
+        case 0: return statistics.primitives;
+        case 1: return statistics.clipperPrimitives;
+        case 2: return statistics.vsInvocations;
+        default: return statistics.psInvocations;
+    }
+}
+
+} // namespace
+
+GpuProfiler::GpuProfiler()
+    : device_(nullptr)
+    , context_(nullptr)
+    , frameIndex_(0)
+    , inFrame_(false)
+    , enabled_(true)
+    , collectStatistics_(false)
+    , initialized_(false)
+    , resolvedFrameTime_(0.0f)
+    , resolvedFrames_(0)
+    , resolvedHasStatistics_(false)
+{
+}
+
+GpuProfiler::~GpuProfiler() {
+    Shutdown();
+}
+
+bool GpuProfiler::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    if (initialized_) return true;
+    if (!device || !context) return false;
+
+    device_ = device;
+    context_ = context;
+
+    for (auto& frame : frames_) {
+        frame.disjoint = CreateQuery(D3D11_QUERY_TIMESTAMP_DISJOINT);
+        frame.frameBegin = CreateQuery(D3D11_QUERY_TIMESTAMP);
+        frame.frameEnd = CreateQuery(D3D11_QUERY_TIMESTAMP);
+        if (!frame.disjoint || !frame.frameBegin || !frame.frameEnd) {
+            Logger::Warning("GPU profiler: timestamp queries unavailable");
+            Shutdown();
+            return false;
+        }
+    }
+
+    openPasses_.reserve(16);
+    resolvedPasses_.reserve(MAX_PASSES_PER_FRAME);
+    counterValues_.reserve(MAX_PASSES_PER_FRAME);
+    initialized_ = true;
+    Logger::Info("GPU profiler initialized");
+    return true;
+}
+
+void GpuProfiler::Shutdown() {
+    auto release = [](ID3D11Query*& query) {
+        if (query) { query->Release(); query = nullptr; }
+    };
+
+    for (auto& frame : frames_) {
+        release(frame.disjoint);
+        release(frame.frameBegin);
+        release(frame.frameEnd);
+        release(frame.statistics);
+        for (auto& pass : frame.passes) {
+            release(pass.begin);
+            release(pass.end);
+            release(pass.statistics);
+        }
+        frame.passCount = 0;
+        frame.pending = false;
+    }
+
+    device_ = nullptr;
+    context_ = nullptr;
+    initialized_ = false;
+}
+
+ID3D11Query* GpuProfiler::CreateQuery(D3D11_QUERY type) {
+    D3D11_QUERY_DESC desc = {};
+    desc.Query = type;
+
+    ID3D11Query* query = nullptr;
+    if (FAILED(device_->CreateQuery(&desc, &query))) {
+        return nullptr;
+    }
+    return query;
+}
+
+void GpuProfiler::BeginFrame() {
+    if (!initialized_ || !enabled_ || inFrame_) return;
+
+    FrameQueries& frame = frames_[frameIndex_];
+
+    // Slot is being reused: pick up its results first (non-blocking, skipped if the GPU is behind)
+    if (frame.pending) {
+        ResolveFrame(frame);
+    }
+
+    frame.passCount = 0;
+    frame.cpuBeginNs = Profiler::GetTimeNs();
+    openPasses_.clear();
+
+    frame.collectStatistics = collectStatistics_;
+    if (frame.collectStatistics && !frame.statistics) {
+        frame.statistics = CreateQuery(D3D11_QUERY_PIPELINE_STATISTICS);
+        frame.collectStatistics = frame.statistics != nullptr;
+    }
+
+    context_->Begin(frame.disjoint);
+    context_->End(frame.frameBegin);
+    if (frame.collectStatistics) {
+        context_->Begin(frame.statistics);
+    }
+    inFrame_ = true;
+}
+
+void GpuProfiler::EndFrame() {
+    if (!inFrame_) return;
+
+    FrameQueries& frame = frames_[frameIndex_];
+
+    // Close anything left open so the frame stays balanced
+    while (!openPasses_.empty()) {
+        EndPass();
+    }
+
+    if (frame.collectStatistics) {
+        context_->End(frame.statistics);
+    }
+    context_->End(frame.frameEnd);
+    context_->End(frame.disjoint);
+    frame.pending = true;
+    inFrame_ = false;
+
+    frameIndex_ = (frameIndex_ + 1) % FRAME_LATENCY;
+}
+
+void GpuProfiler::BeginPass(const char* name) {
+    if (!inFrame_) return;
+
+    FrameQueries& frame = frames_[frameIndex_];
+    if (frame.passCount >= MAX_PASSES_PER_FRAME) return;
+
+    PassQuery& pass = frame.passes[frame.passCount];
+    if (!pass.begin) pass.begin = CreateQuery(D3D11_QUERY_TIMESTAMP);
+    if (!pass.end) pass.end = CreateQuery(D3D11_QUERY_TIMESTAMP);
+    if (!pass.begin || !pass.end) return;
+
+    pass.name = name;
+    pass.depth = static_cast<uint16_t>(openPasses_.size());
+    context_->End(pass.begin);
+
+    // Statistics queries may overlap, so nested passes count their parents' work too
+    if (frame.collectStatistics && !pass.statistics) {
+        pass.statistics = CreateQuery(D3D11_QUERY_PIPELINE_STATISTICS);
+    }
+    if (frame.collectStatistics && pass.statistics) {
+        context_->Begin(pass.statistics);
+    }
+
+    openPasses_.push_back(frame.passCount);
+    frame.passCount++;
+}
+
+void GpuProfiler::EndPass() {
+    if (!inFrame_ || openPasses_.empty()) return;
+
+    FrameQueries& frame = frames_[frameIndex_];
+    PassQuery& pass = frame.passes[openPasses_.back()];
+    openPasses_.pop_back();
+    if (frame.collectStatistics && pass.statistics) {
+        context_->End(pass.statistics);
+    }
+    context_->End(pass.end);
+}
+
+void GpuProfiler::ResolveFrame(FrameQueries& frame) {
+    frame.pending = false;
+
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint = {};
+    if (context_->GetData(frame.disjoint, &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return; // Still in flight after FRAME_LATENCY frames, drop rather than stall
+    }
+    if (disjoint.Disjoint || disjoint.Frequency == 0) {
+        return; // Clock changed mid-frame (power state change), timestamps are meaningless
+    }
+
+    UINT64 frameBegin = 0;
+    UINT64 frameEnd = 0;
+    if (context_->GetData(frame.frameBegin, &frameBegin, sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+        context_->GetData(frame.frameEnd, &frameEnd, sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return;
+    }
+
+    const double ticksToMs = 1000.0 / static_cast<double>(disjoint.Frequency);
+    const double ticksToNs = 1000000000.0 / static_cast<double>(disjoint.Frequency);
+
+    resolvedPasses_.clear();
+    resolvedFrameTime_ = static_cast<float>((frameEnd - frameBegin) * ticksToMs);
+    resolvedFrames_++;
+    resolvedHasStatistics_ = frame.collectStatistics && ReadStatistics(frame.statistics, resolvedStatistics_);
+
+    // GPU timestamps are placed on the CPU timeline relative to when the frame was recorded
+    Profiler::RecordEvent("GPU Frame", frame.cpuBeginNs,
+                          frame.cpuBeginNs + static_cast<uint64_t>((frameEnd - frameBegin) * ticksToNs), 0, 1);
+
+    for (size_t i = 0; i < frame.passCount; ++i) {
+        const PassQuery& pass = frame.passes[i];
+
+        UINT64 begin = 0;
+        UINT64 end = 0;
+        if (context_->GetData(pass.begin, &begin, sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            context_->GetData(pass.end, &end, sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            end < begin || begin < frameBegin) {
+            continue;
+        }
+
+        PassTiming timing;
+        timing.name = pass.name;
+        timing.depth = pass.depth;
+        timing.milliseconds = static_cast<float>((end - begin) * ticksToMs);
+        timing.hasStatistics = frame.collectStatistics && pass.statistics && ReadStatistics(pass.statistics, timing.statistics);
+        resolvedPasses_.push_back(timing);
+
+        uint64_t startNs = frame.cpuBeginNs + static_cast<uint64_t>((begin - frameBegin) * ticksToNs);
+        uint64_t endNs = frame.cpuBeginNs + static_cast<uint64_t>((end - frameBegin) * ticksToNs);
+        Profiler::RecordEvent(pass.name, startNs, endNs, static_cast<uint16_t>(pass.depth + 1), 1);
+    }
+
+    if (resolvedHasStatistics_ && Profiler::IsCapturing()) {
+        RecordStatisticsCounters(frame.cpuBeginNs);
+    }
+}
+
+bool GpuProfiler::ReadStatistics(ID3D11Query* query, PipelineStatistics& statistics) {
+    D3D11_QUERY_DATA_PIPELINE_STATISTICS data = {};
+    if (context_->GetData(query, &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return false;
+    }
+    statistics.vertices = data.IAVertices;
+    statistics.primitives = data.IAPrimitives;
+    statistics.vsInvocations = data.VSInvocations;
+    statistics.psInvocations = data.PSInvocations;
+    statistics.csInvocations = data.CSInvocations;
+    statistics.clipperInvocations = data.CInvocations;
+    statistics.clipperPrimitives = data.CPrimitives;
+    return true;
+}
+
+void GpuProfiler::RecordStatisticsCounters(uint64_t timeNs) {
+    for (size_t counter = 0; counter < STATISTICS_COUNTER_COUNT; ++counter) {
+        // One series per top-level pass name; a pass drawn more than once adds up
+        counterValues_.clear();
+        for (const PassTiming& pass : resolvedPasses_) {
+            if (pass.depth != 0 || !pass.hasStatistics) continue;
+            double value = static_cast<double>(CounterValue(pass.statistics, counter));
+            auto it = std::find_if(counterValues_.begin(), counterValues_.end(),
+                                   [&pass](const ProfileCounterValue& series) { return series.series == pass.name; });
+            if (it != counterValues_.end()) {
+                it->value += value;
+            } else {
+                ProfileCounterValue series;
+                series.series = pass.name;
+                series.value = value;
+                counterValues_.push_back(series);
+            }
+        }
+        if (!counterValues_.empty()) {
+            Profiler::RecordCounter(STATISTICS_COUNTERS[counter], counterValues_.data(), counterValues_.size(), timeNs);
+        }
+    }
+}
+
+float GpuProfiler::GetPassTime(const char* name) const {
+    float total = 0.0f;
+    for (const auto& pass : resolvedPasses_) {
+        if (pass.name == name) {
+            total += pass.milliseconds;
+        }
+    }
+    return total;
+}
+
+} // namespace Nexus
@@ -1,20 +1,55 @@
 #include "GraphicsDevice.h"
+#include "BloomRenderer.h"
+#include "D3D12Device.h"
+#include "DynamicResolution.h"
 #include "Logger.h"
+#include "MaterialTable.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "StateCache.h"
+#include "TemporalAA.h"
+#include "ConstantBufferRing.h"
+#include "CommandRecorder.h"
+#include "OcclusionCuller.h"
+#include "OverdrawVisualizer.h"
+#include "RenderGraph.h"
+#include "SpriteBatcher.h"
+#include "TextureStreamingEngine.h"
+#include "ShaderCache.h"
 #include "UnrealTextureLoader.h"
+#include "TextureFile.h"
 #include <d3d11.h>
+#include <d3d11on12.h>
 #include <d3dcompiler.h>
+#include <dxgi1_5.h>
 #include <DirectXMath.h>
+#include <algorithm>
 #include <vector>
 #include <cstring>
 
 namespace Nexus {
 
+static_assert(D3D12Device::BACK_BUFFER_COUNT == 2, "GraphicsDevice wraps two D3D12 back buffers");
+
 GraphicsDevice::GraphicsDevice()
     : device_(nullptr)
     , context_(nullptr)
     , swapChain_(nullptr)
     , renderTargetView_(nullptr)
     , depthStencilView_(nullptr)
+    , depthShaderView_(nullptr)
+    , frameLatencyWaitable_(nullptr)
+    , swapChainFlags_(0)
+    , tearingSupported_(false)
+    , vsync_(false)
+    , deviceLost_(false)
+    , adapter_(nullptr)
+    , backend_(Backend::D3D11)
+    , jobs_(nullptr)
+    , on12_(nullptr)
+    , wrappedBackBuffers_{}
+    , backBufferViews_{}
     , width_(0)
     , height_(0)
     , fullscreen_(false)
@@ -24,20 +59,27 @@ GraphicsDevice::GraphicsDevice()
     , bloomIntensity_(1.2f)
     , shadowsEnabled_(false)
     , shadowMapSize_(1024)
-    , bloomTexture_(nullptr)
-    , bloomRenderTarget_(nullptr)
-    , heatHazeTexture_(nullptr)
-    , heatHazeRenderTarget_(nullptr)
+    , postProcessing_(false)
     , shadowMap_(nullptr)
     , shadowMapDepth_(nullptr)
     , boxVertexBuffer_(nullptr)
     , boxIndexBuffer_(nullptr)
     , sphereVertexBuffer_(nullptr)
     , sphereIndexBuffer_(nullptr)
-    , constantBuffer_(nullptr)
     , basicVertexShader_(nullptr)
     , basicPixelShader_(nullptr)
     , basicInputLayout_(nullptr)
+    , sphereIndexCount_(0)
+    , instancedVertexShader_(nullptr)
+    , instancedInputLayout_(nullptr)
+    , instanceBuffer_(nullptr)
+    , instanceView_(nullptr)
+    , instanceCapacity_(0)
+    , stateCache_(std::make_unique<StateCache>())
+    , constantRing_(std::make_unique<ConstantBufferRing>())
+    , occlusionCulling_(false)
+    , debugView_(DebugView::None)
+    , debugViewPending_(false)
 {
 }
 
@@ -52,70 +94,308 @@ bool GraphicsDevice::Initialize(HWND hwnd, int width, int height, bool fullscree
     height_ = height;
     fullscreen_ = fullscreen;
     
-    // Create DXGI factory
-    IDXGIFactory* factory = nullptr;
-    HRESULT hr = CreateDXGIFactory(__uuidof(IDXGIFactory), (void**)&factory);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create DXGI factory");
+    if (backend_ == Backend::D3D12) {
+        d3d12_ = std::make_unique<D3D12Device>();
+        if (!d3d12_->Initialize(hwnd, width, height, fullscreen) || !CreateOn12Device()) {
+            Logger::Warning("D3D12 backend unavailable, falling back to D3D11");
+            d3d12_.reset();
+            backend_ = Backend::D3D11;
+        }
+    }
+    if (!device_) {
+        D3D_FEATURE_LEVEL featureLevel;
+        HRESULT hr = D3D11CreateDevice(
+            nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0,
+            nullptr, 0, D3D11_SDK_VERSION,
+            &device_, &featureLevel, &context_
+        );
+        
+        if (FAILED(hr)) {
+            Logger::Error("Failed to create D3D11 device");
+            return false;
+        }
+    }
+    
+    // All pipeline bindings go through the cache from here on
+    stateCache_->Initialize(context_);
+    renderGraph_ = std::make_unique<RenderGraph>();
+    renderGraph_->Initialize(device_, context_, stateCache_.get());
+    if (d3d12_) {
+        commandGraph_ = std::make_unique<RenderGraph>();
+        commandGraph_->Initialize(d3d12_.get(), jobs_);
+    }
+    
+    if (!CreateSwapChain(hwnd)) {
+        return false;
+    }
+    if (!CreateSizeDependentResources()) {
         return false;
     }
     
-    // Create device and swap chain
-    DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
-    swapChainDesc.BufferCount = 1;
-    swapChainDesc.BufferDesc.Width = width;
-    swapChainDesc.BufferDesc.Height = height;
-    swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    swapChainDesc.BufferDesc.RefreshRate.Numerator = 60;
-    swapChainDesc.BufferDesc.RefreshRate.Denominator = 1;
-    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDesc.OutputWindow = hwnd;
-    swapChainDesc.SampleDesc.Count = 1;
-    swapChainDesc.SampleDesc.Quality = 0;
-    swapChainDesc.Windowed = !fullscreen;
+    // Initialize primitive rendering
+    InitializePrimitiveRendering();
     
-    D3D_FEATURE_LEVEL featureLevel;
-    hr = D3D11CreateDeviceAndSwapChain(
-        nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0,
-        nullptr, 0, D3D11_SDK_VERSION,
-        &swapChainDesc, &swapChain_, &device_, &featureLevel, &context_
-    );
+    // GPU timing is optional, rendering continues without it
+    gpuProfiler_ = std::make_unique<GpuProfiler>();
+    if (!gpuProfiler_->Initialize(device_, context_)) {
+        gpuProfiler_.reset();
+    }
+
+    // Streamed textures get half of dedicated VRAM, leaving the rest for render targets, meshes
+    // and everything the driver keeps resident
+    uint64_t streamingBudget = 256ull * 1024 * 1024;
+    IDXGIDevice* dxgiDevice = nullptr;
+    if (SUCCEEDED(device_->QueryInterface(__uuidof(IDXGIDevice), (void**)&dxgiDevice))) {
+        IDXGIAdapter* adapter = nullptr;
+        DXGI_ADAPTER_DESC adapterDesc = {};
+        if (SUCCEEDED(dxgiDevice->GetAdapter(&adapter)) && SUCCEEDED(adapter->GetDesc(&adapterDesc))) {
+            streamingBudget = std::max<uint64_t>(streamingBudget, adapterDesc.DedicatedVideoMemory / 2);
+            adapter->QueryInterface(__uuidof(IDXGIAdapter3), (void**)&adapter_);
+        }
+        if (adapter) adapter->Release();
+        dxgiDevice->Release();
+    }
+    textureStreaming_ = std::make_unique<TextureStreamingEngine>();
+    if (!textureStreaming_->Initialize(device_, context_, streamingBudget)) {
+        textureStreaming_.reset();
+    } else {
+        textureStreaming_->ResizeFeedback(width_, height_);
+    }
     
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create D3D11 device and swap chain");
-        factory->Release();
-        return false;
+    // Materials fall back to binding one at a time without it
+    materialTable_ = std::make_unique<MaterialTable>();
+    if (!materialTable_->Initialize(device_, context_, MaterialTable::Settings())) {
+        materialTable_.reset();
     }
     
-    factory->Release();
+    Logger::Info("Graphics Device initialized successfully");
+    return true;
+}
+
+void GraphicsDevice::Shutdown() {
+    overdraw_.reset();
+    debugView_ = DebugView::None;
+    debugViewPending_ = false;
+    materialTable_.reset();
+    textureStreaming_.reset();
+    temporalAA_.reset();
+    dynamicResolution_.reset();
+    gpuProfiler_.reset();
+    sprites_.reset();
+    commandRecorder_.reset();
+    occlusionCuller_.reset();
+    occlusionCulling_ = false;
     
-    // Create render target view
-    ID3D11Texture2D* backBuffer = nullptr;
-    hr = swapChain_->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer);
+    // Clean up DirectX resources
+    if (instanceView_) { instanceView_->Release(); instanceView_ = nullptr; }
+    if (instanceBuffer_) { instanceBuffer_->Release(); instanceBuffer_ = nullptr; }
+    if (instancedInputLayout_) { instancedInputLayout_->Release(); instancedInputLayout_ = nullptr; }
+    if (instancedVertexShader_) { instancedVertexShader_->Release(); instancedVertexShader_ = nullptr; }
+    instanceCapacity_ = 0;
+    boxInstances_.clear();
+    sphereInstances_.clear();
+    if (basicInputLayout_) { basicInputLayout_->Release(); basicInputLayout_ = nullptr; }
+    if (basicPixelShader_) { basicPixelShader_->Release(); basicPixelShader_ = nullptr; }
+    if (basicVertexShader_) { basicVertexShader_->Release(); basicVertexShader_ = nullptr; }
+    constantRing_->Shutdown();
+    if (sphereIndexBuffer_) { sphereIndexBuffer_->Release(); sphereIndexBuffer_ = nullptr; }
+    if (sphereVertexBuffer_) { sphereVertexBuffer_->Release(); sphereVertexBuffer_ = nullptr; }
+    if (boxIndexBuffer_) { boxIndexBuffer_->Release(); boxIndexBuffer_ = nullptr; }
+    if (boxVertexBuffer_) { boxVertexBuffer_->Release(); boxVertexBuffer_ = nullptr; }
+    ReleasePostProcessing();
+    renderGraph_.reset();
+    commandGraph_.reset();
+    ReleaseSizeDependentResources();
+    if (frameLatencyWaitable_) { CloseHandle(frameLatencyWaitable_); frameLatencyWaitable_ = nullptr; }
+    if (swapChain_) {
+        // A swap chain must not be released in exclusive fullscreen
+        swapChain_->SetFullscreenState(FALSE, nullptr);
+        swapChain_->Release();
+        swapChain_ = nullptr;
+    }
+    stateCache_->Shutdown();
+    if (adapter_) { adapter_->Release(); adapter_ = nullptr; }
+    if (on12_) { on12_->Release(); on12_ = nullptr; }
+    if (context_) { context_->Release(); context_ = nullptr; }
+    if (device_) { device_->Release(); device_ = nullptr; }
+    // Last, once nothing layered on it is left; waits for the GPU
+    d3d12_.reset();
+}
+
+bool GraphicsDevice::CreateOn12Device() {
+    // D3D11 commands go to the D3D12 queue, ordered with the command graph's lists
+    IUnknown* queues[] = { d3d12_->GetQueue() };
+    D3D_FEATURE_LEVEL featureLevel;
+    HRESULT hr = D3D11On12CreateDevice(d3d12_->GetDevice(), 0, nullptr, 0, queues, 1, 0,
+                                       &device_, &context_, &featureLevel);
+    if (SUCCEEDED(hr)) {
+        hr = device_->QueryInterface(__uuidof(ID3D11On12Device), (void**)&on12_);
+    }
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create the D3D11 on 12 device");
+        if (context_) { context_->Release(); context_ = nullptr; }
+        if (device_) { device_->Release(); device_ = nullptr; }
+        return false;
+    }
+    return true;
+}
+
+bool GraphicsDevice::CreateSwapChain(HWND hwnd) {
+    if (d3d12_) {
+        // Created on the D3D12 queue; presenting goes through the D3D12 device
+        swapChain_ = d3d12_->GetSwapChain();
+        swapChain_->AddRef();
+        swapChainFlags_ = d3d12_->GetSwapChainFlags();
+        tearingSupported_ = d3d12_->IsTearingSupported();
+        CreateFrameLatencyWaitable();
+        Logger::Info(std::string("Swap chain created (D3D12, flip discard") +
+                     (tearingSupported_ ? ", tearing allowed)" : ")"));
+        return true;
+    }
+
+    // The swap chain comes from the factory that created the device's adapter
+    IDXGIFactory2* factory = nullptr;
+    IDXGIDevice* dxgiDevice = nullptr;
+    HRESULT hr = device_->QueryInterface(__uuidof(IDXGIDevice), (void**)&dxgiDevice);
+    if (SUCCEEDED(hr)) {
+        IDXGIAdapter* adapter = nullptr;
+        hr = dxgiDevice->GetAdapter(&adapter);
+        if (SUCCEEDED(hr)) {
+            hr = adapter->GetParent(__uuidof(IDXGIFactory2), (void**)&factory);
+            adapter->Release();
+        }
+        dxgiDevice->Release();
+    }
     if (FAILED(hr)) {
-        Logger::Error("Failed to get back buffer");
+        Logger::Error("Failed to get DXGI factory");
         return false;
     }
     
-    hr = device_->CreateRenderTargetView(backBuffer, nullptr, &renderTargetView_);
-    backBuffer->Release();
+    // Tearing lets unsynchronized presents reach variable refresh rate displays right away
+    tearingSupported_ = false;
+    IDXGIFactory5* factory5 = nullptr;
+    if (SUCCEEDED(factory->QueryInterface(__uuidof(IDXGIFactory5), (void**)&factory5))) {
+        BOOL allowTearing = FALSE;
+        if (SUCCEEDED(factory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing)))) {
+            tearingSupported_ = allowTearing == TRUE;
+        }
+        factory5->Release();
+    }
     
+    DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
+    swapChainDesc.Width = width_;
+    swapChainDesc.Height = height_;
+    swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swapChainDesc.SampleDesc.Count = 1;
+    swapChainDesc.SampleDesc.Quality = 0;
+    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swapChainDesc.BufferCount = 2;
+    swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
+    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+    swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT |
+                          (tearingSupported_ ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0);
+    
+    DXGI_SWAP_CHAIN_FULLSCREEN_DESC fullscreenDesc = {};
+    fullscreenDesc.RefreshRate.Numerator = 60;
+    fullscreenDesc.RefreshRate.Denominator = 1;
+    fullscreenDesc.Windowed = !fullscreen_;
+    
+    IDXGISwapChain1* swapChain = nullptr;
+    hr = factory->CreateSwapChainForHwnd(device_, hwnd, &swapChainDesc, &fullscreenDesc, nullptr, &swapChain);
     if (FAILED(hr)) {
-        Logger::Error("Failed to create render target view");
+        // Flip discard needs Windows 10; before that the blt model without latency control
+        Logger::Warning("Flip model swap chain unavailable, falling back to blt model");
+        tearingSupported_ = false;
+        swapChainDesc.BufferCount = 1;
+        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+        swapChainDesc.Flags = 0;
+        hr = factory->CreateSwapChainForHwnd(device_, hwnd, &swapChainDesc, &fullscreenDesc, nullptr, &swapChain);
+    }
+    factory->Release();
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create swap chain");
         return false;
     }
+    swapChain_ = swapChain;
+    swapChainFlags_ = swapChainDesc.Flags;
+    CreateFrameLatencyWaitable();
+    
+    Logger::Info(std::string("Swap chain created (") +
+                 (swapChainDesc.SwapEffect == DXGI_SWAP_EFFECT_FLIP_DISCARD ? "flip discard" : "blt") +
+                 (tearingSupported_ ? ", tearing allowed)" : ")"));
+    return true;
+}
+
+void GraphicsDevice::CreateFrameLatencyWaitable() {
+    // Keep one frame queued: the frame pacer waits on this handle before starting the next frame,
+    // so input is sampled as late as possible instead of a frame or two before it is shown
+    IDXGISwapChain2* swapChain2 = nullptr;
+    if ((swapChainFlags_ & DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT) &&
+        SUCCEEDED(swapChain_->QueryInterface(__uuidof(IDXGISwapChain2), (void**)&swapChain2))) {
+        swapChain2->SetMaximumFrameLatency(1);
+        frameLatencyWaitable_ = swapChain2->GetFrameLatencyWaitableObject();
+        swapChain2->Release();
+    }
+}
+
+bool GraphicsDevice::WrapBackBuffers() {
+    // Each D3D12 back buffer gets a D3D11 resource and view; BeginFrame binds the current one
+    for (UINT i = 0; i < D3D12Device::BACK_BUFFER_COUNT; ++i) {
+        D3D11_RESOURCE_FLAGS flags = {};
+        flags.BindFlags = D3D11_BIND_RENDER_TARGET;
+        HRESULT hr = on12_->CreateWrappedResource(d3d12_->GetBackBuffer(i), &flags, D3D12_RESOURCE_STATE_PRESENT,
+                                                  D3D12_RESOURCE_STATE_PRESENT, __uuidof(ID3D11Resource),
+                                                  (void**)&wrappedBackBuffers_[i]);
+        if (SUCCEEDED(hr)) {
+            hr = device_->CreateRenderTargetView(wrappedBackBuffers_[i], nullptr, &backBufferViews_[i]);
+        }
+        if (FAILED(hr)) {
+            Logger::Error("Failed to wrap the D3D12 back buffers");
+            return false;
+        }
+    }
+    renderTargetView_ = backBufferViews_[d3d12_->GetBackBufferIndex()];
+    renderTargetView_->AddRef();
+    return true;
+}
+
+bool GraphicsDevice::CreateSizeDependentResources() {
+    HRESULT hr = S_OK;
+    if (d3d12_) {
+        if (!WrapBackBuffers()) {
+            return false;
+        }
+    } else {
+        // Create render target view
+        ID3D11Texture2D* backBuffer = nullptr;
+        hr = swapChain_->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer);
+        if (FAILED(hr)) {
+            Logger::Error("Failed to get back buffer");
+            return false;
+        }
+        
+        hr = device_->CreateRenderTargetView(backBuffer, nullptr, &renderTargetView_);
+        backBuffer->Release();
+        
+        if (FAILED(hr)) {
+            Logger::Error("Failed to create render target view");
+            return false;
+        }
+    }
     
     // Create depth stencil buffer
     D3D11_TEXTURE2D_DESC depthDesc = {};
-    depthDesc.Width = width;
-    depthDesc.Height = height;
+    depthDesc.Width = width_;
+    depthDesc.Height = height_;
     depthDesc.MipLevels = 1;
     depthDesc.ArraySize = 1;
-    depthDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+    // Typeless so the Hi-Z build can also read depth through a shader resource view
+    depthDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
     depthDesc.SampleDesc.Count = 1;
     depthDesc.SampleDesc.Quality = 0;
     depthDesc.Usage = D3D11_USAGE_DEFAULT;
-    depthDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+    depthDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
     depthDesc.CPUAccessFlags = 0;
     depthDesc.MiscFlags = 0;
     
@@ -126,62 +406,120 @@ bool GraphicsDevice::Initialize(HWND hwnd, int width, int height, bool fullscree
         return false;
     }
     
-    hr = device_->CreateDepthStencilView(depthStencilBuffer, nullptr, &depthStencilView_);
-    depthStencilBuffer->Release();
-    
+    D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+    dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+    dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+    hr = device_->CreateDepthStencilView(depthStencilBuffer, &dsvDesc, &depthStencilView_);
     if (FAILED(hr)) {
+        depthStencilBuffer->Release();
         Logger::Error("Failed to create depth stencil view");
         return false;
     }
     
+    D3D11_SHADER_RESOURCE_VIEW_DESC depthSrvDesc = {};
+    depthSrvDesc.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+    depthSrvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    depthSrvDesc.Texture2D.MipLevels = 1;
+    if (FAILED(device_->CreateShaderResourceView(depthStencilBuffer, &depthSrvDesc, &depthShaderView_))) {
+        Logger::Warning("Failed to create depth shader resource view, occlusion culling unavailable");
+    }
+    depthStencilBuffer->Release();
+    
     // Set render targets
-    context_->OMSetRenderTargets(1, &renderTargetView_, depthStencilView_);
+    stateCache_->OMSetRenderTargets(1, &renderTargetView_, depthStencilView_);
     
     // Set viewport
     D3D11_VIEWPORT viewport = {};
     viewport.TopLeftX = 0;
     viewport.TopLeftY = 0;
-    viewport.Width = (float)width;
-    viewport.Height = (float)height;
+    viewport.Width = (float)width_;
+    viewport.Height = (float)height_;
     viewport.MinDepth = 0.0f;
     viewport.MaxDepth = 1.0f;
-    context_->RSSetViewports(1, &viewport);
+    stateCache_->RSSetViewports(1, &viewport);
     
     // Set projection matrix
-    float aspectRatio = (float)width / (float)height;
+    float aspectRatio = (float)width_ / (float)height_;
     DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(
         DirectX::XM_PIDIV4, aspectRatio, 0.1f, 1000.0f
     );
     DirectX::XMStoreFloat4x4(&projectionMatrix_, projection);
-    
-    // Initialize primitive rendering
-    InitializePrimitiveRendering();
-    
-    Logger::Info("Graphics Device initialized successfully");
     return true;
 }
 
-void GraphicsDevice::Shutdown() {
-    // Clean up DirectX resources
-    if (basicInputLayout_) { basicInputLayout_->Release(); basicInputLayout_ = nullptr; }
-    if (basicPixelShader_) { basicPixelShader_->Release(); basicPixelShader_ = nullptr; }
-    if (basicVertexShader_) { basicVertexShader_->Release(); basicVertexShader_ = nullptr; }
-    if (constantBuffer_) { constantBuffer_->Release(); constantBuffer_ = nullptr; }
-    if (sphereIndexBuffer_) { sphereIndexBuffer_->Release(); sphereIndexBuffer_ = nullptr; }
-    if (sphereVertexBuffer_) { sphereVertexBuffer_->Release(); sphereVertexBuffer_ = nullptr; }
-    if (boxIndexBuffer_) { boxIndexBuffer_->Release(); boxIndexBuffer_ = nullptr; }
-    if (boxVertexBuffer_) { boxVertexBuffer_->Release(); boxVertexBuffer_ = nullptr; }
-    if (shadowMapDepth_) { shadowMapDepth_->Release(); shadowMapDepth_ = nullptr; }
-    if (shadowMap_) { shadowMap_->Release(); shadowMap_ = nullptr; }
-    if (heatHazeRenderTarget_) { heatHazeRenderTarget_->Release(); heatHazeRenderTarget_ = nullptr; }
-    if (heatHazeTexture_) { heatHazeTexture_->Release(); heatHazeTexture_ = nullptr; }
-    if (bloomRenderTarget_) { bloomRenderTarget_->Release(); bloomRenderTarget_ = nullptr; }
-    if (bloomTexture_) { bloomTexture_->Release(); bloomTexture_ = nullptr; }
+void GraphicsDevice::ReleaseSizeDependentResources() {
+    if (depthShaderView_) { depthShaderView_->Release(); depthShaderView_ = nullptr; }
     if (depthStencilView_) { depthStencilView_->Release(); depthStencilView_ = nullptr; }
     if (renderTargetView_) { renderTargetView_->Release(); renderTargetView_ = nullptr; }
-    if (swapChain_) { swapChain_->Release(); swapChain_ = nullptr; }
-    if (context_) { context_->Release(); context_ = nullptr; }
-    if (device_) { device_->Release(); device_ = nullptr; }
+    for (UINT i = 0; i < D3D12Device::BACK_BUFFER_COUNT; ++i) {
+        if (backBufferViews_[i]) { backBufferViews_[i]->Release(); backBufferViews_[i] = nullptr; }
+        if (wrappedBackBuffers_[i]) { wrappedBackBuffers_[i]->Release(); wrappedBackBuffers_[i] = nullptr; }
+    }
+}
+
+bool GraphicsDevice::Resize(int width, int height) {
+    // Minimized windows report zero size; keep the buffers until the window comes back
+    if (!swapChain_ || width <= 0 || height <= 0) return false;
+    if (width == width_ && height == height_) return true;
+    NEXUS_PROFILE_SCOPE("GraphicsDevice::Resize");
+    
+    // ResizeBuffers fails while anything still references the back buffers, bound or not
+    bool postProcessing = postProcessing_;
+    ReleasePostProcessing();
+    ReleaseSizeDependentResources();
+    context_->ClearState();
+    stateCache_->Invalidate();
+    context_->Flush();
+    
+    // The D3D12 device holds the back buffers itself and waits for the GPU before letting go
+    if (commandGraph_) {
+        commandGraph_->ReleaseTransients();
+    }
+    HRESULT hr = d3d12_ ? (d3d12_->ResizeSwapChain(width, height) ? S_OK : E_FAIL)
+                        : swapChain_->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, swapChainFlags_);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to resize swap chain buffers");
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    if (!CreateSizeDependentResources()) {
+        return false;
+    }
+    
+    // Everything else sized to the screen is recreated at the new size
+    if (postProcessing) {
+        InitializePostProcessing();
+    }
+    if (occlusionCuller_) {
+        bool culling = occlusionCulling_;
+        occlusionCuller_.reset();
+        SetOcclusionCulling(culling);
+    }
+    if (dynamicResolution_) {
+        dynamicResolution_.reset();
+        SetDynamicResolution(true);
+    }
+    if (temporalAA_) {
+        TemporalAA::Settings settings = temporalAA_->GetSettings();
+        temporalAA_.reset();
+        if (SetTemporalAA(true)) {
+            temporalAA_->SetSettings(settings);
+        }
+    }
+    if (overdraw_) {
+        DebugView view = debugView_;
+        overdraw_.reset();
+        SetDebugView(view);
+    }
+    if (textureStreaming_) {
+        textureStreaming_->ResizeFeedback(width_, height_);
+    }
+    
+    CommandContext immediate = GetImmediateCommandContext();
+    BindMainRenderTarget(immediate);
+    Logger::Info("Swap chain resized to " + std::to_string(width) + "x" + std::to_string(height));
+    return true;
 }
 
 void GraphicsDevice::BeginFrame() {
@@ -190,11 +528,94 @@ void GraphicsDevice::BeginFrame() {
         Logger::Info("GraphicsDevice::BeginFrame() - First call");
         firstBegin = false;
     }
-    // Nothing needed for basic implementation
+    
+    batchStats_ = PrimitiveBatchStats();
+    stateCache_->ResetStats();
+    constantRing_->BeginFrame();
+    if (occlusionCuller_) {
+        occlusionCuller_->BeginFrame();
+    }
+    if (textureStreaming_) {
+        textureStreaming_->Update();
+    }
+    if (materialTable_) {
+        materialTable_->Upload();
+    }
+    
+    if (gpuProfiler_) {
+        gpuProfiler_->BeginFrame();
+    }
+    
+    // Scale for this frame from the newest resolved GPU time, then draw the scene into it
+    if (dynamicResolution_ && gpuProfiler_) {
+        dynamicResolution_->Update(gpuProfiler_->GetLastResolvedFrameTime(), gpuProfiler_->GetResolvedFrameCount());
+    }
+    if (temporalAA_) {
+        if (dynamicResolution_) {
+            temporalAA_->BeginFrame(dynamicResolution_->GetRenderWidth(), dynamicResolution_->GetRenderHeight());
+        } else {
+            temporalAA_->BeginFrame();
+        }
+    }
+    
+    if (debugView_ != DebugView::None) {
+        overdraw_->Clear();
+        stateCache_->SetPixelOverride(overdraw_->GetCountShader(), overdraw_->GetCountBlend());
+        if (commandRecorder_) {
+            commandRecorder_->SetPixelOverride(overdraw_->GetCountShader(), overdraw_->GetCountBlend());
+        }
+        debugViewPending_ = true;
+    }
+    
+    // D3D11 may draw to the current D3D12 back buffer until EndFrame hands it back
+    if (d3d12_) {
+        d3d12_->BeginFrame();
+        UINT index = d3d12_->GetBackBufferIndex();
+        renderTargetView_->Release();
+        renderTargetView_ = backBufferViews_[index];
+        renderTargetView_->AddRef();
+        on12_->AcquireWrappedResources(&wrappedBackBuffers_[index], 1);
+    }
+    
+    // Presenting a flip model swap chain unbinds the back buffer, so bind it again every frame
+    CommandContext immediate = GetImmediateCommandContext();
+    BindMainRenderTarget(immediate);
 }
 
 void GraphicsDevice::EndFrame() {
-    // Nothing needed for basic implementation
+    ResolveDebugView();
+    if (renderGraph_ && renderGraph_->HasPasses()) {
+        ExecuteRenderGraph();
+    }
+    if (textureStreaming_) {
+        textureStreaming_->ResolveFeedback();
+    }
+    if (occlusionCulling_ && depthShaderView_) {
+        // Depth can't be read while bound as the depth target
+        stateCache_->OMSetRenderTargets(1, &renderTargetView_, nullptr);
+        DirectX::XMFLOAT4X4 viewProjection;
+        DirectX::XMStoreFloat4x4(&viewProjection, DirectX::XMLoadFloat4x4(&viewMatrix_) * DirectX::XMLoadFloat4x4(&projectionMatrix_));
+        if (dynamicResolution_ || temporalAA_) {
+            UINT renderWidth = 0;
+            UINT renderHeight = 0;
+            GetRenderSize(renderWidth, renderHeight);
+            occlusionCuller_->BuildPyramid(depthShaderView_, viewProjection, renderWidth, renderHeight);
+        } else {
+            occlusionCuller_->BuildPyramid(depthShaderView_, viewProjection);
+        }
+        stateCache_->OMSetRenderTargets(1, &renderTargetView_, depthStencilView_);
+    }
+    if (gpuProfiler_) {
+        gpuProfiler_->EndFrame();
+    }
+    if (d3d12_) {
+        // D3D11 work reaches the queue first, then the command graph's lists
+        on12_->ReleaseWrappedResources(&wrappedBackBuffers_[d3d12_->GetBackBufferIndex()], 1);
+        context_->Flush();
+        if (commandGraph_->HasPasses()) {
+            commandGraph_->Execute();
+        }
+    }
 }
 
 void GraphicsDevice::Present() {
@@ -205,8 +626,20 @@ void GraphicsDevice::Present() {
     }
     
     if (swapChain_) {
-        HRESULT hr = swapChain_->Present(0, 0);
-        if (FAILED(hr)) {
+        // Tearing is only allowed unsynchronized and outside exclusive fullscreen
+        UINT syncInterval = vsync_ ? 1 : 0;
+        UINT flags = (!vsync_ && tearingSupported_ && !fullscreen_) ? DXGI_PRESENT_ALLOW_TEARING : 0;
+        HRESULT hr = d3d12_ ? d3d12_->Present(syncInterval, flags) : swapChain_->Present(syncInterval, flags);
+        
+        // The runtime unbound the back buffer behind the cache's back
+        stateCache_->Invalidate();
+        if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET) {
+            // Only the first failure is worth logging; the device stays lost until reset
+            if (!deviceLost_.exchange(true)) {
+                HRESULT reason = hr == DXGI_ERROR_DEVICE_REMOVED ? device_->GetDeviceRemovedReason() : hr;
+                Logger::Error("Graphics device lost, reason HRESULT: 0x" + std::to_string(reason));
+            }
+        } else if (FAILED(hr)) {
             Logger::Error("Present failed with HRESULT: 0x" + std::to_string(hr));
         } else if (firstPresent) {
             Logger::Info("Present succeeded");
@@ -224,7 +657,7 @@ void GraphicsDevice::Clear(const DirectX::XMFLOAT4& color) {
     }
     
     float clearColor[4] = { color.x, color.y, color.z, color.w };
-    context_->ClearRenderTargetView(renderTargetView_, clearColor);
+    context_->ClearRenderTargetView(GetSceneTarget(), clearColor);
     context_->ClearDepthStencilView(depthStencilView_, D3D11_CLEAR_DEPTH, 1.0f, 0);
 }
 
@@ -236,20 +669,45 @@ void GraphicsDevice::SetViewport(int x, int y, int width, int height) {
     viewport.Height = (float)height;
     viewport.MinDepth = 0.0f;
     viewport.MaxDepth = 1.0f;
-    context_->RSSetViewports(1, &viewport);
-}
-
-bool GraphicsDevice::IsDeviceLost() {
-    return false; // Simplified implementation
+    stateCache_->RSSetViewports(1, &viewport);
 }
 
 bool GraphicsDevice::ResetDevice() {
     return true; // Simplified implementation
 }
 
-// Texture loading functions (now using UnrealTextureLoader)
+bool GraphicsDevice::QueryVideoMemory(GpuMemoryStats& stats) const {
+    stats = GpuMemoryStats();
+    if (!adapter_) return false;
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO local = {};
+    DXGI_QUERY_VIDEO_MEMORY_INFO nonLocal = {};
+    if (FAILED(adapter_->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &local)) ||
+        FAILED(adapter_->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &nonLocal))) {
+        return false;
+    }
+    stats.localUsage = local.CurrentUsage;
+    stats.localBudget = local.Budget;
+    stats.nonLocalUsage = nonLocal.CurrentUsage;
+    stats.nonLocalBudget = nonLocal.Budget;
+    stats.available = true;
+    return true;
+}
+
+// Texture loading. DDS/KTX2 go straight from a file mapping to the GPU; other formats go
+// through UnrealTextureLoader
 ID3D11Texture2D* GraphicsDevice::LoadTexture(const std::string& filename) {
     Logger::Info("Loading texture: " + filename);
+
+    if (TextureFile::IsContainer(filename)) {
+        TextureFile file;
+        ID3D11Texture2D* texture = nullptr;
+        if (!file.Open(filename) || FAILED(file.CreateTexture(device_, &texture, nullptr))) {
+            Logger::Error("Failed to load texture: " + filename);
+            return nullptr;
+        }
+        return texture;
+    }
     
     auto textureData = UnrealTextureLoader::LoadUnrealTexture(filename);
     if (!textureData || !textureData->IsValid()) {
@@ -296,13 +754,6 @@ ID3D11Texture2D* GraphicsDevice::LoadUnrealTexture(const std::string& filename)
 
 ID3D11Texture2D* GraphicsDevice::LoadDDSTexture(const std::string& filename) {
     Logger::Info("Loading DDS texture: " + filename);
-    
-    auto textureData = UnrealTextureLoader::LoadDDS(filename);
-    if (!textureData || !textureData->IsValid()) {
-        Logger::Error("Failed to load DDS texture: " + filename);
-        return nullptr;
-    }
-    
     return LoadTexture(filename);
 }
 
@@ -330,6 +781,15 @@ ID3D11Texture2D* GraphicsDevice::LoadBMPTexture(const std::string& filename) {
     return LoadTexture(filename);
 }
 
+int GraphicsDevice::LoadSprite(const std::string& filename) {
+    if (!sprites_) return 0;
+    ID3D11Texture2D* texture = LoadTexture(filename);
+    if (!texture) return 0;
+    int id = sprites_->AddTexture(texture);
+    texture->Release();
+    return id;
+}
+
 bool GraphicsDevice::LoadUnrealAsset(const std::string& filename) {
     Logger::Info("Loading Unreal asset: " + filename);
     
@@ -394,6 +854,15 @@ void GraphicsDevice::InitializePrimitiveRendering() {
     // Create constant buffer
     CreateConstantBuffer();
     
+    // Instanced path shares the geometry and pixel shader
+    CreateInstancedShaders();
+    
+    // 2D batches are optional, the 3D primitives work without them
+    sprites_ = std::make_unique<SpriteBatcher>();
+    if (!sprites_->Initialize(device_, context_, stateCache_.get())) {
+        sprites_.reset();
+    }
+    
     Logger::Info("Primitive rendering initialized successfully");
 }
 
@@ -607,13 +1076,12 @@ void GraphicsDevice::CreateBasicShaders() {
     
     // Compile vertex shader
     ID3DBlob* vsBlob = nullptr;
-    ID3DBlob* errorBlob = nullptr;
+    std::string errors;
     
-    HRESULT hr = D3DCompile(vertexShaderSource, strlen(vertexShaderSource), nullptr, nullptr, nullptr, "main", "vs_5_0", D3DCOMPILE_DEBUG, 0, &vsBlob, &errorBlob);
+    HRESULT hr = ShaderCache::Compile(vertexShaderSource, nullptr, "main", "vs_5_0", D3DCOMPILE_DEBUG, &vsBlob, &errors);
     if (FAILED(hr)) {
-        if (errorBlob) {
-            Logger::Error("Vertex shader compilation error: " + std::string((char*)errorBlob->GetBufferPointer()));
-            errorBlob->Release();
+        if (!errors.empty()) {
+            Logger::Error("Vertex shader compilation error: " + errors);
         }
         Logger::Error("Failed to compile vertex shader");
         return;
@@ -641,11 +1109,10 @@ void GraphicsDevice::CreateBasicShaders() {
     
     // Compile pixel shader
     ID3DBlob* psBlob = nullptr;
-    hr = D3DCompile(pixelShaderSource, strlen(pixelShaderSource), nullptr, nullptr, nullptr, "main", "ps_5_0", D3DCOMPILE_DEBUG, 0, &psBlob, &errorBlob);
+    hr = ShaderCache::Compile(pixelShaderSource, nullptr, "main", "ps_5_0", D3DCOMPILE_DEBUG, &psBlob, &errors);
     if (FAILED(hr)) {
-        if (errorBlob) {
-            Logger::Error("Pixel shader compilation error: " + std::string((char*)errorBlob->GetBufferPointer()));
-            errorBlob->Release();
+        if (!errors.empty()) {
+            Logger::Error("Pixel shader compilation error: " + errors);
         }
         Logger::Error("Failed to compile pixel shader");
         return;
@@ -662,15 +1129,9 @@ void GraphicsDevice::CreateBasicShaders() {
 }
 
 void GraphicsDevice::CreateConstantBuffer() {
-    D3D11_BUFFER_DESC bufferDesc = {};
-    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    bufferDesc.ByteWidth = sizeof(ConstantBufferData);
-    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    bufferDesc.CPUAccessFlags = 0;
-    
-    HRESULT hr = device_->CreateBuffer(&bufferDesc, nullptr, &constantBuffer_);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create constant buffer");
+    // Every draw takes its constants from the ring instead of updating one shared buffer
+    if (!constantRing_->Initialize(device_, context_)) {
+        Logger::Error("Failed to create constant buffer ring");
     }
 }
 
@@ -689,119 +1150,560 @@ void GraphicsDevice::SetupBasicCamera(const DirectX::XMFLOAT3& position, const D
 }
 
 void GraphicsDevice::RenderBox(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& size, const DirectX::XMFLOAT4& color) {
-    if (!boxVertexBuffer_ || !boxIndexBuffer_ || !basicVertexShader_ || !basicPixelShader_) return;
-    
-    // Setup world matrix
+    CommandContext immediate = GetImmediateCommandContext();
+    RecordBox(immediate, position, size, color);
+}
+
+void GraphicsDevice::RenderSphere(const DirectX::XMFLOAT3& position, float radius, const DirectX::XMFLOAT4& color) {
+    CommandContext immediate = GetImmediateCommandContext();
+    RecordSphere(immediate, position, radius, color);
+}
+
+void GraphicsDevice::RenderCapsule(const DirectX::XMFLOAT3& position, float radius, float height, const DirectX::XMFLOAT4& color) {
+    CommandContext immediate = GetImmediateCommandContext();
+    RecordCapsule(immediate, position, radius, height, color);
+}
+
+void GraphicsDevice::RecordBox(CommandContext& target, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& size, const DirectX::XMFLOAT4& color) {
     DirectX::XMMATRIX world = DirectX::XMMatrixScaling(size.x, size.y, size.z) * DirectX::XMMatrixTranslation(position.x, position.y, position.z);
+    DrawBasicPrimitive(target, boxVertexBuffer_, boxIndexBuffer_, 36, world, color);
+}
+
+void GraphicsDevice::RecordSphere(CommandContext& target, const DirectX::XMFLOAT3& position, float radius, const DirectX::XMFLOAT4& color) {
+    DirectX::XMMATRIX world = DirectX::XMMatrixScaling(radius, radius, radius) * DirectX::XMMatrixTranslation(position.x, position.y, position.z);
+    DrawBasicPrimitive(target, sphereVertexBuffer_, sphereIndexBuffer_, static_cast<UINT>(sphereIndexCount_), world, color);
+}
+
+void GraphicsDevice::RecordCapsule(CommandContext& target, const DirectX::XMFLOAT3& position, float radius, float height, const DirectX::XMFLOAT4& color) {
+    // For now, just render as a stretched sphere
+    RecordSphere(target, position, radius, color);
+}
+
+void GraphicsDevice::DrawBasicPrimitive(CommandContext& target, ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer, UINT indexCount,
+                                        const DirectX::XMMATRIX& world, const DirectX::XMFLOAT4& color) {
+    if (!vertexBuffer || !indexBuffer || !basicVertexShader_ || !basicPixelShader_) return;
     
     // Update constant buffer
     ConstantBufferData cbData;
     DirectX::XMStoreFloat4x4(&cbData.world, world);
     cbData.view = viewMatrix_;
-    cbData.projection = projectionMatrix_;
+    cbData.projection = GetDrawProjection();
     cbData.color = color;
     
-    context_->UpdateSubresource(constantBuffer_, 0, nullptr, &cbData, 0, 0);
+    ConstantBufferRing::Allocation constants;
+    if (!target.constants->Upload(cbData, constants)) return;
     
     // Set shaders and input layout
-    context_->VSSetShader(basicVertexShader_, nullptr, 0);
-    context_->PSSetShader(basicPixelShader_, nullptr, 0);
-    context_->IASetInputLayout(basicInputLayout_);
+    StateCache& state = *target.stateCache;
+    state.VSSetShader(basicVertexShader_);
+    state.PSSetShader(basicPixelShader_);
+    state.IASetInputLayout(basicInputLayout_);
     
     // Set vertex and index buffers
     UINT stride = sizeof(Vertex);
     UINT offset = 0;
-    context_->IASetVertexBuffers(0, 1, &boxVertexBuffer_, &stride, &offset);
-    context_->IASetIndexBuffer(boxIndexBuffer_, DXGI_FORMAT_R32_UINT, 0);
-    context_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    state.IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+    state.IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    state.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     
     // Set constant buffer
-    context_->VSSetConstantBuffers(0, 1, &constantBuffer_);
+    state.VSSetConstantBuffers1(0, 1, &constants.buffer, &constants.firstConstant, &constants.numConstants);
     
     // Draw
-    context_->DrawIndexed(36, 0, 0);
+    target.context->DrawIndexed(indexCount, 0, 0);
 }
 
-void GraphicsDevice::RenderSphere(const DirectX::XMFLOAT3& position, float radius, const DirectX::XMFLOAT4& color) {
-    if (!sphereVertexBuffer_ || !sphereIndexBuffer_ || !basicVertexShader_ || !basicPixelShader_) return;
+CommandContext GraphicsDevice::GetImmediateCommandContext() const {
+    CommandContext immediate;
+    immediate.context = context_;
+    immediate.stateCache = stateCache_.get();
+    immediate.constants = constantRing_.get();
+    return immediate;
+}
+
+void GraphicsDevice::BindMainRenderTarget(CommandContext& target) {
+    // Moving geometry writes its own motion to the second target under temporal anti-aliasing
+    ID3D11RenderTargetView* scene = debugViewPending_ ? overdraw_->GetCounterTarget() : GetSceneTarget();
+    ID3D11RenderTargetView* targets[2] = { scene, temporalAA_ ? temporalAA_->GetVelocityTarget() : nullptr };
+    target.stateCache->OMSetRenderTargets(temporalAA_ ? 2 : 1, targets, depthStencilView_);
+    
+    // At a reduced scale the scene covers the top-left of the target and of the depth buffer
+    UINT renderWidth = 0;
+    UINT renderHeight = 0;
+    GetRenderSize(renderWidth, renderHeight);
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = (float)renderWidth;
+    viewport.Height = (float)renderHeight;
+    viewport.MinDepth = 0.0f;
+    viewport.MaxDepth = 1.0f;
+    target.stateCache->RSSetViewports(1, &viewport);
+}
+
+bool GraphicsDevice::SetOcclusionCulling(bool enabled) {
+    if (enabled && !occlusionCuller_ && device_ && depthShaderView_) {
+        occlusionCuller_ = std::make_unique<OcclusionCuller>();
+        if (!occlusionCuller_->Initialize(device_, context_, width_, height_)) {
+            Logger::Warning("Occlusion culling unavailable on this device");
+            occlusionCuller_.reset();
+        }
+    }
+    occlusionCulling_ = enabled && occlusionCuller_;
+    return occlusionCulling_;
+}
+
+ID3D11RenderTargetView* GraphicsDevice::GetSceneTarget() const {
+    if (dynamicResolution_) return dynamicResolution_->GetSceneTarget();
+    return temporalAA_ ? temporalAA_->GetSceneTarget() : renderTargetView_;
+}
+
+void GraphicsDevice::GetRenderSize(UINT& width, UINT& height) const {
+    if (dynamicResolution_) {
+        width = dynamicResolution_->GetRenderWidth();
+        height = dynamicResolution_->GetRenderHeight();
+    } else if (temporalAA_) {
+        width = temporalAA_->GetRenderWidth();
+        height = temporalAA_->GetRenderHeight();
+    } else {
+        width = static_cast<UINT>(width_);
+        height = static_cast<UINT>(height_);
+    }
+}
+
+DirectX::XMFLOAT4X4 GraphicsDevice::GetDrawProjection() const {
+    if (!temporalAA_) return projectionMatrix_;
+    DirectX::XMFLOAT4X4 projection;
+    DirectX::XMStoreFloat4x4(&projection, temporalAA_->JitterProjection(DirectX::XMLoadFloat4x4(&projectionMatrix_)));
+    return projection;
+}
+
+bool GraphicsDevice::SetDynamicResolution(bool enabled) {
+    if (enabled && !dynamicResolution_ && device_) {
+        dynamicResolution_ = std::make_unique<DynamicResolution>();
+        if (!dynamicResolution_->Initialize(device_, context_, stateCache_.get(), width_, height_,
+                                            DynamicResolution::Settings())) {
+            Logger::Warning("Dynamic resolution unavailable, rendering at native resolution");
+            dynamicResolution_.reset();
+        }
+    } else if (!enabled) {
+        dynamicResolution_.reset();
+    }
     
-    // Setup world matrix
-    DirectX::XMMATRIX world = DirectX::XMMatrixScaling(radius, radius, radius) * DirectX::XMMatrixTranslation(position.x, position.y, position.z);
+    if (device_) {
+        CommandContext immediate = GetImmediateCommandContext();
+        BindMainRenderTarget(immediate);
+    }
+    return dynamicResolution_ != nullptr;
+}
+
+bool GraphicsDevice::SetTemporalAA(bool enabled) {
+    // The resolve reads the scene depth
+    if (enabled && !temporalAA_ && device_ && depthShaderView_) {
+        temporalAA_ = std::make_unique<TemporalAA>();
+        if (!temporalAA_->Initialize(device_, context_, stateCache_.get(), width_, height_, TemporalAA::Settings())) {
+            Logger::Warning("Temporal anti-aliasing unavailable on this device");
+            temporalAA_.reset();
+        }
+    } else if (!enabled) {
+        temporalAA_.reset();
+    }
     
-    // Update constant buffer
-    ConstantBufferData cbData;
-    DirectX::XMStoreFloat4x4(&cbData.world, world);
-    cbData.view = viewMatrix_;
-    cbData.projection = projectionMatrix_;
-    cbData.color = color;
+    if (device_) {
+        CommandContext immediate = GetImmediateCommandContext();
+        BindMainRenderTarget(immediate);
+    }
+    return temporalAA_ != nullptr;
+}
+
+void GraphicsDevice::UpscaleScene() {
+    ResolveDebugView();
+    if (!dynamicResolution_ && !temporalAA_) return;
+    NEXUS_PROFILE_SCOPE("GraphicsDevice::UpscaleScene");
+    GpuProfileScope gpuScope(gpuProfiler_.get(), "Upscale");
+    if (temporalAA_) {
+        ID3D11ShaderResourceView* scene = dynamicResolution_ ? dynamicResolution_->GetSceneView() : temporalAA_->GetSceneView();
+        temporalAA_->Resolve(scene, depthShaderView_, DirectX::XMLoadFloat4x4(&viewMatrix_),
+                             DirectX::XMLoadFloat4x4(&projectionMatrix_), renderTargetView_);
+    } else {
+        dynamicResolution_->Upscale(renderTargetView_);
+    }
+}
+
+bool GraphicsDevice::SetDebugView(DebugView view) {
+    if (debugViewPending_) {
+        ResolveDebugView();
+    }
+    if (view != DebugView::None && !overdraw_ && device_) {
+        overdraw_ = std::make_unique<OverdrawVisualizer>();
+        if (!overdraw_->Initialize(device_, context_, stateCache_.get(), width_, height_)) {
+            Logger::Warning("Overdraw debug views unavailable on this device");
+            overdraw_.reset();
+        }
+    } else if (view == DebugView::None) {
+        overdraw_.reset();
+    }
+    debugView_ = overdraw_ ? view : DebugView::None;
+    return debugView_ == view;
+}
+
+void GraphicsDevice::ResolveDebugView() {
+    if (!debugViewPending_) return;
+    debugViewPending_ = false;
+    stateCache_->SetPixelOverride(nullptr, nullptr);
+    if (commandRecorder_) {
+        commandRecorder_->SetPixelOverride(nullptr, nullptr);
+    }
     
-    context_->UpdateSubresource(constantBuffer_, 0, nullptr, &cbData, 0, 0);
+    NEXUS_PROFILE_SCOPE("GraphicsDevice::ResolveDebugView");
+    GpuProfileScope gpuScope(gpuProfiler_.get(), "DebugView");
+    UINT renderWidth = 0;
+    UINT renderHeight = 0;
+    GetRenderSize(renderWidth, renderHeight);
+    overdraw_->Resolve(debugView_ == DebugView::QuadOvershading ? OverdrawVisualizer::Mode::QuadOvershading
+                                                                : OverdrawVisualizer::Mode::Overdraw,
+                       GetSceneTarget(), renderWidth, renderHeight);
+    CommandContext immediate = GetImmediateCommandContext();
+    BindMainRenderTarget(immediate);
+}
+
+bool GraphicsDevice::EnableParallelSubmission(unsigned int contextCount) {
+    if (!device_) return false;
     
-    // Set shaders and input layout
-    context_->VSSetShader(basicVertexShader_, nullptr, 0);
-    context_->PSSetShader(basicPixelShader_, nullptr, 0);
-    context_->IASetInputLayout(basicInputLayout_);
+    commandRecorder_ = std::make_unique<CommandRecorder>();
+    if (!commandRecorder_->Initialize(device_, contextCount)) {
+        Logger::Warning("Deferred contexts unavailable, parallel submission disabled");
+        commandRecorder_.reset();
+        return false;
+    }
+    return true;
+}
+
+void GraphicsDevice::CreateInstancedShaders() {
+    // World matrix and color arrive per instance; only view-projection lives in a constant buffer
+    const char* vertexShaderSource = R"(
+        cbuffer FrameConstants : register(b0)
+        {
+            matrix ViewProjection;
+        };
+        
+        struct VS_INPUT
+        {
+            float3 Position : POSITION;
+            float3 Normal : NORMAL;
+            float4 World0 : WORLD0;
+            float4 World1 : WORLD1;
+            float4 World2 : WORLD2;
+            float4 World3 : WORLD3;
+            float4 Color : COLOR;
+        };
+        
+        struct VS_OUTPUT
+        {
+            float4 Position : SV_POSITION;
+            float3 Normal : NORMAL;
+            float4 Color : COLOR;
+        };
+        
+        VS_OUTPUT main(VS_INPUT input)
+        {
+            VS_OUTPUT output;
+            
+            float4x4 world = float4x4(input.World0, input.World1, input.World2, input.World3);
+            float4 worldPosition = mul(float4(input.Position, 1.0f), world);
+            output.Position = mul(worldPosition, ViewProjection);
+            output.Normal = normalize(mul(input.Normal, (float3x3)world));
+            output.Color = input.Color;
+            
+            return output;
+        }
+    )";
     
-    // Set vertex and index buffers
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    context_->IASetVertexBuffers(0, 1, &sphereVertexBuffer_, &stride, &offset);
-    context_->IASetIndexBuffer(sphereIndexBuffer_, DXGI_FORMAT_R32_UINT, 0);
-    context_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3DBlob* vsBlob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(vertexShaderSource, nullptr, "main", "vs_5_0", 0, &vsBlob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error("Instanced vertex shader compilation error: " + errors);
+        }
+        Logger::Error("Failed to compile instanced vertex shader, batched primitives fall back to per-object draws");
+        return;
+    }
     
-    // Set constant buffer
-    context_->VSSetConstantBuffers(0, 1, &constantBuffer_);
+    hr = device_->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &instancedVertexShader_);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create instanced vertex shader");
+        vsBlob->Release();
+        return;
+    }
     
-    // Draw
-    context_->DrawIndexed(sphereIndexCount_, 0, 0);
+    D3D11_INPUT_ELEMENT_DESC layout[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 64, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    };
+    
+    hr = device_->CreateInputLayout(layout, ARRAYSIZE(layout), vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &instancedInputLayout_);
+    vsBlob->Release();
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create instanced input layout");
+        instancedVertexShader_->Release();
+        instancedVertexShader_ = nullptr;
+        return;
+    }
+    
+    EnsureInstanceCapacity(1024);
 }
 
-void GraphicsDevice::RenderCapsule(const DirectX::XMFLOAT3& position, float radius, float height, const DirectX::XMFLOAT4& color) {
-    // For now, just render as a stretched sphere
-    RenderSphere(position, radius, color);
+bool GraphicsDevice::EnsureInstanceCapacity(UINT instanceCount) {
+    if (instanceBuffer_ && instanceCount <= instanceCapacity_) return true;
+    
+    UINT capacity = instanceCapacity_ > 0 ? instanceCapacity_ : 1024;
+    while (capacity < instanceCount) {
+        capacity *= 2;
+    }
+    
+    if (instanceView_) {
+        instanceView_->Release();
+        instanceView_ = nullptr;
+    }
+    if (instanceBuffer_) {
+        instanceBuffer_->Release();
+        instanceBuffer_ = nullptr;
+    }
+    instanceCapacity_ = 0;
+    
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = sizeof(PrimitiveInstance) * capacity;
+    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_SHADER_RESOURCE;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    
+    HRESULT hr = device_->CreateBuffer(&bufferDesc, nullptr, &instanceBuffer_);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create instance buffer for " + std::to_string(capacity) + " instances");
+        return false;
+    }
+    
+    // Without the view the batch still draws, just without occlusion culling
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+    viewDesc.BufferEx.NumElements = bufferDesc.ByteWidth / 4;
+    viewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+    device_->CreateShaderResourceView(instanceBuffer_, &viewDesc, &instanceView_);
+    
+    instanceCapacity_ = capacity;
+    return true;
 }
 
-void GraphicsDevice::InitializePostProcessing() {
-    Logger::Info("Initializing post-processing effects...");
+void GraphicsDevice::AppendInstance(std::vector<PrimitiveInstance>& instances, const DirectX::XMFLOAT3& position,
+                                    const DirectX::XMFLOAT3& scale, const DirectX::XMFLOAT4& color) {
+    // Scale + translation only, written directly instead of going through XMMATRIX
+    PrimitiveInstance instance;
+    instance.world = DirectX::XMFLOAT4X4(
+        scale.x, 0.0f, 0.0f, 0.0f,
+        0.0f, scale.y, 0.0f, 0.0f,
+        0.0f, 0.0f, scale.z, 0.0f,
+        position.x, position.y, position.z, 1.0f);
+    instance.color = color;
+    instances.push_back(instance);
+}
+
+void GraphicsDevice::SubmitBox(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& size, const DirectX::XMFLOAT4& color) {
+    AppendInstance(boxInstances_, position, size, color);
+}
+
+void GraphicsDevice::SubmitSphere(const DirectX::XMFLOAT3& position, float radius, const DirectX::XMFLOAT4& color) {
+    AppendInstance(sphereInstances_, position, DirectX::XMFLOAT3(radius, radius, radius), color);
+}
+
+void GraphicsDevice::SubmitCapsule(const DirectX::XMFLOAT3& position, float radius, float height, const DirectX::XMFLOAT4& color) {
+    // Stretched sphere until a capsule mesh exists
+    float halfExtent = radius + height * 0.5f;
+    AppendInstance(sphereInstances_, position, DirectX::XMFLOAT3(radius, halfExtent, radius), color);
+}
+
+void GraphicsDevice::SubmitBoxes(const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* sizes,
+                                 const DirectX::XMFLOAT4* colors, size_t count) {
+    const DirectX::XMFLOAT3 unitSize(1.0f, 1.0f, 1.0f);
+    const DirectX::XMFLOAT4 white(1.0f, 1.0f, 1.0f, 1.0f);
+    if (boxInstances_.capacity() < boxInstances_.size() + count) {
+        boxInstances_.reserve(std::max(boxInstances_.size() + count, boxInstances_.capacity() * 2));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        AppendInstance(boxInstances_, positions[i], sizes ? sizes[i] : unitSize, colors ? colors[i] : white);
+    }
+}
+
+void GraphicsDevice::SubmitSpheres(const DirectX::XMFLOAT3* positions, const float* radii,
+                                   const DirectX::XMFLOAT4* colors, size_t count) {
+    const DirectX::XMFLOAT4 white(1.0f, 1.0f, 1.0f, 1.0f);
+    if (sphereInstances_.capacity() < sphereInstances_.size() + count) {
+        sphereInstances_.reserve(std::max(sphereInstances_.size() + count, sphereInstances_.capacity() * 2));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        float radius = radii ? radii[i] : 1.0f;
+        AppendInstance(sphereInstances_, positions[i], DirectX::XMFLOAT3(radius, radius, radius), colors ? colors[i] : white);
+    }
+}
+
+void GraphicsDevice::FlushPrimitiveBatch() {
+    const size_t total = boxInstances_.size() + sphereInstances_.size();
+    if (total == 0) return;
     
-    // Create bloom render target
-    D3D11_TEXTURE2D_DESC textureDesc = {};
-    textureDesc.Width = width_ / 2;  // Half resolution for bloom
-    textureDesc.Height = height_ / 2;
-    textureDesc.MipLevels = 1;
-    textureDesc.ArraySize = 1;
-    textureDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.SampleDesc.Quality = 0;
-    textureDesc.Usage = D3D11_USAGE_DEFAULT;
-    textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-    textureDesc.CPUAccessFlags = 0;
-    textureDesc.MiscFlags = 0;
+    NEXUS_PROFILE_SCOPE("GraphicsDevice::FlushPrimitiveBatch");
+    
+    // No instancing support compiled: replay through the per-object path
+    if (!instancedVertexShader_ || !EnsureInstanceCapacity(static_cast<UINT>(total))) {
+        for (const auto& instance : boxInstances_) {
+            RenderBox(DirectX::XMFLOAT3(instance.world._41, instance.world._42, instance.world._43),
+                      DirectX::XMFLOAT3(instance.world._11, instance.world._22, instance.world._33), instance.color);
+        }
+        for (const auto& instance : sphereInstances_) {
+            RenderSphere(DirectX::XMFLOAT3(instance.world._41, instance.world._42, instance.world._43),
+                         instance.world._11, instance.color);
+        }
+        boxInstances_.clear();
+        sphereInstances_.clear();
+        return;
+    }
+    
+    // One upload for every instance of every shape
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(instanceBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        Logger::Error("Failed to map instance buffer");
+        boxInstances_.clear();
+        sphereInstances_.clear();
+        return;
+    }
+    PrimitiveInstance* destination = static_cast<PrimitiveInstance*>(mapped.pData);
+    if (!boxInstances_.empty()) {
+        std::memcpy(destination, boxInstances_.data(), sizeof(PrimitiveInstance) * boxInstances_.size());
+    }
+    if (!sphereInstances_.empty()) {
+        std::memcpy(destination + boxInstances_.size(), sphereInstances_.data(), sizeof(PrimitiveInstance) * sphereInstances_.size());
+    }
+    context_->Unmap(instanceBuffer_, 0);
+    
+    // HLSL reads constant buffer matrices column-major, so upload the transpose
+    DirectX::XMFLOAT4X4 projection = GetDrawProjection();
+    DirectX::XMFLOAT4X4 viewProjection;
+    DirectX::XMStoreFloat4x4(&viewProjection, DirectX::XMMatrixTranspose(
+        DirectX::XMLoadFloat4x4(&viewMatrix_) * DirectX::XMLoadFloat4x4(&projection)));
+    ConstantBufferRing::Allocation constants;
+    if (!constantRing_->Upload(viewProjection, constants)) {
+        boxInstances_.clear();
+        sphereInstances_.clear();
+        return;
+    }
+    
+    // Shared state for every shape
+    stateCache_->VSSetShader(instancedVertexShader_);
+    stateCache_->PSSetShader(basicPixelShader_);
+    stateCache_->IASetInputLayout(instancedInputLayout_);
+    stateCache_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    stateCache_->VSSetConstantBuffers1(0, 1, &constants.buffer, &constants.firstConstant, &constants.numConstants);
+    
+    // Cull every shape before any draw binds the compacted results as a vertex buffer
+    const UINT boxCount = static_cast<UINT>(boxInstances_.size());
+    const UINT sphereCount = static_cast<UINT>(sphereInstances_.size());
+    UINT boxArguments = 0;
+    UINT sphereArguments = 0;
+    bool boxCulled = false;
+    bool sphereCulled = false;
+    if (occlusionCulling_ && occlusionCuller_->HasPyramid() && instanceView_) {
+        // Slot 1 may still hold the visible-instance buffer from the last flush, which the
+        // cull shader is about to write
+        UINT stride = sizeof(PrimitiveInstance);
+        UINT offset = 0;
+        stateCache_->IASetVertexBuffers(1, 1, &instanceBuffer_, &stride, &offset);
+        boxCulled = occlusionCuller_->Cull(instanceView_, instanceCapacity_, 0, boxCount, 36, boxArguments);
+        sphereCulled = occlusionCuller_->Cull(instanceView_, instanceCapacity_, boxCount, sphereCount,
+                                              static_cast<UINT>(sphereIndexCount_), sphereArguments);
+    }
+    
+    UINT firstInstance = 0;
+    DrawInstances(boxInstances_, firstInstance, boxVertexBuffer_, boxIndexBuffer_, 36, boxCulled, boxArguments);
+    DrawInstances(sphereInstances_, firstInstance, sphereVertexBuffer_, sphereIndexBuffer_, static_cast<UINT>(sphereIndexCount_),
+                  sphereCulled, sphereArguments);
+    
+    batchStats_.instances += static_cast<unsigned int>(total);
+    boxInstances_.clear();
+    sphereInstances_.clear();
+}
 
-    HRESULT hr = device_->CreateTexture2D(&textureDesc, nullptr, &bloomTexture_);
-    if (SUCCEEDED(hr)) {
-        device_->CreateRenderTargetView(bloomTexture_, nullptr, &bloomRenderTarget_);
-        Logger::Info("Bloom render target created successfully");
+void GraphicsDevice::DrawInstances(const std::vector<PrimitiveInstance>& instances, UINT& firstInstance,
+                                   ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer, UINT indexCount,
+                                   bool occlusionCulled, UINT argumentsOffset) {
+    if (instances.empty()) return;
+    
+    UINT instanceCount = static_cast<UINT>(instances.size());
+    if (vertexBuffer && indexBuffer) {
+        // Culled survivors sit at the same offsets in the compacted buffer, counted on the GPU
+        ID3D11Buffer* buffers[] = { vertexBuffer, occlusionCulled ? occlusionCuller_->GetVisibleInstances() : instanceBuffer_ };
+        UINT strides[] = { sizeof(Vertex), sizeof(PrimitiveInstance) };
+        UINT offsets[] = { 0, 0 };
+        stateCache_->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+        stateCache_->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+        if (occlusionCulled) {
+            context_->DrawIndexedInstancedIndirect(occlusionCuller_->GetDrawArguments(), argumentsOffset);
+        } else {
+            context_->DrawIndexedInstanced(indexCount, instanceCount, 0, 0, firstInstance);
+        }
+        batchStats_.drawCalls++;
     }
+    firstInstance += instanceCount;
+}
 
-    // Create heat haze render target
-    textureDesc.Width = width_;
-    textureDesc.Height = height_;
-    textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+void GraphicsDevice::FlushSpriteBatch() {
+    if (!sprites_ || sprites_->GetQueuedSprites() == 0) return;
+    GpuProfileScope gpuScope(gpuProfiler_.get(), "Sprites");
+    sprites_->Flush(static_cast<UINT>(width_), static_cast<UINT>(height_));
+}
+
+void GraphicsDevice::ReleasePostProcessing() {
+    if (shadowMapDepth_) { shadowMapDepth_->Release(); shadowMapDepth_ = nullptr; }
+    if (shadowMap_) { shadowMap_->Release(); shadowMap_ = nullptr; }
+    bloom_.reset();
+    // Pooled intermediates are sized to the back buffer
+    if (renderGraph_) {
+        renderGraph_->ReleaseTransients();
+    }
+    postProcessing_ = false;
+}
+
+void GraphicsDevice::InitializePostProcessing() {
+    Logger::Info("Initializing post-processing effects...");
     
-    hr = device_->CreateTexture2D(&textureDesc, nullptr, &heatHazeTexture_);
-    if (SUCCEEDED(hr)) {
-        device_->CreateRenderTargetView(heatHazeTexture_, nullptr, &heatHazeRenderTarget_);
-        Logger::Info("Heat haze render target created successfully");
+    // Bloom and heat haze targets are render graph transients, allocated when their passes run
+    BloomRenderer::Settings bloomSettings;
+    bloomSettings.threshold = bloomThreshold_;
+    bloomSettings.intensity = bloomIntensity_;
+    bloom_ = std::make_unique<BloomRenderer>();
+    if (bloom_->Initialize(device_, context_, width_, height_, bloomSettings)) {
+        Logger::Info("Bloom targets created successfully");
+    } else {
+        bloom_.reset();
     }
+    postProcessing_ = true;
 
     // Create shadow map
+    D3D11_TEXTURE2D_DESC textureDesc = {};
     textureDesc.Width = shadowMapSize_;
     textureDesc.Height = shadowMapSize_;
+    textureDesc.MipLevels = 1;
+    textureDesc.ArraySize = 1;
     textureDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.SampleDesc.Quality = 0;
+    textureDesc.Usage = D3D11_USAGE_DEFAULT;
     textureDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
     
-    hr = device_->CreateTexture2D(&textureDesc, nullptr, &shadowMap_);
+    HRESULT hr = device_->CreateTexture2D(&textureDesc, nullptr, &shadowMap_);
     if (SUCCEEDED(hr)) {
         D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
         dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
@@ -814,56 +1716,94 @@ void GraphicsDevice::InitializePostProcessing() {
 }
 
 void GraphicsDevice::RenderBloomPass() {
-    if (!bloomRenderTarget_ || !bloomTexture_) return;
+    NEXUS_PROFILE_SCOPE("GraphicsDevice::BloomPass");
+    if (!bloomEnabled_ || !bloom_ || !renderGraph_) return;
 
-    // Set bloom render target
-    context_->OMSetRenderTargets(1, &bloomRenderTarget_, nullptr);
-    
-    // Clear bloom buffer
-    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-    context_->ClearRenderTargetView(bloomRenderTarget_, clearColor);
-    
-    // Set viewport for bloom (half resolution)
-    D3D11_VIEWPORT viewport = {};
-    viewport.Width = (float)width_ / 2;
-    viewport.Height = (float)height_ / 2;
-    viewport.MinDepth = 0.0f;
-    viewport.MaxDepth = 1.0f;
-    context_->RSSetViewports(1, &viewport);
-    
-    // Render bright pixels only
-    // This would typically use a bloom shader that extracts bright pixels
-    // For now, we'll just clear the buffer
-    
-    // Restore main render target
-    context_->OMSetRenderTargets(1, &renderTargetView_, depthStencilView_);
-    
-    // Restore full viewport
-    viewport.Width = (float)width_;
-    viewport.Height = (float)height_;
-    context_->RSSetViewports(1, &viewport);
-    
-    Logger::Debug("Bloom pass completed");
+    // The swap chain keeps the back buffer alive past this reference
+    ID3D11Resource* backBufferResource = nullptr;
+    renderTargetView_->GetResource(&backBufferResource);
+    ID3D11Texture2D* backBuffer = static_cast<ID3D11Texture2D*>(backBufferResource);
+    D3D11_TEXTURE2D_DESC backBufferDesc;
+    backBuffer->GetDesc(&backBufferDesc);
+    RenderGraph::ResourceHandle target = renderGraph_->ImportTexture("BackBuffer", backBuffer, nullptr, renderTargetView_);
+    backBufferResource->Release();
+
+    // Bloom reads a copy of the back buffer and writes a second texture, which is copied back;
+    // the swap chain itself allows neither. The copy uses the default render target bindings so
+    // it can share memory with the heat haze buffer
+    RenderGraph::TextureDesc desc;
+    desc.width = backBufferDesc.Width;
+    desc.height = backBufferDesc.Height;
+    desc.format = backBufferDesc.Format;
+    RenderGraph::ResourceHandle source = renderGraph_->CreateTexture("BloomSource", desc);
+    desc.bindFlags = D3D11_BIND_UNORDERED_ACCESS;
+    RenderGraph::ResourceHandle output = renderGraph_->CreateTexture("BloomOutput", desc);
+
+    renderGraph_->AddPass("BloomCopy",
+        [=](RenderGraph::Builder& builder) {
+            builder.Read(target);
+            builder.Write(source);
+        },
+        [this, target, source](RenderGraph& graph) {
+            context_->CopyResource(graph.GetTexture(source), graph.GetTexture(target));
+        });
+    renderGraph_->AddPass("Bloom",
+        [=](RenderGraph::Builder& builder) {
+            builder.Read(source);
+            builder.Write(output);
+        },
+        [this, source, output](RenderGraph& graph) {
+            GpuProfileScope gpuScope(gpuProfiler_.get(), "Bloom");
+            bloom_->Render(graph.GetShaderResourceView(source), graph.GetUnorderedAccessView(output));
+        });
+    renderGraph_->AddPass("BloomResolve",
+        [=](RenderGraph::Builder& builder) {
+            builder.Read(output);
+            builder.Write(target);
+        },
+        [this, output, target](RenderGraph& graph) {
+            context_->CopyResource(graph.GetTexture(target), graph.GetTexture(output));
+        });
 }
 
 void GraphicsDevice::RenderHeatHazePass() {
-    if (!heatHazeRenderTarget_ || !heatHazeTexture_) return;
+    NEXUS_PROFILE_SCOPE("GraphicsDevice::HeatHazePass");
+    if (!postProcessing_ || !renderGraph_) return;
+
+    RenderGraph::TextureDesc desc;
+    desc.width = width_;
+    desc.height = height_;
+    desc.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    RenderGraph::ResourceHandle haze = renderGraph_->CreateTexture("HeatHaze", desc);
+
+    // Nothing samples the distortion buffer yet, so the graph culls this pass until a
+    // composite pass reads it
+    renderGraph_->AddPass("HeatHaze",
+        [=](RenderGraph::Builder& builder) {
+            builder.Write(haze);
+        },
+        [this, haze](RenderGraph& graph) {
+            GpuProfileScope gpuScope(gpuProfiler_.get(), "HeatHaze");
+            ID3D11RenderTargetView* target = graph.GetRenderTargetView(haze);
+            stateCache_->OMSetRenderTargets(1, &target, nullptr);
+            
+            // Pooled textures keep old contents, so the first writer clears
+            float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            context_->ClearRenderTargetView(target, clearColor);
+            
+            // Apply heat haze distortion effect
+            // This would typically use a noise texture and distortion shader
+            NEXUS_LOG_DEBUG("Heat haze pass completed");
+        });
+}
+
+void GraphicsDevice::ExecuteRenderGraph() {
+    ResolveDebugView();
+    if (!renderGraph_) return;
+    renderGraph_->Execute();
 
-    // Set heat haze render target
-    context_->OMSetRenderTargets(1, &heatHazeRenderTarget_, nullptr);
-    
-    // Clear heat haze buffer
-    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-    context_->ClearRenderTargetView(heatHazeRenderTarget_, clearColor);
-    
-    // Apply heat haze distortion effect
-    // This would typically use a noise texture and distortion shader
-    // For now, we'll just prepare the buffer
-    
     // Restore main render target
-    context_->OMSetRenderTargets(1, &renderTargetView_, depthStencilView_);
-    
-    Logger::Debug("Heat haze pass completed");
+    stateCache_->OMSetRenderTargets(1, &renderTargetView_, depthStencilView_);
 }
 
 void GraphicsDevice::SetBloomEnabled(bool enabled) {
@@ -871,6 +1811,14 @@ void GraphicsDevice::SetBloomEnabled(bool enabled) {
     Logger::Info("Bloom " + std::string(enabled ? "enabled" : "disabled"));
 }
 
+void GraphicsDevice::SetBloomParameters(float threshold, float intensity) {
+    bloomThreshold_ = threshold;
+    bloomIntensity_ = intensity;
+    if (bloom_) {
+        bloom_->SetParameters(threshold, intensity);
+    }
+}
+
 void GraphicsDevice::SetHeatHazeEnabled(bool enabled) {
     heatHazeEnabled_ = enabled;
     Logger::Info("Heat haze " + std::string(enabled ? "enabled" : "disabled"));
@@ -889,8 +1837,12 @@ void GraphicsDevice::SetShadowMapSize(int size) {
 void GraphicsDevice::BeginShadowPass(const Light& light) {
     if (!shadowMapDepth_) return;
     
+    if (gpuProfiler_) {
+        gpuProfiler_->BeginPass("ShadowMap");
+    }
+    
     // Set shadow map as render target
-    context_->OMSetRenderTargets(0, nullptr, shadowMapDepth_);
+    stateCache_->OMSetRenderTargets(0, nullptr, shadowMapDepth_);
     
     // Clear shadow map
     context_->ClearDepthStencilView(shadowMapDepth_, D3D11_CLEAR_DEPTH, 1.0f, 0);
@@ -901,14 +1853,18 @@ void GraphicsDevice::BeginShadowPass(const Light& light) {
     viewport.Height = (float)shadowMapSize_;
     viewport.MinDepth = 0.0f;
     viewport.MaxDepth = 1.0f;
-    context_->RSSetViewports(1, &viewport);
+    stateCache_->RSSetViewports(1, &viewport);
     
-    Logger::Debug("Shadow pass began");
+    NEXUS_LOG_DEBUG("Shadow pass began");
 }
 
 void GraphicsDevice::EndShadowPass() {
+    if (gpuProfiler_ && shadowMapDepth_) {
+        gpuProfiler_->EndPass();
+    }
+    
     // Restore main render target
-    context_->OMSetRenderTargets(1, &renderTargetView_, depthStencilView_);
+    stateCache_->OMSetRenderTargets(1, &renderTargetView_, depthStencilView_);
     
     // Restore main viewport
     D3D11_VIEWPORT viewport = {};
@@ -916,14 +1872,14 @@ void GraphicsDevice::EndShadowPass() {
     viewport.Height = (float)height_;
     viewport.MinDepth = 0.0f;
     viewport.MaxDepth = 1.0f;
-    context_->RSSetViewports(1, &viewport);
+    stateCache_->RSSetViewports(1, &viewport);
     
-    Logger::Debug("Shadow pass ended");
+    NEXUS_LOG_DEBUG("Shadow pass ended");
 }
 
 void GraphicsDevice::RenderMesh(const Mesh& mesh, const Shader& shader) {
     // Implementation for mesh rendering
-    Logger::Debug("Rendering mesh with shader");
+    NEXUS_LOG_DEBUG("Rendering mesh with shader");
     
     // This would typically involve:
     // 1. Set vertex/index buffers
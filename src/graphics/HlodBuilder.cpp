@@ -0,0 +1,533 @@
+#include "HlodBuilder.h"
+#include "MeshImporter.h"
+#include "MipGenerator.h"
+#include "TextureFile.h"
+#include "MappedFile.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
+// Decoder for the source albedo textures
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_TGA
+#define STBI_ONLY_BMP
+#define STBI_NO_STDIO
+#include <stb/stb_image.h>
+
+namespace Nexus {
+
+namespace {
+
+const char* INDEX_FILE = "hlod.txt";
+const int ATLAS_PADDING = 2;        // Texels kept free of texture coordinates around each tile
+
+// Tightly packed RGBA8
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+Image WhiteImage() {
+    Image image;
+    image.width = 1;
+    image.height = 1;
+    image.pixels.assign(4, 255);
+    return image;
+}
+
+bool LoadImage(const std::string& filename, Image& image) {
+    MappedFile file;
+    if (!file.Open(filename)) return false;
+    int width = 0, height = 0, channels = 0;
+    stbi_uc* decoded = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height, &channels, 4);
+    if (!decoded) return false;
+    image.width = width;
+    image.height = height;
+    image.pixels.assign(decoded, decoded + size_t(width) * height * 4);
+    stbi_image_free(decoded);
+    return true;
+}
+
+// Area average of the source into a size x size block of an atlas with the given row pitch
+void ResampleInto(const Image& source, uint8_t* target, int size, size_t pitch) {
+    for (int y = 0; y < size; ++y) {
+        const int y0 = y * source.height / size;
+        const int y1 = std::max(y0 + 1, (y + 1) * source.height / size);
+        for (int x = 0; x < size; ++x) {
+            const int x0 = x * source.width / size;
+            const int x1 = std::max(x0 + 1, (x + 1) * source.width / size);
+            uint32_t sum[4] = {};
+            for (int sy = y0; sy < y1; ++sy) {
+                const uint8_t* row = &source.pixels[(size_t(sy) * source.width + x0) * 4];
+                for (int sx = x0; sx < x1; ++sx, row += 4) {
+                    for (int c = 0; c < 4; ++c) sum[c] += row[c];
+                }
+            }
+            const uint32_t count = uint32_t(x1 - x0) * uint32_t(y1 - y0);
+            uint8_t* texel = target + y * pitch + x * 4;
+            for (int c = 0; c < 4; ++c) texel[c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+        }
+    }
+}
+
+// Nearest texel with wrapping
+const uint8_t* Sample(const Image& image, float u, float v) {
+    u -= std::floor(u);
+    v -= std::floor(v);
+    const int x = std::min(static_cast<int>(u * image.width), image.width - 1);
+    const int y = std::min(static_cast<int>(v * image.height), image.height - 1);
+    return &image.pixels[(size_t(y) * image.width + x) * 4];
+}
+
+// Square RGBA8 image with a full mip chain
+bool WriteImage(const std::string& filename, const std::vector<uint8_t>& pixels, int size, bool srgb) {
+    MipGenerator::Settings mipSettings;
+    mipSettings.srgb = srgb;
+    std::vector<uint8_t> mipData;
+    std::vector<MipGenerator::Level> levels;
+    if (!MipGenerator::Generate(pixels.data(), size, size, mipSettings, mipData, levels)) return false;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = size;
+    desc.Height = size;
+    desc.MipLevels = static_cast<UINT>(levels.size() + 1);
+    desc.ArraySize = 1;
+    desc.Format = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> subresources(desc.MipLevels);
+    subresources[0] = { pixels.data(), static_cast<UINT>(size * 4), 0 };
+    for (size_t i = 0; i < levels.size(); ++i) {
+        subresources[i + 1] = { mipData.data() + levels[i].offset, static_cast<UINT>(levels[i].width * 4), 0 };
+    }
+    return TextureFile::WriteDDS(filename, desc, subresources.data());
+}
+
+XMMATRIX GetWorldMatrix(const HlodBuilder::Placement& placement) {
+    return XMMatrixScaling(placement.scale.x, placement.scale.y, placement.scale.z) *
+           XMMatrixRotationRollPitchYaw(XMConvertToRadians(placement.rotation.x),
+                                        XMConvertToRadians(placement.rotation.y),
+                                        XMConvertToRadians(placement.rotation.z)) *
+           XMMatrixTranslation(placement.position.x, placement.position.y, placement.position.z);
+}
+
+// Appends the mesh in world space with its texture coordinates squeezed into [offset, offset + scale]
+void AppendTransformed(const MeshData& source, CXMMATRIX world, const XMFLOAT2& offset, const XMFLOAT2& scale,
+                       MeshData& target) {
+    const uint32_t base = static_cast<uint32_t>(target.vertices.size());
+    XMMATRIX normalMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, world));
+    for (const Vertex& vertex : source.vertices) {
+        Vertex v = vertex;
+        XMStoreFloat3(&v.position, XMVector3TransformCoord(XMLoadFloat3(&vertex.position), world));
+        XMStoreFloat3(&v.normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.normal), normalMatrix)));
+        XMStoreFloat3(&v.tangent, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.tangent), world)));
+        v.texCoord.x = offset.x + std::clamp(vertex.texCoord.x, 0.0f, 1.0f) * scale.x;
+        v.texCoord.y = offset.y + std::clamp(vertex.texCoord.y, 0.0f, 1.0f) * scale.y;
+        target.vertices.push_back(v);
+    }
+    for (uint32_t index : source.indices) target.indices.push_back(base + index);
+}
+
+// World bounding sphere of a placed mesh
+void GetBoundingSphere(const MeshData& mesh, const HlodBuilder::Placement& placement, XMFLOAT3& center, float& radius) {
+    XMVECTOR boundsMin = XMLoadFloat3(&mesh.boundsMin);
+    XMVECTOR boundsMax = XMLoadFloat3(&mesh.boundsMax);
+    XMStoreFloat3(&center, XMVector3TransformCoord((boundsMin + boundsMax) * 0.5f, GetWorldMatrix(placement)));
+    const float scale = std::max({ std::fabs(placement.scale.x), std::fabs(placement.scale.y), std::fabs(placement.scale.z) });
+    radius = XMVectorGetX(XMVector3Length(boundsMax - boundsMin)) * 0.5f * scale;
+}
+
+uint64_t GetCellKey(int32_t x, int32_t z) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+}
+
+// Renders the placed mesh into every frame of the two impostor atlases. The projection is
+// orthographic over the bounding sphere, so attributes interpolate linearly in screen space
+void BakeImpostor(const MeshData& mesh, const Image& texture, const HlodBuilder::Placement& placement,
+                  const XMFLOAT3& center, float radius, int frames, int frameSize,
+                  std::vector<uint8_t>& albedo, std::vector<uint8_t>& normals) {
+    const int atlasSize = frames * frameSize;
+    const size_t pitch = size_t(atlasSize) * 4;
+    albedo.assign(pitch * atlasSize, 0);
+    normals.assign(pitch * atlasSize, 0);
+
+    XMMATRIX world = GetWorldMatrix(placement);
+    XMMATRIX normalMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, world));
+    XMVECTOR origin = XMLoadFloat3(&center);
+    std::vector<XMFLOAT3> positions(mesh.vertices.size());
+    std::vector<XMFLOAT3> vertexNormals(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        XMStoreFloat3(&positions[i], XMVector3TransformCoord(XMLoadFloat3(&mesh.vertices[i].position), world) - origin);
+        XMStoreFloat3(&vertexNormals[i], XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&mesh.vertices[i].normal), normalMatrix)));
+    }
+
+    std::vector<float> depths(size_t(frameSize) * frameSize);
+    std::vector<XMFLOAT3> projected(mesh.vertices.size());
+    for (int frameY = 0; frameY < frames; ++frameY) {
+        for (int frameX = 0; frameX < frames; ++frameX) {
+            // Looking from the direction towards the centre, so forward is -direction
+            XMFLOAT3 direction = HlodBuilder::OctahedralDecode((frameX + 0.5f) / frames * 2.0f - 1.0f,
+                                                               (frameY + 0.5f) / frames * 2.0f - 1.0f);
+            XMVECTOR toViewer = XMLoadFloat3(&direction);
+            XMVECTOR up = std::fabs(direction.y) > 0.99f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+            XMVECTOR right = XMVector3Normalize(XMVector3Cross(up, -toViewer));
+            up = XMVector3Cross(-toViewer, right);
+
+            // Pixel x, pixel y, depth in [0, 1] growing towards the viewer
+            const float pixelScale = 0.5f * frameSize / radius;
+            for (size_t i = 0; i < positions.size(); ++i) {
+                XMVECTOR p = XMLoadFloat3(&positions[i]);
+                projected[i].x = XMVectorGetX(XMVector3Dot(p, right)) * pixelScale + 0.5f * frameSize;
+                projected[i].y = 0.5f * frameSize - XMVectorGetX(XMVector3Dot(p, up)) * pixelScale;
+                projected[i].z = XMVectorGetX(XMVector3Dot(p, toViewer)) / radius * 0.5f + 0.5f;
+            }
+
+            std::fill(depths.begin(), depths.end(), -1.0f);
+            const size_t frameOffset = size_t(frameY) * frameSize * pitch + size_t(frameX) * frameSize * 4;
+            for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+                const uint32_t i0 = mesh.indices[t], i1 = mesh.indices[t + 1], i2 = mesh.indices[t + 2];
+                const XMFLOAT3& a = projected[i0];
+                const XMFLOAT3& b = projected[i1];
+                const XMFLOAT3& c = projected[i2];
+                const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+                if (std::fabs(area) < 1e-8f) continue;
+
+                // Both windings, so open and two-sided meshes keep their back faces
+                const int minX = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))));
+                const int maxX = std::min(frameSize - 1, static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))));
+                const int minY = std::max(0, static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))));
+                const int maxY = std::min(frameSize - 1, static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))));
+                for (int y = minY; y <= maxY; ++y) {
+                    const float py = y + 0.5f;
+                    for (int x = minX; x <= maxX; ++x) {
+                        const float px = x + 0.5f;
+                        const float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) / area;
+                        const float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) / area;
+                        const float w2 = 1.0f - w0 - w1;
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+                        const float depth = w0 * a.z + w1 * b.z + w2 * c.z;
+                        float& stored = depths[size_t(y) * frameSize + x];
+                        if (depth <= stored) continue;
+
+                        const Vertex& v0 = mesh.vertices[i0];
+                        const Vertex& v1 = mesh.vertices[i1];
+                        const Vertex& v2 = mesh.vertices[i2];
+                        const uint8_t* texel = Sample(texture, w0 * v0.texCoord.x + w1 * v1.texCoord.x + w2 * v2.texCoord.x,
+                                                      w0 * v0.texCoord.y + w1 * v1.texCoord.y + w2 * v2.texCoord.y);
+                        // Alpha-tested cut-outs such as leaves
+                        if (texel[3] < 128) continue;
+                        stored = depth;
+
+                        XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertexNormals[i0]) * w0 +
+                                                             XMLoadFloat3(&vertexNormals[i1]) * w1 +
+                                                             XMLoadFloat3(&vertexNormals[i2]) * w2);
+                        XMFLOAT3 n;
+                        XMStoreFloat3(&n, normal * 0.5f + XMVectorReplicate(0.5f));
+                        const size_t offset = frameOffset + size_t(y) * pitch + size_t(x) * 4;
+                        std::copy(texel, texel + 3, &albedo[offset]);
+                        albedo[offset + 3] = 255;
+                        normals[offset + 0] = static_cast<uint8_t>(std::clamp(n.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+                        normals[offset + 1] = static_cast<uint8_t>(std::clamp(n.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+                        normals[offset + 2] = static_cast<uint8_t>(std::clamp(n.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+                        normals[offset + 3] = static_cast<uint8_t>(std::clamp(depth, 0.0f, 1.0f) * 255.0f + 0.5f);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+XMFLOAT3 HlodBuilder::OctahedralDecode(float x, float y) {
+    // Upper hemisphere inside the diamond |x| + |y| <= 1, the lower one folded into the corners
+    XMFLOAT3 direction(x, 1.0f - std::fabs(x) - std::fabs(y), y);
+    if (direction.y < 0.0f) {
+        direction.x = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        direction.z = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+    XMStoreFloat3(&direction, XMVector3Normalize(XMLoadFloat3(&direction)));
+    return direction;
+}
+
+bool HlodBuilder::ReadPlacements(const std::string& filename, std::vector<Placement>& placements) {
+    namespace fs = std::filesystem;
+    std::ifstream file(filename);
+    if (!file) {
+        Logger::Error("Cannot open placement list: " + filename);
+        return false;
+    }
+
+    const fs::path folder = fs::path(filename).parent_path();
+    auto resolve = [&](const std::string& path) {
+        return fs::path(path).is_absolute() ? path : (folder / path).string();
+    };
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword)) continue;
+        if (keyword == "light") continue;   // For LightmapBaker::ReadLights
+        if (keyword != "place") {
+            Logger::Warning("Unknown placement keyword '" + keyword + "' at " + filename + ":" + std::to_string(lineNumber));
+            continue;
+        }
+
+        Placement placement;
+        std::string texture;
+        if (!(fields >> placement.mesh >> texture
+                     >> placement.position.x >> placement.position.y >> placement.position.z
+                     >> placement.rotation.x >> placement.rotation.y >> placement.rotation.z
+                     >> placement.scale.x >> placement.scale.y >> placement.scale.z)) {
+            Logger::Error("Malformed placement at " + filename + ":" + std::to_string(lineNumber));
+            return false;
+        }
+        placement.mesh = resolve(placement.mesh);
+        if (texture != "-") placement.texture = resolve(texture);
+        placements.push_back(placement);
+    }
+    return true;
+}
+
+bool HlodBuilder::Build(const std::vector<Placement>& placements, const std::string& outputDirectory,
+                        const Settings& requested, Stats* stats) {
+    NEXUS_PROFILE_SCOPE("HlodBuilder::Build");
+    namespace fs = std::filesystem;
+
+    Settings settings = requested;
+    settings.cellSize = std::max(settings.cellSize, 1.0f);
+    settings.triangleRatio = std::clamp(settings.triangleRatio, 0.0f, 1.0f);
+    settings.atlasSize = std::clamp(settings.atlasSize, 64, 8192);
+    settings.impostorFrames = std::clamp(settings.impostorFrames, 2, 32);
+    settings.impostorFrameSize = std::clamp(settings.impostorFrameSize, 16, 8192 / settings.impostorFrames);
+    Stats result;
+
+    std::error_code error;
+    fs::create_directories(outputDirectory, error);
+    const fs::path output(outputDirectory);
+
+    // Every distinct source once
+    std::map<std::string, MeshData> meshes;
+    std::vector<const MeshData*> placementMeshes(placements.size(), nullptr);
+    for (size_t i = 0; i < placements.size(); ++i) {
+        auto it = meshes.find(placements[i].mesh);
+        if (it == meshes.end()) {
+            MeshData mesh;
+            if (!MeshImporter::Import(placements[i].mesh, mesh) || mesh.indices.empty()) {
+                Logger::Warning("HLOD skips unreadable mesh: " + placements[i].mesh);
+                mesh = MeshData();
+            }
+            MeshImporter::ComputeBounds(mesh);
+            it = meshes.emplace(placements[i].mesh, std::move(mesh)).first;
+        }
+        if (!it->second.indices.empty()) placementMeshes[i] = &it->second;
+    }
+
+    std::map<std::string, Image> images;
+    auto getImage = [&](const std::string& filename) -> const Image& {
+        auto it = images.find(filename);
+        if (it != images.end()) return it->second;
+        Image image;
+        if (filename.empty() || !LoadImage(filename, image)) {
+            if (!filename.empty()) Logger::Warning("HLOD uses white for unreadable texture: " + filename);
+            image = WhiteImage();
+        }
+        return images.emplace(filename, std::move(image)).first->second;
+    };
+
+    // Neighbours are looked up in a grid of isolationDistance buckets
+    std::vector<XMFLOAT3> centers(placements.size());
+    std::vector<float> radii(placements.size(), 0.0f);
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+    const float bucketSize = std::max(settings.isolationDistance, 1.0f);
+    for (uint32_t i = 0; i < placements.size(); ++i) {
+        if (!placementMeshes[i]) continue;
+        GetBoundingSphere(*placementMeshes[i], placements[i], centers[i], radii[i]);
+        buckets[GetCellKey(static_cast<int32_t>(std::floor(placements[i].position.x / bucketSize)),
+                           static_cast<int32_t>(std::floor(placements[i].position.z / bucketSize)))].push_back(i);
+    }
+    auto isIsolated = [&](uint32_t i) {
+        const XMFLOAT3& p = placements[i].position;
+        const int32_t bx = static_cast<int32_t>(std::floor(p.x / bucketSize));
+        const int32_t bz = static_cast<int32_t>(std::floor(p.z / bucketSize));
+        for (int32_t z = bz - 1; z <= bz + 1; ++z) {
+            for (int32_t x = bx - 1; x <= bx + 1; ++x) {
+                auto it = buckets.find(GetCellKey(x, z));
+                if (it == buckets.end()) continue;
+                for (uint32_t j : it->second) {
+                    if (j == i) continue;
+                    const XMFLOAT3& q = placements[j].position;
+                    const float dx = q.x - p.x, dy = q.y - p.y, dz = q.z - p.z;
+                    if (dx * dx + dy * dy + dz * dz < settings.isolationDistance * settings.isolationDistance) return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    std::ofstream index((output / INDEX_FILE).string());
+    if (!index) {
+        Logger::Error("Cannot write HLOD index in " + outputDirectory);
+        return false;
+    }
+    index << "hlod 1\n";
+    index << "cellSize " << settings.cellSize << "\n";
+    index << "proxyDistance " << settings.proxyDistance << "\n";
+
+    // Impostors first; what remains is grouped by cell
+    std::map<std::pair<int32_t, int32_t>, std::vector<uint32_t>> cells;
+    const int impostorSize = settings.impostorFrames * settings.impostorFrameSize;
+    for (uint32_t i = 0; i < placements.size(); ++i) {
+        if (!placementMeshes[i]) continue;
+        if (radii[i] >= settings.impostorRadius && isIsolated(i)) {
+            std::vector<uint8_t> albedo, normals;
+            BakeImpostor(*placementMeshes[i], getImage(placements[i].texture), placements[i], centers[i], radii[i],
+                         settings.impostorFrames, settings.impostorFrameSize, albedo, normals);
+            const std::string name = "impostor_" + std::to_string(i);
+            if (!WriteImage((output / (name + "_albedo.dds")).string(), albedo, impostorSize, true) ||
+                !WriteImage((output / (name + "_normal.dds")).string(), normals, impostorSize, false)) {
+                Logger::Error("Failed to write impostor " + name);
+                return false;
+            }
+            index << "impostor " << i << " " << name << "_albedo.dds " << name << "_normal.dds "
+                  << centers[i].x << " " << centers[i].y << " " << centers[i].z << " " << radii[i] << " "
+                  << settings.impostorFrames << "\n";
+            result.impostors++;
+            continue;
+        }
+        cells[{ static_cast<int32_t>(std::floor(placements[i].position.x / settings.cellSize)),
+                static_cast<int32_t>(std::floor(placements[i].position.z / settings.cellSize)) }].push_back(i);
+    }
+
+    for (const auto& [coordinates, members] : cells) {
+        // One square tile per distinct texture
+        std::vector<std::string> textures;
+        for (uint32_t i : members) {
+            if (std::find(textures.begin(), textures.end(), placements[i].texture) == textures.end()) {
+                textures.push_back(placements[i].texture);
+            }
+        }
+        const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(textures.size()))));
+        const int tileSize = settings.atlasSize / side;
+        if (tileSize <= ATLAS_PADDING * 4) {
+            Logger::Warning("HLOD atlas tiles are only " + std::to_string(tileSize) + " texels; raise the atlas size");
+        }
+        const size_t pitch = size_t(settings.atlasSize) * 4;
+        std::vector<uint8_t> atlas(pitch * settings.atlasSize, 0);
+        for (size_t t = 0; t < textures.size(); ++t) {
+            uint8_t* tile = &atlas[(t / side) * tileSize * pitch + (t % side) * tileSize * 4];
+            ResampleInto(getImage(textures[t]), tile, tileSize, pitch);
+        }
+
+        MeshData proxy;
+        for (uint32_t i : members) {
+            const size_t t = std::find(textures.begin(), textures.end(), placements[i].texture) - textures.begin();
+            const float inset = std::min(float(ATLAS_PADDING), tileSize * 0.25f);
+            XMFLOAT2 offset(((t % side) * tileSize + inset) / settings.atlasSize,
+                            ((t / side) * tileSize + inset) / settings.atlasSize);
+            XMFLOAT2 scale((tileSize - 2.0f * inset) / settings.atlasSize, (tileSize - 2.0f * inset) / settings.atlasSize);
+            AppendTransformed(*placementMeshes[i], GetWorldMatrix(placements[i]), offset, scale, proxy);
+        }
+
+        const size_t target = std::max<size_t>(3, static_cast<size_t>(proxy.indices.size() / 3 * settings.triangleRatio) * 3);
+        result.sourceTriangles += proxy.indices.size() / 3;
+        proxy.indices = MeshImporter::Simplify(proxy.indices, proxy.vertices, target, settings.maxError * settings.cellSize);
+        result.proxyTriangles += proxy.indices.size() / 3;
+        MeshImporter::Optimize(proxy);
+        MeshImporter::ComputeBounds(proxy);
+
+        const std::string name = "hlod_" + std::to_string(coordinates.first) + "_" + std::to_string(coordinates.second);
+        if (!MeshImporter::WriteBinary((output / (name + ".nmesh")).string(), proxy) ||
+            !WriteImage((output / (name + ".dds")).string(), atlas, settings.atlasSize, true)) {
+            Logger::Error("Failed to write HLOD proxy " + name);
+            return false;
+        }
+        index << "proxy " << coordinates.first << " " << coordinates.second << " " << name << ".nmesh " << name << ".dds "
+              << proxy.boundsMin.x << " " << proxy.boundsMin.y << " " << proxy.boundsMin.z << " "
+              << proxy.boundsMax.x << " " << proxy.boundsMax.y << " " << proxy.boundsMax.z << "\n";
+        result.cells++;
+    }
+
+    Logger::Info("HLOD built: " + std::to_string(result.cells) + " proxies (" + std::to_string(result.sourceTriangles) +
+                 " -> " + std::to_string(result.proxyTriangles) + " triangles), " + std::to_string(result.impostors) + " impostors");
+    if (stats) *stats = result;
+    return true;
+}
+
+bool HlodIndex::Load(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string keyword;
+    int version = 0;
+    if (!file || !(file >> keyword >> version) || keyword != "hlod" || version != 1) {
+        Logger::Error("Not an HLOD index: " + filename);
+        return false;
+    }
+
+    proxies_.clear();
+    impostors_.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        if (!(fields >> keyword)) continue;
+        if (keyword == "cellSize") {
+            fields >> cellSize_;
+        } else if (keyword == "proxyDistance") {
+            fields >> proxyDistance_;
+        } else if (keyword == "proxy") {
+            Proxy proxy;
+            if (fields >> proxy.x >> proxy.z >> proxy.mesh >> proxy.atlas
+                       >> proxy.bounds.min.x >> proxy.bounds.min.y >> proxy.bounds.min.z
+                       >> proxy.bounds.max.x >> proxy.bounds.max.y >> proxy.bounds.max.z) {
+                proxies_.push_back(proxy);
+            }
+        } else if (keyword == "impostor") {
+            Impostor impostor;
+            if (fields >> impostor.placement >> impostor.albedo >> impostor.normal
+                       >> impostor.center.x >> impostor.center.y >> impostor.center.z >> impostor.radius >> impostor.frames) {
+                impostors_.push_back(impostor);
+            }
+        }
+    }
+    return true;
+}
+
+bool HlodIndex::UsesProxy(const Proxy& proxy, const XMFLOAT3& cameraPosition) const {
+    const float dx = std::max({ proxy.bounds.min.x - cameraPosition.x, 0.0f, cameraPosition.x - proxy.bounds.max.x });
+    const float dy = std::max({ proxy.bounds.min.y - cameraPosition.y, 0.0f, cameraPosition.y - proxy.bounds.max.y });
+    const float dz = std::max({ proxy.bounds.min.z - cameraPosition.z, 0.0f, cameraPosition.z - proxy.bounds.max.z });
+    return dx * dx + dy * dy + dz * dz > proxyDistance_ * proxyDistance_;
+}
+
+bool HlodIndex::UsesImpostor(const Impostor& impostor, const XMFLOAT3& cameraPosition) const {
+    const float dx = impostor.center.x - cameraPosition.x;
+    const float dy = impostor.center.y - cameraPosition.y;
+    const float dz = impostor.center.z - cameraPosition.z;
+    return std::sqrt(dx * dx + dy * dy + dz * dz) - impostor.radius > proxyDistance_;
+}
+
+void HlodIndex::SelectProxies(const XMFLOAT3& cameraPosition, std::vector<const Proxy*>& proxies) const {
+    proxies.clear();
+    for (const Proxy& proxy : proxies_) {
+        if (UsesProxy(proxy, cameraPosition)) proxies.push_back(&proxy);
+    }
+}
+
+} // namespace Nexus
@@ -13,6 +13,8 @@ Light::Light(LightType type)
     , direction_(0.0f, -1.0f, 0.0f)
     , color_(1.0f, 1.0f, 1.0f)
     , intensity_(1.0f)
+    , range_(10.0f)
+    , castsShadows_(false)
     , coneAngle_(XM_PI / 4.0f)
     , attenuationConstant_(1.0f)
     , attenuationLinear_(0.0f)
@@ -1,27 +1,59 @@
 #include "LightingEngine.h"
+#include "BloomRenderer.h"
+#include "Camera.h"
+#include "CascadedShadowMaps.h"
+#include "ClusteredLightCuller.h"
+#include "DecalSystem.h"
+#include "DeferredRenderer.h"
 #include "Logger.h"
+#include "Mesh.h"
+#include "OcclusionCuller.h"
+#include "ProbeVolume.h"
+#include "ScreenSpaceReflections.h"
+#include "ShadowAtlas.h"
+#include "ShadingRateImage.h"
+#include "SSAORenderer.h"
+#include "StateCache.h"
+#include <algorithm>
 #include <cmath>
 
 namespace Nexus {
 
+namespace {
+// Matches the gamma the forward PBR output is encoded with
+constexpr float DISPLAY_GAMMA = 2.2f;
+}
+
 LightingEngine::LightingEngine()
-    : device_(nullptr), context_(nullptr), screenWidth_(0), screenHeight_(0),
-      sceneTexture_(nullptr), sceneSurface_(nullptr), sceneSRV_(nullptr),
+    : device_(nullptr), context_(nullptr), stateCache_(nullptr), maxLightsPerPass_(128), jobs_(nullptr),
+      screenWidth_(0), screenHeight_(0),
+      sceneTexture_(nullptr), sceneSurface_(nullptr), sceneSRV_(nullptr), sceneTarget_(nullptr),
       normalTexture_(nullptr), normalSurface_(nullptr),
       depthTexture_(nullptr), depthSurface_(nullptr), 
-      bloomTexture_(nullptr), bloomSurface_(nullptr), bloomTextureSRV_(nullptr),
+      bloomTexture_(nullptr), bloomSurface_(nullptr), bloomTextureSRV_(nullptr), bloomTarget_(nullptr),
       heatHazeTexture_(nullptr), heatHazeSurface_(nullptr), heatHazeTextureSRV_(nullptr),
       shadowTexture_(nullptr), shadowSurface_(nullptr),
-      shadowDepthTexture_(nullptr), shadowDepthSurface_(nullptr) {
+      shadowDepthTexture_(nullptr), shadowDepthSurface_(nullptr), deferredRenderingEnabled_(true), ssaoEnabled_(true),
+      reflectionsEnabled_(false), occlusion_(nullptr), variableRateShadingEnabled_(false), probes_(nullptr), decals_(nullptr) {
+    XMStoreFloat4x4(&cullView_, XMMatrixIdentity());
+    XMStoreFloat4x4(&cullProjection_, XMMatrixIdentity());
 }
 
 LightingEngine::~LightingEngine() {
     Shutdown();
 }
 
-bool LightingEngine::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int screenWidth, int screenHeight) {
+bool LightingEngine::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int screenWidth, int screenHeight,
+                                StateCache* stateCache, JobSystem* jobs) {
     device_ = device;
     context_ = context;
+    stateCache_ = stateCache;
+    jobs_ = jobs;
+    if (!stateCache_) {
+        ownedStateCache_ = std::make_unique<StateCache>();
+        ownedStateCache_->Initialize(context);
+        stateCache_ = ownedStateCache_.get();
+    }
     screenWidth_ = screenWidth;
     screenHeight_ = screenHeight;
     
@@ -35,11 +67,31 @@ bool LightingEngine::Initialize(ID3D11Device* device, ID3D11DeviceContext* conte
         return false;
     }
     
-    if (!CreateGBuffer()) {
-        Logger::Error("Failed to create G-Buffer");
-        return false;
+    // Shading falls back to forward without it
+    if (deferredRenderingEnabled_ && !CreateGBuffer()) {
+        Logger::Warning("Deferred rendering unavailable");
+    }
+    
+    // Forward shading still works without it, limited to directional lights
+    clusteredLights_ = std::make_unique<ClusteredLightCuller>();
+    clusteredLights_->SetMaxLightsPerCluster(static_cast<UINT>(maxLightsPerPass_));
+    if (!clusteredLights_->Initialize(device_, context_)) {
+        Logger::Warning("Clustered lighting unavailable");
+        clusteredLights_.reset();
     }
     
+    // Point and spot lights render unshadowed without it
+    ShadowAtlas::Settings atlasSettings;
+    atlasSettings.maxTileSize = static_cast<UINT>(settings_.shadowQuality);
+    atlasSettings.resolution = std::min(atlasSettings.maxTileSize * 4, 8192u);
+    shadowAtlas_ = std::make_unique<ShadowAtlas>();
+    if (!shadowAtlas_->Initialize(device_, context_, stateCache_, atlasSettings)) {
+        Logger::Warning("Shadow atlas unavailable");
+        shadowAtlas_.reset();
+    }
+    
+    CreateSSAO();
+    
     return true;
 }
 
@@ -53,6 +105,10 @@ void LightingEngine::Shutdown() {
         sceneSRV_->Release();
         sceneSRV_ = nullptr;
     }
+    if (sceneTarget_) {
+        sceneTarget_->Release();
+        sceneTarget_ = nullptr;
+    }
     if (sceneTexture_) {
         sceneTexture_->Release();
         sceneTexture_ = nullptr;
@@ -84,6 +140,14 @@ void LightingEngine::Shutdown() {
         bloomTextureSRV_->Release();
         bloomTextureSRV_ = nullptr;
     }
+    if (bloomTarget_) {
+        bloomTarget_->Release();
+        bloomTarget_ = nullptr;
+    }
+    bloom_.reset();
+    ssao_.reset();
+    reflections_.reset();
+    shadingRate_.reset();
     if (bloomTexture_) {
         bloomTexture_->Release();
         bloomTexture_ = nullptr;
@@ -128,6 +192,10 @@ void LightingEngine::Shutdown() {
     
     // Release G-Buffer
     DestroyGBuffer();
+    
+    clusteredLights_.reset();
+    cascadedShadows_.reset();
+    shadowAtlas_.reset();
 }
 
 bool LightingEngine::CreateRenderTargets() {
@@ -147,6 +215,8 @@ bool LightingEngine::CreateRenderTargets() {
     textureDesc.CPUAccessFlags = 0;
     textureDesc.MiscFlags = 0;
     
+    // The scene is also written by the deferred lighting compute pass
+    textureDesc.BindFlags |= D3D11_BIND_UNORDERED_ACCESS;
     hr = device_->CreateTexture2D(&textureDesc, nullptr, &sceneTexture_);
     if (FAILED(hr)) {
         Logger::Error("Failed to create scene texture");
@@ -178,6 +248,16 @@ bool LightingEngine::CreateRenderTargets() {
         return false;
     }
     
+    D3D11_UNORDERED_ACCESS_VIEW_DESC sceneUavDesc = {};
+    sceneUavDesc.Format = textureDesc.Format;
+    sceneUavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+    hr = device_->CreateUnorderedAccessView(sceneTexture_, &sceneUavDesc, &sceneTarget_);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create scene unordered access view");
+        return false;
+    }
+    textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    
     // Create normal render target texture
     hr = device_->CreateTexture2D(&textureDesc, nullptr, &normalTexture_);
     if (FAILED(hr)) {
@@ -204,9 +284,8 @@ bool LightingEngine::CreateRenderTargets() {
         return false;
     }
     
-    // Create bloom render target (half resolution)
-    textureDesc.Width = screenWidth_ / 2;
-    textureDesc.Height = screenHeight_ / 2;
+    // Create bloom output (full resolution): the scene with bloom added, written by compute
+    textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
     
     hr = device_->CreateTexture2D(&textureDesc, nullptr, &bloomTexture_);
     if (FAILED(hr)) {
@@ -226,9 +305,27 @@ bool LightingEngine::CreateRenderTargets() {
         return false;
     }
     
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = textureDesc.Format;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+    hr = device_->CreateUnorderedAccessView(bloomTexture_, &uavDesc, &bloomTarget_);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create bloom unordered access view");
+        return false;
+    }
+    
+    // Scenes render without bloom if it is unavailable
+    BloomRenderer::Settings bloomSettings;
+    bloomSettings.threshold = settings_.bloomThreshold;
+    bloomSettings.intensity = settings_.bloomIntensity;
+    bloom_ = std::make_unique<BloomRenderer>();
+    if (!bloom_->Initialize(device_, context_, screenWidth_, screenHeight_, bloomSettings)) {
+        Logger::Warning("Compute bloom unavailable");
+        bloom_.reset();
+    }
+    
     // Create heat haze render target (full resolution)
-    textureDesc.Width = screenWidth_;
-    textureDesc.Height = screenHeight_;
+    textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
     
     hr = device_->CreateTexture2D(&textureDesc, nullptr, &heatHazeTexture_);
     if (FAILED(hr)) {
@@ -321,152 +418,55 @@ bool LightingEngine::CreateShadowMaps() {
 }
 
 bool LightingEngine::CreateGBuffer() {
-    // Create G-Buffer textures for deferred rendering
-    D3D11_TEXTURE2D_DESC textureDesc = {};
-    textureDesc.Width = screenWidth_;
-    textureDesc.Height = screenHeight_;
-    textureDesc.MipLevels = 1;
-    textureDesc.ArraySize = 1;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.SampleDesc.Quality = 0;
-    textureDesc.Usage = D3D11_USAGE_DEFAULT;
-    textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-    textureDesc.CPUAccessFlags = 0;
-    textureDesc.MiscFlags = 0;
-    
-    HRESULT hr;
-    
-    // Create albedo texture (RGB = albedo, A = metallic)
-    textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    hr = device_->CreateTexture2D(&textureDesc, nullptr, &gBuffer_.albedoTexture);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create G-Buffer albedo texture");
-        return false;
-    }
-    
-    // Create normal texture (RGB = world space normal, A = roughness)
-    textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    hr = device_->CreateTexture2D(&textureDesc, nullptr, &gBuffer_.normalTexture);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create G-Buffer normal texture");
-        return false;
-    }
-    
-    // Create position texture (RGB = world position, A = depth)
-    textureDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    hr = device_->CreateTexture2D(&textureDesc, nullptr, &gBuffer_.positionTexture);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create G-Buffer position texture");
+    deferred_ = std::make_unique<DeferredRenderer>();
+    if (!deferred_->Initialize(device_, context_, static_cast<UINT>(screenWidth_), static_cast<UINT>(screenHeight_))) {
+        deferred_.reset();
         return false;
     }
-    
-    // Create render target views
-    D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
-    rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-    rtvDesc.Texture2D.MipSlice = 0;
-    
-    rtvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    hr = device_->CreateRenderTargetView(gBuffer_.albedoTexture, &rtvDesc, &gBuffer_.albedoRTV);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create G-Buffer albedo RTV");
-        return false;
-    }
-    
-    hr = device_->CreateRenderTargetView(gBuffer_.normalTexture, &rtvDesc, &gBuffer_.normalRTV);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create G-Buffer normal RTV");
-        return false;
-    }
-    
-    rtvDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    hr = device_->CreateRenderTargetView(gBuffer_.positionTexture, &rtvDesc, &gBuffer_.positionRTV);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create G-Buffer position RTV");
-        return false;
-    }
-    
-    // Create shader resource views
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MostDetailedMip = 0;
-    srvDesc.Texture2D.MipLevels = 1;
-    
-    srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    hr = device_->CreateShaderResourceView(gBuffer_.albedoTexture, &srvDesc, &gBuffer_.albedoSRV);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create G-Buffer albedo SRV");
-        return false;
-    }
-    
-    hr = device_->CreateShaderResourceView(gBuffer_.normalTexture, &srvDesc, &gBuffer_.normalSRV);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create G-Buffer normal SRV");
-        return false;
-    }
-    
-    srvDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    hr = device_->CreateShaderResourceView(gBuffer_.positionTexture, &srvDesc, &gBuffer_.positionSRV);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create G-Buffer position SRV");
-        return false;
-    }
-    
     return true;
 }
 
 void LightingEngine::DestroyGBuffer() {
-    if (gBuffer_.albedoSRV) {
-        gBuffer_.albedoSRV->Release();
-        gBuffer_.albedoSRV = nullptr;
-    }
-    if (gBuffer_.normalSRV) {
-        gBuffer_.normalSRV->Release();
-        gBuffer_.normalSRV = nullptr;
-    }
-    if (gBuffer_.positionSRV) {
-        gBuffer_.positionSRV->Release();
-        gBuffer_.positionSRV = nullptr;
-    }
-    if (gBuffer_.albedoRTV) {
-        gBuffer_.albedoRTV->Release();
-        gBuffer_.albedoRTV = nullptr;
-    }
-    if (gBuffer_.normalRTV) {
-        gBuffer_.normalRTV->Release();
-        gBuffer_.normalRTV = nullptr;
-    }
-    if (gBuffer_.positionRTV) {
-        gBuffer_.positionRTV->Release();
-        gBuffer_.positionRTV = nullptr;
-    }
-    if (gBuffer_.albedoTexture) {
-        gBuffer_.albedoTexture->Release();
-        gBuffer_.albedoTexture = nullptr;
-    }
-    if (gBuffer_.normalTexture) {
-        gBuffer_.normalTexture->Release();
-        gBuffer_.normalTexture = nullptr;
+    deferred_.reset();
+}
+
+void LightingEngine::EnableDeferredRendering(bool enable) {
+    deferredRenderingEnabled_ = enable;
+    if (enable && !deferred_ && device_) {
+        SetupGBuffer();
     }
-    if (gBuffer_.positionTexture) {
-        gBuffer_.positionTexture->Release();
-        gBuffer_.positionTexture = nullptr;
+}
+
+void LightingEngine::SetupGBuffer() {
+    DestroyGBuffer();
+    if (!CreateGBuffer()) {
+        Logger::Warning("Deferred rendering unavailable");
     }
 }
 
 void LightingEngine::BeginFrame() {
-    // Clear G-Buffer
-    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-    context_->ClearRenderTargetView(gBuffer_.albedoRTV, clearColor);
-    context_->ClearRenderTargetView(gBuffer_.normalRTV, clearColor);
-    context_->ClearRenderTargetView(gBuffer_.positionRTV, clearColor);
+    if (deferredRenderingEnabled_ && deferred_) {
+        deferred_->BeginGeometryPass(*stateCache_);
+        return;
+    }
     
-    // Set G-Buffer as render targets
-    ID3D11RenderTargetView* renderTargets[] = {
-        gBuffer_.albedoRTV,
-        gBuffer_.normalRTV,
-        gBuffer_.positionRTV
-    };
-    context_->OMSetRenderTargets(3, renderTargets, nullptr);
+    // Forward shading draws straight into the scene
+    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    context_->ClearRenderTargetView(sceneSurface_, clearColor);
+    stateCache_->OMSetRenderTargets(1, &sceneSurface_, nullptr);
+}
+
+void LightingEngine::RenderGBuffer(const std::vector<Mesh*>& meshes) {
+    if (!deferredRenderingEnabled_ || !deferred_) return;
+    
+    deferred_->BeginGeometryPass(*stateCache_);
+    for (Mesh* mesh : meshes) {
+        if (mesh) mesh->Render(context_);
+    }
+}
+
+void LightingEngine::RenderDeferredLighting() {
+    PerformDeferredLightingPass();
 }
 
 void LightingEngine::EndFrame() {
@@ -476,33 +476,37 @@ void LightingEngine::EndFrame() {
     // Apply post-processing effects
     ApplyBloomEffect();
     ApplyHeatHazeEffect();
-    
-    // Update self-shadowing if enabled
-    if (settings_.enableSelfShadowing) {
-        UpdateSelfShadowMaps();
-    }
 }
 
 void LightingEngine::PerformDeferredLightingPass() {
-    // Set scene render target as output
-    context_->OMSetRenderTargets(1, &sceneSurface_, nullptr);
+    if (!deferredRenderingEnabled_ || !deferred_ || !sceneTarget_) return;
+    
+    // The G-buffer, its depth and the scene are all read or written by compute from here
+    stateCache_->OMSetRenderTargets(0, nullptr, nullptr);
+    
+    // This frame's rates come from the last lit frame, still in the scene texture
+    ID3D11ShaderResourceView* shadingRate = nullptr;
+    if (variableRateShadingEnabled_ && shadingRate_) {
+        shadingRate_->Build(sceneSRV_, nullptr);
+        shadingRate = shadingRate_->GetRateView();
+    }
+    
+    XMMATRIX view = XMLoadFloat4x4(&cullView_);
+    XMMATRIX projection = XMLoadFloat4x4(&cullProjection_);
+    XMFLOAT3 ambient(settings_.ambientColor.x * settings_.ambientIntensity,
+                     settings_.ambientColor.y * settings_.ambientIntensity,
+                     settings_.ambientColor.z * settings_.ambientIntensity);
+    
+    // Reflections likewise read the last lit frame, so they go before the clear
+    ID3D11ShaderResourceView* reflections = RenderReflections(view, projection, ambient);
     
-    // Clear scene render target
     float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
     context_->ClearRenderTargetView(sceneSurface_, clearColor);
     
-    // Bind G-Buffer textures as shader resources
-    ID3D11ShaderResourceView* srvs[] = {
-        gBuffer_.albedoSRV,
-        gBuffer_.normalSRV,
-        gBuffer_.positionSRV
-    };
-    context_->PSSetShaderResources(0, 3, srvs);
+    RenderSSAO(deferred_->GetDepthView(), view, projection);
     
-    // Perform lighting calculations for each light
-    for (const auto& light : lightsVector_) {
-        RenderLight(light);
-    }
+    deferred_->Render(clusteredLights_.get(), GetSSAOView(), view, projection, ambient, DISPLAY_GAMMA, sceneTarget_,
+                      shadingRate, probes_, reflections);
 }
 
 void LightingEngine::RenderLight(const Light& light) {
@@ -512,30 +516,38 @@ void LightingEngine::RenderLight(const Light& light) {
 }
 
 void LightingEngine::ApplyBloomEffect() {
-    // Set bloom render target
-    context_->OMSetRenderTargets(1, &bloomSurface_, nullptr);
-    
-    // Clear bloom render target
-    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-    context_->ClearRenderTargetView(bloomSurface_, clearColor);
-    
-    // Bind scene texture as input
-    context_->PSSetShaderResources(0, 1, &sceneSRV_);
+    if (!settings_.enableLightBloom || !bloom_) return;
     
-    // Apply bloom shader (placeholder)
-    // This would render a full-screen quad with bloom shader
+    // The scene is read and the bloom texture written by compute, so neither may stay bound
+    ID3D11ShaderResourceView* nullView = nullptr;
+    stateCache_->OMSetRenderTargets(0, nullptr, nullptr);
+    stateCache_->PSSetShaderResources(0, 1, &nullView);
+    bloom_->Render(sceneSRV_, bloomTarget_);
+}
+
+void LightingEngine::EnableBloom(bool enable) {
+    settings_.enableLightBloom = enable;
+}
+
+void LightingEngine::SetBloomParameters(float threshold, float intensity) {
+    settings_.bloomThreshold = threshold;
+    settings_.bloomIntensity = intensity;
+    if (bloom_) {
+        bloom_->SetParameters(threshold, intensity);
+    }
 }
 
 void LightingEngine::ApplyHeatHazeEffect() {
     // Set heat haze render target
-    context_->OMSetRenderTargets(1, &heatHazeSurface_, nullptr);
+    stateCache_->OMSetRenderTargets(1, &heatHazeSurface_, nullptr);
     
     // Clear heat haze render target
     float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
     context_->ClearRenderTargetView(heatHazeSurface_, clearColor);
     
-    // Bind scene texture as input
-    context_->PSSetShaderResources(0, 1, &sceneSRV_);
+    // Bind the scene as input, with bloom when it ran
+    ID3D11ShaderResourceView* input = settings_.enableLightBloom && bloom_ ? bloomTextureSRV_ : sceneSRV_;
+    stateCache_->PSSetShaderResources(0, 1, &input);
     
     // Apply heat haze shader (placeholder)
     // This would render a full-screen quad with heat haze distortion shader
@@ -559,96 +571,81 @@ void LightingEngine::UpdateLight(int lightId, const Light& light) {
     }
 }
 
-void LightingEngine::CreateShadowMap(int lightId, int size) {
-    ShadowMap shadowMap;
-    shadowMap.lightId = lightId;
-    shadowMap.size = size;
-    shadowMap.renderTargetView = nullptr;
-    shadowMap.shaderResourceView = nullptr;
-    shadowMap.depthStencilView = nullptr;
-    
-    // Create shadow map texture
-    D3D11_TEXTURE2D_DESC textureDesc = {};
-    textureDesc.Width = size;
-    textureDesc.Height = size;
-    textureDesc.MipLevels = 1;
-    textureDesc.ArraySize = 1;
-    textureDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.SampleDesc.Quality = 0;
-    textureDesc.Usage = D3D11_USAGE_DEFAULT;
-    textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-    textureDesc.CPUAccessFlags = 0;
-    textureDesc.MiscFlags = 0;
+void LightingEngine::CullLights(Camera* camera) {
+    if (!camera) return;
+    CullLights(camera->GetViewMatrix(), camera->GetProjectionMatrix());
+}
+
+void LightingEngine::CullLights(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection) {
+    XMStoreFloat4x4(&cullView_, view);
+    XMStoreFloat4x4(&cullProjection_, projection);
+    if (!clusteredLights_) return;
     
-    HRESULT hr = device_->CreateTexture2D(&textureDesc, nullptr, &shadowMap.texture);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create shadow map texture");
-        return;
+    GatherLights();
+    clusteredLights_->Build(lightInput_, view, projection, screenWidth_, screenHeight_, jobs_);
+    if (decals_) {
+        decals_->Build(*clusteredLights_, view, jobs_);
     }
-    
-    // Create render target view
-    D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
-    rtvDesc.Format = textureDesc.Format;
-    rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-    rtvDesc.Texture2D.MipSlice = 0;
-    
-    hr = device_->CreateRenderTargetView(shadowMap.texture, &rtvDesc, &shadowMap.renderTargetView);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create shadow map render target view");
-        return;
+}
+
+void LightingEngine::GatherLights() {
+    lightInput_.clear();
+    lightInput_.reserve(lightsVector_.size() + lights_.size());
+    for (const Light& light : lightsVector_) {
+        lightInput_.push_back(&light);
     }
-    
-    // Create shader resource view
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = textureDesc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MostDetailedMip = 0;
-    srvDesc.Texture2D.MipLevels = 1;
-    
-    hr = device_->CreateShaderResourceView(shadowMap.texture, &srvDesc, &shadowMap.shaderResourceView);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create shadow map shader resource view");
-        return;
+    for (const auto& light : lights_) {
+        lightInput_.push_back(light.get());
     }
-    
-    // Create depth texture
-    D3D11_TEXTURE2D_DESC depthDesc = {};
-    depthDesc.Width = size;
-    depthDesc.Height = size;
-    depthDesc.MipLevels = 1;
-    depthDesc.ArraySize = 1;
-    depthDesc.Format = DXGI_FORMAT_D32_FLOAT;
-    depthDesc.SampleDesc.Count = 1;
-    depthDesc.SampleDesc.Quality = 0;
-    depthDesc.Usage = D3D11_USAGE_DEFAULT;
-    depthDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-    depthDesc.CPUAccessFlags = 0;
-    depthDesc.MiscFlags = 0;
-    
-    hr = device_->CreateTexture2D(&depthDesc, nullptr, &shadowMap.depthTexture);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create shadow map depth texture");
-        return;
+}
+
+void LightingEngine::BindClusteredLights() {
+    if (clusteredLights_) {
+        clusteredLights_->Bind(*stateCache_);
     }
-    
-    // Create depth stencil view
-    D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
-    dsvDesc.Format = depthDesc.Format;
-    dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-    dsvDesc.Texture2D.MipSlice = 0;
-    
-    hr = device_->CreateDepthStencilView(shadowMap.depthTexture, &dsvDesc, &shadowMap.depthStencilView);
-    if (FAILED(hr)) {
-        Logger::Error("Failed to create shadow map depth stencil view");
-        return;
+    if (probes_) {
+        probes_->Bind(*stateCache_);
     }
+    if (decals_) {
+        decals_->Bind(*stateCache_);
+    }
+}
+
+void LightingEngine::SetMaxLightsPerPass(int maxLights) {
+    maxLightsPerPass_ = std::max(1, maxLights);
+    if (clusteredLights_) {
+        clusteredLights_->SetMaxLightsPerCluster(static_cast<UINT>(maxLightsPerPass_));
+    }
+}
+
+void LightingEngine::SetupCascadedShadowMaps(int numCascades) {
+    CascadedShadowMaps::Settings settings;
+    settings.resolution = static_cast<UINT>(settings_.shadowQuality);
+    settings.cascadeCount = static_cast<UINT>(std::clamp(numCascades, 1, static_cast<int>(CascadedShadowMaps::MAX_CASCADES)));
+
+    cascadedShadows_ = std::make_unique<CascadedShadowMaps>();
+    if (!cascadedShadows_->Initialize(device_, context_, stateCache_, settings)) {
+        Logger::Warning("Cascaded shadow maps unavailable");
+        cascadedShadows_.reset();
+    }
+}
+
+void LightingEngine::UpdateCascadedShadowMaps(Camera* camera, Light* directionalLight) {
+    if (!cascadedShadows_ || !camera || !directionalLight || !settings_.enableShadows) return;
+    if (directionalLight->GetType() != LightType::Directional) return;
+    cascadedShadows_->Update(camera->GetViewMatrix(), camera->GetProjectionMatrix(), directionalLight->GetDirection());
+}
+
+void LightingEngine::UpdateShadowAtlas(Camera* camera) {
+    if (!camera) return;
+    UpdateShadowAtlas(camera->GetViewMatrix(), camera->GetProjectionMatrix());
+}
+
+void LightingEngine::UpdateShadowAtlas(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection) {
+    if (!shadowAtlas_ || !settings_.enableShadows) return;
     
-    // Initialize matrices
-    shadowMap.lightViewMatrix = XMMatrixIdentity();
-    shadowMap.lightProjectionMatrix = XMMatrixIdentity();
-    
-    shadowMapsVector_.push_back(shadowMap);
+    GatherLights();
+    shadowAtlas_->Update(lightInput_, view, projection);
 }
 
 void LightingEngine::DestroyShadowMap(ShadowMap& shadowMap) {
@@ -674,25 +671,122 @@ void LightingEngine::DestroyShadowMap(ShadowMap& shadowMap) {
     }
 }
 
-void LightingEngine::UpdateSelfShadowMaps() {
-    // Update self-shadowing shadow maps
-    // This is a placeholder implementation
-    for (auto& shadowMap : shadowMapsVector_) {
-        // Render to shadow map
-        context_->OMSetRenderTargets(1, &shadowMap.renderTargetView, shadowMap.depthStencilView);
-        
-        // Clear shadow map
-        float clearColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-        context_->ClearRenderTargetView(shadowMap.renderTargetView, clearColor);
-        context_->ClearDepthStencilView(shadowMap.depthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
-        
-        // Render scene from light's perspective
-        // This would be implemented based on the specific rendering pipeline
+void LightingEngine::SetLightingSettings(const LightingSettings& settings) {
+    bool ssaoChanged = settings.ssaoQuality != settings_.ssaoQuality;
+    settings_ = settings;
+    if (bloom_) {
+        bloom_->SetParameters(settings_.bloomThreshold, settings_.bloomIntensity);
+    }
+    if (ssaoChanged && device_) {
+        CreateSSAO();
     }
 }
 
-void LightingEngine::SetLightingSettings(const LightingSettings& settings) {
-    settings_ = settings;
+void LightingEngine::CreateSSAO() {
+    ssao_.reset();
+    
+    SSAORenderer::Settings ssaoSettings;
+    switch (settings_.ssaoQuality) {
+        case SSAOQuality::Off:
+            return;
+        case SSAOQuality::Low:
+            ssaoSettings.resolutionDivisor = 4;
+            ssaoSettings.sampleCount = 6;
+            break;
+        case SSAOQuality::Medium:
+            ssaoSettings.resolutionDivisor = 2;
+            ssaoSettings.sampleCount = 8;
+            break;
+        case SSAOQuality::High:
+            ssaoSettings.resolutionDivisor = 2;
+            ssaoSettings.sampleCount = 16;
+            break;
+        case SSAOQuality::Ultra:
+            ssaoSettings.resolutionDivisor = 1;
+            ssaoSettings.sampleCount = 16;
+            break;
+    }
+    
+    // Ambient light goes unoccluded without it
+    ssao_ = std::make_unique<SSAORenderer>();
+    if (!ssao_->Initialize(device_, context_, screenWidth_, screenHeight_, ssaoSettings)) {
+        Logger::Warning("SSAO unavailable");
+        ssao_.reset();
+    }
+}
+
+void LightingEngine::EnableSSAO(bool enable) {
+    ssaoEnabled_ = enable;
+}
+
+void LightingEngine::RenderSSAO(ID3D11ShaderResourceView* depth, Camera* camera) {
+    if (!camera) return;
+    RenderSSAO(depth, camera->GetViewMatrix(), camera->GetProjectionMatrix());
+}
+
+void LightingEngine::RenderSSAO(ID3D11ShaderResourceView* depth, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection) {
+    if (!ssao_) return;
+    if (!ssaoEnabled_) {
+        // Stale history would ghost once it is turned back on
+        ssao_->ResetHistory();
+        return;
+    }
+    
+    // The depth buffer is read by compute, so it may not stay bound as the depth target
+    stateCache_->OMSetRenderTargets(0, nullptr, nullptr);
+    ssao_->Render(depth, view, projection);
+}
+
+void LightingEngine::EnableVariableRateShading(bool enable) {
+    variableRateShadingEnabled_ = enable;
+    if (enable && !shadingRate_ && device_) {
+        shadingRate_ = std::make_unique<ShadingRateImage>();
+        if (!shadingRate_->Initialize(device_, context_, screenWidth_, screenHeight_, ShadingRateImage::Settings())) {
+            Logger::Warning("Variable rate shading unavailable");
+            shadingRate_.reset();
+            variableRateShadingEnabled_ = false;
+        }
+    } else if (!enable && shadingRate_) {
+        // Rates from before would land on an unrelated frame once turned back on
+        shadingRate_->Invalidate();
+    }
+}
+
+void LightingEngine::EnableScreenSpaceReflections(bool enable) {
+    reflectionsEnabled_ = enable;
+    if (enable && !reflections_ && device_) {
+        reflections_ = std::make_unique<ScreenSpaceReflections>();
+        if (!reflections_->Initialize(device_, context_, screenWidth_, screenHeight_, ScreenSpaceReflections::Settings())) {
+            Logger::Warning("Screen-space reflections unavailable");
+            reflections_.reset();
+            reflectionsEnabled_ = false;
+        }
+    } else if (!enable && reflections_) {
+        // Stale history would ghost once it is turned back on
+        reflections_->ResetHistory();
+    }
+}
+
+ID3D11ShaderResourceView* LightingEngine::RenderReflections(FXMMATRIX view, CXMMATRIX projection, const XMFLOAT3& ambient) {
+    if (!reflectionsEnabled_ || !reflections_) return nullptr;
+    
+    if (occlusion_) {
+        XMFLOAT4X4 viewProjection;
+        XMStoreFloat4x4(&viewProjection, view * projection);
+        occlusion_->BuildPyramid(deferred_->GetDepthView(), viewProjection);
+    }
+    reflections_->Render(*deferred_, occlusion_, sceneSRV_, DISPLAY_GAMMA, view, projection, ambient, probes_);
+    return reflections_->GetReflectionView();
+}
+
+void LightingEngine::UpdateProbeVolume(const PhysicsEngine* physics) {
+    if (!probes_) return;
+    GatherLights();
+    probes_->Update(physics, lightInput_);
+}
+
+ID3D11ShaderResourceView* LightingEngine::GetSSAOView() const {
+    return ssao_ && ssaoEnabled_ ? ssao_->GetOcclusionView() : nullptr;
 }
 
 void LightingEngine::Update(float deltaTime) {
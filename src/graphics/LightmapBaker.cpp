@@ -0,0 +1,963 @@
+#include "LightmapBaker.h"
+#include "BlockCompressor.h"
+#include "JobSystem.h"
+#include "Light.h"
+#include "MeshImporter.h"
+#include "StaticGeometry.h"
+#include "TextureFile.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
+namespace Nexus {
+
+namespace {
+
+const char* INDEX_FILE = "lightmaps.txt";
+const char* ATLAS_FILE = "lightmap.dds";
+const int TILE_SIZE = 16;               // Texels per side of one tracing job
+const float WELD_GRID = 1e-4f;          // Corners this close share chart edges
+const float LUMINANCE_SIGMA = 4.0f;     // Denoiser tolerance, in standard deviations of the estimate
+
+struct Triangle {
+    XMFLOAT3 position[3];               // World space
+    XMFLOAT3 normal[3];
+    XMFLOAT3 faceNormal;                // On the side the vertex normals point to
+    float area;
+    uint32_t vertex[3];                 // Into the placement's source mesh
+    uint32_t chart;
+};
+
+struct Chart {
+    uint32_t instance = 0;
+    std::vector<uint32_t> triangles;
+    XMFLOAT3 axisU = { 1.0f, 0.0f, 0.0f };
+    XMFLOAT3 axisV = { 0.0f, 0.0f, 1.0f };
+    XMFLOAT2 min = { 0.0f, 0.0f };      // Projected extent
+    XMFLOAT2 max = { 0.0f, 0.0f };
+    int x = 0, y = 0;                   // Atlas rectangle, padding included
+    int width = 0, height = 0;
+};
+
+struct Texel {
+    uint32_t pixel;
+    uint32_t chart;
+    XMFLOAT3 position;
+    XMFLOAT3 normal;
+    XMFLOAT3 faceNormal;
+};
+
+// Sums of the indirect estimate of one texel
+struct Accumulator {
+    XMFLOAT3 sum = { 0.0f, 0.0f, 0.0f };
+    float luminance = 0.0f;
+    float luminanceSq = 0.0f;
+    uint32_t count = 0;
+};
+
+XMFLOAT3 Add(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+XMFLOAT3 Scale(const XMFLOAT3& v, float s) {
+    return XMFLOAT3(v.x * s, v.y * s, v.z * s);
+}
+
+XMFLOAT3 Multiply(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.x * b.x, a.y * b.y, a.z * b.z);
+}
+
+float Dot(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+XMFLOAT3 Normalize(const XMFLOAT3& v, const XMFLOAT3& fallback) {
+    const float length = std::sqrt(Dot(v, v));
+    return length > 1e-12f ? Scale(v, 1.0f / length) : fallback;
+}
+
+float Luminance(const XMFLOAT3& color) {
+    return color.x * 0.2126f + color.y * 0.7152f + color.z * 0.0722f;
+}
+
+XMMATRIX GetWorldMatrix(const HlodBuilder::Placement& placement) {
+    return XMMatrixScaling(placement.scale.x, placement.scale.y, placement.scale.z) *
+           XMMatrixRotationRollPitchYaw(XMConvertToRadians(placement.rotation.x),
+                                        XMConvertToRadians(placement.rotation.y),
+                                        XMConvertToRadians(placement.rotation.z)) *
+           XMMatrixTranslation(placement.position.x, placement.position.y, placement.position.z);
+}
+
+// PCG hash; seeding from texel and sample gives every path its own stream without shared state
+uint32_t Hash(uint32_t value) {
+    const uint32_t state = value * 747796405u + 2891336453u;
+    const uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+struct Random {
+    uint32_t state;
+    float Next() {
+        state = Hash(state);
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+float RadicalInverse(uint32_t bits) {
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return bits * 2.3283064365386963e-10f;
+}
+
+// Cosine-weighted direction around n, in the branchless basis of Duff et al.
+XMFLOAT3 CosineSample(const XMFLOAT3& n, float u1, float u2) {
+    const float sign = std::copysign(1.0f, n.z);
+    const float a = -1.0f / (sign + n.z);
+    const float b = n.x * n.y * a;
+    const XMFLOAT3 tangent(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+    const XMFLOAT3 bitangent(b, sign + n.y * n.y * a, -n.y);
+    const float r = std::sqrt(u1);
+    const float phi = XM_2PI * u2;
+    return Add(Add(Scale(tangent, r * std::cos(phi)), Scale(bitangent, r * std::sin(phi))),
+               Scale(n, std::sqrt(std::max(0.0f, 1.0f - u1))));
+}
+
+// Traces four texels at a time through TriangleMeshCollider::RayCastPacket. Stateless, so the
+// tiles share one
+struct PathTracer {
+    const TriangleMeshCollider& scene;
+    const std::vector<const Light*>& lights;
+    const LightmapBaker::Settings& settings;
+    float bias;
+
+    // Irradiance from the lights at the points of the lanes in mask, each with a shadow ray
+    void DirectLight(const XMFLOAT3* points, const XMFLOAT3* normals, uint32_t mask, XMFLOAT3* irradiance) const {
+        for (uint32_t lane = 0; lane < TriangleMeshCollider::PACKET_SIZE; ++lane) {
+            irradiance[lane] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        }
+        for (const Light* light : lights) {
+            if (!light) continue;
+            XMFLOAT3 delta[TriangleMeshCollider::PACKET_SIZE] = {};
+            XMFLOAT3 contribution[TriangleMeshCollider::PACKET_SIZE] = {};
+            float maxFraction[TriangleMeshCollider::PACKET_SIZE];
+            uint32_t lanes = 0;
+            for (uint32_t lane = 0; lane < TriangleMeshCollider::PACKET_SIZE; ++lane) {
+                maxFraction[lane] = -1.0f;
+                if (!(mask & (1u << lane))) continue;
+                const XMFLOAT3& point = points[lane];
+                XMFLOAT3 L;
+                float attenuation = 1.0f;
+                if (light->GetType() == LightType::Directional) {
+                    L = Normalize(Scale(light->GetDirection(), -1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+                    delta[lane] = Scale(L, settings.maxDistance);
+                    maxFraction[lane] = 1.0f;
+                } else {
+                    const float range = light->GetRange();
+                    const XMFLOAT3 toLight = Subtract(light->GetPosition(), point);
+                    const float distanceSq = Dot(toLight, toLight);
+                    if (range <= 0.0f || distanceSq >= range * range) continue;
+                    L = Scale(toLight, 1.0f / std::sqrt(std::max(distanceSq, 1e-8f)));
+                    // Same falloff as the clustered lights and ProbeVolume; spot cones are hard-edged
+                    const float ratio = distanceSq / (range * range);
+                    const float window = std::clamp(1.0f - ratio * ratio, 0.0f, 1.0f);
+                    attenuation = window * window / std::max(distanceSq, 0.01f);
+                    if (light->GetType() == LightType::Spot) {
+                        const XMFLOAT3 spot = Normalize(light->GetDirection(), XMFLOAT3(0.0f, -1.0f, 0.0f));
+                        if (-Dot(L, spot) < std::cos(std::min(light->GetConeAngle(), XM_PIDIV2))) continue;
+                    }
+                    delta[lane] = toLight;
+                    maxFraction[lane] = 0.999f;
+                }
+                const float NdotL = Dot(normals[lane], L);
+                if (NdotL <= 0.0f) {
+                    maxFraction[lane] = -1.0f;
+                    continue;
+                }
+                contribution[lane] = Scale(light->GetColor(), light->GetIntensity() * attenuation * NdotL);
+                lanes |= 1u << lane;
+            }
+            if (!lanes) continue;
+
+            TriangleMeshCollider::RayHit hits[TriangleMeshCollider::PACKET_SIZE];
+            scene.RayCastPacket(points, delta, maxFraction, TriangleMeshCollider::PACKET_SIZE, hits);
+            for (uint32_t lane = 0; lane < TriangleMeshCollider::PACKET_SIZE; ++lane) {
+                if ((lanes & (1u << lane)) && !hits[lane].hit) {
+                    irradiance[lane] = Add(irradiance[lane], contribution[lane]);
+                }
+            }
+        }
+    }
+
+    // Radiance along one cosine-distributed path per texel. The first direction is sample of
+    // samples in a Hammersley set rotated per texel, so every pass adds evenly spread directions
+    void TracePaths(const Texel* const* texels, uint32_t count, uint32_t sample, uint32_t samples,
+                    XMFLOAT3* radiance) const {
+        const uint32_t LANES = TriangleMeshCollider::PACKET_SIZE;
+        XMFLOAT3 origin[LANES] = {}, direction[LANES] = {}, throughput[LANES] = {};
+        Random random[LANES] = {};
+        uint32_t active = 0;
+        for (uint32_t lane = 0; lane < count; ++lane) {
+            const Texel& texel = *texels[lane];
+            radiance[lane] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            Random rotation = { Hash(texel.pixel) };
+            float u1 = (sample + 0.5f) / samples + rotation.Next();
+            float u2 = RadicalInverse(sample) + rotation.Next();
+            u1 -= std::floor(u1);
+            u2 -= std::floor(u2);
+            direction[lane] = CosineSample(texel.normal, u1, u2);
+            // Interpolated normals can lean past the face; mirror what would go through it
+            const float below = Dot(direction[lane], texel.faceNormal);
+            if (below < 0.0f) direction[lane] = Subtract(direction[lane], Scale(texel.faceNormal, 2.0f * below));
+            origin[lane] = Add(texel.position, Scale(texel.faceNormal, bias));
+            throughput[lane] = XMFLOAT3(1.0f, 1.0f, 1.0f);
+            random[lane].state = Hash(texel.pixel ^ Hash(sample + 0x9E3779B9u));
+            active |= 1u << lane;
+        }
+
+        const float reflectance = settings.albedo;
+        for (UINT bounce = 0; bounce < settings.bounces && active; ++bounce) {
+            XMFLOAT3 delta[LANES];
+            float maxFraction[LANES];
+            for (uint32_t lane = 0; lane < LANES; ++lane) {
+                delta[lane] = Scale(direction[lane], settings.maxDistance);
+                maxFraction[lane] = (active & (1u << lane)) ? 1.0f : -1.0f;
+            }
+            TriangleMeshCollider::RayHit hits[LANES];
+            scene.RayCastPacket(origin, delta, maxFraction, LANES, hits);
+
+            XMFLOAT3 points[LANES] = {}, normals[LANES] = {};
+            uint32_t lit = 0;
+            for (uint32_t lane = 0; lane < count; ++lane) {
+                if (!(active & (1u << lane))) continue;
+                const TriangleMeshCollider::RayHit& hit = hits[lane];
+                if (!hit.hit) {
+                    radiance[lane] = Add(radiance[lane], Multiply(throughput[lane], settings.skyColor));
+                    continue;
+                }
+                if (hit.backFace) continue;
+                points[lane] = Add(Add(origin[lane], Scale(delta[lane], hit.fraction)), Scale(hit.normal, bias));
+                normals[lane] = hit.normal;
+                lit |= 1u << lane;
+            }
+            if (!lit) break;
+
+            // Lambertian: radiance is reflectance / pi times irradiance, and cosine sampling
+            // leaves reflectance as the throughput of the next segment
+            XMFLOAT3 irradiance[LANES];
+            DirectLight(points, normals, lit, irradiance);
+            for (uint32_t lane = 0; lane < count; ++lane) {
+                if (!(lit & (1u << lane))) continue;
+                radiance[lane] = Add(radiance[lane], Multiply(throughput[lane], Scale(irradiance[lane], reflectance / XM_PI)));
+                throughput[lane] = Scale(throughput[lane], reflectance);
+                origin[lane] = points[lane];
+                const float u1 = random[lane].Next();
+                const float u2 = random[lane].Next();
+                direction[lane] = CosineSample(normals[lane], u1, u2);
+            }
+            active = lit;
+        }
+    }
+};
+
+struct WeldKey {
+    int64_t x, y, z;
+    bool operator==(const WeldKey& other) const { return x == other.x && y == other.y && z == other.z; }
+};
+
+struct WeldKeyHash {
+    size_t operator()(const WeldKey& key) const {
+        return std::hash<int64_t>()(key.x * 73856093 ^ key.y * 19349663 ^ key.z * 83492791);
+    }
+};
+
+// Flood fills the triangles [first, end) of one placement into charts across welded edges
+void BuildCharts(std::vector<Triangle>& triangles, uint32_t first, uint32_t end, uint32_t instance,
+                 float cosAngle, std::vector<Chart>& charts) {
+    std::unordered_map<WeldKey, uint32_t, WeldKeyHash> corners;
+    auto cornerId = [&](const XMFLOAT3& p) {
+        const WeldKey key = { std::llround(p.x / WELD_GRID), std::llround(p.y / WELD_GRID), std::llround(p.z / WELD_GRID) };
+        return corners.emplace(key, static_cast<uint32_t>(corners.size())).first->second;
+    };
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> edges;
+    for (uint32_t t = first; t < end; ++t) {
+        uint32_t ids[3];
+        for (int c = 0; c < 3; ++c) ids[c] = cornerId(triangles[t].position[c]);
+        for (int c = 0; c < 3; ++c) {
+            const uint32_t a = std::min(ids[c], ids[(c + 1) % 3]);
+            const uint32_t b = std::max(ids[c], ids[(c + 1) % 3]);
+            edges[(static_cast<uint64_t>(a) << 32) | b].push_back(t);
+        }
+    }
+    std::vector<std::vector<uint32_t>> neighbours(end - first);
+    for (const auto& [edge, shared] : edges) {
+        for (uint32_t a : shared) {
+            for (uint32_t b : shared) {
+                if (a != b) neighbours[a - first].push_back(b);
+            }
+        }
+    }
+
+    std::vector<uint32_t> queue;
+    for (uint32_t seed = first; seed < end; ++seed) {
+        if (triangles[seed].chart != UINT32_MAX) continue;
+        const uint32_t chartIndex = static_cast<uint32_t>(charts.size());
+        charts.emplace_back();
+        Chart& chart = charts.back();
+        chart.instance = instance;
+        const XMFLOAT3 seedNormal = triangles[seed].faceNormal;
+
+        triangles[seed].chart = chartIndex;
+        queue.assign(1, seed);
+        XMFLOAT3 normalSum(0.0f, 0.0f, 0.0f);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            const Triangle& triangle = triangles[queue[head]];
+            chart.triangles.push_back(queue[head]);
+            normalSum = Add(normalSum, Scale(triangle.faceNormal, triangle.area));
+            for (uint32_t next : neighbours[queue[head] - first]) {
+                if (triangles[next].chart != UINT32_MAX || Dot(triangles[next].faceNormal, seedNormal) < cosAngle) continue;
+                triangles[next].chart = chartIndex;
+                queue.push_back(next);
+            }
+        }
+
+        // Project onto the plane of the area-weighted normal
+        const XMFLOAT3 normal = Normalize(normalSum, seedNormal);
+        const XMFLOAT3 up = std::abs(normal.y) < 0.99f ? XMFLOAT3(0.0f, 1.0f, 0.0f) : XMFLOAT3(1.0f, 0.0f, 0.0f);
+        chart.axisU = Normalize(Cross(up, normal), XMFLOAT3(1.0f, 0.0f, 0.0f));
+        chart.axisV = Cross(normal, chart.axisU);
+        chart.min = XMFLOAT2(FLT_MAX, FLT_MAX);
+        chart.max = XMFLOAT2(-FLT_MAX, -FLT_MAX);
+        for (uint32_t t : chart.triangles) {
+            for (const XMFLOAT3& p : triangles[t].position) {
+                const float u = Dot(p, chart.axisU), v = Dot(p, chart.axisV);
+                chart.min = XMFLOAT2(std::min(chart.min.x, u), std::min(chart.min.y, v));
+                chart.max = XMFLOAT2(std::max(chart.max.x, u), std::max(chart.max.y, v));
+            }
+        }
+    }
+}
+
+// Shelf packing, tallest charts first; false if they do not fit at this density
+bool PackCharts(std::vector<Chart>& charts, const std::vector<uint32_t>& order, float density, int atlasSize,
+                int padding) {
+    int x = 0, y = 0, shelf = 0;
+    for (uint32_t index : order) {
+        Chart& chart = charts[index];
+        chart.width = static_cast<int>(std::ceil((chart.max.x - chart.min.x) * density)) + 1 + padding * 2;
+        chart.height = static_cast<int>(std::ceil((chart.max.y - chart.min.y) * density)) + 1 + padding * 2;
+        if (chart.width > atlasSize) return false;
+        if (x + chart.width > atlasSize) {
+            x = 0;
+            y += shelf;
+            shelf = 0;
+        }
+        if (y + chart.height > atlasSize) return false;
+        chart.x = x;
+        chart.y = y;
+        x += chart.width;
+        shelf = std::max(shelf, chart.height);
+    }
+    return true;
+}
+
+// Texel-space position of a point of a chart; texel (x, y) has its centre at (x + 0.5, y + 0.5)
+XMFLOAT2 ChartTexel(const Chart& chart, const XMFLOAT3& p, float density, int padding) {
+    return XMFLOAT2(chart.x + padding + 0.5f + (Dot(p, chart.axisU) - chart.min.x) * density,
+                    chart.y + padding + 0.5f + (Dot(p, chart.axisV) - chart.min.y) * density);
+}
+
+// Texels whose centre a triangle covers, and those within 0.75 texels of one, which take the
+// nearest point on it so bilinear filtering at chart borders reads the surface, not beyond it
+void RasterizeChart(const std::vector<Chart>& charts, uint32_t chartIndex, const std::vector<Triangle>& triangles,
+                    float density, int padding, int atlasSize, std::vector<int32_t>& texelOf,
+                    std::vector<float>& distanceOf, std::vector<Texel>& texels) {
+    const Chart& chart = charts[chartIndex];
+    for (uint32_t t : chart.triangles) {
+        const Triangle& triangle = triangles[t];
+        XMFLOAT2 c[3];
+        for (int i = 0; i < 3; ++i) c[i] = ChartTexel(chart, triangle.position[i], density, padding);
+        const float area = (c[1].x - c[0].x) * (c[2].y - c[0].y) - (c[2].x - c[0].x) * (c[1].y - c[0].y);
+        if (std::abs(area) < 1e-8f) continue;
+
+        const int x0 = std::max(chart.x, static_cast<int>(std::floor(std::min({ c[0].x, c[1].x, c[2].x }))) - 1);
+        const int y0 = std::max(chart.y, static_cast<int>(std::floor(std::min({ c[0].y, c[1].y, c[2].y }))) - 1);
+        const int x1 = std::min(chart.x + chart.width - 1, static_cast<int>(std::ceil(std::max({ c[0].x, c[1].x, c[2].x }))) + 1);
+        const int y1 = std::min(chart.y + chart.height - 1, static_cast<int>(std::ceil(std::max({ c[0].y, c[1].y, c[2].y }))) + 1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                const float px = x + 0.5f, py = y + 0.5f;
+                float w0 = ((c[1].x - px) * (c[2].y - py) - (c[2].x - px) * (c[1].y - py)) / area;
+                float w1 = ((c[2].x - px) * (c[0].y - py) - (c[0].x - px) * (c[2].y - py)) / area;
+                float w2 = 1.0f - w0 - w1;
+                float distance = 0.0f;
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+                    w0 = std::max(w0, 0.0f);
+                    w1 = std::max(w1, 0.0f);
+                    w2 = std::max(w2, 0.0f);
+                    const float sum = w0 + w1 + w2;
+                    w0 /= sum;
+                    w1 /= sum;
+                    w2 /= sum;
+                    const float qx = c[0].x * w0 + c[1].x * w1 + c[2].x * w2 - px;
+                    const float qy = c[0].y * w0 + c[1].y * w1 + c[2].y * w2 - py;
+                    distance = std::sqrt(qx * qx + qy * qy);
+                    if (distance > 0.75f) continue;
+                }
+
+                const uint32_t pixel = y * atlasSize + x;
+                if (texelOf[pixel] >= 0 && distanceOf[pixel] <= distance) continue;
+                Texel texel;
+                texel.pixel = pixel;
+                texel.chart = chartIndex;
+                texel.position = Add(Add(Scale(triangle.position[0], w0), Scale(triangle.position[1], w1)),
+                                     Scale(triangle.position[2], w2));
+                texel.normal = Normalize(Add(Add(Scale(triangle.normal[0], w0), Scale(triangle.normal[1], w1)),
+                                             Scale(triangle.normal[2], w2)), triangle.faceNormal);
+                texel.faceNormal = triangle.faceNormal;
+                if (texelOf[pixel] >= 0) {
+                    texels[texelOf[pixel]] = texel;
+                } else {
+                    texelOf[pixel] = static_cast<int32_t>(texels.size());
+                    texels.push_back(texel);
+                }
+                distanceOf[pixel] = distance;
+            }
+        }
+    }
+}
+
+// Edge-aware a-trous wavelet filter over the texels, as in SVGF: a 5x5 B3 spline kernel at
+// widening steps, weighted by normal, distance off the centre texel's plane and luminance
+// difference relative to the noise the estimate still has. Variance is filtered alongside
+void Denoise(const std::vector<Texel>& texels, const std::vector<int32_t>& texelOf, int atlasSize, float density,
+             UINT iterations, std::vector<XMFLOAT3>& color, std::vector<float>& variance, JobSystem* jobs) {
+    static const float KERNEL[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+    std::vector<XMFLOAT3> nextColor(color.size());
+    std::vector<float> nextVariance(variance.size());
+
+    for (UINT iteration = 0; iteration < iterations; ++iteration) {
+        const int step = 1 << iteration;
+        auto filter = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Texel& center = texels[i];
+                const int cx = static_cast<int>(center.pixel % atlasSize);
+                const int cy = static_cast<int>(center.pixel / atlasSize);
+                const float centerLuminance = Luminance(color[i]);
+                const float sigma = LUMINANCE_SIGMA * std::sqrt(variance[i]) + 1e-4f;
+
+                XMFLOAT3 sum(0.0f, 0.0f, 0.0f);
+                float weightSum = 0.0f, varianceSum = 0.0f;
+                for (int dy = -2; dy <= 2; ++dy) {
+                    const int y = cy + dy * step;
+                    if (y < 0 || y >= atlasSize) continue;
+                    for (int dx = -2; dx <= 2; ++dx) {
+                        const int x = cx + dx * step;
+                        if (x < 0 || x >= atlasSize) continue;
+                        const int32_t j = texelOf[y * atlasSize + x];
+                        if (j < 0 || texels[j].chart != center.chart) continue;
+
+                        const Texel& other = texels[j];
+                        float weight = KERNEL[std::abs(dx)] * KERNEL[std::abs(dy)];
+                        weight *= std::pow(std::max(0.0f, Dot(center.normal, other.normal)), 32.0f);
+                        weight *= std::exp(-std::abs(Dot(Subtract(other.position, center.position), center.faceNormal)) * density);
+                        weight *= std::exp(-std::abs(Luminance(color[j]) - centerLuminance) / sigma);
+                        sum = Add(sum, Scale(color[j], weight));
+                        weightSum += weight;
+                        varianceSum += variance[j] * weight * weight;
+                    }
+                }
+                // The centre always counts, so weightSum is positive
+                nextColor[i] = Scale(sum, 1.0f / weightSum);
+                nextVariance[i] = varianceSum / (weightSum * weightSum);
+            }
+        };
+        if (jobs && jobs->IsInitialized()) {
+            jobs->ParallelFor(texels.size(), 1024, filter);
+        } else {
+            filter(0, texels.size());
+        }
+        color.swap(nextColor);
+        variance.swap(nextVariance);
+    }
+}
+
+// Grows covered texels outwards by one ring per iteration, each new texel the mean of its
+// covered neighbours
+void Dilate(std::vector<XMFLOAT3>& image, std::vector<uint8_t>& covered, int size, int iterations) {
+    std::vector<uint32_t> filled;
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        filled.clear();
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                const uint32_t pixel = y * size + x;
+                if (covered[pixel]) continue;
+                XMFLOAT3 sum(0.0f, 0.0f, 0.0f);
+                int count = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        const int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= size || ny >= size || !covered[ny * size + nx]) continue;
+                        sum = Add(sum, image[ny * size + nx]);
+                        ++count;
+                    }
+                }
+                if (count == 0) continue;
+                image[pixel] = Scale(sum, 1.0f / count);
+                filled.push_back(pixel);
+            }
+        }
+        if (filled.empty()) break;
+        for (uint32_t pixel : filled) covered[pixel] = 1;
+    }
+}
+
+bool WriteAtlas(const std::string& filename, const std::vector<XMFLOAT3>& image, int size, int quality,
+                JobSystem* jobs) {
+    std::vector<uint16_t> halves(static_cast<size_t>(size) * size * 4);
+    for (size_t i = 0; i < image.size(); ++i) {
+        halves[i * 4 + 0] = PackedVector::XMConvertFloatToHalf(image[i].x);
+        halves[i * 4 + 1] = PackedVector::XMConvertFloatToHalf(image[i].y);
+        halves[i * 4 + 2] = PackedVector::XMConvertFloatToHalf(image[i].z);
+        halves[i * 4 + 3] = PackedVector::XMConvertFloatToHalf(1.0f);
+    }
+    std::vector<uint8_t> blocks(BlockCompressor::GetCompressedSize(BlockCompressor::Format::BC7, size, size));
+    if (!BlockCompressor::CompressBC6H(halves.data(), static_cast<size_t>(size) * 8, size, size, blocks.data(),
+                                      blocks.size(), quality, jobs)) {
+        return false;
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = size;
+    desc.Height = size;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_BC6H_UF16;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    const D3D11_SUBRESOURCE_DATA subresource = { blocks.data(), static_cast<UINT>(size / 4 * 16), 0 };
+    return TextureFile::WriteDDS(filename, desc, &subresource);
+}
+
+} // namespace
+
+bool LightmapBaker::ReadLights(const std::string& filename, std::vector<Light>& lights) {
+    std::ifstream file(filename);
+    if (!file) {
+        Logger::Error("Cannot open placement list: " + filename);
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        std::istringstream fields(line);
+        std::string keyword, type;
+        if (!(fields >> keyword) || keyword != "light") continue;
+
+        XMFLOAT3 position(0.0f, 0.0f, 0.0f), direction(0.0f, -1.0f, 0.0f), color(1.0f, 1.0f, 1.0f);
+        float intensity = 1.0f, range = 0.0f, cone = 45.0f;
+        bool valid = false;
+        Light light;
+        if (fields >> type) {
+            if (type == "directional") {
+                light.SetType(LightType::Directional);
+                valid = static_cast<bool>(fields >> direction.x >> direction.y >> direction.z
+                                                 >> color.x >> color.y >> color.z >> intensity);
+            } else if (type == "point") {
+                light.SetType(LightType::Point);
+                valid = static_cast<bool>(fields >> position.x >> position.y >> position.z
+                                                 >> color.x >> color.y >> color.z >> intensity >> range);
+            } else if (type == "spot") {
+                light.SetType(LightType::Spot);
+                valid = static_cast<bool>(fields >> position.x >> position.y >> position.z
+                                                 >> direction.x >> direction.y >> direction.z
+                                                 >> color.x >> color.y >> color.z >> intensity >> range >> cone);
+            }
+        }
+        if (!valid) {
+            Logger::Error("Malformed light at " + filename + ":" + std::to_string(lineNumber));
+            return false;
+        }
+        light.SetPosition(position);
+        light.SetDirection(direction);
+        light.SetColor(color);
+        light.SetIntensity(intensity);
+        light.SetRange(range);
+        light.SetConeAngle(XMConvertToRadians(cone));
+        lights.push_back(light);
+    }
+    return true;
+}
+
+bool LightmapBaker::Bake(const std::vector<HlodBuilder::Placement>& placements, const std::vector<const Light*>& lights,
+                         const std::string& outputDirectory, const Settings& requested, JobSystem* jobs, Stats* stats,
+                         const ProgressFunction& progress) {
+    NEXUS_PROFILE_SCOPE("LightmapBaker::Bake");
+    namespace fs = std::filesystem;
+
+    Settings settings = requested;
+    settings.texelsPerUnit = std::max(settings.texelsPerUnit, 1e-3f);
+    // Block compression needs whole 4x4 blocks
+    settings.atlasSize = (std::clamp(settings.atlasSize, 64, 8192) + 3) & ~3;
+    settings.padding = std::clamp(settings.padding, 1, 16);
+    settings.chartAngle = std::clamp(settings.chartAngle, 1.0f, 89.0f);
+    settings.samples = std::max(settings.samples, 1u);
+    settings.samplesPerPass = std::clamp(settings.samplesPerPass, 1u, settings.samples);
+    settings.bounces = std::clamp(settings.bounces, 1u, 16u);
+    settings.albedo = std::clamp(settings.albedo, 0.0f, 0.99f);
+    settings.maxDistance = std::max(settings.maxDistance, 1.0f);
+    settings.denoiseIterations = std::min(settings.denoiseIterations, 5u);
+    Stats result;
+
+    std::error_code error;
+    fs::create_directories(outputDirectory, error);
+    const fs::path output(outputDirectory);
+
+    // Every distinct source once
+    std::map<std::string, MeshData> meshes;
+    std::vector<const MeshData*> placementMeshes(placements.size(), nullptr);
+    for (size_t i = 0; i < placements.size(); ++i) {
+        auto it = meshes.find(placements[i].mesh);
+        if (it == meshes.end()) {
+            MeshData mesh;
+            if (!MeshImporter::Import(placements[i].mesh, mesh) || mesh.indices.empty()) {
+                Logger::Warning("Lightmap baking skips unreadable mesh: " + placements[i].mesh);
+                mesh = MeshData();
+            }
+            it = meshes.emplace(placements[i].mesh, std::move(mesh)).first;
+        }
+        if (!it->second.indices.empty()) placementMeshes[i] = &it->second;
+    }
+
+    // World-space triangles, each placement's in one range
+    std::vector<Triangle> triangles;
+    std::vector<uint32_t> instancePlacements;
+    std::vector<uint32_t> instanceStarts;
+    for (uint32_t i = 0; i < placements.size(); ++i) {
+        if (!placementMeshes[i]) continue;
+        const MeshData& mesh = *placementMeshes[i];
+        const XMMATRIX world = GetWorldMatrix(placements[i]);
+        const XMMATRIX normalMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, world));
+        const uint32_t start = static_cast<uint32_t>(triangles.size());
+        for (size_t index = 0; index + 2 < mesh.indices.size(); index += 3) {
+            Triangle triangle;
+            XMFLOAT3 normalSum(0.0f, 0.0f, 0.0f);
+            for (int c = 0; c < 3; ++c) {
+                triangle.vertex[c] = mesh.indices[index + c];
+                const Vertex& vertex = mesh.vertices[triangle.vertex[c]];
+                XMStoreFloat3(&triangle.position[c], XMVector3TransformCoord(XMLoadFloat3(&vertex.position), world));
+                XMStoreFloat3(&triangle.normal[c],
+                              XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.normal), normalMatrix)));
+                normalSum = Add(normalSum, triangle.normal[c]);
+            }
+            const XMFLOAT3 cross = Cross(Subtract(triangle.position[1], triangle.position[0]),
+                                         Subtract(triangle.position[2], triangle.position[0]));
+            const float length = std::sqrt(Dot(cross, cross));
+            if (length < 1e-10f) continue;
+            triangle.area = length * 0.5f;
+            // Whichever winding the source uses, the face normal sides with its vertex normals
+            triangle.faceNormal = Scale(cross, (Dot(cross, normalSum) < 0.0f ? -1.0f : 1.0f) / length);
+            triangle.chart = UINT32_MAX;
+            triangles.push_back(triangle);
+        }
+        if (triangles.size() > start) {
+            instancePlacements.push_back(i);
+            instanceStarts.push_back(start);
+        }
+    }
+    instanceStarts.push_back(static_cast<uint32_t>(triangles.size()));
+    if (triangles.empty()) {
+        Logger::Error("No geometry to bake lightmaps for");
+        return false;
+    }
+    result.instances = static_cast<uint32_t>(instancePlacements.size());
+
+    // The scene for tracing, wound so cross(v1 - v0, v2 - v0) is the front face
+    std::vector<XMFLOAT3> scenePositions;
+    scenePositions.reserve(triangles.size() * 3);
+    for (const Triangle& triangle : triangles) {
+        const XMFLOAT3 cross = Cross(Subtract(triangle.position[1], triangle.position[0]),
+                                     Subtract(triangle.position[2], triangle.position[0]));
+        const bool flip = Dot(cross, triangle.faceNormal) < 0.0f;
+        scenePositions.push_back(triangle.position[0]);
+        scenePositions.push_back(triangle.position[flip ? 2 : 1]);
+        scenePositions.push_back(triangle.position[flip ? 1 : 2]);
+    }
+    std::vector<uint32_t> sceneIndices(scenePositions.size());
+    for (uint32_t i = 0; i < sceneIndices.size(); ++i) sceneIndices[i] = i;
+    TriangleMeshCollider scene;
+    if (!scene.Build(scenePositions.data(), scenePositions.size(), sceneIndices.data(), sceneIndices.size())) {
+        Logger::Error("Failed to build the lightmap scene hierarchy");
+        return false;
+    }
+    const AABB& bounds = scene.GetBounds();
+    const XMFLOAT3 extent = Subtract(bounds.max, bounds.min);
+    const float bias = std::max(1e-3f, std::sqrt(Dot(extent, extent)) * 1e-5f);
+
+    // Charts, packed at the highest density that fits
+    std::vector<Chart> charts;
+    const float cosAngle = std::cos(XMConvertToRadians(settings.chartAngle));
+    for (uint32_t instance = 0; instance < instancePlacements.size(); ++instance) {
+        BuildCharts(triangles, instanceStarts[instance], instanceStarts[instance + 1], instance, cosAngle, charts);
+    }
+    std::vector<uint32_t> order(charts.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return charts[a].max.y - charts[a].min.y > charts[b].max.y - charts[b].min.y;
+    });
+    float density = settings.texelsPerUnit;
+    bool packed = false;
+    for (int attempt = 0; attempt < 64 && !packed; ++attempt) {
+        packed = PackCharts(charts, order, density, settings.atlasSize, settings.padding);
+        if (!packed) density *= 0.9f;
+    }
+    if (!packed) {
+        Logger::Error("Lightmap charts do not fit a " + std::to_string(settings.atlasSize) + " atlas");
+        return false;
+    }
+    if (density < settings.texelsPerUnit) {
+        Logger::Warning("Lightmap density lowered to " + std::to_string(density) + " texels per unit to fit the atlas");
+    }
+    result.charts = static_cast<uint32_t>(charts.size());
+    result.texelsPerUnit = density;
+
+    const int atlasSize = settings.atlasSize;
+    const size_t pixelCount = static_cast<size_t>(atlasSize) * atlasSize;
+    std::vector<int32_t> texelOf(pixelCount, -1);
+    std::vector<Texel> texels;
+    {
+        std::vector<float> distanceOf(pixelCount, FLT_MAX);
+        for (uint32_t chart = 0; chart < charts.size(); ++chart) {
+            RasterizeChart(charts, chart, triangles, density, settings.padding, atlasSize, texelOf, distanceOf, texels);
+        }
+    }
+
+    // Tile by tile, so one job traces neighbouring texels whose rays walk the same nodes
+    const int tilesWide = (atlasSize + TILE_SIZE - 1) / TILE_SIZE;
+    auto tileOf = [&](uint32_t pixel) {
+        return (pixel / atlasSize / TILE_SIZE) * tilesWide + (pixel % atlasSize) / TILE_SIZE;
+    };
+    std::sort(texels.begin(), texels.end(), [&](const Texel& a, const Texel& b) {
+        const uint32_t tileA = tileOf(a.pixel), tileB = tileOf(b.pixel);
+        return tileA != tileB ? tileA < tileB : a.pixel < b.pixel;
+    });
+    std::vector<uint32_t> tileStarts;
+    for (uint32_t i = 0; i < texels.size(); ++i) {
+        texelOf[texels[i].pixel] = static_cast<int32_t>(i);
+        if (i == 0 || tileOf(texels[i].pixel) != tileOf(texels[i - 1].pixel)) tileStarts.push_back(i);
+    }
+    tileStarts.push_back(static_cast<uint32_t>(texels.size()));
+    const size_t tileCount = tileStarts.size() - 1;
+    result.texels = texels.size();
+
+    // fn(first, end) over the texels of every tile, a packet's worth at a time
+    const uint32_t LANES = TriangleMeshCollider::PACKET_SIZE;
+    auto forEachPacket = [&](const std::function<void(uint32_t first, uint32_t count)>& fn) {
+        auto run = [&](size_t begin, size_t end) {
+            for (size_t tile = begin; tile < end; ++tile) {
+                for (uint32_t i = tileStarts[tile]; i < tileStarts[tile + 1]; i += LANES) {
+                    fn(i, std::min(LANES, tileStarts[tile + 1] - i));
+                }
+            }
+        };
+        if (jobs && jobs->IsInitialized() && tileCount > 1) {
+            jobs->ParallelFor(tileCount, 1, run);
+        } else {
+            run(0, tileCount);
+        }
+    };
+
+    const PathTracer tracer = { scene, lights, settings, bias };
+    std::vector<XMFLOAT3> direct(texels.size(), XMFLOAT3(0.0f, 0.0f, 0.0f));
+    if (settings.includeDirect && !lights.empty()) {
+        forEachPacket([&](uint32_t first, uint32_t count) {
+            XMFLOAT3 points[LANES] = {}, normals[LANES] = {}, irradiance[LANES];
+            for (uint32_t lane = 0; lane < count; ++lane) {
+                const Texel& texel = texels[first + lane];
+                points[lane] = Add(texel.position, Scale(texel.faceNormal, bias));
+                normals[lane] = texel.normal;
+            }
+            tracer.DirectLight(points, normals, (1u << count) - 1, irradiance);
+            for (uint32_t lane = 0; lane < count; ++lane) direct[first + lane] = irradiance[lane];
+        });
+    }
+
+    // Progressive refinement: every pass adds samplesPerPass paths to every texel
+    std::vector<Accumulator> accumulators(texels.size());
+    const UINT passes = (settings.samples + settings.samplesPerPass - 1) / settings.samplesPerPass;
+    for (UINT pass = 0; pass < passes; ++pass) {
+        const UINT firstSample = pass * settings.samplesPerPass;
+        const UINT sampleCount = std::min(settings.samplesPerPass, settings.samples - firstSample);
+        forEachPacket([&](uint32_t first, uint32_t count) {
+            const Texel* packet[LANES];
+            for (uint32_t lane = 0; lane < count; ++lane) packet[lane] = &texels[first + lane];
+            XMFLOAT3 radiance[LANES];
+            for (UINT sample = firstSample; sample < firstSample + sampleCount; ++sample) {
+                tracer.TracePaths(packet, count, sample, settings.samples, radiance);
+                for (uint32_t lane = 0; lane < count; ++lane) {
+                    Accumulator& accumulator = accumulators[first + lane];
+                    const float luminance = Luminance(radiance[lane]);
+                    accumulator.sum = Add(accumulator.sum, radiance[lane]);
+                    accumulator.luminance += luminance;
+                    accumulator.luminanceSq += luminance * luminance;
+                    accumulator.count++;
+                }
+            }
+        });
+        result.paths += static_cast<uint64_t>(texels.size()) * sampleCount;
+        if (progress && !progress(pass + 1, passes)) {
+            Logger::Info("Lightmap bake stopped after pass " + std::to_string(pass + 1) + " of " + std::to_string(passes));
+            break;
+        }
+    }
+
+    // The mean of cosine-distributed radiance is irradiance over pi; its variance steers the filter
+    std::vector<XMFLOAT3> indirect(texels.size());
+    std::vector<float> variance(texels.size());
+    for (size_t i = 0; i < texels.size(); ++i) {
+        const Accumulator& accumulator = accumulators[i];
+        const float count = static_cast<float>(std::max(accumulator.count, 1u));
+        const float mean = accumulator.luminance / count;
+        indirect[i] = Scale(accumulator.sum, 1.0f / count);
+        variance[i] = std::max(0.0f, accumulator.luminanceSq / count - mean * mean) / count;
+    }
+    Denoise(texels, texelOf, atlasSize, density, settings.denoiseIterations, indirect, variance, jobs);
+
+    std::vector<XMFLOAT3> image(pixelCount, XMFLOAT3(0.0f, 0.0f, 0.0f));
+    std::vector<uint8_t> covered(pixelCount, 0);
+    for (size_t i = 0; i < texels.size(); ++i) {
+        image[texels[i].pixel] = Add(indirect[i], Scale(direct[i], 1.0f / XM_PI));
+        covered[texels[i].pixel] = 1;
+    }
+    Dilate(image, covered, atlasSize, settings.padding);
+    if (!WriteAtlas((output / ATLAS_FILE).string(), image, atlasSize, settings.quality, jobs)) {
+        Logger::Error("Failed to write lightmap atlas in " + outputDirectory);
+        return false;
+    }
+
+    std::ofstream index((output / INDEX_FILE).string());
+    if (!index) {
+        Logger::Error("Cannot write lightmap index in " + outputDirectory);
+        return false;
+    }
+    index << "lightmap 1\n";
+    index << "atlas " << ATLAS_FILE << "\n";
+
+    // Each placement's mesh with its vertices split per chart, in object space
+    for (uint32_t instance = 0; instance < instancePlacements.size(); ++instance) {
+        const uint32_t placement = instancePlacements[instance];
+        const MeshData& source = *placementMeshes[placement];
+        std::unordered_map<uint64_t, uint32_t> remap;
+        MeshData mesh;
+        std::vector<XMFLOAT2> coordinates;
+        for (uint32_t t = instanceStarts[instance]; t < instanceStarts[instance + 1]; ++t) {
+            const Triangle& triangle = triangles[t];
+            const Chart& chart = charts[triangle.chart];
+            for (int c = 0; c < 3; ++c) {
+                const uint64_t key = (static_cast<uint64_t>(triangle.chart) << 32) | triangle.vertex[c];
+                auto [it, added] = remap.emplace(key, static_cast<uint32_t>(mesh.vertices.size()));
+                if (added) {
+                    mesh.vertices.push_back(source.vertices[triangle.vertex[c]]);
+                    const XMFLOAT2 texel = ChartTexel(chart, triangle.position[c], density, settings.padding);
+                    coordinates.push_back(XMFLOAT2(texel.x / atlasSize, texel.y / atlasSize));
+                }
+                mesh.indices.push_back(it->second);
+            }
+        }
+        // Vertex order has to stay in step with the coordinates, so only the indices are reordered
+        MeshImporter::OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+        MeshImporter::ComputeBounds(mesh);
+
+        const std::string name = "lightmap_" + std::to_string(placement);
+        if (!MeshImporter::WriteBinary((output / (name + ".nmesh")).string(), mesh) ||
+            !WriteCoordinates((output / (name + ".nluv")).string(), coordinates)) {
+            Logger::Error("Failed to write lightmapped mesh " + name);
+            return false;
+        }
+        index << "instance " << placement << " " << name << ".nmesh " << name << ".nluv\n";
+    }
+
+    Logger::Info("Baked lightmaps for " + std::to_string(result.instances) + " placements: " +
+                 std::to_string(result.charts) + " charts, " + std::to_string(result.texels) + " texels, " +
+                 std::to_string(result.paths) + " paths");
+    if (stats) *stats = result;
+    return true;
+}
+
+bool LightmapBaker::WriteCoordinates(const std::string& filename, const std::vector<XMFLOAT2>& coordinates) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) return false;
+    const uint32_t header[3] = { COORDINATES_MAGIC, COORDINATES_VERSION, static_cast<uint32_t>(coordinates.size()) };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(coordinates.data()), coordinates.size() * sizeof(XMFLOAT2));
+    return static_cast<bool>(file);
+}
+
+bool LightmapBaker::ReadCoordinates(const std::string& filename, std::vector<XMFLOAT2>& coordinates) {
+    std::ifstream file(filename, std::ios::binary);
+    uint32_t header[3] = {};
+    if (!file || !file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != COORDINATES_MAGIC ||
+        header[1] != COORDINATES_VERSION) {
+        Logger::Error("Not a lightmap coordinate file: " + filename);
+        return false;
+    }
+    coordinates.resize(header[2]);
+    if (!file.read(reinterpret_cast<char*>(coordinates.data()), coordinates.size() * sizeof(XMFLOAT2))) {
+        Logger::Error("Truncated lightmap coordinate file: " + filename);
+        return false;
+    }
+    return true;
+}
+
+bool LightmapIndex::Load(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string keyword;
+    int version = 0;
+    if (!file || !(file >> keyword >> version) || keyword != "lightmap" || version != 1) {
+        Logger::Error("Not a lightmap index: " + filename);
+        return false;
+    }
+
+    atlas_.clear();
+    instances_.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        if (!(fields >> keyword)) continue;
+        if (keyword == "atlas") {
+            fields >> atlas_;
+        } else if (keyword == "instance") {
+            Instance instance;
+            if (fields >> instance.placement >> instance.mesh >> instance.coordinates) {
+                instances_.push_back(instance);
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace Nexus
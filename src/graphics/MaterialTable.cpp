@@ -0,0 +1,419 @@
+#include "MaterialTable.h"
+#include "Texture.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "StateCache.h"
+#include <algorithm>
+
+namespace Nexus {
+
+namespace {
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+// Batch keys hold one 16-bit field per texture kind: 0 for no map, otherwise the array index + 1
+constexpr UINT BATCH_FIELD_BITS = 16;
+constexpr UINT MAX_ARRAYS = (1u << BATCH_FIELD_BITS) - 1;
+
+const char* MATERIAL_HLSL = R"(
+struct MaterialData
+{
+    float4 AmbientColor;
+    float4 DiffuseColor;
+    float4 SpecularColor;
+    float4 EmissiveColor;
+    uint4 Slices;            // Diffuse, normal, specular, emissive
+    float SpecularPower;
+    uint TextureMask;
+    float2 MaterialPadding;
+};
+
+Texture2DArray MaterialDiffuseMaps : register(t0);
+Texture2DArray MaterialNormalMaps : register(t1);
+Texture2DArray MaterialSpecularMaps : register(t2);
+Texture2DArray MaterialEmissiveMaps : register(t3);
+StructuredBuffer<MaterialData> Materials : register(t4);
+
+float4 SampleMaterialDiffuse(MaterialData material, SamplerState state, float2 uv)
+{
+    float4 color = material.DiffuseColor;
+    if (material.TextureMask & 1) color *= MaterialDiffuseMaps.Sample(state, float3(uv, material.Slices.x));
+    return color;
+}
+
+// Tangent-space normal, (0, 0, 1) without a normal map
+float3 SampleMaterialNormal(MaterialData material, SamplerState state, float2 uv)
+{
+    if (!(material.TextureMask & 2)) return float3(0.0f, 0.0f, 1.0f);
+    float2 xy = MaterialNormalMaps.Sample(state, float3(uv, material.Slices.y)).xy * 2.0f - 1.0f;
+    return float3(xy, sqrt(saturate(1.0f - dot(xy, xy))));
+}
+
+float4 SampleMaterialSpecular(MaterialData material, SamplerState state, float2 uv)
+{
+    float4 color = material.SpecularColor;
+    if (material.TextureMask & 4) color *= MaterialSpecularMaps.Sample(state, float3(uv, material.Slices.z));
+    return color;
+}
+
+float4 SampleMaterialEmissive(MaterialData material, SamplerState state, float2 uv)
+{
+    float4 color = material.EmissiveColor;
+    if (material.TextureMask & 8) color *= MaterialEmissiveMaps.Sample(state, float3(uv, material.Slices.w));
+    return color;
+}
+)";
+
+// Borrowed from the material, so no reference count is touched per map
+Texture* GetMap(const Material& material, UINT kind) {
+    switch (kind) {
+    case 0: return material.GetDiffuseTexture().get();
+    case 1: return material.GetNormalTexture().get();
+    case 2: return material.GetSpecularTexture().get();
+    default: return material.GetEmissiveTexture().get();
+    }
+}
+
+} // namespace
+
+MaterialTable::MaterialTable()
+    : device_(nullptr)
+    , context_(nullptr)
+    , materialBuffer_(nullptr)
+    , materialView_(nullptr)
+    , bufferCapacity_(0)
+    , dirtyBegin_(0)
+    , dirtyEnd_(0)
+{
+}
+
+MaterialTable::~MaterialTable() {
+    Shutdown();
+}
+
+bool MaterialTable::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings) {
+    if (!device || !context) return false;
+    device_ = device;
+    context_ = context;
+    settings_ = settings;
+    settings_.initialMaterials = std::max(settings_.initialMaterials, 1u);
+    settings_.initialArraySlices = std::max(settings_.initialArraySlices, 1u);
+    return EnsureBufferCapacity(settings_.initialMaterials);
+}
+
+void MaterialTable::Shutdown() {
+    // Materials outliving the table must not call back into it
+    for (Entry& entry : entries_) {
+        if (entry.material) {
+            entry.material->table_ = nullptr;
+            entry.material->materialId_ = INVALID_MATERIAL;
+        }
+    }
+    entries_.clear();
+    gpuMaterials_.clear();
+    freeIds_.clear();
+    for (auto& packed : packed_) {
+        packed.first->Release();
+    }
+    packed_.clear();
+    for (TextureArray& array : arrays_) {
+        SafeRelease(array.view);
+        SafeRelease(array.texture);
+    }
+    arrays_.clear();
+    SafeRelease(materialView_);
+    SafeRelease(materialBuffer_);
+    bufferCapacity_ = 0;
+    dirtyBegin_ = dirtyEnd_ = 0;
+    stats_ = Stats();
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+UINT MaterialTable::Register(Material& material) {
+    if (!device_) return INVALID_MATERIAL;
+    if (material.table_ == this) {
+        Update(material);
+        return material.materialId_;
+    }
+    if (material.table_) {
+        material.table_->Remove(material);
+    }
+
+    UINT id;
+    if (!freeIds_.empty()) {
+        id = freeIds_.back();
+        freeIds_.pop_back();
+    } else {
+        id = static_cast<UINT>(entries_.size());
+        entries_.emplace_back();
+        gpuMaterials_.emplace_back();
+    }
+    entries_[id].material = &material;
+    material.table_ = this;
+    material.materialId_ = id;
+    stats_.materials++;
+
+    Pack(id);
+    return id;
+}
+
+void MaterialTable::Update(Material& material) {
+    if (material.table_ != this) return;
+    UINT id = material.materialId_;
+    Unpack(id);
+    Pack(id);
+}
+
+void MaterialTable::Remove(Material& material) {
+    if (material.table_ != this) return;
+    UINT id = material.materialId_;
+    Unpack(id);
+    entries_[id] = Entry();
+    freeIds_.push_back(id);
+    material.table_ = nullptr;
+    material.materialId_ = INVALID_MATERIAL;
+    stats_.materials--;
+}
+
+void MaterialTable::Pack(UINT id) {
+    Entry& entry = entries_[id];
+    const Material& material = *entry.material;
+
+    GpuMaterial& gpu = gpuMaterials_[id];
+    gpu = GpuMaterial();
+    gpu.ambientColor = material.GetAmbientColor();
+    gpu.diffuseColor = material.GetDiffuseColor();
+    gpu.specularColor = material.GetSpecularColor();
+    gpu.emissiveColor = material.GetEmissiveColor();
+    gpu.specularPower = material.GetSpecularPower();
+
+    BatchKey batch = 0;
+    bool batchable = true;
+    for (UINT kind = 0; kind < TEXTURE_KINDS; ++kind) {
+        Texture* map = GetMap(material, kind);
+        if (!map) continue;
+        // Streamed textures reallocate as mips arrive, so there is nothing stable to copy
+        ID3D11Texture2D* source = map->GetTexture();
+        PackedTexture packed;
+        if (!source || !Acquire(source, packed)) {
+            batchable = false;
+            continue;
+        }
+        entry.textures[kind] = source;
+        gpu.slices[kind] = packed.slice;
+        gpu.textureMask |= 1u << kind;
+        batch |= static_cast<BatchKey>(packed.array + 1) << (kind * BATCH_FIELD_BITS);
+    }
+    entry.batch = batchable ? batch : NO_BATCH;
+    MarkDirty(id);
+}
+
+void MaterialTable::Unpack(UINT id) {
+    Entry& entry = entries_[id];
+    for (ID3D11Texture2D*& texture : entry.textures) {
+        if (texture) {
+            ReleaseTexture(texture);
+            texture = nullptr;
+        }
+    }
+    entry.batch = NO_BATCH;
+}
+
+bool MaterialTable::Acquire(ID3D11Texture2D* texture, PackedTexture& packed) {
+    auto existing = packed_.find(texture);
+    if (existing != packed_.end()) {
+        existing->second.references++;
+        packed = existing->second;
+        return true;
+    }
+
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+    if (desc.ArraySize != 1 || desc.SampleDesc.Count != 1) return false;
+    ArrayKey key = { desc.Width, desc.Height, desc.Format, desc.MipLevels };
+
+    auto found = std::find_if(arrays_.begin(), arrays_.end(), [&](const TextureArray& array) { return array.key == key; });
+    if (found == arrays_.end()) {
+        if (arrays_.size() >= MAX_ARRAYS) return false;
+        TextureArray array;
+        array.key = key;
+        if (!GrowArray(array, settings_.initialArraySlices)) return false;
+        arrays_.push_back(array);
+        found = arrays_.end() - 1;
+        stats_.arrays++;
+    }
+
+    TextureArray& array = *found;
+    UINT slice;
+    if (!array.freeSlices.empty()) {
+        slice = array.freeSlices.back();
+        array.freeSlices.pop_back();
+    } else {
+        if (array.used == array.capacity) {
+            UINT capacity = std::min(array.capacity * 2, static_cast<UINT>(D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION));
+            if (capacity == array.capacity || !GrowArray(array, capacity)) {
+                Logger::Warning("Material texture array is full, material stays unbatched");
+                return false;
+            }
+        }
+        slice = array.used++;
+    }
+
+    for (UINT mip = 0; mip < key.mipLevels; ++mip) {
+        context_->CopySubresourceRegion(array.texture, D3D11CalcSubresource(mip, slice, key.mipLevels), 0, 0, 0,
+                                        texture, D3D11CalcSubresource(mip, 0, key.mipLevels), nullptr);
+    }
+
+    // Held until the last material using it lets go, so the pointer key cannot be reused
+    texture->AddRef();
+    packed.array = static_cast<uint16_t>(found - arrays_.begin());
+    packed.slice = slice;
+    packed.references = 1;
+    packed_[texture] = packed;
+    stats_.packedTextures++;
+    return true;
+}
+
+void MaterialTable::ReleaseTexture(ID3D11Texture2D* texture) {
+    auto found = packed_.find(texture);
+    if (found == packed_.end() || --found->second.references > 0) return;
+    arrays_[found->second.array].freeSlices.push_back(found->second.slice);
+    packed_.erase(found);
+    texture->Release();
+    stats_.packedTextures--;
+}
+
+bool MaterialTable::GrowArray(TextureArray& array, UINT capacity) {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = array.key.width;
+    desc.Height = array.key.height;
+    desc.MipLevels = array.key.mipLevels;
+    desc.ArraySize = capacity;
+    desc.Format = array.key.format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    ID3D11Texture2D* texture = nullptr;
+    ID3D11ShaderResourceView* view = nullptr;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &texture))) {
+        Logger::Error("Failed to create material texture array");
+        return false;
+    }
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = desc.Format;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    viewDesc.Texture2DArray.MipLevels = desc.MipLevels;
+    viewDesc.Texture2DArray.ArraySize = capacity;
+    if (FAILED(device_->CreateShaderResourceView(texture, &viewDesc, &view))) {
+        texture->Release();
+        Logger::Error("Failed to create material texture array view");
+        return false;
+    }
+
+    // Slices already handed out move to the larger array
+    for (UINT slice = 0; slice < array.used; ++slice) {
+        for (UINT mip = 0; mip < desc.MipLevels; ++mip) {
+            context_->CopySubresourceRegion(texture, D3D11CalcSubresource(mip, slice, desc.MipLevels), 0, 0, 0,
+                                            array.texture, D3D11CalcSubresource(mip, slice, desc.MipLevels), nullptr);
+        }
+    }
+    SafeRelease(array.view);
+    SafeRelease(array.texture);
+    array.texture = texture;
+    array.view = view;
+    array.capacity = capacity;
+    return true;
+}
+
+bool MaterialTable::EnsureBufferCapacity(UINT materials) {
+    if (materials <= bufferCapacity_) return true;
+    UINT capacity = std::max(bufferCapacity_ * 2, materials);
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth = capacity * sizeof(GpuMaterial);
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    desc.StructureByteStride = sizeof(GpuMaterial);
+    ID3D11Buffer* buffer = nullptr;
+    ID3D11ShaderResourceView* view = nullptr;
+    if (FAILED(device_->CreateBuffer(&desc, nullptr, &buffer))) {
+        Logger::Error("Failed to create material buffer");
+        return false;
+    }
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    viewDesc.Buffer.NumElements = capacity;
+    if (FAILED(device_->CreateShaderResourceView(buffer, &viewDesc, &view))) {
+        buffer->Release();
+        Logger::Error("Failed to create material buffer view");
+        return false;
+    }
+
+    SafeRelease(materialView_);
+    SafeRelease(materialBuffer_);
+    materialBuffer_ = buffer;
+    materialView_ = view;
+    bufferCapacity_ = capacity;
+
+    // The new buffer starts empty, so everything registered goes up again
+    dirtyBegin_ = 0;
+    dirtyEnd_ = static_cast<UINT>(gpuMaterials_.size());
+    return true;
+}
+
+void MaterialTable::MarkDirty(UINT id) {
+    if (dirtyBegin_ == dirtyEnd_) {
+        dirtyBegin_ = id;
+        dirtyEnd_ = id + 1;
+    } else {
+        dirtyBegin_ = std::min(dirtyBegin_, id);
+        dirtyEnd_ = std::max(dirtyEnd_, id + 1);
+    }
+}
+
+void MaterialTable::Upload() {
+    stats_.uploads = 0;
+    if (!device_ || gpuMaterials_.empty()) return;
+    NEXUS_PROFILE_SCOPE("MaterialTable::Upload");
+    if (!EnsureBufferCapacity(static_cast<UINT>(gpuMaterials_.size()))) return;
+    if (dirtyBegin_ == dirtyEnd_) return;
+
+    // One copy of the contiguous range spanning every change since the last upload
+    D3D11_BOX box = {};
+    box.left = dirtyBegin_ * sizeof(GpuMaterial);
+    box.right = dirtyEnd_ * sizeof(GpuMaterial);
+    box.bottom = 1;
+    box.back = 1;
+    context_->UpdateSubresource(materialBuffer_, 0, &box, &gpuMaterials_[dirtyBegin_], 0, 0);
+    dirtyBegin_ = dirtyEnd_ = 0;
+    stats_.uploads = 1;
+}
+
+MaterialTable::BatchKey MaterialTable::GetBatchKey(UINT materialId) const {
+    return materialId < entries_.size() && entries_[materialId].material ? entries_[materialId].batch : NO_BATCH;
+}
+
+void MaterialTable::BindBatch(StateCache& stateCache, BatchKey key) const {
+    if (key == NO_BATCH) return;
+    ID3D11ShaderResourceView* views[TEXTURE_KINDS + 1] = {};
+    for (UINT kind = 0; kind < TEXTURE_KINDS; ++kind) {
+        UINT field = static_cast<UINT>((key >> (kind * BATCH_FIELD_BITS)) & MAX_ARRAYS);
+        views[kind] = field ? arrays_[field - 1].view : nullptr;
+    }
+    views[TEXTURE_KINDS] = materialView_;
+    stateCache.PSSetShaderResources(TEXTURE_SLOT, TEXTURE_KINDS + 1, views);
+    stateCache.VSSetShaderResources(MATERIAL_BUFFER_SLOT, 1, &materialView_);
+}
+
+const char* MaterialTable::GetShaderSource() {
+    return MATERIAL_HLSL;
+}
+
+} // namespace Nexus
@@ -1,116 +1,523 @@
 #include "Mesh.h"
+#include "MeshImporter.h"
 #include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 
 namespace Nexus {
 
 Mesh::Mesh()
     : vertexBuffer_(nullptr)
+    , vertexView_(nullptr)
     , indexBuffer_(nullptr)
+    , meshletBuffer_(nullptr)
+    , meshletView_(nullptr)
+    , indexView_(nullptr)
+    , lightmapBuffer_(nullptr)
     , vertexCount_(0)
     , indexCount_(0)
+    , indexFormat_(DXGI_FORMAT_R32_UINT)
+    , vertexFormat_(VertexFormat::Full)
+    , memoryUsage_(0)
+    , boundsMin_(0.0f, 0.0f, 0.0f)
+    , boundsMax_(0.0f, 0.0f, 0.0f)
 {
     worldMatrix_ = XMMatrixIdentity();
 }
 
 Mesh::~Mesh() {
+    ReleaseBuffers();
+}
+
+void Mesh::Swap(Mesh& other) {
+    std::swap(vertexBuffer_, other.vertexBuffer_);
+    std::swap(vertexView_, other.vertexView_);
+    std::swap(indexBuffer_, other.indexBuffer_);
+    std::swap(meshletBuffer_, other.meshletBuffer_);
+    std::swap(meshletView_, other.meshletView_);
+    std::swap(indexView_, other.indexView_);
+    std::swap(lightmapBuffer_, other.lightmapBuffer_);
+    std::swap(vertexCount_, other.vertexCount_);
+    std::swap(indexCount_, other.indexCount_);
+    std::swap(indexFormat_, other.indexFormat_);
+    std::swap(vertexFormat_, other.vertexFormat_);
+    std::swap(memoryUsage_, other.memoryUsage_);
+    std::swap(boundsMin_, other.boundsMin_);
+    std::swap(boundsMax_, other.boundsMax_);
+    lods_.swap(other.lods_);
+    meshlets_.swap(other.meshlets_);
+}
+
+void Mesh::ReleaseBuffers() {
+    if (lightmapBuffer_) {
+        lightmapBuffer_->Release();
+        lightmapBuffer_ = nullptr;
+    }
+    if (indexView_) {
+        indexView_->Release();
+        indexView_ = nullptr;
+    }
+    if (meshletView_) {
+        meshletView_->Release();
+        meshletView_ = nullptr;
+    }
+    if (meshletBuffer_) {
+        meshletBuffer_->Release();
+        meshletBuffer_ = nullptr;
+    }
     if (indexBuffer_) {
         indexBuffer_->Release();
         indexBuffer_ = nullptr;
     }
+    if (vertexView_) {
+        vertexView_->Release();
+        vertexView_ = nullptr;
+    }
     if (vertexBuffer_) {
         vertexBuffer_->Release();
         vertexBuffer_ = nullptr;
     }
+    vertexCount_ = 0;
+    indexCount_ = 0;
+    memoryUsage_ = 0;
+    lods_.clear();
+    meshlets_.clear();
 }
 
-bool Mesh::LoadFromFile(const std::string& filename, ID3D11Device* device) {
-    Logger::Info("Loading mesh from file: " + filename);
-    
-    // For now, create a simple cube as a placeholder
-    std::vector<Vertex> vertices = {
-        // Front face
-        {{-1.0f, -1.0f, -1.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
-        {{ 1.0f, -1.0f, -1.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
-        {{ 1.0f,  1.0f, -1.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-        {{-1.0f,  1.0f, -1.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-        
-        // Back face
-        {{ 1.0f, -1.0f,  1.0f}, {0.0f, 0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
-        {{-1.0f, -1.0f,  1.0f}, {0.0f, 0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
-        {{-1.0f,  1.0f,  1.0f}, {0.0f, 0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-        {{ 1.0f,  1.0f,  1.0f}, {0.0f, 0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}}
+const D3D11_INPUT_ELEMENT_DESC* Mesh::GetInputLayout(VertexFormat format, UINT& elementCount) {
+    static const D3D11_INPUT_ELEMENT_DESC fullLayout[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 36, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 1, DXGI_FORMAT_R32G32_FLOAT, 1, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
     };
-    
-    std::vector<unsigned int> indices = {
-        0, 1, 2, 0, 2, 3,  // Front
-        4, 5, 6, 4, 6, 7,  // Back
-        5, 0, 3, 5, 3, 6,  // Left
-        1, 4, 7, 1, 7, 2,  // Right
-        3, 2, 7, 3, 7, 6,  // Top
-        5, 4, 1, 5, 1, 0   // Bottom
+    // NORMAL carries both octahedral vectors; the shader decodes them with DecodeOctahedral
+    static const D3D11_INPUT_ELEMENT_DESC compressedLayout[] = {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 1, DXGI_FORMAT_R32G32_FLOAT, 1, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
     };
-    
-    return CreateFromVertices(vertices, indices, device);
+    // For skinning in the vertex shader; the usual path poses these in SkinningSystem first
+    static const D3D11_INPUT_ELEMENT_DESC skinnedLayout[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 36, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "BLENDINDICES", 0, DXGI_FORMAT_R16G16B16A16_UINT, 0, 44, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "BLENDWEIGHT", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 52, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    };
+
+    if (format == VertexFormat::Compressed) {
+        elementCount = ARRAYSIZE(compressedLayout);
+        return compressedLayout;
+    }
+    if (format == VertexFormat::Skinned) {
+        elementCount = ARRAYSIZE(skinnedLayout);
+        return skinnedLayout;
+    }
+    elementCount = ARRAYSIZE(fullLayout);
+    return fullLayout;
+}
+
+UINT Mesh::GetVertexStride(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Compressed: return sizeof(CompressedVertex);
+        case VertexFormat::Skinned: return sizeof(SkinnedVertex);
+        default: return sizeof(Vertex);
+    }
+}
+
+bool Mesh::LoadFromFile(const std::string& filename, ID3D11Device* device, VertexFormat format) {
+    NEXUS_PROFILE_SCOPE("Mesh::LoadFromFile");
+    Logger::Info("Loading mesh from file: " + filename);
+    if (format == VertexFormat::Skinned) {
+        // Importers and the .nmesh cache carry no bone weights yet
+        Logger::Error("Skinned meshes are created with CreateFromSkinnedVertices: " + filename);
+        return false;
+    }
+
+    std::string extension = std::filesystem::path(filename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == ".nmesh") {
+        return LoadBinary(filename, device);
+    }
+
+    if (MeshImporter::IsCacheCurrent(filename) && LoadBinary(MeshImporter::GetCachePath(filename), device) &&
+        vertexFormat_ == format) {
+        return true;
+    }
+
+    // No usable cache: import now and bake one for next time
+    MeshData mesh;
+    if (!MeshImporter::Import(filename, mesh)) {
+        Logger::Error("Failed to load mesh: " + filename);
+        return false;
+    }
+    MeshImporter::GenerateLods(mesh);
+    MeshImporter::Optimize(mesh);
+    MeshImporter::BuildMeshlets(mesh);
+    if (!MeshImporter::WriteBinary(MeshImporter::GetCachePath(filename), mesh, format)) {
+        Logger::Warning("Mesh cache not written, source will be imported again next load: " + filename);
+    }
+
+    return CreateFromVertices(mesh.vertices, mesh.indices, device, format, mesh.lods, mesh.meshlets);
+}
+
+bool Mesh::LoadBinary(const std::string& filename, ID3D11Device* device) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        Logger::Error("Could not open mesh file: " + filename);
+        return false;
+    }
+
+    // One read of the whole file; the buffers are created straight from it
+    std::streamsize size = file.tellg();
+    file.seekg(0);
+    std::vector<char> data(size > 0 ? static_cast<size_t>(size) : 0);
+    if (!file.read(data.data(), size)) {
+        Logger::Error("Could not read mesh file: " + filename);
+        return false;
+    }
+    return LoadBinary(reinterpret_cast<const uint8_t*>(data.data()), data.size(), filename, device);
+}
+
+bool Mesh::LoadBinary(const uint8_t* data, size_t size, const std::string& filename, ID3D11Device* device) {
+    if (size < sizeof(MeshFileHeader)) {
+        Logger::Error("Could not read mesh file: " + filename);
+        return false;
+    }
+
+    MeshFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    bool valid = header.magic == MeshFileHeader::MAGIC &&
+                 header.version == MeshFileHeader::VERSION &&
+                 header.vertexFormat <= static_cast<uint32_t>(VertexFormat::Compressed) &&
+                 header.vertexStride == GetVertexStride(static_cast<VertexFormat>(header.vertexFormat)) &&
+                 (header.indexSize == 2 || header.indexSize == 4) &&
+                 header.vertexOffset <= size &&
+                 header.indexOffset <= size &&
+                 header.lodOffset <= size &&
+                 header.meshletOffset <= size &&
+                 static_cast<uint64_t>(header.lodCount) * sizeof(MeshLod) <= size - header.lodOffset &&
+                 static_cast<uint64_t>(header.meshletCount) * sizeof(Meshlet) <= size - header.meshletOffset &&
+                 static_cast<uint64_t>(header.vertexCount) * header.vertexStride <= size - header.vertexOffset &&
+                 static_cast<uint64_t>(header.indexCount) * header.indexSize <= size - header.indexOffset;
+    if (!valid) {
+        Logger::Error("Invalid or outdated mesh file: " + filename);
+        return false;
+    }
+
+    std::vector<MeshLod> lods(header.lodCount);
+    if (!lods.empty()) {
+        std::memcpy(lods.data(), data + header.lodOffset, lods.size() * sizeof(MeshLod));
+    }
+    std::vector<Meshlet> meshlets(header.meshletCount);
+    if (!meshlets.empty()) {
+        std::memcpy(meshlets.data(), data + header.meshletOffset, meshlets.size() * sizeof(Meshlet));
+    }
+
+    if (!CreateBuffers(data + header.vertexOffset, header.vertexCount, static_cast<VertexFormat>(header.vertexFormat),
+                       data + header.indexOffset, header.indexCount,
+                       header.indexSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT,
+                       std::move(lods), std::move(meshlets), device)) {
+        return false;
+    }
+    boundsMin_ = header.boundsMin;
+    boundsMax_ = header.boundsMax;
+    return true;
 }
 
 bool Mesh::CreateFromVertices(const std::vector<Vertex>& vertices, 
                              const std::vector<unsigned int>& indices,
-                             ID3D11Device* device) {
-    if (!device) return false;
-    
-    vertexCount_ = static_cast<int>(vertices.size());
-    indexCount_ = static_cast<int>(indices.size());
+                             ID3D11Device* device,
+                             VertexFormat format,
+                             const std::vector<MeshLod>& lods,
+                             const std::vector<Meshlet>& meshlets) {
+    if (format == VertexFormat::Skinned) {
+        Logger::Error("Mesh::CreateFromVertices - Skinned meshes need CreateFromSkinnedVertices");
+        return false;
+    }
+
+    XMFLOAT3 boundsMin(0.0f, 0.0f, 0.0f), boundsMax(0.0f, 0.0f, 0.0f);
+    if (!vertices.empty()) {
+        boundsMin = boundsMax = vertices[0].position;
+        for (const Vertex& vertex : vertices) {
+            boundsMin = XMFLOAT3(std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y),
+                                 std::min(boundsMin.z, vertex.position.z));
+            boundsMax = XMFLOAT3(std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y),
+                                 std::max(boundsMax.z, vertex.position.z));
+        }
+    }
+
+    std::vector<CompressedVertex> compressed;
+    const void* vertexData = vertices.data();
+    if (format == VertexFormat::Compressed) {
+        MeshImporter::CompressVertices(vertices, boundsMin, boundsMax, compressed);
+        vertexData = compressed.data();
+    }
+
+    if (!CreateBuffers(vertexData, static_cast<UINT>(vertices.size()), format,
+                       indices.data(), static_cast<UINT>(indices.size()), DXGI_FORMAT_R32_UINT, lods, meshlets, device)) {
+        return false;
+    }
+    boundsMin_ = boundsMin;
+    boundsMax_ = boundsMax;
+    return true;
+}
+
+bool Mesh::CreateFromSkinnedVertices(const std::vector<SkinnedVertex>& vertices,
+                                     const std::vector<unsigned int>& indices,
+                                     ID3D11Device* device,
+                                     const std::vector<MeshLod>& lods,
+                                     const std::vector<Meshlet>& meshlets) {
+    // Bind pose bounds; posed vertices can leave them, so callers cull with the skeleton's
+    XMFLOAT3 boundsMin(0.0f, 0.0f, 0.0f), boundsMax(0.0f, 0.0f, 0.0f);
+    if (!vertices.empty()) {
+        boundsMin = boundsMax = vertices[0].position;
+        for (const SkinnedVertex& vertex : vertices) {
+            boundsMin = XMFLOAT3(std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y),
+                                 std::min(boundsMin.z, vertex.position.z));
+            boundsMax = XMFLOAT3(std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y),
+                                 std::max(boundsMax.z, vertex.position.z));
+        }
+    }
+
+    if (!CreateBuffers(vertices.data(), static_cast<UINT>(vertices.size()), VertexFormat::Skinned,
+                       indices.data(), static_cast<UINT>(indices.size()), DXGI_FORMAT_R32_UINT, lods, meshlets, device)) {
+        return false;
+    }
+    boundsMin_ = boundsMin;
+    boundsMax_ = boundsMax;
+    return true;
+}
+
+bool Mesh::CreateBuffers(const void* vertices, UINT vertexCount, VertexFormat format,
+                         const void* indices, UINT indexCount, DXGI_FORMAT indexFormat,
+                         std::vector<MeshLod> lods, std::vector<Meshlet> meshlets, ID3D11Device* device) {
+    if (!device || vertexCount == 0 || indexCount == 0) return false;
     
+    if (lods.empty()) {
+        lods.push_back({ 0, indexCount, 0.0f });
+    }
+    for (const MeshLod& lod : lods) {
+        if (lod.indexOffset > indexCount || lod.indexCount > indexCount - lod.indexOffset) {
+            Logger::Error("Mesh LOD range outside the index buffer");
+            return false;
+        }
+    }
+    for (const Meshlet& meshlet : meshlets) {
+        if (meshlet.triangleCount > Meshlet::MAX_TRIANGLES || meshlet.indexOffset > indexCount ||
+            meshlet.triangleCount * 3 > indexCount - meshlet.indexOffset) {
+            Logger::Error("Meshlet range outside the index buffer");
+            return false;
+        }
+    }
+
+    ReleaseBuffers();
+    const UINT indexSize = indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
+
     // Create vertex buffer
     D3D11_BUFFER_DESC vertexBufferDesc = {};
-    vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    vertexBufferDesc.ByteWidth = vertexCount_ * sizeof(Vertex);
+    vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    vertexBufferDesc.ByteWidth = vertexCount * GetVertexStride(format);
     vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vertexBufferDesc.CPUAccessFlags = 0;
+    if (format == VertexFormat::Skinned) {
+        // The skinning pass reads the vertices through a raw view
+        vertexBufferDesc.BindFlags |= D3D11_BIND_SHADER_RESOURCE;
+        vertexBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    }
     
     D3D11_SUBRESOURCE_DATA vertexData = {};
-    vertexData.pSysMem = vertices.data();
+    vertexData.pSysMem = vertices;
     
     HRESULT hr = device->CreateBuffer(&vertexBufferDesc, &vertexData, &vertexBuffer_);
     if (FAILED(hr)) {
         Logger::Error("Failed to create vertex buffer");
         return false;
     }
+    if (format == VertexFormat::Skinned) {
+        D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+        viewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+        viewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+        viewDesc.BufferEx.NumElements = vertexBufferDesc.ByteWidth / 4;
+        if (FAILED(device->CreateShaderResourceView(vertexBuffer_, &viewDesc, &vertexView_))) {
+            Logger::Error("Failed to create skinned vertex view");
+            ReleaseBuffers();
+            return false;
+        }
+    }
     
-    // Create index buffer
+    // Create index buffer. Meshlet culling reads it in compute through a raw view, which needs
+    // whole 32-bit words, so an odd count of 16-bit indices gets a padding index
     D3D11_BUFFER_DESC indexBufferDesc = {};
-    indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = indexCount_ * sizeof(unsigned int);
+    indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    indexBufferDesc.ByteWidth = indexCount * indexSize;
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
     indexBufferDesc.CPUAccessFlags = 0;
+
+    std::vector<char> paddedIndices;
+    if (!meshlets.empty()) {
+        indexBufferDesc.BindFlags |= D3D11_BIND_SHADER_RESOURCE;
+        indexBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+        if (indexBufferDesc.ByteWidth % 4 != 0) {
+            paddedIndices.assign(indexBufferDesc.ByteWidth + 2, 0);
+            std::memcpy(paddedIndices.data(), indices, indexBufferDesc.ByteWidth);
+            indexBufferDesc.ByteWidth += 2;
+            indices = paddedIndices.data();
+        }
+    }
     
     D3D11_SUBRESOURCE_DATA indexData = {};
-    indexData.pSysMem = indices.data();
+    indexData.pSysMem = indices;
     
     hr = device->CreateBuffer(&indexBufferDesc, &indexData, &indexBuffer_);
     if (FAILED(hr)) {
         Logger::Error("Failed to create index buffer");
+        ReleaseBuffers();
+        return false;
+    }
+
+    if (!meshlets.empty() && !CreateMeshletViews(meshlets, indexBufferDesc.ByteWidth, device)) {
+        ReleaseBuffers();
         return false;
     }
+
+    vertexCount_ = static_cast<int>(vertexCount);
+    indexCount_ = static_cast<int>(indexCount);
+    indexFormat_ = indexFormat;
+    vertexFormat_ = format;
+    lods_ = std::move(lods);
+    meshlets_ = std::move(meshlets);
+    memoryUsage_ = vertexBufferDesc.ByteWidth + indexBufferDesc.ByteWidth + meshlets_.size() * sizeof(Meshlet);
     
     Logger::Info("Mesh created successfully - Vertices: " + std::to_string(vertexCount_) + 
-                 ", Triangles: " + std::to_string(indexCount_ / 3));
+                 ", Triangles: " + std::to_string(GetTriangleCount()) + ", LODs: " + std::to_string(lods_.size()) +
+                 ", Meshlets: " + std::to_string(meshlets_.size()));
     
     return true;
 }
 
-void Mesh::Render(ID3D11DeviceContext* context) {
-    if (!context || !vertexBuffer_ || !indexBuffer_) return;
+bool Mesh::CreateMeshletViews(const std::vector<Meshlet>& meshlets, UINT indexBytes, ID3D11Device* device) {
+    D3D11_BUFFER_DESC meshletBufferDesc = {};
+    meshletBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    meshletBufferDesc.ByteWidth = static_cast<UINT>(meshlets.size() * sizeof(Meshlet));
+    meshletBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    meshletBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+
+    D3D11_SUBRESOURCE_DATA meshletData = {};
+    meshletData.pSysMem = meshlets.data();
+
+    HRESULT hr = device->CreateBuffer(&meshletBufferDesc, &meshletData, &meshletBuffer_);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create meshlet buffer");
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+    viewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+    viewDesc.BufferEx.NumElements = meshletBufferDesc.ByteWidth / 4;
+    hr = device->CreateShaderResourceView(meshletBuffer_, &viewDesc, &meshletView_);
+    if (SUCCEEDED(hr)) {
+        viewDesc.BufferEx.NumElements = indexBytes / 4;
+        hr = device->CreateShaderResourceView(indexBuffer_, &viewDesc, &indexView_);
+    }
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create meshlet views");
+        return false;
+    }
+    return true;
+}
+
+void Mesh::Render(ID3D11DeviceContext* context, size_t lod) {
+    if (!context || !vertexBuffer_ || !indexBuffer_ || lods_.empty()) return;
     
     // Set vertex buffer
-    UINT stride = sizeof(Vertex);
+    UINT stride = GetVertexStride(vertexFormat_);
     UINT offset = 0;
     context->IASetVertexBuffers(0, 1, &vertexBuffer_, &stride, &offset);
-    context->IASetIndexBuffer(indexBuffer_, DXGI_FORMAT_R32_UINT, 0);
+    // Always set, so a LIGHTMAP shader never reads the previous mesh's coordinates
+    UINT lightmapStride = sizeof(XMFLOAT2);
+    context->IASetVertexBuffers(1, 1, &lightmapBuffer_, &lightmapStride, &offset);
+    context->IASetIndexBuffer(indexBuffer_, indexFormat_, 0);
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     
     // Draw
-    context->DrawIndexed(indexCount_, 0, 0);
+    const MeshLod& level = lods_[std::min(lod, lods_.size() - 1)];
+    context->DrawIndexed(level.indexCount, level.indexOffset, 0);
+}
+
+bool Mesh::SetLightmapCoordinates(const std::vector<XMFLOAT2>& coordinates, ID3D11Device* device) {
+    if (!device || !vertexBuffer_ || coordinates.size() != static_cast<size_t>(vertexCount_)) {
+        Logger::Error("Lightmap coordinates do not match the mesh's vertices");
+        return false;
+    }
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.ByteWidth = static_cast<UINT>(coordinates.size() * sizeof(XMFLOAT2));
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    D3D11_SUBRESOURCE_DATA data = {};
+    data.pSysMem = coordinates.data();
+    ID3D11Buffer* buffer = nullptr;
+    if (FAILED(device->CreateBuffer(&desc, &data, &buffer))) {
+        Logger::Error("Failed to create lightmap coordinate buffer");
+        return false;
+    }
+
+    if (lightmapBuffer_) {
+        memoryUsage_ -= vertexCount_ * sizeof(XMFLOAT2);
+        lightmapBuffer_->Release();
+    }
+    lightmapBuffer_ = buffer;
+    memoryUsage_ += desc.ByteWidth;
+    return true;
+}
+
+void Mesh::RenderIndirect(ID3D11DeviceContext* context, ID3D11Buffer* indexBuffer,
+                          ID3D11Buffer* arguments, UINT argumentsOffset) {
+    if (!context || !vertexBuffer_ || !indexBuffer || !arguments) return;
+
+    UINT stride = GetVertexStride(vertexFormat_);
+    UINT offset = 0;
+    context->IASetVertexBuffers(0, 1, &vertexBuffer_, &stride, &offset);
+    context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->DrawIndexedInstancedIndirect(arguments, argumentsOffset);
+}
+
+void Mesh::RenderInstancedIndirect(ID3D11DeviceContext* context, ID3D11Buffer* arguments, UINT argumentsOffset) {
+    if (!context || !vertexBuffer_ || !indexBuffer_ || !arguments) return;
+
+    UINT stride = GetVertexStride(vertexFormat_);
+    UINT offset = 0;
+    context->IASetVertexBuffers(0, 1, &vertexBuffer_, &stride, &offset);
+    context->IASetIndexBuffer(indexBuffer_, indexFormat_, 0);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->DrawIndexedInstancedIndirect(arguments, argumentsOffset);
+}
+
+void Mesh::RenderSkinned(ID3D11DeviceContext* context, ID3D11Buffer* skinnedVertices, UINT baseVertex, size_t lod) {
+    if (!context || !skinnedVertices || !indexBuffer_ || lods_.empty()) return;
+
+    UINT stride = sizeof(Vertex);
+    UINT offset = 0;
+    context->IASetVertexBuffers(0, 1, &skinnedVertices, &stride, &offset);
+    context->IASetIndexBuffer(indexBuffer_, indexFormat_, 0);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    const MeshLod& level = lods_[std::min(lod, lods_.size() - 1)];
+    context->DrawIndexed(level.indexCount, level.indexOffset, static_cast<INT>(baseVertex));
 }
 
 } // namespace Nexus
@@ -0,0 +1,1612 @@
+#include "MeshImporter.h"
+#include "AtomicFile.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <DirectXPackedVector.h>
+
+#include <rapidjson/document.h>
+
+// Only the zlib decoder is used, for compressed FBX arrays
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_NO_STDIO
+#include <stb/stb_image.h>
+
+namespace Nexus {
+
+namespace {
+
+constexpr int FORSYTH_CACHE_SIZE = 32;
+constexpr int SIMULATED_CACHE_SIZE = 16;
+
+bool ReadFileBytes(const std::string& filename, std::vector<char>& data) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamsize size = file.tellg();
+    if (size < 0) return false;
+    file.seekg(0);
+    data.resize(static_cast<size_t>(size));
+    return size == 0 || static_cast<bool>(file.read(data.data(), size));
+}
+
+std::string GetExtension(const std::string& filename) {
+    std::string extension = std::filesystem::path(filename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+XMFLOAT3 Normalize(const XMFLOAT3& v, const XMFLOAT3& fallback) {
+    float length = std::sqrt(Dot(v, v));
+    return length > 1e-12f ? XMFLOAT3{ v.x / length, v.y / length, v.z / length } : fallback;
+}
+
+// Sources are right-handed; mirroring Z and flipping the winding keeps front faces front-facing
+void ConvertToLeftHanded(MeshData& mesh, size_t firstVertex, size_t firstIndex) {
+    for (size_t i = firstVertex; i < mesh.vertices.size(); ++i) {
+        mesh.vertices[i].position.z = -mesh.vertices[i].position.z;
+        mesh.vertices[i].normal.z = -mesh.vertices[i].normal.z;
+        mesh.vertices[i].tangent.z = -mesh.vertices[i].tangent.z;
+    }
+    for (size_t i = firstIndex; i + 2 < mesh.indices.size(); i += 3) {
+        std::swap(mesh.indices[i + 1], mesh.indices[i + 2]);
+    }
+}
+
+struct CornerKey {
+    int64_t position, texCoord, normal;
+    bool operator==(const CornerKey& other) const {
+        return position == other.position && texCoord == other.texCoord && normal == other.normal;
+    }
+};
+
+struct CornerKeyHash {
+    size_t operator()(const CornerKey& key) const {
+        uint64_t hash = static_cast<uint64_t>(key.position) * 0x9E3779B97F4A7C15ull;
+        hash ^= static_cast<uint64_t>(key.texCoord) + 0x632BE59BD9B4E019ull + (hash << 6) + (hash >> 2);
+        hash ^= static_cast<uint64_t>(key.normal) + 0x85EBCA77C2B2AE63ull + (hash << 6) + (hash >> 2);
+        return static_cast<size_t>(hash);
+    }
+};
+
+// ---------------------------------------------------------------------------------------------
+// OBJ
+
+const char* SkipSpaces(const char* cursor, const char* end) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t')) ++cursor;
+    return cursor;
+}
+
+const char* NextLine(const char* cursor, const char* end) {
+    while (cursor < end && *cursor != '\n') ++cursor;
+    return cursor < end ? cursor + 1 : end;
+}
+
+float ParseFloat(const char*& cursor) {
+    char* next = nullptr;
+    float value = std::strtof(cursor, &next);
+    cursor = next;
+    return value;
+}
+
+// Resolves a 1-based (or negative, relative) OBJ index; -1 when absent or out of range
+int64_t ResolveObjIndex(long value, size_t count) {
+    int64_t index = value < 0 ? static_cast<int64_t>(count) + value : static_cast<int64_t>(value) - 1;
+    return index >= 0 && index < static_cast<int64_t>(count) ? index : -1;
+}
+
+// ---------------------------------------------------------------------------------------------
+// glTF
+
+bool DecodeBase64(const char* text, size_t length, std::vector<char>& out) {
+    auto decode = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    };
+
+    out.clear();
+    out.reserve(length * 3 / 4);
+    uint32_t bits = 0;
+    int bitCount = 0;
+    for (size_t i = 0; i < length && text[i] != '='; ++i) {
+        int value = decode(text[i]);
+        if (value < 0) return false;
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        bitCount += 6;
+        if (bitCount >= 8) {
+            bitCount -= 8;
+            out.push_back(static_cast<char>((bits >> bitCount) & 0xFF));
+        }
+    }
+    return true;
+}
+
+class GltfReader {
+public:
+    bool Load(const std::string& filename) {
+        std::vector<char> file;
+        if (!ReadFileBytes(filename, file)) {
+            Logger::Error("Could not read glTF file: " + filename);
+            return false;
+        }
+        baseDirectory_ = std::filesystem::path(filename).parent_path();
+
+        const char* json = file.data();
+        size_t jsonLength = file.size();
+        std::vector<char> binaryChunk;
+        if (file.size() >= 12 && std::memcmp(file.data(), "glTF", 4) == 0) {
+            // GLB: header, JSON chunk, optional BIN chunk
+            size_t offset = 12;
+            bool haveJson = false;
+            while (offset + 8 <= file.size()) {
+                uint32_t chunkLength, chunkType;
+                std::memcpy(&chunkLength, file.data() + offset, 4);
+                std::memcpy(&chunkType, file.data() + offset + 4, 4);
+                offset += 8;
+                if (chunkLength > file.size() - offset) return false;
+                if (chunkType == 0x4E4F534A) {          // "JSON"
+                    json = file.data() + offset;
+                    jsonLength = chunkLength;
+                    haveJson = true;
+                } else if (chunkType == 0x004E4942) {   // "BIN\0"
+                    binaryChunk.assign(file.data() + offset, file.data() + offset + chunkLength);
+                }
+                offset += (chunkLength + 3) & ~3u;
+            }
+            if (!haveJson) return false;
+        }
+
+        document_.Parse(json, jsonLength);
+        if (document_.HasParseError() || !document_.IsObject()) {
+            Logger::Error("Invalid glTF JSON: " + filename);
+            return false;
+        }
+        return LoadBuffers(binaryChunk);
+    }
+
+    bool AppendMeshes(MeshData& mesh, bool& hasNormals, bool& hasTangents) {
+        if (!document_.HasMember("meshes") || !document_["meshes"].IsArray()) return false;
+
+        hasNormals = true;
+        hasTangents = true;
+        for (const auto& gltfMesh : document_["meshes"].GetArray()) {
+            if (!gltfMesh.HasMember("primitives")) continue;
+            for (const auto& primitive : gltfMesh["primitives"].GetArray()) {
+                if (primitive.HasMember("mode") && primitive["mode"].GetInt() != 4) {
+                    Logger::Warning("Skipping non-triangle glTF primitive");
+                    continue;
+                }
+                if (!AppendPrimitive(primitive, mesh, hasNormals, hasTangents)) return false;
+            }
+        }
+        return !mesh.indices.empty();
+    }
+
+private:
+    bool LoadBuffers(std::vector<char>& binaryChunk) {
+        if (!document_.HasMember("buffers")) return true;
+        if (!document_["buffers"].IsArray()) return false;
+        for (const auto& buffer : document_["buffers"].GetArray()) {
+            if (!buffer.IsObject()) return false;
+            buffers_.emplace_back();
+            std::vector<char>& data = buffers_.back();
+            if (!buffer.HasMember("uri")) {
+                data = std::move(binaryChunk);
+                continue;
+            }
+            if (!buffer["uri"].IsString()) return false;
+
+            std::string uri = buffer["uri"].GetString();
+            size_t comma = uri.find(',');
+            if (uri.compare(0, 5, "data:") == 0 && comma != std::string::npos) {
+                if (!DecodeBase64(uri.c_str() + comma + 1, uri.size() - comma - 1, data)) return false;
+            } else if (!ReadFileBytes((baseDirectory_ / uri).string(), data)) {
+                Logger::Error("Could not read glTF buffer: " + uri);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static int ComponentCount(const char* type) {
+        if (std::strcmp(type, "SCALAR") == 0) return 1;
+        if (std::strcmp(type, "VEC2") == 0) return 2;
+        if (std::strcmp(type, "VEC3") == 0) return 3;
+        if (std::strcmp(type, "VEC4") == 0) return 4;
+        return 0;
+    }
+
+    static size_t ComponentSize(int componentType) {
+        switch (componentType) {
+            case 5120: case 5121: return 1;
+            case 5122: case 5123: return 2;
+            case 5125: case 5126: return 4;
+            default: return 0;
+        }
+    }
+
+    static float ReadComponent(const char* source, int componentType, bool normalized) {
+        switch (componentType) {
+            case 5126: { float v; std::memcpy(&v, source, 4); return v; }
+            case 5125: { uint32_t v; std::memcpy(&v, source, 4); return static_cast<float>(v); }
+            case 5123: { uint16_t v; std::memcpy(&v, source, 2); return normalized ? v / 65535.0f : v; }
+            case 5122: { int16_t v; std::memcpy(&v, source, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+            case 5121: { uint8_t v = static_cast<uint8_t>(*source); return normalized ? v / 255.0f : v; }
+            case 5120: { int8_t v = static_cast<int8_t>(*source); return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+            default: return 0.0f;
+        }
+    }
+
+    // Unsigned member of a glTF object, `fallback` when absent; false when present with another type
+    static bool ReadUint(const rapidjson::Value& object, const char* name, size_t fallback, size_t& value) {
+        if (!object.HasMember(name)) {
+            value = fallback;
+            return true;
+        }
+        if (!object[name].IsUint()) return false;
+        value = object[name].GetUint();
+        return true;
+    }
+
+    // Reads an accessor as floats, `components` values per element; false on malformed data
+    bool ReadAccessor(int accessorIndex, int components, std::vector<float>& out, size_t& count) {
+        if (!document_.HasMember("accessors") || !document_["accessors"].IsArray()) return false;
+        const auto& accessors = document_["accessors"];
+        if (accessorIndex < 0 || accessorIndex >= static_cast<int>(accessors.Size())) return false;
+        const auto& accessor = accessors[accessorIndex];
+        if (!accessor.IsObject()) return false;
+        if (accessor.HasMember("sparse")) {
+            Logger::Error("Sparse glTF accessors are not supported");
+            return false;
+        }
+        if (!accessor.HasMember("componentType") || !accessor["componentType"].IsInt() ||
+            !accessor.HasMember("type") || !accessor["type"].IsString() ||
+            !accessor.HasMember("count") || !accessor["count"].IsUint()) {
+            return false;
+        }
+
+        int componentType = accessor["componentType"].GetInt();
+        int accessorComponents = ComponentCount(accessor["type"].GetString());
+        bool normalized = accessor.HasMember("normalized") && accessor["normalized"].IsBool() &&
+                          accessor["normalized"].GetBool();
+        size_t componentSize = ComponentSize(componentType);
+        count = accessor["count"].GetUint();
+        if (componentSize == 0 || accessorComponents < components) return false;
+
+        if (!accessor.HasMember("bufferView")) {
+            out.assign(count * components, 0.0f);   // All zeros by definition
+            return true;
+        }
+
+        size_t viewIndex;
+        if (!ReadUint(accessor, "bufferView", 0, viewIndex)) return false;
+        if (!document_.HasMember("bufferViews") || !document_["bufferViews"].IsArray()) return false;
+        const auto& views = document_["bufferViews"];
+        if (viewIndex >= views.Size() || !views[static_cast<rapidjson::SizeType>(viewIndex)].IsObject()) return false;
+        const auto& view = views[static_cast<rapidjson::SizeType>(viewIndex)];
+
+        size_t bufferIndex;
+        if (!view.HasMember("buffer") || !ReadUint(view, "buffer", 0, bufferIndex)) return false;
+        if (bufferIndex >= buffers_.size()) return false;
+        const std::vector<char>& buffer = buffers_[bufferIndex];
+
+        size_t elementSize = componentSize * accessorComponents;
+        size_t stride, viewOffset, accessorOffset;
+        if (!ReadUint(view, "byteStride", elementSize, stride) || !ReadUint(view, "byteOffset", 0, viewOffset) ||
+            !ReadUint(accessor, "byteOffset", 0, accessorOffset) || stride < elementSize) {
+            return false;
+        }
+
+        // Checked in this order so a hostile count or offset cannot wrap the end past the buffer
+        size_t offset = viewOffset + accessorOffset;
+        if (count > 0) {
+            if (offset > buffer.size() || elementSize > buffer.size() - offset) return false;
+            if (count - 1 > (buffer.size() - offset - elementSize) / stride) return false;
+        }
+
+        out.assign(count * components, 0.0f);
+        for (size_t i = 0; i < count; ++i) {
+            const char* element = buffer.data() + offset + stride * i;
+            for (int c = 0; c < components; ++c) {
+                out[i * components + c] = ReadComponent(element + c * componentSize, componentType, normalized);
+            }
+        }
+        return true;
+    }
+
+    int Attribute(const rapidjson::Value& primitive, const char* name) const {
+        const auto& attributes = primitive["attributes"];
+        return attributes.HasMember(name) ? attributes[name].GetInt() : -1;
+    }
+
+    bool AppendPrimitive(const rapidjson::Value& primitive, MeshData& mesh, bool& hasNormals, bool& hasTangents) {
+        int positionAccessor = Attribute(primitive, "POSITION");
+        if (positionAccessor < 0) return true;
+
+        std::vector<float> positions, normals, texCoords, tangents, indices;
+        size_t vertexCount = 0, count = 0;
+        if (!ReadAccessor(positionAccessor, 3, positions, vertexCount)) return false;
+
+        int normalAccessor = Attribute(primitive, "NORMAL");
+        int texCoordAccessor = Attribute(primitive, "TEXCOORD_0");
+        int tangentAccessor = Attribute(primitive, "TANGENT");
+        if (normalAccessor >= 0 && (!ReadAccessor(normalAccessor, 3, normals, count) || count != vertexCount)) return false;
+        if (texCoordAccessor >= 0 && (!ReadAccessor(texCoordAccessor, 2, texCoords, count) || count != vertexCount)) return false;
+        if (tangentAccessor >= 0 && (!ReadAccessor(tangentAccessor, 3, tangents, count) || count != vertexCount)) return false;
+        hasNormals = hasNormals && normalAccessor >= 0;
+        hasTangents = hasTangents && tangentAccessor >= 0;
+
+        const size_t baseVertex = mesh.vertices.size();
+        for (size_t i = 0; i < vertexCount; ++i) {
+            Vertex vertex = {};
+            vertex.position = { positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2] };
+            if (!normals.empty()) vertex.normal = { normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2] };
+            if (!tangents.empty()) vertex.tangent = { tangents[i * 3], tangents[i * 3 + 1], tangents[i * 3 + 2] };
+            if (!texCoords.empty()) vertex.texCoord = { texCoords[i * 2], texCoords[i * 2 + 1] };
+            mesh.vertices.push_back(vertex);
+        }
+
+        if (primitive.HasMember("indices")) {
+            if (!ReadAccessor(primitive["indices"].GetInt(), 1, indices, count)) return false;
+            for (size_t i = 0; i + 2 < count; i += 3) {
+                uint32_t a = static_cast<uint32_t>(indices[i]);
+                uint32_t b = static_cast<uint32_t>(indices[i + 1]);
+                uint32_t c = static_cast<uint32_t>(indices[i + 2]);
+                if (a >= vertexCount || b >= vertexCount || c >= vertexCount) return false;
+                mesh.indices.insert(mesh.indices.end(), { uint32_t(baseVertex + a), uint32_t(baseVertex + b), uint32_t(baseVertex + c) });
+            }
+        } else {
+            for (size_t i = 0; i + 2 < vertexCount; i += 3) {
+                mesh.indices.insert(mesh.indices.end(), { uint32_t(baseVertex + i), uint32_t(baseVertex + i + 1), uint32_t(baseVertex + i + 2) });
+            }
+        }
+        return true;
+    }
+
+    rapidjson::Document document_;
+    std::vector<std::vector<char>> buffers_;
+    std::filesystem::path baseDirectory_;
+};
+
+// ---------------------------------------------------------------------------------------------
+// Binary FBX
+
+struct FbxProperty {
+    char type = 0;
+    std::string text;
+    std::vector<double> values;
+};
+
+struct FbxNode {
+    std::string name;
+    std::vector<FbxProperty> properties;
+    std::vector<FbxNode> children;
+
+    const FbxNode* Find(const char* childName) const {
+        for (const FbxNode& child : children) {
+            if (child.name == childName) return &child;
+        }
+        return nullptr;
+    }
+
+    const std::vector<double>* Values(const char* childName) const {
+        const FbxNode* child = Find(childName);
+        return child && !child->properties.empty() ? &child->properties[0].values : nullptr;
+    }
+
+    std::string Text(const char* childName) const {
+        const FbxNode* child = Find(childName);
+        return child && !child->properties.empty() ? child->properties[0].text : std::string();
+    }
+};
+
+class FbxReader {
+public:
+    static constexpr size_t HEADER_SIZE = 27;
+
+    bool Parse(const std::vector<char>& data, FbxNode& root) {
+        static const char MAGIC[] = "Kaydara FBX Binary  ";
+        if (data.size() < HEADER_SIZE || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+            Logger::Error("Not a binary FBX file (ASCII FBX is not supported, re-export as binary)");
+            return false;
+        }
+
+        data_ = reinterpret_cast<const uint8_t*>(data.data());
+        size_ = data.size();
+        position_ = 23;
+        uint32_t version = 0;
+        if (!Read(version)) return false;
+        wideOffsets_ = version >= 7500;
+
+        while (position_ < size_) {
+            FbxNode node;
+            bool isNull = false;
+            if (!ReadNode(node, isNull)) return false;
+            if (isNull) break;
+            root.children.push_back(std::move(node));
+        }
+        return true;
+    }
+
+private:
+    template<typename T>
+    bool Read(T& value) {
+        if (size_ - position_ < sizeof(T)) return false;
+        std::memcpy(&value, data_ + position_, sizeof(T));
+        position_ += sizeof(T);
+        return true;
+    }
+
+    bool ReadOffset(uint64_t& value) {
+        if (wideOffsets_) return Read(value);
+        uint32_t narrow = 0;
+        if (!Read(narrow)) return false;
+        value = narrow;
+        return true;
+    }
+
+    bool ReadNode(FbxNode& node, bool& isNull) {
+        uint64_t endOffset = 0, propertyCount = 0, propertyLength = 0;
+        uint8_t nameLength = 0;
+        if (!ReadOffset(endOffset) || !ReadOffset(propertyCount) || !ReadOffset(propertyLength) || !Read(nameLength)) {
+            return false;
+        }
+        if (endOffset == 0) {
+            isNull = true;
+            return true;
+        }
+        // The node must end inside the file and after its own header, or position_ = endOffset
+        // would rewind into data already parsed and loop forever
+        if (endOffset > size_ || endOffset < position_ || endOffset - position_ < nameLength) return false;
+
+        node.name.assign(reinterpret_cast<const char*>(data_ + position_), nameLength);
+        position_ += nameLength;
+
+        // Every property takes at least its type code byte
+        if (propertyCount > endOffset - position_) return false;
+        node.properties.resize(static_cast<size_t>(propertyCount));
+        for (FbxProperty& property : node.properties) {
+            if (!ReadProperty(property)) return false;
+        }
+
+        while (position_ < endOffset) {
+            FbxNode child;
+            bool childNull = false;
+            if (!ReadNode(child, childNull)) return false;
+            if (childNull) break;
+            node.children.push_back(std::move(child));
+        }
+        if (position_ > endOffset) return false;
+        position_ = static_cast<size_t>(endOffset);
+        return true;
+    }
+
+    template<typename T>
+    static void AppendValues(const uint8_t* source, uint32_t count, std::vector<double>& out) {
+        out.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            T value;
+            std::memcpy(&value, source + i * sizeof(T), sizeof(T));
+            out[i] = static_cast<double>(value);
+        }
+    }
+
+    bool ReadProperty(FbxProperty& property) {
+        uint8_t type = 0;
+        if (!Read(type)) return false;
+        property.type = static_cast<char>(type);
+
+        switch (type) {
+            case 'Y': { int16_t v; if (!Read(v)) return false; property.values = { double(v) }; return true; }
+            case 'C': { uint8_t v; if (!Read(v)) return false; property.values = { double(v) }; return true; }
+            case 'I': { int32_t v; if (!Read(v)) return false; property.values = { double(v) }; return true; }
+            case 'F': { float v; if (!Read(v)) return false; property.values = { double(v) }; return true; }
+            case 'D': { double v; if (!Read(v)) return false; property.values = { v }; return true; }
+            case 'L': { int64_t v; if (!Read(v)) return false; property.values = { double(v) }; return true; }
+            case 'S':
+            case 'R': {
+                uint32_t length = 0;
+                if (!Read(length) || size_ - position_ < length) return false;
+                property.text.assign(reinterpret_cast<const char*>(data_ + position_), length);
+                position_ += length;
+                return true;
+            }
+            case 'f': case 'd': case 'l': case 'i': case 'b':
+                return ReadArray(property, type);
+            default:
+                return false;
+        }
+    }
+
+    bool ReadArray(FbxProperty& property, uint8_t type) {
+        uint32_t count = 0, encoding = 0, storedLength = 0;
+        if (!Read(count) || !Read(encoding) || !Read(storedLength) || size_ - position_ < storedLength) return false;
+
+        size_t elementSize = (type == 'd' || type == 'l') ? 8 : (type == 'b' ? 1 : 4);
+        size_t rawLength = static_cast<size_t>(count) * elementSize;
+        const uint8_t* source = data_ + position_;
+        std::vector<uint8_t> inflated;
+        if (encoding == 1) {
+            inflated.resize(rawLength);
+            int written = stbi_zlib_decode_buffer(reinterpret_cast<char*>(inflated.data()), static_cast<int>(rawLength),
+                                                  reinterpret_cast<const char*>(source), static_cast<int>(storedLength));
+            if (written != static_cast<int>(rawLength)) return false;
+            source = inflated.data();
+        } else if (encoding != 0 || storedLength != rawLength) {
+            return false;
+        }
+        position_ += storedLength;
+
+        switch (type) {
+            case 'f': AppendValues<float>(source, count, property.values); break;
+            case 'd': AppendValues<double>(source, count, property.values); break;
+            case 'l': AppendValues<int64_t>(source, count, property.values); break;
+            case 'i': AppendValues<int32_t>(source, count, property.values); break;
+            case 'b': AppendValues<uint8_t>(source, count, property.values); break;
+        }
+        return true;
+    }
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t position_ = 0;
+    bool wideOffsets_ = false;
+};
+
+// A LayerElementNormal / LayerElementUV resolved to a lookup from polygon-vertex to element
+struct FbxLayer {
+    const std::vector<double>* data = nullptr;
+    const std::vector<double>* index = nullptr;
+    enum class Mapping { PolygonVertex, Vertex, Polygon, AllSame } mapping = Mapping::PolygonVertex;
+    int components = 0;
+
+    bool Load(const FbxNode* layer, const char* dataName, const char* indexName, int componentCount) {
+        if (!layer) return false;
+        data = layer->Values(dataName);
+        if (!data) return false;
+        components = componentCount;
+
+        std::string mappingType = layer->Text("MappingInformationType");
+        if (mappingType == "ByVertice" || mappingType == "ByVertex") mapping = Mapping::Vertex;
+        else if (mappingType == "ByPolygon") mapping = Mapping::Polygon;
+        else if (mappingType == "AllSame") mapping = Mapping::AllSame;
+        else mapping = Mapping::PolygonVertex;
+
+        if (layer->Text("ReferenceInformationType") == "IndexToDirect") {
+            index = layer->Values(indexName);
+            if (!index) return false;
+        }
+        return true;
+    }
+
+    int64_t Element(size_t polygonVertex, int64_t vertex, size_t polygon) const {
+        if (!data) return -1;
+        int64_t element = mapping == Mapping::Vertex ? vertex :
+                          mapping == Mapping::Polygon ? static_cast<int64_t>(polygon) :
+                          mapping == Mapping::AllSame ? 0 : static_cast<int64_t>(polygonVertex);
+        if (index) {
+            if (element < 0 || element >= static_cast<int64_t>(index->size())) return -1;
+            element = static_cast<int64_t>((*index)[static_cast<size_t>(element)]);
+        }
+        return element >= 0 && (element + 1) * components <= static_cast<int64_t>(data->size()) ? element : -1;
+    }
+};
+
+bool AppendFbxGeometry(const FbxNode& geometry, MeshData& mesh, bool& hasNormals) {
+    const std::vector<double>* positions = geometry.Values("Vertices");
+    const std::vector<double>* polygonIndices = geometry.Values("PolygonVertexIndex");
+    if (!positions || !polygonIndices) return true;
+
+    FbxLayer normals, texCoords;
+    bool geometryHasNormals = normals.Load(geometry.Find("LayerElementNormal"), "Normals", "NormalsIndex", 3);
+    texCoords.Load(geometry.Find("LayerElementUV"), "UV", "UVIndex", 2);
+    hasNormals = hasNormals && geometryHasNormals;
+
+    const int64_t positionCount = static_cast<int64_t>(positions->size() / 3);
+    std::unordered_map<CornerKey, uint32_t, CornerKeyHash> corners;
+    std::vector<uint32_t> polygon;
+    size_t polygonIndex = 0;
+
+    for (size_t pv = 0; pv < polygonIndices->size(); ++pv) {
+        int64_t raw = static_cast<int64_t>((*polygonIndices)[pv]);
+        bool lastCorner = raw < 0;
+        int64_t vertex = lastCorner ? ~raw : raw;
+        if (vertex >= positionCount) return false;
+
+        int64_t normalElement = normals.Element(pv, vertex, polygonIndex);
+        int64_t texCoordElement = texCoords.Element(pv, vertex, polygonIndex);
+        CornerKey key = { vertex, texCoordElement, normalElement };
+        auto inserted = corners.emplace(key, static_cast<uint32_t>(mesh.vertices.size()));
+        if (inserted.second) {
+            Vertex v = {};
+            v.position = { float((*positions)[vertex * 3]), float((*positions)[vertex * 3 + 1]), float((*positions)[vertex * 3 + 2]) };
+            if (normalElement >= 0) {
+                const double* n = normals.data->data() + normalElement * 3;
+                v.normal = { float(n[0]), float(n[1]), float(n[2]) };
+            }
+            if (texCoordElement >= 0) {
+                const double* t = texCoords.data->data() + texCoordElement * 2;
+                v.texCoord = { float(t[0]), 1.0f - float(t[1]) };   // FBX UV origin is bottom-left
+            }
+            mesh.vertices.push_back(v);
+        }
+        polygon.push_back(inserted.first->second);
+
+        if (lastCorner) {
+            for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                mesh.indices.insert(mesh.indices.end(), { polygon[0], polygon[i], polygon[i + 1] });
+            }
+            polygon.clear();
+            polygonIndex++;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Optimization helpers
+
+// FIFO cache used to evaluate orderings, as in most hardware of the D3D11 generation
+class CacheSimulator {
+public:
+    CacheSimulator(size_t vertexCount, size_t cacheSize)
+        : stamps_(vertexCount, 0), cacheSize_(static_cast<uint32_t>(cacheSize)), time_(cacheSize_ + 1) {}
+
+    unsigned Access(uint32_t vertex) {
+        if (time_ - stamps_[vertex] <= cacheSize_) return 0;
+        stamps_[vertex] = time_++;
+        return 1;
+    }
+
+    void Flush() { time_ += cacheSize_ + 1; }
+
+private:
+    std::vector<uint32_t> stamps_;
+    uint32_t cacheSize_;
+    uint32_t time_;
+};
+
+uint16_t QuantizeUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+uint8_t QuantizeSnormToUnorm8(float value) {
+    return static_cast<uint8_t>(std::lround((std::min(std::max(value, -1.0f), 1.0f) * 0.5f + 0.5f) * 255.0f));
+}
+
+// Octahedral mapping of a unit vector to [-1,1]^2; the lower hemisphere folds over the diagonals
+void EncodeOctahedral(const XMFLOAT3& v, uint8_t& x, uint8_t& y) {
+    float length = std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z);
+    float ox = length > 0.0f ? v.x / length : 0.0f;
+    float oy = length > 0.0f ? v.y / length : 0.0f;
+    if (v.z < 0.0f) {
+        float fx = (1.0f - std::fabs(oy)) * (ox >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - std::fabs(ox)) * (oy >= 0.0f ? 1.0f : -1.0f);
+        ox = fx;
+        oy = fy;
+    }
+    x = QuantizeSnormToUnorm8(ox);
+    y = QuantizeSnormToUnorm8(oy);
+}
+
+// Sum of squared distances to a set of planes, each weighted by its triangle's area
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0, a11 = 0, a12 = 0, a13 = 0, a22 = 0, a23 = 0, a33 = 0;
+    double weight = 0;
+
+    void AddPlane(double a, double b, double c, double d, double w) {
+        a00 += w * a * a; a01 += w * a * b; a02 += w * a * c; a03 += w * a * d;
+        a11 += w * b * b; a12 += w * b * c; a13 += w * b * d;
+        a22 += w * c * c; a23 += w * c * d;
+        a33 += w * d * d;
+        weight += w;
+    }
+
+    void Add(const Quadric& q) {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+        weight += q.weight;
+    }
+
+    double Evaluate(const XMFLOAT3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+               a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+               a22 * z * z + 2 * a23 * z + a33;
+    }
+};
+
+// Squared distance error of collapsing `from` onto `to`, normalized by the quadric weights
+double CollapseCost(const Quadric& from, const Quadric& to, const XMFLOAT3& position) {
+    Quadric combined = from;
+    combined.Add(to);
+    return combined.weight > 0.0 ? std::max(combined.Evaluate(position), 0.0) / combined.weight : 0.0;
+}
+
+bool ReadCacheHeader(const std::string& filename, MeshFileHeader& header) {
+    std::ifstream file(filename, std::ios::binary);
+    return file && file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+           header.magic == MeshFileHeader::MAGIC && header.version == MeshFileHeader::VERSION;
+}
+
+float ForsythVertexScore(int cachePosition, uint32_t remainingTriangles) {
+    if (remainingTriangles == 0) return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // The triangle just drawn is penalized slightly so the strip does not turn back on itself
+        score = cachePosition < 3 ? 0.75f :
+                std::pow(1.0f - float(cachePosition - 3) / float(FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+    // Low-valence vertices first, so the remaining mesh does not fragment into islands
+    return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+}
+
+}
+
+// -------------------------------------------------------------------------------------------------
+
+bool MeshImporter::Import(const std::string& filename, MeshData& mesh) {
+    std::string extension = GetExtension(filename);
+    if (extension == ".obj") return ImportOBJ(filename, mesh);
+    if (extension == ".gltf" || extension == ".glb") return ImportGLTF(filename, mesh);
+    if (extension == ".fbx") return ImportFBX(filename, mesh);
+
+    Logger::Error("Unsupported mesh format: " + filename);
+    return false;
+}
+
+bool MeshImporter::ImportOBJ(const std::string& filename, MeshData& mesh) {
+    NEXUS_PROFILE_SCOPE("MeshImporter::ImportOBJ");
+
+    std::vector<char> file;
+    if (!ReadFileBytes(filename, file)) {
+        Logger::Error("Could not read OBJ file: " + filename);
+        return false;
+    }
+    file.push_back('\0');   // strtof/strtol stop at the terminator
+
+    std::vector<XMFLOAT3> positions, normals;
+    std::vector<XMFLOAT2> texCoords;
+    std::unordered_map<CornerKey, uint32_t, CornerKeyHash> corners;
+    std::vector<uint32_t> polygon;
+    mesh = MeshData();
+    bool hasNormals = true;
+
+    const char* cursor = file.data();
+    const char* end = file.data() + file.size() - 1;
+    while (cursor < end) {
+        cursor = SkipSpaces(cursor, end);
+        const char* lineEnd = cursor;
+        while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r') ++lineEnd;
+
+        if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            cursor += 2;
+            XMFLOAT3 p;
+            p.x = ParseFloat(cursor); p.y = ParseFloat(cursor); p.z = ParseFloat(cursor);
+            positions.push_back(p);
+        } else if (cursor[0] == 'v' && cursor[1] == 't') {
+            cursor += 2;
+            XMFLOAT2 t;
+            t.x = ParseFloat(cursor); t.y = ParseFloat(cursor);
+            texCoords.push_back({ t.x, 1.0f - t.y });   // OBJ UV origin is bottom-left
+        } else if (cursor[0] == 'v' && cursor[1] == 'n') {
+            cursor += 2;
+            XMFLOAT3 n;
+            n.x = ParseFloat(cursor); n.y = ParseFloat(cursor); n.z = ParseFloat(cursor);
+            normals.push_back(n);
+        } else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            cursor += 2;
+            polygon.clear();
+            bool valid = true;
+            while (true) {
+                cursor = SkipSpaces(cursor, lineEnd);
+                if (cursor >= lineEnd) break;
+
+                char* next = nullptr;
+                CornerKey key = { ResolveObjIndex(std::strtol(cursor, &next, 10), positions.size()), -1, -1 };
+                cursor = next;
+                if (*cursor == '/') {
+                    ++cursor;
+                    if (*cursor != '/') {
+                        key.texCoord = ResolveObjIndex(std::strtol(cursor, &next, 10), texCoords.size());
+                        cursor = next;
+                    }
+                    if (*cursor == '/') {
+                        ++cursor;
+                        key.normal = ResolveObjIndex(std::strtol(cursor, &next, 10), normals.size());
+                        cursor = next;
+                    }
+                }
+                if (key.position < 0) {
+                    valid = false;
+                    break;
+                }
+                hasNormals = hasNormals && key.normal >= 0;
+
+                auto inserted = corners.emplace(key, static_cast<uint32_t>(mesh.vertices.size()));
+                if (inserted.second) {
+                    Vertex vertex = {};
+                    vertex.position = positions[static_cast<size_t>(key.position)];
+                    if (key.normal >= 0) vertex.normal = normals[static_cast<size_t>(key.normal)];
+                    if (key.texCoord >= 0) vertex.texCoord = texCoords[static_cast<size_t>(key.texCoord)];
+                    mesh.vertices.push_back(vertex);
+                }
+                polygon.push_back(inserted.first->second);
+                while (cursor < lineEnd && *cursor != ' ' && *cursor != '\t') ++cursor;
+            }
+
+            if (valid) {
+                for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                    mesh.indices.insert(mesh.indices.end(), { polygon[0], polygon[i], polygon[i + 1] });
+                }
+            }
+        }
+        cursor = NextLine(lineEnd, end);
+    }
+
+    if (mesh.indices.empty()) {
+        Logger::Error("OBJ file contains no faces: " + filename);
+        return false;
+    }
+
+    ConvertToLeftHanded(mesh, 0, 0);
+    if (!hasNormals) GenerateNormals(mesh);
+    GenerateTangents(mesh);
+    ComputeBounds(mesh);
+    return true;
+}
+
+bool MeshImporter::ImportGLTF(const std::string& filename, MeshData& mesh) {
+    NEXUS_PROFILE_SCOPE("MeshImporter::ImportGLTF");
+
+    mesh = MeshData();
+    GltfReader reader;
+    bool hasNormals = false, hasTangents = false;
+    if (!reader.Load(filename) || !reader.AppendMeshes(mesh, hasNormals, hasTangents)) {
+        Logger::Error("Failed to import glTF: " + filename);
+        return false;
+    }
+
+    ConvertToLeftHanded(mesh, 0, 0);
+    if (!hasNormals) GenerateNormals(mesh);
+    if (!hasTangents) GenerateTangents(mesh);
+    ComputeBounds(mesh);
+    return true;
+}
+
+bool MeshImporter::ImportFBX(const std::string& filename, MeshData& mesh) {
+    NEXUS_PROFILE_SCOPE("MeshImporter::ImportFBX");
+
+    std::vector<char> file;
+    if (!ReadFileBytes(filename, file)) {
+        Logger::Error("Could not read FBX file: " + filename);
+        return false;
+    }
+
+    FbxNode root;
+    FbxReader reader;
+    if (!reader.Parse(file, root)) {
+        Logger::Error("Failed to parse FBX: " + filename);
+        return false;
+    }
+
+    mesh = MeshData();
+    bool hasNormals = true;
+    const FbxNode* objects = root.Find("Objects");
+    if (objects) {
+        for (const FbxNode& object : objects->children) {
+            if (object.name != "Geometry" || object.properties.size() < 3 || object.properties[2].text != "Mesh") continue;
+            if (!AppendFbxGeometry(object, mesh, hasNormals)) {
+                Logger::Error("Malformed FBX geometry in " + filename);
+                return false;
+            }
+        }
+    }
+
+    if (mesh.indices.empty()) {
+        Logger::Error("FBX file contains no mesh geometry: " + filename);
+        return false;
+    }
+
+    ConvertToLeftHanded(mesh, 0, 0);
+    if (!hasNormals) GenerateNormals(mesh);
+    GenerateTangents(mesh);
+    ComputeBounds(mesh);
+    return true;
+}
+
+void MeshImporter::GenerateLods(MeshData& mesh, size_t maxLods, float reduction, float maxError) {
+    NEXUS_PROFILE_SCOPE("MeshImporter::GenerateLods");
+
+    mesh.lods.clear();
+    mesh.lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f });
+
+    XMFLOAT3 extent = Subtract(mesh.boundsMax, mesh.boundsMin);
+    const float errorLimit = maxError * std::sqrt(Dot(extent, extent));
+    if (errorLimit <= 0.0f) return;
+
+    // Each level is simplified from the previous one, so errors accumulate along the chain
+    std::vector<uint32_t> chain = mesh.indices;
+    std::vector<uint32_t> previous = mesh.indices;
+    float error = 0.0f;
+    while (mesh.lods.size() < maxLods) {
+        size_t target = static_cast<size_t>(previous.size() / 3 * reduction) * 3;
+        if (target < 3 || error >= errorLimit) break;
+
+        float levelError = 0.0f;
+        std::vector<uint32_t> level = Simplify(previous, mesh.vertices, target, errorLimit - error, &levelError);
+        // Less than 10% saved means the remaining vertices are locked; further levels would be copies
+        if (level.empty() || level.size() > previous.size() * 9 / 10) break;
+
+        error += levelError;
+        mesh.lods.push_back({ static_cast<uint32_t>(chain.size()), static_cast<uint32_t>(level.size()), error });
+        chain.insert(chain.end(), level.begin(), level.end());
+        previous.swap(level);
+    }
+    mesh.indices.swap(chain);
+}
+
+std::vector<uint32_t> MeshImporter::Simplify(const std::vector<uint32_t>& source, const std::vector<Vertex>& vertices,
+                                             size_t targetIndexCount, float targetError, float* resultError) {
+    const size_t vertexCount = vertices.size();
+    std::vector<uint32_t> indices = source;
+
+    // Vertices sharing a position are split by a UV or normal seam
+    std::vector<uint32_t> canonical(vertexCount);
+    std::vector<uint32_t> copies(vertexCount, 0);
+    {
+        std::unordered_map<CornerKey, uint32_t, CornerKeyHash> positions;
+        for (size_t v = 0; v < vertexCount; ++v) {
+            const XMFLOAT3& p = vertices[v].position;
+            CornerKey key = { 0, 0, 0 };
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            key.position = bits[0];
+            key.texCoord = bits[1];
+            key.normal = bits[2];
+            canonical[v] = positions.emplace(key, static_cast<uint32_t>(v)).first->second;
+            copies[canonical[v]]++;
+        }
+    }
+
+    // Lock seams, and borders: position edges used by a single triangle
+    std::vector<bool> lockedPosition(vertexCount, false);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (copies[v] > 1) lockedPosition[v] = true;
+    }
+    {
+        std::unordered_map<uint64_t, uint32_t> edges;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = canonical[indices[i + k]], b = canonical[indices[i + (k + 1) % 3]];
+                edges[(uint64_t(std::min(a, b)) << 32) | std::max(a, b)]++;
+            }
+        }
+        for (const auto& edge : edges) {
+            if (edge.second == 1) {
+                lockedPosition[edge.first >> 32] = true;
+                lockedPosition[edge.first & 0xFFFFFFFFu] = true;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const XMFLOAT3& p0 = vertices[indices[i]].position;
+        XMFLOAT3 normal = Cross(Subtract(vertices[indices[i + 1]].position, p0), Subtract(vertices[indices[i + 2]].position, p0));
+        float area = std::sqrt(Dot(normal, normal));
+        if (area <= 0.0f) continue;
+        normal = { normal.x / area, normal.y / area, normal.z / area };
+        double d = -Dot(normal, p0);
+        for (int k = 0; k < 3; ++k) quadrics[indices[i + k]].AddPlane(normal.x, normal.y, normal.z, d, area * 0.5);
+    }
+
+    struct Collapse {
+        uint32_t from, to;
+        double cost;
+    };
+    const double errorLimit = double(targetError) * targetError;
+    double maxCost = 0.0;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> offsets, adjacency, remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+
+    // Each pass collapses a set of independent edges cheapest first, then rebuilds the indices
+    while (indices.size() > targetIndexCount) {
+        collapses.clear();
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+                if (!lockedPosition[canonical[a]]) {
+                    collapses.push_back({ a, b, CollapseCost(quadrics[a], quadrics[b], vertices[b].position) });
+                }
+                if (!lockedPosition[canonical[b]]) {
+                    collapses.push_back({ b, a, CollapseCost(quadrics[b], quadrics[a], vertices[a].position) });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        offsets.assign(vertexCount + 1, 0);
+        for (uint32_t index : indices) offsets[index + 1]++;
+        for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+        adjacency.resize(indices.size());
+        {
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i) adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        for (size_t v = 0; v < vertexCount; ++v) remap[v] = static_cast<uint32_t>(v);
+        std::fill(touched.begin(), touched.end(), false);
+        size_t triangles = indices.size() / 3;
+        size_t collapsed = 0;
+
+        for (const Collapse& collapse : collapses) {
+            if (collapse.cost > errorLimit || triangles * 3 <= targetIndexCount) break;
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+
+            // Reject collapses that flip a surviving triangle around `from`
+            const XMFLOAT3& target = vertices[collapse.to].position;
+            bool flips = false;
+            size_t removed = 0;
+            for (uint32_t a = offsets[collapse.from]; a < offsets[collapse.from + 1] && !flips; ++a) {
+                const uint32_t* triangle = &indices[adjacency[a] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+                    removed++;
+                    continue;
+                }
+                XMFLOAT3 p[3], q[3];
+                for (int k = 0; k < 3; ++k) {
+                    p[k] = vertices[triangle[k]].position;
+                    q[k] = triangle[k] == collapse.from ? target : p[k];
+                }
+                XMFLOAT3 before = Cross(Subtract(p[1], p[0]), Subtract(p[2], p[0]));
+                XMFLOAT3 after = Cross(Subtract(q[1], q[0]), Subtract(q[2], q[0]));
+                flips = Dot(before, after) <= 0.0f;
+            }
+            if (flips) continue;
+
+            // The whole one-ring is frozen for the pass so flip checks stay valid
+            for (uint32_t a = offsets[collapse.from]; a < offsets[collapse.from + 1]; ++a) {
+                const uint32_t* triangle = &indices[adjacency[a] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+            }
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            maxCost = std::max(maxCost, collapse.cost);
+            triangles -= removed;
+            collapsed++;
+        }
+        if (collapsed == 0) break;
+
+        size_t write = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            indices[write++] = a;
+            indices[write++] = b;
+            indices[write++] = c;
+        }
+        indices.resize(write);
+    }
+
+    if (resultError) *resultError = static_cast<float>(std::sqrt(maxCost));
+    return indices;
+}
+
+void MeshImporter::Optimize(MeshData& mesh) {
+    NEXUS_PROFILE_SCOPE("MeshImporter::Optimize");
+
+    std::vector<MeshLod> lods = mesh.lods;
+    if (lods.empty()) lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f });
+
+    std::vector<uint32_t> level;
+    for (const MeshLod& lod : lods) {
+        auto begin = mesh.indices.begin() + lod.indexOffset;
+        level.assign(begin, begin + lod.indexCount);
+        OptimizeVertexCache(level, mesh.vertices.size());
+        OptimizeOverdraw(level, mesh.vertices);
+        std::copy(level.begin(), level.end(), begin);
+    }
+    OptimizeVertexFetch(mesh);
+}
+
+void MeshImporter::BuildMeshlets(MeshData& mesh, uint32_t maxVertices, uint32_t maxTriangles) {
+    NEXUS_PROFILE_SCOPE("MeshImporter::BuildMeshlets");
+    mesh.meshlets.clear();
+    maxVertices = std::max(3u, std::min(maxVertices, Meshlet::MAX_VERTICES));
+    maxTriangles = std::max(1u, std::min(maxTriangles, Meshlet::MAX_TRIANGLES));
+
+    const uint32_t indexCount = mesh.lods.empty() ? static_cast<uint32_t>(mesh.indices.size()) : mesh.lods[0].indexCount;
+    const uint32_t firstIndex = mesh.lods.empty() ? 0 : mesh.lods[0].indexOffset;
+
+    // stamp[v] == meshlet number + 1 marks vertices the open meshlet already references
+    std::vector<uint32_t> stamp(mesh.vertices.size(), 0);
+    Meshlet meshlet = {};
+    meshlet.indexOffset = firstIndex;
+    uint32_t vertexCount = 0;
+
+    auto flush = [&]() {
+        if (meshlet.triangleCount == 0) return;
+        ComputeMeshletBounds(mesh, meshlet);
+        mesh.meshlets.push_back(meshlet);
+        meshlet = {};
+        vertexCount = 0;
+    };
+
+    for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+        const uint32_t* triangle = &mesh.indices[firstIndex + i];
+        const uint32_t mark = static_cast<uint32_t>(mesh.meshlets.size()) + 1;
+        uint32_t added = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            added += stamp[triangle[corner]] != mark;
+        }
+        if (vertexCount + added > maxVertices || meshlet.triangleCount == maxTriangles) {
+            flush();
+            meshlet.indexOffset = firstIndex + i;
+        }
+
+        // Re-read the mark, a flush above opened a new meshlet
+        const uint32_t current = static_cast<uint32_t>(mesh.meshlets.size()) + 1;
+        for (int corner = 0; corner < 3; ++corner) {
+            if (stamp[triangle[corner]] != current) {
+                stamp[triangle[corner]] = current;
+                ++vertexCount;
+            }
+        }
+        ++meshlet.triangleCount;
+    }
+    flush();
+}
+
+void MeshImporter::ComputeMeshletBounds(const MeshData& mesh, Meshlet& meshlet) {
+    const uint32_t* indices = &mesh.indices[meshlet.indexOffset];
+    const uint32_t indexCount = meshlet.triangleCount * 3;
+
+    // Sphere around the box center; not minimal, but tight enough for thin clusters
+    XMFLOAT3 minimum = mesh.vertices[indices[0]].position, maximum = minimum;
+    for (uint32_t i = 1; i < indexCount; ++i) {
+        const XMFLOAT3& p = mesh.vertices[indices[i]].position;
+        minimum = { std::min(minimum.x, p.x), std::min(minimum.y, p.y), std::min(minimum.z, p.z) };
+        maximum = { std::max(maximum.x, p.x), std::max(maximum.y, p.y), std::max(maximum.z, p.z) };
+    }
+    meshlet.center = { (minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f };
+    float radiusSquared = 0.0f;
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        XMFLOAT3 offset = Subtract(mesh.vertices[indices[i]].position, meshlet.center);
+        radiusSquared = std::max(radiusSquared, Dot(offset, offset));
+    }
+    meshlet.radius = std::sqrt(radiusSquared);
+
+    // Normal cone: axis is the mean face normal, the spread the widest deviation from it
+    std::vector<XMFLOAT3> normals;
+    normals.reserve(meshlet.triangleCount);
+    XMFLOAT3 axis = { 0.0f, 0.0f, 0.0f };
+    for (uint32_t i = 0; i < indexCount; i += 3) {
+        const XMFLOAT3& p0 = mesh.vertices[indices[i]].position;
+        XMFLOAT3 normal = Cross(Subtract(mesh.vertices[indices[i + 1]].position, p0),
+                                Subtract(mesh.vertices[indices[i + 2]].position, p0));
+        if (Dot(normal, normal) < 1e-20f) continue;
+        normal = Normalize(normal, { 0.0f, 1.0f, 0.0f });
+        normals.push_back(normal);
+        axis = { axis.x + normal.x, axis.y + normal.y, axis.z + normal.z };
+    }
+    meshlet.coneAxis = Normalize(axis, { 0.0f, 1.0f, 0.0f });
+
+    float minimumDot = normals.empty() ? -1.0f : 1.0f;
+    for (const XMFLOAT3& normal : normals) {
+        minimumDot = std::min(minimumDot, Dot(normal, meshlet.coneAxis));
+    }
+    // Cones wider than ~84 degrees almost never cull; disable them rather than test them
+    meshlet.coneCutoff = minimumDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minimumDot * minimumDot);
+}
+
+void MeshImporter::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) return;
+
+    // Triangles adjacent to each vertex; the live ones are kept at the front of each range
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (uint32_t index : indices) remaining[index]++;
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (int k = 0; k < 3; ++k) adjacency[cursor[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) vertexScore[v] = ForsythVertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    size_t best = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if (triangleScore[t] > triangleScore[best]) best = t;
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+    const size_t NONE = static_cast<size_t>(-1);
+
+    while (output.size() < indices.size()) {
+        if (best == NONE) {
+            // Nothing in the cache has work left; restart from the next untouched triangle
+            while (emitted[scanCursor]) ++scanCursor;
+            best = scanCursor;
+        }
+
+        const uint32_t* triangle = &indices[best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[best] = true;
+
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = triangle[k];
+            uint32_t* begin = &adjacency[offsets[v]];
+            uint32_t* last = begin + remaining[v] - 1;
+            std::iter_swap(std::find(begin, last + 1, static_cast<uint32_t>(best)), last);
+            remaining[v]--;
+        }
+
+        // Drawn vertices move to the front, everything else shifts back and may fall out
+        nextCache.assign(triangle, triangle + 3);
+        for (uint32_t v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) nextCache.push_back(v);
+        }
+        for (size_t i = FORSYTH_CACHE_SIZE; i < nextCache.size(); ++i) cachePosition[nextCache[i]] = -1;
+        if (nextCache.size() > FORSYTH_CACHE_SIZE) {
+            for (size_t i = FORSYTH_CACHE_SIZE; i < nextCache.size(); ++i) {
+                vertexScore[nextCache[i]] = ForsythVertexScore(-1, remaining[nextCache[i]]);
+            }
+        }
+        nextCache.resize(std::min<size_t>(nextCache.size(), FORSYTH_CACHE_SIZE));
+        cache.swap(nextCache);
+        for (size_t i = 0; i < cache.size(); ++i) {
+            cachePosition[cache[i]] = static_cast<int>(i);
+            vertexScore[cache[i]] = ForsythVertexScore(static_cast<int>(i), remaining[cache[i]]);
+        }
+
+        best = NONE;
+        float bestScore = -1.0f;
+        for (uint32_t v : cache) {
+            for (uint32_t a = offsets[v], e = offsets[v] + remaining[v]; a < e; ++a) {
+                uint32_t t = adjacency[a];
+                float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                triangleScore[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+void MeshImporter::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) return;
+
+    // Hard boundaries: triangles missing the cache on all three vertices start a new cluster anyway
+    std::vector<size_t> hard;
+    {
+        CacheSimulator cache(vertices.size(), SIMULATED_CACHE_SIZE);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            unsigned misses = cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+            if (t == 0 || misses == 3) hard.push_back(t);
+        }
+        hard.push_back(triangleCount);
+    }
+
+    // Soft boundaries: split a cluster once its running ACMR is within threshold of the whole
+    // cluster's; the split costs a cache flush but gives the sort finer pieces to move
+    std::vector<size_t> clusters;
+    for (size_t c = 0; c + 1 < hard.size(); ++c) {
+        size_t start = hard[c], end = hard[c + 1];
+        CacheSimulator cache(vertices.size(), SIMULATED_CACHE_SIZE);
+        unsigned totalMisses = 0;
+        for (size_t t = start; t < end; ++t) {
+            totalMisses += cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+        }
+        float clusterACMR = float(totalMisses) / float(end - start);
+
+        cache.Flush();
+        clusters.push_back(start);
+        unsigned misses = 0;
+        size_t clusterStart = start;
+        for (size_t t = start; t < end; ++t) {
+            misses += cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+            if (t + 1 < end && float(misses) / float(t + 1 - clusterStart) <= threshold * clusterACMR) {
+                clusters.push_back(t + 1);
+                clusterStart = t + 1;
+                misses = 0;
+                cache.Flush();
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // Sort clusters outside-in: those facing away from the mesh centre are drawn first
+    struct Cluster {
+        size_t start, end;
+        XMFLOAT3 centroid, normal;
+        float sortKey;
+    };
+    std::vector<Cluster> sorted;
+    XMFLOAT3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+        Cluster cluster = { clusters[c], clusters[c + 1], { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, 0.0f };
+        float area = 0.0f;
+        for (size_t t = cluster.start; t < cluster.end; ++t) {
+            const XMFLOAT3& p0 = vertices[indices[t * 3]].position;
+            const XMFLOAT3& p1 = vertices[indices[t * 3 + 1]].position;
+            const XMFLOAT3& p2 = vertices[indices[t * 3 + 2]].position;
+            XMFLOAT3 normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+            float triangleArea = std::sqrt(Dot(normal, normal));
+            cluster.normal = { cluster.normal.x + normal.x, cluster.normal.y + normal.y, cluster.normal.z + normal.z };
+            cluster.centroid.x += (p0.x + p1.x + p2.x) * triangleArea / 3.0f;
+            cluster.centroid.y += (p0.y + p1.y + p2.y) * triangleArea / 3.0f;
+            cluster.centroid.z += (p0.z + p1.z + p2.z) * triangleArea / 3.0f;
+            area += triangleArea;
+        }
+        meshCentroid = { meshCentroid.x + cluster.centroid.x, meshCentroid.y + cluster.centroid.y, meshCentroid.z + cluster.centroid.z };
+        meshArea += area;
+        if (area > 0.0f) cluster.centroid = { cluster.centroid.x / area, cluster.centroid.y / area, cluster.centroid.z / area };
+        cluster.normal = Normalize(cluster.normal, { 0.0f, 0.0f, 0.0f });
+        sorted.push_back(cluster);
+    }
+    if (meshArea > 0.0f) meshCentroid = { meshCentroid.x / meshArea, meshCentroid.y / meshArea, meshCentroid.z / meshArea };
+
+    for (Cluster& cluster : sorted) {
+        cluster.sortKey = Dot(Subtract(cluster.centroid, meshCentroid), cluster.normal);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (const Cluster& cluster : sorted) {
+        output.insert(output.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+    }
+    indices.swap(output);
+}
+
+void MeshImporter::OptimizeVertexFetch(MeshData& mesh) {
+    const uint32_t UNUSED = ~0u;
+    std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(vertices);
+}
+
+float MeshImporter::ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return 0.0f;
+
+    CacheSimulator cache(vertexCount, cacheSize);
+    unsigned misses = 0;
+    for (uint32_t index : indices) misses += cache.Access(index);
+    return float(misses) / float(triangleCount);
+}
+
+void MeshImporter::GenerateNormals(MeshData& mesh) {
+    for (Vertex& vertex : mesh.vertices) vertex.normal = { 0.0f, 0.0f, 0.0f };
+
+    // Area-weighted face normals
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        Vertex& v0 = mesh.vertices[mesh.indices[i]];
+        Vertex& v1 = mesh.vertices[mesh.indices[i + 1]];
+        Vertex& v2 = mesh.vertices[mesh.indices[i + 2]];
+        XMFLOAT3 normal = Cross(Subtract(v1.position, v0.position), Subtract(v2.position, v0.position));
+        for (Vertex* v : { &v0, &v1, &v2 }) {
+            v->normal = { v->normal.x + normal.x, v->normal.y + normal.y, v->normal.z + normal.z };
+        }
+    }
+    for (Vertex& vertex : mesh.vertices) vertex.normal = Normalize(vertex.normal, { 0.0f, 1.0f, 0.0f });
+}
+
+void MeshImporter::GenerateTangents(MeshData& mesh) {
+    std::vector<XMFLOAT3> tangents(mesh.vertices.size(), { 0.0f, 0.0f, 0.0f });
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        uint32_t i0 = mesh.indices[i], i1 = mesh.indices[i + 1], i2 = mesh.indices[i + 2];
+        const Vertex& v0 = mesh.vertices[i0];
+        const Vertex& v1 = mesh.vertices[i1];
+        const Vertex& v2 = mesh.vertices[i2];
+
+        XMFLOAT3 edge1 = Subtract(v1.position, v0.position);
+        XMFLOAT3 edge2 = Subtract(v2.position, v0.position);
+        float du1 = v1.texCoord.x - v0.texCoord.x, dv1 = v1.texCoord.y - v0.texCoord.y;
+        float du2 = v2.texCoord.x - v0.texCoord.x, dv2 = v2.texCoord.y - v0.texCoord.y;
+        float determinant = du1 * dv2 - du2 * dv1;
+        if (std::fabs(determinant) < 1e-12f) continue;
+
+        float r = 1.0f / determinant;
+        XMFLOAT3 tangent = { (edge1.x * dv2 - edge2.x * dv1) * r, (edge1.y * dv2 - edge2.y * dv1) * r,
+                             (edge1.z * dv2 - edge2.z * dv1) * r };
+        for (uint32_t index : { i0, i1, i2 }) {
+            tangents[index] = { tangents[index].x + tangent.x, tangents[index].y + tangent.y, tangents[index].z + tangent.z };
+        }
+    }
+
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        const XMFLOAT3& n = mesh.vertices[i].normal;
+        // Gram-Schmidt against the normal; meshes without UVs get any perpendicular axis
+        XMFLOAT3 t = tangents[i];
+        float d = Dot(n, t);
+        t = { t.x - n.x * d, t.y - n.y * d, t.z - n.z * d };
+        XMFLOAT3 axis = std::fabs(n.x) < 0.9f ? XMFLOAT3{ 1.0f, 0.0f, 0.0f } : XMFLOAT3{ 0.0f, 1.0f, 0.0f };
+        mesh.vertices[i].tangent = Normalize(t, Normalize(Cross(axis, n), { 1.0f, 0.0f, 0.0f }));
+    }
+}
+
+void MeshImporter::ComputeBounds(MeshData& mesh) {
+    if (mesh.vertices.empty()) {
+        mesh.boundsMin = mesh.boundsMax = { 0.0f, 0.0f, 0.0f };
+        return;
+    }
+
+    mesh.boundsMin = mesh.boundsMax = mesh.vertices[0].position;
+    for (const Vertex& vertex : mesh.vertices) {
+        mesh.boundsMin = { std::min(mesh.boundsMin.x, vertex.position.x), std::min(mesh.boundsMin.y, vertex.position.y),
+                           std::min(mesh.boundsMin.z, vertex.position.z) };
+        mesh.boundsMax = { std::max(mesh.boundsMax.x, vertex.position.x), std::max(mesh.boundsMax.y, vertex.position.y),
+                           std::max(mesh.boundsMax.z, vertex.position.z) };
+    }
+}
+
+void MeshImporter::CompressVertices(const std::vector<Vertex>& vertices, const XMFLOAT3& boundsMin,
+                                    const XMFLOAT3& boundsMax, std::vector<CompressedVertex>& compressed) {
+    // Flat axes quantize to 0 and decode to the offset alone
+    auto inverseExtent = [](float minimum, float maximum) {
+        return maximum - minimum > 0.0f ? 1.0f / (maximum - minimum) : 0.0f;
+    };
+    XMFLOAT3 scale(inverseExtent(boundsMin.x, boundsMax.x), inverseExtent(boundsMin.y, boundsMax.y),
+                   inverseExtent(boundsMin.z, boundsMax.z));
+
+    compressed.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const Vertex& vertex = vertices[i];
+        CompressedVertex& packed = compressed[i];
+        packed.position[0] = QuantizeUnorm16((vertex.position.x - boundsMin.x) * scale.x);
+        packed.position[1] = QuantizeUnorm16((vertex.position.y - boundsMin.y) * scale.y);
+        packed.position[2] = QuantizeUnorm16((vertex.position.z - boundsMin.z) * scale.z);
+        packed.position[3] = 0;
+        EncodeOctahedral(vertex.normal, packed.normalTangent[0], packed.normalTangent[1]);
+        EncodeOctahedral(vertex.tangent, packed.normalTangent[2], packed.normalTangent[3]);
+        packed.texCoord[0] = PackedVector::XMConvertFloatToHalf(vertex.texCoord.x);
+        packed.texCoord[1] = PackedVector::XMConvertFloatToHalf(vertex.texCoord.y);
+    }
+}
+
+bool MeshImporter::WriteBinary(const std::string& filename, const MeshData& mesh, VertexFormat format) {
+    const bool shortIndices = mesh.vertices.size() <= 0xFFFF;
+    MeshFileHeader header = {};
+    header.magic = MeshFileHeader::MAGIC;
+    header.version = MeshFileHeader::VERSION;
+    header.vertexFormat = static_cast<uint32_t>(format);
+    header.vertexStride = Mesh::GetVertexStride(format);
+    header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    header.indexSize = shortIndices ? 2 : 4;
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    std::vector<MeshLod> lods = mesh.lods;
+    if (lods.empty()) lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f });
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    header.lodOffset = sizeof(MeshFileHeader);
+    header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+    header.meshletOffset = (header.lodOffset + header.lodCount * sizeof(MeshLod) + 15) & ~15u;
+    header.vertexOffset = (header.meshletOffset + header.meshletCount * sizeof(Meshlet) + 15) & ~15u;
+    header.indexOffset = header.vertexOffset + ((header.vertexCount * header.vertexStride + 15) & ~15u);
+    header.boundsMin = mesh.boundsMin;
+    header.boundsMax = mesh.boundsMax;
+
+    std::vector<char> data(header.indexOffset + static_cast<size_t>(header.indexCount) * header.indexSize, 0);
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + header.lodOffset, lods.data(), lods.size() * sizeof(MeshLod));
+    if (!mesh.meshlets.empty()) {
+        std::memcpy(data.data() + header.meshletOffset, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+    }
+    if (format == VertexFormat::Compressed) {
+        std::vector<CompressedVertex> compressed;
+        CompressVertices(mesh.vertices, mesh.boundsMin, mesh.boundsMax, compressed);
+        if (!compressed.empty()) {
+            std::memcpy(data.data() + header.vertexOffset, compressed.data(), compressed.size() * sizeof(CompressedVertex));
+        }
+    } else if (!mesh.vertices.empty()) {
+        std::memcpy(data.data() + header.vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+    }
+    if (shortIndices) {
+        uint16_t* indices = reinterpret_cast<uint16_t*>(data.data() + header.indexOffset);
+        for (size_t i = 0; i < mesh.indices.size(); ++i) indices[i] = static_cast<uint16_t>(mesh.indices[i]);
+    } else if (!mesh.indices.empty()) {
+        std::memcpy(data.data() + header.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    }
+
+    bool written = WriteFileAtomic(filename, [&](std::ostream& file) {
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    });
+    if (!written) {
+        Logger::Error("Failed to write mesh cache: " + filename);
+        return false;
+    }
+    return true;
+}
+
+std::string MeshImporter::GetCachePath(const std::string& sourceFile) {
+    return sourceFile + ".nmesh";
+}
+
+bool MeshImporter::IsCacheCurrent(const std::string& sourceFile) {
+    std::error_code error;
+    auto cacheTime = std::filesystem::last_write_time(GetCachePath(sourceFile), error);
+    if (error) return false;
+    auto sourceTime = std::filesystem::last_write_time(sourceFile, error);
+    return error || cacheTime >= sourceTime;
+}
+
+bool MeshImporter::BuildCache(const std::string& sourceFile, VertexFormat format) {
+    MeshFileHeader header;
+    if (IsCacheCurrent(sourceFile) && ReadCacheHeader(GetCachePath(sourceFile), header) &&
+        header.vertexFormat == static_cast<uint32_t>(format)) {
+        return true;
+    }
+
+    MeshData mesh;
+    if (!Import(sourceFile, mesh)) return false;
+
+    float acmrBefore = ComputeACMR(mesh.indices, mesh.vertices.size());
+    GenerateLods(mesh);
+    Optimize(mesh);
+    std::vector<uint32_t> fullDetail(mesh.indices.begin(), mesh.indices.begin() + mesh.lods[0].indexCount);
+    float acmrAfter = ComputeACMR(fullDetail, mesh.vertices.size());
+    BuildMeshlets(mesh);
+
+    std::string levels;
+    for (const MeshLod& lod : mesh.lods) {
+        levels += (levels.empty() ? "" : "/") + std::to_string(lod.indexCount / 3);
+    }
+    Logger::Info("Baked " + GetCachePath(sourceFile) + ": " + std::to_string(mesh.vertices.size()) + " vertices, " +
+                 levels + " triangles per LOD, " + std::to_string(mesh.meshlets.size()) + " meshlets, ACMR " +
+                 std::to_string(acmrBefore) + " -> " + std::to_string(acmrAfter));
+    return WriteBinary(GetCachePath(sourceFile), mesh, format);
+}
+
+} // namespace Nexus
@@ -0,0 +1,64 @@
+#include "MeshLodSelector.h"
+#include "Camera.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+MeshLodSelector::MeshLodSelector()
+    : cameraPosition_(0.0f, 0.0f, 0.0f)
+    , pixelsPerUnit_(0.0f)
+    , errorThreshold_(1.0f)
+    , hysteresis_(0.15f)
+    , lodBias_(1.0f)
+{
+}
+
+void MeshLodSelector::SetView(const Camera& camera, float viewportHeight) {
+    cameraPosition_ = camera.GetPosition();
+    // _22 of a perspective projection is cot(fovY / 2), the height scale at unit distance
+    float projectionScale = XMVectorGetY(camera.GetProjectionMatrix().r[1]);
+    pixelsPerUnit_ = projectionScale * viewportHeight * 0.5f;
+}
+
+float MeshLodSelector::ProjectError(const Mesh& mesh, FXMMATRIX world, float objectError) const {
+    const XMFLOAT3& boundsMin = mesh.GetBoundsMin();
+    const XMFLOAT3& boundsMax = mesh.GetBoundsMax();
+    XMVECTOR center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&boundsMin), XMLoadFloat3(&boundsMax)), 0.5f);
+    XMVECTOR halfExtent = XMVectorScale(XMVectorSubtract(XMLoadFloat3(&boundsMax), XMLoadFloat3(&boundsMin)), 0.5f);
+
+    // Largest axis scale of the transform, so non-uniformly scaled props stay conservative
+    float scale = std::max({ XMVectorGetX(XMVector3Length(world.r[0])),
+                             XMVectorGetX(XMVector3Length(world.r[1])),
+                             XMVectorGetX(XMVector3Length(world.r[2])) });
+    float radius = XMVectorGetX(XMVector3Length(halfExtent)) * scale;
+
+    XMVECTOR worldCenter = XMVector3Transform(center, world);
+    float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(worldCenter, XMLoadFloat3(&cameraPosition_))));
+
+    // Inside the bounding sphere everything is as close as it gets; treat it as full detail
+    float nearest = distance - radius;
+    if (nearest <= 0.0f) return objectError > 0.0f ? FLT_MAX : 0.0f;
+    return objectError * scale * pixelsPerUnit_ / nearest;
+}
+
+size_t MeshLodSelector::Select(const Mesh& mesh, FXMMATRIX world, size_t currentLod) const {
+    const std::vector<MeshLod>& lods = mesh.GetLods();
+    if (lods.size() < 2 || pixelsPerUnit_ <= 0.0f) return 0;
+
+    // Errors grow along the chain, so walk from fine to coarse and stop at the first miss.
+    // Levels at or finer than the current one get a looser threshold, coarser ones a tighter
+    size_t selected = 0;
+    for (size_t lod = 1; lod < lods.size(); ++lod) {
+        float threshold = errorThreshold_ * lodBias_ * (lod <= currentLod ? 1.0f + hysteresis_ : 1.0f - hysteresis_);
+        if (ProjectError(mesh, world, lods[lod].error) > threshold) break;
+        selected = lod;
+    }
+    return selected;
+}
+
+} // namespace Nexus
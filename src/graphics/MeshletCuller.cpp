@@ -0,0 +1,368 @@
+#include "MeshletCuller.h"
+#include "Mesh.h"
+#include "OcclusionCuller.h"
+#include "SceneBVH.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+// One group per meshlet: thread 0 decides visibility and reserves output space, then every
+// thread copies one triangle. The group count may span two dimensions for very large meshes
+const char* MESHLET_CULL_SHADER = R"(
+    cbuffer MeshletConstants : register(b0)
+    {
+        matrix World;
+        matrix PyramidViewProjection;
+        float4 FrustumPlanes[6];
+        float3 CameraPosition;
+        float RadiusScale;
+        float2 PyramidSize;
+        uint MipCount;
+        uint MeshletCount;
+        uint OutputOffset;
+        uint ArgumentsOffset;
+        uint ShortIndices;
+        uint UseHiZ;
+    };
+
+    ByteAddressBuffer Meshlets : register(t0);
+    ByteAddressBuffer Indices : register(t1);
+    Texture2D<float> HiZ : register(t2);
+    RWByteAddressBuffer OutputIndices : register(u0);
+    RWByteAddressBuffer DrawArguments : register(u1);
+
+    static const uint MESHLET_STRIDE = 48;
+    static const uint GROUPS_PER_ROW = 65535;
+
+    groupshared bool groupVisible;
+    groupshared uint groupBase;
+
+    uint LoadIndex(uint index)
+    {
+        if (ShortIndices) {
+            uint word = Indices.Load((index >> 1) * 4);
+            return (index & 1) ? (word >> 16) : (word & 0xFFFF);
+        }
+        return Indices.Load(index * 4);
+    }
+
+    // Same 2x2 texel footprint test as the instance occlusion pass, on the sphere's box
+    bool HiZVisible(float3 center, float radius)
+    {
+        float3 ndcMin = float3(1e30f, 1e30f, 1e30f);
+        float3 ndcMax = float3(-1e30f, -1e30f, -1e30f);
+        [unroll] for (uint c = 0; c < 8; ++c) {
+            float3 corner = center + radius * float3((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+            float4 clip = mul(float4(corner, 1.0f), PyramidViewProjection);
+            if (clip.w <= 0.0f) return true;
+            float3 ndc = clip.xyz / clip.w;
+            ndcMin = min(ndcMin, ndc);
+            ndcMax = max(ndcMax, ndc);
+        }
+
+        float2 uvMin = saturate(float2(ndcMin.x, -ndcMax.y) * 0.5f + 0.5f);
+        float2 uvMax = saturate(float2(ndcMax.x, -ndcMin.y) * 0.5f + 0.5f);
+        float2 extent = (uvMax - uvMin) * PyramidSize;
+        uint level = min((uint)ceil(log2(max(max(extent.x, extent.y), 1.0f))), MipCount - 1);
+        uint2 levelSize = max(uint2(PyramidSize) >> level, uint2(1, 1));
+        uint2 lo = min(uint2(uvMin * levelSize), levelSize - 1);
+        uint2 hi = min(uint2(uvMax * levelSize), levelSize - 1);
+
+        float occluder = max(max(HiZ.Load(int3(lo, level)), HiZ.Load(int3(hi.x, lo.y, level))),
+                             max(HiZ.Load(int3(lo.x, hi.y, level)), HiZ.Load(int3(hi, level))));
+        return ndcMin.z <= occluder;
+    }
+
+    [numthreads(128, 1, 1)]
+    void main(uint3 group : SV_GroupID, uint thread : SV_GroupIndex)
+    {
+        uint meshletIndex = group.y * GROUPS_PER_ROW + group.x;
+        uint4 bounds = Meshlets.Load4(meshletIndex * MESHLET_STRIDE);
+        uint4 cone = Meshlets.Load4(meshletIndex * MESHLET_STRIDE + 16);
+        uint2 range = Meshlets.Load2(meshletIndex * MESHLET_STRIDE + 32);
+
+        if (thread == 0) {
+            bool visible = meshletIndex < MeshletCount;
+            float3 center = mul(float4(asfloat(bounds.xyz), 1.0f), World).xyz;
+            float radius = asfloat(bounds.w) * RadiusScale;
+
+            [unroll] for (uint p = 0; p < 6; ++p) {
+                visible = visible && dot(FrustumPlanes[p].xyz, center) + FrustumPlanes[p].w >= -radius;
+            }
+
+            // Every triangle faces away when the view direction lies inside the widened cone
+            float3 axis = normalize(mul(asfloat(cone.xyz), (float3x3)World));
+            float3 view = center - CameraPosition;
+            visible = visible && dot(view, axis) < asfloat(cone.w) * length(view) + radius;
+
+            if (visible && UseHiZ) {
+                visible = HiZVisible(center, radius);
+            }
+
+            groupVisible = visible;
+            groupBase = 0;
+            if (visible) {
+                DrawArguments.InterlockedAdd(ArgumentsOffset, range.y * 3, groupBase);
+            }
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        if (groupVisible && thread < range.y) {
+            uint source = range.x + thread * 3;
+            uint destination = (OutputOffset + groupBase + thread * 3) * 4;
+            OutputIndices.Store3(destination, uint3(LoadIndex(source), LoadIndex(source + 1), LoadIndex(source + 2)));
+        }
+    }
+)";
+
+constexpr UINT GROUPS_PER_ROW = 65535;
+
+struct MeshletConstants {
+    DirectX::XMFLOAT4X4 world;
+    DirectX::XMFLOAT4X4 pyramidViewProjection;
+    DirectX::XMFLOAT4 frustumPlanes[Frustum::PLANE_COUNT];
+    DirectX::XMFLOAT3 cameraPosition;
+    float radiusScale;
+    float pyramidSize[2];
+    UINT mipCount;
+    UINT meshletCount;
+    UINT outputOffset;
+    UINT argumentsOffset;
+    UINT shortIndices;
+    UINT useHiZ;
+};
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3D11ComputeShader* CompileComputeShader(ID3D11Device* device, const char* source, const char* name) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", "cs_5_0", 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+
+    ID3D11ComputeShader* shader = nullptr;
+    hr = device->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &shader);
+    blob->Release();
+    return SUCCEEDED(hr) ? shader : nullptr;
+}
+
+template<typename T>
+void WriteConstants(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const T& data) {
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (SUCCEEDED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        std::memcpy(mapped.pData, &data, sizeof(T));
+        context->Unmap(buffer, 0);
+    }
+}
+}
+
+MeshletCuller::MeshletCuller()
+    : device_(nullptr)
+    , context_(nullptr)
+    , cullShader_(nullptr)
+    , cullConstants_(nullptr)
+    , indexBuffer_(nullptr)
+    , indexTarget_(nullptr)
+    , indexCapacity_(0)
+    , indicesThisFrame_(0)
+    , argumentsBuffer_(nullptr)
+    , argumentsTarget_(nullptr)
+    , drawsThisFrame_(0)
+{
+}
+
+MeshletCuller::~MeshletCuller() {
+    Shutdown();
+}
+
+bool MeshletCuller::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    if (!device || !context) return false;
+    device_ = device;
+    context_ = context;
+
+    if (device_->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0) {
+        Logger::Warning("Meshlet culling needs feature level 11_0 compute shaders");
+        return false;
+    }
+
+    cullShader_ = CompileComputeShader(device_, MESHLET_CULL_SHADER, "MeshletCull");
+    D3D11_BUFFER_DESC constantsDesc = {};
+    constantsDesc.Usage = D3D11_USAGE_DYNAMIC;
+    constantsDesc.ByteWidth = sizeof(MeshletConstants);
+    constantsDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constantsDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (!cullShader_ || FAILED(device_->CreateBuffer(&constantsDesc, nullptr, &cullConstants_))) {
+        Logger::Error("Failed to create meshlet culling shader");
+        Shutdown();
+        return false;
+    }
+
+    // Indirect argument records, initialized per draw and counted into by the cull shader
+    D3D11_BUFFER_DESC argumentsDesc = {};
+    argumentsDesc.Usage = D3D11_USAGE_DEFAULT;
+    argumentsDesc.ByteWidth = ARGUMENT_STRIDE * MAX_DRAWS_PER_FRAME;
+    argumentsDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+    argumentsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    if (FAILED(device_->CreateBuffer(&argumentsDesc, nullptr, &argumentsBuffer_))) {
+        Logger::Error("Failed to create meshlet argument buffer");
+        Shutdown();
+        return false;
+    }
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = argumentsDesc.ByteWidth / 4;
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+    if (FAILED(device_->CreateUnorderedAccessView(argumentsBuffer_, &uavDesc, &argumentsTarget_)) ||
+        !EnsureIndexCapacity(INITIAL_INDEX_CAPACITY)) {
+        Logger::Error("Failed to create meshlet culling buffers");
+        Shutdown();
+        return false;
+    }
+
+    Logger::Info("Meshlet culling initialized");
+    return true;
+}
+
+void MeshletCuller::Shutdown() {
+    SafeRelease(argumentsTarget_);
+    SafeRelease(argumentsBuffer_);
+    SafeRelease(indexTarget_);
+    SafeRelease(indexBuffer_);
+    indexCapacity_ = 0;
+    SafeRelease(cullConstants_);
+    SafeRelease(cullShader_);
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+bool MeshletCuller::EnsureIndexCapacity(UINT indexCount) {
+    if (indexBuffer_ && indexCount <= indexCapacity_) return true;
+
+    // Replacing the buffer would strand this frame's earlier draws in the old one
+    if (indexBuffer_ && indicesThisFrame_ > 0) return false;
+
+    UINT capacity = std::max(indexCount, indexCapacity_ * 2);
+    SafeRelease(indexTarget_);
+    SafeRelease(indexBuffer_);
+    indexCapacity_ = 0;
+
+    // Raw buffers may be both written by compute and read by the input assembler
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.ByteWidth = capacity * sizeof(uint32_t);
+    desc.BindFlags = D3D11_BIND_INDEX_BUFFER | D3D11_BIND_UNORDERED_ACCESS;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    if (FAILED(device_->CreateBuffer(&desc, nullptr, &indexBuffer_))) {
+        Logger::Error("Failed to create meshlet index buffer");
+        return false;
+    }
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = capacity;
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+    if (FAILED(device_->CreateUnorderedAccessView(indexBuffer_, &uavDesc, &indexTarget_))) {
+        SafeRelease(indexBuffer_);
+        return false;
+    }
+
+    indexCapacity_ = capacity;
+    return true;
+}
+
+void MeshletCuller::BeginFrame() {
+    stats_ = Stats();
+    indicesThisFrame_ = 0;
+    drawsThisFrame_ = 0;
+}
+
+bool MeshletCuller::Cull(const Mesh& mesh, DirectX::FXMMATRIX world, DirectX::CXMMATRIX viewProjection,
+                         const DirectX::XMFLOAT3& cameraPosition, const OcclusionCuller* occlusion, UINT& argumentsOffset) {
+    using namespace DirectX;
+    if (!cullShader_ || !mesh.HasMeshlets()) return false;
+
+    const std::vector<Meshlet>& meshlets = mesh.GetMeshlets();
+    const UINT meshletCount = static_cast<UINT>(meshlets.size());
+    const UINT indexCount = static_cast<UINT>(mesh.GetLods()[0].indexCount);
+    if (drawsThisFrame_ >= MAX_DRAWS_PER_FRAME || !EnsureIndexCapacity(indicesThisFrame_ + indexCount)) return false;
+
+    NEXUS_PROFILE_SCOPE("MeshletCuller::Cull");
+
+    const UINT outputOffset = indicesThisFrame_;
+    argumentsOffset = drawsThisFrame_ * ARGUMENT_STRIDE;
+    indicesThisFrame_ += indexCount;
+    ++drawsThisFrame_;
+
+    // IndexCount (counted by the shader), InstanceCount, StartIndex, BaseVertex, StartInstance
+    UINT arguments[5] = { 0, 1, outputOffset, 0, 0 };
+    D3D11_BOX region = { argumentsOffset, 0, 0, argumentsOffset + ARGUMENT_STRIDE, 1, 1 };
+    context_->UpdateSubresource(argumentsBuffer_, 0, &region, arguments, 0, 0);
+
+    // Sphere radii grow with the largest axis scale
+    XMFLOAT4X4 worldRows;
+    XMStoreFloat4x4(&worldRows, world);
+    float radiusScale = std::max({ XMVectorGetX(XMVector3Length(XMVectorSet(worldRows._11, worldRows._12, worldRows._13, 0.0f))),
+                                   XMVectorGetX(XMVector3Length(XMVectorSet(worldRows._21, worldRows._22, worldRows._23, 0.0f))),
+                                   XMVectorGetX(XMVector3Length(XMVectorSet(worldRows._31, worldRows._32, worldRows._33, 0.0f))) });
+
+    // HLSL reads constant buffer matrices column-major, so upload the transposes
+    Frustum frustum = Frustum::FromViewProjection(viewProjection);
+    MeshletConstants constants = {};
+    XMStoreFloat4x4(&constants.world, XMMatrixTranspose(world));
+    std::memcpy(constants.frustumPlanes, frustum.planes, sizeof(constants.frustumPlanes));
+    constants.cameraPosition = cameraPosition;
+    constants.radiusScale = radiusScale;
+    constants.meshletCount = meshletCount;
+    constants.outputOffset = outputOffset;
+    constants.argumentsOffset = argumentsOffset;
+    constants.shortIndices = mesh.GetIndexFormat() == DXGI_FORMAT_R16_UINT ? 1 : 0;
+
+    ID3D11ShaderResourceView* pyramid = nullptr;
+    if (occlusion && occlusion->HasPyramid()) {
+        pyramid = occlusion->GetPyramidView();
+        XMStoreFloat4x4(&constants.pyramidViewProjection,
+                        XMMatrixTranspose(XMLoadFloat4x4(&occlusion->GetPyramidViewProjection())));
+        constants.pyramidSize[0] = static_cast<float>(occlusion->GetPyramidWidth());
+        constants.pyramidSize[1] = static_cast<float>(occlusion->GetPyramidHeight());
+        constants.mipCount = occlusion->GetPyramidMipCount();
+        constants.useHiZ = 1;
+    }
+    WriteConstants(context_, cullConstants_, constants);
+
+    ID3D11ShaderResourceView* views[] = { mesh.GetMeshletView(), mesh.GetIndexView(), pyramid };
+    ID3D11UnorderedAccessView* targets[] = { indexTarget_, argumentsTarget_ };
+    context_->CSSetShader(cullShader_, nullptr, 0);
+    context_->CSSetConstantBuffers(0, 1, &cullConstants_);
+    context_->CSSetShaderResources(0, 3, views);
+    context_->CSSetUnorderedAccessViews(0, 2, targets, nullptr);
+    context_->Dispatch(std::min(meshletCount, GROUPS_PER_ROW), (meshletCount + GROUPS_PER_ROW - 1) / GROUPS_PER_ROW, 1);
+
+    // Both outputs are read by the input assembler next
+    ID3D11ShaderResourceView* nullViews[] = { nullptr, nullptr, nullptr };
+    ID3D11UnorderedAccessView* nullTargets[] = { nullptr, nullptr };
+    context_->CSSetShaderResources(0, 3, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 2, nullTargets, nullptr);
+    context_->CSSetShader(nullptr, nullptr, 0);
+
+    stats_.meshlets += meshletCount;
+    stats_.draws++;
+    return true;
+}
+
+} // namespace Nexus
@@ -0,0 +1,257 @@
+#include "MipGenerator.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// SSE2 is part of the x64 baseline, so these need no runtime dispatch
+#include <emmintrin.h>
+
+namespace Nexus {
+
+namespace {
+
+const int SRGB_ENCODE_STEPS = 16384;
+const float PI = 3.14159265358979f;
+
+struct ColorTables {
+    float decode[256];                        // sRGB byte to linear
+    uint8_t encode[SRGB_ENCODE_STEPS + 1];    // Linear in 1/16384 steps to sRGB byte
+};
+
+// 1/16384 steps keep the steep end of the sRGB curve within a tenth of a code
+const ColorTables& GetColorTables() {
+    static const ColorTables tables = [] {
+        ColorTables result;
+        for (int i = 0; i < 256; ++i) {
+            const float value = i / 255.0f;
+            result.decode[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i <= SRGB_ENCODE_STEPS; ++i) {
+            const float value = static_cast<float>(i) / SRGB_ENCODE_STEPS;
+            const float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            result.encode[i] = static_cast<uint8_t>(std::min(255.0f, encoded * 255.0f + 0.5f));
+        }
+        return result;
+    }();
+    return tables;
+}
+
+// Taps of a 1D resampling filter: output sample i reads taps first[i] up to first[i + 1]
+struct Kernel {
+    std::vector<size_t> first;
+    std::vector<int> index;
+    std::vector<float> weight;
+};
+
+float Sinc(float x) {
+    if (std::fabs(x) < 1e-6f) return 1.0f;
+    x *= PI;
+    return std::sin(x) / x;
+}
+
+// Sample i of the output covers [i * scale, (i + 1) * scale) of the source. Box weights are the
+// covered fraction of each source texel; Lanczos3 is stretched by scale. Taps past either edge
+// are clamped onto it
+Kernel BuildKernel(int sourceSize, int size, MipGenerator::Filter filter) {
+    const float scale = static_cast<float>(sourceSize) / size;
+    const float radius = filter == MipGenerator::Filter::Box ? 0.5f * scale : 3.0f * scale;
+
+    Kernel kernel;
+    kernel.first.reserve(size + 1);
+    for (int i = 0; i < size; ++i) {
+        kernel.first.push_back(kernel.index.size());
+        const float center = (i + 0.5f) * scale;
+        const int begin = static_cast<int>(std::floor(center - radius));
+        const int end = static_cast<int>(std::ceil(center + radius));
+
+        float total = 0.0f;
+        for (int source = begin; source < end; ++source) {
+            float weight;
+            if (filter == MipGenerator::Filter::Box) {
+                weight = std::min(source + 1.0f, center + radius) - std::max(static_cast<float>(source), center - radius);
+            } else {
+                const float t = (source + 0.5f - center) / scale;
+                weight = std::fabs(t) < 3.0f ? Sinc(t) * Sinc(t / 3.0f) : 0.0f;
+            }
+            if (std::fabs(weight) < 1e-6f) continue;
+            kernel.index.push_back(std::clamp(source, 0, sourceSize - 1));
+            kernel.weight.push_back(weight);
+            total += weight;
+        }
+        for (size_t tap = kernel.first.back(); tap < kernel.weight.size(); ++tap) {
+            kernel.weight[tap] /= total;
+        }
+    }
+    kernel.first.push_back(kernel.index.size());
+    return kernel;
+}
+
+void DecodeRow(const uint8_t* pixels, int width, bool srgb, float* output) {
+    const float* decode = GetColorTables().decode;
+    const __m128 normalize = _mm_set1_ps(1.0f / 255.0f);
+    const __m128i zero = _mm_setzero_si128();
+    for (int x = 0; x < width; ++x, pixels += 4, output += 4) {
+        if (srgb) {
+            _mm_storeu_ps(output, _mm_set_ps(pixels[3] / 255.0f, decode[pixels[2]], decode[pixels[1]], decode[pixels[0]]));
+        } else {
+            int32_t packed;
+            std::memcpy(&packed, pixels, 4);
+            const __m128i bytes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+            _mm_storeu_ps(output, _mm_mul_ps(_mm_cvtepi32_ps(bytes), normalize));
+        }
+    }
+}
+
+// One RGBA pixel per SSE register, accumulated over the kernel's taps
+void FilterRow(const float* source, const Kernel& kernel, int width, float* output) {
+    for (int x = 0; x < width; ++x) {
+        __m128 sum = _mm_setzero_ps();
+        for (size_t tap = kernel.first[x]; tap < kernel.first[x + 1]; ++tap) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weight[tap]), _mm_loadu_ps(source + kernel.index[tap] * 4)));
+        }
+        _mm_storeu_ps(output + x * 4, sum);
+    }
+}
+
+// Decodes each texel to a [-1, 1] vector, normalizes it and encodes it back. Alpha is untouched
+void RenormalizeRow(float* row, int width) {
+    const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (int x = 0; x < width; ++x, row += 4) {
+        const __m128 texel = _mm_loadu_ps(row);
+        const __m128 normal = _mm_sub_ps(_mm_mul_ps(texel, two), one);
+        alignas(16) float squared[4];
+        _mm_store_ps(squared, _mm_mul_ps(normal, normal));
+        const float length = squared[0] + squared[1] + squared[2];
+        if (length < 1e-12f) continue;
+
+        const __m128 unit = _mm_mul_ps(normal, _mm_set1_ps(1.0f / std::sqrt(length)));
+        const __m128 encoded = _mm_add_ps(_mm_mul_ps(unit, half), half);
+        _mm_storeu_ps(row, _mm_or_ps(_mm_and_ps(rgbMask, encoded), _mm_andnot_ps(rgbMask, texel)));
+    }
+}
+
+void EncodeRow(const float* row, int width, bool srgb, uint8_t* output) {
+    const uint8_t* encode = GetColorTables().encode;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 byteScale = _mm_set1_ps(255.0f);
+    const __m128 tableScale = _mm_set1_ps(static_cast<float>(SRGB_ENCODE_STEPS));
+    for (int x = 0; x < width; ++x, row += 4, output += 4) {
+        // Lanczos lobes can overshoot the representable range
+        const __m128 texel = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(row), zero), one);
+        const __m128i quantized = _mm_cvtps_epi32(_mm_mul_ps(texel, byteScale));
+        const int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(quantized, quantized), quantized));
+        std::memcpy(output, &packed, 4);
+        if (srgb) {
+            alignas(16) int32_t steps[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(steps), _mm_cvtps_epi32(_mm_mul_ps(texel, tableScale)));
+            output[0] = encode[steps[0]];
+            output[1] = encode[steps[1]];
+            output[2] = encode[steps[2]];
+        }
+    }
+}
+
+} // namespace
+
+int MipGenerator::GetMipCount(int width, int height) {
+    int count = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2) ++count;
+    return count;
+}
+
+bool MipGenerator::Generate(const uint8_t* pixels, int width, int height, const Settings& settings,
+                            std::vector<uint8_t>& data, std::vector<Level>& levels, JobSystem* jobs) {
+    NEXUS_PROFILE_SCOPE("MipGenerator::Generate");
+    data.clear();
+    levels.clear();
+    if (!pixels || width <= 0 || height <= 0) return false;
+
+    // Lay every level out up front so the output is a single allocation
+    size_t total = 0;
+    for (int mipWidth = width, mipHeight = height; mipWidth > 1 || mipHeight > 1;) {
+        mipWidth = std::max(1, mipWidth / 2);
+        mipHeight = std::max(1, mipHeight / 2);
+        levels.push_back({ mipWidth, mipHeight, total });
+        total += static_cast<size_t>(mipWidth) * mipHeight * 4;
+    }
+    data.resize(total);
+
+    // Normal maps hold vectors, never gamma-encoded colour
+    const bool srgb = settings.srgb && !settings.normalMap;
+    GetColorTables();
+
+    // Full-precision copies of the level being read and the level being written. The base is
+    // decoded row by row as strips need it, so it is never held as floats
+    std::vector<float> source, destination;
+    int sourceWidth = width, sourceHeight = height;
+    for (size_t l = 0; l < levels.size(); ++l) {
+        const Level& level = levels[l];
+        const bool last = l + 1 == levels.size();
+        if (!last) destination.resize(static_cast<size_t>(level.width) * level.height * 4);
+
+        const Kernel horizontal = BuildKernel(sourceWidth, level.width, settings.filter);
+        const Kernel vertical = BuildKernel(sourceHeight, level.height, settings.filter);
+        const size_t rowFloats = static_cast<size_t>(level.width) * 4;
+
+        // Each strip filters the source rows its output rows touch horizontally, then resolves
+        // its output rows vertically from that, so strips share no intermediate state
+        auto filterStrip = [&](size_t begin, size_t end) {
+            int firstRow = sourceHeight, lastRow = 0;
+            for (size_t tap = vertical.first[begin]; tap < vertical.first[end]; ++tap) {
+                firstRow = std::min(firstRow, vertical.index[tap]);
+                lastRow = std::max(lastRow, vertical.index[tap]);
+            }
+
+            std::vector<float> strip((lastRow - firstRow + 1) * rowFloats);
+            std::vector<float> decoded(l == 0 ? static_cast<size_t>(sourceWidth) * 4 : 0);
+            for (int y = firstRow; y <= lastRow; ++y) {
+                const float* row;
+                if (l == 0) {
+                    DecodeRow(pixels + static_cast<size_t>(y) * sourceWidth * 4, sourceWidth, srgb, decoded.data());
+                    row = decoded.data();
+                } else {
+                    row = source.data() + static_cast<size_t>(y) * sourceWidth * 4;
+                }
+                FilterRow(row, horizontal, level.width, strip.data() + (y - firstRow) * rowFloats);
+            }
+
+            std::vector<float> row(rowFloats);
+            for (size_t y = begin; y < end; ++y) {
+                std::fill(row.begin(), row.end(), 0.0f);
+                for (size_t tap = vertical.first[y]; tap < vertical.first[y + 1]; ++tap) {
+                    const __m128 weight = _mm_set1_ps(vertical.weight[tap]);
+                    const float* input = strip.data() + (vertical.index[tap] - firstRow) * rowFloats;
+                    for (size_t i = 0; i < rowFloats; i += 4) {
+                        _mm_storeu_ps(&row[i], _mm_add_ps(_mm_loadu_ps(&row[i]), _mm_mul_ps(weight, _mm_loadu_ps(input + i))));
+                    }
+                }
+
+                // The renormalized vectors feed the next level too, so lengths never drift
+                if (settings.normalMap) RenormalizeRow(row.data(), level.width);
+                if (!last) std::copy(row.begin(), row.end(), destination.begin() + y * rowFloats);
+                EncodeRow(row.data(), level.width, srgb, data.data() + level.offset + y * level.width * 4);
+            }
+        };
+
+        if (jobs && jobs->IsInitialized() && level.height > 1) {
+            // Strips of at least 16 rows keep the overlap between neighbouring strips small
+            const size_t grain = std::max<size_t>(16, 32768 / level.width);
+            jobs->ParallelFor(level.height, grain, filterStrip);
+        } else {
+            filterStrip(0, level.height);
+        }
+
+        source.swap(destination);
+        sourceWidth = level.width;
+        sourceHeight = level.height;
+    }
+    return true;
+}
+
+} // namespace Nexus
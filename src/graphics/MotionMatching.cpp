@@ -0,0 +1,310 @@
+#include "MotionMatching.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+// Deep enough for any tree: each level leaves at most one sibling pending
+constexpr int MAX_SEARCH_DEPTH = 64;
+
+float HorizontalSum(__m128 v) {
+    __m128 high = _mm_movehl_ps(v, v);
+    __m128 sum = _mm_add_ps(v, high);
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+// Squared distance between two rows, or FLT_MAX once it passes limit. Checked every sixteen
+// features so the early out does not cost more than it saves
+float RowDistance(const float* a, const float* b, size_t stride, float limit) {
+    __m128 sum = _mm_setzero_ps();
+    for (size_t i = 0; i < stride; i += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        sum = _mm_add_ps(sum, _mm_mul_ps(d, d));
+        if ((i & 15) == 12 && HorizontalSum(sum) >= limit) return FLT_MAX;
+    }
+    return HorizontalSum(sum);
+}
+
+// Squared distance from the query to the nearest point of a node's bounds
+float BoundsDistance(const float* query, const float* lo, const float* hi, size_t stride, float limit) {
+    const __m128 zero = _mm_setzero_ps();
+    __m128 sum = zero;
+    for (size_t i = 0; i < stride; i += 4) {
+        __m128 q = _mm_loadu_ps(query + i);
+        __m128 below = _mm_sub_ps(_mm_loadu_ps(lo + i), q);
+        __m128 above = _mm_sub_ps(q, _mm_loadu_ps(hi + i));
+        __m128 d = _mm_max_ps(_mm_max_ps(below, above), zero);
+        sum = _mm_add_ps(sum, _mm_mul_ps(d, d));
+        if ((i & 15) == 12 && HorizontalSum(sum) >= limit) return FLT_MAX;
+    }
+    return HorizontalSum(sum);
+}
+}
+
+MotionDatabase::MotionDatabase()
+    : trajectoryPoints_(0)
+    , posePoints_(0)
+    , hasVelocity_(false)
+    , featureCount_(0)
+    , stride_(0)
+{
+}
+
+void MotionDatabase::Clear() {
+    offsets_.clear();
+    scales_.clear();
+    features_.clear();
+    frames_.clear();
+    nodes_.clear();
+    boundsMin_.clear();
+    boundsMax_.clear();
+    featureCount_ = 0;
+    stride_ = 0;
+}
+
+bool MotionDatabase::Build(const std::vector<std::vector<XMFLOAT3>>& trajectories,
+                           const std::vector<std::vector<XMFLOAT3>>& poses,
+                           const std::vector<XMFLOAT3>& velocities, const MotionMatchingSettings& settings) {
+    NEXUS_PROFILE_SCOPE("MotionDatabase::Build");
+    Clear();
+    settings_ = settings;
+
+    const size_t frameCount = trajectories.size();
+    if (frameCount == 0 || poses.size() != frameCount || (!velocities.empty() && velocities.size() != frameCount)) {
+        Logger::Warning("MotionDatabase::Build - Trajectory, pose and velocity data must cover the same frames");
+        return false;
+    }
+
+    trajectoryPoints_ = trajectories[0].size();
+    posePoints_ = poses[0].size();
+    hasVelocity_ = !velocities.empty();
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        if (trajectories[frame].size() != trajectoryPoints_ || poses[frame].size() != posePoints_) {
+            Logger::Warning("MotionDatabase::Build - Frame " + std::to_string(frame) + " has a different feature layout");
+            return false;
+        }
+    }
+
+    featureCount_ = (trajectoryPoints_ + posePoints_ + (hasVelocity_ ? 1 : 0)) * 3;
+    stride_ = (featureCount_ + 3) & ~size_t(3);
+    if (featureCount_ == 0) {
+        Logger::Warning("MotionDatabase::Build - Frames have no features");
+        return false;
+    }
+
+    // Flatten, padding stays zero so it never adds to a distance
+    std::vector<float> rows(frameCount * stride_, 0.0f);
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        float* row = &rows[frame * stride_];
+        for (const XMFLOAT3& point : trajectories[frame]) { *row++ = point.x; *row++ = point.y; *row++ = point.z; }
+        for (const XMFLOAT3& point : poses[frame]) { *row++ = point.x; *row++ = point.y; *row++ = point.z; }
+        if (hasVelocity_) { *row++ = velocities[frame].x; *row++ = velocities[frame].y; *row++ = velocities[frame].z; }
+    }
+
+    // Center every feature, then scale each group by its weight over the group's deviation so a
+    // group's influence does not depend on its units or on how many points it has
+    offsets_.assign(stride_, 0.0f);
+    scales_.assign(stride_, 0.0f);
+    for (size_t f = 0; f < featureCount_; ++f) {
+        double sum = 0.0;
+        for (size_t frame = 0; frame < frameCount; ++frame) sum += rows[frame * stride_ + f];
+        offsets_[f] = static_cast<float>(sum / frameCount);
+    }
+
+    const size_t groupEnds[3] = { trajectoryPoints_ * 3, (trajectoryPoints_ + posePoints_) * 3, featureCount_ };
+    const float groupWeights[3] = { settings_.trajectoryWeight, settings_.poseWeight, settings_.velocityWeight };
+    size_t groupBegin = 0;
+    for (int group = 0; group < 3; ++group) {
+        const size_t groupEnd = groupEnds[group];
+        if (groupEnd == groupBegin) continue;
+
+        double variance = 0.0;
+        for (size_t f = groupBegin; f < groupEnd; ++f) {
+            for (size_t frame = 0; frame < frameCount; ++frame) {
+                double d = rows[frame * stride_ + f] - offsets_[f];
+                variance += d * d;
+            }
+        }
+        variance /= double(frameCount) * double(groupEnd - groupBegin);
+        const float deviation = std::max(static_cast<float>(std::sqrt(variance)), 1e-6f);
+        for (size_t f = groupBegin; f < groupEnd; ++f) {
+            scales_[f] = groupWeights[group] / deviation;
+        }
+        groupBegin = groupEnd;
+    }
+
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        float* row = &rows[frame * stride_];
+        for (size_t f = 0; f < featureCount_; ++f) {
+            row[f] = (row[f] - offsets_[f]) * scales_[f];
+        }
+    }
+
+    frames_.resize(frameCount);
+    std::iota(frames_.begin(), frames_.end(), 0u);
+    nodes_.reserve(2 * (frameCount / LEAF_SIZE + 1));
+    BuildNode(rows, 0, static_cast<uint32_t>(frameCount));
+
+    // Rows in leaf order, so a leaf scans contiguous memory
+    features_.resize(frameCount * stride_);
+    for (size_t i = 0; i < frameCount; ++i) {
+        std::copy_n(&rows[size_t(frames_[i]) * stride_], stride_, &features_[i * stride_]);
+    }
+
+    Logger::Info("Built motion matching database: " + std::to_string(frameCount) + " frames, " +
+                 std::to_string(featureCount_) + " features, " + std::to_string(nodes_.size()) + " nodes");
+    return true;
+}
+
+uint32_t MotionDatabase::BuildNode(const std::vector<float>& rows, uint32_t first, uint32_t count) {
+    const uint32_t nodeIndex = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back({ first, count, 0, 0 });
+    boundsMin_.resize(boundsMin_.size() + stride_, FLT_MAX);
+    boundsMax_.resize(boundsMax_.size() + stride_, -FLT_MAX);
+
+    float* lo = &boundsMin_[nodeIndex * stride_];
+    float* hi = &boundsMax_[nodeIndex * stride_];
+    for (uint32_t i = first; i < first + count; ++i) {
+        const float* row = &rows[size_t(frames_[i]) * stride_];
+        for (size_t f = 0; f < stride_; ++f) {
+            lo[f] = std::min(lo[f], row[f]);
+            hi[f] = std::max(hi[f], row[f]);
+        }
+    }
+    if (count <= LEAF_SIZE) return nodeIndex;
+
+    // Median split on the widest feature
+    size_t axis = 0;
+    float widest = 0.0f;
+    for (size_t f = 0; f < featureCount_; ++f) {
+        if (hi[f] - lo[f] > widest) {
+            widest = hi[f] - lo[f];
+            axis = f;
+        }
+    }
+    if (widest <= 0.0f) return nodeIndex;   // Identical frames, nothing to split
+
+    const uint32_t half = count / 2;
+    std::nth_element(frames_.begin() + first, frames_.begin() + first + half, frames_.begin() + first + count,
+                     [&rows, axis, this](uint32_t a, uint32_t b) {
+                         return rows[size_t(a) * stride_ + axis] < rows[size_t(b) * stride_ + axis];
+                     });
+
+    // Children push onto nodes_ and the bounds, so index rather than hold references
+    const uint32_t left = BuildNode(rows, first, half);
+    const uint32_t right = BuildNode(rows, first + half, count - half);
+    nodes_[nodeIndex].count = 0;
+    nodes_[nodeIndex].left = left;
+    nodes_[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+void MotionDatabase::NormalizeQuery(const std::vector<XMFLOAT3>& trajectory, const std::vector<XMFLOAT3>& pose,
+                                    const XMFLOAT3& velocity, std::vector<float>& query) const {
+    // Points the query lacks sit at the database mean and cost nothing
+    query.assign(stride_, 0.0f);
+    size_t f = 0;
+    auto append = [&](const std::vector<XMFLOAT3>& points, size_t expected) {
+        for (size_t i = 0; i < expected; ++i, f += 3) {
+            if (i >= points.size()) continue;
+            query[f] = (points[i].x - offsets_[f]) * scales_[f];
+            query[f + 1] = (points[i].y - offsets_[f + 1]) * scales_[f + 1];
+            query[f + 2] = (points[i].z - offsets_[f + 2]) * scales_[f + 2];
+        }
+    };
+    append(trajectory, trajectoryPoints_);
+    append(pose, posePoints_);
+    if (hasVelocity_) {
+        query[f] = (velocity.x - offsets_[f]) * scales_[f];
+        query[f + 1] = (velocity.y - offsets_[f + 1]) * scales_[f + 1];
+        query[f + 2] = (velocity.z - offsets_[f + 2]) * scales_[f + 2];
+    }
+}
+
+uint32_t MotionDatabase::Search(const float* query, float& cost) const {
+    struct Pending {
+        uint32_t node;
+        float bound;
+    };
+
+    uint32_t bestRow = INVALID_FRAME;
+    float bestCost = FLT_MAX;
+
+    Pending stack[MAX_SEARCH_DEPTH];
+    int depth = 0;
+    stack[depth++] = { 0, 0.0f };
+    while (depth > 0) {
+        const Pending pending = stack[--depth];
+        if (pending.bound >= bestCost) continue;
+
+        const Node& node = nodes_[pending.node];
+        if (node.count > 0) {
+            for (uint32_t row = node.first; row < node.first + node.count; ++row) {
+                float distance = RowDistance(query, &features_[size_t(row) * stride_], stride_, bestCost);
+                if (distance < bestCost) {
+                    bestCost = distance;
+                    bestRow = row;
+                }
+            }
+            continue;
+        }
+
+        float leftBound = BoundsDistance(query, &boundsMin_[size_t(node.left) * stride_],
+                                         &boundsMax_[size_t(node.left) * stride_], stride_, bestCost);
+        float rightBound = BoundsDistance(query, &boundsMin_[size_t(node.right) * stride_],
+                                          &boundsMax_[size_t(node.right) * stride_], stride_, bestCost);
+
+        // Nearer child on top so it tightens bestCost before the other is considered
+        Pending nearer = { node.left, leftBound };
+        Pending further = { node.right, rightBound };
+        if (rightBound < leftBound) std::swap(nearer, further);
+        if (further.bound < bestCost && depth < MAX_SEARCH_DEPTH) stack[depth++] = further;
+        if (nearer.bound < bestCost && depth < MAX_SEARCH_DEPTH) stack[depth++] = nearer;
+    }
+
+    cost = bestCost;
+    return bestRow == INVALID_FRAME ? INVALID_FRAME : frames_[bestRow];
+}
+
+uint32_t MotionDatabase::FindBestMatch(const std::vector<XMFLOAT3>& trajectory, const std::vector<XMFLOAT3>& pose,
+                                       const XMFLOAT3& velocity, float* cost) const {
+    if (nodes_.empty()) return INVALID_FRAME;
+
+    std::vector<float> query;
+    NormalizeQuery(trajectory, pose, velocity, query);
+    float bestCost = FLT_MAX;
+    uint32_t frame = Search(query.data(), bestCost);
+    if (cost) *cost = bestCost;
+    return frame;
+}
+
+bool MotionDatabase::Update(MotionMatchState& state, float deltaTime, const std::vector<XMFLOAT3>& trajectory,
+                            const std::vector<XMFLOAT3>& pose, const XMFLOAT3& velocity) const {
+    if (nodes_.empty()) return false;
+
+    state.timeSinceSearch += deltaTime;
+    const bool due = state.timeSinceSearch >= settings_.searchInterval;
+    if (state.frame != INVALID_FRAME && !due) return false;
+
+    // Keep the phase so staggered characters stay staggered
+    if (due) {
+        state.timeSinceSearch = settings_.searchInterval > 0.0f
+            ? std::fmod(state.timeSinceSearch, settings_.searchInterval) : 0.0f;
+    }
+
+    NormalizeQuery(trajectory, pose, velocity, state.query);
+    state.frame = Search(state.query.data(), state.cost);
+    return true;
+}
+
+} // namespace Nexus
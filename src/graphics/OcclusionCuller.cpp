@@ -0,0 +1,523 @@
+#include "OcclusionCuller.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+// Reduces the source level into the destination, farthest depth in x for culling and nearest in
+// y for ray marching; the last row/column of an odd-sized source is folded into the final
+// destination texel so no depth sample is ever skipped
+const char* DOWNSAMPLE_SHADER = R"(
+    cbuffer DownsampleConstants : register(b0)
+    {
+        uint2 SourceSize;
+        uint2 DestinationSize;
+        uint FromDepth;                // The source is the single-channel depth buffer
+        uint3 Padding;
+    };
+
+    Texture2D<float2> Source : register(t0);
+    RWTexture2D<float2> Destination : register(u0);
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= DestinationSize)) return;
+
+        uint2 base = id.xy * 2;
+        uint2 span = uint2(2, 2);
+        if (id.x == DestinationSize.x - 1 && (SourceSize.x & 1)) span.x = 3;
+        if (id.y == DestinationSize.y - 1 && (SourceSize.y & 1)) span.y = 3;
+
+        float2 depth = float2(0.0f, 1.0f);
+        for (uint y = 0; y < span.y; ++y) {
+            for (uint x = 0; x < span.x; ++x) {
+                uint2 texel = min(base + uint2(x, y), SourceSize - 1);
+                float2 range = Source.Load(int3(texel, 0));
+                if (FromDepth) range.y = range.x;
+                depth = float2(max(depth.x, range.x), min(depth.y, range.y));
+            }
+        }
+        Destination[id.xy] = depth;
+    }
+)";
+
+const char* CULL_SHADER = R"(
+    cbuffer CullConstants : register(b0)
+    {
+        matrix ViewProjection;
+        float2 PyramidSize;
+        uint MipCount;
+        uint FirstInstance;
+        uint InstanceCount;
+        uint ArgumentsOffset;
+    };
+
+    ByteAddressBuffer Instances : register(t0);
+    Texture2D<float> HiZ : register(t1);
+    RWByteAddressBuffer VisibleInstances : register(u0);
+    RWByteAddressBuffer DrawArguments : register(u1);
+
+    static const uint STRIDE = 80;
+
+    [numthreads(64, 1, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (id.x >= InstanceCount) return;
+
+        uint source = (FirstInstance + id.x) * STRIDE;
+        uint4 raw[5];
+        [unroll] for (uint r = 0; r < 5; ++r) {
+            raw[r] = Instances.Load4(source + r * 16);
+        }
+        float4x4 world = float4x4(asfloat(raw[0]), asfloat(raw[1]), asfloat(raw[2]), asfloat(raw[3]));
+
+        // Screen rectangle and nearest depth of the instance's unit cube
+        float3 ndcMin = float3(1e30f, 1e30f, 1e30f);
+        float3 ndcMax = float3(-1e30f, -1e30f, -1e30f);
+        bool crossesNear = false;
+        [unroll] for (uint c = 0; c < 8; ++c) {
+            float3 corner = float3((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+            float4 clip = mul(mul(float4(corner, 1.0f), world), ViewProjection);
+            if (clip.w <= 0.0f) {
+                crossesNear = true;
+            } else {
+                float3 ndc = clip.xyz / clip.w;
+                ndcMin = min(ndcMin, ndc);
+                ndcMax = max(ndcMax, ndc);
+            }
+        }
+
+        bool visible = true;
+        if (!crossesNear) {
+            if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f || ndcMin.z > 1.0f) {
+                visible = false;
+            } else {
+                float2 uvMin = saturate(float2(ndcMin.x, -ndcMax.y) * 0.5f + 0.5f);
+                float2 uvMax = saturate(float2(ndcMax.x, -ndcMin.y) * 0.5f + 0.5f);
+
+                // Pick the level where the rectangle spans at most 2x2 texels
+                float2 extent = (uvMax - uvMin) * PyramidSize;
+                uint level = min((uint)ceil(log2(max(max(extent.x, extent.y), 1.0f))), MipCount - 1);
+                uint2 levelSize = max(uint2(PyramidSize) >> level, uint2(1, 1));
+                uint2 lo = min(uint2(uvMin * levelSize), levelSize - 1);
+                uint2 hi = min(uint2(uvMax * levelSize), levelSize - 1);
+
+                float occluder = max(max(HiZ.Load(int3(lo, level)), HiZ.Load(int3(hi.x, lo.y, level))),
+                                     max(HiZ.Load(int3(lo.x, hi.y, level)), HiZ.Load(int3(hi, level))));
+                visible = ndcMin.z <= occluder;
+            }
+        }
+
+        if (visible) {
+            uint slot;
+            DrawArguments.InterlockedAdd(ArgumentsOffset + 4, 1, slot);
+            uint destination = (FirstInstance + slot) * STRIDE;
+            [unroll] for (uint w = 0; w < 5; ++w) {
+                VisibleInstances.Store4(destination + w * 16, raw[w]);
+            }
+        }
+    }
+)";
+
+struct DownsampleConstants {
+    UINT sourceSize[2];
+    UINT destinationSize[2];
+    UINT fromDepth;
+    UINT padding[3];
+};
+
+struct CullConstants {
+    DirectX::XMFLOAT4X4 viewProjection;
+    float pyramidSize[2];
+    UINT mipCount;
+    UINT firstInstance;
+    UINT instanceCount;
+    UINT argumentsOffset;
+    UINT padding[2];
+};
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3D11ComputeShader* CompileComputeShader(ID3D11Device* device, const char* source, const char* name) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", "cs_5_0", 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+
+    ID3D11ComputeShader* shader = nullptr;
+    hr = device->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &shader);
+    blob->Release();
+    return SUCCEEDED(hr) ? shader : nullptr;
+}
+
+ID3D11Buffer* CreateConstantBuffer(ID3D11Device* device, UINT size) {
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = size;
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    ID3D11Buffer* buffer = nullptr;
+    return SUCCEEDED(device->CreateBuffer(&desc, nullptr, &buffer)) ? buffer : nullptr;
+}
+
+template<typename T>
+void WriteConstants(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const T& data) {
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (SUCCEEDED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        std::memcpy(mapped.pData, &data, sizeof(T));
+        context->Unmap(buffer, 0);
+    }
+}
+}
+
+OcclusionCuller::OcclusionCuller()
+    : device_(nullptr)
+    , context_(nullptr)
+    , downsampleShader_(nullptr)
+    , cullShader_(nullptr)
+    , downsampleConstants_(nullptr)
+    , cullConstants_(nullptr)
+    , pyramid_(nullptr)
+    , pyramidView_(nullptr)
+    , pyramidWidth_(0)
+    , pyramidHeight_(0)
+    , depthWidth_(0)
+    , depthHeight_(0)
+    , builtWidth_(0)
+    , builtHeight_(0)
+    , pyramidValid_(false)
+    , visibleBuffer_(nullptr)
+    , visibleTarget_(nullptr)
+    , visibleCapacity_(0)
+    , argumentsBuffer_(nullptr)
+    , argumentsTarget_(nullptr)
+    , drawsThisFrame_(0)
+    , readbackFrame_(0)
+{
+    DirectX::XMStoreFloat4x4(&pyramidViewProjection_, DirectX::XMMatrixIdentity());
+    for (int i = 0; i < READBACK_LATENCY; ++i) {
+        readback_[i] = nullptr;
+        readbackDraws_[i] = 0;
+    }
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    Shutdown();
+}
+
+bool OcclusionCuller::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height) {
+    if (!device || !context || width == 0 || height == 0) return false;
+    device_ = device;
+    context_ = context;
+
+    if (device_->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0) {
+        Logger::Warning("Occlusion culling needs feature level 11_0 compute shaders");
+        return false;
+    }
+
+    if (!CreateShaders() || !CreatePyramid(width, height)) {
+        Shutdown();
+        return false;
+    }
+
+    // Indirect argument records, initialized per draw and counted into by the cull shader
+    D3D11_BUFFER_DESC argumentsDesc = {};
+    argumentsDesc.Usage = D3D11_USAGE_DEFAULT;
+    argumentsDesc.ByteWidth = ARGUMENT_STRIDE * MAX_DRAWS_PER_FRAME;
+    argumentsDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+    argumentsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    if (FAILED(device_->CreateBuffer(&argumentsDesc, nullptr, &argumentsBuffer_))) {
+        Logger::Error("Failed to create indirect argument buffer");
+        Shutdown();
+        return false;
+    }
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = argumentsDesc.ByteWidth / 4;
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+    if (FAILED(device_->CreateUnorderedAccessView(argumentsBuffer_, &uavDesc, &argumentsTarget_))) {
+        Logger::Error("Failed to create indirect argument view");
+        Shutdown();
+        return false;
+    }
+
+    D3D11_BUFFER_DESC readbackDesc = {};
+    readbackDesc.Usage = D3D11_USAGE_STAGING;
+    readbackDesc.ByteWidth = argumentsDesc.ByteWidth;
+    readbackDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    for (int i = 0; i < READBACK_LATENCY; ++i) {
+        device_->CreateBuffer(&readbackDesc, nullptr, &readback_[i]);
+    }
+
+    Logger::Info("Hi-Z occlusion culling initialized (" + std::to_string(pyramidWidth_) + "x" +
+                 std::to_string(pyramidHeight_) + ", " + std::to_string(mipViews_.size()) + " mips)");
+    return true;
+}
+
+void OcclusionCuller::Shutdown() {
+    ReleasePyramid();
+    for (int i = 0; i < READBACK_LATENCY; ++i) {
+        SafeRelease(readback_[i]);
+        readbackDraws_[i] = 0;
+    }
+    SafeRelease(argumentsTarget_);
+    SafeRelease(argumentsBuffer_);
+    SafeRelease(visibleTarget_);
+    SafeRelease(visibleBuffer_);
+    visibleCapacity_ = 0;
+    SafeRelease(cullConstants_);
+    SafeRelease(downsampleConstants_);
+    SafeRelease(cullShader_);
+    SafeRelease(downsampleShader_);
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+bool OcclusionCuller::CreateShaders() {
+    downsampleShader_ = CompileComputeShader(device_, DOWNSAMPLE_SHADER, "HiZDownsample");
+    cullShader_ = CompileComputeShader(device_, CULL_SHADER, "HiZCull");
+    downsampleConstants_ = CreateConstantBuffer(device_, sizeof(DownsampleConstants));
+    cullConstants_ = CreateConstantBuffer(device_, sizeof(CullConstants));
+
+    if (!downsampleShader_ || !cullShader_ || !downsampleConstants_ || !cullConstants_) {
+        Logger::Error("Failed to create occlusion culling shaders");
+        return false;
+    }
+    return true;
+}
+
+bool OcclusionCuller::CreatePyramid(UINT width, UINT height) {
+    depthWidth_ = width;
+    depthHeight_ = height;
+    pyramidWidth_ = std::max(1u, (width + 1) / 2);
+    pyramidHeight_ = std::max(1u, (height + 1) / 2);
+
+    UINT mipCount = 1;
+    for (UINT size = std::max(pyramidWidth_, pyramidHeight_); size > 1; size /= 2) {
+        ++mipCount;
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = pyramidWidth_;
+    desc.Height = pyramidHeight_;
+    desc.MipLevels = mipCount;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R32G32_FLOAT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &pyramid_))) {
+        Logger::Error("Failed to create Hi-Z pyramid");
+        return false;
+    }
+
+    if (FAILED(device_->CreateShaderResourceView(pyramid_, nullptr, &pyramidView_))) {
+        return false;
+    }
+
+    for (UINT mip = 0; mip < mipCount; ++mip) {
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format = desc.Format;
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MostDetailedMip = mip;
+        srvDesc.Texture2D.MipLevels = 1;
+
+        D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format = desc.Format;
+        uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+        uavDesc.Texture2D.MipSlice = mip;
+
+        ID3D11ShaderResourceView* view = nullptr;
+        ID3D11UnorderedAccessView* target = nullptr;
+        if (FAILED(device_->CreateShaderResourceView(pyramid_, &srvDesc, &view)) ||
+            FAILED(device_->CreateUnorderedAccessView(pyramid_, &uavDesc, &target))) {
+            SafeRelease(view);
+            return false;
+        }
+        mipViews_.push_back(view);
+        mipTargets_.push_back(target);
+    }
+    return true;
+}
+
+void OcclusionCuller::ReleasePyramid() {
+    for (ID3D11ShaderResourceView* view : mipViews_) view->Release();
+    for (ID3D11UnorderedAccessView* target : mipTargets_) target->Release();
+    mipViews_.clear();
+    mipTargets_.clear();
+    SafeRelease(pyramidView_);
+    SafeRelease(pyramid_);
+    pyramidValid_ = false;
+}
+
+bool OcclusionCuller::EnsureVisibleCapacity(UINT instanceCapacity) {
+    if (visibleBuffer_ && instanceCapacity <= visibleCapacity_) return true;
+
+    SafeRelease(visibleTarget_);
+    SafeRelease(visibleBuffer_);
+    visibleCapacity_ = 0;
+
+    // Raw buffers may be both written by compute and read by the input assembler
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.ByteWidth = INSTANCE_STRIDE * instanceCapacity;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_UNORDERED_ACCESS;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    if (FAILED(device_->CreateBuffer(&desc, nullptr, &visibleBuffer_))) {
+        Logger::Error("Failed to create visible instance buffer");
+        return false;
+    }
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = desc.ByteWidth / 4;
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+    if (FAILED(device_->CreateUnorderedAccessView(visibleBuffer_, &uavDesc, &visibleTarget_))) {
+        SafeRelease(visibleBuffer_);
+        return false;
+    }
+
+    visibleCapacity_ = instanceCapacity;
+    return true;
+}
+
+void OcclusionCuller::BeginFrame() {
+    ReadBackStats();
+    stats_.tested = 0;
+    stats_.draws = 0;
+    drawsThisFrame_ = 0;
+}
+
+void OcclusionCuller::ReadBackStats() {
+    // The oldest copy is READBACK_LATENCY frames old, normally long finished on the GPU
+    ID3D11Buffer* readback = readback_[readbackFrame_];
+    UINT draws = readbackDraws_[readbackFrame_];
+    if (!readback || draws == 0) return;
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (context_->Map(readback, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped) != S_OK) return;
+
+    uint32_t visible = 0;
+    const UINT* records = static_cast<const UINT*>(mapped.pData);
+    for (UINT draw = 0; draw < draws; ++draw) {
+        visible += records[draw * 5 + 1];
+    }
+    context_->Unmap(readback, 0);
+
+    stats_.visible = visible;
+    readbackDraws_[readbackFrame_] = 0;
+}
+
+void OcclusionCuller::BuildPyramid(ID3D11ShaderResourceView* depth, const DirectX::XMFLOAT4X4& viewProjection,
+                                   UINT depthWidth, UINT depthHeight) {
+    if (!pyramid_ || !depth) return;
+
+    NEXUS_PROFILE_SCOPE("OcclusionCuller::BuildPyramid");
+
+    // Hand this frame's argument records to the readback ring
+    if (drawsThisFrame_ > 0 && readback_[readbackFrame_]) {
+        context_->CopyResource(readback_[readbackFrame_], argumentsBuffer_);
+        readbackDraws_[readbackFrame_] = drawsThisFrame_;
+    }
+    readbackFrame_ = (readbackFrame_ + 1) % READBACK_LATENCY;
+
+    context_->CSSetShader(downsampleShader_, nullptr, 0);
+    context_->CSSetConstantBuffers(0, 1, &downsampleConstants_);
+
+    // A partial frame fills the top-left of every level, each level sized from the one above
+    UINT sourceWidth = depthWidth > 0 ? std::min(depthWidth, depthWidth_) : depthWidth_;
+    UINT sourceHeight = depthHeight > 0 ? std::min(depthHeight, depthHeight_) : depthHeight_;
+    builtWidth_ = std::max(1u, (sourceWidth + 1) / 2);
+    builtHeight_ = std::max(1u, (sourceHeight + 1) / 2);
+    for (size_t mip = 0; mip < mipTargets_.size(); ++mip) {
+        UINT width = std::max(1u, builtWidth_ >> mip);
+        UINT height = std::max(1u, builtHeight_ >> mip);
+
+        DownsampleConstants constants = {{sourceWidth, sourceHeight}, {width, height}, mip == 0 ? 1u : 0u};
+        WriteConstants(context_, downsampleConstants_, constants);
+
+        ID3D11ShaderResourceView* source = mip == 0 ? depth : mipViews_[mip - 1];
+        context_->CSSetShaderResources(0, 1, &source);
+        context_->CSSetUnorderedAccessViews(0, 1, &mipTargets_[mip], nullptr);
+        context_->Dispatch((width + 7) / 8, (height + 7) / 8, 1);
+
+        // Unbind before the level becomes the next source
+        ID3D11ShaderResourceView* nullView = nullptr;
+        ID3D11UnorderedAccessView* nullTarget = nullptr;
+        context_->CSSetShaderResources(0, 1, &nullView);
+        context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+
+        sourceWidth = width;
+        sourceHeight = height;
+    }
+    context_->CSSetShader(nullptr, nullptr, 0);
+
+    pyramidViewProjection_ = viewProjection;
+    pyramidValid_ = true;
+}
+
+bool OcclusionCuller::Cull(ID3D11ShaderResourceView* instances, UINT instanceCapacity, UINT firstInstance, UINT instanceCount,
+                           UINT indexCountPerInstance, UINT& argumentsOffset) {
+    if (!pyramidValid_ || !instances || instanceCount == 0) return false;
+    if (drawsThisFrame_ >= MAX_DRAWS_PER_FRAME || !EnsureVisibleCapacity(instanceCapacity)) return false;
+
+    NEXUS_PROFILE_SCOPE("OcclusionCuller::Cull");
+
+    argumentsOffset = drawsThisFrame_ * ARGUMENT_STRIDE;
+    ++drawsThisFrame_;
+
+    // IndexCountPerInstance, InstanceCount (counted by the shader), StartIndex, BaseVertex, StartInstance
+    UINT arguments[5] = { indexCountPerInstance, 0, 0, 0, firstInstance };
+    D3D11_BOX region = { argumentsOffset, 0, 0, argumentsOffset + ARGUMENT_STRIDE, 1, 1 };
+    context_->UpdateSubresource(argumentsBuffer_, 0, &region, arguments, 0, 0);
+
+    // HLSL reads constant buffer matrices column-major, so upload the transpose
+    CullConstants constants = {};
+    DirectX::XMStoreFloat4x4(&constants.viewProjection,
+                             DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&pyramidViewProjection_)));
+    constants.pyramidSize[0] = static_cast<float>(builtWidth_);
+    constants.pyramidSize[1] = static_cast<float>(builtHeight_);
+    constants.mipCount = static_cast<UINT>(mipViews_.size());
+    constants.firstInstance = firstInstance;
+    constants.instanceCount = instanceCount;
+    constants.argumentsOffset = argumentsOffset;
+    WriteConstants(context_, cullConstants_, constants);
+
+    ID3D11ShaderResourceView* views[] = { instances, pyramidView_ };
+    ID3D11UnorderedAccessView* targets[] = { visibleTarget_, argumentsTarget_ };
+    context_->CSSetShader(cullShader_, nullptr, 0);
+    context_->CSSetConstantBuffers(0, 1, &cullConstants_);
+    context_->CSSetShaderResources(0, 2, views);
+    context_->CSSetUnorderedAccessViews(0, 2, targets, nullptr);
+    context_->Dispatch((instanceCount + 63) / 64, 1, 1);
+
+    // Both outputs are read by the input assembler next
+    ID3D11ShaderResourceView* nullViews[] = { nullptr, nullptr };
+    ID3D11UnorderedAccessView* nullTargets[] = { nullptr, nullptr };
+    context_->CSSetShaderResources(0, 2, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 2, nullTargets, nullptr);
+    context_->CSSetShader(nullptr, nullptr, 0);
+
+    stats_.tested += instanceCount;
+    stats_.draws++;
+    return true;
+}
+
+} // namespace Nexus
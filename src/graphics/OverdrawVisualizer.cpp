@@ -0,0 +1,284 @@
+#include "OverdrawVisualizer.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// Bound in place of every pixel shader; only reads SV_POSITION, which every vertex shader in
+// the engine writes first. Helper lanes, run only to give their quad derivatives, have no input
+// coverage and their output is dropped, so the quad's live pixels are summed from fine
+// derivatives of a per-lane flag and share out its four lanes between them
+const char* COUNT_PS = R"(
+struct Output
+{
+    float2 counts : SV_TARGET0;
+    float4 velocity : SV_TARGET1;   // Adds nothing to TemporalAA's velocity target
+};
+
+Output main(float4 position : SV_POSITION, uint coverage : SV_Coverage)
+{
+    float live = coverage != 0 ? 1.0f : 0.0f;
+
+    // The lane across the quad differs by the derivative, with the sign of this lane's side
+    float2 side = fmod(floor(position.xy), 2.0f);
+    float dx = ddx_fine(live);
+    float row = live + (side.x == 0.0f ? live + dx : live - dx);
+    float dy = ddy_fine(row);
+    float quad = row + (side.y == 0.0f ? row + dy : row - dy);
+
+    Output output;
+    output.counts = float2(1.0f, 4.0f / max(quad, 1.0f));
+    output.velocity = 0.0f;
+    return output;
+}
+)";
+
+const char* FULLSCREEN_VS = R"(
+float4 main(uint id : SV_VertexID) : SV_POSITION
+{
+    float2 uv = float2((id << 1) & 2, id & 2);
+    return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+}
+)";
+
+const char* RESOLVE_PS = R"(
+cbuffer ResolveConstants : register(b0)
+{
+    uint Mode;              // 0 overdraw, 1 quad overshading
+    float MaxOverdraw;
+    float2 Padding;
+};
+
+Texture2D<float2> Counts : register(t0);
+
+float3 Heat(float t)
+{
+    static const float3 STOPS[5] = {
+        float3(0.0f, 0.0f, 0.3f), float3(0.0f, 0.6f, 1.0f), float3(0.2f, 1.0f, 0.2f),
+        float3(1.0f, 0.9f, 0.0f), float3(1.0f, 0.1f, 0.0f)
+    };
+    float x = saturate(t) * 4.0f;
+    uint i = min((uint)x, 3u);
+    return lerp(STOPS[i], STOPS[i + 1], x - i);
+}
+
+float4 main(float4 position : SV_POSITION) : SV_TARGET
+{
+    float2 counts = Counts[uint2(position.xy)];
+    if (counts.x <= 0.0f) {
+        return float4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    if (Mode == 0) {
+        // Past the scale the heat goes to white
+        float3 color = Heat(counts.x / MaxOverdraw);
+        return float4(lerp(color, 1.0f, saturate(counts.x / MaxOverdraw - 1.0f)), 1.0f);
+    }
+
+    // Pixels per lane run: 0.25 when every quad covered one pixel, 1 when all were full
+    float useful = saturate((counts.x / counts.y - 0.25f) / 0.75f);
+    float3 color = useful < 0.5f ? lerp(float3(1.0f, 0.0f, 0.0f), float3(1.0f, 0.9f, 0.0f), useful * 2.0f)
+                                 : lerp(float3(1.0f, 0.9f, 0.0f), float3(0.0f, 1.0f, 0.0f), useful * 2.0f - 1.0f);
+    return float4(color, 1.0f);
+}
+)";
+
+// Matches ResolveConstants above
+struct GpuResolveConstants {
+    uint32_t mode;
+    float maxOverdraw;
+    float padding[2];
+};
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3DBlob* CompileShader(const char* source, const char* name, const char* target) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+} // namespace
+
+OverdrawVisualizer::OverdrawVisualizer()
+    : device_(nullptr)
+    , context_(nullptr)
+    , stateCache_(nullptr)
+    , width_(0)
+    , height_(0)
+    , counterTexture_(nullptr)
+    , counterTarget_(nullptr)
+    , counterView_(nullptr)
+    , countShader_(nullptr)
+    , fullscreenShader_(nullptr)
+    , resolveShader_(nullptr)
+    , constants_(nullptr)
+    , additiveBlend_(nullptr)
+    , rasterizerState_(nullptr)
+    , depthState_(nullptr)
+{
+}
+
+OverdrawVisualizer::~OverdrawVisualizer() {
+    Shutdown();
+}
+
+bool OverdrawVisualizer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                                    UINT width, UINT height) {
+    Shutdown();
+    if (!device || !context || !stateCache || width == 0 || height == 0) return false;
+
+    device_ = device;
+    context_ = context;
+    stateCache_ = stateCache;
+    width_ = width;
+    height_ = height;
+
+    if (!CreateResources() || !CreateShaders()) {
+        Logger::Error("Failed to create overdraw visualizer resources");
+        Shutdown();
+        return false;
+    }
+    return true;
+}
+
+void OverdrawVisualizer::Shutdown() {
+    SafeRelease(counterTarget_);
+    SafeRelease(counterView_);
+    SafeRelease(counterTexture_);
+    SafeRelease(countShader_);
+    SafeRelease(fullscreenShader_);
+    SafeRelease(resolveShader_);
+    SafeRelease(constants_);
+    SafeRelease(additiveBlend_);
+    SafeRelease(rasterizerState_);
+    SafeRelease(depthState_);
+    device_ = nullptr;
+    context_ = nullptr;
+    stateCache_ = nullptr;
+}
+
+bool OverdrawVisualizer::CreateResources() {
+    // Half floats count exactly to 2048 layers and blend on every feature level 10 part
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width_;
+    desc.Height = height_;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R16G16_FLOAT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &counterTexture_))) return false;
+    if (FAILED(device_->CreateRenderTargetView(counterTexture_, nullptr, &counterTarget_))) return false;
+    if (FAILED(device_->CreateShaderResourceView(counterTexture_, nullptr, &counterView_))) return false;
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = sizeof(GpuResolveConstants);
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&bufferDesc, nullptr, &constants_))) return false;
+
+    D3D11_BLEND_DESC blendDesc = {};
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    if (FAILED(device_->CreateBlendState(&blendDesc, &additiveBlend_))) return false;
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizerDesc, &rasterizerState_))) return false;
+
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = FALSE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+    return SUCCEEDED(device_->CreateDepthStencilState(&depthDesc, &depthState_));
+}
+
+bool OverdrawVisualizer::CreateShaders() {
+    ID3DBlob* blob = CompileShader(COUNT_PS, "OverdrawCount_PS", "ps_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &countShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(FULLSCREEN_VS, "OverdrawResolve_VS", "vs_5_0");
+    if (!blob) return false;
+    hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &fullscreenShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(RESOLVE_PS, "OverdrawResolve_PS", "ps_5_0");
+    if (!blob) return false;
+    hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &resolveShader_);
+    blob->Release();
+    return SUCCEEDED(hr);
+}
+
+void OverdrawVisualizer::Clear() {
+    if (!counterTarget_) return;
+    const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    context_->ClearRenderTargetView(counterTarget_, zero);
+}
+
+void OverdrawVisualizer::Resolve(Mode mode, ID3D11RenderTargetView* target, UINT width, UINT height) {
+    if (!device_ || !target) return;
+    NEXUS_PROFILE_SCOPE("OverdrawVisualizer::Resolve");
+
+    GpuResolveConstants constants = {};
+    constants.mode = mode == Mode::QuadOvershading ? 1u : 0u;
+    constants.maxOverdraw = MAX_OVERDRAW;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = static_cast<float>(std::min(width, width_));
+    viewport.Height = static_cast<float>(std::min(height, height_));
+    viewport.MaxDepth = 1.0f;
+    stateCache_->OMSetRenderTargets(1, &target, nullptr);
+    stateCache_->RSSetViewports(1, &viewport);
+    stateCache_->RSSetState(rasterizerState_);
+    stateCache_->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+    stateCache_->OMSetDepthStencilState(depthState_, 0);
+    stateCache_->IASetInputLayout(nullptr);
+    stateCache_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    stateCache_->VSSetShader(fullscreenShader_);
+    stateCache_->PSSetShader(resolveShader_);
+    stateCache_->PSSetConstantBuffers(0, 1, &constants_);
+    stateCache_->PSSetShaderResources(0, 1, &counterView_);
+    context_->Draw(3, 0);
+
+    // The counts are a render target again next frame
+    ID3D11ShaderResourceView* nullView = nullptr;
+    stateCache_->PSSetShaderResources(0, 1, &nullView);
+}
+
+} // namespace Nexus
@@ -1,11 +1,336 @@
 #include "ParticleSystem.h"
+#include "BinaryFile.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
 #include "Camera.h"
+#include "DecalSystem.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <emmintrin.h>
+#include <utility>
 
 namespace Nexus {
 
-ParticleSystem::ParticleSystem() {
-    // Basic initialization
+namespace {
+
+using Streams = ParticleSystem::ParticleStreams;
+
+__m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// table[index * stride + channel] for four indices
+__m128 Gather(const float* table, const int32_t* indices, int stride, int channel) {
+    return _mm_set_ps(table[indices[3] * stride + channel], table[indices[2] * stride + channel],
+                      table[indices[1] * stride + channel], table[indices[0] * stride + channel]);
+}
+
+// Curve value at fraction between sample index and the next
+__m128 SampleCurve(const float* table, const int32_t* indices, __m128 fraction, int stride, int channel) {
+    __m128 a = Gather(table, indices, stride, channel);
+    __m128 b = Gather(table + stride, indices, stride, channel);
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fraction));
+}
+
+// FNV-1a over a curve's keys, which are plain floats without padding
+template<typename T>
+void HashCurve(uint64_t& hash, const std::vector<std::pair<float, T>>& curve) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(curve.data());
+    for (size_t i = 0; i < curve.size() * sizeof(curve[0]); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    hash = (hash ^ curve.size()) * 1099511628211ull;
+}
+
+float HorizontalMin(__m128 v) {
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(_mm_min_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))));
+}
+
+float HorizontalMax(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(_mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))));
+}
+
+AABB Merge(const AABB& a, const AABB& b) {
+    return { XMFLOAT3(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)),
+             XMFLOAT3(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)) };
+}
+
+AABB Grow(const AABB& box, float amount) {
+    return { XMFLOAT3(box.min.x - amount, box.min.y - amount, box.min.z - amount),
+             XMFLOAT3(box.max.x + amount, box.max.y + amount, box.max.z + amount) };
+}
+
+float DistanceToBounds(const XMFLOAT3& point, const AABB& box) {
+    float x = std::max(std::max(box.min.x - point.x, point.x - box.max.x), 0.0f);
+    float y = std::max(std::max(box.min.y - point.y, point.y - box.max.y), 0.0f);
+    float z = std::max(std::max(box.min.z - point.z, point.z - box.max.z), 0.0f);
+    return std::sqrt(x * x + y * y + z * z);
+}
+
+// Box the emission shape spawns particles in
+AABB ShapeBounds(const ParticleSystem::ParticleEmitter& emitter) {
+    XMFLOAT3 extent(0.0f, 0.0f, 0.0f);
+    const XMFLOAT3& shape = emitter.shapeScale;
+    switch (emitter.shape) {
+    case ParticleSystem::EmissionShape::Sphere:
+        extent = XMFLOAT3(shape.x, shape.x, shape.x);
+        break;
+    case ParticleSystem::EmissionShape::Box:
+        extent = shape;
+        break;
+    case ParticleSystem::EmissionShape::Circle:
+        extent = XMFLOAT3(shape.x, 0.0f, shape.x);
+        break;
+    default:
+        break;
+    }
+    return AABB::FromCenterExtents(emitter.position, extent);
+}
+
+// How far a sprite reaches past its centre: half the largest size it can have
+float SpriteReach(const ParticleSystem::ParticleEmitter& emitter) {
+    float size = std::max(emitter.startSize.x + emitter.startSizeVariation.x, emitter.startSize.y + emitter.startSizeVariation.y);
+    for (const XMFLOAT2& curveSize : emitter.sizeTable) {
+        size = std::max(size, std::max(curveSize.x, curveSize.y));
+    }
+    return size * 0.5f;
+}
+
+// Emitter config files: the settings below as one record, the curves and collision planes as
+// sections of their own. Textures, sub-emitters and custom functions are runtime objects and
+// stay with the code that sets them up
+constexpr uint32_t EMITTER_CONFIG_TYPE = MakeFourCC('E', 'M', 'T', 'R');
+constexpr uint32_t EMITTER_CONFIG_VERSION = 1;
+constexpr uint32_t SECTION_SETTINGS = MakeFourCC('S', 'E', 'T', 'S');
+constexpr uint32_t SECTION_VELOCITY_CURVE = MakeFourCC('C', 'V', 'E', 'L');
+constexpr uint32_t SECTION_COLOR_CURVE = MakeFourCC('C', 'C', 'O', 'L');
+constexpr uint32_t SECTION_SIZE_CURVE = MakeFourCC('C', 'S', 'I', 'Z');
+constexpr uint32_t SECTION_ROTATION_CURVE = MakeFourCC('C', 'R', 'O', 'T');
+constexpr uint32_t SECTION_COLLISION_PLANES = MakeFourCC('P', 'L', 'N', 'S');
+
+enum EmitterConfigFlags : uint32_t {
+    CONFIG_LOOPING = 1 << 0,
+    CONFIG_COLLISION = 1 << 1,
+    CONFIG_TRAILS = 1 << 2,
+    CONFIG_NOISE = 1 << 3,
+    CONFIG_TEXTURE_SHEET_ANIMATION = 1 << 4,
+    CONFIG_GPU_SIMULATION = 1 << 5
+};
+
+struct EmitterConfigRecord {
+    uint32_t shape;
+    uint32_t particleType;
+    uint32_t renderMode;
+    uint32_t blendMode;
+    uint32_t flags;
+    int32_t maxParticles;
+    int32_t trailSegments;
+    int32_t lodMaxParticles;
+    float emissionRate;
+    float emissionBurst;
+    float emissionDuration;
+    float emissionDelay;
+    XMFLOAT3 shapeScale;
+    float startLifetime;
+    float startLifetimeVariation;
+    XMFLOAT3 startVelocity;
+    XMFLOAT3 startVelocityVariation;
+    XMFLOAT4 startColor;
+    XMFLOAT4 startColorVariation;
+    XMFLOAT2 startSize;
+    XMFLOAT2 startSizeVariation;
+    float startRotation;
+    float startRotationVariation;
+    float startAngularVelocity;
+    float startMass;
+    XMFLOAT3 gravity;
+    float drag;
+    float turbulence;
+    XMFLOAT3 constantForce;
+    XMFLOAT2 textureSheetTiles;
+    float textureSheetFrameRate;
+    float bounciness;
+    float friction;
+    float trailWidth;
+    float trailLifetime;
+    XMFLOAT4 trailColor;
+    float noiseStrength;
+    float noiseFrequency;
+    XMFLOAT3 noiseOffset;
+    float lodDistance;
+    float lodFadeDistance;
+};
+
+BinarySchema GetEmitterConfigSchema() {
+    using Type = BinarySchema::FieldType;
+    return BinarySchema()
+        .Field("shape", Type::U32).Field("particleType", Type::U32).Field("renderMode", Type::U32)
+        .Field("blendMode", Type::U32).Field("flags", Type::U32)
+        .Field("maxParticles", Type::I32).Field("trailSegments", Type::I32).Field("lodMaxParticles", Type::I32)
+        .Field("emissionRate", Type::F32).Field("emissionBurst", Type::F32).Field("emissionDuration", Type::F32)
+        .Field("emissionDelay", Type::F32).Field("shapeScale", Type::F32, 3)
+        .Field("startLifetime", Type::F32).Field("startLifetimeVariation", Type::F32)
+        .Field("startVelocity", Type::F32, 3).Field("startVelocityVariation", Type::F32, 3)
+        .Field("startColor", Type::F32, 4).Field("startColorVariation", Type::F32, 4)
+        .Field("startSize", Type::F32, 2).Field("startSizeVariation", Type::F32, 2)
+        .Field("startRotation", Type::F32).Field("startRotationVariation", Type::F32)
+        .Field("startAngularVelocity", Type::F32).Field("startMass", Type::F32)
+        .Field("gravity", Type::F32, 3).Field("drag", Type::F32).Field("turbulence", Type::F32)
+        .Field("constantForce", Type::F32, 3)
+        .Field("textureSheetTiles", Type::F32, 2).Field("textureSheetFrameRate", Type::F32)
+        .Field("bounciness", Type::F32).Field("friction", Type::F32)
+        .Field("trailWidth", Type::F32).Field("trailLifetime", Type::F32).Field("trailColor", Type::F32, 4)
+        .Field("noiseStrength", Type::F32).Field("noiseFrequency", Type::F32).Field("noiseOffset", Type::F32, 3)
+        .Field("lodDistance", Type::F32).Field("lodFadeDistance", Type::F32);
+}
+
+// Curve keys as stored: the time, then the value's floats
+BinarySchema GetCurveSchema(uint32_t components) {
+    return BinarySchema().Field("time", BinarySchema::FieldType::F32).Field("value", BinarySchema::FieldType::F32, components);
+}
+
+BinarySchema GetPlaneSchema() {
+    return BinarySchema().Field("normal", BinarySchema::FieldType::F32, 3).Field("distance", BinarySchema::FieldType::F32);
+}
+
+template<typename T>
+struct CurveKey {
+    float time;
+    T value;
+};
+
+template<typename T>
+void AddCurve(BinaryFileWriter& writer, uint32_t id, const std::vector<std::pair<float, T>>& curve) {
+    std::vector<CurveKey<T>> keys;
+    keys.reserve(curve.size());
+    for (const auto& [time, value] : curve) keys.push_back({ time, value });
+    writer.AddSection(id, GetCurveSchema(sizeof(T) / sizeof(float)), keys);
+}
+
+// A missing curve section leaves the curve empty; false only for one that is unreadable
+template<typename T>
+bool ReadCurve(const BinaryFile& file, uint32_t id, std::vector<std::pair<float, T>>& curve) {
+    curve.clear();
+    if (!file.FindSection(id)) return true;
+    std::vector<uint8_t> buffer;
+    size_t count = 0;
+    const CurveKey<T>* keys = file.GetSection<CurveKey<T>>(id, GetCurveSchema(sizeof(T) / sizeof(float)), count, buffer);
+    if (!keys) return false;
+    curve.reserve(count);
+    for (size_t i = 0; i < count; ++i) curve.emplace_back(keys[i].time, keys[i].value);
+    return true;
+}
+
+} // namespace
+
+void ParticleSystem::ParticleStreams::Reserve(size_t newCapacity) {
+    count = std::min(count, newCapacity);
+    size_t newStride = StrideFor(newCapacity);
+    if (newStride > stride) {
+        std::vector<float> grown(newStride * STREAM_COUNT, 0.0f);
+        for (size_t stream = 0; stream < STREAM_COUNT; ++stream) {
+            std::copy_n(storage.data() + stream * stride, count, grown.data() + stream * newStride);
+        }
+        storage.swap(grown);
+        stride = newStride;
+    }
+    capacity = newCapacity;
+}
+
+bool ParticleSystem::ParticleStreams::Add(const Particle& particle) {
+    if (count >= GetCapacity()) return false;
+    Set(count++, particle);
+    return true;
+}
+
+void ParticleSystem::ParticleStreams::Get(size_t index, Particle& particle) const {
+    particle = Particle();
+    particle.position = XMFLOAT3((*this)[POSITION_X][index], (*this)[POSITION_Y][index], (*this)[POSITION_Z][index]);
+    particle.velocity = XMFLOAT3((*this)[VELOCITY_X][index], (*this)[VELOCITY_Y][index], (*this)[VELOCITY_Z][index]);
+    particle.color = XMFLOAT4((*this)[COLOR_R][index], (*this)[COLOR_G][index], (*this)[COLOR_B][index],
+                              (*this)[COLOR_A][index]);
+    particle.size = XMFLOAT2((*this)[SIZE_X][index], (*this)[SIZE_Y][index]);
+    particle.rotation = (*this)[ROTATION][index];
+    particle.angularVelocity = (*this)[ANGULAR_VELOCITY][index];
+    particle.life = (*this)[LIFE][index];
+    float inverseMaxLife = (*this)[INVERSE_MAX_LIFE][index];
+    particle.maxLife = inverseMaxLife > 0.0f ? 1.0f / inverseMaxLife : 0.0f;
+}
+
+void ParticleSystem::ParticleStreams::Set(size_t index, const Particle& particle) {
+    (*this)[POSITION_X][index] = particle.position.x;
+    (*this)[POSITION_Y][index] = particle.position.y;
+    (*this)[POSITION_Z][index] = particle.position.z;
+    (*this)[VELOCITY_X][index] = particle.velocity.x;
+    (*this)[VELOCITY_Y][index] = particle.velocity.y;
+    (*this)[VELOCITY_Z][index] = particle.velocity.z;
+    (*this)[COLOR_R][index] = particle.color.x;
+    (*this)[COLOR_G][index] = particle.color.y;
+    (*this)[COLOR_B][index] = particle.color.z;
+    (*this)[COLOR_A][index] = particle.color.w;
+    (*this)[SIZE_X][index] = particle.size.x;
+    (*this)[SIZE_Y][index] = particle.size.y;
+    (*this)[ROTATION][index] = particle.rotation;
+    (*this)[ANGULAR_VELOCITY][index] = particle.angularVelocity;
+    (*this)[LIFE][index] = particle.life;
+    (*this)[INVERSE_MAX_LIFE][index] = particle.maxLife > 0.0f ? 1.0f / particle.maxLife : 0.0f;
+}
+
+void ParticleSystem::ParticleStreams::Remove(size_t index) {
+    if (index >= count) return;
+    --count;
+    if (index == count) return;
+    for (size_t stream = 0; stream < STREAM_COUNT; ++stream) {
+        float* values = storage.data() + stream * stride;
+        values[index] = values[count];
+    }
+}
+
+ParticleSystem::ParticleSystem()
+    : device_(nullptr)
+    , context_(nullptr)
+    , manager_(std::make_unique<ParticleSystemManager>())
+    , randomGenerator_(std::random_device{}())
+    , jobs_(nullptr)
+    , decals_(nullptr)
+    , bloodDecalLayer_(-1)
+    , viewValid_(false)
+    , viewPosition_(0.0f, 0.0f, 0.0f)
+    , viewFrustum_()
+    , lodEnabled_(true)
+    , multithreadingEnabled_(true)
+    , gpuSimulationEnabled_(false)
+    , sortParticles_(true)
+    , depthTesting_(true)
+    , depthWriting_(false)
+    , cullingEnabled_(true)
+    , debugVisualization_(false)
+    , savedAlphaBlend_(0)
+    , savedSrcBlend_(0)
+    , savedDestBlend_(0)
+    , savedZWrite_(0)
+    , savedZFunc_(0)
+    , savedCullMode_(0)
+    , totalParticles_(0)
+    , activeEmitters_(0)
+    , lastUpdateTime_(0.0f)
+    , particleBudget_(1 << 22)
+{
+    manager_->maxParticlesPerSystem = 1 << 20;
+    manager_->maxTotalParticles = 1 << 22;
+    manager_->updateFrequency = 10.0f;
+    manager_->useMultithreading = true;
+    manager_->lodNearDistance = 50.0f;
+    manager_->lodFarDistance = 200.0f;
+    manager_->lodCullingDistance = 500.0f;
+    manager_->totalParticles = 0;
+    manager_->activeEmitters = 0;
+    manager_->lastUpdateTime = 0.0f;
 }
 
 ParticleSystem::~ParticleSystem() {
@@ -13,34 +338,1261 @@ ParticleSystem::~ParticleSystem() {
 }
 
 bool ParticleSystem::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    NEXUS_MEMORY_SCOPE(MemoryTag::Particles);
     Logger::Info("ParticleSystem: Initializing...");
-    
+
     // Store device and context
     device_ = device;
     context_ = context;
-    
+    EnableGPUSimulation(true);
+
     Logger::Info("ParticleSystem: Initialized successfully");
     return true;
 }
 
 void ParticleSystem::Shutdown() {
     Logger::Info("ParticleSystem: Shutting down...");
-    
+
     // Clean up resources
+    ClearEmitters();
+    gpuSystem_.reset();
+    gpuSimulationEnabled_ = false;
     device_ = nullptr;
     context_ = nullptr;
-    
+
     Logger::Info("ParticleSystem: Shutdown complete");
 }
 
+std::shared_ptr<ParticleSystem::ParticleEmitter> ParticleSystem::CreateEmitter(const std::string& name) {
+    // Value-initialized, so everything not set here starts at zero
+    auto emitter = std::make_shared<ParticleEmitter>();
+    emitter->name = name;
+    emitter->isActive = true;
+    emitter->isLooping = true;
+    emitter->scale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+    emitter->transform = XMMatrixIdentity();
+    emitter->shape = EmissionShape::Point;
+    emitter->emissionRate = 10.0f;
+    emitter->emissionDuration = 5.0f;
+    emitter->shapeScale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+    emitter->particleType = ParticleType::Sprite;
+    emitter->maxParticles = 1000;
+    emitter->startLifetime = 5.0f;
+    emitter->startVelocity = XMFLOAT3(0.0f, 1.0f, 0.0f);
+    emitter->startColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    emitter->startSize = XMFLOAT2(1.0f, 1.0f);
+    emitter->startMass = 1.0f;
+    emitter->renderMode = RenderMode::Billboard;
+    emitter->blendMode = BlendMode::Alpha;
+    emitter->textureSheetTiles = XMFLOAT2(1.0f, 1.0f);
+    emitter->lodMaxParticles = emitter->maxParticles;
+    emitter->lodFactor = 1.0f;
+    emitter->lodEmissionScale = 1.0f;
+    emitter->lodParticleLimit = emitter->maxParticles;
+    emitter->random.seed(randomGenerator_());
+
+    RemoveEmitter(name);
+    manager_->AddEmitter(emitter);
+    return emitter;
+}
+
+void ParticleSystem::RemoveEmitter(const std::string& name) {
+    RemoveEmitter(manager_->FindEmitter(name));
+}
+
+void ParticleSystem::RemoveEmitter(EmitterHandle handle) {
+    // Anyone still holding the emitter finds it empty
+    if (ParticleEmitter* emitter = manager_->GetEmitter(handle)) {
+        RecyclePool(*emitter);
+        manager_->RemoveEmitter(handle);
+    }
+}
+
+std::shared_ptr<ParticleSystem::ParticleEmitter> ParticleSystem::GetEmitter(const std::string& name) {
+    return GetEmitter(manager_->FindEmitter(name));
+}
+
+std::shared_ptr<ParticleSystem::ParticleEmitter> ParticleSystem::GetEmitter(EmitterHandle handle) {
+    ParticleEmitter* emitter = manager_->GetEmitter(handle);
+    return emitter ? manager_->emitters[manager_->slots[handle.index].packed] : nullptr;
+}
+
+ParticleSystem::EmitterHandle ParticleSystem::FindEmitter(const std::string& name) const {
+    return manager_->FindEmitter(name);
+}
+
+void ParticleSystem::ClearEmitters() {
+    if (!manager_) return;
+    for (const std::shared_ptr<ParticleEmitter>& emitter : manager_->emitters) {
+        RecyclePool(*emitter);
+    }
+    manager_->ClearEmitters();
+}
+
+ParticleSystem::EmitterHandle ParticleSystem::ParticleSystemManager::AddEmitter(std::shared_ptr<ParticleEmitter> emitter) {
+    EmitterHandle handle;
+    if (!freeSlots.empty()) {
+        handle.index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        handle.index = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+    handle.generation = slots[handle.index].generation;
+    slots[handle.index].packed = static_cast<uint32_t>(emitters.size());
+    names[emitter->name] = handle;
+    emitterSlots.push_back(handle.index);
+    emitters.push_back(std::move(emitter));
+    return handle;
+}
+
+void ParticleSystem::ParticleSystemManager::RemoveEmitter(EmitterHandle handle) {
+    if (!GetEmitter(handle)) return;
+
+    // The last emitter takes the removed one's place
+    EmitterSlot& slot = slots[handle.index];
+    names.erase(emitters[slot.packed]->name);
+    emitters[slot.packed] = std::move(emitters.back());
+    emitterSlots[slot.packed] = emitterSlots.back();
+    slots[emitterSlots[slot.packed]].packed = slot.packed;
+    emitters.pop_back();
+    emitterSlots.pop_back();
+
+    slot.packed = 0xFFFFFFFFu;
+    slot.generation++;
+    freeSlots.push_back(handle.index);
+}
+
+ParticleSystem::ParticleEmitter* ParticleSystem::ParticleSystemManager::GetEmitter(EmitterHandle handle) const {
+    if (handle.index >= slots.size()) return nullptr;
+    const EmitterSlot& slot = slots[handle.index];
+    return slot.packed != 0xFFFFFFFFu && slot.generation == handle.generation ? emitters[slot.packed].get() : nullptr;
+}
+
+ParticleSystem::EmitterHandle ParticleSystem::ParticleSystemManager::FindEmitter(const std::string& name) const {
+    auto it = names.find(name);
+    return it != names.end() ? it->second : EmitterHandle();
+}
+
+void ParticleSystem::ParticleSystemManager::ClearEmitters() {
+    // Generations carry on, so handles from before stay stale
+    for (uint32_t index : emitterSlots) {
+        slots[index].packed = 0xFFFFFFFFu;
+        slots[index].generation++;
+        freeSlots.push_back(index);
+    }
+    emitters.clear();
+    emitterSlots.clear();
+    names.clear();
+}
+
+void ParticleSystem::StartEmission(const std::string& name) {
+    if (auto emitter = GetEmitter(name)) {
+        emitter->isActive = true;
+        emitter->systemTime = 0.0f;
+        emitter->emissionTimer = 0.0f;
+        emitter->hasEmittedBurst = false;
+    }
+}
+
+void ParticleSystem::StopEmission(const std::string& name) {
+    if (auto emitter = GetEmitter(name)) emitter->isActive = false;
+}
+
+void ParticleSystem::BurstEmission(const std::string& name, int count) {
+    auto emitter = GetEmitter(name);
+    if (!emitter) return;
+    if (emitter->gpuSimulation && gpuSystem_) {
+        if (gpuSystem_->EnsurePool(emitter->gpuPool, emitter->maxParticles)) {
+            BakeCurves(*emitter);
+            gpuSystem_->Stage(*emitter->gpuPool, *emitter, manager_->globalForces, count, 0.0f);
+            emitter->emittedParticleCount += count;
+        }
+        return;
+    }
+    ReservePool(*emitter);
+    ParticleStreams& particles = emitter->particles;
+    count = ClaimParticles(std::min(count, static_cast<int>(particles.GetCapacity() - particles.count)));
+    for (int i = 0; i < count; ++i) {
+        EmitParticle(*emitter);
+    }
+    emitter->aliveParticleCount = static_cast<int>(particles.count);
+}
+
+void ParticleSystem::SetEmitterPosition(const std::string& name, const XMFLOAT3& position) {
+    SetEmitterPosition(manager_->FindEmitter(name), position);
+}
+
+void ParticleSystem::SetEmitterPosition(EmitterHandle handle, const XMFLOAT3& position) {
+    if (ParticleEmitter* emitter = manager_->GetEmitter(handle)) emitter->position = position;
+}
+
+void ParticleSystem::SetEmitterActive(const std::string& name, bool active) {
+    SetEmitterActive(manager_->FindEmitter(name), active);
+}
+
+void ParticleSystem::SetEmitterActive(EmitterHandle handle, bool active) {
+    if (ParticleEmitter* emitter = manager_->GetEmitter(handle)) emitter->isActive = active;
+}
+
+void ParticleSystem::ResetEmitter(const std::string& name) {
+    if (auto emitter = GetEmitter(name)) {
+        emitter->particles.Clear();
+        emitter->gpuPool.reset();
+        emitter->aliveParticleCount = 0;
+        emitter->systemTime = 0.0f;
+        emitter->emissionTimer = 0.0f;
+        emitter->hasEmittedBurst = false;
+    }
+}
+
+void ParticleSystem::CreateExplosionEffect(const std::string& name, const XMFLOAT3& position) {
+    // A one-shot burst on the CPU. Its block is taken now, from a finished explosion's when
+    // there is one, so the frame it goes off does not allocate
+    auto emitter = CreateEmitter(name);
+    emitter->position = position;
+    emitter->isLooping = false;
+    emitter->shape = EmissionShape::Sphere;
+    emitter->shapeScale = XMFLOAT3(0.3f, 0.3f, 0.3f);
+    emitter->maxParticles = 600;
+    emitter->emissionRate = 0.0f;
+    emitter->emissionBurst = 600.0f;
+    emitter->emissionDuration = 0.0f;
+    emitter->startLifetime = 1.0f;
+    emitter->startLifetimeVariation = 0.4f;
+    emitter->startVelocity = XMFLOAT3(0.0f, 1.0f, 0.0f);
+    emitter->startVelocityVariation = XMFLOAT3(8.0f, 8.0f, 8.0f);
+    emitter->startColor = XMFLOAT4(1.0f, 0.7f, 0.3f, 1.0f);
+    emitter->startSize = XMFLOAT2(0.8f, 0.8f);
+    emitter->startSizeVariation = XMFLOAT2(0.3f, 0.3f);
+    emitter->startRotationVariation = XM_PI;
+    emitter->colorOverLifetime = { { 0.0f, XMFLOAT4(1.0f, 0.9f, 0.6f, 1.0f) },
+                                   { 0.3f, XMFLOAT4(1.0f, 0.4f, 0.1f, 0.8f) },
+                                   { 1.0f, XMFLOAT4(0.2f, 0.1f, 0.1f, 0.0f) } };
+    emitter->sizeOverLifetime = { { 0.0f, XMFLOAT2(0.5f, 0.5f) },
+                                  { 1.0f, XMFLOAT2(2.5f, 2.5f) } };
+    emitter->gravity = XMFLOAT3(0.0f, -2.0f, 0.0f);
+    emitter->drag = 3.0f;
+    emitter->renderMode = RenderMode::Billboard;
+    emitter->blendMode = BlendMode::Additive;
+    emitter->lodMaxParticles = emitter->maxParticles / 4;
+    ReservePool(*emitter);
+}
+
+void ParticleSystem::CreateBloodEffect(const std::string& name, const XMFLOAT3& position) {
+    // A one-shot spray of droplets that stop where they land, like the explosion's burst
+    auto emitter = CreateEmitter(name);
+    emitter->position = position;
+    emitter->isLooping = false;
+    emitter->shape = EmissionShape::Sphere;
+    emitter->shapeScale = XMFLOAT3(0.05f, 0.05f, 0.05f);
+    emitter->maxParticles = 150;
+    emitter->emissionRate = 0.0f;
+    emitter->emissionBurst = 150.0f;
+    emitter->emissionDuration = 0.0f;
+    emitter->startLifetime = 0.8f;
+    emitter->startLifetimeVariation = 0.3f;
+    emitter->startVelocity = XMFLOAT3(0.0f, 1.5f, 0.0f);
+    emitter->startVelocityVariation = XMFLOAT3(2.5f, 1.5f, 2.5f);
+    emitter->startColor = XMFLOAT4(0.45f, 0.02f, 0.02f, 1.0f);
+    emitter->startSize = XMFLOAT2(0.04f, 0.04f);
+    emitter->startSizeVariation = XMFLOAT2(0.02f, 0.02f);
+    emitter->colorOverLifetime = { { 0.0f, XMFLOAT4(0.5f, 0.03f, 0.03f, 1.0f) },
+                                   { 1.0f, XMFLOAT4(0.25f, 0.01f, 0.01f, 0.0f) } };
+    emitter->gravity = XMFLOAT3(0.0f, -9.81f, 0.0f);
+    emitter->drag = 0.4f;
+    emitter->enableCollision = true;
+    emitter->bounciness = 0.0f;
+    emitter->friction = 1.0f;
+    emitter->renderMode = RenderMode::Stretched;
+    emitter->blendMode = BlendMode::Alpha;
+    emitter->lodMaxParticles = emitter->maxParticles / 2;
+    ReservePool(*emitter);
+
+    if (!decals_ || bloodDecalLayer_ < 0) return;
+
+    // The splat projects straight down through a box reaching a metre below the spray, at a
+    // random size and spin so repeated hits don't tile
+    const float radius = RandomFloat(0.3f, 0.7f);
+    const XMVECTOR down = XMQuaternionRotationAxis(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), -XM_PIDIV2);
+    const XMVECTOR spin = XMQuaternionRotationAxis(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), RandomFloat(0.0f, XM_2PI));
+    DecalSystem::Decal splat;
+    splat.position = XMFLOAT3(position.x, position.y - 0.5f, position.z);
+    XMStoreFloat4(&splat.rotation, XMQuaternionMultiply(down, spin));
+    splat.halfExtents = XMFLOAT3(radius, radius, 0.75f);
+    splat.layer = static_cast<UINT>(bloodDecalLayer_);
+    splat.color = XMFLOAT4(0.35f, 0.02f, 0.02f, 0.9f);
+    splat.roughness = 0.25f;
+    splat.lifetime = 30.0f;
+    splat.fadeTime = 5.0f;
+    decals_->AddDecal(splat);
+}
+
+void ParticleSystem::CreateSparkEffect(const std::string& name, const XMFLOAT3& position) {
+    auto emitter = CreateEmitter(name);
+    emitter->position = position;
+    emitter->shape = EmissionShape::Sphere;
+    emitter->shapeScale = XMFLOAT3(0.1f, 0.1f, 0.1f);
+    emitter->maxParticles = 20000;
+    emitter->emissionRate = 400.0f;
+    emitter->emissionBurst = 200.0f;
+    emitter->startLifetime = 1.2f;
+    emitter->startLifetimeVariation = 0.4f;
+    emitter->startVelocity = XMFLOAT3(0.0f, 4.0f, 0.0f);
+    emitter->startVelocityVariation = XMFLOAT3(5.0f, 4.0f, 5.0f);
+    emitter->startColor = XMFLOAT4(1.0f, 0.8f, 0.4f, 1.0f);
+    emitter->startSize = XMFLOAT2(0.03f, 0.03f);
+    emitter->colorOverLifetime = { { 0.0f, XMFLOAT4(1.0f, 0.9f, 0.6f, 1.0f) },
+                                   { 0.5f, XMFLOAT4(1.0f, 0.5f, 0.1f, 1.0f) },
+                                   { 1.0f, XMFLOAT4(0.6f, 0.1f, 0.0f, 0.0f) } };
+    emitter->gravity = XMFLOAT3(0.0f, -9.81f, 0.0f);
+    emitter->drag = 0.5f;
+    emitter->enableCollision = true;
+    emitter->bounciness = 0.4f;
+    emitter->friction = 0.3f;
+    emitter->renderMode = RenderMode::Stretched;
+    emitter->blendMode = BlendMode::Additive;
+    emitter->lodMaxParticles = emitter->maxParticles;
+    emitter->gpuSimulation = true;
+}
+
+void ParticleSystem::CreateRainEffect(const std::string& name, const XMFLOAT3& position) {
+    // Falls from a slab above position and stops on the first surface it reaches
+    auto emitter = CreateEmitter(name);
+    emitter->position = position;
+    emitter->shape = EmissionShape::Box;
+    emitter->shapeScale = XMFLOAT3(30.0f, 0.5f, 30.0f);
+    emitter->maxParticles = 200000;
+    emitter->emissionRate = 60000.0f;
+    emitter->startLifetime = 2.0f;
+    emitter->startLifetimeVariation = 0.5f;
+    emitter->startVelocity = XMFLOAT3(0.5f, -14.0f, 0.0f);
+    emitter->startVelocityVariation = XMFLOAT3(0.2f, 2.0f, 0.2f);
+    emitter->startColor = XMFLOAT4(0.7f, 0.75f, 0.85f, 0.35f);
+    emitter->startSize = XMFLOAT2(0.01f, 0.05f);
+    emitter->gravity = XMFLOAT3(0.0f, -9.81f, 0.0f);
+    emitter->drag = 0.3f;
+    emitter->enableCollision = true;
+    emitter->bounciness = 0.0f;
+    emitter->friction = 1.0f;
+    emitter->renderMode = RenderMode::Stretched;
+    emitter->blendMode = BlendMode::Alpha;
+    emitter->lodMaxParticles = emitter->maxParticles;
+    emitter->gpuSimulation = true;
+}
+
+void ParticleSystem::CreateSnowEffect(const std::string& name, const XMFLOAT3& position) {
+    auto emitter = CreateEmitter(name);
+    emitter->position = position;
+    emitter->shape = EmissionShape::Box;
+    emitter->shapeScale = XMFLOAT3(30.0f, 0.5f, 30.0f);
+    emitter->maxParticles = 100000;
+    emitter->emissionRate = 6000.0f;
+    emitter->startLifetime = 12.0f;
+    emitter->startLifetimeVariation = 3.0f;
+    emitter->startVelocity = XMFLOAT3(0.0f, -1.2f, 0.0f);
+    emitter->startVelocityVariation = XMFLOAT3(0.3f, 0.3f, 0.3f);
+    emitter->startColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.9f);
+    emitter->startSize = XMFLOAT2(0.05f, 0.05f);
+    emitter->startSizeVariation = XMFLOAT2(0.02f, 0.02f);
+    emitter->startRotationVariation = XM_PI;
+    emitter->startAngularVelocity = 1.0f;
+    emitter->colorOverLifetime = { { 0.0f, XMFLOAT4(1.0f, 1.0f, 1.0f, 0.0f) },
+                                   { 0.1f, XMFLOAT4(1.0f, 1.0f, 1.0f, 0.9f) },
+                                   { 0.9f, XMFLOAT4(1.0f, 1.0f, 1.0f, 0.9f) },
+                                   { 1.0f, XMFLOAT4(1.0f, 1.0f, 1.0f, 0.0f) } };
+    // Flakes drift at close to terminal speed through a slow noise field
+    emitter->gravity = XMFLOAT3(0.0f, -1.0f, 0.0f);
+    emitter->drag = 0.8f;
+    emitter->enableNoise = true;
+    emitter->noiseStrength = 1.5f;
+    emitter->noiseFrequency = 0.3f;
+    emitter->enableCollision = true;
+    emitter->bounciness = 0.0f;
+    emitter->friction = 1.0f;
+    emitter->renderMode = RenderMode::Billboard;
+    emitter->blendMode = BlendMode::Alpha;
+    emitter->lodMaxParticles = emitter->maxParticles;
+    emitter->gpuSimulation = true;
+}
+
+void ParticleSystem::CreateSmokeEffect(const std::string& name, const XMFLOAT3& position) {
+    // Alpha blended and overlapping heavily, so it relies on the back to front sort
+    auto emitter = CreateEmitter(name);
+    emitter->position = position;
+    emitter->shape = EmissionShape::Circle;
+    emitter->shapeScale = XMFLOAT3(0.5f, 0.5f, 0.5f);
+    emitter->maxParticles = 4000;
+    emitter->emissionRate = 120.0f;
+    emitter->startLifetime = 6.0f;
+    emitter->startLifetimeVariation = 1.5f;
+    emitter->startVelocity = XMFLOAT3(0.0f, 1.2f, 0.0f);
+    emitter->startVelocityVariation = XMFLOAT3(0.3f, 0.3f, 0.3f);
+    emitter->startColor = XMFLOAT4(0.45f, 0.45f, 0.45f, 0.6f);
+    emitter->startSize = XMFLOAT2(0.6f, 0.6f);
+    emitter->startSizeVariation = XMFLOAT2(0.2f, 0.2f);
+    emitter->startRotationVariation = XM_PI;
+    emitter->startAngularVelocity = 0.3f;
+    emitter->colorOverLifetime = { { 0.0f, XMFLOAT4(0.35f, 0.35f, 0.35f, 0.0f) },
+                                   { 0.15f, XMFLOAT4(0.4f, 0.4f, 0.4f, 0.6f) },
+                                   { 1.0f, XMFLOAT4(0.6f, 0.6f, 0.6f, 0.0f) } };
+    emitter->sizeOverLifetime = { { 0.0f, XMFLOAT2(0.5f, 0.5f) },
+                                  { 1.0f, XMFLOAT2(4.0f, 4.0f) } };
+    emitter->gravity = XMFLOAT3(0.0f, 0.2f, 0.0f);
+    emitter->drag = 0.6f;
+    emitter->enableNoise = true;
+    emitter->noiseStrength = 0.6f;
+    emitter->noiseFrequency = 0.4f;
+    emitter->renderMode = RenderMode::Billboard;
+    emitter->blendMode = BlendMode::Alpha;
+    emitter->lodMaxParticles = emitter->maxParticles;
+    emitter->gpuSimulation = true;
+}
+
+void ParticleSystem::SetSortParticles(bool sort) {
+    sortParticles_ = sort;
+    if (gpuSystem_) {
+        std::lock_guard<std::mutex> lock(gpuSystem_->stagingMutex);
+        gpuSystem_->sortEnabled = sort;
+    }
+}
+
+void ParticleSystem::SetMaxParticles(int maxParticles) {
+    manager_->maxTotalParticles = std::max(maxParticles, 0);
+}
+
+void ParticleSystem::SetUpdateFrequency(float frequency) {
+    manager_->updateFrequency = std::max(frequency, 0.0f);
+}
+
+void ParticleSystem::EnableLOD(bool enable) {
+    lodEnabled_ = enable;
+}
+
+void ParticleSystem::SetLODDistances(float nearDist, float farDist, float cullDist) {
+    manager_->lodNearDistance = nearDist;
+    manager_->lodFarDistance = std::max(farDist, nearDist);
+    manager_->lodCullingDistance = cullDist;
+}
+
+void ParticleSystem::SetView(const XMFLOAT4X4& view, const XMFLOAT4X4& projection) {
+    XMMATRIX viewMatrix = XMLoadFloat4x4(&view);
+    XMStoreFloat3(&viewPosition_, XMMatrixInverse(nullptr, viewMatrix).r[3]);
+    viewFrustum_ = Frustum::FromViewProjection(XMMatrixMultiply(viewMatrix, XMLoadFloat4x4(&projection)));
+    viewValid_ = true;
+}
+
+void ParticleSystem::WarmupEmitter(const std::string& name, float time) {
+    if (auto emitter = GetEmitter(name)) {
+        ApplyLOD(*emitter, emitter->lodFactor);
+        FastForward(*emitter, time);
+        UpdateBounds(*emitter);
+    }
+}
+
+void ParticleSystem::EnableMultithreading(bool enable) {
+    multithreadingEnabled_ = enable;
+    manager_->useMultithreading = enable;
+}
+
 void ParticleSystem::Update(float deltaTime) {
-    // Basic particle system update
-    // TODO: Implement particle logic
+    NEXUS_PROFILE_SCOPE("ParticleSystem::Update");
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // One job per emitter; emitters only touch their own state, and the GPU system's staging
+    // is locked. Large emitters split their own update further from inside the job
+    const std::vector<std::shared_ptr<ParticleEmitter>>& emitters = manager_->emitters;
+
+    // Particles that die this update are only given back to the budget on the next one
+    int liveParticles = 0;
+    for (const std::shared_ptr<ParticleEmitter>& emitter : emitters) {
+        liveParticles += static_cast<int>(emitter->particles.count);
+    }
+    particleBudget_.store(std::max(manager_->maxTotalParticles - liveParticles, 0), std::memory_order_relaxed);
+
+    auto update = [this, &emitters, deltaTime](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            TickEmitter(*emitters[i], deltaTime);
+        }
+    };
+    if (CanUseJobs() && emitters.size() > 1) {
+        jobs_->ParallelFor(emitters.size(), 1, update);
+    } else {
+        update(0, emitters.size());
+    }
+
+    int totalParticles = 0;
+    int activeEmitters = 0;
+    for (const std::shared_ptr<ParticleEmitter>& emitter : emitters) {
+        totalParticles += emitter->aliveParticleCount;
+        if (emitter->isActive) activeEmitters++;
+    }
+
+    totalParticles_ = manager_->totalParticles = totalParticles;
+    activeEmitters_ = manager_->activeEmitters = activeEmitters;
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    lastUpdateTime_ = manager_->lastUpdateTime = elapsed.count();
+}
+
+void ParticleSystem::EnableGPUSimulation(bool enable) {
+    if (enable && !gpuSystem_ && device_) {
+        auto gpuSystem = std::make_unique<GPUParticleSystem>();
+        if (gpuSystem->Initialize(device_, context_)) {
+            gpuSystem->sortEnabled = sortParticles_;
+            gpuSystem_ = std::move(gpuSystem);
+        } else {
+            Logger::Warning("ParticleSystem: GPU simulation unavailable, GPU emitters run on the CPU");
+        }
+    } else if (!enable && gpuSystem_) {
+        for (const std::shared_ptr<ParticleEmitter>& emitter : manager_->emitters) {
+            emitter->gpuPool.reset();
+        }
+        gpuSystem_.reset();
+    }
+    gpuSimulationEnabled_ = gpuSystem_ != nullptr;
+}
+
+bool ParticleSystem::CanUseJobs() const {
+    return jobs_ && multithreadingEnabled_ && jobs_->IsInitialized() && jobs_->GetWorkerCount() > 0;
+}
+
+void ParticleSystem::TickEmitter(ParticleEmitter& emitter, float deltaTime) {
+    const bool useLOD = lodEnabled_ && viewValid_;
+
+    // Without measured particles, or after the emitter may have moved away from them, assume the
+    // furthest they could have gone; otherwise the source's current place is added
+    if (emitter.culled || emitter.particles.count == 0) {
+        emitter.bounds = PredictBounds(emitter, true);
+    } else {
+        emitter.bounds = Merge(emitter.bounds, PredictBounds(emitter, false));
+    }
+
+    // Looping emitters out of sight only keep time. One-shots run on, so they finish on schedule
+    if (useLOD && emitter.isLooping && ShouldCullEmitter(emitter)) {
+        emitter.culled = true;
+        emitter.pendingTime += deltaTime;
+        return;
+    }
+    if (emitter.culled) {
+        emitter.culled = false;
+        FastForward(emitter, std::exchange(emitter.pendingTime, 0.0f));
+    }
+
+    const float lodFactor = useLOD ? CalculateLODFactor(emitter) : 1.0f;
+    emitter.lodFactor = lodFactor;
+    ApplyLOD(emitter, lodFactor);
+
+    // Distant emitters wait out their interval, then simulate all of it in one update
+    emitter.pendingTime += deltaTime;
+    const float frequency = manager_->updateFrequency;
+    if (useLOD && frequency > 0.0f && emitter.pendingTime < (1.0f - lodFactor) / frequency) return;
+    UpdateEmitter(emitter, std::exchange(emitter.pendingTime, 0.0f));
+    UpdateBounds(emitter);
+}
+
+float ParticleSystem::CalculateLODFactor(const ParticleEmitter& emitter) const {
+    float nearDistance = emitter.lodDistance > 0.0f ? emitter.lodDistance : manager_->lodNearDistance;
+    float fadeDistance = emitter.lodFadeDistance > 0.0f ? emitter.lodFadeDistance : manager_->lodFarDistance - nearDistance;
+    float distance = DistanceToBounds(viewPosition_, emitter.bounds);
+    if (fadeDistance <= 0.0f) return distance <= nearDistance ? 1.0f : 0.0f;
+    return 1.0f - std::min(std::max((distance - nearDistance) / fadeDistance, 0.0f), 1.0f);
+}
+
+bool ParticleSystem::ShouldCullEmitter(const ParticleEmitter& emitter) const {
+    return DistanceToBounds(viewPosition_, emitter.bounds) > manager_->lodCullingDistance ||
+           !viewFrustum_.Intersects(emitter.bounds);
+}
+
+void ParticleSystem::ApplyLOD(ParticleEmitter& emitter, float lodFactor) const {
+    // Emission scales with the particles allowed, so a thinned emitter keeps its look over time
+    int full = std::max(emitter.maxParticles, 0);
+    int reduced = std::min(std::max(emitter.lodMaxParticles, 0), full);
+    emitter.lodParticleLimit = reduced + static_cast<int>(static_cast<float>(full - reduced) * lodFactor);
+    emitter.lodEmissionScale = full > 0 ? static_cast<float>(emitter.lodParticleLimit) / static_cast<float>(full) : 0.0f;
+}
+
+void ParticleSystem::FastForward(ParticleEmitter& emitter, float time) {
+    // GPU pools were left alone meanwhile and carry on from where they stopped; staging the
+    // whole gap at once would emit it as one burst
+    if (time <= 0.0f || (emitter.gpuSimulation && gpuSystem_)) return;
+
+    // Nothing emitted longer ago than the longest lifetime is still alive, so only the clock
+    // moves through the rest
+    float longest = std::max(emitter.startLifetime + emitter.startLifetimeVariation, FAST_FORWARD_STEP);
+    if (time > longest) {
+        emitter.systemTime += time - longest;
+        time = longest;
+    }
+    while (time > 0.0f) {
+        float step = std::min(time, FAST_FORWARD_STEP);
+        UpdateEmitter(emitter, step);
+        time -= step;
+    }
+}
+
+AABB ParticleSystem::PredictBounds(const ParticleEmitter& emitter, bool travel) const {
+    float reach = SpriteReach(emitter);
+    if (travel) {
+        // The fastest start plus constant acceleration over the longest life, in any direction
+        float life = emitter.startLifetime + emitter.startLifetimeVariation;
+        XMFLOAT3 speed(std::abs(emitter.startVelocity.x) + emitter.startVelocityVariation.x,
+                       std::abs(emitter.startVelocity.y) + emitter.startVelocityVariation.y,
+                       std::abs(emitter.startVelocity.z) + emitter.startVelocityVariation.z);
+        float inverseMass = emitter.startMass > 0.0f ? 1.0f / emitter.startMass : 1.0f;
+        XMFLOAT3 acceleration(emitter.gravity.x + emitter.constantForce.x * inverseMass,
+                              emitter.gravity.y + emitter.constantForce.y * inverseMass,
+                              emitter.gravity.z + emitter.constantForce.z * inverseMass);
+        float accelerationLength = std::sqrt(acceleration.x * acceleration.x + acceleration.y * acceleration.y +
+                                             acceleration.z * acceleration.z) +
+                                   (emitter.enableNoise ? emitter.noiseStrength : 0.0f);
+        float speedLength = std::sqrt(speed.x * speed.x + speed.y * speed.y + speed.z * speed.z);
+        reach += speedLength * life + 0.5f * accelerationLength * life * life;
+    }
+    return Grow(ShapeBounds(emitter), reach);
+}
+
+void ParticleSystem::UpdateBounds(ParticleEmitter& emitter) const {
+    const ParticleStreams& particles = emitter.particles;
+    const size_t count = particles.count;
+    if (count == 0) {
+        emitter.bounds = PredictBounds(emitter, true);
+        return;
+    }
+
+    // The particle centres, four at a time, and the shape new ones appear in
+    AABB bounds = ShapeBounds(emitter);
+    const float* positionX = particles[Streams::POSITION_X];
+    const float* positionY = particles[Streams::POSITION_Y];
+    const float* positionZ = particles[Streams::POSITION_Z];
+    __m128 minX = _mm_set1_ps(bounds.min.x), minY = _mm_set1_ps(bounds.min.y), minZ = _mm_set1_ps(bounds.min.z);
+    __m128 maxX = _mm_set1_ps(bounds.max.x), maxY = _mm_set1_ps(bounds.max.y), maxZ = _mm_set1_ps(bounds.max.z);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(positionX + i), y = _mm_loadu_ps(positionY + i), z = _mm_loadu_ps(positionZ + i);
+        minX = _mm_min_ps(minX, x);
+        minY = _mm_min_ps(minY, y);
+        minZ = _mm_min_ps(minZ, z);
+        maxX = _mm_max_ps(maxX, x);
+        maxY = _mm_max_ps(maxY, y);
+        maxZ = _mm_max_ps(maxZ, z);
+    }
+    bounds = { XMFLOAT3(HorizontalMin(minX), HorizontalMin(minY), HorizontalMin(minZ)),
+               XMFLOAT3(HorizontalMax(maxX), HorizontalMax(maxY), HorizontalMax(maxZ)) };
+    for (; i < count; ++i) {
+        bounds = Merge(bounds, AABB{ XMFLOAT3(positionX[i], positionY[i], positionZ[i]),
+                                     XMFLOAT3(positionX[i], positionY[i], positionZ[i]) });
+    }
+    emitter.bounds = Grow(bounds, SpriteReach(emitter));
+}
+
+void ParticleSystem::UpdateEmitter(ParticleEmitter& emitter, float deltaTime) {
+    if (emitter.gpuSimulation && gpuSystem_) {
+        UpdateGPUEmitter(emitter, deltaTime);
+        return;
+    }
+
+    // A finished one-shot holds no block until it is started again
+    ParticleStreams& particles = emitter.particles;
+    if (IsFinished(emitter)) {
+        if (particles.GetCapacity() > 0) RecyclePool(emitter);
+        emitter.aliveParticleCount = 0;
+        return;
+    }
+    ReservePool(emitter);
+
+    // Existing particles first, so new ones start their life untouched
+    BakeCurves(emitter);
+    size_t count = particles.count;
+    auto update = [this, &emitter, deltaTime](size_t begin, size_t end) {
+        UpdateParticles(emitter, begin, end, deltaTime);
+    };
+    if (CanUseJobs() && count >= PARALLEL_THRESHOLD) {
+        // Multiples of four keep the SSE groups whole
+        size_t grain = std::max<size_t>(count / (jobs_->GetWorkerCount() * 4), 4096) & ~size_t(3);
+        jobs_->ParallelFor(count, grain, update);
+    } else if (count > 0) {
+        update(0, count);
+    }
+
+    if (emitter.customUpdateFunction) {
+        Particle particle;
+        for (size_t i = 0; i < particles.count; ++i) {
+            particles.Get(i, particle);
+            emitter.customUpdateFunction(particle, deltaTime);
+            particles.Set(i, particle);
+        }
+    }
+    CompactParticles(emitter);
+
+    const size_t limit = std::min(static_cast<size_t>(std::max(emitter.lodParticleLimit, 0)), particles.GetCapacity());
+    int room = static_cast<int>(limit - std::min(particles.count, limit));
+    int emitCount = ClaimParticles(std::min(CountEmissions(emitter, deltaTime), room));
+    for (int i = 0; i < emitCount; ++i) {
+        EmitParticle(emitter);
+    }
+
+    emitter.aliveParticleCount = static_cast<int>(particles.count);
+}
+
+void ParticleSystem::ReservePool(ParticleEmitter& emitter) {
+    ParticleStreams& particles = emitter.particles;
+    size_t capacity = static_cast<size_t>(std::min(std::max(emitter.maxParticles, 0), manager_->maxParticlesPerSystem));
+    if (particles.GetCapacity() == capacity) return;
+
+    // An empty emitter takes the smallest spare block that fits
+    size_t stride = ParticleStreams::StrideFor(capacity);
+    if (particles.count == 0 && particles.stride < stride) {
+        std::lock_guard<std::mutex> lock(emitterMutex_);
+        std::vector<ParticleStreams>& spares = manager_->sparePools;
+        auto best = spares.end();
+        for (auto it = spares.begin(); it != spares.end(); ++it) {
+            if (it->stride >= stride && (best == spares.end() || it->stride < best->stride)) best = it;
+        }
+        if (best != spares.end()) {
+            std::swap(particles, *best);
+            if (best->stride == 0) spares.erase(best);
+            particles.count = 0;
+        }
+    }
+    particles.Reserve(capacity);
+}
+
+void ParticleSystem::RecyclePool(ParticleEmitter& emitter) {
+    ParticleStreams pool;
+    std::swap(pool, emitter.particles);
+    emitter.aliveParticleCount = 0;
+    if (pool.stride == 0) return;
+
+    // Past the limit the smallest block is let go
+    std::lock_guard<std::mutex> lock(emitterMutex_);
+    std::vector<ParticleStreams>& spares = manager_->sparePools;
+    if (spares.size() < MAX_SPARE_POOLS) {
+        spares.push_back(std::move(pool));
+        return;
+    }
+    auto smallest = std::min_element(spares.begin(), spares.end(), [](const ParticleStreams& a, const ParticleStreams& b) {
+        return a.stride < b.stride;
+    });
+    if (smallest->stride < pool.stride) *smallest = std::move(pool);
+}
+
+int ParticleSystem::ClaimParticles(int wanted) {
+    int available = particleBudget_.load(std::memory_order_relaxed);
+    int granted;
+    do {
+        granted = std::min(wanted, available);
+        if (granted <= 0) return 0;
+    } while (!particleBudget_.compare_exchange_weak(available, available - granted, std::memory_order_relaxed));
+    return granted;
+}
+
+bool ParticleSystem::IsFinished(const ParticleEmitter& emitter) const {
+    return !emitter.isLooping && emitter.hasEmittedBurst && emitter.particles.count == 0 &&
+           emitter.systemTime - emitter.emissionDelay > emitter.emissionDuration;
+}
+
+void ParticleSystem::UpdateGPUEmitter(ParticleEmitter& emitter, float deltaTime) {
+    // Whatever the CPU simulated before the switch is dropped
+    if (emitter.particles.GetCapacity() > 0) RecyclePool(emitter);
+    emitter.aliveParticleCount = 0;
+    if (!gpuSystem_->EnsurePool(emitter.gpuPool, emitter.maxParticles)) return;
+
+    BakeCurves(emitter);
+    int emitCount = CountEmissions(emitter, deltaTime);
+    gpuSystem_->Stage(*emitter.gpuPool, emitter, manager_->globalForces, emitCount, deltaTime);
+    emitter.emittedParticleCount += emitCount;
+}
+
+int ParticleSystem::CountEmissions(ParticleEmitter& emitter, float deltaTime) {
+    if (!emitter.isActive) return 0;
+
+    int emitCount = 0;
+    emitter.systemTime += deltaTime;
+    float activeTime = emitter.systemTime - emitter.emissionDelay;
+    if (activeTime >= 0.0f) {
+        if (!emitter.hasEmittedBurst) {
+            emitter.hasEmittedBurst = true;
+            emitCount += static_cast<int>(emitter.emissionBurst * emitter.lodEmissionScale);
+        }
+        if (emitter.isLooping || activeTime <= emitter.emissionDuration) {
+            emitter.emissionTimer += deltaTime * emitter.emissionRate * emitter.lodEmissionScale;
+            int rateCount = static_cast<int>(emitter.emissionTimer);
+            emitter.emissionTimer -= static_cast<float>(rateCount);
+            emitCount += rateCount;
+        }
+    }
+    return emitCount;
+}
+
+void ParticleSystem::UpdateParticles(ParticleEmitter& emitter, size_t begin, size_t end, float deltaTime) const {
+    ParticleStreams& particles = emitter.particles;
+    float* positionX = particles[Streams::POSITION_X];
+    float* positionY = particles[Streams::POSITION_Y];
+    float* positionZ = particles[Streams::POSITION_Z];
+    float* velocityX = particles[Streams::VELOCITY_X];
+    float* velocityY = particles[Streams::VELOCITY_Y];
+    float* velocityZ = particles[Streams::VELOCITY_Z];
+    float* rotation = particles[Streams::ROTATION];
+    const float* angularVelocity = particles[Streams::ANGULAR_VELOCITY];
+    float* life = particles[Streams::LIFE];
+    const float* inverseMaxLife = particles[Streams::INVERSE_MAX_LIFE];
+
+    // Constant force is shared by every particle, so it folds into gravity as an acceleration
+    const float inverseMass = emitter.startMass > 0.0f ? 1.0f / emitter.startMass : 1.0f;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 time = _mm_set1_ps(deltaTime);
+    const __m128 keep = _mm_set1_ps(std::max(1.0f - emitter.drag * deltaTime, 0.0f));
+    const __m128 accelerationX = _mm_set1_ps((emitter.gravity.x + emitter.constantForce.x * inverseMass) * deltaTime);
+    const __m128 accelerationY = _mm_set1_ps((emitter.gravity.y + emitter.constantForce.y * inverseMass) * deltaTime);
+    const __m128 accelerationZ = _mm_set1_ps((emitter.gravity.z + emitter.constantForce.z * inverseMass) * deltaTime);
+
+    const float* colorTable = emitter.colorTable.empty() ? nullptr : &emitter.colorTable[0].x;
+    const float* sizeTable = emitter.sizeTable.empty() ? nullptr : &emitter.sizeTable[0].x;
+    const float* speedTable = emitter.speedTable.empty() ? nullptr : emitter.speedTable.data();
+    const float* spinTable = emitter.spinTable.empty() ? nullptr : emitter.spinTable.data();
+    const bool sampleCurves = colorTable || sizeTable || speedTable || spinTable;
+    const __m128 lastSegment = _mm_set1_ps(static_cast<float>(CURVE_SAMPLES - 1));
+    const __m128 lastSegmentStart = _mm_set1_ps(static_cast<float>(CURVE_SAMPLES - 2));
+    const bool collide = emitter.enableCollision && !emitter.collisionPlanes.empty();
+    const __m128 bounce = _mm_set1_ps(emitter.bounciness);
+    const __m128 slide = _mm_set1_ps(1.0f - emitter.friction);
+
+    for (size_t i = begin; i < end; i += 4) {
+        __m128 remaining = _mm_sub_ps(_mm_loadu_ps(life + i), time);
+        _mm_storeu_ps(life + i, remaining);
+
+        // Every curve is read at the same age, so the table indices are found once
+        alignas(16) int32_t indices[4];
+        __m128 fraction = zero;
+        if (sampleCurves) {
+            __m128 age = _mm_sub_ps(one, _mm_mul_ps(remaining, _mm_loadu_ps(inverseMaxLife + i)));
+            __m128 x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(age, zero), one), lastSegment);
+            __m128i segment = _mm_cvttps_epi32(_mm_min_ps(x, lastSegmentStart));
+            fraction = _mm_sub_ps(x, _mm_cvtepi32_ps(segment));
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), segment);
+        }
+        const __m128 moveTime = speedTable ? _mm_mul_ps(time, SampleCurve(speedTable, indices, fraction, 1, 0)) : time;
+        const __m128 turnTime = spinTable ? _mm_mul_ps(time, SampleCurve(spinTable, indices, fraction, 1, 0)) : time;
+
+        __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(velocityX + i), accelerationX), keep);
+        __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(velocityY + i), accelerationY), keep);
+        __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(velocityZ + i), accelerationZ), keep);
+        __m128 px = _mm_add_ps(_mm_loadu_ps(positionX + i), _mm_mul_ps(vx, moveTime));
+        __m128 py = _mm_add_ps(_mm_loadu_ps(positionY + i), _mm_mul_ps(vy, moveTime));
+        __m128 pz = _mm_add_ps(_mm_loadu_ps(positionZ + i), _mm_mul_ps(vz, moveTime));
+        _mm_storeu_ps(rotation + i, _mm_add_ps(_mm_loadu_ps(rotation + i), _mm_mul_ps(_mm_loadu_ps(angularVelocity + i), turnTime)));
+
+        if (colorTable) {
+            _mm_storeu_ps(particles[Streams::COLOR_R] + i, SampleCurve(colorTable, indices, fraction, 4, 0));
+            _mm_storeu_ps(particles[Streams::COLOR_G] + i, SampleCurve(colorTable, indices, fraction, 4, 1));
+            _mm_storeu_ps(particles[Streams::COLOR_B] + i, SampleCurve(colorTable, indices, fraction, 4, 2));
+            _mm_storeu_ps(particles[Streams::COLOR_A] + i, SampleCurve(colorTable, indices, fraction, 4, 3));
+        }
+        if (sizeTable) {
+            _mm_storeu_ps(particles[Streams::SIZE_X] + i, SampleCurve(sizeTable, indices, fraction, 2, 0));
+            _mm_storeu_ps(particles[Streams::SIZE_Y] + i, SampleCurve(sizeTable, indices, fraction, 2, 1));
+        }
+
+        if (collide) {
+            // Planes are (normal, d) with the allowed side where dot(normal, p) + d >= 0
+            for (const XMFLOAT4& plane : emitter.collisionPlanes) {
+                const __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z);
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, nx), _mm_mul_ps(py, ny)), _mm_mul_ps(pz, nz)),
+                                             _mm_set1_ps(plane.w));
+                __m128 below = _mm_cmplt_ps(distance, zero);
+                __m128 push = _mm_and_ps(below, distance);
+                px = _mm_sub_ps(px, _mm_mul_ps(nx, push));
+                py = _mm_sub_ps(py, _mm_mul_ps(ny, push));
+                pz = _mm_sub_ps(pz, _mm_mul_ps(nz, push));
+
+                // Reflect the normal speed by the bounciness, scale the rest by the friction
+                __m128 normalSpeed = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, nx), _mm_mul_ps(vy, ny)), _mm_mul_ps(vz, nz));
+                __m128 hit = _mm_and_ps(below, _mm_cmplt_ps(normalSpeed, zero));
+                __m128 reflected = _mm_mul_ps(normalSpeed, bounce);
+                vx = Select(hit, _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(vx, _mm_mul_ps(nx, normalSpeed)), slide), _mm_mul_ps(nx, reflected)), vx);
+                vy = Select(hit, _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(vy, _mm_mul_ps(ny, normalSpeed)), slide), _mm_mul_ps(ny, reflected)), vy);
+                vz = Select(hit, _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(vz, _mm_mul_ps(nz, normalSpeed)), slide), _mm_mul_ps(nz, reflected)), vz);
+            }
+        }
+
+        _mm_storeu_ps(velocityX + i, vx);
+        _mm_storeu_ps(velocityY + i, vy);
+        _mm_storeu_ps(velocityZ + i, vz);
+        _mm_storeu_ps(positionX + i, px);
+        _mm_storeu_ps(positionY + i, py);
+        _mm_storeu_ps(positionZ + i, pz);
+    }
+}
+
+void ParticleSystem::CompactParticles(ParticleEmitter& emitter) {
+    ParticleStreams& particles = emitter.particles;
+    const float* life = particles[Streams::LIFE];
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    while (i < particles.count) {
+        // Most particles live on, so whole groups of four are passed over with one compare
+        if (i + 4 <= particles.count && _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(life + i), zero)) == 0) {
+            i += 4;
+        } else if (life[i] > 0.0f) {
+            ++i;
+        } else {
+            particles.Remove(i);   // The last particle moves in and is checked next
+        }
+    }
+}
+
+void ParticleSystem::BakeCurves(ParticleEmitter& emitter) const {
+    // Curves are edited in place, so they are compared by hash rather than flagged
+    uint64_t hash = 14695981039346656037ull;
+    HashCurve(hash, emitter.colorOverLifetime);
+    HashCurve(hash, emitter.sizeOverLifetime);
+    HashCurve(hash, emitter.velocityOverLifetime);
+    HashCurve(hash, emitter.rotationOverLifetime);
+    if (emitter.curveVersion != 0 && hash == emitter.curveHash) return;
+    emitter.curveHash = hash;
+    emitter.curveVersion++;
+
+    emitter.colorTable.clear();
+    emitter.sizeTable.clear();
+    emitter.speedTable.clear();
+    emitter.spinTable.clear();
+    if (!emitter.colorOverLifetime.empty()) {
+        emitter.colorTable.resize(CURVE_SAMPLES);
+        for (size_t i = 0; i < CURVE_SAMPLES; ++i) {
+            emitter.colorTable[i] = InterpolateColor(emitter.colorOverLifetime, static_cast<float>(i) / (CURVE_SAMPLES - 1));
+        }
+    }
+    if (!emitter.sizeOverLifetime.empty()) {
+        emitter.sizeTable.resize(CURVE_SAMPLES);
+        for (size_t i = 0; i < CURVE_SAMPLES; ++i) {
+            emitter.sizeTable[i] = InterpolateSize(emitter.sizeOverLifetime, static_cast<float>(i) / (CURVE_SAMPLES - 1));
+        }
+    }
+    if (!emitter.velocityOverLifetime.empty()) {
+        emitter.speedTable.resize(CURVE_SAMPLES);
+        for (size_t i = 0; i < CURVE_SAMPLES; ++i) {
+            emitter.speedTable[i] = InterpolateFloat(emitter.velocityOverLifetime, static_cast<float>(i) / (CURVE_SAMPLES - 1));
+        }
+    }
+    if (!emitter.rotationOverLifetime.empty()) {
+        emitter.spinTable.resize(CURVE_SAMPLES);
+        for (size_t i = 0; i < CURVE_SAMPLES; ++i) {
+            emitter.spinTable[i] = InterpolateFloat(emitter.rotationOverLifetime, static_cast<float>(i) / (CURVE_SAMPLES - 1));
+        }
+    }
+}
+
+float ParticleSystem::InterpolateFloat(const std::vector<std::pair<float, float>>& curve, float time) const {
+    if (curve.empty()) return 0.0f;
+    if (time <= curve.front().first) return curve.front().second;
+    for (size_t i = 1; i < curve.size(); ++i) {
+        if (time <= curve[i].first) {
+            float span = curve[i].first - curve[i - 1].first;
+            float t = span > 0.0f ? (time - curve[i - 1].first) / span : 1.0f;
+            return curve[i - 1].second + (curve[i].second - curve[i - 1].second) * t;
+        }
+    }
+    return curve.back().second;
+}
+
+D3DXVECTOR4 ParticleSystem::InterpolateColor(const std::vector<std::pair<float, D3DXVECTOR4>>& curve, float time) const {
+    if (curve.empty()) return D3DXVECTOR4(1.0f, 1.0f, 1.0f, 1.0f);
+    if (time <= curve.front().first) return curve.front().second;
+    for (size_t i = 1; i < curve.size(); ++i) {
+        if (time <= curve[i].first) {
+            float span = curve[i].first - curve[i - 1].first;
+            XMVECTOR a = XMLoadFloat4(&curve[i - 1].second);
+            XMVECTOR b = XMLoadFloat4(&curve[i].second);
+            D3DXVECTOR4 result;
+            XMStoreFloat4(&result, XMVectorLerp(a, b, span > 0.0f ? (time - curve[i - 1].first) / span : 1.0f));
+            return result;
+        }
+    }
+    return curve.back().second;
+}
+
+D3DXVECTOR2 ParticleSystem::InterpolateSize(const std::vector<std::pair<float, D3DXVECTOR2>>& curve, float time) const {
+    if (curve.empty()) return D3DXVECTOR2(1.0f, 1.0f);
+    if (time <= curve.front().first) return curve.front().second;
+    for (size_t i = 1; i < curve.size(); ++i) {
+        if (time <= curve[i].first) {
+            float span = curve[i].first - curve[i - 1].first;
+            XMVECTOR a = XMLoadFloat2(&curve[i - 1].second);
+            XMVECTOR b = XMLoadFloat2(&curve[i].second);
+            D3DXVECTOR2 result;
+            XMStoreFloat2(&result, XMVectorLerp(a, b, span > 0.0f ? (time - curve[i - 1].first) / span : 1.0f));
+            return result;
+        }
+    }
+    return curve.back().second;
+}
+
+void ParticleSystem::EmitParticle(ParticleEmitter& emitter) {
+    if (emitter.particles.count >= emitter.particles.GetCapacity()) return;
+
+    std::mt19937& random = emitter.random;
+    auto uniform = [&random](float min, float max) {
+        return max > min ? std::uniform_real_distribution<float>(min, max)(random) : min;
+    };
+    auto vary = [&uniform](float value, float range) { return value + uniform(-range, range); };
+
+    // Offset from the emitter by shape; shapeScale is the radius or half extents
+    XMFLOAT3 offset(0.0f, 0.0f, 0.0f);
+    const XMFLOAT3& extent = emitter.shapeScale;
+    switch (emitter.shape) {
+    case EmissionShape::Sphere: {
+        float lengthSquared;
+        do {
+            offset = XMFLOAT3(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f));
+            lengthSquared = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+        } while (lengthSquared > 1.0f);
+        offset = XMFLOAT3(offset.x * extent.x, offset.y * extent.x, offset.z * extent.x);
+        break;
+    }
+    case EmissionShape::Box:
+        offset = XMFLOAT3(uniform(-extent.x, extent.x), uniform(-extent.y, extent.y), uniform(-extent.z, extent.z));
+        break;
+    case EmissionShape::Circle: {
+        float angle = uniform(0.0f, XM_2PI);
+        float radius = extent.x * std::sqrt(uniform(0.0f, 1.0f));
+        offset = XMFLOAT3(std::cos(angle) * radius, 0.0f, std::sin(angle) * radius);
+        break;
+    }
+    default:
+        break;
+    }
+
+    const XMFLOAT3& velocityVariation = emitter.startVelocityVariation;
+    const XMFLOAT4& colorVariation = emitter.startColorVariation;
+    Particle particle;
+    particle.position = XMFLOAT3(emitter.position.x + offset.x, emitter.position.y + offset.y, emitter.position.z + offset.z);
+    particle.velocity = XMFLOAT3(vary(emitter.startVelocity.x, velocityVariation.x), vary(emitter.startVelocity.y, velocityVariation.y),
+                                 vary(emitter.startVelocity.z, velocityVariation.z));
+    auto channel = [&vary](float value, float range) { return std::min(std::max(vary(value, range), 0.0f), 1.0f); };
+    particle.color = XMFLOAT4(channel(emitter.startColor.x, colorVariation.x), channel(emitter.startColor.y, colorVariation.y),
+                              channel(emitter.startColor.z, colorVariation.z), channel(emitter.startColor.w, colorVariation.w));
+    particle.size = XMFLOAT2(std::max(vary(emitter.startSize.x, emitter.startSizeVariation.x), 0.0f),
+                             std::max(vary(emitter.startSize.y, emitter.startSizeVariation.y), 0.0f));
+    particle.rotation = vary(emitter.startRotation, emitter.startRotationVariation);
+    particle.angularVelocity = emitter.startAngularVelocity;
+    particle.maxLife = std::max(vary(emitter.startLifetime, emitter.startLifetimeVariation), 0.001f);
+    particle.life = particle.maxLife;
+
+    emitter.particles.Add(particle);
+    emitter.emittedParticleCount++;
+}
+
+float ParticleSystem::RandomFloat(float min, float max) {
+    if (max <= min) return min;
+    return std::uniform_real_distribution<float>(min, max)(randomGenerator_);
+}
+
+D3DXVECTOR3 ParticleSystem::RandomVector3(const D3DXVECTOR3& min, const D3DXVECTOR3& max) {
+    return D3DXVECTOR3(RandomFloat(min.x, max.x), RandomFloat(min.y, max.y), RandomFloat(min.z, max.z));
+}
+
+D3DXVECTOR4 ParticleSystem::RandomColor(const D3DXVECTOR4& base, const D3DXVECTOR4& variation) {
+    auto channel = [this](float value, float range) {
+        return std::min(std::max(value + RandomFloat(-range, range), 0.0f), 1.0f);
+    };
+    return D3DXVECTOR4(channel(base.x, variation.x), channel(base.y, variation.y), channel(base.z, variation.z),
+                       channel(base.w, variation.w));
+}
+
+int ParticleSystem::GetTotalParticleCount() const {
+    return totalParticles_;
+}
+
+int ParticleSystem::GetActiveEmitterCount() const {
+    return activeEmitters_;
+}
+
+float ParticleSystem::GetLastUpdateTime() const {
+    return lastUpdateTime_;
+}
+
+void ParticleSystem::GetStatistics(int& totalParticles, int& activeEmitters, float& updateTime) const {
+    totalParticles = totalParticles_;
+    activeEmitters = activeEmitters_;
+    updateTime = lastUpdateTime_;
+}
+
+bool ParticleSystem::SaveEmitterConfig(const std::string& name, const std::string& filePath) {
+    auto emitter = GetEmitter(name);
+    if (!emitter) {
+        Logger::Warning("ParticleSystem: No emitter to save named " + name);
+        return false;
+    }
+
+    const ParticleEmitter& e = *emitter;
+    EmitterConfigRecord record = {};
+    record.shape = static_cast<uint32_t>(e.shape);
+    record.particleType = static_cast<uint32_t>(e.particleType);
+    record.renderMode = static_cast<uint32_t>(e.renderMode);
+    record.blendMode = static_cast<uint32_t>(e.blendMode);
+    record.flags = (e.isLooping ? CONFIG_LOOPING : 0) | (e.enableCollision ? CONFIG_COLLISION : 0) |
+                   (e.enableTrails ? CONFIG_TRAILS : 0) | (e.enableNoise ? CONFIG_NOISE : 0) |
+                   (e.useTextureSheetAnimation ? CONFIG_TEXTURE_SHEET_ANIMATION : 0) |
+                   (e.gpuSimulation ? CONFIG_GPU_SIMULATION : 0);
+    record.maxParticles = e.maxParticles;
+    record.trailSegments = e.trailSegments;
+    record.lodMaxParticles = e.lodMaxParticles;
+    record.emissionRate = e.emissionRate;
+    record.emissionBurst = e.emissionBurst;
+    record.emissionDuration = e.emissionDuration;
+    record.emissionDelay = e.emissionDelay;
+    record.shapeScale = e.shapeScale;
+    record.startLifetime = e.startLifetime;
+    record.startLifetimeVariation = e.startLifetimeVariation;
+    record.startVelocity = e.startVelocity;
+    record.startVelocityVariation = e.startVelocityVariation;
+    record.startColor = e.startColor;
+    record.startColorVariation = e.startColorVariation;
+    record.startSize = e.startSize;
+    record.startSizeVariation = e.startSizeVariation;
+    record.startRotation = e.startRotation;
+    record.startRotationVariation = e.startRotationVariation;
+    record.startAngularVelocity = e.startAngularVelocity;
+    record.startMass = e.startMass;
+    record.gravity = e.gravity;
+    record.drag = e.drag;
+    record.turbulence = e.turbulence;
+    record.constantForce = e.constantForce;
+    record.textureSheetTiles = e.textureSheetTiles;
+    record.textureSheetFrameRate = e.textureSheetFrameRate;
+    record.bounciness = e.bounciness;
+    record.friction = e.friction;
+    record.trailWidth = e.trailWidth;
+    record.trailLifetime = e.trailLifetime;
+    record.trailColor = e.trailColor;
+    record.noiseStrength = e.noiseStrength;
+    record.noiseFrequency = e.noiseFrequency;
+    record.noiseOffset = e.noiseOffset;
+    record.lodDistance = e.lodDistance;
+    record.lodFadeDistance = e.lodFadeDistance;
+
+    BinaryFileWriter writer(EMITTER_CONFIG_TYPE, EMITTER_CONFIG_VERSION);
+    writer.AddSection(SECTION_SETTINGS, GetEmitterConfigSchema(), &record, 1);
+    AddCurve(writer, SECTION_VELOCITY_CURVE, e.velocityOverLifetime);
+    AddCurve(writer, SECTION_COLOR_CURVE, e.colorOverLifetime);
+    AddCurve(writer, SECTION_SIZE_CURVE, e.sizeOverLifetime);
+    AddCurve(writer, SECTION_ROTATION_CURVE, e.rotationOverLifetime);
+    writer.AddSection(SECTION_COLLISION_PLANES, GetPlaneSchema(), e.collisionPlanes);
+    return writer.Write(filePath);
+}
+
+bool ParticleSystem::LoadEmitterConfig(const std::string& name, const std::string& filePath) {
+    BinaryFile file;
+    if (!file.Open(filePath, EMITTER_CONFIG_TYPE)) return false;
+    if (file.GetContentVersion() != EMITTER_CONFIG_VERSION) {
+        Logger::Warning("ParticleSystem: Emitter config is from another version: " + filePath);
+        return false;
+    }
+
+    std::vector<uint8_t> buffer;
+    size_t count = 0;
+    const EmitterConfigRecord* record =
+        file.GetSection<EmitterConfigRecord>(SECTION_SETTINGS, GetEmitterConfigSchema(), count, buffer);
+    std::vector<std::pair<float, float>> velocityCurve, rotationCurve;
+    std::vector<std::pair<float, XMFLOAT4>> colorCurve;
+    std::vector<std::pair<float, XMFLOAT2>> sizeCurve;
+    bool valid = record && count == 1 &&
+                 ReadCurve(file, SECTION_VELOCITY_CURVE, velocityCurve) &&
+                 ReadCurve(file, SECTION_COLOR_CURVE, colorCurve) &&
+                 ReadCurve(file, SECTION_SIZE_CURVE, sizeCurve) &&
+                 ReadCurve(file, SECTION_ROTATION_CURVE, rotationCurve);
+    const XMFLOAT4* planes = nullptr;
+    size_t planeCount = 0;
+    std::vector<uint8_t> planeBuffer;
+    if (valid) {
+        planes = file.GetSection<XMFLOAT4>(SECTION_COLLISION_PLANES, GetPlaneSchema(), planeCount, planeBuffer);
+        valid = planes != nullptr;
+    }
+    if (!valid) {
+        Logger::Error("ParticleSystem: Emitter config is damaged: " + filePath);
+        return false;
+    }
+
+    // Applied over an existing emitter, keeping its placement, textures and running particles
+    auto emitter = GetEmitter(name);
+    if (!emitter) emitter = CreateEmitter(name);
+    ParticleEmitter& e = *emitter;
+    e.shape = static_cast<EmissionShape>(std::min(record->shape, static_cast<uint32_t>(EmissionShape::Custom)));
+    e.particleType = static_cast<ParticleType>(std::min(record->particleType, static_cast<uint32_t>(ParticleType::Volumetric)));
+    e.renderMode = static_cast<RenderMode>(std::min(record->renderMode, static_cast<uint32_t>(RenderMode::VelocityAligned)));
+    e.blendMode = static_cast<BlendMode>(std::min(record->blendMode, static_cast<uint32_t>(BlendMode::Overlay)));
+    e.isLooping = (record->flags & CONFIG_LOOPING) != 0;
+    e.enableCollision = (record->flags & CONFIG_COLLISION) != 0;
+    e.enableTrails = (record->flags & CONFIG_TRAILS) != 0;
+    e.enableNoise = (record->flags & CONFIG_NOISE) != 0;
+    e.useTextureSheetAnimation = (record->flags & CONFIG_TEXTURE_SHEET_ANIMATION) != 0;
+    e.gpuSimulation = (record->flags & CONFIG_GPU_SIMULATION) != 0;
+    e.maxParticles = std::max(record->maxParticles, 0);
+    e.trailSegments = record->trailSegments;
+    e.lodMaxParticles = record->lodMaxParticles;
+    e.emissionRate = record->emissionRate;
+    e.emissionBurst = record->emissionBurst;
+    e.emissionDuration = record->emissionDuration;
+    e.emissionDelay = record->emissionDelay;
+    e.shapeScale = record->shapeScale;
+    e.startLifetime = record->startLifetime;
+    e.startLifetimeVariation = record->startLifetimeVariation;
+    e.startVelocity = record->startVelocity;
+    e.startVelocityVariation = record->startVelocityVariation;
+    e.startColor = record->startColor;
+    e.startColorVariation = record->startColorVariation;
+    e.startSize = record->startSize;
+    e.startSizeVariation = record->startSizeVariation;
+    e.startRotation = record->startRotation;
+    e.startRotationVariation = record->startRotationVariation;
+    e.startAngularVelocity = record->startAngularVelocity;
+    e.startMass = record->startMass;
+    e.gravity = record->gravity;
+    e.drag = record->drag;
+    e.turbulence = record->turbulence;
+    e.constantForce = record->constantForce;
+    e.textureSheetTiles = record->textureSheetTiles;
+    e.textureSheetFrameRate = record->textureSheetFrameRate;
+    e.bounciness = record->bounciness;
+    e.friction = record->friction;
+    e.trailWidth = record->trailWidth;
+    e.trailLifetime = record->trailLifetime;
+    e.trailColor = record->trailColor;
+    e.noiseStrength = record->noiseStrength;
+    e.noiseFrequency = record->noiseFrequency;
+    e.noiseOffset = record->noiseOffset;
+    e.lodDistance = record->lodDistance;
+    e.lodFadeDistance = record->lodFadeDistance;
+    // The curve hash picks up the new curves on the next bake
+    e.velocityOverLifetime = std::move(velocityCurve);
+    e.colorOverLifetime = std::move(colorCurve);
+    e.sizeOverLifetime = std::move(sizeCurve);
+    e.rotationOverLifetime = std::move(rotationCurve);
+    e.collisionPlanes.assign(planes, planes + planeCount);
+    return true;
 }
 
 void ParticleSystem::Render(Camera* camera) {
-    // Basic particle rendering
-    // TODO: Implement particle rendering
+    // CPU emitters have no renderer yet; GPU emitters draw here without depth collision
+    if (!camera || !gpuSystem_) return;
+    XMFLOAT4X4 view, projection;
+    XMStoreFloat4x4(&view, camera->GetViewMatrix());
+    XMStoreFloat4x4(&projection, camera->GetProjectionMatrix());
+    RenderGPU(view, projection, nullptr);
+}
+
+void ParticleSystem::SetPixelOverride(ID3D11PixelShader* shader, ID3D11BlendState* blend) {
+    if (!gpuSystem_) return;
+    gpuSystem_->overridePixelShader = shader;
+    gpuSystem_->overrideBlend = blend;
+}
+
+void ParticleSystem::RenderGPU(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, ID3D11ShaderResourceView* depth) {
+    if (!gpuSystem_) return;
+    NEXUS_PROFILE_SCOPE("ParticleSystem::RenderGPU");
+    gpuSystem_->Simulate(view, projection, depth);
+    gpuSystem_->Render(view, projection);
 }
 
 } // namespace Nexus
@@ -0,0 +1,548 @@
+#include "ProbeVolume.h"
+#include "Light.h"
+#include "Logger.h"
+#include "PhysicsEngine.h"
+#include "Profiler.h"
+#include "StateCache.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace Nexus {
+
+namespace {
+
+// Declarations and sampling shared by every shader that reads the volume. PBR_PS.hlsl repeats
+// them under PROBE_VOLUME; keep the two in step
+const char* PROBE_SHADER = R"(
+    cbuffer ProbeConstants : register(b3)
+    {
+        float3 ProbeOrigin;
+        uint ProbeEnabled;              // Zero when no volume is bound
+        float3 ProbeInverseSpacing;
+        uint ProbeL2;
+        float3 ProbeCounts;
+        float ProbeIntensity;
+    };
+
+    Texture3D<float4> ProbeSH : register(t13);
+    SamplerState ProbeSampler : register(s2);
+
+    // Planes are stacked along z; staying half a texel inside one keeps the filter out of the next
+    float4 ProbePlane(float3 cell, uint plane, uint planes)
+    {
+        float3 clamped = clamp(cell, 0.5f, ProbeCounts - 0.5f);
+        float z = (plane * ProbeCounts.z + clamped.z) / (ProbeCounts.z * planes);
+        return ProbeSH.SampleLevel(ProbeSampler, float3(clamped.xy / ProbeCounts.xy, z), 0.0f);
+    }
+
+    // Diffuse light at a point for normal N, to multiply by albedo
+    float3 SampleProbeIrradiance(float3 worldPos, float3 N)
+    {
+        float3 cell = (worldPos - ProbeOrigin) * ProbeInverseSpacing + 0.5f;
+        uint planes = ProbeL2 ? 7 : 3;
+        float4 p0 = ProbePlane(cell, 0, planes);
+        float4 p1 = ProbePlane(cell, 1, planes);
+        float4 p2 = ProbePlane(cell, 2, planes);
+        float3 result = p0.xyz * 0.282095f
+                      + float3(p0.w, p1.xy) * (0.488603f * N.y)
+                      + float3(p1.zw, p2.x) * (0.488603f * N.z)
+                      + p2.yzw * (0.488603f * N.x);
+        if (ProbeL2) {
+            float4 p3 = ProbePlane(cell, 3, planes);
+            float4 p4 = ProbePlane(cell, 4, planes);
+            float4 p5 = ProbePlane(cell, 5, planes);
+            float4 p6 = ProbePlane(cell, 6, planes);
+            result += p3.xyz * (1.092548f * N.x * N.y)
+                    + float3(p3.w, p4.xy) * (1.092548f * N.y * N.z)
+                    + float3(p4.zw, p5.x) * (0.315392f * (3.0f * N.z * N.z - 1.0f))
+                    + p5.yzw * (1.092548f * N.x * N.z)
+                    + p6.xyz * (0.546274f * (N.x * N.x - N.y * N.y));
+        }
+        return max(result, 0.0f) * ProbeIntensity;
+    }
+)";
+
+// Matches ProbeConstants above
+struct GpuProbeConstants {
+    XMFLOAT3 origin;
+    UINT enabled;
+    XMFLOAT3 inverseSpacing;
+    UINT l2;
+    XMFLOAT3 counts;
+    float intensity;
+};
+
+struct ProbeFileHeader {
+    static constexpr uint32_t MAGIC = 0x4252504E;   // "NPRB"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t countX;
+    uint32_t countY;
+    uint32_t countZ;
+    uint32_t coefficientCount;
+};
+
+// Cosine-lobe convolution per band divided by pi (pi, 2pi/3, pi/4 over pi)
+const float BAND_SCALE[ProbeVolume::L2_COEFFICIENTS] = {
+    1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f
+};
+const float SURFACE_BIAS = 0.05f;   // Ray hits are shaded this far off the surface
+
+// Real SH basis in the order the shader unpacks it
+void EvaluateBasis(const XMFLOAT3& d, float basis[ProbeVolume::L2_COEFFICIENTS]) {
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * d.y;
+    basis[2] = 0.488603f * d.z;
+    basis[3] = 0.488603f * d.x;
+    basis[4] = 1.092548f * d.x * d.y;
+    basis[5] = 1.092548f * d.y * d.z;
+    basis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+    basis[7] = 1.092548f * d.x * d.z;
+    basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+}
+
+XMFLOAT3 Scale(const XMFLOAT3& v, float s) { return XMFLOAT3(v.x * s, v.y * s, v.z * s); }
+void AddScaled(XMFLOAT3& target, const XMFLOAT3& v, float s) {
+    target.x += v.x * s;
+    target.y += v.y * s;
+    target.z += v.z * s;
+}
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+} // namespace
+
+ProbeVolume::ProbeVolume()
+    : device_(nullptr)
+    , context_(nullptr)
+    , cursor_(0)
+    , random_(0x5EED)
+    , texture_(nullptr)
+    , view_(nullptr)
+    , constants_(nullptr)
+    , sampler_(nullptr)
+{
+}
+
+ProbeVolume::~ProbeVolume() {
+    Shutdown();
+}
+
+bool ProbeVolume::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Settings& settings) {
+    Shutdown();
+    if (!device || !context) return false;
+    device_ = device;
+    context_ = context;
+    SetSettings(settings);
+    if (!texture_) {
+        Shutdown();
+        return false;
+    }
+    Logger::Info("Probe volume created: " + std::to_string(settings_.countX) + "x" + std::to_string(settings_.countY) +
+                 "x" + std::to_string(settings_.countZ) + (settings_.l2 ? " L2" : " L1") + " probes");
+    return true;
+}
+
+void ProbeVolume::Shutdown() {
+    ReleaseResources();
+    probes_.clear();
+    cursor_ = 0;
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+void ProbeVolume::ReleaseResources() {
+    SafeRelease(view_);
+    SafeRelease(texture_);
+    SafeRelease(constants_);
+    SafeRelease(sampler_);
+}
+
+void ProbeVolume::SetSettings(const Settings& settings) {
+    const bool resize = !texture_ || settings.countX != settings_.countX || settings.countY != settings_.countY ||
+                        settings.countZ != settings_.countZ || settings.l2 != settings_.l2;
+    settings_ = settings;
+    settings_.spacing.x = std::max(settings_.spacing.x, 0.01f);
+    settings_.spacing.y = std::max(settings_.spacing.y, 0.01f);
+    settings_.spacing.z = std::max(settings_.spacing.z, 0.01f);
+    settings_.countX = std::clamp(settings_.countX, 1u, 256u);
+    settings_.countY = std::clamp(settings_.countY, 1u, 256u);
+    settings_.countZ = std::clamp(settings_.countZ, 1u, 2048u / 7u);
+    settings_.probesPerFrame = std::max(settings_.probesPerFrame, 1u);
+    settings_.raysPerProbe = std::clamp(settings_.raysPerProbe, 8u, 1024u);
+    settings_.hysteresis = std::clamp(settings_.hysteresis, 0.0f, 0.99f);
+    settings_.bounceAlbedo = std::clamp(settings_.bounceAlbedo, 0.0f, 1.0f);
+    settings_.maxDistance = std::max(settings_.maxDistance, 0.1f);
+    settings_.intensity = std::max(settings_.intensity, 0.0f);
+
+    if (!device_) return;
+    if (resize) {
+        ReleaseResources();
+        probes_.assign(size_t(settings_.countX) * settings_.countY * settings_.countZ, Probe());
+        cursor_ = 0;
+        if (!CreateResources()) {
+            Logger::Error("Failed to create probe volume resources");
+            ReleaseResources();
+            return;
+        }
+    }
+    UpdateConstants();
+}
+
+bool ProbeVolume::CreateResources() {
+    D3D11_TEXTURE3D_DESC desc = {};
+    desc.Width = settings_.countX;
+    desc.Height = settings_.countY;
+    desc.Depth = settings_.countZ * GetPlaneCount();
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    // Half-float zero is all zero bits
+    std::vector<uint16_t> zeros(size_t(desc.Width) * desc.Height * desc.Depth * 4, 0);
+    D3D11_SUBRESOURCE_DATA data = { zeros.data(), desc.Width * 8, desc.Width * desc.Height * 8 };
+    HRESULT hr = device_->CreateTexture3D(&desc, &data, &texture_);
+    if (SUCCEEDED(hr)) hr = device_->CreateShaderResourceView(texture_, nullptr, &view_);
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = sizeof(GpuProbeConstants);
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (SUCCEEDED(hr)) hr = device_->CreateBuffer(&bufferDesc, nullptr, &constants_);
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (SUCCEEDED(hr)) hr = device_->CreateSamplerState(&samplerDesc, &sampler_);
+    return SUCCEEDED(hr);
+}
+
+void ProbeVolume::UpdateConstants() {
+    if (!constants_) return;
+    GpuProbeConstants constants = {};
+    constants.origin = settings_.origin;
+    constants.enabled = 1;
+    constants.inverseSpacing = XMFLOAT3(1.0f / settings_.spacing.x, 1.0f / settings_.spacing.y, 1.0f / settings_.spacing.z);
+    constants.l2 = settings_.l2 ? 1u : 0u;
+    constants.counts = XMFLOAT3(float(settings_.countX), float(settings_.countY), float(settings_.countZ));
+    constants.intensity = settings_.intensity;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+}
+
+XMFLOAT3 ProbeVolume::GetProbePosition(UINT index) const {
+    const UINT x = index % settings_.countX;
+    const UINT y = (index / settings_.countX) % settings_.countY;
+    const UINT z = index / (settings_.countX * settings_.countY);
+    return XMFLOAT3(settings_.origin.x + x * settings_.spacing.x,
+                    settings_.origin.y + y * settings_.spacing.y,
+                    settings_.origin.z + z * settings_.spacing.z);
+}
+
+void ProbeVolume::Update(const PhysicsEngine* physics, const std::vector<const Light*>& lights) {
+    if (!texture_ || probes_.empty()) return;
+    NEXUS_PROFILE_SCOPE("ProbeVolume::Update");
+
+    const UINT count = std::min(settings_.probesPerFrame, static_cast<UINT>(probes_.size()));
+    std::vector<UINT> batch(count);
+    for (UINT i = 0; i < count; ++i) {
+        batch[i] = cursor_;
+        cursor_ = (cursor_ + 1) % static_cast<UINT>(probes_.size());
+    }
+    Relight(batch, physics, lights, settings_.hysteresis);
+}
+
+void ProbeVolume::Bake(const PhysicsEngine* physics, const std::vector<const Light*>& lights, UINT bounces) {
+    if (!texture_ || probes_.empty()) return;
+    NEXUS_PROFILE_SCOPE("ProbeVolume::Bake");
+
+    // Batches of a few hundred probes keep the ray buffers small
+    const UINT batchSize = 256;
+    std::vector<UINT> batch;
+    for (UINT bounce = 0; bounce < std::max(bounces, 1u); ++bounce) {
+        for (UINT first = 0; first < probes_.size(); first += batchSize) {
+            batch.clear();
+            for (UINT i = first; i < std::min<UINT>(first + batchSize, static_cast<UINT>(probes_.size())); ++i) {
+                batch.push_back(i);
+            }
+            Relight(batch, physics, lights, 0.0f);
+        }
+    }
+    Logger::Info("Probe volume baked: " + std::to_string(probes_.size()) + " probes, " + std::to_string(bounces) + " bounces");
+}
+
+void ProbeVolume::Clear() {
+    if (!texture_) return;
+    probes_.assign(probes_.size(), Probe());
+    for (UINT i = 0; i < probes_.size(); ++i) UploadProbe(i);
+}
+
+void ProbeVolume::Relight(const std::vector<UINT>& batch, const PhysicsEngine* physics,
+                          const std::vector<const Light*>& lights, float hysteresis) {
+    const UINT rays = settings_.raysPerProbe;
+
+    // Spherical Fibonacci directions under a fresh random rotation, so successive updates of a
+    // probe sample different directions
+    std::normal_distribution<float> gaussian;
+    std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+    XMVECTOR axis = XMVector3Normalize(XMVectorSet(gaussian(random_), gaussian(random_), gaussian(random_) + 1e-4f, 0.0f));
+    XMVECTOR rotation = XMQuaternionRotationAxis(axis, angle(random_));
+    std::vector<XMFLOAT3> directions(rays);
+    for (UINT i = 0; i < rays; ++i) {
+        const float y = 1.0f - (2.0f * i + 1.0f) / rays;
+        const float r = std::sqrt(std::max(0.0f, 1.0f - y * y));
+        const float phi = i * 2.39996323f;
+        XMStoreFloat3(&directions[i], XMVector3Rotate(XMVectorSet(r * std::cos(phi), y, r * std::sin(phi), 0.0f), rotation));
+    }
+
+    std::vector<XMFLOAT3> samples(batch.size() * rays, settings_.skyColor);
+    if (radiance_) {
+        for (size_t p = 0; p < batch.size(); ++p) {
+            const XMFLOAT3 origin = GetProbePosition(batch[p]);
+            for (UINT r = 0; r < rays; ++r) samples[p * rays + r] = radiance_(origin, directions[r]);
+        }
+    } else if (physics) {
+        std::vector<PhysicsEngine::RayQuery> queries(samples.size());
+        for (size_t p = 0; p < batch.size(); ++p) {
+            const XMFLOAT3 origin = GetProbePosition(batch[p]);
+            for (UINT r = 0; r < rays; ++r) {
+                PhysicsEngine::RayQuery& query = queries[p * rays + r];
+                query.from = origin;
+                query.to = XMFLOAT3(origin.x + directions[r].x * settings_.maxDistance,
+                                    origin.y + directions[r].y * settings_.maxDistance,
+                                    origin.z + directions[r].z * settings_.maxDistance);
+            }
+        }
+        std::vector<PhysicsEngine::RaycastResult> hits(queries.size());
+        physics->CastBatch(queries.data(), queries.size(), hits.data());
+
+        // Every light that faces a hit point costs one shadow ray
+        struct ShadowRay {
+            size_t sample;
+            XMFLOAT3 irradiance;
+        };
+        std::vector<ShadowRay> shadowRays;
+        std::vector<PhysicsEngine::RayQuery> shadowQueries;
+        const float reflectance = settings_.bounceAlbedo;
+        for (size_t i = 0; i < hits.size(); ++i) {
+            if (!hits[i].hit) continue;
+            const XMFLOAT3& direction = directions[i % rays];
+            const XMFLOAT3& n = hits[i].hitNormal;
+            if (n.x * direction.x + n.y * direction.y + n.z * direction.z > 0.0f) {
+                samples[i] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+                continue;
+            }
+            const XMFLOAT3 point(hits[i].hitPoint.x + n.x * SURFACE_BIAS, hits[i].hitPoint.y + n.y * SURFACE_BIAS,
+                                 hits[i].hitPoint.z + n.z * SURFACE_BIAS);
+            samples[i] = Scale(SampleIrradiance(point, n), reflectance);
+
+            for (const Light* light : lights) {
+                if (!light) continue;
+                XMFLOAT3 L;
+                XMFLOAT3 target;
+                float attenuation = 1.0f;
+                if (light->GetType() == LightType::Directional) {
+                    XMStoreFloat3(&L, XMVector3Normalize(-XMLoadFloat3(&light->GetDirection())));
+                    target = XMFLOAT3(point.x + L.x * settings_.maxDistance, point.y + L.y * settings_.maxDistance,
+                                      point.z + L.z * settings_.maxDistance);
+                } else {
+                    const float range = light->GetRange();
+                    const XMFLOAT3& position = light->GetPosition();
+                    const XMFLOAT3 toLight(position.x - point.x, position.y - point.y, position.z - point.z);
+                    const float distanceSq = toLight.x * toLight.x + toLight.y * toLight.y + toLight.z * toLight.z;
+                    if (range <= 0.0f || distanceSq >= range * range) continue;
+                    L = Scale(toLight, 1.0f / std::sqrt(std::max(distanceSq, 1e-8f)));
+                    // Same falloff as the clustered lights; spot cones are taken as hard-edged
+                    const float ratio = distanceSq / (range * range);
+                    const float window = std::clamp(1.0f - ratio * ratio, 0.0f, 1.0f);
+                    attenuation = window * window / std::max(distanceSq, 0.01f);
+                    if (light->GetType() == LightType::Spot) {
+                        XMFLOAT3 spot;
+                        XMStoreFloat3(&spot, XMVector3Normalize(XMLoadFloat3(&light->GetDirection())));
+                        if (-(L.x * spot.x + L.y * spot.y + L.z * spot.z) < std::cos(std::min(light->GetConeAngle(), XM_PIDIV2))) continue;
+                    }
+                    target = position;
+                }
+                const float NdotL = n.x * L.x + n.y * L.y + n.z * L.z;
+                if (NdotL <= 0.0f) continue;
+
+                PhysicsEngine::RayQuery query;
+                query.from = point;
+                query.to = target;
+                shadowQueries.push_back(query);
+                shadowRays.push_back({ i, Scale(light->GetColor(), light->GetIntensity() * attenuation * NdotL) });
+            }
+        }
+
+        if (!shadowQueries.empty()) {
+            std::vector<PhysicsEngine::RaycastResult> blocked(shadowQueries.size());
+            physics->CastBatch(shadowQueries.data(), shadowQueries.size(), blocked.data());
+            // Lambertian: radiance is reflectance / pi times irradiance
+            for (size_t i = 0; i < shadowRays.size(); ++i) {
+                if (!blocked[i].hit) AddScaled(samples[shadowRays[i].sample], shadowRays[i].irradiance, reflectance / XM_PI);
+            }
+        }
+    }
+
+    // Monte Carlo projection: each ray covers 4 pi / rays of the sphere
+    const UINT coefficients = GetCoefficientCount();
+    const float weight = 4.0f * XM_PI / rays;
+    float basis[L2_COEFFICIENTS];
+    for (size_t p = 0; p < batch.size(); ++p) {
+        XMFLOAT3 projected[L2_COEFFICIENTS] = {};
+        for (UINT r = 0; r < rays; ++r) {
+            EvaluateBasis(directions[r], basis);
+            for (UINT k = 0; k < coefficients; ++k) AddScaled(projected[k], samples[p * rays + r], basis[k] * weight);
+        }
+
+        Probe& probe = probes_[batch[p]];
+        const float keep = probe.lit ? hysteresis : 0.0f;
+        for (UINT k = 0; k < coefficients; ++k) {
+            probe.radiance[k] = XMFLOAT3(projected[k].x + (probe.radiance[k].x - projected[k].x) * keep,
+                                         projected[k].y + (probe.radiance[k].y - projected[k].y) * keep,
+                                         projected[k].z + (probe.radiance[k].z - projected[k].z) * keep);
+        }
+        probe.lit = true;
+        UploadProbe(batch[p]);
+    }
+}
+
+void ProbeVolume::UploadProbe(UINT index) {
+    const Probe& probe = probes_[index];
+    const UINT coefficients = GetCoefficientCount();
+    float values[L2_COEFFICIENTS * 3 + 1] = {};
+    for (UINT k = 0; k < coefficients; ++k) {
+        values[k * 3 + 0] = probe.radiance[k].x * BAND_SCALE[k];
+        values[k * 3 + 1] = probe.radiance[k].y * BAND_SCALE[k];
+        values[k * 3 + 2] = probe.radiance[k].z * BAND_SCALE[k];
+    }
+
+    const UINT x = index % settings_.countX;
+    const UINT y = (index / settings_.countX) % settings_.countY;
+    const UINT z = index / (settings_.countX * settings_.countY);
+    for (UINT plane = 0; plane < GetPlaneCount(); ++plane) {
+        uint16_t texel[4];
+        for (UINT c = 0; c < 4; ++c) texel[c] = PackedVector::XMConvertFloatToHalf(values[plane * 4 + c]);
+        const UINT depth = plane * settings_.countZ + z;
+        D3D11_BOX box = { x, y, depth, x + 1, y + 1, depth + 1 };
+        context_->UpdateSubresource(texture_, 0, &box, texel, sizeof(texel), sizeof(texel));
+    }
+}
+
+XMFLOAT3 ProbeVolume::SampleIrradiance(const XMFLOAT3& position, const XMFLOAT3& normal) const {
+    XMFLOAT3 result(0.0f, 0.0f, 0.0f);
+    if (probes_.empty()) return result;
+
+    const UINT counts[3] = { settings_.countX, settings_.countY, settings_.countZ };
+    const float cell[3] = { (position.x - settings_.origin.x) / settings_.spacing.x,
+                            (position.y - settings_.origin.y) / settings_.spacing.y,
+                            (position.z - settings_.origin.z) / settings_.spacing.z };
+    UINT base[3];
+    float t[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        const float clamped = std::clamp(cell[axis], 0.0f, float(counts[axis] - 1));
+        base[axis] = std::min(static_cast<UINT>(clamped), counts[axis] > 1 ? counts[axis] - 2 : 0u);
+        t[axis] = counts[axis] > 1 ? clamped - base[axis] : 0.0f;
+    }
+
+    float basis[L2_COEFFICIENTS];
+    EvaluateBasis(normal, basis);
+    const UINT coefficients = GetCoefficientCount();
+    for (UINT corner = 0; corner < 8; ++corner) {
+        const UINT offset[3] = { corner & 1, (corner >> 1) & 1, (corner >> 2) & 1 };
+        float w = 1.0f;
+        UINT p[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            w *= offset[axis] ? t[axis] : 1.0f - t[axis];
+            p[axis] = std::min(base[axis] + offset[axis], counts[axis] - 1);
+        }
+        if (w <= 0.0f) continue;
+        const Probe& probe = probes_[p[0] + settings_.countX * (p[1] + settings_.countY * p[2])];
+        for (UINT k = 0; k < coefficients; ++k) AddScaled(result, probe.radiance[k], basis[k] * BAND_SCALE[k] * w);
+    }
+    return XMFLOAT3(std::max(result.x, 0.0f), std::max(result.y, 0.0f), std::max(result.z, 0.0f));
+}
+
+bool ProbeVolume::Save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        Logger::Error("Cannot write probe volume: " + filename);
+        return false;
+    }
+    ProbeFileHeader header = { ProbeFileHeader::MAGIC, ProbeFileHeader::VERSION, settings_.countX, settings_.countY,
+                               settings_.countZ, GetCoefficientCount() };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const Probe& probe : probes_) {
+        const uint32_t lit = probe.lit ? 1u : 0u;
+        file.write(reinterpret_cast<const char*>(&lit), sizeof(lit));
+        file.write(reinterpret_cast<const char*>(probe.radiance), sizeof(XMFLOAT3) * header.coefficientCount);
+    }
+    return file.good();
+}
+
+bool ProbeVolume::Load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    ProbeFileHeader header = {};
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != ProbeFileHeader::MAGIC || header.version != ProbeFileHeader::VERSION) {
+        Logger::Error("Not a probe volume: " + filename);
+        return false;
+    }
+    if (probes_.empty() || header.countX != settings_.countX || header.countY != settings_.countY || header.countZ != settings_.countZ ||
+        header.coefficientCount != GetCoefficientCount()) {
+        Logger::Warning("Probe volume does not match the current grid: " + filename);
+        return false;
+    }
+
+    std::vector<Probe> probes(probes_.size());
+    for (Probe& probe : probes) {
+        uint32_t lit = 0;
+        file.read(reinterpret_cast<char*>(&lit), sizeof(lit));
+        file.read(reinterpret_cast<char*>(probe.radiance), sizeof(XMFLOAT3) * header.coefficientCount);
+        probe.lit = lit != 0;
+    }
+    if (!file) {
+        Logger::Error("Truncated probe volume: " + filename);
+        return false;
+    }
+    probes_.swap(probes);
+    if (texture_) {
+        for (UINT i = 0; i < probes_.size(); ++i) UploadProbe(i);
+    }
+    return true;
+}
+
+void ProbeVolume::Bind(StateCache& stateCache) const {
+    if (!view_) return;
+    stateCache.PSSetShaderResources(TEXTURE_SLOT, 1, &view_);
+    stateCache.PSSetConstantBuffers(CONSTANT_SLOT, 1, &constants_);
+    stateCache.PSSetSamplers(SAMPLER_SLOT, 1, &sampler_);
+}
+
+void ProbeVolume::BindCompute() const {
+    if (!view_) return;
+    context_->CSSetShaderResources(TEXTURE_SLOT, 1, &view_);
+    context_->CSSetConstantBuffers(CONSTANT_SLOT, 1, &constants_);
+    context_->CSSetSamplers(SAMPLER_SLOT, 1, &sampler_);
+}
+
+const char* ProbeVolume::GetShaderSource() {
+    return PROBE_SHADER;
+}
+
+} // namespace Nexus
@@ -0,0 +1,1465 @@
+#include "RayTracingEngine.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+
+// Compacted sizes one frame can request; further static builds that frame stay uncompacted
+constexpr UINT COMPACTION_SLOTS = 256;
+constexpr UINT64 COMPACTION_SLICE_BYTES = COMPACTION_SLOTS * sizeof(UINT64);
+constexpr UINT64 MIN_INSTANCE_CAPACITY = 64;
+
+UINT64 AlignScratch(UINT64 size) {
+    const UINT64 alignment = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT;
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+ID3D12Resource* CreateBuffer(ID3D12Device5* device, UINT64 size, D3D12_HEAP_TYPE heap, D3D12_RESOURCE_FLAGS flags,
+                             D3D12_RESOURCE_STATES state) {
+    D3D12_HEAP_PROPERTIES heapProperties = {};
+    heapProperties.Type = heap;
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Width = std::max<UINT64>(size, 1);
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags = flags;
+
+    ID3D12Resource* resource = nullptr;
+    if (FAILED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, state, nullptr,
+                                               IID_PPV_ARGS(&resource)))) {
+        return nullptr;
+    }
+    return resource;
+}
+
+void UavBarrier(ID3D12GraphicsCommandList4* commandList, ID3D12Resource* resource) {
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+    barrier.UAV.pResource = resource;
+    commandList->ResourceBarrier(1, &barrier);
+}
+
+void TransitionBarrier(ID3D12GraphicsCommandList4* commandList, ID3D12Resource* resource,
+                       D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) {
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource = resource;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore = before;
+    barrier.Transition.StateAfter = after;
+    commandList->ResourceBarrier(1, &barrier);
+}
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+} // namespace
+
+RayTracingEngine::RTScene::RTScene()
+    : topLevelAS_(nullptr)
+    , topLevelCapacity_(0)
+    , topLevelInstances_(0)
+    , topLevelUpdates_(0)
+    , instancesDirty_(false)
+    , needsRebuild_(true)
+    , scratch_(nullptr)
+    , scratchCapacity_(0)
+    , topLevelScratch_(nullptr)
+    , topLevelScratchCapacity_(0)
+    , instanceBuffer_(nullptr)
+    , instanceCapacity_(0)
+    , instanceData_(nullptr)
+    , compactionInfo_(nullptr)
+    , compactionReadback_(nullptr)
+    , frame_(0)
+{
+}
+
+RayTracingEngine::RTScene::~RTScene() {
+    for (BottomLevel& blas : bottomLevels_) {
+        SafeRelease(blas.structure);
+    }
+    if (instanceBuffer_ && instanceData_) {
+        instanceBuffer_->Unmap(0, nullptr);
+    }
+    SafeRelease(instanceBuffer_);
+    SafeRelease(topLevelAS_);
+    SafeRelease(scratch_);
+    SafeRelease(topLevelScratch_);
+    SafeRelease(compactionInfo_);
+    SafeRelease(compactionReadback_);
+    ReleaseRetired(true);
+}
+
+int RayTracingEngine::RTScene::AddGeometry(const RTGeometry& geometry) {
+    geometries_.push_back(geometry);
+    geometryAlive_.push_back(true);
+    bottomLevels_.emplace_back();
+    return static_cast<int>(geometries_.size()) - 1;
+}
+
+void RayTracingEngine::RTScene::RemoveGeometry(int geometryId) {
+    if (geometryId < 0 || geometryId >= static_cast<int>(geometries_.size()) || !geometryAlive_[geometryId]) return;
+    geometryAlive_[geometryId] = false;
+    Retire(bottomLevels_[geometryId].structure);
+    bottomLevels_[geometryId] = BottomLevel();
+    // Instances of the geometry drop out of the TLAS
+    needsRebuild_ = true;
+}
+
+void RayTracingEngine::RTScene::MarkGeometryDeformed(int geometryId) {
+    if (geometryId < 0 || geometryId >= static_cast<int>(geometries_.size()) || !geometryAlive_[geometryId]) return;
+    if (geometries_[geometryId].deformable) {
+        bottomLevels_[geometryId].deformed = true;
+    }
+}
+
+int RayTracingEngine::RTScene::AddInstance(const RTInstance& instance) {
+    int instanceId;
+    if (!freeInstances_.empty()) {
+        instanceId = freeInstances_.back();
+        freeInstances_.pop_back();
+        instances_[instanceId] = instance;
+        instanceAlive_[instanceId] = true;
+    } else {
+        instanceId = static_cast<int>(instances_.size());
+        instances_.push_back(instance);
+        instanceAlive_.push_back(true);
+    }
+    needsRebuild_ = true;
+    return instanceId;
+}
+
+void RayTracingEngine::RTScene::RemoveInstance(int instanceId) {
+    if (instanceId < 0 || instanceId >= static_cast<int>(instances_.size()) || !instanceAlive_[instanceId]) return;
+    instanceAlive_[instanceId] = false;
+    freeInstances_.push_back(instanceId);
+    instanceToMaterial_.erase(instanceId);
+    needsRebuild_ = true;
+}
+
+void RayTracingEngine::RTScene::UpdateInstance(int instanceId, const XMMATRIX& transform) {
+    if (instanceId < 0 || instanceId >= static_cast<int>(instances_.size()) || !instanceAlive_[instanceId]) return;
+    // Uploaded with every other instance in the next build
+    instances_[instanceId].transform = transform;
+    instancesDirty_ = true;
+}
+
+void RayTracingEngine::RTScene::SetMaterial(int instanceId, const RTMaterial& material) {
+    auto it = instanceToMaterial_.find(instanceId);
+    if (it != instanceToMaterial_.end()) {
+        materials_[it->second] = material;
+        return;
+    }
+    instanceToMaterial_[instanceId] = static_cast<int>(materials_.size());
+    materials_.push_back(material);
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS RayTracingEngine::RTScene::GetTopLevelAS() const {
+    return topLevelAS_ ? topLevelAS_->GetGPUVirtualAddress() : 0;
+}
+
+D3D12_RAYTRACING_GEOMETRY_DESC RayTracingEngine::RTScene::GetGeometryDesc(const RTGeometry& geometry) const {
+    D3D12_RAYTRACING_GEOMETRY_DESC desc = {};
+    desc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+    desc.Flags = geometry.flags;
+    desc.Triangles.VertexBuffer.StartAddress = geometry.vertexBuffer->GetGPUVirtualAddress();
+    desc.Triangles.VertexBuffer.StrideInBytes = geometry.vertexStride;
+    desc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+    desc.Triangles.VertexCount = geometry.vertexCount;
+    if (geometry.indexBuffer) {
+        desc.Triangles.IndexBuffer = geometry.indexBuffer->GetGPUVirtualAddress();
+        desc.Triangles.IndexCount = geometry.indexCount;
+        desc.Triangles.IndexFormat = geometry.indexFormat;
+    }
+    return desc;
+}
+
+void RayTracingEngine::RTScene::Retire(ID3D12Resource*& resource) {
+    if (!resource) return;
+    retired_.emplace_back(frame_, resource);
+    resource = nullptr;
+}
+
+void RayTracingEngine::RTScene::ReleaseRetired(bool all) {
+    auto expired = std::remove_if(retired_.begin(), retired_.end(), [&](const std::pair<UINT64, ID3D12Resource*>& entry) {
+        if (!all && frame_ < entry.first + FRAMES_IN_FLIGHT) return false;
+        entry.second->Release();
+        return true;
+    });
+    retired_.erase(expired, retired_.end());
+}
+
+bool RayTracingEngine::RTScene::EnsureBuffer(ID3D12Device5* device, ID3D12Resource*& buffer, UINT64& capacity, UINT64 size,
+                                             D3D12_HEAP_TYPE heap, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state) {
+    if (buffer && capacity >= size) return true;
+    Retire(buffer);
+    buffer = CreateBuffer(device, size, heap, flags, state);
+    capacity = buffer ? size : 0;
+    return buffer != nullptr;
+}
+
+bool RayTracingEngine::RTScene::BuildAccelerationStructures(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList) {
+    if (!device || !commandList) return false;
+    NEXUS_PROFILE_SCOPE("RTScene::BuildAccelerationStructures");
+
+    const UINT64 savedBytes = stats_.compactionSavedBytes;
+    stats_ = Stats();
+    stats_.compactionSavedBytes = savedBytes;
+    ReleaseRetired(false);
+
+    if (!compactionInfo_) {
+        compactionInfo_ = CreateBuffer(device, COMPACTION_SLICE_BYTES, D3D12_HEAP_TYPE_DEFAULT,
+                                       D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        compactionReadback_ = CreateBuffer(device, COMPACTION_SLICE_BYTES * FRAMES_IN_FLIGHT, D3D12_HEAP_TYPE_READBACK,
+                                           D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COPY_DEST);
+        if (!compactionInfo_ || !compactionReadback_) {
+            Logger::Error("Failed to create acceleration structure compaction buffers");
+            SafeRelease(compactionInfo_);
+            SafeRelease(compactionReadback_);
+            return false;
+        }
+    }
+
+    CompactFinishedBuilds(device, commandList);
+    bool bottomLevelsChanged = false;
+    bool built = BuildBottomLevels(device, commandList, bottomLevelsChanged) &&
+                 BuildTopLevel(device, commandList, bottomLevelsChanged);
+    ++frame_;
+    return built;
+}
+
+void RayTracingEngine::RTScene::CompactFinishedBuilds(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList) {
+    // This frame reuses the readback slice of the frame FRAMES_IN_FLIGHT ago, which the GPU has finished
+    const UINT64 slice = frame_ % FRAMES_IN_FLIGHT;
+    const UINT64* sizes = nullptr;
+    bool compacted = false;
+    for (size_t i = 0; i < bottomLevels_.size(); ++i) {
+        BottomLevel& blas = bottomLevels_[i];
+        if (blas.compactionIndex == UINT_MAX || frame_ < blas.compactionFrame + FRAMES_IN_FLIGHT) continue;
+
+        if (!sizes) {
+            D3D12_RANGE readRange = { slice * COMPACTION_SLICE_BYTES, (slice + 1) * COMPACTION_SLICE_BYTES };
+            void* data = nullptr;
+            if (FAILED(compactionReadback_->Map(0, &readRange, &data))) return;
+            sizes = reinterpret_cast<const UINT64*>(static_cast<const uint8_t*>(data) + readRange.Begin);
+        }
+        const UINT64 size = sizes[blas.compactionIndex];
+        blas.compactionIndex = UINT_MAX;
+        if (size == 0 || size >= blas.capacity) continue;
+
+        ID3D12Resource* compactedStructure = CreateBuffer(device, size, D3D12_HEAP_TYPE_DEFAULT,
+                                                          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+                                                          D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE);
+        if (!compactedStructure) continue;
+        commandList->CopyRaytracingAccelerationStructure(compactedStructure->GetGPUVirtualAddress(),
+                                                         blas.structure->GetGPUVirtualAddress(),
+                                                         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+        stats_.compactionSavedBytes += blas.capacity - size;
+        Retire(blas.structure);
+        blas.structure = compactedStructure;
+        blas.capacity = size;
+        blas.compacted = true;
+        ++stats_.blasCompactions;
+        compacted = true;
+    }
+    if (sizes) {
+        D3D12_RANGE writeRange = { 0, 0 };
+        compactionReadback_->Unmap(0, &writeRange);
+    }
+    if (compacted) {
+        // The TLAS points at the old copies
+        UavBarrier(commandList, nullptr);
+        needsRebuild_ = true;
+    }
+}
+
+bool RayTracingEngine::RTScene::BuildBottomLevels(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList, bool& changed) {
+    struct Build {
+        size_t geometry;
+        bool refit;
+        bool compact;
+        UINT64 scratchOffset;
+        D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc;
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs;
+    };
+    std::vector<Build> builds;
+    UINT64 scratchSize = 0;
+    UINT compactions = 0;
+
+    for (size_t i = 0; i < geometries_.size(); ++i) {
+        if (!geometryAlive_[i] || !geometries_[i].vertexBuffer) continue;
+        BottomLevel& blas = bottomLevels_[i];
+        const bool deformable = geometries_[i].deformable;
+        // Refits keep the original topology's tree, which loosens as the mesh deforms
+        const bool rebuild = !blas.structure || (deformable && blas.deformed && blas.refits >= settings_.refitsBeforeRebuild);
+        const bool refit = !rebuild && deformable && blas.deformed;
+        if (!rebuild && !refit) continue;
+
+        Build build = {};
+        build.geometry = i;
+        build.refit = refit;
+        build.compact = rebuild && !deformable && settings_.compactStatic && compactions < COMPACTION_SLOTS;
+        build.geometryDesc = GetGeometryDesc(geometries_[i]);
+        build.inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+        build.inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+        build.inputs.NumDescs = 1;
+        build.inputs.Flags = deformable
+            ? D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE | D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD
+            : D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        if (build.compact) {
+            build.inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION;
+        }
+
+        build.inputs.pGeometryDescs = &build.geometryDesc;
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO info = {};
+        device->GetRaytracingAccelerationStructurePrebuildInfo(&build.inputs, &info);
+        if (info.ResultDataMaxSizeInBytes == 0) continue;
+
+        if (rebuild && (blas.compacted || blas.capacity < info.ResultDataMaxSizeInBytes)) {
+            Retire(blas.structure);
+            blas.structure = CreateBuffer(device, info.ResultDataMaxSizeInBytes, D3D12_HEAP_TYPE_DEFAULT,
+                                          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+                                          D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE);
+            blas.capacity = blas.structure ? info.ResultDataMaxSizeInBytes : 0;
+            if (!blas.structure) {
+                Logger::Error("Failed to allocate a bottom-level acceleration structure");
+                continue;
+            }
+            needsRebuild_ = true;
+        }
+
+        build.scratchOffset = scratchSize;
+        scratchSize += AlignScratch(refit ? info.UpdateScratchDataSizeInBytes : info.ScratchDataSizeInBytes);
+        if (build.compact) {
+            blas.compactionIndex = compactions++;
+            blas.compactionFrame = frame_;
+        } else {
+            blas.compactionIndex = UINT_MAX;
+        }
+        if (refit) {
+            ++blas.refits;
+        } else {
+            blas.refits = 0;
+            blas.compacted = false;
+        }
+        blas.deformed = false;
+        builds.push_back(build);
+    }
+    if (builds.empty()) return true;
+
+    if (!EnsureBuffer(device, scratch_, scratchCapacity_, scratchSize, D3D12_HEAP_TYPE_DEFAULT,
+                      D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)) {
+        Logger::Error("Failed to allocate acceleration structure scratch memory");
+        return false;
+    }
+    // Last frame's builds may still be using the scratch memory
+    UavBarrier(commandList, scratch_);
+
+    const D3D12_GPU_VIRTUAL_ADDRESS scratchAddress = scratch_->GetGPUVirtualAddress();
+    const D3D12_GPU_VIRTUAL_ADDRESS compactionAddress = compactionInfo_->GetGPUVirtualAddress();
+    for (Build& build : builds) {
+        BottomLevel& blas = bottomLevels_[build.geometry];
+        build.inputs.pGeometryDescs = &build.geometryDesc;
+
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+        desc.Inputs = build.inputs;
+        desc.DestAccelerationStructureData = blas.structure->GetGPUVirtualAddress();
+        desc.ScratchAccelerationStructureData = scratchAddress + build.scratchOffset;
+        if (build.refit) {
+            desc.Inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+            desc.SourceAccelerationStructureData = desc.DestAccelerationStructureData;
+            ++stats_.blasRefits;
+        } else {
+            ++stats_.blasBuilds;
+        }
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuild = {};
+        postbuild.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+        postbuild.DestBuffer = compactionAddress + blas.compactionIndex * sizeof(UINT64);
+        commandList->BuildRaytracingAccelerationStructure(&desc, build.compact ? 1 : 0, build.compact ? &postbuild : nullptr);
+    }
+    UavBarrier(commandList, nullptr);
+
+    if (compactions > 0) {
+        const UINT64 slice = frame_ % FRAMES_IN_FLIGHT;
+        TransitionBarrier(commandList, compactionInfo_, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        commandList->CopyBufferRegion(compactionReadback_, slice * COMPACTION_SLICE_BYTES, compactionInfo_, 0,
+                                      compactions * sizeof(UINT64));
+        TransitionBarrier(commandList, compactionInfo_, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    }
+    changed = true;
+    return true;
+}
+
+bool RayTracingEngine::RTScene::BuildTopLevel(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList, bool bottomLevelsChanged) {
+    UINT count = 0;
+    for (size_t i = 0; i < instances_.size(); ++i) {
+        if (!instanceAlive_[i]) continue;
+        const int geometry = instances_[i].geometryId;
+        if (geometry >= 0 && geometry < static_cast<int>(bottomLevels_.size()) && bottomLevels_[geometry].structure) {
+            ++count;
+        }
+    }
+
+    const bool rebuild = needsRebuild_ || !topLevelAS_ || count != topLevelInstances_ ||
+                         topLevelUpdates_ >= settings_.updatesBeforeRebuild;
+    if (!rebuild && !instancesDirty_ && !bottomLevelsChanged) return true;
+    instancesDirty_ = false;
+    needsRebuild_ = false;
+    if (count == 0) {
+        Retire(topLevelAS_);
+        topLevelCapacity_ = 0;
+        topLevelInstances_ = 0;
+        return true;
+    }
+
+    if (count > instanceCapacity_) {
+        if (instanceBuffer_ && instanceData_) {
+            instanceBuffer_->Unmap(0, nullptr);
+        }
+        instanceData_ = nullptr;
+        Retire(instanceBuffer_);
+        instanceCapacity_ = std::max<UINT64>({ count, instanceCapacity_ * 2, MIN_INSTANCE_CAPACITY });
+        instanceBuffer_ = CreateBuffer(device, instanceCapacity_ * FRAMES_IN_FLIGHT * sizeof(D3D12_RAYTRACING_INSTANCE_DESC),
+                                       D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ);
+        D3D12_RANGE readRange = { 0, 0 };
+        if (!instanceBuffer_ || FAILED(instanceBuffer_->Map(0, &readRange, reinterpret_cast<void**>(&instanceData_)))) {
+            Logger::Error("Failed to allocate the ray tracing instance buffer");
+            SafeRelease(instanceBuffer_);
+            instanceCapacity_ = 0;
+            return false;
+        }
+    }
+
+    // Every instance is written in one pass into this frame's slice of the upload buffer
+    const UINT64 sliceOffset = (frame_ % FRAMES_IN_FLIGHT) * instanceCapacity_;
+    D3D12_RAYTRACING_INSTANCE_DESC* descs = instanceData_ + sliceOffset;
+    UINT written = 0;
+    for (size_t i = 0; i < instances_.size(); ++i) {
+        if (!instanceAlive_[i]) continue;
+        const RTInstance& instance = instances_[i];
+        if (instance.geometryId < 0 || instance.geometryId >= static_cast<int>(bottomLevels_.size())) continue;
+        const BottomLevel& blas = bottomLevels_[instance.geometryId];
+        if (!blas.structure) continue;
+
+        D3D12_RAYTRACING_INSTANCE_DESC& desc = descs[written++];
+        XMStoreFloat3x4(reinterpret_cast<XMFLOAT3X4*>(desc.Transform), instance.transform);
+        desc.InstanceID = instance.instanceId & 0xFFFFFF;
+        desc.InstanceMask = instance.instanceMask & 0xFF;
+        desc.InstanceContributionToHitGroupIndex = instance.instanceContributionToHitGroupIndex & 0xFFFFFF;
+        desc.Flags = instance.flags & 0xFF;
+        desc.AccelerationStructure = blas.structure->GetGPUVirtualAddress();
+    }
+    stats_.instancesUploaded = written;
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
+    inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+    inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+    inputs.NumDescs = written;
+    inputs.InstanceDescs = instanceBuffer_->GetGPUVirtualAddress() + sliceOffset * sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+    inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE |
+                   D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+
+    if (rebuild) {
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO info = {};
+        device->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &info);
+        const UINT64 scratchSize = std::max(info.ScratchDataSizeInBytes, info.UpdateScratchDataSizeInBytes);
+        if (!EnsureBuffer(device, topLevelAS_, topLevelCapacity_, info.ResultDataMaxSizeInBytes, D3D12_HEAP_TYPE_DEFAULT,
+                          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE) ||
+            !EnsureBuffer(device, topLevelScratch_, topLevelScratchCapacity_, scratchSize, D3D12_HEAP_TYPE_DEFAULT,
+                          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)) {
+            Logger::Error("Failed to allocate the top-level acceleration structure");
+            needsRebuild_ = true;
+            return false;
+        }
+    }
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+    desc.Inputs = inputs;
+    desc.DestAccelerationStructureData = topLevelAS_->GetGPUVirtualAddress();
+    desc.ScratchAccelerationStructureData = topLevelScratch_->GetGPUVirtualAddress();
+    if (!rebuild) {
+        desc.Inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+        desc.SourceAccelerationStructureData = desc.DestAccelerationStructureData;
+    }
+    UavBarrier(commandList, topLevelScratch_);
+    commandList->BuildRaytracingAccelerationStructure(&desc, 0, nullptr);
+    UavBarrier(commandList, topLevelAS_);
+
+    topLevelInstances_ = written;
+    topLevelUpdates_ = rebuild ? 0 : topLevelUpdates_ + 1;
+    stats_.tlasRebuilt = rebuild;
+    stats_.tlasUpdated = !rebuild;
+    return true;
+}
+
+namespace {
+
+// Per Denoise(): the input table and one target table per pass
+constexpr UINT DENOISER_INPUTS = 6;
+constexpr UINT DENOISER_TARGETS = 4;
+constexpr UINT DESCRIPTOR_RING = 1024;
+constexpr DXGI_FORMAT DENOISER_FORMAT = DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+const char* DENOISE_COMMON_SOURCE = R"(
+cbuffer DenoiseConstants : register(b0) {
+    uint2 Size;
+    uint Frame;
+    uint TraceStride;
+    float TemporalAlpha;
+    float MomentsAlpha;
+    float MaxHistoryLength;
+    uint HistoryValid;
+    float PhiColor;
+    float PhiNormal;
+    float PhiDepth;
+    uint StepSize;
+    uint WriteFeedback;
+    uint2 NoisySize;
+    float Padding;
+};
+
+Texture2D<float4> Noisy : register(t0);
+Texture2D<float> Depth : register(t1);
+Texture2D<float4> Normals : register(t2);
+Texture2D<float2> Motion : register(t3);
+Texture2D<float> PreviousDepth : register(t4);
+Texture2D<float4> PreviousNormals : register(t5);
+
+float Luminance(float3 color) {
+    return dot(color, float3(0.2126, 0.7152, 0.0722));
+}
+
+// Matches Denoiser::GetTracedPixel()
+uint2 TracedPixel(uint2 texel) {
+    if (TraceStride == 2) return uint2(texel.x * 2 + ((texel.y + Frame) & 1), texel.y);
+    if (TraceStride == 4) return texel * 2 + uint2(Frame & 1, (Frame >> 1) & 1);
+    return texel;
+}
+
+uint2 NoisyTexel(uint2 pixel) {
+    if (TraceStride == 2) return uint2(pixel.x / 2, pixel.y);
+    if (TraceStride == 4) return pixel / 2;
+    return pixel;
+}
+
+float DepthWeight(float centerDepth, float depth, float distance) {
+    return exp(-abs(centerDepth - depth) / (PhiDepth * centerDepth * distance + 1e-4));
+}
+
+float NormalWeight(float3 centerNormal, float3 normal) {
+    return pow(saturate(dot(centerNormal, normal)), PhiNormal);
+}
+)";
+
+const char* DENOISE_TEMPORAL_SOURCE = R"(
+RWTexture2D<float4> ColorHistory : register(u0);
+RWTexture2D<float4> MomentsHistory : register(u1);
+RWTexture2D<float4> Integrated : register(u2);
+RWTexture2D<float4> Moments : register(u3);
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID) {
+    uint2 pixel = id.xy;
+    if (any(pixel >= Size)) return;
+
+    uint2 texel = min(NoisyTexel(pixel), NoisySize - 1);
+    float3 current = Noisy[texel].rgb;
+    bool traced = all(TracedPixel(texel) == pixel);
+    float depth = Depth[pixel];
+    float3 normal = Normals[pixel].xyz;
+
+    // Bilinear reprojection, every tap tested against the current surface on its own
+    float3 history = 0;
+    float2 historyMoments = 0;
+    float historyFrames = 0;
+    float weightSum = 0;
+    if (HistoryValid != 0) {
+        float2 position = float2(pixel) - Motion[pixel] * float2(Size);
+        int2 base = int2(floor(position));
+        float2 f = position - float2(base);
+        float weights[4] = { (1 - f.x) * (1 - f.y), f.x * (1 - f.y), (1 - f.x) * f.y, f.x * f.y };
+        int2 offsets[4] = { int2(0, 0), int2(1, 0), int2(0, 1), int2(1, 1) };
+        [unroll]
+        for (int i = 0; i < 4; ++i) {
+            int2 tap = base + offsets[i];
+            if (any(tap < 0) || any(tap >= int2(Size))) continue;
+            if (abs(PreviousDepth[tap] - depth) > 0.1 * depth || dot(PreviousNormals[tap].xyz, normal) < 0.9) continue;
+            float4 moments = MomentsHistory[tap];
+            history += ColorHistory[tap].rgb * weights[i];
+            historyMoments += moments.xy * weights[i];
+            historyFrames += moments.z * weights[i];
+            weightSum += weights[i];
+        }
+    }
+
+    float luminance = Luminance(current);
+    float2 moments = float2(luminance, luminance * luminance);
+    float3 color = current;
+    if (weightSum > 0.01) {
+        history /= weightSum;
+        historyMoments /= weightSum;
+        historyFrames /= weightSum;
+        if (traced) {
+            historyFrames = min(historyFrames + 1, MaxHistoryLength);
+            color = lerp(history, current, max(TemporalAlpha, 1.0 / historyFrames));
+            moments = lerp(historyMoments, moments, max(MomentsAlpha, 1.0 / historyFrames));
+        } else {
+            // Nothing new here this frame
+            color = history;
+            moments = historyMoments;
+        }
+    } else {
+        // Disoccluded: restart from the block's sample
+        historyFrames = traced ? 1 : 0;
+    }
+
+    Integrated[pixel] = float4(color, max(moments.y - moments.x * moments.x, 0));
+    Moments[pixel] = float4(moments, historyFrames, 0);
+}
+)";
+
+const char* DENOISE_VARIANCE_SOURCE = R"(
+RWTexture2D<float4> Integrated : register(u0);
+RWTexture2D<float4> Moments : register(u1);
+RWTexture2D<float4> Output : register(u2);
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID) {
+    uint2 pixel = id.xy;
+    if (any(pixel >= Size)) return;
+
+    float4 center = Integrated[pixel];
+    float historyFrames = Moments[pixel].z;
+    if (historyFrames >= 4) {
+        Output[pixel] = center;
+        return;
+    }
+
+    // Too few frames for the temporal moments: take them from the surface around the pixel
+    float depth = Depth[pixel];
+    float3 normal = Normals[pixel].xyz;
+    float2 moments = 0;
+    float weightSum = 0;
+    for (int y = -3; y <= 3; ++y) {
+        for (int x = -3; x <= 3; ++x) {
+            int2 tap = int2(pixel) + int2(x, y);
+            if (any(tap < 0) || any(tap >= int2(Size))) continue;
+            float weight = DepthWeight(depth, Depth[tap], length(float2(x, y))) * NormalWeight(normal, Normals[tap].xyz);
+            moments += Moments[tap].xy * weight;
+            weightSum += weight;
+        }
+    }
+    moments /= max(weightSum, 1e-4);
+
+    // Overestimate while the history is short, so the wavelet passes filter harder
+    float variance = max(moments.y - moments.x * moments.x, 0) * 4.0 / max(historyFrames, 1.0);
+    Output[pixel] = float4(center.rgb, variance);
+}
+)";
+
+const char* DENOISE_ATROUS_SOURCE = R"(
+RWTexture2D<float4> Input : register(u0);
+RWTexture2D<float4> Output : register(u1);
+RWTexture2D<float4> Feedback : register(u2);
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID) {
+    uint2 pixel = id.xy;
+    if (any(pixel >= Size)) return;
+
+    float4 center = Input[pixel];
+    float depth = Depth[pixel];
+    float3 normal = Normals[pixel].xyz;
+
+    // 3x3 Gaussian over the variance before it scales the luminance edge stop
+    float variance = 0;
+    for (int vy = -1; vy <= 1; ++vy) {
+        for (int vx = -1; vx <= 1; ++vx) {
+            int2 tap = clamp(int2(pixel) + int2(vx, vy), 0, int2(Size) - 1);
+            variance += Input[tap].a * (vx == 0 ? 2 : 1) * (vy == 0 ? 2 : 1) / 16.0;
+        }
+    }
+    float phiLuminance = PhiColor * sqrt(max(variance, 1e-10));
+    float centerLuminance = Luminance(center.rgb);
+
+    // B3 spline, normalized to 1 in the middle
+    const float kernel[3] = { 1.0, 2.0 / 3.0, 1.0 / 6.0 };
+    float3 color = center.rgb;
+    float filteredVariance = center.a;
+    float weightSum = 1.0;
+    for (int y = -2; y <= 2; ++y) {
+        for (int x = -2; x <= 2; ++x) {
+            if (x == 0 && y == 0) continue;
+            int2 tap = int2(pixel) + int2(x, y) * int(StepSize);
+            if (any(tap < 0) || any(tap >= int2(Size))) continue;
+            float4 value = Input[tap];
+            float weight = kernel[abs(x)] * kernel[abs(y)] *
+                           DepthWeight(depth, Depth[tap], length(float2(x, y)) * StepSize) *
+                           NormalWeight(normal, Normals[tap].xyz) *
+                           exp(-abs(Luminance(value.rgb) - centerLuminance) / phiLuminance);
+            color += value.rgb * weight;
+            filteredVariance += value.a * weight * weight;
+            weightSum += weight;
+        }
+    }
+
+    float4 result = float4(color / weightSum, filteredVariance / (weightSum * weightSum));
+    Output[pixel] = result;
+    if (WriteFeedback != 0) {
+        Feedback[pixel] = result;
+    }
+}
+)";
+
+ID3D12Resource* CreateTexture(ID3D12Device5* device, UINT width, UINT height) {
+    D3D12_HEAP_PROPERTIES heapProperties = {};
+    heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width = width;
+    desc.Height = height;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DENOISER_FORMAT;
+    desc.SampleDesc.Count = 1;
+    desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    ID3D12Resource* resource = nullptr;
+    if (FAILED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+                                               D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr,
+                                               IID_PPV_ARGS(&resource)))) {
+        return nullptr;
+    }
+    return resource;
+}
+
+ID3D12PipelineState* CreateComputePipeline(ID3D12Device5* device, ID3D12RootSignature* rootSignature,
+                                           const char* common, const char* body, const char* name) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    if (FAILED(ShaderCache::Compile(std::string(common) + body, name, "main", "cs_5_0", 0, &blob, &errors))) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+    desc.pRootSignature = rootSignature;
+    desc.CS.pShaderBytecode = blob->GetBufferPointer();
+    desc.CS.BytecodeLength = blob->GetBufferSize();
+    ID3D12PipelineState* pipeline = nullptr;
+    HRESULT hr = device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipeline));
+    blob->Release();
+    return SUCCEEDED(hr) ? pipeline : nullptr;
+}
+
+} // namespace
+
+RayTracingEngine::Denoiser::Denoiser()
+    : device_(nullptr)
+    , rootSignature_(nullptr)
+    , temporalPipeline_(nullptr)
+    , variancePipeline_(nullptr)
+    , atrousPipeline_(nullptr)
+    , descriptorHeap_(nullptr)
+    , descriptorSize_(0)
+    , nextDescriptor_(0)
+    , targets_{}
+    , width_(0)
+    , height_(0)
+    , frame_(0)
+{
+}
+
+RayTracingEngine::Denoiser::~Denoiser() {
+    Shutdown();
+}
+
+bool RayTracingEngine::Denoiser::Initialize(ID3D12Device5* device) {
+    if (!device) return false;
+    Shutdown();
+    device_ = device;
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.NumDescriptors = DESCRIPTOR_RING;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    if (FAILED(device_->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&descriptorHeap_)))) {
+        Logger::Error("Failed to create the denoiser descriptor heap");
+        Shutdown();
+        return false;
+    }
+    descriptorSize_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    if (!CreatePipelines()) {
+        Shutdown();
+        return false;
+    }
+    return true;
+}
+
+void RayTracingEngine::Denoiser::Shutdown() {
+    // Callers wait for the GPU to go idle before shutting down
+    ReleaseRetired(true);
+    for (History& history : histories_) {
+        SafeRelease(history.color);
+        SafeRelease(history.moments[0]);
+        SafeRelease(history.moments[1]);
+        history.valid = false;
+    }
+    SafeRelease(targets_[0]);
+    SafeRelease(targets_[1]);
+    width_ = 0;
+    height_ = 0;
+    SafeRelease(temporalPipeline_);
+    SafeRelease(variancePipeline_);
+    SafeRelease(atrousPipeline_);
+    SafeRelease(rootSignature_);
+    SafeRelease(descriptorHeap_);
+    device_ = nullptr;
+}
+
+void RayTracingEngine::Denoiser::SetSettings(const Settings& settings) {
+    settings_ = settings;
+    settings_.atrousIterations = std::clamp(settings_.atrousIterations, 1u, MAX_ATROUS_ITERATIONS);
+    settings_.temporalAlpha = std::clamp(settings_.temporalAlpha, 0.0f, 1.0f);
+    settings_.momentsAlpha = std::clamp(settings_.momentsAlpha, 0.0f, 1.0f);
+    settings_.maxHistoryLength = std::max(settings_.maxHistoryLength, 1u);
+    settings_.phiDepth = std::max(settings_.phiDepth, 1e-4f);
+}
+
+void RayTracingEngine::Denoiser::SetTraceStride(DenoiseType type, UINT stride) {
+    histories_[static_cast<UINT>(type)].traceStride = stride >= 4 ? 4 : (stride >= 2 ? 2 : 1);
+}
+
+void RayTracingEngine::Denoiser::BeginFrame(const Guides& guides) {
+    guides_ = guides;
+    ++frame_;
+    ReleaseRetired(false);
+}
+
+bool RayTracingEngine::Denoiser::CreatePipelines() {
+    D3D12_DESCRIPTOR_RANGE ranges[2] = {};
+    ranges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    ranges[0].NumDescriptors = DENOISER_INPUTS;
+    ranges[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+    ranges[1].NumDescriptors = DENOISER_TARGETS;
+
+    D3D12_ROOT_PARAMETER parameters[3] = {};
+    parameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    parameters[0].Constants.Num32BitValues = sizeof(Constants) / sizeof(UINT);
+    for (UINT i = 0; i < 2; ++i) {
+        parameters[i + 1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        parameters[i + 1].DescriptorTable.NumDescriptorRanges = 1;
+        parameters[i + 1].DescriptorTable.pDescriptorRanges = &ranges[i];
+    }
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 3;
+    desc.pParameters = parameters;
+
+    ID3DBlob* serialized = nullptr;
+    ID3DBlob* errors = nullptr;
+    HRESULT hr = D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &serialized, &errors);
+    if (SUCCEEDED(hr)) {
+        hr = device_->CreateRootSignature(0, serialized->GetBufferPointer(), serialized->GetBufferSize(),
+                                          IID_PPV_ARGS(&rootSignature_));
+    }
+    SafeRelease(serialized);
+    SafeRelease(errors);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create the denoiser root signature");
+        return false;
+    }
+
+    temporalPipeline_ = CreateComputePipeline(device_, rootSignature_, DENOISE_COMMON_SOURCE, DENOISE_TEMPORAL_SOURCE,
+                                              "DenoiseTemporal");
+    variancePipeline_ = CreateComputePipeline(device_, rootSignature_, DENOISE_COMMON_SOURCE, DENOISE_VARIANCE_SOURCE,
+                                              "DenoiseVariance");
+    atrousPipeline_ = CreateComputePipeline(device_, rootSignature_, DENOISE_COMMON_SOURCE, DENOISE_ATROUS_SOURCE,
+                                            "DenoiseAtrous");
+    return temporalPipeline_ && variancePipeline_ && atrousPipeline_;
+}
+
+bool RayTracingEngine::Denoiser::EnsureTargets(UINT width, UINT height) {
+    if (width == width_ && height == height_ && targets_[0] && targets_[1]) return true;
+
+    // The GPU may still be filtering with the old ones
+    Retire(targets_[0]);
+    Retire(targets_[1]);
+    for (History& history : histories_) {
+        Retire(history.color);
+        Retire(history.moments[0]);
+        Retire(history.moments[1]);
+        history.valid = false;
+    }
+    width_ = 0;
+    height_ = 0;
+
+    targets_[0] = CreateTexture(device_, width, height);
+    targets_[1] = CreateTexture(device_, width, height);
+    if (!targets_[0] || !targets_[1]) {
+        Logger::Error("Failed to create the denoiser targets");
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+void RayTracingEngine::Denoiser::Retire(ID3D12Resource*& resource) {
+    if (!resource) return;
+    retired_.emplace_back(frame_, resource);
+    resource = nullptr;
+}
+
+void RayTracingEngine::Denoiser::ReleaseRetired(bool all) {
+    auto expired = std::remove_if(retired_.begin(), retired_.end(), [&](const std::pair<UINT64, ID3D12Resource*>& entry) {
+        if (!all && entry.first + RTScene::FRAMES_IN_FLIGHT > frame_) return false;
+        entry.second->Release();
+        return true;
+    });
+    retired_.erase(expired, retired_.end());
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE RayTracingEngine::Denoiser::WriteDescriptors(ID3D12Resource* const* resources, UINT count,
+                                                                         bool unordered) {
+    // A table never wraps, so that it stays contiguous
+    if (nextDescriptor_ + count > DESCRIPTOR_RING) {
+        nextDescriptor_ = 0;
+    }
+    D3D12_CPU_DESCRIPTOR_HANDLE cpu = descriptorHeap_->GetCPUDescriptorHandleForHeapStart();
+    D3D12_GPU_DESCRIPTOR_HANDLE gpu = descriptorHeap_->GetGPUDescriptorHandleForHeapStart();
+    cpu.ptr += static_cast<SIZE_T>(nextDescriptor_) * descriptorSize_;
+    gpu.ptr += static_cast<UINT64>(nextDescriptor_) * descriptorSize_;
+    nextDescriptor_ += count;
+
+    for (UINT i = 0; i < count; ++i) {
+        D3D12_CPU_DESCRIPTOR_HANDLE handle = cpu;
+        handle.ptr += static_cast<SIZE_T>(i) * descriptorSize_;
+        if (unordered) {
+            // Unused slots get a null view so every table entry is valid
+            D3D12_UNORDERED_ACCESS_VIEW_DESC desc = {};
+            desc.Format = DENOISER_FORMAT;
+            desc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+            device_->CreateUnorderedAccessView(resources[i], nullptr, resources[i] ? nullptr : &desc, handle);
+        } else {
+            device_->CreateShaderResourceView(resources[i], nullptr, handle);
+        }
+    }
+    return gpu;
+}
+
+void RayTracingEngine::Denoiser::Dispatch(ID3D12GraphicsCommandList4* commandList, ID3D12PipelineState* pipeline,
+                                          const Constants& constants, D3D12_GPU_DESCRIPTOR_HANDLE inputs,
+                                          ID3D12Resource* const (&targets)[4]) {
+    commandList->SetPipelineState(pipeline);
+    commandList->SetComputeRoot32BitConstants(0, sizeof(Constants) / sizeof(UINT), &constants, 0);
+    commandList->SetComputeRootDescriptorTable(1, inputs);
+    commandList->SetComputeRootDescriptorTable(2, WriteDescriptors(targets, DENOISER_TARGETS, true));
+    commandList->Dispatch((width_ + 7) / 8, (height_ + 7) / 8, 1);
+    UavBarrier(commandList, nullptr);
+}
+
+void RayTracingEngine::Denoiser::Denoise(ID3D12GraphicsCommandList4* commandList,
+                                         ID3D12Resource* noisyTexture, ID3D12Resource* denoisedTexture,
+                                         DenoiseType type) {
+    if (!device_ || !commandList || !noisyTexture || !denoisedTexture) return;
+    if (!guides_.depth || !guides_.normals || !guides_.motion || !guides_.previousDepth || !guides_.previousNormals) return;
+    NEXUS_PROFILE_SCOPE("RayTracingEngine::Denoiser::Denoise");
+
+    D3D12_RESOURCE_DESC outputDesc = denoisedTexture->GetDesc();
+    D3D12_RESOURCE_DESC noisyDesc = noisyTexture->GetDesc();
+    if (!EnsureTargets(static_cast<UINT>(outputDesc.Width), outputDesc.Height)) return;
+
+    History& history = histories_[static_cast<UINT>(type)];
+    if (!history.color) {
+        history.color = CreateTexture(device_, width_, height_);
+        history.moments[0] = CreateTexture(device_, width_, height_);
+        history.moments[1] = CreateTexture(device_, width_, height_);
+        history.valid = false;
+        if (!history.color || !history.moments[0] || !history.moments[1]) {
+            Logger::Error("Failed to create the denoiser history");
+            Retire(history.color);
+            Retire(history.moments[0]);
+            Retire(history.moments[1]);
+            return;
+        }
+    }
+
+    commandList->SetDescriptorHeaps(1, &descriptorHeap_);
+    commandList->SetComputeRootSignature(rootSignature_);
+
+    ID3D12Resource* const inputs[DENOISER_INPUTS] = {
+        noisyTexture, guides_.depth, guides_.normals, guides_.motion, guides_.previousDepth, guides_.previousNormals
+    };
+    D3D12_GPU_DESCRIPTOR_HANDLE inputTable = WriteDescriptors(inputs, DENOISER_INPUTS, false);
+
+    Constants constants = {};
+    constants.size[0] = width_;
+    constants.size[1] = height_;
+    constants.frame = frame_;
+    constants.traceStride = history.traceStride;
+    constants.temporalAlpha = settings_.temporalAlpha;
+    constants.momentsAlpha = settings_.momentsAlpha;
+    constants.maxHistoryLength = static_cast<float>(settings_.maxHistoryLength);
+    constants.historyValid = history.valid ? 1 : 0;
+    constants.phiColor = settings_.phiColor;
+    constants.phiNormal = settings_.phiNormal;
+    constants.phiDepth = settings_.phiDepth;
+    constants.noisySize[0] = static_cast<UINT>(noisyDesc.Width);
+    constants.noisySize[1] = noisyDesc.Height;
+
+    // Temporal accumulation into targets_[0] and this frame's moments
+    UINT previous = history.current;
+    history.current ^= 1;
+    ID3D12Resource* moments = history.moments[history.current];
+    Dispatch(commandList, temporalPipeline_, constants, inputTable,
+             { history.color, history.moments[previous], targets_[0], moments });
+
+    // Spatial variance where the history is short, into targets_[1]
+    Dispatch(commandList, variancePipeline_, constants, inputTable, { targets_[0], moments, targets_[1], nullptr });
+
+    // Wavelet passes alternate between the targets and end in the output; the first one is kept
+    for (UINT i = 0; i < settings_.atrousIterations; ++i) {
+        bool last = i + 1 == settings_.atrousIterations;
+        constants.stepSize = 1u << i;
+        constants.writeFeedback = i == 0 ? 1 : 0;
+        Dispatch(commandList, atrousPipeline_, constants, inputTable,
+                 { targets_[(i + 1) & 1], last ? denoisedTexture : targets_[i & 1], i == 0 ? history.color : nullptr, nullptr });
+    }
+    history.valid = true;
+}
+
+
+namespace {
+
+constexpr UINT LIST_COUNT = static_cast<UINT>(RayTracingEngine::HybridScheduler::TileList::Count);
+constexpr UINT TILE_PIXELS = RayTracingEngine::HybridScheduler::TILE_SIZE * RayTracingEngine::HybridScheduler::TILE_SIZE;
+constexpr UINT64 COUNTER_BYTES = 16;                 // One counter per list, padded
+constexpr UINT HYBRID_INPUTS = 2;
+
+const char* CLASSIFY_COMMON_SOURCE = R"(
+cbuffer ClassifyConstants : register(b0) {
+    uint2 Size;
+    uint2 TileCount;
+    uint TileCapacity;
+    uint ShadowTileLimit;
+    uint ReflectionTileLimit;
+    float PenumbraMin;
+    float PenumbraMax;
+    float ReflectionRoughness;
+    float SsrRoughness;
+    uint Padding;
+};
+
+Texture2D<float> ShadowVisibility : register(t0);
+Texture2D<float> Roughness : register(t1);
+RWByteAddressBuffer Counters : register(u0);
+RWStructuredBuffer<uint> Tiles : register(u1);
+RWByteAddressBuffer Arguments : register(u2);
+)";
+
+const char* CLASSIFY_TILES_SOURCE = R"(
+groupshared uint TilePenumbra;
+groupshared uint TileRoughness;
+
+[numthreads(8, 8, 1)]
+void main(uint3 group : SV_GroupID, uint3 thread : SV_GroupThreadID, uint index : SV_GroupIndex) {
+    if (index == 0) {
+        TilePenumbra = 0;
+        TileRoughness = asuint(1.0);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 pixel = group.xy * 8 + thread.xy;
+    if (all(pixel < Size)) {
+        float visibility = ShadowVisibility[pixel];
+        if (visibility > PenumbraMin && visibility < PenumbraMax) InterlockedOr(TilePenumbra, 1);
+        // Non-negative floats order like their bits
+        InterlockedMin(TileRoughness, asuint(saturate(Roughness[pixel])));
+    }
+    GroupMemoryBarrierWithGroupSync();
+    if (index != 0) return;
+
+    // Counters keep counting past the limits, which is the demand the CPU plans with
+    uint tile = group.x | (group.y << 16);
+    uint slot;
+    if (TilePenumbra != 0) {
+        Counters.InterlockedAdd(0, 1, slot);
+        if (slot < ShadowTileLimit) Tiles[slot] = tile;
+    }
+
+    float roughness = asfloat(TileRoughness);
+    bool traced = false;
+    if (roughness < ReflectionRoughness) {
+        Counters.InterlockedAdd(4, 1, slot);
+        if (slot < ReflectionTileLimit) {
+            Tiles[TileCapacity + slot] = tile;
+            traced = true;
+        }
+    }
+    if (!traced && roughness < SsrRoughness) {
+        Counters.InterlockedAdd(8, 1, slot);
+        Tiles[2 * TileCapacity + slot] = tile;
+    }
+}
+)";
+
+const char* CLASSIFY_ARGUMENTS_SOURCE = R"(
+[numthreads(1, 1, 1)]
+void main() {
+    Arguments.Store3(0, uint3(min(Counters.Load(0), ShadowTileLimit), 1, 1));
+    Arguments.Store3(12, uint3(min(Counters.Load(4), ReflectionTileLimit), 1, 1));
+    Arguments.Store3(24, uint3(Counters.Load(8), 1, 1));
+}
+)";
+
+} // namespace
+
+RayTracingEngine::HybridScheduler::HybridScheduler()
+    : device_(nullptr)
+    , rootSignature_(nullptr)
+    , classifyPipeline_(nullptr)
+    , argumentsPipeline_(nullptr)
+    , commandSignature_(nullptr)
+    , descriptorHeap_(nullptr)
+    , descriptorSize_(0)
+    , tiles_(nullptr)
+    , tileCapacity_(0)
+    , counters_(nullptr)
+    , arguments_(nullptr)
+    , zeros_(nullptr)
+    , readback_(nullptr)
+    , plans_{}
+    , pending_{}
+    , demandKnown_(false)
+    , lastTracedRays_(0)
+    , frame_(0)
+{
+}
+
+RayTracingEngine::HybridScheduler::~HybridScheduler() {
+    Shutdown();
+}
+
+bool RayTracingEngine::HybridScheduler::Initialize(ID3D12Device5* device) {
+    if (!device) return false;
+    Shutdown();
+    device_ = device;
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.NumDescriptors = HYBRID_INPUTS * RTScene::FRAMES_IN_FLIGHT;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    if (FAILED(device_->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&descriptorHeap_)))) {
+        Logger::Error("Failed to create the hybrid scheduler descriptor heap");
+        Shutdown();
+        return false;
+    }
+    descriptorSize_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    counters_ = CreateBuffer(device_, COUNTER_BYTES, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+                             D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    arguments_ = CreateBuffer(device_, LIST_COUNT * sizeof(D3D12_DISPATCH_ARGUMENTS), D3D12_HEAP_TYPE_DEFAULT,
+                              D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+    zeros_ = CreateBuffer(device_, COUNTER_BYTES, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_FLAG_NONE,
+                          D3D12_RESOURCE_STATE_GENERIC_READ);
+    readback_ = CreateBuffer(device_, COUNTER_BYTES * RTScene::FRAMES_IN_FLIGHT, D3D12_HEAP_TYPE_READBACK,
+                             D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COPY_DEST);
+    void* zeros = nullptr;
+    if (!counters_ || !arguments_ || !zeros_ || !readback_ || FAILED(zeros_->Map(0, nullptr, &zeros))) {
+        Logger::Error("Failed to create the hybrid scheduler buffers");
+        Shutdown();
+        return false;
+    }
+    std::memset(zeros, 0, COUNTER_BYTES);
+    zeros_->Unmap(0, nullptr);
+
+    D3D12_INDIRECT_ARGUMENT_DESC argument = {};
+    argument.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+    D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+    signatureDesc.ByteStride = sizeof(D3D12_DISPATCH_ARGUMENTS);
+    signatureDesc.NumArgumentDescs = 1;
+    signatureDesc.pArgumentDescs = &argument;
+    if (FAILED(device_->CreateCommandSignature(&signatureDesc, nullptr, IID_PPV_ARGS(&commandSignature_))) ||
+        !CreatePipelines()) {
+        Logger::Error("Failed to create the hybrid scheduler pipelines");
+        Shutdown();
+        return false;
+    }
+    return true;
+}
+
+void RayTracingEngine::HybridScheduler::Shutdown() {
+    // Callers wait for the GPU to go idle before shutting down
+    ReleaseRetired(true);
+    SafeRelease(tiles_);
+    tileCapacity_ = 0;
+    SafeRelease(counters_);
+    SafeRelease(arguments_);
+    SafeRelease(zeros_);
+    SafeRelease(readback_);
+    SafeRelease(classifyPipeline_);
+    SafeRelease(argumentsPipeline_);
+    SafeRelease(commandSignature_);
+    SafeRelease(rootSignature_);
+    SafeRelease(descriptorHeap_);
+    for (bool& pending : pending_) pending = false;
+    demandKnown_ = false;
+    device_ = nullptr;
+}
+
+void RayTracingEngine::HybridScheduler::SetSettings(const Settings& settings) {
+    settings_ = settings;
+    settings_.shadowShare = std::clamp(settings_.shadowShare, 0.0f, 1.0f);
+    settings_.shadowRaysPerPixel = std::max(settings_.shadowRaysPerPixel, 1u);
+    settings_.targetMilliseconds = std::max(settings_.targetMilliseconds, 0.0f);
+}
+
+RayTracingEngine::HybridScheduler::Plan RayTracingEngine::HybridScheduler::PlanFrame(const Settings& settings,
+                                                                                     const Demand& demand,
+                                                                                     UINT64 rayBudget,
+                                                                                     UINT previousStride) {
+    // Demand is a few frames old; an eighth more leaves room for it to grow meanwhile
+    auto expected = [](UINT tiles) { return static_cast<UINT64>(tiles) + tiles / 8 + 1; };
+
+    Plan plan;
+    plan.rayBudget = rayBudget;
+    const UINT64 shadowRaysPerTile = static_cast<UINT64>(TILE_PIXELS) * std::max(settings.shadowRaysPerPixel, 1u);
+    const UINT64 shadowBudget = static_cast<UINT64>(static_cast<double>(rayBudget) * std::clamp(settings.shadowShare, 0.0f, 1.0f));
+    const UINT64 shadowTiles = std::min(expected(demand.shadowTiles), shadowBudget / shadowRaysPerTile);
+    plan.shadowTileLimit = static_cast<UINT>(std::min<UINT64>(shadowTiles, UINT_MAX));
+
+    // Reflections get the rest, at the densest stride that fits. Going denser needs a quarter
+    // of headroom, so demand hovering at a boundary does not switch strides every frame
+    const UINT64 reflectionBudget = rayBudget - shadowTiles * shadowRaysPerTile;
+    const UINT64 reflectionTiles = expected(demand.reflectionTiles);
+    plan.reflectionStride = 4;
+    for (UINT stride : { 1u, 2u, 4u }) {
+        UINT64 rays = reflectionTiles * (TILE_PIXELS / stride);
+        if (stride < previousStride) rays += rays / 4;
+        if (rays <= reflectionBudget) {
+            plan.reflectionStride = stride;
+            break;
+        }
+    }
+    // Past the sparsest stride, the tiles over the limit spill over to SSR
+    plan.reflectionTileLimit = static_cast<UINT>(std::min<UINT64>(reflectionBudget / (TILE_PIXELS / plan.reflectionStride), UINT_MAX));
+    return plan;
+}
+
+void RayTracingEngine::HybridScheduler::ReportTracingTime(float milliseconds) {
+    if (milliseconds <= 0.0f || lastTracedRays_ == 0) return;
+    float rate = static_cast<float>(lastTracedRays_) / milliseconds;
+    stats_.raysPerMillisecond = stats_.raysPerMillisecond > 0.0f ? stats_.raysPerMillisecond + (rate - stats_.raysPerMillisecond) * 0.1f : rate;
+}
+
+void RayTracingEngine::HybridScheduler::BeginFrame(Denoiser* denoiser) {
+    ++frame_;
+    ReleaseRetired(false);
+
+    // The slice this frame overwrites was written FRAMES_IN_FLIGHT frames ago, so the GPU is done
+    const UINT slot = static_cast<UINT>(frame_ % RTScene::FRAMES_IN_FLIGHT);
+    if (pending_[slot] && readback_) {
+        D3D12_RANGE range = { slot * COUNTER_BYTES, slot * COUNTER_BYTES + LIST_COUNT * sizeof(UINT) };
+        void* data = nullptr;
+        if (SUCCEEDED(readback_->Map(0, &range, &data))) {
+            UINT counts[LIST_COUNT];
+            std::memcpy(counts, static_cast<uint8_t*>(data) + range.Begin, sizeof(counts));
+            D3D12_RANGE written = { 0, 0 };
+            readback_->Unmap(0, &written);
+
+            const Plan& plan = plans_[slot];
+            stats_.demand.shadowTiles = counts[0];
+            stats_.demand.reflectionTiles = counts[1];
+            const UINT shadowTraced = std::min(counts[0], plan.shadowTileLimit);
+            const UINT reflectionTraced = std::min(counts[1], plan.reflectionTileLimit);
+            stats_.shadowTilesFallback = counts[0] - shadowTraced;
+            stats_.reflectionTilesFallback = counts[1] - reflectionTraced;
+            lastTracedRays_ = static_cast<UINT64>(shadowTraced) * TILE_PIXELS * settings_.shadowRaysPerPixel +
+                              static_cast<UINT64>(reflectionTraced) * (TILE_PIXELS / plan.reflectionStride);
+            demandKnown_ = true;
+        }
+        pending_[slot] = false;
+    }
+
+    // With a time target the budget is what this GPU traces in that time, never more than the cap
+    UINT64 budget = settings_.rayBudget;
+    if (settings_.targetMilliseconds > 0.0f && stats_.raysPerMillisecond > 0.0f) {
+        UINT64 timed = static_cast<UINT64>(static_cast<double>(stats_.raysPerMillisecond) * settings_.targetMilliseconds);
+        budget = std::min(budget, std::max<UINT64>(timed, TILE_PIXELS));
+    }
+
+    // Until the first counts arrive, plan as if every tile wanted rays
+    Demand demand = stats_.demand;
+    if (!demandKnown_) {
+        demand.shadowTiles = UINT_MAX / 2;
+        demand.reflectionTiles = UINT_MAX / 2;
+    }
+    stats_.plan = PlanFrame(settings_, demand, budget, stats_.plan.reflectionStride);
+    if (denoiser) {
+        denoiser->SetTraceStride(Denoiser::DenoiseType::Reflections, stats_.plan.reflectionStride);
+    }
+}
+
+bool RayTracingEngine::HybridScheduler::CreatePipelines() {
+    D3D12_DESCRIPTOR_RANGE range = {};
+    range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    range.NumDescriptors = HYBRID_INPUTS;
+
+    D3D12_ROOT_PARAMETER parameters[5] = {};
+    parameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    parameters[0].Constants.Num32BitValues = sizeof(Constants) / sizeof(UINT);
+    parameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    parameters[1].DescriptorTable.NumDescriptorRanges = 1;
+    parameters[1].DescriptorTable.pDescriptorRanges = &range;
+    for (UINT i = 0; i < 3; ++i) {
+        parameters[i + 2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+        parameters[i + 2].Descriptor.ShaderRegister = i;
+    }
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 5;
+    desc.pParameters = parameters;
+
+    ID3DBlob* serialized = nullptr;
+    ID3DBlob* errors = nullptr;
+    HRESULT hr = D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &serialized, &errors);
+    if (SUCCEEDED(hr)) {
+        hr = device_->CreateRootSignature(0, serialized->GetBufferPointer(), serialized->GetBufferSize(),
+                                          IID_PPV_ARGS(&rootSignature_));
+    }
+    SafeRelease(serialized);
+    SafeRelease(errors);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create the hybrid scheduler root signature");
+        return false;
+    }
+
+    classifyPipeline_ = CreateComputePipeline(device_, rootSignature_, CLASSIFY_COMMON_SOURCE, CLASSIFY_TILES_SOURCE,
+                                              "HybridClassify");
+    argumentsPipeline_ = CreateComputePipeline(device_, rootSignature_, CLASSIFY_COMMON_SOURCE, CLASSIFY_ARGUMENTS_SOURCE,
+                                               "HybridArguments");
+    return classifyPipeline_ && argumentsPipeline_;
+}
+
+bool RayTracingEngine::HybridScheduler::EnsureTileBuffer(UINT tileCount) {
+    if (tiles_ && tileCapacity_ >= tileCount) return true;
+
+    // The GPU may still be reading the old lists
+    Retire(tiles_);
+    tileCapacity_ = 0;
+    tiles_ = CreateBuffer(device_, static_cast<UINT64>(tileCount) * LIST_COUNT * sizeof(UINT), D3D12_HEAP_TYPE_DEFAULT,
+                          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    if (!tiles_) {
+        Logger::Error("Failed to create the hybrid scheduler tile lists");
+        return false;
+    }
+    tileCapacity_ = tileCount;
+    return true;
+}
+
+void RayTracingEngine::HybridScheduler::Retire(ID3D12Resource*& resource) {
+    if (!resource) return;
+    retired_.emplace_back(frame_, resource);
+    resource = nullptr;
+}
+
+void RayTracingEngine::HybridScheduler::ReleaseRetired(bool all) {
+    auto expired = std::remove_if(retired_.begin(), retired_.end(), [&](const std::pair<UINT64, ID3D12Resource*>& entry) {
+        if (!all && entry.first + RTScene::FRAMES_IN_FLIGHT > frame_) return false;
+        entry.second->Release();
+        return true;
+    });
+    retired_.erase(expired, retired_.end());
+}
+
+void RayTracingEngine::HybridScheduler::Classify(ID3D12GraphicsCommandList4* commandList, const Inputs& inputs,
+                                                 UINT width, UINT height) {
+    if (!device_ || !commandList || !inputs.shadowVisibility || !inputs.roughness || width == 0 || height == 0) return;
+    NEXUS_PROFILE_SCOPE("RayTracingEngine::HybridScheduler::Classify");
+
+    const UINT tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const UINT tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    if (!EnsureTileBuffer(tilesX * tilesY)) return;
+
+    // This frame's slice of the descriptor heap; older slices may still be in use
+    const UINT slot = static_cast<UINT>(frame_ % RTScene::FRAMES_IN_FLIGHT);
+    D3D12_CPU_DESCRIPTOR_HANDLE cpu = descriptorHeap_->GetCPUDescriptorHandleForHeapStart();
+    D3D12_GPU_DESCRIPTOR_HANDLE gpu = descriptorHeap_->GetGPUDescriptorHandleForHeapStart();
+    cpu.ptr += static_cast<SIZE_T>(slot) * HYBRID_INPUTS * descriptorSize_;
+    gpu.ptr += static_cast<UINT64>(slot) * HYBRID_INPUTS * descriptorSize_;
+    device_->CreateShaderResourceView(inputs.shadowVisibility, nullptr, cpu);
+    cpu.ptr += descriptorSize_;
+    device_->CreateShaderResourceView(inputs.roughness, nullptr, cpu);
+
+    Constants constants = {};
+    constants.size[0] = width;
+    constants.size[1] = height;
+    constants.tiles[0] = tilesX;
+    constants.tiles[1] = tilesY;
+    constants.tileCapacity = tileCapacity_;
+    constants.shadowTileLimit = std::min(stats_.plan.shadowTileLimit, tileCapacity_);
+    constants.reflectionTileLimit = std::min(stats_.plan.reflectionTileLimit, tileCapacity_);
+    constants.penumbraMin = settings_.penumbraMin;
+    constants.penumbraMax = settings_.penumbraMax;
+    constants.reflectionRoughness = settings_.reflectionRoughness;
+    constants.ssrRoughness = settings_.ssrRoughness;
+
+    TransitionBarrier(commandList, counters_, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST);
+    commandList->CopyBufferRegion(counters_, 0, zeros_, 0, COUNTER_BYTES);
+    TransitionBarrier(commandList, counters_, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    TransitionBarrier(commandList, tiles_, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    TransitionBarrier(commandList, arguments_, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    commandList->SetDescriptorHeaps(1, &descriptorHeap_);
+    commandList->SetComputeRootSignature(rootSignature_);
+    commandList->SetComputeRoot32BitConstants(0, sizeof(Constants) / sizeof(UINT), &constants, 0);
+    commandList->SetComputeRootDescriptorTable(1, gpu);
+    commandList->SetComputeRootUnorderedAccessView(2, counters_->GetGPUVirtualAddress());
+    commandList->SetComputeRootUnorderedAccessView(3, tiles_->GetGPUVirtualAddress());
+    commandList->SetComputeRootUnorderedAccessView(4, arguments_->GetGPUVirtualAddress());
+
+    commandList->SetPipelineState(classifyPipeline_);
+    commandList->Dispatch(tilesX, tilesY, 1);
+    UavBarrier(commandList, counters_);
+    commandList->SetPipelineState(argumentsPipeline_);
+    commandList->Dispatch(1, 1, 1);
+
+    TransitionBarrier(commandList, arguments_, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+    TransitionBarrier(commandList, tiles_, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    TransitionBarrier(commandList, counters_, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    commandList->CopyBufferRegion(readback_, slot * COUNTER_BYTES, counters_, 0, COUNTER_BYTES);
+    TransitionBarrier(commandList, counters_, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    plans_[slot] = stats_.plan;
+    plans_[slot].shadowTileLimit = constants.shadowTileLimit;
+    plans_[slot].reflectionTileLimit = constants.reflectionTileLimit;
+    pending_[slot] = true;
+}
+
+void RayTracingEngine::HybridScheduler::DispatchTiles(ID3D12GraphicsCommandList4* commandList, TileList list) const {
+    if (!commandList || !commandSignature_ || list == TileList::Count) return;
+    commandList->ExecuteIndirect(commandSignature_, 1, arguments_,
+                                 static_cast<UINT64>(list) * sizeof(D3D12_DISPATCH_ARGUMENTS), nullptr, 0);
+}
+
+} // namespace Nexus
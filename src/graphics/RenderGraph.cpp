@@ -0,0 +1,923 @@
+#include "RenderGraph.h"
+#include "D3D12Device.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "StateCache.h"
+#include <algorithm>
+
+namespace Nexus {
+
+namespace {
+
+// Slots cleared when a pass's inputs or outputs may still be bound by an earlier pass
+constexpr UINT UNBIND_SHADER_RESOURCES = 16;
+constexpr UINT UNBIND_UNORDERED_ACCESS = D3D11_PS_CS_UAV_REGISTER_COUNT;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+bool IsDepthFormat(DXGI_FORMAT format) {
+    return format == DXGI_FORMAT_D32_FLOAT || format == DXGI_FORMAT_D24_UNORM_S8_UINT ||
+           format == DXGI_FORMAT_D16_UNORM;
+}
+
+// Depth storage must be typeless for the texture to be sampled as well
+DXGI_FORMAT StorageFormat(DXGI_FORMAT format) {
+    switch (format) {
+    case DXGI_FORMAT_D32_FLOAT: return DXGI_FORMAT_R32_TYPELESS;
+    case DXGI_FORMAT_D24_UNORM_S8_UINT: return DXGI_FORMAT_R24G8_TYPELESS;
+    case DXGI_FORMAT_D16_UNORM: return DXGI_FORMAT_R16_TYPELESS;
+    default: return format;
+    }
+}
+
+DXGI_FORMAT ShaderResourceFormat(DXGI_FORMAT format) {
+    switch (format) {
+    case DXGI_FORMAT_D32_FLOAT: return DXGI_FORMAT_R32_FLOAT;
+    case DXGI_FORMAT_D24_UNORM_S8_UINT: return DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+    case DXGI_FORMAT_D16_UNORM: return DXGI_FORMAT_R16_UNORM;
+    default: return format;
+    }
+}
+
+UINT BytesPerPixel(DXGI_FORMAT format) {
+    switch (format) {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R32G32_FLOAT: return 8;
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_D16_UNORM:
+    case DXGI_FORMAT_R8G8_UNORM: return 2;
+    case DXGI_FORMAT_R8_UNORM: return 1;
+    default: return 4;
+    }
+}
+
+constexpr D3D12_RESOURCE_STATES SHADER_READ_STATES =
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+
+D3D12_RESOURCE_FLAGS ResourceFlags(UINT bindFlags) {
+    D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
+    if (bindFlags & D3D11_BIND_RENDER_TARGET) flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    if (bindFlags & D3D11_BIND_UNORDERED_ACCESS) flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    if (bindFlags & D3D11_BIND_DEPTH_STENCIL) {
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+        if (!(bindFlags & D3D11_BIND_SHADER_RESOURCE)) flags |= D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
+    }
+    return flags;
+}
+
+UINT BindFlags(D3D12_RESOURCE_FLAGS flags) {
+    UINT bindFlags = (flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE) ? 0 : D3D11_BIND_SHADER_RESOURCE;
+    if (flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET) bindFlags |= D3D11_BIND_RENDER_TARGET;
+    if (flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) bindFlags |= D3D11_BIND_UNORDERED_ACCESS;
+    if (flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) bindFlags |= D3D11_BIND_DEPTH_STENCIL;
+    return bindFlags;
+}
+
+// States a compute queue list may transition between
+bool IsComputeState(D3D12_RESOURCE_STATES state) {
+    constexpr D3D12_RESOURCE_STATES COMPUTE_STATES =
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
+        D3D12_RESOURCE_STATE_COPY_DEST | D3D12_RESOURCE_STATE_COPY_SOURCE | D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+    return (state & ~COMPUTE_STATES) == 0;
+}
+
+// Pass indices with UINT32_MAX for none
+uint32_t Later(uint32_t a, uint32_t b) {
+    if (a == UINT32_MAX) return b;
+    if (b == UINT32_MAX) return a;
+    return std::max(a, b);
+}
+
+bool After(uint32_t pass, uint32_t joined) {
+    return pass != UINT32_MAX && (joined == UINT32_MAX || pass > joined);
+}
+
+bool Contains(const std::vector<RenderGraph::ResourceHandle>& handles, RenderGraph::ResourceHandle handle) {
+    return std::find(handles.begin(), handles.end(), handle) != handles.end();
+}
+
+// A pooled texture can stand in for a request if it is the same image with at least its bindings
+bool Compatible(const RenderGraph::TextureDesc& pooled, const RenderGraph::TextureDesc& requested) {
+    return pooled.width == requested.width && pooled.height == requested.height &&
+           pooled.format == requested.format && pooled.mipLevels == requested.mipLevels &&
+           (pooled.bindFlags & requested.bindFlags) == requested.bindFlags;
+}
+
+} // namespace
+
+RenderGraph::ResourceHandle RenderGraph::Builder::Read(ResourceHandle resource) {
+    if (resource < graph_.resources_.size()) {
+        graph_.passes_[pass_].reads.push_back(resource);
+    }
+    return resource;
+}
+
+RenderGraph::ResourceHandle RenderGraph::Builder::Write(ResourceHandle resource) {
+    if (resource < graph_.resources_.size()) {
+        graph_.passes_[pass_].writes.push_back(resource);
+    }
+    return resource;
+}
+
+RenderGraph::ResourceHandle RenderGraph::Builder::WriteUnordered(ResourceHandle resource) {
+    if (resource < graph_.resources_.size()) {
+        graph_.passes_[pass_].writes.push_back(resource);
+        graph_.passes_[pass_].unorderedWrites.push_back(resource);
+    }
+    return resource;
+}
+
+void RenderGraph::Builder::SetSideEffects() {
+    graph_.passes_[pass_].sideEffects = true;
+}
+
+void RenderGraph::Builder::SetAsyncCompute() {
+    graph_.passes_[pass_].asyncCompute = true;
+}
+
+RenderGraph::RenderGraph()
+    : device_(nullptr), context_(nullptr), stateCache_(nullptr), d3d12_(nullptr), jobs_(nullptr), asyncCompute_(true)
+    , lastGraphicsPass_(UINT32_MAX), computeJoined_(UINT32_MAX), graphicsJoined_(UINT32_MAX), frame_(0) {
+}
+
+RenderGraph::~RenderGraph() {
+    Shutdown();
+}
+
+bool RenderGraph::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache) {
+    if (!device || !context || !stateCache) return false;
+    device_ = device;
+    context_ = context;
+    stateCache_ = stateCache;
+    return true;
+}
+
+bool RenderGraph::Initialize(D3D12Device* device, JobSystem* jobs) {
+    if (!device) return false;
+    d3d12_ = device;
+    jobs_ = jobs;
+    return true;
+}
+
+void RenderGraph::Shutdown() {
+    ReleaseTransients();
+    device_ = nullptr;
+    context_ = nullptr;
+    stateCache_ = nullptr;
+    d3d12_ = nullptr;
+    jobs_ = nullptr;
+}
+
+RenderGraph::ResourceHandle RenderGraph::CreateTexture(const char* name, const TextureDesc& desc) {
+    if (desc.width == 0 || desc.height == 0) {
+        Logger::Warning(std::string("Render graph texture has no size: ") + name);
+        return INVALID_RESOURCE;
+    }
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resources_.push_back(resource);
+    return static_cast<ResourceHandle>(resources_.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::ImportTexture(const char* name, ID3D11Texture2D* texture,
+                                                       ID3D11ShaderResourceView* shaderResource,
+                                                       ID3D11RenderTargetView* renderTarget,
+                                                       ID3D11UnorderedAccessView* unorderedAccess,
+                                                       ID3D11DepthStencilView* depthStencil) {
+    if (!texture) return INVALID_RESOURCE;
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    resource.imports.texture = texture;
+    resource.imports.shaderResource = shaderResource;
+    resource.imports.renderTarget = renderTarget;
+    resource.imports.unorderedAccess = unorderedAccess;
+    resource.imports.depthStencil = depthStencil;
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+    resource.desc.width = desc.Width;
+    resource.desc.height = desc.Height;
+    resource.desc.format = desc.Format;
+    resource.desc.bindFlags = desc.BindFlags;
+    resource.desc.mipLevels = desc.MipLevels;
+    resources_.push_back(resource);
+    return static_cast<ResourceHandle>(resources_.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::ImportResource(const char* name, ID3D12Resource* resource,
+                                                        D3D12_RESOURCE_STATES state,
+                                                        D3D12_RESOURCE_STATES finalState) {
+    if (!resource) return INVALID_RESOURCE;
+    Resource entry;
+    entry.name = name;
+    entry.imported = true;
+    entry.imports.resource = resource;
+    entry.imports.state = state;
+    entry.finalState = finalState;
+    const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+    entry.desc.width = static_cast<UINT>(desc.Width);
+    entry.desc.height = desc.Height;
+    entry.desc.format = desc.Format;
+    entry.desc.bindFlags = BindFlags(desc.Flags);
+    entry.desc.mipLevels = desc.MipLevels;
+    resources_.push_back(entry);
+    return static_cast<ResourceHandle>(resources_.size() - 1);
+}
+
+void RenderGraph::AddPass(const char* name, const SetupCallback& setup, ExecuteCallback execute) {
+    if (d3d12_) {
+        Logger::Warning(std::string("Render graph runs D3D12 command passes, pass ignored: ") + name);
+        return;
+    }
+    Pass pass;
+    pass.name = name;
+    pass.execute = std::move(execute);
+    passes_.push_back(std::move(pass));
+    Builder builder(*this, static_cast<uint32_t>(passes_.size() - 1));
+    setup(builder);
+}
+
+void RenderGraph::AddCommandPass(const char* name, const SetupCallback& setup, RecordCallback record) {
+    if (!d3d12_) {
+        Logger::Warning(std::string("Render graph runs D3D11 passes, command pass ignored: ") + name);
+        return;
+    }
+    Pass pass;
+    pass.name = name;
+    pass.record = std::move(record);
+    passes_.push_back(std::move(pass));
+    Builder builder(*this, static_cast<uint32_t>(passes_.size() - 1));
+    setup(builder);
+}
+
+void RenderGraph::Compile() {
+    // Walk back from the outputs: a pass lives if it writes an import, something a later live
+    // pass reads, or has side effects. Passes are recorded in order, so one sweep suffices
+    std::vector<bool> needed(resources_.size(), false);
+    for (size_t i = passes_.size(); i-- > 0;) {
+        Pass& pass = passes_[i];
+        pass.live = pass.sideEffects;
+        for (ResourceHandle write : pass.writes) {
+            if (resources_[write].imported || needed[write]) {
+                pass.live = true;
+            }
+        }
+        if (!pass.live) {
+            stats_.culledPasses++;
+            continue;
+        }
+        for (ResourceHandle read : pass.reads) {
+            needed[read] = true;
+        }
+    }
+
+    // Lifetimes span the first to the last live pass touching each transient
+    for (uint32_t i = 0; i < passes_.size(); ++i) {
+        const Pass& pass = passes_[i];
+        if (!pass.live) continue;
+        for (const std::vector<ResourceHandle>* list : { &pass.reads, &pass.writes }) {
+            for (ResourceHandle handle : *list) {
+                Resource& resource = resources_[handle];
+                resource.firstPass = std::min(resource.firstPass, i);
+                resource.lastPass = std::max(resource.lastPass, i);
+            }
+        }
+    }
+    for (ResourceHandle handle = 0; handle < resources_.size(); ++handle) {
+        const Resource& resource = resources_[handle];
+        if (resource.imported || resource.firstPass == UINT32_MAX) continue;
+        passes_[resource.firstPass].acquires.push_back(handle);
+        passes_[resource.lastPass].releases.push_back(handle);
+        stats_.transientTextures++;
+    }
+}
+
+uint32_t RenderGraph::AcquireTexture(const TextureDesc& desc) {
+    for (uint32_t i = 0; i < pool_.size(); ++i) {
+        PooledTexture& pooled = pool_[i];
+        if (!pooled.inUse && Compatible(pooled.desc, desc)) {
+            pooled.inUse = true;
+            pooled.lastUsedFrame = frame_;
+            return i;
+        }
+    }
+
+    PooledTexture pooled;
+    pooled.desc = desc;
+    if (d3d12_) {
+        D3D12_RESOURCE_DESC resourceDesc = {};
+        resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        resourceDesc.Width = desc.width;
+        resourceDesc.Height = desc.height;
+        resourceDesc.DepthOrArraySize = 1;
+        resourceDesc.MipLevels = static_cast<UINT16>(desc.mipLevels);
+        resourceDesc.Format = StorageFormat(desc.format);
+        resourceDesc.SampleDesc.Count = 1;
+        resourceDesc.Flags = ResourceFlags(desc.bindFlags);
+
+        // Targets start in their write state with a clear value to match, black or far depth
+        D3D12_CLEAR_VALUE clearValue = {};
+        clearValue.Format = desc.format;
+        const bool depth = IsDepthFormat(desc.format) && (desc.bindFlags & D3D11_BIND_DEPTH_STENCIL);
+        const bool target = !depth && (desc.bindFlags & D3D11_BIND_RENDER_TARGET);
+        if (depth) {
+            clearValue.DepthStencil.Depth = 1.0f;
+            pooled.state = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+        } else if (target) {
+            pooled.state = D3D12_RESOURCE_STATE_RENDER_TARGET;
+        }
+        pooled.resource = d3d12_->CreateResource(resourceDesc, pooled.state, depth || target ? &clearValue : nullptr);
+        if (!pooled.resource) {
+            Logger::Error("Failed to create render graph texture");
+            return UINT32_MAX;
+        }
+        pooled.inUse = true;
+        pooled.lastUsedFrame = frame_;
+        pool_.push_back(pooled);
+        return static_cast<uint32_t>(pool_.size() - 1);
+    }
+
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    textureDesc.Width = desc.width;
+    textureDesc.Height = desc.height;
+    textureDesc.MipLevels = desc.mipLevels;
+    textureDesc.ArraySize = 1;
+    textureDesc.Format = StorageFormat(desc.format);
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Usage = D3D11_USAGE_DEFAULT;
+    textureDesc.BindFlags = desc.bindFlags;
+
+    if (FAILED(device_->CreateTexture2D(&textureDesc, nullptr, &pooled.texture))) {
+        Logger::Error("Failed to create render graph texture");
+        return UINT32_MAX;
+    }
+    pooled.inUse = true;
+    pooled.lastUsedFrame = frame_;
+    pool_.push_back(pooled);
+    return static_cast<uint32_t>(pool_.size() - 1);
+}
+
+void RenderGraph::Barrier(const Pass& pass) {
+    bool unbindOutputs = false;
+    bool unbindInputs = false;
+    for (ResourceHandle read : pass.reads) {
+        const PooledTexture* views = Views(read);
+        unbindOutputs |= views && views->boundAsOutput;
+    }
+    for (ResourceHandle write : pass.writes) {
+        const PooledTexture* views = Views(write);
+        unbindInputs |= views && views->boundAsInput;
+    }
+
+    // The runtime would silently unbind the conflicting views and leave the state cache stale
+    if (unbindOutputs) {
+        ID3D11UnorderedAccessView* nullTargets[UNBIND_UNORDERED_ACCESS] = {};
+        stateCache_->OMSetRenderTargets(0, nullptr, nullptr);
+        context_->CSSetUnorderedAccessViews(0, UNBIND_UNORDERED_ACCESS, nullTargets, nullptr);
+        for (PooledTexture& pooled : pool_) pooled.boundAsOutput = false;
+        for (Resource& resource : resources_) resource.imports.boundAsOutput = false;
+        stats_.barriers++;
+    }
+    if (unbindInputs) {
+        ID3D11ShaderResourceView* nullViews[UNBIND_SHADER_RESOURCES] = {};
+        stateCache_->VSSetShaderResources(0, UNBIND_SHADER_RESOURCES, nullViews);
+        stateCache_->PSSetShaderResources(0, UNBIND_SHADER_RESOURCES, nullViews);
+        context_->CSSetShaderResources(0, UNBIND_SHADER_RESOURCES, nullViews);
+        for (PooledTexture& pooled : pool_) pooled.boundAsInput = false;
+        for (Resource& resource : resources_) resource.imports.boundAsInput = false;
+        stats_.barriers++;
+    }
+
+    for (ResourceHandle read : pass.reads) {
+        if (PooledTexture* views = Views(read)) views->boundAsInput = true;
+    }
+    for (ResourceHandle write : pass.writes) {
+        if (PooledTexture* views = Views(write)) views->boundAsOutput = true;
+    }
+}
+
+void RenderGraph::Execute() {
+    if (passes_.empty()) return;
+    NEXUS_PROFILE_SCOPE("RenderGraph::Execute");
+    frame_++;
+    stats_ = Stats();
+    Compile();
+
+    if (d3d12_) {
+        ExecuteCommandPasses();
+    } else {
+        for (Pass& pass : passes_) {
+            if (!pass.live) continue;
+            bool allocated = true;
+            for (ResourceHandle handle : pass.acquires) {
+                Resource& resource = resources_[handle];
+                resource.physical = AcquireTexture(resource.desc);
+                allocated &= resource.physical != UINT32_MAX;
+            }
+            if (allocated) {
+                Barrier(pass);
+                pass.execute(*this);
+                stats_.passes++;
+            } else {
+                Logger::Warning("Render graph pass skipped, transient allocation failed: " + pass.name);
+            }
+            // Freed textures back the next pass's new transients
+            for (ResourceHandle handle : pass.releases) {
+                const Resource& resource = resources_[handle];
+                if (resource.physical != UINT32_MAX) {
+                    pool_[resource.physical].inUse = false;
+                }
+            }
+        }
+    }
+
+    for (const PooledTexture& pooled : pool_) {
+        stats_.physicalTextures += pooled.lastUsedFrame == frame_ ? 1 : 0;
+    }
+    TrimPool();
+    passes_.clear();
+    resources_.clear();
+}
+
+void RenderGraph::ExecuteCommandPasses() {
+    // States are tracked, views created and passes scheduled serially in pass order; only
+    // recording is parallel
+    batches_.clear();
+    queueOrder_[0].clear();
+    queueOrder_[1].clear();
+    passBatch_.assign(passes_.size(), UINT32_MAX);
+    lastTouch_.clear();
+    lastGraphicsPass_ = UINT32_MAX;
+    computeJoined_ = UINT32_MAX;
+    graphicsJoined_ = UINT32_MAX;
+    uint32_t lastComputePass = UINT32_MAX;
+
+    for (uint32_t i = 0; i < passes_.size(); ++i) {
+        Pass& pass = passes_[i];
+        if (!pass.live) continue;
+        bool allocated = true;
+        for (ResourceHandle handle : pass.acquires) {
+            Resource& resource = resources_[handle];
+            resource.physical = AcquireTexture(resource.desc);
+            allocated &= resource.physical != UINT32_MAX;
+        }
+        if (allocated) {
+            Schedule(i);
+            CreateViews(pass);
+            stats_.passes++;
+            if (pass.asyncCompute) {
+                stats_.asyncPasses++;
+                lastComputePass = i;
+            }
+        } else {
+            Logger::Warning("Render graph pass skipped, transient allocation failed: " + pass.name);
+        }
+        for (ResourceHandle handle : pass.releases) {
+            const Resource& resource = resources_[handle];
+            if (resource.physical != UINT32_MAX) {
+                pool_[resource.physical].inUse = false;
+            }
+        }
+    }
+
+    // Imports leave in the state their owner expects, once the compute queue is done with them
+    uint32_t finish = OpenBatch(false, After(lastComputePass, graphicsJoined_) ? EndBatchAfter(lastComputePass)
+                                                                               : UINT32_MAX);
+    for (Resource& resource : resources_) {
+        if (resource.imported && resource.firstPass != UINT32_MAX) {
+            Transition(batches_[finish].tail, resource.imports, resource.finalState);
+        }
+    }
+    SubmitBatches();
+
+    // Views of imports last the frame; the device keeps them until the GPU is done
+    for (Resource& resource : resources_) {
+        if (!resource.imported) continue;
+        d3d12_->FreeDescriptor(resource.imports.shaderResourceIndex);
+        d3d12_->FreeDescriptor(resource.imports.unorderedAccessIndex);
+        d3d12_->FreeRenderTargetView(resource.imports.renderTargetIndex);
+        d3d12_->FreeDepthStencilView(resource.imports.depthStencilIndex);
+    }
+}
+
+void RenderGraph::Schedule(uint32_t index) {
+    Pass& pass = passes_[index];
+    bool compute = pass.asyncCompute && asyncCompute_ && d3d12_->HasAsyncCompute() &&
+                   pass.unorderedWrites.size() == pass.writes.size();
+
+    // The state each texture needs; one the pass also writes stays in its write state
+    std::vector<std::pair<PooledTexture*, D3D12_RESOURCE_STATES>> accesses;
+    auto gather = [&]() {
+        accesses.clear();
+        for (ResourceHandle write : pass.writes) {
+            PooledTexture* texture = Views(write);
+            D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_RENDER_TARGET;
+            if (Contains(pass.unorderedWrites, write)) state = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+            else if (IsDepthFormat(texture->desc.format)) state = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+            accesses.emplace_back(texture, state);
+        }
+        for (ResourceHandle read : pass.reads) {
+            if (Contains(pass.writes, read)) continue;
+            PooledTexture* texture = Views(read);
+            D3D12_RESOURCE_STATES state = IsDepthFormat(texture->desc.format)
+                                              ? D3D12_RESOURCE_STATE_DEPTH_READ | SHADER_READ_STATES
+                                              : SHADER_READ_STATES;
+            // Compute reads in whatever readable state the texture is already in
+            if (compute) {
+                state = (texture->state & D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+                            ? texture->state : D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+            }
+            accesses.emplace_back(texture, state);
+        }
+    };
+    gather();
+
+    // Which graphics work the compute pass waits for, and whether the graphics queue must make
+    // transitions for it
+    uint32_t producer = UINT32_MAX;
+    bool graphicsTransitions = false;
+    if (compute) {
+        for (const auto& access : accesses) {
+            auto touch = lastTouch_.find(access.first->resource);
+            const bool touchedByCompute = touch != lastTouch_.end() && passes_[touch->second].asyncCompute;
+            if (touch != lastTouch_.end() && !touchedByCompute) {
+                producer = Later(producer, touch->second);
+            }
+            if (access.first->state == access.second ||
+                (IsComputeState(access.first->state) && IsComputeState(access.second))) {
+                continue;
+            }
+            // Only safe once the graphics queue has waited for the compute work using it
+            if (touchedByCompute && After(touch->second, graphicsJoined_)) {
+                compute = false;
+                break;
+            }
+            graphicsTransitions = true;
+        }
+        if (!compute) {
+            gather();
+        } else if (graphicsTransitions && producer == UINT32_MAX) {
+            producer = lastGraphicsPass_;
+        }
+    }
+
+    uint32_t batch = UINT32_MAX;
+    if (compute) {
+        uint32_t tailBatch = UINT32_MAX;
+        uint32_t waitFor = UINT32_MAX;
+        if (graphicsTransitions && producer == UINT32_MAX) {
+            // Nothing ran on the graphics queue yet; a batch of just the transitions
+            tailBatch = waitFor = OpenBatch(false, UINT32_MAX);
+            batches_[tailBatch].signal = true;
+        } else if (After(producer, computeJoined_)) {
+            tailBatch = waitFor = EndBatchAfter(producer);
+            computeJoined_ = producer;
+        } else if (graphicsTransitions) {
+            tailBatch = EndBatchAfter(computeJoined_);
+        }
+        batch = OpenBatch(true, waitFor);
+        for (const auto& access : accesses) {
+            const bool onCompute = access.first->state == access.second ||
+                                   (IsComputeState(access.first->state) && IsComputeState(access.second));
+            Transition(onCompute ? pass.barriers : batches_[tailBatch].tail, *access.first, access.second);
+        }
+    } else {
+        // The first graphics use of compute output waits for it
+        producer = UINT32_MAX;
+        for (const auto& access : accesses) {
+            auto touch = lastTouch_.find(access.first->resource);
+            if (touch != lastTouch_.end() && passes_[touch->second].asyncCompute) {
+                producer = Later(producer, touch->second);
+            }
+        }
+        uint32_t waitFor = UINT32_MAX;
+        if (After(producer, graphicsJoined_)) {
+            waitFor = EndBatchAfter(producer);
+            graphicsJoined_ = producer;
+        }
+        batch = OpenBatch(false, waitFor);
+        for (const auto& access : accesses) {
+            Transition(pass.barriers, *access.first, access.second);
+        }
+        lastGraphicsPass_ = index;
+    }
+
+    pass.asyncCompute = compute;
+    passBatch_[index] = batch;
+    batches_[batch].passes.push_back(index);
+    for (const auto& access : accesses) {
+        lastTouch_[access.first->resource] = index;
+    }
+}
+
+uint32_t RenderGraph::OpenBatch(bool compute, uint32_t waitFor) {
+    std::vector<uint32_t>& order = queueOrder_[compute ? 1 : 0];
+    if (waitFor == UINT32_MAX && !order.empty() && !batches_[order.back()].signal) {
+        return order.back();
+    }
+    // A wait comes before everything in its batch, so it starts a new one
+    Batch batch;
+    batch.compute = compute;
+    batch.waitFor = waitFor;
+    batches_.push_back(std::move(batch));
+    order.push_back(static_cast<uint32_t>(batches_.size() - 1));
+    if (waitFor != UINT32_MAX) stats_.queueWaits++;
+    return order.back();
+}
+
+uint32_t RenderGraph::EndBatchAfter(uint32_t pass) {
+    const uint32_t index = passBatch_[pass];
+    std::vector<uint32_t>& passes = batches_[index].passes;
+    auto at = std::find(passes.begin(), passes.end(), pass) + 1;
+    if (at == passes.end()) {
+        batches_[index].signal = true;
+        return index;
+    }
+
+    // Split: the part up to pass signals, the rest keeps the batch's place for anything waiting
+    // on its end
+    Batch head;
+    head.compute = batches_[index].compute;
+    head.passes.assign(passes.begin(), at);
+    head.waitFor = batches_[index].waitFor;
+    head.signal = true;
+    passes.erase(passes.begin(), at);
+    batches_[index].waitFor = UINT32_MAX;
+
+    const uint32_t headIndex = static_cast<uint32_t>(batches_.size());
+    for (uint32_t moved : head.passes) {
+        passBatch_[moved] = headIndex;
+    }
+    std::vector<uint32_t>& order = queueOrder_[head.compute ? 1 : 0];
+    order.insert(std::find(order.begin(), order.end(), index), headIndex);
+    batches_.push_back(std::move(head));
+    return headIndex;
+}
+
+void RenderGraph::SubmitBatches() {
+    // Graphics batches are spread over lists, at most one per thread; compute batches are short
+    const size_t threads = jobs_ && jobs_->IsInitialized() ? jobs_->GetWorkerCount() + 1 : 1;
+    std::vector<std::pair<uint32_t, size_t>> recordings;   // Batch, first pass of the list
+    std::vector<ID3D12GraphicsCommandList4*> lists;
+    std::vector<size_t> perList(batches_.size(), 0);
+    for (uint32_t b = 0; b < batches_.size(); ++b) {
+        Batch& batch = batches_[b];
+        if (batch.passes.empty() && batch.tail.empty()) continue;
+        const size_t count = batch.compute ? 1 : std::max<size_t>(1, std::min(batch.passes.size(), threads));
+        perList[b] = (batch.passes.size() + count - 1) / count;
+        for (size_t l = 0; l < count; ++l) {
+            ID3D12GraphicsCommandList4* list = d3d12_->BeginCommandList(
+                batch.compute ? D3D12Device::QueueType::Compute : D3D12Device::QueueType::Graphics);
+            batch.lists.push_back(list);
+            lists.push_back(list);
+            recordings.emplace_back(b, l * perList[b]);
+        }
+    }
+
+    auto record = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!lists[i]) continue;
+            const Batch& batch = batches_[recordings[i].first];
+            const size_t first = recordings[i].second;
+            const size_t last = std::min(batch.passes.size(), first + perList[recordings[i].first]);
+            for (size_t p = first; p < last; ++p) {
+                Pass& pass = passes_[batch.passes[p]];
+                if (!pass.barriers.empty()) {
+                    lists[i]->ResourceBarrier(static_cast<UINT>(pass.barriers.size()), pass.barriers.data());
+                }
+                pass.record(*this, lists[i]);
+            }
+            if (lists[i] == batch.lists.back() && !batch.tail.empty()) {
+                lists[i]->ResourceBarrier(static_cast<UINT>(batch.tail.size()), batch.tail.data());
+            }
+        }
+    };
+    if (jobs_ && jobs_->IsInitialized() && lists.size() > 1) {
+        jobs_->ParallelFor(lists.size(), 1, record);
+    } else {
+        record(0, lists.size());
+    }
+    stats_.commandLists = static_cast<uint32_t>(lists.size());
+
+    // Each queue in order, moving to the other whenever the next batch waits for one not yet
+    // submitted there
+    size_t next[2] = {};
+    while (next[0] < queueOrder_[0].size() || next[1] < queueOrder_[1].size()) {
+        bool progressed = false;
+        for (int queue = 0; queue < 2; ++queue) {
+            const D3D12Device::QueueType type = queue ? D3D12Device::QueueType::Compute : D3D12Device::QueueType::Graphics;
+            const D3D12Device::QueueType other = queue ? D3D12Device::QueueType::Graphics : D3D12Device::QueueType::Compute;
+            while (next[queue] < queueOrder_[queue].size()) {
+                Batch& batch = batches_[queueOrder_[queue][next[queue]]];
+                if (batch.waitFor != UINT32_MAX && !batches_[batch.waitFor].submitted) break;
+                if (batch.waitFor != UINT32_MAX) {
+                    d3d12_->Wait(type, other, batches_[batch.waitFor].signaled);
+                }
+                d3d12_->Submit(batch.lists.data(), static_cast<UINT>(batch.lists.size()), type);
+                if (batch.signal) {
+                    batch.signaled = d3d12_->Signal(type);
+                }
+                batch.submitted = true;
+                next[queue]++;
+                progressed = true;
+            }
+        }
+        if (!progressed) {
+            Logger::Error("Render graph queues wait on each other, frame dropped");
+            break;
+        }
+    }
+}
+
+void RenderGraph::Transition(std::vector<D3D12_RESOURCE_BARRIER>& barriers, PooledTexture& texture,
+                             D3D12_RESOURCE_STATES state) {
+    D3D12_RESOURCE_BARRIER barrier = {};
+    if (texture.state == state) {
+        // Unordered writes in consecutive passes still have to finish in order
+        if (state != D3D12_RESOURCE_STATE_UNORDERED_ACCESS) return;
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        barrier.UAV.pResource = texture.resource;
+    } else {
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Transition.pResource = texture.resource;
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        barrier.Transition.StateBefore = texture.state;
+        barrier.Transition.StateAfter = state;
+        texture.state = state;
+    }
+    barriers.push_back(barrier);
+    stats_.barriers++;
+}
+
+void RenderGraph::CreateViews(const Pass& pass) {
+    for (ResourceHandle read : pass.reads) {
+        PooledTexture* texture = Views(read);
+        if (texture->shaderResourceIndex != UINT32_MAX || !(texture->desc.bindFlags & D3D11_BIND_SHADER_RESOURCE)) {
+            continue;
+        }
+        D3D12_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+        viewDesc.Format = ShaderResourceFormat(texture->desc.format);
+        viewDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        viewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        viewDesc.Texture2D.MipLevels = texture->desc.mipLevels;
+        texture->shaderResourceIndex = d3d12_->CreateShaderResourceView(texture->resource, &viewDesc);
+    }
+    for (ResourceHandle write : pass.writes) {
+        PooledTexture* texture = Views(write);
+        if (Contains(pass.unorderedWrites, write)) {
+            if (texture->unorderedAccessIndex == UINT32_MAX) {
+                texture->unorderedAccessIndex = d3d12_->CreateUnorderedAccessView(texture->resource, nullptr);
+            }
+        } else if (IsDepthFormat(texture->desc.format)) {
+            if (texture->depthStencilIndex == UINT32_MAX) {
+                D3D12_DEPTH_STENCIL_VIEW_DESC viewDesc = {};
+                viewDesc.Format = texture->desc.format;
+                viewDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+                texture->depthStencilIndex = d3d12_->CreateDepthStencilView(texture->resource, &viewDesc);
+            }
+        } else if (texture->renderTargetIndex == UINT32_MAX) {
+            texture->renderTargetIndex = d3d12_->CreateRenderTargetView(texture->resource, nullptr);
+        }
+    }
+}
+
+void RenderGraph::TrimPool() {
+    stats_.pooledBytes = 0;
+    for (size_t i = pool_.size(); i-- > 0;) {
+        PooledTexture& pooled = pool_[i];
+        if (frame_ - pooled.lastUsedFrame > POOL_RETENTION_FRAMES) {
+            ReleasePooled(pooled);
+            pool_.erase(pool_.begin() + i);
+            continue;
+        }
+        uint64_t bytes = static_cast<uint64_t>(pooled.desc.width) * pooled.desc.height * BytesPerPixel(pooled.desc.format);
+        stats_.pooledBytes += pooled.desc.mipLevels > 1 ? bytes * 4 / 3 : bytes;
+    }
+}
+
+void RenderGraph::ReleaseTransients() {
+    passes_.clear();
+    resources_.clear();
+    for (PooledTexture& pooled : pool_) {
+        ReleasePooled(pooled);
+    }
+    pool_.clear();
+    stats_.pooledBytes = 0;
+}
+
+void RenderGraph::ReleasePooled(PooledTexture& texture) {
+    if (texture.resource) {
+        d3d12_->FreeDescriptor(texture.shaderResourceIndex);
+        d3d12_->FreeDescriptor(texture.unorderedAccessIndex);
+        d3d12_->FreeRenderTargetView(texture.renderTargetIndex);
+        d3d12_->FreeDepthStencilView(texture.depthStencilIndex);
+        d3d12_->ReleaseResource(texture.resource);
+        texture = PooledTexture();
+        return;
+    }
+    SafeRelease(texture.depthStencil);
+    SafeRelease(texture.unorderedAccess);
+    SafeRelease(texture.renderTarget);
+    SafeRelease(texture.shaderResource);
+    SafeRelease(texture.texture);
+}
+
+RenderGraph::PooledTexture* RenderGraph::Views(ResourceHandle resource) {
+    if (resource >= resources_.size()) return nullptr;
+    Resource& entry = resources_[resource];
+    if (entry.imported) return &entry.imports;
+    return entry.physical < pool_.size() ? &pool_[entry.physical] : nullptr;
+}
+
+const RenderGraph::PooledTexture* RenderGraph::Views(ResourceHandle resource) const {
+    return const_cast<RenderGraph*>(this)->Views(resource);
+}
+
+ID3D11Texture2D* RenderGraph::GetTexture(ResourceHandle resource) const {
+    const PooledTexture* views = Views(resource);
+    return views ? views->texture : nullptr;
+}
+
+ID3D11ShaderResourceView* RenderGraph::GetShaderResourceView(ResourceHandle resource) {
+    PooledTexture* views = Views(resource);
+    if (!views) return nullptr;
+    if (!views->shaderResource && !resources_[resource].imported &&
+        (views->desc.bindFlags & D3D11_BIND_SHADER_RESOURCE)) {
+        D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+        viewDesc.Format = ShaderResourceFormat(views->desc.format);
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        viewDesc.Texture2D.MipLevels = views->desc.mipLevels;
+        device_->CreateShaderResourceView(views->texture, &viewDesc, &views->shaderResource);
+    }
+    return views->shaderResource;
+}
+
+ID3D11RenderTargetView* RenderGraph::GetRenderTargetView(ResourceHandle resource) {
+    PooledTexture* views = Views(resource);
+    if (!views) return nullptr;
+    if (!views->renderTarget && !resources_[resource].imported &&
+        (views->desc.bindFlags & D3D11_BIND_RENDER_TARGET)) {
+        device_->CreateRenderTargetView(views->texture, nullptr, &views->renderTarget);
+    }
+    return views->renderTarget;
+}
+
+ID3D11UnorderedAccessView* RenderGraph::GetUnorderedAccessView(ResourceHandle resource) {
+    PooledTexture* views = Views(resource);
+    if (!views) return nullptr;
+    if (!views->unorderedAccess && !resources_[resource].imported &&
+        (views->desc.bindFlags & D3D11_BIND_UNORDERED_ACCESS)) {
+        device_->CreateUnorderedAccessView(views->texture, nullptr, &views->unorderedAccess);
+    }
+    return views->unorderedAccess;
+}
+
+ID3D11DepthStencilView* RenderGraph::GetDepthStencilView(ResourceHandle resource) {
+    PooledTexture* views = Views(resource);
+    if (!views) return nullptr;
+    if (!views->depthStencil && !resources_[resource].imported && IsDepthFormat(views->desc.format) &&
+        (views->desc.bindFlags & D3D11_BIND_DEPTH_STENCIL)) {
+        D3D11_DEPTH_STENCIL_VIEW_DESC viewDesc = {};
+        viewDesc.Format = views->desc.format;
+        viewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+        device_->CreateDepthStencilView(views->texture, &viewDesc, &views->depthStencil);
+    }
+    return views->depthStencil;
+}
+
+ID3D12Resource* RenderGraph::GetResource(ResourceHandle resource) const {
+    const PooledTexture* texture = Views(resource);
+    return texture ? texture->resource : nullptr;
+}
+
+uint32_t RenderGraph::GetShaderResourceIndex(ResourceHandle resource) const {
+    const PooledTexture* texture = Views(resource);
+    return texture ? texture->shaderResourceIndex : UINT32_MAX;
+}
+
+uint32_t RenderGraph::GetUnorderedAccessIndex(ResourceHandle resource) const {
+    const PooledTexture* texture = Views(resource);
+    return texture ? texture->unorderedAccessIndex : UINT32_MAX;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE RenderGraph::GetRenderTargetHandle(ResourceHandle resource) const {
+    const PooledTexture* texture = Views(resource);
+    if (!texture || texture->renderTargetIndex == UINT32_MAX) return D3D12_CPU_DESCRIPTOR_HANDLE{};
+    return d3d12_->GetRenderTargetHandle(texture->renderTargetIndex);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE RenderGraph::GetDepthStencilHandle(ResourceHandle resource) const {
+    const PooledTexture* texture = Views(resource);
+    if (!texture || texture->depthStencilIndex == UINT32_MAX) return D3D12_CPU_DESCRIPTOR_HANDLE{};
+    return d3d12_->GetDepthStencilHandle(texture->depthStencilIndex);
+}
+
+} // namespace Nexus
@@ -0,0 +1,100 @@
+#include "RenderQueue.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Nexus {
+
+RenderQueue::RenderQueue()
+    : nearDepth_(0.0f)
+    , depthScale_(0.0f)
+    , sorted_(true)
+{
+    SetDepthRange(0.1f, 1000.0f);
+}
+
+void RenderQueue::SetDepthRange(float nearDepth, float farDepth) {
+    nearDepth_ = nearDepth;
+    depthScale_ = farDepth > nearDepth ? static_cast<float>(MAX_DEPTH) / (farDepth - nearDepth) : 0.0f;
+}
+
+uint32_t RenderQueue::QuantizeDepth(float viewDepth) const {
+    float scaled = (viewDepth - nearDepth_) * depthScale_;
+    if (!(scaled > 0.0f)) return 0; // Also catches NaN
+    if (scaled >= static_cast<float>(MAX_DEPTH)) return MAX_DEPTH;
+    return static_cast<uint32_t>(scaled);
+}
+
+uint64_t RenderQueue::MakeKey(Pass pass, BlendMode blend, uint32_t shader, uint32_t material, uint32_t mesh, float viewDepth) const {
+    uint64_t key = (static_cast<uint64_t>(pass) & 0xF) << 60 |
+                   (static_cast<uint64_t>(blend) & 0x3) << 58;
+    uint64_t state = static_cast<uint64_t>(std::min(shader, MAX_SHADER)) << 24 |
+                     static_cast<uint64_t>(std::min(material, MAX_MATERIAL)) << 12 |
+                     static_cast<uint64_t>(std::min(mesh, MAX_MESH));
+    uint64_t depth = QuantizeDepth(viewDepth);
+
+    if (blend >= BlendMode::Translucent) {
+        // Far first for correct blending, state only breaks ties
+        return key | (static_cast<uint64_t>(MAX_DEPTH) - depth) << 34 | state;
+    }
+    return key | state << 24 | depth;
+}
+
+void RenderQueue::Reserve(size_t count) {
+    entries_.reserve(count);
+    scratch_.reserve(count);
+}
+
+void RenderQueue::Submit(uint64_t key, uint32_t payload) {
+    entries_.push_back({key, payload});
+    sorted_ = false;
+}
+
+void RenderQueue::Sort() {
+    if (sorted_) return;
+    sorted_ = true;
+    if (entries_.size() < 2) return;
+
+    NEXUS_PROFILE_SCOPE("RenderQueue::Sort");
+
+    // One pass builds the histograms for all eight key bytes
+    uint32_t histograms[8][256];
+    std::memset(histograms, 0, sizeof(histograms));
+    for (const Entry& entry : entries_) {
+        for (int byte = 0; byte < 8; ++byte) {
+            histograms[byte][(entry.key >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    scratch_.resize(entries_.size());
+    Entry* source = entries_.data();
+    Entry* destination = scratch_.data();
+    const uint32_t count = static_cast<uint32_t>(entries_.size());
+
+    for (int byte = 0; byte < 8; ++byte) {
+        uint32_t* histogram = histograms[byte];
+
+        // Every key has the same value in this byte, the pass would be a plain copy
+        const uint32_t firstBucket = (source[0].key >> (byte * 8)) & 0xFF;
+        if (histogram[firstBucket] == count) continue;
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (uint32_t i = 0; i < count; ++i) {
+            destination[histogram[(source[i].key >> (byte * 8)) & 0xFF]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+
+    // An odd number of scatter passes leaves the result in the scratch buffer
+    if (source != entries_.data()) {
+        entries_.swap(scratch_);
+    }
+}
+
+} // namespace Nexus
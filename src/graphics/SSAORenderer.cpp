@@ -0,0 +1,516 @@
+#include "SSAORenderer.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// Shared by every pass. Depth linearization and view position reconstruction assume a
+// symmetric perspective projection
+const char* COMMON_SOURCE = R"(
+    cbuffer SSAOConstants : register(b0)
+    {
+        float4x4 ReprojectToPrevious;  // View space to last frame's clip space
+        float2 ProjectionScale;        // _11 and _22 of the projection
+        float DepthScale;              // _43
+        float DepthOffset;             // _33
+        uint2 FullSize;
+        uint2 LowSize;
+        float Radius;
+        float Intensity;
+        uint SampleCount;
+        uint Frame;
+        float Bias;
+        float BlendWeight;
+        uint Divisor;
+        float Padding;
+    };
+
+    // Beyond the range of the half-float history, cleared depth lands here
+    #define SKY_DEPTH 60000.0f
+
+    float LinearDepth(float depth)
+    {
+        return depth >= 1.0f ? 65000.0f : DepthScale / (depth - DepthOffset);
+    }
+
+    // pixel in full-resolution pixels
+    float3 ViewPosition(float2 pixel, float z)
+    {
+        float2 ndc = pixel / float2(FullSize) * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+        return float3(ndc / ProjectionScale * z, z);
+    }
+)";
+
+// Reduces depth to linear view depth at low resolution, alternating the nearest and farthest
+// sample of each block in a checkerboard, and derives the normal from the full-resolution
+// neighbours of the chosen sample
+const char* DOWNSAMPLE_SHADER = R"(
+    Texture2D<float> Depth : register(t0);
+    RWTexture2D<float> LowDepth : register(u0);
+    RWTexture2D<float4> LowNormal : register(u1);
+
+    float LoadDepth(int2 p)
+    {
+        return LinearDepth(Depth.Load(int3(clamp(p, int2(0, 0), int2(FullSize) - 1), 0)));
+    }
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= LowSize)) return;
+
+        bool nearest = ((id.x ^ id.y) & 1) == 0;
+        int2 base = int2(id.xy * Divisor);
+        int2 pick = base;
+        float z = LoadDepth(base);
+        for (uint y = 0; y < Divisor; ++y) {
+            for (uint x = 0; x < Divisor; ++x) {
+                int2 p = base + int2(x, y);
+                float candidate = LoadDepth(p);
+                if (nearest ? candidate < z : candidate > z) {
+                    z = candidate;
+                    pick = p;
+                }
+            }
+        }
+        LowDepth[id.xy] = z;
+        if (z >= SKY_DEPTH) {
+            LowNormal[id.xy] = float4(0.5f, 0.5f, 0.0f, 0.0f);
+            return;
+        }
+
+        // Difference towards whichever neighbour is on the same surface, so edges keep their normals
+        float2 pixel = float2(pick) + 0.5f;
+        float3 center = ViewPosition(pixel, z);
+        float3 left = ViewPosition(pixel - float2(1.0f, 0.0f), LoadDepth(pick - int2(1, 0)));
+        float3 right = ViewPosition(pixel + float2(1.0f, 0.0f), LoadDepth(pick + int2(1, 0)));
+        float3 up = ViewPosition(pixel - float2(0.0f, 1.0f), LoadDepth(pick - int2(0, 1)));
+        float3 down = ViewPosition(pixel + float2(0.0f, 1.0f), LoadDepth(pick + int2(0, 1)));
+        float3 dx = abs(right.z - z) < abs(z - left.z) ? right - center : center - left;
+        float3 dy = abs(down.z - z) < abs(z - up.z) ? down - center : center - up;
+        float3 normal = normalize(cross(dx, dy));
+        if (dot(normal, center) > 0.0f) normal = -normal;
+        LowNormal[id.xy] = float4(normal * 0.5f + 0.5f, 0.0f);
+    }
+)";
+
+// Hemisphere occlusion at low resolution. The sample spiral is rotated per pixel and per frame
+// so the temporal pass can average a different set of directions every frame
+const char* OCCLUSION_SHADER = R"(
+    Texture2D<float> LowDepth : register(t0);
+    Texture2D<float4> LowNormal : register(t1);
+    RWTexture2D<float> Occlusion : register(u0);
+
+    #define GOLDEN_ANGLE 2.39996323f
+    #define TWO_PI 6.28318531f
+
+    // Jimenez 2014
+    float InterleavedGradientNoise(float2 p)
+    {
+        return frac(52.9829189f * frac(dot(p, float2(0.06711056f, 0.00583715f))));
+    }
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= LowSize)) return;
+
+        float z = LowDepth.Load(int3(id.xy, 0));
+        if (z >= SKY_DEPTH) {
+            Occlusion[id.xy] = 1.0f;
+            return;
+        }
+
+        float3 position = ViewPosition((float2(id.xy) + 0.5f) * Divisor, z);
+        float3 normal = normalize(LowNormal.Load(int3(id.xy, 0)).xyz * 2.0f - 1.0f);
+        float3 tangent = normalize(cross(normal, abs(normal.y) < 0.99f ? float3(0.0f, 1.0f, 0.0f) : float3(1.0f, 0.0f, 0.0f)));
+        float3 bitangent = cross(normal, tangent);
+
+        float noise = InterleavedGradientNoise(float2(id.xy) + 5.588238f * float(Frame % 64));
+        float rotation = noise * TWO_PI;
+        float occlusion = 0.0f;
+        for (uint i = 0; i < SampleCount; ++i) {
+            // Cosine-weighted directions, with sample distances spread towards the center
+            float u = (float(i) + 0.5f) / float(SampleCount);
+            float angle = float(i) * GOLDEN_ANGLE + rotation;
+            float r = sqrt(u);
+            float3 direction = tangent * (cos(angle) * r) + bitangent * (sin(angle) * r) + normal * sqrt(1.0f - u);
+            float reach = frac(u * 7.0f + noise);
+            float3 samplePoint = position + direction * (Radius * lerp(0.1f, 1.0f, reach * reach));
+            if (samplePoint.z <= 0.0f) continue;
+
+            float2 uv = samplePoint.xy * ProjectionScale / samplePoint.z * float2(0.5f, -0.5f) + 0.5f;
+            if (any(uv < 0.0f) || any(uv >= 1.0f)) continue;
+            float sceneZ = LowDepth.Load(int3(uv * float2(LowSize), 0));
+
+            // Surfaces far in front of the sample are separate objects and only partly occlude
+            float range = saturate(Radius / max(abs(z - sceneZ), 1e-4f));
+            occlusion += sceneZ < samplePoint.z - Bias * z ? range * range : 0.0f;
+        }
+        Occlusion[id.xy] = pow(saturate(1.0f - occlusion / float(SampleCount)), Intensity);
+    }
+)";
+
+// Blends this frame's occlusion into the reprojected history. History is clamped to the range
+// of the 3x3 neighbourhood, read once per group into groupshared memory, and is rejected where
+// the depth stored with it does not match where the surface was last frame
+const char* TEMPORAL_SHADER = R"(
+    Texture2D<float> Occlusion : register(t0);
+    Texture2D<float> LowDepth : register(t1);
+    Texture2D<float2> History : register(t2);
+    SamplerState LinearClamp : register(s0);
+    RWTexture2D<float2> Accumulated : register(u0);
+
+    #define TILE 8
+    #define FOOTPRINT (TILE + 2)
+    groupshared float Tile[FOOTPRINT * FOOTPRINT];
+
+    [numthreads(TILE, TILE, 1)]
+    void main(uint3 groupId : SV_GroupID, uint3 local : SV_GroupThreadID, uint index : SV_GroupIndex)
+    {
+        int2 origin = int2(groupId.xy) * TILE - 1;
+        for (uint i = index; i < FOOTPRINT * FOOTPRINT; i += TILE * TILE) {
+            int2 texel = clamp(origin + int2(i % FOOTPRINT, i / FOOTPRINT), int2(0, 0), int2(LowSize) - 1);
+            Tile[i] = Occlusion.Load(int3(texel, 0));
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        uint2 id = groupId.xy * TILE + local.xy;
+        if (any(id >= LowSize)) return;
+
+        int center = (local.y + 1) * FOOTPRINT + local.x + 1;
+        float current = Tile[center];
+        float low = current;
+        float high = current;
+        [unroll] for (int y = -1; y <= 1; ++y) {
+            [unroll] for (int x = -1; x <= 1; ++x) {
+                float neighbour = Tile[center + y * FOOTPRINT + x];
+                low = min(low, neighbour);
+                high = max(high, neighbour);
+            }
+        }
+
+        float z = LowDepth.Load(int3(id, 0));
+        float result = current;
+        if (BlendWeight < 1.0f && z < SKY_DEPTH) {
+            float4 previous = mul(float4(ViewPosition((float2(id) + 0.5f) * Divisor, z), 1.0f), ReprojectToPrevious);
+            float2 uv = previous.xy / previous.w * float2(0.5f, -0.5f) + 0.5f;
+            if (previous.w > 0.0f && all(uv >= 0.0f) && all(uv <= 1.0f)) {
+                // previous.w is the point's view depth last frame
+                float2 history = History.SampleLevel(LinearClamp, uv, 0);
+                if (abs(history.y - previous.w) < 0.05f * previous.w) {
+                    result = lerp(clamp(history.x, low, high), current, BlendWeight);
+                }
+            }
+        }
+        Accumulated[id] = float2(result, z);
+    }
+)";
+
+// Bilateral upsample: bilinear weights of the four nearest low-resolution texels, scaled down
+// by how far their depth is from this pixel's
+const char* UPSAMPLE_SHADER = R"(
+    Texture2D<float> Depth : register(t0);
+    Texture2D<float2> Accumulated : register(t1);
+    RWTexture2D<float> Visibility : register(u0);
+
+    #define DEPTH_SIGMA 0.02f
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= FullSize)) return;
+
+        float z = LinearDepth(Depth.Load(int3(id.xy, 0)));
+        if (z >= SKY_DEPTH) {
+            Visibility[id.xy] = 1.0f;
+            return;
+        }
+
+        float2 position = (float2(id.xy) + 0.5f) / float(Divisor) - 0.5f;
+        int2 base = int2(floor(position));
+        float2 f = position - float2(base);
+        float sum = 0.0f;
+        float weights = 0.0f;
+        float closest = 1.0f;
+        float closestDelta = 1e30f;
+        [unroll] for (int i = 0; i < 4; ++i) {
+            int2 offset = int2(i & 1, i >> 1);
+            float2 tap = Accumulated.Load(int3(clamp(base + offset, int2(0, 0), int2(LowSize) - 1), 0));
+            float2 bilinear = lerp(1.0f - f, f, float2(offset));
+            float depthDelta = abs(tap.y - z);
+            float weight = bilinear.x * bilinear.y * exp(-depthDelta / (DEPTH_SIGMA * z));
+            sum += tap.x * weight;
+            weights += weight;
+            if (depthDelta < closestDelta) {
+                closestDelta = depthDelta;
+                closest = tap.x;
+            }
+        }
+        // No tap on this surface, e.g. thin geometry lost in the downsample
+        Visibility[id.xy] = weights > 1e-4f ? sum / weights : closest;
+    }
+)";
+
+// Matches SSAOConstants above
+struct GpuSSAOConstants {
+    DirectX::XMFLOAT4X4 reprojectToPrevious;
+    float projectionScale[2];
+    float depthScale;
+    float depthOffset;
+    UINT fullSize[2];
+    UINT lowSize[2];
+    float radius;
+    float intensity;
+    UINT sampleCount;
+    UINT frame;
+    float bias;
+    float blendWeight;
+    UINT divisor;
+    float padding;
+};
+
+constexpr UINT GROUP_SIZE = 8;
+constexpr UINT MAX_SAMPLES = 32;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3D11ComputeShader* CompileComputeShader(ID3D11Device* device, const char* source, const char* name) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(std::string(COMMON_SOURCE) + source, name, "main", "cs_5_0", 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+
+    ID3D11ComputeShader* shader = nullptr;
+    hr = device->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &shader);
+    blob->Release();
+    return SUCCEEDED(hr) ? shader : nullptr;
+}
+
+bool CreateTarget(ID3D11Device* device, UINT width, UINT height, DXGI_FORMAT format, ID3D11Texture2D** texture,
+                  ID3D11ShaderResourceView** view, ID3D11UnorderedAccessView** target) {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, texture))) return false;
+    if (FAILED(device->CreateShaderResourceView(*texture, nullptr, view))) return false;
+    return SUCCEEDED(device->CreateUnorderedAccessView(*texture, nullptr, target));
+}
+
+} // namespace
+
+SSAORenderer::SSAORenderer()
+    : device_(nullptr)
+    , context_(nullptr)
+    , width_(0)
+    , height_(0)
+    , lowWidth_(0)
+    , lowHeight_(0)
+    , downsampleShader_(nullptr)
+    , occlusionShader_(nullptr)
+    , temporalShader_(nullptr)
+    , upsampleShader_(nullptr)
+    , constants_(nullptr)
+    , linearClamp_(nullptr)
+    , lowDepth_(nullptr)
+    , lowDepthView_(nullptr)
+    , lowDepthTarget_(nullptr)
+    , lowNormal_(nullptr)
+    , lowNormalView_(nullptr)
+    , lowNormalTarget_(nullptr)
+    , rawOcclusion_(nullptr)
+    , rawOcclusionView_(nullptr)
+    , rawOcclusionTarget_(nullptr)
+    , history_{}
+    , historyViews_{}
+    , historyTargets_{}
+    , historyIndex_(0)
+    , historyValid_(false)
+    , output_(nullptr)
+    , outputView_(nullptr)
+    , outputTarget_(nullptr)
+    , frame_(0)
+{
+    DirectX::XMStoreFloat4x4(&previousViewProjection_, DirectX::XMMatrixIdentity());
+}
+
+SSAORenderer::~SSAORenderer() {
+    Shutdown();
+}
+
+bool SSAORenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height,
+                              const Settings& settings) {
+    Shutdown();
+    if (!device || !context || width == 0 || height == 0) return false;
+
+    device_ = device;
+    context_ = context;
+    width_ = width;
+    height_ = height;
+    settings_ = settings;
+    settings_.resolutionDivisor = settings_.resolutionDivisor >= 4 ? 4 : (settings_.resolutionDivisor >= 2 ? 2 : 1);
+    settings_.sampleCount = std::clamp(settings_.sampleCount, 1u, MAX_SAMPLES);
+    lowWidth_ = std::max(1u, (width + settings_.resolutionDivisor - 1) / settings_.resolutionDivisor);
+    lowHeight_ = std::max(1u, (height + settings_.resolutionDivisor - 1) / settings_.resolutionDivisor);
+
+    if (!CreateShaders() || !CreateTargets()) {
+        Logger::Error("Failed to create SSAO resources");
+        Shutdown();
+        return false;
+    }
+    Logger::Info("SSAO initialized: " + std::to_string(lowWidth_) + "x" + std::to_string(lowHeight_) + ", " +
+                 std::to_string(settings_.sampleCount) + " samples");
+    return true;
+}
+
+void SSAORenderer::Shutdown() {
+    SafeRelease(downsampleShader_);
+    SafeRelease(occlusionShader_);
+    SafeRelease(temporalShader_);
+    SafeRelease(upsampleShader_);
+    SafeRelease(constants_);
+    SafeRelease(linearClamp_);
+    SafeRelease(lowDepthTarget_);
+    SafeRelease(lowDepthView_);
+    SafeRelease(lowDepth_);
+    SafeRelease(lowNormalTarget_);
+    SafeRelease(lowNormalView_);
+    SafeRelease(lowNormal_);
+    SafeRelease(rawOcclusionTarget_);
+    SafeRelease(rawOcclusionView_);
+    SafeRelease(rawOcclusion_);
+    for (UINT i = 0; i < 2; ++i) {
+        SafeRelease(historyTargets_[i]);
+        SafeRelease(historyViews_[i]);
+        SafeRelease(history_[i]);
+    }
+    SafeRelease(outputTarget_);
+    SafeRelease(outputView_);
+    SafeRelease(output_);
+    historyValid_ = false;
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+bool SSAORenderer::CreateShaders() {
+    downsampleShader_ = CompileComputeShader(device_, DOWNSAMPLE_SHADER, "SSAODownsample");
+    occlusionShader_ = CompileComputeShader(device_, OCCLUSION_SHADER, "SSAOOcclusion");
+    temporalShader_ = CompileComputeShader(device_, TEMPORAL_SHADER, "SSAOTemporal");
+    upsampleShader_ = CompileComputeShader(device_, UPSAMPLE_SHADER, "SSAOUpsample");
+    if (!downsampleShader_ || !occlusionShader_ || !temporalShader_ || !upsampleShader_) return false;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = sizeof(GpuSSAOConstants);
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&desc, nullptr, &constants_))) return false;
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    return SUCCEEDED(device_->CreateSamplerState(&samplerDesc, &linearClamp_));
+}
+
+bool SSAORenderer::CreateTargets() {
+    // History keeps its depth in half precision next to the occlusion, enough for the 5% test
+    return CreateTarget(device_, lowWidth_, lowHeight_, DXGI_FORMAT_R32_FLOAT, &lowDepth_, &lowDepthView_, &lowDepthTarget_) &&
+           CreateTarget(device_, lowWidth_, lowHeight_, DXGI_FORMAT_R8G8B8A8_UNORM, &lowNormal_, &lowNormalView_, &lowNormalTarget_) &&
+           CreateTarget(device_, lowWidth_, lowHeight_, DXGI_FORMAT_R8_UNORM, &rawOcclusion_, &rawOcclusionView_, &rawOcclusionTarget_) &&
+           CreateTarget(device_, lowWidth_, lowHeight_, DXGI_FORMAT_R16G16_FLOAT, &history_[0], &historyViews_[0], &historyTargets_[0]) &&
+           CreateTarget(device_, lowWidth_, lowHeight_, DXGI_FORMAT_R16G16_FLOAT, &history_[1], &historyViews_[1], &historyTargets_[1]) &&
+           CreateTarget(device_, width_, height_, DXGI_FORMAT_R8_UNORM, &output_, &outputView_, &outputTarget_);
+}
+
+void SSAORenderer::Dispatch(ID3D11ComputeShader* shader, ID3D11ShaderResourceView* const* views, UINT viewCount,
+                            ID3D11UnorderedAccessView* const* targets, UINT targetCount, UINT width, UINT height) {
+    context_->CSSetShader(shader, nullptr, 0);
+    context_->CSSetShaderResources(0, viewCount, views);
+    context_->CSSetUnorderedAccessViews(0, targetCount, targets, nullptr);
+    context_->Dispatch((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+    // Unbind before the outputs become the next pass's inputs
+    ID3D11ShaderResourceView* nullViews[3] = {};
+    ID3D11UnorderedAccessView* nullTargets[2] = {};
+    context_->CSSetShaderResources(0, viewCount, nullViews);
+    context_->CSSetUnorderedAccessViews(0, targetCount, nullTargets, nullptr);
+}
+
+void SSAORenderer::Render(ID3D11ShaderResourceView* depth, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection) {
+    if (!device_ || !depth) return;
+    NEXUS_PROFILE_SCOPE("SSAORenderer::Render");
+
+    DirectX::XMFLOAT4X4 projectionValues;
+    DirectX::XMStoreFloat4x4(&projectionValues, projection);
+    DirectX::XMMATRIX reproject = DirectX::XMMatrixInverse(nullptr, view) * DirectX::XMLoadFloat4x4(&previousViewProjection_);
+
+    GpuSSAOConstants constants = {};
+    DirectX::XMStoreFloat4x4(&constants.reprojectToPrevious, DirectX::XMMatrixTranspose(reproject));
+    constants.projectionScale[0] = projectionValues._11;
+    constants.projectionScale[1] = projectionValues._22;
+    constants.depthScale = projectionValues._43;
+    constants.depthOffset = projectionValues._33;
+    constants.fullSize[0] = width_;
+    constants.fullSize[1] = height_;
+    constants.lowSize[0] = lowWidth_;
+    constants.lowSize[1] = lowHeight_;
+    constants.radius = std::max(settings_.radius, 1e-3f);
+    constants.intensity = std::max(settings_.intensity, 0.0f);
+    constants.sampleCount = settings_.sampleCount;
+    constants.frame = frame_++;
+    constants.bias = std::max(settings_.bias, 0.0f);
+    constants.blendWeight = historyValid_ ? std::clamp(settings_.temporalBlend, 0.01f, 1.0f) : 1.0f;
+    constants.divisor = settings_.resolutionDivisor;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+
+    context_->CSSetConstantBuffers(0, 1, &constants_);
+    context_->CSSetSamplers(0, 1, &linearClamp_);
+
+    ID3D11ShaderResourceView* downsampleViews[1] = { depth };
+    ID3D11UnorderedAccessView* downsampleTargets[2] = { lowDepthTarget_, lowNormalTarget_ };
+    Dispatch(downsampleShader_, downsampleViews, 1, downsampleTargets, 2, lowWidth_, lowHeight_);
+
+    ID3D11ShaderResourceView* occlusionViews[2] = { lowDepthView_, lowNormalView_ };
+    Dispatch(occlusionShader_, occlusionViews, 2, &rawOcclusionTarget_, 1, lowWidth_, lowHeight_);
+
+    const UINT next = historyIndex_ ^ 1;
+    ID3D11ShaderResourceView* temporalViews[3] = { rawOcclusionView_, lowDepthView_, historyViews_[historyIndex_] };
+    Dispatch(temporalShader_, temporalViews, 3, &historyTargets_[next], 1, lowWidth_, lowHeight_);
+    historyIndex_ = next;
+
+    ID3D11ShaderResourceView* upsampleViews[2] = { depth, historyViews_[historyIndex_] };
+    Dispatch(upsampleShader_, upsampleViews, 2, &outputTarget_, 1, width_, height_);
+
+    context_->CSSetShader(nullptr, nullptr, 0);
+    DirectX::XMStoreFloat4x4(&previousViewProjection_, view * projection);
+    historyValid_ = true;
+}
+
+} // namespace Nexus
@@ -0,0 +1,269 @@
+#include "SceneBVH.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+constexpr uint32_t EMPTY_SLOT = ~0u;   // Unused child slot, its bounds are inverted so it always culls
+
+AABB EmptyBounds() {
+    return {{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+}
+
+void Grow(AABB& bounds, const AABB& box) {
+    bounds.min.x = std::min(bounds.min.x, box.min.x);
+    bounds.min.y = std::min(bounds.min.y, box.min.y);
+    bounds.min.z = std::min(bounds.min.z, box.min.z);
+    bounds.max.x = std::max(bounds.max.x, box.max.x);
+    bounds.max.y = std::max(bounds.max.y, box.max.y);
+    bounds.max.z = std::max(bounds.max.z, box.max.z);
+}
+}
+
+Frustum Frustum::FromViewProjection(FXMMATRIX viewProjection) {
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, viewProjection);
+
+    // Gribb/Hartmann: clip-space conditions expressed as columns of the row-vector matrix
+    Frustum frustum;
+    frustum.planes[Left]   = XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);
+    frustum.planes[Right]  = XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);
+    frustum.planes[Bottom] = XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);
+    frustum.planes[Top]    = XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);
+    frustum.planes[Near]   = XMFLOAT4(m._13, m._23, m._33, m._43);
+    frustum.planes[Far]    = XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);
+
+    for (XMFLOAT4& plane : frustum.planes) {
+        XMStoreFloat4(&plane, XMPlaneNormalize(XMLoadFloat4(&plane)));
+    }
+    return frustum;
+}
+
+bool Frustum::Intersects(const AABB& box) const {
+    XMVECTOR boxMin = XMLoadFloat3(&box.min);
+    XMVECTOR boxMax = XMLoadFloat3(&box.max);
+    XMVECTOR center = XMVectorScale(XMVectorAdd(boxMin, boxMax), 0.5f);
+    XMVECTOR extents = XMVectorScale(XMVectorSubtract(boxMax, boxMin), 0.5f);
+
+    for (const XMFLOAT4& p : planes) {
+        XMVECTOR plane = XMLoadFloat4(&p);
+        // Signed distance of the corner furthest along the plane normal
+        float distance = XMVectorGetX(XMVector3Dot(plane, center)) + p.w +
+                         XMVectorGetX(XMVector3Dot(XMVectorAbs(plane), extents));
+        if (distance < 0.0f) return false;
+    }
+    return true;
+}
+
+SceneBVH::SceneBVH() {
+}
+
+void SceneBVH::Clear() {
+    nodes_.clear();
+    items_.clear();
+    boxes_.clear();
+    centers_.clear();
+}
+
+void SceneBVH::Build(const AABB* boxes, size_t count) {
+    NEXUS_PROFILE_SCOPE("SceneBVH::Build");
+    Clear();
+    if (!boxes || count == 0) return;
+
+    boxes_.assign(boxes, boxes + count);
+    centers_.resize(count);
+    items_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const AABB& box = boxes_[i];
+        centers_[i] = XMFLOAT3((box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f);
+        items_[i] = static_cast<uint32_t>(i);
+    }
+
+    // Each node splits into up to four children, so this is a generous upper bound
+    nodes_.reserve(count / 2 + 1);
+    BuildNode(0, static_cast<uint32_t>(count));
+}
+
+uint32_t SceneBVH::BuildNode(uint32_t first, uint32_t count) {
+    uint32_t nodeIndex = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+
+    // Median split on the longest centroid axis
+    auto split = [this](uint32_t begin, uint32_t size) {
+        XMFLOAT3 lo(FLT_MAX, FLT_MAX, FLT_MAX);
+        XMFLOAT3 hi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (uint32_t i = begin; i < begin + size; ++i) {
+            const XMFLOAT3& c = centers_[items_[i]];
+            lo.x = std::min(lo.x, c.x); lo.y = std::min(lo.y, c.y); lo.z = std::min(lo.z, c.z);
+            hi.x = std::max(hi.x, c.x); hi.y = std::max(hi.y, c.y); hi.z = std::max(hi.z, c.z);
+        }
+        float ex = hi.x - lo.x, ey = hi.y - lo.y, ez = hi.z - lo.z;
+        int axis = (ex >= ey && ex >= ez) ? 0 : (ey >= ez ? 1 : 2);
+
+        uint32_t half = size / 2;
+        auto key = [this, axis](uint32_t item) {
+            const XMFLOAT3& c = centers_[item];
+            return axis == 0 ? c.x : (axis == 1 ? c.y : c.z);
+        };
+        std::nth_element(items_.begin() + begin, items_.begin() + begin + half, items_.begin() + begin + size,
+                         [&key](uint32_t a, uint32_t b) { return key(a) < key(b); });
+        return half;
+    };
+
+    // Two levels of binary splits give the four children
+    uint32_t ranges[4][2] = {};
+    int rangeCount = 0;
+    if (count <= LEAF_SIZE) {
+        ranges[rangeCount][0] = first; ranges[rangeCount][1] = count; ++rangeCount;
+    } else {
+        uint32_t left = split(first, count);
+        uint32_t halves[2][2] = {{first, left}, {first + left, count - left}};
+        for (const auto& half : halves) {
+            if (half[1] <= LEAF_SIZE) {
+                ranges[rangeCount][0] = half[0]; ranges[rangeCount][1] = half[1]; ++rangeCount;
+                continue;
+            }
+            uint32_t quarter = split(half[0], half[1]);
+            ranges[rangeCount][0] = half[0]; ranges[rangeCount][1] = quarter; ++rangeCount;
+            ranges[rangeCount][0] = half[0] + quarter; ranges[rangeCount][1] = half[1] - quarter; ++rangeCount;
+        }
+    }
+
+    for (int slot = 0; slot < 4; ++slot) {
+        if (slot < rangeCount) {
+            SetChild(nodes_[nodeIndex], slot, ranges[slot][0], ranges[slot][1]);
+        } else {
+            Node& node = nodes_[nodeIndex];
+            node.minX[slot] = node.minY[slot] = node.minZ[slot] = FLT_MAX;
+            node.maxX[slot] = node.maxY[slot] = node.maxZ[slot] = -FLT_MAX;
+            node.child[slot] = EMPTY_SLOT;
+            node.count[slot] = 0;
+        }
+    }
+
+    // Recurse after the slot bounds are written; nodes_ may reallocate while building children
+    for (int slot = 0; slot < rangeCount; ++slot) {
+        if (ranges[slot][1] > LEAF_SIZE) {
+            uint32_t child = BuildNode(ranges[slot][0], ranges[slot][1]);
+            nodes_[nodeIndex].child[slot] = child;
+            nodes_[nodeIndex].count[slot] = 0;
+        }
+    }
+    return nodeIndex;
+}
+
+void SceneBVH::SetChild(Node& node, int slot, uint32_t first, uint32_t count) {
+    AABB bounds = EmptyBounds();
+    for (uint32_t i = first; i < first + count; ++i) {
+        Grow(bounds, boxes_[items_[i]]);
+    }
+    node.minX[slot] = bounds.min.x; node.minY[slot] = bounds.min.y; node.minZ[slot] = bounds.min.z;
+    node.maxX[slot] = bounds.max.x; node.maxY[slot] = bounds.max.y; node.maxZ[slot] = bounds.max.z;
+    node.child[slot] = first;
+    node.count[slot] = count;
+}
+
+void SceneBVH::AppendSubtree(uint32_t child, uint32_t count, std::vector<uint32_t>& visible) const {
+    if (count > 0) {
+        visible.insert(visible.end(), items_.begin() + child, items_.begin() + child + count);
+        return;
+    }
+    const Node& node = nodes_[child];
+    for (int slot = 0; slot < 4; ++slot) {
+        if (node.child[slot] != EMPTY_SLOT) {
+            AppendSubtree(node.child[slot], node.count[slot], visible);
+        }
+    }
+}
+
+void SceneBVH::Query(const Frustum& frustum, std::vector<uint32_t>& visible) {
+    NEXUS_PROFILE_SCOPE("SceneBVH::Query");
+    stats_ = Stats();
+    stats_.tested = static_cast<uint32_t>(items_.size());
+    if (nodes_.empty()) return;
+
+    const size_t firstVisible = visible.size();
+
+    // Splat each plane once; the sign masks pick the nearest/furthest box corner per axis
+    XMVECTOR planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT];
+    XMVECTOR planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    XMVECTOR positiveX[Frustum::PLANE_COUNT], positiveY[Frustum::PLANE_COUNT], positiveZ[Frustum::PLANE_COUNT];
+    const XMVECTOR zero = XMVectorZero();
+    for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        const XMFLOAT4& plane = frustum.planes[p];
+        planeX[p] = XMVectorReplicate(plane.x);
+        planeY[p] = XMVectorReplicate(plane.y);
+        planeZ[p] = XMVectorReplicate(plane.z);
+        planeW[p] = XMVectorReplicate(plane.w);
+        positiveX[p] = XMVectorGreaterOrEqual(planeX[p], zero);
+        positiveY[p] = XMVectorGreaterOrEqual(planeY[p], zero);
+        positiveZ[p] = XMVectorGreaterOrEqual(planeZ[p], zero);
+    }
+
+    stack_.clear();
+    stack_.push_back(0);
+    while (!stack_.empty()) {
+        const Node& node = nodes_[stack_.back()];
+        stack_.pop_back();
+        stats_.nodesVisited++;
+
+        XMVECTOR minX = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(node.minX));
+        XMVECTOR minY = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(node.minY));
+        XMVECTOR minZ = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(node.minZ));
+        XMVECTOR maxX = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(node.maxX));
+        XMVECTOR maxY = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(node.maxY));
+        XMVECTOR maxZ = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(node.maxZ));
+
+        XMVECTOR outside = XMVectorFalseInt();
+        XMVECTOR straddling = XMVectorFalseInt();
+        for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            // Corner furthest along the normal behind the plane: out. Nearest one behind: straddling.
+            XMVECTOR farX = XMVectorSelect(minX, maxX, positiveX[p]);
+            XMVECTOR farY = XMVectorSelect(minY, maxY, positiveY[p]);
+            XMVECTOR farZ = XMVectorSelect(minZ, maxZ, positiveZ[p]);
+            XMVECTOR nearX = XMVectorSelect(maxX, minX, positiveX[p]);
+            XMVECTOR nearY = XMVectorSelect(maxY, minY, positiveY[p]);
+            XMVECTOR nearZ = XMVectorSelect(maxZ, minZ, positiveZ[p]);
+
+            XMVECTOR farDistance = XMVectorMultiplyAdd(farX, planeX[p],
+                                   XMVectorMultiplyAdd(farY, planeY[p],
+                                   XMVectorMultiplyAdd(farZ, planeZ[p], planeW[p])));
+            XMVECTOR nearDistance = XMVectorMultiplyAdd(nearX, planeX[p],
+                                    XMVectorMultiplyAdd(nearY, planeY[p],
+                                    XMVectorMultiplyAdd(nearZ, planeZ[p], planeW[p])));
+            outside = XMVectorOrInt(outside, XMVectorLess(farDistance, zero));
+            straddling = XMVectorOrInt(straddling, XMVectorLess(nearDistance, zero));
+        }
+
+        uint32_t outsideMask[4], straddlingMask[4];
+        XMStoreInt4(outsideMask, outside);
+        XMStoreInt4(straddlingMask, straddling);
+
+        for (int slot = 0; slot < 4; ++slot) {
+            if (node.child[slot] == EMPTY_SLOT || outsideMask[slot]) continue;
+
+            if (!straddlingMask[slot]) {
+                AppendSubtree(node.child[slot], node.count[slot], visible);
+            } else if (node.count[slot] > 0) {
+                // Leaf on the boundary: test its objects individually
+                for (uint32_t i = node.child[slot]; i < node.child[slot] + node.count[slot]; ++i) {
+                    if (frustum.Intersects(boxes_[items_[i]])) {
+                        visible.push_back(items_[i]);
+                    }
+                }
+            } else {
+                stack_.push_back(node.child[slot]);
+            }
+        }
+    }
+
+    stats_.visible = static_cast<uint32_t>(visible.size() - firstVisible);
+    stats_.culled = stats_.tested - stats_.visible;
+}
+
+} // namespace Nexus
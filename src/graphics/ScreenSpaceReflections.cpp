@@ -0,0 +1,733 @@
+#include "ScreenSpaceReflections.h"
+#include "DeferredRenderer.h"
+#include "Logger.h"
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+#include "ProbeVolume.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// Shared by every pass. Depth linearization and view position reconstruction assume a
+// symmetric perspective projection, as SSAORenderer and DeferredRenderer do
+const char* COMMON_SOURCE = R"(
+    cbuffer SSRConstants : register(b0)
+    {
+        float4x4 View;
+        float4x4 InverseView;
+        float4x4 ViewToPrevious;       // View space to last frame's clip space
+        float2 ProjectionScale;        // _11 and _22 of the projection
+        float DepthScale;              // _43
+        float DepthOffset;             // _33
+        uint2 FullSize;
+        uint2 LowSize;
+        float2 HiZSize;                // Mip 0 of the pyramid as built
+        uint HiZLevels;                // Zero without a pyramid
+        uint MaxSteps;
+        float3 AmbientLight;
+        float MaxDistance;
+        float Thickness;
+        float MaxRoughness;
+        float EdgeFade;
+        float BlendWeight;
+        float Gamma;
+        uint Frame;
+        uint HasScene;
+        uint ColorLevels;
+    };
+
+    // Beyond the range of the half-float history, cleared depth lands here
+    #define SKY_DEPTH 60000.0f
+
+    float LinearDepth(float depth)
+    {
+        return depth >= 1.0f ? 65000.0f : DepthScale / (depth - DepthOffset);
+    }
+
+    // pixel in full-resolution pixels
+    float3 ViewPosition(float2 pixel, float z)
+    {
+        float2 ndc = pixel / float2(FullSize) * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+        return float3(ndc / ProjectionScale * z, z);
+    }
+
+    // Texture coordinates and hardware depth of a view-space point
+    float3 ScreenPoint(float3 position)
+    {
+        return float3(position.xy * ProjectionScale / position.z * float2(0.5f, -0.5f) + 0.5f,
+                      DepthOffset + DepthScale / position.z);
+    }
+
+    float3 DecodeNormal(float2 encoded)
+    {
+        float3 n = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+        float t = saturate(-n.z);
+        n.xy += n.xy >= 0.0f ? -t : t;
+        return normalize(n);
+    }
+)";
+
+// Brings the last lit frame to half resolution, undoing DeferredRenderer's gamma and tonemap so
+// reflections add up in linear light
+const char* COLOR_SHADER = R"(
+    Texture2D<float4> PreviousScene : register(t0);
+    SamplerState LinearClamp : register(s0);
+    RWTexture2D<float4> Color : register(u0);
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= LowSize)) return;
+
+        // One bilinear tap in the middle of the 2x2 block averages it
+        float3 encoded = PreviousScene.SampleLevel(LinearClamp, (float2(id.xy) + 0.5f) / float2(LowSize), 0).rgb;
+        float3 tonemapped = min(pow(saturate(encoded), Gamma), 0.98f);
+        Color[id.xy] = float4(tonemapped / (1.0f - tonemapped), 1.0f);
+    }
+)";
+
+const char* COLOR_MIP_SHADER = R"(
+    cbuffer MipConstants : register(b1)
+    {
+        uint2 DestinationSize;
+        uint2 MipPadding;
+    };
+
+    Texture2D<float4> Source : register(t0);
+    SamplerState LinearClamp : register(s0);
+    RWTexture2D<float4> Destination : register(u0);
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= DestinationSize)) return;
+        Destination[id.xy] = Source.SampleLevel(LinearClamp, (float2(id.xy) + 0.5f) / float2(DestinationSize), 0);
+    }
+)";
+
+// One ray per half-resolution pixel through the Hi-Z pyramid, in texture coordinates and
+// hardware depth, both linear along the ray on screen. The probe volume's shader source goes in
+// front of this one
+const char* TRACE_SHADER = R"(
+    Texture2D<float> Depth : register(t0);
+    Texture2D<float2> Normals : register(t1);
+    Texture2D<float4> Material : register(t2);
+    Texture2D<float2> HiZ : register(t3);
+    Texture2D<float4> Color : register(t4);
+    SamplerState LinearClamp : register(s0);
+    RWTexture2D<float4> Raw : register(u0);
+
+    float2 HiZLevelSize(int level)
+    {
+        return max(floor(HiZSize / exp2(float(level))), 1.0f);
+    }
+
+    // Ray parameter just past the edge of cell that the ray leaves it through
+    float CellExit(float3 start, float3 direction, float2 cell, float2 size, float2 crossStep)
+    {
+        float2 boundary = (cell + crossStep) / size;
+        float2 t = abs(direction.xy) > 1e-7f ? (boundary - start.xy) / direction.xy : 1e30f;
+        return min(t.x, t.y);
+    }
+
+    // Level 0 is half resolution, so the depth buffer has the last word: a grazing ray can reach a
+    // neighbouring pixel's nearer depth while still in front of its own
+    bool InFrontOfPixel(float3 ray)
+    {
+        uint2 pixel = min(uint2(ray.xy * float2(FullSize)), FullSize - 1);
+        return ray.z < Depth.Load(int3(pixel, 0));
+    }
+
+    // A ray in front of the nearest depth of its cell skips to the cell's edge and climbs a level;
+    // one that reaches that depth inside the cell moves there and descends, hitting below level 0
+    bool HiZTrace(float3 start, float3 direction, float tEnd, out float t)
+    {
+        float2 crossStep = direction.xy >= 0.0f ? 1.001f : -0.001f;
+        int maxLevel = int(HiZLevels) - 1;
+        int level = 0;
+        t = CellExit(start, direction, floor(start.xy * HiZLevelSize(0)), HiZLevelSize(0), crossStep);
+
+        [loop] for (uint i = 0; i < MaxSteps && level >= 0 && t <= tEnd; ++i) {
+            float2 size = HiZLevelSize(level);
+            float3 ray = start + direction * t;
+            float2 cell = floor(ray.xy * size);
+            float nearest = HiZ.Load(int3(clamp(cell, 0.0f, size - 1.0f), level)).y;
+
+            float tSurface = t;
+            if (ray.z < nearest) {
+                tSurface = direction.z > 0.0f ? t + (nearest - ray.z) / direction.z : 1e30f;
+            }
+            float tExit = CellExit(start, direction, cell, size, crossStep);
+            if (tSurface > tExit) {
+                t = tExit;
+                level = min(level + 1, maxLevel);
+            } else if (level == 0 && InFrontOfPixel(start + direction * tSurface)) {
+                t = tExit;
+            } else {
+                t = tSurface;
+                --level;
+            }
+        }
+        return level < 0 && t <= tEnd;
+    }
+
+    float EdgeWeight(float2 uv)
+    {
+        float2 edge = min(uv, 1.0f - uv) / max(EdgeFade, 1e-3f);
+        return saturate(min(edge.x, edge.y));
+    }
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= LowSize)) return;
+
+        // A different sample of each 2x2 block every frame, for the temporal pass to gather
+        static const uint2 JITTER[4] = { uint2(0, 0), uint2(1, 1), uint2(1, 0), uint2(0, 1) };
+        uint2 pixel = min(id.xy * 2 + JITTER[Frame & 3], FullSize - 1);
+        float z = LinearDepth(Depth.Load(int3(pixel, 0)));
+        if (z >= SKY_DEPTH) {
+            Raw[id.xy] = float4(0.0f, 0.0f, 0.0f, SKY_DEPTH);
+            return;
+        }
+
+        float roughness = Material.Load(int3(pixel, 0)).r;
+        float3 position = ViewPosition(float2(pixel) + 0.5f, z);
+        float3 N = normalize(mul(DecodeNormal(Normals.Load(int3(pixel, 0))), (float3x3)View));
+        float3 R = reflect(normalize(position), N);
+
+        float3 worldPos = mul(float4(position, 1.0f), InverseView).xyz;
+        float3 fallback = ProbeEnabled ? SampleProbeIrradiance(worldPos, mul(R, (float3x3)InverseView)) : AmbientLight;
+
+        // Rays towards the camera mostly find back faces the screen doesn't hold
+        float weight = saturate((MaxRoughness - roughness) / (0.2f * MaxRoughness)) * saturate(1.0f + R.z * 2.0f);
+        float3 reflected = float3(0.0f, 0.0f, 0.0f);
+        if (HasScene && HiZLevels > 0 && weight > 0.0f) {
+            // Clipped to the near plane, which is where depth would cross zero
+            float nearZ = -DepthScale / DepthOffset;
+            float3 end = position + R * MaxDistance;
+            if (end.z < nearZ) end = position + R * ((nearZ * 1.01f - position.z) / R.z);
+            float3 start = ScreenPoint(position);
+            float3 direction = ScreenPoint(end) - start;
+
+            float2 tScreen = abs(direction.xy) > 1e-7f ? ((direction.xy >= 0.0f ? 1.0f : 0.0f) - start.xy) / direction.xy : 1e30f;
+            float tEnd = min(1.0f, min(tScreen.x, tScreen.y));
+
+            float t;
+            bool hit = HiZTrace(start, direction, tEnd, t);
+            float3 ray = start + direction * t;
+            uint2 hitPixel = min(uint2(ray.xy * float2(FullSize)), FullSize - 1);
+            float sceneZ = LinearDepth(Depth.Load(int3(hitPixel, 0)));
+
+            // Behind a surface by more than its thickness went under it; a back face isn't lit
+            hit = hit && sceneZ < SKY_DEPTH && LinearDepth(ray.z) - sceneZ < Thickness * sceneZ;
+            hit = hit && dot(mul(DecodeNormal(Normals.Load(int3(hitPixel, 0))), (float3x3)View), R) < 0.0f;
+
+            float4 previous = mul(float4(ViewPosition(ray.xy * float2(FullSize), sceneZ), 1.0f), ViewToPrevious);
+            float2 uv = previous.xy / previous.w * float2(0.5f, -0.5f) + 0.5f;
+            hit = hit && previous.w > 0.0f && all(uv >= 0.0f) && all(uv <= 1.0f);
+
+            if (hit) {
+                // Half-angle of the lobe through its Phong equivalent, widened to the hit distance
+                float a = max(roughness * roughness, 1e-3f);
+                float power = 2.0f / (a * a) - 2.0f;
+                float cosCone = pow(0.244f, 1.0f / (power + 1.0f));
+                float tanCone = sqrt(max(1.0f - cosCone * cosCone, 0.0f)) / cosCone;
+                float travelled = length((ray.xy - start.xy) * float2(LowSize));
+                float level = min(log2(max(2.0f * tanCone * travelled, 1.0f)), float(ColorLevels - 1));
+
+                reflected = Color.SampleLevel(LinearClamp, uv, level).rgb;
+                weight *= EdgeWeight(ray.xy) * EdgeWeight(uv) * saturate((1.0f - t) * 4.0f);
+            } else {
+                weight = 0.0f;
+            }
+        } else {
+            weight = 0.0f;
+        }
+        Raw[id.xy] = float4(lerp(fallback, reflected, weight), z);
+    }
+)";
+
+// Blends this frame's reflections into the reprojected history, clamped to the range of the 3x3
+// neighbourhood and rejected where the stored depth no longer matches, as SSAORenderer does
+const char* TEMPORAL_SHADER = R"(
+    Texture2D<float4> Raw : register(t0);
+    Texture2D<float4> History : register(t1);
+    SamplerState LinearClamp : register(s0);
+    RWTexture2D<float4> Accumulated : register(u0);
+
+    #define TILE 8
+    #define FOOTPRINT (TILE + 2)
+    groupshared float4 Tile[FOOTPRINT * FOOTPRINT];
+
+    [numthreads(TILE, TILE, 1)]
+    void main(uint3 groupId : SV_GroupID, uint3 local : SV_GroupThreadID, uint index : SV_GroupIndex)
+    {
+        int2 origin = int2(groupId.xy) * TILE - 1;
+        for (uint i = index; i < FOOTPRINT * FOOTPRINT; i += TILE * TILE) {
+            int2 texel = clamp(origin + int2(i % FOOTPRINT, i / FOOTPRINT), int2(0, 0), int2(LowSize) - 1);
+            Tile[i] = Raw.Load(int3(texel, 0));
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        uint2 id = groupId.xy * TILE + local.xy;
+        if (any(id >= LowSize)) return;
+
+        int center = (local.y + 1) * FOOTPRINT + local.x + 1;
+        float4 current = Tile[center];
+        float3 low = current.rgb;
+        float3 high = current.rgb;
+        [unroll] for (int y = -1; y <= 1; ++y) {
+            [unroll] for (int x = -1; x <= 1; ++x) {
+                float4 neighbour = Tile[center + y * FOOTPRINT + x];
+                if (neighbour.a < SKY_DEPTH) {
+                    low = min(low, neighbour.rgb);
+                    high = max(high, neighbour.rgb);
+                }
+            }
+        }
+
+        float z = current.a;
+        float3 result = current.rgb;
+        if (BlendWeight < 1.0f && z < SKY_DEPTH) {
+            float4 previous = mul(float4(ViewPosition(float2(id * 2) + 1.0f, z), 1.0f), ViewToPrevious);
+            float2 uv = previous.xy / previous.w * float2(0.5f, -0.5f) + 0.5f;
+            if (previous.w > 0.0f && all(uv >= 0.0f) && all(uv <= 1.0f)) {
+                // previous.w is the point's view depth last frame
+                float4 history = History.SampleLevel(LinearClamp, uv, 0);
+                if (abs(history.a - previous.w) < 0.05f * previous.w) {
+                    result = lerp(clamp(history.rgb, low, high), current.rgb, BlendWeight);
+                }
+            }
+        }
+        Accumulated[id] = float4(result, z);
+    }
+)";
+
+// Bilateral upsample: bilinear weights of the four nearest half-resolution texels, scaled down
+// by how far their depth is from this pixel's
+const char* UPSAMPLE_SHADER = R"(
+    Texture2D<float> Depth : register(t0);
+    Texture2D<float4> Accumulated : register(t1);
+    RWTexture2D<float4> Reflections : register(u0);
+
+    #define DEPTH_SIGMA 0.02f
+
+    [numthreads(8, 8, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (any(id.xy >= FullSize)) return;
+
+        float z = LinearDepth(Depth.Load(int3(id.xy, 0)));
+        if (z >= SKY_DEPTH) {
+            Reflections[id.xy] = float4(0.0f, 0.0f, 0.0f, 0.0f);
+            return;
+        }
+
+        float2 position = (float2(id.xy) + 0.5f) * 0.5f - 0.5f;
+        int2 base = int2(floor(position));
+        float2 f = position - float2(base);
+        float3 sum = float3(0.0f, 0.0f, 0.0f);
+        float weights = 0.0f;
+        float3 closest = float3(0.0f, 0.0f, 0.0f);
+        float closestDelta = 1e30f;
+        [unroll] for (int i = 0; i < 4; ++i) {
+            int2 offset = int2(i & 1, i >> 1);
+            float4 tap = Accumulated.Load(int3(clamp(base + offset, int2(0, 0), int2(LowSize) - 1), 0));
+            float2 bilinear = lerp(1.0f - f, f, float2(offset));
+            float depthDelta = abs(tap.a - z);
+            float weight = bilinear.x * bilinear.y * exp(-depthDelta / (DEPTH_SIGMA * z));
+            sum += tap.rgb * weight;
+            weights += weight;
+            if (depthDelta < closestDelta) {
+                closestDelta = depthDelta;
+                closest = tap.rgb;
+            }
+        }
+        Reflections[id.xy] = float4(weights > 1e-4f ? sum / weights : closest, 1.0f);
+    }
+)";
+
+// Matches SSRConstants above
+struct GpuSSRConstants {
+    DirectX::XMFLOAT4X4 view;
+    DirectX::XMFLOAT4X4 inverseView;
+    DirectX::XMFLOAT4X4 viewToPrevious;
+    float projectionScale[2];
+    float depthScale;
+    float depthOffset;
+    UINT fullSize[2];
+    UINT lowSize[2];
+    float hiZSize[2];
+    UINT hiZLevels;
+    UINT maxSteps;
+    DirectX::XMFLOAT3 ambientLight;
+    float maxDistance;
+    float thickness;
+    float maxRoughness;
+    float edgeFade;
+    float blendWeight;
+    float gamma;
+    UINT frame;
+    UINT hasScene;
+    UINT colorLevels;
+};
+
+struct GpuMipConstants {
+    UINT destinationSize[2];
+    UINT padding[2];
+};
+
+constexpr UINT GROUP_SIZE = 8;
+constexpr UINT MAX_STEPS = 256;
+// The widest cone, at full roughness across the screen, needs about this many
+constexpr UINT MAX_COLOR_MIPS = 7;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3D11ComputeShader* CompileComputeShader(ID3D11Device* device, const std::string& source, const char* name) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(COMMON_SOURCE + source, name, "main", "cs_5_0", 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+
+    ID3D11ComputeShader* shader = nullptr;
+    hr = device->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &shader);
+    blob->Release();
+    return SUCCEEDED(hr) ? shader : nullptr;
+}
+
+ID3D11Buffer* CreateConstantBuffer(ID3D11Device* device, UINT size) {
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = size;
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    ID3D11Buffer* buffer = nullptr;
+    return SUCCEEDED(device->CreateBuffer(&desc, nullptr, &buffer)) ? buffer : nullptr;
+}
+
+template<typename T>
+bool WriteConstants(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const T& data) {
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return false;
+    std::memcpy(mapped.pData, &data, sizeof(T));
+    context->Unmap(buffer, 0);
+    return true;
+}
+
+bool CreateTarget(ID3D11Device* device, UINT width, UINT height, DXGI_FORMAT format, ID3D11Texture2D** texture,
+                  ID3D11ShaderResourceView** view, ID3D11UnorderedAccessView** target) {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, texture))) return false;
+    if (FAILED(device->CreateShaderResourceView(*texture, nullptr, view))) return false;
+    return SUCCEEDED(device->CreateUnorderedAccessView(*texture, nullptr, target));
+}
+
+} // namespace
+
+ScreenSpaceReflections::ScreenSpaceReflections()
+    : device_(nullptr)
+    , context_(nullptr)
+    , width_(0)
+    , height_(0)
+    , lowWidth_(0)
+    , lowHeight_(0)
+    , colorShader_(nullptr)
+    , colorMipShader_(nullptr)
+    , traceShader_(nullptr)
+    , temporalShader_(nullptr)
+    , upsampleShader_(nullptr)
+    , constants_(nullptr)
+    , mipConstants_(nullptr)
+    , linearClamp_(nullptr)
+    , color_(nullptr)
+    , colorView_(nullptr)
+    , raw_(nullptr)
+    , rawView_(nullptr)
+    , rawTarget_(nullptr)
+    , history_{}
+    , historyViews_{}
+    , historyTargets_{}
+    , historyIndex_(0)
+    , historyValid_(false)
+    , output_(nullptr)
+    , outputView_(nullptr)
+    , outputTarget_(nullptr)
+    , previousValid_(false)
+    , frame_(0)
+{
+    DirectX::XMStoreFloat4x4(&previousViewProjection_, DirectX::XMMatrixIdentity());
+}
+
+ScreenSpaceReflections::~ScreenSpaceReflections() {
+    Shutdown();
+}
+
+bool ScreenSpaceReflections::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height,
+                                        const Settings& settings) {
+    Shutdown();
+    if (!device || !context || width == 0 || height == 0) return false;
+
+    device_ = device;
+    context_ = context;
+    width_ = width;
+    height_ = height;
+    lowWidth_ = std::max(1u, (width + 1) / 2);
+    lowHeight_ = std::max(1u, (height + 1) / 2);
+    SetSettings(settings);
+
+    if (!CreateShaders() || !CreateTargets()) {
+        Logger::Error("Failed to create screen-space reflection resources");
+        Shutdown();
+        return false;
+    }
+    Logger::Info("Screen-space reflections initialized: " + std::to_string(lowWidth_) + "x" +
+                 std::to_string(lowHeight_) + ", " + std::to_string(settings_.maxSteps) + " steps");
+    return true;
+}
+
+void ScreenSpaceReflections::Shutdown() {
+    ReleaseTargets();
+    SafeRelease(colorShader_);
+    SafeRelease(colorMipShader_);
+    SafeRelease(traceShader_);
+    SafeRelease(temporalShader_);
+    SafeRelease(upsampleShader_);
+    SafeRelease(constants_);
+    SafeRelease(mipConstants_);
+    SafeRelease(linearClamp_);
+    historyValid_ = false;
+    previousValid_ = false;
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+void ScreenSpaceReflections::SetSettings(const Settings& settings) {
+    settings_ = settings;
+    settings_.maxSteps = std::clamp(settings_.maxSteps, 1u, MAX_STEPS);
+    settings_.maxDistance = std::max(settings_.maxDistance, 1e-3f);
+    settings_.thickness = std::max(settings_.thickness, 0.0f);
+    settings_.maxRoughness = std::clamp(settings_.maxRoughness, 0.01f, 1.0f);
+    settings_.edgeFade = std::clamp(settings_.edgeFade, 0.0f, 0.5f);
+}
+
+bool ScreenSpaceReflections::CreateShaders() {
+    colorShader_ = CompileComputeShader(device_, COLOR_SHADER, "SSRColor");
+    colorMipShader_ = CompileComputeShader(device_, COLOR_MIP_SHADER, "SSRColorMip");
+    traceShader_ = CompileComputeShader(device_, std::string(ProbeVolume::GetShaderSource()) + TRACE_SHADER, "SSRTrace");
+    temporalShader_ = CompileComputeShader(device_, TEMPORAL_SHADER, "SSRTemporal");
+    upsampleShader_ = CompileComputeShader(device_, UPSAMPLE_SHADER, "SSRUpsample");
+    constants_ = CreateConstantBuffer(device_, sizeof(GpuSSRConstants));
+    mipConstants_ = CreateConstantBuffer(device_, sizeof(GpuMipConstants));
+    if (!colorShader_ || !colorMipShader_ || !traceShader_ || !temporalShader_ || !upsampleShader_ ||
+        !constants_ || !mipConstants_) {
+        return false;
+    }
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    return SUCCEEDED(device_->CreateSamplerState(&samplerDesc, &linearClamp_));
+}
+
+bool ScreenSpaceReflections::CreateTargets() {
+    UINT mipCount = 1;
+    for (UINT size = std::max(lowWidth_, lowHeight_); size > 1 && mipCount < MAX_COLOR_MIPS; size /= 2) {
+        ++mipCount;
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = lowWidth_;
+    desc.Height = lowHeight_;
+    desc.MipLevels = mipCount;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &color_)) ||
+        FAILED(device_->CreateShaderResourceView(color_, nullptr, &colorView_))) {
+        return false;
+    }
+
+    for (UINT mip = 0; mip < mipCount; ++mip) {
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format = desc.Format;
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MostDetailedMip = mip;
+        srvDesc.Texture2D.MipLevels = 1;
+
+        D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format = desc.Format;
+        uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+        uavDesc.Texture2D.MipSlice = mip;
+
+        ID3D11ShaderResourceView* view = nullptr;
+        ID3D11UnorderedAccessView* target = nullptr;
+        if (FAILED(device_->CreateShaderResourceView(color_, &srvDesc, &view)) ||
+            FAILED(device_->CreateUnorderedAccessView(color_, &uavDesc, &target))) {
+            SafeRelease(view);
+            return false;
+        }
+        colorMipViews_.push_back(view);
+        colorMipTargets_.push_back(target);
+    }
+
+    // Depth rides in alpha as in SSAORenderer's history, enough for the 5% test
+    const DXGI_FORMAT format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    return CreateTarget(device_, lowWidth_, lowHeight_, format, &raw_, &rawView_, &rawTarget_) &&
+           CreateTarget(device_, lowWidth_, lowHeight_, format, &history_[0], &historyViews_[0], &historyTargets_[0]) &&
+           CreateTarget(device_, lowWidth_, lowHeight_, format, &history_[1], &historyViews_[1], &historyTargets_[1]) &&
+           CreateTarget(device_, width_, height_, format, &output_, &outputView_, &outputTarget_);
+}
+
+void ScreenSpaceReflections::ReleaseTargets() {
+    for (ID3D11ShaderResourceView* view : colorMipViews_) view->Release();
+    for (ID3D11UnorderedAccessView* target : colorMipTargets_) target->Release();
+    colorMipViews_.clear();
+    colorMipTargets_.clear();
+    SafeRelease(colorView_);
+    SafeRelease(color_);
+    SafeRelease(rawTarget_);
+    SafeRelease(rawView_);
+    SafeRelease(raw_);
+    for (UINT i = 0; i < 2; ++i) {
+        SafeRelease(historyTargets_[i]);
+        SafeRelease(historyViews_[i]);
+        SafeRelease(history_[i]);
+    }
+    SafeRelease(outputTarget_);
+    SafeRelease(outputView_);
+    SafeRelease(output_);
+}
+
+void ScreenSpaceReflections::Dispatch(ID3D11ComputeShader* shader, ID3D11ShaderResourceView* const* views, UINT viewCount,
+                                      ID3D11UnorderedAccessView* target, UINT width, UINT height) {
+    context_->CSSetShader(shader, nullptr, 0);
+    context_->CSSetShaderResources(0, viewCount, views);
+    context_->CSSetUnorderedAccessViews(0, 1, &target, nullptr);
+    context_->Dispatch((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+    // Unbind before the output becomes the next pass's input
+    ID3D11ShaderResourceView* nullViews[5] = {};
+    ID3D11UnorderedAccessView* nullTarget = nullptr;
+    context_->CSSetShaderResources(0, viewCount, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+}
+
+void ScreenSpaceReflections::Render(const DeferredRenderer& gbuffer, const OcclusionCuller* hiZ,
+                                    ID3D11ShaderResourceView* previousScene, float gamma,
+                                    DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection,
+                                    const DirectX::XMFLOAT3& ambientLight, const ProbeVolume* probes) {
+    if (!device_) return;
+    NEXUS_PROFILE_SCOPE("ScreenSpaceReflections::Render");
+
+    const bool hasPyramid = hiZ && hiZ->HasPyramid() && hiZ->GetPyramidView();
+    const bool hasScene = previousScene && previousValid_;
+
+    DirectX::XMFLOAT4X4 projectionValues;
+    DirectX::XMStoreFloat4x4(&projectionValues, projection);
+    DirectX::XMMATRIX inverseView = DirectX::XMMatrixInverse(nullptr, view);
+
+    GpuSSRConstants constants = {};
+    DirectX::XMStoreFloat4x4(&constants.view, DirectX::XMMatrixTranspose(view));
+    DirectX::XMStoreFloat4x4(&constants.inverseView, DirectX::XMMatrixTranspose(inverseView));
+    DirectX::XMStoreFloat4x4(&constants.viewToPrevious,
+                             DirectX::XMMatrixTranspose(inverseView * DirectX::XMLoadFloat4x4(&previousViewProjection_)));
+    constants.projectionScale[0] = projectionValues._11;
+    constants.projectionScale[1] = projectionValues._22;
+    constants.depthScale = projectionValues._43;
+    constants.depthOffset = projectionValues._33;
+    constants.fullSize[0] = width_;
+    constants.fullSize[1] = height_;
+    constants.lowSize[0] = lowWidth_;
+    constants.lowSize[1] = lowHeight_;
+    if (hasPyramid) {
+        constants.hiZSize[0] = static_cast<float>(hiZ->GetPyramidWidth());
+        constants.hiZSize[1] = static_cast<float>(hiZ->GetPyramidHeight());
+        constants.hiZLevels = hiZ->GetPyramidMipCount();
+    }
+    constants.maxSteps = settings_.maxSteps;
+    constants.ambientLight = ambientLight;
+    constants.maxDistance = settings_.maxDistance;
+    constants.thickness = settings_.thickness;
+    constants.maxRoughness = settings_.maxRoughness;
+    constants.edgeFade = settings_.edgeFade;
+    constants.blendWeight = historyValid_ ? std::clamp(settings_.temporalBlend, 0.01f, 1.0f) : 1.0f;
+    constants.gamma = gamma > 0.0f ? gamma : 2.2f;
+    constants.frame = frame_++;
+    constants.hasScene = hasScene ? 1u : 0u;
+    constants.colorLevels = static_cast<UINT>(colorMipViews_.size());
+    if (!WriteConstants(context_, constants_, constants)) return;
+
+    ID3D11Buffer* buffers[2] = { constants_, mipConstants_ };
+    context_->CSSetConstantBuffers(0, 2, buffers);
+    context_->CSSetSamplers(0, 1, &linearClamp_);
+
+    if (hasScene) {
+        Dispatch(colorShader_, &previousScene, 1, colorMipTargets_[0], lowWidth_, lowHeight_);
+        for (size_t mip = 1; mip < colorMipTargets_.size(); ++mip) {
+            UINT width = std::max(1u, lowWidth_ >> mip);
+            UINT height = std::max(1u, lowHeight_ >> mip);
+            GpuMipConstants mipConstants = {{width, height}, {}};
+            WriteConstants(context_, mipConstants_, mipConstants);
+            Dispatch(colorMipShader_, &colorMipViews_[mip - 1], 1, colorMipTargets_[mip], width, height);
+        }
+    }
+
+    // Likewise the probe constants read as zero, which falls back to the flat ambient
+    if (probes) {
+        probes->BindCompute();
+    } else {
+        ID3D11Buffer* nullBuffer = nullptr;
+        context_->CSSetConstantBuffers(ProbeVolume::CONSTANT_SLOT, 1, &nullBuffer);
+    }
+
+    ID3D11ShaderResourceView* traceViews[5] = {
+        gbuffer.GetDepthView(), gbuffer.GetTargetView(1), gbuffer.GetTargetView(2),
+        hasPyramid ? hiZ->GetPyramidView() : nullptr, hasScene ? colorView_ : nullptr
+    };
+    Dispatch(traceShader_, traceViews, 5, rawTarget_, lowWidth_, lowHeight_);
+
+    const UINT next = historyIndex_ ^ 1;
+    ID3D11ShaderResourceView* temporalViews[2] = { rawView_, historyViews_[historyIndex_] };
+    Dispatch(temporalShader_, temporalViews, 2, historyTargets_[next], lowWidth_, lowHeight_);
+    historyIndex_ = next;
+
+    ID3D11ShaderResourceView* upsampleViews[2] = { gbuffer.GetDepthView(), historyViews_[historyIndex_] };
+    Dispatch(upsampleShader_, upsampleViews, 2, outputTarget_, width_, height_);
+
+    context_->CSSetShader(nullptr, nullptr, 0);
+    DirectX::XMStoreFloat4x4(&previousViewProjection_, view * projection);
+    previousValid_ = true;
+    historyValid_ = true;
+}
+
+} // namespace Nexus
@@ -1,6 +1,12 @@
 #include "Shader.h"
 #include "Logger.h"
+#include "StateCache.h"
+#include "ConstantBufferRing.h"
+#include "ShaderCache.h"
 #include <d3dcompiler.h>
+#include <d3d11shader.h>
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
@@ -10,9 +16,11 @@ Shader::Shader()
     : vertexShader_(nullptr)
     , pixelShader_(nullptr)
     , inputLayout_(nullptr)
+    , vertexFormat_(VertexFormat::Full)
     , constantBuffer_(nullptr)
     , device_(nullptr)
     , constantBufferSize_(0)
+    , constantsDirty_(false)
 {
 }
 
@@ -48,20 +56,28 @@ bool Shader::LoadFromFile(const std::string& vertexShaderFile,
 
 bool Shader::LoadFromSource(const std::string& vertexShaderSource,
                            const std::string& pixelShaderSource,
-                           ID3D11Device* device) {
+                           ID3D11Device* device,
+                           const std::vector<ShaderCache::Define>& vertexDefines,
+                           const std::vector<ShaderCache::Define>& pixelDefines) {
     device_ = device;
+    vertexFormat_ = VertexFormat::Full;
+    for (const ShaderCache::Define& define : vertexDefines) {
+        if (define.name == COMPRESSED_VERTEX_KEYWORD) {
+            vertexFormat_ = VertexFormat::Compressed;
+        }
+    }
     
     ID3DBlob* vsBlob = nullptr;
     ID3DBlob* psBlob = nullptr;
     
     // Compile vertex shader
-    if (!CompileShader(vertexShaderSource, "vs_5_0", &vsBlob)) {
+    if (!CompileShader(vertexShaderSource, "vs_5_0", &vsBlob, vertexDefines)) {
         Logger::Error("Failed to compile vertex shader");
         return false;
     }
     
     // Compile pixel shader
-    if (!CompileShader(pixelShaderSource, "ps_5_0", &psBlob)) {
+    if (!CompileShader(pixelShaderSource, "ps_5_0", &psBlob, pixelDefines)) {
         Logger::Error("Failed to compile pixel shader");
         if (vsBlob) vsBlob->Release();
         return false;
@@ -85,14 +101,15 @@ bool Shader::LoadFromSource(const std::string& vertexShaderSource,
         return false;
     }
     
-    // Create input layout (basic layout for now)
-    D3D11_INPUT_ELEMENT_DESC layout[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0}
-    };
+    // Create input layout
+    hr = CreateInputLayout(device, vsBlob);
     
-    hr = device->CreateInputLayout(layout, ARRAYSIZE(layout), vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &inputLayout_);
+    // Parameter offsets for the shared b0 constant buffer
+    parameters_.clear();
+    parameterLookup_.clear();
+    constantBufferSize_ = 0;
+    ReflectConstants(vsBlob);
+    ReflectConstants(psBlob);
     
     vsBlob->Release();
     psBlob->Release();
@@ -119,11 +136,34 @@ void Shader::Bind(ID3D11DeviceContext* deviceContext) {
     
     // Set constant buffers
     if (constantBuffer_) {
+        if (constantsDirty_) {
+            D3D11_MAPPED_SUBRESOURCE mapped = {};
+            if (SUCCEEDED(deviceContext->Map(constantBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+                std::memcpy(mapped.pData, constantBufferData_.get(), constantBufferSize_);
+                deviceContext->Unmap(constantBuffer_, 0);
+                constantsDirty_ = false;
+            }
+        }
         deviceContext->VSSetConstantBuffers(0, 1, &constantBuffer_);
         deviceContext->PSSetConstantBuffers(0, 1, &constantBuffer_);
     }
 }
 
+void Shader::Bind(StateCache& stateCache, ConstantBufferRing& ring) {
+    stateCache.VSSetShader(vertexShader_);
+    stateCache.PSSetShader(pixelShader_);
+    stateCache.IASetInputLayout(inputLayout_);
+    
+    // Ring memory is recycled, so the constants are uploaded again on every bind
+    if (constantBufferSize_ > 0) {
+        ConstantBufferRing::Allocation constants;
+        if (ring.Upload(constantBufferData_.get(), static_cast<UINT>(constantBufferSize_), constants)) {
+            stateCache.VSSetConstantBuffers1(0, 1, &constants.buffer, &constants.firstConstant, &constants.numConstants);
+            stateCache.PSSetConstantBuffers1(0, 1, &constants.buffer, &constants.firstConstant, &constants.numConstants);
+        }
+    }
+}
+
 void Shader::Unbind(ID3D11DeviceContext* deviceContext) {
     if (!deviceContext) return;
     
@@ -132,29 +172,55 @@ void Shader::Unbind(ID3D11DeviceContext* deviceContext) {
     deviceContext->IASetInputLayout(nullptr);
 }
 
+Shader::ParameterHandle Shader::FindParameter(const std::string& name) const {
+    auto it = parameterLookup_.find(name);
+    return it != parameterLookup_.end() ? it->second : INVALID_PARAMETER;
+}
+
+void Shader::SetMatrix(ParameterHandle parameter, const XMMATRIX& matrix) {
+    if (parameter < 0 || parameter >= static_cast<ParameterHandle>(parameters_.size())) return;
+    
+    XMFLOAT4X4 value;
+    XMStoreFloat4x4(&value, parameters_[parameter].columnMajor ? XMMatrixTranspose(matrix) : matrix);
+    WriteParameter(parameter, &value, sizeof(value));
+}
+
+void Shader::SetVector(ParameterHandle parameter, const XMFLOAT4& vector) {
+    WriteParameter(parameter, &vector, sizeof(vector));
+}
+
+void Shader::SetFloat(ParameterHandle parameter, float value) {
+    WriteParameter(parameter, &value, sizeof(value));
+}
+
+void Shader::SetInt(ParameterHandle parameter, int value) {
+    WriteParameter(parameter, &value, sizeof(value));
+}
+
+void Shader::SetBool(ParameterHandle parameter, bool value) {
+    // HLSL bools are 32-bit
+    int hlslBool = value ? 1 : 0;
+    WriteParameter(parameter, &hlslBool, sizeof(hlslBool));
+}
+
 void Shader::SetMatrix(const std::string& name, const XMMATRIX& matrix) {
-    // Store matrix in constant buffer data
-    // For now, this is a stub implementation
+    SetMatrix(FindParameter(name), matrix);
 }
 
 void Shader::SetVector(const std::string& name, const XMFLOAT4& vector) {
-    // Store vector in constant buffer data
-    // For now, this is a stub implementation
+    SetVector(FindParameter(name), vector);
 }
 
 void Shader::SetFloat(const std::string& name, float value) {
-    // Store float in constant buffer data
-    // For now, this is a stub implementation
+    SetFloat(FindParameter(name), value);
 }
 
 void Shader::SetInt(const std::string& name, int value) {
-    // Store int in constant buffer data
-    // For now, this is a stub implementation
+    SetInt(FindParameter(name), value);
 }
 
 void Shader::SetBool(const std::string& name, bool value) {
-    // Store bool in constant buffer data
-    // For now, this is a stub implementation
+    SetBool(FindParameter(name), value);
 }
 
 void Shader::SetTexture(const std::string& name, ID3D11ShaderResourceView* texture) {
@@ -178,43 +244,135 @@ void Shader::SetEyePosition(const XMFLOAT3& position) {
     SetVector("eyePosition", XMFLOAT4(position.x, position.y, position.z, 1.0f));
 }
 
-bool Shader::CompileShader(const std::string& source, const std::string& target, ID3DBlob** shader) {
-    ID3DBlob* errorBlob = nullptr;
-    
-    HRESULT hr = D3DCompile(
-        source.c_str(),
-        source.length(),
-        nullptr,
-        nullptr,
-        nullptr,
-        "main",
-        target.c_str(),
-        D3DCOMPILE_ENABLE_STRICTNESS,
-        0,
-        shader,
-        &errorBlob
-    );
+void Shader::SetPositionDequantization(const XMFLOAT3& offset, const XMFLOAT3& scale) {
+    SetVector("positionOffset", XMFLOAT4(offset.x, offset.y, offset.z, 0.0f));
+    SetVector("positionScale", XMFLOAT4(scale.x, scale.y, scale.z, 0.0f));
+}
+
+bool Shader::CompileShader(const std::string& source, const std::string& target, ID3DBlob** shader,
+                           const std::vector<ShaderCache::Define>& defines) {
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, nullptr, "main", target.c_str(), D3DCOMPILE_ENABLE_STRICTNESS, shader, &errors, defines);
     
     if (FAILED(hr)) {
-        if (errorBlob) {
-            Logger::Error("Shader compilation error: " + std::string(static_cast<char*>(errorBlob->GetBufferPointer())));
-            errorBlob->Release();
+        if (!errors.empty()) {
+            Logger::Error("Shader compilation error: " + errors);
         }
         return false;
     }
     
-    if (errorBlob) {
-        errorBlob->Release();
+    return true;
+}
+
+void Shader::ReflectConstants(ID3DBlob* shaderBlob) {
+    ID3D11ShaderReflection* reflection = nullptr;
+    HRESULT hr = D3DReflect(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), IID_ID3D11ShaderReflection, (void**)&reflection);
+    if (FAILED(hr)) {
+        Logger::Warning("Shader reflection failed, parameters will be ignored");
+        return;
     }
     
-    return true;
+    D3D11_SHADER_DESC shaderDesc = {};
+    reflection->GetDesc(&shaderDesc);
+    
+    for (UINT i = 0; i < shaderDesc.ConstantBuffers; ++i) {
+        ID3D11ShaderReflectionConstantBuffer* buffer = reflection->GetConstantBufferByIndex(i);
+        D3D11_SHADER_BUFFER_DESC bufferDesc = {};
+        buffer->GetDesc(&bufferDesc);
+        
+        // Only the buffer bound at b0 is managed by this class
+        D3D11_SHADER_INPUT_BIND_DESC bindDesc = {};
+        if (FAILED(reflection->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc)) ||
+            bindDesc.Type != D3D_SIT_CBUFFER || bindDesc.BindPoint != 0) {
+            continue;
+        }
+        
+        constantBufferSize_ = std::max<size_t>(constantBufferSize_, bufferDesc.Size);
+        
+        for (UINT v = 0; v < bufferDesc.Variables; ++v) {
+            ID3D11ShaderReflectionVariable* variable = buffer->GetVariableByIndex(v);
+            D3D11_SHADER_VARIABLE_DESC variableDesc = {};
+            D3D11_SHADER_TYPE_DESC typeDesc = {};
+            variable->GetDesc(&variableDesc);
+            variable->GetType()->GetDesc(&typeDesc);
+            
+            // Both stages usually declare the same buffer; the first declaration wins
+            auto existing = parameterLookup_.find(variableDesc.Name);
+            if (existing != parameterLookup_.end()) {
+                if (parameters_[existing->second].offset != variableDesc.StartOffset) {
+                    Logger::Warning("Shader parameter '" + std::string(variableDesc.Name) + "' has different offsets per stage");
+                }
+                continue;
+            }
+            
+            Parameter parameter;
+            parameter.name = variableDesc.Name;
+            parameter.offset = variableDesc.StartOffset;
+            parameter.size = variableDesc.Size;
+            parameter.columnMajor = typeDesc.Class == D3D_SVC_MATRIX_COLUMNS;
+            parameterLookup_[parameter.name] = static_cast<ParameterHandle>(parameters_.size());
+            parameters_.push_back(parameter);
+        }
+    }
+    
+    reflection->Release();
+}
+
+HRESULT Shader::CreateInputLayout(ID3D11Device* device, ID3DBlob* vertexShaderBlob) {
+    if (inputLayout_) { inputLayout_->Release(); inputLayout_ = nullptr; }
+    
+    ID3D11ShaderReflection* reflection = nullptr;
+    HRESULT hr = D3DReflect(vertexShaderBlob->GetBufferPointer(), vertexShaderBlob->GetBufferSize(), IID_ID3D11ShaderReflection, (void**)&reflection);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    D3D11_SHADER_DESC shaderDesc = {};
+    reflection->GetDesc(&shaderDesc);
+    
+    // Only the elements the shader consumes, so one vertex format serves every mesh shader
+    UINT formatElementCount = 0;
+    const D3D11_INPUT_ELEMENT_DESC* formatElements = Mesh::GetInputLayout(vertexFormat_, formatElementCount);
+    std::vector<D3D11_INPUT_ELEMENT_DESC> elements;
+    for (UINT i = 0; i < shaderDesc.InputParameters && SUCCEEDED(hr); ++i) {
+        D3D11_SIGNATURE_PARAMETER_DESC parameterDesc = {};
+        reflection->GetInputParameterDesc(i, &parameterDesc);
+        if (parameterDesc.SystemValueType != D3D_NAME_UNDEFINED) continue;
+        
+        const D3D11_INPUT_ELEMENT_DESC* match = std::find_if(formatElements, formatElements + formatElementCount,
+            [&](const D3D11_INPUT_ELEMENT_DESC& element) {
+                return _stricmp(element.SemanticName, parameterDesc.SemanticName) == 0 &&
+                       element.SemanticIndex == parameterDesc.SemanticIndex;
+            });
+        if (match == formatElements + formatElementCount) {
+            Logger::Error("Vertex shader input " + std::string(parameterDesc.SemanticName) +
+                          std::to_string(parameterDesc.SemanticIndex) + " is not part of the mesh vertex format");
+            hr = E_INVALIDARG;
+        } else {
+            elements.push_back(*match);
+        }
+    }
+    
+    if (SUCCEEDED(hr)) {
+        hr = device->CreateInputLayout(elements.data(), static_cast<UINT>(elements.size()),
+                                       vertexShaderBlob->GetBufferPointer(), vertexShaderBlob->GetBufferSize(), &inputLayout_);
+    }
+    reflection->Release();
+    return hr;
 }
 
 void Shader::CreateConstantBuffers(ID3D11Device* device) {
-    // Create a basic constant buffer
-    // This is a simplified implementation
-    constantBufferSize_ = 1024; // 1KB buffer
+    if (constantBuffer_) { constantBuffer_->Release(); constantBuffer_ = nullptr; }
+    
+    // Sized from reflection, nothing to create for shaders without parameters
+    constantBufferSize_ = (constantBufferSize_ + 15) & ~static_cast<size_t>(15);
+    if (constantBufferSize_ == 0) {
+        constantBufferData_.reset();
+        return;
+    }
     constantBufferData_ = std::make_unique<char[]>(constantBufferSize_);
+    std::memset(constantBufferData_.get(), 0, constantBufferSize_);
+    constantsDirty_ = true;
     
     D3D11_BUFFER_DESC bufferDesc = {};
     bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
@@ -225,9 +383,12 @@ void Shader::CreateConstantBuffers(ID3D11Device* device) {
     device->CreateBuffer(&bufferDesc, nullptr, &constantBuffer_);
 }
 
-void Shader::UpdateConstantBuffer(ID3D11DeviceContext* deviceContext, const std::string& name, const void* data, size_t size) {
-    // Update constant buffer with new data
-    // This is a stub implementation
+void Shader::WriteParameter(ParameterHandle parameter, const void* data, size_t size) {
+    if (parameter < 0 || parameter >= static_cast<ParameterHandle>(parameters_.size())) return;
+    
+    const Parameter& target = parameters_[parameter];
+    std::memcpy(constantBufferData_.get() + target.offset, data, std::min<size_t>(size, target.size));
+    constantsDirty_ = true;
 }
 
 } // namespace Nexus
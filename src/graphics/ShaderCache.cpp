@@ -0,0 +1,218 @@
+#include "ShaderCache.h"
+#include "AtomicFile.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace Nexus {
+
+namespace {
+constexpr uint32_t ENTRY_MAGIC = 0x4353584E;   // "NXSC"
+constexpr uint32_t ENTRY_VERSION = 1;
+
+struct EntryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+// FNV-1a; each field is terminated so ("ab", "c") and ("a", "bc") hash differently
+void HashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    unsigned char terminator = 0;
+    hash ^= terminator;
+    hash *= 1099511628211ull;
+}
+
+void HashString(uint64_t& hash, const std::string& text) {
+    HashBytes(hash, text.data(), text.size());
+}
+
+// Relative cache directories hang off the executable, where the NexusShaders build step writes
+// bin/shadercache, rather than whatever working directory the engine was launched from
+std::string ResolveDirectory(const std::string& directory) {
+    std::filesystem::path path(directory);
+    if (path.is_absolute()) return directory;
+
+    wchar_t module[MAX_PATH];
+    DWORD length = GetModuleFileNameW(nullptr, module, MAX_PATH);
+    if (length == 0 || length == MAX_PATH) return directory;
+    return (std::filesystem::path(module).parent_path() / path).string();
+}
+}
+
+std::mutex ShaderCache::mutex_;
+std::string ShaderCache::directory_;
+std::unordered_map<uint64_t, ID3DBlob*> ShaderCache::memory_;
+ShaderCache::Stats ShaderCache::stats_;
+
+void ShaderCache::Initialize(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    directory_ = directory.empty() ? directory : ResolveDirectory(directory);
+    if (directory_.empty()) return;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        Logger::Warning("Shader cache directory unavailable (" + directory_ + "), caching in memory only");
+        directory_.clear();
+        return;
+    }
+    Logger::Info("Shader cache: " + directory_);
+}
+
+void ShaderCache::Shutdown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : memory_) {
+        entry.second->Release();
+    }
+    memory_.clear();
+
+    if (stats_.compiles > 0 || stats_.diskHits > 0) {
+        Logger::Info("Shader cache: " + std::to_string(stats_.diskHits) + " disk hits, " +
+                     std::to_string(stats_.memoryHits) + " memory hits, " + std::to_string(stats_.compiles) +
+                     " compiles (" + std::to_string(static_cast<int>(stats_.compileMs)) + " ms)");
+    }
+}
+
+uint64_t ShaderCache::ComputeKey(const std::string& source, const char* entryPoint, const char* target,
+                                 UINT flags, const std::vector<Define>& defines) {
+    uint64_t hash = 14695981039346656037ull;
+    HashString(hash, source);
+    HashString(hash, entryPoint ? entryPoint : "");
+    HashString(hash, target ? target : "");
+    HashBytes(hash, &flags, sizeof(flags));
+    for (const Define& define : defines) {
+        HashString(hash, define.name);
+        HashString(hash, define.value);
+    }
+
+    // A different compiler can emit different bytecode for the same input
+    const uint32_t compilerVersion = D3D_COMPILER_VERSION;
+    HashBytes(hash, &compilerVersion, sizeof(compilerVersion));
+    return hash;
+}
+
+ShaderCache::Stats ShaderCache::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::string ShaderCache::GetEntryPath(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.cso", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+bool ShaderCache::ReadEntry(uint64_t key, ID3DBlob** bytecode) {
+    std::ifstream file(GetEntryPath(key), std::ios::binary);
+    if (!file) return false;
+
+    EntryHeader header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != ENTRY_MAGIC || header.version != ENTRY_VERSION || header.key != key || header.size == 0) {
+        return false;
+    }
+
+    ID3DBlob* blob = nullptr;
+    if (FAILED(D3DCreateBlob(header.size, &blob))) return false;
+    if (!file.read(static_cast<char*>(blob->GetBufferPointer()), header.size)) {
+        blob->Release();
+        return false;
+    }
+
+    *bytecode = blob;
+    return true;
+}
+
+void ShaderCache::WriteEntry(uint64_t key, ID3DBlob* bytecode) {
+    // A failed write only costs a recompile next run
+    WriteFileAtomic(GetEntryPath(key), [&](std::ostream& file) {
+        EntryHeader header = { ENTRY_MAGIC, ENTRY_VERSION, key, static_cast<uint32_t>(bytecode->GetBufferSize()), 0 };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(static_cast<const char*>(bytecode->GetBufferPointer()), bytecode->GetBufferSize());
+    });
+}
+
+HRESULT ShaderCache::Compile(const std::string& source, const char* sourceName, const char* entryPoint,
+                             const char* target, UINT flags, ID3DBlob** bytecode, std::string* errors,
+                             const std::vector<Define>& defines) {
+    if (!bytecode) return E_INVALIDARG;
+    *bytecode = nullptr;
+
+    const uint64_t key = ComputeKey(source, entryPoint, target, flags, defines);
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = memory_.find(key);
+        if (it != memory_.end()) {
+            it->second->AddRef();
+            *bytecode = it->second;
+            stats_.memoryHits++;
+            return S_OK;
+        }
+        directory = directory_;
+    }
+
+    ID3DBlob* blob = nullptr;
+    bool fromDisk = !directory.empty() && ReadEntry(key, &blob);
+    if (!fromDisk) {
+        NEXUS_PROFILE_SCOPE("ShaderCache::Compile");
+
+        std::vector<D3D_SHADER_MACRO> macros;
+        for (const Define& define : defines) {
+            macros.push_back({ define.name.c_str(), define.value.c_str() });
+        }
+        macros.push_back({ nullptr, nullptr });
+
+        auto start = std::chrono::high_resolution_clock::now();
+        ID3DBlob* errorBlob = nullptr;
+        HRESULT hr = D3DCompile(source.c_str(), source.length(), sourceName, macros.data(), nullptr,
+                                entryPoint, target, flags, 0, &blob, &errorBlob);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        if (errorBlob) {
+            if (FAILED(hr) && errors) {
+                *errors = std::string(static_cast<const char*>(errorBlob->GetBufferPointer()));
+            }
+            errorBlob->Release();
+        }
+        if (FAILED(hr)) {
+            if (blob) blob->Release();
+            return hr;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.compiles++;
+        stats_.compileMs += elapsedMs;
+    }
+
+    if (!fromDisk && !directory.empty()) {
+        WriteEntry(key, blob);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fromDisk) {
+        stats_.diskHits++;
+    }
+    auto inserted = memory_.emplace(key, blob);
+    if (!inserted.second) {
+        // Another thread finished the same shader first
+        blob->Release();
+        blob = inserted.first->second;
+    }
+    blob->AddRef();
+    *bytecode = blob;
+    return S_OK;
+}
+
+} // namespace Nexus
@@ -0,0 +1,178 @@
+#include "ShaderPermutations.h"
+#include "Shader.h"
+#include "Logger.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace Nexus {
+
+namespace {
+const char KEYWORDS_TAG[] = "// keywords:";
+}
+
+ShaderPermutations::ShaderPermutations()
+    : device_(nullptr)
+    , validMask_(0)
+    , variantCount_(0)
+{
+}
+
+ShaderPermutations::~ShaderPermutations() {
+    ReleaseVariants();
+}
+
+void ShaderPermutations::ReleaseVariants() {
+    for (size_t i = 0; i < variantCount_; ++i) {
+        delete variants_[i].load(std::memory_order_relaxed);
+    }
+    variants_.reset();
+    failed_.reset();
+    variantCount_ = 0;
+}
+
+bool ShaderPermutations::LoadFromFile(const std::string& vertexShaderFile, const std::string& pixelShaderFile,
+                                      ID3D11Device* device) {
+    std::ifstream vsFile(vertexShaderFile);
+    std::ifstream psFile(pixelShaderFile);
+    if (!vsFile.is_open() || !psFile.is_open()) {
+        Logger::Error("Failed to open shader files: " + vertexShaderFile + ", " + pixelShaderFile);
+        return false;
+    }
+
+    std::stringstream vsStream, psStream;
+    vsStream << vsFile.rdbuf();
+    psStream << psFile.rdbuf();
+    return LoadFromSource(vsStream.str(), psStream.str(), device);
+}
+
+bool ShaderPermutations::LoadFromSource(const std::string& vertexShaderSource, const std::string& pixelShaderSource,
+                                        ID3D11Device* device) {
+    ReleaseVariants();
+    device_ = device;
+    keywords_.clear();
+    vertex_ = { vertexShaderSource, ParseKeywords(vertexShaderSource), {} };
+    pixel_ = { pixelShaderSource, ParseKeywords(pixelShaderSource), {} };
+    if (!AddStageKeywords(vertex_) || !AddStageKeywords(pixel_)) {
+        keywords_.clear();
+        return false;
+    }
+
+    variantCount_ = size_t(1) << keywords_.size();
+    validMask_ = static_cast<KeywordMask>(variantCount_ - 1);
+    variants_ = std::make_unique<std::atomic<Shader*>[]>(variantCount_);
+    failed_ = std::make_unique<std::atomic<bool>[]>(variantCount_);
+    for (size_t i = 0; i < variantCount_; ++i) {
+        variants_[i].store(nullptr, std::memory_order_relaxed);
+        failed_[i].store(false, std::memory_order_relaxed);
+    }
+
+    // The base variant doubles as a check that the sources compile at all
+    return Select(0) != nullptr;
+}
+
+bool ShaderPermutations::AddStageKeywords(Stage& stage) {
+    for (const std::string& keyword : stage.keywords) {
+        auto it = std::find(keywords_.begin(), keywords_.end(), keyword);
+        if (it == keywords_.end()) {
+            if (keywords_.size() == MAX_KEYWORDS) {
+                Logger::Error("Shader declares more than " + std::to_string(MAX_KEYWORDS) + " keywords");
+                return false;
+            }
+            it = keywords_.insert(keywords_.end(), keyword);
+        }
+        stage.bits.push_back(KeywordMask(1) << (it - keywords_.begin()));
+    }
+    return true;
+}
+
+ShaderPermutations::KeywordMask ShaderPermutations::GetKeywordMask(const std::string& keyword) const {
+    auto it = std::find(keywords_.begin(), keywords_.end(), keyword);
+    return it != keywords_.end() ? KeywordMask(1) << (it - keywords_.begin()) : 0;
+}
+
+ShaderPermutations::KeywordMask ShaderPermutations::GetKeywordMask(const std::vector<std::string>& keywords) const {
+    KeywordMask mask = 0;
+    for (const std::string& keyword : keywords) {
+        mask |= GetKeywordMask(keyword);
+    }
+    return mask;
+}
+
+Shader* ShaderPermutations::Select(KeywordMask mask) {
+    mask &= validMask_;
+    if (mask >= variantCount_) return nullptr;
+
+    Shader* variant = variants_[mask].load(std::memory_order_acquire);
+    if (variant || !Prepare(mask)) return variant;
+    return variants_[mask].load(std::memory_order_acquire);
+}
+
+bool ShaderPermutations::Prepare(KeywordMask mask) {
+    mask &= validMask_;
+    if (mask >= variantCount_) return false;
+    if (variants_[mask].load(std::memory_order_acquire)) return true;
+    if (failed_[mask].load(std::memory_order_relaxed)) return false;
+
+    auto shader = std::make_unique<Shader>();
+    if (!shader->LoadFromSource(vertex_.source, pixel_.source, device_,
+                                BuildDefines(vertex_.keywords, ToStageMask(vertex_, mask)),
+                                BuildDefines(pixel_.keywords, ToStageMask(pixel_, mask)))) {
+        Logger::Error("Failed to build shader variant " + std::to_string(mask));
+        failed_[mask].store(true, std::memory_order_relaxed);
+        return false;
+    }
+
+    Shader* expected = nullptr;
+    if (variants_[mask].compare_exchange_strong(expected, shader.get(), std::memory_order_acq_rel)) {
+        shader.release();
+    }
+    return true;
+}
+
+bool ShaderPermutations::IsCompiled(KeywordMask mask) const {
+    mask &= validMask_;
+    return mask < variantCount_ && variants_[mask].load(std::memory_order_acquire) != nullptr;
+}
+
+ShaderPermutations::KeywordMask ShaderPermutations::ToStageMask(const Stage& stage, KeywordMask mask) {
+    KeywordMask stageMask = 0;
+    for (size_t i = 0; i < stage.bits.size(); ++i) {
+        if (mask & stage.bits[i]) stageMask |= KeywordMask(1) << i;
+    }
+    return stageMask;
+}
+
+std::vector<std::string> ShaderPermutations::ParseKeywords(const std::string& source) {
+    std::vector<std::string> keywords;
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, sizeof(KEYWORDS_TAG) - 1, KEYWORDS_TAG) != 0) {
+            continue;
+        }
+
+        std::istringstream names(line.substr(start + sizeof(KEYWORDS_TAG) - 1));
+        std::string keyword;
+        while (names >> keyword) {
+            if (std::find(keywords.begin(), keywords.end(), keyword) == keywords.end()) {
+                keywords.push_back(keyword);
+            }
+        }
+    }
+    return keywords;
+}
+
+std::vector<ShaderCache::Define> ShaderPermutations::BuildDefines(const std::vector<std::string>& stageKeywords,
+                                                                  KeywordMask stageMask) {
+    std::vector<ShaderCache::Define> defines;
+    for (size_t i = 0; i < stageKeywords.size(); ++i) {
+        if (stageMask & (KeywordMask(1) << i)) {
+            defines.push_back({ stageKeywords[i], "1" });
+        }
+    }
+    return defines;
+}
+
+} // namespace Nexus
@@ -0,0 +1,81 @@
+#include "ShaderWarmup.h"
+#include "ResourceManager.h"
+#include "Texture.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace Nexus {
+
+ShaderWarmup::ShaderWarmup()
+    : jobs_(nullptr)
+    , completed_(0)
+    , failed_(0)
+{
+}
+
+ShaderWarmup::~ShaderWarmup() {
+    Wait();
+}
+
+size_t ShaderWarmup::Start(const ResourceManager& resources, JobSystem* jobs) {
+    NEXUS_PROFILE_SCOPE("ShaderWarmup::Start");
+    Wait();
+
+    variants_.clear();
+    completed_.store(0, std::memory_order_relaxed);
+    failed_.store(0, std::memory_order_relaxed);
+
+    for (const auto& entry : resources.GetMaterials()) {
+        std::shared_ptr<ShaderPermutations> shader = entry.second->GetShader();
+        if (!shader) continue;
+
+        ShaderPermutations::KeywordMask mask = entry.second->GetShaderVariant();
+        if (shader->IsCompiled(mask)) continue;
+
+        auto duplicate = std::find_if(variants_.begin(), variants_.end(), [&](const Variant& variant) {
+            return variant.shader == shader && variant.mask == mask;
+        });
+        if (duplicate == variants_.end()) {
+            variants_.push_back({ shader, mask });
+        }
+    }
+
+    if (variants_.empty()) return 0;
+    Logger::Info("Shader warm-up: " + std::to_string(variants_.size()) + " variants");
+
+    jobs_ = jobs && jobs->IsInitialized() ? jobs : nullptr;
+    for (const Variant& variant : variants_) {
+        if (jobs_) {
+            // Compiles run behind a loading screen, so they can have the efficiency cores
+            jobs_->Execute([this, &variant]() { Build(variant); }, &counter_, JobAffinity::Efficiency);
+        } else {
+            Build(variant);
+        }
+    }
+    return variants_.size();
+}
+
+void ShaderWarmup::Build(const Variant& variant) {
+    NEXUS_PROFILE_SCOPE("ShaderWarmup::Build");
+    if (!variant.shader->Prepare(variant.mask)) {
+        failed_.fetch_add(1, std::memory_order_relaxed);
+    }
+    completed_.fetch_add(1, std::memory_order_release);
+}
+
+void ShaderWarmup::Wait() {
+    if (jobs_) {
+        jobs_->Wait(counter_);
+    }
+}
+
+ShaderWarmup::Progress ShaderWarmup::GetProgress() const {
+    Progress progress;
+    progress.total = variants_.size();
+    progress.completed = completed_.load(std::memory_order_acquire);
+    progress.failed = failed_.load(std::memory_order_relaxed);
+    return progress;
+}
+
+} // namespace Nexus
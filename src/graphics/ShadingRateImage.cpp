@@ -0,0 +1,238 @@
+#include "ShadingRateImage.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <d3d12.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// One group per tile. Each thread takes one pixel's luminance steps to its right and lower
+// neighbours, the group sums them, and thread 0 picks the rate
+const char* BUILD_SHADER = R"(
+    #define TILE_SIZE 16
+    #define TILE_PIXELS (TILE_SIZE * TILE_SIZE)
+
+    cbuffer RateConstants : register(b0)
+    {
+        uint2 SourceSize;
+        float Threshold;
+        float MotionScale;
+        uint MaxRateLog2;
+        uint HasVelocity;
+        float2 Padding;
+    };
+
+    Texture2D<float4> Source : register(t0);
+    Texture2D<float2> Velocity : register(t1);
+    RWTexture2D<uint> Rates : register(u0);
+
+    // Squared steps along x and y, luminance, motion in pixels
+    groupshared float4 Sums[TILE_PIXELS];
+
+    float Luminance(uint2 pixel)
+    {
+        return dot(Source[min(pixel, SourceSize - 1)].rgb, float3(0.299f, 0.587f, 0.114f));
+    }
+
+    // Coarsest level (0, 1, 2 for 1, 2, 4 pixels) whose estimated error stays under limit; going
+    // from half to quarter rate adds a little over twice the error
+    uint RateLog2(float error, float limit)
+    {
+        uint level = error * 2.13f < limit ? 2 : (error < limit ? 1 : 0);
+        return min(level, MaxRateLog2);
+    }
+
+    [numthreads(TILE_SIZE, TILE_SIZE, 1)]
+    void main(uint3 id : SV_DispatchThreadID, uint3 group : SV_GroupID, uint index : SV_GroupIndex)
+    {
+        uint2 pixel = min(id.xy, SourceSize - 1);
+        float luminance = Luminance(pixel);
+        float stepX = Luminance(pixel + uint2(1, 0)) - luminance;
+        float stepY = Luminance(pixel + uint2(0, 1)) - luminance;
+        float motion = HasVelocity ? length(Velocity[pixel] * float2(SourceSize)) : 0.0f;
+        Sums[index] = float4(stepX * stepX, stepY * stepY, luminance, motion);
+        GroupMemoryBarrierWithGroupSync();
+
+        [unroll] for (uint stride = TILE_PIXELS / 2; stride > 0; stride >>= 1) {
+            if (index < stride) {
+                Sums[index] += Sums[index + stride];
+            }
+            GroupMemoryBarrierWithGroupSync();
+        }
+
+        if (index == 0) {
+            float4 mean = Sums[0] / TILE_PIXELS;
+            float blur = rsqrt(1.0f + mean.w * mean.w * MotionScale * MotionScale);
+            float limit = Threshold * (mean.z + 0.05f);
+            uint x = RateLog2(sqrt(mean.x) * blur, limit);
+            uint y = RateLog2(sqrt(mean.y) * blur, limit);
+
+            // Tier 2 has no 4x1 or 1x4
+            x = min(x, y + 1);
+            y = min(y, x + 1);
+            Rates[group.xy] = (x << 2) | y;
+        }
+    }
+)";
+
+// Matches RateConstants above
+struct GpuRateConstants {
+    UINT sourceSize[2];
+    float threshold;
+    float motionScale;
+    UINT maxRateLog2;
+    UINT hasVelocity;
+    float padding[2];
+};
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+} // namespace
+
+ShadingRateImage::ShadingRateImage()
+    : device_(nullptr)
+    , context_(nullptr)
+    , width_(0)
+    , height_(0)
+    , tilesX_(0)
+    , tilesY_(0)
+    , rateTexture_(nullptr)
+    , rateTarget_(nullptr)
+    , rateView_(nullptr)
+    , buildShader_(nullptr)
+    , constants_(nullptr)
+    , valid_(false)
+{
+}
+
+ShadingRateImage::~ShadingRateImage() {
+    Shutdown();
+}
+
+bool ShadingRateImage::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT width, UINT height,
+                                  const Settings& settings) {
+    Shutdown();
+    if (!device || !context || width == 0 || height == 0) return false;
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0) {
+        Logger::Warning("Shading-rate image needs feature level 11_0 compute shaders");
+        return false;
+    }
+
+    device_ = device;
+    context_ = context;
+    width_ = width;
+    height_ = height;
+    tilesX_ = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY_ = (height + TILE_SIZE - 1) / TILE_SIZE;
+    SetSettings(settings);
+
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(BUILD_SHADER, "ShadingRateBuild", "main", "cs_5_0", 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error("ShadingRateBuild compilation error: " + errors);
+        }
+        Shutdown();
+        return false;
+    }
+    hr = device_->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &buildShader_);
+    blob->Release();
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = tilesX_;
+    desc.Height = tilesY_;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8_UINT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+    if (SUCCEEDED(hr)) hr = device_->CreateTexture2D(&desc, nullptr, &rateTexture_);
+    if (SUCCEEDED(hr)) hr = device_->CreateUnorderedAccessView(rateTexture_, nullptr, &rateTarget_);
+    if (SUCCEEDED(hr)) hr = device_->CreateShaderResourceView(rateTexture_, nullptr, &rateView_);
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = sizeof(GpuRateConstants);
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (SUCCEEDED(hr)) hr = device_->CreateBuffer(&bufferDesc, nullptr, &constants_);
+
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create shading-rate image resources");
+        Shutdown();
+        return false;
+    }
+    Logger::Info("Shading-rate image created: " + std::to_string(tilesX_) + "x" + std::to_string(tilesY_) + " tiles");
+    return true;
+}
+
+void ShadingRateImage::Shutdown() {
+    SafeRelease(rateView_);
+    SafeRelease(rateTarget_);
+    SafeRelease(rateTexture_);
+    SafeRelease(buildShader_);
+    SafeRelease(constants_);
+    valid_ = false;
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+void ShadingRateImage::SetSettings(const Settings& settings) {
+    settings_ = settings;
+    settings_.threshold = std::max(settings_.threshold, 0.0f);
+    settings_.motionScale = std::max(settings_.motionScale, 0.0f);
+    settings_.maxRate = settings_.maxRate >= 4 ? 4 : (settings_.maxRate >= 2 ? 2 : 1);
+}
+
+void ShadingRateImage::Build(ID3D11ShaderResourceView* color, ID3D11ShaderResourceView* velocity) {
+    if (!device_ || !color) return;
+    NEXUS_PROFILE_SCOPE("ShadingRateImage::Build");
+
+    GpuRateConstants constants = {};
+    constants.sourceSize[0] = width_;
+    constants.sourceSize[1] = height_;
+    constants.threshold = settings_.threshold;
+    constants.motionScale = settings_.motionScale;
+    constants.maxRateLog2 = settings_.maxRate == 4 ? 2 : (settings_.maxRate == 2 ? 1 : 0);
+    constants.hasVelocity = velocity ? 1u : 0u;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+
+    ID3D11ShaderResourceView* inputs[2] = { color, velocity };
+    context_->CSSetShader(buildShader_, nullptr, 0);
+    context_->CSSetConstantBuffers(0, 1, &constants_);
+    context_->CSSetShaderResources(0, 2, inputs);
+    context_->CSSetUnorderedAccessViews(0, 1, &rateTarget_, nullptr);
+    context_->Dispatch(tilesX_, tilesY_, 1);
+
+    ID3D11ShaderResourceView* nullViews[2] = {};
+    ID3D11UnorderedAccessView* nullTarget = nullptr;
+    context_->CSSetShaderResources(0, 2, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+    context_->CSSetShader(nullptr, nullptr, 0);
+    valid_ = true;
+}
+
+bool ShadingRateImage::QueryHardwareSupport(ID3D12Device* device, UINT& tileSize) {
+    if (!device) return false;
+    D3D12_FEATURE_DATA_D3D12_OPTIONS6 options = {};
+    if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS6, &options, sizeof(options)))) {
+        return false;
+    }
+    tileSize = options.ShadingRateImageTileSize;
+    return options.VariableShadingRateTier >= D3D12_VARIABLE_SHADING_RATE_TIER_2;
+}
+
+} // namespace Nexus
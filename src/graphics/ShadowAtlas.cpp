@@ -0,0 +1,642 @@
+#include "ShadowAtlas.h"
+#include "Light.h"
+#include "Logger.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+
+// A light only shrinks once its importance drops this far below what its current size needs,
+// so lights near a size boundary do not redraw every frame
+constexpr float SHRINK_HYSTERESIS = 1.5f;
+// Lights without tiles are placed before every light that only wants a redraw
+constexpr float UNTILED_PRIORITY = 1e6f;
+constexpr float POSITION_EPSILON = 1e-4f;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+// Depth-only caster transform. Compressed meshes store UNORM16 positions across their bounds
+const char* CASTER_VS = R"(
+cbuffer CasterConstants : register(b0)
+{
+    float4x4 WorldViewProjection;
+    float4 PositionOffset;
+    float4 PositionScale;
+};
+
+float4 main(float4 position : POSITION) : SV_POSITION
+{
+#ifdef COMPRESSED_VERTEX
+    float3 p = PositionOffset.xyz + position.xyz * PositionScale.xyz;
+#else
+    float3 p = position.xyz;
+#endif
+    return mul(float4(p, 1.0f), WorldViewProjection);
+}
+)";
+
+// Fullscreen triangle on the far plane; drawn with depth writes and no pixel shader it clears
+// just the tile the viewport covers
+const char* CLEAR_VS = R"(
+float4 main(uint id : SV_VertexID) : SV_POSITION
+{
+    float2 uv = float2((id << 1) & 2, id & 2);
+    return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 1.0f, 1.0f);
+}
+)";
+
+// Matches CasterConstants above
+struct GpuCasterConstants {
+    XMFLOAT4X4 worldViewProjection;
+    XMFLOAT4 positionOffset;
+    XMFLOAT4 positionScale;
+};
+
+// Cube face directions and up vectors in D3D TextureCube order
+const XMFLOAT3 FACE_DIRECTIONS[6] = {
+    { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+    { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+};
+const XMFLOAT3 FACE_UPS[6] = {
+    { 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f },
+    { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+};
+
+ID3DBlob* CompileShader(const char* source, const char* name, const char* target,
+                        const std::vector<ShaderCache::Define>& defines = {}) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors, defines);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+UINT FloorPowerOfTwo(UINT value) {
+    UINT result = 1;
+    while (result <= value / 2) result *= 2;
+    return result;
+}
+
+bool SphereIntersectsBox(const XMFLOAT3& center, float radius, const AABB& box) {
+    float dx = std::max({ box.min.x - center.x, 0.0f, center.x - box.max.x });
+    float dy = std::max({ box.min.y - center.y, 0.0f, center.y - box.max.y });
+    float dz = std::max({ box.min.z - center.z, 0.0f, center.z - box.max.z });
+    return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+bool NearlyEqual(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return std::fabs(a.x - b.x) <= POSITION_EPSILON && std::fabs(a.y - b.y) <= POSITION_EPSILON &&
+           std::fabs(a.z - b.z) <= POSITION_EPSILON;
+}
+
+} // namespace
+
+void ShadowAtlas::QuadtreeAllocator::Reset(UINT size, UINT minSize) {
+    nodes_.clear();
+    Node root;
+    root.rect.size = size;
+    nodes_.push_back(root);
+    minSize_ = minSize;
+    freeTexels_ = size * size;
+}
+
+uint32_t ShadowAtlas::QuadtreeAllocator::Allocate(UINT size) {
+    if (nodes_.empty() || size < minSize_ || size > nodes_[0].rect.size || (size & (size - 1)) != 0) {
+        return INVALID;
+    }
+    // Fill holes in split nodes first; only split a free node when none is left
+    uint32_t node = Find(0, size, false);
+    if (node == INVALID) node = Find(0, size, true);
+    if (node != INVALID) freeTexels_ -= size * size;
+    return node;
+}
+
+uint32_t ShadowAtlas::QuadtreeAllocator::Find(uint32_t node, UINT size, bool splitFree) {
+    // Indices, not references: splitting grows nodes_
+    const UINT nodeSize = nodes_[node].rect.size;
+    switch (nodes_[node].state) {
+    case State::Used:
+        return INVALID;
+
+    case State::Free:
+        if (nodeSize == size) {
+            nodes_[node].state = State::Used;
+            return node;
+        }
+        if (!splitFree) return INVALID;
+        if (nodes_[node].firstChild == INVALID) {
+            const Rect rect = nodes_[node].rect;
+            const UINT half = rect.size / 2;
+            nodes_[node].firstChild = static_cast<uint32_t>(nodes_.size());
+            for (UINT i = 0; i < 4; ++i) {
+                Node child;
+                child.rect.x = rect.x + (i & 1) * half;
+                child.rect.y = rect.y + (i >> 1) * half;
+                child.rect.size = half;
+                child.parent = node;
+                nodes_.push_back(child);
+            }
+        } else {
+            // Children left over from an earlier merge
+            for (UINT i = 0; i < 4; ++i) nodes_[nodes_[node].firstChild + i].state = State::Free;
+        }
+        nodes_[node].state = State::Split;
+        return Find(nodes_[node].firstChild, size, true);
+
+    case State::Split:
+        if (nodeSize == size) return INVALID;
+        for (UINT i = 0; i < 4; ++i) {
+            uint32_t found = Find(nodes_[node].firstChild + i, size, splitFree);
+            if (found != INVALID) return found;
+        }
+        return INVALID;
+    }
+    return INVALID;
+}
+
+void ShadowAtlas::QuadtreeAllocator::Free(uint32_t node) {
+    if (node >= nodes_.size() || nodes_[node].state != State::Used) return;
+    nodes_[node].state = State::Free;
+    freeTexels_ += nodes_[node].rect.size * nodes_[node].rect.size;
+
+    // Merge upward while all four siblings are free
+    for (uint32_t parent = nodes_[node].parent; parent != INVALID; parent = nodes_[parent].parent) {
+        const uint32_t first = nodes_[parent].firstChild;
+        for (UINT i = 0; i < 4; ++i) {
+            if (nodes_[first + i].state != State::Free) return;
+        }
+        nodes_[parent].state = State::Free;
+    }
+}
+
+ShadowAtlas::QuadtreeAllocator::Rect ShadowAtlas::QuadtreeAllocator::GetRect(uint32_t node) const {
+    return node < nodes_.size() ? nodes_[node].rect : Rect();
+}
+
+ShadowAtlas::ShadowAtlas()
+    : device_(nullptr)
+    , context_(nullptr)
+    , stateCache_(nullptr)
+    , atlasTexture_(nullptr)
+    , atlasView_(nullptr)
+    , atlasTarget_(nullptr)
+    , tileBuffer_(nullptr)
+    , tileView_(nullptr)
+    , casterShaders_{}
+    , casterLayouts_{}
+    , clearShader_(nullptr)
+    , casterConstants_(nullptr)
+    , casterState_(nullptr)
+    , depthState_(nullptr)
+    , overwriteState_(nullptr)
+    , frame_(0)
+    , tilesChanged_(false)
+{
+}
+
+ShadowAtlas::~ShadowAtlas() {
+    Shutdown();
+}
+
+bool ShadowAtlas::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                             const Settings& settings) {
+    Shutdown();
+    if (!device || !context || !stateCache) return false;
+
+    device_ = device;
+    context_ = context;
+    stateCache_ = stateCache;
+    settings_ = settings;
+    // Power-of-two sizes throughout, so every tile is a quadtree node
+    settings_.resolution = FloorPowerOfTwo(std::clamp(settings_.resolution, 256u,
+                                                      static_cast<UINT>(D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)));
+    settings_.maxTileSize = FloorPowerOfTwo(std::clamp(settings_.maxTileSize, 16u, settings_.resolution));
+    settings_.minTileSize = FloorPowerOfTwo(std::clamp(settings_.minTileSize, 16u, settings_.maxTileSize));
+    settings_.maxTileUpdatesPerFrame = std::max(settings_.maxTileUpdatesPerFrame, TILES_PER_LIGHT);
+    settings_.fullCoverage = std::max(settings_.fullCoverage, 0.01f);
+
+    if (!CreateResources() || !CreateShaders()) {
+        Logger::Error("Failed to create shadow atlas resources");
+        Shutdown();
+        return false;
+    }
+
+    allocator_.Reset(settings_.resolution, settings_.minTileSize);
+    entries_.clear();
+    freeSlots_.clear();
+    for (UINT slot = MAX_SHADOWED_LIGHTS; slot-- > 0;) freeSlots_.push_back(slot);
+    tiles_.assign(MAX_SHADOWED_LIGHTS * TILES_PER_LIGHT, Tile());
+    frame_ = 0;
+    tilesChanged_ = true;
+    Logger::Info("Shadow atlas initialized: " + std::to_string(settings_.resolution) + "^2, tiles " +
+                 std::to_string(settings_.minTileSize) + "-" + std::to_string(settings_.maxTileSize));
+    return true;
+}
+
+void ShadowAtlas::Shutdown() {
+    SafeRelease(atlasTarget_);
+    SafeRelease(atlasView_);
+    SafeRelease(atlasTexture_);
+    SafeRelease(tileView_);
+    SafeRelease(tileBuffer_);
+    for (UINT i = 0; i < 2; ++i) {
+        SafeRelease(casterShaders_[i]);
+        SafeRelease(casterLayouts_[i]);
+    }
+    SafeRelease(clearShader_);
+    SafeRelease(casterConstants_);
+    SafeRelease(casterState_);
+    SafeRelease(depthState_);
+    SafeRelease(overwriteState_);
+    entries_.clear();
+    device_ = nullptr;
+    context_ = nullptr;
+    stateCache_ = nullptr;
+}
+
+bool ShadowAtlas::CreateResources() {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = settings_.resolution;
+    desc.Height = settings_.resolution;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R32_TYPELESS;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &atlasTexture_))) return false;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    viewDesc.Texture2D.MipLevels = 1;
+    if (FAILED(device_->CreateShaderResourceView(atlasTexture_, &viewDesc, &atlasView_))) return false;
+
+    D3D11_DEPTH_STENCIL_VIEW_DESC targetDesc = {};
+    targetDesc.Format = DXGI_FORMAT_D32_FLOAT;
+    targetDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+    if (FAILED(device_->CreateDepthStencilView(atlasTexture_, &targetDesc, &atlasTarget_))) return false;
+    context_->ClearDepthStencilView(atlasTarget_, D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+    D3D11_BUFFER_DESC buffer = {};
+    buffer.Usage = D3D11_USAGE_DYNAMIC;
+    buffer.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    buffer.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    buffer.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    buffer.StructureByteStride = sizeof(Tile);
+    buffer.ByteWidth = sizeof(Tile) * MAX_SHADOWED_LIGHTS * TILES_PER_LIGHT;
+    if (FAILED(device_->CreateBuffer(&buffer, nullptr, &tileBuffer_))) return false;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC tileViewDesc = {};
+    tileViewDesc.Format = DXGI_FORMAT_UNKNOWN;
+    tileViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    tileViewDesc.Buffer.NumElements = MAX_SHADOWED_LIGHTS * TILES_PER_LIGHT;
+    if (FAILED(device_->CreateShaderResourceView(tileBuffer_, &tileViewDesc, &tileView_))) return false;
+
+    D3D11_RASTERIZER_DESC rasterizer = {};
+    rasterizer.FillMode = D3D11_FILL_SOLID;
+    rasterizer.CullMode = D3D11_CULL_BACK;
+    rasterizer.DepthBias = settings_.depthBias;
+    rasterizer.SlopeScaledDepthBias = settings_.slopeScaledDepthBias;
+    rasterizer.DepthClipEnable = TRUE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizer, &casterState_))) return false;
+
+    D3D11_DEPTH_STENCIL_DESC depth = {};
+    depth.DepthEnable = TRUE;
+    depth.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+    depth.DepthFunc = D3D11_COMPARISON_LESS;
+    if (FAILED(device_->CreateDepthStencilState(&depth, &depthState_))) return false;
+    depth.DepthFunc = D3D11_COMPARISON_ALWAYS;
+    if (FAILED(device_->CreateDepthStencilState(&depth, &overwriteState_))) return false;
+
+    D3D11_BUFFER_DESC constants = {};
+    constants.Usage = D3D11_USAGE_DYNAMIC;
+    constants.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constants.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    constants.ByteWidth = sizeof(GpuCasterConstants);
+    return SUCCEEDED(device_->CreateBuffer(&constants, nullptr, &casterConstants_));
+}
+
+bool ShadowAtlas::CreateShaders() {
+    std::vector<ShaderCache::Define> compressed = {{COMPRESSED_VERTEX_KEYWORD, "1"}};
+    for (UINT format = 0; format < 2; ++format) {
+        ID3DBlob* blob = CompileShader(CASTER_VS, "AtlasCaster_VS", "vs_5_0",
+                                       format ? compressed : std::vector<ShaderCache::Define>());
+        if (!blob) return false;
+
+        UINT elementCount = 0;
+        const D3D11_INPUT_ELEMENT_DESC* elements = Mesh::GetInputLayout(static_cast<VertexFormat>(format), elementCount);
+        HRESULT hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr,
+                                                 &casterShaders_[format]);
+        if (SUCCEEDED(hr)) {
+            hr = device_->CreateInputLayout(elements, elementCount, blob->GetBufferPointer(), blob->GetBufferSize(),
+                                            &casterLayouts_[format]);
+        }
+        blob->Release();
+        if (FAILED(hr)) return false;
+    }
+
+    ID3DBlob* blob = CompileShader(CLEAR_VS, "AtlasClear_VS", "vs_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &clearShader_);
+    blob->Release();
+    return SUCCEEDED(hr);
+}
+
+UINT ShadowAtlas::ComputeTileSize(float screenFraction, const Settings& settings) {
+    float texels = settings.maxTileSize * std::min(screenFraction / settings.fullCoverage, 1.0f);
+    UINT size = settings.minTileSize;
+    while (size < settings.maxTileSize && static_cast<float>(size) < texels) size *= 2;
+    return size;
+}
+
+void ShadowAtlas::InvalidateStatic() {
+    for (auto& pair : entries_) pair.second.dirty = true;
+}
+
+void ShadowAtlas::InvalidateStatic(const AABB& bounds) {
+    for (auto& pair : entries_) {
+        Entry& entry = pair.second;
+        if (SphereIntersectsBox(entry.position, entry.range, bounds)) entry.dirty = true;
+    }
+}
+
+int ShadowAtlas::GetFirstTile(int lightId) const {
+    auto it = entries_.find(lightId);
+    if (it == entries_.end() || it->second.tileSize == 0) return -1;
+    return static_cast<int>(it->second.slot * TILES_PER_LIGHT);
+}
+
+void ShadowAtlas::Update(const std::vector<const Light*>& lights, FXMMATRIX view, CXMMATRIX projection) {
+    NEXUS_PROFILE_SCOPE("ShadowAtlas::Update");
+    if (!device_) return;
+    stats_ = Stats();
+    frame_++;
+
+    const Frustum frustum = Frustum::FromViewProjection(XMMatrixMultiply(view, projection));
+    XMFLOAT4X4 p;
+    XMStoreFloat4x4(&p, projection);
+    XMFLOAT3 eye;
+    XMStoreFloat3(&eye, XMMatrixInverse(nullptr, view).r[3]);
+
+    // Score every visible shadowed light and note which ones need drawing
+    candidates_.clear();
+    for (const Light* light : lights) {
+        if (!light || !light->CastsShadows() || light->GetType() == LightType::Directional) continue;
+        const float range = light->GetRange();
+        if (range <= settings_.nearPlane) continue;
+        const XMFLOAT3& position = light->GetPosition();
+        if (!frustum.Intersects(AABB::FromCenterExtents(position, XMFLOAT3(range, range, range)))) continue;
+
+        // Projected diameter of the range sphere over the screen height
+        float dx = position.x - eye.x, dy = position.y - eye.y, dz = position.z - eye.z;
+        float distanceSq = dx * dx + dy * dy + dz * dz;
+        float importance = distanceSq <= range * range
+            ? settings_.fullCoverage
+            : range * p._22 / std::sqrt(distanceSq - range * range);
+
+        auto it = entries_.find(light->GetId());
+        if (it == entries_.end()) {
+            if (freeSlots_.empty()) continue;
+            Entry entry;
+            entry.slot = freeSlots_.back();
+            freeSlots_.pop_back();
+            it = entries_.emplace(light->GetId(), entry).first;
+        }
+        Entry& entry = it->second;
+        entry.lastSeen = frame_;
+        entry.importance = importance;
+
+        const bool spot = light->GetType() == LightType::Spot;
+        const UINT faceCount = spot ? 1 : TILES_PER_LIGHT;
+        if (!NearlyEqual(entry.position, position) || entry.range != range ||
+            (spot && (!NearlyEqual(entry.direction, light->GetDirection()) || entry.coneAngle != light->GetConeAngle()))) {
+            entry.position = position;
+            entry.direction = light->GetDirection();
+            entry.range = range;
+            entry.coneAngle = light->GetConeAngle();
+            entry.dirty = true;
+        }
+        for (const Caster& caster : casters_) {
+            if (entry.dirty) break;
+            if (caster.dynamic && SphereIntersectsBox(position, range, caster.bounds)) entry.dirty = true;
+        }
+
+        UINT wanted = ComputeTileSize(importance, settings_);
+        if (entry.tileSize != 0 && wanted < entry.tileSize &&
+            ComputeTileSize(importance * SHRINK_HYSTERESIS, settings_) >= entry.tileSize) {
+            wanted = entry.tileSize;
+        }
+        const bool retile = entry.tileSize != wanted || entry.faceCount != faceCount;
+        if (!retile && !entry.dirty) continue;
+
+        Candidate candidate;
+        candidate.lightId = light->GetId();
+        candidate.light = light;
+        candidate.wantedSize = wanted;
+        candidate.priority = entry.tileSize == 0
+            ? UNTILED_PRIORITY + importance
+            : importance * static_cast<float>(frame_ - entry.lastRendered);
+        candidates_.push_back(candidate);
+    }
+
+    // Lights that left the view or the list give their tiles back before anyone allocates
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.lastSeen != frame_) {
+            ReleaseTiles(it->second);
+            freeSlots_.push_back(it->second.slot);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::sort(candidates_.begin(), candidates_.end(),
+              [](const Candidate& a, const Candidate& b) { return a.priority > b.priority; });
+
+    UINT budget = settings_.maxTileUpdatesPerFrame;
+    bool bound = false;
+    for (const Candidate& candidate : candidates_) {
+        Entry& entry = entries_[candidate.lightId];
+        const UINT faceCount = candidate.light->GetType() == LightType::Spot ? 1 : TILES_PER_LIGHT;
+        if (faceCount > budget) {
+            stats_.lightsDeferred++;
+            continue;
+        }
+        if (entry.tileSize != candidate.wantedSize || entry.faceCount != faceCount) {
+            ReleaseTiles(entry);
+            if (!AllocateTiles(entry, faceCount, candidate.wantedSize)) {
+                stats_.lightsDeferred++;
+                continue;
+            }
+        }
+
+        if (!bound) {
+            // One target for every tile; only the viewport changes between them
+            stateCache_->OMSetRenderTargets(0, nullptr, atlasTarget_);
+            stateCache_->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+            stateCache_->RSSetState(casterState_);
+            stateCache_->PSSetShader(nullptr);
+            stateCache_->VSSetConstantBuffers(0, 1, &casterConstants_);
+            bound = true;
+        }
+        RenderLight(entry, *candidate.light);
+        budget -= faceCount;
+        stats_.lightsUpdated++;
+    }
+
+    for (const auto& pair : entries_) {
+        if (pair.second.tileSize != 0) stats_.lightsShadowed++;
+    }
+    UploadTiles();
+}
+
+void ShadowAtlas::ReleaseTiles(Entry& entry) {
+    for (UINT face = 0; face < entry.faceCount; ++face) {
+        allocator_.Free(entry.nodes[face]);
+    }
+    if (entry.tileSize != 0) tilesChanged_ = true;
+    entry.faceCount = 0;
+    entry.tileSize = 0;
+    entry.dirty = true;
+}
+
+bool ShadowAtlas::TryAllocate(Entry& entry, UINT faceCount, UINT size) {
+    for (UINT face = 0; face < faceCount; ++face) {
+        entry.nodes[face] = allocator_.Allocate(size);
+        if (entry.nodes[face] == QuadtreeAllocator::INVALID) {
+            while (face-- > 0) allocator_.Free(entry.nodes[face]);
+            return false;
+        }
+    }
+    entry.faceCount = faceCount;
+    entry.tileSize = size;
+    return true;
+}
+
+bool ShadowAtlas::AllocateTiles(Entry& entry, UINT faceCount, UINT size) {
+    if (TryAllocate(entry, faceCount, size)) return true;
+
+    // Evict the least important lights not drawn this frame until the tiles fit
+    for (;;) {
+        Entry* victim = nullptr;
+        for (auto& pair : entries_) {
+            Entry& other = pair.second;
+            if (&other == &entry || other.tileSize == 0 || other.lastRendered == frame_ ||
+                other.importance >= entry.importance) {
+                continue;
+            }
+            if (!victim || other.importance < victim->importance) victim = &other;
+        }
+        if (!victim) break;
+        ReleaseTiles(*victim);
+        stats_.evictions++;
+        if (TryAllocate(entry, faceCount, size)) return true;
+    }
+
+    for (UINT smaller = size / 2; smaller >= settings_.minTileSize; smaller /= 2) {
+        if (TryAllocate(entry, faceCount, smaller)) return true;
+    }
+    return false;
+}
+
+XMMATRIX ShadowAtlas::BuildFaceViewProjection(const Light& light, UINT face) const {
+    XMVECTOR position = XMLoadFloat3(&light.GetPosition());
+    if (light.GetType() == LightType::Spot) {
+        XMVECTOR forward = XMVector3Normalize(XMLoadFloat3(&light.GetDirection()));
+        XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+        if (std::fabs(XMVectorGetY(forward)) > 0.99f) {
+            up = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+        }
+        float fov = std::clamp(light.GetConeAngle() * 2.0f, 0.01f, XM_PI * 0.95f);
+        return XMMatrixMultiply(XMMatrixLookToLH(position, forward, up),
+                                XMMatrixPerspectiveFovLH(fov, 1.0f, settings_.nearPlane, light.GetRange()));
+    }
+    return XMMatrixMultiply(XMMatrixLookToLH(position, XMLoadFloat3(&FACE_DIRECTIONS[face]), XMLoadFloat3(&FACE_UPS[face])),
+                            XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, settings_.nearPlane, light.GetRange()));
+}
+
+void ShadowAtlas::RenderLight(Entry& entry, const Light& light) {
+    const float atlasSize = static_cast<float>(settings_.resolution);
+    for (UINT face = 0; face < entry.faceCount; ++face) {
+        QuadtreeAllocator::Rect rect = allocator_.GetRect(entry.nodes[face]);
+        D3D11_VIEWPORT viewport = {};
+        viewport.TopLeftX = static_cast<float>(rect.x);
+        viewport.TopLeftY = static_cast<float>(rect.y);
+        viewport.Width = static_cast<float>(rect.size);
+        viewport.Height = static_cast<float>(rect.size);
+        viewport.MaxDepth = 1.0f;
+        stateCache_->RSSetViewports(1, &viewport);
+
+        // Clear the tile alone, the rest of the atlas keeps other lights' shadows
+        stateCache_->OMSetDepthStencilState(overwriteState_, 0);
+        stateCache_->IASetInputLayout(nullptr);
+        stateCache_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        stateCache_->VSSetShader(clearShader_);
+        context_->Draw(3, 0);
+
+        stateCache_->OMSetDepthStencilState(depthState_, 0);
+        XMMATRIX viewProjection = BuildFaceViewProjection(light, face);
+        Frustum frustum = Frustum::FromViewProjection(viewProjection);
+        for (const Caster& caster : casters_) {
+            if (!caster.mesh || !frustum.Intersects(caster.bounds)) continue;
+
+            GpuCasterConstants constants;
+            XMStoreFloat4x4(&constants.worldViewProjection,
+                            XMMatrixTranspose(XMMatrixMultiply(XMLoadFloat4x4(&caster.world), viewProjection)));
+            XMFLOAT3 offset = caster.mesh->GetPositionOffset();
+            XMFLOAT3 scale = caster.mesh->GetPositionScale();
+            constants.positionOffset = XMFLOAT4(offset.x, offset.y, offset.z, 0.0f);
+            constants.positionScale = XMFLOAT4(scale.x, scale.y, scale.z, 0.0f);
+
+            D3D11_MAPPED_SUBRESOURCE mapped = {};
+            if (FAILED(context_->Map(casterConstants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) continue;
+            std::memcpy(mapped.pData, &constants, sizeof(constants));
+            context_->Unmap(casterConstants_, 0);
+
+            UINT format = caster.mesh->GetVertexFormat() == VertexFormat::Compressed ? 1 : 0;
+            stateCache_->IASetInputLayout(casterLayouts_[format]);
+            stateCache_->VSSetShader(casterShaders_[format]);
+            caster.mesh->Render(context_);
+            stats_.castersDrawn++;
+        }
+
+        // Clip xy in [-1, 1] maps onto the tile, y flipped
+        Tile& tile = tiles_[entry.slot * TILES_PER_LIGHT + face];
+        XMStoreFloat4x4(&tile.viewProjection, XMMatrixTranspose(viewProjection));
+        const float half = 0.5f * rect.size / atlasSize;
+        tile.scaleOffset = XMFLOAT4(half, -half, rect.x / atlasSize + half, rect.y / atlasSize + half);
+        stats_.tilesRendered++;
+    }
+    entry.lastRendered = frame_;
+    entry.dirty = false;
+    tilesChanged_ = true;
+}
+
+void ShadowAtlas::UploadTiles() {
+    if (!tilesChanged_) return;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(tileBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, tiles_.data(), tiles_.size() * sizeof(Tile));
+    context_->Unmap(tileBuffer_, 0);
+    tilesChanged_ = false;
+}
+
+} // namespace Nexus
@@ -0,0 +1,628 @@
+#include "SkinningSystem.h"
+#include "Mesh.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace Nexus {
+
+namespace {
+// One thread per vertex. Bone indices are relative to the instance's palette and weights are
+// renormalized, so a vertex exported with less than four influences still sums to one
+const char* SKINNING_SHADER = R"(
+    cbuffer SkinConstants : register(b0)
+    {
+        uint VertexCount;
+        uint FirstBone;
+        uint BoneCount;
+        uint BaseVertex;
+        uint MorphBase;
+        uint UseMorph;
+    };
+
+    ByteAddressBuffer Vertices : register(t0);
+    StructuredBuffer<float4> Palette : register(t1);
+    ByteAddressBuffer Morph : register(t2);
+    RWByteAddressBuffer Output : register(u0);
+
+    static const uint INPUT_STRIDE = 56;
+    static const uint OUTPUT_STRIDE = 44;
+    static const uint MORPH_STRIDE = 24;
+
+    float3x4 LoadBone(uint index)
+    {
+        uint row = (FirstBone + min(index, BoneCount - 1)) * 3;
+        return float3x4(Palette[row], Palette[row + 1], Palette[row + 2]);
+    }
+
+    [numthreads(64, 1, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (id.x >= VertexCount) return;
+
+        uint input = id.x * INPUT_STRIDE;
+        float3 position = asfloat(Vertices.Load3(input));
+        float3 normal = asfloat(Vertices.Load3(input + 12));
+        float3 tangent = asfloat(Vertices.Load3(input + 24));
+        uint2 texCoord = Vertices.Load2(input + 36);
+        uint2 packedIndices = Vertices.Load2(input + 44);
+        uint packedWeights = Vertices.Load(input + 52);
+
+        if (UseMorph != 0)
+        {
+            uint morph = (MorphBase + id.x) * MORPH_STRIDE;
+            position += asfloat(Morph.Load3(morph));
+            normal += asfloat(Morph.Load3(morph + 12));
+        }
+
+        uint4 indices = uint4(packedIndices.x & 0xFFFF, packedIndices.x >> 16, packedIndices.y & 0xFFFF, packedIndices.y >> 16);
+        float4 weights = float4(packedWeights & 0xFF, (packedWeights >> 8) & 0xFF,
+                                (packedWeights >> 16) & 0xFF, packedWeights >> 24);
+        float total = dot(weights, float4(1.0f, 1.0f, 1.0f, 1.0f));
+        weights = total > 0.0f ? weights / total : float4(1.0f, 0.0f, 0.0f, 0.0f);
+
+        float3x4 skin = LoadBone(indices.x) * weights.x;
+        if (weights.y > 0.0f) skin += LoadBone(indices.y) * weights.y;
+        if (weights.z > 0.0f) skin += LoadBone(indices.z) * weights.z;
+        if (weights.w > 0.0f) skin += LoadBone(indices.w) * weights.w;
+
+        float3 posedPosition = mul(skin, float4(position, 1.0f));
+        float3 posedNormal = normalize(mul((float3x3)skin, normal));
+        float3 posedTangent = normalize(mul((float3x3)skin, tangent));
+
+        uint output = (BaseVertex + id.x) * OUTPUT_STRIDE;
+        Output.Store3(output, asuint(posedPosition));
+        Output.Store3(output + 12, asuint(posedNormal));
+        Output.Store3(output + 24, asuint(posedTangent));
+        Output.Store2(output + 36, texCoord);
+    }
+)";
+
+// One thread per delta of one shape. A shape lists each vertex once, so threads never collide,
+// and shapes run as separate dispatches that the runtime orders
+const char* MORPH_SHADER = R"(
+    cbuffer MorphConstants : register(b0)
+    {
+        uint FirstDelta;
+        uint DeltaCount;
+        float Weight;
+        uint MorphBase;
+    };
+
+    ByteAddressBuffer Deltas : register(t0);
+    RWByteAddressBuffer Accumulation : register(u0);
+
+    static const uint DELTA_STRIDE = 28;
+    static const uint MORPH_STRIDE = 24;
+
+    [numthreads(64, 1, 1)]
+    void main(uint3 id : SV_DispatchThreadID)
+    {
+        if (id.x >= DeltaCount) return;
+
+        uint delta = (FirstDelta + id.x) * DELTA_STRIDE;
+        uint vertex = Deltas.Load(delta);
+        float3 deltaPosition = asfloat(Deltas.Load3(delta + 4));
+        float3 deltaNormal = asfloat(Deltas.Load3(delta + 16));
+
+        uint morph = (MorphBase + vertex) * MORPH_STRIDE;
+        Accumulation.Store3(morph, asuint(asfloat(Accumulation.Load3(morph)) + deltaPosition * Weight));
+        Accumulation.Store3(morph + 12, asuint(asfloat(Accumulation.Load3(morph + 12)) + deltaNormal * Weight));
+    }
+)";
+
+constexpr UINT THREADS_PER_GROUP = 64;
+constexpr UINT ROWS_PER_BONE = 3;
+
+struct SkinConstants {
+    UINT vertexCount;
+    UINT firstBone;
+    UINT boneCount;
+    UINT baseVertex;
+    UINT morphBase;
+    UINT useMorph;
+    UINT padding[2];
+};
+
+struct MorphConstants {
+    UINT firstDelta;
+    UINT deltaCount;
+    float weight;
+    UINT morphBase;
+};
+
+// Layout of one record in MorphTargets::buffer
+struct MorphDelta {
+    uint32_t vertex;
+    DirectX::XMFLOAT3 position;
+    DirectX::XMFLOAT3 normal;
+};
+static_assert(sizeof(MorphDelta) == 28, "MorphDelta must match the morph shader");
+
+// Per vertex in the accumulation buffer: summed position and normal deltas
+constexpr UINT MORPH_STRIDE = 24;
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+bool IsZero(const DirectX::XMFLOAT3& v) {
+    return v.x == 0.0f && v.y == 0.0f && v.z == 0.0f;
+}
+
+ID3D11ComputeShader* CompileComputeShader(ID3D11Device* device, const char* source, const char* name) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", "cs_5_0", 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+
+    ID3D11ComputeShader* shader = nullptr;
+    hr = device->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &shader);
+    blob->Release();
+    return SUCCEEDED(hr) ? shader : nullptr;
+}
+
+template<typename T>
+void WriteConstants(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const T& data) {
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (SUCCEEDED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        std::memcpy(mapped.pData, &data, sizeof(T));
+        context->Unmap(buffer, 0);
+    }
+}
+}
+
+struct SkinningSystem::MorphTargets {
+    struct Shape {
+        UINT firstDelta;
+        UINT deltaCount;
+    };
+
+    ~MorphTargets() {
+        SafeRelease(view);
+        SafeRelease(buffer);
+    }
+
+    ID3D11Buffer* buffer = nullptr;
+    ID3D11ShaderResourceView* view = nullptr;
+    UINT vertexCount = 0;                     // Highest vertex moved plus one
+    std::vector<Shape> shapes;                // Parallel to FacialAnimation::blendShapes
+};
+
+SkinningSystem::SkinningSystem()
+    : device_(nullptr)
+    , context_(nullptr)
+    , skinShader_(nullptr)
+    , skinConstants_(nullptr)
+    , morphShader_(nullptr)
+    , morphConstants_(nullptr)
+    , paletteBuffer_(nullptr)
+    , paletteView_(nullptr)
+    , paletteCapacity_(0)
+    , outputBuffer_(nullptr)
+    , outputTarget_(nullptr)
+    , outputView_(nullptr)
+    , outputCapacity_(0)
+    , verticesThisFrame_(0)
+    , previousBuffer_(nullptr)
+    , previousTarget_(nullptr)
+    , previousView_(nullptr)
+    , previousCapacity_(0)
+    , keepPreviousFrame_(false)
+    , morphBuffer_(nullptr)
+    , morphTarget_(nullptr)
+    , morphView_(nullptr)
+    , morphCapacity_(0)
+    , morphVerticesThisFrame_(0)
+    , dispatched_(false)
+{
+}
+
+SkinningSystem::~SkinningSystem() {
+    Shutdown();
+}
+
+bool SkinningSystem::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    if (!device || !context) return false;
+    device_ = device;
+    context_ = context;
+
+    if (device_->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0) {
+        Logger::Warning("GPU skinning needs feature level 11_0 compute shaders");
+        return false;
+    }
+
+    skinShader_ = CompileComputeShader(device_, SKINNING_SHADER, "Skinning");
+    D3D11_BUFFER_DESC constantsDesc = {};
+    constantsDesc.Usage = D3D11_USAGE_DYNAMIC;
+    constantsDesc.ByteWidth = sizeof(SkinConstants);
+    constantsDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constantsDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (!skinShader_ || FAILED(device_->CreateBuffer(&constantsDesc, nullptr, &skinConstants_))) {
+        Logger::Error("Failed to create skinning shader");
+        Shutdown();
+        return false;
+    }
+
+    // Without it instances still skin, just without blend shapes
+    morphShader_ = CompileComputeShader(device_, MORPH_SHADER, "Morph");
+    constantsDesc.ByteWidth = sizeof(MorphConstants);
+    if (!morphShader_ || FAILED(device_->CreateBuffer(&constantsDesc, nullptr, &morphConstants_))) {
+        Logger::Warning("Failed to create morph shader, blend shapes disabled");
+        SafeRelease(morphShader_);
+    }
+
+    if (!EnsurePaletteCapacity(INITIAL_BONE_CAPACITY) || !EnsureOutputCapacity(INITIAL_VERTEX_CAPACITY)) {
+        Logger::Error("Failed to create skinning buffers");
+        Shutdown();
+        return false;
+    }
+
+    Logger::Info("GPU skinning initialized");
+    return true;
+}
+
+void SkinningSystem::Shutdown() {
+    SafeRelease(morphView_);
+    SafeRelease(morphTarget_);
+    SafeRelease(morphBuffer_);
+    morphCapacity_ = 0;
+    SafeRelease(morphConstants_);
+    SafeRelease(morphShader_);
+    SafeRelease(outputView_);
+    SafeRelease(outputTarget_);
+    SafeRelease(outputBuffer_);
+    outputCapacity_ = 0;
+    SetKeepPreviousFrame(false);
+    SafeRelease(paletteView_);
+    SafeRelease(paletteBuffer_);
+    paletteCapacity_ = 0;
+    SafeRelease(skinConstants_);
+    SafeRelease(skinShader_);
+    instances_.clear();
+    morphPasses_.clear();
+    paletteRows_.clear();
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+bool SkinningSystem::EnsurePaletteCapacity(UINT boneCount) {
+    if (paletteBuffer_ && boneCount <= paletteCapacity_) return true;
+
+    UINT capacity = std::max(boneCount, paletteCapacity_ * 2);
+    SafeRelease(paletteView_);
+    SafeRelease(paletteBuffer_);
+    paletteCapacity_ = 0;
+
+    // Rewritten whole every frame
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = capacity * ROWS_PER_BONE * sizeof(DirectX::XMFLOAT4);
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    desc.StructureByteStride = sizeof(DirectX::XMFLOAT4);
+    if (FAILED(device_->CreateBuffer(&desc, nullptr, &paletteBuffer_))) {
+        Logger::Error("Failed to create bone palette buffer");
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    viewDesc.Buffer.NumElements = capacity * ROWS_PER_BONE;
+    if (FAILED(device_->CreateShaderResourceView(paletteBuffer_, &viewDesc, &paletteView_))) {
+        SafeRelease(paletteBuffer_);
+        return false;
+    }
+
+    paletteCapacity_ = capacity;
+    return true;
+}
+
+bool SkinningSystem::EnsureOutputCapacity(UINT vertexCount) {
+    if (outputBuffer_ && vertexCount <= outputCapacity_) return true;
+
+    UINT capacity = std::max(vertexCount, outputCapacity_ * 2);
+    SafeRelease(outputView_);
+    SafeRelease(outputTarget_);
+    SafeRelease(outputBuffer_);
+    outputCapacity_ = 0;
+
+    // Raw buffers may be both written by compute and read by the input assembler
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.ByteWidth = capacity * sizeof(Vertex);
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    if (FAILED(device_->CreateBuffer(&desc, nullptr, &outputBuffer_))) {
+        Logger::Error("Failed to create skinned vertex buffer");
+        return false;
+    }
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = desc.ByteWidth / 4;
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+    viewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+    viewDesc.BufferEx.NumElements = desc.ByteWidth / 4;
+    if (FAILED(device_->CreateUnorderedAccessView(outputBuffer_, &uavDesc, &outputTarget_)) ||
+        FAILED(device_->CreateShaderResourceView(outputBuffer_, &viewDesc, &outputView_))) {
+        SafeRelease(outputTarget_);
+        SafeRelease(outputBuffer_);
+        return false;
+    }
+
+    outputCapacity_ = capacity;
+    return true;
+}
+
+bool SkinningSystem::EnsureMorphCapacity(UINT vertexCount) {
+    if (morphBuffer_ && vertexCount <= morphCapacity_) return true;
+
+    UINT capacity = std::max(vertexCount, morphCapacity_ * 2);
+    SafeRelease(morphView_);
+    SafeRelease(morphTarget_);
+    SafeRelease(morphBuffer_);
+    morphCapacity_ = 0;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.ByteWidth = capacity * MORPH_STRIDE;
+    desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    if (FAILED(device_->CreateBuffer(&desc, nullptr, &morphBuffer_))) {
+        Logger::Error("Failed to create morph accumulation buffer");
+        return false;
+    }
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = desc.ByteWidth / 4;
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+    viewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+    viewDesc.BufferEx.NumElements = desc.ByteWidth / 4;
+    if (FAILED(device_->CreateUnorderedAccessView(morphBuffer_, &uavDesc, &morphTarget_)) ||
+        FAILED(device_->CreateShaderResourceView(morphBuffer_, &viewDesc, &morphView_))) {
+        SafeRelease(morphTarget_);
+        SafeRelease(morphBuffer_);
+        return false;
+    }
+
+    morphCapacity_ = capacity;
+    return true;
+}
+
+std::shared_ptr<SkinningSystem::MorphTargets> SkinningSystem::CreateMorphTargets(
+    const AnimationSystem::FacialAnimation& facial) {
+    if (!morphShader_) return nullptr;
+
+    // Dense shapes are made sparse here, so the GPU only ever walks vertices that move
+    auto morphs = std::make_shared<MorphTargets>();
+    std::vector<MorphDelta> deltas;
+    for (const auto& blendShape : facial.blendShapes) {
+        MorphTargets::Shape shape = { static_cast<UINT>(deltas.size()), 0 };
+        const bool sparse = !blendShape.vertexIndices.empty();
+        const size_t count = std::min(blendShape.deltaVertices.size(), blendShape.deltaNormals.size());
+        for (size_t i = 0; i < count; ++i) {
+            if (IsZero(blendShape.deltaVertices[i]) && IsZero(blendShape.deltaNormals[i])) continue;
+
+            MorphDelta delta = {};
+            delta.vertex = sparse ? blendShape.vertexIndices[i] : static_cast<uint32_t>(i);
+            delta.position = blendShape.deltaVertices[i];
+            delta.normal = blendShape.deltaNormals[i];
+            deltas.push_back(delta);
+            morphs->vertexCount = std::max(morphs->vertexCount, delta.vertex + 1);
+        }
+        shape.deltaCount = static_cast<UINT>(deltas.size()) - shape.firstDelta;
+        morphs->shapes.push_back(shape);
+    }
+    if (deltas.empty()) return nullptr;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.ByteWidth = static_cast<UINT>(deltas.size() * sizeof(MorphDelta));
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    D3D11_SUBRESOURCE_DATA data = {};
+    data.pSysMem = deltas.data();
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+    viewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+    viewDesc.BufferEx.NumElements = desc.ByteWidth / 4;
+    if (FAILED(device_->CreateBuffer(&desc, &data, &morphs->buffer)) ||
+        FAILED(device_->CreateShaderResourceView(morphs->buffer, &viewDesc, &morphs->view))) {
+        Logger::Error("Failed to create morph target buffer");
+        return nullptr;
+    }
+    return morphs;
+}
+
+void SkinningSystem::BeginFrame() {
+    if (keepPreviousFrame_) {
+        // Last frame's output becomes the previous one; the buffer before it is written next
+        if (!dispatched_ || instances_.empty()) {
+            motionKeys_.clear();
+        }
+        std::swap(outputBuffer_, previousBuffer_);
+        std::swap(outputTarget_, previousTarget_);
+        std::swap(outputView_, previousView_);
+        std::swap(outputCapacity_, previousCapacity_);
+        std::swap(motionKeys_, previousMotionKeys_);
+        motionKeys_.clear();
+    }
+
+    stats_ = Stats();
+    instances_.clear();
+    morphPasses_.clear();
+    paletteRows_.clear();
+    verticesThisFrame_ = 0;
+    morphVerticesThisFrame_ = 0;
+    dispatched_ = false;
+}
+
+bool SkinningSystem::AddInstance(const Mesh& mesh, const std::vector<DirectX::XMFLOAT4X4>& palette, UINT& baseVertex) {
+    if (!skinShader_ || dispatched_ || !mesh.GetVertexView() || palette.empty()) return false;
+
+    Instance instance = {};
+    instance.vertices = mesh.GetVertexView();
+    instance.vertexCount = static_cast<UINT>(mesh.GetVertexCount());
+    instance.firstBone = static_cast<UINT>(paletteRows_.size() / ROWS_PER_BONE);
+    instance.boneCount = static_cast<UINT>(palette.size());
+    instance.baseVertex = verticesThisFrame_;
+    instances_.push_back(instance);
+
+    // Columns of the row-vector matrices, so the shader transforms with three dot products
+    for (const DirectX::XMFLOAT4X4& bone : palette) {
+        paletteRows_.emplace_back(bone._11, bone._21, bone._31, bone._41);
+        paletteRows_.emplace_back(bone._12, bone._22, bone._32, bone._42);
+        paletteRows_.emplace_back(bone._13, bone._23, bone._33, bone._43);
+    }
+
+    baseVertex = verticesThisFrame_;
+    verticesThisFrame_ += instance.vertexCount;
+    return true;
+}
+
+bool SkinningSystem::AddInstance(const Mesh& mesh, const std::vector<DirectX::XMFLOAT4X4>& palette,
+                                 const MorphTargets& morphs, const AnimationSystem::FacialAnimation& facial,
+                                 UINT& baseVertex) {
+    if (!AddInstance(mesh, palette, baseVertex)) return false;
+
+    Instance& instance = instances_.back();
+    if (!morphShader_ || morphs.vertexCount > instance.vertexCount ||
+        morphs.shapes.size() != facial.blendShapes.size()) {
+        return true;
+    }
+
+    const size_t firstPass = morphPasses_.size();
+    for (size_t i = 0; i < morphs.shapes.size(); ++i) {
+        const float weight = facial.blendShapes[i].weight;
+        if (weight == 0.0f || morphs.shapes[i].deltaCount == 0) continue;
+
+        MorphPass pass = { morphs.view, morphs.shapes[i].firstDelta, morphs.shapes[i].deltaCount, weight,
+                           morphVerticesThisFrame_ };
+        morphPasses_.push_back(pass);
+    }
+
+    // A neutral face skins like any other instance
+    if (morphPasses_.size() > firstPass) {
+        instance.morphBase = morphVerticesThisFrame_;
+        instance.useMorph = 1;
+        morphVerticesThisFrame_ += instance.vertexCount;
+    }
+    return true;
+}
+
+void SkinningSystem::SetKeepPreviousFrame(bool keep) {
+    keepPreviousFrame_ = keep;
+    if (!keep) {
+        SafeRelease(previousView_);
+        SafeRelease(previousTarget_);
+        SafeRelease(previousBuffer_);
+        previousCapacity_ = 0;
+        motionKeys_.clear();
+        previousMotionKeys_.clear();
+    }
+}
+
+bool SkinningSystem::TrackMotion(uint64_t key, UINT baseVertex, UINT& previousBaseVertex) {
+    if (!keepPreviousFrame_) return false;
+    motionKeys_[key] = baseVertex;
+
+    auto previous = previousMotionKeys_.find(key);
+    if (previous == previousMotionKeys_.end() || !previousBuffer_) return false;
+    previousBaseVertex = previous->second;
+    return true;
+}
+
+void SkinningSystem::Dispatch() {
+    if (!skinShader_ || dispatched_) return;
+    dispatched_ = true;
+    if (instances_.empty()) return;
+
+    NEXUS_PROFILE_SCOPE("SkinningSystem::Dispatch");
+
+    const UINT boneCount = static_cast<UINT>(paletteRows_.size() / ROWS_PER_BONE);
+    if (!EnsurePaletteCapacity(boneCount) || !EnsureOutputCapacity(verticesThisFrame_)) {
+        Logger::Error("SkinningSystem::Dispatch - Out of memory for " + std::to_string(verticesThisFrame_) + " vertices");
+        return;
+    }
+    if (!morphPasses_.empty() && !EnsureMorphCapacity(morphVerticesThisFrame_)) {
+        Logger::Warning("SkinningSystem::Dispatch - Out of memory for blend shapes, skinning without them");
+        morphPasses_.clear();
+        for (Instance& instance : instances_) instance.useMorph = 0;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(paletteBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, paletteRows_.data(), paletteRows_.size() * sizeof(DirectX::XMFLOAT4));
+    context_->Unmap(paletteBuffer_, 0);
+
+    ID3D11ShaderResourceView* nullViews[] = { nullptr, nullptr, nullptr };
+    ID3D11UnorderedAccessView* nullTarget = nullptr;
+
+    // Sum the active blend shapes of every morphed instance before skinning reads them
+    if (!morphPasses_.empty()) {
+        const UINT zero[4] = { 0, 0, 0, 0 };
+        context_->ClearUnorderedAccessViewUint(morphTarget_, zero);
+
+        context_->CSSetShader(morphShader_, nullptr, 0);
+        context_->CSSetConstantBuffers(0, 1, &morphConstants_);
+        context_->CSSetUnorderedAccessViews(0, 1, &morphTarget_, nullptr);
+        for (const MorphPass& pass : morphPasses_) {
+            MorphConstants constants = { pass.firstDelta, pass.deltaCount, pass.weight, pass.morphBase };
+            WriteConstants(context_, morphConstants_, constants);
+
+            context_->CSSetShaderResources(0, 1, &pass.deltas);
+            context_->Dispatch((pass.deltaCount + THREADS_PER_GROUP - 1) / THREADS_PER_GROUP, 1, 1);
+        }
+        context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+    }
+
+    context_->CSSetShader(skinShader_, nullptr, 0);
+    context_->CSSetConstantBuffers(0, 1, &skinConstants_);
+    context_->CSSetUnorderedAccessViews(0, 1, &outputTarget_, nullptr);
+    for (const Instance& instance : instances_) {
+        SkinConstants constants = { instance.vertexCount, instance.firstBone, instance.boneCount, instance.baseVertex,
+                                    instance.morphBase, instance.useMorph, { 0, 0 } };
+        WriteConstants(context_, skinConstants_, constants);
+
+        ID3D11ShaderResourceView* views[] = { instance.vertices, paletteView_, instance.useMorph ? morphView_ : nullptr };
+        context_->CSSetShaderResources(0, 3, views);
+        context_->Dispatch((instance.vertexCount + THREADS_PER_GROUP - 1) / THREADS_PER_GROUP, 1, 1);
+    }
+
+    // The output is read by the input assembler next
+    context_->CSSetShaderResources(0, 3, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+    context_->CSSetShader(nullptr, nullptr, 0);
+
+    stats_.instances = static_cast<uint32_t>(instances_.size());
+    stats_.vertices = verticesThisFrame_;
+    stats_.bones = boneCount;
+    stats_.morphShapes = static_cast<uint32_t>(morphPasses_.size());
+}
+
+} // namespace Nexus
@@ -0,0 +1,596 @@
+#include "SpriteBatcher.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+
+constexpr DXGI_FORMAT ATLAS_FORMAT = DXGI_FORMAT_R8G8B8A8_UNORM;
+constexpr UINT PADDING = 2;                 // Transparent texels right of and below each packed texture
+constexpr UINT WHITE_SIZE = 4;              // White block at the first page's origin
+constexpr size_t MAX_PAGES = 65536;         // Page index in the low half of a sort key
+constexpr size_t MIN_CAPACITY = 1024;
+
+const char* SPRITE_VS = R"(
+cbuffer SpriteConstants : register(b0) {
+    float2 PixelToClip;
+    float2 Padding;
+};
+
+struct VSInput {
+    float2 center : POSITION;
+    float2 halfSize : TEXCOORD0;
+    float4 texRect : TEXCOORD1;
+    float rotation : TEXCOORD2;
+    float4 color : COLOR0;
+    uint vertexId : SV_VertexID;
+};
+
+struct VSOutput {
+    float4 position : SV_Position;
+    float2 texCoord : TEXCOORD0;
+    float4 color : COLOR0;
+};
+
+VSOutput main(VSInput input) {
+    // Strip corners: top-left, top-right, bottom-left, bottom-right
+    float2 corner = float2(input.vertexId & 1, input.vertexId >> 1);
+    float2 local = (corner * 2.0 - 1.0) * input.halfSize;
+    float s, c;
+    sincos(input.rotation, s, c);
+    float2 pixel = input.center + float2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    VSOutput output;
+    output.position = float4(pixel * PixelToClip + float2(-1.0, 1.0), 0.0, 1.0);
+    output.texCoord = lerp(input.texRect.xy, input.texRect.zw, corner);
+    output.color = input.color;
+    return output;
+}
+)";
+
+const char* SPRITE_PS = R"(
+Texture2D Page : register(t0);
+SamplerState LinearClamp : register(s0);
+
+struct PSInput {
+    float4 position : SV_Position;
+    float2 texCoord : TEXCOORD0;
+    float4 color : COLOR0;
+};
+
+float4 main(PSInput input) : SV_Target {
+    return Page.Sample(LinearClamp, input.texCoord) * input.color;
+}
+)";
+
+// TextRenderer's glyph shading, for the font page
+const char* DISTANCE_FIELD_PS = R"(
+Texture2D<float> Page : register(t0);
+SamplerState LinearClamp : register(s0);
+
+struct PSInput {
+    float4 position : SV_Position;
+    float2 texCoord : TEXCOORD0;
+    float4 color : COLOR0;
+};
+
+float4 main(PSInput input) : SV_Target {
+    float distance = Page.Sample(LinearClamp, input.texCoord);
+    float width = max(fwidth(distance) * 0.7, 1e-4);
+    float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+    return float4(input.color.rgb, input.color.a * coverage);
+}
+)";
+
+uint32_t PackColor(const DirectX::XMFLOAT4& color) {
+    auto channel = [](float value) { return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return channel(color.x) | (channel(color.y) << 8) | (channel(color.z) << 16) | (channel(color.w) << 24);
+}
+
+// Layer in the high half, biased so negative layers sort first, page in the low half
+uint32_t SortKey(int layer, uint16_t page) {
+    return (static_cast<uint32_t>(std::clamp(layer, -32768, 32767) + 32768) << 16) | page;
+}
+
+ID3DBlob* CompileShader(const char* source, const char* name, const char* target) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+} // namespace
+
+SpriteBatcher::SpriteBatcher()
+    : device_(nullptr)
+    , context_(nullptr)
+    , stateCache_(nullptr)
+    , vertexShader_(nullptr)
+    , spriteShader_(nullptr)
+    , distanceFieldShader_(nullptr)
+    , inputLayout_(nullptr)
+    , constants_(nullptr)
+    , linearClamp_(nullptr)
+    , blendState_(nullptr)
+    , rasterizerState_(nullptr)
+    , depthState_(nullptr)
+    , fontPage_(-1)
+    , instanceBuffer_(nullptr)
+    , capacity_(0)
+    , initialized_(false)
+{
+}
+
+SpriteBatcher::~SpriteBatcher() {
+    Shutdown();
+}
+
+bool SpriteBatcher::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache) {
+    if (!device || !context || !stateCache) return false;
+    device_ = device;
+    context_ = context;
+    stateCache_ = stateCache;
+
+    if (!CreatePipeline() || !EnsureCapacity(MIN_CAPACITY) || !AddAtlasPage()) {
+        Logger::Error("Failed to create sprite batcher");
+        Shutdown();
+        return false;
+    }
+
+    // Texture 0: the middle of a white block, which bilinear filtering never reads past
+    UINT x = 0;
+    UINT y = 0;
+    Pack(pages_[0], WHITE_SIZE + PADDING, WHITE_SIZE + PADDING, x, y);
+    std::vector<uint32_t> white(WHITE_SIZE * WHITE_SIZE, 0xffffffff);
+    D3D11_BOX box = { x, y, 0, x + WHITE_SIZE, y + WHITE_SIZE, 1 };
+    context_->UpdateSubresource(pages_[0].texture, 0, &box, white.data(), WHITE_SIZE * sizeof(uint32_t), 0);
+    const float texel = 1.0f / PAGE_SIZE;
+    regions_.push_back({ 0, DirectX::XMFLOAT4((x + 1) * texel, (y + 1) * texel, (x + WHITE_SIZE - 1) * texel,
+                                              (y + WHITE_SIZE - 1) * texel), DirectX::XMFLOAT2(1.0f, 1.0f) });
+
+    initialized_ = true;
+    Logger::Info("Sprite batcher initialized");
+    return true;
+}
+
+void SpriteBatcher::Shutdown() {
+    for (Page& page : pages_) {
+        SafeRelease(page.view);
+        SafeRelease(page.texture);
+    }
+    pages_.clear();
+    regions_.clear();
+    fontPage_ = -1;
+    SafeRelease(vertexShader_);
+    SafeRelease(spriteShader_);
+    SafeRelease(distanceFieldShader_);
+    SafeRelease(inputLayout_);
+    SafeRelease(constants_);
+    SafeRelease(linearClamp_);
+    SafeRelease(blendState_);
+    SafeRelease(rasterizerState_);
+    SafeRelease(depthState_);
+    SafeRelease(instanceBuffer_);
+    capacity_ = 0;
+    instances_.clear();
+    keys_.clear();
+    initialized_ = false;
+}
+
+int SpriteBatcher::AddTexture(ID3D11Texture2D* texture) {
+    if (!initialized_ || !texture) return 0;
+
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+    if (desc.ArraySize != 1 || desc.SampleDesc.Count != 1) {
+        Logger::Error("Sprite textures must be single 2D images");
+        return 0;
+    }
+
+    Region region;
+    region.size = DirectX::XMFLOAT2(static_cast<float>(desc.Width), static_cast<float>(desc.Height));
+
+    const UINT packedWidth = desc.Width + PADDING;
+    const UINT packedHeight = desc.Height + PADDING;
+    if (desc.Format == ATLAS_FORMAT && packedWidth <= PAGE_SIZE && packedHeight <= PAGE_SIZE) {
+        // First page with room, else a new one
+        UINT x = 0;
+        UINT y = 0;
+        size_t page = 0;
+        while (page < pages_.size() && !(pages_[page].atlas && Pack(pages_[page], packedWidth, packedHeight, x, y))) {
+            ++page;
+        }
+        if (page == pages_.size() && (!AddAtlasPage() || !Pack(pages_.back(), packedWidth, packedHeight, x, y))) {
+            return 0;
+        }
+        D3D11_BOX source = { 0, 0, 0, desc.Width, desc.Height, 1 };
+        context_->CopySubresourceRegion(pages_[page].texture, 0, x, y, 0, texture, 0, &source);
+
+        const float texel = 1.0f / PAGE_SIZE;
+        region.page = static_cast<uint16_t>(page);
+        region.texRect = DirectX::XMFLOAT4(x * texel, y * texel, (x + desc.Width) * texel, (y + desc.Height) * texel);
+    } else {
+        // Compressed or oversized: drawn from the texture itself, mips and all
+        if (pages_.size() >= MAX_PAGES) {
+            Logger::Error("Too many sprite texture pages");
+            return 0;
+        }
+        Page page = {};
+        if (FAILED(device_->CreateShaderResourceView(texture, nullptr, &page.view))) {
+            Logger::Error("Failed to create sprite texture view");
+            return 0;
+        }
+        texture->AddRef();
+        page.texture = texture;
+        pages_.push_back(page);
+        region.page = static_cast<uint16_t>(pages_.size() - 1);
+        region.texRect = DirectX::XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f);
+    }
+
+    regions_.push_back(region);
+    return static_cast<int>(regions_.size() - 1);
+}
+
+DirectX::XMFLOAT2 SpriteBatcher::GetTextureSize(int texture) const {
+    if (texture <= 0 || static_cast<size_t>(texture) >= regions_.size()) return DirectX::XMFLOAT2(1.0f, 1.0f);
+    return regions_[texture].size;
+}
+
+void SpriteBatcher::SetFont(const TextRenderer* font) {
+    if (!initialized_) return;
+    ID3D11ShaderResourceView* view = font ? font->GetFontTexture() : nullptr;
+    if (fontPage_ >= 0) {
+        SafeRelease(pages_[fontPage_].view);
+    } else if (view && pages_.size() < MAX_PAGES) {
+        Page page = {};
+        page.distanceField = true;
+        pages_.push_back(page);
+        fontPage_ = static_cast<int>(pages_.size() - 1);
+    }
+    if (fontPage_ < 0) return;
+
+    pages_[fontPage_].view = view;
+    if (view) {
+        view->AddRef();
+    }
+}
+
+void SpriteBatcher::Draw(const Sprite& sprite) {
+    if (!initialized_) return;
+
+    // Unknown textures draw as solid color
+    const size_t id = sprite.texture > 0 && static_cast<size_t>(sprite.texture) < regions_.size() ? sprite.texture : 0;
+    const Region& region = regions_[id];
+    Instance instance;
+    instance.center = sprite.position;
+    instance.halfSize = DirectX::XMFLOAT2((sprite.size.x != 0.0f ? sprite.size.x : region.size.x) * 0.5f,
+                                          (sprite.size.y != 0.0f ? sprite.size.y : region.size.y) * 0.5f);
+    instance.texRect = region.texRect;
+    instance.rotation = sprite.rotation;
+    instance.color = PackColor(sprite.color);
+    Append(instance, region.page, sprite.layer);
+}
+
+void SpriteBatcher::Draw(const Sprite* sprites, size_t count) {
+    if (!initialized_ || !sprites) return;
+    instances_.reserve(instances_.size() + count);
+    keys_.reserve(keys_.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        Draw(sprites[i]);
+    }
+}
+
+void SpriteBatcher::DrawLine(const DirectX::XMFLOAT2& from, const DirectX::XMFLOAT2& to, float thickness,
+                             const DirectX::XMFLOAT4& color, int layer) {
+    if (!initialized_) return;
+
+    const float dx = to.x - from.x;
+    const float dy = to.y - from.y;
+    Instance instance;
+    instance.center = DirectX::XMFLOAT2((from.x + to.x) * 0.5f, (from.y + to.y) * 0.5f);
+    instance.halfSize = DirectX::XMFLOAT2(std::sqrt(dx * dx + dy * dy) * 0.5f, thickness * 0.5f);
+    instance.texRect = regions_[0].texRect;
+    instance.rotation = std::atan2(dy, dx);
+    instance.color = PackColor(color);
+    Append(instance, 0, layer);
+}
+
+void SpriteBatcher::DrawString(const char* text, float x, float y, float scale, const DirectX::XMFLOAT4& color, int layer) {
+    if (!initialized_ || !text || fontPage_ < 0 || !pages_[fontPage_].view) return;
+
+    glyphs_.clear();
+    TextRenderer::LayoutText(text, x, y, scale, glyphs_);
+
+    Instance instance;
+    instance.rotation = 0.0f;
+    instance.color = PackColor(color);
+    for (const TextRenderer::GlyphQuad& glyph : glyphs_) {
+        instance.center = DirectX::XMFLOAT2(glyph.left + glyph.width * 0.5f, glyph.top + glyph.height * 0.5f);
+        instance.halfSize = DirectX::XMFLOAT2(glyph.width * 0.5f, glyph.height * 0.5f);
+        instance.texRect = DirectX::XMFLOAT4(glyph.u0, glyph.v0, glyph.u1, glyph.v1);
+        Append(instance, static_cast<uint16_t>(fontPage_), layer);
+    }
+}
+
+void SpriteBatcher::Append(const Instance& instance, uint16_t page, int layer) {
+    instances_.push_back(instance);
+    keys_.push_back(SortKey(layer, page));
+}
+
+void SpriteBatcher::Flush(UINT width, UINT height) {
+    stats_ = Stats();
+    stats_.pages = static_cast<unsigned int>(pages_.size());
+    if (instances_.empty()) return;
+    if (!initialized_ || width == 0 || height == 0) {
+        instances_.clear();
+        keys_.clear();
+        return;
+    }
+    NEXUS_PROFILE_SCOPE("SpriteBatcher::Flush");
+
+    const size_t count = instances_.size();
+    SortInstances();
+    if (!EnsureCapacity(count)) {
+        instances_.clear();
+        keys_.clear();
+        return;
+    }
+
+    // The sort only moved indices; the instances move once, straight into the buffer
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(instanceBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        Logger::Error("Failed to map sprite instance buffer");
+        instances_.clear();
+        keys_.clear();
+        return;
+    }
+    Instance* destination = static_cast<Instance*>(mapped.pData);
+    for (size_t i = 0; i < count; ++i) {
+        destination[i] = instances_[order_[i]];
+    }
+    context_->Unmap(instanceBuffer_, 0);
+
+    if (SUCCEEDED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        float pixelToClip[4] = { 2.0f / width, -2.0f / height, 0.0f, 0.0f };
+        std::memcpy(mapped.pData, pixelToClip, sizeof(pixelToClip));
+        context_->Unmap(constants_, 0);
+
+        UINT stride = sizeof(Instance);
+        UINT offset = 0;
+        stateCache_->IASetInputLayout(inputLayout_);
+        stateCache_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        stateCache_->IASetVertexBuffers(0, 1, &instanceBuffer_, &stride, &offset);
+        stateCache_->VSSetShader(vertexShader_);
+        stateCache_->VSSetConstantBuffers(0, 1, &constants_);
+        stateCache_->PSSetSamplers(0, 1, &linearClamp_);
+        stateCache_->RSSetState(rasterizerState_);
+        stateCache_->OMSetBlendState(blendState_, nullptr, 0xffffffff);
+        stateCache_->OMSetDepthStencilState(depthState_, 0);
+
+        // One draw per run of a layer and page
+        size_t start = 0;
+        while (start < count) {
+            const uint32_t key = keys_[order_[start]];
+            size_t end = start + 1;
+            while (end < count && keys_[order_[end]] == key) {
+                ++end;
+            }
+            const Page& page = pages_[key & 0xffff];
+            stateCache_->PSSetShader(page.distanceField ? distanceFieldShader_ : spriteShader_);
+            stateCache_->PSSetShaderResources(0, 1, &page.view);
+            context_->DrawInstanced(4, static_cast<UINT>(end - start), 0, static_cast<UINT>(start));
+            ++stats_.drawCalls;
+            start = end;
+        }
+        stats_.sprites = static_cast<unsigned int>(count);
+    }
+
+    instances_.clear();
+    keys_.clear();
+}
+
+void SpriteBatcher::SortInstances() {
+    const size_t count = keys_.size();
+    order_.resize(count);
+    sortScratch_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        order_[i] = static_cast<uint32_t>(i);
+    }
+
+    // Least significant byte first, so each pass keeps the order of the one before and the
+    // submission order survives within a layer and page. All four histograms in one read
+    uint32_t histograms[4][256] = {};
+    for (uint32_t key : keys_) {
+        ++histograms[0][key & 0xff];
+        ++histograms[1][(key >> 8) & 0xff];
+        ++histograms[2][(key >> 16) & 0xff];
+        ++histograms[3][key >> 24];
+    }
+    for (int digit = 0; digit < 4; ++digit) {
+        const int shift = digit * 8;
+        uint32_t* histogram = histograms[digit];
+        // A byte every key shares, such as the layer of a one-layer frame, orders nothing
+        if (histogram[(keys_[0] >> shift) & 0xff] == count) continue;
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            const uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (uint32_t index : order_) {
+            sortScratch_[histogram[(keys_[index] >> shift) & 0xff]++] = index;
+        }
+        order_.swap(sortScratch_);
+    }
+}
+
+bool SpriteBatcher::Pack(Page& page, UINT width, UINT height, UINT& x, UINT& y) {
+    // The shortest shelf the rectangle fits on, else a new shelf under the others
+    Shelf* best = nullptr;
+    for (Shelf& shelf : page.shelves) {
+        if (shelf.height >= height && PAGE_SIZE - shelf.used >= width && (!best || shelf.height < best->height)) {
+            best = &shelf;
+        }
+    }
+    if (!best) {
+        if (PAGE_SIZE - page.top < height) return false;
+        page.shelves.push_back({ page.top, height, 0 });
+        page.top += height;
+        best = &page.shelves.back();
+    }
+    x = best->used;
+    y = best->y;
+    best->used += width;
+    return true;
+}
+
+bool SpriteBatcher::AddAtlasPage() {
+    if (pages_.size() >= MAX_PAGES) {
+        Logger::Error("Too many sprite texture pages");
+        return false;
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = PAGE_SIZE;
+    desc.Height = PAGE_SIZE;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = ATLAS_FORMAT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    // Transparent between packed textures, which linear filtering at their edges reads
+    std::vector<uint32_t> clear(PAGE_SIZE * PAGE_SIZE, 0);
+    D3D11_SUBRESOURCE_DATA data = {};
+    data.pSysMem = clear.data();
+    data.SysMemPitch = PAGE_SIZE * sizeof(uint32_t);
+
+    Page page = {};
+    page.atlas = true;
+    if (FAILED(device_->CreateTexture2D(&desc, &data, &page.texture))) {
+        Logger::Error("Failed to create sprite atlas page");
+        return false;
+    }
+    if (FAILED(device_->CreateShaderResourceView(page.texture, nullptr, &page.view))) {
+        Logger::Error("Failed to create sprite atlas page view");
+        SafeRelease(page.texture);
+        return false;
+    }
+    pages_.push_back(page);
+    return true;
+}
+
+bool SpriteBatcher::EnsureCapacity(size_t instances) {
+    if (instances <= capacity_) return true;
+
+    size_t capacity = std::max(instances, std::max(capacity_ * 2, MIN_CAPACITY));
+    SafeRelease(instanceBuffer_);
+    capacity_ = 0;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth = static_cast<UINT>(capacity * sizeof(Instance));
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&desc, nullptr, &instanceBuffer_))) {
+        Logger::Error("Failed to create sprite instance buffer");
+        return false;
+    }
+    capacity_ = capacity;
+    return true;
+}
+
+bool SpriteBatcher::CreatePipeline() {
+    static_assert(sizeof(Instance) == 40, "Input layout offsets assume a packed 40-byte instance");
+
+    ID3DBlob* blob = CompileShader(SPRITE_VS, "Sprite_VS", "vs_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &vertexShader_);
+    if (SUCCEEDED(hr)) {
+        // Everything is per instance; the four corners come from SV_VertexID
+        D3D11_INPUT_ELEMENT_DESC layout[] = {
+            { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "TEXCOORD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "TEXCOORD", 2, DXGI_FORMAT_R32_FLOAT, 0, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 36, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        };
+        hr = device_->CreateInputLayout(layout, 5, blob->GetBufferPointer(), blob->GetBufferSize(), &inputLayout_);
+    }
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(SPRITE_PS, "Sprite_PS", "ps_5_0");
+    if (!blob) return false;
+    hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &spriteShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(DISTANCE_FIELD_PS, "Sprite_DistanceField_PS", "ps_5_0");
+    if (!blob) return false;
+    hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &distanceFieldShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    D3D11_BUFFER_DESC constantDesc = {};
+    constantDesc.ByteWidth = 16;
+    constantDesc.Usage = D3D11_USAGE_DYNAMIC;
+    constantDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constantDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&constantDesc, nullptr, &constants_))) return false;
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (FAILED(device_->CreateSamplerState(&samplerDesc, &linearClamp_))) return false;
+
+    // Straight alpha, as TextRenderer blends
+    D3D11_BLEND_DESC blendDesc = {};
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    if (FAILED(device_->CreateBlendState(&blendDesc, &blendState_))) return false;
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizerDesc, &rasterizerState_))) return false;
+
+    // Layers decide what is on top, not depth
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = FALSE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+    return SUCCEEDED(device_->CreateDepthStencilState(&depthDesc, &depthState_));
+}
+
+} // namespace Nexus
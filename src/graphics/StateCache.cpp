@@ -0,0 +1,345 @@
+#include "StateCache.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace Nexus {
+
+StateCache::StateCache()
+    : context_(nullptr)
+    , context1_(nullptr)
+    , overrideShader_(nullptr)
+    , overrideBlend_(nullptr)
+{
+    Invalidate();
+}
+
+void StateCache::Initialize(ID3D11DeviceContext* context) {
+    context_ = context;
+    if (context1_) { context1_->Release(); context1_ = nullptr; }
+    if (context_) {
+        context_->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&context1_);
+    }
+    Invalidate();
+    ResetStats();
+}
+
+void StateCache::Shutdown() {
+    if (context1_) { context1_->Release(); context1_ = nullptr; }
+    context_ = nullptr;
+    Invalidate();
+}
+
+void StateCache::Invalidate() {
+    inputLayout_ = Unknown<ID3D11InputLayout>();
+    topology_ = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    topologyValid_ = false;
+    std::fill(std::begin(vertexBuffers_), std::end(vertexBuffers_), Unknown<ID3D11Buffer>());
+    std::fill(std::begin(vertexStrides_), std::end(vertexStrides_), 0u);
+    std::fill(std::begin(vertexOffsets_), std::end(vertexOffsets_), 0u);
+    indexBuffer_ = Unknown<ID3D11Buffer>();
+    indexFormat_ = DXGI_FORMAT_UNKNOWN;
+    indexOffset_ = 0;
+
+    vertexShader_ = Unknown<ID3D11VertexShader>();
+    pixelShader_ = Unknown<ID3D11PixelShader>();
+    for (ShaderStageState* stage : { &vs_, &ps_ }) {
+        std::fill(std::begin(stage->constantBuffers), std::end(stage->constantBuffers), Unknown<ID3D11Buffer>());
+        std::fill(std::begin(stage->firstConstants), std::end(stage->firstConstants), 0u);
+        std::fill(std::begin(stage->numConstants), std::end(stage->numConstants), 0u);
+        std::fill(std::begin(stage->samplers), std::end(stage->samplers), Unknown<ID3D11SamplerState>());
+    }
+    InvalidateShaderResources();
+
+    rasterizerState_ = Unknown<ID3D11RasterizerState>();
+    viewportCount_ = 0;
+    viewportsValid_ = false;
+    std::fill(std::begin(renderTargets_), std::end(renderTargets_), nullptr);
+    renderTargetCount_ = 0;
+    depthStencilView_ = nullptr;
+    renderTargetsValid_ = false;
+    blendState_ = Unknown<ID3D11BlendState>();
+    std::fill(std::begin(blendFactor_), std::end(blendFactor_), 0.0f);
+    sampleMask_ = 0;
+    depthStencilState_ = Unknown<ID3D11DepthStencilState>();
+    stencilRef_ = 0;
+}
+
+void StateCache::InvalidateShaderResources() {
+    std::fill(std::begin(vs_.shaderResources), std::end(vs_.shaderResources), Unknown<ID3D11ShaderResourceView>());
+    std::fill(std::begin(ps_.shaderResources), std::end(ps_.shaderResources), Unknown<ID3D11ShaderResourceView>());
+}
+
+void StateCache::SetPixelOverride(ID3D11PixelShader* shader, ID3D11BlendState* blend) {
+    bool pixelShaderBound = pixelShader_ != nullptr;
+    overrideShader_ = shader;
+    overrideBlend_ = blend;
+
+    // What is bound was chosen under the old override, so the next binding of each goes through
+    pixelShader_ = Unknown<ID3D11PixelShader>();
+    blendState_ = Unknown<ID3D11BlendState>();
+    if (!context_ || !shader) return;
+    if (pixelShaderBound) {
+        PSSetShader(shader);
+    }
+    if (blend) {
+        OMSetBlendState(blend, nullptr, 0xffffffff);
+    }
+}
+
+template<typename T>
+bool StateCache::TrimRange(T** cached, UINT capacity, UINT& startSlot, UINT& count, T* const* values) {
+    if (startSlot + count > capacity) {
+        // Untracked slots: pass the call through and keep whatever part we do track honest
+        for (UINT i = 0; i < count && startSlot + i < capacity; ++i) {
+            cached[startSlot + i] = values[i];
+        }
+        return true;
+    }
+
+    UINT first = count;
+    UINT last = 0;
+    for (UINT i = 0; i < count; ++i) {
+        if (cached[startSlot + i] != values[i]) {
+            first = std::min(first, i);
+            last = i;
+            cached[startSlot + i] = values[i];
+        }
+    }
+    if (first == count) return false;
+
+    startSlot += first;
+    count = last - first + 1;
+    return true;
+}
+
+void StateCache::IASetInputLayout(ID3D11InputLayout* layout) {
+    if (inputLayout_ == layout) { stats_.filtered++; return; }
+    inputLayout_ = layout;
+    context_->IASetInputLayout(layout);
+    stats_.issued++;
+}
+
+void StateCache::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) {
+    if (topologyValid_ && topology_ == topology) { stats_.filtered++; return; }
+    topology_ = topology;
+    topologyValid_ = true;
+    context_->IASetPrimitiveTopology(topology);
+    stats_.issued++;
+}
+
+void StateCache::IASetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) {
+    if (startSlot + count > MAX_VERTEX_BUFFERS) {
+        for (UINT i = startSlot; i < MAX_VERTEX_BUFFERS; ++i) {
+            vertexBuffers_[i] = Unknown<ID3D11Buffer>();
+        }
+        context_->IASetVertexBuffers(startSlot, count, buffers, strides, offsets);
+        stats_.issued++;
+        return;
+    }
+
+    // Buffer, stride and offset all have to match for a slot to count as unchanged
+    UINT first = count;
+    UINT last = 0;
+    for (UINT i = 0; i < count; ++i) {
+        UINT slot = startSlot + i;
+        if (vertexBuffers_[slot] != buffers[i] || vertexStrides_[slot] != strides[i] || vertexOffsets_[slot] != offsets[i]) {
+            first = std::min(first, i);
+            last = i;
+            vertexBuffers_[slot] = buffers[i];
+            vertexStrides_[slot] = strides[i];
+            vertexOffsets_[slot] = offsets[i];
+        }
+    }
+    if (first == count) { stats_.filtered++; return; }
+
+    context_->IASetVertexBuffers(startSlot + first, last - first + 1, buffers + first, strides + first, offsets + first);
+    stats_.issued++;
+}
+
+void StateCache::IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) {
+    if (indexBuffer_ == buffer && indexFormat_ == format && indexOffset_ == offset) { stats_.filtered++; return; }
+    indexBuffer_ = buffer;
+    indexFormat_ = format;
+    indexOffset_ = offset;
+    context_->IASetIndexBuffer(buffer, format, offset);
+    stats_.issued++;
+}
+
+void StateCache::VSSetShader(ID3D11VertexShader* shader) {
+    if (vertexShader_ == shader) { stats_.filtered++; return; }
+    vertexShader_ = shader;
+    context_->VSSetShader(shader, nullptr, 0);
+    stats_.issued++;
+}
+
+void StateCache::PSSetShader(ID3D11PixelShader* shader) {
+    if (overrideShader_ && shader) shader = overrideShader_;
+    if (pixelShader_ == shader) { stats_.filtered++; return; }
+    pixelShader_ = shader;
+    context_->PSSetShader(shader, nullptr, 0);
+    stats_.issued++;
+}
+
+void StateCache::VSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) {
+    SetConstantBuffers(vs_, false, startSlot, count, buffers, nullptr, nullptr);
+}
+
+void StateCache::PSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) {
+    SetConstantBuffers(ps_, true, startSlot, count, buffers, nullptr, nullptr);
+}
+
+void StateCache::VSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+                                       const UINT* firstConstants, const UINT* numConstants) {
+    SetConstantBuffers(vs_, false, startSlot, count, buffers, firstConstants, numConstants);
+}
+
+void StateCache::PSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+                                       const UINT* firstConstants, const UINT* numConstants) {
+    SetConstantBuffers(ps_, true, startSlot, count, buffers, firstConstants, numConstants);
+}
+
+void StateCache::SetConstantBuffers(ShaderStageState& stage, bool pixelStage, UINT startSlot, UINT count,
+                                    ID3D11Buffer* const* buffers, const UINT* firstConstants, const UINT* numConstants) {
+    // Without an 11.1 context ranges cannot be expressed; a zero count also means whole buffer
+    bool ranged = firstConstants && numConstants && context1_;
+    for (UINT i = 0; ranged && i < count; ++i) {
+        ranged = numConstants[i] != 0;
+    }
+
+    UINT first = 0;
+    UINT last = count - 1;
+    if (startSlot + count <= MAX_CONSTANT_BUFFERS) {
+        first = count;
+        last = 0;
+        for (UINT i = 0; i < count; ++i) {
+            UINT slot = startSlot + i;
+            UINT firstConstant = ranged ? firstConstants[i] : 0;
+            UINT numConstant = ranged ? numConstants[i] : 0;
+            if (stage.constantBuffers[slot] != buffers[i] || stage.firstConstants[slot] != firstConstant ||
+                stage.numConstants[slot] != numConstant) {
+                first = std::min(first, i);
+                last = i;
+                stage.constantBuffers[slot] = buffers[i];
+                stage.firstConstants[slot] = firstConstant;
+                stage.numConstants[slot] = numConstant;
+            }
+        }
+        if (first == count) { stats_.filtered++; return; }
+    } else {
+        for (UINT slot = startSlot; slot < MAX_CONSTANT_BUFFERS; ++slot) {
+            stage.constantBuffers[slot] = Unknown<ID3D11Buffer>();
+        }
+    }
+
+    UINT rangeStart = startSlot + first;
+    UINT rangeCount = last - first + 1;
+    if (ranged) {
+        if (pixelStage) {
+            context1_->PSSetConstantBuffers1(rangeStart, rangeCount, buffers + first, firstConstants + first, numConstants + first);
+        } else {
+            context1_->VSSetConstantBuffers1(rangeStart, rangeCount, buffers + first, firstConstants + first, numConstants + first);
+        }
+    } else if (pixelStage) {
+        context_->PSSetConstantBuffers(rangeStart, rangeCount, buffers + first);
+    } else {
+        context_->VSSetConstantBuffers(rangeStart, rangeCount, buffers + first);
+    }
+    stats_.issued++;
+}
+
+void StateCache::VSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views) {
+    UINT first = startSlot;
+    if (!TrimRange(vs_.shaderResources, MAX_SHADER_RESOURCES, startSlot, count, views)) { stats_.filtered++; return; }
+    context_->VSSetShaderResources(startSlot, count, views + (startSlot - first));
+    stats_.issued++;
+}
+
+void StateCache::PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views) {
+    UINT first = startSlot;
+    if (!TrimRange(ps_.shaderResources, MAX_SHADER_RESOURCES, startSlot, count, views)) { stats_.filtered++; return; }
+    context_->PSSetShaderResources(startSlot, count, views + (startSlot - first));
+    stats_.issued++;
+}
+
+void StateCache::PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) {
+    UINT first = startSlot;
+    if (!TrimRange(ps_.samplers, MAX_SAMPLERS, startSlot, count, samplers)) { stats_.filtered++; return; }
+    context_->PSSetSamplers(startSlot, count, samplers + (startSlot - first));
+    stats_.issued++;
+}
+
+void StateCache::RSSetState(ID3D11RasterizerState* state) {
+    if (rasterizerState_ == state) { stats_.filtered++; return; }
+    rasterizerState_ = state;
+    context_->RSSetState(state);
+    stats_.issued++;
+}
+
+void StateCache::RSSetViewports(UINT count, const D3D11_VIEWPORT* viewports) {
+    if (count > MAX_VIEWPORTS) {
+        viewportsValid_ = false;
+        context_->RSSetViewports(count, viewports);
+        stats_.issued++;
+        return;
+    }
+
+    if (viewportsValid_ && viewportCount_ == count &&
+        std::memcmp(viewports_, viewports, sizeof(D3D11_VIEWPORT) * count) == 0) {
+        stats_.filtered++;
+        return;
+    }
+
+    std::memcpy(viewports_, viewports, sizeof(D3D11_VIEWPORT) * count);
+    viewportCount_ = count;
+    viewportsValid_ = true;
+    context_->RSSetViewports(count, viewports);
+    stats_.issued++;
+}
+
+void StateCache::OMSetRenderTargets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthView) {
+    count = std::min(count, MAX_RENDER_TARGETS);
+    bool same = renderTargetsValid_ && renderTargetCount_ == count && depthStencilView_ == depthView;
+    for (UINT i = 0; same && i < count; ++i) {
+        same = renderTargets_[i] == views[i];
+    }
+    if (same) { stats_.filtered++; return; }
+
+    for (UINT i = 0; i < MAX_RENDER_TARGETS; ++i) {
+        renderTargets_[i] = i < count ? views[i] : nullptr;
+    }
+    renderTargetCount_ = count;
+    depthStencilView_ = depthView;
+    renderTargetsValid_ = true;
+    context_->OMSetRenderTargets(count, views, depthView);
+    stats_.issued++;
+
+    // The runtime silently unbinds shader resources that alias a new output
+    InvalidateShaderResources();
+}
+
+void StateCache::OMSetBlendState(ID3D11BlendState* state, const FLOAT blendFactor[4], UINT sampleMask) {
+    static const FLOAT defaultFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    if (overrideShader_ && overrideBlend_) state = overrideBlend_;
+    const FLOAT* factor = blendFactor ? blendFactor : defaultFactor;
+    if (blendState_ == state && sampleMask_ == sampleMask && std::memcmp(blendFactor_, factor, sizeof(blendFactor_)) == 0) {
+        stats_.filtered++;
+        return;
+    }
+
+    blendState_ = state;
+    std::memcpy(blendFactor_, factor, sizeof(blendFactor_));
+    sampleMask_ = sampleMask;
+    context_->OMSetBlendState(state, blendFactor, sampleMask);
+    stats_.issued++;
+}
+
+void StateCache::OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef) {
+    if (depthStencilState_ == state && stencilRef_ == stencilRef) { stats_.filtered++; return; }
+    depthStencilState_ = state;
+    stencilRef_ = stencilRef;
+    context_->OMSetDepthStencilState(state, stencilRef);
+    stats_.issued++;
+}
+
+} // namespace Nexus
@@ -0,0 +1,524 @@
+#include "TemporalAA.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StateCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace Nexus {
+
+namespace {
+
+// Shared by the resolve and the present pass
+const char* TEMPORAL_CONSTANTS = R"(
+cbuffer TemporalConstants : register(b0)
+{
+    float4x4 Reprojection;      // This frame's NDC and depth to the previous frame's clip space
+    float2 RenderSize;          // Rendered pixels
+    float2 OutputSize;
+    float2 JitterPixels;        // Where this frame's samples sit, in rendered pixels
+    float Feedback;
+    float ClipGamma;
+    float Sharpness;
+    uint Reset;                 // No usable history
+    float2 Padding;
+};
+)";
+
+// One thread per output pixel. The 3x3 rendered samples around the pixel are weighed by their
+// jittered distance to its centre and give the neighbourhood's mean and variance; the closest of
+// them picks the motion, so edges move with the foreground
+const char* RESOLVE_CS = R"(
+Texture2D<float4> Scene : register(t0);
+Texture2D<float> Depth : register(t1);
+Texture2D<float2> Velocity : register(t2);
+Texture2D<float4> History : register(t3);
+SamplerState LinearClamp : register(s0);
+RWTexture2D<float4> Output : register(u0);
+
+float3 RgbToYCoCg(float3 c)
+{
+    return float3(dot(c, float3(0.25f, 0.5f, 0.25f)), dot(c, float3(0.5f, 0.0f, -0.5f)), dot(c, float3(-0.25f, 0.5f, -0.25f)));
+}
+
+float3 YCoCgToRgb(float3 c)
+{
+    return float3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+float3 FetchHistory(float2 pixel)
+{
+    return History.SampleLevel(LinearClamp, pixel / OutputSize, 0).rgb;
+}
+
+// Catmull-Rom in five bilinear taps; bilinear alone would blur the history a little every frame
+float3 SampleHistory(float2 uv)
+{
+    float2 pixel = uv * OutputSize;
+    float2 center = floor(pixel - 0.5f) + 0.5f;
+    float2 f = pixel - center;
+
+    float2 w0 = f * (-0.5f + f * (1.0f - 0.5f * f));
+    float2 w1 = 1.0f + f * f * (-2.5f + 1.5f * f);
+    float2 w2 = f * (0.5f + f * (2.0f - 1.5f * f));
+    float2 w3 = f * f * (-0.5f + 0.5f * f);
+    float2 w12 = w1 + w2;
+    float2 p0 = center - 1.0f;
+    float2 p12 = center + w2 / w12;
+    float2 p3 = center + 2.0f;
+
+    float3 color = FetchHistory(float2(p12.x, p0.y)) * (w12.x * w0.y) +
+                   FetchHistory(float2(p0.x, p12.y)) * (w0.x * w12.y) +
+                   FetchHistory(p12) * (w12.x * w12.y) +
+                   FetchHistory(float2(p3.x, p12.y)) * (w3.x * w12.y) +
+                   FetchHistory(float2(p12.x, p3.y)) * (w12.x * w3.y);
+    color /= w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+    return max(color, 0.0f);
+}
+
+// Pulls history towards the box centre until it lies inside
+float3 ClipToBox(float3 history, float3 center, float3 extent)
+{
+    float3 offset = history - center;
+    float3 units = abs(offset) / max(extent, 1e-4f);
+    float peak = max(units.x, max(units.y, units.z));
+    return peak > 1.0f ? center + offset / peak : history;
+}
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    if (any(id.xy >= (uint2)OutputSize)) return;
+
+    float2 uv = (id.xy + 0.5f) / OutputSize;
+    float2 position = uv * RenderSize;
+    int2 lastTexel = (int2)RenderSize - 1;
+    int2 nearest = clamp((int2)floor(position + JitterPixels), 0, lastTexel);
+
+    float3 sum = 0.0f;
+    float totalWeight = 0.0f;
+    float peakWeight = 0.0f;
+    float3 m1 = 0.0f;
+    float3 m2 = 0.0f;
+    float closestDepth = 1.0f;
+    int2 closestTexel = nearest;
+    [unroll] for (int y = -1; y <= 1; ++y) {
+        [unroll] for (int x = -1; x <= 1; ++x) {
+            int2 texel = clamp(nearest + int2(x, y), 0, lastTexel);
+            float3 color = RgbToYCoCg(Scene.Load(int3(texel, 0)).rgb);
+
+            // Gaussian fit of Blackman-Harris over the sample's distance in rendered pixels
+            float2 offset = texel + 0.5f - JitterPixels - position;
+            float weight = exp(-2.29f * dot(offset, offset));
+            sum += color * weight;
+            totalWeight += weight;
+            peakWeight = max(peakWeight, weight);
+            m1 += color;
+            m2 += color * color;
+
+            float depth = Depth.Load(int3(texel, 0));
+            if (depth < closestDepth) {
+                closestDepth = depth;
+                closestTexel = texel;
+            }
+        }
+    }
+    float3 current = sum / totalWeight;
+
+    // Camera motion of the closest surface, then whatever it moved by itself
+    float2 ndc = float2(uv.x * 2.0f - 1.0f, 1.0f - uv.y * 2.0f);
+    float4 previous = mul(float4(ndc, closestDepth, 1.0f), Reprojection);
+    float2 previousUV = previous.xy / previous.w * float2(0.5f, -0.5f) + 0.5f;
+    previousUV -= Velocity.Load(int3(closestTexel, 0));
+
+    float3 result = current;
+    if (!Reset && all(previousUV > 0.0f) && all(previousUV < 1.0f)) {
+        float3 mean = m1 / 9.0f;
+        float3 sigma = sqrt(abs(m2 / 9.0f - mean * mean));
+        float3 history = ClipToBox(RgbToYCoCg(SampleHistory(previousUV)), mean, ClipGamma * sigma);
+
+        // A pixel no sample landed near this frame leans on its history
+        float alpha = (1.0f - Feedback) * peakWeight;
+        result = lerp(history, current, alpha);
+    }
+    Output[id.xy] = float4(YCoCgToRgb(result), 1.0f);
+}
+)";
+
+// Fullscreen triangle, uv spans the output
+const char* FULLSCREEN_VS = R"(
+struct Output
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+Output main(uint id : SV_VertexID)
+{
+    Output output;
+    output.uv = float2((id << 1) & 2, id & 2);
+    output.position = float4(output.uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+    return output;
+}
+)";
+
+// Copies the resolved frame out with contrast-adaptive sharpening, giving back the little
+// softness the accumulation costs; the history itself stays unsharpened
+const char* PRESENT_PS = R"(
+Texture2D<float4> Resolved : register(t0);
+
+float3 Fetch(int2 pixel)
+{
+    return Resolved.Load(int3(clamp(pixel, 0, (int2)OutputSize - 1), 0)).rgb;
+}
+
+float4 main(float4 position : SV_POSITION, float2 uv : TEXCOORD0) : SV_TARGET
+{
+    int2 pixel = (int2)position.xy;
+    float3 color = Fetch(pixel);
+    if (Sharpness > 0.0f) {
+        float3 north = Fetch(pixel - int2(0, 1));
+        float3 south = Fetch(pixel + int2(0, 1));
+        float3 west = Fetch(pixel - int2(1, 0));
+        float3 east = Fetch(pixel + int2(1, 0));
+        float3 low = min(color, min(min(north, south), min(west, east)));
+        float3 high = max(color, max(max(north, south), max(west, east)));
+        float3 amount = sqrt(saturate(min(low, 1.0f - high) / max(high, 1e-4f)));
+        float3 weight = -amount * lerp(0.125f, 0.2f, Sharpness);
+        color = (color + (north + south + west + east) * weight) / (1.0f + 4.0f * weight);
+    }
+    return float4(saturate(color), 1.0f);
+}
+)";
+
+// Matches TemporalConstants above
+struct GpuTemporalConstants {
+    DirectX::XMFLOAT4X4 reprojection;
+    float renderSize[2];
+    float outputSize[2];
+    float jitterPixels[2];
+    float feedback;
+    float clipGamma;
+    float sharpness;
+    UINT reset;
+    float padding[2];
+};
+
+constexpr UINT RESOLVE_GROUP_SIZE = 8;
+constexpr float VELOCITY_CLEAR[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+ID3DBlob* CompileShader(const std::string& source, const char* name, const char* target) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source.c_str(), name, "main", target, 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+// Radical inverse of index in base, in [0, 1)
+float Halton(uint32_t index, uint32_t base) {
+    float fraction = 1.0f;
+    float result = 0.0f;
+    while (index > 0) {
+        fraction /= static_cast<float>(base);
+        result += fraction * static_cast<float>(index % base);
+        index /= base;
+    }
+    return result;
+}
+
+} // namespace
+
+TemporalAA::TemporalAA()
+    : device_(nullptr)
+    , context_(nullptr)
+    , stateCache_(nullptr)
+    , width_(0)
+    , height_(0)
+    , sceneTexture_(nullptr)
+    , sceneTarget_(nullptr)
+    , sceneView_(nullptr)
+    , velocityTexture_(nullptr)
+    , velocityTarget_(nullptr)
+    , velocityView_(nullptr)
+    , historyTextures_{}
+    , historyTargets_{}
+    , historyViews_{}
+    , historyIndex_(0)
+    , historyValid_(false)
+    , resolveShader_(nullptr)
+    , fullscreenShader_(nullptr)
+    , presentShader_(nullptr)
+    , constants_(nullptr)
+    , linearClamp_(nullptr)
+    , rasterizerState_(nullptr)
+    , depthState_(nullptr)
+    , frameIndex_(0)
+    , renderWidth_(0)
+    , renderHeight_(0)
+    , jitter_(0.0f, 0.0f)
+    , jitterPixels_(0.0f, 0.0f)
+{
+    DirectX::XMStoreFloat4x4(&previousViewProjection_, DirectX::XMMatrixIdentity());
+}
+
+TemporalAA::~TemporalAA() {
+    Shutdown();
+}
+
+bool TemporalAA::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache,
+                            UINT width, UINT height, const Settings& settings) {
+    Shutdown();
+    if (!device || !context || !stateCache || width == 0 || height == 0) return false;
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0) {
+        Logger::Warning("Temporal anti-aliasing needs feature level 11_0 compute shaders");
+        return false;
+    }
+
+    device_ = device;
+    context_ = context;
+    stateCache_ = stateCache;
+    width_ = width;
+    height_ = height;
+    SetSettings(settings);
+
+    if (!CreateResources() || !CreateShaders()) {
+        Logger::Error("Failed to create temporal anti-aliasing resources");
+        Shutdown();
+        return false;
+    }
+
+    frameIndex_ = 0;
+    historyIndex_ = 0;
+    historyValid_ = false;
+    BeginFrame();
+    Logger::Info(std::string("Temporal anti-aliasing initialized: ") +
+                 (settings_.mode == Mode::Upscale ? "upscaling from " + std::to_string(settings_.upscaleRatio) : "native"));
+    return true;
+}
+
+void TemporalAA::Shutdown() {
+    SafeRelease(sceneTarget_);
+    SafeRelease(sceneView_);
+    SafeRelease(sceneTexture_);
+    SafeRelease(velocityTarget_);
+    SafeRelease(velocityView_);
+    SafeRelease(velocityTexture_);
+    for (UINT i = 0; i < 2; ++i) {
+        SafeRelease(historyTargets_[i]);
+        SafeRelease(historyViews_[i]);
+        SafeRelease(historyTextures_[i]);
+    }
+    SafeRelease(resolveShader_);
+    SafeRelease(fullscreenShader_);
+    SafeRelease(presentShader_);
+    SafeRelease(constants_);
+    SafeRelease(linearClamp_);
+    SafeRelease(rasterizerState_);
+    SafeRelease(depthState_);
+    historyValid_ = false;
+    device_ = nullptr;
+    context_ = nullptr;
+    stateCache_ = nullptr;
+}
+
+bool TemporalAA::CreateResources() {
+    // Same format as the back buffer, like the dynamic resolution scene target
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width_;
+    desc.Height = height_;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &sceneTexture_))) return false;
+    if (FAILED(device_->CreateRenderTargetView(sceneTexture_, nullptr, &sceneTarget_))) return false;
+    if (FAILED(device_->CreateShaderResourceView(sceneTexture_, nullptr, &sceneView_))) return false;
+
+    desc.Format = DXGI_FORMAT_R16G16_FLOAT;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &velocityTexture_))) return false;
+    if (FAILED(device_->CreateRenderTargetView(velocityTexture_, nullptr, &velocityTarget_))) return false;
+    if (FAILED(device_->CreateShaderResourceView(velocityTexture_, nullptr, &velocityView_))) return false;
+
+    // Half floats keep the slow blend from banding in dark gradients
+    desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+    for (UINT i = 0; i < 2; ++i) {
+        if (FAILED(device_->CreateTexture2D(&desc, nullptr, &historyTextures_[i]))) return false;
+        if (FAILED(device_->CreateUnorderedAccessView(historyTextures_[i], nullptr, &historyTargets_[i]))) return false;
+        if (FAILED(device_->CreateShaderResourceView(historyTextures_[i], nullptr, &historyViews_[i]))) return false;
+    }
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = sizeof(GpuTemporalConstants);
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&bufferDesc, nullptr, &constants_))) return false;
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (FAILED(device_->CreateSamplerState(&samplerDesc, &linearClamp_))) return false;
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizerDesc, &rasterizerState_))) return false;
+
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = FALSE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+    return SUCCEEDED(device_->CreateDepthStencilState(&depthDesc, &depthState_));
+}
+
+bool TemporalAA::CreateShaders() {
+    ID3DBlob* blob = CompileShader(std::string(TEMPORAL_CONSTANTS) + RESOLVE_CS, "TemporalResolve_CS", "cs_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &resolveShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(FULLSCREEN_VS, "TemporalPresent_VS", "vs_5_0");
+    if (!blob) return false;
+    hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &fullscreenShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+
+    blob = CompileShader(std::string(TEMPORAL_CONSTANTS) + PRESENT_PS, "TemporalPresent_PS", "ps_5_0");
+    if (!blob) return false;
+    hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &presentShader_);
+    blob->Release();
+    return SUCCEEDED(hr);
+}
+
+void TemporalAA::SetSettings(const Settings& settings) {
+    settings_ = settings;
+    settings_.upscaleRatio = std::clamp(settings_.upscaleRatio, 0.5f, 1.0f);
+    settings_.feedback = std::clamp(settings_.feedback, 0.0f, 0.98f);
+    settings_.clipGamma = std::clamp(settings_.clipGamma, 0.5f, 3.0f);
+    settings_.sharpness = std::clamp(settings_.sharpness, 0.0f, 1.0f);
+}
+
+void TemporalAA::BeginFrame(UINT renderWidth, UINT renderHeight) {
+    if (!device_) return;
+
+    if (renderWidth == 0 || renderHeight == 0) {
+        float scale = settings_.mode == Mode::Upscale ? settings_.upscaleRatio : 1.0f;
+        renderWidth = static_cast<UINT>(std::lround(width_ * scale));
+        renderHeight = static_cast<UINT>(std::lround(height_ * scale));
+    }
+    renderWidth_ = std::clamp(renderWidth, 1u, width_);
+    renderHeight_ = std::clamp(renderHeight, 1u, height_);
+
+    // Fewer rendered pixels per output pixel need more phases to cover each one
+    float pixelRatio = static_cast<float>(width_) / static_cast<float>(renderWidth_);
+    UINT phases = static_cast<UINT>(std::ceil(JITTER_PHASES * pixelRatio * pixelRatio));
+    phases = std::clamp(phases, JITTER_PHASES, MAX_JITTER_PHASES);
+    uint32_t phase = frameIndex_++ % phases + 1;
+
+    // A clip-space offset of 2 spans the viewport; y points up in clip space and down in pixels
+    jitterPixels_ = DirectX::XMFLOAT2(Halton(phase, 2) - 0.5f, Halton(phase, 3) - 0.5f);
+    jitter_ = DirectX::XMFLOAT2(2.0f * jitterPixels_.x / renderWidth_, -2.0f * jitterPixels_.y / renderHeight_);
+
+    context_->ClearRenderTargetView(velocityTarget_, VELOCITY_CLEAR);
+}
+
+DirectX::XMMATRIX TemporalAA::JitterProjection(DirectX::FXMMATRIX projection) const {
+    // Offsets clip x and y by jitter times w, so it holds for perspective and orthographic alike
+    return DirectX::XMMatrixMultiply(projection, DirectX::XMMatrixTranslation(jitter_.x, jitter_.y, 0.0f));
+}
+
+void TemporalAA::Resolve(ID3D11ShaderResourceView* scene, ID3D11ShaderResourceView* depth,
+                         DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, ID3D11RenderTargetView* target) {
+    if (!device_ || !scene || !depth || !target) return;
+    NEXUS_PROFILE_SCOPE("TemporalAA::Resolve");
+
+    DirectX::XMMATRIX viewProjection = DirectX::XMMatrixMultiply(view, projection);
+    DirectX::XMMATRIX previousViewProjection = DirectX::XMLoadFloat4x4(&previousViewProjection_);
+    DirectX::XMMATRIX reprojection = DirectX::XMMatrixMultiply(DirectX::XMMatrixInverse(nullptr, viewProjection),
+                                                               previousViewProjection);
+
+    GpuTemporalConstants constants = {};
+    DirectX::XMStoreFloat4x4(&constants.reprojection, DirectX::XMMatrixTranspose(reprojection));
+    constants.renderSize[0] = static_cast<float>(renderWidth_);
+    constants.renderSize[1] = static_cast<float>(renderHeight_);
+    constants.outputSize[0] = static_cast<float>(width_);
+    constants.outputSize[1] = static_cast<float>(height_);
+    constants.jitterPixels[0] = jitterPixels_.x;
+    constants.jitterPixels[1] = jitterPixels_.y;
+    constants.feedback = settings_.feedback;
+    constants.clipGamma = settings_.clipGamma;
+    constants.sharpness = settings_.sharpness;
+    constants.reset = historyValid_ ? 0 : 1;
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    std::memcpy(mapped.pData, &constants, sizeof(constants));
+    context_->Unmap(constants_, 0);
+
+    // The scene, velocity and depth can't be read while bound as targets
+    stateCache_->OMSetRenderTargets(1, &target, nullptr);
+
+    UINT next = historyIndex_ ^ 1;
+    ID3D11ShaderResourceView* inputs[4] = { scene, depth, velocityView_, historyViews_[historyIndex_] };
+    context_->CSSetShader(resolveShader_, nullptr, 0);
+    context_->CSSetConstantBuffers(0, 1, &constants_);
+    context_->CSSetShaderResources(0, 4, inputs);
+    context_->CSSetSamplers(0, 1, &linearClamp_);
+    context_->CSSetUnorderedAccessViews(0, 1, &historyTargets_[next], nullptr);
+    context_->Dispatch((width_ + RESOLVE_GROUP_SIZE - 1) / RESOLVE_GROUP_SIZE,
+                       (height_ + RESOLVE_GROUP_SIZE - 1) / RESOLVE_GROUP_SIZE, 1);
+
+    ID3D11ShaderResourceView* nullViews[4] = {};
+    ID3D11UnorderedAccessView* nullTarget = nullptr;
+    context_->CSSetShaderResources(0, 4, nullViews);
+    context_->CSSetUnorderedAccessViews(0, 1, &nullTarget, nullptr);
+    context_->CSSetShader(nullptr, nullptr, 0);
+
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = static_cast<float>(width_);
+    viewport.Height = static_cast<float>(height_);
+    viewport.MaxDepth = 1.0f;
+    stateCache_->RSSetViewports(1, &viewport);
+    stateCache_->RSSetState(rasterizerState_);
+    stateCache_->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+    stateCache_->OMSetDepthStencilState(depthState_, 0);
+    stateCache_->IASetInputLayout(nullptr);
+    stateCache_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    stateCache_->VSSetShader(fullscreenShader_);
+    stateCache_->PSSetShader(presentShader_);
+    stateCache_->PSSetConstantBuffers(0, 1, &constants_);
+    stateCache_->PSSetShaderResources(0, 1, &historyViews_[next]);
+    context_->Draw(3, 0);
+
+    // Written by the next resolve
+    ID3D11ShaderResourceView* nullView = nullptr;
+    stateCache_->PSSetShaderResources(0, 1, &nullView);
+
+    historyIndex_ = next;
+    historyValid_ = true;
+    DirectX::XMStoreFloat4x4(&previousViewProjection_, viewProjection);
+}
+
+} // namespace Nexus
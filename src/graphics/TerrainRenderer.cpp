@@ -0,0 +1,683 @@
+#include "TerrainRenderer.h"
+#include "PhysicsEngine.h"
+#include "StaticGeometry.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+
+// Grid vertices are patch-relative in [0, 1]; the node places and sizes the patch. Odd grid
+// vertices slide onto their even neighbours as the morph factor goes to 1, which turns the patch
+// into the next coarser level's grid
+const char* TERRAIN_VS = R"(
+    #define MAX_LEVELS 8
+
+    struct VS_OUTPUT {
+        float4 position : SV_POSITION;
+        float3 worldPos : TEXCOORD0;
+        float3 normal : TEXCOORD1;
+        float3 tangent : TEXCOORD2;
+        float3 bitangent : TEXCOORD3;
+        float2 texCoord : TEXCOORD4;
+        float4 color : TEXCOORD5;
+        float3 viewDir : TEXCOORD6;
+        float4 lightSpacePos : TEXCOORD7;
+    };
+
+    cbuffer TerrainConstants : register(b0)
+    {
+        matrix ViewProjection;
+        matrix LightViewProjection;
+        float3 CameraPosition;
+        float CellSize;
+        float HeightScale;
+        float HeightOffset;
+        float TextureScale;
+        float GridResolution;
+        float TileSamples;
+        float3 Padding;
+        float4 MorphRanges[MAX_LEVELS];     // Start, 1 / (end - start)
+    };
+
+    struct NodeData
+    {
+        float2 Origin;
+        float Size;
+        uint Level;
+        float2 TileOrigin;
+        uint Slot;
+        uint NodePadding;
+    };
+
+    Texture2DArray<float> Heights : register(t0);
+    StructuredBuffer<NodeData> Nodes : register(t1);
+    SamplerState LinearClamp : register(s0);
+
+    float Height(float2 world, NodeData node)
+    {
+        float2 uv = ((world - node.TileOrigin) / CellSize + 0.5f) / TileSamples;
+        return Heights.SampleLevel(LinearClamp, float3(uv, node.Slot), 0) * HeightScale + HeightOffset;
+    }
+
+    VS_OUTPUT main(float2 grid : POSITION, uint instanceId : SV_InstanceID)
+    {
+        NodeData node = Nodes[instanceId];
+        float2 world = node.Origin + grid * node.Size;
+        float3 position = float3(world.x, Height(world, node), world.y);
+
+        float4 range = MorphRanges[node.Level];
+        float morph = saturate((distance(position, CameraPosition) - range.x) * range.y);
+        float2 odd = frac(grid * GridResolution * 0.5f) * 2.0f;
+        world -= odd * (node.Size / GridResolution) * morph;
+        position = float3(world.x, Height(world, node), world.y);
+
+        // Central differences one sample apart; the clamp makes them one-sided at tile edges
+        float2 step = float2(CellSize, 0.0f);
+        float left = Height(world - step.xy, node);
+        float right = Height(world + step.xy, node);
+        float back = Height(world - step.yx, node);
+        float front = Height(world + step.yx, node);
+
+        VS_OUTPUT output;
+        output.position = mul(float4(position, 1.0f), ViewProjection);
+        output.worldPos = position;
+        output.normal = normalize(float3(left - right, 2.0f * CellSize, back - front));
+        output.tangent = normalize(float3(2.0f * CellSize, right - left, 0.0f));
+        output.bitangent = cross(output.normal, output.tangent);
+        output.texCoord = world * TextureScale;
+        output.color = float4(1.0f, 1.0f, 1.0f, 1.0f);
+        output.viewDir = normalize(CameraPosition - position);
+        output.lightSpacePos = mul(float4(position, 1.0f), LightViewProjection);
+        return output;
+    }
+)";
+
+// Matches TerrainConstants above
+struct GpuTerrainConstants {
+    XMFLOAT4X4 viewProjection;
+    XMFLOAT4X4 lightViewProjection;
+    XMFLOAT3 cameraPosition;
+    float cellSize;
+    float heightScale;
+    float heightOffset;
+    float textureScale;
+    float gridResolution;
+    float tileSamples;
+    float padding[3];
+    XMFLOAT4 morphRanges[TerrainRenderer::MAX_LEVELS];
+};
+
+// Matches NodeData
+struct GpuNode {
+    float origin[2];
+    float size;
+    UINT level;
+    float tileOrigin[2];
+    UINT slot;
+    UINT padding;
+};
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+bool IsPowerOfTwo(UINT value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+UINT Log2(UINT value) {
+    UINT result = 0;
+    while (value >>= 1) ++result;
+    return result;
+}
+
+// Nearest point of the box within range of the camera
+bool InRange(const AABB& box, const XMFLOAT3& camera, float range) {
+    float dx = std::max({ box.min.x - camera.x, 0.0f, camera.x - box.max.x });
+    float dy = std::max({ box.min.y - camera.y, 0.0f, camera.y - box.max.y });
+    float dz = std::max({ box.min.z - camera.z, 0.0f, camera.z - box.max.z });
+    return dx * dx + dy * dy + dz * dz <= range * range;
+}
+
+int32_t FloorDiv(float value, float size) {
+    return static_cast<int32_t>(std::floor(value / size));
+}
+
+} // namespace
+
+TerrainRenderer::TerrainRenderer()
+    : device_(nullptr)
+    , context_(nullptr)
+    , physics_(nullptr)
+    , levelCount_(0)
+    , windowSize_(0)
+    , ranges_{}
+    , vertexShader_(nullptr)
+    , inputLayout_(nullptr)
+    , gridVertices_(nullptr)
+    , gridIndices_(nullptr)
+    , gridIndexCount_(0)
+    , constants_(nullptr)
+    , nodeBuffer_(nullptr)
+    , nodeView_(nullptr)
+    , heightArray_(nullptr)
+    , heightView_(nullptr)
+    , linearClamp_(nullptr)
+    , shutdownRequested_(false)
+    , generation_(0)
+{
+}
+
+TerrainRenderer::~TerrainRenderer() {
+    Shutdown();
+}
+
+bool TerrainRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, PhysicsEngine* physics) {
+    Shutdown();
+    if (!device || !context) return false;
+    device_ = device;
+    context_ = context;
+    physics_ = physics;
+
+    D3D11_BUFFER_DESC constantsDesc = {};
+    constantsDesc.Usage = D3D11_USAGE_DYNAMIC;
+    constantsDesc.ByteWidth = sizeof(GpuTerrainConstants);
+    constantsDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constantsDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    HRESULT hr = device_->CreateBuffer(&constantsDesc, nullptr, &constants_);
+
+    D3D11_BUFFER_DESC nodeDesc = {};
+    nodeDesc.Usage = D3D11_USAGE_DYNAMIC;
+    nodeDesc.ByteWidth = sizeof(GpuNode) * MAX_NODES;
+    nodeDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    nodeDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    nodeDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    nodeDesc.StructureByteStride = sizeof(GpuNode);
+    if (SUCCEEDED(hr)) hr = device_->CreateBuffer(&nodeDesc, nullptr, &nodeBuffer_);
+    if (SUCCEEDED(hr)) hr = device_->CreateShaderResourceView(nodeBuffer_, nullptr, &nodeView_);
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (SUCCEEDED(hr)) hr = device_->CreateSamplerState(&samplerDesc, &linearClamp_);
+
+    if (FAILED(hr) || !CreateShaders()) {
+        Logger::Error("Failed to create terrain rendering resources");
+        Shutdown();
+        return false;
+    }
+
+    shutdownRequested_ = false;
+    loaderThread_ = std::thread(&TerrainRenderer::LoaderThread, this);
+    Logger::Info("Terrain renderer initialized");
+    return true;
+}
+
+bool TerrainRenderer::CreateShaders() {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(TERRAIN_VS, "Terrain_VS", "main", "vs_5_0", 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error("Terrain_VS compilation error: " + errors);
+        }
+        return false;
+    }
+
+    D3D11_INPUT_ELEMENT_DESC layout[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    };
+    hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &vertexShader_);
+    if (SUCCEEDED(hr)) {
+        hr = device_->CreateInputLayout(layout, 1, blob->GetBufferPointer(), blob->GetBufferSize(), &inputLayout_);
+    }
+    blob->Release();
+    return SUCCEEDED(hr);
+}
+
+void TerrainRenderer::Shutdown() {
+    Close();
+
+    if (loaderThread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(loadQueueMutex_);
+            shutdownRequested_ = true;
+        }
+        loadQueueCondition_.notify_all();
+        loaderThread_.join();
+    }
+    completedLoads_.clear();
+
+    SafeRelease(linearClamp_);
+    SafeRelease(nodeView_);
+    SafeRelease(nodeBuffer_);
+    SafeRelease(constants_);
+    SafeRelease(inputLayout_);
+    SafeRelease(vertexShader_);
+    device_ = nullptr;
+    context_ = nullptr;
+    physics_ = nullptr;
+}
+
+bool TerrainRenderer::Open(const std::string& directory, const Settings& settings) {
+    Close();
+    if (!device_) return false;
+
+    if (!IsPowerOfTwo(settings.tileSamples - 1) || !IsPowerOfTwo(settings.gridResolution) ||
+        settings.gridResolution < 2 || settings.gridResolution >= settings.tileSamples ||
+        !(settings.cellSize > 0.0f)) {
+        Logger::Error("Terrain needs tileSamples - 1 and gridResolution to be powers of two with "
+                      "gridResolution below tileSamples");
+        return false;
+    }
+    UINT levelCount = Log2((settings.tileSamples - 1) / settings.gridResolution) + 1;
+    if (levelCount > MAX_LEVELS) {
+        Logger::Error("Terrain tiles are more than " + std::to_string(MAX_LEVELS) + " levels of patches across");
+        return false;
+    }
+
+    settings_ = settings;
+    settings_.morphRatio = std::min(std::max(settings_.morphRatio, 0.01f), 1.0f);
+    settings_.uploadsPerFrame = std::max(settings_.uploadsPerFrame, 1u);
+    settings_.lodDistance = std::max(settings_.lodDistance, 2.0f * settings_.gridResolution * settings_.cellSize);
+    windowSize_ = 2 * settings_.streamRadius + 1;
+    if (!CreateGrid() || !CreateHeightArray()) {
+        Logger::Error("Failed to create terrain buffers");
+        Close();
+        return false;
+    }
+
+    // The coarsest level covers everything resident
+    for (UINT level = 0; level < levelCount; ++level) {
+        ranges_[level] = level + 1 < levelCount ? settings_.lodDistance * static_cast<float>(1u << level) : FLT_MAX;
+    }
+    directory_ = directory;
+    if (!directory_.empty() && directory_.back() != '/' && directory_.back() != '\\') directory_ += '/';
+    levelCount_ = levelCount;
+
+    Logger::Info("Terrain opened: " + directory + ", " + std::to_string(levelCount_) + " levels, " +
+                 std::to_string(windowSize_ * windowSize_) + " tile slots");
+    return true;
+}
+
+bool TerrainRenderer::CreateGrid() {
+    const UINT resolution = settings_.gridResolution;
+    std::vector<XMFLOAT2> vertices;
+    vertices.reserve((resolution + 1) * (resolution + 1));
+    for (UINT z = 0; z <= resolution; ++z) {
+        for (UINT x = 0; x <= resolution; ++x) {
+            vertices.emplace_back(static_cast<float>(x) / resolution, static_cast<float>(z) / resolution);
+        }
+    }
+
+    // Split along the same diagonal as HeightfieldCollider, so leaves match the collision
+    std::vector<uint32_t> indices;
+    indices.reserve(resolution * resolution * 6);
+    for (UINT z = 0; z < resolution; ++z) {
+        for (UINT x = 0; x < resolution; ++x) {
+            uint32_t p00 = z * (resolution + 1) + x;
+            uint32_t p10 = p00 + 1;
+            uint32_t p01 = p00 + resolution + 1;
+            uint32_t p11 = p01 + 1;
+            indices.insert(indices.end(), { p00, p01, p11, p00, p11, p10 });
+        }
+    }
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.ByteWidth = static_cast<UINT>(vertices.size() * sizeof(XMFLOAT2));
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    D3D11_SUBRESOURCE_DATA data = { vertices.data(), 0, 0 };
+    if (FAILED(device_->CreateBuffer(&desc, &data, &gridVertices_))) return false;
+
+    desc.ByteWidth = static_cast<UINT>(indices.size() * sizeof(uint32_t));
+    desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    data.pSysMem = indices.data();
+    if (FAILED(device_->CreateBuffer(&desc, &data, &gridIndices_))) return false;
+    gridIndexCount_ = static_cast<UINT>(indices.size());
+    return true;
+}
+
+bool TerrainRenderer::CreateHeightArray() {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = settings_.tileSamples;
+    desc.Height = settings_.tileSamples;
+    desc.MipLevels = 1;
+    desc.ArraySize = windowSize_ * windowSize_;
+    desc.Format = DXGI_FORMAT_R16_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &heightArray_))) return false;
+    return SUCCEEDED(device_->CreateShaderResourceView(heightArray_, nullptr, &heightView_));
+}
+
+void TerrainRenderer::Close() {
+    for (auto& entry : tiles_) {
+        UnloadTile(entry.second);
+    }
+    tiles_.clear();
+    selected_.clear();
+    stats_ = Stats();
+    levelCount_ = 0;
+
+    SafeRelease(heightView_);
+    SafeRelease(heightArray_);
+    SafeRelease(gridIndices_);
+    SafeRelease(gridVertices_);
+    gridIndexCount_ = 0;
+
+    // Loads already on the loader thread finish and are dropped by FinishLoads()
+    std::lock_guard<std::mutex> lock(loadQueueMutex_);
+    loadQueue_.clear();
+    ++generation_;
+}
+
+UINT TerrainRenderer::GetSlot(int32_t x, int32_t z) const {
+    const int32_t size = static_cast<int32_t>(windowSize_);
+    return static_cast<UINT>(((x % size + size) % size) + ((z % size + size) % size) * size);
+}
+
+void TerrainRenderer::Update(const XMFLOAT3& cameraPosition) {
+    if (!IsOpen()) return;
+    NEXUS_PROFILE_SCOPE("TerrainRenderer::Update");
+
+    const float tileSize = GetTileSize();
+    const int32_t centerX = FloorDiv(cameraPosition.x, tileSize);
+    const int32_t centerZ = FloorDiv(cameraPosition.z, tileSize);
+    const int32_t radius = static_cast<int32_t>(settings_.streamRadius);
+
+    // Tiles that left the window give their slots to the ones that entered it
+    for (auto it = tiles_.begin(); it != tiles_.end();) {
+        Tile& tile = it->second;
+        if (std::abs(tile.x - centerX) > radius || std::abs(tile.z - centerZ) > radius) {
+            UnloadTile(tile);
+            it = tiles_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (int32_t z = centerZ - radius; z <= centerZ + radius; ++z) {
+        for (int32_t x = centerX - radius; x <= centerX + radius; ++x) {
+            uint64_t key = GetTileKey(x, z);
+            if (tiles_.count(key)) continue;
+
+            Tile& tile = tiles_[key];
+            tile.x = x;
+            tile.z = z;
+            tile.slot = GetSlot(x, z);
+
+            auto load = std::make_shared<TileLoad>();
+            load->x = x;
+            load->z = z;
+            load->generation = generation_;
+            load->path = directory_ + std::to_string(x) + "_" + std::to_string(z) + ".r16";
+            load->settings = settings_;
+            load->levelCount = levelCount_;
+            {
+                std::lock_guard<std::mutex> lock(loadQueueMutex_);
+                loadQueue_.push_back(std::move(load));
+            }
+            loadQueueCondition_.notify_one();
+        }
+    }
+
+    FinishLoads();
+
+    stats_.residentTiles = 0;
+    stats_.loadingTiles = 0;
+    for (const auto& entry : tiles_) {
+        if (entry.second.state == TileState::Resident) stats_.residentTiles++;
+        if (entry.second.state == TileState::Loading) stats_.loadingTiles++;
+    }
+}
+
+void TerrainRenderer::FinishLoads() {
+    std::vector<std::shared_ptr<TileLoad>> loads;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex_);
+        loads.swap(completedLoads_);
+    }
+
+    std::vector<std::shared_ptr<TileLoad>> deferred;
+    UINT uploads = 0;
+    for (std::shared_ptr<TileLoad>& load : loads) {
+        if (load->generation != generation_) continue;
+        auto it = tiles_.find(GetTileKey(load->x, load->z));
+        if (it == tiles_.end() || it->second.state != TileState::Loading) continue;
+
+        if (load->failed) {
+            it->second.state = TileState::Missing;
+        } else if (uploads < settings_.uploadsPerFrame) {
+            MakeResident(*load, it->second);
+            ++uploads;
+        } else {
+            deferred.push_back(std::move(load));
+        }
+    }
+
+    if (!deferred.empty()) {
+        std::lock_guard<std::mutex> lock(completedMutex_);
+        completedLoads_.insert(completedLoads_.begin(), deferred.begin(), deferred.end());
+    }
+}
+
+void TerrainRenderer::MakeResident(TileLoad& load, Tile& tile) {
+    const UINT samples = settings_.tileSamples;
+    context_->UpdateSubresource(heightArray_, D3D11CalcSubresource(0, tile.slot, 1), nullptr, load.samples.data(),
+                                samples * sizeof(uint16_t), 0);
+
+    if (physics_) {
+        const float tileSize = GetTileSize();
+        tile.colliderId = physics_->AddHeightfield(std::move(load.collider),
+                                                   PhysicsVector3(tile.x * tileSize, 0.0f, tile.z * tileSize),
+                                                   PhysicsVector3(1.0f, 1.0f, 1.0f));
+    }
+    tile.heightRanges = std::move(load.heightRanges);
+    tile.state = TileState::Resident;
+}
+
+void TerrainRenderer::UnloadTile(Tile& tile) {
+    if (physics_ && tile.colliderId != 0) {
+        physics_->RemoveStaticCollider(tile.colliderId);
+    }
+    tile.colliderId = 0;
+    tile.heightRanges.clear();
+}
+
+void TerrainRenderer::LoaderThread() {
+    for (;;) {
+        std::shared_ptr<TileLoad> load;
+        {
+            std::unique_lock<std::mutex> lock(loadQueueMutex_);
+            loadQueueCondition_.wait(lock, [this] { return shutdownRequested_ || !loadQueue_.empty(); });
+            if (shutdownRequested_) return;
+            load = std::move(loadQueue_.front());
+            loadQueue_.pop_front();
+        }
+
+        ReadTile(*load);
+
+        std::lock_guard<std::mutex> lock(completedMutex_);
+        completedLoads_.push_back(std::move(load));
+    }
+}
+
+void TerrainRenderer::ReadTile(TileLoad& load) {
+    const Settings& settings = load.settings;
+    const UINT samples = settings.tileSamples;
+
+    // Missing tiles are holes in the terrain, not errors
+    std::ifstream file(load.path, std::ios::binary);
+    load.samples.resize(static_cast<size_t>(samples) * samples);
+    if (!file || !file.read(reinterpret_cast<char*>(load.samples.data()), load.samples.size() * sizeof(uint16_t))) {
+        load.failed = true;
+        load.samples.clear();
+        return;
+    }
+
+    std::vector<float> heights(load.samples.size());
+    for (size_t i = 0; i < heights.size(); ++i) {
+        heights[i] = load.samples[i] * (settings.heightScale / 65535.0f) + settings.heightOffset;
+    }
+
+    auto collider = std::make_shared<HeightfieldCollider>();
+    if (!collider->Build(heights.data(), samples, samples, settings.cellSize)) {
+        load.failed = true;
+        return;
+    }
+    load.collider = std::move(collider);
+
+    // Height range of every quadtree node, leaves from the samples (edges included, since
+    // neighbours share them) and each coarser level from its four children
+    load.heightRanges.resize(load.levelCount);
+    const UINT leaves = 1u << (load.levelCount - 1);
+    const UINT leafCells = (samples - 1) / leaves;
+    std::vector<XMFLOAT2>& leafRanges = load.heightRanges[0];
+    leafRanges.assign(static_cast<size_t>(leaves) * leaves, XMFLOAT2(FLT_MAX, -FLT_MAX));
+    for (UINT nodeZ = 0; nodeZ < leaves; ++nodeZ) {
+        for (UINT nodeX = 0; nodeX < leaves; ++nodeX) {
+            XMFLOAT2& range = leafRanges[nodeZ * leaves + nodeX];
+            for (UINT z = nodeZ * leafCells; z <= (nodeZ + 1) * leafCells; ++z) {
+                for (UINT x = nodeX * leafCells; x <= (nodeX + 1) * leafCells; ++x) {
+                    float height = heights[static_cast<size_t>(z) * samples + x];
+                    range.x = std::min(range.x, height);
+                    range.y = std::max(range.y, height);
+                }
+            }
+        }
+    }
+    for (UINT level = 1; level < load.levelCount; ++level) {
+        const UINT count = leaves >> level;
+        const std::vector<XMFLOAT2>& children = load.heightRanges[level - 1];
+        std::vector<XMFLOAT2>& ranges = load.heightRanges[level];
+        ranges.resize(static_cast<size_t>(count) * count);
+        for (UINT nodeZ = 0; nodeZ < count; ++nodeZ) {
+            for (UINT nodeX = 0; nodeX < count; ++nodeX) {
+                XMFLOAT2 range(FLT_MAX, -FLT_MAX);
+                for (UINT child = 0; child < 4; ++child) {
+                    const XMFLOAT2& c = children[(nodeZ * 2 + (child >> 1)) * count * 2 + nodeX * 2 + (child & 1)];
+                    range.x = std::min(range.x, c.x);
+                    range.y = std::max(range.y, c.y);
+                }
+                ranges[nodeZ * count + nodeX] = range;
+            }
+        }
+    }
+}
+
+bool TerrainRenderer::SelectNode(const Tile& tile, UINT level, UINT nodeX, UINT nodeZ, const Frustum& frustum,
+                                 const XMFLOAT3& cameraPosition) {
+    const UINT count = 1u << (levelCount_ - 1 - level);
+    const float tileSize = GetTileSize();
+    const float size = tileSize / count;
+    const XMFLOAT2& heights = tile.heightRanges[level][nodeZ * count + nodeX];
+    Node node = { tile.x * tileSize + nodeX * size, tile.z * tileSize + nodeZ * size, size, level, &tile };
+    AABB box = { { node.x, heights.x, node.z }, { node.x + size, heights.y, node.z + size } };
+
+    if (!InRange(box, cameraPosition, ranges_[level])) return false;
+    if (!frustum.Intersects(box)) return true;
+
+    if (level == 0 || !InRange(box, cameraPosition, ranges_[level - 1])) {
+        selected_.push_back(node);
+        return true;
+    }
+
+    // Children beyond the finer range are still drawn at their own size; every vertex is past
+    // that level's morph range, so the patch is fully morphed to this node's grid
+    for (UINT child = 0; child < 4; ++child) {
+        UINT childX = nodeX * 2 + (child & 1);
+        UINT childZ = nodeZ * 2 + (child >> 1);
+        if (!SelectNode(tile, level - 1, childX, childZ, frustum, cameraPosition)) {
+            selected_.push_back({ tile.x * tileSize + childX * size * 0.5f, tile.z * tileSize + childZ * size * 0.5f,
+                                  size * 0.5f, level - 1, &tile });
+        }
+    }
+    return true;
+}
+
+void TerrainRenderer::Render(CXMMATRIX viewProjection, CXMMATRIX lightViewProjection, const XMFLOAT3& cameraPosition) {
+    stats_.nodes = 0;
+    if (!IsOpen()) return;
+    NEXUS_PROFILE_SCOPE("TerrainRenderer::Render");
+
+    Frustum frustum = Frustum::FromViewProjection(viewProjection);
+    selected_.clear();
+    for (const auto& entry : tiles_) {
+        if (entry.second.state == TileState::Resident) {
+            SelectNode(entry.second, levelCount_ - 1, 0, 0, frustum, cameraPosition);
+        }
+    }
+    if (selected_.empty()) return;
+
+    const UINT nodeCount = static_cast<UINT>(std::min<size_t>(selected_.size(), MAX_NODES));
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(nodeBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    GpuNode* nodes = static_cast<GpuNode*>(mapped.pData);
+    const float tileSize = GetTileSize();
+    for (UINT i = 0; i < nodeCount; ++i) {
+        const Node& node = selected_[i];
+        nodes[i] = { { node.x, node.z }, node.size, node.level,
+                     { node.tile->x * tileSize, node.tile->z * tileSize }, node.tile->slot, 0 };
+    }
+    context_->Unmap(nodeBuffer_, 0);
+
+    GpuTerrainConstants constants = {};
+    XMStoreFloat4x4(&constants.viewProjection, XMMatrixTranspose(viewProjection));
+    XMStoreFloat4x4(&constants.lightViewProjection, XMMatrixTranspose(lightViewProjection));
+    constants.cameraPosition = cameraPosition;
+    constants.cellSize = settings_.cellSize;
+    constants.heightScale = settings_.heightScale;
+    constants.heightOffset = settings_.heightOffset;
+    constants.textureScale = settings_.textureScale;
+    constants.gridResolution = static_cast<float>(settings_.gridResolution);
+    constants.tileSamples = static_cast<float>(settings_.tileSamples);
+    for (UINT level = 0; level < levelCount_; ++level) {
+        if (level + 1 == levelCount_) {
+            constants.morphRanges[level] = XMFLOAT4(FLT_MAX, 0.0f, 0.0f, 0.0f);
+            continue;
+        }
+        float end = ranges_[level];
+        float start = end - (end - (level > 0 ? ranges_[level - 1] : 0.0f)) * settings_.morphRatio;
+        constants.morphRanges[level] = XMFLOAT4(start, 1.0f / std::max(end - start, 1e-3f), 0.0f, 0.0f);
+    }
+    if (SUCCEEDED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        std::memcpy(mapped.pData, &constants, sizeof(constants));
+        context_->Unmap(constants_, 0);
+    }
+
+    UINT stride = sizeof(XMFLOAT2);
+    UINT offset = 0;
+    ID3D11ShaderResourceView* views[] = { heightView_, nodeView_ };
+    context_->IASetInputLayout(inputLayout_);
+    context_->IASetVertexBuffers(0, 1, &gridVertices_, &stride, &offset);
+    context_->IASetIndexBuffer(gridIndices_, DXGI_FORMAT_R32_UINT, 0);
+    context_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context_->VSSetShader(vertexShader_, nullptr, 0);
+    context_->VSSetConstantBuffers(0, 1, &constants_);
+    context_->VSSetShaderResources(0, 2, views);
+    context_->VSSetSamplers(0, 1, &linearClamp_);
+    context_->DrawIndexedInstanced(gridIndexCount_, nodeCount, 0, 0, 0);
+
+    ID3D11ShaderResourceView* nullViews[2] = {};
+    context_->VSSetShaderResources(0, 2, nullViews);
+    stats_.nodes = nodeCount;
+}
+
+} // namespace Nexus
@@ -1,23 +1,213 @@
 #include "TextRenderer.h"
 #include "Logger.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StateCache.h"
 #include <d3d11.h>
 #include <DirectXMath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace Nexus {
 
-TextRenderer::TextRenderer() : device_(nullptr), context_(nullptr), initialized_(false) {}
+namespace {
+
+// Printable ASCII as strokes on a grid of digits: x 0-6, y 0-9 with the baseline at 2, the x
+// height at 6 and capitals reaching 9. Each space-separated stroke is a polyline of "xy" pairs,
+// a lone pair is a dot
+const char* const GLYPH_STROKES[] = {
+    "", "3934 32", "2927 4947", "2922 4942 1767 0454", "574818070615455453421203 3931", "0269 18 53",
+    "621718293948470403123265", "3937", "49383342", "29383322", "3834 1755 1557", "3632 1454", "3321", "1454",
+    "32", "1259", "195968635212030819", "183932 1252", "08195968670262", "0819596867566563521203 2656",
+    "490464 4942", "690906566563521203", "59190803125263655606", "096932",
+    "195968675616070819 165665635212030516", "1252636859190807165667", "36 33", "36 3321", "561452",
+    "1555 1353", "165412", "08195968673534 32", "5546353443535563 6859190803125262", "023962 1454",
+    "02094958574606 4655534202", "6859190803125263", "02094967644202", "69090262 0646", "690902 0646",
+    "68591908031252636545", "0902 6962 0666", "1959 3932 1252", "6963521203", "0902 6904 2662", "090262",
+    "0209356962", "02096269", "195968635212030819", "02094958564505", "195968635212030819 3461",
+    "02094958564505 3562", "685919080716566563521203", "0969 3932", "090312526369", "093269", "0912355269",
+    "0962 6902", "093669 3632", "09690262", "49292242", "1952", "29494222", "163956", "0060", "2938",
+    "16465552 541403124253", "0902 0516465553421203", "5546160503124253", "5952 5546160503124253",
+    "04545546160503124253", "5849291812 0646", "5546160504134354 5651401001", "0902 0516465552",
+    "163632 1252 38", "264641301001 48", "0902 5603 2452", "1939334252", "0602 0516263532 3546566562",
+    "0602 0516465552", "164655534212030516", "0600 0516465553421203", "5650 5546160503124253", "0602 04264655",
+    "55461605144453421203", "1813224253 0646", "0603124253 5652", "063266", "0612355266", "0652 5602",
+    "0632 6610", "06560252", "49383625343342", "3931", "29383645343322", "14254455"
+};
+
+constexpr int FIRST_GLYPH = 32;
+constexpr int GLYPH_COUNT = sizeof(GLYPH_STROKES) / sizeof(GLYPH_STROKES[0]);
+constexpr int ATLAS_COLUMNS = 16;
+constexpr int ATLAS_ROWS = (GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+
+// Every glyph cell spans 9 x 12 grid units around the stroke grid, 24 x 32 texels
+constexpr int CELL_WIDTH = 24;
+constexpr int CELL_HEIGHT = 32;
+constexpr float CELL_LEFT = -1.5f;          // Grid x at the cell's left edge
+constexpr float CELL_TOP = 10.5f;           // Grid y at the cell's top edge
+constexpr float CELL_UNITS_X = 9.0f;
+constexpr float CELL_UNITS_Y = 12.0f;
+constexpr float ADVANCE_UNITS = 7.0f;
+constexpr float STROKE_RADIUS = 0.55f;      // Grid units
+constexpr float DISTANCE_RANGE = 1.5f;      // Grid units either side of the edge the atlas resolves
+constexpr float LINE_HEIGHT = 16.0f;        // Pixels at scale 1, one cell height
+
+constexpr size_t MIN_GLYPH_CAPACITY = 256;
+constexpr size_t MAX_GLYPHS = 65536 / 4;    // 16-bit indices
+
+const char* TEXT_VS = R"(
+cbuffer TextConstants : register(b0) {
+    float2 PixelToClip;
+    float2 Padding;
+};
+
+struct VSInput {
+    float2 position : POSITION;
+    float2 texCoord : TEXCOORD0;
+    float4 color : COLOR0;
+};
+
+struct VSOutput {
+    float4 position : SV_Position;
+    float2 texCoord : TEXCOORD0;
+    float4 color : COLOR0;
+};
+
+VSOutput main(VSInput input) {
+    VSOutput output;
+    output.position = float4(input.position * PixelToClip + float2(-1.0, 1.0), 0.0, 1.0);
+    output.texCoord = input.texCoord;
+    output.color = input.color;
+    return output;
+}
+)";
+
+const char* TEXT_PS = R"(
+Texture2D<float> Atlas : register(t0);
+SamplerState LinearClamp : register(s0);
+
+struct PSInput {
+    float4 position : SV_Position;
+    float2 texCoord : TEXCOORD0;
+    float4 color : COLOR0;
+};
+
+float4 main(PSInput input) : SV_Target {
+    // Antialias over about one pixel whatever the scale
+    float distance = Atlas.Sample(LinearClamp, input.texCoord);
+    float width = max(fwidth(distance) * 0.7, 1e-4);
+    float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+    return float4(input.color.rgb, input.color.a * coverage);
+}
+)";
+
+float SegmentDistance(float px, float py, float ax, float ay, float bx, float by) {
+    float dx = bx - ax;
+    float dy = by - ay;
+    float lengthSquared = dx * dx + dy * dy;
+    float t = lengthSquared > 0.0f ? std::clamp(((px - ax) * dx + (py - ay) * dy) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+    return std::hypot(px - ax - t * dx, py - ay - t * dy);
+}
+
+uint32_t PackColor(const DirectX::XMFLOAT4& color) {
+    auto channel = [](float value) { return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return channel(color.x) | (channel(color.y) << 8) | (channel(color.z) << 16) | (channel(color.w) << 24);
+}
+
+// Calls emit with the quad of every visible glyph of text laid out from (x, y)
+template<typename Emit>
+void ForEachGlyph(const char* text, float x, float y, float scale, Emit emit) {
+    const float unit = LINE_HEIGHT * scale / CELL_UNITS_Y;
+    const float cellU = 1.0f / ATLAS_COLUMNS;
+    const float cellV = 1.0f / ATLAS_ROWS;
+    
+    TextRenderer::GlyphQuad quad;
+    quad.width = CELL_UNITS_X * unit;
+    quad.height = CELL_UNITS_Y * unit;
+    float penX = x;
+    float penY = y;
+    for (const char* c = text; *c; ++c) {
+        if (*c == '\n') {
+            penX = x;
+            penY += quad.height;
+            continue;
+        }
+        int glyph = static_cast<unsigned char>(*c) - FIRST_GLYPH;
+        if (glyph < 0 || glyph >= GLYPH_COUNT) {
+            glyph = '?' - FIRST_GLYPH;
+        }
+        if (glyph > 0) {
+            quad.left = penX + CELL_LEFT * unit;
+            quad.top = penY;
+            quad.u0 = (glyph % ATLAS_COLUMNS) * cellU;
+            quad.v0 = (glyph / ATLAS_COLUMNS) * cellV;
+            quad.u1 = quad.u0 + cellU;
+            quad.v1 = quad.v0 + cellV;
+            emit(quad);
+        }
+        penX += ADVANCE_UNITS * unit;
+    }
+}
+
+ID3DBlob* CompileShader(const char* source, const char* name, const char* target) {
+    ID3DBlob* blob = nullptr;
+    std::string errors;
+    HRESULT hr = ShaderCache::Compile(source, name, "main", target, 0, &blob, &errors);
+    if (FAILED(hr)) {
+        if (!errors.empty()) {
+            Logger::Error(std::string(name) + " compilation error: " + errors);
+        }
+        return nullptr;
+    }
+    return blob;
+}
+
+template<typename T>
+void SafeRelease(T*& object) {
+    if (object) { object->Release(); object = nullptr; }
+}
+
+} // namespace
+
+TextRenderer::TextRenderer()
+    : device_(nullptr)
+    , context_(nullptr)
+    , stateCache_(nullptr)
+    , fontTexture_(nullptr)
+    , vertexShader_(nullptr)
+    , pixelShader_(nullptr)
+    , inputLayout_(nullptr)
+    , constants_(nullptr)
+    , linearClamp_(nullptr)
+    , blendState_(nullptr)
+    , rasterizerState_(nullptr)
+    , depthState_(nullptr)
+    , vertexBuffer_(nullptr)
+    , indexBuffer_(nullptr)
+    , capacity_(0)
+    , initialized_(false)
+{
+}
 
 TextRenderer::~TextRenderer() {
     Shutdown();
 }
 
-bool TextRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+bool TextRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, StateCache* stateCache) {
+    if (!device || !context || !stateCache) return false;
     device_ = device;
     context_ = context;
+    stateCache_ = stateCache;
     
-    // Create a simple bitmap font (for demo purposes)
     if (!CreateBitmapFont()) {
         Logger::Error("Failed to create bitmap font");
+        Shutdown();
+        return false;
+    }
+    if (!CreatePipeline() || !EnsureCapacity(MIN_GLYPH_CAPACITY)) {
+        Logger::Error("Failed to create text pipeline");
+        Shutdown();
         return false;
     }
     
@@ -27,27 +217,139 @@ bool TextRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
 }
 
 void TextRenderer::Shutdown() {
-    if (fontTexture_) {
-        fontTexture_->Release();
-        fontTexture_ = nullptr;
-    }
+    SafeRelease(fontTexture_);
+    SafeRelease(vertexShader_);
+    SafeRelease(pixelShader_);
+    SafeRelease(inputLayout_);
+    SafeRelease(constants_);
+    SafeRelease(linearClamp_);
+    SafeRelease(blendState_);
+    SafeRelease(rasterizerState_);
+    SafeRelease(depthState_);
+    SafeRelease(vertexBuffer_);
+    SafeRelease(indexBuffer_);
+    capacity_ = 0;
+    vertices_.clear();
     initialized_ = false;
 }
 
 void TextRenderer::RenderText(const std::string& text, float x, float y, float scale, const DirectX::XMFLOAT4& color) {
-    if (!initialized_) return;
+    RenderText(text.c_str(), x, y, scale, color);
+}
+
+void TextRenderer::RenderText(const char* text, float x, float y, float scale, const DirectX::XMFLOAT4& color) {
+    if (!initialized_ || !text) return;
     
-    // Simple text rendering - for now just log the text
-    Logger::Info("Rendering text: " + text + " at (" + std::to_string(x) + ", " + std::to_string(y) + ")");
+    const uint32_t packed = PackColor(color);
+    ForEachGlyph(text, x, y, scale, [&](const GlyphQuad& quad) {
+        const float right = quad.left + quad.width;
+        const float bottom = quad.top + quad.height;
+        vertices_.push_back({ DirectX::XMFLOAT2(quad.left, quad.top), DirectX::XMFLOAT2(quad.u0, quad.v0), packed });
+        vertices_.push_back({ DirectX::XMFLOAT2(right, quad.top), DirectX::XMFLOAT2(quad.u1, quad.v0), packed });
+        vertices_.push_back({ DirectX::XMFLOAT2(quad.left, bottom), DirectX::XMFLOAT2(quad.u0, quad.v1), packed });
+        vertices_.push_back({ DirectX::XMFLOAT2(right, bottom), DirectX::XMFLOAT2(quad.u1, quad.v1), packed });
+    });
+}
+
+void TextRenderer::LayoutText(const char* text, float x, float y, float scale, std::vector<GlyphQuad>& quads) {
+    if (!text) return;
+    ForEachGlyph(text, x, y, scale, [&](const GlyphQuad& quad) { quads.push_back(quad); });
+}
+
+void TextRenderer::Flush(UINT width, UINT height) {
+    if (vertices_.empty()) return;
+    if (!initialized_ || width == 0 || height == 0) {
+        vertices_.clear();
+        return;
+    }
+    NEXUS_PROFILE_SCOPE("TextRenderer::Flush");
+    
+    // Whatever does not fit one draw's 16-bit indices is dropped
+    size_t glyphs = std::min(vertices_.size() / 4, MAX_GLYPHS);
+    if (!EnsureCapacity(glyphs)) {
+        vertices_.clear();
+        return;
+    }
+    
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context_->Map(vertexBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        Logger::Error("Failed to map text vertex buffer");
+        vertices_.clear();
+        return;
+    }
+    std::memcpy(mapped.pData, vertices_.data(), glyphs * 4 * sizeof(GlyphVertex));
+    context_->Unmap(vertexBuffer_, 0);
+    vertices_.clear();
+    
+    if (FAILED(context_->Map(constants_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    float pixelToClip[4] = { 2.0f / width, -2.0f / height, 0.0f, 0.0f };
+    std::memcpy(mapped.pData, pixelToClip, sizeof(pixelToClip));
+    context_->Unmap(constants_, 0);
+    
+    UINT stride = sizeof(GlyphVertex);
+    UINT offset = 0;
+    stateCache_->IASetInputLayout(inputLayout_);
+    stateCache_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    stateCache_->IASetVertexBuffers(0, 1, &vertexBuffer_, &stride, &offset);
+    stateCache_->IASetIndexBuffer(indexBuffer_, DXGI_FORMAT_R16_UINT, 0);
+    stateCache_->VSSetShader(vertexShader_);
+    stateCache_->PSSetShader(pixelShader_);
+    stateCache_->VSSetConstantBuffers(0, 1, &constants_);
+    stateCache_->PSSetShaderResources(0, 1, &fontTexture_);
+    stateCache_->PSSetSamplers(0, 1, &linearClamp_);
+    stateCache_->RSSetState(rasterizerState_);
+    stateCache_->OMSetBlendState(blendState_, nullptr, 0xffffffff);
+    stateCache_->OMSetDepthStencilState(depthState_, 0);
+    context_->DrawIndexed(static_cast<UINT>(glyphs * 6), 0, 0);
 }
 
 bool TextRenderer::CreateBitmapFont() {
-    // Create a simple 8x8 pixel font texture (placeholder)
-    const int width = 128;
-    const int height = 128;
-    const int channels = 4;
+    // Distance to the nearest stroke, offset by the stroke radius and stored with the edge at 0.5
+    const int width = ATLAS_COLUMNS * CELL_WIDTH;
+    const int height = ATLAS_ROWS * CELL_HEIGHT;
+    const float unitsPerTexel = CELL_UNITS_X / CELL_WIDTH;
+    std::vector<unsigned char> fontData(width * height, 0);
     
-    std::vector<unsigned char> fontData(width * height * channels, 255);
+    std::vector<float> segments;  // ax, ay, bx, by
+    for (int glyph = 0; glyph < GLYPH_COUNT; ++glyph) {
+        segments.clear();
+        const char* stroke = GLYPH_STROKES[glyph];
+        while (*stroke) {
+            const char* end = std::strchr(stroke, ' ');
+            if (!end) end = stroke + std::strlen(stroke);
+            float previousX = static_cast<float>(stroke[0] - '0');
+            float previousY = static_cast<float>(stroke[1] - '0');
+            if (end - stroke == 2) {
+                segments.insert(segments.end(), { previousX, previousY, previousX, previousY });
+            }
+            for (const char* point = stroke + 2; point + 1 < end; point += 2) {
+                float x = static_cast<float>(point[0] - '0');
+                float y = static_cast<float>(point[1] - '0');
+                segments.insert(segments.end(), { previousX, previousY, x, y });
+                previousX = x;
+                previousY = y;
+            }
+            stroke = *end ? end + 1 : end;
+        }
+        if (segments.empty()) continue;
+        
+        int cellX = (glyph % ATLAS_COLUMNS) * CELL_WIDTH;
+        int cellY = (glyph / ATLAS_COLUMNS) * CELL_HEIGHT;
+        for (int y = 0; y < CELL_HEIGHT; ++y) {
+            float gridY = CELL_TOP - (y + 0.5f) * unitsPerTexel;
+            for (int x = 0; x < CELL_WIDTH; ++x) {
+                float gridX = CELL_LEFT + (x + 0.5f) * unitsPerTexel;
+                float distance = CELL_UNITS_X;
+                for (size_t s = 0; s < segments.size(); s += 4) {
+                    distance = std::min(distance, SegmentDistance(gridX, gridY, segments[s], segments[s + 1],
+                                                                  segments[s + 2], segments[s + 3]));
+                }
+                float value = 0.5f - (distance - STROKE_RADIUS) / (2.0f * DISTANCE_RANGE);
+                fontData[(cellY + y) * width + cellX + x] =
+                    static_cast<unsigned char>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    }
     
     // Create texture
     D3D11_TEXTURE2D_DESC textureDesc = {};
@@ -55,17 +357,17 @@ bool TextRenderer::CreateBitmapFont() {
     textureDesc.Height = height;
     textureDesc.MipLevels = 1;
     textureDesc.ArraySize = 1;
-    textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    textureDesc.Format = DXGI_FORMAT_R8_UNORM;
     textureDesc.SampleDesc.Count = 1;
     textureDesc.SampleDesc.Quality = 0;
-    textureDesc.Usage = D3D11_USAGE_DEFAULT;
+    textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
     textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
     textureDesc.CPUAccessFlags = 0;
     textureDesc.MiscFlags = 0;
     
     D3D11_SUBRESOURCE_DATA textureData = {};
     textureData.pSysMem = fontData.data();
-    textureData.SysMemPitch = width * channels;
+    textureData.SysMemPitch = width;
     textureData.SysMemSlicePitch = 0;
     
     ID3D11Texture2D* texture = nullptr;
@@ -93,4 +395,113 @@ bool TextRenderer::CreateBitmapFont() {
     return true;
 }
 
-}
\ No newline at end of file
+bool TextRenderer::CreatePipeline() {
+    ID3DBlob* blob = CompileShader(TEXT_VS, "Text_VS", "vs_5_0");
+    if (!blob) return false;
+    HRESULT hr = device_->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &vertexShader_);
+    if (SUCCEEDED(hr)) {
+        D3D11_INPUT_ELEMENT_DESC layout[] = {
+            { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        };
+        hr = device_->CreateInputLayout(layout, 3, blob->GetBufferPointer(), blob->GetBufferSize(), &inputLayout_);
+    }
+    blob->Release();
+    if (FAILED(hr)) return false;
+    
+    blob = CompileShader(TEXT_PS, "Text_PS", "ps_5_0");
+    if (!blob) return false;
+    hr = device_->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &pixelShader_);
+    blob->Release();
+    if (FAILED(hr)) return false;
+    
+    D3D11_BUFFER_DESC constantDesc = {};
+    constantDesc.ByteWidth = 16;
+    constantDesc.Usage = D3D11_USAGE_DYNAMIC;
+    constantDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constantDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&constantDesc, nullptr, &constants_))) return false;
+    
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (FAILED(device_->CreateSamplerState(&samplerDesc, &linearClamp_))) return false;
+    
+    // Straight alpha over the target, accumulating coverage in its alpha
+    D3D11_BLEND_DESC blendDesc = {};
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    if (FAILED(device_->CreateBlendState(&blendDesc, &blendState_))) return false;
+    
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    if (FAILED(device_->CreateRasterizerState(&rasterizerDesc, &rasterizerState_))) return false;
+    
+    // Text goes over everything, whether or not a depth buffer is still bound
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = FALSE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+    return SUCCEEDED(device_->CreateDepthStencilState(&depthDesc, &depthState_));
+}
+
+bool TextRenderer::EnsureCapacity(size_t glyphs) {
+    if (glyphs <= capacity_) return true;
+    
+    size_t capacity = std::min(std::max(glyphs, std::max(capacity_ * 2, MIN_GLYPH_CAPACITY)), MAX_GLYPHS);
+    SafeRelease(vertexBuffer_);
+    SafeRelease(indexBuffer_);
+    capacity_ = 0;
+    
+    D3D11_BUFFER_DESC vertexDesc = {};
+    vertexDesc.ByteWidth = static_cast<UINT>(capacity * 4 * sizeof(GlyphVertex));
+    vertexDesc.Usage = D3D11_USAGE_DYNAMIC;
+    vertexDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    vertexDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateBuffer(&vertexDesc, nullptr, &vertexBuffer_))) {
+        Logger::Error("Failed to create text vertex buffer");
+        return false;
+    }
+    
+    // Every glyph is the same two triangles over its own four vertices
+    std::vector<uint16_t> indices(capacity * 6);
+    for (size_t glyph = 0; glyph < capacity; ++glyph) {
+        uint16_t base = static_cast<uint16_t>(glyph * 4);
+        uint16_t* quad = &indices[glyph * 6];
+        quad[0] = base;
+        quad[1] = base + 1;
+        quad[2] = base + 2;
+        quad[3] = base + 2;
+        quad[4] = base + 1;
+        quad[5] = base + 3;
+    }
+    D3D11_BUFFER_DESC indexDesc = {};
+    indexDesc.ByteWidth = static_cast<UINT>(indices.size() * sizeof(uint16_t));
+    indexDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    indexDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    D3D11_SUBRESOURCE_DATA indexData = {};
+    indexData.pSysMem = indices.data();
+    if (FAILED(device_->CreateBuffer(&indexDesc, &indexData, &indexBuffer_))) {
+        Logger::Error("Failed to create text index buffer");
+        SafeRelease(vertexBuffer_);
+        return false;
+    }
+    
+    capacity_ = capacity;
+    return true;
+}
+
+}
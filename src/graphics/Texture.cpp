@@ -1,8 +1,145 @@
 #include "Texture.h"
+#include "MaterialTable.h"
+#include "TextureFile.h"
+#include "TextureStreamingEngine.h"
+#include "BlockCompressor.h"
+#include "MipGenerator.h"
+#include "MappedFile.h"
 #include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+// Decoder for images that are not GPU-ready containers
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_TGA
+#define STBI_ONLY_BMP
+#define STBI_NO_STDIO
+#include <stb/stb_image.h>
 
 namespace Nexus {
 
+namespace {
+
+int g_compressionQuality = 75;
+
+// A decoded image ready for CreateTexture2D or WriteDDS
+struct ImportedImage {
+    D3D11_TEXTURE2D_DESC desc = {};
+    std::unique_ptr<stbi_uc, void (*)(void*)> decoded{ nullptr, stbi_image_free };
+    std::vector<std::vector<uint8_t>> levels;   // Encoded (or RGBA8) mips when compressing
+    std::vector<D3D11_SUBRESOURCE_DATA> subresources;
+    bool normalMap = false;
+};
+
+BlockCompressor::Format ChooseFormat(const uint8_t* pixels, size_t count, bool normalMap, int quality, bool allowBC7) {
+    if (normalMap) return BlockCompressor::Format::BC5;
+    if (quality >= 50 && allowBC7) return BlockCompressor::Format::BC7;
+    for (size_t i = 0; i < count; ++i) {
+        if (pixels[i * 4 + 3] != 255) return BlockCompressor::Format::BC3;
+    }
+    return BlockCompressor::Format::BC1;
+}
+
+DXGI_FORMAT GetDXGIFormat(BlockCompressor::Format format) {
+    switch (format) {
+    case BlockCompressor::Format::BC1: return DXGI_FORMAT_BC1_UNORM;
+    case BlockCompressor::Format::BC3: return DXGI_FORMAT_BC3_UNORM;
+    case BlockCompressor::Format::BC4: return DXGI_FORMAT_BC4_UNORM;
+    case BlockCompressor::Format::BC5: return DXGI_FORMAT_BC5_UNORM;
+    default:                           return DXGI_FORMAT_BC7_UNORM;
+    }
+}
+
+// data is a whole image file; filename names it in messages and for the normal map hints
+bool ImportImage(const uint8_t* data, size_t size, const std::string& filename, int quality, bool allowBC7,
+                 JobSystem* jobs, ImportedImage& image) {
+    NEXUS_PROFILE_SCOPE("Texture::ImportImage");
+    if (size > static_cast<size_t>(INT_MAX)) return false;
+
+    int width = 0, height = 0, channels = 0;
+    image.decoded.reset(stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channels, 4));
+    if (!image.decoded) {
+        Logger::Error("Could not decode image " + filename + ": " + stbi_failure_reason());
+        return false;
+    }
+    const uint8_t* pixels = image.decoded.get();
+    image.normalMap = Texture::DetectNormalMap(filename, pixels, width, height);
+
+    D3D11_TEXTURE2D_DESC& desc = image.desc;
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+
+    if (quality < 0) {
+        D3D11_SUBRESOURCE_DATA subresource = {};
+        subresource.pSysMem = pixels;
+        subresource.SysMemPitch = width * 4;
+        image.subresources.push_back(subresource);
+        return true;
+    }
+
+    // BC formats need a base level that is a whole number of blocks; other sizes keep RGBA8 mips
+    const bool compress = width % 4 == 0 && height % 4 == 0;
+    const BlockCompressor::Format format =
+        ChooseFormat(pixels, static_cast<size_t>(width) * height, image.normalMap, quality, allowBC7);
+    if (compress) desc.Format = GetDXGIFormat(format);
+
+    // Colour images are authored in sRGB, so they are filtered in linear light; normal maps are
+    // renormalized per level
+    MipGenerator::Settings mipSettings;
+    mipSettings.srgb = !image.normalMap;
+    mipSettings.normalMap = image.normalMap;
+    std::vector<uint8_t> mipData;
+    std::vector<MipGenerator::Level> mips;
+    MipGenerator::Generate(pixels, width, height, mipSettings, mipData, mips, jobs);
+    desc.MipLevels = static_cast<UINT>(mips.size() + 1);
+
+    int mipWidth = width, mipHeight = height;
+    for (UINT level = 0; level < desc.MipLevels; ++level) {
+        if (level > 0) {
+            pixels = mipData.data() + mips[level - 1].offset;
+            mipWidth = mips[level - 1].width;
+            mipHeight = mips[level - 1].height;
+        }
+        if (compress) {
+            const size_t size = BlockCompressor::GetCompressedSize(format, mipWidth, mipHeight);
+            image.levels.emplace_back(size);
+            BlockCompressor::Compress(format, pixels, static_cast<size_t>(mipWidth) * 4, mipWidth, mipHeight,
+                                      image.levels.back().data(), size, quality, jobs);
+        } else {
+            image.levels.emplace_back(pixels, pixels + static_cast<size_t>(mipWidth) * mipHeight * 4);
+        }
+    }
+    // Every level now lives in levels; the decoded base is no longer needed
+    image.decoded.reset();
+
+    mipWidth = width;
+    for (const std::vector<uint8_t>& level : image.levels) {
+        D3D11_SUBRESOURCE_DATA subresource = {};
+        subresource.pSysMem = level.data();
+        UINT rowCount = 0;
+        TextureFile::GetSurfaceInfo(desc.Format, mipWidth, 1, subresource.SysMemPitch, rowCount);
+        image.subresources.push_back(subresource);
+        mipWidth = std::max(1, mipWidth / 2);
+    }
+    return true;
+}
+}
+
 // Texture implementation
 Texture::Texture()
     : texture_(nullptr)
@@ -10,6 +147,9 @@ Texture::Texture()
     , width_(0)
     , height_(0)
     , format_(DXGI_FORMAT_UNKNOWN)
+    , memoryUsage_(0)
+    , streaming_(nullptr)
+    , streamingId_(TextureStreamingEngine::INVALID_TEXTURE)
     , isNormalMap_(false)
     , hasMipMaps_(false)
     , minFilter_(D3D11_FILTER_MIN_MAG_MIP_LINEAR)
@@ -20,99 +160,206 @@ Texture::Texture()
 }
 
 Texture::~Texture() {
-    if (shaderResourceView_) { shaderResourceView_->Release(); shaderResourceView_ = nullptr; }
-    if (texture_) { texture_->Release(); texture_ = nullptr; }
+    Release();
 }
 
-bool Texture::LoadFromFile(const std::string& filename, ID3D11Device* device) {
+bool Texture::LoadFromFile(const std::string& filename, ID3D11Device* device, JobSystem* jobs) {
     if (!device) return false;
+    NEXUS_PROFILE_SCOPE("Texture::LoadFromFile");
     
     Logger::Info("Loading texture: " + filename);
-    
-    // For now, create a simple placeholder texture
-    // In a real implementation, you'd use DirectXTex or similar library
-    width_ = 256;
-    height_ = 256;
-    format_ = DXGI_FORMAT_R8G8B8A8_UNORM;
-    
-    // Create a simple 2D texture
-    D3D11_TEXTURE2D_DESC textureDesc = {};
-    textureDesc.Width = width_;
-    textureDesc.Height = height_;
-    textureDesc.MipLevels = 1;
-    textureDesc.ArraySize = 1;
-    textureDesc.Format = format_;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.Usage = D3D11_USAGE_DEFAULT;
-    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    textureDesc.CPUAccessFlags = 0;
-    
-    // Create simple checkerboard pattern
-    std::vector<uint32_t> pixels(width_ * height_);
-    for (int y = 0; y < height_; ++y) {
-        for (int x = 0; x < width_; ++x) {
-            bool checker = ((x / 32) % 2) ^ ((y / 32) % 2);
-            pixels[y * width_ + x] = checker ? 0xFFFFFFFF : 0xFF808080;
-        }
+    Release();
+
+    // GPU-ready containers upload their stored mip chain straight from the file mapping;
+    // anything else is decoded to RGBA8 first
+    MappedFile file;
+    TextureFile container;
+    bool loaded = TextureFile::IsContainer(filename)
+                      ? container.Open(filename) && LoadContainer(container, filename, device)
+                      : file.Open(filename) && LoadDecodedImage(file.GetData(), file.GetSize(), filename, device, jobs);
+    if (!loaded) {
+        Logger::Error("Failed to load texture: " + filename);
+        Release();
+        return false;
     }
     
-    D3D11_SUBRESOURCE_DATA textureData = {};
-    textureData.pSysMem = pixels.data();
-    textureData.SysMemPitch = width_ * 4;
+    Logger::Info("Texture loaded successfully: " + std::to_string(width_) + "x" + std::to_string(height_) +
+                 ", " + std::to_string(memoryUsage_ / 1024) + " KB");
+    return true;
+}
+
+bool Texture::LoadFromMemory(const void* data, size_t size, ID3D11Device* device, const std::string& name,
+                             JobSystem* jobs) {
+    if (!device || !data) return false;
+    NEXUS_PROFILE_SCOPE("Texture::LoadFromMemory");
     
-    HRESULT hr = device->CreateTexture2D(&textureDesc, &textureData, &texture_);
+    Release();
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    TextureFile container;
+    bool loaded = TextureFile::IsContainer(name)
+                      ? container.Open(bytes, size, name) && LoadContainer(container, name, device)
+                      : LoadDecodedImage(bytes, size, name, device, jobs);
+    if (!loaded) {
+        Logger::Error("Failed to load texture: " + name);
+        Release();
+        return false;
+    }
+    return true;
+}
+
+bool Texture::LoadStreaming(const std::string& filename, TextureStreamingEngine* streaming) {
+    if (!streaming) return false;
+    NEXUS_PROFILE_SCOPE("Texture::LoadStreaming");
+
+    Release();
+    const uint32_t id = streaming->LoadTexture(filename);
+    if (id == TextureStreamingEngine::INVALID_TEXTURE) {
+        Logger::Error("Failed to load streamed texture: " + filename);
+        return false;
+    }
+
+    // The engine owns the resource; only the full-resolution properties are kept here
+    streaming_ = streaming;
+    streamingId_ = id;
+    const D3D11_TEXTURE2D_DESC& desc = streaming->GetTextureDesc(id);
+    width_ = static_cast<int>(desc.Width);
+    height_ = static_cast<int>(desc.Height);
+    format_ = desc.Format;
+    hasMipMaps_ = desc.MipLevels > 1;
+    isNormalMap_ = format_ == DXGI_FORMAT_BC5_UNORM || DetectNormalMap(filename, nullptr, 0, 0);
+    return true;
+}
+
+bool Texture::LoadContainer(TextureFile& file, const std::string& filename, ID3D11Device* device) {
+    HRESULT hr = file.CreateTexture(device, &texture_, &shaderResourceView_);
     if (FAILED(hr)) {
         Logger::Error("Failed to create texture: " + filename);
         return false;
     }
+
+    const D3D11_TEXTURE2D_DESC& desc = file.GetDesc();
+    width_ = static_cast<int>(desc.Width);
+    height_ = static_cast<int>(desc.Height);
+    format_ = desc.Format;
+    hasMipMaps_ = desc.MipLevels > 1;
+    memoryUsage_ = TextureFile::ComputeMemoryUsage(desc);
+    isNormalMap_ = format_ == DXGI_FORMAT_BC5_UNORM || DetectNormalMap(filename, nullptr, 0, 0);
+    return true;
+}
+
+bool Texture::LoadDecodedImage(const uint8_t* data, size_t size, const std::string& filename, ID3D11Device* device,
+                               JobSystem* jobs) {
+    // BC7 needs feature level 11_0; older hardware gets BC1/BC3
+    ImportedImage image;
+    const bool allowBC7 = device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0;
+    if (!ImportImage(data, size, filename, g_compressionQuality, allowBC7, jobs, image)) return false;
     
-    // Create shader resource view
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = textureDesc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MostDetailedMip = 0;
-    srvDesc.Texture2D.MipLevels = 1;
+    HRESULT hr = device->CreateTexture2D(&image.desc, image.subresources.data(), &texture_);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create texture: " + filename);
+        return false;
+    }
     
+    const D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = TextureFile::GetViewDesc(image.desc);
     hr = device->CreateShaderResourceView(texture_, &srvDesc, &shaderResourceView_);
     if (FAILED(hr)) {
         Logger::Error("Failed to create shader resource view: " + filename);
         return false;
     }
-    
-    // Auto-detect normal maps
-    DetectNormalMap();
-    
-    Logger::Info("Texture loaded successfully: " + std::to_string(width_) + "x" + std::to_string(height_));
+
+    width_ = static_cast<int>(image.desc.Width);
+    height_ = static_cast<int>(image.desc.Height);
+    format_ = image.desc.Format;
+    hasMipMaps_ = image.desc.MipLevels > 1;
+    memoryUsage_ = TextureFile::ComputeMemoryUsage(image.desc);
+    isNormalMap_ = image.normalMap;
     return true;
 }
 
-bool Texture::CreateRenderTarget(int width, int height, DXGI_FORMAT format, ID3D11Device* device) {
+void Texture::SetCompressionQuality(int quality) {
+    g_compressionQuality = std::min(quality, 100);
+}
+
+int Texture::GetCompressionQuality() {
+    return g_compressionQuality;
+}
+
+bool Texture::ConvertToDDS(const std::string& source, const std::string& destination, int quality, JobSystem* jobs) {
+    NEXUS_PROFILE_SCOPE("Texture::ConvertToDDS");
+    ImportedImage image;
+    MappedFile file;
+    if (!file.Open(source) ||
+        !ImportImage(file.GetData(), file.GetSize(), source, std::min(quality, 100), true, jobs, image) ||
+        !TextureFile::WriteDDS(destination, image.desc, image.subresources.data())) {
+        Logger::Error("Failed to convert " + source + " to " + destination);
+        return false;
+    }
+    Logger::Info("Converted " + source + " to " + destination + " (" +
+                 std::to_string(TextureFile::ComputeMemoryUsage(image.desc) / 1024) + " KB)");
+    return true;
+}
+
+void Texture::Swap(Texture& other) {
+    std::swap(texture_, other.texture_);
+    std::swap(shaderResourceView_, other.shaderResourceView_);
+    std::swap(width_, other.width_);
+    std::swap(height_, other.height_);
+    std::swap(format_, other.format_);
+    std::swap(memoryUsage_, other.memoryUsage_);
+    std::swap(streaming_, other.streaming_);
+    std::swap(streamingId_, other.streamingId_);
+    std::swap(isNormalMap_, other.isNormalMap_);
+    std::swap(hasMipMaps_, other.hasMipMaps_);
+}
+
+void Texture::Release() {
+    if (streaming_) {
+        streaming_->UnloadTexture(streamingId_);
+        streaming_ = nullptr;
+        streamingId_ = TextureStreamingEngine::INVALID_TEXTURE;
+    }
+    if (shaderResourceView_) { shaderResourceView_->Release(); shaderResourceView_ = nullptr; }
+    if (texture_) { texture_->Release(); texture_ = nullptr; }
+    width_ = 0;
+    height_ = 0;
+    format_ = DXGI_FORMAT_UNKNOWN;
+    memoryUsage_ = 0;
+    hasMipMaps_ = false;
+}
+
+bool Texture::CreateRenderTarget(int width, int height, DXGI_FORMAT format, ID3D11Device* device, bool mipMaps) {
     if (!device) return false;
+    Release();
     
     D3D11_TEXTURE2D_DESC textureDesc = {};
     textureDesc.Width = width;
     textureDesc.Height = height;
-    textureDesc.MipLevels = 1;
+    // MipLevels 0 allocates the full chain, which GenerateMipMaps() fills on the GPU
+    textureDesc.MipLevels = mipMaps ? 0 : 1;
     textureDesc.ArraySize = 1;
     textureDesc.Format = format;
     textureDesc.SampleDesc.Count = 1;
     textureDesc.Usage = D3D11_USAGE_DEFAULT;
     textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
     textureDesc.CPUAccessFlags = 0;
+    textureDesc.MiscFlags = mipMaps ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0;
     
     HRESULT hr = device->CreateTexture2D(&textureDesc, nullptr, &texture_);
     if (SUCCEEDED(hr)) {
+        texture_->GetDesc(&textureDesc);
         D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
         srvDesc.Format = textureDesc.Format;
         srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
         srvDesc.Texture2D.MostDetailedMip = 0;
-        srvDesc.Texture2D.MipLevels = 1;
+        srvDesc.Texture2D.MipLevels = textureDesc.MipLevels;
         
         hr = device->CreateShaderResourceView(texture_, &srvDesc, &shaderResourceView_);
         if (SUCCEEDED(hr)) {
             width_ = width;
             height_ = height;
             format_ = format;
+            hasMipMaps_ = textureDesc.MipLevels > 1;
+            memoryUsage_ = TextureFile::ComputeMemoryUsage(textureDesc);
             return true;
         }
     }
@@ -120,15 +367,65 @@ bool Texture::CreateRenderTarget(int width, int height, DXGI_FORMAT format, ID3D
     return false;
 }
 
-void Texture::DetectNormalMap() {
-    // Simple heuristic: check if filename contains "normal" or "norm"
-    // A more sophisticated approach would analyze the texture data
-    isNormalMap_ = false; // For now
+bool Texture::GenerateMipMaps(ID3D11DeviceContext* context) {
+    if (!context || !texture_ || !shaderResourceView_ || !hasMipMaps_) return false;
+
+    D3D11_TEXTURE2D_DESC desc;
+    texture_->GetDesc(&desc);
+    if (!(desc.MiscFlags & D3D11_RESOURCE_MISC_GENERATE_MIPS)) return false;
+
+    // Filters each level from the one above with the driver's compute path
+    context->GenerateMips(shaderResourceView_);
+    return true;
+}
+
+bool Texture::DetectNormalMap(const std::string& filename, const uint8_t* pixels, int width, int height) {
+    std::string name = std::filesystem::path(filename).stem().string();
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    auto endsWith = [&](const char* suffix) {
+        const size_t length = std::strlen(suffix);
+        return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+    };
+    const bool named = name.find("normal") != std::string::npos || endsWith("_n") || endsWith("_nrm") || endsWith("_norm");
+    if (!pixels || width <= 0 || height <= 0) return named;
+
+    // Tangent-space normals are unit length, face out of the surface and average to straight up
+    const size_t count = static_cast<size_t>(width) * height;
+    const size_t step = std::max<size_t>(1, count / 4096);
+    size_t samples = 0, unitLength = 0;
+    float sumX = 0.0f, sumY = 0.0f;
+    for (size_t i = 0; i < count; i += step, ++samples) {
+        const uint8_t* texel = pixels + i * 4;
+        const float x = texel[0] / 127.5f - 1.0f, y = texel[1] / 127.5f - 1.0f, z = texel[2] / 127.5f - 1.0f;
+        if (z >= 0.0f && std::fabs(x * x + y * y + z * z - 1.0f) < 0.2f) ++unitLength;
+        sumX += x;
+        sumY += y;
+    }
+
+    const float fraction = static_cast<float>(unitLength) / samples;
+    if (named) return fraction > 0.5f;
+    return fraction > 0.95f && std::fabs(sumX / samples) < 0.1f && std::fabs(sumY / samples) < 0.1f;
+}
+
+ID3D11ShaderResourceView* Texture::GetShaderResourceView() const {
+    return streaming_ ? streaming_->GetTextureSRV(streamingId_) : shaderResourceView_;
+}
+
+size_t Texture::GetMemoryUsage() const {
+    return streaming_ ? static_cast<size_t>(streaming_->GetTextureMemory(streamingId_)) : memoryUsage_;
+}
+
+void Texture::RegisterUsage(const XMFLOAT3& worldPosition, float screenSize) const {
+    if (streaming_) {
+        streaming_->RegisterTextureUsage(streamingId_, worldPosition, screenSize);
+    }
 }
 
 void Texture::Bind(ID3D11DeviceContext* context, UINT slot) const {
-    if (context && shaderResourceView_) {
-        context->PSSetShaderResources(slot, 1, &shaderResourceView_);
+    ID3D11ShaderResourceView* view = GetShaderResourceView();
+    if (context && view) {
+        context->PSSetShaderResources(slot, 1, &view);
     }
 }
 
@@ -145,10 +442,34 @@ Material::Material()
     , specularColor_(1.0f, 1.0f, 1.0f, 1.0f)
     , emissiveColor_(0.0f, 0.0f, 0.0f, 1.0f)
     , specularPower_(32.0f)
+    , table_(nullptr)
+    , materialId_(MaterialTable::INVALID_MATERIAL)
 {
 }
 
 Material::~Material() {
+    if (table_) {
+        table_->Remove(*this);
+    }
+}
+
+std::vector<std::string> Material::GetActiveKeywords() const {
+    std::vector<std::string> keywords = shaderKeywords_;
+    if (diffuseTexture_) keywords.push_back("ALBEDO_MAP");
+    if (normalTexture_) keywords.push_back("NORMAL_MAP");
+    if (emissiveTexture_) keywords.push_back("EMISSIVE_MAP");
+    return keywords;
+}
+
+ShaderPermutations::KeywordMask Material::GetShaderVariant() const {
+    return shader_ ? shader_->GetKeywordMask(GetActiveKeywords()) : 0;
+}
+
+void Material::RegisterUsage(const XMFLOAT3& worldPosition, float screenSize) const {
+    if (diffuseTexture_) diffuseTexture_->RegisterUsage(worldPosition, screenSize);
+    if (normalTexture_) normalTexture_->RegisterUsage(worldPosition, screenSize);
+    if (specularTexture_) specularTexture_->RegisterUsage(worldPosition, screenSize);
+    if (emissiveTexture_) emissiveTexture_->RegisterUsage(worldPosition, screenSize);
 }
 
 void Material::Bind(ID3D11DeviceContext* context) const {
@@ -0,0 +1,679 @@
+#include "TextureFile.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Nexus {
+
+namespace {
+
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+}
+
+constexpr uint32_t DDS_MAGIC = MakeFourCC('D', 'D', 'S', ' ');
+constexpr uint32_t DDSD_REQUIRED = 0x1007;   // CAPS | HEIGHT | WIDTH | PIXELFORMAT
+constexpr uint32_t DDSD_PITCH = 0x8;
+constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+constexpr uint32_t DDSD_LINEARSIZE = 0x80000;
+constexpr uint32_t DDSCAPS_COMPLEX = 0x8;
+constexpr uint32_t DDSCAPS_TEXTURE = 0x1000;
+constexpr uint32_t DDSCAPS_MIPMAP = 0x400000;
+constexpr uint32_t DDPF_ALPHA = 0x2;
+constexpr uint32_t DDPF_FOURCC = 0x4;
+constexpr uint32_t DDPF_RGB = 0x40;
+constexpr uint32_t DDPF_LUMINANCE = 0x20000;
+constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+constexpr uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0xFC00;
+constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+constexpr uint32_t DDS_MISC_TEXTURECUBE = 0x4;
+
+struct DDSPixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct DDSHeader {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DDSPixelFormat pixelFormat;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DDSHeaderDX10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DDSHeader) == 124, "DDS header layout");
+
+const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+struct KTX2Header {
+    uint8_t identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct KTX2Level {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+static_assert(sizeof(KTX2Header) == 80, "KTX2 header layout");
+
+DXGI_FORMAT GetDDSFormat(const DDSPixelFormat& format) {
+    if (format.flags & DDPF_FOURCC) {
+        switch (format.fourCC) {
+        case MakeFourCC('D', 'X', 'T', '1'): return DXGI_FORMAT_BC1_UNORM;
+        case MakeFourCC('D', 'X', 'T', '2'):
+        case MakeFourCC('D', 'X', 'T', '3'): return DXGI_FORMAT_BC2_UNORM;
+        case MakeFourCC('D', 'X', 'T', '4'):
+        case MakeFourCC('D', 'X', 'T', '5'): return DXGI_FORMAT_BC3_UNORM;
+        case MakeFourCC('A', 'T', 'I', '1'):
+        case MakeFourCC('B', 'C', '4', 'U'): return DXGI_FORMAT_BC4_UNORM;
+        case MakeFourCC('B', 'C', '4', 'S'): return DXGI_FORMAT_BC4_SNORM;
+        case MakeFourCC('A', 'T', 'I', '2'):
+        case MakeFourCC('B', 'C', '5', 'U'): return DXGI_FORMAT_BC5_UNORM;
+        case MakeFourCC('B', 'C', '5', 'S'): return DXGI_FORMAT_BC5_SNORM;
+        // D3DFORMAT values stored as the FourCC
+        case 36:  return DXGI_FORMAT_R16G16B16A16_UNORM;
+        case 110: return DXGI_FORMAT_R16G16B16A16_SNORM;
+        case 111: return DXGI_FORMAT_R16_FLOAT;
+        case 112: return DXGI_FORMAT_R16G16_FLOAT;
+        case 113: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case 114: return DXGI_FORMAT_R32_FLOAT;
+        case 115: return DXGI_FORMAT_R32G32_FLOAT;
+        case 116: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        default:  return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    auto masks = [&](uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+        return format.rBitMask == r && format.gBitMask == g && format.bBitMask == b && format.aBitMask == a;
+    };
+    if (format.flags & DDPF_RGB) {
+        if (format.rgbBitCount == 32) {
+            if (masks(0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000)) return DXGI_FORMAT_R8G8B8A8_UNORM;
+            if (masks(0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000)) return DXGI_FORMAT_B8G8R8A8_UNORM;
+            if (masks(0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000)) return DXGI_FORMAT_B8G8R8X8_UNORM;
+            if (masks(0x0000FFFF, 0xFFFF0000, 0x00000000, 0x00000000)) return DXGI_FORMAT_R16G16_UNORM;
+            if (masks(0x000003FF, 0x000FFC00, 0x3FF00000, 0xC0000000)) return DXGI_FORMAT_R10G10B10A2_UNORM;
+        } else if (format.rgbBitCount == 16) {
+            if (masks(0xF800, 0x07E0, 0x001F, 0x0000)) return DXGI_FORMAT_B5G6R5_UNORM;
+            if (masks(0x7C00, 0x03E0, 0x001F, 0x8000)) return DXGI_FORMAT_B5G5R5A1_UNORM;
+            if (masks(0x0F00, 0x00F0, 0x000F, 0xF000)) return DXGI_FORMAT_B4G4R4A4_UNORM;
+        }
+        // 24-bit RGB has no D3D11 equivalent and would need a conversion copy
+        return DXGI_FORMAT_UNKNOWN;
+    }
+    if (format.flags & DDPF_LUMINANCE) {
+        if (format.rgbBitCount == 8 && masks(0xFF, 0, 0, 0)) return DXGI_FORMAT_R8_UNORM;
+        if (format.rgbBitCount == 16 && masks(0xFFFF, 0, 0, 0)) return DXGI_FORMAT_R16_UNORM;
+        if (format.rgbBitCount == 16 && masks(0x00FF, 0, 0, 0xFF00)) return DXGI_FORMAT_R8G8_UNORM;
+        return DXGI_FORMAT_UNKNOWN;
+    }
+    if ((format.flags & DDPF_ALPHA) && format.rgbBitCount == 8) {
+        return DXGI_FORMAT_A8_UNORM;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+DXGI_FORMAT GetKTX2Format(uint32_t vkFormat) {
+    switch (vkFormat) {
+    case 9:   return DXGI_FORMAT_R8_UNORM;
+    case 16:  return DXGI_FORMAT_R8G8_UNORM;
+    case 37:  return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case 43:  return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    case 44:  return DXGI_FORMAT_B8G8R8A8_UNORM;
+    case 50:  return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+    case 64:  return DXGI_FORMAT_R10G10B10A2_UNORM;     // A2B10G10R10_UNORM_PACK32
+    case 76:  return DXGI_FORMAT_R16_FLOAT;
+    case 83:  return DXGI_FORMAT_R16G16_FLOAT;
+    case 97:  return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case 100: return DXGI_FORMAT_R32_FLOAT;
+    case 103: return DXGI_FORMAT_R32G32_FLOAT;
+    case 109: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    case 122: return DXGI_FORMAT_R11G11B10_FLOAT;       // B10G11R11_UFLOAT_PACK32
+    case 123: return DXGI_FORMAT_R9G9B9E5_SHAREDEXP;    // E5B9G9R9_UFLOAT_PACK32
+    case 131: case 133: return DXGI_FORMAT_BC1_UNORM;
+    case 132: case 134: return DXGI_FORMAT_BC1_UNORM_SRGB;
+    case 135: return DXGI_FORMAT_BC2_UNORM;
+    case 136: return DXGI_FORMAT_BC2_UNORM_SRGB;
+    case 137: return DXGI_FORMAT_BC3_UNORM;
+    case 138: return DXGI_FORMAT_BC3_UNORM_SRGB;
+    case 139: return DXGI_FORMAT_BC4_UNORM;
+    case 140: return DXGI_FORMAT_BC4_SNORM;
+    case 141: return DXGI_FORMAT_BC5_UNORM;
+    case 142: return DXGI_FORMAT_BC5_SNORM;
+    case 143: return DXGI_FORMAT_BC6H_UF16;
+    case 144: return DXGI_FORMAT_BC6H_SF16;
+    case 145: return DXGI_FORMAT_BC7_UNORM;
+    case 146: return DXGI_FORMAT_BC7_UNORM_SRGB;
+    default:  return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+bool IsValidSize(const D3D11_TEXTURE2D_DESC& desc) {
+    UINT fullChain = 1;
+    for (UINT size = std::max(desc.Width, desc.Height); size > 1; size /= 2) ++fullChain;
+    return desc.Width > 0 && desc.Height > 0 && desc.Width <= D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION &&
+           desc.Height <= D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION && desc.MipLevels <= fullChain &&
+           desc.ArraySize <= D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION;
+}
+}
+
+TextureFile::TextureFile()
+    : data_(nullptr)
+    , size_(0)
+    , desc_()
+{
+}
+
+bool TextureFile::IsContainer(const std::string& filename) {
+    std::string extension = std::filesystem::path(filename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".dds" || extension == ".ktx2";
+}
+
+bool TextureFile::Open(const std::string& filename) {
+    NEXUS_PROFILE_SCOPE("TextureFile::Open");
+    Close();
+    filename_ = filename;
+    if (!file_.Open(filename)) return false;
+    data_ = file_.GetData();
+    size_ = file_.GetSize();
+    return Parse();
+}
+
+bool TextureFile::Open(const uint8_t* data, size_t size, const std::string& name) {
+    NEXUS_PROFILE_SCOPE("TextureFile::Open");
+    Close();
+    filename_ = name;
+    data_ = data;
+    size_ = size;
+    return Parse();
+}
+
+bool TextureFile::Parse() {
+    bool parsed = false;
+    if (size_ >= sizeof(KTX2Header) && std::memcmp(data_, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0) {
+        parsed = ParseKTX2();
+    } else if (size_ >= 4 + sizeof(DDSHeader) && std::memcmp(data_, &DDS_MAGIC, 4) == 0) {
+        parsed = ParseDDS();
+    } else {
+        Logger::Error("Not a DDS or KTX2 file: " + filename_);
+    }
+
+    if (!parsed) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void TextureFile::Close() {
+    file_.Close();
+    data_ = nullptr;
+    size_ = 0;
+    subresources_.clear();
+    desc_ = D3D11_TEXTURE2D_DESC();
+}
+
+bool TextureFile::ParseDDS() {
+    const uint8_t* data = data_;
+    DDSHeader header;
+    std::memcpy(&header, data + 4, sizeof(header));
+    if (header.size != sizeof(DDSHeader) || header.pixelFormat.size != sizeof(DDSPixelFormat)) {
+        Logger::Error("Corrupt DDS header: " + filename_);
+        return false;
+    }
+
+    size_t offset = 4 + sizeof(DDSHeader);
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    UINT arraySize = 1;
+    bool cubemap = false;
+
+    if ((header.pixelFormat.flags & DDPF_FOURCC) && header.pixelFormat.fourCC == MakeFourCC('D', 'X', '1', '0')) {
+        if (size_ < offset + sizeof(DDSHeaderDX10)) {
+            Logger::Error("Corrupt DDS header: " + filename_);
+            return false;
+        }
+        DDSHeaderDX10 extended;
+        std::memcpy(&extended, data + offset, sizeof(extended));
+        offset += sizeof(DDSHeaderDX10);
+
+        if (extended.resourceDimension != DDS_DIMENSION_TEXTURE2D) {
+            Logger::Error("Only 2D and cube DDS textures are supported: " + filename_);
+            return false;
+        }
+        format = static_cast<DXGI_FORMAT>(extended.dxgiFormat);
+        arraySize = std::max(1u, extended.arraySize);
+        cubemap = (extended.miscFlag & DDS_MISC_TEXTURECUBE) != 0;
+    } else {
+        if (header.caps2 & DDSCAPS2_VOLUME) {
+            Logger::Error("Volume DDS textures are not supported: " + filename_);
+            return false;
+        }
+        format = GetDDSFormat(header.pixelFormat);
+        if (header.caps2 & DDSCAPS2_CUBEMAP) {
+            if ((header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES) {
+                Logger::Error("Partial DDS cubemaps are not supported: " + filename_);
+                return false;
+            }
+            cubemap = true;
+        }
+    }
+
+    if (GetBitsPerPixel(format) == 0) {
+        Logger::Error("Unsupported DDS pixel format: " + filename_);
+        return false;
+    }
+
+    desc_.Width = header.width;
+    desc_.Height = header.height;
+    desc_.MipLevels = (header.flags & DDSD_MIPMAPCOUNT) ? std::max(1u, header.mipMapCount) : 1;
+    desc_.ArraySize = cubemap ? arraySize * 6 : arraySize;
+    desc_.Format = format;
+    desc_.SampleDesc.Count = 1;
+    desc_.Usage = D3D11_USAGE_IMMUTABLE;
+    desc_.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc_.MiscFlags = cubemap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+    if (!IsValidSize(desc_)) {
+        Logger::Error("DDS dimensions out of range: " + filename_);
+        return false;
+    }
+
+    // DDS stores each array slice (or cube face) with its full mip chain, in subresource order
+    subresources_.resize(static_cast<size_t>(desc_.MipLevels) * desc_.ArraySize);
+    for (UINT slice = 0; slice < desc_.ArraySize; ++slice) {
+        for (UINT mip = 0; mip < desc_.MipLevels; ++mip) {
+            UINT width = std::max(1u, desc_.Width >> mip);
+            UINT height = std::max(1u, desc_.Height >> mip);
+            if (!AddSubresource(D3D11CalcSubresource(mip, slice, desc_.MipLevels), offset, width, height)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool TextureFile::ParseKTX2() {
+    const uint8_t* data = data_;
+    const size_t size = size_;
+    KTX2Header header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.supercompressionScheme != 0) {
+        Logger::Error("Supercompressed KTX2 needs offline transcoding: " + filename_);
+        return false;
+    }
+    if (header.pixelDepth > 1) {
+        Logger::Error("Volume KTX2 textures are not supported: " + filename_);
+        return false;
+    }
+    if (header.faceCount != 1 && header.faceCount != 6) {
+        Logger::Error("Corrupt KTX2 header: " + filename_);
+        return false;
+    }
+
+    DXGI_FORMAT format = GetKTX2Format(header.vkFormat);
+    if (format == DXGI_FORMAT_UNKNOWN) {
+        Logger::Error("Unsupported KTX2 format " + std::to_string(header.vkFormat) + ": " + filename_);
+        return false;
+    }
+
+    const UINT layers = std::max(1u, header.layerCount);
+    desc_.Width = header.pixelWidth;
+    desc_.Height = std::max(1u, header.pixelHeight);
+    desc_.MipLevels = std::max(1u, header.levelCount);   // 0 asks for generated mips; only the base is stored
+    desc_.ArraySize = layers * header.faceCount;
+    desc_.Format = format;
+    desc_.SampleDesc.Count = 1;
+    desc_.Usage = D3D11_USAGE_IMMUTABLE;
+    desc_.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc_.MiscFlags = header.faceCount == 6 ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+    if (!IsValidSize(desc_) ||
+        sizeof(KTX2Header) + static_cast<size_t>(desc_.MipLevels) * sizeof(KTX2Level) > size) {
+        Logger::Error("KTX2 dimensions out of range: " + filename_);
+        return false;
+    }
+
+    // Levels are stored independently (smallest first in the file, but indexed from the base);
+    // inside a level the images run layer by layer, face by face, with tightly packed rows
+    subresources_.resize(static_cast<size_t>(desc_.MipLevels) * desc_.ArraySize);
+    for (UINT mip = 0; mip < desc_.MipLevels; ++mip) {
+        KTX2Level level;
+        std::memcpy(&level, data + sizeof(KTX2Header) + mip * sizeof(KTX2Level), sizeof(level));
+        if (level.byteOffset > size || level.byteLength > size - level.byteOffset) {
+            Logger::Error("KTX2 level outside the file: " + filename_);
+            return false;
+        }
+
+        size_t offset = static_cast<size_t>(level.byteOffset);
+        UINT width = std::max(1u, desc_.Width >> mip);
+        UINT height = std::max(1u, desc_.Height >> mip);
+        for (UINT slice = 0; slice < desc_.ArraySize; ++slice) {
+            if (!AddSubresource(D3D11CalcSubresource(mip, slice, desc_.MipLevels), offset, width, height)) {
+                return false;
+            }
+        }
+        if (offset > level.byteOffset + level.byteLength) {
+            Logger::Error("KTX2 level smaller than its images: " + filename_);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TextureFile::AddSubresource(UINT index, size_t& offset, UINT width, UINT height) {
+    UINT rowPitch = 0, rowCount = 0;
+    if (!GetSurfaceInfo(desc_.Format, width, height, rowPitch, rowCount)) return false;
+
+    const size_t slicePitch = static_cast<size_t>(rowPitch) * rowCount;
+    if (offset > size_ || slicePitch > size_ - offset) {
+        Logger::Error("Texture data truncated: " + filename_);
+        return false;
+    }
+
+    D3D11_SUBRESOURCE_DATA& subresource = subresources_[index];
+    subresource.pSysMem = data_ + offset;
+    subresource.SysMemPitch = rowPitch;
+    subresource.SysMemSlicePitch = static_cast<UINT>(slicePitch);
+    offset += slicePitch;
+    return true;
+}
+
+HRESULT TextureFile::CreateTexture(ID3D11Device* device, ID3D11Texture2D** texture,
+                                   ID3D11ShaderResourceView** view) const {
+    if (!device || !texture || subresources_.empty()) return E_INVALIDARG;
+
+    // The runtime copies the initial data during the call; this is the only copy of the pixels
+    HRESULT hr = device->CreateTexture2D(&desc_, subresources_.data(), texture);
+    if (FAILED(hr) || !view) return hr;
+
+    const D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = GetViewDesc(desc_);
+    hr = device->CreateShaderResourceView(*texture, &srvDesc, view);
+    if (FAILED(hr)) {
+        (*texture)->Release();
+        *texture = nullptr;
+    }
+    return hr;
+}
+
+bool TextureFile::WriteDDS(const std::string& filename, const D3D11_TEXTURE2D_DESC& desc,
+                           const D3D11_SUBRESOURCE_DATA* subresources) {
+    const bool cubemap = (desc.MiscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE) != 0;
+    const UINT mipLevels = std::max(1u, desc.MipLevels);
+    const UINT arraySize = std::max(1u, desc.ArraySize);
+    UINT rowPitch = 0, rowCount = 0;
+    if (!subresources || !GetSurfaceInfo(desc.Format, desc.Width, desc.Height, rowPitch, rowCount) ||
+        (cubemap && arraySize % 6 != 0)) {
+        Logger::Error("Cannot write DDS " + filename + ": unsupported texture description");
+        return false;
+    }
+
+    // Always the DX10 extension, which names the DXGI format directly
+    DDSHeader header = {};
+    header.size = sizeof(DDSHeader);
+    header.flags = DDSD_REQUIRED | DDSD_MIPMAPCOUNT | (IsBlockCompressed(desc.Format) ? DDSD_LINEARSIZE : DDSD_PITCH);
+    header.height = desc.Height;
+    header.width = desc.Width;
+    header.pitchOrLinearSize = IsBlockCompressed(desc.Format) ? rowPitch * rowCount : rowPitch;
+    header.mipMapCount = mipLevels;
+    header.pixelFormat.size = sizeof(DDSPixelFormat);
+    header.pixelFormat.flags = DDPF_FOURCC;
+    header.pixelFormat.fourCC = MakeFourCC('D', 'X', '1', '0');
+    header.caps = DDSCAPS_TEXTURE | (mipLevels > 1 || arraySize > 1 ? DDSCAPS_COMPLEX : 0) | (mipLevels > 1 ? DDSCAPS_MIPMAP : 0);
+    header.caps2 = cubemap ? DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES : 0;
+
+    DDSHeaderDX10 extended = {};
+    extended.dxgiFormat = desc.Format;
+    extended.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+    extended.miscFlag = cubemap ? DDS_MISC_TEXTURECUBE : 0;
+    extended.arraySize = cubemap ? arraySize / 6 : arraySize;
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        Logger::Error("Failed to create file: " + filename);
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&DDS_MAGIC), 4);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&extended), sizeof(extended));
+
+    // Same slice-major order ParseDDS reads, with tightly packed rows
+    for (UINT slice = 0; slice < arraySize; ++slice) {
+        for (UINT mip = 0; mip < mipLevels; ++mip) {
+            GetSurfaceInfo(desc.Format, std::max(1u, desc.Width >> mip), std::max(1u, desc.Height >> mip), rowPitch, rowCount);
+            const D3D11_SUBRESOURCE_DATA& subresource = subresources[D3D11CalcSubresource(mip, slice, mipLevels)];
+            const uint8_t* rows = static_cast<const uint8_t*>(subresource.pSysMem);
+            for (UINT row = 0; row < rowCount; ++row) {
+                file.write(reinterpret_cast<const char*>(rows + static_cast<size_t>(row) * subresource.SysMemPitch), rowPitch);
+            }
+        }
+    }
+
+    if (!file) {
+        Logger::Error("Failed to write DDS: " + filename);
+        return false;
+    }
+    return true;
+}
+
+D3D11_SHADER_RESOURCE_VIEW_DESC TextureFile::GetViewDesc(const D3D11_TEXTURE2D_DESC& desc) {
+    const bool cubemap = (desc.MiscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE) != 0;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = desc.Format;
+    if (cubemap && desc.ArraySize > 6) {
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+        srvDesc.TextureCubeArray.MipLevels = desc.MipLevels;
+        srvDesc.TextureCubeArray.NumCubes = desc.ArraySize / 6;
+    } else if (cubemap) {
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+        srvDesc.TextureCube.MipLevels = desc.MipLevels;
+    } else if (desc.ArraySize > 1) {
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        srvDesc.Texture2DArray.MipLevels = desc.MipLevels;
+        srvDesc.Texture2DArray.ArraySize = desc.ArraySize;
+    } else {
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = desc.MipLevels;
+    }
+    return srvDesc;
+}
+
+UINT TextureFile::GetBitsPerPixel(DXGI_FORMAT format) {
+    switch (format) {
+    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_UINT:
+    case DXGI_FORMAT_R32G32B32A32_SINT:
+        return 128;
+
+    case DXGI_FORMAT_R32G32B32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+    case DXGI_FORMAT_R32G32B32_UINT:
+    case DXGI_FORMAT_R32G32B32_SINT:
+        return 96;
+
+    case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_UINT:
+    case DXGI_FORMAT_R16G16B16A16_SNORM:
+    case DXGI_FORMAT_R16G16B16A16_SINT:
+    case DXGI_FORMAT_R32G32_TYPELESS:
+    case DXGI_FORMAT_R32G32_FLOAT:
+    case DXGI_FORMAT_R32G32_UINT:
+    case DXGI_FORMAT_R32G32_SINT:
+    case DXGI_FORMAT_R32G8X24_TYPELESS:
+    case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+        return 64;
+
+    case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R10G10B10A2_UINT:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_R8G8B8A8_UINT:
+    case DXGI_FORMAT_R8G8B8A8_SNORM:
+    case DXGI_FORMAT_R8G8B8A8_SINT:
+    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+    case DXGI_FORMAT_R16G16_TYPELESS:
+    case DXGI_FORMAT_R16G16_FLOAT:
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R16G16_UINT:
+    case DXGI_FORMAT_R16G16_SNORM:
+    case DXGI_FORMAT_R16G16_SINT:
+    case DXGI_FORMAT_R32_TYPELESS:
+    case DXGI_FORMAT_D32_FLOAT:
+    case DXGI_FORMAT_R32_FLOAT:
+    case DXGI_FORMAT_R32_UINT:
+    case DXGI_FORMAT_R32_SINT:
+    case DXGI_FORMAT_R24G8_TYPELESS:
+    case DXGI_FORMAT_D24_UNORM_S8_UINT:
+    case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+        return 32;
+
+    case DXGI_FORMAT_R8G8_TYPELESS:
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R8G8_UINT:
+    case DXGI_FORMAT_R8G8_SNORM:
+    case DXGI_FORMAT_R8G8_SINT:
+    case DXGI_FORMAT_R16_TYPELESS:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_D16_UNORM:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_R16_UINT:
+    case DXGI_FORMAT_R16_SNORM:
+    case DXGI_FORMAT_R16_SINT:
+    case DXGI_FORMAT_B5G6R5_UNORM:
+    case DXGI_FORMAT_B5G5R5A1_UNORM:
+    case DXGI_FORMAT_B4G4R4A4_UNORM:
+        return 16;
+
+    case DXGI_FORMAT_R8_TYPELESS:
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_R8_UINT:
+    case DXGI_FORMAT_R8_SNORM:
+    case DXGI_FORMAT_R8_SINT:
+    case DXGI_FORMAT_A8_UNORM:
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return 8;
+
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        return 4;
+
+    default:
+        return 0;
+    }
+}
+
+bool TextureFile::IsBlockCompressed(DXGI_FORMAT format) {
+    return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+           (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+bool TextureFile::GetSurfaceInfo(DXGI_FORMAT format, UINT width, UINT height, UINT& rowPitch, UINT& rowCount) {
+    const UINT bitsPerPixel = GetBitsPerPixel(format);
+    if (bitsPerPixel == 0) return false;
+
+    if (IsBlockCompressed(format)) {
+        // 4x4 blocks of 8 (BC1, BC4) or 16 bytes
+        rowPitch = std::max(1u, (width + 3) / 4) * bitsPerPixel * 2;
+        rowCount = std::max(1u, (height + 3) / 4);
+    } else {
+        rowPitch = (width * bitsPerPixel + 7) / 8;
+        rowCount = height;
+    }
+    return true;
+}
+
+size_t TextureFile::ComputeMemoryUsage(const D3D11_TEXTURE2D_DESC& desc) {
+    const UINT mipLevels = desc.MipLevels > 0 ? desc.MipLevels : 1;
+    const size_t samples = std::max(1u, desc.SampleDesc.Count);
+
+    size_t bytes = 0;
+    for (UINT mip = 0; mip < mipLevels; ++mip) {
+        UINT rowPitch = 0, rowCount = 0;
+        if (!GetSurfaceInfo(desc.Format, std::max(1u, desc.Width >> mip), std::max(1u, desc.Height >> mip),
+                            rowPitch, rowCount)) {
+            // Unknown format: count four bytes per texel rather than nothing
+            rowPitch = std::max(1u, desc.Width >> mip) * 4;
+            rowCount = std::max(1u, desc.Height >> mip);
+        }
+        bytes += static_cast<size_t>(rowPitch) * rowCount;
+    }
+    return bytes * std::max(1u, desc.ArraySize) * samples;
+}
+
+} // namespace Nexus
@@ -0,0 +1,1380 @@
+#include "TextureStreamingEngine.h"
+#include "TextureFile.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "StateCache.h"
+#include <d3d11_2.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+
+constexpr UINT TILE_SIZE_BYTES = 64 * 1024;
+constexpr UINT INITIAL_POOL_TILES = 1024;   // 64 MB, grown on demand up to the budget
+
+constexpr UINT DEFAULT_PAGE_CACHE_SIZE = 32;   // 1024 pages
+constexpr UINT MAX_PAGE_CACHE_SIZE = D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION / TextureStreamingEngine::PAGE_SLOT_SIZE;
+constexpr UINT MAX_PAGES = 2048;               // Per side at level 0, the 11 bits of a page key
+constexpr uint32_t EMPTY_FEEDBACK = 0xFFFFFFFFu;
+
+// Matches VirtualTextureBuffer in PBR_PS.hlsl and GBuffer_PS.hlsl
+struct VirtualConstants {
+    XMFLOAT2 size;
+    XMFLOAT2 atlasScale;
+    UINT index;
+    UINT maxLevel;
+    UINT phaseX;
+    UINT phaseY;
+};
+
+template <typename T>
+void SafeRelease(T*& object) {
+    if (object) {
+        object->Release();
+        object = nullptr;
+    }
+}
+
+D3D11_TEXTURE2D_DESC GetSubChainDesc(const D3D11_TEXTURE2D_DESC& desc, UINT mostDetailedMip) {
+    D3D11_TEXTURE2D_DESC subDesc = desc;
+    subDesc.Width = std::max(1u, desc.Width >> mostDetailedMip);
+    subDesc.Height = std::max(1u, desc.Height >> mostDetailedMip);
+    subDesc.MipLevels = desc.MipLevels - mostDetailedMip;
+    subDesc.Usage = D3D11_USAGE_DEFAULT;
+    subDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    subDesc.CPUAccessFlags = 0;
+    return subDesc;
+}
+
+// First level whose larger side fits in TAIL_SIZE; that level and everything coarser stays resident
+UINT ComputeTailMip(const D3D11_TEXTURE2D_DESC& desc) {
+    UINT mip = 0;
+    while (mip + 1 < desc.MipLevels &&
+           std::max(desc.Width >> mip, desc.Height >> mip) > TextureStreamingEngine::TAIL_SIZE) {
+        ++mip;
+    }
+    return mip;
+}
+
+// Block-compressed textures need the top level of every chain we allocate to be a multiple of the
+// block size; textures that break this somewhere above the tail are kept fully resident instead
+bool CanReallocate(const D3D11_TEXTURE2D_DESC& desc, UINT tailMip) {
+    if (!TextureFile::IsBlockCompressed(desc.Format)) return true;
+    for (UINT mip = 0; mip <= tailMip; ++mip) {
+        if (((desc.Width >> mip) % 4) != 0 || ((desc.Height >> mip) % 4) != 0) return false;
+    }
+    return true;
+}
+
+// Page keys and feedback entries: 6-bit texture index, 4-bit level, 11-bit y and x
+uint32_t GetPageKey(UINT level, UINT x, UINT y) {
+    return (level << 22) | (y << 11) | x;
+}
+
+// Page table entries: atlas slot x and y, then the level that slot holds
+uint32_t GetPageEntry(UINT slot, UINT cacheSize, UINT level) {
+    return (slot % cacheSize) | ((slot / cacheSize) << 8) | (level << 16);
+}
+
+uint64_t GetPageBytes(DXGI_FORMAT format) {
+    UINT rowPitch = 0, rowCount = 0;
+    TextureFile::GetSurfaceInfo(format, TextureStreamingEngine::PAGE_SLOT_SIZE, TextureStreamingEngine::PAGE_SLOT_SIZE,
+                                rowPitch, rowCount);
+    return static_cast<uint64_t>(rowPitch) * rowCount;
+}
+
+bool IsPowerOfTwo(UINT value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+}
+
+TextureStreamingEngine::TextureStreamingEngine()
+    : device_(nullptr)
+    , context_(nullptr)
+    , device2_(nullptr)
+    , context2_(nullptr)
+    , nextTextureId_(1)
+    , frameIndex_(1)
+    , shutdownRequested_(false)
+    , loadsInFlight_(0)
+    , pendingMemory_(0)
+    , memoryBudget_(0)
+    , currentMemoryUsage_(0)
+    , lruEnabled_(true)
+    , tiled_(false)
+    , tilePool_(nullptr)
+    , tilePoolSize_(0)
+    , virtualIds_()
+    , pageAtlas_(nullptr)
+    , pageAtlasView_(nullptr)
+    , pageFormat_(DXGI_FORMAT_UNKNOWN)
+    , pageCacheSize_(DEFAULT_PAGE_CACHE_SIZE)
+    , feedback_(nullptr)
+    , feedbackView_(nullptr)
+    , feedbackReadback_()
+    , feedbackWidth_(0)
+    , feedbackHeight_(0)
+    , feedbackWrite_(0)
+    , feedbackPending_(0)
+    , cameraPosition_(0.0f, 0.0f, 0.0f)
+    , cameraDirection_(0.0f, 0.0f, 1.0f)
+    , maxLoadRequestsPerFrame_(8)
+    , mipBias_(0.0f)
+{
+}
+
+TextureStreamingEngine::~TextureStreamingEngine() {
+    Shutdown();
+}
+
+bool TextureStreamingEngine::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, uint64_t budgetBytes,
+                                        int loaderThreads) {
+    if (!device || !context) return false;
+    Shutdown();
+
+    device_ = device;
+    context_ = context;
+    memoryBudget_ = budgetBytes;
+
+    // Tiled resources let a level be made resident by mapping tiles instead of reallocating the chain
+    D3D11_FEATURE_DATA_D3D11_OPTIONS1 options = {};
+    if (SUCCEEDED(device_->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS1, &options, sizeof(options))) &&
+        options.TiledResourcesTier != D3D11_TILED_RESOURCES_NOT_SUPPORTED &&
+        SUCCEEDED(device_->QueryInterface(__uuidof(ID3D11Device2), reinterpret_cast<void**>(&device2_))) &&
+        SUCCEEDED(context_->QueryInterface(__uuidof(ID3D11DeviceContext2), reinterpret_cast<void**>(&context2_)))) {
+        tiled_ = InitializeTilePool(budgetBytes);
+    }
+    if (!tiled_) {
+        SafeRelease(context2_);
+        SafeRelease(device2_);
+    }
+
+    shutdownRequested_ = false;
+    for (int i = 0; i < std::max(1, loaderThreads); ++i) {
+        loaderThreads_.emplace_back(&TextureStreamingEngine::LoaderThread, this);
+    }
+
+    stats_ = StreamingStats();
+    stats_.memoryBudget = memoryBudget_;
+    stats_.tiledResources = tiled_;
+
+    Logger::Info("Texture streaming initialized: " + std::to_string(memoryBudget_ / (1024 * 1024)) + " MB budget, " +
+                 (tiled_ ? "tiled resources" : "reallocated mip chains"));
+    return true;
+}
+
+void TextureStreamingEngine::Shutdown() {
+    if (!loaderThreads_.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(loadQueueMutex_);
+            shutdownRequested_ = true;
+        }
+        loadQueueCondition_.notify_all();
+        for (std::thread& thread : loaderThreads_) {
+            thread.join();
+        }
+        loaderThreads_.clear();
+    }
+    loadQueue_ = std::priority_queue<LoadRequest>();
+
+    for (CompletedLoad& load : completedLoads_) {
+        SafeRelease(load.staging);
+    }
+    completedLoads_.clear();
+    loadsInFlight_ = 0;
+    pendingMemory_ = 0;
+
+    for (auto& entry : textures_) {
+        ReleaseTexture(*entry.second);
+    }
+    textures_.clear();
+    currentMemoryUsage_ = 0;
+
+    for (auto& entry : virtualTextures_) {
+        ReleaseVirtualTexture(entry.first, *entry.second);
+    }
+    virtualTextures_.clear();
+    ReleasePageAtlas();
+    for (ID3D11Texture2D*& readback : feedbackReadback_) {
+        SafeRelease(readback);
+    }
+    SafeRelease(feedbackView_);
+    SafeRelease(feedback_);
+    feedbackPending_ = 0;
+
+    SafeRelease(tilePool_);
+    freeTiles_.clear();
+    tilePoolSize_ = 0;
+    tiled_ = false;
+    SafeRelease(context2_);
+    SafeRelease(device2_);
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+uint32_t TextureStreamingEngine::LoadTexture(const std::string& filePath, StreamingPriority priority) {
+    if (!device_) return INVALID_TEXTURE;
+    NEXUS_PROFILE_SCOPE("TextureStreamingEngine::LoadTexture");
+
+    auto source = std::make_shared<TextureFile>();
+    if (!source->Open(filePath)) return INVALID_TEXTURE;
+
+    auto texture = std::make_unique<StreamingTexture>();
+    texture->source = source;
+    texture->filePath = filePath;
+    texture->desc = source->GetDesc();
+    texture->priority = priority;
+    texture->lastUsedFrame = frameIndex_;
+    if (!CreateResidentTexture(*texture)) {
+        Logger::Error("Failed to create streamed texture: " + filePath);
+        ReleaseTexture(*texture);
+        return INVALID_TEXTURE;
+    }
+
+    const uint32_t id = nextTextureId_++;
+    textures_[id] = std::move(texture);
+    return id;
+}
+
+void TextureStreamingEngine::UnloadTexture(uint32_t textureId) {
+    auto virtualTexture = virtualTextures_.find(textureId);
+    if (virtualTexture != virtualTextures_.end()) {
+        ReleaseVirtualTexture(textureId, *virtualTexture->second);
+        virtualTextures_.erase(virtualTexture);
+        // With no virtual textures left a new one may pick another format or cache size
+        if (virtualTextures_.empty()) {
+            ReleasePageAtlas();
+        }
+        return;
+    }
+
+    auto it = textures_.find(textureId);
+    if (it == textures_.end()) return;
+
+    // An in-flight load still completes; ProcessLoadQueue discards it when the id is gone
+    StreamingTexture& texture = *it->second;
+    if (texture.pendingMip != NO_MIP) {
+        pendingMemory_ -= ComputeMipMemory(texture, texture.pendingMip);
+    }
+    ReleaseTexture(texture);
+    textures_.erase(it);
+}
+
+ID3D11ShaderResourceView* TextureStreamingEngine::GetTextureSRV(uint32_t textureId) const {
+    auto it = textures_.find(textureId);
+    return it != textures_.end() ? it->second->srv : nullptr;
+}
+
+bool TextureStreamingEngine::IsTextureResident(uint32_t textureId, int mipLevel) const {
+    auto it = textures_.find(textureId);
+    return it != textures_.end() && it->second->residentMip <= static_cast<UINT>(std::max(0, mipLevel));
+}
+
+int TextureStreamingEngine::GetResidentMip(uint32_t textureId) const {
+    auto it = textures_.find(textureId);
+    return it != textures_.end() ? static_cast<int>(it->second->residentMip) : -1;
+}
+
+uint64_t TextureStreamingEngine::GetTextureMemory(uint32_t textureId) const {
+    auto it = textures_.find(textureId);
+    return it != textures_.end() ? it->second->memoryUsage : 0;
+}
+
+void TextureStreamingEngine::SetStreamingPriority(uint32_t textureId, StreamingPriority priority) {
+    auto it = textures_.find(textureId);
+    if (it != textures_.end()) {
+        it->second->priority = priority;
+    }
+}
+
+void TextureStreamingEngine::RequestMipLevel(uint32_t textureId, int mipLevel) {
+    auto it = textures_.find(textureId);
+    if (it == textures_.end()) return;
+
+    StreamingTexture& texture = *it->second;
+    texture.pinnedMip = std::min(static_cast<UINT>(std::max(0, mipLevel)), texture.tailMip);
+    UpdateLRU(texture);
+}
+
+void TextureStreamingEngine::EvictTexture(uint32_t textureId) {
+    auto it = textures_.find(textureId);
+    if (it == textures_.end()) return;
+
+    StreamingTexture& texture = *it->second;
+    texture.pinnedMip = NO_MIP;
+    texture.usageFrame = 0;
+    while (texture.residentMip < texture.tailMip) {
+        UnloadTextureMip(texture);
+    }
+}
+
+void TextureStreamingEngine::UpdateCameraPosition(const XMFLOAT3& position, const XMFLOAT3& direction) {
+    cameraPosition_ = position;
+    cameraDirection_ = direction;
+}
+
+void TextureStreamingEngine::RegisterTextureUsage(uint32_t textureId, const XMFLOAT3& worldPosition,
+                                                  float screenSize) {
+    auto it = textures_.find(textureId);
+    if (it == textures_.end()) return;
+
+    // One texel per pixel: each halving of the on-screen size drops a level
+    StreamingTexture& texture = *it->second;
+    const float texels = static_cast<float>(std::max(texture.desc.Width, texture.desc.Height));
+    UINT mip = texture.tailMip;
+    if (screenSize > 0.0f) {
+        const float level = std::floor(std::log2(texels / screenSize) + mipBias_);
+        mip = static_cast<UINT>(std::clamp(level, 0.0f, static_cast<float>(texture.tailMip)));
+    }
+
+    XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&worldPosition), XMLoadFloat3(&cameraPosition_));
+    const float distance = XMVectorGetX(XMVector3Length(offset));
+
+    // Several surfaces can share a texture; the largest one decides
+    if (texture.usageFrame != frameIndex_) {
+        texture.usageFrame = frameIndex_;
+        texture.usageMip = mip;
+        texture.distanceFromCamera = distance;
+    } else {
+        texture.usageMip = std::min(texture.usageMip, mip);
+        texture.distanceFromCamera = std::min(texture.distanceFromCamera, distance);
+    }
+    UpdateLRU(texture);
+}
+
+void TextureStreamingEngine::SetMemoryBudget(uint64_t budgetBytes) {
+    memoryBudget_ = budgetBytes;
+    stats_.memoryBudget = budgetBytes;
+}
+
+void TextureStreamingEngine::TrimMemory(uint64_t targetBytes) {
+    while (currentMemoryUsage_ > targetBytes) {
+        StreamingTexture* victim = FindLRUTexture(nullptr, false);
+        if (!victim) break;
+        UnloadTextureMip(*victim);
+    }
+}
+
+void TextureStreamingEngine::Update() {
+    if (!device_) return;
+    NEXUS_PROFILE_SCOPE("TextureStreamingEngine::Update");
+
+    ++frameIndex_;
+    stats_.uploadsThisFrame = 0;
+    stats_.evictionsThisFrame = 0;
+
+    // Feedback first, so pages it asked for are not evicted for the pages arriving now
+    ReadFeedback();
+    ProcessLoadQueue();
+    ScheduleLoads();
+    EnforceMemoryBudget();
+    UploadPageTables();
+
+    stats_.memoryBudget = memoryBudget_;
+    stats_.residentMemory = currentMemoryUsage_;
+    stats_.textureCount = static_cast<uint32_t>(textures_.size() + virtualTextures_.size());
+    stats_.pendingLoads = loadsInFlight_;
+    stats_.pageCapacity = static_cast<uint32_t>(pageSlots_.size());
+    stats_.residentPages = static_cast<uint32_t>(pageSlots_.size() - freePageSlots_.size());
+}
+
+void TextureStreamingEngine::LoaderThread() {
+    for (;;) {
+        LoadRequest request;
+        {
+            std::unique_lock<std::mutex> lock(loadQueueMutex_);
+            loadQueueCondition_.wait(lock, [this] { return shutdownRequested_ || !loadQueue_.empty(); });
+            if (shutdownRequested_) return;
+            request = loadQueue_.top();
+            loadQueue_.pop();
+        }
+
+        CompletedLoad load;
+        load.textureId = request.textureId;
+        load.mipLevel = request.mipLevel;
+        load.staging = request.page ? LoadPage(request) : LoadTextureMip(request);
+        load.page = request.page;
+        load.pageX = request.pageX;
+        load.pageY = request.pageY;
+
+        std::lock_guard<std::mutex> lock(completedMutex_);
+        completedLoads_.push_back(load);
+    }
+}
+
+ID3D11Texture2D* TextureStreamingEngine::LoadTextureMip(const LoadRequest& request) const {
+    const D3D11_TEXTURE2D_DESC& fullDesc = request.source->GetDesc();
+    const std::vector<D3D11_SUBRESOURCE_DATA>& subresources = request.source->GetSubresources();
+
+    // Creating the staging copy is what touches the mapped pages, so the disk read happens here
+    // rather than on the render thread. Device object creation is free-threaded
+    D3D11_TEXTURE2D_DESC desc = fullDesc;
+    desc.Width = std::max(1u, fullDesc.Width >> request.mipLevel);
+    desc.Height = std::max(1u, fullDesc.Height >> request.mipLevel);
+    desc.MipLevels = 1;
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.BindFlags = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    desc.MiscFlags = 0;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> initialData(desc.ArraySize);
+    for (UINT slice = 0; slice < desc.ArraySize; ++slice) {
+        initialData[slice] = subresources[D3D11CalcSubresource(request.mipLevel, slice, fullDesc.MipLevels)];
+    }
+
+    ID3D11Texture2D* staging = nullptr;
+    if (FAILED(device_->CreateTexture2D(&desc, initialData.data(), &staging))) {
+        return nullptr;
+    }
+    return staging;
+}
+
+void TextureStreamingEngine::ProcessLoadQueue() {
+    std::vector<CompletedLoad> completed;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex_);
+        const size_t count = std::min(completedLoads_.size(), static_cast<size_t>(maxLoadRequestsPerFrame_));
+        completed.assign(completedLoads_.begin(), completedLoads_.begin() + count);
+        completedLoads_.erase(completedLoads_.begin(), completedLoads_.begin() + count);
+    }
+
+    for (CompletedLoad& load : completed) {
+        --loadsInFlight_;
+        if (load.page) {
+            ApplyPage(load);
+            SafeRelease(load.staging);
+            continue;
+        }
+
+        auto it = textures_.find(load.textureId);
+        if (it == textures_.end() || it->second->pendingMip != load.mipLevel) {
+            SafeRelease(load.staging);
+            continue;
+        }
+
+        StreamingTexture& texture = *it->second;
+        const uint64_t bytes = ComputeMipMemory(texture, load.mipLevel);
+        pendingMemory_ -= bytes;
+        texture.pendingMip = NO_MIP;
+
+        // A load that no longer extends the resident chain (it was evicted meanwhile) is dropped
+        if (!load.staging) {
+            Logger::Warning("Failed to stream mip " + std::to_string(load.mipLevel) + " of " + texture.filePath);
+            texture.failed = true;
+        } else if (load.mipLevel + 1 == texture.residentMip && ApplyTextureMip(texture, load.mipLevel, load.staging)) {
+            ++stats_.uploadsThisFrame;
+            stats_.bytesStreamed += bytes;
+        }
+        SafeRelease(load.staging);
+    }
+}
+
+void TextureStreamingEngine::ScheduleLoads() {
+    std::vector<std::pair<LoadRequest, StreamingTexture*>> candidates;
+    for (auto& entry : textures_) {
+        StreamingTexture& texture = *entry.second;
+        if (texture.pendingMip != NO_MIP || texture.residentMip == 0) continue;
+
+        const UINT wanted = GetWantedMip(texture);
+        if (wanted >= texture.residentMip) continue;
+
+        LoadRequest request;
+        request.source = texture.source;
+        request.textureId = entry.first;
+        request.mipLevel = texture.residentMip - 1;
+        request.priority = texture.priority;
+        request.deficit = texture.residentMip - wanted;
+        request.distance = texture.distanceFromCamera;
+        candidates.emplace_back(std::move(request), &texture);
+    }
+
+    // Most urgent first, so they win the budget. The queue is kept short so that requests reflect
+    // the current view rather than where the camera was several frames ago
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return b.first < a.first; });
+
+    stats_.starvedTextures = 0;
+    const uint32_t maxInFlight = static_cast<uint32_t>(maxLoadRequestsPerFrame_) * 2;
+    for (auto& candidate : candidates) {
+        StreamingTexture& texture = *candidate.second;
+        const uint64_t bytes = ComputeMipMemory(texture, candidate.first.mipLevel);
+        if (loadsInFlight_ >= maxInFlight || !EvictFor(bytes, &texture)) {
+            ++stats_.starvedTextures;
+            continue;
+        }
+
+        texture.pendingMip = candidate.first.mipLevel;
+        pendingMemory_ += bytes;
+        ++loadsInFlight_;
+        {
+            std::lock_guard<std::mutex> lock(loadQueueMutex_);
+            loadQueue_.push(std::move(candidate.first));
+        }
+        loadQueueCondition_.notify_one();
+    }
+}
+
+bool TextureStreamingEngine::ApplyTextureMip(StreamingTexture& texture, UINT mipLevel, ID3D11Texture2D* staging) {
+    if (!texture.tiled) {
+        return Reallocate(texture, mipLevel, staging);
+    }
+
+    if (!MapTiles(texture, mipLevel)) return false;
+    context2_->TiledResourceBarrier(nullptr, texture.texture);
+    context_->CopySubresourceRegion(texture.texture, D3D11CalcSubresource(mipLevel, 0, texture.desc.MipLevels),
+                                    0, 0, 0, staging, 0, nullptr);
+    // Only now may the sampler see the new level
+    context_->SetResourceMinLOD(texture.texture, static_cast<float>(mipLevel));
+    texture.residentMip = mipLevel;
+    return true;
+}
+
+void TextureStreamingEngine::UnloadTextureMip(StreamingTexture& texture) {
+    if (texture.residentMip >= texture.tailMip) return;
+
+    const UINT mipLevel = texture.residentMip;
+    if (texture.tiled) {
+        // Clamp first so nothing samples the tiles once they are handed to another texture
+        context_->SetResourceMinLOD(texture.texture, static_cast<float>(mipLevel + 1));
+        UnmapTiles(texture, mipLevel);
+        texture.residentMip = mipLevel + 1;
+    } else if (!Reallocate(texture, mipLevel + 1, nullptr)) {
+        return;
+    }
+    ++stats_.evictionsThisFrame;
+}
+
+bool TextureStreamingEngine::Reallocate(StreamingTexture& texture, UINT mipLevel, ID3D11Texture2D* staging) {
+    const D3D11_TEXTURE2D_DESC desc = GetSubChainDesc(texture.desc, mipLevel);
+    ID3D11Texture2D* resized = nullptr;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &resized))) {
+        return false;
+    }
+
+    // Levels both chains share are copied on the GPU; a finer level comes from the staging texture
+    const UINT oldLevels = texture.desc.MipLevels - texture.residentMip;
+    const UINT firstShared = std::max(mipLevel, texture.residentMip);
+    for (UINT slice = 0; slice < desc.ArraySize; ++slice) {
+        for (UINT mip = firstShared; mip < texture.desc.MipLevels; ++mip) {
+            context_->CopySubresourceRegion(resized, D3D11CalcSubresource(mip - mipLevel, slice, desc.MipLevels),
+                                            0, 0, 0, texture.texture,
+                                            D3D11CalcSubresource(mip - texture.residentMip, slice, oldLevels), nullptr);
+        }
+        if (staging) {
+            context_->CopySubresourceRegion(resized, D3D11CalcSubresource(0, slice, desc.MipLevels), 0, 0, 0,
+                                            staging, slice, nullptr);
+        }
+    }
+
+    const D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = TextureFile::GetViewDesc(desc);
+    ID3D11ShaderResourceView* srv = nullptr;
+    if (FAILED(device_->CreateShaderResourceView(resized, &srvDesc, &srv))) {
+        resized->Release();
+        return false;
+    }
+
+    SafeRelease(texture.srv);
+    SafeRelease(texture.texture);
+    texture.texture = resized;
+    texture.srv = srv;
+    texture.residentMip = mipLevel;
+
+    currentMemoryUsage_ -= texture.memoryUsage;
+    texture.memoryUsage = TextureFile::ComputeMemoryUsage(desc);
+    currentMemoryUsage_ += texture.memoryUsage;
+    return true;
+}
+
+bool TextureStreamingEngine::CreateResidentTexture(StreamingTexture& texture) {
+    const D3D11_TEXTURE2D_DESC& desc = texture.desc;
+    const std::vector<D3D11_SUBRESOURCE_DATA>& subresources = texture.source->GetSubresources();
+
+    texture.tailMip = ComputeTailMip(desc);
+    texture.tiled = tiled_ && texture.tailMip > 0 && desc.ArraySize == 1 &&
+                    (desc.MiscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE) == 0;
+    if (!texture.tiled && !CanReallocate(desc, texture.tailMip)) {
+        texture.tailMip = 0;
+    }
+
+    if (texture.tiled) {
+        D3D11_TEXTURE2D_DESC tiledDesc = GetSubChainDesc(desc, 0);
+        tiledDesc.MiscFlags |= D3D11_RESOURCE_MISC_TILED;
+        if (SUCCEEDED(device_->CreateTexture2D(&tiledDesc, nullptr, &texture.texture))) {
+            UINT totalTiles = 0;
+            D3D11_PACKED_MIP_DESC packedDesc = {};
+            D3D11_TILE_SHAPE tileShape = {};
+            UINT subresourceCount = desc.MipLevels;
+            std::vector<D3D11_SUBRESOURCE_TILING> tilings(desc.MipLevels);
+            device2_->GetResourceTiling(texture.texture, &totalTiles, &packedDesc, &tileShape, &subresourceCount, 0,
+                                        tilings.data());
+
+            // Slot standardMips holds the packed tail, which is mapped (and evicted) as one unit
+            texture.standardMips = packedDesc.NumStandardMips;
+            texture.tileCounts.assign(texture.standardMips + 1, 0);
+            for (UINT mip = 0; mip < texture.standardMips; ++mip) {
+                texture.tileCounts[mip] = tilings[mip].WidthInTiles * tilings[mip].HeightInTiles *
+                                          tilings[mip].DepthInTiles;
+            }
+            texture.tileCounts[texture.standardMips] = packedDesc.NumTilesForPackedMips;
+            texture.tiles.assign(texture.standardMips + 1, std::vector<UINT>());
+            texture.tailMip = std::min(texture.tailMip, texture.standardMips);
+
+            uint64_t tailBytes = 0;
+            for (UINT mip = texture.tailMip; mip <= texture.standardMips; ++mip) {
+                tailBytes += static_cast<uint64_t>(texture.tileCounts[mip]) * TILE_SIZE_BYTES;
+            }
+            EvictFor(tailBytes, nullptr);
+
+            bool mapped = true;
+            for (UINT mip = texture.tailMip; mip <= texture.standardMips && mapped; ++mip) {
+                mapped = MapTiles(texture, mip);
+            }
+            if (mapped) {
+                context2_->TiledResourceBarrier(nullptr, texture.texture);
+                for (UINT mip = texture.tailMip; mip < desc.MipLevels; ++mip) {
+                    const D3D11_SUBRESOURCE_DATA& data = subresources[mip];
+                    context_->UpdateSubresource(texture.texture, mip, nullptr, data.pSysMem, data.SysMemPitch,
+                                                data.SysMemSlicePitch);
+                }
+                context_->SetResourceMinLOD(texture.texture, static_cast<float>(texture.tailMip));
+
+                const D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = TextureFile::GetViewDesc(tiledDesc);
+                if (SUCCEEDED(device_->CreateShaderResourceView(texture.texture, &srvDesc, &texture.srv))) {
+                    texture.residentMip = texture.tailMip;
+                    return true;
+                }
+            }
+        }
+
+        // Out of tiles or a format the tier cannot tile: fall back to an ordinary chain
+        ReleaseTexture(texture);
+        texture.tiled = false;
+        texture.tailMip = CanReallocate(desc, ComputeTailMip(desc)) ? ComputeTailMip(desc) : 0;
+    }
+
+    const D3D11_TEXTURE2D_DESC tailDesc = GetSubChainDesc(desc, texture.tailMip);
+    EvictFor(TextureFile::ComputeMemoryUsage(tailDesc), nullptr);
+
+    // The tail uploads straight from the mapping, like TextureFile::CreateTexture
+    std::vector<D3D11_SUBRESOURCE_DATA> initialData(tailDesc.MipLevels * tailDesc.ArraySize);
+    for (UINT slice = 0; slice < tailDesc.ArraySize; ++slice) {
+        for (UINT mip = 0; mip < tailDesc.MipLevels; ++mip) {
+            initialData[D3D11CalcSubresource(mip, slice, tailDesc.MipLevels)] =
+                subresources[D3D11CalcSubresource(mip + texture.tailMip, slice, desc.MipLevels)];
+        }
+    }
+    if (FAILED(device_->CreateTexture2D(&tailDesc, initialData.data(), &texture.texture))) {
+        return false;
+    }
+
+    const D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = TextureFile::GetViewDesc(tailDesc);
+    if (FAILED(device_->CreateShaderResourceView(texture.texture, &srvDesc, &texture.srv))) {
+        return false;
+    }
+
+    texture.residentMip = texture.tailMip;
+    texture.memoryUsage = TextureFile::ComputeMemoryUsage(tailDesc);
+    currentMemoryUsage_ += texture.memoryUsage;
+    return true;
+}
+
+void TextureStreamingEngine::ReleaseTexture(StreamingTexture& texture) {
+    // Destroying the resource drops its mappings, so tiles go straight back to the pool
+    for (std::vector<UINT>& tiles : texture.tiles) {
+        freeTiles_.insert(freeTiles_.end(), tiles.begin(), tiles.end());
+        tiles.clear();
+    }
+    SafeRelease(texture.srv);
+    SafeRelease(texture.texture);
+    currentMemoryUsage_ -= texture.memoryUsage;
+    texture.memoryUsage = 0;
+}
+
+void TextureStreamingEngine::EnforceMemoryBudget() {
+    TrimMemory(memoryBudget_);
+}
+
+bool TextureStreamingEngine::EvictFor(uint64_t bytes, const StreamingTexture* requester) {
+    while (currentMemoryUsage_ + pendingMemory_ + bytes > memoryBudget_) {
+        StreamingTexture* victim = FindLRUTexture(requester, requester != nullptr);
+        if (!victim) return false;
+        UnloadTextureMip(*victim);
+    }
+    return true;
+}
+
+TextureStreamingEngine::StreamingTexture* TextureStreamingEngine::FindLRUTexture(const StreamingTexture* requester,
+                                                                                 bool lessImportantOnly) {
+    // Textures holding more detail than they want go first, then the longest unused, then the
+    // least important; a requester only displaces textures it outranks so that two textures in
+    // view never evict each other back and forth
+    StreamingTexture* best = nullptr;
+    bool bestSurplus = false;
+    for (auto& entry : textures_) {
+        StreamingTexture& texture = *entry.second;
+        if (&texture == requester || texture.residentMip >= texture.tailMip || texture.pendingMip != NO_MIP) continue;
+
+        const bool surplus = texture.residentMip < GetWantedMip(texture);
+        if (lessImportantOnly && !surplus) {
+            const bool older = lruEnabled_ && texture.lastUsedFrame < requester->lastUsedFrame;
+            if (!older && texture.priority <= requester->priority) continue;
+        }
+
+        if (!best) {
+            best = &texture;
+            bestSurplus = surplus;
+            continue;
+        }
+        if (surplus != bestSurplus) {
+            if (surplus) {
+                best = &texture;
+                bestSurplus = true;
+            }
+            continue;
+        }
+        if (lruEnabled_ && texture.lastUsedFrame != best->lastUsedFrame) {
+            if (texture.lastUsedFrame < best->lastUsedFrame) best = &texture;
+        } else if (texture.priority != best->priority) {
+            if (texture.priority > best->priority) best = &texture;
+        } else if (texture.memoryUsage > best->memoryUsage) {
+            best = &texture;
+        }
+    }
+    return best;
+}
+
+void TextureStreamingEngine::UpdateLRU(StreamingTexture& texture) {
+    texture.lastUsedFrame = frameIndex_;
+}
+
+UINT TextureStreamingEngine::GetWantedMip(const StreamingTexture& texture) const {
+    UINT mip = texture.tailMip;
+    if (texture.usageFrame != 0 && frameIndex_ - texture.usageFrame <= RETAIN_FRAMES) {
+        mip = std::min(mip, texture.usageMip);
+    }
+    if (texture.pinnedMip != NO_MIP) {
+        mip = std::min(mip, texture.pinnedMip);
+    }
+    // Do not keep retrying a level the file could not provide
+    if (texture.failed) {
+        mip = std::max(mip, texture.residentMip);
+    }
+    return mip;
+}
+
+uint64_t TextureStreamingEngine::ComputeMipMemory(const StreamingTexture& texture, UINT mipLevel) const {
+    if (texture.tiled) {
+        return static_cast<uint64_t>(texture.tileCounts[std::min(mipLevel, texture.standardMips)]) * TILE_SIZE_BYTES;
+    }
+    D3D11_TEXTURE2D_DESC desc = GetSubChainDesc(texture.desc, mipLevel);
+    desc.MipLevels = 1;
+    return TextureFile::ComputeMemoryUsage(desc);
+}
+
+bool TextureStreamingEngine::InitializeTilePool(uint64_t budgetBytes) {
+    const UINT tiles = static_cast<UINT>(std::min<uint64_t>(INITIAL_POOL_TILES, budgetBytes / TILE_SIZE_BYTES));
+    if (tiles == 0) return false;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth = tiles * TILE_SIZE_BYTES;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_TILE_POOL;
+    if (FAILED(device_->CreateBuffer(&desc, nullptr, &tilePool_))) {
+        return false;
+    }
+
+    tilePoolSize_ = tiles;
+    freeTiles_.clear();
+    for (UINT tile = tiles; tile > 0; --tile) {
+        freeTiles_.push_back(tile - 1);
+    }
+    return true;
+}
+
+bool TextureStreamingEngine::GrowTilePool(UINT requiredTiles) {
+    // The pool only grows; a lower budget is met by evicting, which returns tiles to the free list
+    const uint64_t maxTiles = std::min<uint64_t>(memoryBudget_ / TILE_SIZE_BYTES, UINT_MAX / TILE_SIZE_BYTES);
+    const uint64_t needed = static_cast<uint64_t>(tilePoolSize_) + requiredTiles - freeTiles_.size();
+    if (needed > maxTiles) return false;
+
+    const UINT newSize = static_cast<UINT>(std::min<uint64_t>(std::max<uint64_t>(needed, tilePoolSize_ * 2ull), maxTiles));
+    if (FAILED(context2_->ResizeTilePool(tilePool_, static_cast<UINT64>(newSize) * TILE_SIZE_BYTES))) {
+        return false;
+    }
+    for (UINT tile = newSize; tile > tilePoolSize_; --tile) {
+        freeTiles_.push_back(tile - 1);
+    }
+    tilePoolSize_ = newSize;
+    return true;
+}
+
+bool TextureStreamingEngine::MapTiles(StreamingTexture& texture, UINT mipLevel) {
+    const UINT slot = std::min(mipLevel, texture.standardMips);
+    const UINT count = texture.tileCounts[slot];
+    if (count == 0) return true;
+    if (freeTiles_.size() < count && !GrowTilePool(count)) return false;
+
+    std::vector<UINT>& tiles = texture.tiles[slot];
+    tiles.assign(freeTiles_.end() - count, freeTiles_.end());
+    freeTiles_.resize(freeTiles_.size() - count);
+
+    // Pool tiles are not contiguous, so every tile is its own one-tile range. Packed mips are
+    // addressed through the first packed subresource
+    D3D11_TILED_RESOURCE_COORDINATE coordinate = {};
+    coordinate.Subresource = slot;
+    D3D11_TILE_REGION_SIZE region = {};
+    region.NumTiles = count;
+    const std::vector<UINT> rangeCounts(count, 1);
+    if (FAILED(context2_->UpdateTileMappings(texture.texture, 1, &coordinate, &region, tilePool_, count, nullptr,
+                                             tiles.data(), rangeCounts.data(), 0))) {
+        freeTiles_.insert(freeTiles_.end(), tiles.begin(), tiles.end());
+        tiles.clear();
+        return false;
+    }
+
+    texture.memoryUsage += static_cast<uint64_t>(count) * TILE_SIZE_BYTES;
+    currentMemoryUsage_ += static_cast<uint64_t>(count) * TILE_SIZE_BYTES;
+    return true;
+}
+
+void TextureStreamingEngine::UnmapTiles(StreamingTexture& texture, UINT mipLevel) {
+    const UINT slot = std::min(mipLevel, texture.standardMips);
+    std::vector<UINT>& tiles = texture.tiles[slot];
+    if (tiles.empty()) return;
+
+    D3D11_TILED_RESOURCE_COORDINATE coordinate = {};
+    coordinate.Subresource = slot;
+    D3D11_TILE_REGION_SIZE region = {};
+    region.NumTiles = static_cast<UINT>(tiles.size());
+    const UINT flags = D3D11_TILE_RANGE_NULL;
+    context2_->UpdateTileMappings(texture.texture, 1, &coordinate, &region, nullptr, 1, &flags, nullptr,
+                                  &region.NumTiles, 0);
+
+    const uint64_t bytes = static_cast<uint64_t>(tiles.size()) * TILE_SIZE_BYTES;
+    texture.memoryUsage -= bytes;
+    currentMemoryUsage_ -= bytes;
+    freeTiles_.insert(freeTiles_.end(), tiles.begin(), tiles.end());
+    tiles.clear();
+}
+
+uint32_t TextureStreamingEngine::LoadVirtualTexture(const std::string& filePath, StreamingPriority priority) {
+    if (!device_) return INVALID_TEXTURE;
+    NEXUS_PROFILE_SCOPE("TextureStreamingEngine::LoadVirtualTexture");
+
+    auto source = std::make_shared<TextureFile>();
+    if (!source->Open(filePath)) return INVALID_TEXTURE;
+
+    const D3D11_TEXTURE2D_DESC& desc = source->GetDesc();
+    const UINT pagesX = desc.Width / PAGE_SIZE;
+    const UINT pagesY = desc.Height / PAGE_SIZE;
+    UINT levels = 1;
+    while ((std::max(pagesX, pagesY) >> (levels - 1)) > 1) {
+        ++levels;
+    }
+    if (desc.ArraySize != 1 || source->IsCubemap() || !IsPowerOfTwo(desc.Width) || !IsPowerOfTwo(desc.Height) ||
+        pagesX == 0 || pagesY == 0 || std::max(pagesX, pagesY) > MAX_PAGES || desc.MipLevels < levels ||
+        TextureFile::GetBitsPerPixel(desc.Format) == 0) {
+        Logger::Error("Not a valid virtual texture: " + filePath);
+        return INVALID_TEXTURE;
+    }
+    if (pageAtlas_ && desc.Format != pageFormat_) {
+        Logger::Error("Virtual texture format differs from the page cache: " + filePath);
+        return INVALID_TEXTURE;
+    }
+    if (!pageAtlas_ && !CreatePageAtlas(desc.Format)) {
+        Logger::Error("Failed to create the virtual texture page cache");
+        return INVALID_TEXTURE;
+    }
+
+    const uint32_t* freeIndex = std::find(std::begin(virtualIds_), std::end(virtualIds_), INVALID_TEXTURE);
+    if (freeIndex == std::end(virtualIds_)) {
+        Logger::Error("Too many virtual textures: " + filePath);
+        return INVALID_TEXTURE;
+    }
+
+    auto texture = std::make_unique<VirtualTexture>();
+    texture->source = source;
+    texture->filePath = filePath;
+    texture->desc = desc;
+    texture->priority = priority;
+    texture->feedbackIndex = static_cast<UINT>(freeIndex - std::begin(virtualIds_));
+    texture->pagesX = pagesX;
+    texture->pagesY = pagesY;
+    texture->levels = levels;
+    texture->pageTable.resize(levels);
+    texture->dirtyRegions.assign(levels, D3D11_BOX());
+    for (UINT level = 0; level < levels; ++level) {
+        texture->pageTable[level].assign(std::max(1u, pagesX >> level) * std::max(1u, pagesY >> level), 0);
+    }
+
+    D3D11_TEXTURE2D_DESC tableDesc = {};
+    tableDesc.Width = pagesX;
+    tableDesc.Height = pagesY;
+    tableDesc.MipLevels = levels;
+    tableDesc.ArraySize = 1;
+    tableDesc.Format = DXGI_FORMAT_R32_UINT;
+    tableDesc.SampleDesc.Count = 1;
+    tableDesc.Usage = D3D11_USAGE_DEFAULT;
+    tableDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_BUFFER_DESC constantsDesc = {};
+    constantsDesc.ByteWidth = sizeof(VirtualConstants);
+    constantsDesc.Usage = D3D11_USAGE_DYNAMIC;
+    constantsDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    constantsDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    const uint32_t id = nextTextureId_++;
+    const D3D11_SHADER_RESOURCE_VIEW_DESC tableViewDesc = TextureFile::GetViewDesc(tableDesc);
+    bool created = SUCCEEDED(device_->CreateTexture2D(&tableDesc, nullptr, &texture->pageTableTexture)) &&
+                   SUCCEEDED(device_->CreateShaderResourceView(texture->pageTableTexture, &tableViewDesc,
+                                                               &texture->pageTableView)) &&
+                   SUCCEEDED(device_->CreateBuffer(&constantsDesc, nullptr, &texture->constants));
+
+    // The single coarsest page is read here and pinned, so every lookup resolves to something
+    if (created) {
+        LoadRequest request;
+        request.source = source;
+        request.textureId = id;
+        request.mipLevel = levels - 1;
+        request.page = true;
+        ID3D11Texture2D* staging = LoadPage(request);
+        created = staging && AddPage(id, *texture, levels - 1, 0, 0, staging, true);
+        SafeRelease(staging);
+    }
+    if (!created) {
+        Logger::Error("Failed to create virtual texture: " + filePath);
+        ReleaseVirtualTexture(id, *texture);
+        return INVALID_TEXTURE;
+    }
+
+    virtualIds_[texture->feedbackIndex] = id;
+    virtualTextures_[id] = std::move(texture);
+    return id;
+}
+
+void TextureStreamingEngine::SetPageCacheSize(UINT pagesPerSide) {
+    pageCacheSize_ = std::clamp(pagesPerSide, 1u, MAX_PAGE_CACHE_SIZE);
+}
+
+bool TextureStreamingEngine::ResizeFeedback(UINT width, UINT height) {
+    if (!device_) return false;
+
+    for (ID3D11Texture2D*& readback : feedbackReadback_) {
+        SafeRelease(readback);
+    }
+    SafeRelease(feedbackView_);
+    SafeRelease(feedback_);
+    feedbackWrite_ = 0;
+    feedbackPending_ = 0;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = std::max(1u, (width + FEEDBACK_SCALE - 1) / FEEDBACK_SCALE);
+    desc.Height = std::max(1u, (height + FEEDBACK_SCALE - 1) / FEEDBACK_SCALE);
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R32_UINT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+
+    D3D11_TEXTURE2D_DESC readbackDesc = desc;
+    readbackDesc.Usage = D3D11_USAGE_STAGING;
+    readbackDesc.BindFlags = 0;
+    readbackDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    bool created = SUCCEEDED(device_->CreateTexture2D(&desc, nullptr, &feedback_)) &&
+                   SUCCEEDED(device_->CreateUnorderedAccessView(feedback_, nullptr, &feedbackView_));
+    for (ID3D11Texture2D*& readback : feedbackReadback_) {
+        created = created && SUCCEEDED(device_->CreateTexture2D(&readbackDesc, nullptr, &readback));
+    }
+    if (!created) {
+        Logger::Error("Failed to create the virtual texture feedback target");
+        for (ID3D11Texture2D*& readback : feedbackReadback_) {
+            SafeRelease(readback);
+        }
+        SafeRelease(feedbackView_);
+        SafeRelease(feedback_);
+        return false;
+    }
+
+    feedbackWidth_ = desc.Width;
+    feedbackHeight_ = desc.Height;
+    const UINT clear[4] = { EMPTY_FEEDBACK, EMPTY_FEEDBACK, EMPTY_FEEDBACK, EMPTY_FEEDBACK };
+    context_->ClearUnorderedAccessViewUint(feedbackView_, clear);
+    return true;
+}
+
+void TextureStreamingEngine::BindVirtualTexture(uint32_t textureId, StateCache& stateCache) {
+    auto it = virtualTextures_.find(textureId);
+    if (it == virtualTextures_.end()) return;
+
+    VirtualTexture& texture = *it->second;
+    if (texture.constantsFrame != frameIndex_) {
+        D3D11_MAPPED_SUBRESOURCE mapped = {};
+        if (SUCCEEDED(context_->Map(texture.constants, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+            VirtualConstants* constants = static_cast<VirtualConstants*>(mapped.pData);
+            const float atlasScale = 1.0f / static_cast<float>(pageCacheSize_ * PAGE_SLOT_SIZE);
+            constants->size = XMFLOAT2(static_cast<float>(texture.desc.Width), static_cast<float>(texture.desc.Height));
+            constants->atlasScale = XMFLOAT2(atlasScale, atlasScale);
+            constants->index = texture.feedbackIndex;
+            constants->maxLevel = texture.levels - 1;
+            // An odd stride visits every pixel of a feedback block once in FEEDBACK_SCALE^2 frames
+            const UINT phase = static_cast<UINT>(frameIndex_ * 37) % (FEEDBACK_SCALE * FEEDBACK_SCALE);
+            constants->phaseX = phase % FEEDBACK_SCALE;
+            constants->phaseY = phase / FEEDBACK_SCALE;
+            context_->Unmap(texture.constants, 0);
+            texture.constantsFrame = frameIndex_;
+        }
+    }
+
+    ID3D11ShaderResourceView* views[] = { texture.pageTableView, pageAtlasView_ };
+    stateCache.PSSetShaderResources(VIRTUAL_SLOT, 2, views);
+    stateCache.PSSetConstantBuffers(VIRTUAL_CONSTANTS_SLOT, 1, &texture.constants);
+    if (feedbackView_) {
+        context_->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr,
+                                                            nullptr, FEEDBACK_UAV_SLOT, 1, &feedbackView_, nullptr);
+    }
+}
+
+void TextureStreamingEngine::ResolveFeedback() {
+    if (!feedback_ || virtualTextures_.empty()) return;
+
+    // Unbound first, since a later draw must not write it between the copy and the clear
+    ID3D11UnorderedAccessView* nullView = nullptr;
+    context_->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr,
+                                                        FEEDBACK_UAV_SLOT, 1, &nullView, nullptr);
+    context_->CopyResource(feedbackReadback_[feedbackWrite_], feedback_);
+    feedbackWrite_ = (feedbackWrite_ + 1) % FEEDBACK_LATENCY;
+    feedbackPending_ = std::min(feedbackPending_ + 1, FEEDBACK_LATENCY);
+
+    const UINT clear[4] = { EMPTY_FEEDBACK, EMPTY_FEEDBACK, EMPTY_FEEDBACK, EMPTY_FEEDBACK };
+    context_->ClearUnorderedAccessViewUint(feedbackView_, clear);
+}
+
+ID3D11Texture2D* TextureStreamingEngine::LoadPage(const LoadRequest& request) const {
+    const D3D11_TEXTURE2D_DESC& fullDesc = request.source->GetDesc();
+    const D3D11_SUBRESOURCE_DATA& level = request.source->GetSubresources()[request.mipLevel];
+
+    // Pages are cut in whole blocks, so block-compressed data is copied rather than re-encoded. The
+    // border repeats the neighbouring pages' texels, and the edge texels past the texture's edges
+    const int block = TextureFile::IsBlockCompressed(fullDesc.Format) ? 4 : 1;
+    UINT blockBytes = 0, blockRows = 0;
+    TextureFile::GetSurfaceInfo(fullDesc.Format, block, block, blockBytes, blockRows);
+    const int levelBlocksX = static_cast<int>((std::max(1u, fullDesc.Width >> request.mipLevel) + block - 1) / block);
+    const int levelBlocksY = static_cast<int>((std::max(1u, fullDesc.Height >> request.mipLevel) + block - 1) / block);
+    const int slotBlocks = static_cast<int>(PAGE_SLOT_SIZE) / block;
+    const int originX = (static_cast<int>(request.pageX * PAGE_SIZE) - static_cast<int>(PAGE_BORDER)) / block;
+    const int originY = (static_cast<int>(request.pageY * PAGE_SIZE) - static_cast<int>(PAGE_BORDER)) / block;
+    const int copyBegin = std::clamp(-originX, 0, slotBlocks);
+    const int copyEnd = std::clamp(levelBlocksX - originX, copyBegin, slotBlocks);
+
+    // Reading the mapping here is what faults the pages in, off the render thread like a mip load
+    const size_t pitch = static_cast<size_t>(slotBlocks) * blockBytes;
+    std::vector<uint8_t> texels(pitch * slotBlocks);
+    for (int row = 0; row < slotBlocks; ++row) {
+        const int sourceRow = std::clamp(originY + row, 0, levelBlocksY - 1);
+        const uint8_t* source = static_cast<const uint8_t*>(level.pSysMem) + static_cast<size_t>(sourceRow) * level.SysMemPitch;
+        uint8_t* dest = texels.data() + row * pitch;
+        for (int column = 0; column < copyBegin; ++column) {
+            std::memcpy(dest + column * blockBytes, source, blockBytes);
+        }
+        std::memcpy(dest + copyBegin * blockBytes, source + (originX + copyBegin) * blockBytes,
+                    static_cast<size_t>(copyEnd - copyBegin) * blockBytes);
+        for (int column = copyEnd; column < slotBlocks; ++column) {
+            std::memcpy(dest + column * blockBytes, source + (levelBlocksX - 1) * blockBytes, blockBytes);
+        }
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = PAGE_SLOT_SIZE;
+    desc.Height = PAGE_SLOT_SIZE;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = fullDesc.Format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    D3D11_SUBRESOURCE_DATA initialData = {};
+    initialData.pSysMem = texels.data();
+    initialData.SysMemPitch = static_cast<UINT>(pitch);
+
+    ID3D11Texture2D* staging = nullptr;
+    if (FAILED(device_->CreateTexture2D(&desc, &initialData, &staging))) {
+        return nullptr;
+    }
+    return staging;
+}
+
+bool TextureStreamingEngine::CreatePageAtlas(DXGI_FORMAT format) {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = pageCacheSize_ * PAGE_SLOT_SIZE;
+    desc.Height = desc.Width;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &pageAtlas_))) {
+        return false;
+    }
+
+    const D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = TextureFile::GetViewDesc(desc);
+    if (FAILED(device_->CreateShaderResourceView(pageAtlas_, &viewDesc, &pageAtlasView_))) {
+        SafeRelease(pageAtlas_);
+        return false;
+    }
+
+    const UINT slots = pageCacheSize_ * pageCacheSize_;
+    pageSlots_.assign(slots, PageSlot());
+    freePageSlots_.clear();
+    for (UINT slot = slots; slot > 0; --slot) {
+        freePageSlots_.push_back(slot - 1);
+    }
+    pageFormat_ = format;
+
+    Logger::Info("Virtual texture page cache: " + std::to_string(slots) + " pages, " +
+                 std::to_string(TextureFile::ComputeMemoryUsage(desc) / (1024 * 1024)) + " MB");
+    return true;
+}
+
+void TextureStreamingEngine::ReleasePageAtlas() {
+    SafeRelease(pageAtlasView_);
+    SafeRelease(pageAtlas_);
+    pageSlots_.clear();
+    freePageSlots_.clear();
+    pageFormat_ = DXGI_FORMAT_UNKNOWN;
+}
+
+void TextureStreamingEngine::ReadFeedback() {
+    if (!feedback_ || feedbackPending_ < FEEDBACK_LATENCY || virtualTextures_.empty()) return;
+    NEXUS_PROFILE_SCOPE("TextureStreamingEngine::ReadFeedback");
+
+    // The oldest copy is the one ResolveFeedback() overwrites next. If the GPU has not reached it
+    // yet, it is skipped rather than waited for
+    ID3D11Texture2D* readback = feedbackReadback_[feedbackWrite_];
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (context_->Map(readback, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped) != S_OK) return;
+
+    // Neighbouring pixels mostly want the same page
+    std::unordered_set<uint32_t> requests;
+    for (UINT y = 0; y < feedbackHeight_; ++y) {
+        const uint32_t* row = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(mapped.pData) +
+                                                                static_cast<size_t>(y) * mapped.RowPitch);
+        uint32_t previous = EMPTY_FEEDBACK;
+        for (UINT x = 0; x < feedbackWidth_; ++x) {
+            if (row[x] != previous && row[x] != EMPTY_FEEDBACK) {
+                requests.insert(row[x]);
+            }
+            previous = row[x];
+        }
+    }
+    context_->Unmap(readback, 0);
+    --feedbackPending_;
+
+    std::unordered_map<uint64_t, LoadRequest> candidates;
+    stats_.pageMisses = 0;
+    for (uint32_t request : requests) {
+        auto it = virtualTextures_.find(virtualIds_[request >> 26]);
+        if (it == virtualTextures_.end()) continue;
+
+        VirtualTexture& texture = *it->second;
+        const UINT level = std::min((request >> 22) & 15u, texture.levels - 1);
+        const UINT x = std::min(request & 2047u, std::max(1u, texture.pagesX >> level) - 1);
+        const UINT y = std::min((request >> 11) & 2047u, std::max(1u, texture.pagesY >> level) - 1);
+
+        // The finest resident page on the way up is what the pixel sampled; the top one always is
+        UINT resident = level;
+        auto page = texture.pages.find(GetPageKey(level, x, y));
+        while (page == texture.pages.end() && resident + 1 < texture.levels) {
+            ++resident;
+            page = texture.pages.find(GetPageKey(resident, x >> (resident - level), y >> (resident - level)));
+        }
+        if (page == texture.pages.end()) continue;
+        pageSlots_[page->second].lastUsedFrame = frameIndex_;
+        if (resident == level) continue;
+        ++stats_.pageMisses;
+
+        // Refine one level at a time, like mips, so each arriving page sharpens the view
+        const UINT next = resident - 1;
+        const UINT nextX = x >> (next - level);
+        const UINT nextY = y >> (next - level);
+        const uint32_t key = GetPageKey(next, nextX, nextY);
+        if (texture.pendingPages.count(key)) continue;
+
+        LoadRequest& load = candidates[(static_cast<uint64_t>(it->first) << 32) | key];
+        if (!load.page) {
+            load.source = texture.source;
+            load.textureId = it->first;
+            load.mipLevel = next;
+            load.priority = texture.priority;
+            load.page = true;
+            load.pageX = nextX;
+            load.pageY = nextY;
+        }
+        load.deficit = std::max(load.deficit, resident - level);
+    }
+
+    std::vector<LoadRequest> sorted;
+    sorted.reserve(candidates.size());
+    for (auto& candidate : candidates) {
+        sorted.push_back(std::move(candidate.second));
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const LoadRequest& a, const LoadRequest& b) { return b < a; });
+
+    const uint32_t maxInFlight = static_cast<uint32_t>(maxLoadRequestsPerFrame_) * 2;
+    for (LoadRequest& request : sorted) {
+        if (loadsInFlight_ >= maxInFlight) break;
+        virtualTextures_[request.textureId]->pendingPages.insert(
+            GetPageKey(request.mipLevel, request.pageX, request.pageY));
+        ++loadsInFlight_;
+        {
+            std::lock_guard<std::mutex> lock(loadQueueMutex_);
+            loadQueue_.push(std::move(request));
+        }
+        loadQueueCondition_.notify_one();
+    }
+}
+
+void TextureStreamingEngine::ApplyPage(const CompletedLoad& load) {
+    auto it = virtualTextures_.find(load.textureId);
+    if (it == virtualTextures_.end()) return;
+
+    VirtualTexture& texture = *it->second;
+    texture.pendingPages.erase(GetPageKey(load.mipLevel, load.pageX, load.pageY));
+    if (!load.staging) {
+        Logger::Warning("Failed to stream a page of mip " + std::to_string(load.mipLevel) + " of " + texture.filePath);
+        return;
+    }
+
+    // With every slot wanted by the last feedback the page is dropped, and asked for again later
+    if (AddPage(load.textureId, texture, load.mipLevel, load.pageX, load.pageY, load.staging, false)) {
+        ++stats_.uploadsThisFrame;
+        stats_.bytesStreamed += GetPageBytes(pageFormat_);
+    }
+}
+
+bool TextureStreamingEngine::AddPage(uint32_t textureId, VirtualTexture& texture, UINT level, UINT x, UINT y,
+                                     ID3D11Texture2D* staging, bool pinned) {
+    const int slot = AllocatePageSlot();
+    if (slot < 0) return false;
+
+    context_->CopySubresourceRegion(pageAtlas_, 0, (slot % pageCacheSize_) * PAGE_SLOT_SIZE,
+                                    (slot / pageCacheSize_) * PAGE_SLOT_SIZE, 0, staging, 0, nullptr);
+
+    PageSlot& page = pageSlots_[slot];
+    page.textureId = textureId;
+    page.key = GetPageKey(level, x, y);
+    page.lastUsedFrame = frameIndex_;
+    page.pinned = pinned;
+    texture.pages[page.key] = static_cast<UINT>(slot);
+    RefreshPageTable(texture, level, x, y);
+    return true;
+}
+
+void TextureStreamingEngine::EvictPage(UINT slot) {
+    PageSlot& page = pageSlots_[slot];
+    auto it = virtualTextures_.find(page.textureId);
+    if (it != virtualTextures_.end()) {
+        VirtualTexture& texture = *it->second;
+        texture.pages.erase(page.key);
+        RefreshPageTable(texture, page.key >> 22, page.key & 2047u, (page.key >> 11) & 2047u);
+    }
+    page = PageSlot();
+    freePageSlots_.push_back(slot);
+    ++stats_.evictionsThisFrame;
+}
+
+int TextureStreamingEngine::AllocatePageSlot() {
+    if (freePageSlots_.empty()) {
+        // The least recently requested page the latest feedback did not ask for
+        int victim = -1;
+        for (UINT slot = 0; slot < pageSlots_.size(); ++slot) {
+            const PageSlot& page = pageSlots_[slot];
+            if (page.pinned || page.lastUsedFrame >= frameIndex_) continue;
+            if (victim < 0 || page.lastUsedFrame < pageSlots_[victim].lastUsedFrame) {
+                victim = static_cast<int>(slot);
+            }
+        }
+        if (victim < 0) return -1;
+        EvictPage(static_cast<UINT>(victim));
+    }
+
+    const UINT slot = freePageSlots_.back();
+    freePageSlots_.pop_back();
+    return static_cast<int>(slot);
+}
+
+void TextureStreamingEngine::RefreshPageTable(VirtualTexture& texture, UINT level, UINT x, UINT y) {
+    // Top down over the page's footprint, so an entry without a page of its own can copy its
+    // parent's, which is already final
+    for (UINT current = level + 1; current-- > 0;) {
+        const UINT shift = level - current;
+        const UINT width = std::max(1u, texture.pagesX >> current);
+        const UINT height = std::max(1u, texture.pagesY >> current);
+        const UINT parentWidth = std::max(1u, texture.pagesX >> (current + 1));
+        const UINT left = x << shift;
+        const UINT top = y << shift;
+        const UINT right = std::min(width, (x + 1) << shift);
+        const UINT bottom = std::min(height, (y + 1) << shift);
+
+        std::vector<uint32_t>& entries = texture.pageTable[current];
+        for (UINT row = top; row < bottom; ++row) {
+            for (UINT column = left; column < right; ++column) {
+                auto page = texture.pages.find(GetPageKey(current, column, row));
+                if (page != texture.pages.end()) {
+                    entries[row * width + column] = GetPageEntry(page->second, pageCacheSize_, current);
+                } else if (current + 1 < texture.levels) {
+                    entries[row * width + column] = texture.pageTable[current + 1][(row >> 1) * parentWidth + (column >> 1)];
+                }
+            }
+        }
+
+        D3D11_BOX& dirty = texture.dirtyRegions[current];
+        if (dirty.right == 0) {
+            dirty = { left, top, 0, right, bottom, 1 };
+        } else {
+            dirty.left = std::min(dirty.left, left);
+            dirty.top = std::min(dirty.top, top);
+            dirty.right = std::max(dirty.right, right);
+            dirty.bottom = std::max(dirty.bottom, bottom);
+        }
+    }
+}
+
+void TextureStreamingEngine::UploadPageTables() {
+    for (auto& entry : virtualTextures_) {
+        VirtualTexture& texture = *entry.second;
+        for (UINT level = 0; level < texture.levels; ++level) {
+            D3D11_BOX& dirty = texture.dirtyRegions[level];
+            if (dirty.right == 0) continue;
+
+            const UINT width = std::max(1u, texture.pagesX >> level);
+            const uint32_t* data = texture.pageTable[level].data() + dirty.top * width + dirty.left;
+            context_->UpdateSubresource(texture.pageTableTexture, level, &dirty, data, width * sizeof(uint32_t), 0);
+            dirty = D3D11_BOX();
+        }
+    }
+}
+
+void TextureStreamingEngine::ReleaseVirtualTexture(uint32_t textureId, VirtualTexture& texture) {
+    // In-flight pages still complete; ApplyPage drops them once the id is gone
+    for (const auto& page : texture.pages) {
+        pageSlots_[page.second] = PageSlot();
+        freePageSlots_.push_back(page.second);
+    }
+    texture.pages.clear();
+    if (virtualIds_[texture.feedbackIndex] == textureId) {
+        virtualIds_[texture.feedbackIndex] = INVALID_TEXTURE;
+    }
+    SafeRelease(texture.constants);
+    SafeRelease(texture.pageTableView);
+    SafeRelease(texture.pageTableTexture);
+}
+
+} // namespace Nexus
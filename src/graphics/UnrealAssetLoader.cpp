@@ -1,4 +1,5 @@
 #include "UnrealTextureLoader.h"
+#include "UnrealPackage.h"
 #include "Logger.h"
 #include <fstream>
 #include <sstream>
@@ -6,14 +7,21 @@
 namespace Nexus {
 
 // Asset loader implementations
-std::unique_ptr<UnrealAssetLoader::UnrealAsset> UnrealAssetLoader::LoadUAsset(const std::string& filename) {
+std::unique_ptr<UnrealAssetLoader::UnrealAsset> UnrealAssetLoader::LoadUAsset(const std::string& filename, JobSystem* jobs) {
     Logger::Info("Loading Unreal Asset: " + filename);
     
     auto asset = std::make_unique<UnrealAsset>();
     asset->filename = filename;
     asset->assetType = "StaticMesh";
     
-    // Create a placeholder mesh
+    UnrealPackage package;
+    if (!package.Open(filename)) {
+        LogWarning("Using placeholder contents for " + filename);
+    } else if (!ParseUAssetFile(package, *asset, jobs)) {
+        LogWarning("Some properties of " + filename + " couldn't be read");
+    }
+    
+    // StaticMesh render data isn't decoded yet, so the geometry is a placeholder
     UnrealMesh mesh;
     mesh.name = "PlaceholderMesh";
     
@@ -45,35 +53,49 @@ std::unique_ptr<UnrealAssetLoader::UnrealAsset> UnrealAssetLoader::LoadUAsset(co
     mesh.boundingBoxMin = {-1.0f, -1.0f, -1.0f};
     mesh.boundingBoxMax = {1.0f, 1.0f, 1.0f};
     
-    // Create a placeholder material
-    UnrealMaterial material;
-    material.name = "PlaceholderMaterial";
-    material.textureSlots["BaseColor"] = "T_Default_BaseColor";
-    material.textureSlots["Normal"] = "T_Default_Normal";
-    material.textureSlots["Roughness"] = "T_Default_Roughness";
-    material.floatParameters["Metallic"] = 0.0f;
-    material.floatParameters["Roughness"] = 0.5f;
-    material.floatParameters["Specular"] = 0.5f;
-    material.colorParameters["BaseColor"] = {0.8f, 0.8f, 0.8f, 1.0f};
+    // Create a placeholder material unless the package defines its own
+    if (asset->materials.empty()) {
+        UnrealMaterial material;
+        material.name = "PlaceholderMaterial";
+        material.textureSlots["BaseColor"] = "T_Default_BaseColor";
+        material.textureSlots["Normal"] = "T_Default_Normal";
+        material.textureSlots["Roughness"] = "T_Default_Roughness";
+        material.floatParameters["Metallic"] = 0.0f;
+        material.floatParameters["Roughness"] = 0.5f;
+        material.floatParameters["Specular"] = 0.5f;
+        material.colorParameters["BaseColor"] = {0.8f, 0.8f, 0.8f, 1.0f};
+        asset->materials.push_back(material);
+    }
     
-    mesh.materials.push_back(material);
+    mesh.materials = asset->materials;
     mesh.materialIndices.resize(mesh.indices.size() / 3, 0);
     
     asset->meshes.push_back(mesh);
-    asset->materials.push_back(material);
     asset->isValid = true;
     
     Logger::Info("Created placeholder Unreal Asset with " + std::to_string(mesh.vertices.size()) + " vertices");
     return asset;
 }
 
-std::unique_ptr<UnrealAssetLoader::UnrealAsset> UnrealAssetLoader::LoadUMap(const std::string& filename) {
+std::unique_ptr<UnrealAssetLoader::UnrealAsset> UnrealAssetLoader::LoadUMap(const std::string& filename, JobSystem* jobs) {
     Logger::Info("Loading Unreal Map: " + filename);
     
     auto asset = std::make_unique<UnrealAsset>();
     asset->filename = filename;
     asset->assetType = "World";
     
+    UnrealPackage package;
+    if (package.Open(filename)) {
+        if (!ParseUAssetFile(package, *asset, jobs)) {
+            LogWarning("Some properties of " + filename + " couldn't be read");
+        }
+        asset->isValid = true;
+        Logger::Info("Loaded Unreal Map with " + std::to_string(asset->instances.size()) + " placed meshes and " +
+                     std::to_string(asset->materials.size()) + " materials");
+        return asset;
+    }
+    LogWarning("Using placeholder contents for " + filename);
+    
     // Create multiple placeholder meshes to represent a level
     for (int i = 0; i < 3; ++i) {
         UnrealMesh mesh;
@@ -337,6 +359,87 @@ std::unique_ptr<UnrealAssetLoader::UnrealAsset> UnrealAssetLoader::LoadDAE(const
     return asset;
 }
 
+bool UnrealAssetLoader::ParseUAssetFile(const UnrealPackage& package, UnrealAsset& asset, JobSystem* jobs) {
+    const std::vector<UnrealPackage::Export>& exports = package.GetExports();
+    const UnrealPackage::Export* mainExport = package.GetMainExport();
+    if (mainExport) {
+        asset.assetType = package.GetName(package.GetClassName(*mainExport));
+    }
+    
+    // Textures are imports: the texture object, whose outer is its package path
+    for (const auto& object : package.GetImports()) {
+        const std::string& className = package.GetName(object.className.index);
+        if (className == "Texture2D" || className == "TextureCube") {
+            asset.textureReferences.push_back(package.GetObjectName(object.outerIndex));
+        }
+    }
+    
+    // Only the exports that convert are decoded, all at once
+    const std::vector<size_t> materials = package.FindExports({"Material", "MaterialInstanceConstant"});
+    const std::vector<size_t> components = package.FindExports({"StaticMeshComponent"});
+    std::vector<size_t> selected = materials;
+    selected.insert(selected.end(), components.begin(), components.end());
+    if (mainExport) {
+        selected.push_back(static_cast<size_t>(mainExport - exports.data()));
+    }
+    std::vector<std::vector<UnrealPackage::Property>> properties;
+    const bool complete = package.ReadExports(selected, properties, jobs);
+    
+    const int32_t twoSidedName = package.FindName("TwoSided");
+    const int32_t blendModeName = package.FindName("BlendMode");
+    const int32_t shadingModelName = package.FindName("ShadingModel");
+    for (size_t i = 0; i < materials.size(); ++i) {
+        UnrealMaterial material;
+        material.name = package.GetName(exports[materials[i]].objectName);
+        if (const auto* twoSided = UnrealPackage::FindProperty(properties[i], twoSidedName)) {
+            material.isTwoSided = twoSided->boolValue;
+        }
+        if (const auto* blendMode = UnrealPackage::FindProperty(properties[i], blendModeName)) {
+            material.isTranslucent = package.ToText(*blendMode).find("Translucent") != std::string::npos;
+        }
+        if (const auto* shadingModel = UnrealPackage::FindProperty(properties[i], shadingModelName)) {
+            material.shaderModel = package.ToText(*shadingModel);
+        }
+        asset.materials.push_back(material);
+    }
+    
+    // Placed meshes keep Unreal's units (centimeters) and axes (Z up)
+    const int32_t staticMeshName = package.FindName("StaticMesh");
+    const int32_t locationName = package.FindName("RelativeLocation");
+    const int32_t rotationName = package.FindName("RelativeRotation");
+    const int32_t scaleName = package.FindName("RelativeScale3D");
+    for (size_t i = 0; i < components.size(); ++i) {
+        const std::vector<UnrealPackage::Property>& componentProperties = properties[materials.size() + i];
+        const auto* staticMesh = UnrealPackage::FindProperty(componentProperties, staticMeshName);
+        if (!staticMesh) continue;
+        
+        UnrealInstance instance;
+        instance.name = package.GetObjectName(exports[components[i]].outerIndex);   // The actor
+        instance.mesh = package.GetObjectName(package.ToObjectIndex(*staticMesh));
+        if (const auto* location = UnrealPackage::FindProperty(componentProperties, locationName)) {
+            package.ToVector(*location, instance.location);
+        }
+        if (const auto* rotation = UnrealPackage::FindProperty(componentProperties, rotationName)) {
+            package.ToVector(*rotation, instance.rotation);
+        }
+        if (const auto* scale = UnrealPackage::FindProperty(componentProperties, scaleName)) {
+            package.ToVector(*scale, instance.scale);
+        }
+        asset.instances.push_back(instance);
+    }
+    
+    if (mainExport) {
+        asset.metadata["Name"] = package.GetName(mainExport->objectName);
+        for (const auto& property : properties.back()) {
+            std::string value = package.ToText(property);
+            if (!value.empty()) {
+                asset.metadata[package.GetName(property.name)] = value;
+            }
+        }
+    }
+    return complete;
+}
+
 // Validation functions
 bool UnrealAssetLoader::ValidateAsset(const UnrealAsset& asset) {
     if (asset.filename.empty()) {
@@ -0,0 +1,680 @@
+#include "UnrealPackage.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+// Only the zlib decoder is used, for compressed bulk data
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_NO_STDIO
+#include <stb/stb_image.h>
+
+namespace Nexus {
+
+namespace {
+
+constexpr uint32_t PACKAGE_FILE_TAG = 0x9E2A83C1;
+constexpr uint32_t PKG_UNVERSIONED_PROPERTIES = 0x00002000;
+constexpr uint32_t PKG_FILTER_EDITOR_ONLY = 0x80000000;
+
+// EUnrealEngineObjectUE4Version / UE5Version values the layouts below depend on
+constexpr int32_t UE4_NAME_HASHES_SERIALIZED = 504;         // Oldest supported
+constexpr int32_t UE4_PRELOAD_DEPENDENCIES_IN_COOKED_EXPORTS = 507;
+constexpr int32_t UE4_TEMPLATE_INDEX_IN_COOKED_EXPORTS = 508;
+constexpr int32_t UE4_PROPERTY_TAG_SET_MAP_SUPPORT = 509;
+constexpr int32_t UE4_ADDED_SEARCHABLE_NAMES = 510;
+constexpr int32_t UE4_64BIT_EXPORTMAP_SERIALSIZES = 511;
+constexpr int32_t UE4_ADDED_PACKAGE_SUMMARY_LOCALIZATION_ID = 516;
+constexpr int32_t UE4_ADDED_PACKAGE_OWNER = 518;
+constexpr int32_t UE4_NON_OUTER_PACKAGE_IMPORT = 520;
+constexpr int32_t UE5_OPTIONAL_RESOURCES = 1003;
+constexpr int32_t UE5_LARGE_WORLD_COORDINATES = 1004;
+constexpr int32_t UE5_REMOVE_OBJECT_EXPORT_PACKAGE_GUID = 1005;
+constexpr int32_t UE5_TRACK_OBJECT_EXPORT_IS_INHERITED = 1006;
+constexpr int32_t UE5_ADD_SOFTOBJECTPATH_LIST = 1008;
+constexpr int32_t UE5_SCRIPT_SERIALIZATION_OFFSET = 1010;
+constexpr int32_t UE5_PROPERTY_TAG_EXTENSION = 1011;
+constexpr int32_t UE5_PROPERTY_TAG_COMPLETE_TYPE_NAME = 1012;   // Not supported
+constexpr int32_t UE5_METADATA_SERIALIZATION_OFFSET = 1014;
+constexpr int32_t UE5_VERSE_CELLS = 1015;
+
+// EBulkDataFlags
+constexpr uint32_t BULKDATA_PAYLOAD_AT_END_OF_FILE = 0x0001;
+constexpr uint32_t BULKDATA_SERIALIZE_COMPRESSED_ZLIB = 0x0002;
+constexpr uint32_t BULKDATA_UNUSED = 0x0020;
+constexpr uint32_t BULKDATA_PAYLOAD_IN_SEPARATE_FILE = 0x0100;
+constexpr uint32_t BULKDATA_SIZE_64BIT = 0x2000;
+constexpr uint32_t BULKDATA_NO_OFFSET_FIXUP = 0x10000;
+
+// Little endian cursor over the mapping; every read is bounds checked and a failed one sticks
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : data_(data), size_(size), offset_(0), ok_(true) {}
+
+    template <typename T>
+    T Read() {
+        T value{};
+        if (!Require(sizeof(T))) return value;
+        std::memcpy(&value, data_ + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return value;
+    }
+
+    void Skip(size_t bytes) {
+        if (Require(bytes)) offset_ += bytes;
+    }
+
+    UnrealName ReadName() {
+        UnrealName name;
+        name.index = Read<int32_t>();
+        name.number = Read<int32_t>();
+        return name;
+    }
+
+    // FString: a length with the terminator, negative for UTF-16, which keeps only the low bytes
+    std::string ReadString() {
+        const int32_t length = Read<int32_t>();
+        if (length == 0) return std::string();
+        const bool wide = length < 0;
+        const size_t count = static_cast<size_t>(wide ? -static_cast<int64_t>(length) : length);
+        if (count > size_ || !Require(count * (wide ? 2 : 1))) {
+            ok_ = false;
+            return std::string();
+        }
+        std::string text(count - 1, '\0');
+        for (size_t i = 0; i + 1 < count; ++i) text[i] = static_cast<char>(data_[offset_ + (wide ? i * 2 : i)]);
+        offset_ += count * (wide ? 2 : 1);
+        return text;
+    }
+
+    void Seek(size_t offset) {
+        if (offset > size_) ok_ = false;
+        else offset_ = offset;
+    }
+
+    size_t GetOffset() const { return offset_; }
+    const uint8_t* GetPointer() const { return data_ + offset_; }
+    bool IsOk() const { return ok_; }
+
+private:
+    bool Require(size_t bytes) {
+        if (!ok_ || bytes > size_ - offset_) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;
+    bool ok_;
+};
+
+void SkipEngineVersion(ByteReader& reader) {
+    reader.Skip(3 * sizeof(uint16_t) + sizeof(uint32_t));
+    reader.ReadString();
+}
+
+// FArchive::SerializeCompressed: a tag, the total sizes, then one size pair per independently
+// compressed chunk and the chunks back to back
+bool DecompressChunkedZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& out, JobSystem* jobs) {
+    ByteReader reader(data, size);
+    const int64_t tag = reader.Read<int64_t>();
+    const int64_t chunkSize = reader.Read<int64_t>();
+    reader.Read<int64_t>();
+    const int64_t totalSize = reader.Read<int64_t>();
+    if (!reader.IsOk() || static_cast<uint32_t>(tag) != PACKAGE_FILE_TAG || chunkSize <= 0 || totalSize < 0) {
+        return false;
+    }
+
+    struct Chunk {
+        size_t source, sourceSize, target, targetSize;
+    };
+    const size_t chunkCount = static_cast<size_t>((totalSize + chunkSize - 1) / chunkSize);
+    if (chunkCount > size / 16) return false;
+    std::vector<Chunk> chunks(chunkCount);
+    size_t target = 0;
+    for (Chunk& chunk : chunks) {
+        chunk.sourceSize = static_cast<size_t>(reader.Read<int64_t>());
+        chunk.targetSize = static_cast<size_t>(reader.Read<int64_t>());
+        chunk.target = target;
+        target += chunk.targetSize;
+    }
+    size_t source = reader.GetOffset();
+    for (Chunk& chunk : chunks) {
+        chunk.source = source;
+        source += chunk.sourceSize;
+    }
+    if (!reader.IsOk() || source > size || target != static_cast<size_t>(totalSize)) return false;
+
+    out.resize(target);
+    std::vector<uint8_t> failed(chunkCount, 0);
+    auto inflate = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Chunk& chunk = chunks[i];
+            const int written = stbi_zlib_decode_buffer(reinterpret_cast<char*>(out.data() + chunk.target),
+                                                        static_cast<int>(chunk.targetSize),
+                                                        reinterpret_cast<const char*>(data + chunk.source),
+                                                        static_cast<int>(chunk.sourceSize));
+            failed[i] = written != static_cast<int>(chunk.targetSize);
+        }
+    };
+    if (jobs) jobs->ParallelFor(chunkCount, 1, inflate);
+    else inflate(0, chunkCount);
+    return std::find(failed.begin(), failed.end(), 1) == failed.end();
+}
+
+}
+
+bool UnrealPackage::Open(const std::string& filename) {
+    Close();
+    if (!file_.Open(filename)) {
+        Logger::Error("UnrealPackage: Failed to open " + filename);
+        return false;
+    }
+    filename_ = filename;
+    if (!ReadSummary() || !ReadTables()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void UnrealPackage::Close() {
+    file_.Close();
+    filename_.clear();
+    names_.clear();
+    nameIndices_.clear();
+    imports_.clear();
+    exports_.clear();
+    noneName_ = -1;
+    structType_ = boolType_ = byteType_ = enumType_ = -1;
+    arrayType_ = setType_ = mapType_ = -1;
+}
+
+bool UnrealPackage::ReadSummary() {
+    ByteReader reader(file_.GetData(), file_.GetSize());
+    if (reader.Read<uint32_t>() != PACKAGE_FILE_TAG) {
+        Logger::Error("UnrealPackage: Not an Unreal package: " + filename_);
+        return false;
+    }
+
+    // -6 to -8 cover 4.16 to 5.3; -9 moved fields around for the saved hash
+    legacyFileVersion_ = reader.Read<int32_t>();
+    if (legacyFileVersion_ > -6 || legacyFileVersion_ < -8) {
+        Logger::Error("UnrealPackage: Unsupported package version " + std::to_string(legacyFileVersion_) + ": " + filename_);
+        return false;
+    }
+    reader.Read<int32_t>();                                 // LegacyUE3Version
+    fileVersionUE4_ = reader.Read<int32_t>();
+    fileVersionUE5_ = legacyFileVersion_ <= -8 ? reader.Read<int32_t>() : 0;
+    reader.Read<int32_t>();                                 // FileVersionLicenseeUE4
+    if (fileVersionUE4_ < UE4_NAME_HASHES_SERIALIZED) {
+        // Zero is a cooked package saved unversioned, which can't be read without the engine's version
+        Logger::Error("UnrealPackage: Package is unversioned or older than 4.16: " + filename_);
+        return false;
+    }
+
+    const int32_t customVersionCount = reader.Read<int32_t>();
+    if (customVersionCount < 0) return false;
+    reader.Skip(static_cast<size_t>(customVersionCount) * 20);
+    reader.Read<int32_t>();                                 // TotalHeaderSize
+    reader.ReadString();                                    // PackageName
+    packageFlags_ = reader.Read<uint32_t>();
+    const bool editorOnlyFiltered = (packageFlags_ & PKG_FILTER_EDITOR_ONLY) != 0;
+    nameCount_ = reader.Read<int32_t>();
+    nameOffset_ = reader.Read<int32_t>();
+    if (fileVersionUE5_ >= UE5_ADD_SOFTOBJECTPATH_LIST) reader.Skip(2 * sizeof(int32_t));
+    if (!editorOnlyFiltered && fileVersionUE4_ >= UE4_ADDED_PACKAGE_SUMMARY_LOCALIZATION_ID) reader.ReadString();
+    reader.Skip(2 * sizeof(int32_t));                       // GatherableTextData
+    exportCount_ = reader.Read<int32_t>();
+    exportOffset_ = reader.Read<int32_t>();
+    importCount_ = reader.Read<int32_t>();
+    importOffset_ = reader.Read<int32_t>();
+    if (!reader.IsOk()) {
+        Logger::Error("UnrealPackage: Truncated summary: " + filename_);
+        return false;
+    }
+
+    // The rest is only needed for where end of file bulk data starts
+    if (fileVersionUE5_ >= UE5_VERSE_CELLS) reader.Skip(4 * sizeof(int32_t));
+    if (fileVersionUE5_ >= UE5_METADATA_SERIALIZATION_OFFSET) reader.Skip(sizeof(int32_t));
+    reader.Skip(3 * sizeof(int32_t));                       // Depends, SoftPackageReferences
+    if (fileVersionUE4_ >= UE4_ADDED_SEARCHABLE_NAMES) reader.Skip(sizeof(int32_t));
+    reader.Skip(sizeof(int32_t) + 16);                      // ThumbnailTable, Guid
+    if (!editorOnlyFiltered && fileVersionUE4_ >= UE4_ADDED_PACKAGE_OWNER) {
+        reader.Skip(fileVersionUE4_ < UE4_NON_OUTER_PACKAGE_IMPORT ? 32 : 16);
+    }
+    const int32_t generationCount = reader.Read<int32_t>();
+    if (generationCount >= 0) reader.Skip(static_cast<size_t>(generationCount) * 2 * sizeof(int32_t));
+    SkipEngineVersion(reader);                              // SavedByEngineVersion
+    SkipEngineVersion(reader);                              // CompatibleWithEngineVersion
+    reader.Read<uint32_t>();                                // CompressionFlags
+    const int32_t compressedChunks = reader.Read<int32_t>();
+    reader.Read<uint32_t>();                                // PackageSource
+    const int32_t packagesToCook = reader.Read<int32_t>();
+    for (int32_t i = 0; i < packagesToCook && reader.IsOk(); ++i) reader.ReadString();
+    if (legacyFileVersion_ > -7) reader.Read<int32_t>();    // NumTextureAllocations
+    reader.Read<int32_t>();                                 // AssetRegistryDataOffset
+    bulkDataStartOffset_ = reader.Read<int64_t>();
+    if (!reader.IsOk() || compressedChunks != 0) {
+        Logger::Warning("UnrealPackage: Can't locate bulk data in " + filename_);
+        bulkDataStartOffset_ = -1;
+    }
+    return true;
+}
+
+bool UnrealPackage::ReadTables() {
+    const size_t fileSize = file_.GetSize();
+    if (nameCount_ < 0 || importCount_ < 0 || exportCount_ < 0 || static_cast<size_t>(nameCount_) > fileSize ||
+        static_cast<size_t>(importCount_) > fileSize || static_cast<size_t>(exportCount_) > fileSize) {
+        Logger::Error("UnrealPackage: Corrupt table counts: " + filename_);
+        return false;
+    }
+    ByteReader reader(file_.GetData(), fileSize);
+    const bool editorOnlyFiltered = (packageFlags_ & PKG_FILTER_EDITOR_ONLY) != 0;
+
+    reader.Seek(static_cast<size_t>(nameOffset_));
+    names_.resize(static_cast<size_t>(nameCount_));
+    nameIndices_.reserve(names_.size());
+    for (int32_t i = 0; i < nameCount_ && reader.IsOk(); ++i) {
+        names_[i] = reader.ReadString();
+        reader.Skip(2 * sizeof(uint16_t));                  // Case preserving and insensitive hashes
+        nameIndices_.emplace(names_[i], i);
+    }
+    noneName_ = FindName("None");
+    structType_ = FindName("StructProperty");
+    boolType_ = FindName("BoolProperty");
+    byteType_ = FindName("ByteProperty");
+    enumType_ = FindName("EnumProperty");
+    arrayType_ = FindName("ArrayProperty");
+    setType_ = FindName("SetProperty");
+    mapType_ = FindName("MapProperty");
+
+    reader.Seek(static_cast<size_t>(importOffset_));
+    imports_.resize(static_cast<size_t>(importCount_));
+    for (Import& object : imports_) {
+        object.classPackage = reader.ReadName();
+        object.className = reader.ReadName();
+        object.outerIndex = reader.Read<int32_t>();
+        object.objectName = reader.ReadName();
+        if (!editorOnlyFiltered && fileVersionUE4_ >= UE4_NON_OUTER_PACKAGE_IMPORT) reader.ReadName();
+        if (fileVersionUE5_ >= UE5_OPTIONAL_RESOURCES) reader.Read<int32_t>();
+    }
+
+    reader.Seek(static_cast<size_t>(exportOffset_));
+    exports_.resize(static_cast<size_t>(exportCount_));
+    for (Export& object : exports_) {
+        object.classIndex = reader.Read<int32_t>();
+        object.superIndex = reader.Read<int32_t>();
+        if (fileVersionUE4_ >= UE4_TEMPLATE_INDEX_IN_COOKED_EXPORTS) reader.Read<int32_t>();
+        object.outerIndex = reader.Read<int32_t>();
+        object.objectName = reader.ReadName();
+        object.objectFlags = reader.Read<uint32_t>();
+        if (fileVersionUE4_ >= UE4_64BIT_EXPORTMAP_SERIALSIZES) {
+            object.serialSize = reader.Read<int64_t>();
+            object.serialOffset = reader.Read<int64_t>();
+        } else {
+            object.serialSize = reader.Read<int32_t>();
+            object.serialOffset = reader.Read<int32_t>();
+        }
+        reader.Skip(3 * sizeof(int32_t));                   // Forced export, not for client, not for server
+        if (fileVersionUE5_ < UE5_REMOVE_OBJECT_EXPORT_PACKAGE_GUID) reader.Skip(16);
+        if (fileVersionUE5_ >= UE5_TRACK_OBJECT_EXPORT_IS_INHERITED) reader.Skip(sizeof(int32_t));
+        reader.Skip(3 * sizeof(int32_t));                   // Package flags, not always loaded, is asset
+        if (fileVersionUE5_ >= UE5_OPTIONAL_RESOURCES) reader.Skip(sizeof(int32_t));
+        if (fileVersionUE4_ >= UE4_PRELOAD_DEPENDENCIES_IN_COOKED_EXPORTS) reader.Skip(5 * sizeof(int32_t));
+        if (fileVersionUE5_ >= UE5_SCRIPT_SERIALIZATION_OFFSET) {
+            object.scriptStart = reader.Read<int64_t>();
+            object.scriptEnd = reader.Read<int64_t>();
+        }
+        if (object.serialOffset < 0 || object.serialSize < 0 ||
+            static_cast<uint64_t>(object.serialOffset) + static_cast<uint64_t>(object.serialSize) > fileSize) {
+            Logger::Error("UnrealPackage: Export outside the file: " + filename_);
+            return false;
+        }
+    }
+
+    if (!reader.IsOk()) {
+        Logger::Error("UnrealPackage: Truncated tables: " + filename_);
+        return false;
+    }
+    return true;
+}
+
+int32_t UnrealPackage::FindName(std::string_view name) const {
+    auto it = nameIndices_.find(std::string(name));
+    return it != nameIndices_.end() ? it->second : -1;
+}
+
+const std::string& UnrealPackage::GetName(int32_t index) const {
+    static const std::string none = "None";
+    return index >= 0 && index < static_cast<int32_t>(names_.size()) ? names_[index] : none;
+}
+
+std::string UnrealPackage::GetName(const UnrealName& name) const {
+    if (name.number <= 0) return GetName(name.index);
+    return GetName(name.index) + "_" + std::to_string(name.number - 1);
+}
+
+std::string UnrealPackage::GetObjectName(int32_t packageIndex) const {
+    if (packageIndex > 0 && packageIndex <= static_cast<int32_t>(exports_.size())) {
+        return GetName(exports_[packageIndex - 1].objectName);
+    }
+    if (packageIndex < 0 && -static_cast<int64_t>(packageIndex) <= static_cast<int64_t>(imports_.size())) {
+        return GetName(imports_[-packageIndex - 1].objectName);
+    }
+    return "None";
+}
+
+int32_t UnrealPackage::GetClassName(const Export& object) const {
+    if (object.classIndex < 0 && -static_cast<int64_t>(object.classIndex) <= static_cast<int64_t>(imports_.size())) {
+        return imports_[-object.classIndex - 1].objectName.index;
+    }
+    if (object.classIndex > 0 && object.classIndex <= static_cast<int32_t>(exports_.size())) {
+        return exports_[object.classIndex - 1].objectName.index;   // A class defined in this package
+    }
+    return -1;
+}
+
+std::vector<size_t> UnrealPackage::FindExports(const std::vector<std::string>& classNames) const {
+    std::vector<int32_t> classes;
+    for (const std::string& name : classNames) {
+        const int32_t index = FindName(name);
+        if (index >= 0) classes.push_back(index);
+    }
+    std::vector<size_t> found;
+    if (classes.empty()) return found;
+    for (size_t i = 0; i < exports_.size(); ++i) {
+        if (std::find(classes.begin(), classes.end(), GetClassName(exports_[i])) != classes.end()) found.push_back(i);
+    }
+    return found;
+}
+
+const UnrealPackage::Export* UnrealPackage::GetMainExport() const {
+    for (const Export& object : exports_) {
+        if (object.outerIndex == 0) return &object;
+    }
+    return nullptr;
+}
+
+const uint8_t* UnrealPackage::GetExportData(size_t exportIndex, size_t& size) const {
+    size = 0;
+    if (exportIndex >= exports_.size()) return nullptr;
+    size = static_cast<size_t>(exports_[exportIndex].serialSize);
+    return file_.GetData() + exports_[exportIndex].serialOffset;
+}
+
+bool UnrealPackage::ReadProperties(size_t exportIndex, std::vector<Property>& properties, size_t* nativeOffset) const {
+    properties.clear();
+    if (exportIndex >= exports_.size()) return false;
+    const Export& object = exports_[exportIndex];
+    size_t size;
+    const uint8_t* data = GetExportData(exportIndex, size);
+    if (object.scriptEnd >= 0) size = std::min(size, static_cast<size_t>(object.scriptEnd));
+    if (ReadTags(data, size, static_cast<size_t>(std::max<int64_t>(object.scriptStart, 0)), properties, nativeOffset)) {
+        return true;
+    }
+    Logger::Error("UnrealPackage: Can't read the properties of " + GetName(object.objectName) + " in " + filename_);
+    return false;
+}
+
+bool UnrealPackage::ReadStructProperties(const Property& property, std::vector<Property>& properties) const {
+    properties.clear();
+    return property.type == structType_ && ReadTags(property.data, property.size, 0, properties, nullptr);
+}
+
+bool UnrealPackage::ReadTags(const uint8_t* data, size_t size, size_t start, std::vector<Property>& properties,
+                             size_t* end) const {
+    if ((packageFlags_ & PKG_UNVERSIONED_PROPERTIES) || fileVersionUE5_ >= UE5_PROPERTY_TAG_COMPLETE_TYPE_NAME) {
+        return false;
+    }
+
+    ByteReader reader(data, size);
+    reader.Seek(start);
+    const bool containerTags = fileVersionUE4_ >= UE4_PROPERTY_TAG_SET_MAP_SUPPORT;
+    while (reader.IsOk()) {
+        Property property;
+        property.name = reader.ReadName();
+        if (!reader.IsOk()) break;
+        if (property.name.index == noneName_) {
+            if (end) *end = reader.GetOffset();
+            return true;
+        }
+
+        property.type = reader.ReadName().index;
+        property.size = reader.Read<uint32_t>();
+        property.arrayIndex = reader.Read<int32_t>();
+        if (property.type == structType_) {
+            property.structName = reader.ReadName().index;
+            reader.Skip(16);                                // Struct guid
+        } else if (property.type == boolType_) {
+            property.boolValue = reader.Read<uint8_t>() != 0;
+        } else if (property.type == byteType_ || property.type == enumType_ || property.type == arrayType_) {
+            property.structName = reader.ReadName().index;
+        } else if (containerTags && (property.type == setType_ || property.type == mapType_)) {
+            property.structName = reader.ReadName().index;
+            if (property.type == mapType_) property.valueType = reader.ReadName().index;
+        }
+        if (reader.Read<uint8_t>() != 0) reader.Skip(16);   // Property guid
+        if (fileVersionUE5_ >= UE5_PROPERTY_TAG_EXTENSION && (reader.Read<uint8_t>() & 0x02)) {
+            reader.Read<uint8_t>();                         // Overridable operation
+        }
+
+        property.data = reader.GetPointer();
+        reader.Skip(property.size);
+        if (reader.IsOk()) properties.push_back(property);
+    }
+    properties.clear();
+    return false;
+}
+
+bool UnrealPackage::ReadExports(const std::vector<size_t>& exportIndices, std::vector<std::vector<Property>>& properties,
+                                JobSystem* jobs) const {
+    NEXUS_PROFILE_SCOPE("UnrealPackage::ReadExports");
+    properties.assign(exportIndices.size(), std::vector<Property>());
+    std::vector<uint8_t> failed(exportIndices.size(), 0);
+    auto read = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) failed[i] = !ReadProperties(exportIndices[i], properties[i]);
+    };
+    if (jobs) jobs->ParallelFor(exportIndices.size(), 16, read);
+    else read(0, exportIndices.size());
+    return std::find(failed.begin(), failed.end(), 1) == failed.end();
+}
+
+const UnrealPackage::Property* UnrealPackage::FindProperty(const std::vector<Property>& properties, int32_t name) {
+    for (const Property& property : properties) {
+        if (property.name.index == name) return &property;
+    }
+    return nullptr;
+}
+
+std::string UnrealPackage::ToText(const Property& property) const {
+    const std::string& type = GetName(property.type);
+    ByteReader reader(property.data, property.size);
+    std::string text;
+    if (type == "BoolProperty") {
+        text = property.boolValue ? "true" : "false";
+    } else if (type == "IntProperty") {
+        text = std::to_string(reader.Read<int32_t>());
+    } else if (type == "Int64Property") {
+        text = std::to_string(reader.Read<int64_t>());
+    } else if (type == "UInt32Property") {
+        text = std::to_string(reader.Read<uint32_t>());
+    } else if (type == "FloatProperty") {
+        text = std::to_string(reader.Read<float>());
+    } else if (type == "DoubleProperty") {
+        text = std::to_string(reader.Read<double>());
+    } else if (type == "NameProperty" || type == "EnumProperty") {
+        text = GetName(reader.ReadName());
+    } else if (type == "ByteProperty") {
+        text = property.size == 1 ? std::to_string(reader.Read<uint8_t>()) : GetName(reader.ReadName());
+    } else if (type == "StrProperty") {
+        text = reader.ReadString();
+    } else if (type == "ObjectProperty" || type == "ClassProperty" || type == "InterfaceProperty") {
+        text = GetObjectName(reader.Read<int32_t>());
+    } else if (type == "SoftObjectProperty") {
+        text = GetName(reader.ReadName());                  // The package path
+    } else if (type == "StructProperty") {
+        DirectX::XMFLOAT3 vector;
+        if (ToVector(property, vector)) {
+            text = std::to_string(vector.x) + " " + std::to_string(vector.y) + " " + std::to_string(vector.z);
+        }
+    }
+    return reader.IsOk() ? text : std::string();
+}
+
+bool UnrealPackage::ToVector(const Property& property, DirectX::XMFLOAT3& value) const {
+    const std::string& structName = GetName(property.structName);
+    if (structName != "Vector" && structName != "Rotator" && structName != "LinearColor") return false;
+
+    // Vector and Rotator became doubles with large world coordinates
+    ByteReader reader(property.data, property.size);
+    if (structName != "LinearColor" && fileVersionUE5_ >= UE5_LARGE_WORLD_COORDINATES) {
+        value.x = static_cast<float>(reader.Read<double>());
+        value.y = static_cast<float>(reader.Read<double>());
+        value.z = static_cast<float>(reader.Read<double>());
+    } else {
+        value.x = reader.Read<float>();
+        value.y = reader.Read<float>();
+        value.z = reader.Read<float>();
+    }
+    return reader.IsOk();
+}
+
+int64_t UnrealPackage::ToInt(const Property& property, int64_t fallback) const {
+    ByteReader reader(property.data, property.size);
+    int64_t value = fallback;
+    switch (property.size) {
+        case 1: value = GetName(property.type) == "Int8Property" ? reader.Read<int8_t>() : reader.Read<uint8_t>(); break;
+        case 2: value = reader.Read<int16_t>(); break;
+        case 4: value = GetName(property.type) == "UInt32Property" ? reader.Read<uint32_t>() : reader.Read<int32_t>(); break;
+        case 8: value = reader.Read<int64_t>(); break;
+        default: break;
+    }
+    return value;
+}
+
+int32_t UnrealPackage::ToObjectIndex(const Property& property) const {
+    if (property.size < sizeof(int32_t)) return 0;
+    int32_t index;
+    std::memcpy(&index, property.data, sizeof(index));
+    return index;
+}
+
+const uint8_t* UnrealPackage::ReadBulkData(const uint8_t* header, size_t available, std::vector<uint8_t>& buffer,
+                                           size_t& size, JobSystem* jobs) const {
+    size = 0;
+    ByteReader reader(header, available);
+    const uint32_t flags = reader.Read<uint32_t>();
+    const bool wide = (flags & BULKDATA_SIZE_64BIT) != 0;
+    const int64_t elementCount = wide ? reader.Read<int64_t>() : reader.Read<int32_t>();
+    const int64_t sizeOnDisk = wide ? reader.Read<int64_t>() : reader.Read<int32_t>();
+    int64_t offset = reader.Read<int64_t>();
+    if (!reader.IsOk() || (flags & BULKDATA_UNUSED) || elementCount <= 0 || sizeOnDisk < 0) return nullptr;
+    if (flags & BULKDATA_PAYLOAD_IN_SEPARATE_FILE) {
+        Logger::Warning("UnrealPackage: Bulk data in a separate file isn't supported: " + filename_);
+        return nullptr;
+    }
+
+    const uint8_t* payload;
+    if (flags & BULKDATA_PAYLOAD_AT_END_OF_FILE) {
+        if (!(flags & BULKDATA_NO_OFFSET_FIXUP)) {
+            if (bulkDataStartOffset_ < 0) return nullptr;
+            offset += bulkDataStartOffset_;
+        }
+        if (offset < 0 || static_cast<uint64_t>(offset) + static_cast<uint64_t>(sizeOnDisk) > file_.GetSize()) return nullptr;
+        payload = file_.GetData() + offset;
+    } else {
+        if (static_cast<uint64_t>(sizeOnDisk) > available - reader.GetOffset()) return nullptr;
+        payload = reader.GetPointer();
+    }
+
+    if (!(flags & BULKDATA_SERIALIZE_COMPRESSED_ZLIB)) {
+        size = static_cast<size_t>(sizeOnDisk);
+        return payload;
+    }
+    NEXUS_PROFILE_SCOPE("UnrealPackage::DecompressBulkData");
+    if (!DecompressChunkedZlib(payload, static_cast<size_t>(sizeOnDisk), buffer, jobs)) {
+        Logger::Error("UnrealPackage: Corrupt compressed bulk data in " + filename_);
+        return nullptr;
+    }
+    size = buffer.size();
+    return buffer.data();
+}
+
+bool UnrealPackage::ReadTextureSource(size_t exportIndex, std::vector<uint8_t>& rgba, int& width, int& height,
+                                      JobSystem* jobs) const {
+    if (fileVersionUE5_ > 0 || (packageFlags_ & PKG_FILTER_EDITOR_ONLY)) return false;
+
+    std::vector<Property> properties, source;
+    size_t nativeOffset = 0;
+    if (!ReadProperties(exportIndex, properties, &nativeOffset)) return false;
+    const Property* sourceProperty = FindProperty(properties, FindName("Source"));
+    if (!sourceProperty || !ReadStructProperties(*sourceProperty, source)) return false;
+
+    auto get = [&](const char* name) { return FindProperty(source, FindName(name)); };
+    const Property* sizeX = get("SizeX");
+    const Property* sizeY = get("SizeY");
+    const Property* format = get("Format");
+    const Property* png = get("bPNGCompressed");
+    if (!sizeX || !sizeY || !format) return false;
+    width = static_cast<int>(ToInt(*sizeX));
+    height = static_cast<int>(ToInt(*sizeY));
+    std::string formatName = ToText(*format);
+    formatName = formatName.substr(formatName.rfind(':') == std::string::npos ? 0 : formatName.rfind(':') + 1);
+    if (width <= 0 || height <= 0 || width > 16384 || height > 16384) return false;
+
+    // The pixels are bulk data after UObject's guid and UTexture's strip flags
+    size_t exportSize;
+    const uint8_t* exportData = GetExportData(exportIndex, exportSize);
+    ByteReader reader(exportData, exportSize);
+    reader.Seek(nativeOffset);
+    if (reader.Read<int32_t>() != 0) reader.Skip(16);
+    const uint8_t globalStripFlags = reader.Read<uint8_t>();
+    reader.Read<uint8_t>();
+    if (!reader.IsOk() || (globalStripFlags & 1)) return false;   // Editor data stripped
+
+    std::vector<uint8_t> buffer;
+    size_t size;
+    const uint8_t* pixels = ReadBulkData(reader.GetPointer(), exportSize - reader.GetOffset(), buffer, size, jobs);
+    if (!pixels) return false;
+
+    const size_t pixelCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+    if (png && png->boolValue) {
+        int pngWidth, pngHeight, channels;
+        stbi_uc* decoded = stbi_load_from_memory(pixels, static_cast<int>(size), &pngWidth, &pngHeight, &channels, 4);
+        if (!decoded) return false;
+        width = pngWidth;
+        height = pngHeight;
+        rgba.assign(decoded, decoded + static_cast<size_t>(pngWidth) * static_cast<size_t>(pngHeight) * 4);
+        stbi_image_free(decoded);
+        return true;
+    }
+    if (formatName == "TSF_BGRA8" && size >= pixelCount * 4) {
+        rgba.resize(pixelCount * 4);
+        for (size_t i = 0; i < pixelCount; ++i) {
+            rgba[i * 4 + 0] = pixels[i * 4 + 2];
+            rgba[i * 4 + 1] = pixels[i * 4 + 1];
+            rgba[i * 4 + 2] = pixels[i * 4 + 0];
+            rgba[i * 4 + 3] = pixels[i * 4 + 3];
+        }
+        return true;
+    }
+    if (formatName == "TSF_G8" && size >= pixelCount) {
+        rgba.resize(pixelCount * 4);
+        for (size_t i = 0; i < pixelCount; ++i) {
+            rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = pixels[i];
+            rgba[i * 4 + 3] = 255;
+        }
+        return true;
+    }
+    Logger::Warning("UnrealPackage: Texture source format " + formatName + " isn't supported: " + filename_);
+    return false;
+}
+
+} // namespace Nexus
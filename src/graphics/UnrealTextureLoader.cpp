@@ -1,9 +1,13 @@
 #include "UnrealTextureLoader.h"
 #include "Logger.h"
+#include "BlockDecompressor.h"
+#include "MipGenerator.h"
+#include "UnrealPackage.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 
 // Placeholder for STB image - we'll implement basic loading without it for now
@@ -499,22 +503,60 @@ std::unique_ptr<TextureData> UnrealTextureLoader::LoadEXR(const std::string& fil
     return texture;
 }
 
-std::unique_ptr<TextureData> UnrealTextureLoader::LoadUasset(const std::string& filename) {
+std::unique_ptr<TextureData> UnrealTextureLoader::LoadUasset(const std::string& filename, JobSystem* jobs) {
     LogInfo("Loading Unreal Asset (.uasset): " + filename);
     
-    std::vector<uint8_t> fileData = ReadFile(filename);
-    if (fileData.empty()) {
+    UnrealPackage package;
+    if (!package.Open(filename)) {
+        return nullptr;
+    }
+    return ExtractTextureFromUAsset(package, jobs);
+}
+
+std::unique_ptr<TextureData> UnrealTextureLoader::ExtractTextureFromUAsset(const UnrealPackage& package, JobSystem* jobs) {
+    std::vector<size_t> textures = package.FindExports({"Texture2D"});
+    if (textures.empty()) {
+        LogError("No Texture2D in " + package.GetFilename());
         return nullptr;
     }
     
-    // For now, create a placeholder with Unreal Engine colors
     auto texture = std::make_unique<TextureData>();
+    texture->metadata.originalFilename = package.GetFilename();
+    texture->metadata.compressionSettings = "TC_Default";
+    texture->metadata.textureGroup = "TEXTUREGROUP_World";
+    texture->metadata.isSRGB = true;
+    
+    // Enum values are read without their "Enum::" prefix
+    std::map<std::string, std::string> properties = ParseUAssetProperties(package, textures.front());
+    auto value = [&](const char* name) -> std::string {
+        auto it = properties.find(name);
+        if (it == properties.end()) return std::string();
+        size_t scope = it->second.rfind("::");
+        return scope == std::string::npos ? it->second : it->second.substr(scope + 2);
+    };
+    if (!value("CompressionSettings").empty()) texture->metadata.compressionSettings = value("CompressionSettings");
+    if (!value("LODGroup").empty()) texture->metadata.textureGroup = value("LODGroup");
+    if (!value("SRGB").empty()) texture->metadata.isSRGB = value("SRGB") == "true";
+    if (!value("LODBias").empty()) texture->metadata.lodBias = static_cast<float>(std::atoi(value("LODBias").c_str()));
+    if (!value("MaxTextureSize").empty()) texture->metadata.maxTextureSize = std::atoi(value("MaxTextureSize").c_str());
+    texture->metadata.padToPowerOfTwo = value("PowerOfTwoMode") == "PadToPowerOfTwo";
+    
+    int width = 0;
+    int height = 0;
+    if (package.ReadTextureSource(textures.front(), texture->data, width, height, jobs)) {
+        texture->metadata.width = width;
+        texture->metadata.height = height;
+        texture->metadata.format = texture->metadata.isSRGB ? TextureFormat::R8G8B8A8_SRGB : TextureFormat::R8G8B8A8_UNORM;
+        texture->metadata.hasAlpha = true;
+        LogInfo("Loaded Unreal texture source: " + std::to_string(width) + "x" + std::to_string(height));
+        return texture;
+    }
+    
+    // Cooked and UE5 textures carry no source we can read; fall back to a placeholder
+    LogWarning("No readable source art in " + package.GetFilename() + ", using a placeholder");
     texture->metadata.width = 512;
     texture->metadata.height = 512;
     texture->metadata.format = TextureFormat::DXT5;
-    texture->metadata.originalFilename = filename;
-    texture->metadata.compressionSettings = "TC_Default";
-    texture->metadata.textureGroup = "TEXTUREGROUP_World";
     
     // Create an Unreal Engine logo-like pattern
     int size = texture->metadata.width * texture->metadata.height * 4;
@@ -545,11 +587,27 @@ std::unique_ptr<TextureData> UnrealTextureLoader::LoadUasset(const std::string&
     return texture;
 }
 
+std::map<std::string, std::string> UnrealTextureLoader::ParseUAssetProperties(const UnrealPackage& package, size_t exportIndex) {
+    std::map<std::string, std::string> properties;
+    std::vector<UnrealPackage::Property> tags;
+    if (!package.ReadProperties(exportIndex, tags)) {
+        return properties;
+    }
+    for (const auto& tag : tags) {
+        std::string value = package.ToText(tag);
+        if (!value.empty()) {
+            properties[package.GetName(tag.name)] = value;
+        }
+    }
+    return properties;
+}
+
 std::unique_ptr<TextureData> UnrealTextureLoader::LoadUmap(const std::string& filename) {
     LogInfo("Loading Unreal Map (.umap): " + filename);
     
-    std::vector<uint8_t> fileData = ReadFile(filename);
-    if (fileData.empty()) {
+    // Only the package tables are read, to reject files that aren't maps
+    UnrealPackage package;
+    if (!package.Open(filename)) {
         return nullptr;
     }
     
@@ -626,39 +684,92 @@ std::unique_ptr<TextureData> UnrealTextureLoader::ConvertFormat(const TextureDat
     return result;
 }
 
-std::unique_ptr<TextureData> UnrealTextureLoader::GenerateMipmaps(const TextureData& source) {
+std::unique_ptr<TextureData> UnrealTextureLoader::GenerateMipmaps(const TextureData& source, JobSystem* jobs) {
     LogInfo("Generating mipmaps for texture: " + std::to_string(source.metadata.width) + "x" + std::to_string(source.metadata.height));
     
-    auto result = std::make_unique<TextureData>(source);
+    const TextureFormat format = source.metadata.format;
+    if (format != TextureFormat::R8G8B8A8_UNORM && format != TextureFormat::R8G8B8A8_SRGB) {
+        LogError("Mipmap generation needs RGBA8 data, not " + GetFormatName(format));
+        return std::make_unique<TextureData>(source);
+    }
+    const size_t baseSize = static_cast<size_t>(source.metadata.width) * source.metadata.height * 4;
+    if (source.metadata.width <= 0 || source.metadata.height <= 0 || source.data.size() < baseSize) {
+        LogError("Texture data is smaller than its dimensions");
+        return std::make_unique<TextureData>(source);
+    }
     
-    // Generate a simple mipmap chain
-    int mipWidth = source.metadata.width;
-    int mipHeight = source.metadata.height;
-    int mipLevel = 0;
+    MipGenerator::Settings settings;
+    settings.filter = MipGenerator::Filter::Lanczos3;
+    settings.srgb = format == TextureFormat::R8G8B8A8_SRGB || source.metadata.isSRGB;
+    settings.normalMap = source.metadata.compressionSettings == "TC_Normalmap";
     
-    while (mipWidth > 1 || mipHeight > 1) {
-        mipWidth = std::max(1, mipWidth / 2);
-        mipHeight = std::max(1, mipHeight / 2);
-        mipLevel++;
-        
-        // Create a simple downsampled version
-        std::vector<uint8_t> mipData(mipWidth * mipHeight * 4);
-        // Simple box filter downsampling would go here
-        result->mipLevels.push_back(mipData);
+    std::vector<uint8_t> mipData;
+    std::vector<MipGenerator::Level> mips;
+    if (!MipGenerator::Generate(source.data.data(), source.metadata.width, source.metadata.height,
+                                settings, mipData, mips, jobs)) {
+        return std::make_unique<TextureData>(source);
     }
     
-    result->metadata.mipLevels = mipLevel + 1;
+    auto result = std::make_unique<TextureData>();
+    result->metadata = source.metadata;
+    result->data = source.data;
+    result->mipLevels.reserve(mips.size());
+    for (const MipGenerator::Level& mip : mips) {
+        const auto begin = mipData.begin() + mip.offset;
+        result->mipLevels.emplace_back(begin, begin + static_cast<size_t>(mip.width) * mip.height * 4);
+    }
+    result->metadata.mipLevels = static_cast<int>(mips.size() + 1);
     
     return result;
 }
 
-std::unique_ptr<TextureData> UnrealTextureLoader::DecompressTexture(const TextureData& source) {
+std::unique_ptr<TextureData> UnrealTextureLoader::DecompressTexture(const TextureData& source, JobSystem* jobs) {
     LogInfo("Decompressing texture format: " + GetFormatName(source.metadata.format));
     
-    // For now, just return a copy
-    auto result = std::make_unique<TextureData>(source);
+    BlockDecompressor::Format blockFormat;
+    switch (source.metadata.format) {
+        case TextureFormat::DXT1: blockFormat = BlockDecompressor::Format::BC1; break;
+        case TextureFormat::DXT3: blockFormat = BlockDecompressor::Format::BC2; break;
+        case TextureFormat::DXT5: blockFormat = BlockDecompressor::Format::BC3; break;
+        case TextureFormat::BC4: blockFormat = BlockDecompressor::Format::BC4; break;
+        case TextureFormat::BC5: blockFormat = BlockDecompressor::Format::BC5; break;
+        case TextureFormat::BC6H:
+        case TextureFormat::BC7:
+            // Upload these as-is through the DDS/KTX2 container path; there is no CPU decoder
+            LogError("CPU decompression of " + GetFormatName(source.metadata.format) + " is not supported");
+            return nullptr;
+        default:
+            return std::make_unique<TextureData>(source);
+    }
+    
+    auto result = std::make_unique<TextureData>();
+    result->metadata = source.metadata;
     result->metadata.format = TextureFormat::R8G8B8A8_UNORM;
     
+    // Decode straight into the result so each level is written exactly once
+    auto decode = [&](const std::vector<uint8_t>& blocks, int width, int height, std::vector<uint8_t>& pixels) {
+        pixels.resize(static_cast<size_t>(width) * height * 4);
+        return BlockDecompressor::Decompress(blockFormat, blocks.data(), blocks.size(), width, height,
+                                             pixels.data(), static_cast<size_t>(width) * 4, jobs);
+    };
+    
+    int width = source.metadata.width;
+    int height = source.metadata.height;
+    if (!decode(source.data, width, height, result->data)) {
+        LogError("Compressed texture data is smaller than a " + std::to_string(width) + "x" + std::to_string(height) + " image");
+        return nullptr;
+    }
+    
+    result->mipLevels.resize(source.mipLevels.size());
+    for (size_t level = 0; level < source.mipLevels.size(); ++level) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        if (!decode(source.mipLevels[level], width, height, result->mipLevels[level])) {
+            LogError("Compressed mip level " + std::to_string(level + 1) + " is truncated");
+            return nullptr;
+        }
+    }
+    
     return result;
 }
 
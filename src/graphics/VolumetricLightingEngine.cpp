@@ -0,0 +1,254 @@
+#include "VolumetricLightingEngine.h"
+#include "AtmosphereRenderer.h"
+#include "Camera.h"
+#include "FroxelFog.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace Nexus {
+
+namespace {
+
+FroxelFog::Settings ToFroxelSettings(const VolumetricLightingEngine::VolumetricSettings& settings, bool temporal) {
+    FroxelFog::Settings froxel;
+    froxel.width = static_cast<UINT>(std::max(settings.froxelResolutionX, 1));
+    froxel.height = static_cast<UINT>(std::max(settings.froxelResolutionY, 1));
+    froxel.depth = static_cast<UINT>(std::max(settings.froxelResolutionZ, 1));
+    froxel.nearPlane = settings.nearPlane;
+    froxel.farPlane = settings.farPlane;
+    froxel.density = settings.density;
+    froxel.heightDensity = settings.fogDensity;
+    froxel.fogHeight = settings.fogHeight;
+    froxel.heightFalloff = settings.fogFalloff;
+
+    // Tint the scattered part of the extinction by the fog color
+    float total = settings.scatteringCoeff + settings.absorptionCoeff;
+    float albedo = total > 0.0f ? settings.scatteringCoeff / total : 0.0f;
+    froxel.albedo = XMFLOAT3(settings.fogColor.x * albedo, settings.fogColor.y * albedo, settings.fogColor.z * albedo);
+    froxel.anisotropy = settings.anisotropy;
+    if (!temporal) {
+        froxel.temporalBlend = 1.0f;
+    }
+    return froxel;
+}
+
+AtmosphereRenderer::Settings ToAtmosphereSettings(const VolumetricLightingEngine::AtmosphereSettings& settings) {
+    AtmosphereRenderer::Settings atmosphere;
+    atmosphere.rayleighScattering = settings.rayleighScattering;
+    atmosphere.mieScattering = settings.mieScattering;
+    atmosphere.ozoneAbsorption = settings.ozoneAbsorption;
+    atmosphere.planetRadius = settings.planetRadius;
+    atmosphere.atmosphereRadius = settings.atmosphereRadius;
+    atmosphere.rayleighScaleHeight = settings.rayleighScaleHeight;
+    atmosphere.mieScaleHeight = settings.mieScaleHeight;
+    atmosphere.ozoneLayerCenter = settings.ozoneLayerCenter;
+    atmosphere.ozoneLayerWidth = settings.ozoneLayerWidth;
+    atmosphere.sunIntensity = settings.sunIntensity;
+    atmosphere.transmittanceWidth = static_cast<UINT>(std::max(settings.transmittanceLUTWidth, 1));
+    atmosphere.transmittanceHeight = static_cast<UINT>(std::max(settings.transmittanceLUTHeight, 1));
+    atmosphere.multiScatteringSize = static_cast<UINT>(std::max(settings.multiScatteringLUTSize, 1));
+    // The sky view is wider than tall since azimuth spans half a turn against the zenith's full one
+    atmosphere.skyViewWidth = static_cast<UINT>(std::max(settings.scatteringLUTSize, 1)) * 3;
+    atmosphere.skyViewHeight = static_cast<UINT>(std::max(settings.scatteringLUTSize, 1)) * 7 / 4;
+    return atmosphere;
+}
+
+bool UsesFroxels(const VolumetricLightingEngine::VolumetricSettings& settings) {
+    return settings.enableVolumetrics && settings.enableVolumetricFog &&
+           settings.technique == VolumetricLightingEngine::VolumetricTechnique::Froxels;
+}
+
+} // namespace
+
+VolumetricLightingEngine::VolumetricLightingEngine()
+    : device_(nullptr)
+    , context_(nullptr)
+    , screenWidth_(0)
+    , screenHeight_(0)
+    , volumetricTexture_(nullptr)
+    , volumetricRTV_(nullptr)
+    , volumetricSRV_(nullptr)
+    , lightCuller_(nullptr)
+    , shadowMaps_(nullptr)
+    , hasCamera_(false)
+    , godRaysTexture_(nullptr)
+    , godRaysRTV_(nullptr)
+    , godRaysSRV_(nullptr)
+    , atmosphereTexture_(nullptr)
+    , atmosphereRTV_(nullptr)
+    , atmosphereSRV_(nullptr)
+    , previousFrameTexture_(nullptr)
+    , previousFrameSRV_(nullptr)
+    , motionVectorTexture_(nullptr)
+    , motionVectorSRV_(nullptr)
+    , volumetricConstantBuffer_(nullptr)
+    , atmosphereConstantBuffer_(nullptr)
+    , godRaysConstantBuffer_(nullptr)
+    , linearSampler_(nullptr)
+    , pointSampler_(nullptr)
+    , atmosphereSampler_(nullptr)
+    , temporalUpsamplingEnabled_(true)
+    , adaptiveQualityEnabled_(false)
+    , froxelCachingEnabled_(false)
+    , adaptiveQualityFactor_(1.0f)
+    , currentHumidity_(0.0f)
+    , currentPollution_(0.0f)
+    , currentCloudCoverage_(0.0f)
+    , timeOfDay_(12.0f)
+{
+    XMStoreFloat4x4(&viewMatrix_, XMMatrixIdentity());
+    XMStoreFloat4x4(&projectionMatrix_, XMMatrixIdentity());
+}
+
+VolumetricLightingEngine::~VolumetricLightingEngine() {
+    Shutdown();
+}
+
+bool VolumetricLightingEngine::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int screenWidth, int screenHeight) {
+    if (!device || !context) return false;
+
+    device_ = device;
+    context_ = context;
+    screenWidth_ = screenWidth;
+    screenHeight_ = screenHeight;
+    InitializeFroxels();
+    PrecomputeAtmosphere();
+    return true;
+}
+
+void VolumetricLightingEngine::Shutdown() {
+    froxelFog_.reset();
+    atmosphere_.reset();
+    lightCuller_ = nullptr;
+    shadowMaps_ = nullptr;
+    hasCamera_ = false;
+    device_ = nullptr;
+    context_ = nullptr;
+}
+
+void VolumetricLightingEngine::Resize(int newWidth, int newHeight) {
+    // The froxel volume is independent of the screen size
+    screenWidth_ = newWidth;
+    screenHeight_ = newHeight;
+}
+
+void VolumetricLightingEngine::SetVolumetricSettings(const VolumetricSettings& settings) {
+    volumetricSettings_ = settings;
+    if (!device_) return;
+
+    if (!UsesFroxels(volumetricSettings_)) {
+        froxelFog_.reset();
+    } else if (!froxelFog_) {
+        InitializeFroxels();
+    } else if (!froxelFog_->SetSettings(ToFroxelSettings(volumetricSettings_, temporalUpsamplingEnabled_))) {
+        Logger::Warning("Froxel fog resize failed, volumetric fog disabled");
+        froxelFog_.reset();
+    }
+}
+
+void VolumetricLightingEngine::SetAtmosphereSettings(const AtmosphereSettings& settings) {
+    atmosphereSettings_ = settings;
+    if (atmosphere_ && !atmosphere_->SetSettings(ToAtmosphereSettings(atmosphereSettings_))) {
+        Logger::Warning("Atmosphere lookup table resize failed, atmospheric scattering disabled");
+        atmosphere_.reset();
+    }
+}
+
+void VolumetricLightingEngine::SetLightSources(const ClusteredLightCuller* lights, const CascadedShadowMaps* shadows) {
+    lightCuller_ = lights;
+    shadowMaps_ = shadows;
+}
+
+void VolumetricLightingEngine::SetTemporalUpsampling(bool enable) {
+    temporalUpsamplingEnabled_ = enable;
+    if (froxelFog_) {
+        froxelFog_->SetSettings(ToFroxelSettings(volumetricSettings_, enable));
+    }
+}
+
+void VolumetricLightingEngine::BeginFrame(Camera* camera) {
+    UpdateFroxels(camera);
+}
+
+void VolumetricLightingEngine::RenderVolumetrics(const std::vector<std::shared_ptr<Light>>& lights) {
+    if (!UsesFroxels(volumetricSettings_)) return;
+    RenderFroxelLighting(lights);
+}
+
+void VolumetricLightingEngine::RenderVolumetricFog() {
+    if (!UsesFroxels(volumetricSettings_)) return;
+    RenderFroxelLighting({});
+}
+
+void VolumetricLightingEngine::RenderAtmosphericScattering(const XMFLOAT3& sunDirection) {
+    if (!atmosphere_ || !volumetricSettings_.enableAtmosphericScattering) return;
+    atmosphereSettings_.sunDirection = sunDirection;
+
+    // World y is the altitude above the ground
+    float cameraHeight = 0.0f;
+    if (hasCamera_) {
+        XMMATRIX inverseView = XMMatrixInverse(nullptr, XMLoadFloat4x4(&viewMatrix_));
+        cameraHeight = XMVectorGetY(inverseView.r[3]);
+    }
+    atmosphere_->Update(sunDirection, cameraHeight);
+}
+
+void VolumetricLightingEngine::EndFrame() {
+    hasCamera_ = false;
+}
+
+void VolumetricLightingEngine::CompositeVolumetricFog(StateCache& stateCache, ID3D11ShaderResourceView* depth,
+                                                      ID3D11RenderTargetView* target, UINT width, UINT height) {
+    if (!froxelFog_) return;
+    froxelFog_->Composite(stateCache, depth, target, width, height);
+}
+
+ID3D11ShaderResourceView* VolumetricLightingEngine::GetFroxelVolume() const {
+    return froxelFog_ ? froxelFog_->GetIntegratedVolume() : nullptr;
+}
+
+void VolumetricLightingEngine::RenderSky(StateCache& stateCache, ID3D11RenderTargetView* target,
+                                         ID3D11DepthStencilView* depthTarget, UINT width, UINT height) {
+    if (!atmosphere_ || !volumetricSettings_.enableAtmosphericScattering) return;
+    atmosphere_->RenderSky(stateCache, target, depthTarget, XMLoadFloat4x4(&viewMatrix_),
+                           XMLoadFloat4x4(&projectionMatrix_), width, height);
+}
+
+void VolumetricLightingEngine::PrecomputeAtmosphere() {
+    atmosphere_ = std::make_unique<AtmosphereRenderer>();
+    if (!atmosphere_->Initialize(device_, context_, ToAtmosphereSettings(atmosphereSettings_))) {
+        Logger::Warning("Atmosphere lookup tables unavailable, atmospheric scattering disabled");
+        atmosphere_.reset();
+        return;
+    }
+    atmosphere_->Update(atmosphereSettings_.sunDirection, 0.0f);
+}
+
+void VolumetricLightingEngine::InitializeFroxels() {
+    froxelFog_.reset();
+    if (!device_ || !UsesFroxels(volumetricSettings_)) return;
+
+    froxelFog_ = std::make_unique<FroxelFog>();
+    if (!froxelFog_->Initialize(device_, context_, ToFroxelSettings(volumetricSettings_, temporalUpsamplingEnabled_))) {
+        Logger::Warning("Froxel fog unavailable, volumetric fog disabled");
+        froxelFog_.reset();
+    }
+}
+
+void VolumetricLightingEngine::UpdateFroxels(Camera* camera) {
+    hasCamera_ = camera != nullptr;
+    if (!camera) return;
+    XMStoreFloat4x4(&viewMatrix_, camera->GetViewMatrix());
+    XMStoreFloat4x4(&projectionMatrix_, camera->GetProjectionMatrix());
+}
+
+void VolumetricLightingEngine::RenderFroxelLighting(const std::vector<std::shared_ptr<Light>>& lights) {
+    // Lights reach the volume through the clustered light lists set in SetLightSources
+    (void)lights;
+    if (!froxelFog_ || !hasCamera_) return;
+    NEXUS_PROFILE_SCOPE("VolumetricLightingEngine::RenderFroxelLighting");
+    froxelFog_->Render(XMLoadFloat4x4(&viewMatrix_), XMLoadFloat4x4(&projectionMatrix_), lightCuller_, shadowMaps_);
+}
+
+} // namespace Nexus
@@ -1,24 +1,59 @@
 #include "InputManager.h"
 #include "Logger.h"
+#include <xinput.h>
 #include <cstring>
 
+#pragma comment(lib, "xinput.lib")
+
 namespace Nexus {
 
+namespace {
+
+// HID usages for RegisterRawInputDevices
+constexpr USHORT RAW_USAGE_PAGE_GENERIC = 0x01;
+constexpr USHORT RAW_USAGE_MOUSE = 0x02;
+constexpr USHORT RAW_USAGE_KEYBOARD = 0x06;
+
+// Raw Input button flags, indexed by MouseButton
+constexpr USHORT MOUSE_DOWN_FLAGS[] = {
+    RI_MOUSE_LEFT_BUTTON_DOWN, RI_MOUSE_RIGHT_BUTTON_DOWN, RI_MOUSE_MIDDLE_BUTTON_DOWN,
+    RI_MOUSE_BUTTON_4_DOWN, RI_MOUSE_BUTTON_5_DOWN
+};
+constexpr USHORT MOUSE_UP_FLAGS[] = {
+    RI_MOUSE_LEFT_BUTTON_UP, RI_MOUSE_RIGHT_BUTTON_UP, RI_MOUSE_MIDDLE_BUTTON_UP,
+    RI_MOUSE_BUTTON_4_UP, RI_MOUSE_BUTTON_5_UP
+};
+constexpr int MOUSE_VIRTUAL_KEYS[] = { VK_LBUTTON, VK_RBUTTON, VK_MBUTTON, VK_XBUTTON1, VK_XBUTTON2 };
+constexpr int MOUSE_BUTTON_COUNT = 5;
+
+int64_t GetTimestamp() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+} // namespace
+
 InputManager::InputManager()
     : hwnd_(nullptr)
     , directInput_(nullptr)
     , keyboard_(nullptr)
     , mouse_(nullptr)
+    , rawInput_(false)
+    , liveInput_(true)
     , mouseX_(0)
     , mouseY_(0)
     , prevMouseX_(0)
     , prevMouseY_(0)
+    , mouseDeltaX_(0)
+    , mouseDeltaY_(0)
+    , wheelDelta_(0)
+    , mouseMotionX_(0)
+    , mouseMotionY_(0)
     , initialized_(false)
 {
     memset(&keyboardState_, 0, sizeof(keyboardState_));
-    memset(&prevKeyboardState_, 0, sizeof(prevKeyboardState_));
     memset(&mouseState_, 0, sizeof(mouseState_));
-    memset(&prevMouseState_, 0, sizeof(prevMouseState_));
 }
 
 InputManager::~InputManager() {
@@ -27,14 +62,20 @@ InputManager::~InputManager() {
 
 bool InputManager::Initialize(HWND hwnd) {
     if (initialized_) return true;
-    
+
     hwnd_ = hwnd;
-    
+
     try {
-        // For now, we'll use simple Windows input without DirectInput
-        // to avoid DirectInput SDK dependency
+        // Raw Input needs no SDK and delivers every key and mouse event as it happens
+        rawInput_ = RegisterRawInput();
+        if (!rawInput_) {
+            Logger::Warning("Raw Input unavailable, polling keyboard and mouse");
+        }
+        pendingEvents_.reserve(256);
+        frameEvents_.reserve(256);
         initialized_ = true;
-        Logger::Info("Input manager initialized (using Windows API)");
+        Logger::Info(rawInput_ ? "Input manager initialized (Raw Input, XInput)"
+                               : "Input manager initialized (polling, XInput)");
         return true;
     } catch (const std::exception& e) {
         Logger::Error("Failed to initialize input manager: " + std::string(e.what()));
@@ -44,67 +85,276 @@ bool InputManager::Initialize(HWND hwnd) {
 
 void InputManager::Shutdown() {
     if (!initialized_) return;
-    
+
+    if (rawInput_) {
+        RAWINPUTDEVICE devices[2] = {};
+        devices[0].usUsagePage = RAW_USAGE_PAGE_GENERIC;
+        devices[0].usUsage = RAW_USAGE_KEYBOARD;
+        devices[0].dwFlags = RIDEV_REMOVE;
+        devices[1].usUsagePage = RAW_USAGE_PAGE_GENERIC;
+        devices[1].usUsage = RAW_USAGE_MOUSE;
+        devices[1].dwFlags = RIDEV_REMOVE;
+        RegisterRawInputDevices(devices, 2, sizeof(RAWINPUTDEVICE));
+        rawInput_ = false;
+    }
+
     // Cleanup DirectInput resources if used
     if (keyboard_) {
         keyboard_->Release();
         keyboard_ = nullptr;
     }
-    
+
     if (mouse_) {
         mouse_->Release();
         mouse_ = nullptr;
     }
-    
+
     if (directInput_) {
         directInput_->Release();
         directInput_ = nullptr;
     }
-    
+
+    pendingEvents_.clear();
+    frameEvents_.clear();
     initialized_ = false;
     Logger::Info("Input manager shutdown");
 }
 
+bool InputManager::RegisterRawInput() {
+    if (!hwnd_) return false;
+
+    // The sink keeps input arriving while another window has focus, so releases that happen
+    // after alt-tab still reach us; HandleRawInput drops everything else from the background
+    RAWINPUTDEVICE devices[2] = {};
+    devices[0].usUsagePage = RAW_USAGE_PAGE_GENERIC;
+    devices[0].usUsage = RAW_USAGE_KEYBOARD;
+    devices[0].dwFlags = RIDEV_INPUTSINK;
+    devices[0].hwndTarget = hwnd_;
+    devices[1].usUsagePage = RAW_USAGE_PAGE_GENERIC;
+    devices[1].usUsage = RAW_USAGE_MOUSE;
+    devices[1].dwFlags = RIDEV_INPUTSINK;
+    devices[1].hwndTarget = hwnd_;
+    return RegisterRawInputDevices(devices, 2, sizeof(RAWINPUTDEVICE)) != FALSE;
+}
+
 void InputManager::Update() {
     if (!initialized_) return;
-    
-    UpdateKeyboard();
-    UpdateMouse();
-    UpdateControllers();
-}
-
-void InputManager::UpdateKeyboard() {
-    // Copy current state to previous
-    memcpy(&prevKeyboardState_, &keyboardState_, sizeof(keyboardState_));
-    
-    // Update keyboard state using Windows API
-    for (int i = 0; i < 256; ++i) {
-        keyboardState_[i] = (GetAsyncKeyState(i) & 0x8000) ? 0x80 : 0x00;
+
+    if (liveInput_) {
+        if (!rawInput_) {
+            PollKeyboard();
+            PollMouse();
+        }
+        UpdateControllers();
     }
-}
+    ApplyEvents();
+    // Replayed input moves the mouse by its events alone
+    if (!liveInput_) return;
 
-void InputManager::UpdateMouse() {
-    // Copy current state to previous
-    prevMouseState_ = mouseState_;
+    // The cursor position is for UI; raw deltas are for aiming
     prevMouseX_ = mouseX_;
     prevMouseY_ = mouseY_;
-    
-    // Get mouse position
     POINT mousePos;
     GetCursorPos(&mousePos);
     ScreenToClient(hwnd_, &mousePos);
     mouseX_ = mousePos.x;
     mouseY_ = mousePos.y;
-    
-    // Get mouse button states
-    mouseState_.rgbButtons[0] = (GetAsyncKeyState(VK_LBUTTON) & 0x8000) ? 0x80 : 0x00;
-    mouseState_.rgbButtons[1] = (GetAsyncKeyState(VK_RBUTTON) & 0x8000) ? 0x80 : 0x00;
-    mouseState_.rgbButtons[2] = (GetAsyncKeyState(VK_MBUTTON) & 0x8000) ? 0x80 : 0x00;
+    if (!rawInput_) {
+        mouseDeltaX_ = mouseX_ - prevMouseX_;
+        mouseDeltaY_ = mouseY_ - prevMouseY_;
+    }
+}
+
+void InputManager::InjectEvent(const InputEvent& event) {
+    InputEvent injected = event;
+    injected.timestamp = GetTimestamp();
+    pendingEvents_.push_back(injected);
+}
+
+void InputManager::HandleRawInput(WPARAM wParam, LPARAM lParam) {
+    if (!initialized_ || !rawInput_ || !liveInput_) return;
+
+    // Keyboard and mouse packets fit in a RAWINPUT; HID devices aren't registered
+    RAWINPUT raw;
+    UINT size = sizeof(raw);
+    if (GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, &raw, &size,
+                        sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1)) {
+        return;
+    }
+    bool background = GET_RAWINPUT_CODE_WPARAM(wParam) == RIM_INPUTSINK;
+
+    if (raw.header.dwType == RIM_TYPEKEYBOARD) {
+        const RAWKEYBOARD& keyboard = raw.data.keyboard;
+        // 0xFF marks the fake shifts around some E0 keys; E1 is only Pause's prefix
+        if (keyboard.VKey == 0xFF || (keyboard.Flags & RI_KEY_E1) ||
+            keyboard.MakeCode == KEYBOARD_OVERRUN_MAKE_CODE) {
+            return;
+        }
+        uint16_t code = (keyboard.MakeCode & 0x7F) | ((keyboard.Flags & RI_KEY_E0) ? 0x80 : 0);
+        bool down = (keyboard.Flags & RI_KEY_BREAK) == 0;
+        // Auto-repeat sends more makes; only the first is an event
+        if (down == keysQueuedDown_.test(code) || (down && background)) return;
+        keysQueuedDown_.set(code, down);
+        QueueEvent(down ? InputEventType::KeyDown : InputEventType::KeyUp, code);
+    } else if (raw.header.dwType == RIM_TYPEMOUSE) {
+        const RAWMOUSE& mouse = raw.data.mouse;
+        for (int button = 0; button < MOUSE_BUTTON_COUNT; ++button) {
+            if ((mouse.usButtonFlags & MOUSE_DOWN_FLAGS[button]) && !background && !buttonsQueuedDown_.test(button)) {
+                buttonsQueuedDown_.set(button);
+                QueueEvent(InputEventType::MouseButtonDown, static_cast<uint16_t>(button));
+            }
+            if ((mouse.usButtonFlags & MOUSE_UP_FLAGS[button]) && buttonsQueuedDown_.test(button)) {
+                buttonsQueuedDown_.reset(button);
+                QueueEvent(InputEventType::MouseButtonUp, static_cast<uint16_t>(button));
+            }
+        }
+        if (background) return;
+        // Absolute motion comes from tablets and remote desktop; the cursor covers those
+        if (!(mouse.usFlags & MOUSE_MOVE_ABSOLUTE) && (mouse.lLastX != 0 || mouse.lLastY != 0)) {
+            QueueEvent(InputEventType::MouseMove, 0, mouse.lLastX, mouse.lLastY);
+            mouseMotionX_.store(mouseMotionX_.load(std::memory_order_relaxed) + mouse.lLastX, std::memory_order_relaxed);
+            mouseMotionY_.store(mouseMotionY_.load(std::memory_order_relaxed) + mouse.lLastY, std::memory_order_relaxed);
+        }
+        if (mouse.usButtonFlags & RI_MOUSE_WHEEL) {
+            QueueEvent(InputEventType::MouseWheel, 0, 0, static_cast<SHORT>(mouse.usButtonData));
+        }
+    }
+}
+
+int64_t InputManager::GetTimestampFrequency() {
+    static const int64_t frequency = []() {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        return value.QuadPart;
+    }();
+    return frequency;
+}
+
+void InputManager::QueueEvent(InputEventType type, uint16_t code, int32_t x, int32_t y, uint8_t controller) {
+    InputEvent event;
+    event.type = type;
+    event.controller = controller;
+    event.code = code;
+    event.x = x;
+    event.y = y;
+    event.timestamp = GetTimestamp();
+    pendingEvents_.push_back(event);
+}
+
+void InputManager::ApplyEvents() {
+    frameEvents_.swap(pendingEvents_);
+    pendingEvents_.clear();
+
+    keysPressed_.reset();
+    keysReleased_.reset();
+    buttonsPressed_.reset();
+    buttonsReleased_.reset();
+    if (rawInput_ || !liveInput_) {
+        mouseDeltaX_ = 0;
+        mouseDeltaY_ = 0;
+    }
+    wheelDelta_ = 0;
+
+    // Edges are kept even when a key went down and up again within the frame
+    for (const InputEvent& event : frameEvents_) {
+        switch (event.type) {
+            case InputEventType::KeyDown:
+                keyboardState_[event.code] = 0x80;
+                keysPressed_.set(event.code);
+                break;
+            case InputEventType::KeyUp:
+                keyboardState_[event.code] = 0x00;
+                keysReleased_.set(event.code);
+                break;
+            case InputEventType::MouseButtonDown:
+                mouseState_.rgbButtons[event.code] = 0x80;
+                buttonsPressed_.set(event.code);
+                break;
+            case InputEventType::MouseButtonUp:
+                mouseState_.rgbButtons[event.code] = 0x00;
+                buttonsReleased_.set(event.code);
+                break;
+            case InputEventType::MouseMove:
+                mouseDeltaX_ += event.x;
+                mouseDeltaY_ += event.y;
+                break;
+            case InputEventType::MouseWheel:
+                wheelDelta_ += event.y;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void InputManager::PollKeyboard() {
+    // KeyCode values are scan codes; map each to its virtual key for GetAsyncKeyState
+    for (int code = 1; code < 256; ++code) {
+        UINT scanCode = (code & 0x7F) | ((code & 0x80) ? 0xE000 : 0);
+        UINT virtualKey = MapVirtualKey(scanCode, MAPVK_VSC_TO_VK_EX);
+        if (virtualKey == 0) continue;
+        bool down = (GetAsyncKeyState(virtualKey) & 0x8000) != 0;
+        if (down != keysQueuedDown_.test(code)) {
+            keysQueuedDown_.set(code, down);
+            QueueEvent(down ? InputEventType::KeyDown : InputEventType::KeyUp, static_cast<uint16_t>(code));
+        }
+    }
+}
+
+void InputManager::PollMouse() {
+    for (int button = 0; button < MOUSE_BUTTON_COUNT; ++button) {
+        bool down = (GetAsyncKeyState(MOUSE_VIRTUAL_KEYS[button]) & 0x8000) != 0;
+        if (down != buttonsQueuedDown_.test(button)) {
+            buttonsQueuedDown_.set(button, down);
+            QueueEvent(down ? InputEventType::MouseButtonDown : InputEventType::MouseButtonUp,
+                       static_cast<uint16_t>(button));
+        }
+    }
 }
 
 void InputManager::UpdateControllers() {
-    // Controller support would be implemented here
-    // Using XInput for Xbox controllers
+    int64_t now = GetTimestamp();
+    for (int i = 0; i < MAX_CONTROLLERS; ++i) {
+        ControllerState& controller = controllers_[i];
+        // XInputGetState stalls on empty slots, so those are only probed once a second
+        if (!controller.connected && now < controller.nextProbe) continue;
+
+        XINPUT_STATE state = {};
+        if (XInputGetState(i, &state) != ERROR_SUCCESS) {
+            if (controller.connected) {
+                for (int bit = 0; bit < 16; ++bit) {
+                    if (controller.buttons & (1u << bit)) {
+                        QueueEvent(InputEventType::ControllerButtonUp, static_cast<uint16_t>(1u << bit), 0, 0, static_cast<uint8_t>(i));
+                    }
+                }
+                QueueEvent(InputEventType::ControllerDisconnected, 0, 0, 0, static_cast<uint8_t>(i));
+                controller = ControllerState();
+                Logger::Info("Controller " + std::to_string(i) + " disconnected");
+            }
+            controller.nextProbe = now + GetTimestampFrequency();
+            continue;
+        }
+
+        if (!controller.connected) {
+            controller.connected = true;
+            controller.packetNumber = state.dwPacketNumber - 1;
+            QueueEvent(InputEventType::ControllerConnected, 0, 0, 0, static_cast<uint8_t>(i));
+            Logger::Info("Controller " + std::to_string(i) + " connected");
+        }
+        if (state.dwPacketNumber == controller.packetNumber) continue;
+        controller.packetNumber = state.dwPacketNumber;
+
+        uint16_t changed = controller.buttons ^ state.Gamepad.wButtons;
+        for (int bit = 0; bit < 16; ++bit) {
+            uint16_t button = static_cast<uint16_t>(1u << bit);
+            if (changed & button) {
+                QueueEvent((state.Gamepad.wButtons & button) ? InputEventType::ControllerButtonDown
+                                                             : InputEventType::ControllerButtonUp,
+                           button, 0, 0, static_cast<uint8_t>(i));
+            }
+        }
+        controller.buttons = state.Gamepad.wButtons;
+    }
 }
 
 bool InputManager::IsKeyDown(KeyCode key) const {
@@ -114,14 +364,12 @@ bool InputManager::IsKeyDown(KeyCode key) const {
 
 bool InputManager::IsKeyPressed(KeyCode key) const {
     if (!initialized_) return false;
-    int keyIndex = static_cast<int>(key);
-    return (keyboardState_[keyIndex] & 0x80) && !(prevKeyboardState_[keyIndex] & 0x80);
+    return keysPressed_.test(static_cast<int>(key));
 }
 
 bool InputManager::IsKeyReleased(KeyCode key) const {
     if (!initialized_) return false;
-    int keyIndex = static_cast<int>(key);
-    return !(keyboardState_[keyIndex] & 0x80) && (prevKeyboardState_[keyIndex] & 0x80);
+    return keysReleased_.test(static_cast<int>(key));
 }
 
 bool InputManager::IsMouseButtonDown(MouseButton button) const {
@@ -131,16 +379,12 @@ bool InputManager::IsMouseButtonDown(MouseButton button) const {
 
 bool InputManager::IsMouseButtonPressed(MouseButton button) const {
     if (!initialized_) return false;
-    int buttonIndex = static_cast<int>(button);
-    return (mouseState_.rgbButtons[buttonIndex] & 0x80) && 
-           !(prevMouseState_.rgbButtons[buttonIndex] & 0x80);
+    return buttonsPressed_.test(static_cast<int>(button));
 }
 
 bool InputManager::IsMouseButtonReleased(MouseButton button) const {
     if (!initialized_) return false;
-    int buttonIndex = static_cast<int>(button);
-    return !(mouseState_.rgbButtons[buttonIndex] & 0x80) && 
-           (prevMouseState_.rgbButtons[buttonIndex] & 0x80);
+    return buttonsReleased_.test(static_cast<int>(button));
 }
 
 void InputManager::GetMousePosition(int& x, int& y) const {
@@ -149,23 +393,30 @@ void InputManager::GetMousePosition(int& x, int& y) const {
 }
 
 void InputManager::GetMouseDelta(int& deltaX, int& deltaY) const {
-    deltaX = mouseX_ - prevMouseX_;
-    deltaY = mouseY_ - prevMouseY_;
+    deltaX = mouseDeltaX_;
+    deltaY = mouseDeltaY_;
 }
 
 int InputManager::GetMouseWheelDelta() const {
-    // Mouse wheel delta would be tracked here
-    return 0;
+    return wheelDelta_;
 }
 
 int InputManager::GetConnectedControllerCount() const {
-    // Return number of connected controllers
-    return 0;
+    int count = 0;
+    for (const auto& controller : controllers_) {
+        if (controller.connected) ++count;
+    }
+    return count;
 }
 
 bool InputManager::IsControllerConnected(int controllerId) const {
-    // Check if specific controller is connected
-    return false;
+    if (controllerId < 0 || controllerId >= MAX_CONTROLLERS) return false;
+    return controllers_[controllerId].connected;
+}
+
+bool InputManager::IsControllerButtonDown(int controllerId, uint16_t button) const {
+    if (!IsControllerConnected(controllerId)) return false;
+    return (controllers_[controllerId].buttons & button) != 0;
 }
 
 } // namespace Nexus
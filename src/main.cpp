@@ -1,5 +1,6 @@
 #include "Engine.h"
 #include "Logger.h"
+#include "SceneBenchmark.h"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -59,11 +60,32 @@ namespace {
         std::cout << "    --fullscreen, -f  Start in fullscreen mode\n";
         std::cout << "    --resolution WxH  Set window resolution (e.g., 1920x1080)\n";
         std::cout << "    --config FILE     Use custom config file\n";
-        std::cout << "    --debug, -d       Enable debug mode\n\n";
+        std::cout << "    --debug, -d       Enable debug mode\n";
+        std::cout << "    --headless        Run simulation only (no window or GPU)\n";
+        std::cout << "    --tick-rate HZ    Headless simulation rate (default 60)\n";
+        std::cout << "    --frames N        Exit after N frames (soak tests)\n";
+        std::cout << "    --parallel-submit Record large passes on deferred contexts\n";
+        std::cout << "    --occlusion-cull  GPU Hi-Z occlusion culling of batched primitives\n";
+        std::cout << "    --fiber-jobs      Run jobs on fibers so waiting jobs free their worker\n";
+        std::cout << "    --benchmark SCENE Play a stock scene uncapped and report frame times\n";
+        std::cout << "                      (physics10k, ai1000, particles1m, lights); --frames\n";
+        std::cout << "                      sets the measured frames\n";
+        std::cout << "    --benchmark-path FILE    Camera path and input script to play\n";
+        std::cout << "    --benchmark-record       Record the path from live camera and input\n";
+        std::cout << "    --benchmark-report FILE  Report file (default scene_benchmark.json)\n";
+        std::cout << "    --record-session FILE    Record input, frame times and seeds for replay\n";
+        std::cout << "    --replay-session FILE    Replay a recorded session as fast as possible,\n";
+        std::cout << "                             profiler on\n";
+        std::cout << "    --replay-realtime        Replay at the recorded frame times\n";
+        std::cout << "    --server PORT            Replicate the world to clients on a UDP port\n";
+        std::cout << "    --max-clients N          Client slots of --server (default 128)\n";
+        std::cout << "    --connect HOST:PORT      Mirror a server's replicated entities\n\n";
         std::cout << "  Examples:\n";
         std::cout << "    " << programName << " demo.py\n";
         std::cout << "    " << programName << " --fullscreen --resolution 1920x1080\n";
-        std::cout << "    " << programName << " --config custom.ini mygame.py\n\n";
+        std::cout << "    " << programName << " --config custom.ini mygame.py\n";
+        std::cout << "    " << programName << " --benchmark physics10k --benchmark-path orbit.path\n";
+        std::cout << "    " << programName << " --headless --server 27015 --max-clients 128\n\n";
     }
     
     void PrintVersionInfo() {
@@ -105,6 +127,23 @@ namespace {
         bool debugMode = false;
         int windowWidth = 1280;
         int windowHeight = 720;
+        bool headless = false;
+        float tickRate = 60.0f;
+        unsigned long long frameLimit = 0;
+        bool parallelSubmit = false;
+        bool occlusionCull = false;
+        bool fiberJobs = false;
+        std::string benchmarkScene;
+        std::string benchmarkPath;
+        std::string benchmarkReport;
+        bool benchmarkRecord = false;
+        std::string recordSession;
+        std::string replaySession;
+        bool replayRealTime = false;
+        int serverPort = 0;
+        unsigned int maxClients = 128;
+        std::string connectHost;
+        int connectPort = 0;
     };
     
     CommandLineArgs ParseCommandLine(int argc, char* argv[]) {
@@ -137,6 +176,77 @@ namespace {
                     }
                 }
             }
+            else if (arg == "--headless") {
+                args.headless = true;
+            }
+            else if (arg == "--tick-rate" && i + 1 < argc) {
+                try {
+                    args.tickRate = std::stof(argv[++i]);
+                } catch (const std::exception&) {
+                    std::cerr << "⚠ Invalid tick rate: " << argv[i] << "\n";
+                }
+            }
+            else if (arg == "--frames" && i + 1 < argc) {
+                try {
+                    args.frameLimit = std::stoull(argv[++i]);
+                } catch (const std::exception&) {
+                    std::cerr << "⚠ Invalid frame count: " << argv[i] << "\n";
+                }
+            }
+            else if (arg == "--parallel-submit") {
+                args.parallelSubmit = true;
+            }
+            else if (arg == "--occlusion-cull") {
+                args.occlusionCull = true;
+            }
+            else if (arg == "--fiber-jobs") {
+                args.fiberJobs = true;
+            }
+            else if (arg == "--benchmark" && i + 1 < argc) {
+                args.benchmarkScene = argv[++i];
+            }
+            else if (arg == "--benchmark-path" && i + 1 < argc) {
+                args.benchmarkPath = argv[++i];
+            }
+            else if (arg == "--benchmark-report" && i + 1 < argc) {
+                args.benchmarkReport = argv[++i];
+            }
+            else if (arg == "--benchmark-record") {
+                args.benchmarkRecord = true;
+            }
+            else if (arg == "--record-session" && i + 1 < argc) {
+                args.recordSession = argv[++i];
+            }
+            else if (arg == "--replay-session" && i + 1 < argc) {
+                args.replaySession = argv[++i];
+            }
+            else if (arg == "--replay-realtime") {
+                args.replayRealTime = true;
+            }
+            else if (arg == "--server" && i + 1 < argc) {
+                try {
+                    args.serverPort = std::stoi(argv[++i]);
+                } catch (const std::exception&) {
+                    std::cerr << "⚠ Invalid server port: " << argv[i] << "\n";
+                }
+            }
+            else if (arg == "--max-clients" && i + 1 < argc) {
+                try {
+                    args.maxClients = static_cast<unsigned int>(std::stoul(argv[++i]));
+                } catch (const std::exception&) {
+                    std::cerr << "⚠ Invalid client count: " << argv[i] << "\n";
+                }
+            }
+            else if (arg == "--connect" && i + 1 < argc) {
+                std::string address = argv[++i];
+                size_t colon = address.rfind(':');
+                try {
+                    args.connectPort = colon != std::string::npos ? std::stoi(address.substr(colon + 1)) : 0;
+                    args.connectHost = address.substr(0, colon);
+                } catch (const std::exception&) {
+                    std::cerr << "⚠ Invalid server address: " << address << "\n";
+                }
+            }
             else if (arg == "--config" && i + 1 < argc) {
                 args.configFile = argv[++i];
             }
@@ -170,6 +280,32 @@ namespace {
             }
         }
         
+        if (args.benchmarkRecord && (args.benchmarkScene.empty() || args.benchmarkPath.empty())) {
+            std::cerr << "❌ --benchmark-record needs --benchmark and --benchmark-path\n";
+            return false;
+        }
+        
+        if (!args.recordSession.empty() && !args.replaySession.empty()) {
+            std::cerr << "❌ A session is either recorded or replayed, not both\n";
+            return false;
+        }
+        
+        if (args.serverPort != 0 && !args.connectHost.empty()) {
+            std::cerr << "❌ --server and --connect can't be combined\n";
+            return false;
+        }
+        
+        if ((args.serverPort != 0 && (args.serverPort < 1 || args.serverPort > 65535)) ||
+            (!args.connectHost.empty() && (args.connectPort < 1 || args.connectPort > 65535))) {
+            std::cerr << "❌ Port must be between 1 and 65535\n";
+            return false;
+        }
+        
+        if (args.headless && args.tickRate <= 0.0f) {
+            std::cerr << "❌ Tick rate must be positive\n";
+            return false;
+        }
+        
         if (args.windowWidth < 640 || args.windowHeight < 480) {
             std::cerr << "❌ Resolution too small. Minimum: 640x480\n";
             return false;
@@ -216,6 +352,37 @@ int main(int argc, char* argv[]) {
             // engine.SetDebugMode(true); // Implement this in Engine class
         }
         
+        if (args.headless) {
+            std::cout << "🖥  Headless mode at " << args.tickRate << " Hz\n";
+            engine.SetHeadless(true, args.tickRate);
+        }
+        if (!args.benchmarkScene.empty()) {
+            Nexus::SceneBenchmark::Settings benchmark;
+            benchmark.scene = args.benchmarkScene;
+            benchmark.pathFile = args.benchmarkPath;
+            benchmark.record = args.benchmarkRecord;
+            benchmark.frames = static_cast<uint32_t>(args.frameLimit);
+            if (!args.benchmarkReport.empty()) {
+                benchmark.reportFile = args.benchmarkReport;
+            }
+            std::cout << "⏱  " << (args.benchmarkRecord ? "Recording path in" : "Benchmarking")
+                      << " scene " << args.benchmarkScene << "\n";
+            engine.SetSceneBenchmark(std::make_unique<Nexus::SceneBenchmark>(benchmark));
+        } else {
+            engine.SetFrameLimit(args.frameLimit);
+        }
+        if (!args.recordSession.empty()) {
+            std::cout << "⏺  Recording session to " << args.recordSession << "\n";
+            engine.RecordSession(args.recordSession);
+        } else if (!args.replaySession.empty()) {
+            std::cout << "⏵  Replaying session " << args.replaySession
+                      << (args.replayRealTime ? " in real time" : "") << "\n";
+            engine.ReplaySession(args.replaySession, args.replayRealTime);
+        }
+        engine.SetParallelSubmission(args.parallelSubmit);
+        engine.SetOcclusionCulling(args.occlusionCull);
+        engine.SetFiberJobs(args.fiberJobs);
+        
         std::cout << "🚀 INITIALIZING ENGINE...\n";
         auto startTime = std::chrono::high_resolution_clock::now();
         
@@ -235,6 +402,20 @@ int main(int argc, char* argv[]) {
         
         std::cout << "✅ Engine initialized successfully in " << duration.count() << "ms\n\n";
         
+        if (args.serverPort != 0) {
+            if (!engine.HostServer(static_cast<uint16_t>(args.serverPort), args.maxClients)) {
+                std::cerr << "❌ Failed to start server on port " << args.serverPort << "\n";
+                return -1;
+            }
+            std::cout << "🌐 Serving up to " << args.maxClients << " clients on UDP port " << args.serverPort << "\n\n";
+        } else if (!args.connectHost.empty()) {
+            if (!engine.ConnectToServer(args.connectHost, static_cast<uint16_t>(args.connectPort))) {
+                std::cerr << "❌ Failed to connect to " << args.connectHost << ":" << args.connectPort << "\n";
+                return -1;
+            }
+            std::cout << "🌐 Connecting to " << args.connectHost << ":" << args.connectPort << "\n\n";
+        }
+        
         // Execute Python script if provided
         if (!args.scriptFile.empty()) {
 #ifdef NEXUS_PYTHON_ENABLED
@@ -259,11 +440,13 @@ int main(int argc, char* argv[]) {
 #endif
         } else {
             std::cout << "🎮 Starting with built-in physics demo\n\n";
-            PrintControls();
+            if (!args.headless) {
+                PrintControls();
+            }
         }
         
         std::cout << "▶️  STARTING MAIN LOOP...\n";
-        std::cout << "   (Press ESC to exit)\n\n";
+        std::cout << (args.headless ? "   (Press Ctrl+C to exit)\n\n" : "   (Press ESC to exit)\n\n");
         std::cout.flush();
         
         // Start the main game loop
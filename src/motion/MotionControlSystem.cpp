@@ -1,22 +1,70 @@
 #include "MotionControlSystem.h"
+#include "JobSystem.h"
 #include "Logger.h"
 #include <algorithm>
 #include <cmath>
 #include <chrono>
+#include <cstring>
+#include <limits>
+#include <xmmintrin.h>
 
 namespace Nexus {
 
+namespace {
+
+// Kinect v2 delivers body frames at 30 Hz
+constexpr double BODY_FRAME_INTERVAL = 1.0 / 30.0;
+
+// One Euro defaults for joints in metres
+constexpr float FILTER_MIN_CUTOFF = 1.0f;
+constexpr float FILTER_BETA = 2.0f;
+constexpr float FILTER_DERIVATIVE_CUTOFF = 1.0f;
+
+constexpr size_t SIMD_WIDTH = 4;
+constexpr size_t DIMENSIONS = GestureRecognizer::MAX_GESTURE_JOINTS * 3;
+constexpr size_t SAMPLES = GestureRecognizer::TEMPLATE_SAMPLES;
+// Sakoe-Chiba band half width in samples
+constexpr size_t WARP_BAND = 4;
+// Frames queued while a match job runs; the oldest are dropped beyond this
+constexpr size_t PENDING_CAPACITY = 32;
+constexpr float PI = 3.14159265f;
+
+float SmoothingAlpha(float cutoff, float deltaTime) {
+    float rate = 2.0f * PI * cutoff * deltaTime;
+    return rate / (rate + 1.0f);
+}
+
+} // namespace
+
+/**
+ * Up to SIMD_WIDTH templates resampled to SAMPLES frames, lane per template, with the running
+ * max and min over the warping band for LB_Keogh
+ */
+struct GestureRecognizer::TemplateGroup {
+    __m128 samples[SAMPLES][DIMENSIONS];
+    __m128 upper[SAMPLES][DIMENSIONS];
+    __m128 lower[SAMPLES][DIMENSIONS];
+    float limit[SIMD_WIDTH];               // threshold^2 * SAMPLES, the largest accepted cost
+    size_t patterns[SIMD_WIDTH];
+    size_t laneCount;
+};
+
 MotionControlSystem::MotionControlSystem()
     : kinectSensor_(nullptr)
     , coordinateMapper_(nullptr)
     , bodyFrameReader_(nullptr)
     , gestureRecognizer_(nullptr)
+    , jobs_(nullptr)
     , isInitialized_(false)
     , calibrationMode_(false)
     , motionSensitivity_(1.0f)
     , aimingSmoothing_(0.8f)
     , gestureThreshold_(0.7f)
+    , trackingTime_(0.0)
+    , lastBodyFrameTime_(0.0)
+    , jointHistory_(std::make_unique<JointHistory>())
 {
+    jointFilter_.SetParameters(FILTER_MIN_CUTOFF, FILTER_BETA, FILTER_DERIVATIVE_CUTOFF);
 }
 
 MotionControlSystem::~MotionControlSystem() {
@@ -79,14 +127,21 @@ void MotionControlSystem::Shutdown() {
     Logger::Info("Motion control system shut down");
 }
 
+void MotionControlSystem::SetJobSystem(JobSystem* jobs) {
+    jobs_ = jobs;
+    if (gestureRecognizer_) {
+        gestureRecognizer_->SetJobSystem(jobs);
+    }
+}
+
 void MotionControlSystem::Update(float deltaTime) {
     if (!isInitialized_) return;
     
     // Update Kinect body tracking
-    UpdateBodyTracking();
+    bool newBodyFrame = UpdateBodyTracking(deltaTime);
     
     // Update gesture recognition
-    UpdateGestureRecognition(deltaTime);
+    UpdateGestureRecognition(newBodyFrame);
     
     // Update motion-based aiming
     UpdateMotionAiming(deltaTime);
@@ -113,70 +168,73 @@ bool MotionControlSystem::InitializeKinect() {
 }
 
 bool MotionControlSystem::InitializeGestureRecognition() {
-    // Temporarily disable gesture recognition to isolate crash
-    Logger::Info("Gesture recognition initialized (disabled for debugging)");
+    if (!gestureRecognizer_) {
+        gestureRecognizer_ = new GestureRecognizer();
+    }
+    gestureRecognizer_->SetJobSystem(jobs_);
+    DefineGesturePatterns();
+    
+    Logger::Info("Gesture recognition initialized");
     return true;
 }
 
 void MotionControlSystem::InitializeMotionTracking() {
-    // Initialize motion tracking parameters
-    motionFilter_.windowSize = 5;
-    motionFilter_.weights = { 0.1f, 0.2f, 0.4f, 0.2f, 0.1f };
-    
-    // Initialize joint tracking - resize vectors first!
-    int jointCount = static_cast<int>(JointType::Count);
-    trackedJoints_.resize(jointCount);
-    jointConfidence_.resize(jointCount);
-    
-    for (int i = 0; i < jointCount; i++) {
+    // Initialize joint tracking
+    for (size_t i = 0; i < JointHistory::JOINT_COUNT; i++) {
         trackedJoints_[i] = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
         jointConfidence_[i] = 0.0f;
     }
+    jointFilter_.Reset();
+    jointHistory_->Clear();
     
     Logger::Info("Motion tracking initialized");
 }
 
-void MotionControlSystem::UpdateBodyTracking() {
+bool MotionControlSystem::UpdateBodyTracking(float deltaTime) {
     // Update body tracking data from Kinect
     // This would normally read from Kinect body frame
-    
-    // Simulated body tracking update
-    static float time = 0.0f;
-    time += 0.016f; // Simulate 60 FPS
+    trackingTime_ += deltaTime;
+    if (trackingTime_ - lastBodyFrameTime_ < BODY_FRAME_INTERVAL) {
+        return false;
+    }
+    float frameDelta = static_cast<float>(trackingTime_ - lastBodyFrameTime_);
+    lastBodyFrameTime_ = trackingTime_;
     
     // Simulate hand movement for demonstration
-    trackedJoints_[static_cast<int>(JointType::HandRight)] = DirectX::XMFLOAT3(
+    DirectX::XMFLOAT3 joints[JointHistory::JOINT_COUNT] = {};
+    float time = static_cast<float>(trackingTime_);
+    joints[static_cast<int>(JointType::HandRight)] = DirectX::XMFLOAT3(
         sinf(time) * 0.5f,
         cosf(time * 0.5f) * 0.3f + 1.0f,
         2.0f
     );
     
-    trackedJoints_[static_cast<int>(JointType::HandLeft)] = DirectX::XMFLOAT3(
+    joints[static_cast<int>(JointType::HandLeft)] = DirectX::XMFLOAT3(
         -sinf(time) * 0.5f,
         cosf(time * 0.5f) * 0.3f + 1.0f,
         2.0f
     );
     
+    jointFilter_.Filter(joints, frameDelta);
+    std::copy(joints, joints + JointHistory::JOINT_COUNT, trackedJoints_);
+    jointHistory_->Push(trackedJoints_, trackingTime_);
+    
     // Update confidence values
     jointConfidence_[static_cast<int>(JointType::HandRight)] = 0.9f;
     jointConfidence_[static_cast<int>(JointType::HandLeft)] = 0.9f;
+    return true;
 }
 
-void MotionControlSystem::UpdateGestureRecognition(float deltaTime) {
+void MotionControlSystem::UpdateGestureRecognition(bool newBodyFrame) {
     if (!gestureRecognizer_) return;
     
-    // Collect joint positions for gesture recognition
-    std::vector<DirectX::XMFLOAT3> keyJoints;
-    keyJoints.push_back(trackedJoints_[static_cast<int>(JointType::HandRight)]);
-    keyJoints.push_back(trackedJoints_[static_cast<int>(JointType::HandLeft)]);
-    keyJoints.push_back(trackedJoints_[static_cast<int>(JointType::Head)]);
-    
-    // Update gesture recognition
-    gestureRecognizer_->Update(keyJoints, deltaTime);
+    // Matching runs off this thread; only the new frame is handed over
+    if (newBodyFrame) {
+        gestureRecognizer_->Update(trackedJoints_, trackingTime_);
+    }
     
-    // Check for recognized gestures
-    auto recognizedGestures = gestureRecognizer_->GetRecognizedGestures();
-    for (const auto& gesture : recognizedGestures) {
+    // Results of the match that finished since the last frame
+    for (const auto& gesture : gestureRecognizer_->TakeRecognizedGestures()) {
         if (gesture.confidence > gestureThreshold_) {
             HandleGesture(gesture);
         }
@@ -184,12 +242,9 @@ void MotionControlSystem::UpdateGestureRecognition(float deltaTime) {
 }
 
 void MotionControlSystem::UpdateMotionAiming(float deltaTime) {
-    // Get hand position for aiming
+    // Get hand position for aiming, already One Euro filtered
     DirectX::XMFLOAT3 rightHand = trackedJoints_[static_cast<int>(JointType::HandRight)];
     
-    // Apply motion filtering for smoother aiming
-    ApplyMotionFiltering(rightHand);
-    
     // Convert hand position to aiming direction
     DirectX::XMFLOAT3 aimDirection = CalculateAimDirection(rightHand);
     
@@ -213,27 +268,53 @@ void MotionControlSystem::UpdateMotionControls(float deltaTime) {
 void MotionControlSystem::DefineGesturePatterns() {
     if (!gestureRecognizer_) return;
     
-    // Define punch gesture
+    // Define punch gesture: the right hand drives forward, fast at first
     GesturePattern punchPattern;
     punchPattern.name = "Punch";
+    punchPattern.type = GestureType::Custom;
     punchPattern.jointSequence = { JointType::HandRight };
-    punchPattern.motionThreshold = 2.0f;
+    for (int i = 0; i < 8; i++) {
+        float t = i / 7.0f;
+        float reach = 1.0f - (1.0f - t) * (1.0f - t);
+        punchPattern.keyPositions.push_back(DirectX::XMFLOAT3(0.0f, 0.05f * reach, -0.45f * reach));
+    }
+    punchPattern.minDuration = 0.1f;
+    punchPattern.maxDuration = 0.5f;
+    punchPattern.threshold = 0.15f;
+    punchPattern.motionThreshold = 0.3f;
     punchPattern.timeWindow = 0.5f;
     gestureRecognizer_->AddPattern(punchPattern);
     
-    // Define grab gesture
+    // Define grab gesture: both hands close in from shoulder width
     GesturePattern grabPattern;
     grabPattern.name = "Grab";
+    grabPattern.type = GestureType::Custom;
     grabPattern.jointSequence = { JointType::HandRight, JointType::HandLeft };
-    grabPattern.motionThreshold = 0.5f;
+    for (int i = 0; i < 8; i++) {
+        float spread = 0.4f - 0.35f * (i / 7.0f);
+        grabPattern.keyPositions.push_back(DirectX::XMFLOAT3(spread, 0.0f, 0.0f));
+        grabPattern.keyPositions.push_back(DirectX::XMFLOAT3(-spread, 0.0f, 0.0f));
+    }
+    grabPattern.minDuration = 0.3f;
+    grabPattern.maxDuration = 1.0f;
+    grabPattern.threshold = 0.15f;
+    grabPattern.motionThreshold = 0.25f;
     grabPattern.timeWindow = 1.0f;
     gestureRecognizer_->AddPattern(grabPattern);
     
-    // Define wave gesture
+    // Define wave gesture: two side to side swings of the raised right hand
     GesturePattern wavePattern;
     wavePattern.name = "Wave";
+    wavePattern.type = GestureType::Shake;
     wavePattern.jointSequence = { JointType::HandRight };
-    wavePattern.motionThreshold = 1.0f;
+    for (int i = 0; i < 24; i++) {
+        float phase = 2.0f * PI * 2.0f * (i / 23.0f);
+        wavePattern.keyPositions.push_back(DirectX::XMFLOAT3(0.15f * sinf(phase), 0.03f * (1.0f - cosf(2.0f * phase)), 0.0f));
+    }
+    wavePattern.minDuration = 1.0f;
+    wavePattern.maxDuration = 2.0f;
+    wavePattern.threshold = 0.1f;
+    wavePattern.motionThreshold = 0.4f;
     wavePattern.timeWindow = 2.0f;
     gestureRecognizer_->AddPattern(wavePattern);
 }
@@ -287,34 +368,6 @@ void MotionControlSystem::HandleWaveGesture(const RecognizedGesture& gesture) {
     motionEvents_.push_back(event);
 }
 
-void MotionControlSystem::ApplyMotionFiltering(DirectX::XMFLOAT3& position) {
-    // Apply motion filter to reduce noise
-    motionFilter_.positions.push_back(position);
-    
-    if (motionFilter_.positions.size() > motionFilter_.windowSize) {
-        motionFilter_.positions.erase(motionFilter_.positions.begin());
-    }
-    
-    // Calculate weighted average
-    DirectX::XMFLOAT3 filteredPosition(0.0f, 0.0f, 0.0f);
-    float totalWeight = 0.0f;
-    
-    for (size_t i = 0; i < motionFilter_.positions.size(); i++) {
-        float weight = (i < motionFilter_.weights.size()) ? motionFilter_.weights[i] : 1.0f;
-        filteredPosition.x += motionFilter_.positions[i].x * weight;
-        filteredPosition.y += motionFilter_.positions[i].y * weight;
-        filteredPosition.z += motionFilter_.positions[i].z * weight;
-        totalWeight += weight;
-    }
-    
-    if (totalWeight > 0.0f) {
-        filteredPosition.x /= totalWeight;
-        filteredPosition.y /= totalWeight;
-        filteredPosition.z /= totalWeight;
-        position = filteredPosition;
-    }
-}
-
 DirectX::XMFLOAT3 MotionControlSystem::CalculateAimDirection(const DirectX::XMFLOAT3& handPosition) {
     // Calculate aiming direction based on hand position
     // This is a simplified calculation - in reality, you'd use both hands and body orientation
@@ -437,35 +490,371 @@ bool MotionControlSystem::IsCalibrating() const {
     return calibrationMode_;
 }
 
+// JointHistory implementations
+void JointHistory::Push(const DirectX::XMFLOAT3* joints, double timestamp) {
+    for (size_t joint = 0; joint < JOINT_COUNT; joint++) {
+        x[joint][head] = joints[joint].x;
+        y[joint][head] = joints[joint].y;
+        z[joint][head] = joints[joint].z;
+    }
+    time[head] = timestamp;
+    head = (head + 1) % CAPACITY;
+    count = std::min(count + 1, CAPACITY);
+}
+
+void JointHistory::Resample(size_t joint, double start, double end, size_t samples,
+                            float* outX, float* outY, float* outZ) const {
+    if (count == 0) {
+        std::fill(outX, outX + samples, 0.0f);
+        std::fill(outY, outY + samples, 0.0f);
+        std::fill(outZ, outZ + samples, 0.0f);
+        return;
+    }
+    
+    // Samples rise in time, so one cursor walks the frames oldest first
+    size_t oldest = (head + CAPACITY - count) % CAPACITY;
+    size_t frame = 0;
+    for (size_t i = 0; i < samples; i++) {
+        double t = samples > 1 ? start + (end - start) * i / (samples - 1) : end;
+        while (frame + 1 < count && time[(oldest + frame + 1) % CAPACITY] <= t) {
+            frame++;
+        }
+        
+        size_t a = (oldest + frame) % CAPACITY;
+        if (frame + 1 >= count || t <= time[a]) {
+            outX[i] = x[joint][a];
+            outY[i] = y[joint][a];
+            outZ[i] = z[joint][a];
+            continue;
+        }
+        size_t b = (a + 1) % CAPACITY;
+        float weight = static_cast<float>((t - time[a]) / (time[b] - time[a]));
+        outX[i] = x[joint][a] + (x[joint][b] - x[joint][a]) * weight;
+        outY[i] = y[joint][a] + (y[joint][b] - y[joint][a]) * weight;
+        outZ[i] = z[joint][a] + (z[joint][b] - z[joint][a]) * weight;
+    }
+}
+
+// JointFilter implementations
+JointFilter::JointFilter()
+    : minCutoff_(FILTER_MIN_CUTOFF)
+    , beta_(FILTER_BETA)
+    , derivativeCutoff_(FILTER_DERIVATIVE_CUTOFF)
+    , primed_(false)
+{
+}
+
+void JointFilter::SetParameters(float minCutoff, float beta, float derivativeCutoff) {
+    minCutoff_ = std::max(minCutoff, 0.001f);
+    beta_ = std::max(beta, 0.0f);
+    derivativeCutoff_ = std::max(derivativeCutoff, 0.001f);
+}
+
+void JointFilter::Filter(DirectX::XMFLOAT3* joints, float deltaTime) {
+    // XMFLOAT3 is three packed floats, so the joints are CHANNEL_COUNT independent channels
+    float* channels = &joints[0].x;
+    if (!primed_) {
+        std::memcpy(value_, channels, sizeof(value_));
+        std::fill(derivative_, derivative_ + CHANNEL_COUNT, 0.0f);
+        primed_ = true;
+        return;
+    }
+    if (deltaTime <= 0.0f) {
+        std::memcpy(channels, value_, sizeof(value_));
+        return;
+    }
+    
+    float derivativeAlpha = SmoothingAlpha(derivativeCutoff_, deltaTime);
+    float inverseDelta = 1.0f / deltaTime;
+    for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+        float rate = (channels[i] - value_[i]) * inverseDelta;
+        derivative_[i] += derivativeAlpha * (rate - derivative_[i]);
+        float alpha = SmoothingAlpha(minCutoff_ + beta_ * std::fabs(derivative_[i]), deltaTime);
+        value_[i] += alpha * (channels[i] - value_[i]);
+        channels[i] = value_[i];
+    }
+}
+
 // GestureRecognizer implementations
-void GestureRecognizer::AddPattern(const GesturePattern& pattern) {
-    patterns_.push_back(pattern);
+GestureRecognizer::GestureRecognizer()
+    : jobs_(nullptr)
+    , matchCounter_(std::make_unique<JobCounter>())
+    , history_(std::make_unique<JointHistory>())
+{
+    pending_.reserve(PENDING_CAPACITY);
+    draining_.reserve(PENDING_CAPACITY);
 }
 
-std::vector<RecognizedGesture> GestureRecognizer::GetRecognizedGestures() const {
-    return recognizedGestures_;
+GestureRecognizer::~GestureRecognizer() {
+    WaitForMatch();
 }
 
-void GestureRecognizer::ProcessJoints(const std::vector<DirectX::XMFLOAT3>& joints) {
-    currentJoints_ = joints;
-    // Basic gesture processing logic would go here
+bool GestureRecognizer::AddPattern(const GesturePattern& pattern) {
+    size_t jointCount = std::min(pattern.jointSequence.size(), MAX_GESTURE_JOINTS);
+    if (jointCount == 0 || pattern.keyPositions.size() < 2 * pattern.jointSequence.size() ||
+        pattern.threshold <= 0.0f || pattern.timeWindow <= 0.0f) {
+        Logger::Warning("Gesture pattern rejected: " + pattern.name);
+        return false;
+    }
+    if (pattern.jointSequence.size() > MAX_GESTURE_JOINTS) {
+        Logger::Warning("Gesture pattern " + pattern.name + " uses only its first " +
+                        std::to_string(MAX_GESTURE_JOINTS) + " joints");
+    }
+    
+    // Groups are read by the match job
+    WaitForMatch();
+    
+    size_t index = patterns_.size();
+    patterns_.push_back(pattern);
+    lastRecognized_.push_back(-std::numeric_limits<double>::infinity());
+    candidates_.emplace_back();
+    if (index % SIMD_WIDTH == 0) {
+        groups_.push_back(std::make_unique<TemplateGroup>());
+        std::memset(groups_.back().get(), 0, sizeof(TemplateGroup));
+    }
+    TemplateGroup& group = *groups_.back();
+    size_t lane = group.laneCount++;
+    group.patterns[lane] = index;
+    group.limit[lane] = pattern.threshold * pattern.threshold * SAMPLES;
+    
+    // Resample to SAMPLES frames relative to the first joint's start
+    size_t stride = pattern.jointSequence.size();
+    size_t frames = pattern.keyPositions.size() / stride;
+    const DirectX::XMFLOAT3& origin = pattern.keyPositions[0];
+    float* samples = reinterpret_cast<float*>(group.samples);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        float position = static_cast<float>(i * (frames - 1)) / (SAMPLES - 1);
+        size_t a = std::min(static_cast<size_t>(position), frames - 2);
+        float weight = position - a;
+        for (size_t slot = 0; slot < jointCount; slot++) {
+            const DirectX::XMFLOAT3& from = pattern.keyPositions[a * stride + slot];
+            const DirectX::XMFLOAT3& to = pattern.keyPositions[(a + 1) * stride + slot];
+            float* out = samples + (i * DIMENSIONS + slot * 3) * SIMD_WIDTH + lane;
+            out[0] = from.x + (to.x - from.x) * weight - origin.x;
+            out[SIMD_WIDTH] = from.y + (to.y - from.y) * weight - origin.y;
+            out[2 * SIMD_WIDTH] = from.z + (to.z - from.z) * weight - origin.z;
+        }
+    }
+    
+    // Envelope over the band; a query frame can only be matched to template frames inside it
+    for (size_t i = 0; i < SAMPLES; i++) {
+        size_t first = i > WARP_BAND ? i - WARP_BAND : 0;
+        size_t last = std::min(i + WARP_BAND, SAMPLES - 1);
+        for (size_t d = 0; d < DIMENSIONS; d++) {
+            float high = -std::numeric_limits<float>::max();
+            float low = std::numeric_limits<float>::max();
+            for (size_t j = first; j <= last; j++) {
+                float value = samples[(j * DIMENSIONS + d) * SIMD_WIDTH + lane];
+                high = std::max(high, value);
+                low = std::min(low, value);
+            }
+            reinterpret_cast<float*>(&group.upper[i][d])[lane] = high;
+            reinterpret_cast<float*>(&group.lower[i][d])[lane] = low;
+        }
+    }
+    return true;
 }
 
-void GestureRecognizer::Update(const std::vector<DirectX::XMFLOAT3>& joints, float deltaTime) {
-    ProcessJoints(joints);
+void GestureRecognizer::SetJobSystem(JobSystem* jobs) {
+    WaitForMatch();
+    jobs_ = jobs;
+}
+
+void GestureRecognizer::Update(const DirectX::XMFLOAT3* joints, double time) {
+    if (groups_.empty()) return;
     
-    // Simple gesture recognition logic
-    recognizedGestures_.clear();
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        if (pending_.size() == PENDING_CAPACITY) {
+            pending_.erase(pending_.begin());
+        }
+        pending_.emplace_back();
+        PendingFrame& frame = pending_.back();
+        std::copy(joints, joints + JointHistory::JOINT_COUNT, frame.joints);
+        frame.time = time;
+    }
     
-    // For now, just a placeholder implementation
-    // Real gesture recognition would analyze joint movements over time
+    if (!jobs_) {
+        MatchPending();
+        return;
+    }
+    // A running match picks these frames up next time
+    if (matchCounter_->IsDone()) {
+        jobs_->Execute([this]() { MatchPending(); }, matchCounter_.get());
+    }
+}
+
+std::vector<RecognizedGesture> GestureRecognizer::TakeRecognizedGestures() {
+    std::vector<RecognizedGesture> gestures;
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    gestures.swap(results_);
+    return gestures;
 }
 
 void GestureRecognizer::Reset() {
-    recognizedGestures_.clear();
-    currentJoints_.clear();
-    gestureStartTime_ = 0.0f;
-    isRecognizing_ = false;
+    WaitForMatch();
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(resultMutex_);
+        results_.clear();
+    }
+    history_->Clear();
+    std::fill(lastRecognized_.begin(), lastRecognized_.end(), -std::numeric_limits<double>::infinity());
+    for (Candidate& candidate : candidates_) {
+        candidate.valid = false;
+    }
+}
+
+void GestureRecognizer::WaitForMatch() {
+    if (jobs_) {
+        jobs_->Wait(*matchCounter_);
+    }
+}
+
+void GestureRecognizer::MatchPending() {
+    {
+        // Both keep their capacity, so the swap never allocates
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        draining_.swap(pending_);
+    }
+    if (draining_.empty()) return;
+    for (const PendingFrame& frame : draining_) {
+        history_->Push(frame.joints, frame.time);
+    }
+    draining_.clear();
+    
+    double now = history_->GetTime(0);
+    for (auto& group : groups_) {
+        MatchGroup(*group, now);
+    }
+}
+
+void GestureRecognizer::MatchGroup(const TemplateGroup& group, double now) {
+    // Query windows, laid out like the templates; lanes that cannot match keep a zero limit
+    alignas(16) float query[SAMPLES][DIMENSIONS][SIMD_WIDTH] = {};
+    alignas(16) float limits[SIMD_WIDTH] = {};
+    alignas(16) float trajectory[3][SAMPLES];
+    double oldest = history_->GetTime(history_->count - 1);
+    
+    for (size_t lane = 0; lane < group.laneCount; lane++) {
+        size_t index = group.patterns[lane];
+        const GesturePattern& pattern = patterns_[index];
+        double start = now - pattern.timeWindow;
+        if (start < oldest || now - lastRecognized_[index] < pattern.timeWindow) continue;
+        
+        size_t jointCount = std::min(pattern.jointSequence.size(), MAX_GESTURE_JOINTS);
+        float origin[3] = {};
+        float travel = 0.0f;
+        for (size_t slot = 0; slot < jointCount; slot++) {
+            history_->Resample(static_cast<size_t>(pattern.jointSequence[slot]), start, now, SAMPLES,
+                               trajectory[0], trajectory[1], trajectory[2]);
+            if (slot == 0) {
+                for (int axis = 0; axis < 3; axis++) origin[axis] = trajectory[axis][0];
+                for (size_t i = 1; i < SAMPLES; i++) {
+                    float dx = trajectory[0][i] - trajectory[0][i - 1];
+                    float dy = trajectory[1][i] - trajectory[1][i - 1];
+                    float dz = trajectory[2][i] - trajectory[2][i - 1];
+                    travel += std::sqrt(dx * dx + dy * dy + dz * dz);
+                }
+            }
+            for (size_t i = 0; i < SAMPLES; i++) {
+                for (int axis = 0; axis < 3; axis++) {
+                    query[i][slot * 3 + axis][lane] = trajectory[axis][i] - origin[axis];
+                }
+            }
+        }
+        
+        // Idle joints never reach the DTW
+        if (travel >= pattern.motionThreshold) {
+            limits[lane] = group.limit[lane];
+        }
+    }
+    
+    // Bit per lane whose DTW cost ends within its limit
+    alignas(16) float costs[SIMD_WIDTH];
+    auto score = [&]() -> int {
+        const __m128 zero = _mm_setzero_ps();
+        __m128 limit = _mm_load_ps(limits);
+        if (_mm_movemask_ps(_mm_cmpgt_ps(limit, zero)) == 0) return 0;
+        
+        // LB_Keogh: distance from each query frame to the template's envelope bounds DTW from below
+        __m128 bound = zero;
+        for (size_t i = 0; i < SAMPLES; i++) {
+            for (size_t d = 0; d < DIMENSIONS; d++) {
+                __m128 value = _mm_load_ps(query[i][d]);
+                __m128 above = _mm_max_ps(_mm_sub_ps(value, group.upper[i][d]), zero);
+                __m128 below = _mm_max_ps(_mm_sub_ps(group.lower[i][d], value), zero);
+                bound = _mm_add_ps(bound, _mm_add_ps(_mm_mul_ps(above, above), _mm_mul_ps(below, below)));
+            }
+        }
+        limit = _mm_and_ps(limit, _mm_cmplt_ps(bound, limit));
+        if (_mm_movemask_ps(_mm_cmpgt_ps(limit, zero)) == 0) return 0;
+        
+        // DTW inside the band over two rows; cell j of a row is template frame j - 1
+        const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        __m128 rows[2][SAMPLES + 1];
+        __m128* previous = rows[0];
+        __m128* current = rows[1];
+        for (size_t j = 0; j <= SAMPLES; j++) previous[j] = infinity;
+        previous[0] = zero;
+        
+        for (size_t i = 1; i <= SAMPLES; i++) {
+            for (size_t j = 0; j <= SAMPLES; j++) current[j] = infinity;
+            size_t first = i > WARP_BAND ? i - WARP_BAND : 1;
+            size_t last = std::min(i + WARP_BAND, SAMPLES);
+            __m128 rowMinimum = infinity;
+            for (size_t j = first; j <= last; j++) {
+                __m128 cost = zero;
+                for (size_t d = 0; d < DIMENSIONS; d++) {
+                    __m128 delta = _mm_sub_ps(_mm_load_ps(query[i - 1][d]), group.samples[j - 1][d]);
+                    cost = _mm_add_ps(cost, _mm_mul_ps(delta, delta));
+                }
+                __m128 best = _mm_min_ps(previous[j - 1], _mm_min_ps(previous[j], current[j - 1]));
+                current[j] = _mm_add_ps(cost, best);
+                rowMinimum = _mm_min_ps(rowMinimum, current[j]);
+            }
+            // Costs only grow along a path, so a row past every limit ends the match
+            if (_mm_movemask_ps(_mm_cmplt_ps(rowMinimum, limit)) == 0) return 0;
+            std::swap(previous, current);
+        }
+        
+        _mm_store_ps(costs, previous[SAMPLES]);
+        return _mm_movemask_ps(_mm_cmplt_ps(previous[SAMPLES], limit));
+    };
+    int matched = score();
+    
+    // A match is held while later windows fit better, so it is reported at its best alignment
+    for (size_t lane = 0; lane < group.laneCount; lane++) {
+        size_t index = group.patterns[lane];
+        const GesturePattern& pattern = patterns_[index];
+        Candidate& candidate = candidates_[index];
+        
+        if ((matched & (1 << lane)) && (!candidate.valid || costs[lane] < candidate.cost)) {
+            size_t joint = static_cast<size_t>(pattern.jointSequence[0]);
+            size_t newest = history_->GetSlot(0);
+            DirectX::XMFLOAT3 direction(query[SAMPLES - 1][0][lane], query[SAMPLES - 1][1][lane], query[SAMPLES - 1][2][lane]);
+            DirectX::XMStoreFloat3(&direction, DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&direction)));
+            
+            RecognizedGesture& gesture = candidate.gesture;
+            gesture.name = pattern.name;
+            gesture.type = pattern.type;
+            gesture.confidence = 1.0f - std::sqrt(costs[lane] / SAMPLES) / pattern.threshold;
+            gesture.position = DirectX::XMFLOAT3(history_->x[joint][newest], history_->y[joint][newest], history_->z[joint][newest]);
+            gesture.direction = direction;
+            gesture.duration = pattern.timeWindow;
+            gesture.jointSequence = pattern.jointSequence;
+            candidate.cost = costs[lane];
+            candidate.valid = true;
+        } else if (candidate.valid) {
+            lastRecognized_[index] = now;
+            candidate.valid = false;
+            std::lock_guard<std::mutex> lock(resultMutex_);
+            results_.push_back(candidate.gesture);
+        }
+    }
 }
 
-} // namespace Nexus
+} // namespace Nexus
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "EngineConfig.h"
+
+#ifdef NEXUS_NETWORKING_ENABLED
+
+#include "NetBitStream.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Nexus {
+
+namespace {
+
+// Smallest-three components lie in [-1/sqrt(2), 1/sqrt(2)]
+constexpr float SMALLEST_THREE_RANGE = 0.70710678f;
+constexpr uint32_t ROTATION_COMPONENT_BITS = 10;
+
+uint32_t QuantizeUnit(float value, float min, float max, uint32_t bits) {
+    const uint32_t maxValue = bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+    float normalized = (std::min(std::max(value, min), max) - min) / (max - min);
+    return static_cast<uint32_t>(normalized * maxValue + 0.5f);
+}
+
+float DequantizeUnit(uint32_t value, float min, float max, uint32_t bits) {
+    const uint32_t maxValue = bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+    return min + (max - min) * (static_cast<float>(value) / maxValue);
+}
+
+} // namespace
+
+NetBitWriter::NetBitWriter(std::vector<uint8_t>& out)
+    : out_(out)
+    , scratch_(0)
+    , scratchBits_(0)
+    , bitCount_(0)
+{
+}
+
+void NetBitWriter::WriteBits(uint32_t value, uint32_t bits) {
+    if (bits == 0) return;
+    if (bits < 32) value &= (1u << bits) - 1;
+    scratch_ |= static_cast<uint64_t>(value) << scratchBits_;
+    scratchBits_ += bits;
+    bitCount_ += bits;
+    while (scratchBits_ >= 32) {
+        uint32_t word = static_cast<uint32_t>(scratch_);
+        for (int i = 0; i < 4; ++i) {
+            out_.push_back(static_cast<uint8_t>(word >> (i * 8)));
+        }
+        scratch_ >>= 32;
+        scratchBits_ -= 32;
+    }
+}
+
+void NetBitWriter::WriteVarint(uint32_t value) {
+    while (value >= 0x80) {
+        WriteBits((value & 0x7F) | 0x80, 8);
+        value >>= 7;
+    }
+    WriteBits(value, 8);
+}
+
+void NetBitWriter::WriteSignedVarint(int32_t value) {
+    WriteVarint((static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+}
+
+void NetBitWriter::WriteQuantized(float value, float min, float max, uint32_t bits) {
+    WriteBits(QuantizeUnit(value, min, max, bits), bits);
+}
+
+void NetBitWriter::Finish() {
+    while (scratchBits_ > 0) {
+        out_.push_back(static_cast<uint8_t>(scratch_));
+        scratch_ >>= 8;
+        scratchBits_ = scratchBits_ > 8 ? scratchBits_ - 8 : 0;
+    }
+}
+
+NetBitReader::NetBitReader(const uint8_t* data, size_t size)
+    : data_(data)
+    , size_(size)
+    , scratch_(0)
+    , scratchBits_(0)
+    , byteIndex_(0)
+    , bitCount_(0)
+    , totalBits_(size * 8)
+    , overflowed_(false)
+{
+}
+
+uint32_t NetBitReader::ReadBits(uint32_t bits) {
+    if (bits == 0) return 0;
+    if (bitCount_ + bits > totalBits_) {
+        overflowed_ = true;
+        bitCount_ = totalBits_;
+        return 0;
+    }
+    while (scratchBits_ < bits) {
+        scratch_ |= static_cast<uint64_t>(data_[byteIndex_++]) << scratchBits_;
+        scratchBits_ += 8;
+    }
+    uint32_t value = static_cast<uint32_t>(scratch_ & (bits >= 32 ? 0xFFFFFFFFull : (1ull << bits) - 1));
+    scratch_ >>= bits;
+    scratchBits_ -= bits;
+    bitCount_ += bits;
+    return value;
+}
+
+uint32_t NetBitReader::ReadVarint() {
+    uint32_t value = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7) {
+        uint32_t byte = ReadBits(8);
+        value |= (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    overflowed_ = true;
+    return 0;
+}
+
+int32_t NetBitReader::ReadSignedVarint() {
+    uint32_t value = ReadVarint();
+    return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1)));
+}
+
+float NetBitReader::ReadQuantized(float min, float max, uint32_t bits) {
+    return DequantizeUnit(ReadBits(bits), min, max, bits);
+}
+
+uint32_t NetQuantization::GetPositionBits(int axis) const {
+    const float extent = (&worldMax.x)[axis] - (&worldMin.x)[axis];
+    const double steps = std::max(static_cast<double>(extent) * resolution, 1.0);
+    return std::min(static_cast<uint32_t>(std::ceil(std::log2(steps + 1.0))), 31u);
+}
+
+QuantizedTransform NetQuantization::Quantize(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT4& rotation) const {
+    QuantizedTransform transform;
+    for (int axis = 0; axis < 3; ++axis) {
+        const float minimum = (&worldMin.x)[axis];
+        const float maximum = (&worldMax.x)[axis];
+        const float value = std::min(std::max((&position.x)[axis], minimum), maximum);
+        transform.position[axis] = static_cast<int32_t>(std::lround((value - minimum) * resolution));
+    }
+
+    // Drop the largest component; q and -q are the same rotation, so flip it positive
+    float q[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+    float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    if (length < 1e-6f) {
+        q[0] = q[1] = q[2] = 0.0f;
+        q[3] = length = 1.0f;
+    }
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; ++i) {
+        if (std::abs(q[i]) > std::abs(q[largest])) largest = i;
+    }
+    const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+    transform.rotation = largest << 30;
+    uint32_t shift = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+        if (i == largest) continue;
+        uint32_t component = QuantizeUnit(sign * q[i] / length, -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE,
+                                          ROTATION_COMPONENT_BITS);
+        transform.rotation |= component << shift;
+        shift += ROTATION_COMPONENT_BITS;
+    }
+    return transform;
+}
+
+void NetQuantization::Dequantize(const QuantizedTransform& transform, DirectX::XMFLOAT3& position,
+                                 DirectX::XMFLOAT4& rotation) const {
+    for (int axis = 0; axis < 3; ++axis) {
+        (&position.x)[axis] = (&worldMin.x)[axis] + transform.position[axis] / resolution;
+    }
+
+    const uint32_t largest = transform.rotation >> 30;
+    float q[4];
+    float sum = 0.0f;
+    uint32_t shift = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+        if (i == largest) continue;
+        uint32_t component = (transform.rotation >> shift) & ((1u << ROTATION_COMPONENT_BITS) - 1);
+        q[i] = DequantizeUnit(component, -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, ROTATION_COMPONENT_BITS);
+        sum += q[i] * q[i];
+        shift += ROTATION_COMPONENT_BITS;
+    }
+    q[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+    rotation = DirectX::XMFLOAT4(q[0], q[1], q[2], q[3]);
+}
+
+} // namespace Nexus
+
+#endif // NEXUS_NETWORKING_ENABLED
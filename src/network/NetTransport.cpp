@@ -0,0 +1,598 @@
+#include "EngineConfig.h"
+
+#ifdef NEXUS_NETWORKING_ENABLED
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include "NetTransport.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace Nexus {
+
+namespace {
+
+enum PacketType : uint8_t {
+    PACKET_CONNECT_REQUEST = 1,
+    PACKET_CONNECT_ACCEPT,
+    PACKET_CONNECT_DENIED,
+    PACKET_PAYLOAD,
+    PACKET_DISCONNECT
+};
+
+// Protocol id, type and salt; payloads add sequence, ack and ack bits
+constexpr size_t CONTROL_HEADER_SIZE = 4 + 1 + 8;
+constexpr size_t PAYLOAD_HEADER_SIZE = CONTROL_HEADER_SIZE + 2 + 2 + 4;
+// Flags, reliable id and length
+constexpr size_t MESSAGE_HEADER_SIZE = 1 + 2 + 2;
+constexpr uint8_t MESSAGE_RELIABLE = 1;
+
+constexpr double CONNECT_RESEND_INTERVAL = 0.25;
+constexpr double CONNECT_TIMEOUT = 5.0;
+constexpr double CONNECTION_TIMEOUT = 10.0;
+// Often enough that the other end's reliable messages are acked before it resends them
+constexpr double KEEP_ALIVE_INTERVAL = 0.1;
+constexpr double MIN_RESEND_DELAY = 0.05;
+constexpr int DISCONNECT_REPEATS = 3;
+
+// Servers with a hundred clients get bursts of a packet each in one tick
+constexpr int SOCKET_BUFFER_SIZE = 4 * 1024 * 1024;
+
+void Put16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void Put32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+void Put64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+uint16_t Get16(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t Get32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+uint64_t Get64(const uint8_t* data) {
+    return static_cast<uint64_t>(Get32(data)) | (static_cast<uint64_t>(Get32(data + 4)) << 32);
+}
+
+// Sequence numbers wrap; a is newer when it's less than half the range ahead
+bool SequenceGreater(uint16_t a, uint16_t b) {
+    return a != b && static_cast<uint16_t>(a - b) < 0x8000;
+}
+
+uint64_t AddressKey(uint32_t address, uint16_t port) {
+    return (static_cast<uint64_t>(address) << 16) | port;
+}
+
+uint64_t RandomSalt() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
+
+void WriteHeader(std::vector<uint8_t>& out, uint32_t protocolId, uint8_t type, uint64_t salt) {
+    out.clear();
+    Put32(out, protocolId);
+    out.push_back(type);
+    Put64(out, salt);
+}
+
+} // namespace
+
+NetTransport::NetTransport()
+    : socket_(static_cast<uintptr_t>(INVALID_SOCKET))
+    , server_(false)
+    , winsockStarted_(false)
+    , protocolId_(0)
+    , connectionCount_(0)
+    , epoch_(std::chrono::steady_clock::now())
+{
+}
+
+NetTransport::~NetTransport() {
+    Close();
+}
+
+double NetTransport::Now() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch_).count();
+}
+
+bool NetTransport::Listen(uint16_t port, uint32_t maxConnections, uint32_t protocolId) {
+    Close();
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        Logger::Error("NetTransport: WSAStartup failed");
+        return false;
+    }
+    winsockStarted_ = true;
+
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        Logger::Error("NetTransport: failed to create socket");
+        Close();
+        return false;
+    }
+    socket_ = static_cast<uintptr_t>(s);
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(s, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR) {
+        Logger::Error("NetTransport: failed to bind UDP port " + std::to_string(port));
+        Close();
+        return false;
+    }
+
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+    int bufferSize = SOCKET_BUFFER_SIZE;
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufferSize), sizeof(bufferSize));
+    setsockopt(s, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&bufferSize), sizeof(bufferSize));
+
+    server_ = true;
+    protocolId_ = protocolId;
+    connections_.resize(std::max(maxConnections, 1u));
+    for (Connection& connection : connections_) {
+        Reset(connection);
+    }
+    Logger::Info("NetTransport: listening on UDP port " + std::to_string(port) + " for up to " +
+                 std::to_string(connections_.size()) + " connections");
+    return true;
+}
+
+bool NetTransport::Connect(const std::string& host, uint16_t port, uint32_t protocolId) {
+    Close();
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        Logger::Error("NetTransport: WSAStartup failed");
+        return false;
+    }
+    winsockStarted_ = true;
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* resolved = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &resolved) != 0 || !resolved) {
+        Logger::Error("NetTransport: cannot resolve " + host);
+        Close();
+        return false;
+    }
+    uint32_t serverAddress = ntohl(reinterpret_cast<const sockaddr_in*>(resolved->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(resolved);
+
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        Logger::Error("NetTransport: failed to create socket");
+        Close();
+        return false;
+    }
+    socket_ = static_cast<uintptr_t>(s);
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+
+    server_ = false;
+    protocolId_ = protocolId;
+    connections_.resize(1);
+    Connection& connection = connections_[0];
+    Reset(connection);
+    connection.state = State::Connecting;
+    connection.address = serverAddress;
+    connection.port = port;
+    connection.salt = RandomSalt();
+    connection.connectStarted = Now();
+    connection.lastSent = -CONNECT_RESEND_INTERVAL;
+    connectionsByAddress_[AddressKey(serverAddress, port)] = 0;
+    Logger::Info("NetTransport: connecting to " + host + ":" + std::to_string(port));
+    return true;
+}
+
+void NetTransport::Close() {
+    if (socket_ != static_cast<uintptr_t>(INVALID_SOCKET)) {
+        for (ConnectionID id = 0; id < connections_.size(); ++id) {
+            if (connections_[id].state == State::Connected) {
+                Disconnect(id);
+            }
+        }
+        closesocket(static_cast<SOCKET>(socket_));
+        socket_ = static_cast<uintptr_t>(INVALID_SOCKET);
+    }
+    if (winsockStarted_) {
+        WSACleanup();
+        winsockStarted_ = false;
+    }
+    connections_.clear();
+    connectionsByAddress_.clear();
+    connectionCount_ = 0;
+    events_.clear();
+}
+
+void NetTransport::Reset(Connection& connection) {
+    connection = Connection();
+    connection.sentPackets.resize(SENT_PACKET_WINDOW);
+    connection.reliableReceived.resize(RELIABLE_WINDOW);
+    connection.reliableReceivedSet.assign(RELIABLE_WINDOW, false);
+}
+
+void NetTransport::Receive() {
+    if (socket_ == static_cast<uintptr_t>(INVALID_SOCKET)) return;
+
+    uint8_t buffer[MAX_PACKET_SIZE];
+    for (;;) {
+        sockaddr_in from = {};
+        int fromLength = sizeof(from);
+        int received = recvfrom(static_cast<SOCKET>(socket_), reinterpret_cast<char*>(buffer), sizeof(buffer), 0,
+                                reinterpret_cast<sockaddr*>(&from), &fromLength);
+        if (received == SOCKET_ERROR) {
+            // WSAECONNRESET is an ICMP port unreachable for an earlier send; the timeout handles it
+            int error = WSAGetLastError();
+            if (error == WSAEWOULDBLOCK) break;
+            if (error == WSAECONNRESET || error == WSAEMSGSIZE) continue;
+            break;
+        }
+        ++stats_.packetsReceived;
+        stats_.bytesReceived += received;
+        HandlePacket(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port), buffer, static_cast<size_t>(received));
+    }
+
+    const double now = Now();
+    for (ConnectionID id = 0; id < connections_.size(); ++id) {
+        Connection& connection = connections_[id];
+        if (connection.state == State::Connecting) {
+            if (now - connection.connectStarted > CONNECT_TIMEOUT) {
+                Logger::Warning("NetTransport: connection attempt timed out");
+                Drop(id, true);
+            } else if (now - connection.lastSent >= CONNECT_RESEND_INTERVAL) {
+                SendControl(connection, PACKET_CONNECT_REQUEST);
+                connection.lastSent = now;
+            }
+        } else if (connection.state == State::Connected && now - connection.lastReceived > CONNECTION_TIMEOUT) {
+            Logger::Info("NetTransport: connection " + std::to_string(id) + " timed out");
+            Drop(id, true);
+        }
+    }
+}
+
+bool NetTransport::PollEvent(Event& event) {
+    if (events_.empty()) return false;
+    event = std::move(events_.front());
+    events_.pop_front();
+    return true;
+}
+
+void NetTransport::HandlePacket(uint32_t address, uint16_t port, const uint8_t* data, size_t size) {
+    if (size < CONTROL_HEADER_SIZE || Get32(data) != protocolId_) {
+        ++stats_.packetsDropped;
+        return;
+    }
+    const uint8_t type = data[4];
+    const uint64_t salt = Get64(data + 5);
+    auto existing = connectionsByAddress_.find(AddressKey(address, port));
+    const ConnectionID id = existing != connectionsByAddress_.end() ? existing->second : INVALID_CONNECTION;
+
+    if (type == PACKET_CONNECT_REQUEST && server_) {
+        if (id != INVALID_CONNECTION) {
+            if (connections_[id].salt == salt) {
+                // The accept was lost
+                SendControl(connections_[id], PACKET_CONNECT_ACCEPT);
+                return;
+            }
+            // The client restarted on the same address
+            Drop(id, true);
+        }
+        auto free = std::find_if(connections_.begin(), connections_.end(),
+                                 [](const Connection& connection) { return connection.state == State::Free; });
+        if (free == connections_.end()) {
+            Connection denied;
+            denied.address = address;
+            denied.port = port;
+            denied.salt = salt;
+            SendControl(denied, PACKET_CONNECT_DENIED);
+            return;
+        }
+        const ConnectionID newId = static_cast<ConnectionID>(free - connections_.begin());
+        Connection& connection = *free;
+        Reset(connection);
+        connection.state = State::Connected;
+        connection.address = address;
+        connection.port = port;
+        connection.salt = salt;
+        connection.lastReceived = Now();
+        connectionsByAddress_[AddressKey(address, port)] = newId;
+        ++connectionCount_;
+        SendControl(connection, PACKET_CONNECT_ACCEPT);
+
+        Event event;
+        event.type = EventType::Connected;
+        event.connection = newId;
+        events_.push_back(std::move(event));
+        return;
+    }
+
+    if (id == INVALID_CONNECTION || connections_[id].salt != salt) {
+        ++stats_.packetsDropped;
+        return;
+    }
+    Connection& connection = connections_[id];
+    connection.lastReceived = Now();
+
+    switch (type) {
+    case PACKET_CONNECT_ACCEPT:
+        if (!server_ && connection.state == State::Connecting) {
+            connection.state = State::Connected;
+            ++connectionCount_;
+            Event event;
+            event.type = EventType::Connected;
+            event.connection = id;
+            events_.push_back(std::move(event));
+        }
+        break;
+    case PACKET_CONNECT_DENIED:
+        if (!server_ && connection.state == State::Connecting) {
+            Logger::Warning("NetTransport: server is full");
+            Drop(id, true);
+        }
+        break;
+    case PACKET_PAYLOAD:
+        if (connection.state == State::Connected) {
+            HandlePayload(id, data, size);
+        }
+        break;
+    case PACKET_DISCONNECT:
+        Drop(id, true);
+        break;
+    default:
+        ++stats_.packetsDropped;
+        break;
+    }
+}
+
+void NetTransport::HandlePayload(ConnectionID id, const uint8_t* data, size_t size) {
+    Connection& connection = connections_[id];
+    if (size < PAYLOAD_HEADER_SIZE) {
+        ++stats_.packetsDropped;
+        return;
+    }
+    const uint8_t* header = data + CONTROL_HEADER_SIZE;
+    const uint16_t sequence = Get16(header);
+    const uint16_t ack = Get16(header + 2);
+    const uint32_t ackBits = Get32(header + 4);
+
+    // Record it for our acks; a packet already seen is a duplicate and is ignored whole
+    if (!connection.receivedAny || SequenceGreater(sequence, connection.remoteSequence)) {
+        uint16_t shift = connection.receivedAny ? static_cast<uint16_t>(sequence - connection.remoteSequence) : 0;
+        if (connection.receivedAny) {
+            connection.receivedBits = shift >= 32 ? 0 : (connection.receivedBits << shift);
+            if (shift <= 32) connection.receivedBits |= 1u << (shift - 1);
+        }
+        connection.remoteSequence = sequence;
+        connection.receivedAny = true;
+    } else {
+        uint16_t age = static_cast<uint16_t>(connection.remoteSequence - sequence);
+        if (age == 0 || age > 32 || (connection.receivedBits & (1u << (age - 1)))) {
+            return;
+        }
+        connection.receivedBits |= 1u << (age - 1);
+    }
+    ProcessAcks(connection, ack, ackBits);
+
+    const uint8_t* cursor = data + PAYLOAD_HEADER_SIZE;
+    const uint8_t* end = data + size;
+    while (end - cursor >= static_cast<ptrdiff_t>(MESSAGE_HEADER_SIZE)) {
+        const uint8_t flags = cursor[0];
+        const uint16_t reliableId = Get16(cursor + 1);
+        const uint16_t length = Get16(cursor + 3);
+        cursor += MESSAGE_HEADER_SIZE;
+        if (end - cursor < length) {
+            ++stats_.packetsDropped;
+            return;
+        }
+
+        if (!(flags & MESSAGE_RELIABLE)) {
+            Event event;
+            event.connection = id;
+            event.data.assign(cursor, cursor + length);
+            events_.push_back(std::move(event));
+        } else {
+            // Resent copies of delivered messages, and ones beyond the window, are dropped
+            const uint16_t ahead = static_cast<uint16_t>(reliableId - connection.nextDeliverId);
+            const size_t slot = reliableId % RELIABLE_WINDOW;
+            if (ahead < RELIABLE_WINDOW && !connection.reliableReceivedSet[slot]) {
+                connection.reliableReceived[slot].assign(cursor, cursor + length);
+                connection.reliableReceivedSet[slot] = true;
+            }
+        }
+        cursor += length;
+    }
+
+    // Deliver the in-order run
+    for (;;) {
+        const size_t slot = connection.nextDeliverId % RELIABLE_WINDOW;
+        if (!connection.reliableReceivedSet[slot]) break;
+        Event event;
+        event.connection = id;
+        event.data = std::move(connection.reliableReceived[slot]);
+        events_.push_back(std::move(event));
+        connection.reliableReceived[slot].clear();
+        connection.reliableReceivedSet[slot] = false;
+        ++connection.nextDeliverId;
+    }
+}
+
+void NetTransport::ProcessAcks(Connection& connection, uint16_t ack, uint32_t ackBits) {
+    const double now = Now();
+    for (uint32_t i = 0; i <= 32; ++i) {
+        if (i > 0 && !(ackBits & (1u << (i - 1)))) continue;
+        const uint16_t sequence = static_cast<uint16_t>(ack - i);
+        SentPacket& sent = connection.sentPackets[sequence % SENT_PACKET_WINDOW];
+        if (sent.sequence != sequence || sent.acked) continue;
+        sent.acked = true;
+        connection.roundTrip += (static_cast<float>(now - sent.time) - connection.roundTrip) * 0.1f;
+
+        if (connection.reliableQueue.empty()) continue;
+        const uint16_t firstId = connection.reliableQueue.front().id;
+        for (uint16_t reliableId : sent.reliableIds) {
+            const uint16_t index = static_cast<uint16_t>(reliableId - firstId);
+            if (index < connection.reliableQueue.size()) {
+                connection.reliableQueue[index].acked = true;
+            }
+        }
+    }
+    while (!connection.reliableQueue.empty() && connection.reliableQueue.front().acked) {
+        connection.reliableQueue.pop_front();
+    }
+}
+
+bool NetTransport::Send(ConnectionID id, const uint8_t* data, size_t size, bool reliable) {
+    if (id >= connections_.size() || connections_[id].state != State::Connected) return false;
+    if (size > MAX_MESSAGE_SIZE) {
+        Logger::Warning("NetTransport: message of " + std::to_string(size) + " bytes is over the limit");
+        return false;
+    }
+    Connection& connection = connections_[id];
+    if (reliable) {
+        ReliableMessage message;
+        message.id = connection.nextReliableId++;
+        message.data.assign(data, data + size);
+        connection.reliableQueue.push_back(std::move(message));
+    } else {
+        connection.unreliableQueue.emplace_back(data, data + size);
+    }
+    return true;
+}
+
+void NetTransport::Flush() {
+    if (socket_ == static_cast<uintptr_t>(INVALID_SOCKET)) return;
+    const double now = Now();
+    for (ConnectionID id = 0; id < connections_.size(); ++id) {
+        if (connections_[id].state == State::Connected) {
+            FlushConnection(id, now);
+        }
+    }
+}
+
+void NetTransport::FlushConnection(ConnectionID id, double now) {
+    Connection& connection = connections_[id];
+    const double resendDelay = std::max(static_cast<double>(connection.roundTrip) * 1.25, MIN_RESEND_DELAY);
+    bool sentAny = false;
+    std::vector<uint16_t> packetReliableIds;
+
+    auto beginPacket = [&]() {
+        WriteHeader(packet_, protocolId_, PACKET_PAYLOAD, connection.salt);
+        Put16(packet_, connection.localSequence);
+        Put16(packet_, connection.remoteSequence);
+        Put32(packet_, connection.receivedBits);
+        packetReliableIds.clear();
+    };
+    auto endPacket = [&]() {
+        SentPacket& sent = connection.sentPackets[connection.localSequence % SENT_PACKET_WINDOW];
+        sent.sequence = connection.localSequence;
+        sent.acked = false;
+        sent.time = now;
+        sent.reliableIds = packetReliableIds;
+        SendPacket(connection, packet_.data(), packet_.size());
+        ++connection.localSequence;
+        connection.lastSent = now;
+        sentAny = true;
+    };
+    auto addMessage = [&](uint8_t flags, uint16_t reliableId, const std::vector<uint8_t>& data) {
+        if (packet_.size() + MESSAGE_HEADER_SIZE + data.size() > MAX_PACKET_SIZE) {
+            endPacket();
+            beginPacket();
+        }
+        packet_.push_back(flags);
+        Put16(packet_, reliableId);
+        Put16(packet_, static_cast<uint16_t>(data.size()));
+        packet_.insert(packet_.end(), data.begin(), data.end());
+    };
+
+    beginPacket();
+    bool hasMessages = false;
+    // Reliable messages first, no further ahead than the receiver's window
+    const size_t reliableLimit = std::min(connection.reliableQueue.size(), RELIABLE_WINDOW);
+    for (size_t i = 0; i < reliableLimit; ++i) {
+        ReliableMessage& message = connection.reliableQueue[i];
+        if (message.acked || (message.lastSent >= 0.0 && now - message.lastSent < resendDelay)) continue;
+        if (message.lastSent >= 0.0) ++stats_.reliableResends;
+        addMessage(MESSAGE_RELIABLE, message.id, message.data);
+        packetReliableIds.push_back(message.id);
+        message.lastSent = now;
+        hasMessages = true;
+    }
+    for (const std::vector<uint8_t>& message : connection.unreliableQueue) {
+        addMessage(0, 0, message);
+        hasMessages = true;
+    }
+    connection.unreliableQueue.clear();
+
+    // An empty packet still carries acks
+    if (hasMessages || (!sentAny && now - connection.lastSent >= KEEP_ALIVE_INTERVAL)) {
+        endPacket();
+    }
+}
+
+void NetTransport::SendControl(const Connection& connection, uint8_t type) {
+    std::vector<uint8_t> packet;
+    WriteHeader(packet, protocolId_, type, connection.salt);
+    SendPacket(connection, packet.data(), packet.size());
+}
+
+void NetTransport::SendPacket(const Connection& connection, const uint8_t* data, size_t size) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(connection.address);
+    address.sin_port = htons(connection.port);
+    sendto(static_cast<SOCKET>(socket_), reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+           reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    ++stats_.packetsSent;
+    stats_.bytesSent += size;
+}
+
+void NetTransport::Disconnect(ConnectionID id) {
+    if (id >= connections_.size() || connections_[id].state == State::Free) return;
+    if (connections_[id].state == State::Connected) {
+        for (int i = 0; i < DISCONNECT_REPEATS; ++i) {
+            SendControl(connections_[id], PACKET_DISCONNECT);
+        }
+    }
+    Drop(id, false);
+}
+
+void NetTransport::Drop(ConnectionID id, bool notify) {
+    Connection& connection = connections_[id];
+    if (connection.state == State::Free) return;
+    if (connection.state == State::Connected) {
+        --connectionCount_;
+    }
+    connectionsByAddress_.erase(AddressKey(connection.address, connection.port));
+    Reset(connection);
+    if (notify) {
+        Event event;
+        event.type = EventType::Disconnected;
+        event.connection = id;
+        events_.push_back(std::move(event));
+    }
+}
+
+bool NetTransport::IsConnected(ConnectionID id) const {
+    return id < connections_.size() && connections_[id].state == State::Connected;
+}
+
+float NetTransport::GetRoundTripMs(ConnectionID id) const {
+    return id < connections_.size() ? connections_[id].roundTrip * 1000.0f : 0.0f;
+}
+
+} // namespace Nexus
+
+#endif // NEXUS_NETWORKING_ENABLED
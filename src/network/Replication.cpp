@@ -0,0 +1,504 @@
+#include "EngineConfig.h"
+
+#ifdef NEXUS_NETWORKING_ENABLED
+
+#include "Replication.h"
+#include "Components.h"
+#include "ECS.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Nexus {
+
+namespace {
+
+enum RecordOp : uint8_t {
+    OP_UPDATE = 0,
+    OP_CREATE,
+    OP_REMOVE
+};
+
+constexpr uint32_t OP_BITS = 2;
+constexpr uint32_t TYPE_BITS = 16;
+constexpr uint32_t ROTATION_BITS = 32;
+// Position deltas within +-127 steps, two metres at the default resolution, take a byte an axis
+constexpr uint32_t SMALL_DELTA_BITS = 8;
+constexpr int32_t SMALL_DELTA_MIN = -128;
+constexpr int32_t SMALL_DELTA_MAX = 127;
+// Type byte and the id, baseline and count varints at their longest
+constexpr uint32_t SNAPSHOT_HEADER_BITS = 8 + 3 * 40;
+// Creates jump ahead of updates of the same age, since the client has nothing to show yet
+constexpr float CREATE_PRIORITY_SCALE = 2.0f;
+
+uint32_t VarintBits(uint32_t value) {
+    uint32_t bytes = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++bytes;
+    }
+    return bytes * 8;
+}
+
+uint32_t FloatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float BitsFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool IsSmallDelta(const QuantizedTransform& from, const QuantizedTransform& to) {
+    for (int axis = 0; axis < 3; ++axis) {
+        int32_t delta = to.position[axis] - from.position[axis];
+        if (delta < SMALL_DELTA_MIN || delta > SMALL_DELTA_MAX) return false;
+    }
+    return true;
+}
+
+void WritePosition(NetBitWriter& writer, const QuantizedTransform& transform, const uint32_t positionBits[3]) {
+    for (int axis = 0; axis < 3; ++axis) {
+        writer.WriteBits(static_cast<uint32_t>(transform.position[axis]), positionBits[axis]);
+    }
+}
+
+void ReadPosition(NetBitReader& reader, QuantizedTransform& transform, const uint32_t positionBits[3]) {
+    for (int axis = 0; axis < 3; ++axis) {
+        transform.position[axis] = static_cast<int32_t>(reader.ReadBits(positionBits[axis]));
+    }
+}
+
+} // namespace
+
+ReplicationServer::ReplicationServer(NetTransport& transport, const Settings& settings)
+    : transport_(transport)
+    , settings_(settings)
+    , grid_(settings.cellSize)
+    , tick_(0)
+    , snapshotTimer_(0.0f)
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        positionBits_[axis] = settings_.quantization.GetPositionBits(axis);
+    }
+}
+
+bool ReplicationServer::HandleEvent(const NetTransport::Event& event) {
+    if (event.connection == NetTransport::INVALID_CONNECTION) return false;
+    if (event.connection >= clients_.size()) {
+        clients_.resize(event.connection + 1);
+    }
+    Client& client = clients_[event.connection];
+
+    switch (event.type) {
+    case NetTransport::EventType::Connected:
+    case NetTransport::EventType::Disconnected:
+        client = Client();
+        client.active = event.type == NetTransport::EventType::Connected;
+        return false;
+    case NetTransport::EventType::Message:
+        break;
+    }
+
+    if (event.data.empty() || event.data[0] >= REPLICATION_MESSAGE_COUNT) return false;
+    if (event.data[0] != REPLICATION_ACK || !client.active) return true;
+
+    NetBitReader reader(event.data.data() + 1, event.data.size() - 1);
+    const uint32_t snapshotId = reader.ReadVarint();
+    DirectX::XMFLOAT3 viewPosition;
+    viewPosition.x = BitsFloat(reader.ReadBits(32));
+    viewPosition.y = BitsFloat(reader.ReadBits(32));
+    viewPosition.z = BitsFloat(reader.ReadBits(32));
+    if (reader.IsOverflowed()) return true;
+
+    // Acks arrive unreliably and out of order; only a newer one moves the baseline
+    if (snapshotId > client.ackedSnapshot && snapshotId < client.nextSnapshotId) {
+        client.ackedSnapshot = snapshotId;
+    }
+    if (!client.focusOverridden && std::isfinite(viewPosition.x) && std::isfinite(viewPosition.y) &&
+        std::isfinite(viewPosition.z)) {
+        client.focus = viewPosition;
+    }
+    return true;
+}
+
+void ReplicationServer::SetClientFocus(NetTransport::ConnectionID connection, const DirectX::XMFLOAT3& focus) {
+    if (connection >= clients_.size()) {
+        clients_.resize(connection + 1);
+    }
+    clients_[connection].focus = focus;
+    clients_[connection].focusOverridden = true;
+}
+
+void ReplicationServer::Update(World& world, JobSystem* jobs, float deltaTime) {
+    NEXUS_PROFILE_SCOPE("ReplicationServer::Update");
+    Gather(world);
+
+    const float interval = 1.0f / std::max(settings_.snapshotRate, 1.0f);
+    snapshotTimer_ += deltaTime;
+    if (snapshotTimer_ < interval) return;
+    // A long hitch sends one snapshot, not a burst
+    snapshotTimer_ = std::min(snapshotTimer_ - interval, interval);
+
+    sendingClients_.clear();
+    for (uint32_t id = 0; id < clients_.size(); ++id) {
+        if (clients_[id].active) {
+            sendingClients_.push_back(id);
+        }
+    }
+    stats_.clients = static_cast<uint32_t>(sendingClients_.size());
+
+    if (jobs && sendingClients_.size() > 1) {
+        jobs->ParallelFor(sendingClients_.size(), 1, [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                EncodeSnapshot(clients_[sendingClients_[i]]);
+            }
+        });
+    } else {
+        for (uint32_t id : sendingClients_) {
+            EncodeSnapshot(clients_[id]);
+        }
+    }
+
+    for (uint32_t id : sendingClients_) {
+        const std::vector<uint8_t>& message = clients_[id].message;
+        stats_.deferredRecords += clients_[id].deferred;
+        if (transport_.Send(id, message.data(), message.size(), false)) {
+            ++stats_.snapshotsSent;
+            stats_.snapshotBytes += message.size();
+        }
+    }
+}
+
+void ReplicationServer::Gather(World& world) {
+    NEXUS_PROFILE_SCOPE("ReplicationServer::Gather");
+    ++tick_;
+    world.ForEach<TransformComponent, ReplicatedComponent>(
+        [this](Entity entity, TransformComponent& transform, ReplicatedComponent& replicated) {
+            if (entity.index >= entities_.size()) {
+                entities_.resize(entity.index + 1);
+            }
+            EntityState& state = entities_[entity.index];
+            if (!state.alive || state.generation != entity.generation) {
+                if (state.alive) {
+                    grid_.Remove(state.gridItem);
+                }
+                state.alive = true;
+                state.generation = entity.generation;
+                state.gridItem = grid_.Insert(transform.position);
+                if (state.gridItem >= gridEntities_.size()) {
+                    gridEntities_.resize(state.gridItem + 1);
+                }
+                gridEntities_[state.gridItem] = entity.index;
+            } else {
+                grid_.Move(state.gridItem, transform.position);
+            }
+            state.type = replicated.type;
+            state.position = transform.position;
+            state.transform = settings_.quantization.Quantize(transform.position, transform.rotation);
+            state.lastSeen = tick_;
+        });
+
+    uint32_t count = 0;
+    for (EntityState& state : entities_) {
+        if (!state.alive) continue;
+        if (state.lastSeen != tick_) {
+            grid_.Remove(state.gridItem);
+            state = EntityState();
+        } else {
+            ++count;
+        }
+    }
+    stats_.entities = count;
+}
+
+void ReplicationServer::EncodeSnapshot(Client& client) {
+    static const Snapshot emptySnapshot;
+
+    // The baseline is what the client has; without a recent enough ack it has nothing we know of
+    const Snapshot* baseline = &emptySnapshot;
+    if (client.ackedSnapshot != 0 && client.nextSnapshotId - client.ackedSnapshot < SNAPSHOT_HISTORY &&
+        client.history[client.ackedSnapshot % SNAPSHOT_HISTORY].id == client.ackedSnapshot) {
+        baseline = &client.history[client.ackedSnapshot % SNAPSHOT_HISTORY];
+    }
+
+    grid_.QueryRadius(client.focus, settings_.interestRadius, client.visible);
+    for (uint32_t& item : client.visible) {
+        item = gridEntities_[item];
+    }
+    std::sort(client.visible.begin(), client.visible.end());
+    if (client.priority.size() < entities_.size()) {
+        client.priority.resize(entities_.size(), 0.0f);
+    }
+
+    // Merge what the client has with what it should have into the candidate records
+    client.records.clear();
+    const uint32_t fullPositionBits = positionBits_[0] + positionBits_[1] + positionBits_[2];
+    auto addRecord = [&](uint32_t index, uint8_t op, const ReplicatedState* base) {
+        Record record;
+        record.index = index;
+        record.op = op;
+        record.baseline = base;
+        record.bits = VarintBits(index) + OP_BITS;
+        if (op == OP_REMOVE) {
+            record.priority = std::numeric_limits<float>::max();
+            client.records.push_back(record);
+            return;
+        }
+
+        const EntityState& state = entities_[index];
+        if (op == OP_CREATE) {
+            record.bits += VarintBits(state.generation) + TYPE_BITS + fullPositionBits + ROTATION_BITS;
+        } else {
+            record.bits += 2;
+            if (std::memcmp(base->transform.position, state.transform.position, sizeof(state.transform.position)) != 0) {
+                record.bits += 1 + (IsSmallDelta(base->transform, state.transform) ? 3 * SMALL_DELTA_BITS : fullPositionBits);
+            }
+            if (base->transform.rotation != state.transform.rotation) {
+                record.bits += ROTATION_BITS;
+            }
+        }
+
+        // Grows for every snapshot the change waits, from 1 at the edge of the radius to 5 at the focus
+        float dx = state.position.x - client.focus.x;
+        float dy = state.position.y - client.focus.y;
+        float dz = state.position.z - client.focus.z;
+        float nearness = 1.0f - std::min(std::sqrt(dx * dx + dy * dy + dz * dz) / settings_.interestRadius, 1.0f);
+        float& priority = client.priority[index];
+        priority += (1.0f + 4.0f * nearness) * (op == OP_CREATE ? CREATE_PRIORITY_SCALE : 1.0f);
+        record.priority = priority;
+        client.records.push_back(record);
+    };
+
+    const std::vector<ReplicatedState>& had = baseline->entities;
+    size_t b = 0, v = 0;
+    while (b < had.size() || v < client.visible.size()) {
+        if (v == client.visible.size() || (b < had.size() && had[b].index < client.visible[v])) {
+            addRecord(had[b].index, OP_REMOVE, &had[b]);
+            ++b;
+        } else if (b == had.size() || client.visible[v] < had[b].index) {
+            addRecord(client.visible[v], OP_CREATE, nullptr);
+            ++v;
+        } else {
+            const EntityState& state = entities_[client.visible[v]];
+            if (had[b].generation != state.generation) {
+                addRecord(client.visible[v], OP_CREATE, &had[b]);
+            } else if (had[b].transform != state.transform) {
+                addRecord(client.visible[v], OP_UPDATE, &had[b]);
+            }
+            ++b;
+            ++v;
+        }
+    }
+
+    // Most urgent first until the budget is spent; the rest wait for a later snapshot
+    std::sort(client.records.begin(), client.records.end(),
+              [](const Record& a, const Record& b) { return a.priority > b.priority; });
+    const size_t budgetBits = settings_.snapshotBudget * 8 - SNAPSHOT_HEADER_BITS;
+    size_t usedBits = 0;
+    size_t selected = 0;
+    for (; selected < client.records.size(); ++selected) {
+        if (usedBits + client.records[selected].bits > budgetBits) break;
+        usedBits += client.records[selected].bits;
+    }
+    client.deferred = static_cast<uint32_t>(client.records.size() - selected);
+    client.records.resize(selected);
+    std::sort(client.records.begin(), client.records.end(),
+              [](const Record& a, const Record& b) { return a.index < b.index; });
+
+    // Encode the records, and record the snapshot as the client will rebuild it
+    const uint32_t snapshotId = client.nextSnapshotId++;
+    Snapshot& snapshot = client.history[snapshotId % SNAPSHOT_HISTORY];
+    snapshot.id = snapshotId;
+    snapshot.entities.clear();
+
+    client.message.clear();
+    client.message.push_back(REPLICATION_SNAPSHOT);
+    NetBitWriter writer(client.message);
+    writer.WriteVarint(snapshotId);
+    writer.WriteVarint(baseline->id != 0 ? snapshotId - baseline->id : 0);
+    writer.WriteVarint(static_cast<uint32_t>(client.records.size()));
+
+    uint32_t previousIndex = 0;
+    b = 0;
+    for (const Record& record : client.records) {
+        while (b < had.size() && had[b].index < record.index) {
+            snapshot.entities.push_back(had[b++]);
+        }
+        if (b < had.size() && had[b].index == record.index) {
+            ++b;
+        }
+
+        writer.WriteVarint(record.index - previousIndex);
+        writer.WriteBits(record.op, OP_BITS);
+        previousIndex = record.index;
+        if (record.op == OP_REMOVE) continue;
+
+        const EntityState& state = entities_[record.index];
+        client.priority[record.index] = 0.0f;
+        if (record.op == OP_CREATE) {
+            writer.WriteVarint(state.generation);
+            writer.WriteBits(state.type, TYPE_BITS);
+            WritePosition(writer, state.transform, positionBits_);
+            writer.WriteBits(state.transform.rotation, ROTATION_BITS);
+        } else {
+            const QuantizedTransform& from = record.baseline->transform;
+            const bool moved = std::memcmp(from.position, state.transform.position, sizeof(from.position)) != 0;
+            writer.WriteBool(moved);
+            if (moved) {
+                const bool small = IsSmallDelta(from, state.transform);
+                writer.WriteBool(small);
+                if (small) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        int32_t delta = state.transform.position[axis] - from.position[axis];
+                        writer.WriteBits(static_cast<uint32_t>(delta - SMALL_DELTA_MIN), SMALL_DELTA_BITS);
+                    }
+                } else {
+                    WritePosition(writer, state.transform, positionBits_);
+                }
+            }
+            writer.WriteBool(from.rotation != state.transform.rotation);
+            if (from.rotation != state.transform.rotation) {
+                writer.WriteBits(state.transform.rotation, ROTATION_BITS);
+            }
+        }
+
+        ReplicatedState sent;
+        sent.index = record.index;
+        sent.generation = state.generation;
+        sent.type = state.type;
+        sent.transform = state.transform;
+        snapshot.entities.push_back(sent);
+    }
+    while (b < had.size()) {
+        snapshot.entities.push_back(had[b++]);
+    }
+    writer.Finish();
+}
+
+ReplicationClient::ReplicationClient(NetTransport& transport, const NetQuantization& quantization)
+    : transport_(transport)
+    , quantization_(quantization)
+    , current_(&empty_)
+    , viewPosition_(0.0f, 0.0f, 0.0f)
+    , snapshotsDropped_(0)
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        positionBits_[axis] = quantization_.GetPositionBits(axis);
+    }
+}
+
+bool ReplicationClient::HandleEvent(const NetTransport::Event& event) {
+    if (event.type == NetTransport::EventType::Disconnected) {
+        for (Snapshot& snapshot : history_) {
+            snapshot = Snapshot();
+        }
+        current_ = &empty_;
+        return false;
+    }
+    if (event.type != NetTransport::EventType::Message || event.data.empty() ||
+        event.data[0] >= REPLICATION_MESSAGE_COUNT) {
+        return false;
+    }
+    if (event.data[0] == REPLICATION_SNAPSHOT && !DecodeSnapshot(event.data.data() + 1, event.data.size() - 1)) {
+        ++snapshotsDropped_;
+    }
+    return true;
+}
+
+bool ReplicationClient::DecodeSnapshot(const uint8_t* data, size_t size) {
+    NEXUS_PROFILE_SCOPE("ReplicationClient::DecodeSnapshot");
+    NetBitReader reader(data, size);
+    const uint32_t snapshotId = reader.ReadVarint();
+    const uint32_t baselineDistance = reader.ReadVarint();
+    const uint32_t recordCount = reader.ReadVarint();
+    if (reader.IsOverflowed() || snapshotId == 0 || snapshotId <= current_->id) return false;
+    // Each record is at least a one-byte index delta and an op, so a count the payload cannot
+    // hold is rejected before it sizes anything
+    if (recordCount > reader.GetBitsRemaining() / (8 + OP_BITS)) return false;
+
+    const Snapshot* baseline = &empty_;
+    if (baselineDistance != 0) {
+        const uint32_t baselineId = snapshotId - baselineDistance;
+        if (baselineDistance >= SNAPSHOT_HISTORY || history_[baselineId % SNAPSHOT_HISTORY].id != baselineId) {
+            return false;
+        }
+        baseline = &history_[baselineId % SNAPSHOT_HISTORY];
+    }
+
+    const std::vector<ReplicatedState>& had = baseline->entities;
+    std::vector<ReplicatedState> entities;
+    entities.reserve(had.size() + recordCount);
+    uint32_t index = 0;
+    size_t b = 0;
+    for (uint32_t i = 0; i < recordCount && !reader.IsOverflowed(); ++i) {
+        index += reader.ReadVarint();
+        const uint32_t op = reader.ReadBits(OP_BITS);
+        while (b < had.size() && had[b].index < index) {
+            entities.push_back(had[b++]);
+        }
+        const ReplicatedState* base = nullptr;
+        if (b < had.size() && had[b].index == index) {
+            base = &had[b++];
+        }
+
+        if (op == OP_REMOVE) continue;
+        ReplicatedState state;
+        if (op == OP_CREATE) {
+            state.index = index;
+            state.generation = reader.ReadVarint();
+            state.type = static_cast<uint16_t>(reader.ReadBits(TYPE_BITS));
+            ReadPosition(reader, state.transform, positionBits_);
+            state.transform.rotation = reader.ReadBits(ROTATION_BITS);
+        } else if (op == OP_UPDATE && base) {
+            state = *base;
+            if (reader.ReadBool()) {
+                if (reader.ReadBool()) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        state.transform.position[axis] +=
+                            static_cast<int32_t>(reader.ReadBits(SMALL_DELTA_BITS)) + SMALL_DELTA_MIN;
+                    }
+                } else {
+                    ReadPosition(reader, state.transform, positionBits_);
+                }
+            }
+            if (reader.ReadBool()) {
+                state.transform.rotation = reader.ReadBits(ROTATION_BITS);
+            }
+        } else {
+            // An update of something the baseline doesn't hold
+            return false;
+        }
+        entities.push_back(state);
+    }
+    if (reader.IsOverflowed()) return false;
+    while (b < had.size()) {
+        entities.push_back(had[b++]);
+    }
+
+    Snapshot& snapshot = history_[snapshotId % SNAPSHOT_HISTORY];
+    snapshot.id = snapshotId;
+    snapshot.entities = std::move(entities);
+    current_ = &snapshot;
+
+    ack_.clear();
+    ack_.push_back(REPLICATION_ACK);
+    NetBitWriter writer(ack_);
+    writer.WriteVarint(snapshotId);
+    writer.WriteBits(FloatBits(viewPosition_.x), 32);
+    writer.WriteBits(FloatBits(viewPosition_.y), 32);
+    writer.WriteBits(FloatBits(viewPosition_.z), 32);
+    writer.Finish();
+    transport_.Send(0, ack_.data(), ack_.size(), false);
+    return true;
+}
+
+} // namespace Nexus
+
+#endif // NEXUS_NETWORKING_ENABLED
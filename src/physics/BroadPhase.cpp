@@ -0,0 +1,353 @@
+#include "BroadPhase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Nexus {
+
+BroadPhase::BroadPhase()
+    : BroadPhase(Settings())
+{
+}
+
+BroadPhase::BroadPhase(const Settings& settings)
+    : settings_(settings)
+    , root_(NULL_NODE)
+    , freeList_(NULL_NODE)
+    , proxyCount_(0)
+{
+}
+
+bool BroadPhase::Overlaps(const AABB& a, const AABB& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+bool BroadPhase::Contains(const AABB& outer, const AABB& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+AABB BroadPhase::Union(const AABB& a, const AABB& b) {
+    return {{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)},
+            {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)}};
+}
+
+// Half the surface area, all the heuristic needs to compare costs
+float BroadPhase::Perimeter(const AABB& box) {
+    float x = box.max.x - box.min.x;
+    float y = box.max.y - box.min.y;
+    float z = box.max.z - box.min.z;
+    return x * y + y * z + z * x;
+}
+
+// Slab test of the segment from + delta * t, t in [0, maxFraction]
+bool BroadPhase::SegmentOverlaps(const AABB& box, const DirectX::XMFLOAT3& from, const DirectX::XMFLOAT3& delta,
+                                 float maxFraction) {
+    const float origin[3] = { from.x, from.y, from.z };
+    const float direction[3] = { delta.x, delta.y, delta.z };
+    const float low[3] = { box.min.x, box.min.y, box.min.z };
+    const float high[3] = { box.max.x, box.max.y, box.max.z };
+    float enter = 0.0f;
+    float exit = maxFraction;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::abs(direction[axis]) < 1e-12f) {
+            if (origin[axis] < low[axis] || origin[axis] > high[axis]) return false;
+            continue;
+        }
+        float inverse = 1.0f / direction[axis];
+        float t1 = (low[axis] - origin[axis]) * inverse;
+        float t2 = (high[axis] - origin[axis]) * inverse;
+        enter = std::max(enter, std::min(t1, t2));
+        exit = std::min(exit, std::max(t1, t2));
+        if (enter > exit) return false;
+    }
+    return true;
+}
+
+uint32_t BroadPhase::AllocateNode() {
+    if (freeList_ == NULL_NODE) {
+        nodes_.emplace_back();
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+    uint32_t node = freeList_;
+    freeList_ = nodes_[node].parent;
+    nodes_[node] = Node();
+    return node;
+}
+
+void BroadPhase::FreeNode(uint32_t node) {
+    nodes_[node] = Node();
+    nodes_[node].parent = freeList_;
+    freeList_ = node;
+}
+
+AABB BroadPhase::MakeFat(const AABB& box, const DirectX::XMFLOAT3& displacement) const {
+    float margin = settings_.fatMargin;
+    AABB fat = {{box.min.x - margin, box.min.y - margin, box.min.z - margin},
+                {box.max.x + margin, box.max.y + margin, box.max.z + margin}};
+
+    // Stretch ahead of the motion so a steadily moving proxy is not reinserted every step
+    float dx = displacement.x * settings_.displacementScale;
+    float dy = displacement.y * settings_.displacementScale;
+    float dz = displacement.z * settings_.displacementScale;
+    (dx < 0.0f ? fat.min.x : fat.max.x) += dx;
+    (dy < 0.0f ? fat.min.y : fat.max.y) += dy;
+    (dz < 0.0f ? fat.min.z : fat.max.z) += dz;
+    return fat;
+}
+
+BroadPhase::ProxyID BroadPhase::CreateProxy(const AABB& box, uint64_t userData) {
+    uint32_t proxy = AllocateNode();
+    Node& node = nodes_[proxy];
+    node.box = MakeFat(box, DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+    node.userData = userData;
+    node.height = 0;
+    node.moved = true;
+    InsertLeaf(proxy);
+    moveBuffer_.push_back(proxy);
+    proxyCount_++;
+    return proxy;
+}
+
+void BroadPhase::DestroyProxy(ProxyID proxy) {
+    if (!IsProxy(proxy)) return;
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    proxyCount_--;
+
+    // The ID may come back for another proxy, so nothing may refer to this one afterwards
+    pairs_.erase(std::remove_if(pairs_.begin(), pairs_.end(),
+                                [proxy](const Pair& pair) { return pair.a == proxy || pair.b == proxy; }),
+                 pairs_.end());
+    moveBuffer_.erase(std::remove(moveBuffer_.begin(), moveBuffer_.end(), proxy), moveBuffer_.end());
+}
+
+bool BroadPhase::MoveProxy(ProxyID proxy, const AABB& box, const DirectX::XMFLOAT3& displacement) {
+    if (!IsProxy(proxy) || Contains(nodes_[proxy].box, box)) return false;
+
+    RemoveLeaf(proxy);
+    nodes_[proxy].box = MakeFat(box, displacement);
+    InsertLeaf(proxy);
+    if (!nodes_[proxy].moved) {
+        nodes_[proxy].moved = true;
+        moveBuffer_.push_back(proxy);
+    }
+    return true;
+}
+
+void BroadPhase::Clear() {
+    nodes_.clear();
+    root_ = NULL_NODE;
+    freeList_ = NULL_NODE;
+    proxyCount_ = 0;
+    moveBuffer_.clear();
+    pairs_.clear();
+    pairsAdded_.clear();
+    pairsRemoved_.clear();
+}
+
+void BroadPhase::InsertLeaf(uint32_t leaf) {
+    if (root_ == NULL_NODE) {
+        root_ = leaf;
+        nodes_[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Descend towards the sibling that grows the tree's total area the least
+    const AABB leafBox = nodes_[leaf].box;
+    uint32_t index = root_;
+    while (nodes_[index].height > 0) {
+        const Node& node = nodes_[index];
+        float area = Perimeter(node.box);
+        float combinedArea = Perimeter(Union(node.box, leafBox));
+
+        // Pairing with this node creates a parent over both; descending passes the growth on
+        float cost = 2.0f * combinedArea;
+        float inheritance = 2.0f * (combinedArea - area);
+
+        float childCost[2];
+        const uint32_t children[2] = { node.child1, node.child2 };
+        for (int i = 0; i < 2; ++i) {
+            const Node& child = nodes_[children[i]];
+            float grown = Perimeter(Union(child.box, leafBox));
+            childCost[i] = (child.height == 0 ? grown : grown - Perimeter(child.box)) + inheritance;
+        }
+
+        if (cost < childCost[0] && cost < childCost[1]) break;
+        index = childCost[0] < childCost[1] ? children[0] : children[1];
+    }
+
+    uint32_t sibling = index;
+    uint32_t oldParent = nodes_[sibling].parent;
+    uint32_t newParent = AllocateNode();
+    Node& parent = nodes_[newParent];
+    parent.parent = oldParent;
+    parent.box = Union(leafBox, nodes_[sibling].box);
+    parent.height = nodes_[sibling].height + 1;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    nodes_[sibling].parent = newParent;
+    nodes_[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE) {
+        root_ = newParent;
+    } else if (nodes_[oldParent].child1 == sibling) {
+        nodes_[oldParent].child1 = newParent;
+    } else {
+        nodes_[oldParent].child2 = newParent;
+    }
+
+    // Refit and rebalance the ancestors
+    index = nodes_[leaf].parent;
+    while (index != NULL_NODE) {
+        index = Balance(index);
+        Node& node = nodes_[index];
+        node.height = 1 + std::max(nodes_[node.child1].height, nodes_[node.child2].height);
+        node.box = Union(nodes_[node.child1].box, nodes_[node.child2].box);
+        index = node.parent;
+    }
+}
+
+void BroadPhase::RemoveLeaf(uint32_t leaf) {
+    if (leaf == root_) {
+        root_ = NULL_NODE;
+        return;
+    }
+
+    uint32_t parent = nodes_[leaf].parent;
+    uint32_t grandParent = nodes_[parent].parent;
+    uint32_t sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+    // The sibling takes the parent's place
+    FreeNode(parent);
+    nodes_[sibling].parent = grandParent;
+    if (grandParent == NULL_NODE) {
+        root_ = sibling;
+        return;
+    }
+    if (nodes_[grandParent].child1 == parent) {
+        nodes_[grandParent].child1 = sibling;
+    } else {
+        nodes_[grandParent].child2 = sibling;
+    }
+
+    uint32_t index = grandParent;
+    while (index != NULL_NODE) {
+        index = Balance(index);
+        Node& node = nodes_[index];
+        node.height = 1 + std::max(nodes_[node.child1].height, nodes_[node.child2].height);
+        node.box = Union(nodes_[node.child1].box, nodes_[node.child2].box);
+        index = node.parent;
+    }
+}
+
+// Rotates the taller child of a up when the children's heights differ by more than one. Returns
+// the node now in a's place
+uint32_t BroadPhase::Balance(uint32_t a) {
+    Node& nodeA = nodes_[a];
+    if (nodeA.height < 2) return a;
+
+    uint32_t b = nodeA.child1;
+    uint32_t c = nodeA.child2;
+    Node& nodeB = nodes_[b];
+    Node& nodeC = nodes_[c];
+    int32_t balance = nodeC.height - nodeB.height;
+    if (balance >= -1 && balance <= 1) return a;
+
+    // Promote the taller child (up) over a; a keeps its other child (stay) and takes the shorter
+    // grandchild, the taller grandchild stays under up
+    bool promoteC = balance > 1;
+    uint32_t up = promoteC ? c : b;
+    uint32_t stay = promoteC ? b : c;
+    Node& nodeUp = nodes_[up];
+    uint32_t f = nodeUp.child1;
+    uint32_t g = nodeUp.child2;
+    uint32_t tall = nodes_[f].height > nodes_[g].height ? f : g;
+    uint32_t shortChild = tall == f ? g : f;
+
+    nodeUp.child1 = a;
+    nodeUp.child2 = tall;
+    nodeUp.parent = nodeA.parent;
+    nodeA.parent = up;
+    if (nodeUp.parent == NULL_NODE) {
+        root_ = up;
+    } else if (nodes_[nodeUp.parent].child1 == a) {
+        nodes_[nodeUp.parent].child1 = up;
+    } else {
+        nodes_[nodeUp.parent].child2 = up;
+    }
+
+    if (promoteC) {
+        nodeA.child2 = shortChild;
+    } else {
+        nodeA.child1 = shortChild;
+    }
+    nodes_[shortChild].parent = a;
+
+    const Node& nodeStay = nodes_[stay];
+    const Node& nodeShort = nodes_[shortChild];
+    const Node& nodeTall = nodes_[tall];
+    nodeA.box = Union(nodeStay.box, nodeShort.box);
+    nodeA.height = 1 + std::max(nodeStay.height, nodeShort.height);
+    nodeUp.box = Union(nodeA.box, nodeTall.box);
+    nodeUp.height = 1 + std::max(nodeA.height, nodeTall.height);
+    return up;
+}
+
+void BroadPhase::UpdatePairs() {
+    pairsAdded_.clear();
+    pairsRemoved_.clear();
+    stats_.moved = static_cast<uint32_t>(moveBuffer_.size());
+
+    // Cached pairs hold until their fat boxes separate
+    size_t kept = 0;
+    for (const Pair& pair : pairs_) {
+        if (Overlaps(nodes_[pair.a].box, nodes_[pair.b].box)) {
+            pairs_[kept++] = pair;
+        } else {
+            pairsRemoved_.push_back(pair);
+        }
+    }
+    pairs_.resize(kept);
+
+    // Only reinserted proxies can have gained partners
+    candidates_.clear();
+    for (ProxyID proxy : moveBuffer_) {
+        Query(nodes_[proxy].box, [&](ProxyID other) {
+            // Two moved proxies find each other twice; the lower ID reports
+            if (other != proxy && !(nodes_[other].moved && other < proxy)) {
+                candidates_.push_back(proxy < other ? Pair{ proxy, other } : Pair{ other, proxy });
+            }
+            return true;
+        });
+    }
+    for (ProxyID proxy : moveBuffer_) {
+        nodes_[proxy].moved = false;
+    }
+    moveBuffer_.clear();
+
+    std::sort(candidates_.begin(), candidates_.end());
+    candidates_.erase(std::unique(candidates_.begin(), candidates_.end()), candidates_.end());
+    for (const Pair& pair : candidates_) {
+        if (!std::binary_search(pairs_.begin(), pairs_.end(), pair)) {
+            pairsAdded_.push_back(pair);
+        }
+    }
+    if (!pairsAdded_.empty()) {
+        size_t middle = pairs_.size();
+        pairs_.insert(pairs_.end(), pairsAdded_.begin(), pairsAdded_.end());
+        std::inplace_merge(pairs_.begin(), pairs_.begin() + middle, pairs_.end());
+    }
+}
+
+const BroadPhase::Stats& BroadPhase::GetStats() const {
+    stats_.proxies = proxyCount_;
+    stats_.height = root_ == NULL_NODE ? 0 : static_cast<uint32_t>(nodes_[root_].height);
+    stats_.pairs = static_cast<uint32_t>(pairs_.size());
+    stats_.pairsAdded = static_cast<uint32_t>(pairsAdded_.size());
+    stats_.pairsRemoved = static_cast<uint32_t>(pairsRemoved_.size());
+    return stats_;
+}
+
+} // namespace Nexus
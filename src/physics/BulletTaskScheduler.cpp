@@ -0,0 +1,68 @@
+#include "BulletTaskScheduler.h"
+
+#if defined(NEXUS_BULLET_PHYSICS_ENABLED) && defined(NEXUS_BULLET_MT_ENABLED)
+
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <vector>
+
+namespace Nexus {
+
+BulletTaskScheduler::BulletTaskScheduler(JobSystem& jobs)
+    : btITaskScheduler("NexusJobSystem")
+    , jobs_(jobs)
+    , numThreads_(0)
+{
+    numThreads_ = getMaxNumThreads();
+}
+
+int BulletTaskScheduler::getMaxNumThreads() const {
+    int threads = jobs_.IsInitialized() ? static_cast<int>(jobs_.GetWorkerCount()) + 1 : 1;
+    return std::min(threads, static_cast<int>(BT_MAX_THREAD_COUNT));
+}
+
+void BulletTaskScheduler::setNumThreads(int numThreads) {
+    numThreads_ = std::clamp(numThreads, 1, getMaxNumThreads());
+}
+
+int BulletTaskScheduler::ChunkSize(int count, int grainSize) const {
+    int chunks = std::max(numThreads_, 1);
+    return std::max((count + chunks - 1) / chunks, std::max(grainSize, 1));
+}
+
+void BulletTaskScheduler::parallelFor(int begin, int end, int grainSize, const btIParallelForBody& body) {
+    NEXUS_PROFILE_SCOPE("BulletTaskScheduler::parallelFor");
+    int count = end - begin;
+    if (count <= 0) return;
+
+    jobs_.ParallelFor(static_cast<size_t>(count), static_cast<size_t>(ChunkSize(count, grainSize)),
+                      [&](size_t chunkBegin, size_t chunkEnd) {
+                          body.forLoop(begin + static_cast<int>(chunkBegin), begin + static_cast<int>(chunkEnd));
+                      });
+}
+
+btScalar BulletTaskScheduler::parallelSum(int begin, int end, int grainSize, const btIParallelSumBody& body) {
+    NEXUS_PROFILE_SCOPE("BulletTaskScheduler::parallelSum");
+    int count = end - begin;
+    if (count <= 0) return btScalar(0);
+
+    // One slot per chunk, summed in order afterwards so the result does not depend on timing
+    int chunkSize = ChunkSize(count, grainSize);
+    std::vector<btScalar> sums((count + chunkSize - 1) / chunkSize, btScalar(0));
+    jobs_.ParallelFor(static_cast<size_t>(count), static_cast<size_t>(chunkSize),
+                      [&](size_t chunkBegin, size_t chunkEnd) {
+                          sums[chunkBegin / chunkSize] =
+                              body.sumLoop(begin + static_cast<int>(chunkBegin), begin + static_cast<int>(chunkEnd));
+                      });
+
+    btScalar total(0);
+    for (btScalar sum : sums) {
+        total += sum;
+    }
+    return total;
+}
+
+} // namespace Nexus
+
+#endif
@@ -0,0 +1,473 @@
+#include "ClothSolver.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+namespace {
+
+constexpr size_t PADDING = 3;
+constexpr float MIN_LENGTH = 1e-6f;
+
+__m128 Gather(const float* values, const uint32_t* indices) {
+    return _mm_set_ps(values[indices[3]], values[indices[2]], values[indices[1]], values[indices[0]]);
+}
+
+void Scatter(float* values, const uint32_t* indices, __m128 v) {
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, v);
+    for (int lane = 0; lane < 4; ++lane) {
+        values[indices[lane]] = lanes[lane];
+    }
+}
+
+__m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+} // namespace
+
+ClothSolver::ClothSolver() : ClothSolver(ClothSettings()) {}
+
+ClothSolver::ClothSolver(const ClothSettings& settings)
+    : settings_(settings)
+    , jobs_(nullptr)
+    , dirty_(false)
+    , particleCount_(0)
+    , serialStart_(0)
+{
+    Clear();
+}
+
+void ClothSolver::Clear() {
+    particleCount_ = 0;
+    for (std::vector<float>* array : {&positionX_, &positionY_, &positionZ_, &previousX_, &previousY_, &previousZ_,
+                                      &velocityX_, &velocityY_, &velocityZ_, &inverseMass_, &tetherLength_}) {
+        array->assign(PADDING, 0.0f);
+    }
+    tetherAnchor_.assign(PADDING, 0);
+    constraintA_.clear();
+    constraintB_.clear();
+    restLength_.clear();
+    compliance_.clear();
+    colorStart_.clear();
+    serialStart_ = 0;
+    dirty_ = false;
+}
+
+template<typename Fn>
+void ClothSolver::ForRange(size_t count, Fn&& fn) {
+    if (jobs_ && jobs_->IsInitialized() && jobs_->GetWorkerCount() > 0 && count >= PARALLEL_THRESHOLD) {
+        // Multiples of four keep the SSE groups whole
+        size_t grain = std::max<size_t>(count / (jobs_->GetWorkerCount() * 4), 512) & ~size_t(3);
+        jobs_->ParallelFor(count, grain, fn);
+    } else {
+        fn(0, count);
+    }
+}
+
+uint32_t ClothSolver::AddParticle(const DirectX::XMFLOAT3& position, float mass) {
+    uint32_t index = static_cast<uint32_t>(particleCount_++);
+    // The padding after the last particle is all zeros, so growing by one shifts it along
+    for (std::vector<float>* array : {&positionX_, &positionY_, &positionZ_, &previousX_, &previousY_, &previousZ_,
+                                      &velocityX_, &velocityY_, &velocityZ_, &inverseMass_, &tetherLength_}) {
+        array->resize(particleCount_ + PADDING, 0.0f);
+    }
+    tetherAnchor_.resize(particleCount_ + PADDING, 0);
+
+    positionX_[index] = previousX_[index] = position.x;
+    positionY_[index] = previousY_[index] = position.y;
+    positionZ_[index] = previousZ_[index] = position.z;
+    inverseMass_[index] = mass > 0.0f ? 1.0f / mass : 0.0f;
+    dirty_ = true;
+    return index;
+}
+
+void ClothSolver::SetParticleMass(uint32_t particle, float mass) {
+    if (particle >= particleCount_) return;
+    inverseMass_[particle] = mass > 0.0f ? 1.0f / mass : 0.0f;
+    velocityX_[particle] = velocityY_[particle] = velocityZ_[particle] = 0.0f;
+    dirty_ = true;   // Tethers run to the pinned particles
+}
+
+void ClothSolver::AddDistanceConstraint(uint32_t a, uint32_t b, float compliance) {
+    if (a >= particleCount_ || b >= particleCount_ || a == b) return;
+    float dx = positionX_[b] - positionX_[a];
+    float dy = positionY_[b] - positionY_[a];
+    float dz = positionZ_[b] - positionZ_[a];
+    constraintA_.push_back(a);
+    constraintB_.push_back(b);
+    restLength_.push_back(std::sqrt(dx * dx + dy * dy + dz * dz));
+    compliance_.push_back(std::max(compliance, 0.0f));
+    dirty_ = true;
+}
+
+uint32_t ClothSolver::AddGrid(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& edgeU,
+                              const DirectX::XMFLOAT3& edgeV, uint32_t columns, uint32_t rows, float particleMass,
+                              float compliance, float bendCompliance) {
+    uint32_t first = static_cast<uint32_t>(particleCount_);
+    float stepU = columns > 1 ? 1.0f / static_cast<float>(columns - 1) : 0.0f;
+    float stepV = rows > 1 ? 1.0f / static_cast<float>(rows - 1) : 0.0f;
+    for (uint32_t row = 0; row < rows; ++row) {
+        for (uint32_t column = 0; column < columns; ++column) {
+            float u = static_cast<float>(column) * stepU;
+            float v = static_cast<float>(row) * stepV;
+            AddParticle(DirectX::XMFLOAT3(origin.x + edgeU.x * u + edgeV.x * v, origin.y + edgeU.y * u + edgeV.y * v,
+                                          origin.z + edgeU.z * u + edgeV.z * v), particleMass);
+        }
+    }
+
+    auto at = [first, columns](uint32_t column, uint32_t row) { return first + row * columns + column; };
+    for (uint32_t row = 0; row < rows; ++row) {
+        for (uint32_t column = 0; column < columns; ++column) {
+            // Structural and shear hold the weave, bending across two cells keeps it from folding flat
+            if (column + 1 < columns) AddDistanceConstraint(at(column, row), at(column + 1, row), compliance);
+            if (row + 1 < rows) AddDistanceConstraint(at(column, row), at(column, row + 1), compliance);
+            if (column + 1 < columns && row + 1 < rows) {
+                AddDistanceConstraint(at(column, row), at(column + 1, row + 1), compliance);
+                AddDistanceConstraint(at(column + 1, row), at(column, row + 1), compliance);
+            }
+            if (column + 2 < columns) AddDistanceConstraint(at(column, row), at(column + 2, row), bendCompliance);
+            if (row + 2 < rows) AddDistanceConstraint(at(column, row), at(column, row + 2), bendCompliance);
+        }
+    }
+    return first;
+}
+
+void ClothSolver::SetParticlePosition(uint32_t particle, const DirectX::XMFLOAT3& position) {
+    if (particle >= particleCount_) return;
+    positionX_[particle] = previousX_[particle] = position.x;
+    positionY_[particle] = previousY_[particle] = position.y;
+    positionZ_[particle] = previousZ_[particle] = position.z;
+    velocityX_[particle] = velocityY_[particle] = velocityZ_[particle] = 0.0f;
+}
+
+DirectX::XMFLOAT3 ClothSolver::GetParticlePosition(uint32_t particle) const {
+    if (particle >= particleCount_) return DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    return DirectX::XMFLOAT3(positionX_[particle], positionY_[particle], positionZ_[particle]);
+}
+
+void ClothSolver::GetParticlePositions(DirectX::XMFLOAT3* positions) const {
+    for (size_t i = 0; i < particleCount_; ++i) {
+        positions[i] = DirectX::XMFLOAT3(positionX_[i], positionY_[i], positionZ_[i]);
+    }
+}
+
+void ClothSolver::SetColliders(const DirectX::XMFLOAT4* spheres, size_t count) {
+    colliders_.assign(spheres, spheres + count);
+}
+
+void ClothSolver::Build() {
+    NEXUS_PROFILE_SCOPE("ClothSolver::Build");
+
+    // Greedy coloring in the order constraints were added; a constraint whose particles already
+    // use every color is left for the serial pass
+    const uint32_t count = static_cast<uint32_t>(constraintA_.size());
+    std::vector<uint64_t> particleColors(particleCount_, 0);
+    std::vector<uint32_t> colors(count);
+    std::vector<uint32_t> colorCounts(MAX_COLORS + 1, 0);
+    uint32_t colorCount = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t used = particleColors[constraintA_[i]] | particleColors[constraintB_[i]];
+        uint32_t color = 0;
+        while (color < MAX_COLORS && (used & (1ull << color))) color++;
+        if (color < MAX_COLORS) {
+            particleColors[constraintA_[i]] |= 1ull << color;
+            particleColors[constraintB_[i]] |= 1ull << color;
+            colorCount = std::max(colorCount, color + 1);
+        }
+        colors[i] = color;
+        colorCounts[color]++;
+    }
+
+    // Counting sort by color, keeping the order within each
+    colorStart_.assign(colorCount + 1, 0);
+    std::vector<uint32_t> offsets(MAX_COLORS + 1, 0);
+    for (uint32_t color = 1; color <= MAX_COLORS; ++color) {
+        offsets[color] = offsets[color - 1] + colorCounts[color - 1];
+    }
+    for (uint32_t color = 0; color <= colorCount; ++color) {
+        colorStart_[color] = offsets[color];
+    }
+    serialStart_ = offsets[MAX_COLORS];
+
+    std::vector<uint32_t> sortedA(count), sortedB(count);
+    std::vector<float> sortedRest(count), sortedCompliance(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t slot = offsets[colors[i]]++;
+        sortedA[slot] = constraintA_[i];
+        sortedB[slot] = constraintB_[i];
+        sortedRest[slot] = restLength_[i];
+        sortedCompliance[slot] = compliance_[i];
+    }
+    constraintA_.swap(sortedA);
+    constraintB_.swap(sortedB);
+    restLength_.swap(sortedRest);
+    compliance_.swap(sortedCompliance);
+
+    BuildTethers();
+    dirty_ = false;
+}
+
+void ClothSolver::BuildTethers() {
+    // Particle to particle links, both ways
+    const size_t count = constraintA_.size();
+    std::vector<uint32_t> linkStart(particleCount_ + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        linkStart[constraintA_[i] + 1]++;
+        linkStart[constraintB_[i] + 1]++;
+    }
+    for (size_t i = 0; i < particleCount_; ++i) {
+        linkStart[i + 1] += linkStart[i];
+    }
+    std::vector<uint32_t> linkFill(linkStart.begin(), linkStart.end() - 1);
+    std::vector<uint32_t> links(count * 2);
+    std::vector<float> linkLengths(count * 2);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t a = constraintA_[i], b = constraintB_[i];
+        links[linkFill[a]] = b;
+        linkLengths[linkFill[a]++] = restLength_[i];
+        links[linkFill[b]] = a;
+        linkLengths[linkFill[b]++] = restLength_[i];
+    }
+
+    // Shortest rest distance to any pinned particle, spreading out from all of them at once
+    std::vector<float> distances(particleCount_, FLT_MAX);
+    std::vector<uint32_t> anchors(particleCount_, NO_PARTICLE);
+    using Entry = std::pair<float, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    for (uint32_t i = 0; i < particleCount_; ++i) {
+        if (inverseMass_[i] > 0.0f) continue;
+        distances[i] = 0.0f;
+        anchors[i] = i;
+        open.push(Entry(0.0f, i));
+    }
+    while (!open.empty()) {
+        Entry entry = open.top();
+        open.pop();
+        uint32_t particle = entry.second;
+        if (entry.first > distances[particle]) continue;
+        for (uint32_t link = linkStart[particle]; link < linkStart[particle + 1]; ++link) {
+            uint32_t next = links[link];
+            float distance = entry.first + linkLengths[link];
+            if (distance < distances[next]) {
+                distances[next] = distance;
+                anchors[next] = anchors[particle];
+                open.push(Entry(distance, next));
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < particleCount_ + PADDING; ++i) {
+        bool tethered = i < particleCount_ && inverseMass_[i] > 0.0f && anchors[i] != NO_PARTICLE;
+        tetherAnchor_[i] = tethered ? anchors[i] : i;
+        tetherLength_[i] = tethered ? distances[i] : FLT_MAX;
+    }
+}
+
+void ClothSolver::Step(float deltaTime) {
+    NEXUS_PROFILE_SCOPE("ClothSolver::Step");
+    if (particleCount_ == 0 || deltaTime <= 0.0f) return;
+    if (dirty_) Build();
+
+    int subSteps = std::max(settings_.subSteps, 1);
+    float stepTime = std::min(deltaTime, settings_.maxTimeStep) / static_cast<float>(subSteps);
+    for (int subStep = 0; subStep < subSteps; ++subStep) {
+        Predict(stepTime);
+        SolveDistances(stepTime);
+        SolveTethers();
+        SolveCollisions();
+        UpdateVelocities(stepTime);
+    }
+}
+
+void ClothSolver::Predict(float stepTime) {
+    const float damping = std::max(1.0f - settings_.damping * stepTime, 0.0f);
+    const DirectX::XMFLOAT3 acceleration(settings_.gravity.x + settings_.wind.x, settings_.gravity.y + settings_.wind.y,
+                                         settings_.gravity.z + settings_.wind.z);
+    ForRange(particleCount_, [&](size_t begin, size_t end) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 time = _mm_set1_ps(stepTime);
+        const __m128 keep = _mm_set1_ps(damping);
+        const __m128 ax = _mm_set1_ps(acceleration.x * stepTime);
+        const __m128 ay = _mm_set1_ps(acceleration.y * stepTime);
+        const __m128 az = _mm_set1_ps(acceleration.z * stepTime);
+        for (size_t i = begin; i < end; i += 4) {
+            // Pinned particles and padding hold still
+            const __m128 free = _mm_cmpgt_ps(_mm_loadu_ps(&inverseMass_[i]), zero);
+            __m128 px = _mm_loadu_ps(&positionX_[i]);
+            __m128 py = _mm_loadu_ps(&positionY_[i]);
+            __m128 pz = _mm_loadu_ps(&positionZ_[i]);
+            _mm_storeu_ps(&previousX_[i], px);
+            _mm_storeu_ps(&previousY_[i], py);
+            _mm_storeu_ps(&previousZ_[i], pz);
+
+            __m128 vx = _mm_and_ps(free, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityX_[i]), ax), keep));
+            __m128 vy = _mm_and_ps(free, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityY_[i]), ay), keep));
+            __m128 vz = _mm_and_ps(free, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityZ_[i]), az), keep));
+            _mm_storeu_ps(&velocityX_[i], vx);
+            _mm_storeu_ps(&velocityY_[i], vy);
+            _mm_storeu_ps(&velocityZ_[i], vz);
+            _mm_storeu_ps(&positionX_[i], _mm_add_ps(px, _mm_mul_ps(vx, time)));
+            _mm_storeu_ps(&positionY_[i], _mm_add_ps(py, _mm_mul_ps(vy, time)));
+            _mm_storeu_ps(&positionZ_[i], _mm_add_ps(pz, _mm_mul_ps(vz, time)));
+        }
+    });
+}
+
+void ClothSolver::SolveDistance(uint32_t constraint, float complianceScale) {
+    uint32_t a = constraintA_[constraint];
+    uint32_t b = constraintB_[constraint];
+    float weightA = inverseMass_[a];
+    float weightB = inverseMass_[b];
+    float denominator = weightA + weightB + compliance_[constraint] * complianceScale;
+    float dx = positionX_[b] - positionX_[a];
+    float dy = positionY_[b] - positionY_[a];
+    float dz = positionZ_[b] - positionZ_[a];
+    float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (denominator <= 0.0f || length < MIN_LENGTH) return;
+
+    // The multiplier's change over the gradient's length, which the correction divides back out
+    float scale = (restLength_[constraint] - length) / (denominator * length);
+    positionX_[a] -= dx * scale * weightA;
+    positionY_[a] -= dy * scale * weightA;
+    positionZ_[a] -= dz * scale * weightA;
+    positionX_[b] += dx * scale * weightB;
+    positionY_[b] += dy * scale * weightB;
+    positionZ_[b] += dz * scale * weightB;
+}
+
+void ClothSolver::SolveDistances(float stepTime) {
+    // XPBD: compliance over the squared step, so stiffness does not depend on the substep count
+    const float complianceScale = 1.0f / (stepTime * stepTime);
+    const uint32_t colorCount = static_cast<uint32_t>(GetColorCount());
+    for (uint32_t color = 0; color < colorCount; ++color) {
+        const uint32_t first = colorStart_[color];
+        const uint32_t count = colorStart_[color + 1] - first;
+        const uint32_t grouped = count & ~3u;
+
+        // No two constraints of a color share a particle, so groups of four gather, solve and
+        // scatter without stepping on each other, on whichever thread
+        ForRange(grouped, [&](size_t begin, size_t end) {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 minLength = _mm_set1_ps(MIN_LENGTH);
+            const __m128 scaleCompliance = _mm_set1_ps(complianceScale);
+            for (size_t group = begin; group < end; group += 4) {
+                const uint32_t* a = &constraintA_[first + group];
+                const uint32_t* b = &constraintB_[first + group];
+                __m128 weightA = Gather(inverseMass_.data(), a);
+                __m128 weightB = Gather(inverseMass_.data(), b);
+                __m128 compliance = _mm_mul_ps(_mm_loadu_ps(&compliance_[first + group]), scaleCompliance);
+                __m128 denominator = _mm_add_ps(_mm_add_ps(weightA, weightB), compliance);
+
+                __m128 ax = Gather(positionX_.data(), a), ay = Gather(positionY_.data(), a), az = Gather(positionZ_.data(), a);
+                __m128 bx = Gather(positionX_.data(), b), by = Gather(positionY_.data(), b), bz = Gather(positionZ_.data(), b);
+                __m128 dx = _mm_sub_ps(bx, ax), dy = _mm_sub_ps(by, ay), dz = _mm_sub_ps(bz, az);
+                __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+                __m128 valid = _mm_and_ps(_mm_cmpgt_ps(denominator, zero), _mm_cmpge_ps(length, minLength));
+                __m128 scale = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(&restLength_[first + group]), length),
+                                          _mm_mul_ps(Select(valid, denominator, _mm_set1_ps(1.0f)),
+                                                     Select(valid, length, _mm_set1_ps(1.0f))));
+                scale = _mm_and_ps(valid, scale);
+                __m128 scaleA = _mm_mul_ps(scale, weightA);
+                __m128 scaleB = _mm_mul_ps(scale, weightB);
+
+                Scatter(positionX_.data(), a, _mm_sub_ps(ax, _mm_mul_ps(dx, scaleA)));
+                Scatter(positionY_.data(), a, _mm_sub_ps(ay, _mm_mul_ps(dy, scaleA)));
+                Scatter(positionZ_.data(), a, _mm_sub_ps(az, _mm_mul_ps(dz, scaleA)));
+                Scatter(positionX_.data(), b, _mm_add_ps(bx, _mm_mul_ps(dx, scaleB)));
+                Scatter(positionY_.data(), b, _mm_add_ps(by, _mm_mul_ps(dy, scaleB)));
+                Scatter(positionZ_.data(), b, _mm_add_ps(bz, _mm_mul_ps(dz, scaleB)));
+            }
+        });
+        for (uint32_t i = first + grouped; i < first + count; ++i) {
+            SolveDistance(i, complianceScale);
+        }
+    }
+
+    for (uint32_t i = serialStart_; i < constraintA_.size(); ++i) {
+        SolveDistance(i, complianceScale);
+    }
+}
+
+void ClothSolver::SolveTethers() {
+    // Anchors are pinned, so their positions this substep are also in previous*, which nothing
+    // writes during the pass
+    ForRange(particleCount_, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += 4) {
+            const uint32_t* anchors = &tetherAnchor_[i];
+            __m128 ax = Gather(previousX_.data(), anchors);
+            __m128 ay = Gather(previousY_.data(), anchors);
+            __m128 az = Gather(previousZ_.data(), anchors);
+            __m128 px = _mm_loadu_ps(&positionX_[i]);
+            __m128 py = _mm_loadu_ps(&positionY_[i]);
+            __m128 pz = _mm_loadu_ps(&positionZ_[i]);
+            __m128 dx = _mm_sub_ps(px, ax), dy = _mm_sub_ps(py, ay), dz = _mm_sub_ps(pz, az);
+            __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+            // Untethered lanes have an infinite squared length and never pull
+            __m128 length = _mm_loadu_ps(&tetherLength_[i]);
+            __m128 over = _mm_cmpgt_ps(distanceSquared, _mm_mul_ps(length, length));
+            __m128 scale = _mm_div_ps(length, _mm_sqrt_ps(Select(over, distanceSquared, _mm_set1_ps(1.0f))));
+            _mm_storeu_ps(&positionX_[i], Select(over, _mm_add_ps(ax, _mm_mul_ps(dx, scale)), px));
+            _mm_storeu_ps(&positionY_[i], Select(over, _mm_add_ps(ay, _mm_mul_ps(dy, scale)), py));
+            _mm_storeu_ps(&positionZ_[i], Select(over, _mm_add_ps(az, _mm_mul_ps(dz, scale)), pz));
+        }
+    });
+}
+
+void ClothSolver::SolveCollisions() {
+    if (colliders_.empty()) return;
+    ForRange(particleCount_, [&](size_t begin, size_t end) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 minLength = _mm_set1_ps(MIN_LENGTH * MIN_LENGTH);
+        for (size_t i = begin; i < end; i += 4) {
+            const __m128 free = _mm_cmpgt_ps(_mm_loadu_ps(&inverseMass_[i]), zero);
+            __m128 px = _mm_loadu_ps(&positionX_[i]);
+            __m128 py = _mm_loadu_ps(&positionY_[i]);
+            __m128 pz = _mm_loadu_ps(&positionZ_[i]);
+            for (const DirectX::XMFLOAT4& sphere : colliders_) {
+                const float radius = sphere.w + settings_.thickness;
+                const __m128 cx = _mm_set1_ps(sphere.x), cy = _mm_set1_ps(sphere.y), cz = _mm_set1_ps(sphere.z);
+                __m128 dx = _mm_sub_ps(px, cx), dy = _mm_sub_ps(py, cy), dz = _mm_sub_ps(pz, cz);
+                __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                __m128 inside = _mm_and_ps(free, _mm_and_ps(_mm_cmplt_ps(distanceSquared, _mm_set1_ps(radius * radius)),
+                                                            _mm_cmpgt_ps(distanceSquared, minLength)));
+
+                // Out along the line from the center, onto the surface
+                __m128 scale = _mm_div_ps(_mm_set1_ps(radius), _mm_sqrt_ps(Select(inside, distanceSquared, _mm_set1_ps(1.0f))));
+                px = Select(inside, _mm_add_ps(cx, _mm_mul_ps(dx, scale)), px);
+                py = Select(inside, _mm_add_ps(cy, _mm_mul_ps(dy, scale)), py);
+                pz = Select(inside, _mm_add_ps(cz, _mm_mul_ps(dz, scale)), pz);
+            }
+            _mm_storeu_ps(&positionX_[i], px);
+            _mm_storeu_ps(&positionY_[i], py);
+            _mm_storeu_ps(&positionZ_[i], pz);
+        }
+    });
+}
+
+void ClothSolver::UpdateVelocities(float stepTime) {
+    ForRange(particleCount_, [&](size_t begin, size_t end) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 inverseTime = _mm_set1_ps(1.0f / stepTime);
+        for (size_t i = begin; i < end; i += 4) {
+            const __m128 free = _mm_cmpgt_ps(_mm_loadu_ps(&inverseMass_[i]), zero);
+            __m128 vx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&positionX_[i]), _mm_loadu_ps(&previousX_[i])), inverseTime);
+            __m128 vy = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&positionY_[i]), _mm_loadu_ps(&previousY_[i])), inverseTime);
+            __m128 vz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&positionZ_[i]), _mm_loadu_ps(&previousZ_[i])), inverseTime);
+            _mm_storeu_ps(&velocityX_[i], _mm_and_ps(free, vx));
+            _mm_storeu_ps(&velocityY_[i], _mm_and_ps(free, vy));
+            _mm_storeu_ps(&velocityZ_[i], _mm_and_ps(free, vz));
+        }
+    });
+}
+
+} // namespace Nexus
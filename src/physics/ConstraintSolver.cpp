@@ -0,0 +1,192 @@
+#include "ConstraintSolver.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace Nexus {
+
+namespace {
+
+float Dot(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+} // namespace
+
+ConstraintSolver::ConstraintSolver()
+    : ConstraintSolver(Settings())
+{
+}
+
+ConstraintSolver::ConstraintSolver(const Settings& settings)
+    : settings_(settings)
+    , deltaTime_(0.0f)
+{
+}
+
+void ConstraintSolver::Begin(float deltaTime) {
+    deltaTime_ = deltaTime;
+    bodies_.clear();
+    rows_.clear();
+    constraints_.clear();
+    stats_ = Stats();
+}
+
+uint32_t ConstraintSolver::AddBody(const DirectX::XMFLOAT3& velocity, float inverseMass) {
+    bodies_.push_back({velocity, inverseMass});
+    return static_cast<uint32_t>(bodies_.size() - 1);
+}
+
+void ConstraintSolver::AddRow(Constraint& constraint, const DirectX::XMFLOAT3& axis, float error, float lower,
+                              float upper, float minimumBias) {
+    float inverseMass = (constraint.a != STATIC_BODY ? bodies_[constraint.a].inverseMass : 0.0f) +
+                        (constraint.b != STATIC_BODY ? bodies_[constraint.b].inverseMass : 0.0f);
+    if (inverseMass <= 0.0f) return;
+
+    Row row;
+    row.axis = axis;
+    row.bias = std::max(-settings_.baumgarte / deltaTime_ * error, minimumBias);
+    row.effectiveMass = 1.0f / inverseMass;
+    row.lower = lower;
+    row.upper = upper;
+    row.impulse = 0.0f;
+    rows_.push_back(row);
+    constraint.rowCount++;
+}
+
+uint32_t ConstraintSolver::AddContact(uint32_t a, uint32_t b, const DirectX::XMFLOAT3& normal, float depth) {
+    Constraint constraint = {a, b, static_cast<uint32_t>(rows_.size()), 0};
+
+    // Bounce off the approach speed the bodies arrive with, not the one left mid-solve
+    DirectX::XMFLOAT3 velocityA = a != STATIC_BODY ? bodies_[a].velocity : DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    DirectX::XMFLOAT3 velocityB = b != STATIC_BODY ? bodies_[b].velocity : DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    float approach = Dot(normal, velocityB) - Dot(normal, velocityA);
+    float restitutionBias = approach < -settings_.restitutionThreshold ? -settings_.restitution * approach : 0.0f;
+
+    AddRow(constraint, normal, -std::max(depth - settings_.slop, 0.0f), 0.0f, FLT_MAX, restitutionBias);
+    if (constraint.rowCount == 0) return NO_ROW;
+    constraints_.push_back(constraint);
+    return constraint.firstRow;
+}
+
+void ConstraintSolver::AddPointJoint(uint32_t a, uint32_t b, const DirectX::XMFLOAT3& anchorA,
+                                     const DirectX::XMFLOAT3& anchorB) {
+    static const DirectX::XMFLOAT3 axes[3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+    static const float locked[3] = {0.0f, 0.0f, 0.0f};
+    AddAxisJoint(a, b, anchorA, anchorB, axes, locked, locked, 3);
+}
+
+void ConstraintSolver::AddAxisJoint(uint32_t a, uint32_t b, const DirectX::XMFLOAT3& anchorA,
+                                    const DirectX::XMFLOAT3& anchorB, const DirectX::XMFLOAT3* axes,
+                                    const float* minimum, const float* maximum, uint32_t axisCount) {
+    Constraint constraint = {a, b, static_cast<uint32_t>(rows_.size()), 0};
+    DirectX::XMFLOAT3 offset(anchorB.x - anchorA.x, anchorB.y - anchorA.y, anchorB.z - anchorA.z);
+
+    for (uint32_t i = 0; i < axisCount; ++i) {
+        if (minimum[i] > maximum[i]) continue;
+        const DirectX::XMFLOAT3& axis = axes[i];
+        float distance = Dot(offset, axis);
+        if (minimum[i] == maximum[i]) {
+            AddRow(constraint, axis, distance - minimum[i], -FLT_MAX, FLT_MAX, -FLT_MAX);
+        } else if (distance < minimum[i]) {
+            AddRow(constraint, axis, distance - minimum[i], 0.0f, FLT_MAX, -FLT_MAX);
+        } else if (distance > maximum[i]) {
+            // The upper limit is a lower limit along the reversed axis
+            AddRow(constraint, DirectX::XMFLOAT3(-axis.x, -axis.y, -axis.z), maximum[i] - distance, 0.0f, FLT_MAX, -FLT_MAX);
+        }
+    }
+    if (constraint.rowCount > 0) constraints_.push_back(constraint);
+}
+
+void ConstraintSolver::Color() {
+    bodyColors_.assign(bodies_.size(), 0);
+    for (std::vector<uint32_t>& color : colors_) {
+        color.clear();
+    }
+    serial_.clear();
+
+    for (uint32_t i = 0; i < constraints_.size(); ++i) {
+        const Constraint& constraint = constraints_[i];
+        uint64_t used = (constraint.a != STATIC_BODY ? bodyColors_[constraint.a] : 0) |
+                        (constraint.b != STATIC_BODY ? bodyColors_[constraint.b] : 0);
+        if (used == UINT64_MAX) {
+            serial_.push_back(i);
+            continue;
+        }
+
+        uint32_t color = 0;
+        while (used & (1ull << color)) color++;
+        if (color >= colors_.size()) colors_.resize(color + 1);
+        colors_[color].push_back(i);
+
+        uint64_t bit = 1ull << color;
+        if (constraint.a != STATIC_BODY) bodyColors_[constraint.a] |= bit;
+        if (constraint.b != STATIC_BODY) bodyColors_[constraint.b] |= bit;
+    }
+}
+
+void ConstraintSolver::SolveConstraint(const Constraint& constraint) {
+    static const DirectX::XMFLOAT3 zero(0.0f, 0.0f, 0.0f);
+    Body* a = constraint.a != STATIC_BODY ? &bodies_[constraint.a] : nullptr;
+    Body* b = constraint.b != STATIC_BODY ? &bodies_[constraint.b] : nullptr;
+    const DirectX::XMFLOAT3& velocityA = a ? a->velocity : zero;
+    const DirectX::XMFLOAT3& velocityB = b ? b->velocity : zero;
+
+    for (uint32_t r = 0; r < constraint.rowCount; ++r) {
+        Row& row = rows_[constraint.firstRow + r];
+        float relative = Dot(row.axis, velocityB) - Dot(row.axis, velocityA);
+        float previous = row.impulse;
+        row.impulse = std::clamp(previous + row.effectiveMass * (row.bias - relative), row.lower, row.upper);
+        float delta = row.impulse - previous;
+
+        if (a) {
+            float scale = delta * a->inverseMass;
+            a->velocity.x -= row.axis.x * scale;
+            a->velocity.y -= row.axis.y * scale;
+            a->velocity.z -= row.axis.z * scale;
+        }
+        if (b) {
+            float scale = delta * b->inverseMass;
+            b->velocity.x += row.axis.x * scale;
+            b->velocity.y += row.axis.y * scale;
+            b->velocity.z += row.axis.z * scale;
+        }
+    }
+}
+
+void ConstraintSolver::Solve(JobSystem* jobs) {
+    NEXUS_PROFILE_SCOPE("ConstraintSolver::Solve");
+    if (constraints_.empty()) return;
+
+    Color();
+
+    auto solveRange = [this](const std::vector<uint32_t>& color, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            SolveConstraint(constraints_[color[i]]);
+        }
+    };
+
+    bool parallel = jobs && jobs->IsInitialized() && jobs->GetWorkerCount() > 0;
+    for (uint32_t iteration = 0; iteration < settings_.iterations; ++iteration) {
+        // Colors run one after another; inside a color no two constraints touch the same body
+        for (const std::vector<uint32_t>& color : colors_) {
+            if (parallel && color.size() >= settings_.parallelThreshold) {
+                size_t grain = std::max<size_t>(color.size() / (jobs->GetWorkerCount() * 4), 64);
+                jobs->ParallelFor(color.size(), grain, [&](size_t begin, size_t end) { solveRange(color, begin, end); });
+            } else {
+                solveRange(color, 0, color.size());
+            }
+        }
+        solveRange(serial_, 0, serial_.size());
+    }
+
+    stats_.bodies = static_cast<uint32_t>(bodies_.size());
+    stats_.constraints = static_cast<uint32_t>(constraints_.size());
+    stats_.rows = static_cast<uint32_t>(rows_.size());
+    stats_.colors = static_cast<uint32_t>(std::count_if(colors_.begin(), colors_.end(),
+                                                        [](const std::vector<uint32_t>& color) { return !color.empty(); }));
+    stats_.serialConstraints = static_cast<uint32_t>(serial_.size());
+}
+
+} // namespace Nexus
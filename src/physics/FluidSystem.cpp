@@ -0,0 +1,373 @@
+#include "FluidSystem.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace Nexus {
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+
+// Spreads the low 10 bits of v so two zero bits follow each
+uint32_t Part1By2(uint32_t v) {
+    v &= 0x000003FF;
+    v = (v ^ (v << 16)) & 0xFF0000FF;
+    v = (v ^ (v << 8)) & 0x0300F00F;
+    v = (v ^ (v << 4)) & 0x030C30C3;
+    v = (v ^ (v << 2)) & 0x09249249;
+    return v;
+}
+
+uint32_t MortonKey(uint32_t x, uint32_t y, uint32_t z) {
+    return Part1By2(x) | (Part1By2(y) << 1) | (Part1By2(z) << 2);
+}
+
+float HorizontalSum(__m128 v) {
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+} // namespace
+
+FluidSystem::FluidSystem()
+    : boundsMin_(-5.0f, 0.0f, -5.0f)
+    , boundsMax_(5.0f, 10.0f, 5.0f)
+    , nextParticleId_(0)
+    , jobs_(nullptr)
+    , radius_(0.2f)
+    , particleMass_(1.0f)
+    , cellSize_(0.2f)
+    , cellBits_(1)
+{
+}
+
+bool FluidSystem::Initialize(const FluidSettings& settings) {
+    settings_ = settings;
+    particles_.clear();
+    particles_.reserve(static_cast<size_t>(std::max(settings_.maxParticles, 0)));
+    nextParticleId_ = 0;
+
+    radius_ = settings_.restDistance * 2.0f;
+    // A particle's share of a rest-density cube one spacing wide
+    particleMass_ = settings_.density * settings_.restDistance * settings_.restDistance * settings_.restDistance;
+
+    SetBounds(DirectX::XMFLOAT3(-settings_.containerSize.x * 0.5f, 0.0f, -settings_.containerSize.z * 0.5f),
+              DirectX::XMFLOAT3(settings_.containerSize.x * 0.5f, settings_.containerSize.y, settings_.containerSize.z * 0.5f));
+    return true;
+}
+
+void FluidSystem::SetBounds(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max) {
+    boundsMin_ = min;
+    boundsMax_ = max;
+    ConfigureGrid();
+}
+
+void FluidSystem::ConfigureGrid() {
+    // Cells are at least a kernel radius wide so a neighbor search never looks past the 27
+    // surrounding cells, and grow beyond that when the bounds would need too many
+    float extent = std::max({boundsMax_.x - boundsMin_.x, boundsMax_.y - boundsMin_.y, boundsMax_.z - boundsMin_.z, radius_});
+    const float maxCells = static_cast<float>(1u << MAX_CELL_BITS);
+    cellSize_ = std::max(radius_, extent / maxCells);
+
+    uint32_t cells = static_cast<uint32_t>(std::ceil(extent / cellSize_));
+    cellBits_ = 1;
+    while ((1u << cellBits_) < cells && cellBits_ < MAX_CELL_BITS) cellBits_++;
+}
+
+uint32_t FluidSystem::CellCoordinate(float position, float boundsMin) const {
+    float cell = (position - boundsMin) / cellSize_;
+    uint32_t last = (1u << cellBits_) - 1;
+    return cell <= 0.0f ? 0 : std::min(static_cast<uint32_t>(cell), last);
+}
+
+void FluidSystem::AddParticle(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& velocity) {
+    if (static_cast<int>(particles_.size()) >= settings_.maxParticles) return;
+
+    Particle particle;
+    particle.position = position;
+    particle.velocity = velocity;
+    particle.force = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    particle.density = settings_.density;
+    particle.pressure = 0.0f;
+    particle.mass = particleMass_;
+    particle.id = nextParticleId_++;
+    particles_.push_back(particle);
+}
+
+void FluidSystem::RemoveParticle(int particleId) {
+    auto it = std::find_if(particles_.begin(), particles_.end(),
+                           [particleId](const Particle& particle) { return particle.id == particleId; });
+    if (it == particles_.end()) return;
+    // Order does not matter, the next sort restores locality
+    *it = particles_.back();
+    particles_.pop_back();
+}
+
+template<typename Fn>
+void FluidSystem::ForRange(size_t count, Fn&& fn) {
+    if (jobs_ && jobs_->IsInitialized() && jobs_->GetWorkerCount() > 0 && count >= PARALLEL_THRESHOLD) {
+        // Multiples of four keep the SSE passes' groups whole
+        size_t grain = std::max<size_t>(count / (jobs_->GetWorkerCount() * 4), 256) & ~size_t(3);
+        jobs_->ParallelFor(count, grain, fn);
+    } else {
+        fn(0, count);
+    }
+}
+
+void FluidSystem::Update(float deltaTime) {
+    NEXUS_PROFILE_SCOPE("FluidSystem::Update");
+    if (particles_.empty() || deltaTime <= 0.0f) return;
+
+    int steps = std::min(static_cast<int>(std::ceil(deltaTime / settings_.maxTimeStep)), std::max(settings_.maxSubSteps, 1));
+    float stepTime = std::min(deltaTime / static_cast<float>(steps), settings_.maxTimeStep);
+    for (int step = 0; step < steps; ++step) {
+        Step(stepTime);
+    }
+}
+
+void FluidSystem::Step(float deltaTime) {
+    BuildGrid();
+    CalculateDensityPressure();
+    CalculateForces();
+    Integrate(deltaTime);
+    HandleCollisions();
+
+    // Write back in sorted order, so the next sort has little to move
+    size_t count = particles_.size();
+    sorted_.resize(count);
+    ForRange(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Particle& particle = sorted_[i];
+            particle.position = DirectX::XMFLOAT3(positionX_[i], positionY_[i], positionZ_[i]);
+            particle.velocity = DirectX::XMFLOAT3(velocityX_[i], velocityY_[i], velocityZ_[i]);
+            particle.force = DirectX::XMFLOAT3(accelerationX_[i], accelerationY_[i], accelerationZ_[i]);
+            particle.density = densities_[i];
+            particle.pressure = pressures_[i];
+            particle.mass = particleMass_;
+            particle.id = particles_[order_[i]].id;
+        }
+    });
+    particles_.swap(sorted_);
+}
+
+void FluidSystem::BuildGrid() {
+    NEXUS_PROFILE_SCOPE("FluidSystem::BuildGrid");
+    size_t count = particles_.size();
+
+    cellKeys_.resize(count);
+    ForRange(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const DirectX::XMFLOAT3& p = particles_[i].position;
+            cellKeys_[i] = MortonKey(CellCoordinate(p.x, boundsMin_.x), CellCoordinate(p.y, boundsMin_.y),
+                                     CellCoordinate(p.z, boundsMin_.z));
+        }
+    });
+
+    // Counting sort by cell key. After the inclusive prefix sum each entry is its cell's end;
+    // scattering backwards moves it down to the cell's start and keeps the sort stable
+    size_t cellCount = size_t(1) << (3 * cellBits_);
+    cellStart_.assign(cellCount + 1, 0);
+    for (uint32_t key : cellKeys_) {
+        cellStart_[key]++;
+    }
+    for (size_t cell = 1; cell <= cellCount; ++cell) {
+        cellStart_[cell] += cellStart_[cell - 1];
+    }
+    order_.resize(count);
+    for (size_t i = count; i-- > 0;) {
+        order_[--cellStart_[cellKeys_[i]]] = static_cast<uint32_t>(i);
+    }
+
+    // Gather into structure of arrays. Padding lanes are masked out of every pass but still
+    // loaded, so they get a harmless density
+    size_t padded = count + 3;
+    for (std::vector<float>* array : {&positionX_, &positionY_, &positionZ_, &velocityX_, &velocityY_, &velocityZ_,
+                                      &accelerationX_, &accelerationY_, &accelerationZ_, &pressures_}) {
+        array->assign(padded, 0.0f);
+    }
+    densities_.assign(padded, 1.0f);
+    ForRange(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Particle& particle = particles_[order_[i]];
+            positionX_[i] = particle.position.x;
+            positionY_[i] = particle.position.y;
+            positionZ_[i] = particle.position.z;
+            velocityX_[i] = particle.velocity.x;
+            velocityY_[i] = particle.velocity.y;
+            velocityZ_[i] = particle.velocity.z;
+        }
+    });
+}
+
+void FluidSystem::CalculateDensityPressure() {
+    NEXUS_PROFILE_SCOPE("FluidSystem::CalculateDensityPressure");
+    const float h2 = radius_ * radius_;
+    // Poly6 kernel: 315 / (64 pi h^9) * (h^2 - r^2)^3
+    const float poly6 = particleMass_ * 315.0f / (64.0f * PI * std::pow(radius_, 9.0f));
+    const uint32_t lastCell = (1u << cellBits_) - 1;
+
+    ForRange(particles_.size(), [&](size_t begin, size_t end) {
+        const __m128 radiusSquared = _mm_set1_ps(h2);
+        const __m128 laneOffsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        for (size_t i = begin; i < end; ++i) {
+            const __m128 px = _mm_set1_ps(positionX_[i]);
+            const __m128 py = _mm_set1_ps(positionY_[i]);
+            const __m128 pz = _mm_set1_ps(positionZ_[i]);
+            uint32_t cx = CellCoordinate(positionX_[i], boundsMin_.x);
+            uint32_t cy = CellCoordinate(positionY_[i], boundsMin_.y);
+            uint32_t cz = CellCoordinate(positionZ_[i], boundsMin_.z);
+
+            __m128 sum = _mm_setzero_ps();
+            for (uint32_t z = cz > 0 ? cz - 1 : 0; z <= std::min(cz + 1, lastCell); ++z) {
+                for (uint32_t y = cy > 0 ? cy - 1 : 0; y <= std::min(cy + 1, lastCell); ++y) {
+                    for (uint32_t x = cx > 0 ? cx - 1 : 0; x <= std::min(cx + 1, lastCell); ++x) {
+                        uint32_t key = MortonKey(x, y, z);
+                        uint32_t first = cellStart_[key];
+                        uint32_t last = cellStart_[key + 1];
+                        const __m128 limit = _mm_set1_ps(static_cast<float>(last));
+                        for (uint32_t j = first; j < last; j += 4) {
+                            __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(&positionX_[j]));
+                            __m128 dy = _mm_sub_ps(py, _mm_loadu_ps(&positionY_[j]));
+                            __m128 dz = _mm_sub_ps(pz, _mm_loadu_ps(&positionZ_[j]));
+                            __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                            __m128 w = _mm_max_ps(_mm_sub_ps(radiusSquared, r2), _mm_setzero_ps());
+                            __m128 valid = _mm_cmplt_ps(_mm_add_ps(_mm_set1_ps(static_cast<float>(j)), laneOffsets), limit);
+                            sum = _mm_add_ps(sum, _mm_and_ps(valid, _mm_mul_ps(_mm_mul_ps(w, w), w)));
+                        }
+                    }
+                }
+            }
+
+            densities_[i] = poly6 * HorizontalSum(sum);
+            // Under-dense regions do not pull, which keeps the surface from clumping
+            pressures_[i] = std::max(settings_.gasConstant * (densities_[i] - settings_.density), 0.0f);
+        }
+    });
+}
+
+void FluidSystem::CalculateForces() {
+    NEXUS_PROFILE_SCOPE("FluidSystem::CalculateForces");
+    // Spiky gradient and viscosity Laplacian share 45 / (pi h^6)
+    const float kernel = 45.0f / (PI * std::pow(radius_, 6.0f));
+    const float h2 = radius_ * radius_;
+    const uint32_t lastCell = (1u << cellBits_) - 1;
+
+    ForRange(particles_.size(), [&](size_t begin, size_t end) {
+        const __m128 radius = _mm_set1_ps(radius_);
+        const __m128 radiusSquared = _mm_set1_ps(h2);
+        const __m128 epsilon = _mm_set1_ps(1e-12f);
+        const __m128 laneOffsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 pressureScale = _mm_set1_ps(0.5f * particleMass_ * kernel);
+        const __m128 viscosityScale = _mm_set1_ps(settings_.viscosity * particleMass_ * kernel);
+        for (size_t i = begin; i < end; ++i) {
+            const __m128 px = _mm_set1_ps(positionX_[i]);
+            const __m128 py = _mm_set1_ps(positionY_[i]);
+            const __m128 pz = _mm_set1_ps(positionZ_[i]);
+            const __m128 vx = _mm_set1_ps(velocityX_[i]);
+            const __m128 vy = _mm_set1_ps(velocityY_[i]);
+            const __m128 vz = _mm_set1_ps(velocityZ_[i]);
+            const __m128 pressure = _mm_set1_ps(pressures_[i]);
+            uint32_t cx = CellCoordinate(positionX_[i], boundsMin_.x);
+            uint32_t cy = CellCoordinate(positionY_[i], boundsMin_.y);
+            uint32_t cz = CellCoordinate(positionZ_[i], boundsMin_.z);
+
+            __m128 fx = _mm_setzero_ps(), fy = _mm_setzero_ps(), fz = _mm_setzero_ps();
+            for (uint32_t z = cz > 0 ? cz - 1 : 0; z <= std::min(cz + 1, lastCell); ++z) {
+                for (uint32_t y = cy > 0 ? cy - 1 : 0; y <= std::min(cy + 1, lastCell); ++y) {
+                    for (uint32_t x = cx > 0 ? cx - 1 : 0; x <= std::min(cx + 1, lastCell); ++x) {
+                        uint32_t key = MortonKey(x, y, z);
+                        uint32_t first = cellStart_[key];
+                        uint32_t last = cellStart_[key + 1];
+                        const __m128 limit = _mm_set1_ps(static_cast<float>(last));
+                        for (uint32_t j = first; j < last; j += 4) {
+                            __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(&positionX_[j]));
+                            __m128 dy = _mm_sub_ps(py, _mm_loadu_ps(&positionY_[j]));
+                            __m128 dz = _mm_sub_ps(pz, _mm_loadu_ps(&positionZ_[j]));
+                            __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+                            // Neighbors inside the kernel, excluding the particle itself
+                            __m128 mask = _mm_and_ps(_mm_cmplt_ps(r2, radiusSquared), _mm_cmpgt_ps(r2, epsilon));
+                            mask = _mm_and_ps(mask, _mm_cmplt_ps(_mm_add_ps(_mm_set1_ps(static_cast<float>(j)), laneOffsets), limit));
+                            if (_mm_movemask_ps(mask) == 0) continue;
+
+                            __m128 r = _mm_sqrt_ps(_mm_max_ps(r2, epsilon));
+                            __m128 falloff = _mm_sub_ps(radius, r);
+                            __m128 inverseDensity = _mm_div_ps(_mm_set1_ps(1.0f), _mm_loadu_ps(&densities_[j]));
+
+                            // Pressure: m (p_i + p_j) / (2 rho_j) * 45 / (pi h^6) * (h - r)^2 along the unit offset
+                            __m128 push = _mm_mul_ps(pressureScale, _mm_add_ps(pressure, _mm_loadu_ps(&pressures_[j])));
+                            push = _mm_mul_ps(push, _mm_mul_ps(inverseDensity, _mm_mul_ps(falloff, falloff)));
+                            push = _mm_and_ps(mask, _mm_div_ps(push, r));
+                            fx = _mm_add_ps(fx, _mm_mul_ps(push, dx));
+                            fy = _mm_add_ps(fy, _mm_mul_ps(push, dy));
+                            fz = _mm_add_ps(fz, _mm_mul_ps(push, dz));
+
+                            // Viscosity: mu m (v_j - v_i) / rho_j * 45 / (pi h^6) * (h - r)
+                            __m128 drag = _mm_and_ps(mask, _mm_mul_ps(viscosityScale, _mm_mul_ps(inverseDensity, falloff)));
+                            fx = _mm_add_ps(fx, _mm_mul_ps(drag, _mm_sub_ps(_mm_loadu_ps(&velocityX_[j]), vx)));
+                            fy = _mm_add_ps(fy, _mm_mul_ps(drag, _mm_sub_ps(_mm_loadu_ps(&velocityY_[j]), vy)));
+                            fz = _mm_add_ps(fz, _mm_mul_ps(drag, _mm_sub_ps(_mm_loadu_ps(&velocityZ_[j]), vz)));
+                        }
+                    }
+                }
+            }
+
+            float inverseDensity = densities_[i] > 0.0f ? 1.0f / densities_[i] : 0.0f;
+            accelerationX_[i] = HorizontalSum(fx) * inverseDensity;
+            accelerationY_[i] = HorizontalSum(fy) * inverseDensity + settings_.gravity;
+            accelerationZ_[i] = HorizontalSum(fz) * inverseDensity;
+        }
+    });
+}
+
+void FluidSystem::Integrate(float deltaTime) {
+    NEXUS_PROFILE_SCOPE("FluidSystem::Integrate");
+    // Semi-implicit Euler, four particles at a time; the padding lanes integrate harmlessly
+    ForRange(particles_.size(), [&](size_t begin, size_t end) {
+        const __m128 dt = _mm_set1_ps(deltaTime);
+        for (size_t i = begin; i < end; i += 4) {
+            __m128 vx = _mm_add_ps(_mm_loadu_ps(&velocityX_[i]), _mm_mul_ps(_mm_loadu_ps(&accelerationX_[i]), dt));
+            __m128 vy = _mm_add_ps(_mm_loadu_ps(&velocityY_[i]), _mm_mul_ps(_mm_loadu_ps(&accelerationY_[i]), dt));
+            __m128 vz = _mm_add_ps(_mm_loadu_ps(&velocityZ_[i]), _mm_mul_ps(_mm_loadu_ps(&accelerationZ_[i]), dt));
+            _mm_storeu_ps(&velocityX_[i], vx);
+            _mm_storeu_ps(&velocityY_[i], vy);
+            _mm_storeu_ps(&velocityZ_[i], vz);
+            _mm_storeu_ps(&positionX_[i], _mm_add_ps(_mm_loadu_ps(&positionX_[i]), _mm_mul_ps(vx, dt)));
+            _mm_storeu_ps(&positionY_[i], _mm_add_ps(_mm_loadu_ps(&positionY_[i]), _mm_mul_ps(vy, dt)));
+            _mm_storeu_ps(&positionZ_[i], _mm_add_ps(_mm_loadu_ps(&positionZ_[i]), _mm_mul_ps(vz, dt)));
+        }
+    });
+}
+
+void FluidSystem::HandleCollisions() {
+    NEXUS_PROFILE_SCOPE("FluidSystem::HandleCollisions");
+    ForRange(particles_.size(), [&](size_t begin, size_t end) {
+        const __m128 damping = _mm_set1_ps(-settings_.boundaryDamping);
+        // Clamps one axis to [min, max], reflecting and damping the velocity of particles that
+        // crossed a wall while moving into it
+        auto clampAxis = [&damping](float* position, float* velocity, float minimum, float maximum) {
+            __m128 p = _mm_loadu_ps(position);
+            __m128 v = _mm_loadu_ps(velocity);
+            __m128 lo = _mm_set1_ps(minimum);
+            __m128 hi = _mm_set1_ps(maximum);
+            __m128 zero = _mm_setzero_ps();
+            __m128 bounce = _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(p, lo), _mm_cmplt_ps(v, zero)),
+                                      _mm_and_ps(_mm_cmpgt_ps(p, hi), _mm_cmpgt_ps(v, zero)));
+            v = _mm_or_ps(_mm_and_ps(bounce, _mm_mul_ps(v, damping)), _mm_andnot_ps(bounce, v));
+            _mm_storeu_ps(position, _mm_min_ps(_mm_max_ps(p, lo), hi));
+            _mm_storeu_ps(velocity, v);
+        };
+        for (size_t i = begin; i < end; i += 4) {
+            clampAxis(&positionX_[i], &velocityX_[i], boundsMin_.x, boundsMax_.x);
+            clampAxis(&positionY_[i], &velocityY_[i], boundsMin_.y, boundsMax_.y);
+            clampAxis(&positionZ_[i], &velocityZ_[i], boundsMin_.z, boundsMax_.z);
+        }
+    });
+}
+
+} // namespace Nexus
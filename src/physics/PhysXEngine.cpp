@@ -0,0 +1,707 @@
+#include "EngineConfig.h"
+
+#ifdef NEXUS_PHYSX_ENABLED
+
+#include "PhysXEngine.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace Nexus {
+
+namespace {
+
+PxDefaultAllocator g_allocator;
+PxDefaultErrorCallback g_errorCallback;
+
+// Contact points read per pair when reporting a collision
+constexpr PxU32 MAX_CONTACT_POINTS = 16;
+
+struct MaterialPreset {
+    PhysXEngine::MaterialType type;
+    float staticFriction;
+    float dynamicFriction;
+    float restitution;
+};
+
+const MaterialPreset MATERIAL_PRESETS[] = {
+    {PhysXEngine::MaterialType::Default, 0.5f, 0.5f, 0.3f},
+    {PhysXEngine::MaterialType::Metal, 0.6f, 0.4f, 0.2f},
+    {PhysXEngine::MaterialType::Wood, 0.5f, 0.4f, 0.3f},
+    {PhysXEngine::MaterialType::Stone, 0.7f, 0.6f, 0.1f},
+    {PhysXEngine::MaterialType::Rubber, 0.9f, 0.8f, 0.8f},
+    {PhysXEngine::MaterialType::Ice, 0.05f, 0.03f, 0.1f},
+    {PhysXEngine::MaterialType::Mud, 0.8f, 0.7f, 0.0f},
+    {PhysXEngine::MaterialType::Sand, 0.7f, 0.6f, 0.0f},
+    {PhysXEngine::MaterialType::Water, 0.0f, 0.0f, 0.0f},
+};
+
+} // namespace
+
+PhysXEngine::PhysXEngine()
+    : foundation_(nullptr)
+    , physics_(nullptr)
+    , dispatcher_(nullptr)
+    , scene_(nullptr)
+    , defaultMaterial_(nullptr)
+    , pvd_(nullptr)
+    , cooking_(nullptr)
+    , cudaContextManager_(nullptr)
+    , gpuDynamicsEnabled_(false)
+    , initialized_(false)
+    , paused_(false)
+    , accumulator_(0.0f)
+    , platformContext_(nullptr)
+    , frontSnapshot_(0)
+    , readingSnapshot_(-1)
+{
+}
+
+PhysXEngine::~PhysXEngine() {
+    Shutdown();
+}
+
+bool PhysXEngine::Initialize(const PhysicsSettings& settings) {
+    if (initialized_) return true;
+    settings_ = settings;
+
+    InitializePhysX();
+    if (!physics_) {
+        Logger::Error("PhysXEngine: failed to create the PhysX SDK");
+        Shutdown();
+        return false;
+    }
+
+    // The CUDA context backs GPU dynamics, the GPU broadphase and particles; CPU mode only
+    // needs it for particles
+    if (settings_.simulationMode != SimulationMode::CPU || settings_.enableParticles) {
+        InitializeGPU();
+    }
+    InitializeCooking();
+    InitializeMaterials();
+
+    simulationCallback_ = std::make_unique<SimulationEventCallback>(this);
+    SetupScene();
+    if (!scene_) {
+        Logger::Error("PhysXEngine: failed to create the scene");
+        Shutdown();
+        return false;
+    }
+
+    initialized_ = true;
+    Logger::Info(std::string("PhysXEngine initialized (") + (gpuDynamicsEnabled_ ? "GPU" : "CPU") + " dynamics)");
+    return true;
+}
+
+void PhysXEngine::Shutdown() {
+    for (ParticleSystem& particles : particleSystems_) {
+        if (particles.system && particles.buffer) particles.system->removeParticleBuffer(particles.buffer);
+        if (scene_ && particles.system) scene_->removeActor(*particles.system);
+        if (particles.buffer) particles.buffer->release();
+        if (particles.system) particles.system->release();
+        if (particles.material) particles.material->release();
+    }
+    particleSystems_.clear();
+
+    if (scene_) {
+        scene_->release();
+        scene_ = nullptr;
+    }
+    simulationCallback_.reset();
+    if (dispatcher_) {
+        dispatcher_->release();
+        dispatcher_ = nullptr;
+    }
+
+    for (auto& material : materials_) {
+        if (material.second) material.second->release();
+    }
+    materials_.clear();
+    defaultMaterial_ = nullptr;
+
+    if (cooking_) {
+        cooking_->release();
+        cooking_ = nullptr;
+    }
+    if (physics_) {
+        PxCloseExtensions();
+        physics_->release();
+        physics_ = nullptr;
+    }
+    if (cudaContextManager_) {
+        cudaContextManager_->release();
+        cudaContextManager_ = nullptr;
+    }
+    if (pvd_) {
+        pvd_->release();
+        pvd_ = nullptr;
+    }
+    if (foundation_) {
+        foundation_->release();
+        foundation_ = nullptr;
+    }
+
+    gpuDynamicsEnabled_ = false;
+    accumulator_ = 0.0f;
+    snapshots_[0].clear();
+    snapshots_[1].clear();
+    initialized_ = false;
+}
+
+void PhysXEngine::InitializePhysX() {
+    foundation_ = PxCreateFoundation(PX_PHYSICS_VERSION, g_allocator, g_errorCallback);
+    if (!foundation_) return;
+
+    physics_ = PxCreatePhysics(PX_PHYSICS_VERSION, *foundation_, PxTolerancesScale(), true, pvd_);
+    if (physics_) PxInitExtensions(*physics_, pvd_);
+}
+
+void PhysXEngine::InitializeGPU() {
+    PxCudaContextManagerDesc desc;
+    cudaContextManager_ = PxCreateCudaContextManager(*foundation_, desc, PxGetProfilerCallback());
+    if (cudaContextManager_ && !cudaContextManager_->contextIsValid()) {
+        cudaContextManager_->release();
+        cudaContextManager_ = nullptr;
+    }
+    if (!cudaContextManager_) {
+        Logger::Warning("PhysXEngine: no usable CUDA device, GPU dynamics and particles are unavailable");
+    }
+}
+
+void PhysXEngine::InitializeCooking() {
+    PxCookingParams params(physics_->getTolerancesScale());
+    // Meshes cooked for a GPU scene carry the data its narrowphase needs
+    params.buildGPUData = cudaContextManager_ != nullptr;
+    cooking_ = PxCreateCooking(PX_PHYSICS_VERSION, *foundation_, params);
+}
+
+void PhysXEngine::InitializeMaterials() {
+    for (const MaterialPreset& preset : MATERIAL_PRESETS) {
+        materials_[preset.type] = CreateMaterial(preset.staticFriction, preset.dynamicFriction, preset.restitution);
+    }
+    defaultMaterial_ = materials_[MaterialType::Default];
+}
+
+void PhysXEngine::SetupScene() {
+    PxSceneDesc sceneDesc(physics_->getTolerancesScale());
+    sceneDesc.gravity = XMFLOAT3ToPxVec3(settings_.gravity);
+    sceneDesc.filterShader = FilterShader;
+    sceneDesc.simulationEventCallback = simulationCallback_.get();
+    sceneDesc.bounceThresholdVelocity = settings_.bounceThreshold;
+    sceneDesc.dynamicTreeRebuildRateHint = static_cast<PxU32>(settings_.dynamicTreeRebuildRateHint);
+    sceneDesc.solverType = settings_.enableTGS ? PxSolverType::eTGS : PxSolverType::ePGS;
+
+    unsigned int threads = settings_.enableMultithreading ? std::max(std::thread::hardware_concurrency(), 2u) - 1 : 0;
+    dispatcher_ = PxDefaultCpuDispatcherCreate(threads);
+    sceneDesc.cpuDispatcher = dispatcher_;
+
+    if (settings_.enableCCD) sceneDesc.flags |= PxSceneFlag::eENABLE_CCD;
+    if (settings_.enablePCM) sceneDesc.flags |= PxSceneFlag::eENABLE_PCM;
+    if (settings_.enableStabilization) sceneDesc.flags |= PxSceneFlag::eENABLE_STABILIZATION;
+    if (settings_.enableAdaptiveForce) sceneDesc.flags |= PxSceneFlag::eADAPTIVE_FORCE;
+    if (settings_.enableFrictionEveryIteration) sceneDesc.flags |= PxSceneFlag::eENABLE_FRICTION_EVERY_ITERATION;
+
+    // GPU moves both the broadphase and the solver to the device, Hybrid only the broadphase
+    bool gpuBroadPhase = cudaContextManager_ && settings_.simulationMode != SimulationMode::CPU;
+    bool gpuDynamics = cudaContextManager_ && settings_.simulationMode == SimulationMode::GPU && settings_.enableGPUDynamics;
+    sceneDesc.cudaContextManager = cudaContextManager_;
+    if (gpuBroadPhase) {
+        sceneDesc.broadPhaseType = PxBroadPhaseType::eGPU;
+    }
+    if (gpuDynamics) {
+        // GPU dynamics always runs the persistent contact manifold
+        sceneDesc.flags |= PxSceneFlag::eENABLE_GPU_DYNAMICS | PxSceneFlag::eENABLE_PCM;
+        sceneDesc.gpuDynamicsConfig.maxRigidContactCount = static_cast<PxU32>(settings_.gpuMaxRigidContactCount);
+        sceneDesc.gpuDynamicsConfig.maxRigidPatchCount = static_cast<PxU32>(settings_.gpuMaxRigidPatchCount);
+        sceneDesc.gpuDynamicsConfig.heapCapacity = static_cast<PxU32>(settings_.gpuHeapCapacity);
+        sceneDesc.gpuDynamicsConfig.tempBufferCapacity = static_cast<PxU32>(settings_.gpuTempBufferCapacity);
+    }
+
+    scene_ = physics_->createScene(sceneDesc);
+    gpuDynamicsEnabled_ = scene_ && gpuDynamics;
+}
+
+PxFilterFlags PhysXEngine::FilterShader(PxFilterObjectAttributes attributes0, PxFilterData filterData0,
+                                        PxFilterObjectAttributes attributes1, PxFilterData filterData1,
+                                        PxPairFlags& pairFlags, const void*, PxU32) {
+    // word0 is the collision group, word1 the mask of groups it collides with
+    if (!(filterData0.word0 & filterData1.word1) || !(filterData1.word0 & filterData0.word1)) {
+        return PxFilterFlag::eKILL;
+    }
+
+    if (PxFilterObjectIsTrigger(attributes0) || PxFilterObjectIsTrigger(attributes1)) {
+        pairFlags = PxPairFlag::eTRIGGER_DEFAULT;
+        return PxFilterFlag::eDEFAULT;
+    }
+
+    // Contact reports are requested here so they come back from GPU pairs as well
+    pairFlags = PxPairFlag::eCONTACT_DEFAULT | PxPairFlag::eNOTIFY_TOUCH_FOUND | PxPairFlag::eNOTIFY_CONTACT_POINTS;
+    return PxFilterFlag::eDEFAULT;
+}
+
+void PhysXEngine::SetPhysicsSettings(const PhysicsSettings& settings) {
+    settings_ = settings;
+    if (scene_) {
+        scene_->setGravity(XMFLOAT3ToPxVec3(settings_.gravity));
+        scene_->setBounceThresholdVelocity(settings_.bounceThreshold);
+    }
+}
+
+void PhysXEngine::StepSimulation(float deltaTime) {
+    if (!initialized_ || paused_) return;
+
+    accumulator_ += deltaTime;
+    int steps = 0;
+    while (accumulator_ >= settings_.timeStep && steps < settings_.maxSubSteps) {
+        SimulateStep(settings_.timeStep);
+        accumulator_ -= settings_.timeStep;
+        steps++;
+    }
+    // Drop what the step budget could not catch up on rather than spiral
+    accumulator_ = std::min(accumulator_, settings_.timeStep);
+
+    if (steps > 0) PublishRenderSnapshot();
+}
+
+void PhysXEngine::StepSimulation() {
+    if (!initialized_ || paused_) return;
+    SimulateStep(settings_.timeStep);
+    PublishRenderSnapshot();
+}
+
+void PhysXEngine::SimulateStep(float timeStep) {
+    NEXUS_PROFILE_SCOPE("PhysXEngine::SimulateStep");
+    scene_->simulate(timeStep);
+    // Contact and trigger callbacks run here, on this thread, for CPU and GPU pairs alike
+    scene_->fetchResults(true);
+    if (!particleSystems_.empty()) scene_->fetchResultsParticleSystem();
+}
+
+void PhysXEngine::Sync() {
+    if (!initialized_) return;
+    // Particle results are the only ones a finished step may still be writing on the GPU
+    if (!particleSystems_.empty()) scene_->fetchResultsParticleSystem();
+}
+
+void PhysXEngine::SetGravity(const XMFLOAT3& gravity) {
+    settings_.gravity = gravity;
+    if (scene_) scene_->setGravity(XMFLOAT3ToPxVec3(gravity));
+}
+
+XMFLOAT3 PhysXEngine::GetGravity() const {
+    return settings_.gravity;
+}
+
+void PhysXEngine::SetTimeStep(float timeStep) {
+    settings_.timeStep = timeStep;
+}
+
+void PhysXEngine::PauseSimulation(bool pause) {
+    paused_ = pause;
+}
+
+PxShape* PhysXEngine::CreateShape(const RigidBodyDesc& desc) {
+    PxShape* shape = nullptr;
+    switch (desc.shapeType) {
+        case ShapeType::Box:
+            shape = CreateBoxShape(XMFLOAT3(desc.dimensions.x * 0.5f, desc.dimensions.y * 0.5f, desc.dimensions.z * 0.5f),
+                                   desc.materialType);
+            break;
+        case ShapeType::Sphere:
+            shape = CreateSphereShape(desc.dimensions.x * 0.5f, desc.materialType);
+            break;
+        case ShapeType::Capsule:
+            shape = CreateCapsuleShape(desc.dimensions.x * 0.5f, desc.dimensions.y * 0.5f, desc.materialType);
+            break;
+        case ShapeType::Plane:
+            shape = physics_->createShape(PxPlaneGeometry(), *GetMaterial(desc.materialType), true);
+            break;
+        default:
+            Logger::Warning("PhysXEngine: bodies from a desc support box, sphere, capsule and plane shapes");
+            return nullptr;
+    }
+    if (!shape) return nullptr;
+
+    PxFilterData filter(desc.collisionGroup, desc.collisionMask, 0, 0);
+    shape->setSimulationFilterData(filter);
+    shape->setQueryFilterData(filter);
+    if (desc.isTrigger) {
+        shape->setFlag(PxShapeFlag::eSIMULATION_SHAPE, false);
+        shape->setFlag(PxShapeFlag::eTRIGGER_SHAPE, true);
+    }
+    return shape;
+}
+
+PxRigidDynamic* PhysXEngine::CreateRigidDynamic(const RigidBodyDesc& desc) {
+    if (!initialized_) return nullptr;
+    if (desc.shapeType == ShapeType::Plane) {
+        Logger::Warning("PhysXEngine: planes can only be static");
+        return nullptr;
+    }
+
+    PxShape* shape = CreateShape(desc);
+    if (!shape) return nullptr;
+
+    PxRigidDynamic* body = physics_->createRigidDynamic(PxTransform(XMFLOAT3ToPxVec3(desc.position),
+                                                                    XMFLOAT4ToPxQuat(desc.rotation)));
+    body->attachShape(*shape);
+    shape->release();
+
+    PxRigidBodyExt::setMassAndUpdateInertia(*body, desc.mass);
+    body->setLinearDamping(desc.linearDamping);
+    body->setAngularDamping(desc.angularDamping);
+    body->setMaxLinearVelocity(desc.maxLinearVelocity);
+    body->setMaxAngularVelocity(desc.maxAngularVelocity);
+    body->setSleepThreshold(settings_.sleepThreshold);
+    body->setSolverIterationCounts(static_cast<PxU32>(settings_.solverIterations),
+                                   static_cast<PxU32>(settings_.velocityIterations));
+    body->setActorFlag(PxActorFlag::eDISABLE_GRAVITY, !desc.enableGravity);
+    if (desc.isKinematic) {
+        body->setRigidBodyFlag(PxRigidBodyFlag::eKINEMATIC, true);
+    } else {
+        body->setRigidBodyFlag(PxRigidBodyFlag::eENABLE_CCD, desc.enableCCD && settings_.enableCCD);
+        body->setLinearVelocity(XMFLOAT3ToPxVec3(desc.velocity));
+        body->setAngularVelocity(XMFLOAT3ToPxVec3(desc.angularVelocity));
+    }
+    body->userData = desc.userData;
+
+    scene_->addActor(*body);
+    return body;
+}
+
+PxRigidStatic* PhysXEngine::CreateRigidStatic(const RigidBodyDesc& desc) {
+    if (!initialized_) return nullptr;
+
+    PxShape* shape = CreateShape(desc);
+    if (!shape) return nullptr;
+
+    PxRigidStatic* body = physics_->createRigidStatic(PxTransform(XMFLOAT3ToPxVec3(desc.position),
+                                                                  XMFLOAT4ToPxQuat(desc.rotation)));
+    body->attachShape(*shape);
+    shape->release();
+    body->userData = desc.userData;
+
+    scene_->addActor(*body);
+    return body;
+}
+
+void PhysXEngine::DestroyRigidActor(PxRigidActor* actor) {
+    if (!actor) return;
+    if (scene_) scene_->removeActor(*actor);
+    actor->release();
+}
+
+PxShape* PhysXEngine::CreateBoxShape(const XMFLOAT3& halfExtents, const MaterialType& material) {
+    return physics_->createShape(PxBoxGeometry(XMFLOAT3ToPxVec3(halfExtents)), *GetMaterial(material), true);
+}
+
+PxShape* PhysXEngine::CreateSphereShape(float radius, const MaterialType& material) {
+    return physics_->createShape(PxSphereGeometry(radius), *GetMaterial(material), true);
+}
+
+PxShape* PhysXEngine::CreateCapsuleShape(float radius, float halfHeight, const MaterialType& material) {
+    return physics_->createShape(PxCapsuleGeometry(radius, halfHeight), *GetMaterial(material), true);
+}
+
+PxMaterial* PhysXEngine::CreateMaterial(float staticFriction, float dynamicFriction, float restitution) {
+    return physics_ ? physics_->createMaterial(staticFriction, dynamicFriction, restitution) : nullptr;
+}
+
+PxMaterial* PhysXEngine::GetMaterial(MaterialType type) {
+    return GetOrCreateMaterial(type);
+}
+
+PxMaterial* PhysXEngine::GetOrCreateMaterial(MaterialType type) {
+    auto it = materials_.find(type);
+    if (it != materials_.end()) return it->second;
+
+    // Custom starts from the default parameters until SetMaterialProperties changes them
+    PxMaterial* material = CreateMaterial(0.5f, 0.5f, 0.3f);
+    materials_[type] = material;
+    return material;
+}
+
+void PhysXEngine::SetMaterialProperties(MaterialType type, float staticFriction, float dynamicFriction, float restitution) {
+    PxMaterial* material = GetOrCreateMaterial(type);
+    if (!material) return;
+    material->setStaticFriction(staticFriction);
+    material->setDynamicFriction(dynamicFriction);
+    material->setRestitution(restitution);
+}
+
+void PhysXEngine::EnableGPUDynamics(bool enable) {
+    settings_.enableGPUDynamics = enable;
+    // The scene's GPU flags are fixed at creation
+    if (initialized_ && enable != gpuDynamicsEnabled_) {
+        Logger::Info("PhysXEngine: GPU dynamics change takes effect on the next Initialize");
+    }
+}
+
+void PhysXEngine::EnableParticles(bool enable) {
+    settings_.enableParticles = enable;
+}
+
+int PhysXEngine::CreateParticleSystem(int maxParticles, const XMFLOAT3& position) {
+    if (!initialized_ || !settings_.enableParticles || maxParticles <= 0) return -1;
+    if (!cudaContextManager_) {
+        Logger::Warning("PhysXEngine: particle systems need a CUDA context");
+        return -1;
+    }
+
+    ParticleSystem particles;
+    particles.maxParticles = static_cast<PxU32>(maxParticles);
+    particles.system = physics_->createPBDParticleSystem(*cudaContextManager_, 96);
+    particles.material = physics_->createPBDMaterial(0.05f, 0.05f, 0.0f, 0.001f, 0.5f, 0.005f, 0.05f, 0.0f, 0.0f);
+    particles.buffer = physics_->createParticleBuffer(particles.maxParticles, 1, cudaContextManager_);
+    if (!particles.system || !particles.material || !particles.buffer) {
+        if (particles.buffer) particles.buffer->release();
+        if (particles.system) particles.system->release();
+        if (particles.material) particles.material->release();
+        Logger::Error("PhysXEngine: failed to create a particle system");
+        return -1;
+    }
+
+    particles.phase = particles.system->createPhase(particles.material,
+                                                    PxParticlePhaseFlags(PxParticlePhaseFlag::eParticlePhaseSelfCollide));
+    particles.system->setRestOffset(particles.radius);
+    particles.system->setContactOffset(particles.radius * 2.0f);
+    particles.system->setParticleContactOffset(particles.radius * 2.0f);
+    particles.system->setSolidRestOffset(particles.radius);
+    particles.buffer->setNbActiveParticles(0);
+    particles.system->addParticleBuffer(particles.buffer);
+    scene_->addActor(*particles.system);
+
+    particleSystems_.push_back(particles);
+    int id = static_cast<int>(particleSystems_.size() - 1);
+    Logger::Info("PhysXEngine: particle system " + std::to_string(id) + " created at (" +
+                 std::to_string(position.x) + ", " + std::to_string(position.y) + ", " +
+                 std::to_string(position.z) + ")");
+    return id;
+}
+
+void PhysXEngine::EmitParticles(int particleSystemId, const XMFLOAT3& position, const XMFLOAT3& velocity, int count) {
+    if (particleSystemId < 0 || particleSystemId >= static_cast<int>(particleSystems_.size()) || count <= 0) return;
+    ParticleSystem& particles = particleSystems_[particleSystemId];
+    PxU32 emitted = std::min(static_cast<PxU32>(count), particles.maxParticles);
+
+    // A loose cube of particles one diameter apart, so they do not start inside each other
+    std::vector<PxVec4> positions(emitted);
+    std::vector<PxVec4> velocities(emitted, PxVec4(velocity.x, velocity.y, velocity.z, 0.0f));
+    std::vector<PxU32> phases(emitted, particles.phase);
+    PxU32 side = static_cast<PxU32>(std::ceil(std::cbrt(static_cast<float>(emitted))));
+    float spacing = particles.radius * 2.0f;
+    float start = -0.5f * spacing * static_cast<float>(side - 1);
+    for (PxU32 i = 0; i < emitted; ++i) {
+        positions[i] = PxVec4(position.x + start + spacing * static_cast<float>(i % side),
+                              position.y + start + spacing * static_cast<float>((i / side) % side),
+                              position.z + start + spacing * static_cast<float>(i / (side * side)),
+                              particles.inverseMass);
+    }
+
+    // Emission wraps around the buffer, so it is written in at most two ranges
+    PxScopedCudaLock lock(*cudaContextManager_);
+    PxU32 written = 0;
+    while (written < emitted) {
+        PxU32 first = particles.nextParticle;
+        PxU32 range = std::min(emitted - written, particles.maxParticles - first);
+        cudaContextManager_->copyHToD(particles.buffer->getPositionInvMasses() + first, positions.data() + written, range);
+        cudaContextManager_->copyHToD(particles.buffer->getVelocities() + first, velocities.data() + written, range);
+        cudaContextManager_->copyHToD(particles.buffer->getPhases() + first, phases.data() + written, range);
+        particles.activeParticles = std::max(particles.activeParticles, first + range);
+        particles.nextParticle = (first + range) % particles.maxParticles;
+        written += range;
+    }
+
+    particles.buffer->setNbActiveParticles(particles.activeParticles);
+    particles.buffer->raiseFlags(PxParticleBufferFlag::eUPDATE_POSITION);
+    particles.buffer->raiseFlags(PxParticleBufferFlag::eUPDATE_VELOCITY);
+    particles.buffer->raiseFlags(PxParticleBufferFlag::eUPDATE_PHASE);
+}
+
+void PhysXEngine::SetParticleProperties(int particleSystemId, float mass, float radius, float damping) {
+    if (particleSystemId < 0 || particleSystemId >= static_cast<int>(particleSystems_.size())) return;
+    ParticleSystem& particles = particleSystems_[particleSystemId];
+
+    particles.radius = radius;
+    particles.system->setRestOffset(radius);
+    particles.system->setContactOffset(radius * 2.0f);
+    particles.system->setParticleContactOffset(radius * 2.0f);
+    particles.system->setSolidRestOffset(radius);
+    particles.material->setDamping(damping);
+    // Mass travels as the inverse in each particle's position w, so it applies from the next emission
+    particles.inverseMass = mass > 0.0f ? 1.0f / mass : 0.0f;
+}
+
+void PhysXEngine::SetCollisionCallback(CollisionCallback callback) {
+    collisionCallback_ = std::move(callback);
+}
+
+void PhysXEngine::SetTriggerCallback(TriggerCallback callback) {
+    triggerCallback_ = std::move(callback);
+}
+
+void PhysXEngine::PublishRenderSnapshot() {
+    NEXUS_PROFILE_SCOPE("PhysXEngine::PublishRenderSnapshot");
+    int back = 1 - frontSnapshot_.load();
+
+    // The renderer still holds the buffer we would write: skip, the next publish catches up
+    if (readingSnapshot_.load() == back) return;
+
+    std::vector<RenderObject>& out = snapshots_[back];
+    out.clear();
+
+    PxU32 actorCount = scene_->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC);
+    actorScratch_.resize(actorCount);
+    if (actorCount > 0) scene_->getActors(PxActorTypeFlag::eRIGID_DYNAMIC, actorScratch_.data(), actorCount);
+    for (PxActor* actor : actorScratch_) {
+        PxRigidDynamic* body = actor->is<PxRigidDynamic>();
+        PxShape* shape = nullptr;
+        if (!body || body->getShapes(&shape, 1) == 0) continue;
+
+        RenderObject obj;
+        obj.position = PxVec3ToXMFLOAT3(body->getGlobalPose().p);
+        obj.previousPosition = obj.position;
+        PxGeometryHolder geometry(shape->getGeometry());
+        switch (geometry.getType()) {
+            case PxGeometryType::eBOX:
+                obj.shapeType = CollisionShape::Type::Box;
+                obj.scale = PxVec3ToXMFLOAT3(geometry.box().halfExtents);
+                break;
+            case PxGeometryType::eSPHERE:
+                obj.shapeType = CollisionShape::Type::Sphere;
+                obj.scale = XMFLOAT3(geometry.sphere().radius, geometry.sphere().radius, geometry.sphere().radius);
+                break;
+            case PxGeometryType::eCAPSULE:
+                obj.shapeType = CollisionShape::Type::Capsule;
+                obj.scale = XMFLOAT3(geometry.capsule().halfHeight + geometry.capsule().radius,
+                                     geometry.capsule().radius, geometry.capsule().radius);
+                break;
+            default:
+                obj.shapeType = CollisionShape::Type::Mesh;
+                break;
+        }
+        out.push_back(obj);
+    }
+
+    // Particle positions are read back from the GPU once per publish
+    for (const ParticleSystem& particles : particleSystems_) {
+        if (particles.activeParticles == 0) continue;
+        particleScratch_.resize(particles.activeParticles);
+        {
+            PxScopedCudaLock lock(*cudaContextManager_);
+            cudaContextManager_->copyDToH(particleScratch_.data(), particles.buffer->getPositionInvMasses(),
+                                          particles.activeParticles);
+        }
+        for (const PxVec4& particle : particleScratch_) {
+            RenderObject obj;
+            obj.position = XMFLOAT3(particle.x, particle.y, particle.z);
+            obj.previousPosition = obj.position;
+            obj.scale = XMFLOAT3(particles.radius, particles.radius, particles.radius);
+            obj.color = XMFLOAT4(0.4f, 0.6f, 1.0f, 1.0f);
+            obj.shapeType = CollisionShape::Type::Sphere;
+            out.push_back(obj);
+        }
+    }
+
+    frontSnapshot_.store(back);
+}
+
+RenderObjectView PhysXEngine::AcquireRenderSnapshot() const {
+    int front = frontSnapshot_.load();
+    for (;;) {
+        readingSnapshot_.store(front);
+        int current = frontSnapshot_.load();
+        if (current == front) break;
+        front = current;
+    }
+
+    RenderObjectView view;
+    view.data = snapshots_[front].data();
+    view.count = snapshots_[front].size();
+    return view;
+}
+
+void PhysXEngine::ReleaseRenderSnapshot() const {
+    readingSnapshot_.store(-1);
+}
+
+XMFLOAT3 PhysXEngine::PxVec3ToXMFLOAT3(const PxVec3& vec) {
+    return XMFLOAT3(vec.x, vec.y, vec.z);
+}
+
+PxVec3 PhysXEngine::XMFLOAT3ToPxVec3(const XMFLOAT3& vec) {
+    return PxVec3(vec.x, vec.y, vec.z);
+}
+
+XMFLOAT4 PhysXEngine::PxQuatToXMFLOAT4(const PxQuat& quat) {
+    return XMFLOAT4(quat.x, quat.y, quat.z, quat.w);
+}
+
+PxQuat PhysXEngine::XMFLOAT4ToPxQuat(const XMFLOAT4& quat) {
+    return PxQuat(quat.x, quat.y, quat.z, quat.w);
+}
+
+void PhysXEngine::SimulationEventCallback::onConstraintBreak(PxConstraintInfo*, PxU32) {
+}
+
+void PhysXEngine::SimulationEventCallback::onWake(PxActor**, PxU32) {
+}
+
+void PhysXEngine::SimulationEventCallback::onSleep(PxActor**, PxU32) {
+}
+
+void PhysXEngine::SimulationEventCallback::onContact(const PxContactPairHeader& pairHeader, const PxContactPair* pairs,
+                                                     PxU32 nbPairs) {
+    if (!engine_->collisionCallback_) return;
+    if (pairHeader.flags & (PxContactPairHeaderFlag::eREMOVED_ACTOR_0 | PxContactPairHeaderFlag::eREMOVED_ACTOR_1)) return;
+
+    PxContactPairPoint points[MAX_CONTACT_POINTS];
+    for (PxU32 i = 0; i < nbPairs; ++i) {
+        const PxContactPair& pair = pairs[i];
+        if (!(pair.events & PxPairFlag::eNOTIFY_TOUCH_FOUND)) continue;
+
+        CollisionEvent event;
+        event.actor1 = pairHeader.actors[0]->is<PxRigidActor>();
+        event.actor2 = pairHeader.actors[1]->is<PxRigidActor>();
+        event.contactPoint = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        event.contactNormal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+        event.impulse = 0.0f;
+        event.separationDistance = 0.0f;
+
+        // The deepest point stands for the contact; impulses add up over all of them
+        PxU32 count = pair.extractContacts(points, MAX_CONTACT_POINTS);
+        for (PxU32 p = 0; p < count; ++p) {
+            event.impulse += points[p].impulse.magnitude();
+            if (p == 0 || points[p].separation < event.separationDistance) {
+                event.contactPoint = engine_->PxVec3ToXMFLOAT3(points[p].position);
+                event.contactNormal = engine_->PxVec3ToXMFLOAT3(points[p].normal);
+                event.separationDistance = points[p].separation;
+            }
+        }
+        engine_->collisionCallback_(event);
+    }
+}
+
+void PhysXEngine::SimulationEventCallback::onTrigger(PxTriggerPair* pairs, PxU32 count) {
+    if (!engine_->triggerCallback_) return;
+
+    for (PxU32 i = 0; i < count; ++i) {
+        const PxTriggerPair& pair = pairs[i];
+        if (pair.flags & (PxTriggerPairFlag::eREMOVED_SHAPE_TRIGGER | PxTriggerPairFlag::eREMOVED_SHAPE_OTHER)) continue;
+
+        TriggerEvent event;
+        event.triggerActor = pair.triggerActor;
+        event.otherActor = pair.otherActor;
+        event.isEntering = pair.status == PxPairFlag::eNOTIFY_TOUCH_FOUND;
+        engine_->triggerCallback_(event);
+    }
+}
+
+void PhysXEngine::SimulationEventCallback::onAdvance(const PxRigidBody* const*, const PxTransform*, const PxU32) {
+}
+
+} // namespace Nexus
+
+#endif // NEXUS_PHYSX_ENABLED
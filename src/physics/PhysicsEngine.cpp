@@ -1,137 +1,2589 @@
 #include "PhysicsEngine.h"
+#include "BroadPhase.h"
+#include "ConstraintSolver.h"
+#include "JobSystem.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
+#include "PhysicsSnapshot.h"
+#include "Profiler.h"
+#include "StaticGeometry.h"
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 
 namespace Nexus {
 
+namespace {
+
+constexpr float GROUND_RESTITUTION = 0.8f;
+// Below this many bodies the integrator runs inline; job overhead would outweigh the work
+constexpr size_t PARALLEL_BODY_THRESHOLD = 4096;
+// Resting bodies still pick up about a step of gravity before the ground or a contact cancels
+// it, so the tolerance sits above g * dt at 60 Hz
+constexpr float SLEEP_VELOCITY = 0.25f;
+constexpr uint32_t SLEEP_STEPS = 30;          // Steps an island must stay slow before it sleeps
+constexpr uint32_t PROXY_SWEEP_PER_STEP = 64;
+constexpr size_t QUERY_PACKETS_PER_JOB = 16;
+constexpr float CCD_MOTION_FRACTION = 0.5f;   // Of the swept radius; slower bodies are not swept
+constexpr float CCD_BACKOFF = 0.01f;          // Gap left in front of a swept hit
+constexpr uint32_t MAX_STATIC_CONTACTS = 4;   // Per body and step, against all static geometry
+constexpr float STATIC_NORMAL_MERGE = 0.95f;  // Contacts with closer normals keep only the deeper
+
+constexpr uint8_t NEAR_TIER = static_cast<uint8_t>(PhysicsEngine::SimulationTier::Near);
+constexpr uint8_t MID_TIER = static_cast<uint8_t>(PhysicsEngine::SimulationTier::Mid);
+constexpr uint8_t FAR_TIER = static_cast<uint8_t>(PhysicsEngine::SimulationTier::Far);
+
+static_assert(sizeof(RigidBodyID) >= sizeof(uint64_t), "Body IDs hold a whole entity");
+
+uint64_t PackEntity(Entity entity) {
+    return (static_cast<uint64_t>(entity.generation) << 32) | entity.index;
+}
+
+Entity UnpackEntity(uint64_t id) {
+    Entity entity;
+    entity.index = static_cast<uint32_t>(id);
+    entity.generation = static_cast<uint32_t>(id >> 32);
+    return entity;
+}
+
+// Same key whichever way round the bodies come
+uint64_t PairKey(Entity a, Entity b) {
+    uint32_t low = std::min(a.index, b.index);
+    uint32_t high = std::max(a.index, b.index);
+    return (static_cast<uint64_t>(high) << 32) | low;
+}
+
+// A body's state whether it is awake or asleep; null if the entity has no body
+PhysicsBodyComponent* FindBody(const World& world, Entity entity, bool* sleeping = nullptr) {
+    if (PhysicsBodyComponent* body = world.GetComponent<PhysicsBodyComponent>(entity)) {
+        if (sleeping) *sleeping = false;
+        return body;
+    }
+    PhysicsBodyComponent* body = world.GetComponent<SleepingBodyComponent>(entity);
+    if (sleeping) *sleeping = body != nullptr;
+    return body;
+}
+
+// Same packing as WorldPartition's cells
+uint64_t RegionCellKey(int32_t x, int32_t z) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+}
+
+// Collision events and touching pairs are kept sorted by pair
+bool TouchOrder(const CollisionEvent& a, const CollisionEvent& b) {
+    return a.bodyA != b.bodyA ? a.bodyA < b.bodyA : a.bodyB < b.bodyB;
+}
+
+// Primitive meshes span [-1, 1], so the scale is the half extent. Bodies never rotate, so boxes
+// stay axis-aligned
+struct BodyShape {
+    XMFLOAT3 center;
+    XMFLOAT3 extents;
+    float radius;     // Spheres only
+    bool sphere;
+};
+
+BodyShape GetBodyShape(const World& world, Entity entity, const TransformComponent& transform) {
+    BodyShape shape;
+    shape.center = transform.position;
+    shape.extents = XMFLOAT3(std::abs(transform.scale.x), std::abs(transform.scale.y), std::abs(transform.scale.z));
+    const RenderableComponent* renderable = world.GetComponent<RenderableComponent>(entity);
+    shape.sphere = renderable && renderable->shapeType == static_cast<uint32_t>(CollisionShape::Type::Sphere);
+    shape.radius = std::max(shape.extents.x, std::max(shape.extents.y, shape.extents.z));
+    if (shape.sphere) {
+        shape.extents = XMFLOAT3(shape.radius, shape.radius, shape.radius);
+    }
+    return shape;
+}
+
+float Component(const XMFLOAT3& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+XMFLOAT3 AxisVector(int axis, float sign) {
+    return XMFLOAT3(axis == 0 ? sign : 0.0f, axis == 1 ? sign : 0.0f, axis == 2 ? sign : 0.0f);
+}
+
+// Sphere a against box b; normal points from a to b
+bool CollideSphereBox(const BodyShape& a, const BodyShape& b, XMFLOAT3& normal, float& depth, XMFLOAT3& point) {
+    XMFLOAT3 closest(std::clamp(a.center.x, b.center.x - b.extents.x, b.center.x + b.extents.x),
+                     std::clamp(a.center.y, b.center.y - b.extents.y, b.center.y + b.extents.y),
+                     std::clamp(a.center.z, b.center.z - b.extents.z, b.center.z + b.extents.z));
+    XMFLOAT3 offset(closest.x - a.center.x, closest.y - a.center.y, closest.z - a.center.z);
+    float distanceSq = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+    if (distanceSq > a.radius * a.radius) return false;
+
+    if (distanceSq > 1e-8f) {
+        float distance = std::sqrt(distanceSq);
+        normal = XMFLOAT3(offset.x / distance, offset.y / distance, offset.z / distance);
+        depth = a.radius - distance;
+        point = closest;
+        return true;
+    }
+
+    // Center inside the box: leave through the nearest face
+    int axis = 0;
+    float faceDistance = FLT_MAX;
+    float sign = 1.0f;
+    for (int i = 0; i < 3; ++i) {
+        float local = Component(a.center, i) - Component(b.center, i);
+        float distance = Component(b.extents, i) - std::abs(local);
+        if (distance < faceDistance) {
+            faceDistance = distance;
+            axis = i;
+            sign = local < 0.0f ? 1.0f : -1.0f;
+        }
+    }
+    normal = AxisVector(axis, sign);
+    depth = a.radius + faceDistance;
+    point = a.center;
+    return true;
+}
+
+// Contact between two shapes; normal points from a to b
+bool Collide(const BodyShape& a, const BodyShape& b, XMFLOAT3& normal, float& depth, XMFLOAT3& point) {
+    if (a.sphere && b.sphere) {
+        XMFLOAT3 offset(b.center.x - a.center.x, b.center.y - a.center.y, b.center.z - a.center.z);
+        float distanceSq = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+        float radii = a.radius + b.radius;
+        if (distanceSq >= radii * radii) return false;
+        float distance = std::sqrt(distanceSq);
+        normal = distance > 1e-4f ? XMFLOAT3(offset.x / distance, offset.y / distance, offset.z / distance)
+                                  : XMFLOAT3(0.0f, 1.0f, 0.0f);
+        depth = radii - distance;
+        float along = a.radius - depth * 0.5f;
+        point = XMFLOAT3(a.center.x + normal.x * along, a.center.y + normal.y * along, a.center.z + normal.z * along);
+        return true;
+    }
+    if (a.sphere) {
+        return CollideSphereBox(a, b, normal, depth, point);
+    }
+    if (b.sphere) {
+        if (!CollideSphereBox(b, a, normal, depth, point)) return false;
+        normal = XMFLOAT3(-normal.x, -normal.y, -normal.z);
+        return true;
+    }
+
+    // Boxes separate along the axis of least overlap
+    int axis = 0;
+    depth = FLT_MAX;
+    float overlapCenter[3];
+    for (int i = 0; i < 3; ++i) {
+        float low = std::max(Component(a.center, i) - Component(a.extents, i), Component(b.center, i) - Component(b.extents, i));
+        float high = std::min(Component(a.center, i) + Component(a.extents, i), Component(b.center, i) + Component(b.extents, i));
+        float overlap = high - low;
+        if (overlap <= 0.0f) return false;
+        overlapCenter[i] = (low + high) * 0.5f;
+        if (overlap < depth) {
+            depth = overlap;
+            axis = i;
+        }
+    }
+    normal = AxisVector(axis, Component(b.center, axis) >= Component(a.center, axis) ? 1.0f : -1.0f);
+    point = XMFLOAT3(overlapCenter[0], overlapCenter[1], overlapCenter[2]);
+    return true;
+}
+
+// Entry fraction along from + delta * t, t in [0, maxFraction]. Rays starting inside hit at 0
+// facing back along the ray
+bool RayCastShape(const BodyShape& shape, const XMFLOAT3& from, const XMFLOAT3& delta, float maxFraction,
+                  float& fraction, XMFLOAT3& normal) {
+    float length = std::sqrt(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+    if (length < 1e-8f) return false;
+    XMFLOAT3 back(-delta.x / length, -delta.y / length, -delta.z / length);
+
+    if (shape.sphere) {
+        XMFLOAT3 offset(from.x - shape.center.x, from.y - shape.center.y, from.z - shape.center.z);
+        float c = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z - shape.radius * shape.radius;
+        if (c <= 0.0f) {
+            fraction = 0.0f;
+            normal = back;
+            return true;
+        }
+        float a = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
+        float b = offset.x * delta.x + offset.y * delta.y + offset.z * delta.z;
+        float discriminant = b * b - a * c;
+        if (b > 0.0f || discriminant < 0.0f) return false;
+        float t = (-b - std::sqrt(discriminant)) / a;
+        if (t > maxFraction) return false;
+        fraction = t;
+        normal = XMFLOAT3((offset.x + delta.x * t) / shape.radius, (offset.y + delta.y * t) / shape.radius,
+                          (offset.z + delta.z * t) / shape.radius);
+        return true;
+    }
+
+    float enter = 0.0f;
+    float exit = maxFraction;
+    int enterAxis = -1;
+    float enterSign = 0.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        float origin = Component(from, axis);
+        float direction = Component(delta, axis);
+        float low = Component(shape.center, axis) - Component(shape.extents, axis);
+        float high = Component(shape.center, axis) + Component(shape.extents, axis);
+        if (std::abs(direction) < 1e-12f) {
+            if (origin < low || origin > high) return false;
+            continue;
+        }
+        float t1 = (low - origin) / direction;
+        float t2 = (high - origin) / direction;
+        if (std::min(t1, t2) > enter) {
+            enter = std::min(t1, t2);
+            enterAxis = axis;
+            enterSign = direction > 0.0f ? -1.0f : 1.0f;
+        }
+        exit = std::min(exit, std::max(t1, t2));
+        if (enter > exit) return false;
+    }
+    fraction = enter;
+    normal = enterAxis < 0 ? back : AxisVector(enterAxis, enterSign);
+    return true;
+}
+
+XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+float Dot(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+// Ericson, Real-Time Collision Detection 5.1.5
+XMFLOAT3 ClosestPointOnTriangle(const XMFLOAT3& p, const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c) {
+    XMFLOAT3 ab = Subtract(b, a), ac = Subtract(c, a), ap = Subtract(p, a);
+    float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return a;
+    
+    XMFLOAT3 bp = Subtract(p, b);
+    float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) return b;
+    
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float v = d1 / (d1 - d3);
+        return XMFLOAT3(a.x + ab.x * v, a.y + ab.y * v, a.z + ab.z * v);
+    }
+    
+    XMFLOAT3 cp = Subtract(p, c);
+    float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) return c;
+    
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float w = d2 / (d2 - d6);
+        return XMFLOAT3(a.x + ac.x * w, a.y + ac.y * w, a.z + ac.z * w);
+    }
+    
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return XMFLOAT3(b.x + (c.x - b.x) * w, b.y + (c.y - b.y) * w, b.z + (c.z - b.z) * w);
+    }
+    
+    float denominator = 1.0f / (va + vb + vc);
+    float v = vb * denominator, w = vc * denominator;
+    return XMFLOAT3(a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w);
+}
+
+// Shape against one static triangle, either side; normal points from the shape into the triangle
+bool CollideTriangle(const BodyShape& shape, const XMFLOAT3* triangle, XMFLOAT3& normal, float& depth, XMFLOAT3& point) {
+    XMFLOAT3 edges[3] = {Subtract(triangle[1], triangle[0]), Subtract(triangle[2], triangle[1]), Subtract(triangle[0], triangle[2])};
+    XMFLOAT3 face = Cross(edges[0], edges[1]);
+    float faceLength = std::sqrt(Dot(face, face));
+    if (faceLength < 1e-12f) return false;
+    face = XMFLOAT3(face.x / faceLength, face.y / faceLength, face.z / faceLength);
+    
+    if (shape.sphere) {
+        XMFLOAT3 closest = ClosestPointOnTriangle(shape.center, triangle[0], triangle[1], triangle[2]);
+        XMFLOAT3 offset = Subtract(closest, shape.center);
+        float distanceSq = Dot(offset, offset);
+        if (distanceSq > shape.radius * shape.radius) return false;
+        
+        if (distanceSq > 1e-8f) {
+            float distance = std::sqrt(distanceSq);
+            normal = XMFLOAT3(offset.x / distance, offset.y / distance, offset.z / distance);
+            depth = shape.radius - distance;
+        } else {
+            // Center on the triangle: push out along the face
+            normal = XMFLOAT3(-face.x, -face.y, -face.z);
+            depth = shape.radius;
+        }
+        point = closest;
+        return true;
+    }
+    
+    // Box: separating axes are the box axes, the face normal and the box axes crossed with each
+    // edge. Edge axes only win clearly shallower, so boxes on a surface are pushed off its face
+    depth = FLT_MAX;
+    float bestReach = 0.0f;
+    auto testAxis = [&](XMFLOAT3 axis, float preference) {
+        float lengthSq = Dot(axis, axis);
+        if (lengthSq < 1e-10f) return true;
+        float inverse = 1.0f / std::sqrt(lengthSq);
+        axis = XMFLOAT3(axis.x * inverse, axis.y * inverse, axis.z * inverse);
+        
+        float reach = shape.extents.x * std::abs(axis.x) + shape.extents.y * std::abs(axis.y) + shape.extents.z * std::abs(axis.z);
+        float center = Dot(shape.center, axis);
+        float p0 = Dot(triangle[0], axis), p1 = Dot(triangle[1], axis), p2 = Dot(triangle[2], axis);
+        float low = std::min(p0, std::min(p1, p2));
+        float high = std::max(p0, std::max(p1, p2));
+        float intoHigh = center + reach - low;     // Overlap if the box leaves towards -axis
+        float intoLow = high - (center - reach);   // ... or towards +axis
+        if (intoHigh <= 0.0f || intoLow <= 0.0f) return false;
+        
+        float overlap = std::min(intoHigh, intoLow);
+        if (overlap * preference < depth) {
+            depth = overlap;
+            bestReach = reach;
+            normal = intoHigh < intoLow ? axis : XMFLOAT3(-axis.x, -axis.y, -axis.z);
+        }
+        return true;
+    };
+    
+    if (!testAxis(face, 1.0f)) return false;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (!testAxis(AxisVector(axis, 1.0f), 1.0f)) return false;
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        for (const XMFLOAT3& edge : edges) {
+            if (!testAxis(Cross(AxisVector(axis, 1.0f), edge), 1.05f)) return false;
+        }
+    }
+    float along = bestReach - depth * 0.5f;
+    point = XMFLOAT3(shape.center.x + normal.x * along, shape.center.y + normal.y * along, shape.center.z + normal.z * along);
+    return true;
+}
+
+// fn(const XMFLOAT3* triangle) in world space for the collider's triangles under a world box
+template<typename Collider, typename Fn>
+void QueryStatic(const Collider& collider, const XMFLOAT3& position, const XMFLOAT3& scale, const AABB& box, Fn&& fn) {
+    AABB local = {{(box.min.x - position.x) / scale.x, (box.min.y - position.y) / scale.y, (box.min.z - position.z) / scale.z},
+                  {(box.max.x - position.x) / scale.x, (box.max.y - position.y) / scale.y, (box.max.z - position.z) / scale.z}};
+    collider.Query(local, [&](const XMFLOAT3* triangle) {
+        XMFLOAT3 placed[3];
+        for (int i = 0; i < 3; ++i) {
+            placed[i] = XMFLOAT3(triangle[i].x * scale.x + position.x, triangle[i].y * scale.y + position.y,
+                                 triangle[i].z * scale.z + position.z);
+        }
+        fn(static_cast<const XMFLOAT3*>(placed));
+    });
+}
+
+// A ray through a placement keeps its fractions; normals scale by the inverse
+template<typename Collider>
+bool RayCastStaticCollider(const Collider& collider, const XMFLOAT3& position, const XMFLOAT3& scale, const XMFLOAT3& from,
+                           const XMFLOAT3& delta, float maxFraction, float& fraction, XMFLOAT3& normal) {
+    XMFLOAT3 localFrom((from.x - position.x) / scale.x, (from.y - position.y) / scale.y, (from.z - position.z) / scale.z);
+    XMFLOAT3 localDelta(delta.x / scale.x, delta.y / scale.y, delta.z / scale.z);
+    XMFLOAT3 localNormal;
+    if (!collider.RayCast(localFrom, localDelta, maxFraction, fraction, localNormal)) return false;
+    XMFLOAT3 n(localNormal.x / scale.x, localNormal.y / scale.y, localNormal.z / scale.z);
+    float length = std::sqrt(Dot(n, n));
+    normal = XMFLOAT3(n.x / length, n.y / length, n.z / length);
+    return true;
+}
+
+
+// Characters
+constexpr float CHARACTER_CACHE_MARGIN = 1.0f;    // Static triangles are cached this far past a move
+constexpr uint32_t CHARACTER_SLIDES = 4;          // Collide-and-slide iterations per pass
+constexpr uint32_t CHARACTER_SWEEP_STEPS = 16;    // Most overlap tests along one sweep before bisecting
+constexpr uint32_t CHARACTER_BISECTIONS = 8;
+constexpr uint32_t CHARACTER_DEPENETRATION = 4;
+constexpr size_t CHARACTERS_PER_JOB = 16;
+
+struct CharacterObstacle {
+    BodyShape shape;
+    RigidBodyID body;
+};
+
+// Closest obstacle to a capsule; distance is between the obstacle and the capsule's segment,
+// so the capsule overlaps it by radius - distance
+struct CharacterContact {
+    XMFLOAT3 normal;     // Out of the obstacle, towards the capsule
+    float distance;
+    RigidBodyID body;
+    float surfaceUp;     // The y of the touched surface's own normal; up on the rim of a flat top
+    float height;        // Of the touched point
+};
+
+// Everything one move can touch. The capsule is a vertical segment halfSegment above and below
+// its center, grown by radius; nothing rotates, so against boxes and spheres the closest points
+// come in closed form
+struct CharacterGeometry {
+    const CharacterObstacle* obstacles;
+    size_t obstacleCount;
+    const XMFLOAT3* triangles;   // Three corners each
+    size_t triangleCount;
+    bool ground;
+    float groundHeight;
+    float halfSegment;
+    float radius;
+    
+    // Keeps the candidate if it is within reach and nearer than the contact so far. Given a
+    // direction (unit length), only what moving that way runs into counts, and what it runs
+    // into most squarely wins over what is nearest
+    static void Keep(const XMFLOAT3& normal, float distance, RigidBodyID body, float surfaceUp, float height, float reach,
+                     const XMFLOAT3* direction, CharacterContact& contact) {
+        if (distance >= reach) return;
+        if (direction) {
+            float facing = Dot(normal, *direction);
+            if (facing > -1e-3f) return;
+            if (contact.distance < reach && facing >= Dot(contact.normal, *direction)) return;
+        } else if (distance >= contact.distance) {
+            return;
+        }
+        contact = {normal, distance, body, surfaceUp, height};
+    }
+    
+    void CollideBox(const XMFLOAT3& center, const BodyShape& box, float reach, const XMFLOAT3* direction,
+                    CharacterContact& contact, RigidBodyID body) const {
+        XMFLOAT3 boxMin = Subtract(box.center, box.extents);
+        XMFLOAT3 boxMax(box.center.x + box.extents.x, box.center.y + box.extents.y, box.center.z + box.extents.z);
+        float bottom = center.y - halfSegment, top = center.y + halfSegment;
+        float segmentY, boxY;
+        if (top < boxMin.y) {
+            segmentY = top;
+            boxY = boxMin.y;
+        } else if (bottom > boxMax.y) {
+            segmentY = bottom;
+            boxY = boxMax.y;
+        } else {
+            segmentY = boxY = std::clamp(center.y, std::max(bottom, boxMin.y), std::min(top, boxMax.y));
+        }
+        XMFLOAT3 offset(center.x - std::clamp(center.x, boxMin.x, boxMax.x), segmentY - boxY,
+                        center.z - std::clamp(center.z, boxMin.z, boxMax.z));
+        float distanceSq = Dot(offset, offset);
+        if (distanceSq > 1e-12f) {
+            float distance = std::sqrt(distanceSq);
+            XMFLOAT3 normal(offset.x / distance, offset.y / distance, offset.z / distance);
+            Keep(normal, distance, body, bottom > boxMax.y ? 1.0f : normal.y, boxY, reach, direction, contact);
+            return;
+        }
+        
+        // The segment runs into the box: leave along the axis needing the least travel
+        float pushes[6] = {center.x - boxMin.x, boxMax.x - center.x, top - boxMin.y, boxMax.y - bottom,
+                           center.z - boxMin.z, boxMax.z - center.z};
+        int best = 0;
+        for (int i = 1; i < 6; ++i) {
+            if (pushes[i] < pushes[best]) best = i;
+        }
+        XMFLOAT3 normal = AxisVector(best / 2, (best & 1) ? 1.0f : -1.0f);
+        Keep(normal, -pushes[best], body, normal.y, std::min(top, boxMax.y), reach, direction, contact);
+    }
+    
+    void CollideSphere(const XMFLOAT3& center, const BodyShape& sphere, float reach, const XMFLOAT3* direction,
+                       CharacterContact& contact, RigidBodyID body) const {
+        XMFLOAT3 offset(center.x - sphere.center.x,
+                        std::clamp(sphere.center.y, center.y - halfSegment, center.y + halfSegment) - sphere.center.y,
+                        center.z - sphere.center.z);
+        float length = std::sqrt(Dot(offset, offset));
+        float distance = length - sphere.radius;
+        if (distance >= reach) return;
+        XMFLOAT3 normal = length > 1e-6f ? XMFLOAT3(offset.x / length, offset.y / length, offset.z / length)
+                                         : XMFLOAT3(0.0f, 1.0f, 0.0f);
+        Keep(normal, distance, body, normal.y, sphere.center.y + normal.y * sphere.radius, reach, direction, contact);
+    }
+    
+    void CollideTriangle(const XMFLOAT3& center, const XMFLOAT3* triangle, float reach, const XMFLOAT3* direction,
+                         CharacterContact& contact) const {
+        // Cheap reject on the triangle's bounds before finding closest points
+        float bottom = center.y - halfSegment - reach, top = center.y + halfSegment + reach;
+        if (std::max({triangle[0].x, triangle[1].x, triangle[2].x}) < center.x - reach ||
+            std::min({triangle[0].x, triangle[1].x, triangle[2].x}) > center.x + reach ||
+            std::max({triangle[0].z, triangle[1].z, triangle[2].z}) < center.z - reach ||
+            std::min({triangle[0].z, triangle[1].z, triangle[2].z}) > center.z + reach ||
+            std::max({triangle[0].y, triangle[1].y, triangle[2].y}) < bottom ||
+            std::min({triangle[0].y, triangle[1].y, triangle[2].y}) > top) {
+            return;
+        }
+        
+        // Alternate between the closest point on the triangle and on the segment; both are
+        // convex, so this settles on the closest pair, and a vertical segment settles fast
+        XMFLOAT3 point = center;
+        XMFLOAT3 closest = center;
+        for (int i = 0; i < 4; ++i) {
+            closest = ClosestPointOnTriangle(point, triangle[0], triangle[1], triangle[2]);
+            float y = std::clamp(closest.y, center.y - halfSegment, center.y + halfSegment);
+            if (i > 0 && y == point.y) break;
+            point.y = y;
+        }
+        XMFLOAT3 offset = Subtract(point, closest);
+        float distance = std::sqrt(Dot(offset, offset));
+        if (distance >= reach) return;
+        
+        // The face normal on the capsule's side
+        XMFLOAT3 face = Cross(Subtract(triangle[1], triangle[0]), Subtract(triangle[2], triangle[0]));
+        float faceLength = std::sqrt(Dot(face, face));
+        if (faceLength < 1e-12f) return;
+        float side = Dot(face, Subtract(center, triangle[0]));
+        if (side < 0.0f || (side == 0.0f && face.y < 0.0f)) faceLength = -faceLength;
+        face = XMFLOAT3(face.x / faceLength, face.y / faceLength, face.z / faceLength);
+        
+        // A segment piercing the triangle leaves through the face
+        XMFLOAT3 normal = distance > 1e-5f ? XMFLOAT3(offset.x / distance, offset.y / distance, offset.z / distance) : face;
+        Keep(normal, distance, PhysicsEngine::NO_BODY, face.y, closest.y, reach, direction, contact);
+    }
+    
+    // The closest obstacle nearer than reach to the segment around center, or given a
+    // direction the one within reach that faces it most squarely
+    bool FindContact(const XMFLOAT3& center, float reach, CharacterContact& contact,
+                     const XMFLOAT3* direction = nullptr) const {
+        contact.distance = FLT_MAX;
+        if (ground) {
+            Keep(XMFLOAT3(0.0f, 1.0f, 0.0f), center.y - halfSegment - groundHeight, PhysicsEngine::NO_BODY, 1.0f, groundHeight,
+                 reach, direction, contact);
+        }
+        for (size_t i = 0; i < obstacleCount; ++i) {
+            const CharacterObstacle& obstacle = obstacles[i];
+            if (obstacle.shape.sphere) {
+                CollideSphere(center, obstacle.shape, reach, direction, contact, obstacle.body);
+            } else {
+                CollideBox(center, obstacle.shape, reach, direction, contact, obstacle.body);
+            }
+        }
+        for (size_t i = 0; i < triangleCount; ++i) {
+            CollideTriangle(center, triangles + i * 3, reach, direction, contact);
+        }
+        return contact.distance < reach;
+    }
+    
+    // Fraction of delta the capsule travels from center before something comes nearer than
+    // reach. Steps no longer than the radius cannot pass through anything, and the step that
+    // hits is bisected. What is already that near at the start only blocks getting nearer
+    float Sweep(const XMFLOAT3& center, const XMFLOAT3& delta, float reach) const {
+        float length = std::sqrt(Dot(delta, delta));
+        if (length < 1e-6f) return 1.0f;
+        CharacterContact contact;
+        if (FindContact(center, reach, contact)) reach = contact.distance - 1e-4f;
+        
+        auto blocked = [&](float t) {
+            XMFLOAT3 at(center.x + delta.x * t, center.y + delta.y * t, center.z + delta.z * t);
+            return FindContact(at, reach, contact);
+        };
+        uint32_t steps = std::clamp(static_cast<uint32_t>(std::ceil(length / radius)), 1u, CHARACTER_SWEEP_STEPS);
+        float free = 0.0f;
+        for (uint32_t step = 1; step <= steps; ++step) {
+            float t = static_cast<float>(step) / steps;
+            if (!blocked(t)) {
+                free = t;
+                continue;
+            }
+            for (uint32_t i = 0; i < CHARACTER_BISECTIONS; ++i) {
+                float middle = (free + t) * 0.5f;
+                if (blocked(middle)) t = middle;
+                else free = middle;
+            }
+            return free;
+        }
+        return 1.0f;
+    }
+};
+
+// Everything a character's move may reach: both ends grown by the capsule, the step it may
+// climb and the ground it may follow down
+AABB CharacterMoveBounds(const PhysicsEngine::CharacterSettings& settings, const XMFLOAT3& position,
+                         const XMFLOAT3& displacement) {
+    float halfHeight = std::max(settings.height * 0.5f, settings.radius);
+    float reach = settings.radius + settings.skinWidth * 2.0f;
+    XMFLOAT3 end(position.x + displacement.x, position.y + displacement.y, position.z + displacement.z);
+    AABB box;
+    box.min = XMFLOAT3(std::min(position.x, end.x) - reach, std::min(position.y, end.y) - halfHeight - settings.stepHeight - reach,
+                       std::min(position.z, end.z) - reach);
+    box.max = XMFLOAT3(std::max(position.x, end.x) + reach, std::max(position.y, end.y) + halfHeight + settings.stepHeight + reach,
+                       std::max(position.z, end.z) + reach);
+    return box;
+}
+} // namespace
+
 PhysicsEngine::PhysicsEngine() 
     : initialized_(false)
+    , world_(nullptr)
+    , jobs_(nullptr)
+    , frontSnapshot_(0)
+    , readingSnapshot_(-1)
+    , gravity_(0.0f, -9.81f, 0.0f)
+    , proxySweepCursor_(0)
+    , continuousForAll_(false)
+    , nextStaticColliderId_(1)
+    , groundEnabled_(true)
+    , groundHeight_(0.0f)
+    , staticVersion_(0)
+    , nextCharacterId_(1)
+    , nextConstraintId_(1)
+    , nextRagdollId_(1)
+    , midElapsed_(0.0f)
+    , midSteps_(0)
+    , midStepDue_(false)
 {
 }
 
-PhysicsEngine::~PhysicsEngine() {
-    Shutdown();
+PhysicsEngine::~PhysicsEngine() {
+    Shutdown();
+}
+
+bool PhysicsEngine::Initialize() {
+    NEXUS_MEMORY_SCOPE(MemoryTag::Physics);
+    Logger::Info("Initializing simplified physics engine...");
+    
+    // Standalone use (tools, tests) gets a private world
+    if (!world_) {
+        ownedWorld_ = std::make_unique<World>();
+        world_ = ownedWorld_.get();
+    }
+    
+    broadPhase_ = std::make_unique<BroadPhase>();
+    proxySweepCursor_ = 0;
+    solver_ = std::make_unique<ConstraintSolver>();
+    
+    // Create basic physics demo objects
+    CreatePhysicsDemo();
+    
+    initialized_ = true;
+    Logger::Info("Physics engine initialized successfully");
+    return true;
+}
+
+void PhysicsEngine::Shutdown() {
+    if (!initialized_) return;
+    
+    Logger::Info("Shutting down physics engine...");
+    
+    WaitForQueries();
+    DestroyBodies();
+    joints_.clear();
+    jointIndices_.clear();
+    jointedPairs_.clear();
+    ragdolls_.clear();
+    staticColliders_.clear();
+    characters_.clear();
+    characterIndices_.clear();
+    broadPhase_.reset();
+    solver_.reset();
+    contacts_.clear();
+    contactRows_.clear();
+    contactImpulses_.clear();
+    collisionEvents_.clear();
+    touching_.clear();
+    snapshots_[0].clear();
+    snapshots_[1].clear();
+    frozenCells_.clear();
+    simulationStats_ = SimulationStats();
+    midElapsed_ = 0.0f;
+    midSteps_ = 0;
+    world_ = nullptr;
+    ownedWorld_.reset();
+    
+    initialized_ = false;
+    Logger::Info("Physics engine shut down");
+}
+
+void PhysicsEngine::StepSimulation(float deltaTime) {
+    if (!initialized_) return;
+    
+    // Async queries read bodies the step is about to move
+    WaitForQueries();
+    
+    // Mid bodies step together once every midInterval steps, over the time gathered since
+    midElapsed_ += deltaTime;
+    midStepDue_ = ++midSteps_ >= regions_.midInterval;
+    
+    IntegrateVelocities(deltaTime);
+    SweepFastBodies();
+    
+    // Body against body, for the pairs the broadphase finds
+    UpdateBroadPhase(deltaTime);
+    ProcessCollisions();
+    SolveConstraints(deltaTime);
+    UpdateSleeping();
+    UpdateSimulationRegions();
+    UpdateCollisionEvents();
+    
+    if (midStepDue_) {
+        midElapsed_ = 0.0f;
+        midSteps_ = 0;
+    }
+}
+
+void PhysicsEngine::IntegrateVelocities(float deltaTime) {
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::IntegrateVelocities");
+    
+    // Each body is one SIMD vector throughout: gravity, integration and the ground response
+    // are branch-free selects, so a chunk streams through its transform and body arrays once
+    const XMVECTOR step = XMVectorReplicate(deltaTime);
+    const XMVECTOR gravityStep = XMVectorScale(XMLoadFloat3(&gravity_), deltaTime);
+    const bool midDue = midStepDue_;
+    const XMVECTOR midStep = XMVectorReplicate(midElapsed_);
+    const XMVECTOR midGravityStep = XMVectorScale(XMLoadFloat3(&gravity_), midElapsed_);
+    const XMVECTOR ground = XMVectorReplicate(groundEnabled_ ? groundHeight_ : -FLT_MAX);
+    const XMVECTOR yMask = XMVectorSelectControl(0, 1, 0, 0);
+    const XMVECTOR groundBounce = XMVectorSet(1.0f, -GROUND_RESTITUTION, 1.0f, 1.0f);
+    
+    auto integrate = [=](size_t count, const Entity*, TransformComponent* transforms, PhysicsBodyComponent* bodies) {
+        for (size_t i = 0; i < count; ++i) {
+            // Static bodies stay where they were put
+            if (bodies[i].mass <= 0.0f) {
+                transforms[i].previousPosition = transforms[i].position;
+                continue;
+            }
+            // And mid bodies hold still between their own steps
+            const bool mid = bodies[i].simulationTier == MID_TIER;
+            if (mid && !midDue) {
+                transforms[i].previousPosition = transforms[i].position;
+                continue;
+            }
+            
+            XMVECTOR position = XMLoadFloat3(&transforms[i].position);
+            XMVECTOR velocity = XMVectorAdd(XMLoadFloat3(&bodies[i].velocity), mid ? midGravityStep : gravityStep);
+            
+            // Keep the last step around for render interpolation. Multiply and add stay separate:
+            // a fused multiply-add rounds differently, and replays must match across builds
+            XMStoreFloat3(&transforms[i].previousPosition, position);
+            position = XMVectorAdd(XMVectorMultiply(velocity, mid ? midStep : step), position);
+            
+            // Below the ground plane: clamp y to it and bounce upwards with damping
+            XMVECTOR below = XMVectorAndInt(XMVectorLess(position, ground), yMask);
+            position = XMVectorSelect(position, ground, below);
+            XMVECTOR bounced = XMVectorMultiply(XMVectorNegate(XMVectorAbs(velocity)), groundBounce);
+            velocity = XMVectorSelect(velocity, bounced, below);
+            
+            XMStoreFloat3(&transforms[i].position, position);
+            XMStoreFloat3(&bodies[i].velocity, velocity);
+        }
+    };
+    
+    // Chunks are independent, so large scenes spread across the job system
+    if (jobs_ && jobs_->IsInitialized() && world_->Count<TransformComponent, PhysicsBodyComponent>() >= PARALLEL_BODY_THRESHOLD) {
+        world_->ParallelForEachChunk<TransformComponent, PhysicsBodyComponent>(*jobs_, integrate);
+    } else {
+        world_->ForEachChunk<TransformComponent, PhysicsBodyComponent>(integrate);
+    }
+}
+
+void PhysicsEngine::SweepFastBodies() {
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::SweepFastBodies");
+    if (!broadPhase_) return;
+    
+    // A sweep reads where the others ended up, including bodies already swept, so sweeps run
+    // in entity order rather than chunk order, which waking and sleeping reshuffle
+    sweptBodies_.clear();
+    world_->ForEachChunk<TransformComponent, PhysicsBodyComponent>(
+        [this](size_t count, const Entity* entities, TransformComponent*, PhysicsBodyComponent* bodies) {
+        for (size_t i = 0; i < count; ++i) {
+            // Mid bodies make do with their contacts
+            if (bodies[i].mass > 0.0f && bodies[i].simulationTier == NEAR_TIER &&
+                (continuousForAll_ || bodies[i].continuous)) {
+                sweptBodies_.push_back(entities[i]);
+            }
+        }
+    });
+    std::sort(sweptBodies_.begin(), sweptBodies_.end(), [](Entity a, Entity b) { return a.index < b.index; });
+    
+    // Other bodies are tested where they ended the step; a sweep only stops at what it reaches
+    // first, so fast bodies meeting each other may still pass and are left to the contacts
+    for (Entity entity : sweptBodies_) {
+        PhysicsBodyComponent& body = *world_->GetComponent<PhysicsBodyComponent>(entity);
+        TransformComponent& transform = *world_->GetComponent<TransformComponent>(entity);
+        XMFLOAT3 from = transform.previousPosition;
+        XMFLOAT3 delta(transform.position.x - from.x, transform.position.y - from.y, transform.position.z - from.z);
+        float distanceSq = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
+        
+        BodyShape self = GetBodyShape(*world_, entity, transform);
+        float radius = self.sphere ? self.radius : std::min(self.extents.x, std::min(self.extents.y, self.extents.z));
+        float threshold = CCD_MOTION_FRACTION * radius;
+        if (distanceSq <= threshold * threshold) continue;
+        
+        uint64_t selfId = PackEntity(entity);
+        XMFLOAT3 to = transform.position;
+        float hitFraction = 1.0f;
+        XMFLOAT3 hitNormal(0.0f, 0.0f, 0.0f);
+        bool hit = false;
+        broadPhase_->RayCastPacket(&from, &to, &radius, 1, [&](uint32_t, BroadPhase::ProxyID proxy, float maxFraction) {
+            uint64_t id = broadPhase_->GetUserData(proxy);
+            if (id == selfId) return maxFraction;
+            Entity other = UnpackEntity(id);
+            const TransformComponent* otherTransform = world_->GetComponent<TransformComponent>(other);
+            if (!otherTransform) return maxFraction;
+            
+            BodyShape shape = GetBodyShape(*world_, other, *otherTransform);
+            shape.radius += radius;
+            shape.extents = XMFLOAT3(shape.extents.x + radius, shape.extents.y + radius, shape.extents.z + radius);
+            
+            // A sweep starting inside a shape is already in contact with it; contacts handle those
+            float fraction;
+            XMFLOAT3 normal;
+            if (!RayCastShape(shape, from, delta, maxFraction, fraction, normal) || fraction <= 0.0f) return maxFraction;
+            hitFraction = fraction;
+            hitNormal = normal;
+            hit = true;
+            return fraction;
+        });
+        
+        // Static geometry is tested along the center; the sphere touches a surface as far before
+        // the center does as its radius over the cosine of the approach
+        float staticFraction;
+        XMFLOAT3 staticNormal;
+        if (RayCastStatic(from, delta, hitFraction, staticFraction, staticNormal)) {
+            float distance = std::sqrt(distanceSq);
+            float cosine = -(delta.x * staticNormal.x + delta.y * staticNormal.y + delta.z * staticNormal.z) / distance;
+            float touch = staticFraction * distance - radius / std::max(cosine, 0.25f);
+            if (touch > 0.0f) {
+                hitFraction = touch / distance;
+                hitNormal = staticNormal;
+                hit = true;
+            }
+        }
+        if (!hit) continue;
+        
+        // Stop just short of the hit and drop the speed into the surface; this step's
+        // contacts take it from there
+        float distance = std::sqrt(distanceSq);
+        float travel = std::max(hitFraction * distance - CCD_BACKOFF, 0.0f) / distance;
+        transform.position = XMFLOAT3(from.x + delta.x * travel, from.y + delta.y * travel, from.z + delta.z * travel);
+        float approach = body.velocity.x * hitNormal.x + body.velocity.y * hitNormal.y + body.velocity.z * hitNormal.z;
+        if (approach < 0.0f) {
+            body.velocity.x -= hitNormal.x * approach;
+            body.velocity.y -= hitNormal.y * approach;
+            body.velocity.z -= hitNormal.z * approach;
+        }
+    }
+}
+
+void PhysicsEngine::UpdateBroadPhase(float deltaTime) {
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::UpdateBroadPhase");
+    
+    // Only awake bodies move; sleeping ones keep their proxies where they fell asleep, and idle
+    // mid bodies where they last stepped
+    world_->ForEachChunk<TransformComponent, PhysicsBodyComponent>(
+        [this, deltaTime](size_t count, const Entity* entities, TransformComponent* transforms, PhysicsBodyComponent* bodies) {
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t userData = PackEntity(entities[i]);
+            
+            // Components are copied with their proxy, so the proxy must also belong to this entity
+            uint32_t& proxy = bodies[i].broadPhaseProxy;
+            bool owned = broadPhase_->IsProxy(proxy) && broadPhase_->GetUserData(proxy) == userData;
+            if (owned && IsIdle(bodies[i])) continue;
+            
+            BodyShape shape = GetBodyShape(*world_, entities[i], transforms[i]);
+            AABB box = AABB::FromCenterExtents(shape.center, shape.extents);
+            if (owned) {
+                const XMFLOAT3& velocity = bodies[i].velocity;
+                float step = bodies[i].simulationTier == MID_TIER ? midElapsed_ : deltaTime;
+                broadPhase_->MoveProxy(proxy, box, XMFLOAT3(velocity.x * step, velocity.y * step, velocity.z * step));
+            } else {
+                proxy = broadPhase_->CreateProxy(box, userData);
+            }
+        }
+    });
+    
+    // Entities destroyed outside the engine leave their proxies behind. Walking every proxy
+    // each step would cost as much as the sleepers save, so a few are checked per step
+    uint32_t capacity = broadPhase_->GetProxyCapacity();
+    for (uint32_t checked = 0; checked < std::min(PROXY_SWEEP_PER_STEP, capacity); ++checked) {
+        if (proxySweepCursor_ >= capacity) proxySweepCursor_ = 0;
+        uint32_t proxy = proxySweepCursor_++;
+        if (!broadPhase_->IsProxy(proxy)) continue;
+        const PhysicsBodyComponent* body = FindBody(*world_, UnpackEntity(broadPhase_->GetUserData(proxy)));
+        if (!body || body->broadPhaseProxy != proxy) {
+            broadPhase_->DestroyProxy(proxy);
+        }
+    }
+    broadPhase_->UpdatePairs();
+}
+
+void PhysicsEngine::ProcessCollisions() {
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::ProcessCollisions");
+    contacts_.clear();
+    wakeList_.clear();
+    for (const BroadPhase::Pair& pair : broadPhase_->GetPairs()) {
+        Entity entityA = UnpackEntity(broadPhase_->GetUserData(pair.a));
+        Entity entityB = UnpackEntity(broadPhase_->GetUserData(pair.b));
+        bool sleepingA, sleepingB;
+        PhysicsBodyComponent* bodyA = FindBody(*world_, entityA, &sleepingA);
+        PhysicsBodyComponent* bodyB = FindBody(*world_, entityB, &sleepingB);
+        if (!bodyA || !bodyB) continue;
+        bool stillA = sleepingA || IsIdle(*bodyA);
+        bool stillB = sleepingB || IsIdle(*bodyB);
+        if (stillA && stillB) continue;
+        if (bodyA->mass <= 0.0f && bodyB->mass <= 0.0f) continue;
+        
+        // A sleeping or idle body only matters to a moving one that can push it
+        bool dynamicA = bodyA->mass > 0.0f;
+        bool dynamicB = bodyB->mass > 0.0f;
+        if ((stillA && !dynamicB) || (stillB && !dynamicA)) continue;
+        
+        // Jointed bodies overlap by design, e.g. neighbouring ragdoll bones
+        if (!jointedPairs_.empty() && jointedPairs_.count(PairKey(entityA, entityB))) continue;
+        
+        const TransformComponent* transformA = world_->GetComponent<TransformComponent>(entityA);
+        const TransformComponent* transformB = world_->GetComponent<TransformComponent>(entityB);
+        if (!transformA || !transformB) continue;
+        
+        Contact contact;
+        if (Collide(GetBodyShape(*world_, entityA, *transformA), GetBodyShape(*world_, entityB, *transformB),
+                    contact.normal, contact.depth, contact.point)) {
+            contact.bodyA = static_cast<RigidBodyID>(PackEntity(entityA));
+            contact.bodyB = static_cast<RigidBodyID>(PackEntity(entityB));
+            contacts_.push_back(contact);
+            
+            // Static sleepers stay asleep, they do not move either way. Nor do frozen bodies, which
+            // would only freeze again; they are obstacles until a focus thaws them
+            bool wakeA = sleepingA && dynamicA && bodyA->simulationTier != FAR_TIER;
+            bool wakeB = sleepingB && dynamicB && bodyB->simulationTier != FAR_TIER;
+            if (wakeA) wakeList_.push_back(entityA);
+            if (wakeB) wakeList_.push_back(entityB);
+            
+            // A near body pulls a mid one it touches up to its own rate, and woken bodies start near
+            bool movingA = wakeA || (dynamicA && !sleepingA);
+            bool movingB = wakeB || (dynamicB && !sleepingB);
+            if (movingA && movingB) {
+                uint8_t tier = std::min(wakeA ? NEAR_TIER : bodyA->simulationTier, wakeB ? NEAR_TIER : bodyB->simulationTier);
+                if (!sleepingA) bodyA->simulationTier = tier;
+                if (!sleepingB) bodyB->simulationTier = tier;
+            }
+        }
+    }
+    
+    // Waking changes archetypes, so it waits until the pairs are done
+    for (Entity entity : wakeList_) {
+        WakeBody(entity);
+    }
+    
+    CollideStaticGeometry();
+}
+
+void PhysicsEngine::CollideStaticGeometry() {
+    if (staticColliders_.empty()) return;
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::CollideStaticGeometry");
+    
+    world_->ForEachChunk<TransformComponent, PhysicsBodyComponent>(
+        [this](size_t count, const Entity* entities, TransformComponent* transforms, PhysicsBodyComponent* bodies) {
+        for (size_t i = 0; i < count; ++i) {
+            if (bodies[i].mass <= 0.0f || IsIdle(bodies[i])) continue;
+            BodyShape shape = GetBodyShape(*world_, entities[i], transforms[i]);
+            AABB box = AABB::FromCenterExtents(shape.center, shape.extents);
+            
+            // A body over a mesh touches many triangles at once, mostly along the same normal;
+            // keeping the deepest contact per direction gives the solver the same answer for
+            // far fewer rows. Mid bodies keep only the deepest
+            const uint32_t maxContacts = bodies[i].simulationTier == MID_TIER ? 1u : MAX_STATIC_CONTACTS;
+            Contact found[MAX_STATIC_CONTACTS];
+            uint32_t foundCount = 0;
+            auto addContact = [&](const XMFLOAT3* triangle) {
+                Contact contact;
+                if (!CollideTriangle(shape, triangle, contact.normal, contact.depth, contact.point)) return;
+                uint32_t shallowest = 0;
+                for (uint32_t k = 0; k < foundCount; ++k) {
+                    if (Dot(found[k].normal, contact.normal) > STATIC_NORMAL_MERGE) {
+                        if (contact.depth > found[k].depth) found[k] = contact;
+                        return;
+                    }
+                    if (found[k].depth < found[shallowest].depth) shallowest = k;
+                }
+                if (foundCount < maxContacts) {
+                    found[foundCount++] = contact;
+                } else if (contact.depth > found[shallowest].depth) {
+                    found[shallowest] = contact;
+                }
+            };
+            
+            for (const StaticCollider& collider : staticColliders_) {
+                if (box.max.x < collider.boundsMin.x || box.min.x > collider.boundsMax.x ||
+                    box.max.y < collider.boundsMin.y || box.min.y > collider.boundsMax.y ||
+                    box.max.z < collider.boundsMin.z || box.min.z > collider.boundsMax.z) {
+                    continue;
+                }
+                if (collider.heightfield) {
+                    QueryStatic(*collider.heightfield, collider.position, collider.scale, box, addContact);
+                } else {
+                    QueryStatic(*collider.mesh, collider.position, collider.scale, box, addContact);
+                }
+            }
+            
+            RigidBodyID id = static_cast<RigidBodyID>(PackEntity(entities[i]));
+            for (uint32_t k = 0; k < foundCount; ++k) {
+                found[k].bodyA = id;
+                found[k].bodyB = NO_BODY;
+                contacts_.push_back(found[k]);
+            }
+        }
+    });
+}
+
+bool PhysicsEngine::RayCastStatic(const PhysicsVector3& from, const PhysicsVector3& delta, float maxFraction,
+                                  float& fraction, PhysicsVector3& normal) const {
+    bool hit = false;
+    for (const StaticCollider& collider : staticColliders_) {
+        float candidate;
+        XMFLOAT3 candidateNormal;
+        bool found = collider.heightfield
+            ? RayCastStaticCollider(*collider.heightfield, collider.position, collider.scale, from, delta, maxFraction,
+                                    candidate, candidateNormal)
+            : RayCastStaticCollider(*collider.mesh, collider.position, collider.scale, from, delta, maxFraction,
+                                    candidate, candidateNormal);
+        if (found) {
+            maxFraction = candidate;
+            fraction = candidate;
+            normal = candidateNormal;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+void PhysicsEngine::SolveConstraints(float deltaTime) {
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::SolveConstraints");
+    
+    // A joint to an awake body keeps its partner awake; waking changes archetypes, so it
+    // happens before any component pointer is taken
+    wakeList_.clear();
+    for (const Joint& joint : joints_) {
+        bool sleepingA = false, sleepingB = false;
+        PhysicsBodyComponent* bodyA = joint.worldA ? nullptr : FindBody(*world_, joint.bodyA, &sleepingA);
+        PhysicsBodyComponent* bodyB = joint.worldB ? nullptr : FindBody(*world_, joint.bodyB, &sleepingB);
+        bool awakeA = bodyA && !sleepingA && bodyA->mass > 0.0f;
+        bool awakeB = bodyB && !sleepingB && bodyB->mass > 0.0f;
+        if (sleepingA && awakeB) wakeList_.push_back(joint.bodyA);
+        if (sleepingB && awakeA) wakeList_.push_back(joint.bodyB);
+        // Tiers follow as they do for contacts
+        if (awakeA && awakeB) {
+            bodyA->simulationTier = bodyB->simulationTier = std::min(bodyA->simulationTier, bodyB->simulationTier);
+        } else if (awakeA && sleepingB) {
+            bodyA->simulationTier = NEAR_TIER;
+        } else if (awakeB && sleepingA) {
+            bodyB->simulationTier = NEAR_TIER;
+        }
+    }
+    for (Entity entity : wakeList_) {
+        WakeBody(entity);
+    }
+    
+    // Contacts and joints between tiers pulled the mid side up above, so mid islands are apart
+    // from near ones and solve on their own over their own time step
+    contactImpulses_.assign(contacts_.size(), 0.0f);
+    SolveTier(SimulationTier::Near, deltaTime);
+    if (midStepDue_ && simulationStats_.midBodies > 0) {
+        SolveTier(SimulationTier::Mid, midElapsed_);
+    }
+    
+    if (collisionCallback_) {
+        for (const Contact& contact : contacts_) {
+            collisionCallback_(contact.bodyA, contact.bodyB, contact.point);
+        }
+    }
+}
+
+void PhysicsEngine::SolveTier(SimulationTier tier, float deltaTime) {
+    // Awake dynamic bodies of the tier are the solver's bodies; everything else holds still
+    const uint8_t solving = static_cast<uint8_t>(tier);
+    solver_->Begin(deltaTime);
+    solverBodies_.clear();
+    solverTransforms_.clear();
+    world_->ForEachChunk<TransformComponent, PhysicsBodyComponent>(
+        [this, solving](size_t count, const Entity*, TransformComponent* transforms, PhysicsBodyComponent* bodies) {
+        for (size_t i = 0; i < count; ++i) {
+            if (bodies[i].mass <= 0.0f || bodies[i].simulationTier != solving) {
+                bodies[i].islandSlot = ConstraintSolver::STATIC_BODY;
+                continue;
+            }
+            bodies[i].islandSlot = solver_->AddBody(bodies[i].velocity, 1.0f / bodies[i].mass);
+            solverBodies_.push_back(&bodies[i]);
+            solverTransforms_.push_back(&transforms[i]);
+        }
+    });
+    contactRows_.assign(contacts_.size(), ConstraintSolver::NO_ROW);
+    if (solverBodies_.empty()) return;
+    
+    auto solverIndex = [this](Entity entity) {
+        const PhysicsBodyComponent* body = world_->GetComponent<PhysicsBodyComponent>(entity);
+        return body ? body->islandSlot : ConstraintSolver::STATIC_BODY;
+    };
+    
+    for (size_t i = 0; i < contacts_.size(); ++i) {
+        const Contact& contact = contacts_[i];
+        contactRows_[i] = solver_->AddContact(solverIndex(UnpackEntity(contact.bodyA)),
+                                              solverIndex(UnpackEntity(contact.bodyB)), contact.normal, contact.depth);
+    }
+    
+    for (const Joint& joint : joints_) {
+        const TransformComponent* transformA = joint.worldA ? nullptr : world_->GetComponent<TransformComponent>(joint.bodyA);
+        const TransformComponent* transformB = joint.worldB ? nullptr : world_->GetComponent<TransformComponent>(joint.bodyB);
+        if ((!joint.worldA && !transformA) || (!joint.worldB && !transformB)) continue;   // A body is gone
+        
+        uint32_t a = joint.worldA ? ConstraintSolver::STATIC_BODY : solverIndex(joint.bodyA);
+        uint32_t b = joint.worldB ? ConstraintSolver::STATIC_BODY : solverIndex(joint.bodyB);
+        if (a == ConstraintSolver::STATIC_BODY && b == ConstraintSolver::STATIC_BODY) continue;
+        
+        const XMFLOAT3& offsetA = joint.frameA.position;
+        const XMFLOAT3& offsetB = joint.frameB.position;
+        XMFLOAT3 anchorA = transformA ? XMFLOAT3(transformA->position.x + offsetA.x, transformA->position.y + offsetA.y,
+                                                 transformA->position.z + offsetA.z) : offsetA;
+        XMFLOAT3 anchorB = transformB ? XMFLOAT3(transformB->position.x + offsetB.x, transformB->position.y + offsetB.y,
+                                                 transformB->position.z + offsetB.z) : offsetB;
+        
+        if (joint.type == ConstraintType::Slider || joint.type == ConstraintType::Generic6DOF) {
+            XMVECTOR rotation = XMLoadFloat4(&joint.frameA.rotation);
+            XMFLOAT3 axes[3];
+            XMStoreFloat3(&axes[0], XMVector3Rotate(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), rotation));
+            XMStoreFloat3(&axes[1], XMVector3Rotate(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), rotation));
+            XMStoreFloat3(&axes[2], XMVector3Rotate(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), rotation));
+            float minimum[3] = {joint.minLimits.x, joint.minLimits.y, joint.minLimits.z};
+            float maximum[3] = {joint.maxLimits.x, joint.maxLimits.y, joint.maxLimits.z};
+            if (joint.type == ConstraintType::Slider) {
+                minimum[1] = maximum[1] = minimum[2] = maximum[2] = 0.0f;
+            }
+            solver_->AddAxisJoint(a, b, anchorA, anchorB, axes, minimum, maximum, 3);
+        } else {
+            solver_->AddPointJoint(a, b, anchorA, anchorB);
+        }
+    }
+    
+    solver_->Solve(jobs_);
+    for (size_t i = 0; i < contacts_.size(); ++i) {
+        if (contactRows_[i] != ConstraintSolver::NO_ROW) {
+            contactImpulses_[i] = solver_->GetImpulse(contactRows_[i]);
+        }
+    }
+    
+    // Positions already moved by the old velocities this step; add what the solve changed
+    for (uint32_t index = 0; index < solverBodies_.size(); ++index) {
+        XMFLOAT3& velocity = solverBodies_[index]->velocity;
+        XMFLOAT3& position = solverTransforms_[index]->position;
+        const XMFLOAT3& solved = solver_->GetVelocity(index);
+        position.x += (solved.x - velocity.x) * deltaTime;
+        position.y += (solved.y - velocity.y) * deltaTime;
+        position.z += (solved.z - velocity.z) * deltaTime;
+        velocity = solved;
+    }
+}
+
+void PhysicsEngine::UpdateSleeping() {
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::UpdateSleeping");
+    
+    // Every awake body starts as its own island
+    islandBodies_.clear();
+    islandParents_.clear();
+    world_->ForEachChunk<TransformComponent, PhysicsBodyComponent>(
+        [this](size_t count, const Entity* entities, TransformComponent*, PhysicsBodyComponent* bodies) {
+        for (size_t i = 0; i < count; ++i) {
+            // A mid step counts for every step it covers, and idle mid bodies keep their count
+            PhysicsBodyComponent& body = bodies[i];
+            if (!IsIdle(body)) {
+                const XMFLOAT3& v = body.velocity;
+                bool slow = body.mass <= 0.0f || v.x * v.x + v.y * v.y + v.z * v.z < SLEEP_VELOCITY * SLEEP_VELOCITY;
+                uint32_t steps = body.simulationTier == MID_TIER ? midSteps_ : 1;
+                body.restingSteps = slow ? std::min(body.restingSteps + steps, SLEEP_STEPS) : 0;
+            }
+            body.islandSlot = static_cast<uint32_t>(islandBodies_.size());
+            islandParents_.push_back(body.islandSlot);
+            islandBodies_.push_back(entities[i]);
+        }
+    });
+    
+    // Touching or jointed dynamic bodies share an island; static bodies never join one, or the
+    // ground would link everything resting on it
+    for (const Contact& contact : contacts_) {
+        const PhysicsBodyComponent* bodyA = world_->GetComponent<PhysicsBodyComponent>(UnpackEntity(contact.bodyA));
+        const PhysicsBodyComponent* bodyB = world_->GetComponent<PhysicsBodyComponent>(UnpackEntity(contact.bodyB));
+        if (!bodyA || !bodyB || bodyA->mass <= 0.0f || bodyB->mass <= 0.0f) continue;
+        uint32_t rootA = FindIsland(bodyA->islandSlot);
+        uint32_t rootB = FindIsland(bodyB->islandSlot);
+        if (rootA != rootB) islandParents_[rootA] = rootB;
+    }
+    for (const Joint& joint : joints_) {
+        if (joint.worldA || joint.worldB) continue;
+        const PhysicsBodyComponent* bodyA = world_->GetComponent<PhysicsBodyComponent>(joint.bodyA);
+        const PhysicsBodyComponent* bodyB = world_->GetComponent<PhysicsBodyComponent>(joint.bodyB);
+        if (!bodyA || !bodyB || bodyA->mass <= 0.0f || bodyB->mass <= 0.0f) continue;
+        uint32_t rootA = FindIsland(bodyA->islandSlot);
+        uint32_t rootB = FindIsland(bodyB->islandSlot);
+        if (rootA != rootB) islandParents_[rootA] = rootB;
+    }
+    
+    // An island sleeps only once all of its bodies have rested long enough
+    islandResting_.assign(islandBodies_.size(), SLEEP_STEPS);
+    for (uint32_t slot = 0; slot < islandBodies_.size(); ++slot) {
+        const PhysicsBodyComponent* body = world_->GetComponent<PhysicsBodyComponent>(islandBodies_[slot]);
+        uint32_t root = FindIsland(slot);
+        islandResting_[root] = std::min(islandResting_[root], body->restingSteps);
+    }
+    for (uint32_t slot = 0; slot < islandBodies_.size(); ++slot) {
+        if (islandResting_[FindIsland(slot)] >= SLEEP_STEPS) {
+            SleepBody(islandBodies_[slot]);
+        }
+    }
+}
+
+void PhysicsEngine::GatherTouchingPairs(std::vector<CollisionEvent>& touches) {
+    // A pair is named the same way every step: lower ID first, static geometry second
+    auto pairOf = [this](uint32_t index) {
+        const Contact& contact = contacts_[index];
+        bool swap = contact.bodyB != NO_BODY && contact.bodyB < contact.bodyA;
+        return swap ? std::make_pair(contact.bodyB, contact.bodyA) : std::make_pair(contact.bodyA, contact.bodyB);
+    };
+    eventOrder_.resize(contacts_.size());
+    for (uint32_t index = 0; index < eventOrder_.size(); ++index) {
+        eventOrder_[index] = index;
+    }
+    std::sort(eventOrder_.begin(), eventOrder_.end(), [&pairOf](uint32_t a, uint32_t b) {
+        auto pairA = pairOf(a), pairB = pairOf(b);
+        return pairA != pairB ? pairA < pairB : a < b;
+    });
+    
+    touches.clear();
+    for (size_t i = 0; i < eventOrder_.size();) {
+        auto pair = pairOf(eventOrder_[i]);
+        CollisionEvent touch;
+        touch.bodyA = pair.first;
+        touch.bodyB = pair.second;
+        touch.impulse = 0.0f;
+        touch.type = CollisionEvent::PERSIST;
+        float deepest = -FLT_MAX;
+        for (; i < eventOrder_.size() && pairOf(eventOrder_[i]) == pair; ++i) {
+            uint32_t index = eventOrder_[i];
+            const Contact& contact = contacts_[index];
+            touch.impulse += contactImpulses_[index];
+            if (contact.depth > deepest) {
+                float sign = contact.bodyA == pair.first ? 1.0f : -1.0f;
+                deepest = contact.depth;
+                touch.point = contact.point;
+                touch.normal = XMFLOAT3(contact.normal.x * sign, contact.normal.y * sign, contact.normal.z * sign);
+            }
+        }
+        const PhysicsBodyComponent* bodyA = FindBody(*world_, UnpackEntity(pair.first));
+        const PhysicsBodyComponent* bodyB = FindBody(*world_, UnpackEntity(pair.second));
+        touch.categories = (bodyA ? bodyA->eventCategories : 0) | (bodyB ? bodyB->eventCategories : 0);
+        touches.push_back(touch);
+    }
+}
+
+void PhysicsEngine::UpdateCollisionEvents() {
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::UpdateCollisionEvents");
+    
+    std::vector<CollisionEvent>& current = touchingScratch_;
+    GatherTouchingPairs(current);
+    collisionEvents_.clear();
+    
+    // A pair that stopped touching ends, unless neither body is awake: sleepers drop out of the
+    // contacts while still resting on each other, so the pair carries over untouched
+    auto endOrCarry = [this, &current](const CollisionEvent& touch) {
+        bool sleepingA = false, sleepingB = false;
+        const PhysicsBodyComponent* bodyA = FindBody(*world_, UnpackEntity(touch.bodyA), &sleepingA);
+        const PhysicsBodyComponent* bodyB =
+            touch.bodyB != NO_BODY ? FindBody(*world_, UnpackEntity(touch.bodyB), &sleepingB) : nullptr;
+        bool exists = bodyA && (bodyB || touch.bodyB == NO_BODY);
+        bool awake = (bodyA && !sleepingA && bodyA->mass > 0.0f) || (bodyB && !sleepingB && bodyB->mass > 0.0f);
+        if (exists && !awake) {
+            current.push_back(touch);
+            return;
+        }
+        CollisionEvent event = touch;
+        event.impulse = 0.0f;
+        event.type = CollisionEvent::END;
+        collisionEvents_.push_back(event);
+    };
+    
+    // Both lists are sorted by pair, so one walk tells what began, went on and ended
+    const size_t touchingCount = current.size();
+    size_t previous = 0;
+    for (size_t i = 0; i < touchingCount; ++i) {
+        while (previous < touching_.size() && TouchOrder(touching_[previous], current[i])) {
+            endOrCarry(touching_[previous++]);
+        }
+        CollisionEvent& touch = current[i];
+        bool continuing = previous < touching_.size() && !TouchOrder(touch, touching_[previous]);
+        if (continuing) ++previous;
+        touch.type = continuing ? CollisionEvent::PERSIST : CollisionEvent::BEGIN;
+        collisionEvents_.push_back(touch);
+    }
+    while (previous < touching_.size()) {
+        endOrCarry(touching_[previous++]);
+    }
+    
+    std::inplace_merge(current.begin(), current.begin() + touchingCount, current.end(), TouchOrder);
+    touching_.swap(current);
+}
+
+uint32_t PhysicsEngine::FindIsland(uint32_t slot) {
+    while (islandParents_[slot] != slot) {
+        islandParents_[slot] = islandParents_[islandParents_[slot]];
+        slot = islandParents_[slot];
+    }
+    return slot;
+}
+
+void PhysicsEngine::WakeBody(Entity entity) {
+    const SleepingBodyComponent* sleeping = world_->GetComponent<SleepingBodyComponent>(entity);
+    if (!sleeping) return;
+    
+    // Whatever woke it is near enough to step it at full rate until tiers are next set
+    PhysicsBodyComponent body = *sleeping;
+    body.restingSteps = 0;
+    body.simulationTier = NEAR_TIER;
+    world_->RemoveComponent<SleepingBodyComponent>(entity);
+    world_->AddComponent<PhysicsBodyComponent>(entity, body);
+}
+
+void PhysicsEngine::SleepBody(Entity entity) {
+    PhysicsBodyComponent* awake = world_->GetComponent<PhysicsBodyComponent>(entity);
+    if (!awake) return;
+    
+    SleepingBodyComponent sleeping;
+    static_cast<PhysicsBodyComponent&>(sleeping) = *awake;
+    sleeping.velocity = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    sleeping.restingSteps = 0;
+    
+    // Interpolation would otherwise keep blending in the last step's motion
+    if (TransformComponent* transform = world_->GetComponent<TransformComponent>(entity)) {
+        transform->previousPosition = transform->position;
+    }
+    world_->RemoveComponent<PhysicsBodyComponent>(entity);
+    world_->AddComponent<SleepingBodyComponent>(entity, sleeping);
+}
+
+void PhysicsEngine::SetBodyActive(RigidBodyID bodyId, bool active) {
+    if (!world_) return;
+    if (active) {
+        WakeBody(UnpackEntity(bodyId));
+    } else {
+        SleepBody(UnpackEntity(bodyId));
+    }
+}
+
+bool PhysicsEngine::IsBodyActive(RigidBodyID bodyId) const {
+    return world_ && world_->GetComponent<PhysicsBodyComponent>(UnpackEntity(bodyId)) != nullptr;
+}
+
+void PhysicsEngine::SetBodyContinuous(RigidBodyID bodyId, bool continuous) {
+    if (!world_) return;
+    if (PhysicsBodyComponent* body = FindBody(*world_, UnpackEntity(bodyId))) {
+        body->continuous = continuous;
+    }
+}
+
+bool PhysicsEngine::IsBodyContinuous(RigidBodyID bodyId) const {
+    const PhysicsBodyComponent* body = world_ ? FindBody(*world_, UnpackEntity(bodyId)) : nullptr;
+    return body && body->mass > 0.0f && (continuousForAll_ || body->continuous);
+}
+
+void PhysicsEngine::SetSimulationRegions(const SimulationRegions& regions) {
+    const float previousCellSize = regions_.cellSize;
+    regions_ = regions;
+    regions_.farDistance = std::max(regions_.farDistance, regions_.nearDistance);
+    regions_.hysteresis = std::max(regions_.hysteresis, 0.0f);
+    regions_.midInterval = std::max(regions_.midInterval, 1u);
+    regions_.cellSize = std::max(regions_.cellSize, 1.0f);
+    if (regions_.cellSize == previousCellSize || frozenCells_.empty()) return;
+    
+    // Frozen bodies do not move, so they go into the new cells from where they are
+    std::unordered_map<uint64_t, std::vector<Entity>> cells;
+    cells.swap(frozenCells_);
+    simulationStats_.frozenBodies = 0;
+    for (const auto& cell : cells) {
+        for (Entity entity : cell.second) {
+            const SleepingBodyComponent* body = world_->GetComponent<SleepingBodyComponent>(entity);
+            const TransformComponent* transform = world_->GetComponent<TransformComponent>(entity);
+            if (!body || !transform || body->simulationTier != FAR_TIER) continue;
+            frozenCells_[GetRegionCell(transform->position)].push_back(entity);
+            ++simulationStats_.frozenBodies;
+        }
+    }
+}
+
+void PhysicsEngine::SetSimulationFocus(uint32_t id, const PhysicsVector3& position) {
+    for (Focus& focus : foci_) {
+        if (focus.id == id) {
+            focus.position = position;
+            return;
+        }
+    }
+    foci_.push_back({ id, position });
+}
+
+void PhysicsEngine::RemoveSimulationFocus(uint32_t id) {
+    foci_.erase(std::remove_if(foci_.begin(), foci_.end(), [id](const Focus& focus) { return focus.id == id; }),
+                foci_.end());
+}
+
+PhysicsEngine::SimulationTier PhysicsEngine::GetBodySimulationTier(RigidBodyID bodyId) const {
+    const PhysicsBodyComponent* body = world_ ? FindBody(*world_, UnpackEntity(bodyId)) : nullptr;
+    return body ? static_cast<SimulationTier>(body->simulationTier) : SimulationTier::Near;
+}
+
+bool PhysicsEngine::IsIdle(const PhysicsBodyComponent& body) const {
+    return body.simulationTier == MID_TIER && !midStepDue_;
+}
+
+void PhysicsEngine::UpdateSimulationRegions() {
+    if (!midStepDue_) return;
+    if (foci_.empty() && simulationStats_.midBodies == 0 && frozenCells_.empty()) return;
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::UpdateSimulationRegions");
+    
+    // Each island takes the nearest tier of its dynamic bodies. The islands are this step's,
+    // and those that fell asleep in it are left alone
+    const float nearLeave = regions_.nearDistance + regions_.hysteresis;
+    const float farEnter = regions_.farDistance + regions_.hysteresis;
+    islandTiers_.assign(islandBodies_.size(), FAR_TIER);
+    for (uint32_t slot = 0; slot < islandBodies_.size(); ++slot) {
+        const PhysicsBodyComponent* body = world_->GetComponent<PhysicsBodyComponent>(islandBodies_[slot]);
+        const TransformComponent* transform = world_->GetComponent<TransformComponent>(islandBodies_[slot]);
+        if (!body || !transform || body->mass <= 0.0f) continue;
+        float distance = GetFocusDistance(transform->position);
+        float nearReach = body->simulationTier == NEAR_TIER ? nearLeave : regions_.nearDistance;
+        uint8_t tier = distance <= nearReach ? NEAR_TIER : distance <= farEnter ? MID_TIER : FAR_TIER;
+        uint8_t& island = islandTiers_[FindIsland(slot)];
+        island = std::min(island, tier);
+    }
+    
+    simulationStats_.nearBodies = 0;
+    simulationStats_.midBodies = 0;
+    freezeList_.clear();
+    for (uint32_t slot = 0; slot < islandBodies_.size(); ++slot) {
+        PhysicsBodyComponent* body = world_->GetComponent<PhysicsBodyComponent>(islandBodies_[slot]);
+        if (!body || body->mass <= 0.0f) continue;
+        uint8_t tier = islandTiers_[FindIsland(slot)];
+        if (tier == FAR_TIER) {
+            freezeList_.push_back(islandBodies_[slot]);
+            continue;
+        }
+        body->simulationTier = tier;
+        ++(tier == NEAR_TIER ? simulationStats_.nearBodies : simulationStats_.midBodies);
+    }
+    
+    // Freezing changes archetypes, so it waits until the tiers are set
+    for (Entity entity : freezeList_) {
+        FreezeBody(entity);
+    }
+    
+    // Frozen bodies thaw once a focus is back within farDistance, mid until the next pass says
+    // otherwise. Only the cells that close to a focus are looked at, or all of them once the
+    // last focus is gone
+    auto thawCell = [this](std::vector<Entity>& frozen) {
+        for (size_t i = 0; i < frozen.size();) {
+            Entity entity = frozen[i];
+            const SleepingBodyComponent* body = world_->GetComponent<SleepingBodyComponent>(entity);
+            const TransformComponent* transform = world_->GetComponent<TransformComponent>(entity);
+            bool stale = !body || !transform || body->simulationTier != FAR_TIER;
+            float distance = stale ? 0.0f : GetFocusDistance(transform->position);
+            if (!stale && distance > regions_.farDistance) {
+                ++i;
+                continue;
+            }
+            if (!stale) {
+                WakeBody(entity);
+                PhysicsBodyComponent* awake = world_->GetComponent<PhysicsBodyComponent>(entity);
+                awake->simulationTier = distance <= regions_.nearDistance ? NEAR_TIER : MID_TIER;
+                ++(awake->simulationTier == NEAR_TIER ? simulationStats_.nearBodies : simulationStats_.midBodies);
+            }
+            frozen[i] = frozen.back();
+            frozen.pop_back();
+            --simulationStats_.frozenBodies;
+        }
+    };
+    if (foci_.empty()) {
+        for (auto cell = frozenCells_.begin(); cell != frozenCells_.end();) {
+            thawCell(cell->second);
+            cell = cell->second.empty() ? frozenCells_.erase(cell) : std::next(cell);
+        }
+        return;
+    }
+    const float reach = regions_.farDistance;
+    for (const Focus& focus : foci_) {
+        const int32_t minX = static_cast<int32_t>(std::floor((focus.position.x - reach) / regions_.cellSize));
+        const int32_t maxX = static_cast<int32_t>(std::floor((focus.position.x + reach) / regions_.cellSize));
+        const int32_t minZ = static_cast<int32_t>(std::floor((focus.position.z - reach) / regions_.cellSize));
+        const int32_t maxZ = static_cast<int32_t>(std::floor((focus.position.z + reach) / regions_.cellSize));
+        for (int32_t z = minZ; z <= maxZ; ++z) {
+            for (int32_t x = minX; x <= maxX; ++x) {
+                auto cell = frozenCells_.find(RegionCellKey(x, z));
+                if (cell == frozenCells_.end()) continue;
+                thawCell(cell->second);
+                if (cell->second.empty()) frozenCells_.erase(cell);
+            }
+        }
+    }
+}
+
+void PhysicsEngine::FreezeBody(Entity entity) {
+    const PhysicsBodyComponent* awake = world_->GetComponent<PhysicsBodyComponent>(entity);
+    const TransformComponent* transform = world_->GetComponent<TransformComponent>(entity);
+    if (!awake || !transform) return;
+    
+    // Asleep as far as the step goes, but keeping its velocity to carry on with once it thaws
+    XMFLOAT3 velocity = awake->velocity;
+    uint64_t cell = GetRegionCell(transform->position);
+    SleepBody(entity);
+    SleepingBodyComponent* frozen = world_->GetComponent<SleepingBodyComponent>(entity);
+    frozen->velocity = velocity;
+    frozen->simulationTier = FAR_TIER;
+    frozenCells_[cell].push_back(entity);
+    ++simulationStats_.frozenBodies;
 }
 
-bool PhysicsEngine::Initialize() {
-    Logger::Info("Initializing simplified physics engine...");
+float PhysicsEngine::GetFocusDistance(const PhysicsVector3& position) const {
+    // On the ground plane, as world partition cells are measured
+    if (foci_.empty()) return 0.0f;
+    float nearestSq = FLT_MAX;
+    for (const Focus& focus : foci_) {
+        float dx = position.x - focus.position.x;
+        float dz = position.z - focus.position.z;
+        nearestSq = std::min(nearestSq, dx * dx + dz * dz);
+    }
+    return std::sqrt(nearestSq);
+}
+
+uint64_t PhysicsEngine::GetRegionCell(const PhysicsVector3& position) const {
+    return RegionCellKey(static_cast<int32_t>(std::floor(position.x / regions_.cellSize)),
+                         static_cast<int32_t>(std::floor(position.z / regions_.cellSize)));
+}
+
+void PhysicsEngine::SaveState(PhysicsSnapshot& snapshot) const {
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::SaveState");
+    if (!world_) {
+        snapshot.Clear();
+        return;
+    }
     
-    // Create basic physics demo objects
-    CreatePhysicsDemo();
+    size_t bodyCount = world_->Count<TransformComponent, PhysicsBodyComponent>() +
+                       world_->Count<TransformComponent, SleepingBodyComponent>();
+    snapshot.Reset(bodyCount, contacts_.size());
     
-    initialized_ = true;
-    Logger::Info("Physics engine initialized successfully");
+    PhysicsSnapshot::Body* records = snapshot.GetBodies();
+    size_t written = 0;
+    auto save = [&records, &written](uint32_t flags) {
+        return [&records, &written, flags](size_t count, const Entity* entities, TransformComponent* transforms, auto* bodies) {
+            for (size_t i = 0; i < count; ++i) {
+                PhysicsSnapshot::Body& record = records[written++];
+                record.index = entities[i].index;
+                record.generation = entities[i].generation;
+                record.position = transforms[i].position;
+                record.previousPosition = transforms[i].previousPosition;
+                record.velocity = bodies[i].velocity;
+                record.mass = bodies[i].mass;
+                record.restingSteps = bodies[i].restingSteps;
+                record.flags = flags | (bodies[i].continuous ? PhysicsSnapshot::BODY_CONTINUOUS : 0u);
+            }
+        };
+    };
+    world_->ForEachChunk<TransformComponent, PhysicsBodyComponent>(save(0u));
+    world_->ForEachChunk<TransformComponent, SleepingBodyComponent>(save(PhysicsSnapshot::BODY_SLEEPING));
+    
+    // Chunk order follows waking and sleeping; entity order keeps unchanged bodies at the same
+    // offsets from one snapshot to the next, which is what diffs feed on
+    std::sort(records, records + written, [](const PhysicsSnapshot::Body& a, const PhysicsSnapshot::Body& b) {
+        return a.index < b.index;
+    });
+    
+    PhysicsSnapshot::Contact* contacts = snapshot.GetContacts();
+    for (size_t i = 0; i < contacts_.size(); ++i) {
+        const Contact& contact = contacts_[i];
+        contacts[i].bodyA = static_cast<uint64_t>(contact.bodyA);
+        contacts[i].bodyB = static_cast<uint64_t>(contact.bodyB);
+        contacts[i].point = contact.point;
+        contacts[i].normal = contact.normal;
+        contacts[i].depth = contact.depth;
+        contacts[i].padding = 0;
+    }
+}
+
+bool PhysicsEngine::RestoreState(const PhysicsSnapshot& snapshot) {
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::RestoreState");
+    if (!world_ || !snapshot.IsValid()) return false;
+    
+    // Async queries read the bodies about to be overwritten
+    WaitForQueries();
+    
+    bool complete = true;
+    const PhysicsSnapshot::Body* records = snapshot.GetBodies();
+    for (size_t i = 0; i < snapshot.GetBodyCount(); ++i) {
+        const PhysicsSnapshot::Body& record = records[i];
+        Entity entity;
+        entity.index = record.index;
+        entity.generation = record.generation;
+        bool sleeping;
+        if (!world_->GetComponent<TransformComponent>(entity) || !FindBody(*world_, entity, &sleeping)) {
+            complete = false;
+            continue;
+        }
+        
+        // Sleeping and waking move the body between archetypes, so components are looked up after
+        bool sleep = (record.flags & PhysicsSnapshot::BODY_SLEEPING) != 0;
+        if (sleep && !sleeping) {
+            SleepBody(entity);
+        } else if (!sleep && sleeping) {
+            WakeBody(entity);
+        }
+        
+        PhysicsBodyComponent* body = FindBody(*world_, entity);
+        TransformComponent* transform = world_->GetComponent<TransformComponent>(entity);
+        transform->position = record.position;
+        transform->previousPosition = record.previousPosition;
+        body->velocity = record.velocity;
+        body->mass = record.mass;
+        body->restingSteps = record.restingSteps;
+        body->continuous = (record.flags & PhysicsSnapshot::BODY_CONTINUOUS) != 0;
+    }
+    
+    const PhysicsSnapshot::Contact* contacts = snapshot.GetContacts();
+    contacts_.resize(snapshot.GetContactCount());
+    for (size_t i = 0; i < contacts_.size(); ++i) {
+        contacts_[i].bodyA = static_cast<RigidBodyID>(contacts[i].bodyA);
+        contacts_[i].bodyB = static_cast<RigidBodyID>(contacts[i].bodyB);
+        contacts_[i].point = contacts[i].point;
+        contacts_[i].normal = contacts[i].normal;
+        contacts_[i].depth = contacts[i].depth;
+    }
+    
+    // The pairs touching at the saved step, so the next step's events follow on from it
+    contactImpulses_.assign(contacts_.size(), 0.0f);
+    collisionEvents_.clear();
+    GatherTouchingPairs(touching_);
+    return complete;
+}
+
+void PhysicsEngine::SetBodyTransform(RigidBodyID bodyId, const PhysicsTransform& transform) {
+    if (!world_) return;
+    Entity entity = UnpackEntity(bodyId);
+    TransformComponent* current = world_->GetComponent<TransformComponent>(entity);
+    if (!current) return;
+    
+    // A teleport is not motion, so nothing interpolates across it
+    current->position = transform.position;
+    current->previousPosition = transform.position;
+    current->rotation = transform.rotation;
+    current->scale = transform.scale;
+    WakeBody(entity);
+}
+
+void PhysicsEngine::SetBodyVelocity(RigidBodyID bodyId, const PhysicsVector3& velocity) {
+    if (!world_) return;
+    Entity entity = UnpackEntity(bodyId);
+    WakeBody(entity);
+    if (PhysicsBodyComponent* body = world_->GetComponent<PhysicsBodyComponent>(entity)) {
+        body->velocity = velocity;
+    }
+}
+
+void PhysicsEngine::ApplyImpulse(RigidBodyID bodyId, const PhysicsVector3& impulse) {
+    if (!world_) return;
+    Entity entity = UnpackEntity(bodyId);
+    const PhysicsBodyComponent* current = FindBody(*world_, entity);
+    if (!current || current->mass <= 0.0f) return;
+    
+    WakeBody(entity);
+    PhysicsBodyComponent* body = world_->GetComponent<PhysicsBodyComponent>(entity);
+    float inverseMass = 1.0f / body->mass;
+    body->velocity.x += impulse.x * inverseMass;
+    body->velocity.y += impulse.y * inverseMass;
+    body->velocity.z += impulse.z * inverseMass;
+}
+
+void PhysicsEngine::SetBodyPositions(const RigidBodyID* bodyIds, const PhysicsVector3* positions, size_t count) {
+    if (!world_) return;
+    for (size_t i = 0; i < count; ++i) {
+        Entity entity = UnpackEntity(bodyIds[i]);
+        TransformComponent* transform = world_->GetComponent<TransformComponent>(entity);
+        if (!transform) continue;
+        
+        transform->position = positions[i];
+        transform->previousPosition = positions[i];
+        WakeBody(entity);
+    }
+}
+
+void PhysicsEngine::GetBodyPositions(const RigidBodyID* bodyIds, PhysicsVector3* positions, size_t count) const {
+    if (!world_) return;
+    for (size_t i = 0; i < count; ++i) {
+        if (const TransformComponent* transform = world_->GetComponent<TransformComponent>(UnpackEntity(bodyIds[i]))) {
+            positions[i] = transform->position;
+        }
+    }
+}
+
+void PhysicsEngine::SetBodyVelocities(const RigidBodyID* bodyIds, const PhysicsVector3* velocities, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        SetBodyVelocity(bodyIds[i], velocities[i]);
+    }
+}
+
+void PhysicsEngine::ApplyImpulses(const RigidBodyID* bodyIds, const PhysicsVector3* impulses, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        ApplyImpulse(bodyIds[i], impulses[i]);
+    }
+}
+
+StaticColliderID PhysicsEngine::AddHeightfield(std::shared_ptr<const HeightfieldCollider> heightfield,
+                                              const PhysicsVector3& position, const PhysicsVector3& scale) {
+    if (!heightfield || heightfield->GetSamplesX() == 0) return 0;
+    StaticCollider collider;
+    collider.heightfield = std::move(heightfield);
+    collider.position = position;
+    collider.scale = scale;
+    const AABB& bounds = collider.heightfield->GetBounds();
+    return AddStaticCollider(std::move(collider), bounds.min, bounds.max);
+}
+
+StaticColliderID PhysicsEngine::AddTriangleMesh(std::shared_ptr<const TriangleMeshCollider> mesh,
+                                               const PhysicsVector3& position, const PhysicsVector3& scale) {
+    if (!mesh || mesh->GetTriangleCount() == 0) return 0;
+    StaticCollider collider;
+    collider.mesh = std::move(mesh);
+    collider.position = position;
+    collider.scale = scale;
+    const AABB& bounds = collider.mesh->GetBounds();
+    return AddStaticCollider(std::move(collider), bounds.min, bounds.max);
+}
+
+StaticColliderID PhysicsEngine::AddStaticCollider(StaticCollider collider, const PhysicsVector3& localMin,
+                                                  const PhysicsVector3& localMax) {
+    // Async rays may be walking the colliders
+    WaitForQueries();
+    XMFLOAT3& scale = collider.scale;
+    scale = XMFLOAT3(std::abs(scale.x), std::abs(scale.y), std::abs(scale.z));
+    if (scale.x < 1e-6f || scale.y < 1e-6f || scale.z < 1e-6f) {
+        Logger::Warning("Static collider needs a nonzero scale on every axis");
+        return 0;
+    }
+    
+    const XMFLOAT3& position = collider.position;
+    collider.boundsMin = XMFLOAT3(localMin.x * scale.x + position.x, localMin.y * scale.y + position.y,
+                                  localMin.z * scale.z + position.z);
+    collider.boundsMax = XMFLOAT3(localMax.x * scale.x + position.x, localMax.y * scale.y + position.y,
+                                  localMax.z * scale.z + position.z);
+    collider.id = nextStaticColliderId_++;
+    staticColliders_.push_back(std::move(collider));
+    ++staticVersion_;
+    return staticColliders_.back().id;
+}
+
+void PhysicsEngine::RemoveStaticCollider(StaticColliderID colliderId) {
+    WaitForQueries();
+    auto it = std::find_if(staticColliders_.begin(), staticColliders_.end(),
+                           [colliderId](const StaticCollider& collider) { return collider.id == colliderId; });
+    if (it != staticColliders_.end()) {
+        staticColliders_.erase(it);
+        ++staticVersion_;
+    }
+}
+
+void PhysicsEngine::SetGroundPlane(bool enabled, float height) {
+    groundEnabled_ = enabled;
+    groundHeight_ = height;
+}
+
+CharacterID PhysicsEngine::CreateCharacter(const CharacterSettings& settings, const PhysicsVector3& position) {
+    Character character;
+    character.id = nextCharacterId_++;
+    character.settings = settings;
+    character.settings.radius = std::max(settings.radius, 0.01f);
+    character.settings.height = std::max(settings.height, character.settings.radius * 2.0f);
+    character.settings.stepHeight = std::max(settings.stepHeight, 0.0f);
+    character.settings.skinWidth = std::max(settings.skinWidth, 1e-3f);
+    character.state.position = position;
+    character.state.velocity = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    character.state.groundNormal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+    character.state.groundBody = NO_BODY;
+    character.state.grounded = false;
+    // Empty, so the first move fills it
+    character.cacheMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+    character.cacheMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    character.cacheVersion = staticVersion_;
+    
+    characterIndices_[character.id] = characters_.size();
+    characters_.push_back(std::move(character));
+    return characters_.back().id;
+}
+
+void PhysicsEngine::DestroyCharacter(CharacterID characterId) {
+    auto it = characterIndices_.find(characterId);
+    if (it == characterIndices_.end()) return;
+    
+    size_t index = it->second;
+    characterIndices_.erase(it);
+    if (index + 1 != characters_.size()) {
+        characters_[index] = std::move(characters_.back());
+        characterIndices_[characters_[index].id] = index;
+    }
+    characters_.pop_back();
+}
+
+void PhysicsEngine::SetCharacterPosition(CharacterID characterId, const PhysicsVector3& position) {
+    auto it = characterIndices_.find(characterId);
+    if (it != characterIndices_.end()) {
+        characters_[it->second].state.position = position;
+    }
+}
+
+bool PhysicsEngine::GetCharacterState(CharacterID characterId, CharacterState& state) const {
+    auto it = characterIndices_.find(characterId);
+    if (it == characterIndices_.end()) return false;
+    state = characters_[it->second].state;
     return true;
 }
 
-void PhysicsEngine::Shutdown() {
-    if (!initialized_) return;
+void PhysicsEngine::MoveCharacters(const CharacterID* characters, const PhysicsVector3* displacements, size_t count,
+                                   float deltaTime) {
+    if (!initialized_ || count == 0) return;
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::MoveCharacters");
     
-    Logger::Info("Shutting down physics engine...");
+    // Tree queries share the broadphase's stack, so the bodies near each move are found here
+    // and only the sweeps, where the time goes, run in parallel
+    moveCharacters_.resize(count);
+    moveBodyStarts_.resize(count + 1);
+    moveBodies_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        moveBodyStarts_[i] = static_cast<uint32_t>(moveBodies_.size());
+        auto it = characterIndices_.find(characters[i]);
+        if (it == characterIndices_.end()) {
+            moveCharacters_[i] = SIZE_MAX;
+            continue;
+        }
+        moveCharacters_[i] = it->second;
+        const Character& character = characters_[it->second];
+        AABB box = CharacterMoveBounds(character.settings, character.state.position, displacements[i]);
+        broadPhase_->Query(box, [this](BroadPhase::ProxyID proxy) {
+            moveBodies_.push_back(UnpackEntity(broadPhase_->GetUserData(proxy)));
+            return true;
+        });
+    }
+    moveBodyStarts_[count] = static_cast<uint32_t>(moveBodies_.size());
+    
+    auto move = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (moveCharacters_[i] == SIZE_MAX) continue;
+            uint32_t first = moveBodyStarts_[i];
+            MoveCharacter(characters_[moveCharacters_[i]], displacements[i], moveBodies_.data() + first,
+                          moveBodyStarts_[i + 1] - first, deltaTime);
+        }
+    };
+    if (jobs_ && jobs_->IsInitialized() && count > CHARACTERS_PER_JOB) {
+        jobs_->ParallelFor(count, CHARACTERS_PER_JOB, move);
+    } else {
+        move(0, count);
+    }
+}
+
+void PhysicsEngine::MoveCharacter(Character& character, const PhysicsVector3& displacement, const Entity* bodies,
+                                  size_t bodyCount, float deltaTime) const {
+    const CharacterSettings& settings = character.settings;
+    CharacterState& state = character.state;
+    const XMFLOAT3 start = state.position;
+    const AABB bounds = CharacterMoveBounds(settings, start, displacement);
     
-    renderObjects_.clear();
-    physicsObjects_.clear();
+    // Static triangles come from the character's cache, refilled with a margin around this
+    // move when it leaves the cached bounds
+    bool cached = character.cacheVersion == staticVersion_ && bounds.min.x >= character.cacheMin.x &&
+                  bounds.min.y >= character.cacheMin.y && bounds.min.z >= character.cacheMin.z &&
+                  bounds.max.x <= character.cacheMax.x && bounds.max.y <= character.cacheMax.y &&
+                  bounds.max.z <= character.cacheMax.z;
+    if (!cached) {
+        AABB cache = {{bounds.min.x - CHARACTER_CACHE_MARGIN, bounds.min.y - CHARACTER_CACHE_MARGIN, bounds.min.z - CHARACTER_CACHE_MARGIN},
+                      {bounds.max.x + CHARACTER_CACHE_MARGIN, bounds.max.y + CHARACTER_CACHE_MARGIN, bounds.max.z + CHARACTER_CACHE_MARGIN}};
+        character.cacheMin = cache.min;
+        character.cacheMax = cache.max;
+        character.cacheVersion = staticVersion_;
+        character.triangles.clear();
+        auto add = [&character](const XMFLOAT3* triangle) {
+            character.triangles.insert(character.triangles.end(), triangle, triangle + 3);
+        };
+        for (const StaticCollider& collider : staticColliders_) {
+            if (collider.boundsMax.x < cache.min.x || collider.boundsMin.x > cache.max.x ||
+                collider.boundsMax.y < cache.min.y || collider.boundsMin.y > cache.max.y ||
+                collider.boundsMax.z < cache.min.z || collider.boundsMin.z > cache.max.z) {
+                continue;
+            }
+            if (collider.heightfield) {
+                QueryStatic(*collider.heightfield, collider.position, collider.scale, cache, add);
+            } else {
+                QueryStatic(*collider.mesh, collider.position, collider.scale, cache, add);
+            }
+        }
+    }
     
-    initialized_ = false;
-    Logger::Info("Physics engine shut down");
+    // Only what this move can reach takes part in its overlap tests
+    thread_local std::vector<CharacterObstacle> obstacles;
+    thread_local std::vector<XMFLOAT3> triangles;
+    obstacles.clear();
+    triangles.clear();
+    for (size_t i = 0; i < bodyCount; ++i) {
+        const TransformComponent* transform = world_->GetComponent<TransformComponent>(bodies[i]);
+        if (!transform) continue;
+        obstacles.push_back({GetBodyShape(*world_, bodies[i], *transform), static_cast<RigidBodyID>(PackEntity(bodies[i]))});
+    }
+    for (size_t i = 0; i < character.triangles.size(); i += 3) {
+        const XMFLOAT3* triangle = &character.triangles[i];
+        if (std::max({triangle[0].x, triangle[1].x, triangle[2].x}) < bounds.min.x ||
+            std::min({triangle[0].x, triangle[1].x, triangle[2].x}) > bounds.max.x ||
+            std::max({triangle[0].y, triangle[1].y, triangle[2].y}) < bounds.min.y ||
+            std::min({triangle[0].y, triangle[1].y, triangle[2].y}) > bounds.max.y ||
+            std::max({triangle[0].z, triangle[1].z, triangle[2].z}) < bounds.min.z ||
+            std::min({triangle[0].z, triangle[1].z, triangle[2].z}) > bounds.max.z) {
+            continue;
+        }
+        triangles.insert(triangles.end(), triangle, triangle + 3);
+    }
+    
+    CharacterGeometry geometry = {obstacles.data(), obstacles.size(), triangles.data(), triangles.size() / 3,
+                                  groundEnabled_, groundHeight_, settings.height * 0.5f - settings.radius, settings.radius};
+    const float contactReach = settings.radius + settings.skinWidth * 0.5f;   // Nearer than this stops a sweep
+    const float restReach = settings.radius + settings.skinWidth;             // Depenetration pushes out to here
+    const float minWalkableY = std::cos(settings.maxSlope);
+    XMFLOAT3 position = start;
+    
+    auto depenetrate = [&]() {
+        CharacterContact contact;
+        for (uint32_t i = 0; i < CHARACTER_DEPENETRATION && geometry.FindContact(position, contactReach, contact); ++i) {
+            float push = restReach - contact.distance;
+            position = XMFLOAT3(position.x + contact.normal.x * push, position.y + contact.normal.y * push,
+                                position.z + contact.normal.z * push);
+        }
+    };
+    
+    // Collide and slide along delta. With wallsOnly, surfaces too steep to walk on count as
+    // vertical, so sideways moves never climb them. True if a wall stopped any part of it
+    auto slide = [&](XMFLOAT3 delta, bool wallsOnly) {
+        XMFLOAT3 planes[CHARACTER_SLIDES];
+        uint32_t planeCount = 0;
+        bool hitWall = false;
+        for (uint32_t i = 0; i < CHARACTER_SLIDES && Dot(delta, delta) > 1e-12f; ++i) {
+            float t = geometry.Sweep(position, delta, contactReach);
+            position = XMFLOAT3(position.x + delta.x * t, position.y + delta.y * t, position.z + delta.z * t);
+            if (t >= 1.0f) break;
+            
+            float length = std::sqrt(Dot(delta, delta));
+            XMFLOAT3 direction(delta.x / length, delta.y / length, delta.z / length);
+            CharacterContact contact;
+            if (!geometry.FindContact(position, restReach, contact, &direction)) {
+                contact.normal = XMFLOAT3(-direction.x, -direction.y, -direction.z);
+            }
+            XMFLOAT3 normal = contact.normal;
+            if (normal.y < minWalkableY) {
+                hitWall = true;
+                float horizontal = std::sqrt(normal.x * normal.x + normal.z * normal.z);
+                if (wallsOnly && horizontal > 1e-3f) normal = XMFLOAT3(normal.x / horizontal, 0.0f, normal.z / horizontal);
+            }
+            
+            XMFLOAT3 left(delta.x * (1.0f - t), delta.y * (1.0f - t), delta.z * (1.0f - t));
+            XMFLOAT3 remaining = left;
+            float into = Dot(remaining, normal);
+            if (into < 0.0f) {
+                remaining = XMFLOAT3(remaining.x - normal.x * into, remaining.y - normal.y * into, remaining.z - normal.z * into);
+            }
+            // Still into an earlier plane: follow the crease between the two
+            for (uint32_t j = 0; j < planeCount; ++j) {
+                if (Dot(remaining, planes[j]) >= -1e-6f) continue;
+                XMFLOAT3 crease = Cross(planes[j], normal);
+                float creaseLength = std::sqrt(Dot(crease, crease));
+                float along = creaseLength > 1e-4f ? Dot(left, crease) / (creaseLength * creaseLength) : 0.0f;
+                remaining = XMFLOAT3(crease.x * along, crease.y * along, crease.z * along);
+                break;
+            }
+            planes[planeCount++] = normal;
+            delta = remaining;
+        }
+        return hitWall;
+    };
+    
+    // Down: drop as asked, plus snap more that is undone unless ground turns up within it.
+    // True if the character ends up standing, on ground at support
+    float support = 0.0f;
+    auto settle = [&](float drop, float snap) {
+        state.grounded = false;
+        state.groundNormal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+        state.groundBody = NO_BODY;
+        if (drop + snap <= 0.0f) return false;
+        
+        float top = position.y;
+        float dropped = (drop + snap) * geometry.Sweep(position, XMFLOAT3(0.0f, -(drop + snap), 0.0f), contactReach);
+        position.y = top - dropped;
+        const XMFLOAT3 downwards(0.0f, -1.0f, 0.0f);
+        CharacterContact contact;
+        bool hit = dropped < drop + snap && geometry.FindContact(position, restReach, contact, &downwards);
+        // Walkable slopes are ground, and so is the rim of a walkable top, which the capsule's
+        // rounded bottom meets at a steeper angle; that is what lets it step onto ledges
+        if (hit && (contact.normal.y >= minWalkableY || (contact.surfaceUp >= minWalkableY && contact.normal.y > 0.0f))) {
+            state.grounded = true;
+            state.groundNormal = contact.normal;
+            state.groundBody = contact.body;
+            support = contact.height;
+            // Rest a whole skin above the ground, so walking on it doesn't graze it
+            position.y += std::max(restReach - contact.distance, 0.0f) / std::max(contact.normal.y, 0.5f);
+        } else if (dropped > drop) {
+            position.y = top - drop;
+        } else if (hit) {
+            // Too steep to stand on: slide down it with the rest of the fall
+            slide(XMFLOAT3(0.0f, dropped - drop, 0.0f), false);
+        }
+        return state.grounded;
+    };
+    
+    depenetrate();
+    const bool wasGrounded = state.grounded;
+    const float rise = std::max(displacement.y, 0.0f);
+    const float fall = std::max(-displacement.y, 0.0f);
+    const XMFLOAT3 sideways(displacement.x, 0.0f, displacement.z);
+    // A grounded character follows the ground down as far as it could step up; others probe
+    // just past the skin to notice landing
+    const float snap = rise > 0.0f ? 0.0f : (wasGrounded ? settings.stepHeight : settings.skinWidth * 2.0f);
+    
+    // Up first, as far as any ceiling allows
+    if (rise > 0.0f) {
+        position.y += rise * geometry.Sweep(position, XMFLOAT3(0.0f, rise, 0.0f), contactReach);
+    }
+    
+    // Then sideways and down. A grounded character stopped by a wall tries again from a step
+    // up, kept if it got further and landed on something to stand on no higher than a step
+    XMFLOAT3 beforeSideways = position;
+    const float feet = position.y - geometry.halfSegment - settings.radius;
+    if (slide(sideways, true) && wasGrounded && rise == 0.0f && settings.stepHeight > 0.0f) {
+        XMFLOAT3 blocked = position;
+        position = beforeSideways;
+        float up = settings.stepHeight * geometry.Sweep(position, XMFLOAT3(0.0f, settings.stepHeight, 0.0f), contactReach);
+        position.y += up;
+        slide(sideways, true);
+        float blockedSq = (blocked.x - beforeSideways.x) * (blocked.x - beforeSideways.x) +
+                          (blocked.z - beforeSideways.z) * (blocked.z - beforeSideways.z);
+        float steppedSq = (position.x - beforeSideways.x) * (position.x - beforeSideways.x) +
+                          (position.z - beforeSideways.z) * (position.z - beforeSideways.z);
+        if (steppedSq <= blockedSq + 1e-8f || !settle(up + fall, snap) || support > feet + settings.stepHeight) {
+            position = blocked;
+            settle(fall, snap);
+        }
+    } else {
+        settle(fall, snap);
+    }
+    
+    // Bodies may have moved into the character since its last move
+    depenetrate();
+    state.position = position;
+    state.velocity = deltaTime > 0.0f ? XMFLOAT3((position.x - start.x) / deltaTime, (position.y - start.y) / deltaTime,
+                                                 (position.z - start.z) / deltaTime)
+                                      : XMFLOAT3(0.0f, 0.0f, 0.0f);
 }
 
-void PhysicsEngine::StepSimulation(float deltaTime) {
-    if (!initialized_) return;
+void PhysicsEngine::SetCollisionCallback(CollisionCallback callback) {
+    collisionCallback_ = std::move(callback);
+}
+
+void PhysicsEngine::SetBodyEventCategories(RigidBodyID bodyId, uint32_t categories) {
+    if (!world_) return;
+    if (PhysicsBodyComponent* body = FindBody(*world_, UnpackEntity(bodyId))) {
+        body->eventCategories = categories;
+    }
+}
+
+size_t PhysicsEngine::GetCollisionEvents(std::vector<CollisionEvent>& events, uint32_t categoryMask,
+                                         uint32_t typeMask) const {
+    size_t first = events.size();
+    for (const CollisionEvent& event : collisionEvents_) {
+        if ((event.categories & categoryMask) && (event.type & typeMask)) {
+            events.push_back(event);
+        }
+    }
+    return events.size() - first;
+}
+
+std::vector<RigidBodyID> PhysicsEngine::GetCollidingBodies(RigidBodyID bodyId) const {
+    std::vector<RigidBodyID> colliding;
+    for (const Contact& contact : contacts_) {
+        if (contact.bodyA == bodyId) colliding.push_back(contact.bodyB);
+        else if (contact.bodyB == bodyId) colliding.push_back(contact.bodyA);
+    }
+    return colliding;
+}
+
+PhysicsEngine::RaycastResult PhysicsEngine::Raycast(const PhysicsVector3& from, const PhysicsVector3& to) const {
+    RaycastResult closest = {};
+    if (!broadPhase_) return closest;
     
-    // Simple physics simulation
-    for (auto& obj : physicsObjects_) {
-        // Apply gravity
-        obj.velocity.y -= 9.81f * deltaTime;
+    XMFLOAT3 delta(to.x - from.x, to.y - from.y, to.z - from.z);
+    float length = std::sqrt(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+    float closestFraction = 1.0f;
+    broadPhase_->RayCast(from, to, [&](BroadPhase::ProxyID proxy, float maxFraction) {
+        Entity entity = UnpackEntity(broadPhase_->GetUserData(proxy));
+        const TransformComponent* transform = world_->GetComponent<TransformComponent>(entity);
+        float fraction;
+        XMFLOAT3 normal;
+        if (!transform || !RayCastShape(GetBodyShape(*world_, entity, *transform), from, delta, maxFraction, fraction, normal)) {
+            return maxFraction;
+        }
+        
+        // Only closer hits from here on
+        closest.hit = true;
+        closest.bodyId = static_cast<RigidBodyID>(PackEntity(entity));
+        closest.hitPoint = XMFLOAT3(from.x + delta.x * fraction, from.y + delta.y * fraction, from.z + delta.z * fraction);
+        closest.hitNormal = normal;
+        closest.distance = fraction * length;
+        closestFraction = fraction;
+        return fraction;
+    });
+    
+    float fraction;
+    XMFLOAT3 normal;
+    if (RayCastStatic(from, delta, closestFraction, fraction, normal)) {
+        closest.hit = true;
+        closest.bodyId = NO_BODY;
+        closest.hitPoint = XMFLOAT3(from.x + delta.x * fraction, from.y + delta.y * fraction, from.z + delta.z * fraction);
+        closest.hitNormal = normal;
+        closest.distance = fraction * length;
+    }
+    return closest;
+}
+
+std::vector<PhysicsEngine::RaycastResult> PhysicsEngine::RaycastAll(const PhysicsVector3& from, const PhysicsVector3& to) const {
+    std::vector<RaycastResult> hits;
+    if (!broadPhase_) return hits;
+    
+    XMFLOAT3 delta(to.x - from.x, to.y - from.y, to.z - from.z);
+    float length = std::sqrt(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+    broadPhase_->RayCast(from, to, [&](BroadPhase::ProxyID proxy, float maxFraction) {
+        Entity entity = UnpackEntity(broadPhase_->GetUserData(proxy));
+        const TransformComponent* transform = world_->GetComponent<TransformComponent>(entity);
+        float fraction;
+        XMFLOAT3 normal;
+        if (transform && RayCastShape(GetBodyShape(*world_, entity, *transform), from, delta, maxFraction, fraction, normal)) {
+            RaycastResult hit;
+            hit.hit = true;
+            hit.bodyId = static_cast<RigidBodyID>(PackEntity(entity));
+            hit.hitPoint = XMFLOAT3(from.x + delta.x * fraction, from.y + delta.y * fraction, from.z + delta.z * fraction);
+            hit.hitNormal = normal;
+            hit.distance = fraction * length;
+            hits.push_back(hit);
+        }
+        return maxFraction;
+    });
+    
+    // Static geometry reports only its closest hit
+    float fraction;
+    XMFLOAT3 normal;
+    if (RayCastStatic(from, delta, 1.0f, fraction, normal)) {
+        RaycastResult hit;
+        hit.hit = true;
+        hit.bodyId = NO_BODY;
+        hit.hitPoint = XMFLOAT3(from.x + delta.x * fraction, from.y + delta.y * fraction, from.z + delta.z * fraction);
+        hit.hitNormal = normal;
+        hit.distance = fraction * length;
+        hits.push_back(hit);
+    }
+    std::sort(hits.begin(), hits.end(), [](const RaycastResult& a, const RaycastResult& b) { return a.distance < b.distance; });
+    return hits;
+}
+
+void PhysicsEngine::CastPackets(const RayQuery* queries, size_t count, RaycastResult* results, size_t firstPacket,
+                                size_t endPacket) const {
+    for (size_t packet = firstPacket; packet < endPacket; ++packet) {
+        size_t first = packet * BroadPhase::PACKET_SIZE;
+        uint32_t lanes = static_cast<uint32_t>(std::min<size_t>(BroadPhase::PACKET_SIZE, count - first));
+        XMFLOAT3 from[BroadPhase::PACKET_SIZE];
+        XMFLOAT3 to[BroadPhase::PACKET_SIZE];
+        float radius[BroadPhase::PACKET_SIZE];
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            const RayQuery& query = queries[first + lane];
+            from[lane] = query.from;
+            to[lane] = query.to;
+            radius[lane] = std::max(query.radius, 0.0f);
+            results[first + lane] = RaycastResult();
+        }
+        
+        broadPhase_->RayCastPacket(from, to, radius, lanes, [&](uint32_t lane, BroadPhase::ProxyID proxy, float maxFraction) {
+            const RayQuery& query = queries[first + lane];
+            uint64_t id = broadPhase_->GetUserData(proxy);
+            if (id == query.ignoreBody) return maxFraction;
+            
+            Entity entity = UnpackEntity(id);
+            const TransformComponent* transform = world_->GetComponent<TransformComponent>(entity);
+            if (!transform) return maxFraction;
+            
+            // A swept sphere hits where its center reaches the shape grown by its radius
+            BodyShape shape = GetBodyShape(*world_, entity, *transform);
+            shape.radius += radius[lane];
+            shape.extents = XMFLOAT3(shape.extents.x + radius[lane], shape.extents.y + radius[lane], shape.extents.z + radius[lane]);
+            
+            XMFLOAT3 delta(to[lane].x - from[lane].x, to[lane].y - from[lane].y, to[lane].z - from[lane].z);
+            float fraction;
+            XMFLOAT3 normal;
+            if (!RayCastShape(shape, from[lane], delta, maxFraction, fraction, normal)) return maxFraction;
+            
+            RaycastResult& result = results[first + lane];
+            result.hit = true;
+            result.bodyId = static_cast<RigidBodyID>(id);
+            result.hitPoint = XMFLOAT3(from[lane].x + delta.x * fraction, from[lane].y + delta.y * fraction,
+                                       from[lane].z + delta.z * fraction);
+            result.hitNormal = normal;
+            result.distance = fraction * std::sqrt(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+            return fraction;
+        });
         
-        // Update position
-        obj.position.x += obj.velocity.x * deltaTime;
-        obj.position.y += obj.velocity.y * deltaTime;
-        obj.position.z += obj.velocity.z * deltaTime;
+        // Rays also hit static geometry, closer than any body they found
+        if (staticColliders_.empty()) continue;
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            if (radius[lane] > 0.0f) continue;
+            RaycastResult& result = results[first + lane];
+            XMFLOAT3 delta(to[lane].x - from[lane].x, to[lane].y - from[lane].y, to[lane].z - from[lane].z);
+            float length = std::sqrt(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+            float maxFraction = result.hit && length > 0.0f ? result.distance / length : 1.0f;
+            float fraction;
+            XMFLOAT3 normal;
+            if (!RayCastStatic(from[lane], delta, maxFraction, fraction, normal)) continue;
+            result.hit = true;
+            result.bodyId = NO_BODY;
+            result.hitPoint = XMFLOAT3(from[lane].x + delta.x * fraction, from[lane].y + delta.y * fraction,
+                                       from[lane].z + delta.z * fraction);
+            result.hitNormal = normal;
+            result.distance = fraction * length;
+        }
+    }
+}
+
+void PhysicsEngine::CastBatch(const RayQuery* queries, size_t count, RaycastResult* results) const {
+    if (count == 0) return;
+    if (!broadPhase_) {
+        std::fill(results, results + count, RaycastResult());
+        return;
+    }
+    
+    NEXUS_PROFILE_SCOPE("PhysicsEngine::CastBatch");
+    size_t packets = (count + BroadPhase::PACKET_SIZE - 1) / BroadPhase::PACKET_SIZE;
+    if (jobs_ && jobs_->IsInitialized() && packets > QUERY_PACKETS_PER_JOB) {
+        jobs_->ParallelFor(packets, QUERY_PACKETS_PER_JOB, [&](size_t begin, size_t end) {
+            CastPackets(queries, count, results, begin, end);
+        });
+    } else {
+        CastPackets(queries, count, results, 0, packets);
+    }
+}
+
+void PhysicsEngine::CastBatchAsync(const RayQuery* queries, size_t count, RaycastResult* results,
+                                   JobCounter& counter) const {
+    if (!jobs_ || !jobs_->IsInitialized() || !broadPhase_) {
+        CastBatch(queries, count, results);
+        return;
+    }
+    
+    size_t packets = (count + BroadPhase::PACKET_SIZE - 1) / BroadPhase::PACKET_SIZE;
+    for (size_t begin = 0; begin < packets; begin += QUERY_PACKETS_PER_JOB) {
+        size_t end = std::min(begin + QUERY_PACKETS_PER_JOB, packets);
+        queryJobs_.pending.fetch_add(1, std::memory_order_relaxed);
+        jobs_->Execute([this, queries, count, results, begin, end]() {
+            CastPackets(queries, count, results, begin, end);
+            queryJobs_.pending.fetch_sub(1, std::memory_order_release);
+        }, &counter);
+    }
+}
+
+void PhysicsEngine::WaitForQueries() const {
+    if (queryJobs_.IsDone()) return;
+    if (jobs_) {
+        jobs_->Wait(queryJobs_);
+    }
+}
+
+void PhysicsEngine::SetWorld(World* world) {
+    if (initialized_) {
+        Logger::Warning("PhysicsEngine::SetWorld must be called before Initialize");
+        return;
+    }
+    world_ = world;
+}
+
+void PhysicsEngine::SetJobSystem(JobSystem* jobs) {
+    jobs_ = jobs;
+}
+
+void PhysicsEngine::SetGravity(const PhysicsVector3& gravity) {
+    gravity_ = gravity;
+}
+
+PhysicsVector3 PhysicsEngine::GetGravity() const {
+    return gravity_;
+}
+
+Entity PhysicsEngine::CreateDemoBody(const XMFLOAT3& position, const XMFLOAT3& scale, const XMFLOAT4& color,
+                                     CollisionShape::Type shapeType, float mass) {
+    TransformComponent transform;
+    transform.position = position;
+    transform.previousPosition = position;
+    transform.scale = scale;
+    
+    PhysicsBodyComponent body;
+    body.mass = mass;
+    
+    RenderableComponent renderable;
+    renderable.color = color;
+    renderable.shapeType = static_cast<uint32_t>(shapeType);
+    
+    Entity entity = world_->CreateEntity(transform, body, renderable);
+    bodies_.push_back(entity);
+    return entity;
+}
+
+void PhysicsEngine::DestroyBody(Entity entity) {
+    bool sleeping = false;
+    const PhysicsBodyComponent* body = FindBody(*world_, entity, &sleeping);
+    if (broadPhase_ && body && broadPhase_->IsProxy(body->broadPhaseProxy) &&
+        broadPhase_->GetUserData(body->broadPhaseProxy) == PackEntity(entity)) {
+        broadPhase_->DestroyProxy(body->broadPhaseProxy);
+    }
+    
+    // Frozen bodies are still in the cell they froze in; world partition unloads whole cells of
+    // them at a time
+    const TransformComponent* transform = world_->GetComponent<TransformComponent>(entity);
+    if (body && sleeping && body->simulationTier == FAR_TIER && transform) {
+        auto cell = frozenCells_.find(GetRegionCell(transform->position));
+        if (cell != frozenCells_.end()) {
+            auto it = std::find(cell->second.begin(), cell->second.end(), entity);
+            if (it != cell->second.end()) {
+                *it = cell->second.back();
+                cell->second.pop_back();
+                --simulationStats_.frozenBodies;
+                if (cell->second.empty()) frozenCells_.erase(cell);
+            }
+        }
+    }
+    world_->DestroyEntity(entity);
+}
+
+void PhysicsEngine::DestroyBodies() {
+    if (world_) {
+        for (Entity entity : bodies_) {
+            DestroyBody(entity);
+        }
+    }
+    bodies_.clear();
+}
+
+RigidBodyID PhysicsEngine::CreateRigidBody(const CollisionShape& shape, const PhysicsTransform& transform, float mass,
+                                           const PhysicsMaterial& material) {
+    (void)material;   // One restitution for all contacts until bodies carry materials
+    if (!world_) return 0;
+    
+    XMFLOAT3 halfExtents;
+    switch (shape.type) {
+    case CollisionShape::Type::Sphere:
+        halfExtents = XMFLOAT3(shape.radius, shape.radius, shape.radius);
+        break;
+    case CollisionShape::Type::Capsule:
+        halfExtents = XMFLOAT3(shape.radius, shape.height * 0.5f + shape.radius, shape.radius);
+        break;
+    default:
+        halfExtents = XMFLOAT3(shape.dimensions.x * 0.5f, shape.dimensions.y * 0.5f, shape.dimensions.z * 0.5f);
+        break;
+    }
+    
+    Entity entity = CreateDemoBody(transform.position,
+                                   XMFLOAT3(halfExtents.x * transform.scale.x, halfExtents.y * transform.scale.y,
+                                            halfExtents.z * transform.scale.z),
+                                   XMFLOAT4(0.7f, 0.7f, 0.7f, 1.0f), shape.type, mass);
+    world_->GetComponent<TransformComponent>(entity)->rotation = transform.rotation;
+    return static_cast<RigidBodyID>(PackEntity(entity));
+}
+
+void PhysicsEngine::RemoveRigidBody(RigidBodyID bodyId) {
+    if (!world_) return;
+    Entity entity = UnpackEntity(bodyId);
+    auto it = std::find(bodies_.begin(), bodies_.end(), entity);
+    if (it != bodies_.end()) {
+        *it = bodies_.back();
+        bodies_.pop_back();
+    }
+    DestroyBody(entity);
+}
+
+ConstraintID PhysicsEngine::CreateConstraint(ConstraintType type, RigidBodyID bodyA, RigidBodyID bodyB,
+                                             const PhysicsTransform& frameA, const PhysicsTransform& frameB) {
+    if (!world_) return 0;
+    
+    Joint joint;
+    joint.id = nextConstraintId_++;
+    joint.type = type;
+    joint.bodyA = UnpackEntity(bodyA);
+    joint.bodyB = UnpackEntity(bodyB);
+    joint.worldA = !FindBody(*world_, joint.bodyA);
+    joint.worldB = !FindBody(*world_, joint.bodyB);
+    joint.frameA = frameA;
+    joint.frameB = frameB;
+    
+    // Sliders start free along their axis, 6DOF joints start locked
+    float open = type == ConstraintType::Slider ? 1.0f : 0.0f;
+    joint.minLimits = XMFLOAT3(open, open, open);
+    joint.maxLimits = XMFLOAT3(-open, -open, -open);
+    
+    jointIndices_[joint.id] = joints_.size();
+    joints_.push_back(joint);
+    if (!joint.worldA && !joint.worldB) {
+        jointedPairs_[PairKey(joint.bodyA, joint.bodyB)]++;
+    }
+    
+    // Jointed bodies should settle together, not start with one asleep
+    if (!joint.worldA) WakeBody(joint.bodyA);
+    if (!joint.worldB) WakeBody(joint.bodyB);
+    return joint.id;
+}
+
+void PhysicsEngine::RemoveConstraint(ConstraintID constraintId) {
+    auto it = jointIndices_.find(constraintId);
+    if (it == jointIndices_.end()) return;
+    
+    size_t index = it->second;
+    jointIndices_.erase(it);
+    const Joint& joint = joints_[index];
+    if (!joint.worldA && !joint.worldB) {
+        auto pair = jointedPairs_.find(PairKey(joint.bodyA, joint.bodyB));
+        if (pair != jointedPairs_.end() && --pair->second == 0) {
+            jointedPairs_.erase(pair);
+        }
+    }
+    if (index + 1 != joints_.size()) {
+        joints_[index] = joints_.back();
+        jointIndices_[joints_[index].id] = index;
+    }
+    joints_.pop_back();
+}
+
+void PhysicsEngine::SetConstraintLimits(ConstraintID constraintId, const PhysicsVector3& minLimits,
+                                        const PhysicsVector3& maxLimits) {
+    auto it = jointIndices_.find(constraintId);
+    if (it == jointIndices_.end()) return;
+    
+    Joint& joint = joints_[it->second];
+    joint.minLimits = minLimits;
+    joint.maxLimits = maxLimits;
+    if (!joint.worldA) WakeBody(joint.bodyA);
+    if (!joint.worldB) WakeBody(joint.bodyB);
+}
+
+RagdollID PhysicsEngine::CreateRagdoll(const RagdollDefinition& definition, const PhysicsTransform& rootTransform) {
+    if (!world_) return 0;
+    
+    Ragdoll ragdoll;
+    std::unordered_map<std::string, RigidBodyID> bones;
+    XMVECTOR rootRotation = XMLoadFloat4(&rootTransform.rotation);
+    for (const RagdollDefinition::Bone& bone : definition.bones) {
+        PhysicsTransform transform = bone.transform;
+        XMStoreFloat3(&transform.position, XMVectorAdd(XMLoadFloat3(&rootTransform.position),
+                                                       XMVector3Rotate(XMLoadFloat3(&bone.transform.position), rootRotation)));
+        XMStoreFloat4(&transform.rotation, XMQuaternionMultiply(XMLoadFloat4(&bone.transform.rotation), rootRotation));
         
-        // Simple ground collision
-        if (obj.position.y < 0.0f) {
-            obj.position.y = 0.0f;
-            obj.velocity.y = std::abs(obj.velocity.y) * 0.8f; // Bounce with damping
+        RigidBodyID id = CreateRigidBody(bone.shape, transform, bone.mass, bone.material);
+        bones[bone.name] = id;
+        ragdoll.bones.push_back(UnpackEntity(id));
+    }
+    
+    for (const RagdollDefinition::Joint& joint : definition.joints) {
+        auto first = bones.find(joint.bone1);
+        auto second = bones.find(joint.bone2);
+        if (first == bones.end() || second == bones.end()) {
+            Logger::Warning("Ragdoll joint between unknown bones " + joint.bone1 + " and " + joint.bone2);
+            continue;
         }
+        
+        // Anchors are in bone space; bodies do not rotate, so the root rotation is applied once
+        PhysicsTransform frameA, frameB;
+        XMStoreFloat3(&frameA.position, XMVector3Rotate(XMLoadFloat3(&joint.anchor1), rootRotation));
+        XMStoreFloat3(&frameB.position, XMVector3Rotate(XMLoadFloat3(&joint.anchor2), rootRotation));
+        ragdoll.joints.push_back(CreateConstraint(ConstraintType::ConeTwist, first->second, second->second, frameA, frameB));
+    }
+    
+    RagdollID id = nextRagdollId_++;
+    ragdolls_[id] = std::move(ragdoll);
+    return id;
+}
+
+void PhysicsEngine::DestroyRagdoll(RagdollID ragdollId) {
+    auto it = ragdolls_.find(ragdollId);
+    if (it == ragdolls_.end()) return;
+    
+    for (ConstraintID joint : it->second.joints) {
+        RemoveConstraint(joint);
+    }
+    for (Entity bone : it->second.bones) {
+        RemoveRigidBody(static_cast<RigidBodyID>(PackEntity(bone)));
+    }
+    ragdolls_.erase(it);
+}
+
+void PhysicsEngine::SetRagdollActive(RagdollID ragdollId, bool active) {
+    auto it = ragdolls_.find(ragdollId);
+    if (it == ragdolls_.end()) return;
+    
+    for (Entity bone : it->second.bones) {
+        SetBodyActive(static_cast<RigidBodyID>(PackEntity(bone)), active);
     }
+}
+
+std::vector<PhysicsTransform> PhysicsEngine::GetRagdollBoneTransforms(RagdollID ragdollId) const {
+    std::vector<PhysicsTransform> transforms;
+    auto it = ragdolls_.find(ragdollId);
+    if (it == ragdolls_.end() || !world_) return transforms;
     
-    // Update render objects
-    for (size_t i = 0; i < physicsObjects_.size() && i < renderObjects_.size(); ++i) {
-        renderObjects_[i].position = physicsObjects_[i].position;
+    transforms.reserve(it->second.bones.size());
+    for (Entity bone : it->second.bones) {
+        const TransformComponent* transform = world_->GetComponent<TransformComponent>(bone);
+        transforms.push_back(transform ? PhysicsTransform(transform->position, transform->rotation, transform->scale)
+                                       : PhysicsTransform());
     }
+    return transforms;
 }
 
 void PhysicsEngine::CreatePhysicsDemo() {
     Logger::Info("Creating physics demo scene...");
     
     // Clear existing objects
-    physicsObjects_.clear();
-    renderObjects_.clear();
+    DestroyBodies();
     
     // Create ground boxes
     for (int i = 0; i < 5; ++i) {
         for (int j = 0; j < 5; ++j) {
-            SimplePhysicsObject physObj;
-            physObj.position = XMFLOAT3(i * 2.0f - 4.0f, 0.5f, j * 2.0f - 4.0f);
-            physObj.velocity = XMFLOAT3(0.0f, 0.0f, 0.0f);
-            physObj.mass = 1.0f;
-            physicsObjects_.push_back(physObj);
-            
-            RenderObject renderObj;
-            renderObj.position = physObj.position;
-            renderObj.scale = XMFLOAT3(1.0f, 1.0f, 1.0f);
-            renderObj.color = XMFLOAT4(0.8f, 0.4f, 0.2f, 1.0f);
-            renderObj.shapeType = CollisionShape::Type::Box;
-            renderObjects_.push_back(renderObj);
+            CreateDemoBody(XMFLOAT3(i * 2.0f - 4.0f, 0.5f, j * 2.0f - 4.0f), XMFLOAT3(1.0f, 1.0f, 1.0f),
+                           XMFLOAT4(0.8f, 0.4f, 0.2f, 1.0f), CollisionShape::Type::Box, 1.0f);
         }
     }
     
     // Create stacked boxes
     for (int i = 0; i < 3; ++i) {
-        SimplePhysicsObject physObj;
-        physObj.position = XMFLOAT3(0.0f, 2.0f + i * 2.0f, 0.0f);
-        physObj.velocity = XMFLOAT3(0.0f, 0.0f, 0.0f);
-        physObj.mass = 1.0f;
-        physicsObjects_.push_back(physObj);
-        
-        RenderObject renderObj;
-        renderObj.position = physObj.position;
-        renderObj.scale = XMFLOAT3(1.0f, 1.0f, 1.0f);
-        renderObj.color = XMFLOAT4(0.2f, 0.8f, 0.4f, 1.0f);
-        renderObj.shapeType = CollisionShape::Type::Box;
-        renderObjects_.push_back(renderObj);
+        CreateDemoBody(XMFLOAT3(0.0f, 2.0f + i * 2.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f),
+                       XMFLOAT4(0.2f, 0.8f, 0.4f, 1.0f), CollisionShape::Type::Box, 1.0f);
     }
     
     // Create spheres
     for (int i = 0; i < 3; ++i) {
-        SimplePhysicsObject physObj;
-        physObj.position = XMFLOAT3(3.0f + i * 1.5f, 5.0f, 0.0f);
-        physObj.velocity = XMFLOAT3(0.0f, 0.0f, 0.0f);
-        physObj.mass = 0.5f;
-        physicsObjects_.push_back(physObj);
-        
-        RenderObject renderObj;
-        renderObj.position = physObj.position;
-        renderObj.scale = XMFLOAT3(0.5f, 0.5f, 0.5f);
-        renderObj.color = XMFLOAT4(0.4f, 0.2f, 0.8f, 1.0f);
-        renderObj.shapeType = CollisionShape::Type::Sphere;
-        renderObjects_.push_back(renderObj);
+        CreateDemoBody(XMFLOAT3(3.0f + i * 1.5f, 5.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f),
+                       XMFLOAT4(0.4f, 0.2f, 0.8f, 1.0f), CollisionShape::Type::Sphere, 0.5f);
     }
     
-    Logger::Info("Created " + std::to_string(physicsObjects_.size()) + " physics objects");
+    Logger::Info("Created " + std::to_string(bodies_.size()) + " physics objects");
+    PublishRenderSnapshot();
 }
 
 void PhysicsEngine::ApplyExplosion(const XMFLOAT3& center, float force, float radius) {
-    Logger::Info("Applying explosion at (" + std::to_string(center.x) + ", " + 
-                 std::to_string(center.y) + ", " + std::to_string(center.z) + ")");
+    NEXUS_LOG_DEBUG("Applying explosion at ({}, {}, {})", center.x, center.y, center.z);
+    
+    // Sleepers in range wake first; the broadphase finds them without visiting the rest
+    if (broadPhase_) {
+        wakeList_.clear();
+        AABB reach = AABB::FromCenterExtents(center, XMFLOAT3(radius, radius, radius));
+        broadPhase_->Query(reach, [this](BroadPhase::ProxyID proxy) {
+            Entity entity = UnpackEntity(broadPhase_->GetUserData(proxy));
+            bool sleeping;
+            const PhysicsBodyComponent* body = FindBody(*world_, entity, &sleeping);
+            if (body && sleeping && body->mass > 0.0f) wakeList_.push_back(entity);
+            return true;
+        });
+        for (Entity entity : wakeList_) {
+            WakeBody(entity);
+        }
+    }
     
-    for (auto& obj : physicsObjects_) {
+    world_->ForEach<TransformComponent, PhysicsBodyComponent>(
+        [&](Entity, TransformComponent& transform, PhysicsBodyComponent& obj) {
         // Calculate distance from explosion center
-        float dx = obj.position.x - center.x;
-        float dy = obj.position.y - center.y;
-        float dz = obj.position.z - center.z;
+        float dx = transform.position.x - center.x;
+        float dy = transform.position.y - center.y;
+        float dz = transform.position.z - center.z;
         float distance = std::sqrt(dx*dx + dy*dy + dz*dz);
         
         if (distance < radius && distance > 0.1f) {
@@ -149,11 +2601,85 @@ void PhysicsEngine::ApplyExplosion(const XMFLOAT3& center, float force, float ra
             obj.velocity.y += dy * explosionForce;
             obj.velocity.z += dz * explosionForce;
         }
-    }
+    });
+}
+
+template<typename Container>
+void PhysicsEngine::ExtractRenderObjects(float alpha, Container& out) const {
+    out.clear();
+    if (!world_) return;
+    
+    alpha = std::clamp(alpha, 0.0f, 1.0f);
+    out.reserve(world_->Count<TransformComponent, RenderableComponent>());
+    
+    world_->ForEachChunk<TransformComponent, RenderableComponent>(
+        [&out, alpha](size_t count, const Entity*, TransformComponent* transforms, RenderableComponent* renderables) {
+        for (size_t i = 0; i < count; ++i) {
+            const TransformComponent& transform = transforms[i];
+            
+            RenderObject obj;
+            obj.previousPosition = transform.previousPosition;
+            obj.position.x = transform.previousPosition.x + (transform.position.x - transform.previousPosition.x) * alpha;
+            obj.position.y = transform.previousPosition.y + (transform.position.y - transform.previousPosition.y) * alpha;
+            obj.position.z = transform.previousPosition.z + (transform.position.z - transform.previousPosition.z) * alpha;
+            obj.scale = transform.scale;
+            obj.color = renderables[i].color;
+            obj.shapeType = static_cast<CollisionShape::Type>(renderables[i].shapeType);
+            out.push_back(obj);
+        }
+    });
 }
 
 std::vector<RenderObject> PhysicsEngine::GetRenderObjects() const {
-    return renderObjects_;
+    std::vector<RenderObject> objects;
+    ExtractRenderObjects(1.0f, objects);
+    return objects;
+}
+
+std::vector<RenderObject> PhysicsEngine::GetInterpolatedRenderObjects(float alpha) const {
+    std::vector<RenderObject> interpolated;
+    ExtractRenderObjects(alpha, interpolated);
+    return interpolated;
+}
+
+void PhysicsEngine::GetInterpolatedRenderObjects(float alpha, FrameVector<RenderObject>& out) const {
+    ExtractRenderObjects(alpha, out);
+}
+
+void PhysicsEngine::PublishRenderSnapshot() {
+    int back = 1 - frontSnapshot_.load();
+    
+    // The renderer still holds the buffer we would write: skip, it keeps the state it has
+    // and the next publish catches up
+    if (readingSnapshot_.load() == back) return;
+    
+    // Steady state reuses the buffer's capacity, so publishing does not allocate
+    ExtractRenderObjects(1.0f, snapshots_[back]);
+    frontSnapshot_.store(back);
+}
+
+RenderObjectView PhysicsEngine::AcquireRenderSnapshot() const {
+    // Pin the front buffer, retrying if a publish flipped it before the pin was visible
+    int front = frontSnapshot_.load();
+    for (;;) {
+        readingSnapshot_.store(front);
+        int current = frontSnapshot_.load();
+        if (current == front) break;
+        front = current;
+    }
+    
+    RenderObjectView view;
+    view.data = snapshots_[front].data();
+    view.count = snapshots_[front].size();
+    return view;
+}
+
+void PhysicsEngine::ReleaseRenderSnapshot() const {
+    readingSnapshot_.store(-1);
+}
+
+size_t PhysicsEngine::GetRenderObjectCount() const {
+    return world_ ? world_->Count<TransformComponent, RenderableComponent>() : 0;
 }
 
 void PhysicsEngine::Update(float deltaTime) {
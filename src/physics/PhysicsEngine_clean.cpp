@@ -1,6 +1,13 @@
 #include "PhysicsEngine.h"
 #include "Logger.h"
+#include "BulletTaskScheduler.h"
+#include "JobSystem.h"
 #include <btBulletDynamicsCommon.h>
+#ifdef NEXUS_BULLET_MT_ENABLED
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#endif
 #include <algorithm>
 
 namespace Nexus {
@@ -11,6 +18,9 @@ PhysicsEngine::PhysicsEngine()
     , dispatcher_(nullptr)
     , broadphase_(nullptr)
     , solver_(nullptr)
+    , solverPool_(nullptr)
+    , jobs_(nullptr)
+    , taskScheduler_(nullptr)
     , nextRigidBodyId_(1)
     , nextConstraintId_(1)
     , nextRagdollId_(1)
@@ -33,11 +43,27 @@ PhysicsEngine::~PhysicsEngine() {
 bool PhysicsEngine::Initialize() {
     // Initialize Bullet Physics
     collisionConfig_ = new btDefaultCollisionConfiguration();
-    dispatcher_ = new btCollisionDispatcher(collisionConfig_);
     broadphase_ = new btDbvtBroadphase();
-    solver_ = new btSequentialImpulseConstraintSolver();
     
-    dynamicsWorld_ = new btDiscreteDynamicsWorld(dispatcher_, broadphase_, solver_, collisionConfig_);
+#ifdef NEXUS_BULLET_MT_ENABLED
+    if (jobs_ && jobs_->IsInitialized() && jobs_->GetWorkerCount() > 0) {
+        // Bullet's parallel loops run as engine jobs; it never starts threads of its own
+        taskScheduler_ = new BulletTaskScheduler(*jobs_);
+        btSetTaskScheduler(taskScheduler_);
+        
+        dispatcher_ = new btCollisionDispatcherMt(collisionConfig_);
+        solverPool_ = new btConstraintSolverPoolMt(taskScheduler_->getMaxNumThreads());
+        solver_ = new btSequentialImpulseConstraintSolverMt();
+        dynamicsWorld_ = new btDiscreteDynamicsWorldMt(dispatcher_, broadphase_, solverPool_, solver_, collisionConfig_);
+        Logger::Info("PhysicsEngine using the multithreaded world on " +
+                     std::to_string(taskScheduler_->getMaxNumThreads()) + " threads");
+    }
+#endif
+    if (!dynamicsWorld_) {
+        dispatcher_ = new btCollisionDispatcher(collisionConfig_);
+        solver_ = new btSequentialImpulseConstraintSolver();
+        dynamicsWorld_ = new btDiscreteDynamicsWorld(dispatcher_, broadphase_, solver_, collisionConfig_);
+    }
     
     // Set default gravity
     dynamicsWorld_->setGravity(btVector3(gravity_.x, gravity_.y, gravity_.z));
@@ -95,6 +121,11 @@ void PhysicsEngine::Shutdown() {
         dynamicsWorld_ = nullptr;
     }
     
+    if (solverPool_) {
+        delete solverPool_;
+        solverPool_ = nullptr;
+    }
+    
     if (solver_) {
         delete solver_;
         solver_ = nullptr;
@@ -115,6 +146,14 @@ void PhysicsEngine::Shutdown() {
         collisionConfig_ = nullptr;
     }
     
+#ifdef NEXUS_BULLET_MT_ENABLED
+    if (taskScheduler_) {
+        btSetTaskScheduler(nullptr);
+        delete taskScheduler_;
+        taskScheduler_ = nullptr;
+    }
+#endif
+    
     isInitialized_ = false;
     Logger::Info("PhysicsEngine shutdown complete");
 }
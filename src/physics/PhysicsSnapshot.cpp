@@ -0,0 +1,122 @@
+#include "PhysicsSnapshot.h"
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+
+// Zero runs shorter than this stay inside a literal; a length costs about as much as the bytes
+constexpr size_t MIN_ZERO_RUN = 8;
+
+void WriteVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool ReadVarint(const uint8_t*& cursor, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        if (cursor == end) return false;
+        uint8_t byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+void PhysicsSnapshot::Reset(size_t bodyCount, size_t contactCount) {
+    data_.resize(sizeof(Header) + bodyCount * sizeof(Body) + contactCount * sizeof(Contact));
+    Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.bodyCount = static_cast<uint32_t>(bodyCount);
+    header.contactCount = static_cast<uint32_t>(contactCount);
+    std::memcpy(data_.data(), &header, sizeof(header));
+}
+
+bool PhysicsSnapshot::IsValid() const {
+    if (data_.size() < sizeof(Header)) return false;
+    const Header& header = GetHeader();
+    return header.magic == MAGIC && header.version == VERSION &&
+           data_.size() == sizeof(Header) + header.bodyCount * sizeof(Body) + header.contactCount * sizeof(Contact);
+}
+
+void PhysicsSnapshot::Diff(const PhysicsSnapshot& base, const PhysicsSnapshot& target, std::vector<uint8_t>& delta) {
+    const uint8_t* from = base.data_.data();
+    const uint8_t* to = target.data_.data();
+    size_t baseSize = base.data_.size();
+    size_t size = target.data_.size();
+    auto changed = [&](size_t i) { return to[i] != (i < baseSize ? from[i] : 0); };
+
+    // Target size, then (zero run, literal length, literal bytes) until the target is covered
+    delta.clear();
+    WriteVarint(delta, size);
+    size_t i = 0;
+    while (i < size) {
+        size_t zeroStart = i;
+        while (i < size && !changed(i)) ++i;
+
+        size_t literalStart = i;
+        size_t literalEnd = size;
+        size_t zeros = 0;
+        for (; i < size; ++i) {
+            zeros = changed(i) ? 0 : zeros + 1;
+            if (zeros == MIN_ZERO_RUN) {
+                literalEnd = i + 1 - MIN_ZERO_RUN;
+                break;
+            }
+        }
+        i = literalEnd;
+
+        WriteVarint(delta, literalStart - zeroStart);
+        WriteVarint(delta, literalEnd - literalStart);
+        for (size_t j = literalStart; j < literalEnd; ++j) {
+            delta.push_back(static_cast<uint8_t>(to[j] ^ (j < baseSize ? from[j] : 0)));
+        }
+    }
+}
+
+bool PhysicsSnapshot::Patch(const PhysicsSnapshot& base, const uint8_t* delta, size_t size, PhysicsSnapshot& target) {
+    if (&base == &target) return false;
+
+    const uint8_t* cursor = delta;
+    const uint8_t* end = delta + size;
+    uint64_t targetSize;
+    if (!ReadVarint(cursor, end, targetSize)) return false;
+
+    const uint8_t* from = base.data_.data();
+    size_t baseSize = base.data_.size();
+    auto baseByte = [&](size_t i) { return i < baseSize ? from[i] : uint8_t(0); };
+
+    target.data_.resize(static_cast<size_t>(targetSize));
+    uint8_t* to = target.data_.data();
+    size_t i = 0;
+    while (i < targetSize) {
+        uint64_t zeros, literal;
+        if (!ReadVarint(cursor, end, zeros) || !ReadVarint(cursor, end, literal) || zeros + literal == 0 ||
+            zeros > targetSize - i || literal > targetSize - i - zeros ||
+            literal > static_cast<uint64_t>(end - cursor)) {
+            target.data_.clear();
+            return false;
+        }
+        for (size_t j = 0; j < zeros; ++j, ++i) {
+            to[i] = baseByte(i);
+        }
+        for (size_t j = 0; j < literal; ++j, ++i) {
+            to[i] = static_cast<uint8_t>(*cursor++ ^ baseByte(i));
+        }
+    }
+
+    if (cursor != end || !target.IsValid()) {
+        target.data_.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace Nexus
@@ -0,0 +1,500 @@
+#include "StaticGeometry.h"
+#include "AtomicFile.h"
+#include "Logger.h"
+#include "MeshImporter.h"
+#include "Profiler.h"
+#include <cfloat>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// SSE2 is part of the x64 baseline, so the packet traversal needs no runtime dispatch
+#include <emmintrin.h>
+
+namespace Nexus {
+
+using namespace DirectX;
+
+namespace {
+
+float Component(const XMFLOAT3& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+float Dot(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Either side counts; the normal is turned to face the ray
+bool RayCastTriangle(const XMFLOAT3* triangle, const XMFLOAT3& from, const XMFLOAT3& delta, float maxFraction,
+                     float& fraction, XMFLOAT3& normal, bool* backFace = nullptr) {
+    XMFLOAT3 edge1 = Subtract(triangle[1], triangle[0]);
+    XMFLOAT3 edge2 = Subtract(triangle[2], triangle[0]);
+    XMFLOAT3 p = Cross(delta, edge2);
+    float determinant = Dot(edge1, p);
+    if (std::abs(determinant) < 1e-12f) return false;
+
+    float inverse = 1.0f / determinant;
+    XMFLOAT3 offset = Subtract(from, triangle[0]);
+    float u = Dot(offset, p) * inverse;
+    if (u < 0.0f || u > 1.0f) return false;
+    XMFLOAT3 q = Cross(offset, edge1);
+    float v = Dot(delta, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f) return false;
+    float t = Dot(edge2, q) * inverse;
+    if (t < 0.0f || t > maxFraction) return false;
+
+    XMFLOAT3 n = Cross(edge1, edge2);
+    float length = std::sqrt(Dot(n, n));
+    float sign = Dot(n, delta) > 0.0f ? -1.0f : 1.0f;
+    if (backFace) *backFace = sign < 0.0f;
+    fraction = t;
+    normal = XMFLOAT3(n.x * sign / length, n.y * sign / length, n.z * sign / length);
+    return true;
+}
+
+// Entry and exit fractions of the segment through box, clipped to [0, maxFraction]
+bool ClipSegment(const AABB& box, const XMFLOAT3& from, const XMFLOAT3& delta, float maxFraction, float& enter,
+                 float& exit) {
+    enter = 0.0f;
+    exit = maxFraction;
+    for (int axis = 0; axis < 3; ++axis) {
+        float origin = Component(from, axis);
+        float direction = Component(delta, axis);
+        float low = Component(box.min, axis);
+        float high = Component(box.max, axis);
+        if (std::abs(direction) < 1e-12f) {
+            if (origin < low || origin > high) return false;
+            continue;
+        }
+        float t1 = (low - origin) / direction;
+        float t2 = (high - origin) / direction;
+        enter = std::max(enter, std::min(t1, t2));
+        exit = std::min(exit, std::max(t1, t2));
+        if (enter > exit) return false;
+    }
+    return true;
+}
+
+AABB TriangleBounds(const XMFLOAT3* triangle) {
+    AABB box;
+    box.min = XMFLOAT3(std::min(std::min(triangle[0].x, triangle[1].x), triangle[2].x),
+                       std::min(std::min(triangle[0].y, triangle[1].y), triangle[2].y),
+                       std::min(std::min(triangle[0].z, triangle[1].z), triangle[2].z));
+    box.max = XMFLOAT3(std::max(std::max(triangle[0].x, triangle[1].x), triangle[2].x),
+                       std::max(std::max(triangle[0].y, triangle[1].y), triangle[2].y),
+                       std::max(std::max(triangle[0].z, triangle[1].z), triangle[2].z));
+    return box;
+}
+
+AABB Union(const AABB& a, const AABB& b) {
+    return {{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)},
+            {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)}};
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------------
+// HeightfieldCollider
+// ---------------------------------------------------------------------------------------------
+
+HeightfieldCollider::HeightfieldCollider()
+    : samplesX_(0)
+    , samplesZ_(0)
+    , cellSize_(1.0f)
+    , bounds_{{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}}
+{
+}
+
+bool HeightfieldCollider::Build(const float* heights, uint32_t samplesX, uint32_t samplesZ, float cellSize) {
+    if (!heights || samplesX < 2 || samplesZ < 2 || !(cellSize > 0.0f)) {
+        Logger::Error("HeightfieldCollider needs at least 2 x 2 samples and a positive cell size");
+        return false;
+    }
+
+    heights_.assign(heights, heights + static_cast<size_t>(samplesX) * samplesZ);
+    samplesX_ = samplesX;
+    samplesZ_ = samplesZ;
+    cellSize_ = cellSize;
+    auto range = std::minmax_element(heights_.begin(), heights_.end());
+    bounds_.min = XMFLOAT3(0.0f, *range.first, 0.0f);
+    bounds_.max = XMFLOAT3((samplesX - 1) * cellSize, *range.second, (samplesZ - 1) * cellSize);
+    return true;
+}
+
+void HeightfieldCollider::GetCell(uint32_t x, uint32_t z, XMFLOAT3* triangles) const {
+    float x0 = x * cellSize_, x1 = (x + 1) * cellSize_;
+    float z0 = z * cellSize_, z1 = (z + 1) * cellSize_;
+    XMFLOAT3 p00(x0, Height(x, z), z0);
+    XMFLOAT3 p10(x1, Height(x + 1, z), z0);
+    XMFLOAT3 p01(x0, Height(x, z + 1), z1);
+    XMFLOAT3 p11(x1, Height(x + 1, z + 1), z1);
+
+    // Both wound so a flat cell faces +y
+    triangles[0] = p00;
+    triangles[1] = p01;
+    triangles[2] = p11;
+    triangles[3] = p00;
+    triangles[4] = p11;
+    triangles[5] = p10;
+}
+
+bool HeightfieldCollider::RayCast(const XMFLOAT3& from, const XMFLOAT3& delta, float maxFraction, float& fraction,
+                                  XMFLOAT3& normal) const {
+    float enter, exit;
+    if (heights_.empty() || !ClipSegment(bounds_, from, delta, maxFraction, enter, exit)) return false;
+
+    // Walk the cells the segment crosses in order (Amanatides and Woo), so the first cell with a
+    // hit holds the closest one
+    const int cellsX = static_cast<int>(samplesX_) - 1;
+    const int cellsZ = static_cast<int>(samplesZ_) - 1;
+    float startX = (from.x + delta.x * enter) / cellSize_;
+    float startZ = (from.z + delta.z * enter) / cellSize_;
+    int x = std::clamp(static_cast<int>(std::floor(startX)), 0, cellsX - 1);
+    int z = std::clamp(static_cast<int>(std::floor(startZ)), 0, cellsZ - 1);
+
+    float directionX = delta.x / cellSize_;
+    float directionZ = delta.z / cellSize_;
+    int stepX = directionX > 0.0f ? 1 : -1;
+    int stepZ = directionZ > 0.0f ? 1 : -1;
+    float originX = from.x / cellSize_;
+    float originZ = from.z / cellSize_;
+    bool movesX = std::abs(directionX) > 1e-12f;
+    bool movesZ = std::abs(directionZ) > 1e-12f;
+    float nextX = movesX ? (static_cast<float>(stepX > 0 ? x + 1 : x) - originX) / directionX : FLT_MAX;
+    float nextZ = movesZ ? (static_cast<float>(stepZ > 0 ? z + 1 : z) - originZ) / directionZ : FLT_MAX;
+    float stepFractionX = movesX ? 1.0f / std::abs(directionX) : FLT_MAX;
+    float stepFractionZ = movesZ ? 1.0f / std::abs(directionZ) : FLT_MAX;
+
+    XMFLOAT3 triangles[6];
+    for (float t = enter; t <= exit;) {
+        GetCell(static_cast<uint32_t>(x), static_cast<uint32_t>(z), triangles);
+        bool hit = false;
+        float closest = exit;
+        float candidate;
+        XMFLOAT3 candidateNormal;
+        for (int i = 0; i < 2; ++i) {
+            if (RayCastTriangle(triangles + i * 3, from, delta, closest, candidate, candidateNormal)) {
+                closest = candidate;
+                normal = candidateNormal;
+                hit = true;
+            }
+        }
+        if (hit) {
+            fraction = closest;
+            return true;
+        }
+
+        if (nextX < nextZ) {
+            x += stepX;
+            t = nextX;
+            nextX += stepFractionX;
+        } else {
+            z += stepZ;
+            t = nextZ;
+            nextZ += stepFractionZ;
+        }
+        if (x < 0 || x >= cellsX || z < 0 || z >= cellsZ) break;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------
+// TriangleMeshCollider
+// ---------------------------------------------------------------------------------------------
+
+TriangleMeshCollider::TriangleMeshCollider()
+    : bounds_{{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}}
+    , quantization_(0.0f, 0.0f, 0.0f)
+{
+}
+
+bool TriangleMeshCollider::Build(const XMFLOAT3* positions, size_t vertexCount, const uint32_t* indices,
+                                 size_t indexCount) {
+    NEXUS_PROFILE_SCOPE("TriangleMeshCollider::Build");
+    nodes_.clear();
+    vertices_.clear();
+
+    // Gather the usable triangles first; the tree is built over their bounds
+    std::vector<XMFLOAT3> source;
+    source.reserve(indexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount) continue;
+        const XMFLOAT3& a = positions[indices[i]];
+        const XMFLOAT3& b = positions[indices[i + 1]];
+        const XMFLOAT3& c = positions[indices[i + 2]];
+        XMFLOAT3 n = Cross(Subtract(b, a), Subtract(c, a));
+        if (Dot(n, n) < 1e-20f) continue;
+        source.push_back(a);
+        source.push_back(b);
+        source.push_back(c);
+    }
+    uint32_t triangleCount = static_cast<uint32_t>(source.size() / 3);
+    if (triangleCount == 0 || triangleCount >= LEAF) {
+        Logger::Error("TriangleMeshCollider: no usable triangles");
+        return false;
+    }
+
+    std::vector<AABB> boxes(triangleCount);
+    std::vector<XMFLOAT3> centers(triangleCount);
+    std::vector<uint32_t> triangles(triangleCount);
+    bounds_ = TriangleBounds(&source[0]);
+    for (uint32_t i = 0; i < triangleCount; ++i) {
+        boxes[i] = TriangleBounds(&source[i * 3]);
+        centers[i] = XMFLOAT3((boxes[i].min.x + boxes[i].max.x) * 0.5f, (boxes[i].min.y + boxes[i].max.y) * 0.5f,
+                              (boxes[i].min.z + boxes[i].max.z) * 0.5f);
+        triangles[i] = i;
+        bounds_ = Union(bounds_, boxes[i]);
+    }
+
+    // Flat meshes have no extent along an axis; any scale works there
+    XMFLOAT3 extent = Subtract(bounds_.max, bounds_.min);
+    quantization_ = XMFLOAT3(65535.0f / std::max(extent.x, 1e-6f), 65535.0f / std::max(extent.y, 1e-6f),
+                             65535.0f / std::max(extent.z, 1e-6f));
+
+    nodes_.reserve(triangleCount * 2 - 1);
+    vertices_.reserve(source.size());
+    BuildNode(triangles, 0, triangleCount, source, boxes, centers);
+    return true;
+}
+
+bool TriangleMeshCollider::Build(const MeshData& mesh) {
+    std::vector<XMFLOAT3> positions(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        positions[i] = mesh.vertices[i].position;
+    }
+    size_t first = mesh.lods.empty() ? 0 : mesh.lods[0].indexOffset;
+    size_t count = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+    return Build(positions.data(), positions.size(), mesh.indices.data() + first, count);
+}
+
+uint32_t TriangleMeshCollider::BuildNode(std::vector<uint32_t>& triangles, uint32_t first, uint32_t count,
+                                         const std::vector<XMFLOAT3>& source, const std::vector<AABB>& boxes,
+                                         const std::vector<XMFLOAT3>& centers) {
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back(Node());
+
+    AABB box = boxes[triangles[first]];
+    for (uint32_t i = 1; i < count; ++i) {
+        box = Union(box, boxes[triangles[first + i]]);
+    }
+
+    uint32_t size = 1;
+    if (count == 1) {
+        uint32_t triangle = static_cast<uint32_t>(vertices_.size() / 3);
+        const XMFLOAT3* vertices = &source[triangles[first] * 3];
+        vertices_.insert(vertices_.end(), vertices, vertices + 3);
+        nodes_[index].data = LEAF | triangle;
+    } else {
+        // Median split on the longest axis of the triangle centers keeps the tree balanced
+        XMFLOAT3 low = centers[triangles[first]];
+        XMFLOAT3 high = low;
+        for (uint32_t i = 1; i < count; ++i) {
+            const XMFLOAT3& center = centers[triangles[first + i]];
+            low = XMFLOAT3(std::min(low.x, center.x), std::min(low.y, center.y), std::min(low.z, center.z));
+            high = XMFLOAT3(std::max(high.x, center.x), std::max(high.y, center.y), std::max(high.z, center.z));
+        }
+        XMFLOAT3 spread = Subtract(high, low);
+        int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+
+        uint32_t half = count / 2;
+        std::nth_element(triangles.begin() + first, triangles.begin() + first + half, triangles.begin() + first + count,
+                         [&](uint32_t a, uint32_t b) { return Component(centers[a], axis) < Component(centers[b], axis); });
+        size += BuildNode(triangles, first, half, source, boxes, centers);
+        size += BuildNode(triangles, first + half, count - half, source, boxes, centers);
+        nodes_[index].data = size;
+    }
+    Quantize(box, nodes_[index].min, nodes_[index].max);
+    return size;
+}
+
+void TriangleMeshCollider::Quantize(const AABB& box, uint16_t* min, uint16_t* max) const {
+    // Rounded outwards, so a quantized box always covers the real one
+    for (int axis = 0; axis < 3; ++axis) {
+        float origin = Component(bounds_.min, axis);
+        float scale = Component(quantization_, axis);
+        float low = std::clamp((Component(box.min, axis) - origin) * scale, 0.0f, 65535.0f);
+        float high = std::clamp((Component(box.max, axis) - origin) * scale, 0.0f, 65535.0f);
+        min[axis] = static_cast<uint16_t>(std::floor(low));
+        max[axis] = static_cast<uint16_t>(std::ceil(high));
+    }
+}
+
+AABB TriangleMeshCollider::Dequantize(const Node& node) const {
+    return {{bounds_.min.x + node.min[0] / quantization_.x, bounds_.min.y + node.min[1] / quantization_.y,
+             bounds_.min.z + node.min[2] / quantization_.z},
+            {bounds_.min.x + node.max[0] / quantization_.x, bounds_.min.y + node.max[1] / quantization_.y,
+             bounds_.min.z + node.max[2] / quantization_.z}};
+}
+
+bool TriangleMeshCollider::RayCast(const XMFLOAT3& from, const XMFLOAT3& delta, float maxFraction, float& fraction,
+                                   XMFLOAT3& normal, bool* backFace) const {
+    float enter, exit;
+    if (nodes_.empty() || !ClipSegment(bounds_, from, delta, maxFraction, enter, exit)) return false;
+
+    // Each hit shortens the segment, so later subtrees have to beat it
+    bool hit = false;
+    const uint32_t count = static_cast<uint32_t>(nodes_.size());
+    for (uint32_t index = 0; index < count;) {
+        const Node& node = nodes_[index];
+        bool overlaps = ClipSegment(Dequantize(node), from, delta, maxFraction, enter, exit);
+        bool leaf = (node.data & LEAF) != 0;
+        if (leaf && overlaps) {
+            float candidate;
+            XMFLOAT3 candidateNormal;
+            bool candidateBack;
+            if (RayCastTriangle(&vertices_[(node.data & ~LEAF) * 3], from, delta, maxFraction, candidate, candidateNormal,
+                                &candidateBack)) {
+                maxFraction = candidate;
+                fraction = candidate;
+                normal = candidateNormal;
+                if (backFace) *backFace = candidateBack;
+                hit = true;
+            }
+        }
+        index += (overlaps || leaf) ? 1 : node.data;
+    }
+    return hit;
+}
+
+void TriangleMeshCollider::RayCastPacket(const XMFLOAT3* from, const XMFLOAT3* delta, const float* maxFraction,
+                                         uint32_t count, RayHit* hits) const {
+    if (count > PACKET_SIZE) count = PACKET_SIZE;
+    for (uint32_t lane = 0; lane < count; ++lane) hits[lane] = RayHit();
+    if (nodes_.empty() || count == 0) return;
+
+    // Same lane setup as BroadPhase::RayCastPacket: huge reciprocals for axis-parallel rays,
+    // negative maxFraction for unused lanes
+    alignas(16) float originX[PACKET_SIZE], originY[PACKET_SIZE], originZ[PACKET_SIZE];
+    alignas(16) float inverseX[PACKET_SIZE], inverseY[PACKET_SIZE], inverseZ[PACKET_SIZE];
+    alignas(16) float maxFractions[PACKET_SIZE];
+    auto reciprocal = [](float d) { return d > 1e-12f ? 1.0f / d : (d < -1e-12f ? 1.0f / d : 1e30f); };
+    for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+        uint32_t source = lane < count ? lane : 0;
+        originX[lane] = from[source].x;
+        originY[lane] = from[source].y;
+        originZ[lane] = from[source].z;
+        inverseX[lane] = reciprocal(delta[source].x);
+        inverseY[lane] = reciprocal(delta[source].y);
+        inverseZ[lane] = reciprocal(delta[source].z);
+        maxFractions[lane] = lane < count ? maxFraction[lane] : -1.0f;
+    }
+    const __m128 ox = _mm_load_ps(originX), oy = _mm_load_ps(originY), oz = _mm_load_ps(originZ);
+    const __m128 ix = _mm_load_ps(inverseX), iy = _mm_load_ps(inverseY), iz = _mm_load_ps(inverseZ);
+    __m128 tMax = _mm_load_ps(maxFractions);
+
+    const uint32_t nodeCount = static_cast<uint32_t>(nodes_.size());
+    for (uint32_t index = 0; index < nodeCount;) {
+        const Node& node = nodes_[index];
+        const AABB box = Dequantize(node);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.x), ox), ix);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.x), ox), ix);
+        __m128 tNear = _mm_max_ps(_mm_min_ps(t1, t2), _mm_setzero_ps());
+        __m128 tFar = _mm_min_ps(_mm_max_ps(t1, t2), tMax);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.y), oy), iy);
+        t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.y), oy), iy);
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.z), oz), iz);
+        t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.z), oz), iz);
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+        const int lanes = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+        const bool leaf = (node.data & LEAF) != 0;
+
+        if (leaf && lanes) {
+            const XMFLOAT3* triangle = &vertices_[(node.data & ~LEAF) * 3];
+            _mm_store_ps(maxFractions, tMax);
+            for (uint32_t lane = 0; lane < count; ++lane) {
+                if (!(lanes & (1 << lane))) continue;
+                RayHit& hit = hits[lane];
+                float candidate;
+                if (RayCastTriangle(triangle, from[lane], delta[lane], maxFractions[lane], candidate, hit.normal,
+                                    &hit.backFace)) {
+                    maxFractions[lane] = candidate;
+                    hit.fraction = candidate;
+                    hit.hit = true;
+                }
+            }
+            tMax = _mm_load_ps(maxFractions);
+        }
+        index += (lanes || leaf) ? 1 : node.data;
+    }
+}
+
+bool TriangleMeshCollider::Save(const std::string& filename) const {
+    FileHeader header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.nodeCount = static_cast<uint32_t>(nodes_.size());
+    header.triangleCount = static_cast<uint32_t>(GetTriangleCount());
+    header.bounds = bounds_;
+
+    bool written = WriteFileAtomic(filename, [&](std::ostream& file) {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(nodes_.data()), nodes_.size() * sizeof(Node));
+        file.write(reinterpret_cast<const char*>(vertices_.data()), vertices_.size() * sizeof(XMFLOAT3));
+    });
+    if (!written) {
+        Logger::Error("Failed to write collision cache: " + filename);
+        return false;
+    }
+    return true;
+}
+
+bool TriangleMeshCollider::Load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    FileHeader header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != MAGIC ||
+        header.version != VERSION || header.triangleCount == 0 || header.nodeCount != header.triangleCount * 2 - 1) {
+        Logger::Error("Not a collision cache: " + filename);
+        return false;
+    }
+
+    nodes_.resize(header.nodeCount);
+    vertices_.resize(static_cast<size_t>(header.triangleCount) * 3);
+    if (!file.read(reinterpret_cast<char*>(nodes_.data()), nodes_.size() * sizeof(Node)) ||
+        !file.read(reinterpret_cast<char*>(vertices_.data()), vertices_.size() * sizeof(XMFLOAT3))) {
+        Logger::Error("Truncated collision cache: " + filename);
+        nodes_.clear();
+        vertices_.clear();
+        return false;
+    }
+
+    bounds_ = header.bounds;
+    XMFLOAT3 extent = Subtract(bounds_.max, bounds_.min);
+    quantization_ = XMFLOAT3(65535.0f / std::max(extent.x, 1e-6f), 65535.0f / std::max(extent.y, 1e-6f),
+                             65535.0f / std::max(extent.z, 1e-6f));
+    return true;
+}
+
+std::string TriangleMeshCollider::GetCachePath(const std::string& sourceFile) {
+    return sourceFile + ".ncol";
+}
+
+bool TriangleMeshCollider::BuildCache(const std::string& sourceFile) {
+    std::error_code error;
+    auto cacheTime = std::filesystem::last_write_time(GetCachePath(sourceFile), error);
+    if (!error) {
+        auto sourceTime = std::filesystem::last_write_time(sourceFile, error);
+        if (error || cacheTime >= sourceTime) return true;
+    }
+
+    MeshData mesh;
+    TriangleMeshCollider collider;
+    if (!MeshImporter::Import(sourceFile, mesh) || !collider.Build(mesh)) return false;
+
+    Logger::Info("Baked " + GetCachePath(sourceFile) + ": " + std::to_string(collider.GetTriangleCount()) +
+                 " triangles, " + std::to_string(collider.GetNodeCount()) + " nodes");
+    return collider.Save(GetCachePath(sourceFile));
+}
+
+} // namespace Nexus
@@ -0,0 +1,215 @@
+#include "BinaryFile.h"
+#include "AtomicFile.h"
+#include "LZ4.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace Nexus {
+
+namespace {
+
+constexpr uint32_t BINARY_MAGIC = 0x4642584E;  // "NXBF"
+constexpr uint32_t BINARY_VERSION = 1;
+
+struct BinaryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t contentType;
+    uint32_t contentVersion;
+    uint32_t sectionCount;
+    uint32_t reserved;
+};
+
+uint64_t AlignUp(uint64_t value) {
+    return (value + BinaryFile::ALIGNMENT - 1) / BinaryFile::ALIGNMENT * BinaryFile::ALIGNMENT;
+}
+
+uint32_t GetFieldSize(BinarySchema::FieldType type) {
+    switch (type) {
+    case BinarySchema::FieldType::U16: return 2;
+    case BinarySchema::FieldType::U32:
+    case BinarySchema::FieldType::I32:
+    case BinarySchema::FieldType::F32:
+    case BinarySchema::FieldType::Offset: return 4;
+    case BinarySchema::FieldType::U64: return 8;
+    default: return 1;
+    }
+}
+
+} // namespace
+
+BinarySchema& BinarySchema::Field(const char* name, FieldType type, uint32_t count) {
+    // FNV-1a 64 over each field's name, type and count
+    auto mix = [this](uint8_t byte) { hash_ = (hash_ ^ byte) * 1099511628211ull; };
+    for (const char* c = name; *c; ++c) mix(static_cast<uint8_t>(*c));
+    mix(0);
+    mix(static_cast<uint8_t>(type));
+    for (int shift = 0; shift < 32; shift += 8) mix(static_cast<uint8_t>(count >> shift));
+    elementSize_ += GetFieldSize(type) * count;
+    return *this;
+}
+
+BinaryFileWriter::BinaryFileWriter(uint32_t contentType, uint32_t contentVersion)
+    : contentType_(contentType)
+    , contentVersion_(contentVersion)
+{
+}
+
+void BinaryFileWriter::AddSection(uint32_t id, const BinarySchema& schema, const void* elements, size_t count,
+                                  bool compress) {
+    Section section;
+    section.entry = {};
+    section.entry.id = id;
+    section.entry.elementSize = schema.GetElementSize();
+    section.entry.schemaHash = schema.GetHash();
+    section.entry.elementCount = count;
+    section.entry.compression = BinaryCompression::None;
+
+    const size_t size = count * schema.GetElementSize();
+    const uint8_t* bytes = static_cast<const uint8_t*>(elements);
+    if (compress && size > 0) {
+        CompressLZ4(bytes, size, section.bytes);
+        if (section.bytes.size() <= size - size / 8) {
+            section.entry.compression = BinaryCompression::LZ4;
+        }
+    }
+    if (section.entry.compression == BinaryCompression::None) {
+        section.bytes.assign(bytes, bytes + size);
+    }
+    section.entry.storedSize = section.bytes.size();
+    sections_.push_back(std::move(section));
+}
+
+bool BinaryFileWriter::Write(const std::string& filename) const {
+    NEXUS_PROFILE_SCOPE("BinaryFileWriter::Write");
+
+    const BinaryHeader header = { BINARY_MAGIC, BINARY_VERSION, contentType_, contentVersion_,
+                                  static_cast<uint32_t>(sections_.size()), 0 };
+    std::vector<BinarySectionEntry> table;
+    table.reserve(sections_.size());
+    uint64_t offset = sizeof(BinaryHeader) + sections_.size() * sizeof(BinarySectionEntry);
+    for (const Section& section : sections_) {
+        offset = AlignUp(offset);
+        table.push_back(section.entry);
+        table.back().offset = offset;
+        offset += section.entry.storedSize;
+    }
+
+    bool saved = WriteFileAtomic(filename, [&](std::ostream& file) {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(BinarySectionEntry)));
+        uint64_t written = sizeof(BinaryHeader) + table.size() * sizeof(BinarySectionEntry);
+        static const char zeros[BinaryFile::ALIGNMENT] = {};
+        for (size_t i = 0; i < sections_.size(); ++i) {
+            file.write(zeros, static_cast<std::streamsize>(table[i].offset - written));
+            file.write(reinterpret_cast<const char*>(sections_[i].bytes.data()), static_cast<std::streamsize>(table[i].storedSize));
+            written = table[i].offset + table[i].storedSize;
+        }
+    });
+    if (!saved) {
+        Logger::Error("Could not write binary file: " + filename);
+        return false;
+    }
+    return true;
+}
+
+bool BinaryFile::Open(const std::string& filename, uint32_t contentType) {
+    Close();
+    if (!file_.Open(filename)) return false;
+
+    const uint8_t* data = file_.GetData();
+    const size_t size = file_.GetSize();
+    BinaryHeader header;
+    if (size < sizeof(header)) {
+        Logger::Error("Binary file is truncated: " + filename);
+        Close();
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != BINARY_MAGIC || header.version != BINARY_VERSION || header.contentType != contentType) {
+        Logger::Error("Not a binary file of the expected kind and version: " + filename);
+        Close();
+        return false;
+    }
+    if ((size - sizeof(header)) / sizeof(BinarySectionEntry) < header.sectionCount) {
+        Logger::Error("Binary file section table is truncated: " + filename);
+        Close();
+        return false;
+    }
+
+    // The mapping is page aligned, so the table after the 24-byte header is 8-byte aligned
+    const BinarySectionEntry* sections = reinterpret_cast<const BinarySectionEntry*>(data + sizeof(header));
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        const BinarySectionEntry& section = sections[i];
+        const bool inside = section.offset % ALIGNMENT == 0 && section.offset <= size &&
+                            section.storedSize <= size - section.offset;
+        const bool sized = section.compression != BinaryCompression::None ||
+                           (section.elementSize > 0 && section.storedSize / section.elementSize == section.elementCount &&
+                            section.storedSize % section.elementSize == 0) ||
+                           (section.elementCount == 0 && section.storedSize == 0);
+        if (!inside || !sized || section.compression > BinaryCompression::LZ4) {
+            Logger::Error("Binary file section table is damaged: " + filename);
+            Close();
+            return false;
+        }
+    }
+
+    contentVersion_ = header.contentVersion;
+    sections_ = sections;
+    sectionCount_ = header.sectionCount;
+    return true;
+}
+
+void BinaryFile::Close() {
+    file_.Close();
+    contentVersion_ = 0;
+    sections_ = nullptr;
+    sectionCount_ = 0;
+}
+
+const BinarySectionEntry* BinaryFile::FindSection(uint32_t id) const {
+    for (uint32_t i = 0; i < sectionCount_; ++i) {
+        if (sections_[i].id == id) return &sections_[i];
+    }
+    return nullptr;
+}
+
+const void* BinaryFile::GetSection(uint32_t id, const BinarySchema& schema, size_t& count,
+                                   std::vector<uint8_t>& buffer) const {
+    count = 0;
+    const BinarySectionEntry* section = FindSection(id);
+    if (!section || section->schemaHash != schema.GetHash() || section->elementSize != schema.GetElementSize()) {
+        return nullptr;
+    }
+
+    const uint8_t* stored = file_.GetData() + section->offset;
+    const void* elements = stored;
+    if (section->compression == BinaryCompression::LZ4) {
+        if (section->elementCount > SIZE_MAX / section->elementSize) return nullptr;
+        buffer.resize(static_cast<size_t>(section->elementCount * section->elementSize));
+        if (!DecompressLZ4(stored, static_cast<size_t>(section->storedSize), buffer.data(), buffer.size())) {
+            return nullptr;
+        }
+        elements = buffer.data();
+    }
+    count = static_cast<size_t>(section->elementCount);
+    return elements;
+}
+
+BinarySchema BinaryStringTable::GetSchema() {
+    return BinarySchema().Field("char", BinarySchema::FieldType::U8);
+}
+
+uint32_t BinaryStringTable::Add(const std::string& text) {
+    auto [it, added] = offsets_.emplace(text, static_cast<uint32_t>(bytes_.size()));
+    if (added) {
+        bytes_.insert(bytes_.end(), text.begin(), text.end());
+        bytes_.push_back('\0');
+    }
+    return it->second;
+}
+
+} // namespace Nexus
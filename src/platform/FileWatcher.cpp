@@ -0,0 +1,279 @@
+#include "FileWatcher.h"
+#include "Platform.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+
+namespace Nexus {
+
+namespace {
+// The most a network share returns in one read; local volumes are happy with it too
+constexpr DWORD BUFFER_SIZE = 64 * 1024;
+constexpr DWORD NOTIFY_FILTER = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+void ToLower(std::string& text) {
+    for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+// The ANSI code page, like every path the engine opens with the A functions
+std::string Narrow(const WCHAR* text, size_t length) {
+    const int size = WideCharToMultiByte(CP_ACP, 0, text, static_cast<int>(length), nullptr, 0, nullptr, nullptr);
+    std::string result(size > 0 ? size : 0, '\0');
+    if (size > 0) WideCharToMultiByte(CP_ACP, 0, text, static_cast<int>(length), &result[0], size, nullptr, nullptr);
+    return result;
+}
+
+std::string GetExtension(const std::string& path) {
+    const size_t dot = path.find_last_of('.');
+    const size_t slash = path.find_last_of('\\');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return {};
+    return path.substr(dot);
+}
+}
+
+struct FileWatcher::Directory {
+    std::string path;                      // Normalized, ends in a backslash
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped = {};
+    std::unique_ptr<DWORD[]> buffer;       // FILE_NOTIFY_INFORMATION must be DWORD aligned
+    bool reading = false;
+
+    ~Directory() {
+        if (handle != INVALID_HANDLE_VALUE) {
+            // The read owns the buffer and OVERLAPPED until it has completed
+            if (reading) {
+                DWORD bytes = 0;
+                CancelIoEx(handle, &overlapped);
+                GetOverlappedResult(handle, &overlapped, &bytes, TRUE);
+            }
+            CloseHandle(handle);
+        }
+        if (overlapped.hEvent) CloseHandle(overlapped.hEvent);
+    }
+};
+
+FileWatcher::FileWatcher()
+    : wakeEvent_(nullptr)
+    , stop_(false)
+    , debounceMs_(100)
+    , overflows_(0)
+    , nextListener_(INVALID_LISTENER + 1)
+{
+}
+
+FileWatcher::~FileWatcher() {
+    Stop();
+}
+
+bool FileWatcher::Start(uint32_t debounceMs) {
+    Stop();
+
+    wakeEvent_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    if (!wakeEvent_) {
+        Logger::Error("Failed to create file watcher event");
+        return false;
+    }
+
+    debounceMs_ = debounceMs;
+    stop_ = false;
+    overflows_ = 0;
+    thread_ = std::thread(&FileWatcher::ThreadMain, this);
+    Logger::Info("File watcher started");
+    return true;
+}
+
+void FileWatcher::Stop() {
+    if (thread_.joinable()) {
+        stop_ = true;
+        SetEvent(wakeEvent_);
+        thread_.join();
+    }
+
+    directories_.clear();
+    added_.clear();
+    pending_.clear();
+    ready_.clear();
+    watched_.clear();
+
+    if (wakeEvent_) {
+        CloseHandle(wakeEvent_);
+        wakeEvent_ = nullptr;
+    }
+}
+
+bool FileWatcher::Watch(const std::string& directory) {
+    if (!thread_.joinable()) return false;
+
+    // Resource and script folders are optional, so a missing one isn't worth a warning
+    const DWORD attributes = GetFileAttributesA(directory.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) return false;
+
+    std::string path = NormalizePath(directory);
+    if (path.empty() || path.back() != '\\') path += '\\';
+    for (const std::string& watched : watched_) {
+        if (path.compare(0, watched.size(), watched) == 0) return true;
+    }
+    if (watched_.size() >= MAX_DIRECTORIES) {
+        Logger::Warning("File watcher is full, not watching " + directory);
+        return false;
+    }
+
+    auto entry = std::make_unique<Directory>();
+    entry->path = path;
+    entry->handle = CreateFileA(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    entry->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (entry->handle == INVALID_HANDLE_VALUE || !entry->overlapped.hEvent) {
+        Logger::Warning("Could not watch directory: " + directory);
+        return false;
+    }
+    entry->buffer.reset(new DWORD[BUFFER_SIZE / sizeof(DWORD)]);
+
+    // The thread issues the reads, so the I/O belongs to it
+    watched_.push_back(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        added_.push_back(std::move(entry));
+    }
+    SetEvent(wakeEvent_);
+    Logger::Info("Watching " + directory + " for changes");
+    return true;
+}
+
+FileWatcher::ListenerID FileWatcher::AddListener(const std::vector<std::string>& extensions, Listener listener) {
+    ListenerEntry entry = { nextListener_++, extensions, std::move(listener) };
+    for (std::string& extension : entry.extensions) ToLower(extension);
+    listeners_.push_back(std::move(entry));
+    return listeners_.back().id;
+}
+
+void FileWatcher::RemoveListener(ListenerID id) {
+    listeners_.erase(std::remove_if(listeners_.begin(), listeners_.end(),
+                                    [id](const ListenerEntry& entry) { return entry.id == id; }),
+                     listeners_.end());
+}
+
+void FileWatcher::Poll() {
+    if (const uint32_t overflows = overflows_.exchange(0)) {
+        Logger::Warning("File watcher lost " + std::to_string(overflows) + " batch(es) of changes; save again to reload");
+    }
+
+    std::vector<std::string> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready.swap(ready_);
+    }
+    if (ready.empty()) return;
+    NEXUS_PROFILE_SCOPE("FileWatcher::Poll");
+
+    // Listeners may add or remove listeners
+    const std::vector<ListenerEntry> listeners = listeners_;
+    for (const std::string& path : ready) {
+        const std::string extension = GetExtension(path);
+        for (const ListenerEntry& listener : listeners) {
+            if (listener.extensions.empty() ||
+                std::find(listener.extensions.begin(), listener.extensions.end(), extension) != listener.extensions.end()) {
+                listener.callback(path);
+            }
+        }
+    }
+}
+
+std::string FileWatcher::NormalizePath(const std::string& path) {
+    char full[MAX_PATH];
+    const DWORD length = GetFullPathNameA(path.c_str(), MAX_PATH, full, nullptr);
+    std::string result = length > 0 && length < MAX_PATH ? std::string(full, length) : path;
+    std::replace(result.begin(), result.end(), '/', '\\');
+    ToLower(result);
+    return result;
+}
+
+void FileWatcher::ThreadMain() {
+    std::vector<HANDLE> events;
+    while (!stop_) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& directory : added_) {
+                if (BeginRead(*directory)) directories_.push_back(std::move(directory));
+            }
+            added_.clear();
+        }
+
+        events.assign(1, wakeEvent_);
+        for (const auto& directory : directories_) events.push_back(directory->overlapped.hEvent);
+
+        // Asleep until something changes, or until the next pending change has been quiet long enough
+        DWORD timeout = INFINITE;
+        uint64_t now = GetTickCount64();
+        for (const auto& change : pending_) {
+            const uint64_t due = change.second + debounceMs_;
+            timeout = std::min(timeout, due > now ? static_cast<DWORD>(due - now) : 0);
+        }
+        const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, timeout);
+
+        // Only the first signalled directory is reported; the rest stay signalled for the next wait
+        now = GetTickCount64();
+        if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + events.size()) {
+            ReadChanges(*directories_[result - WAIT_OBJECT_0 - 1], now);
+        }
+
+        std::vector<std::string> ready;
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (now - it->second < debounceMs_) {
+                ++it;
+                continue;
+            }
+            // Deleted again (an editor's temporary file) or a directory's own timestamp
+            const DWORD attributes = GetFileAttributesA(it->first.c_str());
+            if (attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                ready.push_back(it->first);
+            }
+            it = pending_.erase(it);
+        }
+        if (!ready.empty()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.insert(ready_.end(), ready.begin(), ready.end());
+        }
+    }
+
+    // Cancelled from the thread that issued them
+    directories_.clear();
+}
+
+bool FileWatcher::BeginRead(Directory& directory) {
+    ResetEvent(directory.overlapped.hEvent);
+    directory.reading = ReadDirectoryChangesW(directory.handle, directory.buffer.get(), BUFFER_SIZE, TRUE,
+                                              NOTIFY_FILTER, nullptr, &directory.overlapped, nullptr) != FALSE;
+    return directory.reading;
+}
+
+void FileWatcher::ReadChanges(Directory& directory, uint64_t now) {
+    directory.reading = false;
+
+    DWORD bytes = 0;
+    if (!GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, FALSE)) {
+        // The directory went away: the read below fails too, which ends the watch
+        if (GetLastError() == ERROR_NOTIFY_ENUM_DIR) ++overflows_;
+    } else if (bytes == 0) {
+        // More changed than fits the buffer, and what did is gone
+        ++overflows_;
+    } else {
+        const uint8_t* cursor = reinterpret_cast<const uint8_t*>(directory.buffer.get());
+        for (;;) {
+            const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+            if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                std::string name = Narrow(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                ToLower(name);
+                pending_[directory.path + name] = now;
+            }
+            if (info->NextEntryOffset == 0) break;
+            cursor += info->NextEntryOffset;
+        }
+    }
+
+    BeginRead(directory);
+}
+
+} // namespace Nexus
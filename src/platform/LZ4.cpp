@@ -0,0 +1,115 @@
+#include "LZ4.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Nexus {
+
+namespace {
+
+// LZ4 block format: sequences of a token (literal count, match length), the literals, a 16-bit
+// offset back into the output and the rest of the match length. The last sequence is literals only
+constexpr size_t LZ4_MIN_MATCH = 4;
+constexpr size_t LZ4_LAST_LITERALS = 5;        // The block ends in at least this many literals
+constexpr size_t LZ4_MATCH_START_LIMIT = 12;   // No match starts in the last 12 bytes
+constexpr size_t LZ4_MAX_OFFSET = 65535;
+constexpr uint32_t LZ4_HASH_BITS = 16;
+
+uint32_t Read32(const uint8_t* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+void WriteLength(std::vector<uint8_t>& out, size_t length) {
+    for (; length >= 255; length -= 255) out.push_back(255);
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+void WriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t offset,
+                   size_t matchLength) {
+    const size_t extraMatch = matchLength > 0 ? matchLength - LZ4_MIN_MATCH : 0;
+    out.push_back(static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(extraMatch, 15)));
+    if (literalCount >= 15) WriteLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+    if (matchLength == 0) return;
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (extraMatch >= 15) WriteLength(out, extraMatch - 15);
+}
+
+} // namespace
+
+// Greedy single-probe matcher: fast enough to pack a whole game, and the decoder doesn't care
+void CompressLZ4(const uint8_t* in, size_t size, std::vector<uint8_t>& out) {
+    out.clear();
+    out.reserve(size + size / 255 + 16);
+    size_t anchor = 0;
+    if (size > LZ4_MATCH_START_LIMIT) {
+        std::vector<uint32_t> table(size_t(1) << LZ4_HASH_BITS, 0);
+        const size_t matchEnd = size - LZ4_LAST_LITERALS;
+        const size_t lastStart = size - LZ4_MATCH_START_LIMIT;
+        for (size_t at = 0; at <= lastStart;) {
+            const uint32_t sequence = Read32(in + at);
+            const uint32_t hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+            const size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(at);
+            if (candidate >= at || at - candidate > LZ4_MAX_OFFSET || Read32(in + candidate) != sequence) {
+                ++at;
+                continue;
+            }
+            size_t length = LZ4_MIN_MATCH;
+            while (at + length < matchEnd && in[candidate + length] == in[at + length]) ++length;
+            WriteSequence(out, in + anchor, at - anchor, at - candidate, length);
+            at += length;
+            anchor = at;
+        }
+    }
+    WriteSequence(out, in + anchor, size - anchor, 0, 0);
+}
+
+bool DecompressLZ4(const uint8_t* in, size_t inSize, uint8_t* out, size_t size) {
+    const uint8_t* const inEnd = in + inSize;
+    uint8_t* const outStart = out;
+    uint8_t* const outEnd = out + size;
+    auto readLength = [&in, inEnd](size_t& length) {
+        uint8_t byte = 255;
+        while (byte == 255) {
+            if (in == inEnd) return false;
+            byte = *in++;
+            length += byte;
+        }
+        return true;
+    };
+
+    while (in < inEnd) {
+        const uint8_t token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(literals)) return false;
+        if (literals > static_cast<size_t>(inEnd - in) || literals > static_cast<size_t>(outEnd - out)) return false;
+        std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == inEnd) break;
+
+        if (inEnd - in < 2) return false;
+        const size_t offset = in[0] | (size_t(in[1]) << 8);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(length)) return false;
+        length += LZ4_MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(out - outStart) || length > static_cast<size_t>(outEnd - out)) {
+            return false;
+        }
+        // Overlapping matches repeat the bytes just written, so they go one at a time
+        const uint8_t* match = out - offset;
+        if (offset >= length) {
+            std::memcpy(out, match, length);
+            out += length;
+        } else {
+            for (size_t i = 0; i < length; ++i) *out++ = *match++;
+        }
+    }
+    return out == outEnd;
+}
+
+} // namespace Nexus
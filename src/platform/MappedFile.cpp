@@ -0,0 +1,69 @@
+#include "MappedFile.h"
+#include "Platform.h"
+#include "Logger.h"
+
+namespace Nexus {
+
+MappedFile::MappedFile()
+    : file_(nullptr)
+    , mapping_(nullptr)
+    , data_(nullptr)
+    , size_(0)
+{
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        Logger::Error("Could not open file: " + filename);
+        return false;
+    }
+    file_ = file;
+
+    // Empty files cannot be mapped, and nothing we map is useful empty anyway
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 ||
+        static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX) {
+        Logger::Error("Could not map empty or oversized file: " + filename);
+        Close();
+        return false;
+    }
+
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_) {
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!data_) {
+        Logger::Error("Could not map file: " + filename);
+        Close();
+        return false;
+    }
+
+    size_ = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    if (file_) {
+        CloseHandle(file_);
+        file_ = nullptr;
+    }
+    size_ = 0;
+}
+
+} // namespace Nexus
@@ -0,0 +1,221 @@
+#include "PakArchive.h"
+#include "LZ4.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Nexus {
+
+namespace {
+
+constexpr uint32_t PAK_MAGIC = 0x4B50584E;    // "NXPK"
+constexpr uint32_t PAK_VERSION = 1;
+
+struct PakHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t nameBytes;
+};
+
+uint64_t AlignUp(uint64_t value) {
+    return (value + PakArchive::ALIGNMENT - 1) / PakArchive::ALIGNMENT * PakArchive::ALIGNMENT;
+}
+
+// The rules of HashPakPath, for telling apart names that share a hash
+char NormalizePathChar(char c) {
+    if (c >= 'A' && c <= 'Z') return static_cast<char>(c - 'A' + 'a');
+    return c == '\\' ? '/' : c;
+}
+
+bool IsSamePath(std::string_view path, const char* name) {
+    while (path.size() >= 2 && path[0] == '.' && (path[1] == '/' || path[1] == '\\')) path.remove_prefix(2);
+    for (char c : path) {
+        if (*name == '\0' || NormalizePathChar(c) != NormalizePathChar(*name++)) return false;
+    }
+    return *name == '\0';
+}
+
+// A file on its way into a pak
+struct PendingEntry {
+    PakEntry entry;
+    std::string name;
+    std::string path;
+    size_t input;                              // Position in the input list, which is the data order
+};
+
+}
+
+bool PakArchive::Open(const std::string& filename) {
+    Close();
+    if (!file_.Open(filename)) return false;
+    filename_ = filename;
+
+    const uint8_t* data = file_.GetData();
+    const uint64_t size = file_.GetSize();
+    PakHeader header = {};
+    if (size >= sizeof(header)) std::memcpy(&header, data, sizeof(header));
+    if (header.magic != PAK_MAGIC || header.version != PAK_VERSION) {
+        Logger::Error("Not a pak, or one from another version: " + filename);
+        Close();
+        return false;
+    }
+
+    const uint64_t namesStart = sizeof(header) + uint64_t(header.entryCount) * sizeof(PakEntry);
+    const uint64_t dataStart = namesStart + header.nameBytes;
+    bool valid = dataStart <= size && (header.nameBytes == 0 || data[dataStart - 1] == '\0');
+    // The mapping is page aligned, so the index straight after the header is aligned for reading in place
+    const PakEntry* entries = reinterpret_cast<const PakEntry*>(data + sizeof(header));
+    for (uint32_t i = 0; valid && i < header.entryCount; ++i) {
+        const PakEntry& entry = entries[i];
+        valid = (i == 0 || entries[i - 1].hash < entry.hash) && entry.nameOffset < header.nameBytes &&
+                entry.offset >= dataStart && entry.offset % ALIGNMENT == 0 && entry.size <= size - entry.offset &&
+                entry.compression <= PakCompression::LZ4 &&
+                (entry.compression != PakCompression::None || entry.originalSize == entry.size);
+    }
+    if (!valid) {
+        Logger::Error("Corrupt pak: " + filename);
+        Close();
+        return false;
+    }
+
+    entries_ = entries;
+    entryCount_ = header.entryCount;
+    names_ = reinterpret_cast<const char*>(data + namesStart);
+    Logger::Info("Mounted pak " + filename + " with " + std::to_string(entryCount_) + " files");
+    return true;
+}
+
+void PakArchive::Close() {
+    file_.Close();
+    filename_.clear();
+    entries_ = nullptr;
+    entryCount_ = 0;
+    names_ = nullptr;
+}
+
+const PakEntry* PakArchive::Find(std::string_view path) const {
+    const uint64_t hash = HashPakPath(path);
+    const PakEntry* end = entries_ + entryCount_;
+    const PakEntry* it = std::lower_bound(entries_, end, hash,
+                                          [](const PakEntry& entry, uint64_t value) { return entry.hash < value; });
+    return it != end && it->hash == hash && IsSamePath(path, GetName(*it)) ? it : nullptr;
+}
+
+const uint8_t* PakArchive::Read(const PakEntry& entry, std::vector<uint8_t>& buffer) const {
+    const uint8_t* stored = file_.GetData() + entry.offset;
+    if (entry.compression == PakCompression::None) return stored;
+
+    NEXUS_PROFILE_SCOPE("PakArchive::Decompress");
+    buffer.resize(static_cast<size_t>(entry.originalSize));
+    if (!DecompressLZ4(stored, static_cast<size_t>(entry.size), buffer.data(), buffer.size())) {
+        Logger::Error("Corrupt pak entry " + std::string(GetName(entry)) + " in " + filename_);
+        return nullptr;
+    }
+    return buffer.data();
+}
+
+bool PakArchive::Write(const std::string& filename, const std::vector<std::string>& inputFiles,
+                       const std::string& root, bool compress) {
+    namespace fs = std::filesystem;
+
+    // Names first: the index goes in front of the data, sorted by hash
+    std::vector<PendingEntry> pending(inputFiles.size());
+    for (size_t i = 0; i < inputFiles.size(); ++i) {
+        PendingEntry& entry = pending[i];
+        std::error_code error;
+        fs::path relative = fs::absolute(inputFiles[i], error).lexically_relative(fs::absolute(root.empty() ? "." : root, error));
+        if (relative.empty() || *relative.begin() == "..") relative = fs::path(inputFiles[i]).filename();
+        entry.name = relative.generic_string();
+        entry.path = inputFiles[i];
+        entry.input = i;
+        entry.entry = {};
+        entry.entry.hash = HashPakPath(entry.name);
+    }
+    std::sort(pending.begin(), pending.end(),
+              [](const PendingEntry& a, const PendingEntry& b) { return a.entry.hash < b.entry.hash; });
+    for (size_t i = 1; i < pending.size(); ++i) {
+        if (pending[i].entry.hash == pending[i - 1].entry.hash) {
+            Logger::Error("Pak names " + pending[i - 1].name + " and " + pending[i].name + " have the same hash");
+            return false;
+        }
+    }
+
+    std::string names;
+    for (PendingEntry& entry : pending) {
+        entry.entry.nameOffset = static_cast<uint32_t>(names.size());
+        names.append(entry.name).push_back('\0');
+    }
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        Logger::Error("Could not create pak: " + filename);
+        return false;
+    }
+
+    // Data goes in input order, so files read one after another sit one after another
+    std::vector<PendingEntry*> dataOrder(pending.size());
+    for (PendingEntry& entry : pending) dataOrder[entry.input] = &entry;
+
+    // One input in memory at a time; the index is written over the front once the offsets are known
+    const uint64_t dataStart = sizeof(PakHeader) + pending.size() * sizeof(PakEntry) + names.size();
+    const std::vector<char> zeros(static_cast<size_t>(std::max<uint64_t>(dataStart, ALIGNMENT)), 0);
+    file.write(zeros.data(), static_cast<std::streamsize>(dataStart));
+    uint64_t written = dataStart;
+    uint64_t originalBytes = 0;
+    std::vector<uint8_t> bytes, compressed;
+    for (PendingEntry* next : dataOrder) {
+        PendingEntry& entry = *next;
+        std::ifstream input(entry.path, std::ios::binary | std::ios::ate);
+        if (!input) {
+            Logger::Error("Could not open file for pak: " + entry.path);
+            return false;
+        }
+        bytes.resize(static_cast<size_t>(input.tellg()));
+        input.seekg(0);
+        if (!input.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+            Logger::Error("Could not read file for pak: " + entry.path);
+            return false;
+        }
+
+        // Already compressed formats (PNG, Vorbis) barely shrink and are kept readable in place
+        const uint8_t* stored = bytes.data();
+        entry.entry.size = bytes.size();
+        entry.entry.originalSize = bytes.size();
+        entry.entry.compression = PakCompression::None;
+        if (compress && !bytes.empty()) {
+            CompressLZ4(bytes.data(), bytes.size(), compressed);
+            if (compressed.size() <= bytes.size() - bytes.size() / 8) {
+                stored = compressed.data();
+                entry.entry.size = compressed.size();
+                entry.entry.compression = PakCompression::LZ4;
+            }
+        }
+
+        entry.entry.offset = AlignUp(written);
+        file.write(zeros.data(), static_cast<std::streamsize>(entry.entry.offset - written));
+        file.write(reinterpret_cast<const char*>(stored), static_cast<std::streamsize>(entry.entry.size));
+        written = entry.entry.offset + entry.entry.size;
+        originalBytes += entry.entry.originalSize;
+    }
+
+    PakHeader header = { PAK_MAGIC, PAK_VERSION, static_cast<uint32_t>(pending.size()),
+                         static_cast<uint32_t>(names.size()) };
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const PendingEntry& entry : pending) file.write(reinterpret_cast<const char*>(&entry.entry), sizeof(entry.entry));
+    file.write(names.data(), static_cast<std::streamsize>(names.size()));
+    if (!file) {
+        Logger::Error("Could not write pak: " + filename);
+        return false;
+    }
+
+    Logger::Info("Wrote pak " + filename + " with " + std::to_string(pending.size()) + " files, " +
+                 std::to_string(originalBytes / 1024) + " KB in " + std::to_string(written / 1024) + " KB");
+    return true;
+}
+
+} // namespace Nexus
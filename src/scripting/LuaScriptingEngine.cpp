@@ -1,7 +1,12 @@
 #include "LuaScriptingEngine.h"
+#include "LuaVMPool.h"
+#include "FileWatcher.h"
 #include "Engine.h"
+#include "JobSystem.h"
 #include "Logger.h"
+#include "Profiler.h"
 #include "GameModuleAPI.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -16,11 +21,67 @@ extern "C" {
 
 namespace Nexus {
 
+namespace {
+// How often a task checks the budget, in VM instructions
+constexpr int TASK_HOOK_INSTRUCTIONS = 1000;
+
+uint64_t HashBytes(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool ReadFile(const std::string& filename, std::string& bytes) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    bytes.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(&bytes[0], bytes.size());
+    return static_cast<bool>(file);
+}
+
+// -1 if the file doesn't exist
+long long GetModTime(const std::string& filename) {
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(filename, error);
+    return error ? -1 : static_cast<long long>(time.time_since_epoch().count());
+}
+
+#ifdef NEXUS_LUA_ENABLED
+std::string PopError(lua_State* L) {
+    const char* message = lua_tostring(L, -1);
+    std::string error = message ? message : "(error object is not a string)";
+    lua_pop(L, 1);
+    return error;
+}
+
+int WriteChunk(lua_State*, const void* data, size_t size, void* output) {
+    static_cast<std::string*>(output)->append(static_cast<const char*>(data), size);
+    return 0;
+}
+#endif
+}
+
 LuaScriptingEngine::LuaScriptingEngine()
     : engine_(nullptr)
     , initialized_(false)
     , hotReloadEnabled_(false)
     , L_(nullptr)
+    , updateFunctionStale_(true)
+    , fileWatcher_(nullptr)
+    , fileListener_(FileWatcher::INVALID_LISTENER)
+    , runningTask_(nullptr)
+    , runningTaskCancelled_(false)
+    , nextTask_(1)
+    , taskFrame_(0)
+    , taskTime_(0.0)
+    , taskBudget_(2.0)
+    , profiling_(false)
+    , profileDepth_(0)
+    , profileBase_(0)
 {
 }
 
@@ -48,6 +109,7 @@ bool LuaScriptingEngine::Initialize(Engine* engine) {
         // Initialize Lua bindings
         InitializeLuaBindings();
         RegisterEngineFunctions();
+        RegisterTaskFunctions();
         
         // Add script paths
         AddToPath(".");
@@ -55,6 +117,8 @@ bool LuaScriptingEngine::Initialize(Engine* engine) {
         AddToPath("games/lua");
         
         initialized_ = true;
+        EnableHotReload(hotReloadEnabled_);
+        EnableProfiling(profiling_);
         Logger::Info("Lua scripting engine initialized");
         return true;
 #else
@@ -71,7 +135,17 @@ bool LuaScriptingEngine::Initialize(Engine* engine) {
 void LuaScriptingEngine::Shutdown() {
     if (!initialized_) return;
     
+    SetFileWatcher(nullptr);
+    modifiedScripts_.clear();
+    vmPool_.reset();
+    
 #ifdef NEXUS_LUA_ENABLED
+    // The chunks, function refs and task threads go with the state
+    chunkCache_.clear();
+    tasks_.clear();
+    profileNames_.clear();
+    updateFunction_ = LuaFunctionRef{};
+    updateFunctionStale_ = true;
     if (L_) {
         lua_close(L_);
         L_ = nullptr;
@@ -90,11 +164,48 @@ bool LuaScriptingEngine::ExecuteFile(const std::string& filename) {
     
 #ifdef NEXUS_LUA_ENABLED
     try {
-        int result = luaL_dofile(L_, filename.c_str());
-        if (result != LUA_OK) {
-            std::string error = lua_tostring(L_, -1);
-            lua_pop(L_, 1);
-            Logger::Error("Error executing Lua script " + filename + ": " + error);
+        NEXUS_PROFILE_SCOPE("Lua::ExecuteFile");
+        
+        // Bytecode older than its source is stale, so the source wins while scripts are edited
+        const std::string compiled = GetCompiledPath(filename);
+        const long long sourceTime = GetModTime(filename);
+        const long long compiledTime = compiled != filename ? GetModTime(compiled) : -1;
+        const std::string& path = compiledTime >= sourceTime ? compiled : filename;
+        scriptModTimes_[filename] = std::max(sourceTime, compiledTime);
+        WatchScript(filename);
+        
+        std::string bytes;
+        if (!ReadFile(path, bytes)) {
+            Logger::Error("Could not read Lua script: " + filename);
+            return false;
+        }
+        
+        // Same path and bytes, same function: only the parse is saved, the chunk still runs
+        const uint64_t hash = HashBytes(bytes.data(), bytes.size());
+        auto cached = chunkCache_.find(path);
+        if (cached != chunkCache_.end() && cached->second.hash == hash) {
+            lua_rawgeti(L_, LUA_REGISTRYINDEX, cached->second.ref);
+        } else {
+            const std::string chunkName = "@" + filename;
+            if (luaL_loadbufferx(L_, bytes.data(), bytes.size(), chunkName.c_str(), "bt") != LUA_OK) {
+                Logger::Error("Error compiling Lua script " + filename + ": " + PopError(L_));
+                return false;
+            }
+            lua_pushvalue(L_, -1);
+            const int ref = luaL_ref(L_, LUA_REGISTRYINDEX);
+            if (cached != chunkCache_.end()) {
+                luaL_unref(L_, LUA_REGISTRYINDEX, cached->second.ref);
+                cached->second = { hash, ref };
+            } else {
+                chunkCache_[path] = { hash, ref };
+            }
+        }
+        
+        // It may define a new update
+        updateFunctionStale_ = true;
+        ProfiledEntry entry(*this);
+        if (lua_pcall(L_, 0, 0, 0) != LUA_OK) {
+            Logger::Error("Error executing Lua script " + filename + ": " + PopError(L_));
             return false;
         }
         
@@ -119,6 +230,8 @@ bool LuaScriptingEngine::ExecuteString(const std::string& code) {
     
 #ifdef NEXUS_LUA_ENABLED
     try {
+        updateFunctionStale_ = true;
+        ProfiledEntry entry(*this);
         int result = luaL_dostring(L_, code.c_str());
         if (result != LUA_OK) {
             std::string error = lua_tostring(L_, -1);
@@ -139,6 +252,43 @@ bool LuaScriptingEngine::ExecuteString(const std::string& code) {
 #endif
 }
 
+bool LuaScriptingEngine::CompileFile(const std::string& source, const std::string& output) {
+#ifdef NEXUS_LUA_ENABLED
+    // Bytecode only loads into the same Lua version and number sizes it was compiled with
+    lua_State* L = luaL_newstate();
+    if (!L) {
+        Logger::Error("Failed to create Lua state");
+        return false;
+    }
+    
+    std::string bytecode;
+    bool compiled = luaL_loadfile(L, source.c_str()) == LUA_OK;
+    if (!compiled) {
+        Logger::Error("Error compiling Lua script " + source + ": " + PopError(L));
+    } else if (lua_dump(L, WriteChunk, &bytecode, 1) != 0) {
+        Logger::Error("Could not dump compiled Lua script: " + source);
+        compiled = false;
+    }
+    lua_close(L);
+    if (!compiled) return false;
+    
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+    file.write(bytecode.data(), bytecode.size());
+    if (!file) {
+        Logger::Error("Could not write compiled Lua script: " + output);
+        return false;
+    }
+    return true;
+#else
+    Logger::Error("Lua support not enabled");
+    return false;
+#endif
+}
+
+std::string LuaScriptingEngine::GetCompiledPath(const std::string& source) {
+    return std::filesystem::path(source).replace_extension(".luac").string();
+}
+
 void LuaScriptingEngine::SetGlobal(const std::string& name, double value) {
 #ifdef NEXUS_LUA_ENABLED
     if (!initialized_) return;
@@ -202,6 +352,7 @@ bool LuaScriptingEngine::GetGlobalBool(const std::string& name) {
 bool LuaScriptingEngine::CallFunction(const std::string& functionName) {
 #ifdef NEXUS_LUA_ENABLED
     if (!initialized_) return false;
+    NEXUS_PROFILE_SCOPE("Lua::CallFunction");
     
     lua_getglobal(L_, functionName.c_str());
     if (!lua_isfunction(L_, -1)) {
@@ -209,8 +360,7 @@ bool LuaScriptingEngine::CallFunction(const std::string& functionName) {
         return false;
     }
     
-    int result = lua_pcall(L_, 0, 0, 0);
-    return result == LUA_OK;
+    return ProtectedCall(0, functionName);
 #else
     return false;
 #endif
@@ -219,6 +369,7 @@ bool LuaScriptingEngine::CallFunction(const std::string& functionName) {
 bool LuaScriptingEngine::CallFunction(const std::string& functionName, double arg) {
 #ifdef NEXUS_LUA_ENABLED
     if (!initialized_) return false;
+    NEXUS_PROFILE_SCOPE("Lua::CallFunction");
     
     lua_getglobal(L_, functionName.c_str());
     if (!lua_isfunction(L_, -1)) {
@@ -227,8 +378,7 @@ bool LuaScriptingEngine::CallFunction(const std::string& functionName, double ar
     }
     
     lua_pushnumber(L_, arg);
-    int result = lua_pcall(L_, 1, 0, 0);
-    return result == LUA_OK;
+    return ProtectedCall(1, functionName);
 #else
     return false;
 #endif
@@ -237,6 +387,7 @@ bool LuaScriptingEngine::CallFunction(const std::string& functionName, double ar
 bool LuaScriptingEngine::CallFunction(const std::string& functionName, const std::string& arg) {
 #ifdef NEXUS_LUA_ENABLED
     if (!initialized_) return false;
+    NEXUS_PROFILE_SCOPE("Lua::CallFunction");
     
     lua_getglobal(L_, functionName.c_str());
     if (!lua_isfunction(L_, -1)) {
@@ -245,8 +396,80 @@ bool LuaScriptingEngine::CallFunction(const std::string& functionName, const std
     }
     
     lua_pushstring(L_, arg.c_str());
-    int result = lua_pcall(L_, 1, 0, 0);
-    return result == LUA_OK;
+    return ProtectedCall(1, functionName);
+#else
+    return false;
+#endif
+}
+
+LuaFunctionRef LuaScriptingEngine::GetFunctionRef(const std::string& functionName) {
+    LuaFunctionRef function;
+#ifdef NEXUS_LUA_ENABLED
+    if (!initialized_) return function;
+    
+    lua_getglobal(L_, functionName.c_str());
+    if (!lua_isfunction(L_, -1)) {
+        lua_pop(L_, 1);
+        return function;
+    }
+    function.ref = luaL_ref(L_, LUA_REGISTRYINDEX);
+#endif
+    return function;
+}
+
+void LuaScriptingEngine::ReleaseFunctionRef(LuaFunctionRef& function) {
+#ifdef NEXUS_LUA_ENABLED
+    if (initialized_ && function.IsValid()) luaL_unref(L_, LUA_REGISTRYINDEX, function.ref);
+#endif
+    function = LuaFunctionRef{};
+}
+
+bool LuaScriptingEngine::CallFunction(const LuaFunctionRef& function) {
+#ifdef NEXUS_LUA_ENABLED
+    if (!initialized_ || !function.IsValid()) return false;
+    NEXUS_PROFILE_SCOPE("Lua::CallFunction");
+    
+    lua_rawgeti(L_, LUA_REGISTRYINDEX, function.ref);
+    return ProtectedCall(0, "function ref");
+#else
+    return false;
+#endif
+}
+
+bool LuaScriptingEngine::CallFunction(const LuaFunctionRef& function, double arg) {
+#ifdef NEXUS_LUA_ENABLED
+    if (!initialized_ || !function.IsValid()) return false;
+    NEXUS_PROFILE_SCOPE("Lua::CallFunction");
+    
+    lua_rawgeti(L_, LUA_REGISTRYINDEX, function.ref);
+    lua_pushnumber(L_, arg);
+    return ProtectedCall(1, "function ref");
+#else
+    return false;
+#endif
+}
+
+bool LuaScriptingEngine::CallFunction(const LuaFunctionRef& function, const std::string& arg) {
+#ifdef NEXUS_LUA_ENABLED
+    if (!initialized_ || !function.IsValid()) return false;
+    NEXUS_PROFILE_SCOPE("Lua::CallFunction");
+    
+    lua_rawgeti(L_, LUA_REGISTRYINDEX, function.ref);
+    lua_pushlstring(L_, arg.data(), arg.size());
+    return ProtectedCall(1, "function ref");
+#else
+    return false;
+#endif
+}
+
+bool LuaScriptingEngine::ProtectedCall(int argCount, const std::string& what) {
+#ifdef NEXUS_LUA_ENABLED
+    ProfiledEntry entry(*this);
+    if (lua_pcall(L_, argCount, 0, 0) != LUA_OK) {
+        Logger::Error("Error calling Lua " + what + ": " + PopError(L_));
+        return false;
+    }
+    return true;
 #else
     return false;
 #endif
@@ -259,27 +482,109 @@ void LuaScriptingEngine::RegisterFunction(const std::string& name, lua_CFunction
 #endif
 }
 
+void LuaScriptingEngine::EnableHotReload(bool enable) {
+    hotReloadEnabled_ = enable;
+    SetFileWatcher(enable && initialized_ && engine_ ? engine_->GetFileWatcher() : nullptr);
+}
+
+void LuaScriptingEngine::SetFileWatcher(FileWatcher* watcher) {
+    if (watcher == fileWatcher_) return;
+    if (fileWatcher_) {
+        fileWatcher_->RemoveListener(fileListener_);
+        fileListener_ = FileWatcher::INVALID_LISTENER;
+    }
+    fileWatcher_ = watcher;
+    if (!fileWatcher_) return;
+    
+    fileListener_ = fileWatcher_->AddListener({ ".lua", ".luac" }, [this](const std::string& path) { OnFileChanged(path); });
+    for (const auto& script : scriptModTimes_) {
+        WatchScript(script.first);
+    }
+}
+
+void LuaScriptingEngine::WatchScript(const std::string& filename) {
+    if (!fileWatcher_) return;
+    const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    fileWatcher_->Watch(directory.empty() ? "." : directory.string());
+}
+
+void LuaScriptingEngine::OnFileChanged(const std::string& path) {
+    // Either the source or its bytecode; ExecuteFile picks whichever is newer
+    for (const auto& script : scriptModTimes_) {
+        if (FileWatcher::NormalizePath(script.first) == path ||
+            FileWatcher::NormalizePath(GetCompiledPath(script.first)) == path) {
+            modifiedScripts_.push_back(script.first);
+        }
+    }
+}
+
 void LuaScriptingEngine::CheckForChanges() {
     if (!hotReloadEnabled_ || !initialized_) return;
     
-    // Check modification times of loaded scripts
-    // Reload if changed
+    // Only polled without a watcher
+    if (!fileWatcher_) {
+        for (const auto& script : scriptModTimes_) {
+            const std::string compiled = GetCompiledPath(script.first);
+            long long time = std::max(GetModTime(script.first), compiled != script.first ? GetModTime(compiled) : -1);
+            if (time != script.second) modifiedScripts_.push_back(script.first);
+        }
+    }
+    
+    ReloadModifiedScripts();
 }
 
 void LuaScriptingEngine::ReloadModifiedScripts() {
     if (!hotReloadEnabled_ || !initialized_) return;
     
-    // Reload modified scripts
+    // Taken first, as scripts may load others. A source and its bytecode saved together reload once
+    std::vector<std::string> modified;
+    modified.swap(modifiedScripts_);
+    std::sort(modified.begin(), modified.end());
+    modified.erase(std::unique(modified.begin(), modified.end()), modified.end());
+    for (const std::string& filename : modified) {
+        Logger::Info("Reloading Lua script: " + filename);
+        ExecuteFile(filename);
+    }
+}
+
+LuaEventID LuaScriptingEngine::InternEvent(const std::string& eventName) {
+    auto it = eventIds_.find(eventName);
+    if (it != eventIds_.end()) return it->second;
+    
+    LuaEventID event = static_cast<LuaEventID>(eventCallbacks_.size());
+    eventIds_.emplace(eventName, event);
+    eventCallbacks_.emplace_back();
+    eventScopeNames_.push_back(Profiler::InternName("Lua event " + eventName));
+    return event;
 }
 
 void LuaScriptingEngine::RegisterEventCallback(const std::string& eventName, std::function<void()> callback) {
-    eventCallbacks_[eventName] = callback;
+    RegisterEventCallback(InternEvent(eventName), std::move(callback));
+}
+
+void LuaScriptingEngine::RegisterEventCallback(LuaEventID event, std::function<void()> callback) {
+    if (event < eventCallbacks_.size()) eventCallbacks_[event] = std::move(callback);
 }
 
 void LuaScriptingEngine::TriggerEvent(const std::string& eventName) {
-    auto it = eventCallbacks_.find(eventName);
-    if (it != eventCallbacks_.end()) {
-        it->second();
+    auto it = eventIds_.find(eventName);
+    if (it != eventIds_.end()) {
+        TriggerEvent(it->second);
+    }
+}
+
+void LuaScriptingEngine::TriggerEvent(LuaEventID event) {
+    // Tasks waiting on it resume in the next round of tasks
+    for (Task& task : tasks_) {
+        if (task.wait == Task::Wait::Event && task.event == event) {
+            task.wait = Task::Wait::Frame;
+            task.wakeFrame = taskFrame_;
+        }
+    }
+    
+    if (event < eventCallbacks_.size() && eventCallbacks_[event]) {
+        NEXUS_PROFILE_SCOPE(eventScopeNames_[event]);
+        eventCallbacks_[event]();
     }
 }
 
@@ -289,8 +594,18 @@ void LuaScriptingEngine::Update(float deltaTime) {
     // Update delta time
     SetGlobal("deltaTime", deltaTime);
     
-    // Call update function if it exists
-    CallFunction("update", deltaTime);
+    // Call update function if it exists, looked up only when a script may have replaced it
+    if (updateFunctionStale_) {
+        ReleaseFunctionRef(updateFunction_);
+        updateFunction_ = GetFunctionRef("update");
+        updateFunctionStale_ = false;
+    }
+    CallFunction(updateFunction_, deltaTime);
+    RunTasks(deltaTime);
+    
+    if (vmPool_) {
+        vmPool_->Update(deltaTime, engine_ ? engine_->GetJobs() : nullptr);
+    }
     
     // Check for hot reload
     if (hotReloadEnabled_) {
@@ -298,6 +613,284 @@ void LuaScriptingEngine::Update(float deltaTime) {
     }
 }
 
+bool LuaScriptingEngine::EnableVMPool(unsigned int vmCount) {
+    if (!initialized_) return false;
+    
+    if (vmCount == 0) {
+        JobSystem* jobs = engine_ ? engine_->GetJobs() : nullptr;
+        vmCount = jobs ? jobs->GetWorkerCount() + 1 : 1;
+    }
+    auto pool = std::make_unique<LuaVMPool>();
+    if (!pool->Initialize(vmCount)) return false;
+    vmPool_ = std::move(pool);
+    return true;
+}
+
+void LuaScriptingEngine::EnableProfiling(bool enable) {
+    profiling_ = enable;
+#ifdef NEXUS_LUA_ENABLED
+    if (!initialized_) return;
+    
+    // Hooks are per thread: the main one, every task, and from now on new coroutines
+    lua_sethook(L_, GetHookMask(false) ? Hook : nullptr, GetHookMask(false), 0);
+    for (Task& task : tasks_) {
+        lua_sethook(task.thread, Hook, GetHookMask(true), TASK_HOOK_INSTRUCTIONS);
+    }
+#endif
+}
+
+int LuaScriptingEngine::GetHookMask(bool task) const {
+#ifdef NEXUS_LUA_ENABLED
+    return (task ? LUA_MASKCOUNT : 0) | (profiling_ ? LUA_MASKCALL | LUA_MASKRET : 0);
+#else
+    (void)task;
+    return 0;
+#endif
+}
+
+LuaScriptingEngine::ProfiledEntry::ProfiledEntry(LuaScriptingEngine& engine)
+    : engine(engine)
+    , base(engine.profileBase_)
+{
+    engine.profileBase_ = engine.profileDepth_;
+}
+
+LuaScriptingEngine::ProfiledEntry::~ProfiledEntry() {
+    for (; engine.profileDepth_ > engine.profileBase_; --engine.profileDepth_) {
+        Profiler::EndScope();
+    }
+    engine.profileBase_ = base;
+}
+
+LuaTaskID LuaScriptingEngine::StartTask(const LuaFunctionRef& function) {
+#ifdef NEXUS_LUA_ENABLED
+    if (!initialized_ || !function.IsValid()) return 0;
+    
+    lua_rawgeti(L_, LUA_REGISTRYINDEX, function.ref);
+    return CreateTask(L_, 0);
+#else
+    (void)function;
+    return 0;
+#endif
+}
+
+void LuaScriptingEngine::CancelTask(LuaTaskID task) {
+    // A task cancelling itself runs on until it next waits
+    if (runningTask_ && runningTask_->id == task) {
+        runningTaskCancelled_ = true;
+        return;
+    }
+    
+    for (auto it = tasks_.begin(); it != tasks_.end(); ++it) {
+        if (it->id == task) {
+            ReleaseTask(*it);
+            tasks_.erase(it);
+            return;
+        }
+    }
+}
+
+LuaTaskID LuaScriptingEngine::CreateTask(lua_State* L, int argCount) {
+#ifdef NEXUS_LUA_ENABLED
+    lua_State* thread = lua_newthread(L);
+    const int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_xmove(L, thread, argCount + 1);
+    
+    // Lets the budget suspend a task in the middle of a loop
+    lua_sethook(thread, Hook, GetHookMask(true), TASK_HOOK_INSTRUCTIONS);
+    
+    Task task = { nextTask_++, thread, ref, argCount, Task::Wait::Frame, 0, 0.0, 0 };
+    tasks_.push_back(task);
+    return task.id;
+#else
+    (void)L;
+    (void)argCount;
+    return 0;
+#endif
+}
+
+void LuaScriptingEngine::RunTasks(float deltaTime) {
+#ifdef NEXUS_LUA_ENABLED
+    ++taskFrame_;
+    taskTime_ += deltaTime;
+    if (tasks_.empty()) return;
+    NEXUS_PROFILE_SCOPE("Lua::Tasks");
+    
+    taskDeadline_ = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(taskBudget_);
+    
+    // Every task is visited at most once. Those the budget didn't reach stay in front, so they
+    // go first next frame; tasks started meanwhile wait behind them
+    for (size_t visits = tasks_.size(); visits > 0; --visits) {
+        Task task = tasks_.front();
+        tasks_.pop_front();
+        if (!IsReady(task)) {
+            tasks_.push_back(task);
+            continue;
+        }
+        if (std::chrono::steady_clock::now() >= taskDeadline_) {
+            tasks_.push_front(task);
+            break;
+        }
+        
+        // Unless a wait function says otherwise, a yield (or the budget running out) means next frame
+        task.wait = Task::Wait::Frame;
+        task.wakeFrame = taskFrame_ + 1;
+        runningTask_ = &task;
+        runningTaskCancelled_ = false;
+        int results = 0;
+        int status;
+        {
+            ProfiledEntry entry(*this);
+            status = lua_resume(task.thread, L_, task.argCount, &results);
+        }
+        runningTask_ = nullptr;
+        task.argCount = 0;
+        
+        if (status == LUA_YIELD && !runningTaskCancelled_) {
+            lua_pop(task.thread, results);
+            tasks_.push_back(task);
+            continue;
+        }
+        if (status != LUA_OK && status != LUA_YIELD) {
+            Logger::Error("Lua task " + std::to_string(task.id) + " failed: " + PopError(task.thread));
+        }
+        ReleaseTask(task);
+    }
+#else
+    (void)deltaTime;
+#endif
+}
+
+bool LuaScriptingEngine::IsReady(const Task& task) const {
+    switch (task.wait) {
+    case Task::Wait::Frame: return taskFrame_ >= task.wakeFrame;
+    case Task::Wait::Time: return taskTime_ >= task.wakeTime;
+    default: return false;
+    }
+}
+
+void LuaScriptingEngine::ReleaseTask(Task& task) {
+#ifdef NEXUS_LUA_ENABLED
+    // The thread is collected with everything on its stack
+    luaL_unref(L_, LUA_REGISTRYINDEX, task.ref);
+    task.ref = LUA_NOREF;
+#else
+    (void)task;
+#endif
+}
+
+void LuaScriptingEngine::RegisterTaskFunctions() {
+#ifdef NEXUS_LUA_ENABLED
+    // Copied into every thread created from here on, tasks included
+    *static_cast<LuaScriptingEngine**>(lua_getextraspace(L_)) = this;
+    
+    lua_register(L_, "task_start", LuaTaskStart);
+    lua_register(L_, "task_cancel", LuaTaskCancel);
+    lua_register(L_, "wait_frames", LuaWaitFrames);
+    lua_register(L_, "wait_seconds", LuaWaitSeconds);
+    lua_register(L_, "wait_event", LuaWaitEvent);
+#endif
+}
+
+#ifdef NEXUS_LUA_ENABLED
+LuaScriptingEngine* LuaScriptingEngine::GetEngine(lua_State* L) {
+    return *static_cast<LuaScriptingEngine**>(lua_getextraspace(L));
+}
+
+LuaScriptingEngine::Task* LuaScriptingEngine::GetRunningTask(lua_State* L, const char* function) {
+    Task* task = GetEngine(L)->runningTask_;
+    if (!task || task->thread != L) {
+        luaL_error(L, "%s can only be called from a task", function);
+        return nullptr;
+    }
+    return task;
+}
+
+void LuaScriptingEngine::Hook(lua_State* L, lua_Debug* debug) {
+    LuaScriptingEngine* engine = GetEngine(L);
+    switch (debug->event) {
+    case LUA_HOOKCOUNT:
+        // Only the task's own thread, not a coroutine it resumes, and only where it can yield
+        if (engine->runningTask_ && engine->runningTask_->thread == L && lua_isyieldable(L) &&
+            std::chrono::steady_clock::now() >= engine->taskDeadline_) {
+            lua_yield(L, 0);
+        }
+        break;
+    case LUA_HOOKCALL:
+        engine->BeginFunctionScope(L, debug);
+        break;
+    case LUA_HOOKRET:
+        // C functions have no scope; nor do functions that were running before this entry
+        lua_getinfo(L, "S", debug);
+        if (debug->what[0] != 'C' && engine->profileDepth_ > engine->profileBase_) {
+            --engine->profileDepth_;
+            Profiler::EndScope();
+        }
+        break;
+    default:
+        // A tail call reuses its caller's scope, closed when the callee returns
+        break;
+    }
+}
+
+void LuaScriptingEngine::BeginFunctionScope(lua_State* L, lua_Debug* debug) {
+    lua_getinfo(L, "Sn", debug);
+    if (debug->what[0] == 'C') return;
+    
+    const char*& name = profileNames_[{ debug->source, debug->linedefined }];
+    if (!name) {
+        const std::string function = debug->what[0] == 'm' ? "main chunk" : debug->name ? debug->name : "anonymous";
+        name = Profiler::InternName(function + " (" + debug->short_src + ":" + std::to_string(debug->linedefined) + ")");
+    }
+    Profiler::BeginScope(name);
+    ++profileDepth_;
+}
+
+// task_start(fn, ...): fn(...) runs as a task from the next frame on. Returns its id
+int LuaScriptingEngine::LuaTaskStart(lua_State* L) {
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    const LuaTaskID task = GetEngine(L)->CreateTask(L, lua_gettop(L) - 1);
+    lua_pushinteger(L, task);
+    return 1;
+}
+
+int LuaScriptingEngine::LuaTaskCancel(lua_State* L) {
+    GetEngine(L)->CancelTask(static_cast<LuaTaskID>(luaL_checkinteger(L, 1)));
+    return 0;
+}
+
+int LuaScriptingEngine::LuaWaitFrames(lua_State* L) {
+    Task* task = GetRunningTask(L, "wait_frames");
+    task->wakeFrame = GetEngine(L)->taskFrame_ + std::max<lua_Integer>(luaL_optinteger(L, 1, 1), 1);
+    return lua_yield(L, 0);
+}
+
+int LuaScriptingEngine::LuaWaitSeconds(lua_State* L) {
+    Task* task = GetRunningTask(L, "wait_seconds");
+    task->wait = Task::Wait::Time;
+    task->wakeTime = GetEngine(L)->taskTime_ + luaL_checknumber(L, 1);
+    return lua_yield(L, 0);
+}
+
+int LuaScriptingEngine::LuaWaitEvent(lua_State* L) {
+    Task* task = GetRunningTask(L, "wait_event");
+    task->wait = Task::Wait::Event;
+    task->event = GetEngine(L)->InternEvent(luaL_checkstring(L, 1));
+    return lua_yield(L, 0);
+}
+#else
+LuaScriptingEngine* LuaScriptingEngine::GetEngine(lua_State*) { return nullptr; }
+LuaScriptingEngine::Task* LuaScriptingEngine::GetRunningTask(lua_State*, const char*) { return nullptr; }
+void LuaScriptingEngine::Hook(lua_State*, lua_Debug*) {}
+void LuaScriptingEngine::BeginFunctionScope(lua_State*, lua_Debug*) {}
+int LuaScriptingEngine::LuaTaskStart(lua_State*) { return 0; }
+int LuaScriptingEngine::LuaTaskCancel(lua_State*) { return 0; }
+int LuaScriptingEngine::LuaWaitFrames(lua_State*) { return 0; }
+int LuaScriptingEngine::LuaWaitSeconds(lua_State*) { return 0; }
+int LuaScriptingEngine::LuaWaitEvent(lua_State*) { return 0; }
+#endif
+
 void LuaScriptingEngine::InitializeLuaBindings() {
 #ifdef NEXUS_LUA_ENABLED
     if (!initialized_) return;
@@ -364,6 +957,95 @@ void LuaScriptingEngine::RegisterEngineFunctions() {
         nexus_present_frame();
         return 0;
     });
+    
+    // character_create(x, y, z [, radius, height, stepHeight, maxSlope]) returns an id, or nil
+    // without physics
+    lua_register(L_, "character_create", [](lua_State* L) {
+        NexusPhysics* physics = nexus_engine_get_physics(reinterpret_cast<NexusEngine*>(GetEngine(L)->engine_));
+        NexusVector3 position = { (float)luaL_checknumber(L, 1), (float)luaL_checknumber(L, 2),
+                                  (float)luaL_checknumber(L, 3) };
+        NexusCharacterId character = nexus_physics_create_character(physics, position,
+            (float)luaL_optnumber(L, 4, 0.4), (float)luaL_optnumber(L, 5, 1.8),
+            (float)luaL_optnumber(L, 6, 0.35), (float)luaL_optnumber(L, 7, 0.785));
+        if (character == 0) return 0;
+        lua_pushinteger(L, character);
+        return 1;
+    });
+    
+    lua_register(L_, "character_destroy", [](lua_State* L) {
+        NexusPhysics* physics = nexus_engine_get_physics(reinterpret_cast<NexusEngine*>(GetEngine(L)->engine_));
+        nexus_physics_destroy_character(physics, (NexusCharacterId)luaL_checkinteger(L, 1));
+        return 0;
+    });
+    
+    // character_move(id, dx, dy, dz, dt) returns the new x, y, z and whether it is grounded
+    lua_register(L_, "character_move", [](lua_State* L) {
+        NexusPhysics* physics = nexus_engine_get_physics(reinterpret_cast<NexusEngine*>(GetEngine(L)->engine_));
+        NexusCharacterId character = (NexusCharacterId)luaL_checkinteger(L, 1);
+        float displacement[3] = { (float)luaL_checknumber(L, 2), (float)luaL_checknumber(L, 3),
+                                  (float)luaL_checknumber(L, 4) };
+        nexus_physics_move_characters(physics, &character, displacement, 1, (float)luaL_optnumber(L, 5, 0.0));
+        NexusCharacterState state;
+        if (!nexus_physics_get_character(physics, character, &state)) return 0;
+        lua_pushnumber(L, state.position.x);
+        lua_pushnumber(L, state.position.y);
+        lua_pushnumber(L, state.position.z);
+        lua_pushboolean(L, state.grounded);
+        return 4;
+    });
+    
+    // 2D batch, in pixels from the window's top-left corner: graphics_load_texture(file) returns
+    // a texture id (0 on failure), graphics_draw_sprite(texture, x, y [, width, height, rotation,
+    // r, g, b, a, layer]) centers the sprite on x, y
+    lua_register(L_, "graphics_load_texture", [](lua_State* L) {
+        NexusGraphics* graphics = nexus_engine_get_graphics(reinterpret_cast<NexusEngine*>(GetEngine(L)->engine_));
+        lua_pushinteger(L, nexus_graphics_load_texture(graphics, luaL_checkstring(L, 1)));
+        return 1;
+    });
+    
+    lua_register(L_, "graphics_draw_sprite", [](lua_State* L) {
+        NexusGraphics* graphics = nexus_engine_get_graphics(reinterpret_cast<NexusEngine*>(GetEngine(L)->engine_));
+        NexusSprite sprite;
+        sprite.texture = (int)luaL_checkinteger(L, 1);
+        sprite.x = (float)luaL_checknumber(L, 2);
+        sprite.y = (float)luaL_checknumber(L, 3);
+        sprite.width = (float)luaL_optnumber(L, 4, 0.0);
+        sprite.height = (float)luaL_optnumber(L, 5, 0.0);
+        sprite.rotation = (float)luaL_optnumber(L, 6, 0.0);
+        sprite.color = { (float)luaL_optnumber(L, 7, 1.0), (float)luaL_optnumber(L, 8, 1.0),
+                         (float)luaL_optnumber(L, 9, 1.0), (float)luaL_optnumber(L, 10, 1.0) };
+        sprite.layer = (int)luaL_optinteger(L, 11, 0);
+        nexus_graphics_draw_sprite(graphics, &sprite);
+        return 0;
+    });
+    
+    // graphics_draw_line(x0, y0, x1, y1 [, r, g, b, a])
+    lua_register(L_, "graphics_draw_line", [](lua_State* L) {
+        NexusGraphics* graphics = nexus_engine_get_graphics(reinterpret_cast<NexusEngine*>(GetEngine(L)->engine_));
+        NexusVector3 start = { (float)luaL_checknumber(L, 1), (float)luaL_checknumber(L, 2), 0.0f };
+        NexusVector3 end = { (float)luaL_checknumber(L, 3), (float)luaL_checknumber(L, 4), 0.0f };
+        NexusColor color = { (float)luaL_optnumber(L, 5, 1.0), (float)luaL_optnumber(L, 6, 1.0),
+                             (float)luaL_optnumber(L, 7, 1.0), (float)luaL_optnumber(L, 8, 1.0) };
+        nexus_graphics_draw_line(graphics, start, end, color);
+        return 0;
+    });
+    
+    // graphics_draw_text(text, x, y [, r, g, b, a])
+    lua_register(L_, "graphics_draw_text", [](lua_State* L) {
+        NexusGraphics* graphics = nexus_engine_get_graphics(reinterpret_cast<NexusEngine*>(GetEngine(L)->engine_));
+        NexusColor color = { (float)luaL_optnumber(L, 4, 1.0), (float)luaL_optnumber(L, 5, 1.0),
+                             (float)luaL_optnumber(L, 6, 1.0), (float)luaL_optnumber(L, 7, 1.0) };
+        nexus_graphics_draw_text(graphics, luaL_checkstring(L, 1), (int)luaL_checkinteger(L, 2),
+                                 (int)luaL_checkinteger(L, 3), color);
+        return 0;
+    });
+    
+    // graphics_set_layer(layer) for later lines and text
+    lua_register(L_, "graphics_set_layer", [](lua_State* L) {
+        NexusGraphics* graphics = nexus_engine_get_graphics(reinterpret_cast<NexusEngine*>(GetEngine(L)->engine_));
+        nexus_graphics_set_layer(graphics, (int)luaL_checkinteger(L, 1));
+        return 0;
+    });
 #endif
 }
 
@@ -0,0 +1,289 @@
+#include "LuaVMPool.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+
+#ifdef NEXUS_LUA_ENABLED
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+}
+#endif
+
+namespace Nexus {
+
+namespace {
+#ifdef NEXUS_LUA_ENABLED
+std::string PopError(lua_State* L) {
+    const char* message = lua_tostring(L, -1);
+    std::string error = message ? message : "(error object is not a string)";
+    lua_pop(L, 1);
+    return error;
+}
+#endif
+}
+
+LuaVMPool::LuaVMPool()
+    : nextEntity_(NO_ENTITY + 1) {}
+
+LuaVMPool::~LuaVMPool() {
+    Shutdown();
+}
+
+bool LuaVMPool::Initialize(unsigned int vmCount) {
+    Shutdown();
+#ifdef NEXUS_LUA_ENABLED
+    for (unsigned int i = 0; i < std::max(vmCount, 1u); ++i) {
+        auto vm = std::make_unique<VM>();
+        vm->L = luaL_newstate();
+        if (!vm->L) {
+            Logger::Error("Failed to create Lua state");
+            Shutdown();
+            return false;
+        }
+        luaL_openlibs(vm->L);
+        *static_cast<VM**>(lua_getextraspace(vm->L)) = vm.get();
+        lua_register(vm->L, "send", LuaSend);
+        for (LogLevel level : { LogLevel::Info, LogLevel::Warning, LogLevel::Error }) {
+            lua_pushinteger(vm->L, static_cast<lua_Integer>(level));
+            lua_pushcclosure(vm->L, LuaLog, 1);
+            lua_setglobal(vm->L, level == LogLevel::Info ? "log_info" : level == LogLevel::Warning ? "log_warning" : "log_error");
+        }
+        vms_.push_back(std::move(vm));
+    }
+    Logger::Info("Lua VM pool initialized with " + std::to_string(vms_.size()) + " VMs");
+    return true;
+#else
+    (void)vmCount;
+    Logger::Warning("Lua support not enabled in this build");
+    return false;
+#endif
+}
+
+void LuaVMPool::Shutdown() {
+#ifdef NEXUS_LUA_ENABLED
+    for (auto& vm : vms_) {
+        if (vm->L) lua_close(vm->L);
+    }
+#endif
+    vms_.clear();
+    entityVMs_.clear();
+}
+
+LuaEntityID LuaVMPool::AddEntity(const std::string& filename) {
+#ifdef NEXUS_LUA_ENABLED
+    if (vms_.empty()) return NO_ENTITY;
+
+    // Affinity: an entity never moves, so its VM is picked once by load
+    auto emptiest = std::min_element(vms_.begin(), vms_.end(), [](const auto& a, const auto& b) {
+        return a->entities.size() < b->entities.size();
+    });
+    VM& vm = **emptiest;
+    lua_State* L = vm.L;
+
+    // Compiled once per VM, run once per entity for a table of its own
+    auto chunk = vm.chunks.find(filename);
+    if (chunk == vm.chunks.end()) {
+        if (luaL_loadfilex(L, filename.c_str(), "bt") != LUA_OK) {
+            Logger::Error("Error compiling Lua entity script " + filename + ": " + PopError(L));
+            return NO_ENTITY;
+        }
+        chunk = vm.chunks.emplace(filename, luaL_ref(L, LUA_REGISTRYINDEX)).first;
+    }
+
+    const LuaEntityID id = nextEntity_++;
+    vm.current = id;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, chunk->second);
+    if (lua_pcall(L, 0, 1, 0) != LUA_OK) {
+        vm.current = NO_ENTITY;
+        Logger::Error("Error running Lua entity script " + filename + ": " + PopError(L));
+        return NO_ENTITY;
+    }
+    vm.current = NO_ENTITY;
+    if (!lua_istable(L, -1)) {
+        lua_pop(L, 1);
+        Logger::Error("Lua entity script " + filename + " did not return a table");
+        return NO_ENTITY;
+    }
+
+    lua_pushinteger(L, id);
+    lua_setfield(L, -2, "id");
+    Entity entity = { id, LUA_NOREF, {}, {}, false };
+    if (lua_getfield(L, -1, "update") == LUA_TFUNCTION) entity.update.ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    else lua_pop(L, 1);
+    if (lua_getfield(L, -1, "on_message") == LUA_TFUNCTION) entity.onMessage.ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    else lua_pop(L, 1);
+    entity.table = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    vm.index[id] = vm.entities.size();
+    vm.entities.push_back(entity);
+    entityVMs_[id] = static_cast<uint32_t>(emptiest - vms_.begin());
+    FlushLogs();
+    return id;
+#else
+    (void)filename;
+    return NO_ENTITY;
+#endif
+}
+
+void LuaVMPool::RemoveEntity(LuaEntityID entity) {
+#ifdef NEXUS_LUA_ENABLED
+    auto it = entityVMs_.find(entity);
+    if (it == entityVMs_.end()) return;
+    VM& vm = *vms_[it->second];
+    entityVMs_.erase(it);
+
+    const size_t index = vm.index[entity];
+    Entity& removed = vm.entities[index];
+    luaL_unref(vm.L, LUA_REGISTRYINDEX, removed.table);
+    luaL_unref(vm.L, LUA_REGISTRYINDEX, removed.update.ref);
+    luaL_unref(vm.L, LUA_REGISTRYINDEX, removed.onMessage.ref);
+
+    // Swapped with the last, so updates run in a different order afterwards
+    vm.entities[index] = vm.entities.back();
+    vm.index[vm.entities[index].id] = index;
+    vm.entities.pop_back();
+    vm.index.erase(entity);
+#else
+    (void)entity;
+#endif
+}
+
+void LuaVMPool::Post(LuaEntityID target, const std::string& name, double value) {
+    auto it = entityVMs_.find(target);
+    if (it != entityVMs_.end()) vms_[it->second]->inbox.push_back({ target, NO_ENTITY, name, value, {}, false });
+}
+
+void LuaVMPool::Post(LuaEntityID target, const std::string& name, const std::string& value) {
+    auto it = entityVMs_.find(target);
+    if (it != entityVMs_.end()) vms_[it->second]->inbox.push_back({ target, NO_ENTITY, name, 0.0, value, true });
+}
+
+void LuaVMPool::Update(float deltaTime, JobSystem* jobs) {
+    NEXUS_PROFILE_SCOPE("Lua::VMPool");
+
+    // Everything sent since the last update goes to its target's VM, in VM order so delivery
+    // doesn't depend on which VM finished first
+    for (auto& vm : vms_) {
+        for (LuaMessage& message : vm->outbox) {
+            auto it = entityVMs_.find(message.target);
+            if (it != entityVMs_.end()) vms_[it->second]->inbox.push_back(std::move(message));
+        }
+        vm->outbox.clear();
+    }
+
+    auto run = [this, deltaTime](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) UpdateVM(*vms_[i], deltaTime);
+    };
+    if (jobs && vms_.size() > 1) jobs->ParallelFor(vms_.size(), 1, run);
+    else run(0, vms_.size());
+
+    FlushLogs();
+}
+
+void LuaVMPool::UpdateVM(VM& vm, float deltaTime) {
+#ifdef NEXUS_LUA_ENABLED
+    lua_State* L = vm.L;
+
+    // Messages first, so this update sees them
+    for (const LuaMessage& message : vm.inbox) {
+        auto it = vm.index.find(message.target);
+        if (it == vm.index.end()) continue;
+        Entity& entity = vm.entities[it->second];
+        if (entity.failed || !entity.onMessage.IsValid()) continue;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, entity.onMessage.ref);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, entity.table);
+        lua_pushinteger(L, message.sender);
+        lua_pushlstring(L, message.name.data(), message.name.size());
+        if (message.isText) lua_pushlstring(L, message.text.data(), message.text.size());
+        else lua_pushnumber(L, message.number);
+        Call(vm, entity, 4);
+    }
+    vm.inbox.clear();
+
+    for (Entity& entity : vm.entities) {
+        if (entity.failed || !entity.update.IsValid()) continue;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, entity.update.ref);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, entity.table);
+        lua_pushnumber(L, deltaTime);
+        Call(vm, entity, 2);
+    }
+#else
+    (void)vm;
+    (void)deltaTime;
+#endif
+}
+
+bool LuaVMPool::Call(VM& vm, Entity& entity, int argCount) {
+#ifdef NEXUS_LUA_ENABLED
+    vm.current = entity.id;
+    const bool ok = lua_pcall(vm.L, argCount, 0, 0) == LUA_OK;
+    vm.current = NO_ENTITY;
+    if (!ok) {
+        vm.logs.emplace_back(LogLevel::Error, "Lua entity " + std::to_string(entity.id) + " stopped: " + PopError(vm.L));
+        entity.failed = true;
+    }
+    return ok;
+#else
+    (void)vm;
+    (void)entity;
+    (void)argCount;
+    return false;
+#endif
+}
+
+void LuaVMPool::FlushLogs() {
+    for (auto& vm : vms_) {
+        for (const auto& entry : vm->logs) {
+            switch (entry.first) {
+            case LogLevel::Warning: Logger::Warning(entry.second); break;
+            case LogLevel::Error: Logger::Error(entry.second); break;
+            default: Logger::Info(entry.second); break;
+            }
+        }
+        vm->logs.clear();
+    }
+}
+
+#ifdef NEXUS_LUA_ENABLED
+// Each state's extra space holds its VM
+LuaVMPool::VM* LuaVMPool::GetVM(lua_State* L) {
+    return *static_cast<VM**>(lua_getextraspace(L));
+}
+
+// send(target, name, value): value is a number, string or boolean
+int LuaVMPool::LuaSend(lua_State* L) {
+    VM* vm = GetVM(L);
+    LuaMessage message = {};
+    message.target = static_cast<LuaEntityID>(luaL_checkinteger(L, 1));
+    message.sender = vm->current;
+    size_t length = 0;
+    const char* name = luaL_checklstring(L, 2, &length);
+    message.name.assign(name, length);
+    if (lua_type(L, 3) == LUA_TSTRING) {
+        const char* text = lua_tolstring(L, 3, &length);
+        message.text.assign(text, length);
+        message.isText = true;
+    } else if (lua_isboolean(L, 3)) {
+        message.number = lua_toboolean(L, 3) ? 1.0 : 0.0;
+    } else {
+        message.number = luaL_optnumber(L, 3, 0.0);
+    }
+    vm->outbox.push_back(std::move(message));
+    return 0;
+}
+
+int LuaVMPool::LuaLog(lua_State* L) {
+    VM* vm = GetVM(L);
+    const char* message = luaL_checkstring(L, 1);
+    vm->logs.emplace_back(static_cast<LogLevel>(lua_tointeger(L, lua_upvalueindex(1))), message);
+    return 0;
+}
+#else
+LuaVMPool::VM* LuaVMPool::GetVM(lua_State*) { return nullptr; }
+int LuaVMPool::LuaSend(lua_State*) { return 0; }
+int LuaVMPool::LuaLog(lua_State*) { return 0; }
+#endif
+
+} // namespace Nexus
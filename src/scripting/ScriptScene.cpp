@@ -0,0 +1,160 @@
+#include "ScriptScene.h"
+#include "GraphicsDevice.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+namespace Nexus {
+
+uint32_t ScriptObjectStore::Allocate() {
+    uint32_t slot;
+    if (!freeSlots_.empty()) {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(positions_.size());
+        positions_.emplace_back();
+        rotations_.emplace_back();
+        scales_.emplace_back();
+        sizes_.emplace_back();
+        colors_.emplace_back();
+        shapes_.emplace_back();
+        active_.emplace_back();
+    }
+
+    positions_[slot] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    rotations_[slot] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    scales_[slot] = XMFLOAT3(1.0f, 1.0f, 1.0f);
+    sizes_[slot] = XMFLOAT3(1.0f, 1.0f, 1.0f);
+    colors_[slot] = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    shapes_[slot] = Shape::None;
+    active_[slot] = 1;
+    return slot;
+}
+
+void ScriptObjectStore::Free(uint32_t slot) {
+    shapes_[slot] = Shape::None;
+    active_[slot] = 0;
+    freeSlots_.push_back(slot);
+}
+
+ScriptScene::ScriptScene(ScriptObjectStore& store)
+    : store_(store)
+    , memberCount_(0)
+    , inPass_(false)
+    , needsCompact_(false)
+{
+}
+
+bool ScriptScene::Add(uint32_t slot, uint8_t callbacks, void* object) {
+    if (Contains(slot)) return false;
+    for (const Member& pending : pendingAdds_) {
+        if (pending.slot == slot) return false;
+    }
+
+    if (slot >= memberIndex_.size()) memberIndex_.resize(slot + 1, NOT_A_MEMBER);
+    const Member member = { slot, callbacks, object };
+    if (inPass_) {
+        pendingAdds_.push_back(member);
+    } else {
+        memberIndex_[slot] = static_cast<uint32_t>(members_.size());
+        members_.push_back(member);
+    }
+    ++memberCount_;
+    return true;
+}
+
+bool ScriptScene::Remove(uint32_t slot) {
+    for (size_t i = 0; i < pendingAdds_.size(); ++i) {
+        if (pendingAdds_[i].slot == slot) {
+            pendingAdds_.erase(pendingAdds_.begin() + i);
+            --memberCount_;
+            return true;
+        }
+    }
+    if (!Contains(slot)) return false;
+
+    // Left in place so a running pass keeps its indices; dropped by the next compaction
+    members_[memberIndex_[slot]].object = nullptr;
+    memberIndex_[slot] = NOT_A_MEMBER;
+    --memberCount_;
+    needsCompact_ = true;
+    if (!inPass_) EndPass();
+    return true;
+}
+
+bool ScriptScene::Contains(uint32_t slot) const {
+    return slot < memberIndex_.size() && memberIndex_[slot] != NOT_A_MEMBER;
+}
+
+void ScriptScene::Clear() {
+    for (Member& member : members_) {
+        if (member.object) memberIndex_[member.slot] = NOT_A_MEMBER;
+        member.object = nullptr;
+    }
+    pendingAdds_.clear();
+    memberCount_ = 0;
+    needsCompact_ = true;
+    if (!inPass_) EndPass();
+}
+
+void ScriptScene::EndPass() {
+    inPass_ = false;
+
+    if (needsCompact_) {
+        size_t kept = 0;
+        for (size_t i = 0; i < members_.size(); ++i) {
+            if (!members_[i].object) continue;
+            memberIndex_[members_[i].slot] = static_cast<uint32_t>(kept);
+            members_[kept++] = members_[i];
+        }
+        members_.resize(kept);
+        needsCompact_ = false;
+    }
+
+    for (const Member& member : pendingAdds_) {
+        memberIndex_[member.slot] = static_cast<uint32_t>(members_.size());
+        members_.push_back(member);
+    }
+    pendingAdds_.clear();
+}
+
+void ScriptScene::SubmitBatches(GraphicsDevice& graphics) {
+    NEXUS_PROFILE_SCOPE("ScriptScene::SubmitBatches");
+
+    batchPositions_.clear();
+    batchSizes_.clear();
+    batchColors_.clear();
+    for (const Member& member : members_) {
+        const uint32_t slot = member.slot;
+        if (!member.object || (member.callbacks & CALLBACK_RENDER) || !store_.IsActive(slot)) continue;
+        if (store_.GetShape(slot) != ScriptObjectStore::Shape::Box) continue;
+
+        const XMFLOAT3& size = store_.Size(slot);
+        const XMFLOAT3& scale = store_.Scale(slot);
+        batchPositions_.push_back(store_.Position(slot));
+        batchSizes_.push_back(XMFLOAT3(size.x * scale.x, size.y * scale.y, size.z * scale.z));
+        batchColors_.push_back(store_.Color(slot));
+    }
+    if (!batchPositions_.empty()) {
+        graphics.SubmitBoxes(batchPositions_.data(), batchSizes_.data(), batchColors_.data(), batchPositions_.size());
+    }
+
+    batchPositions_.clear();
+    batchRadii_.clear();
+    batchColors_.clear();
+    for (const Member& member : members_) {
+        const uint32_t slot = member.slot;
+        if (!member.object || (member.callbacks & CALLBACK_RENDER) || !store_.IsActive(slot)) continue;
+        if (store_.GetShape(slot) != ScriptObjectStore::Shape::Sphere) continue;
+
+        batchPositions_.push_back(store_.Position(slot));
+        batchRadii_.push_back(store_.Size(slot).x * store_.Scale(slot).x);
+        batchColors_.push_back(store_.Color(slot));
+    }
+    if (!batchPositions_.empty()) {
+        graphics.SubmitSpheres(batchPositions_.data(), batchRadii_.data(), batchColors_.data(), batchPositions_.size());
+    }
+}
+
+} // namespace Nexus
@@ -1,14 +1,173 @@
 #include "ScriptingEngine.h"
 #include "Engine.h"
 #include "Logger.h"
-#include <iostream>
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "FileWatcher.h"
+#include "FrameMetrics.h"
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+#include <fstream>
+#include <iterator>
 
 namespace Nexus {
 
+namespace {
+#ifdef NEXUS_PYTHON_ENABLED
+// Holds the GIL for a scope, from any thread, including one that already has it
+class GILLock {
+public:
+    GILLock() : state_(PyGILState_Ensure()) {}
+    ~GILLock() { PyGILState_Release(state_); }
+    GILLock(const GILLock&) = delete;
+    GILLock& operator=(const GILLock&) = delete;
+
+private:
+    PyGILState_STATE state_;
+};
+#else
+struct GILLock {
+    GILLock() {}
+};
+#endif
+
+// nexus_tasks, which scripts start tasks with and whose waits tasks yield
+const char* const TASK_MODULE_SOURCE = R"(
+"""Script tasks, resumed by the engine each frame within its time budget.
+
+    def blink(light):
+        while True:
+            light.on = not light.on
+            yield nexus_tasks.wait_seconds(0.5)
+
+    nexus_tasks.start_task(blink(lamp))
+
+A bare yield waits for the next frame. Coroutines await the same waits.
+"""
+
+FRAMES, SECONDS, EVENT = 0, 1, 2
+
+class Wait:
+    __slots__ = ('kind', 'value')
+
+    def __init__(self, kind, value):
+        self.kind = kind
+        self.value = value
+
+    def __await__(self):
+        yield self
+
+def wait_frames(count=1):
+    return Wait(FRAMES, max(int(count), 1))
+
+def wait_seconds(seconds):
+    return Wait(SECONDS, float(seconds))
+
+def wait_event(name):
+    return Wait(EVENT, str(name))
+
+_started = []
+_cancelled = []
+_next_id = 0
+
+def start_task(task):
+    """Runs task from the next frame on; returns an id for cancel_task"""
+    global _next_id
+    if not hasattr(task, 'send'):
+        raise TypeError('start_task takes a generator or coroutine, not ' + type(task).__name__)
+    _next_id += 1
+    _started.append((_next_id, task))
+    return _next_id
+
+def cancel_task(task_id):
+    _cancelled.append(task_id)
+)";
+
+#ifdef NEXUS_PYTHON_ENABLED
+// nexus_metrics functions are bound to a capsule holding the ScriptingEngine, so they follow
+// SetEngine and fail cleanly before an engine is attached
+FrameMetrics* GetScriptMetrics(PyObject* self) {
+    auto* scripting = static_cast<ScriptingEngine*>(PyCapsule_GetPointer(self, nullptr));
+    Engine* engine = scripting ? scripting->GetEngine() : nullptr;
+    FrameMetrics* metrics = engine ? engine->GetMetrics() : nullptr;
+    if (!metrics) PyErr_SetString(PyExc_RuntimeError, "frame metrics not available");
+    return metrics;
+}
+
+PyObject* MetricsSummary(PyObject* self, PyObject* args) {
+    const char* name = "Frame";
+    if (!PyArg_ParseTuple(args, "|s", &name)) return nullptr;
+    FrameMetrics* metrics = GetScriptMetrics(self);
+    if (!metrics) return nullptr;
+    MetricSummary summary;
+    if (!metrics->GetSummary(name, summary)) Py_RETURN_NONE;
+    return Py_BuildValue("{s:f,s:f,s:f,s:f,s:f,s:f,s:I,s:I,s:K}",
+                         "last", summary.last, "mean", summary.mean, "p50", summary.p50,
+                         "p95", summary.p95, "p99", summary.p99, "max", summary.max,
+                         "samples", summary.samples, "hitches", summary.hitches,
+                         "total_hitches", static_cast<unsigned long long>(summary.totalHitches));
+}
+
+PyObject* MetricsSeries(PyObject* self, PyObject*) {
+    FrameMetrics* metrics = GetScriptMetrics(self);
+    if (!metrics) return nullptr;
+    std::vector<std::string> names = metrics->GetSeriesNames();
+    PyObject* list = PyList_New(static_cast<Py_ssize_t>(names.size()));
+    for (size_t i = 0; list && i < names.size(); ++i) {
+        PyList_SET_ITEM(list, static_cast<Py_ssize_t>(i), PyUnicode_FromString(names[i].c_str()));
+    }
+    return list;
+}
+
+PyObject* MetricsExport(PyObject* self, PyObject* args, bool json) {
+    const char* path = nullptr;
+    if (!PyArg_ParseTuple(args, "s", &path)) return nullptr;
+    FrameMetrics* metrics = GetScriptMetrics(self);
+    if (!metrics) return nullptr;
+    return PyBool_FromLong(json ? metrics->ExportJSON(path) : metrics->ExportCSV(path));
+}
+
+PyObject* MetricsExportCSV(PyObject* self, PyObject* args) { return MetricsExport(self, args, false); }
+PyObject* MetricsExportJSON(PyObject* self, PyObject* args) { return MetricsExport(self, args, true); }
+
+PyMethodDef METRICS_METHODS[] = {
+    { "summary", MetricsSummary, METH_VARARGS, "summary(series='Frame') -> dict of ms, or None" },
+    { "series", MetricsSeries, METH_NOARGS, "series() -> names of the recorded series" },
+    { "export_csv", MetricsExportCSV, METH_VARARGS, "export_csv(path) -> True when written" },
+    { "export_json", MetricsExportJSON, METH_VARARGS, "export_json(path) -> True when written" },
+    { nullptr, nullptr, 0, nullptr }
+};
+#endif
+
+bool ReadFile(const std::string& filename, std::string& contents) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+}
+
 ScriptingEngine::ScriptingEngine()
     : engine_(nullptr)
     , initialized_(false)
     , hotReloadEnabled_(false)
+    , fileWatcher_(nullptr)
+    , fileListener_(FileWatcher::INVALID_LISTENER)
+    , updateFunctionStale_(true)
+    , stopThread_(false)
+    , taskFrame_(0)
+    , taskTime_(0.0)
+    , taskBudgetMs_(2.0f)
+    , profiling_(false)
+    , profileDepth_(0)
+#ifdef NEXUS_PYTHON_ENABLED
+    , taskModule_(nullptr)
+    , waitType_(nullptr)
+    , profileCapsule_(nullptr)
+    , mainThreadState_(nullptr)
+    , updateFunction_(nullptr)
+#endif
 {
 }
 
@@ -17,6 +176,7 @@ ScriptingEngine::~ScriptingEngine() {
 }
 
 bool ScriptingEngine::Initialize(Engine* engine) {
+    NEXUS_MEMORY_SCOPE(MemoryTag::Scripting);
     if (initialized_) return true;
     
     engine_ = engine;
@@ -29,6 +189,7 @@ bool ScriptingEngine::Initialize(Engine* engine) {
             Logger::Error("Failed to initialize Python interpreter");
             return false;
         }
+        profileCapsule_ = PyCapsule_New(this, nullptr, nullptr);
 #else
         Logger::Warning("Python support not enabled in this build");
         return false;
@@ -41,8 +202,15 @@ bool ScriptingEngine::Initialize(Engine* engine) {
         
         // Initialize Python bindings
         InitializePythonBindings();
+        FlushLogs();
+        
+#ifdef NEXUS_PYTHON_ENABLED
+        // Taken again only around calls into Python
+        mainThreadState_ = PyEval_SaveThread();
+#endif
         
         initialized_ = true;
+        EnableHotReload(hotReloadEnabled_);
         Logger::Info("Scripting engine initialized");
         return true;
         
@@ -55,13 +223,36 @@ bool ScriptingEngine::Initialize(Engine* engine) {
 void ScriptingEngine::Shutdown() {
     if (!initialized_) return;
     
+    SetFileWatcher(nullptr);
+    modifiedScripts_.clear();
+    EnablePythonThread(false);
+    
 #ifdef NEXUS_PYTHON_ENABLED
     // Cleanup Python
     if (Py_IsInitialized()) {
+        PyEval_RestoreThread(mainThreadState_);
+        mainThreadState_ = nullptr;
+        // Callbacks may hold Python objects
+        eventCallbacks_.clear();
+        for (Task& task : tasks_) {
+            Py_DECREF(task.task);
+        }
+        tasks_.clear();
+        Py_CLEAR(waitType_);
+        Py_CLEAR(taskModule_);
+        PyEval_SetProfile(nullptr, nullptr);
+        for (const auto& entry : profileNames_) {
+            Py_DECREF(entry.first);
+        }
+        profileNames_.clear();
+        Py_CLEAR(profileCapsule_);
+        Py_CLEAR(updateFunction_);
         Py_Finalize();
     }
 #endif
     
+    pending_ = Batch{};
+    updateFunctionStale_ = true;
     initialized_ = false;
     Logger::Info("Scripting engine shutdown");
 }
@@ -72,32 +263,21 @@ bool ScriptingEngine::ExecuteFile(const std::string& filename) {
         return false;
     }
     
-    try {
-        FILE* file = fopen(filename.c_str(), "r");
-        if (!file) {
-            Logger::Error("Could not open script file: " + filename);
-            return false;
-        }
-        
-#ifdef NEXUS_PYTHON_ENABLED
-        int result = PyRun_SimpleFile(file, filename.c_str());
-#else
-        int result = -1; // Error when Python not enabled
-#endif
-        fclose(file);
-        
-        if (result != 0) {
-            Logger::Error("Error executing script: " + filename);
-            return false;
-        }
-        
-        Logger::Info("Successfully executed script: " + filename);
+    scriptFiles_[FileWatcher::NormalizePath(filename)] = filename;
+    WatchScript(filename);
+    
+    if (IsPythonThreadEnabled()) {
+        Submit([this, filename] { RunFile(filename); });
         return true;
-        
-    } catch (const std::exception& e) {
-        Logger::Error("Exception executing script " + filename + ": " + std::string(e.what()));
-        return false;
     }
+    
+    bool result;
+    {
+        GILLock gil;
+        result = RunFile(filename);
+    }
+    FlushLogs();
+    return result;
 }
 
 bool ScriptingEngine::ExecuteString(const std::string& code) {
@@ -106,63 +286,495 @@ bool ScriptingEngine::ExecuteString(const std::string& code) {
         return false;
     }
     
-    try {
+    if (IsPythonThreadEnabled()) {
+        Submit([this, code] { RunString(code); });
+        return true;
+    }
+    
+    bool result;
+    {
+        GILLock gil;
+        result = RunString(code);
+    }
+    FlushLogs();
+    return result;
+}
+
+bool ScriptingEngine::RunFile(const std::string& filename) {
+    NEXUS_PROFILE_SCOPE("Python::ExecuteFile");
+    ApplyProfiling();
+    
+    std::string source;
+    if (!ReadFile(filename, source)) {
+        Log(LogLevel::Error, "Could not open script file: " + filename);
+        return false;
+    }
+    
 #ifdef NEXUS_PYTHON_ENABLED
-        int result = PyRun_SimpleString(code.c_str());
+    updateFunctionStale_ = true;
+    
+    // Compiled from memory, so no FILE* crosses into the interpreter's C runtime, and under
+    // the file's name so tracebacks point into it
+    PyObject* result = nullptr;
+    PyObject* code = Py_CompileString(source.c_str(), filename.c_str(), Py_file_input);
+    if (code) {
+        PyObject* globals = PyModule_GetDict(PyImport_AddModule("__main__"));
+        result = PyEval_EvalCode(code, globals, globals);
+        Py_DECREF(code);
+    }
+    if (!result) {
+        PyErr_Print();
+        Log(LogLevel::Error, "Error executing script: " + filename);
+        return false;
+    }
+    Py_DECREF(result);
+    
+    Log(LogLevel::Info, "Successfully executed script: " + filename);
+    return true;
 #else
-        int result = -1; // Error when Python not enabled
+    Log(LogLevel::Error, "Error executing script: " + filename);
+    return false;
 #endif
-        if (result != 0) {
-            Logger::Error("Error executing Python code");
-            return false;
-        }
-        
-        return true;
-        
-    } catch (const std::exception& e) {
-        Logger::Error("Exception executing Python code: " + std::string(e.what()));
+}
+
+bool ScriptingEngine::RunString(const std::string& code) {
+    NEXUS_PROFILE_SCOPE("Python::ExecuteString");
+    ApplyProfiling();
+    
+#ifdef NEXUS_PYTHON_ENABLED
+    updateFunctionStale_ = true;
+    if (PyRun_SimpleString(code.c_str()) != 0) {
+        Log(LogLevel::Error, "Error executing Python code");
         return false;
     }
+    return true;
+#else
+    (void)code;
+    Log(LogLevel::Error, "Error executing Python code");
+    return false;
+#endif
+}
+
+void ScriptingEngine::EnableHotReload(bool enable) {
+    hotReloadEnabled_ = enable;
+    SetFileWatcher(enable && initialized_ && engine_ ? engine_->GetFileWatcher() : nullptr);
+}
+
+void ScriptingEngine::SetFileWatcher(FileWatcher* watcher) {
+    if (watcher == fileWatcher_) return;
+    if (fileWatcher_) {
+        fileWatcher_->RemoveListener(fileListener_);
+        fileListener_ = FileWatcher::INVALID_LISTENER;
+    }
+    fileWatcher_ = watcher;
+    if (!fileWatcher_) return;
+    
+    fileListener_ = fileWatcher_->AddListener({ ".py" }, [this](const std::string& path) {
+        auto script = scriptFiles_.find(path);
+        if (script != scriptFiles_.end()) modifiedScripts_.push_back(script->second);
+    });
+    for (const auto& script : scriptFiles_) {
+        WatchScript(script.second);
+    }
+}
+
+void ScriptingEngine::WatchScript(const std::string& filename) {
+    if (!fileWatcher_) return;
+    const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    fileWatcher_->Watch(directory.empty() ? "." : directory.string());
 }
 
 void ScriptingEngine::CheckForChanges() {
     if (!hotReloadEnabled_ || !initialized_) return;
     
-    // Check modification times of loaded scripts
-    // Reload if changed
+    // Changes were reported by the watcher as they settled, nothing to look at here
+    ReloadModifiedScripts();
 }
 
 void ScriptingEngine::ReloadModifiedScripts() {
     if (!hotReloadEnabled_ || !initialized_) return;
     
-    // Reload modified scripts
+    std::vector<std::string> modified;
+    modified.swap(modifiedScripts_);
+    std::sort(modified.begin(), modified.end());
+    modified.erase(std::unique(modified.begin(), modified.end()), modified.end());
+    for (const std::string& filename : modified) {
+        Logger::Info("Reloading Python script: " + filename);
+        ExecuteFile(filename);
+    }
 }
 
 void ScriptingEngine::RegisterEventCallback(const std::string& eventName, std::function<void()> callback) {
+    // The map belongs to whichever thread dispatches
+    if (IsPythonThreadEnabled()) {
+        Submit([this, eventName, callback] { eventCallbacks_[eventName] = callback; });
+        return;
+    }
     eventCallbacks_[eventName] = callback;
 }
 
 void ScriptingEngine::TriggerEvent(const std::string& eventName) {
-    auto it = eventCallbacks_.find(eventName);
-    if (it != eventCallbacks_.end()) {
-        it->second();
-    }
+    pending_.events.push_back(eventName);
 }
 
 void ScriptingEngine::Update(float deltaTime) {
     if (!initialized_) return;
+    NEXUS_PROFILE_SCOPE("Python::Update");
     
     // Check for hot reload
     if (hotReloadEnabled_) {
         CheckForChanges();
     }
+    
+    Batch batch = std::move(pending_);
+    pending_ = Batch{};
+    batch.deltaTime = deltaTime;
+    
+    if (IsPythonThreadEnabled()) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            // A frame still waiting takes this one's events and time, so a script that falls
+            // behind catches up with one longer update instead of a backlog
+            if (!queue_.empty() && !queue_.back().task) {
+                Batch& waiting = queue_.back().frame;
+                waiting.events.insert(waiting.events.end(), std::make_move_iterator(batch.events.begin()),
+                                      std::make_move_iterator(batch.events.end()));
+                waiting.deltaTime += batch.deltaTime;
+            } else {
+                queue_.push_back({ {}, std::move(batch) });
+            }
+        }
+        queueReady_.notify_one();
+    } else {
+        GILLock gil;
+        Dispatch(batch);
+    }
+    FlushLogs();
+}
+
+void ScriptingEngine::Dispatch(const Batch& batch) {
+    NEXUS_PROFILE_SCOPE("Python::Dispatch");
+    ApplyProfiling();
+    
+    for (const std::string& eventName : batch.events) {
+        auto it = eventCallbacks_.find(eventName);
+        if (it == eventCallbacks_.end()) continue;
+        NEXUS_PROFILE_SCOPE(GetEventScopeName(eventName));
+        try {
+            it->second();
+        } catch (const std::exception& e) {
+            Log(LogLevel::Error, "Exception in event callback " + eventName + ": " + std::string(e.what()));
+        }
+    }
+    
+#ifdef NEXUS_PYTHON_ENABLED
+    if (updateFunctionStale_) {
+        Py_CLEAR(updateFunction_);
+        PyObject* update = PyObject_GetAttrString(PyImport_AddModule("__main__"), "update");
+        if (update && PyCallable_Check(update)) {
+            updateFunction_ = update;
+        } else {
+            Py_XDECREF(update);
+            PyErr_Clear();
+        }
+        updateFunctionStale_ = false;
+    }
+    
+    if (updateFunction_) {
+        PyObject* result = PyObject_CallFunction(updateFunction_, "d", static_cast<double>(batch.deltaTime));
+        if (!result) {
+            PyErr_Print();
+            Log(LogLevel::Error, "Error in Python update");
+        }
+        Py_XDECREF(result);
+    }
+#endif
+    
+    RunTasks(batch);
+}
+
+void ScriptingEngine::RunTasks(const Batch& batch) {
+    ++taskFrame_;
+    taskTime_ += batch.deltaTime;
+    
+#ifdef NEXUS_PYTHON_ENABLED
+    if (!taskModule_) return;
+    
+    // Started and cancelled by scripts since the last frame
+    PyObject* started = PyObject_GetAttrString(taskModule_, "_started");
+    PyObject* cancelled = PyObject_GetAttrString(taskModule_, "_cancelled");
+    if (!started || !cancelled || !PyList_Check(started) || !PyList_Check(cancelled)) {
+        Py_XDECREF(started);
+        Py_XDECREF(cancelled);
+        PyErr_Clear();
+        return;
+    }
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(started); ++i) {
+        PyObject* entry = PyList_GET_ITEM(started, i);
+        Task task = { PyLong_AsLongLong(PyTuple_GET_ITEM(entry, 0)), PyTuple_GET_ITEM(entry, 1), Task::Wait::Frame, 0, 0.0, {} };
+        Py_INCREF(task.task);
+        tasks_.push_back(std::move(task));
+    }
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(cancelled); ++i) {
+        const long long id = PyLong_AsLongLong(PyList_GET_ITEM(cancelled, i));
+        auto it = std::find_if(tasks_.begin(), tasks_.end(), [id](const Task& task) { return task.id == id; });
+        if (it == tasks_.end()) continue;
+        // Runs its finally blocks
+        PyObject* result = PyObject_CallMethod(it->task, "close", nullptr);
+        if (!result) PyErr_Print();
+        Py_XDECREF(result);
+        Py_DECREF(it->task);
+        tasks_.erase(it);
+    }
+    PyList_SetSlice(started, 0, PY_SSIZE_T_MAX, nullptr);
+    PyList_SetSlice(cancelled, 0, PY_SSIZE_T_MAX, nullptr);
+    Py_DECREF(started);
+    Py_DECREF(cancelled);
+    
+    for (const std::string& eventName : batch.events) {
+        for (Task& task : tasks_) {
+            if (task.wait == Task::Wait::Event && task.event == eventName) {
+                task.wait = Task::Wait::Frame;
+                task.wakeFrame = taskFrame_;
+            }
+        }
+    }
+    
+    if (tasks_.empty()) return;
+    NEXUS_PROFILE_SCOPE("Python::Tasks");
+    
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double, std::milli>(taskBudgetMs_.load()));
+    
+    // Every task is visited at most once. Those the budget didn't reach stay in front, so they
+    // go first next frame
+    for (size_t visits = tasks_.size(); visits > 0; --visits) {
+        Task task = std::move(tasks_.front());
+        tasks_.pop_front();
+        const bool ready = task.wait == Task::Wait::Frame ? taskFrame_ >= task.wakeFrame
+                         : task.wait == Task::Wait::Time  ? taskTime_ >= task.wakeTime
+                         : false;
+        if (!ready) {
+            tasks_.push_back(std::move(task));
+            continue;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            tasks_.push_front(std::move(task));
+            break;
+        }
+        
+        PyObject* yielded = PyObject_CallMethod(task.task, "send", "O", Py_None);
+        if (!yielded) {
+            if (PyErr_ExceptionMatches(PyExc_StopIteration)) {
+                PyErr_Clear();
+            } else {
+                PyErr_Print();
+                Log(LogLevel::Error, "Python task " + std::to_string(task.id) + " failed");
+            }
+            Py_DECREF(task.task);
+            continue;
+        }
+        
+        // Anything but a Wait means the next frame
+        task.wait = Task::Wait::Frame;
+        task.wakeFrame = taskFrame_ + 1;
+        if (PyObject_IsInstance(yielded, waitType_) == 1) {
+            PyObject* kind = PyObject_GetAttrString(yielded, "kind");
+            PyObject* value = PyObject_GetAttrString(yielded, "value");
+            switch (kind && value ? PyLong_AsLong(kind) : -1) {
+            case 0:
+                task.wakeFrame = taskFrame_ + PyLong_AsUnsignedLongLong(value);
+                break;
+            case 1:
+                task.wait = Task::Wait::Time;
+                task.wakeTime = taskTime_ + PyFloat_AsDouble(value);
+                break;
+            case 2:
+                if (const char* name = PyUnicode_AsUTF8(value)) {
+                    task.wait = Task::Wait::Event;
+                    task.event = name;
+                }
+                break;
+            }
+            Py_XDECREF(kind);
+            Py_XDECREF(value);
+            PyErr_Clear();
+        }
+        Py_DECREF(yielded);
+        tasks_.push_back(std::move(task));
+    }
+#endif
+}
+
+void ScriptingEngine::ApplyProfiling() {
+#ifdef NEXUS_PYTHON_ENABLED
+    // Set per thread state, and the Python thread's is recreated with each acquisition of the GIL
+    if (profiling_) {
+        PyEval_SetProfile(ProfileCallback, profileCapsule_);
+        return;
+    }
+    PyEval_SetProfile(nullptr, nullptr);
+    for (const auto& entry : profileNames_) {
+        Py_DECREF(entry.first);
+    }
+    profileNames_.clear();
+#endif
+}
+
+const char* ScriptingEngine::GetEventScopeName(const std::string& eventName) {
+    const char*& name = eventScopeNames_[eventName];
+    if (!name) name = Profiler::InternName("Python event " + eventName);
+    return name;
+}
+
+#ifdef NEXUS_PYTHON_ENABLED
+int ScriptingEngine::ProfileCallback(PyObject* self, PyFrameObject* frame, int what, PyObject*) {
+    auto* engine = static_cast<ScriptingEngine*>(PyCapsule_GetPointer(self, nullptr));
+    
+    // Returns come for every Python frame, also when unwinding and when a generator yields, so
+    // scopes stay balanced. Ones without a scope (already running when profiling began) are skipped
+    if (what == PyTrace_RETURN) {
+        if (engine->profileDepth_ > 0) {
+            --engine->profileDepth_;
+            Profiler::EndScope();
+        }
+        return 0;
+    }
+    if (what != PyTrace_CALL) return 0;
+    
+    // Named once per code object, which is held so its address isn't reused by another
+    PyCodeObject* code = PyFrame_GetCode(frame);
+    const char*& name = engine->profileNames_[reinterpret_cast<PyObject*>(code)];
+    if (name) {
+        Py_DECREF(code);
+    } else {
+        PyObject* function = PyObject_GetAttrString(reinterpret_cast<PyObject*>(code), "co_qualname");
+        if (!function) {
+            PyErr_Clear();
+            function = PyObject_GetAttrString(reinterpret_cast<PyObject*>(code), "co_name");
+        }
+        PyObject* file = PyObject_GetAttrString(reinterpret_cast<PyObject*>(code), "co_filename");
+        const char* functionName = function ? PyUnicode_AsUTF8(function) : nullptr;
+        const char* fileName = file ? PyUnicode_AsUTF8(file) : nullptr;
+        PyErr_Clear();
+        name = Profiler::InternName(std::string(functionName ? functionName : "?") + " (" +
+                                    (fileName ? fileName : "?") + ":" + std::to_string(code->co_firstlineno) + ")");
+        Py_XDECREF(function);
+        Py_XDECREF(file);
+    }
+    Profiler::BeginScope(name);
+    ++engine->profileDepth_;
+    return 0;
+}
+#endif
+
+void ScriptingEngine::EnablePythonThread(bool enable) {
+    if (enable == IsPythonThreadEnabled()) return;
+    
+    if (enable) {
+        if (!initialized_) return;
+        stopThread_ = false;
+        pythonThread_ = std::thread(&ScriptingEngine::PythonThreadMain, this);
+        Logger::Info("Python running on its own thread");
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopThread_ = true;
+    }
+    queueReady_.notify_one();
+    pythonThread_.join();
+    FlushLogs();
+}
+
+void ScriptingEngine::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        queue_.push_back({ std::move(task), {} });
+    }
+    queueReady_.notify_one();
+}
+
+void ScriptingEngine::PythonThreadMain() {
+    NEXUS_MEMORY_SCOPE(MemoryTag::Scripting);
+    for (;;) {
+        std::deque<Command> commands;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueReady_.wait(lock, [this] { return stopThread_ || !queue_.empty(); });
+            // Stopping drains the queue first
+            if (queue_.empty()) return;
+            commands.swap(queue_);
+        }
+        
+        // Everything queued since the last wake under one acquisition of the GIL
+        GILLock gil;
+        for (Command& command : commands) {
+            if (command.task) command.task();
+            else Dispatch(command.frame);
+        }
+    }
+}
+
+void ScriptingEngine::Log(LogLevel level, const std::string& message) {
+    std::lock_guard<std::mutex> lock(logMutex_);
+    logs_.emplace_back(level, message);
+}
+
+void ScriptingEngine::FlushLogs() {
+    std::vector<std::pair<LogLevel, std::string>> logs;
+    {
+        std::lock_guard<std::mutex> lock(logMutex_);
+        logs.swap(logs_);
+    }
+    for (const auto& entry : logs) {
+        switch (entry.first) {
+        case LogLevel::Warning: Logger::Warning(entry.second); break;
+        case LogLevel::Error: Logger::Error(entry.second); break;
+        default: Logger::Info(entry.second); break;
+        }
+    }
 }
 
 void ScriptingEngine::InitializePythonBindings() {
     // Python bindings would be initialized here
     // This would typically involve importing the nexus_engine module
-    ExecuteString("import sys");
-    ExecuteString("print('Python version:', sys.version)");
+    RunString("import sys");
+    RunString("print('Python version:', sys.version)");
+    
+#ifdef NEXUS_PYTHON_ENABLED
+    // Registered in sys.modules, so scripts import it like any other
+    PyObject* module = PyImport_AddModule("nexus_tasks");
+    PyObject* globals = module ? PyModule_GetDict(module) : nullptr;
+    PyObject* result = nullptr;
+    if (globals && PyDict_SetItemString(globals, "__builtins__", PyEval_GetBuiltins()) == 0) {
+        result = PyRun_String(TASK_MODULE_SOURCE, Py_file_input, globals, globals);
+    }
+    if (result) {
+        Py_DECREF(result);
+        Py_INCREF(module);
+        taskModule_ = module;
+        waitType_ = PyObject_GetAttrString(module, "Wait");
+    } else {
+        PyErr_Print();
+        Log(LogLevel::Warning, "Python tasks not available");
+    }
+
+    PyObject* metricsModule = PyImport_AddModule("nexus_metrics");
+    PyObject* self = metricsModule ? PyCapsule_New(this, nullptr, nullptr) : nullptr;
+    for (PyMethodDef* method = METRICS_METHODS; self && method->ml_name; ++method) {
+        PyObject* function = PyCFunction_NewEx(method, self, nullptr);
+        if (!function || PyModule_AddObject(metricsModule, method->ml_name, function) < 0) {
+            Py_XDECREF(function);
+            PyErr_Print();
+            Log(LogLevel::Warning, "Python frame metrics not available");
+            break;
+        }
+    }
+    Py_XDECREF(self);
+#endif
 }
 
 void ScriptingEngine::AddToPath(const std::string& path) {
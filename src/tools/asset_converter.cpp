@@ -1,13 +1,421 @@
 #include "AssetConverter.h"
+#include "HlodBuilder.h"
+#include "JobSystem.h"
+#include "Light.h"
+#include "LightmapBaker.h"
 #include "Logger.h"
+#include "LuaScriptingEngine.h"
+#include "MeshImporter.h"
+#include "PakArchive.h"
+#include "ResourceManager.h"
+#include "SoundBank.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <filesystem>
+#include <set>
+
+// One of the conversion options at argv[i], moving i past its value; false if it isn't one
+static bool ParseConversionOption(int argc, char* argv[], int& i, Nexus::ConversionSettings& settings) {
+    std::string arg = argv[i];
+    if (arg == "--quality" && i + 1 < argc) {
+        std::string quality = argv[++i];
+        if (quality == "high") settings.quality = Nexus::ConversionQuality::High;
+        else if (quality == "medium") settings.quality = Nexus::ConversionQuality::Medium;
+        else if (quality == "low") settings.quality = Nexus::ConversionQuality::Low;
+    } else if (arg == "--compress") {
+        settings.compress = true;
+    } else if (arg == "--optimize") {
+        settings.optimize = true;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static Nexus::ConversionSettings GetDefaultConversionSettings() {
+    Nexus::ConversionSettings settings;
+    settings.quality = Nexus::ConversionQuality::High;
+    settings.compress = false;
+    settings.optimize = true;
+    return settings;
+}
+
+// Converts every supported file under the input folder to the same path under the output folder.
+// Files convert independently, one job each across every core; --jobs caps the threads
+static int ConvertBatch(int argc, char* argv[]) {
+    namespace fs = std::filesystem;
+    const fs::path inputRoot = argv[2];
+    const fs::path outputRoot = argv[3];
+    Nexus::ConversionSettings settings = GetDefaultConversionSettings();
+    unsigned int threads = 0;
+    for (int i = 4; i < argc; i++) {
+        if (std::string(argv[i]) == "--jobs" && i + 1 < argc) {
+            threads = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        } else if (!ParseConversionOption(argc, argv, i, settings)) {
+            Nexus::Logger::Warning("Unknown option: " + std::string(argv[i]));
+        }
+    }
+
+    std::vector<fs::path> inputs;
+    std::vector<Nexus::AssetType> types;
+    {
+        Nexus::AssetConverter converter;
+        std::error_code error;
+        for (const auto& entry : fs::recursive_directory_iterator(inputRoot, error)) {
+            if (!entry.is_regular_file()) continue;
+            const Nexus::AssetType type = converter.DetectAssetType(entry.path().string());
+            if (type == Nexus::AssetType::Unknown) continue;
+            inputs.push_back(entry.path());
+            types.push_back(type);
+        }
+    }
+    if (inputs.empty()) {
+        Nexus::Logger::Error("No supported files under " + inputRoot.string());
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    Nexus::JobSystem jobs;
+    if (threads != 1) jobs.Initialize(threads > 1 ? threads - 1 : 0);
+    std::atomic<int> failed{0};
+    jobs.ParallelFor(inputs.size(), 1, [&](size_t begin, size_t end) {
+        // A converter per job: it keeps the stats of its last conversion
+        Nexus::AssetConverter converter;
+        for (size_t i = begin; i < end; i++) {
+            const fs::path output = outputRoot / inputs[i].lexically_relative(inputRoot);
+            std::error_code error;
+            fs::create_directories(output.parent_path(), error);
+            try {
+                if (!converter.ConvertAsset(inputs[i].string(), output.string(), types[i], settings)) {
+                    Nexus::Logger::Error("Failed to convert: " + inputs[i].string());
+                    failed++;
+                }
+            } catch (const std::exception& e) {
+                Nexus::Logger::Error("Exception converting " + inputs[i].string() + ": " + e.what());
+                failed++;
+            }
+        }
+    });
+    jobs.Shutdown();
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (failed > 0) {
+        std::cout << "❌ Failed to convert " << failed << " of " << inputs.size() << " assets" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ Assets converted: " << inputs.size() << " in " << seconds << " s" << std::endl;
+    std::cout << "📁 Output: " << outputRoot.string() << std::endl;
+    return 0;
+}
+
+// Packs every .wav and .ogg under the inputs (files or folders, root if none) into one bank
+static int BuildSoundBank(int argc, char* argv[]) {
+    std::string outputFile = argv[2];
+    std::string root = argv[3];
+    std::vector<std::string> inputs;
+    auto add = [&inputs](const std::filesystem::path& path) {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".wav" || ext == ".ogg") inputs.push_back(path.string());
+    };
+    for (int i = argc > 4 ? 4 : 3; i < argc; i++) {
+        std::error_code error;
+        if (std::filesystem::is_directory(argv[i], error)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(argv[i], error)) {
+                if (entry.is_regular_file()) add(entry.path());
+            }
+        } else {
+            add(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        Nexus::Logger::Error("No .wav or .ogg files to put in the sound bank");
+        return 1;
+    }
+
+    if (!Nexus::SoundBank::Write(outputFile, inputs, root)) {
+        std::cout << "❌ Failed to build sound bank" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ Sound bank built: " << inputs.size() << " clips" << std::endl;
+    std::cout << "📁 Output: " << outputFile << std::endl;
+    return 0;
+}
+
+// Puts the files a recorded load order asks for first, in that order, the rest after as they
+// were. The engine looks a resource up under each resource path and the pak's root may be one,
+// so a pak name matches a recorded file when either ends with the other
+static void SortByLoadOrder(std::vector<std::string>& inputs, const std::string& root,
+                            const std::vector<Nexus::ResourceManager::LoadOrderEntry>& order) {
+    namespace fs = std::filesystem;
+    auto normalize = [](std::string path) {
+        std::transform(path.begin(), path.end(), path.begin(), [](unsigned char c) {
+            return c == '\\' ? '/' : static_cast<char>(std::tolower(c));
+        });
+        while (path.compare(0, 2, "./") == 0) path.erase(0, 2);
+        return path;
+    };
+    auto endsWith = [](const std::string& path, const std::string& tail) {
+        return path.size() >= tail.size() && path.compare(path.size() - tail.size(), tail.size(), tail) == 0 &&
+               (path.size() == tail.size() || path[path.size() - tail.size() - 1] == '/');
+    };
+
+    std::error_code error;
+    const fs::path rootPath = fs::absolute(root.empty() ? "." : root, error);
+    std::vector<std::string> names;
+    for (const std::string& input : inputs) {
+        fs::path relative = fs::absolute(input, error).lexically_relative(rootPath);
+        if (relative.empty() || *relative.begin() == "..") relative = fs::path(input).filename();
+        names.push_back(normalize(relative.generic_string()));
+    }
+
+    std::vector<size_t> rank(inputs.size(), order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        std::string file = order[i].filename;
+        if (order[i].type == Nexus::ResourceManager::ResourceType::Mesh) file = Nexus::MeshImporter::GetCachePath(file);
+        file = normalize(file);
+        for (size_t input = 0; input < inputs.size(); input++) {
+            if (rank[input] == order.size() && (endsWith(names[input], file) || endsWith(file, names[input]))) rank[input] = i;
+        }
+    }
+
+    std::vector<size_t> sorted(inputs.size());
+    for (size_t i = 0; i < sorted.size(); i++) sorted[i] = i;
+    std::stable_sort(sorted.begin(), sorted.end(), [&rank](size_t a, size_t b) { return rank[a] < rank[b]; });
+    std::vector<std::string> ordered;
+    ordered.reserve(inputs.size());
+    for (size_t i : sorted) ordered.push_back(std::move(inputs[i]));
+    inputs.swap(ordered);
+
+    const size_t placed = static_cast<size_t>(std::count_if(rank.begin(), rank.end(),
+                                                            [&order](size_t r) { return r < order.size(); }));
+    Nexus::Logger::Info("Laid out " + std::to_string(placed) + " of " + std::to_string(inputs.size()) +
+                        " files in load order");
+}
+
+// Packs every file under the inputs (files or folders, root if none) into one pak. Mesh sources
+// go in baked, as the .nmesh the engine looks for; --store leaves every entry uncompressed and
+// --order puts the files of a recorded load order first, so they read sequentially
+static int BuildPak(int argc, char* argv[]) {
+    namespace fs = std::filesystem;
+    std::string outputFile = argv[2];
+    std::string root = argv[3];
+    bool compress = true;
+    std::string orderFile;
+    std::error_code error;
+    const fs::path output = fs::absolute(outputFile, error).lexically_normal();
+    std::vector<std::string> inputs;
+    std::set<fs::path> added;
+    auto add = [&](const fs::path& path) {
+        std::string file = path.string();
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".obj" || ext == ".gltf" || ext == ".glb" || ext == ".fbx") {
+            if (Nexus::MeshImporter::BuildCache(file)) {
+                file = Nexus::MeshImporter::GetCachePath(file);
+            } else {
+                Nexus::Logger::Warning("Could not bake mesh, packing the source: " + file);
+            }
+        }
+        // A folder also lists the caches baked beside their sources, and maybe the pak itself
+        const fs::path absolute = fs::absolute(file, error).lexically_normal();
+        if (absolute != output && added.insert(absolute).second) inputs.push_back(file);
+    };
+
+    std::vector<std::string> sources;
+    for (int i = 4; i < argc; i++) {
+        if (std::string(argv[i]) == "--store") {
+            compress = false;
+        } else if (std::string(argv[i]) == "--order" && i + 1 < argc) {
+            orderFile = argv[++i];
+        } else {
+            sources.push_back(argv[i]);
+        }
+    }
+    if (sources.empty()) sources.push_back(root);
+    for (const std::string& source : sources) {
+        if (fs::is_directory(source, error)) {
+            for (const auto& entry : fs::recursive_directory_iterator(source, error)) {
+                if (entry.is_regular_file()) add(entry.path());
+            }
+        } else {
+            add(source);
+        }
+    }
+    if (inputs.empty()) {
+        Nexus::Logger::Error("No files to put in the pak");
+        return 1;
+    }
+    if (!orderFile.empty()) {
+        std::vector<Nexus::ResourceManager::LoadOrderEntry> order;
+        if (Nexus::ResourceManager::ReadLoadOrder(orderFile, order)) {
+            SortByLoadOrder(inputs, root, order);
+        } else {
+            Nexus::Logger::Warning("Not a load order, packing unordered: " + orderFile);
+        }
+    }
+
+    if (!Nexus::PakArchive::Write(outputFile, inputs, root, compress)) {
+        std::cout << "❌ Failed to build pak" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ Pak built: " << inputs.size() << " files" << std::endl;
+    std::cout << "📁 Output: " << outputFile << std::endl;
+    return 0;
+}
+
+// Compiles every .lua under the inputs (files or folders) to stripped bytecode beside it
+static int CompileLuaScripts(int argc, char* argv[]) {
+    std::vector<std::string> scripts;
+    for (int i = 2; i < argc; i++) {
+        std::error_code error;
+        if (std::filesystem::is_directory(argv[i], error)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(argv[i], error)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".lua") scripts.push_back(entry.path().string());
+            }
+        } else {
+            scripts.push_back(argv[i]);
+        }
+    }
+
+    int failed = 0;
+    for (const std::string& script : scripts) {
+        if (!Nexus::LuaScriptingEngine::CompileFile(script, Nexus::LuaScriptingEngine::GetCompiledPath(script))) failed++;
+    }
+    if (failed > 0) {
+        std::cout << "❌ Failed to compile " << failed << " of " << scripts.size() << " Lua scripts" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ Lua scripts compiled: " << scripts.size() << std::endl;
+    return 0;
+}
+
+// Bakes HLOD proxies and impostors for a placement list; see HlodBuilder for the formats
+static int BuildHlod(int argc, char* argv[]) {
+    Nexus::HlodBuilder::Settings settings;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        float value = static_cast<float>(std::atof(argv[i + 1]));
+        if (option == "--cell-size") {
+            settings.cellSize = value;
+        } else if (option == "--proxy-distance") {
+            settings.proxyDistance = value;
+        } else if (option == "--triangle-ratio") {
+            settings.triangleRatio = value;
+        } else if (option == "--atlas-size") {
+            settings.atlasSize = static_cast<int>(value);
+        } else if (option == "--impostor-radius") {
+            settings.impostorRadius = value;
+        } else {
+            Nexus::Logger::Warning("Unknown HLOD option: " + option);
+        }
+    }
+
+    std::vector<Nexus::HlodBuilder::Placement> placements;
+    if (!Nexus::HlodBuilder::ReadPlacements(argv[2], placements)) return 1;
+    Nexus::HlodBuilder::Stats stats;
+    if (!Nexus::HlodBuilder::Build(placements, argv[3], settings, &stats)) {
+        std::cout << "❌ Failed to build HLOD" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ HLOD built: " << stats.cells << " cell proxies, " << stats.impostors << " impostors" << std::endl;
+    std::cout << "📊 Triangles: " << stats.sourceTriangles << " -> " << stats.proxyTriangles << std::endl;
+    std::cout << "📁 Output: " << argv[3] << std::endl;
+    return 0;
+}
+
+// Bakes lightmaps for the placements and lights of a placement list; see LightmapBaker
+static int BakeLightmaps(int argc, char* argv[]) {
+    Nexus::LightmapBaker::Settings settings;
+    unsigned int threads = 0;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        float value = static_cast<float>(std::atof(argv[i + 1]));
+        if (option == "--density") {
+            settings.texelsPerUnit = value;
+        } else if (option == "--atlas-size") {
+            settings.atlasSize = static_cast<int>(value);
+        } else if (option == "--samples") {
+            settings.samples = static_cast<unsigned int>(std::max(value, 1.0f));
+        } else if (option == "--bounces") {
+            settings.bounces = static_cast<unsigned int>(std::max(value, 1.0f));
+        } else if (option == "--albedo") {
+            settings.albedo = value;
+        } else if (option == "--indirect-only") {
+            settings.includeDirect = value == 0.0f;
+        } else if (option == "--jobs") {
+            threads = static_cast<unsigned int>(std::max(value, 0.0f));
+        } else {
+            Nexus::Logger::Warning("Unknown lightmap option: " + option);
+        }
+    }
+
+    std::vector<Nexus::HlodBuilder::Placement> placements;
+    std::vector<Nexus::Light> lights;
+    if (!Nexus::HlodBuilder::ReadPlacements(argv[2], placements) ||
+        !Nexus::LightmapBaker::ReadLights(argv[2], lights)) {
+        return 1;
+    }
+    std::vector<const Nexus::Light*> lightPointers;
+    for (const Nexus::Light& light : lights) lightPointers.push_back(&light);
+
+    Nexus::JobSystem jobs;
+    if (threads != 1) jobs.Initialize(threads > 1 ? threads - 1 : 0);
+    Nexus::LightmapBaker::Stats stats;
+    const bool baked = Nexus::LightmapBaker::Bake(placements, lightPointers, argv[3], settings, &jobs, &stats,
+        [](UINT pass, UINT passes) {
+            std::cout << "\r🔆 Pass " << pass << "/" << passes << std::flush;
+            return true;
+        });
+    std::cout << std::endl;
+    jobs.Shutdown();
+    if (!baked) {
+        std::cout << "❌ Failed to bake lightmaps" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ Lightmaps baked: " << stats.instances << " placements, " << stats.charts << " charts at "
+              << stats.texelsPerUnit << " texels per unit" << std::endl;
+    std::cout << "📊 Texels: " << stats.texels << ", paths: " << stats.paths << std::endl;
+    std::cout << "📁 Output: " << argv[3] << std::endl;
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
     std::cout << "=== NEXUS ENGINE - UNIVERSAL ASSET CONVERTER ===" << std::endl;
     
+    if (argc >= 4 && std::string(argv[1]) == "--sound-bank") {
+        return BuildSoundBank(argc, argv);
+    }
+    if (argc >= 4 && std::string(argv[1]) == "--pak") {
+        return BuildPak(argc, argv);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--compile-lua") {
+        return CompileLuaScripts(argc, argv);
+    }
+    if (argc >= 4 && std::string(argv[1]) == "--batch") {
+        return ConvertBatch(argc, argv);
+    }
+    if (argc >= 4 && std::string(argv[1]) == "--hlod") {
+        return BuildHlod(argc, argv);
+    }
+    if (argc >= 4 && std::string(argv[1]) == "--lightmap") {
+        return BakeLightmaps(argc, argv);
+    }
+    
     if (argc < 3) {
         std::cout << "Usage: NexusAssetConverter <input_file> <output_file> [options]" << std::endl;
+        std::cout << "       NexusAssetConverter --sound-bank <output_bank> <root> [files or folders...]" << std::endl;
+        std::cout << "       NexusAssetConverter --pak <output_pak> <root> [files or folders...] [--store] [--order <load_order>]" << std::endl;
+        std::cout << "       NexusAssetConverter --compile-lua <files or folders...>" << std::endl;
+        std::cout << "       NexusAssetConverter --batch <input_folder> <output_folder> [options] [--jobs <count>]" << std::endl;
+        std::cout << "       NexusAssetConverter --hlod <placement_list> <output_folder> [--cell-size <units>] [--proxy-distance <units>]" << std::endl;
+        std::cout << "                           [--triangle-ratio <0-1>] [--atlas-size <texels>] [--impostor-radius <units>]" << std::endl;
+        std::cout << "       NexusAssetConverter --lightmap <placement_list> <output_folder> [--density <texels/unit>] [--atlas-size <texels>]" << std::endl;
+        std::cout << "                           [--samples <count>] [--bounces <count>] [--albedo <0-1>] [--indirect-only 1] [--jobs <count>]" << std::endl;
         std::cout << std::endl;
         std::cout << "Supported formats:" << std::endl;
         std::cout << "  Models: .fbx, .obj, .dae, .3ds, .blend, .gltf, .uasset" << std::endl;
@@ -26,23 +434,9 @@ int main(int argc, char* argv[]) {
     std::string outputFile = argv[2];
     
     // Parse options
-    Nexus::ConversionSettings settings;
-    settings.quality = Nexus::ConversionQuality::High;
-    settings.compress = false;
-    settings.optimize = true;
-    
+    Nexus::ConversionSettings settings = GetDefaultConversionSettings();
     for (int i = 3; i < argc; i++) {
-        std::string arg = argv[i];
-        if (arg == "--quality" && i + 1 < argc) {
-            std::string quality = argv[++i];
-            if (quality == "high") settings.quality = Nexus::ConversionQuality::High;
-            else if (quality == "medium") settings.quality = Nexus::ConversionQuality::Medium;
-            else if (quality == "low") settings.quality = Nexus::ConversionQuality::Low;
-        } else if (arg == "--compress") {
-            settings.compress = true;
-        } else if (arg == "--optimize") {
-            settings.optimize = true;
-        }
+        ParseConversionOption(argc, argv, i, settings);
     }
     
     Nexus::Logger::Info("Starting asset conversion...");
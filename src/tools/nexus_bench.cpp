@@ -0,0 +1,565 @@
+#include "EngineConfig.h"
+#include "AISystem.h"
+#include "AnimationSystem.h"
+#include "AudioRenderer.h"
+#include "AudioSystem.h"
+#include "Benchmark.h"
+#include "BlockCompressor.h"
+#include "BlockDecompressor.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "LuaScriptingEngine.h"
+#include "MipGenerator.h"
+#include "ParticleSystem.h"
+#include "PhysicsEngine.h"
+#include "ScriptingEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Encodes the PNG the decode case reads and decodes it the way Texture's import does
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_NO_STDIO
+#include <stb/stb_image.h>
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBI_WRITE_NO_STDIO
+#include <stb/stb_image_write.h>
+
+using namespace Nexus;
+using namespace DirectX;
+
+namespace {
+
+// Every case builds its input from this seed, so two runs time the same work
+constexpr uint32_t SEED = 1234;
+constexpr float FRAME_TIME = 1.0f / 60.0f;
+
+// Bodies in 8-high stacks, so contacts start on the first step and the piles keep shifting
+void AddPhysicsBenchmarks(Benchmark& bench, JobSystem* jobs) {
+    constexpr int STEPS = 10;
+    constexpr int STACK_HEIGHT = 8;
+    for (int bodyCount : { 256, 1024, 4096 }) {
+        auto physics = std::make_shared<std::unique_ptr<PhysicsEngine>>();
+        auto setup = [physics, jobs, bodyCount]() {
+            physics->reset();
+            *physics = std::make_unique<PhysicsEngine>();
+            PhysicsEngine& engine = **physics;
+            engine.Initialize();
+            engine.SetJobSystem(jobs);
+            engine.SetGroundPlane(true, 0.0f);
+
+            const int stacks = (bodyCount + STACK_HEIGHT - 1) / STACK_HEIGHT;
+            const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(stacks))));
+            for (int i = 0; i < bodyCount; ++i) {
+                const int stack = i / STACK_HEIGHT;
+                const int level = i % STACK_HEIGHT;
+                // Every fourth body a sphere, offset a little so the stacks topple
+                const bool sphere = i % 4 == 3;
+                const XMFLOAT3 position((stack % side) * 1.5f + (sphere ? 0.1f : 0.0f), 0.5f + level * 1.02f,
+                                        (stack / side) * 1.5f);
+                engine.CreateRigidBody(sphere ? CollisionShape::CreateSphere(0.5f)
+                                              : CollisionShape::CreateBox(XMFLOAT3(1.0f, 1.0f, 1.0f)),
+                                       PhysicsTransform(position, XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f)), 1.0f);
+            }
+        };
+        auto run = [physics]() {
+            for (int step = 0; step < STEPS; ++step) {
+                (*physics)->StepSimulation(FRAME_TIME);
+            }
+        };
+        bench.Add("physics/step_" + std::to_string(bodyCount), run, static_cast<uint64_t>(bodyCount) * STEPS, setup);
+    }
+}
+
+// Continuous effects run for two seconds first, so the pools are full and steady
+void AddParticleBenchmarks(Benchmark& bench, JobSystem* jobs) {
+    for (int effectCount : { 16, 64 }) {
+        auto particles = std::make_shared<ParticleSystem>();
+        particles->Initialize(nullptr, nullptr);
+        particles->SetJobSystem(jobs);
+        particles->EnableMultithreading(jobs != nullptr);
+        particles->SetMaxParticles(effectCount * 2000);
+        for (int i = 0; i < effectCount; ++i) {
+            const std::string name = "effect" + std::to_string(i);
+            const XMFLOAT3 position((i % 8) * 4.0f, 0.0f, (i / 8) * 4.0f);
+            switch (i % 4) {
+            case 0: particles->CreateFireEffect(name, position); break;
+            case 1: particles->CreateSmokeEffect(name, position); break;
+            case 2: particles->CreateSparkEffect(name, position); break;
+            default: particles->CreateMagicEffect(name, position); break;
+            }
+        }
+        for (int frame = 0; frame < 120; ++frame) {
+            particles->Update(FRAME_TIME);
+        }
+
+        const uint64_t count = std::max(particles->GetTotalParticleCount(), 1);
+        bench.Add("particles/update_" + std::to_string(effectCount) + "_effects",
+                  [particles]() { particles->Update(FRAME_TIME); }, count);
+    }
+}
+
+// A looping clip swinging every bone of a binary-tree skeleton, phase shifted per clip
+std::shared_ptr<AnimationSystem::AnimationClip> CreateBenchmarkClip(AnimationSystem& animation, const std::string& name,
+                                                                    int boneCount, float phase) {
+    constexpr int KEY_COUNT = 31;
+    auto clip = animation.CreateAnimationClip(name);
+    clip->isLooping = true;
+    for (int bone = 0; bone < boneCount; ++bone) {
+        AnimationSystem::AnimationTrack track;
+        track.boneIndex = bone;
+        track.interpolationType = AnimationSystem::InterpolationType::Linear;
+        for (int k = 0; k < KEY_COUNT; ++k) {
+            AnimationSystem::Keyframe key = {};
+            key.time = k * clip->duration / (KEY_COUNT - 1);
+            const float angle = 0.3f * std::sin(key.time * XM_2PI + phase + bone * 0.5f);
+            key.position = XMFLOAT3(0.0f, bone > 0 ? 0.1f : 0.0f, 0.0f);
+            XMStoreFloat4(&key.rotation, XMQuaternionRotationRollPitchYaw(angle, angle * 0.5f, 0.0f));
+            key.scale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+            track.keyframes.push_back(key);
+        }
+        clip->tracks.push_back(std::move(track));
+    }
+    return clip;
+}
+
+// Characters blending two clips at 0.6 and 0.4, from keyframes and from compressed clips
+void AddAnimationBenchmarks(Benchmark& bench, JobSystem* jobs) {
+    constexpr int BONE_COUNT = 64;
+    for (bool compressed : { false, true }) {
+        for (int characterCount : { 16, 128 }) {
+            auto animation = std::make_shared<AnimationSystem>();
+            animation->Initialize(nullptr, nullptr);
+            animation->SetJobSystem(jobs);
+            animation->EnableMultithreading(jobs != nullptr);
+
+            auto walk = CreateBenchmarkClip(*animation, "walk", BONE_COUNT, 0.0f);
+            auto run = CreateBenchmarkClip(*animation, "run", BONE_COUNT, 1.0f);
+            if (compressed) {
+                animation->CompressAnimationClip("walk");
+                animation->CompressAnimationClip("run");
+            }
+
+            for (int c = 0; c < characterCount; ++c) {
+                const std::string name = "character" + std::to_string(c);
+                auto skeleton = animation->CreateSkeleton(name);
+                for (int b = 0; b < BONE_COUNT; ++b) {
+                    AnimationSystem::Bone bone = {};
+                    bone.name = "bone" + std::to_string(b);
+                    bone.parentIndex = b > 0 ? (b - 1) / 2 : -1;
+                    XMStoreFloat4x4(&bone.bindPose, XMMatrixTranslation(0.0f, b > 0 ? 0.1f : 0.0f, 0.0f));
+                    XMStoreFloat4x4(&bone.inverseBindPose, XMMatrixIdentity());
+                    skeleton->boneNameToIndex[bone.name] = b;
+                    skeleton->bones.push_back(bone);
+                }
+                skeleton->BuildHierarchy();
+                animation->CreateCharacter(name, skeleton);
+
+                // Instances start apart in time so characters don't sample the same keys
+                const float weights[] = { 0.6f, 0.4f };
+                const std::shared_ptr<AnimationSystem::AnimationClip> clips[] = { walk, run };
+                for (int i = 0; i < 2; ++i) {
+                    const std::string instanceName = name + (i == 0 ? "_walk" : "_run");
+                    auto instance = animation->CreateAnimationInstance(instanceName, clips[i]);
+                    instance->weight = weights[i];
+                    instance->currentTime = std::fmod(c * 0.137f, clips[i]->duration);
+                    instance->Play();
+                    animation->AddCharacterAnimation(name, instanceName);
+                }
+            }
+
+            bench.Add("animation/" + std::string(compressed ? "blend_compressed_" : "blend_") +
+                          std::to_string(characterCount),
+                      [animation]() { animation->Update(FRAME_TIME); }, static_cast<uint64_t>(characterCount));
+        }
+    }
+}
+
+// Every entity near the viewer and in range of others, so each thinks and perceives every frame
+void AddAIBenchmarks(Benchmark& bench, JobSystem* jobs) {
+    for (int entityCount : { 64, 256 }) {
+        auto ai = std::make_shared<AIManager>();
+        ai->Initialize();
+        ai->SetJobSystem(jobs);
+        ai->SetMaxAIEntities(entityCount);
+        ai->SetLODDistances(10000.0f, 20000.0f);
+        ai->SetTimeBudget(1000.0f);
+
+        std::mt19937 random(SEED);
+        std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+        for (int i = 0; i < entityCount; ++i) {
+            auto entity = ai->CreateAIEntity(static_cast<AIPersonality>(i % 7));
+            if (!entity) break;
+            entity->Initialize(AIVector3(coordinate(random), 0.0f, coordinate(random)));
+        }
+        ai->SetViewerPosition(AIVector3(0.0f, 0.0f, 0.0f));
+        ai->NotifyPlayerPosition(AIVector3(0.0f, 0.0f, 0.0f));
+        ai->NotifyGunshot(AIVector3(10.0f, 0.0f, 10.0f), 1.0f);
+        ai->Update(FRAME_TIME);
+
+        bench.Add("ai/update_" + std::to_string(entityCount), [ai]() { ai->Update(FRAME_TIME); },
+                  static_cast<uint64_t>(entityCount));
+    }
+}
+
+// Voices of a 44.1kHz clip resampled to 48kHz, half of them spatial, into four buses each running
+// EQ, compressor and reverb
+struct AudioBenchmark {
+    AudioRenderer renderer;
+    std::vector<int16_t> clip;
+    std::vector<float> output;
+};
+
+void AddAudioBenchmarks(Benchmark& bench, JobSystem* jobs) {
+    constexpr int SAMPLE_RATE = 48000;
+    constexpr int CLIP_RATE = 44100;
+    constexpr uint32_t FRAMES = 1024;
+    constexpr uint32_t BUS_COUNT = 4;
+
+    for (uint32_t voiceCount : { 32u, 128u }) {
+        auto audio = std::make_shared<AudioBenchmark>();
+        AudioRenderer& renderer = audio->renderer;
+        renderer.Initialize(SAMPLE_RATE, 2);
+        renderer.SetJobSystem(jobs);
+
+        // Two seconds of stereo tone and noise
+        std::mt19937 random(SEED);
+        std::uniform_real_distribution<float> noise(-0.1f, 0.1f);
+        audio->clip.resize(CLIP_RATE * 2 * 2);
+        for (size_t i = 0; i < audio->clip.size(); ++i) {
+            const float t = static_cast<float>(i / 2) / CLIP_RATE;
+            const float sample = 0.4f * std::sin(XM_2PI * 220.0f * t) + noise(random);
+            audio->clip[i] = static_cast<int16_t>(sample * 32767.0f);
+        }
+
+        for (uint32_t bus = 1; bus <= BUS_COUNT; ++bus) {
+            AudioCommand command = {};
+            command.type = AudioCommandType::SetBus;
+            command.voice = bus;
+            command.values[0] = 1.0f;
+            command.values[1] = static_cast<float>(AudioRenderer::MASTER_BUS);
+            command.values[2] = 1.0f;
+            renderer.Submit(command);
+
+            auto chain = std::make_unique<AudioBusChain>();
+            std::shared_ptr<AudioSystem::AudioEffect> effects[] = {
+                std::make_shared<AudioSystem::EQEffect>(), std::make_shared<AudioSystem::CompressorEffect>(),
+                std::make_shared<AudioSystem::ReverbEffect>()
+            };
+            const AudioSystem::AudioEffectType types[] = {
+                AudioSystem::AudioEffectType::EQ, AudioSystem::AudioEffectType::Compression,
+                AudioSystem::AudioEffectType::Reverb
+            };
+            for (int i = 0; i < 3; ++i) {
+                // As AudioSystem::CreateEffect() sets them up
+                effects[i]->type = types[i];
+                effects[i]->isEnabled = true;
+                effects[i]->intensity = 1.0f;
+                effects[i]->wetDryMix = 1.0f;
+                effects[i]->sampleRate = SAMPLE_RATE;
+                effects[i]->xaudioEffect = nullptr;
+                chain->effects.push_back(effects[i]);
+            }
+            renderer.SubmitBusChain(bus, std::move(chain));
+        }
+
+        AudioClip clip = {};
+        clip.data = reinterpret_cast<const uint8_t*>(audio->clip.data());
+        clip.frameCount = CLIP_RATE * 2;
+        clip.sampleRate = CLIP_RATE;
+        clip.channels = 2;
+        clip.bitsPerSample = 16;
+        for (uint32_t voice = 0; voice < voiceCount; ++voice) {
+            AudioCommand play = {};
+            play.type = AudioCommandType::Play;
+            play.voice = voice;
+            play.clip = clip;
+            renderer.Submit(play);
+
+            auto setParam = [&renderer, voice](AudioVoiceParam param, float value) {
+                AudioCommand command = {};
+                command.type = AudioCommandType::SetParam;
+                command.param = param;
+                command.voice = voice;
+                command.values[0] = value;
+                renderer.Submit(command);
+            };
+            setParam(AudioVoiceParam::Looping, 1.0f);
+            setParam(AudioVoiceParam::Volume, 0.1f);
+            setParam(AudioVoiceParam::Bus, static_cast<float>(1 + voice % BUS_COUNT));
+            setParam(AudioVoiceParam::Pitch, 0.9f + 0.2f * (voice % 5) / 4.0f);
+            if (voice % 2) {
+                setParam(AudioVoiceParam::Spatial, 1.0f);
+                AudioCommand position = {};
+                position.type = AudioCommandType::SetPosition;
+                position.voice = voice;
+                position.values[0] = std::cos(voice * 0.7f) * (2.0f + voice % 10);
+                position.values[2] = std::sin(voice * 0.7f) * (2.0f + voice % 10);
+                renderer.Submit(position);
+            }
+        }
+        renderer.Flush();
+        audio->output.resize(FRAMES * 2);
+
+        bench.Add("audio/mix_" + std::to_string(voiceCount) + "_voices",
+                  [audio]() { audio->renderer.Render(audio->output.data(), FRAMES); }, FRAMES);
+    }
+}
+
+// Soft gradients with noise, which compress about as well as real albedo textures
+std::vector<uint8_t> CreateBenchmarkImage(int width, int height) {
+    std::mt19937 random(SEED);
+    std::uniform_int_distribution<int> noise(-12, 12);
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* pixel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            const float u = static_cast<float>(x) / width;
+            const float v = static_cast<float>(y) / height;
+            const int base[3] = {
+                static_cast<int>(128.0f + 100.0f * std::sin(u * 12.0f)),
+                static_cast<int>(128.0f + 100.0f * std::cos(v * 9.0f)),
+                static_cast<int>(255.0f * u * v)
+            };
+            for (int c = 0; c < 3; ++c) {
+                pixel[c] = static_cast<uint8_t>(std::clamp(base[c] + noise(random), 0, 255));
+            }
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+void AppendBytes(void* context, void* data, int size) {
+    auto* output = static_cast<std::vector<uint8_t>*>(context);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    output->insert(output->end(), bytes, bytes + size);
+}
+
+void AddTextureBenchmarks(Benchmark& bench, JobSystem* jobs) {
+    constexpr int SIZE = 1024;
+    const uint64_t pixelCount = static_cast<uint64_t>(SIZE) * SIZE;
+    auto pixels = std::make_shared<std::vector<uint8_t>>(CreateBenchmarkImage(SIZE, SIZE));
+
+    auto png = std::make_shared<std::vector<uint8_t>>();
+    stbi_write_png_to_func(AppendBytes, png.get(), SIZE, SIZE, 4, pixels->data(), SIZE * 4);
+    bench.Add("texture/decode_png", [png]() {
+        int width = 0, height = 0, channels = 0;
+        stbi_uc* decoded = stbi_load_from_memory(png->data(), static_cast<int>(png->size()), &width, &height,
+                                                 &channels, 4);
+        stbi_image_free(decoded);
+    }, pixelCount);
+
+    // Streamed textures fall back to this on devices without the format
+    const size_t bc3Size = BlockDecompressor::GetCompressedSize(BlockDecompressor::Format::BC3, SIZE, SIZE);
+    auto bc3 = std::make_shared<std::vector<uint8_t>>(bc3Size);
+    BlockCompressor::Compress(BlockCompressor::Format::BC3, pixels->data(), SIZE * 4, SIZE, SIZE, bc3->data(),
+                              bc3->size(), 0, jobs);
+    auto decoded = std::make_shared<std::vector<uint8_t>>(pixelCount * 4);
+    bench.Add("texture/decode_bc3", [bc3, decoded, jobs]() {
+        BlockDecompressor::Decompress(BlockDecompressor::Format::BC3, bc3->data(), bc3->size(), SIZE, SIZE,
+                                      decoded->data(), SIZE * 4, jobs);
+    }, pixelCount);
+
+    for (MipGenerator::Filter filter : { MipGenerator::Filter::Box, MipGenerator::Filter::Lanczos3 }) {
+        MipGenerator::Settings settings;
+        settings.filter = filter;
+        settings.srgb = true;
+        auto data = std::make_shared<std::vector<uint8_t>>();
+        auto levels = std::make_shared<std::vector<MipGenerator::Level>>();
+        bench.Add(filter == MipGenerator::Filter::Box ? "texture/mips_box_srgb" : "texture/mips_lanczos_srgb",
+                  [pixels, settings, data, levels, jobs]() {
+                      MipGenerator::Generate(pixels->data(), SIZE, SIZE, settings, *data, *levels, jobs);
+                  }, pixelCount);
+    }
+}
+
+// Per-call cost of crossing into the script VM, CALLS calls per iteration
+void AddScriptBenchmarks(Benchmark& bench) {
+    constexpr int CALLS = 1000;
+
+#ifdef NEXUS_LUA_ENABLED
+    auto lua = std::make_shared<LuaScriptingEngine>();
+    if (lua->Initialize(nullptr) &&
+        lua->ExecuteString("total = 0\nfunction bench_add(x) total = total + x end\nfunction update(dt) end")) {
+        auto function = std::make_shared<LuaFunctionRef>(lua->GetFunctionRef("bench_add"));
+        bench.Add("script/lua_call_ref", [lua, function]() {
+            for (int i = 0; i < CALLS; ++i) lua->CallFunction(*function, 1.0);
+        }, CALLS);
+        bench.Add("script/lua_call_name", [lua]() {
+            for (int i = 0; i < CALLS; ++i) lua->CallFunction("bench_add", 1.0);
+        }, CALLS);
+        bench.Add("script/lua_update", [lua]() {
+            for (int i = 0; i < CALLS; ++i) lua->Update(FRAME_TIME);
+        }, CALLS);
+    } else {
+        std::cerr << "Lua benchmarks skipped: the Lua engine did not start" << std::endl;
+    }
+#endif
+
+#ifdef NEXUS_PYTHON_ENABLED
+    // Python may only be initialized once per process, so this engine lives until exit
+    auto python = std::make_shared<ScriptingEngine>();
+    if (python->Initialize(nullptr) && python->ExecuteString("def update(dt):\n    pass\n")) {
+        bench.Add("script/python_update", [python]() {
+            for (int i = 0; i < CALLS; ++i) python->Update(FRAME_TIME);
+        }, CALLS);
+    } else {
+        std::cerr << "Python benchmarks skipped: the interpreter did not start" << std::endl;
+    }
+#endif
+}
+
+// The medians of two runs differ by more than noise when the gap exceeds three combined MADs
+void PrintComparison(const std::vector<Benchmark::Result>& results, const std::vector<Benchmark::Result>& baseline) {
+    std::map<std::string, const Benchmark::Result*> previous;
+    for (const Benchmark::Result& result : baseline) {
+        previous[result.name] = &result;
+    }
+
+    std::cout << std::endl << "Against the baseline:" << std::endl;
+    for (const Benchmark::Result& result : results) {
+        auto it = previous.find(result.name);
+        if (it == previous.end() || it->second->median <= 0.0) {
+            std::printf("  %-36s new\n", result.name.c_str());
+            continue;
+        }
+        const Benchmark::Result& before = *it->second;
+        const double change = (result.median - before.median) / before.median * 100.0;
+        const double noise = 3.0 * std::sqrt(result.mad * result.mad + before.mad * before.mad);
+        const char* verdict = std::abs(result.median - before.median) <= noise ? "within noise"
+                              : result.median < before.median              ? "faster"
+                                                                           : "SLOWER";
+        std::printf("  %-36s %10.4f -> %10.4f ms  %+7.2f%%  %s\n", result.name.c_str(), before.median,
+                    result.median, change, verdict);
+    }
+}
+
+void PrintUsage() {
+    std::cout << "Usage: NexusBench [options]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Runs headless subsystem benchmarks and reports the median, MAD and iteration count" << std::endl;
+    std::cout << "of each. Times are per iteration; the per-item column divides by the items one" << std::endl;
+    std::cout << "iteration covers." << std::endl;
+    std::cout << std::endl;
+    std::cout << "  --filter <text>        Only benchmarks whose name contains text" << std::endl;
+    std::cout << "  --list                 Print the benchmark names and exit" << std::endl;
+    std::cout << "  --json <file>          Write the results and their samples as JSON" << std::endl;
+    std::cout << "  --baseline <file>      Compare against results written by --json" << std::endl;
+    std::cout << "  --min-time <seconds>   Timed per benchmark, default 0.5" << std::endl;
+    std::cout << "  --min-iterations <n>   Default 10" << std::endl;
+    std::cout << "  --max-iterations <n>   Default 1000" << std::endl;
+    std::cout << "  --warmup <n>           Untimed iterations first, default 3" << std::endl;
+    std::cout << "  --jobs <n>             Worker threads; 0, the default, runs single-threaded" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Benchmark::Settings settings;
+    std::string jsonFile;
+    std::string baselineFile;
+    unsigned int workers = 0;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) {
+            settings.filter = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            jsonFile = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselineFile = argv[++i];
+        } else if (arg == "--min-time" && hasValue) {
+            settings.minSeconds = std::max(std::atof(argv[++i]), 0.0);
+        } else if (arg == "--min-iterations" && hasValue) {
+            settings.minIterations = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 1));
+        } else if (arg == "--max-iterations" && hasValue) {
+            settings.maxIterations = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 1));
+        } else if (arg == "--warmup" && hasValue) {
+            settings.warmupIterations = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--jobs" && hasValue) {
+            workers = static_cast<unsigned int>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--list") {
+            list = true;
+        } else {
+            PrintUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::vector<Benchmark::Result> baseline;
+    if (!baselineFile.empty() && !Benchmark::ReadJSON(baselineFile, baseline)) {
+        std::cerr << "Cannot read baseline " << baselineFile << std::endl;
+        return 1;
+    }
+
+    // Subsystems log every emitter, clip and entity they create
+    Logger::SetLogLevel(LogLevel::Warning);
+
+    JobSystem jobSystem;
+    JobSystem* jobs = nullptr;
+    if (workers > 0) {
+        jobSystem.Initialize(workers);
+        jobs = &jobSystem;
+    }
+
+    Benchmark bench;
+    AddPhysicsBenchmarks(bench, jobs);
+    AddParticleBenchmarks(bench, jobs);
+    AddAnimationBenchmarks(bench, jobs);
+    AddAIBenchmarks(bench, jobs);
+    AddAudioBenchmarks(bench, jobs);
+    AddTextureBenchmarks(bench, jobs);
+    AddScriptBenchmarks(bench);
+
+    if (list) {
+        for (const std::string& name : bench.GetCaseNames()) {
+            std::cout << name << std::endl;
+        }
+        return 0;
+    }
+
+#ifdef NDEBUG
+    bench.SetProperty("build", "release");
+#else
+    bench.SetProperty("build", "debug");
+#endif
+    bench.SetProperty("workers", std::to_string(workers));
+    bench.SetProperty("bcDecoder",
+                      BlockDecompressor::GetInstructionSetName(BlockDecompressor::GetInstructionSet()));
+    bench.SetProperty("minSeconds", std::to_string(settings.minSeconds));
+
+    std::printf("%-36s %12s %12s %8s %14s\n", "benchmark", "median ms", "MAD ms", "iters", "per item ns");
+    const std::vector<Benchmark::Result>& results = bench.Run(settings, [](const Benchmark::Result& result) {
+        std::printf("%-36s %12.4f %12.4f %8u %14.1f\n", result.name.c_str(), result.median, result.mad,
+                    result.iterations, result.median * 1e6 / result.operations);
+        std::fflush(stdout);
+    });
+    if (results.empty()) {
+        std::cerr << "No benchmark matches " << settings.filter << std::endl;
+        return 1;
+    }
+
+    if (!baseline.empty()) {
+        PrintComparison(results, baseline);
+    }
+    if (!jsonFile.empty() && !bench.WriteJSON(jsonFile)) {
+        return 1;
+    }
+
+    if (jobs) jobSystem.Shutdown();
+    Logger::Shutdown();
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "ShaderCache.h"
+#include "ShaderPermutations.h"
+#include "Logger.h"
+#include <d3dcompiler.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// Stage follows the shaders/ naming convention: Name_VS.hlsl, Name_PS.hlsl, Name_CS.hlsl
+const char* TargetForFile(const std::filesystem::path& file) {
+    std::string stem = file.stem().string();
+    if (stem.size() < 3) return nullptr;
+    std::string suffix = stem.substr(stem.size() - 3);
+    if (suffix == "_VS") return "vs_5_0";
+    if (suffix == "_PS") return "ps_5_0";
+    if (suffix == "_CS") return "cs_5_0";
+    return nullptr;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: NexusShaderCompiler <cache_directory> <shader.hlsl>..." << std::endl;
+        std::cout << std::endl;
+        std::cout << "Precompiles shaders into the runtime shader cache. Files are named" << std::endl;
+        std::cout << "<Name>_VS.hlsl, <Name>_PS.hlsl or <Name>_CS.hlsl; every combination of the" << std::endl;
+        std::cout << "keywords declared on a \"// keywords:\" line is compiled." << std::endl;
+        return 1;
+    }
+
+    Nexus::ShaderCache::Initialize(argv[1]);
+    if (Nexus::ShaderCache::GetDirectory().empty()) {
+        std::cerr << "Cannot create cache directory " << argv[1] << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    for (int i = 2; i < argc; i++) {
+        std::filesystem::path file = argv[i];
+        const char* target = TargetForFile(file);
+        if (!target) {
+            std::cerr << "Skipping " << file.string() << ": unknown shader stage" << std::endl;
+            continue;
+        }
+
+        // Read exactly as Shader::LoadFromFile does so the cache keys match at runtime
+        std::ifstream input(file);
+        if (!input.is_open()) {
+            std::cerr << "Cannot open " << file.string() << std::endl;
+            failures++;
+            continue;
+        }
+        std::stringstream stream;
+        stream << input.rdbuf();
+        std::string source = stream.str();
+
+        std::vector<std::string> keywords = Nexus::ShaderPermutations::ParseKeywords(source);
+        if (keywords.size() > Nexus::ShaderPermutations::MAX_KEYWORDS) {
+            std::cerr << file.string() << ": more than " << Nexus::ShaderPermutations::MAX_KEYWORDS
+                      << " keywords" << std::endl;
+            failures++;
+            continue;
+        }
+
+        // Same flags and defines as Shader::CompileShader, so every variant is a runtime cache hit
+        const Nexus::ShaderPermutations::KeywordMask variantCount = 1u << keywords.size();
+        int fileFailures = 0;
+        for (Nexus::ShaderPermutations::KeywordMask mask = 0; mask < variantCount; ++mask) {
+            ID3DBlob* bytecode = nullptr;
+            std::string errors;
+            HRESULT hr = Nexus::ShaderCache::Compile(source, nullptr, "main", target, D3DCOMPILE_ENABLE_STRICTNESS,
+                                                     &bytecode, &errors,
+                                                     Nexus::ShaderPermutations::BuildDefines(keywords, mask));
+            if (FAILED(hr)) {
+                std::cerr << file.string() << ": variant " << mask << " failed" << std::endl << errors << std::endl;
+                fileFailures++;
+                continue;
+            }
+            bytecode->Release();
+        }
+
+        failures += fileFailures;
+        std::cout << file.filename().string() << " (" << target << ", " << variantCount << " variant"
+                  << (variantCount == 1 ? "" : "s") << ")" << std::endl;
+    }
+
+    Nexus::ShaderCache::Stats stats = Nexus::ShaderCache::GetStats();
+    std::cout << stats.compiles << " compiled, " << stats.diskHits << " up to date, " << failures
+              << " failed" << std::endl;
+    Nexus::ShaderCache::Shutdown();
+    return failures > 0 ? 1 : 0;
+}
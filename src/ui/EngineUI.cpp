@@ -2,14 +2,20 @@
 #include "Engine.h"
 #include "Logger.h"
 #include "GraphicsDevice.h"
+#include "GpuProfiler.h"
 #include "InputManager.h"
+#include "Profiler.h"
+#include "FrameMetrics.h"
+#include "MemoryTracker.h"
 
 // ImGui includes
 #include "imgui.h"
+#include "imgui_internal.h"
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx11.h"
 
 #include <Windows.h>
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
@@ -17,17 +23,40 @@
 
 namespace Nexus {
 
+namespace {
+
+// Hover highlights, tooltips and nav fades keep animating for a while after the last input
+constexpr float INPUT_SETTLE_SECONDS = 1.0f;
+
+// Callstack sampling from the memory panel: one allocation per this many bytes on each thread
+constexpr uint64_t ALLOCATION_SAMPLING_BYTES = 64 * 1024;
+constexpr float BYTES_PER_MB = 1024.0f * 1024.0f;
+
+} // namespace
+
 EngineUI::EngineUI()
     : engine_(nullptr)
     , device_(nullptr)
     , context_(nullptr)
     , initialized_(false)
     , isVisible_(true)
+    , dirty_(true)
+    , rebuildThisFrame_(false)
+    , hasDrawData_(false)
+    , displayWidth_(0.0f)
+    , displayHeight_(0.0f)
+    , metricsChanged_(false)
+    , refreshTimer_(0.0f)
+    , frameTimeAccumulator_(0.0f)
+    , framesAccumulated_(0)
+    , fpsHistoryOffset_(0)
+    , logHead_(0)
+    , logCount_(0)
     , imguiContext_(nullptr)
     , fontsLoaded_(false)
 {
-    // Initialize console log
-    consoleLog_.reserve(settings_.maxLogLines);
+    fpsHistory_.fill(0.0f);
+    consoleLog_.resize(settings_.maxLogLines);
 }
 
 EngineUI::~EngineUI() {
@@ -107,20 +136,70 @@ void EngineUI::Shutdown() {
     Logger::Info("Engine UI shutdown complete");
 }
 
+void EngineUI::Update(float deltaTime) {
+    if (!initialized_) return;
+    
+    frameTimeAccumulator_ += deltaTime;
+    framesAccumulated_++;
+    refreshTimer_ += deltaTime;
+    
+    float rate = isVisible_ ? settings_.refreshRate : settings_.hiddenUpdateRate;
+    if (rate <= 0.0f || refreshTimer_ < 1.0f / rate) return;
+    refreshTimer_ = 0.0f;
+    
+    UpdateEngineStatus();
+}
+
 void EngineUI::NewFrame() {
-    if (!initialized_ || !isVisible_) return;
+    rebuildThisFrame_ = false;
+    if (!initialized_ || !isVisible_ || !NeedsRebuild()) return;
+    rebuildThisFrame_ = true;
+    dirty_ = false;
+    
+    if (metricsChanged_.exchange(false)) {
+        std::lock_guard<std::mutex> lock(metricsMutex_);
+        metrics_ = publishedMetrics_;
+        fpsHistory_[fpsHistoryOffset_] = metrics_.fps;
+        fpsHistoryOffset_ = (fpsHistoryOffset_ + 1) % fpsHistory_.size();
+    }
     
     // Start the Dear ImGui frame
     ImGui_ImplDX11_NewFrame();
     ImGui_ImplWin32_NewFrame();
     ImGui::NewFrame();
+}
+
+bool EngineUI::NeedsRebuild() {
+    auto now = std::chrono::steady_clock::now();
+    // Events the window procedure handed to ImGui since its last frame
+    if (GImGui->InputEventsQueue.Size > 0) {
+        lastInputTime_ = now;
+    }
+    if (!hasDrawData_ || dirty_ || metricsChanged_ ||
+        std::chrono::duration<float>(now - lastInputTime_).count() < INPUT_SETTLE_SECONDS) {
+        return true;
+    }
+    // Text cursors blink and drags follow the mouse
+    if (ImGui::IsAnyItemActive() || ImGui::GetIO().WantTextInput) {
+        return true;
+    }
     
-    // Update engine status
-    UpdateEngineStatus();
+    RECT rect = {};
+    HWND hwnd = static_cast<HWND>(ImGui::GetMainViewport()->PlatformHandleRaw);
+    if (hwnd && GetClientRect(hwnd, &rect)) {
+        float width = static_cast<float>(rect.right - rect.left);
+        float height = static_cast<float>(rect.bottom - rect.top);
+        if (width != displayWidth_ || height != displayHeight_) {
+            displayWidth_ = width;
+            displayHeight_ = height;
+            return true;
+        }
+    }
+    return false;
 }
 
 void EngineUI::Render() {
-    if (!initialized_ || !isVisible_) return;
+    if (!initialized_ || !isVisible_ || !rebuildThisFrame_) return;
     
     // Main menu bar
     RenderMainMenuBar();
@@ -185,13 +264,18 @@ void EngineUI::Render() {
 void EngineUI::EndFrame() {
     if (!initialized_ || !isVisible_) return;
     
-    // Rendering
-    ImGui::Render();
+    if (rebuildThisFrame_) {
+        ImGui::Render();
+        hasDrawData_ = true;
+    }
+    if (!hasDrawData_) return;
+    
+    // Without a rebuild this is last frame's draw data; ImGui keeps it until the next NewFrame
     ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
     
-    // Update and Render additional Platform Windows
+    // Update and Render additional Platform Windows; unchanged ones keep their last image
     ImGuiIO& io = ImGui::GetIO();
-    if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
+    if (rebuildThisFrame_ && (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)) {
         ImGui::UpdatePlatformWindows();
         ImGui::RenderPlatformWindowsDefault();
     }
@@ -323,14 +407,8 @@ void EngineUI::RenderQuickActionsPanel() {
 
 void EngineUI::RenderPerformancePanel() {
     if (ImGui::Begin("📊 Performance", &showPerformancePanel_)) {
-        // FPS Graph
-        static std::vector<float> fpsHistory(100);
-        static int fpsOffset = 0;
-        
-        fpsHistory[fpsOffset] = metrics_.fps;
-        fpsOffset = (fpsOffset + 1) % fpsHistory.size();
-        
-        ImGui::PlotLines("FPS", fpsHistory.data(), (int)fpsHistory.size(), fpsOffset, 
+        // FPS Graph, one sample per metrics refresh
+        ImGui::PlotLines("FPS", fpsHistory_.data(), (int)fpsHistory_.size(), (int)fpsHistoryOffset_, 
                         nullptr, 0.0f, 120.0f, ImVec2(0, 80));
         
         // Performance metrics
@@ -338,6 +416,8 @@ void EngineUI::RenderPerformancePanel() {
         
         ImGui::Text("Frame Rate:");
         ImGui::Text("Frame Time:");
+        ImGui::Text("p95 / p99 / Max:");
+        ImGui::Text("Hitches:");
         ImGui::Text("CPU Usage:");
         ImGui::Text("Memory:");
         ImGui::Text("Draw Calls:");
@@ -347,6 +427,8 @@ void EngineUI::RenderPerformancePanel() {
         
         ImGui::Text("%.1f FPS", metrics_.fps);
         ImGui::Text("%.2f ms", metrics_.frameTime);
+        ImGui::Text("%.2f / %.2f / %.2f ms", metrics_.frameTimeP95, metrics_.frameTimeP99, metrics_.frameTimeMax);
+        ImGui::Text("%d", metrics_.hitches);
         ImGui::Text("%.1f%%", metrics_.cpuUsage);
         ImGui::Text("%.1f MB", metrics_.memoryUsage);
         ImGui::Text("%d", metrics_.drawCalls);
@@ -354,6 +436,90 @@ void EngineUI::RenderPerformancePanel() {
         
         ImGui::Columns(1);
         
+        // Per-scope CPU/GPU breakdown from the frame profiler
+        ImGui::Separator();
+        if (ImGui::CollapsingHeader("Frame Profiler", ImGuiTreeNodeFlags_DefaultOpen)) {
+            bool profilerEnabled = Profiler::IsEnabled();
+            if (ImGui::Checkbox("Enabled", &profilerEnabled)) {
+                Profiler::SetEnabled(profilerEnabled);
+            }
+            ImGui::SameLine();
+            if (Profiler::IsCapturing()) {
+                ImGui::TextDisabled("Capturing...");
+            } else if (ImGui::Button("Capture 300 frames")) {
+                Profiler::BeginCapture(300);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Save Trace")) {
+                Profiler::SaveChromeTrace("nexus_trace.json");
+            }
+            
+            ImGui::Text("Frame: %.2f ms", Profiler::GetLastFrameTimeMs());
+            ImGui::Columns(4, "ProfilerColumns");
+            ImGui::Text("Scope"); ImGui::NextColumn();
+            ImGui::Text("Calls"); ImGui::NextColumn();
+            ImGui::Text("Total ms"); ImGui::NextColumn();
+            ImGui::Text("Max ms"); ImGui::NextColumn();
+            ImGui::Separator();
+            for (const auto& scope : Profiler::GetLastFrameStats()) {
+                ImGui::Indent(scope.depth * 8.0f + 1.0f);
+                ImGui::Text("%s%s", scope.lane == 0 ? "" : "[GPU] ", scope.name);
+                ImGui::Unindent(scope.depth * 8.0f + 1.0f);
+                ImGui::NextColumn();
+                ImGui::Text("%u", scope.callCount); ImGui::NextColumn();
+                ImGui::Text("%.3f", scope.totalMs); ImGui::NextColumn();
+                ImGui::Text("%.3f", scope.maxMs); ImGui::NextColumn();
+            }
+            ImGui::Columns(1);
+        }
+        
+        // Heap by subsystem from the allocation hooks, video memory from DXGI
+        ImGui::Separator();
+        if (ImGui::CollapsingHeader("Memory")) {
+            if (!MemoryTracker::IsEnabled()) {
+                ImGui::TextDisabled("Heap tracking is not built in (ENABLE_MEMORY_TRACKING)");
+            }
+            ImGui::Columns(4, "MemoryColumns");
+            ImGui::Text("Tag"); ImGui::NextColumn();
+            ImGui::Text("Current MB"); ImGui::NextColumn();
+            ImGui::Text("Peak MB"); ImGui::NextColumn();
+            ImGui::Text("Allocations"); ImGui::NextColumn();
+            ImGui::Separator();
+            for (size_t i = 0; i < MemoryTracker::TAG_COUNT; ++i) {
+                MemoryTag tag = static_cast<MemoryTag>(i);
+                MemoryTagStats stats = MemoryTracker::GetStats(tag);
+                ImGui::Text("%s", MemoryTracker::GetTagName(tag)); ImGui::NextColumn();
+                ImGui::Text("%.2f", stats.currentBytes / BYTES_PER_MB); ImGui::NextColumn();
+                ImGui::Text("%.2f", stats.peakBytes / BYTES_PER_MB); ImGui::NextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(stats.liveAllocations)); ImGui::NextColumn();
+            }
+            ImGui::Columns(1);
+            
+            if (ImGui::Button("Reset Peaks")) {
+                MemoryTracker::ResetPeaks();
+            }
+            ImGui::SameLine();
+            bool sampling = MemoryTracker::GetSamplingInterval() > 0;
+            if (ImGui::Checkbox("Sample Callstacks", &sampling)) {
+                MemoryTracker::SetSamplingInterval(sampling ? ALLOCATION_SAMPLING_BYTES : 0);
+            }
+            if (sampling) {
+                ImGui::SameLine();
+                if (ImGui::Button("Save Allocation Report")) {
+                    MemoryTracker::SaveAllocationReport("nexus_allocations.txt");
+                }
+            }
+            
+            GpuMemoryStats gpu = MemoryTracker::GetGpuStats();
+            if (gpu.available) {
+                ImGui::Text("Video memory: %.1f / %.1f MB", gpu.localUsage / BYTES_PER_MB, gpu.localBudget / BYTES_PER_MB);
+                ImGui::ProgressBar(gpu.localBudget > 0 ? static_cast<float>(gpu.localUsage) / gpu.localBudget : 0.0f);
+                ImGui::Text("Shared memory: %.1f / %.1f MB", gpu.nonLocalUsage / BYTES_PER_MB, gpu.nonLocalBudget / BYTES_PER_MB);
+            } else {
+                ImGui::TextDisabled("Video memory not available");
+            }
+        }
+        
         // VSync control
         ImGui::Separator();
         if (ImGui::Checkbox("V-Sync", &settings_.enableVSync)) {
@@ -417,13 +583,19 @@ void EngineUI::RenderConsolePanel() {
         const float footer_height_to_reserve = ImGui::GetStyle().ItemSpacing.y + ImGui::GetFrameHeightWithSpacing();
         ImGui::BeginChild("ScrollingRegion", ImVec2(0, -footer_height_to_reserve), false, ImGuiWindowFlags_HorizontalScrollbar);
         
-        for (const auto& line : consoleLog_) {
-            if (line.find("ERROR") != std::string::npos) {
-                ImGui::TextColored(ImVec4(theme_.errorColor[0], theme_.errorColor[1], theme_.errorColor[2], 1.0f), "%s", line.c_str());
-            } else if (line.find("WARNING") != std::string::npos) {
-                ImGui::TextColored(ImVec4(theme_.warningColor[0], theme_.warningColor[1], theme_.warningColor[2], 1.0f), "%s", line.c_str());
-            } else {
-                ImGui::Text("%s", line.c_str());
+        // Only the visible lines are submitted
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(logCount_));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                const LogLine& line = consoleLog_[(logHead_ + i) % consoleLog_.size()];
+                if (line.level == 2) {
+                    ImGui::TextColored(ImVec4(theme_.errorColor[0], theme_.errorColor[1], theme_.errorColor[2], 1.0f), "%s", line.text.c_str());
+                } else if (line.level == 1) {
+                    ImGui::TextColored(ImVec4(theme_.warningColor[0], theme_.warningColor[1], theme_.warningColor[2], 1.0f), "%s", line.text.c_str());
+                } else {
+                    ImGui::TextUnformatted(line.text.c_str(), line.text.c_str() + line.text.size());
+                }
             }
         }
         
@@ -474,7 +646,11 @@ void EngineUI::RenderSettingsPanel() {
         
         if (ImGui::CollapsingHeader("🔧 Advanced")) {
             ImGui::Checkbox("Auto-Save", &settings_.autoSaveEnabled);
-            ImGui::SliderInt("Max Log Lines", &settings_.maxLogLines, 100, 5000);
+            if (ImGui::SliderInt("Max Log Lines", &settings_.maxLogLines, 100, 5000)) {
+                ResizeLog(static_cast<size_t>(settings_.maxLogLines));
+            }
+            ImGui::SliderFloat("Refresh Rate", &settings_.refreshRate, 1.0f, 60.0f, "%.0f Hz");
+            ImGui::SliderFloat("Hidden Update Rate", &settings_.hiddenUpdateRate, 0.0f, 10.0f, "%.1f Hz");
         }
         
         ImGui::Separator();
@@ -488,6 +664,7 @@ void EngineUI::RenderSettingsPanel() {
         
         if (ImGui::Button("🔄 Reset to Defaults")) {
             settings_ = Settings{};
+            ResizeLog(static_cast<size_t>(settings_.maxLogLines));
             ApplyTheme();
         }
     }
@@ -530,8 +707,61 @@ void EngineUI::RenderHelpPanel() {
 
 void EngineUI::RenderDebugPanel() {
     if (ImGui::Begin("🐛 Debug Info", &showDebugPanel_)) {
-        // TODO: Add debug information
-        ImGui::Text("Debug information will be displayed here");
+        GraphicsDevice* graphics = engine_ ? engine_->GetGraphics() : nullptr;
+        if (!graphics) {
+            ImGui::TextDisabled("No graphics device");
+        } else {
+            // Shading cost views replace the scene until switched back
+            static const char* const views[] = { "Shaded", "Overdraw", "Quad overshading" };
+            int view = static_cast<int>(graphics->GetDebugView());
+            if (ImGui::Combo("Scene View", &view, views, 3)) {
+                if (!graphics->SetDebugView(static_cast<GraphicsDevice::DebugView>(view))) {
+                    AddLogMessage("Debug view unavailable on this device", 1);
+                }
+            }
+            if (graphics->GetDebugView() == GraphicsDevice::DebugView::Overdraw) {
+                ImGui::TextWrapped("Layers shaded per pixel: blue 1-2, green 5, yellow 7-8, red 10, white 20 or more");
+            } else if (graphics->GetDebugView() == GraphicsDevice::DebugView::QuadOvershading) {
+                ImGui::TextWrapped("Useful share of 2x2 quad lanes: red 25%% (one pixel per quad), yellow 62%%, green 100%%");
+            }
+        
+            // Work each top-level GPU pass submitted, a few frames old
+            GpuProfiler* gpuProfiler = graphics->GetGpuProfiler();
+            ImGui::Separator();
+            if (gpuProfiler && ImGui::CollapsingHeader("Pipeline Statistics", ImGuiTreeNodeFlags_DefaultOpen)) {
+                bool statistics = gpuProfiler->IsCollectingPipelineStatistics();
+                if (ImGui::Checkbox("Collect", &statistics)) {
+                    gpuProfiler->SetPipelineStatistics(statistics);
+                }
+                if (statistics && gpuProfiler->HasResolvedFrameStatistics()) {
+                    ImGui::Columns(6, "PipelineColumns");
+                    ImGui::Text("Pass"); ImGui::NextColumn();
+                    ImGui::Text("ms"); ImGui::NextColumn();
+                    ImGui::Text("VS"); ImGui::NextColumn();
+                    ImGui::Text("PS"); ImGui::NextColumn();
+                    ImGui::Text("Primitives"); ImGui::NextColumn();
+                    ImGui::Text("Rasterized"); ImGui::NextColumn();
+                    ImGui::Separator();
+                    auto row = [](const char* name, float milliseconds, const GpuProfiler::PipelineStatistics& stats) {
+                        ImGui::Text("%s", name); ImGui::NextColumn();
+                        ImGui::Text("%.3f", milliseconds); ImGui::NextColumn();
+                        ImGui::Text("%llu", static_cast<unsigned long long>(stats.vsInvocations)); ImGui::NextColumn();
+                        ImGui::Text("%llu", static_cast<unsigned long long>(stats.psInvocations)); ImGui::NextColumn();
+                        ImGui::Text("%llu", static_cast<unsigned long long>(stats.primitives)); ImGui::NextColumn();
+                        ImGui::Text("%llu", static_cast<unsigned long long>(stats.clipperPrimitives)); ImGui::NextColumn();
+                    };
+                    for (const GpuProfiler::PassTiming& pass : gpuProfiler->GetLastResolvedPasses()) {
+                        if (pass.depth == 0 && pass.hasStatistics) {
+                            row(pass.name, pass.milliseconds, pass.statistics);
+                        }
+                    }
+                    ImGui::Separator();
+                    row("Frame", gpuProfiler->GetLastResolvedFrameTime(), gpuProfiler->GetLastResolvedFrameStatistics());
+                    ImGui::Columns(1);
+                    ImGui::TextDisabled("Captures from the performance panel record these as counter tracks");
+                }
+            }
+        }
     }
     ImGui::End();
 }
@@ -683,20 +913,46 @@ void EngineUI::UpdateEngineStatus() {
     // TODO: Get real engine status
     status_.isRunning = engine_ != nullptr;
     
-    // Update performance metrics
-    static auto lastTime = std::chrono::high_resolution_clock::now();
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    auto deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
-    lastTime = currentTime;
-    
-    if (deltaTime > 0.0f) {
-        metrics_.fps = 1.0f / deltaTime;
-        metrics_.frameTime = deltaTime * 1000.0f;
+    // Averaged over the frames since the last refresh; percentiles from the engine's window
+    if (framesAccumulated_ > 0 && frameTimeAccumulator_ > 0.0f) {
+        MetricSummary frame;
+        bool haveSummary = engine_ && engine_->GetMetrics() && engine_->GetMetrics()->GetSummary("Frame", frame);
+        std::lock_guard<std::mutex> lock(metricsMutex_);
+        publishedMetrics_.fps = framesAccumulated_ / frameTimeAccumulator_;
+        publishedMetrics_.frameTime = frameTimeAccumulator_ / framesAccumulated_ * 1000.0f;
+        publishedMetrics_.memoryUsage = MemoryTracker::GetTotalBytes() / BYTES_PER_MB;
+        if (haveSummary) {
+            publishedMetrics_.frameTimeP95 = frame.p95;
+            publishedMetrics_.frameTimeP99 = frame.p99;
+            publishedMetrics_.frameTimeMax = frame.max;
+            publishedMetrics_.hitches = static_cast<int>(frame.hitches);
+        }
+        metricsChanged_ = true;
     }
+    frameTimeAccumulator_ = 0.0f;
+    framesAccumulated_ = 0;
 }
 
 void EngineUI::UpdatePerformanceMetrics(const PerformanceMetrics& metrics) {
-    metrics_ = metrics;
+    std::lock_guard<std::mutex> lock(metricsMutex_);
+    publishedMetrics_ = metrics;
+    metricsChanged_ = true;
+}
+
+void EngineUI::ResizeLog(size_t capacity) {
+    capacity = std::max<size_t>(capacity, 1);
+    if (capacity == consoleLog_.size()) return;
+    
+    // Keep the newest lines, oldest first
+    size_t keep = std::min(logCount_, capacity);
+    std::vector<LogLine> lines(capacity);
+    for (size_t i = 0; i < keep; ++i) {
+        lines[i] = std::move(consoleLog_[(logHead_ + logCount_ - keep + i) % consoleLog_.size()]);
+    }
+    consoleLog_.swap(lines);
+    logHead_ = 0;
+    logCount_ = keep;
+    dirty_ = true;
 }
 
 void EngineUI::AddLogMessage(const std::string& message, int level) {
@@ -718,12 +974,18 @@ void EngineUI::AddLogMessage(const std::string& message, int level) {
     
     ss << message;
     
-    consoleLog_.push_back(ss.str());
-    
-    // Limit log size
-    if (consoleLog_.size() > static_cast<size_t>(settings_.maxLogLines)) {
-        consoleLog_.erase(consoleLog_.begin());
+    // The oldest line is overwritten once the ring is full
+    LogLine line;
+    line.text = ss.str();
+    line.level = level;
+    if (logCount_ < consoleLog_.size()) {
+        consoleLog_[(logHead_ + logCount_) % consoleLog_.size()] = std::move(line);
+        logCount_++;
+    } else {
+        consoleLog_[logHead_] = std::move(line);
+        logHead_ = (logHead_ + 1) % consoleLog_.size();
     }
+    dirty_ = true;
 }
 
 void EngineUI::ProcessConsoleCommand(const std::string& command) {
@@ -737,7 +999,8 @@ void EngineUI::ProcessConsoleCommand(const std::string& command) {
         AddLogMessage("  status - Show engine status", 0);
         AddLogMessage("  exit - Exit engine", 0);
     } else if (command == "clear") {
-        consoleLog_.clear();
+        logHead_ = 0;
+        logCount_ = 0;
     } else if (command == "fps") {
         AddLogMessage("FPS: " + std::to_string(metrics_.fps), 0);
         AddLogMessage("Frame Time: " + std::to_string(metrics_.frameTime) + "ms", 0);
@@ -0,0 +1,29 @@
+#include "AtomicFile.h"
+#include <filesystem>
+#include <fstream>
+
+namespace Nexus {
+
+bool WriteFileAtomic(const std::string& filename, const std::function<void(std::ostream&)>& write,
+                     std::ios::openmode mode) {
+    const std::string temporary = filename + ".tmp";
+    std::error_code error;
+    {
+        std::ofstream file(temporary, mode | std::ios::out | std::ios::trunc);
+        if (file) write(file);
+        if (!file || !file.flush()) {
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, filename, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+} // namespace Nexus
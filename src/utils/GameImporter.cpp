@@ -1,17 +1,215 @@
 #include "GameImporter.h"
 #include "Engine.h"
 #include "Logger.h"
+#include "ImportCache.h"
+#include "JobSystem.h"
+#include "MeshImporter.h"
+#include "SceneFile.h"
+#include "StaticGeometry.h"
+#include "UnityYamlReader.h"
+#include <cctype>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <regex>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <thread>
+#include <unordered_map>
 
 namespace fs = std::filesystem;
 
 namespace Nexus {
 
-GameImporter::GameImporter() : engine_(nullptr) {
+namespace {
+// Everything that changes what the converters write; not the output directory, since outputs
+// are recorded relative to it
+std::string DescribeSettings(const GameImporter::ImportSettings& settings) {
+    std::ostringstream text;
+    text << settings.convertMaterials << settings.convertScripts << settings.convertAnimations
+         << settings.preserveHierarchy << settings.optimizeMeshes << settings.generateLODs << settings.bakeCollision
+         << ' ' << settings.scaleMultiplier << ' ' << settings.scriptLanguage;
+    return text.str();
+}
+
+std::string ReadText(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+bool IsHexDigit(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// Class IDs of the Unity documents scene hierarchies are built from
+constexpr uint32_t UNITY_GAME_OBJECT = 1;
+constexpr uint32_t UNITY_TRANSFORM = 4;
+constexpr uint32_t UNITY_RECT_TRANSFORM = 224;
+
+// What a GameObject or Transform document holds, as views into the mapped scene
+struct UnityObjectRecord {
+    std::string_view name;
+    std::vector<int64_t> components;
+    int64_t gameObject = 0;
+    int64_t father = 0;
+    std::vector<int64_t> children;
+    XMFLOAT3 position = { 0.0f, 0.0f, 0.0f };
+    XMFLOAT3 rotation = { 0.0f, 0.0f, 0.0f };
+    XMFLOAT3 scale = { 1.0f, 1.0f, 1.0f };
+};
+
+XMFLOAT3 ToUnityVector(std::string_view flow, const XMFLOAT3& fallback) {
+    return XMFLOAT3(UnityYamlReader::ToFloat(UnityYamlReader::FindFlowValue(flow, "x"), fallback.x),
+                    UnityYamlReader::ToFloat(UnityYamlReader::FindFlowValue(flow, "y"), fallback.y),
+                    UnityYamlReader::ToFloat(UnityYamlReader::FindFlowValue(flow, "z"), fallback.z));
+}
+
+// Unity's Euler angles (degrees, applied Z, X, then Y) of a local rotation
+XMFLOAT3 ToUnityEuler(std::string_view flow) {
+    const float x = UnityYamlReader::ToFloat(UnityYamlReader::FindFlowValue(flow, "x"));
+    const float y = UnityYamlReader::ToFloat(UnityYamlReader::FindFlowValue(flow, "y"));
+    const float z = UnityYamlReader::ToFloat(UnityYamlReader::FindFlowValue(flow, "z"));
+    const float w = UnityYamlReader::ToFloat(UnityYamlReader::FindFlowValue(flow, "w"), 1.0f);
+    const float sinX = std::clamp(2.0f * (w * x - y * z), -1.0f, 1.0f);
+    return XMFLOAT3(XMConvertToDegrees(std::asin(sinX)),
+                    XMConvertToDegrees(std::atan2(2.0f * (w * y + x * z), 1.0f - 2.0f * (x * x + y * y))),
+                    XMConvertToDegrees(std::atan2(2.0f * (w * z + x * y), 1.0f - 2.0f * (x * x + z * z))));
+}
+
+// Walks the top level fields of a GameObject or Transform; sequence items are attributed to the
+// key above them
+void ReadUnityObject(uint32_t classId, std::string_view body, UnityObjectRecord& record) {
+    int topIndent = -1;
+    std::string_view section;
+    UnityYamlReader::ForEachField(body, [&](const UnityYamlField& field) {
+        if (topIndent < 0) topIndent = field.indent;
+        if (!field.item) {
+            if (field.indent != topIndent) return true;
+            section = field.key;
+        } else if (field.indent != topIndent + 2) {
+            return true;
+        }
+
+        if (classId == UNITY_GAME_OBJECT) {
+            if (field.item && section == "m_Component") {
+                record.components.push_back(UnityYamlReader::ToFileId(field.value));
+            } else if (!field.item && section == "m_Name") {
+                record.name = UnityYamlReader::ToString(field.value);
+            }
+        } else if (field.item) {
+            if (section == "m_Children") record.children.push_back(UnityYamlReader::ToFileId(field.value));
+        } else if (section == "m_GameObject") {
+            record.gameObject = UnityYamlReader::ToFileId(field.value);
+        } else if (section == "m_Father") {
+            record.father = UnityYamlReader::ToFileId(field.value);
+        } else if (section == "m_LocalPosition") {
+            record.position = ToUnityVector(field.value, record.position);
+        } else if (section == "m_LocalRotation") {
+            record.rotation = ToUnityEuler(field.value);
+        } else if (section == "m_LocalScale") {
+            record.scale = ToUnityVector(field.value, record.scale);
+        }
+        return true;
+    });
+}
+
+// The hierarchy of a scene or prefab. Documents are parsed independently, on jobs when given,
+// and linked by file ID afterwards
+bool ParseUnityHierarchy(const std::string& filename, std::vector<std::shared_ptr<UnityImporter::UnityGameObject>>& roots,
+                         JobSystem* jobs) {
+    UnityYamlReader reader;
+    if (!reader.Open(filename)) {
+        Logger::Error("Failed to open Unity file: " + filename);
+        return false;
+    }
+    const std::vector<UnityYamlDocument>& documents = reader.GetDocuments();
+
+    std::vector<UnityObjectRecord> records(documents.size());
+    auto parse = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const UnityYamlDocument& document = documents[i];
+            if (document.stripped) continue;
+            if (document.classId == UNITY_GAME_OBJECT || document.classId == UNITY_TRANSFORM ||
+                document.classId == UNITY_RECT_TRANSFORM) {
+                ReadUnityObject(document.classId, document.body, records[i]);
+            }
+        }
+    };
+    if (jobs) jobs->ParallelFor(documents.size(), 256, parse);
+    else parse(0, documents.size());
+
+    std::unordered_map<int64_t, size_t> byFileId;
+    byFileId.reserve(documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) byFileId.emplace(documents[i].fileId, i);
+    auto find = [&](int64_t fileId, bool transform) -> const UnityObjectRecord* {
+        auto it = byFileId.find(fileId);
+        if (it == byFileId.end() || documents[it->second].stripped) return nullptr;
+        const uint32_t classId = documents[it->second].classId;
+        const bool isTransform = classId == UNITY_TRANSFORM || classId == UNITY_RECT_TRANSFORM;
+        if (transform ? !isTransform : classId != UNITY_GAME_OBJECT) return nullptr;
+        return &records[it->second];
+    };
+
+    // One object per GameObject, taking its transform's local values
+    std::unordered_map<int64_t, std::shared_ptr<UnityImporter::UnityGameObject>> objects;
+    std::vector<std::pair<int64_t, const UnityObjectRecord*>> transforms;   // GameObject file ID, transform
+    for (size_t i = 0; i < documents.size(); ++i) {
+        if (documents[i].classId != UNITY_GAME_OBJECT || documents[i].stripped) continue;
+        const UnityObjectRecord& record = records[i];
+        auto object = std::make_shared<UnityImporter::UnityGameObject>();
+        object->name = std::string(record.name);
+        object->position = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        object->rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        object->scale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+
+        const UnityObjectRecord* transform = nullptr;
+        for (int64_t component : record.components) {
+            auto it = byFileId.find(component);
+            if (it == byFileId.end()) continue;
+            object->components.emplace_back(documents[it->second].type);
+            if (!transform) transform = find(component, true);
+        }
+        if (transform) {
+            object->position = transform->position;
+            object->rotation = transform->rotation;
+            object->scale = transform->scale;
+        }
+        transforms.emplace_back(documents[i].fileId, transform);
+        objects.emplace(documents[i].fileId, std::move(object));
+    }
+
+    // Children in their parent's order; objects without a parent in this file are roots
+    for (const auto& [gameObject, transform] : transforms) {
+        std::shared_ptr<UnityImporter::UnityGameObject>& object = objects[gameObject];
+        if (!transform || !find(transform->father, true)) roots.push_back(object);
+        if (!transform) continue;
+        for (int64_t child : transform->children) {
+            const UnityObjectRecord* childTransform = find(child, true);
+            if (!childTransform) continue;
+            auto it = objects.find(childTransform->gameObject);
+            if (it != objects.end()) object->children.push_back(it->second);
+        }
+    }
+    return true;
+}
+
+size_t CountUnityObjects(const std::vector<std::shared_ptr<UnityImporter::UnityGameObject>>& roots) {
+    size_t count = 0;
+    std::vector<const UnityImporter::UnityGameObject*> pending;
+    for (const auto& root : roots) pending.push_back(root.get());
+    while (!pending.empty()) {
+        const UnityImporter::UnityGameObject* object = pending.back();
+        pending.pop_back();
+        ++count;
+        for (const auto& child : object->children) pending.push_back(child.get());
+    }
+    return count;
+}
+}
+
+GameImporter::GameImporter() : engine_(nullptr), unityGuidsScanned_(false), cachedAssets_(0), ioSlots_(1),
+                               importJobs_(nullptr) {
 }
 
 GameImporter::~GameImporter() {
@@ -150,119 +348,17 @@ GameImporter::ImportResult GameImporter::ImportUnityProject(const std::string& p
     result.message = "Unity project import started";
 
     Logger::Info("Importing Unity project from: " + projectPath);
+    BeginIncrementalImport(projectPath, settings);
 
     // Scan for Unity assets
     std::vector<std::string> assetPaths = ScanForAssets(projectPath + "/Assets", EngineType::Unity);
     
     Logger::Info("Found " + std::to_string(assetPaths.size()) + " Unity assets to import");
 
-    for (const std::string& assetPath : assetPaths) {
-        std::string extension = GetFileExtension(assetPath);
-        
-        try {
-            if (extension == ".unity") {
-                // Unity scene file
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Scene);
-                if (ConvertUnityScene(assetPath, outputPath, settings)) {
-                    AssetInfo info;
-                    info.originalPath = assetPath;
-                    info.nexusPath = outputPath;
-                    info.type = AssetType::Scene;
-                    info.name = GetBaseName(assetPath);
-                    importedAssets_.push_back(info);
-                    Logger::Info("Imported Unity scene: " + info.name);
-                }
-            }
-            else if (extension == ".prefab") {
-                // Unity prefab
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Prefab);
-                if (ParseUnityPrefab(assetPath)) {
-                    AssetInfo info;
-                    info.originalPath = assetPath;
-                    info.nexusPath = outputPath;
-                    info.type = AssetType::Prefab;
-                    info.name = GetBaseName(assetPath);
-                    importedAssets_.push_back(info);
-                    Logger::Info("Imported Unity prefab: " + info.name);
-                }
-            }
-            else if (extension == ".mat") {
-                // Unity material
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Material);
-                if (ConvertUnityMaterial(assetPath, outputPath)) {
-                    AssetInfo info;
-                    info.originalPath = assetPath;
-                    info.nexusPath = outputPath;
-                    info.type = AssetType::Material;
-                    info.name = GetBaseName(assetPath);
-                    importedAssets_.push_back(info);
-                    Logger::Info("Imported Unity material: " + info.name);
-                }
-            }
-            else if (extension == ".cs") {
-                // Unity C# script
-                if (settings.convertScripts) {
-                    std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Script);
-                    if (ConvertUnityScript(assetPath, outputPath, settings)) {
-                        AssetInfo info;
-                        info.originalPath = assetPath;
-                        info.nexusPath = outputPath;
-                        info.type = AssetType::Script;
-                        info.name = GetBaseName(assetPath);
-                        importedAssets_.push_back(info);
-                        Logger::Info("Converted Unity script: " + info.name);
-                    }
-                }
-            }
-            else if (extension == ".fbx" || extension == ".obj" || extension == ".dae") {
-                // 3D models
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Mesh);
-                if (ProcessMeshAsset(assetPath, AssetType::Mesh)) {
-                    CopyAssetFile(assetPath, outputPath);
-                    AssetInfo info;
-                    info.originalPath = assetPath;
-                    info.nexusPath = outputPath;
-                    info.type = AssetType::Mesh;
-                    info.name = GetBaseName(assetPath);
-                    importedAssets_.push_back(info);
-                    Logger::Info("Imported mesh: " + info.name);
-                }
-            }
-            else if (extension == ".png" || extension == ".jpg" || extension == ".tga" || extension == ".exr") {
-                // Textures
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Texture);
-                if (ProcessTextureAsset(assetPath, AssetType::Texture)) {
-                    CopyAssetFile(assetPath, outputPath);
-                    AssetInfo info;
-                    info.originalPath = assetPath;
-                    info.nexusPath = outputPath;
-                    info.type = AssetType::Texture;
-                    info.name = GetBaseName(assetPath);
-                    importedAssets_.push_back(info);
-                    Logger::Info("Imported texture: " + info.name);
-                }
-            }
-            else if (extension == ".wav" || extension == ".mp3" || extension == ".ogg") {
-                // Audio files
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Audio);
-                if (ProcessAudioAsset(assetPath, AssetType::Audio)) {
-                    CopyAssetFile(assetPath, outputPath);
-                    AssetInfo info;
-                    info.originalPath = assetPath;
-                    info.nexusPath = outputPath;
-                    info.type = AssetType::Audio;
-                    info.name = GetBaseName(assetPath);
-                    importedAssets_.push_back(info);
-                    Logger::Info("Imported audio: " + info.name);
-                }
-            }
-        }
-        catch (const std::exception& e) {
-            std::string error = "Failed to import asset " + assetPath + ": " + e.what();
-            importErrors_.push_back(error);
-            Logger::Error(error);
-        }
-    }
+    ImportAssets(assetPaths, [this, &settings](const std::string& assetPath, AssetInfo& info) {
+        return ImportUnityAsset(assetPath, settings, info);
+    });
+    EndIncrementalImport();
 
     if (importErrors_.empty()) {
         result.message = "Unity project imported successfully";
@@ -275,127 +371,389 @@ GameImporter::ImportResult GameImporter::ImportUnityProject(const std::string& p
     return result;
 }
 
+bool GameImporter::ImportUnityAsset(const std::string& assetPath, const ImportSettings& settings, AssetInfo& info) {
+    std::string extension = GetFileExtension(assetPath);
+    info.originalPath = assetPath;
+    info.name = GetBaseName(assetPath);
+
+    if (extension == ".unity") {
+        // Unity scene file
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Scene);
+        info.type = AssetType::Scene;
+        if (!ConvertUnityScene(assetPath, info.nexusPath, settings)) return false;
+        Logger::Info("Imported Unity scene: " + info.name);
+    }
+    else if (extension == ".prefab") {
+        // Unity prefab
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Prefab);
+        info.type = AssetType::Prefab;
+        if (!ParseUnityPrefab(assetPath)) return false;
+        Logger::Info("Imported Unity prefab: " + info.name);
+    }
+    else if (extension == ".mat") {
+        // Unity material
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Material);
+        info.type = AssetType::Material;
+        if (!ConvertUnityMaterial(assetPath, info.nexusPath)) return false;
+        Logger::Info("Imported Unity material: " + info.name);
+    }
+    else if (extension == ".cs") {
+        // Unity C# script
+        if (!settings.convertScripts) return false;
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Script);
+        info.type = AssetType::Script;
+        if (!ConvertUnityScript(assetPath, info.nexusPath, settings)) return false;
+        Logger::Info("Converted Unity script: " + info.name);
+    }
+    else if (extension == ".fbx" || extension == ".obj" || extension == ".dae") {
+        // 3D models
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Mesh);
+        info.type = AssetType::Mesh;
+        if (!ProcessMeshAsset(assetPath, AssetType::Mesh)) return false;
+        CopyAssetFile(assetPath, info.nexusPath);
+        // Bake the optimized .nmesh now so the runtime never parses the source
+        if (extension != ".dae" && !MeshImporter::BuildCache(info.nexusPath)) {
+            Logger::Warning("Mesh will be imported at load time: " + info.nexusPath);
+        }
+        // Level geometry collides as a triangle mesh; its tree is built here, not at load
+        if (settings.bakeCollision && extension != ".dae" && !TriangleMeshCollider::BuildCache(info.nexusPath)) {
+            Logger::Warning("No collision cache for: " + info.nexusPath);
+        }
+        Logger::Info("Imported mesh: " + info.name);
+    }
+    else if (extension == ".png" || extension == ".jpg" || extension == ".tga" || extension == ".exr") {
+        // Textures
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Texture);
+        info.type = AssetType::Texture;
+        if (!ProcessTextureAsset(assetPath, AssetType::Texture)) return false;
+        CopyAssetFile(assetPath, info.nexusPath);
+        Logger::Info("Imported texture: " + info.name);
+    }
+    else if (extension == ".wav" || extension == ".mp3" || extension == ".ogg") {
+        // Audio files
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Audio);
+        info.type = AssetType::Audio;
+        if (!ProcessAudioAsset(assetPath, AssetType::Audio)) return false;
+        CopyAssetFile(assetPath, info.nexusPath);
+        Logger::Info("Imported audio: " + info.name);
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
 GameImporter::ImportResult GameImporter::ImportUnrealProject(const std::string& projectPath, const ImportSettings& settings) {
     ImportResult result;
     result.success = true;
     result.message = "Unreal Engine project import started";
 
     Logger::Info("Importing Unreal Engine project from: " + projectPath);
+    BeginIncrementalImport(projectPath, settings);
 
     // Scan for Unreal assets
     std::vector<std::string> assetPaths = ScanForAssets(projectPath + "/Content", EngineType::UnrealEngine);
     
     Logger::Info("Found " + std::to_string(assetPaths.size()) + " Unreal assets to import");
 
-    for (const std::string& assetPath : assetPaths) {
-        std::string extension = GetFileExtension(assetPath);
-        
-        try {
-            if (extension == ".umap") {
-                // Unreal level file
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Level);
-                if (ConvertUnrealLevel(assetPath, outputPath, settings)) {
-                    AssetInfo info;
-                    info.originalPath = assetPath;
-                    info.nexusPath = outputPath;
-                    info.type = AssetType::Level;
-                    info.name = GetBaseName(assetPath);
-                    importedAssets_.push_back(info);
-                    Logger::Info("Imported Unreal level: " + info.name);
-                }
-            }
-            else if (extension == ".uasset") {
-                // Generic Unreal asset - determine type by content
-                // This could be materials, blueprints, meshes, etc.
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Scene);
-                // Add specific parsing logic based on asset content
-                AssetInfo info;
-                info.originalPath = assetPath;
-                info.nexusPath = outputPath;
-                info.type = AssetType::Scene;
-                info.name = GetBaseName(assetPath);
-                importedAssets_.push_back(info);
-                Logger::Info("Imported Unreal asset: " + info.name);
-            }
-            // Handle other Unreal-specific file types...
-        }
-        catch (const std::exception& e) {
-            std::string error = "Failed to import Unreal asset " + assetPath + ": " + e.what();
-            importErrors_.push_back(error);
-            Logger::Error(error);
-        }
-    }
+    ImportAssets(assetPaths, [this, &settings](const std::string& assetPath, AssetInfo& info) {
+        return ImportUnrealAsset(assetPath, settings, info);
+    });
+    EndIncrementalImport();
 
     result.message = "Unreal Engine project imported";
     return result;
 }
 
+bool GameImporter::ImportUnrealAsset(const std::string& assetPath, const ImportSettings& settings, AssetInfo& info) {
+    std::string extension = GetFileExtension(assetPath);
+    info.originalPath = assetPath;
+    info.name = GetBaseName(assetPath);
+
+    if (extension == ".umap") {
+        // Unreal level file
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Level);
+        info.type = AssetType::Level;
+        if (!ConvertUnrealLevel(assetPath, info.nexusPath, settings)) return false;
+        Logger::Info("Imported Unreal level: " + info.name);
+    }
+    else if (extension == ".uasset") {
+        // Generic Unreal asset - determine type by content
+        // This could be materials, blueprints, meshes, etc.
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Scene);
+        info.type = AssetType::Scene;
+        // Add specific parsing logic based on asset content
+        Logger::Info("Imported Unreal asset: " + info.name);
+    }
+    // Handle other Unreal-specific file types...
+    else {
+        return false;
+    }
+    return true;
+}
+
 GameImporter::ImportResult GameImporter::ImportGodotProject(const std::string& projectPath, const ImportSettings& settings) {
     ImportResult result;
     result.success = true;
     result.message = "Godot project import started";
 
     Logger::Info("Importing Godot project from: " + projectPath);
+    BeginIncrementalImport(projectPath, settings);
 
     // Scan for Godot assets
     std::vector<std::string> assetPaths = ScanForAssets(projectPath, EngineType::Godot);
     
     Logger::Info("Found " + std::to_string(assetPaths.size()) + " Godot assets to import");
 
+    ImportAssets(assetPaths, [this, &settings](const std::string& assetPath, AssetInfo& info) {
+        return ImportGodotAsset(assetPath, settings, info);
+    });
+    EndIncrementalImport();
+
+    result.message = "Godot project imported";
+    return result;
+}
+
+bool GameImporter::ImportGodotAsset(const std::string& assetPath, const ImportSettings& settings, AssetInfo& info) {
+    std::string extension = GetFileExtension(assetPath);
+    info.originalPath = assetPath;
+    info.name = GetBaseName(assetPath);
+
+    if (extension == ".tscn") {
+        // Godot scene file
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Scene);
+        info.type = AssetType::Scene;
+        if (!ConvertGodotScene(assetPath, info.nexusPath, settings)) return false;
+        Logger::Info("Imported Godot scene: " + info.name);
+    }
+    else if (extension == ".gd") {
+        // Godot GDScript
+        if (!settings.convertScripts) return false;
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Script);
+        info.type = AssetType::Script;
+        if (!ConvertGodotScript(assetPath, info.nexusPath, settings)) return false;
+        Logger::Info("Converted Godot script: " + info.name);
+    }
+    else if (extension == ".tres" || extension == ".res") {
+        // Godot resource files
+        info.nexusPath = GetNexusAssetPath(assetPath, AssetType::Material);
+        info.type = AssetType::Material;
+        Logger::Info("Imported Godot resource: " + info.name);
+    }
+    // Handle other Godot-specific file types...
+    else {
+        return false;
+    }
+    return true;
+}
+
+int GameImporter::GetImportStage(const std::string& extension) {
+    // Sources first, then what references them: materials name textures, prefabs name meshes
+    // and materials, and scenes and levels name all of those
+    if (extension == ".mat" || extension == ".tres" || extension == ".res") return 1;
+    if (extension == ".prefab" || extension == ".uasset") return 2;
+    if (extension == ".unity" || extension == ".umap" || extension == ".tscn") return 3;
+    return 0;
+}
+
+void GameImporter::ImportAssets(const std::vector<std::string>& assetPaths, const AssetImportFunction& importAsset) {
+    // Unchanged assets are settled here, on this thread, since the import cache isn't thread safe
+    std::vector<std::string> stages[IMPORT_STAGES];
     for (const std::string& assetPath : assetPaths) {
-        std::string extension = GetFileExtension(assetPath);
-        
-        try {
-            if (extension == ".tscn") {
-                // Godot scene file
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Scene);
-                if (ConvertGodotScene(assetPath, outputPath, settings)) {
-                    AssetInfo info;
-                    info.originalPath = assetPath;
-                    info.nexusPath = outputPath;
-                    info.type = AssetType::Scene;
-                    info.name = GetBaseName(assetPath);
-                    importedAssets_.push_back(info);
-                    Logger::Info("Imported Godot scene: " + info.name);
+        if (ImportFromCache(assetPath)) continue;
+        stages[GetImportStage(GetFileExtension(assetPath))].push_back(assetPath);
+    }
+
+    // Importing runs outside the frame, so it gets workers of its own rather than the engine's
+    const unsigned int threads = currentSettings_.maxThreads > 0 ? currentSettings_.maxThreads
+                                                                   : std::max(1u, std::thread::hardware_concurrency());
+    JobSystem jobs;
+    if (threads > 1) jobs.Initialize(threads - 1);
+    importJobs_ = &jobs;
+    ioSlots_ = std::max(1u, currentSettings_.maxConcurrentIO);
+
+    struct Outcome {
+        AssetInfo info;
+        bool imported = false;
+        std::string error;
+    };
+    for (const std::vector<std::string>& stage : stages) {
+        std::vector<Outcome> outcomes(stage.size());
+        jobs.ParallelFor(stage.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                try {
+                    outcomes[i].imported = importAsset(stage[i], outcomes[i].info);
                 }
-            }
-            else if (extension == ".gd") {
-                // Godot GDScript
-                if (settings.convertScripts) {
-                    std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Script);
-                    if (ConvertGodotScript(assetPath, outputPath, settings)) {
-                        AssetInfo info;
-                        info.originalPath = assetPath;
-                        info.nexusPath = outputPath;
-                        info.type = AssetType::Script;
-                        info.name = GetBaseName(assetPath);
-                        importedAssets_.push_back(info);
-                        Logger::Info("Converted Godot script: " + info.name);
-                    }
+                catch (const std::exception& e) {
+                    outcomes[i].error = "Failed to import asset " + stage[i] + ": " + e.what();
                 }
             }
-            else if (extension == ".tres" || extension == ".res") {
-                // Godot resource files
-                std::string outputPath = GetNexusAssetPath(assetPath, AssetType::Material);
-                AssetInfo info;
-                info.originalPath = assetPath;
-                info.nexusPath = outputPath;
-                info.type = AssetType::Material;
-                info.name = GetBaseName(assetPath);
-                importedAssets_.push_back(info);
-                Logger::Info("Imported Godot resource: " + info.name);
+        });
+
+        // Collected in scan order, so results don't depend on how the stage was scheduled
+        for (size_t i = 0; i < stage.size(); ++i) {
+            if (!outcomes[i].error.empty()) {
+                importErrors_.push_back(outcomes[i].error);
+                Logger::Error(outcomes[i].error);
+            } else if (outcomes[i].imported) {
+                importedAssets_.push_back(std::move(outcomes[i].info));
+                CacheImport(stage[i], importedAssets_.back());
             }
-            // Handle other Godot-specific file types...
         }
-        catch (const std::exception& e) {
-            std::string error = "Failed to import Godot asset " + assetPath + ": " + e.what();
-            importErrors_.push_back(error);
-            Logger::Error(error);
+    }
+    importJobs_ = nullptr;
+    jobs.Shutdown();
+}
+
+GameImporter::IOScope::IOScope(GameImporter& importer) : importer_(importer) {
+    std::unique_lock<std::mutex> lock(importer_.ioMutex_);
+    importer_.ioCondition_.wait(lock, [this]() { return importer_.ioSlots_ > 0; });
+    --importer_.ioSlots_;
+}
+
+GameImporter::IOScope::~IOScope() {
+    {
+        std::lock_guard<std::mutex> lock(importer_.ioMutex_);
+        ++importer_.ioSlots_;
+    }
+    importer_.ioCondition_.notify_one();
+}
+
+void GameImporter::BeginIncrementalImport(const std::string& projectPath, const ImportSettings& settings) {
+    currentSettings_ = settings;
+    projectPath_ = projectPath;
+    unityGuids_.clear();
+    unityGuidsScanned_ = false;
+    cachedAssets_ = 0;
+    cache_.reset();
+    if (!settings.incremental) return;
+
+    cache_ = std::make_unique<ImportCache>();
+    cache_->Open(projectPath, settings.outputDirectory, settings.sharedCacheDirectory, DescribeSettings(settings));
+}
+
+void GameImporter::EndIncrementalImport() {
+    if (!cache_) return;
+    cache_->Save();
+    cache_.reset();
+    if (cachedAssets_ > 0) {
+        Logger::Info(std::to_string(cachedAssets_) + " assets unchanged since the last import, skipped");
+    }
+}
+
+bool GameImporter::ImportFromCache(const std::string& assetPath) {
+    if (!cache_) return false;
+    const uint64_t key = cache_->ComputeKey(assetPath, [this](const std::string& source) { return ScanDependencies(source); });
+    const ImportCache::Entry* entry = cache_->Find(assetPath, key);
+    if (!entry) return false;
+
+    AssetInfo info;
+    info.originalPath = assetPath;
+    info.nexusPath = currentSettings_.outputDirectory + entry->asset;
+    info.type = static_cast<AssetType>(entry->assetType);
+    info.name = GetBaseName(assetPath);
+    info.dependencies = entry->dependencies;
+    info.metadata["cached"] = "true";
+    importedAssets_.push_back(info);
+    ++cachedAssets_;
+    return true;
+}
+
+void GameImporter::CacheImport(const std::string& assetPath, AssetInfo& info) {
+    // Only successful imports are recorded; failed or skipped ones are retried next time
+    if (!cache_) return;
+
+    const fs::path outputDirectory = fs::path(currentSettings_.outputDirectory).lexically_normal();
+    std::vector<std::string> outputs;
+    auto addOutput = [&](const std::string& path) {
+        std::error_code error;
+        if (fs::is_regular_file(path, error)) {
+            outputs.push_back(fs::path(path).lexically_normal().lexically_relative(outputDirectory).generic_string());
         }
+    };
+    addOutput(info.nexusPath);
+    if (info.type == AssetType::Mesh) {
+        addOutput(MeshImporter::GetCachePath(info.nexusPath));
+        addOutput(TriangleMeshCollider::GetCachePath(info.nexusPath));
     }
 
-    result.message = "Godot project imported";
-    return result;
+    // Keyed before converting; the key is remembered for the run
+    const uint64_t key = cache_->ComputeKey(assetPath, nullptr);
+    const std::string asset = fs::path(info.nexusPath).lexically_normal().lexically_relative(outputDirectory).generic_string();
+    cache_->Store(assetPath, key, static_cast<uint32_t>(info.type), asset, outputs);
+    if (const ImportCache::Entry* entry = cache_->Find(assetPath, key)) {
+        info.dependencies = entry->dependencies;
+    }
+}
+
+std::vector<std::string> GameImporter::ScanDependencies(const std::string& assetPath) {
+    std::vector<std::string> dependencies;
+    const std::string extension = GetFileExtension(assetPath);
+
+    if (extension == ".tscn" || extension == ".tres") {
+        // [ext_resource path="res://textures/stone.png" ...]
+        const std::string text = ReadText(assetPath);
+        const std::string marker = "path=\"res://";
+        for (size_t at = text.find(marker); at != std::string::npos; at = text.find(marker, at)) {
+            at += marker.size();
+            const size_t end = text.find('"', at);
+            if (end == std::string::npos) break;
+            dependencies.push_back(projectPath_ + "/" + text.substr(at, end - at));
+        }
+    } else if (extension == ".unity" || extension == ".prefab" || extension == ".mat") {
+        // {fileID: 2800000, guid: 0123456789abcdef0123456789abcdef, type: 3}
+        const std::string text = ReadText(assetPath);
+        const std::string marker = "guid: ";
+        for (size_t at = text.find(marker); at != std::string::npos; at = text.find(marker, at)) {
+            at += marker.size();
+            size_t end = at;
+            while (end < text.size() && IsHexDigit(text[end])) ++end;
+            if (end - at != 32) continue;
+            if (!unityGuidsScanned_) ScanUnityGuids();
+            auto it = unityGuids_.find(text.substr(at, end - at));
+            if (it != unityGuids_.end()) dependencies.push_back(it->second);
+        }
+    } else if (extension == ".umap" || extension == ".uasset") {
+        // Packages name what they import in their name table: "/Game/Props/Rock.Rock"
+        const std::string data = ReadText(assetPath);
+        const std::string marker = "/Game/";
+        for (size_t at = data.find(marker); at != std::string::npos; at = data.find(marker, at)) {
+            at += marker.size();
+            size_t end = at;
+            while (end < data.size() && (std::isalnum(static_cast<unsigned char>(data[end])) || data[end] == '_' ||
+                                         data[end] == '-' || data[end] == '/')) {
+                ++end;
+            }
+            const std::string package = projectPath_ + "/Content/" + data.substr(at, end - at);
+            std::error_code error;
+            if (fs::is_regular_file(package + ".uasset", error)) {
+                dependencies.push_back(package + ".uasset");
+            } else if (fs::is_regular_file(package + ".umap", error)) {
+                dependencies.push_back(package + ".umap");
+            }
+        }
+    }
+    return dependencies;
+}
+
+void GameImporter::ScanUnityGuids() {
+    // Only when a changed scene, prefab or material needs its references resolved
+    unityGuidsScanned_ = true;
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(projectPath_ + "/Assets", error), end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file(error) || it->path().extension() != ".meta") continue;
+
+        std::ifstream file(it->path());
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, 6, "guid: ") == 0) {
+                std::string asset = it->path().string();
+                asset.resize(asset.size() - 5);
+                unityGuids_[line.substr(6, 32)] = asset;
+                break;
+            }
+        }
+    }
 }
 
 std::vector<std::string> GameImporter::ScanForAssets(const std::string& directory, EngineType engineType) {
@@ -499,6 +857,7 @@ std::string GameImporter::GetBaseName(const std::string& path) {
 }
 
 bool GameImporter::CopyAssetFile(const std::string& sourcePath, const std::string& destinationPath) {
+    IOScope io(*this);
     try {
         fs::create_directories(fs::path(destinationPath).parent_path());
         fs::copy_file(sourcePath, destinationPath, fs::copy_options::overwrite_existing);
@@ -513,8 +872,37 @@ bool GameImporter::CopyAssetFile(const std::string& sourcePath, const std::strin
 // Placeholder implementations for conversion functions
 bool GameImporter::ConvertUnityScene(const std::string& sceneFile, const std::string& outputPath, const ImportSettings& settings) {
     Logger::Info("Converting Unity scene: " + sceneFile);
-    // TODO: Implement Unity scene parsing and conversion
-    return true;
+    std::vector<UnityImporter::UnityGameObject> gameObjects;
+    if (!UnityImporter::ParseSceneFile(sceneFile, gameObjects, importJobs_)) return false;
+
+    // Flattened depth first, so parents precede children. Unity units are meters, like ours,
+    // apart from the import scale
+    std::vector<SceneFile::Node> nodes;
+    std::vector<std::pair<const UnityImporter::UnityGameObject*, int32_t>> pending;
+    for (auto it = gameObjects.rbegin(); it != gameObjects.rend(); ++it) pending.emplace_back(&*it, -1);
+    while (!pending.empty()) {
+        auto [object, parent] = pending.back();
+        pending.pop_back();
+
+        SceneFile::Node node;
+        node.name = object->name;
+        node.parent = parent;
+        node.position = XMFLOAT3(object->position.x * settings.scaleMultiplier,
+                                 object->position.y * settings.scaleMultiplier,
+                                 object->position.z * settings.scaleMultiplier);
+        XMStoreFloat4(&node.rotation, XMQuaternionRotationRollPitchYaw(XMConvertToRadians(object->rotation.x),
+                                                                       XMConvertToRadians(object->rotation.y),
+                                                                       XMConvertToRadians(object->rotation.z)));
+        node.scale = object->scale;
+        node.components = object->components;
+        nodes.push_back(std::move(node));
+
+        const int32_t index = static_cast<int32_t>(nodes.size() - 1);
+        for (auto it = object->children.rbegin(); it != object->children.rend(); ++it) {
+            if (*it) pending.emplace_back(it->get(), index);
+        }
+    }
+    return SceneFile::Write(outputPath, nodes);
 }
 
 bool GameImporter::ConvertUnrealLevel(const std::string& levelFile, const std::string& outputPath, const ImportSettings& settings) {
@@ -550,15 +938,17 @@ bool GameImporter::ConvertGodotMaterial(const std::string& materialFile, const s
 bool GameImporter::ConvertUnityScript(const std::string& scriptFile, const std::string& outputPath, const ImportSettings& settings) {
     Logger::Info("Converting Unity script: " + scriptFile);
     
-    std::ifstream file(scriptFile);
-    if (!file.is_open()) {
-        Logger::Error("Failed to open Unity script file: " + scriptFile);
-        return false;
+    std::string content;
+    {
+        IOScope io(*this);
+        std::ifstream file(scriptFile);
+        if (!file.is_open()) {
+            Logger::Error("Failed to open Unity script file: " + scriptFile);
+            return false;
+        }
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
     }
     
-    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    file.close();
-    
     std::string convertedCode;
     if (settings.scriptLanguage == "lua") {
         convertedCode = UnityImporter::ConvertCSharpToLua(content);
@@ -569,6 +959,7 @@ bool GameImporter::ConvertUnityScript(const std::string& scriptFile, const std::
         convertedCode = "// Converted from Unity C# script\n// Original: " + scriptFile + "\n\n" + content;
     }
     
+    IOScope io(*this);
     std::ofstream outFile(outputPath);
     if (outFile.is_open()) {
         outFile << convertedCode;
@@ -588,15 +979,17 @@ bool GameImporter::ConvertUnrealBlueprint(const std::string& blueprintFile, cons
 bool GameImporter::ConvertGodotScript(const std::string& scriptFile, const std::string& outputPath, const ImportSettings& settings) {
     Logger::Info("Converting Godot script: " + scriptFile);
     
-    std::ifstream file(scriptFile);
-    if (!file.is_open()) {
-        Logger::Error("Failed to open Godot script file: " + scriptFile);
-        return false;
+    std::string content;
+    {
+        IOScope io(*this);
+        std::ifstream file(scriptFile);
+        if (!file.is_open()) {
+            Logger::Error("Failed to open Godot script file: " + scriptFile);
+            return false;
+        }
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
     }
     
-    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    file.close();
-    
     std::string convertedCode;
     if (settings.scriptLanguage == "lua") {
         convertedCode = GodotImporter::ConvertGDScriptToLua(content);
@@ -607,6 +1000,7 @@ bool GameImporter::ConvertGodotScript(const std::string& scriptFile, const std::
         convertedCode = "# Converted from Godot GDScript\n# Original: " + scriptFile + "\n\n" + content;
     }
     
+    IOScope io(*this);
     std::ofstream outFile(outputPath);
     if (outFile.is_open()) {
         outFile << convertedCode;
@@ -641,13 +1035,87 @@ bool GameImporter::ProcessAnimationAsset(const std::string& animationFile, Asset
     return true;
 }
 
+bool GameImporter::ParseUnityScene(const std::string& sceneFile) {
+    Logger::Info("Parsing Unity scene: " + sceneFile);
+    std::vector<UnityImporter::UnityGameObject> gameObjects;
+    return UnityImporter::ParseSceneFile(sceneFile, gameObjects, importJobs_);
+}
+
 bool GameImporter::ParseUnityPrefab(const std::string& prefabFile) {
     Logger::Info("Parsing Unity prefab: " + prefabFile);
-    // TODO: Implement Unity prefab parsing
+    UnityImporter::UnityGameObject prefab;
+    return UnityImporter::ParsePrefabFile(prefabFile, prefab, importJobs_);
+}
+
+bool GameImporter::ConvertUnityTransform(std::string_view unityTransform, XMFLOAT3& position, XMFLOAT3& rotation, XMFLOAT3& scale) {
+    if (!UnityImporter::ParseTransform(unityTransform, position, rotation, scale)) return false;
+    position.x *= currentSettings_.scaleMultiplier;
+    position.y *= currentSettings_.scaleMultiplier;
+    position.z *= currentSettings_.scaleMultiplier;
     return true;
 }
 
 // Unity Importer Implementation
+bool UnityImporter::ParseSceneFile(const std::string& sceneFile, std::vector<UnityGameObject>& gameObjects, JobSystem* jobs) {
+    std::vector<std::shared_ptr<UnityGameObject>> roots;
+    if (!ParseUnityHierarchy(sceneFile, roots, jobs)) return false;
+
+    gameObjects.clear();
+    gameObjects.reserve(roots.size());
+    for (const auto& root : roots) gameObjects.push_back(*root);
+    Logger::Info("Parsed Unity scene " + sceneFile + ": " + std::to_string(CountUnityObjects(roots)) + " objects, " +
+                 std::to_string(roots.size()) + " roots");
+    return true;
+}
+
+bool UnityImporter::ParsePrefabFile(const std::string& prefabFile, UnityGameObject& prefab, JobSystem* jobs) {
+    std::vector<std::shared_ptr<UnityGameObject>> roots;
+    if (!ParseUnityHierarchy(prefabFile, roots, jobs)) return false;
+    if (roots.empty()) {
+        Logger::Error("Unity prefab has no root object: " + prefabFile);
+        return false;
+    }
+    if (roots.size() > 1) Logger::Warning("Unity prefab has several root objects, using the first: " + prefabFile);
+    prefab = *roots.front();
+    return true;
+}
+
+bool UnityImporter::ParseTransform(std::string_view transform, XMFLOAT3& position, XMFLOAT3& rotation, XMFLOAT3& scale) {
+    UnityObjectRecord record;
+    ReadUnityObject(UNITY_TRANSFORM, transform, record);
+    position = record.position;
+    rotation = record.rotation;
+    scale = record.scale;
+    return true;
+}
+
+TransformHierarchy::NodeID UnityImporter::AddToHierarchy(const UnityGameObject& object, TransformHierarchy& hierarchy,
+                                                         TransformHierarchy::NodeID parent, float positionScale) {
+    // Explicit stack, imported hierarchies can be deeper than the call stack likes
+    std::vector<std::pair<const UnityGameObject*, TransformHierarchy::NodeID>> pending;
+    pending.emplace_back(&object, parent);
+    TransformHierarchy::NodeID root = TransformHierarchy::INVALID_NODE;
+    while (!pending.empty()) {
+        auto [current, currentParent] = pending.back();
+        pending.pop_back();
+
+        // Unity applies Euler angles Z, then X, then Y, as RollPitchYaw does
+        XMFLOAT4 rotation;
+        XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(XMConvertToRadians(current->rotation.x),
+                                                                  XMConvertToRadians(current->rotation.y),
+                                                                  XMConvertToRadians(current->rotation.z)));
+        XMFLOAT3 position(current->position.x * positionScale, current->position.y * positionScale,
+                          current->position.z * positionScale);
+        TransformHierarchy::NodeID node = hierarchy.Create(currentParent, position, rotation, current->scale);
+        if (root == TransformHierarchy::INVALID_NODE) root = node;
+
+        for (auto it = current->children.rbegin(); it != current->children.rend(); ++it) {
+            if (*it) pending.emplace_back(it->get(), node);
+        }
+    }
+    return root;
+}
+
 std::string UnityImporter::ConvertCSharpToLua(const std::string& csharpCode) {
     std::string luaCode = "-- Converted from C# Unity script\n\n";
     
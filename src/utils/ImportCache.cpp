@@ -0,0 +1,348 @@
+#include "ImportCache.h"
+#include "AtomicFile.h"
+#include "MappedFile.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace Nexus {
+
+namespace {
+constexpr const char* DATABASE_NAME = "import_cache.txt";
+constexpr const char* MANIFEST_NAME = "manifest.txt";
+constexpr const char* DATABASE_MAGIC = "NXIC";
+constexpr uint64_t PRIME = 1099511628211ull;
+
+// FNV-1a; each field is terminated so ("ab", "c") and ("a", "bc") hash differently
+void HashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= PRIME;
+    }
+    unsigned char terminator = 0;
+    hash ^= terminator;
+    hash *= PRIME;
+}
+
+void HashValue(uint64_t& hash, uint64_t value) {
+    HashBytes(hash, &value, sizeof(value));
+}
+
+void HashString(uint64_t& hash, const std::string& text) {
+    HashBytes(hash, text.data(), text.size());
+}
+
+bool GetFileStamp(const std::string& path, uint64_t& size, int64_t& writeTime) {
+    std::error_code error;
+    size = fs::file_size(path, error);
+    if (error) return false;
+    writeTime = static_cast<int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+    return !error;
+}
+
+std::string ToHex(uint64_t value) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+}
+
+uint64_t ImportCache::HashFile(const std::string& path, bool& ok) {
+    // Eight bytes a step: large sources are read at memory speed rather than FNV's byte a cycle
+    uint64_t hash = 14695981039346656037ull;
+    std::error_code error;
+    const uint64_t size = fs::file_size(path, error);
+    ok = !error;
+    if (!ok || size == 0) return hash;
+
+    MappedFile file;
+    ok = file.Open(path);
+    if (!ok) return hash;
+    const uint8_t* data = file.GetData();
+    const size_t length = file.GetSize();
+    size_t offset = 0;
+    for (; offset + sizeof(uint64_t) <= length; offset += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + offset, sizeof(word));
+        hash = (hash ^ word) * PRIME;
+        hash ^= hash >> 29;
+    }
+    HashBytes(hash, data + offset, length - offset);
+    HashValue(hash, length);
+    return hash;
+}
+
+bool ImportCache::Open(const std::string& projectRoot, const std::string& outputDirectory,
+                       const std::string& sharedDirectory, const std::string& settings) {
+    Close();
+    projectRoot_ = projectRoot;
+    outputDirectory_ = outputDirectory;
+    sharedDirectory_ = sharedDirectory;
+    settingsHash_ = 14695981039346656037ull;
+    HashString(settingsHash_, settings);
+    open_ = true;
+
+    if (!sharedDirectory_.empty()) {
+        std::error_code error;
+        fs::create_directories(sharedDirectory_, error);
+        if (error) {
+            Logger::Warning("Shared import cache unavailable (" + sharedDirectory_ + "), using the local one only");
+            sharedDirectory_.clear();
+        }
+    }
+
+    std::ifstream file((fs::path(outputDirectory_) / DATABASE_NAME).string());
+    if (!file) return true;
+
+    std::string line;
+    if (!std::getline(file, line) || line != std::string(DATABASE_MAGIC) + " " + std::to_string(CONVERTER_VERSION)) {
+        Logger::Info("Import cache is from another converter version, importing everything");
+        return true;
+    }
+
+    Entry* entry = nullptr;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string tag;
+        std::getline(fields, tag, '\t');
+        if (tag == "S") {
+            std::string source, scanned, assetType;
+            Entry loaded;
+            std::getline(fields, source, '\t');
+            fields >> loaded.size >> loaded.writeTime >> std::hex >> loaded.contentHash >> loaded.key >> std::dec >>
+                scanned >> assetType;
+            fields.get();
+            std::getline(fields, loaded.asset);
+            if (!fields && !fields.eof()) {
+                entry = nullptr;
+                continue;
+            }
+            loaded.dependenciesScanned = scanned == "1";
+            loaded.assetType = static_cast<uint32_t>(std::strtoul(assetType.c_str(), nullptr, 10));
+            entry = &(entries_[source] = std::move(loaded));
+        } else if (entry && tag == "D") {
+            std::string dependency;
+            std::getline(fields, dependency);
+            entry->dependencies.push_back(std::move(dependency));
+        } else if (entry && tag == "O") {
+            std::string output;
+            std::getline(fields, output);
+            entry->outputs.push_back(std::move(output));
+        }
+    }
+    Logger::Info("Import cache: " + std::to_string(entries_.size()) + " entries");
+    return true;
+}
+
+bool ImportCache::Save() {
+    if (!open_) return false;
+
+    const fs::path path = fs::path(outputDirectory_) / DATABASE_NAME;
+    bool written = WriteFileAtomic(path.string(), [&](std::ostream& file) {
+        file << DATABASE_MAGIC << ' ' << CONVERTER_VERSION << '\n';
+        for (const auto& pair : entries_) {
+            const Entry& entry = pair.second;
+            std::error_code error;
+            if (!fs::is_regular_file(fs::path(projectRoot_) / pair.first, error)) continue;
+
+            file << "S\t" << pair.first << '\t' << entry.size << ' ' << entry.writeTime << ' ' << ToHex(entry.contentHash)
+                 << ' ' << ToHex(entry.key) << ' ' << (entry.dependenciesScanned ? 1 : 0) << ' ' << entry.assetType << '\t'
+                 << entry.asset << '\n';
+            for (const std::string& dependency : entry.dependencies) file << "D\t" << dependency << '\n';
+            for (const std::string& output : entry.outputs) file << "O\t" << output << '\n';
+        }
+    }, std::ios::out);
+    if (!written) {
+        Logger::Error("Could not write import cache: " + path.string());
+        return false;
+    }
+    return true;
+}
+
+void ImportCache::Close() {
+    entries_.clear();
+    keys_.clear();
+    open_ = false;
+}
+
+std::string ImportCache::GetRelativePath(const std::string& source) const {
+    // Lexical, so nothing is looked up on disk; scanned paths all start with the project root
+    fs::path relative = fs::path(source).lexically_normal().lexically_relative(fs::path(projectRoot_).lexically_normal());
+    if (relative.empty() || *relative.begin() == "..") relative = fs::path(source).lexically_normal();
+    return relative.generic_string();
+}
+
+ImportCache::Entry* ImportCache::Refresh(const std::string& relative) {
+    const std::string path = (fs::path(projectRoot_) / relative).string();
+    uint64_t size = 0;
+    int64_t writeTime = 0;
+    if (!GetFileStamp(path, size, writeTime)) return nullptr;
+
+    Entry& entry = entries_[relative];
+    if (entry.size != size || entry.writeTime != writeTime || entry.contentHash == 0) {
+        bool ok = false;
+        const uint64_t contentHash = HashFile(path, ok);
+        if (!ok) return nullptr;
+        if (contentHash != entry.contentHash) {
+            entry.contentHash = contentHash;
+            entry.dependenciesScanned = false;
+            entry.dependencies.clear();
+        }
+        entry.size = size;
+        entry.writeTime = writeTime;
+    }
+    return &entry;
+}
+
+uint64_t ImportCache::ComputeKey(const std::string& source, const DependencyScanner& scan) {
+    if (!open_) return 0;
+    std::unordered_map<std::string, uint64_t> visiting;
+    return ComputeKey(GetRelativePath(source), scan, visiting);
+}
+
+uint64_t ImportCache::ComputeKey(const std::string& relative, const DependencyScanner& scan,
+                                 std::unordered_map<std::string, uint64_t>& visiting) {
+    auto known = keys_.find(relative);
+    if (known != keys_.end()) return known->second;
+
+    Entry* entry = Refresh(relative);
+    if (!entry) return 0;
+    // A cycle stands in for itself with its contents alone
+    auto cycle = visiting.find(relative);
+    if (cycle != visiting.end()) return cycle->second;
+    visiting[relative] = entry->contentHash;
+
+    if (!entry->dependenciesScanned && scan) {
+        std::vector<std::string> dependencies;
+        for (const std::string& dependency : scan((fs::path(projectRoot_) / relative).string())) {
+            std::string name = GetRelativePath(dependency);
+            if (name != relative) dependencies.push_back(std::move(name));
+        }
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+        entry->dependencies = std::move(dependencies);
+        entry->dependenciesScanned = true;
+    }
+
+    uint64_t key = 14695981039346656037ull;
+    HashValue(key, entry->contentHash);
+    HashValue(key, settingsHash_);
+    HashValue(key, CONVERTER_VERSION);
+    HashString(key, relative);
+    for (const std::string& dependency : entry->dependencies) {
+        HashString(key, dependency);
+        HashValue(key, ComputeKey(dependency, scan, visiting));
+    }
+    if (key == 0) key = 1;
+
+    visiting.erase(relative);
+    keys_[relative] = key;
+    return key;
+}
+
+const ImportCache::Entry* ImportCache::Find(const std::string& source, uint64_t key) {
+    if (!open_ || key == 0) return nullptr;
+    auto it = entries_.find(GetRelativePath(source));
+    if (it == entries_.end()) return nullptr;
+    Entry& entry = it->second;
+
+    if (entry.key == key) {
+        bool present = true;
+        for (const std::string& output : entry.outputs) {
+            std::error_code error;
+            if (!fs::is_regular_file(fs::path(outputDirectory_) / output, error)) {
+                present = false;
+                break;
+            }
+        }
+        if (present) return &entry;
+    }
+    return Fetch(key, entry) ? &entry : nullptr;
+}
+
+void ImportCache::Store(const std::string& source, uint64_t key, uint32_t assetType, const std::string& asset,
+                        const std::vector<std::string>& outputs) {
+    if (!open_ || key == 0) return;
+    auto it = entries_.find(GetRelativePath(source));
+    if (it == entries_.end()) return;
+
+    Entry& entry = it->second;
+    entry.key = key;
+    entry.assetType = assetType;
+    entry.asset = asset;
+    entry.outputs = outputs;
+    Publish(key, entry);
+}
+
+std::string ImportCache::GetSharedPath(uint64_t key) const {
+    return (fs::path(sharedDirectory_) / ToHex(key)).string();
+}
+
+bool ImportCache::Fetch(uint64_t key, Entry& entry) {
+    if (sharedDirectory_.empty()) return false;
+    const fs::path directory = GetSharedPath(key);
+    std::ifstream manifest((directory / MANIFEST_NAME).string());
+    if (!manifest) return false;
+
+    std::string assetType, asset, output;
+    std::vector<std::string> outputs;
+    if (!std::getline(manifest, assetType) || !std::getline(manifest, asset)) return false;
+    while (std::getline(manifest, output)) {
+        if (!output.empty()) outputs.push_back(output);
+    }
+
+    for (const std::string& name : outputs) {
+        std::error_code error;
+        const fs::path destination = fs::path(outputDirectory_) / name;
+        fs::create_directories(destination.parent_path(), error);
+        fs::copy_file(directory / name, destination, fs::copy_options::overwrite_existing, error);
+        if (error) {
+            Logger::Warning("Could not restore " + name + " from the shared import cache");
+            return false;
+        }
+    }
+
+    entry.key = key;
+    entry.assetType = static_cast<uint32_t>(std::strtoul(assetType.c_str(), nullptr, 10));
+    entry.asset = asset;
+    entry.outputs = std::move(outputs);
+    return true;
+}
+
+void ImportCache::Publish(uint64_t key, const Entry& entry) {
+    if (sharedDirectory_.empty()) return;
+    const fs::path directory = GetSharedPath(key);
+    std::error_code error;
+    if (fs::exists(directory, error)) return;
+
+    // Filled under a name of our own and renamed, so readers only ever see a whole entry; when
+    // another machine gets there first its copy stands
+    const uint64_t stamp = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    const fs::path temporary = directory.string() + ".tmp" + ToHex(stamp);
+    fs::create_directories(temporary, error);
+    bool ok = !error;
+    for (size_t i = 0; ok && i < entry.outputs.size(); ++i) {
+        const fs::path destination = temporary / entry.outputs[i];
+        fs::create_directories(destination.parent_path(), error);
+        fs::copy_file(fs::path(outputDirectory_) / entry.outputs[i], destination, fs::copy_options::overwrite_existing, error);
+        ok = !error;
+    }
+    if (ok) {
+        std::ofstream manifest((temporary / MANIFEST_NAME).string(), std::ios::trunc);
+        manifest << entry.assetType << '\n' << entry.asset << '\n';
+        for (const std::string& output : entry.outputs) manifest << output << '\n';
+        ok = static_cast<bool>(manifest);
+    }
+    if (ok) fs::rename(temporary, directory, error);
+    if (!ok || error) fs::remove_all(temporary, error);
+}
+
+} // namespace Nexus
@@ -1,34 +1,308 @@
 #include "Logger.h"
+#include <algorithm>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
 
 namespace Nexus {
 
 std::unique_ptr<std::ofstream> Logger::logFile_ = nullptr;
-LogLevel Logger::logLevel_ = LogLevel::Info;
-bool Logger::consoleOutput_ = true;
+std::atomic<LogLevel> Logger::logLevel_{ LogLevel::Info };
+std::atomic<bool> Logger::consoleOutput_{ true };
+std::atomic<LogFlushPolicy> Logger::flushPolicy_{ LogFlushPolicy::OnError };
+std::atomic<int> Logger::flushIntervalMs_{ 1000 };
 bool Logger::initialized_ = false;
 
+namespace {
+constexpr size_t RING_SIZE = 4096;             // Power of two
+// How often the writer drains the ring unwoken; producers only wake it to flush
+constexpr std::chrono::milliseconds DRAIN_INTERVAL(10);
+constexpr const char* TRUNCATED = " [...]";
+
+// Guards the log file and, while there is no writer, the console
+std::mutex g_logMutex;
+// False once the writer has been destroyed at exit; later messages are written in place
+std::atomic<bool> g_writerAlive{ true };
+
+struct LogRecord {
+    std::atomic<uint64_t> sequence;            // Ring position it is free for, or that + 1 once filled
+    LogLevel level;
+    int64_t timeMs;                            // System clock
+    uint32_t length;
+    char text[Logger::MAX_MESSAGE_LENGTH];
+};
+
+// "[12:34:56.789] [INFO] " for a system clock time; localtime() is only called from one thread
+// at a time, and only when the second changes
+void AppendPrefix(std::string& out, int64_t timeMs, int64_t& cachedSecond, char (&cachedClock)[16]) {
+    const int64_t second = timeMs / 1000;
+    if (second != cachedSecond) {
+        const std::time_t time = static_cast<std::time_t>(second);
+        std::strftime(cachedClock, sizeof(cachedClock), "%H:%M:%S", std::localtime(&time));
+        cachedSecond = second;
+    }
+    char prefix[32];
+    std::snprintf(prefix, sizeof(prefix), "[%s.%03d] [", cachedClock, static_cast<int>(timeMs % 1000));
+    out += prefix;
+}
+
+int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+}
+
+/**
+ * The ring and the thread draining it. A bounded multi-producer queue after Vyukov: producers
+ * claim a position with one compare-exchange and publish the record through its sequence number,
+ * so they never wait on each other or on the writer.
+ */
+class LogWriter {
+public:
+    LogWriter()
+        : records_(new LogRecord[RING_SIZE])
+        , enqueuePosition_(0)
+        , dequeuePosition_(0)
+        , flushedPosition_(0)
+        , flushTarget_(0)
+        , dropped_(0)
+        , wakeRequested_(false)
+        , stopRequested_(false)
+        , lastFlush_(std::chrono::steady_clock::now())
+        , cachedSecond_(-1)
+    {
+        for (size_t i = 0; i < RING_SIZE; ++i) records_[i].sequence.store(i, std::memory_order_relaxed);
+        thread_ = std::thread(&LogWriter::Run, this);
+    }
+
+    ~LogWriter() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stopRequested_ = true;
+        }
+        wakeCondition_.notify_one();
+        thread_.join();
+        g_writerAlive = false;
+    }
+
+    // False when the ring is full
+    bool TryPush(LogLevel level, int64_t timeMs, const std::string& message) {
+        uint64_t position = enqueuePosition_.load(std::memory_order_relaxed);
+        LogRecord* record;
+        for (;;) {
+            record = &records_[position & (RING_SIZE - 1)];
+            const uint64_t sequence = record->sequence.load(std::memory_order_acquire);
+            const int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+
+        record->level = level;
+        record->timeMs = timeMs;
+        size_t length = message.size();
+        if (length > Logger::MAX_MESSAGE_LENGTH) {
+            const size_t kept = Logger::MAX_MESSAGE_LENGTH - std::strlen(TRUNCATED);
+            std::memcpy(record->text, message.data(), kept);
+            std::memcpy(record->text + kept, TRUNCATED, std::strlen(TRUNCATED));
+            length = Logger::MAX_MESSAGE_LENGTH;
+        } else {
+            std::memcpy(record->text, message.data(), length);
+        }
+        record->length = static_cast<uint32_t>(length);
+        record->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    void Push(LogLevel level, const std::string& message) {
+        const int64_t timeMs = NowMs();
+        if (TryPush(level, timeMs, message)) return;
+        if (level != LogLevel::Error && Logger::flushPolicy_ != LogFlushPolicy::Immediate) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // Errors aren't lost: wait for the writer to make room
+        do {
+            Wake();
+            std::this_thread::yield();
+        } while (!TryPush(level, timeMs, message));
+    }
+
+    void Wake() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            wakeRequested_ = true;
+        }
+        wakeCondition_.notify_one();
+    }
+
+    void Flush() {
+        const uint64_t target = enqueuePosition_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        flushTarget_ = std::max(flushTarget_, target);
+        wakeRequested_ = true;
+        wakeCondition_.notify_one();
+        flushedCondition_.wait(lock, [this, target] { return flushedPosition_ >= target; });
+    }
+
+private:
+    void Run() {
+        for (;;) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                wakeCondition_.wait_for(lock, DRAIN_INTERVAL, [this] { return wakeRequested_ || stopRequested_; });
+                wakeRequested_ = false;
+                stopping = stopRequested_;
+            }
+
+            bool flush = WriteBatch() || stopping;
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastFlush_ >= std::chrono::milliseconds(Logger::flushIntervalMs_.load())) flush = true;
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                if (flushTarget_ > flushedPosition_) flush = true;
+            }
+            if (flush) {
+                std::lock_guard<std::mutex> lock(g_logMutex);
+                if (Logger::logFile_ && Logger::logFile_->is_open()) Logger::logFile_->flush();
+                lastFlush_ = now;
+            }
+
+            bool waiting = false;
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                if (flush) flushedPosition_ = dequeuePosition_;
+                // A record claimed but not filled in yet holds back a flush; go round again for it
+                waiting = flushTarget_ > flushedPosition_;
+                if (waiting) wakeRequested_ = true;
+            }
+            flushedCondition_.notify_all();
+
+            // Producers still finishing records are waited for, so nothing logged before exit is lost
+            if (stopping && enqueuePosition_.load(std::memory_order_acquire) == dequeuePosition_) return;
+            if (waiting) std::this_thread::yield();
+        }
+    }
+
+    // Writes what the ring holds; true if it should be flushed now
+    bool WriteBatch() {
+        bool flush = false;
+        const bool console = Logger::consoleOutput_;
+        const LogFlushPolicy policy = Logger::flushPolicy_;
+        file_.clear();
+        console_.clear();
+
+        const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            const std::string note = "Log ring full, dropped " + std::to_string(dropped) + " messages";
+            Append(LogLevel::Warning, NowMs(), note.data(), note.size(), console);
+        }
+
+        for (;;) {
+            LogRecord& record = records_[dequeuePosition_ & (RING_SIZE - 1)];
+            if (record.sequence.load(std::memory_order_acquire) != dequeuePosition_ + 1) break;
+            Append(record.level, record.timeMs, record.text, record.length, console);
+            if (record.level == LogLevel::Error && policy == LogFlushPolicy::OnError) flush = true;
+            record.sequence.store(dequeuePosition_ + RING_SIZE, std::memory_order_release);
+            ++dequeuePosition_;
+        }
+        if (policy == LogFlushPolicy::Immediate && !file_.empty()) flush = true;
+
+        if (!console_.empty()) {
+            std::cout.write(console_.data(), static_cast<std::streamsize>(console_.size()));
+            std::cout.flush();
+        }
+        if (!file_.empty()) {
+            std::lock_guard<std::mutex> lock(g_logMutex);
+            if (Logger::logFile_ && Logger::logFile_->is_open()) {
+                Logger::logFile_->write(file_.data(), static_cast<std::streamsize>(file_.size()));
+            }
+        }
+        return flush;
+    }
+
+    void Append(LogLevel level, int64_t timeMs, const char* text, size_t length, bool console) {
+        const size_t start = file_.size();
+        AppendPrefix(file_, timeMs, cachedSecond_, cachedClock_);
+        file_ += Logger::LogLevelToString(level);
+        file_ += "] ";
+        file_.append(text, length);
+        file_ += '\n';
+        if (!console) return;
+        if (level == LogLevel::Error) {
+            // Errors go to stderr, after whatever came before them
+            std::cout.write(console_.data(), static_cast<std::streamsize>(console_.size()));
+            std::cout.flush();
+            console_.clear();
+            std::cerr.write(file_.data() + start, static_cast<std::streamsize>(file_.size() - start));
+            std::cerr.flush();
+        } else {
+            console_.append(file_, start, std::string::npos);
+        }
+    }
+
+    std::unique_ptr<LogRecord[]> records_;
+    std::atomic<uint64_t> enqueuePosition_;
+    uint64_t dequeuePosition_;                 // Writer thread only
+    uint64_t flushedPosition_;                 // Under wakeMutex_, as is flushTarget_
+    uint64_t flushTarget_;                     // Flush() waits for the file to be flushed up to here
+    std::atomic<uint64_t> dropped_;
+
+    std::thread thread_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    std::condition_variable flushedCondition_;
+    bool wakeRequested_;
+    bool stopRequested_;
+
+    // Writer thread only
+    std::chrono::steady_clock::time_point lastFlush_;
+    std::string file_;
+    std::string console_;
+    int64_t cachedSecond_;
+    char cachedClock_[16] = {};
+};
+
+namespace {
+LogWriter* GetWriter() {
+    if (!g_writerAlive.load(std::memory_order_acquire)) return nullptr;
+    static LogWriter writer;
+    return &writer;
+}
+}
+
 void Logger::Initialize(const std::string& filename) {
-    if (initialized_) return;
-    
-    logFile_ = std::make_unique<std::ofstream>(filename, std::ios::app);
-    if (logFile_->is_open()) {
+    {
+        std::lock_guard<std::mutex> lock(g_logMutex);
+        if (initialized_) return;
+
+        logFile_ = std::make_unique<std::ofstream>(filename, std::ios::app);
+        if (!logFile_->is_open()) return;
         initialized_ = true;
-        Info("Logger initialized - " + filename);
     }
+    Info("Logger initialized - " + filename);
 }
 
 void Logger::Shutdown() {
-    if (initialized_) {
-        Info("Logger shutting down");
-        if (logFile_ && logFile_->is_open()) {
-            logFile_->close();
-        }
-        logFile_.reset();
-        initialized_ = false;
+    if (!initialized_) return;
+    Info("Logger shutting down");
+    Flush();
+
+    std::lock_guard<std::mutex> lock(g_logMutex);
+    if (logFile_ && logFile_->is_open()) {
+        logFile_->close();
     }
+    logFile_.reset();
+    initialized_ = false;
 }
 
 void Logger::Debug(const std::string& message) {
@@ -47,39 +321,98 @@ void Logger::Error(const std::string& message) {
     Log(LogLevel::Error, message);
 }
 
+void Logger::Flush() {
+    if (LogWriter* writer = GetWriter()) writer->Flush();
+}
+
 void Logger::Log(LogLevel level, const std::string& message) {
-    if (level < logLevel_) return;
-    
-    std::string timestamp = GetTimestamp();
-    std::string levelStr = LogLevelToString(level);
-    std::string logMessage = "[" + timestamp + "] [" + levelStr + "] " + message;
-    
-    // Console output
-    if (consoleOutput_) {
-        if (level == LogLevel::Error) {
-            std::cerr << logMessage << std::endl;
-        } else {
-            std::cout << logMessage << std::endl;
+    if (!IsEnabled(level)) return;
+
+    LogWriter* writer = GetWriter();
+    if (writer) {
+        writer->Push(level, message);
+        const LogFlushPolicy policy = flushPolicy_;
+        if (policy == LogFlushPolicy::Immediate || (level == LogLevel::Error && policy == LogFlushPolicy::OnError)) {
+            writer->Flush();
         }
+        return;
+    }
+
+    // Static destruction has taken the writer; the rest is written in place
+    std::lock_guard<std::mutex> lock(g_logMutex);
+    int64_t second = -1;
+    char clock[16] = {};
+    std::string line;
+    AppendPrefix(line, NowMs(), second, clock);
+    line += LogLevelToString(level) + "] " + message + "\n";
+    if (consoleOutput_) {
+        (level == LogLevel::Error ? std::cerr : std::cout) << line << std::flush;
     }
-    
-    // File output
-    if (initialized_ && logFile_ && logFile_->is_open()) {
-        *logFile_ << logMessage << std::endl;
-        logFile_->flush();
+    if (logFile_ && logFile_->is_open()) {
+        *logFile_ << line << std::flush;
     }
 }
 
-std::string Logger::GetTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    return ss.str();
+void Logger::FormatMessage(std::string& out, std::string_view format, const FormatArgument* arguments, size_t count) {
+    size_t next = 0;
+    for (size_t i = 0; i < format.size(); ++i) {
+        const char c = format[i];
+        if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c) {
+            out += c;
+            ++i;
+            continue;
+        }
+        const size_t close = c == '{' ? format.find('}', i) : std::string_view::npos;
+        if (close == std::string_view::npos) {
+            out += c;
+            continue;
+        }
+
+        // "{}" or "{:.N}"
+        int precision = -1;
+        const std::string_view spec = format.substr(i + 1, close - i - 1);
+        if (spec.size() > 2 && spec[0] == ':' && spec[1] == '.') {
+            std::from_chars(spec.data() + 2, spec.data() + spec.size(), precision);
+        }
+        i = close;
+        if (next >= count) {
+            out += "{?}";
+            continue;
+        }
+
+        const FormatArgument& argument = arguments[next++];
+        char number[64];
+        std::to_chars_result result{ number, std::errc() };
+        switch (argument.type) {
+            case FormatArgument::Type::Signed:
+                result = std::to_chars(number, number + sizeof(number), argument.signedValue);
+                break;
+            case FormatArgument::Type::Unsigned:
+                result = std::to_chars(number, number + sizeof(number), argument.unsignedValue);
+                break;
+            case FormatArgument::Type::Double:
+                // snprintf rather than to_chars, which not every standard library has for doubles
+                result.ptr = number + std::max(0, precision >= 0
+                    ? std::snprintf(number, sizeof(number), "%.*f", precision, argument.doubleValue)
+                    : std::snprintf(number, sizeof(number), "%g", argument.doubleValue));
+                break;
+            case FormatArgument::Type::Bool:
+                out += argument.boolValue ? "true" : "false";
+                break;
+            case FormatArgument::Type::Char:
+                out += argument.charValue;
+                break;
+            case FormatArgument::Type::Text:
+                out += argument.text;
+                break;
+            case FormatArgument::Type::Pointer:
+                result.ptr = number + std::max(0, std::snprintf(number, sizeof(number), "%p", argument.pointer));
+                break;
+            case FormatArgument::Type::None:
+                break;
+        }
+        out.append(number, std::min<size_t>(static_cast<size_t>(result.ptr - number), sizeof(number) - 1));
+    }
 }
 
 std::string Logger::LogLevelToString(LogLevel level) {
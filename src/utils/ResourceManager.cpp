@@ -1,34 +1,142 @@
 #include "ResourceManager.h"
 #include "Texture.h"
+#include "TextureStreamingEngine.h"
 #include "Mesh.h"
+#include "ShaderPermutations.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
+#include "TextureFile.h"
+#include "FileWatcher.h"
+#include "MeshImporter.h"
+#include "PakArchive.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <sstream>
 
 namespace Nexus {
 
+namespace {
+constexpr const char* LOAD_ORDER_MAGIC = "NexusLoadOrder";
+constexpr int LOAD_ORDER_VERSION = 1;
+
+bool LoadFromPak(Texture& texture, const PakArchive& pak, const PakEntry& entry, ID3D11Device* device, JobSystem* jobs) {
+    std::vector<uint8_t> buffer;
+    const uint8_t* data = pak.Read(entry, buffer);
+    return data && texture.LoadFromMemory(data, static_cast<size_t>(entry.originalSize), device, pak.GetName(entry), jobs);
+}
+
+bool LoadFromPak(Mesh& mesh, const PakArchive& pak, const PakEntry& entry, ID3D11Device* device) {
+    std::vector<uint8_t> buffer;
+    const uint8_t* data = pak.Read(entry, buffer);
+    return data && mesh.LoadBinary(data, static_cast<size_t>(entry.originalSize), pak.GetName(entry), device);
+}
+
+struct EvictionCandidate {
+    std::string name;
+    uint64_t lastUsedFrame;
+    uint32_t usedFrames;
+    size_t bytes;
+};
+
+// Marks the resources held this frame as used and collects the rest. Returns the bytes resident
+template <typename Entries, typename Pool>
+size_t TrackUsage(Entries& entries, const Pool& pool, uint64_t frame, std::vector<EvictionCandidate>& unused) {
+    size_t bytes = 0;
+    for (auto& entry : entries) {
+        const size_t size = pool.Get(entry.second.handle)->GetMemoryUsage();
+        bytes += size;
+        if (pool.GetRefCount(entry.second.handle) > 0 || pool.GetShared(entry.second.handle).use_count() > 1) {
+            entry.second.lastUsedFrame = frame;
+            ++entry.second.usedFrames;
+        } else {
+            unused.push_back({ entry.first, entry.second.lastUsedFrame, entry.second.usedFrames, size });
+        }
+    }
+    return bytes;
+}
+
+// Unloads unused resources until bytes fits the budget: the longest unused first, and of those
+// unused as long, the least often used. Returns the bytes left
+template <typename Unload>
+size_t Evict(std::vector<EvictionCandidate>& unused, size_t bytes, size_t budget, Unload unload) {
+    if (bytes <= budget) return bytes;
+    std::sort(unused.begin(), unused.end(), [](const EvictionCandidate& a, const EvictionCandidate& b) {
+        return a.lastUsedFrame != b.lastUsedFrame ? a.lastUsedFrame < b.lastUsedFrame : a.usedFrames < b.usedFrames;
+    });
+    for (const EvictionCandidate& candidate : unused) {
+        if (bytes <= budget) break;
+        unload(candidate.name);
+        bytes -= std::min(bytes, candidate.bytes);
+    }
+    return bytes;
+}
+}
+
+template <typename Resource>
+struct ResourceManager::AsyncLoad {
+    std::shared_ptr<Resource> placeholder;     // Handed out, and filled in when published
+    std::shared_ptr<Resource> loaded;          // The loader thread's until done
+    std::string path;                          // Or the name in the pak
+    std::shared_ptr<PakArchive> pak;
+    const PakEntry* entry = nullptr;
+    std::vector<std::function<void(std::shared_ptr<Resource>)>> callbacks;
+    bool succeeded = false;
+    bool done = false;                         // Under loadMutex_
+};
+
 ResourceManager::ResourceManager()
-    : initialized_(false)
-    , memoryUsage_(0)
+    : fileWatcher_(nullptr)
+    , fileListener_(FileWatcher::INVALID_LISTENER)
+    , stopLoader_(false)
+    , recordingLoadOrder_(false)
+    , prefetchNext_(0)
+    , prefetchWindow_(0)
+    , prefetching_(false)
+    , memoryBudgets_()
+    , overBudget_()
+    , streamingBudget_(0)
+    , frame_(0)
+    , initialized_(false)
     , device_(nullptr)
+    , streaming_(nullptr)
+    , jobs_(nullptr)
 {
 }
 
+template <typename Resource>
+void ResourceManager::WaitForLoad(const AsyncLoad<Resource>& load) {
+    NEXUS_PROFILE_SCOPE("ResourceManager::WaitForLoad");
+    std::unique_lock<std::mutex> lock(loadMutex_);
+    doneCondition_.wait(lock, [&load]() { return load.done; });
+}
+
 ResourceManager::~ResourceManager() {
     Shutdown();
 }
 
-bool ResourceManager::Initialize(ID3D11Device* device) {
+bool ResourceManager::Initialize(ID3D11Device* device, TextureStreamingEngine* streaming, JobSystem* jobs) {
+    NEXUS_MEMORY_SCOPE(MemoryTag::Resources);
     if (initialized_) return true;
     
     device_ = device;
+    streaming_ = streaming;
+    jobs_ = jobs;
+    streamingBudget_ = streaming ? streaming->GetMemoryBudget() : 0;
     
     // Add default resource paths
     AddResourcePath("assets");
     AddResourcePath("textures");
     AddResourcePath("meshes");
+    AddResourcePath("shaders");
     AddResourcePath("sounds");
     
+    stopLoader_ = false;
+    loader_ = std::thread(&ResourceManager::LoaderMain, this);
+    
     initialized_ = true;
     Logger::Info("Resource manager initialized");
     return true;
@@ -37,36 +145,102 @@ bool ResourceManager::Initialize(ID3D11Device* device) {
 void ResourceManager::Shutdown() {
     if (!initialized_) return;
     
+    // Loads still queued are dropped and their callbacks never run
+    StopLoader();
+    textureLoads_.clear();
+    meshLoads_.clear();
+    prefetchList_.clear();
+    prefetchNext_ = 0;
+    paks_.clear();
+    
+    EnableHotReload(nullptr);
+    textureFiles_.clear();
+    shaderFiles_.clear();
+    
     // Clear all resources
+    materials_.clear();
+    shaders_.clear();
     textures_.clear();
     meshes_.clear();
+    texturePool_.Clear();
+    meshPool_.Clear();
     
     initialized_ = false;
-    memoryUsage_ = 0;
     device_ = nullptr;
+    streaming_ = nullptr;
+    jobs_ = nullptr;
     Logger::Info("Resource manager shutdown");
 }
 
+void ResourceManager::Update() {
+    ++frame_;
+    UpdatePrefetch();
+    if (textureLoads_.empty() && meshLoads_.empty()) {
+        EnforceMemoryBudgets();
+        return;
+    }
+    NEXUS_PROFILE_SCOPE("ResourceManager::Update");
+    
+    // Collected first: callbacks may request more loads
+    std::vector<std::pair<std::string, std::shared_ptr<TextureLoad>>> textures;
+    std::vector<std::pair<std::string, std::shared_ptr<MeshLoad>>> meshes;
+    {
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        for (const auto& load : textureLoads_) {
+            if (load.second->done) textures.push_back(load);
+        }
+        for (const auto& load : meshLoads_) {
+            if (load.second->done) meshes.push_back(load);
+        }
+    }
+    for (auto& load : textures) {
+        PublishTexture(load.first, *load.second);
+    }
+    for (auto& load : meshes) {
+        PublishMesh(load.first, *load.second);
+    }
+    EnforceMemoryBudgets();
+}
+
 std::shared_ptr<Texture> ResourceManager::LoadTexture(const std::string& name, const std::string& filename) {
-    // Check if already loaded
+    RecordLoad(ResourceType::Texture, name, filename);
+    // Check if already loaded, finishing an asynchronous load of it
+    auto load = textureLoads_.find(name);
+    if (load != textureLoads_.end()) {
+        const std::shared_ptr<TextureLoad> pending = load->second;
+        WaitForLoad(*pending);
+        PublishTexture(name, *pending);
+    }
     auto it = textures_.find(name);
     if (it != textures_.end()) {
-        return it->second;
+        return texturePool_.GetShared(it->second.handle);
     }
     
-    // Find the file
-    std::string fullPath = FindResourceFile(filename);
-    if (fullPath.empty()) {
+    // Find the file, in the paks first
+    std::shared_ptr<PakArchive> pak;
+    const PakEntry* entry = FindPakEntry(filename, pak);
+    std::string fullPath = entry ? std::string() : FindResourceFile(filename);
+    if (!entry && fullPath.empty()) {
         Logger::Error("Could not find texture file: " + filename);
         return nullptr;
     }
     
-    // Load the texture
+    // Load the texture. Containers stream their mips when a streaming engine is available
     auto texture = std::make_shared<Texture>();
-    if (texture->LoadFromFile(fullPath, device_)) {
-        textures_[name] = texture;
-        memoryUsage_ += texture->GetMemoryUsage();
-        Logger::Info("Loaded texture: " + name + " (" + std::to_string(texture->GetMemoryUsage()) + " bytes)");
+    bool loaded = false;
+    if (entry) {
+        loaded = LoadFromPak(*texture, *pak, *entry, device_, jobs_);
+    } else {
+        loaded = streaming_ && TextureFile::IsContainer(fullPath) ? texture->LoadStreaming(fullPath, streaming_)
+                                                                  : texture->LoadFromFile(fullPath, device_, jobs_);
+    }
+    if (loaded) {
+        RegisterTexture(name, texture);
+        if (!entry) {
+            textureFiles_[name] = FileWatcher::NormalizePath(fullPath);
+            WatchFile(fullPath);
+        }
+        NEXUS_LOG_INFO("Loaded texture: {} ({} bytes)", name, texture->GetMemoryUsage());
         return texture;
     }
     
@@ -76,33 +250,152 @@ std::shared_ptr<Texture> ResourceManager::LoadTexture(const std::string& name, c
 
 std::shared_ptr<Texture> ResourceManager::GetTexture(const std::string& name) {
     auto it = textures_.find(name);
-    return (it != textures_.end()) ? it->second : nullptr;
+    return (it != textures_.end()) ? texturePool_.GetShared(it->second.handle) : nullptr;
 }
 
 void ResourceManager::UnloadTexture(const std::string& name) {
-    textures_.erase(name);
+    auto it = textures_.find(name);
+    if (it != textures_.end()) {
+        texturePool_.Remove(it->second.handle);
+        textures_.erase(it);
+    }
+    textureFiles_.erase(name);
+}
+
+TextureHandle ResourceManager::FindTexture(const std::string& name) const {
+    auto it = textures_.find(name);
+    return (it != textures_.end()) ? it->second.handle : TextureHandle{};
+}
+
+TextureHandle ResourceManager::AcquireTexture(const std::string& name) {
+    const TextureHandle handle = FindTexture(name);
+    texturePool_.AddRef(handle);
+    return handle;
+}
+
+void ResourceManager::ReleaseTexture(TextureHandle handle) {
+    // Freed by the next ClearUnusedResources() once nothing else holds it
+    texturePool_.Release(handle);
+}
+
+void ResourceManager::RegisterTexture(const std::string& name, std::shared_ptr<Texture> texture) {
+    auto it = textures_.find(name);
+    if (it != textures_.end()) texturePool_.Remove(it->second.handle);
+    const TextureHandle handle = texturePool_.Add(std::move(texture));
+    if (handle.IsValid()) {
+        textures_[name] = { handle, frame_, 0 };
+    } else {
+        if (it != textures_.end()) textures_.erase(it);
+        Logger::Error("Too many textures loaded, not registering: " + name);
+    }
+}
+
+std::shared_ptr<Texture> ResourceManager::LoadTextureAsync(const std::string& name, const std::string& filename,
+                                                           TextureCallback onLoaded) {
+    RecordLoad(ResourceType::Texture, name, filename);
+    auto load = textureLoads_.find(name);
+    if (load != textureLoads_.end()) {
+        if (onLoaded) load->second->callbacks.push_back(std::move(onLoaded));
+        return load->second->placeholder;
+    }
+    auto it = textures_.find(name);
+    if (it != textures_.end()) {
+        const std::shared_ptr<Texture>& texture = texturePool_.GetShared(it->second.handle);
+        if (onLoaded) onLoaded(texture);
+        return texture;
+    }
+    
+    // Streamed containers only read their mip tail up front, and the streaming engine is the
+    // main thread's, so they load here
+    std::shared_ptr<PakArchive> pak;
+    const PakEntry* entry = FindPakEntry(filename, pak);
+    std::string fullPath = entry ? pak->GetName(*entry) : FindResourceFile(filename);
+    if (fullPath.empty() || (!entry && streaming_ && TextureFile::IsContainer(fullPath))) {
+        auto texture = LoadTexture(name, filename);
+        if (onLoaded) onLoaded(texture);
+        return texture;
+    }
+    
+    auto pending = std::make_shared<TextureLoad>();
+    pending->placeholder = std::make_shared<Texture>();
+    pending->loaded = std::make_shared<Texture>();
+    pending->path = std::move(fullPath);
+    pending->pak = std::move(pak);
+    pending->entry = entry;
+    if (onLoaded) pending->callbacks.push_back(std::move(onLoaded));
+    textureLoads_[name] = pending;
+    RegisterTexture(name, pending->placeholder);
+    
+    Enqueue([this, pending]() {
+        const bool loaded = pending->entry ? LoadFromPak(*pending->loaded, *pending->pak, *pending->entry, device_, jobs_)
+                                           : pending->loaded->LoadFromFile(pending->path, device_, jobs_);
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        pending->succeeded = loaded;
+        pending->done = true;
+    });
+    return pending->placeholder;
+}
+
+void ResourceManager::PublishTexture(const std::string& name, TextureLoad& load) {
+    // Already published by a LoadTexture() from an earlier callback
+    auto pending = textureLoads_.find(name);
+    if (pending == textureLoads_.end() || pending->second.get() != &load) return;
+    textureLoads_.erase(pending);
+    
+    // Unloaded or replaced while in flight: the result goes to whoever still holds the placeholder
+    auto it = textures_.find(name);
+    const bool registered = it != textures_.end() && texturePool_.Get(it->second.handle) == load.placeholder.get();
+    
+    std::shared_ptr<Texture> result;
+    if (load.succeeded) {
+        load.placeholder->Swap(*load.loaded);
+        load.loaded.reset();
+        result = load.placeholder;
+        if (registered && !load.entry) {
+            textureFiles_[name] = FileWatcher::NormalizePath(load.path);
+            WatchFile(load.path);
+        }
+        NEXUS_LOG_INFO("Loaded texture: {} ({} bytes)", name, result->GetMemoryUsage());
+    } else {
+        if (registered) {
+            texturePool_.Remove(it->second.handle);
+            textures_.erase(it);
+        }
+        Logger::Error("Failed to load texture: " + load.path);
+    }
+    for (const auto& callback : load.callbacks) {
+        callback(result);
+    }
 }
 
 std::shared_ptr<Mesh> ResourceManager::LoadMesh(const std::string& name, const std::string& filename) {
-    // Check if already loaded
+    RecordLoad(ResourceType::Mesh, name, filename);
+    // Check if already loaded, finishing an asynchronous load of it
+    auto load = meshLoads_.find(name);
+    if (load != meshLoads_.end()) {
+        const std::shared_ptr<MeshLoad> pending = load->second;
+        WaitForLoad(*pending);
+        PublishMesh(name, *pending);
+    }
     auto it = meshes_.find(name);
     if (it != meshes_.end()) {
-        return it->second;
+        return meshPool_.GetShared(it->second.handle);
     }
     
-    // Find the file
-    std::string fullPath = FindResourceFile(filename);
-    if (fullPath.empty()) {
+    // Find the file, in the paks first
+    std::shared_ptr<PakArchive> pak;
+    const PakEntry* entry = FindPakMesh(filename, pak);
+    std::string fullPath = entry ? std::string() : FindResourceFile(filename);
+    if (!entry && fullPath.empty()) {
         Logger::Error("Could not find mesh file: " + filename);
         return nullptr;
     }
     
     // Load the mesh
     auto mesh = std::make_shared<Mesh>();
-    if (mesh->LoadFromFile(fullPath, device_)) {
-        meshes_[name] = mesh;
-        memoryUsage_ += mesh->GetMemoryUsage();
-        Logger::Info("Loaded mesh: " + name + " (" + std::to_string(mesh->GetMemoryUsage()) + " bytes)");
+    if (entry ? LoadFromPak(*mesh, *pak, *entry, device_) : mesh->LoadFromFile(fullPath, device_)) {
+        RegisterMesh(name, mesh);
+        NEXUS_LOG_INFO("Loaded mesh: {} ({} bytes)", name, mesh->GetMemoryUsage());
         return mesh;
     }
     
@@ -112,29 +405,407 @@ std::shared_ptr<Mesh> ResourceManager::LoadMesh(const std::string& name, const s
 
 std::shared_ptr<Mesh> ResourceManager::GetMesh(const std::string& name) {
     auto it = meshes_.find(name);
-    return (it != meshes_.end()) ? it->second : nullptr;
+    return (it != meshes_.end()) ? meshPool_.GetShared(it->second.handle) : nullptr;
 }
 
 void ResourceManager::UnloadMesh(const std::string& name) {
-    meshes_.erase(name);
+    auto it = meshes_.find(name);
+    if (it != meshes_.end()) {
+        meshPool_.Remove(it->second.handle);
+        meshes_.erase(it);
+    }
+}
+
+MeshHandle ResourceManager::FindMesh(const std::string& name) const {
+    auto it = meshes_.find(name);
+    return (it != meshes_.end()) ? it->second.handle : MeshHandle{};
+}
+
+MeshHandle ResourceManager::AcquireMesh(const std::string& name) {
+    const MeshHandle handle = FindMesh(name);
+    meshPool_.AddRef(handle);
+    return handle;
+}
+
+void ResourceManager::ReleaseMesh(MeshHandle handle) {
+    meshPool_.Release(handle);
+}
+
+void ResourceManager::RegisterMesh(const std::string& name, std::shared_ptr<Mesh> mesh) {
+    auto it = meshes_.find(name);
+    if (it != meshes_.end()) meshPool_.Remove(it->second.handle);
+    const MeshHandle handle = meshPool_.Add(std::move(mesh));
+    if (handle.IsValid()) {
+        meshes_[name] = { handle, frame_, 0 };
+    } else {
+        if (it != meshes_.end()) meshes_.erase(it);
+        Logger::Error("Too many meshes loaded, not registering: " + name);
+    }
+}
+
+std::shared_ptr<Mesh> ResourceManager::LoadMeshAsync(const std::string& name, const std::string& filename,
+                                                     MeshCallback onLoaded) {
+    RecordLoad(ResourceType::Mesh, name, filename);
+    auto load = meshLoads_.find(name);
+    if (load != meshLoads_.end()) {
+        if (onLoaded) load->second->callbacks.push_back(std::move(onLoaded));
+        return load->second->placeholder;
+    }
+    auto it = meshes_.find(name);
+    if (it != meshes_.end()) {
+        const std::shared_ptr<Mesh>& mesh = meshPool_.GetShared(it->second.handle);
+        if (onLoaded) onLoaded(mesh);
+        return mesh;
+    }
+    
+    std::shared_ptr<PakArchive> pak;
+    const PakEntry* entry = FindPakMesh(filename, pak);
+    std::string fullPath = entry ? pak->GetName(*entry) : FindResourceFile(filename);
+    if (fullPath.empty()) {
+        Logger::Error("Could not find mesh file: " + filename);
+        if (onLoaded) onLoaded(nullptr);
+        return nullptr;
+    }
+    
+    auto pending = std::make_shared<MeshLoad>();
+    pending->placeholder = std::make_shared<Mesh>();
+    pending->loaded = std::make_shared<Mesh>();
+    pending->path = std::move(fullPath);
+    pending->pak = std::move(pak);
+    pending->entry = entry;
+    if (onLoaded) pending->callbacks.push_back(std::move(onLoaded));
+    meshLoads_[name] = pending;
+    RegisterMesh(name, pending->placeholder);
+    
+    // Imports and bakes the .nmesh cache there too when the source is newer
+    Enqueue([this, pending]() {
+        const bool loaded = pending->entry ? LoadFromPak(*pending->loaded, *pending->pak, *pending->entry, device_)
+                                           : pending->loaded->LoadFromFile(pending->path, device_);
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        pending->succeeded = loaded;
+        pending->done = true;
+    });
+    return pending->placeholder;
+}
+
+void ResourceManager::PublishMesh(const std::string& name, MeshLoad& load) {
+    auto pending = meshLoads_.find(name);
+    if (pending == meshLoads_.end() || pending->second.get() != &load) return;
+    meshLoads_.erase(pending);
+    
+    auto it = meshes_.find(name);
+    const bool registered = it != meshes_.end() && meshPool_.Get(it->second.handle) == load.placeholder.get();
+    
+    std::shared_ptr<Mesh> result;
+    if (load.succeeded) {
+        load.placeholder->Swap(*load.loaded);
+        load.loaded.reset();
+        result = load.placeholder;
+        NEXUS_LOG_INFO("Loaded mesh: {} ({} bytes)", name, result->GetMemoryUsage());
+    } else {
+        if (registered) {
+            meshPool_.Remove(it->second.handle);
+            meshes_.erase(it);
+        }
+        Logger::Error("Failed to load mesh: " + load.path);
+    }
+    for (const auto& callback : load.callbacks) {
+        callback(result);
+    }
+}
+
+void ResourceManager::LoaderMain() {
+    NEXUS_MEMORY_SCOPE(MemoryTag::Resources);
+    Profiler::SetThreadName("Resource Loader");
+    std::unique_lock<std::mutex> lock(loadMutex_);
+    for (;;) {
+        loadCondition_.wait(lock, [this]() { return stopLoader_ || !loadQueue_.empty(); });
+        if (stopLoader_) return;
+        
+        std::function<void()> work = std::move(loadQueue_.front());
+        loadQueue_.pop_front();
+        lock.unlock();
+        work();
+        lock.lock();
+        doneCondition_.notify_all();
+    }
+}
+
+void ResourceManager::StopLoader() {
+    if (!loader_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        stopLoader_ = true;
+        loadQueue_.clear();
+    }
+    loadCondition_.notify_all();
+    loader_.join();
+}
+
+void ResourceManager::Enqueue(std::function<void()> work) {
+    {
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        loadQueue_.push_back(std::move(work));
+    }
+    loadCondition_.notify_one();
+}
+
+std::shared_ptr<ShaderPermutations> ResourceManager::LoadShader(const std::string& name,
+                                                                const std::string& vertexShaderFile,
+                                                                const std::string& pixelShaderFile) {
+    // Check if already loaded
+    auto it = shaders_.find(name);
+    if (it != shaders_.end()) {
+        return it->second;
+    }
+    
+    // Find the files
+    std::string vertexPath = FindResourceFile(vertexShaderFile);
+    std::string pixelPath = FindResourceFile(pixelShaderFile);
+    if (vertexPath.empty() || pixelPath.empty()) {
+        Logger::Error("Could not find shader files: " + vertexShaderFile + ", " + pixelShaderFile);
+        return nullptr;
+    }
+    
+    // Only the base variant is built here, the rest on first use or by ShaderWarmup
+    auto shader = std::make_shared<ShaderPermutations>();
+    if (shader->LoadFromFile(vertexPath, pixelPath, device_)) {
+        shaders_[name] = shader;
+        shaderFiles_[name] = { FileWatcher::NormalizePath(vertexPath), FileWatcher::NormalizePath(pixelPath) };
+        WatchFile(vertexPath);
+        WatchFile(pixelPath);
+        NEXUS_LOG_INFO("Loaded shader: {} ({} variants)", name, shader->GetVariantCount());
+        return shader;
+    }
+    
+    Logger::Error("Failed to load shader: " + name);
+    return nullptr;
+}
+
+std::shared_ptr<ShaderPermutations> ResourceManager::GetShader(const std::string& name) {
+    auto it = shaders_.find(name);
+    return (it != shaders_.end()) ? it->second : nullptr;
+}
+
+void ResourceManager::UnloadShader(const std::string& name) {
+    shaders_.erase(name);
+    shaderFiles_.erase(name);
+}
+
+std::shared_ptr<Material> ResourceManager::CreateMaterial(const std::string& name) {
+    auto it = materials_.find(name);
+    if (it != materials_.end()) {
+        return it->second;
+    }
+    
+    auto material = std::make_shared<Material>();
+    materials_[name] = material;
+    return material;
+}
+
+std::shared_ptr<Material> ResourceManager::GetMaterial(const std::string& name) {
+    auto it = materials_.find(name);
+    return (it != materials_.end()) ? it->second : nullptr;
+}
+
+void ResourceManager::UnloadMaterial(const std::string& name) {
+    materials_.erase(name);
+}
+
+void ResourceManager::EnableHotReload(FileWatcher* watcher) {
+    if (fileWatcher_) {
+        fileWatcher_->RemoveListener(fileListener_);
+        fileListener_ = FileWatcher::INVALID_LISTENER;
+    }
+    fileWatcher_ = watcher;
+    if (!fileWatcher_) return;
+    
+    fileListener_ = fileWatcher_->AddListener({}, [this](const std::string& path) { OnFileChanged(path); });
+    for (const auto& path : resourcePaths_) {
+        fileWatcher_->Watch(path);
+    }
+    for (const auto& file : textureFiles_) {
+        WatchFile(file.second);
+    }
+    for (const auto& files : shaderFiles_) {
+        WatchFile(files.second.first);
+        WatchFile(files.second.second);
+    }
+}
+
+void ResourceManager::WatchFile(const std::string& path) {
+    if (!fileWatcher_) return;
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    fileWatcher_->Watch(directory.empty() ? "." : directory.string());
+}
+
+void ResourceManager::OnFileChanged(const std::string& path) {
+    // Entries dropped by ClearUnusedResources are skipped
+    for (const auto& file : textureFiles_) {
+        auto it = textures_.find(file.first);
+        Texture* texture = it != textures_.end() ? texturePool_.Get(it->second.handle) : nullptr;
+        if (file.second != path || !texture) continue;
+        
+        Logger::Info("Reloading texture: " + file.first);
+        const bool loaded = streaming_ && TextureFile::IsContainer(path) ? texture->LoadStreaming(path, streaming_)
+                                                                         : texture->LoadFromFile(path, device_, jobs_);
+        if (!loaded) {
+            Logger::Error("Failed to reload texture: " + file.first);
+        }
+    }
+    
+    for (const auto& files : shaderFiles_) {
+        auto shader = shaders_.find(files.first);
+        if ((files.second.first != path && files.second.second != path) || shader == shaders_.end()) continue;
+        
+        // Only the base variant is rebuilt now, the rest on next use, as after the first load
+        Logger::Info("Reloading shader: " + files.first);
+        if (!shader->second->LoadFromFile(files.second.first, files.second.second, device_)) {
+            Logger::Error("Failed to reload shader: " + files.first);
+        }
+    }
 }
 
 void ResourceManager::AddResourcePath(const std::string& path) {
     resourcePaths_.push_back(path);
+    if (fileWatcher_) {
+        fileWatcher_->Watch(path);
+    }
 }
 
-std::string ResourceManager::FindResourceFile(const std::string& filename) {
-    // Try the filename as-is first
+bool ResourceManager::MountPak(const std::string& filename) {
+    auto pak = std::make_shared<PakArchive>();
+    if (!pak->Open(filename)) {
+        Logger::Error("Could not mount pak: " + filename);
+        return false;
+    }
+    paks_.push_back(std::move(pak));
+    return true;
+}
+
+void ResourceManager::UnmountPak(const std::string& filename) {
+    paks_.erase(std::remove_if(paks_.begin(), paks_.end(),
+                               [&filename](const std::shared_ptr<PakArchive>& pak) { return pak->GetFilename() == filename; }),
+                paks_.end());
+}
+
+void ResourceManager::StartLoadOrderRecording() {
+    recordingLoadOrder_ = true;
+    recordingStart_ = std::chrono::steady_clock::now();
+    loadOrder_.clear();
+    recordedLoads_.clear();
+}
+
+void ResourceManager::RecordLoad(ResourceType type, const std::string& name, const std::string& filename) {
+    if (!recordingLoadOrder_ || prefetching_) return;
+    if (!recordedLoads_.insert(std::to_string(static_cast<int>(type)) + name).second) return;
+    const float timeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - recordingStart_).count();
+    loadOrder_.push_back({ type, name, filename, timeMs });
+}
+
+bool ResourceManager::SaveLoadOrder(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file) {
+        Logger::Error("Could not write load order: " + filename);
+        return false;
+    }
+    file << LOAD_ORDER_MAGIC << " " << LOAD_ORDER_VERSION << "\n";
+    for (const LoadOrderEntry& entry : loadOrder_) {
+        file << (entry.type == ResourceType::Texture ? "texture" : "mesh") << '\t' << entry.timeMs << '\t'
+             << entry.name << '\t' << entry.filename << "\n";
+    }
+    Logger::Info("Saved load order of " + std::to_string(loadOrder_.size()) + " resources: " + filename);
+    return static_cast<bool>(file);
+}
+
+bool ResourceManager::ReadLoadOrder(const std::string& filename, std::vector<LoadOrderEntry>& entries) {
+    entries.clear();
     std::ifstream file(filename);
-    if (file.good()) {
+    std::string line;
+    if (!std::getline(file, line) || line != std::string(LOAD_ORDER_MAGIC) + " " + std::to_string(LOAD_ORDER_VERSION)) {
+        return false;
+    }
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string type, time;
+        LoadOrderEntry entry;
+        std::getline(fields, type, '\t');
+        std::getline(fields, time, '\t');
+        std::getline(fields, entry.name, '\t');
+        std::getline(fields, entry.filename);
+        if (type != "texture" && type != "mesh") continue;
+        if (entry.name.empty() || entry.filename.empty()) continue;
+        entry.type = type == "texture" ? ResourceType::Texture : ResourceType::Mesh;
+        entry.timeMs = std::strtof(time.c_str(), nullptr);
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+bool ResourceManager::PrefetchLoadOrder(const std::string& filename, size_t window) {
+    if (!ReadLoadOrder(filename, prefetchList_)) {
+        return false;
+    }
+    prefetchNext_ = 0;
+    prefetchWindow_ = std::max<size_t>(window, 1);
+    Logger::Info("Prefetching " + std::to_string(prefetchList_.size()) + " resources from " + filename);
+    UpdatePrefetch();
+    return true;
+}
+
+void ResourceManager::UpdatePrefetch() {
+    if (prefetchNext_ >= prefetchList_.size()) return;
+
+    prefetching_ = true;
+    while (prefetchNext_ < prefetchList_.size() && GetPendingLoadCount() < prefetchWindow_) {
+        const LoadOrderEntry& entry = prefetchList_[prefetchNext_++];
+        if (entry.type == ResourceType::Texture) {
+            if (!FindTexture(entry.name).IsValid()) LoadTextureAsync(entry.name, entry.filename);
+        } else if (!FindMesh(entry.name).IsValid()) {
+            LoadMeshAsync(entry.name, entry.filename);
+        }
+    }
+    prefetching_ = false;
+
+    if (prefetchNext_ >= prefetchList_.size()) {
+        prefetchList_.clear();
+        prefetchNext_ = 0;
+    }
+}
+
+const PakEntry* ResourceManager::FindPakEntry(const std::string& filename, std::shared_ptr<PakArchive>& pak) const {
+    for (auto it = paks_.rbegin(); it != paks_.rend(); ++it) {
+        const PakEntry* entry = (*it)->Find(filename);
+        for (size_t i = 0; !entry && i < resourcePaths_.size(); ++i) {
+            entry = (*it)->Find(resourcePaths_[i] + "/" + filename);
+        }
+        if (entry) {
+            pak = *it;
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+const PakEntry* ResourceManager::FindPakMesh(const std::string& filename, std::shared_ptr<PakArchive>& pak) const {
+    // Paks hold meshes baked; there is no importing from memory
+    std::string extension = std::filesystem::path(filename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return FindPakEntry(extension == ".nmesh" ? filename : MeshImporter::GetCachePath(filename), pak);
+}
+
+std::string ResourceManager::FindResourceFile(const std::string& filename) {
+    // Try the filename as-is first. Only the directory entry is looked up, nothing is opened
+    std::error_code error;
+    if (std::filesystem::is_regular_file(filename, error)) {
         return filename;
     }
     
     // Try each resource path
     for (const auto& path : resourcePaths_) {
         std::string fullPath = path + "/" + filename;
-        std::ifstream testFile(fullPath);
-        if (testFile.good()) {
+        if (std::filesystem::is_regular_file(fullPath, error)) {
             return fullPath;
         }
     }
@@ -147,8 +818,9 @@ void ResourceManager::ClearUnusedResources() {
     
     // Clear unused textures
     for (auto it = textures_.begin(); it != textures_.end();) {
-        if (it->second.use_count() == 1) {
-            freedMemory += it->second->GetMemoryUsage();
+        if (texturePool_.GetRefCount(it->second.handle) == 0 && texturePool_.GetShared(it->second.handle).use_count() == 1) {
+            freedMemory += texturePool_.Get(it->second.handle)->GetMemoryUsage();
+            texturePool_.Remove(it->second.handle);
             it = textures_.erase(it);
         } else {
             ++it;
@@ -157,23 +829,85 @@ void ResourceManager::ClearUnusedResources() {
     
     // Clear unused meshes
     for (auto it = meshes_.begin(); it != meshes_.end();) {
-        if (it->second.use_count() == 1) {
-            freedMemory += it->second->GetMemoryUsage();
+        if (meshPool_.GetRefCount(it->second.handle) == 0 && meshPool_.GetShared(it->second.handle).use_count() == 1) {
+            freedMemory += meshPool_.Get(it->second.handle)->GetMemoryUsage();
+            meshPool_.Remove(it->second.handle);
             it = meshes_.erase(it);
         } else {
             ++it;
         }
     }
     
-    memoryUsage_ -= freedMemory;
-    
     if (freedMemory > 0) {
         Logger::Info("Freed " + std::to_string(freedMemory) + " bytes of unused resources");
     }
 }
 
 size_t ResourceManager::GetMemoryUsage() const {
-    return memoryUsage_;
+    return GetMemoryUsage(ResourceType::Texture) + GetMemoryUsage(ResourceType::Mesh);
+}
+
+size_t ResourceManager::GetMemoryUsage(ResourceType type) const {
+    // Summed on demand since streamed textures change size as mips come and go
+    size_t bytes = 0;
+    if (type == ResourceType::Texture) {
+        for (const auto& entry : textures_) {
+            bytes += texturePool_.Get(entry.second.handle)->GetMemoryUsage();
+        }
+    } else if (type == ResourceType::Mesh) {
+        for (const auto& entry : meshes_) {
+            bytes += meshPool_.Get(entry.second.handle)->GetMemoryUsage();
+        }
+    }
+    return bytes;
+}
+
+void ResourceManager::SetMemoryBudget(ResourceType type, size_t bytes) {
+    if (type >= ResourceType::Count) return;
+    memoryBudgets_[static_cast<size_t>(type)] = bytes;
+    overBudget_[static_cast<size_t>(type)] = false;
+    if (type == ResourceType::Texture && bytes == 0 && streaming_) {
+        streaming_->SetMemoryBudget(streamingBudget_);
+    }
+}
+
+void ResourceManager::EnforceMemoryBudgets() {
+    const size_t textureBudget = GetMemoryBudget(ResourceType::Texture);
+    const size_t meshBudget = GetMemoryBudget(ResourceType::Mesh);
+    if (textureBudget == 0 && meshBudget == 0) return;
+    NEXUS_PROFILE_SCOPE("ResourceManager::EnforceMemoryBudgets");
+    
+    std::vector<EvictionCandidate> unused;
+    if (textureBudget > 0) {
+        size_t bytes = TrackUsage(textures_, texturePool_, frame_, unused);
+        bytes = Evict(unused, bytes, textureBudget, [this](const std::string& name) { UnloadTexture(name); });
+        
+        // Streamed mips are the streaming engine's to trim, within what the rest leave it
+        const size_t streamed = streaming_ ? static_cast<size_t>(streaming_->GetMemoryUsage()) : 0;
+        const size_t loaded = bytes > streamed ? bytes - streamed : 0;
+        if (streaming_) {
+            streaming_->SetMemoryBudget(textureBudget > loaded ? textureBudget - loaded : 0);
+        }
+        ReportOverBudget(ResourceType::Texture, loaded);
+    }
+    
+    if (meshBudget > 0) {
+        unused.clear();
+        size_t bytes = TrackUsage(meshes_, meshPool_, frame_, unused);
+        bytes = Evict(unused, bytes, meshBudget, [this](const std::string& name) { UnloadMesh(name); });
+        ReportOverBudget(ResourceType::Mesh, bytes);
+    }
+}
+
+void ResourceManager::ReportOverBudget(ResourceType type, size_t bytes) {
+    // Everything left is in use, so only the game can free it; once per overrun
+    bool& warned = overBudget_[static_cast<size_t>(type)];
+    const size_t budget = GetMemoryBudget(type);
+    if (bytes > budget && !warned) {
+        Logger::Warning(std::string(type == ResourceType::Texture ? "Textures" : "Meshes") + " in use exceed their budget: " +
+                        std::to_string(bytes / (1024 * 1024)) + " of " + std::to_string(budget / (1024 * 1024)) + " MB");
+    }
+    warned = bytes > budget;
 }
 
 } // namespace Nexus
@@ -0,0 +1,208 @@
+#include "UnityYamlReader.h"
+#include <algorithm>
+#include <charconv>
+
+namespace Nexus {
+
+namespace {
+constexpr std::string_view DOCUMENT_MARKER = "--- !u!";
+
+std::string_view Trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+    return text;
+}
+
+// The line starting at offset, without its newline
+std::string_view GetLine(std::string_view text, size_t offset) {
+    const size_t end = text.find('\n', offset);
+    return text.substr(offset, (end == std::string_view::npos ? text.size() : end) - offset);
+}
+
+size_t NextLine(std::string_view text, size_t offset) {
+    const size_t end = text.find('\n', offset);
+    return end == std::string_view::npos ? text.size() : end + 1;
+}
+
+int CountIndent(std::string_view line) {
+    int indent = 0;
+    while (indent < static_cast<int>(line.size()) && line[indent] == ' ') ++indent;
+    return indent;
+}
+
+// The ": " or trailing ':' ending a plain key, npos if the line holds no key
+size_t FindKeyEnd(std::string_view line) {
+    if (line.empty() || line[0] == '{' || line[0] == '[' || line[0] == '"' || line[0] == '\'') return std::string_view::npos;
+    for (size_t i = 0; i < line.size(); ++i) {
+        if (line[i] == ':' && (i + 1 == line.size() || line[i + 1] == ' ' || line[i + 1] == '\r')) return i;
+        if (line[i] == ' ' && i + 1 < line.size() && line[i + 1] == '#') break;
+    }
+    return std::string_view::npos;
+}
+
+// Brackets a line opens minus those it closes
+int CountFlowDepth(std::string_view text) {
+    int depth = 0;
+    for (char c : text) {
+        if (c == '{' || c == '[') ++depth;
+        else if (c == '}' || c == ']') --depth;
+    }
+    return depth;
+}
+
+bool ParseHeader(std::string_view line, UnityYamlDocument& document) {
+    // "--- !u!4 &400000" and maybe " stripped"
+    line.remove_prefix(DOCUMENT_MARKER.size());
+    const char* end = line.data() + line.size();
+    auto result = std::from_chars(line.data(), end, document.classId);
+    if (result.ec != std::errc()) return false;
+    line.remove_prefix(result.ptr - line.data());
+    const size_t ampersand = line.find('&');
+    if (ampersand == std::string_view::npos) return false;
+    result = std::from_chars(line.data() + ampersand + 1, end, document.fileId);
+    if (result.ec != std::errc()) return false;
+    document.stripped = std::string_view(result.ptr, end - result.ptr).find("stripped") != std::string_view::npos;
+    return true;
+}
+}
+
+bool UnityYamlReader::Open(const std::string& filename) {
+    Close();
+    if (!file_.Open(filename)) return false;
+    SplitDocuments(std::string_view(reinterpret_cast<const char*>(file_.GetData()), file_.GetSize()), documents_);
+    return true;
+}
+
+void UnityYamlReader::Close() {
+    documents_.clear();
+    file_.Close();
+}
+
+void UnityYamlReader::SplitDocuments(std::string_view text, std::vector<UnityYamlDocument>& documents) {
+    documents.clear();
+    size_t start = text.compare(0, DOCUMENT_MARKER.size(), DOCUMENT_MARKER) == 0 ? 0 : text.find("\n--- !u!");
+    if (start != std::string_view::npos && start != 0) ++start;
+
+    while (start != std::string_view::npos && start < text.size()) {
+        size_t next = text.find("\n--- !u!", start);
+        const size_t end = next == std::string_view::npos ? text.size() : next + 1;
+
+        UnityYamlDocument document;
+        if (ParseHeader(GetLine(text, start), document)) {
+            // The root key is the line after the header; the body is everything below it
+            const size_t rootStart = NextLine(text, start);
+            if (rootStart < end) {
+                std::string_view root = GetLine(text, rootStart);
+                const size_t colon = root.find(':');
+                document.type = Trim(colon == std::string_view::npos ? root : root.substr(0, colon));
+                const size_t bodyStart = std::min(NextLine(text, rootStart), end);
+                document.body = text.substr(bodyStart, end - bodyStart);
+            }
+            documents.push_back(document);
+        }
+        start = next == std::string_view::npos ? next : next + 1;
+    }
+}
+
+bool UnityYamlReader::NextField(std::string_view body, size_t& offset, UnityYamlField& field) {
+    while (offset < body.size()) {
+        std::string_view line = GetLine(body, offset);
+        offset = NextLine(body, offset);
+        int indent = CountIndent(line);
+        std::string_view content = Trim(line.substr(indent));
+        if (content.empty() || content[0] == '#') continue;
+
+        field.item = content[0] == '-' && (content.size() == 1 || content[1] == ' ');
+        if (field.item) {
+            content = Trim(content.substr(1));
+            indent += 2;
+        }
+        field.indent = indent;
+
+        const size_t keyEnd = FindKeyEnd(content);
+        if (keyEnd == std::string_view::npos) {
+            field.key = std::string_view();
+            field.value = content;
+        } else {
+            field.key = content.substr(0, keyEnd);
+            field.value = Trim(content.substr(keyEnd + 1));
+        }
+
+        // Scalars wrap onto lines indented past the key that hold no key themselves, flow
+        // mappings onto any lines until they close; the view grows over them, newlines included
+        if (!field.value.empty()) {
+            const char* begin = field.value.data();
+            const char* last = begin + field.value.size();
+            const bool flow = field.value[0] == '{' || field.value[0] == '[';
+            int depth = flow ? CountFlowDepth(field.value) : 0;
+            while (offset < body.size()) {
+                std::string_view next = GetLine(body, offset);
+                const int nextIndent = CountIndent(next);
+                std::string_view nextContent = Trim(next.substr(nextIndent));
+                if (depth <= 0 && (nextContent.empty() || nextIndent <= indent - (field.item ? 2 : 0) ||
+                                   nextContent[0] == '-' || FindKeyEnd(nextContent) != std::string_view::npos)) {
+                    break;
+                }
+                if (flow) depth += CountFlowDepth(nextContent);
+                if (!nextContent.empty()) last = nextContent.data() + nextContent.size();
+                offset = NextLine(body, offset);
+            }
+            field.value = std::string_view(begin, last - begin);
+        }
+        return true;
+    }
+    return false;
+}
+
+std::string_view UnityYamlReader::FindFlowValue(std::string_view flow, std::string_view key) {
+    // {fileID: 4000, guid: 0123..., type: 3}
+    size_t at = 0;
+    while ((at = flow.find(key, at)) != std::string_view::npos) {
+        const size_t before = at;
+        at += key.size();
+        const bool starts = before == 0 || flow[before - 1] == '{' || flow[before - 1] == ' ' ||
+                            flow[before - 1] == ',' || flow[before - 1] == '\n';
+        if (!starts || at >= flow.size() || flow[at] != ':') continue;
+
+        size_t end = at + 1;
+        int depth = 0;
+        while (end < flow.size()) {
+            const char c = flow[end];
+            if (c == '{' || c == '[') ++depth;
+            else if ((c == '}' || c == ']') && depth-- == 0) break;
+            else if (c == ',' && depth == 0) break;
+            ++end;
+        }
+        return Trim(flow.substr(at + 1, end - at - 1));
+    }
+    return std::string_view();
+}
+
+int64_t UnityYamlReader::ToFileId(std::string_view flow) {
+    return ToInt(FindFlowValue(flow, "fileID"));
+}
+
+float UnityYamlReader::ToFloat(std::string_view value, float fallback) {
+    value = Trim(value);
+    if (!value.empty() && value[0] == '+') value.remove_prefix(1);
+    float result = fallback;
+    const auto parsed = std::from_chars(value.data(), value.data() + value.size(), result);
+    return parsed.ec == std::errc() ? result : fallback;
+}
+
+int64_t UnityYamlReader::ToInt(std::string_view value, int64_t fallback) {
+    value = Trim(value);
+    int64_t result = fallback;
+    const auto parsed = std::from_chars(value.data(), value.data() + value.size(), result);
+    return parsed.ec == std::errc() ? result : fallback;
+}
+
+std::string_view UnityYamlReader::ToString(std::string_view value) {
+    value = Trim(value);
+    if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+        value = value.substr(1, value.size() - 2);
+    }
+    return value;
+}
+
+} // namespace Nexus